@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+vc_local_control.py - Send commands to cuems-videocomposer over its local control channel
+
+The composer must run with --local-control SOCKET. Commands use the same
+paths and arguments as OSC; they are written into a shared-memory ring
+(layout in src/cuems_videocomposer/cpp/remote/LocalControlRing.h) instead of
+going through the network.
+
+As a module:
+    with LocalControl("/run/cuems/videocomposer.ctl") as vc:
+        vc.send("/videocomposer/layer/load", 1, "clip.mp4")
+        with vc.bundle():
+            vc.send("/videocomposer/layer/1/opacity", 0.0)
+            vc.send("/videocomposer/layer/2/opacity", 1.0)
+
+From the shell (arguments typed like OSC: 3 -> int, 0.5 -> float, text -> string):
+    vc_local_control.py /run/cuems/videocomposer.ctl /videocomposer/layer/load 1 clip.mp4
+"""
+
+import argparse
+import contextlib
+import mmap
+import os
+import socket
+import struct
+import sys
+import time
+
+RING_MAGIC = 0x52434356
+RING_VERSION = 1
+RECORD_PAD = 0x01
+RECORD_BUNDLE_CONTINUES = 0x02
+
+HEADER = struct.Struct("<IIII")     # magic, version, capacity, dataOffset
+HEAD_OFFSET = 64
+DROPPED_OFFSET = 72
+TAIL_OFFSET = 128
+RECORD = struct.Struct("<IHBBq")    # size, pathLength, flags, argCount, atUs
+U64 = struct.Struct("<Q")
+
+
+class RingFull(Exception):
+    """The composer has not caught up; the command was not queued"""
+
+
+def _encode_arg(value):
+    if isinstance(value, bool):
+        value = int(value)
+    if isinstance(value, int):
+        if -(1 << 31) <= value < (1 << 31):
+            return b"i" + struct.pack("<i", value)
+        return b"h" + struct.pack("<q", value)
+    if isinstance(value, float):
+        return b"f" + struct.pack("<f", value)
+    if isinstance(value, tuple) and len(value) == 2 and value[0] in "ihfd":
+        # Explicit type, e.g. ("d", 0.1) for a double
+        return value[0].encode() + struct.pack("<" + {"i": "i", "h": "q", "f": "f", "d": "d"}[value[0]], value[1])
+    data = str(value).encode("utf-8")
+    return b"s" + struct.pack("<I", len(data)) + data
+
+
+class LocalControl:
+    """One controller session: a ring of our own and the eventfd that wakes the composer"""
+
+    def __init__(self, socket_path):
+        self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._socket.connect(socket_path)
+        msg, fds, _, _ = socket.recv_fds(self._socket, 4, 2)
+        if len(msg) != 4 or struct.unpack("<I", msg)[0] != 2 or len(fds) != 2:
+            for fd in fds:
+                os.close(fd)
+            raise RuntimeError("unexpected handshake from " + socket_path)
+        self._mem_fd, self._event_fd = fds
+        size = os.fstat(self._mem_fd).st_size
+        self._map = mmap.mmap(self._mem_fd, size)
+
+        magic, version, capacity, data_offset = HEADER.unpack_from(self._map, 0)
+        if magic != RING_MAGIC or version != RING_VERSION or size < data_offset + capacity:
+            self.close()
+            raise RuntimeError("not a control ring (magic %#x, version %d)" % (magic, version))
+        self._capacity = capacity
+        self._data = data_offset
+        self._head = U64.unpack_from(self._map, HEAD_OFFSET)[0]
+        self._bundle = None
+
+    def close(self):
+        if self._map is not None:
+            self._map.close()
+            self._map = None
+        for fd in (self._mem_fd, self._event_fd):
+            os.close(fd)
+        self._socket.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def send(self, path, *args, at=None):
+        """Queue one command; at is a Unix time in seconds to run it at (like an OSC timetag)"""
+        record = self._encode(path, args, at)
+        if self._bundle is not None:
+            self._bundle.append(record)
+            return
+        self._publish([record])
+
+    @contextlib.contextmanager
+    def bundle(self):
+        """Commands sent inside run on the same frame"""
+        self._bundle = []
+        try:
+            yield self
+            records, self._bundle = self._bundle, None
+            if records:
+                self._publish(records)
+        finally:
+            self._bundle = None
+
+    @property
+    def dropped(self):
+        return U64.unpack_from(self._map, DROPPED_OFFSET)[0]
+
+    def _encode(self, path, args, at):
+        path = path.encode("utf-8")
+        body = path + b"".join(_encode_arg(arg) for arg in args)
+        if not path or len(path) > 0xFFFF or len(args) > 255:
+            raise ValueError("command does not fit a record")
+        at_us = int(at * 1000000) if at else 0
+        return path, len(args), at_us, body
+
+    def _publish(self, records):
+        # Lay every record out after head, then move head once
+        head = self._head
+        tail = U64.unpack_from(self._map, TAIL_OFFSET)[0]
+        writes = []
+        for index, (path, count, at_us, body) in enumerate(records):
+            size = RECORD.size + len(body)
+            need = (size + 7) & ~7
+            if size > self._capacity // 2:
+                raise ValueError("command does not fit a record")
+            offset = head % self._capacity
+            if offset + need > self._capacity:
+                pad = self._capacity - offset
+                writes.append((offset, RECORD.pack(pad, 0, RECORD_PAD, 0, 0)[:pad]))
+                head += pad
+                offset = 0
+            flags = RECORD_BUNDLE_CONTINUES if index + 1 < len(records) else 0
+            writes.append((offset, RECORD.pack(need, len(path), flags, count, at_us) + body + bytes(need - size)))
+            head += need
+        if head - tail > self._capacity:
+            U64.pack_into(self._map, DROPPED_OFFSET, self.dropped + len(records))
+            raise RingFull("%d command(s) dropped, the ring is full" % len(records))
+
+        for offset, data in writes:
+            start = self._data + offset
+            self._map[start:start + len(data)] = data
+        U64.pack_into(self._map, HEAD_OFFSET, head)
+        self._head = head
+        os.write(self._event_fd, U64.pack(1))
+
+
+def _parse_arg(text):
+    for kind in (int, float):
+        try:
+            return kind(text)
+        except ValueError:
+            pass
+    return text
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send a command over the local control channel")
+    parser.add_argument("socket", help="socket given to --local-control")
+    parser.add_argument("path", help="command path, e.g. /videocomposer/layer/load")
+    parser.add_argument("args", nargs="*", help="arguments (int, float or string)")
+    parser.add_argument("--at", type=float, help="run at this Unix time instead of immediately")
+    parser.add_argument("--in", dest="delay", type=float, help="run this many seconds from now")
+    options = parser.parse_args()
+
+    at = options.at
+    if options.delay is not None:
+        at = time.time() + options.delay
+    try:
+        with LocalControl(options.socket) as vc:
+            vc.send(options.path, *[_parse_arg(arg) for arg in options.args], at=at)
+    except (OSError, RuntimeError, RingFull) as error:
+        print("vc_local_control: %s" % error, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -29,7 +29,18 @@
 #include "config/ConfigurationManager.h"
 #include "input/VideoFileInput.h"
 #include "input/AsyncVideoLoader.h"
+#include "input/DecodeAheadBudget.h"
+#include "input/DecodeThreadBudget.h"
+#include "input/DecoderContextPool.h"
+#include "input/DecodeScheduler.h"
+#include "input/RamClipCache.h"
+#include "video/MemoryBudget.h"
+#include "input/PageCachePolicy.h"
+#include "input/RenderNodeManager.h"
+#include "input/HardwareDeviceCache.h"
+#include "display/ProgramBinaryCache.h"
 #include "display/X11Display.h"
+#include "display/SoftwareDisplay.h"
 #ifdef HAVE_WAYLAND
 #include "display/WaylandDisplay.h"
 #endif
@@ -37,25 +48,80 @@
 #include "display/drm/DRMBackend.h"
 #include "display/HeadlessDisplay.h"
 #endif
+#ifdef HAVE_VULKAN_DISPLAY
+#include "display/vulkan/VulkanDisplay.h"
+#endif
 #include "input/HAPVideoInput.h"
+#include "input/ImageSequenceInput.h"
+#include "input/MosaicInput.h"
+#include "input/ProxyMedia.h"
+#include "input/ProxySwitcher.h"
+#include "layer/DecodeGovernor.h"
+#include "layer/LoadAdmission.h"
+#include "input/StillImageInput.h"
+#include "input/TiledImage.h"
+#include "input/ThumbnailService.h"
+#include "input/TestPatternInput.h"
 #include "input/FFmpegLiveInput.h"
+#ifdef ENABLE_HAP_DIRECT
+#include "hap/HapChunkPool.h"
+#endif
 #ifdef HAVE_NDI_SDK
 #include "input/NDIVideoInput.h"
 #endif
+#ifdef HAVE_V4L2
+#include "input/V4L2VideoInput.h"
+#endif
 #include "sync/MIDISyncSource.h"
 #include "sync/FramerateConverterSyncSource.h"
+#include "sync/FrameClock.h"
+#include "sync/FrameLockSyncSource.h"
+#include "sync/VblankClockSyncSource.h"
+#ifdef HAVE_LTC_CAPTURE
+#include "sync/LTCSyncSource.h"
+#endif
 #include "layer/LayerManager.h"
 #include "layer/VideoLayer.h"
+#include "layer/ShowJournal.h"
+#include "remote/ClusterReplicator.h"
+#include "remote/ControlCapture.h"
 #include "video/FrameFormat.h"
 #include "display/DisplayManager.h"
+#include "display/SyncLatencyMonitor.h"
+#include "display/PreviewRenderer.h"
+#include "display/IdleDetector.h"
+#include "output/OutputSinkManager.h"
+#include "video/TexturePool.h"
+#include "output/SharedMemoryOutput.h"
+#include "output/FileEncoderOutput.h"
+#include "output/ReadbackRing.h"
+#ifdef HAVE_NDI_SDK
+#include "output/NDIOutput.h"
+#endif
+#ifdef HAVE_DECKLINK_SDK
+#include "output/DeckLinkOutput.h"
+#include "input/DeckLinkVideoInput.h"
+#endif
+#ifdef HAVE_VAAPI_INTEROP
+#include "output/VaapiEncoderOutput.h"
+#endif
 #include "display/OpenGLRenderer.h"
 #include "remote/OSCRemoteControl.h"
+#include "remote/TelemetryPublisher.h"
 
 #ifdef HAVE_VAAPI_INTEROP
 #endif
 #include "osd/OSDManager.h"
 #include "utils/Logger.h"
+#include "utils/ThreadRoles.h"
+#include "utils/FlightRecorder.h"
+#include "utils/FrameTracer.h"
+#include "utils/FrameArena.h"
+#include "utils/AllocationCounter.h"
 #include "utils/SMPTEUtils.h"
+#include "utils/TimeUtils.h"
+#include "utils/StartupSequence.h"
+#include "utils/WakeSignal.h"
 #include <iostream>
 #include <chrono>
 #include <algorithm>
@@ -65,11 +131,60 @@
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <cstdio>
+#include <sstream>
 
 namespace videocomposer {
 
+struct VideoComposerApplication::ResumeState {
+    std::map<std::string, ShowJournal::Layer> layers;   // Cue ID -> journaled layer, until its load completes
+};
+
+namespace {
+
+// What the show journal (and the cluster) record of a loaded cue
+ShowJournal::Layer journalLayer(const std::string& cueId, const std::string& source, const VideoLayer& layer) {
+    ShowJournal::Layer entry;
+    entry.cueId = cueId;
+    entry.source = source;
+    entry.properties = layer.properties();
+    entry.timeOffset = layer.getTimeOffset();
+    entry.timeScale = layer.getTimeScale();
+    entry.wraparound = layer.getWraparound();
+    entry.mtcFollow = layer.getMtcFollow();
+    entry.decodePriority = layer.getDecodePriority();
+    entry.critical = layer.isCritical();
+    return entry;
+}
+
+void applyJournalLayer(VideoLayer* layer, const ShowJournal::Layer& saved) {
+    layer->properties() = saved.properties;
+    layer->setTimeOffset(saved.timeOffset);
+    layer->setTimeScale(saved.timeScale);
+    layer->setWraparound(saved.wraparound);
+    layer->setMtcFollow(saved.mtcFollow);
+    layer->setDecodePriority(saved.decodePriority);
+    layer->setCritical(saved.critical);
+}
+
+} // namespace
+
 VideoComposerApplication::VideoComposerApplication()
-    : running_(false)
+    : frameLock_(nullptr)
+    , internalClock_(nullptr)
+    , frameClock_(std::make_unique<FrameClock>())
+    , vsyncTarget_(true)
+    , lateLatch_(false)
+    , displayLagNs_(0)
+    , presentationLeadNs_(0)
+    , presentationUs_(0)
+    , videoFps_(0.0)
+    , refreshFps_(0.0)
+    , vrrRequested_(0.0)
+    , vrrFps_(0.0)
+    , nextFlipUs_(0)
+    , offlineRender_(false)
+    , running_(false)
     , initialized_(false)
 {
 }
@@ -111,42 +226,144 @@ bool VideoComposerApplication::initialize(int argc, char** argv) {
     if (verbose) {
         Logger::getInstance().setLevel(Logger::VERBOSE);
     }
+    FrameTracer::instance().setEnabled(config_->getBool("trace", true));
+    FlightRecorder::Settings flightSettings;
+    // The snapshots are made of the trace
+    flightSettings.enabled = config_->getBool("flight_recorder", true) && config_->getBool("trace", true);
+    flightSettings.directory = config_->getString("flight_recorder_dir", "");
+    flightSettings.windowSeconds = config_->getDouble("flight_recorder_seconds", 10.0);
+    FlightRecorder::instance().configure(flightSettings);
 
-    // Initialize display
-    if (!initializeDisplay()) {
-        LOG_ERROR << "Failed to initialize display";
-        return false;
+    // --capture-control / --replay-control: the MTC and OSC traffic of a show
+    std::string capturePath = config_->getString("control_capture", "");
+    if (!capturePath.empty()) {
+        ControlCapture::instance().start(capturePath);
+    }
+    std::string replayPath = config_->getString("control_replay", "");
+    if (!replayPath.empty()) {
+        controlReplay_ = ControlReplay::instance().load(replayPath, config_->getBool("control_replay_fast", false));
+    }
+
+    // Scheduling and CPUs per thread role, taken by each thread as it starts
+    for (int i = 0; i < static_cast<int>(ThreadRole::COUNT); ++i) {
+        ThreadRole role = static_cast<ThreadRole>(i);
+        ThreadRoles::instance().configure(role, config_->getString(std::string("thread_") + ThreadRoles::roleName(role), ""));
+    }
+    if (config_->getBool("lock_memory", false)) {
+        ThreadRoles::lockMemory();
     }
 
-    // Initialize layer manager
-    if (!initializeLayerManager()) {
+    // --render: an offscreen display, and a clock stepped once per composite
+    offlineRender_ = !config_->getString("render", "").empty();
+    if (offlineRender_ && !configureOfflineRender()) {
         return false;
     }
 
-    // Initialize async video loader (for non-blocking video file loading)
-    asyncVideoLoader_ = std::make_unique<AsyncVideoLoader>();
-    asyncVideoLoader_->initialize(config_.get(), displayBackend_.get());
+    // --resume: the journal's display mode applies before the display comes up
+    std::string journalPath = config_->getString("show_journal_file", "");
+    if (journalPath.empty()) {
+        journalPath = ShowJournal::defaultPath();
+    }
+    if (config_->getBool("resume", false)) {
+        ShowJournal::State journaled;
+        if (ShowJournal::load(journalPath, journaled)) {
+            if (!journaled.resolutionMode.empty()) {
+                config_->setString("resolution_mode", journaled.resolutionMode);
+            }
+            resume_ = std::make_unique<ResumeState>();
+            for (ShowJournal::Layer& layer : journaled.layers) {
+                resume_->layers[layer.cueId] = std::move(layer);
+            }
+        } else {
+            LOG_WARNING << "Nothing to resume: no show journal at " << journalPath;
+        }
+    }
 
-    // Initialize OSD manager
-    osdManager_ = std::make_unique<OSDManager>();
+    // Independent steps overlap: the VAAPI probe, MIDI and OSC setup run on
+    // their own threads while the display comes up on this one (the GL
+    // context stays on the main thread). VIDEOCOMPOSER_NO_PARALLEL_STARTUP=1
+    // runs every step here, one after the other.
+    const char* serialEnv = getenv("VIDEOCOMPOSER_NO_PARALLEL_STARTUP");
+    bool background = !(serialEnv && (std::string(serialEnv) == "1" || std::string(serialEnv) == "true"));
+    StartupSequence startup;
 
-    // Initialize remote control
-    if (!initializeRemoteControl()) {
-        LOG_WARNING << "Failed to initialize remote control (continuing without it)";
-        // Don't fail initialization if remote control fails
-    }
+    startup.add("display", [this] {
+        if (!initializeDisplay()) {
+            LOG_ERROR << "Failed to initialize display";
+            return false;
+        }
+        return true;
+    }, {}, true);
+
+    // Render nodes, decode capabilities and the shared memory budgets
+    startup.add("layers", [this] { return initializeLayerManager(); }, {}, !background);
+
+    // Global MIDI/LTC sync source (shared across all layers)
+    startup.add("sync", [this] {
+        initializeGlobalSyncSource();
+        return true;
+    }, {}, !background);
+
+    // Commands are only dispatched from the main loop
+    startup.add("remote", [this] {
+        if (!initializeRemoteControl()) {
+            LOG_WARNING << "Failed to initialize remote control (continuing without it)";
+            // Don't fail initialization if remote control fails
+        }
+        return true;
+    }, {"layers"}, !background);
+
+    // Cluster role and canvas window (the canvas is resized on the GL thread)
+    startup.add("cluster", [this] {
+        initializeCluster();
+        return true;
+    }, {"display", "remote"}, true);
 
-    // Initialize global MIDI sync source (shared across all layers)
-    initializeGlobalSyncSource();
+    // Optional recording and shared-memory output (fail soft: the show goes on without them)
+    startup.add("outputs", [this] { return initializeVirtualOutputs(); }, {"display"}, true);
+
+    startup.add("loader", [this] {
+        initializePlaybackServices();
+        return true;
+    }, {"display", "layers"}, true);
 
     // Create initial layer if movie file provided
-    std::string movieFile = config_->getMovieFile();
-    if (!movieFile.empty()) {
+    startup.add("initial_layer", [this] {
+        std::string movieFile = config_->getMovieFile();
+        if (movieFile.empty()) {
+            return true;
+        }
         if (!createInitialLayer()) {
             LOG_ERROR << "Failed to create initial layer with file: " << movieFile;
             return false;
         }
         LOG_INFO << "Loaded video file: " << movieFile;
+        return true;
+    }, {"loader", "outputs", "sync", "remote"}, true);
+
+    // Journaled cues load alongside the initial layer's; the sync source
+    // seeks each one to the current MTC frame once it is ready
+    startup.add("resume", [this] { return resumeShow(); }, {"initial_layer"}, true);
+
+    startup.add("sync_test", [this] {
+        if (config_->getBool("sync_test", false) && !initializeSyncTest()) {
+            LOG_WARNING << "Sync test: not started";
+        }
+        return true;
+    }, {"initial_layer"}, true);
+
+    bool started = startup.run();
+    startup.logTimings();
+    startupTimings_ = startup.timings();
+    if (!started) {
+        return false;
+    }
+
+    if (config_->getBool("show_journal", true)) {
+        showJournal_ = std::make_unique<ShowJournal>();
+        if (!showJournal_->open(journalPath)) {
+            showJournal_.reset();
+        }
     }
 
     initialized_ = true;
@@ -154,6 +371,59 @@ bool VideoComposerApplication::initialize(int argc, char** argv) {
     return true;
 }
 
+void VideoComposerApplication::initializePlaybackServices() {
+    // Initialize async video loader (for non-blocking video file loading)
+    asyncVideoLoader_ = std::make_unique<AsyncVideoLoader>();
+    asyncVideoLoader_->initialize(config_.get(), displayBackend_.get());
+    
+    // Layers switch to their proxy files when shown small, overloaded or scrubbed
+    proxySwitcher_ = std::make_unique<ProxySwitcher>();
+    ProxySwitcher::Settings proxySettings;
+    proxySettings.enabled = config_->getBool("proxy_media", true) && config_->getBool("proxy_switching", true);
+    proxySettings.loadMissesPerSecond = config_->getDouble("proxy_load_misses", 2.0);
+    proxySettings.holdSeconds = config_->getDouble("proxy_hold_s", 10.0);
+    
+    // The load governor degrades layers by priority (proxies first, then
+    // half rate); it replaces the switcher's all-layers overload rule
+    decodeGovernor_ = std::make_unique<DecodeGovernor>();
+    DecodeGovernor::Settings governorSettings;
+    governorSettings.enabled = config_->getBool("governor", true);
+    governorSettings.missesPerSecond = config_->getDouble("governor_misses", 2.0);
+    governorSettings.lateFramesPerSecond = config_->getDouble("governor_late_frames", 2.0);
+    governorSettings.holdSeconds = proxySettings.holdSeconds;
+    decodeGovernor_->configure(governorSettings);
+    if (governorSettings.enabled) {
+        proxySettings.loadMissesPerSecond = 0.0;
+    }
+    proxySwitcher_->configure(proxySettings);
+    
+    // Loads are profiled and their load predicted before they play
+    loadAdmission_ = std::make_unique<LoadAdmission>();
+    LoadAdmission::Settings admissionSettings;
+    admissionSettings.policy = LoadAdmission::parsePolicy(config_->getString("admission", "warn"));
+    admissionSettings.headroom = config_->getDouble("admission_headroom", 0.9);
+    loadAdmission_->configure(admissionSettings);
+    std::string admissionCosts = config_->getString("admission_costs", "");
+    if (!admissionCosts.empty()) {
+        loadAdmission_->loadBenchmarkFile(admissionCosts);
+    }
+    
+    // Idle until a target subscribes (/videocomposer/stats/subscribe)
+    telemetry_ = std::make_unique<TelemetryPublisher>();
+
+    // Idle until a poster frame is asked for (/videocomposer/show/thumbnail)
+    thumbnails_ = std::make_unique<ThumbnailService>();
+    ThumbnailService::Settings thumbnailSettings;
+    thumbnailSettings.cacheDir = config_->getString("thumbnail_cache_dir", "");
+    thumbnailSettings.format = ThumbnailService::parseFormat(config_->getString("thumbnail_format", "jpg"));
+    thumbnailSettings.width = config_->getInt("thumbnail_width", ThumbnailService::DEFAULT_WIDTH);
+    thumbnailSettings.hardware = config_->getBool("thumbnail_hardware", true);
+    thumbnails_->configure(thumbnailSettings);
+
+    // Initialize OSD manager
+    osdManager_ = std::make_unique<OSDManager>();
+}
+
 bool VideoComposerApplication::initializeConfiguration(int argc, char** argv) {
     config_ = std::make_unique<ConfigurationManager>();
     
@@ -172,6 +442,13 @@ bool VideoComposerApplication::initializeConfiguration(int argc, char** argv) {
 }
 
 bool VideoComposerApplication::initializeDisplay() {
+    // Program binaries must be configured before the first GL context compiles shaders
+    ProgramBinaryCache::instance().configure(config_->getBool("shader_cache", true),
+                                             config_->getString("shader_cache_dir", ""));
+    
+    // Capture for the virtual outputs keeps this many readbacks in flight
+    ReadbackRing::setDefaultDepth(config_->getInt("capture_readback_depth", ReadbackRing::DEFAULT_DEPTH));
+    
     // Create display manager
     displayManager_ = std::make_unique<DisplayManager>();
     
@@ -182,6 +459,84 @@ bool VideoComposerApplication::initializeDisplay() {
     bool waylandAttempted = false;
     bool needsDisplayManager = true;
     
+    // No GPU to render with: composite on the CPU instead
+    auto openSoftwareDisplay = [this]() {
+        auto software = std::make_unique<SoftwareDisplay>();
+        software->setDimensions(1920, 1080);
+        if (!software->openWindow()) {
+            return false;
+        }
+        displayBackend_ = std::move(software);
+        return true;
+    };
+    
+    // VIDEOCOMPOSER_HEADLESS=1: offscreen, whatever display server there is;
+    // =software: the CPU compositor, even with a GPU
+    const char* headlessEnv = getenv("VIDEOCOMPOSER_HEADLESS");
+    std::string headlessMode = headlessEnv ? headlessEnv : "";
+    
+    // --vulkan-display: composite with Vulkan, present through VK_KHR_display
+    if (config_->getBool("vulkan_display", false) && !offlineRender_) {
+#ifdef HAVE_VULKAN_DISPLAY
+        auto vulkan = std::make_unique<VulkanDisplay>();
+        std::string resMode = config_->getString("resolution_mode", "1080p");
+        if (!vulkan->setResolutionMode(resMode)) {
+            LOG_ERROR << "Invalid resolution mode: " << resMode;
+            LOG_ERROR << "Valid modes: native, maximum, 1080p, 720p, 4k";
+            return false;
+        }
+        if (vulkan->openWindow()) {
+            LOG_INFO << "Vulkan display backend initialized with " << vulkan->getOutputCount() << " output(s)";
+            displayBackend_ = std::move(vulkan);
+            needsDisplayManager = false;
+        } else {
+            LOG_WARNING << "Vulkan display backend failed - falling back to the GL backends";
+        }
+#else
+        LOG_WARNING << "Vulkan display not available - rebuild with -DENABLE_VULKAN_DISPLAY=ON";
+#endif
+    }
+    
+    if (displayBackend_) {
+        // Opened above
+    } else if (headlessMode == "software" && !offlineRender_) {
+        if (!openSoftwareDisplay()) {
+            LOG_ERROR << "VIDEOCOMPOSER_HEADLESS: could not open the software display";
+            return false;
+        }
+        LOG_INFO << "Software display backend initialized (1920x1080, VIDEOCOMPOSER_HEADLESS)";
+        needsDisplayManager = false;
+    } else
+#ifdef HAVE_DRM_BACKEND
+    if ((headlessMode == "1" || headlessMode == "true") && !offlineRender_) {
+        auto headless = std::make_unique<HeadlessDisplay>();
+        headless->setDimensions(1920, 1080);
+        if (headless->openWindow()) {
+            LOG_INFO << "Headless display backend initialized (1920x1080, VIDEOCOMPOSER_HEADLESS)";
+            displayBackend_ = std::move(headless);
+        } else if (openSoftwareDisplay()) {
+            LOG_WARNING << "VIDEOCOMPOSER_HEADLESS: no EGL context - compositing on the CPU";
+        } else {
+            LOG_ERROR << "VIDEOCOMPOSER_HEADLESS: could not open the headless display";
+            return false;
+        }
+        needsDisplayManager = false;
+    } else if (offlineRender_) {
+        // Offline render: composite offscreen at the size of the file
+        int width = std::max(16, config_->getInt("render_width", 1920));
+        int height = std::max(16, config_->getInt("render_height", 1080));
+        auto headless = std::make_unique<HeadlessDisplay>();
+        headless->setDimensions(width, height);
+        headless->setLosslessCapture(true);   // Every frame reaches the file
+        if (!headless->openWindow()) {
+            LOG_ERROR << "Offline render: could not open the headless display";
+            return false;
+        }
+        LOG_INFO << "Offline render: headless display " << width << "x" << height;
+        displayBackend_ = std::move(headless);
+        needsDisplayManager = false;
+    } else
+#endif
 #ifdef HAVE_WAYLAND
     if (waylandDisplay) {
         LOG_INFO << "WAYLAND_DISPLAY=" << waylandDisplay << " detected - attempting Wayland backend";
@@ -221,8 +576,11 @@ bool VideoComposerApplication::initializeDisplay() {
                 LOG_INFO << "Headless display backend initialized (1920x1080)";
                 displayBackend_ = std::move(headless);
                 needsDisplayManager = false;
+            } else if (openSoftwareDisplay()) {
+                LOG_WARNING << "No EGL context - compositing on the CPU (software display, 1920x1080)";
+                needsDisplayManager = false;
             } else {
-                LOG_ERROR << "All display backends failed (X11, Wayland, DRM, Headless)";
+                LOG_ERROR << "All display backends failed (X11, Wayland, DRM, Headless, Software)";
                 return false;
             }
         }
@@ -265,6 +623,53 @@ bool VideoComposerApplication::initializeDisplay() {
         }
     }
 
+    // Optional: CPU-frame texture uploads on their own thread
+    if (config_->getBool("upload_thread", false) && !displayBackend_->enableUploadThread()) {
+        LOG_WARNING << "Upload thread not available with this display backend";
+    }
+
+    // Planar YUV frames need the YUV shaders; otherwise convert on the CPU
+    OpenGLRenderer* glRenderer = displayBackend_->getRenderer();
+    if (config_->getBool("gpu_yuv", true) && glRenderer && !glRenderer->supportsPlanarYUV()) {
+        LOG_INFO << "YUV shaders unavailable - software-decoded frames are converted on the CPU";
+        config_->setBool("gpu_yuv", false);
+    }
+    if (!glRenderer && displayBackend_->importsDmaBuf()) {
+        // Hardware frames are imported as DMA-BUFs; software ones still packed
+        LOG_INFO << "No GL renderer - hardware frames imported as DMA-BUFs, software ones decoded to BGRA";
+        config_->setBool("gpu_yuv", false);
+    } else if (!glRenderer) {
+        // The software compositor takes packed frames in memory only
+        LOG_INFO << "No GL renderer - decoding in software to BGRA frames";
+        config_->setBool("gpu_yuv", false);
+        config_->setString("hardware_decoder", "software");
+    }
+    if (glRenderer) {
+        glRenderer->setLayerBatching(config_->getBool("layer_batching", true));
+        glRenderer->setDeinterlaceMode(FieldSelector::parseMode(config_->getString("deinterlace", "auto")));
+        glRenderer->gpuTimer().setEnabled(config_->getBool("gpu_timers", true));
+    }
+    if (config_->getBool("dynamic_resolution", false)) {
+        if (!config_->getBool("gpu_timers", true)) {
+            LOG_WARNING << "Dynamic resolution needs the GPU timers; compositing at native size";
+        } else if (!displayBackend_->setDynamicResolution(
+                       true, static_cast<float>(config_->getDouble("dynamic_resolution_min", 0.5)))) {
+            LOG_WARNING << "Dynamic resolution needs the virtual canvas (DRM backend)";
+        }
+    }
+    
+    // Every texture, surface and cache is accounted against one video memory
+    // budget; caches are evicted before an allocation would exceed it
+    int64_t vramBudget = static_cast<int64_t>(std::max(0, config_->getInt("vram_budget_mb", 0))) * 1024 * 1024;
+    if (vramBudget == 0 && glRenderer) {
+        int64_t total = glRenderer->getVideoMemoryTotal();
+        vramBudget = total > 0 ? total / 10 * 9 : 0;
+    }
+    MemoryBudget::instance().setLimit(MemoryBudget::Pool::VRAM, static_cast<size_t>(vramBudget));
+    if (vramBudget > 0) {
+        LOG_INFO << "Video memory budget: " << vramBudget / (1024 * 1024) << " MB";
+    }
+
 #ifdef HAVE_VAAPI_INTEROP
     // VAAPI zero-copy interop is now per-instance (created by each VideoFileInput)
     // Each layer gets its own interop instance when it opens a file
@@ -276,6 +681,267 @@ bool VideoComposerApplication::initializeDisplay() {
     return true;
 }
 
+bool VideoComposerApplication::initializeVirtualOutputs() {
+    // The render file is the point of an offline render: no file, no render
+    if (!initializeRenderOutput()) {
+        return false;
+    }
+    initializeRecording();
+    initializeSharedMemoryOutput();
+    initializeNDIOutput();
+    initializeDeckLinkOutput();
+    initializePreviewOutput();
+    if (!outputSinkManager_) {
+        return true;
+    }
+    
+    displayBackend_->setOutputSinkManager(outputSinkManager_.get());
+    displayBackend_->setCaptureEnabled(true);
+    if (!displayBackend_->isCaptureEnabled()) {
+        LOG_WARNING << "Virtual outputs need the DRM/KMS backend - this display backend has no capture";
+    }
+    return true;
+}
+
+bool VideoComposerApplication::initializeRenderOutput() {
+    std::string destination = config_->getString("render", "");
+    if (!offlineRender_ || destination.empty()) {
+        return true;
+    }
+    
+    std::string codec = config_->getString("render_codec", "prores");
+    if (codec != "prores" && codec != "hap" && codec != "hap_alpha" && codec != "hap_q") {
+        LOG_ERROR << "Offline render: unknown codec '" << codec << "' (prores, hap, hap_alpha or hap_q)";
+        return false;
+    }
+    
+    unsigned int width = 0, height = 0;
+    displayBackend_->getWindowSize(&width, &height);
+    OutputSinkConfig sinkConfig;
+    sinkConfig.width = static_cast<int>(width);
+    sinkConfig.height = static_cast<int>(height);
+    sinkConfig.frameRate = config_->getDouble("render_fps", 25.0);
+    sinkConfig.codec = codec;
+    
+    auto encoder = std::make_unique<FileEncoderOutput>();
+    if (!encoder->open(destination, sinkConfig)) {
+        LOG_ERROR << "Offline render: could not open " << destination;
+        return false;
+    }
+    
+    if (!outputSinkManager_) {
+        outputSinkManager_ = std::make_unique<OutputSinkManager>();
+    }
+    outputSinkManager_->addSink(std::move(encoder));
+    return true;
+}
+
+bool VideoComposerApplication::initializeRecording() {
+    std::string destination = config_->getString("record", "");
+    if (destination.empty()) {
+        return true;
+    }
+#ifdef HAVE_VAAPI_INTEROP
+    unsigned int width = 0, height = 0;
+    displayBackend_->getWindowSize(&width, &height);
+    
+    OutputSinkConfig sinkConfig;
+    sinkConfig.width = static_cast<int>(width);
+    sinkConfig.height = static_cast<int>(height);
+    double fps = config_->getDouble("fps", 0.0);
+    sinkConfig.frameRate = fps > 0.0 ? fps : config_->getDouble("internal_sync_fps", 25.0);
+    sinkConfig.codec = config_->getString("record_codec", "h264");
+    sinkConfig.bitrate = config_->getInt("record_bitrate_kbps", 0) * 1000;
+    
+    // The encoder imports its surfaces into the canvas context
+    displayBackend_->makeCurrent();
+    auto encoder = std::make_unique<VaapiEncoderOutput>(displayBackend_.get());
+    if (!encoder->open(destination, sinkConfig)) {
+        LOG_ERROR << "Recording disabled: could not open the VAAPI encoder for " << destination;
+        return false;
+    }
+    
+    if (!outputSinkManager_) {
+        outputSinkManager_ = std::make_unique<OutputSinkManager>();
+    }
+    outputSinkManager_->addSink(std::move(encoder));
+    return true;
+#else
+    LOG_ERROR << "Recording disabled: built without VAAPI interop";
+    return false;
+#endif
+}
+
+bool VideoComposerApplication::initializePreviewOutput() {
+    std::string destination = config_->getString("preview", "");
+    if (destination.empty()) {
+        return true;
+    }
+#ifdef HAVE_VAAPI_INTEROP
+    PreviewConfig previewConfig;
+    previewConfig.width = config_->getInt("preview_width", 640);
+    previewConfig.height = config_->getInt("preview_height", 360);
+    previewConfig.fps = config_->getDouble("preview_fps", 5.0);
+    previewConfig.gpuBudgetMs = config_->getDouble("preview_gpu_budget_ms", 1.0);
+    
+    // Its own encoder: the program's sinks never see the atlas
+    OutputSinkConfig sinkConfig;
+    sinkConfig.width = previewConfig.width;
+    sinkConfig.height = previewConfig.height;
+    sinkConfig.frameRate = previewConfig.fps;
+    sinkConfig.codec = "h264";
+    sinkConfig.bitrate = config_->getInt("preview_bitrate_kbps", 1000) * 1000;
+    
+    // Atlas and encoder surfaces are objects of the canvas context
+    displayBackend_->makeCurrent();
+    auto preview = std::make_unique<PreviewRenderer>();
+    if (!preview->init(previewConfig)) {
+        LOG_ERROR << "Preview disabled: could not create the multiview atlas";
+        return false;
+    }
+    auto encoder = std::make_unique<VaapiEncoderOutput>(displayBackend_.get());
+    if (!encoder->open(destination, sinkConfig)) {
+        LOG_ERROR << "Preview disabled: could not open the VAAPI encoder for " << destination;
+        preview->cleanup();
+        return false;
+    }
+    preview->setSink(encoder.get());
+    if (!displayBackend_->setPreviewRenderer(preview.get())) {
+        LOG_WARNING << "Preview disabled: it needs the DRM/KMS backend";
+        encoder->close();
+        preview->cleanup();
+        return false;
+    }
+    LOG_INFO << "Preview: streaming the multiview to " << destination;
+    preview_ = std::move(preview);
+    previewSink_ = std::move(encoder);
+    return true;
+#else
+    LOG_ERROR << "Preview disabled: built without VAAPI interop";
+    return false;
+#endif
+}
+
+bool VideoComposerApplication::initializeSharedMemoryOutput() {
+    std::string path = config_->getString("shm_output", "");
+    if (path.empty()) {
+        return true;
+    }
+    
+    std::string format = config_->getString("shm_format", "rgba");
+    OutputSinkConfig sinkConfig;
+    if (format == "rgba") {
+        sinkConfig.format = PixelFormat::RGBA32;
+    } else if (format == "bgra") {
+        sinkConfig.format = PixelFormat::BGRA32;
+    } else if (format == "uyvy") {
+        sinkConfig.format = PixelFormat::UYVY422;
+    } else if (format == "nv12") {
+        sinkConfig.format = PixelFormat::NV12;
+    } else if (format == "i420") {
+        sinkConfig.format = PixelFormat::YUV420P;
+    } else {
+        LOG_ERROR << "Shared-memory output disabled: unknown format '" << format << "'";
+        return false;
+    }
+    
+    unsigned int width = 0, height = 0;
+    displayBackend_->getWindowSize(&width, &height);
+    sinkConfig.width = static_cast<int>(width);
+    sinkConfig.height = static_cast<int>(height);
+    
+    auto sink = std::make_unique<SharedMemoryOutput>(config_->getBool("shm_dmabuf", false));
+    if (!sink->open(path, sinkConfig)) {
+        LOG_ERROR << "Shared-memory output disabled: could not open " << path;
+        return false;
+    }
+    
+    if (!outputSinkManager_) {
+        outputSinkManager_ = std::make_unique<OutputSinkManager>();
+    }
+    outputSinkManager_->addSink(std::move(sink));
+    return true;
+}
+
+bool VideoComposerApplication::initializeNDIOutput() {
+    std::string name = config_->getString("ndi_output", "");
+    if (name.empty()) {
+        return true;
+    }
+#ifdef HAVE_NDI_SDK
+    unsigned int width = 0, height = 0;
+    displayBackend_->getWindowSize(&width, &height);
+    
+    OutputSinkConfig sinkConfig;
+    sinkConfig.width = static_cast<int>(width);
+    sinkConfig.height = static_cast<int>(height);
+    sinkConfig.format = PixelFormat::UYVY422;
+    double fps = config_->getDouble("fps", 0.0);
+    sinkConfig.frameRate = fps > 0.0 ? fps : config_->getDouble("internal_sync_fps", 25.0);
+    
+    auto sink = std::make_unique<NDIOutput>();
+    if (!sink->open(name, sinkConfig)) {
+        LOG_ERROR << "NDI output disabled: could not create NDI source '" << name << "'";
+        return false;
+    }
+    
+    if (!outputSinkManager_) {
+        outputSinkManager_ = std::make_unique<OutputSinkManager>();
+    }
+    outputSinkManager_->addSink(std::move(sink));
+    return true;
+#else
+    LOG_ERROR << "NDI output disabled: built without the NDI SDK";
+    return false;
+#endif
+}
+
+bool VideoComposerApplication::initializeDeckLinkOutput() {
+    std::string device = config_->getString("decklink_output", "");
+    if (device.empty()) {
+        return true;
+    }
+#ifdef HAVE_DECKLINK_SDK
+    unsigned int width = 0, height = 0;
+    displayBackend_->getWindowSize(&width, &height);
+    
+    OutputSinkConfig sinkConfig;
+    sinkConfig.width = static_cast<int>(width);
+    sinkConfig.height = static_cast<int>(height);
+    sinkConfig.format = PixelFormat::UYVY422;
+    double fps = config_->getDouble("fps", 0.0);
+    sinkConfig.frameRate = fps > 0.0 ? fps : config_->getDouble("internal_sync_fps", 25.0);
+    sinkConfig.codec = config_->getString("decklink_mode", "");  // Mode name, empty = by size and rate
+    
+    auto sink = std::make_unique<DeckLinkOutput>();
+    if (!sink->open(device == "auto" ? "" : device, sinkConfig)) {
+        LOG_ERROR << "DeckLink output disabled: could not open card '" << device << "'";
+        return false;
+    }
+    if (config_->getBool("decklink_clock", false)) {
+        // The show clock counts the card's frames instead of the display's
+        outputClockSinkId_ = sink->getId();
+    }
+    
+    if (!outputSinkManager_) {
+        outputSinkManager_ = std::make_unique<OutputSinkManager>();
+    }
+    outputSinkManager_->addSink(std::move(sink));
+    return true;
+#else
+    LOG_ERROR << "DeckLink output disabled: built without the DeckLink SDK";
+    return false;
+#endif
+}
+
+bool VideoComposerApplication::getOutputClock(int64_t& frame, double& rateHz, int64_t& leadNs) {
+    if (outputClockSinkId_.empty() || !outputSinkManager_) {
+        return false;
+    }
+    OutputSink* sink = outputSinkManager_->getSink(outputClockSinkId_);
+    return sink && sink->isReady() && sink->getOutputClock(frame, rateHz, leadNs);
+}
+
 bool VideoComposerApplication::initializeRemoteControl() {
     // Get OSC port from config (default: 7000)
     int oscPort = config_->getInt("osc_port", 7000);
@@ -288,11 +954,101 @@ bool VideoComposerApplication::initializeRemoteControl() {
         return false;
     }
     
+    // Same commands from controllers on this machine, without the network
+    std::string localControl = config_->getString("local_control", "");
+    if (!localControl.empty() && !remoteControl_->openLocalChannel(localControl)) {
+        LOG_WARNING << "Local control channel not available on " << localControl;
+    }
+    
     return true;
 }
 
 bool VideoComposerApplication::initializeLayerManager() {
     layerManager_ = std::make_unique<LayerManager>();
+    
+    // Software-decoded layers load their frames in parallel
+    layerManager_->setUpdateThreads(config_->getInt("layer_threads", -1));
+    layerManager_->setUpdateDeadline(std::chrono::milliseconds(
+        std::max(0, config_->getInt("layer_update_deadline_ms", LayerManager::DEFAULT_UPDATE_DEADLINE_MS))));
+    
+    // Decode-ahead queues share one memory budget
+    DecodeAheadBudget::instance().configure(
+        static_cast<size_t>(std::max(0, config_->getInt("decode_ahead_budget_mb", 0))) * 1024 * 1024,
+        config_->getDouble("decode_underrun_target", DecodeAheadBudget::DEFAULT_UNDERRUN_PROBABILITY));
+    
+    // ...and one decoder thread budget, split by resolution and priority
+    DecodeThreadBudget::instance().configure(std::max(0, config_->getInt("decode_threads", 0)));
+    
+    // Closed layers leave their opened decoders for the next load of the same format
+    DecoderContextPool::instance().setCapacity(
+        static_cast<size_t>(std::max(0, config_->getInt("decoder_pool", 2))));
+    
+    // Giant stills: cut into a tile cache once, streamed into a fixed atlas
+    TiledImage::Settings tiling;
+    tiling.threshold = std::max(0, config_->getInt("tiled_image_threshold", 8192));
+    tiling.vramBytes = static_cast<size_t>(std::max(1, config_->getInt("tiled_image_vram_mb", 256))) * 1024 * 1024;
+    tiling.cacheDir = config_->getString("tile_cache_dir", "");
+    TiledImage::configure(tiling);
+    
+#ifdef HAVE_NDI_SDK
+    // NDI sources are known before the first NDI cue asks for one
+    if (config_->getBool("ndi_discovery", true)) {
+        NDIDirectory::instance().start();
+    }
+#endif
+    
+    // ...and decode-ahead work is admitted by deadline across all layers
+    DecodeScheduler::instance().configure(std::max(0, config_->getInt("decode_slots", 0)),
+                                          std::max(0, config_->getInt("hw_decode_slots", 0)));
+    
+    // Preloaded (RAM-resident) clips share one memory budget
+    RamClipCache::instance().setBudget(
+        static_cast<size_t>(std::max(0, config_->getInt("preload_budget_mb", 2048))) * 1024 * 1024);
+    
+    // ...within the RAM budget of all frame pools and caches
+    MemoryBudget::instance().setLimit(
+        MemoryBudget::Pool::RAM,
+        static_cast<size_t>(std::max(0, config_->getInt("ram_budget_mb", 0))) * 1024 * 1024);
+    
+    // Page cache kept for the cues that come next
+    PageCachePolicy::instance().configure(
+        config_->getBool("page_cache_policy", true),
+        static_cast<size_t>(std::max(0, config_->getInt("page_cache_prefetch_mb", 64))) * 1024 * 1024,
+        static_cast<size_t>(std::max(0, config_->getInt("page_cache_keep_behind_mb", 64))) * 1024 * 1024);
+    
+    // Hardware decoders are spread over the GPUs (render nodes) that can decode
+    std::string renderNodes = config_->getString("render_nodes", "auto");
+    std::string primaryNode = config_->getString("primary_render_node", "");
+    if (renderNodes == "auto") {
+        RenderNodeManager::instance().enumerate(primaryNode);
+    } else if (renderNodes != "off" && !renderNodes.empty()) {
+        std::vector<std::string> paths;
+        size_t start = 0;
+        while (start <= renderNodes.size()) {
+            size_t comma = renderNodes.find(',', start);
+            std::string path = renderNodes.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            if (!path.empty()) {
+                paths.push_back(path);
+            }
+            if (comma == std::string::npos) {
+                break;
+            }
+            start = comma + 1;
+        }
+        RenderNodeManager::instance().setNodes(paths, primaryNode);
+    }
+    
+    // Decode capabilities of those nodes, probed once (or loaded from the cache file)
+    std::vector<std::string> decodeNodes;
+    for (const RenderNodeManager::Node& node : RenderNodeManager::instance().getNodes()) {
+        decodeNodes.push_back(node.path);
+    }
+    HardwareDeviceCache::instance().build(decodeNodes, config_->getString("hw_caps_cache", ""));
+    
+#ifdef ENABLE_HAP_DIRECT
+    // HAP layers share one chunk decompression pool, started by the first HAP layer
+    HapChunkPool::setInitialConcurrency(static_cast<size_t>(std::max(0, config_->getInt("hap_threads", -1))));
+#endif
     return true;
 }
 
@@ -338,6 +1094,9 @@ int VideoComposerApplication::run() {
     }
     
     LOG_INFO << "Starting cuems-videocomposer application";
+    if (offlineRender_) {
+        return runOffline();
+    }
 
     // Multi-layer compositor main loop:
     // - Run at DISPLAY refresh rate, driven by vsync/page-flip
@@ -349,21 +1108,44 @@ int VideoComposerApplication::run() {
     // The display rate is the common output rate that accommodates all.
     //
     // Multi-monitor handling:
-    // - With multiple monitors at different refresh rates (e.g., 60Hz + 50Hz),
-    //   we wait for ALL page flips to complete before the next frame
-    // - Effective rate is limited by the slowest monitor in sequential mode
-    // - TODO: Atomic modesetting would allow independent flip timing per monitor
+    // - Monitors at the same refresh rate flip together (one atomic commit)
+    // - With different refresh rates (e.g., 60Hz + 50Hz) each CRTC flips on
+    //   its own vblank: the loop runs at the fastest monitor's rate and a
+    //   slower one shows the newest canvas whenever its previous flip is done
+    //   (VIDEOCOMPOSER_SYNC_FLIPS=1 restores lockstep flips)
     //
     // Frame updates are optimized:
     // - Each layer only decodes when its frame changes (based on MTC timing)
     // - Same-frame requests skip decoding (cached in frame_ buffer)
-    // - Rendering happens every vsync for tear-free smooth output
+    // - Rendering happens every vsync for tear-free smooth output, except
+    //   while nothing is on screen (idle power mode, IdleDetector)
     
     LOG_INFO << "Entering video update loop @ display refresh rate (vsync-driven)";
-    
-    // Timing instrumentation for diagnosing micro-jumps
+    initializeIdle();
+    
+    // Frame timeline (FrameTracer): one span per stage, dumped on demand
+    FrameTracer::instance().setThreadName("render");
+    
+    // Startup threads are done: the main thread becomes the render thread
+    // (threads created from here on set their own role)
+    ThreadRoles::instance().apply(ThreadRole::RENDER);
+    
+    // Per-frame lists (layer lists, OSD items, flip surfaces) come from
+    // this arena, reset every vsync: the steady state takes nothing from
+    // the heap. Debug builds count what still does (AllocationCounter).
+    FrameArena frameArena;
+    FrameArena::Scope arenaScope(&frameArena);
+    lastAllocationReportUs_ = vc_get_monotonic_time();
+    int64_t frameNumber = 0;
+    int64_t renderedFrames = 0;
     while (running_ && shouldContinue()) {
-        processEvents();
+        frameArena.reset();
+        uint64_t allocationsBefore = AllocationCounter::threadCount();
+        FRAME_TRACE_SCOPE("frame", frameNumber++);
+        {
+            FRAME_TRACE_SCOPE("events");
+            processEvents();
+        }
         
         // Make OpenGL context current before updating layers
         // Required for VAAPI: EGL image creation needs current EGL context
@@ -371,46 +1153,430 @@ int VideoComposerApplication::run() {
             displayBackend_->makeCurrent();
         }
         
-        updateLayers();
+        updateDisplayRefresh();
+        {
+            FRAME_TRACE_SCOPE("pace");
+            paceVariableRefresh();
+        }
+        int64_t workStartNs = FrameTracer::nowNs();
+        updateInternalClock();
+        trackLateFrames();
+        updatePresentationLead();
+        sampleFrameClock();
+        runScheduledCommands();
+        animateLayers();
+        {
+            FRAME_TRACE_SCOPE("update");
+            updateLayers();
+        }
+        reportSeekCompletions();
+        reportThumbnails();
+        updateGpuTimingOSD();
+        updateTelemetry();
+        updateShowJournal();
+        updateCluster();
+        planSyncTest();
+        
+        // Render - vsync/page-flip wait provides timing (60Hz); an idle
+        // scene sleeps instead, the outputs holding their last frame
+        if (updateIdle()) {
+            {
+                FRAME_TRACE_SCOPE("latch");
+                lateLatch();
+            }
+            updateFlightRecorder(frameNumber, workStartNs);
+            FRAME_TRACE_SCOPE("render");
+            render();
+            if (frameLimit_ > 0 && ++renderedFrames >= frameLimit_) {
+                running_ = false;
+            }
+        } else {
+            FRAME_TRACE_SCOPE("idle");
+            waitWhileIdle();
+        }
+        updateSyncTest();
         
-        // Render - vsync/page-flip wait provides timing (60Hz)
-        render();
+        if (AllocationCounter::isEnabled()) {
+            reportLoopAllocations(AllocationCounter::threadCount() - allocationsBefore, frameArena);
+        }
     }
 
     return 0;
 }
 
-void VideoComposerApplication::processEvents() {
-    // Process display window events
-    if (displayBackend_) {
-        displayBackend_->handleEvents();
+int VideoComposerApplication::runOffline() {
+    if (!internalClock_ || !displayBackend_ || !layerManager_) {
+        LOG_ERROR << "Offline render: no internal clock or display";
+        return 1;
     }
+    FrameTracer::instance().setThreadName("render");
+    double fps = internalClock_->getFramerate();
     
-    // Process remote control events
-    if (remoteControl_) {
-        remoteControl_->process();
+    // The cues loaded at startup are in from the first frame
+    waitForPendingLoads();
+    
+    int64_t start = std::max<int64_t>(0, SMPTEUtils::smpteStringToFrame(config_->getString("render_start", "0"), fps));
+    int64_t frames = config_->getInt("render_frames", 0);
+    if (frames <= 0) {
+        frames = longestLayerFrames(fps) - start;
+    }
+    if (frames <= 0) {
+        LOG_ERROR << "Offline render: nothing to render (no layer of known length after frame " << start
+                  << "; give --render-frames)";
+        return 1;
     }
     
-    // Process completed async video loads
-    processAsyncLoads();
-}
-
+    // The loop is paced by its slowest stage: decode (blocking on
+    // underruns), composite, readback and encode (blocking when full)
+    LOG_INFO << "Offline render: " << frames << " frames at " << fps << " fps from "
+             << SMPTEUtils::frameToSmpteString(start, fps) << " to " << config_->getString("render", "");
+    internalClock_->locate(start);
+    internalClock_->start();
+    
+    FrameArena frameArena;
+    FrameArena::Scope arenaScope(&frameArena);
+    int64_t beginUs = vc_get_monotonic_time();
+    int64_t lastReportUs = beginUs;
+    int64_t rendered = 0;
+    for (; rendered < frames && running_; ++rendered) {
+        frameArena.reset();
+        FRAME_TRACE_SCOPE("frame", rendered);
+        processEvents();
+        waitForPendingLoads();
+        displayBackend_->makeCurrent();
+        
+        // One clock frame per composite; tweens follow show time, not the wall clock
+        internalClock_->advanceToVblank(rendered, fps);
+        presentationUs_ = vc_get_monotonic_time();  // No display: no lead
+        sampleFrameClock();
+        runScheduledCommands();
+        layerManager_->animateAll(beginUs + static_cast<int64_t>(static_cast<double>(rendered) * 1e6 / fps));
+        {
+            FRAME_TRACE_SCOPE("update");
+            updateLayers();
+        }
+        {
+            FRAME_TRACE_SCOPE("render");
+            render();
+        }
+        
+        int64_t now = vc_get_monotonic_time();
+        if (now - lastReportUs >= 2000000) {
+            double elapsed = static_cast<double>(now - beginUs) / 1e6;
+            LOG_INFO << "Offline render: " << rendered + 1 << " / " << frames << " frames ("
+                     << static_cast<double>(rendered + 1) / elapsed / fps << "x realtime)";
+            lastReportUs = now;
+        }
+    }
+    
+    // The last readback and everything queued in front of the encoder
+#ifdef HAVE_DRM_BACKEND
+    static_cast<HeadlessDisplay*>(displayBackend_.get())->flushCapture();
+#endif
+    if (outputSinkManager_) {
+        outputSinkManager_->flush();
+    }
+    
+    double elapsed = std::max(1e-6, static_cast<double>(vc_get_monotonic_time() - beginUs) / 1e6);
+    if (rendered < frames) {
+        LOG_WARNING << "Offline render: stopped after " << rendered << " of " << frames << " frames";
+        return 1;
+    }
+    LOG_INFO << "Offline render: " << rendered << " frames in " << elapsed << " s ("
+             << static_cast<double>(rendered) / elapsed << " fps, "
+             << static_cast<double>(rendered) / elapsed / fps << "x realtime)";
+    return 0;
+}
+
+void VideoComposerApplication::waitForPendingLoads() {
+    while (running_ && asyncVideoLoader_ && asyncVideoLoader_->pendingCount() > 0) {
+        asyncVideoLoader_->pollCompleted();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+int64_t VideoComposerApplication::longestLayerFrames(double fps) const {
+    int64_t longest = 0;
+    for (const VideoLayer* layer : static_cast<const LayerManager&>(*layerManager_).getLayers()) {
+        if (!layer || !layer->isReady()) {
+            continue;
+        }
+        FrameInfo info = layer->getFrameInfo();
+        if (info.totalFrames <= 0 || info.framerate <= 0.0 || layer->getTimeScale() <= 0.0) {
+            continue;   // Live sources and stills have no end
+        }
+        // File frame = show frame * scale + offset, at the layer's own rate
+        double seconds = static_cast<double>(info.totalFrames - layer->getTimeOffset()) /
+                         layer->getTimeScale() / info.framerate;
+        longest = std::max(longest, static_cast<int64_t>(std::ceil(seconds * fps)));
+    }
+    return longest;
+}
+
+void VideoComposerApplication::reportLoopAllocations(uint64_t allocations, const FrameArena& arena) {
+    ++allocationFrames_;
+    if (allocations > 0) {
+        loopAllocations_ += allocations;
+        ++allocatingFrames_;
+    }
+    
+    // Every 10 s: loads, OSC commands and GL drivers allocate too, a
+    // render loop at rest should report nothing
+    int64_t now = vc_get_monotonic_time();
+    if (now - lastAllocationReportUs_ < 10000000) {
+        return;
+    }
+    if (allocatingFrames_ > 0) {
+        LOG_INFO << "Render loop: " << loopAllocations_ << " heap allocation(s) in "
+                 << allocatingFrames_ << " of " << allocationFrames_ << " frames (frame arena "
+                 << arena.highWater() << " of " << arena.capacity() << " bytes used)";
+    }
+    lastAllocationReportUs_ = now;
+    loopAllocations_ = 0;
+    allocatingFrames_ = 0;
+    allocationFrames_ = 0;
+}
+
+void VideoComposerApplication::processEvents() {
+    // Process display window events
+    if (displayBackend_) {
+        displayBackend_->handleEvents();
+    }
+    
+    // Process remote control events (applied before this frame's layer update)
+    loopActivity_ = false;
+    if (controlReplay_) {
+        ControlReplay::instance().update(vc_get_monotonic_time());
+    }
+    if (remoteControl_) {
+        loopActivity_ = remoteControl_->process() > 0;
+    }
+    
+    // Process completed async video loads
+    processAsyncLoads();
+    updateLoadGovernor();
+    updateProxySwitching();
+    updateNDIBandwidth();
+}
+
+void VideoComposerApplication::updateDisplayRefresh() {
+    if (!displayBackend_ || !layerManager_) {
+        return;
+    }
+    
+    // Show framerate: the one most loaded layers share
+    ArenaVector<std::pair<double, int>> rates;
+    for (const VideoLayer* layer : layerManager_->getLayers()) {
+        double fps = layer ? layer->getFrameInfo().framerate : 0.0;
+        if (fps <= 0.0) {
+            continue;
+        }
+        auto it = std::find_if(rates.begin(), rates.end(),
+                               [fps](const std::pair<double, int>& r) { return std::abs(r.first - fps) < 0.001; });
+        if (it != rates.end()) {
+            it->second++;
+        } else {
+            rates.emplace_back(fps, 1);
+        }
+    }
+    if (rates.empty()) {
+        return;
+    }
+    double fps = std::max_element(rates.begin(), rates.end(),
+                                  [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+                                      return a.second < b.second;
+                                  })->first;
+    
+    if (fps != videoFps_) {
+        videoFps_ = fps;
+        displayBackend_->setVideoFramerate(fps);
+    }
+    
+    // Variable refresh for single-framerate shows, else a matched fixed refresh
+    double vrrTarget = (config_->getBool("vrr", false) && rates.size() == 1) ? fps : 0.0;
+    bool matchRefresh = config_->getBool("match_refresh", false) && vrrFps_ <= 0.0 && fps != refreshFps_;
+    if (vrrTarget == vrrRequested_ && !matchRefresh) {
+        return;
+    }
+    
+    // A modeset blanks the outputs: only between shows, never while rolling
+    uint8_t rolling = 0;
+    if (globalSyncSource_) {
+        globalSyncSource_->pollFrame(&rolling);
+    }
+    if (rolling) {
+        return;
+    }
+    if (vrrTarget != vrrRequested_) {
+        vrrRequested_ = vrrTarget;
+        vrrFps_ = displayBackend_->setVariableRefresh(vrrTarget) ? vrrTarget : 0.0;
+        nextFlipUs_ = 0;
+        if (vrrFps_ > 0.0) {
+            LOG_INFO << "Variable refresh: flipping at " << vrrFps_ << " fps";
+            return;
+        }
+    }
+    if (matchRefresh) {
+        refreshFps_ = fps;
+        if (displayBackend_->matchRefreshRate(fps)) {
+            LOG_INFO << "Display refresh matched to " << fps << " fps show";
+        }
+    }
+}
+
+void VideoComposerApplication::paceVariableRefresh() {
+    if (vrrFps_ <= 0.0) {
+        return;
+    }
+    // Flip when the next frame is due instead of on every refresh. The
+    // schedule is absolute, so sleeps do not accumulate error; a late
+    // frame restarts it rather than rushing to catch up.
+    int64_t periodUs = static_cast<int64_t>(1e6 / vrrFps_);
+    int64_t nowUs = vc_get_monotonic_time();
+    if (nextFlipUs_ == 0 || nowUs - nextFlipUs_ > periodUs) {
+        nextFlipUs_ = nowUs;
+    } else if (nextFlipUs_ > nowUs) {
+        std::this_thread::sleep_for(std::chrono::microseconds(nextFlipUs_ - nowUs));
+    }
+    nextFlipUs_ += periodUs;
+}
+
+void VideoComposerApplication::updateInternalClock() {
+    if (!internalClock_) {
+        return;
+    }
+    // Count the vblank this render is shown on; without one, elapsed time
+    int64_t msc = 0;
+    double refreshHz = 0.0;
+    int64_t outputLeadNs = 0;
+    if (getOutputClock(msc, refreshHz, outputLeadNs) ||
+        (displayBackend_ && displayBackend_->getTargetVblank(msc, refreshHz))) {
+        internalClock_->advanceToVblank(msc, refreshHz);
+    } else {
+        internalClock_->advanceToTime(vc_get_monotonic_time());
+    }
+}
+
+void VideoComposerApplication::updatePresentationLead() {
+    int64_t leadNs = displayLagNs_;
+    int64_t outputFrame = 0;
+    double outputHz = 0.0;
+    int64_t outputLeadNs = 0;
+    if (getOutputClock(outputFrame, outputHz, outputLeadNs)) {
+        leadNs += outputLeadNs;  // Shown when the card plays it out
+    } else if (vsyncTarget_ && displayBackend_) {
+        leadNs += displayBackend_->getPresentationLeadNs();
+    }
+    presentationLeadNs_ = leadNs;
+    presentationUs_ = vc_get_monotonic_time() + leadNs / 1000;
+    if (!globalSyncSource_) {
+        return;
+    }
+    // Layers poll through the global source, so one lead covers them all.
+    // Frames are still decoded as before; only the timecode they are chosen
+    // for moves to when this render will be on screen.
+    globalSyncSource_->setPresentationLead(static_cast<double>(leadNs) / 1e9);
+    
+    if (frameLock_) {
+        // Wall clock of the vblank this render is shown on
+        frameLock_->update(vc_get_realtime() + leadNs / 1000);
+    }
+}
+
+void VideoComposerApplication::sampleFrameClock() {
+    // One poll of the global source per render: the layers, the OSD and
+    // the outputs all read this sample, so they agree on the frame. The
+    // lead is taken up to the vblank, not from when it was measured.
+    frameClock_->setSource(globalSyncSource_.get());
+    frameClock_->sample(presentationUs_, vc_get_monotonic_time());
+}
+
+void VideoComposerApplication::lateLatch() {
+    if (!lateLatch_ || !layerManager_) {
+        return;
+    }
+    // Commands that arrived while the layers updated are drawn this frame,
+    // not the next one
+    if (controlReplay_) {
+        ControlReplay::instance().update(vc_get_monotonic_time());
+    }
+    if (remoteControl_ && remoteControl_->process() > 0) {
+        loopActivity_ = true;
+    }
+    
+    // The clock sampled again, for the vblank this render is shown on (the
+    // lead measured again, and the frame lock with it): a layer takes the
+    // newer frame only if it is already decoded, so this never waits
+    updatePresentationLead();
+    sampleFrameClock();
+    layerManager_->latchAll();
+    if (outputSinkManager_) {
+        const FrameClock::Sample& clock = frameClock_->getSample();
+        outputSinkManager_->setTimecode(clock.frame, clock.connected ? clock.framerate : 0.0);
+    }
+}
+
+void VideoComposerApplication::runScheduledCommands() {
+    if (!remoteControl_) {
+        return;
+    }
+    // The frame and wall clock this render is presented at (after the lead)
+    int64_t frame = frameClock_->getSample().frame;
+    if (remoteControl_->runScheduled(frame, vc_get_realtime() + presentationLeadNs_ / 1000) > 0) {
+        loopActivity_ = true;
+    }
+}
+
+void VideoComposerApplication::animateLayers() {
+    if (!layerManager_) {
+        return;
+    }
+    layerManager_->animateAll(vc_get_monotonic_time() + presentationLeadNs_ / 1000);
+}
+
+void VideoComposerApplication::deliverTransportEvents() {
+    if (!globalSyncSource_ || !layerManager_) {
+        return;
+    }
+    if (globalSyncSource_.get() != transportSource_) {
+        // A new source numbers its events from 1
+        transportSource_ = globalSyncSource_.get();
+        transportSerial_ = 0;
+    }
+    // Events are detected while the source is polled (by the frame clock)
+    std::vector<TransportEvent> events;
+    transportSerial_ = globalSyncSource_->readTransportEvents(transportSerial_, events);
+    for (const TransportEvent& event : events) {
+        // Pushed before the layers poll: each of them seeks and decodes
+        // ahead at the new position while the timecode is still settling
+        layerManager_->onTransportEvent(event);
+        loopActivity_ = true;
+    }
+}
+
 void VideoComposerApplication::updateLayers() {
     if (!layerManager_) {
         return;
     }
     
+    deliverTransportEvents();
+    
         layerManager_->updateAll();
         
+    // Virtual outputs carry the show timecode with each frame
+    if (outputSinkManager_) {
+        const FrameClock::Sample& clock = frameClock_->getSample();
+        outputSinkManager_->setTimecode(clock.frame, clock.connected ? clock.framerate : 0.0);
+    }
+    
     // Update OSD with sync source timecode (like xjadeo: osd_smpte_ts = dispFrame - ts_offset)
     // Use global sync source frame directly to avoid backwards jumps from video wraparound
-    if (osdManager_ && globalSyncSource_ && globalSyncSource_->isConnected()) {
-        // Poll sync source to ensure current frame is up to date (layers poll their wrappers, but we poll directly)
-        uint8_t rolling = 0;
-        int64_t syncFrame = globalSyncSource_->pollFrame(&rolling);
+    if (osdManager_ && globalSyncSource_ && frameClock_->getSample().connected) {
+        // The sample the layers chose their frames from
+        int64_t syncFrame = frameClock_->getSample().frame;
         if (syncFrame >= 0) {
             // Get framerate from sync source (MTC framerate)
-            double syncFps = globalSyncSource_->getFramerate();
+            double syncFps = frameClock_->getSample().framerate;
             if (syncFps > 0.0) {
                 // Display sync source timecode (MTC) - this is monotonic and won't jump backwards
                 std::string smpte = SMPTEUtils::frameToSmpteString(syncFrame, syncFps);
@@ -479,6 +1645,34 @@ void VideoComposerApplication::updateLayers() {
     }
 }
 
+void VideoComposerApplication::updateGpuTimingOSD() {
+    if (!osdManager_ || !osdManager_->isModeEnabled(OSDManager::GPU) || !displayBackend_) {
+        return;
+    }
+    OpenGLRenderer* glRenderer = displayBackend_->getRenderer();
+    if (!glRenderer) {
+        return;
+    }
+    
+    // A few times a second: numbers changing every frame cannot be read
+    const GpuTimer& timer = glRenderer->gpuTimer();
+    uint64_t frame = timer.stats().getFrameCount();
+    if (frame < gpuOsdFrame_ + 15 && frame >= gpuOsdFrame_ && !osdManager_->getGpuTimings().empty()) {
+        return;
+    }
+    gpuOsdFrame_ = frame;
+    
+    std::vector<std::string> lines;
+    if (!timer.isActive()) {
+        lines.push_back(timer.isAvailable() ? "GPU timers off" : "GPU timers not supported");
+    } else {
+        for (const GpuTimingStats::Summary& summary : timer.stats().getSummaries()) {
+            lines.push_back(GpuTimingStats::formatLine(summary));
+        }
+    }
+    osdManager_->setGpuTimings(lines);
+}
+
 void VideoComposerApplication::render() {
     if (displayBackend_ && layerManager_) {
         displayBackend_->render(layerManager_.get(), osdManager_.get());
@@ -488,6 +1682,97 @@ void VideoComposerApplication::render() {
     }
 }
 
+void VideoComposerApplication::initializeIdle() {
+    idleDetector_ = std::make_unique<IdleDetector>();
+    idleWake_ = std::make_unique<WakeSignal>();
+    bool enabled = config_->getBool("idle_power_save", true);
+    if (enabled && frameLock_) {
+        // Frame-locked nodes flip together
+        LOG_INFO << "Idle power save: off with frame lock";
+        enabled = false;
+    }
+    idleDetector_->setEnabled(enabled);
+    if (enabled && remoteControl_) {
+        remoteControl_->setWakeSignal(idleWake_.get());
+    }
+    idleOutputCount_ = displayBackend_ ? displayBackend_->getOutputCount() : 0;
+}
+
+bool VideoComposerApplication::updateIdle() {
+    if (!idleDetector_ || !idleDetector_->isEnabled() || !displayBackend_ || !layerManager_) {
+        return true;
+    }
+    
+    // Something drawn: a ready, visible layer under a master that is not blacked out
+    std::shared_ptr<const SceneSnapshot> scene = layerManager_->getSnapshot();
+    OpenGLRenderer* renderer = displayBackend_->getRenderer();
+    bool blackout = renderer && renderer->masterProperties().opacity <= 0.0f;
+    IdleDetector::Frame frame;
+    for (const SceneSnapshot::Entry& entry : scene->entries) {
+        if (entry.ready && entry.properties.visible && entry.properties.opacity > 0.0f) {
+            frame.visible = !blackout;
+            break;
+        }
+    }
+    frame.sceneVersion = scene->version;
+    frame.osdVersion = osdManager_ ? osdManager_->getVersion() : 0;
+    
+    size_t outputs = displayBackend_->getOutputCount();
+    frame.activity = loopActivity_ || syncMoved() || syncTest_ || outputs != idleOutputCount_ ||
+                     (asyncVideoLoader_ && asyncVideoLoader_->pendingCount() > 0) ||
+                     (remoteControl_ && remoteControl_->getScheduledCount() > 0);
+    idleOutputCount_ = outputs;
+    
+    int64_t now = vc_get_monotonic_time();
+    bool render = idleDetector_->update(frame, now);
+    if (render) {
+        if (backendIdle_) {
+            displayBackend_->setIdle(false);
+            backendIdle_ = false;
+            LOG_INFO << "Idle power save: resumed rendering after "
+                     << static_cast<double>(idleDetector_->getLastIdleUs()) / 1e6 << " s";
+        }
+        return true;
+    }
+    if (!backendIdle_) {
+        if (!displayBackend_->setIdle(true)) {
+            // The outputs need every frame (windows, capture): keep rendering
+            idleDetector_->reset();
+            return true;
+        }
+        backendIdle_ = true;
+        LOG_INFO << "Idle power save: nothing on screen, outputs hold the last frame";
+    }
+    return false;
+}
+
+void VideoComposerApplication::waitWhileIdle() {
+    // Remote commands wake the loop at once; an external clock is polled.
+    // Loads, hotplug and telemetry still run every tick.
+    int64_t deadline = vc_get_monotonic_time() + IdleDetector::TICK_US;
+    while (running_) {
+        int64_t now = vc_get_monotonic_time();
+        if (now >= deadline || idleWake_->waitFor(std::min(IdleDetector::POLL_US, deadline - now))) {
+            return;
+        }
+        if (syncMoved()) {
+            return;
+        }
+    }
+}
+
+bool VideoComposerApplication::syncMoved() {
+    // The internal clock only runs for the loop; it never wakes it
+    if (!globalSyncSource_ || internalClock_ || !globalSyncSource_->isConnected()) {
+        return false;
+    }
+    uint8_t rolling = 0;
+    int64_t frame = globalSyncSource_->pollFrame(&rolling);
+    bool moved = rolling != 0 || frame != idleSyncFrame_;
+    idleSyncFrame_ = frame;
+    return moved;
+}
+
 bool VideoComposerApplication::setFPS(double fps) {
     if (fps <= 0.0) {
         return false;
@@ -540,7 +1825,20 @@ OpenGLRenderer& VideoComposerApplication::renderer() {
 void VideoComposerApplication::shutdown() {
     running_ = false;
     
+    // A snapshot still in its post-roll is written now
+    FlightRecorder::instance().stop();
+    ControlCapture::instance().stop();
+    
+    // The last state submitted is written; nothing after this reaches the journal
+    if (showJournal_) {
+        showJournal_->close();
+        showJournal_.reset();
+    }
+    
     // Shutdown async video loader first (before layer manager)
+    if (thumbnails_) {
+        thumbnails_->stop();
+    }
     if (asyncVideoLoader_) {
         asyncVideoLoader_->shutdown();
         asyncVideoLoader_.reset();
@@ -551,11 +1849,41 @@ void VideoComposerApplication::shutdown() {
         layerManager_.reset();
     }
     
+    // Shared hardware device contexts may wrap the display's VADisplay
+    // (and so may the idle decoders holding references to them)
+    DecoderContextPool::instance().clear();
+    HardwareDeviceCache::instance().releaseDevices();
+    
     if (remoteControl_) {
         remoteControl_->shutdown();
         remoteControl_.reset();
     }
     
+#ifdef HAVE_NDI_SDK
+    NDIDirectory::instance().stop();
+#endif
+    
+    // Encoders flush and release their GL surfaces while the context exists
+    if (preview_) {
+        if (displayBackend_) {
+            displayBackend_->setPreviewRenderer(nullptr);
+            displayBackend_->makeCurrent();
+        }
+        previewSink_->close();
+        previewSink_.reset();
+        preview_->cleanup();
+        preview_.reset();
+    }
+    if (outputSinkManager_) {
+        if (displayBackend_) {
+            displayBackend_->setCaptureEnabled(false);
+            displayBackend_->setOutputSinkManager(nullptr);
+            displayBackend_->makeCurrent();
+        }
+        outputSinkManager_->clear();
+        outputSinkManager_.reset();
+    }
+    
     if (displayBackend_) {
         displayBackend_->closeWindow();
         displayBackend_.reset();
@@ -569,6 +1897,29 @@ void VideoComposerApplication::shutdown() {
     initialized_ = false;
 }
 
+bool VideoComposerApplication::configureOfflineRender() {
+#ifdef HAVE_DRM_BACKEND
+    // The internal clock at the render rate; nothing may degrade, skip or
+    // wait on wall-clock time
+    config_->setBool("internal_sync", true);
+    config_->setDouble("internal_sync_fps", config_->getDouble("render_fps", 25.0));
+    config_->setString("ltc_device", "");
+    config_->setString("framelock", "off");
+    config_->setString("midi_port", "none");
+    config_->setBool("vsync_target", false);
+    config_->setInt("display_lag_ms", 0);
+    config_->setBool("governor", false);
+    config_->setBool("proxy_switching", false);
+    config_->setInt("layer_update_deadline_ms", 0);
+    config_->setBool("show_journal", false);
+    config_->setBool("sync_test", false);
+    return true;
+#else
+    LOG_ERROR << "Offline render needs the headless EGL backend - rebuild with libgbm-dev installed";
+    return false;
+#endif
+}
+
 void VideoComposerApplication::configureMIDISyncSource(MIDISyncSource* midiSync) {
     if (!midiSync) {
         return;
@@ -586,6 +1937,38 @@ void VideoComposerApplication::configureMIDISyncSource(MIDISyncSource* midiSync)
 }
 
 bool VideoComposerApplication::initializeGlobalSyncSource() {
+    vsyncTarget_ = config_->getBool("vsync_target", true);
+    lateLatch_ = config_->getBool("late_latch", false);
+    displayLagNs_ = static_cast<int64_t>(std::max(0, config_->getInt("display_lag_ms", 0))) * 1000000;
+    
+    // LTC replaces MTC when a capture device is configured
+    std::string ltcDevice = config_->getString("ltc_device", "");
+    if (!ltcDevice.empty()) {
+#ifdef HAVE_LTC_CAPTURE
+        auto ltcSync = std::make_unique<LTCSyncSource>();
+        ltcSync->setCaptureFormat(LTCSyncSource::DEFAULT_SAMPLE_RATE, LTCSyncSource::DEFAULT_PERIOD_FRAMES,
+                                  static_cast<unsigned int>(std::max(1, config_->getInt("ltc_channel", 1)) - 1));
+        if (ltcSync->connect(ltcDevice.c_str())) {
+            LOG_INFO << "Global LTC sync source initialized on " << ltcDevice;
+            globalSyncSource_ = std::move(ltcSync);
+            initializeFrameLock();
+            return true;
+        }
+        LOG_WARNING << "Cannot capture LTC from " << ltcDevice << ", falling back to MIDI sync";
+#else
+        LOG_WARNING << "LTC sync not available (built without libltc/ALSA), using MIDI sync";
+#endif
+    }
+    
+    if (config_->getBool("internal_sync", false)) {
+        auto clock = std::make_unique<VblankClockSyncSource>(config_->getDouble("internal_sync_fps", 25.0));
+        clock->connect();
+        internalClock_ = clock.get();
+        globalSyncSource_ = std::move(clock);
+        initializeFrameLock();
+        return true;
+    }
+    
     // Always create and enable global MIDI sync source by default
     auto midiSync = std::make_unique<MIDISyncSource>();
     
@@ -595,6 +1978,12 @@ bool VideoComposerApplication::initializeGlobalSyncSource() {
     // Get MIDI port (default: "-1" for autodetect, can be disabled with "none" or "off")
     std::string midiPort = config_->getString("midi_port", "-1");
     
+    // A replayed log is the MTC source, whatever the port
+    if (controlReplay_) {
+        midiSync->chooseDriver("replay");
+        midiPort = "replay";
+    }
+    
     // Connect to MIDI port (use "-1" for autodetect)
     // Only skip if explicitly disabled
     if (midiPort != "none" && midiPort != "off") {
@@ -611,10 +2000,97 @@ bool VideoComposerApplication::initializeGlobalSyncSource() {
     
     // Store as global sync source (always created)
     globalSyncSource_ = std::move(midiSync);
+    initializeFrameLock();
     
     return true;
 }
 
+void VideoComposerApplication::initializeFrameLock() {
+    std::string role = config_->getString("framelock", "");
+    if (role.empty() || role == "off") {
+        return;
+    }
+    if (role != "master" && role != "follower") {
+        LOG_WARNING << "Unknown frame lock role '" << role << "' (expected master or follower)";
+        return;
+    }
+    
+    auto frameLock = std::make_unique<FrameLockSyncSource>(
+        std::move(globalSyncSource_),
+        role == "master" ? FrameLockSyncSource::Role::Master : FrameLockSyncSource::Role::Follower);
+    
+    std::vector<std::string> peers;
+    std::stringstream peerList(config_->getString("framelock_peers", ""));
+    std::string peer;
+    while (std::getline(peerList, peer, ',')) {
+        if (!peer.empty()) {
+            peers.push_back(peer);
+        }
+    }
+    std::string nodeName = config_->getString("framelock_node", "");
+    if (nodeName.empty()) {
+        char host[256] = {0};
+        nodeName = gethostname(host, sizeof(host) - 1) == 0 ? host : "videocomposer";
+    }
+    
+    RemoteControl* remote = remoteControl_.get();
+    frameLock->setTransport(
+        [remote](const std::string& target, const std::string& path,
+                 const std::string& label, const std::vector<double>& values) {
+            if (remote) {
+                remote->sendMessage(target, path, label, values);
+            }
+        },
+        peers, config_->getString("framelock_report", ""), nodeName);
+    
+    LOG_INFO << "Frame lock: " << role << " node '" << nodeName << "'"
+             << (role == "master" ? ", timeline to " + std::to_string(peers.size()) + " peer(s)" : "");
+    frameLock_ = frameLock.get();
+    globalSyncSource_ = std::move(frameLock);
+}
+
+void VideoComposerApplication::initializeCluster() {
+    // Every node places its outputs in the cluster canvas, with or without a role
+    std::string canvas = config_->getString("cluster_canvas", "");
+    if (!canvas.empty()) {
+        int width = 0;
+        int height = 0;
+        if (sscanf(canvas.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+            LOG_WARNING << "Invalid cluster canvas '" << canvas << "' (expected WxH)";
+        } else if (!displayBackend_ || !displayBackend_->setClusterCanvas(width, height)) {
+            LOG_WARNING << "Cluster canvas needs the virtual canvas (DRM backend); compositing the whole canvas";
+        }
+    }
+    
+    std::string role = config_->getString("cluster", "");
+    if (role.empty() || role == "off") {
+        return;
+    }
+    if (role != "authority" && role != "follower") {
+        LOG_WARNING << "Unknown cluster role '" << role << "' (expected authority or follower)";
+        return;
+    }
+    clusterGroup_ = config_->getString("cluster_group", "239.255.42.1:7100");
+    if (!remoteControl_) {
+        LOG_WARNING << "Cluster mode needs the remote control (OSC)";
+        return;
+    }
+    clusterAuthority_ = role == "authority";
+    if (clusterAuthority_) {
+        // A restart is a new epoch: followers take its numbering as it comes
+        int64_t keyframeUs = static_cast<int64_t>(config_->getDouble("cluster_keyframe_s", 1.0) * 1000000.0);
+        cluster_ = std::make_unique<ClusterReplicator>(static_cast<uint64_t>(vc_get_realtime()), keyframeUs);
+    } else {
+        if (!remoteControl_->joinGroup(clusterGroup_)) {
+            LOG_WARNING << "Cluster: cannot receive group " << clusterGroup_;
+            return;
+        }
+        cluster_ = std::make_unique<ClusterReplicator>();
+    }
+    LOG_INFO << "Cluster: " << role << " on " << clusterGroup_
+             << (frameLock_ ? "" : " (no frame lock: nodes present frames independently)");
+}
+
 std::unique_ptr<InputSource> VideoComposerApplication::createInputSource(const std::string& source) {
     // Detect source type and create appropriate input
     
@@ -622,6 +2098,8 @@ std::unique_ptr<InputSource> VideoComposerApplication::createInputSource(const s
     if (isNDISource(source)) {
 #ifdef HAVE_NDI_SDK
         auto ndiInput = std::make_unique<NDIVideoInput>();
+        ndiInput->setUYVYOutput(config_->getBool("gpu_yuv", true));
+        ndiInput->setAdaptiveBandwidth(config_->getBool("ndi_adaptive_bandwidth", true));
         std::string ndiName = source;
         if (ndiName.find("ndi://") == 0) {
             ndiName = ndiName.substr(6);  // Remove prefix
@@ -637,8 +2115,36 @@ std::unique_ptr<InputSource> VideoComposerApplication::createInputSource(const s
 #endif
     }
     
+    // DeckLink capture (decklink://card?mode=NAME)
+    if (source.find("decklink://") == 0) {
+#ifdef HAVE_DECKLINK_SDK
+        auto deckLinkInput = std::make_unique<DeckLinkVideoInput>();
+        if (deckLinkInput->open(source)) {
+            return deckLinkInput;
+        }
+        LOG_WARNING << "Failed to open DeckLink source: " << source;
+        return nullptr;
+#else
+        LOG_ERROR << "DeckLink SDK not available (compiled without HAVE_DECKLINK_SDK)";
+        return nullptr;
+#endif
+    }
+
     // V4L2 device (/dev/video*)
     if (isV4L2Source(source)) {
+#ifdef HAVE_V4L2
+        // Native capture in NV12/UYVY/YUYV, converted on the GPU
+        if (config_->getBool("gpu_yuv", true)) {
+            auto captureInput = std::make_unique<V4L2VideoInput>();
+            captureInput->setDisplayBackend(displayBackend_.get());
+            captureInput->setQueueDepth(config_->getInt("v4l2_buffers", 5));
+            captureInput->setPreferredFormat(config_->getString("v4l2_format", "auto"));
+            if (captureInput->open(source)) {
+                return captureInput;
+            }
+            LOG_INFO << "V4L2: Falling back to FFmpeg capture for " << source;
+        }
+#endif
         auto v4l2Input = std::make_unique<FFmpegLiveInput>();
         v4l2Input->setFormat("v4l2");
         if (v4l2Input->open(source)) {
@@ -648,9 +2154,14 @@ std::unique_ptr<InputSource> VideoComposerApplication::createInputSource(const s
         return nullptr;
     }
     
-    // Network stream (rtsp://, http://, udp://)
+    // Network stream (rtsp://, srt://, udp://, http://, ...)
     if (isNetworkStream(source)) {
         auto streamInput = std::make_unique<FFmpegLiveInput>();
+        std::string hwPrefStr = config_->getString("hardware_decoder", "auto");
+        std::transform(hwPrefStr.begin(), hwPrefStr.end(), hwPrefStr.begin(), [](unsigned char c){ return std::tolower(c); });
+        streamInput->setLowLatency(config_->getBool("stream_low_latency", true));
+        streamInput->setTargetLatency(config_->getInt("stream_latency_ms", 100));
+        streamInput->setHardwareDecode(hwPrefStr != "software" && hwPrefStr != "cpu");
         if (streamInput->open(source)) {
             return streamInput;
         }
@@ -668,14 +2179,12 @@ bool VideoComposerApplication::isNDISource(const std::string& source) {
         return true;
     }
     
-    // Check if source matches NDI naming pattern: "HOSTNAME (Source Name)"
-    // Or query NDI SDK to see if it's a known source
+    // Or a source the NDI directory has seen ("HOSTNAME (Source Name)"),
+    // looked up without waiting
 #ifdef HAVE_NDI_SDK
-    auto ndiSources = NDIVideoInput::discoverSources(1000);
-    for (const auto& s : ndiSources) {
-        if (s == source) {
-            return true;
-        }
+    NDIDirectory::Source known;
+    if (NDIDirectory::instance().find(source, known) && known.name == source) {
+        return true;
     }
 #endif
     
@@ -687,14 +2196,46 @@ bool VideoComposerApplication::isV4L2Source(const std::string& source) {
 }
 
 bool VideoComposerApplication::isNetworkStream(const std::string& source) {
-    return source.find("rtsp://") == 0 || 
-           source.find("http://") == 0 || 
-           source.find("https://") == 0 ||
-           source.find("udp://") == 0 ||
-           source.find("tcp://") == 0;
+    return FFmpegLiveInput::isNetworkUrl(source);
 }
 
-std::unique_ptr<InputSource> VideoComposerApplication::createInputSourceFromFile(const std::string& filepath) {
+std::unique_ptr<InputSource> VideoComposerApplication::createInputSourceFromFile(const std::string& filepath,
+                                                                                bool mosaicTile) {
+    // Tiled clip: tiles are opened here too and stitched into one frame
+    if (MosaicInput::isMosaicPath(filepath) && !mosaicTile) {
+        auto mosaicInput = std::make_unique<MosaicInput>();
+        mosaicInput->setTileFactory([this](const std::string& tilePath) {
+            return createInputSourceFromFile(tilePath, true);
+        });
+        if (!mosaicInput->open(filepath)) {
+            return nullptr;
+        }
+        return mosaicInput;
+    }
+
+    // Numbered image files: decoded per frame by a worker pool
+    if (ImageSequenceInput::isSequencePath(filepath)) {
+        auto sequenceInput = std::make_unique<ImageSequenceInput>();
+        sequenceInput->setFramerate(config_->getDouble("sequence_fps", 25.0));
+        sequenceInput->setThreads(config_->getInt("sequence_threads", -1));
+        sequenceInput->setReadAhead(config_->getInt("sequence_read_ahead", 12));
+        int cacheMB = config_->getInt("sequence_cache_mb", 512);
+        sequenceInput->setCacheBudget(static_cast<size_t>(std::max(0, cacheMB)) * 1024 * 1024);
+        if (!sequenceInput->open(filepath)) {
+            return nullptr;
+        }
+        return sequenceInput;
+    }
+    
+    // Single image: decoded once, shown for any sync position
+    if (StillImageInput::isStillImagePath(filepath)) {
+        auto stillInput = std::make_unique<StillImageInput>();
+        if (!stillInput->open(filepath)) {
+            return nullptr;
+        }
+        return stillInput;
+    }
+
     // Create input source with codec-aware routing
     // Set no-index option before opening (to avoid reopening)
     bool noIndex = config_->getBool("want_noindex", false);
@@ -708,12 +2249,28 @@ std::unique_ptr<InputSource> VideoComposerApplication::createInputSourceFromFile
         hwPref = VideoFileInput::HardwareDecodePreference::VAAPI;
     } else if (hwPrefStr == "cuda" || hwPrefStr == "nvdec") {
         hwPref = VideoFileInput::HardwareDecodePreference::CUDA;
+    } else if (hwPrefStr == "vulkan") {
+        hwPref = VideoFileInput::HardwareDecodePreference::VULKAN;
     }
     
     // First, detect codec by opening with VideoFileInput
     auto tempInput = std::make_unique<VideoFileInput>();
     tempInput->setNoIndex(noIndex);  // Set before opening to avoid reopening
     tempInput->setHardwareDecodePreference(hwPref);
+    int poolBudgetMB = config_->getInt("frame_pool_budget_mb", 128);
+    tempInput->setFramePoolBudget(static_cast<size_t>(std::max(0, poolBudgetMB)) * 1024 * 1024);
+    int reverseBudgetMB = config_->getInt("reverse_cache_mb", 256);
+    tempInput->setReverseCacheBudget(static_cast<size_t>(std::max(0, reverseBudgetMB)) * 1024 * 1024);
+    tempInput->setIndexCache(config_->getBool("index_cache", true),
+                             config_->getString("index_cache_dir", ""));
+    tempInput->setBackgroundIndexing(config_->getBool("background_indexing", false));
+    tempInput->setPlanarOutput(config_->getBool("gpu_yuv", true) && !mosaicTile);
+    tempInput->setReadAhead(ReadAheadIO::parseMode(config_->getString("read_ahead", "auto")),
+                            static_cast<size_t>(std::max(1, config_->getInt("read_ahead_mb", 16))) * 1024 * 1024);
+    tempInput->setDirectIoBitrate(static_cast<int64_t>(std::max(0, config_->getInt("direct_io_mbps", 0))) * 1000000);
+    tempInput->setIntraDecoders(std::max(0, config_->getInt("intra_decoders", 0)));
+    tempInput->setKeyframeOnlyStep(std::max(0, config_->getInt("keyframe_only_step", 8)));
+    tempInput->setDeinterlace(FieldSelector::parseMode(config_->getString("deinterlace", "auto")));
     
 #ifdef HAVE_VAAPI_INTEROP
     // Set DisplayBackend for per-instance VaapiInterop creation
@@ -769,9 +2326,11 @@ std::unique_ptr<SyncSource> VideoComposerApplication::createLayerSyncSource(Inpu
         return nullptr;
     }
     
-    // Wrap global sync source with framerate converter (non-owning reference)
-    // Each layer gets its own framerate converter, but they all share the same global sync source
-    return std::make_unique<FramerateConverterSyncSource>(globalSyncSource_.get(), inputSource);
+    // Wrap the frame clock with a framerate converter (non-owning reference)
+    // Each layer gets its own framerate converter, but they all read the same
+    // per-render sample of the global sync source
+    frameClock_->setSource(globalSyncSource_.get());
+    return std::make_unique<FramerateConverterSyncSource>(frameClock_.get(), inputSource);
 }
 
 void VideoComposerApplication::setupLayerWithInputSource(VideoLayer* layer, std::unique_ptr<InputSource> inputSource) {
@@ -789,6 +2348,11 @@ void VideoComposerApplication::setupLayerWithInputSource(VideoLayer* layer, std:
         layer->setSyncSource(std::move(syncSource));
     }
     
+    // Offline render: a frame not decoded in time is waited for, never skipped
+    if (offlineRender_) {
+        layer->setUnderrunPolicy(InputSource::UnderrunPolicy::BLOCK);
+    }
+    
     // Set layer properties from input source
     auto& props = layer->properties();
     if (layer->isReady()) {
@@ -798,19 +2362,30 @@ void VideoComposerApplication::setupLayerWithInputSource(VideoLayer* layer, std:
     }
 }
 
-bool VideoComposerApplication::createLayerWithFile(const std::string& cueId, const std::string& filepath) {
+namespace {
+
+AsyncVideoLoader::Priority loadPriority(int priority) {
+    return static_cast<AsyncVideoLoader::Priority>(std::max(0, std::min(priority, 2)));
+}
+
+} // namespace
+
+bool VideoComposerApplication::createLayerWithFile(const std::string& cueId, const std::string& filepath, int priority,
+                                                   bool preload) {
     // Create empty layer first (fast, non-blocking)
     auto layer = createEmptyLayer(cueId);
     if (!layer) {
         LOG_ERROR << "Failed to create empty layer";
         return false;
     }
+    layer->properties().preload = preload;
     
     // Add layer to manager with cue ID
     if (!layerManager_->addLayerWithId(cueId, std::move(layer))) {
         LOG_ERROR << "Failed to add layer with cue ID: " << cueId;
         return false;
     }
+    journalSources_[cueId] = filepath;
     
     // Queue async load of video file
     if (asyncVideoLoader_) {
@@ -818,7 +2393,7 @@ bool VideoComposerApplication::createLayerWithFile(const std::string& cueId, con
             [this](const std::string& cid, const std::string& fp, 
                    std::unique_ptr<InputSource> input, bool success) {
                 onAsyncLoadComplete(cid, fp, std::move(input), success);
-            });
+            }, loadPriority(priority), preload);
         LOG_INFO << "Queued async load for layer: " << filepath << " (cue ID: " << cueId << ")";
         return true;
     }
@@ -839,25 +2414,28 @@ bool VideoComposerApplication::createLayerWithFile(const std::string& cueId, con
     return true;
 }
 
-bool VideoComposerApplication::loadFileIntoLayer(const std::string& cueId, const std::string& filepath) {
+bool VideoComposerApplication::loadFileIntoLayer(const std::string& cueId, const std::string& filepath, int priority) {
     // Get or create layer
     VideoLayer* layer = layerManager_->getLayerByCueId(cueId);
     
     if (!layer) {
         // Layer doesn't exist - create it (handles async load internally)
-        return createLayerWithFile(cueId, filepath);
+        return createLayerWithFile(cueId, filepath, priority);
     }
     
-    // Layer exists - cancel any pending load and queue new async load
+    journalSources_[cueId] = filepath;
+    
+    // Layer exists - queue new async load (supersedes a pending load of another file)
     if (asyncVideoLoader_) {
-        // Cancel any previous pending load for this cue
-        asyncVideoLoader_->cancelLoad(cueId);
-        
+        // Shown at its current size, so a proxy may be enough for the new file
+        int displayWidth = 0;
+        int displayHeight = 0;
+        layer->getResolutionHint(displayWidth, displayHeight);
         asyncVideoLoader_->requestLoad(cueId, filepath, 
             [this](const std::string& cid, const std::string& fp, 
                    std::unique_ptr<InputSource> input, bool success) {
                 onAsyncLoadComplete(cid, fp, std::move(input), success);
-            });
+            }, loadPriority(priority), layer->properties().preload, displayWidth, displayHeight);
         LOG_INFO << "Queued async load into existing layer: " << filepath << " (cue ID: " << cueId << ")";
         return true;
     }
@@ -876,6 +2454,13 @@ bool VideoComposerApplication::loadFileIntoLayer(const std::string& cueId, const
 }
 
 bool VideoComposerApplication::unloadFileFromLayer(const std::string& cueId) {
+    // A load still in flight would otherwise refill the layer after the unload
+    if (asyncVideoLoader_) {
+        asyncVideoLoader_->cancelLoad(cueId);
+    }
+
+    journalSources_.erase(cueId);
+    
     VideoLayer* layer = layerManager_->getLayerByCueId(cueId);
     if (!layer) {
         LOG_WARNING << "Layer not found for cue ID: " << cueId;
@@ -892,6 +2477,13 @@ bool VideoComposerApplication::unloadFileFromLayer(const std::string& cueId) {
     return true;
 }
 
+bool VideoComposerApplication::prioritizeLoad(const std::string& cueId, int priority) {
+    if (asyncVideoLoader_) {
+        return asyncVideoLoader_->setPriority(cueId, loadPriority(priority));
+    }
+    return false;
+}
+
 bool VideoComposerApplication::isLoadPending(const std::string& cueId) const {
     if (asyncVideoLoader_) {
         return asyncVideoLoader_->isLoadPending(cueId);
@@ -899,16 +2491,424 @@ bool VideoComposerApplication::isLoadPending(const std::string& cueId) const {
     return false;
 }
 
+bool VideoComposerApplication::prewarmShowIndexes(const std::vector<std::string>& filepaths) {
+    if (!asyncVideoLoader_ || filepaths.empty()) {
+        return false;
+    }
+    asyncVideoLoader_->requestIndexPrewarm(filepaths);
+    return true;
+}
+
+bool VideoComposerApplication::requestThumbnail(const std::string& filepath, double seconds, int width,
+                                                const std::string& target) {
+    if (!thumbnails_) {
+        return false;
+    }
+    ThumbnailService::Request request;
+    request.path = filepath;
+    request.seconds = seconds;
+    request.width = width;
+    request.target = target.empty() ? config_->getString("event_report", "") : target;
+    if (request.target.empty()) {
+        LOG_WARNING << "show/thumbnail: no host port given and no event_report target to answer";
+        return false;
+    }
+    if (!thumbnails_->request(request)) {
+        LOG_WARNING << "show/thumbnail: " << ThumbnailService::MAX_PENDING << " requests queued already, dropping "
+                    << filepath;
+        return false;
+    }
+    return true;
+}
+
 void VideoComposerApplication::processAsyncLoads() {
-    if (asyncVideoLoader_) {
-        asyncVideoLoader_->pollCompleted();
+    // One layer setup per frame: a cue firing several loads at once must
+    // not stall a single flip
+    if (asyncVideoLoader_ && asyncVideoLoader_->pollCompleted(1) > 0) {
+        loopActivity_ = true;
+    }
+}
+
+void VideoComposerApplication::updateNDIBandwidth() {
+#ifdef HAVE_NDI_SDK
+    if (!layerManager_) {
+        return;
+    }
+    // The input's capture thread decides and switches streams
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        NDIVideoInput* ndiInput = layer ? dynamic_cast<NDIVideoInput*>(layer->getInputSource()) : nullptr;
+        if (!ndiInput) {
+            continue;
+        }
+        int displayWidth = 0;
+        int displayHeight = 0;
+        layer->getResolutionHint(displayWidth, displayHeight);
+        ndiInput->setDisplaySize(displayWidth, displayHeight);
+    }
+#endif
+}
+
+void VideoComposerApplication::updateProxySwitching() {
+    if (!proxySwitcher_ || !proxySwitcher_->getSettings().enabled || !asyncVideoLoader_ || !layerManager_) {
+        return;
+    }
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (now - lastProxyUpdate_ < 0.25) {
+        return;
+    }
+    lastProxyUpdate_ = now;
+    
+    std::vector<ProxySwitcher::LayerState> states;
+    uint64_t totalMisses = 0;
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        VideoFileInput* videoInput = layer ? dynamic_cast<VideoFileInput*>(layer->getInputSource()) : nullptr;
+        if (!videoInput || !layer->isReady()) {
+            continue;
+        }
+        totalMisses += videoInput->getUnderrunStats().misses;
+        ProxySwitcher::LayerState state;
+        state.cueId = layerManager_->getCueIdFromLayer(layer);
+        state.path = videoInput->getFilename();
+        layer->getResolutionHint(state.displayWidth, state.displayHeight);
+        state.frame = layer->getCurrentFrame();
+        state.framerate = layer->getFrameInfo().framerate;
+        state.timeScale = layer->getTimeScale();
+        state.playing = layer->isPlaying();
+        state.loadPending = asyncVideoLoader_->isLoadPending(state.cueId);
+        state.degraded = decodeGovernor_ && decodeGovernor_->getLevel(state.cueId) != DecodeGovernor::Level::FULL;
+        states.push_back(std::move(state));
+    }
+    
+    ProxySwitcher::Switch change = proxySwitcher_->update(states, totalMisses, now);
+    if (change.cueId.empty()) {
+        return;
+    }
+    VideoLayer* layer = layerManager_->getLayerByCueId(change.cueId);
+    if (!layer) {
+        return;
+    }
+    LOG_INFO << "Proxy: Cue " << change.cueId << " to " << (change.toProxy ? "proxy " : "master ")
+             << change.path << " (" << change.reason << ")";
+    asyncVideoLoader_->requestLoad(change.cueId, change.path,
+        [this](const std::string& cid, const std::string& fp,
+               std::unique_ptr<InputSource> input, bool success) {
+            onAsyncLoadComplete(cid, fp, std::move(input), success);
+        }, AsyncVideoLoader::Priority::NORMAL, layer->properties().preload);
+}
+
+void VideoComposerApplication::trackLateFrames() {
+    // Each loop iteration renders for the next vsync; a skipped vblank is a
+    // frame the output repeated (variable refresh has no fixed cadence)
+    int64_t msc = 0;
+    double refreshHz = 0.0;
+    // Idle: the held vsyncs are not late frames
+    bool idle = idleDetector_ && idleDetector_->isIdle();
+    if (!displayBackend_ || vrrFps_ > 0.0 || idle || !displayBackend_->getTargetVblank(msc, refreshHz)) {
+        lastVblank_ = -1;
+        return;
+    }
+    if (lastVblank_ >= 0 && msc > lastVblank_ + 1) {
+        lateFrames_ += static_cast<uint64_t>(msc - lastVblank_ - 1);
+    }
+    lastVblank_ = msc;
+    vblankHz_ = refreshHz;
+}
+
+void VideoComposerApplication::updateFlightRecorder(int64_t frame, int64_t workStartNs) {
+    FlightRecorder& recorder = FlightRecorder::instance();
+    if (!recorder.isEnabled()) {
+        return;
+    }
+    // CPU work up to the render: the render itself waits for the vsync
+    FlightRecorder::FrameSample sample;
+    sample.timeNs = workStartNs;
+    sample.frame = static_cast<uint64_t>(frame);
+    sample.workMs = static_cast<float>(FrameTracer::nowNs() - workStartNs) / 1e6f;
+    sample.budgetMs = lastVblank_ >= 0 && vblankHz_ > 0.0 ? static_cast<float>(1000.0 / vblankHz_) : 0.0f;
+
+    // GPU time of a frame FRAMES_IN_FLIGHT back, once per new result
+    bool gpuTimed = false;
+    OpenGLRenderer* glRenderer = displayBackend_ ? displayBackend_->getRenderer() : nullptr;
+    if (glRenderer && glRenderer->gpuTimer().isActive()) {
+        const GpuTimingStats& stats = glRenderer->gpuTimer().stats();
+        GpuTimingStats::Summary summary;
+        if (stats.getFrameCount() != flightGpuFrame_ && stats.getSummary("frame", -1, summary)) {
+            flightGpuFrame_ = stats.getFrameCount();
+            sample.gpuMs = summary.lastMs;
+            gpuTimed = true;
+        }
+    }
+    recorder.recordFrame(sample);
+
+    if (sample.budgetMs > 0.0f && (sample.workMs > sample.budgetMs || (gpuTimed && sample.gpuMs > sample.budgetMs))) {
+        char detail[96];
+        std::snprintf(detail, sizeof(detail), "work %.2f ms, GPU %.2f ms of %.2f ms",
+                      sample.workMs, sample.gpuMs, sample.budgetMs);
+        recorder.trigger(FlightRecorder::Trigger::OVER_BUDGET, detail);
+    }
+}
+
+bool VideoComposerApplication::initializeSyncTest() {
+    if (!displayBackend_ || !layerManager_ || !globalSyncSource_) {
+        return false;
+    }
+    unsigned int width = 0, height = 0;
+    displayBackend_->getWindowSize(&width, &height);
+    bool readback = config_->getBool("sync_test_readback", false);
+    if (!displayBackend_->setFrameLogEnabled(true, readback)) {
+        LOG_WARNING << "Sync test: the display backend has no flip timestamps";
+        return false;
+    }
+    
+    // No framerate: the pattern shows the sync source's frame numbers as is.
+    // A clip (bench_media) at the timecode rate carries the same strips
+    std::string media = config_->getString("sync_test_media", "");
+    std::unique_ptr<InputSource> input;
+    if (media.empty()) {
+        input = std::make_unique<TestPatternInput>(
+            static_cast<int>(std::max(width, 64u)), static_cast<int>(std::max(height, 64u)), 0.0);
+    } else {
+        input = createInputSource(media);
+    }
+    auto layer = input ? createEmptyLayer("synctest") : nullptr;
+    if (!layer) {
+        LOG_WARNING << "Sync test: cannot play " << (media.empty() ? "the test pattern" : media);
+        displayBackend_->setFrameLogEnabled(false, false);
+        return false;
+    }
+    setupLayerWithInputSource(layer.get(), std::move(input));
+    syncTestLayerId_ = layerManager_->addLayer(std::move(layer));
+    if (syncTestLayerId_ < 0) {
+        displayBackend_->setFrameLogEnabled(false, false);
+        return false;
+    }
+    
+    syncTest_ = std::make_unique<SyncLatencyMonitor>();
+    lastSyncReportUs_ = vc_get_monotonic_time();
+    LOG_INFO << "Sync test: " << (media.empty() ? std::to_string(width) + "x" + std::to_string(height) + " pattern"
+                                                : media) << " against " << globalSyncSource_->getName()
+             << (readback ? ", frame numbers read back from the canvas" : "");
+    return true;
+}
+
+void VideoComposerApplication::planSyncTest() {
+    if (!syncTest_ || !displayBackend_) {
+        return;
+    }
+    VideoLayer* layer = layerManager_->getLayer(syncTestLayerId_);
+    int64_t frame = layer ? layer->getLoadedFrame() : -1;
+    displayBackend_->setFrameTag(frame);
+    
+    int64_t msc = 0;
+    double refreshHz = 0.0;
+    if (displayBackend_->getTargetVblank(msc, refreshHz)) {
+        syncTest_->configure(refreshHz, globalSyncSource_->getFramerate());
+        if (frame >= 0) {
+            syncTest_->recordPlan(msc, frame);
+        }
+    }
+}
+
+void VideoComposerApplication::updateSyncTest() {
+    if (!syncTest_ || !displayBackend_) {
+        return;
+    }
+    presentedFrames_.clear();
+    displayBackend_->takePresentedFrames(presentedFrames_);
+    for (const PresentedFrame& frame : presentedFrames_) {
+        int64_t syncTimeUs = frame.tag >= 0 ? globalSyncSource_->getFrameTime(frame.tag) : -1;
+        syncTest_->recordPresented(frame, syncTimeUs);
+        LOG_VERBOSE << "Sync test: msc " << frame.msc << " frame " << frame.tag
+                    << (syncTimeUs >= 0 ? " " + std::to_string(frame.flipNs / 1000 - syncTimeUs) + " us after sync" : "");
+    }
+    
+    int64_t now = vc_get_monotonic_time();
+    if (now - lastSyncReportUs_ >= 10000000) {
+        lastSyncReportUs_ = now;
+        for (const std::string& line : syncTest_->formatReport()) {
+            LOG_INFO << "Sync test: " << line;
+        }
+    }
+}
+
+void VideoComposerApplication::updateLoadGovernor() {
+    if (!decodeGovernor_ || !layerManager_) {
+        return;
+    }
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (now - lastGovernorUpdate_ < 0.25) {
+        return;
+    }
+    lastGovernorUpdate_ = now;
+    
+    std::vector<DecodeGovernor::LayerSample> samples;
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        VideoFileInput* videoInput = layer ? dynamic_cast<VideoFileInput*>(layer->getInputSource()) : nullptr;
+        if (!videoInput || !layer->isReady()) {
+            continue;
+        }
+        DecodeGovernor::LayerSample sample;
+        sample.cueId = layerManager_->getCueIdFromLayer(layer);
+        sample.priority = layer->getDecodePriority();
+        sample.critical = layer->isCritical();
+        sample.hasProxy = proxySwitcher_ && proxySwitcher_->getSettings().enabled &&
+                          proxySwitcher_->hasProxy(videoInput->getFilename());
+        sample.decodeTime = layer->getLoadTime() + videoInput->getDecodeTime();
+        sample.misses = videoInput->getUnderrunStats().misses;
+        samples.push_back(std::move(sample));
+    }
+    
+    std::vector<DecodeGovernor::Decision> decisions = decodeGovernor_->update(samples, lateFrames_, now);
+    if (decisions.empty()) {
+        return;
+    }
+    std::string reportTarget = config_->getString("governor_report", "");
+    for (const DecodeGovernor::Decision& decision : decisions) {
+        VideoLayer* layer = layerManager_->getLayerByCueId(decision.cueId);
+        if (!layer) {
+            continue;
+        }
+        // PROXY is applied by the proxy switcher, which reads the level
+        layer->setRateDivisor(decision.level == DecodeGovernor::Level::HALF_RATE ? 2 : 1);
+        LOG_INFO << "Load governor: Cue " << decision.cueId << " -> " << DecodeGovernor::levelName(decision.level)
+                 << " (" << decision.reason << ", priority " << layer->getDecodePriority() << ")";
+        
+        // Operators see the trade-off: /videocomposer/governor/layer <cueId> <level> <priority>
+        if (remoteControl_ && !reportTarget.empty()) {
+            remoteControl_->sendMessage(reportTarget, "/videocomposer/governor/layer", decision.cueId,
+                                        {static_cast<double>(decision.level),
+                                         static_cast<double>(layer->getDecodePriority())});
+        }
+    }
+    if (remoteControl_ && !reportTarget.empty()) {
+        // /videocomposer/governor/load <misses/s> <late frames/s> <steps applied>
+        remoteControl_->sendMessage(reportTarget, "/videocomposer/governor/load", "",
+                                    {decodeGovernor_->getMissRate(), decodeGovernor_->getLateFrameRate(),
+                                     static_cast<double>(decodeGovernor_->getStepCount())});
+    }
+}
+
+namespace {
+
+// Resident set size of this process (0 if unknown)
+size_t getResidentBytes() {
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+    unsigned long pages = 0, resident = 0;
+    int fields = std::fscanf(file, "%lu %lu", &pages, &resident);
+    std::fclose(file);
+    return fields == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+} // namespace
+
+void VideoComposerApplication::reportThumbnails() {
+    if (!thumbnails_ || !remoteControl_) {
+        return;
+    }
+    thumbnails_->takeResults([this](const ThumbnailService::Result& result) {
+        const ThumbnailService::Request& request = result.request;
+        if (!result.ok) {
+            // /videocomposer/thumbnail/failed <path> <seconds>
+            remoteControl_->sendMessage(request.target, "/videocomposer/thumbnail/failed", request.path,
+                                        {request.seconds});
+            return;
+        }
+        // /videocomposer/thumbnail/ready <path> <image file> <seconds> [image bytes]
+        remoteControl_->sendData(request.target, "/videocomposer/thumbnail/ready", {request.path, result.file},
+                                 {request.seconds}, result.data);
+    });
+}
+
+void VideoComposerApplication::reportSeekCompletions() {
+    if (!layerManager_) {
+        return;
+    }
+    std::string reportTarget;
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        LayerPlayback::SeekCompletion completion;
+        if (!layer || !layer->takeSeekCompletion(completion)) {
+            continue;
+        }
+        std::string cueId = layerManager_->getCueIdFromLayer(layer);
+        LOG_VERBOSE << "Cue " << cueId << ": asynchronous seek to frame " << completion.frame
+                    << (completion.loaded ? " shown" : " failed");
+        if (reportTarget.empty()) {
+            reportTarget = config_->getString("event_report", "");
+        }
+        // /videocomposer/layer/seeked <cueId> <frame> <loaded>
+        if (remoteControl_ && !reportTarget.empty()) {
+            remoteControl_->sendMessage(reportTarget, "/videocomposer/layer/seeked", cueId,
+                                        {static_cast<double>(completion.frame), completion.loaded ? 1.0 : 0.0});
+        }
     }
 }
 
+void VideoComposerApplication::updateTelemetry() {
+    if (!telemetry_ || telemetry_->getSubscriberCount() == 0) {
+        lastLoopUs_ = -1;
+        return;
+    }
+    int64_t now = vc_get_monotonic_time();
+    // Idle iterations are ticks, not frames
+    if (lastLoopUs_ >= 0 && !(idleDetector_ && idleDetector_->isIdle())) {
+        telemetry_->recordFrame((now - lastLoopUs_) / 1000.0);
+    }
+    lastLoopUs_ = now;
+    if (!remoteControl_ || !layerManager_ || !telemetry_->isDue(now)) {
+        return;
+    }
+    
+    TelemetryPublisher::Sample& sample = telemetry_->beginSample();
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        VideoFileInput* videoInput = layer ? dynamic_cast<VideoFileInput*>(layer->getInputSource()) : nullptr;
+        if (!videoInput || !layer->isReady()) {
+            continue;
+        }
+        TelemetryPublisher::LayerSample* entry = telemetry_->addLayer();
+        if (!entry) {
+            break;
+        }
+        entry->layerId = layer->getLayerId();
+        entry->cueId = layerManager_->getCueIdFromLayer(layer);
+        entry->decodedFrames = videoInput->getDecodedFrameCount();
+        entry->underruns = videoInput->getUnderrunStats().misses;
+        entry->queueDepth = videoInput->getQueuedFrameCount();
+        if (std::shared_ptr<FramePool> pool = videoInput->getFramePool()) {
+            FramePool::Stats poolStats = pool->getStats();
+            sample.framePoolBytes += poolStats.capacity * poolStats.bytesPerFrame;
+        }
+    }
+    sample.lateFrames = lateFrames_;
+    if (outputSinkManager_) {
+        sample.sinkDrops = static_cast<uint64_t>(std::max<int64_t>(outputSinkManager_->getTotalFramesDropped(), 0));
+    }
+    if (displayBackend_ && displayBackend_->getRenderer()) {
+        sample.vramUsedBytes = displayBackend_->getRenderer()->getVideoMemoryUsed();
+    }
+    sample.texturePoolBytes = TexturePool::instance().getStats().freeBytes;
+    sample.ramClipBytes = RamClipCache::instance().getStats().bytes;
+    sample.residentBytes = getResidentBytes();
+    if (globalSyncSource_) {
+        double jitter = globalSyncSource_->getJitter();
+        sample.syncJitterMs = jitter >= 0.0 ? jitter * 1000.0 : -1.0;
+    }
+    
+    telemetry_->publish(now, [this](const std::string& target, const std::string& path,
+                                    const std::string& label, const std::vector<double>& values) {
+        return remoteControl_->sendMessage(target, path, label, values);
+    });
+}
+
 void VideoComposerApplication::onAsyncLoadComplete(const std::string& cueId, const std::string& filepath,
                                                    std::unique_ptr<InputSource> inputSource, bool success) {
     if (!success || !inputSource) {
         LOG_ERROR << "Async load failed for: " << filepath << " (cue ID: " << cueId << ")";
+        if (resume_) {
+            resume_->layers.erase(cueId);
+        }
         return;
     }
     
@@ -919,11 +2919,321 @@ void VideoComposerApplication::onAsyncLoadComplete(const std::string& cueId, con
         return;
     }
     
+    // Over capacity with the reject policy: the layer keeps what it had
+    if (!admitLoad(cueId, filepath, inputSource.get())) {
+        VideoFileInput* current = dynamic_cast<VideoFileInput*>(layer->getInputSource());
+        if (current) {
+            journalSources_[cueId] = current->getFilename();
+        } else {
+            journalSources_.erase(cueId);
+        }
+        return;
+    }
+    
+    // A layer already showing media swaps at a frame boundary and keeps its geometry
+    if (layer->isReady()) {
+        // Clip and proxy changing places: take over where the new file has a keyframe
+        VideoFileInput* current = dynamic_cast<VideoFileInput*>(layer->getInputSource());
+        bool proxySwap = current && (ProxyMedia::masterPathFor(filepath) == current->getFilename() ||
+                                     ProxyMedia::masterPathFor(current->getFilename()) == filepath);
+        auto syncSource = createLayerSyncSource(inputSource.get());
+        layer->setIncomingSource(std::move(inputSource), std::move(syncSource), proxySwap);
+        LOG_INFO << "Async load complete, swapping in: " << filepath << " (cue ID: " << cueId << ")";
+        return;
+    }
+    
     // Setup layer with the loaded input source
     setupLayerWithInputSource(layer, std::move(inputSource));
     
+    // Resumed cue: back to the state it had before the restart
+    if (resume_) {
+        auto journaled = resume_->layers.find(cueId);
+        if (journaled != resume_->layers.end()) {
+            applyJournalLayer(layer, journaled->second);
+            resume_->layers.erase(journaled);
+        }
+        if (resume_->layers.empty()) {
+            LOG_INFO << "Resume: every journaled cue is loaded";
+            resume_.reset();
+        }
+    }
+    
+    // Cluster follower: the state the authority replicated meanwhile
+    if (cluster_ && !clusterAuthority_) {
+        applyClusterLayer(cueId);
+    }
+    
     LOG_INFO << "Async load complete: " << filepath << " (cue ID: " << cueId << ")";
 }
 
+namespace {
+
+// As the benchmarks name codecs (LoadAdmission coefficients)
+const char* admissionCodec(InputSource::CodecType codec) {
+    switch (codec) {
+        case InputSource::CodecType::HAP:       return "HAP";
+        case InputSource::CodecType::HAP_Q:     return "HAP_Q";
+        case InputSource::CodecType::HAP_ALPHA: return "HAP_ALPHA";
+        case InputSource::CodecType::H264:      return "H264";
+        case InputSource::CodecType::HEVC:      return "HEVC";
+        case InputSource::CodecType::AV1:       return "AV1";
+        default:                                return "SOFTWARE";
+    }
+}
+
+} // namespace
+
+bool VideoComposerApplication::admitLoad(const std::string& cueId, const std::string& filepath,
+                                         InputSource* inputSource) {
+    VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource);
+    VideoLayer* layer = layerManager_->getLayerByCueId(cueId);
+    if (!loadAdmission_ || !videoInput || !layer ||
+        loadAdmission_->getSettings().policy == LoadAdmission::Policy::OFF) {
+        return true;
+    }
+    
+    // Cues unloaded or removed since no longer count
+    loadAdmission_->prune([this](const std::string& id) {
+        VideoLayer* admitted = layerManager_->getLayerByCueId(id);
+        return admitted && admitted->getInputSource();
+    });
+    for (auto it = admissionDegraded_.begin(); it != admissionDegraded_.end();) {
+        it = layerManager_->getLayerByCueId(*it) ? std::next(it) : admissionDegraded_.erase(it);
+    }
+    LoadAdmission::Settings settings = loadAdmission_->getSettings();
+    settings.cpuThreads = DecodeThreadBudget::instance().getTotalThreads();
+    settings.outputHz = refreshFps_ > 0.0 ? refreshFps_ : 60.0;
+    loadAdmission_->configure(settings);
+    
+    FrameInfo info = videoInput->getFrameInfo();
+    VideoFileInput::StreamProfile stream = videoInput->getStreamProfile();
+    LoadAdmission::MediaProfile media;
+    media.codec = admissionCodec(videoInput->detectCodec());
+    media.profile = stream.profileName;
+    media.width = info.width;
+    media.height = info.height;
+    media.framerate = info.framerate;
+    media.peakBitrate = stream.peakBitrate;
+    media.gopLength = stream.gopLength;
+    media.hardware = stream.hardware;
+    LoadAdmission::Decision decision = loadAdmission_->admit(cueId, media);
+    
+    // Degraded earlier, fits now: back to full rate
+    bool degrade = decision.verdict == LoadAdmission::Verdict::DEGRADE;
+    if (admissionDegraded_.count(cueId) && !degrade) {
+        admissionDegraded_.erase(cueId);
+        layer->setRateDivisor(1);
+    }
+    if (degrade) {
+        admissionDegraded_.insert(cueId);
+        layer->setRateDivisor(2);
+    }
+    
+    const LoadAdmission::Load& total = decision.total;
+    if (decision.verdict == LoadAdmission::Verdict::ACCEPT) {
+        LOG_VERBOSE << "Load admission: Cue " << cueId << " fits (cpu " << total.cpu << ", hardware "
+                    << total.hardware << ", gpu " << total.gpu << ")";
+        return true;
+    }
+    LOG_WARNING << "Load admission: Cue " << cueId << " (" << filepath << ", " << stream.codecName
+                << (stream.profileName.empty() ? "" : " " + stream.profileName) << " " << info.width << "x"
+                << info.height << " @ " << info.framerate << ", " << (media.hardware ? "hardware" : "software")
+                << ", peak " << media.peakBitrate / 1000000 << " Mbit/s, GOP " << media.gopLength << ") -> "
+                << LoadAdmission::verdictName(decision.verdict) << ": " << decision.reason;
+    
+    // /videocomposer/admission <cueId> <verdict> <cpu> <hardware> <gpu> (shares after the load)
+    std::string reportTarget = config_->getString("governor_report", "");
+    if (remoteControl_ && !reportTarget.empty()) {
+        remoteControl_->sendMessage(reportTarget, "/videocomposer/admission", cueId,
+                                    {static_cast<double>(decision.verdict), total.cpu, total.hardware, total.gpu});
+    }
+    return decision.verdict != LoadAdmission::Verdict::REJECT;
+}
+
+bool VideoComposerApplication::sendMemoryReport(const std::string& target) {
+    if (!remoteControl_) {
+        return false;
+    }
+    const double MB = 1024.0 * 1024.0;
+    MemoryBudget::Report report = MemoryBudget::instance().getReport();
+    bool sent = true;
+    // /videocomposer/memory/pool <vram|ram> <used MB> <limit MB> <peak MB> <evicted MB> <refusals>
+    for (MemoryBudget::Pool pool : {MemoryBudget::Pool::VRAM, MemoryBudget::Pool::RAM}) {
+        const MemoryBudget::PoolUsage& usage = report.pools[static_cast<size_t>(pool)];
+        sent = remoteControl_->sendMessage(target, "/videocomposer/memory/pool", MemoryBudget::poolName(pool),
+                                           {usage.used / MB, usage.limit / MB, usage.peak / MB,
+                                            usage.evictedBytes / MB, static_cast<double>(usage.refusals)}) &&
+               sent;
+    }
+    // /videocomposer/memory/subsystem <name> <MB>
+    for (size_t i = 0; i < MemoryBudget::SUBSYSTEMS; ++i) {
+        sent = remoteControl_->sendMessage(
+                   target, "/videocomposer/memory/subsystem",
+                   MemoryBudget::subsystemName(static_cast<MemoryBudget::Subsystem>(i)), {report.subsystems[i] / MB}) &&
+               sent;
+    }
+    // /videocomposer/memory/layer <cueId> <layer id> <VRAM MB> <RAM MB> (empty cue id: shared)
+    for (const MemoryBudget::LayerUsage& layer : report.layers) {
+        VideoLayer* videoLayer = layerManager_ ? layerManager_->getLayer(layer.layerId) : nullptr;
+        std::string cueId = videoLayer ? layerManager_->getCueIdFromLayer(videoLayer) : "";
+        sent = remoteControl_->sendMessage(target, "/videocomposer/memory/layer", cueId,
+                                           {static_cast<double>(layer.layerId),
+                                            layer.bytes[static_cast<size_t>(MemoryBudget::Pool::VRAM)] / MB,
+                                            layer.bytes[static_cast<size_t>(MemoryBudget::Pool::RAM)] / MB}) &&
+               sent;
+    }
+    return sent;
+}
+
+bool VideoComposerApplication::resumeShow() {
+    if (!resume_) {
+        return true;
+    }
+    // Indexes and shader binaries come from their caches; loads run in parallel
+    size_t queued = 0;
+    for (auto it = resume_->layers.begin(); it != resume_->layers.end();) {
+        const ShowJournal::Layer& layer = it->second;
+        if (layerManager_->getLayerByCueId(layer.cueId) ||
+            !createLayerWithFile(layer.cueId, layer.source, 1, layer.properties.preload)) {
+            LOG_WARNING << "Resume: cannot reload cue " << layer.cueId << " (" << layer.source << ")";
+            it = resume_->layers.erase(it);
+            continue;
+        }
+        ++queued;
+        ++it;
+    }
+    LOG_INFO << "Resume: reloading " << queued << " cue(s) from the show journal";
+    if (resume_->layers.empty()) {
+        resume_.reset();
+    }
+    return true;
+}
+
+void VideoComposerApplication::updateShowJournal() {
+    if (!showJournal_ || !layerManager_) {
+        return;
+    }
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (now - lastJournalUpdate_ < 1.0) {
+        return;
+    }
+    lastJournalUpdate_ = now;
+    // A start without cues leaves the previous show's journal alone
+    if (journalSources_.empty() && showJournal_->getWriteCount() == 0) {
+        return;
+    }
+    
+    // Copied here, formatted and written on the journal's thread
+    ShowJournal::State state;
+    state.resolutionMode = config_->getString("resolution_mode", "");
+    for (auto it = journalSources_.begin(); it != journalSources_.end();) {
+        VideoLayer* layer = layerManager_->getLayerByCueId(it->first);
+        if (!layer) {
+            it = journalSources_.erase(it);   // Layer removed
+            continue;
+        }
+        const ShowJournal::Layer* loading = nullptr;
+        if (resume_) {
+            auto journaled = resume_->layers.find(it->first);
+            loading = journaled != resume_->layers.end() ? &journaled->second : nullptr;
+        }
+        if (loading) {
+            state.layers.push_back(*loading);   // Still loading: keep what the journal had
+        } else {
+            state.layers.push_back(journalLayer(it->first, it->second, *layer));
+        }
+        ++it;
+    }
+    showJournal_->submit(std::move(state));
+}
+
+void VideoComposerApplication::updateCluster() {
+    if (!cluster_ || !clusterAuthority_ || !layerManager_ || !remoteControl_) {
+        return;
+    }
+    // The journal's lines of every loaded cue; only changed ones are sent
+    ClusterReplicator::Scene scene;
+    for (const auto& entry : journalSources_) {
+        VideoLayer* layer = layerManager_->getLayerByCueId(entry.first);
+        if (layer) {
+            scene[entry.first] = ShowJournal::formatLayer(journalLayer(entry.first, entry.second, *layer));
+        }
+    }
+    RemoteControl* remote = remoteControl_.get();
+    const std::string& group = clusterGroup_;
+    cluster_->publish(scene, vc_get_monotonic_time(),
+                      [remote, &group](const std::string& path, const std::string& label,
+                                       const std::vector<double>& values) {
+                          return remote->sendMessage(group, path, label, values);
+                      });
+}
+
+bool VideoComposerApplication::receiveClusterMessage(ClusterMessage kind, const std::string& label,
+                                                     const std::vector<double>& values) {
+    if (!cluster_ || clusterAuthority_ || !layerManager_) {
+        return false;
+    }
+    std::vector<ClusterReplicator::Change> changes;
+    if (!cluster_->receive(kind, label, values, changes)) {
+        return false;
+    }
+    for (const ClusterReplicator::Change& change : changes) {
+        if (!change.removed) {
+            applyClusterLayer(change.cueId);
+            continue;
+        }
+        if (asyncVideoLoader_) {
+            asyncVideoLoader_->cancelLoad(change.cueId);
+        }
+        journalSources_.erase(change.cueId);
+        if (layerManager_->removeLayerByCueId(change.cueId)) {
+            LOG_INFO << "Cluster: removed cue " << change.cueId;
+        }
+    }
+    return true;
+}
+
+void VideoComposerApplication::applyClusterLayer(const std::string& cueId) {
+    const ClusterReplicator::Lines* lines = cluster_ ? cluster_->findLayer(cueId) : nullptr;
+    if (!lines) {
+        return;
+    }
+    ShowJournal::Layer state;
+    state.cueId = cueId;
+    for (const std::string& line : *lines) {
+        if (!ShowJournal::parseLine(line, state)) {
+            LOG_WARNING << "Cluster: bad line for cue " << cueId << ": " << line;
+        }
+    }
+    if (state.source.empty()) {
+        return;
+    }
+    
+    // New cue, or a new file for it: loaded here too; the state applies when it completes
+    VideoLayer* layer = layerManager_->getLayerByCueId(cueId);
+    if (!layer) {
+        if (!createLayerWithFile(cueId, state.source, 1, state.properties.preload)) {
+            LOG_WARNING << "Cluster: cannot load cue " << cueId << " (" << state.source << ")";
+        }
+        return;
+    }
+    auto loaded = journalSources_.find(cueId);
+    if (loaded == journalSources_.end() || loaded->second != state.source) {
+        loadFileIntoLayer(cueId, state.source);
+    }
+    if (!layer->isReady()) {
+        return;
+    }
+    // Loop counters run on each node: the authority's are its own
+    const LayerProperties& current = layer->properties();
+    if (state.properties.fullFileLoopCount == current.fullFileLoopCount) {
+        state.properties.currentFullFileLoopCount = current.currentFullFileLoopCount;
+    }
+    if (state.properties.loopRegion.loopCount == current.loopRegion.loopCount) {
+        state.properties.loopRegion.currentLoopCount = current.loopRegion.currentLoopCount;
+    }
+    applyJournalLayer(layer, state);
+}
+
 } // namespace videocomposer
 
@@ -1,8 +1,13 @@
 #ifndef VIDEOCOMPOSER_APPLICATION_H
 #define VIDEOCOMPOSER_APPLICATION_H
 
+#include "utils/StartupSequence.h"
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace videocomposer {
 
@@ -11,6 +16,9 @@ class ConfigurationManager;
 class InputSource;
 class SyncSource;
 class MIDISyncSource;
+class FrameLockSyncSource;
+class VblankClockSyncSource;
+class FrameClock;
 class RemoteControl;
 class DisplayBackend;
 class LayerManager;
@@ -19,6 +27,22 @@ class DisplayManager;
 class OSDManager;
 class OpenGLRenderer;
 class AsyncVideoLoader;
+class ProxySwitcher;
+class DecodeGovernor;
+class LoadAdmission;
+class OutputSinkManager;
+class OutputSink;
+class PreviewRenderer;
+class TelemetryPublisher;
+class ThumbnailService;
+class SyncLatencyMonitor;
+struct PresentedFrame;
+class FrameArena;
+class ShowJournal;
+class IdleDetector;
+class WakeSignal;
+class ClusterReplicator;
+enum class ClusterMessage;
 
 #ifdef HAVE_VAAPI_INTEROP
 class VaapiInterop;
@@ -50,6 +74,12 @@ public:
     // Quit application (called from remote control)
     void quit() { running_ = false; }
 
+    // run() returns after this many rendered frames (0 = until quit; startup benchmark)
+    void setFrameLimit(int64_t frames) { frameLimit_ = frames; }
+
+    // Step timings of initialize()
+    const std::vector<StartupSequence::Timing>& getStartupTimings() const { return startupTimings_; }
+
     // Configuration methods (called from remote control)
     bool setFPS(double fps);
     bool setTimeOffset(int64_t offset);
@@ -59,30 +89,65 @@ public:
     LayerManager* getLayerManager() { return layerManager_.get(); }
     OSDManager* getOSDManager() { return osdManager_.get(); }
     DisplayBackend* getDisplayBackend() { return displayBackend_.get(); }
+    FrameLockSyncSource* getFrameLock() { return frameLock_; }
+    VblankClockSyncSource* getInternalClock() { return internalClock_; }
+    SyncSource* getSyncSource() { return globalSyncSource_.get(); }
+    TelemetryPublisher* getTelemetry() { return telemetry_.get(); }
+    SyncLatencyMonitor* getSyncTest() { return syncTest_.get(); }  // Null without --sync-test
     
     // Get renderer access (for master layer controls)
     OpenGLRenderer& renderer();
     
+    // MemoryBudget usage to a "host:port" target (see stats/memory)
+    bool sendMemoryReport(const std::string& target);
+    
     // File loading methods (called from RemoteCommandRouter)
-    bool createLayerWithFile(const std::string& cueId, const std::string& filepath);
-    bool loadFileIntoLayer(const std::string& cueId, const std::string& filepath);
+    // priority orders queued async loads: 0 = background, 1 = normal, 2 = goes next
+    bool createLayerWithFile(const std::string& cueId, const std::string& filepath, int priority = 1,
+                             bool preload = false);
+    bool loadFileIntoLayer(const std::string& cueId, const std::string& filepath, int priority = 1);
     bool unloadFileFromLayer(const std::string& cueId);
+
+    // Change the priority of a queued load (e.g. when a cue becomes the next one)
+    bool prioritizeLoad(const std::string& cueId, int priority);
     
     // Check if a video load is in progress for a cue ID
     bool isLoadPending(const std::string& cueId) const;
+    
+    // Build frame index caches in the background for every file of a show
+    bool prewarmShowIndexes(const std::vector<std::string>& filepaths);
+    
+    // Poster frame of a file for the cue list, answered to target ("" = event_report)
+    bool requestThumbnail(const std::string& filepath, double seconds, int width, const std::string& target);
+    
+    // Scene change from the cluster authority (cluster follower only)
+    bool receiveClusterMessage(ClusterMessage kind, const std::string& label, const std::vector<double>& values);
 
 private:
     // Component initialization
     bool initializeConfiguration(int argc, char** argv);
     bool initializeDisplay();
+    bool initializeVirtualOutputs();
+    bool initializeRecording();
+    bool initializeSharedMemoryOutput();
+    bool initializeNDIOutput();
+    bool initializeDeckLinkOutput();  // SDI/HDMI program out (scheduled playback)
+    bool initializePreviewOutput();   // Operator multiview stream (PreviewRenderer)
+    bool initializeRenderOutput();    // Offline render file (FileEncoderOutput)
     bool initializeRemoteControl();
     bool initializeLayerManager();
+    void initializePlaybackServices();   // Async loader, proxy switching, governor, telemetry, OSD
     bool createInitialLayer();
     bool initializeGlobalSyncSource();
+    void initializeFrameLock();
+    void initializeCluster();     // Scene replication across nodes (ClusterReplicator)
+    bool initializeSyncTest();
+    bool resumeShow();            // Reload the cues of the show journal (--resume)
+    bool configureOfflineRender();   // Settings that make the offline render (--render) exact
     
     // Common helper methods
     std::unique_ptr<InputSource> createInputSource(const std::string& source);
-    std::unique_ptr<InputSource> createInputSourceFromFile(const std::string& filepath);
+    std::unique_ptr<InputSource> createInputSourceFromFile(const std::string& filepath, bool mosaicTile = false);
     std::unique_ptr<VideoLayer> createEmptyLayer(const std::string& cueId);
     std::unique_ptr<SyncSource> createLayerSyncSource(InputSource* inputSource);
     void configureMIDISyncSource(MIDISyncSource* midiSync);
@@ -95,13 +160,47 @@ private:
 
     // Event loop
     void processEvents();
+    void updateInternalClock();
+    void updateDisplayRefresh();
+    void paceVariableRefresh();
+    void updatePresentationLead();
+    void sampleFrameClock();      // The sync position this render is shown at, for every layer (FrameClock)
+    void runScheduledCommands();  // Remote commands due on this frame (/at, bundle timetags)
+    void animateLayers();         // Property tweens at this render's presentation time
     void updateLayers();
+    void lateLatch();             // Pending commands, sync and decoded frames re-read just before the render (--late-latch)
+    void deliverTransportEvents(); // Locates/stops of the global sync source to every layer
     void render();
     void processAsyncLoads();
+    void updateProxySwitching();  // Layers to/from their proxy files (ProxySwitcher)
+    void updateNDIBandwidth();    // Shown sizes to NDI inputs (proxy stream when small)
+    void updateLoadGovernor();    // Priority-ordered degradation under load (DecodeGovernor)
+    void trackLateFrames();       // Output frames that missed their vsync
+    void updateFlightRecorder(int64_t frame, int64_t workStartNs);   // Frame times to the FlightRecorder, a trigger when over budget
+    void updateGpuTimingOSD();    // Overlay text of the GPU timings (OSDManager::GPU)
+    void reportSeekCompletions(); // Finished asynchronous seeks to the event_report target
+    void reportThumbnails();      // Finished thumbnails to their requesters (ThumbnailService)
+    void updateTelemetry();       // Health messages to /stats/subscribe targets (TelemetryPublisher)
+    void updateShowJournal();     // Loaded cues to the show journal writer (ShowJournal)
+    void updateCluster();         // Scene changes to the cluster followers (authority)
+    void applyClusterLayer(const std::string& cueId);   // Replicated state of a cue to its layer (follower)
+    void planSyncTest();          // Frame and vsync of this render (sync test)
+    void initializeIdle();        // Idle power mode (IdleDetector), once the components exist
+    bool updateIdle();            // false: nothing to show, hold the outputs' last frame
+    void waitWhileIdle();         // Sleep until a command, a moving clock or the next tick
+    bool syncMoved();             // External sync rolled or located since the last check
+    void updateSyncTest();        // Flips since the last render against the sync source (sync test)
+    void reportLoopAllocations(uint64_t allocations, const FrameArena& arena);  // Debug builds (AllocationCounter)
+    
+    // Offline render (--render): frames stepped as fast as they composite
+    int runOffline();
+    void waitForPendingLoads();   // Loads finish before the clock moves on
+    int64_t longestLayerFrames(double fps) const;   // Show frames until the last layer ends
     
     // Async load callback (called when a video finishes loading)
     void onAsyncLoadComplete(const std::string& cueId, const std::string& filepath,
                             std::unique_ptr<InputSource> inputSource, bool success);
+    bool admitLoad(const std::string& cueId, const std::string& filepath, InputSource* inputSource);  // LoadAdmission
 
     // Component pointers
     std::unique_ptr<ConfigurationManager> config_;
@@ -113,13 +212,98 @@ private:
     
     // Global sync source (shared across all layers)
     std::unique_ptr<SyncSource> globalSyncSource_;
+    FrameLockSyncSource* frameLock_;  // globalSyncSource_ when frame lock is on
+    VblankClockSyncSource* internalClock_;  // Internal clock inside globalSyncSource_, if used
+    std::unique_ptr<FrameClock> frameClock_;  // globalSyncSource_ sampled once per render, polled by the layers
+    std::string outputClockSinkId_;  // Sink whose output clock the loop follows (decklink_clock)
+    bool getOutputClock(int64_t& frame, double& rateHz, int64_t& leadNs);
     
     // Async video loader
     std::unique_ptr<AsyncVideoLoader> asyncVideoLoader_;
+    std::unique_ptr<ProxySwitcher> proxySwitcher_;
+    double lastProxyUpdate_ = -1.0;
+    std::unique_ptr<DecodeGovernor> decodeGovernor_;
+    double lastGovernorUpdate_ = -1.0;
+    std::unique_ptr<LoadAdmission> loadAdmission_;
+    std::set<std::string> admissionDegraded_;  // Cues admitted at half rate
+    int64_t lastVblank_ = -1;
+    uint64_t lateFrames_ = 0;
+    double vblankHz_ = 0.0;       // Refresh of the target vblank (0 = no fixed cadence)
+    uint64_t flightGpuFrame_ = 0; // GPU timer frame last given to the flight recorder
+    uint64_t gpuOsdFrame_ = 0;    // GPU timer frame the overlay text was made at
+    std::unique_ptr<TelemetryPublisher> telemetry_;
+    std::unique_ptr<ThumbnailService> thumbnails_;   // Worker starts with the first request
+    int64_t lastLoopUs_ = -1;     // Previous loop iteration (telemetry frame times)
+    uint64_t loopAllocations_ = 0;     // Heap allocations on the render thread since the last report
+    uint64_t allocatingFrames_ = 0;
+    uint64_t allocationFrames_ = 0;
+    int64_t lastAllocationReportUs_ = 0;
+    std::unique_ptr<OutputSinkManager> outputSinkManager_;   // Virtual outputs (recording, shared memory, NDI)
+    std::unique_ptr<PreviewRenderer> preview_;      // Operator multiview, drawn by the display backend
+    std::unique_ptr<OutputSink> previewSink_;       // Its encoder, apart from the program's sinks
+    
+    // Show journal (crash recovery): the source each cue was loaded from,
+    // and with --resume the journaled cues whose loads are still to finish
+    struct ResumeState;
+    std::unique_ptr<ShowJournal> showJournal_;
+    std::map<std::string, std::string> journalSources_;
+    std::unique_ptr<ResumeState> resume_;
+    double lastJournalUpdate_ = -1.0;
+    
+    // Cluster mode: the authority replicates the loaded cues (the journal's
+    // lines) to the followers over a multicast group
+    std::unique_ptr<ClusterReplicator> cluster_;
+    bool clusterAuthority_ = false;
+    std::string clusterGroup_;
+    
+    // Sync test (--sync-test): a test pattern layer whose flips are
+    // measured against the sync source
+    std::unique_ptr<SyncLatencyMonitor> syncTest_;
+    std::vector<PresentedFrame> presentedFrames_;
+    int syncTestLayerId_ = -1;
+    int64_t lastSyncReportUs_ = 0;
+    
+    // Idle power mode: with nothing on screen the loop stops compositing and
+    // flipping, and sleeps until remote commands (woken by the protocol) or
+    // an external clock move
+    std::unique_ptr<IdleDetector> idleDetector_;
+    std::unique_ptr<WakeSignal> idleWake_;
+    bool loopActivity_ = false;     // Commands or loads handled this frame
+    bool backendIdle_ = false;      // Outputs hold their frame (DisplayBackend::setIdle)
+    int64_t idleSyncFrame_ = -1;    // External sync frame last seen
+    
+    // Transport events read from the global sync source (the serial is the source's)
+    const SyncSource* transportSource_ = nullptr;
+    uint64_t transportSerial_ = 0;
+    size_t idleOutputCount_ = 0;    // Outputs last seen (hotplug ends idle)
+    
+    // Frame selection target: predicted scanout + display lag
+    bool vsyncTarget_;
+    bool lateLatch_;              // Re-read commands and sync just before the render
+    int64_t displayLagNs_;
+    int64_t presentationLeadNs_;  // From now to the vblank this render is shown on
+    int64_t presentationUs_;      // Monotonic time of that vblank
+    
+    // Show framerate given to the display backend, and the one its
+    // refresh rate was matched to (0 = none yet)
+    double videoFps_;
+    double refreshFps_;
+    
+    // Variable refresh: framerate asked for, framerate active (0 = fixed
+    // refresh) and monotonic time of the next paced flip
+    double vrrRequested_;
+    double vrrFps_;
+    int64_t nextFlipUs_;
+
+    // Offline render instead of the vsync-driven show loop
+    bool offlineRender_;
 
     // Application state
     bool running_;
     bool initialized_;
+    int64_t frameLimit_ = 0;
+    bool controlReplay_ = false;      // --replay-control log loaded
+    std::vector<StartupSequence::Timing> startupTimings_;
 };
 
 } // namespace videocomposer
@@ -1,6 +1,7 @@
 #include "ConfigurationManager.h"
 #include <fstream>
 #include <sstream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
@@ -18,6 +19,7 @@ ConfigurationManager::~ConfigurationManager() {
 void ConfigurationManager::loadDefaults() {
     // Set default values
     setInt("osc_port", 7000); // Default OSC port
+    setString("local_control", ""); // Unix socket of the shared-memory control channel (empty = off)
     setBool("remote_en", false);
     setBool("mq_en", false);
     setBool("want_quiet", false);
@@ -26,13 +28,147 @@ void ConfigurationManager::loadDefaults() {
     setInt("offset", 0);
     setString("midi_port", "-1"); // -1 = autodetect
     setBool("midi_clkadj", false); // MIDI clock adjustment
+    setString("ltc_device", ""); // ALSA capture device for LTC sync (empty = MTC)
+    setInt("ltc_channel", 1); // Input channel carrying LTC (1-based)
+    setBool("internal_sync", false); // Free-running vblank clock instead of MTC/LTC
+    setDouble("internal_sync_fps", 25.0); // Timecode framerate of the internal clock
+    setBool("sync_test", false); // Frame-coded test pattern, flips measured against the sync source
+    setBool("sync_test_readback", false); // Sync test reads frame numbers back from the canvas
+    setString("sync_test_media", ""); // Frame-coded clip played by the sync test (empty = generated pattern)
+    setString("framelock", ""); // Multi-node frame lock role: master, follower (empty = off)
+    setString("framelock_peers", ""); // Followers receiving the master's timeline (host:port,...)
+    setString("framelock_report", ""); // Receiver of skew telemetry (host:port, empty = none)
+    setString("framelock_node", ""); // Node name in telemetry (empty = hostname)
+    setString("cluster", ""); // Multi-node cluster role: authority, follower (empty = off)
+    setString("cluster_group", "239.255.42.1:7100"); // Multicast group:port the scene is replicated on
+    setString("cluster_canvas", ""); // Whole cluster canvas WxH; outputs are placed in it (empty = this node's)
+    setDouble("cluster_keyframe_s", 1.0); // Authority resends the full scene every N seconds
     setDouble("delay", -1.0); // Frame delay (1.0/fps, or -1 to use file framerate)
     setBool("want_letterbox", true);
     setBool("start_fullscreen", false);
     setBool("start_ontop", false);
     setBool("want_noindex", false); // Index frames by default for frame-accurate seeking
     setString("hardware_decoder", "auto");
+    setInt("frame_pool_budget_mb", 128); // Per-layer decode-ahead frame pool budget
+    setInt("reverse_cache_mb", 256); // Per-layer reverse playback GOP ring budget
+    setInt("decode_ahead_budget_mb", 0); // Decode-ahead memory shared by all layers (0 = per-layer pools only)
+    setDouble("decode_underrun_target", 0.01); // Fraction of decodes allowed to outlast the decode-ahead queue
+    setInt("decode_threads", 0); // Software decoder threads shared by all layers (0 = one per core)
+    setInt("decoder_pool", 2); // Opened decoders of closed layers kept for reloads of the same format (0 = off)
+    setInt("decode_slots", 0); // Software frame decodes at once across layers, earliest deadline first (0 = half the cores)
+    setInt("hw_decode_slots", 0); // Hardware frame decodes at once across layers (0 = 2)
+    setInt("intra_decoders", 0); // Parallel decoders per intra-only layer (0 = its decode thread share, 1 = off)
+    setBool("index_cache", true); // Persist frame indexes between runs
+    setString("index_cache_dir", ""); // Empty = $XDG_CACHE_HOME/cuems-videocomposer/index
+    setInt("tiled_image_threshold", 8192); // Stills wider or taller are drawn from a streamed tile pyramid (0 = never)
+    setInt("tiled_image_vram_mb", 256); // Tile atlas per tiled still layer
+    setString("tile_cache_dir", ""); // Empty = $XDG_CACHE_HOME/cuems-videocomposer/tiles
+    setBool("shader_cache", true); // Persist linked GL program binaries between runs
+    setString("shader_cache_dir", ""); // Empty = $XDG_CACHE_HOME/cuems-videocomposer/shaders
+    setBool("background_indexing", false); // Index on a background thread, play immediately
+    setInt("layer_threads", -1); // Parallel layer frame loads (-1 = auto, 0 = serial)
+    setInt("layer_update_deadline_ms", 12); // Per-frame budget for layer frame loads (0 = none)
+    setBool("vulkan_display", false); // Composite with Vulkan and present through VK_KHR_display (builds with ENABLE_VULKAN_DISPLAY)
+    setBool("upload_thread", false); // Upload CPU frames on a thread with a shared EGL context
+    setBool("gpu_yuv", true); // Convert 4:2:0 software-decoded, UYVY NDI and V4L2 capture frames to RGB on the GPU
+    setBool("layer_batching", true); // Draw plain layers with one instanced draw call
+    setInt("hap_threads", -1); // Threads for HAP chunk decompression, all layers (-1 = auto)
+    // Thread roles: policy[:priority][@cpus], e.g. fifo:70@2-3 (empty = default)
+    setString("thread_render", ""); // Main loop (composite, flip)
+    setString("thread_midi", ""); // MTC receive (default fifo:55)
+    setString("thread_ltc", ""); // LTC capture (default fifo:60)
+    setString("thread_osc", ""); // OSC receive
+    setString("thread_decode", ""); // Layer decode, image sequences, live inputs
+    setString("thread_loader", ""); // Cue loading, prefetch, background indexing
+    setString("thread_hap", ""); // HAP chunk decompression
+    setString("thread_io", ""); // Read-ahead, page cache policy, journal and trace writers
+    setString("thread_output", ""); // Encoders and output sinks
+    setBool("lock_memory", false); // mlockall: no page faults on real-time threads
+    setBool("vsync_target", true); // Pick frames for their predicted scanout time, not render time
+    setBool("late_latch", false); // Re-read commands, sync and decoded frames just before the render
+    setInt("display_lag_ms", 0); // Display processing latency after scanout, added to the frame target
+    setBool("match_refresh", false); // Switch outputs to a refresh rate that is a multiple of the show fps
+    setBool("vrr", false); // Variable refresh for single-framerate shows on VRR-capable outputs
+    setBool("idle_power_save", true); // Stop compositing and flipping while nothing is on screen (outputs hold their last frame)
+    setString("record", ""); // Encode the program output on the GPU to a file or URL (empty = off)
+    setString("record_codec", "h264"); // h264 or hevc
+    setInt("record_bitrate_kbps", 0); // 0 = 6 bit/s per pixel (12 Mbit/s at 1080p)
+    setString("shm_output", ""); // Unix socket of the shared-memory frame ring (empty = off)
+    setString("shm_format", "rgba"); // rgba, bgra, uyvy, nv12 or i420
+    setBool("shm_dmabuf", false); // Also export the ring slots as dmabufs (/dev/udmabuf)
+    setInt("capture_readback_depth", 3); // Fenced readbacks of the program in flight per capture format
+    setString("ndi_output", ""); // NDI source name of the program output (empty = off)
+    setString("decklink_output", ""); // DeckLink card of the SDI/HDMI program output: index, part of its name or "auto" (empty = off)
+    setString("decklink_mode", ""); // DeckLink video mode name, e.g. "1080p25" (empty = canvas size at the show rate)
+    setBool("decklink_clock", false); // Count the show clock in DeckLink output frames (genlocked) instead of display vblanks
+    setBool("ndi_adaptive_bandwidth", true); // NDI layers shown no larger than the sender's proxy receive the low-bandwidth stream
+    setBool("ndi_discovery", true); // Keep a directory of NDI sources from startup (NDI cues connect without a discovery wait)
+    setString("preview", ""); // Stream a multiview of the program and every layer here (srt:// / udp://, empty = off)
+    setInt("preview_width", 640); // Multiview atlas size
+    setInt("preview_height", 360);
+    setDouble("preview_fps", 5.0); // Grids per second while within the GPU budget
+    setDouble("preview_gpu_budget_ms", 1.0); // GPU time one grid may take; dearer grids come less often
+    setInt("preview_bitrate_kbps", 1000);
+    setString("render", ""); // Offline render: composite the show faster than realtime into this file (empty = off)
+    setString("render_start", "0"); // First show frame of the render (frames or SMPTE timecode)
+    setInt("render_frames", 0); // Frames to render (0 = until the longest layer ends)
+    setDouble("render_fps", 25.0);
+    setString("render_codec", "prores"); // prores (422 HQ), hap, hap_alpha or hap_q
+    setInt("render_width", 1920);
+    setInt("render_height", 1080);
+    setInt("v4l2_buffers", 5); // V4L2 capture queue depth (the composer holds up to 3)
+    setString("v4l2_format", "auto"); // V4L2 capture format: auto, nv12, uyvy or yuyv
+    setBool("stream_low_latency", true); // Unbuffered demux, low_delay decode and a jitter buffer for network streams
+    setInt("stream_latency_ms", 100); // Network stream jitter buffer target (0 = show frames as they decode)
+    setDouble("sequence_fps", 25.0); // Framerate of image sequences (files carry none)
+    setInt("sequence_threads", -1); // Image sequence decode threads (-1 = one per core, up to 8)
+    setInt("sequence_read_ahead", 12); // Image sequence frames decoded ahead of the playhead
+    setInt("sequence_cache_mb", 512); // Image sequence decoded frame memory per layer
+    setInt("loader_threads", -1); // Cue load worker threads (-1 = one per core, up to 8)
+    setString("read_ahead", "auto"); // Chunked async reads for decode-ahead: auto (network filesystems), on or off
+    setInt("read_ahead_mb", 16); // Read-ahead window per file
+    setInt("preload_budget_mb", 2048); // RAM shared by clips of layers flagged for preload
+    setInt("vram_budget_mb", 0); // Video memory for textures, surfaces and caches (0 = 90% of what the driver reports)
+    setInt("ram_budget_mb", 0); // RAM for frame pools, preloaded clips and prefetch (0 = no limit)
+    setBool("page_cache_policy", true); // Drop page cache behind playheads, prefetch upcoming cues
+    setInt("page_cache_prefetch_mb", 64); // Opening of queued cue files prefetched and kept cached
+    setInt("page_cache_keep_behind_mb", 64); // Page cache kept behind the slowest playhead of a file
+    setInt("direct_io_mbps", 0); // O_DIRECT decode-ahead reads for files of at least this bitrate (0 = off)
+    setBool("proxy_media", true); // Play "name.proxy.ext" on layers its resolution still covers
+    setBool("proxy_switching", true); // Switch playing layers to/from proxies (shown small, overload, scrubbing)
+    setDouble("proxy_load_misses", 2.0); // Decode misses per second (all layers) that count as overload
+    setDouble("proxy_hold_s", 10.0); // Overload-free seconds before layers go back to the master
+    setInt("keyframe_only_step", 8); // Fast forward: decode keyframes only from this many frames per update (0 = never)
+    setString("deinterlace", "auto"); // auto (interlaced-flagged sources), off, bob, adaptive; shown at field rate
+    setBool("governor", true); // Degrade low-priority layers (proxy, then half rate) when overloaded
+    setDouble("governor_misses", 2.0); // Decode misses per second (all layers) that count as overload
+    setDouble("governor_late_frames", 2.0); // Output frames per second past their vsync that count as overload
+    setString("admission", "warn"); // Loads predicted over capacity: off, warn, reject or degrade (half rate)
+    setDouble("admission_headroom", 0.9); // Share of CPU decode, hardware decode and GPU loads may fill
+    setString("admission_costs", ""); // Benchmark results (bench_decode/bench_composite JSON Lines) with this machine's costs
+    setString("governor_report", ""); // host:port to send governor and admission decisions to over OSC (empty = none)
+    setString("event_report", ""); // host:port to send layer events (asynchronous seek done) to over OSC (empty = none)
+    setString("thumbnail_cache_dir", ""); // Poster frame cache (empty = $XDG_CACHE_HOME/cuems-videocomposer/thumbnails)
+    setString("thumbnail_format", "jpg"); // Poster frames written as jpg or png
+    setInt("thumbnail_width", 320); // Poster frame width when a request gives none
+    setBool("thumbnail_hardware", true); // Keyframe decode and scaling of poster frames on the video engine
+    setBool("trace", true); // Record the frame timeline (dumped with /videocomposer/trace/dump)
+    setBool("flight_recorder", true); // Snapshot the timeline to disk on missed vblanks, decode underruns and frames over budget
+    setString("flight_recorder_dir", ""); // Snapshot directory (empty = $XDG_CACHE_HOME/cuems-videocomposer/flight)
+    setDouble("flight_recorder_seconds", 10.0); // Seconds of timeline before the trigger in a snapshot
+    setString("control_capture", ""); // File the MTC and remote command traffic is recorded to (empty = none)
+    setString("control_replay", ""); // Recorded control traffic played back instead of MIDI and with the OSC commands (empty = none)
+    setBool("control_replay_fast", false); // Replay a frame of the recording per render instead of with its timing
+    setBool("gpu_timers", true); // GPU timestamp queries per layer and pass (/videocomposer/stats/gpu)
+    setBool("dynamic_resolution", false); // Composite the canvas smaller when the GPU nears its frame budget (needs gpu_timers)
+    setDouble("dynamic_resolution_min", 0.5); // Smallest canvas scale per axis (steps of 1/8)
+    setString("render_nodes", "auto"); // GPUs hardware decoders are spread over: auto, off or comma-separated /dev/dri/renderD* paths
+    setString("primary_render_node", ""); // Render node of the compositing GPU (empty = first decode node)
+    setString("hw_caps_cache", ""); // File the probed hardware decode capabilities are kept in (empty = probe every start)
     setString("resolution_mode", "1080p"); // Default resolution mode
+    setBool("show_journal", true); // Keep the loaded cues and their properties on disk for --resume
+    setString("show_journal_file", ""); // Empty = $XDG_CACHE_HOME/cuems-videocomposer/show.journal
+    setBool("resume", false); // Reload the cues of the show journal at startup (after a crash)
 }
 
 bool ConfigurationManager::loadFromFile(const std::string& filename) {
@@ -103,6 +239,10 @@ int ConfigurationManager::parseCommandLine(int argc, char** argv) {
             } else {
                 setInt("osc_port", 7000); // Default port
             }
+        } else if (arg == "--local-control") {
+            if (i + 1 < argc) {
+                setString("local_control", argv[++i]);
+            }
         } else if (arg == "--remote" || arg == "-R") {
             setBool("remote_en", true);
         } else if (arg == "--mq" || arg == "-Q") {
@@ -125,6 +265,58 @@ int ConfigurationManager::parseCommandLine(int argc, char** argv) {
             }
         } else if (arg == "--midi-clkadj" || arg == "--midi-clk") {
             setBool("midi_clkadj", true);
+        } else if (arg == "--ltc") {
+            if (i + 1 < argc) {
+                setString("ltc_device", argv[++i]);
+            }
+        } else if (arg == "--framelock") {
+            if (i + 1 < argc) {
+                setString("framelock", argv[++i]);
+            }
+        } else if (arg == "--framelock-peers") {
+            if (i + 1 < argc) {
+                setString("framelock_peers", argv[++i]);
+            }
+        } else if (arg == "--framelock-report") {
+            if (i + 1 < argc) {
+                setString("framelock_report", argv[++i]);
+            }
+        } else if (arg == "--framelock-node") {
+            if (i + 1 < argc) {
+                setString("framelock_node", argv[++i]);
+            }
+        } else if (arg == "--cluster") {
+            if (i + 1 < argc) {
+                setString("cluster", argv[++i]);
+            }
+        } else if (arg == "--cluster-group") {
+            if (i + 1 < argc) {
+                setString("cluster_group", argv[++i]);
+            }
+        } else if (arg == "--cluster-canvas") {
+            if (i + 1 < argc) {
+                setString("cluster_canvas", argv[++i]);
+            }
+        } else if (arg == "--internal-sync") {
+            setBool("internal_sync", true);
+        } else if (arg == "--internal-sync-fps") {
+            if (i + 1 < argc) {
+                setDouble("internal_sync_fps", std::atof(argv[++i]));
+            }
+        } else if (arg == "--sync-test") {
+            setBool("sync_test", true);
+        } else if (arg == "--sync-test-readback") {
+            setBool("sync_test", true);
+            setBool("sync_test_readback", true);
+        } else if (arg == "--sync-test-media") {
+            if (i + 1 < argc) {
+                setBool("sync_test", true);
+                setString("sync_test_media", argv[++i]);
+            }
+        } else if (arg == "--ltc-channel") {
+            if (i + 1 < argc) {
+                setInt("ltc_channel", std::atoi(argv[++i]));
+            }
         } else if (arg == "--fullscreen" || arg == "-s") {
             setBool("start_fullscreen", true);
         } else if (arg == "--ontop" || arg == "-a") {
@@ -138,6 +330,330 @@ int ConfigurationManager::parseCommandLine(int argc, char** argv) {
                 std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
                 setString("hardware_decoder", value);
             }
+        } else if (arg == "--upload-thread") {
+            setBool("upload_thread", true);
+        } else if (arg == "--no-gpu-yuv") {
+            setBool("gpu_yuv", false);
+        } else if (arg == "--no-layer-batching") {
+            setBool("layer_batching", false);
+        } else if (arg == "--layer-threads") {
+            if (i + 1 < argc) {
+                setInt("layer_threads", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--hap-threads") {
+            if (i + 1 < argc) {
+                setInt("hap_threads", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--thread") {
+            if (i + 1 < argc) {
+                // ROLE=SPEC, e.g. render=fifo:70@2-3
+                std::string value = argv[++i];
+                size_t eq = value.find('=');
+                if (eq != std::string::npos) {
+                    setString("thread_" + value.substr(0, eq), value.substr(eq + 1));
+                }
+            }
+        } else if (arg == "--lock-memory") {
+            setBool("lock_memory", true);
+        } else if (arg == "--match-refresh") {
+            setBool("match_refresh", true);
+        } else if (arg == "--vrr") {
+            setBool("vrr", true);
+        } else if (arg == "--no-idle-power-save") {
+            setBool("idle_power_save", false);
+        } else if (arg == "--record") {
+            if (i + 1 < argc) {
+                setString("record", argv[++i]);
+            }
+        } else if (arg == "--record-codec") {
+            if (i + 1 < argc) {
+                setString("record_codec", argv[++i]);
+            }
+        } else if (arg == "--record-bitrate") {
+            if (i + 1 < argc) {
+                setInt("record_bitrate_kbps", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--preview") {
+            if (i + 1 < argc) {
+                setString("preview", argv[++i]);
+            }
+        } else if (arg == "--preview-size") {
+            if (i + 1 < argc) {
+                int width = 0, height = 0;
+                if (std::sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                    setInt("preview_width", width);
+                    setInt("preview_height", height);
+                }
+            }
+        } else if (arg == "--preview-fps") {
+            if (i + 1 < argc) {
+                setDouble("preview_fps", std::atof(argv[++i]));
+            }
+        } else if (arg == "--preview-budget") {
+            if (i + 1 < argc) {
+                setDouble("preview_gpu_budget_ms", std::atof(argv[++i]));
+            }
+        } else if (arg == "--render") {
+            if (i + 1 < argc) {
+                setString("render", argv[++i]);
+            }
+        } else if (arg == "--render-start") {
+            if (i + 1 < argc) {
+                setString("render_start", argv[++i]);
+            }
+        } else if (arg == "--render-frames") {
+            if (i + 1 < argc) {
+                setInt("render_frames", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--render-fps") {
+            if (i + 1 < argc) {
+                setDouble("render_fps", std::atof(argv[++i]));
+            }
+        } else if (arg == "--render-codec") {
+            if (i + 1 < argc) {
+                setString("render_codec", argv[++i]);
+            }
+        } else if (arg == "--render-size") {
+            if (i + 1 < argc) {
+                int width = 0, height = 0;
+                if (std::sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                    setInt("render_width", width);
+                    setInt("render_height", height);
+                }
+            }
+        } else if (arg == "--shm-output") {
+            if (i + 1 < argc) {
+                setString("shm_output", argv[++i]);
+            }
+        } else if (arg == "--shm-format") {
+            if (i + 1 < argc) {
+                setString("shm_format", argv[++i]);
+            }
+        } else if (arg == "--shm-dmabuf") {
+            setBool("shm_dmabuf", true);
+        } else if (arg == "--capture-readback-depth") {
+            if (i + 1 < argc) {
+                setInt("capture_readback_depth", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--decklink-output") {
+            if (i + 1 < argc) {
+                setString("decklink_output", argv[++i]);
+            }
+        } else if (arg == "--decklink-mode") {
+            if (i + 1 < argc) {
+                setString("decklink_mode", argv[++i]);
+            }
+        } else if (arg == "--decklink-clock") {
+            setBool("decklink_clock", true);
+        } else if (arg == "--no-ndi-adaptive-bandwidth") {
+            setBool("ndi_adaptive_bandwidth", false);
+        } else if (arg == "--no-ndi-discovery") {
+            setBool("ndi_discovery", false);
+        } else if (arg == "--ndi-output") {
+            if (i + 1 < argc) {
+                setString("ndi_output", argv[++i]);
+            }
+        } else if (arg == "--v4l2-buffers") {
+            if (i + 1 < argc) {
+                setInt("v4l2_buffers", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--v4l2-format") {
+            if (i + 1 < argc) {
+                setString("v4l2_format", argv[++i]);
+            }
+        } else if (arg == "--stream-latency") {
+            if (i + 1 < argc) {
+                setInt("stream_latency_ms", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--no-stream-low-latency") {
+            setBool("stream_low_latency", false);
+        } else if (arg == "--sequence-fps") {
+            if (i + 1 < argc) {
+                setDouble("sequence_fps", std::atof(argv[++i]));
+            }
+        } else if (arg == "--sequence-threads") {
+            if (i + 1 < argc) {
+                setInt("sequence_threads", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--sequence-read-ahead") {
+            if (i + 1 < argc) {
+                setInt("sequence_read_ahead", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--sequence-cache") {
+            if (i + 1 < argc) {
+                setInt("sequence_cache_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--loader-threads") {
+            if (i + 1 < argc) {
+                setInt("loader_threads", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--read-ahead") {
+            if (i + 1 < argc) {
+                setString("read_ahead", argv[++i]);
+            }
+        } else if (arg == "--read-ahead-mb") {
+            if (i + 1 < argc) {
+                setInt("read_ahead_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--preload-budget") {
+            if (i + 1 < argc) {
+                setInt("preload_budget_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--vram-budget") {
+            if (i + 1 < argc) {
+                setInt("vram_budget_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--ram-budget") {
+            if (i + 1 < argc) {
+                setInt("ram_budget_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--no-page-cache-policy") {
+            setBool("page_cache_policy", false);
+        } else if (arg == "--direct-io-mbps") {
+            if (i + 1 < argc) {
+                setInt("direct_io_mbps", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--no-proxy") {
+            setBool("proxy_media", false);
+        } else if (arg == "--keyframe-only-step") {
+            if (i + 1 < argc) {
+                setInt("keyframe_only_step", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--deinterlace") {
+            if (i + 1 < argc) {
+                setString("deinterlace", argv[++i]);
+            }
+        } else if (arg == "--no-governor") {
+            setBool("governor", false);
+        } else if (arg == "--no-trace") {
+            setBool("trace", false);
+        } else if (arg == "--no-flight-recorder") {
+            setBool("flight_recorder", false);
+        } else if (arg == "--flight-recorder-dir") {
+            if (i + 1 < argc) {
+                setString("flight_recorder_dir", argv[++i]);
+            }
+        } else if (arg == "--capture-control") {
+            if (i + 1 < argc) {
+                setString("control_capture", argv[++i]);
+            }
+        } else if (arg == "--replay-control") {
+            if (i + 1 < argc) {
+                setString("control_replay", argv[++i]);
+            }
+        } else if (arg == "--replay-fast") {
+            setBool("control_replay_fast", true);
+        } else if (arg == "--no-gpu-timers") {
+            setBool("gpu_timers", false);
+        } else if (arg == "--dynamic-resolution") {
+            setBool("dynamic_resolution", true);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                setDouble("dynamic_resolution_min", std::atof(argv[++i]));
+            }
+        } else if (arg == "--admission") {
+            if (i + 1 < argc) {
+                setString("admission", argv[++i]);
+            }
+        } else if (arg == "--admission-costs") {
+            if (i + 1 < argc) {
+                setString("admission_costs", argv[++i]);
+            }
+        } else if (arg == "--governor-report") {
+            if (i + 1 < argc) {
+                setString("governor_report", argv[++i]);
+            }
+        } else if (arg == "--event-report") {
+            if (i + 1 < argc) {
+                setString("event_report", argv[++i]);
+            }
+        } else if (arg == "--render-nodes") {
+            if (i + 1 < argc) {
+                setString("render_nodes", argv[++i]);
+            }
+        } else if (arg == "--primary-render-node") {
+            if (i + 1 < argc) {
+                setString("primary_render_node", argv[++i]);
+            }
+        } else if (arg == "--hw-caps-cache") {
+            if (i + 1 < argc) {
+                setString("hw_caps_cache", argv[++i]);
+            }
+        } else if (arg == "--resume") {
+            setBool("resume", true);
+        } else if (arg == "--no-show-journal") {
+            setBool("show_journal", false);
+        } else if (arg == "--show-journal") {
+            if (i + 1 < argc) {
+                setString("show_journal_file", argv[++i]);
+            }
+        } else if (arg == "--no-vsync-target") {
+            setBool("vsync_target", false);
+        } else if (arg == "--late-latch") {
+            setBool("late_latch", true);
+        } else if (arg == "--vulkan-display") {
+            setBool("vulkan_display", true);
+        } else if (arg == "--display-lag") {
+            if (i + 1 < argc) {
+                setInt("display_lag_ms", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--background-index") {
+            setBool("background_indexing", true);
+        } else if (arg == "--no-index-cache") {
+            setBool("index_cache", false);
+        } else if (arg == "--index-cache-dir") {
+            if (i + 1 < argc) {
+                setString("index_cache_dir", argv[++i]);
+            }
+        } else if (arg == "--tiled-image-threshold") {
+            if (i + 1 < argc) {
+                setInt("tiled_image_threshold", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--tiled-image-vram-mb") {
+            if (i + 1 < argc) {
+                setInt("tiled_image_vram_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--tile-cache-dir") {
+            if (i + 1 < argc) {
+                setString("tile_cache_dir", argv[++i]);
+            }
+        } else if (arg == "--no-shader-cache") {
+            setBool("shader_cache", false);
+        } else if (arg == "--shader-cache-dir") {
+            if (i + 1 < argc) {
+                setString("shader_cache_dir", argv[++i]);
+            }
+        } else if (arg == "--frame-pool-mb") {
+            if (i + 1 < argc) {
+                setInt("frame_pool_budget_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--decode-ahead-mb") {
+            if (i + 1 < argc) {
+                setInt("decode_ahead_budget_mb", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--decode-threads") {
+            if (i + 1 < argc) {
+                setInt("decode_threads", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--decoder-pool") {
+            if (i + 1 < argc) {
+                setInt("decoder_pool", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--decode-slots") {
+            if (i + 1 < argc) {
+                setInt("decode_slots", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--hw-decode-slots") {
+            if (i + 1 < argc) {
+                setInt("hw_decode_slots", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--intra-decoders") {
+            if (i + 1 < argc) {
+                setInt("intra_decoders", std::atoi(argv[++i]));
+            }
+        } else if (arg == "--reverse-cache-mb") {
+            if (i + 1 < argc) {
+                setInt("reverse_cache_mb", std::atoi(argv[++i]));
+            }
         } else if (arg == "--discover-ndi" || arg == "--list-ndi") {
             setBool("discover_ndi", true);
             if (i + 1 < argc && argv[i + 1][0] != '-') {
@@ -235,12 +751,115 @@ void ConfigurationManager::printUsage() const {
     printf("  -m, --midi PORT        specify MIDI port (ALSA Sequencer port ID or -1 for autodetect)\n");
     printf("                         Default: -1 (autodetect, connects to Midi Through if available)\n");
     printf("  --midi-clkadj           enable MIDI clock adjustment\n");
+    printf("  --ltc DEVICE            sync to LTC captured from an ALSA device (e.g. hw:1,0) instead of MTC\n");
+    printf("  --ltc-channel N         input channel carrying LTC (default: 1)\n");
+    printf("  --internal-sync         free-run on an internal clock counted in display vblanks\n");
+    printf("  --internal-sync-fps FPS timecode framerate of the internal clock (default: 25)\n");
+    printf("  --sync-test             show a frame-coded test pattern and measure cadence and latency\n");
+    printf("                         of its flips against the sync source (/synctest/report)\n");
+    printf("  --sync-test-readback    sync test, frame numbers read back from the composited canvas\n");
+    printf("  --sync-test-media FILE  sync test playing a frame-coded clip (cuems_videocomposer_bench_media)\n");
+    printf("  --framelock ROLE        lock frames with other nodes: master or follower\n");
+    printf("  --framelock-peers LIST  followers (host:port,...) the master sends its timeline to\n");
+    printf("  --framelock-report H:P  send frame lock skew telemetry to H:P once a second\n");
+    printf("  --framelock-node NAME   node name in the telemetry (default: hostname)\n");
+    printf("  --cluster ROLE          replicate the scene across nodes: authority or follower\n");
+    printf("  --cluster-group G:P     multicast group the scene is replicated on (default: 239.255.42.1:7100)\n");
+    printf("  --cluster-canvas WxH    whole cluster canvas; this node's outputs are regions of it\n");
     printf("  -O, --osc PORT         enable OSC remote control on specified port (default: 7000)\n");
+    printf("  --local-control SOCKET  also take commands from local controllers over shared memory\n");
     printf("  -R, --remote            enable text-based remote control (stdin/stdout)\n");
     printf("  -Q, --mq                enable message queue remote control\n");
     printf("  -s, --fullscreen        start in fullscreen mode\n");
     printf("  -a, --ontop             start window on top\n");
-    printf("  --hw-decode MODE      select hardware decoder: auto (default), software, vaapi, cuda\n");
+    printf("  --hw-decode MODE      select hardware decoder: auto (default), software, vaapi, cuda, vulkan\n");
+    printf("  --frame-pool-mb MB    per-layer decode-ahead frame pool budget (default: 128)\n");
+    printf("  --decode-ahead-mb MB  decode-ahead memory shared by all layers, by priority (default: 0 = off)\n");
+    printf("  --decode-threads N    software decoder threads shared by all layers (default: 0 = one per core)\n");
+    printf("  --decoder-pool N      opened decoders kept for reloads of the same format (default: 2, 0 = off)\n");
+    printf("  --decode-slots N      software frame decodes at once, nearest deadline first (default: 0 = half the cores)\n");
+    printf("  --hw-decode-slots N   hardware frame decodes at once (default: 0 = 2)\n");
+    printf("  --intra-decoders N    parallel decoders per ProRes/DNxHR/MJPEG layer (default: 0 = its thread share, 1 = off)\n");
+    printf("  --reverse-cache-mb MB per-layer reverse playback frame ring budget (default: 256)\n");
+    printf("  --index-cache-dir DIR store frame indexes in DIR (default: ~/.cache/cuems-videocomposer/index)\n");
+    printf("  --no-index-cache      always rebuild frame indexes on open\n");
+    printf("  --tiled-image-threshold N  tile stills wider or taller than N pixels (default: 8192, 0 = never)\n");
+    printf("  --tiled-image-vram-mb N    tile atlas per tiled still layer (default: 256)\n");
+    printf("  --tile-cache-dir DIR  store still image tiles in DIR (default: ~/.cache/cuems-videocomposer/tiles)\n");
+    printf("  --shader-cache-dir DIR store GL program binaries in DIR (default: ~/.cache/cuems-videocomposer/shaders)\n");
+    printf("  --no-shader-cache     always compile shaders from source\n");
+    printf("  --background-index    index files in the background and start playback immediately\n");
+    printf("  --layer-threads N     worker threads for software layer decode (default: auto, 0 = serial)\n");
+    printf("  --hap-threads N       threads for HAP chunk decompression, shared by all layers (default: auto)\n");
+    printf("  --thread ROLE=SPEC    scheduling of a thread role: render, midi, ltc, osc, decode, loader,\n");
+    printf("                        hap, io or output; SPEC is policy[:priority][@cpus] (e.g. render=fifo:70@2-3)\n");
+    printf("  --lock-memory         lock the process in RAM (mlockall)\n");
+    printf("  --vulkan-display      composite with Vulkan, straight to the displays (VK_KHR_display, no GL)\n");
+    printf("  --upload-thread       upload CPU frames to the GPU on a separate thread (DRM)\n");
+    printf("  --no-gpu-yuv          convert software-decoded YUV to RGB with swscale instead of a shader\n");
+    printf("                        (and receive NDI as BGRA instead of UYVY, V4L2 through FFmpeg)\n");
+    printf("  --no-layer-batching   draw every layer with its own draw call\n");
+    printf("  --display-lag MS      display latency after scanout, added when picking frames (default: 0)\n");
+    printf("  --no-vsync-target     pick frames for the render time instead of the predicted vsync\n");
+    printf("  --late-latch          re-read commands and sync just before the render, taking newer decoded frames\n");
+    printf("  --match-refresh       switch outputs to a multiple of the show framerate (e.g. 50 Hz for 25 fps)\n");
+    printf("  --vrr                 variable refresh (VRR/FreeSync) at the content rate for single-framerate shows\n");
+    printf("  --no-idle-power-save  keep compositing every vsync while nothing is on screen\n");
+    printf("  --record DEST         record the program output with the VAAPI encoder (file, or srt:// / udp:// URL)\n");
+    printf("  --record-codec CODEC  h264 or hevc (default: h264)\n");
+    printf("  --record-bitrate KBPS recording bitrate (default: from the canvas size)\n");
+    printf("  --preview URL         stream a low-rate multiview of the program and every layer (srt:// / udp://)\n");
+    printf("  --preview-size WxH    multiview size (default: 640x360)\n");
+    printf("  --preview-fps FPS     multiview rate (default: 5)\n");
+    printf("  --preview-budget MS   GPU time per multiview before its rate drops (default: 1.0)\n");
+    printf("  --render FILE         render the show offline, faster than realtime, into a .mov file and exit\n");
+    printf("  --render-start TC     first frame of the render (frames or HH:MM:SS:FF, default: 0)\n");
+    printf("  --render-frames N     frames to render (default: until the longest layer ends)\n");
+    printf("  --render-fps FPS      render framerate (default: 25)\n");
+    printf("  --render-codec CODEC  prores, hap, hap_alpha or hap_q (default: prores)\n");
+    printf("  --render-size WxH     render size (default: 1920x1080)\n");
+    printf("  --capture-readback-depth N  readbacks in flight for the virtual outputs, 1-8 (default: 3)\n");
+    printf("  --shm-output SOCKET   publish the program output in a shared-memory ring for local readers\n");
+    printf("  --shm-format FMT      rgba, bgra, uyvy, nv12 or i420 (default: rgba)\n");
+    printf("  --shm-dmabuf          also hand the ring slots out as dmabufs\n");
+    printf("  --v4l2-buffers N      V4L2 capture queue depth (default: 5)\n");
+    printf("  --v4l2-format FMT     V4L2 capture format: auto, nv12, uyvy or yuyv (default: auto)\n");
+    printf("  --stream-latency MS   network stream jitter buffer target, 0 = none (default: 100)\n");
+    printf("  --no-stream-low-latency  open network streams with FFmpeg's default buffering\n");
+    printf("  --sequence-fps FPS    framerate of image sequences (default: 25)\n");
+    printf("  --sequence-threads N  image sequence decode threads, -1 = auto (default: -1)\n");
+    printf("  --sequence-read-ahead N  image sequence frames decoded ahead (default: 12)\n");
+    printf("  --sequence-cache MB   image sequence frame memory per layer (default: 512)\n");
+    printf("  --loader-threads N    cue load worker threads, -1 = auto (default: -1)\n");
+    printf("  --read-ahead MODE     chunked async file reads: auto (network filesystems), on, off (default: auto)\n");
+    printf("  --read-ahead-mb MB    read-ahead window per file (default: 16)\n");
+    printf("  --preload-budget MB   RAM for clips of preloaded layers (default: 2048)\n");
+    printf("  --vram-budget MB      video memory for all layers and caches (default: 0 = 90%% of the GPU's)\n");
+    printf("  --ram-budget MB       RAM for frame pools, preloaded clips and prefetch (default: 0 = no limit)\n");
+    printf("  --no-page-cache-policy  leave the page cache to the kernel\n");
+    printf("  --direct-io-mbps N    O_DIRECT reads for files of at least N Mbit/s (default: 0 = off)\n");
+    printf("  --no-proxy            always play full-resolution files, never their .proxy copies\n");
+    printf("  --keyframe-only-step N fast forward decodes keyframes only from N frames per update (default: 8, 0 = never)\n");
+    printf("  --deinterlace MODE    interlaced sources: auto, off, bob, adaptive (default: auto)\n");
+    printf("  --no-governor         never degrade layers under load (proxies, half rate)\n");
+    printf("  --admission MODE      loads predicted over capacity: off, warn, reject, degrade (default: warn)\n");
+    printf("  --admission-costs F   per-machine costs from benchmark output (bench_decode/bench_composite)\n");
+    printf("  --governor-report H:P send load governor and admission decisions to H:P over OSC\n");
+    printf("  --event-report H:P    send layer events (asynchronous seek done) to H:P over OSC\n");
+    printf("  --no-trace            don't record the frame timeline (see /videocomposer/trace/dump)\n");
+    printf("  --no-flight-recorder  don't snapshot the timeline on missed vblanks and underruns\n");
+    printf("  --flight-recorder-dir D  write flight recorder snapshots to D\n");
+    printf("  --capture-control F   record the MTC and OSC traffic, timestamped, to F\n");
+    printf("  --replay-control F    play F back as the MTC source and the OSC commands\n");
+    printf("  --replay-fast         replay a recorded frame per render instead of with its timing\n");
+    printf("  --no-gpu-timers       don't time layers and passes on the GPU (see /videocomposer/stats/gpu)\n");
+    printf("  --dynamic-resolution [MIN]  composite the canvas down to MIN (default 0.5) of its size under GPU load\n");
+    printf("  --render-nodes LIST   spread hardware decoders over GPUs: auto, off or renderD* paths (default: auto)\n");
+    printf("  --primary-render-node P  render node of the compositing GPU (default: first decode node)\n");
+    printf("  --hw-caps-cache FILE  keep probed hardware decode capabilities in FILE\n");
+    printf("  --resume              reload the cues of the show journal (restart after a crash)\n");
+    printf("  --show-journal FILE   show journal file (default: ~/.cache/cuems-videocomposer/show.journal)\n");
+    printf("  --no-show-journal     don't record the show state\n");
     printf("  -r, --resolution MODE set display resolution mode:\n");
     printf("                         native  - use panel's true pixels (EDID preferred)\n");
     printf("                         maximum - use highest available resolution\n");
@@ -249,6 +868,12 @@ void ConfigurationManager::printUsage() const {
     printf("                         4k      - force 3840x2160\n");
 #ifdef HAVE_NDI_SDK
     printf("  --discover-ndi [SEC]  discover and list available NDI sources (optional timeout in seconds)\n");
+    printf("  --decklink-output CARD  play the program out of a DeckLink card (index, name or auto), UYVY scheduled\n");
+    printf("  --decklink-mode MODE  DeckLink video mode (e.g. 1080p25; default from canvas size and rate)\n");
+    printf("  --decklink-clock      follow the DeckLink output clock (genlock) instead of the display's vblank\n");
+    printf("  --no-ndi-adaptive-bandwidth  always receive the full NDI stream, even for small layers\n");
+    printf("  --no-ndi-discovery    start the NDI source directory at the first NDI cue, not at startup\n");
+    printf("  --ndi-output NAME     send the program output as an NDI source (UYVY, converted on the GPU)\n");
 #endif
     printf("\n");
     printf("MIDI Sync:\n");
@@ -0,0 +1,83 @@
+#include "AdvancedBlend.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+AdvancedBlend::Path AdvancedBlend::choosePath(const Capabilities& caps) {
+    // Coherent equations and fetch are both free; barriers are not
+    if (caps.blendEquation && caps.coherent) {
+        return Path::BLEND_EQUATION;
+    }
+    if (caps.framebufferFetch) {
+        return Path::FRAMEBUFFER_FETCH;
+    }
+    if (caps.blendEquation) {
+        return Path::BLEND_EQUATION;
+    }
+    return Path::COPY_BOUNDS;
+}
+
+const char* AdvancedBlend::pathName(Path path) {
+    switch (path) {
+        case Path::BLEND_EQUATION:
+            return "blend equations";
+        case Path::FRAMEBUFFER_FETCH:
+            return "framebuffer fetch";
+        case Path::COPY_BOUNDS:
+            return "bounding box copy";
+    }
+    return "unknown";
+}
+
+bool AdvancedBlend::layerBounds(const float* mvp, const float* homography, const Region& viewport, Region& bounds) {
+    if (viewport.width <= 0 || viewport.height <= 0) {
+        return false;
+    }
+    const float quad[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    float x0 = 0.0f;
+    float y0 = 0.0f;
+    float x1 = 0.0f;
+    float y1 = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        float pos[4] = {quad[i][0], quad[i][1], 0.0f, 1.0f};
+        if (homography) {
+            float warped[4];
+            for (int row = 0; row < 4; ++row) {
+                warped[row] = homography[row] * pos[0] + homography[4 + row] * pos[1] + homography[12 + row] * pos[3];
+            }
+            std::copy(warped, warped + 4, pos);
+        }
+        float clip[4];
+        for (int row = 0; row < 4; ++row) {
+            clip[row] = mvp[row] * pos[0] + mvp[4 + row] * pos[1] + mvp[8 + row] * pos[2] + mvp[12 + row] * pos[3];
+        }
+        if (clip[3] <= 1e-6f) {
+            // Reaches behind the view: no finite bounds, take the viewport
+            bounds = viewport;
+            return true;
+        }
+        float x = viewport.x + (clip[0] / clip[3] + 1.0f) * 0.5f * viewport.width;
+        float y = viewport.y + (clip[1] / clip[3] + 1.0f) * 0.5f * viewport.height;
+        x0 = i == 0 ? x : std::min(x0, x);
+        x1 = i == 0 ? x : std::max(x1, x);
+        y0 = i == 0 ? y : std::min(y0, y);
+        y1 = i == 0 ? y : std::max(y1, y);
+    }
+
+    // A pixel of margin: edge fragments sample under their whole footprint
+    float left = std::max(std::floor(x0) - 1.0f, static_cast<float>(viewport.x));
+    float bottom = std::max(std::floor(y0) - 1.0f, static_cast<float>(viewport.y));
+    float right = std::min(std::ceil(x1) + 1.0f, static_cast<float>(viewport.x + viewport.width));
+    float top = std::min(std::ceil(y1) + 1.0f, static_cast<float>(viewport.y + viewport.height));
+    if (right <= left || top <= bottom) {
+        return false;
+    }
+    bounds.x = static_cast<int>(left);
+    bounds.y = static_cast<int>(bottom);
+    bounds.width = static_cast<int>(right - left);
+    bounds.height = static_cast<int>(top - bottom);
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,66 @@
+#ifndef VIDEOCOMPOSER_ADVANCEDBLEND_H
+#define VIDEOCOMPOSER_ADVANCEDBLEND_H
+
+#include "../layer/LayerProperties.h"
+
+namespace videocomposer {
+
+/**
+ * AdvancedBlend - How layers with blend modes that read the destination draw
+ *
+ * Multiply, screen and overlay of a straight-alpha layer are not expressible
+ * with glBlendFunc. In order of preference the renderer uses:
+ *   BLEND_EQUATION     - KHR_blend_equation_advanced (one draw; a blend
+ *                        barrier per layer where it is not coherent)
+ *   FRAMEBUFFER_FETCH  - EXT_shader_framebuffer_fetch (one draw, the shader
+ *                        reads the pixel under it)
+ *   COPY_BOUNDS        - the layer's screen bounding box only is copied to a
+ *                        scratch texture, which the shader blends against
+ * so such a layer costs about as much as a normal one rather than a copy
+ * of the whole canvas.
+ */
+class AdvancedBlend {
+public:
+    enum class Path {
+        BLEND_EQUATION,
+        FRAMEBUFFER_FETCH,
+        COPY_BOUNDS
+    };
+
+    struct Capabilities {
+        bool blendEquation = false;     // GL_KHR_blend_equation_advanced
+        bool coherent = false;          // GL_KHR_blend_equation_advanced_coherent
+        bool framebufferFetch = false;  // GL_EXT_shader_framebuffer_fetch
+    };
+
+    /** Window-space pixel rectangle */
+    struct Region {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    /** Texture unit of the COPY_BOUNDS destination (after the LUT) */
+    static constexpr int DESTINATION_TEXTURE_UNIT = 4;
+
+    static Path choosePath(const Capabilities& caps);
+    static const char* pathName(Path path);
+
+    /** Modes that need the destination (all but NORMAL) */
+    static bool readsDestination(LayerProperties::BlendMode mode) {
+        return mode != LayerProperties::NORMAL;
+    }
+
+    /**
+     * Screen bounds of the layer quad (-1..1, through the optional column-
+     * major homography and then the MVP) in a viewport, padded by a pixel
+     * for filtering and clipped to the viewport
+     * @return false if nothing of the layer is inside
+     */
+    static bool layerBounds(const float* mvp, const float* homography, const Region& viewport, Region& bounds);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_ADVANCEDBLEND_H
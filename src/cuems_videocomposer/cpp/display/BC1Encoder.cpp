@@ -0,0 +1,241 @@
+/**
+ * BC1Encoder.cpp - Real-time BC1 (DXT1) texture compression in a shader
+ */
+
+#include "BC1Encoder.h"
+#include "../video/GPUTextureFrameBuffer.h"
+#include "../utils/Logger.h"
+
+namespace videocomposer {
+
+namespace {
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer
+const char* BC1_VERTEX_SHADER = R"(
+#version 330 core
+
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// One fragment = one 4x4 block: endpoints (c0 > c1, four-colour mode)
+// in x, 2-bit palette indices of the 16 texels (row by row) in y
+const char* BC1_FRAGMENT_SHADER = R"(
+#version 330 core
+
+uniform sampler2D uSourceTex;
+
+out uvec2 fragBlock;
+
+uint pack565(vec3 c) {
+    uvec3 q = uvec3(clamp(c, 0.0, 1.0) * vec3(31.0, 63.0, 31.0) + 0.5);
+    return (q.r << 11) | (q.g << 5) | q.b;
+}
+
+vec3 unpack565(uint c) {
+    return vec3(float((c >> 11) & 31u) / 31.0, float((c >> 5) & 63u) / 63.0, float(c & 31u) / 31.0);
+}
+
+void main() {
+    ivec2 origin = ivec2(gl_FragCoord.xy) * 4;
+    vec3 texels[16];
+    vec3 lo = vec3(1.0);
+    vec3 hi = vec3(0.0);
+    for (int i = 0; i < 16; ++i) {
+        texels[i] = texelFetch(uSourceTex, origin + ivec2(i & 3, i >> 2), 0).rgb;
+        lo = min(lo, texels[i]);
+        hi = max(hi, texels[i]);
+    }
+    // The box diagonal the colours lie along: red and green flipped
+    // where they fall as blue rises
+    vec3 center = (lo + hi) * 0.5;
+    vec2 covariance = vec2(0.0);
+    for (int i = 0; i < 16; ++i) {
+        vec3 d = texels[i] - center;
+        covariance += d.rg * d.b;
+    }
+    if (covariance.x < 0.0) {
+        float r = hi.r;
+        hi.r = lo.r;
+        lo.r = r;
+    }
+    if (covariance.y < 0.0) {
+        float g = hi.g;
+        hi.g = lo.g;
+        lo.g = g;
+    }
+    // Endpoints a little inside the box: the extremes are rarely hit
+    vec3 inset = (hi - lo) / 16.0;
+    uint c0 = pack565(hi - inset);
+    uint c1 = pack565(lo + inset);
+    if (c0 < c1) {
+        uint c = c0;
+        c0 = c1;
+        c1 = c;
+    }
+    if (c0 == c1) {
+        // Flat block: equal endpoints would select the three-colour mode
+        fragBlock = uvec2(c0 | (c0 << 16), 0u);
+        return;
+    }
+    vec3 e0 = unpack565(c0);
+    vec3 axis = unpack565(c1) - e0;
+    float scale = 3.0 / max(dot(axis, axis), 1e-8);
+    // Steps along the axis to palette indices: c0, 2/3 c0, 1/3 c0, c1
+    const uint codes[4] = uint[4](0u, 2u, 3u, 1u);
+    uint indices = 0u;
+    for (int i = 0; i < 16; ++i) {
+        int step = int(clamp(dot(texels[i] - e0, axis) * scale, 0.0, 3.0) + 0.5);
+        indices |= codes[step] << uint(2 * i);
+    }
+    fragBlock = uvec2(c0 | (c1 << 16), indices);
+}
+)";
+
+} // namespace
+
+BC1Encoder::~BC1Encoder() {
+    cleanup();
+}
+
+bool BC1Encoder::isSupported() {
+    return (GLEW_VERSION_4_3 || GLEW_ARB_copy_image) &&
+           GPUTextureFrameBuffer::isCompressedFormatSupported(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+}
+
+bool BC1Encoder::init() {
+    cleanup();
+    shader_ = std::make_unique<ShaderProgram>();
+    if (!shader_->createFromSource(BC1_VERTEX_SHADER, BC1_FRAGMENT_SHADER)) {
+        LOG_ERROR << "BC1Encoder: Failed to compile the encoder shader";
+        shader_.reset();
+        return false;
+    }
+    glGenVertexArrays(1, &vao_);
+    glGenFramebuffers(1, &fbo_);
+    return true;
+}
+
+void BC1Encoder::cleanup() {
+    if (vao_ != 0) {
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (blocks_ != 0) {
+        glDeleteTextures(1, &blocks_);
+        blocks_ = 0;
+    }
+    if (pixels_ != 0) {
+        glDeleteTextures(1, &pixels_);
+        pixels_ = 0;
+    }
+    width_ = 0;
+    height_ = 0;
+    shader_.reset();
+}
+
+bool BC1Encoder::ensureTargets(int width, int height) {
+    if (blocks_ != 0 && width == width_ && height == height_) {
+        return true;
+    }
+    if (blocks_ != 0) {
+        glDeleteTextures(1, &blocks_);
+        blocks_ = 0;
+    }
+    if (pixels_ != 0) {
+        glDeleteTextures(1, &pixels_);
+        pixels_ = 0;
+    }
+    width_ = 0;
+    height_ = 0;
+
+    glGenTextures(1, &blocks_);
+    glBindTexture(GL_TEXTURE_2D, blocks_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width / 4, height / 4, 0,
+                 GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blocks_, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR << "BC1Encoder: FBO incomplete, status=" << status;
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+bool BC1Encoder::encode(GLuint source, int width, int height, GLuint destination) {
+    if (!shader_ || source == 0 || destination == 0 || width <= 0 || height <= 0 ||
+        width % 4 != 0 || height % 4 != 0 || !ensureTargets(width, height)) {
+        return false;
+    }
+    while (glGetError() != GL_NO_ERROR) {}
+
+    GLint previousFbo = 0;
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width / 4, height / 4);
+    glDisable(GL_BLEND);
+
+    shader_->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    shader_->setUniform("uSourceTex", 0);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    shader_->unbind();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+
+    // A block texel and a BC1 block are both 64 bits: copied as they are
+    glCopyImageSubData(blocks_, GL_TEXTURE_2D, 0, 0, 0, 0,
+                       destination, GL_TEXTURE_2D, 0, 0, 0, 0,
+                       width / 4, height / 4, 1);
+    return glGetError() == GL_NO_ERROR;
+}
+
+bool BC1Encoder::encodePixels(const uint8_t* pixels, int width, int height, GLuint destination) {
+    if (!shader_ || !pixels || !ensureTargets(width, height)) {
+        return false;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    if (pixels_ == 0) {
+        glGenTextures(1, &pixels_);
+        glBindTexture(GL_TEXTURE_2D, pixels_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, pixels_);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return encode(pixels_, width, height, destination);
+}
+
+} // namespace videocomposer
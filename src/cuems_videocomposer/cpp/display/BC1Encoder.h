@@ -0,0 +1,74 @@
+/**
+ * BC1Encoder.h - Real-time BC1 (DXT1) texture compression in a shader
+ *
+ * Part of the GPU loop cache (see LoopFrameCache).
+ */
+
+#ifndef VIDEOCOMPOSER_BC1ENCODER_H
+#define VIDEOCOMPOSER_BC1ENCODER_H
+
+#include "ShaderProgram.h"
+#include <GL/glew.h>
+#include <cstdint>
+#include <memory>
+
+namespace videocomposer {
+
+/**
+ * BC1Encoder - RGB frames compressed to BC1 on the GPU
+ *
+ * One fragment per 4x4 block: the diagonal of the block's bounding box
+ * its colours follow, inset by 1/16, gives the RGB565 endpoints and
+ * every texel the nearest of the four palette colours. The 64-bit blocks
+ * are rendered into an RG32UI target and copied into the BC1 texture
+ * (glCopyImageSubData treats both as 64-bit texels), so a 1080p frame is
+ * one draw and one copy, and takes an eighth of its RGBA8 memory. Quality is that of a fast encoder: fine
+ * for video, visible on gradients. Alpha is dropped.
+ *
+ * Usage (context current, GL 4.3 or ARB_copy_image):
+ *   encoder.init();
+ *   encoder.encode(rgbaTexture, width, height, bc1Texture);
+ */
+class BC1Encoder {
+public:
+    BC1Encoder() = default;
+    ~BC1Encoder();
+
+    // Disable copy
+    BC1Encoder(const BC1Encoder&) = delete;
+    BC1Encoder& operator=(const BC1Encoder&) = delete;
+
+    /** BC1 textures and texture copies in this context */
+    static bool isSupported();
+
+    bool init();
+    void cleanup();
+    bool isInitialized() const { return shader_ != nullptr; }
+
+    /**
+     * Compress a texture into a BC1 texture of the same size
+     * @param source RGBA texture, top row first
+     * @param width Multiple of 4
+     * @param height Multiple of 4
+     * @param destination GL_COMPRESSED_RGB_S3TC_DXT1_EXT storage of width x height
+     */
+    bool encode(GLuint source, int width, int height, GLuint destination);
+
+    /** Same from BGRA pixels (uploaded into a scratch texture first) */
+    bool encodePixels(const uint8_t* pixels, int width, int height, GLuint destination);
+
+private:
+    bool ensureTargets(int width, int height);
+
+    std::unique_ptr<ShaderProgram> shader_;
+    GLuint vao_ = 0;              // Empty: the triangle comes from gl_VertexID
+    GLuint fbo_ = 0;
+    GLuint blocks_ = 0;           // RG32UI, one texel per block
+    GLuint pixels_ = 0;           // RGBA8 scratch of encodePixels()
+    int width_ = 0;
+    int height_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_BC1ENCODER_H
@@ -0,0 +1,517 @@
+#include "CPUImageKernels.h"
+#include "../layer/LayerUpdateScheduler.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VIDEOCOMPOSER_KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define VIDEOCOMPOSER_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace videocomposer {
+
+namespace {
+
+using Source = CPUImageKernels::Source;
+using Target = CPUImageKernels::Target;
+using AffineMap = CPUImageKernels::AffineMap;
+
+constexpr int TILE_ROWS = 32;                       // Rows per job on the worker pool
+constexpr int BLOCK_ROWS = 16;
+constexpr int BLOCK_COLUMNS = 64;
+constexpr int64_t MIN_PARALLEL_PIXELS = 256 * 256;  // Smaller outputs stay on the calling thread
+constexpr int64_t HALF = 1 << 15;                   // 0.5 in 16.16
+
+int64_t toFixed(double value) {
+    return static_cast<int64_t>(std::llround(value * 65536.0));
+}
+
+// Source position of the first pixel of a row and its step along the row (16.16)
+struct RowStepper {
+    int64_t x, y;
+    int64_t stepX, stepY;
+};
+
+RowStepper rowStart(const AffineMap& map, int row) {
+    RowStepper stepper;
+    stepper.x = toFixed(map.x0 + map.dxy * row);
+    stepper.y = toFixed(map.y0 + map.dyy * row);
+    stepper.stepX = toFixed(map.dxx);
+    stepper.stepY = toFixed(map.dyx);
+    return stepper;
+}
+
+// Bilinear tap: top-left of the 2x2 block and 8-bit weights of its right
+// column and bottom row (256 = all of it: clamped at the last row/column)
+struct Tap {
+    const uint8_t* top;
+    uint32_t fx, fy;
+};
+
+inline bool makeTap(const Source& source, int64_t sx, int64_t sy, Tap& tap) {
+    if (sx < -HALF || sy < -HALF ||
+        sx > (static_cast<int64_t>(source.width - 1) << 16) + HALF ||
+        sy > (static_cast<int64_t>(source.height - 1) << 16) + HALF) {
+        return false;
+    }
+    int64_t xi = sx >> 16;
+    int64_t yi = sy >> 16;
+    uint32_t fx = (static_cast<uint32_t>(sx) >> 8) & 0xFF;
+    uint32_t fy = (static_cast<uint32_t>(sy) >> 8) & 0xFF;
+    if (xi < 0) {
+        xi = 0;
+        fx = 0;
+    } else if (xi >= source.width - 1) {
+        xi = source.width - 2;
+        fx = 256;
+    }
+    if (yi < 0) {
+        yi = 0;
+        fy = 0;
+    } else if (yi >= source.height - 1) {
+        yi = source.height - 2;
+        fy = 256;
+    }
+    tap.top = source.data + yi * source.stride + xi * 4;
+    tap.fx = fx;
+    tap.fy = fy;
+    return true;
+}
+
+// Rows first, then columns, both rounded: the SIMD versions compute
+// exactly this in 16-bit lanes
+inline void blendScalar(const Tap& tap, int stride, uint8_t* out) {
+    const uint8_t* row0 = tap.top;
+    const uint8_t* row1 = tap.top + stride;
+    const uint32_t wx = 256 - tap.fx;
+    const uint32_t wy = 256 - tap.fy;
+    for (int c = 0; c < 4; ++c) {
+        uint32_t top = (row0[c] * wx + row0[c + 4] * tap.fx + 128) >> 8;
+        uint32_t bottom = (row1[c] * wx + row1[c + 4] * tap.fx + 128) >> 8;
+        out[c] = static_cast<uint8_t>((top * wy + bottom * tap.fy + 128) >> 8);
+    }
+}
+
+int64_t floorDiv(int64_t n, int64_t d) {
+    int64_t q = n / d;
+    return (n % d != 0 && ((n < 0) != (d < 0))) ? q - 1 : q;
+}
+
+// Narrows [first, end) to the x with lo <= start + step * x <= hi
+void clampSpan(int64_t start, int64_t step, int64_t lo, int64_t hi, int& first, int& end) {
+    int64_t lower, upper;
+    if (step == 0) {
+        if (start < lo || start > hi) {
+            first = end;
+        }
+        return;
+    }
+    if (step > 0) {
+        lower = -floorDiv(start - lo, step);
+        upper = floorDiv(hi - start, step);
+    } else {
+        lower = -floorDiv(hi - start, -step);
+        upper = floorDiv(start - lo, -step);
+    }
+    first = static_cast<int>(std::max<int64_t>(first, std::min<int64_t>(lower, end)));
+    end = static_cast<int>(std::min<int64_t>(end, std::max<int64_t>(upper + 1, first)));
+}
+
+// Pixels of a row whose 2x2 block lies wholly inside the source: no
+// clamping or bounds checks for them
+void interiorSpan(const Source& source, const RowStepper& row, int from, int to, int& first, int& end) {
+    first = from;
+    end = to;
+    clampSpan(row.x, row.stepX, 0, (static_cast<int64_t>(source.width - 1) << 16) - 1, first, end);
+    clampSpan(row.y, row.stepY, 0, (static_cast<int64_t>(source.height - 1) << 16) - 1, first, end);
+    if (end < first) {
+        end = first;
+    }
+}
+
+inline Tap interiorTap(const Source& source, int64_t sx, int64_t sy) {
+    Tap tap;
+    tap.top = source.data + (sy >> 16) * source.stride + (sx >> 16) * 4;
+    tap.fx = static_cast<uint32_t>(sx >> 8) & 0xFF;
+    tap.fy = static_cast<uint32_t>(sy >> 8) & 0xFF;
+    return tap;
+}
+
+// Pixels [first, end) of a row near or outside the source edges
+void edgeRun(const Source& source, const RowStepper& row, uint8_t* rowOut, int first, int end) {
+    int64_t sx = row.x + first * row.stepX;
+    int64_t sy = row.y + first * row.stepY;
+    uint8_t* out = rowOut + first * 4;
+    for (int x = first; x < end; ++x, out += 4, sx += row.stepX, sy += row.stepY) {
+        Tap tap;
+        if (makeTap(source, sx, sy, tap)) {
+            blendScalar(tap, source.stride, out);
+        } else {
+            std::memset(out, 0, 4);
+        }
+    }
+}
+
+// Output pixels [from, to) of one row
+void segmentScalar(const Source& source, const RowStepper& row, uint8_t* rowOut, int from, int to) {
+    int first, end;
+    interiorSpan(source, row, from, to, first, end);
+    edgeRun(source, row, rowOut, from, first);
+    int64_t sx = row.x + first * row.stepX;
+    int64_t sy = row.y + first * row.stepY;
+    for (int x = first; x < end; ++x, sx += row.stepX, sy += row.stepY) {
+        blendScalar(interiorTap(source, sx, sy), source.stride, rowOut + x * 4);
+    }
+    edgeRun(source, row, rowOut, end, to);
+}
+
+#ifdef VIDEOCOMPOSER_KERNELS_X86
+
+constexpr int64_t LANES4 = 0x0001000100010001LL;  // A 16-bit weight in 4 lanes
+
+__attribute__((target("sse4.1")))
+inline void blendSse41(const Tap& tap, int stride, uint8_t* out) {
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i top = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(tap.top)));
+    __m128i bottom = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(tap.top + stride)));
+    const __m128i wx = _mm_set_epi64x(tap.fx * LANES4, (256 - tap.fx) * LANES4);
+    top = _mm_mullo_epi16(top, wx);
+    bottom = _mm_mullo_epi16(bottom, wx);
+    top = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), round), 8);
+    bottom = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(bottom, _mm_srli_si128(bottom, 8)), round), 8);
+
+    const __m128i wy = _mm_set_epi64x(tap.fy * LANES4, (256 - tap.fy) * LANES4);
+    __m128i column = _mm_mullo_epi16(_mm_unpacklo_epi64(top, bottom), wy);
+    column = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(column, _mm_srli_si128(column, 8)), round), 8);
+    int32_t pixel = _mm_cvtsi128_si32(_mm_packus_epi16(column, column));
+    std::memcpy(out, &pixel, 4);
+}
+
+// Two pixels per call, one per 128-bit lane
+__attribute__((target("avx2")))
+inline void blendPairAvx2(const Tap& a, const Tap& b, int stride, uint8_t* out) {
+    const __m256i round = _mm256_set1_epi16(128);
+    __m256i top = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a.top)),
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b.top))));
+    __m256i bottom = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a.top + stride)),
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b.top + stride))));
+    const __m256i wx = _mm256_setr_epi64x((256 - a.fx) * LANES4, a.fx * LANES4,
+                                          (256 - b.fx) * LANES4, b.fx * LANES4);
+    top = _mm256_mullo_epi16(top, wx);
+    bottom = _mm256_mullo_epi16(bottom, wx);
+    top = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(top, _mm256_srli_si256(top, 8)), round), 8);
+    bottom = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(bottom, _mm256_srli_si256(bottom, 8)), round), 8);
+
+    const __m256i wy = _mm256_setr_epi64x((256 - a.fy) * LANES4, a.fy * LANES4,
+                                          (256 - b.fy) * LANES4, b.fy * LANES4);
+    __m256i column = _mm256_mullo_epi16(_mm256_unpacklo_epi64(top, bottom), wy);
+    column = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(column, _mm256_srli_si256(column, 8)), round), 8);
+    __m256i packed = _mm256_packus_epi16(column, column);
+    int32_t pixelA = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+    int32_t pixelB = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+    std::memcpy(out, &pixelA, 4);
+    std::memcpy(out + 4, &pixelB, 4);
+}
+
+__attribute__((target("sse4.1")))
+void segmentSse41(const Source& source, const RowStepper& row, uint8_t* rowOut, int from, int to) {
+    int first, end;
+    interiorSpan(source, row, from, to, first, end);
+    edgeRun(source, row, rowOut, from, first);
+    int64_t sx = row.x + first * row.stepX;
+    int64_t sy = row.y + first * row.stepY;
+    for (int x = first; x < end; ++x, sx += row.stepX, sy += row.stepY) {
+        blendSse41(interiorTap(source, sx, sy), source.stride, rowOut + x * 4);
+    }
+    edgeRun(source, row, rowOut, end, to);
+}
+
+__attribute__((target("avx2")))
+void segmentAvx2(const Source& source, const RowStepper& row, uint8_t* rowOut, int from, int to) {
+    int first, end;
+    interiorSpan(source, row, from, to, first, end);
+    edgeRun(source, row, rowOut, from, first);
+    int64_t sx = row.x + first * row.stepX;
+    int64_t sy = row.y + first * row.stepY;
+    int x = first;
+    for (; x + 1 < end; x += 2, sx += 2 * row.stepX, sy += 2 * row.stepY) {
+        blendPairAvx2(interiorTap(source, sx, sy),
+                      interiorTap(source, sx + row.stepX, sy + row.stepY),
+                      source.stride, rowOut + x * 4);
+    }
+    if (x < end) {
+        blendSse41(interiorTap(source, sx, sy), source.stride, rowOut + x * 4);
+    }
+    edgeRun(source, row, rowOut, end, to);
+}
+
+#endif // VIDEOCOMPOSER_KERNELS_X86
+
+#ifdef VIDEOCOMPOSER_KERNELS_NEON
+
+inline void blendNeon(const Tap& tap, int stride, uint8_t* out) {
+    const uint16x8_t wx = vcombine_u16(vdup_n_u16(static_cast<uint16_t>(256 - tap.fx)),
+                                       vdup_n_u16(static_cast<uint16_t>(tap.fx)));
+    uint16x8_t top = vmulq_u16(vmovl_u8(vld1_u8(tap.top)), wx);
+    uint16x8_t bottom = vmulq_u16(vmovl_u8(vld1_u8(tap.top + stride)), wx);
+    uint16x4_t top4 = vrshr_n_u16(vadd_u16(vget_low_u16(top), vget_high_u16(top)), 8);
+    uint16x4_t bottom4 = vrshr_n_u16(vadd_u16(vget_low_u16(bottom), vget_high_u16(bottom)), 8);
+
+    const uint16x8_t wy = vcombine_u16(vdup_n_u16(static_cast<uint16_t>(256 - tap.fy)),
+                                       vdup_n_u16(static_cast<uint16_t>(tap.fy)));
+    uint16x8_t column = vmulq_u16(vcombine_u16(top4, bottom4), wy);
+    uint16x4_t result = vrshr_n_u16(vadd_u16(vget_low_u16(column), vget_high_u16(column)), 8);
+    uint32_t pixel = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(result, result))), 0);
+    std::memcpy(out, &pixel, 4);
+}
+
+void segmentNeon(const Source& source, const RowStepper& row, uint8_t* rowOut, int from, int to) {
+    int first, end;
+    interiorSpan(source, row, from, to, first, end);
+    edgeRun(source, row, rowOut, from, first);
+    int64_t sx = row.x + first * row.stepX;
+    int64_t sy = row.y + first * row.stepY;
+    for (int x = first; x < end; ++x, sx += row.stepX, sy += row.stepY) {
+        blendNeon(interiorTap(source, sx, sy), source.stride, rowOut + x * 4);
+    }
+    edgeRun(source, row, rowOut, end, to);
+}
+
+#endif // VIDEOCOMPOSER_KERNELS_NEON
+
+using Segment = void (*)(const Source&, const RowStepper&, uint8_t*, int, int);
+
+// Rotated maps walk the source diagonally: blocks of BLOCK_ROWS x
+// BLOCK_COLUMNS output pixels keep the source rows they read in cache
+void runSegments(const Source& source, const Target& target, const AffineMap& map,
+                 int firstRow, int endRow, Segment segment) {
+    const bool rotated = map.dxy != 0.0 || map.dyx != 0.0;
+    const int blockColumns = rotated ? BLOCK_COLUMNS : target.width;
+    for (int band = firstRow; band < endRow; band += BLOCK_ROWS) {
+        const int bandEnd = std::min(band + BLOCK_ROWS, endRow);
+        for (int from = 0; from < target.width; from += blockColumns) {
+            const int to = std::min(from + blockColumns, target.width);
+            for (int y = band; y < bandEnd; ++y) {
+                segment(source, rowStart(map, y), target.data + static_cast<size_t>(y) * target.stride, from, to);
+            }
+        }
+    }
+}
+
+CPUImageKernels::Isa detectIsa() {
+#ifdef VIDEOCOMPOSER_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return CPUImageKernels::Isa::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return CPUImageKernels::Isa::SSE41;
+    }
+#elif defined(VIDEOCOMPOSER_KERNELS_NEON)
+    return CPUImageKernels::Isa::NEON;
+#endif
+    return CPUImageKernels::Isa::Scalar;
+}
+
+// Bands of one caller at a time; a second caller meanwhile works alone
+std::mutex poolMutex;
+
+LayerUpdateScheduler& kernelPool() {
+    static LayerUpdateScheduler pool(LayerUpdateScheduler::defaultWorkerCount(), "image kernels");
+    return pool;
+}
+
+} // namespace
+
+CPUImageKernels::AffineMap CPUImageKernels::scaleRotate(int srcWidth, int srcHeight, double scaleX,
+                                                        double scaleY, double degrees,
+                                                        int& outWidth, int& outHeight) {
+    // Quarter turns exact, so they sample pixel centres
+    double turn = std::fmod(degrees, 360.0);
+    if (turn < 0.0) {
+        turn += 360.0;
+    }
+    double c, s;
+    if (std::fmod(turn, 90.0) == 0.0) {
+        static const double COS[4] = {1.0, 0.0, -1.0, 0.0};
+        static const double SIN[4] = {0.0, 1.0, 0.0, -1.0};
+        int quarter = static_cast<int>(turn / 90.0) % 4;
+        c = COS[quarter];
+        s = SIN[quarter];
+    } else {
+        double radians = turn * M_PI / 180.0;
+        c = std::cos(radians);
+        s = std::sin(radians);
+    }
+
+    double scaledWidth = srcWidth * std::fabs(scaleX);
+    double scaledHeight = srcHeight * std::fabs(scaleY);
+    outWidth = std::max(1, static_cast<int>(std::lround(std::fabs(scaledWidth * c) + std::fabs(scaledHeight * s))));
+    outHeight = std::max(1, static_cast<int>(std::lround(std::fabs(scaledWidth * s) + std::fabs(scaledHeight * c))));
+
+    // Output pixel centre relative to the output centre (p, q), rotated
+    // back and unscaled: u = (p cos - q sin) / sx, v = (p sin + q cos) / sy
+    // (y down, so a positive angle turns counter-clockwise on screen)
+    double invX = scaleX != 0.0 ? 1.0 / scaleX : 0.0;
+    double invY = scaleY != 0.0 ? 1.0 / scaleY : 0.0;
+    AffineMap map;
+    map.dxx = c * invX;
+    map.dxy = -s * invX;
+    map.dyx = s * invY;
+    map.dyy = c * invY;
+    double p0 = 0.5 - outWidth / 2.0;
+    double q0 = 0.5 - outHeight / 2.0;
+    map.x0 = map.dxx * p0 + map.dxy * q0 + srcWidth / 2.0 - 0.5;
+    map.y0 = map.dyx * p0 + map.dyy * q0 + srcHeight / 2.0 - 0.5;
+    return map;
+}
+
+void CPUImageKernels::bilinearRows(const Source& source, const Target& target, const AffineMap& map,
+                                   int firstRow, int endRow, Isa isa) {
+    if (source.width < 2 || source.height < 2) {
+        nearestRows(source, target, map, 4, firstRow, endRow);
+        return;
+    }
+    switch (isSupported(isa) ? isa : Isa::Scalar) {
+#ifdef VIDEOCOMPOSER_KERNELS_X86
+        case Isa::AVX2:
+            runSegments(source, target, map, firstRow, endRow, segmentAvx2);
+            return;
+        case Isa::SSE41:
+            runSegments(source, target, map, firstRow, endRow, segmentSse41);
+            return;
+#endif
+#ifdef VIDEOCOMPOSER_KERNELS_NEON
+        case Isa::NEON:
+            runSegments(source, target, map, firstRow, endRow, segmentNeon);
+            return;
+#endif
+        default:
+            runSegments(source, target, map, firstRow, endRow, segmentScalar);
+            return;
+    }
+}
+
+void CPUImageKernels::nearestRows(const Source& source, const Target& target, const AffineMap& map,
+                                  int bytesPerPixel, int firstRow, int endRow) {
+    const int64_t maxX = (static_cast<int64_t>(source.width - 1) << 16) + HALF;
+    const int64_t maxY = (static_cast<int64_t>(source.height - 1) << 16) + HALF;
+    for (int y = firstRow; y < endRow; ++y) {
+        RowStepper row = rowStart(map, y);
+        uint8_t* out = target.data + static_cast<size_t>(y) * target.stride;
+        for (int x = 0; x < target.width; ++x, out += bytesPerPixel, row.x += row.stepX, row.y += row.stepY) {
+            if (row.x < -HALF || row.y < -HALF || row.x > maxX || row.y > maxY) {
+                std::memset(out, 0, bytesPerPixel);
+                continue;
+            }
+            int64_t xi = std::min<int64_t>(std::max<int64_t>((row.x + HALF) >> 16, 0), source.width - 1);
+            int64_t yi = std::min<int64_t>(std::max<int64_t>((row.y + HALF) >> 16, 0), source.height - 1);
+            std::memcpy(out, source.data + yi * source.stride + xi * bytesPerPixel, bytesPerPixel);
+        }
+    }
+}
+
+void CPUImageKernels::transform(const Source& source, const Target& target, const AffineMap& map,
+                                int bytesPerPixel) {
+    if (!source.data || !target.data || source.width <= 0 || source.height <= 0 ||
+        target.width <= 0 || target.height <= 0) {
+        return;
+    }
+    const Isa isa = activeIsa();
+    auto runRows = [&](int firstRow, int endRow) {
+        if (bytesPerPixel == 4) {
+            bilinearRows(source, target, map, firstRow, endRow, isa);
+        } else {
+            nearestRows(source, target, map, bytesPerPixel, firstRow, endRow);
+        }
+    };
+
+    const int tiles = (target.height + TILE_ROWS - 1) / TILE_ROWS;
+    const int64_t pixels = static_cast<int64_t>(target.width) * target.height;
+    if (tiles < 2 || pixels < MIN_PARALLEL_PIXELS || !runBands(target.height, TILE_ROWS, std::ref(runRows))) {
+        runRows(0, target.height);
+    }
+}
+
+bool CPUImageKernels::runBands(int rows, int bandRows, const std::function<void(int, int)>& band) {
+    std::unique_lock<std::mutex> lock(poolMutex, std::defer_lock);
+    if (rows <= 0 || bandRows <= 0 || !lock.try_lock() || kernelPool().getWorkerCount() == 0) {
+        return false;
+    }
+
+    // One job per band; jobs stay small enough for std::function's inline storage
+    struct Band {
+        const std::function<void(int, int)>* run;
+        int first;
+        int end;
+    };
+    static std::vector<std::function<void()>> jobs;  // Under poolMutex
+    jobs.clear();
+    for (int first = 0; first < rows; first += bandRows) {
+        Band slice{&band, first, std::min(first + bandRows, rows)};
+        jobs.push_back([slice]() { (*slice.run)(slice.first, slice.end); });
+    }
+    kernelPool().run(jobs, LayerUpdateScheduler::Clock::time_point::max());
+    jobs.clear();
+    return true;
+}
+
+size_t CPUImageKernels::getConcurrency() {
+    return kernelPool().getWorkerCount() + 1;
+}
+
+CPUImageKernels::Isa CPUImageKernels::activeIsa() {
+    static const Isa isa = [] {
+        Isa best = detectIsa();
+        if (const char* env = std::getenv("VIDEOCOMPOSER_CPU_KERNELS")) {
+            std::string requested = env;
+            for (Isa candidate : {Isa::Scalar, Isa::SSE41, Isa::AVX2, Isa::NEON}) {
+                if (requested == isaName(candidate) && isSupported(candidate)) {
+                    best = candidate;
+                }
+            }
+        }
+        LOG_VERBOSE << "CPU image kernels: " << isaName(best);
+        return best;
+    }();
+    return isa;
+}
+
+bool CPUImageKernels::isSupported(Isa isa) {
+    static const Isa detected = detectIsa();
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::SSE41:
+            return detected == Isa::SSE41 || detected == Isa::AVX2;
+        case Isa::AVX2:
+            return detected == Isa::AVX2;
+        case Isa::NEON:
+            return detected == Isa::NEON;
+    }
+    return false;
+}
+
+const char* CPUImageKernels::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE41: return "sse4.1";
+        case Isa::AVX2: return "avx2";
+        case Isa::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+} // namespace videocomposer
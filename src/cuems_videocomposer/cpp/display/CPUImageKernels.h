@@ -0,0 +1,91 @@
+#ifndef VIDEOCOMPOSER_CPUIMAGEKERNELS_H
+#define VIDEOCOMPOSER_CPUIMAGEKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace videocomposer {
+
+/**
+ * CPUImageKernels - Resampling kernels behind CPUImageProcessor
+ *
+ * One affine pass maps every output pixel centre back into a source
+ * window, so crop, scale and rotation cost a single read of the source.
+ * 32-bit pixels are sampled bilinearly in 8-bit fixed point, other
+ * formats nearest. The bilinear inner loop has AVX2, SSE4.1 and NEON
+ * versions chosen at run time; each gives the same bytes as the scalar
+ * one. transform() splits the output into row tiles on a shared pool of
+ * worker threads (the calling thread takes tiles too); runBands() lends
+ * the same pool to other row-parallel work (SliceScaler).
+ *
+ * Output pixels that map outside the source window are zero.
+ */
+class CPUImageKernels {
+public:
+    enum class Isa { Scalar, SSE41, AVX2, NEON };
+
+    struct Source {
+        const uint8_t* data = nullptr;  // Top-left pixel of the window
+        int width = 0;
+        int height = 0;
+        int stride = 0;                 // Bytes per row
+    };
+
+    struct Target {
+        uint8_t* data = nullptr;
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+    };
+
+    // Source position (in pixels, pixel centres at integers) of output
+    // pixel (x, y): sx = x0 + dxx * x + dxy * y, sy = y0 + dyx * x + dyy * y
+    struct AffineMap {
+        double x0 = 0.0, y0 = 0.0;
+        double dxx = 1.0, dxy = 0.0;
+        double dyx = 0.0, dyy = 1.0;
+    };
+
+    /**
+     * Map for a window of srcWidth x srcHeight scaled, then rotated about
+     * its centre (degrees, counter-clockwise on screen as in the renderer)
+     * @param outWidth, outHeight Bounding box of the result
+     */
+    static AffineMap scaleRotate(int srcWidth, int srcHeight, double scaleX, double scaleY,
+                                 double degrees, int& outWidth, int& outHeight);
+
+    /** Whole target, in row tiles across the worker pool */
+    static void transform(const Source& source, const Target& target, const AffineMap& map,
+                          int bytesPerPixel);
+
+    /**
+     * Run band(first, end) over rows [0, rows) in bands of bandRows on the
+     * worker pool (the calling thread takes bands too)
+     * @return false with nothing run when the pool is busy or has no workers
+     */
+    static bool runBands(int rows, int bandRows, const std::function<void(int, int)>& band);
+
+    /** Threads runBands() spreads over, the caller included */
+    static size_t getConcurrency();
+
+    /** Rows [firstRow, endRow): bilinear, 4 bytes per pixel */
+    static void bilinearRows(const Source& source, const Target& target, const AffineMap& map,
+                             int firstRow, int endRow, Isa isa);
+
+    /** Rows [firstRow, endRow): nearest, any pixel size */
+    static void nearestRows(const Source& source, const Target& target, const AffineMap& map,
+                            int bytesPerPixel, int firstRow, int endRow);
+
+    /**
+     * Best kernel set of this CPU; VIDEOCOMPOSER_CPU_KERNELS=scalar|sse4.1|
+     * avx2|neon asks for a lower one
+     */
+    static Isa activeIsa();
+    static bool isSupported(Isa isa);
+    static const char* isaName(Isa isa);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CPUIMAGEKERNELS_H
@@ -1,4 +1,5 @@
 #include "CPUImageProcessor.h"
+#include "CPUImageKernels.h"
 #include "../utils/Logger.h"
 #include "../video/FrameFormat.h"
 #include <cmath>
@@ -22,15 +23,9 @@ bool CPUImageProcessor::processCPU(const FrameBuffer& input, FrameBuffer& output
 
     // Check if we can skip processing
     if (canSkip(properties, false)) {
-        // No modifications needed - just copy
-        if (!output.isValid() || output.info().width != input.info().width || 
-            output.info().height != input.info().height) {
-            if (!output.allocate(input.info())) {
-                return false;
-            }
-        }
-        std::memcpy(output.data(), input.data(), input.size());
-        return true;
+        // No modifications needed - share the input's pixels
+        output = input;
+        return output.isValid();
     }
 
     // Apply CPU-side modifications: crop/panorama only
@@ -55,18 +50,14 @@ bool CPUImageProcessor::processCPU(const FrameBuffer& input, FrameBuffer& output
     // NOTE: Scale and rotation are NOT applied here - they are handled by OpenGL
     // This avoids double-transformation (CPU + GPU) which causes garbled pixels
 
-    // Copy final result to output
-    if (current != &output) {
-        if (!output.isValid() || output.info().width != current->info().width || 
-            output.info().height != current->info().height) {
-            if (!output.allocate(current->info())) {
-                return false;
-            }
-        }
-        std::memcpy(output.data(), current->data(), current->size());
+    // Hand the final result to output
+    if (current == &temp1) {
+        output = std::move(temp1);
+    } else if (current != &output) {
+        output = *current;
     }
 
-    return true;
+    return output.isValid();
 }
 
 bool CPUImageProcessor::processGPU(const GPUTextureFrameBuffer& input, GPUTextureFrameBuffer& output,
@@ -94,70 +85,66 @@ bool CPUImageProcessor::canSkip(const LayerProperties& properties, bool isHAPCod
     return !hasCrop && !hasPanorama;
 }
 
+bool CPUImageProcessor::shownWindow(const LayerProperties& properties, const FrameInfo& frameInfo,
+                                    FrameWindow& window) {
+    window = FrameWindow();
+    if (properties.panoramaMode) {
+        // Panorama mode: 50% width with the pan offset, clamped
+        window.width = frameInfo.width / 2;
+        window.height = frameInfo.height;
+        window.x = std::min(std::max(properties.panOffset, 0), frameInfo.width - window.width);
+    } else if (properties.crop.enabled) {
+        const auto& crop = properties.crop;
+        if (crop.x < 0 || crop.y < 0 ||
+            crop.x + crop.width > frameInfo.width ||
+            crop.y + crop.height > frameInfo.height ||
+            crop.width <= 0 || crop.height <= 0) {
+            return false;
+        }
+        window.x = crop.x;
+        window.y = crop.y;
+        window.width = crop.width;
+        window.height = crop.height;
+    }
+    return !window.isWhole();
+}
+
 bool CPUImageProcessor::applyCrop(const FrameBuffer& input, FrameBuffer& output,
                                   const LayerProperties& properties,
                                   const FrameInfo& frameInfo) {
-    if (!input.isValid() || !properties.crop.enabled) {
-        return false;
-    }
-
-    const auto& crop = properties.crop;
-    
-    // Validate crop rectangle
-    if (crop.x < 0 || crop.y < 0 || 
-        crop.x + crop.width > frameInfo.width ||
-        crop.y + crop.height > frameInfo.height ||
-        crop.width <= 0 || crop.height <= 0) {
-        return false;
-    }
-
-    // Create output frame info
-    FrameInfo outputInfo = frameInfo;
-    outputInfo.width = crop.width;
-    outputInfo.height = crop.height;
-
-    if (!output.allocate(outputInfo)) {
+    FrameWindow window;
+    if (!input.isValid() || !properties.crop.enabled || !shownWindow(properties, frameInfo, window)) {
         return false;
     }
-
-    // Calculate bytes per pixel from format
-    int bytesPerPixel = getBytesPerPixel(frameInfo.format);
-    int inputStride = frameInfo.width * bytesPerPixel;
-    int outputStride = crop.width * bytesPerPixel;
-
-    // Copy cropped region
-    const uint8_t* src = input.data() + (crop.y * inputStride) + (crop.x * bytesPerPixel);
-    uint8_t* dst = output.data();
-
-    for (int y = 0; y < crop.height; ++y) {
-        std::memcpy(dst, src, outputStride);
-        src += inputStride;
-        dst += outputStride;
-    }
-
-    return true;
+    return copyWindow(input, output, window, frameInfo);
 }
 
 bool CPUImageProcessor::applyPanorama(const FrameBuffer& input, FrameBuffer& output,
                                       const LayerProperties& properties,
                                       const FrameInfo& frameInfo) {
-    if (!input.isValid() || !properties.panoramaMode) {
+    FrameWindow window;
+    if (!input.isValid() || !properties.panoramaMode || !shownWindow(properties, frameInfo, window)) {
         return false;
     }
+    return copyWindow(input, output, window, frameInfo);
+}
 
-    // Panorama mode: crop to 50% width with pan offset
-    int cropWidth = frameInfo.width / 2;
-    int maxOffset = frameInfo.width - cropWidth;
-    
-    // Clamp pan offset
-    int panOffset = properties.panOffset;
-    if (panOffset < 0) panOffset = 0;
-    if (panOffset > maxOffset) panOffset = maxOffset;
+bool CPUImageProcessor::copyWindow(const FrameBuffer& input, FrameBuffer& output, const FrameWindow& window,
+                                   const FrameInfo& frameInfo) {
+    // The decoder may have converted only part of the picture (FrameInfo::window)
+    const FrameInfo& inputInfo = input.info();
+    const FrameWindow& held = inputInfo.window;
+    int x = held.isWhole() ? window.x : window.x - held.x;
+    int y = held.isWhole() ? window.y : window.y - held.y;
+    if (x < 0 || y < 0 || x + window.width > inputInfo.width || y + window.height > inputInfo.height) {
+        return false;
+    }
 
     // Create output frame info
     FrameInfo outputInfo = frameInfo;
-    outputInfo.width = cropWidth;
-    outputInfo.height = frameInfo.height;
+    outputInfo.width = window.width;
+    outputInfo.height = window.height;
+    outputInfo.window = FrameWindow();
 
     if (!output.allocate(outputInfo)) {
         return false;
@@ -165,14 +152,14 @@ bool CPUImageProcessor::applyPanorama(const FrameBuffer& input, FrameBuffer& out
 
     // Calculate bytes per pixel from format
     int bytesPerPixel = getBytesPerPixel(frameInfo.format);
-    int inputStride = frameInfo.width * bytesPerPixel;
-    int outputStride = cropWidth * bytesPerPixel;
+    int inputStride = inputInfo.width * bytesPerPixel;
+    int outputStride = window.width * bytesPerPixel;
 
-    // Copy panorama region
-    const uint8_t* src = input.data() + (panOffset * bytesPerPixel);
+    // Copy the window
+    const uint8_t* src = input.data() + (y * inputStride) + (x * bytesPerPixel);
     uint8_t* dst = output.data();
 
-    for (int y = 0; y < frameInfo.height; ++y) {
+    for (int row = 0; row < window.height; ++row) {
         std::memcpy(dst, src, outputStride);
         src += inputStride;
         dst += outputStride;
@@ -181,133 +168,59 @@ bool CPUImageProcessor::applyPanorama(const FrameBuffer& input, FrameBuffer& out
     return true;
 }
 
-bool CPUImageProcessor::applyScale(const FrameBuffer& input, FrameBuffer& output,
+bool CPUImageProcessor::transform(const FrameBuffer& input, FrameBuffer& output,
                                   const LayerProperties& properties,
                                   const FrameInfo& frameInfo) {
     if (!input.isValid()) {
         return false;
     }
 
-    // Calculate output dimensions
-    int outputWidth = static_cast<int>(frameInfo.width * properties.scaleX);
-    int outputHeight = static_cast<int>(frameInfo.height * properties.scaleY);
-
-    if (outputWidth <= 0 || outputHeight <= 0) {
-        return false;
-    }
-
-    // Create output frame info
-    FrameInfo outputInfo = frameInfo;
-    outputInfo.width = outputWidth;
-    outputInfo.height = outputHeight;
-
-    if (!output.allocate(outputInfo)) {
-        return false;
-    }
-
-    // Simple nearest-neighbor scaling for now
-    // TODO: Implement bilinear/bicubic interpolation for better quality
-    int bytesPerPixel = getBytesPerPixel(frameInfo.format);
-    int inputStride = frameInfo.width * bytesPerPixel;
-
-    const uint8_t* src = input.data();
-    uint8_t* dst = output.data();
-
-    for (int y = 0; y < outputHeight; ++y) {
-        int srcY = (y * frameInfo.height) / outputHeight;
-        const uint8_t* srcRow = src + (srcY * inputStride);
-        
-        for (int x = 0; x < outputWidth; ++x) {
-            int srcX = (x * frameInfo.width) / outputWidth;
-            const uint8_t* srcPixel = srcRow + (srcX * bytesPerPixel);
-            
-            std::memcpy(dst, srcPixel, bytesPerPixel);
-            dst += bytesPerPixel;
+    // Source window: panorama half, crop rectangle or the whole frame
+    FrameWindow shown;
+    if (!shownWindow(properties, frameInfo, shown)) {
+        if (properties.crop.enabled && !properties.panoramaMode) {
+            return false;  // Invalid crop
         }
-    }
-
-    return true;
-}
-
-bool CPUImageProcessor::applyRotation(const FrameBuffer& input, FrameBuffer& output,
-                                     const LayerProperties& properties,
-                                     const FrameInfo& frameInfo) {
-    if (!input.isValid()) {
+        shown.width = frameInfo.width;
+        shown.height = frameInfo.height;
+    }
+    // ... of a frame holding all or part of the picture
+    const FrameInfo& inputInfo = input.info();
+    int windowX = inputInfo.window.isWhole() ? shown.x : shown.x - inputInfo.window.x;
+    int windowY = inputInfo.window.isWhole() ? shown.y : shown.y - inputInfo.window.y;
+    int windowWidth = shown.width, windowHeight = shown.height;
+    if (windowWidth <= 0 || windowHeight <= 0 || windowX < 0 || windowY < 0 ||
+        windowX + windowWidth > inputInfo.width || windowY + windowHeight > inputInfo.height) {
         return false;
     }
 
-    // For now, only support 90-degree increments
-    // Normalize rotation to 0-360 range
-    float rotation = std::fmod(properties.rotation, 360.0f);
-    if (rotation < 0) rotation += 360.0f;
-
-    // Round to nearest 90-degree increment
-    int rotation90 = static_cast<int>(std::round(rotation / 90.0f)) % 4;
-
-    if (rotation90 == 0) {
-        // No rotation - just copy
-        if (!output.isValid() || output.info().width != input.info().width || 
-            output.info().height != input.info().height) {
-            if (!output.allocate(input.info())) {
-                return false;
-            }
-        }
-        std::memcpy(output.data(), input.data(), input.size());
-        return true;
-    }
+    int outputWidth = 0, outputHeight = 0;
+    CPUImageKernels::AffineMap map = CPUImageKernels::scaleRotate(
+        windowWidth, windowHeight, properties.scaleX, properties.scaleY, properties.rotation,
+        outputWidth, outputHeight);
 
-    // Calculate output dimensions (swap for 90/270)
-    int outputWidth = (rotation90 == 1 || rotation90 == 3) ? frameInfo.height : frameInfo.width;
-    int outputHeight = (rotation90 == 1 || rotation90 == 3) ? frameInfo.width : frameInfo.height;
-
-    // Create output frame info
     FrameInfo outputInfo = frameInfo;
     outputInfo.width = outputWidth;
     outputInfo.height = outputHeight;
-
-    if (!output.allocate(outputInfo)) {
+    outputInfo.window = FrameWindow();
+    if (!output.ensureAllocated(outputInfo)) {
         return false;
     }
 
-    // Rotate pixel by pixel
     int bytesPerPixel = getBytesPerPixel(frameInfo.format);
-    int inputStride = frameInfo.width * bytesPerPixel;
-    int outputStride = outputWidth * bytesPerPixel;
-
-    const uint8_t* src = input.data();
-    uint8_t* dst = output.data();
-
-    for (int y = 0; y < outputHeight; ++y) {
-        for (int x = 0; x < outputWidth; ++x) {
-            int srcX, srcY;
-            
-            // Calculate source coordinates based on rotation
-            switch (rotation90) {
-                case 1: // 90 degrees clockwise
-                    srcX = y;
-                    srcY = frameInfo.width - 1 - x;
-                    break;
-                case 2: // 180 degrees
-                    srcX = frameInfo.width - 1 - x;
-                    srcY = frameInfo.height - 1 - y;
-                    break;
-                case 3: // 270 degrees clockwise (90 counter-clockwise)
-                    srcX = frameInfo.height - 1 - y;
-                    srcY = x;
-                    break;
-                default:
-                    srcX = x;
-                    srcY = y;
-                    break;
-            }
-
-            const uint8_t* srcPixel = src + (srcY * inputStride) + (srcX * bytesPerPixel);
-            uint8_t* dstPixel = dst + (y * outputStride) + (x * bytesPerPixel);
-            
-            std::memcpy(dstPixel, srcPixel, bytesPerPixel);
-        }
-    }
-
+    CPUImageKernels::Source source;
+    source.stride = inputInfo.width * bytesPerPixel;
+    source.data = input.data() + windowY * source.stride + windowX * bytesPerPixel;
+    source.width = windowWidth;
+    source.height = windowHeight;
+
+    CPUImageKernels::Target target;
+    target.data = output.data();
+    target.width = outputWidth;
+    target.height = outputHeight;
+    target.stride = outputWidth * bytesPerPixel;
+
+    CPUImageKernels::transform(source, target, map, bytesPerPixel);
     return true;
 }
 
@@ -323,7 +236,8 @@ int CPUImageProcessor::getBytesPerPixel(PixelFormat format) {
             // Default to 3 for RGB conversion
             return 3;
         case PixelFormat::UYVY422:
-            // UYVY422 is 2 bytes per pixel (packed YUV)
+        case PixelFormat::YUYV422:
+            // Packed 4:2:2 is 2 bytes per pixel
             return 2;
         default:
             // Default to 4 (RGBA) for safety
@@ -11,8 +11,7 @@ namespace videocomposer {
  * Uses CPU pixel manipulation for:
  * - Crop (copy pixel region)
  * - Panorama mode (copy 50% width region with offset)
- * - Scale (resampling/interpolation)
- * - Rotation (affine transformation)
+ * - Scale and rotation (transform(): bilinear, fused with the crop)
  * 
  * This is a fallback when GPU processing is not available or not possible.
  */
@@ -33,6 +32,24 @@ public:
 
     bool canSkip(const LayerProperties& properties, bool isHAPCodec) const override;
 
+    /**
+     * Crop (or panorama), scale and rotation in one pass over the source
+     * (CPUImageKernels: bilinear for 32-bit formats, row tiles on worker
+     * threads). processCPU() leaves scale and rotation to the renderer;
+     * this is for paths that have no GL to do them.
+     */
+    bool transform(const FrameBuffer& input, FrameBuffer& output,
+                   const LayerProperties& properties,
+                   const FrameInfo& frameInfo);
+
+    /**
+     * Part of the picture a layer shows: the panorama half or the crop
+     * rectangle, in source pixels
+     * @return false if the whole picture is shown (or the crop is invalid)
+     */
+    static bool shownWindow(const LayerProperties& properties, const FrameInfo& frameInfo,
+                            FrameWindow& window);
+
 private:
     // Apply crop operation
     bool applyCrop(const FrameBuffer& input, FrameBuffer& output,
@@ -44,16 +61,10 @@ private:
                       const LayerProperties& properties,
                       const FrameInfo& frameInfo);
 
-    // Apply scale operation (simple nearest-neighbor for now)
-    bool applyScale(const FrameBuffer& input, FrameBuffer& output,
-                   const LayerProperties& properties,
-                   const FrameInfo& frameInfo);
+    // Copy a window of the picture out of a frame holding all or part of it
+    bool copyWindow(const FrameBuffer& input, FrameBuffer& output, const FrameWindow& window,
+                    const FrameInfo& frameInfo);
 
-    // Apply rotation (90/180/270 degrees for now)
-    bool applyRotation(const FrameBuffer& input, FrameBuffer& output,
-                      const LayerProperties& properties,
-                      const FrameInfo& frameInfo);
-    
     // Helper to get bytes per pixel from pixel format
     int getBytesPerPixel(PixelFormat format);
 };
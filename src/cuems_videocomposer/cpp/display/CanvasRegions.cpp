@@ -0,0 +1,123 @@
+#include "CanvasRegions.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+void CanvasRegions::set(const std::vector<CanvasRect>& rects, int canvasWidth, int canvasHeight) {
+    clear();
+    canvasWidth_ = std::max(canvasWidth, 0);
+    canvasHeight_ = std::max(canvasHeight, 0);
+    totalPixels_ = static_cast<long long>(canvasWidth_) * canvasHeight_;
+
+    // Clip to the canvas; every rectangle edge is a grid line
+    std::vector<CanvasRect> clipped;
+    std::vector<int> xs = {0, canvasWidth_};
+    std::vector<int> ys = {0, canvasHeight_};
+    for (const CanvasRect& rect : rects) {
+        int x0 = std::max(rect.x, 0), x1 = std::min(rect.x + rect.width, canvasWidth_);
+        int y0 = std::max(rect.y, 0), y1 = std::min(rect.y + rect.height, canvasHeight_);
+        if (x1 <= x0 || y1 <= y0) {
+            continue;
+        }
+        clipped.push_back(CanvasRect{x0, y0, x1 - x0, y1 - y0});
+        xs.push_back(x0);
+        xs.push_back(x1);
+        ys.push_back(y0);
+        ys.push_back(y1);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+    // Covered runs of grid cells per band; a run continuing the same run of
+    // the band below extends that rectangle upwards
+    std::vector<CanvasRect> open;
+    for (size_t band = 0; band + 1 < ys.size(); ++band) {
+        int y0 = ys[band], y1 = ys[band + 1];
+        std::vector<CanvasRect> runs;
+        for (size_t column = 0; column + 1 < xs.size(); ++column) {
+            int x0 = xs[column], x1 = xs[column + 1];
+            bool covered = std::any_of(clipped.begin(), clipped.end(), [&](const CanvasRect& rect) {
+                return rect.x <= x0 && rect.x + rect.width >= x1 &&
+                       rect.y <= y0 && rect.y + rect.height >= y1;
+            });
+            if (!covered) {
+                continue;
+            }
+            if (!runs.empty() && runs.back().x + runs.back().width == x0) {
+                runs.back().width = x1 - runs.back().x;
+            } else {
+                runs.push_back(CanvasRect{x0, y0, x1 - x0, y1 - y0});
+            }
+        }
+
+        std::vector<CanvasRect> next;
+        for (CanvasRect& run : runs) {
+            auto below = std::find_if(open.begin(), open.end(), [&](const CanvasRect& rect) {
+                return rect.x == run.x && rect.width == run.width;
+            });
+            if (below != open.end()) {
+                below->height += run.height;
+                next.push_back(*below);
+                open.erase(below);
+            } else {
+                next.push_back(run);
+            }
+        }
+        rects_.insert(rects_.end(), open.begin(), open.end());
+        open = std::move(next);
+    }
+    rects_.insert(rects_.end(), open.begin(), open.end());
+
+    for (const CanvasRect& rect : rects_) {
+        visiblePixels_ += static_cast<long long>(rect.width) * rect.height;
+    }
+}
+
+void CanvasRegions::clear() {
+    rects_.clear();
+    canvasWidth_ = canvasHeight_ = 0;
+    visiblePixels_ = totalPixels_ = 0;
+}
+
+bool CanvasRegions::intersects(float x0, float y0, float x1, float y1) const {
+    if (coversAll()) {
+        return x1 > 0.0f && y1 > 0.0f && x0 < canvasWidth_ && y0 < canvasHeight_;
+    }
+    for (const CanvasRect& rect : rects_) {
+        if (x0 < rect.x + rect.width && x1 > rect.x && y0 < rect.y + rect.height && y1 > rect.y) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<CanvasRect> CanvasRegions::flipped() const {
+    std::vector<CanvasRect> result = rects_;
+    for (CanvasRect& rect : result) {
+        rect.y = canvasHeight_ - rect.y - rect.height;
+    }
+    return result;
+}
+
+CanvasRegions CanvasRegions::scaled(float scale, int width, int height) const {
+    CanvasRegions result;
+    if (rects_.empty()) {
+        return result;
+    }
+    std::vector<CanvasRect> rects;
+    rects.reserve(rects_.size());
+    for (const CanvasRect& rect : rects_) {
+        int x0 = static_cast<int>(std::floor(rect.x * scale)) - 1;
+        int y0 = static_cast<int>(std::floor(rect.y * scale)) - 1;
+        int x1 = static_cast<int>(std::ceil((rect.x + rect.width) * scale)) + 1;
+        int y1 = static_cast<int>(std::ceil((rect.y + rect.height) * scale)) + 1;
+        rects.push_back(CanvasRect{x0, y0, x1 - x0, y1 - y0});
+    }
+    result.set(rects, width, height);
+    return result;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,85 @@
+#ifndef VIDEOCOMPOSER_CANVASREGIONS_H
+#define VIDEOCOMPOSER_CANVASREGIONS_H
+
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * CanvasRect - Pixel rectangle on the virtual canvas (y = 0 at the bottom,
+ * as OutputRegion::canvasY)
+ */
+struct CanvasRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const CanvasRect& other) const {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+};
+
+/**
+ * CanvasRegions - The parts of the virtual canvas that some output shows
+ *
+ * The canvas spans the bounding box of all outputs, so L-shaped, gapped or
+ * overlapping projector layouts leave canvas pixels no output ever reads.
+ * The output regions are merged into disjoint rectangles (overlaps counted
+ * once, neighbours joined), which VirtualCanvas clears and masks to and
+ * OpenGLRenderer culls layers against.
+ */
+class CanvasRegions {
+public:
+    /**
+     * Set the visible rectangles of a canvas (clipped to it)
+     */
+    void set(const std::vector<CanvasRect>& rects, int canvasWidth, int canvasHeight);
+
+    void clear();
+
+    /**
+     * Disjoint rectangles covering exactly the visible pixels
+     */
+    const std::vector<CanvasRect>& rects() const { return rects_; }
+
+    /**
+     * True if every canvas pixel is visible (or no regions are set)
+     */
+    bool coversAll() const { return visiblePixels_ == totalPixels_; }
+
+    /**
+     * True if any visible pixel lies in [x0,x1) x [y0,y1) (canvas pixels)
+     */
+    bool intersects(float x0, float y0, float x1, float y1) const;
+
+    /**
+     * Fraction of the canvas that is visible (1 = all)
+     */
+    float coverage() const {
+        return totalPixels_ > 0 ? static_cast<float>(visiblePixels_) / totalPixels_ : 1.0f;
+    }
+
+    /**
+     * Same rectangles with y counted from the top (for a canvas drawn upside down)
+     */
+    std::vector<CanvasRect> flipped() const;
+
+    /**
+     * The same regions on the canvas composited at a scale (see
+     * VirtualCanvas::setRenderScale), of width x height pixels: rounded
+     * outwards with a pixel around for the upscale's filter
+     */
+    CanvasRegions scaled(float scale, int width, int height) const;
+
+private:
+    std::vector<CanvasRect> rects_;
+    int canvasWidth_ = 0;
+    int canvasHeight_ = 0;
+    long long visiblePixels_ = 0;
+    long long totalPixels_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CANVASREGIONS_H
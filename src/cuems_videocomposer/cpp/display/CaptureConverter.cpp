@@ -0,0 +1,361 @@
+/**
+ * CaptureConverter.cpp - GPU format conversion and scaling before readback
+ */
+
+#include "CaptureConverter.h"
+#include "../utils/Logger.h"
+
+namespace videocomposer {
+
+namespace {
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer
+const char* CONVERT_VERTEX_SHADER = R"(
+#version 330 core
+
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// One packed texel = four bytes of the output frame
+const char* CONVERT_FRAGMENT_SHADER = R"(
+#version 330 core
+
+uniform sampler2D uSourceTex;    // Canvas, bottom row first
+uniform float uLod;              // Pyramid level sampled
+uniform int uFormat;             // 0 RGBA, 1 BGRA, 2 UYVY, 3 NV12, 4 I420
+uniform int uWidth;              // Output frame size in pixels
+uniform int uHeight;
+
+out vec4 fragColor;
+
+// Average over an output-pixel area (center and half size in output
+// pixels, top row first); four bilinear taps cover 2:1 of the level
+vec3 area(vec2 center, vec2 halfSize) {
+    vec2 size = vec2(uWidth, uHeight);
+    vec2 d = halfSize * 0.5;
+    vec3 sum = vec3(0.0);
+    sum += textureLod(uSourceTex, vec2(center.x - d.x, size.y - center.y + d.y) / size, uLod).rgb;
+    sum += textureLod(uSourceTex, vec2(center.x + d.x, size.y - center.y + d.y) / size, uLod).rgb;
+    sum += textureLod(uSourceTex, vec2(center.x - d.x, size.y - center.y - d.y) / size, uLod).rgb;
+    sum += textureLod(uSourceTex, vec2(center.x + d.x, size.y - center.y - d.y) / size, uLod).rgb;
+    return sum * 0.25;
+}
+
+// BT.709, limited range
+float luma(vec3 rgb) {
+    return (16.0 + 219.0 * dot(rgb, vec3(0.2126, 0.7152, 0.0722))) / 255.0;
+}
+
+vec2 chroma(vec3 rgb) {
+    float y = dot(rgb, vec3(0.2126, 0.7152, 0.0722));
+    return (128.0 + 224.0 * vec2((rgb.b - y) / 1.8556, (rgb.r - y) / 1.5748)) / 255.0;
+}
+
+float lumaAt(int x, int y) {
+    return luma(area(vec2(x, y) + 0.5, vec2(0.5)));
+}
+
+// Chroma of a 2x2 block
+vec2 chromaAt(int cx, int cy) {
+    return chroma(area(vec2(cx * 2 + 1, cy * 2 + 1), vec2(1.0)));
+}
+
+// Byte of the planar 4:2:0 layouts at a linear offset
+float planarByte(int offset) {
+    int lumaSize = uWidth * uHeight;
+    if (offset < lumaSize) {
+        return lumaAt(offset % uWidth, offset / uWidth);
+    }
+    int c = offset - lumaSize;
+    if (uFormat == 3) {
+        // NV12: U V pairs, uWidth bytes per row
+        vec2 uv = chromaAt((c % uWidth) / 2, c / uWidth);
+        return (c % 2) == 0 ? uv.x : uv.y;
+    }
+    int halfWidth = uWidth / 2;
+    int planeSize = halfWidth * (uHeight / 2);
+    int plane = c < planeSize ? 0 : 1;
+    c -= plane * planeSize;
+    vec2 uv = chromaAt(c % halfWidth, c / halfWidth);
+    return plane == 0 ? uv.x : uv.y;
+}
+
+void main() {
+    ivec2 t = ivec2(gl_FragCoord.xy);
+    if (uFormat <= 1) {
+        vec3 rgb = area(vec2(t) + 0.5, vec2(0.5));
+        fragColor = uFormat == 0 ? vec4(rgb, 1.0) : vec4(rgb.bgr, 1.0);
+    } else if (uFormat == 2) {
+        int x = t.x * 2;
+        vec3 left = area(vec2(x, t.y) + 0.5, vec2(0.5));
+        vec3 right = area(vec2(x + 1, t.y) + 0.5, vec2(0.5));
+        vec2 uv = chroma(area(vec2(x + 1, t.y) + vec2(0.0, 0.5), vec2(1.0, 0.5)));
+        fragColor = vec4(uv.x, luma(left), uv.y, luma(right));
+    } else {
+        int offset = (t.y * (uWidth / 4) + t.x) * 4;
+        fragColor = vec4(planarByte(offset), planarByte(offset + 1),
+                         planarByte(offset + 2), planarByte(offset + 3));
+    }
+}
+)";
+
+int formatIndex(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA32:  return 0;
+        case PixelFormat::BGRA32:  return 1;
+        case PixelFormat::UYVY422: return 2;
+        case PixelFormat::NV12:    return 3;
+        default:                   return 4;   // YUV420P
+    }
+}
+
+} // namespace
+
+CaptureConverter::CaptureConverter() {
+}
+
+CaptureConverter::~CaptureConverter() {
+    cleanup();
+}
+
+bool CaptureConverter::init(const CaptureFormat& format, int sourceWidth, int sourceHeight) {
+    cleanup();
+    
+    int width = 0;
+    int height = 0;
+    frameSize(format, sourceWidth, sourceHeight, width, height);
+    if (!supports(format.format) ||
+        !packedSize(format.format, width, height, packedWidth_, packedHeight_)) {
+        LOG_ERROR << "CaptureConverter: Unsupported capture format or size "
+                  << width << "x" << height;
+        return false;
+    }
+    
+    format_ = format;
+    sourceWidth_ = sourceWidth;
+    sourceHeight_ = sourceHeight;
+    width_ = width;
+    height_ = height;
+    
+    shader_ = std::make_unique<ShaderProgram>();
+    if (!shader_->createFromSource(CONVERT_VERTEX_SHADER, CONVERT_FRAGMENT_SHADER)) {
+        LOG_ERROR << "CaptureConverter: Failed to compile conversion shader";
+        cleanup();
+        return false;
+    }
+    
+    if (!createTarget()) {
+        cleanup();
+        return false;
+    }
+    
+    initialized_ = true;
+    LOG_INFO << "CaptureConverter: " << sourceWidth_ << "x" << sourceHeight_ << " -> "
+             << width_ << "x" << height_ << " (format " << formatIndex(format_.format)
+             << ", " << FrameData::frameSize(format_.format, width_, height_) << " bytes per frame)";
+    return true;
+}
+
+bool CaptureConverter::createTarget() {
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, packedWidth_, packedHeight_, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR << "CaptureConverter: FBO incomplete, status=" << status;
+        return false;
+    }
+    
+    glGenVertexArrays(1, &vao_);
+    
+    return readback_.configure(static_cast<size_t>(packedWidth_) * packedHeight_ * 4);
+}
+
+void CaptureConverter::cleanup() {
+    readback_.release();
+    if (vao_ != 0) {
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (texture_ != 0) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    shader_.reset();
+    initialized_ = false;
+}
+
+void CaptureConverter::convert(GLuint sourceTexture, int levels) {
+    if (!initialized_) {
+        return;
+    }
+    // The GPU is a whole ring behind: drop this frame rather than wait
+    GLuint buffer = readback_.begin();
+    if (buffer == 0) {
+        return;
+    }
+    
+    GLint previousFbo = 0;
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, packedWidth_, packedHeight_);
+    glDisable(GL_BLEND);
+    
+    shader_->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sourceTexture);
+    shader_->setUniform("uSourceTex", 0);
+    shader_->setUniform("uFormat", formatIndex(format_.format));
+    shader_->setUniform("uWidth", width_);
+    shader_->setUniform("uHeight", height_);
+    shader_->setUniform("uLod", static_cast<float>(std::min(getPyramidLevel(), std::max(levels, 1) - 1)));
+    
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    shader_->unbind();
+    
+    // Start the async read of the packed frame (returns immediately)
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, packedWidth_, packedHeight_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+    readback_.submit(frameNumber_++);
+}
+
+bool CaptureConverter::getResult(FrameData& frame) {
+    if (!initialized_ || !readback_.ready()) {
+        return false;
+    }
+    
+    // The packed rows may round the frame up: room for all of them
+    FrameData result;
+    result.data = new uint8_t[readback_.getSize()];
+    result.ownsData = true;
+    if (!readback_.poll(result.data, readback_.getSize(), &result.frameNumber)) {
+        return false;
+    }
+    result.size = FrameData::frameSize(format_.format, width_, height_);
+    result.width = width_;
+    result.height = height_;
+    result.format = format_.format;
+    frame = std::move(result);
+    return true;
+}
+
+CapturePyramid::~CapturePyramid() {
+    cleanup();
+}
+
+bool CapturePyramid::configure(int width, int height, int levels) {
+    if (texture_ != 0 && width == width_ && height == height_ && levels == levels_) {
+        return true;
+    }
+    cleanup();
+    if (width <= 0 || height <= 0 || levels <= 0) {
+        return false;
+    }
+    
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    for (int level = 0; level < levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8,
+                     std::max(width >> level, 1), std::max(height >> level, 1), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR << "CapturePyramid: FBO incomplete, status=" << status;
+        cleanup();
+        return false;
+    }
+    
+    width_ = width;
+    height_ = height;
+    levels_ = levels;
+    LOG_INFO << "CapturePyramid: " << width_ << "x" << height_ << ", " << levels_ << " levels";
+    return true;
+}
+
+void CapturePyramid::update(GLuint sourceFbo) {
+    if (texture_ == 0) {
+        return;
+    }
+    
+    GLint previousRead = 0;
+    GLint previousDraw = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
+    glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    
+    if (levels_ > 1) {
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+void CapturePyramid::cleanup() {
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (texture_ != 0) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    width_ = 0;
+    height_ = 0;
+    levels_ = 0;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,246 @@
+/**
+ * CaptureConverter.h - GPU format conversion and scaling before readback
+ *
+ * Part of the Virtual Canvas architecture for cuems-videocomposer.
+ *
+ * Converts the canvas into a sink's native format (UYVY, NV12, I420 or
+ * RGBA/BGRA at another size) in a shader pass, so glReadPixels transfers
+ * the final bytes: a 4:2:0 readback is 1.5 bytes per pixel instead of 4,
+ * and no conversion is left for the CPU.
+ */
+
+#ifndef VIDEOCOMPOSER_CAPTURECONVERTER_H
+#define VIDEOCOMPOSER_CAPTURECONVERTER_H
+
+#include "ShaderProgram.h"
+#include "../output/OutputSink.h"
+#include "../output/ReadbackRing.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace videocomposer {
+
+/**
+ * CaptureConverter - One capture format, converted and read back async
+ *
+ * The frame's bytes are packed into an RGBA8 target (four bytes per
+ * texel) laid out exactly as the format is in memory, top row first:
+ * - RGBA32 / BGRA32: one pixel per texel
+ * - UYVY422: two pixels per texel (U Y0 V Y1)
+ * - NV12 / YUV420P: the Y plane then the chroma, four bytes per texel
+ *   and width / 4 texels per row
+ * YUV is BT.709, limited range.
+ *
+ * Downscaled formats sample a CapturePyramid level close to their size,
+ * so a 1/4 or 1/8 frame costs as little as a full-size one.
+ *
+ * Usage (canvas context current):
+ *   converter.init(format, canvasWidth, canvasHeight);
+ *   // Every frame:
+ *   pyramid.update(canvas.getFBO());  // once, shared by all converters
+ *   while (converter.getResult(frame)) { ... }  // finished readbacks
+ *   converter.convert(pyramid.getTexture(), pyramid.getLevels());
+ */
+class CaptureConverter {
+public:
+    CaptureConverter();
+    ~CaptureConverter();
+
+    // Disable copy
+    CaptureConverter(const CaptureConverter&) = delete;
+    CaptureConverter& operator=(const CaptureConverter&) = delete;
+
+    /**
+     * Create the shader, packed target and PBOs
+     * @param format Format and size to produce (0 = source size)
+     * @param sourceWidth Source texture width
+     * @param sourceHeight Source texture height
+     * @return true on success
+     */
+    bool init(const CaptureFormat& format, int sourceWidth, int sourceHeight);
+
+    /**
+     * Cleanup resources
+     */
+    void cleanup();
+
+    bool isInitialized() const { return initialized_; }
+
+    /**
+     * Format as requested (sizes may be 0)
+     */
+    const CaptureFormat& getFormat() const { return format_; }
+
+    int getSourceWidth() const { return sourceWidth_; }
+    int getSourceHeight() const { return sourceHeight_; }
+
+    /**
+     * Frame size produced, after rounding to what the format can pack
+     */
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+    /**
+     * Pyramid levels below the source size this conversion can use
+     * (0 when it is not downscaled by more than 2:1)
+     */
+    int getPyramidLevel() const {
+        return pyramidLevel(sourceWidth_, sourceHeight_, width_, height_);
+    }
+    
+    /**
+     * Convert the source texture and start reading the result back
+     * (non-blocking; the bytes arrive with a later getResult()). Skipped
+     * when every readback buffer is still in flight.
+     * @param sourceTexture Texture of getSourceWidth() x getSourceHeight()
+     * @param levels Mip levels the texture has (1 = none)
+     */
+    void convert(GLuint sourceTexture, int levels = 1);
+
+    /**
+     * Bytes of the oldest convert() whose readback has finished
+     * (never waits on the GPU)
+     * @param frame Receives the frame (owns its data)
+     * @return true if a finished conversion was pending
+     */
+    bool getResult(FrameData& frame);
+
+    /**
+     * Formats the shader can produce
+     */
+    static bool supports(PixelFormat format) {
+        return format == PixelFormat::RGBA32 || format == PixelFormat::BGRA32 ||
+               format == PixelFormat::UYVY422 || format == PixelFormat::NV12 ||
+               format == PixelFormat::YUV420P;
+    }
+
+    /**
+     * Frame size for a format: explicit, or the source size at its level
+     */
+    static void frameSize(const CaptureFormat& format, int sourceWidth, int sourceHeight,
+                          int& width, int& height) {
+        int level = format.level > 0 ? format.level : 0;
+        width = format.width > 0 ? format.width : sourceWidth >> level;
+        height = format.height > 0 ? format.height : sourceHeight >> level;
+    }
+    
+    /**
+     * Pyramid level to sample for a downscale: four bilinear taps read
+     * 2x2 texels of the level, so one level above the scale
+     */
+    static int pyramidLevel(int sourceWidth, int sourceHeight, int width, int height) {
+        if (width <= 0 || height <= 0) {
+            return 0;
+        }
+        double scale = std::min(static_cast<double>(sourceWidth) / width,
+                                static_cast<double>(sourceHeight) / height);
+        return scale > 2.0 ? static_cast<int>(std::ceil(std::log2(scale))) - 1 : 0;
+    }
+    
+    /**
+     * Packed RGBA8 target for a frame
+     * @param format Pixel format
+     * @param width In: requested width, out: rounded down to what the format packs
+     * @param height In: requested height, out: rounded down likewise
+     * @param packedWidth Out: target width in texels
+     * @param packedHeight Out: target height in texels
+     * @return false if the format is not supported or the size is too small
+     */
+    static bool packedSize(PixelFormat format, int& width, int& height,
+                           int& packedWidth, int& packedHeight) {
+        switch (format) {
+            case PixelFormat::RGBA32:
+            case PixelFormat::BGRA32:
+                packedWidth = width;
+                packedHeight = height;
+                break;
+            case PixelFormat::UYVY422:
+                width &= ~1;
+                packedWidth = width / 2;
+                packedHeight = height;
+                break;
+            case PixelFormat::NV12:
+            case PixelFormat::YUV420P:
+                width &= ~3;
+                height &= ~1;
+                packedWidth = width / 4;
+                packedHeight = height + height / 2;
+                break;
+            default:
+                return false;
+        }
+        return packedWidth > 0 && packedHeight > 0;
+    }
+
+private:
+    bool createTarget();
+
+    CaptureFormat format_;
+    int sourceWidth_ = 0;
+    int sourceHeight_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int packedWidth_ = 0;
+    int packedHeight_ = 0;
+
+    std::unique_ptr<ShaderProgram> shader_;
+    GLuint vao_ = 0;              // Empty: the quad comes from gl_VertexID
+    GLuint fbo_ = 0;
+    GLuint texture_ = 0;
+
+    // Fenced readback ring, tagged with the frame number
+    ReadbackRing readback_;
+    int64_t frameNumber_ = 0;
+
+    bool initialized_ = false;
+};
+
+/**
+ * CapturePyramid - Mip chain of the canvas, built once per captured frame
+ *
+ * The canvas is copied into level 0 and the smaller levels are filtered
+ * down from it in one glGenerateMipmap, so every pyramid level a sink
+ * subscribes to (full, 1/2, 1/4...) comes out of the same pass.
+ */
+class CapturePyramid {
+public:
+    CapturePyramid() = default;
+    ~CapturePyramid();
+
+    // Disable copy
+    CapturePyramid(const CapturePyramid&) = delete;
+    CapturePyramid& operator=(const CapturePyramid&) = delete;
+
+    /**
+     * Size the pyramid (reallocates only when something changed)
+     * @param levels Levels to keep, including the full-size one
+     * @return true on success
+     */
+    bool configure(int width, int height, int levels);
+
+    /**
+     * Copy the canvas in and rebuild the smaller levels
+     * @param sourceFbo Framebuffer holding the canvas
+     */
+    void update(GLuint sourceFbo);
+
+    void cleanup();
+
+    GLuint getTexture() const { return texture_; }
+    int getLevels() const { return levels_; }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+private:
+    GLuint texture_ = 0;
+    GLuint fbo_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int levels_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CAPTURECONVERTER_H
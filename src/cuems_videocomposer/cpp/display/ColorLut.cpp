@@ -0,0 +1,181 @@
+#include "ColorLut.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace videocomposer {
+
+void ColorLut::adjust(const Adjustment& adjustment, float rgb[3]) {
+    float r = rgb[0], g = rgb[1], b = rgb[2];
+
+    // Brightness, then contrast about mid grey
+    r = (r + adjustment.brightness - 0.5f) * adjustment.contrast + 0.5f;
+    g = (g + adjustment.brightness - 0.5f) * adjustment.contrast + 0.5f;
+    b = (b + adjustment.brightness - 0.5f) * adjustment.contrast + 0.5f;
+
+    // Saturation against BT.601 luminance
+    float luminance = 0.299f * r + 0.587f * g + 0.114f * b;
+    r = luminance + (r - luminance) * adjustment.saturation;
+    g = luminance + (g - luminance) * adjustment.saturation;
+    b = luminance + (b - luminance) * adjustment.saturation;
+
+    // Hue rotation (same matrix as the shader, row by row)
+    if (adjustment.hue != 0.0f) {
+        float radians = adjustment.hue * 3.14159265359f / 180.0f;
+        float c = std::cos(radians);
+        float s = std::sin(radians);
+        float hr = (0.213f + c * 0.787f - s * 0.213f) * r +
+                   (0.715f - c * 0.715f - s * 0.715f) * g +
+                   (0.072f - c * 0.072f + s * 0.928f) * b;
+        float hg = (0.213f - c * 0.213f + s * 0.143f) * r +
+                   (0.715f + c * 0.285f + s * 0.140f) * g +
+                   (0.072f - c * 0.072f - s * 0.283f) * b;
+        float hb = (0.213f - c * 0.213f - s * 0.787f) * r +
+                   (0.715f - c * 0.715f + s * 0.715f) * g +
+                   (0.072f + c * 0.928f + s * 0.072f) * b;
+        r = hr;
+        g = hg;
+        b = hb;
+    }
+
+    if (adjustment.gamma != 1.0f) {
+        float exponent = 1.0f / adjustment.gamma;
+        r = std::pow(std::max(r, 0.0f), exponent);
+        g = std::pow(std::max(g, 0.0f), exponent);
+        b = std::pow(std::max(b, 0.0f), exponent);
+    }
+
+    rgb[0] = std::min(std::max(r, 0.0f), 1.0f);
+    rgb[1] = std::min(std::max(g, 0.0f), 1.0f);
+    rgb[2] = std::min(std::max(b, 0.0f), 1.0f);
+}
+
+bool ColorLut::build(const Adjustment& adjustment, int size, const ColorLut* calibration) {
+    if (size < 2 || size > MAX_SIZE) {
+        return false;
+    }
+    size_ = size;
+    data_.resize(static_cast<size_t>(size) * size * size * 3);
+    std::fill(domainMin_, domainMin_ + 3, 0.0f);
+    std::fill(domainMax_, domainMax_ + 3, 1.0f);
+
+    float step = 1.0f / (size - 1);
+    float* out = data_.data();
+    for (int b = 0; b < size; ++b) {
+        for (int g = 0; g < size; ++g) {
+            for (int r = 0; r < size; ++r) {
+                float rgb[3] = {r * step, g * step, b * step};
+                adjust(adjustment, rgb);
+                if (calibration && calibration->isValid()) {
+                    float calibrated[3];
+                    calibration->sample(rgb, calibrated);
+                    std::copy(calibrated, calibrated + 3, rgb);
+                }
+                out[0] = rgb[0];
+                out[1] = rgb[1];
+                out[2] = rgb[2];
+                out += 3;
+            }
+        }
+    }
+    return true;
+}
+
+bool ColorLut::loadCube(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_WARNING << "ColorLut: Cannot open " << path;
+        return false;
+    }
+
+    int size = 0;
+    float domainMin[3] = {0.0f, 0.0f, 0.0f};
+    float domainMax[3] = {1.0f, 1.0f, 1.0f};
+    std::vector<float> data;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+        if (first == "LUT_3D_SIZE") {
+            fields >> size;
+        } else if (first == "LUT_1D_SIZE") {
+            LOG_WARNING << "ColorLut: " << path << " is a 1D table, only 3D tables are supported";
+            return false;
+        } else if (first == "DOMAIN_MIN") {
+            fields >> domainMin[0] >> domainMin[1] >> domainMin[2];
+        } else if (first == "DOMAIN_MAX") {
+            fields >> domainMax[0] >> domainMax[1] >> domainMax[2];
+        } else if (first == "TITLE" || first == "LUT_3D_INPUT_RANGE") {
+            continue;
+        } else {
+            // Data line: three numbers
+            std::istringstream values(line);
+            float r, g, b;
+            if (values >> r >> g >> b) {
+                data.push_back(std::min(std::max(r, 0.0f), 1.0f));
+                data.push_back(std::min(std::max(g, 0.0f), 1.0f));
+                data.push_back(std::min(std::max(b, 0.0f), 1.0f));
+            }
+        }
+    }
+
+    if (size < 2 || size > MAX_SIZE ||
+        data.size() != static_cast<size_t>(size) * size * size * 3) {
+        LOG_WARNING << "ColorLut: " << path << " has " << data.size() / 3
+                    << " entries for LUT_3D_SIZE " << size;
+        return false;
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (!(domainMax[c] > domainMin[c])) {
+            LOG_WARNING << "ColorLut: " << path << " has an empty domain";
+            return false;
+        }
+    }
+
+    size_ = size;
+    data_ = std::move(data);
+    std::copy(domainMin, domainMin + 3, domainMin_);
+    std::copy(domainMax, domainMax + 3, domainMax_);
+    LOG_INFO << "ColorLut: Loaded " << size << "^3 table from " << path;
+    return true;
+}
+
+void ColorLut::sample(const float in[3], float out[3]) const {
+    if (!isValid()) {
+        std::copy(in, in + 3, out);
+        return;
+    }
+
+    int index[3];
+    float fraction[3];
+    for (int c = 0; c < 3; ++c) {
+        float position = (in[c] - domainMin_[c]) / (domainMax_[c] - domainMin_[c]);
+        position = std::min(std::max(position, 0.0f), 1.0f) * (size_ - 1);
+        index[c] = std::min(static_cast<int>(position), size_ - 2);
+        fraction[c] = position - index[c];
+    }
+
+    out[0] = out[1] = out[2] = 0.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        int dr = corner & 1, dg = (corner >> 1) & 1, db = (corner >> 2) & 1;
+        float weight = (dr ? fraction[0] : 1.0f - fraction[0]) *
+                       (dg ? fraction[1] : 1.0f - fraction[1]) *
+                       (db ? fraction[2] : 1.0f - fraction[2]);
+        size_t entry = ((static_cast<size_t>(index[2] + db) * size_ + index[1] + dg) * size_ +
+                        index[0] + dr) * 3;
+        out[0] += weight * data_[entry];
+        out[1] += weight * data_[entry + 1];
+        out[2] += weight * data_[entry + 2];
+    }
+}
+
+} // namespace videocomposer
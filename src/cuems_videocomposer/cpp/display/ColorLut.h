@@ -0,0 +1,92 @@
+#ifndef VIDEOCOMPOSER_COLORLUT_H
+#define VIDEOCOMPOSER_COLORLUT_H
+
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ColorLut - 3D colour lookup table (RGB in, RGB out)
+ *
+ * Colour adjustments are baked into a table once per parameter change,
+ * so a colour-adjusted layer costs one 3D texture fetch instead of the
+ * per-pixel HSV and pow math. Tables also load from .cube files (venue
+ * calibration); a calibration table can be applied after an adjustment
+ * in the same bake.
+ *
+ * Entries are stored red fastest, then green, then blue - the order of a
+ * .cube file and of a GL 3D texture (x = red, y = green, z = blue) - with
+ * values clamped to 0-1.
+ */
+class ColorLut {
+public:
+    static constexpr int DEFAULT_SIZE = 33;
+    static constexpr int MAX_SIZE = 65;
+
+    /**
+     * Brightness, contrast, saturation, hue and gamma, as in
+     * LayerProperties::ColorAdjustment
+     */
+    struct Adjustment {
+        float brightness = 0.0f;   // -1.0 to 1.0 (0 = no change)
+        float contrast = 1.0f;     // 0.0 to 2.0 (1 = no change)
+        float saturation = 1.0f;   // 0.0 to 2.0 (1 = no change)
+        float hue = 0.0f;          // -180 to 180 degrees
+        float gamma = 1.0f;        // 0.1 to 3.0 (1 = no change)
+
+        template <typename T>
+        static Adjustment from(const T& colorAdjust) {
+            Adjustment adjustment;
+            adjustment.brightness = colorAdjust.brightness;
+            adjustment.contrast = colorAdjust.contrast;
+            adjustment.saturation = colorAdjust.saturation;
+            adjustment.hue = colorAdjust.hue;
+            adjustment.gamma = colorAdjust.gamma;
+            return adjustment;
+        }
+
+        bool isIdentity() const {
+            return brightness == 0.0f && contrast == 1.0f && saturation == 1.0f &&
+                   hue == 0.0f && gamma == 1.0f;
+        }
+    };
+
+    /**
+     * Apply an adjustment to one colour, exactly as the shaders did
+     * per pixel (brightness, contrast, saturation, hue, gamma, clamp)
+     */
+    static void adjust(const Adjustment& adjustment, float rgb[3]);
+
+    /**
+     * Bake an adjustment, optionally followed by a calibration table
+     * @return false if size is outside 2..MAX_SIZE
+     */
+    bool build(const Adjustment& adjustment, int size = DEFAULT_SIZE,
+               const ColorLut* calibration = nullptr);
+
+    /**
+     * Load a .cube file (LUT_3D_SIZE, optional DOMAIN_MIN / DOMAIN_MAX)
+     * @return false on a missing file, 1D table or wrong entry count
+     */
+    bool loadCube(const std::string& path);
+
+    /**
+     * Trilinear lookup of one colour (clamped to the domain)
+     */
+    void sample(const float in[3], float out[3]) const;
+
+    bool isValid() const { return size_ >= 2; }
+    int size() const { return size_; }
+    const std::vector<float>& data() const { return data_; }
+
+private:
+    int size_ = 0;
+    std::vector<float> data_;   // size^3 RGB triplets
+    float domainMin_[3] = {0.0f, 0.0f, 0.0f};
+    float domainMax_[3] = {1.0f, 1.0f, 1.0f};
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_COLORLUT_H
@@ -0,0 +1,106 @@
+#include "ColorLutCache.h"
+#include "ShaderProgram.h"
+#include "../utils/Logger.h"
+
+namespace videocomposer {
+
+ColorLutCache::~ColorLutCache() {
+    clear();
+}
+
+bool ColorLutCache::bind(ShaderProgram* shader, const ColorLut::Adjustment& adjustment,
+                         const std::string& cubeFile) {
+    if (!shader) {
+        return false;
+    }
+
+    Key key(adjustment.brightness, adjustment.contrast, adjustment.saturation,
+            adjustment.hue, adjustment.gamma, cubeFile);
+    auto it = tables_.find(key);
+    if (it == tables_.end()) {
+        // Same lattice as the calibration table, so its entries are kept exactly
+        const ColorLut* calibration = cubeFile.empty() ? nullptr : cube(cubeFile);
+        ColorLut lut;
+        lut.build(adjustment, calibration ? calibration->size() : ColorLut::DEFAULT_SIZE, calibration);
+
+        Table table;
+        if (!upload(lut, table)) {
+            return false;
+        }
+        evict();
+        it = tables_.emplace(key, table).first;
+        LOG_VERBOSE << "ColorLutCache: Baked " << table.size << "^3 table"
+                    << (calibration ? " with " + cubeFile : std::string()) << " ("
+                    << tables_.size() << " cached)";
+    }
+    it->second.lastUse = ++useCounter_;
+
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_3D, it->second.texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    float size = static_cast<float>(it->second.size);
+    shader->setUniform("uColorLut", TEXTURE_UNIT);
+    shader->setUniform("uColorLutScale", (size - 1.0f) / size, 0.5f / size);
+    return true;
+}
+
+const ColorLut* ColorLutCache::cube(const std::string& path) {
+    auto it = cubes_.find(path);
+    if (it == cubes_.end()) {
+        auto lut = std::make_unique<ColorLut>();
+        if (!lut->loadCube(path)) {
+            LOG_WARNING << "ColorLutCache: " << path << " not applied, colour adjustment only";
+            lut.reset();
+        }
+        it = cubes_.emplace(path, std::move(lut)).first;
+    }
+    return it->second.get();
+}
+
+bool ColorLutCache::upload(const ColorLut& lut, Table& table) {
+    if (!lut.isValid()) {
+        return false;
+    }
+
+    glGenTextures(1, &table.texture);
+    glBindTexture(GL_TEXTURE_3D, table.texture);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, lut.size(), lut.size(), lut.size(), 0,
+                 GL_RGB, GL_FLOAT, lut.data().data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    if (table.texture == 0) {
+        LOG_ERROR << "ColorLutCache: Failed to create 3D texture";
+        return false;
+    }
+    table.size = lut.size();
+    return true;
+}
+
+void ColorLutCache::evict() {
+    while (tables_.size() >= MAX_TABLES) {
+        auto oldest = tables_.begin();
+        for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        glDeleteTextures(1, &oldest->second.texture);
+        tables_.erase(oldest);
+    }
+}
+
+void ColorLutCache::clear() {
+    for (auto& entry : tables_) {
+        glDeleteTextures(1, &entry.second.texture);
+    }
+    tables_.clear();
+    cubes_.clear();
+}
+
+} // namespace videocomposer
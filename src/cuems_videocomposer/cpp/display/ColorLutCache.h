@@ -0,0 +1,74 @@
+#ifndef VIDEOCOMPOSER_COLORLUTCACHE_H
+#define VIDEOCOMPOSER_COLORLUTCACHE_H
+
+#include "ColorLut.h"
+#include <GL/glew.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+
+namespace videocomposer {
+
+class ShaderProgram;
+
+/**
+ * ColorLutCache - Baked colour adjustment tables as GL 3D textures
+ *
+ * Tables are keyed by the adjustment values and .cube file, built on
+ * first use and kept while in use, so a steady adjustment is baked once
+ * and layers with the same settings share a texture. An animated
+ * adjustment bakes one table per distinct value; the least recently
+ * used tables beyond MAX_TABLES are dropped.
+ *
+ * .cube files are parsed once; one that fails to load is remembered and
+ * the adjustment is baked without it.
+ *
+ * Must be used (and destroyed) with the owning GL context current.
+ */
+class ColorLutCache {
+public:
+    static constexpr int TEXTURE_UNIT = 3;      // After the planes of every layer format
+    static constexpr size_t MAX_TABLES = 16;
+
+    ColorLutCache() = default;
+    ~ColorLutCache();
+
+    ColorLutCache(const ColorLutCache&) = delete;
+    ColorLutCache& operator=(const ColorLutCache&) = delete;
+
+    /**
+     * Bind the table for an adjustment on TEXTURE_UNIT and point the
+     * program's uColorLut / uColorLutScale at it (program in use)
+     * @return false if no table could be built
+     */
+    bool bind(ShaderProgram* shader, const ColorLut::Adjustment& adjustment,
+              const std::string& cubeFile);
+
+    size_t getTableCount() const { return tables_.size(); }
+
+    // Drop all tables and parsed files
+    void clear();
+
+private:
+    using Key = std::tuple<float, float, float, float, float, std::string>;
+
+    struct Table {
+        GLuint texture = 0;
+        int size = 0;
+        uint64_t lastUse = 0;
+    };
+
+    const ColorLut* cube(const std::string& path);
+    bool upload(const ColorLut& lut, Table& table);
+    void evict();
+
+    std::map<Key, Table> tables_;
+    std::map<std::string, std::unique_ptr<ColorLut>> cubes_;  // nullptr = failed to load
+    uint64_t useCounter_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_COLORLUTCACHE_H
@@ -0,0 +1,138 @@
+#include "CornerWarpCache.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+const CornerWarpCache::Warp& CornerWarpCache::get(float quadX, float quadY, const float corners[8]) {
+    Key key;
+    key[0] = quadX;
+    key[1] = quadY;
+    std::copy(corners, corners + 8, key.begin() + 2);
+
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        Entry entry;
+        if (!solve(quadX, quadY, corners, entry.warp.matrix)) {
+            LOG_WARNING << "CornerWarpCache: Degenerate corner deform, drawing undeformed";
+        }
+        entry.warp.distortion = distortion(entry.warp.matrix, quadX, quadY);
+        evict();
+        it = entries_.emplace(key, entry).first;
+    }
+    it->second.lastUse = ++useCounter_;
+    return it->second.warp;
+}
+
+bool CornerWarpCache::solve(float quadX, float quadY, const float corners[8], float matrix[16]) {
+    std::fill(matrix, matrix + 16, 0.0f);
+    matrix[0] = matrix[5] = matrix[15] = 1.0f;
+    if (quadX <= 0.0f || quadY <= 0.0f) {
+        return false;
+    }
+
+    // Destination corners
+    const double base[4][2] = {{-quadX, -quadY}, {quadX, -quadY}, {quadX, quadY}, {-quadX, quadY}};
+    double x[4], y[4];
+    for (int i = 0; i < 4; ++i) {
+        x[i] = base[i][0] + corners[i * 2];
+        y[i] = base[i][1] + corners[i * 2 + 1];
+    }
+
+    // Unit square onto the quad (Heckbert's closed form); corner 1 is at
+    // u = 1, corner 3 at v = 1
+    double dx1 = x[1] - x[2], dx2 = x[3] - x[2], dx3 = x[0] - x[1] + x[2] - x[3];
+    double dy1 = y[1] - y[2], dy2 = y[3] - y[2], dy3 = y[0] - y[1] + y[2] - y[3];
+    double g = 0.0, h = 0.0;
+    if (dx3 != 0.0 || dy3 != 0.0) {
+        double den = dx1 * dy2 - dx2 * dy1;
+        if (std::fabs(den) < 1e-12) {
+            return false;
+        }
+        g = (dx3 * dy2 - dx2 * dy3) / den;
+        h = (dx1 * dy3 - dx3 * dy1) / den;
+    }
+    double square[3][3] = {
+        {x[1] - x[0] + g * x[1], x[3] - x[0] + h * x[3], x[0]},
+        {y[1] - y[0] + g * y[1], y[3] - y[0] + h * y[3], y[0]},
+        {g, h, 1.0},
+    };
+
+    // Preceded by the quad onto the unit square: u = (x + quadX) / (2 quadX)
+    double H[3][3];
+    for (int r = 0; r < 3; ++r) {
+        H[r][0] = square[r][0] / (2.0 * quadX);
+        H[r][1] = square[r][1] / (2.0 * quadY);
+        H[r][2] = 0.5 * (square[r][0] + square[r][1]) + square[r][2];
+    }
+    double w = H[2][2];
+    double det = H[0][0] * (H[1][1] * H[2][2] - H[1][2] * H[2][1]) -
+                 H[0][1] * (H[1][0] * H[2][2] - H[1][2] * H[2][0]) +
+                 H[0][2] * (H[1][0] * H[2][1] - H[1][1] * H[2][0]);
+    if (std::fabs(w) < 1e-12 || std::fabs(det) < 1e-12) {
+        return false;
+    }
+
+    // Column-major, z row and column dropped, h33 = 1 (as findHomography)
+    matrix[0] = static_cast<float>(H[0][0] / w);
+    matrix[1] = static_cast<float>(H[1][0] / w);
+    matrix[3] = static_cast<float>(H[2][0] / w);
+    matrix[4] = static_cast<float>(H[0][1] / w);
+    matrix[5] = static_cast<float>(H[1][1] / w);
+    matrix[7] = static_cast<float>(H[2][1] / w);
+    matrix[12] = static_cast<float>(H[0][2] / w);
+    matrix[13] = static_cast<float>(H[1][2] / w);
+    matrix[15] = 1.0f;
+    return true;
+}
+
+float CornerWarpCache::distortion(const float matrix[16], float quadX, float quadY) {
+    float worstElongation = 1.0f;
+    float minArea = 0.0f, maxArea = 0.0f;
+    for (int j = 0; j < 3; ++j) {
+        for (int i = 0; i < 3; ++i) {
+            float px = quadX * (i - 1);
+            float py = quadY * (j - 1);
+            float w = matrix[3] * px + matrix[7] * py + matrix[15];
+            if (w <= 0.0f) {
+                return INFINITY;   // Folded through infinity
+            }
+            float u = (matrix[0] * px + matrix[4] * py + matrix[12]) / w;
+            float v = (matrix[1] * px + matrix[5] * py + matrix[13]) / w;
+
+            // Jacobian of the projective map at this point
+            float a = (matrix[0] - u * matrix[3]) / w;
+            float b = (matrix[4] - u * matrix[7]) / w;
+            float c = (matrix[1] - v * matrix[3]) / w;
+            float d = (matrix[5] - v * matrix[7]) / w;
+            float area = std::fabs(a * d - b * c);
+            if (area <= 0.0f) {
+                return INFINITY;
+            }
+            float sum = a * a + b * b + c * c + d * d;
+            float spread = std::sqrt(std::max(sum * sum - 4.0f * area * area, 0.0f));
+            float major = std::sqrt(0.5f * (sum + spread));
+            float minor = area / major;
+            worstElongation = std::max(worstElongation, major / minor);
+
+            minArea = (i == 0 && j == 0) ? area : std::min(minArea, area);
+            maxArea = std::max(maxArea, area);
+        }
+    }
+    return std::max(worstElongation, maxArea / minArea);
+}
+
+void CornerWarpCache::evict() {
+    while (entries_.size() >= MAX_ENTRIES) {
+        auto oldest = entries_.begin();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        entries_.erase(oldest);
+    }
+}
+
+} // namespace videocomposer
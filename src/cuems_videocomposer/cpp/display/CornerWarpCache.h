@@ -0,0 +1,73 @@
+#ifndef VIDEOCOMPOSER_CORNERWARPCACHE_H
+#define VIDEOCOMPOSER_CORNERWARPCACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace videocomposer {
+
+/**
+ * CornerWarpCache - Homographies of corner-deformed quads
+ *
+ * A corner deform maps the layer quad (-quadX,-quadY)..(quadX,quadY) onto
+ * the same corners moved by eight offsets. The matrix and the warp's
+ * sampling distortion are solved once per quad and corner set and reused
+ * by every draw until a corner (or the letterboxed quad) changes, so
+ * dozens of static mapped surfaces cost a map lookup each per frame.
+ *
+ * Matrices use the layout of findHomography() (column-major 4x4, z
+ * dropped) for uHomography and glMultMatrixf.
+ */
+class CornerWarpCache {
+public:
+    // Below this the warp is mild: plain filtering is as sharp as gradient sampling
+    static constexpr float MILD_DISTORTION = 1.25f;
+    static constexpr size_t MAX_ENTRIES = 64;
+
+    struct Warp {
+        float matrix[16];
+        float distortion = 1.0f;   // Worst footprint elongation / area change over the quad
+        bool isMild() const { return distortion < MILD_DISTORTION; }
+    };
+
+    /**
+     * Warp for a quad and its corner offsets (x,y for the corners at
+     * (-x,-y), (x,-y), (x,y), (-x,y)), solved on first use
+     */
+    const Warp& get(float quadX, float quadY, const float corners[8]);
+
+    /**
+     * Solve the homography of a corner deform
+     * @return false for a degenerate quad (matrix is then identity)
+     */
+    static bool solve(float quadX, float quadY, const float corners[8], float matrix[16]);
+
+    /**
+     * How far a warp departs from a uniform scale: the worst ratio of the
+     * long to short axis of a pixel's footprint, or of the largest to
+     * smallest footprint area, sampled over the quad (1 = no distortion)
+     */
+    static float distortion(const float matrix[16], float quadX, float quadY);
+
+    size_t getEntryCount() const { return entries_.size(); }
+    void clear() { entries_.clear(); }
+
+private:
+    using Key = std::array<float, 10>;
+
+    struct Entry {
+        Warp warp;
+        uint64_t lastUse = 0;
+    };
+
+    void evict();
+
+    std::map<Key, Entry> entries_;
+    uint64_t useCounter_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CORNERWARPCACHE_H
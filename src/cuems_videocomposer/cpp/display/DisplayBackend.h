@@ -3,6 +3,7 @@
 
 #include "../video/FrameBuffer.h"
 #include "OutputInfo.h"
+#include "SyncLatencyMonitor.h"
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -190,6 +191,93 @@ public:
      */
     virtual void setVideoFramerate(double fps) { (void)fps; }
     
+    /**
+     * Switch outputs to a refresh rate that is an integer multiple of the
+     * video framerate, at their current resolution (removes pulldown judder)
+     * @param fps Framerate of the show
+     * @return true if any output changed mode
+     */
+    virtual bool matchRefreshRate(double fps) { (void)fps; return false; }
+    
+    /**
+     * Variable refresh: outputs scan out each frame when it is flipped,
+     * so the caller paces flips at the content rate
+     * @param fps Content framerate, or 0 to return to fixed refresh
+     * @return true if every output is now in variable refresh at fps
+     */
+    virtual bool setVariableRefresh(double fps) { (void)fps; return false; }
+    
+    /**
+     * Predicted time from now until a frame rendered now reaches the screen
+     * Used to pick frames for their presentation time rather than the
+     * time they are rendered.
+     * @return Nanoseconds, or 0 if the backend has no vsync prediction
+     */
+    virtual int64_t getPresentationLeadNs() const { return 0; }
+    
+    /**
+     * Vblank counter of the vsync a frame rendered now is shown on
+     * @param msc Display vblank counter
+     * @param refreshHz Refresh rate of that display
+     * @return false if the backend has no vblank counter
+     */
+    virtual bool getTargetVblank(int64_t& msc, double& refreshHz) const {
+        (void)msc; (void)refreshHz;
+        return false;
+    }
+    
+    /**
+     * Idle render loop: render() is not called until the loop resumes, and
+     * the outputs keep scanning out the frame last flipped
+     * @param idle Enter (true) or leave idle
+     * @return false if the outputs cannot hold a frame (windows that must
+     *         be redrawn, streams that need every frame); keep rendering
+     */
+    virtual bool setIdle(bool idle) { (void)idle; return false; }
+    
+    /**
+     * Cluster node: the output regions are positions in a canvas of this
+     * size, shared with the other nodes; only this node's outputs' part of
+     * it is allocated and composited (0x0 = off)
+     * @return false if the backend has no virtual canvas
+     */
+    virtual bool setClusterCanvas(int width, int height) { (void)width; (void)height; return false; }
+    
+    /**
+     * Composite the canvas smaller while the GPU is near its frame budget
+     * (MultiOutputRenderer::dynamicResolution)
+     * @param minScale Smallest scale per axis
+     * @return false if the backend has no virtual canvas
+     */
+    virtual bool setDynamicResolution(bool enabled, float minScale) {
+        (void)enabled; (void)minScale;
+        return false;
+    }
+    
+    // ===== Presentation frame log (sync test) =====
+    
+    /**
+     * Log each flip of the primary output with the frame number it shows
+     * @param enabled Start or stop logging (stopping drops unread flips)
+     * @param readback Read the number from the FrameCode strip of the
+     *        composited canvas instead of taking it from setFrameTag()
+     * @return false if the backend has no flip timestamps
+     */
+    virtual bool setFrameLogEnabled(bool enabled, bool readback) {
+        (void)enabled; (void)readback;
+        return false;
+    }
+    
+    /**
+     * Frame number shown by the next rendered frame (-1 = unknown)
+     */
+    virtual void setFrameTag(int64_t tag) { (void)tag; }
+    
+    /**
+     * Move the logged flips, oldest first, to the end of out
+     */
+    virtual void takePresentedFrames(std::vector<PresentedFrame>& out) { (void)out; }
+    
     // ===== Virtual Output / Capture Support =====
     
     /**
@@ -215,6 +303,16 @@ public:
         (void)sinkManager;
     }
     
+    /**
+     * Set the operator preview drawn after each program frame
+     * @param preview Preview renderer (not owned; nullptr = none)
+     * @return false if this backend draws no preview
+     */
+    virtual bool setPreviewRenderer(class PreviewRenderer* preview) {
+        (void)preview;
+        return false;
+    }
+    
     /**
      * Set resolution mode for all outputs
      * @param mode Mode string: "native", "maximum", "1080p", "720p", "4k"
@@ -267,6 +365,20 @@ public:
      * @return Reference to the renderer, or nullptr if not initialized
      */
     virtual OpenGLRenderer* getRenderer() { return nullptr; }
+    
+    /**
+     * Move CPU-frame texture uploads to a dedicated thread with a shared
+     * EGL context (see TextureUploader)
+     * @return true if the upload thread is running
+     */
+    virtual bool enableUploadThread() { return false; }
+
+    /**
+     * Hardware-decoded frames are handed over as their DMA-BUF
+     * (GPUTextureFrameBuffer::setExternalDmaBuf) instead of GL textures
+     * @return true if this backend imports them itself (VulkanDisplay)
+     */
+    virtual bool importsDmaBuf() const { return false; }
 
 #ifdef HAVE_EGL
     /**
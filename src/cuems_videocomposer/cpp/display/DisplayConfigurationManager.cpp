@@ -3,6 +3,7 @@
  */
 
 #include "DisplayConfigurationManager.h"
+#include "GridWarpMesh.h"
 #include "../utils/Logger.h"
 
 #include <fstream>
@@ -269,6 +270,21 @@ std::vector<OutputRegion> DisplayConfigurationManager::generateOutputRegions(
             }
         }
         
+        // Calibration grid, tessellated by the blit
+        if (customConfig && customConfig->warpEnabled && !customConfig->warpMeshPath.empty()) {
+            auto mesh = std::make_shared<GridWarpMesh>();
+            if (mesh->loadFromFile(customConfig->warpMeshPath)) {
+                region.warpMesh = mesh;
+            } else {
+                LOG_WARNING << "DisplayConfigurationManager: Output " << out.name
+                            << " shown unwarped, mesh not loaded: " << customConfig->warpMeshPath;
+            }
+            region.warpMeshPath = customConfig->warpMeshPath;
+        }
+        if (customConfig) {
+            region.dynamicResolution = customConfig->dynamicResolution;
+        }
+        
         regions.push_back(region);
     }
     
@@ -395,7 +411,13 @@ bool DisplayConfigurationManager::saveToFile(const std::string& path) const {
         file << "blend=" << out.blend.left << "," << out.blend.right
              << "," << out.blend.top << "," << out.blend.bottom
              << "," << out.blend.gamma << "\n";
+        if (out.warpEnabled && !out.warpMeshPath.empty()) {
+            file << "warp_mesh=" << out.warpMeshPath << "\n";
+        }
         file << "enabled=" << (out.enabled ? "true" : "false") << "\n";
+        if (!out.dynamicResolution) {
+            file << "dynamic_resolution=false\n";
+        }
         file << "\n";
     }
     
@@ -471,8 +493,13 @@ bool DisplayConfigurationManager::loadFromFile(const std::string& path) {
                        &out->blend.left, &out->blend.right,
                        &out->blend.top, &out->blend.bottom,
                        &out->blend.gamma);
+            } else if (key == "warp_mesh") {
+                out->warpMeshPath = value;
+                out->warpEnabled = !value.empty();
             } else if (key == "enabled") {
                 out->enabled = (value == "true" || value == "1");
+            } else if (key == "dynamic_resolution") {
+                out->dynamicResolution = (value == "true" || value == "1");
             }
         }
     }
@@ -70,6 +70,7 @@ struct OutputConfiguration {
     
     // Status
     bool enabled = true;
+    bool dynamicResolution = true;  // false: keeps the canvas at native size while shown
 };
 
 /**
@@ -0,0 +1,44 @@
+#include "DrawOrder.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+bool DrawOrder::overlaps(const Item& a, const Item& b) {
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+void DrawOrder::groupByState(const std::vector<Item>& items, std::vector<size_t>& order) {
+    order.clear();
+    std::vector<size_t> pending(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        pending[i] = i;
+    }
+    
+    while (!pending.empty()) {
+        // The first pending item may always draw next; a later one only if
+        // it overlaps none of the items it would jump
+        size_t pick = 0;
+        if (!order.empty() && items[pending[0]].stateKey != items[order.back()].stateKey) {
+            uint32_t key = items[order.back()].stateKey;
+            size_t end = std::min(pending.size(), LOOKAHEAD + 1);
+            for (size_t j = 1; j < end; ++j) {
+                const Item& candidate = items[pending[j]];
+                if (candidate.stateKey != key) {
+                    continue;
+                }
+                bool disjoint = true;
+                for (size_t k = 0; k < j && disjoint; ++k) {
+                    disjoint = !overlaps(candidate, items[pending[k]]);
+                }
+                if (disjoint) {
+                    pick = j;
+                    break;
+                }
+            }
+        }
+        order.push_back(pending[pick]);
+        pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(pick));
+    }
+}
+
+} // namespace videocomposer
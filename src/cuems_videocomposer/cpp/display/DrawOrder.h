@@ -0,0 +1,45 @@
+#ifndef VIDEOCOMPOSER_DRAWORDER_H
+#define VIDEOCOMPOSER_DRAWORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * DrawOrder - Reorders layer draws so equal GL state comes out adjacent
+ *
+ * Layers draw back to front, but only layers that overlap on screen must
+ * keep that order: disjoint ones (a row of logos, a grid of inputs) give
+ * the same image in any order. A layer whose state matches the previous
+ * draw is moved ahead of the layers it does not touch, so plain layers
+ * join one instanced batch and program/blend switches between
+ * alternating layer kinds drop out.
+ */
+class DrawOrder {
+public:
+    struct Item {
+        uint32_t stateKey = 0;  // Equal keys draw with the same program and blending
+        float x0 = 0.0f;        // Screen bounds (any space, the same for all items)
+        float y0 = 0.0f;
+        float x1 = 0.0f;
+        float y1 = 0.0f;
+    };
+
+    /** How far ahead (in pending layers) a matching layer is looked for */
+    static const size_t LOOKAHEAD = 16;
+
+    /**
+     * Draw order for items given back to front: indices into items, every
+     * pair of overlapping items kept in its original order
+     */
+    static void groupByState(const std::vector<Item>& items, std::vector<size_t>& order);
+
+    /** True if the bounds share area (touching edges do not count) */
+    static bool overlaps(const Item& a, const Item& b);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DRAWORDER_H
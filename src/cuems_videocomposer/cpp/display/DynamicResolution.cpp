@@ -0,0 +1,99 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+DynamicResolution::DynamicResolution()
+    : enabled_(false)
+    , minScale_(DEFAULT_MIN_SCALE)
+    , budgetMs_(1000.0 / 60.0)
+    , scale_(1.0f)
+    , over_(0)
+    , under_(0)
+    , settle_(0)
+    , changes_(0)
+{
+}
+
+void DynamicResolution::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    if (!enabled) {
+        reset();
+    }
+}
+
+void DynamicResolution::setMinScale(float scale) {
+    // Whole steps only, so every scale reached is one
+    float steps = std::floor(std::min(std::max(scale, STEP), 1.0f) / STEP + 0.5f);
+    minScale_ = steps * STEP;
+    if (scale_ < minScale_) {
+        setScale(minScale_);
+    }
+}
+
+void DynamicResolution::setBudget(double budgetMs) {
+    budgetMs_ = budgetMs > 0.0 ? budgetMs : 1000.0 / 60.0;
+}
+
+bool DynamicResolution::update(double gpuMs) {
+    if (!enabled_ || gpuMs <= 0.0) {
+        return false;
+    }
+    if (settle_ > 0) {
+        --settle_;
+        return false;
+    }
+
+    if (gpuMs > HIGH_WATER * budgetMs_) {
+        under_ = 0;
+        if (++over_ < DOWN_FRAMES || scale_ <= minScale_) {
+            return false;
+        }
+        // Cost follows the pixel count, the square of the scale
+        float fit = scale_ * static_cast<float>(std::sqrt(TARGET * budgetMs_ / gpuMs));
+        float next = std::floor(fit / STEP) * STEP;
+        setScale(std::max(minScale_, std::min(next, scale_ - STEP)));
+        return true;
+    }
+
+    over_ = 0;
+    if (scale_ >= 1.0f) {
+        under_ = 0;
+        return false;
+    }
+    float up = std::min(1.0f, scale_ + STEP);
+    double predicted = gpuMs * (up * up) / (scale_ * scale_);
+    if (predicted >= LOW_WATER * budgetMs_) {
+        under_ = 0;
+        return false;
+    }
+    if (++under_ < UP_FRAMES) {
+        return false;
+    }
+    setScale(up);
+    return true;
+}
+
+void DynamicResolution::reset() {
+    scale_ = 1.0f;
+    over_ = 0;
+    under_ = 0;
+    settle_ = 0;
+}
+
+int DynamicResolution::scaledSize(int size, float scale) {
+    return std::max(1, static_cast<int>(std::lround(size * static_cast<double>(scale))));
+}
+
+void DynamicResolution::setScale(float scale) {
+    if (scale != scale_) {
+        scale_ = scale;
+        ++changes_;
+    }
+    over_ = 0;
+    under_ = 0;
+    settle_ = SETTLE_FRAMES;
+}
+
+} // namespace videocomposer
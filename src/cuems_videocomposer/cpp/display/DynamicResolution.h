@@ -0,0 +1,76 @@
+#ifndef VIDEOCOMPOSER_DYNAMICRESOLUTION_H
+#define VIDEOCOMPOSER_DYNAMICRESOLUTION_H
+
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * DynamicResolution - Canvas render scale that keeps the GPU within its frame budget
+ *
+ * Fed the GPU time of each rendered frame (read back from the timer
+ * queries, frames late). Over HIGH_WATER of the budget for DOWN_FRAMES
+ * frames in a row, the scale drops in one go to what should fit the
+ * TARGET share of it (cost taken as proportional to the pixels drawn);
+ * under LOW_WATER even at the next step up for UP_FRAMES frames in a
+ * row, it rises one STEP. Samples of the SETTLE_FRAMES after a change
+ * were still drawn at the old scale and are ignored.
+ *
+ * Scales are multiples of STEP between the minimum and 1 (native).
+ */
+class DynamicResolution {
+public:
+    static constexpr float STEP = 0.125f;
+    static constexpr float DEFAULT_MIN_SCALE = 0.5f;
+    static constexpr double HIGH_WATER = 0.9;
+    static constexpr double TARGET = 0.75;
+    static constexpr double LOW_WATER = 0.7;
+    static constexpr int DOWN_FRAMES = 3;
+    static constexpr int UP_FRAMES = 90;
+    static constexpr int SETTLE_FRAMES = 6;      // GpuTimer::FRAMES_IN_FLIGHT and a margin
+
+    DynamicResolution();
+
+    /** Off: back to native at once */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+    void setMinScale(float scale);
+    float getMinScale() const { return minScale_; }
+
+    /** GPU time per output frame (the refresh period) */
+    void setBudget(double budgetMs);
+    double getBudget() const { return budgetMs_; }
+
+    /**
+     * GPU time of a frame
+     * @return true if the scale changed
+     */
+    bool update(double gpuMs);
+
+    float getScale() const { return scale_; }
+
+    /** Native again, counters cleared (e.g. a new canvas) */
+    void reset();
+
+    uint64_t getChangeCount() const { return changes_; }
+
+    /** Scaled pixel count of a canvas side, at least 1 */
+    static int scaledSize(int size, float scale);
+
+private:
+    void setScale(float scale);
+
+    bool enabled_;
+    float minScale_;
+    double budgetMs_;
+    float scale_;
+    int over_;
+    int under_;
+    int settle_;
+    uint64_t changes_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DYNAMICRESOLUTION_H
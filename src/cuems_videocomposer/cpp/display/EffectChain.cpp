@@ -0,0 +1,81 @@
+#include "EffectChain.h"
+#include "VideoShaders.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+namespace {
+
+// The kernel reaches three sigmas: a radius of r pixels is sigma r / 3
+constexpr float SIGMAS_PER_RADIUS = 3.0f;
+constexpr float MIN_SIGMA = 0.3f;
+
+static_assert(EffectChain::MAX_TAPS == VideoShaders::EFFECT_MAX_TAPS, "blur shader tap arrays");
+
+} // namespace
+
+EffectChain::Plan EffectChain::plan(const LayerProperties::Effects& effects, int sourceWidth, int sourceHeight) {
+    Plan plan;
+    plan.fused = effects.isActive();
+
+    float radius = 0.0f;
+    if (effects.blurRadius >= 0.5f) {
+        radius = effects.blurRadius;
+        plan.filterWeight = 1.0f;
+    } else if (effects.sharpenAmount > 0.0f) {
+        radius = std::max(effects.sharpenRadius, 1.0f);
+        plan.filterWeight = -effects.sharpenAmount;
+    }
+    if (radius <= 0.0f || sourceWidth <= 0 || sourceHeight <= 0) {
+        plan.filterWeight = 0.0f;
+        return plan;
+    }
+
+    // Smallest size, from half down, that holds the kernel in MAX_TAPS taps
+    float sigma = radius / SIGMAS_PER_RADIUS;
+    plan.shift = 1;
+    while (plan.shift < MAX_SHIFT &&
+           std::ceil(SIGMAS_PER_RADIUS * sigma / static_cast<float>(1 << plan.shift)) > 2 * MAX_TAPS) {
+        ++plan.shift;
+    }
+    int scale = 1 << plan.shift;
+    plan.width = std::max(1, (sourceWidth + scale - 1) / scale);
+    plan.height = std::max(1, (sourceHeight + scale - 1) / scale);
+    plan.taps = gaussianTaps(sigma / static_cast<float>(scale), plan.offsets, plan.weights);
+    plan.filter = true;
+    return plan;
+}
+
+int EffectChain::gaussianTaps(float sigma, float offsets[MAX_TAPS + 1], float weights[MAX_TAPS + 1]) {
+    sigma = std::max(sigma, MIN_SIGMA);
+    int reach = std::min(static_cast<int>(std::ceil(SIGMAS_PER_RADIUS * sigma)), 2 * MAX_TAPS);
+
+    // Discrete kernel over 0..reach (one side), normalized over both sides
+    float texel[2 * MAX_TAPS + 2] = {};
+    float sum = 0.0f;
+    for (int i = 0; i <= reach; ++i) {
+        texel[i] = std::exp(-0.5f * (i * i) / (sigma * sigma));
+        sum += i == 0 ? texel[i] : 2.0f * texel[i];
+    }
+    for (int i = 0; i <= reach; ++i) {
+        texel[i] /= sum;
+    }
+
+    offsets[0] = 0.0f;
+    weights[0] = texel[0];
+    int taps = 0;
+    for (int i = 1; i <= reach; i += 2) {
+        float weight = texel[i] + texel[i + 1];
+        ++taps;
+        weights[taps] = weight;
+        offsets[taps] = weight > 0.0f ? (i * texel[i] + (i + 1) * texel[i + 1]) / weight : static_cast<float>(i);
+    }
+    for (int i = taps + 1; i <= MAX_TAPS; ++i) {
+        offsets[i] = 0.0f;
+        weights[i] = 0.0f;
+    }
+    return taps;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,56 @@
+#ifndef VIDEOCOMPOSER_EFFECTCHAIN_H
+#define VIDEOCOMPOSER_EFFECTCHAIN_H
+
+#include "../layer/LayerProperties.h"
+
+namespace videocomposer {
+
+/**
+ * EffectChain - Plans a layer's effects into the fewest GL passes
+ *
+ * Chroma key and vignette are per pixel: they run in the layer's own draw
+ * (FEATURE_EFFECTS), no pass of their own. Blur and sharpen need the
+ * neighbourhood: the layer's source is drawn into a pooled target at
+ * reduced size (half at least, smaller for wide blurs so the kernel stays
+ * within MAX_TAPS bilinear taps), blurred there across and down, and the
+ * layer's draw mixes its own sample with that (blur: replaced; sharpen:
+ * unsharp mask, pushed away from it).
+ *
+ * Chain order: filter, key, vignette. The key uses the unfiltered colour,
+ * so keyed edges stay sharp under a blur.
+ */
+class EffectChain {
+public:
+    static constexpr int MAX_TAPS = 8;    // Bilinear taps per side, two texels each
+    static constexpr int MAX_SHIFT = 4;   // Intermediates down to 1/16 size
+    static constexpr int TEXTURE_UNIT = 5;  // Filtered source (after the LUT and blend destination)
+
+    struct Plan {
+        bool fused = false;          // The layer draw runs the effect stage
+        bool filter = false;         // Blur/sharpen passes before the layer draw
+        float filterWeight = 0.0f;   // mix(sample, filtered, weight): 1 = blur, < 0 = sharpen
+        int shift = 0;               // Intermediate = source size >> shift (rounded up)
+        int width = 0;
+        int height = 0;
+        int taps = 0;                // Taps per side besides the centre
+        float offsets[MAX_TAPS + 1] = {};  // In intermediate texels ([0] = centre)
+        float weights[MAX_TAPS + 1] = {};  // Sum of the centre and twice the rest is 1
+
+        /** Draws before the layer's own: source, across, down */
+        int passes() const { return filter ? 3 : 0; }
+    };
+
+    /** Plan for a layer source of sourceWidth x sourceHeight */
+    static Plan plan(const LayerProperties::Effects& effects, int sourceWidth, int sourceHeight);
+
+    /**
+     * Half of a normalized Gaussian as bilinear taps: two neighbouring
+     * texels per tap, read at the offset between them that weighs both right
+     * @return Taps besides the centre (at most MAX_TAPS)
+     */
+    static int gaussianTaps(float sigma, float offsets[MAX_TAPS + 1], float weights[MAX_TAPS + 1]);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_EFFECTCHAIN_H
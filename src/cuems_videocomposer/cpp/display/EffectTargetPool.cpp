@@ -0,0 +1,128 @@
+#include "EffectTargetPool.h"
+#include "../utils/Logger.h"
+#include "../video/MemoryBudget.h"
+#include <GL/glew.h>
+
+namespace videocomposer {
+
+namespace {
+
+size_t targetBytes(int width, int height) {
+    return static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+}
+
+EffectTargetPool::Backend glBackend() {
+    const MemoryBudget::Account account(MemoryBudget::Subsystem::EFFECT_TARGETS, MemoryBudget::NO_LAYER);
+    EffectTargetPool::Backend backend;
+    backend.create = [account](int width, int height, EffectTargetPool::Target& target) {
+        if (!MemoryBudget::instance().reserve(account, targetBytes(width, height))) {
+            return false;
+        }
+        GLint previous = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+        glGenTextures(1, &target.texture);
+        glBindTexture(GL_TEXTURE_2D, target.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenFramebuffers(1, &target.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            LOG_ERROR << "Effect target FBO is not complete: 0x" << std::hex << status;
+            glDeleteFramebuffers(1, &target.fbo);
+            glDeleteTextures(1, &target.texture);
+            MemoryBudget::instance().release(account, targetBytes(width, height));
+            target = EffectTargetPool::Target();
+            return false;
+        }
+        return true;
+    };
+    backend.destroy = [account](const EffectTargetPool::Target& target) {
+        glDeleteFramebuffers(1, &target.fbo);
+        glDeleteTextures(1, &target.texture);
+        MemoryBudget::instance().release(account, targetBytes(target.width, target.height));
+    };
+    return backend;
+}
+
+} // namespace
+
+EffectTargetPool::EffectTargetPool()
+    : EffectTargetPool(glBackend())
+{
+}
+
+EffectTargetPool::EffectTargetPool(const Backend& backend)
+    : backend_(backend)
+{
+}
+
+EffectTargetPool::~EffectTargetPool() {
+    clear();
+}
+
+const EffectTargetPool::Target* EffectTargetPool::acquire(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return nullptr;
+    }
+    for (auto& entry : entries_) {
+        if (!entry->inUse && entry->target.width == width && entry->target.height == height) {
+            entry->inUse = true;
+            entry->lastUsed = frame_;
+            ++reused_;
+            return &entry->target;
+        }
+    }
+    auto entry = std::make_unique<Entry>();
+    if (!backend_.create(width, height, entry->target)) {
+        return nullptr;
+    }
+    entry->target.width = width;
+    entry->target.height = height;
+    entry->inUse = true;
+    entry->lastUsed = frame_;
+    ++created_;
+    entries_.push_back(std::move(entry));
+    return &entries_.back()->target;
+}
+
+void EffectTargetPool::release(const Target* target) {
+    if (!target) {
+        return;
+    }
+    for (auto& entry : entries_) {
+        if (&entry->target == target) {
+            entry->inUse = false;
+            entry->lastUsed = frame_;
+            return;
+        }
+    }
+}
+
+void EffectTargetPool::endFrame() {
+    ++frame_;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        Entry& entry = **it;
+        if (!entry.inUse && frame_ - entry.lastUsed > IDLE_FRAMES) {
+            backend_.destroy(entry.target);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void EffectTargetPool::clear() {
+    for (auto& entry : entries_) {
+        backend_.destroy(entry->target);
+    }
+    entries_.clear();
+}
+
+} // namespace videocomposer
@@ -0,0 +1,86 @@
+#ifndef VIDEOCOMPOSER_EFFECTTARGETPOOL_H
+#define VIDEOCOMPOSER_EFFECTTARGETPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Forward declaration to avoid including OpenGL headers here
+typedef unsigned int GLuint;
+
+namespace videocomposer {
+
+/**
+ * EffectTargetPool - Render targets for layer effect passes, shared by layers
+ *
+ * A layer's blur passes need two intermediates only until its own draw;
+ * the next layer with the same intermediate size gets the same ones back.
+ * Passes run in order on one context, so a target is reusable as soon as
+ * it is released (no fence, unlike TexturePool). Targets not used for
+ * IDLE_FRAMES composites are deleted.
+ *
+ * Must be used (and destroyed) with the owning GL context current.
+ */
+class EffectTargetPool {
+public:
+    struct Target {
+        GLuint fbo = 0;
+        GLuint texture = 0;   // RGBA8, linear filtering, clamped
+        int width = 0;
+        int height = 0;
+    };
+
+    /**
+     * GL calls behind the pool (replaced in tests)
+     */
+    struct Backend {
+        std::function<bool(int width, int height, Target& target)> create;
+        std::function<void(const Target& target)> destroy;
+    };
+
+    static constexpr uint64_t IDLE_FRAMES = 120;
+
+    /** Pool for the current GL context */
+    EffectTargetPool();
+    explicit EffectTargetPool(const Backend& backend);
+    ~EffectTargetPool();
+
+    EffectTargetPool(const EffectTargetPool&) = delete;
+    EffectTargetPool& operator=(const EffectTargetPool&) = delete;
+
+    /**
+     * Free target of exactly this size, a new one if none is
+     * @return nullptr if the target cannot be created
+     */
+    const Target* acquire(int width, int height);
+    void release(const Target* target);
+
+    /** End of a composite: deletes targets idle for IDLE_FRAMES */
+    void endFrame();
+
+    /** Delete every target (none may be in use) */
+    void clear();
+
+    size_t getTargetCount() const { return entries_.size(); }
+    uint64_t getCreatedCount() const { return created_; }
+    uint64_t getReuseCount() const { return reused_; }
+
+private:
+    struct Entry {
+        Target target;
+        bool inUse = false;
+        uint64_t lastUsed = 0;
+    };
+
+    Backend backend_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+    uint64_t frame_ = 0;
+    uint64_t created_ = 0;
+    uint64_t reused_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_EFFECTTARGETPOOL_H
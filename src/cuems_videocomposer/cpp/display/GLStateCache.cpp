@@ -0,0 +1,131 @@
+#include "GLStateCache.h"
+#include <GL/glew.h>
+
+namespace videocomposer {
+
+namespace {
+
+GLStateCache::Backend glBackend() {
+    GLStateCache::Backend backend;
+    backend.useProgram = [](GLuint program) { glUseProgram(program); };
+    backend.bindVertexArray = [](GLuint vao) { glBindVertexArray(vao); };
+    backend.setBlend = [](bool enabled) {
+        if (enabled) {
+            glEnable(GL_BLEND);
+        } else {
+            glDisable(GL_BLEND);
+        }
+    };
+    backend.blendFunc = [](GLenum src, GLenum dst) { glBlendFunc(src, dst); };
+    backend.activeTexture = [](GLuint unit) { glActiveTexture(GL_TEXTURE0 + unit); };
+    backend.bindTexture2D = [](GLuint texture) { glBindTexture(GL_TEXTURE_2D, texture); };
+    return backend;
+}
+
+} // namespace
+
+GLStateCache::GLStateCache()
+    : GLStateCache(glBackend())
+{
+}
+
+GLStateCache::GLStateCache(const Backend& backend)
+    : backend_(backend)
+{
+}
+
+void GLStateCache::useProgram(GLuint program) {
+    if (programKnown_ && program_ == program) {
+        ++skipped_;
+        return;
+    }
+    backend_.useProgram(program);
+    program_ = program;
+    programKnown_ = true;
+    ++issued_;
+}
+
+void GLStateCache::bindVertexArray(GLuint vao) {
+    if (vaoKnown_ && vao_ == vao) {
+        ++skipped_;
+        return;
+    }
+    backend_.bindVertexArray(vao);
+    vao_ = vao;
+    vaoKnown_ = true;
+    ++issued_;
+}
+
+void GLStateCache::setBlend(bool enabled) {
+    if (blendKnown_ && blend_ == enabled) {
+        ++skipped_;
+        return;
+    }
+    backend_.setBlend(enabled);
+    blend_ = enabled;
+    blendKnown_ = true;
+    ++issued_;
+}
+
+void GLStateCache::blendFunc(GLenum src, GLenum dst) {
+    if (blendFuncKnown_ && blendSrc_ == src && blendDst_ == dst) {
+        ++skipped_;
+        return;
+    }
+    backend_.blendFunc(src, dst);
+    blendSrc_ = src;
+    blendDst_ = dst;
+    blendFuncKnown_ = true;
+    ++issued_;
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLuint texture) {
+    bool tracked = unit < static_cast<GLuint>(MAX_TEXTURE_UNITS);
+    if (tracked && texturesKnown_[unit] && textures_[unit] == texture &&
+        activeUnitKnown_ && activeUnit_ == unit) {
+        ++skipped_;
+        return;
+    }
+    if (!activeUnitKnown_ || activeUnit_ != unit) {
+        backend_.activeTexture(unit);
+        activeUnit_ = unit;
+        activeUnitKnown_ = true;
+        ++issued_;
+    }
+    if (tracked && texturesKnown_[unit] && textures_[unit] == texture) {
+        ++skipped_;
+        return;
+    }
+    backend_.bindTexture2D(texture);
+    if (tracked) {
+        textures_[unit] = texture;
+        texturesKnown_[unit] = true;
+    }
+    ++issued_;
+}
+
+void GLStateCache::unbindTextures() {
+    // Highest unit first, so unit 0 is left active
+    for (int unit = MAX_TEXTURE_UNITS - 1; unit >= 0; --unit) {
+        if (texturesKnown_[unit] && textures_[unit] != 0) {
+            bindTexture(static_cast<GLuint>(unit), 0);
+        }
+    }
+}
+
+void GLStateCache::invalidate() {
+    programKnown_ = false;
+    vaoKnown_ = false;
+    blendKnown_ = false;
+    blendFuncKnown_ = false;
+    invalidateTextures();
+}
+
+void GLStateCache::invalidateTextures() {
+    activeUnitKnown_ = false;
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+        texturesKnown_[unit] = false;
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,93 @@
+#ifndef VIDEOCOMPOSER_GLSTATECACHE_H
+#define VIDEOCOMPOSER_GLSTATECACHE_H
+
+#include <cstdint>
+#include <functional>
+
+// Forward declaration to avoid including OpenGL headers here
+typedef unsigned int GLuint;
+typedef unsigned int GLenum;
+
+namespace videocomposer {
+
+/**
+ * GLStateCache - Skips redundant program, VAO, blend and texture state changes
+ *
+ * Consecutive layer draws mostly use the same program, the same quad VAO
+ * and normal blending; re-issuing those per draw is pure driver overhead
+ * (validation on every state change, on Mesa especially). The renderer
+ * sets that state through here, and only changes reach the GL.
+ *
+ * The cache only knows the state it set. Anything else drawing on the
+ * context (output blits, capture, another surface's frame) may change it,
+ * so callers invalidate() at the start of each pass. Uploads and LUT
+ * binds inside a pass bind 2D textures themselves; invalidateTextures()
+ * after those keeps the program and blend state known.
+ */
+class GLStateCache {
+public:
+    /**
+     * GL calls behind the cache (replaced in tests)
+     */
+    struct Backend {
+        std::function<void(GLuint program)> useProgram;
+        std::function<void(GLuint vao)> bindVertexArray;
+        std::function<void(bool enabled)> setBlend;
+        std::function<void(GLenum src, GLenum dst)> blendFunc;
+        std::function<void(GLuint unit)> activeTexture;
+        std::function<void(GLuint texture)> bindTexture2D;
+    };
+
+    /** Texture units whose GL_TEXTURE_2D binding is tracked */
+    static const int MAX_TEXTURE_UNITS = 8;
+
+    /** Cache for the current GL context */
+    GLStateCache();
+    explicit GLStateCache(const Backend& backend);
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void setBlend(bool enabled);
+    void blendFunc(GLenum src, GLenum dst);
+
+    /**
+     * Bind a GL_TEXTURE_2D on a unit (0-based); leaves that unit active.
+     * Units past MAX_TEXTURE_UNITS always reach the GL.
+     */
+    void bindTexture(GLuint unit, GLuint texture);
+
+    /** Bind 0 on every unit this cache bound a texture on */
+    void unbindTextures();
+
+    /** Forget everything: the next call of each kind reaches the GL */
+    void invalidate();
+
+    /** Forget the active unit and texture bindings only */
+    void invalidateTextures();
+
+    /** State changes passed to the GL / dropped as redundant */
+    uint64_t getIssued() const { return issued_; }
+    uint64_t getSkipped() const { return skipped_; }
+
+private:
+    Backend backend_;
+    GLuint program_ = 0;
+    GLuint vao_ = 0;
+    bool blend_ = false;
+    GLenum blendSrc_ = 0;
+    GLenum blendDst_ = 0;
+    bool programKnown_ = false;
+    bool vaoKnown_ = false;
+    bool blendKnown_ = false;
+    bool blendFuncKnown_ = false;
+    GLuint activeUnit_ = 0;
+    bool activeUnitKnown_ = false;
+    GLuint textures_[MAX_TEXTURE_UNITS] = {};
+    bool texturesKnown_[MAX_TEXTURE_UNITS] = {};
+    uint64_t issued_ = 0;
+    uint64_t skipped_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_GLSTATECACHE_H
@@ -0,0 +1,163 @@
+#include "GpuTimer.h"
+#include "../utils/Logger.h"
+#include <GL/glew.h>
+#include <algorithm>
+
+namespace videocomposer {
+
+GpuTimer::GpuTimer()
+    : current_(0)
+    , available_(false)
+    , enabled_(true)
+    , frameOpen_(false)
+    , droppedFrames_(0)
+{
+}
+
+GpuTimer::~GpuTimer() {
+    // Queries belong to the context: cleanup() runs while it is current
+}
+
+bool GpuTimer::init() {
+    if (available_) {
+        return true;
+    }
+    if (!(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) {
+        LOG_INFO << "GpuTimer: timer queries not supported, GPU timings off";
+        return false;
+    }
+
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0) {
+        LOG_INFO << "GpuTimer: GL_TIMESTAMP has no counter bits, GPU timings off";
+        return false;
+    }
+
+    for (QuerySet& set : sets_) {
+        glGenQueries(MAX_SECTIONS * 2, set.queries);
+        set.count = 0;
+        set.lastQuery = -1;
+    }
+    current_ = 0;
+    available_ = true;
+    LOG_INFO << "GpuTimer: " << FRAMES_IN_FLIGHT << " query sets of " << MAX_SECTIONS << " sections";
+    return true;
+}
+
+void GpuTimer::cleanup() {
+    if (!available_) {
+        return;
+    }
+    for (QuerySet& set : sets_) {
+        glDeleteQueries(MAX_SECTIONS * 2, set.queries);
+        std::fill(std::begin(set.queries), std::end(set.queries), 0u);
+        set.count = 0;
+        set.lastQuery = -1;
+    }
+    available_ = false;
+    frameOpen_ = false;
+}
+
+void GpuTimer::setEnabled(bool enabled) {
+    if (enabled == enabled_) {
+        return;
+    }
+    enabled_ = enabled;
+    // Sets written before a pause say nothing about the frames after it
+    for (QuerySet& set : sets_) {
+        set.count = 0;
+        set.lastQuery = -1;
+    }
+    stats_.reset();
+}
+
+void GpuTimer::beginFrame() {
+    if (!isActive()) {
+        return;
+    }
+    current_ = (current_ + 1) % FRAMES_IN_FLIGHT;
+    QuerySet& set = sets_[current_];
+    collect(set);
+    set.count = 0;
+    set.lastQuery = -1;
+    frameOpen_ = true;
+}
+
+int GpuTimer::begin(const char* name, int id) {
+    if (!isActive()) {
+        return NO_SECTION;
+    }
+    QuerySet& set = sets_[current_];
+    if (set.count >= MAX_SECTIONS) {
+        return NO_SECTION;
+    }
+    int section = set.count++;
+    set.sections[section].name = name;
+    set.sections[section].id = id;
+    set.sections[section].ended = false;
+    glQueryCounter(set.queries[section * 2], GL_TIMESTAMP);
+    set.lastQuery = std::max(set.lastQuery, section * 2);
+    return section;
+}
+
+void GpuTimer::end(int section) {
+    if (section == NO_SECTION || !isActive()) {
+        return;
+    }
+    QuerySet& set = sets_[current_];
+    if (section >= set.count || set.sections[section].ended) {
+        return;
+    }
+    glQueryCounter(set.queries[section * 2 + 1], GL_TIMESTAMP);
+    set.sections[section].ended = true;
+    set.lastQuery = section * 2 + 1;
+}
+
+void GpuTimer::collect(QuerySet& set) {
+    if (set.count == 0 || set.lastQuery < 0) {
+        return;
+    }
+
+    // Timestamps complete in order: the last one written being ready means
+    // all of them are, and reading them does not wait
+    GLint ready = 0;
+    glGetQueryObjectiv(set.queries[set.lastQuery], GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (!ready) {
+        ++droppedFrames_;
+        return;
+    }
+
+    stats_.beginFrame();
+    GLuint64 frameStart = UINT64_MAX;
+    GLuint64 frameEnd = 0;
+    struct Result { const char* name; int id; double ms; };
+    Result results[MAX_SECTIONS];
+    int resultCount = 0;
+    for (int i = 0; i < set.count; ++i) {
+        const Section& section = set.sections[i];
+        if (!section.ended) {
+            continue;
+        }
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(set.queries[i * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(set.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        if (end < start) {
+            continue;
+        }
+        frameStart = std::min(frameStart, start);
+        frameEnd = std::max(frameEnd, end);
+        results[resultCount++] = {section.name, section.id, static_cast<double>(end - start) / 1.0e6};
+    }
+    if (resultCount == 0) {
+        return;
+    }
+
+    // The whole frame first, so it leads the listings
+    stats_.add("frame", -1, static_cast<double>(frameEnd - frameStart) / 1.0e6);
+    for (int i = 0; i < resultCount; ++i) {
+        stats_.add(results[i].name, results[i].id, results[i].ms);
+    }
+}
+
+} // namespace videocomposer
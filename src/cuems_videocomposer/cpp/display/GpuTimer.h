@@ -0,0 +1,105 @@
+#ifndef VIDEOCOMPOSER_GPUTIMER_H
+#define VIDEOCOMPOSER_GPUTIMER_H
+
+#include "GpuTimingStats.h"
+#include <cstdint>
+
+// Forward declaration for OpenGL types
+typedef unsigned int GLuint;
+
+namespace videocomposer {
+
+/**
+ * GpuTimer - GPU time of render sections from GL timestamp queries
+ *
+ * A section (a layer draw, the master pass, an output blit) writes a
+ * GL_TIMESTAMP query when it starts and another when it ends, so sections
+ * can nest. Each frame uses one of FRAMES_IN_FLIGHT query sets; a set is
+ * read when the renderer comes back around to it, frames later, and
+ * dropped rather than waited for if the GPU has not got there yet.
+ * Results go to stats(), with "frame" spanning the whole set.
+ *
+ * All calls on the thread of the GL context the queries were made in.
+ */
+class GpuTimer {
+public:
+    static constexpr int FRAMES_IN_FLIGHT = 4;
+    static constexpr int MAX_SECTIONS = 64;    // Per frame; later sections are not timed
+    static constexpr int NO_SECTION = -1;
+
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /**
+     * Create the queries (context current)
+     * @return false if the context has no timer queries (GL 3.3 / ARB_timer_query)
+     */
+    bool init();
+    void cleanup();
+
+    bool isAvailable() const { return available_; }
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+    bool isActive() const { return available_ && enabled_; }
+
+    /** Move to the next query set, reading what it held */
+    void beginFrame();
+    void endFrame() { frameOpen_ = false; }
+    bool isFrameOpen() const { return frameOpen_; }
+
+    /** @return Section handle for end(), NO_SECTION if not timed */
+    int begin(const char* name, int id = -1);
+    void end(int section);
+
+    GpuTimingStats& stats() { return stats_; }
+    const GpuTimingStats& stats() const { return stats_; }
+
+    /** Query sets dropped because the GPU was more than FRAMES_IN_FLIGHT behind */
+    uint64_t getDroppedFrames() const { return droppedFrames_; }
+
+    /** Times the rest of the enclosing block */
+    class Scope {
+    public:
+        Scope(GpuTimer& timer, const char* name, int id = -1)
+            : timer_(timer), section_(timer.begin(name, id)) {}
+        ~Scope() { timer_.end(section_); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GpuTimer& timer_;
+        int section_;
+    };
+
+private:
+    struct Section {
+        const char* name = nullptr;
+        int id = -1;
+        bool ended = false;
+    };
+
+    struct QuerySet {
+        GLuint queries[MAX_SECTIONS * 2] = {};
+        Section sections[MAX_SECTIONS];
+        int count = 0;
+        int lastQuery = -1;     // Index of the query written last
+    };
+
+    void collect(QuerySet& set);
+
+    QuerySet sets_[FRAMES_IN_FLIGHT];
+    int current_;
+    bool available_;
+    bool enabled_;
+    bool frameOpen_;
+    uint64_t droppedFrames_;
+    GpuTimingStats stats_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_GPUTIMER_H
@@ -0,0 +1,89 @@
+#include "GpuTimingStats.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace videocomposer {
+
+GpuTimingStats::GpuTimingStats()
+    : frame_(0)
+{
+}
+
+void GpuTimingStats::beginFrame() {
+    ++frame_;
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+        [this](const Entry& entry) { return entry.lastFrame + WINDOW < frame_; }),
+        entries_.end());
+}
+
+void GpuTimingStats::add(const char* name, int id, double ms) {
+    if (!name) {
+        return;
+    }
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+        [name, id](const Entry& entry) { return entry.id == id && entry.name == name; });
+    if (it == entries_.end()) {
+        entries_.emplace_back();
+        it = entries_.end() - 1;
+        it->name = name;
+        it->id = id;
+    }
+    it->samples[it->next] = static_cast<float>(ms);
+    it->next = (it->next + 1) % WINDOW;
+    it->count = std::min(it->count + 1, WINDOW);
+    it->lastFrame = frame_;
+}
+
+GpuTimingStats::Summary GpuTimingStats::summarize(const Entry& entry) const {
+    Summary summary;
+    summary.name = entry.name;
+    summary.id = entry.id;
+    summary.samples = entry.count;
+    if (entry.count == 0) {
+        return summary;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < entry.count; ++i) {
+        sum += entry.samples[i];
+        summary.maxMs = std::max(summary.maxMs, static_cast<double>(entry.samples[i]));
+    }
+    summary.averageMs = sum / static_cast<double>(entry.count);
+    summary.lastMs = entry.samples[(entry.next + WINDOW - 1) % WINDOW];
+    return summary;
+}
+
+std::vector<GpuTimingStats::Summary> GpuTimingStats::getSummaries() const {
+    std::vector<Summary> summaries;
+    summaries.reserve(entries_.size());
+    for (const Entry& entry : entries_) {
+        summaries.push_back(summarize(entry));
+    }
+    return summaries;
+}
+
+bool GpuTimingStats::getSummary(const std::string& name, int id, Summary& out) const {
+    for (const Entry& entry : entries_) {
+        if (entry.id == id && entry.name == name) {
+            out = summarize(entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+void GpuTimingStats::reset() {
+    entries_.clear();
+}
+
+std::string GpuTimingStats::formatLine(const Summary& summary) {
+    char buffer[128];
+    std::string label = summary.name;
+    if (summary.id >= 0) {
+        label += " " + std::to_string(summary.id);
+    }
+    std::snprintf(buffer, sizeof(buffer), "%s: %.2f ms avg, %.2f max",
+                  label.c_str(), summary.averageMs, summary.maxMs);
+    return buffer;
+}
+
+} // namespace videocomposer
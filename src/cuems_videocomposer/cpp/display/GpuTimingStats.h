@@ -0,0 +1,69 @@
+#ifndef VIDEOCOMPOSER_GPUTIMINGSTATS_H
+#define VIDEOCOMPOSER_GPUTIMINGSTATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * GpuTimingStats - Rolling GPU times of named render sections
+ *
+ * A section is a name and an id (layer id, output index; -1 for passes
+ * that exist once, like the master pass). The last WINDOW frames of each
+ * section are kept for the average and the maximum; a section not seen
+ * for a whole window (a removed layer) is dropped.
+ */
+class GpuTimingStats {
+public:
+    static constexpr size_t WINDOW = 120;   // Frames (two seconds at 60 fps)
+
+    struct Summary {
+        std::string name;
+        int id = -1;
+        double lastMs = 0.0;
+        double averageMs = 0.0;
+        double maxMs = 0.0;
+        size_t samples = 0;
+    };
+
+    GpuTimingStats();
+
+    /** Start the next frame's samples (drops sections idle for a window) */
+    void beginFrame();
+
+    /** One sample of a section in the current frame */
+    void add(const char* name, int id, double ms);
+
+    /** All sections, in the order they first appeared */
+    std::vector<Summary> getSummaries() const;
+    bool getSummary(const std::string& name, int id, Summary& out) const;
+
+    uint64_t getFrameCount() const { return frame_; }
+    void reset();
+
+    /** "layer 3: 1.24 ms avg, 2.10 max" */
+    static std::string formatLine(const Summary& summary);
+
+private:
+    struct Entry {
+        std::string name;
+        int id = -1;
+        std::array<float, WINDOW> samples{};
+        size_t count = 0;
+        size_t next = 0;
+        uint64_t lastFrame = 0;
+    };
+
+    Summary summarize(const Entry& entry) const;
+
+    std::vector<Entry> entries_;
+    uint64_t frame_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_GPUTIMINGSTATS_H
@@ -0,0 +1,272 @@
+/**
+ * GridWarpMesh.cpp - Calibration grid tessellation
+ */
+
+#include "GridWarpMesh.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace videocomposer {
+
+namespace {
+
+// Catmull-Rom weights of the four points around a fraction
+void catmullRom(float f, float weights[4]) {
+    float f2 = f * f;
+    float f3 = f2 * f;
+    weights[0] = 0.5f * (-f3 + 2.0f * f2 - f);
+    weights[1] = 0.5f * (3.0f * f3 - 5.0f * f2 + 2.0f);
+    weights[2] = 0.5f * (-3.0f * f3 + 4.0f * f2 + f);
+    weights[3] = 0.5f * (f3 - f2);
+}
+
+// Cell and fraction of a 0-1 position along count grid points
+void locate(float position, int count, int& cell, float& fraction) {
+    float scaled = std::min(std::max(position, 0.0f), 1.0f) * (count - 1);
+    cell = std::min(static_cast<int>(scaled), count - 2);
+    fraction = scaled - cell;
+}
+
+} // namespace
+
+bool GridWarpMesh::setGrid(int columns, int rows, const std::vector<float>& points) {
+    if (columns < 2 || rows < 2 ||
+        points.size() != static_cast<size_t>(columns) * rows * 2) {
+        LOG_WARNING << "GridWarpMesh: Invalid " << columns << "x" << rows << " grid with "
+                    << points.size() / 2 << " points";
+        return false;
+    }
+    columns_ = columns;
+    rows_ = rows;
+    points_ = points;
+    ++revision_;
+    return true;
+}
+
+void GridWarpMesh::setInterpolation(Interpolation interpolation) {
+    if (interpolation != interpolation_) {
+        interpolation_ = interpolation;
+        ++revision_;
+    }
+}
+
+void GridWarpMesh::setTolerance(float pixels) {
+    pixels = std::max(pixels, 0.01f);
+    if (pixels != tolerance_) {
+        tolerance_ = pixels;
+        ++revision_;
+    }
+}
+
+bool GridWarpMesh::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_WARNING << "GridWarpMesh: Cannot open " << path;
+        return false;
+    }
+
+    int columns = 0, rows = 0;
+    Interpolation interpolation = Interpolation::Bicubic;
+    std::vector<float> points;
+    bool header = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        if (!header) {
+            std::string keyword, mode;
+            if (!(fields >> keyword)) {
+                continue;
+            }
+            if (keyword != "grid" || !(fields >> columns >> rows)) {
+                LOG_WARNING << "GridWarpMesh: " << path << " does not start with 'grid <columns> <rows>'";
+                return false;
+            }
+            if (fields >> mode) {
+                if (mode == "bilinear") {
+                    interpolation = Interpolation::Bilinear;
+                } else if (mode != "bicubic") {
+                    LOG_WARNING << "GridWarpMesh: Unknown interpolation '" << mode << "' in " << path;
+                    return false;
+                }
+            }
+            header = true;
+            continue;
+        }
+        float u, v;
+        if (fields >> u >> v) {
+            points.push_back(u);
+            points.push_back(v);
+        }
+    }
+
+    if (!header || !setGrid(columns, rows, points)) {
+        LOG_WARNING << "GridWarpMesh: No usable grid in " << path;
+        return false;
+    }
+    setInterpolation(interpolation);
+    LOG_INFO << "GridWarpMesh: Loaded " << columns << "x" << rows << " grid from " << path;
+    return true;
+}
+
+void GridWarpMesh::point(int column, int row, float& u, float& v) const {
+    // One point past an edge: continued in a straight line, so the bicubic
+    // reproduces straight lines right up to the border
+    if (column < 0 || column >= columns_ || row < 0 || row >= rows_) {
+        int edgeColumn = std::min(std::max(column, 0), columns_ - 1);
+        int edgeRow = std::min(std::max(row, 0), rows_ - 1);
+        int innerColumn = edgeColumn + (column < 0 ? 1 : column >= columns_ ? -1 : 0);
+        int innerRow = edgeRow + (row < 0 ? 1 : row >= rows_ ? -1 : 0);
+        float eu, ev, iu, iv;
+        point(edgeColumn, edgeRow, eu, ev);
+        point(innerColumn, innerRow, iu, iv);
+        u = 2.0f * eu - iu;
+        v = 2.0f * ev - iv;
+        return;
+    }
+    const float* p = &points_[(static_cast<size_t>(row) * columns_ + column) * 2];
+    u = p[0];
+    v = p[1];
+}
+
+void GridWarpMesh::evaluate(float s, float t, float& u, float& v) const {
+    u = s;
+    v = t;
+    if (!isValid()) {
+        return;
+    }
+
+    int column, row;
+    float fs, ft;
+    locate(s, columns_, column, fs);
+    locate(t, rows_, row, ft);
+
+    float ws[4] = {0.0f, 1.0f - fs, fs, 0.0f};
+    float wt[4] = {0.0f, 1.0f - ft, ft, 0.0f};
+    if (interpolation_ == Interpolation::Bicubic) {
+        catmullRom(fs, ws);
+        catmullRom(ft, wt);
+    }
+
+    u = 0.0f;
+    v = 0.0f;
+    for (int j = 0; j < 4; ++j) {
+        if (wt[j] == 0.0f) {
+            continue;
+        }
+        for (int i = 0; i < 4; ++i) {
+            if (ws[i] == 0.0f) {
+                continue;
+            }
+            float pu, pv;
+            point(column - 1 + i, row - 1 + j, pu, pv);
+            u += ws[i] * wt[j] * pu;
+            v += ws[i] * wt[j] * pv;
+        }
+    }
+}
+
+void GridWarpMesh::subdivisions(int outputWidth, int outputHeight,
+                                std::vector<int>& columnSteps, std::vector<int>& rowSteps) const {
+    columnSteps.assign(std::max(columns_ - 1, 0), 1);
+    rowSteps.assign(std::max(rows_ - 1, 0), 1);
+    if (!isValid() || outputWidth <= 0 || outputHeight <= 0) {
+        return;
+    }
+
+    // Distance in output pixels between a warp midpoint and the straight
+    // segment (or triangle diagonal) of its endpoints
+    auto deviation = [&](float sa, float ta, float sb, float tb) {
+        float ua, va, ub, vb, um, vm;
+        evaluate(sa, ta, ua, va);
+        evaluate(sb, tb, ub, vb);
+        evaluate(0.5f * (sa + sb), 0.5f * (ta + tb), um, vm);
+        float du = (um - 0.5f * (ua + ub)) * outputWidth;
+        float dv = (vm - 0.5f * (va + vb)) * outputHeight;
+        return std::sqrt(du * du + dv * dv);
+    };
+    // The error of a straight piece falls with the square of its count
+    auto steps = [&](float error, float cellPixels) {
+        int limit = std::max(1, std::min(MAX_SUBDIVISIONS,
+                                         static_cast<int>(cellPixels / MIN_SEGMENT_PIXELS)));
+        int needed = static_cast<int>(std::ceil(std::sqrt(error / tolerance_)));
+        return std::min(std::max(needed, 1), limit);
+    };
+
+    float cellWidth = static_cast<float>(outputWidth) / (columns_ - 1);
+    float cellHeight = static_cast<float>(outputHeight) / (rows_ - 1);
+    for (int row = 0; row + 1 < rows_; ++row) {
+        float t0 = static_cast<float>(row) / (rows_ - 1);
+        float t1 = static_cast<float>(row + 1) / (rows_ - 1);
+        for (int column = 0; column + 1 < columns_; ++column) {
+            float s0 = static_cast<float>(column) / (columns_ - 1);
+            float s1 = static_cast<float>(column + 1) / (columns_ - 1);
+            float twist = deviation(s0, t0, s1, t1);
+            float across = std::max({deviation(s0, t0, s1, t0), deviation(s0, t1, s1, t1), twist});
+            float along = std::max({deviation(s0, t0, s0, t1), deviation(s1, t0, s1, t1), twist});
+            columnSteps[column] = std::max(columnSteps[column], steps(across, cellWidth));
+            rowSteps[row] = std::max(rowSteps[row], steps(along, cellHeight));
+        }
+    }
+}
+
+bool GridWarpMesh::buildMesh(int outputWidth, int outputHeight,
+                             std::vector<WarpVertex>& vertices,
+                             std::vector<uint32_t>& indices) const {
+    vertices.clear();
+    indices.clear();
+    if (!isValid()) {
+        return false;
+    }
+
+    std::vector<int> columnSteps, rowSteps;
+    subdivisions(outputWidth, outputHeight, columnSteps, rowSteps);
+
+    // Vertex positions along each axis: every grid line plus the subdivisions
+    auto positions = [](const std::vector<int>& cellSteps) {
+        std::vector<float> result;
+        float cells = static_cast<float>(cellSteps.size());
+        for (size_t cell = 0; cell < cellSteps.size(); ++cell) {
+            for (int step = 0; step < cellSteps[cell]; ++step) {
+                result.push_back((cell + static_cast<float>(step) / cellSteps[cell]) / cells);
+            }
+        }
+        result.push_back(1.0f);
+        return result;
+    };
+    std::vector<float> xs = positions(columnSteps);
+    std::vector<float> ys = positions(rowSteps);
+
+    vertices.reserve(xs.size() * ys.size());
+    for (float y : ys) {
+        for (float x : xs) {
+            WarpVertex vertex;
+            vertex.x = x;
+            vertex.y = y;
+            evaluate(x, y, vertex.u, vertex.v);
+            vertices.push_back(vertex);
+        }
+    }
+
+    uint32_t stride = static_cast<uint32_t>(xs.size());
+    indices.reserve((xs.size() - 1) * (ys.size() - 1) * 6);
+    for (uint32_t row = 0; row + 1 < ys.size(); ++row) {
+        for (uint32_t column = 0; column + 1 < stride; ++column) {
+            uint32_t a = row * stride + column;
+            uint32_t b = a + 1;
+            uint32_t c = a + stride;
+            uint32_t d = c + 1;
+            indices.insert(indices.end(), {a, b, d, a, d, c});
+        }
+    }
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,94 @@
+/**
+ * GridWarpMesh.h - Warp mesh from a calibration grid
+ *
+ * Part of the Virtual Canvas architecture for cuems-videocomposer.
+ */
+
+#ifndef VIDEOCOMPOSER_GRIDWARPMESH_H
+#define VIDEOCOMPOSER_GRIDWARPMESH_H
+
+#include "OutputRegion.h"
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * GridWarpMesh - Control grid tessellated into a vertex mesh
+ *
+ * The grid holds, for columns x rows points spread evenly across the
+ * output, the source position each one shows (0-1 in the output's canvas
+ * region, row 0 at the bottom). Between points the warp is interpolated
+ * bilinearly or with a Catmull-Rom bicubic, evaluated on the CPU when the
+ * mesh is built; the GPU then only interpolates per-vertex UVs.
+ *
+ * Density is adaptive: each column and each row of grid cells gets as
+ * many subdivisions as its most curved cell needs for the triangles to
+ * stay within the tolerance. Subdividing whole columns and rows keeps
+ * the mesh free of T-junctions.
+ *
+ * File format (text, '#' starts a comment):
+ *   grid <columns> <rows> [bilinear|bicubic]
+ *   <u> <v>            one line per point, row by row from the bottom
+ */
+class GridWarpMesh : public WarpMesh {
+public:
+    enum class Interpolation { Bilinear, Bicubic };
+
+    static constexpr int MAX_SUBDIVISIONS = 8;   // Per grid cell and axis
+    static constexpr float MIN_SEGMENT_PIXELS = 4.0f;
+
+    GridWarpMesh() = default;
+
+    /**
+     * Set the control grid
+     * @param points columns * rows (u, v) pairs, row by row from the bottom
+     * @return false if the grid is smaller than 2x2 or points are missing
+     */
+    bool setGrid(int columns, int rows, const std::vector<float>& points);
+
+    void setInterpolation(Interpolation interpolation);
+    Interpolation getInterpolation() const { return interpolation_; }
+
+    /**
+     * Largest distance, in output pixels, of the triangles from the
+     * interpolated warp
+     */
+    void setTolerance(float pixels);
+
+    bool loadFromFile(const std::string& path) override;
+    bool isValid() const override { return columns_ >= 2 && rows_ >= 2; }
+    void getDimensions(int& width, int& height) const override {
+        width = columns_;
+        height = rows_;
+    }
+    bool buildMesh(int outputWidth, int outputHeight,
+                   std::vector<WarpVertex>& vertices,
+                   std::vector<uint32_t>& indices) const override;
+    unsigned int revision() const override { return revision_; }
+
+    /**
+     * Interpolated source position at (s, t), 0-1 across the output
+     */
+    void evaluate(float s, float t, float& u, float& v) const;
+
+    /**
+     * Subdivisions per column and per row of grid cells for an output
+     */
+    void subdivisions(int outputWidth, int outputHeight,
+                      std::vector<int>& columnSteps, std::vector<int>& rowSteps) const;
+
+private:
+    int columns_ = 0;
+    int rows_ = 0;
+    std::vector<float> points_;
+    Interpolation interpolation_ = Interpolation::Bicubic;
+    float tolerance_ = 0.5f;
+    unsigned int revision_ = 0;
+
+    void point(int column, int row, float& u, float& v) const;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_GRIDWARPMESH_H
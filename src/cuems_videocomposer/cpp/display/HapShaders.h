@@ -4,7 +4,7 @@
 namespace videocomposer {
 
 // Vertex shader for HAP (compatible with standard renderer uniforms)
-// Uses same uniform names and layout as VideoShaders.h for compatibility
+// Uses same uniform names, layout and USE_* feature macros as VideoShaders.h
 static const char* HAP_VERTEX_SHADER = R"(
 #version 330 core
 
@@ -12,16 +12,17 @@ layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoord;
 
 uniform mat4 uMVP;
+#ifdef USE_HOMOGRAPHY
 uniform mat4 uHomography;
-uniform bool uUseHomography;
+#endif
 
 out vec2 vTexCoord;
 
 void main() {
     vec4 pos = vec4(aPos, 0.0, 1.0);
-    if (uUseHomography) {
-        pos = uHomography * pos;
-    }
+#ifdef USE_HOMOGRAPHY
+    pos = uHomography * pos;
+#endif
     gl_Position = uMVP * pos;
     vTexCoord = aTexCoord;
 }
@@ -105,6 +106,33 @@ void main() {
 }
 )";
 
+// Fragment shader for HAP HDR (BC6H float RGB, linear light)
+// The output is SDR: highlights are compressed (extended Reinhard, white
+// at 4x diffuse white) before the sRGB transfer
+static const char* HAP_HDR_FRAGMENT_SHADER = R"(
+#version 330 core
+
+uniform sampler2D uTexture;
+uniform float uOpacity;
+
+in vec2 vTexCoord;
+out vec4 FragColor;
+
+vec3 linearToSrgb(vec3 c) {
+    return mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, step(vec3(0.0031308), c));
+}
+
+void main() {
+    // Signed BC6H can store negative values
+    vec3 rgb = max(texture(uTexture, vTexCoord).rgb, vec3(0.0));
+
+    const float white = 4.0;
+    vec3 mapped = rgb * (1.0 + rgb / (white * white)) / (1.0 + rgb);
+
+    FragColor = vec4(linearToSrgb(clamp(mapped, 0.0, 1.0)), 1.0) * uOpacity;
+}
+)";
+
 } // namespace videocomposer
 
 #endif // VIDEOCOMPOSER_HAPSHADERS_H
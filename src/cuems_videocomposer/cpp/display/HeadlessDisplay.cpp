@@ -8,10 +8,12 @@
 
 #include "OpenGLRenderer.h"
 #include "../output/FrameCapture.h"
+#include "../output/OutputSinkManager.h"
 #include "../layer/LayerManager.h"
 #include "../layer/VideoLayer.h"
 #include "../osd/OSDManager.h"
 #include "../utils/Logger.h"
+#include "../utils/TimeUtils.h"
 
 #include <GL/glew.h>
 #include <gbm.h>
@@ -180,20 +182,74 @@ void HeadlessDisplay::render(LayerManager* layerManager, OSDManager* osdManager)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     
-    // Render layers
+    // Composite the render list as last published by the layer manager
     if (renderer_ && layerManager) {
-        // Render each visible layer
-        for (size_t i = 0; i < layerManager->getLayerCount(); ++i) {
-            VideoLayer* layer = layerManager->getLayer(static_cast<int>(i));
-            if (layer && layer->properties().visible && layer->isReady()) {
-                renderer_->renderLayer(layer);
-            }
-        }
+        std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+        renderer_->setViewport(0, 0, width_, height_);
+        renderer_->compositeLayers(scene->layers, scene->groups);
+    }
+    
+    if (captureEnabled_ && outputSinkManager_) {
+        captureForVirtualOutputs();
     }
     
     // Unbind FBO
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     
+    // Textures released by this composite go back to the pool
+    if (renderer_) {
+        renderer_->cleanupDeferredTextures();
+    }
+    
+    clearCurrent();
+}
+
+void HeadlessDisplay::setCaptureEnabled(bool enabled, int width, int height) {
+    (void)width; (void)height;  // Always the offscreen surface size
+    captureEnabled_ = enabled;
+    if (!enabled && frameCapture_ && frameCapture_->isInitialized()) {
+        makeCurrent();
+        frameCapture_->cleanup();
+        clearCurrent();
+    }
+}
+
+void HeadlessDisplay::captureForVirtualOutputs() {
+    int64_t now = vc_get_monotonic_time();
+    outputSinkManager_->writeTextureToGpuSinks(offscreenTexture_, width_, height_, now);
+    
+    std::vector<CaptureFormat> formats = outputSinkManager_->getCaptureFormats();
+    if (formats.empty() || !frameCapture_) {
+        return;
+    }
+    if (!frameCapture_->isInitialized()) {
+        if (!frameCapture_->initialize(width_, height_)) {
+            return;
+        }
+        frameCapture_->setSourceFBO(offscreenFBO_);
+        frameCapture_->setReadBuffer(GL_COLOR_ATTACHMENT0);
+        frameCapture_->setLossless(losslessCapture_);
+    }
+    
+    // Earlier frames' readbacks ran while this one was composited
+    writeCompletedCapture();
+    frameCapture_->startCapture();
+}
+
+void HeadlessDisplay::writeCompletedCapture() {
+    FrameData frame;
+    while (frameCapture_->getCompletedFrame(frame)) {
+        outputSinkManager_->writeFrameToFormat(std::move(frame), CaptureFormat());
+    }
+}
+
+void HeadlessDisplay::flushCapture() {
+    if (!initialized_ || !outputSinkManager_ || !frameCapture_ || !frameCapture_->isInitialized()) {
+        return;
+    }
+    makeCurrent();
+    frameCapture_->flush();
+    writeCompletedCapture();
     clearCurrent();
 }
 
@@ -211,6 +267,9 @@ void HeadlessDisplay::resize(unsigned int width, unsigned int height) {
     
     if (initialized_) {
         makeCurrent();
+        if (frameCapture_) {
+            frameCapture_->cleanup();   // Set up again at the new size
+        }
         destroyOffscreenSurface();
         createOffscreenSurface(width_, height_);
         clearCurrent();
@@ -379,6 +438,11 @@ bool HeadlessDisplay::initEGL() {
     };
     
     eglContext_ = eglCreateContext(eglDisplay_, eglConfig_, EGL_NO_CONTEXT, contextAttribs);
+    if (eglContext_ == EGL_NO_CONTEXT) {
+        // No profiles on the GLES API: version 3 only (the renderer needs GLES 3)
+        EGLint versionAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_NONE };
+        eglContext_ = eglCreateContext(eglDisplay_, eglConfig_, EGL_NO_CONTEXT, versionAttribs);
+    }
     if (eglContext_ == EGL_NO_CONTEXT) {
         // Try simpler context
         EGLint simpleAttribs[] = { EGL_NONE };
@@ -9,6 +9,8 @@
  * - Testing
  * 
  * Uses EGL surfaceless context or pbuffer for offscreen rendering.
+ * With an OutputSinkManager the composite feeds the virtual outputs
+ * (the offline render encodes it to a file).
  */
 
 #ifndef VIDEOCOMPOSER_HEADLESSDISPLAY_H
@@ -31,6 +33,7 @@ namespace videocomposer {
 
 class OpenGLRenderer;
 class FrameCapture;
+class OutputSinkManager;
 
 /**
  * HeadlessDisplay - Offscreen rendering without a display
@@ -68,6 +71,12 @@ public:
     
     bool supportsMultiDisplay() const override { return false; }
     
+    // Capture of the offscreen surface for the virtual outputs: GPU sinks
+    // take its texture, CPU sinks fenced RGBA readbacks a few frames behind
+    void setCaptureEnabled(bool enabled, int width = 0, int height = 0) override;
+    bool isCaptureEnabled() const override { return captureEnabled_; }
+    void setOutputSinkManager(OutputSinkManager* sinkManager) override { outputSinkManager_ = sinkManager; }
+    
     void* getContext() override;
     void makeCurrent() override;
     void clearCurrent() override;
@@ -112,6 +121,17 @@ public:
      */
     FrameCapture* getFrameCapture() { return frameCapture_.get(); }
     
+    /**
+     * Wait for a free readback buffer instead of dropping the frame
+     * (offline render)
+     */
+    void setLosslessCapture(bool lossless) { losslessCapture_ = lossless; }
+    
+    /**
+     * Hand the readbacks still in flight to the sinks (after the last frame)
+     */
+    void flushCapture();
+    
 private:
     // DRM/GBM
     int drmFd_ = -1;
@@ -138,6 +158,9 @@ private:
     // Renderer
     std::unique_ptr<OpenGLRenderer> renderer_;
     std::unique_ptr<FrameCapture> frameCapture_;
+    OutputSinkManager* outputSinkManager_ = nullptr;
+    bool captureEnabled_ = false;
+    bool losslessCapture_ = false;
     
     // EGL extension function pointers
 #ifdef HAVE_EGL
@@ -181,6 +204,16 @@ private:
      * Initialize VAAPI
      */
     void initVAAPI();
+    
+    /**
+     * Give the composite to the sinks (offscreen FBO bound)
+     */
+    void captureForVirtualOutputs();
+    
+    /**
+     * Send the completed readback, if any, to the RGBA sinks
+     */
+    void writeCompletedCapture();
 };
 
 } // namespace videocomposer
@@ -0,0 +1,62 @@
+#include "IdleDetector.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+IdleDetector::IdleDetector(int settleFrames)
+    : settleFrames_(std::max(1, settleFrames))
+    , enabled_(true)
+    , idle_(false)
+    , seen_(false)
+    , quietFrames_(0)
+    , sceneVersion_(0)
+    , osdVersion_(0)
+    , idlePeriods_(0)
+    , idleSinceUs_(0)
+    , lastIdleUs_(0)
+{
+}
+
+void IdleDetector::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    if (!enabled_) {
+        reset();
+    }
+}
+
+void IdleDetector::reset() {
+    idle_ = false;
+    idleSinceUs_ = 0;
+    quietFrames_ = 0;
+}
+
+bool IdleDetector::update(const Frame& frame, int64_t nowUs) {
+    bool changed = !seen_ || frame.visible || frame.activity ||
+                   frame.sceneVersion != sceneVersion_ || frame.osdVersion != osdVersion_;
+    seen_ = true;
+    sceneVersion_ = frame.sceneVersion;
+    osdVersion_ = frame.osdVersion;
+    lastIdleUs_ = 0;
+
+    if (!enabled_ || changed) {
+        if (idle_) {
+            lastIdleUs_ = nowUs - idleSinceUs_;
+        }
+        reset();
+        return true;
+    }
+    if (idle_) {
+        return false;
+    }
+
+    // Quiet frames are rendered until every output has the final image
+    if (++quietFrames_ <= settleFrames_) {
+        return true;
+    }
+    idle_ = true;
+    idleSinceUs_ = nowUs;
+    idlePeriods_++;
+    return false;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,73 @@
+#ifndef VIDEOCOMPOSER_IDLEDETECTOR_H
+#define VIDEOCOMPOSER_IDLEDETECTOR_H
+
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * IdleDetector - When the render loop can stop compositing and flipping
+ *
+ * The scene is idle when nothing is on screen (no visible layer, or the
+ * master is blacked out), the scene and the OSD stopped changing and
+ * nothing else is going on (remote commands, loads, a rolling clock).
+ * The first quiet frames are still rendered, so every output has flipped
+ * the final image before the loop stops; the outputs then keep scanning
+ * it out. Any change ends idle on the frame it is seen.
+ */
+class IdleDetector {
+public:
+    static constexpr int DEFAULT_SETTLE_FRAMES = 3;
+    
+    // While idle the loop sleeps in slices: an external clock is polled
+    // every POLL_US, the loop's housekeeping (loads, hotplug) runs every TICK_US
+    static constexpr int64_t POLL_US = 5000;
+    static constexpr int64_t TICK_US = 100000;
+
+    /** What the loop saw this frame */
+    struct Frame {
+        bool visible = false;       // Something is drawn (layer, not blacked out)
+        bool activity = false;      // Commands, loads, scheduled work or sync moved
+        uint64_t sceneVersion = 0;  // SceneSnapshot::version
+        uint64_t osdVersion = 0;    // OSDManager::getVersion()
+    };
+
+    explicit IdleDetector(int settleFrames = DEFAULT_SETTLE_FRAMES);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+    /**
+     * @param nowUs Monotonic time
+     * @return true to render this frame, false to hold the last one
+     */
+    bool update(const Frame& frame, int64_t nowUs);
+
+    /** Render again from the next frame (the outputs cannot hold theirs) */
+    void reset();
+
+    bool isIdle() const { return idle_; }
+    uint64_t getIdlePeriods() const { return idlePeriods_; }
+
+    /** Monotonic time idle started at (0 = not idle) */
+    int64_t getIdleSinceUs() const { return idleSinceUs_; }
+
+    /** Length of the idle period the last update() ended (microseconds) */
+    int64_t getLastIdleUs() const { return lastIdleUs_; }
+
+private:
+    int settleFrames_;
+    bool enabled_;
+    bool idle_;
+    bool seen_;                 // A frame was seen (versions are valid)
+    int quietFrames_;           // Rendered frames since the last change
+    uint64_t sceneVersion_;
+    uint64_t osdVersion_;
+    uint64_t idlePeriods_;
+    int64_t idleSinceUs_;
+    int64_t lastIdleUs_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_IDLEDETECTOR_H
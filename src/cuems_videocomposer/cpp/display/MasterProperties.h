@@ -1,6 +1,8 @@
 #ifndef VIDEOCOMPOSER_MASTERPROPERTIES_H
 #define VIDEOCOMPOSER_MASTERPROPERTIES_H
 
+#include <string>
+
 namespace videocomposer {
 
 /**
@@ -40,11 +42,13 @@ struct MasterProperties {
         float saturation = 1.0f;   // 0.0 to 2.0 (1 = no change, 0 = grayscale)
         float hue = 0.0f;          // -180 to 180 degrees
         float gamma = 1.0f;        // 0.1 to 3.0 (1 = no change)
+        std::string lutFile;       // .cube table applied after the above ("" = none)
         
         // Check if any adjustments are active (non-default)
         bool isActive() const {
             return brightness != 0.0f || contrast != 1.0f || 
-                   saturation != 1.0f || hue != 0.0f || gamma != 1.0f;
+                   saturation != 1.0f || hue != 0.0f || gamma != 1.0f ||
+                   !lutFile.empty();
         }
         
         // Reset all to defaults
@@ -54,6 +58,7 @@ struct MasterProperties {
             saturation = 1.0f;
             hue = 0.0f;
             gamma = 1.0f;
+            lutFile.clear();
         }
     };
     ColorAdjustment colorAdjust;
@@ -96,6 +101,26 @@ struct MasterProperties {
         }
         colorAdjust.reset();
     }
+    
+    // Check if the composite output draws the same as with `other`
+    bool rendersSameAs(const MasterProperties& other) const {
+        if (x != other.x || y != other.y || opacity != other.opacity ||
+            scaleX != other.scaleX || scaleY != other.scaleY || rotation != other.rotation ||
+            cornerDeform.enabled != other.cornerDeform.enabled) {
+            return false;
+        }
+        for (int i = 0; i < 8; i++) {
+            if (cornerDeform.corners[i] != other.cornerDeform.corners[i]) {
+                return false;
+            }
+        }
+        return colorAdjust.brightness == other.colorAdjust.brightness &&
+               colorAdjust.contrast == other.colorAdjust.contrast &&
+               colorAdjust.saturation == other.colorAdjust.saturation &&
+               colorAdjust.hue == other.colorAdjust.hue &&
+               colorAdjust.gamma == other.colorAdjust.gamma &&
+               colorAdjust.lutFile == other.colorAdjust.lutFile;
+    }
 };
 
 } // namespace videocomposer
@@ -6,13 +6,17 @@
  */
 
 #include "MultiOutputRenderer.h"
+#include "PreviewRenderer.h"
 #include "../output/OutputSinkManager.h"
 #include "../layer/LayerManager.h"
 #include "../utils/Logger.h"
+#include "../utils/FrameTracer.h"
+#include "../utils/TimeUtils.h"
 
 #include <GL/glew.h>
 #include <GL/gl.h>
 #include <cstring>
+#include <cmath>
 #include <algorithm>
 
 namespace videocomposer {
@@ -69,13 +73,34 @@ void MultiOutputRenderer::configureOutputs(const std::vector<OutputRegion>& regi
         return;
     }
     
+    // Cluster node: its canvas starts at the outputs' top left corner
+    int originX = 0;
+    int originY = 0;
+    if (hasClusterCanvas() && !regions.empty()) {
+        originX = regions.front().canvasX;
+        originY = regions.front().canvasY;
+        for (const OutputRegion& region : regions) {
+            originX = std::min(originX, region.canvasX);
+            originY = std::min(originY, region.canvasY);
+        }
+    }
+    
+    // The same outputs on the same surfaces: apply only what changed
+    if (applyOutputChanges(regions, surfaces, originX, originY)) {
+        return;
+    }
+    
     outputs_.clear();
     outputRegions_ = regions;
+    originX_ = originX;
+    originY_ = originY;
     
     for (size_t i = 0; i < surfaces.size(); ++i) {
         OutputState state;
         state.surface = surfaces[i];
         state.region = regions[i];
+        state.region.canvasX -= originX_;
+        state.region.canvasY -= originY_;
         outputs_.push_back(std::move(state));
         
         LOG_INFO << "MultiOutputRenderer: Configured output " << i
@@ -88,6 +113,80 @@ void MultiOutputRenderer::configureOutputs(const std::vector<OutputRegion>& regi
     reconfigureCanvas();
 }
 
+bool MultiOutputRenderer::applyOutputChanges(const std::vector<OutputRegion>& regions,
+                                             const std::vector<OutputSurface*>& surfaces,
+                                             int originX, int originY) {
+    if (outputs_.empty() || outputs_.size() != regions.size() ||
+        originX != originX_ || originY != originY_) {
+        return false;
+    }
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+        if (outputs_[i].surface != surfaces[i] || outputRegions_[i].name != regions[i].name) {
+            return false;
+        }
+    }
+    
+    // Blend, warp and output size are picked up by the output's next blit
+    // (OutputBlitShader rebakes just those maps); only placement touches
+    // the canvas and the composited regions
+    bool canvasChanged = false;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+        OutputRegion::Changes changes = outputRegions_[i].changesTo(regions[i]);
+        if (!changes.any()) {
+            continue;
+        }
+        canvasChanged |= changes.affectsCanvas();
+        outputs_[i].region = regions[i];
+        outputs_[i].region.canvasX -= originX_;
+        outputs_[i].region.canvasY -= originY_;
+        LOG_VERBOSE << "MultiOutputRenderer: Updated output " << i << " (" << regions[i].name << ")"
+                    << (changes.placement ? " placement" : "") << (changes.physical ? " size" : "")
+                    << (changes.blend ? " blend" : "") << (changes.warp ? " warp" : "")
+                    << (changes.enabled ? " enabled" : "")
+                    << (changes.dynamicResolution ? " dynamic resolution" : "");
+    }
+    outputRegions_ = regions;
+    if (canvasChanged) {
+        // Same canvas size: the canvas keeps its FBO (see VirtualCanvas::configure)
+        reconfigureCanvas();
+    }
+    return true;
+}
+
+bool MultiOutputRenderer::setOutputSurface(const std::string& name, OutputSurface* surface) {
+    for (auto& output : outputs_) {
+        if (output.region.name == name) {
+            output.surface = surface;
+            // Same canvas size: no reallocation, only the visible parts change
+            updateVisibleRegions();
+            return true;
+        }
+    }
+    return false;
+}
+
+void MultiOutputRenderer::setClusterCanvas(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        width = 0;
+        height = 0;
+    }
+    if (width == clusterWidth_ && height == clusterHeight_) {
+        return;
+    }
+    clusterWidth_ = width;
+    clusterHeight_ = height;
+    if (hasClusterCanvas()) {
+        LOG_INFO << "MultiOutputRenderer: Cluster canvas " << width << "x" << height;
+    }
+    // Regions move into (or out of) this node's window
+    std::vector<OutputSurface*> surfaces;
+    for (const auto& output : outputs_) {
+        surfaces.push_back(output.surface);
+    }
+    std::vector<OutputRegion> regions = outputRegions_;
+    configureOutputs(regions, surfaces);
+}
+
 void MultiOutputRenderer::reconfigureCanvas() {
     if (!canvas_) {
         return;
@@ -98,6 +197,8 @@ void MultiOutputRenderer::reconfigureCanvas() {
     
     if (width > 0 && height > 0) {
         canvas_->configure(width, height);
+        canvasValid_ = false;
+        updateVisibleRegions();
         LOG_INFO << "MultiOutputRenderer: Canvas configured to " << width << "x" << height;
     }
 }
@@ -115,13 +216,107 @@ void MultiOutputRenderer::calculateCanvasSize(int& width, int& height) const {
     }
 }
 
+void MultiOutputRenderer::updateVisibleRegions() {
+    if (!canvas_) {
+        return;
+    }
+    std::vector<CanvasRect> rects;
+    for (const auto& output : outputs_) {
+        const OutputRegion& region = output.region;
+        if (region.enabled && output.surface) {
+            // One pixel around for the scaled blit's filtering
+            rects.push_back(CanvasRect{region.canvasX - 1, region.canvasY - 1,
+                                       region.canvasWidth + 2, region.canvasHeight + 2});
+        }
+    }
+    visibleRegions_.set(rects, canvas_->getWidth(), canvas_->getHeight());
+    // Capture reads the whole canvas; with no output enabled keep drawing it all
+    if (captureEnabled_ || rects.empty()) {
+        visibleRegions_.clear();
+    }
+    
+    // Composited smaller, the same parts of the smaller picture
+    CanvasRegions drawn = visibleRegions_;
+    if (canvas_->getRenderScale() < 1.0f) {
+        drawn = visibleRegions_.scaled(canvas_->getRenderScale(), canvas_->getRenderWidth(),
+                                       canvas_->getRenderHeight());
+    }
+    
+    // The direct scanout canvas is drawn upside down
+    canvas_->setVisibleRects(drawn.coversAll() ? std::vector<CanvasRect>()
+                             : directScanout_ ? drawn.flipped() : drawn.rects());
+    if (renderer_) {
+        renderer_->setVisibleRegions(drawn);
+    }
+    canvasValid_ = false;
+    if (!visibleRegions_.coversAll()) {
+        LOG_INFO << "MultiOutputRenderer: Outputs show " << static_cast<int>(visibleRegions_.coverage() * 100.0f)
+                 << "% of the canvas, compositing " << visibleRegions_.rects().size() << " region(s)";
+    }
+}
+
+bool MultiOutputRenderer::canScaleCanvas() const {
+    if (!canvas_ || captureEnabled_ || directScanout_ || canvas_->hasExternalTargets()) {
+        return false;
+    }
+    for (const auto& output : outputs_) {
+        if (output.surface && output.region.enabled && !output.region.dynamicResolution) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double MultiOutputRenderer::frameBudgetMs() const {
+    double refresh = 0.0;
+    for (const auto& output : outputs_) {
+        if (output.surface && output.region.enabled) {
+            refresh = std::max(refresh, output.surface->getOutputInfo().refreshRate);
+        }
+    }
+    return 1000.0 / (refresh > 0.0 ? refresh : 60.0);
+}
+
+void MultiOutputRenderer::updateRenderScale() {
+    if (!canvas_ || !renderer_) {
+        return;
+    }
+    float scale = 1.0f;
+    if (dynamicResolution_.isEnabled() && canScaleCanvas()) {
+        // GPU time of a frame FRAMES_IN_FLIGHT back, once per new result
+        const GpuTimingStats& stats = renderer_->gpuTimer().stats();
+        GpuTimingStats::Summary frame;
+        if (stats.getFrameCount() != timedFrames_ && stats.getSummary("frame", -1, frame)) {
+            timedFrames_ = stats.getFrameCount();
+            dynamicResolution_.setBudget(frameBudgetMs());
+            if (dynamicResolution_.update(frame.lastMs)) {
+                LOG_INFO << "MultiOutputRenderer: Compositing at "
+                         << static_cast<int>(dynamicResolution_.getScale() * 100.0f) << "% (GPU "
+                         << frame.lastMs << " ms of " << dynamicResolution_.getBudget() << ")";
+            }
+        }
+        scale = dynamicResolution_.getScale();
+    } else {
+        dynamicResolution_.reset();
+    }
+    
+    if (scale != canvas_->getRenderScale()) {
+        canvas_->setRenderScale(scale);
+        updateVisibleRegions();
+        canvasValid_ = false;
+    }
+}
+
 void MultiOutputRenderer::cleanup() {
+    captureConverters_.clear();
+    capturePyramid_.cleanup();
     blitShader_.reset();
     renderer_.reset();
     canvas_.reset();
     
     outputs_.clear();
     outputRegions_.clear();
+    canvasValid_ = false;
     
     initialized_ = false;
 }
@@ -131,7 +326,10 @@ void MultiOutputRenderer::setOutputSinkManager(OutputSinkManager* sinkManager) {
 }
 
 void MultiOutputRenderer::setCaptureEnabled(bool enabled) {
-    captureEnabled_ = enabled;
+    if (enabled != captureEnabled_) {
+        captureEnabled_ = enabled;
+        updateVisibleRegions();
+    }
 }
 
 void MultiOutputRenderer::setCaptureResolution(int width, int height) {
@@ -144,16 +342,47 @@ void MultiOutputRenderer::render(LayerManager* layerManager, OSDManager* osdMana
         return;
     }
     
-    // Step 1: Render all layers to virtual canvas
-    renderToCanvas(layerManager, osdManager);
-    
-    // Step 2: Blit canvas regions to each output
-    blitToOutputs();
+    // The composite, the blits and the capture are one GPU timer frame
+    GpuTimer* gpuTimer = renderer_ ? &renderer_->gpuTimer() : nullptr;
+    if (gpuTimer) {
+        gpuTimer->beginFrame();
+    }
+    updateRenderScale();
+    
+    if (canRenderToOutputDirectly()) {
+        // One plain output: composite into it, no canvas and no blit
+        renderToOutput(outputs_.front(), layerManager);
+        (void)osdManager;
+    } else {
+        // Step 1: Render all layers to virtual canvas
+        renderToCanvas(layerManager, osdManager);
+        
+        // Step 2: Blit canvas regions to each output (direct scanout: the
+        // backend presents the canvas itself)
+        if (!directScanout_) {
+            blitToOutputs();
+        }
+    }
     
     // Step 3: Capture for virtual outputs (sinks)
     if (captureEnabled_ && outputSinkManager_) {
         captureForVirtualOutputs();
     }
+    
+    if (gpuTimer) {
+        gpuTimer->endFrame();
+    }
+    
+    // Step 4: Operator multiview, timed and paced on its own
+    if (preview_ && blitShader_ && renderer_) {
+        int64_t now = vc_get_monotonic_time();
+        if (preview_->pacer().isDue(now)) {
+            std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+            preview_->render(*renderer_, *blitShader_, scene->layers, canvasValid_ ? canvas_->getTexture() : 0,
+                             canvas_->getWidth(), canvas_->getHeight(), now,
+                             canvas_->getRenderWidth(), canvas_->getRenderHeight());
+        }
+    }
 }
 
 void MultiOutputRenderer::renderToCanvas(LayerManager* layerManager, OSDManager* osdManager) {
@@ -161,24 +390,33 @@ void MultiOutputRenderer::renderToCanvas(LayerManager* layerManager, OSDManager*
         return;
     }
     
-    // Begin rendering to canvas
-    canvas_->beginFrame();
+    // Render list as last published by the layer manager
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
     
-    // Set viewport to full canvas
-    renderer_->setViewport(0, 0, canvas_->getWidth(), canvas_->getHeight());
+    // Nothing changed: the outputs re-present the previous canvas
+    if (!updateDamage(*scene) && damageTracking_) {
+        skippedComposites_++;
+        return;
+    }
     
-    // Get all layers sorted by z-order
-    auto layers = layerManager->getLayersSortedByZOrder();
+    // Begin rendering to canvas
+    canvas_->beginFrame();
     
-    // Convert to const vector
-    std::vector<const VideoLayer*> constLayers;
-    constLayers.reserve(layers.size());
-    for (auto* layer : layers) {
-        constLayers.push_back(layer);
+    // Set viewport to full canvas (cluster node: the cluster canvas, this
+    // node's window of it on the canvas), in the composited part's pixels
+    if (hasClusterCanvas()) {
+        double scaleX = static_cast<double>(canvas_->getRenderWidth()) / canvas_->getWidth();
+        double scaleY = static_cast<double>(canvas_->getRenderHeight()) / canvas_->getHeight();
+        renderer_->setViewport(static_cast<int>(std::lround(-originX_ * scaleX)),
+                               static_cast<int>(std::lround(-originY_ * scaleY)),
+                               static_cast<int>(std::lround(clusterWidth_ * scaleX)),
+                               static_cast<int>(std::lround(clusterHeight_ * scaleY)));
+    } else {
+        renderer_->setViewport(0, 0, canvas_->getRenderWidth(), canvas_->getRenderHeight());
     }
     
     // Composite all layers
-    renderer_->compositeLayers(constLayers);
+    renderer_->compositeLayers(scene->layers, scene->groups);
     
     // Render OSD if available
     // TODO: OSD rendering to canvas
@@ -186,6 +424,88 @@ void MultiOutputRenderer::renderToCanvas(LayerManager* layerManager, OSDManager*
     
     // End canvas rendering
     canvas_->endFrame();
+    canvasValid_ = true;
+    
+    // Textures released by this composite go back to the pool
+    renderer_->cleanupDeferredTextures();
+}
+
+void MultiOutputRenderer::renderToOutput(OutputState& output, LayerManager* layerManager) {
+    if (!renderer_ || !output.surface) {
+        return;
+    }
+    // Still queued for scanout: it takes the newest composite once its flip completes
+    if (skipBusyOutputs_ && output.surface->isFlipPending()) {
+        return;
+    }
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    // Keep the scene version current for a switch back to the canvas, which
+    // this path does not draw
+    updateDamage(*scene);
+    canvasValid_ = false;
+    
+    output.surface->makeCurrent();
+    renderer_->setViewport(0, 0, output.region.physicalWidth, output.region.physicalHeight);
+    renderer_->compositeLayers(scene->layers, scene->groups);
+    output.surface->swapBuffers();
+    output.surface->releaseCurrent();
+    directOutputFrames_++;
+    
+    // Textures released by this composite go back to the pool
+    renderer_->cleanupDeferredTextures();
+}
+
+bool MultiOutputRenderer::updateDamage(const SceneSnapshot& scene) {
+    const MasterProperties& master = renderer_->masterProperties();
+    // A new scene version means a layer, its frame or its properties changed
+    bool dirty = !canvasValid_ || scene.version != canvasVersion_ ||
+                 !master.rendersSameAs(canvasMaster_);
+    canvasMaster_ = master;
+    canvasVersion_ = scene.version;
+    return dirty;
+}
+
+bool MultiOutputRenderer::canScanoutDirectly() const {
+    // Scanout crops the canvas at the configured (cluster) positions
+    if (outputs_.empty() || captureEnabled_ || hasClusterCanvas()) {
+        return false;
+    }
+    for (const auto& output : outputs_) {
+        const OutputRegion& region = output.region;
+        if (!output.surface) {
+            continue;   // Unplugged
+        }
+        if (!region.enabled || !region.isOneToOne() ||
+            region.hasBlending() || region.hasWarping()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MultiOutputRenderer::canRenderToOutputDirectly() const {
+    if (!outputFastPath_ || outputs_.size() != 1 || captureEnabled_ || preview_ || directScanout_ || !canvas_ ||
+        hasClusterCanvas() || canvas_->getRenderScale() < 1.0f) {
+        return false;
+    }
+    const OutputRegion& region = outputs_.front().region;
+    return outputs_.front().surface && region.enabled && region.isOneToOne() &&
+           !region.hasBlending() && !region.hasWarping() &&
+           region.canvasX == 0 && region.canvasY == 0 &&
+           region.canvasWidth == canvas_->getWidth() && region.canvasHeight == canvas_->getHeight();
+}
+
+void MultiOutputRenderer::setDirectScanout(bool enabled) {
+    if (enabled == directScanout_) {
+        return;
+    }
+    directScanout_ = enabled;
+    if (renderer_) {
+        renderer_->setFlipY(enabled);
+    }
+    updateVisibleRegions();
+    // The other target does not hold the last composite
+    canvasValid_ = false;
 }
 
 void MultiOutputRenderer::blitToOutputs() {
@@ -194,6 +514,10 @@ void MultiOutputRenderer::blitToOutputs() {
     }
     
     for (auto& output : outputs_) {
+        // Still queued for scanout: it takes the newest canvas once its flip completes
+        if (skipBusyOutputs_ && output.surface && output.surface->isFlipPending()) {
+            continue;
+        }
         if (output.surface) {
             if (output.region.enabled) {
                 blitToOutput(output);
@@ -214,6 +538,7 @@ void MultiOutputRenderer::blitToOutput(OutputState& output) {
     if (!output.surface || !blitShader_ || !canvas_) {
         return;
     }
+    FRAME_TRACE_SCOPE("blit");
     
     // Make output surface current
     output.surface->makeCurrent();
@@ -226,11 +551,14 @@ void MultiOutputRenderer::blitToOutput(OutputState& output) {
     glClear(GL_COLOR_BUFFER_BIT);
     
     // Blit canvas region to output with blend/warp
+    GpuTimer::Scope gpuBlit(renderer_->gpuTimer(), "blit", static_cast<int>(&output - outputs_.data()));
     blitShader_->blit(
         canvas_->getTexture(),
         canvas_->getWidth(),
         canvas_->getHeight(),
-        output.region
+        output.region,
+        canvas_->getRenderWidth(),
+        canvas_->getRenderHeight()
     );
     
     // Swap buffers
@@ -262,15 +590,87 @@ const OutputInfo* MultiOutputRenderer::getOutputInfo(int index) const {
 }
 
 void MultiOutputRenderer::captureForVirtualOutputs() {
-    if (!outputSinkManager_ || !canvas_) {
+    if (!outputSinkManager_ || !canvas_ || !renderer_) {
         return;
     }
+    GpuTimer::Scope gpuCapture(renderer_->gpuTimer(), "capture");
+    
+    int canvasWidth = canvas_->getWidth();
+    int canvasHeight = canvas_->getHeight();
+    
+    // GPU sinks (hardware encoders) take the texture itself: no readback
+    outputSinkManager_->writeTextureToGpuSinks(canvas_->getTexture(), canvasWidth, canvasHeight,
+                                               vc_get_monotonic_time());
+    
+    std::vector<CaptureFormat> formats = outputSinkManager_->getCaptureFormats();
+    
+    // Converters nobody asks for any more, or made for another canvas size
+    captureConverters_.erase(
+        std::remove_if(captureConverters_.begin(), captureConverters_.end(),
+            [&](const std::unique_ptr<CaptureConverter>& converter) {
+                return std::find(formats.begin(), formats.end(), converter->getFormat()) == formats.end() ||
+                       converter->getSourceWidth() != canvasWidth ||
+                       converter->getSourceHeight() != canvasHeight;
+            }),
+        captureConverters_.end());
+    
+    for (const CaptureFormat& format : formats) {
+        if (format == CaptureFormat()) {
+            captureCanvas(format);
+            continue;
+        }
+        
+        // Converted and scaled on the GPU: only the sink's bytes are read back
+        CaptureConverter* converter = nullptr;
+        for (auto& existing : captureConverters_) {
+            if (existing->getFormat() == format) {
+                converter = existing.get();
+                break;
+            }
+        }
+        if (!converter) {
+            auto created = std::make_unique<CaptureConverter>();
+            if (!created->init(format, canvasWidth, canvasHeight)) {
+                continue;
+            }
+            converter = created.get();
+            captureConverters_.push_back(std::move(created));
+        }
+        
+        // Finished readbacks of earlier frames first
+        FrameData frame;
+        while (converter->getResult(frame)) {
+            outputSinkManager_->writeFrameToFormat(std::move(frame), format);
+        }
+    }
     
-    // Start async capture from canvas (double-buffered PBO)
-    canvas_->startAsyncCapture();
-    
-    // Check if previous capture is ready
-    if (canvas_->isAsyncCaptureReady()) {
+    // One pyramid for every downscaled format, then the conversions
+    int levels = 1;
+    for (const auto& converter : captureConverters_) {
+        levels = std::max(levels, converter->getPyramidLevel() + 1);
+    }
+    if (levels > 1) {
+        if (capturePyramid_.configure(canvasWidth, canvasHeight, levels)) {
+            capturePyramid_.update(canvas_->getFBO());
+        } else {
+            levels = 1;
+        }
+    } else {
+        capturePyramid_.cleanup();
+    }
+    for (auto& converter : captureConverters_) {
+        if (levels > 1 && converter->getPyramidLevel() > 0) {
+            converter->convert(capturePyramid_.getTexture(), levels);
+        } else {
+            converter->convert(canvas_->getTexture());
+        }
+    }
+}
+
+void MultiOutputRenderer::captureCanvas(const CaptureFormat& format) {
+    // Finished readbacks first (their fences have signalled): that frees
+    // their buffers for this frame's
+    while (canvas_->isAsyncCaptureReady()) {
         // Allocate frame data
         int width = canvas_->getWidth();
         int height = canvas_->getHeight();
@@ -285,9 +685,12 @@ void MultiOutputRenderer::captureForVirtualOutputs() {
         frame.ownsData = true;
         
         if (canvas_->getAsyncCaptureResult(frame.data, bufferSize)) {
-            outputSinkManager_->writeFrameToAll(frame);
+            outputSinkManager_->writeFrameToFormat(std::move(frame), format);
         }
     }
+    
+    // Fenced async capture from canvas; dropped if the GPU is a ring behind
+    canvas_->startAsyncCapture();
 }
 
 int MultiOutputRenderer::findOutputByName(const std::string& name) const {
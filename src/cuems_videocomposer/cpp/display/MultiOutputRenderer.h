@@ -12,6 +12,25 @@
  * - Geometric warping for keystone/curved surfaces
  * - Frame capture for virtual outputs (NDI, streaming)
  * - Synchronized multi-output presentation
+ * - Damage tracking: the canvas is only re-composited when a layer loaded
+ *   a new frame, changed a property, or the layer set changed (still-image
+ *   layers load their frame once, so they never damage it afterwards)
+ * - Single-output fast path: one plain 1:1 output (no blend, warp or
+ *   capture) is composited straight into its surface, without the canvas
+ *   and the blit
+ * - Sparse layouts: canvas pixels no enabled output shows are neither
+ *   cleared nor filled, and layers entirely outside every output are culled
+ *   (the whole canvas is drawn while virtual outputs capture it)
+ * - Operator preview: a PreviewRenderer draws its multiview after the
+ *   program frame and its GPU timer frame (the single-output fast path is
+ *   off meanwhile, the program tile samples the canvas)
+ * - Cluster nodes: with a cluster canvas set, the output regions are in a
+ *   canvas shared with other nodes; this node's canvas is only its outputs'
+ *   bounding box, composited as that window of the cluster canvas
+ * - Dynamic resolution: with the GPU near its frame budget the canvas is
+ *   composited at a fraction of its size and scaled up in the blits
+ *   (DynamicResolution), unless an output opts out or the canvas is
+ *   captured or scanned out
  */
 
 #ifndef VIDEOCOMPOSER_MULTIOUTPUTRENDERER_H
@@ -22,8 +41,11 @@
 #include "OutputRegion.h"
 #include "VirtualCanvas.h"
 #include "OutputBlitShader.h"
+#include "CaptureConverter.h"
+#include "DynamicResolution.h"
 #include "OpenGLRenderer.h"
 #include "../layer/LayerManager.h"
+#include "../layer/LayerProperties.h"
 #include "../osd/OSDManager.h"
 #include <vector>
 #include <memory>
@@ -39,6 +61,7 @@ namespace videocomposer {
 // Forward declarations
 class OutputSurface;
 class OutputSinkManager;
+class PreviewRenderer;
 
 /**
  * Geometry definitions
@@ -134,17 +157,38 @@ public:
      * Call after init() to set up output layout.
      * 
      * @param regions Vector of output regions defining canvas layout
-     * @param surfaces Corresponding output surfaces (not owned)
+     * @param surfaces Corresponding output surfaces (not owned; nullptr for
+     *        an output that is unplugged)
      */
     void configureOutputs(const std::vector<OutputRegion>& regions,
                           const std::vector<OutputSurface*>& surfaces);
     
+    /**
+     * Swap the surface of one output (hotplug), keeping the canvas: nullptr
+     * detaches an unplugged output, whose region stays but is not drawn
+     * @return false if no output has that name
+     */
+    bool setOutputSurface(const std::string& name, OutputSurface* surface);
+    
     /**
      * Reconfigure canvas size (call when outputs change)
      * Automatically calculates combined size from output regions.
      */
     void reconfigureCanvas();
     
+    /**
+     * Cluster node: regions are in a canvas of this size that other nodes
+     * show parts of. The canvas covers the outputs' bounding box only and
+     * layers are placed in the whole cluster canvas (0x0 = off). Direct
+     * scanout and the single-output fast path are off meanwhile.
+     */
+    void setClusterCanvas(int width, int height);
+    bool hasClusterCanvas() const { return clusterWidth_ > 0 && clusterHeight_ > 0; }
+    
+    /** Cluster canvas pixel at this node's canvas origin */
+    int getCanvasOriginX() const { return originX_; }
+    int getCanvasOriginY() const { return originY_; }
+    
     /**
      * Cleanup resources
      */
@@ -174,6 +218,11 @@ public:
     int getCanvasWidth() const { return canvas_ ? canvas_->getWidth() : 0; }
     int getCanvasHeight() const { return canvas_ ? canvas_->getHeight() : 0; }
     
+    /**
+     * Get the layer compositing renderer
+     */
+    OpenGLRenderer* getRenderer() { return renderer_.get(); }
+    
     // ===== Layer Mapping =====
     
     // ===== Virtual Output Integration =====
@@ -198,6 +247,13 @@ public:
      */
     void setCaptureResolution(int width, int height);
     
+    /**
+     * Set the operator preview drawn after each program frame (not owned;
+     * nullptr = none)
+     */
+    void setPreviewRenderer(PreviewRenderer* preview) { preview_ = preview; }
+    PreviewRenderer* getPreviewRenderer() const { return preview_; }
+    
     // ===== Rendering =====
     
     /**
@@ -207,6 +263,85 @@ public:
      */
     void render(LayerManager* layerManager, OSDManager* osdManager = nullptr);
     
+    /**
+     * Skip re-compositing the canvas when nothing changed (default: on)
+     * The outputs are still blitted from the previous canvas every frame.
+     */
+    void setDamageTracking(bool enabled) { damageTracking_ = enabled; }
+    bool getDamageTracking() const { return damageTracking_; }
+    
+    /**
+     * Force the next render() to re-composite the canvas
+     */
+    void invalidateCanvas() { canvasValid_ = false; }
+    
+    /**
+     * Number of render() calls that re-presented the previous canvas
+     */
+    uint64_t getSkippedComposites() const { return skippedComposites_; }
+    
+    /**
+     * Composite straight into the output when only one plain output is
+     * shown (default: on). Its surface keeps no previous frame, so this path
+     * composites every frame: damage tracking applies to the canvas path only.
+     */
+    void setOutputFastPath(bool enabled) { outputFastPath_ = enabled; }
+    bool getOutputFastPath() const { return outputFastPath_; }
+    
+    /**
+     * Check if render() would composite straight into the output: one
+     * output, enabled, 1:1 at the canvas origin and canvas-sized, without
+     * edge blend or warp, no capture or direct scanout, and the canvas at
+     * native size
+     */
+    bool canRenderToOutputDirectly() const;
+    
+    /**
+     * Frames composited straight into the output (fast path)
+     */
+    uint64_t getDirectOutputFrames() const { return directOutputFrames_; }
+    
+    /**
+     * Canvas pixels shown by an enabled output (covers the whole canvas
+     * while capturing)
+     */
+    const CanvasRegions& getVisibleRegions() const { return visibleRegions_; }
+    
+    /**
+     * Check if the outputs can scan out the canvas directly: every output
+     * enabled, 1:1, without edge blend or warp, and no capture (the canvas
+     * is then stored top-down)
+     */
+    bool canScanoutDirectly() const;
+    
+    /**
+     * Direct scanout: render() only composites the canvas (upside down, into
+     * the VirtualCanvas external targets); the backend presents the canvas
+     * buffer with per-output plane source rectangles instead of blits
+     */
+    void setDirectScanout(bool enabled);
+    bool isDirectScanout() const { return directScanout_; }
+    
+    /**
+     * Skip outputs with a flip pending instead of rendering ahead into them
+     * (outputs paced by their own vblank pick up the newest canvas when free)
+     */
+    void setSkipBusyOutputs(bool enabled) { skipBusyOutputs_ = enabled; }
+    bool getSkipBusyOutputs() const { return skipBusyOutputs_; }
+    
+    /**
+     * Render scale controller, fed the GPU frame times (off by default)
+     */
+    DynamicResolution& dynamicResolution() { return dynamicResolution_; }
+    const DynamicResolution& dynamicResolution() const { return dynamicResolution_; }
+    
+    /**
+     * Check if the canvas may be composited below native size: not captured
+     * or scanned out, and every shown output allows it
+     * (OutputRegion::dynamicResolution)
+     */
+    bool canScaleCanvas() const;
+    
     /**
      * Present all outputs (synchronized swap/flip)
      */
@@ -230,7 +365,7 @@ private:
      */
     struct OutputState {
         OutputSurface* surface = nullptr;
-        OutputRegion region;                      // Canvas region for this output
+        OutputRegion region;                      // Canvas region for this output (node canvas)
     };
     
     // Virtual Canvas components
@@ -238,7 +373,13 @@ private:
     std::unique_ptr<OutputBlitShader> blitShader_;
     
     std::vector<OutputState> outputs_;
-    std::vector<OutputRegion> outputRegions_;     // Output regions in canvas
+    std::vector<OutputRegion> outputRegions_;     // Output regions in canvas (as configured)
+    
+    // Cluster canvas (setClusterCanvas): size, and where this node's canvas starts in it
+    int clusterWidth_ = 0;
+    int clusterHeight_ = 0;
+    int originX_ = 0;
+    int originY_ = 0;
     std::unique_ptr<OpenGLRenderer> renderer_;
     
     // Virtual output capture
@@ -246,9 +387,28 @@ private:
     int captureWidth_ = 0;
     int captureHeight_ = 0;
     bool captureEnabled_ = false;
+    std::vector<std::unique_ptr<CaptureConverter>> captureConverters_;  // One per sink format
+    CapturePyramid capturePyramid_;     // Shared by the downscaled formats
+    PreviewRenderer* preview_ = nullptr;  // Not owned
     
     bool initialized_ = false;
     
+    // Damage tracking
+    bool damageTracking_ = true;
+    bool canvasValid_ = false;                    // Canvas holds the last composite
+    uint64_t canvasVersion_ = 0;                  // Scene version last composited
+    MasterProperties canvasMaster_;
+    uint64_t skippedComposites_ = 0;
+    
+    bool directScanout_ = false;
+    bool skipBusyOutputs_ = false;
+    bool outputFastPath_ = true;
+    uint64_t directOutputFrames_ = 0;
+    CanvasRegions visibleRegions_;
+    
+    DynamicResolution dynamicResolution_;
+    uint64_t timedFrames_ = 0;                    // GPU timer frames fed to it
+    
     // ===== Private Methods =====
     
     /**
@@ -256,6 +416,17 @@ private:
      */
     void renderToCanvas(LayerManager* layerManager, OSDManager* osdManager);
     
+    /**
+     * Compare the scene with the last composite and record its version
+     * @return true if the canvas needs to be composited again
+     */
+    bool updateDamage(const SceneSnapshot& scene);
+    
+    /**
+     * Fast path: composite all layers into the single output's surface
+     */
+    void renderToOutput(OutputState& output, LayerManager* layerManager);
+    
     /**
      * Blit canvas regions to all outputs
      */
@@ -267,10 +438,15 @@ private:
     void blitToOutput(OutputState& output);
     
     /**
-     * Capture frame for virtual outputs
+     * Capture frame for virtual outputs, once per distinct sink format
      */
     void captureForVirtualOutputs();
     
+    /**
+     * Plain canvas readback (RGBA, canvas size, bottom row first)
+     */
+    void captureCanvas(const CaptureFormat& format);
+    
     /**
      * Find output by name
      */
@@ -280,6 +456,29 @@ private:
      * Calculate canvas size from output regions
      */
     void calculateCanvasSize(int& width, int& height) const;
+    
+    /**
+     * Update the outputs in place when only their configuration changed
+     * @return false if outputs were added, removed, renamed or moved to
+     *         other surfaces (configureOutputs rebuilds them)
+     */
+    bool applyOutputChanges(const std::vector<OutputRegion>& regions,
+                            const std::vector<OutputSurface*>& surfaces, int originX, int originY);
+    
+    /**
+     * Restrict the canvas and the compositor to the enabled outputs' regions
+     */
+    void updateVisibleRegions();
+    
+    /**
+     * Feed the newest GPU frame time to the controller and apply its scale
+     */
+    void updateRenderScale();
+    
+    /**
+     * GPU time per frame: the period of the fastest output
+     */
+    double frameBudgetMs() const;
 };
 
 } // namespace videocomposer
@@ -1,20 +1,19 @@
 #include "OpenGLRenderer.h"
+#include "TextureUploader.h"
 #include "../layer/VideoLayer.h"
 #include "../osd/OSDRenderer.h"
 #include "../utils/Logger.h"
+#include "../utils/FrameTracer.h"
 #include "../input/HAPVideoInput.h"
 #include "../input/InputSource.h"
 #include "VideoShaders.h"
-#include "HapShaders.h"
+#include "ProgramBinaryCache.h"
+#include "../video/TexturePool.h"
 #include <GL/glew.h>  // Must be included before GL/gl.h
-extern "C" {
-#ifndef HAVE_GL
-#define HAVE_GL
-#endif
-#include "../../homography.h"
-}
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <cmath>
 
@@ -36,33 +35,50 @@ extern "C" {
 #ifndef GL_BGRA
 #define GL_BGRA 0x80E1
 #endif
-#ifndef GL_TEXTURE_RECTANGLE_ARB
-#define GL_TEXTURE_RECTANGLE_ARB 0x84F5
-#endif
 
 namespace videocomposer {
 
 OpenGLRenderer::OpenGLRenderer()
-    : textureId_(0)
-    , textureWidth_(0)
-    , textureHeight_(0)
+    : viewportX_(0)
+    , viewportY_(0)
     , viewportWidth_(0)
     , viewportHeight_(0)
     , letterbox_(true)
     , initialized_(false)
+    , hasBufferStorage_(false)
+    , hasMemoryInfo_(false)
+    , hasCopyImage_(false)
+    , blendPath_(AdvancedBlend::Path::COPY_BOUNDS)
+    , blendCoherent_(false)
+    , blendDestTexture_(0)
+    , blendDestWidth_(0)
+    , blendDestHeight_(0)
+    , warmupEvictorId_(0)
     , quadVAO_(0)
     , quadVBO_(0)
-    , rgbaShader_(nullptr)
-    , rgbaShaderHQ_(nullptr)
-    , nv12Shader_(nullptr)
-    , yuv420pShader_(nullptr)
-    , useShaders_(false)
-    , texturesToDelete_()
+    , osdVAO_(0)
+    , osdVBO_(0)
+    , shaderCache_(nullptr)
+    , bc1Failed_(false)
+    , culledLayerCount_(0)
+    , layerBatchingEnabled_(true)
+    , batchOpen_(false)
+    , batch_()
+    , batchUBO_(0)
+    , batchProgramId_(0)
+    , deinterlaceMode_(FieldSelector::Mode::AUTO)
+    , groupRedrawCount_(0)
+    , masterFolded_(false)
+    , masterMatrix_()
+    , masterOpacity_(1.0f)
+    , flipY_(false)
+    , flipLayers_(false)
     , masterFBO_(0)
     , masterFBOTexture_(0)
     , masterFBOWidth_(0)
     , masterFBOHeight_(0)
     , masterFBOInitialized_(false)
+    , masterFBOPassCount_(0)
 {
 }
 
@@ -95,37 +111,46 @@ bool OpenGLRenderer::init() {
     LOG_INFO << "OpenGL version: " << glGetString(GL_VERSION);
     LOG_INFO << "GLSL version: " << glGetString(GL_SHADING_LANGUAGE_VERSION);
 
-    // Check for required OpenGL versions/extensions
-    if (!GLEW_VERSION_3_3) {
-        LOG_WARNING << "OpenGL 3.3 not available, some features may not work";
+    // Every path draws with shaders and vertex arrays: GL 3.3 (any profile)
+    // or GLES 3
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int esMajor = 0;
+    bool gles = version && sscanf(version, "OpenGL ES %d", &esMajor) == 1;
+    if (gles ? esMajor < 3 : !GLEW_VERSION_3_3) {
+        LOG_ERROR << "OpenGLRenderer: OpenGL 3.3 or OpenGL ES 3.0 required";
+        return false;
+    }
+    if (!gles) {
+        GLint profileMask = 0;
+        glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profileMask);
+        if (profileMask & GL_CONTEXT_CORE_PROFILE_BIT) {
+            LOG_INFO << "OpenGLRenderer: Running in Core Profile mode (like mpv)";
+        }
     }
-
-    // Check if we're in core profile (DRM/EGL uses core profile)
-    // mpv always uses Core Profile and never calls glEnable(GL_TEXTURE_*)
-    GLint profileMask = 0;
-    glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profileMask);
-    isCoreProfile_ = (profileMask & GL_CONTEXT_CORE_PROFILE_BIT) != 0;
     
-    if (isCoreProfile_) {
-        LOG_INFO << "OpenGLRenderer: Running in Core Profile mode (like mpv)";
+    // Persistent mapped PBOs let software decode write straight into GL memory
+    hasBufferStorage_ = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if (hasBufferStorage_) {
+        LOG_INFO << "OpenGLRenderer: Zero-copy software decode enabled (persistent mapped PBOs)";
     }
+    hasMemoryInfo_ = GLEW_NVX_gpu_memory_info;
+    hasCopyImage_ = GLEW_VERSION_4_3 || GLEW_ARB_copy_image;
+    
+    // Multiply/screen/overlay in one draw where the GL can read the destination
+    AdvancedBlend::Capabilities blendCaps;
+    blendCaps.blendEquation = GLEW_KHR_blend_equation_advanced && glBlendBarrierKHR;
+    blendCaps.coherent = GLEW_KHR_blend_equation_advanced_coherent;
+    blendCaps.framebufferFetch = GLEW_EXT_shader_framebuffer_fetch;
+    blendPath_ = AdvancedBlend::choosePath(blendCaps);
+    blendCoherent_ = blendCaps.coherent;
+    LOG_INFO << "OpenGLRenderer: Advanced blend modes through " << AdvancedBlend::pathName(blendPath_);
     
     // Initialize OpenGL state (matches original xjadeo)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);  // Black background, fully opaque
     glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // glEnable(GL_TEXTURE_*) is deprecated in Core Profile - skip it (mpv doesn't use it)
-    if (!isCoreProfile_) {
-    glEnable(GL_TEXTURE_RECTANGLE_ARB);
-    }
-
-    // Generate texture
-    glGenTextures(1, &textureId_);
-    if (textureId_ == 0) {
-        return false;
-    }
+    glState_.invalidate();
+    glState_.setBlend(true);
+    glState_.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     // Initialize VBO/VAO for shader-based rendering
     if (!initQuadVBO()) {
@@ -133,41 +158,68 @@ bool OpenGLRenderer::init() {
         return false;
     }
     
-    // Initialize shaders (optional - gracefully fall back to fixed-function if fails)
-    if (GLEW_VERSION_3_3) {
-        if (initShaders()) {
-            useShaders_ = true;
-            LOG_INFO << "Shader-based rendering enabled";
-        } else {
-            LOG_WARNING << "Failed to initialize shaders, using fixed-function pipeline";
-            useShaders_ = false;
-        }
-    } else {
-        LOG_INFO << "OpenGL 3.3 not available, using fixed-function pipeline";
-        useShaders_ = false;
+    if (!initShaders()) {
+        LOG_ERROR << "Failed to initialize shaders";
+        cleanupQuadVBO();
+        return false;
     }
+    
+    // Without timer queries the GPU timings are just not reported
+    gpuTimer_.init();
+
+    // Armed-layer uploads give way to layers that are live
+    renderThread_ = std::this_thread::get_id();
+    warmupEvictorId_ = MemoryBudget::instance().addEvictor(
+        MemoryBudget::Tier::WARMUP, MemoryBudget::Pool::VRAM,
+        [this](size_t bytes) { return evictArmedUploads(bytes); });
 
     initialized_ = true;
     return true;
 }
 
 void OpenGLRenderer::cleanup() {
-    if (textureId_ != 0) {
-        glDeleteTextures(1, &textureId_);
-        textureId_ = 0;
+    if (warmupEvictorId_ != 0) {
+        MemoryBudget::instance().removeEvictor(warmupEvictorId_);
+        warmupEvictorId_ = 0;
     }
     
+    // Upload thread first: its textures live in this renderer's share group
+    uploader_.reset();
+    
     // Cleanup all cached layer textures and PBOs
     for (auto& pair : layerTextureCache_) {
-        if (pair.second.textureId != 0) {
-            glDeleteTextures(1, &pair.second.textureId);
-        }
-        cleanupLayerPBOs(pair.second);
+        releaseLayerTexture(pair.second);
     }
     layerTextureCache_.clear();
+    for (auto& pair : tiledTextures_) {
+        releaseTiledTexture(pair.second);
+    }
+    tiledTextures_.clear();
+    for (auto& pair : groupCaches_) {
+        releaseGroupCache(pair.second);
+    }
+    groupCaches_.clear();
+    planarTextures_.clear();
+    planarArmedGenerations_.clear();
+    bc1Encoder_.reset();
+    bc1Failed_ = false;
+    cleanupDeferredTextures();
+    
+    // The context goes away with the renderer: free the pooled objects now
+    TexturePool::instance().clear();
     
     // Cleanup VBO/VAO
     cleanupQuadVBO();
+    batch_.clear();
+    if (batchUBO_ != 0) {
+        glDeleteBuffers(1, &batchUBO_);
+        batchUBO_ = 0;
+    }
+    if (blendDestTexture_ != 0) {
+        glDeleteTextures(1, &blendDestTexture_);
+        blendDestTexture_ = 0;
+        blendDestWidth_ = blendDestHeight_ = 0;
+    }
     
     // Cleanup shaders
     cleanupShaders();
@@ -175,9 +227,79 @@ void OpenGLRenderer::cleanup() {
     // Cleanup master FBO
     cleanupMasterFBO();
     
+    gpuTimer_.cleanup();
+
     initialized_ = false;
 }
 
+int64_t OpenGLRenderer::getVideoMemoryTotal() const {
+    if (!initialized_ || !hasMemoryInfo_) {
+        return -1;
+    }
+    GLint total = 0;  // KiB
+    glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+    return total > 0 ? static_cast<int64_t>(total) * 1024 : -1;
+}
+
+int64_t OpenGLRenderer::getVideoMemoryUsed() const {
+    if (!initialized_ || !hasMemoryInfo_) {
+        return -1;
+    }
+    // Both in KiB
+    GLint total = 0, available = 0;
+    glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+    glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+    if (total <= 0 || available > total) {
+        return -1;
+    }
+    return static_cast<int64_t>(total - available) * 1024;
+}
+
+#ifdef HAVE_EGL
+bool OpenGLRenderer::enableUploadThread(EGLDisplay display, EGLContext context) {
+    if (uploader_) {
+        return true;
+    }
+    auto uploader = std::make_unique<TextureUploader>();
+    if (!uploader->init(display, context)) {
+        LOG_WARNING << "OpenGLRenderer: Upload thread unavailable, uploading on the render thread";
+        return false;
+    }
+    uploader_ = std::move(uploader);
+    return true;
+}
+#endif
+
+bool OpenGLRenderer::isUploadThreadEnabled() const {
+    return uploader_ && uploader_->isRunning();
+}
+
+void OpenGLRenderer::submitUploads(const std::vector<const VideoLayer*>& layers) {
+    // Queue every CPU frame up front so the copies run while earlier layers draw
+    std::vector<int>& layerIds = uploadLayerIds_;
+    layerIds.clear();
+    for (const VideoLayer* layer : layers) {
+        if (!layer || !layer->isReady() || !layer->properties().visible) {
+            continue;
+        }
+        const FrameBuffer* cpuBuffer = nullptr;
+        const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+        bool isOnGPU = layer->getPreparedFrame(cpuBuffer, gpuBuffer);
+        if (!isOnGPU && cpuBuffer && cpuBuffer->isValid() && !isShaderYUV(cpuBuffer->info().format)) {
+            if (layer->hasStaticFrame() || hasArmedUpload(layer)) {
+                continue;  // Still image or armed cue: its cached texture is drawn as is
+            }
+            std::shared_ptr<MappedFrameRing> ring = layer->getFrameRing();
+            if (ring && ring->indexOf(cpuBuffer) >= 0) {
+                continue;  // Decoded into a mapped PBO, nothing to copy
+            }
+            uploader_->submit(layer->getLayerId(), *cpuBuffer);
+            layerIds.push_back(layer->getLayerId());
+        }
+    }
+    uploader_->retainLayers(layerIds);
+}
+
 // PBO helper methods for async texture upload
 bool OpenGLRenderer::initLayerPBOs(LayerTextureCache& cache, int width, int height) {
     if (cache.pboInitialized) {
@@ -187,19 +309,21 @@ bool OpenGLRenderer::initLayerPBOs(LayerTextureCache& cache, int width, int heig
     // Calculate buffer size (BGRA = 4 bytes per pixel)
     size_t bufferSize = static_cast<size_t>(width) * height * 4;
     
-    glGenBuffers(2, cache.pbo);
+    // Recycled from layers that went away where possible
+    for (int i = 0; i < 2; i++) {
+        cache.pbo[i] = TexturePool::instance().acquireBuffer(
+            bufferSize, MemoryBudget::Account(MemoryBudget::Subsystem::UPLOAD_BUFFERS, cache.layerId));
+    }
     if (cache.pbo[0] == 0 || cache.pbo[1] == 0) {
         LOG_ERROR << "Failed to create PBOs for layer texture upload";
+        for (int i = 0; i < 2; i++) {
+            TexturePool::instance().releaseBuffer(cache.pbo[i], bufferSize);
+            cache.pbo[i] = 0;
+        }
         return false;
     }
     
-    // Initialize both PBOs with empty storage
-    for (int i = 0; i < 2; i++) {
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, cache.pbo[i]);
-        glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
-    }
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-    
+    cache.pboSize = bufferSize;
     cache.pboIndex = 0;
     cache.pboInitialized = true;
     
@@ -209,143 +333,429 @@ bool OpenGLRenderer::initLayerPBOs(LayerTextureCache& cache, int width, int heig
 
 void OpenGLRenderer::cleanupLayerPBOs(LayerTextureCache& cache) {
     if (cache.pboInitialized) {
-        glDeleteBuffers(2, cache.pbo);
+        for (int i = 0; i < 2; i++) {
+            TexturePool::instance().releaseBuffer(cache.pbo[i], cache.pboSize);
+        }
         cache.pbo[0] = 0;
         cache.pbo[1] = 0;
         cache.pboInitialized = false;
     }
+    releaseFrameRing(cache);
 }
 
-void OpenGLRenderer::setViewport(int x, int y, int width, int height) {
-    viewportWidth_ = width;
-    viewportHeight_ = height;
-    glViewport(x, y, width, height);
-    setupOrthoProjection();
+bool OpenGLRenderer::attachFrameRing(LayerTextureCache& cache, const std::shared_ptr<MappedFrameRing>& ring,
+                                     const FrameInfo& info) {
+    if (!hasBufferStorage_ || !ring || cache.ring || ring->isAttached() ||
+        info.format != PixelFormat::BGRA32) {
+        return false;
+    }
+    releaseOrphanedFrameRings();
+    
+    size_t slotSize = static_cast<size_t>(info.width) * info.height * 4;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    uint8_t* memory[MappedFrameRing::SLOTS] = {nullptr, nullptr, nullptr};
+    
+    glGenBuffers(MappedFrameRing::SLOTS, cache.ringPbo);
+    bool ok = true;
+    for (int i = 0; i < MappedFrameRing::SLOTS && ok; ++i) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, cache.ringPbo[i]);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, slotSize, nullptr, flags);
+        memory[i] = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slotSize, flags));
+        ok = cache.ringPbo[i] != 0 && memory[i] != nullptr;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    if (!ok) {
+        // Driver advertises buffer storage but cannot map it - stop trying
+        LOG_WARNING << "OpenGLRenderer: Persistent PBO mapping failed, zero-copy decode disabled";
+        hasBufferStorage_ = false;
+        glDeleteBuffers(MappedFrameRing::SLOTS, cache.ringPbo);
+        for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+            cache.ringPbo[i] = 0;
+        }
+        return false;
+    }
+    
+    if (!ring->attach(memory, slotSize, info)) {
+        // A slot is still displayed from an earlier attachment - retry later
+        glDeleteBuffers(MappedFrameRing::SLOTS, cache.ringPbo);
+        for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+            cache.ringPbo[i] = 0;
+        }
+        return false;
+    }
+    
+    cache.ring = ring;
+    cache.uploadedSlot = -1;
+    cache.uploadedGeneration = 0;
+    LOG_DEBUG << "Attached zero-copy decode ring for layer (" << info.width << "x" << info.height << ")";
+    return true;
 }
 
-void OpenGLRenderer::setupOrthoProjection() {
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+void OpenGLRenderer::uploadFromFrameRing(LayerTextureCache& cache, int slot) {
+    FRAME_TRACE_SCOPE("upload");
+    pollFrameRingFences(cache);
+    
+    uint64_t generation = cache.ring->generation(slot);
+    if (slot == cache.uploadedSlot && generation == cache.uploadedGeneration) {
+        return;  // Same frame as last composite - texture is current
+    }
+    
+    // Pixels are already in the PBO: the transfer is GPU-side only
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, cache.ringPbo[slot]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cache.width, cache.height,
+                    GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    // Keep the decoder off this slot until the GPU has read it
+    if (cache.ringFence[slot]) {
+        glDeleteSync(cache.ringFence[slot]);
+    }
+    cache.ringFence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    cache.ring->setGpuBusy(slot, true);
+    
+    cache.uploadedSlot = slot;
+    cache.uploadedGeneration = generation;
 }
 
-bool OpenGLRenderer::uploadFrameToTexture(const FrameBuffer& frame) {
-    if (!frame.isValid() || textureId_ == 0) {
-        return false;
+void OpenGLRenderer::pollFrameRingFences(LayerTextureCache& cache) {
+    for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+        if (!cache.ringFence[i]) {
+            continue;
+        }
+        GLenum status = glClientWaitSync(cache.ringFence[i], 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync(cache.ringFence[i]);
+            cache.ringFence[i] = nullptr;
+            cache.ring->setGpuBusy(i, false);
+        }
     }
+}
 
-    const FrameInfo& info = frame.info();
-
-    // Update texture if size changed (matches original xjadeo)
-    if (textureWidth_ != info.width || textureHeight_ != info.height) {
-        textureWidth_ = info.width;
-        textureHeight_ = info.height;
-
-        glBindTexture(GL_TEXTURE_RECTANGLE_ARB, textureId_);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // Use GL_REPLACE instead of GL_DECAL for proper texture rendering
-        // GL_DECAL blends with vertex color based on alpha, which can cause black output
-        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-        // Allocate texture storage (BGRA format, matches original xjadeo)
-        glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA,
-                     textureWidth_, textureHeight_, 0,
-                     GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
-    }
-
-    // Upload frame data (matches original xjadeo: BGRA format)
-    // Note: GL_TEXTURE_RECTANGLE_ARB doesn't need glEnable, just bind
-    glBindTexture(GL_TEXTURE_RECTANGLE_ARB, textureId_);
-    
-    // Use BGRA format (matches original xjadeo)
-    GLenum format = GL_BGRA;
-    GLenum type = GL_UNSIGNED_BYTE;
-    
-    // Performance optimization: Use glTexSubImage2D when texture size hasn't changed
-    // This is faster than glTexImage2D because it doesn't reallocate texture storage
-    // Only use glTexImage2D when texture size changes (handled above)
-    glTexSubImage2D(GL_TEXTURE_RECTANGLE_ARB, 0,
-                    0, 0,  // xoffset, yoffset
-                    textureWidth_, textureHeight_,
-                    format, type, frame.data());
-
-    return true;
+void OpenGLRenderer::releaseFrameRing(LayerTextureCache& cache) {
+    if (!cache.ring) {
+        return;
+    }
+    
+    // Displayed slots get copied out before the mapping disappears
+    cache.ring->detach(true);
+    cache.ring.reset();
+    
+    for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+        if (cache.ringFence[i]) {
+            glDeleteSync(cache.ringFence[i]);
+            cache.ringFence[i] = nullptr;
+        }
+    }
+    // Deleting a mapped buffer unmaps it; pending GPU reads are kept alive by GL
+    glDeleteBuffers(MappedFrameRing::SLOTS, cache.ringPbo);
+    for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+        cache.ringPbo[i] = 0;
+    }
+    cache.uploadedSlot = -1;
+    cache.uploadedGeneration = 0;
 }
 
-bool OpenGLRenderer::bindGPUTexture(const GPUTextureFrameBuffer& gpuFrame) {
-    if (!gpuFrame.isValid()) {
-        return false;
+void OpenGLRenderer::releaseOrphanedFrameRings() {
+    // The cache holds the last reference once a layer is destroyed
+    for (auto& pair : layerTextureCache_) {
+        if (pair.second.ring && pair.second.ring.use_count() == 1) {
+            releaseFrameRing(pair.second);
+        }
     }
+}
 
-    GLuint textureId = gpuFrame.getTextureId();
+OpenGLRenderer::TiledLayerTexture* OpenGLRenderer::tiledTexture(int layerId,
+                                                                 const std::shared_ptr<TiledImage>& image) {
+    auto it = tiledTextures_.find(layerId);
+    if (it != tiledTextures_.end() && it->second.image == image) {
+        return &it->second;
+    }
+    if (it != tiledTextures_.end()) {
+        releaseTiledTexture(it->second);
+        tiledTextures_.erase(it);
+    }
+    
+    // As many slots as the budget pays for, within the maximum texture size
+    int stride = image->getTileStride();
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    size_t perSide = static_cast<size_t>(std::max(1, maxSize / stride));
+    size_t wanted = std::max<size_t>(4, TiledImage::getSettings().vramBytes / image->getTileBytes());
+    size_t columns = std::min(wanted, perSide);
+    size_t rows = std::min(std::max<size_t>(1, wanted / columns), perSide);
+    
+    TexturePool::Key key;
+    key.width = static_cast<int>(columns) * stride;
+    key.height = static_cast<int>(rows) * stride;
+    key.internalFormat = GL_RGBA8;
+    key.levels = 1;
+    GLuint textureId = TexturePool::instance().acquireTexture(
+        key, MemoryBudget::Account(MemoryBudget::Subsystem::LAYER_TEXTURES, layerId));
+    glState_.invalidateTextures();
     if (textureId == 0) {
-        return false;
+        return nullptr;  // Over the budget: the overview is drawn instead
     }
-
-    // All GPU textures (HAP and hardware-decoded) use GL_TEXTURE_2D
-    // GPUTextureFrameBuffer always allocates textures as GL_TEXTURE_2D
-    GLenum target = GL_TEXTURE_2D;
     
-    // CRITICAL: Disable GL_TEXTURE_RECTANGLE_ARB before enabling GL_TEXTURE_2D
-    // Having both enabled simultaneously causes rendering issues
-    glDisable(GL_TEXTURE_RECTANGLE_ARB);
+    TiledLayerTexture& cache = tiledTextures_[layerId];
+    cache.image = image;
+    cache.textureId = textureId;
+    cache.width = key.width;
+    cache.height = key.height;
+    cache.columns = static_cast<int>(columns);
+    cache.residency = TileResidency(columns * rows);
+    cache.stamp = 0;
     
-    // CRITICAL: Ensure we're using texture unit 0 for shader-based rendering
-    // Without this, the texture may be bound to the wrong unit
-    glActiveTexture(GL_TEXTURE0);
+    // Pooled storage keeps its last filtering; tiles are drawn unmipmapped
+    glState_.bindTexture(0, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    // The top tile stands in wherever nothing finer is resident yet
+    uint32_t top = static_cast<uint32_t>(image->getPyramid().getTileCount() - 1);
+    uint32_t evicted = TileResidency::NO_TILE;
+    uploadTile(cache, top, cache.residency.allocate(top, 0, evicted));
+    cache.residency.pin(top);
+    
+    LOG_INFO << "OpenGLRenderer: Tile atlas of layer " << layerId << ": " << cache.residency.getSlotCount()
+             << " tiles (" << (TexturePool::textureBytes(key) >> 20) << " MB)";
+    return &cache;
+}
+
+void OpenGLRenderer::uploadTile(TiledLayerTexture& cache, uint32_t tile, int slot) {
+    const uint8_t* data = cache.image->tileData(tile);
+    if (!data || slot < 0) {
+        return;
+    }
+    // Straight from the mapping (the streaming thread has read it in)
+    int stride = cache.image->getTileStride();
+    glState_.bindTexture(0, cache.textureId);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % cache.columns) * stride, (slot / cache.columns) * stride,
+                    stride, stride, GL_BGRA, GL_UNSIGNED_BYTE, data);
+}
+
+void OpenGLRenderer::releaseTiledTexture(TiledLayerTexture& cache) {
+    TexturePool::Key key;
+    key.width = cache.width;
+    key.height = cache.height;
+    key.internalFormat = GL_RGBA8;
+    key.levels = 1;
+    TexturePool::instance().releaseTexture(cache.textureId, key);
+    cache.textureId = 0;
+    cache.image.reset();
+}
+
+void OpenGLRenderer::releaseOrphanedTiledTextures() {
+    // The atlas holds the last reference once the layer's still is closed
+    for (auto it = tiledTextures_.begin(); it != tiledTextures_.end();) {
+        if (it->second.image.use_count() == 1) {
+            releaseTiledTexture(it->second);
+            it = tiledTextures_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool OpenGLRenderer::renderTiledImage(int layerId, const std::shared_ptr<TiledImage>& image,
+                                      const LayerProperties& props, float quad_x, float quad_y) {
+    // Packed halves would straddle tiles: such layers draw the overview
+    if (props.packedAlpha != PackedAlpha::Layout::NONE || viewportWidth_ <= 0 || viewportHeight_ <= 0) {
+        return false;
+    }
+    TiledLayerTexture* cache = tiledTexture(layerId, image);
+    if (!cache) {
+        return false;
+    }
+    flushLayerBatch();
     
-    glEnable(target);
-    glBindTexture(target, textureId);
+    uint32_t features = 0;
+    ShaderProgram* shader = layerShader(ShaderKind::RGBA, props, features, quad_x, quad_y);
+    if (features & (VideoShaders::FEATURE_ANISOTROPIC | VideoShaders::FEATURE_EFFECTS)) {
+        // Gradient sampling reaches past the tile borders into the next slot,
+        // and effects would read the atlas as the image
+        features &= ~static_cast<uint32_t>(VideoShaders::FEATURE_ANISOTROPIC | VideoShaders::FEATURE_EFFECTS);
+        shader = shaderCache_->get(ShaderKind::RGBA, features);
+    }
+    if (!shader) {
+        return false;
+    }
     
-    // Set texture parameters
-    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // The program's transform on the CPU: which tiles are on screen, how large
+    float mvp[16];
+    computeMVPMatrix(mvp, 0.0f, 0.0f, quad_x, quad_y, props);
+    const float* homography = nullptr;
+    if (features & VideoShaders::FEATURE_HOMOGRAPHY) {
+        homography = cornerWarps_.get(quad_x, quad_y, props.cornerDeform.corners).matrix;
+    }
+    const float width = static_cast<float>(viewportWidth_);
+    const float height = static_cast<float>(viewportHeight_);
+    auto toScreen = [&](float u, float v, float& x, float& y) {
+        float pos[4] = {-1.0f + 2.0f * u, 1.0f - 2.0f * v, 0.0f, 1.0f};
+        if (homography) {
+            float warped[4];
+            for (int row = 0; row < 4; ++row) {
+                warped[row] = homography[row] * pos[0] + homography[4 + row] * pos[1] + homography[12 + row] * pos[3];
+            }
+            memcpy(pos, warped, sizeof(pos));
+        }
+        float clip[4];
+        for (int row = 0; row < 4; ++row) {
+            clip[row] = mvp[row] * pos[0] + mvp[4 + row] * pos[1] + mvp[8 + row] * pos[2] + mvp[12 + row] * pos[3];
+        }
+        if (clip[3] <= 1e-6f) {
+            return false;
+        }
+        x = (clip[0] / clip[3] + 1.0f) * 0.5f * width;
+        y = (clip[1] / clip[3] + 1.0f) * 0.5f * height;
+        return true;
+    };
+    TilePyramid::Projector project = [&](float u0, float v0, float u1, float v1, float& across, float& down) {
+        const float us[4] = {u0, u1, u1, u0};
+        const float vs[4] = {v0, v0, v1, v1};
+        float x[4];
+        float y[4];
+        for (int i = 0; i < 4; ++i) {
+            if (!toScreen(us[i], vs[i], x[i], y[i])) {
+                // Reaches behind the view: refine (the tile budget bounds it)
+                across = down = std::numeric_limits<float>::max();
+                return true;
+            }
+        }
+        if (std::max({x[0], x[1], x[2], x[3]}) < 0.0f || std::min({x[0], x[1], x[2], x[3]}) > width ||
+            std::max({y[0], y[1], y[2], y[3]}) < 0.0f || std::min({y[0], y[1], y[2], y[3]}) > height) {
+            return false;
+        }
+        auto edge = [&x, &y](int a, int b) { return std::hypot(x[b] - x[a], y[b] - y[a]); };
+        across = std::max(edge(0, 1), edge(3, 2));
+        down = std::max(edge(0, 3), edge(1, 2));
+        return true;
+    };
     
-    // Set texture environment mode
-    // GL_REPLACE: Use texture color directly (ignores vertex color, preserves texture alpha)
-    // This is appropriate for video textures where we want the exact texture colors
-    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    const TilePyramid& pyramid = image->getPyramid();
+    TileResidency& residency = cache->residency;
+    size_t budget = std::max<size_t>(1, residency.getSlotCount() - 1);  // The top tile has its own
+    pyramid.select(project, budget, tiledSelection_);
+    
+    // Tiles on screen are used at this stamp before any slot changes hands
+    uint64_t stamp = ++cache->stamp;
+    for (const TilePyramid::Tile& tile : tiledSelection_) {
+        residency.use(pyramid.tileIndex(tile), stamp);
+    }
+    
+    const int stride = image->getTileStride();
+    const float atlasWidth = static_cast<float>(cache->width);
+    const float atlasHeight = static_cast<float>(cache->height);
+    tiledWanted_.clear();
+    tiledVertices_.clear();
+    int uploads = 0;
+    for (const TilePyramid::Tile& tile : tiledSelection_) {
+        uint32_t index = pyramid.tileIndex(tile);
+        int slot = residency.find(index);
+        if (slot < 0) {
+            if (uploads < MAX_TILE_UPLOADS && image->isPrefetched(index)) {
+                uint32_t evicted = TileResidency::NO_TILE;
+                slot = residency.allocate(index, stamp, evicted);
+                if (slot >= 0) {
+                    uploadTile(*cache, index, slot);
+                    ++uploads;
+                }
+            } else {
+                tiledWanted_.push_back(index);
+            }
+        }
+        
+        // Not resident yet: the region from the nearest resident ancestor
+        TilePyramid::Tile source = tile;
+        while (slot < 0 && source.level < pyramid.getTopLevel()) {
+            source.level += 1;
+            source.x /= 2;
+            source.y /= 2;
+            slot = residency.use(pyramid.tileIndex(source), stamp);
+        }
+        if (slot < 0) {
+            continue;
+        }
+        
+        float u[2];
+        float v[2];
+        pyramid.tileRegion(tile, u[0], v[0], u[1], v[1]);
+        float originX = static_cast<float>((slot % cache->columns) * stride + TiledImage::BORDER);
+        float originY = static_cast<float>((slot / cache->columns) * stride + TiledImage::BORDER);
+        float corner[4][4];
+        for (int i = 0; i < 4; ++i) {
+            float cu = u[i == 1 || i == 2];
+            float cv = v[i >= 2];
+            float tx, ty;
+            pyramid.tileTexels(source, cu, cv, tx, ty);
+            corner[i][0] = -1.0f + 2.0f * cu;
+            corner[i][1] = 1.0f - 2.0f * cv;
+            corner[i][2] = (originX + tx) / atlasWidth;
+            corner[i][3] = (originY + ty) / atlasHeight;
+        }
+        const int order[6] = {0, 1, 2, 0, 2, 3};
+        for (int i : order) {
+            tiledVertices_.insert(tiledVertices_.end(), corner[i], corner[i] + 4);
+        }
+    }
+    image->prefetch(tiledWanted_);
+    if (tiledVertices_.empty()) {
+        return true;
+    }
     
-    // Update texture dimensions for rendering
-    const FrameInfo& info = gpuFrame.info();
-    textureWidth_ = info.width;
-    textureHeight_ = info.height;
+    applyBlendModeFromProps(props);
+    glState_.useProgram(shader->getProgramId());
+    shader->setUniform("uTexture", 0);
+    shader->setUniform("uOpacity", props.opacity * masterOpacity_);
+    if (features & VideoShaders::FEATURE_COLOR_CORRECTION) {
+        setColorCorrectionUniforms(shader, props.colorAdjust);
+    }
+    if (homography) {
+        shader->setUniformMatrix4fv("uHomography", homography);
+    }
+    shader->setUniformMatrix4fv("uMVP", mvp);
+    glState_.bindTexture(0, cache->textureId);
     
+    // Same vertex layout as the OSD quads, streamed the same way
+    glState_.bindVertexArray(osdVAO_);
+    glBindBuffer(GL_ARRAY_BUFFER, osdVBO_);
+    glBufferData(GL_ARRAY_BUFFER, tiledVertices_.size() * sizeof(float), tiledVertices_.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    beginAdvancedBlend(shader, features, props, mvp, homography);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(tiledVertices_.size() / 4));
+    endAdvancedBlend(features);
     return true;
 }
 
-void OpenGLRenderer::renderQuad(float x, float y, float width, float height) {
-    // Use pixel coordinates for GL_TEXTURE_RECTANGLE_ARB (matches original xjadeo)
-    glBegin(GL_QUADS);
-    glTexCoord2f(0.0f, (GLfloat)textureHeight_); glVertex2f(x, y);
-    glTexCoord2f((GLfloat)textureWidth_, (GLfloat)textureHeight_); glVertex2f(x + width, y);
-    glTexCoord2f((GLfloat)textureWidth_, 0.0f); glVertex2f(x + width, y + height);
-    glTexCoord2f(0.0f, 0.0f); glVertex2f(x, y + height);
-    glEnd();
+void OpenGLRenderer::setViewport(int x, int y, int width, int height) {
+    viewportX_ = x;
+    viewportY_ = y;
+    viewportWidth_ = width;
+    viewportHeight_ = height;
+    glViewport(x, y, width, height);
+    // Called per target and frame: another surface's context or pass may
+    // have changed program, VAO and blend state since
+    glState_.invalidate();
 }
 
-void OpenGLRenderer::renderQuadWithCrop(float x, float y, float width, float height,
-                                       float texX, float texY, float texWidth, float texHeight) {
-    // This function is used for both GL_TEXTURE_RECTANGLE_ARB (pixel coords) and GL_TEXTURE_2D (normalized coords)
-    // For GL_TEXTURE_2D (HAP), texX/texY/texWidth/texHeight are already normalized (0.0-1.0)
-    // For GL_TEXTURE_RECTANGLE_ARB, we need to convert to pixel coordinates
-    // We'll detect which one based on whether the texture is bound as GL_TEXTURE_2D or GL_TEXTURE_RECTANGLE_ARB
-    // For now, assume normalized coordinates (GL_TEXTURE_2D) since this is called for HAP
+bool OpenGLRenderer::bindGPUTexture(const GPUTextureFrameBuffer& gpuFrame) {
+    if (!gpuFrame.isValid()) {
+        return false;
+    }
+
+    GLuint textureId = gpuFrame.getTextureId();
+    if (textureId == 0) {
+        return false;
+    }
+
+    // All GPU textures (HAP and hardware-decoded) use GL_TEXTURE_2D, on
+    // texture unit 0 for the shaders. Filtering and wrapping are set where
+    // the texture is created (GPUTextureFrameBuffer, the interops), not per frame.
+    glState_.bindTexture(0, textureId);
     
-    // Use normalized texture coordinates (0.0-1.0) for GL_TEXTURE_2D
-    glBegin(GL_QUADS);
-    glTexCoord2f(texX, texY + texHeight); glVertex2f(x, y);
-    glTexCoord2f(texX + texWidth, texY + texHeight); glVertex2f(x + width, y);
-    glTexCoord2f(texX + texWidth, texY); glVertex2f(x + width, y + height);
-    glTexCoord2f(texX, texY); glVertex2f(x, y + height);
-    glEnd();
+    return true;
 }
 
 void OpenGLRenderer::calculateCropCoordinates(const VideoLayer* layer, float& texX, float& texY, 
@@ -409,70 +819,6 @@ void OpenGLRenderer::calculateCropCoordinatesFromProps(const LayerProperties& pr
     }
 }
 
-void OpenGLRenderer::applyLayerTransform(const VideoLayer* layer) {
-    if (!layer) return;
-    
-    // Default quad size for backward compatibility
-    applyLayerTransform(layer, 1.0f, 1.0f);
-}
-
-void OpenGLRenderer::applyLayerTransform(const VideoLayer* layer, float quad_x, float quad_y) {
-    if (!layer) return;
-    applyLayerTransformFromProps(layer->properties(), quad_x, quad_y);
-}
-
-void OpenGLRenderer::applyLayerTransformFromProps(const LayerProperties& props, float quad_x, float quad_y) {
-    // Apply position (x, y) - convert from pixel coordinates to normalized coordinates
-    // Viewport is -1 to 1, so we need to scale by viewport size
-    if (viewportWidth_ > 0 && viewportHeight_ > 0) {
-        float normX = (2.0f * props.x) / viewportWidth_;
-        float normY = (2.0f * props.y) / viewportHeight_;
-        glTranslatef(normX, -normY, 0.0f);  // Negative Y because OpenGL Y is inverted
-    }
-    
-    // Apply scale
-    glScalef(props.scaleX, props.scaleY, 1.0f);
-    
-    // Apply rotation (around center)
-    if (props.rotation != 0.0f) {
-        glTranslatef(0.5f, 0.5f, 0.0f);
-        glRotatef(props.rotation, 0.0f, 0.0f, 1.0f);
-        glTranslatef(-0.5f, -0.5f, 0.0f);
-    }
-    
-    // Apply corner deformation (warping) if enabled
-    if (props.cornerDeform.enabled) {
-        // Calculate source corners (base quad)
-        Point src[4];
-        src[0].x = -quad_x;
-        src[0].y = -quad_y;
-        src[1].x = quad_x;
-        src[1].y = -quad_y;
-        src[2].x = quad_x;
-        src[2].y = quad_y;
-        src[3].x = -quad_x;
-        src[3].y = quad_y;
-        
-        // Calculate destination corners (with deformation offsets)
-        Point dst[4];
-        dst[0].x = src[0].x + props.cornerDeform.corners[0];
-        dst[0].y = src[0].y + props.cornerDeform.corners[1];
-        dst[1].x = src[1].x + props.cornerDeform.corners[2];
-        dst[1].y = src[1].y + props.cornerDeform.corners[3];
-        dst[2].x = src[2].x + props.cornerDeform.corners[4];
-        dst[2].y = src[2].y + props.cornerDeform.corners[5];
-        dst[3].x = src[3].x + props.cornerDeform.corners[6];
-        dst[3].y = src[3].y + props.cornerDeform.corners[7];
-        
-        // Calculate homography matrix
-        GLfloat homography[16];
-        findHomography(src, dst, homography);
-        
-        // Apply homography matrix
-        glMultMatrixf(homography);
-    }
-}
-
 void OpenGLRenderer::applyBlendMode(const VideoLayer* layer) {
     if (!layer) return;
     applyBlendModeFromProps(layer->properties());
@@ -481,21 +827,183 @@ void OpenGLRenderer::applyBlendMode(const VideoLayer* layer) {
 void OpenGLRenderer::applyBlendModeFromProps(const LayerProperties& props) {
     switch (props.blendMode) {
         case LayerProperties::NORMAL:
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glState_.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
             break;
         case LayerProperties::MULTIPLY:
-            glBlendFunc(GL_DST_COLOR, GL_ZERO);
+            glState_.blendFunc(GL_DST_COLOR, GL_ZERO);
             break;
         case LayerProperties::SCREEN:
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_COLOR);
+            glState_.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_COLOR);
             break;
         case LayerProperties::OVERLAY:
             // Simplified overlay blend
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            glState_.blendFunc(GL_SRC_ALPHA, GL_ONE);
             break;
     }
 }
 
+void OpenGLRenderer::beginAdvancedBlend(ShaderProgram* shader, uint32_t features, const LayerProperties& props,
+                                        const float* mvp, const float* homography) {
+    // Programs without the feature (HAP) keep the glBlendFunc approximation
+    if (!(features & VideoShaders::FEATURE_ADVANCED_BLEND)) {
+        return;
+    }
+    if (blendPath_ == AdvancedBlend::Path::BLEND_EQUATION) {
+        GLenum equation = props.blendMode == LayerProperties::MULTIPLY ? GL_MULTIPLY_KHR
+                        : props.blendMode == LayerProperties::SCREEN   ? GL_SCREEN_KHR
+                                                                       : GL_OVERLAY_KHR;
+        glState_.setBlend(true);
+        glBlendEquation(equation);
+        if (!blendCoherent_) {
+            // Orders this draw after the ones below it
+            glBlendBarrierKHR();
+        }
+        return;
+    }
+    
+    shader->setUniform("uBlendMode", static_cast<int>(props.blendMode));
+    if (blendPath_ == AdvancedBlend::Path::COPY_BOUNDS) {
+        // Only the pixels the layer can touch are copied, not the canvas
+        GLint viewport[4] = {0, 0, 0, 0};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        AdvancedBlend::Region view;
+        view.x = viewport[0];
+        view.y = viewport[1];
+        view.width = viewport[2];
+        view.height = viewport[3];
+        AdvancedBlend::Region bounds;
+        if (!AdvancedBlend::layerBounds(mvp, homography, view, bounds)) {
+            bounds.width = bounds.height = 1;  // Off screen: the copy is never read
+        }
+        
+        glActiveTexture(GL_TEXTURE0 + AdvancedBlend::DESTINATION_TEXTURE_UNIT);
+        if (blendDestTexture_ == 0 || bounds.width > blendDestWidth_ || bounds.height > blendDestHeight_) {
+            // Grows in steps, so a layer scaling up does not reallocate every frame
+            if (blendDestTexture_ == 0) {
+                glGenTextures(1, &blendDestTexture_);
+            }
+            blendDestWidth_ = std::max(blendDestWidth_, (bounds.width + 255) & ~255);
+            blendDestHeight_ = std::max(blendDestHeight_, (bounds.height + 255) & ~255);
+            glBindTexture(GL_TEXTURE_2D, blendDestTexture_);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, blendDestWidth_, blendDestHeight_, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        } else {
+            glBindTexture(GL_TEXTURE_2D, blendDestTexture_);
+        }
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, bounds.x, bounds.y, bounds.width, bounds.height);
+        glActiveTexture(GL_TEXTURE0);
+        // The copy went on its own unit; the active unit is no longer known
+        glState_.invalidateTextures();
+        
+        shader->setUniform("uBlendDestination", AdvancedBlend::DESTINATION_TEXTURE_UNIT);
+        shader->setUniform("uBlendDestinationRect", static_cast<float>(bounds.x), static_cast<float>(bounds.y),
+                           1.0f / blendDestWidth_, 1.0f / blendDestHeight_);
+    }
+    // The program writes the blended result itself
+    glState_.setBlend(false);
+}
+
+void OpenGLRenderer::endAdvancedBlend(uint32_t features) {
+    if (!(features & VideoShaders::FEATURE_ADVANCED_BLEND)) {
+        return;
+    }
+    if (blendPath_ == AdvancedBlend::Path::BLEND_EQUATION) {
+        glBlendEquation(GL_FUNC_ADD);
+    } else {
+        glState_.setBlend(true);
+    }
+}
+
+const EffectTargetPool::Target* OpenGLRenderer::renderEffectFilter(const EffectChain::Plan& plan, ShaderKind kind,
+                                                                   uint32_t features,
+                                                                   const SourceUniforms& setSource) {
+    if (!plan.filter || !(features & VideoShaders::FEATURE_EFFECTS) || !effectBlurShader_ || !effectTargets_) {
+        return nullptr;
+    }
+    // The picture as the layer samples it, without placement, warp or blending
+    const uint32_t sourceFeatures = features & (VideoShaders::FEATURE_COLOR_CORRECTION |
+                                                VideoShaders::FEATURE_DEINTERLACE |
+                                                VideoShaders::FEATURE_PACKED_ALPHA);
+    ShaderProgram* source = shaderCache_->get(kind, sourceFeatures);
+    const EffectTargetPool::Target* image = effectTargets_->acquire(plan.width, plan.height);
+    const EffectTargetPool::Target* across = effectTargets_->acquire(plan.width, plan.height);
+    if (!source || !image || !across) {
+        effectTargets_->release(image);
+        effectTargets_->release(across);
+        return nullptr;
+    }
+    FRAME_TRACE_SCOPE("effects");
+    
+    GLint targetFBO = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &targetFBO);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    glState_.setBlend(false);
+    glState_.bindVertexArray(quadVAO_);
+    glViewport(0, 0, plan.width, plan.height);
+    
+    // Source at the reduced size: top of the picture in the top row
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    glBindFramebuffer(GL_FRAMEBUFFER, image->fbo);
+    setSource(source, sourceFeatures);
+    source->setUniform("uOpacity", 1.0f);
+    source->setUniformMatrix4fv("uMVP", identity);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    
+    // Separable Gaussian, across then down, on its own unit (the layer's
+    // planes stay bound for its draw)
+    ShaderProgram* blur = effectBlurShader_.get();
+    glState_.useProgram(blur->getProgramId());
+    blur->setUniform("uTexture", EffectChain::TEXTURE_UNIT);
+    blur->setUniform("uTaps", plan.taps);
+    for (int i = 0; i <= plan.taps; ++i) {
+        std::string index = "[" + std::to_string(i) + "]";
+        blur->setUniform("uOffsets" + index, plan.offsets[i]);
+        blur->setUniform("uWeights" + index, plan.weights[i]);
+    }
+    glActiveTexture(GL_TEXTURE0 + EffectChain::TEXTURE_UNIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, across->fbo);
+    glBindTexture(GL_TEXTURE_2D, image->texture);
+    blur->setUniform("uTexelStep", 1.0f / plan.width, 0.0f);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, image->fbo);
+    glBindTexture(GL_TEXTURE_2D, across->texture);
+    blur->setUniform("uTexelStep", 0.0f, 1.0f / plan.height);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glBindTexture(GL_TEXTURE_2D, image->texture);
+    glActiveTexture(GL_TEXTURE0);
+    // The filter went on its own unit; the active unit is no longer known
+    glState_.invalidateTextures();
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(targetFBO));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    glState_.setBlend(true);
+    
+    // The next layer's filter reuses it at once
+    effectTargets_->release(across);
+    return image;
+}
+
+void OpenGLRenderer::setEffectUniforms(ShaderProgram* shader, const LayerProperties::Effects& effects,
+                                       const EffectChain::Plan& plan, const EffectTargetPool::Target* filtered) {
+    // Filtered source on its unit (bound by renderEffectFilter)
+    shader->setUniform("uEffectFiltered", EffectChain::TEXTURE_UNIT);
+    shader->setUniform("uEffectFilterWeight", filtered ? plan.filterWeight : 0.0f);
+    const LayerProperties::Effects::ChromaKey& key = effects.chromaKey;
+    shader->setUniform("uEffectKeyColor", key.red, key.green, key.blue, key.enabled ? 1.0f : 0.0f);
+    shader->setUniform("uEffectKeyParams", key.similarity, std::max(key.smoothness, 0.0001f), key.spill);
+    shader->setUniform("uEffectVignette", effects.vignetteAmount, effects.vignetteSoftness);
+}
+
 bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
     if (!layer || !layer->isReady()) {
         return false;
@@ -506,6 +1014,16 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
     if (!props.visible) {
         return false;
     }
+    
+    // Interlaced sources show the field due now; every other draw whole frames
+    FieldOrder fieldOrder = layer->getFrameInfo().fieldOrder;
+    layerField_.phase = layer->getFieldPhase();
+    layerField_.parity = FieldSelector::parity(deinterlaceMode_, fieldOrder, layerField_.phase);
+    layerField_.adaptive = FieldSelector::resolve(deinterlaceMode_, fieldOrder) == FieldSelector::Mode::ADAPTIVE;
+    struct FieldReset {
+        LayerField& field;
+        ~FieldReset() { field = LayerField(); }
+    } fieldReset{layerField_};
 
             // Check if frame is on GPU (hardware-decoded)
             const FrameBuffer* cpuBuffer = nullptr;
@@ -524,13 +1042,14 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
                 
                 const FrameInfo& info = cpuBuffer->info();
                 int layerId = layer->getLayerId();
+                if (isShaderYUV(info.format)) {
+                    // YUV from software decode or a live input: upload planes, convert in shader
+                    return renderPlanarFrame(layerId, *cpuBuffer, props, layer->getFrameInfo(),
+                                             layer->getFrameGeneration());
+                }
                 int layerTextureWidth = info.width;
                 int layerTextureHeight = info.height;
                 
-                // Check if we have a cached texture for this layer
-                GLuint layerTextureId = 0;
-                auto cacheIt = layerTextureCache_.find(layerId);
-                
         // Calculate quad size with letterboxing (matches original xjadeo)
         // Original uses _gl_quad_x and _gl_quad_y for letterboxing
         float quad_x = 1.0f;
@@ -541,7 +1060,7 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
         
         if (letterbox_) {
             // Calculate aspect ratios (matches original xjadeo logic)
-            float asp_src = frameInfo.aspect > 0.0f ? frameInfo.aspect : (float)props.width / (float)props.height;
+            float asp_src = layerAspect(props, frameInfo);
             float asp_dst = (float)viewportWidth_ / (float)viewportHeight_;
             
             if (asp_dst > asp_src) {
@@ -556,10 +1075,9 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
         }
         
         // Always use shader-based rendering for CPU frames when shaders available
-        // This provides consistent behavior and supports color correction
-        // The uniform branch (uColorCorrectionEnabled) has negligible overhead (~0.02%)
-        // compared to the potential visual artifacts from switching render paths mid-playback
-        if (useShaders_ && rgbaShader_) {
+        // This provides consistent behavior and supports color correction; the
+        // program is specialized, so unused stages cost nothing
+        if (shaderCache_) {
             // Shader-based rendering path for CPU frames
             // Uses GL_TEXTURE_2D for shader compatibility
             
@@ -567,49 +1085,82 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
             GLuint shaderTextureId = 0;
             auto cacheIt = layerTextureCache_.find(layerId);
             
-            LayerTextureCache* cachePtr = nullptr;
-            if (cacheIt != layerTextureCache_.end() &&
-                cacheIt->second.width == layerTextureWidth &&
-                cacheIt->second.height == layerTextureHeight) {
-                shaderTextureId = cacheIt->second.textureId;
-                cachePtr = &cacheIt->second;
-            } else {
-                // Create new GL_TEXTURE_2D
-                if (cacheIt != layerTextureCache_.end()) {
-                    texturesToDelete_.push_back(cacheIt->second.textureId);
-                    cleanupLayerPBOs(cacheIt->second);
-                    layerTextureCache_.erase(cacheIt);
-                }
-                
-                glGenTextures(1, &shaderTextureId);
-                glBindTexture(GL_TEXTURE_2D, shaderTextureId);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, layerTextureWidth, layerTextureHeight, 
-                             0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
-                
-                LayerTextureCache cache;
-                cache.textureId = shaderTextureId;
-                cache.width = layerTextureWidth;
-                cache.height = layerTextureHeight;
-                cache.pbo[0] = 0;
-                cache.pbo[1] = 0;
-                cache.pboIndex = 0;
-                cache.pboInitialized = false;
-                layerTextureCache_[layerId] = cache;
-                cachePtr = &layerTextureCache_[layerId];
+            // Zero-copy: the layer decoded straight into one of our mapped PBOs
+            std::shared_ptr<MappedFrameRing> ring = layer->getFrameRing();
+            int ringSlot = ring ? ring->indexOf(cpuBuffer) : -1;
+            if (!ring && cacheIt != layerTextureCache_.end() && cacheIt->second.ring) {
+                // Layer now modifies frames on the CPU - stop decoding into GL memory
+                releaseFrameRing(cacheIt->second);
             }
             
-            // Upload frame data using PBO double-buffering for async transfer
-            // This avoids blocking the render thread during CPU→GPU copy
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, shaderTextureId);
+            // Still image: uploaded once into the layer's cached texture
+            bool still = layer->hasStaticFrame();
             
-            size_t dataSize = static_cast<size_t>(layerTextureWidth) * layerTextureHeight * 4;
+            // Giant still: the tiles on screen instead (the frame is its overview)
+            if (still) {
+                std::shared_ptr<TiledImage> tiled = layer->getTiledImage();
+                if (tiled && renderTiledImage(layerId, tiled, props, quad_x, quad_y)) {
+                    return true;
+                }
+            }
+            
+            // Cue armed before GO: the frame was uploaded while the layer was hidden
+            bool armedUpload = !still && ringSlot < 0 && hasArmedUpload(layer);
+            
+            // Upload thread: texture arrives fenced, nothing to copy here
+            TextureUploader::Texture uploaded;
+            bool useUploader = !still && !armedUpload && ringSlot < 0 && isUploadThreadEnabled() &&
+                               uploader_->wait(layerId, *cpuBuffer, uploaded);
+            
+            LayerTextureCache* cachePtr = nullptr;
+            if (useUploader) {
+                shaderTextureId = uploaded.textureId;
+            } else {
+                // Stills keep a mipmap chain so scaled-down logos stay clean
+                int levels = still ? TexturePool::fullMipLevels(layerTextureWidth, layerTextureHeight) : 1;
+                cachePtr = &layerTexture(layerId, layerTextureWidth, layerTextureHeight, levels);
+                shaderTextureId = cachePtr->textureId;
+                if (shaderTextureId == 0) {
+                    return false;  // Refused by the memory budget
+                }
+            }
+            
+            // Upload frame data using PBO double-buffering for async transfer
+            // This avoids blocking the render thread during CPU→GPU copy
+            glState_.bindTexture(0, shaderTextureId);
             
-            if (cachePtr && initLayerPBOs(*cachePtr, layerTextureWidth, layerTextureHeight)) {
+            size_t dataSize = static_cast<size_t>(layerTextureWidth) * layerTextureHeight * 4;
+            
+            if (cachePtr && cachePtr->stillGeneration != 0 && !still) {
+                // The layer plays video again: only level 0 is uploaded from now on
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                cachePtr->stillGeneration = 0;
+            }
+            
+            if (cachePtr && !armedUpload) {
+                cachePtr->armedGeneration = 0;
+            }
+            
+            if (useUploader) {
+                // Make the GPU wait for the upload before sampling
+                glWaitSync(uploaded.fence, 0, GL_TIMEOUT_IGNORED);
+                glDeleteSync(uploaded.fence);
+            } else if (armedUpload) {
+                // Texture already holds this frame
+            } else if (still && cachePtr) {
+                // Direct upload (a PBO would show it one composite late), with
+                // mipmaps so scaled-down logos stay clean; then never again
+                uint64_t generation = layer->getFrameGeneration();
+                if (cachePtr->stillGeneration != generation) {
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, layerTextureWidth, layerTextureHeight,
+                                    GL_BGRA, GL_UNSIGNED_BYTE, cpuBuffer->data());
+                    glGenerateMipmap(GL_TEXTURE_2D);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                    cachePtr->stillGeneration = generation;
+                }
+            } else if (ringSlot >= 0 && cachePtr && cachePtr->ring == ring) {
+                uploadFromFrameRing(*cachePtr, ringSlot);
+            } else if (cachePtr && initLayerPBOs(*cachePtr, layerTextureWidth, layerTextureHeight)) {
                 // PBO path: async upload
                 int currentPBO = cachePtr->pboIndex;
                 int nextPBO = 1 - currentPBO;
@@ -639,41 +1190,61 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
                             GL_BGRA, GL_UNSIGNED_BYTE, cpuBuffer->data());
             }
             
+            if (ring && cachePtr && !cachePtr->ring && !still) {
+                // Offer mapped PBOs for the next decode (copy path until then)
+                attachFrameRing(*cachePtr, ring, info);
+            }
+            
+            // Plain layers join the pending instanced draw (uploader textures
+            // are handed back at the end of this draw, so those draw now)
+            if (!useUploader && canBatch(props)) {
+                queueBatchedLayer(shaderTextureId, quad_x, quad_y, props);
+                return true;
+            }
+            flushLayerBatch();
+            
             // Apply blend mode
             applyBlendModeFromProps(props);
             
             // Use shader
-            ShaderProgram* shader = (props.cornerDeform.enabled && 
-                                     props.cornerDeform.highQuality && 
-                                     rgbaShaderHQ_) 
-                                   ? rgbaShaderHQ_.get() 
-                                   : rgbaShader_.get();
-            shader->use();
-            shader->setUniform("uTexture", 0);
-            shader->setUniform("uOpacity", props.opacity);
+            uint32_t features = 0;
+            ShaderProgram* shader = layerShader(ShaderKind::RGBA, props, features, quad_x, quad_y);
+            auto setSource = [&](ShaderProgram* program, uint32_t programFeatures) {
+                glState_.useProgram(program->getProgramId());
+                program->setUniform("uTexture", 0);
+                if (programFeatures & VideoShaders::FEATURE_COLOR_CORRECTION) {
+                    setColorCorrectionUniforms(program, props.colorAdjust);
+                }
+                if (programFeatures & VideoShaders::FEATURE_DEINTERLACE) {
+                    setFieldUniforms(program);
+                }
+                if (programFeatures & VideoShaders::FEATURE_PACKED_ALPHA) {
+                    setPackedAlphaUniforms(program, props, layerTextureWidth, layerTextureHeight, 0.5f);
+                }
+            };
             
-            // Set color correction uniforms (uses uniform branch for zero-cost when disabled)
-            setColorCorrectionUniforms(shader, props.colorAdjust);
+            // Blur and sharpen read the frame filtered at reduced size
+            EffectChain::Plan effectPlan;
+            const EffectTargetPool::Target* filtered = nullptr;
+            if (features & VideoShaders::FEATURE_EFFECTS) {
+                effectPlan = EffectChain::plan(props.effects, layerTextureWidth, layerTextureHeight);
+                filtered = renderEffectFilter(effectPlan, ShaderKind::RGBA, features, setSource);
+            }
+            
+            setSource(shader, features);
+            shader->setUniform("uOpacity", props.opacity * masterOpacity_);
+            if (features & VideoShaders::FEATURE_ANISOTROPIC) {
+                shader->setUniform("uAnisotropy", 4.0f);
+            }
+            if (features & VideoShaders::FEATURE_EFFECTS) {
+                setEffectUniforms(shader, props.effects, effectPlan, filtered);
+            }
             
             // Handle corner deformation
-            if (props.cornerDeform.enabled) {
-                Point src[4], dst[4];
-                src[0].x = -quad_x; src[0].y = -quad_y;
-                src[1].x = quad_x;  src[1].y = -quad_y;
-                src[2].x = quad_x;  src[2].y = quad_y;
-                src[3].x = -quad_x; src[3].y = quad_y;
-                
-                for (int i = 0; i < 4; ++i) {
-                    dst[i].x = src[i].x + props.cornerDeform.corners[i * 2];
-                    dst[i].y = src[i].y + props.cornerDeform.corners[i * 2 + 1];
-                }
-                
-                GLfloat homography[16];
-                findHomography(src, dst, homography);
-                shader->setUniform("uUseHomography", 1);
+            const float* homography = nullptr;
+            if (features & VideoShaders::FEATURE_HOMOGRAPHY) {
+                homography = cornerWarps_.get(quad_x, quad_y, props.cornerDeform.corners).matrix;
                 shader->setUniformMatrix4fv("uHomography", homography);
-            } else {
-                shader->setUniform("uUseHomography", 0);
             }
             
             // Compute MVP matrix
@@ -682,180 +1253,1260 @@ bool OpenGLRenderer::renderLayer(const VideoLayer* layer) {
             shader->setUniformMatrix4fv("uMVP", mvp);
             
             // Draw using VAO
-            glBindVertexArray(quadVAO_);
+            glState_.bindVertexArray(quadVAO_);
+            beginAdvancedBlend(shader, features, props, mvp, homography);
             glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-            glBindVertexArray(0);
+            endAdvancedBlend(features);
+            if (filtered) {
+                effectTargets_->release(filtered);
+            }
             
-            shader->unbind();
-            glBindTexture(GL_TEXTURE_2D, 0);
+            if (useUploader) {
+                uploader_->release(layerId, uploaded);
+            }
             
             return true;
         }
         
-        // Fixed-function fallback (only if shaders unavailable - legacy systems)
-        // Use GL_TEXTURE_RECTANGLE_ARB for fixed-function path
-        if (cacheIt != layerTextureCache_.end()) {
-            // Texture exists - check if size matches
-            if (cacheIt->second.width == layerTextureWidth && 
-                cacheIt->second.height == layerTextureHeight) {
-                // Reuse existing texture
-                layerTextureId = cacheIt->second.textureId;
-            } else {
-                // Size changed - delete old texture and create new one
-                texturesToDelete_.push_back(cacheIt->second.textureId);
-                layerTextureCache_.erase(cacheIt);
-                cacheIt = layerTextureCache_.end();
-            }
+        // Renderer not initialized: no programs to draw with
+        return false;
+    } else {
+        // No valid frame available
+        return false;
+    }
+}
+
+OpenGLRenderer::LayerTextureCache& OpenGLRenderer::layerTexture(int layerId, int width, int height, int levels,
+                                                                 bool warmup) {
+    auto cacheIt = layerTextureCache_.find(layerId);
+    if (cacheIt != layerTextureCache_.end() &&
+        cacheIt->second.width == width && cacheIt->second.height == height &&
+        cacheIt->second.levels == levels) {
+        if (cacheIt->second.warmup && !warmup) {
+            // The armed layer went live: its texture is no longer evictable
+            TexturePool::instance().reassignTexture(
+                cacheIt->second.textureId,
+                MemoryBudget::Account(MemoryBudget::Subsystem::LAYER_TEXTURES, layerId));
+            cacheIt->second.warmup = false;
+        }
+        return cacheIt->second;
+    }
+    
+    // Old texture and PBOs go back to the pool (reused once the GPU is done)
+    if (cacheIt != layerTextureCache_.end()) {
+        releaseLayerTexture(cacheIt->second);
+        layerTextureCache_.erase(cacheIt);
+    }
+    
+    TexturePool::Key key;
+    key.width = width;
+    key.height = height;
+    key.internalFormat = GL_RGBA8;
+    key.levels = levels;
+    MemoryBudget::Subsystem subsystem =
+        warmup ? MemoryBudget::Subsystem::ARMED_UPLOADS : MemoryBudget::Subsystem::LAYER_TEXTURES;
+    GLuint textureId = TexturePool::instance().acquireTexture(key, MemoryBudget::Account(subsystem, layerId));
+    // The pool binds (and unbinds) new textures on the active unit
+    glState_.invalidateTextures();
+    if (textureId == 0) {
+        // Over the budget: nothing cached, the layer is skipped this frame
+        noTexture_ = LayerTextureCache();
+        return noTexture_;
+    }
+    glState_.bindTexture(0, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    LayerTextureCache cache;
+    cache.textureId = textureId;
+    cache.width = width;
+    cache.height = height;
+    cache.levels = levels;
+    cache.layerId = layerId;
+    cache.warmup = warmup;
+    cache.pbo[0] = 0;
+    cache.pbo[1] = 0;
+    cache.pboIndex = 0;
+    cache.pboInitialized = false;
+    return layerTextureCache_[layerId] = cache;
+}
+
+void OpenGLRenderer::releaseLayerTexture(LayerTextureCache& cache) {
+    TexturePool::Key key;
+    key.width = cache.width;
+    key.height = cache.height;
+    key.internalFormat = GL_RGBA8;
+    key.levels = cache.levels;
+    TexturePool::instance().releaseTexture(cache.textureId, key);
+    cache.textureId = 0;
+    cleanupLayerPBOs(cache);
+}
+
+size_t OpenGLRenderer::evictArmedUploads(size_t bytes) {
+    // Textures are only touched from the thread the context is current on
+    if (std::this_thread::get_id() != renderThread_) {
+        return 0;
+    }
+    size_t freed = 0;
+    for (auto it = layerTextureCache_.begin(); it != layerTextureCache_.end() && freed < bytes;) {
+        if (!it->second.warmup) {
+            ++it;
+            continue;
+        }
+        TexturePool::Key key;
+        key.width = it->second.width;
+        key.height = it->second.height;
+        key.internalFormat = GL_RGBA8;
+        key.levels = it->second.levels;
+        freed += TexturePool::textureBytes(key);
+        LOG_INFO << "OpenGLRenderer: Dropped the armed upload of layer " << it->first << " (memory budget)";
+        releaseLayerTexture(it->second);
+        it = layerTextureCache_.erase(it);
+    }
+    return freed;
+}
+
+bool OpenGLRenderer::hasArmedUpload(const VideoLayer* layer) const {
+    auto cacheIt = layerTextureCache_.find(layer->getLayerId());
+    return cacheIt != layerTextureCache_.end() && cacheIt->second.armedGeneration != 0 &&
+           cacheIt->second.armedGeneration == layer->getFrameGeneration();
+}
+
+void OpenGLRenderer::prepareArmedLayers(const std::vector<const VideoLayer*>& layers) {
+    for (const VideoLayer* layer : layers) {
+        if (!layer || !layer->isReady() || layer->properties().visible || !layer->isArmedFrameReady()) {
+            continue;
+        }
+        const FrameBuffer* cpuBuffer = nullptr;
+        const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+        if (layer->getPreparedFrame(cpuBuffer, gpuBuffer) || !cpuBuffer || !cpuBuffer->isValid()) {
+            continue;  // GPU-decoded frame: already a texture
         }
         
-        // Create new texture if needed
-        if (layerTextureId == 0) {
-            glGenTextures(1, &layerTextureId);
-            if (layerTextureId == 0) {
-                return false;
+        int layerId = layer->getLayerId();
+        uint64_t generation = layer->getFrameGeneration();
+        const FrameInfo& info = cpuBuffer->info();
+        if (isShaderYUV(info.format)) {
+            auto armed = planarArmedGenerations_.find(layerId);
+            if ((armed == planarArmedGenerations_.end() || armed->second != generation) &&
+                uploadPlanarFrame(layerId, *cpuBuffer)) {
+                planarArmedGenerations_[layerId] = generation;
             }
-            
-            glBindTexture(GL_TEXTURE_RECTANGLE_ARB, layerTextureId);
-            glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            // Use GL_REPLACE instead of GL_DECAL for proper texture rendering
-            // GL_DECAL blends with vertex color based on alpha, which can cause black output
-            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-            
-            // Allocate texture storage
-            glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA, 
-                         layerTextureWidth, layerTextureHeight, 0,
-                         GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
-            
-            // Cache the texture
-            LayerTextureCache cache;
-            cache.textureId = layerTextureId;
-            cache.width = layerTextureWidth;
-            cache.height = layerTextureHeight;
-            layerTextureCache_[layerId] = cache;
+            glState_.invalidateTextures();
+            continue;
+        }
+        if (!shaderCache_ || info.format != PixelFormat::BGRA32) {
+            continue;
         }
         
-        // Upload frame data to cached texture
-        // glEnable is deprecated in Core Profile - only use in compatibility mode
-        if (!isCoreProfile_) {
-        glEnable(GL_TEXTURE_RECTANGLE_ARB);
-        }
-        glBindTexture(GL_TEXTURE_RECTANGLE_ARB, layerTextureId);
-        glTexSubImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, 0, 0,
-                        layerTextureWidth, layerTextureHeight,
+        bool still = layer->hasStaticFrame();
+        int levels = still ? TexturePool::fullMipLevels(info.width, info.height) : 1;
+        LayerTextureCache& cache = layerTexture(layerId, info.width, info.height, levels, true);
+        if (cache.textureId == 0) {
+            continue;  // Refused by the memory budget: uploaded once it goes live
+        }
+        std::shared_ptr<MappedFrameRing> ring = layer->getFrameRing();
+        int ringSlot = ring ? ring->indexOf(cpuBuffer) : -1;
+        glState_.bindTexture(0, cache.textureId);
+        if (ringSlot >= 0 && cache.ring == ring) {
+            uploadFromFrameRing(cache, ringSlot);  // Draw path sees the slot as current
+            continue;
+        }
+        if ((still ? cache.stillGeneration : cache.armedGeneration) == generation) {
+            continue;
+        }
+        
+        // Direct upload: a PBO would hold the frame back one composite
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, info.width, info.height,
                         GL_BGRA, GL_UNSIGNED_BYTE, cpuBuffer->data());
+        if (still) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            cache.stillGeneration = generation;
+        } else {
+            cache.armedGeneration = generation;
+        }
+    }
+}
+
+void OpenGLRenderer::fillLoopCaches(const std::vector<const VideoLayer*>& layers) {
+    bool filled = false;
+    for (const VideoLayer* layer : layers) {
+        std::shared_ptr<LoopFrameCache> cache = layer && layer->isReady() ? layer->getLoopCache() : nullptr;
+        if (cache && cache->wants(layer->getLoadedFrame())) {
+            cacheLoopFrame(layer, *cache);
+            filled = true;
+        }
+    }
+    if (filled) {
+        // Textures, program and framebuffer were bound directly
+        glState_.invalidate();
+        glState_.setBlend(true);
+    }
+}
+
+bool OpenGLRenderer::cacheLoopFrame(const VideoLayer* layer, LoopFrameCache& cache) {
+    FRAME_TRACE_SCOPE("loop_cache");
+    const FrameBuffer* cpuBuffer = nullptr;
+    const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+    bool onGPU = layer->getPreparedFrame(cpuBuffer, gpuBuffer);
+    bool compress = cache.getMode() == LoopFrameCache::Mode::COMPRESSED;
+    int layerId = layer->getLayerId();
+    
+    auto frame = std::make_shared<GPUTextureFrameBuffer>();
+    frame->setBudgetAccount(MemoryBudget::Account(MemoryBudget::Subsystem::LOOP_TEXTURES, layerId));
+    const char* failure = nullptr;
+    if (onGPU && gpuBuffer && gpuBuffer->isValid()) {
+        failure = copyLoopFrame(*gpuBuffer, compress, *frame);
+    } else if (!onGPU && cpuBuffer && cpuBuffer->isValid()) {
+        failure = uploadLoopFrame(*cpuBuffer, compress, *frame);
+    } else {
+        return false;  // Nothing loaded yet
+    }
+    if (failure) {
+        cache.abandon(failure);
+        return false;
+    }
+    
+    // The first frame tells what the whole loop needs: give up now rather
+    // than evict everything else on the way
+    size_t bytes = frame->getTextureBytes();
+    MemoryBudget& budget = MemoryBudget::instance();
+    size_t limit = budget.getLimit(MemoryBudget::Pool::VRAM);
+    if (cache.getStats().frames == 0 && limit > 0 &&
+        budget.getUsed(MemoryBudget::Pool::VRAM) + bytes * static_cast<size_t>(cache.getLoopLength() - 1) > limit) {
+        cache.abandon("the loop does not fit the VRAM budget");
+        return false;
+    }
+    return cache.store(layer->getLoadedFrame(), std::move(frame), bytes);
+}
+
+const char* OpenGLRenderer::copyLoopFrame(const GPUTextureFrameBuffer& source, bool compress,
+                                          GPUTextureFrameBuffer& frame) {
+    if (!hasCopyImage_) {
+        return "texture copies need OpenGL 4.3 or ARB_copy_image";
+    }
+    if (source.isDeinterlaced()) {
+        return "fields deinterlaced by the decoder";
+    }
+    const FrameInfo& info = source.info();
+    TexturePlaneType planeType = source.getPlaneType();
+    bool allocated;
+    switch (planeType) {
+        case TexturePlaneType::SINGLE:
+            if (compress && !source.isHAPTexture() && info.width % 4 == 0 && info.height % 4 == 0 && bc1Encoder()) {
+                if (!frame.allocate(info, GL_COMPRESSED_RGB_S3TC_DXT1_EXT)) {
+                    return "refused by the memory budget";
+                }
+                return bc1Encoder_->encode(source.getTextureId(), info.width, info.height, frame.getTextureId())
+                           ? nullptr : "BC1 compression failed";
+            }
+            allocated = frame.allocate(info, source.getTextureFormat(), source.isHAPTexture());
+            frame.setHapVariant(source.getHapVariant());
+            break;
+        case TexturePlaneType::HAP_Q_ALPHA:
+            allocated = frame.allocateHapQAlpha(info);
+            frame.setHapVariant(source.getHapVariant());
+            break;
+        case TexturePlaneType::YUV_P010:
+            return "16-bit decoder surfaces";
+        default:
+            // Hardware decoded YUV planes stay as they are: no GPU YUV encoder
+            allocated = frame.allocateMultiPlane(info, planeType);
+            break;
+    }
+    if (!allocated) {
+        return "refused by the memory budget";
+    }
+    while (glGetError() != GL_NO_ERROR) {}
+    for (int plane = 0; plane < frame.getNumPlanes(); ++plane) {
+        const TexturePool::Key& storage = frame.getPlaneStorage(plane);
+        glCopyImageSubData(source.getTextureId(plane), GL_TEXTURE_2D, 0, 0, 0, 0,
+                           frame.getTextureId(plane), GL_TEXTURE_2D, 0, 0, 0, 0,
+                           storage.width, storage.height, 1);
+    }
+    return glGetError() == GL_NO_ERROR ? nullptr : "texture copy failed";
+}
+
+const char* OpenGLRenderer::uploadLoopFrame(const FrameBuffer& source, bool compress, GPUTextureFrameBuffer& frame) {
+    const FrameInfo& info = source.info();
+    if (isShaderYUV(info.format)) {
+        if (!supportsPlanarYUV()) {
+            return "planar YUV frames without YUV shaders";
+        }
+        if (!frame.allocateMultiPlane(info, planarTextureType(info.format))) {
+            return "refused by the memory budget";
+        }
+        const uint8_t* data[4] = {nullptr, nullptr, nullptr, nullptr};
+        int strides[4] = {0, 0, 0, 0};
+        return source.getPlanes(data, strides) &&
+               frame.uploadMultiPlaneData(data[0], data[1], data[2], strides[0], strides[1], strides[2])
+                   ? nullptr : "plane upload failed";
+    }
+    if (info.format != PixelFormat::BGRA32) {
+        return "pixel format";
+    }
+    if (compress && info.width % 4 == 0 && info.height % 4 == 0 && bc1Encoder()) {
+        if (!frame.allocate(info, GL_COMPRESSED_RGB_S3TC_DXT1_EXT)) {
+            return "refused by the memory budget";
+        }
+        return bc1Encoder_->encodePixels(source.data(), info.width, info.height, frame.getTextureId())
+                   ? nullptr : "BC1 compression failed";
+    }
+    if (!frame.allocate(info, GL_RGBA)) {
+        return "refused by the memory budget";
+    }
+    while (glGetError() != GL_NO_ERROR) {}
+    glBindTexture(GL_TEXTURE_2D, frame.getTextureId());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, info.width, info.height, GL_BGRA, GL_UNSIGNED_BYTE, source.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return glGetError() == GL_NO_ERROR ? nullptr : "upload failed";
+}
+
+BC1Encoder* OpenGLRenderer::bc1Encoder() {
+    if (!bc1Encoder_ && !bc1Failed_) {
+        // Without it compressed loops are kept uncompressed
+        bc1Encoder_ = std::make_unique<BC1Encoder>();
+        if (!BC1Encoder::isSupported() || !bc1Encoder_->init()) {
+            LOG_WARNING << "OpenGLRenderer: No BC1 encoder, loop caches stay uncompressed";
+            bc1Encoder_.reset();
+            bc1Failed_ = true;
+        }
+    }
+    return bc1Encoder_.get();
+}
+
+void OpenGLRenderer::compositeLayers(const std::vector<const VideoLayer*>& layers) {
+    static const std::vector<LayerGroup> noGroups;
+    compositeLayers(layers, noGroups);
+}
+
+void OpenGLRenderer::compositeLayers(const std::vector<const VideoLayer*>& layers,
+                                     const std::vector<LayerGroup>& groups) {
+    FRAME_TRACE_SCOPE("composite");
+    // One timer frame per composite, unless the caller's frame has more passes
+    bool ownGpuFrame = !gpuTimer_.isFrameOpen();
+    if (ownGpuFrame) {
+        gpuTimer_.beginFrame();
+    }
+    GpuTimer::Scope gpuComposite(gpuTimer_, "composite");
+    
+    // State from before this pass is unknown; layers draw blended
+    glState_.invalidate();
+    glState_.setBlend(true);
+    
+    // Hidden standby layers get their start frame onto the GPU ahead of GO
+    prepareArmedLayers(layers);
+    fillLoopCaches(layers);
+    
+    // Group members go into their group images first; the rest is drawn here
+    groupDraws_.clear();
+    groupRedrawCount_ = 0;
+    bool grouped = !groups.empty() && shaderCache_;
+    if (grouped) {
+        renderGroups(layers, groups);
+    }
+    const std::vector<const VideoLayer*>& topLevel = grouped ? ungroupedLayers_ : layers;
+    
+    // Layers under the top-most opaque full-viewport layer cannot be seen:
+    // no upload, no texture binding, no draw
+    size_t first = firstUnoccludedLayer(topLevel);
+    for (size_t i = 0; i < topLevel.size(); ++i) {
+        if (topLevel[i]) {
+            topLevel[i]->setOccluded(i < first);
+        }
+    }
+    culledLayerCount_ = first;
+    
+    // Layers no output shows are culled the same way
+    std::vector<const VideoLayer*>& drawn = drawnLayers_;
+    drawn.clear();
+    planeDrawn_.clear();
+    drawnBefore_.assign(topLevel.size() + 1, 0);
+    for (size_t i = 0; i < topLevel.size(); ++i) {
+        drawnBefore_[i] = drawn.size();
+        if (i < first) {
+            continue;
+        }
+        // On an overlay plane, above this composite
+        if (topLevel[i] && std::find(planeLayers_.begin(), planeLayers_.end(),
+                                     topLevel[i]->getLayerId()) != planeLayers_.end()) {
+            planeDrawn_.push_back(topLevel[i]);
+            continue;
+        }
+        if (missesVisibleRegions(topLevel[i])) {
+            topLevel[i]->setOccluded(true);
+            ++culledLayerCount_;
+            continue;
+        }
+        drawn.push_back(topLevel[i]);
+    }
+    drawnBefore_[topLevel.size()] = drawn.size();
+    updateDisplaySizes(drawn);
+    updateDisplaySizes(planeDrawn_);
+    
+    // Group images go where the group's z-order puts them among the layers
+    if (grouped) {
+        for (const LayerGroup& group : groups) {
+            auto it = groupCaches_.find(group.groupId);
+            if (it == groupCaches_.end() || !it->second.drawable) {
+                continue;
+            }
+            size_t position = 0;
+            while (position < topLevel.size() && topLevel[position] &&
+                   topLevel[position]->properties().zOrder >= group.properties.zOrder) {
+                ++position;
+            }
+            if (position >= first) {
+                groupDraws_.emplace_back(drawnBefore_[position], &group);
+            }
+        }
+        std::stable_sort(groupDraws_.begin(), groupDraws_.end(),
+            [](const std::pair<size_t, const LayerGroup*>& a, const std::pair<size_t, const LayerGroup*>& b) {
+                if (a.first != b.first) {
+                    return a.first < b.first;
+                }
+                return a.second->properties.zOrder > b.second->properties.zOrder;
+            });
+    }
+    
+    // Master transforms: fold into the layer matrices when that draws the
+    // same image, otherwise composite into the FBO and transform that
+    // (group images are not checked for folding: they take the FBO)
+    bool useMasterFBO = false;
+    if (masterProperties_.isActive()) {
+        masterFolded_ = groupDraws_.empty() && canFoldMaster(drawn);
+        useMasterFBO = !masterFolded_;
+    }
+    if (masterFolded_) {
+        buildMasterMatrix();
+        masterOpacity_ = masterProperties_.opacity;
+    }
+    
+    // Target the composite ends up in (VirtualCanvas binds its own FBO)
+    GLint targetFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &targetFBO);
+    
+    if (useMasterFBO) {
+        ++masterFBOPassCount_;
+        // Initialize or resize FBO if needed
+        if (!masterFBOInitialized_ || masterFBOWidth_ != viewportWidth_ || masterFBOHeight_ != viewportHeight_) {
+            if (!initMasterFBO(viewportWidth_, viewportHeight_)) {
+                LOG_ERROR << "Failed to initialize master FBO, falling back to direct rendering";
+                useMasterFBO = false;
+            }
+        }
+    }
+    
+    if (useMasterFBO && masterFBOInitialized_) {
+        // Render layers to FBO
+        glBindFramebuffer(GL_FRAMEBUFFER, masterFBO_);
+        glViewport(0, 0, masterFBOWidth_, masterFBOHeight_);
+    }
+    
+    // Clear to opaque black (alpha = 1.0); a target restricted to the
+    // visible regions was cleared to them already
+    if ((useMasterFBO && masterFBOInitialized_) || visibleRegions_.coversAll()) {
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    
+    // The master FBO pass flips its final quad instead
+    flipLayers_ = flipY_ && !(useMasterFBO && masterFBOInitialized_);
+    
+    if (masterFolded_ && masterProperties_.rotation == 0.0f) {
+        // The FBO clipped layers to the canvas; clip to the transformed canvas
+        float x0 = masterProperties_.x - std::fabs(masterProperties_.scaleX);
+        float x1 = masterProperties_.x + std::fabs(masterProperties_.scaleX);
+        float y0 = masterProperties_.y - std::fabs(masterProperties_.scaleY);
+        float y1 = masterProperties_.y + std::fabs(masterProperties_.scaleY);
+        if (flipLayers_) {
+            std::swap(y0, y1);
+            y0 = -y0;
+            y1 = -y1;
+        }
+        auto toPixels = [](float ndc, int size) {
+            float px = (std::min(std::max(ndc, -1.0f), 1.0f) + 1.0f) * 0.5f * size;
+            return static_cast<GLint>(std::lround(px));
+        };
+        GLint sx0 = toPixels(x0, viewportWidth_);
+        GLint sy0 = toPixels(y0, viewportHeight_);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(viewportX_ + sx0, viewportY_ + sy0,
+                  toPixels(x1, viewportWidth_) - sx0, toPixels(y1, viewportHeight_) - sy0);
+    }
+
+    // Drop decode rings and tile atlases of layers that no longer exist
+    releaseOrphanedFrameRings();
+    releaseOrphanedTiledTextures();
+    if (effectTargets_) {
+        effectTargets_->endFrame();
+    }
+    
+    bool asyncUpload = isUploadThreadEnabled() && shaderCache_;
+    if (asyncUpload) {
+        submitUploads(drawn);
+    }
+
+    // Render layers in z-order (already sorted by LayerManager); layers that
+    // do not overlap are grouped by state (group images have no bounds here)
+    if (layerBatchingEnabled_ && groupDraws_.empty()) {
+        groupDrawnByState(drawn);
+    }
+    batchOpen_ = layerBatchingEnabled_ && shaderCache_;
+    size_t nextGroup = 0;
+    auto drawGroupsBefore = [this, &nextGroup](size_t index) {
+        while (nextGroup < groupDraws_.size() && groupDraws_[nextGroup].first <= index) {
+            const LayerGroup& group = *groupDraws_[nextGroup].second;
+            drawGroupImage(groupCaches_[group.groupId], group);
+            ++nextGroup;
+        }
+    };
+    for (size_t i = 0; i < drawn.size(); ++i) {
+        drawGroupsBefore(i);
+        const VideoLayer* layer = drawn[i];
+        if (layer && layer->isReady()) {
+            // A batched layer only queues its draw (timed as "batch"); a
+            // layer that ends a batch includes that batch's draw
+            GpuTimer::Scope gpuLayer(gpuTimer_, "layer", layer->getLayerId());
+            renderLayer(layer);
+            // If no frame was rendered, clear will show black screen (expected)
+            // This is normal when waiting for MTC or when no frames are available yet
+        }
+    }
+    drawGroupsBefore(drawn.size());
+    flushLayerBatch();
+    batchOpen_ = false;
+    
+    if (masterFolded_) {
+        glDisable(GL_SCISSOR_TEST);
+        masterFolded_ = false;
+        masterOpacity_ = 1.0f;
+    }
+    flipLayers_ = false;
+    
+    if (asyncUpload) {
+        // Frame buffers may be overwritten by the next layer update
+        uploader_->drain();
+    }
+    
+    if (useMasterFBO && masterFBOInitialized_) {
+        // Back to the original target, render with master transforms
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(targetFBO));
+        glViewport(viewportX_, viewportY_, viewportWidth_, viewportHeight_);
         
-        // Fixed-function fallback (only if shaders unavailable - legacy systems)
-        // Save matrix state before applying transforms
-        glPushMatrix();
+        // Clear screen
+        if (visibleRegions_.coversAll()) {
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
         
-        // Apply layer transform using the thread-safe props copy
-        applyLayerTransformFromProps(props, quad_x, quad_y);
-
-        // Apply blend mode using the thread-safe props copy
-        applyBlendModeFromProps(props);
+        // Render FBO texture with master transforms
+        GpuTimer::Scope gpuMaster(gpuTimer_, "master");
+        renderMasterQuadWithTransforms();
+    }
+    endPass();
+    
+    if (ownGpuFrame) {
+        gpuTimer_.endFrame();
+    }
+}
 
-        // Set opacity
-        glColor4f(1.0f, 1.0f, 1.0f, props.opacity);
+void OpenGLRenderer::renderGroups(const std::vector<const VideoLayer*>& layers,
+                                  const std::vector<LayerGroup>& groups) {
+    auto findGroup = [&groups](int groupId) -> const LayerGroup* {
+        for (const LayerGroup& group : groups) {
+            if (group.groupId == groupId) {
+                return &group;
+            }
+        }
+        return nullptr;
+    };
+    
+    // Layers naming a group that does not exist are drawn on their own
+    ungroupedLayers_.clear();
+    for (const VideoLayer* layer : layers) {
+        if (layer && (layer->properties().groupId == 0 || !findGroup(layer->properties().groupId))) {
+            ungroupedLayers_.push_back(layer);
+        }
+    }
+    
+    for (const LayerGroup& group : groups) {
+        GroupCache& cache = groupCaches_[group.groupId];
+        cache.seen = true;
+        cache.drawable = false;
         
-        // Render centered quad (matches original xjadeo)
-        float x = -quad_x;
-        float y = -quad_y;
-        float w = 2.0f * quad_x;
-        float h = 2.0f * quad_y;
-
-                // Calculate texture coordinates for cropping/panorama using thread-safe props copy
-                float texX = 0.0f, texY = 0.0f, texWidth = 1.0f, texHeight = 1.0f;
-                calculateCropCoordinatesFromProps(props, frameInfo, texX, texY, texWidth, texHeight);
-
-                // Regular texture uses GL_TEXTURE_RECTANGLE_ARB (already bound above)
-                // Use pixel coordinates for GL_TEXTURE_RECTANGLE_ARB
-                glBegin(GL_QUADS);
-                glTexCoord2f(0.0f, (GLfloat)layerTextureHeight); glVertex2f(x, y);
-                glTexCoord2f((GLfloat)layerTextureWidth, (GLfloat)layerTextureHeight); glVertex2f(x + w, y);
-                glTexCoord2f((GLfloat)layerTextureWidth, 0.0f); glVertex2f(x + w, y + h);
-                glTexCoord2f(0.0f, 0.0f); glVertex2f(x, y + h);
-                glEnd();
-                
-                // Unbind texture (texture is cached, don't delete)
-                glBindTexture(GL_TEXTURE_RECTANGLE_ARB, 0);
-                glDisable(GL_TEXTURE_RECTANGLE_ARB);
+        groupMembers_.clear();
+        for (const VideoLayer* layer : layers) {
+            if (layer && layer->properties().groupId == group.groupId) {
+                groupMembers_.push_back(layer);
+                // Members of a hidden group are as good as hidden; the group
+                // transform leaves their on-screen size unknown
+                layer->setOccluded(!group.properties.visible);
+                layer->setDisplaySize(0, 0);
+            }
+        }
+        if (!group.properties.visible || groupMembers_.empty()) {
+            continue;
+        }
+        if (updateGroupMembers(cache, groupMembers_)) {
+            GpuTimer::Scope gpuGroup(gpuTimer_, "group", group.groupId);
+            if (!redrawGroupImage(cache, groupMembers_)) {
+                continue;
+            }
+            ++groupRedrawCount_;
+        }
+        cache.drawable = true;
+    }
+    
+    // Images of groups that were removed
+    for (auto it = groupCaches_.begin(); it != groupCaches_.end();) {
+        if (!it->second.seen) {
+            releaseGroupCache(it->second);
+            it = groupCaches_.erase(it);
+        } else {
+            it->second.seen = false;
+            ++it;
+        }
+    }
+}
 
-                glPopMatrix();
+bool OpenGLRenderer::updateGroupMembers(GroupCache& cache, const std::vector<const VideoLayer*>& members) {
+    bool changed = !cache.valid || cache.image.info().width != viewportWidth_ ||
+                   cache.image.info().height != viewportHeight_ || cache.members.size() != members.size();
+    cache.members.resize(members.size());
+    for (size_t i = 0; i < members.size(); ++i) {
+        const VideoLayer* layer = members[i];
+        GroupMember& member = cache.members[i];
+        bool ready = layer->isReady();
+        uint64_t generation = layer->getFrameGeneration();
+        const LayerProperties& props = layer->properties();
+        if (member.layer != layer || member.layerId != layer->getLayerId() || member.ready != ready ||
+            member.generation != generation || !member.properties.rendersSameAs(props)) {
+            changed = true;
+            member.layer = layer;
+            member.layerId = layer->getLayerId();
+            member.ready = ready;
+            member.generation = generation;
+            member.properties = props;
+        }
+    }
+    return changed;
+}
 
-                return true;
-    } else {
-        // No valid frame available
+bool OpenGLRenderer::redrawGroupImage(GroupCache& cache, const std::vector<const VideoLayer*>& members) {
+    cache.valid = false;
+    if (viewportWidth_ <= 0 || viewportHeight_ <= 0) {
+        return false;
+    }
+    
+    if (!cache.image.isValid() || cache.image.info().width != viewportWidth_ ||
+        cache.image.info().height != viewportHeight_) {
+        if (cache.fbo != 0) {
+            glDeleteFramebuffers(1, &cache.fbo);
+            cache.fbo = 0;
+        }
+        FrameInfo info;
+        info.width = viewportWidth_;
+        info.height = viewportHeight_;
+        info.aspect = static_cast<float>(viewportWidth_) / static_cast<float>(viewportHeight_);
+        info.format = PixelFormat::RGBA32;
+        cache.image.setBudgetAccount(
+            MemoryBudget::Account(MemoryBudget::Subsystem::GROUP_IMAGES, MemoryBudget::NO_LAYER));
+        bool allocated = cache.image.allocate(info, GL_RGBA);
+        glState_.invalidateTextures();
+        if (!allocated) {
+            return false;
+        }
+        glGenFramebuffers(1, &cache.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, cache.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cache.image.getTextureId(), 0);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            LOG_ERROR << "Layer group FBO is not complete: 0x" << std::hex << status;
+            releaseGroupCache(cache);
+            return false;
+        }
+    }
+    
+    GLint targetFBO = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &targetFBO);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, cache.fbo);
+    glViewport(0, 0, viewportWidth_, viewportHeight_);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    
+    // Stored top row first, like a decoded frame, so the image draws with
+    // the layer path. Members blend over transparent black: translucent
+    // edges come out slightly darker than drawn straight to the target.
+    flipLayers_ = true;
+    batchOpen_ = layerBatchingEnabled_;
+    for (const VideoLayer* layer : members) {
+        if (layer->isReady()) {
+            renderLayer(layer);
+        }
+    }
+    flushLayerBatch();
+    batchOpen_ = false;
+    flipLayers_ = false;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(targetFBO));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    cache.valid = true;
+    return true;
+}
+
+void OpenGLRenderer::drawGroupImage(GroupCache& cache, const LayerGroup& group) {
+    LayerProperties props = group.properties;
+    props.width = cache.image.info().width;
+    props.height = cache.image.info().height;
+    renderLayerFromGPU(cache.image, props, cache.image.info());
+}
+
+void OpenGLRenderer::releaseGroupCache(GroupCache& cache) {
+    if (cache.fbo != 0) {
+        glDeleteFramebuffers(1, &cache.fbo);
+        cache.fbo = 0;
+    }
+    cache.image.release();
+    cache.members.clear();
+    cache.valid = false;
+    cache.drawable = false;
+}
+
+bool OpenGLRenderer::layerCorners(const VideoLayer* layer, float corner[4][2]) {
+    if (!layer) {
+        return false;
+    }
+    const LayerProperties& props = layer->properties();
+    
+    // Same quad as the shader paths: letterboxed, then scaled and rotated
+    float quad_x = 1.0f;
+    float quad_y = 1.0f;
+    const FrameInfo& frameInfo = layer->getFrameInfo();
+    if (letterbox_ && viewportWidth_ > 0 && viewportHeight_ > 0) {
+        float asp_src = layerAspect(props, frameInfo);
+        float asp_dst = (float)viewportWidth_ / (float)viewportHeight_;
+        if (asp_dst > asp_src) {
+            quad_x = asp_src / asp_dst;
+        } else {
+            quad_y = asp_dst / asp_src;
+        }
+    }
+    float mvp[16];
+    computeMVPMatrix(mvp, 0.0f, 0.0f, quad_x, quad_y, props);
+    
+    // Quad corners in order around the quad (corner deform moves them before the MVP)
+    const float unit[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    for (int i = 0; i < 4; ++i) {
+        float u = unit[i][0];
+        float v = unit[i][1];
+        if (props.cornerDeform.enabled) {
+            u += props.cornerDeform.corners[i * 2];
+            v += props.cornerDeform.corners[i * 2 + 1];
+        }
+        corner[i][0] = mvp[0] * u + mvp[4] * v + mvp[12];
+        corner[i][1] = mvp[1] * u + mvp[5] * v + mvp[13];
+    }
+    return true;
+}
+
+bool OpenGLRenderer::getLayerBounds(const VideoLayer* layer, float& x0, float& y0, float& x1, float& y1) {
+    float corner[4][2];
+    if (viewportWidth_ <= 0 || viewportHeight_ <= 0 || !layerCorners(layer, corner)) {
         return false;
     }
+    float left = corner[0][0], right = corner[0][0];
+    float bottom = corner[0][1], top = corner[0][1];
+    for (int i = 1; i < 4; ++i) {
+        left = std::min(left, corner[i][0]);
+        right = std::max(right, corner[i][0]);
+        bottom = std::min(bottom, corner[i][1]);
+        top = std::max(top, corner[i][1]);
+    }
+    x0 = (left + 1.0f) * 0.5f * static_cast<float>(viewportWidth_);
+    x1 = (right + 1.0f) * 0.5f * static_cast<float>(viewportWidth_);
+    y0 = (1.0f - top) * 0.5f * static_cast<float>(viewportHeight_);
+    y1 = (1.0f - bottom) * 0.5f * static_cast<float>(viewportHeight_);
+    return true;
+}
+
+void OpenGLRenderer::groupDrawnByState(std::vector<const VideoLayer*>& layers) {
+    if (layers.size() < 3) {
+        return;  // Nothing to gain: two layers either match or do not
+    }
+    drawItems_.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        DrawOrder::Item& item = drawItems_[i];
+        const VideoLayer* layer = layers[i];
+        float corner[4][2];
+        if (!layer || !layerCorners(layer, corner)) {
+            // Unknown bounds: overlaps everything, stays where it is
+            item.stateKey = 0xffffffffu;
+            item.x0 = item.y0 = -1e30f;
+            item.x1 = item.y1 = 1e30f;
+            continue;
+        }
+        // Frame format picks the program kind; blend mode, effects, colour
+        // correction and corner deform the permutation and blend state
+        const LayerProperties& props = layer->properties();
+        item.stateKey = (static_cast<uint32_t>(layer->getFrameInfo().format) << 8) |
+                        (props.effects.isActive() ? 0x80u : 0u) |
+                        (static_cast<uint32_t>(props.blendMode) << 2) |
+                        (props.colorAdjust.isActive() ? 2u : 0u) | (props.cornerDeform.enabled ? 1u : 0u);
+        item.x0 = item.x1 = corner[0][0];
+        item.y0 = item.y1 = corner[0][1];
+        for (int c = 1; c < 4; ++c) {
+            item.x0 = std::min(item.x0, corner[c][0]);
+            item.x1 = std::max(item.x1, corner[c][0]);
+            item.y0 = std::min(item.y0, corner[c][1]);
+            item.y1 = std::max(item.y1, corner[c][1]);
+        }
+    }
+    DrawOrder::groupByState(drawItems_, drawOrder_);
+    orderedLayers_.resize(layers.size());
+    for (size_t i = 0; i < drawOrder_.size(); ++i) {
+        orderedLayers_[i] = layers[drawOrder_[i]];
+    }
+    layers.swap(orderedLayers_);
+}
+
+bool OpenGLRenderer::canFoldMaster(const std::vector<const VideoLayer*>& layers) {
+    const MasterProperties& master = masterProperties_;
+    // Color adjust and deform work on the composite image
+    if (master.colorAdjust.isActive() || master.cornerDeform.enabled || !shaderCache_) {
+        return false;
+    }
+    
+    size_t visibleCount = 0;
+    bool insideCanvas = true;
+    for (const VideoLayer* layer : layers) {
+        if (!layer || !layer->isReady() || !layer->properties().visible) {
+            continue;
+        }
+        ++visibleCount;
+        float corner[4][2];
+        layerCorners(layer, corner);
+        for (int i = 0; i < 4; ++i) {
+            insideCanvas &= std::fabs(corner[i][0]) <= 1.0f && std::fabs(corner[i][1]) <= 1.0f;
+        }
+        // Fading the composite over black equals fading its only layer, but not
+        // fading each of several overlapping layers
+        if (master.opacity != 1.0f &&
+            (visibleCount > 1 || layer->properties().blendMode != LayerProperties::NORMAL)) {
+            return false;
+        }
+    }
+    
+    // Parts of layers outside the canvas must stay cut off. Without rotation
+    // the scissor does that; with rotation only if nothing sticks out.
+    return master.rotation == 0.0f || insideCanvas;
+}
+
+void OpenGLRenderer::buildMasterMatrix() {
+    // Same order as the FBO pass: translate * scale * rotate (column-major)
+    const MasterProperties& master = masterProperties_;
+    float rad = master.rotation * M_PI / 180.0f;
+    float cosR = std::cos(rad);
+    float sinR = std::sin(rad);
+    for (int i = 0; i < 16; i++) {
+        masterMatrix_[i] = 0.0f;
+    }
+    masterMatrix_[0] = master.scaleX * cosR;
+    masterMatrix_[1] = master.scaleY * sinR;
+    masterMatrix_[4] = -master.scaleX * sinR;
+    masterMatrix_[5] = master.scaleY * cosR;
+    masterMatrix_[10] = 1.0f;
+    masterMatrix_[12] = master.x;
+    masterMatrix_[13] = master.y;
+    masterMatrix_[15] = 1.0f;
+}
+
+bool OpenGLRenderer::canBatch(const LayerProperties& props) const {
+    // Anything beyond transform and opacity needs its own program or blend state
+    return batchOpen_ && !props.colorAdjust.isActive() && !props.cornerDeform.enabled &&
+           props.blendMode == LayerProperties::NORMAL && layerField_.parity < 0 &&
+           props.packedAlpha == PackedAlpha::Layout::NONE && !props.effects.isActive();
+}
+
+void OpenGLRenderer::queueBatchedLayer(GLuint textureId, float quad_x, float quad_y,
+                                       const LayerProperties& props) {
+    BatchedLayer entry;
+    entry.textureId = textureId;
+    computeMVPMatrix(entry.mvp, 0.0f, 0.0f, quad_x, quad_y, props);
+    entry.opacity = props.opacity * masterOpacity_;
+    batch_.push_back(entry);
+    
+    if (batch_.size() >= static_cast<size_t>(VideoShaders::MAX_BATCH_LAYERS)) {
+        flushLayerBatch();
+    }
+}
+
+void OpenGLRenderer::flushLayerBatch() {
+    if (batch_.empty()) {
+        return;
+    }
+    GpuTimer::Scope gpuBatch(gpuTimer_, "batch");
+    
+    ShaderProgram* shader = shaderCache_ ? shaderCache_->get(ShaderKind::RGBA_BATCH, 0) : nullptr;
+    if (!shader) {
+        // No batch program on this driver: same result, one draw per layer
+        ShaderProgram* plain = shaderCache_ ? shaderCache_->get(ShaderKind::RGBA, 0) : nullptr;
+        if (plain) {
+            glState_.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glState_.useProgram(plain->getProgramId());
+            plain->setUniform("uTexture", 0);
+            glState_.bindVertexArray(quadVAO_);
+            for (const BatchedLayer& entry : batch_) {
+                glState_.bindTexture(0, entry.textureId);
+                plain->setUniform("uOpacity", entry.opacity);
+                plain->setUniformMatrix4fv("uMVP", entry.mvp);
+                glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+            }
+        }
+        batch_.clear();
+        return;
+    }
+    
+    // Per-instance data, std140: mat4 mvp + vec4(opacity, slot, 0, 0)
+    const size_t count = batch_.size();
+    float instances[VideoShaders::MAX_BATCH_LAYERS * VideoShaders::BATCH_INSTANCE_FLOATS];
+    for (size_t i = 0; i < count; ++i) {
+        float* dst = instances + i * VideoShaders::BATCH_INSTANCE_FLOATS;
+        memcpy(dst, batch_[i].mvp, sizeof(batch_[i].mvp));
+        dst[16] = batch_[i].opacity;
+        dst[17] = static_cast<float>(i);
+        dst[18] = 0.0f;
+        dst[19] = 0.0f;
+    }
+    if (batchUBO_ == 0) {
+        glGenBuffers(1, &batchUBO_);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, batchUBO_);
+    // Orphan each time: the previous batch may still be in flight
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(instances), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, count * VideoShaders::BATCH_INSTANCE_FLOATS * sizeof(float), instances);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, VideoShaders::BATCH_UBO_BINDING, batchUBO_);
+    
+    glState_.useProgram(shader->getProgramId());
+    if (batchProgramId_ != shader->getProgramId()) {
+        // Program state, set once per program
+        GLuint block = glGetUniformBlockIndex(shader->getProgramId(), "LayerInstances");
+        if (block != GL_INVALID_INDEX) {
+            glUniformBlockBinding(shader->getProgramId(), block, VideoShaders::BATCH_UBO_BINDING);
+        }
+        for (int i = 0; i < VideoShaders::MAX_BATCH_LAYERS; ++i) {
+            shader->setUniform("uTextures[" + std::to_string(i) + "]", i);
+        }
+        batchProgramId_ = shader->getProgramId();
+    }
+    
+    for (size_t i = count; i > 0; --i) {
+        glState_.bindTexture(static_cast<GLuint>(i - 1), batch_[i - 1].textureId);
+    }
+    
+    glState_.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // NORMAL (see canBatch)
+    glState_.bindVertexArray(quadVAO_);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, static_cast<GLsizei>(count));
+    batch_.clear();
+}
+
+bool OpenGLRenderer::coversViewportOpaque(const VideoLayer* layer) {
+    if (!layer || !layer->isReady()) {
+        return false;
+    }
+    const LayerProperties& props = layer->properties();
+    if (!props.visible || props.opacity < 1.0f || props.blendMode != LayerProperties::NORMAL ||
+        props.cornerDeform.enabled || props.packedAlpha != PackedAlpha::Layout::NONE ||
+        props.effects.isActive()) {
+        return false;
+    }
+    const InputSource* input = layer->getInputSource();
+    if (!input || input->hasAlpha()) {
+        return false;
+    }
+    // Only a layer that actually draws a frame hides anything
+    const FrameBuffer* cpuBuffer = nullptr;
+    const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+    bool isOnGPU = layer->getPreparedFrame(cpuBuffer, gpuBuffer);
+    if (isOnGPU ? !(gpuBuffer && gpuBuffer->isValid()) : !(cpuBuffer && cpuBuffer->isValid())) {
+        return false;
+    }
+    
+    float corner[4][2];
+    layerCorners(layer, corner);
+    
+    // Every viewport corner must lie inside the (convex) quad
+    const float unit[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    const float epsilon = 1e-4f;
+    for (int v = 0; v < 4; ++v) {
+        bool anyPositive = false;
+        bool anyNegative = false;
+        for (int i = 0; i < 4; ++i) {
+            const float* a = corner[i];
+            const float* b = corner[(i + 1) % 4];
+            float cross = (b[0] - a[0]) * (unit[v][1] - a[1]) - (b[1] - a[1]) * (unit[v][0] - a[0]);
+            anyPositive |= cross > epsilon;
+            anyNegative |= cross < -epsilon;
+        }
+        if (anyPositive && anyNegative) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OpenGLRenderer::updateDisplaySizes(const std::vector<const VideoLayer*>& layers) {
+    for (const VideoLayer* layer : layers) {
+        if (!layer || !layer->isReady()) {
+            continue;
+        }
+        // A master transform scales the composite again: size unknown
+        float corner[4][2];
+        if (masterProperties_.isActive() || viewportWidth_ <= 0 || viewportHeight_ <= 0 ||
+            !layerCorners(layer, corner)) {
+            layer->setDisplaySize(0, 0);
+            continue;
+        }
+        // Longest of opposite edges, in output pixels (rotation and warping included)
+        auto edge = [this, &corner](int a, int b) {
+            float dx = (corner[b][0] - corner[a][0]) * 0.5f * static_cast<float>(viewportWidth_);
+            float dy = (corner[b][1] - corner[a][1]) * 0.5f * static_cast<float>(viewportHeight_);
+            return std::sqrt(dx * dx + dy * dy);
+        };
+        float width = std::max(edge(0, 1), edge(3, 2));
+        float height = std::max(edge(0, 3), edge(1, 2));
+        layer->setDisplaySize(static_cast<int>(std::ceil(width)), static_cast<int>(std::ceil(height)));
+    }
+}
+
+bool OpenGLRenderer::missesVisibleRegions(const VideoLayer* layer) {
+    // Master transforms move layers after layerCorners; the fixed-function
+    // path places quads differently
+    if (visibleRegions_.coversAll() || masterProperties_.isActive() ||
+        !shaderCache_ || !layer) {
+        return false;
+    }
+    float corner[4][2];
+    if (!layerCorners(layer, corner)) {
+        return false;
+    }
+    float x0 = corner[0][0], x1 = corner[0][0];
+    float y0 = corner[0][1], y1 = corner[0][1];
+    for (int i = 1; i < 4; ++i) {
+        x0 = std::min(x0, corner[i][0]);
+        x1 = std::max(x1, corner[i][0]);
+        y0 = std::min(y0, corner[i][1]);
+        y1 = std::max(y1, corner[i][1]);
+    }
+    // Target pixels: the viewport may start off the target (cluster canvas window)
+    auto toPixels = [](float ndc, int size, int origin) { return origin + (ndc + 1.0f) * 0.5f * size; };
+    return !visibleRegions_.intersects(toPixels(x0, viewportWidth_, viewportX_),
+                                       toPixels(y0, viewportHeight_, viewportY_),
+                                       toPixels(x1, viewportWidth_, viewportX_),
+                                       toPixels(y1, viewportHeight_, viewportY_));
+}
+
+size_t OpenGLRenderer::firstUnoccludedLayer(const std::vector<const VideoLayer*>& layers) {
+    // The fixed-function path places quads differently; cull only with shaders
+    if (!shaderCache_) {
+        return 0;
+    }
+    for (size_t i = layers.size(); i > 0; --i) {
+        if (coversViewportOpaque(layers[i - 1])) {
+            return i - 1;
+        }
+    }
+    return 0;
+}
+
+void OpenGLRenderer::cleanupDeferredTextures() {
+    // Called AFTER swapBuffers(), when the frame's draws are queued
+    // Pooled textures released this frame: retire fences, trim to the limit
+    TexturePool::instance().collect();
+    // Charges made without a reservation this frame: evict for them
+    MemoryBudget::instance().enforce();
+}
+
+bool OpenGLRenderer::renderPlanarFrame(int layerId, const FrameBuffer& frame, const LayerProperties& props,
+                                       const FrameInfo& frameInfo, uint64_t generation) {
+    // Armed cue: the planes were uploaded while the layer was hidden
+    auto armed = planarArmedGenerations_.find(layerId);
+    bool armedUpload = armed != planarArmedGenerations_.end() && armed->second == generation;
+    if (armed != planarArmedGenerations_.end()) {
+        planarArmedGenerations_.erase(armed);
+    }
+    if (!armedUpload) {
+        bool uploaded = uploadPlanarFrame(layerId, frame);
+        // Plane uploads bind their textures directly
+        glState_.invalidateTextures();
+        if (!uploaded) {
+            return false;
+        }
+    }
+    return renderLayerFromGPU(planarTextures_[layerId], props, frameInfo);
 }
 
-void OpenGLRenderer::compositeLayers(const std::vector<const VideoLayer*>& layers) {
-    // Check if master transforms are active
-    bool useMasterFBO = masterProperties_.isActive();
-    
-    if (useMasterFBO) {
-        // Initialize or resize FBO if needed
-        if (!masterFBOInitialized_ || masterFBOWidth_ != viewportWidth_ || masterFBOHeight_ != viewportHeight_) {
-            if (!initMasterFBO(viewportWidth_, viewportHeight_)) {
-                LOG_ERROR << "Failed to initialize master FBO, falling back to direct rendering";
-                useMasterFBO = false;
+bool OpenGLRenderer::renderLayerPreview(const VideoLayer* layer) {
+    if (!layer || !layer->isReady() || !shaderCache_) {
+        return false;
+    }
+    const FrameBuffer* cpuBuffer = nullptr;
+    const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+    bool isOnGPU = layer->getPreparedFrame(cpuBuffer, gpuBuffer);
+    const FrameInfo& frameInfo = layer->getFrameInfo();
+    int layerId = layer->getLayerId();
+    
+    LayerProperties props;
+    props.width = frameInfo.width > 0 ? frameInfo.width : 16;
+    props.height = frameInfo.height > 0 ? frameInfo.height : 9;
+    
+    // Drawn outside the composite: no master fold, no batch
+    bool folded = masterFolded_;
+    float opacity = masterOpacity_;
+    bool flip = flipLayers_;
+    bool letterbox = letterbox_;
+    masterFolded_ = false;
+    masterOpacity_ = 1.0f;
+    flipLayers_ = flipY_;
+    letterbox_ = true;
+    
+    bool drawn = false;
+    if (isOnGPU && gpuBuffer && gpuBuffer->isValid()) {
+        drawn = renderLayerFromGPU(*gpuBuffer, props, frameInfo);
+    } else if (cpuBuffer && cpuBuffer->isValid() && isShaderYUV(cpuBuffer->info().format)) {
+        auto planes = planarTextures_.find(layerId);
+        drawn = planes != planarTextures_.end() && planes->second.isValid() &&
+                renderLayerFromGPU(planes->second, props, frameInfo);
+    } else if (cpuBuffer && cpuBuffer->isValid() && (layer->hasStaticFrame() || !isUploadThreadEnabled())) {
+        // The uploader hands its textures back after the draw: only the
+        // layer's own cached texture still holds the frame
+        auto cache = layerTextureCache_.find(layerId);
+        if (cache != layerTextureCache_.end() && cache->second.textureId != 0) {
+            float asp_src = layerAspect(props, frameInfo);
+            float asp_dst = (float)viewportWidth_ / (float)viewportHeight_;
+            float quad_x = asp_dst > asp_src ? asp_src / asp_dst : 1.0f;
+            float quad_y = asp_dst > asp_src ? 1.0f : asp_dst / asp_src;
+            
+            applyBlendModeFromProps(props);
+            uint32_t features = 0;
+            ShaderProgram* shader = layerShader(ShaderKind::RGBA, props, features, quad_x, quad_y);
+            glState_.bindTexture(0, cache->second.textureId);
+            glState_.useProgram(shader->getProgramId());
+            shader->setUniform("uTexture", 0);
+            shader->setUniform("uOpacity", 1.0f);
+            if (features & VideoShaders::FEATURE_PACKED_ALPHA) {
+                setPackedAlphaUniforms(shader, props, cache->second.width, cache->second.height, 0.5f);
+            }
+            if (features & VideoShaders::FEATURE_EFFECTS) {
+                // Key and vignette only: the preview skips the filter passes
+                setEffectUniforms(shader, props.effects, EffectChain::Plan(), nullptr);
             }
+            float mvp[16];
+            computeMVPMatrix(mvp, 0.0f, 0.0f, quad_x, quad_y, props);
+            shader->setUniformMatrix4fv("uMVP", mvp);
+            glState_.bindVertexArray(quadVAO_);
+            beginAdvancedBlend(shader, features, props, mvp, nullptr);
+            glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+            endAdvancedBlend(features);
+            drawn = true;
         }
     }
     
-    if (useMasterFBO && masterFBOInitialized_) {
-        // Render layers to FBO
-        glBindFramebuffer(GL_FRAMEBUFFER, masterFBO_);
-        glViewport(0, 0, masterFBOWidth_, masterFBOHeight_);
-    }
-    
-    // Clear to opaque black (alpha = 1.0)
-    glClear(GL_COLOR_BUFFER_BIT);
+    masterFolded_ = folded;
+    masterOpacity_ = opacity;
+    flipLayers_ = flip;
+    letterbox_ = letterbox;
+    endPass();
+    return drawn;
+}
 
-    // Render layers in z-order (already sorted by LayerManager)
-    for (const VideoLayer* layer : layers) {
-        if (layer && layer->isReady()) {
-            renderLayer(layer);
-            // If no frame was rendered, clear will show black screen (expected)
-            // This is normal when waiting for MTC or when no frames are available yet
+bool OpenGLRenderer::uploadPlanarFrame(int layerId, const FrameBuffer& frame) {
+    FRAME_TRACE_SCOPE("upload");
+    if (!supportsPlanarYUV()) {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            LOG_WARNING << "OpenGLRenderer: Planar YUV frame without YUV shader support (disable gpu_yuv)";
         }
+        return false;
     }
     
-    if (useMasterFBO && masterFBOInitialized_) {
-        // Unbind FBO, render to screen with master transforms
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glViewport(0, 0, viewportWidth_, viewportHeight_);
-        
-        // Clear screen
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        // Render FBO texture with master transforms
-        renderMasterQuadWithTransforms();
+    const FrameInfo& info = frame.info();
+    TexturePlaneType planeType = planarTextureType(info.format);
+    
+    GPUTextureFrameBuffer& planes = planarTextures_[layerId];
+    if (!planes.isValid() || planes.getPlaneType() != planeType ||
+        planes.info().width != info.width || planes.info().height != info.height) {
+        planes.setBudgetAccount(MemoryBudget::Account(MemoryBudget::Subsystem::LAYER_TEXTURES, layerId));
+        if (!planes.allocateMultiPlane(info, planeType)) {
+            planarTextures_.erase(layerId);
+            return false;
+        }
     }
+    planes.setColorInfo(info.colorMatrix, info.colorRange);
+    
+    const uint8_t* data[4] = {nullptr, nullptr, nullptr, nullptr};
+    int strides[4] = {0, 0, 0, 0};
+    return frame.getPlanes(data, strides) &&
+           planes.uploadMultiPlaneData(data[0], data[1], data[2], strides[0], strides[1], strides[2]);
 }
 
-void OpenGLRenderer::updateTexture(int width, int height) {
-    textureWidth_ = width;
-    textureHeight_ = height;
-    
-    if (textureId_ != 0) {
-        glBindTexture(GL_TEXTURE_RECTANGLE_ARB, textureId_);
-        glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA, 
-                     width, height, 0,
-                     GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+TexturePlaneType OpenGLRenderer::planarTextureType(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::YUV420P10: return TexturePlaneType::YUV_420P10;
+        case PixelFormat::UYVY422: return TexturePlaneType::YUV_UYVY;
+        case PixelFormat::YUYV422: return TexturePlaneType::YUV_YUYV;
+        case PixelFormat::NV12: return TexturePlaneType::YUV_NV12;
+        default: return TexturePlaneType::YUV_420P;
     }
 }
 
-void OpenGLRenderer::cleanupDeferredTextures() {
-    // Delete textures that were deferred from previous frame
-    // This is called AFTER swapBuffers() to ensure OpenGL is done using them
-    if (!texturesToDelete_.empty()) {
-        glDeleteTextures(static_cast<GLsizei>(texturesToDelete_.size()), texturesToDelete_.data());
-        texturesToDelete_.clear();
-    }
+void OpenGLRenderer::setYuvUniforms(ShaderProgram* shader, const FrameInfo& info, bool tenBit, bool msbAligned) {
+    // Luma coefficients (Kr, Kb) per ITU-R BT.601 / BT.709 / BT.2020
+    float kr = 0.2126f, kb = 0.0722f;
+    if (info.colorMatrix == ColorMatrix::BT601) {
+        kr = 0.299f;
+        kb = 0.114f;
+    } else if (info.colorMatrix == ColorMatrix::BT2020) {
+        kr = 0.2627f;
+        kb = 0.0593f;
+    }
+    float kg = 1.0f - kr - kb;
+    
+    // Normalised code values: 8-bit in R8, 10-bit rescaled from R16 (see uYuvScale)
+    int shift = tenBit ? 2 : 0;
+    float maxCode = tenBit ? 1023.0f : 255.0f;
+    float chromaMid = static_cast<float>(128 << shift) / maxCode;
+    float black = 0.0f;
+    float lumaScale = 1.0f;
+    float chromaScale = 1.0f;
+    if (info.colorRange == ColorRange::LIMITED) {
+        black = static_cast<float>(16 << shift) / maxCode;
+        lumaScale = maxCode / static_cast<float>(219 << shift);
+        chromaScale = maxCode / static_cast<float>(224 << shift);
+    }
+    
+    // Column-major: columns multiply Y, U (Cb) and V (Cr)
+    float matrix[9] = {
+        lumaScale, lumaScale, lumaScale,
+        0.0f, -2.0f * kb * (1.0f - kb) / kg * chromaScale, 2.0f * (1.0f - kb) * chromaScale,
+        2.0f * (1.0f - kr) * chromaScale, -2.0f * kr * (1.0f - kr) / kg * chromaScale, 0.0f
+    };
+    shader->setUniformMatrix3fv("uYuvMatrix", matrix);
+    shader->setUniform("uYuvOffset", black, chromaMid, chromaMid);
+    // P010 puts the 10 bits in the high bits of the word (x << 6)
+    float scale = 1.0f;
+    if (tenBit) {
+        scale = msbAligned ? 65535.0f / (1023.0f * 64.0f) : 65535.0f / 1023.0f;
+    }
+    shader->setUniform("uYuvScale", scale);
 }
 
 bool OpenGLRenderer::renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, const LayerProperties& properties, const FrameInfo& frameInfo) {
@@ -869,6 +2520,12 @@ bool OpenGLRenderer::renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, c
     }
 
     TexturePlaneType planeType = gpuFrame.getPlaneType();
+    
+    // VAAPI VPP made progressive frames of both fields: pick one, no shader pass
+    bool vppFields = gpuFrame.isDeinterlaced();
+    if (vppFields) {
+        layerField_.parity = -1;
+    }
 
     // For multi-plane formats (NV12, YUV420P), skip bindGPUTexture
     // We'll bind textures manually in the shader path
@@ -885,7 +2542,7 @@ bool OpenGLRenderer::renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, c
     float quad_y = 1.0f;
     
     if (letterbox_) {
-        float asp_src = frameInfo.aspect > 0.0f ? frameInfo.aspect : (float)properties.width / (float)properties.height;
+        float asp_src = layerAspect(properties, frameInfo);
         float asp_dst = (float)viewportWidth_ / (float)viewportHeight_;
         
         if (asp_dst > asp_src) {
@@ -898,150 +2555,142 @@ bool OpenGLRenderer::renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, c
     }
     
     // Use shader-based rendering if available (supports corner deformation)
-    if (useShaders_ && rgbaShader_) {
+    if (shaderCache_) {
+        // Plain single-plane layers join the pending instanced draw
+        // HAP Q and HAP HDR need their own conversion shader
+        bool needsHapShader = gpuFrame.isHAPTexture() && (gpuFrame.getHapVariant() == HapVariant::HAP_Q ||
+                                                          gpuFrame.getHapVariant() == HapVariant::HAP_HDR);
+        if (planeType == TexturePlaneType::SINGLE && !needsHapShader && canBatch(properties)) {
+            queueBatchedLayer(gpuFrame.getTextureId(), quad_x, quad_y, properties);
+            return true;
+        }
+        flushLayerBatch();
+        
         // Apply blend mode (use shared function to avoid duplication)
         applyBlendModeFromProps(properties);
         
-        // Select shader based on texture format and quality setting
-        ShaderProgram* shader = nullptr;
-        
-        if (planeType == TexturePlaneType::YUV_NV12 && nv12Shader_) {
-            // NV12 format (VAAPI, CUDA)
-            shader = nv12Shader_.get();
+        // Select the shader kind for the texture format and bind its planes
+        ShaderKind kind = ShaderKind::RGBA;
+        if (planeType == TexturePlaneType::YUV_NV12 || planeType == TexturePlaneType::YUV_P010) {
+            // NV12 format (VAAPI, CUDA); P010 has the same layout in 16-bit planes
+            kind = ShaderKind::NV12;
             
             GLuint texY = gpuFrame.getTextureId(0);
             GLuint texUV = gpuFrame.getTextureId(1);
+            if (vppFields && layerField_.phase == 1 && gpuFrame.hasSecondField()) {
+                texY = gpuFrame.getSecondFieldTextureId(0);
+                texUV = gpuFrame.getSecondFieldTextureId(1);
+            }
             
-            // Bind Y plane to texture unit 0
-            // Note: glEnable(GL_TEXTURE_2D) not needed with shaders (mpv doesn't use it)
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texY);
-            
-            // Bind UV plane to texture unit 1
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, texUV);
-            
-            // Reset to texture unit 0
-            glActiveTexture(GL_TEXTURE0);
-            
-            shader->use();
-            shader->setUniform("uTexY", 0);   // Texture unit 0
-            shader->setUniform("uTexUV", 1);  // Texture unit 1
-            
+            // Y plane on texture unit 0, UV plane on unit 1
+            glState_.bindTexture(1, texUV);
+            glState_.bindTexture(0, texY);
             
-        } else if (planeType == TexturePlaneType::YUV_420P && yuv420pShader_) {
+        } else if (planeType == TexturePlaneType::YUV_420P || planeType == TexturePlaneType::YUV_420P10) {
             // YUV420P format (software decoded, some hardware decoders)
-            shader = yuv420pShader_.get();
-            
-            // Bind Y plane to texture unit 0
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gpuFrame.getTextureId(0));
+            kind = ShaderKind::YUV420P;
             
-            // Bind U plane to texture unit 1
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, gpuFrame.getTextureId(1));
+            // Y, U and V planes on texture units 0, 1 and 2
+            glState_.bindTexture(2, gpuFrame.getTextureId(2));
+            glState_.bindTexture(1, gpuFrame.getTextureId(1));
+            glState_.bindTexture(0, gpuFrame.getTextureId(0));
             
-            // Bind V plane to texture unit 2
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, gpuFrame.getTextureId(2));
+        } else if (planeType == TexturePlaneType::YUV_UYVY || planeType == TexturePlaneType::YUV_YUYV) {
+            // Packed 4:2:2 (NDI, V4L2): one texture, luma and chroma split in
+            // the shader (YUYV textures are swizzled to read as UYVY)
+            kind = ShaderKind::UYVY;
             
-            // Reset to texture unit 0
-            glActiveTexture(GL_TEXTURE0);
+            glState_.bindTexture(0, gpuFrame.getTextureId(0));
             
-            shader->use();
-            shader->setUniform("uTexY", 0);   // Texture unit 0
-            shader->setUniform("uTexU", 1);   // Texture unit 1
-            shader->setUniform("uTexV", 2);   // Texture unit 2
-            
-        } else if (planeType == TexturePlaneType::HAP_Q_ALPHA && hapQAlphaShader_) {
+        } else if (planeType == TexturePlaneType::HAP_Q_ALPHA && shaderCache_->get(ShaderKind::HAP_Q_ALPHA, 0)) {
             // HAP Q Alpha (dual texture: YCoCg color + alpha)
-            shader = hapQAlphaShader_.get();
-            
-            // Bind YCoCg color texture to unit 0
-            // Note: glEnable(GL_TEXTURE_2D) not needed with shaders (mpv doesn't use it)
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gpuFrame.getTextureId(0));
+            kind = ShaderKind::HAP_Q_ALPHA;
             
-            // Bind alpha texture to unit 1
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, gpuFrame.getTextureId(1));
+            // YCoCg color texture on unit 0, alpha texture on unit 1
+            glState_.bindTexture(1, gpuFrame.getTextureId(1));
+            glState_.bindTexture(0, gpuFrame.getTextureId(0));
             
-            // Reset to texture unit 0
-            glActiveTexture(GL_TEXTURE0);
-            
-            shader->use();
-            shader->setUniform("uTexture", 0);       // YCoCg texture unit 0
-            shader->setUniform("uTextureAlpha", 1);  // Alpha texture unit 1
-            
-        } else {
-            // RGBA/single-plane format (HAP, HAP Alpha, decompressed frames)
-            // Check if this is HAP Q (YCoCg format)
-            bool isHAP = gpuFrame.isHAPTexture();
+        } else if (gpuFrame.isHAPTexture()) {
+            // HAP Q: YCoCg DXT5 (single texture) - needs YCoCg→RGB conversion
+            // HAP HDR: BC6H linear float - tone mapped to the SDR output
+            // Others (HAP, HAP Alpha, HAP R) render like standard RGBA
+            // NOTE: HAP R support is UNTESTED - needs verification with actual HAP R files
             HapVariant variant = gpuFrame.getHapVariant();
-            
-            if (isHAP && variant == HapVariant::HAP_Q && hapQShader_) {
-                // HAP Q: YCoCg DXT5 (single texture) - needs YCoCg→RGB conversion
-                shader = hapQShader_.get();
-                shader->use();
-                shader->setUniform("uTexture", 0);  // Texture unit 0
-            } else {
-                // Standard RGBA/HAP/HAP Alpha/HAP R (BPTC RGBA renders like standard RGBA)
-                // NOTE: HAP R support is UNTESTED - needs verification with actual HAP R files
-                shader = (properties.cornerDeform.enabled && 
-                         properties.cornerDeform.highQuality && 
-                         rgbaShaderHQ_) 
-                        ? rgbaShaderHQ_.get() 
-                        : rgbaShader_.get();
-                
-                shader->use();
-                shader->setUniform("uTexture", 0);  // Texture unit 0
+            if (variant == HapVariant::HAP_Q && shaderCache_->get(ShaderKind::HAP_Q, 0)) {
+                kind = ShaderKind::HAP_Q;
+            } else if (variant == HapVariant::HAP_HDR && shaderCache_->get(ShaderKind::HAP_HDR, 0)) {
+                kind = ShaderKind::HAP_HDR;
             }
         }
         
-        shader->setUniform("uOpacity", properties.opacity);
+        uint32_t features = 0;
+        ShaderProgram* shader = layerShader(kind, properties, features, quad_x, quad_y);
+        if (!shader) {
+            return false;
+        }
+        
+        // Sampling uniforms of the layer's source, shared with the effect filter
+        const FrameInfo& sourceInfo = gpuFrame.info();
+        auto setSource = [&](ShaderProgram* program, uint32_t programFeatures) {
+            glState_.useProgram(program->getProgramId());
+            if (kind == ShaderKind::NV12) {
+                program->setUniform("uTexY", 0);   // Texture unit 0
+                program->setUniform("uTexUV", 1);  // Texture unit 1
+                setYuvUniforms(program, sourceInfo, planeType == TexturePlaneType::YUV_P010, true);
+            } else if (kind == ShaderKind::YUV420P) {
+                program->setUniform("uTexY", 0);   // Texture unit 0
+                program->setUniform("uTexU", 1);   // Texture unit 1
+                program->setUniform("uTexV", 2);   // Texture unit 2
+                setYuvUniforms(program, sourceInfo, planeType == TexturePlaneType::YUV_420P10);
+            } else if (kind == ShaderKind::UYVY) {
+                program->setUniform("uTexUYVY", 0);
+                setYuvUniforms(program, sourceInfo, false);
+            } else {
+                program->setUniform("uTexture", 0);  // Texture unit 0
+                if (kind == ShaderKind::HAP_Q_ALPHA) {
+                    program->setUniform("uTextureAlpha", 1);  // Alpha texture unit 1
+                }
+            }
+            
+            // Set color correction uniforms for per-layer color adjustment
+            if (programFeatures & VideoShaders::FEATURE_COLOR_CORRECTION) {
+                setColorCorrectionUniforms(program, properties.colorAdjust);
+            }
+            if (programFeatures & VideoShaders::FEATURE_DEINTERLACE) {
+                setFieldUniforms(program);
+            }
+            if (programFeatures & VideoShaders::FEATURE_PACKED_ALPHA) {
+                // A texel of inset keeps 4:2:0 chroma (half resolution) off the seam too
+                float inset = planeType == TexturePlaneType::SINGLE ? 0.5f : 1.0f;
+                setPackedAlphaUniforms(program, properties, sourceInfo.width, sourceInfo.height, inset);
+            }
+        };
+        
+        // Blur and sharpen read the source filtered at reduced size
+        EffectChain::Plan effectPlan;
+        const EffectTargetPool::Target* filtered = nullptr;
+        if (features & VideoShaders::FEATURE_EFFECTS) {
+            effectPlan = EffectChain::plan(properties.effects, sourceInfo.width, sourceInfo.height);
+            filtered = renderEffectFilter(effectPlan, kind, features, setSource);
+        }
         
-        // Set color correction uniforms for per-layer color adjustment
-        setColorCorrectionUniforms(shader, properties.colorAdjust);
+        setSource(shader, features);
+        shader->setUniform("uOpacity", properties.opacity * masterOpacity_);
+        if (features & VideoShaders::FEATURE_EFFECTS) {
+            setEffectUniforms(shader, properties.effects, effectPlan, filtered);
+        }
         
         // Handle corner deformation (homography warping) - works with all shader types
-        if (properties.cornerDeform.enabled) {
-            // Calculate source corners (base quad before warping)
-            Point src[4];
-            src[0].x = -quad_x;
-            src[0].y = -quad_y;
-            src[1].x = quad_x;
-            src[1].y = -quad_y;
-            src[2].x = quad_x;
-            src[2].y = quad_y;
-            src[3].x = -quad_x;
-            src[3].y = quad_y;
-            
-            // Calculate destination corners (with deformation offsets)
-            Point dst[4];
-            dst[0].x = src[0].x + properties.cornerDeform.corners[0];
-            dst[0].y = src[0].y + properties.cornerDeform.corners[1];
-            dst[1].x = src[1].x + properties.cornerDeform.corners[2];
-            dst[1].y = src[1].y + properties.cornerDeform.corners[3];
-            dst[2].x = src[2].x + properties.cornerDeform.corners[4];
-            dst[2].y = src[2].y + properties.cornerDeform.corners[5];
-            dst[3].x = src[3].x + properties.cornerDeform.corners[6];
-            dst[3].y = src[3].y + properties.cornerDeform.corners[7];
-            
-            // Compute homography matrix
-            GLfloat homography[16];
-            findHomography(src, dst, homography);
-            
-            shader->setUniform("uUseHomography", 1);
+        const float* homography = nullptr;
+        if (features & VideoShaders::FEATURE_HOMOGRAPHY) {
+            // Solved once per corner set (and letterboxed quad size)
+            homography = cornerWarps_.get(quad_x, quad_y, properties.cornerDeform.corners).matrix;
             shader->setUniformMatrix4fv("uHomography", homography);
-            
-            // Set anisotropy level for high-quality RGBA shader
-            if (properties.cornerDeform.highQuality && 
-                planeType == TexturePlaneType::SINGLE && 
-                rgbaShaderHQ_ && shader == rgbaShaderHQ_.get()) {
-                shader->setUniform("uAnisotropy", 4.0f);
-            }
-        } else {
-            shader->setUniform("uUseHomography", 0);
+        }
+        
+        // Set anisotropy level for the high-quality RGBA permutation
+        if (features & VideoShaders::FEATURE_ANISOTROPIC) {
+            shader->setUniform("uAnisotropy", 4.0f);
         }
         
         // Compute MVP matrix (position, scale, rotation - homography applied separately in shader)
@@ -1057,9 +2706,13 @@ bool OpenGLRenderer::renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, c
         // For now, we'll render without crop (will be implemented in Phase 2)
         
         // Bind VAO and draw
-        glBindVertexArray(quadVAO_);
+        glState_.bindVertexArray(quadVAO_);
+        beginAdvancedBlend(shader, features, properties, mvp, homography);
         glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-        glBindVertexArray(0);
+        endAdvancedBlend(features);
+        if (filtered) {
+            effectTargets_->release(filtered);
+        }
         
         // NOTE: Removed glFinish() here - it was causing GPU pipeline stalls
         // The DMA-BUF data is read by the GPU during glDrawArrays, and we keep
@@ -1067,229 +2720,106 @@ bool OpenGLRenderer::renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, c
         // The page flip (vsync wait) provides the necessary synchronization.
         // This matches mpv's approach for smooth playback.
         
-        shader->unbind();
-        
-        // Unbind and disable multi-plane textures (like mpv does)
-        if (planeType == TexturePlaneType::YUV_NV12 || planeType == TexturePlaneType::YUV_420P) {
-            // Unbind texture unit 1
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glDisable(GL_TEXTURE_2D);
-            
-            // Unbind texture unit 0
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glDisable(GL_TEXTURE_2D);
-            
-            if (planeType == TexturePlaneType::YUV_420P) {
-                // Also unbind texture unit 2 for YUV420P
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, 0);
-                glDisable(GL_TEXTURE_2D);
-                glActiveTexture(GL_TEXTURE0);
-            }
-        }
+        // Planes stay bound: the next layer rebinds only what differs, and
+        // endPass() unbinds every unit
         
         return true;
     }
 
-    // Fallback: Fixed-function pipeline (only if shaders unavailable)
-    // Apply layer transform
-    glPushMatrix();
-    
-    // Apply position (x, y) - convert from pixel coordinates to normalized coordinates
-    if (viewportWidth_ > 0 && viewportHeight_ > 0) {
-        float normX = (2.0f * properties.x) / viewportWidth_;
-        float normY = (2.0f * properties.y) / viewportHeight_;
-        glTranslatef(normX, -normY, 0.0f);  // Negative Y because OpenGL Y is inverted
-    }
-    
-    glScalef(properties.scaleX, properties.scaleY, 1.0f);
-    
-    // Apply rotation (around center)
-    if (properties.rotation != 0.0f) {
-        glTranslatef(0.5f, 0.5f, 0.0f);
-        glRotatef(properties.rotation, 0.0f, 0.0f, 1.0f);
-        glTranslatef(-0.5f, -0.5f, 0.0f);
-    }
-    
-    // Apply corner deformation (warping) if enabled
-    if (properties.cornerDeform.enabled) {
-        // Calculate source corners (base quad)
-        Point src[4];
-        src[0].x = -quad_x;
-        src[0].y = -quad_y;
-        src[1].x = quad_x;
-        src[1].y = -quad_y;
-        src[2].x = quad_x;
-        src[2].y = quad_y;
-        src[3].x = -quad_x;
-        src[3].y = quad_y;
-        
-        // Calculate destination corners (with deformation offsets)
-        Point dst[4];
-        dst[0].x = src[0].x + properties.cornerDeform.corners[0];
-        dst[0].y = src[0].y + properties.cornerDeform.corners[1];
-        dst[1].x = src[1].x + properties.cornerDeform.corners[2];
-        dst[1].y = src[1].y + properties.cornerDeform.corners[3];
-        dst[2].x = src[2].x + properties.cornerDeform.corners[4];
-        dst[2].y = src[2].y + properties.cornerDeform.corners[5];
-        dst[3].x = src[3].x + properties.cornerDeform.corners[6];
-        dst[3].y = src[3].y + properties.cornerDeform.corners[7];
-        
-        // Calculate homography matrix
-        GLfloat homography[16];
-        findHomography(src, dst, homography);
-        
-        // Apply homography matrix
-        glMultMatrixf(homography);
-    }
-
-    // Apply blend mode (use shared function to avoid duplication)
-    applyBlendModeFromProps(properties);
-
-    // Set opacity
-    glColor4f(1.0f, 1.0f, 1.0f, properties.opacity);
-    
-    // Render centered quad
-    float x = -quad_x;
-    float y = -quad_y;
-    float w = 2.0f * quad_x;
-    float h = 2.0f * quad_y;
-
-    // Calculate texture coordinates for cropping/panorama
-    float texX = 0.0f, texY = 0.0f, texWidth = 1.0f, texHeight = 1.0f;
-    calculateCropCoordinatesFromProps(properties, frameInfo, texX, texY, texWidth, texHeight);
-
-    // Render quad with texture coordinates
-    // All GPU textures (HAP and hardware-decoded) use GL_TEXTURE_2D
-    // GL_TEXTURE_2D uses normalized texture coordinates (0.0-1.0)
-    GLenum target = GL_TEXTURE_2D;
-    
-    // Use normalized texture coordinates (0.0-1.0) for GL_TEXTURE_2D
-    glBegin(GL_QUADS);
-    glTexCoord2f(texX, texY + texHeight); glVertex2f(x, y);
-    glTexCoord2f(texX + texWidth, texY + texHeight); glVertex2f(x + w, y);
-    glTexCoord2f(texX + texWidth, texY); glVertex2f(x + w, y + h);
-    glTexCoord2f(texX, texY); glVertex2f(x, y + h);
-    glEnd();
-
-    // Disable texture
-    glDisable(target);
-    glPopMatrix();
-
-    return true;
+    // Renderer not initialized: no programs to draw with
+    return false;
 }
 
-void OpenGLRenderer::renderOSDItems(const std::vector<OSDRenderItem>& items) {
-    if (items.empty()) {
+void OpenGLRenderer::renderOSDItems(const ArenaVector<OSDRenderItem>& items) {
+    if (items.empty() || !osdShader_ || osdVAO_ == 0) {
         return;
     }
+    glState_.invalidate();
 
-    // Save current OpenGL state before modifying for OSD rendering
-    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
-    
-    // CRITICAL: Disable GL_TEXTURE_RECTANGLE_ARB (used by video layers) before rendering OSD
-    // OSD uses GL_TEXTURE_2D, and both cannot be active simultaneously
-    glDisable(GL_TEXTURE_RECTANGLE_ARB);
-    
-    // Save and set projection matrix for OSD (2D overlay in normalized coordinates)
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
-
-    // Save and set modelview matrix for OSD
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    // Disable depth test (we're rendering 2D overlay on top of everything)
+    // 2D overlay on top of everything, standard alpha blending: transparent
+    // pixels (A=0) leave the destination unchanged
     glDisable(GL_DEPTH_TEST);
-    // Ensure OSD is rendered on top by using a high depth value if depth test were enabled
-    // Since depth test is disabled, this is just for clarity
-
-    // Enable blending for OSD
-    glEnable(GL_BLEND);
-    // Use standard alpha blending for correct rendering of textures with alpha
-    // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA works for non-premultiplied alpha
-    // This ensures transparent pixels (A=0) are completely invisible
-    // When A=0: src contribution = 0, dst contribution = 1.0 * dst (unchanged)
-    // When A=255: src contribution = 1.0 * src, dst contribution = 0 (fully opaque)
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Disable face culling
     glDisable(GL_CULL_FACE);
-    
-    // Enable texture 2D (OSD uses GL_TEXTURE_2D, not GL_TEXTURE_RECTANGLE_ARB)
-    // Note: glEnable(GL_TEXTURE_2D) is deprecated in Core Profile
-    if (!isCoreProfile_) {
-    glEnable(GL_TEXTURE_2D);
-    }
-    
-    // Set color to white (texture provides color)
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glState_.setBlend(true);
+    glState_.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Item and glyph rectangles are in screen pixels from the top-left (Y down);
+    // OpenGL coordinates here are -1 to 1 with Y up
+    const float sx = 2.0f / viewportWidth_;
+    const float sy = 2.0f / viewportHeight_;
+
+    // Two triangles per rectangle: x, y, u, v per vertex
+    std::vector<float>& vertices = osdVertices_;
+    auto addQuad = [&vertices](float x0, float y0, float x1, float y1,
+                               float u0, float v0, float u1, float v1) {
+        const float quad[6][4] = {
+            {x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1},
+            {x0, y0, u0, v0}, {x1, y1, u1, v1}, {x0, y1, u0, v1}
+        };
+        vertices.insert(vertices.end(), &quad[0][0], &quad[0][0] + 24);
+    };
+    auto draw = [this, &vertices]() {
+        if (vertices.empty()) {
+            return;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, osdVBO_);
+        // Orphan each time: the previous draw may still be in flight
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size() / 4));
+        vertices.clear();
+    };
 
-    // Render each OSD item
+    glState_.useProgram(osdShader_->getProgramId());
+    glState_.bindVertexArray(osdVAO_);
+    osdShader_->setUniform("uTexture", 0);
+
+    // Boxes first, untextured, so no glyph is drawn under another item's box
+    vertices.clear();
     for (const auto& item : items) {
-        if (item.textureId == 0) {
-            LOG_WARNING << "OSD: Skipping item with textureId=0";
+        if (!item.hasBox) {
             continue;
         }
-
-        glBindTexture(GL_TEXTURE_2D, item.textureId);
-        
-        // Set texture environment to MODULATE for proper alpha blending
-        // Video layers use GL_DECAL which ignores alpha - we need MODULATE for transparency
-        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-
-        // Calculate normalized coordinates
-        // OpenGL coordinates: -1 to 1, with origin at center, Y up (top=1.0, bottom=-1.0)
-        // Screen coordinates: 0 to viewportWidth/Height, with origin at top-left, Y down (top=0, bottom=height)
-        // item.x and item.y are in screen pixels from top-left (item.y is top of text)
-        float x = -1.0f + (2.0f * item.x / viewportWidth_);
-        // Convert screen Y (top=0) to OpenGL Y (top=1.0): y_gl = 1.0 - 2.0 * (y_screen / height)
-        float y = 1.0f - (2.0f * item.y / viewportHeight_);
-        float w = 2.0f * item.width / viewportWidth_;
-        // Height is negative because we're going down from top
-        float h = -2.0f * item.height / viewportHeight_;
-
-        // Ensure texture is bound and enabled
-        if (!isCoreProfile_) {
-        glEnable(GL_TEXTURE_2D);
+        float x0 = -1.0f + sx * item.x;
+        float y0 = 1.0f - sy * item.y;
+        addQuad(x0, y0, x0 + sx * item.width, y0 - sy * item.height, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+    osdShader_->setUniform("uTextured", 0);
+    osdShader_->setUniform("uColor", 0.0f, 0.0f, 0.0f, 1.0f);
+    draw();
+
+    // Glyphs: one draw per atlas texture (normally one for all items), white
+    // texels with the glyph coverage in alpha
+    osdShader_->setUniform("uTextured", 1);
+    osdShader_->setUniform("uColor", 1.0f, 1.0f, 1.0f, 1.0f);
+    unsigned int boundTexture = 0;
+    for (const auto& item : items) {
+        if (item.textureId == 0 || item.glyphs.empty()) {
+            continue;
+        }
+        if (item.textureId != boundTexture) {
+            draw();
+            glState_.bindTexture(0, item.textureId);
+            boundTexture = item.textureId;
+        }
+        for (const auto& glyph : item.glyphs) {
+            // Atlas v = 0 is the glyph's top row
+            float x0 = -1.0f + sx * (item.x + glyph.x);
+            float y0 = 1.0f - sy * (item.y + glyph.y);
+            addQuad(x0, y0, x0 + sx * glyph.width, y0 - sy * glyph.height,
+                    glyph.u0, glyph.v0, glyph.u1, glyph.v1);
         }
-        
-        // Set color to white with full opacity for text
-        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-
-        // Render textured quad with proper texture coordinates
-        // OpenGL texture coordinates: (0,0) = bottom-left, (1,1) = top-right
-        // Our bitmap is stored with (0,0) at top-left, so we need to flip Y
-        // Top-left vertex -> (0,0) texture (bitmap top-left), bottom-left -> (0,1) texture (bitmap bottom-left)
-        glBegin(GL_QUADS);
-        glTexCoord2f(0.0f, 0.0f); glVertex2f(x, y);           // Top-left vertex -> bitmap top-left (0,0)
-        glTexCoord2f(1.0f, 0.0f); glVertex2f(x + w, y);       // Top-right vertex -> bitmap top-right (1,0)
-        glTexCoord2f(1.0f, 1.0f); glVertex2f(x + w, y + h);   // Bottom-right vertex -> bitmap bottom-right (1,1)
-        glTexCoord2f(0.0f, 1.0f); glVertex2f(x, y + h);       // Bottom-left vertex -> bitmap bottom-left (0,1)
-        glEnd();
     }
+    draw();
+    endPass();
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
-    
-    // Restore matrices (must restore in reverse order)
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    
-    // Restore all OpenGL state (including GL_TEXTURE_RECTANGLE_ARB if it was enabled)
-    glPopAttrib();
-    
-    // Re-enable GL_TEXTURE_RECTANGLE_ARB for video layers (they need it for next frame)
-    if (!isCoreProfile_) {
-    glEnable(GL_TEXTURE_RECTANGLE_ARB);
-    }
+void OpenGLRenderer::endPass() {
+    // Whatever draws next on this context (output blits, capture) binds
+    // its own program, vertex array and textures
+    glState_.unbindTextures();
+    glState_.useProgram(0);
+    glState_.bindVertexArray(0);
 }
 
 bool OpenGLRenderer::initQuadVBO() {
@@ -1336,9 +2866,27 @@ bool OpenGLRenderer::initQuadVBO() {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(float)));
     
+    // OSD boxes and glyphs: same layout, vertices streamed per draw
+    glGenVertexArrays(1, &osdVAO_);
+    glGenBuffers(1, &osdVBO_);
+    if (osdVAO_ == 0 || osdVBO_ == 0) {
+        LOG_ERROR << "Failed to generate OSD VAO/VBO";
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        cleanupQuadVBO();
+        return false;
+    }
+    glBindVertexArray(osdVAO_);
+    glBindBuffer(GL_ARRAY_BUFFER, osdVBO_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(float)));
+    
     // Unbind
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    glState_.invalidate();
     
     LOG_VERBOSE << "Quad VBO/VAO initialized (VAO: " << quadVAO_ << ", VBO: " << quadVBO_ << ")";
     return true;
@@ -1353,73 +2901,155 @@ void OpenGLRenderer::cleanupQuadVBO() {
         glDeleteVertexArrays(1, &quadVAO_);
         quadVAO_ = 0;
     }
+    if (osdVBO_ != 0) {
+        glDeleteBuffers(1, &osdVBO_);
+        osdVBO_ = 0;
+    }
+    if (osdVAO_ != 0) {
+        glDeleteVertexArrays(1, &osdVAO_);
+        osdVAO_ = 0;
+    }
+    osdVertices_.clear();
 }
 
 bool OpenGLRenderer::initShaders() {
-    // Create RGBA shader (for CPU frames, HAP)
-    rgbaShader_ = std::make_unique<ShaderProgram>();
-    if (!rgbaShader_->createFromSource(VideoShaders::VERTEX_SHADER, VideoShaders::FRAGMENT_RGBA)) {
+    // Layer programs are built per feature set on first use; compile the plain
+    // permutations now so missing driver support shows up at startup
+    shaderCache_ = std::make_unique<ShaderCache>();
+    shaderCache_->setBlendPath(blendPath_);
+    colorLuts_ = std::make_unique<ColorLutCache>();
+    if (!shaderCache_->get(ShaderKind::RGBA, 0)) {
         LOG_ERROR << "Failed to create RGBA shader";
         cleanupShaders();
         return false;
     }
-    
-    // Create high-quality RGBA shader (for extreme corner warping)
-    rgbaShaderHQ_ = std::make_unique<ShaderProgram>();
-    if (!rgbaShaderHQ_->createFromSource(VideoShaders::VERTEX_SHADER, VideoShaders::FRAGMENT_RGBA_HQ)) {
-        LOG_WARNING << "Failed to create HQ RGBA shader, will use standard quality for warping";
-        rgbaShaderHQ_.reset();
-    }
-    
-    // Create NV12 shader (for VAAPI/CUDA)
-    nv12Shader_ = std::make_unique<ShaderProgram>();
-    if (!nv12Shader_->createFromSource(VideoShaders::VERTEX_SHADER, VideoShaders::FRAGMENT_NV12)) {
+    if (!shaderCache_->get(ShaderKind::NV12, 0)) {
         LOG_ERROR << "Failed to create NV12 shader";
         cleanupShaders();
         return false;
     }
-    
-    // Create YUV420P shader (fallback)
-    yuv420pShader_ = std::make_unique<ShaderProgram>();
-    if (!yuv420pShader_->createFromSource(VideoShaders::VERTEX_SHADER, VideoShaders::FRAGMENT_YUV420P)) {
+    if (!shaderCache_->get(ShaderKind::YUV420P, 0)) {
         LOG_ERROR << "Failed to create YUV420P shader";
         cleanupShaders();
         return false;
     }
-    
-    // Create HAP Q shader (YCoCg→RGB conversion)
-    hapQShader_ = std::make_unique<ShaderProgram>();
-    if (!hapQShader_->createFromSource(HAP_VERTEX_SHADER, HAP_Q_FRAGMENT_SHADER)) {
+    if (!shaderCache_->get(ShaderKind::HAP_Q, 0)) {
         LOG_WARNING << "Failed to create HAP Q shader, HAP Q videos will use fallback";
-        hapQShader_.reset();
     }
-    
-    // Create HAP Q Alpha shader (dual texture: YCoCg + alpha)
-    hapQAlphaShader_ = std::make_unique<ShaderProgram>();
-    if (!hapQAlphaShader_->createFromSource(HAP_VERTEX_SHADER, HAP_Q_ALPHA_FRAGMENT_SHADER)) {
+    if (!shaderCache_->get(ShaderKind::HAP_Q_ALPHA, 0)) {
         LOG_WARNING << "Failed to create HAP Q Alpha shader, HAP Q Alpha videos will use fallback";
-        hapQAlphaShader_.reset();
+    }
+    if (!shaderCache_->get(ShaderKind::HAP_HDR, 0)) {
+        LOG_WARNING << "Failed to create HAP HDR shader, HAP HDR videos will not be tone mapped";
+    }
+    
+    // With binaries on disk every permutation loads quickly: build them all
+    // now instead of compiling when a layer first enables a feature mid-show
+    if (ProgramBinaryCache::instance().isEnabled()) {
+        size_t programs = shaderCache_->prewarm();
+        LOG_VERBOSE << "Shader permutations ready: " << programs;
     }
     
-    // Create master post-processing shader (for FBO with color correction)
+    // Master pass (FBO composite drawn with the master transforms)
     masterShader_ = std::make_unique<ShaderProgram>();
     if (!masterShader_->createFromSource(VideoShaders::MASTER_VERTEX_SHADER, VideoShaders::MASTER_FRAGMENT_SHADER)) {
-        LOG_WARNING << "Failed to create master shader, master color correction will be disabled";
-        masterShader_.reset();
+        LOG_ERROR << "Failed to create master shader";
+        cleanupShaders();
+        return false;
+    }
+    
+    // OSD boxes and text
+    osdShader_ = std::make_unique<ShaderProgram>();
+    if (!osdShader_->createFromSource(VideoShaders::OSD_VERTEX_SHADER, VideoShaders::OSD_FRAGMENT_SHADER)) {
+        LOG_WARNING << "Failed to create OSD shader, OSD will not be drawn";
+        osdShader_.reset();
+    }
+    
+    // Layer effect filters (blur, sharpen) and their shared intermediates
+    effectBlurShader_ = std::make_unique<ShaderProgram>();
+    if (!effectBlurShader_->createFromSource(VideoShaders::EFFECT_VERTEX_SHADER,
+                                             VideoShaders::EFFECT_BLUR_FRAGMENT_SHADER)) {
+        LOG_WARNING << "Failed to create effect blur shader, blur and sharpen will not be applied";
+        effectBlurShader_.reset();
     }
+    effectTargets_ = std::make_unique<EffectTargetPool>();
     
     LOG_VERBOSE << "All video shaders compiled successfully";
     return true;
 }
 
 void OpenGLRenderer::cleanupShaders() {
-    rgbaShader_.reset();
-    rgbaShaderHQ_.reset();
-    nv12Shader_.reset();
-    yuv420pShader_.reset();
-    hapQShader_.reset();
-    hapQAlphaShader_.reset();
+    shaderCache_.reset();
+    colorLuts_.reset();
+    batchProgramId_ = 0;
     masterShader_.reset();
+    osdShader_.reset();
+    effectBlurShader_.reset();
+    effectTargets_.reset();
+}
+
+ShaderProgram* OpenGLRenderer::layerShader(ShaderKind kind, const LayerProperties& props, uint32_t& features,
+                                           float quad_x, float quad_y) {
+    features = 0;
+    if (props.colorAdjust.isActive()) {
+        features |= VideoShaders::FEATURE_COLOR_CORRECTION;
+    }
+    if (props.cornerDeform.enabled) {
+        features |= VideoShaders::FEATURE_HOMOGRAPHY;
+        // Mild warps sample as sharply without the gradient filtering
+        if (props.cornerDeform.highQuality &&
+            !cornerWarps_.get(quad_x, quad_y, props.cornerDeform.corners).isMild()) {
+            features |= VideoShaders::FEATURE_ANISOTROPIC;
+        }
+    }
+    if (layerField_.parity >= 0) {
+        // Field sampling takes the place of the gradient sampling
+        features |= VideoShaders::FEATURE_DEINTERLACE;
+        features &= ~static_cast<uint32_t>(VideoShaders::FEATURE_ANISOTROPIC);
+    }
+    if (props.packedAlpha != PackedAlpha::Layout::NONE) {
+        features |= VideoShaders::FEATURE_PACKED_ALPHA;
+    }
+    if (AdvancedBlend::readsDestination(props.blendMode)) {
+        features |= VideoShaders::FEATURE_ADVANCED_BLEND;
+    }
+    if (props.effects.isActive()) {
+        features |= VideoShaders::FEATURE_EFFECTS;
+    }
+    features &= ShaderCache::supportedFeatures(kind);
+    
+    ShaderProgram* shader = shaderCache_->get(kind, features);
+    if (!shader && (features & VideoShaders::FEATURE_ANISOTROPIC)) {
+        // High-quality sampling is optional: use standard quality for warping
+        features &= ~static_cast<uint32_t>(VideoShaders::FEATURE_ANISOTROPIC);
+        shader = shaderCache_->get(kind, features);
+    }
+    if (!shader && features != 0) {
+        // Draw unadjusted rather than not at all
+        features = 0;
+        shader = shaderCache_->get(kind, features);
+    }
+    return shader;
+}
+
+void OpenGLRenderer::setFieldUniforms(ShaderProgram* shader) {
+    shader->setUniform("uField", layerField_.parity);
+    shader->setUniform("uDeinterlaceAdaptive", layerField_.adaptive ? 1 : 0);
+}
+
+float OpenGLRenderer::layerAspect(const LayerProperties& props, const FrameInfo& frameInfo) const {
+    float aspect = frameInfo.aspect > 0.0f ? frameInfo.aspect : (float)props.width / (float)props.height;
+    return PackedAlpha::pictureAspect(props.packedAlpha, aspect);
+}
+
+void OpenGLRenderer::setPackedAlphaUniforms(ShaderProgram* shader, const LayerProperties& props, int width,
+                                            int height, float insetTexels) {
+    PackedAlpha::Rect color;
+    PackedAlpha::Rect alpha;
+    PackedAlpha::regions(props.packedAlpha, width, height, insetTexels, color, alpha);
+    shader->setUniform("uPackedColorRect", color.offsetX, color.offsetY, color.scaleX, color.scaleY);
+    shader->setUniform("uPackedAlphaRect", alpha.offsetX, alpha.offsetY, alpha.scaleX, alpha.scaleY);
+    shader->setUniform("uPackedPremultiplied", props.packedAlphaPremultiplied ? 1 : 0);
 }
 
 void OpenGLRenderer::computeMVPMatrix(float* mvp, float x, float y, float width, float height,
@@ -1467,6 +3097,28 @@ void OpenGLRenderer::computeMVPMatrix(float* mvp, float x, float y, float width,
     // Translation
     mvp[12] = posX;
     mvp[13] = posY;
+    
+    // Folded master transform applies on top of the layer's own
+    if (masterFolded_) {
+        float layerMvp[16];
+        memcpy(layerMvp, mvp, sizeof(layerMvp));
+        for (int col = 0; col < 4; col++) {
+            for (int row = 0; row < 4; row++) {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; k++) {
+                    sum += masterMatrix_[k * 4 + row] * layerMvp[col * 4 + k];
+                }
+                mvp[col * 4 + row] = sum;
+            }
+        }
+    }
+    
+    if (flipLayers_) {
+        mvp[1] = -mvp[1];
+        mvp[5] = -mvp[5];
+        mvp[9] = -mvp[9];
+        mvp[13] = -mvp[13];
+    }
 }
 
 void OpenGLRenderer::renderQuadWithShader(ShaderProgram* shader, float x, float y, 
@@ -1475,8 +3127,7 @@ void OpenGLRenderer::renderQuadWithShader(ShaderProgram* shader, float x, float
         return;
     }
     
-    // Use shader
-    shader->use();
+    glState_.useProgram(shader->getProgramId());
     
     // Compute MVP matrix
     float mvp[16];
@@ -1484,18 +3135,16 @@ void OpenGLRenderer::renderQuadWithShader(ShaderProgram* shader, float x, float
     
     // Set uniforms
     shader->setUniformMatrix4fv("uMVP", mvp);
-    shader->setUniform("uOpacity", props.opacity);
+    shader->setUniform("uOpacity", props.opacity * masterOpacity_);
     
-    // Set color correction uniforms
-    setColorCorrectionUniforms(shader, props.colorAdjust);
+    // Set color correction uniforms (caller picked a color-correcting program)
+    if (props.colorAdjust.isActive()) {
+        setColorCorrectionUniforms(shader, props.colorAdjust);
+    }
     
     // Bind VAO and draw
-    glBindVertexArray(quadVAO_);
+    glState_.bindVertexArray(quadVAO_);
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    glBindVertexArray(0);
-    
-    // Unbind shader
-    shader->unbind();
 }
 
 bool OpenGLRenderer::initMasterFBO(int width, int height) {
@@ -1527,7 +3176,7 @@ bool OpenGLRenderer::initMasterFBO(int width, int height) {
     }
     
     // Setup texture
-    glBindTexture(GL_TEXTURE_2D, masterFBOTexture_);
+    glState_.bindTexture(0, masterFBOTexture_);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -1548,7 +3197,7 @@ bool OpenGLRenderer::initMasterFBO(int width, int height) {
     }
     
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glState_.bindTexture(0, 0);
     
     masterFBOWidth_ = width;
     masterFBOHeight_ = height;
@@ -1576,195 +3225,72 @@ void OpenGLRenderer::renderMasterQuadWithTransforms() {
     // Render the FBO texture to screen with master transforms applied
     const MasterProperties& props = masterProperties_;
     
-    // PERFORMANCE: True zero-cost optimization for master layer
-    // ----------------------------------------------------------
-    // When color correction is disabled, we use the fixed-function path
-    // which has ZERO shader overhead. This is the "separate shader" approach
-    // applied to the master layer. For per-layer rendering, we use uniform
-    // branching instead (see setColorCorrectionUniforms for analysis).
-    //
-    // Use shader path if color correction is active and shader is available
-    if (props.colorAdjust.isActive() && masterShader_ && masterShader_->isValid()) {
-        // Shader-based rendering with color correction
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, masterFBOTexture_);
-        
-        masterShader_->use();
-        masterShader_->setUniform("uTexture", 0);
-        masterShader_->setUniform("uOpacity", props.opacity);
-        setMasterColorCorrectionUniforms(masterShader_.get(), props.colorAdjust);
-        
-        // Enable blending
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        
-        // Save matrix state for transforms
-        glPushMatrix();
-        
-        // Apply position offset
-        glTranslatef(props.x, props.y, 0.0f);
-        
-        // Apply scale
-        glScalef(props.scaleX, props.scaleY, 1.0f);
-        
-        // Apply rotation
-        if (props.rotation != 0.0f) {
-            glRotatef(props.rotation, 0.0f, 0.0f, 1.0f);
-        }
-        
-        // Apply corner deformation
-        if (props.cornerDeform.enabled) {
-            Point src[4];
-            src[0].x = -1.0; src[0].y = -1.0;
-            src[1].x =  1.0; src[1].y = -1.0;
-            src[2].x =  1.0; src[2].y =  1.0;
-            src[3].x = -1.0; src[3].y =  1.0;
-            
-            Point dst[4];
-            dst[0].x = src[0].x + props.cornerDeform.corners[0];
-            dst[0].y = src[0].y + props.cornerDeform.corners[1];
-            dst[1].x = src[1].x + props.cornerDeform.corners[2];
-            dst[1].y = src[1].y + props.cornerDeform.corners[3];
-            dst[2].x = src[2].x + props.cornerDeform.corners[4];
-            dst[2].y = src[2].y + props.cornerDeform.corners[5];
-            dst[3].x = src[3].x + props.cornerDeform.corners[6];
-            dst[3].y = src[3].y + props.cornerDeform.corners[7];
-            
-            GLfloat homography[16];
-            findHomography(src, dst, homography);
-            glMultMatrixf(homography);
-        }
-        
-        // Draw fullscreen quad using VAO
-        glBindVertexArray(quadVAO_);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-        glBindVertexArray(0);
-        
-        glPopMatrix();
-        masterShader_->unbind();
-        
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_BLEND);
-    } else {
-        // Fixed-function fallback (no color correction)
-        // Note: This path won't work in Core Profile (DRM mode)
-        if (!isCoreProfile_) {
-        glEnable(GL_TEXTURE_2D);
-        }
-        glBindTexture(GL_TEXTURE_2D, masterFBOTexture_);
-        
-        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-        
-        glPushMatrix();
-        
-        // Apply position offset
-        glTranslatef(props.x, props.y, 0.0f);
-        
-        // Apply scale
-        glScalef(props.scaleX, props.scaleY, 1.0f);
-        
-        // Apply rotation (around center)
-        if (props.rotation != 0.0f) {
-            glRotatef(props.rotation, 0.0f, 0.0f, 1.0f);
-        }
-        
-        // Apply corner deformation if enabled
-        if (props.cornerDeform.enabled) {
-            Point src[4];
-            src[0].x = -1.0; src[0].y = -1.0;
-            src[1].x =  1.0; src[1].y = -1.0;
-            src[2].x =  1.0; src[2].y =  1.0;
-            src[3].x = -1.0; src[3].y =  1.0;
-            
-            Point dst[4];
-            dst[0].x = src[0].x + props.cornerDeform.corners[0];
-            dst[0].y = src[0].y + props.cornerDeform.corners[1];
-            dst[1].x = src[1].x + props.cornerDeform.corners[2];
-            dst[1].y = src[1].y + props.cornerDeform.corners[3];
-            dst[2].x = src[2].x + props.cornerDeform.corners[4];
-            dst[2].y = src[2].y + props.cornerDeform.corners[5];
-            dst[3].x = src[3].x + props.cornerDeform.corners[6];
-            dst[3].y = src[3].y + props.cornerDeform.corners[7];
-            
-            GLfloat homography[16];
-            findHomography(src, dst, homography);
-            glMultMatrixf(homography);
+    // flip * translate * scale * rotate, then the corner deform before them
+    // (as for layers, the homography moves the quad's corners)
+    buildMasterMatrix();
+    float mvp[16];
+    memcpy(mvp, masterMatrix_, sizeof(mvp));
+    if (props.cornerDeform.enabled) {
+        const float* warp = cornerWarps_.get(1.0f, 1.0f, props.cornerDeform.corners).matrix;
+        for (int col = 0; col < 4; col++) {
+            for (int row = 0; row < 4; row++) {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; k++) {
+                    sum += masterMatrix_[k * 4 + row] * warp[col * 4 + k];
+                }
+                mvp[col * 4 + row] = sum;
+            }
         }
-        
-        // Set opacity
-        glColor4f(1.0f, 1.0f, 1.0f, props.opacity);
-        
-        // Enable blending for opacity
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        
-        // Render quad with FBO texture
-        glBegin(GL_QUADS);
-        glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, -1.0f);
-        glTexCoord2f(1.0f, 0.0f); glVertex2f( 1.0f, -1.0f);
-        glTexCoord2f(1.0f, 1.0f); glVertex2f( 1.0f,  1.0f);
-        glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f,  1.0f);
-        glEnd();
-        
-        glPopMatrix();
-        
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D);
-        glDisable(GL_BLEND);
-        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
     }
+    if (flipY_) {
+        mvp[1] = -mvp[1];
+        mvp[5] = -mvp[5];
+        mvp[9] = -mvp[9];
+        mvp[13] = -mvp[13];
+    }
+    
+    glState_.bindTexture(0, masterFBOTexture_);
+    
+    // Unadjusted composites skip the LUT (uColorCorrectionEnabled)
+    glState_.useProgram(masterShader_->getProgramId());
+    masterShader_->setUniform("uTexture", 0);
+    masterShader_->setUniform("uOpacity", props.opacity);
+    masterShader_->setUniformMatrix4fv("uMVP", mvp);
+    setMasterColorCorrectionUniforms(masterShader_.get(), props.colorAdjust);
+    
+    glState_.setBlend(true);
+    glState_.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    // Draw fullscreen quad using VAO
+    glState_.bindVertexArray(quadVAO_);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    
+    glState_.setBlend(false);
 }
 
-// Set color correction uniforms for per-layer rendering
-//
-// DESIGN DECISION: Always use shader path, rely on uniform branching
-// -------------------------------------------------------------------
-// We always use the shader path for all layers (CPU and GPU frames) rather than
-// switching between fixed-function and shader paths based on color correction state.
-//
-// Why:
-// 1. Consistent rendering - no visual artifacts from path switching mid-playback
-// 2. Negligible overhead - uniform branch check costs ~0.02% GPU per layer
-// 3. Simpler code - single render path to maintain
-//
-// When color correction is disabled (isActive() == false):
-//   - Only 1 uniform is set (uColorCorrectionEnabled = 0)
-//   - Shader branch skips all color math (~0.02% GPU overhead)
-//
-// When enabled:
-//   - 6 uniforms are set (enabled + 5 color values)
-//   - Full color correction applied in shader
+// Bind the baked colour table for per-layer rendering
 //
+// Only called for programs built with VideoShaders::FEATURE_COLOR_CORRECTION;
+// layers without an active adjustment use a permutation that has no color
+// stage at all (see VideoShaders::Feature). The table is baked by
+// ColorLutCache when the adjustment changes, not per frame.
 void OpenGLRenderer::setColorCorrectionUniforms(ShaderProgram* shader, 
                                                 const LayerProperties::ColorAdjustment& colorAdjust) {
-    if (!shader) return;
-    
-    bool enabled = colorAdjust.isActive();
-    shader->setUniform("uColorCorrectionEnabled", enabled ? 1 : 0);
+    if (!shader || !colorLuts_) return;
     
-    if (enabled) {
-        shader->setUniform("uBrightness", colorAdjust.brightness);
-        shader->setUniform("uContrast", colorAdjust.contrast);
-        shader->setUniform("uSaturation", colorAdjust.saturation);
-        shader->setUniform("uHue", colorAdjust.hue);
-        shader->setUniform("uGamma", colorAdjust.gamma);
-    }
+    colorLuts_->bind(shader, ColorLut::Adjustment::from(colorAdjust), colorAdjust.lutFile);
+    // The LUT goes on its own unit; the active unit is no longer known
+    glState_.invalidateTextures();
 }
 
 void OpenGLRenderer::setMasterColorCorrectionUniforms(ShaderProgram* shader,
                                                       const MasterProperties::ColorAdjustment& colorAdjust) {
     if (!shader) return;
     
-    bool enabled = colorAdjust.isActive();
+    bool enabled = colorAdjust.isActive() && colorLuts_ &&
+                   colorLuts_->bind(shader, ColorLut::Adjustment::from(colorAdjust), colorAdjust.lutFile);
+    glState_.invalidateTextures();
     shader->setUniform("uColorCorrectionEnabled", enabled ? 1 : 0);
-    
-    if (enabled) {
-        shader->setUniform("uBrightness", colorAdjust.brightness);
-        shader->setUniform("uContrast", colorAdjust.contrast);
-        shader->setUniform("uSaturation", colorAdjust.saturation);
-        shader->setUniform("uHue", colorAdjust.hue);
-        shader->setUniform("uGamma", colorAdjust.gamma);
-    }
 }
 
 } // namespace videocomposer
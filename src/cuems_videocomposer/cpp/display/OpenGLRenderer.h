@@ -3,27 +3,54 @@
 
 #include "../video/FrameBuffer.h"
 #include "../video/GPUTextureFrameBuffer.h"
+#include "../video/MappedFrameRing.h"
+#include "../video/FieldSelector.h"
+#include "../video/TileResidency.h"
+#include "../input/TiledImage.h"
 #include "../layer/VideoLayer.h"
+#include "../layer/LayerGroup.h"
 #include "ShaderProgram.h"
+#include "ShaderCache.h"
+#include "AdvancedBlend.h"
+#include "EffectChain.h"
+#include "EffectTargetPool.h"
+#include "ColorLutCache.h"
+#include "CornerWarpCache.h"
+#include "CanvasRegions.h"
 #include "MasterProperties.h"
+#include "GpuTimer.h"
+#include "GLStateCache.h"
+#include "BC1Encoder.h"
+#include "DrawOrder.h"
+#include "../utils/FrameArena.h"
 #include <vector>
 #include <map>
+#include <functional>
 #include <cstdint>
 #include <memory>
+#include <thread>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#endif
 
 // Forward declaration for OpenGL types
 typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
 
 namespace videocomposer {
 
 // Forward declaration
 struct OSDRenderItem;
+class TextureUploader;
 
 /**
  * OpenGLRenderer - Handles OpenGL rendering for layers
  * 
  * Manages shared OpenGL context, layer compositing, blending, and transforms.
- * This class handles the actual OpenGL rendering operations.
+ * This class handles the actual OpenGL rendering operations. Every path
+ * draws with shaders and vertex arrays, so any GL 3.3 context (core or
+ * compatibility) or GLES 3 context works.
  */
 class OpenGLRenderer {
 public:
@@ -41,99 +68,361 @@ public:
     
     // Render a layer from GPU texture (for HAP and hardware-decoded frames)
     bool renderLayerFromGPU(const GPUTextureFrameBuffer& gpuFrame, const LayerProperties& properties, const FrameInfo& frameInfo);
+    
+    // Draw a layer's whole current frame, letterboxed into the viewport,
+    // from the texture its last composite left (operator preview): no
+    // upload, its own placement and opacity ignored. False if the frame
+    // is not kept in a texture (upload thread) or nothing was drawn yet.
+    bool renderLayerPreview(const VideoLayer* layer);
 
     // Composite all layers (applies master transforms if active)
+    // Layers hidden under an opaque layer covering the viewport are skipped
+    // and marked occluded (VideoLayer::setOccluded)
     void compositeLayers(const std::vector<const VideoLayer*>& layers);
     
+    // Composite with layer groups: members are drawn into their group's
+    // cached image (again only when a member changed), and the image is
+    // drawn like a layer at the group's place in the z-order
+    void compositeLayers(const std::vector<const VideoLayer*>& layers, const std::vector<LayerGroup>& groups);
+    
+    // Upload the start frame of armed (hidden, standby) layers into their
+    // textures, so the composite after GO draws without an upload
+    // (called by compositeLayers; GPU-decoded frames are textures already)
+    void prepareArmedLayers(const std::vector<const VideoLayer*>& layers);
+    
+    // Copy the prepared frame of layers filling a loop cache into the
+    // cache's textures (see LoopFrameCache; called by compositeLayers)
+    void fillLoopCaches(const std::vector<const VideoLayer*>& layers);
+    
+    // Restrict compositing to the target pixels some output shows, in
+    // target pixels (the target is cleared and masked to them, see
+    // VirtualCanvas::setVisibleRects): the target is not cleared again, and
+    // layers missing every region are culled like occluded ones. Regions
+    // covering the viewport (the default) draw everything.
+    void setVisibleRegions(const CanvasRegions& regions) { visibleRegions_ = regions; }
+    
+    // Layers skipped by occlusion or visible-region culling in the last composite
+    size_t getCulledLayerCount() const { return culledLayerCount_; }
+    
+    // Layers the display engine shows on overlay planes (DRM backend): left
+    // out of the composite, but not marked occluded, so they keep decoding
+    void setPlaneLayers(std::vector<int> layerIds) { planeLayers_ = std::move(layerIds); }
+    const std::vector<int>& getPlaneLayers() const { return planeLayers_; }
+    
+    // Bounds of a layer's quad in viewport pixels, top row first (as shown)
+    bool getLayerBounds(const VideoLayer* layer, float& x0, float& y0, float& x1, float& y1);
+    
+    // Group images drawn again in the last composite (a member changed)
+    size_t getGroupRedrawCount() const { return groupRedrawCount_; }
+    
+    // Composites that rendered through the master FBO (master transforms that
+    // could not be folded into the layer matrices)
+    size_t getMasterFBOPassCount() const { return masterFBOPassCount_; }
+    
+    // GPU time of each layer draw, the master pass and the output passes
+    // (see GpuTimer; compositeLayers starts a timer frame unless the caller did)
+    GpuTimer& gpuTimer() { return gpuTimer_; }
+    const GpuTimer& gpuTimer() const { return gpuTimer_; }
+    
+    // Video memory in use, where the driver says (GL_NVX_gpu_memory_info);
+    // -1 otherwise
+    int64_t getVideoMemoryUsed() const;
+    int64_t getVideoMemoryTotal() const;
+    
+    // Render upside down, for targets stored top-down (DRM scanout buffers)
+    void setFlipY(bool flip) { flipY_ = flip; }
+    bool getFlipY() const { return flipY_; }
+    
+    // Draw consecutive plain layers (no color correction, no corner deform,
+    // normal blending, single-plane texture) with one instanced draw call;
+    // layers that do not overlap are reordered to make such runs longer
+    void setLayerBatching(bool enabled) { layerBatchingEnabled_ = enabled; }
+    bool getLayerBatching() const { return layerBatchingEnabled_; }
+    
+    // Interlaced sources: draw the field each output frame is due (field
+    // rate), bob or adaptive, unless VAAPI VPP already deinterlaced them
+    void setDeinterlaceMode(FieldSelector::Mode mode) { deinterlaceMode_ = mode; }
+    FieldSelector::Mode getDeinterlaceMode() const { return deinterlaceMode_; }
+    
     // Master properties access
     MasterProperties& masterProperties() { return masterProperties_; }
     const MasterProperties& masterProperties() const { return masterProperties_; }
 
-    // Set viewport
+    // Set viewport (x, y may be negative: a target showing part of a larger canvas)
     void setViewport(int x, int y, int width, int height);
 
-    // Update texture when video source changes
-    void updateTexture(int width, int height);
-
     // Set letterbox mode
     void setLetterbox(bool enabled) { letterbox_ = enabled; }
     bool getLetterbox() const { return letterbox_; }
 
     // Render OSD items
-    void renderOSDItems(const std::vector<struct OSDRenderItem>& items);
+    void renderOSDItems(const ArenaVector<struct OSDRenderItem>& items);
     
     // Cleanup deferred texture deletions (call after swapBuffers)
     void cleanupDeferredTextures();
+    
+#ifdef HAVE_EGL
+    /**
+     * Upload CPU-decoded frames on a dedicated thread (see TextureUploader)
+     * @param display EGL display of this renderer's context
+     * @param context This renderer's EGL context (textures are shared with it)
+     * @return true if the upload thread is running
+     */
+    bool enableUploadThread(EGLDisplay display, EGLContext context);
+#endif
+    bool isUploadThreadEnabled() const;
+    
+    // True if planar YUV CPU frames can be converted in a shader
+    bool supportsPlanarYUV() const { return shaderCache_ != nullptr; }
 
 private:
     // OpenGL state
-    unsigned int textureId_;        // For GL_TEXTURE_RECTANGLE_ARB (regular textures)
-    int textureWidth_;
-    int textureHeight_;
+    int viewportX_;
+    int viewportY_;
     int viewportWidth_;
     int viewportHeight_;
     bool letterbox_;
     bool initialized_;
-    bool isCoreProfile_;  // True if OpenGL Core Profile (DRM/EGL mode)
+    bool hasBufferStorage_;  // Persistent mapped buffers (GL 4.4 / ARB_buffer_storage)
+    bool hasMemoryInfo_;     // GL_NVX_gpu_memory_info
+    bool hasCopyImage_;      // glCopyImageSubData (GL 4.3 / ARB_copy_image)
+    AdvancedBlend::Path blendPath_;  // Blend modes that read the destination
+    bool blendCoherent_;             // No barrier between advanced-blend draws
+    GLuint blendDestTexture_;        // COPY_BOUNDS: scratch copy of a layer's bounds
+    int blendDestWidth_;
+    int blendDestHeight_;
+    int warmupEvictorId_;    // MemoryBudget evictor of armed-layer uploads
+    std::thread::id renderThread_;
     
     // Shader-based rendering (VBO/VAO)
     GLuint quadVAO_;                // Vertex Array Object for quad
     GLuint quadVBO_;                // Vertex Buffer Object for quad
+    GLuint osdVAO_;                 // OSD boxes and glyphs (streamed)
+    GLuint osdVBO_;
+    std::vector<float> osdVertices_;  // Reused between OSD draws
+    GLStateCache glState_;          // Program, VAO and blend state set by the renderer
     
     // Shader programs
-    // All shaders include color correction with uniform branch (uColorCorrectionEnabled).
-    // We always use the shader path for consistent rendering - no switching between
-    // fixed-function and shader paths to avoid visual artifacts mid-playback.
-    // Overhead is negligible (~0.02% GPU per layer when color correction disabled).
-    std::unique_ptr<ShaderProgram> rgbaShader_;      // For CPU frames, HAP, HAP Alpha
-    std::unique_ptr<ShaderProgram> rgbaShaderHQ_;    // High-quality variant for extreme warps
-    std::unique_ptr<ShaderProgram> nv12Shader_;      // For VAAPI/CUDA NV12
-    std::unique_ptr<ShaderProgram> yuv420pShader_;   // For YUV420P fallback
-    std::unique_ptr<ShaderProgram> hapQShader_;      // For HAP Q (YCoCg→RGB)
-    std::unique_ptr<ShaderProgram> hapQAlphaShader_; // For HAP Q Alpha (dual texture)
+    // Layer programs are specialized per feature set (see VideoShaders::Feature)
+    // and built on demand
+    std::unique_ptr<ShaderCache> shaderCache_;       // Layer programs (null = not initialized)
+    std::unique_ptr<ColorLutCache> colorLuts_;       // Baked colour adjustment tables
+    CornerWarpCache cornerWarps_;                    // Corner deform homographies
     std::unique_ptr<ShaderProgram> masterShader_;    // For master FBO post-processing
-    bool useShaders_;               // Enable shader rendering (vs fixed-function)
-    
-    // Deferred texture deletion (textures to delete after swapBuffers)
-    std::vector<GLuint> texturesToDelete_;
+    std::unique_ptr<ShaderProgram> osdShader_;       // OSD boxes and text
+    std::unique_ptr<ShaderProgram> effectBlurShader_;  // Effect filter passes (null = no blur/sharpen)
+    std::unique_ptr<EffectTargetPool> effectTargets_;  // Their intermediates, shared by layers
     
     // Cached textures per layer (layerId -> texture info)
     struct LayerTextureCache {
-        GLuint textureId;
-        int width;
-        int height;
+        GLuint textureId = 0;
+        int width = 0;
+        int height = 0;
+        int levels = 1;         // Mipmap levels (pooled texture storage)
+        int layerId = -1;       // Budget account of the texture and PBOs
+        bool warmup = false;    // Uploaded for an armed layer (evictable)
         // PBO double-buffering for async texture upload
-        GLuint pbo[2];          // Double-buffered PBOs
-        int pboIndex;           // Current PBO index (0 or 1)
-        bool pboInitialized;    // PBOs have been created
+        GLuint pbo[2] = {0, 0}; // Double-buffered PBOs
+        size_t pboSize = 0;     // Bytes per PBO (pooled)
+        int pboIndex = 0;       // Current PBO index (0 or 1)
+        bool pboInitialized = false;  // PBOs have been created
+        // Zero-copy decode: persistently mapped PBOs the layer decodes into
+        std::shared_ptr<MappedFrameRing> ring;
+        GLuint ringPbo[MappedFrameRing::SLOTS] = {0, 0, 0};
+        GLsync ringFence[MappedFrameRing::SLOTS] = {nullptr, nullptr, nullptr};
+        int uploadedSlot = -1;           // Ring slot currently in the texture
+        uint64_t uploadedGeneration = 0;
+        uint64_t stillGeneration = 0;    // Layer frame generation of the still in the texture (0 = none)
+        uint64_t armedGeneration = 0;    // Layer frame generation uploaded while armed (0 = none)
     };
     std::map<int, LayerTextureCache> layerTextureCache_;
     
+    // Cached GL_TEXTURE_2D of a layer, (re)taken from the texture pool at this size;
+    // textureId 0 (not cached) when the memory budget refuses it. Warmup
+    // textures (armed layers) are evictable until the layer draws them
+    LayerTextureCache& layerTexture(int layerId, int width, int height, int levels = 1, bool warmup = false);
+    LayerTextureCache noTexture_;
+    void releaseLayerTexture(LayerTextureCache& cache);
+    
+    // Memory budget: drop armed-layer uploads (render thread only)
+    size_t evictArmedUploads(size_t bytes);
+    
+    // Layer texture holds the layer's current frame from prepareArmedLayers()
+    bool hasArmedUpload(const VideoLayer* layer) const;
+    
     // PBO helper methods
     bool initLayerPBOs(LayerTextureCache& cache, int width, int height);
     void cleanupLayerPBOs(LayerTextureCache& cache);
     
+    // Zero-copy decode ring helpers
+    bool attachFrameRing(LayerTextureCache& cache, const std::shared_ptr<MappedFrameRing>& ring,
+                         const FrameInfo& info);
+    void uploadFromFrameRing(LayerTextureCache& cache, int slot);
+    void pollFrameRingFences(LayerTextureCache& cache);
+    void releaseFrameRing(LayerTextureCache& cache);
+    void releaseOrphanedFrameRings();
+    
+    // Planar YUV CPU frames: per-layer plane textures, converted in the shader
+    std::map<int, GPUTextureFrameBuffer> planarTextures_;
+    std::map<int, uint64_t> planarArmedGenerations_;  // Planes uploaded while armed
+    bool uploadPlanarFrame(int layerId, const FrameBuffer& frame);
+    static TexturePlaneType planarTextureType(PixelFormat format);
+    
+    // Loop cache frames: copies of GPU frames, uploads of CPU ones (BC1
+    // compressed where the cache asks for it); nullptr or why not
+    std::unique_ptr<BC1Encoder> bc1Encoder_;   // Created on first use
+    bool bc1Failed_;
+    bool cacheLoopFrame(const VideoLayer* layer, LoopFrameCache& cache);
+    const char* copyLoopFrame(const GPUTextureFrameBuffer& source, bool compress, GPUTextureFrameBuffer& frame);
+    const char* uploadLoopFrame(const FrameBuffer& source, bool compress, GPUTextureFrameBuffer& frame);
+    BC1Encoder* bc1Encoder();
+    bool renderPlanarFrame(int layerId, const FrameBuffer& frame, const LayerProperties& props,
+                           const FrameInfo& frameInfo, uint64_t generation);
+    void setYuvUniforms(ShaderProgram* shader, const FrameInfo& info, bool tenBit, bool msbAligned = false);
+    
+    // Giant stills (TiledImage): the tiles on screen, uploaded into a fixed
+    // atlas per layer from the tile cache mapping and drawn one quad each
+    struct TiledLayerTexture {
+        std::shared_ptr<TiledImage> image;
+        GLuint textureId = 0;
+        int width = 0;           // Atlas texels
+        int height = 0;
+        int columns = 1;         // Tile slots per atlas row
+        TileResidency residency;
+        uint64_t stamp = 0;      // Draws so far: tiles used by this one stay
+    };
+    static constexpr int MAX_TILE_UPLOADS = 8;  // Per layer and draw
+    std::map<int, TiledLayerTexture> tiledTextures_;
+    std::vector<TilePyramid::Tile> tiledSelection_;  // Reused per draw
+    std::vector<uint32_t> tiledWanted_;
+    std::vector<float> tiledVertices_;
+    TiledLayerTexture* tiledTexture(int layerId, const std::shared_ptr<TiledImage>& image);
+    void uploadTile(TiledLayerTexture& cache, uint32_t tile, int slot);
+    void releaseTiledTexture(TiledLayerTexture& cache);
+    void releaseOrphanedTiledTextures();
+    bool renderTiledImage(int layerId, const std::shared_ptr<TiledImage>& image, const LayerProperties& props,
+                          float quad_x, float quad_y);
+    
+    // Upload thread for CPU frames (nullptr = upload on the render thread)
+    std::unique_ptr<TextureUploader> uploader_;
+    std::vector<int> uploadLayerIds_;  // Layers submitted this frame (reused)
+    void submitUploads(const std::vector<const VideoLayer*>& layers);
+    
+    // Occlusion culling
+    size_t culledLayerCount_;
+    CanvasRegions visibleRegions_;      // Target pixels shown (see setVisibleRegions)
+    bool coversViewportOpaque(const VideoLayer* layer);
+    bool missesVisibleRegions(const VideoLayer* layer);
+    size_t firstUnoccludedLayer(const std::vector<const VideoLayer*>& layers);
+    
+    // Layer batching: plain layers are queued while compositeLayers runs and
+    // drawn together when a layer that needs its own draw (or the end) comes
+    struct BatchedLayer {
+        GLuint textureId;
+        float mvp[16];
+        float opacity;
+    };
+    bool layerBatchingEnabled_;
+    bool batchOpen_;                    // Queueing allowed (inside compositeLayers)
+    std::vector<BatchedLayer> batch_;
+    GLuint batchUBO_;                   // Per-instance data (VideoShaders::LayerInstances)
+    GLuint batchProgramId_;             // Batch program whose samplers are set up
+    bool canBatch(const LayerProperties& props) const;
+    
+    // Field of the layer being drawn (set by renderLayer, whole frames otherwise)
+    struct LayerField {
+        int parity = -1;        // Lines shown, see FieldSelector::parity (-1 = whole frame)
+        int phase = 0;          // First or second field in time
+        bool adaptive = false;
+    };
+    FieldSelector::Mode deinterlaceMode_;
+    LayerField layerField_;
+    void setFieldUniforms(ShaderProgram* shader);
+    void queueBatchedLayer(GLuint textureId, float quad_x, float quad_y, const LayerProperties& props);
+    void flushLayerBatch();
+    
+    // Draw order within z-order constraints: disjoint layers of the same
+    // state move together (see DrawOrder), so batches run longer and
+    // program/blend switches drop
+    std::vector<DrawOrder::Item> drawItems_;
+    std::vector<size_t> drawOrder_;
+    std::vector<const VideoLayer*> orderedLayers_;
+    void groupDrawnByState(std::vector<const VideoLayer*>& layers);
+    
+    // Layer groups: each group's members are drawn into an image of the
+    // viewport size, kept until a member changes
+    struct GroupMember {
+        const VideoLayer* layer = nullptr;
+        int layerId = -1;
+        bool ready = false;
+        uint64_t generation = 0;
+        LayerProperties properties;
+    };
+    struct GroupCache {
+        GPUTextureFrameBuffer image;        // RGBA, pooled
+        GLuint fbo = 0;
+        bool valid = false;                 // Image holds `members`
+        bool drawable = false;              // Drawn in the current composite
+        bool seen = false;
+        std::vector<GroupMember> members;   // As last drawn into the image
+    };
+    std::map<int, GroupCache> groupCaches_;
+    std::vector<const VideoLayer*> ungroupedLayers_;
+    std::vector<const VideoLayer*> groupMembers_;
+    std::vector<std::pair<size_t, const LayerGroup*>> groupDraws_;  // (drawn index to draw before, group)
+    std::vector<const VideoLayer*> drawnLayers_;  // Unoccluded layers of this frame (reused)
+    std::vector<int> planeLayers_;      // See setPlaneLayers
+    std::vector<const VideoLayer*> planeDrawn_;   // Of this frame (reused)
+    std::vector<size_t> drawnBefore_;   // Drawn layers below each top-level position (reused)
+    size_t groupRedrawCount_;
+    void renderGroups(const std::vector<const VideoLayer*>& layers, const std::vector<LayerGroup>& groups);
+    bool updateGroupMembers(GroupCache& cache, const std::vector<const VideoLayer*>& members);
+    bool redrawGroupImage(GroupCache& cache, const std::vector<const VideoLayer*>& members);
+    void drawGroupImage(GroupCache& cache, const LayerGroup& group);
+    void releaseGroupCache(GroupCache& cache);
+    
     // Master layer properties (for composite output)
     MasterProperties masterProperties_;
     
+    // Affine master transforms folded into each layer's MVP (no FBO pass)
+    bool masterFolded_;                 // Set while compositing with a folded master
+    float masterMatrix_[16];            // Master translate * scale * rotate
+    float masterOpacity_;               // Multiplies layer opacity (1.0 unless folded)
+    bool flipY_;
+    bool flipLayers_;                   // Set while layers draw to a flipped target
+    bool layerCorners(const VideoLayer* layer, float corner[4][2]);
+    void updateDisplaySizes(const std::vector<const VideoLayer*>& layers);  // VideoLayer::setDisplaySize
+    bool canFoldMaster(const std::vector<const VideoLayer*>& layers);
+    void buildMasterMatrix();
+    
     // FBO for off-screen rendering (used when master transforms are active)
     GLuint masterFBO_;              // Framebuffer Object
     GLuint masterFBOTexture_;       // Texture attached to FBO
     int masterFBOWidth_;            // FBO texture width
     int masterFBOHeight_;           // FBO texture height
     bool masterFBOInitialized_;     // FBO is ready to use
+    size_t masterFBOPassCount_;     // Composites that needed the FBO pass
+    
+    GpuTimer gpuTimer_;             // Timestamp queries around the passes
 
     // Internal methods
-    void setupOrthoProjection();
-    void renderQuad(float x, float y, float width, float height);
-    void renderQuadWithCrop(float x, float y, float width, float height,
-                           float texX, float texY, float texWidth, float texHeight);
-    void applyLayerTransform(const VideoLayer* layer);
-    void applyLayerTransform(const VideoLayer* layer, float quad_x, float quad_y);
-    void applyLayerTransformFromProps(const LayerProperties& props, float quad_x, float quad_y);
     void applyBlendMode(const VideoLayer* layer);
     void applyBlendModeFromProps(const LayerProperties& props);
-    bool uploadFrameToTexture(const FrameBuffer& frame);
+    // Blend state and destination of a FEATURE_ADVANCED_BLEND draw (the
+    // program in use, mvp/homography as set on it); endAdvancedBlend() after it
+    void beginAdvancedBlend(ShaderProgram* shader, uint32_t features, const LayerProperties& props,
+                            const float* mvp, const float* homography);
+    void endAdvancedBlend(uint32_t features);
+    // Sets a layer program's texture and source uniforms (and uses it); the
+    // effect filter draws the layer's source through a reduced program with it
+    using SourceUniforms = std::function<void(ShaderProgram* program, uint32_t features)>;
+    // Blur/sharpen passes of a layer (textures bound as for its draw): the
+    // filtered source, to release to effectTargets_ after the draw, or null
+    const EffectTargetPool::Target* renderEffectFilter(const EffectChain::Plan& plan, ShaderKind kind,
+                                                       uint32_t features, const SourceUniforms& setSource);
+    void setEffectUniforms(ShaderProgram* shader, const LayerProperties::Effects& effects,
+                           const EffectChain::Plan& plan, const EffectTargetPool::Target* filtered);
+    void endPass();   // Unbind program and VAO for whoever draws next
     bool bindGPUTexture(const GPUTextureFrameBuffer& gpuFrame);
     void calculateCropCoordinates(const VideoLayer* layer, float& texX, float& texY, 
                                   float& texWidth, float& texHeight);
@@ -147,6 +436,16 @@ private:
     // Shader helpers
     bool initShaders();
     void cleanupShaders();
+    // Smallest program for a layer: the kind plus the features its properties use
+    // (features is set to those actually compiled in). quad_x/quad_y size the
+    // corner deform, whose severity decides if high-quality sampling is worth it.
+    ShaderProgram* layerShader(ShaderKind kind, const LayerProperties& props, uint32_t& features,
+                               float quad_x, float quad_y);
+    // Aspect ratio the layer is letterboxed with (one picture of a packed-alpha frame)
+    float layerAspect(const LayerProperties& props, const FrameInfo& frameInfo) const;
+    // Halves of a packed-alpha texture of width x height (insetTexels: see PackedAlpha::regions)
+    void setPackedAlphaUniforms(ShaderProgram* shader, const LayerProperties& props, int width, int height,
+                                float insetTexels);
     void computeMVPMatrix(float* mvp, float x, float y, float width, float height,
                          const LayerProperties& props);
     void renderQuadWithShader(ShaderProgram* shader, float x, float y, 
@@ -3,6 +3,7 @@
  */
 
 #include "OutputBlitShader.h"
+#include "ShaderProgram.h"
 #include "../utils/Logger.h"
 
 #include <GL/glew.h>
@@ -11,94 +12,102 @@
 
 namespace videocomposer {
 
-// Vertex shader - simple fullscreen quad
+// Vertex shader - fullscreen quad or warp mesh
 const char* OutputBlitShader::getVertexShaderSource() {
     return R"(
 #version 330 core
 
 layout(location = 0) in vec2 aPosition;
-layout(location = 1) in vec2 aTexCoord;
+layout(location = 1) in vec2 aTexCoord;  // Source position in the region (warp mesh UV)
 
-out vec2 vTexCoord;
+out vec2 vOutputPos;             // 0-1 across output
+out vec2 vSourcePos;
 
 void main() {
     gl_Position = vec4(aPosition, 0.0, 1.0);
-    vTexCoord = aTexCoord;
+    vOutputPos = aPosition * 0.5 + 0.5;
+    vSourcePos = aTexCoord;
 }
 )";
 }
 
-// Fragment shader with edge blending and warp support
+// Fragment shader: blend and warp come baked, one fetch each
 const char* OutputBlitShader::getFragmentShaderSource() {
     return R"(
 #version 330 core
 
 uniform sampler2D uCanvasTex;
-uniform vec2 uCanvasSize;        // Canvas dimensions in pixels
-uniform vec4 uSourceRect;        // x, y, width, height in canvas pixels
-uniform vec2 uOutputSize;        // Output dimensions in pixels
-uniform vec4 uBlendWidths;       // left, right, top, bottom blend widths in pixels
-uniform float uBlendGamma;       // Gamma for perceptual blending (typically 2.2)
-uniform int uWarpEnabled;        // 0 = disabled, 1 = enabled
-uniform sampler2D uWarpTex;      // Warp displacement texture
-
-in vec2 vTexCoord;               // 0-1 across output
+uniform vec4 uSourceRect;        // x, y, width, height in canvas texture coordinates
+uniform int uMaskEnabled;        // 0 = no edge blending
+uniform sampler2D uMaskTex;      // Blend weight per output pixel
+uniform int uWarpEnabled;        // 0 = no warp
+uniform sampler2D uLookupTex;    // Canvas texture coordinate per output position
+uniform int uUpscale;            // 0 = the canvas is composited at full size
+uniform vec2 uContentScale;      // Composited part of the canvas texture
+uniform vec2 uCanvasSize;        // Canvas texture size in texels
+
+in vec2 vOutputPos;              // 0-1 across output
+in vec2 vSourcePos;              // 0-1 across the region, warped by a mesh
 out vec4 fragColor;
 
+// Catmull-Rom from 9 bilinear fetches, kept inside the composited part
+vec3 sampleUpscaled(vec2 texCoord) {
+    vec2 lo = 0.5 / uCanvasSize;
+    vec2 hi = uContentScale - lo;
+    vec2 samplePos = texCoord * uCanvasSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+    vec2 p0 = clamp((texPos1 - 1.0) / uCanvasSize, lo, hi);
+    vec2 p12 = clamp((texPos1 + w2 / w12) / uCanvasSize, lo, hi);
+    vec2 p3 = clamp((texPos1 + 2.0) / uCanvasSize, lo, hi);
+    vec3 color =
+        (texture(uCanvasTex, vec2(p0.x, p0.y)).rgb * w0.x +
+         texture(uCanvasTex, vec2(p12.x, p0.y)).rgb * w12.x +
+         texture(uCanvasTex, vec2(p3.x, p0.y)).rgb * w3.x) * w0.y +
+        (texture(uCanvasTex, vec2(p0.x, p12.y)).rgb * w0.x +
+         texture(uCanvasTex, vec2(p12.x, p12.y)).rgb * w12.x +
+         texture(uCanvasTex, vec2(p3.x, p12.y)).rgb * w3.x) * w12.y +
+        (texture(uCanvasTex, vec2(p0.x, p3.y)).rgb * w0.x +
+         texture(uCanvasTex, vec2(p12.x, p3.y)).rgb * w12.x +
+         texture(uCanvasTex, vec2(p3.x, p3.y)).rgb * w3.x) * w3.y;
+    return clamp(color, 0.0, 1.0);
+}
+
 void main() {
-    vec2 outputPos = vTexCoord;
-    
-    // Apply warp displacement if enabled
-    if (uWarpEnabled != 0) {
-        // Warp texture stores displacement as RG values (0.5 = no displacement)
-        vec2 warpOffset = texture(uWarpTex, vTexCoord).xy * 2.0 - 1.0;
-        // Scale displacement (adjust 0.1 for warp strength)
-        outputPos += warpOffset * 0.1;
-        // Clamp to valid range
-        outputPos = clamp(outputPos, vec2(0.0), vec2(1.0));
-    }
-    
-    // Map output position to canvas coordinates
-    vec2 canvasCoord = uSourceRect.xy + outputPos * uSourceRect.zw;
-    
-    // Normalize to texture coordinates (0-1)
-    vec2 texCoord = canvasCoord / uCanvasSize;
-    
-    // Sample canvas texture
-    vec4 color = texture(uCanvasTex, texCoord);
-    
-    // Calculate edge blending alpha
-    float alpha = 1.0;
-    vec2 pixelPos = vTexCoord * uOutputSize;
-    
-    // Left edge blend
-    if (uBlendWidths.x > 0.0 && pixelPos.x < uBlendWidths.x) {
-        alpha *= smoothstep(0.0, uBlendWidths.x, pixelPos.x);
-    }
-    
-    // Right edge blend
-    if (uBlendWidths.y > 0.0 && pixelPos.x > (uOutputSize.x - uBlendWidths.y)) {
-        alpha *= smoothstep(0.0, uBlendWidths.y, uOutputSize.x - pixelPos.x);
-    }
-    
-    // Top edge blend
-    if (uBlendWidths.z > 0.0 && pixelPos.y < uBlendWidths.z) {
-        alpha *= smoothstep(0.0, uBlendWidths.z, pixelPos.y);
-    }
-    
-    // Bottom edge blend
-    if (uBlendWidths.w > 0.0 && pixelPos.y > (uOutputSize.y - uBlendWidths.w)) {
-        alpha *= smoothstep(0.0, uBlendWidths.w, uOutputSize.y - pixelPos.y);
-    }
-    
-    // Apply gamma correction for perceptual blending
-    // This ensures the overlap region appears correctly bright
-    if (alpha < 1.0) {
-        alpha = pow(alpha, uBlendGamma);
-    }
-    
-    // Output with blending applied
-    fragColor = vec4(color.rgb * alpha, 1.0);
+    vec2 texCoord = uWarpEnabled != 0
+        ? texture(uLookupTex, vOutputPos).xy
+        : uSourceRect.xy + vSourcePos * uSourceRect.zw;
+    vec3 color = uUpscale != 0
+        ? sampleUpscaled(texCoord * uContentScale)
+        : texture(uCanvasTex, texCoord).rgb;
+    float alpha = uMaskEnabled != 0 ? texture(uMaskTex, vOutputPos).r : 1.0;
+    fragColor = vec4(color * alpha, 1.0);
+}
+)";
+}
+
+// Warp bake: output position to canvas texture coordinate, once per calibration
+const char* OutputBlitShader::getBakeShaderSource() {
+    return R"(
+#version 330 core
+
+uniform sampler2D uWarpTex;      // Displacement as RG (0.5 = none)
+uniform vec4 uSourceRect;        // x, y, width, height in canvas texture coordinates
+
+in vec2 vOutputPos;
+in vec2 vSourcePos;
+out vec4 fragColor;
+
+void main() {
+    vec2 warpOffset = texture(uWarpTex, vOutputPos).xy * 2.0 - 1.0;
+    // Scale displacement (0.1 = warp strength), clamp to the region
+    vec2 outputPos = clamp(vOutputPos + warpOffset * 0.1, vec2(0.0), vec2(1.0));
+    fragColor = vec4(uSourceRect.xy + outputPos * uSourceRect.zw, 0.0, 1.0);
 }
 )";
 }
@@ -131,13 +140,16 @@ bool OutputBlitShader::init() {
     
     // Get uniform locations
     uCanvasTex_ = glGetUniformLocation(program_, "uCanvasTex");
-    uCanvasSize_ = glGetUniformLocation(program_, "uCanvasSize");
     uSourceRect_ = glGetUniformLocation(program_, "uSourceRect");
-    uOutputSize_ = glGetUniformLocation(program_, "uOutputSize");
-    uBlendWidths_ = glGetUniformLocation(program_, "uBlendWidths");
-    uBlendGamma_ = glGetUniformLocation(program_, "uBlendGamma");
+    uMaskEnabled_ = glGetUniformLocation(program_, "uMaskEnabled");
+    uMaskTex_ = glGetUniformLocation(program_, "uMaskTex");
     uWarpEnabled_ = glGetUniformLocation(program_, "uWarpEnabled");
-    uWarpTex_ = glGetUniformLocation(program_, "uWarpTex");
+    uLookupTex_ = glGetUniformLocation(program_, "uLookupTex");
+    uUpscale_ = glGetUniformLocation(program_, "uUpscale");
+    uContentScale_ = glGetUniformLocation(program_, "uContentScale");
+    uCanvasSize_ = glGetUniformLocation(program_, "uCanvasSize");
+    uBakeWarpTex_ = glGetUniformLocation(bakeProgram_, "uWarpTex");
+    uBakeSourceRect_ = glGetUniformLocation(bakeProgram_, "uSourceRect");
     
     initialized_ = true;
     LOG_INFO << "OutputBlitShader: Initialized";
@@ -146,6 +158,13 @@ bool OutputBlitShader::init() {
 }
 
 void OutputBlitShader::cleanup() {
+    invalidateMaps();
+    
+    if (bakeFbo_ != 0) {
+        glDeleteFramebuffers(1, &bakeFbo_);
+        bakeFbo_ = 0;
+    }
+    
     if (vao_ != 0) {
         glDeleteVertexArrays(1, &vao_);
         vao_ = 0;
@@ -161,14 +180,9 @@ void OutputBlitShader::cleanup() {
         program_ = 0;
     }
     
-    if (vertexShader_ != 0) {
-        glDeleteShader(vertexShader_);
-        vertexShader_ = 0;
-    }
-    
-    if (fragmentShader_ != 0) {
-        glDeleteShader(fragmentShader_);
-        fragmentShader_ = 0;
+    if (bakeProgram_ != 0) {
+        glDeleteProgram(bakeProgram_);
+        bakeProgram_ = 0;
     }
     
     initialized_ = false;
@@ -176,68 +190,341 @@ void OutputBlitShader::cleanup() {
 
 void OutputBlitShader::blit(GLuint canvasTexture,
                             int canvasWidth, int canvasHeight,
-                            const OutputRegion& region) {
+                            const OutputRegion& region,
+                            int contentWidth, int contentHeight) {
     if (!initialized_) {
         LOG_ERROR << "OutputBlitShader: Not initialized";
         return;
     }
     
-    // Use our shader program
-    glUseProgram(program_);
-    
-    // Set uniforms
-    glUniform2f(uCanvasSize_, 
-                static_cast<float>(canvasWidth), 
-                static_cast<float>(canvasHeight));
-    
-    glUniform4f(uSourceRect_,
-                static_cast<float>(region.canvasX),
-                static_cast<float>(region.canvasY),
-                static_cast<float>(region.canvasWidth),
-                static_cast<float>(region.canvasHeight));
-    
-    glUniform2f(uOutputSize_,
-                static_cast<float>(region.physicalWidth),
-                static_cast<float>(region.physicalHeight));
+    // Region in canvas texture coordinates
+    float sourceRect[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    if (canvasWidth > 0 && canvasHeight > 0) {
+        sourceRect[0] = static_cast<float>(region.canvasX) / canvasWidth;
+        sourceRect[1] = static_cast<float>(region.canvasY) / canvasHeight;
+        sourceRect[2] = static_cast<float>(region.canvasWidth) / canvasWidth;
+        sourceRect[3] = static_cast<float>(region.canvasHeight) / canvasHeight;
+    }
     
-    // Blend configuration
-    glUniform4f(uBlendWidths_,
-                region.blend.left,
-                region.blend.right,
-                region.blend.top,
-                region.blend.bottom);
+    // Blend mask and warp lookup: baked on the first blit after a change
+    GLuint maskTexture = 0;
+    GLuint lookupTexture = 0;
+    GLuint vao = vao_;
+    GLsizei meshIndices = 0;
+    if (region.hasBlending() || region.hasWarping()) {
+        const OutputMaps& maps = prepareMaps(region, sourceRect);
+        maskTexture = maps.maskTexture;
+        lookupTexture = maps.lookupTexture;
+        if (maps.meshVao != 0) {
+            vao = maps.meshVao;
+            meshIndices = maps.meshIndices;
+        }
+    }
     
-    glUniform1f(uBlendGamma_, region.blend.gamma);
+    // Use our shader program
+    glUseProgram(program_);
     
-    // Warp configuration
-    bool hasWarp = region.hasWarping();
-    glUniform1i(uWarpEnabled_, hasWarp ? 1 : 0);
+    glUniform4fv(uSourceRect_, 1, sourceRect);
+    glUniform1i(uMaskEnabled_, maskTexture != 0 ? 1 : 0);
+    glUniform1i(uWarpEnabled_, lookupTexture != 0 ? 1 : 0);
+    
+    // Composited smaller than the canvas: the maps stay in full canvas
+    // coordinates, the shader scales them into the composited part
+    bool upscale = canvasWidth > 0 && canvasHeight > 0 && contentWidth > 0 && contentHeight > 0 &&
+                   (contentWidth < canvasWidth || contentHeight < canvasHeight);
+    glUniform1i(uUpscale_, upscale ? 1 : 0);
+    if (upscale) {
+        glUniform2f(uContentScale_, static_cast<float>(contentWidth) / canvasWidth,
+                    static_cast<float>(contentHeight) / canvasHeight);
+        glUniform2f(uCanvasSize_, static_cast<float>(canvasWidth), static_cast<float>(canvasHeight));
+    }
     
     // Bind canvas texture to unit 0
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, canvasTexture);
     glUniform1i(uCanvasTex_, 0);
     
-    // Bind warp texture to unit 1 if enabled
-    if (hasWarp && region.warpMesh) {
+    // Baked maps on units 1 and 2
+    if (maskTexture != 0) {
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, region.warpMesh->getTexture());
-        glUniform1i(uWarpTex_, 1);
+        glBindTexture(GL_TEXTURE_2D, maskTexture);
+        glUniform1i(uMaskTex_, 1);
+    }
+    if (lookupTexture != 0) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, lookupTexture);
+        glUniform1i(uLookupTex_, 2);
     }
     
-    // Draw fullscreen quad
-    glBindVertexArray(vao_);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    // Draw the warp mesh, or the fullscreen quad
+    glBindVertexArray(vao);
+    if (meshIndices > 0) {
+        glDrawElements(GL_TRIANGLES, meshIndices, GL_UNSIGNED_INT, nullptr);
+    } else {
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
     glBindVertexArray(0);
     
     // Cleanup
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (lookupTexture != 0) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (maskTexture != 0) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, 0);
     glUseProgram(0);
 }
 
+void OutputBlitShader::invalidateMaps() {
+    for (auto& entry : maps_) {
+        releaseMaps(entry.second);
+    }
+    maps_.clear();
+}
+
+void OutputBlitShader::releaseMaps(OutputMaps& maps) {
+    if (maps.maskTexture != 0) {
+        glDeleteTextures(1, &maps.maskTexture);
+        maps.maskTexture = 0;
+    }
+    if (maps.lookupTexture != 0) {
+        glDeleteTextures(1, &maps.lookupTexture);
+        maps.lookupTexture = 0;
+    }
+    releaseMesh(maps);
+}
+
+void OutputBlitShader::releaseMesh(OutputMaps& maps) {
+    if (maps.meshVao != 0) {
+        glDeleteVertexArrays(1, &maps.meshVao);
+        maps.meshVao = 0;
+    }
+    if (maps.meshBuffers[0] != 0) {
+        glDeleteBuffers(2, maps.meshBuffers);
+        maps.meshBuffers[0] = maps.meshBuffers[1] = 0;
+    }
+    maps.meshIndices = 0;
+}
+
+const OutputBlitShader::OutputMaps& OutputBlitShader::prepareMaps(const OutputRegion& region,
+                                                                    const float sourceRect[4]) {
+    OutputMaps& maps = maps_[region.name];
+    GLuint warpTexture = region.warpMesh ? region.warpMesh->getTexture() : 0;
+    
+    // Only what changed is rebaked, into the textures already there when
+    // their size holds (calibration tweaks one edge or point at a time)
+    bool sizeChanged = !maps.baked ||
+                       maps.width != region.physicalWidth ||
+                       maps.height != region.physicalHeight;
+    bool blendChanged = sizeChanged ||
+                        maps.blend.left != region.blend.left ||
+                        maps.blend.right != region.blend.right ||
+                        maps.blend.top != region.blend.top ||
+                        maps.blend.bottom != region.blend.bottom ||
+                        maps.blend.gamma != region.blend.gamma;
+    unsigned int warpRevision = region.warpMesh ? region.warpMesh->revision() : 0;
+    bool warpChanged = sizeChanged ||
+                       maps.warpMesh != region.warpMesh.get() ||
+                       maps.warpTexture != warpTexture ||
+                       maps.warpRevision != warpRevision ||
+                       !std::equal(sourceRect, sourceRect + 4, maps.sourceRect);
+    if (!blendChanged && !warpChanged) {
+        return maps;
+    }
+    
+    maps.baked = true;
+    maps.blend = region.blend;
+    maps.width = region.physicalWidth;
+    maps.height = region.physicalHeight;
+    maps.warpMesh = region.warpMesh.get();
+    maps.warpTexture = warpTexture;
+    maps.warpRevision = warpRevision;
+    std::copy(sourceRect, sourceRect + 4, maps.sourceRect);
+    
+    if (blendChanged) {
+        if (maps.maskTexture != 0 && (sizeChanged || !region.hasBlending())) {
+            glDeleteTextures(1, &maps.maskTexture);
+            maps.maskTexture = 0;
+        }
+        if (region.hasBlending() && !bakeMask(maps)) {
+            LOG_WARNING << "OutputBlitShader: Blend mask for " << region.name << " not baked";
+        }
+    }
+    if (warpChanged) {
+        // A mesh replaces the displacement lookup when the warp has one
+        bool baked = region.warpMesh && bakeMesh(maps, *region.warpMesh);
+        if (!baked) {
+            releaseMesh(maps);
+        }
+        if (!baked && region.warpMesh && warpTexture != 0) {
+            baked = bakeLookup(maps, region);
+            if (!baked) {
+                LOG_WARNING << "OutputBlitShader: Warp lookup for " << region.name << " not baked";
+            }
+        } else if (maps.lookupTexture != 0) {
+            glDeleteTextures(1, &maps.lookupTexture);
+            maps.lookupTexture = 0;
+        }
+    }
+    
+    LOG_VERBOSE << "OutputBlitShader: Baked maps for " << region.name << " ("
+                << maps.width << "x" << maps.height
+                << (maps.maskTexture != 0 ? ", blend" : "")
+                << (maps.lookupTexture != 0 ? ", warp" : "")
+                << (maps.meshIndices > 0 ? ", mesh of " + std::to_string(maps.meshIndices / 3) +
+                                           " triangles" : "") << ")";
+    return maps;
+}
+
+bool OutputBlitShader::bakeMask(OutputMaps& maps) {
+    if (maps.width <= 0 || maps.height <= 0) {
+        return false;
+    }
+    
+    std::vector<uint16_t> mask;
+    buildBlendMask(maps.blend, maps.width, maps.height, mask);
+    
+    GLint previousAlignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    
+    if (maps.maskTexture != 0) {
+        // Same output size: new weights into the mask already there
+        glBindTexture(GL_TEXTURE_2D, maps.maskTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, maps.width, maps.height,
+                        GL_RED, GL_UNSIGNED_SHORT, mask.data());
+    } else {
+        glGenTextures(1, &maps.maskTexture);
+        glBindTexture(GL_TEXTURE_2D, maps.maskTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, maps.width, maps.height, 0,
+                     GL_RED, GL_UNSIGNED_SHORT, mask.data());
+        // One texel per output pixel
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    return true;
+}
+
+bool OutputBlitShader::bakeMesh(OutputMaps& maps, const WarpMesh& warpMesh) {
+    std::vector<WarpVertex> vertices;
+    std::vector<uint32_t> indices;
+    if (!warpMesh.buildMesh(maps.width, maps.height, vertices, indices) || indices.empty()) {
+        return false;
+    }
+    
+    // Same layout as the quad: position in NDC, then the region UV
+    std::vector<float> data;
+    data.reserve(vertices.size() * 4);
+    for (const WarpVertex& vertex : vertices) {
+        data.push_back(vertex.x * 2.0f - 1.0f);
+        data.push_back(vertex.y * 2.0f - 1.0f);
+        data.push_back(vertex.u);
+        data.push_back(vertex.v);
+    }
+    
+    // A rebuilt mesh goes into the buffers of the previous one
+    if (maps.meshVao == 0) {
+        glGenVertexArrays(1, &maps.meshVao);
+        glGenBuffers(2, maps.meshBuffers);
+    }
+    glBindVertexArray(maps.meshVao);
+    glBindBuffer(GL_ARRAY_BUFFER, maps.meshBuffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, maps.meshBuffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    
+    maps.meshIndices = static_cast<GLsizei>(indices.size());
+    return true;
+}
+
+bool OutputBlitShader::bakeLookup(OutputMaps& maps, const OutputRegion& region) {
+    if (bakeProgram_ == 0) {
+        return false;
+    }
+    
+    // Lookup at the displacement's resolution: filtering it matches
+    // filtering the displacement, except where the clamp kicks in
+    int width = 0, height = 0;
+    region.warpMesh->getDimensions(width, height);
+    if (width <= 0 || height <= 0) {
+        width = maps.width;
+        height = maps.height;
+    }
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    
+    // The bake overwrites every texel: a lookup of the same size is reused
+    if (maps.lookupTexture != 0 && (maps.lookupWidth != width || maps.lookupHeight != height)) {
+        glDeleteTextures(1, &maps.lookupTexture);
+        maps.lookupTexture = 0;
+    }
+    if (maps.lookupTexture == 0) {
+        glGenTextures(1, &maps.lookupTexture);
+        glBindTexture(GL_TEXTURE_2D, maps.lookupTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        maps.lookupWidth = width;
+        maps.lookupHeight = height;
+    }
+    
+    GLint previousFbo = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    if (bakeFbo_ == 0) {
+        glGenFramebuffers(1, &bakeFbo_);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, bakeFbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, maps.lookupTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status == GL_FRAMEBUFFER_COMPLETE) {
+        glViewport(0, 0, width, height);
+        glUseProgram(bakeProgram_);
+        glUniform4fv(uBakeSourceRect_, 1, maps.sourceRect);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, maps.warpTexture);
+        glUniform1i(uBakeWarpTex_, 0);
+        glBindVertexArray(vao_);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(0);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR << "OutputBlitShader: Warp bake FBO incomplete, status=" << status;
+        glDeleteTextures(1, &maps.lookupTexture);
+        maps.lookupTexture = 0;
+        return false;
+    }
+    return true;
+}
+
 void OutputBlitShader::blitSimple(GLuint canvasTexture,
                                    int canvasWidth, int canvasHeight,
                                    int srcX, int srcY, int srcWidth, int srcHeight,
@@ -258,36 +545,68 @@ void OutputBlitShader::blitSimple(GLuint canvasTexture,
 }
 
 bool OutputBlitShader::compileShaders() {
-    // Compile vertex shader
-    vertexShader_ = compileShader(GL_VERTEX_SHADER, getVertexShaderSource());
-    if (vertexShader_ == 0) {
+    program_ = linkProgram(getVertexShaderSource(), getFragmentShaderSource(), "blit");
+    if (program_ == 0) {
         return false;
     }
     
+    // Without the bake pass warped outputs fall back to the plain region
+    bakeProgram_ = linkProgram(getVertexShaderSource(), getBakeShaderSource(), "warp bake");
+    if (bakeProgram_ == 0) {
+        LOG_WARNING << "OutputBlitShader: Warp bake program unavailable, warp disabled";
+    }
+    return true;
+}
+
+GLuint OutputBlitShader::linkProgram(const char* vertexSource, const char* fragmentSource,
+                                     const char* what) {
+    // Binary from an earlier run: no compile, no link
+    GLuint program = ShaderProgram::loadProgramBinary(vertexSource, fragmentSource);
+    if (program != 0) {
+        LOG_INFO << "OutputBlitShader: Program (" << what << ") loaded from binary cache";
+        return program;
+    }
+    
+    // Compile vertex shader
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    if (vertexShader == 0) {
+        return 0;
+    }
+    
     // Compile fragment shader
-    fragmentShader_ = compileShader(GL_FRAGMENT_SHADER, getFragmentShaderSource());
-    if (fragmentShader_ == 0) {
-        return false;
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        return 0;
     }
     
     // Create program
-    program_ = glCreateProgram();
-    glAttachShader(program_, vertexShader_);
-    glAttachShader(program_, fragmentShader_);
-    glLinkProgram(program_);
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    ShaderProgram::prepareProgramBinary(program);
+    glLinkProgram(program);
+    
+    // Shaders are owned by the program once linked
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
     
     // Check link status
     GLint linkStatus;
-    glGetProgramiv(program_, GL_LINK_STATUS, &linkStatus);
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
     if (linkStatus != GL_TRUE) {
         GLchar infoLog[512];
-        glGetProgramInfoLog(program_, sizeof(infoLog), nullptr, infoLog);
-        LOG_ERROR << "OutputBlitShader: Program link failed: " << infoLog;
-        return false;
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        LOG_ERROR << "OutputBlitShader: Program (" << what << ") link failed: " << infoLog;
+        glDeleteProgram(program);
+        return 0;
     }
+    ShaderProgram::saveProgramBinary(program, vertexSource, fragmentSource);
     
-    LOG_INFO << "OutputBlitShader: Shaders compiled and linked";
-    return true;
+    LOG_INFO << "OutputBlitShader: Shaders (" << what << ") compiled and linked";
+    return program;
 }
 
 GLuint OutputBlitShader::compileShader(GLenum type, const char* source) {
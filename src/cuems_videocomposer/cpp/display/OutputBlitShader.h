@@ -7,6 +7,15 @@
  * current framebuffer (output surface) with optional:
  * - Edge blending (soft edges for projector overlap)
  * - Geometric warping (for keystone/curved surface correction)
+ *
+ * Blend curves and warp displacement are static per calibration, so both
+ * are baked per output when its OutputRegion changes: a blend mask
+ * texture and a canvas lookup map. Each blit is then one fetch of each
+ * plus a multiply. A warp with a mesh form (GridWarpMesh) is drawn as
+ * that mesh instead, so it costs no more fill than a plain blit.
+ *
+ * A canvas composited at a reduced scale (dynamic resolution) is scaled
+ * up to the output with a Catmull-Rom filter.
  */
 
 #ifndef VIDEOCOMPOSER_OUTPUTBLITSHADER_H
@@ -14,6 +23,12 @@
 
 #include "OutputRegion.h"
 #include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace videocomposer {
 
@@ -65,10 +80,16 @@ public:
      * @param canvasWidth Canvas width in pixels
      * @param canvasHeight Canvas height in pixels
      * @param region Output region configuration (position, size, blend, warp)
+     * @param contentWidth Composited part of the canvas, from its bottom-left
+     *        corner (dynamic resolution, see VirtualCanvas::setRenderScale);
+     *        smaller than the canvas, it is scaled up with a Catmull-Rom
+     *        filter. 0 = the whole canvas.
+     * @param contentHeight Height of that part
      */
     void blit(GLuint canvasTexture,
               int canvasWidth, int canvasHeight,
-              const OutputRegion& region);
+              const OutputRegion& region,
+              int contentWidth = 0, int contentHeight = 0);
     
     /**
      * Simple blit without blend/warp (for testing)
@@ -88,13 +109,86 @@ public:
                     int srcX, int srcY, int srcWidth, int srcHeight,
                     int dstWidth, int dstHeight);
     
+    /**
+     * Drop the baked maps (rebuilt on the next blit of each output)
+     */
+    void invalidateMaps();
+    
+    /**
+     * Blend weight at a pixel centre: smoothstep ramps on each edge
+     * multiplied, then raised to the blend gamma
+     */
+    static float blendWeight(const BlendEdges& blend, int width, int height, int x, int y) {
+        return edgeWeights(blend.left, blend.right, width, x, blend.gamma) *
+               edgeWeights(blend.top, blend.bottom, height, y, blend.gamma);
+    }
+    
+    /**
+     * Blend mask for an output, row 0 at texture coordinate v = 0
+     * @param mask Receives width * height weights in 16-bit fixed point
+     */
+    static void buildBlendMask(const BlendEdges& blend, int width, int height,
+                               std::vector<uint16_t>& mask) {
+        mask.assign(static_cast<size_t>(std::max(width, 0)) * std::max(height, 0), 0);
+        // pow(a * b, g) = pow(a, g) * pow(b, g): one curve per axis
+        std::vector<float> columns(std::max(width, 0));
+        for (int x = 0; x < width; ++x) {
+            columns[x] = edgeWeights(blend.left, blend.right, width, x, blend.gamma);
+        }
+        for (int y = 0; y < height; ++y) {
+            float row = edgeWeights(blend.top, blend.bottom, height, y, blend.gamma);
+            uint16_t* out = mask.data() + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; ++x) {
+                out[x] = static_cast<uint16_t>(std::lround(row * columns[x] * 65535.0f));
+            }
+        }
+    }
+    
 private:
+    /**
+     * Baked maps of one output and the region they were built from
+     */
+    struct OutputMaps {
+        bool baked = false;
+        BlendEdges blend;
+        int width = 0;
+        int height = 0;
+        const WarpMesh* warpMesh = nullptr;
+        GLuint warpTexture = 0;
+        unsigned int warpRevision = 0;
+        float sourceRect[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        
+        GLuint maskTexture = 0;      // R16 blend weights, 0 without blending
+        GLuint lookupTexture = 0;    // RG32F canvas coordinates, 0 without warp
+        int lookupWidth = 0;
+        int lookupHeight = 0;
+        GLuint meshVao = 0;          // Warp mesh, 0 without one
+        GLuint meshBuffers[2] = {0, 0};
+        GLsizei meshIndices = 0;
+    };
+    
+    static float edgeWeights(float lowWidth, float highWidth, int length, int index, float gamma) {
+        float pos = index + 0.5f;
+        float weight = 1.0f;
+        if (lowWidth > 0.0f && pos < lowWidth) {
+            weight *= smoothstep(pos / lowWidth);
+        }
+        if (highWidth > 0.0f && pos > length - highWidth) {
+            weight *= smoothstep((length - pos) / highWidth);
+        }
+        return weight < 1.0f ? std::pow(weight, gamma) : weight;
+    }
+    
+    static float smoothstep(float t) {
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+    
+
     bool initialized_ = false;
     
     // Shader program
     GLuint program_ = 0;
-    GLuint vertexShader_ = 0;
-    GLuint fragmentShader_ = 0;
     
     // Vertex array and buffer for fullscreen quad
     GLuint vao_ = 0;
@@ -102,13 +196,22 @@ private:
     
     // Uniform locations
     GLint uCanvasTex_ = -1;
-    GLint uCanvasSize_ = -1;
-    GLint uSourceRect_ = -1;      // x, y, width, height in canvas pixels
-    GLint uOutputSize_ = -1;      // output width, height in pixels
-    GLint uBlendWidths_ = -1;     // left, right, top, bottom blend widths
-    GLint uBlendGamma_ = -1;      // gamma for perceptual blending
+    GLint uSourceRect_ = -1;      // x, y, width, height in canvas texture coordinates
+    GLint uMaskEnabled_ = -1;     // 0 or 1
+    GLint uMaskTex_ = -1;         // baked blend mask
     GLint uWarpEnabled_ = -1;     // 0 or 1
-    GLint uWarpTex_ = -1;         // warp displacement texture
+    GLint uLookupTex_ = -1;       // baked canvas lookup map
+    GLint uUpscale_ = -1;         // 0 or 1 (dynamic resolution)
+    GLint uContentScale_ = -1;    // composited part of the canvas texture
+    GLint uCanvasSize_ = -1;      // canvas texture size in texels
+    
+    // Warp bake pass: displacement texture to lookup map
+    GLuint bakeProgram_ = 0;
+    GLint uBakeWarpTex_ = -1;
+    GLint uBakeSourceRect_ = -1;
+    GLuint bakeFbo_ = 0;
+    
+    std::map<std::string, OutputMaps> maps_;  // By output name
     
     // ===== Private Methods =====
     
@@ -122,6 +225,22 @@ private:
      */
     bool createQuadVAO();
     
+    /**
+     * Baked maps for a region, rebuilt if its blend, size, source or warp changed
+     */
+    const OutputMaps& prepareMaps(const OutputRegion& region, const float sourceRect[4]);
+    
+    bool bakeMask(OutputMaps& maps);
+    bool bakeLookup(OutputMaps& maps, const OutputRegion& region);
+    bool bakeMesh(OutputMaps& maps, const WarpMesh& warpMesh);
+    void releaseMesh(OutputMaps& maps);
+    void releaseMaps(OutputMaps& maps);
+    
+    /**
+     * Link a program from vertex and fragment sources (binary cache first)
+     */
+    GLuint linkProgram(const char* vertexSource, const char* fragmentSource, const char* what);
+    
     /**
      * Compile a shader
      */
@@ -136,6 +255,11 @@ private:
      * Get fragment shader source
      */
     static const char* getFragmentShaderSource();
+    
+    /**
+     * Get warp bake fragment shader source
+     */
+    static const char* getBakeShaderSource();
 };
 
 } // namespace videocomposer
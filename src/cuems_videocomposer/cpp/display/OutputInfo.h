@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cmath>
 
 namespace videocomposer {
 
@@ -124,6 +125,39 @@ struct OutputInfo {
         return nullptr;
     }
     
+    /**
+     * Find the mode at a resolution whose refresh is an integer multiple
+     * of a video framerate (50 Hz for 25 fps, 59.94 Hz for 29.97 fps)
+     *
+     * Of several multiples, the one closest to the current refresh rate
+     * wins (lower on a tie), so a 60 Hz output goes to 50 Hz rather than
+     * 25 or 100 Hz.
+     * @return Matching mode, or nullptr if none is a multiple
+     */
+    const OutputMode* findRefreshMultiple(int w, int h, double fps) const {
+        if (fps <= 0.0) {
+            return nullptr;
+        }
+        const OutputMode* best = nullptr;
+        for (const auto& mode : modes) {
+            if (mode.width != w || mode.height != h || mode.refreshRate <= 0.0) {
+                continue;
+            }
+            double multiple = std::round(mode.refreshRate / fps);
+            // 0.05%: 60 Hz is not a multiple of 29.97 fps, 59.94 Hz is
+            if (multiple < 1.0 || std::abs(mode.refreshRate - multiple * fps) > mode.refreshRate * 0.0005) {
+                continue;
+            }
+            double distance = std::abs(mode.refreshRate - refreshRate);
+            double bestDistance = best ? std::abs(best->refreshRate - refreshRate) : 0.0;
+            if (!best || distance < bestDistance - 0.01 ||
+                (std::abs(distance - bestDistance) <= 0.01 && mode.refreshRate < best->refreshRate)) {
+                best = &mode;
+            }
+        }
+        return best;
+    }
+    
     /**
      * Get display name for UI (e.g., "Samsung U28E590 (HDMI-A-1)")
      */
@@ -8,8 +8,10 @@
 #ifndef VIDEOCOMPOSER_OUTPUTREGION_H
 #define VIDEOCOMPOSER_OUTPUTREGION_H
 
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace videocomposer {
 
@@ -39,6 +41,19 @@ struct BlendEdges {
 // Forward declaration
 class WarpMesh;
 
+/**
+ * WarpVertex - One vertex of a warp mesh
+ *
+ * Both positions run 0-1 with v = 0 at the bottom, as the blit quad's
+ * texture coordinates.
+ */
+struct WarpVertex {
+    float x = 0.0f;     // Position across the output
+    float y = 0.0f;
+    float u = 0.0f;     // Source position in the output's canvas region
+    float v = 0.0f;
+};
+
 /**
  * OutputRegion - Defines an output's position and configuration in the virtual canvas
  * 
@@ -74,6 +89,7 @@ struct OutputRegion {
     
     // ===== State =====
     bool enabled = true;            // Is this output active?
+    bool dynamicResolution = true;  // May show the canvas composited smaller under GPU load
     
     // ===== Helper Methods =====
     
@@ -120,6 +136,37 @@ struct OutputRegion {
         return canvasHeight > 0 ? static_cast<float>(physicalHeight) / canvasHeight : 1.0f;
     }
     
+    /**
+     * What a new configuration of this output changes, so that only that is
+     * applied: placement and enabled move the canvas and what is composited;
+     * the output size, blend and warp only rebake the output's own maps
+     */
+    struct Changes {
+        bool placement = false;     // Canvas position or size
+        bool physical = false;      // Output resolution
+        bool blend = false;
+        bool warp = false;          // Mesh object or its file
+        bool enabled = false;
+        bool dynamicResolution = false;
+        
+        bool any() const { return placement || physical || blend || warp || enabled || dynamicResolution; }
+        bool affectsCanvas() const { return placement || enabled; }
+    };
+    
+    Changes changesTo(const OutputRegion& next) const {
+        Changes changes;
+        changes.placement = canvasX != next.canvasX || canvasY != next.canvasY ||
+                            canvasWidth != next.canvasWidth || canvasHeight != next.canvasHeight;
+        changes.physical = physicalWidth != next.physicalWidth || physicalHeight != next.physicalHeight;
+        changes.blend = blend.left != next.blend.left || blend.right != next.blend.right ||
+                        blend.top != next.blend.top || blend.bottom != next.blend.bottom ||
+                        blend.gamma != next.blend.gamma;
+        changes.warp = warpMesh != next.warpMesh || warpMeshPath != next.warpMeshPath;
+        changes.enabled = enabled != next.enabled;
+        changes.dynamicResolution = dynamicResolution != next.dynamicResolution;
+        return changes;
+    }
+    
     /**
      * Create a default 1:1 region for an output
      */
@@ -139,10 +186,12 @@ struct OutputRegion {
 };
 
 /**
- * WarpMesh - Placeholder for geometric warp mesh
+ * WarpMesh - Geometric warp of an output
  * 
- * TODO: Implement mesh loading and GPU representation
- * Supports common mesh formats for keystone/geometric correction.
+ * A warp is either a displacement texture sampled per pixel (getTexture)
+ * or a vertex mesh drawn in place of the blit quad (buildMesh), which
+ * costs no more fill than a plain blit. GridWarpMesh builds meshes from
+ * calibration grids.
  */
 class WarpMesh {
 public:
@@ -177,6 +226,27 @@ public:
         width = 0;
         height = 0;
     }
+    
+    /**
+     * Triangle mesh for an output of the given size
+     * @param vertices Receives the vertices
+     * @param indices Receives three indices per triangle
+     * @return false if this warp has no mesh form
+     */
+    virtual bool buildMesh(int outputWidth, int outputHeight,
+                           std::vector<WarpVertex>& vertices,
+                           std::vector<uint32_t>& indices) const {
+        (void)outputWidth;
+        (void)outputHeight;
+        vertices.clear();
+        indices.clear();
+        return false;
+    }
+    
+    /**
+     * Bumped whenever the warp changes, so baked copies are rebuilt
+     */
+    virtual unsigned int revision() const { return 0; }
 };
 
 } // namespace videocomposer
@@ -0,0 +1,55 @@
+#include "PreviewGrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+std::vector<CanvasRect> PreviewGrid::layout(int count, int atlasWidth, int atlasHeight, bool topDown, int gap) {
+    std::vector<CanvasRect> tiles;
+    if (count <= 0 || atlasWidth <= 0 || atlasHeight <= 0) {
+        return tiles;
+    }
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    int rows = (count + columns - 1) / columns;
+    gap = std::max(0, gap);
+    int cellWidth = std::max(1, (atlasWidth - gap * (columns - 1)) / columns);
+    int cellHeight = std::max(1, (atlasHeight - gap * (rows - 1)) / rows);
+
+    tiles.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        int column = i % columns;
+        int row = i / columns;
+        CanvasRect tile;
+        tile.x = column * (cellWidth + gap);
+        tile.y = topDown ? row * (cellHeight + gap) : atlasHeight - (row + 1) * cellHeight - row * gap;
+        tile.width = cellWidth;
+        tile.height = cellHeight;
+        tiles.push_back(tile);
+    }
+    return tiles;
+}
+
+PreviewPacer::PreviewPacer(double fps, double budgetMs) : fps_(1.0), budgetMs_(1.0) {
+    setRate(fps);
+    setBudget(budgetMs);
+}
+
+void PreviewPacer::setRate(double fps) {
+    fps_ = fps > 0.0 ? fps : 1.0;
+}
+
+void PreviewPacer::setBudget(double budgetMs) {
+    budgetMs_ = budgetMs > 0.0 ? budgetMs : 1.0;
+}
+
+void PreviewPacer::markRendered(int64_t nowUs) {
+    // From now, not from the last slot: a late render does not bunch up
+    nextUs_ = nowUs + static_cast<int64_t>(1e6 * stretch_ / fps_);
+    ++renders_;
+}
+
+void PreviewPacer::reportGpuTime(double ms) {
+    stretch_ = std::min(MAX_STRETCH, std::max(1.0, ms / budgetMs_));
+}
+
+} // namespace videocomposer
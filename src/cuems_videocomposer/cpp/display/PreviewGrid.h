@@ -0,0 +1,72 @@
+#ifndef VIDEOCOMPOSER_PREVIEWGRID_H
+#define VIDEOCOMPOSER_PREVIEWGRID_H
+
+#include "CanvasRegions.h"
+#include <cstdint>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * PreviewGrid - Tile layout of the operator multiview
+ *
+ * Tile 0 is the program output, the others one layer each, row by row
+ * from the top left of the image. Columns and rows are as even as the
+ * count allows (extra columns first), with a gap of background between
+ * tiles; each image is letterboxed into its tile when drawn.
+ */
+class PreviewGrid {
+public:
+    /**
+     * @param topDown The atlas is stored top row first (y = 0 at the top)
+     * @return count tiles in atlas pixels (CanvasRect: y = 0 at the bottom
+     *         unless topDown)
+     */
+    static std::vector<CanvasRect> layout(int count, int atlasWidth, int atlasHeight,
+                                          bool topDown = false, int gap = 2);
+};
+
+/**
+ * PreviewPacer - When the multiview renders, within its GPU time budget
+ *
+ * Runs at the preview rate; a render that took longer on the GPU than the
+ * budget stretches the next intervals by the same factor (up to
+ * MAX_STRETCH), so the preview's GPU time per second stays at the budget
+ * times the rate. Back under budget, the rate returns.
+ */
+class PreviewPacer {
+public:
+    static constexpr double MAX_STRETCH = 8.0;
+
+    explicit PreviewPacer(double fps = 5.0, double budgetMs = 1.0);
+
+    void setRate(double fps);
+    void setBudget(double budgetMs);
+    double getRate() const { return fps_; }
+    double getBudget() const { return budgetMs_; }
+
+    /** True if a render is due at this monotonic time */
+    bool isDue(int64_t nowUs) const { return nowUs >= nextUs_; }
+
+    /** A render was issued at this time */
+    void markRendered(int64_t nowUs);
+
+    /** GPU time of a past render (read back from its timer query) */
+    void reportGpuTime(double ms);
+
+    /** Factor the interval is stretched by (1 = on rate) */
+    double getStretch() const { return stretch_; }
+
+    uint64_t getRenderCount() const { return renders_; }
+
+private:
+    double fps_;
+    double budgetMs_;
+    double stretch_ = 1.0;
+    int64_t nextUs_ = 0;
+    uint64_t renders_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PREVIEWGRID_H
@@ -0,0 +1,131 @@
+#include "PreviewRenderer.h"
+#include "OpenGLRenderer.h"
+#include "OutputBlitShader.h"
+#include "../output/OutputSink.h"
+#include "../layer/VideoLayer.h"
+#include "../utils/Logger.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+
+namespace videocomposer {
+
+PreviewRenderer::PreviewRenderer() {
+}
+
+PreviewRenderer::~PreviewRenderer() {
+    // GL objects belong to the context: cleanup() runs while it is current
+}
+
+bool PreviewRenderer::init(const PreviewConfig& config) {
+    cleanup();
+    config_ = config;
+    config_.width = std::max(16, config_.width);
+    config_.height = std::max(16, config_.height);
+    config_.maxLayers = std::max(0, config_.maxLayers);
+    pacer_ = PreviewPacer(config_.fps, config_.gpuBudgetMs);
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, config_.width, config_.height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFbo));
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR << "PreviewRenderer: Atlas FBO incomplete, status=" << status;
+        cleanup();
+        return false;
+    }
+
+    // Without timer queries the budget cannot be checked: the rate holds
+    if (!gpuTimer_.init()) {
+        LOG_WARNING << "PreviewRenderer: No GPU timer queries, preview paced by rate only";
+    }
+    timedFrames_ = 0;
+    LOG_INFO << "PreviewRenderer: " << config_.width << "x" << config_.height << " multiview at "
+             << pacer_.getRate() << " fps, GPU budget " << pacer_.getBudget() << " ms";
+    return true;
+}
+
+void PreviewRenderer::cleanup() {
+    gpuTimer_.cleanup();
+    if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (texture_ != 0) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+}
+
+bool PreviewRenderer::render(OpenGLRenderer& renderer, OutputBlitShader& blit,
+                             const std::vector<const VideoLayer*>& layers,
+                             unsigned int canvasTexture, int canvasWidth, int canvasHeight, int64_t nowUs,
+                             int contentWidth, int contentHeight) {
+    if (!isInitialized() || !pacer_.isDue(nowUs)) {
+        return false;
+    }
+
+    // Reads the render FRAMES_IN_FLIGHT grids back, never waiting for it
+    gpuTimer_.beginFrame();
+    const GpuTimingStats& stats = gpuTimer_.stats();
+    GpuTimingStats::Summary frame;
+    if (stats.getFrameCount() != timedFrames_ && stats.getSummary("frame", -1, frame)) {
+        timedFrames_ = stats.getFrameCount();
+        pacer_.reportGpuTime(frame.lastMs);
+    }
+    pacer_.markRendered(nowUs);
+
+    GLint previousFbo = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    {
+        GpuTimer::Scope gpuPreview(gpuTimer_, "preview");
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glViewport(0, 0, config_.width, config_.height);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // Topmost layers first, after the program
+        size_t shown = std::min(layers.size(), static_cast<size_t>(config_.maxLayers));
+        std::vector<CanvasRect> tiles = PreviewGrid::layout(static_cast<int>(shown) + 1, config_.width,
+                                                            config_.height, renderer.getFlipY());
+        if (canvasTexture != 0 && canvasWidth > 0 && canvasHeight > 0) {
+            glViewport(tiles[0].x, tiles[0].y, tiles[0].width, tiles[0].height);
+            blit.blitSimple(static_cast<GLuint>(canvasTexture), canvasWidth, canvasHeight, 0, 0,
+                            contentWidth > 0 ? contentWidth : canvasWidth,
+                            contentHeight > 0 ? contentHeight : canvasHeight, tiles[0].width, tiles[0].height);
+        }
+        for (size_t i = 0; i < shown; ++i) {
+            const CanvasRect& tile = tiles[i + 1];
+            renderer.setViewport(tile.x, tile.y, tile.width, tile.height);
+            renderer.renderLayerPreview(layers[layers.size() - 1 - i]);
+        }
+    }
+    gpuTimer_.endFrame();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFbo));
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    renderer.setViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    if (sink_ && sink_->isReady()) {
+        sink_->writeTexture(texture_, config_.width, config_.height, nowUs);
+    }
+    return true;
+}
+
+} // namespace videocomposer
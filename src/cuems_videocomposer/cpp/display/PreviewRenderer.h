@@ -0,0 +1,87 @@
+/**
+ * PreviewRenderer.h - Operator multiview of the program and every layer
+ *
+ * Draws a low-resolution grid (PreviewGrid) into its own atlas texture a
+ * few times a second, after the program frame: tile 0 is the canvas,
+ * the others each layer's current frame, topmost first, sampled from the
+ * textures the composite left (no uploads, no decode). The atlas goes to
+ * one GPU sink of its own (a VAAPI encoder streaming to the operator UI),
+ * never to the program's virtual outputs.
+ */
+
+#ifndef VIDEOCOMPOSER_PREVIEWRENDERER_H
+#define VIDEOCOMPOSER_PREVIEWRENDERER_H
+
+#include "GpuTimer.h"
+#include "PreviewGrid.h"
+#include <cstdint>
+#include <vector>
+
+namespace videocomposer {
+
+class OpenGLRenderer;
+class OutputBlitShader;
+class OutputSink;
+class VideoLayer;
+
+struct PreviewConfig {
+    int width = 640;             // Atlas size
+    int height = 360;
+    double fps = 5.0;
+    double gpuBudgetMs = 1.0;    // GPU time one grid may take at that rate
+    int maxLayers = 15;          // Layer tiles (the lowest z-orders are left out)
+};
+
+/**
+ * PreviewRenderer - Multiview atlas paced to a GPU time budget
+ *
+ * Its GPU time is measured with its own timer queries (GpuTimer), read
+ * back renders later, and fed to a PreviewPacer: an expensive grid runs
+ * less often rather than eating into the program's frame time. All calls
+ * on the render thread with the canvas context current.
+ */
+class PreviewRenderer {
+public:
+    PreviewRenderer();
+    ~PreviewRenderer();
+
+    PreviewRenderer(const PreviewRenderer&) = delete;
+    PreviewRenderer& operator=(const PreviewRenderer&) = delete;
+
+    bool init(const PreviewConfig& config);
+    void cleanup();
+    bool isInitialized() const { return fbo_ != 0; }
+
+    /** Sink the atlas is written to (not owned, a GPU sink; nullptr = none) */
+    void setSink(OutputSink* sink) { sink_ = sink; }
+
+    /**
+     * Draw and send the grid if one is due
+     * @param layers Render list of this frame, bottom to top
+     * @param canvasTexture Program canvas (0 = leave its tile black)
+     * @param contentWidth Composited part of the canvas (dynamic resolution,
+     *        0 = all of it), and its height
+     * @return true if a grid was drawn
+     */
+    bool render(OpenGLRenderer& renderer, OutputBlitShader& blit,
+                const std::vector<const VideoLayer*>& layers,
+                unsigned int canvasTexture, int canvasWidth, int canvasHeight, int64_t nowUs,
+                int contentWidth = 0, int contentHeight = 0);
+
+    unsigned int getTexture() const { return texture_; }
+    const PreviewConfig& getConfig() const { return config_; }
+    const PreviewPacer& pacer() const { return pacer_; }
+
+private:
+    PreviewConfig config_;
+    PreviewPacer pacer_;
+    GpuTimer gpuTimer_;
+    uint64_t timedFrames_ = 0;    // GPU timer frames already given to the pacer
+    unsigned int fbo_ = 0;
+    unsigned int texture_ = 0;
+    OutputSink* sink_ = nullptr;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PREVIEWRENDERER_H
@@ -0,0 +1,221 @@
+/**
+ * ProgramBinaryCache.cpp - Persistent on-disk cache for GL program binaries
+ */
+
+#include "ProgramBinaryCache.h"
+#include "../utils/Logger.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'C', 'V', 'C', 'P', 'R', 'O', 'G', '\0'};
+constexpr size_t MAX_BINARY_BYTES = 64 * 1024 * 1024;  // Sanity limit for corrupt headers
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint64_t key;
+    uint64_t binarySize;
+};
+
+uint64_t fnv1a(const uint8_t* data, size_t len, uint64_t hash = 1469598103934665603ULL) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t fnv1a(const std::string& s, uint64_t hash) {
+    // Include the terminator so "ab"+"c" and "a"+"bc" hash differently
+    return fnv1a(reinterpret_cast<const uint8_t*>(s.c_str()), s.size() + 1, hash);
+}
+
+bool readFully(int fd, void* data, size_t len) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+ProgramBinaryCache& ProgramBinaryCache::instance() {
+    static ProgramBinaryCache cache;
+    return cache;
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string& cacheDir)
+    : enabled_(true)
+    , cacheDir_(cacheDir.empty() ? defaultCacheDir() : cacheDir)
+{
+}
+
+void ProgramBinaryCache::configure(bool enabled, const std::string& cacheDir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    cacheDir_ = cacheDir.empty() ? defaultCacheDir() : cacheDir;
+}
+
+bool ProgramBinaryCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+std::string ProgramBinaryCache::getCacheDir() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cacheDir_;
+}
+
+std::string ProgramBinaryCache::defaultCacheDir() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/cuems-videocomposer/shaders";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) {
+        return std::string(home) + "/.cache/cuems-videocomposer/shaders";
+    }
+    return "/tmp/cuems-videocomposer/shaders";
+}
+
+uint64_t ProgramBinaryCache::keyFor(const std::string& driverId, const std::string& vertexSource,
+                                    const std::string& fragmentSource) {
+    uint64_t hash = fnv1a(driverId, 1469598103934665603ULL);
+    hash = fnv1a(vertexSource, hash);
+    return fnv1a(fragmentSource, hash);
+}
+
+std::string ProgramBinaryCache::cachePathFor(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cvprog", static_cast<unsigned long long>(key));
+    return getCacheDir() + "/" + name;
+}
+
+bool ProgramBinaryCache::createDirectories(const std::string& path) {
+    std::string partial;
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        partial = path.substr(0, pos);
+        if (partial.empty()) continue;
+        if (mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProgramBinaryCache::load(uint64_t key, uint32_t& format, std::vector<uint8_t>& binary) const {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    std::string cachePath = cachePathFor(key);
+    int fd = ::open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;  // Plain miss
+    }
+
+    CacheHeader header;
+    const char* reason = nullptr;
+    if (!readFully(fd, &header, sizeof(header))) {
+        reason = "truncated";
+    } else if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        reason = "bad magic";
+    } else if (header.version != FORMAT_VERSION) {
+        reason = "format version mismatch";
+    } else if (header.key != key) {
+        reason = "key mismatch";
+    } else if (header.binarySize == 0 || header.binarySize > MAX_BINARY_BYTES) {
+        reason = "bad size";
+    } else {
+        binary.resize(static_cast<size_t>(header.binarySize));
+        if (!readFully(fd, binary.data(), binary.size())) {
+            reason = "truncated";
+        }
+    }
+    ::close(fd);
+
+    if (reason) {
+        LOG_INFO << "Program binary cache stale: " << cachePath << " (" << reason << ")";
+        binary.clear();
+        return false;
+    }
+
+    format = header.binaryFormat;
+    return true;
+}
+
+bool ProgramBinaryCache::store(uint64_t key, uint32_t format, const void* data, size_t size) const {
+    if (!isEnabled() || !data || size == 0 || size > MAX_BINARY_BYTES) {
+        return false;
+    }
+
+    std::string cacheDir = getCacheDir();
+    if (!createDirectories(cacheDir)) {
+        LOG_WARNING << "Program binary cache: cannot create " << cacheDir << ": " << strerror(errno);
+        return false;
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.binaryFormat = format;
+    header.key = key;
+    header.binarySize = size;
+
+    // Write to a temp file and rename, so readers never see a partial binary
+    std::string cachePath = cachePathFor(key);
+    std::string tmpPath = cachePath + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_WARNING << "Program binary cache: cannot write " << tmpPath << ": " << strerror(errno);
+        return false;
+    }
+
+    bool ok = writeFully(fd, &header, sizeof(header)) && writeFully(fd, data, size);
+    ok = (::close(fd) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+        LOG_WARNING << "Program binary cache: failed to store " << cachePath;
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    LOG_VERBOSE << "Program binary cache: stored " << size << " bytes in " << cachePath;
+    return true;
+}
+
+void ProgramBinaryCache::invalidate(uint64_t key) const {
+    unlink(cachePathFor(key).c_str());
+}
+
+} // namespace videocomposer
@@ -0,0 +1,102 @@
+#ifndef VIDEOCOMPOSER_PROGRAMBINARYCACHE_H
+#define VIDEOCOMPOSER_PROGRAMBINARYCACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ProgramBinaryCache - Persistent on-disk cache for linked GL program binaries
+ *
+ * Compiling and linking every video, HAP and output shader costs hundreds of
+ * milliseconds on some drivers, at each start and again whenever a DRM/EGL
+ * context is recreated after a hotplug. Linked programs are stored as
+ * glGetProgramBinary blobs and handed back to glProgramBinary next time
+ * (see ShaderProgram::loadProgramBinary / saveProgramBinary).
+ *
+ * Cache file layout (native endianness, one file per program):
+ *   Header - magic, format version, key, GL binary format, binary size
+ *   Data   - the driver's program binary
+ *
+ * The key hashes the driver identity (vendor, renderer, version) with both
+ * shader sources, so a driver update or a source change simply misses. A
+ * binary the driver still rejects is dropped and the program is rebuilt.
+ *
+ * This class does no GL calls itself.
+ */
+class ProgramBinaryCache {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    /**
+     * Shared instance used by ShaderProgram and OutputBlitShader
+     * (enabled with defaultCacheDir() until configured)
+     */
+    static ProgramBinaryCache& instance();
+
+    /**
+     * @param cacheDir Directory for cache files (empty = defaultCacheDir())
+     */
+    explicit ProgramBinaryCache(const std::string& cacheDir = std::string());
+
+    /**
+     * @param enabled false = never read or write binaries
+     * @param cacheDir Directory for cache files (empty = defaultCacheDir())
+     */
+    void configure(bool enabled, const std::string& cacheDir = std::string());
+
+    bool isEnabled() const;
+    std::string getCacheDir() const;
+
+    /**
+     * Default cache directory: $XDG_CACHE_HOME/cuems-videocomposer/shaders,
+     * falling back to ~/.cache/cuems-videocomposer/shaders
+     */
+    static std::string defaultCacheDir();
+
+    /**
+     * Cache key for a program on a given driver
+     * @param driverId Driver identity (vendor, renderer, version strings)
+     */
+    static uint64_t keyFor(const std::string& driverId, const std::string& vertexSource,
+                           const std::string& fragmentSource);
+
+    /**
+     * Load a cached binary
+     * @param format Receives the GL binary format
+     * @param binary Receives the binary
+     * @return true on a cache hit
+     */
+    bool load(uint64_t key, uint32_t& format, std::vector<uint8_t>& binary) const;
+
+    /**
+     * Store a binary (written atomically via rename)
+     * @return true on success
+     */
+    bool store(uint64_t key, uint32_t format, const void* data, size_t size) const;
+
+    /**
+     * Remove a cached binary (if any), e.g. after the driver rejected it
+     */
+    void invalidate(uint64_t key) const;
+
+    /**
+     * Get the cache file path used for a key
+     */
+    std::string cachePathFor(uint64_t key) const;
+
+private:
+    static bool createDirectories(const std::string& path);
+
+    mutable std::mutex mutex_;
+    bool enabled_;
+    std::string cacheDir_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PROGRAMBINARYCACHE_H
@@ -0,0 +1,175 @@
+#include "ShaderCache.h"
+#include "VideoShaders.h"
+#include "HapShaders.h"
+#include "../utils/Logger.h"
+
+namespace videocomposer {
+
+namespace {
+
+// Directives ahead of the feature #defines (see VideoShaders::ADVANCED_BLEND_FUNCTIONS)
+std::string blendPreamble(AdvancedBlend::Path path) {
+    switch (path) {
+        case AdvancedBlend::Path::BLEND_EQUATION:
+            return "#extension GL_KHR_blend_equation_advanced : require\n#define BLEND_EQUATION\n";
+        case AdvancedBlend::Path::FRAMEBUFFER_FETCH:
+            return "#extension GL_EXT_shader_framebuffer_fetch : require\n#define BLEND_FETCH\n";
+        case AdvancedBlend::Path::COPY_BOUNDS:
+            return "#define BLEND_COPY\n";
+    }
+    return std::string();
+}
+
+} // namespace
+
+ShaderCache::ShaderCache()
+    : blendPath_(AdvancedBlend::Path::COPY_BOUNDS)
+{
+}
+
+ShaderCache::~ShaderCache() {
+    clear();
+}
+
+uint32_t ShaderCache::supportedFeatures(ShaderKind kind) {
+    switch (kind) {
+        case ShaderKind::RGBA:
+            return VideoShaders::FEATURE_COLOR_CORRECTION | VideoShaders::FEATURE_HOMOGRAPHY |
+                   VideoShaders::FEATURE_ANISOTROPIC | VideoShaders::FEATURE_DEINTERLACE |
+                   VideoShaders::FEATURE_PACKED_ALPHA | VideoShaders::FEATURE_ADVANCED_BLEND |
+                   VideoShaders::FEATURE_EFFECTS;
+        case ShaderKind::NV12:
+        case ShaderKind::YUV420P:
+            return VideoShaders::FEATURE_COLOR_CORRECTION | VideoShaders::FEATURE_HOMOGRAPHY |
+                   VideoShaders::FEATURE_DEINTERLACE | VideoShaders::FEATURE_PACKED_ALPHA |
+                   VideoShaders::FEATURE_ADVANCED_BLEND | VideoShaders::FEATURE_EFFECTS;
+        case ShaderKind::UYVY:
+            return VideoShaders::FEATURE_COLOR_CORRECTION | VideoShaders::FEATURE_HOMOGRAPHY |
+                   VideoShaders::FEATURE_DEINTERLACE | VideoShaders::FEATURE_ADVANCED_BLEND |
+                   VideoShaders::FEATURE_EFFECTS;
+        case ShaderKind::HAP_Q:
+        case ShaderKind::HAP_Q_ALPHA:
+        case ShaderKind::HAP_HDR:
+            return VideoShaders::FEATURE_HOMOGRAPHY;
+        case ShaderKind::RGBA_BATCH:
+            return 0;
+    }
+    return 0;
+}
+
+void ShaderCache::setBlendPath(AdvancedBlend::Path path) {
+    if (path == blendPath_) {
+        return;
+    }
+    blendPath_ = path;
+    for (auto it = programs_.begin(); it != programs_.end();) {
+        if (it->first & VideoShaders::FEATURE_ADVANCED_BLEND) {
+            it = programs_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+ShaderProgram* ShaderCache::get(ShaderKind kind, uint32_t features) {
+    features &= supportedFeatures(kind);
+    uint32_t k = key(kind, features);
+
+    auto it = programs_.find(k);
+    if (it == programs_.end()) {
+        it = programs_.emplace(k, build(kind, features)).first;
+    }
+    return it->second.get();
+}
+
+std::unique_ptr<ShaderProgram> ShaderCache::build(ShaderKind kind, uint32_t features) {
+    std::string vertex;
+    std::string fragment;
+    switch (kind) {
+        case ShaderKind::RGBA:
+            vertex = VideoShaders::VERTEX_SHADER;
+            fragment = VideoShaders::FRAGMENT_RGBA;
+            break;
+        case ShaderKind::NV12:
+            vertex = VideoShaders::VERTEX_SHADER;
+            fragment = VideoShaders::FRAGMENT_NV12;
+            break;
+        case ShaderKind::YUV420P:
+            vertex = VideoShaders::VERTEX_SHADER;
+            fragment = VideoShaders::FRAGMENT_YUV420P;
+            break;
+        case ShaderKind::UYVY:
+            vertex = VideoShaders::VERTEX_SHADER;
+            fragment = VideoShaders::FRAGMENT_UYVY;
+            break;
+        case ShaderKind::HAP_Q:
+            vertex = HAP_VERTEX_SHADER;
+            fragment = HAP_Q_FRAGMENT_SHADER;
+            break;
+        case ShaderKind::HAP_Q_ALPHA:
+            vertex = HAP_VERTEX_SHADER;
+            fragment = HAP_Q_ALPHA_FRAGMENT_SHADER;
+            break;
+        case ShaderKind::HAP_HDR:
+            vertex = HAP_VERTEX_SHADER;
+            fragment = HAP_HDR_FRAGMENT_SHADER;
+            break;
+        case ShaderKind::RGBA_BATCH:
+            vertex = VideoShaders::BATCH_VERTEX_SHADER;
+            fragment = VideoShaders::batchFragmentShader();
+            break;
+    }
+
+    // Extension directives only where they apply: the fragment stage
+    std::string preamble;
+    if (features & VideoShaders::FEATURE_ADVANCED_BLEND) {
+        preamble = blendPreamble(blendPath_);
+    }
+    auto program = std::make_unique<ShaderProgram>();
+    if (!program->createFromSource(VideoShaders::specialize(vertex, features),
+                                   VideoShaders::specialize(fragment, features, preamble))) {
+        LOG_WARNING << "Failed to build shader permutation (kind " << static_cast<uint32_t>(kind)
+                    << ", features 0x" << std::hex << features << std::dec << ")";
+        return nullptr;
+    }
+    LOG_VERBOSE << "Built shader permutation (kind " << static_cast<uint32_t>(kind)
+                << ", features 0x" << std::hex << features << std::dec << ")";
+    return program;
+}
+
+size_t ShaderCache::prewarm() {
+    const ShaderKind kinds[] = {ShaderKind::RGBA, ShaderKind::NV12, ShaderKind::YUV420P,
+                                ShaderKind::HAP_Q, ShaderKind::HAP_Q_ALPHA, ShaderKind::RGBA_BATCH,
+                                ShaderKind::UYVY, ShaderKind::HAP_HDR};
+    for (ShaderKind kind : kinds) {
+        // All subsets of the supported feature bits
+        uint32_t mask = supportedFeatures(kind);
+        for (uint32_t features = mask; ; features = (features - 1) & mask) {
+            // Fields are not gradient sampled (see OpenGLRenderer::layerShader)
+            const uint32_t exclusive = VideoShaders::FEATURE_ANISOTROPIC | VideoShaders::FEATURE_DEINTERLACE;
+            if ((features & exclusive) != exclusive) {
+                get(kind, features);
+            }
+            if (features == 0) {
+                break;
+            }
+        }
+    }
+    return getProgramCount();
+}
+
+size_t ShaderCache::getProgramCount() const {
+    size_t count = 0;
+    for (const auto& entry : programs_) {
+        if (entry.second) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void ShaderCache::clear() {
+    programs_.clear();
+}
+
+} // namespace videocomposer
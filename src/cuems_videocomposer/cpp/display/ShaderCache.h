@@ -0,0 +1,91 @@
+#ifndef VIDEOCOMPOSER_SHADERCACHE_H
+#define VIDEOCOMPOSER_SHADERCACHE_H
+
+#include "ShaderProgram.h"
+#include "AdvancedBlend.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+
+namespace videocomposer {
+
+/**
+ * Base layer program (texture format); features are VideoShaders::Feature bits
+ */
+enum class ShaderKind : uint32_t {
+    RGBA = 0,      // CPU frames, HAP, HAP Alpha, HAP R
+    NV12,          // VAAPI/CUDA
+    YUV420P,       // Software decode (8 and 10-bit)
+    HAP_Q,         // YCoCg DXT5
+    HAP_Q_ALPHA,   // YCoCg DXT5 + RGTC1 alpha
+    RGBA_BATCH,    // Instanced plain RGBA layers (no features)
+    UYVY,          // Packed 4:2:2 live inputs (NDI, V4L2)
+    HAP_HDR        // BC6H float RGB (HAP HDR), tone mapped
+};
+
+/**
+ * ShaderCache - Lazily built, specialized layer shader programs
+ *
+ * Programs are keyed by (kind, feature bits) and compiled the first time
+ * a layer needs that combination, so the renderer can always pick the
+ * smallest program for a layer. Features a kind does not implement are
+ * masked off. A permutation that fails to build is remembered and not
+ * retried every frame. FEATURE_ADVANCED_BLEND programs are built for the
+ * context's AdvancedBlend path (see setBlendPath()).
+ *
+ * Must be used (and destroyed) with the owning GL context current.
+ */
+class ShaderCache {
+public:
+    ShaderCache();
+    ~ShaderCache();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    /**
+     * Get the program for a kind and feature set, building it on first use
+     * @return nullptr if the permutation does not compile
+     */
+    ShaderProgram* get(ShaderKind kind, uint32_t features);
+
+    /**
+     * Feature bits a kind supports (others are ignored by get())
+     */
+    static uint32_t supportedFeatures(ShaderKind kind);
+
+    /**
+     * How advanced-blend programs get the destination (drops the programs
+     * built for another path)
+     */
+    void setBlendPath(AdvancedBlend::Path path);
+    AdvancedBlend::Path getBlendPath() const { return blendPath_; }
+
+    /**
+     * Build every permutation of every kind, so no layer change compiles
+     * mid-show. With the program binary cache this costs a full compile only
+     * once per driver; later starts load binaries.
+     * @return Number of programs available
+     */
+    size_t prewarm();
+
+    // Number of successfully built programs
+    size_t getProgramCount() const;
+
+    // Drop all programs
+    void clear();
+
+private:
+    static uint32_t key(ShaderKind kind, uint32_t features) {
+        return (static_cast<uint32_t>(kind) << 16) | features;
+    }
+
+    std::unique_ptr<ShaderProgram> build(ShaderKind kind, uint32_t features);
+
+    std::map<uint32_t, std::unique_ptr<ShaderProgram>> programs_;  // nullptr = failed
+    AdvancedBlend::Path blendPath_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SHADERCACHE_H
@@ -1,10 +1,48 @@
 #include "ShaderProgram.h"
+#include "ProgramBinaryCache.h"
+#include "VideoShaders.h"
 #include "../utils/Logger.h"
+#include <cstring>
 #include <vector>
 #include <GL/glew.h>
 
 namespace videocomposer {
 
+namespace {
+
+// GL 4.1 / ARB_get_program_binary with at least one binary format
+bool programBinarySupported() {
+    if (!ProgramBinaryCache::instance().isEnabled()) {
+        return false;
+    }
+    if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+// GLES 3 context (GBM/EGL surfaces fall back to one when desktop GL is missing)
+bool isGLESContext() {
+    const GLubyte* version = glGetString(GL_VERSION);
+    return version && strncmp(reinterpret_cast<const char*>(version), "OpenGL ES", 9) == 0;
+}
+
+// Binaries are only valid for the driver that produced them
+std::string driverId() {
+    std::string id;
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : names) {
+        const GLubyte* value = glGetString(name);
+        id += value ? reinterpret_cast<const char*>(value) : "?";
+        id += '\n';
+    }
+    return id;
+}
+
+} // namespace
+
 ShaderProgram::ShaderProgram()
     : programId_(0)
     , vertexShaderId_(0)
@@ -36,6 +74,13 @@ bool ShaderProgram::createFromSource(const std::string& vertexSource,
                                      const std::string& fragmentSource) {
     cleanup();
     
+    // Binary from an earlier run: no compile, no link
+    programId_ = loadProgramBinary(vertexSource, fragmentSource);
+    if (programId_ != 0) {
+        LOG_VERBOSE << "Shader program loaded from binary cache (ID: " << programId_ << ")";
+        return true;
+    }
+    
     // Compile vertex shader
     vertexShaderId_ = compileShader(GL_VERTEX_SHADER, vertexSource);
     if (vertexShaderId_ == 0) {
@@ -57,6 +102,7 @@ bool ShaderProgram::createFromSource(const std::string& vertexSource,
         cleanup();
         return false;
     }
+    saveProgramBinary(programId_, vertexSource, fragmentSource);
     
     LOG_INFO << "Shader program created successfully (ID: " << programId_ << ")";
     return true;
@@ -69,7 +115,9 @@ GLuint ShaderProgram::compileShader(GLenum type, const std::string& source) {
         return 0;
     }
     
-    const char* sourcePtr = source.c_str();
+    // Sources are GLSL 330 core; GLES only differs in the preamble
+    const std::string glesSource = isGLESContext() ? VideoShaders::forGLES(source) : std::string();
+    const char* sourcePtr = glesSource.empty() ? source.c_str() : glesSource.c_str();
     glShaderSource(shaderId, 1, &sourcePtr, nullptr);
     glCompileShader(shaderId);
     
@@ -97,6 +145,7 @@ bool ShaderProgram::linkProgram() {
     
     glAttachShader(programId_, vertexShaderId_);
     glAttachShader(programId_, fragmentShaderId_);
+    prepareProgramBinary(programId_);
     glLinkProgram(programId_);
     
     // Check link status
@@ -171,6 +220,67 @@ GLint ShaderProgram::getAttribLocation(const std::string& name) const {
     return glGetAttribLocation(programId_, name.c_str());
 }
 
+GLuint ShaderProgram::loadProgramBinary(const std::string& vertexSource, const std::string& fragmentSource) {
+    if (!programBinarySupported()) {
+        return 0;
+    }
+    
+    ProgramBinaryCache& cache = ProgramBinaryCache::instance();
+    uint64_t key = ProgramBinaryCache::keyFor(driverId(), vertexSource, fragmentSource);
+    uint32_t format = 0;
+    std::vector<uint8_t> binary;
+    if (!cache.load(key, format, binary)) {
+        return 0;
+    }
+    
+    GLuint programId = glCreateProgram();
+    if (programId == 0) {
+        return 0;
+    }
+    glProgramBinary(programId, static_cast<GLenum>(format), binary.data(), static_cast<GLsizei>(binary.size()));
+    
+    GLint linked = 0;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // Driver no longer accepts it (e.g. updated without a version string change)
+        while (glGetError() != GL_NO_ERROR) {}
+        LOG_INFO << "Cached program binary rejected by driver, rebuilding";
+        glDeleteProgram(programId);
+        cache.invalidate(key);
+        return 0;
+    }
+    return programId;
+}
+
+void ShaderProgram::prepareProgramBinary(GLuint programId) {
+    if (programId != 0 && programBinarySupported()) {
+        glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ShaderProgram::saveProgramBinary(GLuint programId, const std::string& vertexSource,
+                                      const std::string& fragmentSource) {
+    if (programId == 0 || !programBinarySupported()) {
+        return;
+    }
+    
+    GLint length = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<uint8_t> binary(static_cast<size_t>(length));
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(programId, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    
+    uint64_t key = ProgramBinaryCache::keyFor(driverId(), vertexSource, fragmentSource);
+    ProgramBinaryCache::instance().store(key, format, binary.data(), static_cast<size_t>(written));
+}
+
 void ShaderProgram::setUniform(const std::string& name, int value) {
     GLint location = getUniformLocation(name);
     if (location != -1) {
@@ -206,6 +316,13 @@ void ShaderProgram::setUniform(const std::string& name, float x, float y, float
     }
 }
 
+void ShaderProgram::setUniformMatrix3fv(const std::string& name, const float* matrix) {
+    GLint location = getUniformLocation(name);
+    if (location != -1) {
+        glUniformMatrix3fv(location, 1, GL_FALSE, matrix);
+    }
+}
+
 void ShaderProgram::setUniformMatrix4fv(const std::string& name, const float* matrix) {
     GLint location = getUniformLocation(name);
     if (location != -1) {
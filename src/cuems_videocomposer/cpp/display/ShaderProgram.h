@@ -40,6 +40,7 @@ public:
     void setUniform(const std::string& name, float x, float y);
     void setUniform(const std::string& name, float x, float y, float z);
     void setUniform(const std::string& name, float x, float y, float z, float w);
+    void setUniformMatrix3fv(const std::string& name, const float* matrix);
     void setUniformMatrix4fv(const std::string& name, const float* matrix);
     
     // Get uniform location (cached)
@@ -47,6 +48,18 @@ public:
     
     // Get attribute location
     GLint getAttribLocation(const std::string& name) const;
+    
+    /**
+     * Program binary cache glue (see ProgramBinaryCache), also used by
+     * shaders that manage their own GL program (OutputBlitShader)
+     * - loadProgramBinary: linked program from the cache, 0 on a miss
+     * - prepareProgramBinary: call between glCreateProgram and glLinkProgram
+     * - saveProgramBinary: call after a successful link
+     */
+    static GLuint loadProgramBinary(const std::string& vertexSource, const std::string& fragmentSource);
+    static void prepareProgramBinary(GLuint programId);
+    static void saveProgramBinary(GLuint programId, const std::string& vertexSource,
+                                  const std::string& fragmentSource);
 
 private:
     GLuint programId_;
@@ -0,0 +1,374 @@
+#include "SoftwareCompositor.h"
+#include "ColorLut.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VIDEOCOMPOSER_COMPOSITOR_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define VIDEOCOMPOSER_COMPOSITOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace videocomposer {
+
+namespace {
+
+constexpr int64_t MIN_PARALLEL_PIXELS = 256 * 256;   // Smaller canvases stay on the calling thread
+const uint8_t OPAQUE_BLACK[4] = {0, 0, 0, 255};
+
+// Straight alpha (0-255) to 0-256, times the layer opacity; the SIMD
+// versions compute exactly this in 16-bit lanes
+inline uint32_t layerAlpha(uint32_t alpha, int opacity256) {
+    uint32_t a = alpha + (alpha >> 7);
+    return opacity256 >= 256 ? a : (a * static_cast<uint32_t>(opacity256) + 128) >> 8;
+}
+
+inline uint32_t mix(uint32_t d, uint32_t s, uint32_t a) {
+    return (d * (256 - a) + s * a + 128) >> 8;
+}
+
+inline uint32_t div255(uint32_t x) {
+    return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+void blendNormalScalar(const uint8_t* s, uint8_t* d, int n, int opacity256) {
+    for (int x = 0; x < n; ++x, s += 4, d += 4) {
+        uint32_t a = layerAlpha(s[3], opacity256);
+        d[0] = static_cast<uint8_t>(mix(d[0], s[0], a));
+        d[1] = static_cast<uint8_t>(mix(d[1], s[1], a));
+        d[2] = static_cast<uint8_t>(mix(d[2], s[2], a));
+        d[3] = 255;
+    }
+}
+
+// Multiply, screen and overlay: mix(d, f(s, d), alpha) as in blendOutput()
+// of the advanced blend shaders, with an opaque destination
+void blendModeScalar(const uint8_t* s, uint8_t* d, int n, int opacity256, LayerProperties::BlendMode mode) {
+    for (int x = 0; x < n; ++x, s += 4, d += 4) {
+        uint32_t a = layerAlpha(s[3], opacity256);
+        if (a == 0) {
+            continue;
+        }
+        for (int c = 0; c < 3; ++c) {
+            uint32_t sc = s[c];
+            uint32_t dc = d[c];
+            uint32_t f;
+            if (mode == LayerProperties::MULTIPLY) {
+                f = div255(sc * dc);
+            } else if (mode == LayerProperties::SCREEN) {
+                f = sc + dc - div255(sc * dc);
+            } else if (dc < 128) {
+                f = div255(2 * sc * dc);
+            } else {
+                f = 255 - div255(2 * (255 - sc) * (255 - dc));
+            }
+            d[c] = static_cast<uint8_t>(mix(dc, std::min<uint32_t>(f, 255), a));
+        }
+        d[3] = 255;
+    }
+}
+
+#ifdef VIDEOCOMPOSER_COMPOSITOR_X86
+
+// Four pixels of 16-bit channels, two per 128-bit lane
+__attribute__((target("avx2")))
+inline __m256i mixAvx2(__m256i s16, __m256i d16, __m256i opacity, bool fullOpacity) {
+    const __m256i round = _mm256_set1_epi16(128);
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s16, 0xFF), 0xFF);
+    a = _mm256_add_epi16(a, _mm256_srli_epi16(a, 7));
+    if (!fullOpacity) {
+        a = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, opacity), round), 8);
+    }
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(d16, _mm256_sub_epi16(_mm256_set1_epi16(256), a)),
+                                   _mm256_mullo_epi16(s16, a));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, round), 8);
+}
+
+__attribute__((target("avx2")))
+void blendNormalAvx2(const uint8_t* s, uint8_t* d, int n, int opacity256) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opacity = _mm256_set1_epi16(static_cast<short>(opacity256));
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    const bool fullOpacity = opacity256 >= 256;
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + x * 4));
+        __m256i dst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d + x * 4));
+        __m256i lo = mixAvx2(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero), opacity, fullOpacity);
+        __m256i hi = mixAvx2(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero), opacity, fullOpacity);
+        __m256i out = _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + x * 4), out);
+    }
+    blendNormalScalar(s + x * 4, d + x * 4, n - x, opacity256);
+}
+
+#endif // VIDEOCOMPOSER_COMPOSITOR_X86
+
+#ifdef VIDEOCOMPOSER_COMPOSITOR_NEON
+
+// Two pixels of 16-bit channels
+inline uint16x8_t mixNeon(uint16x8_t s16, uint16x8_t d16, int opacity256) {
+    uint16x8_t a = vcombine_u16(vdup_lane_u16(vget_low_u16(s16), 3), vdup_lane_u16(vget_high_u16(s16), 3));
+    a = vaddq_u16(a, vshrq_n_u16(a, 7));
+    if (opacity256 < 256) {
+        a = vshrq_n_u16(vaddq_u16(vmulq_n_u16(a, static_cast<uint16_t>(opacity256)), vdupq_n_u16(128)), 8);
+    }
+    uint16x8_t sum = vmlaq_u16(vmulq_u16(d16, vsubq_u16(vdupq_n_u16(256), a)), s16, a);
+    return vshrq_n_u16(vaddq_u16(sum, vdupq_n_u16(128)), 8);
+}
+
+void blendNormalNeon(const uint8_t* s, uint8_t* d, int n, int opacity256) {
+    static const uint8_t OPAQUE[16] = {0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255};
+    const uint8x16_t opaque = vld1q_u8(OPAQUE);
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        uint8x16_t src = vld1q_u8(s + x * 4);
+        uint8x16_t dst = vld1q_u8(d + x * 4);
+        uint16x8_t lo = mixNeon(vmovl_u8(vget_low_u8(src)), vmovl_u8(vget_low_u8(dst)), opacity256);
+        uint16x8_t hi = mixNeon(vmovl_u8(vget_high_u8(src)), vmovl_u8(vget_high_u8(dst)), opacity256);
+        vst1q_u8(d + x * 4, vorrq_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)), opaque));
+    }
+    blendNormalScalar(s + x * 4, d + x * 4, n - x, opacity256);
+}
+
+#endif // VIDEOCOMPOSER_COMPOSITOR_NEON
+
+inline int lerp(int a, int b, int weight) {
+    return a + (((b - a) * weight + 128) >> 8);
+}
+
+} // namespace
+
+SoftwareCompositor::SoftwareCompositor()
+    : isa_(CPUImageKernels::activeIsa()) {
+}
+
+SoftwareCompositor::~SoftwareCompositor() = default;
+
+bool SoftwareCompositor::place(const Layer& layer, int canvasWidth, int canvasHeight, Placement& placement) {
+    const LayerProperties& props = layer.properties;
+    const int srcWidth = layer.source.width;
+    const int srcHeight = layer.source.height;
+    if (srcWidth <= 0 || srcHeight <= 0 || canvasWidth <= 0 || canvasHeight <= 0 ||
+        props.scaleX == 0.0f || props.scaleY == 0.0f) {
+        return false;
+    }
+
+    // Fitted to the canvas by aspect (letterboxed), as the renderer's quad
+    double aspect = layer.aspect > 0.0f ? layer.aspect : static_cast<double>(srcWidth) / srcHeight;
+    double fitWidth = canvasWidth;
+    double fitHeight = canvasHeight;
+    if (static_cast<double>(canvasWidth) / canvasHeight > aspect) {
+        fitWidth = canvasHeight * aspect;
+    } else {
+        fitHeight = canvasWidth / aspect;
+    }
+
+    // Scaled and rotated about its centre, that centre on the canvas centre
+    int boxWidth = 0, boxHeight = 0;
+    CPUImageKernels::AffineMap map = CPUImageKernels::scaleRotate(
+        srcWidth, srcHeight, fitWidth / srcWidth * props.scaleX, fitHeight / srcHeight * props.scaleY,
+        props.rotation, boxWidth, boxHeight);
+    const double left = canvasWidth / 2.0 - boxWidth / 2.0;
+    const double top = canvasHeight / 2.0 - boxHeight / 2.0;
+    map.x0 -= map.dxx * left + map.dxy * top;
+    map.y0 -= map.dyx * left + map.dyy * top;
+
+    placement.map = map;
+    placement.x0 = std::max(0, static_cast<int>(std::floor(left)));
+    placement.y0 = std::max(0, static_cast<int>(std::floor(top)));
+    placement.x1 = std::min(canvasWidth, static_cast<int>(std::ceil(left + boxWidth)));
+    placement.y1 = std::min(canvasHeight, static_cast<int>(std::ceil(top + boxHeight)));
+    return placement.x0 < placement.x1 && placement.y0 < placement.y1;
+}
+
+void SoftwareCompositor::composite(const std::vector<Layer>& layers, uint8_t* canvas, int width, int height,
+                                   int stride) {
+    if (!canvas || width <= 0 || height <= 0) {
+        return;
+    }
+    if (tables_.size() > MAX_TABLES) {
+        tables_.clear();   // Rebaked on use; never while a pointer to one is held
+    }
+
+    prepared_.clear();
+    for (const Layer& layer : layers) {
+        const LayerProperties& props = layer.properties;
+        Prepared prepared;
+        prepared.layer = &layer;
+        prepared.opacity256 = static_cast<int>(std::lround(std::min(std::max(props.opacity, 0.0f), 1.0f) * 256.0f));
+        if (!props.visible || prepared.opacity256 == 0 || !layer.source.data ||
+            !place(layer, width, height, prepared.placement)) {
+            continue;
+        }
+        prepared.table = props.colorAdjust.isActive() ? table(props.colorAdjust) : nullptr;
+        prepared_.push_back(prepared);
+    }
+
+    auto rows = [&](int firstRow, int endRow) { compositeRows(firstRow, endRow, canvas, width, stride); };
+    const int64_t pixels = static_cast<int64_t>(width) * height;
+    if (height < 2 * TILE_ROWS || pixels < MIN_PARALLEL_PIXELS ||
+        !CPUImageKernels::runBands(height, TILE_ROWS, std::ref(rows))) {
+        rows(0, height);
+    }
+}
+
+void SoftwareCompositor::compositeRows(int firstRow, int endRow, uint8_t* canvas, int width, int stride) {
+    for (int y = firstRow; y < endRow; ++y) {
+        uint8_t* row = canvas + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < width; ++x) {
+            std::memcpy(row + x * 4, OPAQUE_BLACK, 4);
+        }
+    }
+
+    // Sampled rows of one layer over this tile (one buffer per worker thread)
+    thread_local std::vector<uint8_t> scratch;
+    for (const Prepared& prepared : prepared_) {
+        const Placement& placement = prepared.placement;
+        const int first = std::max(firstRow, placement.y0);
+        const int end = std::min(endRow, placement.y1);
+        if (first >= end) {
+            continue;
+        }
+        const int columns = placement.x1 - placement.x0;
+        const int rowBytes = columns * 4;
+        scratch.resize(static_cast<size_t>(rowBytes) * (end - first));
+
+        CPUImageKernels::AffineMap map = placement.map;
+        map.x0 += map.dxx * placement.x0 + map.dxy * first;
+        map.y0 += map.dyx * placement.x0 + map.dyy * first;
+        CPUImageKernels::Target target;
+        target.data = scratch.data();
+        target.width = columns;
+        target.height = end - first;
+        target.stride = rowBytes;
+        CPUImageKernels::bilinearRows(prepared.layer->source, target, map, 0, end - first, isa_);
+
+        const LayerProperties::BlendMode mode = prepared.layer->properties.blendMode;
+        for (int y = first; y < end; ++y) {
+            uint8_t* pixels = scratch.data() + static_cast<size_t>(y - first) * rowBytes;
+            if (prepared.layer->swapRedBlue) {
+                swapRedBlue(pixels, columns);
+            }
+            if (prepared.table) {
+                applyTable(*prepared.table, pixels, columns, redFirst_);
+            }
+            blendRow(pixels, canvas + static_cast<size_t>(y) * stride + placement.x0 * 4, columns,
+                     prepared.opacity256, mode, isa_);
+        }
+    }
+}
+
+void SoftwareCompositor::blendRow(const uint8_t* source, uint8_t* canvas, int n, int opacity256,
+                                  LayerProperties::BlendMode mode, CPUImageKernels::Isa isa) {
+    if (n <= 0 || opacity256 <= 0) {
+        return;
+    }
+    if (mode != LayerProperties::NORMAL) {
+        blendModeScalar(source, canvas, n, opacity256, mode);
+        return;
+    }
+#ifdef VIDEOCOMPOSER_COMPOSITOR_X86
+    if (isa == CPUImageKernels::Isa::AVX2 && CPUImageKernels::isSupported(isa)) {
+        blendNormalAvx2(source, canvas, n, opacity256);
+        return;
+    }
+#endif
+#ifdef VIDEOCOMPOSER_COMPOSITOR_NEON
+    if (isa == CPUImageKernels::Isa::NEON) {
+        blendNormalNeon(source, canvas, n, opacity256);
+        return;
+    }
+#endif
+    (void)isa;
+    blendNormalScalar(source, canvas, n, opacity256);
+}
+
+const SoftwareCompositor::ColorTable* SoftwareCompositor::table(const LayerProperties::ColorAdjustment& adjust) {
+    Key key(adjust.brightness, adjust.contrast, adjust.saturation, adjust.hue, adjust.gamma, adjust.lutFile);
+    auto it = tables_.find(key);
+    if (it != tables_.end()) {
+        return it->second.get();
+    }
+
+    // Same lattice as the calibration table, as ColorLutCache bakes it
+    const ColorLut* calibration = nullptr;
+    if (!adjust.lutFile.empty()) {
+        auto cube = cubes_.find(adjust.lutFile);
+        if (cube == cubes_.end()) {
+            auto lut = std::make_unique<ColorLut>();
+            if (!lut->loadCube(adjust.lutFile)) {
+                LOG_WARNING << "SoftwareCompositor: " << adjust.lutFile << " not applied, colour adjustment only";
+                lut.reset();
+            }
+            cube = cubes_.emplace(adjust.lutFile, std::move(lut)).first;
+        }
+        calibration = cube->second.get();
+    }
+    ColorLut lut;
+    if (!lut.build(ColorLut::Adjustment::from(adjust), calibration ? calibration->size() : ColorLut::DEFAULT_SIZE,
+                   calibration)) {
+        return nullptr;
+    }
+    auto baked = std::make_unique<ColorTable>();
+    bakeTable(lut, *baked);
+    return tables_.emplace(key, std::move(baked)).first->second.get();
+}
+
+void SoftwareCompositor::bakeTable(const ColorLut& lut, ColorTable& table) {
+    table.size = lut.size();
+    table.data.resize(lut.data().size());
+    for (size_t i = 0; i < lut.data().size(); ++i) {
+        float value = std::min(std::max(lut.data()[i], 0.0f), 1.0f);
+        table.data[i] = static_cast<uint16_t>(std::lround(value * 255.0f * 64.0f));
+    }
+    const int last = std::max(table.size - 1, 1);
+    for (int v = 0; v < 256; ++v) {
+        int position = (v * last * 256 + 127) / 255;
+        int index = std::min(position >> 8, std::max(last - 1, 0));
+        table.index[v] = static_cast<uint8_t>(index);
+        table.weight[v] = static_cast<uint16_t>(position - index * 256);
+    }
+}
+
+void SoftwareCompositor::applyTable(const ColorTable& table, uint8_t* pixels, int n, bool redFirst) {
+    if (table.size < 2) {
+        return;
+    }
+    const int red = redFirst ? 0 : 2;
+    const int blue = redFirst ? 2 : 0;
+    const size_t stepG = static_cast<size_t>(3) * table.size;
+    const size_t stepB = stepG * table.size;
+    const uint16_t* data = table.data.data();
+    for (int x = 0; x < n; ++x, pixels += 4) {
+        const int r = pixels[red], g = pixels[1], b = pixels[blue];
+        const int wr = table.weight[r], wg = table.weight[g], wb = table.weight[b];
+        const uint16_t* base = data + 3 * (table.index[r] + table.size * (table.index[g] + table.size * table.index[b]));
+        int out[3];
+        for (int c = 0; c < 3; ++c) {
+            const uint16_t* p = base + c;
+            int c00 = lerp(p[0], p[3], wr);
+            int c10 = lerp(p[stepG], p[stepG + 3], wr);
+            int c01 = lerp(p[stepB], p[stepB + 3], wr);
+            int c11 = lerp(p[stepB + stepG], p[stepB + stepG + 3], wr);
+            int value = lerp(lerp(c00, c10, wg), lerp(c01, c11, wg), wb);
+            out[c] = std::min(std::max((value + 32) >> 6, 0), 255);
+        }
+        pixels[red] = static_cast<uint8_t>(out[0]);
+        pixels[1] = static_cast<uint8_t>(out[1]);
+        pixels[blue] = static_cast<uint8_t>(out[2]);
+    }
+}
+
+void SoftwareCompositor::swapRedBlue(uint8_t* pixels, int n) {
+    for (int x = 0; x < n; ++x, pixels += 4) {
+        std::swap(pixels[0], pixels[2]);
+    }
+}
+
+} // namespace videocomposer
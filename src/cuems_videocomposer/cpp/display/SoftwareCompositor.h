@@ -0,0 +1,128 @@
+#ifndef VIDEOCOMPOSER_SOFTWARECOMPOSITOR_H
+#define VIDEOCOMPOSER_SOFTWARECOMPOSITOR_H
+
+#include "CPUImageKernels.h"
+#include "../layer/LayerProperties.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace videocomposer {
+
+class ColorLut;
+
+/**
+ * SoftwareCompositor - The layer model composited on the CPU
+ *
+ * For nodes without a GPU (SoftwareDisplay). Layers are placed as the
+ * renderer places them: fitted to the canvas by aspect, scaled and
+ * rotated about the canvas centre, then blended with their opacity and
+ * blend mode (normal, multiply, screen, overlay, the formulas of the
+ * advanced blend shaders) over an opaque black canvas. Colour
+ * adjustments go through a baked ColorLut, as in the shaders. Crop and
+ * panorama are applied before, by LayerDisplay (CPUImageProcessor).
+ *
+ * The canvas is composited in row tiles on the CPUImageKernels worker
+ * pool: each tile is cleared, then every layer over it is sampled
+ * (bilinear, the SIMD kernels of CPUImageKernels) into a scratch row
+ * and blended in, so a tile stays in cache across the layers. Normal
+ * blending, the common case, has AVX2 and NEON versions giving the same
+ * bytes as the scalar one.
+ *
+ * Pixels are 4 bytes with alpha last (BGRA or RGBA, as the canvas);
+ * layer alpha is straight. One caller at a time.
+ */
+class SoftwareCompositor {
+public:
+    static constexpr int TILE_ROWS = 32;
+    static constexpr size_t MAX_TABLES = 16;
+
+    struct Layer {
+        CPUImageKernels::Source source;         // As shown (crop and panorama applied)
+        bool swapRedBlue = false;               // Channel order other than the canvas
+        float aspect = 0.0f;                    // Display aspect (0 = source width / height)
+        LayerProperties properties;
+    };
+
+    /** Where a layer lands on the canvas */
+    struct Placement {
+        CPUImageKernels::AffineMap map;         // Canvas pixel -> source pixel
+        int x0 = 0, y0 = 0;                     // Canvas pixels covered, ends exclusive
+        int x1 = 0, y1 = 0;
+    };
+
+    /** Colour adjustment baked for 8-bit pixels */
+    struct ColorTable {
+        int size = 0;                           // Points per axis (as the ColorLut)
+        std::vector<uint16_t> data;             // size^3 RGB, 6 fractional bits, red fastest
+        uint8_t index[256];                     // Lower table point of each 8-bit value
+        uint16_t weight[256];                   // Weight of the upper one (0-256)
+    };
+
+    SoftwareCompositor();
+    ~SoftwareCompositor();
+
+    SoftwareCompositor(const SoftwareCompositor&) = delete;
+    SoftwareCompositor& operator=(const SoftwareCompositor&) = delete;
+
+    /**
+     * Composite layers, bottom first, onto the canvas
+     * @param canvas width x height pixels, stride bytes per row
+     */
+    void composite(const std::vector<Layer>& layers, uint8_t* canvas, int width, int height, int stride);
+
+    /**
+     * Canvas map and bounds of a layer
+     * @return false if nothing of it is on the canvas
+     */
+    static bool place(const Layer& layer, int canvasWidth, int canvasHeight, Placement& placement);
+
+    /**
+     * Blend n straight-alpha pixels over opaque ones (the canvas alpha
+     * stays opaque)
+     * @param opacity256 Layer opacity, 0-256
+     */
+    static void blendRow(const uint8_t* source, uint8_t* canvas, int n, int opacity256,
+                         LayerProperties::BlendMode mode, CPUImageKernels::Isa isa);
+
+    /** Colour table of an adjustment and optional calibration table */
+    static void bakeTable(const ColorLut& lut, ColorTable& table);
+
+    /**
+     * Look up n pixels in place
+     * @param redFirst Red is byte 0 (RGBA) rather than byte 2 (BGRA)
+     */
+    static void applyTable(const ColorTable& table, uint8_t* pixels, int n, bool redFirst);
+
+    /** Swap bytes 0 and 2 of n pixels */
+    static void swapRedBlue(uint8_t* pixels, int n);
+
+    /** Canvas channel order: red is byte 0 (default BGRA) */
+    void setRedFirst(bool redFirst) { redFirst_ = redFirst; }
+
+private:
+    // Layer ready to draw: placement and colour table resolved
+    struct Prepared {
+        const Layer* layer = nullptr;
+        Placement placement;
+        const ColorTable* table = nullptr;
+        int opacity256 = 256;
+    };
+
+    const ColorTable* table(const LayerProperties::ColorAdjustment& adjust);
+    void compositeRows(int firstRow, int endRow, uint8_t* canvas, int width, int stride);
+
+    using Key = std::tuple<float, float, float, float, float, std::string>;
+    std::map<Key, std::unique_ptr<ColorTable>> tables_;
+    std::map<std::string, std::unique_ptr<ColorLut>> cubes_;   // nullptr = failed to load
+    std::vector<Prepared> prepared_;
+    bool redFirst_ = false;
+    CPUImageKernels::Isa isa_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SOFTWARECOMPOSITOR_H
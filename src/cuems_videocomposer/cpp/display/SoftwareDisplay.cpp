@@ -0,0 +1,231 @@
+/**
+ * SoftwareDisplay.cpp - CPU-only rendering implementation
+ */
+
+#include "SoftwareDisplay.h"
+#include "CaptureConverter.h"
+#include "../layer/LayerManager.h"
+#include "../layer/VideoLayer.h"
+#include "../output/FrameCapture.h"
+#include "../output/OutputSinkManager.h"
+#include "../video/SliceScaler.h"
+#include "../utils/Logger.h"
+#include "../utils/TimeUtils.h"
+
+#include <cstring>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace videocomposer {
+
+SoftwareDisplay::SoftwareDisplay() {
+}
+
+SoftwareDisplay::~SoftwareDisplay() {
+    closeWindow();
+}
+
+bool SoftwareDisplay::openWindow() {
+    if (initialized_) {
+        LOG_WARNING << "SoftwareDisplay: Already initialized";
+        return true;
+    }
+    if (width_ <= 0 || height_ <= 0) {
+        LOG_ERROR << "SoftwareDisplay: Invalid size " << width_ << "x" << height_;
+        return false;
+    }
+
+    canvas_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+    initialized_ = true;
+    LOG_INFO << "SoftwareDisplay: Compositing " << width_ << "x" << height_ << " on the CPU ("
+             << CPUImageKernels::isaName(CPUImageKernels::activeIsa()) << ", "
+             << CPUImageKernels::getConcurrency() << " threads)";
+    return true;
+}
+
+void SoftwareDisplay::closeWindow() {
+    scalers_.clear();
+    canvas_.clear();
+    canvas_.shrink_to_fit();
+    initialized_ = false;
+}
+
+void SoftwareDisplay::render(LayerManager* layerManager, OSDManager* osdManager) {
+    (void)osdManager;  // No OSD without GL
+
+    if (!initialized_) {
+        return;
+    }
+
+    layers_.clear();
+    if (layerManager) {
+        std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+        // Entries are top first, the compositor draws bottom first
+        for (auto it = scene->entries.rbegin(); it != scene->entries.rend(); ++it) {
+            const SceneSnapshot::Entry& entry = *it;
+            const LayerProperties& props = entry.properties;
+            if (!entry.layer || !entry.ready || !props.visible || props.opacity <= 0.0f) {
+                continue;
+            }
+            if (props.packedAlpha != PackedAlpha::Layout::NONE) {
+                warnOnce(entry.layerId, "packed alpha");
+                continue;
+            }
+
+            const FrameBuffer* cpuBuffer = nullptr;
+            const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+            if (entry.layer->getPreparedFrame(cpuBuffer, gpuBuffer)) {
+                warnOnce(entry.layerId, "frame on the GPU");
+                continue;
+            }
+            if (!cpuBuffer || !cpuBuffer->isValid()) {
+                continue;
+            }
+            const FrameInfo& info = cpuBuffer->info();
+            if (info.format != PixelFormat::BGRA32 && info.format != PixelFormat::RGBA32) {
+                warnOnce(entry.layerId, "pixel format (needs packed BGRA or RGBA)");
+                continue;
+            }
+
+            SoftwareCompositor::Layer layer;
+            layer.source.data = cpuBuffer->data();
+            layer.source.width = info.width;
+            layer.source.height = info.height;
+            layer.source.stride = cpuBuffer->stride(0) > 0 ? cpuBuffer->stride(0) : info.width * 4;
+            layer.swapRedBlue = info.format == PixelFormat::RGBA32;
+            layer.aspect = entry.layer->getFrameInfo().aspect;   // As the renderer's letterbox
+            layer.properties = props;
+            layers_.push_back(layer);
+        }
+    }
+
+    compositor_.composite(layers_, canvas_.data(), width_, height_, width_ * 4);
+    ++frameNumber_;
+
+    if (captureEnabled_ && outputSinkManager_) {
+        writeOutputs();
+    }
+}
+
+void SoftwareDisplay::setCaptureEnabled(bool enabled, int width, int height) {
+    (void)width; (void)height;  // Always the canvas size
+    captureEnabled_ = enabled;
+    if (!enabled) {
+        scalers_.clear();
+    }
+}
+
+void SoftwareDisplay::writeOutputs() {
+    std::vector<CaptureFormat> formats = outputSinkManager_->getCaptureFormats();
+    if (formats.empty()) {
+        return;
+    }
+    if (scalers_.size() < formats.size()) {
+        scalers_.resize(formats.size());
+    }
+
+    int64_t now = vc_get_monotonic_time();
+    for (size_t i = 0; i < formats.size(); ++i) {
+        const CaptureFormat& format = formats[i];
+        int width = 0, height = 0;
+        CaptureConverter::frameSize(format, width_, height_, width, height);
+        if (!CaptureConverter::supports(format.format) || width <= 0 || height <= 0) {
+            continue;
+        }
+
+        FrameData frame;
+        frame.size = FrameData::frameSize(format.format, width, height);
+        frame.data = new uint8_t[frame.size];
+        frame.ownsData = true;
+        frame.width = width;
+        frame.height = height;
+        frame.format = format.format;
+        frame.timestamp = now;
+        frame.frameNumber = frameNumber_;
+
+        if (format.format == PixelFormat::BGRA32 && width == width_ && height == height_) {
+            std::memcpy(frame.data, canvas_.data(), frame.size);
+        } else if (!convert(i, format, width, height, frame.data)) {
+            continue;
+        }
+        outputSinkManager_->writeFrameToFormat(std::move(frame), format);
+    }
+}
+
+bool SoftwareDisplay::convert(size_t index, const CaptureFormat& format, int width, int height, uint8_t* data) {
+    // Planes back to back, as FrameData::frameSize counts them
+    size_t luma = static_cast<size_t>(width) * height;
+    size_t chroma = static_cast<size_t>(width / 2) * (height / 2);
+    uint8_t* dst[4] = {data, nullptr, nullptr, nullptr};
+    int dstStride[4] = {0, 0, 0, 0};
+    AVPixelFormat dstFormat = AV_PIX_FMT_NONE;
+    switch (format.format) {
+        case PixelFormat::RGBA32:
+        case PixelFormat::BGRA32:
+            dstFormat = format.format == PixelFormat::RGBA32 ? AV_PIX_FMT_RGBA : AV_PIX_FMT_BGRA;
+            dstStride[0] = width * 4;
+            break;
+        case PixelFormat::UYVY422:
+            dstFormat = AV_PIX_FMT_UYVY422;
+            dstStride[0] = width * 2;
+            break;
+        case PixelFormat::NV12:
+            dstFormat = AV_PIX_FMT_NV12;
+            dst[1] = data + luma;
+            dstStride[0] = width;
+            dstStride[1] = (width / 2) * 2;
+            break;
+        case PixelFormat::YUV420P:
+            dstFormat = AV_PIX_FMT_YUV420P;
+            dst[1] = data + luma;
+            dst[2] = data + luma + chroma;
+            dstStride[0] = width;
+            dstStride[1] = width / 2;
+            dstStride[2] = width / 2;
+            break;
+        default:
+            return false;
+    }
+
+    if (!scalers_[index]) {
+        scalers_[index] = std::make_unique<SliceScaler>();
+    }
+    const uint8_t* src[4] = {canvas_.data(), nullptr, nullptr, nullptr};
+    int srcStride[4] = {width_ * 4, 0, 0, 0};
+    if (!scalers_[index]->scale(src, srcStride, width_, height_, AV_PIX_FMT_BGRA,
+                                dst, dstStride, width, height, dstFormat, SWS_BILINEAR)) {
+        LOG_WARNING << "SoftwareDisplay: No conversion to capture format " << static_cast<int>(format.format);
+        return false;
+    }
+    return true;
+}
+
+void SoftwareDisplay::warnOnce(int layerId, const char* reason) {
+    if (warnedLayers_.insert(layerId).second) {
+        LOG_WARNING << "SoftwareDisplay: Layer " << layerId << " not composited: " << reason;
+    }
+}
+
+void SoftwareDisplay::resize(unsigned int width, unsigned int height) {
+    if (width == 0 || height == 0) {
+        return;
+    }
+    if (static_cast<int>(width) == width_ && static_cast<int>(height) == height_) {
+        return;
+    }
+
+    width_ = static_cast<int>(width);
+    height_ = static_cast<int>(height);
+    if (initialized_) {
+        canvas_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+    }
+}
+
+void SoftwareDisplay::getWindowSize(unsigned int* width, unsigned int* height) const {
+    *width = static_cast<unsigned int>(width_);
+    *height = static_cast<unsigned int>(height_);
+}
+
+} // namespace videocomposer
@@ -0,0 +1,104 @@
+/**
+ * SoftwareDisplay.h - CPU-only rendering backend for nodes without a GPU
+ *
+ * The fallback when no EGL context can be had (VMs and servers without a
+ * render node), or forced with VIDEOCOMPOSER_HEADLESS=software. The layers
+ * are composited by SoftwareCompositor into a BGRA canvas in memory, which
+ * feeds the virtual outputs (NDI, streams, recording) directly.
+ */
+
+#ifndef VIDEOCOMPOSER_SOFTWAREDISPLAY_H
+#define VIDEOCOMPOSER_SOFTWAREDISPLAY_H
+
+#include "DisplayBackend.h"
+#include "SoftwareCompositor.h"
+#include "../output/OutputSink.h"
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace videocomposer {
+
+class OutputSinkManager;
+class SliceScaler;
+
+/**
+ * SoftwareDisplay - Headless composite on the CPU
+ *
+ * No GL context and no renderer (getRenderer() is null), so layers decode
+ * to packed BGRA/RGBA in memory. Frames left on the GPU, HAP and planar
+ * YUV layers cannot be composited and are skipped (logged once per
+ * layer); groups and the master transform are not applied, members are
+ * composited straight onto the canvas. No OSD.
+ */
+class SoftwareDisplay : public DisplayBackend {
+public:
+    SoftwareDisplay();
+    ~SoftwareDisplay() override;
+
+    // ===== DisplayBackend Interface =====
+
+    bool openWindow() override;
+    void closeWindow() override;
+    bool isWindowOpen() const override { return initialized_; }
+
+    void render(LayerManager* layerManager, OSDManager* osdManager = nullptr) override;
+    void handleEvents() override {}  // No events without a window
+
+    void resize(unsigned int width, unsigned int height) override;
+    void getWindowSize(unsigned int* width, unsigned int* height) const override;
+
+    void setPosition(int x, int y) override { (void)x; (void)y; }
+    void getWindowPos(int* x, int* y) const override { *x = 0; *y = 0; }
+
+    void setFullscreen(int action) override { (void)action; }
+    bool getFullscreen() const override { return true; }
+
+    void setOnTop(int action) override { (void)action; }
+    bool getOnTop() const override { return false; }
+
+    bool supportsMultiDisplay() const override { return false; }
+
+    // The canvas goes to the CPU sinks, converted to each capture format
+    void setCaptureEnabled(bool enabled, int width = 0, int height = 0) override;
+    bool isCaptureEnabled() const override { return captureEnabled_; }
+    void setOutputSinkManager(OutputSinkManager* sinkManager) override { outputSinkManager_ = sinkManager; }
+
+    // ===== Software-Specific Methods =====
+
+    /**
+     * Set render dimensions
+     * Call before openWindow() to set initial size
+     */
+    void setDimensions(int width, int height) {
+        width_ = width;
+        height_ = height;
+    }
+
+    /** Last composite: BGRA, width x height, 4 * width bytes per row */
+    const uint8_t* getCanvas() const { return canvas_.data(); }
+
+private:
+    void writeOutputs();
+    bool convert(size_t index, const CaptureFormat& format, int width, int height, uint8_t* data);
+    void warnOnce(int layerId, const char* reason);
+
+    SoftwareCompositor compositor_;
+    std::vector<SoftwareCompositor::Layer> layers_;
+    std::vector<uint8_t> canvas_;
+    std::vector<std::unique_ptr<SliceScaler>> scalers_;   // One per capture format
+    std::set<int> warnedLayers_;
+
+    int width_ = 1920;
+    int height_ = 1080;
+    int64_t frameNumber_ = 0;
+
+    bool initialized_ = false;
+    OutputSinkManager* outputSinkManager_ = nullptr;
+    bool captureEnabled_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SOFTWAREDISPLAY_H
@@ -0,0 +1,214 @@
+#include "SyncLatencyMonitor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr int64_t PHOTON_WINDOW_NS = 200000000;  // Edges later than this after a flip are unmatched
+
+double nearestRank(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+std::string formatStats(const char* name, const SyncLatencyMonitor::LatencyStats& stats) {
+    char line[160];
+    if (stats.samples == 0) {
+        std::snprintf(line, sizeof(line), "%s: no samples", name);
+    } else {
+        std::snprintf(line, sizeof(line), "%s: %.2f ms mean, %.2f p50, %.2f p99, %.2f..%.2f (%zu)",
+                      name, stats.meanMs, stats.p50Ms, stats.p99Ms, stats.minMs, stats.maxMs, stats.samples);
+    }
+    return line;
+}
+
+} // namespace
+
+void SyncLatencyMonitor::Samples::add(double value) {
+    if (values.size() < WINDOW) {
+        values.push_back(value);
+    } else {
+        values[next] = value;
+    }
+    next = (next + 1) % WINDOW;
+}
+
+SyncLatencyMonitor::LatencyStats SyncLatencyMonitor::Samples::stats() const {
+    LatencyStats out;
+    if (values.empty()) {
+        return out;
+    }
+    std::vector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double value : sorted) {
+        total += value;
+    }
+    out.samples = sorted.size();
+    out.meanMs = total / sorted.size();
+    out.p50Ms = nearestRank(sorted, 0.5);
+    out.p99Ms = nearestRank(sorted, 0.99);
+    out.minMs = sorted.front();
+    out.maxMs = sorted.back();
+    return out;
+}
+
+SyncLatencyMonitor::SyncLatencyMonitor()
+    : refreshHz_(60.0)
+    , fps_(25.0)
+{
+    reset();
+}
+
+void SyncLatencyMonitor::configure(double refreshHz, double fps) {
+    if (refreshHz > 0.0) {
+        refreshHz_ = refreshHz;
+    }
+    if (fps > 0.0) {
+        fps_ = fps;
+    }
+}
+
+void SyncLatencyMonitor::recordPlan(int64_t msc, int64_t frame) {
+    plans_[nextPlan_] = Plan{msc, frame};
+    nextPlan_ = (nextPlan_ + 1) % PLAN_HISTORY;
+}
+
+void SyncLatencyMonitor::restartCadence(const PresentedFrame& frame) {
+    cadenceStartMsc_ = frame.msc;
+    cadenceStartTag_ = frame.tag;
+}
+
+void SyncLatencyMonitor::recordPresented(const PresentedFrame& frame, int64_t syncFrameTimeUs) {
+    if (frame.tag < 0) {
+        report_.unknown++;
+        return;
+    }
+    if (frame.tag == lastTag_) {
+        return;  // Same frame flipped again: its hold goes on
+    }
+
+    bool patchToggled = true;
+    if (lastTag_ < 0) {
+        restartCadence(frame);
+    } else {
+        int64_t step = frame.tag - lastTag_;
+        int64_t hold = frame.msc - lastChangeMsc_;
+        patchToggled = (step % 2) != 0;
+        if (step > 0 && step <= MAX_SKIP && hold > 0) {
+            double ratio = refreshHz_ / fps_;
+            report_.holds[static_cast<size_t>(std::min<int64_t>(hold, MAX_HOLD))]++;
+            report_.totalHolds++;
+            if (hold == static_cast<int64_t>(std::floor(ratio)) || hold == static_cast<int64_t>(std::ceil(ratio))) {
+                report_.correctHolds++;
+            }
+            report_.skipped += step - 1;
+            double expected = (frame.tag - cadenceStartTag_) * ratio;
+            double error = std::fabs(static_cast<double>(frame.msc - cadenceStartMsc_) - expected);
+            report_.maxPhaseError = std::max(report_.maxPhaseError, error);
+        } else {
+            if (step < 0 && step >= -MAX_SKIP) {
+                report_.backwards++;
+            } else {
+                report_.locates++;
+            }
+            restartCadence(frame);
+        }
+    }
+    report_.frames++;
+    lastTag_ = frame.tag;
+    lastChangeMsc_ = frame.msc;
+
+    if (syncFrameTimeUs >= 0) {
+        latency_.add((frame.flipNs / 1000 - syncFrameTimeUs) / 1000.0);
+        report_.latencyFromClock = true;
+    } else {
+        // Latest plan for this frame: how many vsyncs it came late
+        for (size_t i = 1; i <= PLAN_HISTORY; ++i) {
+            const Plan& plan = plans_[(nextPlan_ + PLAN_HISTORY - i) % PLAN_HISTORY];
+            if (plan.frame == frame.tag) {
+                latency_.add((frame.msc - plan.msc) * 1000.0 / refreshHz_);
+                break;
+            }
+        }
+    }
+
+    if (patchToggled) {
+        patchFlips_[nextPatchFlip_] = frame.flipNs;
+        nextPatchFlip_ = (nextPatchFlip_ + 1) % patchFlips_.size();
+    }
+}
+
+bool SyncLatencyMonitor::recordPhotodiodeEdge(int64_t timeNs) {
+    // The edge belongs to the latest toggle before it, matched once
+    int64_t latest = 0;
+    for (int64_t flipNs : patchFlips_) {
+        if (flipNs > 0 && flipNs <= timeNs) {
+            latest = std::max(latest, flipNs);
+        }
+    }
+    if (latest == 0 || latest == matchedPatchFlip_ || timeNs - latest > PHOTON_WINDOW_NS) {
+        return false;
+    }
+    photon_.add((timeNs - latest) / 1e6);
+    matchedPatchFlip_ = latest;
+    return true;
+}
+
+SyncLatencyMonitor::Report SyncLatencyMonitor::getReport() const {
+    Report report = report_;
+    report.latency = latency_.stats();
+    report.photon = photon_.stats();
+    return report;
+}
+
+std::vector<std::string> SyncLatencyMonitor::formatReport() const {
+    Report report = getReport();
+    std::vector<std::string> lines;
+    char line[160];
+
+    std::snprintf(line, sizeof(line), "%.3f fps on %.3f Hz: %lld frames, %lld skipped, %lld backwards, %lld locates, %lld unknown",
+                  fps_, refreshHz_, static_cast<long long>(report.frames), static_cast<long long>(report.skipped),
+                  static_cast<long long>(report.backwards), static_cast<long long>(report.locates),
+                  static_cast<long long>(report.unknown));
+    lines.push_back(line);
+
+    std::string holds = "Holds:";
+    for (int hold = 1; hold <= MAX_HOLD; ++hold) {
+        if (report.holds[hold] > 0) {
+            std::snprintf(line, sizeof(line), " %d%s=%lld", hold, hold == MAX_HOLD ? "+" : "",
+                          static_cast<long long>(report.holds[hold]));
+            holds += line;
+        }
+    }
+    lines.push_back(report.totalHolds > 0 ? holds : "Holds: none");
+
+    double correct = report.totalHolds > 0 ? 100.0 * report.correctHolds / report.totalHolds : 0.0;
+    std::snprintf(line, sizeof(line), "Cadence: %.1f%% correct, max phase error %.2f vsyncs",
+                  correct, report.maxPhaseError);
+    lines.push_back(line);
+
+    lines.push_back(formatStats(report.latencyFromClock ? "Sync to flip" : "Planned vsync to flip", report.latency));
+    lines.push_back(formatStats("Flip to photon", report.photon));
+    return lines;
+}
+
+void SyncLatencyMonitor::reset() {
+    plans_.fill(Plan{});
+    nextPlan_ = 0;
+    lastTag_ = -1;
+    lastChangeMsc_ = 0;
+    cadenceStartMsc_ = 0;
+    cadenceStartTag_ = 0;
+    patchFlips_.fill(0);
+    nextPatchFlip_ = 0;
+    matchedPatchFlip_ = 0;
+    report_ = Report{};
+    latency_ = Samples{};
+    photon_ = Samples{};
+}
+
+} // namespace videocomposer
@@ -0,0 +1,145 @@
+#ifndef VIDEOCOMPOSER_SYNCLATENCYMONITOR_H
+#define VIDEOCOMPOSER_SYNCLATENCYMONITOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * A buffer that reached the screen, as reported by the page flip event
+ */
+struct PresentedFrame {
+    int64_t flipNs = 0;     // Flip timestamp (monotonic nanoseconds)
+    int64_t msc = 0;        // Vsync counter of the flip
+    int64_t tag = -1;       // Frame number the buffer shows (-1 = unknown)
+};
+
+/**
+ * SyncLatencyMonitor - Which frame was on screen at each vsync, against
+ * the sync source
+ *
+ * Fed the presented frames of the sync test (frame numbers taken from the
+ * test pattern), it measures:
+ * - cadence: vsyncs each frame stayed on screen. At 25 fps on 60 Hz the
+ *   holds must be 2 or 3 in the 2-3 pattern, so a hold is correct when it
+ *   is the floor or ceiling of refresh / fps, and the phase error is the
+ *   drift of the running vsync count from the ideal one;
+ * - skipped frames (a step of more than one) and frames going backwards;
+ *   a step beyond MAX_SKIP is a locate and restarts the cadence;
+ * - latency from the sync source to the flip, when the source knows when
+ *   its timecode reached a frame (SyncSource::getFrameTime), otherwise
+ *   to the vsync the frame was planned for (recordPlan);
+ * - photon latency from the flip to a photodiode edge on the patch.
+ *
+ * Not thread-safe: used from the main loop.
+ */
+class SyncLatencyMonitor {
+public:
+    static constexpr size_t WINDOW = 4096;      // Latency samples kept
+    static constexpr int MAX_HOLD = 8;          // Longer holds share the last bucket
+    static constexpr int64_t MAX_SKIP = 8;      // Larger steps are locates
+    static constexpr size_t PLAN_HISTORY = 64;  // Planned frames kept for matching
+
+    struct LatencyStats {
+        size_t samples = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    struct Report {
+        int64_t frames = 0;                         // Frame changes seen
+        int64_t unknown = 0;                        // Flips without a frame number
+        std::array<int64_t, MAX_HOLD + 1> holds{};  // Holds by vsync count (index 0 unused)
+        int64_t correctHolds = 0;
+        int64_t totalHolds = 0;
+        double maxPhaseError = 0.0;                 // Vsyncs, either direction
+        int64_t skipped = 0;                        // Frames never shown
+        int64_t backwards = 0;                      // Steps to an earlier frame
+        int64_t locates = 0;
+        bool latencyFromClock = false;              // Latency against the timecode, not the plan
+        LatencyStats latency;                       // Timecode (or planned vsync) to flip
+        LatencyStats photon;                        // Flip to photodiode edge
+    };
+
+    SyncLatencyMonitor();
+
+    /**
+     * Set the display refresh and the frame rate of the sync source
+     */
+    void configure(double refreshHz, double fps);
+
+    /**
+     * Record the frame a render targets to appear at vsync msc
+     */
+    void recordPlan(int64_t msc, int64_t frame);
+
+    /**
+     * Record a flip
+     * @param frame The flip
+     * @param syncFrameTimeUs When the sync source reached frame.tag
+     *        (monotonic microseconds), or -1 if it cannot tell
+     */
+    void recordPresented(const PresentedFrame& frame, int64_t syncFrameTimeUs);
+
+    /**
+     * Record a level change of the photodiode on the patch
+     * @param timeNs Monotonic nanoseconds
+     * @return true if it was matched to a flip
+     */
+    bool recordPhotodiodeEdge(int64_t timeNs);
+
+    Report getReport() const;
+
+    /** Report as log lines */
+    std::vector<std::string> formatReport() const;
+
+    /** Clear the statistics, keeping the configuration */
+    void reset();
+
+private:
+    struct Plan {
+        int64_t msc = 0;
+        int64_t frame = -1;
+    };
+
+    struct Samples {
+        std::vector<double> values;
+        size_t next = 0;
+
+        void add(double value);
+        LatencyStats stats() const;
+    };
+
+    void restartCadence(const PresentedFrame& frame);
+
+    double refreshHz_;
+    double fps_;
+
+    std::array<Plan, PLAN_HISTORY> plans_;
+    size_t nextPlan_;
+
+    int64_t lastTag_;
+    int64_t lastChangeMsc_;
+    int64_t cadenceStartMsc_;
+    int64_t cadenceStartTag_;
+
+    // Flips that toggled the photodiode patch, for edge matching
+    std::array<int64_t, 16> patchFlips_;
+    size_t nextPatchFlip_;
+    int64_t matchedPatchFlip_;
+
+    Report report_;
+    Samples latency_;
+    Samples photon_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SYNCLATENCYMONITOR_H
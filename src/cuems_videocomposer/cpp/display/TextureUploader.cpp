@@ -0,0 +1,506 @@
+#include "TextureUploader.h"
+#include "../utils/Logger.h"
+#include <GL/glew.h>  // Must be included before GL/gl.h
+#include <GL/gl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+
+namespace videocomposer {
+
+TextureUploader::TextureUploader()
+    : running_(false)
+    , stop_(false)
+    , initState_(0)
+{
+}
+
+TextureUploader::~TextureUploader() {
+    shutdown();
+}
+
+#ifdef HAVE_EGL
+bool TextureUploader::init(EGLDisplay display, EGLContext shareContext) {
+    if (running_) {
+        return true;
+    }
+    if (display == EGL_NO_DISPLAY || shareContext == EGL_NO_CONTEXT) {
+        LOG_WARNING << "TextureUploader: No EGL render context to share with";
+        return false;
+    }
+
+    display_ = display;
+    shareContext_ = shareContext;
+    stop_ = false;
+    initState_ = 0;
+
+    // The context is created on the worker: eglBindAPI is per thread
+    workerThread_ = std::make_unique<std::thread>(&TextureUploader::workerThreadFunc, this);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCond_.wait(lock, [this] { return initState_ != 0; });
+    if (initState_ < 0) {
+        lock.unlock();
+        workerThread_->join();
+        workerThread_.reset();
+        return false;
+    }
+
+    running_ = true;
+    LOG_INFO << "TextureUploader: Upload thread running (shared EGL context)";
+    return true;
+}
+
+bool TextureUploader::createContext() {
+    EGLint clientType = EGL_OPENGL_API;
+    eglQueryContext(display_, shareContext_, EGL_CONTEXT_CLIENT_TYPE, &clientType);
+    if (!eglBindAPI(clientType == EGL_OPENGL_ES_API ? EGL_OPENGL_ES_API : EGL_OPENGL_API)) {
+        LOG_ERROR << "TextureUploader: Failed to bind GL API";
+        return false;
+    }
+
+    // Shared contexts must use a compatible config: reuse the render context's
+    EGLint configId = 0;
+    eglQueryContext(display_, shareContext_, EGL_CONFIG_ID, &configId);
+    EGLint configAttribs[] = { EGL_CONFIG_ID, configId, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display_, configAttribs, &config, 1, &numConfigs) || numConfigs < 1) {
+        LOG_ERROR << "TextureUploader: Failed to find the render context's EGL config";
+        return false;
+    }
+
+    EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context_ = eglCreateContext(display_, config, shareContext_, contextAttribs);
+    if (context_ == EGL_NO_CONTEXT) {
+        // Try simpler context
+        EGLint simpleAttribs[] = { EGL_NONE };
+        context_ = eglCreateContext(display_, config, shareContext_, simpleAttribs);
+    }
+    if (context_ == EGL_NO_CONTEXT) {
+        LOG_ERROR << "TextureUploader: eglCreateContext failed: 0x" << std::hex << eglGetError() << std::dec;
+        return false;
+    }
+
+    // No drawing happens here: surfaceless if possible, else a 1x1 pbuffer
+    const char* extensions = eglQueryString(display_, EGL_EXTENSIONS);
+    bool hasSurfaceless = extensions && strstr(extensions, "EGL_KHR_surfaceless_context");
+    if (!hasSurfaceless) {
+        EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface_ = eglCreatePbufferSurface(display_, config, pbufferAttribs);
+        if (surface_ == EGL_NO_SURFACE) {
+            LOG_ERROR << "TextureUploader: No surfaceless context and pbuffer creation failed";
+            destroyContext();
+            return false;
+        }
+    }
+
+    if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+        LOG_ERROR << "TextureUploader: eglMakeCurrent failed: 0x" << std::hex << eglGetError() << std::dec;
+        destroyContext();
+        return false;
+    }
+    return true;
+}
+
+void TextureUploader::destroyContext() {
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface_ != EGL_NO_SURFACE) {
+        eglDestroySurface(display_, surface_);
+        surface_ = EGL_NO_SURFACE;
+    }
+    if (context_ != EGL_NO_CONTEXT) {
+        eglDestroyContext(display_, context_);
+        context_ = EGL_NO_CONTEXT;
+    }
+    eglReleaseThread();
+}
+#endif
+
+void TextureUploader::shutdown() {
+    if (!workerThread_) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCond_.notify_all();
+    if (workerThread_->joinable()) {
+        workerThread_->join();
+    }
+    workerThread_.reset();
+    running_ = false;
+
+    // Fences of uploads nobody waited for (render context is current here)
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& pair : jobs_) {
+        if (pair.second->done && pair.second->ok && pair.second->result.fence) {
+            glDeleteSync(pair.second->result.fence);
+        }
+    }
+    jobs_.clear();
+}
+
+void TextureUploader::submit(int layerId, const FrameBuffer& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_ || jobs_.count(layerId)) {
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->layerId = layerId;
+    job->frame = &frame;
+    jobs_[layerId] = job;
+    queue_.push_back(job);
+    workCond_.notify_one();
+}
+
+bool TextureUploader::wait(int layerId, const FrameBuffer& frame, Texture& texture) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        return false;
+    }
+
+    auto it = jobs_.find(layerId);
+    if (it != jobs_.end() && it->second->frame != &frame) {
+        // Queued for a different buffer: let it finish, then drop it
+        std::shared_ptr<Job> stale = it->second;
+        doneCond_.wait(lock, [&stale] { return stale->done; });
+        if (stale->ok && stale->result.fence) {
+            glDeleteSync(stale->result.fence);
+        }
+        jobs_.erase(layerId);
+        it = jobs_.end();
+    }
+
+    if (it == jobs_.end()) {
+        auto job = std::make_shared<Job>();
+        job->layerId = layerId;
+        job->frame = &frame;
+        it = jobs_.emplace(layerId, job).first;
+        queue_.push_back(job);
+        workCond_.notify_one();
+    }
+
+    std::shared_ptr<Job> job = it->second;
+    if (!job->done) {
+        stats_.waits++;
+        doneCond_.wait(lock, [&job] { return job->done; });
+    }
+    jobs_.erase(layerId);
+
+    if (!job->ok) {
+        return false;
+    }
+    texture = job->result;
+    return true;
+}
+
+void TextureUploader::release(int layerId, const Texture& texture) {
+    if (texture.slot < 0 || texture.slot >= SLOTS) {
+        return;
+    }
+
+    // The worker must not overwrite the texture before these draws are done
+    GLsync readFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();  // Make the fence visible to the upload context
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = layers_.find(layerId);
+    if (it == layers_.end() || it->second.texture[texture.slot] != texture.textureId) {
+        glDeleteSync(readFence);
+        return;
+    }
+    GLsync& slotFence = it->second.readFence[texture.slot];
+    if (slotFence) {
+        glDeleteSync(slotFence);
+    }
+    slotFence = readFence;
+}
+
+void TextureUploader::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCond_.wait(lock, [this] {
+        for (const auto& pair : jobs_) {
+            if (!pair.second->done) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    // Uploads for layers that were not drawn this frame
+    for (auto& pair : jobs_) {
+        if (pair.second->ok && pair.second->result.fence) {
+            glDeleteSync(pair.second->result.fence);
+        }
+    }
+    jobs_.clear();
+}
+
+void TextureUploader::retainLayers(const std::vector<int>& layerIds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool removed = false;
+    for (const auto& pair : layers_) {
+        if (std::find(layerIds.begin(), layerIds.end(), pair.first) != layerIds.end()) {
+            continue;
+        }
+        if (std::find(removedLayers_.begin(), removedLayers_.end(), pair.first) == removedLayers_.end()) {
+            removedLayers_.push_back(pair.first);
+            removed = true;
+        }
+    }
+    if (removed) {
+        workCond_.notify_one();
+    }
+}
+
+TextureUploader::Stats TextureUploader::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool TextureUploader::ensureSlots(LayerSlots& slots, int layerId, int width, int height) {
+    if (slots.texture[0] != 0 && slots.width == width && slots.height == height) {
+        return true;
+    }
+    deleteSlots(slots);
+
+    // Textures and buffers are the same size: charged once to each subsystem
+    size_t bufferSize = static_cast<size_t>(width) * height * 4;
+    MemoryBudget& budget = MemoryBudget::instance();
+    MemoryBudget::Account textures(MemoryBudget::Subsystem::LAYER_TEXTURES, layerId);
+    MemoryBudget::Account buffers(MemoryBudget::Subsystem::UPLOAD_BUFFERS, layerId);
+    if (!budget.reserve(textures, bufferSize * SLOTS)) {
+        LOG_DEBUG << "TextureUploader: Upload textures of layer " << layerId << " refused by the memory budget";
+        return false;
+    }
+    if (!budget.reserve(buffers, bufferSize * SLOTS)) {
+        budget.release(textures, bufferSize * SLOTS);
+        LOG_DEBUG << "TextureUploader: Upload buffers of layer " << layerId << " refused by the memory budget";
+        return false;
+    }
+    slots.layerId = layerId;
+    slots.chargedBytes = bufferSize * SLOTS;
+
+    glGenTextures(SLOTS, slots.texture);
+    glGenBuffers(SLOTS, slots.pbo);
+    for (int i = 0; i < SLOTS; ++i) {
+        if (slots.texture[i] == 0 || slots.pbo[i] == 0) {
+            LOG_ERROR << "TextureUploader: Failed to create upload textures";
+            deleteSlots(slots);
+            return false;
+        }
+        glBindTexture(GL_TEXTURE_2D, slots.texture[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0,
+                     GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots.pbo[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    slots.width = width;
+    slots.height = height;
+    slots.next = 0;
+
+    LOG_DEBUG << "TextureUploader: Allocated upload textures (" << width << "x" << height << ")";
+    return true;
+}
+
+void TextureUploader::deleteSlots(LayerSlots& slots) {
+    GLsync readFences[SLOTS];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < SLOTS; ++i) {
+            readFences[i] = slots.readFence[i];
+            slots.readFence[i] = nullptr;
+        }
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        if (readFences[i]) {
+            // Deleting a texture still being sampled is deferred by GL, but
+            // the fence itself has to go
+            glDeleteSync(readFences[i]);
+        }
+    }
+    if (slots.texture[0] != 0 || slots.texture[1] != 0) {
+        glDeleteTextures(SLOTS, slots.texture);
+    }
+    if (slots.pbo[0] != 0 || slots.pbo[1] != 0) {
+        glDeleteBuffers(SLOTS, slots.pbo);
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        slots.texture[i] = 0;
+        slots.pbo[i] = 0;
+    }
+    slots.width = 0;
+    slots.height = 0;
+    if (slots.chargedBytes > 0) {
+        MemoryBudget& budget = MemoryBudget::instance();
+        budget.release(MemoryBudget::Account(MemoryBudget::Subsystem::LAYER_TEXTURES, slots.layerId),
+                       slots.chargedBytes);
+        budget.release(MemoryBudget::Account(MemoryBudget::Subsystem::UPLOAD_BUFFERS, slots.layerId),
+                       slots.chargedBytes);
+        slots.chargedBytes = 0;
+    }
+}
+
+bool TextureUploader::upload(Job& job) {
+    const FrameInfo& info = job.frame->info();
+    int width = info.width;
+    int height = info.height;
+    size_t dataSize = static_cast<size_t>(width) * height * 4;
+    if (width <= 0 || height <= 0 || !job.frame->isValid() || job.frame->size() < dataSize) {
+        return false;
+    }
+
+    LayerSlots* slots = nullptr;
+    {
+        // Only this thread inserts or erases entries, so the pointer stays valid
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots = &layers_[job.layerId];
+    }
+    if (!ensureSlots(*slots, job.layerId, width, height)) {
+        return false;
+    }
+
+    int slot = slots->next;
+    GLsync readFence = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readFence = slots->readFence[slot];
+        slots->readFence[slot] = nullptr;
+    }
+    if (readFence) {
+        // GPU-side wait: the previous draw from this texture must finish first
+        glWaitSync(readFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(readFence);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slots->pbo[slot]);
+    void* ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, dataSize,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!ptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        LOG_WARNING << "TextureUploader: Failed to map upload buffer";
+        return false;
+    }
+    memcpy(ptr, job.frame->data(), dataSize);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindTexture(GL_TEXTURE_2D, slots->texture[slot]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                    GL_BGRA, GL_UNSIGNED_BYTE, nullptr);  // offset 0 in PBO
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();  // Make the fence visible to the render context
+    if (!fence) {
+        return false;
+    }
+
+    job.result.textureId = slots->texture[slot];
+    job.result.fence = fence;
+    job.result.width = width;
+    job.result.height = height;
+    job.result.slot = slot;
+    slots->next = (slot + 1) % SLOTS;
+    return true;
+}
+
+void TextureUploader::workerThreadFunc() {
+#ifdef HAVE_EGL
+    bool contextOk = createContext();
+#else
+    bool contextOk = false;
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        initState_ = contextOk ? 1 : -1;
+    }
+    doneCond_.notify_all();
+    if (!contextOk) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (!queue_.empty()) {
+            std::shared_ptr<Job> job = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+            bool ok = upload(*job);
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            job->ok = ok;
+            job->done = true;
+            if (ok) {
+                stats_.uploads++;
+                stats_.lastUploadMs = ms;
+            }
+            doneCond_.notify_all();
+            continue;
+        }
+
+        if (!removedLayers_.empty()) {
+            int layerId = removedLayers_.front();
+            removedLayers_.pop_front();
+            auto it = layers_.find(layerId);
+            if (it != layers_.end()) {
+                LayerSlots slots = it->second;
+                layers_.erase(it);
+                lock.unlock();
+                deleteSlots(slots);
+                lock.lock();
+            }
+            continue;
+        }
+
+        workCond_.wait(lock, [this] { return stop_ || !queue_.empty() || !removedLayers_.empty(); });
+    }
+
+    // Fail anything still queued so no caller waits forever
+    for (auto& job : queue_) {
+        job->done = true;
+        job->ok = false;
+    }
+    queue_.clear();
+    doneCond_.notify_all();
+
+    std::map<int, LayerSlots> layers;
+    layers.swap(layers_);
+    lock.unlock();
+
+    for (auto& pair : layers) {
+        deleteSlots(pair.second);
+    }
+    glFinish();
+
+#ifdef HAVE_EGL
+    destroyContext();
+#endif
+}
+
+} // namespace videocomposer
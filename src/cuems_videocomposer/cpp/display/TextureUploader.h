@@ -0,0 +1,167 @@
+#ifndef VIDEOCOMPOSER_TEXTUREUPLOADER_H
+#define VIDEOCOMPOSER_TEXTUREUPLOADER_H
+
+#include "../video/FrameBuffer.h"
+#include "../video/MemoryBudget.h"
+#include <map>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#endif
+
+// Forward declarations for OpenGL types
+typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
+
+namespace videocomposer {
+
+/**
+ * TextureUploader - Uploads CPU-decoded frames on a dedicated thread
+ *
+ * The worker owns an EGL context shared with the render context. For each
+ * layer it keeps two texture/PBO pairs; an upload maps the PBO, copies the
+ * frame into it, streams it into the texture and hands the texture back with
+ * a fence. The render thread only queues the upload, waits on the GPU for the
+ * fence (glWaitSync) and draws.
+ *
+ * Frame data is read on the worker thread, so a submitted frame must stay
+ * untouched until wait() or drain() returns. OpenGLRenderer submits all CPU
+ * layers at the start of a composite and drains at the end, which keeps the
+ * copies overlapping with the drawing of the other layers.
+ *
+ * Texture reuse is fenced the other way as well: release() records a fence
+ * after the draw, and the worker waits for it before writing that texture
+ * again.
+ */
+class TextureUploader {
+public:
+    struct Texture {
+        GLuint textureId = 0;
+        GLsync fence = nullptr;  // Signalled when the upload is complete
+        int width = 0;
+        int height = 0;
+        int slot = -1;           // Internal texture slot (for release())
+    };
+
+    struct Stats {
+        uint64_t uploads = 0;     // Frames uploaded
+        uint64_t waits = 0;       // wait() calls that blocked on the worker
+        double lastUploadMs = 0.0;
+    };
+
+    TextureUploader();
+    ~TextureUploader();
+
+#ifdef HAVE_EGL
+    /**
+     * Create the shared context and start the worker thread
+     * @param display EGL display of the render context
+     * @param shareContext Render context to share textures with
+     * @return true if the upload thread is running
+     */
+    bool init(EGLDisplay display, EGLContext shareContext);
+#endif
+
+    /**
+     * Stop the worker and delete its textures (render context must stay alive)
+     */
+    void shutdown();
+
+    bool isRunning() const { return running_; }
+
+    /**
+     * Queue the upload of a layer's frame (no-op if one is already queued)
+     */
+    void submit(int layerId, const FrameBuffer& frame);
+
+    /**
+     * Wait for a layer's upload, submitting it first if needed
+     * @param texture Receives the uploaded texture; the caller must make the
+     *                GPU wait on texture.fence before sampling it
+     * @return false if the upload failed (caller falls back to its own path)
+     */
+    bool wait(int layerId, const FrameBuffer& frame, Texture& texture);
+
+    /**
+     * Hand a texture back after drawing with it
+     * Call on the render thread, after the draw commands are issued.
+     */
+    void release(int layerId, const Texture& texture);
+
+    /**
+     * Wait until no queued upload reads frame data anymore
+     */
+    void drain();
+
+    /**
+     * Drop the textures of every layer not in the list (removed layers)
+     */
+    void retainLayers(const std::vector<int>& layerIds);
+
+    Stats getStats() const;
+
+private:
+    static constexpr int SLOTS = 2;
+
+    struct LayerSlots {
+        GLuint texture[SLOTS] = {0, 0};
+        GLuint pbo[SLOTS] = {0, 0};
+        GLsync readFence[SLOTS] = {nullptr, nullptr};  // Set by release()
+        int width = 0;
+        int height = 0;
+        int next = 0;
+        int layerId = -1;
+        size_t chargedBytes = 0;  // To the memory budget, per subsystem
+    };
+
+    struct Job {
+        int layerId = 0;
+        const FrameBuffer* frame = nullptr;
+        bool done = false;
+        bool ok = false;
+        Texture result;
+    };
+
+    void workerThreadFunc();
+    bool upload(Job& job);
+    bool ensureSlots(LayerSlots& slots, int layerId, int width, int height);
+    void deleteSlots(LayerSlots& slots);
+
+#ifdef HAVE_EGL
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLContext shareContext_ = EGL_NO_CONTEXT;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    bool createContext();
+    void destroyContext();
+#endif
+
+    // Worker-owned GL objects, per layer
+    std::map<int, LayerSlots> layers_;
+    std::deque<int> removedLayers_;
+
+    std::map<int, std::shared_ptr<Job>> jobs_;  // Latest job per layer
+    std::deque<std::shared_ptr<Job>> queue_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCond_;
+    std::condition_variable doneCond_;
+    std::unique_ptr<std::thread> workerThread_;
+    std::atomic<bool> running_;
+    bool stop_;
+    int initState_;  // 0 = pending, 1 = running, -1 = failed
+
+    Stats stats_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TEXTUREUPLOADER_H
@@ -1,16 +1,99 @@
 #ifndef VIDEOCOMPOSER_VIDEOSHADERS_H
 #define VIDEOCOMPOSER_VIDEOSHADERS_H
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 
 namespace videocomposer {
 
 /**
- * Video shader source code (GLSL 330 core)
+ * Video shader source code (GLSL 330 core, see forGLES() for GLES 3)
  * Based on mpv's video_shaders.c approach
  */
 namespace VideoShaders {
 
+// Layer shader features (permutation bits)
+//
+// DESIGN DECISION: Compile-time specialized programs instead of uniform branching
+// -------------------------------------------------------------------------------
+// Every layer is still drawn through the shader path (no switching to fixed
+// function mid-playback), but each optional stage is compiled in only when the
+// layer uses it: the sources below guard it with USE_* macros and specialize()
+// inserts the matching #defines. ShaderCache builds each permutation on first
+// use. A plain layer then runs a single texture fetch, with no dead uniforms
+// and none of the HSV or warp math, which matters on weak iGPUs where the
+// branchy general-purpose program limited fill rate.
+enum Feature : uint32_t {
+    FEATURE_COLOR_CORRECTION = 1u << 0,  // Baked 3D LUT (brightness/contrast/saturation/hue/gamma, .cube)
+    FEATURE_HOMOGRAPHY       = 1u << 1,  // Corner deformation (vertex stage)
+    FEATURE_ANISOTROPIC      = 1u << 2,  // Gradient sampling for extreme warps (RGBA only)
+    FEATURE_DEINTERLACE      = 1u << 3,  // One field of an interlaced frame (bob or adaptive)
+    FEATURE_PACKED_ALPHA     = 1u << 4,  // Colour and alpha halves of one frame (see PackedAlpha)
+    FEATURE_ADVANCED_BLEND   = 1u << 5,  // Multiply/screen/overlay against the destination (see AdvancedBlend)
+    FEATURE_EFFECTS          = 1u << 6   // Per-layer effect stage: filter mix, key, vignette (see EffectChain)
+};
+
+/**
+ * Insert the #defines for the given feature bits after the #version line
+ * @param preamble Directives ahead of those (#extension lines, see forGLES())
+ */
+inline std::string specialize(const std::string& source, uint32_t features, const std::string& preamble = "") {
+    std::string defines = preamble;
+    if (features & FEATURE_COLOR_CORRECTION) {
+        defines += "#define USE_COLOR_CORRECTION\n";
+    }
+    if (features & FEATURE_HOMOGRAPHY) {
+        defines += "#define USE_HOMOGRAPHY\n";
+    }
+    if (features & FEATURE_ANISOTROPIC) {
+        defines += "#define USE_ANISOTROPIC\n";
+    }
+    if (features & FEATURE_DEINTERLACE) {
+        defines += "#define USE_DEINTERLACE\n";
+    }
+    if (features & FEATURE_PACKED_ALPHA) {
+        defines += "#define USE_PACKED_ALPHA\n";
+    }
+    if (features & FEATURE_ADVANCED_BLEND) {
+        defines += "#define USE_ADVANCED_BLEND\n";
+    }
+    if (features & FEATURE_EFFECTS) {
+        defines += "#define USE_EFFECTS\n";
+    }
+    
+    // #version must stay the first directive
+    size_t version = source.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return defines + source;
+    }
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+/**
+ * Same program for a GLES 3 context: the sources below are GLSL 330 core,
+ * which only needs the version line and default precisions changed
+ */
+inline std::string forGLES(const std::string& source) {
+    const std::string desktop = "#version 330 core";
+    size_t version = source.find(desktop);
+    if (version == std::string::npos) {
+        return source;
+    }
+    // #extension lines must come before any statement, precisions included
+    size_t body = version + desktop.size();
+    const std::string extension = "\n#extension";
+    while (source.compare(body, extension.size(), extension) == 0) {
+        body = std::min(source.find('\n', body + 1), source.size());
+    }
+    return source.substr(0, version) +
+           "#version 300 es" + source.substr(version + desktop.size(), body - version - desktop.size()) +
+           "\nprecision highp float;\n"
+           "precision highp sampler3D;" +
+           source.substr(body);
+}
+
 // Vertex shader (shared by all video shaders)
 const std::string VERTEX_SHADER = R"(
 #version 330 core
@@ -19,229 +102,480 @@ layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoord;
 
 uniform mat4 uMVP;
+#ifdef USE_HOMOGRAPHY
 uniform mat4 uHomography;      // 4x4 homography for corner warping
-uniform bool uUseHomography;   // Enable homography transformation
+#endif
 
 out vec2 vTexCoord;
 
 void main() {
     vec4 pos = vec4(aPos, 0.0, 1.0);
     
-    if (uUseHomography) {
-        pos = uHomography * pos;  // Apply warping first
-    }
+#ifdef USE_HOMOGRAPHY
+    pos = uHomography * pos;  // Apply warping first
+#endif
     
     gl_Position = uMVP * pos;  // Then apply positioning/scaling
     vTexCoord = aTexCoord;
 }
 )";
 
-// Color correction functions (shared GLSL code)
-//
-// DESIGN DECISION: Always use shader path with uniform branching
-// ---------------------------------------------------------------
-// We always use the shader path for all layers (CPU and GPU frames) with uniform
-// branching (uColorCorrectionEnabled) to skip color correction when disabled.
-//
-// Why this approach:
-//   1. Consistent rendering - no visual artifacts from switching render paths mid-playback
-//   2. Negligible overhead - uniform branch costs ~0.02% GPU per layer (1920x1080)
-//   3. Simpler code - single render path to maintain
-//
-// On modern GPUs, uniform branches are very efficient (~1-2 clock cycles per fragment)
-// because all threads in a warp/wavefront take the same path.
-//
-const std::string COLOR_CORRECTION_FUNCTIONS = R"(
-// Apply brightness: -1.0 to 1.0 (0 = no change)
-vec3 applyBrightness(vec3 color, float brightness) {
-    return color + brightness;
+// Color correction through a baked 3D LUT (shared GLSL code)
+// ColorLutCache bakes brightness/contrast/saturation/hue/gamma (and any
+// .cube calibration) into the table once per parameter change, so the
+// per-pixel cost is one 3D texture fetch. The table sits on texture unit
+// ColorLutCache::TEXTURE_UNIT, after every layer format's planes.
+const std::string COLOR_LUT_FUNCTIONS = R"(
+uniform sampler3D uColorLut;   // Baked adjustment
+uniform vec2 uColorLutScale;   // (size - 1) / size, 0.5 / size: lattice to texel centres
+
+vec3 applyColorLut(vec3 color) {
+    return texture(uColorLut, clamp(color, 0.0, 1.0) * uColorLutScale.x + uColorLutScale.y).rgb;
 }
+)";
 
-// Apply contrast: 0.0 to 2.0 (1 = no change)
-vec3 applyContrast(vec3 color, float contrast) {
-    return (color - 0.5) * contrast + 0.5;
+// YUV to RGB conversion shared by the NV12, YUV420P and UYVY shaders
+// Matrix (BT.601/709/2020), range expansion and bit depth come from uniforms
+// set by OpenGLRenderer::setYuvUniforms() from the frame's colour metadata
+const std::string YUV_CONVERSION_FUNCTIONS = R"(
+uniform mat3 uYuvMatrix;   // Range-expanded YUV -> RGB matrix
+uniform vec3 uYuvOffset;   // Black level and chroma midpoint
+uniform float uYuvScale;   // Sample rescale (65535/1023 for 10-bit in R16, 65535/65472 for P010)
+
+vec3 yuvToRgb(vec3 yuv) {
+    return uYuvMatrix * (yuv * uYuvScale - uYuvOffset);
 }
 
-// Apply saturation: 0.0 to 2.0 (1 = no change, 0 = grayscale)
-vec3 applySaturation(vec3 color, float saturation) {
-    float luminance = dot(color, vec3(0.299, 0.587, 0.114));
-    return mix(vec3(luminance), color, saturation);
+#ifdef USE_PACKED_ALPHA
+// Alpha picture of a packed frame: its luma, range-expanded like the colour's
+float packedAlphaFromLuma(float y) {
+    return clamp((y * uYuvScale - uYuvOffset.x) * uYuvMatrix[0][0], 0.0, 1.0);
 }
+#endif
+)";
 
-// Apply hue rotation: -180 to 180 degrees
-vec3 applyHue(vec3 color, float hueDegrees) {
-    float hueRad = hueDegrees * 3.14159265359 / 180.0;
-    float cosH = cos(hueRad);
-    float sinH = sin(hueRad);
-    
-    // Hue rotation matrix
-    mat3 hueMatrix = mat3(
-        0.213 + cosH * 0.787 - sinH * 0.213,
-        0.213 - cosH * 0.213 + sinH * 0.143,
-        0.213 - cosH * 0.213 - sinH * 0.787,
-        
-        0.715 - cosH * 0.715 - sinH * 0.715,
-        0.715 + cosH * 0.285 + sinH * 0.140,
-        0.715 - cosH * 0.715 + sinH * 0.715,
-        
-        0.072 - cosH * 0.072 + sinH * 0.928,
-        0.072 - cosH * 0.072 - sinH * 0.283,
-        0.072 + cosH * 0.928 + sinH * 0.072
-    );
+// Field of an interlaced frame, sampled at full height (see FieldSelector)
+// Bob interpolates between the two nearest lines of the shown field.
+// Adaptive weaves (both fields, full detail where the picture is still)
+// unless the other field's nearest line combs against the shown field's
+// lines around it, and bobs there. Bob or adaptive is a uniform rather
+// than another permutation: both are a few fetches, and the branch is
+// the same for the whole layer.
+const std::string DEINTERLACE_FUNCTIONS = R"(
+uniform int uField;                  // Line parity shown: 0 = top (even) lines, 1 = bottom
+uniform bool uDeinterlaceAdaptive;
+
+// Rows of the shown field around a (texel-centre) row, and the weight of the lower one
+float fieldRows(float row, float height, out float r0, out float r1) {
+    float field = float(uField);
+    float last = height - 1.0 - mod(height - 1.0 - field, 2.0);
+    float k = (row - field) * 0.5;
+    float k0 = floor(k);
+    r0 = clamp(2.0 * k0 + field, field, last);
+    r1 = clamp(r0 + 2.0, field, last);
+    return k - k0;
+}
+
+vec4 sampleField(sampler2D tex, vec2 uv) {
+    float height = float(textureSize(tex, 0).y);
+    float r0;
+    float r1;
+    float f = fieldRows(uv.y * height - 0.5, height, r0, r1);
+    // Texel-centre rows: filtered across, not between, lines
+    vec4 above = texture(tex, vec2(uv.x, (r0 + 0.5) / height));
+    vec4 below = texture(tex, vec2(uv.x, (r1 + 0.5) / height));
+    vec4 bob = mix(above, below, f);
+    if (!uDeinterlaceAdaptive) {
+        return bob;
+    }
     
-    return hueMatrix * color;
+    // The other field's line between them, against what the shown field predicts
+    float other = clamp(r0 + 1.0, 0.0, height - 1.0);
+    vec4 woven = texture(tex, vec2(uv.x, (other + 0.5) / height));
+    vec4 comb = abs(woven - 0.5 * (above + below)) - 0.5 * abs(above - below);
+    float motion = max(max(comb.r, comb.g), max(comb.b, comb.a));
+    return mix(texture(tex, uv), bob, smoothstep(0.02, 0.08, motion));
 }
+)";
+
+// Plane fetch of the layer shaders: the shown field when deinterlacing
+const std::string SAMPLE_PLANE_FUNCTIONS = R"(
+#ifdef USE_DEINTERLACE
+)" + DEINTERLACE_FUNCTIONS + R"(
+#define samplePlane(tex, uv) sampleField(tex, uv)
+#else
+#define samplePlane(tex, uv) texture(tex, uv)
+#endif
+)";
 
-// Apply gamma: 0.1 to 3.0 (1 = no change)
-vec3 applyGamma(vec3 color, float gamma) {
-    return pow(max(color, vec3(0.0)), vec3(1.0 / gamma));
+// Packed-alpha frames (shared GLSL code)
+// The layer quad maps to the colour half; alpha is read at the same spot of
+// the other half. Regions come from PackedAlpha::regions(), inset so that
+// filtering never reaches across the seam. The compositor blends straight
+// alpha, so premultiplied colour is divided back out.
+const std::string PACKED_ALPHA_FUNCTIONS = R"(
+uniform vec4 uPackedColorRect;     // Colour half: offset.xy, scale.zw
+uniform vec4 uPackedAlphaRect;     // Alpha half
+uniform bool uPackedPremultiplied;
+
+vec2 packedColorUV(vec2 uv) { return uPackedColorRect.xy + uv * uPackedColorRect.zw; }
+vec2 packedAlphaUV(vec2 uv) { return uPackedAlphaRect.xy + uv * uPackedAlphaRect.zw; }
+
+vec3 packedStraightColor(vec3 rgb, float alpha) {
+    return uPackedPremultiplied && alpha > 0.0 ? clamp(rgb / alpha, 0.0, 1.0) : rgb;
+}
+)";
+
+// Per-layer effect stage (shared GLSL code, see EffectChain)
+// Runs on the layer's straight colour before opacity and blending. Stages
+// whose uniforms are zero are skipped, so one program covers any chain;
+// the uniforms are constant per draw, so the branches do not diverge.
+// uEffectFiltered is the blurred source from the filter passes, stored
+// bottom-up (row 0 = bottom of the picture).
+const std::string EFFECT_FUNCTIONS = R"(
+uniform sampler2D uEffectFiltered;
+uniform float uEffectFilterWeight;  // 1 = blur, < 0 = sharpen, 0 = no filter
+uniform vec4 uEffectKeyColor;       // rgb, a = 1 to key
+uniform vec3 uEffectKeyParams;      // Similarity, smoothness, spill
+uniform vec2 uEffectVignette;       // Amount, softness
+
+vec2 keyChroma(vec3 c) {
+    return vec2(dot(c, vec3(-0.168736, -0.331264, 0.5)), dot(c, vec3(0.5, -0.418688, -0.081312)));
 }
 
-// Apply all color corrections
-vec3 applyColorCorrection(vec3 color, float brightness, float contrast, 
-                          float saturation, float hue, float gamma) {
-    vec3 result = color;
-    result = applyBrightness(result, brightness);
-    result = applyContrast(result, contrast);
-    result = applySaturation(result, saturation);
-    if (hue != 0.0) {
-        result = applyHue(result, hue);
+vec4 applyEffects(vec4 color, vec2 uv) {
+    vec3 unfiltered = color.rgb;
+    if (uEffectFilterWeight != 0.0) {
+        vec4 filtered = texture(uEffectFiltered, vec2(uv.x, 1.0 - uv.y));
+        color = clamp(mix(color, filtered, uEffectFilterWeight), 0.0, 1.0);
     }
-    if (gamma != 1.0) {
-        result = applyGamma(result, gamma);
+    if (uEffectKeyColor.a > 0.0) {
+        // Distance in chroma only, so shadows on the screen key out too
+        float d = distance(keyChroma(unfiltered), keyChroma(uEffectKeyColor.rgb));
+        float edge = uEffectKeyParams.x + uEffectKeyParams.y;
+        color.a *= smoothstep(uEffectKeyParams.x, edge, d);
+        float spill = uEffectKeyParams.z * (1.0 - smoothstep(uEffectKeyParams.x, edge + 0.2, d));
+        color.rgb = mix(color.rgb, vec3(dot(color.rgb, vec3(0.2126, 0.7152, 0.0722))), clamp(spill, 0.0, 1.0));
     }
-    return clamp(result, 0.0, 1.0);
+    if (uEffectVignette.x > 0.0) {
+        // 0 at the centre, 1 in the corners
+        float r = length(uv - 0.5) * 1.4142136;
+        color.rgb *= 1.0 - uEffectVignette.x * smoothstep(1.0 - max(uEffectVignette.y, 0.001), 1.0, r);
+    }
+    return color;
 }
 )";
 
-// Fragment shader for RGBA textures (CPU frames, HAP after decompression)
-const std::string FRAGMENT_RGBA = R"(
+// Separable Gaussian for the effect filter passes, on pooled targets
+// Blurs premultiplied, so transparent texels lend no colour, and writes
+// straight alpha again. Taps are bilinear (see EffectChain::gaussianTaps).
+constexpr int EFFECT_MAX_TAPS = 8;  // EffectChain::MAX_TAPS
+
+const std::string EFFECT_VERTEX_SHADER = R"(
 #version 330 core
 
-in vec2 vTexCoord;
+layout(location = 0) in vec2 aPos;
 
-uniform sampler2D uTexture;
-uniform float uOpacity;
+out vec2 vTexCoord;
 
-// Color correction uniforms
-uniform float uBrightness;   // -1.0 to 1.0 (0 = no change)
-uniform float uContrast;     // 0.0 to 2.0 (1 = no change)
-uniform float uSaturation;   // 0.0 to 2.0 (1 = no change)
-uniform float uHue;          // -180 to 180 degrees
-uniform float uGamma;        // 0.1 to 3.0 (1 = no change)
-uniform bool uColorCorrectionEnabled;
+void main() {
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    vTexCoord = aPos * 0.5 + 0.5;  // Target texels, no flip
+}
+)";
 
-)" + COLOR_CORRECTION_FUNCTIONS + R"(
+const std::string EFFECT_BLUR_FRAGMENT_SHADER = R"(
+#version 330 core
+
+in vec2 vTexCoord;
+
+uniform sampler2D uTexture;
+uniform vec2 uTexelStep;  // One texel along the pass direction
+uniform int uTaps;
+uniform float uOffsets[)" + std::to_string(EFFECT_MAX_TAPS + 1) + R"(];
+uniform float uWeights[)" + std::to_string(EFFECT_MAX_TAPS + 1) + R"(];
 
 out vec4 FragColor;
 
+vec4 premultiplied(vec2 uv) {
+    vec4 c = texture(uTexture, uv);
+    return vec4(c.rgb * c.a, c.a);
+}
+
 void main() {
-    vec4 color = texture(uTexture, vTexCoord);
-    vec3 rgb = color.rgb;
-    
-    if (uColorCorrectionEnabled) {
-        rgb = applyColorCorrection(rgb, uBrightness, uContrast, 
-                                   uSaturation, uHue, uGamma);
+    vec4 sum = premultiplied(vTexCoord) * uWeights[0];
+    for (int i = 1; i <= uTaps; ++i) {
+        vec2 offset = uTexelStep * uOffsets[i];
+        sum += (premultiplied(vTexCoord + offset) + premultiplied(vTexCoord - offset)) * uWeights[i];
     }
-    
-    FragColor = vec4(rgb, color.a * uOpacity);
+    FragColor = vec4(sum.a > 0.0 ? sum.rgb / sum.a : vec3(0.0), sum.a);
+}
+)";
+
+// Blend modes that read the destination (shared GLSL code, declares FragColor)
+// The layer's straight colour and alpha go through blendOutput(). With
+// BLEND_EQUATION the KHR advanced equations do the blending and take
+// premultiplied colour; BLEND_FETCH reads the pixel under the fragment and
+// BLEND_COPY a copy of the layer's screen bounds, and the renderer draws
+// those with blending off. The formula below is the one of the KHR
+// equations, so every path gives the same pixels. uBlendMode is uniform
+// per draw (LayerProperties::BlendMode), so its branches do not diverge.
+const std::string ADVANCED_BLEND_FUNCTIONS = R"(
+#if defined(USE_ADVANCED_BLEND) && defined(BLEND_EQUATION)
+layout(blend_support_multiply, blend_support_screen, blend_support_overlay) out;
+out vec4 FragColor;
+#elif defined(USE_ADVANCED_BLEND) && defined(BLEND_FETCH)
+inout vec4 FragColor;
+#else
+out vec4 FragColor;
+#endif
+
+#if defined(USE_ADVANCED_BLEND) && !defined(BLEND_EQUATION)
+#ifndef BLEND_FETCH
+uniform sampler2D uBlendDestination;
+uniform vec4 uBlendDestinationRect;  // Copied region: window offset xy, 1 / size zw
+#endif
+uniform int uBlendMode;
+
+vec3 blendChannels(vec3 s, vec3 d) {
+    if (uBlendMode == 1) {
+        return s * d;
+    }
+    if (uBlendMode == 2) {
+        return s + d - s * d;
+    }
+    // Overlay: multiply or screen, by the destination
+    return mix(2.0 * s * d, 1.0 - 2.0 * (1.0 - s) * (1.0 - d), step(0.5, d));
+}
+#endif
+
+vec4 blendOutput(vec4 color) {
+#if defined(USE_ADVANCED_BLEND) && defined(BLEND_EQUATION)
+    return vec4(color.rgb * color.a, color.a);
+#elif defined(USE_ADVANCED_BLEND)
+#ifdef BLEND_FETCH
+    vec4 dst = FragColor;
+#else
+    vec4 dst = texture(uBlendDestination, (gl_FragCoord.xy - uBlendDestinationRect.xy) * uBlendDestinationRect.zw);
+#endif
+    vec3 s = clamp(color.rgb, 0.0, 1.0);
+    float as = clamp(color.a, 0.0, 1.0);
+    float ad = dst.a;
+    vec3 d = ad > 0.0 ? clamp(dst.rgb / ad, 0.0, 1.0) : vec3(0.0);
+    vec3 rgb = as * ad * blendChannels(s, d) + as * (1.0 - ad) * s + (1.0 - as) * dst.rgb;
+    return vec4(rgb, as + ad * (1.0 - as));
+#else
+    return color;
+#endif
 }
 )";
 
-// High-quality RGBA fragment shader with anisotropic filtering for extreme warps
-const std::string FRAGMENT_RGBA_HQ = R"(
+// Fragment shader for RGBA textures (CPU frames, HAP after decompression)
+// USE_ANISOTROPIC: gradient-based sampling for extreme corner warps
+const std::string FRAGMENT_RGBA = R"(
 #version 330 core
 
 in vec2 vTexCoord;
 
 uniform sampler2D uTexture;
 uniform float uOpacity;
+#ifdef USE_ANISOTROPIC
 uniform float uAnisotropy;  // 1.0 = normal, 2.0-16.0 = enhanced filtering
+#endif
 
-// Color correction uniforms
-uniform float uBrightness;
-uniform float uContrast;
-uniform float uSaturation;
-uniform float uHue;
-uniform float uGamma;
-uniform bool uColorCorrectionEnabled;
+#ifdef USE_COLOR_CORRECTION
+)" + COLOR_LUT_FUNCTIONS + R"(
+#endif
 
-)" + COLOR_CORRECTION_FUNCTIONS + R"(
+#ifdef USE_PACKED_ALPHA
+)" + PACKED_ALPHA_FUNCTIONS + R"(
+#endif
 
-out vec4 FragColor;
+)" + SAMPLE_PLANE_FUNCTIONS + R"(
+
+#ifdef USE_EFFECTS
+)" + EFFECT_FUNCTIONS + R"(
+#endif
+
+)" + ADVANCED_BLEND_FUNCTIONS + R"(
 
 void main() {
+#ifdef USE_PACKED_ALPHA
+    vec2 colorUV = packedColorUV(vTexCoord);
+#else
+    vec2 colorUV = vTexCoord;
+#endif
+#ifdef USE_ANISOTROPIC
     // Gradient-based anisotropic filtering for better quality on warped regions
-    vec2 dx = dFdx(vTexCoord) * uAnisotropy;
-    vec2 dy = dFdy(vTexCoord) * uAnisotropy;
-    vec4 color = textureGrad(uTexture, vTexCoord, dx, dy);
-    
+    vec2 dx = dFdx(colorUV) * uAnisotropy;
+    vec2 dy = dFdy(colorUV) * uAnisotropy;
+    vec4 color = textureGrad(uTexture, colorUV, dx, dy);
+#ifdef USE_PACKED_ALPHA
+    color.a = textureGrad(uTexture, packedAlphaUV(vTexCoord), dx, dy).g;
+#endif
+#else
+    vec4 color = samplePlane(uTexture, colorUV);
+#ifdef USE_PACKED_ALPHA
+    color.a = samplePlane(uTexture, packedAlphaUV(vTexCoord)).g;
+#endif
+#endif
     vec3 rgb = color.rgb;
-    if (uColorCorrectionEnabled) {
-        rgb = applyColorCorrection(rgb, uBrightness, uContrast, 
-                                   uSaturation, uHue, uGamma);
-    }
+#ifdef USE_PACKED_ALPHA
+    rgb = packedStraightColor(rgb, color.a);
+#endif
     
-    FragColor = vec4(rgb, color.a * uOpacity);
+#ifdef USE_COLOR_CORRECTION
+    rgb = applyColorLut(rgb);
+#endif
+    
+#ifdef USE_EFFECTS
+    vec4 effected = applyEffects(vec4(rgb, color.a), vTexCoord);
+    FragColor = blendOutput(vec4(effected.rgb, effected.a * uOpacity));
+#else
+    FragColor = blendOutput(vec4(rgb, color.a * uOpacity));
+#endif
+}
+)";
+
+// Batched RGBA layers: one instanced draw for up to MAX_BATCH_LAYERS plain
+// layers (no color correction, no deform, normal blending). Per-instance
+// transform and opacity come from the LayerInstances uniform block (std140,
+// binding BATCH_UBO_BINDING); instance i samples texture unit i.
+constexpr int MAX_BATCH_LAYERS = 16;  // GL 3.3 guarantees 16 fragment texture units
+constexpr int BATCH_UBO_BINDING = 0;
+constexpr int BATCH_INSTANCE_FLOATS = 20;  // mat4 mvp + vec4 (opacity, slot, -, -)
+
+const std::string BATCH_VERTEX_SHADER = R"(
+#version 330 core
+
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+
+struct LayerInstance {
+    mat4 mvp;
+    vec4 params;  // x = opacity, y = texture slot
+};
+
+layout(std140) uniform LayerInstances {
+    LayerInstance uLayers[)" + std::to_string(MAX_BATCH_LAYERS) + R"(];
+};
+
+out vec2 vTexCoord;
+flat out int vSlot;
+flat out float vOpacity;
+
+void main() {
+    LayerInstance layer = uLayers[gl_InstanceID];
+    gl_Position = layer.mvp * vec4(aPos, 0.0, 1.0);
+    vTexCoord = aTexCoord;
+    vSlot = int(layer.params.y);
+    vOpacity = layer.params.x;
+}
+)";
+
+/**
+ * Fragment shader for batched RGBA layers
+ * GLSL 3.30 only allows constant sampler array indices, hence the switch
+ * (uniform within each tile, so it does not diverge)
+ */
+inline std::string batchFragmentShader() {
+    std::string cases;
+    for (int i = 0; i < MAX_BATCH_LAYERS; ++i) {
+        std::string n = std::to_string(i);
+        cases += "        case " + n + ": return texture(uTextures[" + n + "], uv);\n";
+    }
+    return R"(
+#version 330 core
+
+in vec2 vTexCoord;
+flat in int vSlot;
+flat in float vOpacity;
+
+uniform sampler2D uTextures[)" + std::to_string(MAX_BATCH_LAYERS) + R"(];
+
+out vec4 FragColor;
+
+vec4 sampleSlot(int slot, vec2 uv) {
+    switch (slot) {
+)" + cases + R"(    }
+    return vec4(0.0);
+}
+
+void main() {
+    vec4 color = sampleSlot(vSlot, vTexCoord);
+    FragColor = vec4(color.rgb, color.a * vOpacity);
 }
 )";
+}
 
 // Fragment shader for NV12 format (VAAPI, CUDA output)
 // NV12: Y plane (full resolution) + interleaved UV plane (half resolution)
+// Also used for P010 (R16/RG16 planes, rescaled through uYuvScale)
 // Note: Uses shared VERTEX_SHADER which supports homography warping
 const std::string FRAGMENT_NV12 = R"(
 #version 330 core
 
 in vec2 vTexCoord;
 
-uniform sampler2D uTexY;   // Luma plane (R8)
-uniform sampler2D uTexUV;  // Chroma plane (RG8)
+uniform sampler2D uTexY;   // Luma plane (R8, R16 for P010)
+uniform sampler2D uTexUV;  // Chroma plane (RG8, RG16 for P010)
 uniform float uOpacity;
 
-// Color correction uniforms
-uniform float uBrightness;
-uniform float uContrast;
-uniform float uSaturation;
-uniform float uHue;
-uniform float uGamma;
-uniform bool uColorCorrectionEnabled;
+#ifdef USE_COLOR_CORRECTION
+)" + COLOR_LUT_FUNCTIONS + R"(
+#endif
 
-)" + COLOR_CORRECTION_FUNCTIONS + R"(
+)" + YUV_CONVERSION_FUNCTIONS + R"(
 
-out vec4 FragColor;
+#ifdef USE_PACKED_ALPHA
+)" + PACKED_ALPHA_FUNCTIONS + R"(
+#endif
+
+)" + SAMPLE_PLANE_FUNCTIONS + R"(
 
-// BT.709 YUV to RGB conversion matrix
-// Based on mpv's color matrix handling
-const mat3 yuv2rgb = mat3(
-    1.0,      1.0,       1.0,
-    0.0,     -0.18732,   1.8556,
-    1.5748,  -0.46812,   0.0
-);
+#ifdef USE_EFFECTS
+)" + EFFECT_FUNCTIONS + R"(
+#endif
+
+)" + ADVANCED_BLEND_FUNCTIONS + R"(
 
 void main() {
-    float y = texture(uTexY, vTexCoord).r;
-    vec2 uv = texture(uTexUV, vTexCoord).rg;
-    
-    // YUV values are in range [0, 1], adjust to standard range
-    vec3 yuv = vec3(y - 0.0625, uv.r - 0.5, uv.g - 0.5);
+#ifdef USE_PACKED_ALPHA
+    vec2 colorUV = packedColorUV(vTexCoord);
+#else
+    vec2 colorUV = vTexCoord;
+#endif
+    float y = samplePlane(uTexY, colorUV).r;
+    vec2 uv = samplePlane(uTexUV, colorUV).rg;
     
     // Convert to RGB
-    vec3 rgb = yuv2rgb * yuv;
+    vec3 rgb = yuvToRgb(vec3(y, uv));
     
     // Clamp to valid range
     rgb = clamp(rgb, 0.0, 1.0);
     
-    // Apply color correction
-    if (uColorCorrectionEnabled) {
-        rgb = applyColorCorrection(rgb, uBrightness, uContrast, 
-                                   uSaturation, uHue, uGamma);
-    }
+    float alpha = 1.0;
+#ifdef USE_PACKED_ALPHA
+    alpha = packedAlphaFromLuma(samplePlane(uTexY, packedAlphaUV(vTexCoord)).r);
+    rgb = packedStraightColor(rgb, alpha);
+#endif
+    
+    // Apply color correction (baked LUT)
+#ifdef USE_COLOR_CORRECTION
+    rgb = applyColorLut(rgb);
+#endif
     
-    FragColor = vec4(rgb, uOpacity);
+#ifdef USE_EFFECTS
+    vec4 effected = applyEffects(vec4(rgb, alpha), vTexCoord);
+    FragColor = blendOutput(vec4(effected.rgb, effected.a * uOpacity));
+#else
+    FragColor = blendOutput(vec4(rgb, alpha * uOpacity));
+#endif
 }
 )";
 
-// Fragment shader for YUV420P format (fallback, 3 separate planes)
+// Fragment shader for YUV420P format (software decode and fallback, 3 separate planes)
+// Also used for 10-bit YUV420P (R16 planes, rescaled through uYuvScale)
 // Note: Uses shared VERTEX_SHADER which supports homography warping
 const std::string FRAGMENT_YUV420P = R"(
 #version 330 core
@@ -253,62 +587,157 @@ uniform sampler2D uTexU;  // U chroma plane (R8)
 uniform sampler2D uTexV;  // V chroma plane (R8)
 uniform float uOpacity;
 
-// Color correction uniforms
-uniform float uBrightness;
-uniform float uContrast;
-uniform float uSaturation;
-uniform float uHue;
-uniform float uGamma;
-uniform bool uColorCorrectionEnabled;
+#ifdef USE_COLOR_CORRECTION
+)" + COLOR_LUT_FUNCTIONS + R"(
+#endif
 
-)" + COLOR_CORRECTION_FUNCTIONS + R"(
+)" + YUV_CONVERSION_FUNCTIONS + R"(
 
-out vec4 FragColor;
+#ifdef USE_PACKED_ALPHA
+)" + PACKED_ALPHA_FUNCTIONS + R"(
+#endif
+
+)" + SAMPLE_PLANE_FUNCTIONS + R"(
+
+#ifdef USE_EFFECTS
+)" + EFFECT_FUNCTIONS + R"(
+#endif
 
-// BT.709 YUV to RGB conversion matrix
-const mat3 yuv2rgb = mat3(
-    1.0,      1.0,       1.0,
-    0.0,     -0.18732,   1.8556,
-    1.5748,  -0.46812,   0.0
-);
+)" + ADVANCED_BLEND_FUNCTIONS + R"(
 
 void main() {
-    float y = texture(uTexY, vTexCoord).r;
-    float u = texture(uTexU, vTexCoord).r;
-    float v = texture(uTexV, vTexCoord).r;
+#ifdef USE_PACKED_ALPHA
+    vec2 colorUV = packedColorUV(vTexCoord);
+#else
+    vec2 colorUV = vTexCoord;
+#endif
+    float y = samplePlane(uTexY, colorUV).r;
+    float u = samplePlane(uTexU, colorUV).r;
+    float v = samplePlane(uTexV, colorUV).r;
     
-    // YUV values are in range [0, 1], adjust to standard range
-    vec3 yuv = vec3(y - 0.0625, u - 0.5, v - 0.5);
+    // Convert to RGB
+    vec3 rgb = yuvToRgb(vec3(y, u, v));
+    
+    // Clamp to valid range
+    rgb = clamp(rgb, 0.0, 1.0);
+    
+    float alpha = 1.0;
+#ifdef USE_PACKED_ALPHA
+    alpha = packedAlphaFromLuma(samplePlane(uTexY, packedAlphaUV(vTexCoord)).r);
+    rgb = packedStraightColor(rgb, alpha);
+#endif
+    
+    // Apply color correction (baked LUT)
+#ifdef USE_COLOR_CORRECTION
+    rgb = applyColorLut(rgb);
+#endif
+    
+#ifdef USE_EFFECTS
+    vec4 effected = applyEffects(vec4(rgb, alpha), vTexCoord);
+    FragColor = blendOutput(vec4(effected.rgb, effected.a * uOpacity));
+#else
+    FragColor = blendOutput(vec4(rgb, alpha * uOpacity));
+#endif
+}
+)";
+
+// Fragment shader for packed UYVY (NDI and other live inputs)
+// One RGBA8 texel holds two pixels (U Y0 V Y1): chroma is filtered by the
+// sampler at its own (half) resolution, luma is filtered here from texels
+// USE_DEINTERLACE: bob (packed luma is not adaptive; the mode is ignored)
+// Note: Uses shared VERTEX_SHADER which supports homography warping
+const std::string FRAGMENT_UYVY = R"(
+#version 330 core
+
+in vec2 vTexCoord;
+
+uniform sampler2D uTexUYVY;  // Packed frame (RGBA8, half width)
+uniform float uOpacity;
+
+#ifdef USE_COLOR_CORRECTION
+)" + COLOR_LUT_FUNCTIONS + R"(
+#endif
+
+)" + YUV_CONVERSION_FUNCTIONS + R"(
+
+#ifdef USE_DEINTERLACE
+)" + DEINTERLACE_FUNCTIONS + R"(
+#endif
+
+#ifdef USE_EFFECTS
+)" + EFFECT_FUNCTIONS + R"(
+#endif
+
+)" + ADVANCED_BLEND_FUNCTIONS + R"(
+
+float lumaAt(ivec2 p, ivec2 size) {
+    p = clamp(p, ivec2(0), size - 1);
+    vec4 texel = texelFetch(uTexUYVY, ivec2(p.x >> 1, p.y), 0);
+    return (p.x & 1) == 0 ? texel.g : texel.a;
+}
+
+void main() {
+    ivec2 texels = textureSize(uTexUYVY, 0);
+    ivec2 size = ivec2(texels.x * 2, texels.y);
+    
+    // Bilinear luma at full resolution
+    vec2 pos = vTexCoord * vec2(size) - 0.5;
+    ivec2 p0 = ivec2(floor(pos));
+    vec2 f = pos - vec2(p0);
+#ifdef USE_DEINTERLACE
+    // Lines of the shown field only
+    float r0;
+    float r1;
+    f.y = fieldRows(pos.y, float(size.y), r0, r1);
+    ivec2 above = ivec2(p0.x, int(r0));
+    ivec2 below = ivec2(p0.x, int(r1));
+    float y = mix(mix(lumaAt(above, size), lumaAt(above + ivec2(1, 0), size), f.x),
+                  mix(lumaAt(below, size), lumaAt(below + ivec2(1, 0), size), f.x), f.y);
+    vec2 uv = texture(uTexUYVY, vec2(vTexCoord.x, (r0 + 0.5) / float(size.y))).rb;
+    uv = mix(uv, texture(uTexUYVY, vec2(vTexCoord.x, (r1 + 0.5) / float(size.y))).rb, f.y);
+#else
+    float y = mix(mix(lumaAt(p0, size), lumaAt(p0 + ivec2(1, 0), size), f.x),
+                  mix(lumaAt(p0 + ivec2(0, 1), size), lumaAt(p0 + ivec2(1, 1), size), f.x), f.y);
+    vec2 uv = texture(uTexUYVY, vTexCoord).rb;
+#endif
     
     // Convert to RGB
-    vec3 rgb = yuv2rgb * yuv;
+    vec3 rgb = yuvToRgb(vec3(y, uv));
     
     // Clamp to valid range
     rgb = clamp(rgb, 0.0, 1.0);
     
-    // Apply color correction
-    if (uColorCorrectionEnabled) {
-        rgb = applyColorCorrection(rgb, uBrightness, uContrast, 
-                                   uSaturation, uHue, uGamma);
-    }
+    // Apply color correction (baked LUT)
+#ifdef USE_COLOR_CORRECTION
+    rgb = applyColorLut(rgb);
+#endif
     
-    FragColor = vec4(rgb, uOpacity);
+#ifdef USE_EFFECTS
+    vec4 effected = applyEffects(vec4(rgb, 1.0), vTexCoord);
+    FragColor = blendOutput(vec4(effected.rgb, effected.a * uOpacity));
+#else
+    FragColor = blendOutput(vec4(rgb, uOpacity));
+#endif
 }
 )";
 
-// Master post-processing shader (for FBO composite with color correction)
-// Simple vertex shader for fullscreen quad
+// Master pass: the composite FBO drawn with the master transforms
+// uMVP carries flip * translate * scale * rotate * corner homography. The
+// FBO is stored bottom-up, so its texture is read the other way up than
+// the (top-down) layer textures the quad's coordinates are for.
 const std::string MASTER_VERTEX_SHADER = R"(
 #version 330 core
 
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec2 aTexCoord;
 
+uniform mat4 uMVP;
+
 out vec2 vTexCoord;
 
 void main() {
-    gl_Position = vec4(aPos, 0.0, 1.0);
-    vTexCoord = aTexCoord;
+    gl_Position = uMVP * vec4(aPos, 0.0, 1.0);
+    vTexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
 }
 )";
 
@@ -321,15 +750,9 @@ in vec2 vTexCoord;
 uniform sampler2D uTexture;
 uniform float uOpacity;
 
-// Color correction uniforms
-uniform float uBrightness;
-uniform float uContrast;
-uniform float uSaturation;
-uniform float uHue;
-uniform float uGamma;
 uniform bool uColorCorrectionEnabled;
 
-)" + COLOR_CORRECTION_FUNCTIONS + R"(
+)" + COLOR_LUT_FUNCTIONS + R"(
 
 out vec4 FragColor;
 
@@ -338,14 +761,45 @@ void main() {
     vec3 rgb = color.rgb;
     
     if (uColorCorrectionEnabled) {
-        rgb = applyColorCorrection(rgb, uBrightness, uContrast, 
-                                   uSaturation, uHue, uGamma);
+        rgb = applyColorLut(rgb);
     }
     
     FragColor = vec4(rgb, color.a * uOpacity);
 }
 )";
 
+// OSD: boxes and glyph quads, positioned in normalized device coordinates
+const std::string OSD_VERTEX_SHADER = R"(
+#version 330 core
+
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+
+out vec2 vTexCoord;
+
+void main() {
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    vTexCoord = aTexCoord;
+}
+)";
+
+// Boxes are flat colour; glyphs are white texels with coverage in alpha
+const std::string OSD_FRAGMENT_SHADER = R"(
+#version 330 core
+
+in vec2 vTexCoord;
+
+uniform sampler2D uTexture;
+uniform vec4 uColor;
+uniform bool uTextured;
+
+out vec4 FragColor;
+
+void main() {
+    FragColor = uTextured ? uColor * texture(uTexture, vTexCoord) : uColor;
+}
+)";
+
 } // namespace VideoShaders
 
 } // namespace videocomposer
@@ -3,10 +3,14 @@
  */
 
 #include "VirtualCanvas.h"
+#include "DynamicResolution.h"
+#include "../output/ReadbackRing.h"
+#include "../video/MemoryBudget.h"
 #include "../utils/Logger.h"
 
 #include <GL/glew.h>  // Must be included before GL/gl.h
 #include <GL/gl.h>
+#include <algorithm>
 #include <cstring>
 
 namespace videocomposer {
@@ -60,11 +64,14 @@ void VirtualCanvas::cleanup() {
         endFrame();
     }
     
-    destroyPBOs();
+    readback_.reset();
     destroyFBO();
+    externalTargets_.clear();
+    currentTarget_ = -1;
     
     width_ = 0;
     height_ = 0;
+    updateRenderSize();
     initialized_ = false;
     
     LOG_INFO << "VirtualCanvas: Cleaned up";
@@ -99,14 +106,15 @@ bool VirtualCanvas::configure(int width, int height) {
         return false;
     }
     
-    // Recreate PBOs if they exist
-    if (pboInitialized_) {
-        destroyPBOs();
-        initPBOs(width, height);
+    // Readbacks in flight are of the old size
+    if (readback_) {
+        readback_->release();
     }
     
     width_ = width;
     height_ = height;
+    updateRenderSize();
+    fullClears_ = std::max<int>(1, static_cast<int>(externalTargets_.size()));
     
     LOG_INFO << "VirtualCanvas: Configured " << width_ << "x" << height_;
     
@@ -124,15 +132,42 @@ void VirtualCanvas::beginFrame() {
         return;
     }
     
-    // Bind our FBO
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    // Bind our FBO, or the next external target
+    GLuint target = fbo_;
+    if (!externalTargets_.empty()) {
+        currentTarget_ = (currentTarget_ + 1) % static_cast<int>(externalTargets_.size());
+        target = externalTargets_[currentTarget_].fbo;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
     
-    // Set viewport to full canvas
-    glViewport(0, 0, width_, height_);
+    // Set viewport to the composited part (the full canvas at scale 1)
+    glViewport(0, 0, renderWidth_, renderHeight_);
     
     // Clear to black
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (visibleRects_.empty()) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    } else {
+        // Depth 0 rejects every fragment (layers draw at depth 0.5) except in
+        // the visible rectangles, cleared to black and depth 1
+        if (fullClears_ > 0) {
+            glClear(GL_COLOR_BUFFER_BIT);
+            --fullClears_;
+        }
+        glDepthMask(GL_TRUE);
+        glClearDepth(0.0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glClearDepth(1.0);
+        glEnable(GL_SCISSOR_TEST);
+        for (const CanvasRect& rect : visibleRects_) {
+            glScissor(rect.x, rect.y, rect.width, rect.height);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_FALSE);
+    }
     
     rendering_ = true;
 }
@@ -142,6 +177,11 @@ void VirtualCanvas::endFrame() {
         return;
     }
     
+    if (!visibleRects_.empty()) {
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+    }
+    
     // Flush GL commands (glFinish not needed - waitForFlip provides sync)
     glFlush();
     
@@ -151,6 +191,47 @@ void VirtualCanvas::endFrame() {
     rendering_ = false;
 }
 
+void VirtualCanvas::setVisibleRects(const std::vector<CanvasRect>& rects) {
+    if (rendering_) {
+        endFrame();
+    }
+    visibleRects_ = rects;
+    fullClears_ = std::max<int>(1, static_cast<int>(externalTargets_.size()));
+}
+
+void VirtualCanvas::setRenderScale(float scale) {
+    scale = std::min(std::max(scale, 0.0f), 1.0f);
+    if (scale <= 0.0f || scale == renderScale_) {
+        return;
+    }
+    if (rendering_) {
+        endFrame();
+    }
+    renderScale_ = scale;
+    updateRenderSize();
+    // Pixels of a larger scale are left outside the new part
+    fullClears_ = std::max<int>(1, static_cast<int>(externalTargets_.size()));
+}
+
+void VirtualCanvas::updateRenderSize() {
+    if (renderScale_ >= 1.0f || width_ <= 0 || height_ <= 0) {
+        renderWidth_ = width_;
+        renderHeight_ = height_;
+        return;
+    }
+    renderWidth_ = DynamicResolution::scaledSize(width_, renderScale_);
+    renderHeight_ = DynamicResolution::scaledSize(height_, renderScale_);
+}
+
+void VirtualCanvas::setExternalTargets(const std::vector<RenderTarget>& targets) {
+    if (rendering_) {
+        endFrame();
+    }
+    externalTargets_ = targets;
+    currentTarget_ = -1;
+    fullClears_ = std::max<int>(1, static_cast<int>(externalTargets_.size()));
+}
+
 bool VirtualCanvas::captureFrame(void* buffer, size_t bufferSize) {
     return captureRegion(0, 0, width_, height_, buffer, bufferSize);
 }
@@ -185,99 +266,63 @@ bool VirtualCanvas::captureRegion(int x, int y, int width, int height,
     return true;
 }
 
-void VirtualCanvas::startAsyncCapture() {
+bool VirtualCanvas::startAsyncCapture() {
     if (!initialized_ || fbo_ == 0) {
         LOG_ERROR << "VirtualCanvas: Cannot start async capture - not configured";
-        return;
+        return false;
     }
     
-    // Initialize PBOs if needed
-    if (!pboInitialized_) {
-        if (!initPBOs(width_, height_)) {
-            LOG_ERROR << "VirtualCanvas: Failed to initialize PBOs for async capture";
-            return;
-        }
+    if (!readback_) {
+        readback_ = std::make_unique<ReadbackRing>();
+    }
+    if (!readback_->configure(static_cast<size_t>(width_) * height_ * 4)) {
+        LOG_ERROR << "VirtualCanvas: Failed to initialize PBOs for async capture";
+        readback_.reset();
+        return false;
     }
     
-    // Swap PBO index
-    currentPbo_ = (currentPbo_ + 1) % 2;
+    GLuint buffer = readback_->begin();
+    if (buffer == 0) {
+        return false;
+    }
     
-    // Bind FBO for reading
+    // Start async read (returns immediately), fenced so the map never waits
     glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
-    
-    // Bind PBO for pixel pack
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[currentPbo_]);
-    
-    // Start async read (returns immediately)
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
     glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    
-    // Unbind
     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-    
-    asyncCaptureInProgress_ = true;
-    asyncCaptureWidth_ = width_;
-    asyncCaptureHeight_ = height_;
+    readback_->submit();
+    return true;
 }
 
 bool VirtualCanvas::isAsyncCaptureReady() const {
-    if (!asyncCaptureInProgress_) {
-        return false;
-    }
-    
-    // Check if the previous PBO transfer is complete
-    // (We read from the previous PBO while the current one is being filled)
-    int prevPbo = (currentPbo_ + 1) % 2;
-    
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[prevPbo]);
-    
-    // Try to map - if it succeeds, data is ready
-    void* ptr = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-    if (ptr) {
-        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        return true;
-    }
-    
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    return false;
+    return readback_ && readback_->ready();
 }
 
 bool VirtualCanvas::getAsyncCaptureResult(void* buffer, size_t bufferSize) {
-    if (!asyncCaptureInProgress_) {
+    if (!readback_ || readback_->pending() == 0) {
         return false;
     }
     
-    size_t requiredSize = static_cast<size_t>(asyncCaptureWidth_ * asyncCaptureHeight_ * 4);
-    if (!buffer || bufferSize < requiredSize) {
+    if (!buffer || bufferSize < readback_->getSize()) {
         LOG_ERROR << "VirtualCanvas: Invalid buffer for async capture result";
         return false;
     }
     
-    // Read from the previous PBO (double-buffering)
-    int prevPbo = (currentPbo_ + 1) % 2;
-    
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[prevPbo]);
-    
-    void* ptr = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-    if (!ptr) {
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        return false;
-    }
-    
-    // Copy data
-    memcpy(buffer, ptr, requiredSize);
-    
-    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    
-    return true;
+    return readback_->poll(buffer, bufferSize);
 }
 
 bool VirtualCanvas::createFBO(int width, int height) {
     // Destroy existing FBO if any
     destroyFBO();
     
+    // Color and depth, 4 bytes a pixel each
+    chargedBytes_ = static_cast<size_t>(width) * height * 8;
+    MemoryBudget::instance().charge(MemoryBudget::Account(MemoryBudget::Subsystem::CANVAS, MemoryBudget::NO_LAYER),
+                                    chargedBytes_);
+    
     // Create texture
     glGenTextures(1, &texture_);
     glBindTexture(GL_TEXTURE_2D, texture_);
@@ -338,44 +383,12 @@ void VirtualCanvas::destroyFBO() {
         glDeleteRenderbuffers(1, &depthRbo_);
         depthRbo_ = 0;
     }
-}
-
-bool VirtualCanvas::initPBOs(int width, int height) {
-    if (pboInitialized_) {
-        return true;
-    }
     
-    size_t bufferSize = static_cast<size_t>(width * height * 4);
-    
-    glGenBuffers(2, pbo_);
-    
-    for (int i = 0; i < 2; ++i) {
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[i]);
-        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+    if (chargedBytes_ > 0) {
+        MemoryBudget::instance().release(
+            MemoryBudget::Account(MemoryBudget::Subsystem::CANVAS, MemoryBudget::NO_LAYER), chargedBytes_);
+        chargedBytes_ = 0;
     }
-    
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    
-    pboInitialized_ = true;
-    currentPbo_ = 0;
-    
-    LOG_INFO << "VirtualCanvas: Initialized PBOs for async capture (" 
-             << bufferSize << " bytes each)";
-    
-    return true;
-}
-
-void VirtualCanvas::destroyPBOs() {
-    if (!pboInitialized_) {
-        return;
-    }
-    
-    glDeleteBuffers(2, pbo_);
-    pbo_[0] = 0;
-    pbo_[1] = 0;
-    
-    pboInitialized_ = false;
-    asyncCaptureInProgress_ = false;
 }
 
 } // namespace videocomposer
@@ -17,7 +17,9 @@
 #ifndef VIDEOCOMPOSER_VIRTUALCANVAS_H
 #define VIDEOCOMPOSER_VIRTUALCANVAS_H
 
+#include "CanvasRegions.h"
 #include <GL/glew.h>  // For GLuint
+#include <memory>
 #include <vector>
 
 #ifdef HAVE_EGL
@@ -26,6 +28,8 @@
 
 namespace videocomposer {
 
+class ReadbackRing;
+
 /**
  * VirtualCanvas - Single FBO for compositing all layers
  * 
@@ -43,6 +47,14 @@ namespace videocomposer {
  */
 class VirtualCanvas {
 public:
+    /**
+     * Externally owned render target (e.g. a DRM scanout buffer)
+     */
+    struct RenderTarget {
+        GLuint fbo = 0;
+        GLuint texture = 0;
+    };
+    
     VirtualCanvas();
     ~VirtualCanvas();
     
@@ -93,11 +105,36 @@ public:
     int getWidth() const { return width_; }
     int getHeight() const { return height_; }
     
+    /**
+     * Dynamic resolution: frames are composited into the bottom-left
+     * getRenderWidth() x getRenderHeight() pixels of the canvas, which keeps
+     * its size (no reallocation on a change). Outputs sample that part and
+     * scale it up (OutputBlitShader::blit's contentScale); captures and
+     * external targets read the whole canvas, so they need scale 1.
+     * @param scale Fraction of the canvas size per axis, (0, 1]
+     */
+    void setRenderScale(float scale);
+    float getRenderScale() const { return renderScale_; }
+    int getRenderWidth() const { return renderWidth_; }
+    int getRenderHeight() const { return renderHeight_; }
+    
     // ===== Rendering =====
     
+    /**
+     * Restrict each frame to the canvas pixels some output shows
+     * (framebuffer rows, i.e. already flipped for an upside-down canvas, and
+     * of the composited part at a render scale below 1).
+     * beginFrame() then clears only these rectangles and masks the rest
+     * out through the depth buffer, so layers fill only visible pixels.
+     * Hidden pixels are cleared once per target and stay black.
+     * Pass an empty list to draw the whole canvas. External targets have no
+     * depth buffer: there only the clears are restricted.
+     */
+    void setVisibleRects(const std::vector<CanvasRect>& rects);
+    
     /**
      * Begin rendering to the canvas
-     * Binds the FBO, sets viewport, and clears to black.
+     * Binds the FBO, sets viewport, and clears to black (see setVisibleRects).
      * Call before rendering layers.
      */
     void beginFrame();
@@ -114,13 +151,29 @@ public:
      */
     bool isRendering() const { return rendering_; }
     
+    /**
+     * Render into external targets instead of the canvas FBO
+     * Each beginFrame() moves on to the next target, so the target holding
+     * the last frame is left alone while the next one is drawn. Targets must
+     * be canvas-sized. Pass an empty list to return to the canvas FBO.
+     */
+    void setExternalTargets(const std::vector<RenderTarget>& targets);
+    bool hasExternalTargets() const { return !externalTargets_.empty(); }
+    
+    /**
+     * External target holding the last frame (-1 = none / canvas FBO)
+     */
+    int getCurrentTarget() const { return currentTarget_; }
+    
     // ===== Texture Access =====
     
     /**
      * Get the canvas texture for blitting to outputs
      * @return OpenGL texture ID (RGBA8 format)
      */
-    GLuint getTexture() const { return texture_; }
+    GLuint getTexture() const {
+        return currentTarget_ >= 0 ? externalTargets_[currentTarget_].texture : texture_;
+    }
     
     /**
      * Get the FBO ID (for direct binding if needed)
@@ -153,18 +206,20 @@ public:
                        void* buffer, size_t bufferSize);
     
     /**
-     * Start async capture (non-blocking)
-     * Call getAsyncCaptureResult() to retrieve data.
+     * Start async capture (non-blocking) into the readback ring
+     * (ReadbackRing::getDefaultDepth() deep). Call getAsyncCaptureResult()
+     * for the oldest finished one first, so a buffer is free.
+     * @return false if every buffer was still in flight (frame dropped)
      */
-    void startAsyncCapture();
+    bool startAsyncCapture();
     
     /**
-     * Check if async capture is ready
+     * Check if the oldest async capture has finished (its fence signalled)
      */
     bool isAsyncCaptureReady() const;
     
     /**
-     * Get async capture result
+     * Get the oldest finished async capture (never waits on the GPU)
      * @param buffer Output buffer
      * @param bufferSize Size of output buffer
      * @return true if data was copied, false if not ready or failed
@@ -178,18 +233,27 @@ private:
     int width_ = 0;
     int height_ = 0;
     
+    // Composited part of the canvas (see setRenderScale)
+    float renderScale_ = 1.0f;
+    int renderWidth_ = 0;
+    int renderHeight_ = 0;
+    
     // FBO resources
     GLuint fbo_ = 0;
     GLuint texture_ = 0;
     GLuint depthRbo_ = 0;
+    size_t chargedBytes_ = 0;           // To the memory budget
     
-    // PBO for async capture (double-buffered)
-    GLuint pbo_[2] = {0, 0};
-    int currentPbo_ = 0;
-    bool pboInitialized_ = false;
-    bool asyncCaptureInProgress_ = false;
-    int asyncCaptureWidth_ = 0;
-    int asyncCaptureHeight_ = 0;
+    // Visible canvas pixels (empty = all, see setVisibleRects)
+    std::vector<CanvasRect> visibleRects_;
+    int fullClears_ = 0;                // Frames left that clear the hidden pixels too
+    
+    // External render targets (see setExternalTargets)
+    std::vector<RenderTarget> externalTargets_;
+    int currentTarget_ = -1;
+    
+    // Fenced PBO ring for async capture (created with the first capture)
+    std::unique_ptr<ReadbackRing> readback_;
     
 #ifdef HAVE_EGL
     EGLDisplay eglDisplay_ = EGL_NO_DISPLAY;
@@ -209,14 +273,9 @@ private:
     void destroyFBO();
     
     /**
-     * Initialize PBOs for async capture
-     */
-    bool initPBOs(int width, int height);
-    
-    /**
-     * Destroy PBOs
+     * Render size from the canvas size and the scale
      */
-    void destroyPBOs();
+    void updateRenderSize();
 };
 
 } // namespace videocomposer
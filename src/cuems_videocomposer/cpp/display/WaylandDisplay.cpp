@@ -3,6 +3,7 @@
 #ifdef HAVE_WAYLAND
 
 #include "../layer/LayerManager.h"
+#include "../layer/VideoLayer.h"
 #include "../osd/OSDManager.h"
 #include "../osd/OSDRenderer.h"
 #include "../input/HardwareDecoder.h"
@@ -12,6 +13,8 @@
 #include <wayland-egl.h>
 #include "xdg-shell-client-protocol.h"
 #include "linux-dmabuf-unstable-v1-client-protocol.h"
+#include "presentation-time-client-protocol.h"
+#include "viewporter-client-protocol.h"
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -22,9 +25,14 @@
 #include <va/va_drm.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <drm_fourcc.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <ctime>
 
 namespace videocomposer {
 
@@ -50,6 +58,25 @@ static const struct xdg_toplevel_listener xdg_toplevel_listener = {
     WaylandDisplay::xdgToplevelClose
 };
 
+// Presentation listeners
+static const struct wp_presentation_listener presentation_listener = {
+    WaylandDisplay::presentationClockId
+};
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    WaylandDisplay::feedbackSyncOutput,
+    WaylandDisplay::feedbackPresented,
+    WaylandDisplay::feedbackDiscarded
+};
+
+// Decoder subsurface frame callback
+static const struct wl_callback_listener video_frame_listener = {
+    WaylandDisplay::videoFrameDone
+};
+
+// Dmabuf buffers kept for the decoder's surface pool
+static const size_t MAX_VIDEO_BUFFERS = 32;
+
 WaylandDisplay::WaylandDisplay()
     : renderer_(std::make_unique<OpenGLRenderer>())
     , osdRenderer_(std::make_unique<OSDRenderer>())
@@ -63,6 +90,22 @@ WaylandDisplay::WaylandDisplay()
     , xdgToplevel_(nullptr)
     , dmabuf_(nullptr)
     , presentation_(nullptr)
+    , presentationClock_(CLOCK_MONOTONIC)
+    , lastMsc_(0)
+    , videoFps_(0.0)
+    , frameTag_(-1)
+    , frameLogEnabled_(false)
+    , subcompositor_(nullptr)
+    , viewporter_(nullptr)
+    , videoSurface_(nullptr)
+    , videoSubsurface_(nullptr)
+    , videoViewport_(nullptr)
+    , videoFrameCallback_(nullptr)
+    , videoShownKey_(0)
+    , videoX_(0)
+    , videoY_(0)
+    , videoActive_(false)
+    , layerBypassEnabled_(true)
 #ifdef HAVE_EGL
     , eglDisplay_(EGL_NO_DISPLAY)
     , eglContext_(EGL_NO_CONTEXT)
@@ -112,6 +155,12 @@ bool WaylandDisplay::openWindow() {
         LOG_WARNING << "Failed to initialize VAAPI - hardware decode may not work";
     }
 
+    const char* disableBypass = getenv("VIDEOCOMPOSER_NO_PLANE_BYPASS");
+    if (disableBypass && (std::string(disableBypass) == "1" || std::string(disableBypass) == "true")) {
+        LOG_INFO << "Wayland: Subsurface bypass disabled via VIDEOCOMPOSER_NO_PLANE_BYPASS";
+        layerBypassEnabled_ = false;
+    }
+
     makeCurrent();
 
     // Initialize renderer
@@ -166,6 +215,11 @@ void WaylandDisplay::render(LayerManager* layerManager, OSDManager* osdManager)
         return;
     }
 
+    // A lone full-screen VAAPI layer is handed to the compositor
+    if (presentLayerBypass(layerManager, osdManager)) {
+        return;
+    }
+
     makeCurrent();
 
     // If no layer manager, just clear to black and swap
@@ -174,43 +228,38 @@ void WaylandDisplay::render(LayerManager* layerManager, OSDManager* osdManager)
         glClear(GL_COLOR_BUFFER_BIT);
         glFlush();
         swapBuffers();
+        if (videoActive_) {
+            hideVideoSurface();
+        }
         clearCurrent();
         return;
     }
 
-    // Get all layers sorted by z-order
-    auto layers = layerManager->getLayersSortedByZOrder();
-    
-    // Convert to const vector for rendering
-    std::vector<const VideoLayer*> constLayers;
-    constLayers.reserve(layers.size());
-    for (auto* layer : layers) {
-        constLayers.push_back(layer);
-    }
+    // Layers in z-order, as last published by the layer manager
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    const std::vector<const VideoLayer*>& constLayers = scene->layers;
 
     // Set viewport
     renderer_->setViewport(0, 0, windowWidth_, windowHeight_);
 
     // Composite all layers
-    renderer_->compositeLayers(constLayers);
+    renderer_->compositeLayers(constLayers, scene->groups);
 
     // Render OSD if available
     if (osdManager && osdRenderer_) {
         auto osdItems = osdRenderer_->prepareOSDRender(osdManager, windowWidth_, windowHeight_);
         if (!osdItems.empty()) {
+            // Glyph atlas texture stays with the OSD renderer
             renderer_->renderOSDItems(osdItems);
-            
-            // Cleanup OSD textures after rendering
-            for (const auto& item : osdItems) {
-                if (item.textureId != 0) {
-                    glDeleteTextures(1, &item.textureId);
-                }
-            }
         }
     }
 
     glFlush();
     swapBuffers();
+    if (videoActive_) {
+        // The composited frame is committed underneath; stop showing the decoder surface
+        hideVideoSurface();
+    }
     
     renderer_->cleanupDeferredTextures();
     
@@ -329,11 +378,328 @@ void WaylandDisplay::clearCurrent() {
 void WaylandDisplay::swapBuffers() {
 #ifdef HAVE_EGL
     if (eglDisplay_ != EGL_NO_DISPLAY && eglSurface_ != EGL_NO_SURFACE) {
+        // Feedback attaches to the commit eglSwapBuffers makes
+        requestPresentationFeedback(wlSurface_);
         eglSwapBuffers(eglDisplay_, eglSurface_);
     }
 #endif
 }
 
+// Presentation timing
+void WaylandDisplay::setVideoFramerate(double fps) {
+    videoFps_ = fps;
+    presentationTiming_.setVideoFramerate(fps);
+}
+
+int64_t WaylandDisplay::getPresentationLeadNs() const {
+    int64_t lead = presentationTiming_.getTimeToNextVsync();
+    if (lead > 0 && !feedbacks_.empty()) {
+        // The next refresh shows the frame already committed
+        int64_t duration = presentationTiming_.getVsyncDuration();
+        lead += duration > 0 ? duration : presentationTiming_.getExpectedVsyncDuration();
+    }
+    return lead;
+}
+
+bool WaylandDisplay::getTargetVblank(int64_t& msc, double& refreshHz) const {
+    int64_t next = presentationTiming_.getNextVsyncCounter();
+    if (next < 0) {
+        return false;
+    }
+    // Same refresh as getPresentationLeadNs()
+    msc = next + (feedbacks_.empty() ? 0 : 1);
+    refreshHz = presentationTiming_.getRefreshRate();
+    return true;
+}
+
+bool WaylandDisplay::setFrameLogEnabled(bool enabled, bool readback) {
+    // No canvas to read the frame code back from
+    if (!presentation_ || (enabled && readback)) {
+        return false;
+    }
+    frameLogEnabled_ = enabled;
+    presentationTiming_.setFrameLogEnabled(enabled);
+    if (!enabled) {
+        frameTag_ = -1;
+    }
+    return true;
+}
+
+void WaylandDisplay::takePresentedFrames(std::vector<PresentedFrame>& out) {
+    presentationTiming_.takePresentedFrames(out);
+}
+
+void WaylandDisplay::requestPresentationFeedback(struct wl_surface* surface) {
+    if (!presentation_ || !surface) {
+        return;
+    }
+    struct wp_presentation_feedback* feedback = wp_presentation_feedback(presentation_, surface);
+    wp_presentation_feedback_add_listener(feedback, &feedback_listener, this);
+    Feedback& pending = feedbacks_[feedback];
+    pending.readyNs = PresentationTiming::getCurrentTimeNs();
+    pending.tag = frameLogEnabled_ ? frameTag_ : -1;
+    presentationTiming_.recordQueueDepth(static_cast<int>(feedbacks_.size()));
+}
+
+void WaylandDisplay::onPresented(int64_t presentedNs, uint32_t refreshNs, uint64_t seq, bool hasSeq,
+                                 const Feedback& feedback) {
+    // Refresh of the output the surface is on (0 = unknown or variable)
+    if (refreshNs > 0) {
+        double hz = 1e9 / refreshNs;
+        if (std::fabs(hz - presentationTiming_.getRefreshRate()) > 0.01) {
+            presentationTiming_.init(hz);
+            presentationTiming_.setVideoFramerate(videoFps_);
+        }
+    }
+    
+    // Compositors without a vblank counter: count refreshes since the last frame
+    const PresentationEntry last = presentationTiming_.getInfo();
+    int64_t duration = presentationTiming_.getExpectedVsyncDuration();
+    if (hasSeq) {
+        lastMsc_ = static_cast<int64_t>(seq);
+    } else if (last.valid && duration > 0 && presentedNs > last.ust) {
+        lastMsc_ += std::max<int64_t>(1, (presentedNs - last.ust + duration / 2) / duration);
+    } else {
+        lastMsc_++;
+    }
+    
+    presentationTiming_.recordFlip(static_cast<unsigned int>(presentedNs / 1000000000LL),
+                                   static_cast<unsigned int>((presentedNs % 1000000000LL) / 1000),
+                                   static_cast<unsigned int>(lastMsc_));
+    presentationTiming_.recordPresentedFrame(feedback.tag);
+    presentationTiming_.recordBufferPresented(feedback.readyNs);
+}
+
+// Dmabuf subsurface bypass
+const VideoLayer* WaylandDisplay::findBypassLayer(LayerManager* layerManager, OSDManager* osdManager) const {
+    // OSD and master effects are drawn by GL
+    if ((osdManager && osdManager->getMode() != 0) || renderer_->masterProperties().isActive()) {
+        return nullptr;
+    }
+    
+    // Exactly one visible layer, drawn as-is
+    const VideoLayer* layer = nullptr;
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    for (const VideoLayer* candidate : scene->layers) {
+        if (!candidate || !candidate->isReady() || !candidate->properties().visible) {
+            continue;
+        }
+        if (layer) {
+            return nullptr;
+        }
+        layer = candidate;
+    }
+    if (!layer) {
+        return nullptr;
+    }
+    const LayerProperties& props = layer->properties();
+    if (props.x != 0 || props.y != 0 || props.scaleX != 1.0f || props.scaleY != 1.0f ||
+        props.rotation != 0.0f || props.opacity != 1.0f || props.crop.enabled || props.panoramaMode ||
+        props.cornerDeform.enabled || props.colorAdjust.isActive() ||
+        props.blendMode != LayerProperties::NORMAL || props.groupId != 0 ||
+        props.packedAlpha != PackedAlpha::Layout::NONE || props.effects.isActive()) {
+        return nullptr;
+    }
+    return layer;
+}
+
+bool WaylandDisplay::presentLayerBypass(LayerManager* layerManager, OSDManager* osdManager) {
+    if (!layerBypassEnabled_ || !layerManager || !dmabuf_ || !subcompositor_) {
+        return false;
+    }
+    const VideoLayer* layer = findBypassLayer(layerManager, osdManager);
+    const FrameBuffer* cpuBuffer = nullptr;
+    const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+    if (!layer || !layer->getPreparedFrame(cpuBuffer, gpuBuffer) || !gpuBuffer ||
+        gpuBuffer->getPlaneType() != TexturePlaneType::YUV_NV12 ||
+        !gpuBuffer->getDmaBufPlanes().isValid()) {
+        return false;
+    }
+    // The compositor picks the YUV matrix itself; full range would be crushed
+    const FrameInfo& info = gpuBuffer->info();
+    if (info.colorRange != ColorRange::LIMITED) {
+        return false;
+    }
+    const DmaBufPlanes& planes = gpuBuffer->getDmaBufPlanes();
+    
+    // Destination rectangle, letterboxed like OpenGLRenderer
+    int outW = static_cast<int>(windowWidth_);
+    int outH = static_cast<int>(windowHeight_);
+    int dstX = 0, dstY = 0, dstW = outW, dstH = outH;
+    if (renderer_->getLetterbox() && outW > 0 && outH > 0) {
+        float srcAspect = info.aspect > 0.0f ? info.aspect : static_cast<float>(planes.width) / planes.height;
+        float dstAspect = static_cast<float>(outW) / outH;
+        if (dstAspect > srcAspect) {
+            dstW = static_cast<int>(outH * srcAspect + 0.5f);
+            dstX = (outW - dstW) / 2;
+        } else {
+            dstH = static_cast<int>(outW / srcAspect + 0.5f);
+            dstY = (outH - dstH) / 2;
+        }
+    }
+    // Scaling needs wp_viewporter
+    if (!viewporter_ && (dstW != planes.width || dstH != planes.height)) {
+        return false;
+    }
+    
+    if (!videoSurface_) {
+        videoSurface_ = wl_compositor_create_surface(wlCompositor_);
+        videoSubsurface_ = wl_subcompositor_get_subsurface(subcompositor_, videoSurface_, wlSurface_);
+        if (!videoSurface_ || !videoSubsurface_) {
+            LOG_WARNING << "Wayland: Cannot create video subsurface, compositing instead";
+            layerBypassEnabled_ = false;
+            return false;
+        }
+        // Committed on its own; input goes to the window
+        wl_subsurface_set_desync(videoSubsurface_);
+        struct wl_region* region = wl_compositor_create_region(wlCompositor_);
+        wl_surface_set_input_region(videoSurface_, region);
+        wl_region_destroy(region);
+        if (viewporter_) {
+            videoViewport_ = wp_viewporter_get_viewport(viewporter_, videoSurface_);
+        }
+    }
+    
+    struct wl_buffer* buffer = getVideoBuffer(planes);
+    if (!buffer) {
+        // e.g. the compositor cannot import this format or modifier
+        LOG_INFO << "Wayland: Compositor cannot show decoder surfaces, compositing instead";
+        layerBypassEnabled_ = false;
+        return false;
+    }
+    
+    if (!videoActive_) {
+        // Black behind the letterbox bars
+        makeCurrent();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        swapBuffers();
+        clearCurrent();
+        videoActive_ = true;
+        LOG_INFO << "Wayland: Handing decoder surfaces to the compositor";
+    }
+    
+    // One commit per compositor frame, as eglSwapBuffers paces the GL path
+    while (videoFrameCallback_ && wl_display_dispatch(wlDisplay_) != -1) {
+    }
+    
+    if (dstX != videoX_ || dstY != videoY_) {
+        // Position is parent state
+        wl_subsurface_set_position(videoSubsurface_, dstX, dstY);
+        wl_surface_commit(wlSurface_);
+        videoX_ = dstX;
+        videoY_ = dstY;
+    }
+    if (videoViewport_) {
+        wp_viewport_set_destination(videoViewport_, dstW, dstH);
+    }
+    wl_surface_attach(videoSurface_, buffer, 0, 0);
+    wl_surface_damage(videoSurface_, 0, 0, INT32_MAX, INT32_MAX);
+    videoFrameCallback_ = wl_surface_frame(videoSurface_);
+    wl_callback_add_listener(videoFrameCallback_, &video_frame_listener, this);
+    requestPresentationFeedback(videoSurface_);
+    wl_surface_commit(videoSurface_);
+    wl_display_flush(wlDisplay_);
+    
+    // Held until a later frame replaces it on screen
+    videoShownKey_ = planes.key;
+    videoShownOwner_ = planes.owner;
+    return true;
+}
+
+struct wl_buffer* WaylandDisplay::getVideoBuffer(const DmaBufPlanes& planes) {
+#ifdef HAVE_VAAPI_INTEROP
+    auto it = videoBuffers_.find(planes.key);
+    if (it != videoBuffers_.end()) {
+        const VideoBuffer& cached = it->second;
+        if (cached.fd == planes.fds[0] && cached.width == planes.width && cached.height == planes.height) {
+            return cached.buffer;
+        }
+        // Stale: the decoder surface was replaced
+        if (planes.key != videoShownKey_) {
+            wl_buffer_destroy(cached.buffer);
+        }
+        videoBuffers_.erase(it);
+    }
+    if (videoBuffers_.size() >= MAX_VIDEO_BUFFERS) {
+        // New surface pool: drop all but the buffer on screen
+        for (auto entry = videoBuffers_.begin(); entry != videoBuffers_.end();) {
+            if (entry->first == videoShownKey_) {
+                ++entry;
+                continue;
+            }
+            wl_buffer_destroy(entry->second.buffer);
+            entry = videoBuffers_.erase(entry);
+        }
+    }
+    
+    // Import and wait for the compositor's answer (once per decoder surface)
+    struct Import {
+        struct wl_buffer* buffer = nullptr;
+        bool done = false;
+    } import;
+    static const struct zwp_linux_buffer_params_v1_listener params_listener = {
+        [](void* data, struct zwp_linux_buffer_params_v1*, struct wl_buffer* buffer) {
+            Import* result = static_cast<Import*>(data);
+            result->buffer = buffer;
+            result->done = true;
+        },
+        [](void* data, struct zwp_linux_buffer_params_v1*) {
+            static_cast<Import*>(data)->done = true;
+        }
+    };
+    struct zwp_linux_buffer_params_v1* params = zwp_linux_dmabuf_v1_create_params(dmabuf_);
+    for (uint32_t plane = 0; plane < 2; ++plane) {
+        zwp_linux_buffer_params_v1_add(params, planes.fds[plane], plane, planes.offsets[plane],
+                                       planes.pitches[plane], static_cast<uint32_t>(planes.modifier >> 32),
+                                       static_cast<uint32_t>(planes.modifier & 0xffffffff));
+    }
+    zwp_linux_buffer_params_v1_add_listener(params, &params_listener, &import);
+    zwp_linux_buffer_params_v1_create(params, planes.width, planes.height, DRM_FORMAT_NV12, 0);
+    while (!import.done && wl_display_dispatch(wlDisplay_) != -1) {
+    }
+    zwp_linux_buffer_params_v1_destroy(params);
+    if (!import.buffer) {
+        return nullptr;
+    }
+    
+    VideoBuffer& entry = videoBuffers_[planes.key];
+    entry.buffer = import.buffer;
+    entry.fd = planes.fds[0];
+    entry.width = planes.width;
+    entry.height = planes.height;
+    return entry.buffer;
+#else
+    (void)planes;
+    return nullptr;
+#endif
+}
+
+void WaylandDisplay::hideVideoSurface() {
+    if (videoFrameCallback_) {
+        // Surfaces without content get no frame callbacks
+        wl_callback_destroy(videoFrameCallback_);
+        videoFrameCallback_ = nullptr;
+    }
+    if (videoSurface_) {
+        wl_surface_attach(videoSurface_, nullptr, 0, 0);
+        wl_surface_commit(videoSurface_);
+    }
+    videoShownKey_ = 0;
+    videoShownOwner_.reset();
+    videoActive_ = false;
+}
+
+void WaylandDisplay::releaseVideoBuffers() {
+    if (videoActive_) {
+        hideVideoSurface();
+    }
+    for (auto& [key, entry] : videoBuffers_) {
+        wl_buffer_destroy(entry.buffer);
+    }
+    videoBuffers_.clear();
+}
+
 // Wayland initialization
 bool WaylandDisplay::initWayland() {
     // Step 1: Connect to Wayland display
@@ -384,6 +750,11 @@ bool WaylandDisplay::initWayland() {
         LOG_INFO << "zwp_linux_dmabuf_v1 available - VAAPI zero-copy enabled";
     }
     
+    // Without presentation feedback frames are paced by eglSwapBuffers alone
+    if (!presentation_) {
+        LOG_WARNING << "wp_presentation not available - frame selection cannot use presentation times";
+    }
+    
     // Step 4: Create Wayland surface
     wlSurface_ = wl_compositor_create_surface(wlCompositor_);
     if (!wlSurface_) {
@@ -435,6 +806,37 @@ bool WaylandDisplay::initWayland() {
 }
 
 void WaylandDisplay::cleanupWayland() {
+    releaseVideoBuffers();
+    if (videoViewport_) {
+        wp_viewport_destroy(videoViewport_);
+        videoViewport_ = nullptr;
+    }
+    if (videoSubsurface_) {
+        wl_subsurface_destroy(videoSubsurface_);
+        videoSubsurface_ = nullptr;
+    }
+    if (videoSurface_) {
+        wl_surface_destroy(videoSurface_);
+        videoSurface_ = nullptr;
+    }
+    if (viewporter_) {
+        wp_viewporter_destroy(viewporter_);
+        viewporter_ = nullptr;
+    }
+    if (subcompositor_) {
+        wl_subcompositor_destroy(subcompositor_);
+        subcompositor_ = nullptr;
+    }
+    
+    for (auto& [feedback, pending] : feedbacks_) {
+        wp_presentation_feedback_destroy(feedback);
+    }
+    feedbacks_.clear();
+    if (presentation_) {
+        wp_presentation_destroy(presentation_);
+        presentation_ = nullptr;
+    }
+    
     if (wlEglWindow_) {
         wl_egl_window_destroy(wlEglWindow_);
         wlEglWindow_ = nullptr;
@@ -531,11 +933,11 @@ bool WaylandDisplay::initEGL() {
         return false;
     }
     
-    // Step 5: Create EGL context
+    // Step 5: Create EGL context (Core Profile, as for X11)
     EGLint contextAttribs[] = {
         EGL_CONTEXT_MAJOR_VERSION, 3,
         EGL_CONTEXT_MINOR_VERSION, 3,
-        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
         EGL_NONE
     };
     
@@ -779,6 +1181,20 @@ void WaylandDisplay::registryHandleGlobal(void* data, struct wl_registry* regist
             wl_registry_bind(registry, name, &zwp_linux_dmabuf_v1_interface, 3)
         );
         LOG_INFO << "Bound to zwp_linux_dmabuf_v1";
+    } else if (strcmp(interface, "wp_presentation") == 0) {
+        display->presentation_ = static_cast<struct wp_presentation*>(
+            wl_registry_bind(registry, name, &wp_presentation_interface, 1)
+        );
+        wp_presentation_add_listener(display->presentation_, &presentation_listener, display);
+        LOG_INFO << "Bound to wp_presentation";
+    } else if (strcmp(interface, "wl_subcompositor") == 0) {
+        display->subcompositor_ = static_cast<struct wl_subcompositor*>(
+            wl_registry_bind(registry, name, &wl_subcompositor_interface, 1)
+        );
+    } else if (strcmp(interface, "wp_viewporter") == 0) {
+        display->viewporter_ = static_cast<struct wp_viewporter*>(
+            wl_registry_bind(registry, name, &wp_viewporter_interface, 1)
+        );
     }
 }
 
@@ -811,6 +1227,61 @@ void WaylandDisplay::xdgToplevelClose(void* data, struct xdg_toplevel* xdg_tople
     // The application should handle this by checking a flag in the main loop
 }
 
+
+// Presentation feedback callbacks
+void WaylandDisplay::presentationClockId(void* data, struct wp_presentation* presentation, uint32_t clockId) {
+    WaylandDisplay* display = static_cast<WaylandDisplay*>(data);
+    display->presentationClock_ = clockId;
+}
+
+void WaylandDisplay::feedbackSyncOutput(void* data, struct wp_presentation_feedback* feedback,
+                                        struct wl_output* output) {
+    // Single window: the output it was presented on is not needed
+}
+
+void WaylandDisplay::feedbackPresented(void* data, struct wp_presentation_feedback* feedback,
+                                       uint32_t tvSecHi, uint32_t tvSecLo, uint32_t tvNsec, uint32_t refresh,
+                                       uint32_t seqHi, uint32_t seqLo, uint32_t flags) {
+    WaylandDisplay* display = static_cast<WaylandDisplay*>(data);
+    auto it = display->feedbacks_.find(feedback);
+    if (it != display->feedbacks_.end()) {
+        int64_t sec = (static_cast<int64_t>(tvSecHi) << 32) | tvSecLo;
+        int64_t presentedNs = sec * 1000000000LL + tvNsec;
+        if (display->presentationClock_ != CLOCK_MONOTONIC) {
+            // Move the timestamp onto the clock of PresentationTiming
+            struct timespec other;
+            clock_gettime(static_cast<clockid_t>(display->presentationClock_), &other);
+            presentedNs += PresentationTiming::getCurrentTimeNs() -
+                           (static_cast<int64_t>(other.tv_sec) * 1000000000LL + other.tv_nsec);
+        }
+        uint64_t seq = (static_cast<uint64_t>(seqHi) << 32) | seqLo;
+        bool hasSeq = (flags & WP_PRESENTATION_FEEDBACK_KIND_VSYNC) && seq != 0;
+        Feedback pending = it->second;
+        display->feedbacks_.erase(it);
+        display->onPresented(presentedNs, refresh, seq, hasSeq, pending);
+        display->presentationTiming_.recordQueueDepth(static_cast<int>(display->feedbacks_.size()));
+    }
+    wp_presentation_feedback_destroy(feedback);
+}
+
+void WaylandDisplay::feedbackDiscarded(void* data, struct wp_presentation_feedback* feedback) {
+    // Replaced by a later commit before it was shown
+    WaylandDisplay* display = static_cast<WaylandDisplay*>(data);
+    if (display->feedbacks_.erase(feedback) > 0) {
+        display->presentationTiming_.recordBufferReplaced();
+        display->presentationTiming_.recordQueueDepth(static_cast<int>(display->feedbacks_.size()));
+    }
+    wp_presentation_feedback_destroy(feedback);
+}
+
+void WaylandDisplay::videoFrameDone(void* data, struct wl_callback* callback, uint32_t time) {
+    WaylandDisplay* display = static_cast<WaylandDisplay*>(data);
+    if (display->videoFrameCallback_ == callback) {
+        display->videoFrameCallback_ = nullptr;
+    }
+    wl_callback_destroy(callback);
+}
+
 } // namespace videocomposer
 
 #endif // HAVE_WAYLAND
@@ -3,7 +3,10 @@
 
 #include "DisplayBackend.h"
 #include "OpenGLRenderer.h"
+#include "drm/PresentationTiming.h"
+#include "../video/DmaBufPlanes.h"
 #include <memory>
+#include <unordered_map>
 
 #ifdef HAVE_WAYLAND
 
@@ -17,8 +20,16 @@ struct wl_array;
 struct xdg_wm_base;
 struct xdg_surface;
 struct xdg_toplevel;
+struct wl_subcompositor;
+struct wl_subsurface;
+struct wl_buffer;
+struct wl_callback;
+struct wl_output;
 struct zwp_linux_dmabuf_v1;
 struct wp_presentation;
+struct wp_presentation_feedback;
+struct wp_viewporter;
+struct wp_viewport;
 
 // EGL forward declarations for platform-specific types (not in DisplayBackend)
 #ifdef HAVE_EGL
@@ -30,12 +41,18 @@ namespace videocomposer {
 
 // Forward declaration
 class LayerManager;
+class VideoLayer;
 
 /**
  * WaylandDisplay - Wayland-based display backend with EGL/OpenGL (Linux only)
  * 
  * Implements DisplayBackend using Wayland + EGL + OpenGL on Linux.
  * Supports VAAPI zero-copy via DMA-BUF import using zwp_linux_dmabuf_v1 protocol.
+ *
+ * Frames are paced from wp_presentation feedback (when the compositor has
+ * it), like the DRM backend is from page flips. A lone full-screen VAAPI
+ * layer is handed to the compositor as a dmabuf on a subsurface instead of
+ * being composited, so it can put the decoder surface on a plane.
  * 
  * Note: This backend uses Wayland for windowing and EGL for OpenGL context.
  *       For X11 systems, use X11Display instead.
@@ -62,6 +79,14 @@ public:
     bool supportsMultiDisplay() const override { return false; }  // Wayland doesn't have Xinerama-like API
     void* getContext() override;
 
+    // Presentation timing (from wp_presentation feedback)
+    void setVideoFramerate(double fps) override;
+    int64_t getPresentationLeadNs() const override;
+    bool getTargetVblank(int64_t& msc, double& refreshHz) const override;
+    bool setFrameLogEnabled(bool enabled, bool readback) override;
+    void setFrameTag(int64_t tag) override { frameTag_ = tag; }
+    void takePresentedFrames(std::vector<PresentedFrame>& out) override;
+
     // OpenGL context management (override DisplayBackend interface)
     void makeCurrent() override;
     void clearCurrent() override;
@@ -97,7 +122,23 @@ public:
                                     int32_t width, int32_t height, ::wl_array* states);
     static void xdgToplevelClose(void* data, struct xdg_toplevel* xdg_toplevel);
 
+    // Presentation feedback callbacks (static for C API) - must be public
+    static void presentationClockId(void* data, struct wp_presentation* presentation, uint32_t clockId);
+    static void feedbackSyncOutput(void* data, struct wp_presentation_feedback* feedback,
+                                   struct wl_output* output);
+    static void feedbackPresented(void* data, struct wp_presentation_feedback* feedback,
+                                  uint32_t tvSecHi, uint32_t tvSecLo, uint32_t tvNsec, uint32_t refresh,
+                                  uint32_t seqHi, uint32_t seqLo, uint32_t flags);
+    static void feedbackDiscarded(void* data, struct wp_presentation_feedback* feedback);
+    static void videoFrameDone(void* data, struct wl_callback* callback, uint32_t time);
+
 private:
+    // A commit waiting for its presentation feedback
+    struct Feedback {
+        int64_t readyNs = 0;       // Committed at (monotonic)
+        int64_t tag = -1;          // Frame number it shows
+    };
+
     // Wayland initialization
     bool initWayland();
     void cleanupWayland();
@@ -116,6 +157,18 @@ private:
     
     // OpenGL context management (implementation details)
     void swapBuffers();
+    
+    // Presentation feedback for the next commit of surface
+    void requestPresentationFeedback(struct wl_surface* surface);
+    void onPresented(int64_t presentedNs, uint32_t refreshNs, uint64_t seq, bool hasSeq,
+                     const Feedback& feedback);
+    
+    // Dmabuf subsurface bypass (single full-screen VAAPI layer)
+    const VideoLayer* findBypassLayer(LayerManager* layerManager, OSDManager* osdManager) const;
+    bool presentLayerBypass(LayerManager* layerManager, OSDManager* osdManager);
+    struct wl_buffer* getVideoBuffer(const DmaBufPlanes& planes);
+    void hideVideoSurface();
+    void releaseVideoBuffers();
 
     // OpenGL renderer
     std::unique_ptr<OpenGLRenderer> renderer_;
@@ -140,6 +193,34 @@ private:
     
     // Presentation timing (optional)
     struct wp_presentation* presentation_;
+    uint32_t presentationClock_;   // clockid_t of feedback timestamps
+    PresentationTiming presentationTiming_;
+    std::unordered_map<struct wp_presentation_feedback*, Feedback> feedbacks_;  // Not yet presented or discarded
+    int64_t lastMsc_;              // Synthesised when the compositor has no counter
+    double videoFps_;
+    int64_t frameTag_;
+    bool frameLogEnabled_;
+    
+    // Subsurface for decoder surfaces (wl_subcompositor, wp_viewporter)
+    struct wl_subcompositor* subcompositor_;
+    struct wp_viewporter* viewporter_;
+    struct wl_surface* videoSurface_;
+    struct wl_subsurface* videoSubsurface_;
+    struct wp_viewport* videoViewport_;
+    struct wl_callback* videoFrameCallback_;
+    struct VideoBuffer {
+        struct wl_buffer* buffer = nullptr;
+        int fd = -1;       // Y plane fd it was created from
+        int width = 0;
+        int height = 0;
+    };
+    std::unordered_map<uint64_t, VideoBuffer> videoBuffers_;
+    uint64_t videoShownKey_;
+    std::shared_ptr<void> videoShownOwner_;  // Decoder surface on screen
+    int videoX_;                             // Subsurface position (parent state)
+    int videoY_;
+    bool videoActive_;
+    bool layerBypassEnabled_;
     
 #ifdef HAVE_EGL
     // EGL context for OpenGL
@@ -7,6 +7,7 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <cmath>
 #include <iostream>
 
 #if defined(PLATFORM_LINUX) || (!defined(PLATFORM_WINDOWS) && !defined(PLATFORM_OSX))
@@ -31,6 +32,12 @@
 #include <va/va.h>
 #include <va/va_x11.h>
 #endif
+
+#ifdef HAVE_X11_PRESENT
+#include <X11/Xlib-xcb.h>
+#include <xcb/present.h>
+#include <cstdlib>  // for free
+#endif
 #elif defined(PLATFORM_WINDOWS)
 #include <windows.h>
 #include <GL/gl.h>
@@ -69,6 +76,16 @@ X11Display::X11Display()
     , hglrc_(nullptr)
 #elif defined(PLATFORM_OSX)
     , nsContext_(nullptr)
+#endif
+    , rateBaseUst_(0)
+    , rateBaseMsc_(0)
+    , videoFps_(0.0)
+    , frameTag_(-1)
+    , frameLogEnabled_(false)
+#if defined(PLATFORM_LINUX) || (!defined(PLATFORM_WINDOWS) && !defined(PLATFORM_OSX))
+    , xcb_(nullptr)
+    , presentEvents_(nullptr)
+    , presentEventId_(0)
 #endif
     , windowWidth_(640)
     , windowHeight_(360)
@@ -140,6 +157,14 @@ bool X11Display::openWindow() {
     }
 
     clearCurrent();
+    
+#if defined(USE_GLX)
+    // Optional: without it frames are paced by the swap alone
+    if (!initPresent()) {
+        LOG_INFO << "X11 Present extension not available - no presentation timestamps";
+    }
+#endif
+    
     windowOpen_ = true;
     return true;
 }
@@ -157,6 +182,7 @@ void X11Display::closeWindow() {
     clearCurrent();
 
 #if defined(USE_GLX)
+    cleanupPresent();
 #ifdef HAVE_EGL
     // If EGL was initialized (pure EGL mode), use EGL cleanup which handles everything
     if (eglDisplay_ != EGL_NO_DISPLAY) {
@@ -188,34 +214,22 @@ void X11Display::render(LayerManager* layerManager, OSDManager* osdManager) {
 
     makeCurrent();
 
-    // Get all layers sorted by z-order
-    auto layers = layerManager->getLayersSortedByZOrder();
-    
-    // Convert to const vector for rendering
-    std::vector<const VideoLayer*> constLayers;
-    constLayers.reserve(layers.size());
-    for (auto* layer : layers) {
-        constLayers.push_back(layer);
-    }
+    // Layers in z-order, as last published by the layer manager
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    const std::vector<const VideoLayer*>& constLayers = scene->layers;
 
     // Set viewport
     renderer_->setViewport(0, 0, windowWidth_, windowHeight_);
 
     // Composite all layers
-    renderer_->compositeLayers(constLayers);
+    renderer_->compositeLayers(constLayers, scene->groups);
 
     // Render OSD if available
     if (osdManager && osdRenderer_) {
         auto osdItems = osdRenderer_->prepareOSDRender(osdManager, windowWidth_, windowHeight_);
         if (!osdItems.empty()) {
+            // Glyph atlas texture stays with the OSD renderer
             renderer_->renderOSDItems(osdItems);
-            
-            // Cleanup OSD textures after rendering (but before swapBuffers)
-            for (const auto& item : osdItems) {
-                if (item.textureId != 0) {
-                    glDeleteTextures(1, &item.textureId);
-                }
-            }
         }
     }
 
@@ -325,6 +339,55 @@ void* X11Display::getContext() {
 #endif
 }
 
+// Presentation timing
+void X11Display::setVideoFramerate(double fps) {
+    videoFps_ = fps;
+    presentationTiming_.setVideoFramerate(fps);
+}
+
+int64_t X11Display::getPresentationLeadNs() const {
+    int64_t lead = presentationTiming_.getTimeToNextVsync();
+    if (lead > 0 && !pendingSwaps_.empty()) {
+        // The next vblank shows the frame already swapped
+        int64_t duration = presentationTiming_.getVsyncDuration();
+        lead += duration > 0 ? duration : presentationTiming_.getExpectedVsyncDuration();
+    }
+    return lead;
+}
+
+bool X11Display::getTargetVblank(int64_t& msc, double& refreshHz) const {
+    int64_t next = presentationTiming_.getNextVsyncCounter();
+    if (next < 0 || presentationTiming_.getRefreshRate() <= 0.0) {
+        return false;
+    }
+    // Same vblank as getPresentationLeadNs()
+    msc = next + (pendingSwaps_.empty() ? 0 : 1);
+    refreshHz = presentationTiming_.getRefreshRate();
+    return true;
+}
+
+bool X11Display::setFrameLogEnabled(bool enabled, bool readback) {
+#if defined(USE_GLX)
+    // No canvas to read the frame code back from
+    if (!presentEvents_ || (enabled && readback)) {
+        return false;
+    }
+    frameLogEnabled_ = enabled;
+    presentationTiming_.setFrameLogEnabled(enabled);
+    if (!enabled) {
+        frameTag_ = -1;
+    }
+    return true;
+#else
+    (void)enabled; (void)readback;
+    return false;
+#endif
+}
+
+void X11Display::takePresentedFrames(std::vector<PresentedFrame>& out) {
+    presentationTiming_.takePresentedFrames(out);
+}
+
 // Platform-specific implementations
 #if defined(USE_GLX)
 bool X11Display::initGLX() {
@@ -539,18 +602,18 @@ bool X11Display::initEGL() {
     XSetWMProtocols(display_, window_, &wmDelete, 1);
     
     // Step 9: Create EGL context
-    // Use Compatibility Profile to support legacy fixed-function pipeline (glBegin/glEnd)
-    // which is still used by some rendering paths (software decode, HAP)
+    // Core Profile: the renderer only uses shaders and vertex arrays, and
+    // core contexts skip the compatibility state tracking in the driver
     EGLint contextAttribs[] = {
         EGL_CONTEXT_MAJOR_VERSION, 3,
         EGL_CONTEXT_MINOR_VERSION, 3,
-        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
         EGL_NONE
     };
     
     eglContext_ = eglCreateContext(eglDisplay_, eglConfig_, EGL_NO_CONTEXT, contextAttribs);
     if (eglContext_ == EGL_NO_CONTEXT) {
-        // Try without core profile (fallback for older drivers)
+        // Default context (fallback for older drivers; 3.3 is checked by the renderer)
         LOG_WARNING << "EGL core profile context failed, trying compatibility";
         EGLint fallbackAttribs[] = { EGL_NONE };
         eglContext_ = eglCreateContext(eglDisplay_, eglConfig_, EGL_NO_CONTEXT, fallbackAttribs);
@@ -779,6 +842,8 @@ bool X11Display::queryEGLExtensions() {
 void X11Display::handleEventsGLX() {
     if (!display_) return;
 
+    processPresentEvents();
+
     XEvent event;
     while (XPending(display_)) {
         XNextEvent(display_, &event);
@@ -855,16 +920,28 @@ void X11Display::clearCurrent() {
 
 void X11Display::swapBuffers() {
 #if defined(USE_GLX)
+    if (presentEvents_) {
+        // Drivers that bypass Present never complete; keep the queue bounded
+        if (pendingSwaps_.size() >= 8) {
+            pendingSwaps_.pop_front();
+        }
+        PendingSwap swap;
+        swap.readyNs = PresentationTiming::getCurrentTimeNs();
+        swap.tag = frameLogEnabled_ ? frameTag_ : -1;
+        pendingSwaps_.push_back(swap);
+    }
 #ifdef HAVE_EGL
     // Pure EGL path
     if (eglDisplay_ != EGL_NO_DISPLAY && eglSurface_ != EGL_NO_SURFACE) {
         eglSwapBuffers(eglDisplay_, eglSurface_);
+        processPresentEvents();
         return;
     }
 #endif
     // Fallback to GLX
     if (display_ && window_) {
         glXSwapBuffers(display_, window_);
+        processPresentEvents();
     }
 #elif defined(USE_WGL)
     if (hdc_) {
@@ -875,6 +952,103 @@ void X11Display::swapBuffers() {
 #endif
 }
 
+// Present extension: the driver presents each swap of the window, and every
+// client selecting the window gets its completion (like mpv's present_sync)
+bool X11Display::initPresent() {
+#ifdef HAVE_X11_PRESENT
+    if (!display_ || !window_) {
+        return false;
+    }
+    xcb_ = XGetXCBConnection(display_);
+    const xcb_query_extension_reply_t* extension = xcb_get_extension_data(xcb_, &xcb_present_id);
+    if (!extension || !extension->present) {
+        xcb_ = nullptr;
+        return false;
+    }
+    presentEventId_ = xcb_generate_id(xcb_);
+    xcb_present_select_input(xcb_, presentEventId_, static_cast<xcb_window_t>(window_),
+                             XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY);
+    presentEvents_ = xcb_register_for_special_xge(xcb_, &xcb_present_id, presentEventId_, nullptr);
+    xcb_flush(xcb_);
+    LOG_INFO << "X11 Present extension: pacing frames from swap completions";
+    return presentEvents_ != nullptr;
+#else
+    return false;
+#endif
+}
+
+void X11Display::cleanupPresent() {
+#ifdef HAVE_X11_PRESENT
+    if (presentEvents_) {
+        xcb_present_select_input(xcb_, presentEventId_, static_cast<xcb_window_t>(window_), 0);
+        xcb_unregister_for_special_event(xcb_, presentEvents_);
+        presentEvents_ = nullptr;
+    }
+    xcb_ = nullptr;
+#endif
+    pendingSwaps_.clear();
+}
+
+void X11Display::processPresentEvents() {
+#ifdef HAVE_X11_PRESENT
+    if (!presentEvents_) {
+        return;
+    }
+    xcb_generic_event_t* event;
+    while ((event = xcb_poll_for_special_event(xcb_, presentEvents_)) != nullptr) {
+        const xcb_present_generic_event_t* generic = reinterpret_cast<const xcb_present_generic_event_t*>(event);
+        if (generic->evtype == XCB_PRESENT_COMPLETE_NOTIFY) {
+            const xcb_present_complete_notify_event_t* complete =
+                reinterpret_cast<const xcb_present_complete_notify_event_t*>(event);
+            if (complete->kind == XCB_PRESENT_COMPLETE_KIND_PIXMAP) {
+                onSwapComplete(complete->ust, complete->msc, complete->mode == XCB_PRESENT_COMPLETE_MODE_SKIP);
+            }
+        }
+        free(event);
+    }
+#endif
+}
+
+void X11Display::onSwapComplete(uint64_t ust, uint64_t msc, bool skipped) {
+    // Completions come in swap order
+    PendingSwap swap;
+    if (!pendingSwaps_.empty()) {
+        swap = pendingSwaps_.front();
+        pendingSwaps_.pop_front();
+    }
+    presentationTiming_.recordQueueDepth(static_cast<int>(pendingSwaps_.size()));
+    if (skipped) {
+        // Replaced by a later swap before it was shown
+        presentationTiming_.recordBufferReplaced();
+        return;
+    }
+    
+    // UST is CLOCK_MONOTONIC in microseconds
+    unsigned int sec = static_cast<unsigned int>(ust / 1000000);
+    unsigned int usec = static_cast<unsigned int>(ust % 1000000);
+    presentationTiming_.recordFlip(sec, usec, static_cast<unsigned int>(msc));
+    
+    // Refresh rate from the counters; re-measured once the span is long
+    // enough to be exact, and from scratch when the window changes CRTC
+    if (rateBaseUst_ == 0 || msc <= rateBaseMsc_ || ust <= rateBaseUst_) {
+        rateBaseUst_ = ust;
+        rateBaseMsc_ = msc;
+    } else {
+        uint64_t span = msc - rateBaseMsc_;
+        double hz = span * 1e6 / static_cast<double>(ust - rateBaseUst_);
+        double current = presentationTiming_.getRefreshRate();
+        bool first = current <= 0.0 && span >= 8;
+        bool refined = current > 0.0 && span >= 240 && std::fabs(hz - current) > current * 0.0005;
+        if (first || refined) {
+            presentationTiming_.init(hz);
+            presentationTiming_.setVideoFramerate(videoFps_);
+            presentationTiming_.recordFlip(sec, usec, static_cast<unsigned int>(msc));
+        }
+    }
+    presentationTiming_.recordPresentedFrame(swap.tag);
+    presentationTiming_.recordBufferPresented(swap.readyNs);
+}
+
 #elif defined(USE_WGL)
 // Windows (WGL) implementation - NOT SUPPORTED
 // Only Linux GLX is implemented
@@ -3,6 +3,8 @@
 
 #include "DisplayBackend.h"
 #include "OpenGLRenderer.h"
+#include "drm/PresentationTiming.h"
+#include <deque>
 #include <memory>
 
 // Forward declarations for platform-specific types
@@ -11,6 +13,8 @@ struct _XDisplay;
 typedef struct _XDisplay Display;
 typedef unsigned long Window;
 typedef struct __GLXcontextRec *GLXContext;
+struct xcb_connection_t;
+struct xcb_special_event;
 
 // EGL forward declarations for platform-specific types (not in DisplayBackend)
 #ifdef HAVE_EGL
@@ -39,6 +43,9 @@ class LayerManager;
  * 
  * Implements DisplayBackend using X11 + EGL + OpenGL on Linux.
  * Supports multi-layer rendering and multi-display output (Xinerama).
+ *
+ * With the Present extension, the completion (UST/MSC) of every swap of
+ * the window is fed to PresentationTiming, as page flips are on DRM.
  * 
  * Note: This backend uses X11 for windowing and EGL for OpenGL context.
  *       For Wayland systems, use WaylandDisplay instead.
@@ -65,6 +72,14 @@ public:
     bool supportsMultiDisplay() const override { return true; }
     void* getContext() override;
 
+    // Presentation timing (from Present complete notifications)
+    void setVideoFramerate(double fps) override;
+    int64_t getPresentationLeadNs() const override;
+    bool getTargetVblank(int64_t& msc, double& refreshHz) const override;
+    bool setFrameLogEnabled(bool enabled, bool readback) override;
+    void setFrameTag(int64_t tag) override { frameTag_ = tag; }
+    void takePresentedFrames(std::vector<PresentedFrame>& out) override;
+
     // OpenGL context management (override DisplayBackend interface)
     void makeCurrent() override;
     void clearCurrent() override;
@@ -115,6 +130,12 @@ private:
     // OpenGL context management (implementation details)
     void swapBuffers();
 
+    // Present extension (swap completion timestamps)
+    bool initPresent();
+    void cleanupPresent();
+    void processPresentEvents();
+    void onSwapComplete(uint64_t ust, uint64_t msc, bool skipped);
+
     // Window management
     void setupWindowHints();
     void updateWindowProperties();
@@ -160,6 +181,24 @@ private:
     void* nsContext_;
 #endif
 
+    // Swaps waiting for their completion, oldest first
+    struct PendingSwap {
+        int64_t readyNs = 0;     // Swapped at (monotonic)
+        int64_t tag = -1;        // Frame number it shows
+    };
+    std::deque<PendingSwap> pendingSwaps_;
+    PresentationTiming presentationTiming_;
+    uint64_t rateBaseUst_;       // First completion the refresh rate is measured from
+    uint64_t rateBaseMsc_;
+    double videoFps_;
+    int64_t frameTag_;
+    bool frameLogEnabled_;
+#if defined(PLATFORM_LINUX) || (!defined(PLATFORM_WINDOWS) && !defined(PLATFORM_OSX))
+    xcb_connection_t* xcb_;      // Xlib's connection (not owned)
+    struct xcb_special_event* presentEvents_;
+    uint32_t presentEventId_;
+#endif
+
     // Window state
     unsigned int windowWidth_;
     unsigned int windowHeight_;
@@ -8,12 +8,21 @@
 #include "../../layer/LayerManager.h"
 #include "../../layer/VideoLayer.h"
 #include "../../osd/OSDManager.h"
+#include "../../video/FrameCode.h"
+#include "PlaneAssignment.h"
 #include "../../utils/Logger.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>  // for getenv
+#include <cmath>
+#include <cerrno>
+#include <thread>
+#include <poll.h>
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <xf86drmMode.h>  // for atomic modesetting
+#include <drm_fourcc.h>
 
 #ifdef HAVE_VAAPI_INTEROP
 #include <va/va.h>
@@ -44,6 +53,9 @@ bool DRMBackend::openWindow() {
         LOG_ERROR << "DRMBackend: Failed to initialize DRM output manager";
         return false;
     }
+    outputManager_->setHotplugCallback([this](const OutputInfo& info, bool connected) {
+        onHotplug(info.name, connected);
+    });
     
     // Apply resolution mode before creating surfaces
     // This modifies the output dimensions in outputManager_
@@ -78,11 +90,32 @@ bool DRMBackend::openWindow() {
     EGLDisplay sharedDisplay = EGL_NO_DISPLAY;
     gbm_device* sharedGbmDevice = nullptr;
     
+    const char* buffers = std::getenv("VIDEOCOMPOSER_DRM_BUFFERS");
+    if (buffers && std::string(buffers) == "2") {
+        LOG_INFO << "DRMBackend: Double-buffered flips via VIDEOCOMPOSER_DRM_BUFFERS";
+        swapchainBuffers_ = 2;
+    }
+    
+    const char* noFences = std::getenv("VIDEOCOMPOSER_NO_EXPLICIT_FENCES");
+    if (noFences && (std::string(noFences) == "1" || std::string(noFences) == "true")) {
+        LOG_INFO << "DRMBackend: Explicit fencing disabled via VIDEOCOMPOSER_NO_EXPLICIT_FENCES (glFinish before flips)";
+        explicitFencingEnabled_ = false;
+    }
+    
+    const char* noModifiers = std::getenv("VIDEOCOMPOSER_NO_MODIFIERS");
+    if (noModifiers && (std::string(noModifiers) == "1" || std::string(noModifiers) == "true")) {
+        LOG_INFO << "DRMBackend: Plane modifiers disabled via VIDEOCOMPOSER_NO_MODIFIERS (implicit buffer layouts)";
+        modifiersEnabled_ = false;
+    }
+    
     for (const auto& outputInfo : outputs) {
         const std::string& outputName = outputInfo.name;
         LOG_INFO << "DRMBackend: Creating surface for " << outputName;
         
         auto surface = std::make_unique<DRMSurface>(outputManager_.get(), outputName);
+        surface->setBufferCount(swapchainBuffers_);
+        surface->setExplicitFencingAllowed(explicitFencingEnabled_);
+        surface->setModifiersAllowed(modifiersEnabled_);
         
         // Pass shared resources to subsequent surfaces
         if (!surface->init(sharedContext, sharedDisplay, sharedGbmDevice)) {
@@ -121,6 +154,30 @@ bool DRMBackend::openWindow() {
     if (primary) {
         primary->makeCurrent();
         
+        const char* disableScanout = std::getenv("VIDEOCOMPOSER_NO_DIRECT_SCANOUT");
+        if (disableScanout && (std::string(disableScanout) == "1" || std::string(disableScanout) == "true")) {
+            LOG_INFO << "DRMBackend: Direct scanout disabled via VIDEOCOMPOSER_NO_DIRECT_SCANOUT";
+            directScanoutEnabled_ = false;
+        }
+        
+        const char* syncFlips = std::getenv("VIDEOCOMPOSER_SYNC_FLIPS");
+        if (syncFlips && (std::string(syncFlips) == "1" || std::string(syncFlips) == "true")) {
+            LOG_INFO << "DRMBackend: Independent flip pacing disabled via VIDEOCOMPOSER_SYNC_FLIPS";
+            independentFlipsEnabled_ = false;
+        }
+        
+        const char* disableBypass = std::getenv("VIDEOCOMPOSER_NO_PLANE_BYPASS");
+        if (disableBypass && (std::string(disableBypass) == "1" || std::string(disableBypass) == "true")) {
+            LOG_INFO << "DRMBackend: Plane bypass disabled via VIDEOCOMPOSER_NO_PLANE_BYPASS";
+            layerBypassEnabled_ = false;
+        }
+        
+        const char* disableOverlays = std::getenv("VIDEOCOMPOSER_NO_OVERLAY_PLANES");
+        if (disableOverlays && (std::string(disableOverlays) == "1" || std::string(disableOverlays) == "true")) {
+            LOG_INFO << "DRMBackend: Overlay planes disabled via VIDEOCOMPOSER_NO_OVERLAY_PLANES";
+            overlayPlanesEnabled_ = false;
+        }
+        
         // Check for environment variable to disable Virtual Canvas (for debugging)
         const char* disableVC = std::getenv("VIDEOCOMPOSER_NO_VIRTUAL_CANVAS");
         if (disableVC && (std::string(disableVC) == "1" || std::string(disableVC) == "true")) {
@@ -169,15 +226,34 @@ void DRMBackend::closeWindow() {
 #endif
     
     // Cleanup renderers
+    overlayPlanes_.reset();
+    layerScanout_.reset();
+    scanoutCanvas_.reset();
     multiRenderer_.reset();
     renderer_.reset();
     outputRegions_.clear();
     
-    // Cleanup surfaces
+    // Cleanup surfaces (unplugged and replaced ones last: the first surface
+    // may be among them, and it owns the shared EGL context)
+    for (auto& [name, pending] : preparingSurfaces_) {
+        std::unique_ptr<DRMSurface> surface = pending.get();
+        if (surface) {
+            surface->cleanup();
+        }
+    }
+    preparingSurfaces_.clear();
     for (auto& [name, surface] : surfaces_) {
         surface->cleanup();
     }
     surfaces_.clear();
+    for (auto& [name, surface] : parkedSurfaces_) {
+        surface->cleanup();
+    }
+    parkedSurfaces_.clear();
+    for (auto& surface : retiredSurfaces_) {
+        surface->cleanup();
+    }
+    retiredSurfaces_.clear();
     
     // Cleanup DRM
     outputManager_->cleanup();
@@ -186,11 +262,17 @@ void DRMBackend::closeWindow() {
 }
 
 bool DRMBackend::isWindowOpen() const {
-    return initialized_ && !surfaces_.empty();
+    // Still open with every output unplugged (a projector power-cycling)
+    return initialized_ && (!surfaces_.empty() || !parkedSurfaces_.empty());
 }
 
 void DRMBackend::render(LayerManager* layerManager, OSDManager* osdManager) {
-    if (!initialized_ || surfaces_.empty()) {
+    if (!initialized_) {
+        return;
+    }
+    if (surfaces_.empty()) {
+        // No vblank to pace the loop until an output comes back
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
         return;
     }
     
@@ -217,16 +299,87 @@ void DRMBackend::renderVirtualCanvas(LayerManager* layerManager, OSDManager* osd
         surface->processFlipEvents();
     }
     
+    // Mixed refresh rates: only outputs whose last flip completed are drawn,
+    // so the loop runs at the fastest output's rate
+    bool independent = independentFlipsEnabled_ && mixedRefreshRates();
+    updateFlipGroups(independent);
+    if (independent) {
+        waitForFreeOutput();
+    }
+    multiRenderer_->setSkipBusyOutputs(independent);
+    
     primary->makeCurrent();
     
+    // Composite into the scanout buffers when the outputs are plain crops
+    // (one commit covers every CRTC, so only with matching refresh rates)
+    bool direct = !independent && !frameLogEnabled_ && directScanoutAvailable();
+    if (direct != multiRenderer_->isDirectScanout()) {
+        VirtualCanvas* canvas = multiRenderer_->getCanvas();
+        canvas->setExternalTargets(direct ? scanoutCanvas_->getRenderTargets()
+                                          : std::vector<VirtualCanvas::RenderTarget>());
+        multiRenderer_->setDirectScanout(direct);
+        LOG_INFO << "DRMBackend: " << (direct ? "Scanning out the canvas directly" : "Blitting canvas regions to outputs");
+    }
+    
+    // A lone full-screen VAAPI layer goes straight to the plane
+    if (direct && presentLayerBypass(layerManager, osdManager)) {
+        // The canvas was not drawn this frame
+        multiRenderer_->invalidateCanvas();
+        primary->releaseCurrent();
+        return;
+    }
+    
+    // Picture-in-picture layers on overlay planes, the rest composited; the
+    // other paths commit the outputs' primary planes only
+    if (direct) {
+        assignOverlayPlanes(layerManager, osdManager);
+    } else {
+        releaseOverlayPlanes();
+    }
+    
+    // Outputs flipped one by one go through their own swapchain (mailbox);
+    // a single atomic commit across CRTCs waits for every output instead
+    bool perSurface = !independent && !direct && (frameLogEnabled_ || !atomicFlipsAvailable());
+    if (perSurface) {
+        for (auto& [name, surface] : surfaces_) {
+            surface->acquireRenderBuffer();
+        }
+    }
+    
     // MultiOutputRenderer::render() handles:
     // 1. Rendering all layers to VirtualCanvas
     // 2. Blitting regions to each output surface (with blend/warp)
     // 3. Swapping buffers on each surface
     multiRenderer_->render(layerManager, osdManager);
+    if (frameLogReadback_) {
+        setFrameTag(readFrameCode());
+    }
     
     primary->releaseCurrent();
     
+    if (perSurface) {
+        for (auto& [name, surface] : surfaces_) {
+            surface->presentFrame();
+        }
+        return;
+    }
+    
+    if (independent) {
+        // Per-CRTC flip events; busy outputs (and groups) were not drawn
+        // this frame. A group's commit marks all of it pending.
+        for (auto& [name, surface] : surfaces_) {
+            if (surface->isFlipPending()) {
+                continue;
+            }
+            if (surface->getFlipPeers().empty()) {
+                surface->scheduleAtomicPageFlip();
+            } else {
+                groupPageFlip(surface.get());
+            }
+        }
+        return;
+    }
+    
     // Wait for all pending flips to complete first
     for (auto& [name, surface] : surfaces_) {
         if (surface->isFlipPending()) {
@@ -234,33 +387,47 @@ void DRMBackend::renderVirtualCanvas(LayerManager* layerManager, OSDManager* osd
         }
     }
     
-    // Check if we can use atomic modesetting with planes
-    bool useAtomic = outputManager_->supportsAtomic() && surfaces_.size() > 1;
-    bool allHavePlanes = true;
-    bool allModesSet = true;
-    
-    if (useAtomic) {
-        for (auto& [name, surface] : surfaces_) {
-            if (!surface->getPlane()) {
-                allHavePlanes = false;
+    if (direct) {
+        bool overlays = overlayPlanes_ && !overlayPlanes_->getPending().empty();
+        if (overlays && !scanoutPageFlip()) {
+            // Tested, yet refused: this frame goes out without the layers
+            // on planes, the next one composites them again
+            LOG_WARNING << "DRMBackend: Overlay plane commit failed, compositing every layer";
+            overlayPlanesEnabled_ = false;
+            overlays = false;
+            releaseOverlayPlanes();
+        }
+        if (!overlays && !scanoutPageFlip()) {
+            // Blits from the next frame on
+            LOG_WARNING << "DRMBackend: Direct scanout commit failed, disabling direct scanout";
+            directScanoutEnabled_ = false;
+        } else {
+            if (layerScanout_) {
+                layerScanout_->noteGLFrame();
             }
-            if (!surface->isModeSet()) {
-                allModesSet = false;
+            if (overlayPlanes_) {
+                overlayPlanes_->noteCommitted();   // Planes no longer used are off
             }
         }
-        useAtomic = allHavePlanes && allModesSet;
+        return;
     }
     
-    if (useAtomic) {
-        // ATOMIC PATH: Submit all page flips in single atomic commit
-        // All outputs flip on same vsync = 60fps for any number of outputs
-        atomicPageFlip();
-    } else {
-        // LEGACY PATH: Sequential page flips (single output or no atomic/planes)
-        for (auto& [name, surface] : surfaces_) {
-            surface->schedulePageFlip();
+    // ATOMIC PATH: Submit all page flips in single atomic commit
+    // All outputs flip on same vsync = 60fps for any number of outputs
+    atomicPageFlip();
+}
+
+bool DRMBackend::atomicFlipsAvailable() const {
+    // Single output or no atomic/planes: sequential page flips
+    if (!outputManager_->supportsAtomic() || surfaces_.size() <= 1) {
+        return false;
+    }
+    for (const auto& [name, surface] : surfaces_) {
+        if (!surface->getPlane() || !surface->isModeSet()) {
+            return false;
         }
     }
+    return true;
 }
 
 bool DRMBackend::atomicPageFlip() {
@@ -270,9 +437,18 @@ bool DRMBackend::atomicPageFlip() {
         return false;
     }
     
-    std::vector<DRMSurface*> preparedSurfaces;
+    ArenaVector<DRMSurface*> preparedSurfaces;
     bool success = true;
     
+    // With explicit fencing the commit need not block: the kernel waits for
+    // the render fences and each CRTC's out fence tells when it flipped
+    bool nonBlocking = true;
+    for (const auto& [name, surface] : surfaces_) {
+        nonBlocking = nonBlocking && surface->hasExplicitFencing() && surface->getOutFencePtrProperty() != 0;
+    }
+    ArenaVector<int32_t> outFences;   // Written by the kernel: no reallocation from here
+    outFences.resize(surfaces_.size(), -1);
+    
     // Prepare each surface and add to atomic request
     for (auto& [name, surface] : surfaces_) {
         uint32_t fbId = surface->prepareAtomicFlip();
@@ -290,34 +466,22 @@ bool DRMBackend::atomicPageFlip() {
             break;
         }
         
-        // Set plane properties for atomic commit
-        // FB_ID - the framebuffer to display
-        if (drmModeAtomicAddProperty(request, plane->planeId, plane->propFbId, fbId) < 0) {
-            LOG_WARNING << "DRMBackend: Failed to set FB_ID for plane " << plane->planeId;
-            success = false;
-            break;
+        // Every plane in the one request: all CRTCs flip on the same vblank
+        DRMOutputManager::PlaneFlip flip;
+        flip.plane = plane;
+        flip.crtcId = surface->getCrtcId();
+        flip.fbId = fbId;
+        flip.width = surface->getWidth();
+        flip.height = surface->getHeight();
+        flip.inFence = surface->getPendingFence();
+        if (nonBlocking) {
+            flip.outFencePtrProp = surface->getOutFencePtrProperty();
+            flip.outFence = &outFences[preparedSurfaces.size() - 1];
         }
-        
-        // CRTC_ID - which CRTC this plane is connected to
-        if (drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcId, surface->getCrtcId()) < 0) {
-            LOG_WARNING << "DRMBackend: Failed to set CRTC_ID for plane " << plane->planeId;
+        if (!outputManager_->addPlaneFlip(request, flip)) {
             success = false;
             break;
         }
-        
-        // Source rectangle (in 16.16 fixed point)
-        uint32_t w = surface->getWidth();
-        uint32_t h = surface->getHeight();
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcX, 0);
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcY, 0);
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcW, w << 16);
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcH, h << 16);
-        
-        // Destination rectangle
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcX, 0);
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcY, 0);
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcW, w);
-        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcH, h);
     }
     
     if (success) {
@@ -325,10 +489,14 @@ bool DRMBackend::atomicPageFlip() {
         // Use ALLOW_MODESET to permit mode changes if needed
         // Don't use PAGE_FLIP_EVENT since we handle buffer release in finalizeAtomicFlip
         uint32_t flags = DRM_MODE_ATOMIC_ALLOW_MODESET;
+        if (nonBlocking) {
+            flags |= DRM_MODE_ATOMIC_NONBLOCK;
+        }
         if (outputManager_->commitAtomic(request, flags)) {
-            // Success - finalize all surfaces (releases buffers immediately)
-            for (auto* surface : preparedSurfaces) {
-                surface->finalizeAtomicFlip();
+            // Success - finalize all surfaces (releases buffers immediately;
+            // after a non-blocking commit, once the out fence has signalled)
+            for (size_t i = 0; i < preparedSurfaces.size(); ++i) {
+                preparedSurfaces[i]->finalizeAtomicFlip(outFences[i]);
             }
         } else {
             LOG_WARNING << "DRMBackend: Atomic commit failed";
@@ -350,6 +518,519 @@ bool DRMBackend::atomicPageFlip() {
     return success;
 }
     
+bool DRMBackend::directScanoutAvailable() {
+    if (!directScanoutEnabled_ || !multiRenderer_ || !outputManager_->supportsAtomic() ||
+        !multiRenderer_->canScanoutDirectly()) {
+        return false;
+    }
+    // The first frames set the modes through the surfaces
+    for (auto& [name, surface] : surfaces_) {
+        DRMPlane* plane = surface->getPlane();
+        if (!plane || !plane->propertiesLoaded || !surface->isModeSet()) {
+            return false;
+        }
+    }
+    
+    int width = multiRenderer_->getCanvasWidth();
+    int height = multiRenderer_->getCanvasHeight();
+    if (scanoutCanvas_ && scanoutCanvas_->getWidth() == width && scanoutCanvas_->getHeight() == height) {
+        return true;
+    }
+    
+    // (Re)allocate for the current canvas size
+    if (multiRenderer_->isDirectScanout()) {
+        multiRenderer_->getCanvas()->setExternalTargets({});
+        multiRenderer_->setDirectScanout(false);
+    }
+    // Every plane scans out the same buffers: only layouts all of them take
+    std::vector<uint64_t> modifiers;
+    bool firstPlane = true;
+    for (auto& [name, surface] : surfaces_) {
+        const DRMPlane* plane = surface->getPlane();
+        if (!modifiersEnabled_ || plane->inFormats.empty()) {
+            modifiers.clear();
+            break;
+        }
+        std::vector<uint64_t> planeModifiers = plane->inFormats.getModifiers(GBM_FORMAT_XRGB8888);
+        modifiers = firstPlane ? planeModifiers : FormatModifierTable::intersect(modifiers, planeModifiers);
+        firstPlane = false;
+    }
+    
+    DRMSurface* primary = getPrimarySurface();
+    scanoutCanvas_ = std::make_unique<ScanoutCanvas>(outputManager_.get());
+    if (!primary || !scanoutCanvas_->init(primary->getGbmDevice(), primary->getDisplay(), width, height,
+                                          eglCreateImageKHR_, eglDestroyImageKHR_,
+                                          glEGLImageTargetTexture2DOES_, modifiers)) {
+        LOG_INFO << "DRMBackend: Direct scanout not available, blitting canvas regions";
+        scanoutCanvas_.reset();
+        directScanoutEnabled_ = false;
+        return false;
+    }
+    return true;
+}
+
+bool DRMBackend::scanoutPageFlip(bool testOnly) {
+    uint32_t fbId = scanoutCanvas_ ? scanoutCanvas_->getFbId(multiRenderer_->getCanvas()->getCurrentTarget()) : 0;
+    if (fbId == 0) {
+        return false;
+    }
+    
+    drmModeAtomicReq* request = outputManager_->createAtomicRequest();
+    if (!request) {
+        LOG_WARNING << "DRMBackend: Failed to create atomic request";
+        return false;
+    }
+    
+    int canvasHeight = scanoutCanvas_->getHeight();
+    bool success = true;
+    for (auto& [name, surface] : surfaces_) {
+        auto region = std::find_if(outputRegions_.begin(), outputRegions_.end(),
+                                   [&name](const OutputRegion& r) { return r.name == name; });
+        if (region == outputRegions_.end()) {
+            success = false;
+            break;
+        }
+        
+        DRMPlane* plane = surface->getPlane();
+        uint32_t w = static_cast<uint32_t>(region->canvasWidth);
+        uint32_t h = static_cast<uint32_t>(region->canvasHeight);
+        // Canvas regions are bottom-up (GL), the buffer is stored top-down
+        uint32_t srcX = static_cast<uint32_t>(region->canvasX);
+        uint32_t srcY = static_cast<uint32_t>(canvasHeight - region->canvasY - region->canvasHeight);
+        
+        if (drmModeAtomicAddProperty(request, plane->planeId, plane->propFbId, fbId) < 0 ||
+            drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcId, surface->getCrtcId()) < 0) {
+            success = false;
+            break;
+        }
+        
+        // Source rectangle: this output's region of the canvas (16.16 fixed point)
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcX, srcX << 16);
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcY, srcY << 16);
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcW, w << 16);
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propSrcH, h << 16);
+        
+        // Destination rectangle (regions are 1:1, see canScanoutDirectly)
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcX, 0);
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcY, 0);
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcW, w);
+        drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcH, h);
+    }
+    
+    // Layers on overlay planes change on the same vblank as the canvas
+    if (success && overlayPlanes_) {
+        success = overlayPlanes_->addToRequest(request);
+    }
+    
+    // Blocking commit: the previous canvas buffer is free once it returns.
+    // Rendering was flushed in VirtualCanvas::endFrame; the kernel waits for
+    // the buffer's implicit fence before scanning it out.
+    if (success) {
+        success = outputManager_->commitAtomic(request, DRM_MODE_ATOMIC_ALLOW_MODESET |
+                                                        (testOnly ? DRM_MODE_ATOMIC_TEST_ONLY : 0));
+    }
+    
+    drmModeAtomicFree(request);
+    return success;
+}
+
+bool DRMBackend::mixedRefreshRates() const {
+    double first = 0.0;
+    for (const auto& [name, surface] : surfaces_) {
+        double rate = surface->getOutputInfo().refreshRate;
+        if (rate <= 0.0) {
+            continue;
+        }
+        if (first <= 0.0) {
+            first = rate;
+        } else if (std::abs(rate - first) > 0.5) {  // OutputMode::matches tolerance
+            return true;
+        }
+    }
+    return false;
+}
+
+void DRMBackend::updateFlipGroups(bool grouped) {
+    // Outputs at the same refresh rate flip in one commit, so they land on
+    // the same vblank even while other outputs run at another rate
+    auto groupable = [this](const DRMSurface* surface) {
+        return outputManager_->supportsAtomic() && surface->getPlane() &&
+               surface->getPlane()->propertiesLoaded && surface->isModeSet();
+    };
+    auto peers = [&](const DRMSurface* a, const DRMSurface* b) {
+        return grouped && a != b && groupable(a) && groupable(b) &&
+               std::abs(a->getOutputInfo().refreshRate - b->getOutputInfo().refreshRate) <= 0.5;
+    };
+    
+    bool changed = false;
+    for (const auto& [nameA, a] : surfaces_) {
+        size_t count = 0;
+        for (const auto& [nameB, b] : surfaces_) {
+            if (peers(a.get(), b.get())) {
+                const std::vector<DRMSurface*>& current = a->getFlipPeers();
+                changed = changed || std::find(current.begin(), current.end(), b.get()) == current.end();
+                ++count;
+            }
+        }
+        changed = changed || count != a->getFlipPeers().size();
+    }
+    if (!changed) {
+        return;
+    }
+    
+    // Flip events in flight are routed through the old groups
+    for (auto& [name, surface] : surfaces_) {
+        surface->waitForFlip();
+    }
+    for (auto& [nameA, a] : surfaces_) {
+        a->clearFlipPeers();
+        for (auto& [nameB, b] : surfaces_) {
+            if (peers(a.get(), b.get())) {
+                a->addFlipPeer(b.get());
+            }
+        }
+        if (!a->getFlipPeers().empty()) {
+            LOG_INFO << "DRMBackend: " << nameA << " flips with " << a->getFlipPeers().size()
+                     << " output(s) at " << a->getOutputInfo().refreshRate << " Hz";
+        }
+    }
+}
+
+bool DRMBackend::groupPageFlip(DRMSurface* leader) {
+    drmModeAtomicReq* request = outputManager_->createAtomicRequest();
+    if (!request) {
+        return leader->scheduleAtomicPageFlip();
+    }
+    
+    ArenaVector<DRMSurface*> group;
+    group.push_back(leader);
+    for (DRMSurface* peer : leader->getFlipPeers()) {
+        group.push_back(peer);
+    }
+    
+    size_t prepared = 0;
+    while (prepared < group.size() && group[prepared]->addAtomicPageFlip(request)) {
+        ++prepared;
+    }
+    
+    // One ioctl, one flip event per CRTC (routed through the leader's peers)
+    bool success = prepared == group.size() &&
+                   outputManager_->commitAtomic(request, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, leader);
+    drmModeAtomicFree(request);
+    
+    for (size_t i = 0; i < prepared; ++i) {
+        if (success) {
+            group[i]->atomicPageFlipScheduled();
+        } else {
+            group[i]->cancelAtomicFlip();
+        }
+    }
+    if (!success && prepared < group.size()) {
+        // A member cannot join the commit: flip them one by one
+        LOG_WARNING << "DRMBackend: Group flip unavailable, flipping outputs separately";
+        for (DRMSurface* surface : group) {
+            surface->scheduleAtomicPageFlip();
+        }
+    }
+    return success;
+}
+
+void DRMBackend::waitForFreeOutput() {
+    auto allPending = [this]() {
+        for (auto& [name, surface] : surfaces_) {
+            if (!surface->isFlipPending()) {
+                return false;
+            }
+        }
+        return !surfaces_.empty();
+    };
+    
+    struct pollfd pfd = {};
+    pfd.fd = outputManager_->getFd();
+    pfd.events = POLLIN;
+    while (allPending()) {
+        int ret = poll(&pfd, 1, 1000);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            LOG_WARNING << "DRMBackend: Page flip timeout";
+            for (auto& [name, surface] : surfaces_) {
+                surface->waitForFlip();
+            }
+            return;
+        }
+        // Events are dispatched to their own surface, whichever one reads them
+        surfaces_.begin()->second->processFlipEvents();
+    }
+}
+
+bool DRMBackend::presentLayerBypass(LayerManager* layerManager, OSDManager* osdManager) {
+    if (!layerBypassEnabled_ || !layerManager || surfaces_.size() != 1 || outputRegions_.size() != 1) {
+        return false;
+    }
+    // OSD and master effects are drawn by GL
+    OpenGLRenderer* renderer = multiRenderer_->getRenderer();
+    if (!renderer || (osdManager && osdManager->getMode() != 0) || renderer->masterProperties().isActive()) {
+        return false;
+    }
+    // The output must show the whole canvas
+    const OutputRegion& region = outputRegions_.front();
+    if (region.canvasX != 0 || region.canvasY != 0 ||
+        region.canvasWidth != multiRenderer_->getCanvasWidth() ||
+        region.canvasHeight != multiRenderer_->getCanvasHeight()) {
+        return false;
+    }
+    
+    // Exactly one visible layer, drawn as-is
+    const VideoLayer* layer = nullptr;
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    for (const VideoLayer* candidate : scene->layers) {
+        if (!candidate || !candidate->isReady() || !candidate->properties().visible) {
+            continue;
+        }
+        if (layer) {
+            return false;
+        }
+        layer = candidate;
+    }
+    if (!layer) {
+        return false;
+    }
+    const LayerProperties& props = layer->properties();
+    if (props.x != 0 || props.y != 0 || props.scaleX != 1.0f || props.scaleY != 1.0f ||
+        props.rotation != 0.0f || props.opacity != 1.0f || props.crop.enabled || props.panoramaMode ||
+        props.cornerDeform.enabled || props.colorAdjust.isActive() ||
+        props.blendMode != LayerProperties::NORMAL || props.groupId != 0 ||
+        props.packedAlpha != PackedAlpha::Layout::NONE || props.effects.isActive()) {
+        return false;
+    }
+    
+    const FrameBuffer* cpuBuffer = nullptr;
+    const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+    if (!layer->getPreparedFrame(cpuBuffer, gpuBuffer) || !gpuBuffer ||
+        gpuBuffer->getPlaneType() != TexturePlaneType::YUV_NV12 ||
+        !gpuBuffer->getDmaBufPlanes().isValid()) {
+        return false;
+    }
+    
+    // The primary plane alone shows the frame
+    releaseOverlayPlanes();
+    if (!layerScanout_) {
+        layerScanout_ = std::make_unique<LayerScanout>(outputManager_.get());
+    }
+    const FrameInfo& info = gpuBuffer->info();
+    DRMSurface* surface = surfaces_.begin()->second.get();
+    if (!layerScanout_->present(surface, gpuBuffer->getDmaBufPlanes(), info.aspect,
+                                renderer->getLetterbox(), info.colorMatrix, info.colorRange)) {
+        // e.g. the plane has no NV12 support or cannot scale
+        LOG_INFO << "DRMBackend: Plane cannot show decoder surfaces, compositing instead";
+        layerBypassEnabled_ = false;
+        return false;
+    }
+    return true;
+}
+    
+void DRMBackend::assignOverlayPlanes(LayerManager* layerManager, OSDManager* osdManager) {
+    OpenGLRenderer* renderer = multiRenderer_->getRenderer();
+    if (!renderer) {
+        return;
+    }
+    // OSD and master effects are drawn by GL over every layer
+    std::vector<OverlayPlanes::Placement> placements;
+    if (overlayPlanesEnabled_ && layerManager && !(osdManager && osdManager->getMode() != 0) &&
+        !renderer->masterProperties().isActive() && multiRenderer_->getCanvas()->getRenderScale() >= 1.0f) {
+        placements = planOverlayPlanes(layerManager, renderer);
+    }
+    if (placements.empty() && !(overlayPlanes_ && overlayPlanes_->isActive())) {
+        releaseOverlayPlanes();
+        return;
+    }
+    if (!overlayPlanes_) {
+        overlayPlanes_ = std::make_unique<OverlayPlanes>(outputManager_.get());
+    }
+    
+    // Steady layouts are tested once; a refused layout gives its bottom
+    // layer back to the composite until the driver takes the rest
+    auto signature = [](const std::vector<OverlayPlanes::Placement>& pending) {
+        std::vector<int64_t> key;
+        for (const OverlayPlanes::Placement& p : pending) {
+            key.insert(key.end(), {static_cast<int64_t>(p.plane->planeId), p.layerId, p.dstX, p.dstY, p.dstW, p.dstH,
+                                   std::lround(p.srcW), std::lround(p.srcH), p.opacity < 1.0f ? 1 : 0,
+                                   static_cast<int64_t>(p.frame.modifier)});
+        }
+        return key;
+    };
+    overlayPlanes_->setPending(std::move(placements));
+    std::vector<OverlayPlanes::Placement>& pending = overlayPlanes_->getPending();
+    while (!pending.empty() && signature(pending) != overlayAccepted_) {
+        if (scanoutPageFlip(true)) {
+            overlayAccepted_ = signature(pending);
+            break;
+        }
+        const OverlayPlanes::Placement& refused = pending.front();
+        LOG_VERBOSE << "DRMBackend: Plane " << refused.plane->planeId << " refused layer " << refused.layerId
+                    << " at " << refused.dstW << "x" << refused.dstH;
+        overlayRejected_[refused.layerId] = (static_cast<int64_t>(refused.dstW) << 32) | refused.dstH;
+        pending.erase(pending.begin());
+    }
+    
+    // The composite draws what left or joined the planes
+    std::vector<int> layerIds;
+    for (const OverlayPlanes::Placement& p : pending) {
+        layerIds.push_back(p.layerId);
+    }
+    if (layerIds != renderer->getPlaneLayers()) {
+        renderer->setPlaneLayers(std::move(layerIds));
+        multiRenderer_->invalidateCanvas();
+    }
+}
+
+std::vector<OverlayPlanes::Placement> DRMBackend::planOverlayPlanes(LayerManager* layerManager, OpenGLRenderer* renderer) {
+    std::vector<OverlayPlanes::Placement> placements;
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    // Group images are composited with no bounds known here
+    if (!scene->groups.empty()) {
+        return placements;
+    }
+    
+    // Each output's overlay planes and canvas rectangle (top row first, as
+    // the scanout buffer is stored)
+    struct Output {
+        DRMSurface* surface = nullptr;
+        PlaneCandidate bounds;
+        std::vector<DRMPlane*> planes;
+        bool alpha = true;   // Every plane fades
+    };
+    std::vector<Output> outputs;
+    std::vector<int> planesPerOutput;
+    std::vector<const DRMPlane*> taken;
+    int canvasHeight = multiRenderer_->getCanvasHeight();
+    for (auto& [name, surface] : surfaces_) {
+        auto region = std::find_if(outputRegions_.begin(), outputRegions_.end(),
+                                   [&name](const OutputRegion& r) { return r.name == name; });
+        if (region == outputRegions_.end()) {
+            continue;
+        }
+        Output output;
+        output.surface = surface.get();
+        output.bounds.x0 = static_cast<float>(region->canvasX);
+        output.bounds.x1 = static_cast<float>(region->canvasX + region->canvasWidth);
+        output.bounds.y0 = static_cast<float>(canvasHeight - region->canvasY - region->canvasHeight);
+        output.bounds.y1 = static_cast<float>(canvasHeight - region->canvasY);
+        for (DRMPlane* plane : outputManager_->getOverlayPlanesForCrtc(surface->getCrtcId())) {
+            // A plane several CRTCs can use serves the first of them
+            if (std::find(taken.begin(), taken.end(), plane) != taken.end() ||
+                (!plane->inFormats.empty() && plane->inFormats.getModifiers(DRM_FORMAT_NV12).empty())) {
+                continue;
+            }
+            taken.push_back(plane);
+            output.planes.push_back(plane);
+            output.alpha = output.alpha && plane->propAlpha != 0;
+        }
+        planesPerOutput.push_back(static_cast<int>(output.planes.size()));
+        outputs.push_back(std::move(output));
+    }
+    if (taken.empty()) {
+        return placements;
+    }
+    
+    // Visible layers, bottom to top, with what their plane would show
+    std::vector<PlaneCandidate> candidates;
+    std::vector<OverlayPlanes::Placement> wanted;
+    for (const VideoLayer* layer : scene->layers) {
+        if (!layer || !layer->isReady() || !layer->properties().visible) {
+            continue;
+        }
+        PlaneCandidate candidate;
+        OverlayPlanes::Placement placement;
+        placement.layerId = layer->getLayerId();
+        if (!renderer->getLayerBounds(layer, candidate.x0, candidate.y0, candidate.x1, candidate.y1)) {
+            // Unknown bounds: composited, over everything below
+            candidate.x0 = candidate.y0 = -1e30f;
+            candidate.x1 = candidate.y1 = 1e30f;
+            candidates.push_back(candidate);
+            wanted.push_back(placement);
+            continue;
+        }
+        
+        // Drawn by a plane exactly as GL draws it: placed and scaled only
+        const LayerProperties& props = layer->properties();
+        const FrameBuffer* cpuBuffer = nullptr;
+        const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+        bool eligible = props.rotation == 0.0f && props.scaleX > 0.0f && props.scaleY > 0.0f &&
+                        !props.crop.enabled && !props.panoramaMode && !props.cornerDeform.enabled &&
+                        !props.colorAdjust.isActive() && props.blendMode == LayerProperties::NORMAL &&
+                        props.groupId == 0 && props.packedAlpha == PackedAlpha::Layout::NONE &&
+                        !props.effects.isActive() &&
+                        layer->getPreparedFrame(cpuBuffer, gpuBuffer) && gpuBuffer &&
+                        gpuBuffer->getPlaneType() == TexturePlaneType::YUV_NV12 &&
+                        gpuBuffer->getDmaBufPlanes().isValid();
+        
+        // On one output only: its plane shows the part on that output
+        int on = -1;
+        for (size_t o = 0; eligible && o < outputs.size(); ++o) {
+            if (PlaneAssignment::overlaps(candidate, outputs[o].bounds)) {
+                eligible = on < 0;
+                on = static_cast<int>(o);
+            }
+        }
+        if (eligible && on >= 0 && (props.opacity >= 1.0f || outputs[on].alpha)) {
+            const Output& output = outputs[on];
+            const DmaBufPlanes& frame = gpuBuffer->getDmaBufPlanes();
+            float cx0 = std::max(candidate.x0, output.bounds.x0);
+            float cy0 = std::max(candidate.y0, output.bounds.y0);
+            float cx1 = std::min(candidate.x1, output.bounds.x1);
+            float cy1 = std::min(candidate.y1, output.bounds.y1);
+            float scaleX = static_cast<float>(frame.width) / (candidate.x1 - candidate.x0);
+            float scaleY = static_cast<float>(frame.height) / (candidate.y1 - candidate.y0);
+            placement.crtcId = output.surface->getCrtcId();
+            placement.frame = frame;
+            placement.dstX = static_cast<int>(std::lround(cx0 - output.bounds.x0));
+            placement.dstY = static_cast<int>(std::lround(cy0 - output.bounds.y0));
+            placement.dstW = static_cast<int>(std::lround(cx1 - output.bounds.x0)) - placement.dstX;
+            placement.dstH = static_cast<int>(std::lround(cy1 - output.bounds.y0)) - placement.dstY;
+            placement.srcX = (cx0 - candidate.x0) * scaleX;
+            placement.srcY = (cy0 - candidate.y0) * scaleY;
+            placement.srcW = (cx1 - cx0) * scaleX;
+            placement.srcH = (cy1 - cy0) * scaleY;
+            placement.opacity = props.opacity;
+            placement.matrix = gpuBuffer->info().colorMatrix;
+            placement.range = gpuBuffer->info().colorRange;
+            
+            // Sizes a plane refused stay composited
+            auto refused = overlayRejected_.find(placement.layerId);
+            candidate.eligible = placement.dstW > 0 && placement.dstH > 0 &&
+                (refused == overlayRejected_.end() ||
+                 refused->second != ((static_cast<int64_t>(placement.dstW) << 32) | placement.dstH));
+            candidate.output = on;
+        }
+        candidates.push_back(candidate);
+        wanted.push_back(std::move(placement));
+    }
+    
+    // Bottom to top: each output's lowest plane takes its lowest layer
+    std::vector<size_t> next(outputs.size(), 0);
+    for (size_t index : PlaneAssignment::choose(candidates, planesPerOutput)) {
+        OverlayPlanes::Placement& placement = wanted[index];
+        int on = candidates[index].output;
+        placement.plane = outputs[on].planes[next[on]++];
+        placements.push_back(std::move(placement));
+    }
+    return placements;
+}
+
+void DRMBackend::releaseOverlayPlanes() {
+    if (overlayPlanes_ && overlayPlanes_->isActive()) {
+        overlayPlanes_->release();
+    }
+    OpenGLRenderer* renderer = multiRenderer_ ? multiRenderer_->getRenderer() : nullptr;
+    if (renderer && !renderer->getPlaneLayers().empty()) {
+        renderer->setPlaneLayers({});
+        multiRenderer_->invalidateCanvas();
+    }
+}
+    
 void DRMBackend::renderLegacy(LayerManager* layerManager, OSDManager* osdManager) {
     (void)osdManager;  // OSD rendering handled separately
     
@@ -365,6 +1046,7 @@ void DRMBackend::renderLegacy(LayerManager* layerManager, OSDManager* osdManager
         }
         
         // Begin frame
+        surface->acquireRenderBuffer();
         if (!surface->beginFrame()) {
             continue;
         }
@@ -378,19 +1060,13 @@ void DRMBackend::renderLegacy(LayerManager* layerManager, OSDManager* osdManager
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
         
-        // Render layers (use getLayersSortedByZOrder like X11/Wayland backends do)
+        // Render layers in z-order (same render list as X11/Wayland backends)
         if (renderer_ && layerManager) {
-            auto layers = layerManager->getLayersSortedByZOrder();
+            std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
             
-            for (size_t i = 0; i < layers.size(); ++i) {
-                VideoLayer* layer = layers[i];
-                if (layer) {
-                    bool visible = layer->properties().visible;
-                    bool ready = layer->isReady();
-                    
-                    if (visible && ready) {
-                        renderer_->renderLayer(layer);
-                    }
+            for (const VideoLayer* layer : scene->layers) {
+                if (layer && layer->properties().visible && layer->isReady()) {
+                    renderer_->renderLayer(layer);
                 }
             }
         }
@@ -398,22 +1074,199 @@ void DRMBackend::renderLegacy(LayerManager* layerManager, OSDManager* osdManager
         // End frame
         surface->endFrame();
         
-        // Wait for pending flip before scheduling a new one
-        // (can only have one flip pending at a time)
-        if (surface->isFlipPending()) {
+        // Flip, or queue behind the pending flip (one flip pending at a time)
+        surface->presentFrame();
+    }
+}
+
+void DRMBackend::handleEvents() {
+    // Hotplug changes found by the monitor thread, applied between frames
+    if (outputManager_ && initialized_) {
+        outputManager_->pollHotplug();
+        swapInPreparedSurfaces();
+    }
+}
+
+void DRMBackend::onHotplug(const std::string& name, bool connected) {
+    DRMSurface* primary = getPrimarySurface();
+    if (!connected) {
+        auto it = surfaces_.find(name);
+        if (it == surfaces_.end()) {
+            return;
+        }
+        // Out of the flips, but its GPU resources stay for a reconnect; the
+        // canvas keeps its size, only this region is no longer drawn
+        for (auto& [other, surface] : surfaces_) {
             surface->waitForFlip();
+            surface->clearFlipPeers();
+        }
+        parkedSurfaces_[name] = std::move(it->second);
+        surfaces_.erase(it);
+        layerScanout_.reset();
+        overlayPlanes_.reset();
+        if (multiRenderer_) {
+            if (primary) {
+                primary->makeCurrent();
+            }
+            multiRenderer_->setOutputSurface(name, nullptr);
+            if (primary) {
+                primary->releaseCurrent();
+            }
+        }
+        LOG_INFO << "DRMBackend: " << name << " unplugged, " << surfaces_.size() << " output(s) left";
+        return;
+    }
+    
+    const DRMConnector* conn = outputManager_->getConnectorByName(name);
+    if (!conn || !conn->info.enabled) {
+        LOG_WARNING << "DRMBackend: " << name << " connected but has no CRTC";
+        return;
+    }
+    
+    // Same display back (or one at the same size): reuse the surface
+    auto parked = parkedSurfaces_.find(name);
+    if (parked != parkedSurfaces_.end() && !preparingSurfaces_.count(name) &&
+        parked->second->getWidth() == static_cast<uint32_t>(conn->info.width) &&
+        parked->second->getHeight() == static_cast<uint32_t>(conn->info.height) &&
+        parked->second->bindOutput()) {
+        std::unique_ptr<DRMSurface> surface = std::move(parked->second);
+        parkedSurfaces_.erase(parked);
+        addSurface(std::move(surface));
+        return;
+    }
+    prepareSurface(name);
+}
+
+void DRMBackend::prepareSurface(const std::string& name) {
+    if (preparingSurfaces_.count(name)) {
+        return;   // Checked again once it is ready
+    }
+    // Shares the EGL display, context and GBM device of the existing surfaces
+    DRMSurface* shared = getPrimarySurface();
+    if (!shared && !parkedSurfaces_.empty()) {
+        shared = parkedSurfaces_.begin()->second.get();
+    }
+    if (!shared && !retiredSurfaces_.empty()) {
+        shared = retiredSurfaces_.front().get();
+    }
+    if (!shared) {
+        LOG_WARNING << "DRMBackend: No surface to share resources with for " << name;
+        return;
+    }
+    
+    auto surface = std::make_unique<DRMSurface>(outputManager_.get(), name);
+    surface->setBufferCount(swapchainBuffers_);
+    surface->setExplicitFencingAllowed(explicitFencingEnabled_);
+    surface->setModifiersAllowed(modifiersEnabled_);
+    if (!surface->bindOutput()) {
+        return;
+    }
+    EGLContext context = shared->getContext();
+    EGLDisplay display = shared->getDisplay();
+    gbm_device* gbmDevice = shared->getGbmDevice();
+    
+    // GBM and EGL surface allocation runs while the other outputs render;
+    // the shared context stays current on this thread
+    LOG_INFO << "DRMBackend: Preparing a " << surface->getWidth() << "x" << surface->getHeight()
+             << " surface for " << name;
+    preparingSurfaces_[name] = std::async(std::launch::async,
+        [surface = std::move(surface), context, display, gbmDevice]() mutable {
+            if (!surface->createResources(context, display, gbmDevice, false)) {
+                surface.reset();
+            }
+            return std::move(surface);
+        });
+}
+
+void DRMBackend::swapInPreparedSurfaces() {
+    for (auto it = preparingSurfaces_.begin(); it != preparingSurfaces_.end();) {
+        if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        std::string name = it->first;
+        std::unique_ptr<DRMSurface> surface = it->second.get();
+        it = preparingSurfaces_.erase(it);
+        if (!surface) {
+            LOG_ERROR << "DRMBackend: Failed to create surface for " << name;
+            continue;
         }
         
-        // Schedule page flip (non-blocking)
-        surface->schedulePageFlip();
+        // Unplugged again, or another mode, while it was being prepared
+        const DRMConnector* conn = outputManager_->getConnectorByName(name);
+        bool sameSize = conn && conn->info.enabled &&
+                        surface->getWidth() == static_cast<uint32_t>(conn->info.width) &&
+                        surface->getHeight() == static_cast<uint32_t>(conn->info.height);
+        if (!sameSize || !surface->bindOutput()) {
+            surface->cleanup();
+            if (conn && conn->info.enabled) {
+                prepareSurface(name);
+            }
+            continue;
+        }
+        addSurface(std::move(surface));
     }
 }
 
-void DRMBackend::handleEvents() {
-    // Poll for hotplug events
-    if (outputManager_) {
-        outputManager_->pollHotplug();
+void DRMBackend::addSurface(std::unique_ptr<DRMSurface> surface) {
+    std::string name = surface->getOutputName();
+    DRMSurface* added = surface.get();
+    
+    // A parked surface at the old size is replaced; the one the others share
+    // resources with is kept until close
+    auto parked = parkedSurfaces_.find(name);
+    if (parked != parkedSurfaces_.end()) {
+        if (parked->second->ownsSharedResources()) {
+            retiredSurfaces_.push_back(std::move(parked->second));
+        } else {
+            parked->second->cleanup();
+        }
+        parkedSurfaces_.erase(parked);
+    }
+    surfaces_[name] = std::move(surface);
+    layerScanout_.reset();
+    overlayPlanes_.reset();
+    
+    if (multiRenderer_) {
+        DRMSurface* primary = getPrimarySurface();
+        primary->makeCurrent();
+        
+        auto region = std::find_if(outputRegions_.begin(), outputRegions_.end(),
+                                   [&name](const OutputRegion& r) { return r.name == name; });
+        int width = static_cast<int>(added->getWidth());
+        int height = static_cast<int>(added->getHeight());
+        if (region == outputRegions_.end()) {
+            // A connector the canvas has no region for: one more on the right
+            int canvasX = 0;
+            for (const auto& r : outputRegions_) {
+                canvasX = std::max(canvasX, r.canvasX + r.canvasWidth);
+            }
+            outputRegions_.push_back(OutputRegion::createDefault(name, width, height, canvasX, 0));
+            multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
+        } else if (region->physicalWidth != width || region->physicalHeight != height) {
+            // Different display: its region follows the new mode (as setOutputMode)
+            if (region->canvasWidth == region->physicalWidth) region->canvasWidth = width;
+            if (region->canvasHeight == region->physicalHeight) region->canvasHeight = height;
+            region->physicalWidth = width;
+            region->physicalHeight = height;
+            multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
+        } else {
+            // Canvas unchanged: only the surface returns
+            multiRenderer_->setOutputSurface(name, added);
+        }
+        primary->releaseCurrent();
+    }
+    
+    LOG_INFO << "DRMBackend: " << name << " back with " << surfaces_.size() << " output(s)";
+}
+
+std::vector<OutputSurface*> DRMBackend::regionSurfaces() {
+    std::vector<OutputSurface*> result;
+    for (const auto& region : outputRegions_) {
+        auto it = surfaces_.find(region.name);
+        result.push_back(it != surfaces_.end() ? it->second.get() : nullptr);
     }
+    return result;
 }
 
 void DRMBackend::resize(unsigned int width, unsigned int height) {
@@ -484,6 +1337,21 @@ OpenGLRenderer* DRMBackend::getRenderer() {
     return renderer_.get();
 }
 
+bool DRMBackend::enableUploadThread() {
+#ifdef HAVE_EGL
+    // Legacy mode renders each output directly and never drains the uploader
+    DRMSurface* primary = getPrimarySurface();
+    OpenGLRenderer* renderer = multiRenderer_ ? multiRenderer_->getRenderer() : nullptr;
+    if (!useVirtualCanvas_ || !renderer || !primary) {
+        LOG_WARNING << "DRMBackend: Upload thread requires Virtual Canvas mode";
+        return false;
+    }
+    return renderer->enableUploadThread(primary->getDisplay(), primary->getContext());
+#else
+    return false;
+#endif
+}
+
 #ifdef HAVE_EGL
 EGLDisplay DRMBackend::getEGLDisplay() const {
     DRMSurface* primary = const_cast<DRMBackend*>(this)->getPrimarySurface();
@@ -565,11 +1433,7 @@ bool DRMBackend::configureOutputRegion(const std::string& outputName,
             surfaces_.begin()->second->makeCurrent();
         }
         
-        std::vector<OutputSurface*> surfacePtrs;
-        for (auto& [name, surface] : surfaces_) {
-            surfacePtrs.push_back(surface.get());
-        }
-        multiRenderer_->configureOutputs(outputRegions_, surfacePtrs);
+        multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
     }
     
     return true;
@@ -610,11 +1474,7 @@ bool DRMBackend::configureOutputBlend(const std::string& outputName,
             surfaces_.begin()->second->makeCurrent();
         }
         
-        std::vector<OutputSurface*> surfacePtrs;
-        for (auto& [name, surface] : surfaces_) {
-            surfacePtrs.push_back(surface.get());
-        }
-        multiRenderer_->configureOutputs(outputRegions_, surfacePtrs);
+        multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
     }
     
     return true;
@@ -723,11 +1583,7 @@ bool DRMBackend::setOutputMode(const std::string& outputName, int width, int hei
         }
         
         // Reconfigure renderer with new regions
-        std::vector<OutputSurface*> surfacePtrs;
-        for (auto& [name, surf] : surfaces_) {
-            surfacePtrs.push_back(surf.get());
-        }
-        multiRenderer_->configureOutputs(outputRegions_, surfacePtrs);
+        multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
     }
     
     LOG_INFO << "DRMBackend: " << outputName << " successfully changed to "
@@ -761,6 +1617,14 @@ bool DRMBackend::isCaptureEnabled() const {
     return multiRenderer_->isCaptureEnabled();
 }
 
+bool DRMBackend::setPreviewRenderer(PreviewRenderer* preview) {
+    if (!multiRenderer_) {
+        return false;
+    }
+    multiRenderer_->setPreviewRenderer(preview);
+    return true;
+}
+
 void DRMBackend::setOutputSinkManager(OutputSinkManager* sinkManager) {
     if (multiRenderer_) {
         multiRenderer_->setOutputSinkManager(sinkManager);
@@ -981,12 +1845,7 @@ bool DRMBackend::initVirtualCanvas() {
     buildOutputRegions();
     
     // Configure MultiOutputRenderer with surfaces and regions
-    std::vector<OutputSurface*> surfacePtrs;
-    for (auto& [name, surface] : surfaces_) {
-        surfacePtrs.push_back(surface.get());
-    }
-    
-    multiRenderer_->configureOutputs(outputRegions_, surfacePtrs);
+    multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
     
     LOG_INFO << "DRMBackend: Virtual Canvas initialized with " 
              << outputRegions_.size() << " output(s)";
@@ -1079,11 +1938,7 @@ void DRMBackend::autoConfigureOutputs(const std::string& arrangement, int overla
             surfaces_.begin()->second->makeCurrent();
         }
         
-        std::vector<OutputSurface*> surfacePtrs;
-        for (auto& [name, surf] : surfaces_) {
-            surfacePtrs.push_back(surf.get());
-        }
-        multiRenderer_->configureOutputs(outputRegions_, surfacePtrs);
+        multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
     }
     
     LOG_INFO << "DRMBackend: Auto-configured " << outputRegions_.size() 
@@ -1104,11 +1959,7 @@ bool DRMBackend::configureOutputRegion(const std::string& outputName, const Outp
                     surfaces_.begin()->second->makeCurrent();
                 }
                 
-                std::vector<OutputSurface*> surfacePtrs;
-                for (auto& [name, surf] : surfaces_) {
-                    surfacePtrs.push_back(surf.get());
-                }
-                multiRenderer_->configureOutputs(outputRegions_, surfacePtrs);
+                multiRenderer_->configureOutputs(outputRegions_, regionSurfaces());
             }
             
             LOG_INFO << "DRMBackend: Configured output region " << outputName;
@@ -1130,6 +1981,222 @@ int64_t DRMBackend::getTotalDroppedFrames() const {
     return total;
 }
 
+int64_t DRMBackend::getPresentationLeadNs() const {
+    if (surfaces_.empty() || !surfaces_.begin()->second) {
+        return 0;
+    }
+    const DRMSurface* primary = surfaces_.begin()->second.get();
+    const PresentationTiming& timing = primary->getPresentationTiming();
+    if (vrrFps_ > 0.0) {
+        // Variable refresh scans out on the flip, after any pending one
+        return primary->isFlipPending() ? static_cast<int64_t>(1e9 / vrrFps_) : 0;
+    }
+    int64_t lead = timing.getTimeToNextVsync();
+    if (lead > 0 && primary->isFlipPending()) {
+        // The next vsync shows the frame already queued
+        int64_t duration = timing.getVsyncDuration();
+        lead += duration > 0 ? duration : timing.getExpectedVsyncDuration();
+    }
+    return lead;
+}
+
+bool DRMBackend::getTargetVblank(int64_t& msc, double& refreshHz) const {
+    if (surfaces_.empty() || !surfaces_.begin()->second) {
+        return false;
+    }
+    const DRMSurface* primary = surfaces_.begin()->second.get();
+    const PresentationTiming& timing = primary->getPresentationTiming();
+    int64_t next = timing.getNextVsyncCounter();
+    if (next < 0) {
+        return false;
+    }
+    // Same vsync as getPresentationLeadNs()
+    msc = next + (primary->isFlipPending() ? 1 : 0);
+    refreshHz = timing.getRefreshRate();
+    return true;
+}
+
+bool DRMBackend::setIdle(bool idle) {
+    if (!initialized_ || surfaces_.empty()) {
+        return false;
+    }
+    if (idle) {
+        if (isCaptureEnabled()) {
+            return false;
+        }
+        // The last frame reaches the screen and its flip event is handled
+        for (auto& [name, surface] : surfaces_) {
+            surface->waitForFlip();
+        }
+        return true;
+    }
+    // Vblank prediction extrapolates from the last flip; the held vsyncs
+    // are not dropped frames
+    for (auto& [name, surface] : surfaces_) {
+        surface->getPresentationTiming().skipGap();
+    }
+    return true;
+}
+
+bool DRMBackend::setClusterCanvas(int width, int height) {
+    if (!multiRenderer_) {
+        return false;
+    }
+    makeCurrent();
+    multiRenderer_->setClusterCanvas(width, height);
+    return true;
+}
+
+bool DRMBackend::setDynamicResolution(bool enabled, float minScale) {
+    if (!multiRenderer_) {
+        return false;
+    }
+    multiRenderer_->dynamicResolution().setMinScale(minScale);
+    multiRenderer_->dynamicResolution().setEnabled(enabled);
+    return true;
+}
+
+bool DRMBackend::setFrameLogEnabled(bool enabled, bool readback) {
+    DRMSurface* primary = getPrimarySurface();
+    if (!primary) {
+        return false;
+    }
+    frameLogEnabled_ = enabled;
+    frameLogReadback_ = enabled && readback && useVirtualCanvas_ && multiRenderer_;
+    if (multiRenderer_) {
+        // The frame code is read back from the canvas
+        multiRenderer_->setOutputFastPath(!frameLogReadback_);
+    }
+    primary->getPresentationTiming().setFrameLogEnabled(enabled);
+    if (!enabled) {
+        setFrameTag(-1);
+    }
+    return true;
+}
+
+void DRMBackend::setFrameTag(int64_t tag) {
+    for (auto& [name, surface] : surfaces_) {
+        surface->setFrameTag(tag);
+    }
+}
+
+void DRMBackend::takePresentedFrames(std::vector<PresentedFrame>& out) {
+    DRMSurface* primary = getPrimarySurface();
+    if (primary) {
+        primary->getPresentationTiming().takePresentedFrames(out);
+    }
+}
+
+int64_t DRMBackend::readFrameCode() {
+    VirtualCanvas* canvas = multiRenderer_ ? multiRenderer_->getCanvas() : nullptr;
+    int width = canvas ? canvas->getWidth() : 0;
+    int height = canvas ? canvas->getHeight() : 0;
+    if (width < FrameCode::CELLS || height < 4) {
+        return -1;
+    }
+    // One row near either edge, whatever the canvas row order (a
+    // synchronous read: the sync test accepts the stall)
+    frameCodeRow_.resize(static_cast<size_t>(width) * 4);
+    for (int y : {1, height - 2}) {
+        if (canvas->captureRegion(0, y, width, 1, frameCodeRow_.data(), frameCodeRow_.size())) {
+            int64_t frame = FrameCode::decodeRow(frameCodeRow_.data(), width);
+            if (frame >= 0) {
+                return frame;
+            }
+        }
+    }
+    return -1;
+}
+
+bool DRMBackend::matchRefreshRate(double fps) {
+    bool changed = false;
+    for (auto& [name, surface] : surfaces_) {
+        const DRMConnector* conn = outputManager_ ? outputManager_->getConnectorByName(name) : nullptr;
+        if (!surface || !conn) {
+            continue;
+        }
+        int width = static_cast<int>(surface->getWidth());
+        int height = static_cast<int>(surface->getHeight());
+        const OutputMode* mode = conn->info.findRefreshMultiple(width, height, fps);
+        if (!mode || std::abs(mode->refreshRate - conn->info.refreshRate) < 0.01) {
+            continue;
+        }
+        
+        double oldRefresh = conn->info.refreshRate;
+        int index = conn->info.index;
+        if (surface->isFlipPending()) {
+            surface->waitForFlip();
+        }
+        if (!outputManager_->setModeAtomic(index, width, height, mode->refreshRate)) {
+            // Legacy drivers: modeset with the next frame's buffer
+            if (!outputManager_->prepareMode(index, width, height, mode->refreshRate)) {
+                continue;
+            }
+            surface->requestModeset();
+        }
+        
+        PresentationTiming& timing = surface->getPresentationTiming();
+        timing.init(conn->info.refreshRate);
+        timing.setVideoFramerate(fps);
+        LOG_INFO << "DRMBackend: " << name << " refresh " << oldRefresh << " -> "
+                 << conn->info.refreshRate << " Hz for " << fps << " fps";
+        changed = true;
+    }
+    return changed;
+}
+
+bool DRMBackend::setVariableRefresh(double fps) {
+    if (!outputManager_ || fps == vrrFps_) {
+        return fps > 0.0 && fps == vrrFps_;
+    }
+    
+    // A show spanning a VRR and a fixed output would judder on one of them
+    if (fps > 0.0) {
+        for (auto& [name, surface] : surfaces_) {
+            const DRMConnector* conn = outputManager_->getConnectorByName(name);
+            if (!conn || !outputManager_->isVrrCapable(conn->info.index)) {
+                LOG_INFO << "DRMBackend: " << name << " is not VRR capable, keeping fixed refresh";
+                return false;
+            }
+        }
+    }
+    
+    bool enable = fps > 0.0;
+    bool success = true;
+    for (auto& [name, surface] : surfaces_) {
+        const DRMConnector* conn = outputManager_->getConnectorByName(name);
+        if (!surface || !conn) {
+            continue;
+        }
+        if (surface->isFlipPending()) {
+            surface->waitForFlip();
+        }
+        if (!outputManager_->setVrrEnabled(conn->info.index, enable)) {
+            success = false;
+            continue;
+        }
+        // Vsyncs now follow the content: one per frame
+        PresentationTiming& timing = surface->getPresentationTiming();
+        timing.init(enable ? fps : conn->info.refreshRate);
+        timing.setVideoFramerate(enable ? fps : 0.0);
+    }
+    
+    if (enable && !success) {
+        // Partial VRR is worse than none
+        for (auto& [name, surface] : surfaces_) {
+            const DRMConnector* conn = outputManager_->getConnectorByName(name);
+            if (conn) {
+                outputManager_->setVrrEnabled(conn->info.index, false);
+                surface->getPresentationTiming().init(conn->info.refreshRate);
+            }
+        }
+        vrrFps_ = 0.0;
+        return false;
+    }
+    vrrFps_ = enable ? fps : 0.0;
+    return enable;
+}
+
 void DRMBackend::setVideoFramerate(double fps) {
     // Set video framerate on all surfaces' presentation timing
     // This tells them to expect vsync skips (e.g., 25fps on 60Hz display)
@@ -22,9 +22,13 @@
 #include "../MultiOutputRenderer.h"
 #include "DRMOutputManager.h"
 #include "DRMSurface.h"
+#include "ScanoutCanvas.h"
+#include "LayerScanout.h"
+#include "OverlayPlanes.h"
 #include <vector>
 #include <map>
 #include <memory>
+#include <future>
 
 namespace videocomposer {
 
@@ -35,6 +39,7 @@ class OSDManager;
 class VirtualCanvas;
 class OutputBlitShader;
 class OutputSinkManager;
+class PreviewRenderer;
 class DisplayConfigurationManager;
 
 /**
@@ -79,6 +84,7 @@ public:
     void clearCurrent() override;
     
     OpenGLRenderer* getRenderer() override;
+    bool enableUploadThread() override;
     
 #ifdef HAVE_EGL
     EGLDisplay getEGLDisplay() const override;
@@ -138,6 +144,11 @@ public:
      */
     void setOutputSinkManager(OutputSinkManager* sinkManager) override;
     
+    /**
+     * Set the operator preview (override)
+     */
+    bool setPreviewRenderer(PreviewRenderer* preview) override;
+    
     /**
      * Set resolution mode (override)
      */
@@ -166,6 +177,47 @@ public:
      */
     void setVideoFramerate(double fps);
     
+    /**
+     * Atomic modeset of each output to the mode at its resolution whose
+     * refresh is a multiple of fps (legacy modeset on the next flip when
+     * atomic is unavailable)
+     */
+    bool matchRefreshRate(double fps) override;
+    
+    /**
+     * Sets VRR_ENABLED on every output (all must be vrr_capable)
+     */
+    bool setVariableRefresh(double fps) override;
+    
+    /**
+     * Time until the primary output's next free vsync, from its flip timestamps
+     */
+    int64_t getPresentationLeadNs() const override;
+    
+    /**
+     * Vblank counter of the primary output's next free vsync
+     */
+    bool getTargetVblank(int64_t& msc, double& refreshHz) const override;
+    
+    /**
+     * Scanout holds the last flipped buffer; not while capturing for
+     * virtual outputs, which need every frame
+     */
+    bool setIdle(bool idle) override;
+    
+    /** Virtual canvas only (MultiOutputRenderer::setClusterCanvas) */
+    bool setClusterCanvas(int width, int height) override;
+    bool setDynamicResolution(bool enabled, float minScale) override;
+    
+    /**
+     * Flips of the primary output from its page flip events. While logging,
+     * frames go through the per-output swapchain (no direct scanout, no
+     * blocking multi-CRTC commit, which has no flip events).
+     */
+    bool setFrameLogEnabled(bool enabled, bool readback) override;
+    void setFrameTag(int64_t tag) override;
+    void takePresentedFrames(std::vector<PresentedFrame>& out) override;
+    
     /**
      * Get surface for a specific output
      */
@@ -249,6 +301,72 @@ private:
     
     // Atomic modesetting
     bool atomicPageFlip();  // Returns true if successful
+    bool atomicFlipsAvailable() const;  // All outputs in one commit
+    
+    // Buffers per output swapchain (3 = mailbox, 2 = wait for the flip)
+    int swapchainBuffers_ = 3;
+    
+    // Render fences go to the commit (IN_FENCE_FD) instead of a glFinish()
+    bool explicitFencingEnabled_ = true;
+    
+    // Tiled/compressed buffers from the planes' IN_FORMATS (surfaces, scanout canvas)
+    bool modifiersEnabled_ = true;
+    
+    // Direct scanout: planes show their canvas region straight from the
+    // canvas buffer (no per-output blit) when no output blends, warps or scales
+    std::unique_ptr<ScanoutCanvas> scanoutCanvas_;
+    bool directScanoutEnabled_ = true;
+    bool directScanoutAvailable();   // Primary context must be current
+    bool scanoutPageFlip(bool testOnly = false);   // Returns true if successful
+    
+    // Independent flip pacing: with outputs at different refresh rates each
+    // CRTC flips on its own vblank instead of waiting for the slowest one
+    bool independentFlipsEnabled_ = true;
+    bool mixedRefreshRates() const;
+    void updateFlipGroups(bool grouped);     // Same-rate outputs become flip peers
+    bool groupPageFlip(DRMSurface* leader);  // One commit for the leader and its peers
+    void waitForFreeOutput();        // Blocks while every output has a flip pending
+    
+    // Presentation frame log (sync test)
+    bool frameLogEnabled_ = false;
+    bool frameLogReadback_ = false;  // Frame numbers read back from the canvas
+    std::vector<uint8_t> frameCodeRow_;
+    int64_t readFrameCode();         // Primary context must be current; -1 if no strip
+    
+    // Plane bypass: a lone untransformed VAAPI layer is put on the plane
+    // as NV12, skipping compositing entirely (requires direct scanout)
+    std::unique_ptr<LayerScanout> layerScanout_;
+    bool layerBypassEnabled_ = true;
+    bool presentLayerBypass(LayerManager* layerManager, OSDManager* osdManager);
+    
+    // Overlay planes: eligible layers (plain, hardware decoded) are scanned
+    // out on overlay planes over the canvas, the rest composited (requires
+    // direct scanout; see PlaneAssignment)
+    std::unique_ptr<OverlayPlanes> overlayPlanes_;
+    bool overlayPlanesEnabled_ = true;
+    std::vector<int64_t> overlayAccepted_;         // Placements the last TEST_ONLY commit took
+    std::map<int, int64_t> overlayRejected_;       // Layer -> placement size the driver refused
+    void assignOverlayPlanes(LayerManager* layerManager, OSDManager* osdManager);
+    std::vector<OverlayPlanes::Placement> planOverlayPlanes(LayerManager* layerManager, OpenGLRenderer* renderer);
+    void releaseOverlayPlanes();     // Everything composited again
+    
+    // Variable refresh: content framerate the outputs follow (0 = fixed refresh)
+    double vrrFps_ = 0.0;
+    
+    // Hotplug, applied between frames: an unplugged output keeps its surface
+    // and canvas region, so a reconnect at the same size is only a modeset.
+    // Surfaces for new connectors (or sizes) are created on a worker while
+    // the other outputs keep flipping, then swapped in.
+    std::map<std::string, std::unique_ptr<DRMSurface>> parkedSurfaces_;
+    std::map<std::string, std::future<std::unique_ptr<DRMSurface>>> preparingSurfaces_;
+    std::vector<std::unique_ptr<DRMSurface>> retiredSurfaces_;  // Replaced, but own the shared context
+    void onHotplug(const std::string& name, bool connected);
+    void prepareSurface(const std::string& name);
+    void swapInPreparedSurfaces();
+    void addSurface(std::unique_ptr<DRMSurface> surface);
+    
+    // Surfaces in outputRegions_ order (nullptr for unplugged outputs)
+    std::vector<OutputSurface*> regionSurfaces();
     
     // Configuration
     std::string devicePath_;
@@ -4,10 +4,12 @@
 
 #include "DRMOutputManager.h"
 #include "../../utils/Logger.h"
+#include "../../utils/FrameTracer.h"
 
 #include <fcntl.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <algorithm>
@@ -136,10 +138,30 @@ bool DRMOutputManager::init(const std::string& devicePath) {
     
     LOG_INFO << "DRMOutputManager: Detected " << getOutputCount() << " connected outputs";
     
+    // Watch for hotplug off the render thread
+    std::vector<HotplugMonitor::Change> watched;
+    for (const auto& conn : connectors_) {
+        watched.push_back(HotplugMonitor::Change{conn.connectorId, conn.info.connected});
+    }
+    hotplugMonitor_.setConnectors(watched);
+    int fd = drmFd_;
+    hotplugMonitor_.start([fd](uint32_t connectorId, bool force, bool& connected) {
+        drmModeConnector* conn = force ? drmModeGetConnector(fd, connectorId)
+                                       : drmModeGetConnectorCurrent(fd, connectorId);
+        if (!conn) {
+            return false;
+        }
+        connected = (conn->connection == DRM_MODE_CONNECTED);
+        drmModeFreeConnector(conn);
+        return true;
+    });
+    
     return true;
 }
 
 void DRMOutputManager::cleanup() {
+    hotplugMonitor_.stop();
+    
     // Restore original modes
     restoreOriginalModes();
     
@@ -328,83 +350,7 @@ bool DRMOutputManager::detectOutputs() {
         
         // Only process connected outputs
         if (drmConn.info.connected) {
-            // Parse modes
-            parseModes(drmConn);
-            
-            // Read EDID
-            readEDID(drmConn);
-            
-            // Get connector properties
-            getConnectorProperties(drmConn);
-            
-            // Allocate CRTC
-            if (allocateCrtc(drmConn)) {
-                drmConn.info.enabled = true;
-                
-                // Save original CRTC state
-                drmConn.savedCrtc = drmModeGetCrtc(drmFd_, drmConn.crtcId);
-                if (drmConn.savedCrtc && drmConn.savedCrtc->mode_valid) {
-                    // Use current mode from CRTC
-                    drmConn.info.width = drmConn.savedCrtc->width;
-                    drmConn.info.height = drmConn.savedCrtc->height;
-                    drmConn.info.x = drmConn.savedCrtc->x;
-                    drmConn.info.y = drmConn.savedCrtc->y;
-                    
-                    // Initialize currentMode from savedCrtc
-                    drmConn.currentMode = drmConn.savedCrtc->mode;
-                    drmConn.hasCurrentMode = true;
-                    
-                    // Get refresh rate from current mode
-                    drmModeModeInfo* mode = &drmConn.savedCrtc->mode;
-                    if (mode->htotal && mode->vtotal) {
-                        drmConn.info.refreshRate = static_cast<double>(mode->clock * 1000) /
-                                                   (mode->htotal * mode->vtotal);
-                    }
-                } else {
-                    // No current mode set (no compositor running) - use preferred or first available mode
-                    drmModeModeInfo* bestMode = nullptr;
-                    
-                    // Find preferred mode first
-                    for (int m = 0; m < conn->count_modes; ++m) {
-                        if (conn->modes[m].type & DRM_MODE_TYPE_PREFERRED) {
-                            bestMode = &conn->modes[m];
-                            break;
-                        }
-                    }
-                    
-                    // Fall back to first mode if no preferred
-                    if (!bestMode && conn->count_modes > 0) {
-                        bestMode = &conn->modes[0];
-                    }
-                    
-                    if (bestMode) {
-                        drmConn.info.width = bestMode->hdisplay;
-                        drmConn.info.height = bestMode->vdisplay;
-                        drmConn.info.x = 0;
-                        drmConn.info.y = 0;
-                        
-                        // Initialize currentMode from bestMode
-                        drmConn.currentMode = *bestMode;
-                        drmConn.hasCurrentMode = true;
-                        
-                        if (bestMode->htotal && bestMode->vtotal) {
-                            drmConn.info.refreshRate = static_cast<double>(bestMode->clock * 1000) /
-                                                       (bestMode->htotal * bestMode->vtotal);
-                        }
-                        
-                        LOG_INFO << "DRMOutputManager: No active mode on " << drmConn.info.name 
-                                 << ", will use " << bestMode->hdisplay << "x" << bestMode->vdisplay
-                                 << (bestMode->type & DRM_MODE_TYPE_PREFERRED ? " (preferred)" : "");
-                    } else {
-                        LOG_WARNING << "DRMOutputManager: No modes available for " << drmConn.info.name;
-                    }
-                }
-            }
-            
-            LOG_INFO << "DRMOutputManager: Found output " << drmConn.info.name
-                     << " (" << drmConn.info.getDisplayName() << ")"
-                     << " " << drmConn.info.width << "x" << drmConn.info.height
-                     << "@" << drmConn.info.refreshRate << "Hz";
+            setupConnector(drmConn);
         } else {
             // Disconnected connector - still track it
             drmConn.info.enabled = false;
@@ -416,6 +362,94 @@ bool DRMOutputManager::detectOutputs() {
     return getOutputCount() > 0;
 }
 
+void DRMOutputManager::setupConnector(DRMConnector& drmConn) {
+    drmModeConnector* conn = drmConn.connector;
+    
+    // Parse modes
+    parseModes(drmConn);
+    
+    // Read EDID
+    readEDID(drmConn);
+    
+    // Get connector properties
+    getConnectorProperties(drmConn);
+    
+    // Allocate CRTC
+    if (allocateCrtc(drmConn)) {
+        drmConn.info.enabled = true;
+        
+        // Save original CRTC state (kept across a reconnect to the same CRTC)
+        if (drmConn.savedCrtc && drmConn.savedCrtc->crtc_id != drmConn.crtcId) {
+            drmModeFreeCrtc(drmConn.savedCrtc);
+            drmConn.savedCrtc = nullptr;
+        }
+        if (!drmConn.savedCrtc) {
+            drmConn.savedCrtc = drmModeGetCrtc(drmFd_, drmConn.crtcId);
+        }
+        if (drmConn.savedCrtc && drmConn.savedCrtc->mode_valid) {
+            // Use current mode from CRTC
+            drmConn.info.width = drmConn.savedCrtc->width;
+            drmConn.info.height = drmConn.savedCrtc->height;
+            drmConn.info.x = drmConn.savedCrtc->x;
+            drmConn.info.y = drmConn.savedCrtc->y;
+            
+            // Initialize currentMode from savedCrtc
+            drmConn.currentMode = drmConn.savedCrtc->mode;
+            drmConn.hasCurrentMode = true;
+            
+            // Get refresh rate from current mode
+            drmModeModeInfo* mode = &drmConn.savedCrtc->mode;
+            if (mode->htotal && mode->vtotal) {
+                drmConn.info.refreshRate = static_cast<double>(mode->clock * 1000) /
+                                           (mode->htotal * mode->vtotal);
+            }
+        } else {
+            // No current mode set (no compositor running) - use preferred or first available mode
+            drmModeModeInfo* bestMode = nullptr;
+            
+            // Find preferred mode first
+            for (int m = 0; m < conn->count_modes; ++m) {
+                if (conn->modes[m].type & DRM_MODE_TYPE_PREFERRED) {
+                    bestMode = &conn->modes[m];
+                    break;
+                }
+            }
+            
+            // Fall back to first mode if no preferred
+            if (!bestMode && conn->count_modes > 0) {
+                bestMode = &conn->modes[0];
+            }
+            
+            if (bestMode) {
+                drmConn.info.width = bestMode->hdisplay;
+                drmConn.info.height = bestMode->vdisplay;
+                drmConn.info.x = 0;
+                drmConn.info.y = 0;
+                
+                // Initialize currentMode from bestMode
+                drmConn.currentMode = *bestMode;
+                drmConn.hasCurrentMode = true;
+                
+                if (bestMode->htotal && bestMode->vtotal) {
+                    drmConn.info.refreshRate = static_cast<double>(bestMode->clock * 1000) /
+                                               (bestMode->htotal * bestMode->vtotal);
+                }
+                
+                LOG_INFO << "DRMOutputManager: No active mode on " << drmConn.info.name 
+                         << ", will use " << bestMode->hdisplay << "x" << bestMode->vdisplay
+                         << (bestMode->type & DRM_MODE_TYPE_PREFERRED ? " (preferred)" : "");
+            } else {
+                LOG_WARNING << "DRMOutputManager: No modes available for " << drmConn.info.name;
+            }
+        }
+    }
+    
+    LOG_INFO << "DRMOutputManager: Found output " << drmConn.info.name
+             << " (" << drmConn.info.getDisplayName() << ")"
+             << " " << drmConn.info.width << "x" << drmConn.info.height
+             << "@" << drmConn.info.refreshRate << "Hz";
+}
+
 std::string DRMOutputManager::getConnectorTypeName(uint32_t type) const {
     if (type < sizeof(connectorTypeNames) / sizeof(connectorTypeNames[0])) {
         return connectorTypeNames[type];
@@ -721,54 +755,50 @@ size_t DRMOutputManager::getOutputCount() const {
 }
 
 bool DRMOutputManager::refreshOutputs() {
-    // Re-probe connectors for hotplug changes
+    // Connection changes seen by the hotplug monitor. It probed the
+    // connector on its own thread, so the state it left is read here
+    // without another probe (no EDID read over DDC on the caller's thread).
     bool changed = false;
     
-    for (auto& conn : connectors_) {
-        if (!conn.connector) {
-            continue;
-        }
-        
-        // Get fresh connector state
-        drmModeConnector* fresh = drmModeGetConnector(drmFd_, conn.connectorId);
-        if (!fresh) {
+    for (const HotplugMonitor::Change& change : hotplugMonitor_.takeChanges()) {
+        auto it = std::find_if(connectors_.begin(), connectors_.end(),
+                               [&change](const DRMConnector& c) { return c.connectorId == change.connectorId; });
+        if (it == connectors_.end() || it->info.connected == change.connected) {
             continue;
         }
+        DRMConnector& conn = *it;
         
-        bool wasConnected = conn.info.connected;
-        bool isConnected = (fresh->connection == DRM_MODE_CONNECTED);
-        
-        if (wasConnected != isConnected) {
-            changed = true;
-            conn.info.connected = isConnected;
-            
-            if (isConnected) {
-                // Update connector info
+        if (change.connected) {
+            drmModeConnector* fresh = drmModeGetConnectorCurrent(drmFd_, conn.connectorId);
+            if (!fresh) {
+                continue;
+            }
+            if (conn.connector) {
                 drmModeFreeConnector(conn.connector);
-                conn.connector = fresh;
-                parseModes(conn);
-                readEDID(conn);
-                
-                if (hotplugCallback_) {
-                    hotplugCallback_(conn.info, true);
-                }
-            } else {
-                drmModeFreeConnector(fresh);
-                
-                // Release CRTC
-                auto it = crtcToConnector_.find(conn.crtcId);
-                if (it != crtcToConnector_.end()) {
-                    crtcToConnector_.erase(it);
-                }
-                conn.crtcId = 0;
-                conn.info.enabled = false;
-                
-                if (hotplugCallback_) {
-                    hotplugCallback_(conn.info, false);
-                }
+            }
+            conn.connector = fresh;
+            conn.info.connected = true;
+            conn.info.enabled = false;
+            setupConnector(conn);
+            if (conn.info.enabled) {
+                applyResolutionModeToOutput(conn.info.index);
             }
         } else {
-            drmModeFreeConnector(fresh);
+            // Release CRTC
+            auto crtc = crtcToConnector_.find(conn.crtcId);
+            if (crtc != crtcToConnector_.end()) {
+                crtcToConnector_.erase(crtc);
+            }
+            conn.crtcId = 0;
+            conn.info.connected = false;
+            conn.info.enabled = false;
+        }
+        changed = true;
+        
+        LOG_INFO << "DRMOutputManager: " << conn.info.name
+                 << (change.connected ? " connected" : " disconnected");
+        if (hotplugCallback_) {
+            hotplugCallback_(conn.info, change.connected);
         }
     }
     
@@ -924,6 +954,106 @@ bool DRMOutputManager::prepareMode(int index, int width, int height, double refr
     return true;
 }
 
+bool DRMOutputManager::setModeAtomic(int index, int width, int height, double refreshRate) {
+    DRMConnector* conn = getConnector(index);
+    if (!atomicSupported_ || !conn || !conn->connector || !conn->crtcId || !conn->propCrtcId) {
+        return false;
+    }
+    
+    drmModeModeInfo* mode = findMode(conn->connector, width, height, refreshRate);
+    if (!mode) {
+        return false;
+    }
+    
+    uint32_t propModeId = getPropertyId(conn->crtcId, DRM_MODE_OBJECT_CRTC, "MODE_ID");
+    uint32_t propActive = getPropertyId(conn->crtcId, DRM_MODE_OBJECT_CRTC, "ACTIVE");
+    if (!propModeId || !propActive) {
+        return false;
+    }
+    
+    uint32_t blobId = 0;
+    if (drmModeCreatePropertyBlob(drmFd_, mode, sizeof(*mode), &blobId) != 0) {
+        LOG_WARNING << "DRMOutputManager: Cannot create mode blob: " << strerror(errno);
+        return false;
+    }
+    
+    drmModeAtomicReq* request = drmModeAtomicAlloc();
+    bool success = request &&
+        drmModeAtomicAddProperty(request, conn->crtcId, propModeId, blobId) >= 0 &&
+        drmModeAtomicAddProperty(request, conn->crtcId, propActive, 1) >= 0 &&
+        drmModeAtomicAddProperty(request, conn->connectorId, conn->propCrtcId, conn->crtcId) >= 0;
+    if (success) {
+        // Test first so a rejected mode leaves the output untouched
+        success = drmModeAtomicCommit(drmFd_, request,
+                                      DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr) == 0 &&
+                  drmModeAtomicCommit(drmFd_, request, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr) == 0;
+    }
+    if (request) {
+        drmModeAtomicFree(request);
+    }
+    // The CRTC holds its own reference to the blob
+    drmModeDestroyPropertyBlob(drmFd_, blobId);
+    
+    if (!success) {
+        LOG_WARNING << "DRMOutputManager: Atomic modeset to " << width << "x" << height
+                    << "@" << refreshRate << "Hz rejected for " << conn->info.name;
+        return false;
+    }
+    
+    conn->currentMode = *mode;
+    conn->hasCurrentMode = true;
+    conn->info.width = mode->hdisplay;
+    conn->info.height = mode->vdisplay;
+    if (mode->htotal && mode->vtotal) {
+        conn->info.refreshRate = static_cast<double>(mode->clock * 1000) /
+                                 (mode->htotal * mode->vtotal);
+    }
+    
+    LOG_INFO << "DRMOutputManager: Atomic modeset " << conn->info.name << " to "
+             << conn->info.width << "x" << conn->info.height
+             << "@" << conn->info.refreshRate << "Hz";
+    return true;
+}
+
+bool DRMOutputManager::isVrrCapable(int index) {
+    DRMConnector* conn = getConnector(index);
+    if (!conn || !conn->connectorId) {
+        return false;
+    }
+    return getPropertyValue(conn->connectorId, DRM_MODE_OBJECT_CONNECTOR, "vrr_capable") != 0;
+}
+
+bool DRMOutputManager::setVrrEnabled(int index, bool enabled) {
+    DRMConnector* conn = getConnector(index);
+    if (!atomicSupported_ || !conn || !conn->crtcId) {
+        return false;
+    }
+    uint32_t propVrr = getPropertyId(conn->crtcId, DRM_MODE_OBJECT_CRTC, "VRR_ENABLED");
+    if (!propVrr) {
+        return false;
+    }
+    
+    drmModeAtomicReq* request = drmModeAtomicAlloc();
+    if (!request) {
+        return false;
+    }
+    bool success = drmModeAtomicAddProperty(request, conn->crtcId, propVrr, enabled ? 1 : 0) >= 0;
+    if (success) {
+        // Most drivers toggle VRR in place; some need a modeset
+        success = drmModeAtomicCommit(drmFd_, request, 0, nullptr) == 0 ||
+                  drmModeAtomicCommit(drmFd_, request, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr) == 0;
+    }
+    drmModeAtomicFree(request);
+    
+    if (!success) {
+        LOG_WARNING << "DRMOutputManager: Cannot " << (enabled ? "enable" : "disable")
+                    << " VRR on " << conn->info.name << ": " << strerror(errno);
+        return false;
+    }
+    LOG_INFO << "DRMOutputManager: VRR " << (enabled ? "enabled" : "disabled") << " on " << conn->info.name;
+    return true;
+}
+
 bool DRMOutputManager::setMode(const std::string& name, int width, int height, double refreshRate) {
     DRMConnector* conn = getConnectorByName(name);
     if (!conn) {
@@ -1133,13 +1263,56 @@ drmModeAtomicReq* DRMOutputManager::createAtomicRequest() {
     return drmModeAtomicAlloc();
 }
 
-bool DRMOutputManager::commitAtomic(drmModeAtomicReq* request, uint32_t flags) {
+bool DRMOutputManager::addPlaneFlip(drmModeAtomicReq* request, const PlaneFlip& flip) {
+    const DRMPlane* plane = flip.plane;
+    if (!request || !plane || !plane->propertiesLoaded) {
+        return false;
+    }
+    
+    uint32_t id = plane->planeId;
+    if (drmModeAtomicAddProperty(request, id, plane->propFbId, flip.fbId) < 0 ||
+        drmModeAtomicAddProperty(request, id, plane->propCrtcId, flip.crtcId) < 0) {
+        LOG_WARNING << "DRMOutputManager: Failed to add flip of plane " << id;
+        return false;
+    }
+    
+    // Full framebuffer (16.16 source): the plane may still carry a canvas
+    // crop or a letterboxed video rectangle
+    drmModeAtomicAddProperty(request, id, plane->propSrcX, 0);
+    drmModeAtomicAddProperty(request, id, plane->propSrcY, 0);
+    drmModeAtomicAddProperty(request, id, plane->propSrcW, static_cast<uint64_t>(flip.width) << 16);
+    drmModeAtomicAddProperty(request, id, plane->propSrcH, static_cast<uint64_t>(flip.height) << 16);
+    drmModeAtomicAddProperty(request, id, plane->propCrtcX, 0);
+    drmModeAtomicAddProperty(request, id, plane->propCrtcY, 0);
+    drmModeAtomicAddProperty(request, id, plane->propCrtcW, flip.width);
+    drmModeAtomicAddProperty(request, id, plane->propCrtcH, flip.height);
+    
+    // The GPU may still be drawing the frame: the kernel waits for it
+    if (flip.inFence >= 0 && plane->propInFenceFd != 0) {
+        drmModeAtomicAddProperty(request, id, plane->propInFenceFd, static_cast<uint64_t>(flip.inFence));
+    }
+    if (flip.outFence && flip.outFencePtrProp != 0) {
+        drmModeAtomicAddProperty(request, flip.crtcId, flip.outFencePtrProp,
+                                 reinterpret_cast<uint64_t>(flip.outFence));
+    }
+    return true;
+}
+
+bool DRMOutputManager::commitAtomic(drmModeAtomicReq* request, uint32_t flags, void* userData) {
     if (!request || !atomicSupported_) {
         return false;
     }
     
-    int ret = drmModeAtomicCommit(drmFd_, request, flags, nullptr);
+    FRAME_TRACE_SCOPE("flip.submit");
+    int ret = drmModeAtomicCommit(drmFd_, request, flags, userData);
     if (ret != 0) {
+        if (-ret == EBUSY && (flags & DRM_MODE_ATOMIC_NONBLOCK)) {
+            LOG_VERBOSE << "DRMOutputManager: Atomic commit busy, retrying next frame";
+            return false;
+        }
+        if (flags & DRM_MODE_ATOMIC_TEST_ONLY) {
+            return false;   // The caller tries another configuration
+        }
         LOG_ERROR << "DRMOutputManager: Atomic commit failed: " << strerror(-ret);
         return false;
     }
@@ -1272,6 +1445,24 @@ void DRMOutputManager::loadPlaneProperties(DRMPlane& plane) {
     plane.propCrtcY = getPropertyId(plane.planeId, DRM_MODE_OBJECT_PLANE, "CRTC_Y");
     plane.propCrtcW = getPropertyId(plane.planeId, DRM_MODE_OBJECT_PLANE, "CRTC_W");
     plane.propCrtcH = getPropertyId(plane.planeId, DRM_MODE_OBJECT_PLANE, "CRTC_H");
+    plane.propInFenceFd = getPropertyId(plane.planeId, DRM_MODE_OBJECT_PLANE, "IN_FENCE_FD");
+    plane.propAlpha = getPropertyId(plane.planeId, DRM_MODE_OBJECT_PLANE, "alpha");
+    plane.propZpos = getPropertyId(plane.planeId, DRM_MODE_OBJECT_PLANE, "zpos");
+    if (plane.propZpos != 0) {
+        plane.zpos = getPropertyValue(plane.planeId, DRM_MODE_OBJECT_PLANE, "zpos");
+    }
+    
+    // Tiled and compressed layouts the plane scans out
+    uint64_t inFormats = getPropertyValue(plane.planeId, DRM_MODE_OBJECT_PLANE, "IN_FORMATS");
+    if (inFormats != 0) {
+        drmModePropertyBlobPtr blob = drmModeGetPropertyBlob(drmFd_, static_cast<uint32_t>(inFormats));
+        if (blob) {
+            if (!plane.inFormats.parse(blob->data, blob->length)) {
+                LOG_WARNING << "DRMOutputManager: Malformed IN_FORMATS on plane " << plane.planeId;
+            }
+            drmModeFreePropertyBlob(blob);
+        }
+    }
     
     plane.propertiesLoaded = (plane.propFbId != 0 && plane.propCrtcId != 0);
     
@@ -1317,5 +1508,29 @@ DRMPlane* DRMOutputManager::getPrimaryPlaneForCrtc(uint32_t crtcId) {
     return nullptr;
 }
 
+std::vector<DRMPlane*> DRMOutputManager::getOverlayPlanesForCrtc(uint32_t crtcId) {
+    std::vector<DRMPlane*> overlays;
+    int crtcIndex = getCrtcIndex(crtcId);
+    DRMPlane* primary = crtcIndex >= 0 ? getPrimaryPlaneForCrtc(crtcId) : nullptr;
+    if (!primary) {
+        return overlays;
+    }
+    uint32_t crtcMask = 1 << crtcIndex;
+    for (auto& plane : planes_) {
+        if (!(plane.possibleCrtcs & crtcMask) || plane.type != DRM_PLANE_TYPE_OVERLAY ||
+            !plane.propertiesLoaded || plane.propCrtcX == 0 || plane.propSrcX == 0) {
+            continue;
+        }
+        // Drivers with zpos may stack some overlays under the primary
+        if (plane.propZpos != 0 && primary->propZpos != 0 && plane.zpos <= primary->zpos) {
+            continue;
+        }
+        overlays.push_back(&plane);
+    }
+    std::stable_sort(overlays.begin(), overlays.end(),
+                     [](const DRMPlane* a, const DRMPlane* b) { return a->zpos < b->zpos; });
+    return overlays;
+}
+
 } // namespace videocomposer
 
@@ -17,6 +17,8 @@
 
 #include "../OutputInfo.h"
 #include "SeatManager.h"
+#include "HotplugMonitor.h"
+#include "FormatModifiers.h"
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <vector>
@@ -59,6 +61,11 @@ struct DRMPlane {
     uint32_t propCrtcY = 0;         // CRTC_Y property
     uint32_t propCrtcW = 0;         // CRTC_W property
     uint32_t propCrtcH = 0;         // CRTC_H property
+    uint32_t propInFenceFd = 0;     // IN_FENCE_FD property (0 = no explicit fencing)
+    uint32_t propAlpha = 0;         // alpha property, 0-0xffff (0 = opaque only)
+    uint32_t propZpos = 0;          // zpos property (0 = stacking by type)
+    uint64_t zpos = 0;              // Its value at discovery
+    FormatModifierTable inFormats;  // IN_FORMATS (empty = implicit layouts only)
     
     bool propertiesLoaded = false;  // True if property IDs are cached
 };
@@ -158,7 +165,9 @@ public:
     DRMConnector* getConnectorByName(const std::string& name);
     
     /**
-     * Refresh output detection (hotplug handling)
+     * Apply connection changes found by the hotplug monitor thread
+     * (connects get a CRTC and the resolution policy's mode)
+     * @return true if any output was connected or disconnected
      */
     bool refreshOutputs();
     
@@ -186,6 +195,25 @@ public:
      */
     bool prepareMode(int index, int width, int height, double refreshRate = 0.0);
     
+    /**
+     * Switch mode in one atomic commit (MODE_ID + ACTIVE + connector
+     * CRTC_ID), keeping the current framebuffer. Only for modes at the
+     * current resolution, e.g. a refresh rate change.
+     * @return false if atomic is unsupported or the commit was rejected
+     */
+    bool setModeAtomic(int index, int width, int height, double refreshRate);
+    
+    /**
+     * Connector reports vrr_capable (VRR/FreeSync/Adaptive-Sync display)
+     */
+    bool isVrrCapable(int index);
+    
+    /**
+     * Set the CRTC VRR_ENABLED property (atomic only)
+     * @return true if the property was committed
+     */
+    bool setVrrEnabled(int index, bool enabled);
+    
     // ===== Resolution Mode Selection =====
     
     /**
@@ -243,13 +271,37 @@ public:
      */
     drmModeAtomicReq* createAtomicRequest();
     
+    /**
+     * One plane's flip: its CRTC shows the whole framebuffer
+     */
+    struct PlaneFlip {
+        const DRMPlane* plane = nullptr;
+        uint32_t crtcId = 0;
+        uint32_t fbId = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int inFence = -1;               // Render fence for IN_FENCE_FD (-1 = none)
+        uint32_t outFencePtrProp = 0;   // CRTC's OUT_FENCE_PTR (0 = no out fence)
+        int32_t* outFence = nullptr;    // Written by the kernel on commit
+    };
+    
+    /**
+     * Add a plane flip to an atomic request
+     * Every plane flip in one commit lands on the same vblank when the
+     * CRTCs share a refresh rate, for the price of one ioctl.
+     * @return false if a property could not be added
+     */
+    bool addPlaneFlip(drmModeAtomicReq* request, const PlaneFlip& flip);
+    
     /**
      * Commit an atomic request
      * @param request Atomic request to commit
      * @param flags Commit flags (e.g., DRM_MODE_ATOMIC_NONBLOCK)
+     * @param userData Passed to the flip event of every CRTC in the commit
+     *        (with DRM_MODE_PAGE_FLIP_EVENT)
      * @return true on success
      */
-    bool commitAtomic(drmModeAtomicReq* request, uint32_t flags);
+    bool commitAtomic(drmModeAtomicReq* request, uint32_t flags, void* userData = nullptr);
     
     // ===== Plane Management =====
     
@@ -260,6 +312,12 @@ public:
      */
     DRMPlane* getPrimaryPlaneForCrtc(uint32_t crtcId);
     
+    /**
+     * Overlay planes a CRTC can use above its primary plane
+     * @return Planes bottom first (by zpos)
+     */
+    std::vector<DRMPlane*> getOverlayPlanesForCrtc(uint32_t crtcId);
+    
     /**
      * Get all planes
      */
@@ -305,8 +363,8 @@ public:
     void setHotplugCallback(HotplugCallback callback) { hotplugCallback_ = std::move(callback); }
     
     /**
-     * Poll for hotplug events
-     * Call periodically or when udev events indicate DRM changes
+     * Apply hotplug changes and fire the callback (cheap, call every frame;
+     * the probing runs on the monitor thread)
      */
     void pollHotplug();
     
@@ -334,6 +392,7 @@ private:
     
     // Hotplug
     HotplugCallback hotplugCallback_;
+    HotplugMonitor hotplugMonitor_;
     
     // ===== Private Methods =====
     
@@ -352,6 +411,11 @@ private:
      */
     bool detectOutputs();
     
+    /**
+     * Modes, EDID, properties, CRTC and initial mode of a connected output
+     */
+    void setupConnector(DRMConnector& connector);
+    
     /**
      * Get connector type name (HDMI, DP, VGA, etc.)
      */
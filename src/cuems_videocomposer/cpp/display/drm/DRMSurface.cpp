@@ -5,6 +5,7 @@
 #include "DRMSurface.h"
 #include "DRMOutputManager.h"
 #include "../../utils/Logger.h"
+#include "../../utils/FrameTracer.h"
 
 #include <cstring>
 #include <string>
@@ -35,6 +36,38 @@ DRMSurface::~DRMSurface() {
 }
 
 bool DRMSurface::init(EGLContext sharedContext, EGLDisplay sharedDisplay, gbm_device* sharedGbmDevice) {
+    return bindOutput() && createResources(sharedContext, sharedDisplay, sharedGbmDevice, true);
+}
+
+gbm_surface* DRMSurface::createTiledSurface(uint32_t& format) {
+    if (!modifiersAllowed_ || !plane_ || plane_->inFormats.empty()) {
+        return nullptr;
+    }
+    
+    static const uint32_t formats[] = {
+        GBM_FORMAT_ARGB8888, GBM_FORMAT_XRGB8888, GBM_FORMAT_ABGR8888, GBM_FORMAT_XBGR8888,
+    };
+    for (uint32_t candidate : formats) {
+        std::vector<uint64_t> modifiers = plane_->inFormats.getModifiers(candidate);
+        if (!FormatModifierTable::hasTiled(modifiers)) {
+            continue;   // Linear only: the implicit path does as well
+        }
+        // GBM picks the best layout the GPU renders to from the list
+        gbm_surface* surface = gbm_surface_create_with_modifiers(
+            gbmDevice_, width_, height_, candidate, modifiers.data(),
+            static_cast<unsigned int>(modifiers.size()));
+        if (surface) {
+            format = candidate;
+            LOG_INFO << "DRMSurface: Created GBM surface with format 0x" << std::hex << candidate << std::dec
+                     << " from " << modifiers.size() << " plane modifiers";
+            return surface;
+        }
+    }
+    LOG_VERBOSE << "DRMSurface: No surface with the plane's modifiers, using implicit layouts";
+    return nullptr;
+}
+
+bool DRMSurface::bindOutput() {
     if (!outputManager_ || !outputManager_->isInitialized()) {
         LOG_ERROR << "DRMSurface: Invalid output manager";
         return false;
@@ -53,6 +86,7 @@ bool DRMSurface::init(EGLContext sharedContext, EGLDisplay sharedDisplay, gbm_de
     height_ = connector->info.height;
     
     // Get primary plane for atomic modesetting
+    plane_ = nullptr;
     if (outputManager_->supportsAtomic()) {
         plane_ = outputManager_->getPrimaryPlaneForCrtc(crtcId_);
         if (plane_) {
@@ -63,13 +97,30 @@ bool DRMSurface::init(EGLContext sharedContext, EGLDisplay sharedDisplay, gbm_de
                         << ", atomic modesetting may not work";
         }
     }
+    propOutFencePtr_ = outputManager_->supportsAtomic()
+        ? outputManager_->getPropertyId(crtcId_, DRM_MODE_OBJECT_CRTC, "OUT_FENCE_PTR") : 0;
     
     if (width_ == 0 || height_ == 0) {
         LOG_ERROR << "DRMSurface: Invalid output dimensions";
         return false;
     }
     
-    LOG_INFO << "DRMSurface: Initializing for " << connector->info.name
+    // The CRTC (or the display behind it) is new: set the mode with the next frame
+    modeSet_ = false;
+    
+    // Initialize presentation timing with display refresh rate
+    const OutputInfo& outputInfo = connector->info;
+    if (outputInfo.refreshRate > 0) {
+        presentationTiming_.init(outputInfo.refreshRate);
+    } else {
+        presentationTiming_.init(60.0);  // Fallback to 60Hz
+    }
+    return true;
+}
+
+bool DRMSurface::createResources(EGLContext sharedContext, EGLDisplay sharedDisplay,
+                                 gbm_device* sharedGbmDevice, bool testCurrent) {
+    LOG_INFO << "DRMSurface: Initializing for " << outputName_
              << " (" << width_ << "x" << height_ << ")";
     
     // Use shared GBM device if provided, otherwise create new one
@@ -92,20 +143,6 @@ bool DRMSurface::init(EGLContext sharedContext, EGLDisplay sharedDisplay, gbm_de
     // Check if this is NVIDIA - it requires explicit modifiers
     bool isNvidia = gbmBackend && (std::string(gbmBackend).find("nvidia") != std::string::npos);
     
-    // TODO: Implement full mpv-style IN_FORMATS probing for all drivers.
-    // Currently we only use explicit modifiers for NVIDIA with hardcoded list. Improvements:
-    //   1. Query DRM plane resources via drmModeGetPlaneResources() to find primary plane
-    //   2. Query plane's "IN_FORMATS" property blob (drmModePropertyBlobPtr)
-    //   3. Parse drm_format_modifier_blob structure to get all supported format+modifier pairs
-    //   4. Filter modifiers for the selected format (ARGB8888/XRGB8888)
-    //   5. Pass complete probed modifier list to gbm_surface_create_with_modifiers()
-    // Benefits:
-    //   - Optimal tiled formats on Intel/AMD (may improve performance)
-    //   - Support for all NVIDIA modifier variants (not just h=0..5)
-    //   - Automatic adaptation to driver updates/new modifiers
-    //   - Works correctly for all GPU vendors without hardcoded lists
-    // See mpv's probe_gbm_modifiers() in video/out/opengl/context_drm_egl.c:473
-    
     // TODO: Probe plane formats instead of hardcoded list.
     // Currently we try hardcoded formats. Better approach (mpv-style):
     //   1. Get primary plane via drmModeGetPlane() for the CRTC
@@ -128,6 +165,13 @@ bool DRMSurface::init(EGLContext sharedContext, EGLDisplay sharedDisplay, gbm_de
     // Track the format we successfully created
     uint32_t gbmFormat = 0;
     
+    // The plane's IN_FORMATS modifiers (mpv's probe_gbm_modifiers()): tiled
+    // and compressed layouts on Intel/AMD, every variant on NVIDIA
+    gbmSurface_ = createTiledSurface(gbmFormat);
+    if (gbmSurface_) {
+        goto gbm_surface_created;
+    }
+    
     // NVIDIA requires explicit modifiers - try gbm_surface_create_with_modifiers
     // Based on drm_info, NVIDIA supports BLOCK_LINEAR_2D modifiers
     if (isNvidia) {
@@ -337,6 +381,11 @@ gbm_surface_created:
         };
         
         eglContext_ = eglCreateContext(eglDisplay_, eglConfig_, EGL_NO_CONTEXT, contextAttribs);
+        if (eglContext_ == EGL_NO_CONTEXT) {
+            // No profiles on the GLES API: version 3 only (the renderer needs GLES 3)
+            EGLint versionAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_NONE };
+            eglContext_ = eglCreateContext(eglDisplay_, eglConfig_, EGL_NO_CONTEXT, versionAttribs);
+        }
         if (eglContext_ == EGL_NO_CONTEXT) {
             // Try simpler context
             EGLint simpleAttribs[] = { EGL_NONE };
@@ -389,33 +438,32 @@ gbm_surface_created:
         return false;
     }
     
-    // Make context current to test
-    if (!eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_)) {
-        LOG_ERROR << "DRMSurface: Failed to make EGL context current";
-        cleanup();
-        return false;
-    }
-    
-    // Disable EGL's internal vsync - we handle vsync via DRM page flips
-    // This prevents double-waiting (EGL vsync + DRM page flip) which causes jitter
-    // mpv does this in context_drm_egl.c
-    eglSwapInterval(eglDisplay_, 0);
-    
-    // Log GL info
-    LOG_INFO << "DRMSurface: GL Vendor: " << (const char*)glGetString(GL_VENDOR);
-    LOG_INFO << "DRMSurface: GL Renderer: " << (const char*)glGetString(GL_RENDERER);
-    LOG_INFO << "DRMSurface: GL Version: " << (const char*)glGetString(GL_VERSION);
-    
-    eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-    
-    // Initialize presentation timing with display refresh rate
-    const OutputInfo& outputInfo = getOutputInfo();
-    if (outputInfo.refreshRate > 0) {
-        presentationTiming_.init(outputInfo.refreshRate);
+    if (testCurrent) {
+        // Make context current to test
+        if (!eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_)) {
+            LOG_ERROR << "DRMSurface: Failed to make EGL context current";
+            cleanup();
+            return false;
+        }
+        
+        // Disable EGL's internal vsync - we handle vsync via DRM page flips
+        // This prevents double-waiting (EGL vsync + DRM page flip) which causes jitter
+        // mpv does this in context_drm_egl.c
+        eglSwapInterval(eglDisplay_, 0);
+        
+        // Log GL info
+        LOG_INFO << "DRMSurface: GL Vendor: " << (const char*)glGetString(GL_VENDOR);
+        LOG_INFO << "DRMSurface: GL Renderer: " << (const char*)glGetString(GL_RENDERER);
+        LOG_INFO << "DRMSurface: GL Version: " << (const char*)glGetString(GL_VERSION);
+        
+        eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     } else {
-        presentationTiming_.init(60.0);  // Fallback to 60Hz
+        // The shared context is current on the render thread
+        swapIntervalPending_ = true;
     }
     
+    initExplicitFencing();
+    
     initialized_ = true;
     LOG_INFO << "DRMSurface: Initialized successfully for " << outputName_;
     
@@ -423,14 +471,18 @@ gbm_surface_created:
 }
 
 void DRMSurface::cleanup() {
-    // Wait for any pending flip
+    // Wait for any pending flip (a queued frame is not shown)
+    dropQueuedBuffer();
     if (flipPending_) {
         waitForFlip();
     }
     
     // Destroy framebuffers
-    destroyFramebuffer(currentFb_);
-    destroyFramebuffer(nextFb_);
+    destroyFramebuffers();
+    
+    waitForOutFence();
+    closeFence(renderFence_);
+    closeFence(pendingFence_);
     
     // Release BOs
     if (previousBo_ && gbmSurface_) {
@@ -505,13 +557,13 @@ bool DRMSurface::resize(int width, int height) {
              << " to " << width << "x" << height;
     
     // Wait for pending flip
+    dropQueuedBuffer();
     if (flipPending_) {
         waitForFlip();
     }
     
     // Destroy old framebuffers
-    destroyFramebuffer(currentFb_);
-    destroyFramebuffer(nextFb_);
+    destroyFramebuffers();
     
     // Release current BO
     if (currentBo_ && gbmSurface_) {
@@ -555,7 +607,13 @@ bool DRMSurface::resize(int width, int height) {
         { GBM_FORMAT_XBGR8888, "XBGR8888" },
     };
     
-    // NVIDIA requires explicit modifiers (see TODO in init() for full IN_FORMATS probing)
+    uint32_t tiledFormat = 0;
+    gbmSurface_ = createTiledSurface(tiledFormat);
+    if (gbmSurface_) {
+        goto gbm_resize_surface_created;
+    }
+    
+    // NVIDIA requires explicit modifiers (without IN_FORMATS on the plane)
     if (isNvidia) {
         // Same NVIDIA modifiers as in init()
         uint64_t nvidiaModifiers[] = {
@@ -644,6 +702,10 @@ const OutputInfo& DRMSurface::getOutputInfo() const {
 void DRMSurface::makeCurrent() {
     if (eglDisplay_ != EGL_NO_DISPLAY && eglContext_ != EGL_NO_CONTEXT) {
         eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+        if (swapIntervalPending_) {
+            eglSwapInterval(eglDisplay_, 0);
+            swapIntervalPending_ = false;
+        }
     }
 }
 
@@ -654,12 +716,93 @@ void DRMSurface::releaseCurrent() {
 }
 
 void DRMSurface::swapBuffers() {
-    if (eglDisplay_ != EGL_NO_DISPLAY && eglSurface_ != EGL_NO_SURFACE) {
+    if (eglDisplay_ == EGL_NO_DISPLAY || eglSurface_ == EGL_NO_SURFACE) {
+        return;
+    }
+    
+    if (!explicitFencing_) {
         // Use glFinish to ensure GPU completely finishes before swap
         // This provides maximum synchronization at cost of some latency
         glFinish();
         eglSwapBuffers(eglDisplay_, eglSurface_);
+        return;
     }
+    
+    // The fence follows the frame's rendering; the swap flushes it, so it
+    // has a sync file afterwards. The kernel waits for it, not the CPU.
+    EGLint attribs[] = {
+        EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID,
+        EGL_NONE
+    };
+    EGLSyncKHR sync = eglCreateSyncKHR_(eglDisplay_, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+    eglSwapBuffers(eglDisplay_, eglSurface_);
+    closeFence(renderFence_);
+    if (sync != EGL_NO_SYNC_KHR) {
+        renderFence_ = eglDupNativeFenceFDANDROID_(eglDisplay_, sync);
+        eglDestroySyncKHR_(eglDisplay_, sync);
+    }
+    if (renderFence_ < 0) {
+        // No fence this frame: the buffer must be complete all the same
+        renderFence_ = -1;
+        glFinish();
+    }
+}
+
+void DRMSurface::initExplicitFencing() {
+    explicitFencing_ = false;
+    if (!explicitFencingAllowed_ || !outputManager_->supportsAtomic()) {
+        return;
+    }
+    const char* extensions = eglQueryString(eglDisplay_, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_ANDROID_native_fence_sync")) {
+        eglCreateSyncKHR_ = (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+        eglDestroySyncKHR_ = (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+        eglDupNativeFenceFDANDROID_ =
+            (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)eglGetProcAddress("eglDupNativeFenceFDANDROID");
+        explicitFencing_ = eglCreateSyncKHR_ && eglDestroySyncKHR_ && eglDupNativeFenceFDANDROID_;
+    }
+    LOG_INFO << "DRMSurface: " << outputName_ << " flips "
+             << (explicitFencing_ ? "with the render fence as IN_FENCE_FD" : "after glFinish()");
+}
+
+bool DRMSurface::waitFence(int fd, int timeoutMs) {
+    struct pollfd pfd = {};
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (true) {
+        int ret = poll(&pfd, 1, timeoutMs);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        return ret > 0;
+    }
+}
+
+void DRMSurface::closeFence(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+void DRMSurface::waitRenderFence() {
+    if (renderFence_ < 0) {
+        return;
+    }
+    if (!waitFence(renderFence_, 1000)) {
+        LOG_WARNING << "DRMSurface: Render fence timeout";
+    }
+    closeFence(renderFence_);
+}
+
+void DRMSurface::waitForOutFence() {
+    if (outFence_ < 0) {
+        return;
+    }
+    if (!waitFence(outFence_, 1000)) {
+        LOG_WARNING << "DRMSurface: Page flip timeout";
+    }
+    closeFence(outFence_);
 }
 
 bool DRMSurface::beginFrame() {
@@ -752,6 +895,10 @@ bool DRMSurface::createFramebuffer(gbm_bo* bo, Framebuffer& fb) {
     int ret = drmModeAddFB2WithModifiers(outputManager_->getFd(), width, height,
                                           format, handles, strides, offsets,
                                           modifiers, &fb.fbId, flags);
+    if (ret == 0) {
+        LOG_VERBOSE << "DRMSurface: Framebuffer " << fb.fbId << " modifier 0x" << std::hex << modifier
+                    << std::dec << " (" << num_planes << " plane(s))";
+    }
     
     // Fallback: try drmModeAddFB2 without modifiers array
     if (ret != 0) {
@@ -798,26 +945,49 @@ void DRMSurface::destroyFramebuffer(Framebuffer& fb) {
     fb.bo = nullptr;
 }
 
+uint32_t DRMSurface::framebufferFor(gbm_bo* bo) {
+    for (const Framebuffer& fb : framebuffers_) {
+        if (fb.bo == bo) {
+            return fb.fbId;
+        }
+    }
+    Framebuffer fb;
+    if (!createFramebuffer(bo, fb)) {
+        return 0;
+    }
+    framebuffers_.push_back(fb);
+    return fb.fbId;
+}
+
+void DRMSurface::destroyFramebuffers() {
+    for (Framebuffer& fb : framebuffers_) {
+        destroyFramebuffer(fb);
+    }
+    framebuffers_.clear();
+}
+
 bool DRMSurface::schedulePageFlip() {
     if (!initialized_ || !outputManager_ || flipPending_) {
         return false;
     }
     
     // Lock front buffer from GBM surface
-    // Note: glFinish() is called before swapBuffers to ensure rendering is complete
+    // Note: rendering is complete (glFinish() before the swap, or the CPU
+    // waits for the render fence: a legacy flip takes no IN_FENCE_FD)
+    waitRenderFence();
     gbm_bo* bo = gbm_surface_lock_front_buffer(gbmSurface_);
     if (!bo) {
         LOG_ERROR << "DRMSurface: Failed to lock front buffer";
         return false;
     }
-    
-    // Check if we need to create a new framebuffer
-    if (nextFb_.bo != bo) {
-        destroyFramebuffer(nextFb_);
-        if (!createFramebuffer(bo, nextFb_)) {
-            gbm_surface_release_buffer(gbmSurface_, bo);
-            return false;
-        }
+    return flipBuffer(bo, PresentationTiming::getCurrentTimeNs(), frameTag_);
+}
+
+bool DRMSurface::flipBuffer(gbm_bo* bo, int64_t readyNs, int64_t tag) {
+    uint32_t fbId = framebufferFor(bo);
+    if (fbId == 0) {
+        gbm_surface_release_buffer(gbmSurface_, bo);
+        return false;
     }
     
     int ret;
@@ -849,7 +1019,7 @@ bool DRMSurface::schedulePageFlip() {
         LOG_INFO << "DRMSurface: Setting mode for " << conn->info.name 
                  << " (" << mode->hdisplay << "x" << mode->vdisplay << ")";
         ret = drmModeSetCrtc(outputManager_->getFd(), crtcId_,
-                            nextFb_.fbId, 0, 0, &connectorId_, 1, mode);
+                            fbId, 0, 0, &connectorId_, 1, mode);
         
         if (ret != 0) {
             LOG_ERROR << "DRMSurface: Modeset failed: " << strerror(-ret);
@@ -874,17 +1044,19 @@ bool DRMSurface::schedulePageFlip() {
             gbm_surface_release_buffer(gbmSurface_, currentBo_);
         }
         currentBo_ = bo;
-        
-        // Swap framebuffers
-        std::swap(currentFb_, nextFb_);
+        currentReadyNs_ = readyNs;
+        currentTag_ = tag;
+        updateQueueDepth();
         
         // No flip pending for modeset
         return true;
     }
     
     // Subsequent frames: use page flip for vsync
+    int64_t submitNs = FrameTracer::nowNs();
     ret = drmModePageFlip(outputManager_->getFd(), crtcId_,
-                              nextFb_.fbId, DRM_MODE_PAGE_FLIP_EVENT, this);
+                              fbId, DRM_MODE_PAGE_FLIP_EVENT, this);
+    FrameTracer::instance().record("flip.submit", submitNs, FrameTracer::nowNs(), crtcId_);
     
     if (ret != 0) {
         // EBUSY (16) = flip already pending, ENOSPC (28) = no buffer slots
@@ -911,7 +1083,7 @@ bool DRMSurface::schedulePageFlip() {
             
             if (mode) {
                 ret = drmModeSetCrtc(outputManager_->getFd(), crtcId_,
-                                    nextFb_.fbId, 0, 0, &connectorId_, 1, mode);
+                                    fbId, 0, 0, &connectorId_, 1, mode);
                 if (ret != 0) {
                     LOG_ERROR << "DRMSurface: SetCrtc fallback failed: " << strerror(-ret);
                     gbm_surface_release_buffer(gbmSurface_, bo);
@@ -924,7 +1096,9 @@ bool DRMSurface::schedulePageFlip() {
                     gbm_surface_release_buffer(gbmSurface_, currentBo_);
                 }
                 currentBo_ = bo;
-                std::swap(currentFb_, nextFb_);
+                currentReadyNs_ = readyNs;
+                currentTag_ = tag;
+                updateQueueDepth();
                 
                 // No flip pending in fallback mode
                 return true;
@@ -943,13 +1117,102 @@ bool DRMSurface::schedulePageFlip() {
     // hasFreeBuffers() returns true and we render to the displayed buffer = corruption
     previousBo_ = currentBo_;
     currentBo_ = bo;
+    currentReadyNs_ = readyNs;
+    currentTag_ = tag;
+    updateQueueDepth();
     
-    // Swap framebuffers
-    std::swap(currentFb_, nextFb_);
+    return true;
+}
+
+void DRMSurface::acquireRenderBuffer() {
+    if (bufferCount_ < 3 || !outputManager_) {
+        return;
+    }
+    processFlipEvents();
+    if (!queuedBo_) {
+        return;
+    }
+    
+    // A frame is already waiting: wait for the vblank that flips it, not for
+    // the queue to drain
+    int fd = outputManager_->getFd();
+    struct pollfd pfd = {};
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (queuedBo_ && flipPending_) {
+        int ret = poll(&pfd, 1, 1000);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            LOG_WARNING << "DRMSurface: Page flip timeout";
+            flipPending_ = false;
+            break;
+        }
+        handleFlipEvents(fd);
+    }
+    
+    // The flip was lost (or never pending): show the queued frame now
+    if (queuedBo_ && !flipPending_) {
+        flipQueuedBuffer();
+    }
+}
+
+bool DRMSurface::presentFrame() {
+    if (!initialized_ || !outputManager_) {
+        return false;
+    }
+    if (bufferCount_ < 3 || !modeSet_) {
+        if (flipPending_) {
+            waitForFlip();
+        }
+        return schedulePageFlip();
+    }
+    
+    // The flip may have completed while this frame was drawn
+    processFlipEvents();
+    if (!flipPending_) {
+        return schedulePageFlip();
+    }
     
+    waitRenderFence();
+    gbm_bo* bo = gbm_surface_lock_front_buffer(gbmSurface_);
+    if (!bo) {
+        LOG_ERROR << "DRMSurface: Failed to lock front buffer";
+        return false;
+    }
+    // Newest frame wins
+    if (queuedBo_) {
+        gbm_surface_release_buffer(gbmSurface_, queuedBo_);
+        presentationTiming_.recordBufferReplaced();
+    }
+    queuedBo_ = bo;
+    queuedReadyNs_ = PresentationTiming::getCurrentTimeNs();
+    queuedTag_ = frameTag_;
+    updateQueueDepth();
     return true;
 }
 
+void DRMSurface::flipQueuedBuffer() {
+    gbm_bo* bo = queuedBo_;
+    queuedBo_ = nullptr;
+    if (bo && !flipBuffer(bo, queuedReadyNs_, queuedTag_)) {
+        updateQueueDepth();
+    }
+}
+
+void DRMSurface::dropQueuedBuffer() {
+    if (queuedBo_ && gbmSurface_) {
+        gbm_surface_release_buffer(gbmSurface_, queuedBo_);
+    }
+    queuedBo_ = nullptr;
+    updateQueueDepth();
+}
+
+void DRMSurface::updateQueueDepth() {
+    presentationTiming_.recordQueueDepth((previousBo_ ? 1 : 0) + (currentBo_ ? 1 : 0) + (queuedBo_ ? 1 : 0));
+}
+
 uint32_t DRMSurface::prepareAtomicFlip() {
     if (!initialized_ || !outputManager_ || flipPending_) {
         LOG_DEBUG << "DRMSurface: Cannot prepare atomic flip (init=" << initialized_ 
@@ -957,6 +1220,15 @@ uint32_t DRMSurface::prepareAtomicFlip() {
         return 0;
     }
     
+    // The previous non-blocking commit must have flipped before the next
+    waitForOutFence();
+    
+    // The commit carries the render fence; a plane without IN_FENCE_FD
+    // needs the rendering complete first
+    if (!plane_ || plane_->propInFenceFd == 0) {
+        waitRenderFence();
+    }
+    
     // Lock front buffer from GBM surface
     // Note: After eglSwapBuffers(), front buffer should always be available
     gbm_bo* bo = gbm_surface_lock_front_buffer(gbmSurface_);
@@ -966,20 +1238,20 @@ uint32_t DRMSurface::prepareAtomicFlip() {
         return 0;
     }
     
-    // Check if we need to create a new framebuffer
-    if (nextFb_.bo != bo) {
-        destroyFramebuffer(nextFb_);
-        if (!createFramebuffer(bo, nextFb_)) {
-            gbm_surface_release_buffer(gbmSurface_, bo);
-            return 0;
-        }
+    uint32_t fbId = framebufferFor(bo);
+    if (fbId == 0) {
+        gbm_surface_release_buffer(gbmSurface_, bo);
+        return 0;
     }
     
     // Store the BO and FB ID for later (will be committed in finalizeAtomicFlip)
     pendingBo_ = bo;
-    pendingFbId_ = nextFb_.fbId;
+    pendingFbId_ = fbId;
+    closeFence(pendingFence_);
+    pendingFence_ = renderFence_;
+    renderFence_ = -1;
     
-    return nextFb_.fbId;
+    return fbId;
 }
 
 void DRMSurface::cancelAtomicFlip() {
@@ -988,16 +1260,28 @@ void DRMSurface::cancelAtomicFlip() {
         gbm_surface_release_buffer(gbmSurface_, pendingBo_);
         pendingBo_ = nullptr;
     }
+    // A fallback flip of the same frame still has to wait for it
+    if (pendingFence_ >= 0) {
+        closeFence(renderFence_);
+        renderFence_ = pendingFence_;
+        pendingFence_ = -1;
+    }
 }
 
-void DRMSurface::finalizeAtomicFlip() {
+void DRMSurface::finalizeAtomicFlip(int outFence) {
     if (!pendingBo_) {
+        closeFence(outFence);
         return;
     }
     
     // For atomic commits, we don't use page flip events (user_data is NULL)
     // Instead, we release the previous buffer immediately since atomic commit
-    // guarantees all planes flip together on the same vsync
+    // guarantees all planes flip together on the same vsync. After a
+    // non-blocking commit the next prepareAtomicFlip() waits for the out
+    // fence first, so the buffer released then is off screen.
+    closeFence(pendingFence_);
+    closeFence(outFence_);
+    outFence_ = outFence;
     
     // Release the OLD buffer (it was being displayed, now new one is)
     if (previousBo_ && gbmSurface_) {
@@ -1007,16 +1291,104 @@ void DRMSurface::finalizeAtomicFlip() {
     // Update buffer tracking
     previousBo_ = currentBo_;  // Current becomes previous (still being displayed until next flip)
     currentBo_ = pendingBo_;
+    currentReadyNs_ = 0;
+    currentTag_ = frameTag_;
     pendingBo_ = nullptr;
     pendingFbId_ = 0;
-    
-    // Swap framebuffers
-    std::swap(currentFb_, nextFb_);
+    updateQueueDepth();
     
     // Don't set flipPending_ for atomic - we handle buffer release ourselves
     // This allows the next frame to proceed immediately
 }
 
+bool DRMSurface::scheduleAtomicPageFlip() {
+    if (!modeSet_ || !plane_ || !plane_->propertiesLoaded || !outputManager_ ||
+        !outputManager_->supportsAtomic()) {
+        return schedulePageFlip();
+    }
+    
+    drmModeAtomicReq* request = drmModeAtomicAlloc();
+    if (!request) {
+        return false;
+    }
+    if (!addAtomicPageFlip(request)) {
+        drmModeAtomicFree(request);
+        return false;
+    }
+    
+    int64_t submitNs = FrameTracer::nowNs();
+    int ret = drmModeAtomicCommit(outputManager_->getFd(), request,
+                                  DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, this);
+    FrameTracer::instance().record("flip.submit", submitNs, FrameTracer::nowNs(), crtcId_);
+    drmModeAtomicFree(request);
+    if (ret != 0) {
+        if (-ret == EBUSY) {
+            LOG_VERBOSE << "DRMSurface: Atomic flip busy, retrying next frame";
+        } else {
+            LOG_WARNING << "DRMSurface: Atomic flip failed: " << strerror(-ret);
+        }
+        cancelAtomicFlip();
+        return false;
+    }
+    
+    atomicPageFlipScheduled();
+    return true;
+}
+
+bool DRMSurface::addAtomicPageFlip(drmModeAtomicReq* request) {
+    if (!modeSet_ || !plane_ || !plane_->propertiesLoaded || !outputManager_) {
+        return false;
+    }
+    
+    uint32_t fbId = prepareAtomicFlip();
+    if (fbId == 0) {
+        return false;
+    }
+    
+    DRMOutputManager::PlaneFlip flip;
+    flip.plane = plane_;
+    flip.crtcId = crtcId_;
+    flip.fbId = fbId;
+    flip.width = width_;
+    flip.height = height_;
+    flip.inFence = pendingFence_;
+    if (!outputManager_->addPlaneFlip(request, flip)) {
+        cancelAtomicFlip();
+        return false;
+    }
+    return true;
+}
+
+void DRMSurface::atomicPageFlipScheduled() {
+    // A synchronized commit may have left its last buffer referenced
+    if (previousBo_ && gbmSurface_) {
+        gbm_surface_release_buffer(gbmSurface_, previousBo_);
+    }
+    
+    // Released by pageFlipHandler, as for legacy flips
+    closeFence(pendingFence_);
+    flipPending_ = true;
+    previousBo_ = currentBo_;
+    currentBo_ = pendingBo_;
+    currentReadyNs_ = 0;
+    currentTag_ = frameTag_;
+    pendingBo_ = nullptr;
+    pendingFbId_ = 0;
+    updateQueueDepth();
+}
+
+bool DRMSurface::isFlipPending() const {
+    if (flipPending_) {
+        return true;
+    }
+    for (const DRMSurface* peer : flipPeers_) {
+        if (peer->flipPending_) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void DRMSurface::waitForFlip() {
     if (!flipPending_ || !outputManager_) {
         return;
@@ -1029,9 +1401,6 @@ void DRMSurface::waitForFlip() {
     pfd.fd = fd;
     pfd.events = POLLIN;
     
-    drmEventContext evctx = {};
-    evctx.version = 2;
-    evctx.page_flip_handler = pageFlipHandler;
     
     while (flipPending_) {
         int ret = poll(&pfd, 1, 1000);  // 1 second timeout
@@ -1050,31 +1419,65 @@ void DRMSurface::waitForFlip() {
         }
         
         if (pfd.revents & POLLIN) {
-            drmHandleEvent(fd, &evctx);
+            handleFlipEvents(fd);
         }
     }
     
     flipPending_ = false;
 }
 
+void DRMSurface::handleFlipEvents(int fd) {
+    drmEventContext evctx = {};
+    evctx.version = 3;
+    evctx.page_flip_handler2 = pageFlipHandler;
+    drmHandleEvent(fd, &evctx);
+}
+
 void DRMSurface::pageFlipHandler(int fd, unsigned int frame,
                                   unsigned int sec, unsigned int usec,
-                                  void* data) {
+                                  unsigned int crtcId, void* data) {
     (void)fd;
     DRMSurface* surface = static_cast<DRMSurface*>(data);
-    if (surface) {
-        // Record presentation timing (like mpv's drm_pflip_cb)
-        // frame = msc (vsync counter), sec/usec = presentation timestamp
-        surface->presentationTiming_.recordFlip(sec, usec, frame);
-        
-        // NOW it's safe to release the previous buffer - flip is complete,
-        // so previousBo_ is no longer being displayed
-        if (surface->previousBo_ && surface->gbmSurface_) {
-            gbm_surface_release_buffer(surface->gbmSurface_, surface->previousBo_);
-            surface->previousBo_ = nullptr;
+    if (!surface) {
+        return;
+    }
+    // One event per CRTC, all with the user data of the commit
+    if (crtcId != 0 && crtcId != surface->crtcId_) {
+        for (DRMSurface* peer : surface->flipPeers_) {
+            if (peer->crtcId_ == crtcId) {
+                surface = peer;
+                break;
+            }
         }
-        
-        surface->flipPending_ = false;
+    }
+    surface->flipCompleted(frame, sec, usec);
+}
+
+void DRMSurface::flipCompleted(unsigned int frame, unsigned int sec, unsigned int usec) {
+    // Record presentation timing (like mpv's drm_pflip_cb)
+    // frame = msc (vsync counter), sec/usec = presentation timestamp
+    presentationTiming_.recordFlip(sec, usec, frame);
+    presentationTiming_.recordPresentedFrame(currentTag_);
+    // The kernel's vblank timestamp (CLOCK_MONOTONIC, the trace clock)
+    FrameTracer::instance().instant("flip.complete",
+                                    static_cast<int64_t>(sec) * 1000000000LL + static_cast<int64_t>(usec) * 1000,
+                                    crtcId_);
+    presentationTiming_.recordBufferPresented(currentReadyNs_);
+    
+    // NOW it's safe to release the previous buffer - flip is complete,
+    // so previousBo_ is no longer being displayed
+    if (previousBo_ && gbmSurface_) {
+        gbm_surface_release_buffer(gbmSurface_, previousBo_);
+        previousBo_ = nullptr;
+    }
+    
+    flipPending_ = false;
+    
+    // Mailbox: the newest finished frame goes out on the next vblank
+    if (queuedBo_) {
+        flipQueuedBuffer();
+    } else {
+        updateQueueDepth();
     }
 }
 
@@ -1100,10 +1503,7 @@ bool DRMSurface::processFlipEvents() {
     int ret = poll(&pfd, 1, 0);  // timeout=0 for non-blocking
     
     if (ret > 0 && (pfd.revents & POLLIN)) {
-        drmEventContext evctx = {};
-        evctx.version = 2;
-        evctx.page_flip_handler = pageFlipHandler;
-        drmHandleEvent(fd, &evctx);
+        handleFlipEvents(fd);
         return !flipPending_;  // Return true if flip completed
     }
     
@@ -8,8 +8,10 @@
  * Features:
  * - GBM surface for buffer allocation
  * - EGL surface for OpenGL rendering
- * - Double-buffered page flipping
+ * - Triple-buffered page flipping with a mailbox (or double-buffered)
  * - Synchronized vsync presentation
+ * - Explicit fencing: the frame's render fence goes to the plane's
+ *   IN_FENCE_FD instead of a glFinish() before the swap
  */
 
 #ifndef VIDEOCOMPOSER_DRMSURFACE_H
@@ -53,7 +55,7 @@ public:
     // ===== Initialization =====
     
     /**
-     * Initialize GBM + EGL for this output
+     * Initialize GBM + EGL for this output (bindOutput() + createResources())
      * @param sharedContext Optional EGL context to share resources with
      * @param sharedDisplay Optional shared EGL display (required for context sharing)
      * @param sharedGbmDevice Optional shared GBM device (for resource sharing)
@@ -63,6 +65,24 @@ public:
               EGLDisplay sharedDisplay = EGL_NO_DISPLAY,
               gbm_device* sharedGbmDevice = nullptr);
     
+    /**
+     * Take the connector, CRTC, plane and size from the output manager
+     * (render thread). Again after a reconnect: the next frame redoes the
+     * modeset.
+     * @return false if the output is not connected
+     */
+    bool bindOutput();
+    
+    /**
+     * Create the GBM surface, EGL surface and context for the bound size
+     * @param testCurrent Make the context current once to check it. Pass
+     *        false off the render thread (a hotplugged output's surface,
+     *        prepared while the shared context is current there); the swap
+     *        interval is then set by the first makeCurrent().
+     */
+    bool createResources(EGLContext sharedContext, EGLDisplay sharedDisplay,
+                         gbm_device* sharedGbmDevice, bool testCurrent = true);
+    
     /**
      * Cleanup all resources
      */
@@ -111,9 +131,18 @@ public:
     void waitForFlip() override;
     
     /**
-     * Check if a flip is pending
+     * Check if a flip is pending, here or on a flip peer (a group flips
+     * together, so it is drawn only once every member is free)
+     */
+    bool isFlipPending() const override;
+    
+    /**
+     * Outputs flipped in the same commit as this one (same refresh rate);
+     * their flip events may be read through this surface
      */
-    bool isFlipPending() const override { return flipPending_; }
+    void clearFlipPeers() { flipPeers_.clear(); }
+    void addFlipPeer(DRMSurface* peer) { flipPeers_.push_back(peer); }
+    const std::vector<DRMSurface*>& getFlipPeers() const { return flipPeers_; }
     
     /**
      * Check if GBM surface has free buffers available
@@ -127,6 +156,58 @@ public:
      */
     bool processFlipEvents();
     
+    // ===== Swapchain =====
+    
+    /**
+     * Buffers in the swapchain
+     * 2: the next frame is flipped once the pending flip completes.
+     * 3: a finished frame waits in a mailbox while a flip is pending and is
+     *    flipped on the next vblank; a newer frame replaces it.
+     * @param count 2 or 3
+     */
+    void setBufferCount(int count) { bufferCount_ = count >= 3 ? 3 : 2; }
+    
+    /**
+     * Allow explicit fencing (off: glFinish() before every swap); call
+     * before init()
+     */
+    void setExplicitFencingAllowed(bool allowed) { explicitFencingAllowed_ = allowed; }
+    
+    /**
+     * Allocate with the plane's IN_FORMATS modifiers (off: implicit
+     * layouts only); call before init()
+     */
+    void setModifiersAllowed(bool allowed) { modifiersAllowed_ = allowed; }
+    int getBufferCount() const { return bufferCount_; }
+    
+    /**
+     * Call before drawing a frame that will be shown with presentFrame()
+     * With a mailbox, waits only while a finished frame is already queued
+     * (the loop then runs one frame ahead of the display, never more);
+     * rendering never waits for the flip of the frame before it.
+     */
+    void acquireRenderBuffer();
+    
+    /**
+     * Show the frame just swapped: flipped now when no flip is pending,
+     * otherwise queued in the mailbox (3 buffers) or flipped after the
+     * pending flip completes (2 buffers)
+     * @return true if the frame was flipped or queued
+     */
+    bool presentFrame();
+    
+    /**
+     * Check if a finished frame is waiting in the mailbox
+     */
+    bool hasQueuedFrame() const { return queuedBo_ != nullptr; }
+    
+    /**
+     * Frame number shown by the frame being drawn, logged with its flip
+     * (PresentationTiming::setFrameLogEnabled)
+     * @param tag Frame number, or -1 if unknown
+     */
+    void setFrameTag(int64_t tag) { frameTag_ = tag; }
+    
     // ===== Atomic Modesetting Support =====
     
     /**
@@ -139,8 +220,10 @@ public:
     /**
      * Finalize atomic flip after successful drmModeAtomicCommit
      * Updates internal state (currentBo_, previousBo_, etc.)
+     * @param outFence The CRTC's OUT_FENCE_PTR fence of a non-blocking
+     *        commit (owned from here on), -1 for a blocking commit
      */
-    void finalizeAtomicFlip();
+    void finalizeAtomicFlip(int outFence = -1);
     
     /**
      * Cancel atomic flip if prepare succeeded but commit failed
@@ -148,6 +231,50 @@ public:
      */
     void cancelAtomicFlip();
     
+    /**
+     * Render fence (sync file) of the buffer prepared by prepareAtomicFlip(),
+     * for the plane's IN_FENCE_FD; -1 without explicit fencing. Still
+     * owned by the surface.
+     */
+    int getPendingFence() const { return pendingFence_; }
+    
+    /**
+     * Whether the render fence goes to the commit instead of a glFinish()
+     * (EGL_ANDROID_native_fence_sync and IN_FENCE_FD on the plane)
+     */
+    bool hasExplicitFencing() const { return explicitFencing_; }
+    
+    /**
+     * OUT_FENCE_PTR property of the CRTC (0 = none)
+     */
+    uint32_t getOutFencePtrProperty() const { return propOutFencePtr_; }
+    
+    /**
+     * Wait for the previous non-blocking commit's out fence (its flip)
+     */
+    void waitForOutFence();
+    
+    /**
+     * Schedule a flip of this CRTC alone (non-blocking atomic commit with a
+     * flip event), resetting the plane to the full framebuffer
+     * Falls back to schedulePageFlip() without atomic or before the modeset.
+     * @return true on success
+     */
+    bool scheduleAtomicPageFlip();
+    
+    /**
+     * Add this CRTC's flip to a shared non-blocking commit with flip events
+     * (prepareAtomicFlip() included; cancelled again on failure)
+     * @return true if the flip is in the request
+     */
+    bool addAtomicPageFlip(drmModeAtomicReq* request);
+    
+    /**
+     * After the commit of addAtomicPageFlip() succeeded: the flip event
+     * releases the previous buffer, as for scheduleAtomicPageFlip()
+     */
+    void atomicPageFlipScheduled();
+    
     /**
      * Get CRTC ID for atomic property
      */
@@ -158,6 +285,12 @@ public:
      */
     bool isModeSet() const { return modeSet_; }
     
+    /**
+     * Redo the CRTC modeset with the next frame (after a mode change at
+     * the same resolution)
+     */
+    void requestModeset() { modeSet_ = false; }
+    
     /**
      * Get the primary plane for this surface (for atomic modesetting)
      * @return Pointer to plane, or nullptr if not available
@@ -234,6 +367,12 @@ public:
      */
     gbm_surface* getGbmSurface() const { return gbmSurface_; }
     
+    /**
+     * True if this surface created the GBM device, EGL display or context
+     * the other surfaces share (it must outlive them)
+     */
+    bool ownsSharedResources() const { return ownGbmDevice_ || ownEglDisplay_ || ownEglContext_; }
+    
 private:
     // Framebuffer info
     struct Framebuffer {
@@ -247,10 +386,34 @@ private:
     // Destroy framebuffer
     void destroyFramebuffer(Framebuffer& fb);
     
-    // Page flip handler callback
+    // Framebuffer of a GBM buffer, created on first use (0 on failure)
+    uint32_t framebufferFor(gbm_bo* bo);
+    void destroyFramebuffers();
+    
+    // Flip a locked buffer (modeset on the first frame); releases it on failure
+    bool flipBuffer(gbm_bo* bo, int64_t readyNs, int64_t tag);
+    
+    // Mailbox
+    void flipQueuedBuffer();
+    void dropQueuedBuffer();
+    void updateQueueDepth();
+    
+    // GBM surface in a layout from the plane's IN_FORMATS (nullptr if none)
+    gbm_surface* createTiledSurface(uint32_t& format);
+    
+    // Explicit fencing
+    void initExplicitFencing();
+    void waitRenderFence();                  // Legacy flips: the CPU waits instead
+    static bool waitFence(int fd, int timeoutMs);
+    static void closeFence(int& fd);
+    
+    // Page flip handler callback (user data: the committing surface; a
+    // group commit's events go to the peer on their CRTC)
     static void pageFlipHandler(int fd, unsigned int frame, 
                                 unsigned int sec, unsigned int usec, 
-                                void* data);
+                                unsigned int crtcId, void* data);
+    static void handleFlipEvents(int fd);
+    void flipCompleted(unsigned int frame, unsigned int sec, unsigned int usec);
     
     // ===== Members =====
     
@@ -269,17 +432,30 @@ private:
     EGLSurface eglSurface_ = EGL_NO_SURFACE;
     EGLConfig eglConfig_ = nullptr;
     
-    // Framebuffers for page flipping
-    Framebuffer currentFb_;
-    Framebuffer nextFb_;
+    // Framebuffers for page flipping, one per GBM buffer (GBM recycles a
+    // fixed set, so a buffer's framebuffer is never removed while shown)
+    std::vector<Framebuffer> framebuffers_;
     gbm_bo* currentBo_ = nullptr;    // Buffer currently being displayed
     gbm_bo* previousBo_ = nullptr;   // Buffer to release after flip completes
     gbm_bo* pendingBo_ = nullptr;    // Buffer pending atomic commit
     
+    // Mailbox: newest finished frame, flipped when the pending flip completes
+    int bufferCount_ = 3;
+    gbm_bo* queuedBo_ = nullptr;
+    int64_t queuedReadyNs_ = 0;      // When the queued frame finished rendering
+    int64_t currentReadyNs_ = 0;     // When the last flipped frame finished rendering
+    
+    // Frame numbers of the buffers, for the presentation frame log
+    int64_t frameTag_ = -1;          // Frame being drawn
+    int64_t queuedTag_ = -1;
+    int64_t currentTag_ = -1;
+    
     // Flip state
     bool flipPending_ = false;
+    std::vector<DRMSurface*> flipPeers_;   // Not owned; same commit as this one
     bool initialized_ = false;
     bool modeSet_ = false;           // True if CRTC mode has been set (initial modeset done)
+    bool swapIntervalPending_ = false;  // Created off-thread, eglSwapInterval not yet set
     
     // Ownership flags (for cleanup)
     bool ownGbmDevice_ = false;      // True if we created the GBM device
@@ -294,6 +470,19 @@ private:
     DRMPlane* plane_ = nullptr;
     uint32_t pendingFbId_ = 0;   // FB ID for pending atomic commit
     
+    bool modifiersAllowed_ = true;     // IN_FORMATS modifiers for the GBM surface
+    
+    // Explicit fencing (sync file descriptors, -1 = none)
+    bool explicitFencingAllowed_ = true;
+    bool explicitFencing_ = false;
+    PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR_ = nullptr;
+    PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR_ = nullptr;
+    PFNEGLDUPNATIVEFENCEFDANDROIDPROC eglDupNativeFenceFDANDROID_ = nullptr;
+    int renderFence_ = -1;       // Last swap's rendering, for the next locked buffer
+    int pendingFence_ = -1;      // pendingBo_'s rendering (IN_FENCE_FD)
+    int outFence_ = -1;          // Flip of the last non-blocking commit (OUT_FENCE_PTR)
+    uint32_t propOutFencePtr_ = 0;
+    
     // Presentation timing (frame pacing like mpv)
     PresentationTiming presentationTiming_;
     
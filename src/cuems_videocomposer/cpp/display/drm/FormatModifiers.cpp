@@ -0,0 +1,105 @@
+/**
+ * FormatModifiers.cpp - IN_FORMATS parsing
+ */
+
+#include "FormatModifiers.h"
+#include <algorithm>
+#include <cstring>
+
+namespace videocomposer {
+
+namespace {
+
+// Kernel UAPI layout (drm_mode.h), repeated so the parser needs no libdrm
+struct BlobHeader {
+    uint32_t version;
+    uint32_t flags;
+    uint32_t countFormats;
+    uint32_t formatsOffset;
+    uint32_t countModifiers;
+    uint32_t modifiersOffset;
+};
+
+struct BlobModifier {
+    uint64_t formats;    // Bit i: formats[offset + i] takes the modifier
+    uint32_t offset;
+    uint32_t pad;
+    uint64_t modifier;
+};
+
+constexpr uint64_t MOD_LINEAR = 0;
+constexpr uint64_t MOD_INVALID = (1ull << 56) - 1;   // DRM_FORMAT_MOD_INVALID
+
+} // namespace
+
+bool FormatModifierTable::parse(const void* data, size_t size) {
+    modifiers_.clear();
+    if (!data || size < sizeof(BlobHeader)) {
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    BlobHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.version != 1 ||
+        header.formatsOffset > size ||
+        header.countFormats > (size - header.formatsOffset) / sizeof(uint32_t) ||
+        header.modifiersOffset > size ||
+        header.countModifiers > (size - header.modifiersOffset) / sizeof(BlobModifier)) {
+        return false;
+    }
+
+    std::vector<uint32_t> formats(header.countFormats);
+    if (!formats.empty()) {
+        memcpy(formats.data(), bytes + header.formatsOffset, formats.size() * sizeof(uint32_t));
+    }
+    for (uint32_t m = 0; m < header.countModifiers; ++m) {
+        BlobModifier entry;
+        memcpy(&entry, bytes + header.modifiersOffset + m * sizeof(BlobModifier), sizeof(entry));
+        if (entry.modifier == MOD_INVALID) {
+            continue;
+        }
+        for (uint32_t bit = 0; bit < 64; ++bit) {
+            uint64_t index = static_cast<uint64_t>(entry.offset) + bit;
+            if ((entry.formats & (1ull << bit)) && index < formats.size()) {
+                modifiers_[formats[index]].push_back(entry.modifier);
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<uint64_t> FormatModifierTable::getModifiers(uint32_t format) const {
+    auto it = modifiers_.find(format);
+    return it != modifiers_.end() ? it->second : std::vector<uint64_t>();
+}
+
+bool FormatModifierTable::supports(uint32_t format, uint64_t modifier) const {
+    if (modifiers_.empty()) {
+        return true;
+    }
+    auto it = modifiers_.find(format);
+    return it != modifiers_.end() &&
+           std::find(it->second.begin(), it->second.end(), modifier) != it->second.end();
+}
+
+std::vector<uint64_t> FormatModifierTable::intersect(const std::vector<uint64_t>& a,
+                                                     const std::vector<uint64_t>& b) {
+    std::vector<uint64_t> result;
+    for (uint64_t modifier : a) {
+        if (std::find(b.begin(), b.end(), modifier) != b.end()) {
+            result.push_back(modifier);
+        }
+    }
+    return result;
+}
+
+bool FormatModifierTable::hasTiled(const std::vector<uint64_t>& modifiers) {
+    for (uint64_t modifier : modifiers) {
+        if (modifier != MOD_LINEAR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,61 @@
+/**
+ * FormatModifiers.h - Format/modifier pairs a DRM plane can scan out
+ *
+ * Parsed from the plane's IN_FORMATS blob. Handing these lists to GBM
+ * (instead of an implicit layout) lets Intel and AMD allocate tiled and
+ * compressed (CCS/DCC) buffers, which cut scanout and composition memory
+ * bandwidth.
+ */
+
+#ifndef VIDEOCOMPOSER_FORMATMODIFIERS_H
+#define VIDEOCOMPOSER_FORMATMODIFIERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * FormatModifierTable - Modifiers per DRM fourcc
+ */
+class FormatModifierTable {
+public:
+    /**
+     * Parse an IN_FORMATS blob (struct drm_format_modifier_blob)
+     * @return false if the blob is malformed (the table is left empty)
+     */
+    bool parse(const void* data, size_t size);
+
+    void clear() { modifiers_.clear(); }
+    bool empty() const { return modifiers_.empty(); }
+
+    /**
+     * Modifiers for a format, in the driver's order (empty if unknown)
+     */
+    std::vector<uint64_t> getModifiers(uint32_t format) const;
+
+    /**
+     * Whether the plane takes the pair; an empty table (no IN_FORMATS)
+     * claims nothing and answers true
+     */
+    bool supports(uint32_t format, uint64_t modifier) const;
+
+    /**
+     * Modifiers in both lists, in the order of the first
+     */
+    static std::vector<uint64_t> intersect(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b);
+
+    /**
+     * Whether a list holds anything but LINEAR (worth an explicit allocation)
+     */
+    static bool hasTiled(const std::vector<uint64_t>& modifiers);
+
+private:
+    std::map<uint32_t, std::vector<uint64_t>> modifiers_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FORMATMODIFIERS_H
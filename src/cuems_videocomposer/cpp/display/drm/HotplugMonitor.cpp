@@ -0,0 +1,163 @@
+/**
+ * HotplugMonitor.cpp - Background connector probing for DRM hotplug
+ */
+
+#include "HotplugMonitor.h"
+#include "../../utils/Logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+namespace videocomposer {
+
+HotplugMonitor::HotplugMonitor() {
+}
+
+HotplugMonitor::~HotplugMonitor() {
+    stop();
+}
+
+void HotplugMonitor::setConnectors(const std::vector<Change>& connectors) {
+    states_.clear();
+    for (const Change& connector : connectors) {
+        states_[connector.connectorId] = connector.connected;
+    }
+}
+
+bool HotplugMonitor::start(Probe probe, int intervalMs) {
+    if (thread_) {
+        return true;
+    }
+    probe_ = std::move(probe);
+    intervalMs_ = intervalMs > 0 ? intervalMs : 1000;
+
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd_ < 0) {
+        LOG_WARNING << "HotplugMonitor: eventfd failed: " << strerror(errno);
+        return false;
+    }
+    ueventFd_ = openUeventSocket();
+    if (ueventFd_ < 0) {
+        LOG_INFO << "HotplugMonitor: No kernel uevents, re-reading connector state every "
+                 << intervalMs_ << " ms";
+    }
+
+    thread_ = std::make_unique<std::thread>(&HotplugMonitor::threadFunc, this);
+    return true;
+}
+
+void HotplugMonitor::stop() {
+    if (thread_) {
+        uint64_t one = 1;
+        if (write(wakeFd_, &one, sizeof(one)) < 0) {
+            LOG_WARNING << "HotplugMonitor: Failed to wake the probe thread";
+        }
+        thread_->join();
+        thread_.reset();
+    }
+    if (ueventFd_ >= 0) {
+        close(ueventFd_);
+        ueventFd_ = -1;
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+        wakeFd_ = -1;
+    }
+}
+
+void HotplugMonitor::probeAll(bool force) {
+    for (auto& [connectorId, connected] : states_) {
+        bool now = connected;
+        if (!probe_ || !probe_(connectorId, force, now) || now == connected) {
+            continue;
+        }
+        connected = now;
+        std::lock_guard<std::mutex> lock(mutex_);
+        changes_.push_back(Change{connectorId, now});
+    }
+}
+
+std::vector<HotplugMonitor::Change> HotplugMonitor::takeChanges() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Change> changes;
+    changes.swap(changes_);
+    return changes;
+}
+
+bool HotplugMonitor::isDrmHotplugEvent(const char* message, size_t length) {
+    if (!message || length < 7 || std::strncmp(message, "change@", 7) != 0) {
+        return false;
+    }
+    bool drm = false;
+    bool hotplug = false;
+    size_t offset = 0;
+    while (offset < length) {
+        const char* field = message + offset;
+        size_t fieldLength = strnlen(field, length - offset);
+        std::string value(field, fieldLength);
+        drm = drm || value == "SUBSYSTEM=drm";
+        hotplug = hotplug || value == "HOTPLUG=1";
+        offset += fieldLength + 1;
+    }
+    return drm && hotplug;
+}
+
+void HotplugMonitor::threadFunc() {
+    struct pollfd fds[2] = {};
+    fds[0].fd = wakeFd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = ueventFd_;
+    fds[1].events = POLLIN;
+    nfds_t count = ueventFd_ >= 0 ? 2 : 1;
+
+    while (true) {
+        int ret = poll(fds, count, intervalMs_);
+        if (ret < 0 && errno != EINTR) {
+            LOG_WARNING << "HotplugMonitor: poll failed: " << strerror(errno);
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            break;
+        }
+        // A hotplug uevent means the kernel saw a change: probe the
+        // hardware; otherwise the cached state is read, which is cheap
+        bool hotplug = count > 1 && (fds[1].revents & POLLIN) && readUevents();
+        probeAll(hotplug);
+    }
+}
+
+int HotplugMonitor::openUeventSocket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;  // Kernel uevents (udev's own rebroadcast is group 2)
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool HotplugMonitor::readUevents() {
+    bool hotplug = false;
+    char buffer[4096];
+    while (true) {
+        ssize_t length = recv(ueventFd_, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+            break;
+        }
+        hotplug = hotplug || isDrmHotplugEvent(buffer, static_cast<size_t>(length));
+    }
+    return hotplug;
+}
+
+} // namespace videocomposer
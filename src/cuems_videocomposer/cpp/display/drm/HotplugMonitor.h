@@ -0,0 +1,93 @@
+/**
+ * HotplugMonitor.h - Background connector probing for DRM hotplug
+ *
+ * A forced connector probe reads the EDID over DDC and holds the kernel's
+ * mode config lock, so probing on the render thread stalls every output.
+ * The monitor probes on its own thread: woken by the kernel's drm hotplug
+ * uevent it forces a probe, otherwise it re-reads the cached connector
+ * state at an interval. The render thread only collects the changes.
+ */
+
+#ifndef VIDEOCOMPOSER_HOTPLUGMONITOR_H
+#define VIDEOCOMPOSER_HOTPLUGMONITOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+class HotplugMonitor {
+public:
+    struct Change {
+        uint32_t connectorId = 0;
+        bool connected = false;
+    };
+
+    /**
+     * Read a connector's connection state (on the monitor thread)
+     * @param force Re-probe the hardware instead of reading the cached state
+     * @return false if the connector could not be read
+     */
+    using Probe = std::function<bool(uint32_t connectorId, bool force, bool& connected)>;
+
+    HotplugMonitor();
+    ~HotplugMonitor();
+
+    /**
+     * Connectors to watch, with their state when the outputs were detected
+     * (call before start())
+     */
+    void setConnectors(const std::vector<Change>& connectors);
+
+    /**
+     * Start the probe thread
+     * @param intervalMs Cached state re-read interval (hotplug uevents wake it early)
+     */
+    bool start(Probe probe, int intervalMs = 1000);
+
+    void stop();
+
+    bool isRunning() const { return thread_ != nullptr; }
+
+    /**
+     * Probe every connector once, queueing the ones whose state changed
+     * (the thread's work; callable directly while it is not running)
+     */
+    void probeAll(bool force);
+
+    /**
+     * Changes since the last call, oldest first
+     */
+    std::vector<Change> takeChanges();
+
+    /**
+     * True for a kernel uevent reporting a drm hotplug ("change@..." with
+     * SUBSYSTEM=drm and HOTPLUG=1; fields are NUL separated)
+     */
+    static bool isDrmHotplugEvent(const char* message, size_t length);
+
+private:
+    void threadFunc();
+    int openUeventSocket();
+    bool readUevents();      // True if a drm hotplug event was read
+
+    Probe probe_;
+    int intervalMs_ = 1000;
+    std::map<uint32_t, bool> states_;    // Probe thread only while running
+    std::vector<Change> changes_;
+
+    std::mutex mutex_;                   // Guards changes_
+    std::unique_ptr<std::thread> thread_;
+    int ueventFd_ = -1;                  // -1 if uevents are unavailable (interval only)
+    int wakeFd_ = -1;                    // eventfd, signalled by stop()
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_HOTPLUGMONITOR_H
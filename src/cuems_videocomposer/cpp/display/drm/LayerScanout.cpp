@@ -0,0 +1,233 @@
+/**
+ * LayerScanout.cpp - Hardware-decoded frames scanned out without compositing
+ */
+
+#include "LayerScanout.h"
+#include "DRMOutputManager.h"
+#include "DRMSurface.h"
+#include "../../utils/Logger.h"
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
+#include <cstring>
+#include <cerrno>
+
+namespace videocomposer {
+
+LayerScanout::LayerScanout(DRMOutputManager* outputManager)
+    : outputManager_(outputManager)
+{
+}
+
+LayerScanout::~LayerScanout() {
+    cleanup();
+}
+
+bool LayerScanout::present(DRMSurface* surface, const DmaBufPlanes& planes, float aspect, bool letterbox,
+                           ColorMatrix matrix, ColorRange range) {
+    DRMPlane* plane = surface ? surface->getPlane() : nullptr;
+    if (!plane || !plane->propertiesLoaded || !planes.isValid()) {
+        return false;
+    }
+    // The decoder picked the layout: the plane must scan it out as it is
+    if (!plane->inFormats.supports(DRM_FORMAT_NV12, planes.modifier)) {
+        LOG_VERBOSE << "LayerScanout: Plane " << plane->planeId << " does not take NV12 modifier 0x"
+                    << std::hex << planes.modifier << std::dec;
+        return false;
+    }
+
+    uint32_t fbId = getFramebuffer(planes);
+    if (fbId == 0) {
+        return false;
+    }
+    if (colorProps_.planeId != plane->planeId) {
+        colorProps_.load(outputManager_->getFd(), plane->planeId);
+    }
+
+    // Destination rectangle, letterboxed like OpenGLRenderer
+    int outW = static_cast<int>(surface->getWidth());
+    int outH = static_cast<int>(surface->getHeight());
+    int dstX = 0, dstY = 0, dstW = outW, dstH = outH;
+    if (letterbox && outW > 0 && outH > 0) {
+        float srcAspect = aspect > 0.0f ? aspect : static_cast<float>(planes.width) / planes.height;
+        float dstAspect = static_cast<float>(outW) / outH;
+        if (dstAspect > srcAspect) {
+            dstW = static_cast<int>(outH * srcAspect + 0.5f);
+            dstX = (outW - dstW) / 2;
+        } else {
+            dstH = static_cast<int>(outW / srcAspect + 0.5f);
+            dstY = (outH - dstH) / 2;
+        }
+    }
+
+    drmModeAtomicReq* request = outputManager_->createAtomicRequest();
+    if (!request) {
+        return false;
+    }
+
+    uint32_t id = plane->planeId;
+    bool success = drmModeAtomicAddProperty(request, id, plane->propFbId, fbId) >= 0 &&
+                   drmModeAtomicAddProperty(request, id, plane->propCrtcId, surface->getCrtcId()) >= 0;
+    if (success) {
+        // Source rectangle in 16.16 fixed point
+        drmModeAtomicAddProperty(request, id, plane->propSrcX, 0);
+        drmModeAtomicAddProperty(request, id, plane->propSrcY, 0);
+        drmModeAtomicAddProperty(request, id, plane->propSrcW, static_cast<uint64_t>(planes.width) << 16);
+        drmModeAtomicAddProperty(request, id, plane->propSrcH, static_cast<uint64_t>(planes.height) << 16);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcX, dstX);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcY, dstY);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcW, dstW);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcH, dstH);
+
+        colorProps_.add(request, matrix, range);
+
+        // Blocking, like the canvas commits: the previous buffer is off screen on return
+        success = outputManager_->commitAtomic(request, DRM_MODE_ATOMIC_ALLOW_MODESET);
+    }
+    drmModeAtomicFree(request);
+
+    if (!success) {
+        return false;
+    }
+
+    if (!onScreen_.isValid()) {
+        LOG_INFO << "LayerScanout: Scanning out " << planes.width << "x" << planes.height
+                 << " NV12 frames on plane " << id;
+    }
+    onScreen_ = planes;
+    if (framebuffers_.size() > MAX_FRAMEBUFFERS) {
+        removeFramebuffers(true);
+    }
+    return true;
+}
+
+void LayerScanout::noteGLFrame() {
+    if (!onScreen_.isValid() && framebuffers_.empty()) {
+        return;
+    }
+    // The GL commit blocked until its buffer replaced the decoder surface
+    onScreen_ = DmaBufPlanes();
+    removeFramebuffers(false);
+}
+
+void LayerScanout::cleanup() {
+    onScreen_ = DmaBufPlanes();
+    removeFramebuffers(false);
+    colorProps_ = ColorProperties();
+}
+
+uint32_t LayerScanout::getFramebuffer(const DmaBufPlanes& planes) {
+    auto it = framebuffers_.find(planes.key);
+    if (it != framebuffers_.end()) {
+        const Framebuffer& fb = it->second;
+        if (fb.fd == planes.fds[0] && fb.width == planes.width && fb.height == planes.height) {
+            return fb.fbId;
+        }
+        // Key reused by another surface (decoder reopened)
+        if (onScreen_.key == planes.key) {
+            return 0;
+        }
+        drmModeRmFB(outputManager_->getFd(), fb.fbId);
+        framebuffers_.erase(it);
+    }
+
+    Framebuffer fb;
+    fb.fbId = createFramebuffer(outputManager_->getFd(), planes);
+    if (fb.fbId == 0) {
+        return 0;
+    }
+    fb.fd = planes.fds[0];
+    fb.width = planes.width;
+    fb.height = planes.height;
+    framebuffers_[planes.key] = fb;
+    return fb.fbId;
+}
+
+uint32_t LayerScanout::createFramebuffer(int drmFd, const DmaBufPlanes& planes) {
+    // Handles are per DRM fd and shared with Mesa's imports of the same
+    // buffers, so they are not closed here
+    uint32_t handles[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 2; ++i) {
+        if (drmPrimeFDToHandle(drmFd, planes.fds[i], &handles[i]) != 0) {
+            LOG_WARNING << "LayerScanout: Cannot import DMA-BUF plane " << i << ": " << strerror(errno);
+            return 0;
+        }
+    }
+
+    uint32_t pitches[4] = {planes.pitches[0], planes.pitches[1], 0, 0};
+    uint32_t offsets[4] = {planes.offsets[0], planes.offsets[1], 0, 0};
+    uint64_t modifiers[4] = {planes.modifier, planes.modifier, 0, 0};
+    bool hasModifier = planes.modifier != DRM_FORMAT_MOD_INVALID && planes.modifier != 0;
+
+    uint32_t fbId = 0;
+    int ret = drmModeAddFB2WithModifiers(drmFd, planes.width, planes.height, DRM_FORMAT_NV12,
+                                         handles, pitches, offsets, modifiers, &fbId,
+                                         hasModifier ? DRM_MODE_FB_MODIFIERS : 0);
+    if (ret != 0 && !hasModifier) {
+        ret = drmModeAddFB2(drmFd, planes.width, planes.height, DRM_FORMAT_NV12,
+                            handles, pitches, offsets, &fbId, 0);
+    }
+    if (ret != 0) {
+        LOG_WARNING << "LayerScanout: Cannot create an NV12 framebuffer: " << strerror(-ret);
+        return 0;
+    }
+    return fbId;
+}
+
+void LayerScanout::ColorProperties::load(int drmFd, uint32_t plane) {
+    *this = ColorProperties();
+    planeId = plane;
+
+    drmModeObjectProperties* props = drmModeObjectGetProperties(drmFd, planeId, DRM_MODE_OBJECT_PLANE);
+    if (!props) {
+        return;
+    }
+    for (uint32_t i = 0; i < props->count_props; ++i) {
+        drmModePropertyRes* prop = drmModeGetProperty(drmFd, props->props[i]);
+        if (!prop) {
+            continue;
+        }
+        bool isEncoding = strcmp(prop->name, "COLOR_ENCODING") == 0;
+        bool isRange = strcmp(prop->name, "COLOR_RANGE") == 0;
+        if (isEncoding || isRange) {
+            (isEncoding ? encoding : range) = prop->prop_id;
+            for (int e = 0; e < prop->count_enums; ++e) {
+                const char* name = prop->enums[e].name;
+                uint64_t value = prop->enums[e].value;
+                if (strcmp(name, "ITU-R BT.601 YCbCr") == 0) bt601 = value;
+                else if (strcmp(name, "ITU-R BT.709 YCbCr") == 0) bt709 = value;
+                else if (strcmp(name, "ITU-R BT.2020 YCbCr") == 0) bt2020 = value;
+                else if (strcmp(name, "YCbCr limited range") == 0) limited = value;
+                else if (strcmp(name, "YCbCr full range") == 0) full = value;
+            }
+        }
+        drmModeFreeProperty(prop);
+    }
+    drmModeFreeObjectProperties(props);
+}
+
+void LayerScanout::ColorProperties::add(drmModeAtomicReq* request, ColorMatrix matrix, ColorRange colorRange) const {
+    if (encoding != 0) {
+        uint64_t value = matrix == ColorMatrix::BT601 ? bt601
+                       : matrix == ColorMatrix::BT2020 ? bt2020
+                       : bt709;
+        drmModeAtomicAddProperty(request, planeId, encoding, value);
+    }
+    if (range != 0) {
+        drmModeAtomicAddProperty(request, planeId, range, colorRange == ColorRange::FULL ? full : limited);
+    }
+}
+
+void LayerScanout::removeFramebuffers(bool keepOnScreen) {
+    for (auto it = framebuffers_.begin(); it != framebuffers_.end();) {
+        if (keepOnScreen && onScreen_.isValid() && it->first == onScreen_.key) {
+            ++it;
+            continue;
+        }
+        drmModeRmFB(outputManager_->getFd(), it->second.fbId);
+        it = framebuffers_.erase(it);
+    }
+}
+
+} // namespace videocomposer
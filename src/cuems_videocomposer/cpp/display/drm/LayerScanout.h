@@ -0,0 +1,108 @@
+/**
+ * LayerScanout.h - Hardware-decoded frames scanned out without compositing
+ *
+ * Part of the Virtual Canvas architecture for cuems-videocomposer.
+ *
+ * When a single VAAPI layer fills the only output untransformed, its NV12
+ * surface is wrapped in a DRM framebuffer and put on the output's plane,
+ * so the frame is never sampled, composited or copied by the GPU.
+ */
+
+#ifndef VIDEOCOMPOSER_LAYERSCANOUT_H
+#define VIDEOCOMPOSER_LAYERSCANOUT_H
+
+#include "../../video/DmaBufPlanes.h"
+#include "../../video/FrameFormat.h"
+#include <xf86drmMode.h>
+#include <cstdint>
+#include <unordered_map>
+
+namespace videocomposer {
+
+class DRMOutputManager;
+class DRMSurface;
+
+/**
+ * LayerScanout - NV12 decoder surfaces on a DRM plane
+ *
+ * Framebuffers are cached per decoder surface, so a steady stream only
+ * issues one atomic commit per frame. The frame on the plane is referenced
+ * until a GL-composited frame replaces it.
+ */
+class LayerScanout {
+public:
+    /**
+     * @param outputManager DRM output manager (not owned)
+     */
+    explicit LayerScanout(DRMOutputManager* outputManager);
+    ~LayerScanout();
+
+    LayerScanout(const LayerScanout&) = delete;
+    LayerScanout& operator=(const LayerScanout&) = delete;
+
+    /**
+     * Show a frame on the surface's plane (blocking commit)
+     * @param aspect Display aspect ratio (0 = width / height)
+     * @param letterbox Keep the aspect ratio (as OpenGLRenderer::setLetterbox)
+     * @return false if the plane cannot show this frame (atomic commits
+     *         are all-or-nothing, so the screen is unchanged)
+     */
+    bool present(DRMSurface* surface, const DmaBufPlanes& planes, float aspect, bool letterbox,
+                 ColorMatrix matrix, ColorRange range);
+
+    /**
+     * A GL-composited frame has been committed over the plane:
+     * release the last frame and its framebuffers
+     */
+    void noteGLFrame();
+
+    // True while a decoder surface is on screen
+    bool isActive() const { return onScreen_.isValid(); }
+
+    /**
+     * Release all framebuffers (the plane must no longer show them)
+     */
+    void cleanup();
+
+    // COLOR_ENCODING / COLOR_RANGE of a plane (0 if the driver has none)
+    struct ColorProperties {
+        uint32_t planeId = 0;
+        uint32_t encoding = 0;
+        uint32_t range = 0;
+        uint64_t bt601 = 0, bt709 = 0, bt2020 = 0;
+        uint64_t limited = 0, full = 0;
+
+        void load(int drmFd, uint32_t plane);
+        // YCbCr -> RGB conversion in the display engine
+        void add(drmModeAtomicReq* request, ColorMatrix matrix, ColorRange colorRange) const;
+    };
+
+    /**
+     * Wrap decoder planes in an NV12 framebuffer (shared with OverlayPlanes)
+     * @return Framebuffer ID, 0 on failure
+     */
+    static uint32_t createFramebuffer(int drmFd, const DmaBufPlanes& planes);
+
+private:
+    struct Framebuffer {
+        uint32_t fbId = 0;
+        int fd = -1;       // Y plane fd it was created from
+        int width = 0;
+        int height = 0;
+    };
+
+    uint32_t getFramebuffer(const DmaBufPlanes& planes);
+    void removeFramebuffers(bool keepOnScreen);
+
+    DRMOutputManager* outputManager_;  // Not owned
+    std::unordered_map<uint64_t, Framebuffer> framebuffers_;
+    ColorProperties colorProps_;
+    DmaBufPlanes onScreen_;             // Holds the decoder surface while scanned out
+
+    // Growable decoder pools are bounded the same way in VaapiInterop
+    static constexpr size_t MAX_FRAMEBUFFERS = 64;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LAYERSCANOUT_H
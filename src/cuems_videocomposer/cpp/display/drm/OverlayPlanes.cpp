@@ -0,0 +1,168 @@
+/**
+ * OverlayPlanes.cpp - Layers on DRM overlay planes, over the scanned-out canvas
+ */
+
+#include "OverlayPlanes.h"
+#include "DRMOutputManager.h"
+#include "../../utils/Logger.h"
+
+#include <xf86drm.h>
+#include <drm_fourcc.h>
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+OverlayPlanes::OverlayPlanes(DRMOutputManager* outputManager)
+    : outputManager_(outputManager)
+{
+}
+
+OverlayPlanes::~OverlayPlanes() {
+    cleanup();
+}
+
+bool OverlayPlanes::addToRequest(drmModeAtomicReq* request) {
+    if (!request) {
+        return false;
+    }
+    for (const Placement& placement : pending_) {
+        const DRMPlane* plane = placement.plane;
+        uint32_t fbId = plane && placement.frame.isValid() ? getFramebuffer(placement.frame) : 0;
+        if (fbId == 0) {
+            return false;
+        }
+        uint32_t id = plane->planeId;
+        if (drmModeAtomicAddProperty(request, id, plane->propFbId, fbId) < 0 ||
+            drmModeAtomicAddProperty(request, id, plane->propCrtcId, placement.crtcId) < 0) {
+            return false;
+        }
+        // Source rectangle in 16.16 fixed point: a clipped layer shows part of its frame
+        auto fixed = [](float pixels) { return static_cast<uint64_t>(std::lround(pixels * 65536.0f)); };
+        drmModeAtomicAddProperty(request, id, plane->propSrcX, fixed(placement.srcX));
+        drmModeAtomicAddProperty(request, id, plane->propSrcY, fixed(placement.srcY));
+        drmModeAtomicAddProperty(request, id, plane->propSrcW, fixed(placement.srcW));
+        drmModeAtomicAddProperty(request, id, plane->propSrcH, fixed(placement.srcH));
+        drmModeAtomicAddProperty(request, id, plane->propCrtcX, placement.dstX);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcY, placement.dstY);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcW, placement.dstW);
+        drmModeAtomicAddProperty(request, id, plane->propCrtcH, placement.dstH);
+        if (plane->propAlpha != 0) {
+            float opacity = std::min(std::max(placement.opacity, 0.0f), 1.0f);
+            drmModeAtomicAddProperty(request, id, plane->propAlpha,
+                                     static_cast<uint64_t>(std::lround(opacity * 65535.0f)));
+        }
+
+        auto props = colorProps_.find(id);
+        if (props == colorProps_.end()) {
+            props = colorProps_.emplace(id, LayerScanout::ColorProperties()).first;
+            props->second.load(outputManager_->getFd(), id);
+        }
+        props->second.add(request, placement.matrix, placement.range);
+    }
+
+    // Planes this commit no longer uses
+    for (const Placement& shown : onScreen_) {
+        bool kept = std::any_of(pending_.begin(), pending_.end(),
+                                [&shown](const Placement& p) { return p.plane == shown.plane; });
+        if (!kept && !disable(request, shown.plane)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OverlayPlanes::noteCommitted() {
+    // Blocking commits: the frames replaced are off screen
+    if (onScreen_.empty() && !pending_.empty()) {
+        LOG_INFO << "OverlayPlanes: " << pending_.size() << " layer(s) on overlay planes";
+    } else if (!onScreen_.empty() && pending_.empty()) {
+        LOG_INFO << "OverlayPlanes: All layers composited again";
+    }
+    onScreen_ = std::move(pending_);
+    pending_.clear();
+    if (framebuffers_.size() > MAX_FRAMEBUFFERS) {
+        trimFramebuffers();
+    }
+}
+
+void OverlayPlanes::release() {
+    pending_.clear();
+    if (onScreen_.empty()) {
+        return;
+    }
+    drmModeAtomicReq* request = outputManager_->createAtomicRequest();
+    bool success = request != nullptr;
+    for (const Placement& shown : onScreen_) {
+        success = success && disable(request, shown.plane);
+    }
+    success = success && outputManager_->commitAtomic(request, DRM_MODE_ATOMIC_ALLOW_MODESET);
+    if (request) {
+        drmModeAtomicFree(request);
+    }
+    if (!success) {
+        LOG_WARNING << "OverlayPlanes: Cannot switch the overlay planes off";
+        return;
+    }
+    noteCommitted();
+}
+
+void OverlayPlanes::cleanup() {
+    pending_.clear();
+    onScreen_.clear();
+    for (const auto& [key, fb] : framebuffers_) {
+        drmModeRmFB(outputManager_->getFd(), fb.fbId);
+    }
+    framebuffers_.clear();
+    colorProps_.clear();
+}
+
+uint32_t OverlayPlanes::getFramebuffer(const DmaBufPlanes& planes) {
+    auto it = framebuffers_.find(planes.key);
+    if (it != framebuffers_.end()) {
+        const Framebuffer& fb = it->second;
+        if (fb.fd == planes.fds[0] && fb.width == planes.width && fb.height == planes.height) {
+            return fb.fbId;
+        }
+        // Key reused by another surface (decoder reopened)
+        if (onScreen(planes.key)) {
+            return 0;
+        }
+        drmModeRmFB(outputManager_->getFd(), fb.fbId);
+        framebuffers_.erase(it);
+    }
+
+    Framebuffer fb;
+    fb.fbId = LayerScanout::createFramebuffer(outputManager_->getFd(), planes);
+    if (fb.fbId == 0) {
+        return 0;
+    }
+    fb.fd = planes.fds[0];
+    fb.width = planes.width;
+    fb.height = planes.height;
+    framebuffers_[planes.key] = fb;
+    return fb.fbId;
+}
+
+bool OverlayPlanes::onScreen(uint64_t key) const {
+    return std::any_of(onScreen_.begin(), onScreen_.end(),
+                       [key](const Placement& p) { return p.frame.key == key; });
+}
+
+void OverlayPlanes::trimFramebuffers() {
+    for (auto it = framebuffers_.begin(); it != framebuffers_.end();) {
+        if (onScreen(it->first)) {
+            ++it;
+            continue;
+        }
+        drmModeRmFB(outputManager_->getFd(), it->second.fbId);
+        it = framebuffers_.erase(it);
+    }
+}
+
+bool OverlayPlanes::disable(drmModeAtomicReq* request, const DRMPlane* plane) {
+    return plane && drmModeAtomicAddProperty(request, plane->planeId, plane->propFbId, 0) >= 0 &&
+           drmModeAtomicAddProperty(request, plane->planeId, plane->propCrtcId, 0) >= 0;
+}
+
+} // namespace videocomposer
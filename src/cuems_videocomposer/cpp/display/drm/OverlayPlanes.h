@@ -0,0 +1,120 @@
+/**
+ * OverlayPlanes.h - Layers on DRM overlay planes, over the scanned-out canvas
+ *
+ * Part of the Virtual Canvas architecture for cuems-videocomposer.
+ *
+ * Picture-in-picture layouts composite small hardware-decoded layers over
+ * the canvas every frame. With direct scanout, each such layer can go on an
+ * overlay plane instead: the display engine scales, places and fades it,
+ * and the GPU composites only the rest (see PlaneAssignment).
+ */
+
+#ifndef VIDEOCOMPOSER_OVERLAYPLANES_H
+#define VIDEOCOMPOSER_OVERLAYPLANES_H
+
+#include "LayerScanout.h"
+#include "../../video/DmaBufPlanes.h"
+#include "../../video/FrameFormat.h"
+#include <xf86drmMode.h>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace videocomposer {
+
+class DRMOutputManager;
+struct DRMPlane;
+
+/**
+ * OverlayPlanes - NV12 decoder surfaces on overlay planes
+ *
+ * The backend sets the placements of the next frame, tests them with a
+ * TEST_ONLY commit, and adds them to the canvas commit: the canvas and its
+ * layers change on the same vblank. Frames on a plane are referenced until
+ * the next commit replaces them; planes no longer used are switched off in
+ * that commit.
+ */
+class OverlayPlanes {
+public:
+    struct Placement {
+        int layerId = 0;
+        const DRMPlane* plane = nullptr;
+        uint32_t crtcId = 0;
+        DmaBufPlanes frame;        // Held while on screen
+        float srcX = 0.0f;         // Frame pixels shown
+        float srcY = 0.0f;
+        float srcW = 0.0f;
+        float srcH = 0.0f;
+        int dstX = 0;              // CRTC pixels covered
+        int dstY = 0;
+        int dstW = 0;
+        int dstH = 0;
+        float opacity = 1.0f;      // Needs the plane's alpha below 1
+        ColorMatrix matrix = ColorMatrix::BT709;
+        ColorRange range = ColorRange::LIMITED;
+    };
+
+    /**
+     * @param outputManager DRM output manager (not owned)
+     */
+    explicit OverlayPlanes(DRMOutputManager* outputManager);
+    ~OverlayPlanes();
+
+    OverlayPlanes(const OverlayPlanes&) = delete;
+    OverlayPlanes& operator=(const OverlayPlanes&) = delete;
+
+    /** Placements of the next commit, bottom to top */
+    void setPending(std::vector<Placement> placements) { pending_ = std::move(placements); }
+    std::vector<Placement>& getPending() { return pending_; }
+
+    /**
+     * Add the pending placements to a commit; planes on screen that are
+     * not pending are switched off in it
+     * @return false if a framebuffer or property could not be added
+     */
+    bool addToRequest(drmModeAtomicReq* request);
+
+    /** The commit with the pending placements succeeded */
+    void noteCommitted();
+
+    // True while a plane shows a layer
+    bool isActive() const { return !onScreen_.empty(); }
+
+    /**
+     * Switch every plane off (blocking commit), e.g. before a commit that
+     * does not carry the overlays
+     */
+    void release();
+
+    /**
+     * Release all framebuffers (the planes must no longer show them)
+     */
+    void cleanup();
+
+private:
+    struct Framebuffer {
+        uint32_t fbId = 0;
+        int fd = -1;       // Y plane fd it was created from
+        int width = 0;
+        int height = 0;
+    };
+
+    uint32_t getFramebuffer(const DmaBufPlanes& planes);
+    bool onScreen(uint64_t key) const;
+    void trimFramebuffers();
+    static bool disable(drmModeAtomicReq* request, const DRMPlane* plane);
+
+    DRMOutputManager* outputManager_;  // Not owned
+    std::vector<Placement> pending_;
+    std::vector<Placement> onScreen_;
+    std::unordered_map<uint64_t, Framebuffer> framebuffers_;
+    std::map<uint32_t, LayerScanout::ColorProperties> colorProps_;   // By plane
+
+    // A few decoder pools of surfaces (see LayerScanout)
+    static constexpr size_t MAX_FRAMEBUFFERS = 128;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_OVERLAYPLANES_H
@@ -0,0 +1,38 @@
+/**
+ * PlaneAssignment.cpp - Layers the display engine shows on overlay planes
+ */
+
+#include "PlaneAssignment.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+bool PlaneAssignment::overlaps(const PlaneCandidate& a, const PlaneCandidate& b) {
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+std::vector<size_t> PlaneAssignment::choose(const std::vector<PlaneCandidate>& layers,
+                                            const std::vector<int>& planesPerOutput) {
+    std::vector<size_t> chosen;
+    std::vector<int> used(planesPerOutput.size(), 0);
+    std::vector<const PlaneCandidate*> composited;   // Above the layer looked at
+    for (size_t i = layers.size(); i > 0; --i) {
+        const PlaneCandidate& layer = layers[i - 1];
+        bool free = layer.eligible && layer.output >= 0 &&
+                    static_cast<size_t>(layer.output) < planesPerOutput.size() &&
+                    used[layer.output] < planesPerOutput[layer.output];
+        for (size_t c = 0; free && c < composited.size(); ++c) {
+            free = !overlaps(layer, *composited[c]);
+        }
+        if (free) {
+            chosen.push_back(i - 1);
+            used[layer.output]++;
+        } else {
+            composited.push_back(&layer);
+        }
+    }
+    std::reverse(chosen.begin(), chosen.end());
+    return chosen;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,53 @@
+/**
+ * PlaneAssignment.h - Layers the display engine shows on overlay planes
+ *
+ * Overlay planes are stacked above the plane scanning out the canvas, so
+ * a layer can leave the composite only when nothing composited above it
+ * covers any of it. Such a layer is scaled, placed and faded by its plane
+ * instead of being sampled and blended by the GPU.
+ */
+
+#ifndef VIDEOCOMPOSER_PLANEASSIGNMENT_H
+#define VIDEOCOMPOSER_PLANEASSIGNMENT_H
+
+#include <cstddef>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * PlaneCandidate - A visible layer, as the plane pass sees it
+ */
+struct PlaneCandidate {
+    bool eligible = false;   // A plane can show it as GL draws it (see DRMBackend)
+    int output = -1;         // The one output it is on (-1 = none, or several)
+    float x0 = 0.0f;         // Bounds in canvas pixels
+    float y0 = 0.0f;
+    float x1 = 0.0f;
+    float y1 = 0.0f;
+};
+
+/**
+ * PlaneAssignment - Which layers go on planes
+ */
+class PlaneAssignment {
+public:
+    /**
+     * Choose layers for the overlay planes, from the top down: a layer
+     * goes on a plane if it is eligible, its output has a plane left and
+     * it does not overlap a composited layer above it. Everything else is
+     * composited (and hides what is under it from the pass).
+     * @param layers Bottom to top
+     * @param planesPerOutput Overlay planes free on each output
+     * @return Indices into layers, bottom to top (the plane order)
+     */
+    static std::vector<size_t> choose(const std::vector<PlaneCandidate>& layers,
+                                      const std::vector<int>& planesPerOutput);
+
+    /** Whether two candidates' bounds share any area */
+    static bool overlaps(const PlaneCandidate& a, const PlaneCandidate& b);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PLANEASSIGNMENT_H
@@ -3,7 +3,9 @@
  */
 
 #include "PresentationTiming.h"
+#include "../../utils/FlightRecorder.h"
 #include "../../utils/Logger.h"
+#include <cstdio>
 #include <ctime>
 
 namespace videocomposer {
@@ -58,7 +60,11 @@ void PresentationTiming::recordFlip(unsigned int sec, unsigned int usec, unsigne
     current_.valid = true;
     
     // Calculate vsync duration and skipped frames if we have a previous entry
-    if (previous_.valid && previous_.ust > 0 && current_.ust > previous_.ust) {
+    if (gapExpected_) {
+        gapExpected_ = false;
+        current_.vsync_duration = previous_.vsync_duration > 0 ? previous_.vsync_duration : expectedVsyncNs_;
+        current_.skipped_vsyncs = 0;
+    } else if (previous_.valid && previous_.ust > 0 && current_.ust > previous_.ust) {
         int64_t ust_delta = current_.ust - previous_.ust;
         int64_t msc_delta = current_.msc - previous_.msc;
         
@@ -83,6 +89,10 @@ void PresentationTiming::recordFlip(unsigned int sec, unsigned int usec, unsigne
                 // Allow 1 vsync tolerance for timing jitter
                 if (unexpectedSkips > 1) {
                     totalUnexpectedDrops_ += unexpectedSkips;
+                    char detail[64];
+                    std::snprintf(detail, sizeof(detail), "%lld vblank(s) beyond expected",
+                                  static_cast<long long>(unexpectedSkips));
+                    FlightRecorder::instance().trigger(FlightRecorder::Trigger::MISSED_VBLANK, detail);
                     // Only log actual problems, not expected timing
                     if (totalUnexpectedDrops_ <= 5 || totalUnexpectedDrops_ % 60 == 0) {
                         LOG_WARNING << "PresentationTiming: Dropped " << unexpectedSkips 
@@ -112,11 +122,90 @@ PresentationEntry PresentationTiming::getInfo() const {
     return current_;
 }
 
+int64_t PresentationTiming::predictNextVsync(int64_t afterNs) const {
+    int64_t duration = current_.vsync_duration > 0 ? current_.vsync_duration : expectedVsyncNs_;
+    if (!current_.valid || current_.ust <= 0 || duration <= 0) {
+        return 0;
+    }
+    if (afterNs < current_.ust) {
+        return current_.ust;
+    }
+    // Whole vsyncs since the last flip, plus the one still to come
+    int64_t vsyncs = (afterNs - current_.ust) / duration + 1;
+    return current_.ust + vsyncs * duration;
+}
+
+int64_t PresentationTiming::getTimeToNextVsync() const {
+    int64_t now = getCurrentTimeNs();
+    int64_t next = predictNextVsync(now);
+    return next > 0 ? next - now : 0;
+}
+
+int64_t PresentationTiming::getNextVsyncCounter() const {
+    int64_t duration = current_.vsync_duration > 0 ? current_.vsync_duration : expectedVsyncNs_;
+    int64_t next = predictNextVsync(getCurrentTimeNs());
+    if (next <= 0 || duration <= 0) {
+        return -1;
+    }
+    return current_.msc + (next - current_.ust + duration / 2) / duration;
+}
+
+void PresentationTiming::recordQueueDepth(int depth) {
+    bufferStats_.queueDepth = depth;
+    if (depth > bufferStats_.maxQueueDepth) {
+        bufferStats_.maxQueueDepth = depth;
+    }
+}
+
+void PresentationTiming::recordBufferPresented(int64_t readyNs) {
+    bufferStats_.presented++;
+    if (readyNs <= 0 || !current_.valid || current_.ust < readyNs) {
+        return;
+    }
+    int64_t age = current_.ust - readyNs;
+    bufferStats_.lastBufferAgeNs = age;
+    bufferStats_.totalBufferAgeNs += age;
+    if (age > bufferStats_.maxBufferAgeNs) {
+        bufferStats_.maxBufferAgeNs = age;
+    }
+}
+
+void PresentationTiming::setFrameLogEnabled(bool enabled) {
+    frameLogEnabled_ = enabled;
+    if (!enabled) {
+        frameLog_.clear();
+    }
+}
+
+void PresentationTiming::recordPresentedFrame(int64_t tag) {
+    if (!frameLogEnabled_ || !current_.valid) {
+        return;
+    }
+    if (frameLog_.size() >= FRAME_LOG_LIMIT) {
+        frameLog_.pop_front();
+    }
+    PresentedFrame frame;
+    frame.flipNs = current_.ust;
+    frame.msc = current_.msc;
+    frame.tag = tag;
+    frameLog_.push_back(frame);
+}
+
+void PresentationTiming::takePresentedFrames(std::vector<PresentedFrame>& out) {
+    out.insert(out.end(), frameLog_.begin(), frameLog_.end());
+    frameLog_.clear();
+}
+
 void PresentationTiming::reset() {
     current_ = PresentationEntry();
     previous_ = PresentationEntry();
     totalDroppedFrames_ = 0;
     totalUnexpectedDrops_ = 0;
+    // The depth is the surface's current state, not a statistic
+    int depth = bufferStats_.queueDepth;
+    bufferStats_ = BufferQueueStats();
+    bufferStats_.queueDepth = depth;
+    bufferStats_.maxQueueDepth = depth;
     // Keep expectedVsyncNs_, displayHz_, videoFps_, expectedVsyncsPerFrame_, initialized_ - they're set by init()/setVideoFramerate()
 }
 
@@ -10,8 +10,11 @@
 #ifndef VIDEOCOMPOSER_PRESENTATIONTIMING_H
 #define VIDEOCOMPOSER_PRESENTATIONTIMING_H
 
+#include "../SyncLatencyMonitor.h"
 #include <cstdint>
 #include <chrono>
+#include <deque>
+#include <vector>
 
 namespace videocomposer {
 
@@ -27,6 +30,20 @@ struct PresentationEntry {
     bool valid = false;
 };
 
+/**
+ * Swapchain statistics: how many buffers are held and how old frames are
+ * when they reach the screen
+ */
+struct BufferQueueStats {
+    int queueDepth = 0;             // Buffers held now (displayed, pending, queued)
+    int maxQueueDepth = 0;
+    int64_t presented = 0;          // Frames that reached the screen
+    int64_t replaced = 0;           // Queued frames replaced by a newer one unseen
+    int64_t lastBufferAgeNs = 0;    // Render completion to scanout, last frame
+    int64_t maxBufferAgeNs = 0;
+    int64_t totalBufferAgeNs = 0;   // Mean age = totalBufferAgeNs / presented
+};
+
 /**
  * Tracks presentation timing for smooth frame pacing
  * 
@@ -70,6 +87,12 @@ public:
      */
     void recordFlip(unsigned int sec, unsigned int usec, unsigned int msc);
     
+    /**
+     * Flips were held on purpose (idle loop): the vsyncs until the next
+     * flip are not dropped frames
+     */
+    void skipGap() { gapExpected_ = true; }
+    
     /**
      * Get current presentation timing info
      */
@@ -101,6 +124,79 @@ public:
      */
     bool isRunningBehind() const { return current_.skipped_vsyncs > 0; }
     
+    /**
+     * Predict the first vsync strictly after a point in time, extrapolated
+     * from the last flip timestamp
+     * @param afterNs Monotonic time in nanoseconds
+     * @return Monotonic vsync time in nanoseconds, or 0 before the first flip
+     */
+    int64_t predictNextVsync(int64_t afterNs) const;
+    
+    /**
+     * Time from now until the next predicted vsync
+     * @return Nanoseconds, or 0 before the first flip
+     */
+    int64_t getTimeToNextVsync() const;
+    
+    /**
+     * Vsync counter (msc) of the next vsync from now, extrapolated like
+     * predictNextVsync
+     * @return Counter value, or -1 before the first flip
+     */
+    int64_t getNextVsyncCounter() const;
+    
+    /**
+     * Refresh rate given to init()
+     */
+    double getRefreshRate() const { return displayHz_; }
+    
+    // ===== Swapchain statistics =====
+    
+    /**
+     * Record the number of buffers the surface holds
+     */
+    void recordQueueDepth(int depth);
+    
+    /**
+     * Record that the frame just flipped (see recordFlip) finished rendering
+     * at readyNs; its age is measured to the flip timestamp
+     * @param readyNs Monotonic time in nanoseconds, or 0 if unknown
+     */
+    void recordBufferPresented(int64_t readyNs);
+    
+    /**
+     * Record a queued frame replaced by a newer one before it was shown
+     */
+    void recordBufferReplaced() { bufferStats_.replaced++; }
+    
+    BufferQueueStats getBufferStats() const { return bufferStats_; }
+    
+    // ===== Frame log (sync test) =====
+    
+    static constexpr size_t FRAME_LOG_LIMIT = 1024;  // Oldest flips dropped beyond this
+    
+    /**
+     * Keep a log of flipped frames for takePresentedFrames()
+     */
+    void setFrameLogEnabled(bool enabled);
+    bool isFrameLogEnabled() const { return frameLogEnabled_; }
+    
+    /**
+     * Log the frame just flipped (see recordFlip)
+     * @param tag Frame number the buffer shows (-1 = unknown)
+     */
+    void recordPresentedFrame(int64_t tag);
+    
+    /**
+     * Move the logged flips, oldest first, to the end of out
+     */
+    void takePresentedFrames(std::vector<PresentedFrame>& out);
+    
+    /**
+     * Current monotonic time in nanoseconds (the clock of flip timestamps)
+     */
+    static int64_t getCurrentTimeNs();
+    
     /**
      * Reset statistics
      */
@@ -117,12 +213,13 @@ private:
     double videoFps_ = 0.0;            // Expected video framerate (0 = match display)
     int expectedVsyncsPerFrame_ = 1;   // Expected vsyncs between flips (display_hz / video_fps)
     bool initialized_ = false;
+    bool gapExpected_ = false;         // skipGap(): next flip starts a new baseline
+    BufferQueueStats bufferStats_;
+    bool frameLogEnabled_ = false;
+    std::deque<PresentedFrame> frameLog_;
     
     // Convert DRM timestamp to nanoseconds
     static int64_t toNanoseconds(unsigned int sec, unsigned int usec);
-    
-    // Get current monotonic time in nanoseconds
-    static int64_t getCurrentTimeNs();
 };
 
 } // namespace videocomposer
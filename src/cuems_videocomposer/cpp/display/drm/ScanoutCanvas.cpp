@@ -0,0 +1,233 @@
+/**
+ * ScanoutCanvas.cpp - Scanout-capable buffers for the Virtual Canvas
+ */
+
+#include "ScanoutCanvas.h"
+#include "DRMOutputManager.h"
+#include "../../utils/Logger.h"
+
+#include <GL/gl.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+namespace videocomposer {
+
+ScanoutCanvas::ScanoutCanvas(DRMOutputManager* outputManager)
+    : outputManager_(outputManager)
+{
+}
+
+ScanoutCanvas::~ScanoutCanvas() {
+    cleanup();
+}
+
+bool ScanoutCanvas::init(gbm_device* gbmDevice, EGLDisplay eglDisplay, int width, int height,
+                         PFNEGLCREATEIMAGEKHRPROC createImage, PFNEGLDESTROYIMAGEKHRPROC destroyImage,
+                         PFNGLEGLIMAGETARGETTEXTURE2DOESPROC imageTargetTexture,
+                         const std::vector<uint64_t>& modifiers) {
+    cleanup();
+
+    if (!gbmDevice || eglDisplay == EGL_NO_DISPLAY || !outputManager_ ||
+        !createImage || !destroyImage || !imageTargetTexture || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    gbmDevice_ = gbmDevice;
+    eglDisplay_ = eglDisplay;
+    eglCreateImageKHR_ = createImage;
+    eglDestroyImageKHR_ = destroyImage;
+    glEGLImageTargetTexture2DOES_ = imageTargetTexture;
+    width_ = width;
+    height_ = height;
+
+    // A layout every plane takes first, the implicit one if that fails
+    std::vector<std::vector<uint64_t>> attempts;
+    if (FormatModifierTable::hasTiled(modifiers)) {
+        attempts.push_back(modifiers);
+    }
+    attempts.emplace_back();
+    for (const std::vector<uint64_t>& attempt : attempts) {
+        buffers_.resize(BUFFER_COUNT);
+        bool created = true;
+        for (Buffer& buffer : buffers_) {
+            created = created && createBuffer(buffer, attempt);
+        }
+        if (created) {
+            LOG_INFO << "ScanoutCanvas: " << BUFFER_COUNT << " scanout buffers of " << width_ << "x" << height_
+                     << " (modifier 0x" << std::hex << gbm_bo_get_modifier(buffers_[0].bo) << std::dec << ")";
+            return true;
+        }
+        for (Buffer& buffer : buffers_) {
+            destroyBuffer(buffer);
+        }
+        buffers_.clear();
+    }
+    cleanup();
+    return false;
+}
+
+void ScanoutCanvas::cleanup() {
+    for (Buffer& buffer : buffers_) {
+        destroyBuffer(buffer);
+    }
+    buffers_.clear();
+    width_ = 0;
+    height_ = 0;
+}
+
+std::vector<VirtualCanvas::RenderTarget> ScanoutCanvas::getRenderTargets() const {
+    std::vector<VirtualCanvas::RenderTarget> targets;
+    targets.reserve(buffers_.size());
+    for (const Buffer& buffer : buffers_) {
+        VirtualCanvas::RenderTarget target;
+        target.fbo = buffer.fbo;
+        target.texture = buffer.texture;
+        targets.push_back(target);
+    }
+    return targets;
+}
+
+uint32_t ScanoutCanvas::getFbId(int index) const {
+    if (index < 0 || index >= static_cast<int>(buffers_.size())) {
+        return 0;
+    }
+    return buffers_[index].fbId;
+}
+
+bool ScanoutCanvas::createBuffer(Buffer& buffer, const std::vector<uint64_t>& layout) {
+    const uint32_t format = GBM_FORMAT_XRGB8888;
+    if (layout.empty()) {
+        buffer.bo = gbm_bo_create(gbmDevice_, width_, height_, format,
+                                  GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING);
+    } else {
+        // Scanout and rendering implied; GBM picks from the list
+        buffer.bo = gbm_bo_create_with_modifiers(gbmDevice_, width_, height_, format,
+                                                 layout.data(), static_cast<unsigned int>(layout.size()));
+    }
+    if (!buffer.bo) {
+        LOG_WARNING << "ScanoutCanvas: gbm_bo_create failed for " << width_ << "x" << height_
+                    << (layout.empty() ? "" : " with modifiers");
+        return false;
+    }
+
+    uint64_t modifier = gbm_bo_get_modifier(buffer.bo);
+    bool hasModifier = modifier != DRM_FORMAT_MOD_INVALID && modifier != 0;
+
+    // DRM framebuffer, as in DRMSurface::createFramebuffer; compressed
+    // layouts carry their metadata in further planes of the same buffer
+    int planeCount = hasModifier ? std::max(1, std::min(gbm_bo_get_plane_count(buffer.bo), 4)) : 1;
+    uint32_t handles[4] = {0, 0, 0, 0};
+    uint32_t strides[4] = {0, 0, 0, 0};
+    uint32_t offsets[4] = {0, 0, 0, 0};
+    uint64_t modifiers[4] = {0, 0, 0, 0};
+    for (int i = 0; i < planeCount; ++i) {
+        handles[i] = gbm_bo_get_handle_for_plane(buffer.bo, i).u32;
+        strides[i] = gbm_bo_get_stride_for_plane(buffer.bo, i);
+        offsets[i] = gbm_bo_get_offset(buffer.bo, i);
+        modifiers[i] = modifier;
+    }
+    if (handles[0] == 0) {
+        handles[0] = gbm_bo_get_handle(buffer.bo).u32;
+        strides[0] = gbm_bo_get_stride(buffer.bo);
+    }
+    int ret = drmModeAddFB2WithModifiers(outputManager_->getFd(), width_, height_, format,
+                                         handles, strides, offsets, modifiers, &buffer.fbId,
+                                         hasModifier ? DRM_MODE_FB_MODIFIERS : 0);
+    if (ret != 0 && planeCount == 1) {
+        ret = drmModeAddFB2(outputManager_->getFd(), width_, height_, format,
+                            handles, strides, offsets, &buffer.fbId, 0);
+    }
+    if (ret != 0) {
+        LOG_WARNING << "ScanoutCanvas: Cannot create a " << width_ << "x" << height_
+                    << " framebuffer: " << strerror(-ret);
+        buffer.fbId = 0;
+        return false;
+    }
+
+    // Import into GL through a dma-buf
+    int fd = gbm_bo_get_fd(buffer.bo);
+    if (fd < 0) {
+        LOG_WARNING << "ScanoutCanvas: gbm_bo_get_fd failed";
+        return false;
+    }
+    std::vector<EGLint> attribs = {
+        EGL_WIDTH, width_,
+        EGL_HEIGHT, height_,
+        EGL_LINUX_DRM_FOURCC_EXT, static_cast<EGLint>(format),
+    };
+    static const EGLint planeAttribs[4][5] = {
+        {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+         EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+        {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+         EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+        {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+         EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+        {EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+         EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT},
+    };
+    for (int i = 0; i < planeCount; ++i) {
+        const EGLint* names = planeAttribs[i];
+        attribs.insert(attribs.end(), {names[0], fd,
+                                       names[1], static_cast<EGLint>(offsets[i]),
+                                       names[2], static_cast<EGLint>(strides[i])});
+        if (hasModifier) {
+            attribs.insert(attribs.end(), {names[3], static_cast<EGLint>(modifier & 0xffffffff),
+                                           names[4], static_cast<EGLint>(modifier >> 32)});
+        }
+    }
+    attribs.push_back(EGL_NONE);
+    buffer.image = eglCreateImageKHR_(eglDisplay_, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+                                      nullptr, attribs.data());
+    close(fd);  // The image holds its own reference
+    if (buffer.image == EGL_NO_IMAGE_KHR) {
+        LOG_WARNING << "ScanoutCanvas: eglCreateImageKHR failed (0x" << std::hex << eglGetError() << std::dec << ")";
+        return false;
+    }
+
+    glGenTextures(1, &buffer.texture);
+    glBindTexture(GL_TEXTURE_2D, buffer.texture);
+    glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, buffer.image);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &buffer.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, buffer.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, buffer.texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_WARNING << "ScanoutCanvas: Scanout buffer is not renderable (0x" << std::hex << status << std::dec << ")";
+        return false;
+    }
+    return true;
+}
+
+void ScanoutCanvas::destroyBuffer(Buffer& buffer) {
+    if (buffer.fbo != 0) {
+        glDeleteFramebuffers(1, &buffer.fbo);
+        buffer.fbo = 0;
+    }
+    if (buffer.texture != 0) {
+        glDeleteTextures(1, &buffer.texture);
+        buffer.texture = 0;
+    }
+    if (buffer.image != EGL_NO_IMAGE_KHR && eglDestroyImageKHR_) {
+        eglDestroyImageKHR_(eglDisplay_, buffer.image);
+        buffer.image = EGL_NO_IMAGE_KHR;
+    }
+    if (buffer.fbId != 0 && outputManager_) {
+        drmModeRmFB(outputManager_->getFd(), buffer.fbId);
+        buffer.fbId = 0;
+    }
+    if (buffer.bo) {
+        gbm_bo_destroy(buffer.bo);
+        buffer.bo = nullptr;
+    }
+}
+
+} // namespace videocomposer
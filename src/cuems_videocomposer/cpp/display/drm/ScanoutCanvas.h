@@ -0,0 +1,107 @@
+/**
+ * ScanoutCanvas.h - Scanout-capable buffers for the Virtual Canvas
+ *
+ * Part of the Virtual Canvas architecture for cuems-videocomposer.
+ *
+ * Canvas-sized GBM buffers that are both GL render targets (EGLImage
+ * texture + FBO) and DRM framebuffers. When no output needs edge blending,
+ * warping or scaling, the canvas is composited straight into one of these
+ * and every CRTC's primary plane scans out its region through SRC_X/Y/W/H,
+ * so no per-output copy is made.
+ */
+
+#ifndef VIDEOCOMPOSER_SCANOUTCANVAS_H
+#define VIDEOCOMPOSER_SCANOUTCANVAS_H
+
+#include "../DisplayBackend.h"   // EGL image function pointer types
+#include "../VirtualCanvas.h"
+#include <GL/glew.h>
+#include <gbm.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <vector>
+#include <cstdint>
+
+namespace videocomposer {
+
+class DRMOutputManager;
+
+/**
+ * ScanoutCanvas - Double-buffered canvas in scanout memory
+ *
+ * Buffers are stored top-down (memory row 0 is the top scanline), so the
+ * canvas must be rendered with OpenGLRenderer::setFlipY(true).
+ * Must be created and destroyed with the canvas GL context current.
+ */
+class ScanoutCanvas {
+public:
+    // The atomic commit blocks until the flip, so two buffers suffice
+    static constexpr int BUFFER_COUNT = 2;
+
+    /**
+     * @param outputManager DRM output manager (not owned)
+     */
+    explicit ScanoutCanvas(DRMOutputManager* outputManager);
+    ~ScanoutCanvas();
+
+    ScanoutCanvas(const ScanoutCanvas&) = delete;
+    ScanoutCanvas& operator=(const ScanoutCanvas&) = delete;
+
+    /**
+     * Allocate the buffers
+     * @param modifiers XRGB8888 modifiers every plane scans out (tiled or
+     *        compressed buffers; empty or on failure: implicit layout)
+     * @return false if the driver cannot render to or scan out such a
+     *         buffer (e.g. canvas wider than the CRTC limit)
+     */
+    bool init(gbm_device* gbmDevice, EGLDisplay eglDisplay, int width, int height,
+              PFNEGLCREATEIMAGEKHRPROC createImage, PFNEGLDESTROYIMAGEKHRPROC destroyImage,
+              PFNGLEGLIMAGETARGETTEXTURE2DOESPROC imageTargetTexture,
+              const std::vector<uint64_t>& modifiers = {});
+
+    /**
+     * Release all buffers
+     */
+    void cleanup();
+
+    bool isInitialized() const { return !buffers_.empty(); }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+    /**
+     * Render targets for VirtualCanvas::setExternalTargets (same order as buffers)
+     */
+    std::vector<VirtualCanvas::RenderTarget> getRenderTargets() const;
+
+    /**
+     * DRM framebuffer of a buffer (0 if out of range)
+     */
+    uint32_t getFbId(int index) const;
+
+private:
+    struct Buffer {
+        gbm_bo* bo = nullptr;
+        EGLImageKHR image = EGL_NO_IMAGE_KHR;
+        GLuint texture = 0;
+        GLuint fbo = 0;
+        uint32_t fbId = 0;
+    };
+
+    bool createBuffer(Buffer& buffer, const std::vector<uint64_t>& modifiers);
+    void destroyBuffer(Buffer& buffer);
+
+    DRMOutputManager* outputManager_;  // Not owned
+    gbm_device* gbmDevice_ = nullptr;
+    EGLDisplay eglDisplay_ = EGL_NO_DISPLAY;
+    PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR_ = nullptr;
+    PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR_ = nullptr;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES_ = nullptr;
+
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<Buffer> buffers_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SCANOUTCANVAS_H
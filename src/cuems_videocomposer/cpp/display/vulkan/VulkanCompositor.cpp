@@ -0,0 +1,459 @@
+#include "VulkanCompositor.h"
+#include "VulkanContext.h"
+#include "../../utils/Logger.h"
+
+namespace videocomposer {
+
+namespace {
+
+// SPIR-V of shaders/VulkanLayer.{vert,frag}, compiled by glslc at build time
+const uint32_t kLayerVert[] = {
+#include "VulkanLayer.vert.spv.inc"
+};
+const uint32_t kLayerFrag[] = {
+#include "VulkanLayer.frag.spv.inc"
+};
+
+constexpr VkFormat CANVAS_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+// Push constants of both shaders (std430, 128 bytes, the guaranteed minimum)
+struct LayerConstants {
+    float box[4];
+    float canvasSize[2];
+    float sourceSize[2];
+    float mapX[4];
+    float mapY[4];
+    float yuv[12];
+    float opacity;
+    int32_t isYuv;
+    float texelSize[2];
+};
+static_assert(sizeof(LayerConstants) == 128, "LayerConstants must match the shaders' push constants");
+
+VkShaderModule createModule(VkDevice device, const uint32_t* code, size_t size) {
+    VkShaderModuleCreateInfo info{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    info.codeSize = size;
+    info.pCode = code;
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device, &info, nullptr, &module) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return module;
+}
+
+} // namespace
+
+VulkanCompositor::VulkanCompositor(VulkanContext& context)
+    : context_(context) {
+}
+
+VulkanCompositor::~VulkanCompositor() {
+    cleanup();
+}
+
+bool VulkanCompositor::init(int frameSlots) {
+    VkDevice device = context_.getDevice();
+
+    VkSamplerCreateInfo samplerInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler_) != VK_SUCCESS) {
+        sampler_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    for (uint32_t i = 0; i < 2; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    setInfo.bindingCount = 2;
+    setInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &setLayout_) != VK_SUCCESS) {
+        setLayout_ = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_LAYERS * 2};
+    VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.maxSets = MAX_LAYERS;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    pools_.assign(static_cast<size_t>(frameSlots), VK_NULL_HANDLE);
+    for (VkDescriptorPool& pool : pools_) {
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+            pool = VK_NULL_HANDLE;
+            cleanup();
+            return false;
+        }
+    }
+
+    if (!createPipeline()) {
+        cleanup();
+        return false;
+    }
+    return true;
+}
+
+bool VulkanCompositor::createPipeline() {
+    VkDevice device = context_.getDevice();
+
+    VkPushConstantRange range{VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(LayerConstants)};
+    VkPipelineLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout_;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &range;
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS) {
+        pipelineLayout_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkShaderModule vert = createModule(device, kLayerVert, sizeof(kLayerVert));
+    VkShaderModule frag = createModule(device, kLayerFrag, sizeof(kLayerFrag));
+    VkPipelineShaderStageCreateInfo stages[2] = {{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO},
+                                                 {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO}};
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vert;
+    stages[0].pName = "main";
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = frag;
+    stages[1].pName = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInput{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    VkPipelineInputAssemblyStateCreateInfo assembly{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    VkPipelineViewportStateCreateInfo viewport{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+    VkPipelineRasterizationStateCreateInfo raster{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    raster.polygonMode = VK_POLYGON_MODE_FILL;
+    raster.cullMode = VK_CULL_MODE_NONE;
+    raster.lineWidth = 1.0f;
+    VkPipelineMultisampleStateCreateInfo multisample{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Straight alpha over an opaque canvas, as the renderer's normal blend
+    VkPipelineColorBlendAttachmentState attachment{};
+    attachment.blendEnable = VK_TRUE;
+    attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo blend{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    blend.attachmentCount = 1;
+    blend.pAttachments = &attachment;
+
+    VkDynamicState dynamicStates[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamicStates;
+
+    VkPipelineRenderingCreateInfo rendering{VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
+    rendering.colorAttachmentCount = 1;
+    rendering.pColorAttachmentFormats = &CANVAS_FORMAT;
+
+    VkGraphicsPipelineCreateInfo info{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    info.pNext = &rendering;
+    info.stageCount = 2;
+    info.pStages = stages;
+    info.pVertexInputState = &vertexInput;
+    info.pInputAssemblyState = &assembly;
+    info.pViewportState = &viewport;
+    info.pRasterizationState = &raster;
+    info.pMultisampleState = &multisample;
+    info.pColorBlendState = &blend;
+    info.pDynamicState = &dynamic;
+    info.layout = pipelineLayout_;
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    if (vert != VK_NULL_HANDLE && frag != VK_NULL_HANDLE) {
+        result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline_);
+    }
+    if (vert != VK_NULL_HANDLE) {
+        vkDestroyShaderModule(device, vert, nullptr);
+    }
+    if (frag != VK_NULL_HANDLE) {
+        vkDestroyShaderModule(device, frag, nullptr);
+    }
+    if (result != VK_SUCCESS) {
+        LOG_ERROR << "VulkanCompositor: Failed to create layer pipeline: " << VulkanContext::resultName(result);
+        pipeline_ = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+void VulkanCompositor::cleanup() {
+    VkDevice device = context_.getDevice();
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+    destroyCanvas();
+    if (pipeline_ != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, pipeline_, nullptr);
+        pipeline_ = VK_NULL_HANDLE;
+    }
+    if (pipelineLayout_ != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout_, nullptr);
+        pipelineLayout_ = VK_NULL_HANDLE;
+    }
+    for (VkDescriptorPool pool : pools_) {
+        if (pool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+    }
+    pools_.clear();
+    if (setLayout_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, setLayout_, nullptr);
+        setLayout_ = VK_NULL_HANDLE;
+    }
+    if (sampler_ != VK_NULL_HANDLE) {
+        vkDestroySampler(device, sampler_, nullptr);
+        sampler_ = VK_NULL_HANDLE;
+    }
+}
+
+bool VulkanCompositor::configure(int width, int height, const std::vector<CanvasRect>& visible) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    regions_.set(visible, width, height);
+    if (canvas_ != VK_NULL_HANDLE && width == width_ && height == height_) {
+        return true;
+    }
+    destroyCanvas();
+
+    VkDevice device = context_.getDevice();
+    VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = CANVAS_FORMAT;
+    imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device, &imageInfo, nullptr, &canvas_) != VK_SUCCESS) {
+        canvas_ = VK_NULL_HANDLE;
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, canvas_, &requirements);
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = context_.findMemoryType(requirements.memoryTypeBits,
+                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(device, &allocInfo, nullptr, &canvasMemory_) != VK_SUCCESS) {
+        LOG_ERROR << "VulkanCompositor: No device memory for a " << width << "x" << height << " canvas";
+        canvasMemory_ = VK_NULL_HANDLE;
+        destroyCanvas();
+        return false;
+    }
+    vkBindImageMemory(device, canvas_, canvasMemory_, 0);
+
+    VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    viewInfo.image = canvas_;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = CANVAS_FORMAT;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    if (vkCreateImageView(device, &viewInfo, nullptr, &canvasView_) != VK_SUCCESS) {
+        canvasView_ = VK_NULL_HANDLE;
+        destroyCanvas();
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    LOG_INFO << "VulkanCompositor: Canvas " << width << "x" << height;
+    return true;
+}
+
+void VulkanCompositor::destroyCanvas() {
+    VkDevice device = context_.getDevice();
+    if (canvasView_ != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, canvasView_, nullptr);
+        canvasView_ = VK_NULL_HANDLE;
+    }
+    if (canvas_ != VK_NULL_HANDLE) {
+        vkDestroyImage(device, canvas_, nullptr);
+        canvas_ = VK_NULL_HANDLE;
+    }
+    if (canvasMemory_ != VK_NULL_HANDLE) {
+        vkFreeMemory(device, canvasMemory_, nullptr);
+        canvasMemory_ = VK_NULL_HANDLE;
+    }
+    width_ = 0;
+    height_ = 0;
+}
+
+void VulkanCompositor::record(VkCommandBuffer cmd, int slot, const std::vector<Draw>& draws) {
+    if (canvas_ == VK_NULL_HANDLE || slot < 0 || slot >= static_cast<int>(pools_.size())) {
+        return;
+    }
+    VkDevice device = context_.getDevice();
+    vkResetDescriptorPool(device, pools_[slot], 0);
+
+    // Cleared whole: only the last frame's blits must be done reading it
+    VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = canvas_;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    VkDependencyInfo dependency{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.imageMemoryBarrierCount = 1;
+    dependency.pImageMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    VkRenderingAttachmentInfo attachment{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    attachment.imageView = canvasView_;
+    attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.clearValue.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    VkRenderingInfo rendering{VK_STRUCTURE_TYPE_RENDERING_INFO};
+    rendering.renderArea = {{0, 0}, {static_cast<uint32_t>(width_), static_cast<uint32_t>(height_)}};
+    rendering.layerCount = 1;
+    rendering.colorAttachmentCount = 1;
+    rendering.pColorAttachments = &attachment;
+    vkCmdBeginRendering(cmd, &rendering);
+
+    VkViewport viewport{0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_), 0.0f, 1.0f};
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &rendering.renderArea);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_);
+
+    for (const Draw& draw : draws) {
+        const SoftwareCompositor::Placement& placement = draw.placement;
+        // Regions count y up
+        if (!regions_.intersects(static_cast<float>(placement.x0), static_cast<float>(height_ - placement.y1),
+                                 static_cast<float>(placement.x1), static_cast<float>(height_ - placement.y0))) {
+            continue;
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        allocInfo.descriptorPool = pools_[slot];
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &setLayout_;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS) {
+            LOG_WARNING << "VulkanCompositor: More than " << MAX_LAYERS << " layers, the rest not drawn";
+            break;
+        }
+        VkDescriptorImageInfo images[2] = {};
+        VkWriteDescriptorSet writes[2] = {{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET},
+                                          {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}};
+        for (uint32_t i = 0; i < 2; ++i) {
+            images[i].sampler = sampler_;
+            images[i].imageView = draw.views[i] != VK_NULL_HANDLE ? draw.views[i] : draw.views[0];
+            images[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            writes[i].dstSet = set;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[i].pImageInfo = &images[i];
+        }
+        vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &set, 0, nullptr);
+
+        const CPUImageKernels::AffineMap& map = placement.map;
+        LayerConstants constants = {};
+        constants.box[0] = static_cast<float>(placement.x0);
+        constants.box[1] = static_cast<float>(placement.y0);
+        constants.box[2] = static_cast<float>(placement.x1);
+        constants.box[3] = static_cast<float>(placement.y1);
+        constants.canvasSize[0] = static_cast<float>(width_);
+        constants.canvasSize[1] = static_cast<float>(height_);
+        constants.sourceSize[0] = static_cast<float>(draw.sourceWidth);
+        constants.sourceSize[1] = static_cast<float>(draw.sourceHeight);
+        constants.mapX[0] = static_cast<float>(map.x0);
+        constants.mapX[1] = static_cast<float>(map.dxx);
+        constants.mapX[2] = static_cast<float>(map.dxy);
+        constants.mapY[0] = static_cast<float>(map.y0);
+        constants.mapY[1] = static_cast<float>(map.dyx);
+        constants.mapY[2] = static_cast<float>(map.dyy);
+        for (int i = 0; i < 12; ++i) {
+            constants.yuv[i] = draw.yuvRows[i];
+        }
+        constants.opacity = draw.opacity;
+        constants.isYuv = draw.yuv ? 1 : 0;
+        constants.texelSize[0] = 1.0f / static_cast<float>(draw.imageWidth);
+        constants.texelSize[1] = 1.0f / static_cast<float>(draw.imageHeight);
+        vkCmdPushConstants(cmd, pipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                           sizeof(constants), &constants);
+        vkCmdDraw(cmd, 4, 1, 0, 0);
+    }
+    vkCmdEndRendering(cmd);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+void VulkanCompositor::yuvRows(const FrameInfo& info, bool highDepth, float rows[12]) {
+    // As OpenGLRenderer::setYuvUniforms: Kr, Kb per ITU-R BT.601 / BT.709 / BT.2020
+    float kr = 0.2126f, kb = 0.0722f;
+    if (info.colorMatrix == ColorMatrix::BT601) {
+        kr = 0.299f;
+        kb = 0.114f;
+    } else if (info.colorMatrix == ColorMatrix::BT2020) {
+        kr = 0.2627f;
+        kb = 0.0593f;
+    }
+    float kg = 1.0f - kr - kb;
+
+    int shift = highDepth ? 2 : 0;
+    float maxCode = highDepth ? 1023.0f : 255.0f;
+    float chromaMid = static_cast<float>(128 << shift) / maxCode;
+    float black = 0.0f;
+    float lumaScale = 1.0f;
+    float chromaScale = 1.0f;
+    if (info.colorRange == ColorRange::LIMITED) {
+        black = static_cast<float>(16 << shift) / maxCode;
+        lumaScale = maxCode / static_cast<float>(219 << shift);
+        chromaScale = maxCode / static_cast<float>(224 << shift);
+    }
+    // P010 puts the 10 bits in the high bits of the word (x << 6)
+    float scale = highDepth ? 65535.0f / (1023.0f * 64.0f) : 1.0f;
+
+    // Row-major, columns multiply Y, U (Cb) and V (Cr)
+    const float matrix[3][3] = {
+        {lumaScale, 0.0f, 2.0f * (1.0f - kr) * chromaScale},
+        {lumaScale, -2.0f * kb * (1.0f - kb) / kg * chromaScale, -2.0f * kr * (1.0f - kr) / kg * chromaScale},
+        {lumaScale, 2.0f * (1.0f - kb) * chromaScale, 0.0f}
+    };
+    const float offset[3] = {black, chromaMid, chromaMid};
+    for (int row = 0; row < 3; ++row) {
+        float constant = 0.0f;
+        for (int column = 0; column < 3; ++column) {
+            rows[row * 4 + column] = matrix[row][column] * scale;
+            constant -= matrix[row][column] * offset[column];
+        }
+        rows[row * 4 + 3] = constant;
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,100 @@
+#ifndef VIDEOCOMPOSER_VULKANCOMPOSITOR_H
+#define VIDEOCOMPOSER_VULKANCOMPOSITOR_H
+
+#include "../CanvasRegions.h"
+#include "../SoftwareCompositor.h"
+#include "../../video/FrameFormat.h"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace videocomposer {
+
+class VulkanContext;
+
+/**
+ * VulkanCompositor - The layers drawn into the canvas image
+ *
+ * The Vulkan counterpart of VirtualCanvas: one image spanning the
+ * output regions, cleared to black and drawn bottom layer first. Layers
+ * are placed exactly as SoftwareCompositor places them (its canvas ->
+ * source map is evaluated per fragment, so rotation and scale match)
+ * and blended normally with their opacity. RGBA images are sampled as
+ * they are; NV12/P010 planes are converted with the renderer's YUV
+ * matrix (matrix, range and bit depth of the frame).
+ *
+ * The canvas is y down (pixel rows as the swapchain's); CanvasRegions,
+ * y up as OutputRegion, cull layers no output shows. After record() the
+ * canvas is in TRANSFER_SRC_OPTIMAL for the outputs' blits.
+ */
+class VulkanCompositor {
+public:
+    static constexpr uint32_t MAX_LAYERS = 64;   // Per frame
+
+    struct Draw {
+        VkImageView views[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};   // RGBA, or Y and UV
+        bool yuv = false;
+        float yuvRows[12] = {};                 // See yuvRows()
+        int sourceWidth = 0;
+        int sourceHeight = 0;
+        int imageWidth = 0;                     // Sampled image (decoder surfaces may be padded)
+        int imageHeight = 0;
+        SoftwareCompositor::Placement placement;
+        float opacity = 1.0f;
+    };
+
+    explicit VulkanCompositor(VulkanContext& context);
+    ~VulkanCompositor();
+
+    VulkanCompositor(const VulkanCompositor&) = delete;
+    VulkanCompositor& operator=(const VulkanCompositor&) = delete;
+
+    /**
+     * @param frameSlots Frames in flight (one descriptor pool each)
+     */
+    bool init(int frameSlots);
+    void cleanup();
+
+    /**
+     * (Re)create the canvas; the GPU must be idle
+     */
+    bool configure(int width, int height, const std::vector<CanvasRect>& visible);
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    VkImage getCanvas() const { return canvas_; }
+
+    /**
+     * Record the composite of a frame slot (its previous frame completed)
+     */
+    void record(VkCommandBuffer cmd, int slot, const std::vector<Draw>& draws);
+
+    /**
+     * The renderer's YUV -> RGB conversion as three rows: rgb[i] =
+     * dot(rows[4i..4i+2], yuv) + rows[4i+3], yuv the sampled values
+     * @param highDepth 16-bit planes with 10-bit samples in the high bits (P010)
+     */
+    static void yuvRows(const FrameInfo& info, bool highDepth, float rows[12]);
+
+private:
+    bool createPipeline();
+    void destroyCanvas();
+
+    VulkanContext& context_;
+    VkSampler sampler_ = VK_NULL_HANDLE;
+    VkDescriptorSetLayout setLayout_ = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+    VkPipeline pipeline_ = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> pools_;
+
+    VkImage canvas_ = VK_NULL_HANDLE;
+    VkDeviceMemory canvasMemory_ = VK_NULL_HANDLE;
+    VkImageView canvasView_ = VK_NULL_HANDLE;
+    int width_ = 0;
+    int height_ = 0;
+    CanvasRegions regions_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VULKANCOMPOSITOR_H
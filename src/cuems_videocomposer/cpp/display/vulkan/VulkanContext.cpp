@@ -0,0 +1,343 @@
+#include "VulkanContext.h"
+#include "../../utils/Logger.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+namespace {
+
+bool hasExtension(const std::vector<VkExtensionProperties>& extensions, const char* name) {
+    for (const VkExtensionProperties& extension : extensions) {
+        if (std::strcmp(extension.extensionName, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<VkExtensionProperties> deviceExtensions(VkPhysicalDevice device) {
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> extensions(count);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &count, extensions.data());
+    return extensions;
+}
+
+} // namespace
+
+VulkanContext::VulkanContext() {
+}
+
+VulkanContext::~VulkanContext() {
+    cleanup();
+}
+
+bool VulkanContext::init() {
+    if (device_ != VK_NULL_HANDLE) {
+        return true;
+    }
+    if (!createInstance() || !pickPhysicalDevice() || !createDevice()) {
+        cleanup();
+        return false;
+    }
+    return true;
+}
+
+void VulkanContext::cleanup() {
+    if (device_ != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(device_);
+        vkDestroyDevice(device_, nullptr);
+        device_ = VK_NULL_HANDLE;
+    }
+    if (instance_ != VK_NULL_HANDLE) {
+        vkDestroyInstance(instance_, nullptr);
+        instance_ = VK_NULL_HANDLE;
+    }
+    physicalDevice_ = VK_NULL_HANDLE;
+    graphicsQueue_ = VK_NULL_HANDLE;
+    transferQueue_ = VK_NULL_HANDLE;
+    getMemoryFdProperties_ = nullptr;
+    importSemaphoreFd_ = nullptr;
+    dmaBufImport_ = false;
+    syncFdImport_ = false;
+}
+
+bool VulkanContext::createInstance() {
+    uint32_t version = 0;
+    if (vkEnumerateInstanceVersion(&version) != VK_SUCCESS || version < VK_API_VERSION_1_3) {
+        LOG_ERROR << "VulkanContext: Vulkan 1.3 loader required";
+        return false;
+    }
+
+    uint32_t count = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> available(count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+    if (!hasExtension(available, VK_KHR_SURFACE_EXTENSION_NAME) ||
+        !hasExtension(available, VK_KHR_DISPLAY_EXTENSION_NAME)) {
+        LOG_ERROR << "VulkanContext: " << VK_KHR_DISPLAY_EXTENSION_NAME << " not available";
+        return false;
+    }
+    const char* extensions[] = {VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_DISPLAY_EXTENSION_NAME};
+
+    VkApplicationInfo app{VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    app.pApplicationName = "cuems-videocomposer";
+    app.pEngineName = "cuems-videocomposer";
+    app.apiVersion = VK_API_VERSION_1_3;
+
+    VkInstanceCreateInfo info{VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    info.pApplicationInfo = &app;
+    info.enabledExtensionCount = 2;
+    info.ppEnabledExtensionNames = extensions;
+    VkResult result = vkCreateInstance(&info, nullptr, &instance_);
+    if (result != VK_SUCCESS) {
+        LOG_ERROR << "VulkanContext: vkCreateInstance failed: " << resultName(result);
+        return false;
+    }
+    return true;
+}
+
+bool VulkanContext::pickPhysicalDevice() {
+    uint32_t count = 0;
+    vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+    std::vector<VkPhysicalDevice> devices(count);
+    vkEnumeratePhysicalDevices(instance_, &count, devices.data());
+
+    // Vulkan 1.3 with the features used, a graphics queue and swapchains;
+    // a device with a display connected first
+    VkPhysicalDevice fallback = VK_NULL_HANDLE;
+    for (VkPhysicalDevice device : devices) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (properties.apiVersion < VK_API_VERSION_1_3 ||
+            !hasExtension(deviceExtensions(device), VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
+            continue;
+        }
+
+        VkPhysicalDeviceVulkan13Features features13{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+        VkPhysicalDeviceVulkan12Features features12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+        features12.pNext = &features13;
+        VkPhysicalDeviceFeatures2 features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        features.pNext = &features12;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+        if (!features12.timelineSemaphore || !features13.synchronization2 || !features13.dynamicRendering) {
+            continue;
+        }
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+        bool graphics = false;
+        for (const VkQueueFamilyProperties& family : families) {
+            graphics = graphics || (family.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+        }
+        if (!graphics) {
+            continue;
+        }
+
+        uint32_t displays = 0;
+        vkGetPhysicalDeviceDisplayPropertiesKHR(device, &displays, nullptr);
+        LOG_INFO << "VulkanContext: " << properties.deviceName << ", " << displays << " display(s)";
+        if (displays > 0) {
+            physicalDevice_ = device;
+            break;
+        }
+        if (fallback == VK_NULL_HANDLE) {
+            fallback = device;
+        }
+    }
+    if (physicalDevice_ == VK_NULL_HANDLE) {
+        physicalDevice_ = fallback;
+    }
+    if (physicalDevice_ == VK_NULL_HANDLE) {
+        LOG_ERROR << "VulkanContext: No Vulkan 1.3 device with timeline semaphores, "
+                  << "synchronization2 and dynamic rendering";
+        return false;
+    }
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+    return true;
+}
+
+bool VulkanContext::createDevice() {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &familyCount, families.data());
+
+    // Graphics family; for uploads a transfer-only family (the copy
+    // engine), else any other family with transfers, else graphics
+    graphicsFamily_ = UINT32_MAX;
+    transferFamily_ = UINT32_MAX;
+    for (uint32_t i = 0; i < familyCount; ++i) {
+        if (graphicsFamily_ == UINT32_MAX && (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            graphicsFamily_ = i;
+        }
+    }
+    for (uint32_t i = 0; i < familyCount && transferFamily_ == UINT32_MAX; ++i) {
+        VkQueueFlags flags = families[i].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            transferFamily_ = i;
+        }
+    }
+    for (uint32_t i = 0; i < familyCount && transferFamily_ == UINT32_MAX; ++i) {
+        if (i != graphicsFamily_ && (families[i].queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            transferFamily_ = i;
+        }
+    }
+    if (transferFamily_ == UINT32_MAX) {
+        transferFamily_ = graphicsFamily_;
+    }
+
+    // Optional extensions: DMA-BUF import and sync file import
+    std::vector<VkExtensionProperties> available = deviceExtensions(physicalDevice_);
+    std::vector<const char*> extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    dmaBufImport_ = hasExtension(available, VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME) &&
+                    hasExtension(available, VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME) &&
+                    hasExtension(available, VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME);
+    if (dmaBufImport_) {
+        extensions.push_back(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME);
+        if (hasExtension(available, VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME)) {
+            extensions.push_back(VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME);
+            foreignFamily_ = VK_QUEUE_FAMILY_FOREIGN_EXT;
+        }
+    }
+    syncFdImport_ = hasExtension(available, VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+    if (syncFdImport_) {
+        extensions.push_back(VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+    }
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queues[2] = {{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO},
+                                         {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO}};
+    queues[0].queueFamilyIndex = graphicsFamily_;
+    queues[0].queueCount = 1;
+    queues[0].pQueuePriorities = &priority;
+    queues[1].queueFamilyIndex = transferFamily_;
+    queues[1].queueCount = 1;
+    queues[1].pQueuePriorities = &priority;
+
+    VkPhysicalDeviceVulkan13Features features13{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+    features13.synchronization2 = VK_TRUE;
+    features13.dynamicRendering = VK_TRUE;
+    VkPhysicalDeviceVulkan12Features features12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    features12.pNext = &features13;
+    features12.timelineSemaphore = VK_TRUE;
+    VkPhysicalDeviceFeatures2 features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+    features.pNext = &features12;
+
+    VkDeviceCreateInfo info{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    info.pNext = &features;
+    info.queueCreateInfoCount = transferFamily_ != graphicsFamily_ ? 2 : 1;
+    info.pQueueCreateInfos = queues;
+    info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    info.ppEnabledExtensionNames = extensions.data();
+    VkResult result = vkCreateDevice(physicalDevice_, &info, nullptr, &device_);
+    if (result != VK_SUCCESS) {
+        LOG_ERROR << "VulkanContext: vkCreateDevice failed: " << resultName(result);
+        device_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    vkGetDeviceQueue(device_, graphicsFamily_, 0, &graphicsQueue_);
+    vkGetDeviceQueue(device_, transferFamily_, 0, &transferQueue_);
+    if (dmaBufImport_) {
+        getMemoryFdProperties_ = reinterpret_cast<PFN_vkGetMemoryFdPropertiesKHR>(
+            vkGetDeviceProcAddr(device_, "vkGetMemoryFdPropertiesKHR"));
+        dmaBufImport_ = getMemoryFdProperties_ != nullptr;
+    }
+    if (syncFdImport_) {
+        importSemaphoreFd_ = reinterpret_cast<PFN_vkImportSemaphoreFdKHR>(
+            vkGetDeviceProcAddr(device_, "vkImportSemaphoreFdKHR"));
+        syncFdImport_ = importSemaphoreFd_ != nullptr;
+    }
+
+    LOG_INFO << "VulkanContext: Graphics queue family " << graphicsFamily_ << ", transfer queue family "
+             << transferFamily_ << (transferFamily_ != graphicsFamily_ ? " (dedicated)" : " (shared)")
+             << ", DMA-BUF import " << (dmaBufImport_ ? "on" : "off")
+             << ", decode fences " << (syncFdImport_ ? "GPU wait" : "CPU wait");
+    return true;
+}
+
+uint32_t VulkanContext::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) &&
+            (memoryProperties_.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+VkSemaphore VulkanContext::createTimeline(uint64_t initialValue) const {
+    VkSemaphoreTypeCreateInfo type{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    type.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type.initialValue = initialValue;
+    VkSemaphoreCreateInfo info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    info.pNext = &type;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(device_, &info, nullptr, &semaphore) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return semaphore;
+}
+
+VkSemaphore VulkanContext::createSemaphore() const {
+    VkSemaphoreCreateInfo info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(device_, &info, nullptr, &semaphore) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return semaphore;
+}
+
+bool VulkanContext::waitTimeline(VkSemaphore timeline, uint64_t value, uint64_t timeoutNs) const {
+    if (value == 0) {
+        return true;
+    }
+    VkSemaphoreWaitInfo wait{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    wait.semaphoreCount = 1;
+    wait.pSemaphores = &timeline;
+    wait.pValues = &value;
+    VkResult result = vkWaitSemaphores(device_, &wait, timeoutNs);
+    if (result != VK_SUCCESS) {
+        LOG_WARNING << "VulkanContext: Timeline wait for " << value << ": " << resultName(result);
+        return false;
+    }
+    return true;
+}
+
+uint64_t VulkanContext::getTimelineValue(VkSemaphore timeline) const {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device_, timeline, &value);
+    return value;
+}
+
+const char* VulkanContext::resultName(VkResult result) {
+    switch (result) {
+        case VK_SUCCESS: return "VK_SUCCESS";
+        case VK_NOT_READY: return "VK_NOT_READY";
+        case VK_TIMEOUT: return "VK_TIMEOUT";
+        case VK_SUBOPTIMAL_KHR: return "VK_SUBOPTIMAL_KHR";
+        case VK_ERROR_OUT_OF_HOST_MEMORY: return "VK_ERROR_OUT_OF_HOST_MEMORY";
+        case VK_ERROR_OUT_OF_DEVICE_MEMORY: return "VK_ERROR_OUT_OF_DEVICE_MEMORY";
+        case VK_ERROR_INITIALIZATION_FAILED: return "VK_ERROR_INITIALIZATION_FAILED";
+        case VK_ERROR_DEVICE_LOST: return "VK_ERROR_DEVICE_LOST";
+        case VK_ERROR_EXTENSION_NOT_PRESENT: return "VK_ERROR_EXTENSION_NOT_PRESENT";
+        case VK_ERROR_FEATURE_NOT_PRESENT: return "VK_ERROR_FEATURE_NOT_PRESENT";
+        case VK_ERROR_INCOMPATIBLE_DRIVER: return "VK_ERROR_INCOMPATIBLE_DRIVER";
+        case VK_ERROR_FORMAT_NOT_SUPPORTED: return "VK_ERROR_FORMAT_NOT_SUPPORTED";
+        case VK_ERROR_INVALID_EXTERNAL_HANDLE: return "VK_ERROR_INVALID_EXTERNAL_HANDLE";
+        case VK_ERROR_SURFACE_LOST_KHR: return "VK_ERROR_SURFACE_LOST_KHR";
+        case VK_ERROR_OUT_OF_DATE_KHR: return "VK_ERROR_OUT_OF_DATE_KHR";
+        case VK_ERROR_NATIVE_WINDOW_IN_USE_KHR: return "VK_ERROR_NATIVE_WINDOW_IN_USE_KHR";
+        default: return "VK_ERROR";
+    }
+}
+
+} // namespace videocomposer
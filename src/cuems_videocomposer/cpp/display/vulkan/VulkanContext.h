@@ -0,0 +1,104 @@
+#ifndef VIDEOCOMPOSER_VULKANCONTEXT_H
+#define VIDEOCOMPOSER_VULKANCONTEXT_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * VulkanContext - Instance, device and queues of the Vulkan display
+ *
+ * One physical device with Vulkan 1.3 (timeline semaphores,
+ * synchronization2, dynamic rendering) that drives displays directly
+ * through VK_KHR_display, preferring one with a display connected.
+ *
+ * Two queues: the graphics queue composites and presents; uploads go
+ * to a transfer queue, from a transfer-only family (the copy engine)
+ * when the device has one, so they overlap the composite. DMA-BUF
+ * import (external memory fd, DRM format modifiers) and sync file
+ * import are optional: without them hardware-decoded frames take the
+ * CPU path and decode fences are waited for on the CPU.
+ */
+class VulkanContext {
+public:
+    VulkanContext();
+    ~VulkanContext();
+
+    VulkanContext(const VulkanContext&) = delete;
+    VulkanContext& operator=(const VulkanContext&) = delete;
+
+    bool init();
+    void cleanup();
+    bool isInitialized() const { return device_ != VK_NULL_HANDLE; }
+
+    VkInstance getInstance() const { return instance_; }
+    VkPhysicalDevice getPhysicalDevice() const { return physicalDevice_; }
+    VkDevice getDevice() const { return device_; }
+
+    VkQueue getGraphicsQueue() const { return graphicsQueue_; }
+    uint32_t getGraphicsFamily() const { return graphicsFamily_; }
+    VkQueue getTransferQueue() const { return transferQueue_; }
+    uint32_t getTransferFamily() const { return transferFamily_; }
+
+    /** DMA-BUF images can be imported (VK_EXT_external_memory_dma_buf + modifiers) */
+    bool supportsDmaBufImport() const { return dmaBufImport_; }
+
+    /** Sync files can be imported into semaphores (VK_KHR_external_semaphore_fd) */
+    bool supportsSyncFdImport() const { return syncFdImport_; }
+
+    /** Queue family images shared with other drivers are acquired from */
+    uint32_t getForeignFamily() const { return foreignFamily_; }
+
+    PFN_vkGetMemoryFdPropertiesKHR getMemoryFdProperties() const { return getMemoryFdProperties_; }
+    PFN_vkImportSemaphoreFdKHR importSemaphoreFd() const { return importSemaphoreFd_; }
+
+    /**
+     * Memory type allowed by typeBits with these properties
+     * @return UINT32_MAX if there is none
+     */
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+    /** Timeline semaphore at initialValue (VK_NULL_HANDLE on failure) */
+    VkSemaphore createTimeline(uint64_t initialValue = 0) const;
+
+    /** Binary semaphore (VK_NULL_HANDLE on failure) */
+    VkSemaphore createSemaphore() const;
+
+    /**
+     * Block until a timeline semaphore reaches value
+     * @return false on timeout or device loss
+     */
+    bool waitTimeline(VkSemaphore timeline, uint64_t value, uint64_t timeoutNs = UINT64_MAX) const;
+
+    /** Value a timeline semaphore has reached */
+    uint64_t getTimelineValue(VkSemaphore timeline) const;
+
+    static const char* resultName(VkResult result);
+
+private:
+    bool createInstance();
+    bool pickPhysicalDevice();
+    bool createDevice();
+
+    VkInstance instance_ = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties_ = {};
+
+    VkQueue graphicsQueue_ = VK_NULL_HANDLE;
+    VkQueue transferQueue_ = VK_NULL_HANDLE;
+    uint32_t graphicsFamily_ = 0;
+    uint32_t transferFamily_ = 0;
+
+    bool dmaBufImport_ = false;
+    bool syncFdImport_ = false;
+    uint32_t foreignFamily_ = VK_QUEUE_FAMILY_EXTERNAL;
+
+    PFN_vkGetMemoryFdPropertiesKHR getMemoryFdProperties_ = nullptr;
+    PFN_vkImportSemaphoreFdKHR importSemaphoreFd_ = nullptr;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VULKANCONTEXT_H
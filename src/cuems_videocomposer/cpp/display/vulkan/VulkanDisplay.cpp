@@ -0,0 +1,500 @@
+/**
+ * VulkanDisplay.cpp - Vulkan display backend implementation
+ */
+
+#include "VulkanDisplay.h"
+#include "../CanvasRegions.h"
+#include "../../layer/LayerManager.h"
+#include "../../layer/VideoLayer.h"
+#include "../../video/GPUTextureFrameBuffer.h"
+#include "../../utils/Logger.h"
+
+#include <algorithm>
+
+namespace videocomposer {
+
+VulkanDisplay::VulkanDisplay()
+    : uploader_(context_)
+    , importer_(context_)
+    , compositor_(context_) {
+}
+
+VulkanDisplay::~VulkanDisplay() {
+    closeWindow();
+}
+
+bool VulkanDisplay::openWindow() {
+    if (initialized_) {
+        LOG_WARNING << "VulkanDisplay: Already initialized";
+        return true;
+    }
+    if (!context_.init()) {
+        return false;
+    }
+
+    // Every connected display, side by side on the canvas
+    VkPhysicalDevice physicalDevice = context_.getPhysicalDevice();
+    uint32_t count = 0;
+    vkGetPhysicalDeviceDisplayPropertiesKHR(physicalDevice, &count, nullptr);
+    std::vector<VkDisplayPropertiesKHR> displays(count);
+    vkGetPhysicalDeviceDisplayPropertiesKHR(physicalDevice, &count, displays.data());
+    std::vector<uint32_t> usedPlanes;
+    int canvasX = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        auto output = std::make_unique<VulkanOutput>(context_, displays[i].display, displays[i],
+                                                     static_cast<int>(outputs_.size()));
+        if (!output->init(resolutionMode_, usedPlanes)) {
+            continue;
+        }
+        OutputRegion region;
+        region.name = output->getName();
+        region.canvasX = canvasX;
+        region.canvasWidth = output->getWidth();
+        region.canvasHeight = output->getHeight();
+        region.physicalWidth = output->getWidth();
+        region.physicalHeight = output->getHeight();
+        canvasX += region.canvasWidth;
+        regions_.push_back(region);
+        outputs_.push_back(std::move(output));
+    }
+    if (outputs_.empty()) {
+        LOG_ERROR << "VulkanDisplay: No display could be driven (is another process holding them?)";
+        closeWindow();
+        return false;
+    }
+
+    if (!createFrames() || !uploader_.init(frameTimeline_) || !compositor_.init(FRAMES_IN_FLIGHT) ||
+        !configureCanvas()) {
+        LOG_ERROR << "VulkanDisplay: Failed to set up the composite";
+        closeWindow();
+        return false;
+    }
+    dmaBufImport_ = importer_.init();
+
+    initialized_ = true;
+    LOG_INFO << "VulkanDisplay: " << outputs_.size() << " output(s), canvas " << compositor_.getWidth() << "x"
+             << compositor_.getHeight() << ", hardware frames "
+             << (importsDmaBuf() ? "imported as DMA-BUF" : "copied through the CPU");
+    return true;
+}
+
+void VulkanDisplay::closeWindow() {
+    if (context_.getDevice() != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(context_.getDevice());
+    }
+    for (FrameSlot& frame : frames_) {
+        frame.owners.clear();
+    }
+    importer_.cleanup();
+    uploader_.cleanup();
+    compositor_.cleanup();
+    destroyFrames();
+    outputs_.clear();
+    regions_.clear();
+    context_.cleanup();
+    warnedLayers_.clear();
+    dmaBufImport_ = false;
+    initialized_ = false;
+}
+
+bool VulkanDisplay::createFrames() {
+    VkDevice device = context_.getDevice();
+    VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = context_.getGraphicsFamily();
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
+        commandPool_ = VK_NULL_HANDLE;
+        return false;
+    }
+    frameTimeline_ = context_.createTimeline(0);
+    if (frameTimeline_ == VK_NULL_HANDLE) {
+        return false;
+    }
+    frameValue_ = 0;
+    frameIndex_ = 0;
+
+    for (FrameSlot& frame : frames_) {
+        VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocInfo.commandPool = commandPool_;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &frame.cmd) != VK_SUCCESS) {
+            frame.cmd = VK_NULL_HANDLE;
+            return false;
+        }
+        frame.value = 0;
+        for (size_t i = 0; i < outputs_.size(); ++i) {
+            VkSemaphore semaphore = context_.createSemaphore();
+            if (semaphore == VK_NULL_HANDLE) {
+                return false;
+            }
+            frame.acquired.push_back(semaphore);
+        }
+    }
+    return true;
+}
+
+void VulkanDisplay::destroyFrames() {
+    VkDevice device = context_.getDevice();
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+    for (FrameSlot& frame : frames_) {
+        for (VkSemaphore semaphore : frame.acquired) {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+        frame = FrameSlot();   // Command buffers go with the pool
+    }
+    if (commandPool_ != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device, commandPool_, nullptr);
+        commandPool_ = VK_NULL_HANDLE;
+    }
+    if (frameTimeline_ != VK_NULL_HANDLE) {
+        vkDestroySemaphore(device, frameTimeline_, nullptr);
+        frameTimeline_ = VK_NULL_HANDLE;
+    }
+}
+
+bool VulkanDisplay::configureCanvas() {
+    // Bounding box of the regions, as MultiOutputRenderer::calculateCanvasSize
+    int width = 0;
+    int height = 0;
+    std::vector<CanvasRect> visible;
+    for (const OutputRegion& region : regions_) {
+        width = std::max(width, region.canvasX + region.canvasWidth);
+        height = std::max(height, region.canvasY + region.canvasHeight);
+        if (region.enabled) {
+            // One pixel around for the scaled blit's filtering
+            visible.push_back(CanvasRect{region.canvasX - 1, region.canvasY - 1,
+                                         region.canvasWidth + 2, region.canvasHeight + 2});
+        }
+    }
+    return compositor_.configure(width, height, visible);
+}
+
+void VulkanDisplay::render(LayerManager* layerManager, OSDManager* osdManager) {
+    (void)osdManager;  // No OSD without GL
+
+    if (!initialized_) {
+        return;
+    }
+
+    // The slot's last frame must be done with its command buffer and images
+    FrameSlot& frame = frames_[frameIndex_];
+    if (!context_.waitTimeline(frameTimeline_, frame.value)) {
+        return;
+    }
+    frame.owners.clear();
+    uint64_t completed = context_.getTimelineValue(frameTimeline_);
+    importer_.collect(completed);
+    uploader_.collect(completed);
+
+    const uint64_t value = frameValue_ + 1;
+    const uint64_t uploadStart = uploader_.getValue();
+    waits_.clear();
+    signals_.clear();
+    collectLayers(layerManager, value);
+    if (uploader_.getValue() > uploadStart) {
+        VkSemaphoreSubmitInfo wait{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+        wait.semaphore = uploader_.getTimeline();
+        wait.value = uploader_.getValue();
+        wait.stageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        waits_.push_back(wait);
+    }
+
+    VkCommandBuffer cmd = frame.cmd;
+    vkResetCommandBuffer(cmd, 0);
+    VkCommandBufferBeginInfo begin{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &begin);
+    importer_.recordAcquire(cmd, imported_);
+    compositor_.record(cmd, frameIndex_, draws_);
+    importer_.recordRelease(cmd, imported_);
+
+    // Each region to its display
+    swapchains_.clear();
+    imageIndices_.clear();
+    std::vector<VkSemaphore> renderFinished;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+        VulkanOutput& output = *outputs_[i];
+        uint32_t imageIndex = 0;
+        if (!regions_[i].enabled || !output.acquire(frame.acquired[i], imageIndex)) {
+            continue;
+        }
+        recordBlit(cmd, output.getImage(imageIndex), regions_[i], output.getWidth(), output.getHeight());
+
+        VkSemaphoreSubmitInfo wait{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+        wait.semaphore = frame.acquired[i];
+        wait.stageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        waits_.push_back(wait);
+        VkSemaphoreSubmitInfo signal{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+        signal.semaphore = output.getRenderFinished(imageIndex);
+        signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        signals_.push_back(signal);
+        renderFinished.push_back(signal.semaphore);
+        swapchains_.push_back(output.getSwapchain());
+        imageIndices_.push_back(imageIndex);
+    }
+    vkEndCommandBuffer(cmd);
+
+    VkSemaphoreSubmitInfo timeline{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    timeline.semaphore = frameTimeline_;
+    timeline.value = value;
+    timeline.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    signals_.push_back(timeline);
+    VkCommandBufferSubmitInfo cmdInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO};
+    cmdInfo.commandBuffer = cmd;
+    VkSubmitInfo2 submit{VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    submit.waitSemaphoreInfoCount = static_cast<uint32_t>(waits_.size());
+    submit.pWaitSemaphoreInfos = waits_.data();
+    submit.commandBufferInfoCount = 1;
+    submit.pCommandBufferInfos = &cmdInfo;
+    submit.signalSemaphoreInfoCount = static_cast<uint32_t>(signals_.size());
+    submit.pSignalSemaphoreInfos = signals_.data();
+    VkResult result = vkQueueSubmit2(context_.getGraphicsQueue(), 1, &submit, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) {
+        // Uploads already wait on this frame's value: nothing can be submitted after it
+        LOG_ERROR << "VulkanDisplay: Submit failed: " << VulkanContext::resultName(result)
+                  << ", stopping output";
+        initialized_ = false;
+        return;
+    }
+    frame.value = value;
+    frameValue_ = value;
+    frameIndex_ = (frameIndex_ + 1) % FRAMES_IN_FLIGHT;
+
+    if (swapchains_.empty()) {
+        return;
+    }
+    std::vector<VkResult> results(swapchains_.size(), VK_SUCCESS);
+    VkPresentInfoKHR present{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+    present.waitSemaphoreCount = static_cast<uint32_t>(renderFinished.size());
+    present.pWaitSemaphores = renderFinished.data();
+    present.swapchainCount = static_cast<uint32_t>(swapchains_.size());
+    present.pSwapchains = swapchains_.data();
+    present.pImageIndices = imageIndices_.data();
+    present.pResults = results.data();
+    vkQueuePresentKHR(context_.getGraphicsQueue(), &present);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i] == VK_ERROR_OUT_OF_DATE_KHR) {
+            for (auto& output : outputs_) {
+                if (output->getSwapchain() == swapchains_[i]) {
+                    output->recreateSwapchain();
+                }
+            }
+        }
+    }
+}
+
+void VulkanDisplay::collectLayers(LayerManager* layerManager, uint64_t frameValue) {
+    FrameSlot& frame = frames_[frameIndex_];
+    draws_.clear();
+    imported_.clear();
+    if (!layerManager) {
+        return;
+    }
+
+    const int canvasWidth = compositor_.getWidth();
+    const int canvasHeight = compositor_.getHeight();
+    std::shared_ptr<const SceneSnapshot> scene = layerManager->getSnapshot();
+    // Entries are top first, the compositor draws bottom first
+    for (auto it = scene->entries.rbegin(); it != scene->entries.rend(); ++it) {
+        const SceneSnapshot::Entry& entry = *it;
+        const LayerProperties& props = entry.properties;
+        if (!entry.layer || !entry.ready || !props.visible || props.opacity <= 0.0f) {
+            continue;
+        }
+        if (props.packedAlpha != PackedAlpha::Layout::NONE) {
+            warnOnce(entry.layerId, "packed alpha");
+            continue;
+        }
+        if (props.blendMode != LayerProperties::NORMAL) {
+            warnOnce(entry.layerId, "blend mode (drawn normal)");
+        } else if (props.colorAdjust.isActive() || props.effects.isActive()) {
+            warnOnce(entry.layerId, "colour adjustment and effects (not applied)");
+        }
+
+        VulkanCompositor::Draw draw;
+        const FrameBuffer* cpuBuffer = nullptr;
+        const GPUTextureFrameBuffer* gpuBuffer = nullptr;
+        if (entry.layer->getPreparedFrame(cpuBuffer, gpuBuffer)) {
+            const DmaBufPlanes& planes = gpuBuffer ? gpuBuffer->getDmaBufPlanes() : DmaBufPlanes();
+            TexturePlaneType planeType = gpuBuffer ? gpuBuffer->getPlaneType() : TexturePlaneType::SINGLE;
+            if (!dmaBufImport_ || !planes.isValid() ||
+                (planeType != TexturePlaneType::YUV_NV12 && planeType != TexturePlaneType::YUV_P010)) {
+                warnOnce(entry.layerId, "frame in GL textures");
+                continue;
+            }
+            if (props.crop.enabled || props.panoramaMode) {
+                warnOnce(entry.layerId, "crop of a hardware-decoded frame (shown whole)");
+            }
+            bool highDepth = planeType == TexturePlaneType::YUV_P010;
+            const VulkanDmaBufImporter::Image* image = importer_.import(planes, highDepth, frameValue);
+            if (!image) {
+                continue;
+            }
+            VkSemaphore fence = importer_.decodeFence(planes, frameValue);
+            if (fence != VK_NULL_HANDLE) {
+                VkSemaphoreSubmitInfo wait{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+                wait.semaphore = fence;
+                wait.stageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+                waits_.push_back(wait);
+            }
+            if (std::find(imported_.begin(), imported_.end(), image) == imported_.end()) {
+                imported_.push_back(image);
+            }
+            frame.owners.push_back(planes.owner);
+
+            const FrameInfo& info = gpuBuffer->info();
+            draw.views[0] = image->views[0];
+            draw.views[1] = image->views[1];
+            draw.yuv = true;
+            VulkanCompositor::yuvRows(info, highDepth, draw.yuvRows);
+            draw.sourceWidth = info.width > 0 ? info.width : image->width;
+            draw.sourceHeight = info.height > 0 ? info.height : image->height;
+            draw.imageWidth = image->width;
+            draw.imageHeight = image->height;
+        } else {
+            if (!cpuBuffer || !cpuBuffer->isValid()) {
+                continue;
+            }
+            const FrameInfo& info = cpuBuffer->info();
+            if (info.format != PixelFormat::BGRA32 && info.format != PixelFormat::RGBA32) {
+                warnOnce(entry.layerId, "pixel format (needs packed BGRA or RGBA)");
+                continue;
+            }
+            int stride = cpuBuffer->stride(0) > 0 ? cpuBuffer->stride(0) : info.width * 4;
+            const VulkanUploader::Image* image = uploader_.upload(entry.layerId, cpuBuffer->data(), info.width,
+                                                                  info.height, stride,
+                                                                  info.format == PixelFormat::RGBA32, frameValue);
+            if (!image) {
+                continue;
+            }
+            draw.views[0] = image->view;
+            draw.sourceWidth = info.width;
+            draw.sourceHeight = info.height;
+            draw.imageWidth = image->width;
+            draw.imageHeight = image->height;
+        }
+
+        // Placed as the CPU compositor places it
+        SoftwareCompositor::Layer layer;
+        layer.source.width = draw.sourceWidth;
+        layer.source.height = draw.sourceHeight;
+        layer.aspect = entry.layer->getFrameInfo().aspect;
+        layer.properties = props;
+        if (!SoftwareCompositor::place(layer, canvasWidth, canvasHeight, draw.placement)) {
+            continue;
+        }
+        draw.opacity = std::min(props.opacity, 1.0f);
+        draws_.push_back(draw);
+    }
+}
+
+void VulkanDisplay::recordBlit(VkCommandBuffer cmd, VkImage target, const OutputRegion& region, int width,
+                               int height) {
+    VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;   // Chained to the acquire's wait
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = target;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    VkDependencyInfo dependency{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.imageMemoryBarrierCount = 1;
+    dependency.pImageMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    // Region y counts up from the canvas bottom, the canvas image's rows down
+    const int top = compositor_.getHeight() - region.canvasY - region.canvasHeight;
+    VkImageBlit blit{};
+    blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    blit.srcOffsets[0] = {region.canvasX, top, 0};
+    blit.srcOffsets[1] = {region.canvasX + region.canvasWidth, top + region.canvasHeight, 1};
+    blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    blit.dstOffsets[0] = {0, 0, 0};
+    blit.dstOffsets[1] = {width, height, 1};
+    vkCmdBlitImage(cmd, compositor_.getCanvas(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = VK_ACCESS_2_NONE;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+std::vector<OutputInfo> VulkanDisplay::getOutputs() const {
+    std::vector<OutputInfo> infos;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+        OutputInfo info = outputs_[i]->getInfo();
+        info.x = regions_[i].canvasX;
+        info.y = regions_[i].canvasY;
+        infos.push_back(info);
+    }
+    return infos;
+}
+
+bool VulkanDisplay::configureOutputRegion(const std::string& outputName, int canvasX, int canvasY,
+                                          int canvasWidth, int canvasHeight) {
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+        if (regions_[i].name != outputName) {
+            continue;
+        }
+        OutputRegion& region = regions_[i];
+        region.canvasX = canvasX;
+        region.canvasY = canvasY;
+        region.canvasWidth = canvasWidth > 0 ? canvasWidth : outputs_[i]->getWidth();
+        region.canvasHeight = canvasHeight > 0 ? canvasHeight : outputs_[i]->getHeight();
+
+        // The canvas is in use until the frames in flight complete
+        vkDeviceWaitIdle(context_.getDevice());
+        if (!configureCanvas()) {
+            LOG_ERROR << "VulkanDisplay: Failed to resize the canvas for " << outputName;
+            return false;
+        }
+        LOG_INFO << "VulkanDisplay: " << outputName << " shows canvas " << region.canvasWidth << "x"
+                 << region.canvasHeight << "+" << canvasX << "+" << canvasY;
+        return true;
+    }
+    LOG_WARNING << "VulkanDisplay: No output " << outputName;
+    return false;
+}
+
+bool VulkanDisplay::setResolutionMode(const std::string& mode) {
+    if (mode != "native" && mode != "maximum" && mode != "1080p" && mode != "720p" && mode != "4k") {
+        return false;
+    }
+    resolutionMode_ = mode;
+    if (initialized_) {
+        LOG_INFO << "VulkanDisplay: Resolution mode " << mode << " applies when the display is reopened";
+    }
+    return true;
+}
+
+bool VulkanDisplay::importsDmaBuf() const {
+#ifdef HAVE_VAAPI_INTEROP
+    return dmaBufImport_;
+#else
+    return false;   // No VAAPI exporter in this build
+#endif
+}
+
+void VulkanDisplay::warnOnce(int layerId, const char* reason) {
+    if (warnedLayers_.insert(layerId).second) {
+        LOG_WARNING << "VulkanDisplay: Layer " << layerId << " not composited as the GL renderer would: "
+                    << reason;
+    }
+}
+
+void VulkanDisplay::getWindowSize(unsigned int* width, unsigned int* height) const {
+    *width = static_cast<unsigned int>(compositor_.getWidth());
+    *height = static_cast<unsigned int>(compositor_.getHeight());
+}
+
+} // namespace videocomposer
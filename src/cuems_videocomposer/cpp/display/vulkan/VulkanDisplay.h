@@ -0,0 +1,133 @@
+/**
+ * VulkanDisplay.h - Vulkan display backend (opt-in, --vulkan-display)
+ *
+ * Composites on a Vulkan device and presents straight to the displays
+ * through VK_KHR_display, without a display server, EGL or GL.
+ */
+
+#ifndef VIDEOCOMPOSER_VULKANDISPLAY_H
+#define VIDEOCOMPOSER_VULKANDISPLAY_H
+
+#include "../DisplayBackend.h"
+#include "../OutputRegion.h"
+#include "VulkanCompositor.h"
+#include "VulkanContext.h"
+#include "VulkanDmaBufImporter.h"
+#include "VulkanOutput.h"
+#include "VulkanUploader.h"
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * VulkanDisplay - Layers composited and presented with Vulkan
+ *
+ * One output per VkDisplayKHR, each an OutputRegion of a shared canvas
+ * (side by side by default, moved with configureOutputRegion) as in
+ * the DRM backend's virtual canvas; each frame the canvas is composited
+ * once (VulkanCompositor) and every region is blitted to its display's
+ * swapchain, all presented in one call.
+ *
+ * Frames come in two ways. Hardware-decoded VAAPI frames arrive as
+ * their DMA-BUF (importsDmaBuf) and are sampled in place, waiting on
+ * the decode's fence. CPU frames (packed BGRA/RGBA; getRenderer() is
+ * null, so layers decode to it as for SoftwareDisplay) are copied on
+ * the transfer queue while the previous frame composites. Submissions
+ * are ordered with timeline semaphores: the frame timeline, signalled
+ * by each composite, paces the CPU (FRAMES_IN_FLIGHT ahead) and frees
+ * upload slots; the upload timeline gates the composite.
+ *
+ * Not supported, skipped or drawn plainly (logged once per layer): OSD,
+ * capture and virtual outputs, operator preview, edge blending and
+ * warping, groups and the master transform, colour adjustment and
+ * effects, blend modes other than normal (drawn normal), packed alpha,
+ * crop and panorama of hardware-decoded frames (shown whole), HAP and
+ * frames only in GL textures.
+ */
+class VulkanDisplay : public DisplayBackend {
+public:
+    static constexpr int FRAMES_IN_FLIGHT = 2;
+
+    VulkanDisplay();
+    ~VulkanDisplay() override;
+
+    // ===== DisplayBackend Interface =====
+
+    bool openWindow() override;
+    void closeWindow() override;
+    bool isWindowOpen() const override { return initialized_; }
+
+    void render(LayerManager* layerManager, OSDManager* osdManager = nullptr) override;
+    void handleEvents() override {}  // No window system
+
+    void resize(unsigned int width, unsigned int height) override { (void)width; (void)height; }
+    void getWindowSize(unsigned int* width, unsigned int* height) const override;
+
+    void setPosition(int x, int y) override { (void)x; (void)y; }
+    void getWindowPos(int* x, int* y) const override { *x = 0; *y = 0; }
+
+    void setFullscreen(int action) override { (void)action; }
+    bool getFullscreen() const override { return true; }
+
+    void setOnTop(int action) override { (void)action; }
+    bool getOnTop() const override { return true; }
+
+    bool supportsMultiDisplay() const override { return true; }
+
+    size_t getOutputCount() const override { return outputs_.size(); }
+    std::vector<OutputInfo> getOutputs() const override;
+    bool configureOutputRegion(const std::string& outputName, int canvasX, int canvasY,
+                               int canvasWidth = 0, int canvasHeight = 0) override;
+    bool setResolutionMode(const std::string& mode) override;
+
+    bool importsDmaBuf() const override;
+
+private:
+    struct FrameSlot {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        uint64_t value = 0;                             // Frame timeline value of its last submit
+        std::vector<VkSemaphore> acquired;              // Per output
+        std::vector<std::shared_ptr<void>> owners;      // Decoder surfaces sampled
+    };
+
+    bool createFrames();
+    void destroyFrames();
+    bool configureCanvas();
+    void collectLayers(LayerManager* layerManager, uint64_t frameValue);
+    void recordBlit(VkCommandBuffer cmd, VkImage target, const OutputRegion& region, int width, int height);
+    void warnOnce(int layerId, const char* reason);
+
+    VulkanContext context_;
+    VulkanUploader uploader_;
+    VulkanDmaBufImporter importer_;
+    VulkanCompositor compositor_;
+    std::vector<std::unique_ptr<VulkanOutput>> outputs_;
+    std::vector<OutputRegion> regions_;                 // Per output
+
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+    VkSemaphore frameTimeline_ = VK_NULL_HANDLE;
+    uint64_t frameValue_ = 0;
+    FrameSlot frames_[FRAMES_IN_FLIGHT];
+    int frameIndex_ = 0;
+
+    // Per frame, kept for their capacity
+    std::vector<VulkanCompositor::Draw> draws_;
+    std::vector<const VulkanDmaBufImporter::Image*> imported_;
+    std::vector<VkSemaphoreSubmitInfo> waits_;
+    std::vector<VkSemaphoreSubmitInfo> signals_;
+    std::vector<VkSwapchainKHR> swapchains_;
+    std::vector<uint32_t> imageIndices_;
+
+    std::string resolutionMode_ = "native";
+    std::set<int> warnedLayers_;
+    bool dmaBufImport_ = false;
+    bool initialized_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VULKANDISPLAY_H
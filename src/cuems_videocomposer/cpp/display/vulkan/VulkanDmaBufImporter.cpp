@@ -0,0 +1,364 @@
+#include "VulkanDmaBufImporter.h"
+#include "VulkanContext.h"
+#include "../../utils/Logger.h"
+
+#include <linux/dma-buf.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace videocomposer {
+
+namespace {
+
+// DRM_FORMAT_MOD_INVALID: the layout is implicit, nothing to import with
+constexpr uint64_t MODIFIER_INVALID = 0x00ffffffffffffffULL;
+
+// CPU wait for a decode before the frame is dropped from this composite
+constexpr int DECODE_WAIT_MS = 100;
+
+} // namespace
+
+VulkanDmaBufImporter::VulkanDmaBufImporter(VulkanContext& context)
+    : context_(context) {
+}
+
+VulkanDmaBufImporter::~VulkanDmaBufImporter() {
+    cleanup();
+}
+
+bool VulkanDmaBufImporter::init() {
+    if (!context_.supportsDmaBufImport()) {
+        return false;
+    }
+
+    gpuFences_ = false;
+    if (context_.supportsSyncFdImport()) {
+        VkPhysicalDeviceExternalSemaphoreInfo info{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_SEMAPHORE_INFO};
+        info.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT;
+        VkExternalSemaphoreProperties properties{VK_STRUCTURE_TYPE_EXTERNAL_SEMAPHORE_PROPERTIES};
+        vkGetPhysicalDeviceExternalSemaphoreProperties(context_.getPhysicalDevice(), &info, &properties);
+        gpuFences_ = (properties.externalSemaphoreFeatures & VK_EXTERNAL_SEMAPHORE_FEATURE_IMPORTABLE_BIT) != 0;
+    }
+#ifndef DMA_BUF_IOCTL_EXPORT_SYNC_FILE
+    gpuFences_ = false;   // Kernel headers without sync file export: poll the DMA-BUF
+#endif
+    LOG_INFO << "VulkanDmaBufImporter: Decode fences waited for on the " << (gpuFences_ ? "GPU" : "CPU");
+    return true;
+}
+
+void VulkanDmaBufImporter::cleanup() {
+    VkDevice device = context_.getDevice();
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+    for (auto& entry : images_) {
+        destroy(entry.second);
+    }
+    images_.clear();
+    for (auto& used : usedSemaphores_) {
+        freeSemaphores_.push_back(used.second);
+    }
+    usedSemaphores_.clear();
+    for (VkSemaphore semaphore : freeSemaphores_) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    freeSemaphores_.clear();
+    modifiers_.clear();
+    failedKeys_.clear();
+}
+
+const VulkanDmaBufImporter::Image* VulkanDmaBufImporter::import(const DmaBufPlanes& planes, bool highDepth,
+                                                                uint64_t frameValue) {
+    if (!planes.isValid()) {
+        return nullptr;
+    }
+    auto it = images_.find(planes.key);
+    if (it != images_.end()) {
+        it->second.lastFrame = frameValue;
+        return &it->second;
+    }
+    if (failedKeys_.count(planes.key)) {
+        return nullptr;
+    }
+
+    Image image;
+    image.width = planes.width;
+    image.height = planes.height;
+    image.highDepth = highDepth;
+    VkFormat formats[2] = {highDepth ? VK_FORMAT_R16_UNORM : VK_FORMAT_R8_UNORM,
+                           highDepth ? VK_FORMAT_R16G16_UNORM : VK_FORMAT_R8G8_UNORM};
+    int widths[2] = {planes.width, (planes.width + 1) / 2};
+    int heights[2] = {planes.height, (planes.height + 1) / 2};
+
+    bool ok = planes.modifier != MODIFIER_INVALID;
+    for (int plane = 0; ok && plane < 2; ++plane) {
+        ok = supportsModifier(formats[plane], planes.modifier) &&
+             importPlane(planes.fds[plane], planes.offsets[plane], planes.pitches[plane], planes.modifier,
+                         formats[plane], widths[plane], heights[plane],
+                         image.planes[plane], image.memory[plane], image.views[plane]);
+    }
+    if (!ok) {
+        destroy(image);
+        if (failedKeys_.size() > 1024) {
+            failedKeys_.clear();
+        }
+        failedKeys_.insert(planes.key);
+        LOG_WARNING << "VulkanDmaBufImporter: Cannot import " << planes.width << "x" << planes.height
+                    << " surface (modifier 0x" << std::hex << planes.modifier << std::dec << ")";
+        return nullptr;
+    }
+
+    image.lastFrame = frameValue;
+    LOG_VERBOSE << "VulkanDmaBufImporter: Imported surface " << planes.key << " (" << planes.width << "x"
+                << planes.height << (highDepth ? ", 16-bit planes" : "") << ")";
+    return &images_.emplace(planes.key, image).first->second;
+}
+
+bool VulkanDmaBufImporter::supportsModifier(VkFormat format, uint64_t modifier) {
+    auto key = std::make_pair(format, modifier);
+    auto it = modifiers_.find(key);
+    if (it != modifiers_.end()) {
+        return it->second;
+    }
+
+    VkDrmFormatModifierPropertiesListEXT list{VK_STRUCTURE_TYPE_DRM_FORMAT_MODIFIER_PROPERTIES_LIST_EXT};
+    VkFormatProperties2 properties{VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2};
+    properties.pNext = &list;
+    vkGetPhysicalDeviceFormatProperties2(context_.getPhysicalDevice(), format, &properties);
+    std::vector<VkDrmFormatModifierPropertiesEXT> entries(list.drmFormatModifierCount);
+    list.pDrmFormatModifierProperties = entries.data();
+    vkGetPhysicalDeviceFormatProperties2(context_.getPhysicalDevice(), format, &properties);
+
+    bool supported = false;
+    for (uint32_t i = 0; i < list.drmFormatModifierCount; ++i) {
+        const VkDrmFormatModifierPropertiesEXT& entry = entries[i];
+        if (entry.drmFormatModifier == modifier && entry.drmFormatModifierPlaneCount == 1 &&
+            (entry.drmFormatModifierTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+            supported = true;
+        }
+    }
+    if (!supported) {
+        LOG_WARNING << "VulkanDmaBufImporter: Format " << format << " cannot be sampled with modifier 0x"
+                    << std::hex << modifier << std::dec;
+    }
+    modifiers_[key] = supported;
+    return supported;
+}
+
+bool VulkanDmaBufImporter::importPlane(int fd, uint32_t offset, uint32_t pitch, uint64_t modifier, VkFormat format,
+                                       int width, int height, VkImage& image, VkDeviceMemory& memory,
+                                       VkImageView& view) {
+    VkDevice device = context_.getDevice();
+
+    // One memory plane at the exporter's offset and pitch
+    VkSubresourceLayout layout{};
+    layout.offset = offset;
+    layout.rowPitch = pitch;
+    VkImageDrmFormatModifierExplicitCreateInfoEXT modifierInfo{
+        VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_EXPLICIT_CREATE_INFO_EXT};
+    modifierInfo.drmFormatModifier = modifier;
+    modifierInfo.drmFormatModifierPlaneCount = 1;
+    modifierInfo.pPlaneLayouts = &layout;
+    VkExternalMemoryImageCreateInfo externalInfo{VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO};
+    externalInfo.pNext = &modifierInfo;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+
+    VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.pNext = &externalInfo;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkResult result = vkCreateImage(device, &imageInfo, nullptr, &image);
+    if (result != VK_SUCCESS) {
+        LOG_WARNING << "VulkanDmaBufImporter: vkCreateImage failed: " << VulkanContext::resultName(result);
+        image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryFdPropertiesKHR fdProperties{VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR};
+    result = context_.getMemoryFdProperties()(device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT, fd,
+                                              &fdProperties);
+    if (result != VK_SUCCESS) {
+        LOG_WARNING << "VulkanDmaBufImporter: vkGetMemoryFdPropertiesKHR failed: "
+                    << VulkanContext::resultName(result);
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, image, &requirements);
+    uint32_t memoryType = context_.findMemoryType(requirements.memoryTypeBits & fdProperties.memoryTypeBits, 0);
+    if (memoryType == UINT32_MAX) {
+        LOG_WARNING << "VulkanDmaBufImporter: No memory type for the DMA-BUF";
+        return false;
+    }
+
+    // The import takes ownership of its fd, the exporter keeps its own
+    int importFd = dup(fd);
+    if (importFd < 0) {
+        return false;
+    }
+    off_t size = lseek(importFd, 0, SEEK_END);
+    lseek(importFd, 0, SEEK_SET);
+
+    VkMemoryDedicatedAllocateInfo dedicated{VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+    dedicated.image = image;
+    VkImportMemoryFdInfoKHR importInfo{VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR};
+    importInfo.pNext = &dedicated;
+    importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+    importInfo.fd = importFd;
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.pNext = &importInfo;
+    allocInfo.allocationSize = std::max<VkDeviceSize>(requirements.size, size > 0 ? static_cast<VkDeviceSize>(size) : 0);
+    allocInfo.memoryTypeIndex = memoryType;
+    result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        LOG_WARNING << "VulkanDmaBufImporter: DMA-BUF import failed: " << VulkanContext::resultName(result);
+        close(importFd);
+        memory = VK_NULL_HANDLE;
+        return false;
+    }
+    vkBindImageMemory(device, image, memory, 0);
+
+    VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+        view = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+VkSemaphore VulkanDmaBufImporter::decodeFence(const DmaBufPlanes& planes, uint64_t frameValue) {
+    // Fences of the writers (the decode) a reader must wait for
+    int syncFd = -1;
+#ifdef DMA_BUF_IOCTL_EXPORT_SYNC_FILE
+    struct dma_buf_export_sync_file exportInfo = {};
+    exportInfo.flags = DMA_BUF_SYNC_READ;
+    exportInfo.fd = -1;
+    if (ioctl(planes.fds[0], DMA_BUF_IOCTL_EXPORT_SYNC_FILE, &exportInfo) == 0) {
+        syncFd = exportInfo.fd;
+    }
+#endif
+
+    if (syncFd >= 0 && gpuFences_) {
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        if (!freeSemaphores_.empty()) {
+            semaphore = freeSemaphores_.back();
+            freeSemaphores_.pop_back();
+        } else {
+            semaphore = context_.createSemaphore();
+        }
+        if (semaphore != VK_NULL_HANDLE) {
+            VkImportSemaphoreFdInfoKHR importInfo{VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR};
+            importInfo.semaphore = semaphore;
+            importInfo.flags = VK_SEMAPHORE_IMPORT_TEMPORARY_BIT;
+            importInfo.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT;
+            importInfo.fd = syncFd;
+            if (context_.importSemaphoreFd()(context_.getDevice(), &importInfo) == VK_SUCCESS) {
+                usedSemaphores_.emplace_back(frameValue, semaphore);   // The semaphore owns the fd now
+                return semaphore;
+            }
+            freeSemaphores_.push_back(semaphore);
+        }
+    }
+
+    // On the CPU: the sync file, or the DMA-BUF itself (readable once its writers are done)
+    struct pollfd pfd = {syncFd >= 0 ? syncFd : planes.fds[0], POLLIN, 0};
+    if (poll(&pfd, 1, DECODE_WAIT_MS) == 0) {
+        LOG_VERBOSE << "VulkanDmaBufImporter: Decode of surface " << planes.key << " still running after "
+                    << DECODE_WAIT_MS << " ms";
+    }
+    if (syncFd >= 0) {
+        close(syncFd);
+    }
+    return VK_NULL_HANDLE;
+}
+
+void VulkanDmaBufImporter::recordAcquire(VkCommandBuffer cmd, const std::vector<const Image*>& images) const {
+    recordBarriers(cmd, images, true);
+}
+
+void VulkanDmaBufImporter::recordRelease(VkCommandBuffer cmd, const std::vector<const Image*>& images) const {
+    recordBarriers(cmd, images, false);
+}
+
+void VulkanDmaBufImporter::recordBarriers(VkCommandBuffer cmd, const std::vector<const Image*>& images,
+                                          bool acquire) const {
+    if (images.empty()) {
+        return;
+    }
+    std::vector<VkImageMemoryBarrier2> barriers;
+    barriers.reserve(images.size() * 2);
+    for (const Image* image : images) {
+        for (VkImage plane : image->planes) {
+            VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+            if (acquire) {
+                barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+                barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+                barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                barrier.srcQueueFamilyIndex = context_.getForeignFamily();
+                barrier.dstQueueFamilyIndex = context_.getGraphicsFamily();
+            } else {
+                barrier.srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+                barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+                barrier.srcQueueFamilyIndex = context_.getGraphicsFamily();
+                barrier.dstQueueFamilyIndex = context_.getForeignFamily();
+            }
+            barrier.image = plane;
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            barriers.push_back(barrier);
+        }
+    }
+    VkDependencyInfo dependency{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+    dependency.pImageMemoryBarriers = barriers.data();
+    vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+void VulkanDmaBufImporter::collect(uint64_t completedValue) {
+    while (!usedSemaphores_.empty() && usedSemaphores_.front().first <= completedValue) {
+        freeSemaphores_.push_back(usedSemaphores_.front().second);
+        usedSemaphores_.pop_front();
+    }
+    for (auto it = images_.begin(); it != images_.end();) {
+        if (it->second.lastFrame + IDLE_FRAMES < completedValue) {
+            destroy(it->second);
+            it = images_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void VulkanDmaBufImporter::destroy(Image& image) {
+    VkDevice device = context_.getDevice();
+    for (int plane = 0; plane < 2; ++plane) {
+        if (image.views[plane] != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, image.views[plane], nullptr);
+        }
+        if (image.planes[plane] != VK_NULL_HANDLE) {
+            vkDestroyImage(device, image.planes[plane], nullptr);
+        }
+        if (image.memory[plane] != VK_NULL_HANDLE) {
+            vkFreeMemory(device, image.memory[plane], nullptr);
+        }
+    }
+    image = Image();
+}
+
+} // namespace videocomposer
@@ -0,0 +1,97 @@
+#ifndef VIDEOCOMPOSER_VULKANDMABUFIMPORTER_H
+#define VIDEOCOMPOSER_VULKANDMABUFIMPORTER_H
+
+#include "../../video/DmaBufPlanes.h"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace videocomposer {
+
+class VulkanContext;
+
+/**
+ * VulkanDmaBufImporter - Hardware-decoded frames as Vulkan images, no copy
+ *
+ * The Y and UV planes of a DMA-BUF (VaapiDmaBufExporter) are imported
+ * as two images (R8 + R8G8, R16 + R16G16 for 10-bit) with the exporter's
+ * DRM format modifier, and cached by DmaBufPlanes::key, so each decoder
+ * surface is imported once.
+ *
+ * The images belong to the decoder's driver: each composite acquires
+ * them from the foreign queue family and releases them back. The
+ * decode's fence is exported from the DMA-BUF (DMA_BUF_IOCTL_EXPORT_SYNC_FILE)
+ * and imported into a semaphore the composite waits on; without sync
+ * file import it is waited for on the CPU.
+ */
+class VulkanDmaBufImporter {
+public:
+    struct Image {
+        VkImage planes[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};   // Y, UV
+        VkImageView views[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+        VkDeviceMemory memory[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+        int width = 0;
+        int height = 0;
+        bool highDepth = false;
+        uint64_t lastFrame = 0;
+    };
+
+    explicit VulkanDmaBufImporter(VulkanContext& context);
+    ~VulkanDmaBufImporter();
+
+    VulkanDmaBufImporter(const VulkanDmaBufImporter&) = delete;
+    VulkanDmaBufImporter& operator=(const VulkanDmaBufImporter&) = delete;
+
+    bool init();
+    void cleanup();
+
+    /**
+     * Images of a frame's planes (imported on first use)
+     * @param frameValue Frame timeline value of the composite reading them
+     * @return nullptr if the planes cannot be imported
+     */
+    const Image* import(const DmaBufPlanes& planes, bool highDepth, uint64_t frameValue);
+
+    /**
+     * Semaphore signalled when the frame's decode has finished
+     * @return VK_NULL_HANDLE if there is nothing to wait for on the GPU
+     *         (waited for on the CPU, or no fence)
+     */
+    VkSemaphore decodeFence(const DmaBufPlanes& planes, uint64_t frameValue);
+
+    /** Acquire from the decoder before sampling, release back after */
+    void recordAcquire(VkCommandBuffer cmd, const std::vector<const Image*>& images) const;
+    void recordRelease(VkCommandBuffer cmd, const std::vector<const Image*>& images) const;
+
+    /**
+     * Recycle fence semaphores and drop images of surfaces gone for a while
+     * @param completedValue Frame timeline value the GPU has reached
+     */
+    void collect(uint64_t completedValue);
+
+private:
+    static constexpr uint64_t IDLE_FRAMES = 120;
+
+    bool importPlane(int fd, uint32_t offset, uint32_t pitch, uint64_t modifier, VkFormat format,
+                     int width, int height, VkImage& image, VkDeviceMemory& memory, VkImageView& view);
+    bool supportsModifier(VkFormat format, uint64_t modifier);
+    void destroy(Image& image);
+    void recordBarriers(VkCommandBuffer cmd, const std::vector<const Image*>& images, bool acquire) const;
+
+    VulkanContext& context_;
+    bool gpuFences_ = false;
+    std::unordered_map<uint64_t, Image> images_;
+    std::map<std::pair<VkFormat, uint64_t>, bool> modifiers_;
+    std::set<uint64_t> failedKeys_;                              // Logged once
+    std::vector<VkSemaphore> freeSemaphores_;
+    std::deque<std::pair<uint64_t, VkSemaphore>> usedSemaphores_;   // By frame value
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VULKANDMABUFIMPORTER_H
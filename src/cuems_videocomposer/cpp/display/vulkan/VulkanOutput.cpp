@@ -0,0 +1,295 @@
+#include "VulkanOutput.h"
+#include "VulkanContext.h"
+#include "../../utils/Logger.h"
+
+#include <algorithm>
+
+namespace videocomposer {
+
+VulkanOutput::VulkanOutput(VulkanContext& context, VkDisplayKHR display, const VkDisplayPropertiesKHR& properties,
+                           int index)
+    : context_(context)
+    , display_(display)
+    , properties_(properties)
+    , index_(index) {
+    // Drivers name displays by connector where they can; the pointer is not kept
+    if (properties.displayName && properties.displayName[0]) {
+        name_ = properties.displayName;
+    } else {
+        name_ = "VK-DISPLAY-" + std::to_string(index + 1);
+    }
+    properties_.displayName = nullptr;
+}
+
+VulkanOutput::~VulkanOutput() {
+    cleanup();
+}
+
+bool VulkanOutput::init(const std::string& resolutionMode, std::vector<uint32_t>& usedPlanes) {
+    VkPhysicalDevice physicalDevice = context_.getPhysicalDevice();
+    uint32_t count = 0;
+    vkGetDisplayModePropertiesKHR(physicalDevice, display_, &count, nullptr);
+    modes_.resize(count);
+    vkGetDisplayModePropertiesKHR(physicalDevice, display_, &count, modes_.data());
+    if (modes_.empty()) {
+        LOG_ERROR << "VulkanOutput: " << name_ << " has no modes";
+        return false;
+    }
+    if (!pickMode(resolutionMode) || !pickPlane(usedPlanes)) {
+        return false;
+    }
+
+    VkDisplayPlaneCapabilitiesKHR capabilities;
+    vkGetDisplayPlaneCapabilitiesKHR(physicalDevice, mode_, plane_, &capabilities);
+    VkDisplayPlaneAlphaFlagBitsKHR alpha = VK_DISPLAY_PLANE_ALPHA_OPAQUE_BIT_KHR;
+    if (!(capabilities.supportedAlpha & alpha)) {
+        alpha = static_cast<VkDisplayPlaneAlphaFlagBitsKHR>(
+            capabilities.supportedAlpha & (~capabilities.supportedAlpha + 1));   // Lowest supported
+    }
+
+    VkDisplaySurfaceCreateInfoKHR surfaceInfo{VK_STRUCTURE_TYPE_DISPLAY_SURFACE_CREATE_INFO_KHR};
+    surfaceInfo.displayMode = mode_;
+    surfaceInfo.planeIndex = plane_;
+    surfaceInfo.planeStackIndex = stackIndex_;
+    surfaceInfo.transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    surfaceInfo.globalAlpha = 1.0f;
+    surfaceInfo.alphaMode = alpha;
+    surfaceInfo.imageExtent = extent_;
+    VkResult result = vkCreateDisplayPlaneSurfaceKHR(context_.getInstance(), &surfaceInfo, nullptr, &surface_);
+    if (result != VK_SUCCESS) {
+        LOG_ERROR << "VulkanOutput: " << name_ << ": vkCreateDisplayPlaneSurfaceKHR failed: "
+                  << VulkanContext::resultName(result);
+        surface_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkBool32 supported = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, context_.getGraphicsFamily(), surface_, &supported);
+    if (!supported) {
+        LOG_ERROR << "VulkanOutput: " << name_ << ": Graphics queue cannot present to it";
+        cleanup();
+        return false;
+    }
+    if (!createSwapchain()) {
+        cleanup();
+        return false;
+    }
+    LOG_INFO << "VulkanOutput: " << name_ << " " << extent_.width << "x" << extent_.height << "@"
+             << refreshRate_ << "Hz on plane " << plane_ << ", " << images_.size() << " images";
+    return true;
+}
+
+bool VulkanOutput::pickMode(const std::string& resolutionMode) {
+    uint32_t width = properties_.physicalResolution.width;
+    uint32_t height = properties_.physicalResolution.height;
+    if (resolutionMode == "maximum") {
+        for (const VkDisplayModePropertiesKHR& mode : modes_) {
+            const VkExtent2D& size = mode.parameters.visibleRegion;
+            if (static_cast<uint64_t>(size.width) * size.height > static_cast<uint64_t>(width) * height) {
+                width = size.width;
+                height = size.height;
+            }
+        }
+    } else if (resolutionMode == "1080p") {
+        width = 1920;
+        height = 1080;
+    } else if (resolutionMode == "720p") {
+        width = 1280;
+        height = 720;
+    } else if (resolutionMode == "4k") {
+        width = 3840;
+        height = 2160;
+    }
+
+    // Highest refresh at that size; else the display's first (preferred) mode
+    const VkDisplayModePropertiesKHR* picked = nullptr;
+    for (const VkDisplayModePropertiesKHR& mode : modes_) {
+        const VkDisplayModeParametersKHR& parameters = mode.parameters;
+        if (parameters.visibleRegion.width == width && parameters.visibleRegion.height == height &&
+            (!picked || parameters.refreshRate > picked->parameters.refreshRate)) {
+            picked = &mode;
+        }
+    }
+    if (!picked) {
+        LOG_WARNING << "VulkanOutput: " << name_ << " has no " << width << "x" << height
+                    << " mode, using its first";
+        picked = &modes_[0];
+    }
+    mode_ = picked->displayMode;
+    extent_ = picked->parameters.visibleRegion;
+    refreshRate_ = picked->parameters.refreshRate / 1000.0;   // Millihertz
+    return true;
+}
+
+bool VulkanOutput::pickPlane(std::vector<uint32_t>& usedPlanes) {
+    VkPhysicalDevice physicalDevice = context_.getPhysicalDevice();
+    uint32_t count = 0;
+    vkGetPhysicalDeviceDisplayPlanePropertiesKHR(physicalDevice, &count, nullptr);
+    std::vector<VkDisplayPlanePropertiesKHR> planes(count);
+    vkGetPhysicalDeviceDisplayPlanePropertiesKHR(physicalDevice, &count, planes.data());
+
+    for (uint32_t plane = 0; plane < count; ++plane) {
+        if (std::find(usedPlanes.begin(), usedPlanes.end(), plane) != usedPlanes.end()) {
+            continue;
+        }
+        uint32_t displayCount = 0;
+        vkGetDisplayPlaneSupportedDisplaysKHR(physicalDevice, plane, &displayCount, nullptr);
+        std::vector<VkDisplayKHR> displays(displayCount);
+        vkGetDisplayPlaneSupportedDisplaysKHR(physicalDevice, plane, &displayCount, displays.data());
+        if (std::find(displays.begin(), displays.end(), display_) != displays.end()) {
+            plane_ = plane;
+            stackIndex_ = planes[plane].currentStackIndex;
+            usedPlanes.push_back(plane);
+            return true;
+        }
+    }
+    LOG_ERROR << "VulkanOutput: No free plane for " << name_;
+    return false;
+}
+
+bool VulkanOutput::createSwapchain() {
+    VkPhysicalDevice physicalDevice = context_.getPhysicalDevice();
+    VkDevice device = context_.getDevice();
+
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface_, &capabilities);
+    if (!(capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        LOG_ERROR << "VulkanOutput: " << name_ << ": Swapchain images cannot be blitted to";
+        return false;
+    }
+    if (capabilities.currentExtent.width != UINT32_MAX) {
+        extent_ = capabilities.currentExtent;
+    }
+
+    uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface_, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface_, &formatCount, formats.data());
+    if (formats.empty()) {
+        return false;
+    }
+    VkSurfaceFormatKHR format = formats[0];
+    for (const VkSurfaceFormatKHR& candidate : formats) {
+        if (candidate.format == VK_FORMAT_B8G8R8A8_UNORM) {
+            format = candidate;
+            break;
+        }
+    }
+
+    // Triple buffered, as the DRM backend's default
+    uint32_t imageCount = std::max(3u, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0) {
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    }
+
+    VkSwapchainKHR oldSwapchain = swapchain_;
+    VkSwapchainCreateInfoKHR info{VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
+    info.surface = surface_;
+    info.minImageCount = imageCount;
+    info.imageFormat = format.format;
+    info.imageColorSpace = format.colorSpace;
+    info.imageExtent = extent_;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    info.clipped = VK_TRUE;
+    info.oldSwapchain = oldSwapchain;
+    VkResult result = vkCreateSwapchainKHR(device, &info, nullptr, &swapchain_);
+    if (oldSwapchain != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+    }
+    if (result != VK_SUCCESS) {
+        LOG_ERROR << "VulkanOutput: " << name_ << ": vkCreateSwapchainKHR failed: "
+                  << VulkanContext::resultName(result);
+        swapchain_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    uint32_t count = 0;
+    vkGetSwapchainImagesKHR(device, swapchain_, &count, nullptr);
+    images_.resize(count);
+    vkGetSwapchainImagesKHR(device, swapchain_, &count, images_.data());
+    while (renderFinished_.size() < count) {
+        VkSemaphore semaphore = context_.createSemaphore();
+        if (semaphore == VK_NULL_HANDLE) {
+            return false;
+        }
+        renderFinished_.push_back(semaphore);
+    }
+    return true;
+}
+
+bool VulkanOutput::recreateSwapchain() {
+    vkDeviceWaitIdle(context_.getDevice());
+    LOG_INFO << "VulkanOutput: " << name_ << ": Recreating swapchain";
+    return createSwapchain();
+}
+
+bool VulkanOutput::acquire(VkSemaphore acquired, uint32_t& imageIndex) {
+    if (swapchain_ == VK_NULL_HANDLE) {
+        return false;
+    }
+    VkResult result = vkAcquireNextImageKHR(context_.getDevice(), swapchain_, UINT64_MAX, acquired,
+                                            VK_NULL_HANDLE, &imageIndex);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        recreateSwapchain();
+        return false;
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        LOG_WARNING << "VulkanOutput: " << name_ << ": vkAcquireNextImageKHR: " << VulkanContext::resultName(result);
+        return false;
+    }
+    return true;
+}
+
+void VulkanOutput::destroySwapchain() {
+    VkDevice device = context_.getDevice();
+    for (VkSemaphore semaphore : renderFinished_) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    renderFinished_.clear();
+    images_.clear();
+    if (swapchain_ != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(device, swapchain_, nullptr);
+        swapchain_ = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanOutput::cleanup() {
+    if (context_.getDevice() == VK_NULL_HANDLE) {
+        return;
+    }
+    destroySwapchain();
+    if (surface_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(context_.getInstance(), surface_, nullptr);
+        surface_ = VK_NULL_HANDLE;
+    }
+}
+
+OutputInfo VulkanOutput::getInfo() const {
+    OutputInfo info;
+    info.name = name_;
+    info.width = static_cast<int32_t>(extent_.width);
+    info.height = static_cast<int32_t>(extent_.height);
+    info.physicalWidthMM = static_cast<int32_t>(properties_.physicalDimensions.width);
+    info.physicalHeightMM = static_cast<int32_t>(properties_.physicalDimensions.height);
+    info.refreshRate = refreshRate_;
+    info.connected = true;
+    info.enabled = swapchain_ != VK_NULL_HANDLE;
+    info.index = index_;
+    for (const VkDisplayModePropertiesKHR& mode : modes_) {
+        OutputMode outputMode;
+        outputMode.width = static_cast<int32_t>(mode.parameters.visibleRegion.width);
+        outputMode.height = static_cast<int32_t>(mode.parameters.visibleRegion.height);
+        outputMode.refreshRate = mode.parameters.refreshRate / 1000.0;
+        outputMode.preferred = mode.parameters.visibleRegion.width == properties_.physicalResolution.width &&
+                               mode.parameters.visibleRegion.height == properties_.physicalResolution.height;
+        info.modes.push_back(outputMode);
+    }
+    return info;
+}
+
+} // namespace videocomposer
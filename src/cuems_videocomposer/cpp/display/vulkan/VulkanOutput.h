@@ -0,0 +1,84 @@
+#ifndef VIDEOCOMPOSER_VULKANOUTPUT_H
+#define VIDEOCOMPOSER_VULKANOUTPUT_H
+
+#include "../OutputInfo.h"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+class VulkanContext;
+
+/**
+ * VulkanOutput - One display driven through VK_KHR_display
+ *
+ * A display plane surface on the display's mode, and a FIFO swapchain
+ * on it (vsync, no tearing) whose images are written by blits from the
+ * canvas. The mode is picked by resolution policy as DRMOutputManager
+ * picks it: "native" (the display's physical resolution), "maximum",
+ * "1080p", "720p" or "4k", the highest refresh at that size.
+ */
+class VulkanOutput {
+public:
+    VulkanOutput(VulkanContext& context, VkDisplayKHR display, const VkDisplayPropertiesKHR& properties,
+                 int index);
+    ~VulkanOutput();
+
+    VulkanOutput(const VulkanOutput&) = delete;
+    VulkanOutput& operator=(const VulkanOutput&) = delete;
+
+    /**
+     * Pick the mode and a plane, create the surface and swapchain
+     * @param usedPlanes Planes taken by other outputs (this one's is added)
+     */
+    bool init(const std::string& resolutionMode, std::vector<uint32_t>& usedPlanes);
+    void cleanup();
+
+    /**
+     * Next swapchain image, signalling acquired when it can be written
+     * @return false if there is none this frame (swapchain recreated)
+     */
+    bool acquire(VkSemaphore acquired, uint32_t& imageIndex);
+
+    /** Rebuild the swapchain after VK_ERROR_OUT_OF_DATE_KHR */
+    bool recreateSwapchain();
+
+    VkSwapchainKHR getSwapchain() const { return swapchain_; }
+    VkImage getImage(uint32_t index) const { return images_[index]; }
+    VkSemaphore getRenderFinished(uint32_t index) const { return renderFinished_[index]; }
+
+    const std::string& getName() const { return name_; }
+    int getWidth() const { return static_cast<int>(extent_.width); }
+    int getHeight() const { return static_cast<int>(extent_.height); }
+    OutputInfo getInfo() const;
+
+private:
+    bool pickMode(const std::string& resolutionMode);
+    bool pickPlane(std::vector<uint32_t>& usedPlanes);
+    bool createSwapchain();
+    void destroySwapchain();
+
+    VulkanContext& context_;
+    VkDisplayKHR display_;
+    VkDisplayPropertiesKHR properties_;
+    std::string name_;
+    int index_;
+
+    std::vector<VkDisplayModePropertiesKHR> modes_;
+    VkDisplayModeKHR mode_ = VK_NULL_HANDLE;
+    double refreshRate_ = 0.0;
+    uint32_t plane_ = UINT32_MAX;
+    uint32_t stackIndex_ = 0;
+
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
+    VkSwapchainKHR swapchain_ = VK_NULL_HANDLE;
+    VkExtent2D extent_ = {0, 0};
+    std::vector<VkImage> images_;
+    std::vector<VkSemaphore> renderFinished_;   // Per image: the present waits on it
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VULKANOUTPUT_H
@@ -0,0 +1,298 @@
+#include "VulkanUploader.h"
+#include "VulkanContext.h"
+#include "../../utils/Logger.h"
+
+#include <cstring>
+
+namespace videocomposer {
+
+VulkanUploader::VulkanUploader(VulkanContext& context)
+    : context_(context) {
+}
+
+VulkanUploader::~VulkanUploader() {
+    cleanup();
+}
+
+bool VulkanUploader::init(VkSemaphore frameTimeline) {
+    frameTimeline_ = frameTimeline;
+    timeline_ = context_.createTimeline(0);
+    if (timeline_ == VK_NULL_HANDLE) {
+        LOG_ERROR << "VulkanUploader: Failed to create upload timeline";
+        return false;
+    }
+
+    VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = context_.getTransferFamily();
+    if (vkCreateCommandPool(context_.getDevice(), &poolInfo, nullptr, &pool_) != VK_SUCCESS) {
+        LOG_ERROR << "VulkanUploader: Failed to create transfer command pool";
+        cleanup();
+        return false;
+    }
+    return true;
+}
+
+void VulkanUploader::cleanup() {
+    VkDevice device = context_.getDevice();
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+    for (auto& layer : layers_) {
+        for (Slot& slot : layer.second.slots) {
+            destroy(slot);
+        }
+    }
+    layers_.clear();
+    if (pool_ != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device, pool_, nullptr);
+        pool_ = VK_NULL_HANDLE;
+    }
+    if (timeline_ != VK_NULL_HANDLE) {
+        vkDestroySemaphore(device, timeline_, nullptr);
+        timeline_ = VK_NULL_HANDLE;
+    }
+    value_ = 0;
+}
+
+const VulkanUploader::Image* VulkanUploader::upload(int layerId, const uint8_t* data, int width, int height,
+                                                    int stride, bool rgba, uint64_t frameValue) {
+    if (!data || width <= 0 || height <= 0 || stride < width * 4 || stride % 4 != 0 || pool_ == VK_NULL_HANDLE) {
+        return nullptr;
+    }
+    LayerImages& layer = layers_[layerId];
+    Slot& slot = layer.slots[layer.next];
+    layer.next ^= 1;
+    layer.lastFrame = frameValue;
+
+    // The staging buffer is free once its last copy completed
+    VkDeviceSize size = static_cast<VkDeviceSize>(stride) * height;
+    VkFormat format = rgba ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+    if (!context_.waitTimeline(timeline_, slot.uploadValue) || !prepare(slot, width, height, format, size)) {
+        return nullptr;
+    }
+    std::memcpy(slot.mapped, data, static_cast<size_t>(size));
+
+    VkCommandBuffer cmd = slot.cmd;
+    vkResetCommandBuffer(cmd, 0);
+    VkCommandBufferBeginInfo begin{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &begin);
+
+    // Old contents are overwritten whole
+    VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = slot.image.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    VkDependencyInfo dependency{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dependency.imageMemoryBarrierCount = 1;
+    dependency.pImageMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+
+    VkBufferImageCopy region{};
+    region.bufferRowLength = static_cast<uint32_t>(stride / 4);
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    vkCmdCopyBufferToImage(cmd, slot.staging, slot.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // Visibility to the composite comes with the timeline signal
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccessMask = VK_ACCESS_2_NONE;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier2(cmd, &dependency);
+    vkEndCommandBuffer(cmd);
+
+    // The copy waits for the composite that last read this image
+    VkSemaphoreSubmitInfo wait{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    wait.semaphore = frameTimeline_;
+    wait.value = slot.readValue;
+    wait.stageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    VkSemaphoreSubmitInfo signal{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    signal.semaphore = timeline_;
+    signal.value = value_ + 1;
+    signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    VkCommandBufferSubmitInfo cmdInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO};
+    cmdInfo.commandBuffer = cmd;
+    VkSubmitInfo2 submit{VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    submit.waitSemaphoreInfoCount = slot.readValue > 0 ? 1 : 0;
+    submit.pWaitSemaphoreInfos = &wait;
+    submit.commandBufferInfoCount = 1;
+    submit.pCommandBufferInfos = &cmdInfo;
+    submit.signalSemaphoreInfoCount = 1;
+    submit.pSignalSemaphoreInfos = &signal;
+    VkResult result = vkQueueSubmit2(context_.getTransferQueue(), 1, &submit, VK_NULL_HANDLE);
+    if (result != VK_SUCCESS) {
+        LOG_ERROR << "VulkanUploader: Transfer submit failed: " << VulkanContext::resultName(result);
+        return nullptr;
+    }
+    slot.uploadValue = ++value_;
+    slot.readValue = frameValue;
+    return &slot.image;
+}
+
+bool VulkanUploader::prepare(Slot& slot, int width, int height, VkFormat format, VkDeviceSize stagingSize) {
+    VkDevice device = context_.getDevice();
+    if (slot.image.image != VK_NULL_HANDLE &&
+        (slot.image.width != width || slot.image.height != height || slot.format != format)) {
+        release(slot);
+    }
+    if (slot.stagingSize < stagingSize && slot.staging != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, slot.staging, nullptr);
+        vkFreeMemory(device, slot.stagingMemory, nullptr);
+        slot.staging = VK_NULL_HANDLE;
+        slot.stagingMemory = VK_NULL_HANDLE;
+        slot.stagingSize = 0;
+        slot.mapped = nullptr;
+    }
+
+    if (slot.cmd == VK_NULL_HANDLE) {
+        VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocInfo.commandPool = pool_;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &slot.cmd) != VK_SUCCESS) {
+            slot.cmd = VK_NULL_HANDLE;
+            return false;
+        }
+    }
+
+    if (slot.staging == VK_NULL_HANDLE) {
+        VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        bufferInfo.size = stagingSize;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &slot.staging) != VK_SUCCESS) {
+            slot.staging = VK_NULL_HANDLE;
+            return false;
+        }
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, slot.staging, &requirements);
+        VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = context_.findMemoryType(
+            requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+            vkAllocateMemory(device, &allocInfo, nullptr, &slot.stagingMemory) != VK_SUCCESS) {
+            LOG_ERROR << "VulkanUploader: No host-visible memory for " << stagingSize << " byte staging buffer";
+            vkDestroyBuffer(device, slot.staging, nullptr);
+            slot.staging = VK_NULL_HANDLE;
+            slot.stagingMemory = VK_NULL_HANDLE;
+            return false;
+        }
+        vkBindBufferMemory(device, slot.staging, slot.stagingMemory, 0);
+        vkMapMemory(device, slot.stagingMemory, 0, VK_WHOLE_SIZE, 0, &slot.mapped);
+        slot.stagingSize = stagingSize;
+    }
+
+    if (slot.image.image == VK_NULL_HANDLE) {
+        uint32_t families[2] = {context_.getTransferFamily(), context_.getGraphicsFamily()};
+        VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = format;
+        imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        if (families[0] != families[1]) {
+            imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            imageInfo.queueFamilyIndexCount = 2;
+            imageInfo.pQueueFamilyIndices = families;
+        }
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (vkCreateImage(device, &imageInfo, nullptr, &slot.image.image) != VK_SUCCESS) {
+            slot.image.image = VK_NULL_HANDLE;
+            return false;
+        }
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, slot.image.image, &requirements);
+        VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = context_.findMemoryType(requirements.memoryTypeBits,
+                                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (allocInfo.memoryTypeIndex == UINT32_MAX ||
+            vkAllocateMemory(device, &allocInfo, nullptr, &slot.imageMemory) != VK_SUCCESS) {
+            LOG_ERROR << "VulkanUploader: No device memory for " << width << "x" << height << " image";
+            vkDestroyImage(device, slot.image.image, nullptr);
+            slot.image.image = VK_NULL_HANDLE;
+            slot.imageMemory = VK_NULL_HANDLE;
+            return false;
+        }
+        vkBindImageMemory(device, slot.image.image, slot.imageMemory, 0);
+
+        VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        viewInfo.image = slot.image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        if (vkCreateImageView(device, &viewInfo, nullptr, &slot.image.view) != VK_SUCCESS) {
+            slot.image.view = VK_NULL_HANDLE;
+            release(slot);
+            return false;
+        }
+        slot.image.width = width;
+        slot.image.height = height;
+        slot.format = format;
+    }
+    return true;
+}
+
+void VulkanUploader::release(Slot& slot) {
+    // Neither a copy nor a composite may still use it
+    context_.waitTimeline(timeline_, slot.uploadValue);
+    context_.waitTimeline(frameTimeline_, slot.readValue);
+
+    VkDevice device = context_.getDevice();
+    if (slot.image.view != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, slot.image.view, nullptr);
+    }
+    if (slot.image.image != VK_NULL_HANDLE) {
+        vkDestroyImage(device, slot.image.image, nullptr);
+    }
+    if (slot.imageMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, slot.imageMemory, nullptr);
+    }
+    slot.image = Image();
+    slot.imageMemory = VK_NULL_HANDLE;
+    slot.format = VK_FORMAT_UNDEFINED;
+}
+
+void VulkanUploader::destroy(Slot& slot) {
+    release(slot);
+    VkDevice device = context_.getDevice();
+    if (slot.staging != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, slot.staging, nullptr);
+    }
+    if (slot.stagingMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, slot.stagingMemory, nullptr);   // Unmaps
+    }
+    if (slot.cmd != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(device, pool_, 1, &slot.cmd);
+    }
+    slot = Slot();
+}
+
+void VulkanUploader::collect(uint64_t completedValue) {
+    for (auto it = layers_.begin(); it != layers_.end();) {
+        if (it->second.lastFrame + IDLE_FRAMES < completedValue) {
+            for (Slot& slot : it->second.slots) {
+                destroy(slot);
+            }
+            it = layers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,103 @@
+#ifndef VIDEOCOMPOSER_VULKANUPLOADER_H
+#define VIDEOCOMPOSER_VULKANUPLOADER_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+
+namespace videocomposer {
+
+class VulkanContext;
+
+/**
+ * VulkanUploader - CPU frames into sampled images on the transfer queue
+ *
+ * Each layer has two slots (image, persistently mapped staging buffer,
+ * command buffer), used in turn, so a frame is copied while the last
+ * one is being composited. Copies are submitted to the context's
+ * transfer queue and signal the upload timeline; the composite waits on
+ * it. A slot's copy waits on the frame timeline for the composite that
+ * last read its image, and its staging buffer is not written before its
+ * last copy has completed.
+ *
+ * Images are shared (concurrent) between the transfer and graphics
+ * families, so no ownership transfers. Packed BGRA and RGBA only.
+ */
+class VulkanUploader {
+public:
+    struct Image {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        int width = 0;
+        int height = 0;
+    };
+
+    explicit VulkanUploader(VulkanContext& context);
+    ~VulkanUploader();
+
+    VulkanUploader(const VulkanUploader&) = delete;
+    VulkanUploader& operator=(const VulkanUploader&) = delete;
+
+    /**
+     * @param frameTimeline Signalled with a frame's value when its composite completes
+     */
+    bool init(VkSemaphore frameTimeline);
+    void cleanup();
+
+    /**
+     * Copy a frame into the layer's next image
+     * @param stride Bytes per row (a multiple of 4)
+     * @param frameValue Frame timeline value of the composite reading it
+     * @return nullptr on failure
+     */
+    const Image* upload(int layerId, const uint8_t* data, int width, int height, int stride,
+                        bool rgba, uint64_t frameValue);
+
+    /** Upload timeline and the value of the last copy submitted (the composite waits on it) */
+    VkSemaphore getTimeline() const { return timeline_; }
+    uint64_t getValue() const { return value_; }
+
+    /**
+     * Free the images of layers not drawn for a while
+     * @param completedValue Frame timeline value the GPU has reached
+     */
+    void collect(uint64_t completedValue);
+
+private:
+    // Frames a layer may go without an upload before its images are freed
+    static constexpr uint64_t IDLE_FRAMES = 120;
+
+    struct Slot {
+        Image image;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+        VkBuffer staging = VK_NULL_HANDLE;
+        VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+        VkDeviceSize stagingSize = 0;
+        void* mapped = nullptr;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        uint64_t uploadValue = 0;     // Upload timeline value of its last copy
+        uint64_t readValue = 0;       // Frame timeline value of its last composite
+    };
+
+    struct LayerImages {
+        Slot slots[2];
+        int next = 0;
+        uint64_t lastFrame = 0;
+    };
+
+    bool prepare(Slot& slot, int width, int height, VkFormat format, VkDeviceSize stagingSize);
+    void release(Slot& slot);
+    void destroy(Slot& slot);
+
+    VulkanContext& context_;
+    VkSemaphore frameTimeline_ = VK_NULL_HANDLE;
+    VkSemaphore timeline_ = VK_NULL_HANDLE;
+    uint64_t value_ = 0;
+    VkCommandPool pool_ = VK_NULL_HANDLE;
+    std::map<int, LayerImages> layers_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VULKANUPLOADER_H
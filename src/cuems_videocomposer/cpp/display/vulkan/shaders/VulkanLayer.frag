@@ -0,0 +1,40 @@
+#version 450
+
+layout(push_constant) uniform Layer {
+    vec4 box;
+    vec2 canvasSize;
+    vec2 sourceSize;
+    vec4 mapX;          // x0, dxx, dxy: source x of a canvas pixel
+    vec4 mapY;          // y0, dyx, dyy
+    vec4 yuv[3];        // Rows of the YUV -> RGB matrix, offset in w
+    float opacity;
+    int isYuv;
+    vec2 texelSize;     // 1 / image size (may be padded past the source)
+} layer;
+
+layout(set = 0, binding = 0) uniform sampler2D plane0;   // RGBA, or Y
+layout(set = 0, binding = 1) uniform sampler2D plane1;   // UV
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Pixel centres at integers, as the CPU compositor's map
+    vec2 pixel = gl_FragCoord.xy - 0.5;
+    vec2 source = vec2(layer.mapX.x + layer.mapX.y * pixel.x + layer.mapX.z * pixel.y,
+                       layer.mapY.x + layer.mapY.y * pixel.x + layer.mapY.z * pixel.y);
+    if (any(lessThan(source, vec2(-0.5))) || any(greaterThan(source, layer.sourceSize - 0.5))) {
+        discard;
+    }
+    vec2 uv = (source + 0.5) * layer.texelSize;
+
+    vec4 color;
+    if (layer.isYuv != 0) {
+        vec3 yuv = vec3(texture(plane0, uv).r, texture(plane1, uv).rg);
+        color = vec4(dot(layer.yuv[0].xyz, yuv) + layer.yuv[0].w,
+                     dot(layer.yuv[1].xyz, yuv) + layer.yuv[1].w,
+                     dot(layer.yuv[2].xyz, yuv) + layer.yuv[2].w, 1.0);
+    } else {
+        color = texture(plane0, uv);
+    }
+    outColor = vec4(clamp(color.rgb, 0.0, 1.0), color.a * layer.opacity);
+}
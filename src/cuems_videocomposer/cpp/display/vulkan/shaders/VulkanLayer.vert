@@ -0,0 +1,20 @@
+#version 450
+
+// Quad over a layer's bounding box on the canvas (triangle strip of 4)
+layout(push_constant) uniform Layer {
+    vec4 box;           // x0, y0, x1, y1 in canvas pixels, y down
+    vec2 canvasSize;
+    vec2 sourceSize;
+    vec4 mapX;          // Canvas pixel -> source pixel (SoftwareCompositor::place)
+    vec4 mapY;
+    vec4 yuv[3];
+    float opacity;
+    int isYuv;
+    vec2 texelSize;     // 1 / image size (may be padded past the source)
+} layer;
+
+void main() {
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 position = mix(layer.box.xy, layer.box.zw, corner);
+    gl_Position = vec4(position / layer.canvasSize * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,226 @@
+#include "HapChunkPool.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+namespace {
+
+std::mutex instanceMutex;
+size_t initialConcurrency = 0;      // 0 = defaultConcurrency()
+HapChunkPool* sharedPool = nullptr;  // Once instance() created it
+
+} // namespace
+
+HapChunkPool& HapChunkPool::instance() {
+    static HapChunkPool pool([] {
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        return initialConcurrency;
+    }());
+    {
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        sharedPool = &pool;
+    }
+    return pool;
+}
+
+void HapChunkPool::setInitialConcurrency(size_t maxConcurrency) {
+    HapChunkPool* pool = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        initialConcurrency = maxConcurrency;
+        pool = sharedPool;
+    }
+    if (pool) {
+        pool->configure(maxConcurrency);
+    }
+}
+
+size_t HapChunkPool::defaultConcurrency() {
+    unsigned int hw = std::thread::hardware_concurrency();
+    if (hw <= 1) {
+        return 1;
+    }
+    return std::min<size_t>(hw, MAX_AUTO_CONCURRENCY);
+}
+
+HapChunkPool::HapChunkPool(size_t maxConcurrency)
+    : workerCount_(0)
+    , maxConcurrency_(0)
+    , stop_(false)
+{
+    configure(maxConcurrency);
+}
+
+HapChunkPool::~HapChunkPool() {
+    stopWorkers();
+}
+
+void HapChunkPool::configure(size_t maxConcurrency) {
+    if (maxConcurrency == 0) {
+        maxConcurrency = defaultConcurrency();
+    }
+
+    std::lock_guard<std::mutex> configLock(configMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (maxConcurrency == maxConcurrency_) {
+            return;
+        }
+    }
+    stopWorkers();
+    startWorkers(maxConcurrency - 1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    workerCount_ = workers_.size();
+    maxConcurrency_ = maxConcurrency;
+    stats_.maxConcurrency = maxConcurrency;
+    LOG_INFO << "HAP chunk pool: " << workers_.size() << " worker thread(s)";
+}
+
+void HapChunkPool::startWorkers(size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+    }
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<std::thread>(&HapChunkPool::workerThreadFunc, this));
+    }
+}
+
+void HapChunkPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        workerCount_ = 0;
+    }
+    workCond_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->joinable()) {
+            worker->join();
+        }
+    }
+    workers_.clear();
+}
+
+unsigned int HapChunkPool::runChunks(Batch& batch) {
+    unsigned int done = 0;
+    for (;;) {
+        unsigned int index = batch.next.fetch_add(1);
+        if (index >= batch.count) {
+            return done;
+        }
+        batch.function(batch.p, index);
+        done++;
+    }
+}
+
+void HapChunkPool::finishChunksLocked(Batch& batch, unsigned int done) {
+    batch.completed += done;
+    stats_.chunks += done;
+    // Fully claimed batches no longer take new workers
+    auto it = std::find(pending_.begin(), pending_.end(), &batch);
+    if (it != pending_.end() && batch.next.load() >= batch.count) {
+        pending_.erase(it);
+    }
+}
+
+HapChunkPool::Batch* HapChunkPool::pickBatchLocked() const {
+    Batch* best = nullptr;
+    for (Batch* batch : pending_) {
+        if (batch->next.load() >= batch->count) {
+            continue;
+        }
+        if (!best || batch->deadline < best->deadline) {
+            best = batch;
+        }
+    }
+    return best;
+}
+
+void HapChunkPool::run(WorkFunction function, void* p, unsigned int count,
+                       Clock::time_point deadline) {
+    if (!function || count == 0) {
+        return;
+    }
+
+    Batch batch;
+    batch.function = function;
+    batch.p = p;
+    batch.count = count;
+    batch.deadline = deadline;
+
+    bool shared = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.batches++;
+        // A single chunk is not worth waking anyone for
+        if (count > 1 && workerCount_ > 0) {
+            pending_.push_back(&batch);
+            shared = true;
+        }
+    }
+    if (shared) {
+        workCond_.notify_all();
+    }
+
+    unsigned int done = runChunks(batch);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    finishChunksLocked(batch, done);
+    // Wait for chunks claimed by workers; the batch lives on this stack
+    doneCond_.wait(lock, [&batch]() {
+        return batch.completed >= batch.count && batch.workers == 0;
+    });
+    auto it = std::find(pending_.begin(), pending_.end(), &batch);
+    if (it != pending_.end()) {
+        pending_.erase(it);
+    }
+    if (Clock::now() > deadline) {
+        stats_.lateBatches++;
+    }
+}
+
+void HapChunkPool::workerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::HAP);
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        Batch* batch = nullptr;
+        workCond_.wait(lock, [this, &batch]() {
+            batch = pickBatchLocked();
+            return stop_ || batch != nullptr;
+        });
+        if (stop_) {
+            return;
+        }
+
+        batch->workers++;
+        lock.unlock();
+        unsigned int done = runChunks(*batch);
+        lock.lock();
+        finishChunksLocked(*batch, done);
+        stats_.workerChunks += done;
+        batch->workers--;
+        doneCond_.notify_all();
+    }
+}
+
+size_t HapChunkPool::getMaxConcurrency() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxConcurrency_;
+}
+
+HapChunkPool::Stats HapChunkPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void HapChunkPool::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats();
+    stats_.maxConcurrency = maxConcurrency_;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,119 @@
+#ifndef VIDEOCOMPOSER_HAPCHUNKPOOL_H
+#define VIDEOCOMPOSER_HAPCHUNKPOOL_H
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace videocomposer {
+
+/**
+ * HapChunkPool - Process-wide worker pool for HAP Snappy chunk decompression
+ *
+ * HapDecode() hands its per-chunk work function to a callback. Every
+ * HapDecoder forwards it here instead of opening its own parallel region,
+ * so all HAP layers share one set of persistent threads and the total
+ * number of threads decompressing chunks stays capped.
+ *
+ * The calling thread always works on its own batch, so a batch completes
+ * even when every worker is busy elsewhere. Idle workers join the pending
+ * batch with the earliest deadline first.
+ */
+class HapChunkPool {
+public:
+    using Clock = std::chrono::steady_clock;
+    using WorkFunction = void (*)(void* p, unsigned int index);
+
+    struct Stats {
+        size_t maxConcurrency = 0;  // Workers + the calling thread
+        uint64_t batches = 0;       // run() calls
+        uint64_t chunks = 0;        // Chunks decompressed
+        uint64_t workerChunks = 0;  // Of which on pool workers
+        uint64_t lateBatches = 0;   // Batches finished after their deadline
+    };
+
+    /**
+     * Shared instance, created on first use: its workers only start once
+     * a HAP layer decodes
+     */
+    static HapChunkPool& instance();
+
+    /**
+     * Concurrency the shared instance is created with (0 = default);
+     * reconfigures it if it already exists
+     */
+    static void setInitialConcurrency(size_t maxConcurrency);
+
+    /**
+     * @param maxConcurrency Threads decompressing chunks of one batch,
+     *                       including the caller (1 = no workers)
+     */
+    explicit HapChunkPool(size_t maxConcurrency);
+    ~HapChunkPool();
+
+    /**
+     * Default concurrency: hardware threads, capped at MAX_AUTO_CONCURRENCY
+     * (layer decode workers compete for the same cores)
+     */
+    static size_t defaultConcurrency();
+    static constexpr size_t MAX_AUTO_CONCURRENCY = 4;
+
+    /**
+     * Change the concurrency cap. Safe while batches run: workers finish
+     * the chunks they claimed and callers drain the rest.
+     * @param maxConcurrency Threads including the caller (0 = default)
+     */
+    void configure(size_t maxConcurrency);
+
+    /**
+     * Run function(p, 0..count-1) and return when all chunks are done
+     * @param deadline When the decoded frame is needed (orders batches)
+     */
+    void run(WorkFunction function, void* p, unsigned int count,
+             Clock::time_point deadline = Clock::time_point::max());
+
+    size_t getMaxConcurrency() const;
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    struct Batch {
+        WorkFunction function = nullptr;
+        void* p = nullptr;
+        unsigned int count = 0;
+        Clock::time_point deadline;
+        std::atomic<unsigned int> next{0};
+        unsigned int completed = 0;  // Guarded by mutex_
+        unsigned int workers = 0;    // Workers inside this batch (mutex_)
+    };
+
+    void startWorkers(size_t count);
+    void stopWorkers();
+    void workerThreadFunc();
+    Batch* pickBatchLocked() const;
+    static unsigned int runChunks(Batch& batch);
+    void finishChunksLocked(Batch& batch, unsigned int done);
+
+    std::vector<std::unique_ptr<std::thread>> workers_;  // Changed under configMutex_
+    size_t workerCount_;             // Running workers (mutex_)
+    std::vector<Batch*> pending_;    // Batches with unclaimed chunks
+    size_t maxConcurrency_;
+    bool stop_;
+
+    mutable std::mutex mutex_;
+    std::mutex configMutex_;         // Serialises configure()
+    std::condition_variable workCond_;
+    std::condition_variable doneCond_;
+
+    Stats stats_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_HAPCHUNKPOOL_H
@@ -2,13 +2,21 @@
 #include "../utils/Logger.h"
 #include <cstring>
 #include <sstream>
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <algorithm>
 
 namespace videocomposer {
 
+void HapDecodeLatency::record(double ms) {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && ms >= BUCKET_LIMITS_MS[bucket]) {
+        bucket++;
+    }
+    counts[bucket]++;
+    frames++;
+    totalMs += ms;
+    maxMs = std::max(maxMs, ms);
+}
+
 HapDecoder::HapDecoder() {
 }
 
@@ -17,15 +25,42 @@ HapDecoder::~HapDecoder() {
 
 bool HapDecoder::decode(const uint8_t* packetData, size_t packetSize,
                         int width, int height,
-                        std::vector<HapDecodedTexture>& textures) {
-    if (!packetData || packetSize == 0) {
-        lastError_ = "Invalid packet data";
+                        std::vector<HapDecodedTexture>& textures,
+                        HapChunkPool::Clock::time_point deadline) {
+    auto start = HapChunkPool::Clock::now();
+    if (getLayout(packetData, packetSize, width, height, textures) == 0) {
+        return false;
+    }
+
+    // Decode each texture into its own buffer
+    std::vector<uint8_t*> outputs;
+    for (HapDecodedTexture& texture : textures) {
+        texture.data.resize(texture.size);
+        outputs.push_back(texture.data.data());
+    }
+    if (!decodeTextures(packetData, packetSize, outputs, textures, deadline)) {
+        textures.clear();
         return false;
     }
+    for (HapDecodedTexture& texture : textures) {
+        texture.data.resize(texture.size);
+    }
+
+    recordLatency(start);
+    return true;
+}
 
+size_t HapDecoder::getLayout(const uint8_t* packetData, size_t packetSize,
+                             int width, int height,
+                             std::vector<HapDecodedTexture>& textures) {
     // Clear output
     textures.clear();
 
+    if (!packetData || packetSize == 0) {
+        lastError_ = "Invalid packet data";
+        return 0;
+    }
+
     // Get texture count
     unsigned int textureCount = 0;
     unsigned int result = HapGetFrameTextureCount(packetData, packetSize, &textureCount);
@@ -33,17 +68,17 @@ bool HapDecoder::decode(const uint8_t* packetData, size_t packetSize,
         std::ostringstream oss;
         oss << "HapGetFrameTextureCount failed with code " << result;
         lastError_ = oss.str();
-        return false;
+        return 0;
     }
 
     if (textureCount == 0 || textureCount > 2) {
         std::ostringstream oss;
         oss << "Invalid texture count: " << textureCount;
         lastError_ = oss.str();
-        return false;
+        return 0;
     }
 
-    // Decode each texture
+    size_t total = 0;
     for (unsigned int i = 0; i < textureCount; i++) {
         HapDecodedTexture texture;
 
@@ -54,7 +89,8 @@ bool HapDecoder::decode(const uint8_t* packetData, size_t packetSize,
             std::ostringstream oss;
             oss << "HapGetFrameTextureFormat failed for texture " << i << " with code " << result;
             lastError_ = oss.str();
-            return false;
+            textures.clear();
+            return 0;
         }
 
         texture.format = textureFormat;
@@ -67,38 +103,111 @@ bool HapDecoder::decode(const uint8_t* packetData, size_t packetSize,
             std::ostringstream oss;
             oss << "Unknown texture format: 0x" << std::hex << textureFormat;
             lastError_ = oss.str();
+            textures.clear();
+            return 0;
+        }
+        texture.size = dxtSize;
+
+        // Textures follow each other in a shared buffer, 16-byte aligned
+        texture.offset = (total + 15) & ~static_cast<size_t>(15);
+        total = texture.offset + dxtSize;
+
+        textures.push_back(std::move(texture));
+    }
+
+    return total;
+}
+
+bool HapDecoder::decodeInto(const uint8_t* packetData, size_t packetSize,
+                            uint8_t* buffer, size_t bufferSize,
+                            std::vector<HapDecodedTexture>& textures,
+                            HapChunkPool::Clock::time_point deadline) {
+    auto start = HapChunkPool::Clock::now();
+    if (!buffer || textures.empty()) {
+        lastError_ = "No texture layout";
+        return false;
+    }
+
+    std::vector<uint8_t*> outputs;
+    for (const HapDecodedTexture& texture : textures) {
+        if (texture.offset + texture.size > bufferSize) {
+            lastError_ = "Decode buffer too small for texture layout";
             return false;
         }
+        outputs.push_back(buffer + texture.offset);
+    }
+    if (!decodeTextures(packetData, packetSize, outputs, textures, deadline)) {
+        return false;
+    }
 
-        // Allocate buffer for decompressed DXT data
-        texture.data.resize(dxtSize);
-        texture.size = dxtSize;
+    recordLatency(start);
+    return true;
+}
 
-        // Decode texture
-        unsigned long bytesUsed = 0;
-        result = HapDecode(packetData, packetSize, i,
-                          decodeCallback, nullptr,  // Single-threaded decode callback
-                          texture.data.data(), dxtSize,
-                          &bytesUsed,
-                          &textureFormat);
+bool HapDecoder::decodeTextures(const uint8_t* packetData, size_t packetSize,
+                                const std::vector<uint8_t*>& outputs,
+                                std::vector<HapDecodedTexture>& textures,
+                                HapChunkPool::Clock::time_point deadline) {
+    std::vector<TextureJob> jobs(textures.size());
+    for (unsigned int i = 0; i < textures.size(); i++) {
+        jobs[i].packetData = packetData;
+        jobs[i].packetSize = packetSize;
+        jobs[i].index = i;
+        jobs[i].output = outputs[i];
+        jobs[i].texture = &textures[i];
+        jobs[i].deadline = deadline;
+    }
 
-        if (result != HapResult_No_Error) {
+    // HAP Q Alpha: colour and alpha decompress side by side, each texture's
+    // chunks again spread over the pool (a worker may run a nested batch)
+    if (jobs.size() > 1) {
+        HapChunkPool::instance().run(runTextureJob, jobs.data(),
+                                     static_cast<unsigned int>(jobs.size()), deadline);
+    } else if (!jobs.empty()) {
+        runTextureJob(jobs.data(), 0);
+    }
+
+    for (const TextureJob& job : jobs) {
+        if (job.result != HapResult_No_Error) {
             std::ostringstream oss;
-            oss << "HapDecode failed for texture " << i << " with code " << result;
+            oss << "HapDecode failed for texture " << job.index << " with code " << job.result;
             lastError_ = oss.str();
             return false;
         }
+    }
+    return true;
+}
 
-        // Verify bytes used
-        if (bytesUsed != dxtSize) {
-            texture.size = bytesUsed;
-            texture.data.resize(bytesUsed);
-        }
-
-        textures.push_back(std::move(texture));
+void HapDecoder::runTextureJob(void* p, unsigned int index) {
+    TextureJob& job = static_cast<TextureJob*>(p)[index];
+    unsigned long bytesUsed = 0;
+    unsigned int textureFormat = job.texture->format;
+    job.result = HapDecode(job.packetData, job.packetSize, job.index,
+                           decodeCallback, &job.deadline,  // Chunks go to the shared pool
+                           job.output, job.texture->size,
+                           &bytesUsed,
+                           &textureFormat);
+
+    // Verify bytes used
+    if (job.result == HapResult_No_Error && bytesUsed != job.texture->size) {
+        job.texture->size = bytesUsed;
     }
+}
 
-    return true;
+void HapDecoder::recordLatency(HapChunkPool::Clock::time_point start) {
+    double ms = std::chrono::duration<double, std::milli>(HapChunkPool::Clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(latencyMutex_);
+    latency_.record(ms);
+}
+
+HapDecodeLatency HapDecoder::getLatency() const {
+    std::lock_guard<std::mutex> lock(latencyMutex_);
+    return latency_;
+}
+
+void HapDecoder::resetLatency() {
+    std::lock_guard<std::mutex> lock(latencyMutex_);
+    latency_ = HapDecodeLatency();
 }
 
 HapVariant HapDecoder::getVariant(const uint8_t* packetData, size_t packetSize) {
@@ -133,6 +242,9 @@ HapVariant HapDecoder::getVariant(const uint8_t* packetData, size_t packetSize)
                 return HapVariant::HAP_Q;
             case HapTextureFormat_RGBA_BPTC_UNORM:
                 return HapVariant::HAP_R;  // HAP R (BPTC/BC7 - best quality + alpha) - UNTESTED
+            case HapTextureFormat_RGB_BPTC_UNSIGNED_FLOAT:
+            case HapTextureFormat_RGB_BPTC_SIGNED_FLOAT:
+                return HapVariant::HAP_HDR;  // HAP HDR (BPTC/BC6H float RGB)
             default:
                 return HapVariant::NONE;
         }
@@ -190,7 +302,7 @@ size_t HapDecoder::calculateDXTSize(int width, int height, unsigned int format)
         case HapTextureFormat_RGBA_BPTC_UNORM:
         case HapTextureFormat_RGB_BPTC_SIGNED_FLOAT:
         case HapTextureFormat_RGB_BPTC_UNSIGNED_FLOAT:
-            // BC7/BPTC: 16 bytes per 4x4 block
+            // BC7/BC6H (BPTC): 16 bytes per 4x4 block
             // NOTE: HAP R (RGBA_BPTC_UNORM) support is UNTESTED
             return blockCount * 16;
 
@@ -202,27 +314,11 @@ size_t HapDecoder::calculateDXTSize(int width, int height, unsigned int format)
 
 void HapDecoder::decodeCallback(HapDecodeWorkFunction function, void *p,
                                 unsigned int count, void *info) {
-    // Parallel Snappy chunk decompression using OpenMP
-    // This provides ~0.3-0.6ms savings per frame for 1080p HAP
-    // 
-    // TODO: For larger performance gains with multi-layer HAP playback,
-    // implement a shared thread pool for layer-parallel decoding in LayerManager.
-    // Layer-parallel decoding can provide 6-7x speedup for 10+ simultaneous layers
-    // by decoding all layer frames in parallel before rendering.
-    // See: LayerManager::update() - could submit decode jobs to thread pool
-    
-#ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic)
-    for (unsigned int i = 0; i < count; i++) {
-        function(p, i);
-    }
-#else
-    // Fallback: sequential execution
-    for (unsigned int i = 0; i < count; i++) {
-        function(p, i);
-    }
-#endif
+    // Parallel Snappy chunk decompression on the process-wide pool, shared
+    // by all HAP layers so concurrent decodes do not oversubscribe cores
+    auto deadline = info ? *static_cast<const HapChunkPool::Clock::time_point*>(info)
+                         : HapChunkPool::Clock::time_point::max();
+    HapChunkPool::instance().run(function, p, count, deadline);
 }
 
 } // namespace videocomposer
-
@@ -5,6 +5,8 @@
 #include <cstddef>
 #include <string>
 #include <vector>
+#include <mutex>
+#include "HapChunkPool.h"
 #include "../video/GPUTextureFrameBuffer.h"
 
 extern "C" {
@@ -19,11 +21,29 @@ namespace videocomposer {
  * Decoded texture information
  */
 struct HapDecodedTexture {
-    std::vector<uint8_t> data;      // DXT compressed data
+    std::vector<uint8_t> data;      // DXT compressed data (empty after decodeInto())
     unsigned int format;             // HapTextureFormat enum value
     size_t size;                     // Size in bytes
     int width;                       // Texture width
     int height;                      // Texture height
+    size_t offset = 0;               // Position in the decodeInto() buffer
+};
+
+/**
+ * Decode latency histogram (one per decoder, i.e. per layer)
+ */
+struct HapDecodeLatency {
+    static constexpr int BUCKETS = 7;
+    // Upper bounds in ms of all but the last bucket (last = slower)
+    static constexpr double BUCKET_LIMITS_MS[BUCKETS - 1] = {1.0, 2.0, 4.0, 8.0, 16.0, 33.0};
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t frames = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+
+    void record(double ms);
+    double averageMs() const { return frames > 0 ? totalMs / frames : 0.0; }
 };
 
 /**
@@ -31,6 +51,8 @@ struct HapDecodedTexture {
  * 
  * Provides convenient methods to decode HAP frames from packets.
  * Handles all HAP variants: HAP, HAP Q, HAP Alpha, HAP Q Alpha.
+ * Snappy chunks are decompressed on the shared HapChunkPool, and the
+ * two textures of HAP Q Alpha are decoded concurrently.
  */
 class HapDecoder {
 public:
@@ -44,11 +66,34 @@ public:
      * @param width Frame width (for validation)
      * @param height Frame height (for validation)
      * @param textures Output vector to receive decoded textures (1 or 2)
+     * @param deadline When the frame is needed (chunk pool priority)
      * @return true on success, false on error
      */
     bool decode(const uint8_t* packetData, size_t packetSize,
                 int width, int height,
-                std::vector<HapDecodedTexture>& textures);
+                std::vector<HapDecodedTexture>& textures,
+                HapChunkPool::Clock::time_point deadline = HapChunkPool::Clock::time_point::max());
+
+    /**
+     * Work out where each texture of a frame goes for decodeInto()
+     * @param textures Receives format, maximum size and offset per texture
+     * @return Buffer size needed for the whole frame, 0 on error
+     */
+    size_t getLayout(const uint8_t* packetData, size_t packetSize,
+                     int width, int height,
+                     std::vector<HapDecodedTexture>& textures);
+
+    /**
+     * Decode a HAP frame into caller memory (e.g. a mapped upload buffer),
+     * skipping the per-texture vectors of decode()
+     * @param buffer Destination, at least getLayout() bytes
+     * @param textures Layout from getLayout(); sizes are updated to the bytes written
+     * @return true on success, false on error
+     */
+    bool decodeInto(const uint8_t* packetData, size_t packetSize,
+                    uint8_t* buffer, size_t bufferSize,
+                    std::vector<HapDecodedTexture>& textures,
+                    HapChunkPool::Clock::time_point deadline = HapChunkPool::Clock::time_point::max());
 
     /**
      * Get the HAP variant from packet data (without decoding)
@@ -72,6 +117,12 @@ public:
      */
     const std::string& getLastError() const { return lastError_; }
 
+    /**
+     * Latency of successful decode() calls (thread-safe)
+     */
+    HapDecodeLatency getLatency() const;
+    void resetLatency();
+
 private:
     /**
      * Calculate expected DXT buffer size based on dimensions and format
@@ -79,12 +130,40 @@ private:
     static size_t calculateDXTSize(int width, int height, unsigned int format);
 
     /**
-     * Decode callback for multithreaded decoding (not used for now)
+     * One texture of a frame, decoded on whichever pool thread picks it up
+     */
+    struct TextureJob {
+        const uint8_t* packetData = nullptr;
+        size_t packetSize = 0;
+        unsigned int index = 0;
+        uint8_t* output = nullptr;
+        HapDecodedTexture* texture = nullptr;
+        HapChunkPool::Clock::time_point deadline;
+        unsigned int result = HapResult_No_Error;
+    };
+
+    /**
+     * Decode all textures of a frame, in parallel when there are two
+     * @param outputs Destination of each texture
+     */
+    bool decodeTextures(const uint8_t* packetData, size_t packetSize,
+                        const std::vector<uint8_t*>& outputs,
+                        std::vector<HapDecodedTexture>& textures,
+                        HapChunkPool::Clock::time_point deadline);
+    static void runTextureJob(void* p, unsigned int index);
+    void recordLatency(HapChunkPool::Clock::time_point start);
+
+    /**
+     * Decode callback: runs the chunks on the shared chunk pool
+     * @param info Pointer to the frame deadline (HapChunkPool::Clock::time_point)
      */
     static void decodeCallback(HapDecodeWorkFunction function, void *p, 
                                unsigned int count, void *info);
 
     std::string lastError_;
+    
+    mutable std::mutex latencyMutex_;
+    HapDecodeLatency latency_;
 };
 
 } // namespace videocomposer
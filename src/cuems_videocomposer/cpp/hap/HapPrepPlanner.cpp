@@ -0,0 +1,110 @@
+#include "HapPrepPlanner.h"
+#include "../layer/LoadAdmission.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace videocomposer {
+
+HapPrepPlanner::Plan HapPrepPlanner::plan(const Machine& machine, const Source& source, Format requested,
+                                          bool highQuality) {
+    Plan plan;
+    Format format = requested;
+    if (format == Format::AUTO) {
+        if (source.alpha) {
+            format = highQuality && machine.bptc ? Format::HAP_R : Format::HAP_ALPHA;
+        } else {
+            format = highQuality ? Format::HAP_Q : Format::HAP;
+        }
+    }
+    if (format == Format::HAP_R && !machine.bptc) {
+        format = source.alpha ? Format::HAP_ALPHA : Format::HAP_Q;
+        plan.reason = "no BPTC on this GPU, HAP R replaced; ";
+    }
+    if (source.alpha && (format == Format::HAP || format == Format::HAP_Q)) {
+        plan.reason += "alpha dropped; ";
+    }
+    plan.format = format;
+
+    size_t threads = std::max<size_t>(machine.chunkThreads, 1);
+    plan.textureBytes = textureBytes(format, source.width, source.height);
+    plan.chunks = chooseChunks(plan.textureBytes, threads);
+
+    // The benchmark clips have BENCH_CHUNKS chunks: their cost is that much parallel work
+    LoadAdmission defaults;
+    const LoadAdmission& costs = machine.costs ? *machine.costs : defaults;
+    double megapixels = static_cast<double>(source.width) * source.height / 1e6;
+    double serialSeconds = costs.getDecodeCost(codecName(format), false) * megapixels *
+                           static_cast<double>(std::min<size_t>(BENCH_CHUNKS, threads));
+    double decodeSeconds = serialSeconds / static_cast<double>(std::min<size_t>(plan.chunks, threads));
+    double framerate = source.framerate > 0.0 ? source.framerate : 25.0;
+    int layers = std::max(machine.layers, 1);
+    plan.rawBytesPerSecond = static_cast<double>(plan.textureBytes) * framerate * layers;
+    plan.decodeMs = decodeSeconds * 1000.0;
+
+    char text[160];
+    bool slowSnappy = decodeSeconds * layers > SNAPPY_FRAME_SHARE / framerate;
+    bool diskCarriesRaw = machine.storageBytesPerSecond > 0.0 &&
+                          plan.rawBytesPerSecond <= machine.storageBytesPerSecond * STORAGE_HEADROOM;
+    if (slowSnappy && diskCarriesRaw) {
+        plan.snappy = false;
+        plan.decodeMs = 0.0;
+        plan.chunks = 1;   // An uncompressed frame is one copy, chunks buy nothing
+        std::snprintf(text, sizeof(text), "Snappy would take %.1f ms of each %.1f ms frame, the disk reads raw textures",
+                      decodeSeconds * layers * 1000.0, 1000.0 / framerate);
+    } else if (machine.storageBytesPerSecond > 0.0 && !diskCarriesRaw) {
+        std::snprintf(text, sizeof(text), "Snappy, %.0f MB/s of raw textures is more than the disk reads",
+                      plan.rawBytesPerSecond / 1e6);
+    } else {
+        std::snprintf(text, sizeof(text), "Snappy, %.1f ms per frame on %d chunk(s)", plan.decodeMs, plan.chunks);
+    }
+    plan.reason += text;
+    return plan;
+}
+
+size_t HapPrepPlanner::textureBytes(Format format, int width, int height) {
+    size_t blocks = static_cast<size_t>((std::max(width, 0) + 3) / 4) * static_cast<size_t>((std::max(height, 0) + 3) / 4);
+    return blocks * (format == Format::HAP ? 8 : 16);
+}
+
+int HapPrepPlanner::chooseChunks(size_t textureBytes, size_t threads) {
+    size_t target = std::min<size_t>(threads, MAX_CHUNKS);
+    target = std::min(target, std::max<size_t>(textureBytes / MIN_CHUNK_BYTES, 1));
+    for (size_t chunks = std::max<size_t>(target, 1); chunks > 1; --chunks) {
+        if (textureBytes % chunks == 0) {
+            return static_cast<int>(chunks);
+        }
+    }
+    return 1;
+}
+
+const char* HapPrepPlanner::formatName(Format format) {
+    switch (format) {
+        case Format::HAP_ALPHA: return "hap_alpha";
+        case Format::HAP_Q: return "hap_q";
+        case Format::HAP_R: return "hap_r";
+        case Format::AUTO: return "auto";
+        default: return "hap";
+    }
+}
+
+const char* HapPrepPlanner::codecName(Format format) {
+    switch (format) {
+        case Format::HAP_Q: return "HAP_Q";
+        // HAP R has HAP Alpha's 16 bytes per block; the benchmarks have no HAP R clips
+        case Format::HAP_ALPHA:
+        case Format::HAP_R: return "HAP_ALPHA";
+        default: return "HAP";
+    }
+}
+
+bool HapPrepPlanner::parseFormat(const std::string& name, Format& format) {
+    for (Format candidate : {Format::AUTO, Format::HAP, Format::HAP_ALPHA, Format::HAP_Q, Format::HAP_R}) {
+        if (name == formatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace videocomposer
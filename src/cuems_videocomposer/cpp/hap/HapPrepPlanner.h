@@ -0,0 +1,94 @@
+#ifndef VIDEOCOMPOSER_HAPPREPPLANNER_H
+#define VIDEOCOMPOSER_HAPPREPPLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace videocomposer {
+
+class LoadAdmission;
+
+/**
+ * HapPrepPlanner - HAP encoding settings for the machine a show plays on
+ *
+ * HAP decode cost is Snappy decompression, run as one job per chunk on
+ * the HapChunkPool: a single-chunk file decodes on one thread however
+ * many the pool has. The planner picks the variant, the chunk count (one
+ * per pool thread, none smaller than MIN_CHUNK_BYTES) and whether Snappy
+ * pays off at all: when decompressing would take a large share of the
+ * frame period and the storage carries the raw textures, the file is
+ * written uncompressed. Decode costs are LoadAdmission's, i.e. this
+ * machine's benchmark results where there are some.
+ *
+ * Used by cuems-videocomposer-prep; it only decides, the tool encodes.
+ */
+class HapPrepPlanner {
+public:
+    enum class Format {
+        AUTO,       // From the source's alpha and the quality asked for
+        HAP,        // DXT1
+        HAP_ALPHA,  // DXT5
+        HAP_Q,      // DXT5 YCoCg
+        HAP_R       // BPTC (BC7), needs GPU support
+    };
+
+    struct Machine {
+        size_t chunkThreads = 1;               // HapChunkPool concurrency (hap_threads)
+        bool bptc = false;                     // GPU samples BPTC textures
+        double storageBytesPerSecond = 0.0;    // Sustained read rate of the media disk (0 = unknown)
+        int layers = 1;                        // HAP layers expected to play at once
+        const LoadAdmission* costs = nullptr;  // Decode costs (nullptr = built-in)
+    };
+
+    struct Source {
+        int width = 0;
+        int height = 0;
+        double framerate = 25.0;
+        bool alpha = false;
+    };
+
+    struct Plan {
+        Format format = Format::HAP;
+        int chunks = 1;
+        bool snappy = true;
+        size_t textureBytes = 0;          // One frame, uncompressed
+        double decodeMs = 0.0;            // Predicted Snappy time per frame (0 without Snappy)
+        double rawBytesPerSecond = 0.0;   // Reading raw textures for all layers
+        std::string reason;
+    };
+
+    static constexpr int MAX_CHUNKS = 64;                 // FFmpeg's HAP encoder
+    static constexpr size_t MIN_CHUNK_BYTES = 64 * 1024;  // Below this a job costs more than it saves
+    static constexpr int BENCH_CHUNKS = 4;                // Chunks of the benchmark media
+    static constexpr double SNAPPY_FRAME_SHARE = 0.25;    // Decode time per frame period worth avoiding
+    static constexpr double STORAGE_HEADROOM = 0.7;       // Share of the disk raw textures may need
+
+    /**
+     * @param requested Format to write (AUTO: HAP, HAP Q when highQuality,
+     *                  HAP Alpha, or HAP R for high-quality alpha on BPTC GPUs)
+     */
+    static Plan plan(const Machine& machine, const Source& source, Format requested, bool highQuality);
+
+    /** Bytes of one frame's texture(s) */
+    static size_t textureBytes(Format format, int width, int height);
+
+    /**
+     * Chunks for a texture: one per thread, fewer when they would get
+     * small, and a count that divides the texture evenly
+     */
+    static int chooseChunks(size_t textureBytes, size_t threads);
+
+    /** FFmpeg HAP encoder "format" value */
+    static const char* formatName(Format format);
+
+    /** LoadAdmission codec name */
+    static const char* codecName(Format format);
+
+    /** "auto", "hap", "hap_alpha", "hap_q" or "hap_r"; false if unknown */
+    static bool parseFormat(const std::string& name, Format& format);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_HAPPREPPLANNER_H
@@ -0,0 +1,168 @@
+#include "HapUploadRing.h"
+#include "../utils/Logger.h"
+#include <GL/glew.h>  // Must be included before GL/gl.h
+#include <GL/gl.h>
+
+namespace videocomposer {
+
+namespace {
+// A slot is three frames old when reused; only a stalled GPU waits this long
+constexpr GLuint64 FENCE_TIMEOUT_NS = 20000000;  // 20 ms
+}
+
+HapUploadRing::HapUploadRing()
+    : current_(-1)
+    , next_(0)
+    , initialized_(false)
+    , available_(false)
+    , persistent_(false)
+    , persistentFailed_(false)
+{
+    for (int i = 0; i < SLOTS; ++i) {
+        buffers_[i] = 0;
+        mapped_[i] = nullptr;
+        capacity_[i] = 0;
+        fences_[i] = nullptr;
+    }
+}
+
+HapUploadRing::~HapUploadRing() {
+    release();
+}
+
+bool HapUploadRing::init() {
+    initialized_ = true;
+    available_ = GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range;
+    persistent_ = available_ && !persistentFailed_ && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+    if (!available_) {
+        LOG_INFO << "HAP upload ring: mapped buffers not supported, uploading from client memory";
+        return false;
+    }
+    glGenBuffers(SLOTS, buffers_);
+    LOG_VERBOSE << "HAP upload ring: " << (persistent_ ? "persistent mapped buffers" : "mapped PBOs");
+    return true;
+}
+
+bool HapUploadRing::allocatePersistent(int slot, size_t size) {
+    // Immutable storage cannot grow: replace the buffer
+    if (mapped_[slot]) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[slot]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        mapped_[slot] = nullptr;
+    }
+    glDeleteBuffers(1, &buffers_[slot]);
+    glGenBuffers(1, &buffers_[slot]);
+    capacity_[slot] = 0;
+
+    // Snappy reads back earlier output for matches, so ask for a readable
+    // (cached) mapping rather than write-combined memory
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[slot]);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+    mapped_[slot] = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!mapped_[slot]) {
+        return false;
+    }
+    capacity_[slot] = size;
+    return true;
+}
+
+uint8_t* HapUploadRing::map(size_t size) {
+    if (!initialized_ && !init()) {
+        return nullptr;
+    }
+    if (!available_ || size == 0 || current_ >= 0) {
+        return nullptr;
+    }
+
+    int slot = next_;
+    if (persistent_) {
+        // Wait until the GPU has consumed this slot's previous frame
+        if (fences_[slot]) {
+            GLenum status = glClientWaitSync(fences_[slot], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                return nullptr;
+            }
+            glDeleteSync(fences_[slot]);
+            fences_[slot] = nullptr;
+        }
+        if (capacity_[slot] < size && !allocatePersistent(slot, size)) {
+            // Driver advertises buffer storage but cannot map it - stop trying
+            LOG_WARNING << "HAP upload ring: persistent mapping failed, using mapped PBOs";
+            release();
+            persistentFailed_ = true;
+            return nullptr;
+        }
+        current_ = slot;
+        return mapped_[slot];
+    }
+
+    // PBO mode: orphan the storage, so the map never waits for the GPU
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[slot]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void* memory = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                    GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!memory) {
+        return nullptr;
+    }
+    capacity_[slot] = size;
+    current_ = slot;
+    return static_cast<uint8_t*>(memory);
+}
+
+bool HapUploadRing::unmap() {
+    if (current_ < 0) {
+        return false;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[current_]);
+    if (persistent_) {
+        return true;  // Coherent mapping: writes are already visible
+    }
+    // Storage can be lost while mapped (e.g. display mode change)
+    return glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+}
+
+void HapUploadRing::fence() {
+    if (current_ < 0) {
+        return;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (persistent_) {
+        fences_[current_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    next_ = (current_ + 1) % SLOTS;
+    current_ = -1;
+}
+
+void HapUploadRing::release() {
+    if (!initialized_) {
+        return;
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        if (fences_[i]) {
+            glDeleteSync(fences_[i]);
+            fences_[i] = nullptr;
+        }
+        if (mapped_[i] || (!persistent_ && i == current_)) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[i]);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            mapped_[i] = nullptr;
+        }
+        capacity_[i] = 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(SLOTS, buffers_);
+    for (int i = 0; i < SLOTS; ++i) {
+        buffers_[i] = 0;
+    }
+    current_ = -1;
+    next_ = 0;
+    initialized_ = false;
+    available_ = false;
+    persistent_ = false;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,78 @@
+#ifndef VIDEOCOMPOSER_HAPUPLOADRING_H
+#define VIDEOCOMPOSER_HAPUPLOADRING_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Forward declaration for OpenGL types
+typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
+
+namespace videocomposer {
+
+/**
+ * HapUploadRing - Pixel unpack buffers that HAP frames are decompressed into
+ *
+ * HapDecoder::decodeInto() writes the DXT data straight into a mapped
+ * buffer and the compressed texture upload is sourced from it, so the
+ * frame never passes through client memory:
+ *
+ *   map() -> decode -> unmap() -> upload with buffer offsets -> fence()
+ *
+ * With GL 4.4 / ARB_buffer_storage the slots are persistently mapped and
+ * guarded by fences. Otherwise each frame orphans and maps a plain PBO.
+ * All methods need the GL context of the textures (render thread).
+ */
+class HapUploadRing {
+public:
+    static constexpr int SLOTS = 3;
+
+    HapUploadRing();
+    ~HapUploadRing();
+
+    /**
+     * Map the next slot for writing
+     * @param size Bytes needed for the frame
+     * @return Destination memory, or nullptr (decode to client memory instead)
+     */
+    uint8_t* map(size_t size);
+
+    /**
+     * Finish writing the mapped slot and bind it as GL_PIXEL_UNPACK_BUFFER;
+     * texture uploads then take offsets into the slot
+     * @return false if the contents were lost (skip the upload)
+     */
+    bool unmap();
+
+    /**
+     * Unbind the slot and mark it in use by the uploads issued since
+     * unmap(). Also call after a failed decode or unmap().
+     */
+    void fence();
+
+    /**
+     * Delete the GL buffers
+     */
+    void release();
+
+    bool isPersistent() const { return persistent_; }
+
+private:
+    bool init();
+    bool allocatePersistent(int slot, size_t size);
+
+    GLuint buffers_[SLOTS];
+    uint8_t* mapped_[SLOTS];      // Persistent mappings (nullptr in PBO mode)
+    size_t capacity_[SLOTS];
+    GLsync fences_[SLOTS];
+    int current_;                 // Slot being written (-1 = none)
+    int next_;
+    bool initialized_;
+    bool available_;              // GL supports mapped unpack buffers
+    bool persistent_;
+    bool persistentFailed_;       // Driver could not map persistently - PBO mode for good
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_HAPUPLOADRING_H
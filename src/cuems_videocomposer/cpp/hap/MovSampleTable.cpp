@@ -0,0 +1,371 @@
+#include "MovSampleTable.h"
+#include "../utils/Logger.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr uint32_t fourcc(char a, char b, char c, char d) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(a)) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(d));
+}
+
+uint32_t readU32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t readU64(const uint8_t* p) {
+    return (static_cast<uint64_t>(readU32(p)) << 32) | readU32(p + 4);
+}
+
+// Table boxes: version/flags, then a 32-bit entry count
+bool readEntryCount(const uint8_t* payload, size_t size, size_t headerSize,
+                    size_t entrySize, uint32_t& count) {
+    if (size < headerSize) {
+        return false;
+    }
+    count = readU32(payload + headerSize - 4);
+    return (size - headerSize) / entrySize >= count;
+}
+
+} // namespace
+
+MovSampleTable::MovSampleTable()
+    : data_(nullptr)
+    , mappedSize_(0)
+    , base_(nullptr)
+    , baseSize_(0)
+{
+}
+
+MovSampleTable::~MovSampleTable() {
+    close();
+}
+
+bool MovSampleTable::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file referenced
+    if (mapping == MAP_FAILED) {
+        LOG_WARNING << "HAP: could not map " << path << ", using libavformat packet reader";
+        return false;
+    }
+
+    data_ = static_cast<uint8_t*>(mapping);
+    mappedSize_ = static_cast<size_t>(st.st_size);
+    if (!parse(data_, mappedSize_)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MovSampleTable::close() {
+    if (data_) {
+        munmap(data_, mappedSize_);
+        data_ = nullptr;
+        mappedSize_ = 0;
+    }
+    base_ = nullptr;
+    baseSize_ = 0;
+    offsets_.clear();
+    sizes_.clear();
+}
+
+const uint8_t* MovSampleTable::packet(int64_t frameNumber, size_t& size) const {
+    if (!base_ || frameNumber < 0 || frameNumber >= getSampleCount()) {
+        return nullptr;
+    }
+    size = sizes_[frameNumber];
+    return base_ + offsets_[frameNumber];
+}
+
+void MovSampleTable::prefetch(int64_t frameNumber) const {
+    if (!data_ || frameNumber < 0 || frameNumber >= getSampleCount()) {
+        return;
+    }
+    // madvise() wants a page-aligned start
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = offsets_[frameNumber] & ~(pageSize - 1);
+    size_t length = offsets_[frameNumber] + sizes_[frameNumber] - start;
+    madvise(data_ + start, length, MADV_WILLNEED);
+}
+
+bool MovSampleTable::nextBox(const uint8_t*& cursor, const uint8_t* end, Box& box) {
+    size_t remaining = static_cast<size_t>(end - cursor);
+    if (remaining < 8) {
+        return false;
+    }
+    uint64_t boxSize = readU32(cursor);
+    box.type = readU32(cursor + 4);
+    size_t header = 8;
+    if (boxSize == 1) {
+        if (remaining < 16) {
+            return false;
+        }
+        boxSize = readU64(cursor + 8);
+        header = 16;
+    } else if (boxSize == 0) {
+        boxSize = remaining;  // Extends to the end of the file/parent
+    }
+    if (boxSize < header || boxSize > remaining) {
+        return false;
+    }
+    box.payload = cursor + header;
+    box.size = static_cast<size_t>(boxSize) - header;
+    cursor += boxSize;
+    return true;
+}
+
+bool MovSampleTable::parse(const uint8_t* data, size_t size) {
+    base_ = nullptr;
+    baseSize_ = 0;
+    offsets_.clear();
+    sizes_.clear();
+
+    const uint8_t* cursor = data;
+    const uint8_t* end = data + size;
+    Box box;
+    while (nextBox(cursor, end, box)) {
+        if (box.type != fourcc('m', 'o', 'o', 'v')) {
+            continue;
+        }
+        const uint8_t* trakCursor = box.payload;
+        const uint8_t* moovEnd = box.payload + box.size;
+        Box trak;
+        while (nextBox(trakCursor, moovEnd, trak)) {
+            if (trak.type != fourcc('t', 'r', 'a', 'k')) {
+                continue;
+            }
+            Track track;
+            if (!parseContainer(trak.payload, trak.size, track) || !track.video || !track.hap) {
+                continue;
+            }
+            if (!track.constantDuration || track.editShift) {
+                LOG_VERBOSE << "HAP: track timing is not one sample per frame, using libavformat packet reader";
+                return false;
+            }
+            base_ = data;
+            baseSize_ = size;
+            if (!buildIndex(track)) {
+                base_ = nullptr;
+                baseSize_ = 0;
+                offsets_.clear();
+                sizes_.clear();
+                return false;
+            }
+            return true;
+        }
+        return false;  // Only one moov per file
+    }
+    return false;
+}
+
+bool MovSampleTable::parseContainer(const uint8_t* data, size_t size, Track& track) {
+    const uint8_t* cursor = data;
+    const uint8_t* end = data + size;
+    Box box;
+    while (nextBox(cursor, end, box)) {
+        switch (box.type) {
+            case fourcc('m', 'd', 'i', 'a'):
+            case fourcc('m', 'i', 'n', 'f'):
+            case fourcc('s', 't', 'b', 'l'):
+            case fourcc('e', 'd', 't', 's'):
+                if (!parseContainer(box.payload, box.size, track)) {
+                    return false;
+                }
+                break;
+            default:
+                if (!parseLeaf(box, track)) {
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+bool MovSampleTable::parseLeaf(const Box& box, Track& track) {
+    const uint8_t* p = box.payload;
+    uint32_t count = 0;
+
+    switch (box.type) {
+        case fourcc('h', 'd', 'l', 'r'):
+            // MP4 handler_type / QuickTime component subtype (the minf data
+            // handler has 'alis' or 'url ' here)
+            if (box.size >= 12 && readU32(p + 8) == fourcc('v', 'i', 'd', 'e')) {
+                track.video = true;
+            }
+            return true;
+
+        case fourcc('s', 't', 's', 'd'):
+            // First sample description: size, then the codec fourcc
+            if (box.size >= 16) {
+                uint32_t format = readU32(p + 12);
+                track.hap = (format >> 8) == (fourcc('H', 'a', 'p', 0) >> 8);
+            }
+            return true;
+
+        case fourcc('s', 't', 't', 's'):
+            if (!readEntryCount(p, box.size, 8, 8, count)) {
+                return false;
+            }
+            // Runs of equal deltas may still be split across entries
+            for (uint32_t i = 1; i < count; ++i) {
+                if (readU32(p + 12 + i * 8) != readU32(p + 12)) {
+                    track.constantDuration = false;
+                }
+            }
+            return true;
+
+        case fourcc('e', 'l', 's', 't'): {
+            bool version1 = box.size > 0 && p[0] == 1;
+            size_t entrySize = version1 ? 20 : 12;
+            if (!readEntryCount(p, box.size, 8, entrySize, count)) {
+                return false;
+            }
+            if (count > 1) {
+                track.editShift = true;
+            } else if (count == 1) {
+                const uint8_t* entry = p + 8;
+                uint64_t mediaTime = version1 ? readU64(entry + 8) : readU32(entry + 4);
+                track.editShift = mediaTime != 0;
+            }
+            return true;
+        }
+
+        case fourcc('s', 't', 's', 'z'): {
+            if (box.size < 12) {
+                return false;
+            }
+            uint32_t uniformSize = readU32(p + 4);
+            count = readU32(p + 8);
+            if (uniformSize != 0) {
+                track.sampleSizes.assign(count, uniformSize);
+                return true;
+            }
+            if ((box.size - 12) / 4 < count) {
+                return false;
+            }
+            track.sampleSizes.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                track.sampleSizes[i] = readU32(p + 12 + i * 4);
+            }
+            return true;
+        }
+
+        case fourcc('s', 't', 'z', '2'): {
+            if (box.size < 12) {
+                return false;
+            }
+            unsigned int fieldBits = p[7];
+            count = readU32(p + 8);
+            if ((fieldBits != 4 && fieldBits != 8 && fieldBits != 16) ||
+                (box.size - 12) * 8 / fieldBits < count) {
+                return false;
+            }
+            track.sampleSizes.resize(count);
+            const uint8_t* entries = p + 12;
+            for (uint32_t i = 0; i < count; ++i) {
+                if (fieldBits == 16) {
+                    track.sampleSizes[i] = (static_cast<uint32_t>(entries[i * 2]) << 8) | entries[i * 2 + 1];
+                } else if (fieldBits == 8) {
+                    track.sampleSizes[i] = entries[i];
+                } else {
+                    uint8_t pair = entries[i / 2];
+                    track.sampleSizes[i] = (i % 2 == 0) ? (pair >> 4) : (pair & 0x0f);
+                }
+            }
+            return true;
+        }
+
+        case fourcc('s', 't', 'c', 'o'):
+            if (!readEntryCount(p, box.size, 8, 4, count)) {
+                return false;
+            }
+            track.chunkOffsets.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                track.chunkOffsets[i] = readU32(p + 8 + i * 4);
+            }
+            return true;
+
+        case fourcc('c', 'o', '6', '4'):
+            if (!readEntryCount(p, box.size, 8, 8, count)) {
+                return false;
+            }
+            track.chunkOffsets.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                track.chunkOffsets[i] = readU64(p + 8 + i * 8);
+            }
+            return true;
+
+        case fourcc('s', 't', 's', 'c'):
+            if (!readEntryCount(p, box.size, 8, 12, count)) {
+                return false;
+            }
+            track.stscFirstChunk.resize(count);
+            track.stscSamplesPerChunk.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                track.stscFirstChunk[i] = readU32(p + 8 + i * 12);
+                track.stscSamplesPerChunk[i] = readU32(p + 12 + i * 12);
+            }
+            return true;
+
+        default:
+            return true;  // Not needed for the index
+    }
+}
+
+bool MovSampleTable::buildIndex(const Track& track) {
+    const size_t sampleCount = track.sampleSizes.size();
+    if (sampleCount == 0 || track.chunkOffsets.empty() || track.stscFirstChunk.empty()) {
+        return false;  // Fragmented or empty track
+    }
+
+    offsets_.resize(sampleCount);
+    sizes_ = track.sampleSizes;
+
+    size_t sample = 0;
+    for (size_t entry = 0; entry < track.stscFirstChunk.size() && sample < sampleCount; ++entry) {
+        // Chunk numbers are 1-based; each run extends to the next entry's first chunk
+        uint64_t firstChunk = track.stscFirstChunk[entry];
+        uint64_t lastChunk = (entry + 1 < track.stscFirstChunk.size())
+            ? track.stscFirstChunk[entry + 1]
+            : track.chunkOffsets.size() + 1;
+        if (firstChunk == 0 || lastChunk < firstChunk || lastChunk > track.chunkOffsets.size() + 1) {
+            return false;
+        }
+        for (uint64_t chunk = firstChunk; chunk < lastChunk && sample < sampleCount; ++chunk) {
+            uint64_t offset = track.chunkOffsets[chunk - 1];
+            for (uint32_t i = 0; i < track.stscSamplesPerChunk[entry] && sample < sampleCount; ++i) {
+                if (offset > baseSize_ || sizes_[sample] > baseSize_ - offset) {
+                    LOG_WARNING << "HAP: sample " << sample << " lies outside the file";
+                    return false;
+                }
+                offsets_[sample] = offset;
+                offset += sizes_[sample];
+                sample++;
+            }
+        }
+    }
+    return sample == sampleCount;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,96 @@
+#ifndef VIDEOCOMPOSER_MOVSAMPLETABLE_H
+#define VIDEOCOMPOSER_MOVSAMPLETABLE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace videocomposer {
+
+/**
+ * MovSampleTable - Memory-mapped packet access for HAP in QuickTime/MOV
+ *
+ * Parses the sample table (stsz/stz2, stco/co64, stsc) of the HAP video
+ * track once and maps the whole file, so any frame's packet is a pointer
+ * lookup: no demuxer state, no seek, and reverse playback or scrubbing
+ * costs the same as playing forward.
+ *
+ * Only files where sample N is frame N are accepted (constant sample
+ * duration, no edit list shift); anything else is left to libavformat.
+ * The file must not be truncated while it is mapped.
+ */
+class MovSampleTable {
+public:
+    MovSampleTable();
+    ~MovSampleTable();
+
+    MovSampleTable(const MovSampleTable&) = delete;
+    MovSampleTable& operator=(const MovSampleTable&) = delete;
+
+    /**
+     * Map the file and index the HAP video track
+     * @return false if the file is not a MOV with a usable HAP track
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+
+    /**
+     * Number of video samples (frames)
+     */
+    int64_t getSampleCount() const { return static_cast<int64_t>(sizes_.size()); }
+
+    /**
+     * Packet of a frame, pointing into the mapped file
+     * @param size Set to the packet size
+     * @return Packet data, or nullptr if the frame is out of range
+     */
+    const uint8_t* packet(int64_t frameNumber, size_t& size) const;
+
+    /**
+     * Ask the kernel to start reading a frame's packet in the background
+     */
+    void prefetch(int64_t frameNumber) const;
+
+    /**
+     * Index a MOV already in memory (used by open(); exposed for tests)
+     */
+    bool parse(const uint8_t* data, size_t size);
+
+private:
+    struct Box {
+        uint32_t type;
+        const uint8_t* payload;
+        size_t size;      // Payload size
+    };
+
+    struct Track {
+        bool video = false;
+        bool hap = false;
+        bool constantDuration = true;
+        bool editShift = false;
+        std::vector<uint64_t> chunkOffsets;
+        std::vector<uint32_t> sampleSizes;
+        std::vector<uint32_t> stscFirstChunk;
+        std::vector<uint32_t> stscSamplesPerChunk;
+    };
+
+    static bool nextBox(const uint8_t*& cursor, const uint8_t* end, Box& box);
+    bool parseContainer(const uint8_t* data, size_t size, Track& track);
+    bool parseLeaf(const Box& box, Track& track);
+    bool buildIndex(const Track& track);
+
+    uint8_t* data_;          // Mapped file (nullptr when closed)
+    size_t mappedSize_;
+    const uint8_t* base_;    // File contents (mapping or parse() buffer)
+    size_t baseSize_;
+    std::vector<uint64_t> offsets_;
+    std::vector<uint32_t> sizes_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_MOVSAMPLETABLE_H
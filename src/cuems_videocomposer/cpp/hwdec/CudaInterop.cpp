@@ -0,0 +1,244 @@
+#ifdef HAVE_CUDA_INTEROP
+
+#include "CudaInterop.h"
+#include "../utils/Logger.h"
+
+// Include GLEW before GL for proper initialization
+#ifdef HAVE_GLEW
+#include <GL/glew.h>
+#endif
+#include <GL/gl.h>
+
+// ffnvcodec must come before hwcontext_cuda.h (it provides the CUDA types)
+#include <ffnvcodec/dynlink_loader.h>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+#include <libavutil/hwcontext_cuda.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace videocomposer {
+
+CudaInterop::CudaInterop()
+    : cu_(nullptr)
+    , deviceRef_(nullptr)
+    , textureY_(0)
+    , textureUV_(0)
+    , resourceY_(nullptr)
+    , resourceUV_(nullptr)
+    , width_(0)
+    , height_(0)
+    , heldFrame_(nullptr)
+{
+}
+
+CudaInterop::~CudaInterop() {
+    if (heldFrame_) {
+        av_frame_free(&heldFrame_);
+    }
+    releaseTextures();
+    if (cu_) {
+        cuda_free_functions(&cu_);
+    }
+}
+
+bool CudaInterop::init() {
+    if (cu_) {
+        return true;
+    }
+    if (cuda_load_functions(&cu_, nullptr) < 0) {
+        LOG_WARNING << "CudaInterop: Failed to load CUDA driver functions";
+        cu_ = nullptr;
+        return false;
+    }
+    heldFrame_ = av_frame_alloc();
+    if (!heldFrame_) {
+        cuda_free_functions(&cu_);
+        return false;
+    }
+    LOG_INFO << "CudaInterop initialized (CUDA-GL texture interop)";
+    return true;
+}
+
+bool CudaInterop::check(int result, const char* what) const {
+    if (result == CUDA_SUCCESS) {
+        return true;
+    }
+    const char* name = nullptr;
+    cu_->cuGetErrorName(static_cast<CUresult>(result), &name);
+    LOG_WARNING << "CudaInterop: " << what << " failed: " << (name ? name : "unknown error");
+    return false;
+}
+
+bool CudaInterop::ensureTextures(AVFrame* cudaFrame) {
+    AVHWFramesContext* framesCtx = (AVHWFramesContext*)cudaFrame->hw_frames_ctx->data;
+
+    if (deviceRef_ && deviceRef_->data == framesCtx->device_ref->data &&
+        width_ == cudaFrame->width && height_ == cudaFrame->height) {
+        return true;
+    }
+    releaseTextures();
+
+    deviceRef_ = av_buffer_ref(framesCtx->device_ref);
+    if (!deviceRef_) {
+        return false;
+    }
+    AVCUDADeviceContext* cudaDevCtx = (AVCUDADeviceContext*)framesCtx->device_ctx->hwctx;
+    if (!check(cu_->cuCtxPushCurrent(cudaDevCtx->cuda_ctx), "cuCtxPushCurrent")) {
+        releaseTextures();
+        return false;
+    }
+
+    int width = cudaFrame->width;
+    int height = cudaFrame->height;
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+
+    glGenTextures(1, &textureY_);
+    glGenTextures(1, &textureUV_);
+    bool ok = textureY_ != 0 && textureUV_ != 0;
+    if (ok) {
+        glBindTexture(GL_TEXTURE_2D, textureY_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+        glBindTexture(GL_TEXTURE_2D, textureUV_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, chromaWidth, chromaHeight, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // The whole texture is overwritten every frame
+        ok = check(cu_->cuGraphicsGLRegisterImage(&resourceY_, textureY_, GL_TEXTURE_2D,
+                                                  CU_GRAPHICS_REGISTER_FLAGS_WRITE_DISCARD),
+                   "cuGraphicsGLRegisterImage (Y)") &&
+             check(cu_->cuGraphicsGLRegisterImage(&resourceUV_, textureUV_, GL_TEXTURE_2D,
+                                                  CU_GRAPHICS_REGISTER_FLAGS_WRITE_DISCARD),
+                   "cuGraphicsGLRegisterImage (UV)");
+    }
+
+    CUcontext dummy;
+    cu_->cuCtxPopCurrent(&dummy);
+
+    if (!ok) {
+        releaseTextures();
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    LOG_INFO << "CudaInterop: Registered " << width << "x" << height << " NV12 textures with CUDA";
+    return true;
+}
+
+void CudaInterop::releaseTextures() {
+    if (deviceRef_ && (resourceY_ || resourceUV_)) {
+        AVHWDeviceContext* deviceCtx = (AVHWDeviceContext*)deviceRef_->data;
+        AVCUDADeviceContext* cudaDevCtx = (AVCUDADeviceContext*)deviceCtx->hwctx;
+        if (cu_->cuCtxPushCurrent(cudaDevCtx->cuda_ctx) == CUDA_SUCCESS) {
+            if (resourceY_) {
+                cu_->cuGraphicsUnregisterResource(resourceY_);
+            }
+            if (resourceUV_) {
+                cu_->cuGraphicsUnregisterResource(resourceUV_);
+            }
+            CUcontext dummy;
+            cu_->cuCtxPopCurrent(&dummy);
+        }
+    }
+    resourceY_ = nullptr;
+    resourceUV_ = nullptr;
+    av_buffer_unref(&deviceRef_);
+
+    if (textureY_ != 0) {
+        glDeleteTextures(1, &textureY_);
+        textureY_ = 0;
+    }
+    if (textureUV_ != 0) {
+        glDeleteTextures(1, &textureUV_);
+        textureUV_ = 0;
+    }
+    width_ = 0;
+    height_ = 0;
+}
+
+bool CudaInterop::importFrame(AVFrame* cudaFrame, GLuint& texY, GLuint& texUV) {
+    if (!cu_ || !cudaFrame || cudaFrame->format != AV_PIX_FMT_CUDA || !cudaFrame->hw_frames_ctx) {
+        return false;
+    }
+
+    AVHWFramesContext* framesCtx = (AVHWFramesContext*)cudaFrame->hw_frames_ctx->data;
+    if (framesCtx->sw_format != AV_PIX_FMT_NV12) {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            LOG_WARNING << "CudaInterop: " << av_get_pix_fmt_name(framesCtx->sw_format)
+                        << " frames are not supported, using CPU copy";
+        }
+        return false;
+    }
+
+    if (!ensureTextures(cudaFrame)) {
+        return false;
+    }
+
+    AVCUDADeviceContext* cudaDevCtx = (AVCUDADeviceContext*)framesCtx->device_ctx->hwctx;
+    CUstream stream = cudaDevCtx->stream;
+    if (!check(cu_->cuCtxPushCurrent(cudaDevCtx->cuda_ctx), "cuCtxPushCurrent")) {
+        return false;
+    }
+
+    // Mapping waits (on the GPU) for GL to finish sampling the previous frame
+    CUgraphicsResource resources[2] = { resourceY_, resourceUV_ };
+    bool ok = check(cu_->cuGraphicsMapResources(2, resources, stream), "cuGraphicsMapResources");
+    if (ok) {
+        CUarray arrays[2] = { nullptr, nullptr };
+        ok = check(cu_->cuGraphicsSubResourceGetMappedArray(&arrays[0], resourceY_, 0, 0),
+                   "cuGraphicsSubResourceGetMappedArray (Y)") &&
+             check(cu_->cuGraphicsSubResourceGetMappedArray(&arrays[1], resourceUV_, 0, 0),
+                   "cuGraphicsSubResourceGetMappedArray (UV)");
+
+        for (int plane = 0; ok && plane < 2; ++plane) {
+            CUDA_MEMCPY2D copy = {};
+            copy.srcMemoryType = CU_MEMORYTYPE_DEVICE;
+            copy.srcDevice = (CUdeviceptr)cudaFrame->data[plane];
+            copy.srcPitch = cudaFrame->linesize[plane];
+            copy.dstMemoryType = CU_MEMORYTYPE_ARRAY;
+            copy.dstArray = arrays[plane];
+            // UV plane: half height, interleaved U/V bytes
+            copy.WidthInBytes = plane == 0 ? width_ : ((width_ + 1) / 2) * 2;
+            copy.Height = plane == 0 ? height_ : (height_ + 1) / 2;
+            ok = check(cu_->cuMemcpy2DAsync(&copy, stream), "cuMemcpy2DAsync");
+        }
+
+        // Unmapping orders the copies before subsequent GL work
+        cu_->cuGraphicsUnmapResources(2, resources, stream);
+    }
+
+    CUcontext dummy;
+    cu_->cuCtxPopCurrent(&dummy);
+
+    if (!ok) {
+        return false;
+    }
+
+    // Keep the source buffer out of the pool until the copy has surely run
+    av_frame_unref(heldFrame_);
+    if (av_frame_ref(heldFrame_, cudaFrame) < 0) {
+        LOG_WARNING << "CudaInterop: Failed to ref frame";
+    }
+
+    texY = textureY_;
+    texUV = textureUV_;
+    return true;
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_CUDA_INTEROP
@@ -0,0 +1,85 @@
+#ifndef VIDEOCOMPOSER_CUDAINTEROP_H
+#define VIDEOCOMPOSER_CUDAINTEROP_H
+
+#ifdef HAVE_CUDA_INTEROP
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/buffer.h>
+}
+
+// GL types - minimal definitions to avoid GLEW conflicts
+typedef unsigned int GLuint;
+
+// CUDA types from ffnvcodec (the full headers are only included in the .cpp)
+struct CudaFunctions;
+struct CUgraphicsResource_st;
+
+namespace videocomposer {
+
+/**
+ * CudaInterop - Zero-copy NVDEC (AV_PIX_FMT_CUDA) to OpenGL texture interop
+ *
+ * Keeps one pair of R8 (Y) / RG8 (UV) textures registered with CUDA
+ * (cuGraphicsGLRegisterImage). Each frame is copied device-to-device from
+ * the decoder's CUDA buffer into the mapped textures on the decoder's
+ * stream, so it never leaves VRAM; unmapping orders the copy before the
+ * GL draws that sample it, without a CPU wait.
+ *
+ * The result uses the same NV12 texture contract as VaapiInterop
+ * (GPUTextureFrameBuffer::setExternalNV12Textures). libcuda is loaded at
+ * runtime through the ffnvcodec loader. Only NV12 frames are imported;
+ * other software formats (P010, ...) fall back to the CPU copy path.
+ *
+ * All methods must be called from the GL thread.
+ */
+class CudaInterop {
+public:
+    CudaInterop();
+    ~CudaInterop();
+
+    CudaInterop(const CudaInterop&) = delete;
+    CudaInterop& operator=(const CudaInterop&) = delete;
+
+    /**
+     * Load the CUDA driver functions
+     * @return false if libcuda is not available
+     */
+    bool init();
+
+    bool isAvailable() const { return cu_ != nullptr; }
+
+    /**
+     * Copy a CUDA frame into the interop textures
+     * @param cudaFrame AVFrame with format AV_PIX_FMT_CUDA and NV12 sw_format
+     * @param texY Output: OpenGL texture ID for Y plane
+     * @param texUV Output: OpenGL texture ID for UV plane
+     * @return true if the textures hold the frame
+     */
+    bool importFrame(AVFrame* cudaFrame, GLuint& texY, GLuint& texUV);
+
+private:
+    bool ensureTextures(AVFrame* cudaFrame);
+    void releaseTextures();
+    bool check(int result, const char* what) const;
+
+    CudaFunctions* cu_;
+
+    // Device the textures are registered with (referenced so its CUDA context outlives them)
+    AVBufferRef* deviceRef_;
+    GLuint textureY_;
+    GLuint textureUV_;
+    CUgraphicsResource_st* resourceY_;
+    CUgraphicsResource_st* resourceUV_;
+    int width_;
+    int height_;
+
+    // Last imported frame, kept until the next import so its buffer isn't
+    // reused while the asynchronous copy is still pending
+    AVFrame* heldFrame_;
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_CUDA_INTEROP
+#endif // VIDEOCOMPOSER_CUDAINTEROP_H
@@ -0,0 +1,215 @@
+#ifdef HAVE_V4L2_INTEROP
+
+#include "V4L2Interop.h"
+#include "../utils/Logger.h"
+
+// Include GLEW before GL for proper initialization
+#ifdef HAVE_GLEW
+#include <GL/glew.h>
+#endif
+#include <GL/gl.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <drm_fourcc.h>
+
+// EGL extension constants for DMA-BUF import
+#ifndef EGL_LINUX_DMA_BUF_EXT
+#define EGL_LINUX_DMA_BUF_EXT             0x3270
+#endif
+#ifndef EGL_LINUX_DRM_FOURCC_EXT
+#define EGL_LINUX_DRM_FOURCC_EXT          0x3271
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_FD_EXT
+#define EGL_DMA_BUF_PLANE0_FD_EXT         0x3272
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_OFFSET_EXT
+#define EGL_DMA_BUF_PLANE0_OFFSET_EXT     0x3273
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_PITCH_EXT
+#define EGL_DMA_BUF_PLANE0_PITCH_EXT      0x3274
+#endif
+
+namespace videocomposer {
+
+V4L2Interop::V4L2Interop()
+    : eglDisplay_(EGL_NO_DISPLAY)
+    , eglCreateImageKHR_(nullptr)
+    , eglDestroyImageKHR_(nullptr)
+    , glEGLImageTargetTexture2DOES_(nullptr)
+    , glEGLImageTargetTexStorageEXT_(nullptr)
+    , isDesktopGL_(false)
+    , initialized_(false)
+{
+}
+
+V4L2Interop::~V4L2Interop() {
+    clear();
+}
+
+bool V4L2Interop::init(DisplayBackend* display) {
+    if (!display) {
+        LOG_ERROR << "V4L2Interop: DisplayBackend is null";
+        return false;
+    }
+
+    eglDisplay_ = display->getEGLDisplay();
+    if (eglDisplay_ == EGL_NO_DISPLAY) {
+        LOG_WARNING << "V4L2Interop: No EGL display";
+        return false;
+    }
+
+    eglCreateImageKHR_ = display->getEglCreateImageKHR();
+    eglDestroyImageKHR_ = display->getEglDestroyImageKHR();
+    glEGLImageTargetTexture2DOES_ = display->getGlEGLImageTargetTexture2DOES();
+    glEGLImageTargetTexStorageEXT_ = display->getGlEGLImageTargetTexStorageEXT();
+    isDesktopGL_ = display->isDesktopGL();
+
+    if (!eglCreateImageKHR_ || !eglDestroyImageKHR_ ||
+        (!glEGLImageTargetTexStorageEXT_ && !glEGLImageTargetTexture2DOES_)) {
+        LOG_WARNING << "V4L2Interop: Missing EGL image extension functions";
+        return false;
+    }
+
+    initialized_ = true;
+    LOG_INFO << "V4L2Interop initialized (V4L2 → DMA-BUF → EGL image)";
+    return true;
+}
+
+bool V4L2Interop::importBuffer(int index, int fd, PixelFormat format, int width, int height,
+                               uint32_t bytesPerLine, GLuint textures[2]) {
+    if (!initialized_ || fd < 0) {
+        return false;
+    }
+
+    auto it = cache_.find(index);
+    if (it != cache_.end() && (it->second.fd != fd || it->second.format != format ||
+                               it->second.width != width || it->second.height != height)) {
+        destroyImport(it->second);
+        cache_.erase(it);
+        it = cache_.end();
+    }
+    if (it == cache_.end()) {
+        Import import;
+        if (!createImport(fd, format, width, height, bytesPerLine, import)) {
+            destroyImport(import);
+            return false;
+        }
+        it = cache_.emplace(index, import).first;
+    }
+
+    textures[0] = it->second.textures[0];
+    textures[1] = it->second.textures[1];
+    return true;
+}
+
+bool V4L2Interop::createImport(int fd, PixelFormat format, int width, int height, uint32_t bytesPerLine,
+                               Import& import) {
+    import.fd = fd;
+    import.format = format;
+    import.width = width;
+    import.height = height;
+
+    if (format == PixelFormat::NV12) {
+        // Single-planar NV12: the UV plane follows the luma rows
+        uint32_t uvOffset = bytesPerLine * static_cast<uint32_t>(height);
+        import.images[0] = createImage(fd, DRM_FORMAT_R8, width, height, 0, bytesPerLine);
+        import.images[1] = createImage(fd, DRM_FORMAT_GR88, width / 2, height / 2, uvOffset, bytesPerLine);
+        return import.images[0] != EGL_NO_IMAGE_KHR && import.images[1] != EGL_NO_IMAGE_KHR &&
+               bindTexture(import.textures[0], import.images[0]) &&
+               bindTexture(import.textures[1], import.images[1]);
+    }
+    if (format == PixelFormat::UYVY422 || format == PixelFormat::YUYV422) {
+        // One RGBA texel per macropixel, bytes in memory order
+        import.images[0] = createImage(fd, DRM_FORMAT_ABGR8888, width / 2, height, 0, bytesPerLine);
+        return import.images[0] != EGL_NO_IMAGE_KHR && bindTexture(import.textures[0], import.images[0]);
+    }
+
+    LOG_WARNING << "V4L2Interop: Unsupported capture format";
+    return false;
+}
+
+EGLImageKHR V4L2Interop::createImage(int fd, uint32_t fourcc, int width, int height,
+                                     uint32_t offset, uint32_t pitch) {
+    // Capture buffers are linear: no modifier
+    EGLint attribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_LINUX_DRM_FOURCC_EXT, (EGLint)fourcc,
+        EGL_DMA_BUF_PLANE0_FD_EXT, fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)offset,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, (EGLint)pitch,
+        EGL_NONE
+    };
+
+    // Must match the current GL context's display
+    EGLDisplay currentDisplay = eglGetCurrentDisplay();
+    if (currentDisplay == EGL_NO_DISPLAY) {
+        currentDisplay = eglDisplay_;
+    }
+    EGLImageKHR image = eglCreateImageKHR_(currentDisplay, EGL_NO_CONTEXT,
+                                           EGL_LINUX_DMA_BUF_EXT, nullptr, attribs);
+    if (image == EGL_NO_IMAGE_KHR) {
+        EGLint error = eglGetError();
+        LOG_WARNING << "V4L2Interop: eglCreateImageKHR failed (error=0x" << std::hex << error << std::dec << ")";
+    }
+    return image;
+}
+
+bool V4L2Interop::bindTexture(GLuint& texture, EGLImageKHR image) {
+    glGenTextures(1, &texture);
+    if (texture == 0) {
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // TexStorageEXT on Desktop GL, Texture2DOES on ES (same choice as VaapiInterop)
+    bool bound = false;
+    if (isDesktopGL_ && glEGLImageTargetTexStorageEXT_) {
+        glEGLImageTargetTexStorageEXT_(GL_TEXTURE_2D, image, nullptr);
+        bound = glGetError() == GL_NO_ERROR;
+    }
+    if (!bound && glEGLImageTargetTexture2DOES_) {
+        glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, image);
+        bound = glGetError() == GL_NO_ERROR;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!bound) {
+        LOG_WARNING << "V4L2Interop: Failed to bind EGL image to texture";
+    }
+    return bound;
+}
+
+void V4L2Interop::destroyImport(Import& import) {
+    for (int i = 0; i < 2; ++i) {
+        if (import.textures[i] != 0) {
+            glDeleteTextures(1, &import.textures[i]);
+        }
+    }
+    EGLDisplay currentDisplay = eglGetCurrentDisplay();
+    if (currentDisplay == EGL_NO_DISPLAY) {
+        currentDisplay = eglDisplay_;
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (import.images[i] != EGL_NO_IMAGE_KHR) {
+            eglDestroyImageKHR_(currentDisplay, import.images[i]);
+        }
+    }
+    import = Import();
+}
+
+void V4L2Interop::clear() {
+    for (auto& entry : cache_) {
+        destroyImport(entry.second);
+    }
+    cache_.clear();
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_V4L2_INTEROP
@@ -0,0 +1,103 @@
+#ifndef VIDEOCOMPOSER_V4L2INTEROP_H
+#define VIDEOCOMPOSER_V4L2INTEROP_H
+
+#ifdef HAVE_V4L2_INTEROP
+
+// EGL typedefs and extension function types
+#include "../display/DisplayBackend.h"
+#include "../video/FrameFormat.h"
+#include <cstdint>
+#include <unordered_map>
+
+// GL types - minimal definitions to avoid GLEW conflicts
+typedef unsigned int GLuint;
+
+namespace videocomposer {
+
+/**
+ * V4L2Interop - Zero-copy V4L2 capture buffer to OpenGL texture interop
+ *
+ * Pipeline:
+ *   V4L2 MMAP buffer → VIDIOC_EXPBUF (DMA-BUF) → EGL Image → OpenGL Texture
+ *
+ * Uses the same EGL DMA-BUF import as VaapiInterop. NV12 buffers are
+ * imported as R8 + GR88 images of the one DMA-BUF and follow the NV12
+ * texture contract (GPUTextureFrameBuffer::setExternalNV12Textures);
+ * packed 4:2:2 (UYVY, YUYV) buffers become one half-width ABGR8888 image
+ * for the renderer's UYVY shader.
+ *
+ * A capture device cycles through a fixed set of buffers, so each one is
+ * imported once and its images and textures are cached by buffer index
+ * until clear(). The caller keeps the DMA-BUF fds open and must not hand
+ * a buffer back to the driver while the GPU may still sample it.
+ *
+ * All methods must be called from the GL thread.
+ */
+class V4L2Interop {
+public:
+    V4L2Interop();
+    ~V4L2Interop();
+
+    V4L2Interop(const V4L2Interop&) = delete;
+    V4L2Interop& operator=(const V4L2Interop&) = delete;
+
+    /**
+     * Initialize with DisplayBackend (gets EGL display and extension functions)
+     * @return true if EGL DMA-BUF import is available
+     */
+    bool init(DisplayBackend* display);
+    bool isAvailable() const { return initialized_; }
+
+    /**
+     * Textures showing one capture buffer
+     * @param index Buffer index (cache key)
+     * @param fd DMA-BUF of the buffer
+     * @param format NV12, UYVY422 or YUYV422
+     * @param bytesPerLine Row pitch (of the luma plane for NV12)
+     * @param textures Output: packed texture, or Y and UV textures for NV12
+     * @return false if the buffer cannot be imported
+     */
+    bool importBuffer(int index, int fd, PixelFormat format, int width, int height,
+                      uint32_t bytesPerLine, GLuint textures[2]);
+
+    /**
+     * Destroy every cached import (buffers reallocated or device closed)
+     */
+    void clear();
+
+private:
+    // Images and textures of one capture buffer
+    struct Import {
+        int fd = -1;
+        PixelFormat format = PixelFormat::NV12;
+        int width = 0;
+        int height = 0;
+        EGLImageKHR images[2] = {nullptr, nullptr};
+        GLuint textures[2] = {0, 0};
+    };
+
+    bool createImport(int fd, PixelFormat format, int width, int height, uint32_t bytesPerLine,
+                      Import& import);
+    EGLImageKHR createImage(int fd, uint32_t fourcc, int width, int height,
+                            uint32_t offset, uint32_t pitch);
+
+    // Create a texture and bind it to an EGL image
+    bool bindTexture(GLuint& texture, EGLImageKHR image);
+
+    void destroyImport(Import& import);
+
+    EGLDisplay eglDisplay_;
+    PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR_;
+    PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR_;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES_;
+    PFNGLEGLIMAGETARGETTEXSTORAGEEXTPROC glEGLImageTargetTexStorageEXT_;
+    bool isDesktopGL_;
+    bool initialized_;
+
+    std::unordered_map<int, Import> cache_;
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_V4L2_INTEROP
+#endif // VIDEOCOMPOSER_V4L2INTEROP_H
@@ -0,0 +1,300 @@
+#ifdef HAVE_VAAPI_INTEROP
+
+#include "VaapiDeinterlacer.h"
+#include "../utils/Logger.h"
+#include "../utils/FrameTracer.h"
+#include "../video/MemoryBudget.h"
+
+#include <cstring>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixfmt.h>
+}
+
+#ifndef VA_RT_FORMAT_YUV420_10
+#define VA_RT_FORMAT_YUV420_10 VA_RT_FORMAT_YUV420_10BPP
+#endif
+
+namespace videocomposer {
+
+namespace {
+
+// More past frames than this is a filter for offline use
+constexpr unsigned int MAX_FORWARD_REFERENCES = 4;
+
+const char* algorithmName(VAProcDeinterlacingType algorithm) {
+    switch (algorithm) {
+        case VAProcDeinterlacingMotionAdaptive: return "motion adaptive";
+        case VAProcDeinterlacingMotionCompensated: return "motion compensated";
+        case VAProcDeinterlacingBob: return "bob";
+        default: return "other";
+    }
+}
+
+} // namespace
+
+VaapiDeinterlacer::VaapiDeinterlacer()
+    : display_(nullptr)
+    , config_(VA_INVALID_ID)
+    , context_(VA_INVALID_ID)
+    , nextSurface_(0)
+    , width_(0)
+    , height_(0)
+    , rtFormat_(0)
+    , algorithm_(VAProcDeinterlacingBob)
+    , algorithmBob_(false)
+    , algorithmChosen_(false)
+    , forwardReferences_(0)
+    , reference_(nullptr)
+    , failed_(false)
+    , chargedBytes_(0)
+{
+    for (VASurfaceID& surface : surfaces_) {
+        surface = VA_INVALID_ID;
+    }
+}
+
+VaapiDeinterlacer::~VaapiDeinterlacer() {
+    reset();
+    av_frame_free(&reference_);
+}
+
+void VaapiDeinterlacer::reset() {
+    if (reference_) {
+        av_frame_unref(reference_);
+    }
+    if (display_) {
+        if (context_ != VA_INVALID_ID) {
+            vaDestroyContext(display_, context_);
+        }
+        if (surfaces_[0] != VA_INVALID_ID) {
+            vaDestroySurfaces(display_, surfaces_, OUTPUT_SURFACES);
+        }
+        if (config_ != VA_INVALID_ID) {
+            vaDestroyConfig(display_, config_);
+        }
+    }
+    for (VASurfaceID& surface : surfaces_) {
+        surface = VA_INVALID_ID;
+    }
+    if (chargedBytes_ > 0) {
+        MemoryBudget::instance().release(budgetAccount_, chargedBytes_);
+        chargedBytes_ = 0;
+    }
+    display_ = nullptr;
+    config_ = VA_INVALID_ID;
+    context_ = VA_INVALID_ID;
+    nextSurface_ = 0;
+    width_ = 0;
+    height_ = 0;
+    rtFormat_ = 0;
+    algorithmChosen_ = false;
+    forwardReferences_ = 0;
+    failed_ = false;
+}
+
+bool VaapiDeinterlacer::setup(VADisplay display, int width, int height, unsigned int rtFormat,
+                              unsigned int fourcc) {
+    display_ = display;
+    if (vaCreateConfig(display, VAProfileNone, VAEntrypointVideoProc, nullptr, 0, &config_) != VA_STATUS_SUCCESS) {
+        config_ = VA_INVALID_ID;
+        LOG_INFO << "VaapiDeinterlacer: No video processing entrypoint, deinterlacing in the shader";
+        return false;
+    }
+
+    // Output in the decoder's layout, so the surfaces import the same way
+    VASurfaceAttrib attrib;
+    memset(&attrib, 0, sizeof(attrib));
+    attrib.type = VASurfaceAttribPixelFormat;
+    attrib.flags = VA_SURFACE_ATTRIB_SETTABLE;
+    attrib.value.type = VAGenericValueTypeInteger;
+    attrib.value.value.i = static_cast<int>(fourcc);
+    if (vaCreateSurfaces(display, rtFormat, width, height, surfaces_, OUTPUT_SURFACES, &attrib, 1) !=
+        VA_STATUS_SUCCESS) {
+        surfaces_[0] = VA_INVALID_ID;
+        LOG_WARNING << "VaapiDeinterlacer: Failed to create " << width << "x" << height << " output surfaces";
+        return false;
+    }
+    // 4:2:0, 8 or 16 bits a sample
+    budgetAccount_ = MemoryBudget::resolve(MemoryBudget::Account(MemoryBudget::Subsystem::DECODE_SURFACES));
+    chargedBytes_ = static_cast<size_t>(width) * height * (fourcc == VA_FOURCC_P010 ? 6 : 3) / 2 * OUTPUT_SURFACES;
+    MemoryBudget::instance().charge(budgetAccount_, chargedBytes_);
+    if (vaCreateContext(display, config_, width, height, VA_PROGRESSIVE, surfaces_, OUTPUT_SURFACES,
+                        &context_) != VA_STATUS_SUCCESS) {
+        context_ = VA_INVALID_ID;
+        LOG_WARNING << "VaapiDeinterlacer: Failed to create the video processing context";
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    rtFormat_ = rtFormat;
+    return true;
+}
+
+bool VaapiDeinterlacer::chooseAlgorithm(bool bob) {
+    VAProcFilterCapDeinterlacing caps[VAProcDeinterlacingCount];
+    unsigned int count = VAProcDeinterlacingCount;
+    if (vaQueryVideoProcFilterCaps(display_, context_, VAProcFilterDeinterlacing, caps, &count) !=
+            VA_STATUS_SUCCESS || count == 0) {
+        LOG_INFO << "VaapiDeinterlacer: Driver has no deinterlacing filter, deinterlacing in the shader";
+        return false;
+    }
+
+    const VAProcDeinterlacingType adaptive[] = {VAProcDeinterlacingMotionAdaptive,
+                                                VAProcDeinterlacingMotionCompensated, VAProcDeinterlacingBob};
+    const VAProcDeinterlacingType bobOnly[] = {VAProcDeinterlacingBob};
+    const VAProcDeinterlacingType* candidates = bob ? bobOnly : adaptive;
+    size_t candidateCount = bob ? 1 : 3;
+
+    for (size_t i = 0; i < candidateCount; ++i) {
+        bool supported = false;
+        for (unsigned int c = 0; c < count; ++c) {
+            supported = supported || caps[c].type == candidates[i];
+        }
+        if (!supported) {
+            continue;
+        }
+
+        // References the filter needs: future frames would delay the output
+        VAProcFilterParameterBufferDeinterlacing params;
+        memset(&params, 0, sizeof(params));
+        params.type = VAProcFilterDeinterlacing;
+        params.algorithm = candidates[i];
+        VABufferID filter;
+        if (vaCreateBuffer(display_, context_, VAProcFilterParameterBufferType, sizeof(params), 1, &params,
+                           &filter) != VA_STATUS_SUCCESS) {
+            continue;
+        }
+        VAProcPipelineCaps pipelineCaps;
+        memset(&pipelineCaps, 0, sizeof(pipelineCaps));
+        VAStatus status = vaQueryVideoProcPipelineCaps(display_, context_, &filter, 1, &pipelineCaps);
+        vaDestroyBuffer(display_, filter);
+        if (status != VA_STATUS_SUCCESS || pipelineCaps.num_backward_references > 0 ||
+            pipelineCaps.num_forward_references > MAX_FORWARD_REFERENCES) {
+            continue;
+        }
+
+        algorithm_ = candidates[i];
+        algorithmBob_ = bob;
+        algorithmChosen_ = true;
+        forwardReferences_ = pipelineCaps.num_forward_references;
+        LOG_INFO << "VaapiDeinterlacer: " << algorithmName(algorithm_) << " deinterlacing on the video engine ("
+                 << width_ << "x" << height_ << ", " << forwardReferences_ << " reference(s))";
+        return true;
+    }
+    LOG_INFO << "VaapiDeinterlacer: No usable deinterlacing algorithm, deinterlacing in the shader";
+    return false;
+}
+
+bool VaapiDeinterlacer::renderField(VASurfaceID input, VASurfaceID output, uint32_t flags) {
+    VAProcFilterParameterBufferDeinterlacing params;
+    memset(&params, 0, sizeof(params));
+    params.type = VAProcFilterDeinterlacing;
+    params.algorithm = algorithm_;
+    params.flags = flags;
+    VABufferID filter;
+    if (vaCreateBuffer(display_, context_, VAProcFilterParameterBufferType, sizeof(params), 1, &params,
+                       &filter) != VA_STATUS_SUCCESS) {
+        return false;
+    }
+
+    // The previous frame (this one again at the start of a stream)
+    VASurfaceID references[MAX_FORWARD_REFERENCES];
+    VASurfaceID previous = reference_ && reference_->buf[0] ? (VASurfaceID)(uintptr_t)reference_->data[3] : input;
+    for (unsigned int i = 0; i < forwardReferences_; ++i) {
+        references[i] = previous;
+    }
+
+    VAProcPipelineParameterBuffer pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.surface = input;
+    pipeline.filter_flags = VA_FRAME_PICTURE;
+    pipeline.filters = &filter;
+    pipeline.num_filters = 1;
+    pipeline.forward_references = forwardReferences_ > 0 ? references : nullptr;
+    pipeline.num_forward_references = forwardReferences_;
+
+    VABufferID pipelineBuffer;
+    bool ok = vaCreateBuffer(display_, context_, VAProcPipelineParameterBufferType, sizeof(pipeline), 1,
+                             &pipeline, &pipelineBuffer) == VA_STATUS_SUCCESS;
+    if (ok) {
+        ok = vaBeginPicture(display_, context_, output) == VA_STATUS_SUCCESS;
+        if (ok) {
+            ok = vaRenderPicture(display_, context_, &pipelineBuffer, 1) == VA_STATUS_SUCCESS;
+            ok = vaEndPicture(display_, context_) == VA_STATUS_SUCCESS && ok;
+        }
+        vaDestroyBuffer(display_, pipelineBuffer);
+    }
+    vaDestroyBuffer(display_, filter);
+    return ok;
+}
+
+bool VaapiDeinterlacer::process(VADisplay display, const AVFrame* frame, FieldOrder order, bool bob,
+                                VASurfaceID fields[2]) {
+    FRAME_TRACE_SCOPE("vaapi.deinterlace");
+    if (failed_ || !frame || !frame->hw_frames_ctx || order == FieldOrder::PROGRESSIVE) {
+        return false;
+    }
+    const AVHWFramesContext* framesCtx = reinterpret_cast<const AVHWFramesContext*>(frame->hw_frames_ctx->data);
+    unsigned int rtFormat;
+    unsigned int fourcc;
+    if (framesCtx->sw_format == AV_PIX_FMT_NV12) {
+        rtFormat = VA_RT_FORMAT_YUV420;
+        fourcc = VA_FOURCC_NV12;
+    } else if (framesCtx->sw_format == AV_PIX_FMT_P010) {
+        rtFormat = VA_RT_FORMAT_YUV420_10;
+        fourcc = VA_FOURCC_P010;
+    } else {
+        return false;  // Imported as decoded, the shader deinterlaces
+    }
+
+    if (display != display_ || frame->width != width_ || frame->height != height_ || rtFormat != rtFormat_) {
+        reset();
+        if (!setup(display, frame->width, frame->height, rtFormat, fourcc)) {
+            reset();
+            failed_ = true;
+            return false;
+        }
+    }
+    if (!algorithmChosen_ || algorithmBob_ != bob) {
+        if (!chooseAlgorithm(bob)) {
+            reset();
+            failed_ = true;
+            return false;
+        }
+    }
+
+    VASurfaceID input = (VASurfaceID)(uintptr_t)frame->data[3];
+    bool bottomFirst = order == FieldOrder::BOTTOM_FIRST;
+    for (int field = 0; field < 2; ++field) {
+        uint32_t flags = bottomFirst ? VA_DEINTERLACING_BOTTOM_FIELD_FIRST : 0;
+        if ((field == 0) == bottomFirst) {
+            flags |= VA_DEINTERLACING_BOTTOM_FIELD;
+        }
+        VASurfaceID output = surfaces_[nextSurface_];
+        nextSurface_ = (nextSurface_ + 1) % OUTPUT_SURFACES;
+        if (!renderField(input, output, flags)) {
+            LOG_WARNING << "VaapiDeinterlacer: Video processing failed, deinterlacing in the shader";
+            reset();
+            failed_ = true;
+            return false;
+        }
+        fields[field] = output;
+    }
+
+    // Reference of the next frame's filter
+    if (!reference_) {
+        reference_ = av_frame_alloc();
+    } else {
+        av_frame_unref(reference_);
+    }
+    if (reference_ && av_frame_ref(reference_, frame) < 0) {
+        av_frame_unref(reference_);
+    }
+    return true;
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
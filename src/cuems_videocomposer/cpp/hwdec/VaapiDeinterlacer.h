@@ -0,0 +1,77 @@
+#ifndef VIDEOCOMPOSER_VAAPIDEINTERLACER_H
+#define VIDEOCOMPOSER_VAAPIDEINTERLACER_H
+
+#ifdef HAVE_VAAPI_INTEROP
+
+#include <va/va.h>
+#include <va/va_vpp.h>
+#include "../video/FieldSelector.h"
+#include "../video/MemoryBudget.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace videocomposer {
+
+/**
+ * VaapiDeinterlacer - Both fields of an interlaced VAAPI frame as
+ * progressive surfaces, on the video engine (VPP)
+ *
+ * Each field goes through the driver's deinterlacing filter into a
+ * surface of a small output ring: motion adaptive (motion compensated if
+ * that is all the driver has, with the previous frame as reference) or
+ * bob. The output surfaces are imported like decoded ones, so nothing
+ * leaves the GPU. A driver without the filter, or one whose motion
+ * adaptive filter needs future frames, falls back to bob, and a failed
+ * setup turns the deinterlacer off for the stream (the shader path then
+ * deinterlaces the decoded surface).
+ */
+class VaapiDeinterlacer {
+public:
+    static constexpr int OUTPUT_SURFACES = 8;  // Two fields a frame, frames in flight and spare
+
+    VaapiDeinterlacer();
+    ~VaapiDeinterlacer();
+
+    /**
+     * Deinterlace one decoded frame
+     * @param order Field order of the frame (not PROGRESSIVE)
+     * @param bob Bob instead of motion adaptive
+     * @param fields Output: first and second field in time
+     * @return false if VPP is unavailable (nothing was done)
+     */
+    bool process(VADisplay display, const AVFrame* frame, FieldOrder order, bool bob, VASurfaceID fields[2]);
+
+    /** Drop the pipeline and reference (new stream, size or display) */
+    void reset();
+
+    bool isAvailable() const { return !failed_; }
+
+private:
+    bool setup(VADisplay display, int width, int height, unsigned int rtFormat, unsigned int fourcc);
+    bool chooseAlgorithm(bool bob);
+    bool renderField(VASurfaceID input, VASurfaceID output, uint32_t flags);
+
+    VADisplay display_;
+    VAConfigID config_;
+    VAContextID context_;
+    VASurfaceID surfaces_[OUTPUT_SURFACES];
+    int nextSurface_;
+    int width_;
+    int height_;
+    unsigned int rtFormat_;
+    VAProcDeinterlacingType algorithm_;
+    bool algorithmBob_;                  // Algorithm chosen for a bob request
+    bool algorithmChosen_;
+    unsigned int forwardReferences_;
+    AVFrame* reference_;                 // Previous decoded frame (kept alive as reference)
+    bool failed_;
+    MemoryBudget::Account budgetAccount_;
+    size_t chargedBytes_;                // Output surfaces, to the memory budget
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
+#endif // VIDEOCOMPOSER_VAAPIDEINTERLACER_H
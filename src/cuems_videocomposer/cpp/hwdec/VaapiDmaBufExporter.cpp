@@ -0,0 +1,172 @@
+#ifdef HAVE_VAAPI_INTEROP
+
+#include "VaapiDmaBufExporter.h"
+#include "../utils/Logger.h"
+
+#include <drm_fourcc.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+#include <libavutil/hwcontext_vaapi.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+// Keys of every exporter in the process, so importers never see one twice
+std::atomic<uint64_t> nextKey{1};
+
+// What a frame's DmaBufPlanes::owner holds
+struct ExportedFrame {
+    AVFrame* frame = nullptr;
+    std::shared_ptr<void> fds;
+    ~ExportedFrame() { av_frame_free(&frame); }
+};
+
+} // namespace
+
+VaapiDmaBufExporter::Fds::~Fds() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+VaapiDmaBufExporter::VaapiDmaBufExporter() {
+}
+
+VaapiDmaBufExporter::~VaapiDmaBufExporter() {
+    clear();
+    av_buffer_unref(&framesCtx_);
+}
+
+bool VaapiDmaBufExporter::exportFrame(const AVFrame* frame, DmaBufPlanes& planes, bool& highDepth) {
+    if (!frame || frame->format != AV_PIX_FMT_VAAPI || !frame->hw_frames_ctx) {
+        return false;
+    }
+    AVHWFramesContext* framesCtx = (AVHWFramesContext*)frame->hw_frames_ctx->data;
+    if (!framesCtx || !framesCtx->device_ctx) {
+        return false;
+    }
+    VADisplay vaDisplay = ((AVVAAPIDeviceContext*)framesCtx->device_ctx->hwctx)->display;
+    VASurfaceID surface = (VASurfaceID)(uintptr_t)frame->data[3];
+
+    // Surface IDs are only meaningful within one frames context
+    if (!framesCtx_ || framesCtx_->data != frame->hw_frames_ctx->data) {
+        clear();
+        av_buffer_unref(&framesCtx_);
+        framesCtx_ = av_buffer_ref(frame->hw_frames_ctx);
+        if (!framesCtx_) {
+            return false;
+        }
+    }
+
+    auto it = surfaces_.find(surface);
+    if (it == surfaces_.end()) {
+        // Sync before the first export, as VaapiInterop (once per surface)
+        VAStatus syncStatus = vaSyncSurface(vaDisplay, surface);
+        if (syncStatus != VA_STATUS_SUCCESS) {
+            LOG_WARNING << "VaapiDmaBufExporter: vaSyncSurface (pre-export) failed: " << syncStatus;
+        }
+        if (surfaces_.size() >= MAX_CACHED_SURFACES) {
+            clear();
+        }
+        SurfaceExport surfaceExport;
+        if (!exportSurface(vaDisplay, surface, surfaceExport)) {
+            return false;
+        }
+        it = surfaces_.emplace(surface, surfaceExport).first;
+        LOG_VERBOSE << "VaapiDmaBufExporter: Exported surface " << surface
+                    << " (" << surfaces_.size() << " cached)";
+    }
+    const SurfaceExport& cached = it->second;
+
+    auto owner = std::make_shared<ExportedFrame>();
+    owner->frame = av_frame_clone(frame);
+    if (!owner->frame) {
+        return false;
+    }
+    owner->fds = cached.fds;
+
+    planes.key = cached.key;
+    planes.fds[0] = cached.fds->fds[0];
+    planes.fds[1] = cached.fds->fds[1];
+    planes.offsets[0] = cached.offsets[0];
+    planes.offsets[1] = cached.offsets[1];
+    planes.pitches[0] = cached.pitches[0];
+    planes.pitches[1] = cached.pitches[1];
+    planes.modifier = cached.modifier;
+    planes.width = cached.width;
+    planes.height = cached.height;
+    planes.owner = owner;
+    highDepth = cached.highDepth;
+    return true;
+}
+
+bool VaapiDmaBufExporter::exportSurface(VADisplay vaDisplay, VASurfaceID surface, SurfaceExport& out) {
+    VADRMPRIMESurfaceDescriptor desc;
+    memset(&desc, 0, sizeof(desc));
+    VAStatus vaStatus = vaExportSurfaceHandle(vaDisplay, surface, VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                                              VA_EXPORT_SURFACE_READ_ONLY | VA_EXPORT_SURFACE_SEPARATE_LAYERS,
+                                              &desc);
+    if (vaStatus != VA_STATUS_SUCCESS) {
+        LOG_ERROR << "VaapiDmaBufExporter: vaExportSurfaceHandle failed: " << vaStatus;
+        return false;
+    }
+
+    // Y and UV planes, as separate layers or the two planes of one
+    uint32_t objects[2] = {0, 0};
+    bool ok = true;
+    if (desc.num_layers == 2) {
+        out.highDepth = desc.layers[0].drm_format == DRM_FORMAT_R16;
+        for (int plane = 0; plane < 2; ++plane) {
+            objects[plane] = desc.layers[plane].object_index[0];
+            out.offsets[plane] = desc.layers[plane].offset[0];
+            out.pitches[plane] = desc.layers[plane].pitch[0];
+        }
+    } else if (desc.num_layers == 1 && desc.layers[0].num_planes >= 2) {
+        uint32_t composed = desc.layers[0].drm_format;
+        out.highDepth = composed == DRM_FORMAT_P010 || composed == DRM_FORMAT_P012 || composed == DRM_FORMAT_P016;
+        for (int plane = 0; plane < 2; ++plane) {
+            objects[plane] = desc.layers[0].object_index[plane];
+            out.offsets[plane] = desc.layers[0].offset[plane];
+            out.pitches[plane] = desc.layers[0].pitch[plane];
+        }
+    } else {
+        LOG_ERROR << "VaapiDmaBufExporter: Unsupported layer configuration";
+        ok = false;
+    }
+
+    if (ok) {
+        out.fds = std::make_shared<Fds>();
+        for (int plane = 0; plane < 2; ++plane) {
+            out.fds->fds[plane] = dup(desc.objects[objects[plane]].fd);
+        }
+        out.modifier = desc.objects[objects[0]].drm_format_modifier;
+        out.width = static_cast<int>(desc.width);
+        out.height = static_cast<int>(desc.height);
+        out.key = nextKey.fetch_add(1);
+        ok = out.fds->fds[0] >= 0 && out.fds->fds[1] >= 0;
+    }
+
+    for (uint32_t i = 0; i < desc.num_objects; i++) {
+        close(desc.objects[i].fd);
+    }
+    return ok;
+}
+
+void VaapiDmaBufExporter::clear() {
+    if (!surfaces_.empty()) {
+        LOG_VERBOSE << "VaapiDmaBufExporter: Dropping " << surfaces_.size() << " cached surfaces";
+    }
+    surfaces_.clear();   // Fds of frames still in flight close with their owner
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
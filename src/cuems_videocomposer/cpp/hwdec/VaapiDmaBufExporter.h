@@ -0,0 +1,88 @@
+#ifndef VIDEOCOMPOSER_VAAPIDMABUFEXPORTER_H
+#define VIDEOCOMPOSER_VAAPIDMABUFEXPORTER_H
+
+#ifdef HAVE_VAAPI_INTEROP
+
+#include <va/va.h>
+#include <va/va_drmcommon.h>
+
+#include "../video/DmaBufPlanes.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace videocomposer {
+
+/**
+ * VaapiDmaBufExporter - VAAPI surfaces as DMA-BUF planes, without EGL
+ *
+ * For display backends that import decoded frames themselves
+ * (DisplayBackend::importsDmaBuf, the Vulkan display). Each surface of
+ * the decoder's pool is exported once (vaExportSurfaceHandle, separate
+ * R8 + GR88 layers, R16 + GR1616 for 10-bit) and its fds are cached by
+ * VASurfaceID, as VaapiInterop caches its EGL images; the cache is
+ * dropped when frames arrive from another hardware frames context.
+ *
+ * Every export gets a process-unique DmaBufPlanes::key, so importers
+ * can cache by it. The planes' owner holds both the frame (the surface
+ * is not decoded into) and the fds, so a frame still in flight keeps
+ * them open after its surface has left the cache.
+ *
+ * No wait for the decode here: the importer waits on the DMA-BUF's
+ * fence (DMA_BUF_IOCTL_EXPORT_SYNC_FILE), on the GPU where it can.
+ */
+class VaapiDmaBufExporter {
+public:
+    VaapiDmaBufExporter();
+    ~VaapiDmaBufExporter();
+
+    VaapiDmaBufExporter(const VaapiDmaBufExporter&) = delete;
+    VaapiDmaBufExporter& operator=(const VaapiDmaBufExporter&) = delete;
+
+    /**
+     * Planes of a decoded frame
+     * @param frame AVFrame with format AV_PIX_FMT_VAAPI
+     * @param highDepth Set for 10-bit and deeper surfaces (16-bit planes)
+     * @return false if the surface cannot be exported
+     */
+    bool exportFrame(const AVFrame* frame, DmaBufPlanes& planes, bool& highDepth);
+
+private:
+    // Upper bound for growable pools (fixed decoder pools stay well below it)
+    static constexpr size_t MAX_CACHED_SURFACES = 64;
+
+    // Fds of one export, closed when the last frame using them is released
+    struct Fds {
+        int fds[2] = {-1, -1};   // Y, UV
+        ~Fds();
+    };
+
+    struct SurfaceExport {
+        std::shared_ptr<Fds> fds;
+        uint32_t offsets[2] = {0, 0};
+        uint32_t pitches[2] = {0, 0};
+        uint64_t modifier = 0;
+        int width = 0;
+        int height = 0;
+        bool highDepth = false;
+        uint64_t key = 0;
+    };
+
+    bool exportSurface(VADisplay vaDisplay, VASurfaceID surface, SurfaceExport& out);
+    void clear();
+
+    std::unordered_map<VASurfaceID, SurfaceExport> surfaces_;
+    // Frames context the cached surfaces belong to (referenced so its address can't be reused)
+    AVBufferRef* framesCtx_ = nullptr;
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
+
+#endif // VIDEOCOMPOSER_VAAPIDMABUFEXPORTER_H
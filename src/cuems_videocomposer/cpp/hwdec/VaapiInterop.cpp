@@ -3,6 +3,7 @@
 #include "VaapiInterop.h"
 #include "../display/DisplayBackend.h"
 #include "../utils/Logger.h"
+#include "../utils/FrameTracer.h"
 
 // Include GLEW before GL for proper initialization
 #ifdef HAVE_GLEW
@@ -11,6 +12,9 @@
 #include <GL/gl.h>
 
 #include <unistd.h>  // for close()
+#include <sys/ioctl.h>
+#include <linux/dma-buf.h>
+#include <cerrno>
 #include <cstring>   // for memset()
 #include <chrono>    // for timing diagnostics
 #include <vector>    // for texture readback
@@ -46,8 +50,39 @@
 #define EGL_HEIGHT                        0x3056
 #endif
 
+// DRM_FORMAT_MOD_INVALID: layout implied by the exporting driver
+#define DRM_FORMAT_MOD_INVALID_VALUE      0x00ffffffffffffffULL
+
+// DMA-BUF fence export (Linux 6.0+), for headers that predate it
+#ifndef DMA_BUF_IOCTL_EXPORT_SYNC_FILE
+struct dma_buf_export_sync_file {
+    __u32 flags;
+    __s32 fd;
+};
+#define DMA_BUF_IOCTL_EXPORT_SYNC_FILE _IOWR(DMA_BUF_BASE, 2, struct dma_buf_export_sync_file)
+#endif
+
 namespace videocomposer {
 
+namespace {
+
+// Field order a decoded frame is flagged with (PROGRESSIVE if not interlaced)
+FieldOrder frameFieldOrder(const AVFrame* frame) {
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(58, 7, 100)
+    bool interlaced = frame->flags & AV_FRAME_FLAG_INTERLACED;
+    bool topFirst = frame->flags & AV_FRAME_FLAG_TOP_FIELD_FIRST;
+#else
+    bool interlaced = frame->interlaced_frame != 0;
+    bool topFirst = frame->top_field_first != 0;
+#endif
+    if (!interlaced) {
+        return FieldOrder::PROGRESSIVE;
+    }
+    return topFirst ? FieldOrder::TOP_FIRST : FieldOrder::BOTTOM_FIRST;
+}
+
+} // namespace
+
 VaapiInterop::VaapiInterop()
     : vaDisplay_(nullptr)
     , eglDisplay_(EGL_NO_DISPLAY)
@@ -59,12 +94,16 @@ VaapiInterop::VaapiInterop()
     , eglCreateSyncKHR_(nullptr)
     , eglDestroySyncKHR_(nullptr)
     , eglClientWaitSyncKHR_(nullptr)
+    , eglWaitSyncKHR_(nullptr)
     , hasSyncSupport_(false)
+    , hasNativeFenceSync_(false)
     , initialized_(false)
+    , cachedFramesCtx_(nullptr)
+    , currentSurface_(VA_INVALID_ID)
+    , currentVaDisplay_(nullptr)
+    , cacheGeneration_(0)
     , eglImageY_(EGL_NO_IMAGE_KHR)
     , eglImageUV_(EGL_NO_IMAGE_KHR)
-    , prevEglImageY_(EGL_NO_IMAGE_KHR)
-    , prevEglImageUV_(EGL_NO_IMAGE_KHR)
     , textureY_(0)
     , textureUV_(0)
     , frameWidth_(0)
@@ -80,9 +119,7 @@ VaapiInterop::VaapiInterop()
     , debugLastEglImageUV_(EGL_NO_IMAGE_KHR)
     , debugReadbackEnabled_(false)  // Set to true for detailed debugging
     // Experimental fixes
-    , keepFDsOpen_(true)  // ENABLED: Keep DMA-BUF FDs open until frame release
-    , openYFd_(-1)
-    , openUVFd_(-1)
+    , keepFDsOpen_(true)  // ENABLED: Keep DMA-BUF FDs open while the surface is cached
     , useEglSync_(true)  // ENABLED: Use EGL sync fence
     , debugSurfaceReadbackEnabled_(false)  // Set to true for VAAPI surface verification
 {
@@ -91,37 +128,17 @@ VaapiInterop::VaapiInterop()
 VaapiInterop::~VaapiInterop() {
     releaseFrame();
     
-    // Unref frames if they exist
+    // Free frames if they exist
     if (currentFrame_) {
-        av_frame_unref(currentFrame_);
         av_frame_free(&currentFrame_);
-        currentFrame_ = nullptr;
     }
     if (previousFrame_) {
-        av_frame_unref(previousFrame_);
         av_frame_free(&previousFrame_);
-        previousFrame_ = nullptr;
     }
     
-    // Delete textures
-    if (textureY_ != 0) {
-        glDeleteTextures(1, &textureY_);
-        textureY_ = 0;
-    }
-    if (textureUV_ != 0) {
-        glDeleteTextures(1, &textureUV_);
-        textureUV_ = 0;
-    }
-    
-    // Close any remaining open FDs
-    if (openYFd_ >= 0) {
-        close(openYFd_);
-        openYFd_ = -1;
-    }
-    if (openUVFd_ >= 0) {
-        close(openUVFd_);
-        openUVFd_ = -1;
-    }
+    // Delete cached textures, EGL images and DMA-BUF FDs
+    clearSurfaceCache();
+    av_buffer_unref(&cachedFramesCtx_);
 }
 
 bool VaapiInterop::init(DisplayBackend* display) {
@@ -187,6 +204,15 @@ bool VaapiInterop::init(DisplayBackend* display) {
         LOG_INFO << "VaapiInterop: EGL sync extension not available";
     }
     
+    // Native fence sync lets the GPU wait for VAAPI decode without blocking the CPU
+    eglWaitSyncKHR_ = (PFNEGLWAITSYNCKHRPROC)eglGetProcAddress("eglWaitSyncKHR");
+    const char* eglExtensions = eglQueryString(eglDisplay_, EGL_EXTENSIONS);
+    hasNativeFenceSync_ = hasSyncSupport_ && eglWaitSyncKHR_ && eglExtensions &&
+                          strstr(eglExtensions, "EGL_ANDROID_native_fence_sync") &&
+                          strstr(eglExtensions, "EGL_KHR_wait_sync");
+    LOG_INFO << "VaapiInterop: Decode sync via "
+             << (hasNativeFenceSync_ ? "DMA-BUF native fence (GPU wait)" : "vaSyncSurface (CPU wait)");
+    
     // Get VAAPI display (shared with FFmpeg decoder for zero-copy)
     vaDisplay_ = display->getVADisplay();
     if (!vaDisplay_) {
@@ -208,189 +234,23 @@ bool VaapiInterop::init(DisplayBackend* display) {
 bool VaapiInterop::importFrame(AVFrame* vaapiFrame,
                                GLuint& texY, GLuint& texUV,
                                int& width, int& height) {
-    if (!initialized_) {
-        LOG_ERROR << "VaapiInterop: Not initialized";
-        return false;
-    }
-    
-    if (!vaapiFrame) {
-        LOG_ERROR << "VaapiInterop: Null frame";
+    // Same two phases as the async path, back to back on the GL thread
+    if (!createEGLImages(vaapiFrame, width, height)) {
         return false;
     }
     
-    if (vaapiFrame->format != AV_PIX_FMT_VAAPI) {
-        LOG_ERROR << "VaapiInterop: Frame is not VAAPI format (format=" << vaapiFrame->format << ")";
-        return false;
-    }
-    
-    if (!vaapiFrame->hw_frames_ctx) {
-        LOG_ERROR << "VaapiInterop: Frame has no hardware context";
-        return false;
-    }
-    
-    // Release previous frame resources
-    releaseFrame();
-    
-    // Get VAAPI surface from AVFrame
-    // For VAAPI frames, data[3] contains the VASurfaceID
-    VASurfaceID surface = (VASurfaceID)(uintptr_t)vaapiFrame->data[3];
-    
-    // Get VAAPI device context from frame
-    AVHWFramesContext* hwFramesCtx = (AVHWFramesContext*)vaapiFrame->hw_frames_ctx->data;
-    if (!hwFramesCtx || !hwFramesCtx->device_ctx) {
-        LOG_ERROR << "VaapiInterop: Invalid hardware frames context";
-        return false;
-    }
-    
-    AVVAAPIDeviceContext* vaapiDevCtx = (AVVAAPIDeviceContext*)hwFramesCtx->device_ctx->hwctx;
-    if (!vaapiDevCtx) {
-        LOG_ERROR << "VaapiInterop: Invalid VAAPI device context";
-        return false;
-    }
-    
-    VADisplay vaDisplay = vaapiDevCtx->display;
-    
-    // Debug: Check if the VADisplay from the frame matches our shared display
-    if (vaDisplay_ && vaDisplay != vaDisplay_) {
-        LOG_WARNING << "VaapiInterop: Frame VADisplay (" << vaDisplay 
-                   << ") differs from shared VADisplay (" << vaDisplay_ << ")";
-    }
-    
-    // CRITICAL: Sync BEFORE export to ensure decoding is complete (like mpv)
-    VAStatus vaStatus = vaSyncSurface(vaDisplay, surface);
-    if (vaStatus != VA_STATUS_SUCCESS) {
-        LOG_WARNING << "VaapiInterop: vaSyncSurface (pre-export) failed: " << vaStatus;
-        // Continue anyway - export might still work
-    }
-    
-    // Export surface to DMA-BUF using vaExportSurfaceHandle
-    VADRMPRIMESurfaceDescriptor desc;
-    memset(&desc, 0, sizeof(desc));
-    
-    // Use SEPARATE_LAYERS like mpv does for EGL interop
-    // Each plane becomes a separate layer with its own DRM format
-    vaStatus = vaExportSurfaceHandle(
-        vaDisplay, surface,
-        VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
-        VA_EXPORT_SURFACE_READ_ONLY | VA_EXPORT_SURFACE_SEPARATE_LAYERS,
-        &desc);
-    
-    if (vaStatus != VA_STATUS_SUCCESS) {
-        LOG_ERROR << "VaapiInterop: vaExportSurfaceHandle failed: " << vaStatus;
-        return false;
-    }
-    
-    // NOTE: Post-export sync removed - pre-export sync is sufficient
-    // EGL image import provides implicit synchronization
-    
-    width = desc.width;
-    height = desc.height;
-    frameWidth_ = width;
-    frameHeight_ = height;
-    
-    // Verify we have NV12 format (expected from VAAPI H.264 decoding)
-    if (desc.fourcc != VA_FOURCC_NV12 && desc.fourcc != VA_FOURCC('N','V','1','2')) {
-        LOG_WARNING << "VaapiInterop: Unexpected fourcc: " << std::hex << desc.fourcc 
-                   << " (expected NV12)";
-        // Continue anyway - DRM fourcc might differ
-    }
-    
-    // With COMPOSED_LAYERS, we get 1 layer with 2 planes for NV12
-    // With SEPARATE_LAYERS, we get 2 layers with 1 plane each
-    int yObjectIdx, uvObjectIdx;
-    uint32_t yOffset, uvOffset, yPitch, uvPitch;
-    uint64_t yModifier, uvModifier;
-    uint32_t yFormat, uvFormat;
-    
-    if (desc.num_layers == 1 && desc.layers[0].num_planes >= 2) {
-        // COMPOSED_LAYERS mode: single layer with multiple planes
-        yObjectIdx = desc.layers[0].object_index[0];
-        yOffset = desc.layers[0].offset[0];
-        yPitch = desc.layers[0].pitch[0];
-        yModifier = desc.objects[yObjectIdx].drm_format_modifier;
-        yFormat = DRM_FORMAT_R8;  // Y plane as R8
-        
-        uvObjectIdx = desc.layers[0].object_index[1];
-        uvOffset = desc.layers[0].offset[1];
-        uvPitch = desc.layers[0].pitch[1];
-        uvModifier = desc.objects[uvObjectIdx].drm_format_modifier;
-        uvFormat = DRM_FORMAT_GR88;  // UV plane as GR88
-    } else if (desc.num_layers >= 2) {
-        // SEPARATE_LAYERS mode: each plane is a separate layer
-        yObjectIdx = desc.layers[0].object_index[0];
-        yOffset = desc.layers[0].offset[0];
-        yPitch = desc.layers[0].pitch[0];
-        yModifier = desc.objects[yObjectIdx].drm_format_modifier;
-        yFormat = desc.layers[0].drm_format;  // Use layer's actual format
-        
-        uvObjectIdx = desc.layers[1].object_index[0];
-        uvOffset = desc.layers[1].offset[0];
-        uvPitch = desc.layers[1].pitch[0];
-        uvModifier = desc.objects[uvObjectIdx].drm_format_modifier;
-        uvFormat = desc.layers[1].drm_format;  // Use layer's actual format
-    } else {
-        LOG_ERROR << "VaapiInterop: Invalid layer configuration for NV12";
-        // Close DMA-BUF fds
-        for (uint32_t i = 0; i < desc.num_objects; i++) {
-            close(desc.objects[i].fd);
-        }
-        return false;
-    }
-    
-    int yFd = desc.objects[yObjectIdx].fd;
-    int uvFd = desc.objects[uvObjectIdx].fd;
-    
-    // Create EGL image for Y plane (full resolution)
-    eglImageY_ = createEGLImageFromDmaBuf(
-        yFd, width, height,
-        yFormat, yOffset, yPitch, yModifier);
-    
-    if (eglImageY_ == EGL_NO_IMAGE_KHR) {
-        LOG_ERROR << "VaapiInterop: Failed to create EGL image for Y plane";
-        // Close DMA-BUF fds
-        for (uint32_t i = 0; i < desc.num_objects; i++) {
-            close(desc.objects[i].fd);
-        }
-        return false;
-    }
-    
-    // Create EGL image for UV plane (half resolution)
-    eglImageUV_ = createEGLImageFromDmaBuf(
-        uvFd, width / 2, height / 2,
-        uvFormat, uvOffset, uvPitch, uvModifier);
-    
-    if (eglImageUV_ == EGL_NO_IMAGE_KHR) {
-        LOG_ERROR << "VaapiInterop: Failed to create EGL image for UV plane";
-        eglDestroyImageKHR_(eglDisplay_, eglImageY_);
-        eglImageY_ = EGL_NO_IMAGE_KHR;
-        // Close DMA-BUF fds
-        for (uint32_t i = 0; i < desc.num_objects; i++) {
-            close(desc.objects[i].fd);
-        }
-        return false;
-    }
-    
-    
-    // Close DMA-BUF fds now - EGL holds references to the underlying buffers
-    for (uint32_t i = 0; i < desc.num_objects; i++) {
-        close(desc.objects[i].fd);
-    }
-    
-    // Phase 1 complete - EGL images are ready
-    // Now try to bind textures (Phase 2) - this requires a GL context
     if (!bindTexturesToImages(texY, texUV)) {
         LOG_WARNING << "VaapiInterop: Phase 2 (texture binding) failed - EGL images will be kept for later binding";
-        // Don't clean up EGL images - they can be bound later from the GL thread
         // Return false to indicate incomplete import
         return false;
     }
     
-    
     return true;
 }
 
 bool VaapiInterop::createEGLImages(AVFrame* vaapiFrame, int& width, int& height) {
-    // Create EGL images only - do NOT bind textures here
+    FRAME_TRACE_SCOPE("egl.import");
+    // Look up (or create) the EGL images of the frame's surface - do NOT bind textures here
     // The caller should call bindTexturesToImages() from the GL thread
     
     if (!initialized_) {
@@ -416,14 +276,6 @@ bool VaapiInterop::createEGLImages(AVFrame* vaapiFrame, int& width, int& height)
     // Get VAAPI surface from AVFrame
     VASurfaceID surface = (VASurfaceID)(uintptr_t)vaapiFrame->data[3];
     
-    // CRITICAL: Save old EGL images before creating new ones
-    // They must stay alive until new textures are bound (GPU might still be sampling from them)
-    // They will be destroyed in bindTexturesToImages() AFTER new textures are bound
-    prevEglImageY_ = eglImageY_;
-    prevEglImageUV_ = eglImageUV_;
-    eglImageY_ = EGL_NO_IMAGE_KHR;
-    eglImageUV_ = EGL_NO_IMAGE_KHR;
-    
     // CRITICAL: MPV-style immediate release pattern  
     // MPV does: map frame → render → unmap (release immediately)
     // To match this, we keep ONLY the frame being rendered (currentFrame_)
@@ -439,12 +291,8 @@ bool VaapiInterop::createEGLImages(AVFrame* vaapiFrame, int& width, int& height)
     }
     
     // CRITICAL: Release any existing frame BEFORE importing new one
-    // This is necessary when multiple layers share the same VaapiInterop instance
-    // Each layer may try to import a frame before the previous layer's frame is released
     // Releasing here ensures we don't have multiple frames in flight
     if (currentFrame_->buf[0]) {
-        // Release the previous frame's resources (but keep EGL images/textures for now)
-        // They will be cleaned up in bindTexturesToImages() after new textures are bound
         av_frame_unref(currentFrame_);
     }
     
@@ -463,16 +311,115 @@ bool VaapiInterop::createEGLImages(AVFrame* vaapiFrame, int& width, int& height)
     
     VADisplay vaDisplay = vaapiDevCtx->display;
     
+    // Surface IDs are only meaningful within one frames context:
+    // a reopened or resized decoder gets new surfaces, so start over
+    if (!cachedFramesCtx_ || cachedFramesCtx_->data != vaapiFrame->hw_frames_ctx->data) {
+        if (!surfaceCache_.empty()) {
+            LOG_VERBOSE << "VaapiInterop: Frames context changed, dropping "
+                        << surfaceCache_.size() << " cached surfaces";
+        }
+        clearSurfaceCache();
+        deinterlacer_.reset();
+        av_buffer_unref(&cachedFramesCtx_);
+        cachedFramesCtx_ = av_buffer_ref(vaapiFrame->hw_frames_ctx);
+        if (!cachedFramesCtx_) {
+            LOG_ERROR << "VaapiInterop: Failed to ref hardware frames context";
+            return false;
+        }
+    }
+    
+    // Interlaced frames: both fields made progressive on the video engine
+    // are imported instead of the decoded surface (the shader path
+    // deinterlaces it when VPP is unavailable)
+    VASurfaceID shown = surface;
+    VASurfaceID secondField = VA_INVALID_ID;
+    FieldOrder order = frameFieldOrder(vaapiFrame);
+    if (order == FieldOrder::PROGRESSIVE) {
+        order = streamFieldOrder_;
+    }
+    FieldSelector::Mode mode = FieldSelector::resolve(deinterlaceMode_, order);
+    if (mode != FieldSelector::Mode::OFF) {
+        VASurfaceID fields[2];
+        if (deinterlacer_.process(vaDisplay, vaapiFrame,
+                                  order == FieldOrder::PROGRESSIVE ? FieldOrder::TOP_FIRST : order,
+                                  mode == FieldSelector::Mode::BOB, fields)) {
+            shown = fields[0];
+            secondField = fields[1];
+        }
+    }
+    
+    // Decode completion of cached surfaces is waited for in bindTexturesToImages()
+    // (the second field first: importing the shown one may not drop it then)
+    if (secondField != VA_INVALID_ID && !importSurface(secondField, vaDisplay)) {
+        secondField = VA_INVALID_ID;
+    }
+    SurfaceImport* shownImport = importSurface(shown, vaDisplay);
+    if (!shownImport) {
+        return false;
+    }
+    
+    const SurfaceImport& import = *shownImport;
+    width = import.width;
+    height = import.height;
+    
+    // DEBUG: Read back VAAPI surface to verify decoded content
+    if (debugSurfaceReadbackEnabled_) {
+        debugReadbackVaapiSurface(surface, vaDisplay, width, height);
+    }
+    frameWidth_ = width;
+    frameHeight_ = height;
+    
+    // CRITICAL: Clone the new frame to currentFrame_ (increment ref count)
+    // This keeps the VAAPI surface alive while we use its EGL images
+    int ret = av_frame_ref(currentFrame_, vaapiFrame);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        LOG_ERROR << "VaapiInterop: Failed to ref frame: " << errbuf;
+        return false;
+    }
+    
+    currentSurface_ = shown;
+    currentVaDisplay_ = vaDisplay;
+    eglImageY_ = import.imageY;
+    eglImageUV_ = import.imageUV;
+    currentHighDepth_ = import.highDepth;
+    currentDeinterlaced_ = shown != surface;
+    secondFieldSurface_ = secondField;
+    return true;
+}
+
+VaapiInterop::SurfaceImport* VaapiInterop::importSurface(VASurfaceID surface, VADisplay vaDisplay) {
+    auto it = surfaceCache_.find(surface);
+    if (it == surfaceCache_.end()) {
+        // CRITICAL: Sync BEFORE export like mpv (only once per surface)
+        VAStatus syncStatus = vaSyncSurface(vaDisplay, surface);
+        if (syncStatus != VA_STATUS_SUCCESS) {
+            LOG_WARNING << "VaapiInterop: vaSyncSurface (pre-export) failed: " << syncStatus;
+        }
+        
+        // Growable pools can hand out more surfaces than the decoder cycles through
+        if (surfaceCache_.size() >= MAX_CACHED_SURFACES) {
+            LOG_VERBOSE << "VaapiInterop: Surface cache full, dropping " << surfaceCache_.size() << " surfaces";
+            clearSurfaceCache();
+        }
+        
+        SurfaceImport import;
+        if (!exportSurface(surface, vaDisplay, import)) {
+            return nullptr;
+        }
+        it = surfaceCache_.emplace(surface, import).first;
+        LOG_VERBOSE << "VaapiInterop: Imported surface " << surface
+                    << " (" << surfaceCache_.size() << " cached)";
+    }
+    return &it->second;
+}
+
+bool VaapiInterop::exportSurface(VASurfaceID surface, VADisplay vaDisplay, SurfaceImport& import) {
     // Export surface to DMA-BUF
     VADRMPRIMESurfaceDescriptor desc;
     memset(&desc, 0, sizeof(desc));
     
-    // CRITICAL: Sync BEFORE export to ensure decode is complete
-    VAStatus syncStatus = vaSyncSurface(vaDisplay, surface);
-    if (syncStatus != VA_STATUS_SUCCESS) {
-        LOG_WARNING << "VaapiInterop: vaSyncSurface (pre-export) failed: " << syncStatus;
-    }
-    
     VAStatus vaStatus = vaExportSurfaceHandle(
         vaDisplay, surface,
         VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
@@ -488,53 +435,54 @@ bool VaapiInterop::createEGLImages(AVFrame* vaapiFrame, int& width, int& height)
     // mpv only syncs once before export, not after
     // The EGL image import provides implicit synchronization
     
-    width = desc.width;
-    height = desc.height;
-    
-    // DEBUG: Read back VAAPI surface to verify decoded content
-    if (debugSurfaceReadbackEnabled_) {
-        debugReadbackVaapiSurface(surface, vaDisplay, width, height);
-    }
-    frameWidth_ = width;
-    frameHeight_ = height;
+    int width = desc.width;
+    int height = desc.height;
     
-    // Extract plane info (same logic as importFrame)
+    // Extract plane info
     int yObjectIdx, uvObjectIdx;
     uint32_t yOffset, uvOffset, yPitch, uvPitch;
     uint64_t yModifier, uvModifier;
     uint32_t yFormat, uvFormat;
     int yFd, uvFd;
     
+    // 10-bit and deeper surfaces (P010/P012/P016, HEVC Main10) hold their
+    // samples in the high bits of 16-bit words: R16/GR1616 planes, read as
+    // normalised 16-bit by the NV12 shader
+    bool highDepth = false;
+    
     if (desc.num_layers == 2) {
         // SEPARATE_LAYERS mode - force R8/GR88 like mpv does for NV12
+        highDepth = desc.layers[0].drm_format == DRM_FORMAT_R16;
         yObjectIdx = desc.layers[0].object_index[0];
         yOffset = desc.layers[0].offset[0];
         yPitch = desc.layers[0].pitch[0];
-        yFormat = DRM_FORMAT_R8;  // Force R8 for Y plane like mpv
+        yFormat = highDepth ? DRM_FORMAT_R16 : DRM_FORMAT_R8;  // Force R8 for Y plane like mpv
         yModifier = desc.objects[yObjectIdx].drm_format_modifier;
         yFd = dup(desc.objects[yObjectIdx].fd);
         
         uvObjectIdx = desc.layers[1].object_index[0];
         uvOffset = desc.layers[1].offset[0];
         uvPitch = desc.layers[1].pitch[0];
-        uvFormat = DRM_FORMAT_GR88;  // Force GR88 for UV plane like mpv
+        uvFormat = highDepth ? DRM_FORMAT_GR1616 : DRM_FORMAT_GR88;  // Force GR88 for UV plane like mpv
         uvModifier = desc.objects[uvObjectIdx].drm_format_modifier;
         uvFd = dup(desc.objects[uvObjectIdx].fd);
         
     } else if (desc.num_layers == 1 && desc.layers[0].num_planes >= 2) {
         // COMPOSED_LAYERS mode
+        uint32_t composed = desc.layers[0].drm_format;
+        highDepth = composed == DRM_FORMAT_P010 || composed == DRM_FORMAT_P012 || composed == DRM_FORMAT_P016;
         yObjectIdx = desc.layers[0].object_index[0];
         yOffset = desc.layers[0].offset[0];
         yPitch = desc.layers[0].pitch[0];
         yModifier = desc.objects[yObjectIdx].drm_format_modifier;
-        yFormat = DRM_FORMAT_R8;
+        yFormat = highDepth ? DRM_FORMAT_R16 : DRM_FORMAT_R8;
         yFd = dup(desc.objects[yObjectIdx].fd);
         
         uvObjectIdx = desc.layers[0].object_index[1];
         uvOffset = desc.layers[0].offset[1];
         uvPitch = desc.layers[0].pitch[1];
         uvModifier = desc.objects[uvObjectIdx].drm_format_modifier;
-        uvFormat = DRM_FORMAT_GR88;
+        uvFormat = highDepth ? DRM_FORMAT_GR1616 : DRM_FORMAT_GR88;
         uvFd = dup(desc.objects[uvObjectIdx].fd);
     } else {
         LOG_ERROR << "VaapiInterop: Unsupported layer configuration";
@@ -549,63 +497,58 @@ bool VaapiInterop::createEGLImages(AVFrame* vaapiFrame, int& width, int& height)
         close(desc.objects[i].fd);
     }
     
-    // Create EGL images
-    eglImageY_ = createEGLImageFromDmaBuf(yFd, width, height, yFormat, yOffset, yPitch, yModifier);
-    
-    if (eglImageY_ == EGL_NO_IMAGE_KHR) {
-        LOG_ERROR << "VaapiInterop: Failed to create EGL image for Y plane";
+    // A surface decoded on another GPU (render node) reaches this one through
+    // PRIME: its layout is only known from an explicit modifier, so implicit
+    // ones are refused and a rejected modifier is not retried without it
+    bool foreign = vaDisplay_ && vaDisplay != vaDisplay_;
+    if (foreign && (yModifier == DRM_FORMAT_MOD_INVALID_VALUE || uvModifier == DRM_FORMAT_MOD_INVALID_VALUE)) {
+        LOG_VERBOSE << "VaapiInterop: Surface from another GPU has an implicit modifier, cannot share it";
         close(yFd);
         close(uvFd);
         return false;
     }
     
-    eglImageUV_ = createEGLImageFromDmaBuf(uvFd, width / 2, height / 2, uvFormat, uvOffset, uvPitch, uvModifier);
+    // Create EGL images
+    import.imageY = createEGLImageFromDmaBuf(yFd, width, height, yFormat, yOffset, yPitch, yModifier, !foreign);
+    if (import.imageY != EGL_NO_IMAGE_KHR) {
+        import.imageUV = createEGLImageFromDmaBuf(uvFd, width / 2, height / 2, uvFormat, uvOffset, uvPitch,
+                                                  uvModifier, !foreign);
+    }
     
     // Handle FD lifetime based on experimental flag
     if (keepFDsOpen_) {
-        // Keep FDs open until frame is released - driver may need them
-        // Close any previously open FDs first
-        if (openYFd_ >= 0) {
-            close(openYFd_);
-        }
-        if (openUVFd_ >= 0) {
-            close(openUVFd_);
-        }
-        openYFd_ = yFd;
-        openUVFd_ = uvFd;
+        // Keep FDs open until the surface leaves the cache - driver may need them
+        import.fdY = yFd;
+        import.fdUV = uvFd;
     } else {
-        // Close FDs immediately (original behavior)
+        // Close FDs immediately (EGL holds references to the underlying buffers)
         close(yFd);
         close(uvFd);
     }
     
-    if (eglImageUV_ == EGL_NO_IMAGE_KHR) {
-        LOG_ERROR << "VaapiInterop: Failed to create EGL image for UV plane";
-        eglDestroyImageKHR_(eglDisplay_, eglImageY_);
-        eglImageY_ = EGL_NO_IMAGE_KHR;
+    if (import.imageY == EGL_NO_IMAGE_KHR || import.imageUV == EGL_NO_IMAGE_KHR) {
+        LOG_ERROR << "VaapiInterop: Failed to create EGL image for "
+                  << (import.imageY == EGL_NO_IMAGE_KHR ? "Y" : "UV") << " plane";
+        destroySurfaceImport(import);
         return false;
     }
     
-    // CRITICAL: Clone the new frame to currentFrame_ (increment ref count)
-    // This keeps the VAAPI surface alive while we use its EGL images
-    // We do this AFTER all validation and EGL image creation succeeds
-    int ret = av_frame_ref(currentFrame_, vaapiFrame);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        LOG_ERROR << "VaapiInterop: Failed to ref frame: " << errbuf;
-        // Clean up EGL images since we can't keep the surface alive
-        eglDestroyImageKHR_(eglDisplay_, eglImageY_);
-        eglDestroyImageKHR_(eglDisplay_, eglImageUV_);
-        eglImageY_ = EGL_NO_IMAGE_KHR;
-        eglImageUV_ = EGL_NO_IMAGE_KHR;
-        return false;
+    import.width = width;
+    import.height = height;
+    import.offsets[0] = yOffset;
+    import.offsets[1] = uvOffset;
+    import.pitches[0] = yPitch;
+    import.pitches[1] = uvPitch;
+    import.modifier = yModifier;
+    import.highDepth = highDepth;
+    if (highDepth) {
+        LOG_VERBOSE << "VaapiInterop: Surface " << surface << " imported as 16-bit planes (R16/GR1616)";
     }
-    
     return true;
 }
 
 bool VaapiInterop::bindTexturesToImages(GLuint& texY, GLuint& texUV) {
+    FRAME_TRACE_SCOPE("egl.bind");
     if (!hasEGLImages()) {
         LOG_ERROR << "VaapiInterop: No EGL images to bind";
         return false;
@@ -617,187 +560,206 @@ bool VaapiInterop::bindTexturesToImages(GLuint& texY, GLuint& texUV) {
         return false;
     }
     
-    // MPV order: delete textures FIRST, then destroy EGL images
-    // The texture was bound to the old EGL image, so delete it before destroying the image
-    EGLDisplay currentDisplay = eglGetCurrentDisplay();
-    if (currentDisplay == EGL_NO_DISPLAY) {
-        currentDisplay = eglDisplay_;
+    auto it = surfaceCache_.find(currentSurface_);
+    if (it == surfaceCache_.end()) {
+        LOG_ERROR << "VaapiInterop: Current surface is not cached";
+        return false;
     }
+    SurfaceImport& import = it->second;
+    if (!createTextures(import)) {
+        destroySurfaceImport(import);
+        surfaceCache_.erase(it);
+        releaseFrame();
+        return false;
+    }
+    textureY_ = import.textureY;
+    textureUV_ = import.textureUV;
     
-    // NOTE: Removed glFinish() here - it was causing GPU pipeline stalls
-    // glDeleteTextures is safe without glFinish() because:
-    // 1. OpenGL defers deletion until the texture is no longer in use
-    // 2. The texture won't actually be freed until pending draw calls complete
-    // This is the same approach mpv uses for smooth playback
+    // The surface holds a new frame - make sure its decode is complete before sampling
+    bool gpuWait = waitForDecode(import);
     
-    // Step 1: Delete old textures (they were bound to old EGL images)
-    if (textureY_ != 0) {
-        glDeleteTextures(1, &textureY_);
-        textureY_ = 0;
-    }
-    if (textureUV_ != 0) {
-        glDeleteTextures(1, &textureUV_);
-        textureUV_ = 0;
+    // Second field of a deinterlaced frame: written by the same VPP job sequence
+    secondTextureY_ = 0;
+    secondTextureUV_ = 0;
+    auto second = surfaceCache_.find(secondFieldSurface_);
+    if (secondFieldSurface_ != VA_INVALID_ID && second != surfaceCache_.end()) {
+        if (createTextures(second->second)) {
+            if (!hasNativeFenceSync_ || !waitOnDmaBufFence(second->second.fdY)) {
+                vaSyncSurface(currentVaDisplay_, secondFieldSurface_);
+            }
+            secondTextureY_ = second->second.textureY;
+            secondTextureUV_ = second->second.textureUV;
+        } else {
+            destroySurfaceImport(second->second);
+            surfaceCache_.erase(second);
+        }
     }
     
-    // Step 2: Now safe to destroy the old EGL images
-    if (prevEglImageY_ != EGL_NO_IMAGE_KHR) {
-        eglDestroyImageKHR_(currentDisplay, prevEglImageY_);
-        prevEglImageY_ = EGL_NO_IMAGE_KHR;
-    }
-    if (prevEglImageUV_ != EGL_NO_IMAGE_KHR) {
-        eglDestroyImageKHR_(currentDisplay, prevEglImageUV_);
-        prevEglImageUV_ = EGL_NO_IMAGE_KHR;
+    // CRITICAL: Flush GPU commands to ensure EGL image bindings are submitted
+    // glFlush() submits commands to GPU without blocking
+    glFlush();
+    
+    // EXPERIMENTAL: Use EGL sync fence to ensure texture data is ready
+    // This may help with GPU caching issues by forcing synchronization
+    // Not needed after a fence wait (it would block the CPU on the decode again)
+    if (useEglSync_ && hasSyncSupport_ && !gpuWait) {
+        EGLDisplay currentDisplay = eglGetCurrentDisplay();
+        if (currentDisplay != EGL_NO_DISPLAY) {
+            // Create a sync fence
+            EGLSyncKHR sync = eglCreateSyncKHR_(currentDisplay, EGL_SYNC_FENCE_KHR, nullptr);
+            if (sync != nullptr) {
+                // Wait on the fence (forces GPU to complete all pending operations)
+                eglClientWaitSyncKHR_(currentDisplay, sync, 0, EGL_FOREVER_KHR);
+                eglDestroySyncKHR_(currentDisplay, sync);
+            }
+        }
     }
     
-        glGenTextures(1, &textureY_);
-        glGenTextures(1, &textureUV_);
+    texY = textureY_;
+    texUV = textureUV_;
+    return true;
+}
+
+bool VaapiInterop::getSecondFieldTextures(GLuint& texY, GLuint& texUV) const {
+    if (secondTextureY_ == 0 || secondTextureUV_ == 0) {
+        return false;
+    }
+    texY = secondTextureY_;
+    texUV = secondTextureUV_;
+    return true;
+}
+
+bool VaapiInterop::createTextures(SurfaceImport& import) {
+    // Textures stay bound to the surface's EGL images across frames;
+    // only the first frame decoded into a surface creates them
+    if (import.textureY == 0) {
+        glGenTextures(1, &import.textureY);
+        glGenTextures(1, &import.textureUV);
         
-        if (textureY_ == 0 || textureUV_ == 0) {
+        if (import.textureY == 0 || import.textureUV == 0) {
             LOG_ERROR << "VaapiInterop: Failed to create textures";
             return false;
         }
         
-    // Set texture parameters before binding EGL image
-        glBindTexture(GL_TEXTURE_2D, textureY_);
+        // Set texture parameters before binding EGL image
+        glBindTexture(GL_TEXTURE_2D, import.textureY);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
-        glBindTexture(GL_TEXTURE_2D, textureUV_);
+        glBindTexture(GL_TEXTURE_2D, import.textureUV);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         
         glBindTexture(GL_TEXTURE_2D, 0);
-    
-    // Clear any pending GL errors before we start
-    while (glGetError() != GL_NO_ERROR) {}
-    
-    // Bind Y plane texture using the appropriate extension (mpv approach)
-    glBindTexture(GL_TEXTURE_2D, textureY_);
-    bool bindSuccess = false;
-    
-    if (isDesktopGL_ && glEGLImageTargetTexStorageEXT_) {
-        // Desktop GL path (DRM/KMS) - use TexStorageEXT like mpv
-        glEGLImageTargetTexStorageEXT_(GL_TEXTURE_2D, eglImageY_, nullptr);
-        GLenum err = glGetError();
-        if (err == GL_NO_ERROR) {
-            bindSuccess = true;
-        } else {
-            static int errCount = 0;
-            if (errCount++ < 5) {
-                LOG_WARNING << "VaapiInterop: glEGLImageTargetTexStorageEXT Y failed: 0x" 
-                           << std::hex << err << std::dec;
-            }
+        
+        // Clear any pending GL errors before we start
+        while (glGetError() != GL_NO_ERROR) {}
+        
+        if (!bindTextureToImage(import.textureY, import.imageY, "Y") ||
+            !bindTextureToImage(import.textureUV, import.imageUV, "UV")) {
+            return false;
         }
     }
+    return true;
+}
+
+bool VaapiInterop::waitForDecode(const SurfaceImport& import) {
+    FRAME_TRACE_SCOPE("vaapi.sync");
+    if (hasNativeFenceSync_ && waitOnDmaBufFence(import.fdY)) {
+        return true;
+    }
     
-    // Fallback to Texture2DOES if TexStorageEXT not available or failed
-    if (!bindSuccess && glEGLImageTargetTexture2DOES_) {
-        glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, eglImageY_);
-        GLenum err = glGetError();
-        if (err == GL_NO_ERROR) {
-            bindSuccess = true;
-    } else {
-            static int errCount = 0;
-            if (errCount++ < 5) {
-                LOG_WARNING << "VaapiInterop: glEGLImageTargetTexture2DOES Y failed: 0x" 
-                           << std::hex << err << std::dec;
-            }
+    // Fallback: block until the decode is complete
+    VAStatus syncStatus = vaSyncSurface(currentVaDisplay_, currentSurface_);
+    if (syncStatus != VA_STATUS_SUCCESS) {
+        LOG_WARNING << "VaapiInterop: vaSyncSurface failed: " << syncStatus;
+    }
+    return false;
+}
+
+bool VaapiInterop::waitOnDmaBufFence(int fd) {
+    if (fd < 0) {
+        return false;  // FDs not kept (keepFDsOpen_ disabled)
+    }
+    
+    // Pending writes (the decode) as a sync file
+    struct dma_buf_export_sync_file exportSync;
+    exportSync.flags = DMA_BUF_SYNC_READ;
+    exportSync.fd = -1;
+    if (ioctl(fd, DMA_BUF_IOCTL_EXPORT_SYNC_FILE, &exportSync) != 0) {
+        if (errno == ENOTTY || errno == EINVAL) {
+            LOG_INFO << "VaapiInterop: Kernel cannot export DMA-BUF fences, using vaSyncSurface";
+            hasNativeFenceSync_ = false;
         }
+        return false;
     }
     
-    if (!bindSuccess) {
-        LOG_ERROR << "VaapiInterop: Failed to bind Y plane";
-        glBindTexture(GL_TEXTURE_2D, 0);
+    EGLDisplay currentDisplay = eglGetCurrentDisplay();
+    if (currentDisplay == EGL_NO_DISPLAY) {
+        currentDisplay = eglDisplay_;
+    }
+    
+    EGLint attribs[] = {
+        EGL_SYNC_NATIVE_FENCE_FD_ANDROID, exportSync.fd,
+        EGL_NONE
+    };
+    EGLSyncKHR sync = eglCreateSyncKHR_(currentDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+    if (sync == nullptr) {
+        // EGL only takes ownership of the fd on success
+        close(exportSync.fd);
         return false;
     }
     
-    // Bind UV plane texture
-    glBindTexture(GL_TEXTURE_2D, textureUV_);
-    bindSuccess = false;
+    // Server-side wait: later GL commands wait for the decode, the CPU doesn't
+    EGLint waited = eglWaitSyncKHR_(currentDisplay, sync, 0);
+    eglDestroySyncKHR_(currentDisplay, sync);
+    return waited == EGL_TRUE;
+}
+
+bool VaapiInterop::bindTextureToImage(GLuint texture, EGLImageKHR image, const char* plane) {
+    // Bind using the appropriate extension (mpv approach)
+    glBindTexture(GL_TEXTURE_2D, texture);
+    bool bindSuccess = false;
     
     if (isDesktopGL_ && glEGLImageTargetTexStorageEXT_) {
         // Desktop GL path (DRM/KMS) - use TexStorageEXT like mpv
-        glEGLImageTargetTexStorageEXT_(GL_TEXTURE_2D, eglImageUV_, nullptr);
+        glEGLImageTargetTexStorageEXT_(GL_TEXTURE_2D, image, nullptr);
         GLenum err = glGetError();
         if (err == GL_NO_ERROR) {
             bindSuccess = true;
         } else {
             static int errCount = 0;
             if (errCount++ < 5) {
-                LOG_WARNING << "VaapiInterop: glEGLImageTargetTexStorageEXT UV failed: 0x" 
+                LOG_WARNING << "VaapiInterop: glEGLImageTargetTexStorageEXT " << plane << " failed: 0x" 
                            << std::hex << err << std::dec;
             }
         }
     }
     
-    // Fallback to Texture2DOES
+    // Fallback to Texture2DOES if TexStorageEXT not available or failed
     if (!bindSuccess && glEGLImageTargetTexture2DOES_) {
-        glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, eglImageUV_);
+        glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, image);
         GLenum err = glGetError();
         if (err == GL_NO_ERROR) {
             bindSuccess = true;
-    } else {
+        } else {
             static int errCount = 0;
             if (errCount++ < 5) {
-                LOG_WARNING << "VaapiInterop: glEGLImageTargetTexture2DOES UV failed: 0x" 
+                LOG_WARNING << "VaapiInterop: glEGLImageTargetTexture2DOES " << plane << " failed: 0x" 
                            << std::hex << err << std::dec;
-    }
-        }
-    }
-    
-    if (!bindSuccess) {
-        LOG_ERROR << "VaapiInterop: Failed to bind UV plane";
-        glBindTexture(GL_TEXTURE_2D, 0);
-        return false;
-    }
-    
-    glBindTexture(GL_TEXTURE_2D, 0);
-    
-    // CRITICAL: Flush GPU commands to ensure EGL image bindings are submitted
-    // glFlush() submits commands to GPU without blocking
-    glFlush();
-    
-    // EXPERIMENTAL: Use EGL sync fence to ensure texture data is ready
-    // This may help with GPU caching issues by forcing synchronization
-    if (useEglSync_ && hasSyncSupport_) {
-        EGLDisplay currentDisplay = eglGetCurrentDisplay();
-        if (currentDisplay != EGL_NO_DISPLAY) {
-            // Create a sync fence
-            EGLSyncKHR sync = eglCreateSyncKHR_(currentDisplay, EGL_SYNC_FENCE_KHR, nullptr);
-            if (sync != nullptr) {
-                // Wait on the fence (forces GPU to complete all pending operations)
-                eglClientWaitSyncKHR_(currentDisplay, sync, 0, EGL_FOREVER_KHR);
-                eglDestroySyncKHR_(currentDisplay, sync);
             }
         }
     }
     
-    // Close old DMA-BUF FDs if keepFDsOpen_ mode was used
-    // (These are from the previous frame)
-    if (openYFd_ >= 0) {
-        close(openYFd_);
-        openYFd_ = -1;
-    }
-    if (openUVFd_ >= 0) {
-        close(openUVFd_);
-        openUVFd_ = -1;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!bindSuccess) {
+        LOG_ERROR << "VaapiInterop: Failed to bind " << plane << " plane";
     }
-    
-    // CRITICAL: NOW release the old AVFrame (after new textures bound and old EGL images destroyed)
-    // Frame was already released in createEGLImages() - nothing to do here
-    // The VAAPI surface was returned to the pool immediately when we imported the new frame
-
-    
-    // Return NEW texture IDs
-    texY = textureY_;
-    texUV = textureUV_;
-    
-    return true;
+    return bindSuccess;
 }
 
 void VaapiInterop::debugReadbackYTexture() {
@@ -936,49 +898,108 @@ void VaapiInterop::debugReadbackVaapiSurface(VASurfaceID surface, VADisplay vaDi
 }
 
 void VaapiInterop::releaseFrame() {
-    // CRITICAL: Wait for GPU to finish rendering before releasing resources
-    // The GPU might still be sampling from textures backed by these EGL images/DMA-BUFs
-    // If we release them while rendering is in progress, we'll get frozen frames
-    // when the VAAPI surface pool recycles surfaces
-    EGLContext currentContext = eglGetCurrentContext();
-    if (currentContext != EGL_NO_CONTEXT) {
-        // We have a GL context - ensure all rendering is complete
-        glFinish();
+    // Drop the frame reference only - the surface's EGL images and textures
+    // stay cached for the next time the decoder hands it out
+    if (currentFrame_ && currentFrame_->buf[0]) {
+        av_frame_unref(currentFrame_);
+    }
+    currentSurface_ = VA_INVALID_ID;
+    eglImageY_ = EGL_NO_IMAGE_KHR;
+    eglImageUV_ = EGL_NO_IMAGE_KHR;
+    currentHighDepth_ = false;
+    textureY_ = 0;
+    textureUV_ = 0;
+    currentDeinterlaced_ = false;
+    secondFieldSurface_ = VA_INVALID_ID;
+    secondTextureY_ = 0;
+    secondTextureUV_ = 0;
+}
+
+void VaapiInterop::destroySurfaceImport(SurfaceImport& import) {
+    // MPV order: delete textures FIRST, then destroy EGL images
+    // glDeleteTextures is deferred by GL until pending draw calls complete
+    if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+        if (import.textureY != 0) {
+            glDeleteTextures(1, &import.textureY);
+        }
+        if (import.textureUV != 0) {
+            glDeleteTextures(1, &import.textureUV);
+        }
     }
+    import.textureY = 0;
+    import.textureUV = 0;
     
     // Use eglGetCurrentDisplay() like mpv does
     EGLDisplay currentDisplay = eglGetCurrentDisplay();
     if (currentDisplay == EGL_NO_DISPLAY) {
         currentDisplay = eglDisplay_;  // Fallback to stored display
     }
-    
-    if (eglImageY_ != EGL_NO_IMAGE_KHR) {
-        eglDestroyImageKHR_(currentDisplay, eglImageY_);
-        eglImageY_ = EGL_NO_IMAGE_KHR;
+    if (import.imageY != EGL_NO_IMAGE_KHR) {
+        eglDestroyImageKHR_(currentDisplay, import.imageY);
+        import.imageY = EGL_NO_IMAGE_KHR;
     }
-    if (eglImageUV_ != EGL_NO_IMAGE_KHR) {
-        eglDestroyImageKHR_(currentDisplay, eglImageUV_);
-        eglImageUV_ = EGL_NO_IMAGE_KHR;
+    if (import.imageUV != EGL_NO_IMAGE_KHR) {
+        eglDestroyImageKHR_(currentDisplay, import.imageUV);
+        import.imageUV = EGL_NO_IMAGE_KHR;
     }
     
-    // Close open DMA-BUF FDs if keepFDsOpen_ mode was used
-    if (openYFd_ >= 0) {
-        close(openYFd_);
-        openYFd_ = -1;
+    if (import.fdY >= 0) {
+        close(import.fdY);
+        import.fdY = -1;
+    }
+    if (import.fdUV >= 0) {
+        close(import.fdUV);
+        import.fdUV = -1;
+    }
+}
+
+void VaapiInterop::clearSurfaceCache() {
+    releaseFrame();
+    for (auto& entry : surfaceCache_) {
+        destroySurfaceImport(entry.second);
+    }
+    surfaceCache_.clear();
+    ++cacheGeneration_;
+}
+
+bool VaapiInterop::getCurrentDmaBufPlanes(DmaBufPlanes& planes) const {
+    if (!currentFrame_ || !currentFrame_->buf[0]) {
+        return false;
+    }
+    auto it = surfaceCache_.find(currentSurface_);
+    // Plane scanout takes NV12 only
+    if (it == surfaceCache_.end() || it->second.fdY < 0 || it->second.fdUV < 0 || it->second.highDepth) {
+        return false;
     }
-    if (openUVFd_ >= 0) {
-        close(openUVFd_);
-        openUVFd_ = -1;
+    const SurfaceImport& import = it->second;
+    
+    AVFrame* ref = av_frame_clone(currentFrame_);
+    if (!ref) {
+        return false;
     }
+    planes.owner = std::shared_ptr<void>(ref, [](void* p) {
+        AVFrame* frame = static_cast<AVFrame*>(p);
+        av_frame_free(&frame);
+    });
+    planes.key = (static_cast<uint64_t>(cacheGeneration_) << 32) | currentSurface_;
+    planes.fds[0] = import.fdY;
+    planes.fds[1] = import.fdUV;
+    planes.offsets[0] = import.offsets[0];
+    planes.offsets[1] = import.offsets[1];
+    planes.pitches[0] = import.pitches[0];
+    planes.pitches[1] = import.pitches[1];
+    planes.modifier = import.modifier;
+    planes.width = import.width;
+    planes.height = import.height;
+    return true;
 }
 
 EGLImageKHR VaapiInterop::createEGLImageFromDmaBuf(
     int fd, int width, int height,
-    uint32_t fourcc, uint32_t offset, uint32_t pitch, uint64_t modifier) {
+    uint32_t fourcc, uint32_t offset, uint32_t pitch, uint64_t modifier, bool allowModifierFallback) {
     
     // Check if we need to specify modifier (DRM_FORMAT_MOD_INVALID means linear/default)
-    // DRM_FORMAT_MOD_INVALID = 0x00ffffffffffffff
-    bool hasModifier = (modifier != 0 && modifier != 0x00ffffffffffffffULL);
+    bool hasModifier = (modifier != 0 && modifier != DRM_FORMAT_MOD_INVALID_VALUE);
     
     if (hasModifier) {
         // With modifier - use EGL_DMA_BUF_PLANE0_MODIFIER_LO/HI_EXT
@@ -1004,11 +1025,15 @@ EGLImageKHR VaapiInterop::createEGLImageFromDmaBuf(
             currentDisplay, EGL_NO_CONTEXT,
             EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
         
-        if (image == EGL_NO_IMAGE_KHR) {
-            // Fall through to try without modifier
-        } else {
+        if (image != EGL_NO_IMAGE_KHR) {
             return image;
         }
+        if (!allowModifierFallback) {
+            LOG_VERBOSE << "VaapiInterop: Modifier 0x" << std::hex << modifier << std::dec
+                        << " not accepted by the compositing GPU";
+            return EGL_NO_IMAGE_KHR;
+        }
+        // Fall through to try without modifier
     }
     
     // Without modifier (or fallback)
@@ -1041,26 +1066,22 @@ EGLImageKHR VaapiInterop::createEGLImageFromDmaBuf(
 }
 
 void VaapiInterop::releaseCurrentFrame() {
-    // MPV-style immediate release of VAAPI surface (but keep textures/EGL images for now)
+    // MPV-style immediate release of VAAPI surface (but keep textures/EGL images)
     // 
     // CRITICAL INSIGHT: We CAN'T delete textures here because OpenGLRenderer still has their IDs!
     // The renderer will use those texture IDs until the NEXT frame is imported.
     // 
-    // But we CAN unref the AVFrame immediately - the EGL images hold dup'd DMA-BUF FDs,
-    // so they keep the surface data alive even after the AVFrame is unreffed!
-    // The surface itself might go back to the pool, but the DMABUF memory stays valid
-    // until we destroy the EGL images (which happens on next import)
+    // But we CAN unref the AVFrame immediately - the surface goes back to the pool
+    // and its cached EGL images/textures are reused when the decoder hands it out again
     
     // Unref the AVFrame immediately - returns VAAPI surface to pool
     if (currentFrame_ && currentFrame_->buf[0]) {
         av_frame_unref(currentFrame_);
     }
     
-    // Textures, EGL images, and DMA-BUF FDs stay alive until next import
-    // (They're cleaned up in bindTexturesToImages() when creating new resources)
+    // Textures, EGL images, and DMA-BUF FDs stay cached with the surface
 }
 
 } // namespace videocomposer
 
 #endif // HAVE_VAAPI_INTEROP
-
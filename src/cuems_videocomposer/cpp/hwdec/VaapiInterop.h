@@ -29,6 +29,9 @@ typedef EGLBoolean (*PFNEGLDESTROYIMAGEKHRPROC)(EGLDisplay, EGLImageKHR);
 #ifndef EGL_SYNC_NATIVE_FENCE_ANDROID
 #define EGL_SYNC_NATIVE_FENCE_ANDROID 0x3144
 #endif
+#ifndef EGL_SYNC_NATIVE_FENCE_FD_ANDROID
+#define EGL_SYNC_NATIVE_FENCE_FD_ANDROID 0x3145
+#endif
 #ifndef EGL_FOREVER_KHR
 #define EGL_FOREVER_KHR 0xFFFFFFFFFFFFFFFFull
 #endif
@@ -42,12 +45,17 @@ typedef void* EGLSyncKHR;
 typedef EGLSyncKHR (*PFNEGLCREATESYNCKHRPROC)(EGLDisplay, EGLenum, const EGLint*);
 typedef EGLBoolean (*PFNEGLDESTROYSYNCKHRPROC)(EGLDisplay, EGLSyncKHR);
 typedef EGLint (*PFNEGLCLIENTWAITSYNCKHRPROC)(EGLDisplay, EGLSyncKHR, EGLint, uint64_t);
+typedef EGLint (*PFNEGLWAITSYNCKHRPROC)(EGLDisplay, EGLSyncKHR, EGLint);
 // GL_OES_EGL_image extension function type (for OpenGL ES)
 typedef void (*PFNGLEGLIMAGETARGETTEXTURE2DOESPROC)(GLenum, void*);
 // GL_EXT_EGL_image_storage extension function type (for Desktop OpenGL)
 typedef void (*PFNGLEGLIMAGETARGETTEXSTORAGEEXTPROC)(GLenum, void*, const int*);
 
 #include <drm_fourcc.h>
+#include "../video/DmaBufPlanes.h"
+#include "VaapiDeinterlacer.h"
+#include <cstddef>
+#include <unordered_map>
 
 extern "C" {
 #include <libavutil/hwcontext.h>
@@ -70,7 +78,25 @@ class DisplayBackend;
  *   VAAPI Surface → DRM PRIME FD → EGL Image → OpenGL Texture
  * 
  * The result is NV12 format textures (Y plane + UV plane) which are
- * converted to RGB by the NV12 shader during rendering.
+ * converted to RGB by the NV12 shader during rendering. 10-bit surfaces
+ * (P010 and deeper) are imported the same way as R16/RG16 textures.
+ *
+ * The decoder cycles through a small fixed pool of surfaces, so each
+ * surface is exported and imported once: its DMA-BUF fds, EGL images and
+ * textures are cached by VASurfaceID and reused whenever the surface comes
+ * back with a new frame. The cache is dropped when frames arrive from a
+ * different hardware frames context (decoder reopened or resized).
+ *
+ * Decode completion is waited for on the GPU: the surface's DMA-BUF fence
+ * is exported as a sync file and handed to EGL_ANDROID_native_fence_sync +
+ * eglWaitSyncKHR, so rendering waits in the command stream and neither the
+ * decode thread nor the GL thread blocks. Without kernel or EGL support
+ * the interop falls back to vaSyncSurface().
+ *
+ * Interlaced frames can be deinterlaced on the video engine first
+ * (setDeinterlace, VaapiDeinterlacer): both fields are imported as
+ * progressive surfaces, the first as the frame's textures, the second
+ * through getSecondFieldTextures().
  */
 class VaapiInterop {
 public:
@@ -86,7 +112,8 @@ public:
     
     /**
      * Phase 1: Create EGL images from VAAPI frame (can be called from any thread)
-     * This exports the VAAPI surface to DMA-BUF and creates EGL images.
+     * The first frame in a surface exports it to DMA-BUF and creates EGL images;
+     * later frames in the same surface reuse the cached images.
      * Call bindTexturesToImages() from the GL thread to complete the import.
      * 
      * @param vaapiFrame AVFrame with format AV_PIX_FMT_VAAPI
@@ -122,8 +149,8 @@ public:
                     int& width, int& height);
     
     /**
-     * Release resources for the current imported frame
-     * Must be called before importing a new frame
+     * Drop the current imported frame (e.g. after a failed import)
+     * The surface cache is kept; the next import replaces the current frame anyway
      */
     void releaseFrame();
     
@@ -145,6 +172,11 @@ public:
     int getFrameWidth() const { return frameWidth_; }
     int getFrameHeight() const { return frameHeight_; }
     
+    /**
+     * Whether the current frame has 16-bit planes (P010 and deeper)
+     */
+    bool isHighDepthFrame() const { return currentHighDepth_; }
+    
     /**
      * Check if VAAPI interop is available and initialized
      */
@@ -166,6 +198,35 @@ public:
      */
     VADisplay getVADisplay() const { return vaDisplay_; }
     
+    /**
+     * Describe the current surface's DMA-BUF (valid after successful importFrame)
+     * The planes hold a reference to the decoded frame, so its surface is not
+     * reused while e.g. a scanout plane still shows it.
+     * @return false if the fds were not kept open or there is no current frame
+     */
+    bool getCurrentDmaBufPlanes(DmaBufPlanes& planes) const;
+    
+    /**
+     * Deinterlace interlaced frames with VPP before import (as the mode
+     * resolves for their field order, see FieldSelector::resolve)
+     * @param streamOrder Field order of frames not flagged interlaced
+     */
+    void setDeinterlace(FieldSelector::Mode mode, FieldOrder streamOrder) {
+        deinterlaceMode_ = mode;
+        streamFieldOrder_ = streamOrder;
+    }
+    
+    /**
+     * The current frame was deinterlaced: its textures are the first field
+     */
+    bool isDeinterlacedFrame() const { return currentDeinterlaced_; }
+    
+    /**
+     * Second field of a deinterlaced frame (valid after bindTexturesToImages)
+     * @return false if there is none
+     */
+    bool getSecondFieldTextures(GLuint& texY, GLuint& texUV) const;
+    
 private:
     // VAAPI display (shared with FFmpeg decoder for zero-copy)
     VADisplay vaDisplay_;
@@ -187,20 +248,56 @@ private:
     PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR_;
     PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR_;
     PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR_;
+    PFNEGLWAITSYNCKHRPROC eglWaitSyncKHR_;
     bool hasSyncSupport_;
+    // EGL_ANDROID_native_fence_sync + EGL_KHR_wait_sync (cleared if the kernel can't export fences)
+    bool hasNativeFenceSync_;
     
     // State
     bool initialized_;
     
-    // Current frame state
+    // Imported resources of one VAAPI surface, reused every time the surface is decoded into
+    struct SurfaceImport {
+        int fdY = -1;   // Only kept open with keepFDsOpen_
+        int fdUV = -1;
+        EGLImageKHR imageY = EGL_NO_IMAGE_KHR;
+        EGLImageKHR imageUV = EGL_NO_IMAGE_KHR;
+        GLuint textureY = 0;   // Created on first bind (GL thread)
+        GLuint textureUV = 0;
+        int width = 0;
+        int height = 0;
+        uint32_t offsets[2] = {0, 0};   // Y, UV
+        uint32_t pitches[2] = {0, 0};
+        uint64_t modifier = 0;
+        bool highDepth = false;         // P010/P012/P016: R16 + GR1616 images
+    };
+    
+    // Upper bound for growable pools (fixed decoder pools stay well below it)
+    static constexpr size_t MAX_CACHED_SURFACES = 64;
+    
+    std::unordered_map<VASurfaceID, SurfaceImport> surfaceCache_;
+    // Frames context the cached surfaces belong to (referenced so its address can't be reused)
+    AVBufferRef* cachedFramesCtx_;
+    VASurfaceID currentSurface_;
+    uint32_t cacheGeneration_;    // Bumped when the cache is dropped (DmaBufPlanes keys)
+    VADisplay currentVaDisplay_;  // Display of currentSurface_ (for the vaSyncSurface fallback)
+    
+    // Current frame state (images/textures of currentSurface_)
     EGLImageKHR eglImageY_;
     EGLImageKHR eglImageUV_;
-    // Previous EGL images - kept alive until new textures are bound
-    EGLImageKHR prevEglImageY_;
-    EGLImageKHR prevEglImageUV_;
+    bool currentHighDepth_ = false;
     GLuint textureY_;
     GLuint textureUV_;
     
+    // VPP deinterlacing of the current frame (second field imported like the first)
+    VaapiDeinterlacer deinterlacer_;
+    FieldSelector::Mode deinterlaceMode_ = FieldSelector::Mode::OFF;
+    FieldOrder streamFieldOrder_ = FieldOrder::PROGRESSIVE;
+    bool currentDeinterlaced_ = false;
+    VASurfaceID secondFieldSurface_ = VA_INVALID_ID;
+    GLuint secondTextureY_ = 0;
+    GLuint secondTextureUV_ = 0;
+    
     // Cached frame info
     int frameWidth_;
     int frameHeight_;
@@ -228,11 +325,9 @@ private:
     bool debugReadbackEnabled_;
     
     // ========== EXPERIMENTAL FIXES ==========
-    // Keep DMA-BUF FDs open until frame is released (instead of closing immediately)
+    // Keep DMA-BUF FDs open while the surface is cached (instead of closing after import)
     // Some drivers may lose reference when FD is closed
     bool keepFDsOpen_;
-    int openYFd_;
-    int openUVFd_;
     
     // Use EGL sync fence to ensure DMA-BUF is ready before texture sampling
     bool useEglSync_;
@@ -240,10 +335,37 @@ private:
     // Enable VAAPI surface readback debugging (very expensive!)
     bool debugSurfaceReadbackEnabled_;
     
-    // Create EGL image from DMA-BUF descriptor
+    // Export a surface to DMA-BUF and create its EGL images
+    bool exportSurface(VASurfaceID surface, VADisplay vaDisplay, SurfaceImport& import);
+    
+    // Cached import of a surface, exported on first use (nullptr on failure)
+    SurfaceImport* importSurface(VASurfaceID surface, VADisplay vaDisplay);
+    
+    // Create a cached surface's textures and bind them to its images, once (GL thread)
+    bool createTextures(SurfaceImport& import);
+    
+    // Make the GPU wait for the current surface's decode
+    // @return true for a GPU-side wait, false if vaSyncSurface() was used
+    bool waitForDecode(const SurfaceImport& import);
+    
+    // GPU-side wait on the DMA-BUF's pending writes; false if fences can't be exported
+    bool waitOnDmaBufFence(int fd);
+    
+    // Bind one plane's texture to its EGL image (GL thread)
+    bool bindTextureToImage(GLuint texture, EGLImageKHR image, const char* plane);
+    
+    // Destroy one cached surface's textures, EGL images and fds
+    void destroySurfaceImport(SurfaceImport& import);
+    
+    // Destroy every cached surface
+    void clearSurfaceCache();
+    
+    // Create EGL image from DMA-BUF descriptor; without allowModifierFallback
+    // a rejected modifier fails instead of retrying with the implicit layout
     EGLImageKHR createEGLImageFromDmaBuf(
         int fd, int width, int height,
-        uint32_t fourcc, uint32_t offset, uint32_t pitch, uint64_t modifier = 0);
+        uint32_t fourcc, uint32_t offset, uint32_t pitch, uint64_t modifier = 0,
+        bool allowModifierFallback = true);
     
     // Debug: Read back Y texture data and log first few pixels
     void debugReadbackYTexture();
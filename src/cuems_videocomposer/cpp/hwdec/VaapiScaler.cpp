@@ -0,0 +1,134 @@
+#ifdef HAVE_VAAPI_INTEROP
+
+#include "VaapiScaler.h"
+#include "../utils/Logger.h"
+
+#include <cstdint>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+#include <libavutil/hwcontext_vaapi.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace videocomposer {
+
+VaapiScaler::~VaapiScaler() {
+    reset();
+}
+
+void VaapiScaler::reset() {
+    if (display_) {
+        if (context_ != VA_INVALID_ID) {
+            vaDestroyContext(display_, context_);
+        }
+        if (config_ != VA_INVALID_ID) {
+            vaDestroyConfig(display_, config_);
+        }
+    }
+    av_frame_free(&target_);
+    av_buffer_unref(&framesRef_);
+    device_ = nullptr;
+    display_ = nullptr;
+    config_ = VA_INVALID_ID;
+    context_ = VA_INVALID_ID;
+    width_ = 0;
+    height_ = 0;
+    failed_ = false;
+}
+
+bool VaapiScaler::setup(AVBufferRef* deviceRef, int width, int height) {
+    AVHWDeviceContext* device = reinterpret_cast<AVHWDeviceContext*>(deviceRef->data);
+    display_ = static_cast<AVVAAPIDeviceContext*>(device->hwctx)->display;
+    device_ = device;
+
+    framesRef_ = av_hwframe_ctx_alloc(deviceRef);
+    if (!framesRef_) {
+        return false;
+    }
+    AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(framesRef_->data);
+    frames->format = AV_PIX_FMT_VAAPI;
+    frames->sw_format = AV_PIX_FMT_NV12;
+    frames->width = width;
+    frames->height = height;
+    frames->initial_pool_size = 1;
+    target_ = av_frame_alloc();
+    if (av_hwframe_ctx_init(framesRef_) < 0 || !target_ || av_hwframe_get_buffer(framesRef_, target_, 0) < 0) {
+        LOG_WARNING << "VaapiScaler: Failed to create a " << width << "x" << height << " output surface";
+        return false;
+    }
+
+    if (vaCreateConfig(display_, VAProfileNone, VAEntrypointVideoProc, nullptr, 0, &config_) != VA_STATUS_SUCCESS) {
+        config_ = VA_INVALID_ID;
+        LOG_INFO << "VaapiScaler: No video processing entrypoint, thumbnails are scaled on the CPU";
+        return false;
+    }
+    VASurfaceID surface = static_cast<VASurfaceID>(reinterpret_cast<uintptr_t>(target_->data[3]));
+    if (vaCreateContext(display_, config_, width, height, VA_PROGRESSIVE, &surface, 1, &context_) !=
+        VA_STATUS_SUCCESS) {
+        context_ = VA_INVALID_ID;
+        LOG_WARNING << "VaapiScaler: Failed to create the video processing context";
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+bool VaapiScaler::scale(const AVFrame* frame, int width, int height, AVFrame* out) {
+    if (failed_ || !frame || frame->format != AV_PIX_FMT_VAAPI || !frame->hw_frames_ctx || width <= 0 ||
+        height <= 0) {
+        return false;
+    }
+    const AVHWFramesContext* input = reinterpret_cast<const AVHWFramesContext*>(frame->hw_frames_ctx->data);
+    if (input->device_ref->data != device_ || width != width_ || height != height_) {
+        reset();
+        if (!setup(input->device_ref, width, height)) {
+            reset();
+            failed_ = true;
+            return false;
+        }
+    }
+
+    // The whole picture (not the padded surface) into the whole output
+    VARectangle region;
+    region.x = 0;
+    region.y = 0;
+    region.width = static_cast<uint16_t>(frame->width);
+    region.height = static_cast<uint16_t>(frame->height);
+    VAProcPipelineParameterBuffer pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.surface = static_cast<VASurfaceID>(reinterpret_cast<uintptr_t>(frame->data[3]));
+    pipeline.surface_region = &region;
+    pipeline.filter_flags = VA_FRAME_PICTURE | VA_FILTER_SCALING_HQ;
+    pipeline.output_background_color = 0xff000000;
+
+    VASurfaceID output = static_cast<VASurfaceID>(reinterpret_cast<uintptr_t>(target_->data[3]));
+    VABufferID pipelineBuffer;
+    bool ok = vaCreateBuffer(display_, context_, VAProcPipelineParameterBufferType, sizeof(pipeline), 1,
+                             &pipeline, &pipelineBuffer) == VA_STATUS_SUCCESS;
+    if (ok) {
+        ok = vaBeginPicture(display_, context_, output) == VA_STATUS_SUCCESS;
+        if (ok) {
+            ok = vaRenderPicture(display_, context_, &pipelineBuffer, 1) == VA_STATUS_SUCCESS;
+            ok = vaEndPicture(display_, context_) == VA_STATUS_SUCCESS && ok;
+        }
+        vaDestroyBuffer(display_, pipelineBuffer);
+    }
+    if (!ok) {
+        LOG_WARNING << "VaapiScaler: Scaling failed, thumbnails are scaled on the CPU";
+        reset();
+        failed_ = true;
+        return false;
+    }
+
+    // Only the small surface leaves the GPU (the transfer waits for VPP)
+    av_frame_unref(out);
+    out->format = AV_PIX_FMT_NV12;
+    return av_hwframe_transfer_data(out, target_, 0) >= 0;
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
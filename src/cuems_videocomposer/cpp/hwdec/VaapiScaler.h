@@ -0,0 +1,64 @@
+#ifndef VIDEOCOMPOSER_VAAPISCALER_H
+#define VIDEOCOMPOSER_VAAPISCALER_H
+
+#ifdef HAVE_VAAPI_INTEROP
+
+#include <va/va.h>
+#include <va/va_vpp.h>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+namespace videocomposer {
+
+/**
+ * VaapiScaler - A decoded VAAPI frame scaled down on the video engine (VPP)
+ *
+ * For thumbnails: the frame is scaled into one NV12 surface of the output
+ * size, and only that small surface is downloaded. The surface and the
+ * pipeline are kept while the device and output size stay the same; a
+ * driver without video processing turns the scaler off (callers then
+ * download the whole frame and scale it on the CPU).
+ *
+ * One caller at a time.
+ */
+class VaapiScaler {
+public:
+    VaapiScaler() = default;
+    ~VaapiScaler();
+
+    VaapiScaler(const VaapiScaler&) = delete;
+    VaapiScaler& operator=(const VaapiScaler&) = delete;
+
+    /**
+     * Scale a frame to width x height and download it
+     * @param out Receives an NV12 frame in system memory
+     * @return false if the frame is not a VAAPI surface or VPP failed
+     */
+    bool scale(const AVFrame* frame, int width, int height, AVFrame* out);
+
+    /** Drop the surface and pipeline */
+    void reset();
+
+    bool isAvailable() const { return !failed_; }
+
+private:
+    bool setup(AVBufferRef* deviceRef, int width, int height);
+
+    const void* device_ = nullptr;       // AVHWDeviceContext the pipeline is on
+    VADisplay display_ = nullptr;
+    VAConfigID config_ = VA_INVALID_ID;
+    VAContextID context_ = VA_INVALID_ID;
+    AVBufferRef* framesRef_ = nullptr;   // Pool of the output surface
+    AVFrame* target_ = nullptr;          // The output surface
+    int width_ = 0;
+    int height_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
+#endif // VIDEOCOMPOSER_VAAPISCALER_H
@@ -0,0 +1,264 @@
+#ifdef HAVE_VULKAN_INTEROP
+
+#include "VulkanInterop.h"
+#include "../utils/Logger.h"
+
+// Include GLEW before GL for proper initialization
+#ifdef HAVE_GLEW
+#include <GL/glew.h>
+#endif
+#include <GL/gl.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <drm_fourcc.h>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+#include <libavutil/error.h>
+}
+
+// EGL extension constants for DMA-BUF import
+#ifndef EGL_LINUX_DMA_BUF_EXT
+#define EGL_LINUX_DMA_BUF_EXT             0x3270
+#endif
+#ifndef EGL_LINUX_DRM_FOURCC_EXT
+#define EGL_LINUX_DRM_FOURCC_EXT          0x3271
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_FD_EXT
+#define EGL_DMA_BUF_PLANE0_FD_EXT         0x3272
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_OFFSET_EXT
+#define EGL_DMA_BUF_PLANE0_OFFSET_EXT     0x3273
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_PITCH_EXT
+#define EGL_DMA_BUF_PLANE0_PITCH_EXT      0x3274
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT
+#define EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT 0x3443
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT
+#define EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT 0x3444
+#endif
+
+namespace videocomposer {
+
+VulkanInterop::VulkanInterop()
+    : eglDisplay_(EGL_NO_DISPLAY)
+    , eglCreateImageKHR_(nullptr)
+    , eglDestroyImageKHR_(nullptr)
+    , glEGLImageTargetTexture2DOES_(nullptr)
+    , glEGLImageTargetTexStorageEXT_(nullptr)
+    , isDesktopGL_(false)
+    , initialized_(false)
+{
+}
+
+VulkanInterop::~VulkanInterop() {
+    destroyImport(current_);
+}
+
+bool VulkanInterop::init(DisplayBackend* display) {
+    if (!display) {
+        LOG_ERROR << "VulkanInterop: DisplayBackend is null";
+        return false;
+    }
+
+    eglDisplay_ = display->getEGLDisplay();
+    if (eglDisplay_ == EGL_NO_DISPLAY) {
+        LOG_WARNING << "VulkanInterop: No EGL display";
+        return false;
+    }
+
+    eglCreateImageKHR_ = display->getEglCreateImageKHR();
+    eglDestroyImageKHR_ = display->getEglDestroyImageKHR();
+    glEGLImageTargetTexture2DOES_ = display->getGlEGLImageTargetTexture2DOES();
+    glEGLImageTargetTexStorageEXT_ = display->getGlEGLImageTargetTexStorageEXT();
+    isDesktopGL_ = display->isDesktopGL();
+
+    if (!eglCreateImageKHR_ || !eglDestroyImageKHR_ ||
+        (!glEGLImageTargetTexStorageEXT_ && !glEGLImageTargetTexture2DOES_)) {
+        LOG_WARNING << "VulkanInterop: Missing EGL image extension functions";
+        return false;
+    }
+
+    initialized_ = true;
+    LOG_INFO << "VulkanInterop initialized (Vulkan → DRM PRIME → EGL image)";
+    return true;
+}
+
+bool VulkanInterop::importFrame(AVFrame* vulkanFrame, GLuint& texY, GLuint& texUV) {
+    if (!initialized_ || !vulkanFrame || vulkanFrame->format != AV_PIX_FMT_VULKAN) {
+        return false;
+    }
+
+    Import import;
+    import.drmFrame = av_frame_alloc();
+    if (!import.drmFrame) {
+        return false;
+    }
+
+    // Export the VkImage memory; FFmpeg waits for the decode to finish here
+    import.drmFrame->format = AV_PIX_FMT_DRM_PRIME;
+    int ret = av_hwframe_map(import.drmFrame, vulkanFrame, AV_HWFRAME_MAP_READ);
+    if (ret < 0) {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            LOG_WARNING << "VulkanInterop: Failed to map frame to DRM PRIME (" << errbuf
+                        << "), using CPU copy";
+        }
+        av_frame_free(&import.drmFrame);
+        return false;
+    }
+
+    const AVDRMFrameDescriptor* desc = (const AVDRMFrameDescriptor*)import.drmFrame->data[0];
+    if (!createImages(desc, vulkanFrame->width, vulkanFrame->height, import) ||
+        !bindTexture(import.textureY, import.imageY) ||
+        !bindTexture(import.textureUV, import.imageUV)) {
+        destroyImport(import);
+        return false;
+    }
+
+    // The renderer switches to the new textures now; the previous frame can go
+    destroyImport(current_);
+    current_ = import;
+
+    texY = current_.textureY;
+    texUV = current_.textureUV;
+    return true;
+}
+
+bool VulkanInterop::createImages(const AVDRMFrameDescriptor* desc, int width, int height, Import& import) {
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+
+    if (desc->nb_layers >= 2) {
+        // One layer per plane (R8 + GR88)
+        const AVDRMLayerDescriptor& layerY = desc->layers[0];
+        const AVDRMLayerDescriptor& layerUV = desc->layers[1];
+        if (layerY.format != DRM_FORMAT_R8 || layerUV.format != DRM_FORMAT_GR88 ||
+            layerY.nb_planes < 1 || layerUV.nb_planes < 1) {
+            static bool warned = false;
+            if (!warned) {
+                warned = true;
+                LOG_WARNING << "VulkanInterop: Unsupported layer formats, using CPU copy";
+            }
+            return false;
+        }
+        import.imageY = createImage(desc->objects[layerY.planes[0].object_index], layerY.planes[0],
+                                    DRM_FORMAT_R8, width, height);
+        import.imageUV = createImage(desc->objects[layerUV.planes[0].object_index], layerUV.planes[0],
+                                     DRM_FORMAT_GR88, chromaWidth, chromaHeight);
+    } else if (desc->nb_layers == 1 && desc->layers[0].format == DRM_FORMAT_NV12 &&
+               desc->layers[0].nb_planes >= 2) {
+        // Single NV12 layer: import each plane on its own
+        const AVDRMLayerDescriptor& layer = desc->layers[0];
+        import.imageY = createImage(desc->objects[layer.planes[0].object_index], layer.planes[0],
+                                    DRM_FORMAT_R8, width, height);
+        import.imageUV = createImage(desc->objects[layer.planes[1].object_index], layer.planes[1],
+                                     DRM_FORMAT_GR88, chromaWidth, chromaHeight);
+    } else {
+        static bool warned = false;
+        if (!warned) {
+            warned = true;
+            LOG_WARNING << "VulkanInterop: Only NV12 frames are supported, using CPU copy";
+        }
+        return false;
+    }
+
+    return import.imageY != EGL_NO_IMAGE_KHR && import.imageUV != EGL_NO_IMAGE_KHR;
+}
+
+EGLImageKHR VulkanInterop::createImage(const AVDRMObjectDescriptor& object, const AVDRMPlaneDescriptor& plane,
+                                       uint32_t fourcc, int width, int height) {
+    EGLint attribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_LINUX_DRM_FOURCC_EXT, (EGLint)fourcc,
+        EGL_DMA_BUF_PLANE0_FD_EXT, object.fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)plane.offset,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, (EGLint)plane.pitch,
+        EGL_NONE, EGL_NONE,
+        EGL_NONE, EGL_NONE,
+        EGL_NONE
+    };
+    // Vulkan images are usually tiled; the modifier is required to sample them correctly
+    if (object.format_modifier != DRM_FORMAT_MOD_INVALID) {
+        attribs[12] = EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT;
+        attribs[13] = (EGLint)(object.format_modifier & 0xffffffff);
+        attribs[14] = EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT;
+        attribs[15] = (EGLint)(object.format_modifier >> 32);
+    }
+
+    // Must match the current GL context's display
+    EGLDisplay currentDisplay = eglGetCurrentDisplay();
+    if (currentDisplay == EGL_NO_DISPLAY) {
+        currentDisplay = eglDisplay_;
+    }
+    EGLImageKHR image = eglCreateImageKHR_(currentDisplay, EGL_NO_CONTEXT,
+                                           EGL_LINUX_DMA_BUF_EXT, nullptr, attribs);
+    if (image == EGL_NO_IMAGE_KHR) {
+        EGLint error = eglGetError();
+        LOG_WARNING << "VulkanInterop: eglCreateImageKHR failed (error=0x" << std::hex << error << std::dec << ")";
+    }
+    return image;
+}
+
+bool VulkanInterop::bindTexture(GLuint& texture, EGLImageKHR image) {
+    glGenTextures(1, &texture);
+    if (texture == 0) {
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // TexStorageEXT on Desktop GL, Texture2DOES on ES (same choice as VaapiInterop)
+    bool bound = false;
+    if (isDesktopGL_ && glEGLImageTargetTexStorageEXT_) {
+        glEGLImageTargetTexStorageEXT_(GL_TEXTURE_2D, image, nullptr);
+        bound = glGetError() == GL_NO_ERROR;
+    }
+    if (!bound && glEGLImageTargetTexture2DOES_) {
+        glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, image);
+        bound = glGetError() == GL_NO_ERROR;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!bound) {
+        LOG_WARNING << "VulkanInterop: Failed to bind EGL image to texture";
+    }
+    return bound;
+}
+
+void VulkanInterop::destroyImport(Import& import) {
+    if (import.textureY != 0) {
+        glDeleteTextures(1, &import.textureY);
+    }
+    if (import.textureUV != 0) {
+        glDeleteTextures(1, &import.textureUV);
+    }
+    EGLDisplay currentDisplay = eglGetCurrentDisplay();
+    if (currentDisplay == EGL_NO_DISPLAY) {
+        currentDisplay = eglDisplay_;
+    }
+    if (import.imageY != EGL_NO_IMAGE_KHR) {
+        eglDestroyImageKHR_(currentDisplay, import.imageY);
+    }
+    if (import.imageUV != EGL_NO_IMAGE_KHR) {
+        eglDestroyImageKHR_(currentDisplay, import.imageUV);
+    }
+    if (import.drmFrame) {
+        av_frame_free(&import.drmFrame);
+    }
+    import = Import();
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_VULKAN_INTEROP
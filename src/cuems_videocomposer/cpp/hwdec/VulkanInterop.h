@@ -0,0 +1,99 @@
+#ifndef VIDEOCOMPOSER_VULKANINTEROP_H
+#define VIDEOCOMPOSER_VULKANINTEROP_H
+
+#ifdef HAVE_VULKAN_INTEROP
+
+// EGL typedefs and extension function types
+#include "../display/DisplayBackend.h"
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/hwcontext_drm.h>
+}
+
+// GL types - minimal definitions to avoid GLEW conflicts
+typedef unsigned int GLuint;
+
+namespace videocomposer {
+
+/**
+ * VulkanInterop - Zero-copy Vulkan Video (AV_PIX_FMT_VULKAN) to OpenGL texture interop
+ *
+ * Pipeline:
+ *   VkImage → av_hwframe_map (DRM PRIME) → EGL Image → OpenGL Texture
+ *
+ * FFmpeg exports the decoded image's memory as DMA-BUF fds with its DRM
+ * modifier; each plane is imported as an EGL image and bound to a texture,
+ * giving the same NV12 texture contract as VaapiInterop
+ * (GPUTextureFrameBuffer::setExternalNV12Textures). The mapping waits for
+ * the decode's timeline semaphore before returning, so the textures are
+ * complete when sampled. Only 8-bit 4:2:0 (NV12) frames are imported;
+ * other formats fall back to the CPU copy path.
+ *
+ * The mapped frame and its images are kept until the next import replaces
+ * them, so the decoder can't reuse the image while GL still samples it.
+ *
+ * All methods must be called from the GL thread.
+ */
+class VulkanInterop {
+public:
+    VulkanInterop();
+    ~VulkanInterop();
+
+    VulkanInterop(const VulkanInterop&) = delete;
+    VulkanInterop& operator=(const VulkanInterop&) = delete;
+
+    /**
+     * Initialize with DisplayBackend (gets EGL display and extension functions)
+     * @return true if EGL DMA-BUF import is available
+     */
+    bool init(DisplayBackend* display);
+
+    bool isAvailable() const { return initialized_; }
+
+    /**
+     * Import a Vulkan frame as NV12 textures
+     * @param vulkanFrame AVFrame with format AV_PIX_FMT_VULKAN
+     * @param texY Output: OpenGL texture ID for Y plane
+     * @param texUV Output: OpenGL texture ID for UV plane
+     * @return true if the textures hold the frame
+     */
+    bool importFrame(AVFrame* vulkanFrame, GLuint& texY, GLuint& texUV);
+
+private:
+    // Resources of one imported frame
+    struct Import {
+        AVFrame* drmFrame = nullptr;  // DRM PRIME mapping (references the Vulkan frame)
+        EGLImageKHR imageY = nullptr;
+        EGLImageKHR imageUV = nullptr;
+        GLuint textureY = 0;
+        GLuint textureUV = 0;
+    };
+
+    // Create both planes' EGL images from the mapped frame's descriptor
+    bool createImages(const AVDRMFrameDescriptor* desc, int width, int height, Import& import);
+
+    EGLImageKHR createImage(const AVDRMObjectDescriptor& object, const AVDRMPlaneDescriptor& plane,
+                            uint32_t fourcc, int width, int height);
+
+    // Create a texture and bind it to an EGL image
+    bool bindTexture(GLuint& texture, EGLImageKHR image);
+
+    void destroyImport(Import& import);
+
+    EGLDisplay eglDisplay_;
+    PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR_;
+    PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR_;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES_;
+    PFNGLEGLIMAGETARGETTEXSTORAGEEXTPROC glEGLImageTargetTexStorageEXT_;
+    bool isDesktopGL_;
+    bool initialized_;
+
+    Import current_;
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_VULKAN_INTEROP
+#endif // VIDEOCOMPOSER_VULKANINTEROP_H
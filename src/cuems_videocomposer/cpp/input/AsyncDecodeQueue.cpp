@@ -5,8 +5,13 @@
  */
 
 #include "AsyncDecodeQueue.h"
+#include "FrameIndexCache.h"
+#include "MediaProbe.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/FrameTracer.h"
 #include <chrono>
+#include <algorithm>
 
 extern "C" {
 #include <libavutil/imgutils.h>
@@ -20,16 +25,36 @@ namespace videocomposer {
 AsyncDecodeQueue::AsyncDecodeQueue()
     : formatCtx_(nullptr)
     , codecCtx_(nullptr)
+    , ownsContexts_(true)
     , decodeFrame_(nullptr)
     , swsCtx_(nullptr)
     , videoStream_(-1)
     , hwDeviceCtx_(nullptr)
     , useHardware_(false)
+    , requestedQueueDepth_(DEFAULT_QUEUE_SIZE)
+    , surfacePoolSize_(0)
+    , surfaceAccount_(MemoryBudget::Subsystem::DECODE_SURFACES, MemoryBudget::NO_LAYER)
+    , surfaceBytes_(0)
     , width_(0)
     , height_(0)
     , framerate_(0)
     , frameCount_(0)
     , ready_(false)
+    , readAheadMode_(ReadAheadIO::Mode::OFF)
+    , readAheadBytes_(ReadAheadIO::DEFAULT_WINDOW_BYTES)
+    , readAheadDirect_(false)
+    , useProbeCache_(false)
+    , intraDecoders_(0)
+    , intraPacket_(nullptr)
+    , lastDispatchedFrame_(-1)
+    , maxQueueSize_(DEFAULT_QUEUE_SIZE)
+    , targetDepth_(DEFAULT_QUEUE_SIZE)
+    , framesSinceDepthEval_(0)
+    , budgetClient_(0)
+    , threadClient_(0)
+    , schedulerClient_(0)
+    , intraSlotsHeld_(0)
+    , decodeEpoch_(0)
 {
     timeBase_ = {1, 1};
     frameRateQ_ = {1, 1};
@@ -39,16 +64,43 @@ AsyncDecodeQueue::~AsyncDecodeQueue() {
     close();
 }
 
-bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCtx) {
+bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCtx,
+                            std::shared_ptr<FramePool> framePool) {
     close();  // Close any existing
     
     filename_ = filename;
     hwDeviceCtx_ = hwDeviceCtx;
+    // The surface pool is created on the decode thread, outside the layer's scope
+    surfaceAccount_ = MemoryBudget::resolve(MemoryBudget::Account(MemoryBudget::Subsystem::DECODE_SURFACES));
+    
+    // Queue slots come from the shared pool; one slot stays reserved for the
+    // frame currently handed out to the caller
+    framePool_ = framePool ? framePool : FramePool::create(DEFAULT_QUEUE_SIZE + 1);
+    maxQueueSize_ = framePool_->capacity() > 1 ? framePool_->capacity() - 1 : 1;
+    frameRing_.reset(framePool_->capacity());
     
     
     // Open format context
     formatCtx_ = nullptr;
-    int ret = avformat_open_input(&formatCtx_, filename.c_str(), nullptr, nullptr);
+    if (readAheadDirect_ || ReadAheadIO::wanted(readAheadMode_, filename)) {
+        readAhead_ = std::make_unique<ReadAheadIO>();
+        if (readAhead_->open(filename, readAheadBytes_, readAheadDirect_)) {
+            formatCtx_ = avformat_alloc_context();
+            formatCtx_->pb = readAhead_->getContext();
+            formatCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+            LOG_INFO << "AsyncDecodeQueue: Read-ahead I/O for " << filename;
+        } else {
+            readAhead_.reset();
+        }
+    }
+    // A cached probe names the demuxer and stands in for find_stream_info
+    FrameIndexCache::Probe probe;
+    bool haveProbe = false;
+    if (useProbeCache_) {
+        haveProbe = FrameIndexCache(probeCacheDir_).loadProbe(filename, probe);
+    }
+    const AVInputFormat* inputFormat = haveProbe ? MediaProbe::inputFormat(probe) : nullptr;
+    int ret = avformat_open_input(&formatCtx_, filename.c_str(), inputFormat, nullptr);
     if (ret < 0) {
         char errbuf[AV_ERROR_MAX_STRING_SIZE];
         av_strerror(ret, errbuf, sizeof(errbuf));
@@ -57,11 +109,16 @@ bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCt
     }
     
     // Find stream info
-    ret = avformat_find_stream_info(formatCtx_, nullptr);
-    if (ret < 0) {
-        LOG_ERROR << "AsyncDecodeQueue: Failed to find stream info";
-        avformat_close_input(&formatCtx_);
-        return false;
+    if (haveProbe && MediaProbe::apply(formatCtx_, probe)) {
+        LOG_VERBOSE << "AsyncDecodeQueue: Using cached probe for " << filename;
+    } else {
+        ret = avformat_find_stream_info(formatCtx_, nullptr);
+        if (ret < 0) {
+            LOG_ERROR << "AsyncDecodeQueue: Failed to find stream info";
+            avformat_close_input(&formatCtx_);
+            return false;
+        }
+        haveProbe = false;
     }
     
     // Find video stream
@@ -78,6 +135,9 @@ bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCt
         avformat_close_input(&formatCtx_);
         return false;
     }
+    if (useProbeCache_ && !haveProbe && MediaProbe::capture(formatCtx_, videoStream_, probe)) {
+        FrameIndexCache(probeCacheDir_).storeProbe(filename, probe);
+    }
     
     AVStream* stream = formatCtx_->streams[videoStream_];
     AVCodecParameters* codecpar = stream->codecpar;
@@ -108,6 +168,14 @@ bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCt
         useHardware_ = false;
     }
     
+    // Hardware frames pin surfaces of the decoder's fixed-size pool; the
+    // pool is sized for this depth in createSurfacePool()
+    if (useHardware_) {
+        maxQueueSize_ = std::min(maxQueueSize_, DEFAULT_QUEUE_SIZE);
+    }
+    requestedQueueDepth_ = maxQueueSize_;
+    surfacePoolSize_ = 0;
+    
     if (!codec) {
         LOG_ERROR << "AsyncDecodeQueue: No decoder found for codec " << codecpar->codec_id;
         avformat_close_input(&formatCtx_);
@@ -140,10 +208,22 @@ bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCt
         }
     }
     
-    // Set thread count for software decode
+    // Own the VAAPI surface pool so its size follows the queue depth
+    if (useHardware_ && codecCtx_->hw_device_ctx) {
+        AVHWDeviceContext* device = reinterpret_cast<AVHWDeviceContext*>(codecCtx_->hw_device_ctx->data);
+        if (device->type == AV_HWDEVICE_TYPE_VAAPI) {
+            codecCtx_->opaque = this;
+            codecCtx_->get_format = &AsyncDecodeQueue::getHwFormat;
+        }
+    }
+    
+    // Software decode shares the global decoder thread budget
     if (!useHardware_) {
-        codecCtx_->thread_count = 4;
-        codecCtx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        DecodeThreadBudget& threads = DecodeThreadBudget::instance();
+        threadClient_ = threads.addClient(codecpar->width, codecpar->height, priority_.load());
+        DecodeThreadBudget::Grant grant = threads.grant(threadClient_);
+        codecCtx_->thread_count = grant.threads;
+        codecCtx_->thread_type = grant.frameThreads ? FF_THREAD_FRAME | FF_THREAD_SLICE : FF_THREAD_SLICE;
     }
     
     // Open codec
@@ -157,12 +237,74 @@ bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCt
         return false;
     }
     
+    if (!start()) {
+        avcodec_free_context(&codecCtx_);
+        avformat_close_input(&formatCtx_);
+        return false;
+    }
+    return true;
+}
+
+bool AsyncDecodeQueue::attach(const std::string& filename, AVFormatContext* formatCtx, int videoStream,
+                              AVCodecContext* codecCtx, std::shared_ptr<FramePool> framePool) {
+    close();
+    surfaceAccount_ = MemoryBudget::resolve(MemoryBudget::Account(MemoryBudget::Subsystem::DECODE_SURFACES));
+    if (!formatCtx || !codecCtx || videoStream < 0 || videoStream >= static_cast<int>(formatCtx->nb_streams)) {
+        return false;
+    }
+    
+    filename_ = filename;
+    formatCtx_ = formatCtx;
+    codecCtx_ = codecCtx;
+    videoStream_ = videoStream;
+    ownsContexts_ = false;
+    useHardware_ = codecCtx->hw_device_ctx != nullptr || codecCtx->hw_frames_ctx != nullptr;
+    
+    framePool_ = framePool ? framePool : FramePool::create(DEFAULT_QUEUE_SIZE + 1);
+    maxQueueSize_ = framePool_->capacity() > 1 ? framePool_->capacity() - 1 : 1;
+    frameRing_.reset(framePool_->capacity());
+    // The owner's decoder sized its surface pool with extra frames for us
+    if (useHardware_) {
+        maxQueueSize_ = std::min(maxQueueSize_, DEFAULT_QUEUE_SIZE);
+    }
+    requestedQueueDepth_ = maxQueueSize_;
+    surfacePoolSize_ = 0;
+    engineMoved_ = false;
+    positionLost_ = true;  // Wherever the owner left the demuxer
+    dropThrough_ = -1;
+    
+    if (!start()) {
+        formatCtx_ = nullptr;
+        codecCtx_ = nullptr;
+        ownsContexts_ = true;
+        return false;
+    }
+    return true;
+}
+
+std::unique_lock<std::recursive_mutex> AsyncDecodeQueue::lockEngine(bool* moved) {
+    if (ownsContexts_) {
+        if (moved) {
+            *moved = false;
+        }
+        return std::unique_lock<std::recursive_mutex>();
+    }
+    std::unique_lock<std::recursive_mutex> lock(engineMutex_);
+    if (moved) {
+        *moved = engineMoved_;
+    }
+    engineMoved_ = false;
+    positionLost_ = true;
+    return lock;
+}
+
+bool AsyncDecodeQueue::start() {
+    AVStream* stream = formatCtx_->streams[videoStream_];
+    
     // Allocate decode frame
     decodeFrame_ = av_frame_alloc();
     if (!decodeFrame_) {
         LOG_ERROR << "AsyncDecodeQueue: Failed to allocate frame";
-        avcodec_free_context(&codecCtx_);
-        avformat_close_input(&formatCtx_);
         return false;
     }
     
@@ -194,16 +336,35 @@ bool AsyncDecodeQueue::open(const std::string& filename, AVBufferRef* hwDeviceCt
         frameCount_ = 0;
     }
     
+    startIntraDecoders();
     ready_ = true;
     
-    LOG_INFO << "AsyncDecodeQueue: Opened " << filename 
+    LOG_INFO << "AsyncDecodeQueue: " << (ownsContexts_ ? "Opened " : "Attached to ") << filename_
              << " (" << width_ << "x" << height_ << " @ " << framerate_ << "fps"
-             << ", " << (useHardware_ ? "hardware" : "software") << " decode)";
+             << ", " << (useHardware_ ? "hardware" : "software") << " decode"
+             << (intraPool_.getWorkers() > 0 ? ", " + std::to_string(intraPool_.getWorkers()) + " intra decoders" : "")
+             << ")";
     
     // Start decode thread
     threadStop_ = false;
     targetFrame_ = 0;
     lastDecodedFrame_ = -1;
+    lastDispatchedFrame_ = -1;
+    decodeEpoch_ = seekEpoch_.load();
+    
+    // Start deep; measured decode times bring the depth down
+    jitter_.reset();
+    resetUnderrunStats();
+    framesSinceDepthEval_ = 0;
+    targetDepth_ = maxQueueSize_;
+    targetDepthStat_ = targetDepth_;
+    budgetClient_ = DecodeAheadBudget::instance().addClient(priority_.load());
+    DecodeScheduler& scheduler = DecodeScheduler::instance();
+    schedulerClient_ = scheduler.addClient(useHardware_ ? DecodeScheduler::Resource::HARDWARE
+                                                        : DecodeScheduler::Resource::CPU, priority_.load());
+    scheduler.setVisible(schedulerClient_, visible_.load());
+    intraSlotsHeld_ = 0;
+    
     decodeThread_ = std::make_unique<std::thread>(&AsyncDecodeQueue::decodeThreadFunc, this);
     
     return true;
@@ -213,19 +374,36 @@ void AsyncDecodeQueue::close() {
     // Stop decode thread
     if (decodeThread_) {
         threadStop_ = true;
-        queueCond_.notify_all();
-        seekCond_.notify_all();
+        wakeCond_.notify_all();
         if (decodeThread_->joinable()) {
             decodeThread_->join();
         }
         decodeThread_.reset();
     }
+    intraPool_.close();  // Hands its slots back before the pool goes
+    if (intraPacket_) {
+        av_packet_free(&intraPacket_);
+    }
     
-    // Clear queue
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        frameQueue_.clear();
+    if (budgetClient_) {
+        DecodeAheadBudget::instance().removeClient(budgetClient_);
+        budgetClient_ = 0;
+    }
+    if (threadClient_) {
+        DecodeThreadBudget::instance().removeClient(threadClient_);
+        threadClient_ = 0;
+    }
+    if (schedulerClient_) {
+        DecodeScheduler::instance().removeClient(schedulerClient_);  // Frees its slots
+        schedulerClient_ = 0;
     }
+    intraSlotsHeld_ = 0;
+    chargeSurfaces(0);
+    
+    // Clear queue (returns slots to the pool); the decode thread is gone
+    frameRing_.clear();
+    lastReturned_.reset();
+    framePool_.reset();
     
     // Cleanup FFmpeg
     if (swsCtx_) {
@@ -237,6 +415,16 @@ void AsyncDecodeQueue::close() {
         av_frame_free(&decodeFrame_);
     }
     
+    if (!ownsContexts_) {
+        // Hand the owner's decoder back as the owner configured it
+        if (codecCtx_) {
+            codecCtx_->skip_frame = AVDISCARD_DEFAULT;
+        }
+        codecCtx_ = nullptr;
+        formatCtx_ = nullptr;
+        ownsContexts_ = true;
+    }
+    
     if (codecCtx_) {
         avcodec_free_context(&codecCtx_);
     }
@@ -244,119 +432,189 @@ void AsyncDecodeQueue::close() {
     if (formatCtx_) {
         avformat_close_input(&formatCtx_);
     }
+    readAhead_.reset();  // After the format context that reads through it
     
     ready_ = false;
 }
 
+bool AsyncDecodeQueue::getReadAheadStats(ReadAheadIO::Stats& stats) const {
+    if (!readAhead_) {
+        return false;
+    }
+    stats = readAhead_->getStats();
+    return true;
+}
+
 AVFrame* AsyncDecodeQueue::getFrame(int64_t frameNumber, int maxWaitMs) {
-    std::unique_lock<std::mutex> lock(queueMutex_);
-    
     // Update target so decode thread knows what we need
     targetFrame_ = frameNumber;
+    uint64_t epoch = seekEpoch_.load(std::memory_order_acquire);
+    
+    // Release frames we've played past (and leftovers from before a seek).
+    // While skipping, the frame shown for the target may be further back.
+    int64_t keepFrom = frameNumber - 2;
+    bool skipping = skipMode_.load() != SkipMode::NONE;
+    if (skipping) {
+        FramePool::Handle shown = frameRing_.findClosestBefore(frameNumber, epoch);
+        if (shown) {
+            keepFrom = std::min(keepFrom, shown->frameNumber);
+        }
+    }
+    frameRing_.dropBefore(keepFrom, epoch);
     
     // Look for frame in queue
-    for (auto& qf : frameQueue_) {
-        if (qf.frameNumber == frameNumber && qf.ready) {
-            return qf.frame;
+    FramePool::Handle qf = frameRing_.find(frameNumber, epoch);
+    if (qf) {
+        framePool_->recordHit();
+        lastReturned_ = qf;
+        return qf->avFrame;
+    }
+    
+    // Discarded by the skip mode: the earlier frame is the one to show
+    if (skipping && frameNumber <= lastDecodedFrame_.load()) {
+        FramePool::Handle closest = frameRing_.findClosestBefore(frameNumber, epoch);
+        if (closest) {
+            lastReturned_ = closest;
+            return closest->avFrame;
         }
     }
+    framePool_->recordMiss();
+    misses_++;
     
-    // Frame not ready - wait if requested
+    // Frame not ready - wait if requested (polling: the decode thread never holds us up)
     if (maxWaitMs > 0) {
         auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxWaitMs);
         
         while (std::chrono::steady_clock::now() < deadline) {
             // Wake decode thread
-            queueCond_.notify_one();
-            
-            // Wait for frame
-            queueCond_.wait_for(lock, std::chrono::milliseconds(1));
+            wakeCond_.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
             
             // Check again
-            for (auto& qf : frameQueue_) {
-                if (qf.frameNumber == frameNumber && qf.ready) {
-                    return qf.frame;
-                }
+            qf = frameRing_.find(frameNumber, epoch);
+            if (qf) {
+                lastReturned_ = qf;
+                return qf->avFrame;
             }
         }
     }
     
     // Frame not available - return closest earlier frame if available
-    AVFrame* closest = nullptr;
-    int64_t closestDiff = INT64_MAX;
-    
-    for (auto& qf : frameQueue_) {
-        if (qf.ready && qf.frameNumber <= frameNumber) {
-            int64_t diff = frameNumber - qf.frameNumber;
-            if (diff < closestDiff) {
-                closestDiff = diff;
-                closest = qf.frame;
-            }
-        }
+    FramePool::Handle closest = frameRing_.findClosestBefore(frameNumber, epoch);
+    if (!closest) {
+        return nullptr;
     }
-    
-    return closest;
+    held_++;
+    lastReturned_ = closest;
+    return closest->avFrame;
 }
 
 void AsyncDecodeQueue::seek(int64_t frameNumber) {
-    // Set seek request
+    // New epoch: frames still arriving from the old position are ignored
     seekTarget_ = frameNumber;
-    seekRequested_ = true;
+    seekEpoch_.fetch_add(1, std::memory_order_acq_rel);
     
-    // Clear queue
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        frameQueue_.clear();
-    }
+    // Clear queue (lastReturned_ is kept: the caller may still display it)
+    frameRing_.clear();
     
     // Update target
     targetFrame_ = frameNumber;
     lastDecodedFrame_ = -1;
     
     // Wake decode thread
-    queueCond_.notify_all();
+    wakeCond_.notify_all();
 }
 
 bool AsyncDecodeQueue::hasFrame(int64_t frameNumber) const {
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    for (const auto& qf : frameQueue_) {
-        if (qf.frameNumber == frameNumber && qf.ready) {
-            return true;
-        }
+    return frameRing_.find(frameNumber, seekEpoch_.load(std::memory_order_acquire)) != nullptr;
+}
+
+bool AsyncDecodeQueue::isFrameReachable(int64_t frameNumber) const {
+    int64_t oldest = frameRing_.oldestFrame();
+    if (oldest >= 0 && frameNumber < oldest) {
+        return false;  // Played or skipped past
+    }
+    // A pending seek counts as being there already
+    int64_t position = std::max(lastDecodedFrame_.load(), seekTarget_.load() - 1);
+    if (oldest < 0 && frameNumber <= position) {
+        return false;
+    }
+    return frameNumber <= position + MAX_FORWARD_GAP;
+}
+
+void AsyncDecodeQueue::setSkipMode(SkipMode mode) {
+    SkipMode previous = skipMode_.exchange(mode);
+    if (previous == SkipMode::KEYFRAMES && mode != SkipMode::KEYFRAMES && ready_) {
+        // Frames after the last keyframe reference what was discarded
+        seek(targetFrame_.load());
     }
-    return false;
 }
 
 void AsyncDecodeQueue::setTargetFrame(int64_t frameNumber) {
     targetFrame_ = frameNumber;
-    queueCond_.notify_one();
+    wakeCond_.notify_one();
+}
+
+void AsyncDecodeQueue::setPriority(int priority) {
+    priority_ = std::max(1, priority);
+    if (budgetClient_) {
+        DecodeAheadBudget::instance().setPriority(budgetClient_, priority_.load());
+    }
+    if (threadClient_) {
+        DecodeThreadBudget::instance().setPriority(threadClient_, priority_.load());
+    }
+    if (schedulerClient_) {
+        DecodeScheduler::instance().setPriority(schedulerClient_, priority_.load());
+    }
+}
+
+void AsyncDecodeQueue::setVisible(bool visible) {
+    if (visible_.exchange(visible) != visible && schedulerClient_) {
+        DecodeScheduler::instance().setVisible(schedulerClient_, visible);
+    }
+}
+
+AsyncDecodeQueue::UnderrunStats AsyncDecodeQueue::getUnderrunStats() const {
+    UnderrunStats stats;
+    stats.misses = misses_;
+    stats.held = held_;
+    stats.skipped = skipped_;
+    return stats;
+}
+
+void AsyncDecodeQueue::resetUnderrunStats() {
+    misses_ = 0;
+    held_ = 0;
+    skipped_ = 0;
 }
 
 size_t AsyncDecodeQueue::getQueueSize() const {
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    return frameQueue_.size();
+    return frameRing_.size();
 }
 
 int64_t AsyncDecodeQueue::getOldestFrame() const {
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    if (frameQueue_.empty()) return -1;
-    return frameQueue_.front().frameNumber;
+    return frameRing_.oldestFrame();
 }
 
 int64_t AsyncDecodeQueue::getNewestFrame() const {
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    if (frameQueue_.empty()) return -1;
-    return frameQueue_.back().frameNumber;
+    return frameRing_.newestFrame();
 }
 
 void AsyncDecodeQueue::decodeThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
     LOG_INFO << "AsyncDecodeQueue: Decode thread started";
+    FrameTracer::instance().setThreadName("decode");
     
     while (!threadStop_) {
-        // Check for seek request
-        if (seekRequested_) {
-            seekRequested_ = false;
+        // Uncontended unless the owner of attached contexts decodes itself
+        std::unique_lock<std::recursive_mutex> engine(engineMutex_);
+        
+        // Check for seek request (a new epoch)
+        uint64_t epoch = seekEpoch_.load(std::memory_order_acquire);
+        if (epoch != decodeEpoch_) {
+            decodeEpoch_ = epoch;
             int64_t seekFrame = seekTarget_.load();
+            flushIntraFrames();  // Frames for the old position
             
             if (!seekInternal(seekFrame)) {
                 LOG_WARNING << "AsyncDecodeQueue: Seek to frame " << seekFrame << " failed";
@@ -365,63 +623,275 @@ void AsyncDecodeQueue::decodeThreadFunc() {
             // Flush decoder
             avcodec_flush_buffers(codecCtx_);
             lastDecodedFrame_ = seekFrame - 1;
+            lastDispatchedFrame_ = seekFrame - 1;
+            positionLost_ = false;
+            dropThrough_ = -1;
+            engineMoved_ = true;
         }
         
         // Check if we should decode more
         int64_t target = targetFrame_.load();
         
-        // Get queue state
-        size_t queueSize;
-        int64_t newestInQueue = -1;
-        {
-            std::lock_guard<std::mutex> lock(queueMutex_);
-            queueSize = frameQueue_.size();
-            if (!frameQueue_.empty()) {
-                newestInQueue = frameQueue_.back().frameNumber;
-            }
-        }
+        // Get queue state (the requesting thread pops frames it has played past)
+        size_t queueSize = frameRing_.size();
+        int64_t newestInQueue = frameRing_.newestFrame();
         
         // Decide if we should decode
+        size_t depth = std::min(targetDepth_, maxQueueSize_);
         bool shouldDecode = false;
-        if (queueSize < MAX_QUEUE_SIZE) {
-            // Queue not full
+        if (queueSize < depth && framePool_->available() > 0) {
+            // Queue not full and a pool slot is free
             if (newestInQueue < 0) {
                 // Queue empty - start from target
                 shouldDecode = true;
-            } else if (newestInQueue < target + static_cast<int64_t>(MAX_QUEUE_SIZE)) {
+            } else if (newestInQueue < target + static_cast<int64_t>(depth)) {
                 // Buffer ahead of target
                 shouldDecode = true;
             }
         }
         
+        // Intra decoders: demux ahead, queue what the decoders finished
+        if (intraPool_.getWorkers() > 0) {
+            bool progressed = retireIntraFrames();
+            if (!threadStop_ && dispatchIntraFrames(target, depth)) {
+                progressed = true;
+            }
+            engine.unlock();
+            if (!progressed) {
+                // The decoders wake us when a frame is done
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wakeCond_.wait_for(lock, std::chrono::milliseconds(2));
+            }
+            continue;
+        }
+        
+        // Catching up or fast playback: let the decoder skip frames nothing
+        // references (or everything but keyframes)
+        bool behind = catchUp_.load() && lastDecodedFrame_.load() < target;
+        SkipMode skipMode = skipMode_.load();
+        AVDiscard discard = skipMode == SkipMode::KEYFRAMES ? AVDISCARD_NONKEY
+                          : (behind || skipMode == SkipMode::NONREF) ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
         if (shouldDecode && !threadStop_) {
-            if (!decodeNextFrame()) {
+            // Our turn among all layers' decodes (not holding the engine
+            // while waiting); a seek meanwhile restarts the loop
+            engine.unlock();
+            DecodeScheduler& scheduler = DecodeScheduler::instance();
+            if (!scheduler.acquire(schedulerClient_, bufferedSeconds(newestInQueue, target),
+                                   std::chrono::milliseconds(5))) {
+                continue;
+            }
+            engine.lock();
+            if (seekEpoch_.load(std::memory_order_acquire) != decodeEpoch_ || threadStop_) {
+                engine.unlock();
+                scheduler.release(schedulerClient_);
+                continue;
+            }
+            if (codecCtx_->skip_frame != discard) {
+                codecCtx_->skip_frame = discard;
+            }
+            // The owner decoded on the shared contexts: continue after the
+            // newest queued frame, dropping what the seek decodes again
+            if (positionLost_) {
+                positionLost_ = false;
+                int64_t resumeFrame = std::max(lastDecodedFrame_.load(), targetFrame_.load() - 1) + 1;
+                if (!seekInternal(resumeFrame)) {
+                    LOG_WARNING << "AsyncDecodeQueue: Resync to frame " << resumeFrame << " failed";
+                }
+                avcodec_flush_buffers(codecCtx_);
+                dropThrough_ = resumeFrame - 1;
+            }
+            engineMoved_ = true;
+            auto decodeStart = std::chrono::steady_clock::now();
+            bool decoded = decodeNextFrame();
+            engine.unlock();
+            scheduler.release(schedulerClient_);
+            if (decoded) {
+                addDecodeTime(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - decodeStart).count());
+            } else {
                 // Decode failed or EOF - wait a bit
-                std::unique_lock<std::mutex> lock(queueMutex_);
-                queueCond_.wait_for(lock, std::chrono::milliseconds(10));
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wakeCond_.wait_for(lock, std::chrono::milliseconds(10));
             }
         } else {
+            engine.unlock();
             // Nothing to do - wait for signal
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            queueCond_.wait_for(lock, std::chrono::milliseconds(5));
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCond_.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+    
+    LOG_INFO << "AsyncDecodeQueue: Decode thread stopped";
+}
+
+void AsyncDecodeQueue::addDecodeTime(double seconds) {
+    jitter_.addSample(seconds);
+    if (++framesSinceDepthEval_ >= DEPTH_EVAL_INTERVAL) {
+        framesSinceDepthEval_ = 0;
+        updateTargetDepth();
+    }
+}
+
+void AsyncDecodeQueue::startIntraDecoders() {
+    if (intraDecoders_ < 2 || useHardware_) {
+        return;
+    }
+    AVCodecParameters* codecpar = formatCtx_->streams[videoStream_]->codecpar;
+    const AVCodecDescriptor* descriptor = avcodec_descriptor_get(codecpar->codec_id);
+    if (!descriptor || !(descriptor->props & AV_CODEC_PROP_INTRA_ONLY)) {
+        return;
+    }
+    
+    // More decoders than queue slots would only wait for slots
+    int workers = std::min(intraDecoders_, static_cast<int>(maxQueueSize_));
+    intraPacket_ = av_packet_alloc();
+    if (workers < 2 || !intraPacket_ ||
+        !intraPool_.open(codecpar, workers, 1, [this]() { wakeCond_.notify_one(); })) {
+        LOG_WARNING << "AsyncDecodeQueue: Parallel intra decoding unavailable, using one decoder";
+        intraPool_.close();
+        av_packet_free(&intraPacket_);
+    }
+}
+
+bool AsyncDecodeQueue::dispatchIntraFrames(int64_t target, size_t depth) {
+    // Keep every decoder busy even when the adaptive depth is shallow
+    const size_t ahead = std::min(std::max(depth, static_cast<size_t>(intraPool_.getWorkers())), maxQueueSize_);
+    bool dispatched = false;
+    
+    while (!threadStop_ && frameRing_.size() + intraPool_.inFlight() < ahead &&
+           lastDispatchedFrame_ < target + static_cast<int64_t>(ahead)) {
+        // The owner decoded on the shared demuxer: continue after what we read
+        if (positionLost_) {
+            positionLost_ = false;
+            int64_t resumeFrame = std::max(lastDispatchedFrame_, targetFrame_.load() - 1) + 1;
+            if (!seekInternal(resumeFrame)) {
+                LOG_WARNING << "AsyncDecodeQueue: Resync to frame " << resumeFrame << " failed";
+            }
+            dropThrough_ = resumeFrame - 1;
         }
+        engineMoved_ = true;
         
-        // Trim old frames from queue
-        {
-            std::lock_guard<std::mutex> lock(queueMutex_);
-            int64_t current = targetFrame_.load();
-            
-            // Remove frames that are more than 2 frames behind current
-            while (!frameQueue_.empty() && frameQueue_.front().frameNumber < current - 2) {
-                frameQueue_.pop_front();
+        // One scheduler slot per frame in the pool, returned when it retires
+        if (!DecodeScheduler::instance().acquire(schedulerClient_, bufferedSeconds(lastDispatchedFrame_, target),
+                                                  std::chrono::milliseconds(0))) {
+            break;
+        }
+        FramePool::Handle slot = framePool_->acquire();
+        if (!slot) {
+            DecodeScheduler::instance().release(schedulerClient_);
+            break;  // Caller holds the slots
+        }
+        
+        // Next video packet
+        int ret;
+        while ((ret = av_read_frame(formatCtx_, intraPacket_)) >= 0 && intraPacket_->stream_index != videoStream_) {
+            av_packet_unref(intraPacket_);
+        }
+        if (ret < 0) {
+            DecodeScheduler::instance().release(schedulerClient_);
+            break;  // EOF: the decoders finish what they have
+        }
+        
+        // Packets of intra-only streams are in presentation order
+        int64_t pts = intraPacket_->pts != AV_NOPTS_VALUE ? intraPacket_->pts : intraPacket_->dts;
+        int64_t frameNum = pts != AV_NOPTS_VALUE
+            ? static_cast<int64_t>(pts * av_q2d(timeBase_) * framerate_ + 0.5)
+            : lastDispatchedFrame_ + 1;
+        lastDispatchedFrame_ = frameNum;
+        
+        bool drop = frameNum <= dropThrough_;
+        if (!drop) {
+            dropThrough_ = -1;
+            // Late frames are not worth decoding
+            if (catchUp_ && frameNum < targetFrame_.load()) {
+                skipped_++;
+                drop = true;
             }
         }
+        if (!drop && intraPool_.submit(intraPacket_, frameNum, std::move(slot))) {
+            intraSlotsHeld_++;
+            dispatched = true;
+        } else {
+            DecodeScheduler::instance().release(schedulerClient_);
+        }
+        av_packet_unref(intraPacket_);
+    }
+    return dispatched;
+}
+
+bool AsyncDecodeQueue::retireIntraFrames() {
+    IntraDecoderPool::Result result;
+    bool retired = false;
+    while (intraPool_.retire(result)) {
+        retired = true;
+        if (intraSlotsHeld_ > 0) {
+            intraSlotsHeld_--;
+            DecodeScheduler::instance().release(schedulerClient_);
+        }
+        if (!result.ok) {
+            result.slot.reset();
+            continue;
+        }
+        result.slot->frameNumber = result.frameNumber;
+        frameRing_.push(std::move(result.slot), decodeEpoch_);
+        decodedFrames_.fetch_add(1, std::memory_order_relaxed);
+        if (result.frameNumber > lastDecodedFrame_.load()) {
+            lastDecodedFrame_ = result.frameNumber;
+        }
+        // The queue fills at the pool's rate, not one decoder's
+        addDecodeTime(result.decodeSeconds / intraPool_.getWorkers());
+    }
+    return retired;
+}
+
+void AsyncDecodeQueue::flushIntraFrames() {
+    intraPool_.flush();
+    DecodeScheduler& scheduler = DecodeScheduler::instance();
+    for (; intraSlotsHeld_ > 0; --intraSlotsHeld_) {
+        scheduler.release(schedulerClient_);
+    }
+}
+
+double AsyncDecodeQueue::bufferedSeconds(int64_t newestFrame, int64_t target) const {
+    if (newestFrame < target || framerate_ <= 0.0) {
+        return 0.0;
+    }
+    return static_cast<double>(newestFrame - target + 1) / framerate_;
+}
+
+void AsyncDecodeQueue::updateTargetDepth() {
+    DecodeAheadBudget& budget = DecodeAheadBudget::instance();
+    decodeTimeStat_ = jitter_.percentile(0.5);
+    size_t minDepth = std::min(MIN_HW_QUEUE_DEPTH, maxQueueSize_);
+    size_t wanted = jitter_.depthFor(framerate_ > 0 ? 1.0 / framerate_ : 0.0,
+                                     budget.getUnderrunProbability(),
+                                     minDepth, maxQueueSize_);
+
+    // Frames of this layer the shared budget allows
+    size_t bytesPerFrame = framePool_->getStats().bytesPerFrame;
+    if (bytesPerFrame == 0) {
+        bytesPerFrame = static_cast<size_t>(width_) * height_ * 3 / 2;
+    }
+    if (bytesPerFrame > 0) {
+        size_t granted = budget.request(budgetClient_, wanted * bytesPerFrame) / bytesPerFrame;
+        wanted = std::max(minDepth, std::min(wanted, granted));
+    }
+
+    // Grow at once (an underrun is near), shrink one frame at a time
+    targetDepth_ = std::min(targetDepth_, maxQueueSize_);
+    size_t depth = wanted >= targetDepth_ ? wanted : targetDepth_ - 1;
+    if (depth != targetDepth_) {
+        LOG_VERBOSE << "AsyncDecodeQueue: Decode-ahead depth " << targetDepth_ << " -> " << depth
+                    << " (decode p50 " << jitter_.percentile(0.5) * 1000.0
+                    << " ms, p" << (1.0 - budget.getUnderrunProbability()) * 100.0
+                    << " " << jitter_.percentile(1.0 - budget.getUnderrunProbability()) * 1000.0 << " ms)";
+        targetDepth_ = depth;
+        targetDepthStat_ = depth;
     }
-    
-    LOG_INFO << "AsyncDecodeQueue: Decode thread stopped";
 }
 
 bool AsyncDecodeQueue::decodeNextFrame() {
+    FRAME_TRACE_SCOPE("decode.async");
     AVPacket* packet = av_packet_alloc();
     if (!packet) return false;
     
@@ -497,61 +967,128 @@ bool AsyncDecodeQueue::decodeNextFrame() {
         frameNum = lastDecodedFrame_ + 1;
     }
     
-    // For VAAPI hardware frames, sync the GPU before marking frame as ready
-    // This ensures the decode is complete before we put it in the queue
-    if (useHardware_ && decodeFrame_->format == AV_PIX_FMT_VAAPI) {
-        VASurfaceID surface = (VASurfaceID)(uintptr_t)decodeFrame_->data[3];
-        if (surface != VA_INVALID_SURFACE && hwDeviceCtx_) {
-            AVHWDeviceContext* hwctx = (AVHWDeviceContext*)hwDeviceCtx_->data;
-            AVVAAPIDeviceContext* vactx = (AVVAAPIDeviceContext*)hwctx->hwctx;
-            VADisplay vaDisplay = vactx->display;
-            
-            // Sync the surface - blocks until GPU decode is complete
-            VAStatus vaStatus = vaSyncSurface(vaDisplay, surface);
-            if (vaStatus != VA_STATUS_SUCCESS) {
-                LOG_WARNING << "AsyncDecodeQueue: vaSyncSurface failed: " << vaStatus;
-            }
-        }
+    // Decoded again by a resync seek: already queued before
+    if (frameNum <= dropThrough_) {
+        av_frame_unref(decodeFrame_);
+        return true;
+    }
+    dropThrough_ = -1;
+    
+    // Frames the decoder skipped show up as gaps (fast playback skips are
+    // not underruns); late frames are not worth a slot, except a keyframe
+    // just behind the target in keyframe-only mode, which is what is shown
+    SkipMode skipMode = skipMode_.load();
+    if (codecCtx_->skip_frame == AVDISCARD_NONREF && skipMode == SkipMode::NONE &&
+        lastDecodedFrame_ >= 0 && frameNum > lastDecodedFrame_ + 1) {
+        skipped_ += static_cast<uint64_t>(frameNum - lastDecodedFrame_ - 1);
     }
+    if (catchUp_ && skipMode != SkipMode::KEYFRAMES && frameNum < targetFrame_.load()) {
+        av_frame_unref(decodeFrame_);
+        lastDecodedFrame_ = frameNum;
+        skipped_++;
+        return true;
+    }
+    
+    // VAAPI frames are queued without waiting for the GPU decode to finish:
+    // VaapiInterop waits on the surface's fence when it is imported, so the
+    // decode thread can keep submitting and the hardware queue stays full
     
-    // Create queue entry
-    QueuedFrame qf;
-    qf.frameNumber = frameNum;
-    qf.frame = av_frame_alloc();
-    if (!qf.frame) {
+    // Take a slot from the pool (no per-frame allocation)
+    FramePool::Handle qf = framePool_->acquire();
+    if (!qf || !qf->avFrame) {
+        // Pool exhausted (caller holding frames) - drop this frame
+        av_frame_unref(decodeFrame_);
+        lastDecodedFrame_ = frameNum;
         return false;
     }
+    qf->frameNumber = frameNum;
     
     // Move frame data (avoids copy for hardware frames)
-    av_frame_move_ref(qf.frame, decodeFrame_);
-    qf.ready = true;
+    av_frame_move_ref(qf->avFrame, decodeFrame_);
     
-    // Add to queue
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        
-        // Insert in order
-        bool inserted = false;
-        for (auto it = frameQueue_.begin(); it != frameQueue_.end(); ++it) {
-            if (it->frameNumber > frameNum) {
-                frameQueue_.insert(it, std::move(qf));
-                inserted = true;
-                break;
-            }
-        }
-        if (!inserted) {
-            frameQueue_.push_back(std::move(qf));
-        }
-    }
+    // Publish (decoder output is in presentation order; lookups don't rely on it)
+    // Never fails: the loop only decodes while the ring has room
+    frameRing_.push(std::move(qf), decodeEpoch_);
+    decodedFrames_.fetch_add(1, std::memory_order_relaxed);
     
     lastDecodedFrame_ = frameNum;
     
-    // Notify waiting threads
-    queueCond_.notify_all();
-    
     return true;
 }
 
+AVPixelFormat AsyncDecodeQueue::getHwFormat(AVCodecContext* ctx, const AVPixelFormat* formats) {
+    AsyncDecodeQueue* self = static_cast<AsyncDecodeQueue*>(ctx->opaque);
+    for (const AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; p++) {
+        if (*p == AV_PIX_FMT_VAAPI) {
+            if (!self->createSurfacePool(ctx)) {
+                // Let the hwaccel allocate its default pool (previous behaviour)
+                av_buffer_unref(&ctx->hw_frames_ctx);
+            }
+            return AV_PIX_FMT_VAAPI;
+        }
+    }
+    // No VAAPI for this stream: take the decoder's preferred software format
+    return avcodec_default_get_format(ctx, formats);
+}
+
+void AsyncDecodeQueue::chargeSurfaces(size_t bytes) {
+    MemoryBudget& budget = MemoryBudget::instance();
+    budget.release(surfaceAccount_, surfaceBytes_);
+    surfaceBytes_ = bytes;
+    budget.charge(surfaceAccount_, surfaceBytes_);
+}
+
+bool AsyncDecodeQueue::createSurfacePool(AVCodecContext* ctx) {
+    // Called again when the stream parameters change: start from scratch
+    av_buffer_unref(&ctx->hw_frames_ctx);
+    chargeSurfaces(0);
+
+    size_t depth = requestedQueueDepth_;
+    for (;;) {
+        AVBufferRef* framesRef = nullptr;
+        if (avcodec_get_hw_frames_parameters(ctx, ctx->hw_device_ctx, AV_PIX_FMT_VAAPI, &framesRef) < 0) {
+            LOG_WARNING << "AsyncDecodeQueue: No VAAPI frame parameters, using the decoder's surface pool";
+            return false;
+        }
+        AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(framesRef->data);
+
+        // initial_pool_size is what the decoder itself references (DPB +
+        // output); 0 means the pool grows on demand and needs no sizing
+        int decoderSurfaces = frames->initial_pool_size;
+        if (decoderSurfaces > 0) {
+            frames->initial_pool_size = decoderSurfaces + static_cast<int>(depth) + SURFACES_OUTSIDE_QUEUE;
+        }
+        if (av_hwframe_ctx_init(framesRef) >= 0) {
+            ctx->hw_frames_ctx = framesRef;
+            surfacePoolSize_ = frames->initial_pool_size;
+            // 4:2:0, 8 or 16 bits a sample
+            size_t surfaceBytes = static_cast<size_t>(frames->width) * frames->height *
+                                  (frames->sw_format == AV_PIX_FMT_P010 ? 6 : 3) / 2;
+            chargeSurfaces(static_cast<size_t>(std::max(surfacePoolSize_, 0)) * surfaceBytes);
+            if (depth < requestedQueueDepth_) {
+                LOG_WARNING << "AsyncDecodeQueue: VAAPI surface pool limited, queue depth "
+                            << requestedQueueDepth_ << " -> " << depth;
+            }
+            LOG_INFO << "AsyncDecodeQueue: VAAPI surface pool " << surfacePoolSize_
+                     << " (decoder " << decoderSurfaces << ", queue " << depth
+                     << ", held " << SURFACES_OUTSIDE_QUEUE << ")";
+            maxQueueSize_ = depth;
+            return true;
+        }
+        av_buffer_unref(&framesRef);
+
+        // Out of surfaces (other layers hold theirs): try a shallower queue
+        if (decoderSurfaces <= 0 || depth <= MIN_HW_QUEUE_DEPTH) {
+            LOG_WARNING << "AsyncDecodeQueue: Could not allocate a VAAPI surface pool, "
+                        << "using the decoder's default pool";
+            maxQueueSize_ = MIN_HW_QUEUE_DEPTH;
+            surfacePoolSize_ = 0;
+            return false;
+        }
+        depth = std::max(MIN_HW_QUEUE_DEPTH, depth / 2);
+    }
+}
+
 bool AsyncDecodeQueue::seekInternal(int64_t frameNumber) {
     if (!formatCtx_ || videoStream_ < 0) {
         return false;
@@ -3,13 +3,21 @@
 
 #include "../video/FrameBuffer.h"
 #include "../video/GPUTextureFrameBuffer.h"
+#include "../video/FramePool.h"
+#include "../video/MemoryBudget.h"
+#include "SpscFrameRing.h"
+#include "DecodeJitterTracker.h"
+#include "DecodeAheadBudget.h"
+#include "DecodeThreadBudget.h"
+#include "DecodeScheduler.h"
+#include "ReadAheadIO.h"
+#include "IntraDecoderPool.h"
 #include <string>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
-#include <deque>
 #include <functional>
 
 extern "C" {
@@ -33,14 +41,73 @@ class VaapiInterop;
  * - Main thread requests frames by number, gets them from queue instantly
  * - Pre-buffers ahead of current playback position
  * - Handles seeking by flushing queue and restarting
+ * - Queue entries are slots of a FramePool (shared with the owning
+ *   VideoFileInput), so queue depth is bounded by the layer's memory budget
+ * - The queue is a lock-free SPSC ring (SpscFrameRing): getFrame() and
+ *   hasFrame() never take a lock the decode thread holds. A seek bumps an
+ *   epoch instead of synchronizing with the decode thread; frames decoded
+ *   for the old position are ignored and released
+ *
+ * getFrame(), seek(), hasFrame() and setTargetFrame() must be called from
+ * one thread (the ring's consumer).
  * 
  * For VAAPI hardware decode:
- * - Decode thread creates AVFrames with VAAPI surfaces
- * - Main thread does vaSyncSurface + EGL import (fast)
+ * - Decode thread creates AVFrames with VAAPI surfaces and queues them
+ *   without waiting for the decode to complete
+ * - Main thread does the EGL import; VaapiInterop makes the GPU wait on the
+ *   surface's fence (vaSyncSurface only as a fallback)
  * - This decouples slow GPU decode from display timing
+ * - The surface pool (hw_frames_ctx) is created here, sized for the
+ *   decoder's references plus the queue depth plus the frames held by the
+ *   caller and the interop. If the driver cannot allocate that many
+ *   surfaces the queue depth is reduced instead of failing the decode.
+ *
+ * The decode-ahead depth adapts to the measured decode times
+ * (DecodeJitterTracker): steady decoders keep a short queue, jittery ones
+ * buffer deeper, up to the pool size. The memory this takes is shared
+ * with the other layers through DecodeAheadBudget, by priority.
+ *
+ * With catch-up enabled (UnderrunPolicy::DROP) a decoder that falls
+ * behind playback skips non-reference frames and stops queueing frames
+ * that are already late, until it is back ahead of the target.
+ *
+ * For fast playback (SkipMode) the decoder discards the frames that are
+ * not shown anyway: non-reference frames, or everything but keyframes.
+ * A request for a discarded frame gets the nearest earlier one.
+ *
+ * attach() serves from the owner's demuxer and decoder instead of opening
+ * a second set on the same file. The owner then takes lockEngine() around
+ * its own decoding (synchronous fallback, reverse playback); the decode
+ * thread is parked meanwhile and afterwards re-seeks to where it left off.
+ *
+ * With setIntraDecoders() an intra-only software stream is decoded on
+ * several decoders at once (IntraDecoderPool): the decode thread only
+ * demuxes, hands each packet to the next free decoder and queues the
+ * frames in packet order. Late frames are dropped before decoding.
+ *
+ * Each frame decoded ahead waits for a DecodeScheduler slot first, so
+ * under load the layers closest to running dry decode first.
  */
 class AsyncDecodeQueue {
 public:
+    /**
+     * Underrun counters (since open or the last reset)
+     */
+    struct UnderrunStats {
+        uint64_t misses = 0;   // Requested frame not decoded in time
+        uint64_t held = 0;     // Misses served with the nearest earlier frame
+        uint64_t skipped = 0;  // Frames skipped or discarded while catching up
+    };
+
+    /**
+     * Frames the decoder discards during fast playback
+     */
+    enum class SkipMode {
+        NONE,
+        NONREF,     // Frames nothing references (AVDISCARD_NONREF)
+        KEYFRAMES   // All but keyframes (AVDISCARD_NONKEY)
+    };
+
     AsyncDecodeQueue();
     ~AsyncDecodeQueue();
 
@@ -48,9 +115,29 @@ public:
      * Open video file and start decode thread
      * @param filename Path to video file
      * @param hwDeviceCtx Hardware device context (for VAAPI, can be nullptr for software)
+     * @param framePool Pool to take queue slots from (nullptr = create a private
+     *                  pool of DEFAULT_QUEUE_SIZE frames)
      * @return true on success
      */
-    bool open(const std::string& filename, AVBufferRef* hwDeviceCtx = nullptr);
+    bool open(const std::string& filename, AVBufferRef* hwDeviceCtx = nullptr,
+              std::shared_ptr<FramePool> framePool = nullptr);
+
+    /**
+     * Start the decode thread on an open demuxer and decoder owned by the
+     * caller (not freed by close(); the caller must outlive the queue)
+     * @param filename For log messages
+     * @return true on success
+     */
+    bool attach(const std::string& filename, AVFormatContext* formatCtx, int videoStream,
+                AVCodecContext* codecCtx, std::shared_ptr<FramePool> framePool);
+
+    /**
+     * Exclusive use of attached contexts for the caller's own decoding
+     * (recursive; no-op after open()). Queued frames stay valid.
+     * @param moved Set if the decode thread used the contexts since the
+     *              previous lock: the caller's idea of the position is stale
+     */
+    std::unique_lock<std::recursive_mutex> lockEngine(bool* moved = nullptr);
 
     /**
      * Close and stop decode thread
@@ -63,7 +150,8 @@ public:
      * If not, waits briefly then returns nullptr (caller should use previous frame).
      * @param frameNumber Requested frame number
      * @param maxWaitMs Maximum time to wait if frame not ready (0 = no wait)
-     * @return AVFrame pointer (caller must NOT free) or nullptr
+     * @return AVFrame pointer (caller must NOT free) or nullptr.
+     *         The frame stays valid until the next getFrame()/seek()/close().
      */
     AVFrame* getFrame(int64_t frameNumber, int maxWaitMs = 0);
 
@@ -78,6 +166,12 @@ public:
      */
     bool hasFrame(int64_t frameNumber) const;
 
+    /**
+     * Check if the decode thread will deliver a frame without a seek
+     * (false when it has already passed it or is too far behind it)
+     */
+    bool isFrameReachable(int64_t frameNumber) const;
+
     /**
      * Get video properties
      */
@@ -101,40 +195,91 @@ public:
     int64_t getOldestFrame() const;
     int64_t getNewestFrame() const;
 
+    /**
+     * Get the frame pool backing the queue (for statistics)
+     */
+    std::shared_ptr<FramePool> getFramePool() const { return framePool_; }
+
+    /**
+     * Current adaptive decode-ahead depth (frames)
+     */
+    size_t getTargetDepth() const { return targetDepthStat_.load(); }
+
+    /**
+     * Median decode time of recent frames (seconds, 0 until measured)
+     */
+    double getDecodeTime() const { return decodeTimeStat_.load(); }
+
+    /**
+     * Frames decoded into the queue so far (for decode rates)
+     */
+    uint64_t getDecodedFrameCount() const { return decodedFrames_.load(std::memory_order_relaxed); }
+
+    /**
+     * Share of the decode-ahead budget relative to other layers (>= 1)
+     */
+    void setPriority(int priority);
+
+    /**
+     * Whether the layer is on screen (hidden layers decode after visible ones)
+     */
+    void setVisible(bool visible);
+
+    /**
+     * Skip non-reference frames and drop late frames while behind the target
+     */
+    void setCatchUp(bool enabled) { catchUp_ = enabled; }
+
+    /**
+     * Discard frames fast playback does not show. Leaving KEYFRAMES
+     * restarts decoding at the target (the skipped frames are references).
+     */
+    void setSkipMode(SkipMode mode);
+    SkipMode getSkipMode() const { return skipMode_.load(); }
+
+    UnderrunStats getUnderrunStats() const;
+    void resetUnderrunStats();
+
+    /**
+     * Read the file through ReadAheadIO (applies to the next open())
+     * @param windowBytes Read-ahead window
+     * @param direct Read with O_DIRECT (implies read-ahead whatever the mode)
+     */
+    void setReadAhead(ReadAheadIO::Mode mode, size_t windowBytes, bool direct = false) {
+        readAheadMode_ = mode;
+        readAheadBytes_ = windowBytes;
+        readAheadDirect_ = direct;
+    }
+
+    /**
+     * Reuse the cached demuxer probe of the file instead of
+     * avformat_find_stream_info (applies to the next open())
+     * @param cacheDir Frame index cache directory (empty = default)
+     */
+    void setProbeCache(bool enabled, const std::string& cacheDir = std::string()) {
+        useProbeCache_ = enabled;
+        probeCacheDir_ = cacheDir;
+    }
+
+    /**
+     * Decode intra-only software streams on this many decoders at once
+     * (applies to the next open()/attach(); 0 or 1 = a single decoder).
+     * The frame pool needs a slot per decoder to keep them all busy.
+     */
+    void setIntraDecoders(int decoders) { intraDecoders_ = decoders; }
+
+    /** Decoders working in parallel (0 = single decoder) */
+    int getIntraDecoders() const { return intraPool_.getWorkers(); }
+
+    /**
+     * Storage I/O statistics
+     * @return false if the file is read through libavformat's own I/O
+     */
+    bool getReadAheadStats(ReadAheadIO::Stats& stats) const;
+
 private:
-    // Decoded frame in queue
-    struct QueuedFrame {
-        int64_t frameNumber;
-        AVFrame* frame;  // Owned by this struct
-        bool ready;
-        
-        QueuedFrame() : frameNumber(-1), frame(nullptr), ready(false) {}
-        ~QueuedFrame() {
-            if (frame) {
-                av_frame_free(&frame);
-            }
-        }
-        
-        // Move-only
-        QueuedFrame(QueuedFrame&& other) noexcept 
-            : frameNumber(other.frameNumber), frame(other.frame), ready(other.ready) {
-            other.frame = nullptr;
-        }
-        QueuedFrame& operator=(QueuedFrame&& other) noexcept {
-            if (this != &other) {
-                if (frame) av_frame_free(&frame);
-                frameNumber = other.frameNumber;
-                frame = other.frame;
-                ready = other.ready;
-                other.frame = nullptr;
-            }
-            return *this;
-        }
-        
-        // No copy
-        QueuedFrame(const QueuedFrame&) = delete;
-        QueuedFrame& operator=(const QueuedFrame&) = delete;
-    };
+    // Shared tail of open() and attach(): frame, stream properties, decode thread
+    bool start();
 
     // Decode thread function
     void decodeThreadFunc();
@@ -142,10 +287,25 @@ private:
     // Internal decode (called from thread)
     bool decodeNextFrame();
     bool seekInternal(int64_t frameNumber);
+    void updateTargetDepth();
+    void addDecodeTime(double seconds);
+    
+    // Intra-only streams on IntraDecoderPool (called from the decode thread)
+    void startIntraDecoders();
+    bool dispatchIntraFrames(int64_t target, size_t depth);
+    bool retireIntraFrames();
+    void flushIntraFrames();
+    double bufferedSeconds(int64_t newestFrame, int64_t target) const;  // Scheduler slack
+
+    // VAAPI surface pool negotiation (called by the decoder from get_format)
+    static AVPixelFormat getHwFormat(AVCodecContext* ctx, const AVPixelFormat* formats);
+    bool createSurfacePool(AVCodecContext* ctx);
+    void chargeSurfaces(size_t bytes);
     
     // FFmpeg objects (owned by decode thread)
     AVFormatContext* formatCtx_;
     AVCodecContext* codecCtx_;
+    bool ownsContexts_;             // false after attach()
     AVFrame* decodeFrame_;
     SwsContext* swsCtx_;
     int videoStream_;
@@ -155,6 +315,13 @@ private:
     // Hardware decoding
     AVBufferRef* hwDeviceCtx_;  // Not owned, shared from VideoFileInput
     bool useHardware_;
+    size_t requestedQueueDepth_;   // Depth asked for before surface pool negotiation
+    int surfacePoolSize_;          // Surfaces in our hw_frames_ctx (0 = decoder default pool)
+    MemoryBudget::Account surfaceAccount_;  // Layer that opened the queue
+    size_t surfaceBytes_;          // Charged for the surface pool
+    static constexpr size_t MIN_HW_QUEUE_DEPTH = 2;
+    static constexpr int SURFACES_OUTSIDE_QUEUE = 3;  // Frame handed out + interop current/previous
+    static constexpr int64_t MAX_FORWARD_GAP = 30;    // Further ahead than this needs a seek
     
     // Video properties
     int width_;
@@ -164,23 +331,70 @@ private:
     bool ready_;
     std::string filename_;
     
-    // Frame queue
-    static constexpr size_t MAX_QUEUE_SIZE = 8;  // Buffer up to 8 frames
-    std::deque<QueuedFrame> frameQueue_;
-    mutable std::mutex queueMutex_;
-    std::condition_variable queueCond_;
+    // Storage reads (nullptr = libavformat file protocol)
+    ReadAheadIO::Mode readAheadMode_;
+    size_t readAheadBytes_;
+    bool readAheadDirect_;
+    std::unique_ptr<ReadAheadIO> readAhead_;
+    
+    // Cached stream probe (FrameIndexCache/MediaProbe)
+    bool useProbeCache_;
+    std::string probeCacheDir_;
+    
+    // Parallel decoding of intra-only streams
+    int intraDecoders_;                 // Requested
+    IntraDecoderPool intraPool_;
+    AVPacket* intraPacket_;
+    int64_t lastDispatchedFrame_;       // Newest frame handed to the pool
+    
+    // Frame queue (slots owned by framePool_)
+    static constexpr size_t DEFAULT_QUEUE_SIZE = 8;  // Used when no pool is supplied
+    std::shared_ptr<FramePool> framePool_;
+    size_t maxQueueSize_;
+    SpscFrameRing frameRing_;         // Decode thread pushes, caller pops
+    FramePool::Handle lastReturned_;  // Keeps the frame handed to the caller alive
+    
+    // Adaptive decode-ahead depth (decode thread)
+    static constexpr int DEPTH_EVAL_INTERVAL = 30;  // Decoded frames between re-evaluations
+    DecodeJitterTracker jitter_;
+    size_t targetDepth_;
+    int framesSinceDepthEval_;
+    std::atomic<size_t> targetDepthStat_{0};
+    std::atomic<double> decodeTimeStat_{0.0};
+    std::atomic<uint64_t> decodedFrames_{0};
+    DecodeAheadBudget::ClientId budgetClient_;
+    std::atomic<int> priority_{DecodeAheadBudget::DEFAULT_PRIORITY};
+    DecodeThreadBudget::ClientId threadClient_;  // Software decode only
+    DecodeScheduler::ClientId schedulerClient_;
+    std::atomic<bool> visible_{true};
+    int intraSlotsHeld_;  // Scheduler slots of the frames in the intra pool
+    
+    // Underrun handling
+    std::atomic<bool> catchUp_{false};
+    std::atomic<SkipMode> skipMode_{SkipMode::NONE};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> held_{0};
+    std::atomic<uint64_t> skipped_{0};
     
     // Decode thread control
     std::unique_ptr<std::thread> decodeThread_;
     std::atomic<bool> threadStop_{false};
     std::atomic<int64_t> targetFrame_{0};
     std::atomic<int64_t> lastDecodedFrame_{-1};
-    std::atomic<bool> seekRequested_{false};
     std::atomic<int64_t> seekTarget_{0};
+    std::atomic<uint64_t> seekEpoch_{0};  // Bumped by seek()
+    uint64_t decodeEpoch_;                // Epoch the decode thread is decoding for
+    
+    // Attached contexts: the decode thread holds engineMutex_ while it
+    // seeks or decodes, the owner while it decodes on its own
+    std::recursive_mutex engineMutex_;
+    bool engineMoved_ = false;     // Decode thread used the contexts (guarded by engineMutex_)
+    bool positionLost_ = false;    // Owner used them; re-seek before decoding on (guarded)
+    int64_t dropThrough_ = -1;     // After that re-seek: frames already queued (decode thread)
     
-    // Synchronization
-    std::condition_variable seekCond_;
-    std::mutex seekMutex_;
+    // Idle wait of the decode thread (only it locks the mutex; callers just notify)
+    std::condition_variable wakeCond_;
+    std::mutex wakeMutex_;
 };
 
 } // namespace videocomposer
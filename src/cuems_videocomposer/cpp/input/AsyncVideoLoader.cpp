@@ -1,5 +1,5 @@
 /**
- * AsyncVideoLoader.cpp - Background thread for video file loading
+ * AsyncVideoLoader.cpp - Background threads for video file loading
  * 
  * Implements async video loading to avoid blocking the main render loop.
  */
@@ -7,8 +7,15 @@
 #include "AsyncVideoLoader.h"
 #include "VideoFileInput.h"
 #include "HAPVideoInput.h"
+#include "ImageSequenceInput.h"
+#include "MosaicInput.h"
+#include "StillImageInput.h"
 #include "HardwareDecoder.h"
+#include "RamClipCache.h"
+#include "PageCachePolicy.h"
+#include "ProxyMedia.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
 #include "../config/ConfigurationManager.h"
 #include "../display/DisplayBackend.h"
 #include <algorithm>
@@ -20,6 +27,7 @@ AsyncVideoLoader::AsyncVideoLoader()
     : config_(nullptr)
     , displayBackend_(nullptr)
     , running_(false)
+    , nextRequestId_(1)
 {
 }
 
@@ -31,11 +39,20 @@ void AsyncVideoLoader::initialize(ConfigurationManager* config, DisplayBackend*
     config_ = config;
     displayBackend_ = displayBackend;
 
-    // Start worker thread
+    // One worker per core by default: opens are mostly disk and demuxer bound
+    int threads = config_ ? config_->getInt("loader_threads", -1) : -1;
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, 8));
+    }
+
+    // Start worker threads
     running_ = true;
-    workerThread_ = std::make_unique<std::thread>(&AsyncVideoLoader::workerThread, this);
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back(&AsyncVideoLoader::workerThread, this);
+    }
     
-    LOG_INFO << "AsyncVideoLoader: Worker thread started";
+    LOG_INFO << "AsyncVideoLoader: " << threads << " worker thread(s) started";
 }
 
 void AsyncVideoLoader::shutdown() {
@@ -43,68 +60,139 @@ void AsyncVideoLoader::shutdown() {
         return;
     }
 
-    // Signal thread to stop
-    running_ = false;
+    // Signal threads to stop and abort opens in progress
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        running_ = false;
+        for (const auto& cancelled : activeLoads_) {
+            *cancelled = true;
+        }
+    }
     requestCond_.notify_all();
 
-    // Wait for thread to finish
-    if (workerThread_ && workerThread_->joinable()) {
-        workerThread_->join();
+    // Wait for threads to finish
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
     }
-    workerThread_.reset();
+    workers_.clear();
 
     // Clear queues
     {
         std::lock_guard<std::mutex> lock(requestMutex_);
-        std::queue<LoadRequest> empty;
-        std::swap(requestQueue_, empty);
+        requestQueue_.clear();
+        pending_.clear();
+        openingFiles_.clear();
+        activeLoads_.clear();
     }
     {
         std::lock_guard<std::mutex> lock(resultMutex_);
-        std::queue<LoadResult> empty;
-        std::swap(resultQueue_, empty);
-    }
-    {
-        std::lock_guard<std::mutex> lock(pendingMutex_);
-        pendingCueIds_.clear();
+        resultQueue_.clear();
     }
 
     LOG_INFO << "AsyncVideoLoader: Shut down";
 }
 
-void AsyncVideoLoader::requestLoad(const std::string& cueId, const std::string& filepath, LoadCallback callback) {
-    {
-        std::lock_guard<std::mutex> lock(pendingMutex_);
-        pendingCueIds_.insert(cueId);
-    }
-
+void AsyncVideoLoader::requestLoad(const std::string& cueId, const std::string& filepath, LoadCallback callback,
+                                   Priority priority, bool preload, int displayWidth, int displayHeight) {
     {
         std::lock_guard<std::mutex> lock(requestMutex_);
-        requestQueue_.push({cueId, filepath, callback});
+        auto it = pending_.find(cueId);
+        if (it != pending_.end() && it->second.filepath == filepath) {
+            // Same file already pending for this cue: keep that load
+            for (auto& request : requestQueue_) {
+                if (request.id == it->second.id) {
+                    request.priority = std::max(request.priority, priority);
+                    request.preload = request.preload || preload;
+                    request.displayWidth = displayWidth;
+                    request.displayHeight = displayHeight;
+                    request.callback = std::move(callback);
+                    break;
+                }
+            }
+            LOG_INFO << "AsyncVideoLoader: Load of '" << filepath << "' already pending (cue: " << cueId << ")";
+            return;
+        }
+        if (it != pending_.end()) {
+            LOG_INFO << "AsyncVideoLoader: '" << filepath << "' supersedes '" << it->second.filepath
+                     << "' (cue: " << cueId << ")";
+            cancelLocked(cueId);
+        }
+
+        LoadRequest request;
+        request.id = nextRequestId_++;
+        request.cueId = cueId;
+        request.filepath = filepath;
+        request.callback = std::move(callback);
+        request.priority = priority;
+        request.preload = preload;
+        request.displayWidth = displayWidth;
+        request.displayHeight = displayHeight;
+        request.cancelled = std::make_shared<std::atomic<bool>>(false);
+        pending_[cueId] = {request.id, filepath, request.cancelled};
+        requestQueue_.push_back(std::move(request));
     }
     requestCond_.notify_one();
+    
+    // The opening is read from storage while the request waits for a worker
+    // (and stays cached until GO)
+    if (!preload) {
+        PageCachePolicy::instance().prefetch(filepath);
+    }
+
+    LOG_INFO << "AsyncVideoLoader: Queued load request for '" << filepath << "' (cue: " << cueId
+             << ", priority " << static_cast<int>(priority) << ")";
+}
 
-    LOG_INFO << "AsyncVideoLoader: Queued load request for '" << filepath << "' (cue: " << cueId << ")";
+bool AsyncVideoLoader::setPriority(const std::string& cueId, Priority priority) {
+    std::lock_guard<std::mutex> lock(requestMutex_);
+    auto it = pending_.find(cueId);
+    if (it == pending_.end()) {
+        return false;
+    }
+    if (priority == Priority::NEXT) {
+        PageCachePolicy::instance().prefetch(it->second.filepath);  // Renews its protection
+    }
+    for (auto& request : requestQueue_) {
+        if (request.id == it->second.id) {
+            request.priority = priority;
+            return true;
+        }
+    }
+    return false;
 }
 
-int AsyncVideoLoader::pollCompleted() {
+int AsyncVideoLoader::pollCompleted(int maxResults) {
     int count = 0;
 
-    while (true) {
+    while (maxResults <= 0 || count < maxResults) {
         LoadResult result;
         {
             std::lock_guard<std::mutex> lock(resultMutex_);
             if (resultQueue_.empty()) {
                 break;
             }
-            result = std::move(resultQueue_.front());
-            resultQueue_.pop();
+            // Highest priority first, in completion order within a priority
+            auto best = resultQueue_.begin();
+            for (auto it = resultQueue_.begin(); it != resultQueue_.end(); ++it) {
+                if (it->priority > best->priority) {
+                    best = it;
+                }
+            }
+            result = std::move(*best);
+            resultQueue_.erase(best);
         }
 
-        // Remove from pending set
+        // Drop results of loads cancelled or superseded after they finished
         {
-            std::lock_guard<std::mutex> lock(pendingMutex_);
-            pendingCueIds_.erase(result.cueId);
+            std::lock_guard<std::mutex> lock(requestMutex_);
+            auto it = pending_.find(result.cueId);
+            if (it == pending_.end() || it->second.id != result.id) {
+                LOG_INFO << "AsyncVideoLoader: Discarding result for cancelled cue: " << result.cueId;
+                continue;
+            }
+            pending_.erase(it);
         }
 
         // Invoke callback on main thread
@@ -118,109 +206,255 @@ int AsyncVideoLoader::pollCompleted() {
     return count;
 }
 
+void AsyncVideoLoader::requestIndexPrewarm(const std::vector<std::string>& filepaths) {
+    if (config_ && (config_->getBool("want_noindex", false) || !config_->getBool("index_cache", true))) {
+        LOG_INFO << "AsyncVideoLoader: Index cache disabled, skipping pre-warm";
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        for (const auto& filepath : filepaths) {
+            LoadRequest request;
+            request.id = nextRequestId_++;
+            request.filepath = filepath;
+            request.priority = Priority::BACKGROUND;
+            request.cancelled = std::make_shared<std::atomic<bool>>(false);
+            request.prewarmOnly = true;
+            requestQueue_.push_back(std::move(request));
+        }
+    }
+    requestCond_.notify_all();
+
+    LOG_INFO << "AsyncVideoLoader: Queued index pre-warm for " << filepaths.size() << " file(s)";
+}
+
 void AsyncVideoLoader::cancelLoad(const std::string& cueId) {
-    // Mark as cancelled in pending set (worker thread will check)
-    std::lock_guard<std::mutex> lock(pendingMutex_);
-    pendingCueIds_.erase(cueId);
+    std::lock_guard<std::mutex> lock(requestMutex_);
+    if (pending_.count(cueId) == 0) {
+        return;
+    }
+    cancelLocked(cueId);
     LOG_INFO << "AsyncVideoLoader: Cancelled load for cue: " << cueId;
 }
 
+void AsyncVideoLoader::cancelLocked(const std::string& cueId) {
+    auto it = pending_.find(cueId);
+    if (it == pending_.end()) {
+        return;
+    }
+    // A worker already opening the file sees the flag; a queued request is dropped
+    *it->second.cancelled = true;
+    uint64_t id = it->second.id;
+    requestQueue_.erase(std::remove_if(requestQueue_.begin(), requestQueue_.end(),
+                                       [id](const LoadRequest& request) { return request.id == id; }),
+                        requestQueue_.end());
+    pending_.erase(it);
+}
+
 bool AsyncVideoLoader::isLoadPending(const std::string& cueId) const {
-    std::lock_guard<std::mutex> lock(pendingMutex_);
-    return pendingCueIds_.count(cueId) > 0;
+    std::lock_guard<std::mutex> lock(requestMutex_);
+    return pending_.count(cueId) > 0;
 }
 
 size_t AsyncVideoLoader::pendingCount() const {
-    std::lock_guard<std::mutex> lock(pendingMutex_);
-    return pendingCueIds_.size();
+    std::lock_guard<std::mutex> lock(requestMutex_);
+    return pending_.size();
+}
+
+std::deque<AsyncVideoLoader::LoadRequest>::iterator AsyncVideoLoader::nextRequestLocked() {
+    auto best = requestQueue_.end();
+    for (auto it = requestQueue_.begin(); it != requestQueue_.end(); ++it) {
+        // A file being opened is left to that open: the next load of it then
+        // finds the index cache warm instead of scanning the file again
+        if (openingFiles_.count(it->filepath) > 0) {
+            continue;
+        }
+        if (best == requestQueue_.end() || it->priority > best->priority) {
+            best = it;
+        }
+    }
+    return best;
 }
 
 void AsyncVideoLoader::workerThread() {
-    LOG_INFO << "AsyncVideoLoader: Worker thread running";
+    ThreadRoles::instance().apply(ThreadRole::LOADER);
+    LOG_VERBOSE << "AsyncVideoLoader: Worker thread running";
 
-    while (running_) {
+    while (true) {
         LoadRequest request;
         
         // Wait for a request
         {
             std::unique_lock<std::mutex> lock(requestMutex_);
-            requestCond_.wait(lock, [this] {
-                return !requestQueue_.empty() || !running_;
+            auto next = requestQueue_.end();
+            requestCond_.wait(lock, [this, &next] {
+                if (!running_) {
+                    return true;
+                }
+                next = nextRequestLocked();
+                return next != requestQueue_.end();
             });
 
             if (!running_) {
                 break;
             }
 
-            if (requestQueue_.empty()) {
-                continue;
-            }
-
-            request = std::move(requestQueue_.front());
-            requestQueue_.pop();
+            request = std::move(*next);
+            requestQueue_.erase(next);
+            openingFiles_.insert(request.filepath);
+            activeLoads_.insert(request.cancelled);
         }
 
-        // Check if load was cancelled
-        {
-            std::lock_guard<std::mutex> lock(pendingMutex_);
-            if (pendingCueIds_.count(request.cueId) == 0) {
-                LOG_INFO << "AsyncVideoLoader: Skipping cancelled load for cue: " << request.cueId;
-                continue;
-            }
-        }
+        std::unique_ptr<InputSource> inputSource;
+        bool success = false;
 
-        LOG_INFO << "AsyncVideoLoader: Loading '" << request.filepath << "' (cue: " << request.cueId << ")";
-        auto startTime = std::chrono::high_resolution_clock::now();
+        if (request.prewarmOnly) {
+            // Index pre-warm requests have no cue and post no result
+            prewarmIndexAsync(request.filepath, request.cancelled.get());
+        } else {
+            LOG_INFO << "AsyncVideoLoader: Loading '" << request.filepath << "' (cue: " << request.cueId << ")";
+            auto startTime = std::chrono::high_resolution_clock::now();
 
-        // Perform the heavy loading work
-        auto inputSource = createInputSourceAsync(request.filepath);
+            // A small layer plays the file's proxy when one covers it
+            std::string path = request.filepath;
+            if (!config_ || config_->getBool("proxy_media", true)) {
+                path = ProxyMedia::select(path, request.displayWidth, request.displayHeight);
+            }
 
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+            // Perform the heavy loading work
+            inputSource = createInputSourceAsync(path, request.cancelled.get(), request.preload);
 
-        bool success = (inputSource != nullptr);
-        if (success) {
-            LOG_INFO << "AsyncVideoLoader: Loaded '" << request.filepath 
-                     << "' in " << duration.count() << "ms";
-        } else {
-            LOG_WARNING << "AsyncVideoLoader: Failed to load '" << request.filepath << "'";
-        }
+            auto endTime = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
 
-        // Check again if cancelled before posting result
-        {
-            std::lock_guard<std::mutex> lock(pendingMutex_);
-            if (pendingCueIds_.count(request.cueId) == 0) {
+            success = (inputSource != nullptr);
+            if (*request.cancelled) {
                 LOG_INFO << "AsyncVideoLoader: Discarding result for cancelled cue: " << request.cueId;
-                continue;
+            } else if (success) {
+                LOG_INFO << "AsyncVideoLoader: Loaded '" << request.filepath 
+                         << "' in " << duration.count() << "ms";
+            } else {
+                LOG_WARNING << "AsyncVideoLoader: Failed to load '" << request.filepath << "'";
             }
         }
 
-        // Post result to main thread
-        {
+        // Post result to main thread (pollCompleted drops it if cancelled since)
+        if (!request.prewarmOnly && !*request.cancelled) {
             std::lock_guard<std::mutex> lock(resultMutex_);
-            resultQueue_.push({
-                request.cueId,
-                request.filepath,
-                std::move(inputSource),
-                success,
-                request.callback
-            });
+            LoadResult result;
+            result.id = request.id;
+            result.cueId = request.cueId;
+            result.filepath = request.filepath;
+            result.inputSource = std::move(inputSource);
+            result.success = success;
+            result.priority = request.priority;
+            result.callback = std::move(request.callback);
+            resultQueue_.push_back(std::move(result));
+        }
+
+        // Release the file to loads waiting on it
+        {
+            std::lock_guard<std::mutex> lock(requestMutex_);
+            openingFiles_.erase(openingFiles_.find(request.filepath));
+            activeLoads_.erase(request.cancelled);
+        }
+        requestCond_.notify_all();
+    }
+
+    LOG_VERBOSE << "AsyncVideoLoader: Worker thread exiting";
+}
+
+void AsyncVideoLoader::prewarmIndexAsync(const std::string& filepath, const std::atomic<bool>* cancelled) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Opening builds the index (or validates the cached one) and stores it;
+    // software decode avoids creating a hardware context just for indexing
+    VideoFileInput videoInput;
+    videoInput.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+    if (config_) {
+        videoInput.setIndexCache(true, config_->getString("index_cache_dir", ""));
+    }
+    videoInput.setOpenAbort(cancelled);
+
+    if (!videoInput.open(filepath)) {
+        if (!*cancelled) {
+            LOG_WARNING << "AsyncVideoLoader: Index pre-warm failed for '" << filepath << "'";
         }
+        return;
     }
+    videoInput.close();
 
-    LOG_INFO << "AsyncVideoLoader: Worker thread exiting";
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - startTime);
+    LOG_INFO << "AsyncVideoLoader: Index ready for '" << filepath << "' (" << duration.count() << "ms)";
 }
 
-std::unique_ptr<InputSource> AsyncVideoLoader::createInputSourceAsync(const std::string& filepath) {
+std::unique_ptr<InputSource> AsyncVideoLoader::createInputSourceAsync(const std::string& filepath,
+                                                                    const std::atomic<bool>* cancelled,
+                                                                    bool preload, bool mosaicTile) {
     // Check for HAP codec (uses custom decoder)
     std::string ext = filepath.substr(filepath.find_last_of('.') + 1);
     std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
     
+    // Tiled clip: every tile opened like a clip of its own, decoded in parallel
+    if (MosaicInput::isMosaicPath(filepath) && !mosaicTile) {
+        auto mosaicInput = std::make_unique<MosaicInput>();
+        mosaicInput->setTileFactory([this, cancelled, preload](const std::string& tilePath) {
+            return *cancelled ? nullptr : createInputSourceAsync(tilePath, cancelled, preload, true);
+        });
+        if (!mosaicInput->open(filepath)) {
+            if (!*cancelled) {
+                LOG_ERROR << "AsyncVideoLoader: Failed to open mosaic " << filepath;
+            }
+            return nullptr;
+        }
+        return mosaicInput;
+    }
+
+    // Numbered image files: decoded per frame by a worker pool
+    if (ImageSequenceInput::isSequencePath(filepath)) {
+        auto sequenceInput = std::make_unique<ImageSequenceInput>();
+        if (config_) {
+            sequenceInput->setFramerate(config_->getDouble("sequence_fps", 25.0));
+            sequenceInput->setThreads(config_->getInt("sequence_threads", -1));
+            sequenceInput->setReadAhead(config_->getInt("sequence_read_ahead", 12));
+            int cacheMB = config_->getInt("sequence_cache_mb", 512);
+            sequenceInput->setCacheBudget(static_cast<size_t>(std::max(0, cacheMB)) * 1024 * 1024);
+        }
+        if (!sequenceInput->open(filepath)) {
+            LOG_ERROR << "AsyncVideoLoader: Failed to open image sequence " << filepath;
+            return nullptr;
+        }
+        return sequenceInput;
+    }
+
+    // Single image: decoded here, once, so the render thread never touches the file
+    if (StillImageInput::isStillImagePath(filepath)) {
+        auto stillInput = std::make_unique<StillImageInput>();
+        if (!stillInput->open(filepath)) {
+            LOG_ERROR << "AsyncVideoLoader: Failed to open still image " << filepath;
+            return nullptr;
+        }
+        return stillInput;
+    }
+
+    // Held across the HAP probe so the input that opens the file picks up
+    // this copy instead of reading the file again
+    std::shared_ptr<const RamClip> ramClip;
+    if (preload) {
+        ramClip = RamClipCache::instance().acquire(filepath, cancelled);
+        if (*cancelled) {
+            return nullptr;
+        }
+    }
+    
     // For HAP files or files that need HAP decoding
     // We do a quick probe to check codec before full open
     if (ext == "mov" || ext == "mp4") {
         // Quick check for HAP codec
         auto hapInput = std::make_unique<HAPVideoInput>();
+        hapInput->setPreload(ramClip != nullptr);
         if (hapInput->open(filepath)) {
             LOG_INFO << "AsyncVideoLoader: Using HAP decoder for " << filepath;
             return hapInput;
@@ -241,11 +475,30 @@ std::unique_ptr<InputSource> AsyncVideoLoader::createInputSourceAsync(const std:
         hwPref = VideoFileInput::HardwareDecodePreference::VAAPI;
     } else if (hwPrefStr == "cuda" || hwPrefStr == "nvdec") {
         hwPref = VideoFileInput::HardwareDecodePreference::CUDA;
+    } else if (hwPrefStr == "vulkan") {
+        hwPref = VideoFileInput::HardwareDecodePreference::VULKAN;
     }
     
     auto videoInput = std::make_unique<VideoFileInput>();
     videoInput->setNoIndex(noIndex);
     videoInput->setHardwareDecodePreference(hwPref);
+    videoInput->setPreload(ramClip != nullptr);
+    int poolBudgetMB = config_ ? config_->getInt("frame_pool_budget_mb", 128) : 128;
+    videoInput->setFramePoolBudget(static_cast<size_t>(std::max(0, poolBudgetMB)) * 1024 * 1024);
+    int reverseBudgetMB = config_ ? config_->getInt("reverse_cache_mb", 256) : 256;
+    videoInput->setReverseCacheBudget(static_cast<size_t>(std::max(0, reverseBudgetMB)) * 1024 * 1024);
+    if (config_) {
+        videoInput->setIndexCache(config_->getBool("index_cache", true),
+                                  config_->getString("index_cache_dir", ""));
+        videoInput->setBackgroundIndexing(config_->getBool("background_indexing", false));
+        videoInput->setPlanarOutput(config_->getBool("gpu_yuv", true) && !mosaicTile);
+        videoInput->setReadAhead(ReadAheadIO::parseMode(config_->getString("read_ahead", "auto")),
+                                 static_cast<size_t>(std::max(1, config_->getInt("read_ahead_mb", 16))) * 1024 * 1024);
+        videoInput->setDirectIoBitrate(static_cast<int64_t>(std::max(0, config_->getInt("direct_io_mbps", 0))) * 1000000);
+        videoInput->setIntraDecoders(std::max(0, config_->getInt("intra_decoders", 0)));
+        videoInput->setKeyframeOnlyStep(std::max(0, config_->getInt("keyframe_only_step", 8)));
+        videoInput->setDeinterlace(FieldSelector::parseMode(config_->getString("deinterlace", "auto")));
+    }
     
 #ifdef HAVE_VAAPI_INTEROP
     // Set DisplayBackend for per-instance VaapiInterop creation
@@ -254,8 +507,14 @@ std::unique_ptr<InputSource> AsyncVideoLoader::createInputSourceAsync(const std:
     }
 #endif
     
-    if (!videoInput->open(filepath)) {
-        LOG_ERROR << "AsyncVideoLoader: Failed to open " << filepath;
+    // A superseded load stops indexing; the flag must not outlive this load
+    videoInput->setOpenAbort(cancelled);
+    bool opened = videoInput->open(filepath);
+    videoInput->setOpenAbort(nullptr);
+    if (!opened) {
+        if (!*cancelled) {
+            LOG_ERROR << "AsyncVideoLoader: Failed to open " << filepath;
+        }
         return nullptr;
     }
     
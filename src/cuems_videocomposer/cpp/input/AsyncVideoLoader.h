@@ -4,13 +4,15 @@
 #include "InputSource.h"
 #include <memory>
 #include <string>
-#include <queue>
+#include <deque>
+#include <map>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 #include <functional>
 #include <atomic>
 #include <set>
+#include <vector>
 
 namespace videocomposer {
 
@@ -18,10 +20,19 @@ class DisplayBackend;
 class ConfigurationManager;
 
 /**
- * AsyncVideoLoader - Background thread for video file loading
+ * AsyncVideoLoader - Background threads for video file loading
  * 
  * Performs heavy file opening operations (format probing, codec init, indexing)
- * in a background thread to avoid blocking the main render loop.
+ * on a pool of worker threads to avoid blocking the main render loop.
+ * 
+ * Requests are served by priority (the go-next cue first), then in arrival
+ * order. A newer load for a cue supersedes the older one: queued requests are
+ * dropped and an open still indexing is aborted. Loads of a file that is
+ * already being opened wait for that open, then reuse its frame index cache
+ * instead of probing and indexing the same file twice in parallel.
+ * 
+ * Queued files get their opening prefetched into the page cache
+ * (PageCachePolicy), so a cue's first frames are hot by the time it goes.
  * 
  * Usage:
  * 1. Call requestLoad() with filepath and callback
@@ -35,33 +46,66 @@ public:
     using LoadCallback = std::function<void(const std::string&, const std::string&, 
                                             std::unique_ptr<InputSource>, bool)>;
 
+    // Order in which queued requests are served
+    enum class Priority {
+        BACKGROUND = 0,  // Index pre-warm
+        NORMAL = 1,      // Cue loads
+        NEXT = 2         // The cue that goes next
+    };
+
     AsyncVideoLoader();
     ~AsyncVideoLoader();
 
     /**
-     * Initialize the loader with required dependencies
-     * @param config Configuration manager for hardware decode settings
+     * Initialize the loader with required dependencies and start the workers
+     * @param config Configuration manager for hardware decode settings and
+     *        loader_threads (can be nullptr: one worker per core, up to 8)
      * @param displayBackend Display backend for VAAPI interop (can be nullptr)
      */
     void initialize(ConfigurationManager* config, DisplayBackend* displayBackend);
 
     /**
      * Request async loading of a video file
+     * Supersedes a pending load of another file for the same cue; a pending
+     * load of the same file is kept (its priority is raised if needed).
      * @param cueId Layer cue ID for this load
      * @param filepath Path to video file
      * @param callback Callback to invoke when loading completes
+     * @param priority Queue priority
+     * @param preload Read the whole file into RAM (RamClipCache)
+     * @param displayWidth, displayHeight Size the layer is shown at (0 = unknown):
+     *        a smaller proxy of the file may be played (ProxyMedia)
      */
-    void requestLoad(const std::string& cueId, const std::string& filepath, LoadCallback callback);
+    void requestLoad(const std::string& cueId, const std::string& filepath, LoadCallback callback,
+                     Priority priority = Priority::NORMAL, bool preload = false,
+                     int displayWidth = 0, int displayHeight = 0);
+
+    /**
+     * Change the priority of a queued load (no effect once it is loading)
+     * @return true if a queued load was found for the cue
+     */
+    bool setPriority(const std::string& cueId, Priority priority);
+
+    /**
+     * Queue background index builds so later loads hit the frame index cache
+     * (e.g. for every file of a show when the show is loaded)
+     * @param filepaths Video files to index
+     */
+    void requestIndexPrewarm(const std::vector<std::string>& filepaths);
 
     /**
      * Poll for completed loads and invoke callbacks
      * Call this from the main thread each frame
+     * @param maxResults Callbacks to invoke at most (0 = all), so several
+     *        loads finishing together are spread over frames (highest
+     *        priority first)
      * @return Number of callbacks invoked
      */
-    int pollCompleted();
+    int pollCompleted(int maxResults = 0);
 
     /**
-     * Cancel all pending loads for a cue ID
+     * Cancel the pending load for a cue ID
+     * Its callback is not invoked, even if the load has already finished.
      * @param cueId Cue ID to cancel
      */
     void cancelLoad(const std::string& cueId);
@@ -78,54 +122,89 @@ public:
      */
     size_t pendingCount() const;
 
+    /**
+     * Number of worker threads (0 before initialize())
+     */
+    size_t workerCount() const { return workers_.size(); }
+
     /**
      * Shutdown the loader
      */
     void shutdown();
 
 private:
+    using CancelFlag = std::shared_ptr<std::atomic<bool>>;
+
     // Request structure
     struct LoadRequest {
+        uint64_t id = 0;
         std::string cueId;
         std::string filepath;
         LoadCallback callback;
+        Priority priority = Priority::NORMAL;
+        CancelFlag cancelled;
+        bool prewarmOnly = false;  // Build/validate index cache only
+        bool preload = false;      // Demux from a RAM copy of the file
+        int displayWidth = 0;      // Layer size on the canvas (0 = unknown)
+        int displayHeight = 0;
     };
 
     // Result structure
     struct LoadResult {
+        uint64_t id = 0;
         std::string cueId;
         std::string filepath;
         std::unique_ptr<InputSource> inputSource;
-        bool success;
+        bool success = false;
+        Priority priority = Priority::NORMAL;
         LoadCallback callback;
     };
 
+    // Latest load requested for a cue (queued, loading or finished but not polled)
+    struct PendingLoad {
+        uint64_t id;
+        std::string filepath;
+        CancelFlag cancelled;
+    };
+
     // Worker thread function
     void workerThread();
 
+    // Best request whose file is not being opened by another worker (requestMutex_ held)
+    std::deque<LoadRequest>::iterator nextRequestLocked();
+
+    // Drop the pending load of a cue and its queued request (requestMutex_ held)
+    void cancelLocked(const std::string& cueId);
+
     // Create input source (runs in worker thread)
-    std::unique_ptr<InputSource> createInputSourceAsync(const std::string& filepath);
+    // mosaicTile: a tile of a MosaicInput, which stitches packed RGBA/BGRA frames
+    std::unique_ptr<InputSource> createInputSourceAsync(const std::string& filepath,
+                                                        const std::atomic<bool>* cancelled,
+                                                        bool preload, bool mosaicTile = false);
+
+    // Build index cache for a file (runs in worker thread)
+    void prewarmIndexAsync(const std::string& filepath, const std::atomic<bool>* cancelled);
 
     // Dependencies
     ConfigurationManager* config_;
     DisplayBackend* displayBackend_;
 
     // Threading
-    std::unique_ptr<std::thread> workerThread_;
+    std::vector<std::thread> workers_;
     std::atomic<bool> running_;
 
-    // Request queue (protected by mutex)
+    // Requests, pending loads and files being opened (protected by requestMutex_)
     mutable std::mutex requestMutex_;
     std::condition_variable requestCond_;
-    std::queue<LoadRequest> requestQueue_;
+    std::deque<LoadRequest> requestQueue_;
+    std::map<std::string, PendingLoad> pending_;   // By cue ID
+    std::multiset<std::string> openingFiles_;
+    std::set<CancelFlag> activeLoads_;             // Aborted on shutdown
+    uint64_t nextRequestId_;
 
     // Result queue (protected by mutex, consumed by main thread)
     mutable std::mutex resultMutex_;
-    std::queue<LoadResult> resultQueue_;
-
-    // Track pending loads by cue ID
-    mutable std::mutex pendingMutex_;
-    std::set<std::string> pendingCueIds_;
+    std::deque<LoadResult> resultQueue_;
 };
 
 } // namespace videocomposer
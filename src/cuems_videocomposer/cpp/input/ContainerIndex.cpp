@@ -0,0 +1,85 @@
+#include "ContainerIndex.h"
+
+namespace videocomposer {
+
+bool ContainerIndex::fromSamples(const std::vector<Sample>& samples, const FrameTime& frameTime,
+                                 std::vector<FrameIndexCache::Entry>& entries) {
+    entries.clear();
+    entries.reserve(samples.size());
+
+    // Same seek table as the packet scan's Pass 3 with unverified keyframes:
+    // every frame seeks to the latest keyframe at or before it
+    const Sample* seekKey = nullptr;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const Sample& sample = samples[i];
+        if (sample.key) {
+            seekKey = &sample;
+        }
+        FrameIndexCache::Entry entry;
+        entry.pkt_pts = sample.timestamp;
+        entry.pkt_pos = sample.pos;
+        entry.frame_pts = -1;
+        entry.frame_pos = sample.key ? sample.pos : -1;
+        entry.timestamp = frameTime(static_cast<int64_t>(i));
+        entry.seekpts = seekKey ? seekKey->timestamp : 0;
+        entry.seekpos = seekKey ? seekKey->pos : 0;
+        entry.key = sample.key ? 1 : 0;
+        entries.push_back(entry);
+    }
+
+    if (!seekKey) {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ContainerIndex::fromKeyframes(const std::vector<Sample>& keyframes, int64_t startTime, int64_t frameCount,
+                                   const FrameTime& frameTime, std::vector<FrameIndexCache::Entry>& entries) {
+    entries.clear();
+    if (keyframes.empty() || frameCount <= 0) {
+        return false;
+    }
+    entries.reserve(static_cast<size_t>(frameCount));
+
+    // A keyframe belongs to the frame slot it falls in (within half a frame:
+    // Matroska stores millisecond timestamps)
+    size_t next = 0;
+    const Sample* seekKey = nullptr;
+    int64_t lastKeyFrame = 0;
+    for (int64_t i = 0; i < frameCount; ++i) {
+        const int64_t slot = startTime + frameTime(i);
+        const int64_t halfFrame = (frameTime(i + 1) - frameTime(i)) / 2;
+        bool key = false;
+        while (next < keyframes.size() && keyframes[next].timestamp <= slot + halfFrame) {
+            seekKey = &keyframes[next++];
+            key = true;
+        }
+        if (key) {
+            if (i - lastKeyFrame > MAX_KEYFRAME_GAP) {
+                entries.clear();
+                return false;
+            }
+            lastKeyFrame = i;
+        }
+
+        FrameIndexCache::Entry entry;
+        entry.pkt_pts = key ? seekKey->timestamp : slot;
+        entry.pkt_pos = seekKey ? seekKey->pos : -1;
+        entry.frame_pts = -1;
+        entry.frame_pos = key ? seekKey->pos : -1;
+        entry.timestamp = frameTime(i);
+        entry.seekpts = seekKey ? seekKey->timestamp : 0;
+        entry.seekpos = seekKey ? seekKey->pos : 0;
+        entry.key = key ? 1 : 0;
+        entries.push_back(entry);
+    }
+
+    if (!seekKey || frameCount - lastKeyFrame > MAX_KEYFRAME_GAP) {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,61 @@
+#ifndef VIDEOCOMPOSER_CONTAINERINDEX_H
+#define VIDEOCOMPOSER_CONTAINERINDEX_H
+
+#include "FrameIndexCache.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ContainerIndex - Frame index from the tables a container already carries
+ *
+ * MP4/MOV (stts/stss/stco) and AVI (idx1) list every sample with its
+ * timestamp, byte position and keyframe flag; Matroska Cues list the
+ * keyframes. libavformat exposes both as the stream's index entries, so
+ * the frame index VideoFileInput otherwise builds by reading every packet
+ * and decoding a frame per keyframe takes milliseconds instead.
+ *
+ * Entries use the FrameIndexCache::Entry layout (= VideoFileInput's
+ * FrameIndex). Keyframes are not decoded to verify their presentation
+ * time, so seek lookups use the frame's slot time (as for hardware
+ * decoders, whose keyframes are not verified either).
+ */
+class ContainerIndex {
+public:
+    /**
+     * Index entry from the container (stream time base)
+     */
+    struct Sample {
+        int64_t timestamp;  // Decode timestamp
+        int64_t pos;        // Byte position (-1 = unknown)
+        bool key;
+    };
+
+    /** Frame number -> time of that frame after the first (stream time base) */
+    using FrameTime = std::function<int64_t(int64_t frame)>;
+
+    /** Keyframes further apart than this: the table is too sparse to use */
+    static constexpr int64_t MAX_KEYFRAME_GAP = 300;
+
+    /**
+     * Index from a sample table (one sample per frame, decode order)
+     * @return false without a keyframe
+     */
+    static bool fromSamples(const std::vector<Sample>& samples, const FrameTime& frameTime,
+                            std::vector<FrameIndexCache::Entry>& entries);
+
+    /**
+     * Index from keyframes only, for a constant frame rate stream
+     * @param startTime Time of frame 0
+     * @param frameCount Frames in the stream
+     * @return false if the keyframes leave a gap over MAX_KEYFRAME_GAP frames
+     */
+    static bool fromKeyframes(const std::vector<Sample>& keyframes, int64_t startTime, int64_t frameCount,
+                              const FrameTime& frameTime, std::vector<FrameIndexCache::Entry>& entries);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CONTAINERINDEX_H
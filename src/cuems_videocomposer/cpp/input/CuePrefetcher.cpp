@@ -0,0 +1,468 @@
+#include "CuePrefetcher.h"
+#include "VideoFileInput.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace videocomposer {
+
+CuePrefetcher::CuePrefetcher()
+    : noIndex_(false)
+    , useIndexCache_(true)
+    , feedSlot_(nullptr)
+    , feedNext_(-1)
+    , feedGeneration_(0)
+    , hits_(0)
+    , fedFrames_(0)
+    , layerId_(MemoryBudget::NO_LAYER)
+    , slotBytes_(0)
+    , evictorIds_{0, 0}
+{
+}
+
+CuePrefetcher::~CuePrefetcher() {
+    close();
+}
+
+bool CuePrefetcher::open(const VideoFileInput& source) {
+    close();
+
+    if (!source.isReady() || source.getFilename().empty()) {
+        return false;
+    }
+
+    filename_ = source.getFilename();
+    noIndex_ = source.getNoIndex();
+    useIndexCache_ = source.getIndexCacheEnabled();
+    indexCacheDir_ = source.getIndexCacheDir();
+
+    // +1 so the frame last handed out can stay alive while the feed refills
+    feedPool_ = FramePool::create(FEED_AHEAD + 1);
+
+    FrameInfo info = source.getFrameInfo();
+    layerId_ = MemoryBudget::currentLayer();
+    slotBytes_ = static_cast<size_t>(std::max(info.width, 0)) * std::max(info.height, 0) * 4 * SLOT_FRAMES;
+    budgetRetryAt_ = std::chrono::steady_clock::time_point();
+    MemoryBudget& budget = MemoryBudget::instance();
+    evictorIds_[0] = budget.addEvictor(MemoryBudget::Tier::PREFETCH, MemoryBudget::Pool::RAM, [this](size_t bytes) {
+        return evict(MemoryBudget::Subsystem::CUE_PREFETCH, bytes);
+    });
+    evictorIds_[1] = budget.addEvictor(MemoryBudget::Tier::LOOP_CACHE, MemoryBudget::Pool::RAM, [this](size_t bytes) {
+        return evict(MemoryBudget::Subsystem::LOOP_PREFETCH, bytes);
+    });
+
+    stop_ = false;
+    workerThread_ = std::make_unique<std::thread>(&CuePrefetcher::workerThreadFunc, this);
+    return true;
+}
+
+void CuePrefetcher::close() {
+    // First: evictors lock mutex_ and touch the slots
+    for (int& id : evictorIds_) {
+        if (id != 0) {
+            MemoryBudget::instance().removeEvictor(id);
+            id = 0;
+        }
+    }
+
+    if (workerThread_) {
+        stop_ = true;
+        workCond_.notify_all();
+        feedCond_.notify_all();
+        if (workerThread_->joinable()) {
+            workerThread_->join();
+        }
+        workerThread_.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    endFeedLocked();
+    lastTaken_.reset();
+    for (Slot& slot : slots_) {
+        dropSlotLocked(slot);
+    }
+    cues_.clear();
+    cheapCues_.clear();
+    loopCues_.clear();
+}
+
+void CuePrefetcher::dropSlotLocked(Slot& slot) {
+    if (slot.input) {
+        slot.input->close();
+        slot.input.reset();
+    }
+    slot.target = -1;
+    slot.primed = false;
+    slot.frame.release();
+    if (slot.charged > 0) {
+        MemoryBudget::instance().release(MemoryBudget::Account(slot.chargedTo, layerId_), slot.charged);
+        slot.charged = 0;
+    }
+}
+
+size_t CuePrefetcher::evict(MemoryBudget::Subsystem subsystem, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t freed = 0;
+    for (Slot& slot : slots_) {
+        // Unprimed slots (and the feed) are in use by the worker
+        if (freed >= bytes || &slot == feedSlot_ || !slot.primed || slot.chargedTo != subsystem) {
+            continue;
+        }
+        LOG_VERBOSE << "Cue prefetch: dropped primed frame " << slot.target << " (memory budget)";
+        freed += slot.charged;
+        dropSlotLocked(slot);
+    }
+    if (freed > 0) {
+        budgetRetryAt_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(BUDGET_RETRY_MS);
+    }
+    return freed;
+}
+
+void CuePrefetcher::setCues(const std::vector<int64_t>& frames, const std::vector<int64_t>& loopFrames) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cues_.clear();
+    for (int64_t frame : frames) {
+        if (frame >= 0) {
+            cues_.push_back(frame);
+        }
+    }
+    loopCues_.clear();
+    loopCues_.insert(loopFrames.begin(), loopFrames.end());
+    std::sort(cues_.begin(), cues_.end());
+    cues_.erase(std::unique(cues_.begin(), cues_.end()), cues_.end());
+    workCond_.notify_all();
+}
+
+void CuePrefetcher::setPlayhead(int64_t frameNumber) {
+    int64_t previous = playhead_.exchange(frameNumber);
+    if (previous != frameNumber) {
+        workCond_.notify_one();
+    }
+}
+
+bool CuePrefetcher::isCueLocked(int64_t frameNumber) const {
+    return std::binary_search(cues_.begin(), cues_.end(), frameNumber);
+}
+
+bool CuePrefetcher::hasFrame(int64_t frameNumber) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (feedSlot_) {
+        if (lastTaken_ && lastTaken_->frameNumber == frameNumber) {
+            return true;
+        }
+        for (const auto& handle : feedQueue_) {
+            if (handle->frameNumber == frameNumber) {
+                return true;
+            }
+        }
+    }
+    if (!isCueLocked(frameNumber)) {
+        return false;
+    }
+    for (const Slot& slot : slots_) {
+        if (slot.primed && slot.target == frameNumber) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CuePrefetcher::take(int64_t frameNumber, FrameBuffer& buffer) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (feedSlot_) {
+        if (lastTaken_ && lastTaken_->frameNumber == frameNumber) {
+            copyFrame(lastTaken_->buffer, buffer);
+            return true;
+        }
+
+        // Frames within the feed window are worth a short wait (same budget
+        // as AsyncDecodeQueue::getFrame); anything else is a new locate
+        if (frameNumber > (lastTaken_ ? lastTaken_->frameNumber : feedNext_ - 1) &&
+            frameNumber <= feedNext_ + static_cast<int64_t>(FEED_AHEAD)) {
+            auto ready = [this, frameNumber] {
+                return !feedSlot_ || stop_ ||
+                       (!feedQueue_.empty() && feedQueue_.back()->frameNumber >= frameNumber);
+            };
+            feedCond_.wait_for(lock, std::chrono::milliseconds(5), ready);
+
+            while (!feedQueue_.empty() && feedQueue_.front()->frameNumber < frameNumber) {
+                feedQueue_.pop_front();
+            }
+            if (!feedQueue_.empty() && feedQueue_.front()->frameNumber == frameNumber) {
+                lastTaken_ = std::move(feedQueue_.front());
+                feedQueue_.pop_front();
+                copyFrame(lastTaken_->buffer, buffer);
+                fedFrames_++;
+                workCond_.notify_one();
+                return true;
+            }
+        }
+        endFeedLocked();
+    }
+
+    if (!isCueLocked(frameNumber)) {
+        return false;
+    }
+
+    for (Slot& slot : slots_) {
+        if (!slot.primed || slot.target != frameNumber) {
+            continue;
+        }
+
+        copyFrame(slot.frame, buffer);
+        hits_++;
+
+        // The slot's decoder sits right after the cue: keep it decoding
+        slot.primed = false;
+        feedSlot_ = &slot;
+        feedNext_ = frameNumber + 1;
+        feedGeneration_++;
+        workCond_.notify_one();
+
+        LOG_VERBOSE << "Cue prefetch: locate to " << frameNumber << " served from side cache";
+        return true;
+    }
+
+    return false;
+}
+
+bool CuePrefetcher::isFeeding() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return feedSlot_ != nullptr;
+}
+
+void CuePrefetcher::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endFeedLocked();
+}
+
+void CuePrefetcher::endFeedLocked() {
+    if (!feedSlot_) {
+        return;
+    }
+    // Slot stays unprimed, so the worker parks it on a cue again
+    feedSlot_ = nullptr;
+    feedNext_ = -1;
+    feedGeneration_++;
+    feedQueue_.clear();
+    lastTaken_.reset();
+    workCond_.notify_one();
+    feedCond_.notify_all();
+}
+
+CuePrefetcher::Stats CuePrefetcher::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.cues = cues_.size();
+    for (const Slot& slot : slots_) {
+        if (slot.primed && isCueLocked(slot.target)) {
+            stats.primed++;
+        }
+    }
+    stats.hits = hits_;
+    stats.fedFrames = fedFrames_;
+    return stats;
+}
+
+std::vector<int64_t> CuePrefetcher::desiredTargetsLocked() const {
+    // Nearest cues ahead of the playhead first, then the most recent ones behind it
+    int64_t playhead = playhead_.load();
+    std::vector<int64_t> desired;
+    auto ahead = std::lower_bound(cues_.begin(), cues_.end(), playhead);
+    for (auto it = ahead; it != cues_.end() && desired.size() < MAX_PRIMED_CUES; ++it) {
+        if (!cheapCues_.count(*it)) {
+            desired.push_back(*it);
+        }
+    }
+    for (auto it = ahead; it != cues_.begin() && desired.size() < MAX_PRIMED_CUES;) {
+        --it;
+        if (!cheapCues_.count(*it)) {
+            desired.push_back(*it);
+        }
+    }
+    return desired;
+}
+
+void CuePrefetcher::copyFrame(const FrameBuffer& src, FrameBuffer& dst) {
+    if (!src.isValid()) {
+        return;
+    }
+    dst = src;  // Shared until one of them is written
+}
+
+bool CuePrefetcher::feedStep() {
+    Slot* slot = nullptr;
+    int64_t frameNumber = -1;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!feedSlot_ || feedQueue_.size() >= FEED_AHEAD) {
+            return false;
+        }
+        slot = feedSlot_;
+        frameNumber = feedNext_;
+        generation = feedGeneration_;
+    }
+
+    FramePool::Handle handle = feedPool_->acquire();
+    if (!handle) {
+        return false;  // Consumer still holds the slots
+    }
+
+    // Sequential read: the decoder is already positioned after the last frame
+    bool ok = slot->input && slot->input->readFrame(frameNumber, handle->buffer);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != feedGeneration_) {
+        return true;  // Feed ended while decoding; drop the frame
+    }
+    if (ok) {
+        handle->frameNumber = frameNumber;
+        feedQueue_.push_back(std::move(handle));
+        feedNext_ = frameNumber + 1;
+    } else {
+        endFeedLocked();
+    }
+    feedCond_.notify_all();
+    return true;
+}
+
+bool CuePrefetcher::primeStep() {
+    Slot* slot = nullptr;
+    int64_t target = -1;
+    MemoryBudget::Subsystem subsystem = MemoryBudget::Subsystem::CUE_PREFETCH;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (std::chrono::steady_clock::now() < budgetRetryAt_) {
+            return false;
+        }
+        std::vector<int64_t> desired = desiredTargetsLocked();
+
+        auto covered = [this](int64_t frame) {
+            for (const Slot& s : slots_) {
+                if (s.target == frame && (s.primed || &s == feedSlot_)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        for (int64_t frame : desired) {
+            if (covered(frame)) {
+                continue;
+            }
+            // Prefer a slot parked on a cue that is no longer wanted
+            for (Slot& s : slots_) {
+                if (&s == feedSlot_) {
+                    continue;
+                }
+                if (!s.primed || std::find(desired.begin(), desired.end(), s.target) == desired.end()) {
+                    slot = &s;
+                    break;
+                }
+            }
+            if (slot) {
+                target = frame;
+                slot->target = target;
+                slot->primed = false;
+                if (loopCues_.count(target)) {
+                    subsystem = MemoryBudget::Subsystem::LOOP_PREFETCH;
+                }
+            }
+            break;
+        }
+    }
+
+    if (!slot) {
+        return false;
+    }
+
+    // The decoder is charged as the kind of cue it is parked on
+    if (slot->charged == 0 || slot->chargedTo != subsystem) {
+        if (!MemoryBudget::instance().reserve(MemoryBudget::Account(subsystem, layerId_), slotBytes_)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            LOG_VERBOSE << "Cue prefetch: frame " << target << " not primed (memory budget)";
+            dropSlotLocked(*slot);
+            budgetRetryAt_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(BUDGET_RETRY_MS);
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slot->charged > 0) {
+            MemoryBudget::instance().release(MemoryBudget::Account(slot->chargedTo, layerId_), slot->charged);
+        }
+        slot->charged = slotBytes_;
+        slot->chargedTo = subsystem;
+    }
+
+    if (!slot->input) {
+        auto input = std::make_unique<VideoFileInput>();
+        input->setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+        input->setNoIndex(noIndex_);
+        input->setIndexCache(useIndexCache_, indexCacheDir_);
+        input->setFramePoolBudget(0);
+        if (!input->open(filename_)) {
+            LOG_WARNING << "Cue prefetch: cannot open " << filename_;
+            std::lock_guard<std::mutex> lock(mutex_);
+            cheapCues_.insert(target);  // Do not retry this cue
+            dropSlotLocked(*slot);
+            return true;
+        }
+        slot->input = std::move(input);
+    }
+
+    // GOP-aware: a cue on (or just after) a keyframe seeks fast enough already
+    int64_t distance = slot->input->getKeyframeDistance(target);
+    if (distance >= 0 && distance < MIN_SEEK_DISTANCE) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cheapCues_.insert(target);
+        slot->target = -1;
+        return true;
+    }
+
+    FrameBuffer decoded;
+    slot->input->resetSeekState();
+    bool ok = slot->input->seek(target) && slot->input->readFrame(target, decoded);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) {
+        LOG_WARNING << "Cue prefetch: failed to decode cue frame " << target;
+        cheapCues_.insert(target);
+        slot->target = -1;
+        return true;
+    }
+    slot->frame.swap(decoded);
+    slot->primed = true;
+    LOG_VERBOSE << "Cue prefetch: primed frame " << target << " (" << distance << " frames from keyframe)";
+    return true;
+}
+
+void CuePrefetcher::workerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::LOADER);
+    // Priming must never compete with the render loop
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+
+    while (!stop_) {
+        // A running feed is latency-critical, priming is not
+        if (feedStep()) {
+            continue;
+        }
+        if (primeStep()) {
+            continue;
+        }
+
+        // No predicate: any notify (new cues, playhead, consumed frame) is a
+        // reason to re-check; a missed one only costs the timeout
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!stop_) {
+            workCond_.wait_for(lock, std::chrono::milliseconds(20));
+        }
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,173 @@
+#ifndef VIDEOCOMPOSER_CUEPREFETCHER_H
+#define VIDEOCOMPOSER_CUEPREFETCHER_H
+
+#include "../video/FrameBuffer.h"
+#include "../video/FramePool.h"
+#include "../video/MemoryBudget.h"
+#include <chrono>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+
+namespace videocomposer {
+
+class VideoFileInput;
+
+/**
+ * CuePrefetcher - Pre-decodes frames at known jump targets of a layer
+ *
+ * A locate on a long-GOP file has to decode from the previous keyframe,
+ * which stalls the render loop for as long as the GOP is. When the show's
+ * cue list is known, that work can be done ahead of time:
+ *
+ * - Each primed cue owns a private software VideoFileInput that has already
+ *   seeked to and decoded the cue frame, so the locate is a buffer copy.
+ * - On a hit, that decoder is already positioned right after the cue and
+ *   keeps decoding sequentially into a small side queue ("feed"), so the
+ *   frames following the locate do not stall either. The feed lasts until
+ *   playback leaves it (non-sequential jump) or the layer's own decoder
+ *   has caught up (see release()).
+ * - Cues whose seek is already cheap (keyframe within MIN_SEEK_DISTANCE
+ *   frames, per the frame index) are left to the layer's decoder.
+ *
+ * All decoding happens on one low-priority worker thread; take() only
+ * copies finished frames.
+ *
+ * Private decoders are charged to MemoryBudget, as CUE_PREFETCH or (loop
+ * targets) LOOP_PREFETCH, to the layer that opened the prefetcher. When the
+ * budget refuses one, priming pauses for a while; when it evicts, parked
+ * decoders are closed and their cues are decoded by the layer as usual.
+ */
+class CuePrefetcher {
+public:
+    static constexpr size_t MAX_PRIMED_CUES = 4;     // Private decoders per layer
+    static constexpr int64_t MIN_SEEK_DISTANCE = 4;  // Frames from keyframe worth priming
+    static constexpr size_t FEED_AHEAD = 4;          // Frames decoded ahead after a hit
+    static constexpr size_t SLOT_FRAMES = 4;         // Frames a private decoder holds (budget estimate)
+    static constexpr int BUDGET_RETRY_MS = 1000;     // Pause of priming after a refusal or eviction
+
+    struct Stats {
+        size_t cues = 0;        // Registered cues
+        size_t primed = 0;      // Cues ready for an instant locate
+        uint64_t hits = 0;      // Locates served from a primed cue
+        uint64_t fedFrames = 0; // Frames served from the feed after a hit
+    };
+
+    CuePrefetcher();
+    ~CuePrefetcher();
+
+    /**
+     * Start prefetching for the file open in a layer's input
+     * (copies filename and index settings; the source is not retained)
+     * @return true if the worker thread was started
+     */
+    bool open(const VideoFileInput& source);
+
+    /**
+     * Stop the worker and release all private decoders
+     */
+    void close();
+
+    /**
+     * Replace the cue list
+     * @param frames Jump targets in input frame numbers
+     * @param loopFrames Those of them that are loop targets (budgeted apart)
+     */
+    void setCues(const std::vector<int64_t>& frames, const std::vector<int64_t>& loopFrames = {});
+
+    /**
+     * Report the layer's current frame (cues ahead of it are primed first)
+     */
+    void setPlayhead(int64_t frameNumber);
+
+    /**
+     * Check if a frame can be served without decoding
+     */
+    bool hasFrame(int64_t frameNumber) const;
+
+    /**
+     * Copy a prefetched frame into the caller's buffer
+     * A primed cue starts a feed; fed frames are consumed in order.
+     * Requesting any other frame ends the feed.
+     * @return true if the frame was served, false if the caller must decode it
+     */
+    bool take(int64_t frameNumber, FrameBuffer& buffer);
+
+    /**
+     * Check if frames after a hit are currently being fed
+     */
+    bool isFeeding() const;
+
+    /**
+     * End the current feed (the layer's decoder has caught up)
+     */
+    void release();
+
+    Stats getStats() const;
+
+private:
+    struct Slot {
+        int64_t target = -1;                   // Cue this decoder is parked on
+        bool primed = false;                   // frame holds the decoded target
+        std::unique_ptr<VideoFileInput> input; // Private decoder (worker thread only)
+        FrameBuffer frame;
+        size_t charged = 0;                    // Budget charge of the decoder
+        MemoryBudget::Subsystem chargedTo = MemoryBudget::Subsystem::CUE_PREFETCH;
+    };
+
+    void workerThreadFunc();
+    bool feedStep();
+    bool primeStep();
+    std::vector<int64_t> desiredTargetsLocked() const;
+    bool isCueLocked(int64_t frameNumber) const;
+    void endFeedLocked();
+    void dropSlotLocked(Slot& slot);
+    size_t evict(MemoryBudget::Subsystem subsystem, size_t bytes);
+    static void copyFrame(const FrameBuffer& src, FrameBuffer& dst);
+
+    // Settings copied from the layer's input
+    std::string filename_;
+    bool noIndex_;
+    bool useIndexCache_;
+    std::string indexCacheDir_;
+
+    Slot slots_[MAX_PRIMED_CUES];
+    std::vector<int64_t> cues_;      // Sorted, unique
+    std::set<int64_t> cheapCues_;    // Cues close enough to a keyframe to skip
+    std::set<int64_t> loopCues_;     // Cues that are loop targets
+    std::atomic<int64_t> playhead_{0};
+
+    // Feed state (after a hit)
+    Slot* feedSlot_;
+    int64_t feedNext_;               // Next frame the feed decoder will produce
+    uint64_t feedGeneration_;        // Bumped whenever a feed starts or ends
+    std::shared_ptr<FramePool> feedPool_;
+    std::deque<FramePool::Handle> feedQueue_;
+    FramePool::Handle lastTaken_;    // Lets a repeated request be served again
+
+    uint64_t hits_;
+    uint64_t fedFrames_;
+
+    // Memory budget
+    int layerId_;
+    size_t slotBytes_;
+    int evictorIds_[2];              // Cue and loop prefetch tiers
+    std::chrono::steady_clock::time_point budgetRetryAt_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCond_;   // Wakes the worker
+    std::condition_variable feedCond_;   // Signals new fed frames to take()
+    std::unique_ptr<std::thread> workerThread_;
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CUEPREFETCHER_H
@@ -0,0 +1,426 @@
+#include "DeckLinkVideoInput.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace videocomposer {
+
+#ifdef HAVE_DECKLINK_SDK
+namespace {
+
+bool sameIID(REFIID a, const REFIID& b) {
+    return std::memcmp(&a, &b, sizeof(REFIID)) == 0;
+}
+
+std::string takeString(const char* text) {
+    if (!text) {
+        return "";
+    }
+    std::string result = text;
+    free(const_cast<char*>(text));
+    return result;
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+/** The card allocates its capture frames from the pool */
+class PoolAllocator : public IDeckLinkMemoryAllocator {
+public:
+    explicit PoolAllocator(std::shared_ptr<PinnedBufferPool> pool) : pool_(std::move(pool)), refCount_(1) {}
+    virtual ~PoolAllocator() = default;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override {
+        CFUUIDBytes iunknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+        if (sameIID(iid, iunknown) || sameIID(iid, IID_IDeckLinkMemoryAllocator)) {
+            *ppv = static_cast<IDeckLinkMemoryAllocator*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount_; }
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG count = --refCount_;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE AllocateBuffer(unsigned int bufferSize, void** allocatedBuffer) override {
+        *allocatedBuffer = pool_->acquire(bufferSize);
+        return *allocatedBuffer ? S_OK : E_OUTOFMEMORY;
+    }
+    HRESULT STDMETHODCALLTYPE ReleaseBuffer(void* buffer) override {
+        pool_->release(buffer);
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE Commit() override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE Decommit() override {
+        pool_->trim();
+        return S_OK;
+    }
+
+private:
+    std::shared_ptr<PinnedBufferPool> pool_;
+    std::atomic<ULONG> refCount_;
+};
+
+class InputCallback : public IDeckLinkInputCallback {
+public:
+    InputCallback(DeckLinkVideoInput* owner, IDeckLinkInput* input, BMDVideoInputFlags flags)
+        : owner_(owner), input_(input), flags_(flags), refCount_(1) {}
+    virtual ~InputCallback() = default;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override {
+        CFUUIDBytes iunknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+        if (sameIID(iid, iunknown) || sameIID(iid, IID_IDeckLinkInputCallback)) {
+            *ppv = static_cast<IDeckLinkInputCallback*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount_; }
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG count = --refCount_;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE VideoInputFormatChanged(BMDVideoInputFormatChangedEvents,
+                                                      IDeckLinkDisplayMode* mode,
+                                                      BMDDetectedVideoInputFormatFlags) override {
+        // Follow the signal: restart the streams in its mode
+        input_->PauseStreams();
+        input_->EnableVideoInput(mode->GetDisplayMode(), bmdFormat8BitYUV, flags_);
+        input_->FlushStreams();
+        input_->StartStreams();
+        BMDTimeValue duration = 0;
+        BMDTimeScale scale = 0;
+        mode->GetFrameRate(&duration, &scale);
+        const char* name = nullptr;
+        mode->GetName(&name);
+        LOG_INFO << "DeckLink: Input changed to " << takeString(name);
+        owner_->onFormatChanged(static_cast<int>(mode->GetWidth()), static_cast<int>(mode->GetHeight()),
+                                duration > 0 ? static_cast<double>(scale) / duration : 0.0, scale, duration,
+                                mode->GetFieldDominance() != bmdProgressiveFrame);
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE VideoInputFrameArrived(IDeckLinkVideoInputFrame* frame,
+                                                     IDeckLinkAudioInputPacket*) override {
+        if (!frame || (frame->GetFlags() & bmdFrameHasNoInputSource)) {
+            return S_OK;
+        }
+        void* bytes = nullptr;
+        if (frame->GetBytes(&bytes) != S_OK || !bytes) {
+            return S_OK;
+        }
+
+        // Received when its last line was: the frame's reference clock
+        // timestamp, moved onto the steady clock through the card's clock now
+        auto receiveTime = std::chrono::steady_clock::now();
+        BMDTimeValue frameTime = 0;
+        BMDTimeValue frameDuration = 0;
+        BMDTimeValue hardwareNow = 0;
+        BMDTimeValue timeInFrame = 0;
+        BMDTimeValue ticksPerFrame = 0;
+        if (frame->GetHardwareReferenceTimestamp(1000000, &frameTime, &frameDuration) == S_OK &&
+            input_->GetHardwareReferenceClock(1000000, &hardwareNow, &timeInFrame, &ticksPerFrame) == S_OK) {
+            BMDTimeValue age = hardwareNow - (frameTime + frameDuration);
+            if (age > 0 && age < 1000000) {
+                receiveTime -= std::chrono::microseconds(age);
+            }
+        }
+
+        frame->AddRef();
+        std::shared_ptr<void> owner(frame, [](void* held) {
+            static_cast<IDeckLinkVideoInputFrame*>(held)->Release();
+        });
+        owner_->onFrameArrived(owner, static_cast<const uint8_t*>(bytes), static_cast<int>(frame->GetWidth()),
+                               static_cast<int>(frame->GetHeight()), frame->GetRowBytes(), receiveTime);
+        return S_OK;
+    }
+
+private:
+    DeckLinkVideoInput* owner_;
+    IDeckLinkInput* input_;
+    BMDVideoInputFlags flags_;
+    std::atomic<ULONG> refCount_;
+};
+
+IDeckLinkDisplayMode* findInputMode(IDeckLinkInput* input, const std::string& name) {
+    IDeckLinkDisplayModeIterator* iterator = nullptr;
+    if (input->GetDisplayModeIterator(&iterator) != S_OK) {
+        return nullptr;
+    }
+    std::string wanted = lowercase(name);
+    IDeckLinkDisplayMode* found = nullptr;
+    IDeckLinkDisplayMode* mode = nullptr;
+    while (iterator->Next(&mode) == S_OK) {
+        const char* modeName = nullptr;
+        mode->GetName(&modeName);
+        // Without a name the first mode: format detection follows the signal
+        if (!found && (wanted.empty() || lowercase(takeString(modeName)) == wanted)) {
+            found = mode;
+            continue;
+        }
+        mode->Release();
+    }
+    iterator->Release();
+    return found;
+}
+
+} // namespace
+#endif
+
+DeckLinkVideoInput::DeckLinkVideoInput()
+    : buffers_(std::make_shared<PinnedBufferPool>())
+{
+    frameInfo_ = {};
+}
+
+DeckLinkVideoInput::~DeckLinkVideoInput() {
+    close();
+}
+
+bool DeckLinkVideoInput::isDeckLinkSource(const std::string& source) {
+    return source.compare(0, std::strlen(PREFIX), PREFIX) == 0;
+}
+
+bool DeckLinkVideoInput::open(const std::string& source) {
+    close();
+
+    std::string spec = isDeckLinkSource(source) ? source.substr(std::strlen(PREFIX)) : source;
+    std::string modeName;
+    size_t query = spec.find("?mode=");
+    if (query != std::string::npos) {
+        modeName = spec.substr(query + 6);
+        spec.erase(query);
+    }
+
+#ifdef HAVE_DECKLINK_SDK
+    IDeckLinkIterator* iterator = CreateDeckLinkIteratorInstance();
+    if (!iterator) {
+        LOG_ERROR << "DeckLink: Driver not installed";
+        return false;
+    }
+    // First card, by index, or by part of its name
+    char* end = nullptr;
+    long index = spec.empty() ? 0 : std::strtol(spec.c_str(), &end, 10);
+    bool byIndex = spec.empty() || (end && *end == '\0');
+    IDeckLink* device = nullptr;
+    for (long i = 0; iterator->Next(&device) == S_OK; ++i) {
+        const char* name = nullptr;
+        device->GetDisplayName(&name);
+        std::string displayName = takeString(name);
+        if (byIndex ? i == index : displayName.find(spec) != std::string::npos) {
+            device_ = device;
+            deviceName_ = displayName;
+            break;
+        }
+        device->Release();
+    }
+    iterator->Release();
+    if (!device_) {
+        LOG_ERROR << "DeckLink: No card '" << spec << "'";
+        return false;
+    }
+    if (device_->QueryInterface(IID_IDeckLinkInput, reinterpret_cast<void**>(&input_)) != S_OK) {
+        LOG_ERROR << "DeckLink: " << deviceName_ << " has no video input";
+        close();
+        return false;
+    }
+
+    IDeckLinkDisplayMode* mode = findInputMode(input_, modeName);
+    if (!mode) {
+        LOG_ERROR << "DeckLink: " << deviceName_ << " has no input mode '" << modeName << "'";
+        close();
+        return false;
+    }
+    BMDDisplayMode displayMode = mode->GetDisplayMode();
+    BMDTimeValue duration = 0;
+    BMDTimeScale scale = 0;
+    mode->GetFrameRate(&duration, &scale);
+    onFormatChanged(static_cast<int>(mode->GetWidth()), static_cast<int>(mode->GetHeight()),
+                    duration > 0 ? static_cast<double>(scale) / duration : 25.0, scale, duration,
+                    mode->GetFieldDominance() != bmdProgressiveFrame);
+    mode->Release();
+
+    // 8-bit 4:2:2, converted in the renderer's shader; follows the signal where the card can
+    inputFlags_ = bmdVideoInputEnableFormatDetection;
+    if (input_->EnableVideoInput(displayMode, bmdFormat8BitYUV, inputFlags_) != S_OK) {
+        inputFlags_ = bmdVideoInputFlagDefault;
+        if (input_->EnableVideoInput(displayMode, bmdFormat8BitYUV, inputFlags_) != S_OK) {
+            LOG_ERROR << "DeckLink: Could not enable the input of " << deviceName_;
+            close();
+            return false;
+        }
+        LOG_WARNING << "DeckLink: " << deviceName_ << " cannot detect the input format; it must match "
+                    << frameInfo_.width << "x" << frameInfo_.height;
+    }
+
+    PoolAllocator* allocator = new PoolAllocator(buffers_);
+    allocator_ = allocator;
+    input_->SetVideoInputFrameMemoryAllocator(allocator);
+    InputCallback* callback = new InputCallback(this, input_, inputFlags_);
+    callback_ = callback;
+    input_->SetCallback(callback);
+    if (input_->StartStreams() != S_OK) {
+        LOG_ERROR << "DeckLink: Could not start capture on " << deviceName_;
+        close();
+        return false;
+    }
+
+    LOG_INFO << "DeckLink: Capturing from " << deviceName_ << " (" << frameInfo_.width << "x"
+             << frameInfo_.height << " @ " << frameInfo_.framerate << " fps, UYVY"
+             << (buffers_->isLocked() ? "" : ", buffers not locked") << ")";
+    ready_ = true;
+    startCaptureThread();
+    return true;
+#else
+    (void)modeName;
+    LOG_ERROR << "DeckLink SDK not available (compiled without HAVE_DECKLINK_SDK)";
+    return false;
+#endif
+}
+
+void DeckLinkVideoInput::close() {
+    stopCaptureThread();
+
+#ifdef HAVE_DECKLINK_SDK
+    if (input_) {
+        input_->StopStreams();
+        input_->SetCallback(nullptr);
+        input_->DisableVideoInput();
+        input_->Release();
+        input_ = nullptr;
+    }
+    if (callback_) {
+        callback_->Release();
+        callback_ = nullptr;
+    }
+    if (allocator_) {
+        allocator_->Release();  // The pool stays while frames hold buffers
+        allocator_ = nullptr;
+    }
+    if (device_) {
+        device_->Release();
+        device_ = nullptr;
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        newest_.reset();
+        newestData_ = nullptr;
+    }
+    ready_ = false;
+    frameCount_ = 0;
+}
+
+FrameInfo DeckLinkVideoInput::getFrameInfo() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frameInfo_;
+}
+
+void DeckLinkVideoInput::onFormatChanged(int width, int height, double framerate, int64_t rateNum,
+                                         int64_t rateDen, bool interlaced) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frameInfo_.width = width;
+    frameInfo_.height = height;
+    frameInfo_.aspect = height > 0 ? static_cast<float>(width) / static_cast<float>(height) : 0.0f;
+    frameInfo_.framerate = framerate > 0.0 ? framerate : 25.0;
+    frameInfo_.framerateNum = static_cast<int>(rateNum);
+    frameInfo_.framerateDen = static_cast<int>(rateDen);
+    frameInfo_.format = PixelFormat::UYVY422;
+    frameInfo_.colorMatrix = height < 720 ? ColorMatrix::BT601 : ColorMatrix::BT709;
+    frameInfo_.totalFrames = 0;  // Live stream
+    frameInfo_.duration = 0.0;
+    if (interlaced) {
+        LOG_INFO << "DeckLink: Interlaced input, both fields shown as one frame";
+    }
+}
+
+void DeckLinkVideoInput::onFrameArrived(const std::shared_ptr<void>& frame, const uint8_t* data, int width,
+                                        int height, long rowBytes,
+                                        std::chrono::steady_clock::time_point receiveTime) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (newest_) {
+            ++replaced_;  // The capture thread did not get to it
+        }
+        newest_ = frame;
+        newestData_ = data;
+        newestWidth_ = width;
+        newestHeight_ = height;
+        newestRowBytes_ = rowBytes;
+        newestReceiveTime_ = receiveTime;
+    }
+    frameArrived_.notify_one();
+}
+
+bool DeckLinkVideoInput::captureFrame(FrameBuffer& buffer) {
+    std::shared_ptr<void> frame;
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    long rowBytes = 0;
+    FrameInfo info;
+    uint64_t replaced = 0;
+    std::chrono::steady_clock::time_point receiveTime;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!frameArrived_.wait_for(lock, std::chrono::milliseconds(100), [this] { return newest_ != nullptr; })) {
+            return false;
+        }
+        frame = std::move(newest_);
+        newest_.reset();
+        data = newestData_;
+        width = newestWidth_;
+        height = newestHeight_;
+        rowBytes = newestRowBytes_;
+        receiveTime = newestReceiveTime_;
+        replaced = replaced_;
+        replaced_ = 0;
+        info = frameInfo_;
+    }
+    if (replaced > 0) {
+        addDroppedFrames(replaced);
+    }
+    setFrameReceiveTime(receiveTime);
+
+    info.width = width;
+    info.height = height;
+    info.format = PixelFormat::UYVY422;
+    size_t tightRow = static_cast<size_t>(width) * 2;
+    if (rowBytes == static_cast<long>(tightRow)) {
+        // Zero-copy: the layer gets the card's buffer, back to the pool with its last reference
+        if (!buffer.wrap(data, tightRow * height, info, frame)) {
+            return false;
+        }
+        frameCount_++;
+        return true;
+    }
+
+    // Padded rows: copy them tight
+    if (!buffer.ensureAllocated(info)) {
+        return false;
+    }
+    for (int row = 0; row < height; ++row) {
+        std::memcpy(buffer.data() + row * tightRow, data + static_cast<size_t>(row) * rowBytes, tightRow);
+    }
+    frameCount_++;
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,99 @@
+#ifndef VIDEOCOMPOSER_DECKLINKVIDEOINPUT_H
+#define VIDEOCOMPOSER_DECKLINKVIDEOINPUT_H
+
+#include "LiveInputSource.h"
+#include "../video/FrameFormat.h"
+#include "../video/PinnedBufferPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#ifdef HAVE_DECKLINK_SDK
+#include <DeckLinkAPI.h>
+#endif
+
+namespace videocomposer {
+
+/**
+ * DeckLinkVideoInput - SDI/HDMI capture from a Blackmagic DeckLink card
+ *
+ * Source: "decklink://" plus the card (index or part of its name), with an
+ * optional "?mode=NAME" to start from (e.g. "decklink://1?mode=1080p50");
+ * the card's format detection follows the signal after that.
+ *
+ * The card DMAs each frame as 8-bit UYVY into a page-aligned, locked
+ * buffer of a PinnedBufferPool (its frame memory allocator), and the frame
+ * is handed to the layer as is: the renderer uploads it from there and
+ * converts it in a shader, and the buffer goes back to the pool when the
+ * last FrameBuffer referencing it is released. 8-bit UYVY rows are tight,
+ * so frames are not copied.
+ *
+ * Latency: only the newest arrived frame is kept, and its receive time is
+ * taken from the card's hardware reference clock (the end of the frame on
+ * the wire), so the layer shows a frame at most one capture period plus
+ * one output frame after it arrived.
+ */
+class DeckLinkVideoInput : public LiveInputSource {
+public:
+    static constexpr const char* PREFIX = "decklink://";
+
+    DeckLinkVideoInput();
+    virtual ~DeckLinkVideoInput();
+
+    static bool isDeckLinkSource(const std::string& source);
+
+    // InputSource interface
+    bool open(const std::string& source) override;
+    void close() override;
+    bool isReady() const override { return ready_; }
+    FrameInfo getFrameInfo() const override;
+    int64_t getCurrentFrame() const override { return frameCount_.load(); }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+    bool hasAlpha() const override { return false; }
+
+    // Card callback thread
+    void onFrameArrived(const std::shared_ptr<void>& frame, const uint8_t* data, int width, int height,
+                        long rowBytes, std::chrono::steady_clock::time_point receiveTime);
+    void onFormatChanged(int width, int height, double framerate, int64_t rateNum, int64_t rateDen,
+                         bool interlaced);
+
+protected:
+    bool captureFrame(FrameBuffer& buffer) override;
+    const char* getSourceTypeName() const override { return "DeckLink"; }
+
+private:
+    std::string deviceName_;
+    bool ready_ = false;
+    std::atomic<int64_t> frameCount_{0};
+
+    mutable std::mutex mutex_;   // Frame hand-over and format: card thread vs. capture thread
+    std::condition_variable frameArrived_;
+    FrameInfo frameInfo_;
+    std::shared_ptr<void> newest_;       // Keeps the card's frame (and its buffer)
+    const uint8_t* newestData_ = nullptr;
+    int newestWidth_ = 0;
+    int newestHeight_ = 0;
+    long newestRowBytes_ = 0;
+    std::chrono::steady_clock::time_point newestReceiveTime_;
+    uint64_t replaced_ = 0;              // Frames replaced before the capture thread took them
+
+    std::shared_ptr<PinnedBufferPool> buffers_;
+
+#ifdef HAVE_DECKLINK_SDK
+    IDeckLink* device_ = nullptr;
+    IDeckLinkInput* input_ = nullptr;
+    IUnknown* callback_ = nullptr;      // IDeckLinkInputCallback
+    IUnknown* allocator_ = nullptr;     // IDeckLinkMemoryAllocator
+    BMDVideoInputFlags inputFlags_ = bmdVideoInputFlagDefault;
+#endif
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECKLINKVIDEOINPUT_H
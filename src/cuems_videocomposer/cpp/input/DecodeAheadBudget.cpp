@@ -0,0 +1,112 @@
+#include "DecodeAheadBudget.h"
+#include <algorithm>
+#include <vector>
+
+namespace videocomposer {
+
+DecodeAheadBudget& DecodeAheadBudget::instance() {
+    static DecodeAheadBudget budget;
+    return budget;
+}
+
+DecodeAheadBudget::DecodeAheadBudget()
+    : totalBytes_(0)
+    , underrunProbability_(DEFAULT_UNDERRUN_PROBABILITY)
+    , nextId_(1)
+{
+}
+
+void DecodeAheadBudget::configure(size_t totalBytes, double underrunProbability) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    totalBytes_ = totalBytes;
+    underrunProbability_ = std::min(std::max(underrunProbability, 0.0), 0.5);
+}
+
+size_t DecodeAheadBudget::getTotalBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalBytes_;
+}
+
+double DecodeAheadBudget::getUnderrunProbability() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return underrunProbability_;
+}
+
+DecodeAheadBudget::ClientId DecodeAheadBudget::addClient(int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClientId id = nextId_++;
+    clients_[id].priority = std::max(1, priority);
+    return id;
+}
+
+void DecodeAheadBudget::removeClient(ClientId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.erase(id);
+}
+
+void DecodeAheadBudget::setPriority(ClientId id, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it != clients_.end()) {
+        it->second.priority = std::max(1, priority);
+    }
+}
+
+size_t DecodeAheadBudget::request(ClientId id, size_t demandBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it == clients_.end()) {
+        return demandBytes;
+    }
+    it->second.demand = demandBytes;
+    return grantLocked(id);
+}
+
+size_t DecodeAheadBudget::grantLocked(ClientId id) const {
+    size_t totalDemand = 0;
+    for (const auto& entry : clients_) {
+        totalDemand += entry.second.demand;
+    }
+    if (totalBytes_ == 0 || totalDemand <= totalBytes_) {
+        return clients_.at(id).demand;
+    }
+
+    // Water-filling: satisfy clients whose demand is below their weighted
+    // share, then split what is left among the rest
+    std::vector<const std::pair<const ClientId, Client>*> open;
+    for (const auto& entry : clients_) {
+        open.push_back(&entry);
+    }
+    double remaining = static_cast<double>(totalBytes_);
+    for (;;) {
+        double weights = 0.0;
+        for (const auto* entry : open) {
+            weights += entry->second.priority;
+        }
+        bool satisfiedAny = false;
+        for (auto it = open.begin(); it != open.end(); ) {
+            double share = remaining * (*it)->second.priority / weights;
+            if (static_cast<double>((*it)->second.demand) <= share) {
+                if ((*it)->first == id) {
+                    return (*it)->second.demand;
+                }
+                remaining -= static_cast<double>((*it)->second.demand);
+                it = open.erase(it);
+                satisfiedAny = true;
+            } else {
+                ++it;
+            }
+        }
+        if (!satisfiedAny) {
+            break;
+        }
+    }
+
+    double weights = 0.0;
+    for (const auto* entry : open) {
+        weights += entry->second.priority;
+    }
+    return static_cast<size_t>(remaining * clients_.at(id).priority / weights);
+}
+
+} // namespace videocomposer
@@ -0,0 +1,74 @@
+#ifndef VIDEOCOMPOSER_DECODEAHEADBUDGET_H
+#define VIDEOCOMPOSER_DECODEAHEADBUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace videocomposer {
+
+/**
+ * DecodeAheadBudget - Process-wide memory budget for decode-ahead queues
+ *
+ * Every AsyncDecodeQueue registers here and periodically reports how much
+ * memory its measured decode jitter calls for (depth x frame size). While
+ * the sum of the demands fits the budget every layer gets what it asked
+ * for; beyond that the budget is shared by priority (water-filling: a
+ * layer never gets more than it asked for, and what it leaves over goes
+ * to the others in proportion to their priorities).
+ *
+ * A total of 0 disables the global limit (each layer is still bounded by
+ * its own frame pool).
+ */
+class DecodeAheadBudget {
+public:
+    static constexpr int DEFAULT_PRIORITY = 1;
+    static constexpr double DEFAULT_UNDERRUN_PROBABILITY = 0.01;
+
+    using ClientId = uint64_t;
+
+    /**
+     * Shared instance (unlimited until configured)
+     */
+    static DecodeAheadBudget& instance();
+
+    DecodeAheadBudget();
+
+    /**
+     * @param totalBytes Memory shared by all decode-ahead queues (0 = unlimited)
+     * @param underrunProbability Target fraction of decodes allowed to outlast the queue
+     */
+    void configure(size_t totalBytes, double underrunProbability = DEFAULT_UNDERRUN_PROBABILITY);
+
+    size_t getTotalBytes() const;
+    double getUnderrunProbability() const;
+
+    ClientId addClient(int priority = DEFAULT_PRIORITY);
+    void removeClient(ClientId id);
+    void setPriority(ClientId id, int priority);
+
+    /**
+     * Report a client's demand and get the bytes it may use
+     * @return Granted bytes (= demandBytes when the budget allows)
+     */
+    size_t request(ClientId id, size_t demandBytes);
+
+private:
+    struct Client {
+        int priority = DEFAULT_PRIORITY;
+        size_t demand = 0;
+    };
+
+    size_t grantLocked(ClientId id) const;
+
+    mutable std::mutex mutex_;
+    size_t totalBytes_;
+    double underrunProbability_;
+    std::map<ClientId, Client> clients_;
+    ClientId nextId_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECODEAHEADBUDGET_H
@@ -0,0 +1,41 @@
+#include "DecodeJitterTracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+void DecodeJitterTracker::addSample(double seconds) {
+    samples_[next_] = std::max(0.0, seconds);
+    next_ = (next_ + 1) % WINDOW;
+    count_ = std::min(count_ + 1, WINDOW);
+}
+
+void DecodeJitterTracker::reset() {
+    next_ = 0;
+    count_ = 0;
+}
+
+double DecodeJitterTracker::percentile(double q) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    std::array<double, WINDOW> sorted = samples_;
+    size_t index = static_cast<size_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * count_));
+    index = index > 0 ? index - 1 : 0;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + count_);
+    return sorted[index];
+}
+
+size_t DecodeJitterTracker::depthFor(double framePeriod, double underrunProbability,
+                                     size_t minDepth, size_t maxDepth) const {
+    maxDepth = std::max(minDepth, maxDepth);
+    if (count_ < MIN_SAMPLES || framePeriod <= 0.0 || percentile(0.5) >= framePeriod) {
+        return maxDepth;
+    }
+    // Frames played while the slow decode runs, plus the one being shown
+    double spike = percentile(1.0 - underrunProbability);
+    size_t depth = static_cast<size_t>(std::ceil(spike / framePeriod)) + 1;
+    return std::min(std::max(depth, minDepth), maxDepth);
+}
+
+} // namespace videocomposer
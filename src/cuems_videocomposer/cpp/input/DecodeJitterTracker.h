@@ -0,0 +1,54 @@
+#ifndef VIDEOCOMPOSER_DECODEJITTERTRACKER_H
+#define VIDEOCOMPOSER_DECODEJITTERTRACKER_H
+
+#include <array>
+#include <cstddef>
+
+namespace videocomposer {
+
+/**
+ * DecodeJitterTracker - Recent decode times of one layer and the
+ * decode-ahead depth they call for
+ *
+ * While one frame decodes, playback consumes duration / frame period
+ * queued frames. A queue deep enough for the (1 - underrunProbability)
+ * quantile of recent decode times therefore only runs dry on rarer
+ * spikes. A decoder slower than real time on average (median above the
+ * frame period) cannot be saved by depth and gets the maximum.
+ *
+ * Not thread-safe: owned by one decode thread.
+ */
+class DecodeJitterTracker {
+public:
+    static constexpr size_t WINDOW = 120;      // Samples kept (a few seconds of playback)
+    static constexpr size_t MIN_SAMPLES = 16;  // Below this depthFor() returns maxDepth
+
+    void addSample(double seconds);
+    void reset();
+
+    size_t sampleCount() const { return count_; }
+
+    /**
+     * Quantile of the recent decode times
+     * @param q 0..1 (0.5 = median)
+     * @return Seconds, or 0 without samples
+     */
+    double percentile(double q) const;
+
+    /**
+     * Look-ahead depth for a target underrun probability
+     * @param framePeriod Seconds per played frame
+     * @param underrunProbability Fraction of decodes allowed to outlast the queue (e.g. 0.01)
+     */
+    size_t depthFor(double framePeriod, double underrunProbability,
+                    size_t minDepth, size_t maxDepth) const;
+
+private:
+    std::array<double, WINDOW> samples_{};
+    size_t next_ = 0;
+    size_t count_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECODEJITTERTRACKER_H
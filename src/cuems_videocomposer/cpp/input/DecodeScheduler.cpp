@@ -0,0 +1,163 @@
+#include "DecodeScheduler.h"
+#include <algorithm>
+#include <thread>
+
+namespace videocomposer {
+
+namespace {
+double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int resourceIndex(DecodeScheduler::Resource resource) {
+    return resource == DecodeScheduler::Resource::HARDWARE ? 1 : 0;
+}
+} // namespace
+
+DecodeScheduler& DecodeScheduler::instance() {
+    static DecodeScheduler scheduler;
+    return scheduler;
+}
+
+DecodeScheduler::DecodeScheduler()
+    : cpuSlots_(0)
+    , hardwareSlots_(0)
+    , active_{0, 0}
+    , nextId_(1)
+{
+}
+
+void DecodeScheduler::configure(int cpuSlots, int hardwareSlots) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpuSlots_ = std::max(0, cpuSlots);
+    hardwareSlots_ = std::max(0, hardwareSlots);
+    slotCond_.notify_all();
+}
+
+int DecodeScheduler::getSlots(Resource resource) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slotsLocked(resource);
+}
+
+int DecodeScheduler::slotsLocked(Resource resource) const {
+    if (resource == Resource::HARDWARE) {
+        return hardwareSlots_ > 0 ? hardwareSlots_ : DEFAULT_HARDWARE_SLOTS;
+    }
+    if (cpuSlots_ > 0) {
+        return cpuSlots_;
+    }
+    // Software decoders run several threads each: half the cores keeps
+    // them all busy without every layer decoding at once
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2);
+}
+
+DecodeScheduler::ClientId DecodeScheduler::addClient(Resource resource, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClientId id = nextId_++;
+    Client& client = clients_[id];
+    client.resource = resource;
+    client.priority = std::max(1, priority);
+    return id;
+}
+
+void DecodeScheduler::removeClient(ClientId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it == clients_.end()) {
+        return;
+    }
+    active_[resourceIndex(it->second.resource)] -= it->second.held;
+    clients_.erase(it);
+    slotCond_.notify_all();
+}
+
+void DecodeScheduler::setPriority(ClientId id, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it != clients_.end()) {
+        it->second.priority = std::max(1, priority);
+    }
+}
+
+void DecodeScheduler::setVisible(ClientId id, bool visible) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it != clients_.end()) {
+        it->second.visible = visible;
+    }
+}
+
+void DecodeScheduler::setBackground(ClientId id, bool background) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it != clients_.end()) {
+        it->second.background = background;
+        slotCond_.notify_all();
+    }
+}
+
+double DecodeScheduler::deadline(double now, double slackSeconds, int priority, bool visible) {
+    double slack = std::max(0.0, slackSeconds) / std::max(1, priority);
+    return now + slack + (visible ? 0.0 : HIDDEN_DELAY);
+}
+
+bool DecodeScheduler::firstInLineLocked(ClientId id, const Client& client) const {
+    // Free slots left once the waiters with earlier deadlines have theirs
+    int ahead = 0;
+    for (const auto& entry : clients_) {
+        const Client& other = entry.second;
+        if (entry.first == id || !other.waiting || other.resource != client.resource) {
+            continue;
+        }
+        if (client.background != other.background) {
+            ahead += client.background ? 1 : 0;  // Background waits behind everyone
+            continue;
+        }
+        // Lower id first on ties
+        if (other.deadline < client.deadline ||
+            (other.deadline == client.deadline && entry.first < id)) {
+            ahead++;
+        }
+    }
+    int slots = slotsLocked(client.resource);
+    if (client.background) {
+        // A slot stays free for playback
+        return ahead == 0 && active_[resourceIndex(client.resource)] + (slots > 1 ? 1 : 0) < slots;
+    }
+    return active_[resourceIndex(client.resource)] + ahead < slots;
+}
+
+bool DecodeScheduler::acquire(ClientId id, double slackSeconds, std::chrono::milliseconds maxWait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it == clients_.end()) {
+        return true;  // Not scheduled
+    }
+    Client& client = it->second;
+    client.deadline = deadline(nowSeconds(), slackSeconds, client.priority, client.visible);
+    client.waiting = true;
+    bool granted = firstInLineLocked(id, client) ||
+        (maxWait.count() > 0 &&
+         slotCond_.wait_for(lock, maxWait, [&] { return firstInLineLocked(id, client); }));
+    client.waiting = false;
+    if (granted) {
+        client.held++;
+        active_[resourceIndex(client.resource)]++;
+    } else {
+        slotCond_.notify_all();  // We no longer stand in front of anyone
+    }
+    return granted;
+}
+
+void DecodeScheduler::release(ClientId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it == clients_.end() || it->second.held <= 0) {
+        return;
+    }
+    it->second.held--;
+    active_[resourceIndex(it->second.resource)]--;
+    slotCond_.notify_all();
+}
+
+} // namespace videocomposer
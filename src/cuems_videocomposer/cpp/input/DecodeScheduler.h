@@ -0,0 +1,100 @@
+#ifndef VIDEOCOMPOSER_DECODESCHEDULER_H
+#define VIDEOCOMPOSER_DECODESCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace videocomposer {
+
+/**
+ * DecodeScheduler - Earliest-deadline-first admission of decode work
+ *
+ * Decode-ahead threads take a slot here before each frame they decode.
+ * Slots are limited per resource (software decoders, hardware decoder),
+ * and when more layers want one than there are, the layer whose queue
+ * runs dry first gets it: its deadline is now plus the time its queued
+ * frames cover. Priority shortens that time (priority 2 counts as half
+ * the buffer), and a layer nobody sees is pushed back by HIDDEN_DELAY
+ * seconds, so it decodes only when the visible layers are comfortable.
+ *
+ * Without contention a slot is granted at once. Background clients
+ * (thumbnails) only get a slot nobody else waits for, and never the last
+ * free one of a resource with several.
+ */
+class DecodeScheduler {
+public:
+    static constexpr int DEFAULT_PRIORITY = 1;
+    static constexpr double HIDDEN_DELAY = 1.0;  // Seconds a hidden layer's deadline moves back
+    static constexpr int DEFAULT_HARDWARE_SLOTS = 2;
+
+    enum class Resource {
+        CPU,
+        HARDWARE
+    };
+
+    using ClientId = uint64_t;
+
+    /**
+     * Shared instance (auto slot counts until configured)
+     */
+    static DecodeScheduler& instance();
+
+    DecodeScheduler();
+
+    /**
+     * @param cpuSlots Software frame decodes at once (0 = half the cores)
+     * @param hardwareSlots Hardware frame decodes at once (0 = DEFAULT_HARDWARE_SLOTS)
+     */
+    void configure(int cpuSlots, int hardwareSlots);
+
+    int getSlots(Resource resource) const;
+
+    ClientId addClient(Resource resource, int priority = DEFAULT_PRIORITY);
+    void removeClient(ClientId id);
+    void setPriority(ClientId id, int priority);
+    void setVisible(ClientId id, bool visible);
+    void setBackground(ClientId id, bool background);
+
+    /**
+     * Wait for a decode slot, earliest deadline first
+     * @param slackSeconds Time the client's queued frames still cover
+     * @param maxWait Give up after this long (0 = only if free now)
+     * @return true with a slot to release() after the decode
+     */
+    bool acquire(ClientId id, double slackSeconds, std::chrono::milliseconds maxWait);
+    void release(ClientId id);
+
+    /**
+     * Deadline ordering key (seconds; smaller goes first)
+     */
+    static double deadline(double now, double slackSeconds, int priority, bool visible);
+
+private:
+    struct Client {
+        Resource resource = Resource::CPU;
+        int priority = DEFAULT_PRIORITY;
+        bool visible = true;
+        bool background = false;
+        bool waiting = false;
+        double deadline = 0.0;
+        int held = 0;
+    };
+
+    bool firstInLineLocked(ClientId id, const Client& client) const;
+    int slotsLocked(Resource resource) const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable slotCond_;
+    int cpuSlots_;
+    int hardwareSlots_;
+    int active_[2];  // Slots in use per resource
+    std::map<ClientId, Client> clients_;
+    ClientId nextId_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECODESCHEDULER_H
@@ -0,0 +1,125 @@
+#include "DecodeThreadBudget.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+namespace {
+int coreCount() {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+} // namespace
+
+DecodeThreadBudget& DecodeThreadBudget::instance() {
+    static DecodeThreadBudget budget;
+    return budget;
+}
+
+DecodeThreadBudget::DecodeThreadBudget()
+    : totalThreads_(coreCount())
+    , nextId_(1)
+{
+}
+
+void DecodeThreadBudget::configure(int totalThreads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    totalThreads_ = totalThreads > 0 ? totalThreads : coreCount();
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+int DecodeThreadBudget::getTotalThreads() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalThreads_;
+}
+
+DecodeThreadBudget::ClientId DecodeThreadBudget::addClient(int width, int height, int priority, bool lowLatency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClientId id = nextId_++;
+    Client& client = clients_[id];
+    client.pixels = std::max(1.0, static_cast<double>(width) * static_cast<double>(height));
+    client.priority = std::max(1, priority);
+    client.lowLatency = lowLatency;
+    generation_.fetch_add(1, std::memory_order_release);
+    return id;
+}
+
+void DecodeThreadBudget::removeClient(ClientId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (clients_.erase(id)) {
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void DecodeThreadBudget::setPriority(ClientId id, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it != clients_.end() && it->second.priority != std::max(1, priority)) {
+        it->second.priority = std::max(1, priority);
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void DecodeThreadBudget::setLowLatency(ClientId id, bool lowLatency) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(id);
+    if (it != clients_.end() && it->second.lowLatency != lowLatency) {
+        it->second.lowLatency = lowLatency;
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+DecodeThreadBudget::Grant DecodeThreadBudget::grant(ClientId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Grant result;
+    auto it = clients_.find(id);
+    if (it == clients_.end()) {
+        return result;
+    }
+    result.threads = threadsLocked(id);
+    result.frameThreads = !it->second.lowLatency && result.threads > 1;
+    return result;
+}
+
+int DecodeThreadBudget::threadsLocked(ClientId id) const {
+    double weights = 0.0;
+    for (const auto& entry : clients_) {
+        weights += entry.second.pixels * entry.second.priority;
+    }
+
+    // Largest remainder: floors first, the leftover threads to the largest
+    // fractions (lower id first on ties), so the shares add up to the total
+    struct Share {
+        ClientId id;
+        int threads;
+        double fraction;
+    };
+    std::vector<Share> shares;
+    shares.reserve(clients_.size());
+    int assigned = 0;
+    for (const auto& entry : clients_) {
+        double exact = totalThreads_ * entry.second.pixels * entry.second.priority / weights;
+        int threads = static_cast<int>(std::floor(exact));
+        shares.push_back({entry.first, threads, exact - threads});
+        assigned += threads;
+    }
+    std::vector<Share*> byFraction;
+    for (Share& share : shares) {
+        byFraction.push_back(&share);
+    }
+    std::stable_sort(byFraction.begin(), byFraction.end(),
+                     [](const Share* a, const Share* b) { return a->fraction > b->fraction; });
+    for (size_t i = 0; assigned < totalThreads_ && i < byFraction.size(); ++i, ++assigned) {
+        ++byFraction[i]->threads;
+    }
+
+    for (const Share& share : shares) {
+        if (share.id == id) {
+            return std::min(std::max(1, share.threads), MAX_CLIENT_THREADS);
+        }
+    }
+    return 1;
+}
+
+} // namespace videocomposer
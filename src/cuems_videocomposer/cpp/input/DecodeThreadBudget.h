@@ -0,0 +1,83 @@
+#ifndef VIDEOCOMPOSER_DECODETHREADBUDGET_H
+#define VIDEOCOMPOSER_DECODETHREADBUDGET_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace videocomposer {
+
+/**
+ * DecodeThreadBudget - Process-wide FFmpeg decoder thread budget
+ *
+ * Every software decoder registers here with its resolution and priority
+ * and opens its codec with the thread count it is granted. The total is
+ * split in proportion to priority x pixels (largest remainder, at least
+ * one thread each), so eight software layers on eight cores get about
+ * eight decoder threads instead of eight times FFmpeg's default.
+ *
+ * Low-latency clients (live sources, layers that keep seeking) get slice
+ * threading only: frame threading delays every frame by one per thread
+ * and has to refill after each seek. The others get frame threading for
+ * throughput.
+ *
+ * The thread count of an open codec is fixed, so clients re-read their
+ * grant at points where they flush anyway (seeks) once getGeneration()
+ * says the split has changed.
+ */
+class DecodeThreadBudget {
+public:
+    static constexpr int DEFAULT_PRIORITY = 1;
+    static constexpr int MAX_CLIENT_THREADS = 16;  // FFmpeg gains nothing beyond this
+
+    using ClientId = uint64_t;
+
+    struct Grant {
+        int threads = 0;            // 0 = FFmpeg default (unknown client)
+        bool frameThreads = false;  // Frame + slice threading; slice only if false
+    };
+
+    /**
+     * Shared instance (all cores until configured)
+     */
+    static DecodeThreadBudget& instance();
+
+    DecodeThreadBudget();
+
+    /**
+     * @param totalThreads Decoder threads shared by all layers (0 = one per core)
+     */
+    void configure(int totalThreads);
+
+    int getTotalThreads() const;
+
+    ClientId addClient(int width, int height, int priority = DEFAULT_PRIORITY, bool lowLatency = false);
+    void removeClient(ClientId id);
+    void setPriority(ClientId id, int priority);
+    void setLowLatency(ClientId id, bool lowLatency);
+
+    Grant grant(ClientId id) const;
+
+    /** Bumped whenever a grant may have changed */
+    uint64_t getGeneration() const { return generation_.load(std::memory_order_acquire); }
+
+private:
+    struct Client {
+        double pixels = 1.0;
+        int priority = DEFAULT_PRIORITY;
+        bool lowLatency = false;
+    };
+
+    int threadsLocked(ClientId id) const;
+
+    mutable std::mutex mutex_;
+    int totalThreads_;
+    std::map<ClientId, Client> clients_;
+    ClientId nextId_;
+    std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECODETHREADBUDGET_H
@@ -0,0 +1,142 @@
+#include "DecoderContextPool.h"
+#include "../utils/Logger.h"
+#include <iterator>
+
+namespace videocomposer {
+
+bool DecoderContextPool::Key::operator==(const Key& other) const {
+    return decoder == other.decoder && profile == other.profile && width == other.width &&
+           height == other.height && format == other.format && device == other.device &&
+           threads == other.threads && frameThreads == other.frameThreads && extradata == other.extradata;
+}
+
+DecoderContextPool& DecoderContextPool::instance() {
+    static DecoderContextPool pool;
+    return pool;
+}
+
+DecoderContextPool::DecoderContextPool()
+    : capacity_(DEFAULT_CAPACITY)
+    , reuses_(0)
+{
+}
+
+DecoderContextPool::~DecoderContextPool() {
+    clear();
+}
+
+void DecoderContextPool::setCapacity(size_t capacity) {
+    std::deque<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (idle_.size() > capacity_) {
+            evicted.push_back(idle_.front());
+            idle_.pop_front();
+        }
+    }
+    for (Entry& entry : evicted) {
+        avcodec_free_context(&entry.ctx);
+    }
+}
+
+size_t DecoderContextPool::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+DecoderContextPool::Key DecoderContextPool::makeKey(const AVCodec* codec, const AVCodecParameters* params,
+                                                    const std::string& device, int threads, bool frameThreads) {
+    Key key;
+    if (codec && codec->name) {
+        key.decoder = codec->name;
+    }
+    if (params) {
+        key.profile = params->profile;
+        key.width = params->width;
+        key.height = params->height;
+        key.format = params->format;
+        if (params->extradata && params->extradata_size > 0) {
+            key.extradata.assign(params->extradata, params->extradata + params->extradata_size);
+        }
+    }
+    key.device = device;
+    key.threads = threads;
+    key.frameThreads = frameThreads;
+    return key;
+}
+
+AVCodecContext* DecoderContextPool::acquire(const Key& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Most recently returned first: its surfaces are the likeliest still resident
+    for (auto it = idle_.rbegin(); it != idle_.rend(); ++it) {
+        if (it->key == key) {
+            AVCodecContext* ctx = it->ctx;
+            idle_.erase(std::next(it).base());
+            ++reuses_;
+            return ctx;
+        }
+    }
+    return nullptr;
+}
+
+void DecoderContextPool::release(const Key& key, AVCodecContext*& ctx) {
+    if (!ctx) {
+        return;
+    }
+    if (key.decoder.empty()) {
+        avcodec_free_context(&ctx);
+        return;
+    }
+
+    // Nothing of the last stream survives: no frames, no per-layer decode settings
+    avcodec_flush_buffers(ctx);
+    ctx->skip_frame = AVDISCARD_DEFAULT;
+
+    std::deque<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ > 0) {
+            Entry entry;
+            entry.key = key;
+            entry.ctx = ctx;
+            ctx = nullptr;
+            idle_.push_back(std::move(entry));
+        }
+        while (idle_.size() > capacity_) {
+            evicted.push_back(idle_.front());
+            idle_.pop_front();
+        }
+    }
+    if (ctx) {
+        avcodec_free_context(&ctx);
+    }
+    for (Entry& entry : evicted) {
+        LOG_VERBOSE << "DecoderContextPool: Freeing idle " << entry.key.decoder << " " << entry.key.width << "x"
+                    << entry.key.height << " decoder";
+        avcodec_free_context(&entry.ctx);
+    }
+}
+
+void DecoderContextPool::clear() {
+    std::deque<Entry> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle.swap(idle_);
+    }
+    for (Entry& entry : idle) {
+        avcodec_free_context(&entry.ctx);
+    }
+}
+
+size_t DecoderContextPool::getIdleCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+uint64_t DecoderContextPool::getReuseCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reuses_;
+}
+
+} // namespace videocomposer
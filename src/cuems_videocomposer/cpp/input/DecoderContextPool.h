@@ -0,0 +1,98 @@
+#ifndef VIDEOCOMPOSER_DECODERCONTEXTPOOL_H
+#define VIDEOCOMPOSER_DECODERCONTEXTPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace videocomposer {
+
+/**
+ * DecoderContextPool - Warm decoder contexts of closed layers
+ *
+ * Opening a decoder (and for hardware decoding its VAAPI decode session
+ * and surface pool) costs far more than decoding a frame, and a playlist
+ * of same-format clips opens one per cue. A layer that closes hands its
+ * opened context back here, flushed; the next load of a stream with the
+ * same decoder, profile, size, pixel format, headers and device (and for
+ * software decoders the same thread grant) reuses it instead of opening
+ * another. Headers are compared byte for byte: an MP4 decoder parses
+ * its SPS/PPS only when it opens.
+ *
+ * The least recently returned contexts are freed beyond the capacity
+ * (idle hardware contexts keep their surfaces). Thread-safe.
+ */
+class DecoderContextPool {
+public:
+    struct Key {
+        std::string decoder;           // AVCodec name (h264, h264_cuvid, ...)
+        int profile = 0;
+        int width = 0;
+        int height = 0;
+        int format = -1;               // Stream pixel format (AVCodecParameters::format)
+        std::string device;            // HardwareDeviceCache key ("" = software)
+        int threads = 0;               // Software thread grant
+        bool frameThreads = false;
+        std::vector<uint8_t> extradata;
+
+        bool operator==(const Key& other) const;
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY = 2;
+
+    static DecoderContextPool& instance();
+
+    DecoderContextPool();
+    ~DecoderContextPool();
+
+    DecoderContextPool(const DecoderContextPool&) = delete;
+    DecoderContextPool& operator=(const DecoderContextPool&) = delete;
+
+    /** Idle contexts kept (0 = free every context on release) */
+    void setCapacity(size_t capacity);
+    size_t getCapacity() const;
+
+    static Key makeKey(const AVCodec* codec, const AVCodecParameters* params, const std::string& device,
+                       int threads = 0, bool frameThreads = false);
+
+    /**
+     * An idle context opened for this key, taken out of the pool
+     * @return Opened context (caller owns it) or nullptr
+     */
+    AVCodecContext* acquire(const Key& key);
+
+    /**
+     * Return an opened context: flushed and kept for the key, or freed
+     * (ctx is nullptr afterwards either way)
+     */
+    void release(const Key& key, AVCodecContext*& ctx);
+
+    /** Free every idle context (before the devices they use go away) */
+    void clear();
+
+    size_t getIdleCount() const;
+    uint64_t getReuseCount() const;
+
+private:
+    struct Entry {
+        Key key;
+        AVCodecContext* ctx = nullptr;
+    };
+
+    mutable std::mutex mutex_;
+    std::deque<Entry> idle_;   // Oldest first
+    size_t capacity_;
+    uint64_t reuses_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECODERCONTEXTPOOL_H
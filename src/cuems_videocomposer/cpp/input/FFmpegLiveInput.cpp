@@ -1,21 +1,52 @@
 #include "FFmpegLiveInput.h"
+#include "HardwareDecoder.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
 #include <cuems_mediadecoder/FFmpegUtils.h>
+#include <algorithm>
 #include <cstring>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/frame.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/pixfmt.h>
 #include <libswscale/swscale.h>
 }
 
 namespace videocomposer {
 
+namespace {
+
+double steadySeconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration<double>(time.time_since_epoch()).count();
+}
+
+std::chrono::steady_clock::time_point steadyTime(double seconds) {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)));
+}
+
+double streamFramerate(const AVStream* avStream) {
+    // r_frame_rate is preferred over avg_frame_rate
+    if (avStream->r_frame_rate.den > 0 && avStream->r_frame_rate.num > 0) {
+        return av_q2d(avStream->r_frame_rate);
+    }
+    if (avStream->avg_frame_rate.den > 0 && avStream->avg_frame_rate.num > 0) {
+        return av_q2d(avStream->avg_frame_rate);
+    }
+    return 25.0;  // Default
+}
+
+} // namespace
+
 FFmpegLiveInput::FFmpegLiveInput()
     : ready_(false)
     , frameCount_(0)
+    , abort_(false)
+    , receiving_(false)
 {
     frameInfo_ = {};
 }
@@ -24,84 +55,300 @@ FFmpegLiveInput::~FFmpegLiveInput() {
     close();
 }
 
+bool FFmpegLiveInput::isNetworkUrl(const std::string& source) {
+    static const char* const schemes[] = {
+        "rtsp://", "rtsps://", "rtmp://", "srt://", "udp://", "rtp://", "tcp://", "http://", "https://"
+    };
+    for (const char* scheme : schemes) {
+        if (source.compare(0, strlen(scheme), scheme) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool FFmpegLiveInput::open(const std::string& source) {
     close();  // Close any existing connection
 
-    // Open with format if specified (e.g., "v4l2" for /dev/video*)
-    if (!mediaReader_.open(source, format_)) {
-        LOG_ERROR << "Failed to open live source: " << source;
-        return false;
+    if (lowLatency_) {
+        if (!openLowLatency(source)) {
+            return false;
+        }
+    } else {
+        // Open with format if specified (e.g., "v4l2" for /dev/video*)
+        if (!mediaReader_.open(source, format_)) {
+            LOG_ERROR << "Failed to open live source: " << source;
+            return false;
+        }
+
+        // Get video stream
+        int videoStream = mediaReader_.findStream(AVMEDIA_TYPE_VIDEO);
+        if (videoStream < 0) {
+            LOG_ERROR << "No video stream found in live source";
+            mediaReader_.close();
+            return false;
+        }
+
+        // Get codec parameters
+        auto codecParams = mediaReader_.getCodecParameters(videoStream);
+        if (!codecParams) {
+            LOG_ERROR << "Failed to get codec parameters";
+            mediaReader_.close();
+            return false;
+        }
+
+        // Open video decoder (software only for live streams)
+        if (!videoDecoder_.openCodec(codecParams)) {
+            LOG_ERROR << "Failed to open video decoder for live source";
+            mediaReader_.close();
+            return false;
+        }
+
+        // Get stream for framerate
+        AVStream* avStream = mediaReader_.getStream(videoStream);
+        if (!avStream) {
+            LOG_ERROR << "Failed to get stream";
+            mediaReader_.close();
+            return false;
+        }
+
+        // Get frame info
+        frameInfo_.width = codecParams->width;
+        frameInfo_.height = codecParams->height;
+        frameInfo_.aspect = static_cast<float>(codecParams->width) / static_cast<float>(codecParams->height);
+        frameInfo_.framerate = streamFramerate(avStream);
     }
 
-    // Get video stream
-    int videoStream = mediaReader_.findStream(AVMEDIA_TYPE_VIDEO);
-    if (videoStream < 0) {
-        LOG_ERROR << "No video stream found in live source";
-        mediaReader_.close();
-        return false;
+    frameInfo_.format = PixelFormat::RGBA32;
+    frameInfo_.totalFrames = 0;  // Live stream
+    frameInfo_.duration = 0.0;
+
+    ready_ = true;
+    if (formatCtx_ && targetLatencyMs_ > 0) {
+        jitter_.reset();
+        jitter_.setTargetLatency(targetLatencyMs_ / 1000.0);
+        jitter_.setFramePeriod(1.0 / frameInfo_.framerate);
+        reportedDropped_ = 0;
+        reportedRepeated_ = 0;
+        receiving_ = true;
+        receiveThread_ = std::thread(&FFmpegLiveInput::receiveLoop, this);
     }
+    startCaptureThread();  // Start async capture
+    LOG_INFO << "Opened live source: " << source << " (" << frameInfo_.width << "x" << frameInfo_.height << ")";
+    return true;
+}
 
-    // Get codec parameters
-    auto codecParams = mediaReader_.getCodecParameters(videoStream);
-    if (!codecParams) {
-        LOG_ERROR << "Failed to get codec parameters";
-        mediaReader_.close();
+bool FFmpegLiveInput::openLowLatency(const std::string& source) {
+    abort_ = false;
+    formatCtx_ = avformat_alloc_context();
+    if (!formatCtx_) {
+        return false;
+    }
+    formatCtx_->interrupt_callback.callback = &FFmpegLiveInput::interruptCallback;
+    formatCtx_->interrupt_callback.opaque = this;
+
+    // No demuxer-side buffering and a short probe: the first frames are
+    // shown as soon as they decode instead of after analyzeduration
+    AVDictionary* options = nullptr;
+    av_dict_set(&options, "fflags", "nobuffer", 0);
+    av_dict_set(&options, "flags", "low_delay", 0);
+    av_dict_set(&options, "probesize", "32768", 0);
+    av_dict_set(&options, "analyzeduration", "100000", 0);  // 100 ms
+    av_dict_set(&options, "rw_timeout", "5000000", 0);      // Give up on a dead stream after 5 s
+
+    auto inputFormat = format_.empty() ? nullptr : av_find_input_format(format_.c_str());
+    int ret = avformat_open_input(&formatCtx_, source.c_str(), inputFormat, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        LOG_ERROR << "Failed to open live source: " << source << " (" << errbuf << ")";
+        formatCtx_ = nullptr;  // Freed by avformat_open_input
+        return false;
+    }
+    if (avformat_find_stream_info(formatCtx_, nullptr) < 0) {
+        LOG_ERROR << "Failed to read stream info from live source: " << source;
+        closeLowLatency();
         return false;
     }
 
-    // Open video decoder (software only for live streams)
-    if (!videoDecoder_.openCodec(codecParams)) {
+    videoStream_ = av_find_best_stream(formatCtx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    const AVCodec* codec = videoStream_ >= 0
+        ? avcodec_find_decoder(formatCtx_->streams[videoStream_]->codecpar->codec_id) : nullptr;
+    if (!codec) {
+        LOG_ERROR << "No decodable video stream found in live source";
+        closeLowLatency();
+        return false;
+    }
+    // Audio and data packets are not even demuxed
+    for (unsigned int i = 0; i < formatCtx_->nb_streams; ++i) {
+        if (static_cast<int>(i) != videoStream_) {
+            formatCtx_->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+    AVStream* avStream = formatCtx_->streams[videoStream_];
+    timeBase_ = avStream->time_base;
+
+    // Hardware first, software if the hardware decoder refuses to open
+    for (int attempt = hardwareDecode_ ? 0 : 1; attempt < 2 && !codecCtx_; ++attempt) {
+        codecCtx_ = avcodec_alloc_context3(codec);
+        if (!codecCtx_ || avcodec_parameters_to_context(codecCtx_, avStream->codecpar) < 0) {
+            avcodec_free_context(&codecCtx_);
+            break;
+        }
+        codecCtx_->pkt_timebase = avStream->time_base;
+        codecCtx_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        codecCtx_->thread_type = FF_THREAD_SLICE;  // Frame threads add a frame of delay each
+        bool hardware = attempt == 0 && openHardwareDecoder(codecCtx_);
+        if (!hardware) {
+            DecodeThreadBudget& threads = DecodeThreadBudget::instance();
+            threadClient_ = threads.addClient(avStream->codecpar->width, avStream->codecpar->height,
+                                              DecodeThreadBudget::DEFAULT_PRIORITY, true);
+            codecCtx_->thread_count = threads.grant(threadClient_).threads;
+        }
+
+        if (avcodec_open2(codecCtx_, codec, nullptr) < 0) {
+            avcodec_free_context(&codecCtx_);
+            if (threadClient_) {
+                DecodeThreadBudget::instance().removeClient(threadClient_);
+                threadClient_ = 0;
+            }
+            av_buffer_unref(&hwDeviceCtx_);
+            hwPixFmt_ = AV_PIX_FMT_NONE;
+            if (hardware) {
+                LOG_WARNING << "Failed to open hardware decoder for live source, using software";
+            }
+        }
+    }
+    if (!codecCtx_) {
         LOG_ERROR << "Failed to open video decoder for live source";
-        mediaReader_.close();
+        closeLowLatency();
         return false;
     }
 
-    // Get stream for framerate
-    AVStream* avStream = mediaReader_.getStream(videoStream);
-    if (!avStream) {
-        LOG_ERROR << "Failed to get stream";
-        mediaReader_.close();
+    frame_ = av_frame_alloc();
+    swFrame_ = av_frame_alloc();
+    packet_ = av_packet_alloc();
+    if (!frame_ || !swFrame_ || !packet_) {
+        closeLowLatency();
         return false;
     }
 
-    // Get frame info
-    frameInfo_.width = codecParams->width;
-    frameInfo_.height = codecParams->height;
-    frameInfo_.aspect = static_cast<float>(codecParams->width) / static_cast<float>(codecParams->height);
-    
-    // Try to get framerate from stream (r_frame_rate is preferred over avg_frame_rate)
-    double framerate = 0.0;
-    if (avStream->r_frame_rate.den > 0 && avStream->r_frame_rate.num > 0) {
-        framerate = av_q2d(avStream->r_frame_rate);
+    frameInfo_.width = codecCtx_->width;
+    frameInfo_.height = codecCtx_->height;
+    frameInfo_.aspect = codecCtx_->height > 0
+        ? static_cast<float>(codecCtx_->width) / static_cast<float>(codecCtx_->height) : 0.0f;
+    frameInfo_.framerate = streamFramerate(avStream);
+
+    LOG_INFO << "Live source opened with the low-latency profile ("
+             << (hwDeviceCtx_ ? "hardware" : "software") << " decode, "
+             << targetLatencyMs_ << "ms jitter buffer)";
+    return true;
+}
+
+bool FFmpegLiveInput::openHardwareDecoder(AVCodecContext* codecCtx) {
+    AVHWDeviceType deviceType = HardwareDecoder::getFFmpegDeviceType(HardwareDecoder::detectAvailable());
+    if (deviceType == AV_HWDEVICE_TYPE_NONE) {
+        return false;
     }
-    if (framerate <= 0.0 && avStream->avg_frame_rate.den > 0 && avStream->avg_frame_rate.num > 0) {
-        framerate = av_q2d(avStream->avg_frame_rate);
+
+    // Only hwaccels on the regular decoder: wrapper decoders (cuvid, qsv)
+    // queue several frames internally
+    hwPixFmt_ = AV_PIX_FMT_NONE;
+    for (int n = 0; ; n++) {
+        const AVCodecHWConfig* cfg = avcodec_get_hw_config(codecCtx->codec, n);
+        if (!cfg) {
+            break;
+        }
+        if (cfg->device_type == deviceType && (cfg->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX)) {
+            hwPixFmt_ = cfg->pix_fmt;
+            break;
+        }
     }
-    if (framerate <= 0.0) {
-        framerate = 25.0;  // Default
+    if (hwPixFmt_ == AV_PIX_FMT_NONE ||
+        av_hwdevice_ctx_create(&hwDeviceCtx_, deviceType, nullptr, nullptr, 0) < 0) {
+        hwDeviceCtx_ = nullptr;
+        hwPixFmt_ = AV_PIX_FMT_NONE;
+        return false;
+    }
+    codecCtx->hw_device_ctx = av_buffer_ref(hwDeviceCtx_);
+    if (!codecCtx->hw_device_ctx) {
+        av_buffer_unref(&hwDeviceCtx_);
+        hwPixFmt_ = AV_PIX_FMT_NONE;
+        return false;
     }
-    frameInfo_.framerate = framerate;
-
-    frameInfo_.format = PixelFormat::RGBA32;
-    frameInfo_.totalFrames = 0;  // Live stream
-    frameInfo_.duration = 0.0;
 
-    ready_ = true;
-    startCaptureThread();  // Start async capture
-    LOG_INFO << "Opened live source: " << source << " (" << frameInfo_.width << "x" << frameInfo_.height << ")";
+    codecCtx->opaque = this;
+    codecCtx->get_format = [](AVCodecContext* ctx, const AVPixelFormat* pix_fmts) -> AVPixelFormat {
+        auto* self = static_cast<FFmpegLiveInput*>(ctx->opaque);
+        for (const AVPixelFormat* p = pix_fmts; *p != AV_PIX_FMT_NONE; p++) {
+            if (*p == self->hwPixFmt_) {
+                return *p;
+            }
+        }
+        // Surface not offered (unsupported profile): decode this stream in software
+        for (const AVPixelFormat* p = pix_fmts; *p != AV_PIX_FMT_NONE; p++) {
+            const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(*p);
+            if (desc && !(desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+                return *p;
+            }
+        }
+        return AV_PIX_FMT_NONE;
+    };
+    LOG_INFO << "Live source: using " << av_hwdevice_get_type_name(deviceType) << " hardware decoding";
     return true;
 }
 
 void FFmpegLiveInput::close() {
+    // Unblock a network read and the receive thread, then the capture thread
+    abort_ = true;
+    if (receiving_) {
+        {
+            std::lock_guard<std::mutex> lock(jitterMutex_);
+            receiving_ = false;
+        }
+        jitterChanged_.notify_all();
+    }
+    if (receiveThread_.joinable()) {
+        receiveThread_.join();
+    }
     stopCaptureThread();  // Stop async capture first
 
+    closeLowLatency();
     videoDecoder_.close();
     mediaReader_.close();
+    scaler_.reset();
+    jitter_.reset();
+    setSourceBufferedFrames(0);
     ready_ = false;
     frameCount_ = 0;
 }
 
+void FFmpegLiveInput::closeLowLatency() {
+    av_packet_free(&packet_);
+    av_frame_free(&swFrame_);
+    av_frame_free(&frame_);
+    avcodec_free_context(&codecCtx_);
+    if (threadClient_) {
+        DecodeThreadBudget::instance().removeClient(threadClient_);
+        threadClient_ = 0;
+    }
+    av_buffer_unref(&hwDeviceCtx_);
+    hwPixFmt_ = AV_PIX_FMT_NONE;
+    if (formatCtx_) {
+        avformat_close_input(&formatCtx_);
+    }
+    videoStream_ = -1;
+}
+
+int FFmpegLiveInput::interruptCallback(void* opaque) {
+    return static_cast<FFmpegLiveInput*>(opaque)->abort_.load() ? 1 : 0;
+}
+
 bool FFmpegLiveInput::isReady() const {
+    if (formatCtx_) {
+        return ready_ && codecCtx_ != nullptr;
+    }
     return ready_ && mediaReader_.isReady() && videoDecoder_.isReady();
 }
 
@@ -114,7 +361,7 @@ int64_t FFmpegLiveInput::getCurrentFrame() const {
 }
 
 InputSource::CodecType FFmpegLiveInput::detectCodec() const {
-    return CodecType::SOFTWARE;  // Live streams via FFmpeg are software-decoded
+    return CodecType::SOFTWARE;  // Frames reach the layer as CPU RGBA even when decoded on the GPU
 }
 
 InputSource::DecodeBackend FFmpegLiveInput::getOptimalBackend() const {
@@ -126,6 +373,19 @@ bool FFmpegLiveInput::captureFrame(FrameBuffer& buffer) {
         return false;
     }
 
+    if (formatCtx_) {
+        if (receiving_) {
+            return releaseBufferedFrame(buffer);
+        }
+        double pts = 0.0;
+        std::chrono::steady_clock::time_point received;
+        if (!decodeLowLatency(buffer, pts, received)) {
+            return false;
+        }
+        setFrameReceiveTime(received);
+        return true;
+    }
+
     // Read packet
     AVPacket* packet = av_packet_alloc();
     if (!packet) {
@@ -158,38 +418,135 @@ bool FFmpegLiveInput::captureFrame(FrameBuffer& buffer) {
         return false;  // No frame available yet
     }
 
+    bool converted = convertFrame(frame, buffer);
+    av_frame_free(&frame);
+    return converted;
+}
+
+bool FFmpegLiveInput::decodeLowLatency(FrameBuffer& buffer, double& pts,
+                                       std::chrono::steady_clock::time_point& received) {
+    // A packet can hold several frames, and a frame can need several packets
+    int ret = avcodec_receive_frame(codecCtx_, frame_);
+    while (ret == AVERROR(EAGAIN) && !abort_) {
+        ret = av_read_frame(formatCtx_, packet_);
+        if (ret < 0) {
+            return false;  // End of stream, network error or close()
+        }
+        lastPacketTime_ = std::chrono::steady_clock::now();
+        if (packet_->stream_index == videoStream_) {
+            ret = avcodec_send_packet(codecCtx_, packet_);
+        }
+        av_packet_unref(packet_);
+        if (ret < 0 && ret != AVERROR(EAGAIN)) {
+            return false;  // Corrupt packet; the next keyframe recovers
+        }
+        ret = avcodec_receive_frame(codecCtx_, frame_);
+    }
+    if (ret < 0) {
+        return false;
+    }
+    received = lastPacketTime_;  // Arrival of the packet that completed the frame
+
+    int64_t timestamp = frame_->best_effort_timestamp;
+    pts = timestamp != AV_NOPTS_VALUE ? timestamp * av_q2d(timeBase_) : steadySeconds(received);
+
+    AVFrame* frame = frame_;
+    if (hwPixFmt_ != AV_PIX_FMT_NONE && frame_->format == hwPixFmt_) {
+        av_frame_unref(swFrame_);
+        if (av_hwframe_transfer_data(swFrame_, frame_, 0) < 0) {
+            av_frame_unref(frame_);
+            return false;
+        }
+        frame = swFrame_;
+    }
+    bool converted = convertFrame(frame, buffer);
+    av_frame_unref(frame_);
+    return converted;
+}
+
+bool FFmpegLiveInput::convertFrame(AVFrame* frame, FrameBuffer& buffer) {
     // Convert frame to RGBA
     FrameInfo info;
     info.width = frame->width;
     info.height = frame->height;
     info.aspect = static_cast<float>(frame->width) / static_cast<float>(frame->height);
+    info.framerate = frameInfo_.framerate;
     info.format = PixelFormat::RGBA32;
 
-    if (!buffer.allocate(info)) {
-        av_frame_free(&frame);
+    if (!buffer.ensureAllocated(info)) {
         return false;
     }
 
-    // Convert frame format to RGBA (using swscale)
-    SwsContext* swsCtx = sws_getContext(
-        frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
-        frame->width, frame->height, AV_PIX_FMT_RGBA,
-        SWS_BILINEAR, nullptr, nullptr, nullptr);
+    // Convert frame format to RGBA (using swscale in slices, contexts reused while the size stays)
+    uint8_t* dstData[4] = { buffer.data(), nullptr, nullptr, nullptr };
+    // RGBA = 4 bytes per pixel
+    int dstLinesize[4] = { frame->width * 4, 0, 0, 0 };
+    if (!scaler_.scale(frame->data, frame->linesize, frame->width, frame->height,
+                       static_cast<AVPixelFormat>(frame->format), dstData, dstLinesize,
+                       frame->width, frame->height, AV_PIX_FMT_RGBA, SWS_BILINEAR)) {
+        return false;
+    }
+    frameCount_++;
+    return true;
+}
 
-    if (swsCtx) {
-        uint8_t* dstData[1] = { buffer.data() };
-        // RGBA = 4 bytes per pixel
-        int dstLinesize[1] = { frame->width * 4 };
-        sws_scale(swsCtx, frame->data, frame->linesize, 0, frame->height, dstData, dstLinesize);
-        sws_freeContext(swsCtx);
-        frameCount_++;
-        av_frame_free(&frame);
-        return true;
+void FFmpegLiveInput::receiveLoop() {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
+    FrameBuffer decoded;
+    while (receiving_) {
+        double pts = 0.0;
+        std::chrono::steady_clock::time_point received;
+        if (!decodeLowLatency(decoded, pts, received)) {
+            if (receiving_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));  // Stream stalled or broken
+            }
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(jitterMutex_);
+            jitter_.push(pts, steadySeconds(received), decoded);
+            reportJitterStatistics();
+        }
+        jitterChanged_.notify_one();
     }
+}
 
-    av_frame_free(&frame);
+bool FFmpegLiveInput::releaseBufferedFrame(FrameBuffer& buffer) {
+    std::unique_lock<std::mutex> lock(jitterMutex_);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (receiving_) {
+        auto now = std::chrono::steady_clock::now();
+        double received = 0.0;
+        bool released = jitter_.pop(steadySeconds(now), buffer, &received);
+        reportJitterStatistics();
+        if (released) {
+            setFrameReceiveTime(steadyTime(received));
+            return true;
+        }
+        if (now >= deadline) {
+            return false;  // Nothing arrived
+        }
+
+        // Sleep until the next frame is due or a new one arrives
+        double due = jitter_.nextDueTime();
+        auto wakeAt = due >= 0.0 ? std::min(deadline, steadyTime(due)) : deadline;
+        jitterChanged_.wait_until(lock, wakeAt);
+    }
     return false;
 }
 
-} // namespace videocomposer
+void FFmpegLiveInput::reportJitterStatistics() {
+    setSourceBufferedFrames(static_cast<int>(jitter_.depth()));
+    uint64_t dropped = jitter_.droppedFrames();
+    if (dropped > reportedDropped_) {
+        addDroppedFrames(dropped - reportedDropped_);
+        reportedDropped_ = dropped;
+    }
+    uint64_t repeated = jitter_.repeatedFrames();
+    if (repeated > reportedRepeated_) {
+        addRepeatedFrames(repeated - reportedRepeated_);
+        reportedRepeated_ = repeated;
+    }
+}
 
+} // namespace videocomposer
@@ -2,17 +2,38 @@
 #define VIDEOCOMPOSER_FFMPEGLIVEINPUT_H
 
 #include "LiveInputSource.h"
+#include "LiveJitterBuffer.h"
+#include "DecodeThreadBudget.h"
+#include "../video/SliceScaler.h"
 #include <cuems_mediadecoder/MediaFileReader.h>
 #include <cuems_mediadecoder/VideoDecoder.h>
 #include <string>
+#include <thread>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVBufferRef;
+struct AVFrame;
+struct AVPacket;
 
 namespace videocomposer {
 
 /**
  * FFmpegLiveInput - Live input via FFmpeg (V4L2, RTSP, etc.)
- * 
+ *
  * Stopgap implementation using FFmpeg for live sources.
  * Later can be replaced with dedicated V4L2Input if needed.
+ *
+ * Low-latency profile (network streams): the demuxer is opened without
+ * buffering and with a short probe, the decoder runs with low_delay and
+ * slice threads only (frame threads hold frames back), hardware decoding
+ * is used when available, and a LiveJitterBuffer paces frames to the
+ * target latency from a separate receive thread.
  */
 class FFmpegLiveInput : public LiveInputSource {
 public:
@@ -32,21 +53,79 @@ public:
     // Set FFmpeg format (e.g., "v4l2", "rtsp")
     void setFormat(const std::string& format) { format_ = format; }
 
+    // Settings below apply to the next open()
+
+    /** Low-latency demux and decode profile (see class comment) */
+    void setLowLatency(bool enabled) { lowLatency_ = enabled; }
+
+    /**
+     * Jitter buffer target in the low-latency profile
+     * @param ms Milliseconds; 0 passes frames on as soon as they decode
+     */
+    void setTargetLatency(int ms) { targetLatencyMs_ = ms > 0 ? ms : 0; }
+
+    /** Decode on the GPU in the low-latency profile when a decoder is available */
+    void setHardwareDecode(bool enabled) { hardwareDecode_ = enabled; }
+
+    /** rtsp://, rtmp://, srt://, udp://, rtp://, tcp:// and http(s):// sources */
+    static bool isNetworkUrl(const std::string& source);
+
 protected:
     // LiveInputSource interface
     bool captureFrame(FrameBuffer& buffer) override;
     const char* getSourceTypeName() const override { return format_.empty() ? "FFmpegLive" : format_.c_str(); }
 
 private:
+    bool openLowLatency(const std::string& source);
+    bool openHardwareDecoder(AVCodecContext* codecCtx);
+    void closeLowLatency();
+
+    // Decode the next frame (low-latency profile); false when a packet gave no frame
+    bool decodeLowLatency(FrameBuffer& buffer, double& pts, std::chrono::steady_clock::time_point& received);
+    bool convertFrame(AVFrame* frame, FrameBuffer& buffer);
+
+    // Jitter buffer: receiveLoop() decodes into it, captureFrame() releases on time
+    void receiveLoop();
+    bool releaseBufferedFrame(FrameBuffer& buffer);
+    void reportJitterStatistics();  // jitterMutex_ held
+
+    static int interruptCallback(void* opaque);
+
     cuems_mediadecoder::MediaFileReader mediaReader_;
     cuems_mediadecoder::VideoDecoder videoDecoder_;
     FrameInfo frameInfo_;
     std::string format_;
     bool ready_;
     std::atomic<int64_t> frameCount_;
+    SliceScaler scaler_;  // Contexts kept between frames of the same size
+
+    // Low-latency profile
+    bool lowLatency_ = false;
+    int targetLatencyMs_ = 100;
+    bool hardwareDecode_ = true;
+    AVFormatContext* formatCtx_ = nullptr;
+    AVCodecContext* codecCtx_ = nullptr;
+    DecodeThreadBudget::ClientId threadClient_ = 0;  // Software decode only
+    AVBufferRef* hwDeviceCtx_ = nullptr;
+    AVPixelFormat hwPixFmt_ = AV_PIX_FMT_NONE;
+    AVFrame* frame_ = nullptr;
+    AVFrame* swFrame_ = nullptr;
+    AVPacket* packet_ = nullptr;
+    int videoStream_ = -1;
+    AVRational timeBase_ = {0, 1};
+    std::chrono::steady_clock::time_point lastPacketTime_;
+    std::atomic<bool> abort_;       // Interrupts blocking network reads
+
+    // Jitter buffer (only when targetLatencyMs_ > 0)
+    LiveJitterBuffer jitter_;
+    std::thread receiveThread_;
+    std::atomic<bool> receiving_;
+    std::mutex jitterMutex_;
+    std::condition_variable jitterChanged_;
+    uint64_t reportedDropped_ = 0;  // jitterMutex_
+    uint64_t reportedRepeated_ = 0;
 };
 
 } // namespace videocomposer
 
 #endif // VIDEOCOMPOSER_FFMPEGLIVEINPUT_H
-
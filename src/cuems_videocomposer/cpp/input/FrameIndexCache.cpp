@@ -0,0 +1,423 @@
+/**
+ * FrameIndexCache.cpp - Persistent on-disk cache for frame indexes
+ */
+
+#include "FrameIndexCache.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'C', 'V', 'C', 'I', 'D', 'X', '\0', '\0'};
+constexpr char PROBE_MAGIC[8] = {'C', 'V', 'C', 'P', 'R', 'B', '\0', '\0'};
+constexpr size_t HASH_SAMPLE_BYTES = 64 * 1024;  // Hashed from start and end of file
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t fileSize;
+    int64_t fileMtimeNs;
+    uint64_t contentHash;
+    int64_t frameCount;
+    int64_t totalFrames;
+    uint8_t byteSeek;
+    uint8_t reserved[7];
+};
+
+struct ProbeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t fieldCount;
+    uint64_t fileSize;
+    int64_t fileMtimeNs;
+    uint64_t contentHash;
+    uint32_t nameLength;
+    uint32_t extradataLength;
+};
+
+constexpr size_t MAX_PROBE_STRING = 256;
+constexpr size_t MAX_PROBE_EXTRADATA = 16 * 1024 * 1024;
+
+/** The numeric probe fields in file order */
+template <typename ProbeT, typename Fn>
+void forEachProbeField(ProbeT& p, Fn fn) {
+    fn(p.streamIndex); fn(p.codecId); fn(p.codecTag); fn(p.pixelFormat);
+    fn(p.width); fn(p.height); fn(p.profile); fn(p.level); fn(p.fieldOrder);
+    fn(p.colorRange); fn(p.colorPrimaries); fn(p.colorTrc); fn(p.colorSpace);
+    fn(p.chromaLocation); fn(p.bitsPerRawSample); fn(p.bitRate);
+    fn(p.sampleAspect[0]); fn(p.sampleAspect[1]); fn(p.timeBase[0]); fn(p.timeBase[1]);
+    fn(p.frameRate[0]); fn(p.frameRate[1]); fn(p.avgFrameRate[0]); fn(p.avgFrameRate[1]);
+    fn(p.startTime); fn(p.duration); fn(p.frames);
+    fn(p.formatStartTime); fn(p.formatDuration); fn(p.formatBitRate);
+}
+
+uint32_t probeFieldCount() {
+    FrameIndexCache::Probe probe;
+    uint32_t count = 0;
+    forEachProbeField(probe, [&count](int64_t&) { ++count; });
+    return count;
+}
+
+uint64_t fnv1a(const uint8_t* data, size_t len, uint64_t hash = 1469598103934665603ULL) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool readFully(int fd, uint8_t* buf, size_t len, off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, buf + done, len - done, offset + static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeAtomically(const std::string& path, const std::vector<uint8_t>& data) {
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = writeFully(fd, data.data(), data.size());
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+FrameIndexCache::FrameIndexCache(const std::string& cacheDir)
+    : cacheDir_(cacheDir.empty() ? defaultCacheDir() : cacheDir)
+{
+}
+
+std::string FrameIndexCache::defaultCacheDir() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/cuems-videocomposer/index";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) {
+        return std::string(home) + "/.cache/cuems-videocomposer/index";
+    }
+    return "/tmp/cuems-videocomposer/index";
+}
+
+std::string FrameIndexCache::cachePathFor(const std::string& mediaPath) const {
+    // Key the cache by canonical path so different spellings share one entry
+    char resolved[PATH_MAX];
+    std::string key = realpath(mediaPath.c_str(), resolved) ? std::string(resolved) : mediaPath;
+
+    uint64_t hash = fnv1a(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cvidx", static_cast<unsigned long long>(hash));
+    return cacheDir_ + "/" + name;
+}
+
+std::string FrameIndexCache::probePathFor(const std::string& mediaPath) const {
+    std::string path = cachePathFor(mediaPath);
+    return path.substr(0, path.size() - 6) + ".cvprb";
+}
+
+bool FrameIndexCache::identify(const std::string& mediaPath, FileIdentity& id) {
+    int fd = ::open(mediaPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    id.size = static_cast<uint64_t>(st.st_size);
+    id.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+
+    // Sample start and end of the file: catches in-place rewrites that keep
+    // size and mtime (e.g. copies with preserved timestamps) without reading it all
+    std::vector<uint8_t> sample(HASH_SAMPLE_BYTES);
+    size_t headLen = static_cast<size_t>(std::min<uint64_t>(id.size, HASH_SAMPLE_BYTES));
+    uint64_t hash = fnv1a(reinterpret_cast<const uint8_t*>(&id.size), sizeof(id.size));
+    bool ok = readFully(fd, sample.data(), headLen, 0);
+    if (ok) {
+        hash = fnv1a(sample.data(), headLen, hash);
+        if (id.size > HASH_SAMPLE_BYTES) {
+            size_t tailLen = static_cast<size_t>(std::min<uint64_t>(id.size - HASH_SAMPLE_BYTES, HASH_SAMPLE_BYTES));
+            ok = readFully(fd, sample.data(), tailLen, static_cast<off_t>(id.size - tailLen));
+            if (ok) {
+                hash = fnv1a(sample.data(), tailLen, hash);
+            }
+        }
+    }
+    ::close(fd);
+
+    id.contentHash = hash;
+    return ok;
+}
+
+bool FrameIndexCache::createDirectories(const std::string& path) {
+    std::string partial;
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        partial = path.substr(0, pos);
+        if (partial.empty()) continue;
+        if (mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FrameIndexCache::load(const std::string& mediaPath, Entry*& entries, Metadata& meta) const {
+    FileIdentity id;
+    if (!identify(mediaPath, id)) {
+        return false;
+    }
+
+    std::string cachePath = cachePathFor(mediaPath);
+    int fd = ::open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;  // Plain miss
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t mappedSize = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const CacheHeader* header = static_cast<const CacheHeader*>(mapped);
+    const char* reason = nullptr;
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        reason = "bad magic";
+    } else if (header->version != FORMAT_VERSION || header->entrySize != sizeof(Entry)) {
+        reason = "format version mismatch";
+    } else if (header->fileSize != id.size || header->fileMtimeNs != id.mtimeNs ||
+               header->contentHash != id.contentHash) {
+        reason = "media file changed";
+    } else if (header->frameCount <= 0 ||
+               mappedSize != sizeof(CacheHeader) + static_cast<size_t>(header->frameCount) * sizeof(Entry)) {
+        reason = "truncated";
+    }
+
+    if (reason) {
+        LOG_INFO << "Frame index cache stale for " << mediaPath << " (" << reason << ")";
+        munmap(mapped, mappedSize);
+        return false;
+    }
+
+    size_t entryBytes = static_cast<size_t>(header->frameCount) * sizeof(Entry);
+    Entry* index = static_cast<Entry*>(malloc(entryBytes));
+    if (!index) {
+        munmap(mapped, mappedSize);
+        return false;
+    }
+    memcpy(index, static_cast<const uint8_t*>(mapped) + sizeof(CacheHeader), entryBytes);
+    entries = index;
+    meta.frameCount = header->frameCount;
+    meta.totalFrames = header->totalFrames;
+    meta.byteSeek = header->byteSeek != 0;
+
+    munmap(mapped, mappedSize);
+    return true;
+}
+
+bool FrameIndexCache::store(const std::string& mediaPath, const Entry* entries, const Metadata& meta) const {
+    if (!entries || meta.frameCount <= 0) {
+        return false;
+    }
+
+    FileIdentity id;
+    if (!identify(mediaPath, id)) {
+        return false;
+    }
+
+    if (!createDirectories(cacheDir_)) {
+        LOG_WARNING << "Frame index cache: cannot create " << cacheDir_ << ": " << strerror(errno);
+        return false;
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.entrySize = sizeof(Entry);
+    header.fileSize = id.size;
+    header.fileMtimeNs = id.mtimeNs;
+    header.contentHash = id.contentHash;
+    header.frameCount = meta.frameCount;
+    header.totalFrames = meta.totalFrames;
+    header.byteSeek = meta.byteSeek ? 1 : 0;
+
+    // Write to a temp file and rename, so readers never see a partial index
+    std::string cachePath = cachePathFor(mediaPath);
+    std::string tmpPath = cachePath + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_WARNING << "Frame index cache: cannot write " << tmpPath << ": " << strerror(errno);
+        return false;
+    }
+
+    bool ok = writeFully(fd, &header, sizeof(header)) &&
+              writeFully(fd, entries, static_cast<size_t>(meta.frameCount) * sizeof(Entry));
+    ok = (::close(fd) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+        LOG_WARNING << "Frame index cache: failed to store index for " << mediaPath;
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    LOG_VERBOSE << "Frame index cache: stored " << meta.frameCount << " entries in " << cachePath;
+    return true;
+}
+
+bool FrameIndexCache::loadProbe(const std::string& mediaPath, Probe& probe) const {
+    FileIdentity id;
+    if (!identify(mediaPath, id)) {
+        return false;
+    }
+
+    std::string probePath = probePathFor(mediaPath);
+    int fd = ::open(probePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    ProbeHeader header;
+    struct stat st;
+    const char* reason = nullptr;
+    uint32_t fieldCount = probeFieldCount();
+    if (fstat(fd, &st) != 0 || !readFully(fd, reinterpret_cast<uint8_t*>(&header), sizeof(header), 0)) {
+        reason = "truncated";
+    } else if (memcmp(header.magic, PROBE_MAGIC, sizeof(PROBE_MAGIC)) != 0) {
+        reason = "bad magic";
+    } else if (header.version != PROBE_VERSION || header.fieldCount != fieldCount) {
+        reason = "format version mismatch";
+    } else if (header.fileSize != id.size || header.fileMtimeNs != id.mtimeNs ||
+               header.contentHash != id.contentHash) {
+        reason = "media file changed";
+    } else if (header.nameLength > MAX_PROBE_STRING || header.extradataLength > MAX_PROBE_EXTRADATA ||
+               static_cast<size_t>(st.st_size) != sizeof(header) + fieldCount * sizeof(int64_t) +
+                                                  header.nameLength + header.extradataLength) {
+        reason = "truncated";
+    }
+
+    std::vector<uint8_t> body;
+    if (!reason) {
+        body.resize(static_cast<size_t>(st.st_size) - sizeof(header));
+        if (!readFully(fd, body.data(), body.size(), sizeof(header))) {
+            reason = "truncated";
+        }
+    }
+    ::close(fd);
+
+    if (reason) {
+        LOG_INFO << "Probe cache stale for " << mediaPath << " (" << reason << ")";
+        return false;
+    }
+
+    const uint8_t* p = body.data();
+    forEachProbeField(probe, [&p](int64_t& field) {
+        memcpy(&field, p, sizeof(field));
+        p += sizeof(field);
+    });
+    probe.formatName.assign(reinterpret_cast<const char*>(p), header.nameLength);
+    p += header.nameLength;
+    probe.extradata.assign(p, p + header.extradataLength);
+    return true;
+}
+
+bool FrameIndexCache::storeProbe(const std::string& mediaPath, const Probe& probe) const {
+    if (probe.formatName.empty() || probe.formatName.size() > MAX_PROBE_STRING ||
+        probe.extradata.size() > MAX_PROBE_EXTRADATA) {
+        return false;
+    }
+
+    FileIdentity id;
+    if (!identify(mediaPath, id)) {
+        return false;
+    }
+
+    if (!createDirectories(cacheDir_)) {
+        LOG_WARNING << "Frame index cache: cannot create " << cacheDir_ << ": " << strerror(errno);
+        return false;
+    }
+
+    ProbeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PROBE_MAGIC, sizeof(PROBE_MAGIC));
+    header.version = PROBE_VERSION;
+    header.fieldCount = probeFieldCount();
+    header.fileSize = id.size;
+    header.fileMtimeNs = id.mtimeNs;
+    header.contentHash = id.contentHash;
+    header.nameLength = static_cast<uint32_t>(probe.formatName.size());
+    header.extradataLength = static_cast<uint32_t>(probe.extradata.size());
+
+    std::vector<uint8_t> data(reinterpret_cast<const uint8_t*>(&header),
+                              reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+    forEachProbeField(probe, [&data](const int64_t& field) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&field);
+        data.insert(data.end(), bytes, bytes + sizeof(field));
+    });
+    data.insert(data.end(), probe.formatName.begin(), probe.formatName.end());
+    data.insert(data.end(), probe.extradata.begin(), probe.extradata.end());
+
+    std::string probePath = probePathFor(mediaPath);
+    if (!writeAtomically(probePath, data)) {
+        LOG_WARNING << "Frame index cache: failed to store probe for " << mediaPath;
+        return false;
+    }
+
+    LOG_VERBOSE << "Frame index cache: stored probe in " << probePath;
+    return true;
+}
+
+void FrameIndexCache::invalidate(const std::string& mediaPath) const {
+    unlink(cachePathFor(mediaPath).c_str());
+    unlink(probePathFor(mediaPath).c_str());
+}
+
+} // namespace videocomposer
@@ -0,0 +1,165 @@
+#ifndef VIDEOCOMPOSER_FRAMEINDEXCACHE_H
+#define VIDEOCOMPOSER_FRAMEINDEXCACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * FrameIndexCache - Persistent on-disk cache for VideoFileInput frame indexes
+ *
+ * Building the xjadeo-style frame index means reading every packet of the
+ * file (and decoding one frame per keyframe). For long shows this costs
+ * seconds per cue load, so the finished index is stored in a cache directory
+ * and memory-mapped back on the next open.
+ *
+ * Cache file layout (native endianness, one file per media file):
+ *   Header  - magic, format version, entry size, source file identity
+ *             (size, mtime, sampled content hash) and index metadata
+ *   Entry[] - frameCount index entries
+ *
+ * An entry is only used if the format version, entry size and the media
+ * file's size, mtime and content hash all match; otherwise the caller runs
+ * the full scan and stores a fresh index.
+ *
+ * Next to the index a probe file keeps what avformat_find_stream_info
+ * found out about the video stream (see MediaProbe), under the same rules.
+ */
+class FrameIndexCache {
+public:
+    /**
+     * On-disk index entry (layout matches VideoFileInput::FrameIndex)
+     */
+    struct Entry {
+        int64_t pkt_pts;
+        int64_t pkt_pos;
+        int64_t frame_pts;
+        int64_t frame_pos;
+        int64_t timestamp;
+        int64_t seekpts;
+        int64_t seekpos;
+        uint8_t key;
+    };
+
+    /**
+     * Index-wide values stored alongside the entries
+     */
+    struct Metadata {
+        int64_t frameCount = 0;
+        int64_t totalFrames = 0;
+        bool byteSeek = false;
+    };
+
+    /**
+     * Demuxer probe of the video stream: container, codec parameters,
+     * extradata, rates and timing (FFmpeg enums and rationals as numbers)
+     */
+    struct Probe {
+        std::string formatName;         // AVInputFormat name
+        int64_t streamIndex = -1;
+        int64_t codecId = 0;
+        int64_t codecTag = 0;
+        int64_t pixelFormat = -1;
+        int64_t width = 0;
+        int64_t height = 0;
+        int64_t profile = -99;
+        int64_t level = -99;
+        int64_t fieldOrder = 0;
+        int64_t colorRange = 0;
+        int64_t colorPrimaries = 2;     // Unspecified
+        int64_t colorTrc = 2;
+        int64_t colorSpace = 2;
+        int64_t chromaLocation = 0;
+        int64_t bitsPerRawSample = 0;
+        int64_t bitRate = 0;
+        int64_t sampleAspect[2] = {0, 1};
+        int64_t timeBase[2] = {0, 1};
+        int64_t frameRate[2] = {0, 1};      // r_frame_rate
+        int64_t avgFrameRate[2] = {0, 1};
+        int64_t startTime = INT64_MIN;      // Stream time base, INT64_MIN = unknown
+        int64_t duration = INT64_MIN;
+        int64_t frames = 0;
+        int64_t formatStartTime = INT64_MIN;  // AV_TIME_BASE units
+        int64_t formatDuration = INT64_MIN;
+        int64_t formatBitRate = 0;
+        std::vector<uint8_t> extradata;
+    };
+
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr uint32_t PROBE_VERSION = 1;
+
+    /**
+     * @param cacheDir Directory for cache files (empty = defaultCacheDir())
+     */
+    explicit FrameIndexCache(const std::string& cacheDir = std::string());
+
+    /**
+     * Default cache directory: $XDG_CACHE_HOME/cuems-videocomposer/index,
+     * falling back to ~/.cache/cuems-videocomposer/index
+     */
+    static std::string defaultCacheDir();
+
+    /**
+     * Load a cached index for a media file
+     * The header is checked in the mapped file, then the entries are copied
+     * once, straight from the mapping.
+     * @param mediaPath Path to the media file
+     * @param entries Receives meta.frameCount entries on success, malloc'd
+     *                (owned by the caller, released with free())
+     * @param meta Receives the index metadata on success
+     * @return true on a valid cache hit, false on miss or stale cache
+     */
+    bool load(const std::string& mediaPath, Entry*& entries, Metadata& meta) const;
+
+    /**
+     * Store an index for a media file (written atomically via rename)
+     * @param mediaPath Path to the media file
+     * @param entries Index entries (meta.frameCount entries)
+     * @param meta Index metadata
+     * @return true on success
+     */
+    bool store(const std::string& mediaPath, const Entry* entries, const Metadata& meta) const;
+
+    /**
+     * Load the cached probe of a media file
+     * @return true on a valid hit for the file as it is now
+     */
+    bool loadProbe(const std::string& mediaPath, Probe& probe) const;
+
+    /**
+     * Store the probe of a media file (written atomically via rename)
+     */
+    bool storeProbe(const std::string& mediaPath, const Probe& probe) const;
+
+    /**
+     * Remove the cached index and probe for a media file (if any)
+     */
+    void invalidate(const std::string& mediaPath) const;
+
+    /**
+     * Get the cache file path used for a media file
+     */
+    std::string cachePathFor(const std::string& mediaPath) const;
+    std::string probePathFor(const std::string& mediaPath) const;
+
+    const std::string& getCacheDir() const { return cacheDir_; }
+
+private:
+    struct FileIdentity {
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+        uint64_t contentHash = 0;
+    };
+
+    static bool identify(const std::string& mediaPath, FileIdentity& id);
+    static bool createDirectories(const std::string& path);
+
+    std::string cacheDir_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMEINDEXCACHE_H
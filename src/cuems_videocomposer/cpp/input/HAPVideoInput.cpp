@@ -23,6 +23,12 @@
 #ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
 #define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
 #endif
+#ifndef GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+#define GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT 0x8E8E
+#endif
+#ifndef GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+#define GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT 0x8E8F
+#endif
 
 extern "C" {
 #include <libavutil/avutil.h>
@@ -46,8 +52,13 @@ HAPVideoInput::HAPVideoInput()
     , currentFrame_(-1)
     , hapVariant_(HAPVariant::HAP)
     , ready_(false)
+    , preload_(false)
 #ifdef ENABLE_HAP_DIRECT
+    , directDecode_(true)
     , fallbackWarningShown_(false)
+    , bptcWarningShown_(false)
+    , decodeDeadline_(HapChunkPool::Clock::time_point::max())
+    , lastMappedFrame_(-1)
 #endif
 {
     frameRateQ_ = {1, 1};
@@ -79,8 +90,13 @@ bool HAPVideoInput::open(const std::string& source) {
         return false;
     }
 
+    if (preload_) {
+        ramClip_ = RamClipCache::instance().acquire(source);
+    }
+    const std::string& readPath = ramClip_ ? ramClip_->path() : source;
+
     // Open video file using MediaFileReader
-    if (!mediaReader_.open(source)) {
+    if (!mediaReader_.open(readPath)) {
         return false;
     }
 
@@ -174,6 +190,8 @@ bool HAPVideoInput::open(const std::string& source) {
     frameInfo_.height = height;
     frameInfo_.aspect = (float)width / (float)height;
     frameInfo_.framerate = framerate;
+    frameInfo_.framerateNum = framerate > 0.0 ? avStream->r_frame_rate.num : 0;
+    frameInfo_.framerateDen = framerate > 0.0 ? avStream->r_frame_rate.den : 1;
     frameInfo_.duration = duration;
     // HAP uses compressed texture format, not traditional pixel format
     frameInfo_.format = PixelFormat::BGRA32; // Placeholder
@@ -188,6 +206,13 @@ bool HAPVideoInput::open(const std::string& source) {
     // This makes file opening instant instead of scanning the entire file
     frameCount_ = frameInfo_.totalFrames;
     scanComplete_ = true;
+
+#ifdef ENABLE_HAP_DIRECT
+    // Index the MOV sample table so packets are read straight from a mapping
+    if (sampleTable_.open(readPath)) {
+        LOG_INFO << "HAP: Memory-mapped packet access (" << sampleTable_.getSampleCount() << " samples)";
+    }
+#endif
     LOG_INFO << "HAP: Ready for playback (" << frameCount_ << " frames, no indexing needed - all keyframes)";
 
     ready_ = true;
@@ -196,6 +221,7 @@ bool HAPVideoInput::open(const std::string& source) {
 
 void HAPVideoInput::close() {
     cleanup();
+    ramClip_.reset();
     ready_ = false;
     currentFile_.clear();
     currentFrame_ = -1;
@@ -359,12 +385,9 @@ bool HAPVideoInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
     // If same frame is requested and we have valid decoded data, just copy from frame_
     if (currentFrame_ == frameNumber && frame_ && frame_->data[0]) {
         // Same frame requested - just copy existing data
-        if (!buffer.isValid() || buffer.info().width != frameInfo_.width ||
-            buffer.info().height != frameInfo_.height) {
-            FrameInfo outputInfo = frameInfo_;
-            outputInfo.format = PixelFormat::RGBA32;
-            buffer.allocate(outputInfo);
-        }
+        FrameInfo outputInfo = frameInfo_;
+        outputInfo.format = PixelFormat::RGBA32;
+        buffer.ensureAllocated(outputInfo);
         
         // Copy from decoded frame (HAP decodes to RGBA, linesize may have padding)
         int srcLinesize = frame_->linesize[0];
@@ -501,30 +524,39 @@ bool HAPVideoInput::readFrameToTexture(int64_t frameNumber, GPUTextureFrameBuffe
     }
 
 #ifdef ENABLE_HAP_DIRECT
-    // Try direct HAP decode first (optimal path)
-    AVPacket* packet = av_packet_alloc();
-    if (!packet) {
-        return false;
-    }
-
-    if (readRawPacket(frameNumber, packet)) {
-        bool success = decodeHapDirectToTexture(packet, textureBuffer);
-        av_packet_free(&packet);
-        
-        if (success) {
-            currentFrame_ = frameNumber;
+    // Direct decode off: FFmpeg only (benchmarks)
+    if (directDecode_) {
+        // Mapped packets: any frame is a pointer lookup, no seek or demuxer state
+        if (sampleTable_.isOpen() && readMappedFrameToTexture(frameNumber, textureBuffer)) {
             return true;
         }
-        
-        // Log fallback warning (once per file)
-        if (!fallbackWarningShown_) {
-            LOG_WARNING << "HAP direct decode failed for frame " << frameNumber 
-                       << ", falling back to FFmpeg RGBA path (reduced performance)";
-            LOG_WARNING << "Error: " << hapDecoder_.getLastError();
-            fallbackWarningShown_ = true;
+
+        // Try direct HAP decode first (optimal path)
+        AVPacket* packet = av_packet_alloc();
+        if (!packet) {
+            return false;
+        }
+
+        if (readRawPacket(frameNumber, packet)) {
+            bool success = packet->size > 0 &&
+                           decodeHapDirectToTexture(packet->data, static_cast<size_t>(packet->size), textureBuffer);
+            av_packet_free(&packet);
+            
+            if (success) {
+                currentFrame_ = frameNumber;
+                return true;
+            }
+            
+            // Log fallback warning (once per file)
+            if (!fallbackWarningShown_) {
+                LOG_WARNING << "HAP direct decode failed for frame " << frameNumber 
+                           << ", falling back to FFmpeg RGBA path (reduced performance)";
+                LOG_WARNING << "Error: " << hapDecoder_.getLastError();
+                fallbackWarningShown_ = true;
+            }
+        } else {
+            av_packet_free(&packet);
         }
-    } else {
-        av_packet_free(&packet);
     }
 #endif
 
@@ -591,6 +623,16 @@ int64_t HAPVideoInput::getCurrentFrame() const {
     return currentFrame_;
 }
 
+bool HAPVideoInput::hasAlpha() const {
+    if (!codecCtx_) {
+        return true;
+    }
+    // The FourCC is reliable where the variant is only known after decoding:
+    // Hap1 (DXT1) and HapY (scaled YCoCg DXT5) carry no alpha
+    uint32_t tag = codecCtx_->codec_tag;
+    return tag != MKTAG('H', 'a', 'p', '1') && tag != MKTAG('H', 'a', 'p', 'Y');
+}
+
 InputSource::CodecType HAPVideoInput::detectCodec() const {
     if (hapVariant_ == HAPVariant::HAP_Q) {
         return CodecType::HAP_Q;
@@ -649,25 +691,72 @@ bool HAPVideoInput::readRawPacket(int64_t frameNumber, AVPacket* packet) {
     return false;
 }
 
-bool HAPVideoInput::decodeHapDirectToTexture(AVPacket* packet, GPUTextureFrameBuffer& textureBuffer) {
-    if (!packet || packet->size == 0) {
+bool HAPVideoInput::readMappedFrameToTexture(int64_t frameNumber, GPUTextureFrameBuffer& textureBuffer) {
+    size_t size = 0;
+    const uint8_t* data = sampleTable_.packet(frameNumber, size);
+    if (!data || size == 0) {
+        return false;
+    }
+
+    // Page in the next packet in the playback direction while this one decodes
+    int64_t step = (lastMappedFrame_ >= 0 && frameNumber < lastMappedFrame_) ? -1 : 1;
+    sampleTable_.prefetch(frameNumber + step);
+    lastMappedFrame_ = frameNumber;
+
+    if (!decodeHapDirectToTexture(data, size, textureBuffer)) {
+        return false;
+    }
+    currentFrame_ = frameNumber;
+    // The demuxer did not follow: make the libavformat path seek when used again
+    lastDecodedFrameNo_ = -1;
+    return true;
+}
+
+bool HAPVideoInput::decodeHapDirectToTexture(const uint8_t* data, size_t size, GPUTextureFrameBuffer& textureBuffer) {
+    if (!data || size == 0) {
         return false;
     }
 
     // Get HAP variant from packet
-    HapVariant variant = hapDecoder_.getVariant(packet->data, packet->size);
+    HapVariant variant = hapDecoder_.getVariant(data, size);
     if (variant == HapVariant::NONE) {
         LOG_WARNING << "Unknown HAP variant in packet";
         return false;
     }
 
-    // Decode HAP packet to DXT textures
+    // Decode HAP packet to DXT textures, straight into a mapped upload
+    // buffer when the GL supports it (saves a DXT-sized copy per frame)
     std::vector<HapDecodedTexture> textures;
-    if (!hapDecoder_.decode(packet->data, packet->size, 
-                            frameInfo_.width, frameInfo_.height, textures)) {
+    bool fromBuffer = false;
+    size_t frameSize = hapDecoder_.getLayout(data, size,
+                                             frameInfo_.width, frameInfo_.height, textures);
+    uint8_t* mapped = frameSize > 0 ? uploadRing_.map(frameSize) : nullptr;
+    if (mapped) {
+        bool decoded = hapDecoder_.decodeInto(data, size, mapped, frameSize,
+                                              textures, decodeDeadline_);
+        fromBuffer = uploadRing_.unmap() && decoded;
+        if (!fromBuffer) {
+            uploadRing_.fence();
+            if (!decoded) {
+                return false;
+            }
+            // Mapping lost before the upload: decode again to client memory
+        }
+    }
+    if (!fromBuffer && !hapDecoder_.decode(data, size,
+                                           frameInfo_.width, frameInfo_.height, textures, decodeDeadline_)) {
         return false;
     }
 
+    bool uploaded = uploadHapTextures(textures, variant, fromBuffer, textureBuffer);
+    if (fromBuffer) {
+        uploadRing_.fence();
+    }
+    return uploaded;
+}
+
+bool HAPVideoInput::uploadHapTextures(const std::vector<HapDecodedTexture>& textures, HapVariant variant,
+                                      bool fromBuffer, GPUTextureFrameBuffer& textureBuffer) {
     if (textures.empty()) {
         LOG_WARNING << "No textures decoded from HAP packet";
         return false;
@@ -690,16 +779,22 @@ bool HAPVideoInput::decodeHapDirectToTexture(AVPacket* packet, GPUTextureFrameBu
         }
 
         // Upload both textures
-        if (!textureBuffer.uploadHapQAlphaData(
-                textures[0].data.data(), textures[0].size,
-                textures[1].data.data(), textures[1].size,
-                frameInfo_.width, frameInfo_.height)) {
+        bool uploaded = fromBuffer
+            ? textureBuffer.uploadHapQAlphaFromBuffer(
+                  textures[0].offset, textures[0].size,
+                  textures[1].offset, textures[1].size,
+                  frameInfo_.width, frameInfo_.height)
+            : textureBuffer.uploadHapQAlphaData(
+                  textures[0].data.data(), textures[0].size,
+                  textures[1].data.data(), textures[1].size,
+                  frameInfo_.width, frameInfo_.height);
+        if (!uploaded) {
             return false;
         }
 
         textureBuffer.setHapVariant(HapVariant::HAP_Q_ALPHA);
     } else {
-        // Single texture: HAP, HAP Q, or HAP Alpha
+        // Single texture: HAP, HAP Q, HAP Alpha, HAP R or HAP HDR
         if (textures.size() != 1) {
             LOG_WARNING << "Single-texture HAP should have 1 texture, got " << textures.size();
             return false;
@@ -725,11 +820,30 @@ bool HAPVideoInput::decodeHapDirectToTexture(AVPacket* packet, GPUTextureFrameBu
                 glFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
                 gpuVariant = HapVariant::HAP_R;  // HAP R (BPTC/BC7 - best quality + alpha) - UNTESTED
                 break;
+            case HapTextureFormat_RGB_BPTC_UNSIGNED_FLOAT:
+                glFormat = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+                gpuVariant = HapVariant::HAP_HDR;
+                break;
+            case HapTextureFormat_RGB_BPTC_SIGNED_FLOAT:
+                glFormat = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+                gpuVariant = HapVariant::HAP_HDR;
+                break;
             default:
                 LOG_WARNING << "Unsupported HAP texture format: 0x" << std::hex << textures[0].format;
                 return false;
         }
 
+        // BPTC is GL 4.2 / ARB_texture_compression_bptc, and FFmpeg cannot decode it on the CPU
+        if ((gpuVariant == HapVariant::HAP_R || gpuVariant == HapVariant::HAP_HDR) &&
+            !GPUTextureFrameBuffer::isCompressedFormatSupported(glFormat)) {
+            if (!bptcWarningShown_) {
+                LOG_WARNING << (gpuVariant == HapVariant::HAP_R ? "HAP R" : "HAP HDR")
+                            << " needs BPTC texture compression, which this GL driver does not offer";
+                bptcWarningShown_ = true;
+            }
+            return false;
+        }
+
         // Allocate texture if needed
         if (!textureBuffer.isValid() || textureBuffer.getTextureFormat() != glFormat) {
             if (!textureBuffer.allocate(frameInfo_, glFormat, true)) {
@@ -739,9 +853,14 @@ bool HAPVideoInput::decodeHapDirectToTexture(AVPacket* packet, GPUTextureFrameBu
         }
 
         // Upload compressed DXT data
-        if (!textureBuffer.uploadCompressedData(
-                textures[0].data.data(), textures[0].size,
-                frameInfo_.width, frameInfo_.height, glFormat)) {
+        bool uploaded = fromBuffer
+            ? textureBuffer.uploadCompressedFromBuffer(
+                  textures[0].offset, textures[0].size,
+                  frameInfo_.width, frameInfo_.height, glFormat)
+            : textureBuffer.uploadCompressedData(
+                  textures[0].data.data(), textures[0].size,
+                  frameInfo_.width, frameInfo_.height, glFormat);
+        if (!uploaded) {
             return false;
         }
 
@@ -803,6 +922,9 @@ void HAPVideoInput::cleanup() {
     
 #ifdef ENABLE_HAP_DIRECT
     fallbackWarningShown_ = false;
+    bptcWarningShown_ = false;
+    sampleTable_.close();
+    lastMappedFrame_ = -1;
 #endif
 }
 
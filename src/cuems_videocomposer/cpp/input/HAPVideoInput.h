@@ -2,6 +2,7 @@
 #define VIDEOCOMPOSER_HAPVIDEOINPUT_H
 
 #include "InputSource.h"
+#include "RamClipCache.h"
 #include "../video/GPUTextureFrameBuffer.h"
 #include <cuems_mediadecoder/MediaFileReader.h>
 #include <cuems_mediadecoder/VideoDecoder.h>
@@ -11,6 +12,8 @@
 
 #ifdef ENABLE_HAP_DIRECT
 #include "../hap/HapDecoder.h"
+#include "../hap/HapUploadRing.h"
+#include "../hap/MovSampleTable.h"
 #endif
 
 extern "C" {
@@ -46,6 +49,7 @@ public:
     FrameInfo getFrameInfo() const override;
     int64_t getCurrentFrame() const override;
     CodecType detectCodec() const override;
+    bool hasAlpha() const override;
     bool supportsDirectGPUTexture() const override;
     DecodeBackend getOptimalBackend() const override;
 
@@ -64,6 +68,33 @@ public:
      */
     CodecType getHAPVariant() const;
 
+    /**
+     * Keep the whole file (all compressed packets) in RAM, read on open
+     * (RamClipCache budget permitting)
+     */
+    void setPreload(bool enabled) { preload_ = enabled; }
+    bool isPreloaded() const { return ramClip_ != nullptr; }
+
+#ifdef ENABLE_HAP_DIRECT
+    /**
+     * Set when the next frame is needed; the shared chunk pool serves the
+     * layer with the closest deadline first
+     */
+    void setDecodeDeadline(HapChunkPool::Clock::time_point deadline) { decodeDeadline_ = deadline; }
+
+    /**
+     * Direct decode latency histogram for this input (thread-safe)
+     */
+    HapDecodeLatency getDecodeLatency() const { return hapDecoder_.getLatency(); }
+    void resetDecodeLatency() { hapDecoder_.resetLatency(); }
+
+    /**
+     * Decode with the HAP SDK (default) or always take the FFmpeg RGBA
+     * fallback (benchmarks and driver comparisons)
+     */
+    void setDirectDecode(bool enabled) { directDecode_ = enabled; }
+    bool getDirectDecode() const { return directDecode_; }
+#endif
 
 private:
     enum class HAPVariant {
@@ -82,7 +113,10 @@ private:
     
 #ifdef ENABLE_HAP_DIRECT
     // Direct HAP decoding methods (Vidvox SDK)
-    bool decodeHapDirectToTexture(AVPacket* packet, GPUTextureFrameBuffer& textureBuffer);
+    bool decodeHapDirectToTexture(const uint8_t* data, size_t size, GPUTextureFrameBuffer& textureBuffer);
+    bool readMappedFrameToTexture(int64_t frameNumber, GPUTextureFrameBuffer& textureBuffer);
+    bool uploadHapTextures(const std::vector<HapDecodedTexture>& textures, HapVariant variant,
+                           bool fromBuffer, GPUTextureFrameBuffer& textureBuffer);
     bool readRawPacket(int64_t frameNumber, AVPacket* packet);
 #endif
     
@@ -114,11 +148,19 @@ private:
     // Internal state
     bool ready_;
     AVRational frameRateQ_;
+    bool preload_;
+    std::shared_ptr<const RamClip> ramClip_;  // RAM copy demuxed instead of the file
     
 #ifdef ENABLE_HAP_DIRECT
     // HAP direct decoding
     HapDecoder hapDecoder_;
+    bool directDecode_;
     bool fallbackWarningShown_;
+    bool bptcWarningShown_;          // Driver lacks BPTC (HAP R / HAP HDR) warned once
+    HapChunkPool::Clock::time_point decodeDeadline_;
+    HapUploadRing uploadRing_;       // Mapped buffers HAP frames decode into
+    MovSampleTable sampleTable_;     // Mapped MOV packets (bypasses libavformat)
+    int64_t lastMappedFrame_;        // Last frame read from sampleTable_ (-1 = none)
 #endif
 };
 
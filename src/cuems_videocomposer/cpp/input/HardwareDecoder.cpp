@@ -3,6 +3,8 @@
 #include <cstring>
 #include <string>
 #include <vector>
+#include <map>
+#include <mutex>
 #include <utility>
 #include <sstream>
 #include <cstdio>
@@ -35,6 +37,10 @@ namespace videocomposer {
 static HardwareDecoder::Type cached_hw_type = HardwareDecoder::Type::NONE;
 static bool hw_type_detected = false;
 
+// isAvailableForCodec answers per (decoder type, codec)
+static std::map<std::pair<int, int>, bool> codec_availability;
+static std::mutex codec_availability_mutex;
+
 // FFmpeg log callback state for suppressing messages during probing
 static std::vector<std::string> captured_ffmpeg_messages;
 static std::vector<std::string> captured_libva_errors;
@@ -224,6 +230,7 @@ HardwareDecoder::Type HardwareDecoder::detectAvailable() {
     // Try to detect available hardware decoders
     // Check in order of preference: VAAPI > CUDA > QSV > VideoToolbox > DXVA2
     // VAAPI is checked first because we have VaapiInterop for zero-copy GPU texture uploads
+    // Vulkan Video is not auto-detected (driver support still varies); it is opt-in
     
     AVBufferRef* hwDeviceCtx = nullptr;
     int ret = -1;
@@ -439,6 +446,10 @@ AVHWDeviceType HardwareDecoder::getFFmpegDeviceType(Type type) {
             return AV_HWDEVICE_TYPE_VIDEOTOOLBOX;
         case Type::DXVA2:
             return AV_HWDEVICE_TYPE_DXVA2;
+#ifdef VIDEOCOMPOSER_HAVE_AV_VULKAN
+        case Type::VULKAN:
+            return AV_HWDEVICE_TYPE_VULKAN;
+#endif
         default:
             return AV_HWDEVICE_TYPE_NONE;
     }
@@ -464,6 +475,11 @@ AVPixelFormat HardwareDecoder::getHardwarePixelFormat(Type type, AVCodecID codec
         case Type::DXVA2:
             // DXVA2 outputs DXVA2 frames
             return AV_PIX_FMT_DXVA2_VLD;
+#ifdef VIDEOCOMPOSER_HAVE_AV_VULKAN
+        case Type::VULKAN:
+            // Vulkan Video outputs VkImage-backed frames
+            return AV_PIX_FMT_VULKAN;
+#endif
         default:
             return AV_PIX_FMT_NONE;
     }
@@ -476,6 +492,19 @@ bool HardwareDecoder::isAvailableForCodec(AVCodecID codecId) {
 }
 
 bool HardwareDecoder::isAvailableForCodec(AVCodecID codecId, Type hwType) {
+    // Answers only depend on FFmpeg's decoder list: probe each pair once
+    std::lock_guard<std::mutex> lock(codec_availability_mutex);
+    std::pair<int, int> key(static_cast<int>(hwType), static_cast<int>(codecId));
+    auto it = codec_availability.find(key);
+    if (it != codec_availability.end()) {
+        return it->second;
+    }
+    bool available = probeCodec(codecId, hwType);
+    codec_availability[key] = available;
+    return available;
+}
+
+bool HardwareDecoder::probeCodec(AVCodecID codecId, Type hwType) {
     // Check if hardware decoder is available for the given codec
     if (hwType == Type::NONE) {
         return false;
@@ -506,13 +535,13 @@ bool HardwareDecoder::isAvailableForCodec(AVCodecID codecId, Type hwType) {
     // NOTE: Different hardware decoders work differently:
     // - QSV/CUVID: Have dedicated wrapper decoders (h264_qsv, h264_cuvid)
     // - VAAPI: Uses standard decoder with hw_device_ctx attached (hwaccel mechanism)
-    // - VideoToolbox: Uses standard decoder with hw_device_ctx (like VAAPI)
+    // - VideoToolbox, Vulkan: Use standard decoder with hw_device_ctx (like VAAPI)
     
     std::string codecName = avcodec_get_name(codecId);
     
-    // For VAAPI and VideoToolbox, check if the standard decoder supports hwaccel
+    // For VAAPI, VideoToolbox and Vulkan, check if the standard decoder supports hwaccel
     // by verifying the hw_device_ctx method is available
-    if (hwType == Type::VAAPI || hwType == Type::VIDEOTOOLBOX) {
+    if (hwType == Type::VAAPI || hwType == Type::VIDEOTOOLBOX || hwType == Type::VULKAN) {
         // Find the standard software decoder
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 0, 0)
         const AVCodec* decoder = avcodec_find_decoder(codecId);
@@ -600,6 +629,8 @@ const char* HardwareDecoder::getName(Type type) {
             return "VideoToolbox";
         case Type::DXVA2:
             return "DXVA2";
+        case Type::VULKAN:
+            return "Vulkan";
         default:
             return "None";
     }
@@ -8,6 +8,12 @@ extern "C" {
 #include <libavutil/hwcontext.h>
 }
 
+// Vulkan hwcontext (FFmpeg 4.3+); Vulkan Video decode itself needs FFmpeg 6.1+,
+// which is checked at runtime through the decoder's hw configs
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(56, 51, 100)
+#define VIDEOCOMPOSER_HAVE_AV_VULKAN 1
+#endif
+
 namespace videocomposer {
 
 /**
@@ -19,6 +25,7 @@ namespace videocomposer {
  * - CUDA (NVIDIA GPUs)
  * - VideoToolbox (macOS)
  * - DXVA2 (Windows)
+ * - Vulkan Video (any vendor; only used when requested explicitly)
  */
 class HardwareDecoder {
 public:
@@ -28,7 +35,8 @@ public:
         VAAPI,          // VAAPI (Linux)
         CUDA,           // CUDA/NVDEC (NVIDIA)
         VIDEOTOOLBOX,   // VideoToolbox (macOS)
-        DXVA2           // DXVA2 (Windows)
+        DXVA2,          // DXVA2 (Windows)
+        VULKAN          // Vulkan Video (FFmpeg hwaccel)
     };
 
     /**
@@ -61,6 +69,7 @@ public:
     
     /**
      * Check if hardware decoder is available for the given codec (with pre-detected type)
+     * Answers are cached per decoder type and codec
      * @param codecId Codec ID (H264, HEVC, AV1)
      * @param hwType Pre-detected hardware decoder type
      * @return true if hardware decoder is available for this codec
@@ -73,6 +82,10 @@ public:
      * @return String name of the decoder type
      */
     static const char* getName(Type type);
+
+private:
+    // Uncached isAvailableForCodec
+    static bool probeCodec(AVCodecID codecId, Type hwType);
 };
 
 } // namespace videocomposer
@@ -0,0 +1,305 @@
+#include "HardwareDeviceCache.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifdef HAVE_VAAPI_INTEROP
+#include <va/va.h>
+#include <va/va_drm.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+extern "C" {
+#include <libavutil/avutil.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+const char* CACHE_HEADER = "# cuems-videocomposer hardware decode capabilities";
+
+#ifdef HAVE_VAAPI_INTEROP
+struct VaapiProfileInfo {
+    VAProfile vaProfile;
+    AVCodecID codec;
+    int profile;   // FFmpeg profile
+    int bitDepth;
+};
+
+// Decode profiles FFmpeg's VAAPI hwaccel can use
+const VaapiProfileInfo VAAPI_PROFILES[] = {
+    {VAProfileMPEG2Main, AV_CODEC_ID_MPEG2VIDEO, 4, 8},
+    {VAProfileH264ConstrainedBaseline, AV_CODEC_ID_H264, 578, 8},
+    {VAProfileH264Main, AV_CODEC_ID_H264, 77, 8},
+    {VAProfileH264High, AV_CODEC_ID_H264, 100, 8},
+    {VAProfileHEVCMain, AV_CODEC_ID_HEVC, 1, 8},
+    {VAProfileHEVCMain10, AV_CODEC_ID_HEVC, 2, 10},
+    {VAProfileVP8Version0_3, AV_CODEC_ID_VP8, HardwareDeviceCache::PROFILE_UNKNOWN, 8},
+    {VAProfileVP9Profile0, AV_CODEC_ID_VP9, 0, 8},
+    {VAProfileVP9Profile2, AV_CODEC_ID_VP9, 2, 10},
+#if VA_CHECK_VERSION(1, 8, 0)
+    {VAProfileAV1Profile0, AV_CODEC_ID_AV1, 0, 10},
+#endif
+};
+
+std::vector<HardwareDeviceCache::Capability> probeVaapiNode(const std::string& path, bool& ok) {
+    std::vector<HardwareDeviceCache::Capability> capabilities;
+    ok = false;
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return capabilities;
+    }
+    VADisplay display = vaGetDisplayDRM(fd);
+    int major = 0, minor = 0;
+    if (display) {
+        vaSetInfoCallback(display, [](void*, const char*) {}, nullptr);
+    }
+    if (!display || vaInitialize(display, &major, &minor) != VA_STATUS_SUCCESS) {
+        close(fd);
+        return capabilities;
+    }
+    ok = true;
+
+    int numProfiles = vaMaxNumProfiles(display);
+    std::vector<VAProfile> profiles(static_cast<size_t>(std::max(numProfiles, 0)));
+    if (vaQueryConfigProfiles(display, profiles.data(), &numProfiles) != VA_STATUS_SUCCESS) {
+        numProfiles = 0;
+    }
+    for (int i = 0; i < numProfiles; ++i) {
+        const VaapiProfileInfo* info = nullptr;
+        for (const VaapiProfileInfo& candidate : VAAPI_PROFILES) {
+            if (candidate.vaProfile == profiles[i]) {
+                info = &candidate;
+            }
+        }
+        if (!info) {
+            continue;
+        }
+        VAConfigID config = VA_INVALID_ID;
+        if (vaCreateConfig(display, profiles[i], VAEntrypointVLD, nullptr, 0, &config) != VA_STATUS_SUCCESS) {
+            continue;  // Encode-only profile
+        }
+        HardwareDeviceCache::Capability capability;
+        capability.device = path;
+        capability.codec = info->codec;
+        capability.profile = info->profile;
+        capability.maxBitDepth = info->bitDepth;
+        unsigned int numAttribs = 0;
+        if (vaQuerySurfaceAttributes(display, config, nullptr, &numAttribs) == VA_STATUS_SUCCESS && numAttribs) {
+            std::vector<VASurfaceAttrib> attribs(numAttribs);
+            if (vaQuerySurfaceAttributes(display, config, attribs.data(), &numAttribs) == VA_STATUS_SUCCESS) {
+                for (unsigned int a = 0; a < numAttribs; ++a) {
+                    if (attribs[a].type == VASurfaceAttribMaxWidth) {
+                        capability.maxWidth = attribs[a].value.value.i;
+                    } else if (attribs[a].type == VASurfaceAttribMaxHeight) {
+                        capability.maxHeight = attribs[a].value.value.i;
+                    }
+                }
+            }
+        }
+        vaDestroyConfig(display, config);
+        capabilities.push_back(capability);
+    }
+    vaTerminate(display);
+    close(fd);
+    return capabilities;
+}
+#endif
+
+} // namespace
+
+HardwareDeviceCache& HardwareDeviceCache::instance() {
+    static HardwareDeviceCache cache;
+    return cache;
+}
+
+HardwareDeviceCache::HardwareDeviceCache() {
+}
+
+HardwareDeviceCache::~HardwareDeviceCache() {
+    releaseDevices();
+}
+
+void HardwareDeviceCache::build(const std::vector<std::string>& nodes, const std::string& cachePath) {
+    if (!cachePath.empty() && load(cachePath)) {
+        bool complete = true;
+        for (const std::string& node : nodes) {
+            complete = complete && isProbed(node);
+        }
+        if (complete) {
+            LOG_INFO << "HardwareDeviceCache: Capabilities of " << nodes.size() << " device(s) loaded from "
+                     << cachePath;
+            return;
+        }
+    }
+
+#ifdef HAVE_VAAPI_INTEROP
+    auto start = std::chrono::steady_clock::now();
+    bool probedAny = false;
+    for (const std::string& node : nodes) {
+        if (isProbed(node)) {
+            continue;
+        }
+        bool ok = false;
+        std::vector<Capability> capabilities = probeVaapiNode(node, ok);
+        if (!ok) {
+            LOG_VERBOSE << "HardwareDeviceCache: Could not probe " << node;
+            continue;
+        }
+        setCapabilities(node, capabilities);
+        probedAny = true;
+        for (const Capability& capability : capabilities) {
+            LOG_VERBOSE << "HardwareDeviceCache: " << node << " decodes " << avcodec_get_name(capability.codec)
+                        << " profile " << capability.profile << " up to " << capability.maxWidth << "x"
+                        << capability.maxHeight << " " << capability.maxBitDepth << "-bit";
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (probedAny) {
+        LOG_INFO << "HardwareDeviceCache: Probed decode capabilities in " << ms << " ms";
+        if (!cachePath.empty()) {
+            save(cachePath);
+        }
+    }
+#else
+    (void)nodes;
+#endif
+}
+
+void HardwareDeviceCache::setCapabilities(const std::string& device, const std::vector<Capability>& capabilities) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = capabilities_.begin(); it != capabilities_.end();) {
+        it = it->device == device ? capabilities_.erase(it) : std::next(it);
+    }
+    for (Capability capability : capabilities) {
+        capability.device = device;
+        capabilities_.push_back(capability);
+    }
+    probed_.insert(device);
+}
+
+bool HardwareDeviceCache::isProbed(const std::string& device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return probed_.count(device) != 0;
+}
+
+bool HardwareDeviceCache::profileCovers(AVCodecID codec, int supported, int profile) {
+    if (profile == PROFILE_UNKNOWN || supported == PROFILE_UNKNOWN || supported == profile) {
+        return true;
+    }
+    // High decodes Constrained Baseline (578), Baseline (66) and Main (77)
+    if (codec == AV_CODEC_ID_H264 && supported == 100) {
+        return profile == 66 || profile == 77 || profile == 578;
+    }
+    // Main 10 decodes Main
+    if (codec == AV_CODEC_ID_HEVC && supported == 2) {
+        return profile == 1;
+    }
+    return false;
+}
+
+HardwareDeviceCache::Support HardwareDeviceCache::supports(const std::string& device, AVCodecID codec, int profile,
+                                                           int width, int height, int bitDepth) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!probed_.count(device)) {
+        return Support::UNKNOWN;
+    }
+    for (const Capability& capability : capabilities_) {
+        if (capability.device == device && capability.codec == codec &&
+            profileCovers(codec, capability.profile, profile) && bitDepth <= capability.maxBitDepth &&
+            (capability.maxWidth <= 0 || width <= capability.maxWidth) &&
+            (capability.maxHeight <= 0 || height <= capability.maxHeight)) {
+            return Support::SUPPORTED;
+        }
+    }
+    return Support::UNSUPPORTED;
+}
+
+bool HardwareDeviceCache::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        LOG_WARNING << "HardwareDeviceCache: Cannot write " << path;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    file << CACHE_HEADER << "\n" << "ffmpeg " << av_version_info() << "\n";
+    // One "device <path>" line per probed device, then its codecs
+    for (const std::string& device : probed_) {
+        file << "device " << device << "\n";
+        for (const Capability& capability : capabilities_) {
+            if (capability.device == device) {
+                file << avcodec_get_name(capability.codec) << " " << capability.profile << " "
+                     << capability.maxWidth << " " << capability.maxHeight << " " << capability.maxBitDepth << "\n";
+            }
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool HardwareDeviceCache::load(const std::string& path) {
+    std::ifstream file(path);
+    std::string header, version;
+    if (!file || !std::getline(file, header) || header != CACHE_HEADER || !std::getline(file, version)) {
+        return false;
+    }
+    if (version != std::string("ffmpeg ") + av_version_info()) {
+        LOG_INFO << "HardwareDeviceCache: " << path << " was written by another FFmpeg build, probing again";
+        return false;
+    }
+
+    std::map<std::string, std::vector<Capability>> loaded;
+    std::string line, device;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+        if (first == "device") {
+            fields >> device;
+            loaded[device];
+            continue;
+        }
+        const AVCodecDescriptor* descriptor = avcodec_descriptor_get_by_name(first.c_str());
+        Capability capability;
+        if (device.empty() || !descriptor ||
+            !(fields >> capability.profile >> capability.maxWidth >> capability.maxHeight >> capability.maxBitDepth)) {
+            LOG_WARNING << "HardwareDeviceCache: Ignoring " << path << " (bad line: " << line << ")";
+            return false;
+        }
+        capability.codec = descriptor->id;
+        loaded[device].push_back(capability);
+    }
+    for (const auto& entry : loaded) {
+        setCapabilities(entry.first, entry.second);
+    }
+    return true;
+}
+
+AVBufferRef* HardwareDeviceCache::acquireDevice(const std::string& key, const DeviceFactory& factory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(key);
+    if (it == devices_.end()) {
+        AVBufferRef* device = factory ? factory() : nullptr;
+        if (!device) {
+            return nullptr;
+        }
+        it = devices_.emplace(key, device).first;
+    }
+    return av_buffer_ref(it->second);
+}
+
+void HardwareDeviceCache::releaseDevices() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : devices_) {
+        av_buffer_unref(&entry.second);
+    }
+    devices_.clear();
+}
+
+} // namespace videocomposer
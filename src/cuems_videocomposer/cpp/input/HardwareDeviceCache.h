@@ -0,0 +1,95 @@
+#ifndef VIDEOCOMPOSER_HARDWAREDEVICECACHE_H
+#define VIDEOCOMPOSER_HARDWAREDEVICECACHE_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+}
+
+namespace videocomposer {
+
+/**
+ * HardwareDeviceCache - What each decode device can do, and one device context per device
+ *
+ * Capabilities (codec x profile x maximum size x bit depth) are probed
+ * once at startup for every VAAPI render node, and optionally saved to a
+ * file that later starts load instead of probing (the file is ignored
+ * when it was written by another FFmpeg build). Layer opens then check a
+ * clip against its device without touching the driver.
+ *
+ * Hardware decoders share one refcounted AVBufferRef device context per
+ * device instead of creating (and initializing) one per layer.
+ */
+class HardwareDeviceCache {
+public:
+    enum class Support {
+        UNKNOWN,      // Device not probed: use the decoder heuristics
+        SUPPORTED,
+        UNSUPPORTED
+    };
+
+    static constexpr int PROFILE_UNKNOWN = -99;  // FF_PROFILE_UNKNOWN / AV_PROFILE_UNKNOWN
+
+    struct Capability {
+        std::string device;             // Render node path
+        AVCodecID codec = AV_CODEC_ID_NONE;
+        int profile = PROFILE_UNKNOWN;
+        int maxWidth = 0;               // 0 = not reported
+        int maxHeight = 0;
+        int maxBitDepth = 8;
+    };
+
+    /** Creates a device context (nullptr on failure) */
+    using DeviceFactory = std::function<AVBufferRef*()>;
+
+    static HardwareDeviceCache& instance();
+
+    HardwareDeviceCache();
+    ~HardwareDeviceCache();
+
+    /**
+     * Capabilities of the VAAPI render nodes, from the file when it lists
+     * them all, else probed (and the file rewritten)
+     * @param cachePath Capability file ("" = do not persist)
+     */
+    void build(const std::vector<std::string>& nodes, const std::string& cachePath = "");
+
+    /** Record a device as probed, with what it decodes */
+    void setCapabilities(const std::string& device, const std::vector<Capability>& capabilities);
+    bool isProbed(const std::string& device) const;
+
+    Support supports(const std::string& device, AVCodecID codec, int profile,
+                     int width, int height, int bitDepth) const;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    /**
+     * Shared device context for a key (device path, display, ...),
+     * created with the factory on first use
+     * @return New reference (caller unrefs) or nullptr
+     */
+    AVBufferRef* acquireDevice(const std::string& key, const DeviceFactory& factory);
+
+    /** Drop the cached device contexts (before the display goes away) */
+    void releaseDevices();
+
+private:
+    static bool profileCovers(AVCodecID codec, int supported, int profile);
+
+    mutable std::mutex mutex_;
+    std::set<std::string> probed_;
+    std::vector<Capability> capabilities_;
+    std::map<std::string, AVBufferRef*> devices_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_HARDWAREDEVICECACHE_H
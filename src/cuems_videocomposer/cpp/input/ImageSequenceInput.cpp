@@ -0,0 +1,543 @@
+#include "ImageSequenceInput.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+constexpr int MAX_AUTO_THREADS = 8;
+constexpr int MAX_DIGITS = 18;  // Fits int64_t
+
+std::string lowerExtension(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return std::string();
+    }
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+AVCodecID codecForExtension(const std::string& ext) {
+    if (ext == "dpx") return AV_CODEC_ID_DPX;
+    if (ext == "exr") return AV_CODEC_ID_EXR;
+    if (ext == "png") return AV_CODEC_ID_PNG;
+    if (ext == "tga") return AV_CODEC_ID_TARGA;
+    if (ext == "tif" || ext == "tiff") return AV_CODEC_ID_TIFF;
+    return AV_CODEC_ID_NONE;
+}
+
+bool allDigits(const std::string& s, size_t begin, size_t end) {
+    if (begin >= end) {
+        return false;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(s[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void unmapPacket(void* opaque, uint8_t* data) {
+    munmap(data, reinterpret_cast<uintptr_t>(opaque));
+}
+
+// Load a whole file into packet: mapped when the zero-filled tail of the
+// last page is long enough to be FFmpeg's packet padding, read otherwise
+bool loadFile(const std::string& path, AVPacket* packet) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > INT32_MAX - AV_INPUT_BUFFER_PADDING_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t mappedSize = (size + page - 1) / page * page;
+
+    bool loaded = false;
+    if (mappedSize - size >= AV_INPUT_BUFFER_PADDING_SIZE) {
+        void* data = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, mappedSize, MADV_SEQUENTIAL);
+            AVBufferRef* buf = av_buffer_create(static_cast<uint8_t*>(data), static_cast<int>(mappedSize),
+                                                unmapPacket, reinterpret_cast<void*>(mappedSize),
+                                                AV_BUFFER_FLAG_READONLY);
+            if (buf) {
+                packet->buf = buf;
+                packet->data = buf->data;
+                packet->size = static_cast<int>(size);
+                loaded = true;
+            } else {
+                munmap(data, mappedSize);
+            }
+        }
+    }
+    if (!loaded && av_new_packet(packet, static_cast<int>(size)) == 0) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::read(fd, packet->data + done, size - done);
+            if (n <= 0) {
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        loaded = done == size;
+        if (!loaded) {
+            av_packet_unref(packet);
+        }
+    }
+    ::close(fd);
+    return loaded;
+}
+
+} // namespace
+
+struct ImageSequenceInput::Decoder {
+    AVCodecContext* codecCtx = nullptr;
+    AVFrame* frame = nullptr;
+    AVPacket* packet = nullptr;
+    SwsContext* swsCtx = nullptr;
+
+    ~Decoder() {
+        sws_freeContext(swsCtx);
+        av_packet_free(&packet);
+        av_frame_free(&frame);
+        avcodec_free_context(&codecCtx);
+    }
+
+    bool init(int codecId) {
+        const AVCodec* codec = avcodec_find_decoder(static_cast<AVCodecID>(codecId));
+        if (!codec) {
+            return false;
+        }
+        codecCtx = avcodec_alloc_context3(codec);
+        frame = av_frame_alloc();
+        packet = av_packet_alloc();
+        if (!codecCtx || !frame || !packet) {
+            return false;
+        }
+        codecCtx->thread_count = 1;  // Parallel across files instead
+
+        // EXR holds linear light: convert to sRGB for display
+        AVDictionary* options = nullptr;
+        if (codecId == AV_CODEC_ID_EXR) {
+            av_dict_set(&options, "apply_trc", "iec61966_2_1", 0);
+        }
+        int ret = avcodec_open2(codecCtx, codec, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            avcodec_free_context(&codecCtx);
+            return false;
+        }
+        return true;
+    }
+};
+
+bool ImageSequenceInput::Pattern::parse(const std::string& source, Pattern& pattern, int64_t* number) {
+    size_t slash = source.find_last_of('/');
+    size_t nameStart = slash == std::string::npos ? 0 : slash + 1;
+    if (number) {
+        *number = -1;
+    }
+
+    // printf pattern: %d or %0Nd
+    size_t percent = source.find('%', nameStart);
+    if (percent != std::string::npos) {
+        size_t i = percent + 1;
+        int width = 0;
+        while (i < source.size() && std::isdigit(static_cast<unsigned char>(source[i]))) {
+            width = width * 10 + (source[i] - '0');
+            ++i;
+        }
+        if (i >= source.size() || source[i] != 'd' || width > MAX_DIGITS) {
+            return false;
+        }
+        pattern.prefix = source.substr(0, percent);
+        pattern.suffix = source.substr(i + 1);
+        pattern.digits = width;
+        return true;
+    }
+
+    // '#' run, one character per digit
+    size_t hash = source.find('#', nameStart);
+    if (hash != std::string::npos) {
+        size_t end = source.find_first_not_of('#', hash);
+        if (end == std::string::npos) {
+            end = source.size();
+        }
+        if (end - hash > static_cast<size_t>(MAX_DIGITS)) {
+            return false;
+        }
+        pattern.prefix = source.substr(0, hash);
+        pattern.suffix = source.substr(end);
+        pattern.digits = static_cast<int>(end - hash);
+        return true;
+    }
+
+    // Numbered file: the last run of digits before the extension
+    size_t end = source.find_last_of('.');
+    if (end == std::string::npos || end < nameStart) {
+        end = source.size();
+    }
+    size_t begin = end;
+    while (begin > nameStart && std::isdigit(static_cast<unsigned char>(source[begin - 1]))) {
+        --begin;
+    }
+    if (begin == end || end - begin > static_cast<size_t>(MAX_DIGITS)) {
+        return false;
+    }
+    pattern.prefix = source.substr(0, begin);
+    pattern.suffix = source.substr(end);
+    pattern.digits = static_cast<int>(end - begin);
+    if (number) {
+        *number = std::stoll(source.substr(begin, end - begin));
+    }
+    return true;
+}
+
+bool ImageSequenceInput::Pattern::scan() {
+    size_t slash = prefix.find_last_of('/');
+    std::string dirPath = slash == std::string::npos ? "." : (slash == 0 ? "/" : prefix.substr(0, slash));
+    std::string namePrefix = slash == std::string::npos ? prefix : prefix.substr(slash + 1);
+
+    DIR* dir = opendir(dirPath.c_str());
+    if (!dir) {
+        return false;
+    }
+    first = 0;
+    last = -1;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= namePrefix.size() + suffix.size() ||
+            name.compare(0, namePrefix.size(), namePrefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        size_t begin = namePrefix.size();
+        size_t end = name.size() - suffix.size();
+        size_t width = end - begin;
+        // Zero-padded to digits: wider numbers have no leading zero
+        if (!allDigits(name, begin, end) || width > static_cast<size_t>(MAX_DIGITS) ||
+            width < static_cast<size_t>(digits) ||
+            (width > static_cast<size_t>(std::max(digits, 1)) && name[begin] == '0')) {
+            continue;
+        }
+        int64_t value = std::stoll(name.substr(begin, width));
+        if (last < first) {
+            first = last = value;
+        } else {
+            first = std::min(first, value);
+            last = std::max(last, value);
+        }
+    }
+    closedir(dir);
+    return last >= first;
+}
+
+std::string ImageSequenceInput::Pattern::pathFor(int64_t number) const {
+    std::string digitsText = std::to_string(number);
+    if (static_cast<int>(digitsText.size()) < digits) {
+        digitsText.insert(0, static_cast<size_t>(digits) - digitsText.size(), '0');
+    }
+    return prefix + digitsText + suffix;
+}
+
+ImageSequenceInput::ImageSequenceInput() {
+    frameInfo_ = {};
+}
+
+ImageSequenceInput::~ImageSequenceInput() {
+    close();
+}
+
+bool ImageSequenceInput::isImageExtension(const std::string& path) {
+    return codecForExtension(lowerExtension(path)) != AV_CODEC_ID_NONE;
+}
+
+bool ImageSequenceInput::isSequencePath(const std::string& path) {
+    if (!isImageExtension(path)) {
+        return false;
+    }
+    Pattern pattern;
+    int64_t number = -1;
+    if (!Pattern::parse(path, pattern, &number)) {
+        return false;
+    }
+    if (number < 0) {
+        return true;  // Explicit pattern
+    }
+    // One numbered still (logo_2.png) is not a sequence
+    struct stat st;
+    return stat(pattern.pathFor(number + 1).c_str(), &st) == 0 ||
+           (number > 0 && stat(pattern.pathFor(number - 1).c_str(), &st) == 0);
+}
+
+bool ImageSequenceInput::open(const std::string& source) {
+    close();
+
+    if (!isImageExtension(source) || !Pattern::parse(source, pattern_) || !pattern_.scan()) {
+        LOG_ERROR << "Image sequence: no numbered frames found for " << source;
+        return false;
+    }
+    codecId_ = codecForExtension(lowerExtension(source));
+
+    // The first frame gives the size of every frame
+    Decoder decoder;
+    FrameBuffer firstFrame;
+    if (!decodeInto(decoder, 0, firstFrame, &hasAlpha_)) {
+        LOG_ERROR << "Image sequence: cannot decode " << pattern_.pathFor(pattern_.first);
+        return false;
+    }
+    frameInfo_ = firstFrame.info();
+
+    size_t capacity = FramePool::capacityForBudget(cacheBudget_, firstFrame.size());
+    framePool_ = FramePool::create(capacity, firstFrame.size());
+    // Window + the frame shown + the one behind it + one a caller may still hold
+    window_ = std::max(1, std::min(readAhead_, static_cast<int>(capacity) - 3));
+
+    int threads = threads_ > 0 ? threads_
+                               : std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()),
+                                                      MAX_AUTO_THREADS));
+    threads = std::min(threads, window_ + 1);
+    stopping_ = false;
+    playhead_ = 0;
+    direction_ = 1;
+    currentFrame_ = -1;
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ImageSequenceInput::workerLoop, this);
+    }
+    ready_ = true;
+
+    LOG_INFO << "Image sequence: " << pattern_.frameCount() << " frames ("
+             << pattern_.pathFor(pattern_.first) << ", " << frameInfo_.width << "x" << frameInfo_.height
+             << "), " << threads << " decode threads, " << window_ << " frames ahead";
+    return true;
+}
+
+void ImageSequenceInput::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    frameReady_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+    jobs_.clear();
+    inFlight_.clear();
+    decoded_.clear();
+    framePool_.reset();  // Frames still held by readers keep the pool alive
+    ready_ = false;
+    currentFrame_ = -1;
+}
+
+bool ImageSequenceInput::seek(int64_t frameNumber) {
+    if (!ready_ || frameNumber < 0 || frameNumber >= pattern_.frameCount()) {
+        return false;
+    }
+    // Every frame decodes on its own: just start reading ahead from there
+    std::lock_guard<std::mutex> lock(mutex_);
+    playhead_ = frameNumber;
+    direction_ = 1;
+    scheduleLocked(frameNumber);
+    jobAvailable_.notify_all();
+    return true;
+}
+
+bool ImageSequenceInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
+    if (!ready_ || frameNumber < 0 || frameNumber >= pattern_.frameCount()) {
+        return false;
+    }
+
+    FramePool::Handle frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        int64_t step = frameNumber - playhead_;
+        if (step > 0 || step < -window_) {
+            direction_ = 1;   // Forward, or a jump back that starts playing forward again
+        } else if (step < 0) {
+            direction_ = -1;  // Reverse playback
+        }
+        playhead_ = frameNumber;
+
+        // Frames left behind go back to the pool
+        int64_t low = direction_ > 0 ? playhead_ - 1 : playhead_ - window_;
+        int64_t high = direction_ > 0 ? playhead_ + window_ : playhead_ + 1;
+        for (auto it = decoded_.begin(); it != decoded_.end();) {
+            it = (it->first < low || it->first > high) ? decoded_.erase(it) : std::next(it);
+        }
+
+        scheduleLocked(frameNumber);
+        for (int k = 1; k <= window_; ++k) {
+            scheduleLocked(frameNumber + direction_ * k);
+        }
+        jobAvailable_.notify_all();
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!decoded_.count(frameNumber) && inFlight_.count(frameNumber) && !stopping_) {
+            if (frameReady_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        auto it = decoded_.find(frameNumber);
+        if (it == decoded_.end()) {
+            return false;  // Missing or undecodable file: the layer keeps its last frame
+        }
+        frame = it->second;
+    }
+
+    FrameBuffer& pooled = frame->buffer;
+    uint8_t* data = pooled.data();
+    if (!buffer.wrap(data, pooled.size(), pooled.info(), std::shared_ptr<void>(frame, data))) {
+        return false;
+    }
+    currentFrame_ = frameNumber;
+    return true;
+}
+
+void ImageSequenceInput::scheduleLocked(int64_t frameNumber) {
+    if (frameNumber < 0 || frameNumber >= pattern_.frameCount() || decoded_.count(frameNumber)) {
+        return;
+    }
+    if (inFlight_.count(frameNumber)) {
+        if (frameNumber == playhead_) {
+            // Needed now: move it to the front if it is still waiting
+            auto queued = std::find(jobs_.begin(), jobs_.end(), frameNumber);
+            if (queued != jobs_.end() && queued != jobs_.begin()) {
+                jobs_.erase(queued);
+                jobs_.push_front(frameNumber);
+            }
+        }
+        return;
+    }
+    inFlight_.insert(frameNumber);
+    if (frameNumber == playhead_) {
+        jobs_.push_front(frameNumber);
+    } else {
+        jobs_.push_back(frameNumber);
+    }
+}
+
+void ImageSequenceInput::workerLoop() {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
+    Decoder decoder;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (jobs_.empty()) {
+            jobAvailable_.wait(lock);
+            continue;
+        }
+        int64_t frameNumber = jobs_.front();
+        jobs_.pop_front();
+
+        // Skip work the playhead has already moved away from
+        int64_t distance = (frameNumber - playhead_) * direction_;
+        if (distance < -1 || distance > window_) {
+            inFlight_.erase(frameNumber);
+            continue;
+        }
+        int64_t prefetchFrame = frameNumber + direction_ * window_;
+        lock.unlock();
+
+        // An exhausted pool means readers hold every frame: the job is
+        // dropped and scheduled again on the next read
+        FramePool::Handle slot = framePool_->acquire();
+        bool decoded = slot && decodeInto(decoder, frameNumber, slot->buffer);
+        if (decoded) {
+            slot->frameNumber = frameNumber;
+            prefetch(prefetchFrame);
+        }
+
+        lock.lock();
+        inFlight_.erase(frameNumber);
+        if (decoded && !stopping_) {
+            decoded_[frameNumber] = std::move(slot);
+        }
+        frameReady_.notify_all();
+    }
+}
+
+void ImageSequenceInput::prefetch(int64_t frameNumber) const {
+    if (frameNumber < 0 || frameNumber >= pattern_.frameCount()) {
+        return;
+    }
+    // Starts the read of the frame after the window while this one decodes
+    int fd = ::open(pattern_.pathFor(pattern_.first + frameNumber).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        ::close(fd);
+    }
+}
+
+bool ImageSequenceInput::decodeInto(Decoder& decoder, int64_t frameNumber, FrameBuffer& buffer, bool* alpha) {
+    if (!decoder.codecCtx && !decoder.init(codecId_)) {
+        return false;
+    }
+    if (!loadFile(pattern_.pathFor(pattern_.first + frameNumber), decoder.packet)) {
+        return false;
+    }
+    int ret = avcodec_send_packet(decoder.codecCtx, decoder.packet);
+    av_packet_unref(decoder.packet);
+    if (ret < 0 || avcodec_receive_frame(decoder.codecCtx, decoder.frame) < 0) {
+        return false;
+    }
+
+    AVFrame* frame = decoder.frame;
+    FrameInfo info;
+    info.width = frame->width;
+    info.height = frame->height;
+    info.aspect = frame->height > 0 ? static_cast<float>(frame->width) / static_cast<float>(frame->height) : 0.0f;
+    info.framerate = framerate_;
+    info.totalFrames = pattern_.frameCount();
+    info.duration = static_cast<double>(info.totalFrames) / framerate_;
+    info.format = PixelFormat::BGRA32;  // What the renderer uploads
+    if (alpha) {
+        const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+        *alpha = desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+    }
+
+    bool converted = false;
+    if (buffer.ensureAllocated(info)) {
+        decoder.swsCtx = sws_getCachedContext(decoder.swsCtx,
+            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+            frame->width, frame->height, AV_PIX_FMT_BGRA,
+            SWS_POINT, nullptr, nullptr, nullptr);
+        if (decoder.swsCtx) {
+            uint8_t* dstData[1] = { buffer.data() };
+            int dstLinesize[1] = { frame->width * 4 };
+            sws_scale(decoder.swsCtx, frame->data, frame->linesize, 0, frame->height, dstData, dstLinesize);
+            converted = true;
+        }
+    }
+    av_frame_unref(decoder.frame);
+    return converted;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,129 @@
+#ifndef VIDEOCOMPOSER_IMAGESEQUENCEINPUT_H
+#define VIDEOCOMPOSER_IMAGESEQUENCEINPUT_H
+
+#include "InputSource.h"
+#include "../video/FramePool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ImageSequenceInput - Numbered image files (DPX, EXR, PNG, TGA, TIFF) as a clip
+ *
+ * Frame N is the file numbered first + N, so any frame resolves to a path
+ * without a directory lookup and every frame decodes on its own: seeking
+ * is instant. A worker pool decodes a window of frames ahead of the last
+ * request into a FramePool; readFrame() hands the pooled frame out shared
+ * (no copy). Files are mapped rather than read where FFmpeg's packet
+ * padding fits in the last page, and the files just past the window are
+ * prefetched with posix_fadvise(WILLNEED).
+ *
+ * Accepted sources: a printf pattern ("shot.%06d.dpx"), a '#' run
+ * ("shot.######.dpx"), or any one numbered file of the sequence.
+ */
+class ImageSequenceInput : public InputSource {
+public:
+    /**
+     * Where frame files live: prefix + number (zero-padded to digits) + suffix
+     */
+    struct Pattern {
+        std::string prefix;
+        std::string suffix;
+        int digits = 0;       // Minimum width (numbers are zero-padded to it)
+        int64_t first = 0;    // Lowest number on disk
+        int64_t last = -1;    // Highest number on disk
+
+        /**
+         * Split a source into prefix/digits/suffix (first/last are not scanned)
+         * @param number Set to the number of a numbered file (-1 for patterns)
+         */
+        static bool parse(const std::string& source, Pattern& pattern, int64_t* number = nullptr);
+
+        /** List the directory once and set first/last */
+        bool scan();
+
+        std::string pathFor(int64_t number) const;
+        int64_t frameCount() const { return last >= first ? last - first + 1 : 0; }
+    };
+
+    ImageSequenceInput();
+    ~ImageSequenceInput() override;
+
+    /**
+     * Whether a path names an image sequence: a pattern, or a numbered image
+     * file whose next number also exists (a lone numbered still is not one)
+     */
+    static bool isSequencePath(const std::string& path);
+
+    /** Image file extensions handled (dpx, exr, png, tga, tif, tiff) */
+    static bool isImageExtension(const std::string& path);
+
+    // Settings below apply to the next open()
+    void setFramerate(double fps) { framerate_ = fps > 0.0 ? fps : 25.0; }
+    void setThreads(int threads) { threads_ = threads; }          // -1 = auto
+    void setReadAhead(int frames) { readAhead_ = frames > 0 ? frames : 1; }
+    void setCacheBudget(size_t bytes) { cacheBudget_ = bytes; }   // Frame pool memory
+
+    // InputSource interface
+    bool open(const std::string& source) override;
+    void close() override;
+    bool isReady() const override { return ready_; }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override;
+    bool seek(int64_t frameNumber) override;
+    FrameInfo getFrameInfo() const override { return frameInfo_; }
+    int64_t getCurrentFrame() const override { return currentFrame_; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+    bool hasAlpha() const override { return hasAlpha_; }
+    bool hasInstantSeek() const override { return true; }
+
+    std::shared_ptr<FramePool> getFramePool() const { return framePool_; }
+
+private:
+    struct Decoder;  // Per-thread FFmpeg state
+
+    bool decodeInto(Decoder& decoder, int64_t frameNumber, FrameBuffer& buffer, bool* alpha = nullptr);
+    void workerLoop();
+    void scheduleLocked(int64_t frameNumber);  // mutex_ held
+    void prefetch(int64_t frameNumber) const;
+
+    Pattern pattern_;
+    int codecId_ = 0;  // AVCodecID from the extension
+    FrameInfo frameInfo_;
+    bool ready_ = false;
+    bool hasAlpha_ = false;
+    int64_t currentFrame_ = -1;
+
+    double framerate_ = 25.0;
+    int threads_ = -1;
+    int readAhead_ = 12;
+    size_t cacheBudget_ = 512ull * 1024 * 1024;
+    int window_ = 0;  // readAhead_ capped by the pool
+
+    std::shared_ptr<FramePool> framePool_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::condition_variable frameReady_;
+    std::deque<int64_t> jobs_;                        // Frames to decode, most urgent first
+    std::set<int64_t> inFlight_;                      // Queued or decoding
+    std::map<int64_t, FramePool::Handle> decoded_;    // Ready frames around the playhead
+    int64_t playhead_ = 0;
+    int direction_ = 1;                               // Read-ahead direction
+    bool stopping_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_IMAGESEQUENCEINPUT_H
@@ -3,11 +3,14 @@
 
 #include "../video/FrameBuffer.h"
 #include "../video/FrameFormat.h"
+#include <memory>
 #include <string>
 #include <cstdint>
 
 namespace videocomposer {
 
+class TiledImage;
+
 /**
  * Abstract base class for all input sources.
  * 
@@ -93,6 +96,15 @@ public:
         CPU_SOFTWARE   // CPU software decoder
     };
 
+    /**
+     * What to do when a pre-decoded frame is not ready in time
+     */
+    enum class UnderrunPolicy {
+        BLOCK,         // Wait briefly, then decode synchronously on the calling thread
+        HOLD,          // Never block: show the nearest decoded frame (or keep the last one)
+        DROP           // HOLD, and let the decoder skip non-reference frames to catch up
+    };
+
     /**
      * Detect the codec type of this input source
      * @return CodecType enum value
@@ -118,6 +130,34 @@ public:
      */
     virtual bool isLiveStream() const { return false; }  // Default: not live
 
+    /**
+     * Check if frames may carry transparency
+     * Opaque sources let the renderer skip the layers they cover.
+     * @return true unless the source is known to be opaque (default)
+     */
+    virtual bool hasAlpha() const { return true; }
+
+    /**
+     * Check if any frame can be read without decoding its neighbours
+     * (image sequences, intra-only codecs): scrubbing and reverse play are cheap.
+     * @return false unless every frame decodes on its own (default)
+     */
+    virtual bool hasInstantSeek() const { return false; }
+
+    /**
+     * Check if the content never changes after open() (still images)
+     * Layers then load the frame once and the renderer uploads it once.
+     * @return false unless every readFrame() returns the same image (default)
+     */
+    virtual bool isStatic() const { return false; }
+
+    /**
+     * Tiles of a giant still image (the frames read are its overview)
+     * The renderer then draws the tiles on screen instead of the frame.
+     * @return nullptr unless the source is tiled (default)
+     */
+    virtual std::shared_ptr<TiledImage> getTiledImage() const { return nullptr; }
+
     /**
      * For live streams: get the latest available frame
      * Default implementation calls readFrame(0, buffer)
@@ -0,0 +1,187 @@
+#include "IntraDecoderPool.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/FrameTracer.h"
+#include <algorithm>
+#include <chrono>
+
+namespace videocomposer {
+
+IntraDecoderPool::IntraDecoderPool()
+    : stop_(false)
+{
+}
+
+IntraDecoderPool::~IntraDecoderPool() {
+    close();
+}
+
+bool IntraDecoderPool::open(const AVCodecParameters* codecpar, int workers, int threadsPerDecoder,
+                            std::function<void()> onDecoded) {
+    close();
+    const AVCodec* codec = codecpar ? avcodec_find_decoder(codecpar->codec_id) : nullptr;
+    if (!codec || workers < 1) {
+        return false;
+    }
+
+    for (int i = 0; i < workers; ++i) {
+        AVCodecContext* ctx = avcodec_alloc_context3(codec);
+        if (!ctx || avcodec_parameters_to_context(ctx, codecpar) < 0) {
+            avcodec_free_context(&ctx);
+            close();
+            return false;
+        }
+        // Slice threads only: frame threading holds frames back, and the
+        // parallelism comes from the other decoders
+        ctx->thread_count = std::max(1, threadsPerDecoder);
+        ctx->thread_type = FF_THREAD_SLICE;
+        if (avcodec_open2(ctx, codec, nullptr) < 0) {
+            LOG_ERROR << "IntraDecoderPool: Failed to open decoder " << i << " of " << workers;
+            avcodec_free_context(&ctx);
+            close();
+            return false;
+        }
+        decoders_.push_back(ctx);
+    }
+
+    onDecoded_ = std::move(onDecoded);
+    stop_ = false;
+    for (size_t i = 0; i < decoders_.size(); ++i) {
+        threads_.emplace_back(&IntraDecoderPool::workerFunc, this, i);
+    }
+    return true;
+}
+
+void IntraDecoderPool::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCond_.notify_all();
+    for (std::thread& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+
+    for (const std::shared_ptr<Job>& job : inFlight_) {
+        av_packet_free(&job->packet);
+    }
+    pending_.clear();
+    inFlight_.clear();
+
+    for (AVCodecContext*& ctx : decoders_) {
+        avcodec_free_context(&ctx);
+    }
+    decoders_.clear();
+    onDecoded_ = nullptr;
+}
+
+bool IntraDecoderPool::submit(const AVPacket* packet, int64_t frameNumber, FramePool::Handle slot) {
+    if (threads_.empty() || !slot || !slot->avFrame) {
+        return false;
+    }
+    auto job = std::make_shared<Job>();
+    job->packet = av_packet_clone(packet);
+    if (!job->packet) {
+        return false;
+    }
+    job->frameNumber = frameNumber;
+    job->slot = std::move(slot);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(job);
+        inFlight_.push_back(job);
+    }
+    workCond_.notify_one();
+    return true;
+}
+
+size_t IntraDecoderPool::inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inFlight_.size();
+}
+
+bool IntraDecoderPool::retire(Result& result) {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inFlight_.empty() || !inFlight_.front()->done) {
+            return false;
+        }
+        job = std::move(inFlight_.front());
+        inFlight_.pop_front();
+    }
+    result.frameNumber = job->frameNumber;
+    result.slot = std::move(job->slot);
+    result.ok = job->ok;
+    result.decodeSeconds = job->decodeSeconds;
+    return true;
+}
+
+void IntraDecoderPool::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Packets no worker has taken are just dropped
+    for (const std::shared_ptr<Job>& job : pending_) {
+        av_packet_free(&job->packet);
+        job->done = true;
+    }
+    pending_.clear();
+    doneCond_.wait(lock, [this] {
+        for (const std::shared_ptr<Job>& job : inFlight_) {
+            if (!job->done) {
+                return false;
+            }
+        }
+        return true;
+    });
+    inFlight_.clear();  // Returns the slots to the pool
+}
+
+void IntraDecoderPool::workerFunc(size_t worker) {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
+    FrameTracer::instance().setThreadName("decode.intra");
+    AVCodecContext* ctx = decoders_[worker];
+
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workCond_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+            if (stop_) {
+                return;
+            }
+            job = pending_.front();
+            pending_.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok;
+        {
+            FRAME_TRACE_SCOPE("decode.intra");
+            av_frame_unref(job->slot->avFrame);
+            // Intra frames come out of the packet that carries them
+            ok = avcodec_send_packet(ctx, job->packet) >= 0 &&
+                 avcodec_receive_frame(ctx, job->slot->avFrame) == 0;
+            if (!ok) {
+                avcodec_flush_buffers(ctx);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            av_packet_free(&job->packet);
+            job->ok = ok;
+            job->decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            job->done = true;
+        }
+        job.reset();  // A flush may be waiting to hand the slot back
+        doneCond_.notify_all();
+        if (onDecoded_) {
+            onDecoded_();
+        }
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,102 @@
+#ifndef VIDEOCOMPOSER_INTRADECODERPOOL_H
+#define VIDEOCOMPOSER_INTRADECODERPOOL_H
+
+#include "../video/FramePool.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace videocomposer {
+
+/**
+ * IntraDecoderPool - Several decoders of one intra-only stream
+ *
+ * ProRes, DNxHR or MJPEG frames do not reference each other, so
+ * consecutive packets can go to independent decoders. Each worker thread
+ * owns one decoder; submit() hands a packet to the next free one and
+ * retire() returns the frames in submission order, whichever worker
+ * finished first. One caller (the demuxing thread) submits and retires.
+ */
+class IntraDecoderPool {
+public:
+    struct Result {
+        int64_t frameNumber = -1;
+        FramePool::Handle slot;      // Holds the frame if ok
+        bool ok = false;
+        double decodeSeconds = 0.0;  // On its worker
+    };
+
+    IntraDecoderPool();
+    ~IntraDecoderPool();
+
+    IntraDecoderPool(const IntraDecoderPool&) = delete;
+    IntraDecoderPool& operator=(const IntraDecoderPool&) = delete;
+
+    /**
+     * Open one decoder per worker on the stream's parameters
+     * @param threadsPerDecoder Slice threads of each decoder
+     * @param onDecoded Called on a worker after each frame (wake the caller)
+     * @return false if a decoder cannot be opened
+     */
+    bool open(const AVCodecParameters* codecpar, int workers, int threadsPerDecoder,
+              std::function<void()> onDecoded = nullptr);
+    void close();
+
+    int getWorkers() const { return static_cast<int>(threads_.size()); }
+
+    /**
+     * Decode a packet into a pool slot (the packet is referenced, not taken)
+     * @return false if the pool is not open
+     */
+    bool submit(const AVPacket* packet, int64_t frameNumber, FramePool::Handle slot);
+
+    /** Frames submitted and not retired yet */
+    size_t inFlight() const;
+
+    /**
+     * Oldest submitted frame, once its worker is done with it
+     * @return false if it is still decoding (or nothing is in flight)
+     */
+    bool retire(Result& result);
+
+    /**
+     * Drop everything in flight (waits for the frames being decoded)
+     */
+    void flush();
+
+private:
+    struct Job {
+        AVPacket* packet = nullptr;
+        int64_t frameNumber = -1;
+        FramePool::Handle slot;
+        bool done = false;
+        bool ok = false;
+        double decodeSeconds = 0.0;
+    };
+
+    void workerFunc(size_t worker);
+
+    std::vector<AVCodecContext*> decoders_;
+    std::vector<std::thread> threads_;
+    std::function<void()> onDecoded_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCond_;  // Jobs pending or stop
+    std::condition_variable doneCond_;  // A job finished (flush)
+    std::deque<std::shared_ptr<Job>> pending_;   // Not picked up by a worker yet
+    std::deque<std::shared_ptr<Job>> inFlight_;  // Submission order, pending included
+    bool stop_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_INTRADECODERPOOL_H
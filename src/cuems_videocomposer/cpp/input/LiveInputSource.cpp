@@ -1,5 +1,6 @@
 #include "LiveInputSource.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
 #include <algorithm>
 #include <utility>
 
@@ -7,13 +8,20 @@ namespace videocomposer {
 
 LiveInputSource::LiveInputSource()
     : running_(false)
-    , bufferSize_(3)
-    , writeIndex_(0)
-    , readIndex_(0)
-    , availableFrames_(0)
+    , published_(2)
+    , waiters_(0)
+    , framesCaptured_(0)
+    , framesDropped_(0)
+    , captureErrors_(0)
+    , framesDelivered_(0)
+    , framesRepeated_(0)
+    , sourceBufferedFrames_(0)
+    , avgCaptureTimeMs_(0.0)
+    , lastCaptureTimeMs_(0.0)
+    , avgLatencyMs_(0.0)
+    , lastLatencyMs_(0.0)
     , consecutiveErrors_(0)
 {
-    frameBuffer_.resize(bufferSize_);
     lastStatLogTime_ = std::chrono::steady_clock::now();
 }
 
@@ -21,36 +29,21 @@ LiveInputSource::~LiveInputSource() {
     stopCaptureThread();
 }
 
-void LiveInputSource::setBufferSize(int frames) {
-    if (frames < 1) frames = 1;
-    if (frames > 30) frames = 30;  // Reasonable limit
-    
-    if (running_) {
-        LOG_WARNING << getSourceTypeName() << ": Cannot change buffer size while running";
-        return;
-    }
-    
-    bufferSize_ = frames;
-    frameBuffer_.resize(bufferSize_);
-    LOG_INFO << getSourceTypeName() << ": Buffer size set to " << bufferSize_ << " frames";
-}
-
 void LiveInputSource::startCaptureThread() {
     if (running_) {
         return;  // Already running
     }
 
-    // Reset state
-    writeIndex_ = 0;
-    readIndex_ = 0;
-    availableFrames_ = 0;
+    // Reset state (buffers keep their storage for reuse, but nothing is fresh)
+    back_ = 0;
+    front_ = 1;
+    published_ = 2;
     consecutiveErrors_ = 0;
     resetStatistics();
-    frameBuffer_.resize(bufferSize_);
 
     running_ = true;
     captureThread_ = std::thread(&LiveInputSource::captureLoop, this);
-    LOG_INFO << getSourceTypeName() << ": Capture thread started (buffer: " << bufferSize_ << " frames)";
+    LOG_INFO << getSourceTypeName() << ": Capture thread started";
 }
 
 void LiveInputSource::stopCaptureThread() {
@@ -59,7 +52,10 @@ void LiveInputSource::stopCaptureThread() {
     }
 
     running_ = false;
-    frameAvailable_.notify_all();  // Wake up thread if waiting
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+    }
+    frameAvailable_.notify_all();  // Wake up a waiting reader
 
     if (captureThread_.joinable()) {
         captureThread_.join();
@@ -75,51 +71,43 @@ void LiveInputSource::stopCaptureThread() {
 }
 
 void LiveInputSource::captureLoop() {
-    FrameBuffer tempBuffer;
-
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
     while (running_) {
         auto captureStart = std::chrono::steady_clock::now();
+        hasReceiveTime_ = false;
         
-        // Capture frame from source (implemented by subclass)
-        if (captureFrame(tempBuffer)) {
+        // Capture frame from source (implemented by subclass) into the back buffer
+        if (captureFrame(buffers_[back_])) {
             auto captureEnd = std::chrono::steady_clock::now();
             double captureTimeMs = std::chrono::duration<double, std::milli>(captureEnd - captureStart).count();
+            receiveTimes_[back_] = hasReceiveTime_ ? receiveTime_ : captureStart;
             
             // Reset error count on success
             consecutiveErrors_ = 0;
             
-            // Add to circular buffer using move semantics
-            {
-                std::lock_guard<std::mutex> lock(bufferMutex_);
-                int idx = writeIndex_.load() % bufferSize_;
-                
-                // Check if we're overwriting an unread frame
-                if (availableFrames_.load() >= bufferSize_) {
-                    std::lock_guard<std::mutex> statsLock(statsMutex_);
-                    stats_.framesDropped++;
-                } else {
-                    availableFrames_++;
-                }
-                
-                // Move frame into buffer (avoids copy)
-                frameBuffer_[idx].swap(tempBuffer);
-                writeIndex_++;
-                
-                // Update statistics
-                {
-                    std::lock_guard<std::mutex> statsLock(statsMutex_);
-                    stats_.framesCaptured++;
-                    stats_.lastCaptureTimeMs = captureTimeMs;
-                    // Running average
-                    if (stats_.framesCaptured == 1) {
-                        stats_.avgCaptureTimeMs = captureTimeMs;
-                    } else {
-                        stats_.avgCaptureTimeMs = stats_.avgCaptureTimeMs * 0.95 + captureTimeMs * 0.05;
-                    }
-                }
+            // Publish: the back buffer becomes the fresh frame, the previous
+            // published buffer becomes the next back buffer
+            int previous = published_.exchange(back_ | FRESH_BIT);
+            back_ = previous & INDEX_MASK;
+            if (previous & FRESH_BIT) {
+                framesDropped_.fetch_add(1, std::memory_order_relaxed);  // Never read
+            }
+            if (waiters_.load() > 0) {
+                std::lock_guard<std::mutex> lock(waitMutex_);
             }
             frameAvailable_.notify_one();
             
+            // Update statistics
+            uint64_t captured = framesCaptured_.fetch_add(1, std::memory_order_relaxed) + 1;
+            lastCaptureTimeMs_.store(captureTimeMs, std::memory_order_relaxed);
+            // Running average
+            if (captured == 1) {
+                avgCaptureTimeMs_.store(captureTimeMs, std::memory_order_relaxed);
+            } else {
+                double avg = avgCaptureTimeMs_.load(std::memory_order_relaxed);
+                avgCaptureTimeMs_.store(avg * 0.95 + captureTimeMs * 0.05, std::memory_order_relaxed);
+            }
+            
             // Periodic statistics logging (every 30 seconds)
             auto now = std::chrono::steady_clock::now();
             if (std::chrono::duration_cast<std::chrono::seconds>(now - lastStatLogTime_).count() >= 30) {
@@ -127,17 +115,15 @@ void LiveInputSource::captureLoop() {
                 LOG_INFO << getSourceTypeName() << ": "
                          << stats.framesCaptured << " frames, "
                          << stats.framesDropped << " dropped, "
-                         << "avg capture: " << stats.avgCaptureTimeMs << "ms";
+                         << stats.framesRepeated << " repeated, "
+                         << "avg capture: " << stats.avgCaptureTimeMs << "ms, "
+                         << "latency: " << stats.avgLatencyMs << "ms";
                 lastStatLogTime_ = now;
             }
         } else {
             // Capture failed
             consecutiveErrors_++;
-            
-            {
-                std::lock_guard<std::mutex> statsLock(statsMutex_);
-                stats_.captureErrors++;
-            }
+            uint64_t errors = captureErrors_.fetch_add(1, std::memory_order_relaxed) + 1;
             
             // Log warning periodically, not every error
             if (consecutiveErrors_ == ERROR_LOG_THRESHOLD) {
@@ -145,7 +131,7 @@ void LiveInputSource::captureLoop() {
                            << " consecutive capture errors";
             } else if (consecutiveErrors_ > 0 && consecutiveErrors_ % (ERROR_LOG_THRESHOLD * 10) == 0) {
                 LOG_WARNING << getSourceTypeName() << ": " << consecutiveErrors_ 
-                           << " consecutive capture errors (total: " << stats_.captureErrors << ")";
+                           << " consecutive capture errors (total: " << errors << ")";
             }
             
             // Small delay to avoid busy-waiting on continuous failure
@@ -155,35 +141,31 @@ void LiveInputSource::captureLoop() {
 }
 
 bool LiveInputSource::readLatestFrame(FrameBuffer& buffer) {
-    std::unique_lock<std::mutex> lock(bufferMutex_);
-    
     // Wait for frame with timeout
-    if (availableFrames_.load() == 0) {
-        // Wait up to 100ms for a frame
-        bool gotFrame = frameAvailable_.wait_for(lock, std::chrono::milliseconds(100),
-            [this] { return availableFrames_.load() > 0 || !running_; });
-        
-        if (!gotFrame || availableFrames_.load() == 0) {
+    if (!(published_.load() & FRESH_BIT)) {
+        waiters_++;
+        {
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            // Wait up to 100ms for a frame
+            frameAvailable_.wait_for(lock, std::chrono::milliseconds(100),
+                [this] { return (published_.load() & FRESH_BIT) || !running_; });
+        }
+        waiters_--;
+        if (!(published_.load() & FRESH_BIT)) {
             return false;  // Timeout or stopped
         }
     }
 
-    // Get latest frame (most recent write)
-    int idx = (writeIndex_.load() - 1) % bufferSize_;
-    if (idx < 0) idx += bufferSize_;  // Handle wrap
-    
-    // Copy the frame (we keep buffer intact for possible re-reads)
-    buffer = frameBuffer_[idx];
-    
-    // Mark all frames as consumed (we only care about latest)
-    availableFrames_ = 0;
-    readIndex_ = writeIndex_.load();
-    
-    {
-        std::lock_guard<std::mutex> statsLock(statsMutex_);
-        stats_.framesDelivered++;
-    }
+    // Take the fresh frame; our previous buffer goes back to be published over
+    front_ = published_.exchange(front_) & INDEX_MASK;
+    buffer.swap(buffers_[front_]);
     
+    double latencyMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - receiveTimes_[front_]).count();
+    uint64_t delivered = framesDelivered_.fetch_add(1, std::memory_order_relaxed) + 1;
+    lastLatencyMs_.store(latencyMs, std::memory_order_relaxed);
+    double avg = avgLatencyMs_.load(std::memory_order_relaxed);
+    avgLatencyMs_.store(delivered == 1 ? latencyMs : avg * 0.95 + latencyMs * 0.05, std::memory_order_relaxed);
     return true;
 }
 
@@ -194,21 +176,38 @@ bool LiveInputSource::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
 }
 
 bool LiveInputSource::isBufferEmpty() const {
-    return availableFrames_.load() == 0;
+    return !(published_.load() & FRESH_BIT);
 }
 
 int LiveInputSource::getBufferedFrameCount() const {
-    return availableFrames_.load();
+    return (isBufferEmpty() ? 0 : 1) + sourceBufferedFrames_.load(std::memory_order_relaxed);
 }
 
 LiveInputSource::Statistics LiveInputSource::getStatistics() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    Statistics stats;
+    stats.framesCaptured = framesCaptured_.load(std::memory_order_relaxed);
+    stats.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+    stats.captureErrors = captureErrors_.load(std::memory_order_relaxed);
+    stats.framesDelivered = framesDelivered_.load(std::memory_order_relaxed);
+    stats.framesRepeated = framesRepeated_.load(std::memory_order_relaxed);
+    stats.bufferedFrames = getBufferedFrameCount();
+    stats.avgCaptureTimeMs = avgCaptureTimeMs_.load(std::memory_order_relaxed);
+    stats.lastCaptureTimeMs = lastCaptureTimeMs_.load(std::memory_order_relaxed);
+    stats.avgLatencyMs = avgLatencyMs_.load(std::memory_order_relaxed);
+    stats.lastLatencyMs = lastLatencyMs_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 void LiveInputSource::resetStatistics() {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    stats_ = Statistics{};
+    framesCaptured_ = 0;
+    framesDropped_ = 0;
+    captureErrors_ = 0;
+    framesDelivered_ = 0;
+    framesRepeated_ = 0;
+    avgCaptureTimeMs_ = 0.0;
+    lastCaptureTimeMs_ = 0.0;
+    avgLatencyMs_ = 0.0;
+    lastLatencyMs_ = 0.0;
     lastStatLogTime_ = std::chrono::steady_clock::now();
 }
 
@@ -7,7 +7,6 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
-#include <vector>
 #include <cstdint>
 #include <chrono>
 
@@ -16,12 +15,14 @@ namespace videocomposer {
 /**
  * LiveInputSource - Base class for live input sources (NDI, V4L2, RTSP, etc.)
  * 
- * Provides async frame capture with buffering to prevent frame drops.
+ * Provides async frame capture so a slow render never stalls the source.
  * Live streams cannot seek, so they continuously capture frames in a background thread.
  * 
  * Features:
- * - Circular frame buffer with configurable size
- * - Move semantics for efficient frame handling
+ * - Triple buffer: the capture thread and the reader exchange whole
+ *   FrameBuffers through one atomic index, never copying pixels
+ * - Only the newest frame is kept; frames replaced before they were read
+ *   count as dropped
  * - Statistics tracking (frames captured, dropped, errors)
  * - Automatic error logging with threshold
  */
@@ -34,22 +35,33 @@ public:
     bool isLiveStream() const override { return true; }
     bool seek(int64_t frameNumber) override { return false; }  // No seeking for live streams
     bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override;
+
+    /**
+     * Take the newest captured frame
+     *
+     * The frame is swapped into buffer: the caller's previous storage goes
+     * back to the capture thread for reuse (one read later, so whatever the
+     * caller still does with last frame's pixels stays valid until then).
+     * Waits up to 100ms when no new frame has arrived since the last read.
+     */
     bool readLatestFrame(FrameBuffer& buffer) override;
 
-    // Live stream specific - buffer management
-    void setBufferSize(int frames);
-    int getBufferSize() const { return bufferSize_; }
+    // Live stream specific - buffer state
     bool isBufferEmpty() const;
-    int getBufferedFrameCount() const;
+    int getBufferedFrameCount() const;  // 0 or 1, plus frames the source buffers itself
 
     // Statistics
     struct Statistics {
         uint64_t framesCaptured = 0;     // Total frames captured
-        uint64_t framesDropped = 0;      // Frames overwritten before read
+        uint64_t framesDropped = 0;      // Frames replaced by a newer one before read
         uint64_t captureErrors = 0;      // captureFrame() failures
         uint64_t framesDelivered = 0;    // Frames returned via readLatestFrame
+        uint64_t framesRepeated = 0;     // Frame periods the source had nothing new (jitter underruns)
+        int bufferedFrames = 0;          // Frames waiting in the source's own buffer and the exchange
         double avgCaptureTimeMs = 0.0;   // Average capture time
         double lastCaptureTimeMs = 0.0;  // Last capture time
+        double avgLatencyMs = 0.0;       // Average time from receive to readLatestFrame
+        double lastLatencyMs = 0.0;      // Latency of the last delivered frame
     };
     Statistics getStatistics() const;
     void resetStatistics();
@@ -65,24 +77,54 @@ protected:
     // Subclass can override to get name for logging
     virtual const char* getSourceTypeName() const { return "LiveInput"; }
 
+    /**
+     * Called from captureFrame(): when the frame being captured was received
+     * (defaults to the start of the captureFrame() call). Latency statistics
+     * run from here to readLatestFrame().
+     */
+    void setFrameReceiveTime(std::chrono::steady_clock::time_point time) { receiveTime_ = time; hasReceiveTime_ = true; }
+
+    // For sources with their own buffering (jitter buffers)
+    void setSourceBufferedFrames(int frames) { sourceBufferedFrames_.store(frames, std::memory_order_relaxed); }
+    void addDroppedFrames(uint64_t frames) { framesDropped_.fetch_add(frames, std::memory_order_relaxed); }
+    void addRepeatedFrames(uint64_t frames) { framesRepeated_.fetch_add(frames, std::memory_order_relaxed); }
+
 private:
     void captureLoop();  // Runs in dedicated thread
 
     std::thread captureThread_;
     std::atomic<bool> running_;
 
-    // Frame buffer (circular)
-    std::vector<FrameBuffer> frameBuffer_;
-    int bufferSize_ = 3;  // Default: 3 frames
-    std::atomic<int> writeIndex_;
-    std::atomic<int> readIndex_;
-    std::atomic<int> availableFrames_;  // Frames available for reading
-    std::mutex bufferMutex_;
+    // Triple buffer: the capture thread owns buffers_[back_], the reader
+    // buffers_[front_], and the third (published) one is exchanged through
+    // published_ = index | FRESH_BIT. FRESH_BIT is set while the published
+    // frame has not been read.
+    static constexpr int FRESH_BIT = 4;
+    static constexpr int INDEX_MASK = 3;
+    FrameBuffer buffers_[3];
+    std::chrono::steady_clock::time_point receiveTimes_[3];  // Travel with buffers_
+    std::chrono::steady_clock::time_point receiveTime_;      // Capture thread only
+    bool hasReceiveTime_ = false;
+    int back_ = 0;                 // Capture thread only
+    int front_ = 1;                // Reader only
+    std::atomic<int> published_;
+
+    // Only taken when the reader has to wait for a frame
+    std::atomic<int> waiters_;
+    std::mutex waitMutex_;
     std::condition_variable frameAvailable_;
 
-    // Statistics (protected by statsMutex_)
-    mutable std::mutex statsMutex_;
-    Statistics stats_;
+    // Statistics (written without locks; getStatistics() reads a snapshot)
+    std::atomic<uint64_t> framesCaptured_;
+    std::atomic<uint64_t> framesDropped_;
+    std::atomic<uint64_t> captureErrors_;
+    std::atomic<uint64_t> framesDelivered_;
+    std::atomic<uint64_t> framesRepeated_;
+    std::atomic<int> sourceBufferedFrames_;
+    std::atomic<double> avgCaptureTimeMs_;
+    std::atomic<double> lastCaptureTimeMs_;
+    std::atomic<double> avgLatencyMs_;
+    std::atomic<double> lastLatencyMs_;
     std::chrono::steady_clock::time_point lastStatLogTime_;
     
     // Error tracking
@@ -0,0 +1,119 @@
+#include "LiveJitterBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+// Share of the gap to a slower arrival that base_ follows per frame
+static constexpr double BASE_DRIFT = 0.01;
+
+LiveJitterBuffer::LiveJitterBuffer(double targetLatency)
+    : target_(targetLatency > 0.0 ? targetLatency : 0.0)
+{
+}
+
+bool LiveJitterBuffer::push(double pts, double received, FrameBuffer& frame) {
+    double transit = received - pts;
+    if (hasBase_ && std::abs(transit - base_) > RESYNC_SECONDS) {
+        // Stream restarted or timestamps jumped: queued frames belong to the old timeline
+        while (!entries_.empty()) {
+            recycle(entries_.front().frame);
+            entries_.pop_front();
+            ++dropped_;
+        }
+        hasBase_ = false;
+        hasReleased_ = false;
+    }
+    if (!hasBase_ || transit < base_) {
+        base_ = transit;
+        hasBase_ = true;
+    } else {
+        base_ += (transit - base_) * BASE_DRIFT;
+    }
+
+    if (hasReleased_ && pts <= lastPts_) {
+        ++dropped_;  // Reordered or duplicated behind what was already shown
+        return false;
+    }
+    auto pos = entries_.end();
+    while (pos != entries_.begin() && std::prev(pos)->pts > pts) {
+        --pos;
+    }
+    if (pos != entries_.begin() && std::prev(pos)->pts == pts) {
+        ++dropped_;
+        return false;
+    }
+
+    pos = entries_.insert(pos, Entry{pts, received, FrameBuffer()});
+    pos->frame.swap(frame);
+    if (!spare_.empty()) {
+        frame.swap(spare_.back());
+        spare_.pop_back();
+    }
+
+    while (entries_.size() > MAX_FRAMES) {
+        recycle(entries_.front().frame);
+        entries_.pop_front();
+        ++dropped_;
+    }
+    return true;
+}
+
+bool LiveJitterBuffer::pop(double now, FrameBuffer& frame, double* received) {
+    size_t due = 0;
+    while (due < entries_.size() && dueTime(entries_[due].pts) <= now) {
+        ++due;
+    }
+    if (due == 0) {
+        if (hasReleased_ && framePeriod_ > 0.0) {
+            while (now >= nextExpected_ + framePeriod_ * 0.5) {
+                ++repeated_;
+                nextExpected_ += framePeriod_;
+            }
+        }
+        return false;
+    }
+
+    // Behind schedule: skip to the newest due frame
+    for (; due > 1; --due) {
+        recycle(entries_.front().frame);
+        entries_.pop_front();
+        ++dropped_;
+    }
+
+    Entry& entry = entries_.front();
+    frame.swap(entry.frame);
+    recycle(entry.frame);
+    if (received) {
+        *received = entry.received;
+    }
+    lastPts_ = entry.pts;
+    nextExpected_ = std::max(now, dueTime(entry.pts)) + framePeriod_;
+    hasReleased_ = true;
+    entries_.pop_front();
+    return true;
+}
+
+double LiveJitterBuffer::nextDueTime() const {
+    return entries_.empty() ? -1.0 : dueTime(entries_.front().pts);
+}
+
+void LiveJitterBuffer::reset() {
+    while (!entries_.empty()) {
+        recycle(entries_.front().frame);
+        entries_.pop_front();
+    }
+    hasBase_ = false;
+    hasReleased_ = false;
+    dropped_ = 0;
+    repeated_ = 0;
+}
+
+void LiveJitterBuffer::recycle(FrameBuffer& frame) {
+    if (frame.isValid() && spare_.size() < MAX_FRAMES) {
+        spare_.emplace_back();
+        spare_.back().swap(frame);
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,95 @@
+#ifndef VIDEOCOMPOSER_LIVEJITTERBUFFER_H
+#define VIDEOCOMPOSER_LIVEJITTERBUFFER_H
+
+#include "../video/FrameBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * LiveJitterBuffer - Timestamp-paced release of frames from a network stream
+ *
+ * A frame is due targetLatency after it would have arrived over the
+ * fastest path seen so far: due = pts + base + target, where base tracks
+ * the minimum (arrival - pts) and follows slow clock drift upwards.
+ * Network jitter below the target is absorbed; a frame that arrives late
+ * is released at once. When several frames are due together (after a
+ * stall) only the newest is released and the rest are dropped, which
+ * brings latency back to the target. A frame period with nothing to
+ * release counts as a repeat (the reader keeps showing the last frame).
+ *
+ * Times are seconds: pts on the stream clock, everything else on a local
+ * monotonic clock. Not thread-safe: the owner locks around it.
+ */
+class LiveJitterBuffer {
+public:
+    static constexpr size_t MAX_FRAMES = 16;       // Oldest frames are dropped beyond this
+    static constexpr double RESYNC_SECONDS = 1.0;  // Timestamp jumps larger than this restart pacing
+
+    explicit LiveJitterBuffer(double targetLatency = 0.1);
+
+    void setTargetLatency(double seconds) { target_ = seconds > 0.0 ? seconds : 0.0; }
+    double targetLatency() const { return target_; }
+
+    /** Nominal frame period, used to count repeats (0 = don't count) */
+    void setFramePeriod(double seconds) { framePeriod_ = seconds > 0.0 ? seconds : 0.0; }
+
+    /**
+     * Queue a decoded frame
+     *
+     * The frame is swapped in; frame gets recycled storage (or an empty
+     * buffer) back.
+     * @param received Local time its packet arrived
+     * @return false if it was dropped (older than the last released frame)
+     */
+    bool push(double pts, double received, FrameBuffer& frame);
+
+    /**
+     * Release the newest frame that is due at now
+     *
+     * Older due frames are dropped. The caller's storage is recycled.
+     * @param received Set to the released frame's arrival time
+     * @return false when nothing is due yet
+     */
+    bool pop(double now, FrameBuffer& frame, double* received = nullptr);
+
+    /** Local time the oldest queued frame is due (-1 when empty) */
+    double nextDueTime() const;
+
+    size_t depth() const { return entries_.size(); }
+    uint64_t droppedFrames() const { return dropped_; }
+    uint64_t repeatedFrames() const { return repeated_; }
+
+    void reset();
+
+private:
+    struct Entry {
+        double pts;
+        double received;
+        FrameBuffer frame;
+    };
+
+    double dueTime(double pts) const { return pts + base_ + target_; }
+    void recycle(FrameBuffer& frame);
+
+    std::deque<Entry> entries_;       // Ordered by pts
+    std::vector<FrameBuffer> spare_;  // Storage for the next push()
+    double target_;
+    double framePeriod_ = 0.0;
+
+    bool hasBase_ = false;
+    double base_ = 0.0;               // Fastest (received - pts) seen, drifting up
+    bool hasReleased_ = false;
+    double lastPts_ = 0.0;            // Released last
+    double nextExpected_ = 0.0;       // When the next frame should be released
+
+    uint64_t dropped_ = 0;
+    uint64_t repeated_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LIVEJITTERBUFFER_H
@@ -0,0 +1,152 @@
+#include "MediaProbe.h"
+#include "../utils/Logger.h"
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+// FF_PROFILE_UNKNOWN/FF_LEVEL_UNKNOWN, renamed AV_* in FFmpeg 6.1
+constexpr int UNKNOWN_PROFILE = -99;
+constexpr int UNKNOWN_LEVEL = -99;
+
+void storeRational(const AVRational& value, int64_t* out) {
+    out[0] = value.num;
+    out[1] = value.den;
+}
+
+AVRational loadRational(const int64_t* in) {
+    return AVRational{static_cast<int>(in[0]), static_cast<int>(in[1])};
+}
+
+bool unset(const AVRational& value) {
+    return value.num == 0 || value.den == 0;
+}
+
+} // namespace
+
+bool MediaProbe::capture(const AVFormatContext* formatCtx, int streamIndex, FrameIndexCache::Probe& probe) {
+    if (!formatCtx || !formatCtx->iformat || streamIndex < 0 ||
+        static_cast<unsigned int>(streamIndex) >= formatCtx->nb_streams) {
+        return false;
+    }
+    const AVStream* stream = formatCtx->streams[streamIndex];
+    const AVCodecParameters* par = stream->codecpar;
+    if (par->codec_type != AVMEDIA_TYPE_VIDEO) {
+        return false;
+    }
+
+    probe = FrameIndexCache::Probe();
+    probe.formatName = formatCtx->iformat->name;
+    probe.streamIndex = streamIndex;
+    probe.codecId = par->codec_id;
+    probe.codecTag = par->codec_tag;
+    probe.pixelFormat = par->format;
+    probe.width = par->width;
+    probe.height = par->height;
+    probe.profile = par->profile;
+    probe.level = par->level;
+    probe.fieldOrder = par->field_order;
+    probe.colorRange = par->color_range;
+    probe.colorPrimaries = par->color_primaries;
+    probe.colorTrc = par->color_trc;
+    probe.colorSpace = par->color_space;
+    probe.chromaLocation = par->chroma_location;
+    probe.bitsPerRawSample = par->bits_per_raw_sample;
+    probe.bitRate = par->bit_rate;
+    storeRational(par->sample_aspect_ratio, probe.sampleAspect);
+    storeRational(stream->time_base, probe.timeBase);
+    storeRational(stream->r_frame_rate, probe.frameRate);
+    storeRational(stream->avg_frame_rate, probe.avgFrameRate);
+    probe.startTime = stream->start_time;
+    probe.duration = stream->duration;
+    probe.frames = stream->nb_frames;
+    probe.formatStartTime = formatCtx->start_time;
+    probe.formatDuration = formatCtx->duration;
+    probe.formatBitRate = formatCtx->bit_rate;
+    if (par->extradata && par->extradata_size > 0) {
+        probe.extradata.assign(par->extradata, par->extradata + par->extradata_size);
+    }
+    // Without these the decoder could not be set up from the probe alone
+    return probe.codecId != AV_CODEC_ID_NONE && probe.width > 0 && probe.height > 0 &&
+           probe.pixelFormat >= 0;
+}
+
+const AVInputFormat* MediaProbe::inputFormat(const FrameIndexCache::Probe& probe) {
+    if (probe.formatName.empty()) {
+        return nullptr;
+    }
+    // iformat->name may list aliases ("mov,mp4,m4a,..."); any of them finds it
+    std::string first = probe.formatName.substr(0, probe.formatName.find(','));
+    return av_find_input_format(first.c_str());
+}
+
+bool MediaProbe::apply(AVFormatContext* formatCtx, const FrameIndexCache::Probe& probe) {
+    if (!formatCtx || !formatCtx->iformat || probe.formatName != formatCtx->iformat->name) {
+        return false;
+    }
+    // Streams that only appear while packets are read are not there yet
+    if (formatCtx->ctx_flags & AVFMTCTX_NOHEADER) {
+        return false;
+    }
+    if (probe.streamIndex < 0 || probe.streamIndex >= static_cast<int64_t>(formatCtx->nb_streams)) {
+        return false;
+    }
+    AVStream* stream = formatCtx->streams[probe.streamIndex];
+    AVCodecParameters* par = stream->codecpar;
+    if (par->codec_type != AVMEDIA_TYPE_VIDEO || par->codec_id != static_cast<AVCodecID>(probe.codecId)) {
+        return false;
+    }
+    if ((par->width > 0 && par->width != probe.width) || (par->height > 0 && par->height != probe.height)) {
+        return false;
+    }
+
+    // The header wins where it has a value; the probe fills the rest
+    if (par->format < 0) par->format = static_cast<int>(probe.pixelFormat);
+    if (par->width <= 0) par->width = static_cast<int>(probe.width);
+    if (par->height <= 0) par->height = static_cast<int>(probe.height);
+    if (par->codec_tag == 0) par->codec_tag = static_cast<uint32_t>(probe.codecTag);
+    if (par->profile == UNKNOWN_PROFILE) par->profile = static_cast<int>(probe.profile);
+    if (par->level == UNKNOWN_LEVEL) par->level = static_cast<int>(probe.level);
+    if (par->field_order == AV_FIELD_UNKNOWN) par->field_order = static_cast<AVFieldOrder>(probe.fieldOrder);
+    if (par->color_range == AVCOL_RANGE_UNSPECIFIED) par->color_range = static_cast<AVColorRange>(probe.colorRange);
+    if (par->color_primaries == AVCOL_PRI_UNSPECIFIED) par->color_primaries = static_cast<AVColorPrimaries>(probe.colorPrimaries);
+    if (par->color_trc == AVCOL_TRC_UNSPECIFIED) par->color_trc = static_cast<AVColorTransferCharacteristic>(probe.colorTrc);
+    if (par->color_space == AVCOL_SPC_UNSPECIFIED) par->color_space = static_cast<AVColorSpace>(probe.colorSpace);
+    if (par->chroma_location == AVCHROMA_LOC_UNSPECIFIED) par->chroma_location = static_cast<AVChromaLocation>(probe.chromaLocation);
+    if (par->bits_per_raw_sample == 0) par->bits_per_raw_sample = static_cast<int>(probe.bitsPerRawSample);
+    if (par->bit_rate == 0) par->bit_rate = probe.bitRate;
+    if (unset(par->sample_aspect_ratio)) par->sample_aspect_ratio = loadRational(probe.sampleAspect);
+
+    if ((!par->extradata || par->extradata_size == 0) && !probe.extradata.empty()) {
+        uint8_t* extradata = static_cast<uint8_t*>(av_mallocz(probe.extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+        if (!extradata) {
+            return false;
+        }
+        memcpy(extradata, probe.extradata.data(), probe.extradata.size());
+        av_freep(&par->extradata);
+        par->extradata = extradata;
+        par->extradata_size = static_cast<int>(probe.extradata.size());
+    }
+
+    if (unset(stream->time_base)) stream->time_base = loadRational(probe.timeBase);
+    if (unset(stream->r_frame_rate)) stream->r_frame_rate = loadRational(probe.frameRate);
+    if (unset(stream->avg_frame_rate)) stream->avg_frame_rate = loadRational(probe.avgFrameRate);
+    if (stream->start_time == AV_NOPTS_VALUE) stream->start_time = probe.startTime;
+    if (stream->duration == AV_NOPTS_VALUE) stream->duration = probe.duration;
+    if (stream->nb_frames == 0) stream->nb_frames = probe.frames;
+    if (formatCtx->start_time == AV_NOPTS_VALUE) formatCtx->start_time = probe.formatStartTime;
+    if (formatCtx->duration == AV_NOPTS_VALUE) formatCtx->duration = probe.formatDuration;
+    if (formatCtx->bit_rate == 0) formatCtx->bit_rate = probe.formatBitRate;
+
+    // Other streams are not decoded; the demuxer's own header values are enough
+    LOG_VERBOSE << "MediaProbe: Reused probe for stream " << probe.streamIndex << " ("
+                << probe.formatName << ")";
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,41 @@
+#ifndef VIDEOCOMPOSER_MEDIAPROBE_H
+#define VIDEOCOMPOSER_MEDIAPROBE_H
+
+#include "FrameIndexCache.h"
+
+struct AVFormatContext;
+struct AVInputFormat;
+
+namespace videocomposer {
+
+/**
+ * MediaProbe - Replays a cached avformat_find_stream_info result
+ *
+ * find_stream_info decodes frames of every stream to learn what the
+ * container header leaves out (pixel format, frame rate, extradata of
+ * some codecs), which is most of the time a cue load spends before the
+ * first frame. The result for the video stream is kept in the frame index
+ * cache; on the next open the demuxer is opened with the known input
+ * format and, when its header agrees with the probe, the cached values
+ * fill what the header did not set instead of probing again.
+ */
+class MediaProbe {
+public:
+    /** Record the probed state of a video stream */
+    static bool capture(const AVFormatContext* formatCtx, int streamIndex, FrameIndexCache::Probe& probe);
+
+    /** Input format named in a probe (nullptr lets FFmpeg detect it) */
+    static const AVInputFormat* inputFormat(const FrameIndexCache::Probe& probe);
+
+    /**
+     * Fill the fields of a freshly opened context that its header left unset
+     * @return false if the probe does not match the file as opened (or the
+     *         demuxer only creates streams while reading), so the caller
+     *         probes the usual way
+     */
+    static bool apply(AVFormatContext* formatCtx, const FrameIndexCache::Probe& probe);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_MEDIAPROBE_H
@@ -0,0 +1,335 @@
+#include "MosaicInput.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace videocomposer {
+
+namespace {
+
+bool isPacked4(PixelFormat format) {
+    return format == PixelFormat::RGBA32 || format == PixelFormat::BGRA32;
+}
+
+} // namespace
+
+bool MosaicInput::Manifest::parse(const std::string& path, Manifest& manifest) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        LOG_ERROR << "Mosaic: Cannot open manifest " << path;
+        return false;
+    }
+    std::string dir;
+    size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos) {
+        dir = path.substr(0, slash + 1);
+    }
+
+    manifest = Manifest();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+
+        std::istringstream in(line.substr(start));
+        std::string keyword;
+        in >> keyword;
+        if (keyword == "canvas") {
+            if (!(in >> manifest.width >> manifest.height) || manifest.width <= 0 || manifest.height <= 0) {
+                LOG_ERROR << "Mosaic: " << path << ":" << lineNumber << ": expected 'canvas <width> <height>'";
+                return false;
+            }
+        } else if (keyword == "tile") {
+            TileSpec tile;
+            std::string tilePath;
+            if (!(in >> tile.x >> tile.y) || tile.x < 0 || tile.y < 0) {
+                LOG_ERROR << "Mosaic: " << path << ":" << lineNumber << ": expected 'tile <x> <y> <path>'";
+                return false;
+            }
+            std::getline(in >> std::ws, tilePath);  // The rest of the line: paths may hold spaces
+            if (tilePath.empty()) {
+                LOG_ERROR << "Mosaic: " << path << ":" << lineNumber << ": tile without a path";
+                return false;
+            }
+            tile.path = tilePath[0] == '/' ? tilePath : dir + tilePath;
+            manifest.tiles.push_back(std::move(tile));
+        } else {
+            LOG_ERROR << "Mosaic: " << path << ":" << lineNumber << ": unknown keyword '" << keyword << "'";
+            return false;
+        }
+    }
+    if (manifest.tiles.empty()) {
+        LOG_ERROR << "Mosaic: " << path << " lists no tiles";
+        return false;
+    }
+    return true;
+}
+
+MosaicInput::MosaicInput() = default;
+
+MosaicInput::~MosaicInput() {
+    close();
+}
+
+bool MosaicInput::isMosaicPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || path.find('/', dot) != std::string::npos) {
+        return false;
+    }
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == "mosaic";
+}
+
+bool MosaicInput::open(const std::string& source) {
+    close();
+    if (!tileFactory_) {
+        LOG_ERROR << "Mosaic: No tile factory set";
+        return false;
+    }
+    Manifest manifest;
+    if (!Manifest::parse(source, manifest)) {
+        return false;
+    }
+
+    // Open every tile and check that they play as one clip
+    int width = 0;
+    int height = 0;
+    int64_t area = 0;
+    for (const TileSpec& spec : manifest.tiles) {
+        auto tile = std::make_unique<Tile>();
+        tile->spec = spec;
+        tile->input = tileFactory_(spec.path);
+        if (!tile->input || !tile->input->isReady()) {
+            LOG_ERROR << "Mosaic: Cannot open tile " << spec.path;
+            tiles_.clear();
+            return false;
+        }
+        FrameInfo info = tile->input->getFrameInfo();
+        if (!tiles_.empty()) {
+            const FrameInfo& first = frameInfo_;
+            if (std::abs(info.framerate - first.framerate) > 0.001) {
+                LOG_ERROR << "Mosaic: Tile " << spec.path << " runs at " << info.framerate << " fps, "
+                          << manifest.tiles[0].path << " at " << first.framerate;
+                tiles_.clear();
+                return false;
+            }
+            if (info.totalFrames != first.totalFrames) {
+                LOG_WARNING << "Mosaic: Tile " << spec.path << " has " << info.totalFrames
+                            << " frames, " << manifest.tiles[0].path << " " << first.totalFrames
+                            << "; playing the shortest";
+            }
+            frameInfo_.totalFrames = std::min(frameInfo_.totalFrames, info.totalFrames);
+            hasAlpha_ = hasAlpha_ || tile->input->hasAlpha();
+            instantSeek_ = instantSeek_ && tile->input->hasInstantSeek();
+        } else {
+            frameInfo_ = info;
+            codec_ = tile->input->detectCodec();
+            hasAlpha_ = tile->input->hasAlpha();
+            instantSeek_ = tile->input->hasInstantSeek();
+        }
+        for (const auto& other : tiles_) {
+            FrameInfo otherInfo = other->input->getFrameInfo();
+            if (spec.x < other->spec.x + otherInfo.width && other->spec.x < spec.x + info.width &&
+                spec.y < other->spec.y + otherInfo.height && other->spec.y < spec.y + info.height) {
+                LOG_ERROR << "Mosaic: Tiles " << other->spec.path << " and " << spec.path << " overlap";
+                tiles_.clear();
+                return false;
+            }
+        }
+        width = std::max(width, spec.x + info.width);
+        height = std::max(height, spec.y + info.height);
+        area += static_cast<int64_t>(info.width) * info.height;
+        tiles_.push_back(std::move(tile));
+    }
+
+    if (manifest.width > 0) {
+        if (width > manifest.width || height > manifest.height) {
+            LOG_ERROR << "Mosaic: Tiles span " << width << "x" << height << ", beyond the "
+                      << manifest.width << "x" << manifest.height << " canvas of " << source;
+            tiles_.clear();
+            return false;
+        }
+        width = manifest.width;
+        height = manifest.height;
+    }
+    frameInfo_.width = width;
+    frameInfo_.height = height;
+    frameInfo_.aspect = static_cast<float>(width) / static_cast<float>(height);
+    if (frameInfo_.framerate > 0.0) {
+        frameInfo_.duration = static_cast<double>(frameInfo_.totalFrames) / frameInfo_.framerate;
+    }
+    covered_ = area >= static_cast<int64_t>(width) * height;
+
+    for (auto& tile : tiles_) {
+        tile->worker = std::thread(&MosaicInput::workerLoop, this, std::ref(*tile));
+    }
+
+    // The first frame fixes the pixel format (decoders may convert on output)
+    jobFrame_ = 0;
+    runPhase(Phase::DECODE);
+    PixelFormat format = tiles_[0]->frame.info().format;
+    for (const auto& tile : tiles_) {
+        if (!tile->ok) {
+            LOG_ERROR << "Mosaic: Cannot decode the first frame of " << tile->spec.path;
+            close();
+            return false;
+        }
+        if (tile->frame.info().format != format || !isPacked4(format)) {
+            LOG_ERROR << "Mosaic: Tile " << tile->spec.path
+                      << " does not decode to the RGBA/BGRA format shared by all tiles";
+            close();
+            return false;
+        }
+    }
+    frameInfo_.format = format;
+
+    ready_ = true;
+    LOG_INFO << "Mosaic: " << source << " (" << width << "x" << height << ", " << tiles_.size()
+             << " tiles, " << frameInfo_.totalFrames << " frames)";
+    return true;
+}
+
+void MosaicInput::close() {
+    if (!tiles_.empty() && tiles_[0]->worker.joinable()) {
+        runPhase(Phase::STOP);
+        for (auto& tile : tiles_) {
+            tile->worker.join();
+        }
+    }
+    for (auto& tile : tiles_) {
+        if (tile->input) {
+            tile->input->close();
+        }
+    }
+    tiles_.clear();
+    ready_ = false;
+    currentFrame_ = -1;
+    frameInfo_ = FrameInfo();
+}
+
+bool MosaicInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
+    if (!ready_) {
+        return false;
+    }
+
+    jobFrame_ = frameNumber;
+    runPhase(Phase::DECODE);
+    for (const auto& tile : tiles_) {
+        if (!tile->ok) {
+            tornFrames_++;
+            LOG_VERBOSE << "Mosaic: Tile " << tile->spec.path << " missed frame " << frameNumber;
+            return false;  // Shown only when every tile has it
+        }
+    }
+
+    FrameInfo info = frameInfo_;
+    if (!buffer.ensureAllocated(info)) {
+        return false;
+    }
+    if (!covered_) {
+        memset(buffer.data(), 0, buffer.size());  // Gaps between tiles stay transparent
+    }
+    jobCanvas_ = &buffer;
+    runPhase(Phase::COPY);
+    jobCanvas_ = nullptr;
+    for (const auto& tile : tiles_) {
+        if (!tile->ok) {
+            return false;
+        }
+    }
+    currentFrame_ = frameNumber;
+    return true;
+}
+
+bool MosaicInput::seek(int64_t frameNumber) {
+    if (!ready_) {
+        return false;
+    }
+    bool ok = true;
+    for (auto& tile : tiles_) {
+        ok = tile->input->seek(frameNumber) && ok;
+    }
+    if (ok) {
+        currentFrame_ = frameNumber;
+    }
+    return ok;
+}
+
+void MosaicInput::resetSeekState() {
+    for (auto& tile : tiles_) {
+        tile->input->resetSeekState();
+    }
+}
+
+void MosaicInput::runPhase(Phase phase) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    phase_ = phase;
+    pending_ = tiles_.size();
+    generation_++;
+    workCond_.notify_all();
+    doneCond_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+void MosaicInput::workerLoop(Tile& tile) {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workCond_.wait(lock, [&]() { return generation_ != seen; });
+        seen = generation_;
+        Phase phase = phase_;
+        int64_t frameNumber = jobFrame_;
+        FrameBuffer* canvas = jobCanvas_;
+        lock.unlock();
+
+        if (phase == Phase::DECODE) {
+            // A decoder that lands on a neighbouring frame counts as a miss
+            tile.ok = tile.input->readFrame(frameNumber, tile.frame) &&
+                      tile.input->getCurrentFrame() == frameNumber;
+        } else if (phase == Phase::COPY) {
+            tile.ok = canvas && copyTile(tile, *canvas);
+        }
+
+        lock.lock();
+        if (--pending_ == 0) {
+            doneCond_.notify_one();
+        }
+        if (phase == Phase::STOP) {
+            return;
+        }
+    }
+}
+
+bool MosaicInput::copyTile(const Tile& tile, FrameBuffer& canvas) const {
+    const FrameInfo& info = tile.frame.info();
+    if (!tile.frame.isValid() || info.format != frameInfo_.format ||
+        tile.spec.x + info.width > frameInfo_.width || tile.spec.y + info.height > frameInfo_.height) {
+        LOG_WARNING << "Mosaic: Tile " << tile.spec.path << " changed geometry or format";
+        return false;
+    }
+    // Each tile writes only its own rectangle: the workers never overlap
+    const size_t rowBytes = static_cast<size_t>(info.width) * 4;
+    const size_t canvasStride = static_cast<size_t>(frameInfo_.width) * 4;
+    const uint8_t* src = tile.frame.data();
+    uint8_t* dst = canvas.data() + static_cast<size_t>(tile.spec.y) * canvasStride +
+                   static_cast<size_t>(tile.spec.x) * 4;
+    for (int row = 0; row < info.height; ++row) {
+        memcpy(dst, src, rowBytes);
+        src += rowBytes;
+        dst += canvasStride;
+    }
+    return true;
+}
+
+} // namespace videocomposer
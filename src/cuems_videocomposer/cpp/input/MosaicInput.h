@@ -0,0 +1,125 @@
+#ifndef VIDEOCOMPOSER_MOSAICINPUT_H
+#define VIDEOCOMPOSER_MOSAICINPUT_H
+
+#include "InputSource.h"
+#include "../video/FrameBuffer.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * MosaicInput - One clip split into tile files, played as a single layer
+ *
+ * Content larger than one decoder can handle (e.g. 16K walls) is encoded
+ * as a grid of tiles. Each tile has its own decoder and a worker thread;
+ * a frame is decoded on all tiles in parallel, and only when every tile
+ * produced the same frame number is it stitched into the canvas. A frame
+ * any tile misses is not shown (the layer keeps its previous frame), so
+ * tiles never tear against each other.
+ *
+ * The manifest (".mosaic") is a text file:
+ *   # comment
+ *   canvas <width> <height>      optional, default: bounding box of the tiles
+ *   tile <x> <y> <path>          path relative to the manifest's directory
+ *
+ * Tiles must share framerate and pixel format (4 bytes per pixel: RGBA32
+ * or BGRA32). The mosaic is as long as its shortest tile.
+ */
+class MosaicInput : public InputSource {
+public:
+    struct TileSpec {
+        int x = 0;
+        int y = 0;
+        std::string path;
+    };
+
+    struct Manifest {
+        int width = 0;   // 0 = bounding box of the tiles
+        int height = 0;
+        std::vector<TileSpec> tiles;
+
+        /**
+         * Read a manifest; tile paths come back resolved against its directory
+         */
+        static bool parse(const std::string& path, Manifest& manifest);
+    };
+
+    /** Opens one tile file (configured like any other clip of the show) */
+    using TileFactory = std::function<std::unique_ptr<InputSource>(const std::string& path)>;
+
+    MosaicInput();
+    ~MosaicInput() override;
+
+    /** Whether a path names a mosaic manifest (".mosaic") */
+    static bool isMosaicPath(const std::string& path);
+
+    // Applies to the next open()
+    void setTileFactory(TileFactory factory) { tileFactory_ = std::move(factory); }
+
+    // InputSource interface
+    bool open(const std::string& source) override;
+    void close() override;
+    bool isReady() const override { return ready_; }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override;
+    bool seek(int64_t frameNumber) override;
+    void resetSeekState() override;
+    FrameInfo getFrameInfo() const override { return frameInfo_; }
+    int64_t getCurrentFrame() const override { return currentFrame_; }
+    CodecType detectCodec() const override { return codec_; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+    bool hasAlpha() const override { return hasAlpha_; }
+    bool hasInstantSeek() const override { return instantSeek_; }
+
+    size_t getTileCount() const { return tiles_.size(); }
+
+    /** Frames dropped because the tiles did not all deliver them */
+    uint64_t getTornFrames() const { return tornFrames_; }
+
+private:
+    enum class Phase { DECODE, COPY, STOP };
+
+    struct Tile {
+        TileSpec spec;
+        std::unique_ptr<InputSource> input;
+        FrameBuffer frame;
+        bool ok = false;
+        std::thread worker;
+    };
+
+    void runPhase(Phase phase);  // On every tile's worker; returns when all are done
+    void workerLoop(Tile& tile);
+    bool copyTile(const Tile& tile, FrameBuffer& canvas) const;
+
+    TileFactory tileFactory_;
+    std::vector<std::unique_ptr<Tile>> tiles_;
+    FrameInfo frameInfo_;
+    CodecType codec_ = CodecType::SOFTWARE;
+    bool ready_ = false;
+    bool hasAlpha_ = false;
+    bool instantSeek_ = false;
+    bool covered_ = false;  // Tiles cover the whole canvas (no gaps to clear)
+    int64_t currentFrame_ = -1;
+    uint64_t tornFrames_ = 0;
+
+    // Work handed to the tile workers
+    std::mutex mutex_;
+    std::condition_variable workCond_;
+    std::condition_variable doneCond_;
+    Phase phase_ = Phase::DECODE;
+    uint64_t generation_ = 0;
+    size_t pending_ = 0;
+    int64_t jobFrame_ = 0;
+    FrameBuffer* jobCanvas_ = nullptr;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_MOSAICINPUT_H
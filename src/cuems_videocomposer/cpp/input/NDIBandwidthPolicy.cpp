@@ -0,0 +1,64 @@
+#include "NDIBandwidthPolicy.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+NDIBandwidthPolicy::NDIBandwidthPolicy()
+    : enabled_(true)
+    , sourceWidth_(0)
+    , sourceHeight_(0)
+    , proxyWidth_(0)
+    , proxyHeight_(0)
+    , current_(Bandwidth::HIGHEST)
+    , smallSince_(-1.0)
+{
+}
+
+void NDIBandwidthPolicy::setSourceSize(int width, int height) {
+    sourceWidth_ = std::max(width, 0);
+    sourceHeight_ = std::max(height, 0);
+}
+
+void NDIBandwidthPolicy::setProxySize(int width, int height) {
+    proxyWidth_ = std::max(width, 0);
+    proxyHeight_ = std::max(height, 0);
+}
+
+bool NDIBandwidthPolicy::proxyEnough(int displayWidth, int displayHeight) const {
+    if (displayWidth <= 0 || displayHeight <= 0 || sourceWidth_ <= 0 || sourceHeight_ <= 0) {
+        return false;
+    }
+    int proxyWidth = proxyWidth_;
+    int proxyHeight = proxyHeight_;
+    if (proxyWidth <= 0 || proxyHeight <= 0) {
+        proxyWidth = std::min(sourceWidth_, DEFAULT_PROXY_WIDTH);
+        proxyHeight = static_cast<int>(static_cast<long long>(sourceHeight_) * proxyWidth / sourceWidth_);
+    }
+    if (proxyWidth >= sourceWidth_) {
+        return false;  // Nothing to save
+    }
+    // Going to the proxy needs headroom, staying on it does not
+    double limit = current_ == Bandwidth::LOWEST ? 1.0 : HEADROOM;
+    return displayWidth <= proxyWidth * limit && displayHeight <= proxyHeight * limit;
+}
+
+NDIBandwidthPolicy::Bandwidth NDIBandwidthPolicy::update(int displayWidth, int displayHeight, double now) {
+    if (!enabled_ || !proxyEnough(displayWidth, displayHeight)) {
+        smallSince_ = -1.0;
+        return Bandwidth::HIGHEST;   // Full detail at once
+    }
+    if (current_ == Bandwidth::LOWEST) {
+        return Bandwidth::LOWEST;
+    }
+    if (smallSince_ < 0.0) {
+        smallSince_ = now;
+    }
+    return now - smallSince_ >= SETTLE_SECONDS ? Bandwidth::LOWEST : Bandwidth::HIGHEST;
+}
+
+void NDIBandwidthPolicy::setCurrent(Bandwidth bandwidth) {
+    current_ = bandwidth;
+    smallSince_ = -1.0;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,67 @@
+#ifndef VIDEOCOMPOSER_NDIBANDWIDTHPOLICY_H
+#define VIDEOCOMPOSER_NDIBANDWIDTHPOLICY_H
+
+namespace videocomposer {
+
+/**
+ * NDIBandwidthPolicy - Which NDI stream a receiver should take
+ *
+ * NDI senders offer a low-bandwidth proxy of each source (typically 640
+ * pixels wide) next to the full stream. A layer shown no larger than the
+ * proxy (multiview tile, picture-in-picture) receives the proxy; it goes
+ * back to the full stream as soon as it is shown larger (or its size is
+ * unknown). Going to the proxy waits until the size has been small for
+ * SETTLE_SECONDS, so an animation through small sizes does not switch.
+ *
+ * The policy only decides; NDIVideoInput switches by bringing up a second
+ * receiver and swapping when it delivers (the layer holds its last frame).
+ */
+class NDIBandwidthPolicy {
+public:
+    enum class Bandwidth {
+        HIGHEST,
+        LOWEST
+    };
+
+    static constexpr int DEFAULT_PROXY_WIDTH = 640;
+    static constexpr double SETTLE_SECONDS = 1.0;
+    static constexpr double HEADROOM = 0.9;   // Shown at most this share of the proxy to go to it
+
+    NDIBandwidthPolicy();
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool isEnabled() const { return enabled_; }
+
+    /** Full stream size (the proxy keeps its aspect) */
+    void setSourceSize(int width, int height);
+
+    /** Proxy size as received (replaces the DEFAULT_PROXY_WIDTH guess) */
+    void setProxySize(int width, int height);
+
+    /**
+     * @param displayWidth,displayHeight Shown size (VideoLayer::getResolutionHint, 0 = needs full)
+     * @param now Seconds on a monotonic clock
+     * @return The stream to receive now
+     */
+    Bandwidth update(int displayWidth, int displayHeight, double now);
+
+    Bandwidth getCurrent() const { return current_; }
+
+    /** The receiver now takes this stream (a switch completed) */
+    void setCurrent(Bandwidth bandwidth);
+
+private:
+    bool proxyEnough(int displayWidth, int displayHeight) const;
+
+    bool enabled_;
+    int sourceWidth_;
+    int sourceHeight_;
+    int proxyWidth_;
+    int proxyHeight_;
+    Bandwidth current_;
+    double smallSince_;   // < 0 = shown larger than the proxy
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_NDIBANDWIDTHPOLICY_H
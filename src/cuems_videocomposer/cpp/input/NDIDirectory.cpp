@@ -0,0 +1,203 @@
+#include "NDIDirectory.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <chrono>
+
+#ifdef HAVE_NDI_SDK
+#include <Processing.NDI.Lib.h>
+#endif
+
+namespace videocomposer {
+
+NDIDirectory& NDIDirectory::instance() {
+    static NDIDirectory directory;
+    return directory;
+}
+
+NDIDirectory::NDIDirectory()
+    : running_(false)
+    , stop_(false)
+    , startedMs_(0)
+{
+}
+
+NDIDirectory::~NDIDirectory() {
+    stop();
+}
+
+int64_t NDIDirectory::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void NDIDirectory::start() {
+#ifdef HAVE_NDI_SDK
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    stop_ = false;
+    startedMs_ = nowMs();
+    running_ = true;
+    finderThread_ = std::thread(&NDIDirectory::finderThreadFunc, this);
+#endif
+}
+
+void NDIDirectory::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        stop_ = true;
+    }
+    changed_.notify_all();
+    if (finderThread_.joinable()) {
+        finderThread_.join();
+    }
+    running_ = false;
+}
+
+void NDIDirectory::finderThreadFunc() {
+#ifdef HAVE_NDI_SDK
+    ThreadRoles::instance().apply(ThreadRole::LOADER);
+    if (!NDIlib_initialize()) {
+        LOG_ERROR << "NDI directory: Failed to initialize NDI SDK";
+        return;
+    }
+    NDIlib_find_instance_t finder = NDIlib_find_create_v2();
+    if (!finder) {
+        LOG_ERROR << "NDI directory: Failed to create finder";
+        NDIlib_destroy();
+        return;
+    }
+    LOG_INFO << "NDI directory: Watching the network for sources";
+
+    std::vector<Source> current;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) {
+                break;
+            }
+        }
+        // Returns early when the list changes
+        NDIlib_find_wait_for_sources(finder, SCAN_INTERVAL_MS);
+        uint32_t count = 0;
+        const NDIlib_source_t* found = NDIlib_find_get_current_sources(finder, &count);
+        current.clear();
+        for (uint32_t i = 0; i < count; ++i) {
+            Source source;
+            source.name = found[i].p_ndi_name ? found[i].p_ndi_name : "";
+            source.url = found[i].p_url_address ? found[i].p_url_address : "";
+            if (!source.name.empty()) {
+                current.push_back(std::move(source));
+            }
+        }
+        update(current, nowMs());
+    }
+
+    NDIlib_find_destroy(finder);
+    NDIlib_destroy();
+#endif
+}
+
+void NDIDirectory::update(const std::vector<Source>& current, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool changed = false;
+    for (const Source& seen : current) {
+        auto it = std::find_if(sources_.begin(), sources_.end(),
+                               [&seen](const Source& known) { return known.name == seen.name; });
+        if (it == sources_.end()) {
+            Source added = seen;
+            added.lastSeenMs = nowMs;
+            added.revision = 1;
+            sources_.push_back(std::move(added));
+            LOG_INFO << "NDI directory: Found '" << seen.name << "'";
+            changed = true;
+            continue;
+        }
+        if (it->url != seen.url) {
+            // Restarted sender, new address: receivers re-point to it
+            LOG_INFO << "NDI directory: '" << seen.name << "' moved to " << seen.url;
+            it->url = seen.url;
+            it->revision++;
+            changed = true;
+        }
+        it->lastSeenMs = nowMs;
+    }
+    size_t before = sources_.size();
+    sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+                                  [nowMs](const Source& known) { return nowMs - known.lastSeenMs > LINGER_MS; }),
+                   sources_.end());
+    changed = changed || sources_.size() != before;
+    if (changed) {
+        changed_.notify_all();
+    }
+}
+
+bool NDIDirectory::find(const std::string& name, Source& source) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Source* partial = nullptr;
+    for (const Source& known : sources_) {
+        if (known.name == name) {
+            source = known;
+            return true;
+        }
+        if (!partial && !name.empty() && known.name.find(name) != std::string::npos) {
+            partial = &known;
+        }
+    }
+    if (partial) {
+        source = *partial;
+        return true;
+    }
+    return false;
+}
+
+bool NDIDirectory::waitFor(const std::string& name, int timeoutMs, Source& source) {
+    if (find(name, source)) {
+        return true;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (changed_.wait_until(lock, deadline) == std::cv_status::timeout) {
+            break;
+        }
+        lock.unlock();
+        if (find(name, source)) {
+            return true;
+        }
+        lock.lock();
+    }
+    lock.unlock();
+    return find(name, source);
+}
+
+void NDIDirectory::waitForListening(int ms) {
+    int64_t remaining = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        remaining = startedMs_ + ms - nowMs();
+    }
+    if (remaining > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(remaining));
+    }
+}
+
+std::vector<std::string> NDIDirectory::getSourceNames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    names.reserve(sources_.size());
+    for (const Source& known : sources_) {
+        names.push_back(known.name);
+    }
+    return names;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,91 @@
+#ifndef VIDEOCOMPOSER_NDIDIRECTORY_H
+#define VIDEOCOMPOSER_NDIDIRECTORY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * NDIDirectory - Process-wide live list of the NDI sources on the network
+ *
+ * Finding a source means creating an NDI finder and waiting for mDNS
+ * answers, which took seconds on every NDI cue open (and on every source
+ * name check). One finder instead runs for the whole process on a
+ * background thread and keeps the directory current: a known source is
+ * connected to at once, and receivers re-point to a source that came back
+ * at another address (see NDIVideoInput::captureFrame) without the layer
+ * being torn down.
+ *
+ * Sources that leave stay listed for LINGER_MS, so a restarting sender
+ * does not make a cue load fail in between.
+ */
+class NDIDirectory {
+public:
+    static constexpr int64_t LINGER_MS = 10000;
+    static constexpr int SCAN_INTERVAL_MS = 500;   // Longest a change goes unnoticed
+
+    struct Source {
+        std::string name;       // "HOST (Source)"
+        std::string url;        // Address the finder reported
+        int64_t lastSeenMs = 0;
+        uint64_t revision = 0;  // Bumped when the address changes
+    };
+
+    static NDIDirectory& instance();
+
+    NDIDirectory();
+    ~NDIDirectory();
+
+    NDIDirectory(const NDIDirectory&) = delete;
+    NDIDirectory& operator=(const NDIDirectory&) = delete;
+
+    /** Start the finder thread (idempotent; a no-op without the NDI SDK) */
+    void start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    /**
+     * Source by exact name, else the first whose name contains it (as
+     * cue files name sources)
+     */
+    bool find(const std::string& name, Source& source) const;
+
+    /**
+     * find(), waiting up to timeoutMs for the source to appear
+     */
+    bool waitFor(const std::string& name, int timeoutMs, Source& source);
+
+    /** Wait until the finder has been listening for at least ms (discovery lists) */
+    void waitForListening(int ms);
+
+    std::vector<std::string> getSourceNames() const;
+
+    /**
+     * Merge one finder snapshot: new sources are added, changed addresses
+     * bump the revision, sources missing for LINGER_MS are dropped
+     */
+    void update(const std::vector<Source>& current, int64_t nowMs);
+
+    static int64_t nowMs();
+
+private:
+    void finderThreadFunc();
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<Source> sources_;
+    std::atomic<bool> running_;
+    bool stop_;
+    int64_t startedMs_;
+    std::thread finderThread_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_NDIDIRECTORY_H
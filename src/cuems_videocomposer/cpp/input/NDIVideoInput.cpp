@@ -12,7 +12,6 @@ NDIVideoInput::NDIVideoInput()
 {
 #ifdef HAVE_NDI_SDK
     ndiReceiver_ = nullptr;
-    ndiFinder_ = nullptr;
 #endif
     frameInfo_ = {};
 }
@@ -37,10 +36,6 @@ bool NDIVideoInput::initializeNDI() {
 
 void NDIVideoInput::shutdownNDI() {
 #ifdef HAVE_NDI_SDK
-    if (ndiFinder_) {
-        NDIlib_find_destroy(ndiFinder_);
-        ndiFinder_ = nullptr;
-    }
     NDIlib_destroy();
     LOG_INFO << "NDI SDK shutdown";
 #endif
@@ -48,74 +43,35 @@ void NDIVideoInput::shutdownNDI() {
 
 bool NDIVideoInput::connectToSource(const std::string& sourceName) {
 #ifdef HAVE_NDI_SDK
-    // Create finder to discover sources
-    if (!ndiFinder_) {
-        ndiFinder_ = NDIlib_find_create_v2();
-        if (!ndiFinder_) {
-            LOG_ERROR << "NDI: Failed to create finder";
-            return false;
-        }
-    }
-
-    LOG_INFO << "NDI: Searching for source '" << sourceName << "' (timeout: " << discoveryTimeoutMs_ << "ms)";
-
-    // Poll for sources with timeout (more responsive than sleep)
-    auto startTime = std::chrono::steady_clock::now();
-    const NDIlib_source_t* selectedSource = nullptr;
-    
-    while (true) {
-        // Check for sources
-        uint32_t numSources = 0;
-        const NDIlib_source_t* sources = NDIlib_find_get_current_sources(ndiFinder_, &numSources);
-        
-        // Look for matching source (exact match or partial match)
-        for (uint32_t i = 0; i < numSources; i++) {
-            std::string ndiName = sources[i].p_ndi_name;
-            if (ndiName == sourceName || ndiName.find(sourceName) != std::string::npos) {
-                selectedSource = &sources[i];
-                LOG_INFO << "NDI: Found source '" << ndiName << "'";
-                break;
-            }
-        }
-        
-        if (selectedSource) break;
-        
-        // Check timeout
-        auto elapsed = std::chrono::steady_clock::now() - startTime;
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() >= discoveryTimeoutMs_) {
+    // Sources already on the network connect at once: the directory has
+    // been listening since startup
+    NDIDirectory& directory = NDIDirectory::instance();
+    directory.start();
+    NDIDirectory::Source found;
+    if (!directory.find(sourceName, found)) {
+        LOG_INFO << "NDI: Waiting for source '" << sourceName << "' (timeout: " << discoveryTimeoutMs_ << "ms)";
+        if (!directory.waitFor(sourceName, discoveryTimeoutMs_, found)) {
             LOG_ERROR << "NDI: Source not found: " << sourceName;
-            
-            // List available sources
-            uint32_t finalNumSources = 0;
-            const NDIlib_source_t* finalSources = NDIlib_find_get_current_sources(ndiFinder_, &finalNumSources);
-            if (finalNumSources > 0) {
-                LOG_INFO << "NDI: Available sources (" << finalNumSources << "):";
-                for (uint32_t i = 0; i < finalNumSources; i++) {
-                    LOG_INFO << "  - " << finalSources[i].p_ndi_name;
+            std::vector<std::string> available = directory.getSourceNames();
+            if (!available.empty()) {
+                LOG_INFO << "NDI: Available sources (" << available.size() << "):";
+                for (const auto& name : available) {
+                    LOG_INFO << "  - " << name;
                 }
             } else {
                 LOG_INFO << "NDI: No sources found on network";
             }
             return false;
         }
-        
-        // Wait a bit before polling again
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    LOG_INFO << "NDI: Found source '" << found.name << "'";
+    connected_ = found;
 
-    // Create receiver
-    NDIlib_recv_create_v3_t recv_desc;
-    recv_desc.source_to_connect_to = *selectedSource;
-    recv_desc.color_format = NDIlib_recv_color_format_BGRX_BGRA;  // BGRA format (matches OpenGL expectation)
-    recv_desc.bandwidth = NDIlib_recv_bandwidth_highest;
-    recv_desc.allow_video_fields = false;  // Progressive only
-    recv_desc.p_ndi_recv_name = "cuems-videocomposer";  // Identify ourselves
-
-    ndiReceiver_ = NDIlib_recv_create_v3(&recv_desc);
+    ndiReceiver_ = createReceiver(NDIBandwidthPolicy::Bandwidth::HIGHEST, receiverRef_);
     if (!ndiReceiver_) {
-        LOG_ERROR << "NDI: Failed to create receiver";
         return false;
     }
+    bandwidthPolicy_.setCurrent(NDIBandwidthPolicy::Bandwidth::HIGHEST);
 
     LOG_INFO << "NDI: Connected to source: " << sourceName;
     return true;
@@ -125,6 +81,90 @@ bool NDIVideoInput::connectToSource(const std::string& sourceName) {
 #endif
 }
 
+#ifdef HAVE_NDI_SDK
+NDIlib_recv_instance_t NDIVideoInput::createReceiver(NDIBandwidthPolicy::Bandwidth bandwidth,
+                                                     std::shared_ptr<void>& ref) {
+    NDIlib_source_t selectedSource;
+    selectedSource.p_ndi_name = connected_.name.c_str();
+    selectedSource.p_url_address = connected_.url.empty() ? nullptr : connected_.url.c_str();
+
+    NDIlib_recv_create_v3_t recv_desc;
+    recv_desc.source_to_connect_to = selectedSource;
+    // UYVY: native for opaque sources, converted in the renderer's shader;
+    // BGRA otherwise (matches OpenGL expectation)
+    recv_desc.color_format = uyvyOutput_ ? NDIlib_recv_color_format_UYVY_BGRA
+                                         : NDIlib_recv_color_format_BGRX_BGRA;
+    recv_desc.bandwidth = bandwidth == NDIBandwidthPolicy::Bandwidth::LOWEST ? NDIlib_recv_bandwidth_lowest
+                                                                             : NDIlib_recv_bandwidth_highest;
+    recv_desc.allow_video_fields = false;  // Progressive only
+    recv_desc.p_ndi_recv_name = "cuems-videocomposer";  // Identify ourselves
+
+    NDIlib_recv_instance_t receiver = NDIlib_recv_create_v3(&recv_desc);
+    if (!receiver) {
+        LOG_ERROR << "NDI: Failed to create receiver";
+        return nullptr;
+    }
+    ref = std::shared_ptr<void>(receiver, [](void* instance) {
+        NDIlib_recv_destroy(static_cast<NDIlib_recv_instance_t>(instance));
+    });
+    if (tallyProgram_ || tallyPreview_) {
+        NDIlib_tally_t tally;
+        tally.on_program = tallyProgram_;
+        tally.on_preview = tallyPreview_;
+        NDIlib_recv_set_tally(receiver, &tally);
+    }
+    return receiver;
+}
+
+void NDIVideoInput::updateBandwidth() {
+    if (!bandwidthPolicy_.isEnabled()) {
+        return;
+    }
+    int64_t now = NDIDirectory::nowMs();
+    NDIBandwidthPolicy::Bandwidth wanted =
+        bandwidthPolicy_.update(displayWidth_.load(), displayHeight_.load(), now / 1000.0);
+    if (pendingReceiver_) {
+        if (wanted == pendingBandwidth_ && now - pendingSinceMs_ <= connectionTimeoutMs_) {
+            return;
+        }
+        if (wanted == pendingBandwidth_) {
+            LOG_WARNING << "NDI: " << connected_.name << " sent nothing on the "
+                        << (pendingBandwidth_ == NDIBandwidthPolicy::Bandwidth::LOWEST ? "proxy" : "full")
+                        << " stream, staying on the current one";
+            switchRetryMs_ = now + SWITCH_RETRY_MS;
+        }
+        std::lock_guard<std::mutex> lock(receiverMutex_);
+        pendingRef_.reset();
+        pendingReceiver_ = nullptr;
+        return;
+    }
+    if (wanted == bandwidthPolicy_.getCurrent() || now < switchRetryMs_) {
+        return;
+    }
+
+    // The current stream keeps feeding the layer until the new one delivers
+    std::lock_guard<std::mutex> lock(receiverMutex_);
+    pendingReceiver_ = createReceiver(wanted, pendingRef_);
+    if (!pendingReceiver_) {
+        switchRetryMs_ = now + SWITCH_RETRY_MS;
+        return;
+    }
+    pendingBandwidth_ = wanted;
+    pendingSinceMs_ = now;
+}
+
+void NDIVideoInput::completeBandwidthSwitch() {
+    std::lock_guard<std::mutex> lock(receiverMutex_);
+    // Frames of the old stream still held keep their receiver alive
+    receiverRef_ = std::move(pendingRef_);
+    ndiReceiver_ = pendingReceiver_;
+    pendingReceiver_ = nullptr;
+    bandwidthPolicy_.setCurrent(pendingBandwidth_);
+    LOG_INFO << "NDI: " << connected_.name << " now on the "
+             << (pendingBandwidth_ == NDIBandwidthPolicy::Bandwidth::LOWEST ? "proxy" : "full") << " stream";
+}
+#endif
+
 bool NDIVideoInput::open(const std::string& source) {
     if (!initializeNDI()) {
         return false;
@@ -161,18 +201,24 @@ bool NDIVideoInput::open(const std::string& source) {
         
         if (video_frame.frame_rate_N > 0 && video_frame.frame_rate_D > 0) {
             frameInfo_.framerate = static_cast<double>(video_frame.frame_rate_N) / static_cast<double>(video_frame.frame_rate_D);
+            frameInfo_.framerateNum = video_frame.frame_rate_N;
+            frameInfo_.framerateDen = video_frame.frame_rate_D;
         } else {
             frameInfo_.framerate = 25.0;  // Default
         }
         
-        frameInfo_.format = PixelFormat::BGRA32;  // BGRA matches OpenGL expectation
+        frameInfo_.format = video_frame.FourCC == NDIlib_FourCC_video_type_UYVY
+                                ? PixelFormat::UYVY422 : PixelFormat::BGRA32;
+        frameInfo_.colorMatrix = video_frame.yres < 720 ? ColorMatrix::BT601 : ColorMatrix::BT709;
         frameInfo_.totalFrames = 0;  // Live stream, no total frames
+        bandwidthPolicy_.setSourceSize(frameInfo_.width, frameInfo_.height);
         frameInfo_.duration = 0.0;
         
         NDIlib_recv_free_video_v2(ndiReceiver_, &video_frame);
         
         LOG_INFO << "NDI: Source format: " << frameInfo_.width << "x" << frameInfo_.height 
-                 << " @ " << frameInfo_.framerate << " fps (BGRA)";
+                 << " @ " << frameInfo_.framerate << " fps ("
+                 << (frameInfo_.format == PixelFormat::UYVY422 ? "UYVY" : "BGRA") << ")";
     } else {
         LOG_WARNING << "NDI: No video frame received, using defaults (1920x1080 @25fps)";
         frameInfo_.width = 1920;
@@ -183,6 +229,7 @@ bool NDIVideoInput::open(const std::string& source) {
     }
 #endif
 
+    lastVideoMs_ = NDIDirectory::nowMs();
     ready_ = true;
     startCaptureThread();  // Start async capture
     return true;
@@ -192,15 +239,17 @@ void NDIVideoInput::close() {
     stopCaptureThread();  // Stop async capture first
 
 #ifdef HAVE_NDI_SDK
-    if (ndiReceiver_) {
-        NDIlib_recv_destroy(ndiReceiver_);
-        ndiReceiver_ = nullptr;
-    }
+    // Frames still held by layers keep the receiver until they are released
+    pendingRef_.reset();
+    pendingReceiver_ = nullptr;
+    receiverRef_.reset();
+    ndiReceiver_ = nullptr;
 #endif
 
     shutdownNDI();
     ready_ = false;
     sourceName_.clear();
+    connected_ = NDIDirectory::Source();
     frameCount_ = 0;
 }
 
@@ -235,19 +284,73 @@ bool NDIVideoInput::captureFrame(FrameBuffer& buffer) {
     NDIlib_audio_frame_v2_t audio_frame;
     NDIlib_metadata_frame_t metadata_frame;
 
-    // Non-blocking capture with short timeout
-    NDIlib_frame_type_e frame_type = NDIlib_recv_capture_v2(
-        ndiReceiver_, &video_frame, &audio_frame, &metadata_frame, 100);
+    updateBandwidth();
+    NDIlib_frame_type_e frame_type = NDIlib_frame_type_none;
+    if (pendingReceiver_) {
+        // Switching streams: the new one takes over with its first frame
+        frame_type = NDIlib_recv_capture_v2(pendingReceiver_, &video_frame, nullptr, nullptr, 0);
+        if (frame_type == NDIlib_frame_type_video) {
+            completeBandwidthSwitch();
+        } else {
+            frame_type = NDIlib_recv_capture_v2(
+                ndiReceiver_, &video_frame, &audio_frame, &metadata_frame, 20);
+        }
+    } else {
+        // Non-blocking capture with short timeout
+        frame_type = NDIlib_recv_capture_v2(
+            ndiReceiver_, &video_frame, &audio_frame, &metadata_frame, 100);
+    }
 
     if (frame_type == NDIlib_frame_type_video) {
-        // Allocate buffer for frame
+        lastVideoMs_ = NDIDirectory::nowMs();
+        if (bandwidthPolicy_.getCurrent() == NDIBandwidthPolicy::Bandwidth::LOWEST) {
+            bandwidthPolicy_.setProxySize(video_frame.xres, video_frame.yres);
+        } else {
+            bandwidthPolicy_.setSourceSize(video_frame.xres, video_frame.yres);
+        }
         FrameInfo info;
         info.width = video_frame.xres;
         info.height = video_frame.yres;
         info.aspect = static_cast<float>(video_frame.xres) / static_cast<float>(video_frame.yres);
+        info.colorMatrix = video_frame.yres < 720 ? ColorMatrix::BT601 : ColorMatrix::BT709;
+        
+        if (video_frame.FourCC == NDIlib_FourCC_video_type_UYVY) {
+            info.format = PixelFormat::UYVY422;
+            size_t rowBytes = static_cast<size_t>(video_frame.xres) * 2;
+            if (video_frame.line_stride_in_bytes == static_cast<int>(rowBytes)) {
+                // Zero-copy: the layer gets the SDK's frame, freed with its last reference
+                std::shared_ptr<void> receiver = receiverRef_;
+                std::shared_ptr<NDIlib_video_frame_v2_t> owner(
+                    new NDIlib_video_frame_v2_t(video_frame),
+                    [receiver](NDIlib_video_frame_v2_t* frame) {
+                        NDIlib_recv_free_video_v2(static_cast<NDIlib_recv_instance_t>(receiver.get()), frame);
+                        delete frame;
+                    });
+                if (!buffer.wrap(video_frame.p_data, rowBytes * video_frame.yres, info, owner)) {
+                    return false;
+                }
+                frameCount_++;
+                return true;
+            }
+            
+            // Padded rows: copy them tight
+            if (!buffer.ensureAllocated(info)) {
+                NDIlib_recv_free_video_v2(ndiReceiver_, &video_frame);
+                return false;
+            }
+            for (int row = 0; row < video_frame.yres; ++row) {
+                memcpy(buffer.data() + row * rowBytes,
+                       video_frame.p_data + static_cast<size_t>(row) * video_frame.line_stride_in_bytes, rowBytes);
+            }
+            frameCount_++;
+            NDIlib_recv_free_video_v2(ndiReceiver_, &video_frame);
+            return true;
+        }
+        
+        // Allocate buffer for frame
         info.format = PixelFormat::BGRA32;  // BGRA matches OpenGL expectation
         
-        if (!buffer.allocate(info)) {
+        if (!buffer.ensureAllocated(info)) {
             NDIlib_recv_free_video_v2(ndiReceiver_, &video_frame);
             return false;
         }
@@ -265,6 +368,7 @@ bool NDIVideoInput::captureFrame(FrameBuffer& buffer) {
         return false;
     }
 
+    reconnectIfMoved();
     return false;
 #else
     (void)buffer;  // Unused
@@ -272,45 +376,51 @@ bool NDIVideoInput::captureFrame(FrameBuffer& buffer) {
 #endif
 }
 
-std::vector<std::string> NDIVideoInput::discoverSources(int timeoutMs) {
-    std::vector<std::string> sources;
-
+void NDIVideoInput::reconnectIfMoved() {
 #ifdef HAVE_NDI_SDK
-    if (!NDIlib_initialize()) {
-        LOG_ERROR << "Failed to initialize NDI SDK for discovery";
-        return sources;
-    }
-
-    NDIlib_find_instance_t finder = NDIlib_find_create_v2();
-    if (!finder) {
-        NDIlib_destroy();
-        return sources;
+    int64_t now = NDIDirectory::nowMs();
+    if (now - lastVideoMs_ < RECONNECT_AFTER_MS || now - lastReconnectCheckMs_ < NDIDirectory::SCAN_INTERVAL_MS) {
+        return;
     }
-
-    // Wait for sources to be discovered
-    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
-
-    uint32_t numSources = 0;
-    const NDIlib_source_t* foundSources = NDIlib_find_get_current_sources(finder, &numSources);
-
-    for (uint32_t i = 0; i < numSources; i++) {
-        sources.push_back(foundSources[i].p_ndi_name);
+    lastReconnectCheckMs_ = now;
+
+    // A restarted sender comes back at a new address; the receiver is
+    // pointed there in place, the layer keeps its last frame meanwhile
+    NDIDirectory::Source current;
+    if (!NDIDirectory::instance().find(connected_.name, current) || current.name != connected_.name ||
+        (current.revision == connected_.revision && current.url == connected_.url)) {
+        return;
     }
-
-    NDIlib_find_destroy(finder);
-    NDIlib_destroy();
+    connected_ = current;
+    NDIlib_source_t source;
+    source.p_ndi_name = connected_.name.c_str();
+    source.p_url_address = connected_.url.empty() ? nullptr : connected_.url.c_str();
+    NDIlib_recv_connect(ndiReceiver_, &source);
+    LOG_INFO << "NDI: Reconnected to '" << connected_.name << "' at " << connected_.url;
 #endif
+}
 
-    return sources;
+std::vector<std::string> NDIVideoInput::discoverSources(int timeoutMs) {
+    // The directory accumulates while the process runs; a fresh one only
+    // needs the timeout once
+    NDIDirectory& directory = NDIDirectory::instance();
+    directory.start();
+    directory.waitForListening(timeoutMs);
+    return directory.getSourceNames();
 }
 
 void NDIVideoInput::setTallyState(bool onProgram, bool onPreview) {
 #ifdef HAVE_NDI_SDK
-    if (ndiReceiver_) {
-        NDIlib_tally_t tally;
-        tally.on_program = onProgram;
-        tally.on_preview = onPreview;
-        NDIlib_recv_set_tally(ndiReceiver_, &tally);
+    std::lock_guard<std::mutex> lock(receiverMutex_);
+    tallyProgram_ = onProgram;
+    tallyPreview_ = onPreview;
+    for (NDIlib_recv_instance_t receiver : {ndiReceiver_, pendingReceiver_}) {
+        if (receiver) {
+            NDIlib_tally_t tally;
+            tally.on_program = onProgram;
+            tally.on_preview = onPreview;
+            NDIlib_recv_set_tally(receiver, &tally);
+        }
     }
 #else
     (void)onProgram;
@@ -2,7 +2,12 @@
 #define VIDEOCOMPOSER_NDIVIDEOINPUT_H
 
 #include "LiveInputSource.h"
+#include "NDIDirectory.h"
+#include "NDIBandwidthPolicy.h"
 #include "../video/FrameFormat.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -18,6 +23,15 @@ namespace videocomposer {
  * 
  * Receives video streams over NDI protocol. Uses async frame capture
  * via LiveInputSource base class to prevent frame drops.
+ *
+ * With UYVY output (default) opaque sources are received in their native
+ * 4:2:2 and the SDK's frame is handed to the layer as is: the renderer
+ * uploads it (half the bytes of BGRA) and converts it in a shader, and the
+ * frame goes back to the SDK when the last buffer referencing it is
+ * released. Sources with alpha still arrive as BGRA.
+ *
+ * A layer shown small receives the sender's low-bandwidth proxy stream
+ * instead (NDIBandwidthPolicy, fed by setDisplaySize()).
  */
 class NDIVideoInput : public LiveInputSource {
 public:
@@ -35,9 +49,21 @@ public:
     DecodeBackend getOptimalBackend() const override;
 
     // NDI-specific
+    // Sources seen by the NDIDirectory, listening at least timeoutMs
     static std::vector<std::string> discoverSources(int timeoutMs = 5000);
     void setTallyState(bool onProgram, bool onPreview);
     
+    /**
+     * Receive UYVY for the renderer's YUV shader instead of BGRA (set before open())
+     */
+    void setUYVYOutput(bool enabled) { uyvyOutput_ = enabled; }
+    
+    // Switch to the proxy stream while shown small (set before open())
+    void setAdaptiveBandwidth(bool enabled) { bandwidthPolicy_.setEnabled(enabled); }
+    
+    // Shown size in output pixels (VideoLayer::getResolutionHint, 0 = needs full)
+    void setDisplaySize(int width, int height) { displayWidth_ = width; displayHeight_ = height; }
+    
     // Connection settings
     void setConnectionTimeout(int timeoutMs) { connectionTimeoutMs_ = timeoutMs; }
     void setDiscoveryTimeout(int timeoutMs) { discoveryTimeoutMs_ = timeoutMs; }
@@ -54,20 +80,50 @@ private:
     bool initializeNDI();
     void shutdownNDI();
     bool connectToSource(const std::string& sourceName);
+    // Capture thread: re-point the receiver when the source moved
+    void reconnectIfMoved();
+
+    static constexpr int64_t RECONNECT_AFTER_MS = 2000;  // Without video before checking
+    static constexpr int64_t SWITCH_RETRY_MS = 10000;    // After a stream switch failed
+
+#ifdef HAVE_NDI_SDK
+    NDIlib_recv_instance_t createReceiver(NDIBandwidthPolicy::Bandwidth bandwidth, std::shared_ptr<void>& ref);
+    // Capture thread: start or abandon a switch to the stream the policy wants
+    void updateBandwidth();
+    void completeBandwidthSwitch();
+#endif
 
 #ifdef HAVE_NDI_SDK
     NDIlib_recv_instance_t ndiReceiver_;
-    NDIlib_find_instance_t ndiFinder_;
+    // Destroys the receiver once no received frame references it any more
+    std::shared_ptr<void> receiverRef_;
+    // Receiver of the other stream while switching (capture thread)
+    NDIlib_recv_instance_t pendingReceiver_ = nullptr;
+    std::shared_ptr<void> pendingRef_;
+    std::mutex receiverMutex_;  // Receiver swaps vs. tally
 #endif
+    bool uyvyOutput_ = true;
 
     FrameInfo frameInfo_;
     std::string sourceName_;
     bool ready_;
     std::atomic<int64_t> frameCount_;
+    NDIDirectory::Source connected_;
+    int64_t lastVideoMs_ = 0;
+    int64_t lastReconnectCheckMs_ = 0;
+    
+    NDIBandwidthPolicy bandwidthPolicy_;  // Capture thread
+    NDIBandwidthPolicy::Bandwidth pendingBandwidth_ = NDIBandwidthPolicy::Bandwidth::HIGHEST;
+    int64_t pendingSinceMs_ = 0;
+    int64_t switchRetryMs_ = 0;
+    std::atomic<int> displayWidth_{0};
+    std::atomic<int> displayHeight_{0};
+    bool tallyProgram_ = false;
+    bool tallyPreview_ = false;
     
     // Timeouts (milliseconds)
     int connectionTimeoutMs_ = 5000;  // Time to wait for first frame
-    int discoveryTimeoutMs_ = 2000;   // Time to wait for source discovery
+    int discoveryTimeoutMs_ = 2000;   // Time to wait for a source not yet seen
 };
 
 } // namespace videocomposer
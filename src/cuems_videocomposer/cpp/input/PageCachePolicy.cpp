@@ -0,0 +1,208 @@
+#include "PageCachePolicy.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <limits>
+#include <unistd.h>
+
+namespace videocomposer {
+
+PageCachePolicy& PageCachePolicy::instance() {
+    static PageCachePolicy policy;
+    return policy;
+}
+
+PageCachePolicy::PageCachePolicy()
+    : stop_(false)
+    , enabled_(true)
+    , prefetchBytes_(static_cast<int64_t>(DEFAULT_PREFETCH_BYTES))
+    , keepBehindBytes_(static_cast<int64_t>(DEFAULT_KEEP_BEHIND_BYTES))
+    , nextId_(1)
+{
+}
+
+PageCachePolicy::~PageCachePolicy() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCond_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void PageCachePolicy::configure(bool enabled, size_t prefetchBytes, size_t keepBehindBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    prefetchBytes_ = static_cast<int64_t>(prefetchBytes);
+    keepBehindBytes_ = static_cast<int64_t>(keepBehindBytes);
+}
+
+bool PageCachePolicy::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+void PageCachePolicy::prefetch(const std::string& path, int64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || path.empty() || prefetchBytes_ <= 0) {
+        return;
+    }
+    Range range{std::max<int64_t>(0, offset), std::max<int64_t>(0, offset) + prefetchBytes_};
+
+    // Most recent last; the oldest protection lapses first
+    protected_.erase(std::remove_if(protected_.begin(), protected_.end(),
+                                    [&](const std::pair<std::string, Range>& entry) {
+                                        return entry.first == path && entry.second.begin == range.begin;
+                                    }),
+                     protected_.end());
+    protected_.emplace_back(path, range);
+    while (protected_.size() > MAX_PROTECTED) {
+        protected_.pop_front();
+    }
+
+    stats_.prefetches++;
+    stats_.prefetchBytes += static_cast<uint64_t>(range.end - range.begin);
+    queueLocked({path, {range}, POSIX_FADV_WILLNEED});
+}
+
+PageCachePolicy::ClientId PageCachePolicy::addPlayhead(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || path.empty()) {
+        return 0;
+    }
+    ClientId id = nextId_++;
+    playheads_[id].path = path;
+    droppedTo_.emplace(path, prefetchBytes_);  // The file's own opening stays cached
+    return id;
+}
+
+void PageCachePolicy::removePlayhead(ClientId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = playheads_.find(id);
+    if (it == playheads_.end()) {
+        return;
+    }
+    std::string path = it->second.path;
+    playheads_.erase(it);
+    for (const auto& entry : playheads_) {
+        if (entry.second.path == path) {
+            return;
+        }
+    }
+    droppedTo_.erase(path);
+}
+
+void PageCachePolicy::updatePlayhead(ClientId id, int64_t bytePosition) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = playheads_.find(id);
+    if (it == playheads_.end() || bytePosition < 0) {
+        return;
+    }
+    it->second.position = bytePosition;
+
+    // Slowest playhead of the file (layers at other positions still need theirs)
+    const std::string& path = it->second.path;
+    int64_t slowest = std::numeric_limits<int64_t>::max();
+    for (const auto& entry : playheads_) {
+        if (entry.second.path == path) {
+            if (entry.second.position < 0) {
+                return;  // A layer on it has not played yet
+            }
+            slowest = std::min(slowest, entry.second.position);
+        }
+    }
+
+    int64_t& droppedTo = droppedTo_[path];
+    int64_t target = std::max(prefetchBytes_, slowest - keepBehindBytes_);
+    if (target < droppedTo) {
+        droppedTo = target;  // Went back (seek, loop): dropped again as it plays on
+        return;
+    }
+    if (target - droppedTo < DROP_STEP) {
+        return;
+    }
+    std::vector<Range> ranges = unprotectedLocked(path, {droppedTo, target});
+    droppedTo = target;
+    if (ranges.empty()) {
+        return;
+    }
+    stats_.drops++;
+    for (const Range& range : ranges) {
+        stats_.droppedBytes += static_cast<uint64_t>(range.end - range.begin);
+    }
+    queueLocked({path, std::move(ranges), POSIX_FADV_DONTNEED});
+}
+
+std::vector<PageCachePolicy::Range> PageCachePolicy::unprotectedLocked(const std::string& path, Range range) const {
+    std::vector<Range> ranges{range};
+    for (const auto& entry : protected_) {
+        if (entry.first != path) {
+            continue;
+        }
+        const Range& keep = entry.second;
+        std::vector<Range> remaining;
+        for (const Range& r : ranges) {
+            if (keep.end <= r.begin || keep.begin >= r.end) {
+                remaining.push_back(r);
+                continue;
+            }
+            if (r.begin < keep.begin) {
+                remaining.push_back({r.begin, keep.begin});
+            }
+            if (keep.end < r.end) {
+                remaining.push_back({keep.end, r.end});
+            }
+        }
+        ranges.swap(remaining);
+    }
+    return ranges;
+}
+
+void PageCachePolicy::queueLocked(Job job) {
+    jobs_.push_back(std::move(job));
+    if (!worker_.joinable()) {
+        worker_ = std::thread(&PageCachePolicy::workerThreadFunc, this);
+    }
+    workCond_.notify_one();
+}
+
+PageCachePolicy::Stats PageCachePolicy::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.playheads = playheads_.size();
+    stats.protectedRanges = protected_.size();
+    return stats;
+}
+
+void PageCachePolicy::workerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::IO);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workCond_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+        if (stop_) {
+            return;
+        }
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+
+        // Opening can block on network filesystems: never on the caller's thread
+        int fd = ::open(job.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            for (const Range& range : job.ranges) {
+                posix_fadvise(fd, static_cast<off_t>(range.begin),
+                              static_cast<off_t>(range.end - range.begin), job.advice);
+            }
+            ::close(fd);
+        } else {
+            LOG_VERBOSE << "Page cache policy: cannot open " << job.path;
+        }
+
+        lock.lock();
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,115 @@
+#ifndef VIDEOCOMPOSER_PAGECACHEPOLICY_H
+#define VIDEOCOMPOSER_PAGECACHEPOLICY_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * PageCachePolicy - Keeps the page cache for the cues that come next
+ *
+ * Playing a long show front to back fills the page cache with frames
+ * that will not be shown again, pushing out the openings of the next
+ * clips. This policy:
+ * - drops (POSIX_FADV_DONTNEED) what lies more than keepBehind bytes
+ *   behind the slowest playhead of a file, in DROP_STEP batches
+ * - prefetches (POSIX_FADV_WILLNEED) the first prefetchBytes of files
+ *   queued for loading, and keeps the most recent MAX_PROTECTED of those
+ *   ranges (and every file's own opening) out of the drops
+ *
+ * The fadvise calls run on a worker thread; callers only queue them.
+ */
+class PageCachePolicy {
+public:
+    static constexpr size_t DEFAULT_PREFETCH_BYTES = 64 * 1024 * 1024;
+    static constexpr size_t DEFAULT_KEEP_BEHIND_BYTES = 64 * 1024 * 1024;
+    static constexpr int64_t DROP_STEP = 8 * 1024 * 1024;
+    static constexpr size_t MAX_PROTECTED = 32;
+
+    using ClientId = uint64_t;  // 0 = not registered
+
+    struct Stats {
+        uint64_t prefetches = 0;
+        uint64_t prefetchBytes = 0;
+        uint64_t drops = 0;
+        uint64_t droppedBytes = 0;
+        size_t playheads = 0;
+        size_t protectedRanges = 0;
+    };
+
+    static PageCachePolicy& instance();
+
+    PageCachePolicy();
+    ~PageCachePolicy();
+
+    /**
+     * @param enabled false turns every call into a no-op
+     * @param prefetchBytes Opening of a file prefetched and protected
+     * @param keepBehindBytes Cache kept behind the slowest playhead
+     */
+    void configure(bool enabled, size_t prefetchBytes, size_t keepBehindBytes);
+    bool isEnabled() const;
+
+    /**
+     * Bring the segment of a file starting at offset into the page cache
+     * (e.g. when a cue is queued for loading or goes next)
+     */
+    void prefetch(const std::string& path, int64_t offset = 0);
+
+    /**
+     * Playheads of a file; cache behind the slowest one is dropped
+     */
+    ClientId addPlayhead(const std::string& path);
+    void removePlayhead(ClientId id);
+    void updatePlayhead(ClientId id, int64_t bytePosition);
+
+    Stats getStats() const;
+
+private:
+    struct Range {
+        int64_t begin;
+        int64_t end;
+    };
+
+    struct Job {
+        std::string path;
+        std::vector<Range> ranges;
+        int advice;
+    };
+
+    struct Playhead {
+        std::string path;
+        int64_t position = -1;
+    };
+
+    void queueLocked(Job job);
+    std::vector<Range> unprotectedLocked(const std::string& path, Range range) const;
+    void workerThreadFunc();
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCond_;
+    std::deque<Job> jobs_;
+    std::thread worker_;  // Started with the first job
+    bool stop_;
+
+    bool enabled_;
+    int64_t prefetchBytes_;
+    int64_t keepBehindBytes_;
+    std::map<ClientId, Playhead> playheads_;
+    std::map<std::string, int64_t> droppedTo_;  // By file: dropped up to this offset
+    std::deque<std::pair<std::string, Range>> protected_;  // Most recent last
+    ClientId nextId_;
+    Stats stats_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PAGECACHEPOLICY_H
@@ -0,0 +1,109 @@
+#include "ProxyMedia.h"
+#include "../utils/Logger.h"
+#include <cmath>
+#include <sys/stat.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace videocomposer {
+
+std::string ProxyMedia::proxyPathFor(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1) {
+        return path + ".proxy";
+    }
+    return path.substr(0, dot) + ".proxy" + path.substr(dot);
+}
+
+std::string ProxyMedia::masterPathFor(const std::string& path) {
+    static const std::string tag = ".proxy";
+    size_t slash = path.find_last_of('/');
+    size_t start = slash == std::string::npos ? 0 : slash + 1;
+    auto endsWithTag = [&](size_t end) {
+        return end >= start + tag.size() + 1 && path.compare(end - tag.size(), tag.size(), tag) == 0;
+    };
+    if (endsWithTag(path.size())) {
+        return path.substr(0, path.size() - tag.size());  // "name.proxy"
+    }
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos && dot >= start && endsWithTag(dot)) {
+        return path.substr(0, dot - tag.size()) + path.substr(dot);  // "name.proxy.ext"
+    }
+    return std::string();
+}
+
+bool ProxyMedia::probe(const std::string& path, Probe& probe) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, path.c_str(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    int stream = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream < 0 || formatCtx->streams[stream]->codecpar->width <= 0) {
+        // Header alone did not tell (e.g. raw streams): read a little
+        if (avformat_find_stream_info(formatCtx, nullptr) >= 0) {
+            stream = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        }
+    }
+    if (stream < 0) {
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+    AVStream* avStream = formatCtx->streams[stream];
+    probe.width = avStream->codecpar->width;
+    probe.height = avStream->codecpar->height;
+    probe.framerate = avStream->r_frame_rate.num > 0 && avStream->r_frame_rate.den > 0
+                          ? av_q2d(avStream->r_frame_rate) : 0.0;
+    probe.duration = formatCtx->duration > 0 ? static_cast<double>(formatCtx->duration) / AV_TIME_BASE : 0.0;
+    avformat_close_input(&formatCtx);
+    return probe.width > 0 && probe.height > 0;
+}
+
+bool ProxyMedia::matches(const Probe& clip, const Probe& proxy) {
+    if (proxy.width <= 0 || proxy.height <= 0 || (proxy.width >= clip.width && proxy.height >= clip.height)) {
+        return false;  // Not a reduction
+    }
+    // Frame numbers must mean the same picture in both files
+    if (clip.framerate <= 0.0 || std::fabs(proxy.framerate - clip.framerate) > 0.001) {
+        return false;
+    }
+    return std::fabs(proxy.duration - clip.duration) * clip.framerate < 1.0;
+}
+
+bool ProxyMedia::covers(const Probe& clip, const Probe& proxy, int width, int height) {
+    if (width <= 0 || height <= 0 || proxy.width < width || proxy.height < height) {
+        return false;  // Unknown size, or the proxy would be upscaled on the canvas
+    }
+    return matches(clip, proxy);
+}
+
+std::string ProxyMedia::select(const std::string& path, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return path;
+    }
+    std::string proxyPath = proxyPathFor(path);
+    struct stat st;
+    if (stat(proxyPath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return path;
+    }
+
+    Probe clip;
+    Probe proxy;
+    if (!probe(path, clip) || !probe(proxyPath, proxy)) {
+        return path;
+    }
+    if (!covers(clip, proxy, width, height)) {
+        LOG_VERBOSE << "Proxy: " << proxyPath << " (" << proxy.width << "x" << proxy.height << ", "
+                    << proxy.framerate << " fps, " << proxy.duration << " s) does not stand in for "
+                    << path << " at " << width << "x" << height;
+        return path;
+    }
+    LOG_INFO << "Proxy: Playing " << proxyPath << " (" << proxy.width << "x" << proxy.height
+             << ") for a " << width << "x" << height << " layer instead of " << path << " ("
+             << clip.width << "x" << clip.height << ")";
+    return proxyPath;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,56 @@
+#ifndef VIDEOCOMPOSER_PROXYMEDIA_H
+#define VIDEOCOMPOSER_PROXYMEDIA_H
+
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * ProxyMedia - Reduced-resolution copies of clips for small layers
+ *
+ * A 4K clip shown as a 960x540 picture-in-picture does not need 4K
+ * frames: decoding, converting and uploading them costs memory bandwidth
+ * and VRAM for pixels that are sampled away. A clip "name.ext" may have
+ * a proxy "name.proxy.ext" next to it; a layer whose on-canvas size the
+ * proxy still covers plays the proxy instead. The proxy must have the
+ * clip's framerate and length, so frame numbers (and cues) match.
+ */
+class ProxyMedia {
+public:
+    struct Probe {
+        int width = 0;
+        int height = 0;
+        double framerate = 0.0;
+        double duration = 0.0;  // Seconds
+    };
+
+    /** Where the proxy of a clip would be ("dir/name.proxy.ext") */
+    static std::string proxyPathFor(const std::string& path);
+
+    /** The clip a proxy path stands in for (empty when path is not a proxy name) */
+    static std::string masterPathFor(const std::string& path);
+
+    /** Read dimensions and timing from a file's header */
+    static bool probe(const std::string& path, Probe& probe);
+
+    /**
+     * Whether a proxy can stand in for a clip at all: smaller, same timing
+     */
+    static bool matches(const Probe& clip, const Probe& proxy);
+
+    /**
+     * Whether a proxy can stand in for a clip on a layer showing width x height
+     * pixels without being upscaled
+     */
+    static bool covers(const Probe& clip, const Probe& proxy, int width, int height);
+
+    /**
+     * File to open for a layer showing width x height pixels (0 = unknown):
+     * the proxy when it exists and covers the layer, otherwise path
+     */
+    static std::string select(const std::string& path, int width, int height);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PROXYMEDIA_H
@@ -0,0 +1,116 @@
+#include "ProxySwitcher.h"
+#include "../utils/Logger.h"
+#include <cmath>
+#include <iterator>
+#include <set>
+
+namespace videocomposer {
+
+ProxySwitcher::ProxySwitcher()
+    : probe_(&ProxyMedia::probe)
+    , lastMisses_(0)
+    , lastMissTime_(-1.0)
+    , overloadUntil_(-1.0)
+{
+}
+
+const ProxySwitcher::Media& ProxySwitcher::media(const std::string& masterPath) {
+    auto it = media_.find(masterPath);
+    if (it != media_.end()) {
+        return it->second;
+    }
+    Media entry;
+    std::string proxyPath = ProxyMedia::proxyPathFor(masterPath);
+    entry.valid = probe_(masterPath, entry.clip) && probe_(proxyPath, entry.proxy) &&
+                  ProxyMedia::matches(entry.clip, entry.proxy);
+    if (entry.valid) {
+        LOG_INFO << "Proxy: " << proxyPath << " (" << entry.proxy.width << "x" << entry.proxy.height
+                 << ") can stand in for " << masterPath;
+    }
+    return media_.emplace(masterPath, entry).first->second;
+}
+
+bool ProxySwitcher::hasProxy(const std::string& path) {
+    std::string master = ProxyMedia::masterPathFor(path);
+    return media(master.empty() ? path : master).valid;
+}
+
+ProxySwitcher::Switch ProxySwitcher::update(const std::vector<LayerState>& layers, uint64_t totalMisses,
+                                            double now) {
+    Switch result;
+    if (!settings_.enabled) {
+        return result;
+    }
+
+    // Overload: underrun rate of all layers, measured over at least a second
+    if (lastMissTime_ < 0.0 || totalMisses < lastMisses_) {
+        lastMisses_ = totalMisses;
+        lastMissTime_ = now;
+    } else if (now - lastMissTime_ >= 1.0 && settings_.loadMissesPerSecond > 0.0) {
+        double rate = static_cast<double>(totalMisses - lastMisses_) / (now - lastMissTime_);
+        if (rate >= settings_.loadMissesPerSecond) {
+            if (!isOverloaded(now)) {
+                LOG_INFO << "Proxy: Decode overloaded (" << rate << " misses/s), switching layers to proxies";
+            }
+            overloadUntil_ = now + settings_.holdSeconds;
+        }
+        lastMisses_ = totalMisses;
+        lastMissTime_ = now;
+    }
+
+    std::set<std::string> seen;
+    for (const LayerState& layer : layers) {
+        seen.insert(layer.cueId);
+        Tracked& tracked = tracked_[layer.cueId];
+
+        // Scrubbing: the position jumps away from where playback takes it,
+        // twice in a row (a single locate or loop wrap is not a scrub)
+        if (tracked.frame >= 0 && layer.frame >= 0) {
+            double advance = layer.playing ? layer.framerate * layer.timeScale * (now - tracked.time) : 0.0;
+            double error = static_cast<double>(layer.frame) - (static_cast<double>(tracked.frame) + advance);
+            if (std::fabs(error) > static_cast<double>(settings_.scrubJumpFrames)) {
+                if (now - tracked.lastJump <= SCRUB_HOLD_SECONDS) {
+                    tracked.scrubUntil = now + SCRUB_HOLD_SECONDS;
+                }
+                tracked.lastJump = now;
+            }
+        }
+        tracked.frame = layer.frame;
+        tracked.time = now;
+
+        if (!result.cueId.empty() || layer.loadPending || now - tracked.lastSwitch < MIN_SWITCH_INTERVAL) {
+            continue;
+        }
+        std::string master = ProxyMedia::masterPathFor(layer.path);
+        bool onProxy = !master.empty();
+        if (!onProxy) {
+            master = layer.path;
+        }
+        const Media& entry = media(master);
+        if (!entry.valid) {
+            continue;
+        }
+
+        bool small = ProxyMedia::covers(entry.clip, entry.proxy, layer.displayWidth, layer.displayHeight);
+        bool scrubbing = now < tracked.scrubUntil;
+        bool overloaded = isOverloaded(now);
+        bool wantProxy = small || scrubbing || overloaded || layer.degraded;
+        if (wantProxy == onProxy) {
+            continue;
+        }
+        result.cueId = layer.cueId;
+        result.toProxy = wantProxy;
+        result.path = wantProxy ? ProxyMedia::proxyPathFor(master) : master;
+        result.reason = !wantProxy ? "conditions cleared" : small ? "shown small" : scrubbing ? "scrubbing"
+                      : overloaded ? "decode overload" : "degraded by load governor";
+        tracked.lastSwitch = now;
+    }
+
+    // Forget layers that are gone
+    for (auto it = tracked_.begin(); it != tracked_.end();) {
+        it = seen.count(it->first) ? std::next(it) : tracked_.erase(it);
+    }
+    return result;
+}
+
+} // namespace videocomposer
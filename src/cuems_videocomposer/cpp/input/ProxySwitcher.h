@@ -0,0 +1,114 @@
+#ifndef VIDEOCOMPOSER_PROXYSWITCHER_H
+#define VIDEOCOMPOSER_PROXYSWITCHER_H
+
+#include "ProxyMedia.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ProxySwitcher - When layers should play a clip's proxy instead of the clip
+ *
+ * A layer with a proxy (ProxyMedia) plays it while
+ * - it is shown no larger than the proxy (picture-in-picture, multiview)
+ * - decode is overloaded: underrun misses across all layers reach
+ *   loadMissesPerSecond (and for holdSeconds after they stop), or the
+ *   caller degrades it (DecodeGovernor, which then does the overload
+ *   detection per layer and priority)
+ * - it is being scrubbed: its position jumps away from where playback
+ *   would have taken it (and for SCRUB_HOLD_SECONDS after)
+ * and goes back to the clip when none of these holds.
+ *
+ * The switcher only decides; the caller loads the other file into the
+ * layer, which swaps it in gaplessly at a frame boundary. At most one
+ * switch is returned per update so loads are spread out.
+ */
+class ProxySwitcher {
+public:
+    static constexpr double SCRUB_HOLD_SECONDS = 2.0;
+    static constexpr double MIN_SWITCH_INTERVAL = 1.0;  // Per layer, against flapping
+
+    struct Settings {
+        bool enabled = true;
+        double loadMissesPerSecond = 2.0;  // 0 = no overload detection here
+        double holdSeconds = 10.0;
+        int64_t scrubJumpFrames = 12;  // Position error that counts as a scrub
+    };
+
+    /** One layer as seen by an update */
+    struct LayerState {
+        std::string cueId;
+        std::string path;          // File the layer plays
+        int displayWidth = 0;      // VideoLayer::getResolutionHint (0 = needs full)
+        int displayHeight = 0;
+        int64_t frame = -1;        // Current frame
+        double framerate = 0.0;
+        double timeScale = 1.0;
+        bool playing = false;
+        bool loadPending = false;  // A load for the layer is queued: leave it alone
+        bool degraded = false;     // The caller wants the proxy (load governor)
+    };
+
+    struct Switch {
+        std::string cueId;
+        std::string path;     // File to load into the layer
+        bool toProxy = false;
+        std::string reason;
+    };
+
+    using ProbeFunction = std::function<bool(const std::string& path, ProxyMedia::Probe& probe)>;
+
+    ProxySwitcher();
+
+    void configure(const Settings& settings) { settings_ = settings; }
+    const Settings& getSettings() const { return settings_; }
+
+    /** How files are probed (default ProxyMedia::probe); results are cached per clip */
+    void setProbeFunction(ProbeFunction probe) { probe_ = std::move(probe); }
+
+    /**
+     * @param layers Every layer playing a file
+     * @param totalMisses Underrun misses of all layers so far
+     * @param now Seconds on a monotonic clock
+     * @return The switch to make, if any (empty cueId = none)
+     */
+    Switch update(const std::vector<LayerState>& layers, uint64_t totalMisses, double now);
+
+    bool isOverloaded(double now) const { return now < overloadUntil_; }
+
+    /** Whether a file (clip or proxy) has a proxy that stands in for its clip */
+    bool hasProxy(const std::string& path);
+
+private:
+    struct Media {
+        bool valid = false;  // The proxy exists and matches the clip
+        ProxyMedia::Probe clip;
+        ProxyMedia::Probe proxy;
+    };
+
+    struct Tracked {
+        int64_t frame = -1;
+        double time = 0.0;
+        double lastJump = -1e9;
+        double scrubUntil = -1.0;
+        double lastSwitch = -1e9;
+    };
+
+    const Media& media(const std::string& masterPath);
+
+    Settings settings_;
+    ProbeFunction probe_;
+    std::map<std::string, Media> media_;      // By clip path
+    std::map<std::string, Tracked> tracked_;  // By cue ID
+    uint64_t lastMisses_;
+    double lastMissTime_;
+    double overloadUntil_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PROXYSWITCHER_H
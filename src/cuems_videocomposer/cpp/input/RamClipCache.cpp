@@ -0,0 +1,194 @@
+#include "RamClipCache.h"
+#include "../utils/Logger.h"
+#include "../video/MemoryBudget.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr size_t COPY_PIECE = 8 * 1024 * 1024;  // Abort is checked between pieces
+
+const MemoryBudget::Account CLIP_ACCOUNT(MemoryBudget::Subsystem::RAM_CLIPS, MemoryBudget::NO_LAYER);
+
+} // namespace
+
+RamClip::~RamClip() {
+    if (data_) {
+        if (locked_) {
+            munlock(data_, size_);
+        }
+        munmap(data_, size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+RamClipCache& RamClipCache::instance() {
+    MemoryBudget::instance();  // Constructed first, so it outlives clips released at exit
+    static RamClipCache cache;
+    return cache;
+}
+
+RamClipCache::RamClipCache()
+    : budgetBytes_(DEFAULT_BUDGET_BYTES)
+    , usedBytes_(0)
+{
+}
+
+void RamClipCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budgetBytes_ = bytes;
+}
+
+std::shared_ptr<const RamClip> RamClipCache::acquire(const std::string& path, const std::atomic<bool>* abort) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        LOG_WARNING << "Preload: Cannot read " << path << ", playing it from storage";
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    std::shared_ptr<const RamClip> existing;  // Released outside the lock (its deleter locks)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = clips_.find(path);
+        if (it != clips_.end()) {
+            existing = it->second.lock();
+            if (existing && existing->size() == size) {
+                return existing;  // Another layer preloaded it
+            }
+        }
+        if (usedBytes_ + size > budgetBytes_) {
+            LOG_WARNING << "Preload: " << path << " (" << size / (1024 * 1024) << " MB) exceeds the RAM budget ("
+                        << usedBytes_ / (1024 * 1024) << " of " << budgetBytes_ / (1024 * 1024)
+                        << " MB used), playing it from storage";
+            return nullptr;
+        }
+        usedBytes_ += size;  // Given back by the clip's deleter
+    }
+    existing.reset();
+
+    // The process-wide budget may evict prefetch caches to make room
+    if (!MemoryBudget::instance().reserve(CLIP_ACCOUNT, size)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            usedBytes_ -= std::min(usedBytes_, size);
+        }
+        LOG_WARNING << "Preload: " << path << " (" << size / (1024 * 1024)
+                    << " MB) exceeds the memory budget, playing it from storage";
+        return nullptr;
+    }
+
+    std::shared_ptr<RamClip> clip = load(path, size, abort);
+    if (clip) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clips_[path] = clip;
+    }
+    return clip;
+}
+
+std::shared_ptr<RamClip> RamClipCache::load(const std::string& path, size_t size, const std::atomic<bool>* abort) {
+    // Created first: failures below return the reserved budget through release()
+    std::shared_ptr<RamClip> clip(new RamClip, [this](RamClip* c) { release(c); });
+    clip->size_ = size;
+    clip->sourcePath_ = path;
+
+    int source = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source < 0) {
+        LOG_WARNING << "Preload: Cannot open " << path << ": " << strerror(errno);
+        return nullptr;
+    }
+    posix_fadvise(source, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    clip->fd_ = memfd_create("cuems-clip", MFD_CLOEXEC);
+    bool ok = clip->fd_ >= 0 && ftruncate(clip->fd_, static_cast<off_t>(size)) == 0;
+    if (ok) {
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, clip->fd_, 0);
+        ok = data != MAP_FAILED;
+        if (ok) {
+            clip->data_ = data;
+#ifdef MADV_HUGEPAGE
+            madvise(data, size, MADV_HUGEPAGE);  // Only honoured with shmem THP enabled
+#endif
+        }
+    }
+    if (!ok) {
+        LOG_WARNING << "Preload: Cannot allocate " << size / (1024 * 1024) << " MB for " << path << ": "
+                    << strerror(errno);
+        ::close(source);
+        return nullptr;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(clip->data_);
+    size_t done = 0;
+    while (done < size) {
+        if (abort && *abort) {
+            ::close(source);
+            return nullptr;
+        }
+        ssize_t n = pread(source, out + done, std::min(COPY_PIECE, size - done), static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            LOG_WARNING << "Preload: Read of " << path << " failed at " << done << " bytes";
+            ::close(source);
+            return nullptr;
+        }
+        done += static_cast<size_t>(n);
+    }
+    ::close(source);
+
+    clip->locked_ = mlock(clip->data_, size) == 0;
+    if (!clip->locked_) {
+        LOG_WARNING << "Preload: Could not lock " << path << " in memory (" << strerror(errno)
+                    << ", raise RLIMIT_MEMLOCK); it may be swapped out";
+    }
+    clip->path_ = "/proc/self/fd/" + std::to_string(clip->fd_);
+    LOG_INFO << "Preload: " << path << " in RAM (" << size / (1024 * 1024) << " MB"
+             << (clip->locked_ ? ", locked)" : ")");
+    return clip;
+}
+
+void RamClipCache::release(RamClip* clip) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        usedBytes_ -= std::min(usedBytes_, clip->size_);
+        auto it = clips_.find(clip->sourcePath_);
+        if (it != clips_.end() && it->second.expired()) {
+            clips_.erase(it);
+        }
+    }
+    MemoryBudget::instance().release(CLIP_ACCOUNT, clip->size_);
+    delete clip;
+}
+
+RamClipCache::Stats RamClipCache::getStats() const {
+    std::vector<std::shared_ptr<const RamClip>> live;  // Released outside the lock
+    Stats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : clips_) {
+        std::shared_ptr<const RamClip> clip = entry.second.lock();
+        if (clip) {
+            stats.clips++;
+            stats.bytes += clip->size();
+            if (clip->isLocked()) {
+                stats.lockedBytes += clip->size();
+            }
+            live.push_back(std::move(clip));
+        }
+    }
+    stats.budgetBytes = budgetBytes_;
+    return stats;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,95 @@
+#ifndef VIDEOCOMPOSER_RAMCLIPCACHE_H
+#define VIDEOCOMPOSER_RAMCLIPCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * RamClip - A media file copied into locked, anonymous memory
+ *
+ * The copy lives in a memfd, so demuxers open it like a file (path()) and
+ * never touch the storage it came from. The mapping is mlock()ed (and
+ * asks for transparent huge pages) so it is not paged out during a show.
+ */
+class RamClip {
+public:
+    ~RamClip();
+
+    RamClip(const RamClip&) = delete;
+    RamClip& operator=(const RamClip&) = delete;
+
+    /** Path of the RAM copy (/proc/self/fd/N) */
+    const std::string& path() const { return path_; }
+    const std::string& sourcePath() const { return sourcePath_; }
+    size_t size() const { return size_; }
+    bool isLocked() const { return locked_; }
+
+private:
+    friend class RamClipCache;
+    RamClip() = default;
+
+    int fd_ = -1;
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    bool locked_ = false;
+    std::string path_;
+    std::string sourcePath_;
+};
+
+/**
+ * RamClipCache - Process-wide RAM-resident clips under a memory budget
+ *
+ * Layers flagged for preload get their whole file read into RAM at load
+ * time. Layers preloading the same file share one copy; it is freed with
+ * the last layer using it. A file that does not fit the budget is not
+ * preloaded (the layer plays it from storage).
+ */
+class RamClipCache {
+public:
+    static constexpr size_t DEFAULT_BUDGET_BYTES = 2048ULL * 1024 * 1024;
+
+    struct Stats {
+        size_t clips = 0;
+        size_t bytes = 0;
+        size_t lockedBytes = 0;
+        size_t budgetBytes = 0;
+    };
+
+    static RamClipCache& instance();
+
+    RamClipCache();
+
+    /**
+     * @param bytes Memory all preloaded clips may use together
+     */
+    void setBudget(size_t bytes);
+
+    /**
+     * Get the RAM copy of a file, reading it if no layer holds one yet
+     * @param abort Stops the copy once it becomes true (may be nullptr)
+     * @return nullptr if the file cannot be read or does not fit the budget
+     */
+    std::shared_ptr<const RamClip> acquire(const std::string& path, const std::atomic<bool>* abort = nullptr);
+
+    Stats getStats() const;
+
+private:
+    std::shared_ptr<RamClip> load(const std::string& path, size_t size, const std::atomic<bool>* abort);
+    void release(RamClip* clip);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::weak_ptr<const RamClip>> clips_;
+    size_t budgetBytes_;
+    size_t usedBytes_;  // Reserved by live clips and copies in progress
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_RAMCLIPCACHE_H
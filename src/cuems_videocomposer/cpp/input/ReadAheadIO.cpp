@@ -0,0 +1,391 @@
+#include "ReadAheadIO.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+constexpr int AVIO_BUFFER_SIZE = 256 * 1024;  // Demuxer-side buffer, filled from chunks
+
+// statfs f_type values (linux/magic.h)
+constexpr long NFS_SUPER_MAGIC = 0x6969;
+constexpr long SMB_SUPER_MAGIC = 0x517B;
+constexpr long CIFS_SUPER_MAGIC = 0xFF534D42;
+constexpr long SMB2_SUPER_MAGIC = 0xFE534D42;
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+} // namespace
+
+ReadAheadIO::Mode ReadAheadIO::parseMode(const std::string& name) {
+    if (name == "off") {
+        return Mode::OFF;
+    }
+    if (name == "on") {
+        return Mode::ON;
+    }
+    return Mode::AUTO;
+}
+
+bool ReadAheadIO::isNetworkPath(const std::string& path) {
+    struct statfs fs;
+    if (statfs(path.c_str(), &fs) != 0) {
+        return false;
+    }
+    long type = static_cast<long>(static_cast<unsigned long>(fs.f_type) & 0xFFFFFFFFUL);
+    return type == NFS_SUPER_MAGIC || type == SMB_SUPER_MAGIC ||
+           type == CIFS_SUPER_MAGIC || type == SMB2_SUPER_MAGIC;
+}
+
+bool ReadAheadIO::wanted(Mode mode, const std::string& path) {
+    return mode == Mode::ON || (mode == Mode::AUTO && isNetworkPath(path));
+}
+
+ReadAheadIO::ReadAheadIO()
+    : fd_(-1)
+    , direct_(false)
+    , fileSize_(0)
+    , position_(0)
+    , windowChunks_(DEFAULT_WINDOW_BYTES / CHUNK_SIZE)
+    , avio_(nullptr)
+    , stop_(false)
+    , readBusyUs_(0)
+{
+}
+
+ReadAheadIO::~ReadAheadIO() {
+    close();
+}
+
+bool ReadAheadIO::open(const std::string& path, size_t windowBytes, bool direct) {
+    close();
+
+    // Chunks are aligned in the file and in memory, as O_DIRECT requires
+    direct_ = false;
+    if (direct) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        direct_ = fd_ >= 0;
+        if (!direct_) {
+            LOG_WARNING << "Read-ahead I/O: O_DIRECT not available for " << path << ", using cached reads";
+        }
+    }
+    if (fd_ < 0) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    fileSize_ = static_cast<int64_t>(st.st_size);
+    position_ = 0;
+    windowChunks_ = std::max<size_t>(1, (windowBytes + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    // We do our own read-ahead: keep the kernel's from doubling it
+    if (!direct_) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_RANDOM);
+    }
+
+    unsigned char* buffer = static_cast<unsigned char*>(av_malloc(AVIO_BUFFER_SIZE));
+    avio_ = buffer ? avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this,
+                                        &ReadAheadIO::readCallback, nullptr,
+                                        &ReadAheadIO::seekCallback) : nullptr;
+    if (!avio_) {
+        av_free(buffer);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    stop_ = false;
+    stats_ = Stats();
+    readBusyUs_ = 0;
+    for (size_t i = 0; i < READ_THREADS; ++i) {
+        workers_.emplace_back(&ReadAheadIO::workerThreadFunc, this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readAheadLocked(0);
+    }
+
+    LOG_INFO << "Read-ahead I/O: " << path << " (" << windowChunks_ << " x "
+             << CHUNK_SIZE / 1024 << " KB window" << (direct_ ? ", O_DIRECT)" : ")");
+    return true;
+}
+
+void ReadAheadIO::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCond_.notify_all();
+    readyCond_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    for (auto& entry : chunks_) {
+        free(entry.second.data);
+    }
+    chunks_.clear();
+    queue_.clear();
+    for (uint8_t* data : spare_) {
+        free(data);
+    }
+    spare_.clear();
+
+    if (avio_) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    fileSize_ = 0;
+    position_ = 0;
+}
+
+int ReadAheadIO::readCallback(void* opaque, uint8_t* buffer, int size) {
+    return static_cast<ReadAheadIO*>(opaque)->read(buffer, size);
+}
+
+int64_t ReadAheadIO::seekCallback(void* opaque, int64_t offset, int whence) {
+    return static_cast<ReadAheadIO*>(opaque)->seek(offset, whence);
+}
+
+int64_t ReadAheadIO::chunkCount() const {
+    return (fileSize_ + static_cast<int64_t>(CHUNK_SIZE) - 1) / static_cast<int64_t>(CHUNK_SIZE);
+}
+
+int ReadAheadIO::read(uint8_t* buffer, int size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ < 0 || size <= 0) {
+        return AVERROR(EINVAL);
+    }
+    if (position_ >= fileSize_) {
+        return AVERROR_EOF;
+    }
+
+    int64_t index = position_ / static_cast<int64_t>(CHUNK_SIZE);
+    requestLocked(index, true);
+    readAheadLocked(index);
+
+    auto it = chunks_.find(index);
+    if (it->second.state != ChunkState::READY && it->second.state != ChunkState::FAILED) {
+        // Storage is behind the demuxer
+        auto start = std::chrono::steady_clock::now();
+        readyCond_.wait(lock, [&]() {
+            it = chunks_.find(index);
+            return stop_ || it == chunks_.end() ||
+                   it->second.state == ChunkState::READY || it->second.state == ChunkState::FAILED;
+        });
+        uint64_t waited = elapsedUs(start);
+        stats_.stalls++;
+        stats_.stallUs += waited;
+        stats_.maxStallUs = std::max(stats_.maxStallUs, waited);
+        if (stop_ || it == chunks_.end()) {
+            return AVERROR_EXIT;
+        }
+    }
+    if (it->second.state == ChunkState::FAILED) {
+        if (it->second.data) {
+            spare_.push_back(it->second.data);
+        }
+        chunks_.erase(it);  // Retried on the next read
+        return AVERROR(EIO);
+    }
+
+    size_t offset = static_cast<size_t>(position_ - index * static_cast<int64_t>(CHUNK_SIZE));
+    if (offset >= it->second.length) {
+        return AVERROR_EOF;  // File shrank under us
+    }
+    size_t count = std::min(static_cast<size_t>(size), it->second.length - offset);
+    memcpy(buffer, it->second.data + offset, count);
+    position_ += static_cast<int64_t>(count);
+    stats_.bytesServed += count;
+    return static_cast<int>(count);
+}
+
+int64_t ReadAheadIO::seek(int64_t offset, int whence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE) {
+        return fileSize_;
+    }
+    int64_t target;
+    switch (whence) {
+        case SEEK_SET: target = offset; break;
+        case SEEK_CUR: target = position_ + offset; break;
+        case SEEK_END: target = fileSize_ + offset; break;
+        default: return AVERROR(EINVAL);
+    }
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
+
+    int64_t oldIndex = position_ / static_cast<int64_t>(CHUNK_SIZE);
+    int64_t index = target / static_cast<int64_t>(CHUNK_SIZE);
+    position_ = target;
+    if (index != oldIndex) {
+        stats_.seeks++;
+        // Reads queued for the old position are not needed any more
+        evictLocked(index);
+        std::deque<int64_t> keep;
+        for (int64_t queued : queue_) {
+            if (chunks_.count(queued)) {
+                keep.push_back(queued);
+            }
+        }
+        queue_.swap(keep);
+        requestLocked(index, true);
+        readAheadLocked(index);
+    }
+    return target;
+}
+
+void ReadAheadIO::requestLocked(int64_t index, bool urgent) {
+    if (index < 0 || index >= chunkCount()) {
+        return;
+    }
+    auto it = chunks_.find(index);
+    if (it != chunks_.end()) {
+        if (urgent && it->second.state == ChunkState::QUEUED) {
+            // Move to the front: the demuxer waits for it
+            queue_.erase(std::remove(queue_.begin(), queue_.end(), index), queue_.end());
+            queue_.push_front(index);
+            workCond_.notify_one();
+        }
+        return;
+    }
+    chunks_[index].state = ChunkState::QUEUED;
+    if (urgent) {
+        queue_.push_front(index);
+    } else {
+        queue_.push_back(index);
+    }
+    workCond_.notify_one();
+}
+
+void ReadAheadIO::readAheadLocked(int64_t index) {
+    evictLocked(index);
+    for (size_t i = 1; i <= windowChunks_; ++i) {
+        requestLocked(index + static_cast<int64_t>(i), false);
+    }
+}
+
+void ReadAheadIO::evictLocked(int64_t index) {
+    // Keep the previous chunk (demuxers step back a little) and the window
+    int64_t first = index - 1;
+    int64_t last = index + static_cast<int64_t>(windowChunks_);
+    for (auto it = chunks_.begin(); it != chunks_.end();) {
+        bool outside = it->first < first || it->first > last;
+        if (outside && it->second.state != ChunkState::LOADING) {
+            if (it->second.data) {
+                spare_.push_back(it->second.data);
+            }
+            it = chunks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ReadAheadIO::workerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::IO);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workCond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+        int64_t index = queue_.front();
+        queue_.pop_front();
+        auto it = chunks_.find(index);
+        if (it == chunks_.end() || it->second.state != ChunkState::QUEUED) {
+            continue;
+        }
+        Chunk& chunk = it->second;  // LOADING chunks are never erased
+        chunk.state = ChunkState::LOADING;
+        uint8_t* data = chunk.data;
+        if (!data && !spare_.empty()) {
+            data = spare_.back();
+            spare_.pop_back();
+        }
+        lock.unlock();
+
+        if (!data) {
+            void* aligned = nullptr;
+            if (posix_memalign(&aligned, ALIGNMENT, CHUNK_SIZE) == 0) {
+                data = static_cast<uint8_t*>(aligned);
+            }
+        }
+        off_t offset = static_cast<off_t>(index) * static_cast<off_t>(CHUNK_SIZE);
+        size_t wanted = static_cast<size_t>(std::min<int64_t>(CHUNK_SIZE, fileSize_ - offset));
+        // O_DIRECT lengths are whole blocks: the file's last block comes back short
+        size_t request = direct_ ? (wanted + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT : wanted;
+        size_t done = 0;
+        bool failed = data == nullptr;
+        auto start = std::chrono::steady_clock::now();
+        while (!failed && done < wanted) {
+            ssize_t n = pread(fd_, data + done, request - done, offset + static_cast<off_t>(done));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed = n < 0;
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        done = std::min(done, wanted);
+        uint64_t busy = elapsedUs(start);
+
+        lock.lock();
+        chunk.data = data;
+        chunk.length = done;
+        chunk.state = failed ? ChunkState::FAILED : ChunkState::READY;
+        if (!failed) {
+            stats_.bytesRead += done;
+            stats_.chunkReads++;
+            readBusyUs_ += busy;
+        } else {
+            LOG_WARNING << "Read-ahead I/O: read failed at offset " << offset << ": " << strerror(errno);
+        }
+        readyCond_.notify_all();
+    }
+}
+
+ReadAheadIO::Stats ReadAheadIO::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    if (readBusyUs_ > 0) {
+        stats.throughputMBs = static_cast<double>(stats_.bytesRead) / static_cast<double>(readBusyUs_);
+    }
+    return stats;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,135 @@
+#ifndef VIDEOCOMPOSER_READAHEADIO_H
+#define VIDEOCOMPOSER_READAHEADIO_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AVIOContext;
+
+namespace videocomposer {
+
+/**
+ * ReadAheadIO - AVIOContext with large asynchronous reads for network media
+ *
+ * libavformat's file protocol reads a few KB at a time, synchronously, on
+ * the demuxing thread. On NFS/SMB every short read can be a round trip, so
+ * high-bitrate files (ProRes, DNxHR) stall the decode-ahead thread.
+ *
+ * This context reads the file in CHUNK_SIZE blocks (aligned in the file and
+ * in memory) on READ_THREADS worker threads and serves the demuxer from
+ * memory:
+ * - Sequential read-ahead keeps a window of chunks in flight past the
+ *   read position.
+ * - A seek drops queued chunks outside the new window and reads the target
+ *   chunk first. Demuxers seek to the keyframe's byte offset, so the GOP
+ *   the decoder needs next is what gets fetched.
+ * - Stalls (the demuxer waiting for a chunk) and storage throughput are
+ *   counted for /stats/io.
+ */
+class ReadAheadIO {
+public:
+    enum class Mode {
+        OFF,    // libavformat's own file I/O
+        AUTO,   // Only for files on network filesystems (NFS, SMB/CIFS)
+        ON      // Every file
+    };
+
+    static constexpr size_t CHUNK_SIZE = 1024 * 1024;  // Bytes per storage read
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr size_t READ_THREADS = 2;
+    static constexpr size_t DEFAULT_WINDOW_BYTES = 16 * CHUNK_SIZE;
+
+    struct Stats {
+        uint64_t bytesRead = 0;     // From storage
+        uint64_t bytesServed = 0;   // To the demuxer
+        uint64_t chunkReads = 0;
+        uint64_t seeks = 0;
+        uint64_t stalls = 0;        // Demuxer reads that had to wait for storage
+        uint64_t stallUs = 0;
+        uint64_t maxStallUs = 0;
+        double throughputMBs = 0.0; // Storage read rate while reading
+    };
+
+    /** "off", "auto" or "on" (anything else = AUTO) */
+    static Mode parseMode(const std::string& name);
+
+    /** Check if a path is on NFS or SMB/CIFS */
+    static bool isNetworkPath(const std::string& path);
+
+    /** Check if mode asks for read-ahead on this path */
+    static bool wanted(Mode mode, const std::string& path);
+
+    ReadAheadIO();
+    ~ReadAheadIO();
+
+    /**
+     * Open a file and create the AVIOContext
+     * @param windowBytes Read-ahead window (rounded up to whole chunks)
+     * @param direct Read with O_DIRECT, bypassing the page cache (falls back
+     *        to cached reads where the filesystem does not support it)
+     */
+    bool open(const std::string& path, size_t windowBytes = DEFAULT_WINDOW_BYTES, bool direct = false);
+    void close();
+
+    /**
+     * Context for AVFormatContext::pb (set AVFMT_FLAG_CUSTOM_IO; owned here,
+     * close the format context first)
+     */
+    AVIOContext* getContext() const { return avio_; }
+
+    // AVIO callbacks (also used directly by tests)
+    int read(uint8_t* buffer, int size);
+    int64_t seek(int64_t offset, int whence);
+
+    int64_t getFileSize() const { return fileSize_; }
+    bool isDirect() const { return direct_; }
+    Stats getStats() const;
+
+private:
+    enum class ChunkState { QUEUED, LOADING, READY, FAILED };
+
+    struct Chunk {
+        ChunkState state = ChunkState::QUEUED;
+        uint8_t* data = nullptr;  // CHUNK_SIZE, ALIGNMENT-aligned
+        size_t length = 0;
+    };
+
+    static int readCallback(void* opaque, uint8_t* buffer, int size);
+    static int64_t seekCallback(void* opaque, int64_t offset, int whence);
+
+    void workerThreadFunc();
+    void requestLocked(int64_t index, bool urgent);
+    void readAheadLocked(int64_t index);
+    void evictLocked(int64_t index);
+    int64_t chunkCount() const;
+
+    int fd_;
+    bool direct_;
+    int64_t fileSize_;
+    int64_t position_;
+    size_t windowChunks_;
+    AVIOContext* avio_;
+
+    std::map<int64_t, Chunk> chunks_;
+    std::deque<int64_t> queue_;     // QUEUED chunks, next to read first
+    std::vector<uint8_t*> spare_;   // Buffers of evicted chunks
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable workCond_;
+    std::condition_variable readyCond_;
+    bool stop_;
+
+    Stats stats_;
+    uint64_t readBusyUs_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_READAHEADIO_H
@@ -0,0 +1,168 @@
+#include "RenderNodeManager.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+
+namespace videocomposer {
+
+RenderNodeManager& RenderNodeManager::instance() {
+    static RenderNodeManager manager;
+    return manager;
+}
+
+RenderNodeManager::RenderNodeManager()
+    : probe_(&RenderNodeManager::probeVaapi)
+    , nextId_(1)
+{
+}
+
+void RenderNodeManager::setProbe(Probe probe) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    probe_ = probe ? probe : Probe(&RenderNodeManager::probeVaapi);
+}
+
+bool RenderNodeManager::probeVaapi(const std::string& path) {
+    AVBufferRef* device = nullptr;
+    if (av_hwdevice_ctx_create(&device, AV_HWDEVICE_TYPE_VAAPI, path.c_str(), nullptr, 0) < 0) {
+        return false;
+    }
+    av_buffer_unref(&device);
+    return true;
+}
+
+size_t RenderNodeManager::enumerate(const std::string& primaryPath) {
+    std::vector<std::string> paths;
+    DIR* dir = opendir("/dev/dri");
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (strncmp(entry->d_name, "renderD", 7) == 0) {
+                paths.push_back(std::string("/dev/dri/") + entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(paths.begin(), paths.end());
+    return setNodes(paths, primaryPath);
+}
+
+size_t RenderNodeManager::setNodes(const std::vector<std::string>& paths, const std::string& primaryPath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_.clear();
+    sessions_.clear();
+    for (const std::string& path : paths) {
+        if (!probe_(path)) {
+            LOG_VERBOSE << "RenderNodeManager: " << path << " cannot decode (no VAAPI device)";
+            continue;
+        }
+        Node node;
+        node.path = path;
+        node.primary = path == primaryPath;
+        nodes_.push_back(node);
+    }
+    if (!nodes_.empty() && std::none_of(nodes_.begin(), nodes_.end(), [](const Node& n) { return n.primary; })) {
+        if (!primaryPath.empty()) {
+            LOG_WARNING << "RenderNodeManager: Primary node " << primaryPath << " cannot decode, using "
+                        << nodes_.front().path;
+        }
+        nodes_.front().primary = true;
+    }
+    for (const Node& node : nodes_) {
+        LOG_INFO << "RenderNodeManager: Decode node " << node.path << (node.primary ? " (compositing GPU)" : "");
+    }
+    return nodes_.size();
+}
+
+RenderNodeManager::SessionId RenderNodeManager::acquire(int width, int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (nodes_.size() < 2) {
+        return 0;
+    }
+
+    // Least loaded shareable node; the compositing GPU (always usable) wins ties
+    size_t best = nodes_.size();
+    uint64_t bestLoad = 0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        const Node& node = nodes_[i];
+        if (!node.shareable && !node.primary) {
+            continue;
+        }
+        uint64_t load = node.pixels + static_cast<uint64_t>(node.sessions) * SESSION_COST_PIXELS;
+        if (best == nodes_.size() || load < bestLoad || (load == bestLoad && node.primary)) {
+            best = i;
+            bestLoad = load;
+        }
+    }
+    if (best == nodes_.size()) {
+        return 0;
+    }
+
+    Session session;
+    session.node = best;
+    session.pixels = static_cast<uint64_t>(std::max(width, 0)) * static_cast<uint64_t>(std::max(height, 0));
+    nodes_[best].sessions++;
+    nodes_[best].pixels += session.pixels;
+    SessionId id = nextId_++;
+    sessions_[id] = session;
+    return id;
+}
+
+void RenderNodeManager::release(SessionId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+        return;
+    }
+    Node& node = nodes_[it->second.node];
+    node.sessions--;
+    node.pixels -= it->second.pixels;
+    sessions_.erase(it);
+}
+
+std::string RenderNodeManager::getPath(SessionId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    return it != sessions_.end() ? nodes_[it->second.node].path : std::string();
+}
+
+std::string RenderNodeManager::getPrimaryPath() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Node& node : nodes_) {
+        if (node.primary) {
+            return node.path;
+        }
+    }
+    return std::string();
+}
+
+bool RenderNodeManager::isPrimary(SessionId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    return it == sessions_.end() || nodes_[it->second.node].primary;
+}
+
+void RenderNodeManager::reportShareFailure(SessionId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+        return;
+    }
+    Node& node = nodes_[it->second.node];
+    if (!node.primary && node.shareable) {
+        node.shareable = false;
+        LOG_WARNING << "RenderNodeManager: Frames from " << node.path
+                    << " cannot be imported by the compositing GPU, no new decoders go there";
+    }
+}
+
+std::vector<RenderNodeManager::Node> RenderNodeManager::getNodes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nodes_;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,108 @@
+#ifndef VIDEOCOMPOSER_RENDERNODEMANAGER_H
+#define VIDEOCOMPOSER_RENDERNODEMANAGER_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * RenderNodeManager - Spreads VAAPI decode sessions over the DRM render nodes
+ *
+ * Every /dev/dri/renderD* node that can open a VAAPI device is a decode
+ * node. Each hardware decoder asks for a node when it opens and gets the
+ * least loaded one, where the load is the pixels of the sessions already
+ * on a node plus a fixed cost per session. The primary node (the GPU that
+ * composites) wins ties; frames decoded on the others reach it as
+ * DMA-BUF (PRIME) imports.
+ *
+ * A node whose frames the compositing GPU cannot import (the exported
+ * format modifier is not accepted) is marked unshareable and gets no new
+ * sessions: its frames would go through system memory.
+ *
+ * With fewer than two nodes every session gets id 0 (the default device).
+ */
+class RenderNodeManager {
+public:
+    using SessionId = uint64_t;
+
+    /** Whether the node at the path can decode (VAAPI device opens) */
+    using Probe = std::function<bool(const std::string& path)>;
+
+    /** Per-session cost in pixels, so many small layers still spread out */
+    static constexpr uint64_t SESSION_COST_PIXELS = 1920 * 1080 / 4;
+
+    struct Node {
+        std::string path;
+        bool primary = false;
+        bool shareable = true;
+        int sessions = 0;
+        uint64_t pixels = 0;
+    };
+
+    /**
+     * Shared instance (no nodes until enumerated)
+     */
+    static RenderNodeManager& instance();
+
+    RenderNodeManager();
+
+    void setProbe(Probe probe);
+
+    /**
+     * Probe every /dev/dri/renderD* node
+     * @param primaryPath Node of the compositing GPU ("" = the first decode node)
+     * @return Number of decode nodes
+     */
+    size_t enumerate(const std::string& primaryPath = "");
+
+    /**
+     * Probe these nodes instead of scanning /dev/dri
+     * @return Number of decode nodes
+     */
+    size_t setNodes(const std::vector<std::string>& paths, const std::string& primaryPath = "");
+
+    /**
+     * Assign a decoder to the least loaded node
+     * @return Session id (0 = use the default device)
+     */
+    SessionId acquire(int width, int height);
+    void release(SessionId id);
+
+    /** Node path of a session ("" for id 0 or unknown) */
+    std::string getPath(SessionId id) const;
+
+    /** Node of the compositing GPU ("" before enumeration) */
+    std::string getPrimaryPath() const;
+
+    /** Whether a session decodes on the compositing GPU (true for id 0) */
+    bool isPrimary(SessionId id) const;
+
+    /** Frames of the session's node could not be imported by the compositing GPU */
+    void reportShareFailure(SessionId id);
+
+    std::vector<Node> getNodes() const;
+
+    /** Default probe: a VAAPI device can be created on the node */
+    static bool probeVaapi(const std::string& path);
+
+private:
+    struct Session {
+        size_t node = 0;
+        uint64_t pixels = 0;
+    };
+
+    Probe probe_;
+    mutable std::mutex mutex_;
+    std::vector<Node> nodes_;
+    std::map<SessionId, Session> sessions_;
+    SessionId nextId_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_RENDERNODEMANAGER_H
@@ -0,0 +1,51 @@
+#include "ReverseFrameRing.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+ReverseFrameRing::Segment ReverseFrameRing::plan(int64_t targetFrame, int64_t keyframe, size_t capacity) {
+    Segment segment;
+    if (targetFrame < 0 || capacity == 0) {
+        return segment;
+    }
+    keyframe = std::max<int64_t>(0, std::min(keyframe, targetFrame));
+
+    segment.decodeFrom = keyframe;
+    segment.keepTo = targetFrame;
+    // GOPs longer than the ring are served in several passes from the same keyframe
+    segment.keepFrom = std::max(keyframe, targetFrame - static_cast<int64_t>(capacity) + 1);
+    return segment;
+}
+
+void ReverseFrameRing::setPool(std::shared_ptr<FramePool> pool) {
+    clear();
+    pool_ = std::move(pool);
+}
+
+FramePool::Handle ReverseFrameRing::store(int64_t frameNumber) {
+    if (!pool_ || (!frames_.empty() && frameNumber <= frames_.back()->frameNumber)) {
+        return nullptr;
+    }
+    FramePool::Handle slot = pool_->acquire();
+    if (!slot) {
+        return nullptr;
+    }
+    slot->frameNumber = frameNumber;
+    frames_.push_back(slot);
+    return slot;
+}
+
+FramePool::Handle ReverseFrameRing::find(int64_t frameNumber) const {
+    auto it = std::lower_bound(frames_.begin(), frames_.end(), frameNumber,
+        [](const FramePool::Handle& slot, int64_t frame) { return slot->frameNumber < frame; });
+    if (it == frames_.end() || (*it)->frameNumber != frameNumber) {
+        return nullptr;
+    }
+    return *it;
+}
+
+void ReverseFrameRing::clear() {
+    frames_.clear();
+}
+
+} // namespace videocomposer
@@ -0,0 +1,78 @@
+#ifndef VIDEOCOMPOSER_REVERSEFRAMERING_H
+#define VIDEOCOMPOSER_REVERSEFRAMERING_H
+
+#include "../video/FramePool.h"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ReverseFrameRing - Decoded frames of one GOP segment for reverse playback
+ *
+ * Long-GOP codecs can only decode forward from a keyframe. Instead of
+ * seeking back and decoding forward for every frame shown, VideoFileInput
+ * decodes a whole segment (keyframe up to the requested frame) once, keeps
+ * the last capacity() frames here and serves them in reverse order. The
+ * next refill covers the frames just before the segment.
+ *
+ * Slots come from a dedicated FramePool sized from the reverse cache
+ * budget: CPU buffers for software decode, AVFrame surface references
+ * for hardware decode.
+ */
+class ReverseFrameRing {
+public:
+    static constexpr size_t MAX_FRAMES = 120;
+
+    /**
+     * Frames to decode and keep for one refill
+     */
+    struct Segment {
+        int64_t decodeFrom = -1;  // Keyframe the decoder starts at
+        int64_t keepFrom = -1;    // First frame stored in the ring
+        int64_t keepTo = -1;      // Last frame stored (the requested frame)
+    };
+
+    /**
+     * Plan the refill that serves targetFrame
+     * @param keyframe Seek keyframe of targetFrame (from the frame index)
+     * @param capacity Frames the ring can hold
+     */
+    static Segment plan(int64_t targetFrame, int64_t keyframe, size_t capacity);
+
+    /**
+     * Use a new pool (drops all frames)
+     */
+    void setPool(std::shared_ptr<FramePool> pool);
+    std::shared_ptr<FramePool> getPool() const { return pool_; }
+
+    size_t capacity() const { return pool_ ? pool_->capacity() : 0; }
+    size_t size() const { return frames_.size(); }
+
+    /**
+     * Take a slot for a frame of the segment being decoded
+     * @return Slot to decode into, or nullptr if the ring is full
+     */
+    FramePool::Handle store(int64_t frameNumber);
+
+    /**
+     * Look up a stored frame
+     * @return Slot, or nullptr if not in the ring
+     */
+    FramePool::Handle find(int64_t frameNumber) const;
+
+    /**
+     * Drop all frames (slots return to the pool)
+     */
+    void clear();
+
+private:
+    std::shared_ptr<FramePool> pool_;
+    std::vector<FramePool::Handle> frames_;  // Ascending frame numbers
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_REVERSEFRAMERING_H
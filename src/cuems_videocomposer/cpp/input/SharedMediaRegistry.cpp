@@ -0,0 +1,177 @@
+#include "SharedMediaRegistry.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <sys/stat.h>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr size_t MAX_SPARE_FRAMES = 4;  // Recycled buffers kept per file
+
+} // namespace
+
+SharedMediaRegistry& SharedMediaRegistry::instance() {
+    static SharedMediaRegistry registry;
+    return registry;
+}
+
+SharedMediaRegistry::SharedMediaRegistry()
+    : frameHits_(0)
+    , indexHits_(0)
+{
+}
+
+void SharedMediaRegistry::addUser(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Media& media = media_[path];
+    media.users++;
+    if (media.users == 2) {
+        LOG_INFO << "Shared media: " << path << " is on several layers, sharing decoded frames";
+    }
+}
+
+void SharedMediaRegistry::removeUser(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = media_.find(path);
+    if (it == media_.end()) {
+        return;
+    }
+    Media& media = it->second;
+    media.users = std::max(0, media.users - 1);
+    if (media.users < 2) {
+        dropFramesLocked(media);
+    }
+    if (media.users == 0) {
+        media_.erase(it);  // Index goes with the last layer
+    }
+}
+
+bool SharedMediaRegistry::isShared(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = media_.find(path);
+    return it != media_.end() && it->second.users >= 2;
+}
+
+bool SharedMediaRegistry::findFrame(const std::string& path, int64_t frameNumber, FrameBuffer& buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = media_.find(path);
+    if (it == media_.end() || it->second.users < 2) {
+        return false;
+    }
+    for (const auto& entry : it->second.recent) {
+        if (entry.first == frameNumber && entry.second->isValid()) {
+            const FrameBuffer& frame = *entry.second;
+            frameHits_++;
+            return buffer.wrap(frame.data(), frame.size(), frame.info(), entry.second);
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<FrameBuffer> SharedMediaRegistry::acquireFrame(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = media_.find(path);
+    if (it != media_.end()) {
+        auto& spare = it->second.spare;
+        for (auto sp = spare.begin(); sp != spare.end(); ++sp) {
+            // Only the registry holds it: no layer shows this frame any more
+            if (sp->use_count() == 1) {
+                std::shared_ptr<FrameBuffer> frame = std::move(*sp);
+                spare.erase(sp);
+                return frame;
+            }
+        }
+    }
+    return std::make_shared<FrameBuffer>();
+}
+
+void SharedMediaRegistry::publishFrame(const std::string& path, int64_t frameNumber,
+                                       std::shared_ptr<FrameBuffer> frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = media_.find(path);
+    if (it == media_.end() || it->second.users < 2 || !frame) {
+        return;
+    }
+    Media& media = it->second;
+    media.recent.emplace_front(frameNumber, std::move(frame));
+    while (media.recent.size() > RECENT_FRAMES) {
+        if (media.spare.size() < MAX_SPARE_FRAMES) {
+            media.spare.push_back(std::move(media.recent.back().second));
+        }
+        media.recent.pop_back();
+    }
+}
+
+void SharedMediaRegistry::dropFramesLocked(Media& media) {
+    media.recent.clear();
+    media.spare.clear();
+}
+
+bool SharedMediaRegistry::identify(const std::string& path, uint64_t& size, int64_t& mtimeNs) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool SharedMediaRegistry::findIndex(const std::string& path, std::vector<FrameIndexCache::Entry>& entries,
+                                    FrameIndexCache::Metadata& meta) {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    if (!identify(path, size, mtimeNs)) {
+        return false;
+    }
+    std::shared_ptr<const std::vector<FrameIndexCache::Entry>> index;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = media_.find(path);
+        if (it == media_.end() || !it->second.index ||
+            it->second.indexSize != size || it->second.indexMtimeNs != mtimeNs) {
+            return false;
+        }
+        index = it->second.index;
+        meta = it->second.indexMeta;
+        indexHits_++;
+    }
+    entries.assign(index->begin(), index->end());  // Copy outside the lock
+    return true;
+}
+
+void SharedMediaRegistry::publishIndex(const std::string& path, const FrameIndexCache::Entry* entries,
+                                       const FrameIndexCache::Metadata& meta) {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    if (!entries || meta.frameCount <= 0 || !identify(path, size, mtimeNs)) {
+        return;
+    }
+    auto index = std::make_shared<const std::vector<FrameIndexCache::Entry>>(
+        entries, entries + meta.frameCount);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Media& media = media_[path];
+    media.index = std::move(index);
+    media.indexMeta = meta;
+    media.indexSize = size;
+    media.indexMtimeNs = mtimeNs;
+}
+
+SharedMediaRegistry::Stats SharedMediaRegistry::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    for (const auto& entry : media_) {
+        if (entry.second.users > 0) {
+            stats.files++;
+        }
+        if (entry.second.index) {
+            stats.indexes++;
+        }
+    }
+    stats.frameHits = frameHits_;
+    stats.indexHits = indexHits_;
+    return stats;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,110 @@
+#ifndef VIDEOCOMPOSER_SHAREDMEDIAREGISTRY_H
+#define VIDEOCOMPOSER_SHAREDMEDIAREGISTRY_H
+
+#include "FrameIndexCache.h"
+#include "../video/FrameBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * SharedMediaRegistry - Process-wide sharing between layers playing one file
+ *
+ * Duplicated layers and mirrored outputs often play the same clip on
+ * several layers. Each layer still owns its VideoFileInput (demuxer and
+ * decoder), so layers at different positions play independently, but:
+ *
+ * - Frame index: the first open publishes its index (keyed by path, file
+ *   size and mtime); later opens of the same file copy it instead of
+ *   scanning the file again.
+ * - Decoded frames: while more than one layer uses a file, the BGRA frames
+ *   a layer decodes are published by (path, frame). A layer at the same
+ *   position wraps that frame (no copy) instead of decoding it, so N
+ *   layers in lockstep cost one decode per frame.
+ *
+ * Frame buffers are recycled once no layer references them.
+ */
+class SharedMediaRegistry {
+public:
+    static constexpr size_t RECENT_FRAMES = 2;  // Published frames kept per file
+
+    struct Stats {
+        size_t files = 0;      // Files with at least one user
+        size_t indexes = 0;    // Indexes held
+        uint64_t frameHits = 0;
+        uint64_t indexHits = 0;
+    };
+
+    static SharedMediaRegistry& instance();
+
+    SharedMediaRegistry();
+
+    /**
+     * Layers playing a file (frames are only published with two or more)
+     */
+    void addUser(const std::string& path);
+    void removeUser(const std::string& path);
+    bool isShared(const std::string& path) const;
+
+    /**
+     * Wrap the frame another layer decoded at this position
+     * @return false if no layer has published it
+     */
+    bool findFrame(const std::string& path, int64_t frameNumber, FrameBuffer& buffer);
+
+    /**
+     * Get a buffer to decode a frame into for publishFrame()
+     */
+    std::shared_ptr<FrameBuffer> acquireFrame(const std::string& path);
+
+    /**
+     * Publish a decoded frame (replaces the oldest of RECENT_FRAMES)
+     */
+    void publishFrame(const std::string& path, int64_t frameNumber, std::shared_ptr<FrameBuffer> frame);
+
+    /**
+     * Copy a published index of the file, if the file has not changed since
+     * @return true if entries and meta were filled
+     */
+    bool findIndex(const std::string& path, std::vector<FrameIndexCache::Entry>& entries,
+                   FrameIndexCache::Metadata& meta);
+
+    /**
+     * Publish a complete frame index (meta.frameCount entries)
+     */
+    void publishIndex(const std::string& path, const FrameIndexCache::Entry* entries,
+                      const FrameIndexCache::Metadata& meta);
+
+    Stats getStats() const;
+
+private:
+    struct Media {
+        int users = 0;
+        std::deque<std::pair<int64_t, std::shared_ptr<FrameBuffer>>> recent;
+        std::vector<std::shared_ptr<FrameBuffer>> spare;
+        // Index and the file identity it was built for
+        std::shared_ptr<const std::vector<FrameIndexCache::Entry>> index;
+        FrameIndexCache::Metadata indexMeta;
+        uint64_t indexSize = 0;
+        int64_t indexMtimeNs = 0;
+    };
+
+    static bool identify(const std::string& path, uint64_t& size, int64_t& mtimeNs);
+    void dropFramesLocked(Media& media);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Media> media_;
+    uint64_t frameHits_;
+    uint64_t indexHits_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SHAREDMEDIAREGISTRY_H
@@ -0,0 +1,110 @@
+#include "SpscFrameRing.h"
+
+namespace videocomposer {
+
+SpscFrameRing::SpscFrameRing(size_t capacity)
+    : capacity_(0)
+{
+    reset(capacity);
+}
+
+void SpscFrameRing::reset(size_t capacity) {
+    entries_.reset(capacity > 0 ? new Entry[capacity] : nullptr);
+    capacity_ = capacity;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+}
+
+bool SpscFrameRing::push(FramePool::Handle slot, uint64_t epoch) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    // Acquire: the consumer has finished releasing the entry we're about to reuse
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (!slot || head - tail >= capacity_) {
+        return false;
+    }
+
+    Entry& entry = entries_[head % capacity_];
+    entry.frameNumber.store(slot->frameNumber, std::memory_order_relaxed);
+    entry.epoch = epoch;
+    entry.slot = std::move(slot);
+    // Release: publish the entry to the consumer
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+FramePool::Handle SpscFrameRing::find(int64_t frameNumber, uint64_t epoch) const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (uint64_t pos = tail_.load(std::memory_order_relaxed); pos < head; ++pos) {
+        const Entry& entry = entries_[pos % capacity_];
+        if (entry.epoch == epoch && entry.slot->frameNumber == frameNumber) {
+            return entry.slot;
+        }
+    }
+    return nullptr;
+}
+
+FramePool::Handle SpscFrameRing::findClosestBefore(int64_t frameNumber, uint64_t epoch) const {
+    FramePool::Handle closest;
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (uint64_t pos = tail_.load(std::memory_order_relaxed); pos < head; ++pos) {
+        const Entry& entry = entries_[pos % capacity_];
+        if (entry.epoch != epoch || entry.slot->frameNumber > frameNumber) {
+            continue;
+        }
+        if (!closest || entry.slot->frameNumber > closest->frameNumber) {
+            closest = entry.slot;
+        }
+    }
+    return closest;
+}
+
+void SpscFrameRing::dropBefore(int64_t frameNumber, uint64_t epoch) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (tail_.load(std::memory_order_relaxed) < head) {
+        const Entry& entry = entries_[tail_.load(std::memory_order_relaxed) % capacity_];
+        if (entry.epoch == epoch && entry.slot->frameNumber >= frameNumber) {
+            break;
+        }
+        pop();
+    }
+}
+
+void SpscFrameRing::clear() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (tail_.load(std::memory_order_relaxed) < head) {
+        pop();
+    }
+}
+
+void SpscFrameRing::pop() {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    entries_[tail % capacity_].slot.reset();
+    // Release: the producer may reuse the entry once it sees the new tail
+    tail_.store(tail + 1, std::memory_order_release);
+}
+
+size_t SpscFrameRing::size() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    return head > tail ? static_cast<size_t>(head - tail) : 0;
+}
+
+int64_t SpscFrameRing::oldestFrame() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (head <= tail) {
+        return -1;
+    }
+    return entries_[tail % capacity_].frameNumber.load(std::memory_order_relaxed);
+}
+
+int64_t SpscFrameRing::newestFrame() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (head <= tail) {
+        return -1;
+    }
+    return entries_[(head - 1) % capacity_].frameNumber.load(std::memory_order_relaxed);
+}
+
+} // namespace videocomposer
@@ -0,0 +1,102 @@
+#ifndef VIDEOCOMPOSER_SPSCFRAMERING_H
+#define VIDEOCOMPOSER_SPSCFRAMERING_H
+
+#include "../video/FramePool.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace videocomposer {
+
+/**
+ * SpscFrameRing - Lock-free single-producer/single-consumer queue of decoded frames
+ *
+ * Backs AsyncDecodeQueue: the decode thread pushes FramePool slots, the
+ * thread that requests frames looks them up and pops the ones it has
+ * played past. Neither side takes a lock or waits for the other.
+ *
+ * - The entry array is allocated once; head and tail only ever grow
+ * - Lookups scan at most capacity() entries (wait-free)
+ * - Every entry carries the seek epoch it was decoded in; lookups ignore
+ *   entries from other epochs, so a seek never has to wait for frames the
+ *   decoder is still delivering from the old position
+ *
+ * push() is producer-only; find*(), dropBefore() and clear() are
+ * consumer-only. size() and the oldest/newest getters may be called from
+ * any thread and are approximate while both sides run.
+ */
+class SpscFrameRing {
+public:
+    explicit SpscFrameRing(size_t capacity = 0);
+
+    SpscFrameRing(const SpscFrameRing&) = delete;
+    SpscFrameRing& operator=(const SpscFrameRing&) = delete;
+
+    /**
+     * Reallocate with a new capacity (drops all frames)
+     * Not thread-safe: only call while neither side is running
+     */
+    void reset(size_t capacity);
+
+    size_t capacity() const { return capacity_; }
+
+    // ===== Producer (decode thread) =====
+
+    /**
+     * Append a decoded frame
+     * @return false if the ring is full (the slot is not taken)
+     */
+    bool push(FramePool::Handle slot, uint64_t epoch);
+
+    // ===== Consumer (frame requests) =====
+
+    /**
+     * Look up a frame of the given epoch
+     * @return Slot, or nullptr if not queued
+     */
+    FramePool::Handle find(int64_t frameNumber, uint64_t epoch) const;
+
+    /**
+     * Closest queued frame at or before frameNumber (same epoch)
+     * @return Slot, or nullptr if there is none
+     */
+    FramePool::Handle findClosestBefore(int64_t frameNumber, uint64_t epoch) const;
+
+    /**
+     * Pop frames older than frameNumber or from another epoch off the front
+     * (slots return to the pool)
+     */
+    void dropBefore(int64_t frameNumber, uint64_t epoch);
+
+    /**
+     * Pop every published frame
+     */
+    void clear();
+
+    // ===== Any thread =====
+
+    size_t size() const;
+    int64_t oldestFrame() const;  // -1 if empty
+    int64_t newestFrame() const;  // -1 if empty
+
+private:
+    struct Entry {
+        FramePool::Handle slot;                  // Written by the producer, reset by the consumer
+        std::atomic<int64_t> frameNumber{-1};    // Atomic so statistics readers don't race
+        uint64_t epoch = 0;
+    };
+
+    void pop();
+
+    std::unique_ptr<Entry[]> entries_;
+    size_t capacity_;
+
+    // Monotonic positions (entry index = position % capacity_)
+    alignas(64) std::atomic<uint64_t> head_{0};  // Next position to write (producer)
+    alignas(64) std::atomic<uint64_t> tail_{0};  // Oldest published position (consumer)
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SPSCFRAMERING_H
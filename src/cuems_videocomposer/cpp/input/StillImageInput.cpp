@@ -0,0 +1,250 @@
+#include "StillImageInput.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+std::string lowerExtension(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return std::string();
+    }
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+// Decode the first video frame of path into frame (the caller unrefs it)
+bool decodeImage(const std::string& path, AVFrame* frame) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, path.c_str(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    AVCodecContext* codecCtx = nullptr;
+    AVPacket* packet = av_packet_alloc();
+    bool decoded = false;
+
+    int stream = avformat_find_stream_info(formatCtx, nullptr) >= 0
+        ? av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0) : -1;
+    const AVCodec* codec = stream >= 0
+        ? avcodec_find_decoder(formatCtx->streams[stream]->codecpar->codec_id) : nullptr;
+    if (codec && packet) {
+        codecCtx = avcodec_alloc_context3(codec);
+    }
+    AVDictionary* options = nullptr;
+    if (codecCtx && lowerExtension(path) == "exr") {
+        // EXR holds linear light: convert to sRGB for display
+        av_dict_set(&options, "apply_trc", "iec61966_2_1", 0);
+    }
+    if (codecCtx && avcodec_parameters_to_context(codecCtx, formatCtx->streams[stream]->codecpar) >= 0 &&
+        avcodec_open2(codecCtx, codec, &options) >= 0) {
+        bool flushing = false;
+        while (!decoded) {
+            int ret = avcodec_receive_frame(codecCtx, frame);
+            if (ret == 0) {
+                decoded = true;
+            } else if (ret != AVERROR(EAGAIN) || flushing) {
+                break;
+            } else if (av_read_frame(formatCtx, packet) < 0) {
+                avcodec_send_packet(codecCtx, nullptr);  // Drain a decoder that holds the frame back
+                flushing = true;
+            } else {
+                if (packet->stream_index == stream) {
+                    avcodec_send_packet(codecCtx, packet);
+                }
+                av_packet_unref(packet);
+            }
+        }
+    }
+    av_dict_free(&options);
+    av_packet_free(&packet);
+    avcodec_free_context(&codecCtx);
+    avformat_close_input(&formatCtx);
+    return decoded;
+}
+
+// Tile cache of a decoded image, converted to BGRA a block of rows at a
+// time so no full-size BGRA copy of a giant image is ever held
+bool buildTiles(const AVFrame* decoded, const std::string& cachePath, const TiledImage::SourceIdentity& identity,
+                bool alpha, int tileSize) {
+    const int BLOCK_ROWS = 256;  // Multiple of every chroma subsampling
+    AVPixelFormat format = static_cast<AVPixelFormat>(decoded->format);
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    if (!desc) {
+        return false;
+    }
+    int width = decoded->width;
+    int height = decoded->height;
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> block(static_cast<size_t>(BLOCK_ROWS) * rowBytes);
+    SwsContext* swsCtx = nullptr;
+    int blockStart = 0;
+    int blockRows = 0;
+
+    auto rows = [&](int y, int count, uint8_t* dst) {
+        for (int i = 0; i < count; ++i) {
+            int row = y + i;
+            if (row >= blockStart + blockRows) {
+                // Rows arrive in order: the next block starts here
+                blockStart = row;
+                blockRows = std::min(BLOCK_ROWS, height - blockStart);
+                swsCtx = sws_getCachedContext(swsCtx, width, blockRows, format, width, blockRows, AV_PIX_FMT_BGRA,
+                                              SWS_BILINEAR, nullptr, nullptr, nullptr);
+                if (!swsCtx) {
+                    return false;
+                }
+                const uint8_t* src[4] = {nullptr, nullptr, nullptr, nullptr};
+                for (int p = 0; p < 4 && decoded->data[p]; ++p) {
+                    bool palette = p == 1 && (desc->flags & AV_PIX_FMT_FLAG_PAL);
+                    int shift = (p == 1 || p == 2) ? desc->log2_chroma_h : 0;
+                    src[p] = palette ? decoded->data[p]
+                                     : decoded->data[p] + static_cast<ptrdiff_t>(blockStart >> shift) * decoded->linesize[p];
+                }
+                uint8_t* dstData[1] = { block.data() };
+                int dstLinesize[1] = { static_cast<int>(rowBytes) };
+                sws_scale(swsCtx, src, decoded->linesize, 0, blockRows, dstData, dstLinesize);
+            }
+            memcpy(dst + static_cast<size_t>(i) * rowBytes, block.data() + (row - blockStart) * rowBytes, rowBytes);
+        }
+        return true;
+    };
+
+    bool built = TiledImage::build(cachePath, identity, width, height, alpha, tileSize, rows);
+    sws_freeContext(swsCtx);
+    return built;
+}
+
+} // namespace
+
+StillImageInput::StillImageInput() = default;
+
+StillImageInput::~StillImageInput() {
+    close();
+}
+
+bool StillImageInput::isStillImagePath(const std::string& path) {
+    static const char* const extensions[] = {
+        "png", "jpg", "jpeg", "bmp", "tga", "tif", "tiff", "webp", "dpx", "exr"
+    };
+    std::string ext = lowerExtension(path);
+    return std::find(std::begin(extensions), std::end(extensions), ext) != std::end(extensions);
+}
+
+bool StillImageInput::open(const std::string& source) {
+    close();
+
+    // Tiled before: map the cache file, nothing to decode
+    TiledImage::Settings tiling = TiledImage::getSettings();
+    TiledImage::SourceIdentity identity;
+    std::string cachePath;
+    if (tiling.threshold > 0 && TiledImage::identify(source, identity)) {
+        cachePath = TiledImage::cachePathFor(tiling.cacheDir, source);
+        if (openTiled(source, cachePath, identity)) {
+            return true;
+        }
+    }
+
+    AVFrame* decoded = av_frame_alloc();
+    if (!decoded || !decodeImage(source, decoded)) {
+        LOG_ERROR << "Still image: cannot decode " << source;
+        av_frame_free(&decoded);
+        return false;
+    }
+
+    FrameInfo info;
+    info.width = decoded->width;
+    info.height = decoded->height;
+    info.aspect = decoded->height > 0 ? static_cast<float>(decoded->width) / static_cast<float>(decoded->height) : 0.0f;
+    info.totalFrames = 0;  // No duration: shown for any sync position
+    info.format = PixelFormat::BGRA32;
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(decoded->format));
+    bool alpha = desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+
+    // Beyond what a texture (and VRAM) holds: tiles, drawn as the view needs them
+    if (!cachePath.empty() && (decoded->width > tiling.threshold || decoded->height > tiling.threshold)) {
+        if (buildTiles(decoded, cachePath, identity, alpha, tiling.tileSize)) {
+            av_frame_free(&decoded);
+            return openTiled(source, cachePath, identity);
+        }
+        LOG_WARNING << "Still image: cannot tile " << source << ", showing it whole";
+    }
+
+    auto frame = std::make_shared<FrameBuffer>();
+    SwsContext* swsCtx = sws_getContext(
+        decoded->width, decoded->height, static_cast<AVPixelFormat>(decoded->format),
+        decoded->width, decoded->height, AV_PIX_FMT_BGRA,
+        SWS_BILINEAR, nullptr, nullptr, nullptr);
+    bool converted = false;
+    if (swsCtx && frame->ensureAllocated(info)) {
+        uint8_t* dstData[1] = { frame->data() };
+        int dstLinesize[1] = { decoded->width * 4 };
+        sws_scale(swsCtx, decoded->data, decoded->linesize, 0, decoded->height, dstData, dstLinesize);
+        converted = true;
+    }
+    sws_freeContext(swsCtx);
+    av_frame_free(&decoded);
+    if (!converted) {
+        LOG_ERROR << "Still image: cannot convert " << source;
+        return false;
+    }
+
+    frame_ = std::move(frame);
+    frameInfo_ = info;
+    hasAlpha_ = alpha;
+    LOG_INFO << "Still image: " << source << " (" << info.width << "x" << info.height
+             << (alpha ? ", alpha" : "") << ")";
+    return true;
+}
+
+bool StillImageInput::openTiled(const std::string& source, const std::string& cachePath,
+                                 const TiledImage::SourceIdentity& identity) {
+    auto tiled = std::make_shared<TiledImage>();
+    if (!tiled->open(cachePath, identity)) {
+        return false;
+    }
+    auto frame = std::make_shared<FrameBuffer>();
+    if (!tiled->readLevel(tiled->levelFitting(OVERVIEW_SIZE), *frame)) {
+        LOG_ERROR << "Still image: cannot read the tiles of " << source;
+        return false;
+    }
+
+    const TilePyramid& pyramid = tiled->getPyramid();
+    frame_ = std::move(frame);
+    frameInfo_ = frame_->info();
+    hasAlpha_ = tiled->hasAlpha();
+    tiled_ = std::move(tiled);
+    LOG_INFO << "Still image: " << source << " (" << pyramid.getWidth() << "x" << pyramid.getHeight() << ", "
+             << pyramid.getTileCount() << " tiles" << (hasAlpha_ ? ", alpha" : "") << ")";
+    return true;
+}
+
+void StillImageInput::close() {
+    frame_.reset();  // Layers still showing it keep their reference
+    tiled_.reset();  // As does the renderer's tile atlas
+    frameInfo_ = {};
+    hasAlpha_ = false;
+}
+
+bool StillImageInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
+    (void)frameNumber;  // Every frame is the image
+    if (!frame_) {
+        return false;
+    }
+    return buffer.wrap(frame_->data(), frame_->size(), frame_->info(), frame_);
+}
+
+} // namespace videocomposer
@@ -0,0 +1,63 @@
+#ifndef VIDEOCOMPOSER_STILLIMAGEINPUT_H
+#define VIDEOCOMPOSER_STILLIMAGEINPUT_H
+
+#include "InputSource.h"
+#include "TiledImage.h"
+#include <memory>
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * StillImageInput - A single image (logo, slate) shown as a layer
+ *
+ * The image is decoded once in open() - on the AsyncVideoLoader thread for
+ * cue loads - and every readFrame() shares that frame without a copy. The
+ * source reports itself static, so the layer loads it once, the renderer
+ * uploads it once (with mipmaps) and damage tracking never sees it change.
+ *
+ * Images wider or taller than the tiling threshold (TiledImage::Settings)
+ * are cut into a tile cache file instead - once: later opens map the file
+ * without decoding. Frames read are then an overview of at most
+ * OVERVIEW_SIZE texels and the renderer draws the tiles on screen.
+ */
+class StillImageInput : public InputSource {
+public:
+    static constexpr int OVERVIEW_SIZE = 2048;
+
+    StillImageInput();
+    ~StillImageInput() override;
+
+    /** Image file extensions handled (png, jpg/jpeg, bmp, tga, tif/tiff, webp, dpx, exr) */
+    static bool isStillImagePath(const std::string& path);
+
+    // InputSource interface
+    bool open(const std::string& source) override;
+    void close() override;
+    bool isReady() const override { return frame_ != nullptr; }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override;
+    bool seek(int64_t frameNumber) override { (void)frameNumber; return isReady(); }
+    FrameInfo getFrameInfo() const override { return frameInfo_; }
+    int64_t getCurrentFrame() const override { return 0; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+    bool hasAlpha() const override { return hasAlpha_; }
+    bool hasInstantSeek() const override { return true; }
+    bool isStatic() const override { return true; }
+    std::shared_ptr<TiledImage> getTiledImage() const override { return tiled_; }
+
+private:
+    // Map a built tile cache and read its overview
+    bool openTiled(const std::string& source, const std::string& cachePath,
+                   const TiledImage::SourceIdentity& identity);
+
+    std::shared_ptr<FrameBuffer> frame_;  // Decoded BGRA image, shared with readers
+    FrameInfo frameInfo_;
+    bool hasAlpha_ = false;
+    std::shared_ptr<TiledImage> tiled_;   // Giant images only
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_STILLIMAGEINPUT_H
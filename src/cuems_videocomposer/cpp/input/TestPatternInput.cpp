@@ -0,0 +1,67 @@
+#include "TestPatternInput.h"
+#include "../video/FrameCode.h"
+#include <algorithm>
+#include <cstring>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr int BAR_STEPS = 60;   // Bar positions before it wraps
+
+void fillRect(uint8_t* pixels, int width, int x0, int y0, int w, int h, uint8_t level) {
+    for (int y = y0; y < y0 + h; ++y) {
+        uint8_t* row = pixels + (static_cast<size_t>(y) * width + x0) * 4;
+        for (int x = 0; x < w; ++x) {
+            row[x * 4 + 0] = row[x * 4 + 1] = row[x * 4 + 2] = level;
+            row[x * 4 + 3] = 255;
+        }
+    }
+}
+
+} // namespace
+
+TestPatternInput::TestPatternInput(int width, int height, double framerate) {
+    frameInfo_.width = std::max(width, FrameCode::CELLS);
+    frameInfo_.height = std::max(height, 16);
+    frameInfo_.aspect = static_cast<float>(frameInfo_.width) / static_cast<float>(frameInfo_.height);
+    frameInfo_.framerate = framerate;
+    frameInfo_.totalFrames = 0;  // No duration: every sync position has a frame
+    frameInfo_.format = PixelFormat::BGRA32;
+    frameInfo_.colorRange = ColorRange::FULL;
+    stripHeight_ = std::max(frameInfo_.height / 16, 4);
+
+    background_.resize(static_cast<size_t>(frameInfo_.width) * frameInfo_.height * 4);
+    fillRect(background_.data(), frameInfo_.width, 0, 0, frameInfo_.width, frameInfo_.height, 96);
+}
+
+bool TestPatternInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
+    if (!buffer.ensureAllocated(frameInfo_)) {
+        return false;
+    }
+    const int width = frameInfo_.width;
+    const int height = frameInfo_.height;
+    uint8_t* pixels = buffer.data();
+    std::memcpy(pixels, background_.data(), background_.size());
+
+    // Strips top and bottom, so a readback finds one whatever the row order
+    const size_t stride = static_cast<size_t>(width) * 4;
+    FrameCode::encodeRow(pixels, width, frameNumber);
+    for (int y = 1; y < stripHeight_; ++y) {
+        std::memcpy(pixels + y * stride, pixels, stride);
+    }
+    for (int y = height - stripHeight_; y < height; ++y) {
+        std::memcpy(pixels + y * stride, pixels, stride);
+    }
+
+    int64_t frame = frameNumber < 0 ? -frameNumber : frameNumber;
+    int patch = std::min(width, height) / 6;
+    fillRect(pixels, width, 0, height - stripHeight_ - patch, patch, patch, frame % 2 == 0 ? 255 : 0);
+
+    int barWidth = std::max(width / BAR_STEPS, 1);
+    int barX = static_cast<int>(frame % BAR_STEPS) * (width - barWidth) / (BAR_STEPS - 1);
+    fillRect(pixels, width, barX, stripHeight_, barWidth, height - 2 * stripHeight_ - patch, 224);
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,51 @@
+#ifndef VIDEOCOMPOSER_TESTPATTERNINPUT_H
+#define VIDEOCOMPOSER_TESTPATTERNINPUT_H
+
+#include "InputSource.h"
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * TestPatternInput - Generated frames that carry their own frame number
+ *
+ * Every frame has a FrameCode strip along the top and bottom edges, a
+ * photodiode patch in the bottom-left corner (white on even frames, black
+ * on odd ones) and a bar that steps across the image, over a grey
+ * background. Used by the sync test to tell which frame reached the
+ * screen: from a readback of the canvas, a camera, or a photodiode.
+ */
+class TestPatternInput : public InputSource {
+public:
+    /**
+     * @param framerate Frame rate of the pattern, or 0 to show the sync
+     *        source's frame numbers unconverted
+     */
+    TestPatternInput(int width, int height, double framerate);
+
+    /** Rows covered by each FrameCode strip */
+    int stripHeight() const { return stripHeight_; }
+
+    // InputSource interface
+    bool open(const std::string& source) override { (void)source; return true; }
+    void close() override {}
+    bool isReady() const override { return true; }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override;
+    bool seek(int64_t frameNumber) override { (void)frameNumber; return true; }
+    FrameInfo getFrameInfo() const override { return frameInfo_; }
+    int64_t getCurrentFrame() const override { return 0; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+    bool hasAlpha() const override { return false; }
+    bool hasInstantSeek() const override { return true; }
+
+private:
+    FrameInfo frameInfo_;
+    int stripHeight_;
+    std::vector<uint8_t> background_;   // Grey frame, copied into every frame
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TESTPATTERNINPUT_H
@@ -0,0 +1,492 @@
+#include "ThumbnailService.h"
+#include "HardwareDecoder.h"
+#include "HardwareDeviceCache.h"
+#include "RenderNodeManager.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#ifdef HAVE_VAAPI_INTEROP
+#include "../hwdec/VaapiScaler.h"
+#endif
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+#include <libavutil/hwcontext.h>
+#include <libswscale/swscale.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+constexpr std::chrono::milliseconds SLOT_WAIT(200);
+constexpr int JPEG_QSCALE = 4;      // 2 (best) .. 31
+
+uint64_t fnv1a(const uint8_t* data, size_t len, uint64_t hash = 1469598103934665603ULL) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool createDirectories(const std::string& path) {
+    std::string partial;
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        partial = path.substr(0, pos);
+        if (partial.empty()) continue;
+        if (mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The FFmpeg objects of one thumbnail, freed on every return
+struct Extraction {
+    AVFormatContext* format = nullptr;
+    AVCodecContext* decoder = nullptr;
+    AVCodecContext* encoder = nullptr;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;
+    AVFrame* download = nullptr;
+    AVFrame* picture = nullptr;
+    SwsContext* sws = nullptr;
+
+    ~Extraction() {
+        sws_freeContext(sws);
+        av_frame_free(&picture);
+        av_frame_free(&download);
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        avcodec_free_context(&encoder);
+        avcodec_free_context(&decoder);
+        avformat_close_input(&format);
+    }
+};
+
+AVPixelFormat chooseVaapi(AVCodecContext*, const AVPixelFormat* formats) {
+    for (const AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; ++p) {
+        if (*p == AV_PIX_FMT_VAAPI) {
+            return *p;
+        }
+    }
+    return formats[0];  // The software format the decoder offers
+}
+
+} // namespace
+
+ThumbnailService::ThumbnailService() = default;
+
+ThumbnailService::~ThumbnailService() {
+    stop();
+}
+
+void ThumbnailService::configure(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.width = std::clamp(settings_.width, 16, MAX_WIDTH);
+}
+
+ThumbnailService::Settings ThumbnailService::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+bool ThumbnailService::request(const Request& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The same thumbnail asked for again before it was made is made once
+    for (const Request& queued : pending_) {
+        if (queued.path == request.path && queued.seconds == request.seconds && queued.width == request.width &&
+            queued.target == request.target) {
+            return true;
+        }
+    }
+    if (pending_.size() >= MAX_PENDING) {
+        return false;
+    }
+    pending_.push_back(request);
+    if (!running_) {
+        running_ = true;
+        stopping_ = false;
+        thread_ = std::thread(&ThumbnailService::run, this);
+    }
+    cond_.notify_one();
+    return true;
+}
+
+size_t ThumbnailService::takeResults(const ResultCallback& report) {
+    std::vector<Result> results;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (results_.empty()) {
+            return 0;
+        }
+        results.swap(results_);
+    }
+    for (const Result& result : results) {
+        report(result);
+    }
+    return results.size();
+}
+
+size_t ThumbnailService::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void ThumbnailService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        stopping_ = true;
+        pending_.clear();
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+}
+
+std::string ThumbnailService::defaultCacheDir() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/cuems-videocomposer/thumbnails";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) {
+        return std::string(home) + "/.cache/cuems-videocomposer/thumbnails";
+    }
+    return "/tmp/cuems-videocomposer/thumbnails";
+}
+
+std::string ThumbnailService::cachePathFor(const std::string& cacheDir, const std::string& path, uint64_t size,
+                                           int64_t mtimeNs, double seconds, int width, Format format) {
+    // Keyed by canonical path and identity: a replaced file gets new thumbnails
+    char resolved[PATH_MAX];
+    std::string key = realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+    uint64_t hash = fnv1a(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    hash = fnv1a(reinterpret_cast<const uint8_t*>(&size), sizeof(size), hash);
+    hash = fnv1a(reinterpret_cast<const uint8_t*>(&mtimeNs), sizeof(mtimeNs), hash);
+
+    char name[80];
+    snprintf(name, sizeof(name), "%016llx-%lldms-%dw.%s", static_cast<unsigned long long>(hash),
+             static_cast<long long>(std::llround(std::max(0.0, seconds) * 1000.0)), width,
+             format == Format::PNG ? "png" : "jpg");
+    return (cacheDir.empty() ? defaultCacheDir() : cacheDir) + "/" + name;
+}
+
+void ThumbnailService::fitSize(int width, int height, int sarNum, int sarDen, int maxWidth, int& outWidth,
+                               int& outHeight) {
+    outWidth = 0;
+    outHeight = 0;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    double displayWidth = width;
+    if (sarNum > 0 && sarDen > 0) {
+        displayWidth = static_cast<double>(width) * sarNum / sarDen;
+    }
+    double scaledWidth = std::min(static_cast<double>(std::max(2, maxWidth)), displayWidth);
+    double scaledHeight = scaledWidth * height / displayWidth;
+    outWidth = std::max(2, static_cast<int>(std::lround(scaledWidth / 2.0)) * 2);
+    outHeight = std::max(2, static_cast<int>(std::lround(scaledHeight / 2.0)) * 2);
+}
+
+ThumbnailService::Format ThumbnailService::parseFormat(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    return lower == "png" ? Format::PNG : Format::JPEG;
+}
+
+void ThumbnailService::run() {
+    ThreadRoles::instance().apply(ThreadRole::LOADER);
+    DecodeScheduler& scheduler = DecodeScheduler::instance();
+    cpuClient_ = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    hardwareClient_ = scheduler.addClient(DecodeScheduler::Resource::HARDWARE);
+    scheduler.setBackground(cpuClient_, true);
+    scheduler.setBackground(hardwareClient_, true);
+
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (stopping_) {
+                break;
+            }
+            request = std::move(pending_.front());
+            pending_.pop_front();
+        }
+        Result result;
+        result.request = request;
+        process(request, result);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            break;
+        }
+        results_.push_back(std::move(result));
+    }
+
+    scheduler.removeClient(cpuClient_);
+    scheduler.removeClient(hardwareClient_);
+#ifdef HAVE_VAAPI_INTEROP
+    scaler_.reset();
+#endif
+}
+
+void ThumbnailService::process(const Request& request, Result& result) {
+    Settings settings = getSettings();
+    int width = std::clamp(request.width > 0 ? request.width : settings.width, 16, MAX_WIDTH);
+    struct stat st;
+    if (stat(request.path.c_str(), &st) != 0) {
+        LOG_WARNING << "Thumbnail: cannot read " << request.path << ": " << std::strerror(errno);
+        return;
+    }
+    int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    std::string cacheDir = settings.cacheDir.empty() ? defaultCacheDir() : settings.cacheDir;
+    result.file = cachePathFor(cacheDir, request.path, static_cast<uint64_t>(st.st_size), mtimeNs,
+                               request.seconds, width, settings.format);
+
+    result.cached = access(result.file.c_str(), R_OK) == 0;
+    if (!result.cached) {
+        if (!createDirectories(cacheDir)) {
+            LOG_WARNING << "Thumbnail: cannot create " << cacheDir << ": " << std::strerror(errno);
+            return;
+        }
+        if (!extract(request.path, request.seconds, width, result.file)) {
+            return;
+        }
+        LOG_VERBOSE << "Thumbnail of " << request.path << " at " << request.seconds << " s: " << result.file;
+    }
+
+    // Small images travel with the reply
+    std::ifstream in(result.file, std::ios::binary);
+    if (!in) {
+        LOG_WARNING << "Thumbnail: cannot read " << result.file;
+        return;
+    }
+    in.seekg(0, std::ios::end);
+    std::streamoff bytes = in.tellg();
+    if (bytes > 0 && static_cast<size_t>(bytes) <= MAX_INLINE_BYTES) {
+        in.seekg(0, std::ios::beg);
+        result.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    result.ok = true;
+}
+
+bool ThumbnailService::acquireSlot(DecodeScheduler::ClientId client) {
+    // Retried until free: a request waits as long as playback keeps the decoders busy
+    while (!DecodeScheduler::instance().acquire(client, 0.0, SLOT_WAIT)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ThumbnailService::extract(const std::string& path, double seconds, int width, const std::string& outPath) {
+    Extraction x;
+    if (avformat_open_input(&x.format, path.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(x.format, nullptr) < 0) {
+        LOG_WARNING << "Thumbnail: cannot open " << path;
+        return false;
+    }
+    const AVCodec* decoder = nullptr;
+    int index = av_find_best_stream(x.format, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+    if (index < 0 || !decoder) {
+        LOG_WARNING << "Thumbnail: no decodable video in " << path;
+        return false;
+    }
+    AVStream* stream = x.format->streams[index];
+
+    // The keyframe at or before the time
+    if (seconds > 0.0) {
+        int64_t ts = av_rescale_q(static_cast<int64_t>(seconds * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+        if (stream->start_time != AV_NOPTS_VALUE) {
+            ts += stream->start_time;
+        }
+        if (av_seek_frame(x.format, index, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+            LOG_VERBOSE << "Thumbnail: cannot seek in " << path << ", using the first keyframe";
+        }
+    }
+
+    x.decoder = avcodec_alloc_context3(decoder);
+    if (!x.decoder || avcodec_parameters_to_context(x.decoder, stream->codecpar) < 0) {
+        return false;
+    }
+    x.decoder->skip_frame = AVDISCARD_NONKEY;
+    x.decoder->flags |= AV_CODEC_FLAG_LOW_DELAY;   // Only keyframes go in: each comes out at once
+    x.decoder->thread_count = 1;
+
+    Settings settings = getSettings();
+    bool hardware = false;
+    AVCodecID codecId = stream->codecpar->codec_id;
+    if (settings.hardware && HardwareDecoder::detectAvailable() == HardwareDecoder::Type::VAAPI &&
+        HardwareDecoder::isAvailableForCodec(codecId, HardwareDecoder::Type::VAAPI)) {
+        std::string node = RenderNodeManager::instance().getPrimaryPath();
+        AVBufferRef* device = HardwareDeviceCache::instance().acquireDevice(node, [&node]() -> AVBufferRef* {
+            AVBufferRef* created = nullptr;
+            return av_hwdevice_ctx_create(&created, AV_HWDEVICE_TYPE_VAAPI, node.empty() ? nullptr : node.c_str(),
+                                          nullptr, 0) < 0 ? nullptr : created;
+        });
+        if (device) {
+            x.decoder->hw_device_ctx = device;
+            x.decoder->get_format = chooseVaapi;
+            hardware = true;
+        }
+    }
+    if (avcodec_open2(x.decoder, decoder, nullptr) < 0) {
+        LOG_WARNING << "Thumbnail: cannot open the " << decoder->name << " decoder for " << path;
+        return false;
+    }
+    x.packet = av_packet_alloc();
+    x.frame = av_frame_alloc();
+    x.download = av_frame_alloc();
+    if (!x.packet || !x.frame || !x.download) {
+        return false;
+    }
+
+    // Keyframe packets only, each decode in a slot of the scheduler
+    DecodeScheduler::ClientId client = hardware ? hardwareClient_ : cpuClient_;
+    bool decoded = false;
+    bool draining = false;
+    for (int packets = 0; !decoded && !draining && packets < MAX_PACKETS; ++packets) {
+        if (av_read_frame(x.format, x.packet) < 0) {
+            draining = true;   // End of file: what the decoder still holds
+        } else if (x.packet->stream_index != index || !(x.packet->flags & AV_PKT_FLAG_KEY)) {
+            av_packet_unref(x.packet);
+            continue;
+        }
+        if (!acquireSlot(client)) {
+            return false;
+        }
+        int sent = avcodec_send_packet(x.decoder, draining ? nullptr : x.packet);
+        decoded = (sent >= 0 || sent == AVERROR(EAGAIN)) && avcodec_receive_frame(x.decoder, x.frame) >= 0;
+        DecodeScheduler::instance().release(client);
+        av_packet_unref(x.packet);
+    }
+    if (!decoded) {
+        LOG_WARNING << "Thumbnail: no keyframe decoded in " << path << " at " << seconds << " s";
+        return false;
+    }
+
+    int outWidth = 0;
+    int outHeight = 0;
+    AVRational sar = av_guess_sample_aspect_ratio(x.format, stream, x.frame);
+    fitSize(x.frame->width, x.frame->height, sar.num, sar.den, width, outWidth, outHeight);
+
+    // Hardware frames: scaled on the video engine, only the thumbnail downloaded
+    const AVFrame* source = x.frame;
+    if (x.frame->format == AV_PIX_FMT_VAAPI) {
+        if (!acquireSlot(client)) {
+            return false;
+        }
+        bool ready = false;
+#ifdef HAVE_VAAPI_INTEROP
+        if (!scaler_) {
+            scaler_ = std::make_unique<VaapiScaler>();
+        }
+        ready = scaler_->scale(x.frame, outWidth, outHeight, x.download);
+#endif
+        ready = ready || av_hwframe_transfer_data(x.download, x.frame, 0) >= 0;
+        DecodeScheduler::instance().release(client);
+        if (!ready) {
+            LOG_WARNING << "Thumbnail: cannot download the decoded frame of " << path;
+            return false;
+        }
+        source = x.download;
+    }
+    return encode(source, outWidth, outHeight, settings.format, outPath);
+}
+
+bool ThumbnailService::encode(const AVFrame* frame, int width, int height, Format format,
+                              const std::string& outPath) {
+    Extraction x;
+    bool png = format == Format::PNG;
+    AVPixelFormat pixelFormat = png ? AV_PIX_FMT_RGB24 : AV_PIX_FMT_YUVJ420P;
+    const AVCodec* encoder = avcodec_find_encoder(png ? AV_CODEC_ID_PNG : AV_CODEC_ID_MJPEG);
+    if (!encoder) {
+        LOG_WARNING << "Thumbnail: FFmpeg has no " << (png ? "PNG" : "JPEG") << " encoder";
+        return false;
+    }
+
+    // What is left to scale is thumbnail-sized, or a software frame
+    x.sws = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format), width, height,
+                           pixelFormat, SWS_AREA, nullptr, nullptr, nullptr);
+    x.picture = av_frame_alloc();
+    if (!x.sws || !x.picture) {
+        return false;
+    }
+    const int* sourceMatrix = sws_getCoefficients(frame->colorspace == AVCOL_SPC_BT709 ? SWS_CS_ITU709 : SWS_CS_DEFAULT);
+    sws_setColorspaceDetails(x.sws, sourceMatrix, frame->color_range == AVCOL_RANGE_JPEG,
+                             sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+    x.picture->format = pixelFormat;
+    x.picture->width = width;
+    x.picture->height = height;
+    if (av_frame_get_buffer(x.picture, 0) < 0) {
+        return false;
+    }
+    sws_scale(x.sws, frame->data, frame->linesize, 0, frame->height, x.picture->data, x.picture->linesize);
+
+    x.encoder = avcodec_alloc_context3(encoder);
+    x.packet = av_packet_alloc();
+    if (!x.encoder || !x.packet) {
+        return false;
+    }
+    x.encoder->width = width;
+    x.encoder->height = height;
+    x.encoder->pix_fmt = pixelFormat;
+    x.encoder->time_base = AVRational{1, 25};
+    if (!png) {
+        x.encoder->flags |= AV_CODEC_FLAG_QSCALE;
+        x.encoder->global_quality = FF_QP2LAMBDA * JPEG_QSCALE;
+        x.encoder->color_range = AVCOL_RANGE_JPEG;
+        x.picture->quality = x.encoder->global_quality;
+    }
+    if (avcodec_open2(x.encoder, encoder, nullptr) < 0 || avcodec_send_frame(x.encoder, x.picture) < 0 ||
+        avcodec_receive_packet(x.encoder, x.packet) < 0) {
+        LOG_WARNING << "Thumbnail: " << encoder->name << " encoding failed";
+        return false;
+    }
+
+    // Written whole, then renamed: a reader never sees half an image
+    std::string tmpPath = outPath + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        LOG_WARNING << "Thumbnail: cannot write " << tmpPath << ": " << std::strerror(errno);
+        return false;
+    }
+    bool written = std::fwrite(x.packet->data, 1, static_cast<size_t>(x.packet->size), file) ==
+                   static_cast<size_t>(x.packet->size);
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(tmpPath.c_str(), outPath.c_str()) != 0) {
+        LOG_WARNING << "Thumbnail: cannot write " << outPath << ": " << std::strerror(errno);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,146 @@
+#ifndef VIDEOCOMPOSER_THUMBNAILSERVICE_H
+#define VIDEOCOMPOSER_THUMBNAILSERVICE_H
+
+#include "DecodeScheduler.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AVFrame;
+
+namespace videocomposer {
+
+class VaapiScaler;
+
+/**
+ * ThumbnailService - Poster frames of clips for the cue list, in the background
+ *
+ * A request names a file and a time; the service answers with a small
+ * JPEG or PNG of the keyframe at or before that time. Only keyframe
+ * packets are decoded, on the hardware decoder when it has the codec,
+ * scaled on the video engine (VaapiScaler) so only the thumbnail leaves
+ * the GPU; other clips decode in software on this thread.
+ *
+ * Images are cached by file (path, size, mtime), time and width, so a
+ * request for a thumbnail made before is answered from the cache without
+ * decoding. One worker thread (LOADER role) takes each decode through
+ * DecodeScheduler as a background client: it only runs when no playback
+ * decode waits, and never takes the last free slot.
+ *
+ * Results are collected by the main loop with takeResults().
+ */
+class ThumbnailService {
+public:
+    static constexpr int DEFAULT_WIDTH = 320;
+    static constexpr int MAX_WIDTH = 1920;
+    static constexpr size_t MAX_PENDING = 256;
+    static constexpr int MAX_PACKETS = 2000;    // Read before giving up on a keyframe
+    static constexpr size_t MAX_INLINE_BYTES = 32 * 1024;  // Images sent with the reply (one datagram)
+
+    enum class Format {
+        JPEG,
+        PNG
+    };
+
+    struct Settings {
+        std::string cacheDir;            // Empty = defaultCacheDir()
+        Format format = Format::JPEG;
+        int width = DEFAULT_WIDTH;       // Requests without a width
+        bool hardware = true;            // Hardware decode and scaling when available
+    };
+
+    struct Request {
+        std::string path;
+        double seconds = 0.0;
+        int width = 0;                   // 0 = Settings::width
+        std::string target;              // "host:port" the result goes to
+    };
+
+    struct Result {
+        Request request;
+        bool ok = false;
+        std::string file;                // Cached image
+        std::string data;                // Its bytes, when at most MAX_INLINE_BYTES
+        bool cached = false;             // Answered from the cache
+    };
+
+    using ResultCallback = std::function<void(const Result& result)>;
+
+    ThumbnailService();
+    ~ThumbnailService();
+
+    ThumbnailService(const ThumbnailService&) = delete;
+    ThumbnailService& operator=(const ThumbnailService&) = delete;
+
+    void configure(const Settings& settings);
+    Settings getSettings() const;
+
+    /**
+     * Queue a request (the worker starts with the first)
+     * @return false if MAX_PENDING requests wait already
+     */
+    bool request(const Request& request);
+
+    /**
+     * Hand the finished requests to report (main thread)
+     * @return Number of results
+     */
+    size_t takeResults(const ResultCallback& report);
+
+    size_t getPendingCount() const;
+
+    /** Wait for the worker and stop it (queued requests are dropped) */
+    void stop();
+
+    /**
+     * Default cache directory: $XDG_CACHE_HOME/cuems-videocomposer/thumbnails,
+     * falling back to ~/.cache/cuems-videocomposer/thumbnails
+     */
+    static std::string defaultCacheDir();
+
+    /** Cache file of a thumbnail (".jpg" or ".png"), keyed by the file's identity */
+    static std::string cachePathFor(const std::string& cacheDir, const std::string& path, uint64_t size,
+                                    int64_t mtimeNs, double seconds, int width, Format format);
+
+    /**
+     * Thumbnail size of a width x height picture with the given sample
+     * aspect ratio, maxWidth wide at most and never upscaled (even sizes)
+     */
+    static void fitSize(int width, int height, int sarNum, int sarDen, int maxWidth, int& outWidth, int& outHeight);
+
+    /** Image written for a file name ("jpg", "jpeg", "png"; others JPEG) */
+    static Format parseFormat(const std::string& name);
+
+private:
+    void run();
+    void process(const Request& request, Result& result);
+    bool extract(const std::string& path, double seconds, int width, const std::string& outPath);
+    bool acquireSlot(DecodeScheduler::ClientId client);
+    static bool encode(const AVFrame* frame, int width, int height, Format format, const std::string& outPath);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Request> pending_;
+    std::vector<Result> results_;
+    Settings settings_;
+    std::thread thread_;
+    bool running_ = false;
+    bool stopping_ = false;
+
+    // Worker thread only
+    DecodeScheduler::ClientId cpuClient_ = 0;
+    DecodeScheduler::ClientId hardwareClient_ = 0;
+#ifdef HAVE_VAAPI_INTEROP
+    std::unique_ptr<VaapiScaler> scaler_;
+#endif
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_THUMBNAILSERVICE_H
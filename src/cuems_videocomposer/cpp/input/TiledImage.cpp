@@ -0,0 +1,525 @@
+#include "TiledImage.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'C', 'V', 'T', 'I', 'L', 'E', 'S', '\0'};
+constexpr size_t PAGE_BYTES = 4096;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tileSize;
+    uint32_t border;
+    int32_t width;
+    int32_t height;
+    uint8_t hasAlpha;
+    uint8_t reserved[3];
+    uint64_t fileSize;
+    int64_t fileMtimeNs;
+    uint64_t tileCount;
+};
+static_assert(sizeof(CacheHeader) <= TiledImage::DATA_OFFSET, "tile cache header overlaps the tiles");
+
+std::mutex settingsMutex;
+TiledImage::Settings settings;
+
+uint64_t fnv1a(const uint8_t* data, size_t len, uint64_t hash = 1469598103934665603ULL) {
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool createDirectories(const std::string& path) {
+    std::string partial;
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        partial = path.substr(0, pos);
+        if (partial.empty()) continue;
+        if (mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Tiles of a cache file being written or read: level rows in, tiles out
+ */
+class TileLayout {
+public:
+    TileLayout(const TilePyramid& pyramid, uint8_t* base)
+        : pyramid_(pyramid)
+        , base_(base)
+        , tileSize_(pyramid.getTileSize())
+        , stride_(pyramid.getTileSize() + 2 * TiledImage::BORDER)
+    {
+    }
+
+    uint8_t* tile(int level, int x, int y) const {
+        TilePyramid::Tile t;
+        t.level = level;
+        t.x = x;
+        t.y = y;
+        size_t tileBytes = static_cast<size_t>(stride_) * stride_ * 4;
+        return base_ + TiledImage::DATA_OFFSET + pyramid_.tileIndex(t) * tileBytes;
+    }
+
+    // Row y of a level from its tiles (levelWidth * 4 bytes)
+    void readRow(int level, int y, uint8_t* dst) const {
+        int ty = y / tileSize_;
+        size_t offset = (static_cast<size_t>(y % tileSize_ + TiledImage::BORDER) * stride_ + TiledImage::BORDER) * 4;
+        for (int tx = 0; tx < pyramid_.tilesX(level); ++tx) {
+            TilePyramid::Tile t;
+            t.level = level;
+            t.x = tx;
+            t.y = ty;
+            memcpy(dst + static_cast<size_t>(tx) * tileSize_ * 4, tile(level, tx, ty) + offset,
+                   static_cast<size_t>(pyramid_.tileTexelsX(t)) * 4);
+        }
+    }
+
+    // One row of tiles from a band of level rows: band row r is level row
+    // ty * tileSize - BORDER + r, clamped to the image
+    void writeBand(int level, int ty, const uint8_t* band) const {
+        int width = pyramid_.levelWidth(level);
+        size_t rowBytes = static_cast<size_t>(width) * 4;
+        for (int tx = 0; tx < pyramid_.tilesX(level); ++tx) {
+            uint8_t* dst = tile(level, tx, ty);
+            int x0 = tx * tileSize_;
+            int count = std::min(tileSize_, width - x0);
+            for (int r = 0; r < stride_; ++r) {
+                const uint8_t* src = band + r * rowBytes;
+                uint8_t* row = dst + static_cast<size_t>(r) * stride_ * 4;
+                memcpy(row, src + static_cast<size_t>(std::max(x0 - 1, 0)) * 4, 4);
+                memcpy(row + 4, src + static_cast<size_t>(x0) * 4, static_cast<size_t>(count) * 4);
+                for (int c = 1 + count; c < stride_; ++c) {
+                    memcpy(row + c * 4, src + static_cast<size_t>(std::min(x0 + c - 1, width - 1)) * 4, 4);
+                }
+            }
+        }
+    }
+
+private:
+    const TilePyramid& pyramid_;
+    uint8_t* base_;
+    int tileSize_;
+    int stride_;
+};
+
+// Box filter of four BGRA texels; colour weighted by alpha so transparent
+// texels do not darken the edges of what they surround
+void average4(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d, bool alpha, uint8_t* out) {
+    if (!alpha) {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = static_cast<uint8_t>((a[i] + b[i] + c[i] + d[i] + 2) >> 2);
+        }
+        return;
+    }
+    uint32_t weight = a[3] + b[3] + c[3] + d[3];
+    if (weight == 0) {
+        memset(out, 0, 4);
+        return;
+    }
+    for (int i = 0; i < 3; ++i) {
+        out[i] = static_cast<uint8_t>((a[i] * a[3] + b[i] * b[3] + c[i] * c[3] + d[i] * d[3] + weight / 2) / weight);
+    }
+    out[3] = static_cast<uint8_t>((weight + 2) >> 2);
+}
+
+// Tiles of one level from its rows, read top to bottom in bands
+bool buildLevel(const TileLayout& layout, const TilePyramid& pyramid, int level,
+                const TiledImage::RowSource& rows) {
+    int tileSize = pyramid.getTileSize();
+    int height = pyramid.levelHeight(level);
+    size_t rowBytes = static_cast<size_t>(pyramid.levelWidth(level)) * 4;
+    std::vector<uint8_t> band(static_cast<size_t>(tileSize + 2 * TiledImage::BORDER) * rowBytes);
+
+    // Rows past the bottom repeat the last one
+    auto readRows = [&](int y, int count, int slot) {
+        int valid = std::max(0, std::min(count, height - y));
+        if (valid > 0 && !rows(y, valid, band.data() + slot * rowBytes)) {
+            return false;
+        }
+        for (int i = valid; i < count; ++i) {
+            memcpy(band.data() + (slot + i) * rowBytes, band.data() + (slot + i - 1) * rowBytes, rowBytes);
+        }
+        return true;
+    };
+
+    for (int ty = 0; ty < pyramid.tilesY(level); ++ty) {
+        if (ty == 0) {
+            if (!readRows(0, tileSize + 1, 1)) {
+                return false;
+            }
+            memcpy(band.data(), band.data() + rowBytes, rowBytes);
+        } else {
+            // The last two rows of the band above are this band's first two
+            memmove(band.data(), band.data() + tileSize * rowBytes, 2 * rowBytes);
+            if (!readRows(ty * tileSize + 1, tileSize, 2)) {
+                return false;
+            }
+        }
+        layout.writeBand(level, ty, band.data());
+    }
+    return true;
+}
+
+} // namespace
+
+void TiledImage::configure(const Settings& s) {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    settings = s;
+    settings.tileSize = std::max(settings.tileSize, 16);
+}
+
+TiledImage::Settings TiledImage::getSettings() {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    return settings;
+}
+
+std::string TiledImage::defaultCacheDir() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/cuems-videocomposer/tiles";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) {
+        return std::string(home) + "/.cache/cuems-videocomposer/tiles";
+    }
+    return "/tmp/cuems-videocomposer/tiles";
+}
+
+std::string TiledImage::cachePathFor(const std::string& cacheDir, const std::string& sourcePath) {
+    // Keyed by canonical path so different spellings share one file
+    char resolved[PATH_MAX];
+    std::string key = realpath(sourcePath.c_str(), resolved) ? std::string(resolved) : sourcePath;
+
+    uint64_t hash = fnv1a(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cvtiles", static_cast<unsigned long long>(hash));
+    return (cacheDir.empty() ? defaultCacheDir() : cacheDir) + "/" + name;
+}
+
+bool TiledImage::identify(const std::string& sourcePath, SourceIdentity& id) {
+    struct stat st;
+    if (stat(sourcePath.c_str(), &st) != 0) {
+        return false;
+    }
+    id.size = static_cast<uint64_t>(st.st_size);
+    id.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool TiledImage::build(const std::string& cachePath, const SourceIdentity& id, int width, int height,
+                       bool hasAlpha, int tileSize, const RowSource& rows) {
+    TilePyramid pyramid(width, height, tileSize);
+    if (pyramid.getTileCount() == 0 || !rows) {
+        return false;
+    }
+    auto started = std::chrono::steady_clock::now();
+    int stride = pyramid.getTileSize() + 2 * BORDER;
+    size_t tileBytes = static_cast<size_t>(stride) * stride * 4;
+    size_t fileSize = DATA_OFFSET + pyramid.getTileCount() * tileBytes;
+
+    size_t slash = cachePath.find_last_of('/');
+    if (slash != std::string::npos && slash > 0 && !createDirectories(cachePath.substr(0, slash))) {
+        LOG_WARNING << "Tile cache: cannot create " << cachePath.substr(0, slash) << ": " << strerror(errno);
+        return false;
+    }
+
+    // Written through a mapping of a temp file, then renamed into place.
+    // The blocks are reserved first: a full disk must fail here, not fault
+    // on a write into the mapping
+    std::string tmpPath = cachePath + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_WARNING << "Tile cache: cannot write " << tmpPath << ": " << strerror(errno);
+        return false;
+    }
+    int reserved = posix_fallocate(fd, 0, static_cast<off_t>(fileSize));
+    void* mapped = reserved == 0
+        ? mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_WARNING << "Tile cache: cannot allocate " << (fileSize >> 20) << " MB for " << cachePath << ": "
+                    << strerror(reserved != 0 ? reserved : errno);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    uint8_t* base = static_cast<uint8_t*>(mapped);
+    TileLayout layout(pyramid, base);
+
+    // Level 0 from the image, every other level from the one below in the file
+    bool ok = buildLevel(layout, pyramid, 0, rows);
+    for (int level = 1; ok && level < pyramid.getLevelCount(); ++level) {
+        int belowWidth = pyramid.levelWidth(level - 1);
+        int belowHeight = pyramid.levelHeight(level - 1);
+        int levelWidth = pyramid.levelWidth(level);
+        std::vector<uint8_t> upper(static_cast<size_t>(belowWidth) * 4);
+        std::vector<uint8_t> lower(upper.size());
+        RowSource filtered = [&](int y, int count, uint8_t* dst) {
+            for (int i = 0; i < count; ++i) {
+                int below = (y + i) * 2;
+                layout.readRow(level - 1, below, upper.data());
+                layout.readRow(level - 1, std::min(below + 1, belowHeight - 1), lower.data());
+                uint8_t* out = dst + static_cast<size_t>(i) * levelWidth * 4;
+                for (int x = 0; x < levelWidth; ++x) {
+                    size_t left = static_cast<size_t>(x) * 8;
+                    size_t right = static_cast<size_t>(std::min(x * 2 + 1, belowWidth - 1)) * 4;
+                    average4(&upper[left], &upper[right], &lower[left], &lower[right], hasAlpha, out + x * 4);
+                }
+            }
+            return true;
+        };
+        ok = buildLevel(layout, pyramid, level, filtered);
+    }
+
+    if (ok) {
+        CacheHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.tileSize = static_cast<uint32_t>(pyramid.getTileSize());
+        header.border = BORDER;
+        header.width = width;
+        header.height = height;
+        header.hasAlpha = hasAlpha ? 1 : 0;
+        header.fileSize = id.size;
+        header.fileMtimeNs = id.mtimeNs;
+        header.tileCount = pyramid.getTileCount();
+        memcpy(base, &header, sizeof(header));
+    }
+    ok = munmap(mapped, fileSize) == 0 && ok;
+
+    if (!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+        LOG_WARNING << "Tile cache: failed to build " << cachePath;
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    LOG_INFO << "Tile cache: " << width << "x" << height << " into " << pyramid.getTileCount() << " tiles, "
+             << pyramid.getLevelCount() << " levels (" << (fileSize >> 20) << " MB) in " << elapsed.count() << " ms";
+    return true;
+}
+
+TiledImage::TiledImage()
+    : hasAlpha_(false)
+    , fd_(-1)
+    , mapping_(nullptr)
+    , mappingSize_(0)
+    , prefetchCount_(0)
+    , stop_(false)
+{
+}
+
+TiledImage::~TiledImage() {
+    close();
+}
+
+bool TiledImage::open(const std::string& cachePath, const SourceIdentity& id) {
+    close();
+
+    int fd = ::open(cachePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;  // Plain miss
+    }
+    CacheHeader header;
+    struct stat st;
+    const char* reason = nullptr;
+    if (fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        reason = "unreadable";
+    } else if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        reason = "bad magic";
+    } else if (header.version != FORMAT_VERSION || header.border != static_cast<uint32_t>(BORDER)) {
+        reason = "format version mismatch";
+    } else if (header.fileSize != id.size || header.fileMtimeNs != id.mtimeNs) {
+        reason = "image changed";
+    }
+    TilePyramid pyramid;
+    if (!reason) {
+        pyramid = TilePyramid(header.width, header.height, static_cast<int>(header.tileSize));
+        size_t stride = header.tileSize + 2 * BORDER;
+        if (pyramid.getTileCount() == 0 || header.tileCount != pyramid.getTileCount() ||
+            static_cast<size_t>(st.st_size) != DATA_OFFSET + pyramid.getTileCount() * stride * stride * 4) {
+            reason = "truncated";
+        }
+    }
+    if (reason) {
+        LOG_INFO << "Tile cache stale: " << cachePath << " (" << reason << ")";
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        LOG_WARNING << "Tile cache: cannot map " << cachePath << ": " << strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    // Tiles are read where the view is, not front to back
+    madvise(mapped, static_cast<size_t>(st.st_size), MADV_RANDOM);
+
+    fd_ = fd;
+    mapping_ = static_cast<uint8_t*>(mapped);
+    mappingSize_ = static_cast<size_t>(st.st_size);
+    pyramid_ = pyramid;
+    hasAlpha_ = header.hasAlpha != 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        prefetched_.assign(pyramid_.getTileCount(), 0);
+        queue_.clear();
+        prefetchCount_ = 0;
+        stop_ = false;
+    }
+    streamThread_ = std::thread(&TiledImage::streamThreadFunc, this);
+    return true;
+}
+
+void TiledImage::close() {
+    stopStreaming();
+    if (mapping_) {
+        munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    pyramid_ = TilePyramid();
+    hasAlpha_ = false;
+}
+
+void TiledImage::stopStreaming() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        queue_.clear();
+    }
+    streamCond_.notify_all();
+    if (streamThread_.joinable()) {
+        streamThread_.join();
+    }
+}
+
+size_t TiledImage::getTileBytes() const {
+    size_t stride = static_cast<size_t>(getTileStride());
+    return stride * stride * 4;
+}
+
+const uint8_t* TiledImage::tileData(uint32_t tile) const {
+    if (!mapping_ || tile >= pyramid_.getTileCount()) {
+        return nullptr;
+    }
+    return mapping_ + DATA_OFFSET + static_cast<size_t>(tile) * getTileBytes();
+}
+
+int TiledImage::levelFitting(int maxSize) const {
+    for (int level = 0; level < pyramid_.getLevelCount(); ++level) {
+        if (pyramid_.levelWidth(level) <= maxSize && pyramid_.levelHeight(level) <= maxSize) {
+            return level;
+        }
+    }
+    return pyramid_.getTopLevel();
+}
+
+bool TiledImage::readLevel(int level, FrameBuffer& frame) const {
+    if (!mapping_ || level < 0 || level >= pyramid_.getLevelCount()) {
+        return false;
+    }
+    FrameInfo info;
+    info.width = pyramid_.levelWidth(level);
+    info.height = pyramid_.levelHeight(level);
+    info.aspect = static_cast<float>(pyramid_.getWidth()) / static_cast<float>(pyramid_.getHeight());
+    info.totalFrames = 0;
+    info.format = PixelFormat::BGRA32;
+    if (!frame.ensureAllocated(info)) {
+        return false;
+    }
+    TileLayout layout(pyramid_, mapping_);
+    uint8_t* dst = frame.data();
+    for (int y = 0; y < info.height; ++y) {
+        layout.readRow(level, y, dst + static_cast<size_t>(y) * info.width * 4);
+    }
+    return true;
+}
+
+void TiledImage::prefetch(const std::vector<uint32_t>& tiles) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        for (uint32_t tile : tiles) {
+            if (tile < prefetched_.size() && !prefetched_[tile]) {
+                queue_.push_back(tile);
+            }
+        }
+        if (queue_.empty()) {
+            return;
+        }
+    }
+    streamCond_.notify_one();
+}
+
+bool TiledImage::isPrefetched(uint32_t tile) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tile < prefetched_.size() && prefetched_[tile];
+}
+
+uint64_t TiledImage::getPrefetchCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return prefetchCount_;
+}
+
+void TiledImage::streamThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::IO);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        streamCond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+        uint32_t tile = queue_.front();
+        queue_.pop_front();
+        if (prefetched_[tile]) {
+            continue;
+        }
+        lock.unlock();
+
+        // Fault the tile's pages in here, so the upload on the render
+        // thread copies from the page cache instead of waiting on storage
+        size_t begin = DATA_OFFSET + static_cast<size_t>(tile) * getTileBytes();
+        size_t end = begin + getTileBytes();
+        size_t alignedBegin = begin & ~(PAGE_BYTES - 1);
+        madvise(mapping_ + alignedBegin, end - alignedBegin, MADV_WILLNEED);
+        uint8_t sum = 0;
+        for (size_t offset = begin; offset < end; offset += PAGE_BYTES) {
+            sum = static_cast<uint8_t>(sum + *static_cast<volatile const uint8_t*>(mapping_ + offset));
+        }
+        sum = static_cast<uint8_t>(sum + *static_cast<volatile const uint8_t*>(mapping_ + end - 1));
+        (void)sum;
+
+        lock.lock();
+        prefetched_[tile] = 1;
+        ++prefetchCount_;
+    }
+}
+
+} // namespace videocomposer
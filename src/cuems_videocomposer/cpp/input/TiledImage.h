@@ -0,0 +1,143 @@
+#ifndef VIDEOCOMPOSER_TILEDIMAGE_H
+#define VIDEOCOMPOSER_TILEDIMAGE_H
+
+#include "../video/FrameBuffer.h"
+#include "../video/TilePyramid.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * TiledImage - Giant still image served as a memory-mapped tile pyramid
+ *
+ * Projection backplates of 16K-32K exceed the maximum texture size and
+ * any sensible share of VRAM. Such an image is cut once into a tile cache
+ * file: every TilePyramid level as fixed-size BGRA tiles with a BORDER of
+ * clamped neighbour texels (so bilinear filtering never reads another
+ * tile). The file is memory-mapped; the renderer keeps only the tiles on
+ * screen resident in a fixed-size atlas and uploads them straight from
+ * the mapping.
+ *
+ * Tiles the renderer asks for are faulted in by a streaming thread, so a
+ * draw never waits on storage: until a tile is prefetched its nearest
+ * resident ancestor is drawn instead.
+ *
+ * Cache file layout (native endianness, one file per image):
+ *   Header  - magic, format version, source identity (size, mtime),
+ *             image size, tile size, border, alpha
+ *   Tile[]  - in TilePyramid index order from DATA_OFFSET, getTileBytes() each
+ */
+class TiledImage {
+public:
+    static constexpr int BORDER = 1;
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr size_t DATA_OFFSET = 4096;
+
+    struct Settings {
+        int threshold = 8192;                      // Images wider or taller than this are tiled
+        int tileSize = TilePyramid::DEFAULT_TILE_SIZE;
+        size_t vramBytes = 256 * 1024 * 1024;      // Atlas budget per layer
+        std::string cacheDir;                      // Empty = defaultCacheDir()
+    };
+
+    struct SourceIdentity {
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+    };
+
+    /**
+     * Rows of the source image as BGRA (width * 4 bytes each), requested
+     * top to bottom, each row once
+     */
+    using RowSource = std::function<bool(int y, int rows, uint8_t* dst)>;
+
+    static void configure(const Settings& settings);
+    static Settings getSettings();
+
+    /**
+     * Default cache directory: $XDG_CACHE_HOME/cuems-videocomposer/tiles,
+     * falling back to ~/.cache/cuems-videocomposer/tiles
+     */
+    static std::string defaultCacheDir();
+    static std::string cachePathFor(const std::string& cacheDir, const std::string& sourcePath);
+    static bool identify(const std::string& sourcePath, SourceIdentity& id);
+
+    /**
+     * Write the tile cache file of an image (atomically via rename).
+     * Level 0 comes from rows; each level above is filtered from the one
+     * below it in the file, so only a band of rows is held in memory.
+     */
+    static bool build(const std::string& cachePath, const SourceIdentity& id, int width, int height,
+                      bool hasAlpha, int tileSize, const RowSource& rows);
+
+    TiledImage();
+    ~TiledImage();
+
+    TiledImage(const TiledImage&) = delete;
+    TiledImage& operator=(const TiledImage&) = delete;
+
+    /**
+     * Map a tile cache file and start streaming
+     * @return false if missing, of another version or made from another source
+     */
+    bool open(const std::string& cachePath, const SourceIdentity& id);
+    void close();
+    bool isOpen() const { return mapping_ != nullptr; }
+
+    const TilePyramid& getPyramid() const { return pyramid_; }
+    bool hasAlpha() const { return hasAlpha_; }
+
+    /** Texels per tile row and column, borders included */
+    int getTileStride() const { return pyramid_.getTileSize() + 2 * BORDER; }
+    size_t getTileBytes() const;
+
+    /** Tile texels (getTileStride() square, BGRA) in the mapping */
+    const uint8_t* tileData(uint32_t tile) const;
+
+    /** Finest level no wider or taller than maxSize */
+    int levelFitting(int maxSize) const;
+
+    /** One level assembled into a BGRA frame (overview for other paths) */
+    bool readLevel(int level, FrameBuffer& frame) const;
+
+    /**
+     * Tiles needed on screen, most wanted first: replaces the tiles still
+     * queued from the previous call
+     */
+    void prefetch(const std::vector<uint32_t>& tiles);
+
+    /** The tile's pages have been read in (the kernel may still drop them) */
+    bool isPrefetched(uint32_t tile) const;
+
+    uint64_t getPrefetchCount() const;
+
+private:
+    void streamThreadFunc();
+    void stopStreaming();
+
+    TilePyramid pyramid_;
+    bool hasAlpha_;
+    int fd_;
+    uint8_t* mapping_;
+    size_t mappingSize_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable streamCond_;
+    std::deque<uint32_t> queue_;
+    std::vector<uint8_t> prefetched_;   // Per tile
+    uint64_t prefetchCount_;
+    bool stop_;
+    std::thread streamThread_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TILEDIMAGE_H
@@ -0,0 +1,550 @@
+#include "V4L2VideoInput.h"
+#include "../video/GPUTextureFrameBuffer.h"
+#include "../utils/Logger.h"
+#ifdef HAVE_V4L2_INTEROP
+#include "../hwdec/V4L2Interop.h"
+#endif
+
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+namespace videocomposer {
+
+namespace {
+
+int xioctl(int fd, unsigned long request, void* arg) {
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+bool toPixelFormat(uint32_t fourcc, PixelFormat& format) {
+    switch (fourcc) {
+        case V4L2_PIX_FMT_NV12: format = PixelFormat::NV12; return true;
+        case V4L2_PIX_FMT_UYVY: format = PixelFormat::UYVY422; return true;
+        case V4L2_PIX_FMT_YUYV: format = PixelFormat::YUYV422; return true;
+        default: return false;
+    }
+}
+
+// Bytes of one tight row (of the luma plane for NV12)
+int tightRowBytes(const FrameInfo& info) {
+    return info.format == PixelFormat::NV12 ? info.width : info.width * 2;
+}
+
+// Rows of all planes (NV12 chroma rows share the luma pitch)
+int totalRows(const FrameInfo& info) {
+    return info.format == PixelFormat::NV12 ? info.height + info.height / 2 : info.height;
+}
+
+// Y'CbCr matrix and range of the negotiated format (V4L2 defaults when unset)
+void setColorInfo(const v4l2_pix_format& pix, FrameInfo& info) {
+    uint32_t encoding = pix.ycbcr_enc;
+    if (encoding == V4L2_YCBCR_ENC_DEFAULT) {
+        encoding = V4L2_MAP_YCBCR_ENC_DEFAULT(pix.colorspace);
+    }
+    switch (encoding) {
+        case V4L2_YCBCR_ENC_709:
+            info.colorMatrix = ColorMatrix::BT709;
+            break;
+        case V4L2_YCBCR_ENC_BT2020:
+            info.colorMatrix = ColorMatrix::BT2020;
+            break;
+        default:
+            info.colorMatrix = ColorMatrix::BT601;
+            break;
+    }
+    uint32_t quantization = pix.quantization;
+    if (quantization == V4L2_QUANTIZATION_DEFAULT) {
+        quantization = V4L2_MAP_QUANTIZATION_DEFAULT(false, pix.colorspace, encoding);
+    }
+    info.colorRange = quantization == V4L2_QUANTIZATION_FULL_RANGE ? ColorRange::FULL : ColorRange::LIMITED;
+}
+
+std::atomic<uint32_t> nextInstanceId{1};
+
+} // namespace
+
+// Device fd and its mapped buffers; frames still held by layers keep it alive
+struct V4L2VideoInput::Device {
+    struct Buffer {
+        uint8_t* memory = nullptr;
+        size_t length = 0;
+        int dmabuf = -1;        // VIDIOC_EXPBUF, -1 if the driver can't export
+    };
+
+    int fd = -1;
+    std::vector<Buffer> buffers;
+    std::atomic<bool> streaming{false};
+
+    ~Device() {
+        for (Buffer& buffer : buffers) {
+            if (buffer.memory) {
+                munmap(buffer.memory, buffer.length);
+            }
+            if (buffer.dmabuf >= 0) {
+                ::close(buffer.dmabuf);
+            }
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool queue(uint32_t index) {
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = index;
+        return xioctl(fd, VIDIOC_QBUF, &buf) == 0;
+    }
+};
+
+V4L2VideoInput::V4L2VideoInput()
+    : frameCount_(0)
+    , framesSkipped_(0)
+{
+#ifdef HAVE_V4L2_INTEROP
+    instanceId_ = nextInstanceId++;
+#endif
+}
+
+V4L2VideoInput::~V4L2VideoInput() {
+    close();
+}
+
+bool V4L2VideoInput::open(const std::string& source) {
+    close();
+
+    auto device = std::make_shared<Device>();
+    device->fd = ::open(source.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (device->fd < 0) {
+        LOG_ERROR << "V4L2: Cannot open " << source << ": " << strerror(errno);
+        return false;
+    }
+
+    v4l2_capability cap{};
+    if (xioctl(device->fd, VIDIOC_QUERYCAP, &cap) < 0) {
+        LOG_ERROR << "V4L2: " << source << " is not a V4L2 device";
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        LOG_WARNING << "V4L2: " << source << " has no single-planar streaming capture"
+                    << ((caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) ? " (multi-planar only)" : "");
+        return false;
+    }
+
+    device_ = device;
+    devicePath_ = source;
+    if (!negotiateFormat() || !allocateBuffers()) {
+        device_.reset();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < device_->buffers.size(); ++i) {
+        if (!device_->queue(i)) {
+            LOG_ERROR << "V4L2: VIDIOC_QBUF failed: " << strerror(errno);
+            device_.reset();
+            return false;
+        }
+    }
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(device_->fd, VIDIOC_STREAMON, &type) < 0) {
+        LOG_ERROR << "V4L2: VIDIOC_STREAMON failed: " << strerror(errno);
+        device_.reset();
+        return false;
+    }
+    device_->streaming = true;
+
+#ifdef HAVE_V4L2_INTEROP
+    // DMA-BUF import needs every buffer exported
+    bool exported = !device_->buffers.empty();
+    for (const Device::Buffer& buffer : device_->buffers) {
+        exported = exported && buffer.dmabuf >= 0;
+    }
+    if (exported && displayBackend_) {
+        interop_ = std::make_unique<V4L2Interop>();
+        if (!interop_->init(displayBackend_)) {
+            interop_.reset();
+        }
+    } else if (!exported) {
+        LOG_INFO << "V4L2: Driver cannot export DMA-BUFs, uploading frames";
+    }
+    importFailed_ = false;
+#endif
+
+    ready_ = true;
+    startCaptureThread();
+
+    const char* formatName = frameInfo_.format == PixelFormat::NV12 ? "NV12"
+                           : frameInfo_.format == PixelFormat::UYVY422 ? "UYVY" : "YUYV";
+    LOG_INFO << "V4L2: " << source << " (" << cap.card << ") " << frameInfo_.width << "x" << frameInfo_.height
+             << " " << formatName << " @ " << frameInfo_.framerate << " fps, "
+             << device_->buffers.size() << " buffers" << (hasDmaBufImport() ? ", DMA-BUF import" : "");
+    return true;
+}
+
+bool V4L2VideoInput::negotiateFormat() {
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(device_->fd, VIDIOC_G_FMT, &fmt) < 0) {
+        LOG_ERROR << "V4L2: VIDIOC_G_FMT failed: " << strerror(errno);
+        return false;
+    }
+
+    // Formats the renderer converts on the GPU, in order of preference
+    std::vector<uint32_t> candidates;
+    if (preferredFormat_ == "nv12") {
+        candidates = {V4L2_PIX_FMT_NV12};
+    } else if (preferredFormat_ == "uyvy") {
+        candidates = {V4L2_PIX_FMT_UYVY};
+    } else if (preferredFormat_ == "yuyv") {
+        candidates = {V4L2_PIX_FMT_YUYV};
+    } else {
+        candidates = {V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_UYVY, V4L2_PIX_FMT_YUYV};
+    }
+
+    std::vector<uint32_t> supported;
+    v4l2_fmtdesc desc{};
+    desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    while (xioctl(device_->fd, VIDIOC_ENUM_FMT, &desc) == 0) {
+        supported.push_back(desc.pixelformat);
+        desc.index++;
+    }
+
+    uint32_t chosen = 0;
+    for (uint32_t candidate : candidates) {
+        for (uint32_t format : supported) {
+            if (format == candidate) {
+                chosen = candidate;
+                break;
+            }
+        }
+        if (chosen) {
+            break;
+        }
+    }
+    if (!chosen) {
+        LOG_WARNING << "V4L2: " << devicePath_ << " offers no " << (preferredFormat_ == "auto" ? "NV12, UYVY or YUYV"
+                                                                                             : preferredFormat_)
+                    << " capture";
+        return false;
+    }
+
+    fmt.fmt.pix.pixelformat = chosen;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(device_->fd, VIDIOC_S_FMT, &fmt) < 0 || fmt.fmt.pix.pixelformat != chosen) {
+        LOG_ERROR << "V4L2: VIDIOC_S_FMT failed: " << strerror(errno);
+        return false;
+    }
+
+    FrameInfo info;
+    // Woven fields are deinterlaced by the renderer; separate fields are not supported
+    switch (fmt.fmt.pix.field) {
+        case V4L2_FIELD_NONE:
+        case V4L2_FIELD_ANY:
+            break;
+        case V4L2_FIELD_INTERLACED_TB:
+            info.fieldOrder = FieldOrder::TOP_FIRST;
+            break;
+        case V4L2_FIELD_INTERLACED_BT:
+            info.fieldOrder = FieldOrder::BOTTOM_FIRST;
+            break;
+        case V4L2_FIELD_INTERLACED:
+            // Temporal order left to the standard: NTSC is bottom field first
+            info.fieldOrder = fmt.fmt.pix.height == 480 ? FieldOrder::BOTTOM_FIRST : FieldOrder::TOP_FIRST;
+            break;
+        default:
+            LOG_WARNING << "V4L2: Capture delivers fields as separate buffers, shown as they come";
+            break;
+    }
+    if (info.fieldOrder != FieldOrder::PROGRESSIVE) {
+        LOG_INFO << "V4L2: Interlaced capture ("
+                 << (info.fieldOrder == FieldOrder::TOP_FIRST ? "top" : "bottom") << " field first)";
+    }
+    toPixelFormat(chosen, info.format);
+    info.width = static_cast<int>(fmt.fmt.pix.width) & ~1;
+    info.height = static_cast<int>(fmt.fmt.pix.height) & ~1;
+    info.aspect = static_cast<float>(info.width) / static_cast<float>(info.height > 0 ? info.height : 1);
+    setColorInfo(fmt.fmt.pix, info);
+
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(device_->fd, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator > 0) {
+        info.framerateNum = static_cast<int>(parm.parm.capture.timeperframe.denominator);
+        info.framerateDen = static_cast<int>(parm.parm.capture.timeperframe.numerator);
+        info.framerate = static_cast<double>(info.framerateNum) / info.framerateDen;
+    }
+
+    bytesPerLine_ = fmt.fmt.pix.bytesperline;
+    if (bytesPerLine_ < static_cast<uint32_t>(tightRowBytes(info))) {
+        bytesPerLine_ = static_cast<uint32_t>(tightRowBytes(info));
+    }
+    frameInfo_ = info;
+    return true;
+}
+
+bool V4L2VideoInput::allocateBuffers() {
+    int depth = queueDepth_ < 2 ? 2 : (queueDepth_ > 32 ? 32 : queueDepth_);
+
+    v4l2_requestbuffers req{};
+    req.count = static_cast<uint32_t>(depth);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(device_->fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        LOG_ERROR << "V4L2: VIDIOC_REQBUFS failed: " << strerror(errno);
+        return false;
+    }
+    if (req.count <= 3) {
+        LOG_WARNING << "V4L2: Only " << req.count << " buffers, the driver may drop frames while "
+                    << "the composer holds them (v4l2_buffers)";
+    }
+
+    size_t frameBytes = static_cast<size_t>(bytesPerLine_) * totalRows(frameInfo_);
+    device_->buffers.resize(req.count);
+    for (uint32_t i = 0; i < req.count; ++i) {
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(device_->fd, VIDIOC_QUERYBUF, &buf) < 0 || buf.length < frameBytes) {
+            LOG_ERROR << "V4L2: VIDIOC_QUERYBUF failed for buffer " << i;
+            return false;
+        }
+        void* memory = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, device_->fd, buf.m.offset);
+        if (memory == MAP_FAILED) {
+            LOG_ERROR << "V4L2: mmap failed for buffer " << i << ": " << strerror(errno);
+            return false;
+        }
+        Device::Buffer& buffer = device_->buffers[i];
+        buffer.memory = static_cast<uint8_t*>(memory);
+        buffer.length = buf.length;
+
+        v4l2_exportbuffer expbuf{};
+        expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        expbuf.index = i;
+        expbuf.flags = O_RDONLY | O_CLOEXEC;
+        if (xioctl(device_->fd, VIDIOC_EXPBUF, &expbuf) == 0) {
+            buffer.dmabuf = expbuf.fd;
+        }
+    }
+    return true;
+}
+
+void V4L2VideoInput::close() {
+    stopCaptureThread();  // Stop async capture first
+
+    if (device_) {
+        device_->streaming = false;
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(device_->fd, VIDIOC_STREAMOFF, &type);
+        if (framesSkipped_ > 0) {
+            LOG_INFO << "V4L2: " << framesSkipped_.load() << " frames skipped for newer ones";
+        }
+    }
+
+#ifdef HAVE_V4L2_INTEROP
+    interop_.reset();
+    shown_.release();
+    previous_.release();
+    fallback_.release();
+#endif
+    // Frames still held by layers keep the mapping until they are released
+    device_.reset();
+    ready_ = false;
+    frameCount_ = 0;
+    framesSkipped_ = 0;
+}
+
+bool V4L2VideoInput::supportsDirectGPUTexture() const {
+    return hasDmaBufImport();
+}
+
+InputSource::DecodeBackend V4L2VideoInput::getOptimalBackend() const {
+    return hasDmaBufImport() ? DecodeBackend::GPU_HARDWARE : DecodeBackend::CPU_SOFTWARE;
+}
+
+bool V4L2VideoInput::hasDmaBufImport() const {
+#ifdef HAVE_V4L2_INTEROP
+    return interop_ && !importFailed_;
+#else
+    return false;
+#endif
+}
+
+bool V4L2VideoInput::captureFrame(FrameBuffer& buffer) {
+    // The stale frame in this buffer goes back to the driver before we wait
+    buffer.release();
+
+    std::shared_ptr<Device> device = device_;
+    if (!device || !device->streaming) {
+        return false;
+    }
+
+    pollfd pfd{device->fd, POLLIN, 0};
+    if (poll(&pfd, 1, 100) <= 0) {
+        return false;  // No signal (or stopping)
+    }
+
+    // Drain: only the newest filled buffer is kept
+    v4l2_buffer latest{};
+    bool haveFrame = false;
+    while (true) {
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(device->fd, VIDIOC_DQBUF, &buf) < 0) {
+            break;  // EAGAIN: nothing more filled
+        }
+        if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+            device->queue(buf.index);
+            continue;
+        }
+        if (haveFrame) {
+            device->queue(latest.index);
+            framesSkipped_++;
+        }
+        latest = buf;
+        haveFrame = true;
+    }
+    if (!haveFrame || latest.index >= device->buffers.size()) {
+        return false;
+    }
+
+    // Wrap the mapping; the buffer is queued again with the last reference
+    uint32_t index = latest.index;
+    Device::Buffer& mapped = device->buffers[index];
+    std::shared_ptr<void> owner(mapped.memory, [device, index](void*) {
+        if (device->streaming) {
+            device->queue(index);
+        }
+    });
+    size_t size = static_cast<size_t>(bytesPerLine_) * totalRows(frameInfo_);
+    if (!buffer.wrap(mapped.memory, size, frameInfo_, owner)) {
+        return false;
+    }
+    frameCount_++;
+    return true;
+}
+
+bool V4L2VideoInput::readLatestFrame(FrameBuffer& buffer) {
+#ifdef HAVE_V4L2_INTEROP
+    if (fallback_.isValid()) {
+        FrameBuffer frame;
+        frame.swap(fallback_);
+        if (bytesPerLine_ == static_cast<uint32_t>(tightRowBytes(frameInfo_))) {
+            buffer.swap(frame);
+            return true;
+        }
+        return copyTight(frame.data(), bytesPerLine_, frame.info(), buffer);
+    }
+#endif
+    if (bytesPerLine_ == static_cast<uint32_t>(tightRowBytes(frameInfo_))) {
+        return LiveInputSource::readLatestFrame(buffer);
+    }
+
+    // Padded rows: the driver buffer goes back as soon as it is copied
+    FrameBuffer padded;
+    if (!LiveInputSource::readLatestFrame(padded)) {
+        return false;
+    }
+    return copyTight(padded.data(), bytesPerLine_, padded.info(), buffer);
+}
+
+bool V4L2VideoInput::readLatestFrameToTexture(GPUTextureFrameBuffer& textureBuffer) {
+#ifdef HAVE_V4L2_INTEROP
+    if (!hasDmaBufImport()) {
+        return false;
+    }
+    FrameBuffer frame;
+    if (!LiveInputSource::readLatestFrame(frame)) {
+        return false;
+    }
+
+    const FrameInfo& info = frame.info();
+    int index = bufferIndexOf(frame);
+    GLuint textures[2] = {0, 0};
+    bool imported = index >= 0 &&
+        interop_->importBuffer(index, device_->buffers[index].dmabuf, info.format,
+                               info.width, info.height, bytesPerLine_, textures);
+    if (imported) {
+        imported = info.format == PixelFormat::NV12
+            ? textureBuffer.setExternalNV12Textures(textures[0], textures[1], info)
+            : textureBuffer.setExternalPackedTexture(
+                  textures[0], info.format == PixelFormat::UYVY422 ? TexturePlaneType::YUV_UYVY
+                                                                   : TexturePlaneType::YUV_YUYV, info);
+    }
+    if (!imported) {
+        LOG_WARNING << "V4L2: DMA-BUF import failed, uploading frames instead";
+        importFailed_ = true;
+        fallback_.swap(frame);
+        return false;
+    }
+
+    if (info.format == PixelFormat::NV12) {
+        // Lets the DRM backend scan the capture buffer out directly
+        DmaBufPlanes planes;
+        planes.key = (1ull << 63) | (static_cast<uint64_t>(instanceId_) << 32) | static_cast<uint32_t>(index);
+        planes.fds[0] = device_->buffers[index].dmabuf;
+        planes.fds[1] = device_->buffers[index].dmabuf;
+        planes.offsets[1] = bytesPerLine_ * static_cast<uint32_t>(info.height);
+        planes.pitches[0] = bytesPerLine_;
+        planes.pitches[1] = bytesPerLine_;
+        planes.width = info.width;
+        planes.height = info.height;
+        planes.owner = std::make_shared<FrameBuffer>(frame);  // Shares the buffer
+        textureBuffer.setDmaBufPlanes(planes);
+    }
+
+    // The frame drawn last may still be read by the GPU: keep it one more frame
+    previous_.swap(shown_);
+    shown_.swap(frame);
+    return true;
+#else
+    (void)textureBuffer;
+    return false;
+#endif
+}
+
+int V4L2VideoInput::bufferIndexOf(const FrameBuffer& frame) const {
+    if (!device_ || !frame.isShared()) {
+        return -1;
+    }
+    for (size_t i = 0; i < device_->buffers.size(); ++i) {
+        if (device_->buffers[i].memory == frame.data()) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool V4L2VideoInput::copyTight(const uint8_t* data, uint32_t bytesPerLine, const FrameInfo& info,
+                               FrameBuffer& buffer) {
+    PixelFormat format = info.format;
+    if (!data || (format != PixelFormat::NV12 && format != PixelFormat::UYVY422 &&
+                  format != PixelFormat::YUYV422)) {
+        return false;
+    }
+    int rowBytes = tightRowBytes(info);
+    if (bytesPerLine < static_cast<uint32_t>(rowBytes) || !buffer.ensureAllocated(info)) {
+        return false;
+    }
+    int rows = totalRows(info);
+    uint8_t* dst = buffer.data();
+    for (int row = 0; row < rows; ++row) {
+        memcpy(dst + static_cast<size_t>(row) * rowBytes, data + static_cast<size_t>(row) * bytesPerLine, rowBytes);
+    }
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,127 @@
+#ifndef VIDEOCOMPOSER_V4L2VIDEOINPUT_H
+#define VIDEOCOMPOSER_V4L2VIDEOINPUT_H
+
+#include "LiveInputSource.h"
+#include "../video/FrameFormat.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace videocomposer {
+
+class DisplayBackend;
+class GPUTextureFrameBuffer;
+#ifdef HAVE_V4L2_INTEROP
+class V4L2Interop;
+#endif
+
+/**
+ * V4L2VideoInput - Native V4L2 capture input (capture cards, cameras)
+ *
+ * Streams from /dev/video* with MMAP buffers and never copies a frame:
+ * a dequeued buffer is handed to the layer as is (FrameBuffer::wrap()) and
+ * goes back to the driver when the last FrameBuffer referencing it is
+ * released. With EGL the buffers are also exported as DMA-BUFs
+ * (VIDIOC_EXPBUF) and imported as textures through V4L2Interop, so the
+ * GPU samples the capture memory directly; without it the renderer
+ * uploads the same memory and converts it in a shader. NV12, UYVY and
+ * YUYV are captured natively, all converted to RGB on the GPU.
+ *
+ * Latency: the capture thread drains every filled buffer and keeps only
+ * the newest, so a frame is at most one frame period old when the layer
+ * takes it. The queue depth only sets how many buffers the driver can
+ * fill ahead: up to three are held outside the driver (the newest, the
+ * one on screen, and the previous one the GPU may still read), so the
+ * depth must leave the driver at least one. Single-planar devices only.
+ */
+class V4L2VideoInput : public LiveInputSource {
+public:
+    V4L2VideoInput();
+    virtual ~V4L2VideoInput();
+
+    // InputSource interface
+    bool open(const std::string& source) override;
+    void close() override;
+    bool isReady() const override { return ready_; }
+    FrameInfo getFrameInfo() const override { return frameInfo_; }
+    int64_t getCurrentFrame() const override { return frameCount_.load(); }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override;
+    DecodeBackend getOptimalBackend() const override;
+
+    /**
+     * Newest frame as CPU memory (shared with the driver buffer when its
+     * rows are tight, copied tight otherwise)
+     */
+    bool readLatestFrame(FrameBuffer& buffer) override;
+
+    /**
+     * Newest frame as textures of the capture buffer (GL thread)
+     * @return false if there is no new frame or the import failed (then
+     *         hasDmaBufImport() is false and readLatestFrame() takes over)
+     */
+    bool readLatestFrameToTexture(GPUTextureFrameBuffer& textureBuffer);
+
+    /**
+     * Buffers are imported into EGL instead of uploaded
+     */
+    bool hasDmaBufImport() const;
+
+    // Settings (before open())
+    void setDisplayBackend(DisplayBackend* display) { displayBackend_ = display; }
+    void setQueueDepth(int buffers) { queueDepth_ = buffers; }
+    /**
+     * Capture format: "auto" (NV12, then UYVY, then YUYV), "nv12", "uyvy" or "yuyv"
+     */
+    void setPreferredFormat(const std::string& format) { preferredFormat_ = format; }
+
+    /**
+     * Copy a capture buffer with padded rows into a tight frame
+     * @param bytesPerLine Row pitch of the source (of the luma plane for NV12)
+     */
+    static bool copyTight(const uint8_t* data, uint32_t bytesPerLine, const FrameInfo& info,
+                          FrameBuffer& buffer);
+
+protected:
+    // LiveInputSource interface
+    bool captureFrame(FrameBuffer& buffer) override;
+    const char* getSourceTypeName() const override { return "V4L2"; }
+
+private:
+    struct Device;
+
+    bool negotiateFormat();
+    bool allocateBuffers();
+
+    // Buffer index of a frame wrapped by captureFrame(), -1 if none
+    int bufferIndexOf(const FrameBuffer& frame) const;
+
+    std::shared_ptr<Device> device_;
+    std::string devicePath_;
+    FrameInfo frameInfo_;
+    uint32_t bytesPerLine_ = 0;
+    bool ready_ = false;
+    std::atomic<int64_t> frameCount_;
+    std::atomic<uint64_t> framesSkipped_;   // Drained in favour of a newer buffer
+
+    DisplayBackend* displayBackend_ = nullptr;
+    int queueDepth_ = 5;
+    std::string preferredFormat_ = "auto";
+
+#ifdef HAVE_V4L2_INTEROP
+    std::unique_ptr<V4L2Interop> interop_;
+    bool importFailed_ = false;
+    uint32_t instanceId_;                   // DmaBufPlanes keys
+    // Frames shown from textures: their buffers stay out of the driver
+    // until the GPU is done with them
+    FrameBuffer shown_;
+    FrameBuffer previous_;
+    // Frame that failed to import, handed to the next readLatestFrame()
+    FrameBuffer fallback_;
+#endif
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_V4L2VIDEOINPUT_H
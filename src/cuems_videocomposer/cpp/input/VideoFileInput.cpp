@@ -1,16 +1,33 @@
 #include "VideoFileInput.h"
 #include "../../ffcompat.h"
 #include "../utils/CLegacyBridge.h"
+#include "../utils/FlightRecorder.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "SharedMediaRegistry.h"
+#include "ContainerIndex.h"
+#include "HardwareDeviceCache.h"
+#include "DecoderContextPool.h"
+#include "MediaProbe.h"
 #include <cstring>
 #include <cassert>
 #include <algorithm>
 #include <vector>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #ifdef HAVE_VAAPI_INTEROP
 #include "../hwdec/VaapiInterop.h"
+#include "../hwdec/VaapiDmaBufExporter.h"
 #include "../display/DisplayBackend.h"
 #endif
+#ifdef HAVE_CUDA_INTEROP
+#include "../hwdec/CudaInterop.h"
+#endif
+#ifdef HAVE_VULKAN_INTEROP
+#include "../hwdec/VulkanInterop.h"
+#endif
 
 // OpenGL includes
 #ifdef __APPLE__
@@ -22,6 +39,7 @@
 extern "C" {
 #include <libavutil/avutil.h>
 #include <libavutil/mathematics.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/mem.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/error.h>
@@ -36,20 +54,31 @@ VideoFileInput::VideoFileInput()
     , codecCtx_(nullptr)
     , frame_(nullptr)
     , frameFMT_(nullptr)
-    , swsCtx_(nullptr)
-    , swsCtxWidth_(0)
-    , swsCtxHeight_(0)
-    , swsCtxFormat_(AV_PIX_FMT_NONE)
+    , windowFrame_(nullptr)
     , videoStream_(-1)
     , hwDeviceCtx_(nullptr)
+    , renderNodeSession_(0)
+    , renderNodeShareFailed_(false)
     , hwFrame_(nullptr)
     , hwDecoderType_(HardwareDecoder::Type::NONE)
     , useHardwareDecoding_(false)
     , codecCtxAllocated_(false)
     , hwPreference_(HardwareDecodePreference::AUTO)
+    , hwLastDecodedFrame_(-1)
+    , planarOutput_(false)
+    , reversePlayback_(false)
+    , reverseCacheBudget_(0)
+    , keyframeOnlyStep_(8)
+    , skipMode_(AsyncDecodeQueue::SkipMode::NONE)
 #ifdef HAVE_VAAPI_INTEROP
     , vaapiInterop_(nullptr)
     , displayBackend_(nullptr)
+#endif
+#ifdef HAVE_CUDA_INTEROP
+    , cudaInterop_(nullptr)
+#endif
+#ifdef HAVE_VULKAN_INTEROP
+    , vulkanInterop_(nullptr)
 #endif
     , frameIndex_(nullptr)
     , frameCount_(0)
@@ -58,12 +87,28 @@ VideoFileInput::VideoFileInput()
     , scanComplete_(false)
     , byteSeek_(false)
     , noIndex_(false)
+    , useIndexCache_(true)
+    , decodePriority_(DecodeAheadBudget::DEFAULT_PRIORITY)
+    , decodeVisible_(true)
+    , underrunPolicy_(UnderrunPolicy::BLOCK)
+    , readAheadMode_(ReadAheadIO::Mode::OFF)
+    , readAheadBytes_(ReadAheadIO::DEFAULT_WINDOW_BYTES)
+    , preload_(false)
+    , directIoBitrate_(0)
+    , intraDecoders_(0)
+    , deinterlaceMode_(FieldSelector::Mode::AUTO)
+    , pageCacheClient_(0)
+    , backgroundIndexing_(false)
+    , backgroundIndexTotal_(0)
+    , backgroundIndexByteSeek_(false)
+    , indexAbort_(nullptr)
     , frameInfo_()
     , currentFile_()
     , ignoreStartOffset_(false)
     , currentFrame_(-1)
     , ready_(false)
     , frameRateQ_({1, 1})
+    , framePoolBudget_(0)
     , useAsyncDecode_(false)
 {
 }
@@ -95,8 +140,17 @@ bool VideoFileInput::open(const std::string& source) {
         return false;
     }
 
+    // Preloaded clips are demuxed from their RAM copy; caches stay keyed by the file
+    if (preload_) {
+        ramClip_ = RamClipCache::instance().acquire(source, indexAbort_);
+    }
+    if (indexAbort_ && *indexAbort_) {
+        return false;
+    }
+    const std::string& readPath = ramClip_ ? ramClip_->path() : source;
+
     // Open video file using MediaFileReader
-    if (!mediaReader_.open(source)) {
+    if (!mediaReader_.open(readPath)) {
         return false;
     }
 
@@ -114,8 +168,23 @@ bool VideoFileInput::open(const std::string& source) {
         return false;
     }
 
+    // MediaFileReader always probes; keep the result for demuxers opened
+    // on their own (AsyncDecodeQueue), which can skip that step
+    if (useIndexCache_) {
+        FrameIndexCache cache(indexCacheDir_);
+        FrameIndexCache::Probe probe;
+        if (!cache.loadProbe(source, probe) && MediaProbe::capture(formatCtx_, videoStream_, probe)) {
+            cache.storeProbe(source, probe);
+        }
+    }
+
     // Open codec (try hardware first, fallback to software)
-    if (!openHardwareCodec() && !openCodec()) {
+    bool codecOpened = openHardwareCodec();
+    if (!codecOpened) {
+        releaseRenderNode();
+        codecOpened = openCodec();
+    }
+    if (!codecOpened) {
         mediaReader_.close();
         formatCtx_ = nullptr;
         return false;
@@ -160,7 +229,24 @@ bool VideoFileInput::open(const std::string& source) {
     frameInfo_.height = height;
     frameInfo_.aspect = (float)width / (float)height;
     frameInfo_.framerate = framerate;
+    frameInfo_.framerateNum = framerate > 0.0 ? avStream->r_frame_rate.num : 0;
+    frameInfo_.framerateDen = framerate > 0.0 ? avStream->r_frame_rate.den : 1;
     frameInfo_.duration = duration;
+    // Display field order as flagged (TB/BB: bottom field shown first)
+    AVCodecParameters* fieldParams = mediaReader_.getCodecParameters(videoStream_);
+    switch (fieldParams ? fieldParams->field_order : AV_FIELD_UNKNOWN) {
+        case AV_FIELD_TT:
+        case AV_FIELD_BT:
+            frameInfo_.fieldOrder = FieldOrder::TOP_FIRST;
+            break;
+        case AV_FIELD_BB:
+        case AV_FIELD_TB:
+            frameInfo_.fieldOrder = FieldOrder::BOTTOM_FIRST;
+            break;
+        default:
+            frameInfo_.fieldOrder = FieldOrder::PROGRESSIVE;
+            break;
+    }
     // Use BGRA32 format for OpenGL rendering (matches original xjadeo)
     frameInfo_.format = PixelFormat::BGRA32;
 
@@ -173,8 +259,15 @@ bool VideoFileInput::open(const std::string& source) {
     }
 
     // Index frames (unless --noindex flag is set)
-    if (!noIndex_) {
-    if (!indexFrames()) {
+    if (!noIndex_ && backgroundIndexing_ && !isIntraFrameCodec() &&
+        !loadSharedIndex() && !(useIndexCache_ && loadIndexFromCache())) {
+        // Playable immediately via timestamp seeks; exact seeks come online
+        // as the background indexer publishes its progress
+        scanComplete_ = true;
+        frameCount_ = frameInfo_.totalFrames;
+        startBackgroundIndexing();
+    } else if (!noIndex_) {
+    if (!scanComplete_ && !indexFrames()) {
         cleanup();
         return false;
     }
@@ -193,13 +286,45 @@ bool VideoFileInput::open(const std::string& source) {
     ready_ = true;
     currentFrame_ = -1;
     
+    // Intra-only software streams decode ahead on several decoders, each
+    // holding a pool slot while it works
+    int intraDecoders = 0;
+    if (!useHardwareDecoding_ && isIntraFrameCodec()) {
+        intraDecoders = intraDecoders_ > 0 ? intraDecoders_ : decoderThreads_.threads;
+        if (intraDecoders < 2) {
+            intraDecoders = 0;
+        }
+    }
+    createFramePool(intraDecoders > 0 ? static_cast<size_t>(intraDecoders) + 2 : 0);
+    
     // Initialize async decode queue for hardware decoding
     // This provides mpv-style pre-buffering for smooth playback
-    if (useHardwareDecoding_ && hwDeviceCtx_) {
+    if ((useHardwareDecoding_ && hwDeviceCtx_) || intraDecoders > 0) {
         asyncDecodeQueue_ = std::make_unique<AsyncDecodeQueue>();
-        if (asyncDecodeQueue_->open(currentFile_, hwDeviceCtx_)) {
+        asyncDecodeQueue_->setPriority(decodePriority_);
+        asyncDecodeQueue_->setVisible(decodeVisible_);
+        asyncDecodeQueue_->setIntraDecoders(intraDecoders);
+        asyncDecodeQueue_->setCatchUp(underrunPolicy_ == UnderrunPolicy::DROP);
+        asyncDecodeQueue_->setSkipMode(skipMode_);
+        bool direct = !ramClip_ && directIoBitrate_ > 0 && formatCtx_ && formatCtx_->bit_rate >= directIoBitrate_;
+        ReadAheadIO::Mode readAhead = ramClip_ ? ReadAheadIO::Mode::OFF : readAheadMode_;
+        asyncDecodeQueue_->setReadAhead(readAhead, readAheadBytes_, direct);
+        asyncDecodeQueue_->setProbeCache(useIndexCache_ && !ramClip_, indexCacheDir_);
+        // One demuxer and decoder per layer: the queue decodes on ours,
+        // unless it needs its own reads (MediaFileReader takes no custom I/O)
+        bool separate = direct || ReadAheadIO::wanted(readAhead, currentFile_);
+        bool started = separate
+            ? asyncDecodeQueue_->open(ramClip_ ? ramClip_->path() : currentFile_, hwDeviceCtx_, framePool_)
+            : asyncDecodeQueue_->attach(currentFile_, formatCtx_, videoStream_, codecCtx_, framePool_);
+        if (started && !useHardwareDecoding_ && asyncDecodeQueue_->getIntraDecoders() == 0) {
+            // No parallel decoders after all: decode synchronously as before
+            asyncDecodeQueue_->close();
+            asyncDecodeQueue_.reset();
+            useAsyncDecode_ = false;
+        } else if (started) {
             useAsyncDecode_ = true;
-            LOG_INFO << "Async decode queue enabled for smooth hardware decoding";
+            LOG_INFO << "Async decode queue enabled for smooth " << (useHardwareDecoding_ ? "hardware" : "intra")
+                     << " decoding";
         } else {
             LOG_WARNING << "Failed to initialize async decode queue, using synchronous decode";
             asyncDecodeQueue_.reset();
@@ -220,14 +345,21 @@ void VideoFileInput::close() {
     
     // Stop async decode thread first
     stopAsyncDecode();
+    stopBackgroundIndexing();
     
-    // Clear frame cache
+    // Clear frame cache (returns slots to the pool)
     {
         std::lock_guard<std::mutex> lock(cacheMutex_);
         frameCache_.clear();
     }
+    framePool_.reset();
     
     cleanup();
+    ramClip_.reset();
+    if (pageCacheClient_) {
+        PageCachePolicy::instance().removePlayhead(pageCacheClient_);
+        pageCacheClient_ = 0;
+    }
     currentFile_.clear();
     ready_ = false;
     currentFrame_ = -1;
@@ -292,6 +424,7 @@ static bool isCompatibleWithHardwareDecoder(AVCodecParameters* codecParams, Hard
     switch (hwType) {
         case HardwareDecoder::Type::VAAPI:
         case HardwareDecoder::Type::VIDEOTOOLBOX:
+        case HardwareDecoder::Type::VULKAN:
             // These use standard decoder with hw_device_ctx
             codec = avcodec_find_decoder(codecId);
             break;
@@ -375,6 +508,10 @@ bool VideoFileInput::openHardwareCodec() {
             forceSpecificDecoder = true;
             forcedType = HardwareDecoder::Type::CUDA;
             break;
+        case HardwareDecodePreference::VULKAN:
+            forceSpecificDecoder = true;
+            forcedType = HardwareDecoder::Type::VULKAN;
+            break;
         default:
             break;
     }
@@ -411,7 +548,7 @@ bool VideoFileInput::openHardwareCodec() {
     // Find hardware decoder
     // NOTE: Different hardware decoders work differently:
     // - QSV/CUVID/DXVA2: Have dedicated wrapper decoders (h264_qsv, h264_cuvid)
-    // - VAAPI/VideoToolbox: Use standard decoder with hw_device_ctx attached
+    // - VAAPI/VideoToolbox/Vulkan: Use standard decoder with hw_device_ctx attached
     
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 0, 0)
     const AVCodec* hwCodec = nullptr;
@@ -423,7 +560,8 @@ bool VideoFileInput::openHardwareCodec() {
     switch (hwDecoderType_) {
         case HardwareDecoder::Type::VAAPI:
         case HardwareDecoder::Type::VIDEOTOOLBOX:
-            // VAAPI and VideoToolbox use the standard decoder with hw_device_ctx (hwaccel method)
+        case HardwareDecoder::Type::VULKAN:
+            // VAAPI, VideoToolbox and Vulkan use the standard decoder with hw_device_ctx (hwaccel method)
             hwCodec = avcodec_find_decoder(codecId);
             hwCodecName = codecName + " (with " + HardwareDecoder::getName(hwDecoderType_) + " hwaccel)";
             break;
@@ -505,44 +643,160 @@ bool VideoFileInput::openHardwareCodec() {
         hwPixFmt = HardwareDecoder::getHardwarePixelFormat(hwDecoderType_, codecId);
     }
 
-    // Create hardware device context (needed for frame transfers even if not for codec)
-    int ret = -1;
+    // Hardware device context (needed for frame transfers even if not for codec),
+    // one per device shared by all its decoders (HardwareDeviceCache)
+    std::string deviceKey;
+
+    // With several GPUs, VAAPI decoders go to the least loaded render node;
+    // frames from a node other than the compositing GPU's are shared as DMA-BUF
+    releaseRenderNode();
+    HardwareDeviceCache& devices = HardwareDeviceCache::instance();
+    if (hwDeviceType == AV_HWDEVICE_TYPE_VAAPI) {
+        RenderNodeManager& nodes = RenderNodeManager::instance();
+        renderNodeSession_ = nodes.acquire(codecParams->width, codecParams->height);
+
+        // Probed capabilities (profile, size, bit depth) of the node it would run on
+        int bitDepth = codecParams->bits_per_raw_sample;
+        const AVPixFmtDescriptor* pixDesc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(codecParams->format));
+        if (bitDepth <= 0) {
+            bitDepth = pixDesc ? pixDesc->comp[0].depth : 8;
+        }
+        auto supportedOn = [&](const std::string& node) {
+            return devices.supports(node, codecId, codecParams->profile, codecParams->width, codecParams->height,
+                                    bitDepth) != HardwareDeviceCache::Support::UNSUPPORTED;
+        };
+        if (renderNodeSession_ && !nodes.isPrimary(renderNodeSession_) &&
+            !supportedOn(nodes.getPath(renderNodeSession_))) {
+            releaseRenderNode();  // The compositing GPU may still decode it
+        }
+        if (!renderNodeSession_ && !supportedOn(nodes.getPrimaryPath())) {
+            LOG_INFO << codecName << " " << codecParams->width << "x" << codecParams->height << " " << bitDepth
+                     << "-bit is not decoded by " << nodes.getPrimaryPath() << ", falling back to software";
+            return false;
+        }
+
+        if (renderNodeSession_ && !nodes.isPrimary(renderNodeSession_)) {
+            std::string node = nodes.getPath(renderNodeSession_);
+            hwDeviceCtx_ = devices.acquireDevice(node, [&]() -> AVBufferRef* {
+                AVBufferRef* device = nullptr;
+                return av_hwdevice_ctx_create(&device, hwDeviceType, node.c_str(), nullptr, 0) < 0 ? nullptr : device;
+            });
+            if (!hwDeviceCtx_) {
+                LOG_WARNING << "Failed to open VAAPI device on " << node << ", using the compositing GPU";
+                releaseRenderNode();
+            } else {
+                LOG_INFO << "Decoding on render node " << node;
+                deviceKey = node;
+            }
+        }
+    }
     
 #ifdef HAVE_VAAPI_INTEROP
     // For VAAPI: use shared VADisplay from VaapiInterop for zero-copy support
     // This ensures the decoder and EGL interop use the same VAAPI display
-    if (hwDeviceType == AV_HWDEVICE_TYPE_VAAPI && vaapiInterop_ && vaapiInterop_->getVADisplay()) {
+    if (!hwDeviceCtx_ && hwDeviceType == AV_HWDEVICE_TYPE_VAAPI && vaapiInterop_ && vaapiInterop_->getVADisplay()) {
         VADisplay sharedDisplay = vaapiInterop_->getVADisplay();
-        
-        hwDeviceCtx_ = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_VAAPI);
-        if (hwDeviceCtx_) {
-            AVHWDeviceContext* hwctx = (AVHWDeviceContext*)hwDeviceCtx_->data;
+        std::string key = "vadisplay:" + std::to_string(reinterpret_cast<uintptr_t>(sharedDisplay));
+        hwDeviceCtx_ = devices.acquireDevice(key, [sharedDisplay]() -> AVBufferRef* {
+            AVBufferRef* device = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_VAAPI);
+            if (!device) {
+                return nullptr;
+            }
+            AVHWDeviceContext* hwctx = (AVHWDeviceContext*)device->data;
             AVVAAPIDeviceContext* vactx = (AVVAAPIDeviceContext*)hwctx->hwctx;
             vactx->display = sharedDisplay;
             
-            ret = av_hwdevice_ctx_init(hwDeviceCtx_);
+            int ret = av_hwdevice_ctx_init(device);
             if (ret < 0) {
                 char errbuf[AV_ERROR_MAX_STRING_SIZE];
                 av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
                 LOG_WARNING << "Failed to init shared VAAPI device: " << errbuf;
-                av_buffer_unref(&hwDeviceCtx_);
-                hwDeviceCtx_ = nullptr;
-            } else {
-                LOG_INFO << "Using shared VADisplay for VAAPI zero-copy";
+                av_buffer_unref(&device);
+                return nullptr;
             }
+            LOG_INFO << "Using shared VADisplay for VAAPI zero-copy";
+            return device;
+        });
+        if (hwDeviceCtx_) {
+            deviceKey = key;
         }
     }
 #endif
     
     // Fallback: create device context normally (creates its own display)
     if (!hwDeviceCtx_) {
-        ret = av_hwdevice_ctx_create(&hwDeviceCtx_, hwDeviceType, nullptr, nullptr, 0);
-        if (ret < 0) {
-            hwDeviceCtx_ = nullptr;
+        std::string key = std::string("default:") + av_hwdevice_get_type_name(hwDeviceType);
+        hwDeviceCtx_ = devices.acquireDevice(key, [hwDeviceType]() -> AVBufferRef* {
+            AVBufferRef* device = nullptr;
+            return av_hwdevice_ctx_create(&device, hwDeviceType, nullptr, nullptr, 0) < 0 ? nullptr : device;
+        });
+        if (!hwDeviceCtx_) {
             return false;
         }
+        deviceKey = key;
+    }
+
+    // A closed layer's warm decoder for the same stream format and device
+    // skips the decode session setup
+    decoderKey_ = DecoderContextPool::makeKey(hwCodec, codecParams, deviceKey);
+    codecCtx_ = DecoderContextPool::instance().acquire(decoderKey_);
+    if (codecCtx_) {
+        codecCtxAllocated_ = true;
+        AVStream* avStream = mediaReader_.getStream(videoStream_);
+        if (avStream) {
+            codecCtx_->pkt_timebase = avStream->time_base;
+        }
+        LOG_INFO << "Reusing warm hardware decoder: " << hwCodecName
+                 << " (" << HardwareDecoder::getName(hwDecoderType_) << ")";
+    } else if (!openHardwareContext(hwCodec, codecParams, needsHwDeviceCtx, needsHwFramesCtx, hwPixFmt,
+                                    hwCodecName)) {
+        return false;
+    }
+
+    // Allocate frames
+    frame_ = av_frame_alloc();
+    if (!frame_) {
+        avcodec_free_context(&codecCtx_);
+        codecCtx_ = nullptr;
+        av_buffer_unref(&hwDeviceCtx_);
+        hwDeviceCtx_ = nullptr;
+        return false;
+    }
+
+    hwFrame_ = av_frame_alloc();
+    if (!hwFrame_) {
+        av_frame_free(&frame_);
+        frame_ = nullptr;
+        avcodec_free_context(&codecCtx_);
+        codecCtx_ = nullptr;
+        av_buffer_unref(&hwDeviceCtx_);
+        hwDeviceCtx_ = nullptr;
+        return false;
+    }
+
+    frameFMT_ = av_frame_alloc();
+    if (!frameFMT_) {
+        av_frame_free(&frame_);
+        frame_ = nullptr;
+        av_frame_free(&hwFrame_);
+        hwFrame_ = nullptr;
+        avcodec_free_context(&codecCtx_);
+        codecCtx_ = nullptr;
+        av_buffer_unref(&hwDeviceCtx_);
+        hwDeviceCtx_ = nullptr;
+        return false;
     }
 
+    useHardwareDecoding_ = true;
+    LOG_INFO << "Using HARDWARE decoding for " << codecName;
+    return true;
+}
+
+bool VideoFileInput::openHardwareContext(const AVCodec* hwCodec, AVCodecParameters* codecParams,
+                                         bool needsHwDeviceCtx, bool needsHwFramesCtx, AVPixelFormat hwPixFmt,
+                                         const std::string& hwCodecName) {
+    AVCodecID codecId = codecParams->codec_id;
+
     // Allocate codec context for hardware decoder
     codecCtx_ = avcodec_alloc_context3(hwCodec);
     if (!codecCtx_) {
@@ -629,10 +883,10 @@ bool VideoFileInput::openHardwareCodec() {
     // But with EGL image lifecycle delays (we keep textures/EGL images alive for 1 frame),
     // we need extra surfaces to prevent pool exhaustion
     // MPV uses hwdec_extra_frames=6, we use more to account for our architecture
-    codecCtx_->extra_hw_frames = 20;  // Request 20 extra surfaces
+    codecCtx_->extra_hw_frames = EXTRA_HW_FRAMES;  // Request 20 extra surfaces
 
     // Open hardware codec
-    ret = avcodec_open2(codecCtx_, hwCodec, nullptr);
+    int ret = avcodec_open2(codecCtx_, hwCodec, nullptr);
     if (ret < 0) {
         char errbuf[AV_ERROR_MAX_STRING_SIZE];
         av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
@@ -656,43 +910,6 @@ bool VideoFileInput::openHardwareCodec() {
     
     LOG_INFO << "Successfully opened hardware decoder: " << hwCodecName 
              << " (" << HardwareDecoder::getName(hwDecoderType_) << ")";
-
-    // Allocate frames
-    frame_ = av_frame_alloc();
-    if (!frame_) {
-        avcodec_free_context(&codecCtx_);
-        codecCtx_ = nullptr;
-        av_buffer_unref(&hwDeviceCtx_);
-        hwDeviceCtx_ = nullptr;
-        return false;
-    }
-
-    hwFrame_ = av_frame_alloc();
-    if (!hwFrame_) {
-        av_frame_free(&frame_);
-        frame_ = nullptr;
-        avcodec_free_context(&codecCtx_);
-        codecCtx_ = nullptr;
-        av_buffer_unref(&hwDeviceCtx_);
-        hwDeviceCtx_ = nullptr;
-        return false;
-    }
-
-    frameFMT_ = av_frame_alloc();
-    if (!frameFMT_) {
-        av_frame_free(&frame_);
-        frame_ = nullptr;
-        av_frame_free(&hwFrame_);
-        hwFrame_ = nullptr;
-        avcodec_free_context(&codecCtx_);
-        codecCtx_ = nullptr;
-        av_buffer_unref(&hwDeviceCtx_);
-        hwDeviceCtx_ = nullptr;
-        return false;
-    }
-
-    useHardwareDecoding_ = true;
-    LOG_INFO << "Using HARDWARE decoding for " << codecName;
     return true;
 }
 
@@ -707,23 +924,20 @@ bool VideoFileInput::openCodec() {
     std::string codecName = avcodec_get_name(codecParams->codec_id);
     LOG_INFO << "Opening software decoder for codec: " << codecName;
 
-    // Open codec using VideoDecoder
-    if (!videoDecoder_.openCodec(codecParams)) {
+    // Opened here rather than through VideoDecoder: the thread count has
+    // to be set before avcodec_open2()
+    if (!openSoftwareContext(codecParams)) {
         LOG_ERROR << "Failed to open software decoder for codec: " << codecName;
         return false;
     }
-
-    // Get codec context from VideoDecoder
-    codecCtx_ = videoDecoder_.getCodecContext();
-    codecCtxAllocated_ = false;  // Managed by VideoDecoder
     
-    LOG_INFO << "Successfully opened software decoder: " << codecName;
+    LOG_INFO << "Successfully opened software decoder: " << codecName << " ("
+             << decoderThreads_.threads << (decoderThreads_.frameThreads ? " frame" : " slice") << " threads)";
 
     // Allocate frames
     frame_ = av_frame_alloc();
     if (!frame_) {
-        videoDecoder_.close();
-        codecCtx_ = nullptr;
+        avcodec_free_context(&codecCtx_);
         return false;
     }
 
@@ -731,8 +945,7 @@ bool VideoFileInput::openCodec() {
     if (!frameFMT_) {
         av_frame_free(&frame_);
         frame_ = nullptr;
-        videoDecoder_.close();
-        codecCtx_ = nullptr;
+        avcodec_free_context(&codecCtx_);
         return false;
     }
 
@@ -741,6 +954,130 @@ bool VideoFileInput::openCodec() {
     return true;
 }
 
+bool VideoFileInput::openSoftwareContext(AVCodecParameters* codecParams) {
+    const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
+    if (!codec) {
+        return false;
+    }
+
+    DecodeThreadBudget::Grant grant;
+    if (indexAbort_) {
+        // Background indexer: decodes a frame per keyframe, outside the budget
+        grant.threads = 1;
+    } else {
+        DecodeThreadBudget& threads = DecodeThreadBudget::instance();
+        if (!threadClient_) {
+            threadClient_ = threads.addClient(codecParams->width, codecParams->height, decodePriority_);
+        }
+        // Generation first: a change racing with grant() triggers another rebalance
+        threadGeneration_ = threads.getGeneration();
+        grant = threads.grant(threadClient_);
+    }
+    AVStream* avStream = mediaReader_.getStream(videoStream_);
+
+    // A closed layer's warm decoder, opened with the same thread grant
+    DecoderContextPool::Key key = DecoderContextPool::makeKey(codec, codecParams, std::string(), grant.threads,
+                                                              grant.frameThreads);
+    AVCodecContext* ctx = DecoderContextPool::instance().acquire(key);
+    if (ctx) {
+        if (avStream) {
+            ctx->pkt_timebase = avStream->time_base;
+        }
+        LOG_VERBOSE << "Reusing warm software decoder: " << codec->name;
+    } else {
+        ctx = avcodec_alloc_context3(codec);
+        if (!ctx) {
+            return false;
+        }
+        if (avcodec_parameters_to_context(ctx, codecParams) < 0) {
+            avcodec_free_context(&ctx);
+            return false;
+        }
+        ctx->thread_count = grant.threads;
+        ctx->thread_type = grant.frameThreads ? FF_THREAD_FRAME | FF_THREAD_SLICE : FF_THREAD_SLICE;
+        if (avStream) {
+            ctx->pkt_timebase = avStream->time_base;
+        }
+        if (avcodec_open2(ctx, codec, nullptr) < 0) {
+            avcodec_free_context(&ctx);
+            return false;
+        }
+    }
+    codecCtx_ = ctx;
+    codecCtxAllocated_ = true;
+    decoderThreads_ = grant;
+    decoderKey_ = key;
+    return true;
+}
+
+void VideoFileInput::rebalanceDecodeThreads() {
+    if (useHardwareDecoding_ || !threadClient_ || !codecCtx_) {
+        return;
+    }
+    DecodeThreadBudget& threads = DecodeThreadBudget::instance();
+
+    // Scrubbing, reverse playback and cue jumping seek again and again;
+    // frame threading would refill its pipeline after every one
+    auto now = std::chrono::steady_clock::now();
+    bool seekHeavy = lastSeekTime_.time_since_epoch().count() != 0 &&
+        now - lastSeekTime_ < std::chrono::milliseconds(SEEK_HEAVY_INTERVAL_MS);
+    lastSeekTime_ = now;
+    threads.setLowLatency(threadClient_, seekHeavy);
+
+    if (threads.getGeneration() == threadGeneration_) {
+        return;
+    }
+    DecodeThreadBudget::Grant grant = threads.grant(threadClient_);
+    if (grant.threads == decoderThreads_.threads && grant.frameThreads == decoderThreads_.frameThreads) {
+        threadGeneration_ = threads.getGeneration();
+        return;
+    }
+
+    // The caller flushes after the seek, so no decoder state is lost
+    AVCodecContext* previous = codecCtx_;
+    DecoderContextPool::Key previousKey = decoderKey_;
+    AVCodecParameters* codecParams = mediaReader_.getCodecParameters(videoStream_);
+    if (codecParams && openSoftwareContext(codecParams)) {
+        // Another layer of this format may get the old grant
+        DecoderContextPool::instance().release(previousKey, previous);
+        LOG_VERBOSE << "Software decoder now on " << decoderThreads_.threads
+                    << (decoderThreads_.frameThreads ? " frame" : " slice") << " threads: " << currentFile_;
+    } else {
+        codecCtx_ = previous;
+    }
+}
+
+std::unique_lock<std::recursive_mutex> VideoFileInput::lockDecodeEngine() {
+    if (!asyncDecodeQueue_) {
+        return std::unique_lock<std::recursive_mutex>();
+    }
+    bool moved = false;
+    std::unique_lock<std::recursive_mutex> lock = asyncDecodeQueue_->lockEngine(&moved);
+    if (lock.owns_lock()) {
+        if (moved) {
+            // The queue decoded on: wherever this path left the decoder is gone
+            hwLastDecodedFrame_ = -1;
+            lastDecodedPTS_ = -1;
+            lastDecodedFrameNo_ = -1;
+            currentFrame_ = -1;
+        }
+        if (codecCtx_) {
+            codecCtx_->skip_frame = AVDISCARD_DEFAULT;  // The queue sets its own per decode
+        }
+    }
+    return lock;
+}
+
+int VideoFileInput::decoderSendPacket(AVPacket* packet) {
+    // Software contexts come from openSoftwareContext(); the hardware path
+    // keeps its VideoDecoder calls
+    return useHardwareDecoding_ ? videoDecoder_.sendPacket(packet) : avcodec_send_packet(codecCtx_, packet);
+}
+
+int VideoFileInput::decoderReceiveFrame(AVFrame* frame) {
+    return useHardwareDecoding_ ? videoDecoder_.receiveFrame(frame) : avcodec_receive_frame(codecCtx_, frame);
+}
+
 // Forward declaration of FrameIndex structure (matches VideoFileInput::FrameIndex layout)
 // Note: This is a duplicate struct definition for helper functions since VideoFileInput::FrameIndex is private
 struct LocalFrameIndex {
@@ -904,6 +1241,315 @@ bool VideoFileInput::indexFrames() {
         return scanComplete_;
     }
     
+    // Another layer of this process already indexed the file
+    if (loadSharedIndex()) {
+        return true;
+    }
+    
+    // The container's own tables are cheaper to read than a cache to validate
+    if (buildIndexFromContainer()) {
+        publishSharedIndex();
+        return true;
+    }
+    
+    // Reuse a persisted index if the file hasn't changed since it was built
+    if (useIndexCache_ && loadIndexFromCache()) {
+        publishSharedIndex();
+        return true;
+    }
+    
+    if (!buildFrameIndex()) {
+        return false;
+    }
+    
+    if (useIndexCache_) {
+        saveIndexToCache();
+    }
+    publishSharedIndex();
+    return true;
+}
+
+bool VideoFileInput::loadIndexFromCache() {
+    FrameIndexCache cache(indexCacheDir_);
+    FrameIndexCache::Entry* entries = nullptr;
+    FrameIndexCache::Metadata meta;
+    if (!cache.load(currentFile_, entries, meta)) {
+        return false;
+    }
+    // Copied once from the mapped cache file; used as the index as it is
+    adoptIndex(reinterpret_cast<FrameIndex*>(entries), meta);
+    
+    LOG_INFO << "Loaded frame index from cache (" << frameCount_ << " frames): " << currentFile_;
+    return true;
+}
+
+bool VideoFileInput::loadSharedIndex() {
+    std::vector<FrameIndexCache::Entry> entries;
+    FrameIndexCache::Metadata meta;
+    if (!SharedMediaRegistry::instance().findIndex(currentFile_, entries, meta) ||
+        !adoptIndexEntries(entries, meta)) {
+        return false;
+    }
+    
+    LOG_INFO << "Using frame index shared by another layer (" << frameCount_ << " frames): " << currentFile_;
+    return true;
+}
+
+void VideoFileInput::publishSharedIndex() {
+    if (!frameIndex_ || frameCount_ <= 0) {
+        return;
+    }
+    
+    FrameIndexCache::Metadata meta;
+    meta.frameCount = frameCount_;
+    meta.totalFrames = frameInfo_.totalFrames;
+    meta.byteSeek = byteSeek_;
+    SharedMediaRegistry::instance().publishIndex(
+        currentFile_, reinterpret_cast<const FrameIndexCache::Entry*>(frameIndex_), meta);
+}
+
+bool VideoFileInput::adoptIndexEntries(const std::vector<FrameIndexCache::Entry>& entries,
+                                       const FrameIndexCache::Metadata& meta) {
+    static_assert(sizeof(FrameIndex) == sizeof(FrameIndexCache::Entry),
+                  "FrameIndex and FrameIndexCache::Entry layouts must match");
+    
+    FrameIndex* index = static_cast<FrameIndex*>(malloc(entries.size() * sizeof(FrameIndex)));
+    if (!index) {
+        return false;
+    }
+    memcpy(index, entries.data(), entries.size() * sizeof(FrameIndex));
+    adoptIndex(index, meta);
+    return true;
+}
+
+void VideoFileInput::adoptIndex(FrameIndex* index, const FrameIndexCache::Metadata& meta) {
+    if (frameIndex_) {
+        free(frameIndex_);
+    }
+    frameIndex_ = index;
+    frameCount_ = meta.frameCount;
+    byteSeek_ = meta.byteSeek;
+    if (meta.totalFrames > frameInfo_.totalFrames) {
+        frameInfo_.totalFrames = meta.totalFrames;
+    }
+    scanComplete_ = true;
+}
+
+void VideoFileInput::saveIndexToCache() {
+    if (!frameIndex_ || frameCount_ <= 0) {
+        return;
+    }
+    
+    FrameIndexCache::Metadata meta;
+    meta.frameCount = frameCount_;
+    meta.totalFrames = frameInfo_.totalFrames;
+    meta.byteSeek = byteSeek_;
+    
+    FrameIndexCache cache(indexCacheDir_);
+    cache.store(currentFile_, reinterpret_cast<const FrameIndexCache::Entry*>(frameIndex_), meta);
+}
+
+void VideoFileInput::updatePageCachePlayhead(int64_t frameNumber) {
+    // Preloaded clips are not in the page cache; without an index there is no byte position
+    if (ramClip_ || !frameIndex_ || frameNumber < 0 || frameNumber >= frameCount_) {
+        return;
+    }
+    PageCachePolicy& policy = PageCachePolicy::instance();
+    if (!pageCacheClient_) {
+        pageCacheClient_ = policy.addPlayhead(currentFile_);
+    }
+    policy.updatePlayhead(pageCacheClient_, frameIndex_[frameNumber].pkt_pos);
+}
+
+bool VideoFileInput::indexAborted() const {
+    return indexAbort_ && indexAbort_->load(std::memory_order_relaxed);
+}
+
+void VideoFileInput::publishIndexProgress(int64_t coveredFrames) {
+    if (indexProgress_) {
+        indexProgress_(frameIndex_, coveredFrames);
+    }
+}
+
+void VideoFileInput::startBackgroundIndexing() {
+    backgroundIndexStop_ = false;
+    backgroundIndexDone_ = false;
+    backgroundIndex_.store(nullptr);
+    backgroundIndexCovered_.store(0);
+    backgroundIndexThread_ = std::make_unique<std::thread>(&VideoFileInput::backgroundIndexThreadFunc, this);
+    LOG_INFO << "Background indexing started: " << currentFile_;
+}
+
+void VideoFileInput::stopBackgroundIndexing() {
+    if (!backgroundIndexThread_) {
+        return;
+    }
+    
+    backgroundIndexStop_ = true;
+    if (backgroundIndexThread_->joinable()) {
+        backgroundIndexThread_->join();
+    }
+    backgroundIndexThread_.reset();
+    
+    // Finished but never adopted
+    if (backgroundIndexDone_) {
+        free(const_cast<FrameIndex*>(backgroundIndex_.load()));
+    }
+    backgroundIndex_.store(nullptr);
+    backgroundIndexCovered_.store(0);
+    backgroundIndexDone_ = false;
+}
+
+void VideoFileInput::adoptBackgroundIndex() {
+    if (backgroundIndexThread_->joinable()) {
+        backgroundIndexThread_->join();
+    }
+    backgroundIndexThread_.reset();
+    
+    FrameIndex* index = const_cast<FrameIndex*>(backgroundIndex_.exchange(nullptr));
+    int64_t count = backgroundIndexCovered_.exchange(0);
+    backgroundIndexDone_ = false;
+    
+    if (!index || count <= 0) {
+        // Indexing failed - stay on timestamp seeking
+        noIndex_ = true;
+        return;
+    }
+    
+    if (frameIndex_) {
+        free(frameIndex_);
+    }
+    frameIndex_ = index;
+    frameCount_ = count;
+    byteSeek_ = backgroundIndexByteSeek_;
+    if (backgroundIndexTotal_ > frameInfo_.totalFrames) {
+        frameInfo_.totalFrames = backgroundIndexTotal_;
+    }
+    
+    LOG_INFO << "Background indexing complete (" << frameCount_ << " frames), using indexed seeking";
+    publishSharedIndex();
+}
+
+void VideoFileInput::backgroundIndexThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::LOADER);
+    // Keep the indexer from competing with decode/render threads
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+    
+    // Separate instance = separate demuxer and decoder, so playback on this
+    // instance never shares FFmpeg contexts with the indexer
+    VideoFileInput indexer;
+    indexer.setHardwareDecodePreference(HardwareDecodePreference::SOFTWARE_ONLY);
+    indexer.setIndexCache(useIndexCache_, indexCacheDir_);
+    indexer.setPreload(ramClip_ != nullptr);  // Shares this instance's RAM copy
+    indexer.indexAbort_ = &backgroundIndexStop_;
+    indexer.indexProgress_ = [this](const FrameIndex* index, int64_t covered) {
+        // Index array is stable once Pass 1 has finished; entries below
+        // 'covered' are never written again
+        backgroundIndex_.store(index, std::memory_order_release);
+        backgroundIndexCovered_.store(covered, std::memory_order_release);
+    };
+    
+    bool ok = indexer.open(currentFile_);
+    if (ok) {
+        // Take ownership of the finished array before the indexer goes away
+        backgroundIndexTotal_ = indexer.frameInfo_.totalFrames;
+        backgroundIndexByteSeek_ = indexer.byteSeek_;
+        backgroundIndex_.store(indexer.frameIndex_, std::memory_order_release);
+        backgroundIndexCovered_.store(indexer.frameCount_, std::memory_order_release);
+        indexer.frameIndex_ = nullptr;
+        indexer.frameCount_ = 0;
+    } else {
+        backgroundIndex_.store(nullptr);
+        backgroundIndexCovered_.store(0);
+        if (!backgroundIndexStop_) {
+            LOG_WARNING << "Background indexing failed, staying on timestamp seeking: " << currentFile_;
+        }
+    }
+    indexer.indexProgress_ = nullptr;
+    indexer.close();
+    
+    backgroundIndexDone_ = true;
+}
+
+bool VideoFileInput::buildIndexFromContainer() {
+    AVStream* avStream = mediaReader_.getStream(videoStream_);
+    if (!avStream || !formatCtx_ || !formatCtx_->iformat || !formatCtx_->iformat->name) {
+        return false;
+    }
+    
+    // Only demuxers whose index lists what is in the file: others (MPEG-TS,
+    // or MP4/MKV read without their tables) only index what was read so far
+    const char* container = formatCtx_->iformat->name;
+    const bool sampleTable = strstr(container, "mov") || strstr(container, "avi");
+    const bool cues = strstr(container, "matroska") != nullptr;
+    if (!sampleTable && !cues) {
+        return false;
+    }
+    
+    const AVRational timeBase = avStream->time_base;
+    if (cues) {
+        // Keyframes only, so frames in between are placed at a constant rate
+        if (av_cmp_q(avStream->avg_frame_rate, avStream->r_frame_rate) != 0 || frameInfo_.totalFrames <= 0) {
+            return false;
+        }
+        // Matroska reads the Cues on the first seek
+        int64_t start = avStream->start_time != AV_NOPTS_VALUE ? avStream->start_time : 0;
+        if (!mediaReader_.seek(start, videoStream_, AVSEEK_FLAG_BACKWARD)) {
+            return false;
+        }
+    }
+    
+    std::vector<ContainerIndex::Sample> samples;
+    const int count = avformat_index_get_entries_count(avStream);
+    samples.reserve(count > 0 ? count : 0);
+    for (int i = 0; i < count; ++i) {
+        const AVIndexEntry* entry = avformat_index_get_entry(avStream, i);
+        if (!entry || (entry->flags & AVINDEX_DISCARD_FRAME)) {
+            continue;
+        }
+        samples.push_back({entry->timestamp, entry->pos, (entry->flags & AVINDEX_KEYFRAME) != 0});
+    }
+    if (samples.empty()) {
+        return false;
+    }
+    
+    const AVRational frameRate = frameRateQ_;
+    auto frameTime = [frameRate, timeBase](int64_t frame) { return av_rescale_q(frame, frameRate, timeBase); };
+    std::vector<FrameIndexCache::Entry> entries;
+    bool built;
+    if (sampleTable) {
+        // A table with only keyframes or a fraction of the frames is not a sample table
+        const bool allKeys = std::all_of(samples.begin(), samples.end(),
+                                         [](const ContainerIndex::Sample& s) { return s.key; });
+        const int64_t expected = frameInfo_.totalFrames;
+        if (allKeys || (expected > 0 && static_cast<int64_t>(samples.size()) < expected * 9 / 10)) {
+            return false;
+        }
+        built = ContainerIndex::fromSamples(samples, frameTime, entries);
+    } else {
+        int64_t start = avStream->start_time != AV_NOPTS_VALUE ? avStream->start_time : 0;
+        built = ContainerIndex::fromKeyframes(samples, start, frameInfo_.totalFrames, frameTime, entries);
+    }
+    if (!built) {
+        LOG_INFO << "Container index of " << currentFile_ << " is not usable, scanning packets";
+        return false;
+    }
+    
+    FrameIndexCache::Metadata meta;
+    meta.frameCount = static_cast<int64_t>(entries.size());
+    meta.totalFrames = meta.frameCount;
+    meta.byteSeek = byteSeek_;
+    if (!adoptIndexEntries(entries, meta)) {
+        return false;
+    }
+    publishIndexProgress(frameCount_);
+    
+    LOG_INFO << "Frame index from " << (sampleTable ? "sample table" : "cues") << " (" << frameCount_
+             << " frames, " << samples.size() << " index entries): " << currentFile_;
+    return true;
+}
+
+bool VideoFileInput::buildFrameIndex() {
     // xjadeo-style 3-pass indexing implementation
 
     frameCount_ = 0;
@@ -955,6 +1601,15 @@ bool VideoFileInput::indexFrames() {
      * -> get PTS/DTS of every *packet*
      */
     while (mediaReader_.readPacket(packet) == 0) {
+        if (indexAborted()) {
+            av_packet_unref(packet);
+            av_packet_free(&packet);
+            free(frameIndex_);
+            frameIndex_ = nullptr;
+            frameCount_ = 0;
+            return false;
+        }
+        
         if (packet->stream_index != videoStream_) {
             av_packet_unref(packet);
             continue;
@@ -1043,6 +1698,7 @@ bool VideoFileInput::indexFrames() {
                 }
                 av_packet_free(&packet);
                 scanComplete_ = true;
+                publishIndexProgress(frameCount_);
                 return true;
             }
         }
@@ -1094,9 +1750,50 @@ bool VideoFileInput::indexFrames() {
         }
     }
     
+    /* Pass 3: Create Seek-Table
+     * -> assign seek-[key]frame to every frame
+     *
+     * Entry i only depends on keyframes up to i + 2 + max_keyframe_interval,
+     * so when a progress listener is attached (background indexing), the
+     * table is extended while Pass 2 is still running and the covered range
+     * is published as it grows.
+     */
+    int64_t seekTableEnd = 0;
+    auto extendSeekTable = [&](int64_t end) {
+        for (int64_t i = seekTableEnd; i < end; ++i) {
+            int64_t searchLimit = std::min(frameCount_ - 1, i + 2 + max_keyframe_interval);
+            int64_t kfi = keyframeLookupHelper(reinterpret_cast<LocalFrameIndex*>(frameIndex_), frameCount_, searchLimit, frameIndex_[i].timestamp);
+            
+            if (kfi < 0) {
+                frameIndex_[i].seekpts = 0;
+                frameIndex_[i].seekpos = 0;
+            } else {
+                frameIndex_[i].seekpts = frameIndex_[kfi].pkt_pts;
+                frameIndex_[i].seekpos = frameIndex_[kfi].frame_pos;
+            }
+        }
+        if (end > seekTableEnd) {
+            seekTableEnd = end;
+        }
+    };
+    
     for (int64_t i = 0; i < frameCount_; ++i) {
         if (!frameIndex_[i].key) continue;
         
+        if (indexAborted()) {
+            free(frameIndex_);
+            frameIndex_ = nullptr;
+            frameCount_ = 0;
+            return false;
+        }
+        
+        // Keyframes before i are verified: publish the frames whose seek
+        // window can no longer change
+        if (indexProgress_ && i - 2 - max_keyframe_interval > seekTableEnd + 250) {
+            extendSeekTable(i - 2 - max_keyframe_interval);
+            publishIndexProgress(seekTableEnd);
+        }
+        
         // Seek to keyframe
         if (!mediaReader_.seek(frameIndex_[i].pkt_pts, videoStream_, AVSEEK_FLAG_BACKWARD)) {
             LOG_WARNING << "IDX2: Seek failed for keyframe " << i;
@@ -1132,14 +1829,14 @@ bool VideoFileInput::indexFrames() {
             
             if (decodePacket->stream_index == videoStream_) {
                 // Send packet to decoder
-                err = videoDecoder_.sendPacket(decodePacket);
+                err = decoderSendPacket(decodePacket);
                 if (err < 0 && err != AVERROR(EAGAIN)) {
                     av_packet_free(&decodePacket);
                     break;
                 }
                 
                 // Receive frame from decoder
-                err = videoDecoder_.receiveFrame(frame_);
+                err = decoderReceiveFrame(frame_);
                 if (err == 0) {
                     got_pic = true;
                     pts = parsePTSFromFrame(frame_);
@@ -1166,23 +1863,9 @@ bool VideoFileInput::indexFrames() {
     
     LOG_INFO << "Pass 2 complete: verified " << keyframecount << " keyframes";
     
-    /* Pass 3: Create Seek-Table
-     * -> assign seek-[key]frame to every frame
-     */
     LOG_INFO << "Indexing video (Pass 3: Creating seek table)...";
     
-    for (int64_t i = 0; i < frameCount_; ++i) {
-        int64_t searchLimit = std::min(frameCount_ - 1, i + 2 + max_keyframe_interval);
-        int64_t kfi = keyframeLookupHelper(reinterpret_cast<LocalFrameIndex*>(frameIndex_), frameCount_, searchLimit, frameIndex_[i].timestamp);
-        
-        if (kfi < 0) {
-            frameIndex_[i].seekpts = 0;
-            frameIndex_[i].seekpos = 0;
-        } else {
-            frameIndex_[i].seekpts = frameIndex_[kfi].pkt_pts;
-            frameIndex_[i].seekpos = frameIndex_[kfi].frame_pos;
-        }
-    }
+    extendSeekTable(frameCount_);
     
     LOG_INFO << "Pass 3 complete: seek table created";
     
@@ -1192,6 +1875,7 @@ bool VideoFileInput::indexFrames() {
     }
 
     scanComplete_ = true;
+    publishIndexProgress(frameCount_);
     return true;
 }
 
@@ -1199,6 +1883,7 @@ bool VideoFileInput::seek(int64_t frameNumber) {
     if (!isReady() || !scanComplete_) {
         return false;
     }
+    auto engine = lockDecodeEngine();
 
     int64_t targetFrame = frameNumber;
     if (ignoreStartOffset_) {
@@ -1209,6 +1894,24 @@ bool VideoFileInput::seek(int64_t frameNumber) {
         return false;
     }
 
+    // Background indexing: exact seeks inside the covered range, timestamp
+    // seeks beyond it, until the finished index is adopted
+    if (backgroundIndexThread_) {
+        if (backgroundIndexDone_) {
+            adoptBackgroundIndex();
+        } else {
+            const FrameIndex* partial = backgroundIndex_.load(std::memory_order_acquire);
+            int64_t covered = backgroundIndexCovered_.load(std::memory_order_acquire);
+            if (partial && targetFrame < covered) {
+                return seekWithIndex(partial, covered, targetFrame);
+            }
+            if (frameInfo_.totalFrames > 0 && targetFrame >= frameInfo_.totalFrames) {
+                return false;
+            }
+            return seekByTimestamp(targetFrame);
+        }
+    }
+
     // If no indexing, use timestamp-based seeking
     if (noIndex_ || !frameIndex_) {
         // Check bounds using totalFrames instead of frameCount_
@@ -1226,6 +1929,151 @@ bool VideoFileInput::seek(int64_t frameNumber) {
     return seekToFrame(targetFrame);
 }
 
+int64_t VideoFileInput::getKeyframeDistance(int64_t frameNumber) const {
+    if (!frameIndex_ || frameNumber < 0 || frameNumber >= frameCount_ || backgroundIndexThread_) {
+        return -1;
+    }
+    
+    const int64_t seekpts = frameIndex_[frameNumber].seekpts;
+    for (int64_t i = frameNumber; i >= 0; --i) {
+        if (frameIndex_[i].key && frameIndex_[i].pkt_pts == seekpts) {
+            return frameNumber - i;
+        }
+    }
+    return frameNumber;  // Seek goes back to the start of the file
+}
+
+VideoFileInput::StreamProfile VideoFileInput::getStreamProfile() const {
+    StreamProfile profile;
+    if (!codecCtx_) {
+        return profile;
+    }
+    profile.codecName = avcodec_get_name(codecCtx_->codec_id);
+    if (const char* name = avcodec_profile_name(codecCtx_->codec_id, codecCtx_->profile)) {
+        profile.profileName = name;
+    }
+    profile.hardware = useHardwareDecoding_ && hwDeviceCtx_;
+    profile.peakBitrate = formatCtx_ && formatCtx_->bit_rate > 0 ? formatCtx_->bit_rate : codecCtx_->bit_rate;
+    if (isIntraFrameCodec()) {
+        profile.gopLength = 1;
+    }
+    if (!frameIndex_ || frameCount_ <= 0 || backgroundIndexThread_) {
+        return profile;
+    }
+
+    // Busiest second: file bytes between packets a second apart (index entries
+    // without a position are skipped)
+    const int64_t window = std::max<int64_t>(1, static_cast<int64_t>(frameInfo_.framerate + 0.5));
+    int64_t peakBytes = 0;
+    int64_t lastKey = -1;
+    for (int64_t i = 0; i < frameCount_; ++i) {
+        if (frameIndex_[i].key) {
+            if (lastKey >= 0) {
+                profile.gopLength = std::max(profile.gopLength, static_cast<int>(i - lastKey));
+            }
+            lastKey = i;
+        }
+        if (i + window < frameCount_ && frameIndex_[i].pkt_pos >= 0 &&
+            frameIndex_[i + window].pkt_pos > frameIndex_[i].pkt_pos) {
+            peakBytes = std::max(peakBytes, frameIndex_[i + window].pkt_pos - frameIndex_[i].pkt_pos);
+        }
+    }
+    if (lastKey >= 0) {
+        profile.gopLength = std::max(profile.gopLength, static_cast<int>(frameCount_ - lastKey));
+    }
+    if (peakBytes > 0) {
+        profile.peakBitrate = peakBytes * 8;
+    }
+    return profile;
+}
+
+void VideoFileInput::setDecodePriority(int priority) {
+    decodePriority_ = std::max(1, priority);
+    if (asyncDecodeQueue_) {
+        asyncDecodeQueue_->setPriority(decodePriority_);
+    }
+    if (threadClient_) {
+        DecodeThreadBudget::instance().setPriority(threadClient_, decodePriority_);
+    }
+}
+
+void VideoFileInput::setDecodeVisible(bool visible) {
+    decodeVisible_ = visible;
+    if (asyncDecodeQueue_) {
+        asyncDecodeQueue_->setVisible(visible);
+    }
+}
+
+void VideoFileInput::setUnderrunPolicy(UnderrunPolicy policy) {
+    underrunPolicy_ = policy;
+    if (asyncDecodeQueue_) {
+        asyncDecodeQueue_->setCatchUp(policy == UnderrunPolicy::DROP);
+    }
+}
+
+VideoFileInput::UnderrunStats VideoFileInput::getUnderrunStats() const {
+    UnderrunStats stats;
+    if (asyncDecodeQueue_) {
+        AsyncDecodeQueue::UnderrunStats queue = asyncDecodeQueue_->getUnderrunStats();
+        stats.misses = queue.misses;
+        stats.held = queue.held;
+        stats.skipped = queue.skipped;
+    }
+    stats.held += underrunHeldLast_;
+    stats.resyncs = underrunResyncs_;
+    stats.syncDecodes = underrunSyncDecodes_;
+    return stats;
+}
+
+void VideoFileInput::resetUnderrunStats() {
+    if (asyncDecodeQueue_) {
+        asyncDecodeQueue_->resetUnderrunStats();
+    }
+    underrunHeldLast_ = 0;
+    underrunResyncs_ = 0;
+    underrunSyncDecodes_ = 0;
+}
+
+void VideoFileInput::setPlaybackStep(int64_t step) {
+    using SkipMode = AsyncDecodeQueue::SkipMode;
+    SkipMode mode = step > 1 ? SkipMode::NONREF : SkipMode::NONE;
+    // Keyframes only from the threshold on, until the step falls to half of
+    // it (a step wavering around the threshold does not restart decoding)
+    if (keyframeOnlyStep_ > 0 && (step >= keyframeOnlyStep_ ||
+                                  (skipMode_ == SkipMode::KEYFRAMES && step * 2 > keyframeOnlyStep_))) {
+        mode = SkipMode::KEYFRAMES;
+    }
+    if (mode == skipMode_) {
+        return;
+    }
+    if (skipMode_ == SkipMode::KEYFRAMES) {
+        // The discarded frames are references: restart from a keyframe
+        resetSeekState();
+        currentFrame_ = -1;
+        hwLastDecodedFrame_ = -1;
+    }
+    LOG_VERBOSE << "Playback step " << step << ": "
+                << (mode == SkipMode::KEYFRAMES ? "decoding keyframes only"
+                    : mode == SkipMode::NONREF ? "skipping non-reference frames" : "decoding every frame");
+    skipMode_ = mode;
+    if (codecCtx_ && mode == SkipMode::NONE && !asyncDecodeQueue_) {
+        codecCtx_->skip_frame = AVDISCARD_DEFAULT;  // Other decode paths share the context
+    }
+    if (asyncDecodeQueue_) {
+        asyncDecodeQueue_->setSkipMode(mode);
+    }
+}
+
+void VideoFileInput::prepareSeek(int64_t frameNumber) {
+    if (useAsyncDecode_ && asyncDecodeQueue_) {
+        asyncDecodeQueue_->seek(frameNumber);
+    }
+}
+
+bool VideoFileInput::hasQueuedFrame(int64_t frameNumber) const {
+    return useAsyncDecode_ && asyncDecodeQueue_ && asyncDecodeQueue_->hasFrame(frameNumber);
+}
+
 void VideoFileInput::resetSeekState() {
     // Reset internal tracking to force next seek to actually perform the seek
     // even if seeking to the same frame number (used for MTC full frame SYSEX)
@@ -1234,11 +2082,15 @@ void VideoFileInput::resetSeekState() {
 }
 
 bool VideoFileInput::seekToFrame(int64_t frameNumber) {
-    if (frameNumber < 0 || frameNumber >= frameCount_ || !frameIndex_) {
+    return seekWithIndex(frameIndex_, frameCount_, frameNumber);
+}
+
+bool VideoFileInput::seekWithIndex(const FrameIndex* index, int64_t indexCount, int64_t frameNumber) {
+    if (frameNumber < 0 || frameNumber >= indexCount || !index) {
         return false;
     }
 
-    const FrameIndex& idx = frameIndex_[frameNumber];
+    const FrameIndex& idx = index[frameNumber];
     int64_t timestamp = idx.timestamp;
 
     if (timestamp < 0) {
@@ -1251,8 +2103,10 @@ bool VideoFileInput::seekToFrame(int64_t frameNumber) {
         needSeek = true;
     } else if (lastDecodedPTS_ > timestamp) {
         needSeek = true;
+    } else if (lastDecodedFrameNo_ >= indexCount) {
+        needSeek = true;  // Last decode was outside the (partial) index
     } else if ((frameNumber - lastDecodedFrameNo_) != 1) {
-        if (idx.seekpts != frameIndex_[lastDecodedFrameNo_].seekpts) {
+        if (idx.seekpts != index[lastDecodedFrameNo_].seekpts) {
             needSeek = true;
         }
     }
@@ -1272,6 +2126,8 @@ bool VideoFileInput::seekToFrame(int64_t frameNumber) {
             return false;
         }
 
+        rebalanceDecodeThreads();
+
         // Flush codec buffers after seek
         if (codecCtx_) {
             avcodec_flush_buffers(codecCtx_);
@@ -1297,6 +2153,8 @@ bool VideoFileInput::seekByTimestamp(int64_t frameNumber) {
         return false;
     }
 
+    rebalanceDecodeThreads();
+
     // Just flush for all codecs
     if (codecCtx_) {
         avcodec_flush_buffers(codecCtx_);
@@ -1313,6 +2171,27 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
     if (!isReady()) {
         return false;
     }
+    // Before the engine lock, which parks the queue's decode thread
+    if (useAsyncDecode_ && asyncDecodeQueue_ && !useHardwareDecoding_ && !reversePlayback_ &&
+        readQueuedFrame(frameNumber, buffer)) {
+        return true;
+    }
+    auto engine = lockDecodeEngine();
+    updatePageCachePlayhead(frameNumber);
+
+    // Fast playback: decode only what can be shown
+    AVDiscard discard = AVDISCARD_DEFAULT;
+    if (skipMode_ == AsyncDecodeQueue::SkipMode::KEYFRAMES) {
+        int64_t distance = getKeyframeDistance(frameNumber);
+        if (distance >= 0) {
+            frameNumber -= distance;  // Show the keyframe at or before the request
+            discard = AVDISCARD_NONKEY;
+        } else {
+            discard = AVDISCARD_NONREF;  // No index to find keyframes with
+        }
+    } else if (skipMode_ == AsyncDecodeQueue::SkipMode::NONREF) {
+        discard = AVDISCARD_NONREF;
+    }
 
     // QUICK WIN #1: Early return for same frame (xjadeo: if (!force_update && dispFrame == timestamp) return;)
     // If same frame is requested and we have valid decoded data, just re-run color conversion
@@ -1320,46 +2199,54 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
     if (currentFrame_ == frameNumber && frame_ && frame_->data[0]) {
         // Same frame requested - frame_ still has decoded YUV data
         // Just re-run color conversion to output buffer (much faster than re-decoding)
-        if (!swsCtx_) {
+        if (copyPlanarFrame(frame_, buffer)) {
+            // Planar output: copy the planes again, conversion happens on the GPU
+            return true;
+        } else if (!scaler_.isReady()) {
             // No color conversion context - can't reuse
         } else {
-            // Ensure output buffer is allocated
-            if (!buffer.isValid() || buffer.info().width != frameInfo_.width ||
-                buffer.info().height != frameInfo_.height) {
-                FrameInfo outputInfo;
-                outputInfo.width = frameInfo_.width;
-                outputInfo.height = frameInfo_.height;
-                outputInfo.format = PixelFormat::BGRA32;
-                buffer.allocate(outputInfo);
-            }
-            
-            // Re-run color conversion (frame_ → buffer)
-            uint8_t* dstData[1] = { buffer.data() };
-            int dstLinesize[1] = { static_cast<int>(frameInfo_.width * 4) };
-            sws_scale(swsCtx_, frame_->data, frame_->linesize, 0, 
-                      codecCtx_->height, dstData, dstLinesize);
-            return true;
+            // Re-run color conversion (frame_ → buffer), for the current window
+            return convertFrameToBuffer(frame_, buffer);
         }
     }
 
+    // Reverse playback: serve the GOP segment decoded forward, refill on a miss
+    if (reversePlayback_ && !useHardwareDecoding_) {
+        FramePool::Handle slot = reverseRing_.find(frameNumber);
+        if (slot && isPlanarYUV(slot->buffer.info().format) != producesPlanarFrames()) {
+            slot.reset();  // Planar output was toggled since the refill
+        }
+        if (!slot && fillReverseRing(frameNumber)) {
+            slot = reverseRing_.find(frameNumber);
+        }
+        if (slot) {
+            // Shared with the ring slot; the decoder stays at the end of the
+            // segment (currentFrame_)
+            buffer = slot->buffer;
+            return buffer.isValid();
+        }
+        // No frame index or refill failed: seek and decode this frame alone
+    } else if (reverseRing_.size() > 0) {
+        reverseRing_.clear();
+    }
+
     // Check frame cache first (async pre-buffered frames)
     if (!useHardwareDecoding_) {
         std::lock_guard<std::mutex> lock(cacheMutex_);
-        CachedFrame* cached = findCachedFrame(frameNumber);
-        if (cached && cached->valid) {
-            // Found in cache - copy to output buffer
-            if (!buffer.isValid() || buffer.info().width != cached->buffer.info().width ||
-                buffer.info().height != cached->buffer.info().height) {
-                buffer.allocate(cached->buffer.info());
+        FramePool::Handle cached = findCachedFrame(frameNumber);
+        if (cached) {
+            framePool_->recordHit();
+            // Found in cache - the output shares the slot's pixels (BGRA or planar YUV)
+            buffer = cached->buffer;
+            if (!buffer.isValid()) {
+                return false;
             }
-            memcpy(buffer.data(), cached->buffer.data(), 
-                   cached->buffer.info().width * cached->buffer.info().height * 4);
             currentFrame_ = frameNumber;
             
-            // Remove from cache (frame consumed)
+            // Remove from cache (frame consumed, slot returns to the pool)
             frameCache_.erase(
                 std::remove_if(frameCache_.begin(), frameCache_.end(),
-                    [frameNumber](const CachedFrame& cf) { return cf.frameNumber == frameNumber; }),
+                    [frameNumber](const FramePool::Handle& cf) { return cf->frameNumber == frameNumber; }),
                 frameCache_.end());
             
             // Start async decode for next frames
@@ -1367,6 +2254,9 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
             
             return true;
         }
+        if (decodeThreadRunning_ && framePool_) {
+            framePool_->recordMiss();
+        }
     }
 
     // Check if we need to seek (optimize for sequential frame access)
@@ -1397,6 +2287,9 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
     }
 
     // Decode frame
+    if (codecCtx_ && codecCtx_->skip_frame != discard) {
+        codecCtx_->skip_frame = discard;
+    }
     AVPacket* packet = av_packet_alloc();
     if (!packet) {
         return false;
@@ -1456,8 +2349,8 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
         if (err < 0) {
             if (err == AVERROR_EOF) {
                 // Drain remaining frames
-                videoDecoder_.sendPacket(nullptr);
-                while ((err = videoDecoder_.receiveFrame(frame_)) == 0) {
+                decoderSendPacket(nullptr);
+                while ((err = decoderReceiveFrame(frame_)) == 0) {
                     int64_t pts = parsePTSFromFrame(frame_);
                     if (pts == AV_NOPTS_VALUE) continue;
                     lastDecodedPTS_ = pts;
@@ -1503,14 +2396,14 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
         
         --maxPackets;
 
-        err = videoDecoder_.sendPacket(packet);
+        err = decoderSendPacket(packet);
         if (err < 0 && err != AVERROR(EAGAIN)) {
             --bailout;
             continue;
         }
 
         // Drain ALL available frames
-        while ((err = videoDecoder_.receiveFrame(frame_)) == 0) {
+        while ((err = decoderReceiveFrame(frame_)) == 0) {
             int64_t pts = parsePTSFromFrame(frame_);
             if (pts == AV_NOPTS_VALUE) continue;
             
@@ -1550,6 +2443,11 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
                     frameFinished = true;
                     break;
                 }
+                // The target was discarded (fast playback): show the next frame
+                if (discard != AVDISCARD_DEFAULT) {
+                    frameFinished = true;
+                    break;
+                }
             }
         }
         
@@ -1569,82 +2467,166 @@ bool VideoFileInput::readFrame(int64_t frameNumber, FrameBuffer& buffer) {
     
     av_frame_free(&bestFrame);
 
-    if (!frameFinished) {
-        // Log detailed error information for debugging format-specific issues
-        if (targetTimestamp >= 0) {
-            LOG_WARNING << "Failed to decode target frame " << frameNumber 
-                       << " (target PTS: " << targetTimestamp 
-                       << ", last decoded PTS: " << (lastDecodedPTS_ >= 0 ? std::to_string(lastDecodedPTS_) : "none")
-                       << ", bailout expired)";
+    if (!frameFinished) {
+        // Log detailed error information for debugging format-specific issues
+        if (targetTimestamp >= 0) {
+            LOG_WARNING << "Failed to decode target frame " << frameNumber 
+                       << " (target PTS: " << targetTimestamp 
+                       << ", last decoded PTS: " << (lastDecodedPTS_ >= 0 ? std::to_string(lastDecodedPTS_) : "none")
+                       << ", bailout expired)";
+        } else {
+            LOG_WARNING << "Failed to decode frame " << frameNumber 
+                       << " (no target timestamp, bailout expired)";
+        }
+        return false;
+    }
+
+    if (!convertFrameToBuffer(frame_, buffer)) {
+        return false;
+    }
+
+    int64_t pts = parsePTSFromFrame(frame_);
+    if (pts != AV_NOPTS_VALUE) {
+        lastDecodedPTS_ = pts;
+        lastDecodedFrameNo_ = frameNumber;
+    }
+
+    currentFrame_ = frameNumber;
+    
+    // Start async decode for next frames (software decoding only)
+    if (!useHardwareDecoding_) {
+        startAsyncDecode(frameNumber);
+    }
+    
+    return true;
+}
+
+bool VideoFileInput::convertFrameToBuffer(AVFrame* frame, FrameBuffer& buffer) {
+    // Planar output: copy the planes, the renderer converts to RGB
+    if (copyPlanarFrame(frame, buffer)) {
+        return true;
+    }
+
+    // Crop or panorama: convert the pixels shown only, through a reference
+    // cropped by FFmpeg (plane offsets for the pixel format)
+    FrameWindow window = convertWindow();
+    const uint8_t* const* srcData = frame->data;
+    const int* srcLinesize = frame->linesize;
+    if (!window.isWhole()) {
+        if (!windowFrame_) {
+            windowFrame_ = av_frame_alloc();
+        }
+        if (windowFrame_ && av_frame_ref(windowFrame_, frame) == 0) {
+            windowFrame_->crop_left = window.x;
+            windowFrame_->crop_top = window.y;
+            windowFrame_->crop_right = frame->width - window.x - window.width;
+            windowFrame_->crop_bottom = frame->height - window.y - window.height;
+            if (av_frame_apply_cropping(windowFrame_, AV_FRAME_CROP_UNALIGNED) == 0) {
+                srcData = windowFrame_->data;
+                srcLinesize = windowFrame_->linesize;
+            } else {
+                window = FrameWindow();
+            }
         } else {
-            LOG_WARNING << "Failed to decode frame " << frameNumber 
-                       << " (no target timestamp, bailout expired)";
+            window = FrameWindow();
         }
-        return false;
     }
 
-    // Allocate buffer if needed
-    if (!buffer.isValid() || buffer.info().width != frameInfo_.width || 
-        buffer.info().height != frameInfo_.height) {
-        if (!buffer.allocate(frameInfo_)) {
-            return false;
-        }
+    FrameInfo outputInfo = frameInfo_;
+    if (!window.isWhole()) {
+        outputInfo.width = window.width;
+        outputInfo.height = window.height;
+        outputInfo.window = window;
     }
 
-    // Convert frame format using sws_scale (YUV to RGB)
-    // Initialize sws context if needed
-    if (!swsCtx_ || swsCtxWidth_ != frameInfo_.width || swsCtxHeight_ != frameInfo_.height) {
-        if (swsCtx_) {
-            sws_freeContext(swsCtx_);
-            swsCtx_ = nullptr;
-        }
-        
-        // Convert from source format to BGRA32 for OpenGL
-        // Use SWS_BILINEAR for better real-time performance (mpv default for scaling)
-        // SWS_BICUBIC is higher quality but significantly slower for 10-bit content
-        swsCtx_ = sws_getContext(
-            codecCtx_->width, codecCtx_->height, codecCtx_->pix_fmt,
-            frameInfo_.width, frameInfo_.height, AV_PIX_FMT_BGRA,
-            SWS_BILINEAR, nullptr, nullptr, nullptr
-        );
-        if (!swsCtx_) {
-            return false;
-        }
-        swsCtxWidth_ = frameInfo_.width;
-        swsCtxHeight_ = frameInfo_.height;
-    }
+    // Allocate buffer if needed (a buffer shared with a copy gets a new block)
+    bool ok = buffer.ensureAllocated(outputInfo);
+
+    // Convert frame format using sws_scale (YUV to RGB), sliced across threads
 
     // Calculate BGRA buffer stride (BGRA32 = 4 bytes per pixel)
-    int bgraStride = frameInfo_.width * 4;
+    int bgraStride = outputInfo.width * 4;
     
     // Prepare destination frame (BGRA32, packed format - single plane)
     uint8_t* dstData[4] = {buffer.data(), nullptr, nullptr, nullptr};
     int dstLinesize[4] = {bgraStride, 0, 0, 0};
     
-    // Scale and convert YUV to RGB
-    int result = sws_scale(swsCtx_,
-              (const uint8_t* const*)frame_->data, frame_->linesize,
-              0, codecCtx_->height,
-              dstData, dstLinesize);
-    
-    if (result <= 0) {
-        return false;
-    }
+    // Convert from source format to BGRA32 for OpenGL
+    // Use SWS_BILINEAR for better real-time performance (mpv default for scaling)
+    // SWS_BICUBIC is higher quality but significantly slower for 10-bit content
+    int srcWidth = window.isWhole() ? codecCtx_->width : window.width;
+    int srcHeight = window.isWhole() ? codecCtx_->height : window.height;
+    ok = ok && scaler_.scale(srcData, srcLinesize, srcWidth, srcHeight,
+                             codecCtx_->pix_fmt, dstData, dstLinesize,
+                             outputInfo.width, outputInfo.height, AV_PIX_FMT_BGRA, SWS_BILINEAR);
+    if (windowFrame_) {
+        av_frame_unref(windowFrame_);
+    }
+    return ok;
+}
 
-    int64_t pts = parsePTSFromFrame(frame_);
-    if (pts != AV_NOPTS_VALUE) {
-        lastDecodedPTS_ = pts;
-        lastDecodedFrameNo_ = frameNumber;
+FrameWindow VideoFileInput::convertWindow() const {
+    // Source pixels are output pixels only when the conversion does not scale
+    if (sourceWindow_.isWhole() || !codecCtx_ ||
+        codecCtx_->width != frameInfo_.width || codecCtx_->height != frameInfo_.height) {
+        return FrameWindow();
+    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(codecCtx_->pix_fmt);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_PAL))) {
+        return FrameWindow();
+    }
+
+    // Rounded out to whole chroma samples, so no plane starts mid-sample
+    int alignX = 1 << desc->log2_chroma_w;
+    int alignY = 1 << desc->log2_chroma_h;
+    int x0 = std::max(0, sourceWindow_.x) / alignX * alignX;
+    int y0 = std::max(0, sourceWindow_.y) / alignY * alignY;
+    int x1 = std::min(frameInfo_.width, (sourceWindow_.x + sourceWindow_.width + alignX - 1) / alignX * alignX);
+    int y1 = std::min(frameInfo_.height, (sourceWindow_.y + sourceWindow_.height + alignY - 1) / alignY * alignY);
+    if (x1 <= x0 || y1 <= y0 || (x0 == 0 && y0 == 0 && x1 == frameInfo_.width && y1 == frameInfo_.height)) {
+        return FrameWindow();
+    }
+    FrameWindow window;
+    window.x = x0;
+    window.y = y0;
+    window.width = x1 - x0;
+    window.height = y1 - y0;
+    return window;
+}
+
+FrameInfo VideoFileInput::getOutputInfo() const {
+    FrameInfo info = frameInfo_;
+    FrameWindow window = producesPlanarFrames() ? FrameWindow() : convertWindow();
+    if (!window.isWhole()) {
+        info.width = window.width;
+        info.height = window.height;
+        info.window = window;
     }
+    return info;
+}
 
-    currentFrame_ = frameNumber;
+bool VideoFileInput::readQueuedFrame(int64_t frameNumber, FrameBuffer& buffer) {
+    asyncDecodeQueue_->setTargetFrame(frameNumber);
     
-    // Start async decode for next frames (software decoding only)
-    if (!useHardwareDecoding_) {
-        startAsyncDecode(frameNumber);
+    // Same underrun handling as the hardware queue in readFrameToTexture()
+    bool block = underrunPolicy_ == UnderrunPolicy::BLOCK;
+    if (!block && !asyncDecodeQueue_->isFrameReachable(frameNumber)) {
+        asyncDecodeQueue_->seek(frameNumber);
+        underrunResyncs_++;
     }
     
-    return true;
+    AVFrame* queuedFrame = asyncDecodeQueue_->getFrame(frameNumber, block ? 5 : 0);
+    if (queuedFrame && convertFrameToBuffer(queuedFrame, buffer)) {
+        return true;
+    }
+    if (!block && buffer.isValid()) {
+        underrunHeldLast_++;
+        FlightRecorder::instance().trigger(FlightRecorder::Trigger::DECODE_UNDERRUN, "held last frame");
+        return true;
+    }
+    underrunSyncDecodes_++;
+    FlightRecorder::instance().trigger(FlightRecorder::Trigger::DECODE_UNDERRUN, "synchronous decode");
+    return false;
 }
 
 int64_t VideoFileInput::parsePTSFromFrame(AVFrame* frame) {
@@ -1677,6 +2659,76 @@ int64_t VideoFileInput::parsePTSFromFrame(AVFrame* frame) {
     return pts;
 }
 
+bool VideoFileInput::producesPlanarFrames() const {
+    if (!planarOutput_ || !planarOutputAllowed_ || useHardwareDecoding_ || !codecCtx_) {
+        return false;
+    }
+    return codecCtx_->pix_fmt == AV_PIX_FMT_YUV420P ||
+           codecCtx_->pix_fmt == AV_PIX_FMT_YUVJ420P ||
+           codecCtx_->pix_fmt == AV_PIX_FMT_YUV420P10LE;
+}
+
+bool VideoFileInput::copyPlanarFrame(const AVFrame* frame, FrameBuffer& buffer) {
+    if (!frame || !frame->data[0] || !producesPlanarFrames()) {
+        return false;
+    }
+    // No scaling on this path: decoded size must be the output size
+    if (frame->width != frameInfo_.width || frame->height != frameInfo_.height) {
+        return false;
+    }
+    
+    AVPixelFormat avFormat = static_cast<AVPixelFormat>(frame->format);
+    FrameInfo info = frameInfo_;
+    switch (avFormat) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+            info.format = PixelFormat::YUV420P;
+            break;
+        case AV_PIX_FMT_YUV420P10LE:
+            info.format = PixelFormat::YUV420P10;
+            break;
+        default:
+            return false;
+    }
+    
+    // Colour metadata for the shader; untagged content follows the usual
+    // SD/HD convention (BT.601 below 720 lines)
+    switch (frame->colorspace) {
+        case AVCOL_SPC_BT709:
+            info.colorMatrix = ColorMatrix::BT709;
+            break;
+        case AVCOL_SPC_BT470BG:
+        case AVCOL_SPC_SMPTE170M:
+        case AVCOL_SPC_FCC:
+            info.colorMatrix = ColorMatrix::BT601;
+            break;
+        case AVCOL_SPC_BT2020_NCL:
+        case AVCOL_SPC_BT2020_CL:
+            info.colorMatrix = ColorMatrix::BT2020;
+            break;
+        default:
+            info.colorMatrix = (frame->height >= 720) ? ColorMatrix::BT709 : ColorMatrix::BT601;
+            break;
+    }
+    bool fullRange = frame->color_range == AVCOL_RANGE_JPEG || avFormat == AV_PIX_FMT_YUVJ420P;
+    info.colorRange = fullRange ? ColorRange::FULL : ColorRange::LIMITED;
+    
+    if (!buffer.ensureAllocated(info)) {
+        return false;
+    }
+    
+    // Tightly packed planes (FrameBuffer layout), one memcpy per row
+    uint8_t* dstData[4] = {nullptr, nullptr, nullptr, nullptr};
+    int dstLinesize[4] = {0, 0, 0, 0};
+    if (av_image_fill_arrays(dstData, dstLinesize, buffer.data(), avFormat,
+                             info.width, info.height, 1) < 0) {
+        return false;
+    }
+    av_image_copy(dstData, dstLinesize, const_cast<const uint8_t**>(frame->data), frame->linesize,
+                  avFormat, info.width, info.height);
+    return true;
+}
+
 FrameInfo VideoFileInput::getFrameInfo() const {
     return frameInfo_;
 }
@@ -1685,6 +2737,23 @@ int64_t VideoFileInput::getCurrentFrame() const {
     return currentFrame_;
 }
 
+bool VideoFileInput::hasAlpha() const {
+    if (!codecCtx_) {
+        return true;
+    }
+    // Hardware frames report their surface format; the decoded layout is sw_pix_fmt
+    AVPixelFormat format = codecCtx_->pix_fmt;
+    const AVPixelFormatDescriptor* desc = av_pix_fmt_desc_get(format);
+    if (desc && (desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+        format = codecCtx_->sw_pix_fmt;
+        desc = av_pix_fmt_desc_get(format);
+    }
+    if (!desc) {
+        return !useHardwareDecoding_;  // Hardware decoders output no alpha
+    }
+    return (desc->flags & AV_PIX_FMT_FLAG_ALPHA) != 0;
+}
+
 InputSource::CodecType VideoFileInput::detectCodec() const {
     if (!codecCtx_) {
         return CodecType::SOFTWARE;
@@ -1776,6 +2845,26 @@ bool VideoFileInput::readFrameToTexture(int64_t frameNumber, GPUTextureFrameBuff
         // Hardware decoding not available or not enabled
         return false;
     }
+    updatePageCachePlayhead(frameNumber);
+
+    // Reverse playback: serve the GOP segment decoded forward (the async
+    // queue only decodes ahead and would reseek for every frame)
+    if (reversePlayback_) {
+        FramePool::Handle slot = reverseRing_.find(frameNumber);
+        if (!slot && fillReverseRingHardware(frameNumber)) {
+            slot = reverseRing_.find(frameNumber);
+        }
+        if (slot) {
+#ifdef HAVE_VAAPI_INTEROP
+            ensureVaapiInterop();
+#endif
+            if (transferHardwareFrameToGPU(slot->avFrame, textureBuffer)) {
+                return true;
+            }
+        }
+    } else if (reverseRing_.size() > 0) {
+        reverseRing_.clear();
+    }
 
     // =========================================================================
     // ASYNC DECODE PATH (mpv-style)
@@ -1785,8 +2874,16 @@ bool VideoFileInput::readFrameToTexture(int64_t frameNumber, GPUTextureFrameBuff
         // Set target frame so decode thread knows where we are
         asyncDecodeQueue_->setTargetFrame(frameNumber);
         
-        // Try to get frame from queue (wait up to 5ms if not ready)
-        AVFrame* queuedFrame = asyncDecodeQueue_->getFrame(frameNumber, 5);
+        // Non-blocking policies move the queue to a jump target instead of
+        // decoding it here
+        bool block = underrunPolicy_ == UnderrunPolicy::BLOCK;
+        if (!block && !asyncDecodeQueue_->isFrameReachable(frameNumber)) {
+            asyncDecodeQueue_->seek(frameNumber);
+            underrunResyncs_++;
+        }
+        
+        // Try to get frame from queue (BLOCK waits up to 5ms if not ready)
+        AVFrame* queuedFrame = asyncDecodeQueue_->getFrame(frameNumber, block ? 5 : 0);
         
         if (queuedFrame) {
             // Got frame from queue - transfer to GPU texture
@@ -1805,7 +2902,16 @@ bool VideoFileInput::readFrameToTexture(int64_t frameNumber, GPUTextureFrameBuff
                            << asyncDecodeQueue_->getOldestFrame() << ", newest=" 
                            << asyncDecodeQueue_->getNewestFrame() << ")";
             }
+            // Keep showing the last frame (only a layer with nothing on
+            // screen yet decodes synchronously)
+            if (!block && textureBuffer.isValid()) {
+                underrunHeldLast_++;
+                FlightRecorder::instance().trigger(FlightRecorder::Trigger::DECODE_UNDERRUN, "held last frame");
+                return true;
+            }
             // Fall through to synchronous path as backup
+            underrunSyncDecodes_++;
+            FlightRecorder::instance().trigger(FlightRecorder::Trigger::DECODE_UNDERRUN, "synchronous decode");
         }
     }
     
@@ -1813,23 +2919,23 @@ bool VideoFileInput::readFrameToTexture(int64_t frameNumber, GPUTextureFrameBuff
     // SYNCHRONOUS DECODE PATH (fallback)
     // Used when async queue is not available or frame was missed
     // =========================================================================
+    auto engine = lockDecodeEngine();
 
     // Seek to frame if needed
     // Only seek if this frame is far from the last decoded position
     // For consecutive frames, just decode forward
-    static int64_t lastDecodedFrame = -1;
     
     // QUICK WIN #2: Early return for same frame (xjadeo-style)
     // If same frame is requested, GPU texture already has correct data
     // This avoids re-decoding when the caller requests the same frame multiple times
-    if (lastDecodedFrame == frameNumber && textureBuffer.isValid()) {
+    if (hwLastDecodedFrame_ == frameNumber && textureBuffer.isValid()) {
         // Same frame already decoded and texture is valid - nothing to do
         return true;
     }
     
-    bool needSeek = (lastDecodedFrame < 0 ||  // Initial state - must seek
-                     frameNumber < lastDecodedFrame ||  // Backward seek
-                     frameNumber > lastDecodedFrame + 30);  // Large forward jump
+    bool needSeek = (hwLastDecodedFrame_ < 0 ||  // Initial state - must seek
+                     frameNumber < hwLastDecodedFrame_ ||  // Backward seek
+                     frameNumber > hwLastDecodedFrame_ + 30);  // Large forward jump
     
     if (needSeek) {
         // SPECIAL CASE: Frames before first keyframe
@@ -2003,18 +3109,10 @@ bool VideoFileInput::readFrameToTexture(int64_t frameNumber, GPUTextureFrameBuff
         hwFrame_->best_effort_timestamp != AV_NOPTS_VALUE ? hwFrame_->best_effort_timestamp : hwFrame_->pts,
         timeBase, frameRateQ_
     );
-    lastDecodedFrame = decodedFrameNum;
+    hwLastDecodedFrame_ = decodedFrameNum;
 
-    // Lazy initialization of VaapiInterop (needs GL context which may not be available at open time)
 #ifdef HAVE_VAAPI_INTEROP
-    if (!vaapiInterop_ && displayBackend_ && displayBackend_->hasVaapiSupport() && 
-        hwDecoderType_ == HardwareDecoder::Type::VAAPI) {
-        vaapiInterop_ = std::make_unique<VaapiInterop>();
-        if (!vaapiInterop_->init(displayBackend_)) {
-            LOG_WARNING << "Failed to initialize per-instance VaapiInterop, falling back to CPU copy";
-            vaapiInterop_.reset();
-        }
-    }
+    ensureVaapiInterop();
 #endif
 
     // Transfer hardware frame to GPU texture
@@ -2043,7 +3141,11 @@ bool VideoFileInput::transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFram
                       hwFrame->format == AV_PIX_FMT_CUDA ||
                       hwFrame->format == AV_PIX_FMT_QSV ||
                       hwFrame->format == AV_PIX_FMT_VIDEOTOOLBOX ||
-                      hwFrame->format == AV_PIX_FMT_DXVA2_VLD);
+                      hwFrame->format == AV_PIX_FMT_DXVA2_VLD
+#ifdef VIDEOCOMPOSER_HAVE_AV_VULKAN
+                      || hwFrame->format == AV_PIX_FMT_VULKAN
+#endif
+                      );
     
     if (!isHwFrame && !hwFrame->data[0]) {
         LOG_WARNING << "transferHardwareFrameToGPU: frame has no data";
@@ -2051,6 +3153,18 @@ bool VideoFileInput::transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFram
     }
 
 #ifdef HAVE_VAAPI_INTEROP
+    // Backend without GL (Vulkan display): the surface goes over as its
+    // DMA-BUF and the backend imports it; the CPU path below needs GL
+    if (hwFrame->format == AV_PIX_FMT_VAAPI && displayBackend_ && displayBackend_->importsDmaBuf()) {
+        if (!dmaBufExporter_) {
+            dmaBufExporter_ = std::make_unique<VaapiDmaBufExporter>();
+        }
+        DmaBufPlanes planes;
+        bool highDepth = false;
+        return dmaBufExporter_->exportFrame(hwFrame, planes, highDepth) &&
+               textureBuffer.setExternalDmaBuf(planes, frameInfo_, highDepth);
+    }
+    
     // VAAPI ZERO-COPY PATH: Use shared VADisplay for direct GPU-to-GPU transfer
     // Two-phase import:
     //   Phase 1: createEGLImages - can be done from any thread
@@ -2066,11 +3180,24 @@ bool VideoFileInput::transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFram
             // If not, the caller can call bindTexturesToImages later
             if (vaapiInterop_->bindTexturesToImages(texY, texUV)) {
                 // Set up the texture buffer with the imported textures
-                if (!textureBuffer.setExternalNV12Textures(texY, texUV, frameInfo_)) {
+                if (!textureBuffer.setExternalNV12Textures(texY, texUV, frameInfo_,
+                                                           vaapiInterop_->isHighDepthFrame())) {
                     LOG_WARNING << "transferHardwareFrameToGPU: Failed to set external NV12 textures";
                     vaapiInterop_->releaseFrame();
                     // Fall through to CPU path
                 } else {
+                    if (vaapiInterop_->isDeinterlacedFrame()) {
+                        GLuint secondY = 0, secondUV = 0;
+                        vaapiInterop_->getSecondFieldTextures(secondY, secondUV);
+                        textureBuffer.setDeinterlacedFields(secondY, secondUV);
+                    }
+                    // Expose the DMA-BUF so the DRM backend can scan it out directly
+                    // (progressive only: a scanout plane cannot show single fields)
+                    DmaBufPlanes planes;
+                    if (FieldSelector::resolve(deinterlaceMode_, frameInfo_.fieldOrder) == FieldSelector::Mode::OFF &&
+                        vaapiInterop_->getCurrentDmaBufPlanes(planes)) {
+                        textureBuffer.setDmaBufPlanes(planes);
+                    }
                     return true;
                 }
             } else {
@@ -2079,6 +3206,45 @@ bool VideoFileInput::transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFram
             }
         } else {
             LOG_VERBOSE << "transferHardwareFrameToGPU: VAAPI zero-copy failed, falling back to CPU path";
+            // Decoded on another GPU whose DMA-BUF the compositing GPU cannot import
+            if (renderNodeSession_ && !renderNodeShareFailed_) {
+                renderNodeShareFailed_ = true;
+                RenderNodeManager::instance().reportShareFailure(renderNodeSession_);
+            }
+        }
+    }
+#endif
+
+#ifdef HAVE_CUDA_INTEROP
+    // NVDEC ZERO-COPY PATH: device-to-device copy into CUDA-registered GL textures
+    if (hwFrame->format == AV_PIX_FMT_CUDA) {
+        ensureCudaInterop();
+        GLuint texY = 0, texUV = 0;
+        if (cudaInterop_ && cudaInterop_->isAvailable() &&
+            cudaInterop_->importFrame(hwFrame, texY, texUV)) {
+            if (textureBuffer.setExternalNV12Textures(texY, texUV, frameInfo_)) {
+                return true;
+            }
+            LOG_WARNING << "transferHardwareFrameToGPU: Failed to set external NV12 textures";
+        } else {
+            LOG_VERBOSE << "transferHardwareFrameToGPU: CUDA zero-copy failed, falling back to CPU path";
+        }
+    }
+#endif
+
+#ifdef HAVE_VULKAN_INTEROP
+    // VULKAN ZERO-COPY PATH: VkImage exported as DMA-BUF and imported as EGL images
+    if (hwFrame->format == AV_PIX_FMT_VULKAN) {
+        ensureVulkanInterop();
+        GLuint texY = 0, texUV = 0;
+        if (vulkanInterop_ && vulkanInterop_->isAvailable() &&
+            vulkanInterop_->importFrame(hwFrame, texY, texUV)) {
+            if (textureBuffer.setExternalNV12Textures(texY, texUV, frameInfo_)) {
+                return true;
+            }
+            LOG_WARNING << "transferHardwareFrameToGPU: Failed to set external NV12 textures";
+        } else {
+            LOG_VERBOSE << "transferHardwareFrameToGPU: Vulkan zero-copy failed, falling back to CPU path";
         }
     }
 #endif
@@ -2204,26 +3370,8 @@ bool VideoFileInput::transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFram
         }
     }
 
-    // Initialize sws context if needed
-    if (!swsCtx_ || swsCtxWidth_ != sourceFrame->width || swsCtxHeight_ != sourceFrame->height ||
-        swsCtxFormat_ != srcFormat) {
-        if (swsCtx_) {
-            sws_freeContext(swsCtx_);
-            swsCtx_ = nullptr;
-        }
-        
-        // Use SWS_BILINEAR for better real-time performance
-        swsCtx_ = sws_getContext(
-            sourceFrame->width, sourceFrame->height, srcFormat,
-            frameInfo_.width, frameInfo_.height, AV_PIX_FMT_RGBA,
-            SWS_BILINEAR, nullptr, nullptr, nullptr
-        );
-        if (!swsCtx_) {
-            return false;
-        }
-        swsCtxWidth_ = sourceFrame->width;
-        swsCtxHeight_ = sourceFrame->height;
-        swsCtxFormat_ = srcFormat;
+    if (srcFormat != fallbackFormat_) {
+        fallbackFormat_ = srcFormat;
         LOG_WARNING << "transferHardwareFrameToGPU: Using sws_scale fallback for format " 
                    << av_get_pix_fmt_name(srcFormat) << " (slower path)";
     }
@@ -2237,14 +3385,12 @@ bool VideoFileInput::transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFram
     uint8_t* dstData[4] = {rgbaBuffer.data(), nullptr, nullptr, nullptr};
     int dstLinesize[4] = {rgbaStride, 0, 0, 0};
     
-    // Scale and convert to RGBA
-    int result = sws_scale(swsCtx_,
-              (const uint8_t* const*)sourceFrame->data, sourceFrame->linesize,
-              0, sourceFrame->height,
-              dstData, dstLinesize);
-    
-    if (result <= 0) {
-        LOG_WARNING << "transferHardwareFrameToGPU: sws_scale failed, result=" << result;
+    // Scale and convert to RGBA (SWS_BILINEAR for better real-time performance)
+    if (!scaler_.scale(sourceFrame->data, sourceFrame->linesize, sourceFrame->width, sourceFrame->height,
+                       srcFormat, dstData, dstLinesize,
+                       frameInfo_.width, frameInfo_.height, AV_PIX_FMT_RGBA, SWS_BILINEAR)) {
+        LOG_WARNING << "transferHardwareFrameToGPU: sws_scale failed for format "
+                    << av_get_pix_fmt_name(srcFormat);
         return false;
     }
 
@@ -2268,9 +3414,202 @@ bool VideoFileInput::hasVaapiZeroCopy() const {
     return vaapiInterop_ != nullptr && vaapiInterop_->isAvailable() &&
            hwDecoderType_ == HardwareDecoder::Type::VAAPI;
 }
+
+void VideoFileInput::ensureVaapiInterop() {
+    // Lazy initialization of VaapiInterop (needs GL context which may not be available at open time)
+    if (!vaapiInterop_ && displayBackend_ && displayBackend_->hasVaapiSupport() && 
+        hwDecoderType_ == HardwareDecoder::Type::VAAPI) {
+        vaapiInterop_ = std::make_unique<VaapiInterop>();
+        if (!vaapiInterop_->init(displayBackend_)) {
+            LOG_WARNING << "Failed to initialize per-instance VaapiInterop, falling back to CPU copy";
+            vaapiInterop_.reset();
+        } else {
+            vaapiInterop_->setDeinterlace(deinterlaceMode_, frameInfo_.fieldOrder);
+        }
+    }
+}
+#endif
+
+#ifdef HAVE_CUDA_INTEROP
+void VideoFileInput::ensureCudaInterop() {
+    // Lazy initialization (called from the GL thread); a failed init is kept so it isn't retried per frame
+    if (!cudaInterop_ && hwDecoderType_ == HardwareDecoder::Type::CUDA) {
+        cudaInterop_ = std::make_unique<CudaInterop>();
+        if (!cudaInterop_->init()) {
+            LOG_WARNING << "Failed to initialize CudaInterop, falling back to CPU copy";
+        }
+    }
+}
+#endif
+
+#ifdef HAVE_VULKAN_INTEROP
+void VideoFileInput::ensureVulkanInterop() {
+    // Lazy initialization (called from the GL thread); a failed init is kept so it isn't retried per frame
+    if (!vulkanInterop_ && displayBackend_ && hwDecoderType_ == HardwareDecoder::Type::VULKAN) {
+        vulkanInterop_ = std::make_unique<VulkanInterop>();
+        if (!vulkanInterop_->init(displayBackend_)) {
+            LOG_WARNING << "Failed to initialize VulkanInterop, falling back to CPU copy";
+        }
+    }
+}
 #endif
 
+// ============================================================================
+// Reverse playback (GOP segments decoded forward, served backward)
+// ============================================================================
+
+bool VideoFileInput::ensureReverseRing() {
+    if (reverseRing_.capacity() > 0) {
+        return true;
+    }
+    if (frameInfo_.width <= 0 || frameInfo_.height <= 0) {
+        return false;
+    }
+
+    size_t pixels = static_cast<size_t>(frameInfo_.width) * frameInfo_.height;
+    size_t bytesPerFrame;
+    size_t maxFrames = ReverseFrameRing::MAX_FRAMES;
+    if (useHardwareDecoding_) {
+        // Surfaces come from the decoder's pool: leave it enough to keep decoding
+        bytesPerFrame = pixels * 3 / 2;
+        maxFrames = EXTRA_HW_FRAMES - 4;
+    } else if (producesPlanarFrames()) {
+        bytesPerFrame = codecCtx_->pix_fmt == AV_PIX_FMT_YUV420P10LE ? pixels * 3 : pixels * 3 / 2;
+    } else {
+        bytesPerFrame = pixels * 4;
+    }
+
+    size_t capacity = FramePool::capacityForBudget(reverseCacheBudget_, bytesPerFrame,
+                                                   FramePool::MIN_FRAMES, maxFrames);
+    reverseRing_.setPool(FramePool::create(capacity, bytesPerFrame));
+    LOG_VERBOSE << "Reverse playback ring: " << capacity << " frames ("
+                << (capacity * bytesPerFrame) / (1024 * 1024) << " MB) for " << currentFile_;
+    return true;
+}
+
+bool VideoFileInput::fillReverseRing(int64_t frameNumber) {
+    // GOP start from the frame index (no index: no segment to decode)
+    int64_t distance = getKeyframeDistance(frameNumber);
+    if (distance < 0 || !ensureReverseRing()) {
+        return false;
+    }
+    ReverseFrameRing::Segment segment =
+        ReverseFrameRing::plan(frameNumber, frameNumber - distance, reverseRing_.capacity());
+
+    // Start the segment at its keyframe, keep only the frames the ring can hold
+    reverseRing_.clear();
+    resetSeekState();
+    currentFrame_ = -1;
+    for (int64_t frame = segment.decodeFrom; frame <= segment.keepTo; ++frame) {
+        FramePool::Handle slot;
+        if (frame >= segment.keepFrom) {
+            slot = reverseRing_.store(frame);
+            if (!slot) {
+                reverseRing_.clear();
+                return false;
+            }
+        }
+        if (!decodeFrameInternal(frame, slot ? &slot->buffer : nullptr)) {
+            LOG_VERBOSE << "Reverse playback: decode failed at frame " << frame;
+            reverseRing_.clear();
+            return false;
+        }
+    }
+    lastDecodedFrameNo_ = segment.keepTo;
+    return true;
+}
+
+bool VideoFileInput::fillReverseRingHardware(int64_t frameNumber) {
+    auto engine = lockDecodeEngine();
+    int64_t distance = getKeyframeDistance(frameNumber);
+    if (distance < 0 || !codecCtx_ || !hwFrame_ || !ensureReverseRing()) {
+        return false;
+    }
+    ReverseFrameRing::Segment segment =
+        ReverseFrameRing::plan(frameNumber, frameNumber - distance, reverseRing_.capacity());
+
+    reverseRing_.clear();
+    resetSeekState();
+    if (!seek(segment.decodeFrom)) {
+        return false;
+    }
+    avcodec_flush_buffers(codecCtx_);
+    hwLastDecodedFrame_ = -1;  // The synchronous path has to seek again after this
+
+    AVPacket* packet = av_packet_alloc();
+    if (!packet) {
+        return false;
+    }
+
+    // Decode forward from the keyframe; B-frame reordering needs some slack
+    AVRational timeBase = formatCtx_->streams[videoStream_]->time_base;
+    const int64_t maxPackets = segment.keepTo - segment.decodeFrom + 64;
+    int64_t packetsSent = 0;
+    bool flushed = false;
+    while (packetsSent < maxPackets) {
+        int err = avcodec_receive_frame(codecCtx_, hwFrame_);
+        if (err == 0) {
+            int64_t framePTS = hwFrame_->best_effort_timestamp != AV_NOPTS_VALUE
+                               ? hwFrame_->best_effort_timestamp
+                               : hwFrame_->pts;
+            int64_t decodedFrame = av_rescale_q(framePTS, timeBase, frameRateQ_);
+            if (decodedFrame >= segment.keepFrom && decodedFrame <= segment.keepTo) {
+                // The ring keeps the surface reference, nothing is copied
+                FramePool::Handle slot = reverseRing_.store(decodedFrame);
+                if (slot) {
+                    av_frame_move_ref(slot->avFrame, hwFrame_);
+                }
+            }
+            av_frame_unref(hwFrame_);
+            if (decodedFrame >= segment.keepTo) {
+                break;
+            }
+            continue;
+        }
+        if (err != AVERROR(EAGAIN) || flushed) {
+            break;  // Drained, or a decoder error
+        }
+
+        av_packet_unref(packet);
+        err = mediaReader_.readPacket(packet);
+        if (err == AVERROR_EOF) {
+            avcodec_send_packet(codecCtx_, nullptr);
+            flushed = true;
+            continue;
+        }
+        if (err < 0) {
+            break;
+        }
+        if (packet->stream_index != videoStream_) {
+            continue;
+        }
+        if (avcodec_send_packet(codecCtx_, packet) == 0) {
+            ++packetsSent;
+        }
+    }
+    av_packet_free(&packet);
+
+    if (!reverseRing_.find(frameNumber)) {
+        LOG_VERBOSE << "Reverse playback: hardware decode did not reach frame " << frameNumber;
+        reverseRing_.clear();
+        return false;
+    }
+    return true;
+}
+
+void VideoFileInput::releaseRenderNode() {
+    if (renderNodeSession_) {
+        RenderNodeManager::instance().release(renderNodeSession_);
+        renderNodeSession_ = 0;
+    }
+    renderNodeShareFailed_ = false;
+}
+
 void VideoFileInput::cleanup() {
+    // Drop reverse ring frames first (they may reference decoder surfaces)
+    reverseRing_.setPool(nullptr);
+    hwLastDecodedFrame_ = -1;
+
     // Free frame index
     if (frameIndex_) {
         free(frameIndex_);
@@ -2279,13 +3618,8 @@ void VideoFileInput::cleanup() {
     frameCount_ = 0;
 
     // Free software scaler
-    if (swsCtx_) {
-        sws_freeContext(swsCtx_);
-        swsCtx_ = nullptr;
-    }
-    swsCtxWidth_ = 0;
-    swsCtxHeight_ = 0;
-    swsCtxFormat_ = AV_PIX_FMT_NONE;
+    scaler_.reset();
+    fallbackFormat_ = AV_PIX_FMT_NONE;
 
     // Free hardware frames (must use av_frame_free for frames allocated with av_frame_alloc)
     if (hwFrame_) {
@@ -2298,6 +3632,9 @@ void VideoFileInput::cleanup() {
         av_frame_free(&frameFMT_);
         frameFMT_ = nullptr;
     }
+    if (windowFrame_) {
+        av_frame_free(&windowFrame_);
+    }
     if (frame_) {
         av_frame_free(&frame_);
         frame_ = nullptr;
@@ -2308,21 +3645,30 @@ void VideoFileInput::cleanup() {
         av_buffer_unref(&hwDeviceCtx_);
         hwDeviceCtx_ = nullptr;
     }
+    releaseRenderNode();
+
+    if (threadClient_) {
+        DecodeThreadBudget::instance().removeClient(threadClient_);
+        threadClient_ = 0;
+    }
 
     // Close video decoder (for software decoding)
-    if (!useHardwareDecoding_) {
+    if (!useHardwareDecoding_ && !codecCtxAllocated_) {
         videoDecoder_.close();
         codecCtx_ = nullptr;
     } else {
         // For hardware decoding, we need to manually close
     if (codecCtx_) {
-        avcodec_close(codecCtx_);
         if (codecCtxAllocated_) {
-        avcodec_free_context(&codecCtx_);
+            // Flushed and kept warm for the next load of this format (or freed)
+            DecoderContextPool::instance().release(decoderKey_, codecCtx_);
+        } else {
+            avcodec_close(codecCtx_);
         }
         codecCtx_ = nullptr;
         }
     }
+    decoderKey_ = DecoderContextPool::Key();
 
     // Close media reader (closes format context)
     mediaReader_.close();
@@ -2331,6 +3677,13 @@ void VideoFileInput::cleanup() {
 #ifdef HAVE_VAAPI_INTEROP
     // Clean up per-instance VaapiInterop
     vaapiInterop_.reset();
+    dmaBufExporter_.reset();
+#endif
+#ifdef HAVE_CUDA_INTEROP
+    cudaInterop_.reset();
+#endif
+#ifdef HAVE_VULKAN_INTEROP
+    vulkanInterop_.reset();
 #endif
 
     videoStream_ = -1;
@@ -2346,6 +3699,21 @@ void VideoFileInput::cleanup() {
 // Async Frame Pre-buffering (like mpv's decode-ahead)
 // ============================================================================
 
+void VideoFileInput::createFramePool(size_t minFrames) {
+    // Software path keeps BGRA copies; hardware path only holds surface
+    // references, but budget against the NV12 surface size they pin
+    size_t bytesPerFrame = static_cast<size_t>(frameInfo_.width) * frameInfo_.height;
+    bytesPerFrame = useHardwareDecoding_ ? bytesPerFrame * 3 / 2 : bytesPerFrame * 4;
+    
+    size_t capacity = FramePool::capacityForBudget(framePoolBudget_, bytesPerFrame,
+                                                   std::max(FramePool::MIN_FRAMES, minFrames),
+                                                   std::max(FramePool::MAX_FRAMES, minFrames));
+    framePool_ = FramePool::create(capacity, bytesPerFrame);
+    
+    LOG_VERBOSE << "Frame pool: " << capacity << " frames ("
+                << (capacity * bytesPerFrame) / (1024 * 1024) << " MB) for " << currentFile_;
+}
+
 void VideoFileInput::stopAsyncDecode() {
     if (decodeThread_) {
         decodeThreadStop_ = true;
@@ -2361,7 +3729,7 @@ void VideoFileInput::stopAsyncDecode() {
 
 void VideoFileInput::startAsyncDecode(int64_t startFrame) {
     // DISABLED: Async decode has race conditions with shared FFmpeg objects
-    // The decode thread and main thread share frame_, codecCtx_, swsCtx_, etc.
+    // The decode thread and main thread share frame_, codecCtx_, scaler_, etc.
     // without proper synchronization, causing corrupted frames.
     // 
     // TODO: SMOOTHNESS FIX #2 - Implement proper async decode like mpv
@@ -2398,16 +3766,17 @@ void VideoFileInput::startAsyncDecode(int64_t startFrame) {
 #endif
 }
 
-VideoFileInput::CachedFrame* VideoFileInput::findCachedFrame(int64_t frameNumber) {
+FramePool::Handle VideoFileInput::findCachedFrame(int64_t frameNumber) {
     for (auto& cf : frameCache_) {
-        if (cf.frameNumber == frameNumber && cf.valid) {
-            return &cf;
+        if (cf->frameNumber == frameNumber) {
+            return cf;
         }
     }
     return nullptr;
 }
 
 void VideoFileInput::decodeThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
     LOG_INFO << "Async decode thread started";
     
     while (!decodeThreadStop_) {
@@ -2418,24 +3787,27 @@ void VideoFileInput::decodeThreadFunc() {
         {
             std::lock_guard<std::mutex> lock(cacheMutex_);
             // Only decode if frame not already cached and cache not full
-            if (frameCache_.size() < FRAME_CACHE_SIZE && !findCachedFrame(targetFrame)) {
+            if (framePool_ && frameCache_.size() < framePool_->capacity() &&
+                !findCachedFrame(targetFrame)) {
                 shouldDecode = true;
             }
         }
         
-        if (shouldDecode && targetFrame >= 0 && targetFrame < frameCount_) {
-            // Decode the frame
-            CachedFrame cf;
-            cf.frameNumber = targetFrame;
-            cf.valid = false;
-            
-            if (decodeFrameInternal(targetFrame, cf.buffer)) {
-                cf.valid = true;
+        // Take a pool slot; exhausted pool means the consumer is behind
+        FramePool::Handle cf;
+        if (shouldDecode) {
+            cf = framePool_->acquire();
+        }
+        
+        if (cf && targetFrame >= 0 && targetFrame < frameCount_) {
+            // Decode the frame into the pooled buffer
+            if (decodeFrameInternal(targetFrame, &cf->buffer)) {
+                cf->frameNumber = targetFrame;
                 
                 // Add to cache
                 std::lock_guard<std::mutex> lock(cacheMutex_);
                 // Remove old frames if cache is full
-                while (frameCache_.size() >= FRAME_CACHE_SIZE) {
+                while (frameCache_.size() >= framePool_->capacity()) {
                     frameCache_.pop_front();
                 }
                 frameCache_.push_back(std::move(cf));
@@ -2458,7 +3830,7 @@ void VideoFileInput::decodeThreadFunc() {
     LOG_INFO << "Async decode thread stopped";
 }
 
-bool VideoFileInput::decodeFrameInternal(int64_t frameNumber, FrameBuffer& buffer) {
+bool VideoFileInput::decodeFrameInternal(int64_t frameNumber, FrameBuffer* buffer) {
     // This is a copy of the decoding logic from readFrame, but without cache check
     // Used by the async decode thread
     
@@ -2519,8 +3891,8 @@ bool VideoFileInput::decodeFrameInternal(int64_t frameNumber, FrameBuffer& buffe
         int err = mediaReader_.readPacket(packet);
         if (err < 0) {
             if (err == AVERROR_EOF) {
-                videoDecoder_.sendPacket(nullptr);
-                while ((err = videoDecoder_.receiveFrame(frame_)) == 0) {
+                decoderSendPacket(nullptr);
+                while ((err = decoderReceiveFrame(frame_)) == 0) {
                     int64_t pts = parsePTSFromFrame(frame_);
                     if (pts == AV_NOPTS_VALUE) continue;
                     lastDecodedPTS_ = pts;
@@ -2566,13 +3938,13 @@ bool VideoFileInput::decodeFrameInternal(int64_t frameNumber, FrameBuffer& buffe
         
         --maxPackets;
 
-        err = videoDecoder_.sendPacket(packet);
+        err = decoderSendPacket(packet);
         if (err < 0 && err != AVERROR(EAGAIN)) {
             --bailout;
             continue;
         }
 
-        while ((err = videoDecoder_.receiveFrame(frame_)) == 0) {
+        while ((err = decoderReceiveFrame(frame_)) == 0) {
             int64_t pts = parsePTSFromFrame(frame_);
             if (pts == AV_NOPTS_VALUE) continue;
             
@@ -2633,43 +4005,35 @@ bool VideoFileInput::decodeFrameInternal(int64_t frameNumber, FrameBuffer& buffe
         return false;
     }
 
-    // Allocate buffer if needed
-    if (!buffer.isValid() || buffer.info().width != frameInfo_.width || 
-        buffer.info().height != frameInfo_.height) {
-        if (!buffer.allocate(frameInfo_)) {
-            return false;
-        }
+    // Decode only: frames before the part of a reverse segment that is kept
+    if (!buffer) {
+        currentFrame_ = frameNumber;
+        return true;
     }
 
-    // Convert frame format
-    if (!swsCtx_ || swsCtxWidth_ != frameInfo_.width || swsCtxHeight_ != frameInfo_.height) {
-        if (swsCtx_) {
-            sws_freeContext(swsCtx_);
-            swsCtx_ = nullptr;
-        }
-        
-        swsCtx_ = sws_getContext(
-            codecCtx_->width, codecCtx_->height, codecCtx_->pix_fmt,
-            frameInfo_.width, frameInfo_.height, AV_PIX_FMT_BGRA,
-            SWS_BILINEAR, nullptr, nullptr, nullptr
-        );
-        if (!swsCtx_) {
+    // Planar output: copy the planes, the renderer converts to RGB
+    if (copyPlanarFrame(frame_, *buffer)) {
+        currentFrame_ = frameNumber;
+        return true;
+    }
+
+    // Allocate buffer if needed
+    if (!buffer->isValid() || buffer->info().width != frameInfo_.width || 
+        buffer->info().height != frameInfo_.height ||
+        buffer->info().format != frameInfo_.format) {
+        if (!buffer->allocate(frameInfo_)) {
             return false;
         }
-        swsCtxWidth_ = frameInfo_.width;
-        swsCtxHeight_ = frameInfo_.height;
     }
 
+    // Convert frame format
     int bgraStride = frameInfo_.width * 4;
-    uint8_t* dstData[4] = {buffer.data(), nullptr, nullptr, nullptr};
+    uint8_t* dstData[4] = {buffer->data(), nullptr, nullptr, nullptr};
     int dstLinesize[4] = {bgraStride, 0, 0, 0};
     
-    int result = sws_scale(swsCtx_,
-              (const uint8_t* const*)frame_->data, frame_->linesize,
-              0, codecCtx_->height,
-              dstData, dstLinesize);
-    
-    if (result <= 0) {
+    if (!scaler_.scale(frame_->data, frame_->linesize, codecCtx_->width, codecCtx_->height,
+                       codecCtx_->pix_fmt, dstData, dstLinesize,
+                       frameInfo_.width, frameInfo_.height, AV_PIX_FMT_BGRA, SWS_BILINEAR)) {
         return false;
     }
 
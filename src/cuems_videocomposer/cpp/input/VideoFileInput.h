@@ -4,7 +4,17 @@
 #include "InputSource.h"
 #include "HardwareDecoder.h"
 #include "AsyncDecodeQueue.h"
+#include "DecodeThreadBudget.h"
+#include "DecoderContextPool.h"
+#include "FrameIndexCache.h"
+#include "RamClipCache.h"
+#include "PageCachePolicy.h"
+#include "RenderNodeManager.h"
+#include "ReverseFrameRing.h"
 #include "../video/GPUTextureFrameBuffer.h"
+#include "../video/FramePool.h"
+#include "../video/FieldSelector.h"
+#include "../video/SliceScaler.h"
 #include <cuems_mediadecoder/MediaFileReader.h>
 #include <cuems_mediadecoder/VideoDecoder.h>
 #include <string>
@@ -15,6 +25,8 @@
 #include <condition_variable>
 #include <atomic>
 #include <deque>
+#include <functional>
+#include <chrono>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -28,8 +40,15 @@ namespace videocomposer {
 // Forward declarations
 #ifdef HAVE_VAAPI_INTEROP
 class VaapiInterop;
+class VaapiDmaBufExporter;
 class DisplayBackend;
 #endif
+#ifdef HAVE_CUDA_INTEROP
+class CudaInterop;
+#endif
+#ifdef HAVE_VULKAN_INTEROP
+class VulkanInterop;
+#endif
 
 /**
  * VideoFileInput - FFmpeg-based video file input source
@@ -47,7 +66,8 @@ public:
         AUTO,
         SOFTWARE_ONLY,
         VAAPI,
-        CUDA
+        CUDA,
+        VULKAN
     };
 
     // InputSource interface
@@ -60,6 +80,8 @@ public:
     FrameInfo getFrameInfo() const override;
     int64_t getCurrentFrame() const override;
     CodecType detectCodec() const override;
+    bool hasAlpha() const override;
+    bool hasInstantSeek() const override { return isIntraFrameCodec(); }
     bool supportsDirectGPUTexture() const override;
     DecodeBackend getOptimalBackend() const override;
 
@@ -79,8 +101,230 @@ public:
     void setNoIndex(bool noIndex) { noIndex_ = noIndex; }
     bool getNoIndex() const { return noIndex_; }
 
+    /**
+     * Configure the persistent frame index cache (applied on open)
+     * @param enabled Load/store indexes from the cache directory
+     * @param cacheDir Cache directory (empty = FrameIndexCache::defaultCacheDir())
+     */
+    void setIndexCache(bool enabled, const std::string& cacheDir = std::string()) {
+        useIndexCache_ = enabled;
+        indexCacheDir_ = cacheDir;
+    }
+    bool getIndexCacheEnabled() const { return useIndexCache_; }
+    const std::string& getIndexCacheDir() const { return indexCacheDir_; }
+
+    /**
+     * Share of the process-wide decode-ahead budget (DecodeAheadBudget)
+     * relative to other layers; 1 = default, higher = deeper queue under pressure
+     */
+    void setDecodePriority(int priority);
+    int getDecodePriority() const { return decodePriority_; }
+
+    /**
+     * Whether the layer is on screen; hidden layers decode ahead only when
+     * visible ones have enough buffered (DecodeScheduler)
+     */
+    void setDecodeVisible(bool visible);
+
+    /**
+     * What the async decode path does when a frame is not decoded in time
+     * (BLOCK = wait and decode synchronously, the previous behaviour)
+     */
+    void setUnderrunPolicy(UnderrunPolicy policy);
+    UnderrunPolicy getUnderrunPolicy() const { return underrunPolicy_; }
+
+    /**
+     * Underrun counters of the async decode path
+     */
+    struct UnderrunStats {
+        uint64_t misses = 0;       // Frame not decoded in time
+        uint64_t held = 0;         // Misses shown as the nearest earlier / last frame
+        uint64_t resyncs = 0;      // Queue repositioned instead of decoding synchronously
+        uint64_t skipped = 0;      // Frames the decoder skipped to catch up
+        uint64_t syncDecodes = 0;  // Misses decoded synchronously on the render thread
+    };
+    UnderrunStats getUnderrunStats() const;
+    void resetUnderrunStats();
+
+    /** Median decode time of the decode-ahead queue (seconds, 0 = none or not measured) */
+    double getDecodeTime() const { return asyncDecodeQueue_ ? asyncDecodeQueue_->getDecodeTime() : 0.0; }
+
+    /** Frames decoded ahead so far / frames queued now (0 without the queue) */
+    uint64_t getDecodedFrameCount() const { return asyncDecodeQueue_ ? asyncDecodeQueue_->getDecodedFrameCount() : 0; }
+    size_t getQueuedFrameCount() const { return asyncDecodeQueue_ ? asyncDecodeQueue_->getQueueSize() : 0; }
+
+    const std::string& getFilename() const { return currentFile_; }
+
+    /**
+     * Read the decode-ahead demuxer's file through ReadAheadIO (applied on open)
+     * @param windowBytes Read-ahead window
+     */
+    void setReadAhead(ReadAheadIO::Mode mode, size_t windowBytes) {
+        readAheadMode_ = mode;
+        readAheadBytes_ = windowBytes;
+    }
+
+    /**
+     * Read the whole file into RAM on open and demux from there, so playback
+     * never touches storage (RamClipCache budget permitting)
+     */
+    void setPreload(bool enabled) { preload_ = enabled; }
+    bool isPreloaded() const { return ramClip_ != nullptr; }
+
+    /**
+     * Read files of at least this average bitrate with O_DIRECT in the
+     * decode-ahead demuxer, so they do not flood the page cache (applied on open)
+     * @param bitsPerSecond Threshold (0 = never)
+     */
+    void setDirectIoBitrate(int64_t bitsPerSecond) { directIoBitrate_ = bitsPerSecond; }
+
+    /**
+     * Decode intra-only software streams (ProRes, DNxHR, MJPEG...) ahead on
+     * this many decoders in parallel (applied on open)
+     * @param decoders 0 = the layer's share of the decode threads, 1 = off
+     */
+    void setIntraDecoders(int decoders) { intraDecoders_ = decoders; }
+
+    /**
+     * Deinterlacing of interlaced streams (VAAPI video engine when the
+     * driver has it, otherwise the renderer's shader)
+     */
+    void setDeinterlace(FieldSelector::Mode mode) { deinterlaceMode_ = mode; }
+
+    /**
+     * Storage I/O statistics of the decode-ahead demuxer
+     * @return false if it does not use ReadAheadIO
+     */
+    bool getReadAheadStats(ReadAheadIO::Stats& stats) const {
+        return asyncDecodeQueue_ && asyncDecodeQueue_->getReadAheadStats(stats);
+    }
+
+    /**
+     * Get how many frames a seek to frameNumber has to decode
+     * (distance from its seek keyframe, per the frame index)
+     * @return Distance in frames, or -1 if no index is available
+     */
+    int64_t getKeyframeDistance(int64_t frameNumber) const;
+
+    /**
+     * What playing the stream costs, for load admission (LoadAdmission)
+     */
+    struct StreamProfile {
+        std::string codecName;    // FFmpeg codec name
+        std::string profileName;  // Codec profile ("" = unknown)
+        int64_t peakBitrate = 0;  // Bits over the busiest second of the index (container average without one)
+        int gopLength = 0;        // Longest keyframe interval (0 = unknown)
+        bool hardware = false;    // Decoded by the hardware decoder
+    };
+    StreamProfile getStreamProfile() const;
+
+    /**
+     * Start positioning the async decode queue at a frame without waiting
+     * (no-op without the hardware async queue)
+     */
+    void prepareSeek(int64_t frameNumber);
+
+    /**
+     * Check if the async decode queue already holds a frame
+     */
+    bool hasQueuedFrame(int64_t frameNumber) const;
+
+    /**
+     * Build the frame index on a background thread (applied on open)
+     *
+     * On a cache miss open() returns as soon as the codec is ready; seeks
+     * are exact inside the range indexed so far and fall back to timestamp
+     * seeking beyond it until the scan finishes.
+     */
+    void setBackgroundIndexing(bool enabled) { backgroundIndexing_ = enabled; }
+    bool getBackgroundIndexing() const { return backgroundIndexing_; }
+
+    /**
+     * Check if a background index scan is still running
+     */
+    bool isIndexing() const { return backgroundIndexThread_ && !backgroundIndexDone_; }
+
+    /**
+     * Abort the index scan of the next open() (which then fails) once *abort
+     * becomes true - lets a superseded async load give up early
+     */
+    void setOpenAbort(const std::atomic<bool>* abort) { indexAbort_ = abort; }
+
     void setHardwareDecodePreference(HardwareDecodePreference preference) { hwPreference_ = preference; }
 
+    /**
+     * Hand 4:2:0 software-decoded frames out as planar YUV (YUV420P or
+     * YUV420P10) instead of converting them to BGRA with swscale; the
+     * renderer converts in a shader. Other pixel formats keep the BGRA path.
+     */
+    void setPlanarOutput(bool enabled) { planarOutput_ = enabled; }
+    bool getPlanarOutput() const { return planarOutput_; }
+
+    /**
+     * Temporarily fall back to BGRA (layer needs CPU-side pixel access,
+     * e.g. crop/panorama). Set by LayerPlayback before each load.
+     */
+    void setPlanarOutputAllowed(bool allowed) { planarOutputAllowed_ = allowed; }
+
+    /**
+     * Convert only this part of the picture to BGRA (the crop or panorama
+     * window of the layer; whole = everything), rounded out to the chroma
+     * grid. Frames say the part they hold in FrameInfo::window. Set by
+     * LayerPlayback before each load.
+     */
+    void setSourceWindow(const FrameWindow& window) { sourceWindow_ = window; }
+
+    /**
+     * Geometry of the BGRA frames readFrame() produces with the window set
+     */
+    FrameInfo getOutputInfo() const;
+
+    /**
+     * Check if readFrame() currently produces planar YUV frames
+     */
+    bool producesPlanarFrames() const;
+
+    /**
+     * Set the memory budget for this input's frame pool (applied on open)
+     * @param bytes Budget in bytes (0 = minimum pool size)
+     */
+    void setFramePoolBudget(size_t bytes) { framePoolBudget_ = bytes; }
+    size_t getFramePoolBudget() const { return framePoolBudget_; }
+
+    /**
+     * Get the frame pool shared by the pre-buffer and async decode queue
+     * @return Pool, or nullptr if no file is open
+     */
+    std::shared_ptr<FramePool> getFramePool() const { return framePool_; }
+
+    /**
+     * Serve backward playback from GOP segments decoded forward into a
+     * frame ring instead of seeking back for every frame (needs the frame
+     * index). Set by LayerPlayback before each load.
+     */
+    void setReversePlayback(bool reverse) { reversePlayback_ = reverse; }
+
+    /**
+     * Frames playback advances per displayed frame (1 = normal speed). Above
+     * 1 non-reference frames are not decoded; from the keyframe-only step on
+     * only keyframes are, and a request shows the keyframe at or before it.
+     * Set by LayerPlayback before each load.
+     */
+    void setPlaybackStep(int64_t step);
+
+    /**
+     * Set the playback step from which only keyframes are decoded
+     * @param step Frames per displayed frame (0 = never)
+     */
+    void setKeyframeOnlyStep(int64_t step) { keyframeOnlyStep_ = step; }
+
+    /**
+     * Set the memory budget of the reverse playback ring
+     * @param bytes Budget in bytes (0 = minimum ring size)
+     */
+    void setReverseCacheBudget(size_t bytes) { reverseCacheBudget_ = bytes; }
+    size_t getReverseCacheBudget() const { return reverseCacheBudget_; }
+
 #ifdef HAVE_VAAPI_INTEROP
     /**
      * Set DisplayBackend for creating per-instance VAAPI interop
@@ -109,14 +353,56 @@ private:
     bool initializeFFmpeg();
     bool openCodec();
     bool openHardwareCodec();
+    bool openHardwareContext(const AVCodec* hwCodec, AVCodecParameters* codecParams, bool needsHwDeviceCtx,
+                             bool needsHwFramesCtx, AVPixelFormat hwPixFmt, const std::string& hwCodecName);
+    bool openSoftwareContext(AVCodecParameters* codecParams);
+    void rebalanceDecodeThreads();   // At seeks: reopen if the thread grant changed
+    int decoderSendPacket(AVPacket* packet);
+    int decoderReceiveFrame(AVFrame* frame);
     bool indexFrames();
+    bool buildIndexFromContainer();  // MP4/MOV/AVI sample tables, Matroska Cues
+    bool buildFrameIndex();          // Full 3-pass scan (cache miss)
+    bool loadIndexFromCache();
+    void saveIndexToCache();
+    bool loadSharedIndex();          // Index published by another instance (SharedMediaRegistry)
+    void publishSharedIndex();
+    bool adoptIndexEntries(const std::vector<FrameIndexCache::Entry>& entries,
+                           const FrameIndexCache::Metadata& meta);
+    void adoptIndex(FrameIndex* index, const FrameIndexCache::Metadata& meta);  // Takes the malloc'd array
     bool isIntraFrameCodec() const;  // Check if codec is intra-frame only (all keyframes)
     void setupDirectSeekMode();      // Setup direct seek mode for intra-frame codecs
     bool seekToFrame(int64_t frameNumber);
+    bool seekWithIndex(const FrameIndex* index, int64_t indexCount, int64_t frameNumber);
+    bool indexAborted() const;
+    void updatePageCachePlayhead(int64_t frameNumber);  // PageCachePolicy drops behind it
+    void publishIndexProgress(int64_t coveredFrames);
+    void startBackgroundIndexing();
+    void stopBackgroundIndexing();
+    void adoptBackgroundIndex();
+    void backgroundIndexThreadFunc();
     bool seekByTimestamp(int64_t frameNumber);
     int64_t parsePTSFromFrame(AVFrame* frame);
     bool transferHardwareFrameToGPU(AVFrame* hwFrame, GPUTextureFrameBuffer& textureBuffer);
+    bool copyPlanarFrame(const AVFrame* frame, FrameBuffer& buffer);
+    FrameWindow convertWindow() const;
+    bool convertFrameToBuffer(AVFrame* frame, FrameBuffer& buffer);  // Planar copy or BGRA
+    bool readQueuedFrame(int64_t frameNumber, FrameBuffer& buffer);  // Parallel intra decode-ahead
+    bool ensureReverseRing();
+    bool fillReverseRing(int64_t frameNumber);
+    bool fillReverseRingHardware(int64_t frameNumber);
+    // Own decoding on the demuxer/decoder the async queue is attached to
+    std::unique_lock<std::recursive_mutex> lockDecodeEngine();
+#ifdef HAVE_VAAPI_INTEROP
+    void ensureVaapiInterop();
+#endif
+#ifdef HAVE_CUDA_INTEROP
+    void ensureCudaInterop();
+#endif
+#ifdef HAVE_VULKAN_INTEROP
+    void ensureVulkanInterop();
+#endif
     void cleanup();
+    void releaseRenderNode();
 
     // Media decoder module
     cuems_mediadecoder::MediaFileReader mediaReader_;
@@ -127,24 +413,49 @@ private:
     AVCodecContext* codecCtx_;   // Access via videoDecoder_.getCodecContext()
     AVFrame* frame_;
     AVFrame* frameFMT_;
-    SwsContext* swsCtx_;
-    int swsCtxWidth_;
-    int swsCtxHeight_;
-    AVPixelFormat swsCtxFormat_;   // Track source format for sws context recreation
+    SliceScaler scaler_;          // CPU conversion to BGRA/RGBA, sliced across threads
+    AVPixelFormat fallbackFormat_ = AV_PIX_FMT_NONE;   // Logged once per format
     int videoStream_;
 
     // Hardware decoding
     AVBufferRef* hwDeviceCtx_;        // Hardware device context
+    RenderNodeManager::SessionId renderNodeSession_;  // Render node the VAAPI decoder runs on (0 = default)
+    bool renderNodeShareFailed_;      // Its frames could not be imported by the compositing GPU
     AVFrame* hwFrame_;                // Hardware frame (for hardware decoding)
     HardwareDecoder::Type hwDecoderType_;  // Type of hardware decoder in use
     bool useHardwareDecoding_;        // Whether hardware decoding is enabled
     bool codecCtxAllocated_;          // Whether codecCtx_ was allocated separately (hardware) or is part of stream (software)
+    DecoderContextPool::Key decoderKey_;  // Format codecCtx_ goes back to the DecoderContextPool with
     HardwareDecodePreference hwPreference_;
+    int64_t hwLastDecodedFrame_;      // Decoder position of the synchronous hardware path
+    static constexpr int EXTRA_HW_FRAMES = 20;  // Surfaces requested beyond the decoder's own
+    
+    // Planar YUV output for software decode (GPU colour conversion)
+    bool planarOutput_;
+    std::atomic<bool> planarOutputAllowed_{true};  // Read by the async decode thread
+
+    // Part of the picture converted to BGRA (crop-aware conversion)
+    FrameWindow sourceWindow_;
+    AVFrame* windowFrame_;            // Reference to the decoded frame, cropped to the window
+
+    // Reverse playback: GOP segments decoded forward, served backward
+    bool reversePlayback_;
+    size_t reverseCacheBudget_;
+    int64_t keyframeOnlyStep_;
+    AsyncDecodeQueue::SkipMode skipMode_;  // Fast playback (setPlaybackStep)
+    ReverseFrameRing reverseRing_;
     
 #ifdef HAVE_VAAPI_INTEROP
     std::unique_ptr<VaapiInterop> vaapiInterop_;  // VAAPI zero-copy interop (owned per-instance)
+    std::unique_ptr<VaapiDmaBufExporter> dmaBufExporter_;  // Surfaces as DMA-BUFs, for backends without GL
     DisplayBackend* displayBackend_;  // DisplayBackend for initializing interop (not owned)
 #endif
+#ifdef HAVE_CUDA_INTEROP
+    std::unique_ptr<CudaInterop> cudaInterop_;  // NVDEC zero-copy interop (owned per-instance)
+#endif
+#ifdef HAVE_VULKAN_INTEROP
+    std::unique_ptr<VulkanInterop> vulkanInterop_;  // Vulkan Video zero-copy interop (owned per-instance)
+#endif
 
     // Frame indexing
     FrameIndex* frameIndex_;
@@ -154,6 +465,43 @@ private:
     bool scanComplete_;
     bool byteSeek_;
     bool noIndex_;
+    bool useIndexCache_;
+    int decodePriority_;
+    bool decodeVisible_;
+    // Software decoder threads (global budget, see DecodeThreadBudget)
+    DecodeThreadBudget::ClientId threadClient_ = 0;
+    DecodeThreadBudget::Grant decoderThreads_;
+    uint64_t threadGeneration_ = 0;
+    std::chrono::steady_clock::time_point lastSeekTime_;
+    static constexpr int SEEK_HEAVY_INTERVAL_MS = 1000;  // Seeks closer than this: slice threading
+    UnderrunPolicy underrunPolicy_;
+    ReadAheadIO::Mode readAheadMode_;
+    size_t readAheadBytes_;
+    bool preload_;
+    std::shared_ptr<const RamClip> ramClip_;  // RAM copy demuxed instead of the file
+    int64_t directIoBitrate_;
+    int intraDecoders_;
+    FieldSelector::Mode deinterlaceMode_;
+    PageCachePolicy::ClientId pageCacheClient_;  // Registered on the first frame played
+    std::atomic<uint64_t> underrunHeldLast_{0};
+    std::atomic<uint64_t> underrunResyncs_{0};
+    std::atomic<uint64_t> underrunSyncDecodes_{0};
+    std::string indexCacheDir_;
+
+    // Background indexing: a private VideoFileInput (own demuxer/decoder)
+    // scans the file and publishes the prefix of entries that is final
+    bool backgroundIndexing_;
+    std::unique_ptr<std::thread> backgroundIndexThread_;
+    std::atomic<bool> backgroundIndexStop_{false};
+    std::atomic<bool> backgroundIndexDone_{false};
+    std::atomic<const FrameIndex*> backgroundIndex_{nullptr};
+    std::atomic<int64_t> backgroundIndexCovered_{0};
+    int64_t backgroundIndexTotal_;
+    bool backgroundIndexByteSeek_;
+
+    // Hooks set on the background indexer instance (indexAbort_ also by setOpenAbort)
+    const std::atomic<bool>* indexAbort_;
+    std::function<void(const FrameIndex*, int64_t)> indexProgress_;
 
     // Video properties
     FrameInfo frameInfo_;
@@ -165,15 +513,14 @@ private:
     bool ready_;
     AVRational frameRateQ_;
     
-    // Async frame pre-buffering (like mpv's decode-ahead)
-    struct CachedFrame {
-        int64_t frameNumber;
-        FrameBuffer buffer;
-        bool valid;
-    };
+    // Frame pool shared by the pre-buffer and the async decode queue,
+    // sized from framePoolBudget_ when a file is opened
+    std::shared_ptr<FramePool> framePool_;
+    size_t framePoolBudget_;
+    void createFramePool(size_t minFrames = 0);
     
-    static constexpr size_t FRAME_CACHE_SIZE = 4;  // Pre-buffer up to 4 frames
-    std::deque<CachedFrame> frameCache_;
+    // Async frame pre-buffering (like mpv's decode-ahead), bounded by framePool_
+    std::deque<FramePool::Handle> frameCache_;
     std::mutex cacheMutex_;
     
     // Async decode thread
@@ -184,10 +531,10 @@ private:
     std::atomic<bool> decodeThreadStop_{false};
     
     void decodeThreadFunc();
-    bool decodeFrameInternal(int64_t frameNumber, FrameBuffer& buffer);
+    bool decodeFrameInternal(int64_t frameNumber, FrameBuffer* buffer);  // nullptr: decode only
     void startAsyncDecode(int64_t startFrame);
     void stopAsyncDecode();
-    CachedFrame* findCachedFrame(int64_t frameNumber);
+    FramePool::Handle findCachedFrame(int64_t frameNumber);
     
     // NEW: Async decode queue for smooth hardware decoding
     // This provides mpv-style pre-buffering to decouple decode latency from display timing
@@ -0,0 +1,165 @@
+#include "DecodeGovernor.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+namespace videocomposer {
+
+DecodeGovernor::DecodeGovernor()
+    : windowMisses_(0)
+    , lastLate_(0)
+    , windowStart_(-1.0)
+    , windowOverloaded_(false)
+    , missRate_(0.0)
+    , lateRate_(0.0)
+    , overloadUntil_(-1.0)
+    , lastStep_(-1e9)
+{
+}
+
+const char* DecodeGovernor::levelName(Level level) {
+    switch (level) {
+        case Level::PROXY: return "proxy";
+        case Level::HALF_RATE: return "half_rate";
+        default: return "full";
+    }
+}
+
+DecodeGovernor::Level DecodeGovernor::getLevel(const std::string& cueId) const {
+    auto it = levels_.find(cueId);
+    return it != levels_.end() ? it->second : Level::FULL;
+}
+
+std::vector<DecodeGovernor::Decision> DecodeGovernor::update(const std::vector<LayerSample>& layers,
+                                                             uint64_t lateFrames, double now) {
+    std::vector<Decision> decisions;
+
+    // Layers that are gone, critical now, or a disabled governor: no degradation
+    std::set<std::string> degradable;
+    for (const LayerSample& layer : layers) {
+        if (settings_.enabled && !layer.critical) {
+            degradable.insert(layer.cueId);
+        }
+    }
+    for (auto it = steps_.begin(); it != steps_.end();) {
+        it = degradable.count(it->cueId) ? std::next(it) : steps_.erase(it);
+    }
+    for (auto it = levels_.begin(); it != levels_.end();) {
+        if (degradable.count(it->first)) {
+            ++it;
+            continue;
+        }
+        bool present = std::any_of(layers.begin(), layers.end(),
+                                   [&it](const LayerSample& layer) { return layer.cueId == it->first; });
+        if (present) {
+            decisions.push_back({it->first, Level::FULL, settings_.enabled ? "critical" : "governor off"});
+        }
+        it = levels_.erase(it);
+    }
+    if (!settings_.enabled) {
+        return decisions;
+    }
+
+    // Load: misses of every layer (counters restart with each file) and late
+    // output frames, as rates over windows of at least a second
+    std::map<std::string, uint64_t> misses;
+    for (const LayerSample& layer : layers) {
+        auto last = layerMisses_.find(layer.cueId);
+        uint64_t previous = last != layerMisses_.end() ? last->second : 0;
+        windowMisses_ += layer.misses >= previous ? layer.misses - previous : layer.misses;
+        misses[layer.cueId] = layer.misses;
+    }
+    layerMisses_.swap(misses);
+    if (windowStart_ < 0.0 || lateFrames < lastLate_) {
+        windowStart_ = now;
+        windowMisses_ = 0;
+        lastLate_ = lateFrames;
+    } else if (now - windowStart_ >= 1.0) {
+        double seconds = now - windowStart_;
+        missRate_ = static_cast<double>(windowMisses_) / seconds;
+        lateRate_ = static_cast<double>(lateFrames - lastLate_) / seconds;
+        bool decodeOver = settings_.missesPerSecond > 0.0 && missRate_ >= settings_.missesPerSecond;
+        bool renderOver = settings_.lateFramesPerSecond > 0.0 && lateRate_ >= settings_.lateFramesPerSecond;
+        windowOverloaded_ = decodeOver || renderOver;
+        if (windowOverloaded_) {
+            std::ostringstream reason;
+            reason << (decodeOver ? "decode misses " : "late frames ")
+                   << (decodeOver ? missRate_ : lateRate_) << "/s";
+            overloadReason_ = reason.str();
+            overloadUntil_ = now + settings_.holdSeconds;
+        }
+        windowStart_ = now;
+        windowMisses_ = 0;
+        lastLate_ = lateFrames;
+    }
+
+    if (now - lastStep_ < settings_.stepSeconds) {
+        return decisions;
+    }
+    if (windowOverloaded_) {
+        if (degradeOne(layers, decisions)) {
+            lastStep_ = now;
+        }
+        windowOverloaded_ = false;  // Judge the next window with this step applied
+    } else if (!isOverloaded(now) && !steps_.empty()) {
+        // Undo the last step
+        Step step = steps_.back();
+        steps_.pop_back();
+        if (step.previous == Level::FULL) {
+            levels_.erase(step.cueId);
+        } else {
+            levels_[step.cueId] = step.previous;
+        }
+        decisions.push_back({step.cueId, step.previous, "load cleared"});
+        lastStep_ = now;
+    }
+    return decisions;
+}
+
+bool DecodeGovernor::degradeOne(const std::vector<LayerSample>& layers, std::vector<Decision>& decisions) {
+    // Least important first; within a priority the most expensive decode
+    std::vector<const LayerSample*> order;
+    for (const LayerSample& layer : layers) {
+        if (!layer.critical) {
+            order.push_back(&layer);
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const LayerSample* a, const LayerSample* b) {
+        if (a->priority != b->priority) {
+            return a->priority < b->priority;
+        }
+        if (a->decodeTime != b->decodeTime) {
+            return a->decodeTime > b->decodeTime;
+        }
+        return a->cueId < b->cueId;
+    });
+
+    // Proxies for every layer that has one, before any layer loses frames
+    const LayerSample* target = nullptr;
+    Level level = Level::PROXY;
+    for (const LayerSample* layer : order) {
+        if (layer->hasProxy && getLevel(layer->cueId) == Level::FULL) {
+            target = layer;
+            break;
+        }
+    }
+    if (!target) {
+        level = Level::HALF_RATE;
+        for (const LayerSample* layer : order) {
+            if (getLevel(layer->cueId) != Level::HALF_RATE) {
+                target = layer;
+                break;
+            }
+        }
+    }
+    if (!target) {
+        return false;  // Nothing left to give
+    }
+    steps_.push_back({target->cueId, getLevel(target->cueId)});
+    levels_[target->cueId] = level;
+    decisions.push_back({target->cueId, level, overloadReason_});
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,107 @@
+#ifndef VIDEOCOMPOSER_DECODEGOVERNOR_H
+#define VIDEOCOMPOSER_DECODEGOVERNOR_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * DecodeGovernor - Degrades layers in priority order when the composer is overloaded
+ *
+ * Overload is decode underrun misses across all layers, or output frames
+ * that missed their vsync, above a rate per second. While overloaded the
+ * governor takes one degradation step per stepSeconds:
+ * - first lower-priority layers play their proxy (ProxyMedia), lowest
+ *   decode priority first and the most expensive decode within a priority
+ * - then layers load every other frame (half rate), in the same order
+ * Layers marked critical are never degraded. Once the load has stayed
+ * below the thresholds for holdSeconds, steps are undone one per
+ * stepSeconds, the last one first.
+ *
+ * The governor only decides; the caller applies the levels it returns.
+ */
+class DecodeGovernor {
+public:
+    enum class Level {
+        FULL,       // Not degraded
+        PROXY,      // Plays its reduced-resolution proxy
+        HALF_RATE   // Loads every other frame (and plays its proxy, if any)
+    };
+
+    struct Settings {
+        bool enabled = true;
+        double missesPerSecond = 2.0;      // Decode misses (all layers) that count as overload
+        double lateFramesPerSecond = 2.0;  // Output frames past their vsync that count as overload
+        double stepSeconds = 1.0;          // Between degradation (or recovery) steps
+        double holdSeconds = 10.0;         // Load-free time before degradation is undone
+    };
+
+    /** One layer as seen by an update */
+    struct LayerSample {
+        std::string cueId;
+        int priority = 1;          // Decode priority (higher = more important)
+        bool critical = false;     // Never degraded
+        bool hasProxy = false;     // PROXY is possible
+        double decodeTime = 0.0;   // Seconds per frame
+        uint64_t misses = 0;       // Underrun misses so far
+    };
+
+    /** A level change (or a step's reason) to apply and report */
+    struct Decision {
+        std::string cueId;
+        Level level = Level::FULL;
+        std::string reason;
+    };
+
+    DecodeGovernor();
+
+    void configure(const Settings& settings) { settings_ = settings; }
+    const Settings& getSettings() const { return settings_; }
+
+    /**
+     * @param layers Every layer playing a file
+     * @param lateFrames Output frames that missed their vsync so far
+     * @param now Seconds on a monotonic clock
+     * @return Level changes since the last update
+     */
+    std::vector<Decision> update(const std::vector<LayerSample>& layers, uint64_t lateFrames, double now);
+
+    Level getLevel(const std::string& cueId) const;
+    bool isOverloaded(double now) const { return now < overloadUntil_; }
+    size_t getStepCount() const { return steps_.size(); }
+
+    /** Load measured over the last window (per second) */
+    double getMissRate() const { return missRate_; }
+    double getLateFrameRate() const { return lateRate_; }
+
+    static const char* levelName(Level level);
+
+private:
+    struct Step {
+        std::string cueId;
+        Level previous;
+    };
+
+    bool degradeOne(const std::vector<LayerSample>& layers, std::vector<Decision>& decisions);
+
+    Settings settings_;
+    std::map<std::string, Level> levels_;  // Degraded layers only
+    std::vector<Step> steps_;              // Applied steps, oldest first
+    std::map<std::string, uint64_t> layerMisses_;  // Miss counters at the last update
+    uint64_t windowMisses_;
+    uint64_t lastLate_;
+    double windowStart_;
+    bool windowOverloaded_;  // The last full window was over a threshold
+    double missRate_;
+    double lateRate_;
+    double overloadUntil_;
+    double lastStep_;
+    std::string overloadReason_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECODEGOVERNOR_H
@@ -7,7 +7,8 @@
 namespace videocomposer {
 
 LayerDisplay::LayerDisplay()
-    : preparedFrameOnGPU_(false)
+    : properties_(&ownProperties_)
+    , preparedFrameOnGPU_(false)
     , frameReady_(false)
     , sourceFrameCpu_(nullptr)
     , sourceFrameGpu_(nullptr)
@@ -17,6 +18,14 @@ LayerDisplay::LayerDisplay()
 LayerDisplay::~LayerDisplay() {
 }
 
+void LayerDisplay::bindProperties(LayerProperties* storage) {
+    LayerProperties* target = storage ? storage : &ownProperties_;
+    if (target != properties_) {
+        *target = *properties_;
+        properties_ = target;
+    }
+}
+
 bool LayerDisplay::prepareFrame(const FrameBuffer* cpuFrame, const GPUTextureFrameBuffer* gpuFrame, 
                                 bool isFrameOnGPU, bool isHAPCodec) {
     frameReady_ = false;
@@ -24,7 +33,10 @@ bool LayerDisplay::prepareFrame(const FrameBuffer* cpuFrame, const GPUTextureFra
     sourceFrameGpu_ = nullptr;
 
     // Check if we can skip modifications (no crop/panorama)
-    if (canSkipModifications(isHAPCodec)) {
+    // YUV frames pass through as well: the CPU processor works on RGB
+    // pixels, and playback switches back to BGRA on the next frame
+    bool planarCpuFrame = !isFrameOnGPU && cpuFrame && isShaderYUV(cpuFrame->info().format);
+    if (planarCpuFrame || canSkipModifications(isHAPCodec)) {
         // No modifications needed - store pointer to source frame (zero-copy)
         if (isFrameOnGPU && gpuFrame && gpuFrame->isValid()) {
             sourceFrameGpu_ = gpuFrame;
@@ -41,6 +53,16 @@ bool LayerDisplay::prepareFrame(const FrameBuffer* cpuFrame, const GPUTextureFra
         return false;
     }
 
+    // The decoder converted just the part shown: nothing left to cut out
+    FrameWindow shown;
+    if (!isFrameOnGPU && cpuFrame && cpuFrame->isValid() && !cpuFrame->info().window.isWhole() &&
+        CPUImageProcessor::shownWindow(*properties_, frameInfo_, shown) && shown == cpuFrame->info().window) {
+        sourceFrameCpu_ = cpuFrame;
+        preparedFrameOnGPU_ = false;
+        frameReady_ = true;
+        return true;
+    }
+
     // Apply modifications (crop/panorama only - scale/rotation handled by OpenGL)
     // This path requires actual pixel manipulation, so we need our own buffer
     
@@ -97,13 +119,13 @@ bool LayerDisplay::applyModificationsGPU(const GPUTextureFrameBuffer& input, GPU
     // For HAP textures, most operations are done via texture coordinates (zero-copy)
     // For other GPU textures, shader-based processing can be added later
     
-    if (!gpuProcessor_.canProcess(properties_, input.isHAPTexture())) {
+    if (!gpuProcessor_.canProcess(*properties_, input.isHAPTexture())) {
         // GPU processor cannot handle this - just copy
         output = input;
         return true;
     }
     
-    return gpuProcessor_.processGPU(input, output, properties_, frameInfo_);
+    return gpuProcessor_.processGPU(input, output, *properties_, frameInfo_);
 }
 
 bool LayerDisplay::applyModificationsCPU(const FrameBuffer& input, FrameBuffer& output) {
@@ -114,19 +136,13 @@ bool LayerDisplay::applyModificationsCPU(const FrameBuffer& input, FrameBuffer&
         return false;
     }
     
-    if (!cpuProcessor_.canProcess(properties_, false)) {
-        // CPU processor cannot handle this - just copy
-        if (!output.isValid() || output.info().width != input.info().width || 
-            output.info().height != input.info().height) {
-            if (!output.allocate(input.info())) {
-                return false;
-            }
-        }
-        memcpy(output.data(), input.data(), input.size());
-        return true;
+    if (!cpuProcessor_.canProcess(*properties_, false)) {
+        // CPU processor cannot handle this - share the input's pixels
+        output = input;
+        return output.isValid();
     }
     
-    return cpuProcessor_.processCPU(input, output, properties_, frameInfo_);
+    return cpuProcessor_.processCPU(input, output, *properties_, frameInfo_);
 }
 
 bool LayerDisplay::canSkipModifications(bool isHAPCodec) const {
@@ -134,14 +150,14 @@ bool LayerDisplay::canSkipModifications(bool isHAPCodec) const {
     // This delegates to the appropriate processor (GPU or CPU)
     if (isHAPCodec) {
         // For HAP, use GPU processor's skip logic
-        return gpuProcessor_.canSkip(properties_, true);
+        return gpuProcessor_.canSkip(*properties_, true);
     } else {
         // For other codecs, check both processors
         // If GPU can skip, we can skip; otherwise check CPU
-        if (gpuProcessor_.canSkip(properties_, false)) {
+        if (gpuProcessor_.canSkip(*properties_, false)) {
             return true;
         }
-        return cpuProcessor_.canSkip(properties_, false);
+        return cpuProcessor_.canSkip(*properties_, false);
     }
 }
 
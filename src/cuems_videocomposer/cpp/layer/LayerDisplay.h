@@ -29,9 +29,15 @@ public:
     ~LayerDisplay();
 
     // Set layer properties
-    void setProperties(const LayerProperties& props) { properties_ = props; }
-    const LayerProperties& getProperties() const { return properties_; }
-    LayerProperties& getProperties() { return properties_; }
+    void setProperties(const LayerProperties& props) { *properties_ = props; }
+    const LayerProperties& getProperties() const { return *properties_; }
+    LayerProperties& getProperties() { return *properties_; }
+    
+    /**
+     * Keep the properties in external storage (LayerPropertyStore slot);
+     * current values move there. nullptr = back to the layer's own copy.
+     */
+    void bindProperties(LayerProperties* storage);
 
     // Prepare frame for rendering
     // Takes frame from LayerPlayback (CPU or GPU) and applies modifications
@@ -48,12 +54,16 @@ public:
     // Check if frame is ready for rendering
     bool isReady() const { return frameReady_; }
 
+    // Check if the prepared frame is the playback frame itself (no modifications)
+    bool isPassThrough() const { return sourceFrameCpu_ || sourceFrameGpu_; }
+
     // Get frame info (for aspect ratio calculations, etc.)
     void setFrameInfo(const FrameInfo& info) { frameInfo_ = info; }
     const FrameInfo& getFrameInfo() const { return frameInfo_; }
 
 private:
-    LayerProperties properties_;
+    LayerProperties ownProperties_;     // Used while not in a LayerManager
+    LayerProperties* properties_;       // Own copy or store slot
     FrameInfo frameInfo_;
     
     // Prepared frame buffers (used when modifications are applied)
@@ -0,0 +1,31 @@
+#ifndef VIDEOCOMPOSER_LAYERGROUP_H
+#define VIDEOCOMPOSER_LAYERGROUP_H
+
+#include "LayerProperties.h"
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * LayerGroup - Layers composited and transformed as one
+ *
+ * Layers whose LayerProperties::groupId names a group are drawn into the
+ * group's own image, in their z-order, with their own properties. That
+ * image is then drawn like a full-canvas layer with the group's properties
+ * (position, scale, rotation, opacity, blend, z-order, visibility, color).
+ * The renderer keeps the image and draws it again only when a member
+ * changes, so a static group costs one quad per frame.
+ */
+struct LayerGroup {
+    int groupId = 0;
+    std::string name;
+    LayerProperties properties;     // Of the group image (width/height unused)
+
+    bool rendersSameAs(const LayerGroup& other) const {
+        return groupId == other.groupId && properties.rendersSameAs(other.properties);
+    }
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LAYERGROUP_H
@@ -1,18 +1,46 @@
 #include "LayerManager.h"
+#include "LayerUpdateScheduler.h"
+#include "../utils/Logger.h"
 #include <algorithm>
+#include <atomic>
 #include <map>
 
 namespace videocomposer {
 
 LayerManager::LayerManager()
     : nextLayerId_(1)
+    , nextGroupId_(1)
+    , updateDeadline_(std::chrono::milliseconds(DEFAULT_UPDATE_DEADLINE_MS))
+    , current_(std::make_shared<SceneSnapshot>())
 {
 }
 
 LayerManager::~LayerManager() {
+    updateScheduler_.reset();
     layers_.clear();
 }
 
+void LayerManager::bindToStore(VideoLayer* layer) {
+    size_t slot = propertyStore_.acquire(layer, layer->properties());
+    layer->bindPropertySlot(&propertyStore_.at(slot), static_cast<int>(slot));
+}
+
+void LayerManager::setUpdateThreads(int threads) {
+    size_t workers = threads < 0 ? LayerUpdateScheduler::defaultWorkerCount() : static_cast<size_t>(threads);
+    if (workers == 0) {
+        updateScheduler_.reset();
+        return;
+    }
+    if (updateScheduler_ && updateScheduler_->getWorkerCount() == workers) {
+        return;
+    }
+    updateScheduler_ = std::make_unique<LayerUpdateScheduler>(workers);
+}
+
+size_t LayerManager::getUpdateThreads() const {
+    return updateScheduler_ ? updateScheduler_->getWorkerCount() : 0;
+}
+
 int LayerManager::addLayer(std::unique_ptr<VideoLayer> layer) {
     if (!layer) {
         return -1;
@@ -20,9 +48,11 @@ int LayerManager::addLayer(std::unique_ptr<VideoLayer> layer) {
     
     int layerId = nextLayerId_++;
     layer->setLayerId(layerId);
+    bindToStore(layer.get());
     layers_.push_back(std::move(layer));
     
     sortLayersByZOrder();
+    publishSnapshot();
     return layerId;
 }
 
@@ -40,7 +70,13 @@ bool LayerManager::removeLayer(int layerId) {
                 break;
             }
         }
+        int slot = (*it)->getPropertySlot();
         layers_.erase(it);
+        if (slot >= 0) {
+            propertyStore_.release(static_cast<size_t>(slot));
+        }
+        // The render list must not keep pointing at the removed layer
+        publishSnapshot();
         return true;
     }
     
@@ -73,8 +109,8 @@ const VideoLayer* LayerManager::getLayer(int layerId) const {
     return nullptr;
 }
 
-std::vector<VideoLayer*> LayerManager::getLayers() {
-    std::vector<VideoLayer*> result;
+ArenaVector<VideoLayer*> LayerManager::getLayers() {
+    ArenaVector<VideoLayer*> result;
     result.reserve(layers_.size());
     
     for (auto& layer : layers_) {
@@ -84,8 +120,8 @@ std::vector<VideoLayer*> LayerManager::getLayers() {
     return result;
 }
 
-std::vector<const VideoLayer*> LayerManager::getLayers() const {
-    std::vector<const VideoLayer*> result;
+ArenaVector<const VideoLayer*> LayerManager::getLayers() const {
+    ArenaVector<const VideoLayer*> result;
     result.reserve(layers_.size());
     
     for (const auto& layer : layers_) {
@@ -96,34 +132,64 @@ std::vector<const VideoLayer*> LayerManager::getLayers() const {
 }
 
 void LayerManager::updateAll() {
-    // TODO: PERFORMANCE - Layer-parallel HAP decoding
-    // Currently layers are updated sequentially, which means HAP decode happens
-    // one layer at a time. For 10+ HAP layers, this takes 10-12ms (30-36% of frame budget).
-    //
-    // To achieve 6-7x speedup for multi-layer HAP:
-    // 1. Create a shared DecodeThreadPool (singleton, hardware_concurrency threads)
-    // 2. Submit all layer decode jobs to the pool in parallel
-    // 3. Wait for all decodes to complete before rendering
-    //
-    // Example architecture:
-    //   DecodeThreadPool& pool = DecodeThreadPool::instance();
-    //   for (auto& layer : layers_) {
-    //       pool.enqueue([&layer]() { layer->decodeFrame(); });
-    //   }
-    //   pool.waitAll();
-    //   for (auto& layer : layers_) {
-    //       layer->uploadToGPU();  // GPU uploads must be sequential (OpenGL context)
-    //   }
-    //
-    // Note: GPU texture uploads must remain on main thread (OpenGL context bound).
-    // Only the CPU decode (Snappy decompression) should be parallelized.
-    
-    // Collect layers to remove (auto-unload)
-    std::vector<int> layersToRemove;
+    // Phase 1 (render thread): poll sync sources. They share the global MTC
+    // source, so polling stays serial and cheap.
+    ArenaVector<VideoLayer*> cpuLayers;
+    ArenaVector<VideoLayer*> renderThreadLayers;
+    cpuLayers.reserve(layers_.size());
+    renderThreadLayers.reserve(layers_.size());
+    for (auto& layer : layers_) {
+        if (!layer || !layer->isReady()) {
+            continue;
+        }
+        layer->pollSync();
+        if (!layer->hasPendingLoad()) {
+            continue;
+        }
+        if (layer->canLoadOffRenderThread()) {
+            cpuLayers.push_back(layer.get());
+        } else {
+            renderThreadLayers.push_back(layer.get());
+        }
+    }
+    
+    // Phase 2: decode. CPU-only loads (software decode, CPU HAP, live copies)
+    // go to the scheduler; GL/EGL-bound loads (VAAPI import, direct HAP
+    // upload) run here on the render thread at the same time.
+    auto renderThreadWork = [&renderThreadLayers]() {
+        for (VideoLayer* layer : renderThreadLayers) {
+            layer->loadPendingFrame();
+        }
+    };
+    if (cpuLayers.size() > 1 && updateScheduler_) {
+        // Kept between frames: the scheduler takes a std::vector
+        std::vector<std::function<void()>>& jobs = updateJobs_;
+        jobs.clear();
+        for (VideoLayer* layer : cpuLayers) {
+            jobs.push_back([layer]() { layer->loadPendingFrame(); });
+        }
+        auto deadline = LayerUpdateScheduler::Clock::now() + updateDeadline_;
+        if (updateDeadline_.count() <= 0) {
+            deadline = LayerUpdateScheduler::Clock::time_point::max();
+        }
+        size_t skipped = updateScheduler_->run(jobs, deadline, renderThreadWork);
+        jobs.clear();
+        if (skipped > 0) {
+            LOG_VERBOSE << "Layer update deadline: " << skipped << " layer(s) keep their previous frame";
+        }
+    } else {
+        renderThreadWork();
+        for (VideoLayer* layer : cpuLayers) {
+            layer->loadPendingFrame();
+        }
+    }
+    
+    // Phase 3 (render thread): loop/end handling and auto-unload
+    ArenaVector<int> layersToRemove;
     
     for (auto& layer : layers_) {
         if (layer && layer->isReady()) {
-            layer->update();
+            layer->finishUpdate();
             
             // Check for auto-unload: if playback ended and autoUnload is enabled
             auto& props = layer->properties();
@@ -153,6 +219,36 @@ void LayerManager::updateAll() {
     for (int layerId : layersToRemove) {
         removeLayer(layerId);
     }
+    
+    publishSnapshot();
+}
+
+size_t LayerManager::latchAll() {
+    size_t latched = 0;
+    for (auto& layer : layers_) {
+        if (layer && layer->latchSync()) {
+            latched++;
+        }
+    }
+    publishSnapshot();
+    return latched;
+}
+
+void LayerManager::onTransportEvent(const TransportEvent& event) {
+    for (auto& layer : layers_) {
+        if (layer) {
+            layer->onTransportEvent(event);
+        }
+    }
+}
+
+void LayerManager::animateAll(int64_t presentationUs) {
+    for (size_t slot = 0; slot < propertyStore_.slotCount(); ++slot) {
+        VideoLayer* layer = propertyStore_.owner(slot);
+        if (layer && layer->animator().isAnimating()) {
+            layer->animator().apply(propertyStore_.at(slot), presentationUs);
+        }
+    }
 }
 
 VideoLayer* LayerManager::getLayerByIndex(size_t index) {
@@ -227,6 +323,9 @@ bool LayerManager::duplicateLayer(int layerId, int* newLayerId) {
     newProps.scaleY = sourceProps.scaleY;
     newProps.rotation = sourceProps.rotation;
     newProps.blendMode = sourceProps.blendMode;
+    newProps.packedAlpha = sourceProps.packedAlpha;
+    newProps.packedAlphaPremultiplied = sourceProps.packedAlphaPremultiplied;
+    newProps.groupId = sourceProps.groupId;
 
     // Note: We can't duplicate the input source easily without cloning
     // This would require InputSource to support cloning
@@ -318,8 +417,8 @@ bool LayerManager::moveLayerDown(int layerId) {
     return true;
 }
 
-std::vector<VideoLayer*> LayerManager::getLayersSortedByZOrder() {
-    std::vector<VideoLayer*> result;
+ArenaVector<VideoLayer*> LayerManager::getLayersSortedByZOrder() {
+    ArenaVector<VideoLayer*> result;
     result.reserve(layers_.size());
     
     for (auto& layer : layers_) {
@@ -335,8 +434,8 @@ std::vector<VideoLayer*> LayerManager::getLayersSortedByZOrder() {
     return result;
 }
 
-std::vector<const VideoLayer*> LayerManager::getLayersSortedByZOrder() const {
-    std::vector<const VideoLayer*> result;
+ArenaVector<const VideoLayer*> LayerManager::getLayersSortedByZOrder() const {
+    ArenaVector<const VideoLayer*> result;
     result.reserve(layers_.size());
     
     for (const auto& layer : layers_) {
@@ -352,6 +451,136 @@ std::vector<const VideoLayer*> LayerManager::getLayersSortedByZOrder() const {
     return result;
 }
 
+LayerGroup* LayerManager::getGroup(std::string_view name) {
+    auto it = groups_.find(name);
+    return it != groups_.end() ? &it->second : nullptr;
+}
+
+LayerGroup* LayerManager::createGroup(const std::string& name) {
+    if (name.empty()) {
+        return nullptr;
+    }
+    auto it = groups_.find(name);
+    if (it == groups_.end()) {
+        LayerGroup group;
+        group.groupId = nextGroupId_++;
+        group.name = name;
+        it = groups_.emplace(name, group).first;
+    }
+    return &it->second;
+}
+
+bool LayerManager::removeGroup(std::string_view name) {
+    auto it = groups_.find(name);
+    if (it == groups_.end()) {
+        return false;
+    }
+    int groupId = it->second.groupId;
+    for (auto& layer : layers_) {
+        if (layer->properties().groupId == groupId) {
+            layer->properties().groupId = 0;
+        }
+    }
+    groups_.erase(it);
+    return true;
+}
+
+bool LayerManager::setLayerGroup(int layerId, std::string_view name) {
+    VideoLayer* layer = getLayer(layerId);
+    if (!layer) {
+        return false;
+    }
+    if (name.empty()) {
+        layer->properties().groupId = 0;
+        return true;
+    }
+    LayerGroup* group = createGroup(std::string(name));
+    if (!group) {
+        return false;
+    }
+    layer->properties().groupId = group->groupId;
+    return true;
+}
+
+std::shared_ptr<const SceneSnapshot> LayerManager::getSnapshot() const {
+    return std::atomic_load(&current_);
+}
+
+bool LayerManager::snapshotMatches(const SceneSnapshot& snapshot) const {
+    if (snapshot.entries.size() != layers_.size() || snapshot.groups.size() != groups_.size()) {
+        return false;
+    }
+    size_t g = 0;
+    for (const auto& group : groups_) {
+        if (!snapshot.groups[g++].rendersSameAs(group.second)) {
+            return false;
+        }
+    }
+    // Every layer has one slot: the entries cover them all if each still
+    // finds its layer, unchanged, in its slot
+    for (const SceneSnapshot::Entry& entry : snapshot.entries) {
+        size_t slot = static_cast<size_t>(entry.slot);
+        const VideoLayer* layer = propertyStore_.owner(slot);
+        if (!layer || layer != entry.layer || entry.layerId != layer->getLayerId() ||
+            entry.ready != layer->isReady() || entry.frameGeneration != layer->getFrameGeneration() ||
+            !entry.properties.rendersSameAs(propertyStore_.at(slot))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LayerManager::publishSnapshot() {
+    // Only this thread publishes, so the plain read of current_ is safe
+    const SceneSnapshot& previous = *current_;
+    if (snapshotMatches(previous)) {
+        return false;
+    }
+    
+    // Reuse the older buffer (and its capacity) when no reader holds it;
+    // readers only reach it through current_, which no longer points at it
+    std::shared_ptr<SceneSnapshot> next;
+    if (spare_ && spare_.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        next = std::move(spare_);
+    } else {
+        next = std::make_shared<SceneSnapshot>();
+    }
+    spare_.reset();
+    
+    next->version = previous.version + 1;
+    next->entries.clear();
+    for (const auto& layer : layers_) {
+        SceneSnapshot::Entry entry;
+        entry.layer = layer.get();
+        entry.layerId = layer->getLayerId();
+        entry.slot = layer->getPropertySlot();
+        entry.ready = layer->isReady();
+        entry.frameGeneration = layer->getFrameGeneration();
+        entry.properties = layer->properties();
+        next->entries.push_back(entry);
+    }
+    // Descending z-order (top layers first), as getLayersSortedByZOrder()
+    std::stable_sort(next->entries.begin(), next->entries.end(),
+        [](const SceneSnapshot::Entry& a, const SceneSnapshot::Entry& b) {
+            return a.properties.zOrder > b.properties.zOrder;
+        });
+    next->layers.clear();
+    for (const SceneSnapshot::Entry& entry : next->entries) {
+        next->layers.push_back(entry.layer);
+    }
+    next->groups.clear();
+    for (const auto& group : groups_) {
+        next->groups.push_back(group.second);
+    }
+    
+    std::shared_ptr<const SceneSnapshot> published = next;
+    std::shared_ptr<const SceneSnapshot> old = std::atomic_exchange(&current_, published);
+    // The retired snapshot becomes the spare (const only towards readers)
+    spare_ = std::const_pointer_cast<SceneSnapshot>(old);
+    return true;
+}
+
 bool LayerManager::addLayerWithId(const std::string& cueId, std::unique_ptr<VideoLayer> layer) {
     if (!layer) {
         return false;
@@ -360,9 +589,11 @@ bool LayerManager::addLayerWithId(const std::string& cueId, std::unique_ptr<Vide
     int layerId = nextLayerId_++;
     layer->setLayerId(layerId);
     cueIdToLayerId_[cueId] = layerId;
+    bindToStore(layer.get());
     layers_.push_back(std::move(layer));
     
     sortLayersByZOrder();
+    publishSnapshot();
     return true;
 }
 
@@ -376,7 +607,7 @@ bool LayerManager::removeLayerByCueId(const std::string& cueId) {
     return false;
 }
 
-VideoLayer* LayerManager::getLayerByCueId(const std::string& cueId) {
+VideoLayer* LayerManager::getLayerByCueId(std::string_view cueId) {
     auto mapIt = cueIdToLayerId_.find(cueId);
     if (mapIt != cueIdToLayerId_.end()) {
         return getLayer(mapIt->second);
@@ -384,7 +615,7 @@ VideoLayer* LayerManager::getLayerByCueId(const std::string& cueId) {
     return nullptr;
 }
 
-const VideoLayer* LayerManager::getLayerByCueId(const std::string& cueId) const {
+const VideoLayer* LayerManager::getLayerByCueId(std::string_view cueId) const {
     auto mapIt = cueIdToLayerId_.find(cueId);
     if (mapIt != cueIdToLayerId_.end()) {
         return getLayer(mapIt->second);
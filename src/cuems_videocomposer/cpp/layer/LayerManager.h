@@ -2,14 +2,22 @@
 #define VIDEOCOMPOSER_LAYERMANAGER_H
 
 #include "VideoLayer.h"
+#include "SceneSnapshot.h"
+#include "LayerPropertyStore.h"
+#include "../utils/FrameArena.h"
 #include <vector>
 #include <memory>
 #include <map>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <chrono>
+#include <functional>
 
 namespace videocomposer {
 
+class LayerUpdateScheduler;
+
 /**
  * LayerManager - Manages collection of VideoLayer instances
  * 
@@ -30,13 +38,13 @@ public:
     // Layer management by UUID (cue ID)
     bool addLayerWithId(const std::string& cueId, std::unique_ptr<VideoLayer> layer);
     bool removeLayerByCueId(const std::string& cueId);
-    VideoLayer* getLayerByCueId(const std::string& cueId);
-    const VideoLayer* getLayerByCueId(const std::string& cueId) const;
+    VideoLayer* getLayerByCueId(std::string_view cueId);
+    const VideoLayer* getLayerByCueId(std::string_view cueId) const;
     std::string getCueIdFromLayer(VideoLayer* layer) const;
     
     // Get all layers (sorted by z-order)
-    std::vector<VideoLayer*> getLayers();
-    std::vector<const VideoLayer*> getLayers() const;
+    ArenaVector<VideoLayer*> getLayers();
+    ArenaVector<const VideoLayer*> getLayers() const;
     
     // Layer count
     size_t getLayerCount() const { return layers_.size(); }
@@ -44,6 +52,44 @@ public:
     // Update all layers
     void updateAll();
     
+    /**
+     * Push a transport event of the global sync source to every layer
+     * (call before updateAll(), see LayerPlayback::onTransportEvent)
+     */
+    void onTransportEvent(const TransportEvent& event);
+    
+    /**
+     * Advance every layer's property tweens to this presentation time
+     * (one pass over the property store, see PropertyAnimator)
+     */
+    void animateAll(int64_t presentationUs);
+    
+    /**
+     * Late latch, after updateAll() and just before the render: layers on
+     * the sync source switch to a newer frame if it is already decoded,
+     * and the snapshot is republished with the properties as they are now
+     * (see LayerPlayback::latchSync)
+     * @return Layers whose frame changed
+     */
+    size_t latchAll();
+    
+    /**
+     * Configure parallel layer updates
+     * @param threads Worker threads for CPU-side frame loads
+     *                (-1 = auto, 0 = serial updates on the render thread)
+     */
+    void setUpdateThreads(int threads);
+    size_t getUpdateThreads() const;
+    
+    /**
+     * Per-frame budget for layer frame loads; loads not started in time
+     * are skipped for this frame (0 = no deadline)
+     */
+    void setUpdateDeadline(std::chrono::milliseconds deadline) { updateDeadline_ = deadline; }
+    static constexpr int DEFAULT_UPDATE_DEADLINE_MS = 12;
+    
+    LayerUpdateScheduler* getUpdateScheduler() const { return updateScheduler_.get(); }
+    
     // Get layer by index
     VideoLayer* getLayerByIndex(size_t index);
     const VideoLayer* getLayerByIndex(size_t index) const;
@@ -56,16 +102,55 @@ public:
     bool moveLayerUp(int layerId);
     bool moveLayerDown(int layerId);
     
+    /**
+     * Layer groups (see LayerGroup): members are composited into the
+     * group's image, drawn with the group's properties
+     */
+    LayerGroup* getGroup(std::string_view name);
+    LayerGroup* createGroup(const std::string& name);   // The existing one if the name is taken
+    bool removeGroup(std::string_view name);            // Members are ungrouped
+    bool setLayerGroup(int layerId, std::string_view name);  // Empty name = ungroup; creates the group
+    size_t getGroupCount() const { return groups_.size(); }
+    
     // Get layers sorted by z-order (for rendering)
-    std::vector<VideoLayer*> getLayersSortedByZOrder();
-    std::vector<const VideoLayer*> getLayersSortedByZOrder() const;
+    ArenaVector<VideoLayer*> getLayersSortedByZOrder();
+    ArenaVector<const VideoLayer*> getLayersSortedByZOrder() const;
+    
+    /**
+     * Current render list; safe to read from any thread without locking.
+     * The returned snapshot never changes and stays valid while held.
+     */
+    std::shared_ptr<const SceneSnapshot> getSnapshot() const;
+    
+    /**
+     * Rebuild the render list if anything changed since the last one
+     * (called by updateAll() and when layers are added or removed)
+     * @return true if a new version was published
+     */
+    bool publishSnapshot();
 
 private:
+    // Declared before layers_: the layers point into it until destroyed
+    LayerPropertyStore propertyStore_;
     std::vector<std::unique_ptr<VideoLayer>> layers_;
     int nextLayerId_;
-    std::map<std::string, int> cueIdToLayerId_;  // Map UUID cue ID to internal layer ID
+    std::map<std::string, int, std::less<>> cueIdToLayerId_;  // Map UUID cue ID to internal layer ID (looked up by string_view)
+    std::map<std::string, LayerGroup, std::less<>> groups_;
+    int nextGroupId_;
+    
+    // Parallel CPU-side layer updates (nullptr = serial)
+    std::unique_ptr<LayerUpdateScheduler> updateScheduler_;
+    std::chrono::milliseconds updateDeadline_;
+    std::vector<std::function<void()>> updateJobs_;  // Reused each frame
+    
+    // Render list: current_ is swapped atomically; spare_ is the previous
+    // one, reused for the next build once no reader holds it
+    std::shared_ptr<const SceneSnapshot> current_;
+    std::shared_ptr<SceneSnapshot> spare_;
     
     void sortLayersByZOrder();
+    void bindToStore(VideoLayer* layer);
+    bool snapshotMatches(const SceneSnapshot& snapshot) const;
     int getNextZOrder();
 };
 
@@ -1,10 +1,18 @@
 #include "LayerPlayback.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
 #include "../utils/SMPTEUtils.h"
+#include "../utils/FrameTracer.h"
 #include "../sync/SyncSource.h"
 #include "../input/HAPVideoInput.h"
 #include "../input/VideoFileInput.h"
+#include "../input/CuePrefetcher.h"
+#include "../input/SharedMediaRegistry.h"
+#ifdef HAVE_V4L2
+#include "../input/V4L2VideoInput.h"
+#endif
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <chrono>
 
@@ -20,22 +28,379 @@ LayerPlayback::LayerPlayback()
     , mtcFollow_(true)  // Default: follow MTC
     , wasRolling_(false)
     , lastLoggedFrame_(-1)
-    , debugCounter_(0)
     , loggedExceededDuration_(false)
     , frameOnGPU_(false)
+    , cueTimeOffset_(0)
+    , cueTimeScale_(1.0)
+    , pendingLoad_(PendingLoad::NONE)
+    , pendingFrame_(-1)
+    , locatePending_(false)
+    , frameRing_(MappedFrameRing::create())
+    , planarOutputAllowed_(true)
+    , decodePriority_(1)
+    , decodeVisible_(true)
+    , underrunPolicy_(InputSource::UnderrunPolicy::BLOCK)
+    , rateDivisor_(1)
+    , loadTime_(0.0)
+    , vsyncCount_(0)
+    , lastFrameChangeVsync_(0)
+    , lastVideoFrame_(-1)
+    , frameGeneration_(0)
+    , loadedFrame_(-1)
+    , loadSuspended_(false)
+    , skippedWhileSuspended_(false)
+    , staticFrameLoaded_(false)
+    , armed_(false)
+    , armedFrame_(0)
+    , armLoadPending_(false)
+    , incomingDone_(false)
+    , incomingLoaded_(false)
+    , incomingPrepared_(-1)
+    , incomingLead_(INCOMING_MIN_LEAD)
+    , incomingFailures_(0)
+    , incomingKeyframeAligned_(false)
+    , sourceSwapped_(false)
+    , seekDone_(false)
+    , seekLoaded_(false)
+    , seekTarget_(-1)
+    , seekQueued_(-1)
+    , seekCompleted_(false)
 {
 }
 
 LayerPlayback::~LayerPlayback() {
+    cancelAsyncSeek();
+    cancelIncoming();
     pause();
+    if (!sharedMediaPath_.empty()) {
+        SharedMediaRegistry::instance().removeUser(sharedMediaPath_);
+    }
 }
 
 void LayerPlayback::setInputSource(std::unique_ptr<InputSource> input) {
+    cancelAsyncSeek();
+    cancelIncoming();
     pause();
+    cuePrefetcher_.reset();
     inputSource_ = std::move(input);
+    frameGeneration_++;
+    loadedFrame_ = -1;
     currentFrame_ = -1;
     lastSyncFrame_ = -1;
     frameOnGPU_ = false;
+    staticFrameLoaded_ = false;
+    armLoadPending_ = armed_;
+    
+    // Cue list and decode settings belong to the layer, so they carry over to the new file
+    if (!cueSyncFrames_.empty() || !loopFrames_.empty()) {
+        applyCuePoints();
+    }
+    applyDecodePriority();
+    applyDecodeVisible();
+    applyUnderrunPolicy();
+    registerSharedMedia();
+}
+
+void LayerPlayback::setIncomingSource(std::unique_ptr<InputSource> input, std::unique_ptr<SyncSource> sync,
+                                      bool keyframeAligned) {
+    if (!isReady() || !input || !input->isReady()) {
+        // Nothing on screen to keep: plain load
+        setInputSource(std::move(input));
+        if (sync) {
+            setSyncSource(std::move(sync));
+        }
+        return;
+    }
+    cancelIncoming();
+    incomingSource_ = std::move(input);
+    incomingSync_ = std::move(sync);
+    incomingLead_ = INCOMING_MIN_LEAD;
+    incomingKeyframeAligned_ = keyframeAligned;
+}
+
+bool LayerPlayback::takeSourceSwapped() {
+    bool swapped = sourceSwapped_;
+    sourceSwapped_ = false;
+    return swapped;
+}
+
+void LayerPlayback::cancelIncoming() {
+    if (incomingThread_) {
+        incomingThread_->join();  // At most one frame decode
+        incomingThread_.reset();
+    }
+    incomingSource_.reset();
+    incomingSync_.reset();
+    incomingFrame_ = FrameBuffer();
+    incomingDone_ = false;
+    incomingLoaded_ = false;
+    incomingPrepared_ = -1;
+    incomingFailures_ = 0;
+}
+
+int64_t LayerPlayback::incomingTargetFrame(bool* rolling) {
+    *rolling = false;
+    int64_t frame = 0;
+    SyncSource* sync = incomingSync_ ? incomingSync_.get() : syncSource_.get();
+    if (armed_) {
+        frame = armedFrame_;
+    } else if (mtcFollow_ && sync && sync->isConnected()) {
+        // Same mapping as updateFromSyncSource(), through the incoming source's sync
+        uint8_t syncRolling = 0;
+        int64_t syncFrame = sync->pollFrame(&syncRolling);
+        if (syncFrame >= 0) {
+            frame = static_cast<int64_t>(std::floor(static_cast<double>(syncFrame) * timeScale_)) + timeOffset_;
+            *rolling = syncRolling != 0;
+        }
+    }
+    int64_t totalFrames = incomingSource_->getFrameInfo().totalFrames;
+    if (totalFrames > 0) {
+        frame = std::min(frame, totalFrames - 1);
+    }
+    return std::max<int64_t>(0, frame);
+}
+
+void LayerPlayback::updateIncoming() {
+    // Live inputs have no positions: take over with their first frame
+    if (incomingSource_->isLiveStream()) {
+        if (incomingSource_->readLatestFrame(incomingFrame_)) {
+            adoptIncoming(0);
+        }
+        return;
+    }
+    
+    if (incomingThread_) {
+        if (!incomingDone_) {
+            return;  // Still decoding; the current source keeps playing
+        }
+        incomingThread_->join();
+        incomingThread_.reset();
+        if (!incomingLoaded_ && ++incomingFailures_ >= INCOMING_MAX_FAILURES) {
+            // Cannot preload: switch now and let the normal path load
+            LOG_WARNING << "Gapless swap: cannot decode frame " << incomingPrepared_ << ", switching directly";
+            adoptIncoming(-1);
+            return;
+        }
+    }
+    
+    bool rolling = false;
+    int64_t target = incomingTargetFrame(&rolling);
+    int direction = timeScale_ < 0.0 ? -1 : 1;
+    if (incomingLoaded_) {
+        if (target == incomingPrepared_) {
+            adoptIncoming(target);  // Frame boundary reached with the frame in hand
+            return;
+        }
+        if (rolling && (incomingPrepared_ - target) * direction > 0) {
+            return;  // Not there yet
+        }
+        if (rolling) {
+            // Sync passed the prepared frame: aim further ahead
+            incomingLead_ = std::min(incomingLead_ * 2, INCOMING_MAX_LEAD);
+        }
+    }
+    
+    // Decode the takeover frame off the render thread
+    int64_t frame = rolling ? target + direction * incomingLead_ : target;
+    int64_t totalFrames = incomingSource_->getFrameInfo().totalFrames;
+    if (totalFrames > 0) {
+        frame = std::min(frame, totalFrames - 1);
+    }
+    frame = std::max<int64_t>(0, frame);
+    if (incomingKeyframeAligned_ && rolling && direction > 0) {
+        frame = incomingKeyframeAtOrAfter(frame, target + INCOMING_MAX_LEAD);
+    }
+    incomingPrepared_ = frame;
+    incomingLoaded_ = false;
+    incomingDone_ = false;
+    InputSource* source = incomingSource_.get();
+    incomingThread_ = std::make_unique<std::thread>([this, source, frame]() {
+        ThreadRoles::instance().apply(ThreadRole::LOADER);
+        incomingLoaded_ = source->seek(frame) && source->readFrame(frame, incomingFrame_);
+        incomingDone_ = true;
+    });
+}
+
+int64_t LayerPlayback::incomingKeyframeAtOrAfter(int64_t frame, int64_t limit) const {
+    const VideoFileInput* videoInput = dynamic_cast<const VideoFileInput*>(incomingSource_.get());
+    if (!videoInput) {
+        return frame;
+    }
+    int64_t totalFrames = videoInput->getFrameInfo().totalFrames;
+    if (totalFrames > 0) {
+        limit = std::min(limit, totalFrames - 1);
+    }
+    for (int64_t f = frame; f <= limit; ++f) {
+        int64_t distance = videoInput->getKeyframeDistance(f);
+        if (distance < 0) {
+            return frame;  // No index: any frame will do
+        }
+        if (distance == 0) {
+            return f;
+        }
+    }
+    return frame;
+}
+
+void LayerPlayback::adoptIncoming(int64_t frameNumber) {
+    cuePrefetcher_.reset();
+    inputSource_ = std::move(incomingSource_);
+    if (incomingSync_) {
+        syncSource_ = std::move(incomingSync_);
+    }
+    frameOnGPU_ = false;
+    ringFrame_.reset();
+    staticFrameLoaded_ = false;
+    if (frameNumber >= 0) {
+        // The prepared frame is the current frame: no gap, no reload
+        cpuFrameBuffer_.swap(incomingFrame_);
+        staticFrameLoaded_ = inputSource_->isStatic();
+        currentFrame_ = frameNumber;
+        loadedFrame_ = frameNumber;
+        lastSyncFrame_ = inputSource_->isLiveStream() ? -1 : frameNumber;
+        armLoadPending_ = false;
+    } else {
+        currentFrame_ = -1;
+        loadedFrame_ = -1;
+        lastSyncFrame_ = -1;
+        armLoadPending_ = armed_;
+    }
+    frameGeneration_++;
+    incomingFrame_ = FrameBuffer();
+    incomingLoaded_ = false;
+    incomingPrepared_ = -1;
+    incomingFailures_ = 0;
+    sourceSwapped_ = true;
+    
+    if (!cueSyncFrames_.empty() || !loopFrames_.empty()) {
+        applyCuePoints();
+    }
+    applyDecodePriority();
+    applyDecodeVisible();
+    applyUnderrunPolicy();
+    registerSharedMedia();
+    LOG_INFO << "Gapless swap: new source took over at frame " << frameNumber;
+}
+
+void LayerPlayback::registerSharedMedia() {
+    VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get());
+    std::string path = videoInput && videoInput->isReady() ? videoInput->getFilename() : std::string();
+    if (path == sharedMediaPath_) {
+        return;
+    }
+    SharedMediaRegistry& registry = SharedMediaRegistry::instance();
+    if (!sharedMediaPath_.empty()) {
+        registry.removeUser(sharedMediaPath_);
+    }
+    sharedMediaPath_ = path;
+    if (!sharedMediaPath_.empty()) {
+        registry.addUser(sharedMediaPath_);
+    }
+}
+
+bool LayerPlayback::loadSharedFrame(VideoFileInput* videoInput, int64_t frameNumber) {
+    // Another layer at this position already decoded the frame
+    SharedMediaRegistry& registry = SharedMediaRegistry::instance();
+    if (registry.findFrame(sharedMediaPath_, frameNumber, cpuFrameBuffer_)) {
+        return true;
+    }
+    std::shared_ptr<FrameBuffer> frame = registry.acquireFrame(sharedMediaPath_);
+    if (!videoInput->readFrame(frameNumber, *frame) ||
+        !cpuFrameBuffer_.wrap(frame->data(), frame->size(), frame->info(), frame)) {
+        return false;
+    }
+    registry.publishFrame(sharedMediaPath_, frameNumber, std::move(frame));
+    return true;
+}
+
+void LayerPlayback::setDecodePriority(int priority) {
+    decodePriority_ = std::max(1, priority);
+    applyDecodePriority();
+}
+
+void LayerPlayback::applyDecodePriority() {
+    if (VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get())) {
+        videoInput->setDecodePriority(decodePriority_);
+    }
+}
+
+void LayerPlayback::setDecodeVisible(bool visible) {
+    if (decodeVisible_ != visible) {
+        decodeVisible_ = visible;
+        applyDecodeVisible();
+    }
+}
+
+void LayerPlayback::applyDecodeVisible() {
+    if (VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get())) {
+        videoInput->setDecodeVisible(decodeVisible_);
+    }
+}
+
+void LayerPlayback::setUnderrunPolicy(InputSource::UnderrunPolicy policy) {
+    underrunPolicy_ = policy;
+    applyUnderrunPolicy();
+}
+
+void LayerPlayback::applyUnderrunPolicy() {
+    if (VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get())) {
+        videoInput->setUnderrunPolicy(underrunPolicy_);
+    }
+}
+
+void LayerPlayback::setCuePoints(const std::vector<int64_t>& syncFrames) {
+    cueSyncFrames_ = syncFrames;
+    applyCuePoints();
+}
+
+void LayerPlayback::setLoopTargets(const std::vector<int64_t>& frames) {
+    if (frames == loopFrames_) {
+        return;
+    }
+    loopFrames_ = frames;
+    applyCuePoints();
+}
+
+void LayerPlayback::applyCuePoints() {
+    cueTimeOffset_ = timeOffset_;
+    cueTimeScale_ = timeScale_;
+    
+    VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get());
+    if ((cueSyncFrames_.empty() && loopFrames_.empty()) || !videoInput || !videoInput->isReady()) {
+        cuePrefetcher_.reset();
+        return;
+    }
+    
+    if (!cuePrefetcher_) {
+        cuePrefetcher_ = std::make_unique<CuePrefetcher>();
+        if (!cuePrefetcher_->open(*videoInput)) {
+            cuePrefetcher_.reset();
+            return;
+        }
+    }
+    
+    // Map cue timecodes to input frames the same way sync frames are mapped
+    int64_t totalFrames = videoInput->getFrameInfo().totalFrames;
+    std::vector<int64_t> frames;
+    frames.reserve(cueSyncFrames_.size() + loopFrames_.size());
+    for (int64_t syncFrame : cueSyncFrames_) {
+        int64_t frame = static_cast<int64_t>(std::floor(static_cast<double>(syncFrame) * timeScale_)) + timeOffset_;
+        if (frame >= 0 && (totalFrames <= 0 || frame < totalFrames)) {
+            frames.push_back(frame);
+        }
+    }
+    // Loop targets are already input frames
+    std::vector<int64_t> loopFrames;
+    for (int64_t frame : loopFrames_) {
+        if (frame >= 0 && (totalFrames <= 0 || frame < totalFrames)) {
+            frames.push_back(frame);
+            loopFrames.push_back(frame);
+        }
+    }
+    cuePrefetcher_->setCues(frames, loopFrames);
+    
+    LOG_INFO << "Cue prefetch: " << frames.size() << " cue(s) registered"
+             << (loopFrames_.empty() ? "" : " (including loop targets)");
 }
 
 void LayerPlayback::setSyncSource(std::unique_ptr<SyncSource> sync) {
@@ -60,6 +425,14 @@ bool LayerPlayback::seek(int64_t frameNumber) {
     if (!inputSource_) {
         return false;
     }
+    cancelAsyncSeek();  // This one wins
+    
+    if (isPreloaded(frameNumber) && loadFrame(frameNumber)) {
+        // Loop wrap or cue: the target is pre-decoded (or cached), no decoder seek
+        currentFrame_ = frameNumber;
+        lastSyncFrame_ = -1;
+        return true;
+    }
     
     if (inputSource_->seek(frameNumber)) {
         currentFrame_ = frameNumber;
@@ -70,10 +443,156 @@ bool LayerPlayback::seek(int64_t frameNumber) {
     return false;
 }
 
+bool LayerPlayback::seekAsync(int64_t frameNumber) {
+    if (!inputSource_ || !inputSource_->isReady() || inputSource_->isLiveStream()) {
+        return false;
+    }
+    int64_t totalFrames = inputSource_->getFrameInfo().totalFrames;
+    if (totalFrames > 0) {
+        frameNumber = std::min(frameNumber, totalFrames - 1);
+    }
+    frameNumber = std::max<int64_t>(0, frameNumber);
+    
+    if (seekThread_) {
+        seekQueued_ = frameNumber;  // Started when the current decode returns
+        return true;
+    }
+    if (isPreloaded(frameNumber) && loadFrame(frameNumber)) {
+        // Pre-decoded: nothing to wait for
+        currentFrame_ = frameNumber;
+        lastSyncFrame_ = -1;
+        completeAsyncSeek(frameNumber, true);
+        return true;
+    }
+    startAsyncSeek(frameNumber);
+    return true;
+}
+
+void LayerPlayback::startAsyncSeek(int64_t frameNumber) {
+    seekTarget_ = frameNumber;
+    seekLoaded_ = false;
+    seekDone_ = false;
+    InputSource* source = inputSource_.get();
+    seekThread_ = std::make_unique<std::thread>([this, source, frameNumber]() {
+        ThreadRoles::instance().apply(ThreadRole::LOADER);
+        source->resetSeekState();
+        seekLoaded_ = source->seek(frameNumber) && source->readFrame(frameNumber, seekFrame_);
+        seekDone_ = true;
+    });
+}
+
+bool LayerPlayback::updateAsyncSeek() {
+    if (!seekDone_) {
+        return false;  // The layer keeps its frame; the input is the thread's
+    }
+    seekThread_->join();
+    seekThread_.reset();
+    
+    if (seekQueued_ >= 0) {
+        // Superseded while decoding: go for the latest target
+        int64_t next = seekQueued_;
+        seekQueued_ = -1;
+        startAsyncSeek(next);
+        return false;
+    }
+    
+    if (seekLoaded_) {
+        cpuFrameBuffer_.swap(seekFrame_);
+        ringFrame_.reset();
+        frameOnGPU_ = false;
+        currentFrame_ = seekTarget_;
+        loadedFrame_ = seekTarget_;
+        frameGeneration_++;
+    } else {
+        LOG_WARNING << "Asynchronous seek: cannot decode frame " << seekTarget_;
+    }
+    // As seek(): a following sync source takes over again from here
+    lastSyncFrame_ = -1;
+    seekFrame_ = FrameBuffer();
+    completeAsyncSeek(seekTarget_, seekLoaded_);
+    return true;
+}
+
+void LayerPlayback::cancelAsyncSeek() {
+    if (seekThread_) {
+        seekThread_->join();  // At most one seek and frame decode
+        seekThread_.reset();
+    }
+    seekFrame_ = FrameBuffer();
+    seekDone_ = false;
+    seekLoaded_ = false;
+    seekQueued_ = -1;
+}
+
+void LayerPlayback::completeAsyncSeek(int64_t frameNumber, bool loaded) {
+    seekCompletion_.frame = frameNumber;
+    seekCompletion_.loaded = loaded;
+    seekCompleted_ = true;
+}
+
+bool LayerPlayback::takeSeekCompletion(SeekCompletion& completion) {
+    if (!seekCompleted_) {
+        return false;
+    }
+    completion = seekCompletion_;
+    seekCompleted_ = false;
+    return true;
+}
+
+void LayerPlayback::arm(int64_t frameNumber) {
+    armed_ = true;
+    armedFrame_ = std::max<int64_t>(0, frameNumber);
+    armLoadPending_ = true;
+    playing_ = false;
+}
+
+void LayerPlayback::go() {
+    if (!armed_) {
+        return;
+    }
+    armed_ = false;
+    armLoadPending_ = false;
+    // lastSyncFrame_ is the armed frame: if sync maps there nothing is
+    // reloaded, otherwise the next frame continues from the warm decoder
+}
+
 void LayerPlayback::update() {
+    pollSync();
+    loadPendingFrame();
+}
+
+void LayerPlayback::pollSync() {
+    pendingLoad_ = PendingLoad::NONE;
     if (!isReady()) {
         return;
     }
+    
+    if (seekThread_ && !updateAsyncSeek()) {
+        return;
+    }
+    
+    if (incomingSource_) {
+        updateIncoming();
+    }
+
+    // Cue frames depend on the layer's time-scaling
+    if (cuePrefetcher_ && (timeOffset_ != cueTimeOffset_ || timeScale_ != cueTimeScale_)) {
+        applyCuePoints();
+    }
+
+    if (armed_) {
+        // Standby: load the start frame once; sync does not move the layer
+        if (armLoadPending_) {
+            int64_t totalFrames = inputSource_->getFrameInfo().totalFrames;
+            if (totalFrames > 0) {
+                armedFrame_ = std::min(armedFrame_, totalFrames - 1);
+            }
+            armLoadPending_ = false;
+            pendingFrame_ = armedFrame_;
+            pendingLoad_ = PendingLoad::LOCATE;
+        }
+        return;
+    }
 
     // Always check sync source, even when not playing
     // This allows automatic start when MTC is received
@@ -90,6 +609,7 @@ void LayerPlayback::updateFromSyncSource() {
         // No sync source - manual playback or paused
         return;
     }
+    FRAME_TRACE_SCOPE("frame.select");
     
     // Check if MTC following is disabled for this layer
     if (!mtcFollow_) {
@@ -104,10 +624,7 @@ void LayerPlayback::updateFromSyncSource() {
     int64_t syncFrame = syncSource_->pollFrame(&rolling);
     
     // Debug: log frame and rolling state periodically
-    debugCounter_++;
-    if (debugCounter_ % 60 == 0) {  // Log every 60 calls (~1 second at 60fps)
-        LOG_VERBOSE << "MTC poll: syncFrame=" << syncFrame << ", rolling=" << (int)rolling;
-    }
+    LOG_VERBOSE_EVERY(1000) << "MTC poll: syncFrame=" << syncFrame << ", rolling=" << (int)rolling;
     
     // Log MTC status changes
     if (rolling != 0 && !wasRolling_) {
@@ -121,8 +638,8 @@ void LayerPlayback::updateFromSyncSource() {
     }
     
     // Also log when we have a frame but not rolling (for debugging)
-    if (syncFrame >= 0 && rolling == 0 && debugCounter_ % 300 == 0) {
-        LOG_VERBOSE << "MTC: Has frame " << syncFrame << " but not rolling (waiting for MTC to start)";
+    if (syncFrame >= 0 && rolling == 0) {
+        LOG_VERBOSE_EVERY(5000) << "MTC: Has frame " << syncFrame << " but not rolling (waiting for MTC to start)";
     }
     
     // Automatically start playing when MTC is rolling (rolling != 0)
@@ -177,40 +694,17 @@ void LayerPlayback::updateFromSyncSource() {
     
     // Process frame updates only if we have a valid frame
     if (syncFrame >= 0) {
-        // Apply time-scaling: multiply by timescale, then add offset
-        // Note: Framerate conversion is handled by FramerateConverterSyncSource wrapper
-        // LayerPlayback doesn't need to know about framerate conversion
-        int64_t adjustedFrame = static_cast<int64_t>(std::floor(static_cast<double>(syncFrame) * timeScale_)) + timeOffset_;
-        
-        // Clamp frame to valid range (no automatic wrapping - use loop instead)
-        if (inputSource_) {
-            FrameInfo info = inputSource_->getFrameInfo();
-            int64_t totalFrames = info.totalFrames;
-            
-            if (totalFrames > 0) {
-                // Clamp to valid range instead of wrapping
-                // Only log once to avoid flooding output
-                if (adjustedFrame >= totalFrames) {
-                    if (!loggedExceededDuration_) {
-                        LOG_INFO << "Frame " << adjustedFrame << " exceeds video duration (" << totalFrames << "), clamping to " << (totalFrames - 1) << " (will not log again)";
-                        loggedExceededDuration_ = true;
-                    }
-                    adjustedFrame = totalFrames - 1;
-                } else if (adjustedFrame < 0) {
-                    LOG_VERBOSE << "Frame " << adjustedFrame << " is negative, clamping to 0";
-                    adjustedFrame = 0;
-                    loggedExceededDuration_ = false; // Reset since we're back in valid range
-                } else {
-                    // Frame is in valid range, reset the flag
-                    loggedExceededDuration_ = false;
-                }
-            }
-        }
+        int64_t adjustedFrame = toLayerFrame(syncFrame);
         
         // Check if a full frame SYSEX was received (indicates explicit position command)
         // Full frames require immediate seek/update regardless of frame number change
         // This works with any SyncSource (including FramerateConverterSyncSource wrapper)
         bool fullFrameReceived = syncSource_->wasFullFrameReceived();
+        if (locatePending_) {
+            // Pushed to every layer; the flag above only reaches the first one to ask
+            fullFrameReceived = true;
+            locatePending_ = false;
+        }
         if (fullFrameReceived) {
             LOG_INFO << "MTC: Full frame SYSEX received - forcing seek to frame " << adjustedFrame;
         }
@@ -223,62 +717,8 @@ void LayerPlayback::updateFromSyncSource() {
         // However, full SYSEX frames are explicit position commands and must always seek
         // even if the frame number is the same (e.g., 00:00:00:00 to reset position)
         if (adjustedFrame != lastSyncFrame_ || fullFrameReceived) {
-            // Track vsync count when frames change (for micro-jump diagnosis)
-            static int64_t vsyncCount = 0;
-            static int64_t lastFrameChangeVsync = 0;
-            static int64_t lastVideoFrame = -1;
-            vsyncCount++;
-            
-            if (fullFrameReceived) {
-                // Full frame received - force a seek first, then load
-                // This ensures we jump to the exact position even if frame number is same
-                // Reset seek state to bypass codec optimizations (needed for H264 with indexing)
-                LOG_VERBOSE << "MTC: Full frame - forcing seek to frame " << adjustedFrame;
-                if (inputSource_) {
-                    inputSource_->resetSeekState();  // Force actual seek even if same frame
-                }
-                if (inputSource_ && inputSource_->seek(adjustedFrame)) {
-                    if (loadFrame(adjustedFrame)) {
-                        currentFrame_ = adjustedFrame;
-                        lastSyncFrame_ = adjustedFrame;
-                    } else {
-                        LOG_WARNING << "Failed to load frame " << adjustedFrame << " after full frame seek";
-                    }
-                } else {
-                    LOG_WARNING << "Failed to seek to frame " << adjustedFrame << " for full frame update";
-                }
-            } else if (loadFrame(adjustedFrame)) {
-                // Normal update - loadFrame() handles seek optimization internally
-                // (no seek for consecutive frames, seeks for backwards/non-consecutive)
-                currentFrame_ = adjustedFrame;
-                lastSyncFrame_ = adjustedFrame;
-                
-                // Log frame display duration (vsyncs since last frame change)
-                // With MTC interpolation at 60Hz, we get a new frame number every vsync,
-                // so 1 vsync per frame is normal and expected for smooth playback.
-                // Only log if something truly unusual happens (like stuck on same frame for many vsyncs)
-                int64_t vsyncsSinceLast = vsyncCount - lastFrameChangeVsync;
-                if (lastVideoFrame >= 0 && vsyncsSinceLast > 4) {
-                    // Only warn if frame was held for more than 4 vsyncs (>66ms - likely stall)
-                    LOG_WARNING << "Frame pacing: frame " << lastVideoFrame << " held for " 
-                                << vsyncsSinceLast << " vsyncs (possible stall)";
-                }
-                lastFrameChangeVsync = vsyncCount;
-                lastVideoFrame = adjustedFrame;
-            } else {
-                // If load fails, try seeking first (helps with keyframe-based codecs)
-                LOG_WARNING << "Failed to load frame " << adjustedFrame << ", trying seek first";
-                if (inputSource_ && inputSource_->seek(adjustedFrame)) {
-                    if (loadFrame(adjustedFrame)) {
-                        currentFrame_ = adjustedFrame;
-                        lastSyncFrame_ = adjustedFrame;
-                    } else {
-                        LOG_WARNING << "Failed to load frame " << adjustedFrame << " even after seek";
-                    }
-                } else {
-                    LOG_WARNING << "Failed to seek to frame " << adjustedFrame;
-                }
-            }
+            pendingFrame_ = adjustedFrame;
+            pendingLoad_ = fullFrameReceived ? PendingLoad::LOCATE : PendingLoad::FRAME;
         }
     } else {
         // No valid sync frame yet (MTC not received or not rolling)
@@ -287,28 +727,258 @@ void LayerPlayback::updateFromSyncSource() {
         if (inputSource_ && currentFrame_ < 0) {
             // Only load frame 0 once if we haven't loaded any frame yet
             // This ensures video is visible even when waiting for MTC
-            if (loadFrame(0)) {
-                currentFrame_ = 0;
-                LOG_INFO << "Loaded frame 0 as fallback (waiting for MTC)";
-                // Keep lastSyncFrame_ as -1 so we reload when MTC arrives
+            pendingFrame_ = 0;
+            pendingLoad_ = PendingLoad::FALLBACK;
+        }
+    }
+}
+
+int64_t LayerPlayback::toLayerFrame(int64_t syncFrame) {
+    // Apply time-scaling: multiply by timescale, then add offset
+    // Note: Framerate conversion is handled by FramerateConverterSyncSource wrapper
+    // LayerPlayback doesn't need to know about framerate conversion
+    int64_t adjustedFrame = static_cast<int64_t>(std::floor(static_cast<double>(syncFrame) * timeScale_)) + timeOffset_;
+    
+    // Clamp frame to valid range (no automatic wrapping - use loop instead)
+    if (inputSource_) {
+        FrameInfo info = inputSource_->getFrameInfo();
+        int64_t totalFrames = info.totalFrames;
+        
+        if (totalFrames > 0) {
+            // Clamp to valid range instead of wrapping
+            // Only log once to avoid flooding output
+            if (adjustedFrame >= totalFrames) {
+                if (!loggedExceededDuration_) {
+                    LOG_INFO << "Frame " << adjustedFrame << " exceeds video duration (" << totalFrames << "), clamping to " << (totalFrames - 1) << " (will not log again)";
+                    loggedExceededDuration_ = true;
+                }
+                adjustedFrame = totalFrames - 1;
+            } else if (adjustedFrame < 0) {
+                LOG_VERBOSE << "Frame " << adjustedFrame << " is negative, clamping to 0";
+                adjustedFrame = 0;
+                loggedExceededDuration_ = false; // Reset since we're back in valid range
             } else {
-                LOG_WARNING << "Failed to load frame 0 as fallback";
+                // Frame is in valid range, reset the flag
+                loggedExceededDuration_ = false;
             }
         }
     }
+    
+    // Load governor: every n-th frame only
+    if (rateDivisor_ > 1 && adjustedFrame > 0) {
+        adjustedFrame -= adjustedFrame % rateDivisor_;
+    }
+    return adjustedFrame;
+}
+
+bool LayerPlayback::latchSync() {
+    if (!isReady() || armed_ || seekThread_ || incomingSource_ || loadSuspended_ || locatePending_ ||
+        !mtcFollow_ || !syncSource_ || !syncSource_->isConnected()) {
+        return false;
+    }
+    uint8_t rolling = 0;
+    int64_t syncFrame = syncSource_->pollFrame(&rolling);
+    if (syncFrame < 0 || rolling == 0) {
+        return false;
+    }
+    int64_t frame = toLayerFrame(syncFrame);
+    if (frame == lastSyncFrame_) {
+        return false;
+    }
+    
+    // Only a frame that is already decoded: a decode here would delay the draw
+    VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get());
+    if (!isPreloaded(frame) && !(videoInput && videoInput->hasQueuedFrame(frame))) {
+        return false;
+    }
+    if (!loadFrame(frame)) {
+        return false;   // The next update seeks if it has to
+    }
+    currentFrame_ = frame;
+    lastSyncFrame_ = frame;
+    lastFrameChangeVsync_ = vsyncCount_;
+    lastVideoFrame_ = frame;
+    return true;
+}
+
+void LayerPlayback::onTransportEvent(const TransportEvent& event) {
+    if (event.kind == TransportEvent::Kind::START || !mtcFollow_ || armed_) {
+        // Starting rolls on from the located frame; armed layers ignore sync
+        return;
+    }
+    LOG_VERBOSE << "Transport " << (event.kind == TransportEvent::Kind::LOCATE ? "locate" : "stop")
+                << " at sync frame " << event.frame << " - seeking on the next poll";
+    locatePending_ = true;
+}
+
+void LayerPlayback::setLoadSuspended(bool suspended) {
+    if (loadSuspended_ && !suspended && skippedWhileSuspended_) {
+        // Shown again: the frame on screen is stale even if sync stood still
+        lastSyncFrame_ = -1;
+        skippedWhileSuspended_ = false;
+    }
+    loadSuspended_ = suspended;
+}
+
+void LayerPlayback::loadPendingFrame() {
+    PendingLoad load = pendingLoad_;
+    int64_t adjustedFrame = pendingFrame_;
+    pendingLoad_ = PendingLoad::NONE;
+    
+    if (load == PendingLoad::NONE) {
+        return;
+    }
+    
+    if (loadSuspended_ && load == PendingLoad::FRAME) {
+        // Hidden: keep the position (loops and end handling use it), skip the decode
+        currentFrame_ = adjustedFrame;
+        lastSyncFrame_ = adjustedFrame;
+        skippedWhileSuspended_ = true;
+        return;
+    }
+    
+    if (load == PendingLoad::FALLBACK) {
+        if (loadFrame(0)) {
+            currentFrame_ = 0;
+            LOG_INFO << "Loaded frame 0 as fallback (waiting for MTC)";
+            // Keep lastSyncFrame_ as -1 so we reload when MTC arrives
+        } else {
+            LOG_WARNING << "Failed to load frame 0 as fallback";
+        }
+        return;
+    }
+    
+    // Track vsync count when frames change (for micro-jump diagnosis)
+    vsyncCount_++;
+    
+    if (load == PendingLoad::LOCATE) {
+        // Full frame received - force a seek first, then load
+        // This ensures we jump to the exact position even if frame number is same
+        // Reset seek state to bypass codec optimizations (needed for H264 with indexing)
+        LOG_VERBOSE << "MTC: Full frame - forcing seek to frame " << adjustedFrame;
+        if (isPreloaded(adjustedFrame) && loadFrame(adjustedFrame)) {
+            // Locate to a prefetched cue or cached frame: no decoder seek on the render thread
+            currentFrame_ = adjustedFrame;
+            lastSyncFrame_ = adjustedFrame;
+        } else {
+            if (inputSource_) {
+                inputSource_->resetSeekState();  // Force actual seek even if same frame
+            }
+            if (inputSource_ && inputSource_->seek(adjustedFrame)) {
+                if (loadFrame(adjustedFrame)) {
+                    currentFrame_ = adjustedFrame;
+                    lastSyncFrame_ = adjustedFrame;
+                } else {
+                    LOG_WARNING << "Failed to load frame " << adjustedFrame << " after full frame seek";
+                }
+            } else {
+                LOG_WARNING << "Failed to seek to frame " << adjustedFrame << " for full frame update";
+            }
+        }
+    } else if (loadFrame(adjustedFrame)) {
+        // Normal update - loadFrame() handles seek optimization internally
+        // (no seek for consecutive frames, seeks for backwards/non-consecutive)
+        currentFrame_ = adjustedFrame;
+        lastSyncFrame_ = adjustedFrame;
+        
+        // Log frame display duration (vsyncs since last frame change)
+        // With MTC interpolation at 60Hz, we get a new frame number every vsync,
+        // so 1 vsync per frame is normal and expected for smooth playback.
+        // Only log if something truly unusual happens (like stuck on same frame for many vsyncs)
+        int64_t vsyncsSinceLast = vsyncCount_ - lastFrameChangeVsync_;
+        if (lastVideoFrame_ >= 0 && vsyncsSinceLast > 4) {
+            // Only warn if frame was held for more than 4 vsyncs (>66ms - likely stall)
+            LOG_WARNING_EVERY(1000) << "Frame pacing: frame " << lastVideoFrame_ << " held for " 
+                        << vsyncsSinceLast << " vsyncs (possible stall)";
+        }
+        lastFrameChangeVsync_ = vsyncCount_;
+        lastVideoFrame_ = adjustedFrame;
+    } else {
+        // If load fails, try seeking first (helps with keyframe-based codecs)
+        LOG_WARNING_EVERY(1000) << "Failed to load frame " << adjustedFrame << ", trying seek first";
+        if (inputSource_ && inputSource_->seek(adjustedFrame)) {
+            if (loadFrame(adjustedFrame)) {
+                currentFrame_ = adjustedFrame;
+                lastSyncFrame_ = adjustedFrame;
+            } else {
+                LOG_WARNING_EVERY(1000) << "Failed to load frame " << adjustedFrame << " even after seek";
+            }
+        } else {
+            LOG_WARNING_EVERY(1000) << "Failed to seek to frame " << adjustedFrame;
+        }
+    }
 }
 
 bool LayerPlayback::loadFrame(int64_t frameNumber) {
+    // Static sources show the same frame for every position: no reload, and
+    // an unchanged generation keeps the texture and the canvas as they are
+    if (staticFrameLoaded_) {
+        return true;
+    }
+    if (loadLoopCacheFrame(frameNumber)) {
+        return true;
+    }
+    FRAME_TRACE_SCOPE("decode", frameNumber);
+    auto loadStart = std::chrono::steady_clock::now();
+    bool loaded = loadFrameContent(frameNumber);
+    loadTime_ += 0.1 * (std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count() - loadTime_);
+    if (!loaded) {
+        return false;
+    }
+    loopFrame_.reset();  // No longer viewed by gpuFrameBuffer_
+    staticFrameLoaded_ = inputSource_->isStatic();
+    frameGeneration_++;
+    loadedFrame_ = frameNumber;
+    return true;
+}
+
+bool LayerPlayback::loadLoopCacheFrame(int64_t frameNumber) {
+    std::shared_ptr<const GPUTextureFrameBuffer> cached = loopCache_ ? loopCache_->find(frameNumber) : nullptr;
+    if (!cached) {
+        return false;
+    }
+    // A view: the cache, or loopFrame_ after an eviction, owns the textures
+    gpuFrameBuffer_ = *cached;
+    loopFrame_ = std::move(cached);
+    frameOnGPU_ = true;
+    ringFrame_.reset();
+    frameGeneration_++;
+    loadedFrame_ = frameNumber;
+    return true;
+}
+
+bool LayerPlayback::isPreloaded(int64_t frameNumber) const {
+    return (cuePrefetcher_ && cuePrefetcher_->hasFrame(frameNumber)) ||
+           (loopCache_ && loopCache_->has(frameNumber));
+}
+
+bool LayerPlayback::loadFrameContent(int64_t frameNumber) {
     if (!inputSource_ || !inputSource_->isReady()) {
         return false;
     }
 
     // Check if this is a live stream (NDI, V4L2, RTSP, etc.)
     if (inputSource_->isLiveStream()) {
+#ifdef HAVE_V4L2
+        // V4L2 capture buffers imported as textures (no upload)
+        V4L2VideoInput* v4l2Input = dynamic_cast<V4L2VideoInput*>(inputSource_.get());
+        if (v4l2Input && v4l2Input->hasDmaBufImport()) {
+            if (v4l2Input->readLatestFrameToTexture(gpuFrameBuffer_)) {
+                frameOnGPU_ = true;
+                ringFrame_.reset();
+                return true;
+            }
+            if (v4l2Input->hasDmaBufImport()) {
+                return false;  // No new frame
+            }
+            // Import failed: the frame is read from memory below
+        }
+#endif
         // Live streams: get latest available frame (ignore frameNumber)
         // The async buffer in LiveInputSource keeps frames ready
         if (inputSource_->readLatestFrame(cpuFrameBuffer_)) {
             frameOnGPU_ = false;
+            ringFrame_.reset();
             return true;
         }
         return false;
@@ -318,9 +988,18 @@ bool LayerPlayback::loadFrame(int64_t frameNumber) {
     HAPVideoInput* hapInput = dynamic_cast<HAPVideoInput*>(inputSource_.get());
     if (hapInput) {
 #ifdef ENABLE_HAP_DIRECT
-        // HAP with direct texture upload: decode directly to compressed DXT GPU texture
+        // HAP with direct texture upload: decode directly to compressed DXT GPU texture.
+        // The frame is due one source frame period from now (faster layers first).
+        double fps = hapInput->getFrameInfo().framerate * std::max(1.0, std::fabs(timeScale_));
+        auto deadline = HapChunkPool::Clock::now();
+        if (fps > 0.0) {
+            deadline += std::chrono::duration_cast<HapChunkPool::Clock::duration>(
+                std::chrono::duration<double>(1.0 / fps));
+        }
+        hapInput->setDecodeDeadline(deadline);
         if (hapInput->readFrameToTexture(frameNumber, gpuFrameBuffer_)) {
             frameOnGPU_ = true;
+            ringFrame_.reset();
             return true;
         }
         // If direct upload fails, fall through to FFmpeg fallback (handled in readFrameToTexture)
@@ -330,6 +1009,7 @@ bool LayerPlayback::loadFrame(int64_t frameNumber) {
         // HAP without direct upload: decode to CPU buffer as RGBA (FFmpeg fallback)
         if (hapInput->readFrame(frameNumber, cpuFrameBuffer_)) {
             frameOnGPU_ = false;
+            ringFrame_.reset();
             return true;
         }
         return false;
@@ -337,22 +1017,37 @@ bool LayerPlayback::loadFrame(int64_t frameNumber) {
     }
     
     bool success = false;
-    static bool loggedBackend = false;  // Log decode backend once
+    static std::atomic<bool> loggedBackend{false};  // Log decode backend once (any layer)
     
     // Check if this is VideoFileInput with hardware decoding
     VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get());
+    if (videoInput && cuePrefetcher_ && loadPrefetchedFrame(videoInput, frameNumber)) {
+        frameOnGPU_ = false;
+        ringFrame_.reset();
+        return true;
+    }
     if (videoInput) {
+        // Backward playback is served from GOP segments decoded forward
+        videoInput->setReversePlayback(timeScale_ < 0.0);
+
+        // Fast forward or reduced rate: frames between the displayed ones
+        // need not be decoded
+        int64_t step = 1;
+        if ((timeScale_ > 1.0 || rateDivisor_ > 1) && currentFrame_ >= 0 && frameNumber > currentFrame_) {
+            step = frameNumber - currentFrame_;
+        }
+        videoInput->setPlaybackStep(step);
+
         // Check if hardware decoding is available and should be used
         InputSource::DecodeBackend backend = videoInput->getOptimalBackend();
         
         // Log the decode backend once at startup
-        if (!loggedBackend) {
+        if (!loggedBackend.exchange(true)) {
             if (backend == InputSource::DecodeBackend::GPU_HARDWARE) {
                 LOG_INFO << "Decode path: GPU_HARDWARE (VAAPI zero-copy)";
             } else {
                 LOG_INFO << "Decode path: CPU_SOFTWARE";
             }
-            loggedBackend = true;
         }
         
         if (backend == InputSource::DecodeBackend::GPU_HARDWARE) {
@@ -360,6 +1055,7 @@ bool LayerPlayback::loadFrame(int64_t frameNumber) {
             if (videoInput->readFrameToTexture(frameNumber, gpuFrameBuffer_)) {
                 frameOnGPU_ = true;
                 success = true;
+                ringFrame_.reset();
             } else {
                 // If hardware decoding fails, fall through to software decoding
                 LOG_WARNING << "Hardware decoding failed for frame " << frameNumber << ", falling back to software";
@@ -367,10 +1063,36 @@ bool LayerPlayback::loadFrame(int64_t frameNumber) {
         }
         
         if (!success) {
-            // Software decoding: use CPU frame buffer
-            if (videoInput->readFrame(frameNumber, cpuFrameBuffer_)) {
+            // Software decoding: planar YUV for GPU conversion, or BGRA
+            // straight into a mapped PBO slot when the renderer has attached
+            // one, otherwise into the CPU buffer
+            videoInput->setPlanarOutputAllowed(planarOutputAllowed_);
+            bool planar = videoInput->producesPlanarFrames();
+            bool shared = !planar && !sharedMediaPath_.empty() &&
+                          SharedMediaRegistry::instance().isShared(sharedMediaPath_);
+            // Convert only the crop/panorama window, unless other layers show the frame too
+            videoInput->setSourceWindow(shared ? FrameWindow() : sourceWindow_);
+            if (shared) {
+                // Same file on other layers: one decode per frame, shared BGRA buffers
+                if (loadSharedFrame(videoInput, frameNumber)) {
+                    frameOnGPU_ = false;
+                    ringFrame_.reset();
+                    return true;
+                }
+                return false;
+            }
+            if (cpuFrameBuffer_.isShared()) {
+                cpuFrameBuffer_.release();  // Never decode into another layer's frame
+            }
+            MappedFrameRing::Handle slot;
+            if (!planar) {
+                slot = frameRing_->acquire(videoInput->getOutputInfo());
+            }
+            FrameBuffer& target = slot ? slot->buffer : cpuFrameBuffer_;
+            if (videoInput->readFrame(frameNumber, target)) {
                 frameOnGPU_ = false;
                 success = true;
+                ringFrame_ = std::move(slot);
             }
         }
     } else {
@@ -378,12 +1100,60 @@ bool LayerPlayback::loadFrame(int64_t frameNumber) {
         if (inputSource_->readFrame(frameNumber, cpuFrameBuffer_)) {
             frameOnGPU_ = false;
             success = true;
+            ringFrame_.reset();
         }
     }
     
     return success;
 }
 
+bool LayerPlayback::loadPrefetchedFrame(VideoFileInput* videoInput, int64_t frameNumber) {
+    cuePrefetcher_->setPlayhead(frameNumber);
+    
+    bool feeding = cuePrefetcher_->isFeeding();
+    if (feeding && videoInput->hasQueuedFrame(frameNumber)) {
+        // Hardware queue has caught up behind the feed - hand playback back
+        cuePrefetcher_->release();
+        return false;
+    }
+    
+    if (!cuePrefetcher_->take(frameNumber, cpuFrameBuffer_)) {
+        return false;
+    }
+    
+    if (!feeding) {
+        // Fresh cue locate: reposition the hardware queue (if any) just past
+        // the frames the feed already has in flight
+        videoInput->prepareSeek(frameNumber + static_cast<int64_t>(CuePrefetcher::FEED_AHEAD));
+    }
+    return true;
+}
+
+bool LayerPlayback::canLoadOffRenderThread() const {
+    if (!inputSource_ || inputSource_->isLiveStream()) {
+        return true;
+    }
+    
+    // Loop cache textures are released on the render thread
+    if (loopFrame_ || (loopCache_ && loopCache_->isComplete())) {
+        return false;
+    }
+    
+#ifdef ENABLE_HAP_DIRECT
+    // Direct HAP decode uploads compressed textures (GL context)
+    if (dynamic_cast<HAPVideoInput*>(inputSource_.get())) {
+        return false;
+    }
+#endif
+    
+    // Hardware decode imports surfaces into GL textures (EGL/GL context)
+    VideoFileInput* videoInput = dynamic_cast<VideoFileInput*>(inputSource_.get());
+    if (videoInput && videoInput->getOptimalBackend() == InputSource::DecodeBackend::GPU_HARDWARE) {
+        return false;
+    }
+    return true;
+}
+
 bool LayerPlayback::getFrameBuffer(const FrameBuffer*& cpuBuffer, const GPUTextureFrameBuffer*& gpuBuffer) const {
     if (frameOnGPU_) {
         // Frame is on GPU - return pointer to GPU buffer
@@ -391,8 +1161,8 @@ bool LayerPlayback::getFrameBuffer(const FrameBuffer*& cpuBuffer, const GPUTextu
         cpuBuffer = nullptr;
         return true; // true = on GPU
     } else {
-        // Frame is on CPU - return pointer to CPU buffer
-        cpuBuffer = &cpuFrameBuffer_;
+        // Frame is on CPU - return pointer to CPU buffer (or mapped slot)
+        cpuBuffer = ringFrame_ ? &ringFrame_->buffer : &cpuFrameBuffer_;
         gpuBuffer = nullptr;
         return false; // false = on CPU
     }
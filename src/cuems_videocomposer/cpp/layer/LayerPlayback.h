@@ -5,11 +5,20 @@
 #include "../sync/SyncSource.h"
 #include "../video/FrameBuffer.h"
 #include "../video/GPUTextureFrameBuffer.h"
+#include "../video/MappedFrameRing.h"
+#include "../video/LoopFrameCache.h"
+#include <atomic>
 #include <memory>
+#include <string>
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 namespace videocomposer {
 
+class CuePrefetcher;
+class VideoFileInput;
+
 /**
  * LayerPlayback - Handles sync and frame loading for a layer
  * 
@@ -31,6 +40,20 @@ public:
     void setInputSource(std::unique_ptr<InputSource> input);
     void setSyncSource(std::unique_ptr<SyncSource> sync);
     
+    // Gapless swap: the current source keeps playing while a helper thread
+    // decodes the incoming one at a frame a little ahead of sync; when sync
+    // reaches that frame the incoming source (and its sync, if given) takes
+    // over with the frame already loaded. Without a ready source this is
+    // setInputSource(). keyframeAligned moves the takeover (while rolling
+    // forward) to the next keyframe of the incoming file within
+    // INCOMING_MAX_LEAD, so the new decoder starts on a GOP boundary.
+    void setIncomingSource(std::unique_ptr<InputSource> input, std::unique_ptr<SyncSource> sync,
+                           bool keyframeAligned = false);
+    bool hasIncomingSource() const { return incomingSource_ != nullptr; }
+    
+    // True once after the incoming source took over (frame info may differ)
+    bool takeSourceSwapped();
+    
     InputSource* getInputSource() const { return inputSource_.get(); }
     SyncSource* getSyncSource() const { return syncSource_.get(); }
 
@@ -42,10 +65,78 @@ public:
     bool seek(int64_t frameNumber);
     int64_t getCurrentFrame() const { return currentFrame_; }
     
+    // What the layer shows while an asynchronous seek is in flight
+    enum class SeekPlaceholder {
+        HOLD,   // The current frame
+        BLANK   // Nothing (the layer is hidden, see VideoLayer::seekAsync)
+    };
+    
+    // Asynchronous seek: returns at once, the current frame stays on screen
+    // while a helper thread seeks the input and decodes frameNumber; the
+    // first pollSync() after that takes the frame over (sync and loading
+    // pause meanwhile). A new request replaces one in flight (once the
+    // frame being decoded is done). Pre-decoded cue frames are taken now.
+    bool seekAsync(int64_t frameNumber);
+    bool isSeeking() const { return seekThread_ != nullptr; }
+    
+    struct SeekCompletion {
+        int64_t frame = -1;
+        bool loaded = false;   // false = the target could not be decoded
+    };
+    
+    // True once per finished asynchronous seek
+    bool takeSeekCompletion(SeekCompletion& completion);
+    
+    // Bumped whenever a frame is loaded (lets renderers skip unchanged layers)
+    uint64_t getFrameGeneration() const { return frameGeneration_; }
+    
+    // Frame number of the image last loaded (-1 = none yet)
+    int64_t getLoadedFrame() const { return loadedFrame_; }
+    
+    // The loaded frame comes from a static source and will not change
+    bool hasStaticFrame() const { return staticFrameLoaded_; }
+    
+    // Follow sync without loading frames (layer not visible); the current
+    // frame is loaded again when resumed
+    void setLoadSuspended(bool suspended);
+    
+    // Standby: load frameNumber once (seeked and decoded, decode-ahead
+    // running) and ignore sync until go(), which resumes following sync
+    // from that frame. Survives setInputSource() so a cue can be armed
+    // while its file is still loading.
+    void arm(int64_t frameNumber);
+    void go();
+    bool isArmed() const { return armed_; }
+    int64_t getArmedFrame() const { return armedFrame_; }
+    
+    // Armed and the start frame is the loaded frame
+    bool isArmedFrameReady() const { return armed_ && !armLoadPending_ && currentFrame_ == armedFrame_; }
+    
     // Update playback (called from main loop)
     // Polls sync source and loads frames as needed
     void update();
     
+    // Split update for parallel layer updates (LayerManager::updateAll):
+    // pollSync() reads the (shared) sync source and decides which frame to
+    // load; loadPendingFrame() does the decode and may run on a worker
+    // thread when canLoadOffRenderThread() is true
+    void pollSync();
+    bool hasPendingLoad() const { return pendingLoad_ != PendingLoad::NONE; }
+    
+    // Transport event of the (global) sync source, pushed to every layer
+    // before pollSync(): a locate or stop makes the next pollSync() seek,
+    // which drops the decode-ahead for the old position and restarts it at
+    // the new one, so the first rolling frame is already decoded
+    void onTransportEvent(const TransportEvent& event);
+    void loadPendingFrame();
+    bool canLoadOffRenderThread() const;
+    
+    // Late latch (render thread, after update, just before the draw): the
+    // sync source is polled again and a newer frame taken if it is already
+    // decoded (prefetched, cached or queued); never decodes or seeks.
+    // Returns true if the frame changed
+    bool latchSync();
+    
     // Get frame buffer (CPU or GPU) - returns const references to avoid copies
     // Returns true if frame is on GPU, false if on CPU
     bool getFrameBuffer(const FrameBuffer*& cpuBuffer, const GPUTextureFrameBuffer*& gpuBuffer) const;
@@ -53,6 +144,17 @@ public:
     // Check if current frame is on GPU
     bool isFrameOnGPU() const { return frameOnGPU_; }
     
+    // Mapped PBO slots the renderer attaches for software decode
+    std::shared_ptr<MappedFrameRing> getFrameRing() const { return frameRing_; }
+    
+    // Allow planar YUV frames from software decode (false while the layer
+    // needs BGRA pixels on the CPU, e.g. for crop/panorama)
+    void setPlanarOutputAllowed(bool allowed) { planarOutputAllowed_ = allowed; }
+    
+    // Part of the picture the layer shows (crop/panorama): software decode
+    // converts only that to BGRA
+    void setSourceWindow(const FrameWindow& window) { sourceWindow_ = window; }
+    
     // Check if current source is HAP codec
     bool isHAPCodec() const;
     
@@ -77,6 +179,38 @@ public:
     // Reverse playback (multiplies timescale by -1.0 and adjusts offset)
     void reverse();
     
+    // Cue list for locate prefetching (sync source frames, before time-scaling)
+    // Empty list stops prefetching
+    void setCuePoints(const std::vector<int64_t>& syncFrames);
+    const std::vector<int64_t>& getCuePoints() const { return cueSyncFrames_; }
+    
+    // Loop wrap targets (input frames, e.g. a loop region's start) kept
+    // pre-decoded alongside the cues, so a wrap-around seek is served from
+    // memory. Unchanged lists are a no-op.
+    void setLoopTargets(const std::vector<int64_t>& frames);
+    
+    // GPU loop cache (see LoopFrameCache; null = none): once complete, its
+    // frames are played as they are, with no decode and no wrap-around seek
+    void setLoopCache(std::shared_ptr<LoopFrameCache> cache) { loopCache_ = std::move(cache); }
+    
+    // Decode-ahead budget share relative to other layers (1 = default)
+    void setDecodePriority(int priority);
+    int getDecodePriority() const { return decodePriority_; }
+    
+    // Hidden (occluded) layers decode ahead after the visible ones
+    void setDecodeVisible(bool visible);
+    
+    // What to show when the decoder has not delivered a frame in time
+    void setUnderrunPolicy(InputSource::UnderrunPolicy policy);
+    InputSource::UnderrunPolicy getUnderrunPolicy() const { return underrunPolicy_; }
+    
+    // Load only every n-th frame (load governor; 1 = every frame)
+    void setRateDivisor(int divisor) { rateDivisor_ = divisor > 1 ? divisor : 1; }
+    int getRateDivisor() const { return rateDivisor_; }
+    
+    // Time a frame load takes, smoothed (seconds)
+    double getLoadTime() const { return loadTime_; }
+    
     // Check if playback has reached the end
     // Returns true if playback has ended, false otherwise
     bool checkPlaybackEnd() const;
@@ -97,7 +231,6 @@ private:
     // MTC sync state (per-layer, not static!)
     bool wasRolling_;        // Previous rolling state for change detection
     int64_t lastLoggedFrame_; // Last logged frame for periodic logging
-    int debugCounter_;       // Debug counter for periodic logging
     bool loggedExceededDuration_; // True if we've logged "frame exceeded duration" message
     
     // Frame buffers (CPU and GPU)
@@ -105,9 +238,106 @@ private:
     GPUTextureFrameBuffer gpuFrameBuffer_;
     bool frameOnGPU_;     // True if current frame is in GPU buffer
     
+    // Cue prefetching (VideoFileInput only)
+    std::vector<int64_t> cueSyncFrames_;
+    std::vector<int64_t> loopFrames_;  // Input frames, not time-scaled
+    
+    // File registered with SharedMediaRegistry (empty = none)
+    std::string sharedMediaPath_;
+    std::unique_ptr<CuePrefetcher> cuePrefetcher_;
+    int64_t cueTimeOffset_;   // Time-scaling the cue frames were mapped with
+    double cueTimeScale_;
+    
+    // Frame chosen by pollSync() for loadPendingFrame()
+    enum class PendingLoad {
+        NONE,
+        FRAME,     // Frame changed - sequential or nearby load
+        LOCATE,    // Full frame SYSEX - forced seek
+        FALLBACK   // No sync yet - show frame 0
+    };
+    PendingLoad pendingLoad_;
+    int64_t pendingFrame_;
+    bool locatePending_;      // Transport located or stopped, seek on the next poll
+    
+    // Zero-copy software decode: current frame, when it lives in a ring slot
+    std::shared_ptr<MappedFrameRing> frameRing_;
+    MappedFrameRing::Handle ringFrame_;
+    
+    // Loop cache frame gpuFrameBuffer_ is a view of (kept alive here)
+    std::shared_ptr<LoopFrameCache> loopCache_;
+    std::shared_ptr<const GPUTextureFrameBuffer> loopFrame_;
+    bool planarOutputAllowed_;
+    FrameWindow sourceWindow_;
+    int decodePriority_;
+    bool decodeVisible_;
+    InputSource::UnderrunPolicy underrunPolicy_;
+    int rateDivisor_;
+    double loadTime_;
+    
+    // Frame pacing diagnostics
+    int64_t vsyncCount_;
+    int64_t lastFrameChangeVsync_;
+    int64_t lastVideoFrame_;
+    uint64_t frameGeneration_;
+    int64_t loadedFrame_;
+    bool loadSuspended_;
+    bool skippedWhileSuspended_;
+    bool staticFrameLoaded_;  // Static source (still image): its one frame is current
+    bool armed_;              // Standby at armedFrame_, sync ignored
+    int64_t armedFrame_;
+    bool armLoadPending_;     // Start frame still to be requested
+    
     // Internal methods
     void updateFromSyncSource();
+    int64_t toLayerFrame(int64_t syncFrame);   // Time-scaled, clamped, governed
     bool loadFrame(int64_t frameNumber);
+    bool loadFrameContent(int64_t frameNumber);
+    bool loadPrefetchedFrame(VideoFileInput* videoInput, int64_t frameNumber);
+    bool loadLoopCacheFrame(int64_t frameNumber);
+    bool isPreloaded(int64_t frameNumber) const;  // Cue prefetch or loop cache
+    void applyCuePoints();
+    void applyDecodePriority();
+    void applyDecodeVisible();
+    void applyUnderrunPolicy();
+    void registerSharedMedia();
+    bool loadSharedFrame(VideoFileInput* videoInput, int64_t frameNumber);
+    
+    // Incoming source (gapless swap), driven from pollSync()
+    static constexpr int64_t INCOMING_MIN_LEAD = 3;
+    static constexpr int64_t INCOMING_MAX_LEAD = 64;
+    static constexpr int INCOMING_MAX_FAILURES = 3;
+    std::unique_ptr<InputSource> incomingSource_;
+    std::unique_ptr<SyncSource> incomingSync_;
+    std::unique_ptr<std::thread> incomingThread_;  // Decodes incomingFrame_
+    FrameBuffer incomingFrame_;
+    std::atomic<bool> incomingDone_;
+    bool incomingLoaded_;        // incomingFrame_ holds incomingPrepared_
+    int64_t incomingPrepared_;   // Frame decoded (or being decoded), -1 = none
+    int64_t incomingLead_;       // Frames ahead of rolling sync to prepare
+    int incomingFailures_;
+    bool incomingKeyframeAligned_;
+    bool sourceSwapped_;
+    
+    // Asynchronous seek (seekAsync), driven from pollSync()
+    std::unique_ptr<std::thread> seekThread_;   // Seeks inputSource_ and decodes seekTarget_
+    FrameBuffer seekFrame_;
+    std::atomic<bool> seekDone_;
+    bool seekLoaded_;            // seekFrame_ holds seekTarget_ (read after join)
+    int64_t seekTarget_;
+    int64_t seekQueued_;         // Requested while one was in flight, -1 = none
+    bool seekCompleted_;
+    SeekCompletion seekCompletion_;
+    
+    void startAsyncSeek(int64_t frameNumber);
+    bool updateAsyncSeek();      // False while the seek is still running
+    void cancelAsyncSeek();
+    void completeAsyncSeek(int64_t frameNumber, bool loaded);
+    
+    void updateIncoming();
+    int64_t incomingTargetFrame(bool* rolling);
+    int64_t incomingKeyframeAtOrAfter(int64_t frame, int64_t limit) const;
+    void adoptIncoming(int64_t frameNumber);
+    void cancelIncoming();
 };
 
 } // namespace videocomposer
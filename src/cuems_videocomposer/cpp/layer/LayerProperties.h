@@ -1,7 +1,9 @@
 #ifndef VIDEOCOMPOSER_LAYERPROPERTIES_H
 #define VIDEOCOMPOSER_LAYERPROPERTIES_H
 
+#include "../video/PackedAlpha.h"
 #include <cstdint>
+#include <string>
 
 namespace videocomposer {
 
@@ -16,6 +18,7 @@ struct LayerProperties {
     float opacity = 1.0f;   // Opacity (0.0 - 1.0)
     int zOrder = 0;         // Layer stacking order
     bool visible = true;    // Show/hide layer
+    int groupId = 0;        // Layer group it composites into (0 = none, see LayerGroup)
     
     // Transform (simplified for now, can be extended)
     float scaleX = 1.0f;
@@ -44,6 +47,10 @@ struct LayerProperties {
     };
     BlendMode blendMode = NORMAL;
     
+    // Colour and alpha packed into one frame (see PackedAlpha)
+    PackedAlpha::Layout packedAlpha = PackedAlpha::Layout::NONE;
+    bool packedAlphaPremultiplied = false;  // Colour half already multiplied by alpha
+    
     // Corner deformation (warping) - 4 corners, each with x,y offset
     struct {
         float corners[8];  // [corner1x, corner1y, corner2x, corner2y, corner3x, corner3y, corner4x, corner4y]
@@ -58,11 +65,13 @@ struct LayerProperties {
         float saturation = 1.0f;   // 0.0 to 2.0 (1 = no change, 0 = grayscale)
         float hue = 0.0f;          // -180 to 180 degrees
         float gamma = 1.0f;        // 0.1 to 3.0 (1 = no change)
+        std::string lutFile;       // .cube table applied after the above ("" = none)
         
         // Check if any adjustments are active (non-default)
         bool isActive() const {
             return brightness != 0.0f || contrast != 1.0f || 
-                   saturation != 1.0f || hue != 0.0f || gamma != 1.0f;
+                   saturation != 1.0f || hue != 0.0f || gamma != 1.0f ||
+                   !lutFile.empty();
         }
         
         // Reset all to defaults
@@ -72,13 +81,53 @@ struct LayerProperties {
             saturation = 1.0f;
             hue = 0.0f;
             gamma = 1.0f;
+            lutFile.clear();
         }
     };
     ColorAdjustment colorAdjust;
     
+    // Per-layer effects (see EffectChain): key and vignette run in the
+    // layer's own draw, blur and sharpen filter a reduced-size copy first
+    struct Effects {
+        float blurRadius = 0.0f;       // Gaussian radius in source pixels (0 = off)
+        float sharpenAmount = 0.0f;    // Unsharp mask strength (0 = off, 1 = strong; blur wins)
+        float sharpenRadius = 2.0f;    // Source pixels
+        struct ChromaKey {
+            bool enabled = false;
+            float red = 0.0f;          // Key colour
+            float green = 1.0f;
+            float blue = 0.0f;
+            float similarity = 0.4f;   // Chroma distance keyed out fully
+            float smoothness = 0.08f;  // Ramp from there to opaque
+            float spill = 0.1f;        // Key colour taken out of the kept edges
+            
+            bool operator==(const ChromaKey& other) const {
+                return enabled == other.enabled && red == other.red && green == other.green &&
+                       blue == other.blue && similarity == other.similarity &&
+                       smoothness == other.smoothness && spill == other.spill;
+            }
+        } chromaKey;
+        float vignetteAmount = 0.0f;   // Darkening at the corners (0 = off, 1 = black)
+        float vignetteSoftness = 0.5f; // Falloff width (0-1)
+        
+        bool needsFilter() const { return blurRadius > 0.0f || sharpenAmount > 0.0f; }
+        bool isActive() const { return needsFilter() || chromaKey.enabled || vignetteAmount > 0.0f; }
+        
+        bool operator==(const Effects& other) const {
+            return blurRadius == other.blurRadius && sharpenAmount == other.sharpenAmount &&
+                   sharpenRadius == other.sharpenRadius && chromaKey == other.chromaKey &&
+                   vignetteAmount == other.vignetteAmount && vignetteSoftness == other.vignetteSoftness;
+        }
+        bool operator!=(const Effects& other) const { return !(*this == other); }
+    };
+    Effects effects;
+    
     // Auto-unload: automatically unload file when playback ends
     bool autoUnload = false;
     
+    // Preload: load files into RAM and play them from there (applies to the next load)
+    bool preload = false;
+    
     // Full file loop count (for wraparound)
     int fullFileLoopCount = -1;        // -1 = infinite, 0 = no loop, >0 = loop N times
     int currentFullFileLoopCount = -1; // Current loop iteration (starts at fullFileLoopCount, decrements)
@@ -92,6 +141,44 @@ struct LayerProperties {
         int currentLoopCount = -1; // Current loop iteration (starts at loopCount, decrements)
     };
     LoopRegion loopRegion;
+    
+    // Check if a layer with these properties draws the same as with `other`
+    // (ignores playback-only fields such as loops and auto-unload)
+    bool rendersSameAs(const LayerProperties& other) const {
+        if (x != other.x || y != other.y || width != other.width || height != other.height ||
+            opacity != other.opacity || zOrder != other.zOrder || visible != other.visible ||
+            scaleX != other.scaleX || scaleY != other.scaleY || rotation != other.rotation ||
+            panoramaMode != other.panoramaMode || panOffset != other.panOffset ||
+            blendMode != other.blendMode || groupId != other.groupId ||
+            packedAlpha != other.packedAlpha || packedAlphaPremultiplied != other.packedAlphaPremultiplied ||
+            effects != other.effects) {
+            return false;
+        }
+        if (crop.enabled != other.crop.enabled ||
+            (crop.enabled && (crop.x != other.crop.x || crop.y != other.crop.y ||
+                              crop.width != other.crop.width || crop.height != other.crop.height))) {
+            return false;
+        }
+        if (cornerDeform.enabled != other.cornerDeform.enabled) {
+            return false;
+        }
+        if (cornerDeform.enabled) {
+            if (cornerDeform.highQuality != other.cornerDeform.highQuality) {
+                return false;
+            }
+            for (int i = 0; i < 8; i++) {
+                if (cornerDeform.corners[i] != other.cornerDeform.corners[i]) {
+                    return false;
+                }
+            }
+        }
+        return colorAdjust.brightness == other.colorAdjust.brightness &&
+               colorAdjust.contrast == other.colorAdjust.contrast &&
+               colorAdjust.saturation == other.colorAdjust.saturation &&
+               colorAdjust.hue == other.colorAdjust.hue &&
+               colorAdjust.gamma == other.colorAdjust.gamma &&
+               colorAdjust.lutFile == other.colorAdjust.lutFile;
+    }
 };
 
 } // namespace videocomposer
@@ -0,0 +1,38 @@
+#include "LayerPropertyStore.h"
+
+namespace videocomposer {
+
+size_t LayerPropertyStore::acquire(VideoLayer* owner, const LayerProperties& initial) {
+    size_t slot;
+    if (!freeSlots_.empty()) {
+        // Lowest free slot first keeps the walked range short
+        auto lowest = freeSlots_.begin();
+        for (auto it = freeSlots_.begin(); it != freeSlots_.end(); ++it) {
+            if (*it < *lowest) {
+                lowest = it;
+            }
+        }
+        slot = *lowest;
+        freeSlots_.erase(lowest);
+        owners_[slot] = owner;
+    } else {
+        slot = owners_.size();
+        if (slot / BLOCK_SIZE >= blocks_.size()) {
+            blocks_.push_back(std::make_unique<Block>());
+        }
+        owners_.push_back(owner);
+    }
+    at(slot) = initial;
+    return slot;
+}
+
+void LayerPropertyStore::release(size_t slot) {
+    if (slot >= owners_.size() || !owners_[slot]) {
+        return;
+    }
+    owners_[slot] = nullptr;
+    at(slot) = LayerProperties();
+    freeSlots_.push_back(slot);
+}
+
+} // namespace videocomposer
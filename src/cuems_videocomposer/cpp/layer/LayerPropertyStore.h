@@ -0,0 +1,60 @@
+#ifndef VIDEOCOMPOSER_LAYERPROPERTYSTORE_H
+#define VIDEOCOMPOSER_LAYERPROPERTYSTORE_H
+
+#include "LayerProperties.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace videocomposer {
+
+class VideoLayer;
+
+/**
+ * LayerPropertyStore - Contiguous storage of the managed layers' properties
+ *
+ * Each layer in the manager gets a stable slot; its LayerProperties live in
+ * fixed-size blocks here instead of inside the heap-allocated layer, and
+ * per-slot data (owner, occupancy) sits in parallel arrays. Passes run
+ * every frame (animation, change detection) walk the slots in order
+ * rather than chasing one pointer per layer.
+ *
+ * Slots never move: a block is never reallocated, and a released slot is
+ * reused by the next layer added.
+ */
+class LayerPropertyStore {
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    /**
+     * Take a slot for a layer, initialised with its current properties
+     * @return Slot index
+     */
+    size_t acquire(VideoLayer* owner, const LayerProperties& initial);
+
+    /** Give a slot back (its properties are reset) */
+    void release(size_t slot);
+
+    LayerProperties& at(size_t slot) { return blocks_[slot / BLOCK_SIZE]->at(slot % BLOCK_SIZE); }
+    const LayerProperties& at(size_t slot) const { return blocks_[slot / BLOCK_SIZE]->at(slot % BLOCK_SIZE); }
+
+    /** Layer in a slot (nullptr = free) */
+    VideoLayer* owner(size_t slot) const { return slot < owners_.size() ? owners_[slot] : nullptr; }
+
+    /** Slots in use, and the index range to walk (free slots included) */
+    size_t size() const { return owners_.size() - freeSlots_.size(); }
+    size_t slotCount() const { return owners_.size(); }
+
+private:
+    using Block = std::array<LayerProperties, BLOCK_SIZE>;
+
+    std::vector<std::unique_ptr<Block>> blocks_;
+    std::vector<VideoLayer*> owners_;      // Indexed by slot
+    std::vector<size_t> freeSlots_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LAYERPROPERTYSTORE_H
@@ -0,0 +1,145 @@
+#include "LayerUpdateScheduler.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/FrameTracer.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+size_t LayerUpdateScheduler::defaultWorkerCount() {
+    unsigned int hw = std::thread::hardware_concurrency();
+    if (hw <= 1) {
+        return 0;
+    }
+    return std::min<size_t>(hw - 1, MAX_AUTO_WORKERS);
+}
+
+LayerUpdateScheduler::LayerUpdateScheduler(size_t workerCount, const char* name)
+    : name_(name)
+    , jobs_(nullptr)
+    , batchOpen_(false)
+    , generation_(0)
+    , activeWorkers_(0)
+    , stop_(false)
+{
+    workers_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.push_back(std::make_unique<std::thread>(&LayerUpdateScheduler::workerThreadFunc, this));
+    }
+    stats_.workers = workerCount;
+
+    LOG_INFO << "Worker pool (" << name_ << "): " << workerCount << " worker thread(s)";
+}
+
+LayerUpdateScheduler::~LayerUpdateScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCond_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->joinable()) {
+            worker->join();
+        }
+    }
+}
+
+void LayerUpdateScheduler::runJobs() {
+    const size_t count = jobs_->size();
+    for (;;) {
+        size_t index = nextJob_.fetch_add(1);
+        if (index >= count) {
+            return;
+        }
+        if (Clock::now() > deadline_) {
+            skipped_++;
+            continue;
+        }
+        (*jobs_)[index]();
+        executed_++;
+    }
+}
+
+size_t LayerUpdateScheduler::run(const std::vector<std::function<void()>>& jobs,
+                                 Clock::time_point deadline,
+                                 const std::function<void()>& renderThreadWork) {
+    if (jobs.empty()) {
+        if (renderThreadWork) {
+            renderThreadWork();
+        }
+        return 0;
+    }
+
+    auto start = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_ = &jobs;
+        deadline_ = deadline;
+        nextJob_ = 0;
+        skipped_ = 0;
+        executed_ = 0;
+        batchOpen_ = true;
+        generation_++;
+    }
+    // A single job gains nothing from a thread hop
+    if (jobs.size() > 1) {
+        workCond_.notify_all();
+    }
+
+    // GL-bound work overlaps with the workers' decodes
+    if (renderThreadWork) {
+        renderThreadWork();
+    }
+    runJobs();
+
+    // All jobs are claimed; close the batch and wait for the ones in flight
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        batchOpen_ = false;
+        doneCond_.wait(lock, [this] { return activeWorkers_ == 0; });
+        jobs_ = nullptr;
+
+        stats_.batches++;
+        stats_.jobs += executed_;
+        stats_.skipped += skipped_;
+        stats_.lastBatchMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    return skipped_;
+}
+
+LayerUpdateScheduler::Stats LayerUpdateScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void LayerUpdateScheduler::workerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::DECODE);
+    uint64_t seenGeneration = 0;
+    FrameTracer::instance().setThreadName(name_);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_) {
+        workCond_.wait(lock, [this, seenGeneration] {
+            return stop_ || generation_ != seenGeneration;
+        });
+        if (stop_) {
+            break;
+        }
+        seenGeneration = generation_;
+        if (!batchOpen_) {
+            continue;  // Woke after the batch was already finished
+        }
+
+        activeWorkers_++;
+        lock.unlock();
+        runJobs();
+        lock.lock();
+        if (--activeWorkers_ == 0) {
+            doneCond_.notify_all();
+        }
+    }
+}
+
+} // namespace videocomposer
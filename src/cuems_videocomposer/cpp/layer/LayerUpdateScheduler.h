@@ -0,0 +1,97 @@
+#ifndef VIDEOCOMPOSER_LAYERUPDATESCHEDULER_H
+#define VIDEOCOMPOSER_LAYERUPDATESCHEDULER_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * LayerUpdateScheduler - Runs the CPU-side part of layer updates in parallel
+ *
+ * LayerManager::updateAll() hands over one job per layer whose frame load
+ * does not touch the GL/EGL context (software decode, CPU HAP, live copies).
+ * A small set of persistent worker threads plus the calling (render) thread
+ * claim jobs one at a time from a shared cursor, so a layer with an
+ * expensive seek never holds back the remaining layers.
+ *
+ * Per-frame deadline: jobs still unclaimed when the deadline passes are
+ * skipped. Those layers keep their previous frame and retry on the next
+ * update. Jobs that already started always run to completion.
+ */
+class LayerUpdateScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t workers = 0;        // Worker threads (render thread not counted)
+        uint64_t batches = 0;      // run() calls with at least one job
+        uint64_t jobs = 0;         // Jobs executed
+        uint64_t skipped = 0;      // Jobs dropped by the deadline
+        double lastBatchMs = 0.0;  // Wall time of the last batch
+    };
+
+    /**
+     * @param workerCount Worker threads (0 = run every job on the calling thread)
+     * @param name Thread name in traces and logs (literal)
+     */
+    explicit LayerUpdateScheduler(size_t workerCount, const char* name = "layer update");
+    ~LayerUpdateScheduler();
+
+    /**
+     * Default worker count: one less than the hardware threads (the render
+     * thread participates), capped at MAX_AUTO_WORKERS
+     */
+    static size_t defaultWorkerCount();
+    static constexpr size_t MAX_AUTO_WORKERS = 7;
+
+    /**
+     * Run a batch of jobs and return when all claimed jobs have finished
+     * @param jobs Jobs to run (any thread)
+     * @param deadline Jobs not started by this time are skipped
+     * @param renderThreadWork Optional work that must stay on the calling
+     *                         thread; runs while workers process the batch
+     * @return Number of jobs skipped because of the deadline
+     */
+    size_t run(const std::vector<std::function<void()>>& jobs,
+               Clock::time_point deadline,
+               const std::function<void()>& renderThreadWork = nullptr);
+
+    size_t getWorkerCount() const { return workers_.size(); }
+    Stats getStats() const;
+
+private:
+    void workerThreadFunc();
+    void runJobs();
+
+    const char* name_;
+    std::vector<std::unique_ptr<std::thread>> workers_;
+
+    // Current batch (valid while batchOpen_)
+    const std::vector<std::function<void()>>* jobs_;
+    Clock::time_point deadline_;
+    std::atomic<size_t> nextJob_{0};
+    std::atomic<size_t> skipped_{0};
+    std::atomic<size_t> executed_{0};
+    bool batchOpen_;
+    uint64_t generation_;
+    size_t activeWorkers_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCond_;
+    std::condition_variable doneCond_;
+    bool stop_;
+
+    Stats stats_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LAYERUPDATESCHEDULER_H
@@ -0,0 +1,294 @@
+#include "LoadAdmission.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace videocomposer {
+
+namespace {
+
+// Bits per pixel the benchmark clips are encoded at; long-GOP files above
+// it spend more time entropy decoding (about half the decode at this rate)
+constexpr double REFERENCE_BITS_PER_PIXEL = 0.2;
+
+constexpr double DEFAULT_HARDWARE_COST = 0.0008;
+
+std::string costKey(const std::string& codec, bool hardware) {
+    return codec + (hardware ? "/hw" : "/sw");
+}
+
+// Number after "key": in a one-line JSON object (false if absent)
+bool numberField(const std::string& line, const char* key, double& value, size_t from = 0) {
+    std::string marker = "\"" + std::string(key) + "\":";
+    size_t pos = line.find(marker, from);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    const char* start = line.c_str() + pos + marker.size();
+    char* end = nullptr;
+    value = std::strtod(start, &end);
+    return end != start;
+}
+
+// String value of "key" (no escapes: codec, backend and status names)
+std::string stringField(const std::string& line, const char* key) {
+    std::string marker = "\"" + std::string(key) + "\":\"";
+    size_t pos = line.find(marker);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += marker.size();
+    size_t end = line.find('"', pos);
+    return end != std::string::npos ? line.substr(pos, end - pos) : "";
+}
+
+std::string percent(double share) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.0f%%", share * 100.0);
+    return text;
+}
+
+} // namespace
+
+LoadAdmission::LoadAdmission()
+    : gpuSecondsPerMegapixel_(DEFAULT_GPU_SECONDS_PER_MEGAPIXEL)
+{
+    // One core of a mid-range desktop; hardware decoders are about equal
+    // across the codecs they support
+    setDecodeCost("H264", false, 0.0024);
+    setDecodeCost("HEVC", false, 0.0040);
+    setDecodeCost("AV1", false, 0.0050);
+    setDecodeCost("SOFTWARE", false, 0.0030);
+    setDecodeCost("HAP", false, 0.0005);
+    setDecodeCost("HAP_Q", false, 0.0008);
+    setDecodeCost("HAP_ALPHA", false, 0.0008);
+}
+
+const char* LoadAdmission::verdictName(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::WARN: return "warn";
+        case Verdict::REJECT: return "reject";
+        case Verdict::DEGRADE: return "degrade";
+        default: return "accept";
+    }
+}
+
+LoadAdmission::Policy LoadAdmission::parsePolicy(const std::string& name) {
+    if (name == "off") return Policy::OFF;
+    if (name == "reject") return Policy::REJECT;
+    if (name == "degrade") return Policy::DEGRADE;
+    return Policy::WARN;
+}
+
+void LoadAdmission::setDecodeCost(const std::string& codec, bool hardware, double secondsPerMegapixel) {
+    if (secondsPerMegapixel > 0.0) {
+        decodeCosts_[costKey(codec, hardware)] = secondsPerMegapixel;
+    }
+}
+
+double LoadAdmission::getDecodeCost(const std::string& codec, bool hardware) const {
+    auto it = decodeCosts_.find(costKey(codec, hardware));
+    if (it != decodeCosts_.end()) {
+        return it->second;
+    }
+    if (hardware) {
+        return DEFAULT_HARDWARE_COST;
+    }
+    it = decodeCosts_.find(costKey("SOFTWARE", false));
+    return it != decodeCosts_.end() ? it->second : 0.0030;
+}
+
+int LoadAdmission::loadBenchmarkLines(const std::string& text) {
+    std::map<std::string, double> fastest;
+    double gpuCost = 0.0;
+    bool gpuAnimated = false;
+    int used = 0;
+
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        double fps = 0.0;
+        double width = 0.0;
+        double height = 0.0;
+        std::string backend = stringField(line, "backend");
+        if (!backend.empty()) {
+            // bench_decode: one file and backend
+            if (stringField(line, "status") != "ok" || !numberField(line, "fps", fps) || fps <= 0.0 ||
+                !numberField(line, "width", width) || !numberField(line, "height", height) || width * height <= 0.0) {
+                continue;
+            }
+            bool hardware = backend != "software" && backend.compare(0, 4, "hap-") != 0;
+            std::string key = costKey(stringField(line, "codec"), hardware);
+            double cost = 1.0 / (fps * width * height / 1e6);
+            auto it = fastest.find(key);
+            if (it == fastest.end() || cost < it->second) {
+                fastest[key] = cost;
+            }
+            ++used;
+            continue;
+        }
+
+        // bench_composite: one scene; animated scenes upload every layer every
+        // frame, as playing video does, so they are preferred
+        double layers = 0.0;
+        double gpuMs = 0.0;
+        std::string resolution = stringField(line, "resolution");
+        size_t gpu = line.find("\"gpu_ms\":{");
+        if (!numberField(line, "layers", layers) || layers <= 0.0 || gpu == std::string::npos ||
+            !numberField(line, "avg", gpuMs, gpu) || gpuMs <= 0.0 ||
+            std::sscanf(resolution.c_str(), "%lfx%lf", &width, &height) != 2 || width * height <= 0.0) {
+            continue;
+        }
+        bool animated = line.find("\"animated\":true") != std::string::npos;
+        double cost = gpuMs / 1000.0 / (layers * width * height / 1e6);
+        if ((animated && !gpuAnimated) || (animated == gpuAnimated && cost > gpuCost)) {
+            gpuCost = cost;  // The most demanding scene: admission errs on the safe side
+            gpuAnimated = animated;
+        }
+        ++used;
+    }
+
+    for (const auto& entry : fastest) {
+        decodeCosts_[entry.first] = entry.second;
+    }
+    if (gpuCost > 0.0) {
+        gpuSecondsPerMegapixel_ = gpuCost;
+    }
+    return used;
+}
+
+bool LoadAdmission::loadBenchmarkFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_WARNING << "LoadAdmission: Cannot read benchmark results " << path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    int used = loadBenchmarkLines(text.str());
+    LOG_INFO << "LoadAdmission: " << used << " benchmark result(s) from " << path;
+    return used > 0;
+}
+
+LoadAdmission::Load LoadAdmission::predict(const MediaProfile& media) const {
+    Load load;
+    double megapixels = static_cast<double>(media.width) * media.height / 1e6;
+    if (megapixels <= 0.0) {
+        return load;
+    }
+    double frameSeconds = megapixels * getDecodeCost(media.codec, media.hardware);
+    if (media.gopLength > 1 && media.peakBitrate > 0 && media.framerate > 0.0) {
+        double bitsPerPixel = media.peakBitrate / (megapixels * 1e6 * media.framerate);
+        frameSeconds *= 0.5 + 0.5 * std::max(1.0, bitsPerPixel / REFERENCE_BITS_PER_PIXEL);
+    }
+
+    double decode = std::max(0.0, media.framerate) * frameSeconds;
+    if (media.hardware) {
+        load.hardware = decode;
+    } else {
+        int threads = settings_.cpuThreads > 0 ? settings_.cpuThreads
+                                               : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        load.cpu = decode / threads;
+    }
+    load.gpu = settings_.outputHz * megapixels * gpuSecondsPerMegapixel_;
+    load.seekSeconds = std::max(1, media.gopLength) * frameSeconds;
+    return load;
+}
+
+LoadAdmission::Load LoadAdmission::scaled(const Load& load, double factor) {
+    Load result = load;
+    result.cpu *= factor;
+    result.hardware *= factor;
+    return result;  // Still composited every output frame
+}
+
+LoadAdmission::Load LoadAdmission::totalExcept(const std::string& cueId) const {
+    Load total;
+    for (const auto& entry : admitted_) {
+        if (entry.first == cueId) {
+            continue;
+        }
+        total.cpu += entry.second.cpu;
+        total.hardware += entry.second.hardware;
+        total.gpu += entry.second.gpu;
+        total.seekSeconds = std::max(total.seekSeconds, entry.second.seekSeconds);
+    }
+    return total;
+}
+
+LoadAdmission::Load LoadAdmission::getTotal() const {
+    return totalExcept(std::string());
+}
+
+bool LoadAdmission::fits(const Load& total) const {
+    return total.cpu <= settings_.headroom && total.hardware <= settings_.headroom &&
+           total.gpu <= settings_.headroom;
+}
+
+std::string LoadAdmission::describe(const Load& total) const {
+    std::string over;
+    auto add = [&](const char* name, double share) {
+        if (share > settings_.headroom) {
+            over += (over.empty() ? "" : ", ") + std::string(name) + " " + percent(share);
+        }
+    };
+    add("cpu decode", total.cpu);
+    add("hardware decode", total.hardware);
+    add("gpu", total.gpu);
+    return over.empty() ? "within headroom" : over + " (headroom " + percent(settings_.headroom) + ")";
+}
+
+LoadAdmission::Decision LoadAdmission::admit(const std::string& cueId, const MediaProfile& media) {
+    Decision decision;
+    if (settings_.policy == Policy::OFF) {
+        return decision;
+    }
+
+    auto combine = [this, &cueId](const Load& cue) {
+        Load total = totalExcept(cueId);
+        total.cpu += cue.cpu;
+        total.hardware += cue.hardware;
+        total.gpu += cue.gpu;
+        total.seekSeconds = std::max(total.seekSeconds, cue.seekSeconds);
+        return total;
+    };
+    decision.cue = predict(media);
+    decision.total = combine(decision.cue);
+    decision.reason = describe(decision.total);
+
+    if (!fits(decision.total)) {
+        switch (settings_.policy) {
+            case Policy::REJECT:
+                decision.verdict = Verdict::REJECT;
+                return decision;  // A file it replaces keeps its share
+            case Policy::DEGRADE:
+                decision.verdict = Verdict::DEGRADE;
+                decision.cue = scaled(decision.cue, 0.5);
+                decision.total = combine(decision.cue);
+                decision.reason = fits(decision.total) ? "half rate fits" : "still over at half rate: " +
+                                                                            describe(decision.total);
+                break;
+            default:
+                decision.verdict = Verdict::WARN;
+                break;
+        }
+    }
+    admitted_[cueId] = decision.cue;
+    return decision;
+}
+
+void LoadAdmission::release(const std::string& cueId) {
+    admitted_.erase(cueId);
+}
+
+void LoadAdmission::prune(const std::function<bool(const std::string&)>& isLive) {
+    for (auto it = admitted_.begin(); it != admitted_.end();) {
+        it = isLive(it->first) ? std::next(it) : admitted_.erase(it);
+    }
+}
+
+} // namespace videocomposer
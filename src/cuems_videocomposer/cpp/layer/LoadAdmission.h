@@ -0,0 +1,140 @@
+#ifndef VIDEOCOMPOSER_LOADADMISSION_H
+#define VIDEOCOMPOSER_LOADADMISSION_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * LoadAdmission - Predicts the load a cue adds before it plays
+ *
+ * Each file is profiled when it is loaded (codec, resolution, frame rate,
+ * peak bitrate, GOP length, hardware or software decode) and its cost is
+ * predicted with per-machine coefficients: decode seconds per megapixel
+ * for each codec and path, and GPU composite seconds per megapixel. The
+ * coefficients come from the benchmarks (cuems_videocomposer_bench_decode
+ * and _bench_composite JSON Lines), with rough built-in defaults for
+ * what they did not measure.
+ *
+ * Loads are summed over the admitted cues as fractions of the machine:
+ * software decode of its decoder threads, hardware decode of the decoder,
+ * GPU of the output frame period. A cue that would take one of them past
+ * the headroom is accepted with a warning, rejected, or degraded to half
+ * rate, per the policy. Like DecodeGovernor it only decides; the caller
+ * applies and reports the verdict.
+ */
+class LoadAdmission {
+public:
+    enum class Policy {
+        OFF,      // Admit everything, predict nothing
+        WARN,     // Admit, report the overload
+        REJECT,   // Keep the cue out
+        DEGRADE   // Admit at half rate (warned if still over)
+    };
+
+    enum class Verdict {
+        ACCEPT,
+        WARN,
+        REJECT,
+        DEGRADE
+    };
+
+    /** What a file costs to play, as profiled at load time */
+    struct MediaProfile {
+        std::string codec = "SOFTWARE";  // CodecType name, as the benchmarks print it
+        std::string profile;             // Codec profile (reported only)
+        int width = 0;
+        int height = 0;
+        double framerate = 0.0;
+        int64_t peakBitrate = 0;         // Bits per second over the busiest second (0 = unknown)
+        int gopLength = 0;               // Longest keyframe interval in frames (1 = intra-only)
+        bool hardware = false;           // Decoded by the hardware decoder
+    };
+
+    /** Share of each resource one cue (or all of them) takes, 1.0 = all of it */
+    struct Load {
+        double cpu = 0.0;
+        double hardware = 0.0;
+        double gpu = 0.0;
+        double seekSeconds = 0.0;  // Worst seek: decoding a whole GOP
+    };
+
+    struct Settings {
+        Policy policy = Policy::WARN;
+        double headroom = 0.9;   // Share of each resource admissions may fill
+        int cpuThreads = 0;      // Decoder threads (0 = one per core)
+        double outputHz = 60.0;  // Frames composited per second
+    };
+
+    struct Decision {
+        Verdict verdict = Verdict::ACCEPT;
+        Load cue;       // This cue (at the rate it is admitted with)
+        Load total;     // All admitted cues with this one
+        std::string reason;
+    };
+
+    // Built-in coefficients (a mid-range desktop) until benchmarked
+    static constexpr double DEFAULT_GPU_SECONDS_PER_MEGAPIXEL = 0.00025;
+
+    LoadAdmission();
+
+    void configure(const Settings& settings) { settings_ = settings; }
+    const Settings& getSettings() const { return settings_; }
+
+    /**
+     * Set a decode coefficient
+     * @param secondsPerMegapixel Decode time of one frame per megapixel
+     */
+    void setDecodeCost(const std::string& codec, bool hardware, double secondsPerMegapixel);
+    double getDecodeCost(const std::string& codec, bool hardware) const;
+
+    void setGpuCost(double secondsPerMegapixel) { gpuSecondsPerMegapixel_ = secondsPerMegapixel; }
+    double getGpuCost() const { return gpuSecondsPerMegapixel_; }
+
+    /**
+     * Take coefficients from benchmark output (decode and composite lines;
+     * the fastest run of each codec and path wins)
+     * @return Number of lines used
+     */
+    int loadBenchmarkLines(const std::string& text);
+    bool loadBenchmarkFile(const std::string& path);
+
+    /** Cost of one cue at its full frame rate */
+    Load predict(const MediaProfile& media) const;
+
+    /**
+     * Decide on a cue and count it as admitted unless rejected (a cue
+     * already admitted is replaced, so a file swap is not counted twice)
+     */
+    Decision admit(const std::string& cueId, const MediaProfile& media);
+
+    /** The cue no longer plays */
+    void release(const std::string& cueId);
+
+    /** Release every cue for which isLive is false */
+    void prune(const std::function<bool(const std::string&)>& isLive);
+
+    Load getTotal() const;
+    size_t getAdmittedCount() const { return admitted_.size(); }
+
+    static const char* verdictName(Verdict verdict);
+    static Policy parsePolicy(const std::string& name);
+
+private:
+    static Load scaled(const Load& load, double factor);
+    Load totalExcept(const std::string& cueId) const;
+    bool fits(const Load& total) const;
+    std::string describe(const Load& total) const;
+
+    Settings settings_;
+    std::map<std::string, double> decodeCosts_;  // "<codec>/<sw|hw>" -> seconds per megapixel
+    double gpuSecondsPerMegapixel_;
+    std::map<std::string, Load> admitted_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LOADADMISSION_H
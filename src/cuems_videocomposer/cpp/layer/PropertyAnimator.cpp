@@ -0,0 +1,152 @@
+#include "PropertyAnimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+void PropertyAnimator::animate(Property property, float target, int64_t durationUs, Easing easing) {
+    Track track;
+    track.property = property;
+    track.to = target;
+    track.durationUs = std::max<int64_t>(0, durationUs);
+    track.easing = easing;
+
+    // A new tween of a property replaces the running one (from where it is)
+    for (Track& existing : tracks_) {
+        if (existing.property == property) {
+            existing = track;
+            return;
+        }
+    }
+    tracks_.push_back(track);
+}
+
+void PropertyAnimator::stop(Property property) {
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                                 [property](const Track& t) { return t.property == property; }),
+                  tracks_.end());
+}
+
+void PropertyAnimator::stopAll() {
+    tracks_.clear();
+}
+
+bool PropertyAnimator::isAnimating(Property property) const {
+    return std::any_of(tracks_.begin(), tracks_.end(),
+                       [property](const Track& t) { return t.property == property; });
+}
+
+bool PropertyAnimator::apply(LayerProperties& props, int64_t presentationUs) {
+    bool changed = false;
+    for (auto it = tracks_.begin(); it != tracks_.end();) {
+        Track& track = *it;
+        float current = get(props, track.property);
+        if (track.startUs < 0) {
+            // First render after the command: start from what is shown now
+            track.startUs = presentationUs;
+            track.from = current;
+        } else if (current != track.written) {
+            // Set directly meanwhile: that value stays
+            it = tracks_.erase(it);
+            continue;
+        }
+
+        float t = 1.0f;
+        if (track.durationUs > 0) {
+            t = static_cast<float>(presentationUs - track.startUs) / static_cast<float>(track.durationUs);
+            t = std::max(0.0f, std::min(1.0f, t));
+        }
+        float value = t >= 1.0f ? track.to : track.from + (track.to - track.from) * ease(track.easing, t);
+        set(props, track.property, value);
+        track.written = get(props, track.property);
+        changed = changed || track.written != current;
+
+        if (t >= 1.0f) {
+            it = tracks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return changed;
+}
+
+bool PropertyAnimator::parseEasing(std::string_view name, Easing& easing) {
+    if (name == "linear") {
+        easing = Easing::LINEAR;
+    } else if (name == "in") {
+        easing = Easing::EASE_IN;
+    } else if (name == "out") {
+        easing = Easing::EASE_OUT;
+    } else if (name == "inout") {
+        easing = Easing::EASE_IN_OUT;
+    } else if (name == "smooth") {
+        easing = Easing::SMOOTH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+float PropertyAnimator::ease(Easing easing, float t) {
+    switch (easing) {
+        case Easing::EASE_IN:
+            return t * t * t;
+        case Easing::EASE_OUT: {
+            float u = 1.0f - t;
+            return 1.0f - u * u * u;
+        }
+        case Easing::EASE_IN_OUT:
+            if (t < 0.5f) {
+                return 4.0f * t * t * t;
+            } else {
+                float u = -2.0f * t + 2.0f;
+                return 1.0f - u * u * u / 2.0f;
+            }
+        case Easing::SMOOTH:
+            return t * t * (3.0f - 2.0f * t);
+        case Easing::LINEAR:
+        default:
+            return t;
+    }
+}
+
+float PropertyAnimator::get(const LayerProperties& props, Property property) {
+    switch (property) {
+        case Property::OPACITY:    return props.opacity;
+        case Property::X:          return static_cast<float>(props.x);
+        case Property::Y:          return static_cast<float>(props.y);
+        case Property::SCALE_X:    return props.scaleX;
+        case Property::SCALE_Y:    return props.scaleY;
+        case Property::ROTATION:   return props.rotation;
+        case Property::BRIGHTNESS: return props.colorAdjust.brightness;
+        case Property::CONTRAST:   return props.colorAdjust.contrast;
+        case Property::SATURATION: return props.colorAdjust.saturation;
+        case Property::HUE:        return props.colorAdjust.hue;
+        case Property::GAMMA:      return props.colorAdjust.gamma;
+        default:
+            return props.cornerDeform.corners[static_cast<int>(property) - static_cast<int>(Property::CORNER_0)];
+    }
+}
+
+void PropertyAnimator::set(LayerProperties& props, Property property, float value) {
+    switch (property) {
+        case Property::OPACITY:    props.opacity = std::max(0.0f, std::min(1.0f, value)); break;
+        case Property::X:          props.x = static_cast<int>(std::lround(value)); break;
+        case Property::Y:          props.y = static_cast<int>(std::lround(value)); break;
+        case Property::SCALE_X:    props.scaleX = value; break;
+        case Property::SCALE_Y:    props.scaleY = value; break;
+        case Property::ROTATION:   props.rotation = value; break;
+        // Same ranges the direct OSC commands clamp to
+        case Property::BRIGHTNESS: props.colorAdjust.brightness = std::max(-1.0f, std::min(1.0f, value)); break;
+        case Property::CONTRAST:   props.colorAdjust.contrast = std::max(0.0f, std::min(2.0f, value)); break;
+        case Property::SATURATION: props.colorAdjust.saturation = std::max(0.0f, std::min(2.0f, value)); break;
+        case Property::HUE:        props.colorAdjust.hue = value; break;
+        case Property::GAMMA:      props.colorAdjust.gamma = std::max(0.1f, std::min(3.0f, value)); break;
+        default:
+            props.cornerDeform.corners[static_cast<int>(property) - static_cast<int>(Property::CORNER_0)] = value;
+            props.cornerDeform.enabled = true;
+            break;
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,91 @@
+#ifndef VIDEOCOMPOSER_PROPERTYANIMATOR_H
+#define VIDEOCOMPOSER_PROPERTYANIMATOR_H
+
+#include "LayerProperties.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * PropertyAnimator - Tweens of a layer's display properties
+ *
+ * One command sets a target, a duration and an easing; the compositor then
+ * moves the property itself, evaluated every vsync against the time the
+ * render will be presented, so a fade costs no control traffic and does
+ * not step when packets clump. A tween starts on the first render after
+ * it was set and lands exactly on its target.
+ *
+ * Setting a property directly while it is animating wins: the tween sees
+ * a value it did not write and stops.
+ */
+class PropertyAnimator {
+public:
+    enum class Property {
+        OPACITY,
+        X,
+        Y,
+        SCALE_X,
+        SCALE_Y,
+        ROTATION,
+        BRIGHTNESS,
+        CONTRAST,
+        SATURATION,
+        HUE,
+        GAMMA,
+        CORNER_0,  // cornerDeform.corners[0..7]
+        CORNER_7 = CORNER_0 + 7
+    };
+
+    enum class Easing {
+        LINEAR,
+        EASE_IN,      // Cubic
+        EASE_OUT,
+        EASE_IN_OUT,
+        SMOOTH        // Smoothstep, gentle both ends
+    };
+
+    /**
+     * Animate one property from its current value
+     * @param durationUs Duration (<= 0 = set on the next render)
+     */
+    void animate(Property property, float target, int64_t durationUs, Easing easing = Easing::LINEAR);
+
+    /** Stop one tween where it is */
+    void stop(Property property);
+    void stopAll();
+
+    /**
+     * Move every tween to its value at this presentation time
+     * @return true if any property changed
+     */
+    bool apply(LayerProperties& props, int64_t presentationUs);
+
+    bool isAnimating() const { return !tracks_.empty(); }
+    bool isAnimating(Property property) const;
+
+    /** Easing by name: linear, in, out, inout, smooth */
+    static bool parseEasing(std::string_view name, Easing& easing);
+    static float ease(Easing easing, float t);
+
+    static float get(const LayerProperties& props, Property property);
+    static void set(LayerProperties& props, Property property, float value);
+
+private:
+    struct Track {
+        Property property;
+        float from = 0.0f;
+        float to = 0.0f;
+        int64_t startUs = -1;    // -1 = starts on the next apply()
+        int64_t durationUs = 0;
+        Easing easing = Easing::LINEAR;
+        float written = 0.0f;    // Last value written (as read back)
+    };
+
+    std::vector<Track> tracks_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PROPERTYANIMATOR_H
@@ -0,0 +1,41 @@
+#ifndef VIDEOCOMPOSER_SCENESNAPSHOT_H
+#define VIDEOCOMPOSER_SCENESNAPSHOT_H
+
+#include "LayerGroup.h"
+#include "LayerProperties.h"
+#include <cstdint>
+#include <vector>
+
+namespace videocomposer {
+
+class VideoLayer;
+
+/**
+ * SceneSnapshot - Immutable render list published by LayerManager
+ *
+ * Layers in render order (top first) with the state they had when the
+ * snapshot was taken. A new snapshot, with a new version, is published
+ * only when a layer was added, removed, reordered, changed a property or
+ * got a new frame; an unchanged version means the scene is the same.
+ * Readers never see it change. Textures stay owned by the layers, and
+ * layers are only removed between renders.
+ */
+struct SceneSnapshot {
+    struct Entry {
+        const VideoLayer* layer = nullptr;
+        int layerId = -1;
+        int slot = -1;              // LayerPropertyStore slot
+        bool ready = false;
+        uint64_t frameGeneration = 0;
+        LayerProperties properties;
+    };
+
+    uint64_t version = 0;
+    std::vector<Entry> entries;                 // Sorted by z-order, top first
+    std::vector<const VideoLayer*> layers;      // Same order, for the renderer
+    std::vector<LayerGroup> groups;             // Groups members composite into (by name)
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SCENESNAPSHOT_H
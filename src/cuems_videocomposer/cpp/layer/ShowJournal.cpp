@@ -0,0 +1,372 @@
+#include "ShowJournal.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace videocomposer {
+
+namespace {
+
+const char* JOURNAL_HEADER = "cuems-videocomposer show journal 1";
+
+bool createParentDirectories(const std::string& path) {
+    size_t pos = 0;
+    while ((pos = path.find('/', pos + 1)) != std::string::npos) {
+        std::string partial = path.substr(0, pos);
+        if (mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rest of the line after the key (paths may contain spaces)
+std::string restOfLine(std::istringstream& fields) {
+    std::string rest;
+    std::getline(fields >> std::ws, rest);
+    return rest;
+}
+
+} // namespace
+
+ShowJournal::ShowJournal() {
+}
+
+ShowJournal::~ShowJournal() {
+    close();
+}
+
+bool ShowJournal::open(const std::string& path) {
+    close();
+    if (path.empty() || !createParentDirectories(path)) {
+        LOG_WARNING << "ShowJournal: Cannot create the directory of " << path;
+        return false;
+    }
+    path_ = path;
+    written_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+    }
+    writer_ = std::make_unique<std::thread>(&ShowJournal::writerThreadFunc, this);
+    LOG_INFO << "ShowJournal: Recording the show state in " << path_;
+    return true;
+}
+
+void ShowJournal::close() {
+    if (!writer_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeCond_.notify_all();
+    writer_->join();
+    writer_.reset();
+}
+
+void ShowJournal::submit(State state) {
+    if (!writer_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::make_unique<State>(std::move(state));
+    }
+    wakeCond_.notify_all();
+}
+
+uint64_t ShowJournal::getWriteCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writeCount_;
+}
+
+void ShowJournal::writerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::IO);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wakeCond_.wait(lock, [this] { return stop_ || pending_; });
+        std::unique_ptr<State> state = std::move(pending_);
+        bool stop = stop_;
+        lock.unlock();
+
+        if (state) {
+            std::string text = format(*state);
+            if (text != written_ && writeFile(text)) {
+                written_ = std::move(text);
+                lock.lock();
+                ++writeCount_;
+                lock.unlock();
+            }
+        }
+        lock.lock();
+        if (stop && !pending_) {
+            return;
+        }
+    }
+}
+
+bool ShowJournal::writeFile(const std::string& text) {
+    // Renamed over the journal, so a crash mid-write leaves the previous one
+    std::string temporary = path_ + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file || !(file << text) || !file.flush()) {
+            LOG_WARNING << "ShowJournal: Cannot write " << temporary;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path_.c_str()) != 0) {
+        LOG_WARNING << "ShowJournal: Cannot replace " << path_ << ": " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+std::string ShowJournal::format(const State& state) {
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << JOURNAL_HEADER << "\n";
+    if (!state.resolutionMode.empty()) {
+        out << "resolution " << state.resolutionMode << "\n";
+    }
+    for (const Layer& layer : state.layers) {
+        out << "layer " << layer.cueId << "\n";
+        for (const std::string& line : formatLayer(layer)) {
+            out << line << "\n";
+        }
+        out << "end\n";
+    }
+    return out.str();
+}
+
+std::vector<std::string> ShowJournal::formatLayer(const Layer& layer) {
+    std::vector<std::string> lines;
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    auto line = [&lines, &out]() {
+        lines.push_back(out.str());
+        out.str(std::string());
+    };
+    const LayerProperties& p = layer.properties;
+    out << "source " << layer.source;
+    line();
+    out << "geometry " << p.x << " " << p.y << " " << p.width << " " << p.height;
+    line();
+    out << "opacity " << p.opacity;
+    line();
+    out << "z " << p.zOrder;
+    line();
+    out << "visible " << p.visible;
+    line();
+    out << "scale " << p.scaleX << " " << p.scaleY;
+    line();
+    out << "rotation " << p.rotation;
+    line();
+    out << "crop " << p.crop.enabled << " " << p.crop.x << " " << p.crop.y << " " << p.crop.width << " "
+        << p.crop.height;
+    line();
+    out << "panorama " << p.panoramaMode << " " << p.panOffset;
+    line();
+    out << "blend " << static_cast<int>(p.blendMode);
+    line();
+    out << "packed_alpha " << PackedAlpha::layoutName(p.packedAlpha) << " " << p.packedAlphaPremultiplied;
+    line();
+    out << "deform " << p.cornerDeform.enabled << " " << p.cornerDeform.highQuality;
+    for (float corner : p.cornerDeform.corners) {
+        out << " " << corner;
+    }
+    line();
+    out << "color " << p.colorAdjust.brightness << " " << p.colorAdjust.contrast << " "
+        << p.colorAdjust.saturation << " " << p.colorAdjust.hue << " " << p.colorAdjust.gamma;
+    line();
+    if (!p.colorAdjust.lutFile.empty()) {
+        out << "lut " << p.colorAdjust.lutFile;
+        line();
+    }
+    const LayerProperties::Effects& fx = p.effects;
+    out << "effects " << fx.blurRadius << " " << fx.sharpenAmount << " " << fx.sharpenRadius << " "
+        << fx.chromaKey.enabled << " " << fx.chromaKey.red << " " << fx.chromaKey.green << " "
+        << fx.chromaKey.blue << " " << fx.chromaKey.similarity << " " << fx.chromaKey.smoothness << " "
+        << fx.chromaKey.spill << " " << fx.vignetteAmount << " " << fx.vignetteSoftness;
+    line();
+    out << "auto_unload " << p.autoUnload;
+    line();
+    out << "preload " << p.preload;
+    line();
+    out << "file_loops " << p.fullFileLoopCount;
+    line();
+    out << "loop_region " << p.loopRegion.enabled << " " << p.loopRegion.startFrame << " "
+        << p.loopRegion.endFrame << " " << p.loopRegion.loopCount;
+    line();
+    out.precision(std::numeric_limits<double>::max_digits10);
+    out << "time " << layer.timeOffset << " " << layer.timeScale;
+    line();
+    out.precision(std::numeric_limits<float>::max_digits10);
+    out << "wraparound " << layer.wraparound;
+    line();
+    out << "mtc_follow " << layer.mtcFollow;
+    line();
+    out << "decode_priority " << layer.decodePriority;
+    line();
+    out << "critical " << layer.critical;
+    line();
+    return lines;
+}
+
+bool ShowJournal::parse(std::istream& input, State& state) {
+    std::string line;
+    if (!std::getline(input, line) || line != JOURNAL_HEADER) {
+        return false;
+    }
+    State parsed;
+    Layer* layer = nullptr;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) {
+            continue;
+        }
+        if (key == "resolution" && !layer) {
+            parsed.resolutionMode = restOfLine(fields);
+            continue;
+        }
+        if (key == "layer") {
+            parsed.layers.emplace_back();
+            layer = &parsed.layers.back();
+            layer->cueId = restOfLine(fields);
+            continue;
+        }
+        if (!layer) {
+            LOG_WARNING << "ShowJournal: Ignoring line outside a layer: " << line;
+            continue;
+        }
+
+        if (key == "end") {
+            layer = nullptr;
+        } else if (!parseLine(line, *layer)) {
+            LOG_WARNING << "ShowJournal: Bad line: " << line;
+            return false;
+        }
+    }
+
+    // A layer without a source can't be loaded again
+    for (auto it = parsed.layers.begin(); it != parsed.layers.end();) {
+        it = it->source.empty() ? parsed.layers.erase(it) : it + 1;
+    }
+    state = std::move(parsed);
+    return true;
+}
+
+bool ShowJournal::parseLine(const std::string& line, Layer& layer) {
+    std::istringstream fields(line);
+    std::string key;
+    if (!(fields >> key)) {
+        return true;
+    }
+    LayerProperties& p = layer.properties;
+    bool ok = true;
+    if (key == "source") {
+        layer.source = restOfLine(fields);
+    } else if (key == "geometry") {
+        ok = static_cast<bool>(fields >> p.x >> p.y >> p.width >> p.height);
+    } else if (key == "opacity") {
+        ok = static_cast<bool>(fields >> p.opacity);
+    } else if (key == "z") {
+        ok = static_cast<bool>(fields >> p.zOrder);
+    } else if (key == "visible") {
+        ok = static_cast<bool>(fields >> p.visible);
+    } else if (key == "scale") {
+        ok = static_cast<bool>(fields >> p.scaleX >> p.scaleY);
+    } else if (key == "rotation") {
+        ok = static_cast<bool>(fields >> p.rotation);
+    } else if (key == "crop") {
+        ok = static_cast<bool>(fields >> p.crop.enabled >> p.crop.x >> p.crop.y >> p.crop.width >> p.crop.height);
+    } else if (key == "panorama") {
+        ok = static_cast<bool>(fields >> p.panoramaMode >> p.panOffset);
+    } else if (key == "blend") {
+        int blend = 0;
+        ok = static_cast<bool>(fields >> blend) && blend >= LayerProperties::NORMAL &&
+             blend <= LayerProperties::OVERLAY;
+        p.blendMode = ok ? static_cast<LayerProperties::BlendMode>(blend) : LayerProperties::NORMAL;
+    } else if (key == "packed_alpha") {
+        std::string layout;
+        ok = static_cast<bool>(fields >> layout >> p.packedAlphaPremultiplied) &&
+             PackedAlpha::parseLayout(layout, p.packedAlpha);
+    } else if (key == "deform") {
+        ok = static_cast<bool>(fields >> p.cornerDeform.enabled >> p.cornerDeform.highQuality);
+        for (float& corner : p.cornerDeform.corners) {
+            ok = ok && static_cast<bool>(fields >> corner);
+        }
+    } else if (key == "color") {
+        ok = static_cast<bool>(fields >> p.colorAdjust.brightness >> p.colorAdjust.contrast >>
+                               p.colorAdjust.saturation >> p.colorAdjust.hue >> p.colorAdjust.gamma);
+    } else if (key == "lut") {
+        p.colorAdjust.lutFile = restOfLine(fields);
+    } else if (key == "effects") {
+        LayerProperties::Effects& fx = p.effects;
+        ok = static_cast<bool>(fields >> fx.blurRadius >> fx.sharpenAmount >> fx.sharpenRadius >>
+                               fx.chromaKey.enabled >> fx.chromaKey.red >> fx.chromaKey.green >>
+                               fx.chromaKey.blue >> fx.chromaKey.similarity >> fx.chromaKey.smoothness >>
+                               fx.chromaKey.spill >> fx.vignetteAmount >> fx.vignetteSoftness);
+    } else if (key == "auto_unload") {
+        ok = static_cast<bool>(fields >> p.autoUnload);
+    } else if (key == "preload") {
+        ok = static_cast<bool>(fields >> p.preload);
+    } else if (key == "file_loops") {
+        ok = static_cast<bool>(fields >> p.fullFileLoopCount);
+        p.currentFullFileLoopCount = p.fullFileLoopCount;
+    } else if (key == "loop_region") {
+        ok = static_cast<bool>(fields >> p.loopRegion.enabled >> p.loopRegion.startFrame >>
+                               p.loopRegion.endFrame >> p.loopRegion.loopCount);
+        p.loopRegion.currentLoopCount = p.loopRegion.loopCount;
+    } else if (key == "time") {
+        ok = static_cast<bool>(fields >> layer.timeOffset >> layer.timeScale);
+    } else if (key == "wraparound") {
+        ok = static_cast<bool>(fields >> layer.wraparound);
+    } else if (key == "mtc_follow") {
+        ok = static_cast<bool>(fields >> layer.mtcFollow);
+    } else if (key == "decode_priority") {
+        ok = static_cast<bool>(fields >> layer.decodePriority);
+    } else if (key == "critical") {
+        ok = static_cast<bool>(fields >> layer.critical);
+    } else {
+        LOG_VERBOSE << "ShowJournal: Ignoring unknown key: " << key;
+    }
+    return ok;
+}
+
+bool ShowJournal::load(const std::string& path, State& state) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    if (!parse(file, state)) {
+        LOG_WARNING << "ShowJournal: " << path << " is not a show journal";
+        return false;
+    }
+    return true;
+}
+
+std::string ShowJournal::defaultPath() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/cuems-videocomposer/show.journal";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) {
+        return std::string(home) + "/.cache/cuems-videocomposer/show.journal";
+    }
+    return "/tmp/cuems-videocomposer/show.journal";
+}
+
+} // namespace videocomposer
@@ -0,0 +1,102 @@
+#ifndef VIDEOCOMPOSER_SHOWJOURNAL_H
+#define VIDEOCOMPOSER_SHOWJOURNAL_H
+
+#include "LayerProperties.h"
+#include <condition_variable>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ShowJournal - Show state kept on disk for crash recovery (--resume)
+ *
+ * The render loop hands over the loaded cues (source, properties, timing)
+ * and the display configuration now and then; a writer thread formats
+ * them and replaces the journal file (written aside, then renamed) when
+ * something changed. A restart with --resume reads it back and loads the
+ * same cues before the first MTC arrives. Index and shader caches are
+ * keyed by file and driver, so the reloaded cues find them as they are.
+ *
+ * Text, one "key values" line per item, a "layer <cue ID>" ... "end"
+ * block per cue.
+ */
+class ShowJournal {
+public:
+    struct Layer {
+        std::string cueId;
+        std::string source;
+        LayerProperties properties;
+        int64_t timeOffset = 0;
+        double timeScale = 1.0;
+        bool wraparound = false;
+        bool mtcFollow = true;
+        int decodePriority = 1;
+        bool critical = false;
+    };
+
+    struct State {
+        std::string resolutionMode;   // Empty = not recorded
+        std::vector<Layer> layers;
+    };
+
+    ShowJournal();
+    ~ShowJournal();
+
+    /**
+     * Start the writer thread for a journal file
+     */
+    bool open(const std::string& path);
+
+    /** Write what is still pending and stop the writer */
+    void close();
+
+    bool isOpen() const { return writer_ != nullptr; }
+    const std::string& getPath() const { return path_; }
+
+    /**
+     * Queue a state for the writer (replaces one not yet written)
+     */
+    void submit(State state);
+
+    /** Journal files written so far (unchanged states are not written) */
+    uint64_t getWriteCount() const;
+
+    static std::string format(const State& state);
+    static bool parse(std::istream& input, State& state);
+
+    /** The "key values" lines of one layer block (without "layer" and "end") */
+    static std::vector<std::string> formatLayer(const Layer& layer);
+
+    /** Apply one such line (unknown keys are ignored; false if malformed) */
+    static bool parseLine(const std::string& line, Layer& layer);
+
+    /** Read a journal file (false if missing or not a journal) */
+    static bool load(const std::string& path, State& state);
+
+    /** $XDG_CACHE_HOME/cuems-videocomposer/show.journal */
+    static std::string defaultPath();
+
+private:
+    void writerThreadFunc();
+    bool writeFile(const std::string& text);
+
+    std::string path_;
+    std::unique_ptr<State> pending_;
+    std::string written_;         // Writer thread only
+    uint64_t writeCount_ = 0;
+    bool stop_ = false;
+
+    mutable std::mutex mutex_;    // Guards pending_, writeCount_, stop_
+    std::condition_variable wakeCond_;
+    std::unique_ptr<std::thread> writer_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SHOWJOURNAL_H
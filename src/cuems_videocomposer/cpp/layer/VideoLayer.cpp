@@ -2,7 +2,9 @@
 #include "../utils/Logger.h"
 #include "../utils/SMPTEUtils.h"
 #include "../sync/MIDISyncSource.h"
+#include "../video/MemoryBudget.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 
 namespace videocomposer {
@@ -10,6 +12,12 @@ namespace videocomposer {
 VideoLayer::VideoLayer()
     : layerId_(-1)
     , frameBufferCacheValid_(false)
+    , occluded_(false)
+    , suspendWhenOccluded_(false)
+    , critical_(false)
+    , seekHidLayer_(false)
+    , displayWidth_(0)
+    , displayHeight_(0)
 {
     // Set frame info in display when it changes
     // This will be updated when input source is set
@@ -22,7 +30,19 @@ VideoLayer::~VideoLayer() {
 void VideoLayer::setInputSource(std::unique_ptr<InputSource> input) {
     pause();
     playback_.setInputSource(std::move(input));
-    
+    refreshFrameInfo();
+}
+
+void VideoLayer::setIncomingSource(std::unique_ptr<InputSource> input, std::unique_ptr<SyncSource> sync,
+                                   bool keyframeAligned) {
+    // Playback keeps running; finishUpdate() picks up the frame info after the swap
+    playback_.setIncomingSource(std::move(input), std::move(sync), keyframeAligned);
+    if (!playback_.hasIncomingSource()) {
+        refreshFrameInfo();
+    }
+}
+
+void VideoLayer::refreshFrameInfo() {
     // Update display with frame info
     if (playback_.isReady()) {
         FrameInfo info = playback_.getFrameInfo();
@@ -64,13 +84,157 @@ bool VideoLayer::seek(int64_t frameNumber) {
     return result;
 }
 
+bool VideoLayer::seekAsync(int64_t frameNumber, LayerPlayback::SeekPlaceholder placeholder) {
+    if (!playback_.seekAsync(frameNumber)) {
+        return false;
+    }
+    frameBufferCacheValid_ = false;
+    if (placeholder == LayerPlayback::SeekPlaceholder::BLANK && playback_.isSeeking() && properties().visible) {
+        properties().visible = false;
+        seekHidLayer_ = true;
+    }
+    return true;
+}
+
+bool VideoLayer::isSeeking() const {
+    return playback_.isSeeking();
+}
+
+bool VideoLayer::takeSeekCompletion(LayerPlayback::SeekCompletion& completion) {
+    return playback_.takeSeekCompletion(completion);
+}
+
 void VideoLayer::update() {
     if (!isReady()) {
         return;
     }
 
     // Update playback (polls sync source and loads frames)
+    MemoryBudget::LayerScope budgetScope(layerId_);
+    updatePlanarOutput();
+    updateLoopPrefetch();
+    updateLoopCache();
+    playback_.setLoadSuspended(suspendWhenOccluded_ && occluded_);
+    playback_.setDecodeVisible(!occluded_);
     playback_.update();
+    finishUpdate();
+}
+
+void VideoLayer::pollSync() {
+    MemoryBudget::LayerScope budgetScope(layerId_);
+    updatePlanarOutput();
+    updateLoopPrefetch();
+    updateLoopCache();
+    playback_.setLoadSuspended(suspendWhenOccluded_ && occluded_);
+    playback_.setDecodeVisible(!occluded_);
+    playback_.pollSync();
+}
+
+void VideoLayer::updatePlanarOutput() {
+    // Crop/panorama are applied to BGRA pixels on the CPU
+    const LayerProperties& props = properties();
+    playback_.setPlanarOutputAllowed(!props.crop.enabled && !props.panoramaMode);
+    
+    // ... and only the part shown is converted
+    FrameWindow window;
+    CPUImageProcessor::shownWindow(props, playback_.getFrameInfo(), window);
+    playback_.setSourceWindow(window);
+}
+
+void VideoLayer::getResolutionHint(int& width, int& height) const {
+    // Crop/panorama enlarge a part of the frame: that part needs full detail
+    const LayerProperties& props = properties();
+    if (props.crop.enabled || props.panoramaMode) {
+        width = 0;
+        height = 0;
+        return;
+    }
+    width = displayWidth_;
+    height = displayHeight_;
+}
+
+bool VideoLayer::hasPendingLoad() const {
+    return playback_.hasPendingLoad();
+}
+
+void VideoLayer::onTransportEvent(const TransportEvent& event) {
+    playback_.onTransportEvent(event);
+}
+
+void VideoLayer::loadPendingFrame() {
+    MemoryBudget::LayerScope budgetScope(layerId_);
+    playback_.loadPendingFrame();
+}
+
+bool VideoLayer::canLoadOffRenderThread() const {
+    return playback_.canLoadOffRenderThread();
+}
+
+void VideoLayer::updateLoopPrefetch() {
+    const LayerProperties& props = properties();
+    std::vector<int64_t> targets;
+    if (props.loopRegion.enabled && props.loopRegion.currentLoopCount != 0) {
+        targets.push_back(props.loopRegion.startFrame);
+    }
+    if (playback_.getWraparound() && props.fullFileLoopCount != 0 && props.currentFullFileLoopCount != 0) {
+        targets.push_back(0);
+    }
+    playback_.setLoopTargets(targets);
+}
+
+void VideoLayer::updateLoopCache() {
+    if (!loopCache_) {
+        return;
+    }
+    // Crop and panorama frames are changed on the CPU, live ones never repeat
+    const LayerProperties& props = properties();
+    InputSource* input = playback_.getInputSource();
+    bool cacheable = input && !input->isLiveStream() && !input->isStatic() &&
+                     !props.crop.enabled && !props.panoramaMode;
+    int64_t totalFrames = playback_.getFrameInfo().totalFrames;
+    if (cacheable && props.loopRegion.enabled && props.loopRegion.currentLoopCount != 0) {
+        int64_t end = props.loopRegion.endFrame + 1;  // The end frame is shown before the wrap
+        loopCache_->setLoop(input, props.loopRegion.startFrame, totalFrames > 0 ? std::min(end, totalFrames) : end);
+    } else if (cacheable && playback_.getWraparound() && props.fullFileLoopCount != 0 &&
+               props.currentFullFileLoopCount != 0) {
+        loopCache_->setLoop(input, 0, totalFrames);
+    } else {
+        loopCache_->setLoop(nullptr, 0, 0);
+    }
+}
+
+bool VideoLayer::latchSync() {
+    if (!isReady()) {
+        return false;
+    }
+    MemoryBudget::LayerScope budgetScope(layerId_);
+    if (!playback_.latchSync()) {
+        return false;
+    }
+    updateFieldPhase();
+    return true;
+}
+
+void VideoLayer::updateFieldPhase() {
+    // Field due this output frame, at the rate frames are played
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    fieldSelector_.update(playback_.getFrameGeneration(), now,
+                          playback_.getFrameInfo().framerate * std::fabs(getTimeScale()));
+}
+
+void VideoLayer::finishUpdate() {
+    if (!isReady()) {
+        return;
+    }
+    if (playback_.takeSourceSwapped()) {
+        refreshFrameInfo();
+    }
+    if (seekHidLayer_ && !playback_.isSeeking()) {
+        properties().visible = true;  // The target frame is in place
+        seekHidLayer_ = false;
+    }
+    
+    updateFieldPhase();
     
     // Check for playback end and handle looping/auto-unload
     if (playback_.checkPlaybackEnd()) {
@@ -226,6 +390,79 @@ bool VideoLayer::getMtcFollow() const {
     return playback_.getMtcFollow();
 }
 
+void VideoLayer::arm(int64_t frameNumber) {
+    properties().visible = false;
+    playback_.arm(frameNumber);
+    LOG_INFO << "Layer " << layerId_ << " armed at frame " << playback_.getArmedFrame();
+}
+
+void VideoLayer::go() {
+    if (!playback_.isArmed()) {
+        properties().visible = true;
+        return;
+    }
+    if (!playback_.isArmedFrameReady()) {
+        LOG_WARNING << "Layer " << layerId_ << ": GO before the armed frame was loaded";
+    }
+    playback_.go();
+    properties().visible = true;
+}
+
+bool VideoLayer::isArmed() const {
+    return playback_.isArmed();
+}
+
+bool VideoLayer::isArmedFrameReady() const {
+    return playback_.isArmedFrameReady();
+}
+
+void VideoLayer::setCuePoints(const std::vector<int64_t>& syncFrames) {
+    MemoryBudget::LayerScope budgetScope(layerId_);
+    playback_.setCuePoints(syncFrames);
+}
+
+void VideoLayer::setDecodePriority(int priority) {
+    playback_.setDecodePriority(priority);
+}
+
+int VideoLayer::getDecodePriority() const {
+    return playback_.getDecodePriority();
+}
+
+void VideoLayer::setUnderrunPolicy(InputSource::UnderrunPolicy policy) {
+    playback_.setUnderrunPolicy(policy);
+}
+
+void VideoLayer::setLoopCacheMode(LoopFrameCache::Mode mode) {
+    if (mode == LoopFrameCache::Mode::OFF) {
+        playback_.setLoopCache(nullptr);
+        loopCache_.reset();
+        return;
+    }
+    if (!loopCache_) {
+        loopCache_ = std::make_shared<LoopFrameCache>(layerId_);
+        playback_.setLoopCache(loopCache_);
+    }
+    loopCache_->setMode(mode);
+    updateLoopCache();
+}
+
+LoopFrameCache::Mode VideoLayer::getLoopCacheMode() const {
+    return loopCache_ ? loopCache_->getMode() : LoopFrameCache::Mode::OFF;
+}
+
+void VideoLayer::setRateDivisor(int divisor) {
+    playback_.setRateDivisor(divisor);
+}
+
+int VideoLayer::getRateDivisor() const {
+    return playback_.getRateDivisor();
+}
+
+double VideoLayer::getLoadTime() const {
+    return playback_.getLoadTime();
+}
+
 bool VideoLayer::isPlaying() const {
     return playback_.isPlaying();
 }
@@ -234,6 +471,14 @@ int64_t VideoLayer::getCurrentFrame() const {
     return playback_.getCurrentFrame();
 }
 
+uint64_t VideoLayer::getFrameGeneration() const {
+    return playback_.getFrameGeneration();
+}
+
+int64_t VideoLayer::getLoadedFrame() const {
+    return playback_.getLoadedFrame();
+}
+
 InputSource* VideoLayer::getInputSource() const {
     return playback_.getInputSource();
 }
@@ -277,5 +522,24 @@ bool VideoLayer::isFrameOnGPU() const {
     return display_.isFrameOnGPU();
 }
 
+bool VideoLayer::hasStaticFrame() const {
+    // Crop/panorama output is rebuilt from the image, so it is not static
+    return playback_.hasStaticFrame() && display_.isReady() && display_.isPassThrough();
+}
+
+std::shared_ptr<TiledImage> VideoLayer::getTiledImage() const {
+    InputSource* input = playback_.getInputSource();
+    return hasStaticFrame() && input ? input->getTiledImage() : nullptr;
+}
+
+std::shared_ptr<MappedFrameRing> VideoLayer::getFrameRing() const {
+    // Modified frames are read back by the CPU processor; mapped memory is
+    // write-combined, so only pass-through layers decode into the ring
+    if (!display_.isReady() || !display_.isPassThrough()) {
+        return nullptr;
+    }
+    return playback_.getFrameRing();
+}
+
 } // namespace videocomposer
 
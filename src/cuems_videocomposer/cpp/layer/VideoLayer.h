@@ -4,12 +4,15 @@
 #include "LayerProperties.h"
 #include "LayerPlayback.h"
 #include "LayerDisplay.h"
+#include "PropertyAnimator.h"
 #include "../input/InputSource.h"
 #include "../sync/SyncSource.h"
 #include "../video/FrameBuffer.h"
 #include "../video/GPUTextureFrameBuffer.h"
+#include "../video/FieldSelector.h"
 #include <memory>
 #include <cstdint>
+#include <vector>
 
 namespace videocomposer {
 
@@ -31,12 +34,20 @@ public:
     void setInputSource(std::unique_ptr<InputSource> input);
     void setSyncSource(std::unique_ptr<SyncSource> sync);
     
+    // Replace the media without a gap (see LayerPlayback::setIncomingSource)
+    void setIncomingSource(std::unique_ptr<InputSource> input, std::unique_ptr<SyncSource> sync,
+                           bool keyframeAligned = false);
+    
     InputSource* getInputSource() const;
     SyncSource* getSyncSource() const;
 
     // Properties access
     LayerProperties& properties();
     const LayerProperties& properties() const;
+    
+    // Tweens of the properties (applied once per render, see PropertyAnimator)
+    PropertyAnimator& animator() { return animator_; }
+    const PropertyAnimator& animator() const { return animator_; }
 
     // Playback control
     bool play();
@@ -46,9 +57,33 @@ public:
     bool seek(int64_t frameNumber);
     int64_t getCurrentFrame() const;
     
+    // Seek without blocking the render loop (see LayerPlayback::seekAsync);
+    // BLANK hides the layer until the target frame is shown
+    bool seekAsync(int64_t frameNumber,
+                   LayerPlayback::SeekPlaceholder placeholder = LayerPlayback::SeekPlaceholder::HOLD);
+    bool isSeeking() const;
+    bool takeSeekCompletion(LayerPlayback::SeekCompletion& completion);
+    uint64_t getFrameGeneration() const;
+    int64_t getLoadedFrame() const;
+    
     // Update layer (called from main loop)
     void update();
     
+    // Phases of update() for parallel layer updates (see LayerPlayback):
+    // pollSync() -> loadPendingFrame() (worker thread if canLoadOffRenderThread())
+    // -> finishUpdate() (loop/end handling, render thread)
+    void pollSync();
+    bool hasPendingLoad() const;
+    
+    // Locate/stop of the sync source (see LayerPlayback::onTransportEvent)
+    void onTransportEvent(const TransportEvent& event);
+    void loadPendingFrame();
+    bool canLoadOffRenderThread() const;
+    void finishUpdate();
+    
+    // Newer already-decoded frame just before the draw (see LayerPlayback::latchSync)
+    bool latchSync();
+    
     // Render layer (called from display backend)
     bool render(FrameBuffer& outputBuffer);
 
@@ -67,11 +102,24 @@ public:
     
     // Check if current frame is on GPU
     bool isFrameOnGPU() const;
+    
+    // Decode ring for zero-copy uploads (nullptr while the CPU modifies frames)
+    std::shared_ptr<MappedFrameRing> getFrameRing() const;
+    
+    // Prepared frame is a still image shown unmodified: upload it once
+    bool hasStaticFrame() const;
+
+    // Tiles of a giant still shown unmodified (nullptr = draw the frame)
+    std::shared_ptr<TiledImage> getTiledImage() const;
 
     // Layer ID
     void setLayerId(int id) { layerId_ = id; }
     int getLayerId() const { return layerId_; }
     
+    // Slot of the properties in the manager's LayerPropertyStore (-1 = own copy)
+    void bindPropertySlot(LayerProperties* storage, int slot) { display_.bindProperties(storage); propertySlot_ = slot; }
+    int getPropertySlot() const { return propertySlot_; }
+    
     // Time-scaling (applied to sync source frames)
     void setTimeOffset(int64_t offset);
     int64_t getTimeOffset() const;
@@ -88,18 +136,97 @@ public:
     
     // Reverse playback (multiplies timescale by -1.0 and adjusts offset)
     void reverse();
+    
+    // Standby: hide the layer and have its start frame decoded (and on the
+    // GPU, see OpenGLRenderer::prepareArmedLayers) while sync is ignored;
+    // go() shows it and resumes sync from that frame
+    void arm(int64_t frameNumber);
+    void go();
+    bool isArmed() const;
+    bool isArmedFrameReady() const;
+    
+    // Cue list for locate prefetching (sync source frames)
+    void setCuePoints(const std::vector<int64_t>& syncFrames);
+    
+    // Decode-ahead budget share relative to other layers (1 = default)
+    void setDecodePriority(int priority);
+    int getDecodePriority() const;
+    
+    // Frame shown when the decoder falls behind (default: block and decode)
+    void setUnderrunPolicy(InputSource::UnderrunPolicy policy);
+    
+    // GPU loop cache (see LoopFrameCache): a looping region or file is kept
+    // decoded in VRAM after its first pass (default: off). Null when off.
+    void setLoopCacheMode(LoopFrameCache::Mode mode);
+    LoopFrameCache::Mode getLoopCacheMode() const;
+    std::shared_ptr<LoopFrameCache> getLoopCache() const { return loopCache_; }
+    
+    // Occlusion: set by the renderer when opaque layers above cover this one
+    // completely. Opt-in: stop loading frames while occluded (the position
+    // keeps following sync, the current frame is loaded again on reveal).
+    void setOccluded(bool occluded) const { occluded_ = occluded; }
+    bool isOccluded() const { return occluded_; }
+    void setSuspendWhenOccluded(bool enabled) { suspendWhenOccluded_ = enabled; }
+    bool getSuspendWhenOccluded() const { return suspendWhenOccluded_; }
+    
+    // Load governor (DecodeGovernor): critical layers are never degraded;
+    // a degraded layer may load only every n-th frame
+    void setCritical(bool critical) { critical_ = critical; }
+    bool isCritical() const { return critical_; }
+    void setRateDivisor(int divisor);
+    int getRateDivisor() const;
+    double getLoadTime() const;  // Seconds per frame load, smoothed
+    
+    // On-canvas size in output pixels from the last composite (set by the
+    // renderer, 0 = unknown)
+    void setDisplaySize(int width, int height) const { displayWidth_ = width; displayHeight_ = height; }
+    
+    // Resolution a source loaded into this layer needs to look as it does
+    // now (0x0 = full: unknown, or cropped to a part of the frame)
+    void getResolutionHint(int& width, int& height) const;
+    
+    // Field of an interlaced frame due this output frame: 0 = first in
+    // time, 1 = second (see FieldSelector; the renderer draws it)
+    int getFieldPhase() const { return fieldSelector_.getPhase(); }
 
 private:
     // Composed components
     LayerPlayback playback_;
     LayerDisplay display_;
+    PropertyAnimator animator_;
     
     // Layer identification
     int layerId_;
+    int propertySlot_ = -1;
     
     // Backward compatibility: CPU frame buffer cache
     mutable FrameBuffer frameBufferCache_;
     mutable bool frameBufferCacheValid_;
+    
+    // Occlusion state from the last composite (renderer holds const layers)
+    mutable bool occluded_;
+    bool suspendWhenOccluded_;
+    bool critical_;
+    bool seekHidLayer_;     // Hidden by a BLANK asynchronous seek, shown when it completes
+    mutable int displayWidth_;
+    mutable int displayHeight_;
+    FieldSelector fieldSelector_;
+    std::shared_ptr<LoopFrameCache> loopCache_;
+    
+    // Tell playback whether planar YUV frames are usable for current properties
+    void updatePlanarOutput();
+    
+    // Keep the loop region start / file start pre-decoded while a loop can wrap
+    void updateLoopPrefetch();
+    
+    // Give the loop cache the frames one pass of the loop plays
+    void updateLoopCache();
+    
+    // Push the source's frame info to the display after a source change
+    void refreshFrameInfo();
+    
+    // Deinterlace field for the frame shown (after a frame change)
+    void updateFieldPhase();
 };
 
 } // namespace videocomposer
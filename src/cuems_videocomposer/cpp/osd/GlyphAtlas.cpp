@@ -0,0 +1,124 @@
+#include "GlyphAtlas.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace videocomposer {
+
+GlyphAtlas::GlyphAtlas(int width, int height)
+    : width_(width)
+    , height_(height)
+    , fontSize_(0)
+    , pixels_(static_cast<size_t>(width) * height, 0)
+    , glyphCount_(0)
+    , dirty_(false)
+    , shelfX_(0)
+    , shelfY_(0)
+    , shelfHeight_(0)
+{
+    present_.fill(false);
+}
+
+void GlyphAtlas::reset(int fontSize) {
+    fontSize_ = fontSize;
+    std::fill(pixels_.begin(), pixels_.end(), 0);
+    present_.fill(false);
+    glyphCount_ = 0;
+    shelfX_ = 0;
+    shelfY_ = 0;
+    shelfHeight_ = 0;
+    dirty_ = true;
+}
+
+bool GlyphAtlas::add(unsigned char code, const Glyph& metrics, const uint8_t* bitmap, int pitch) {
+    Glyph glyph = metrics;
+    if (glyph.width < 0 || glyph.height < 0 || glyph.width > width_ || glyph.height > height_) {
+        return false;
+    }
+
+    if (glyph.width > 0 && glyph.height > 0) {
+        if (shelfX_ + glyph.width > width_) {
+            // Start a new shelf below the current one
+            shelfY_ += shelfHeight_ + GUTTER;
+            shelfX_ = 0;
+            shelfHeight_ = 0;
+        }
+        if (shelfY_ + glyph.height > height_) {
+            return false;
+        }
+
+        glyph.x = shelfX_;
+        glyph.y = shelfY_;
+        for (int row = 0; row < glyph.height; ++row) {
+            std::memcpy(&pixels_[static_cast<size_t>(glyph.y + row) * width_ + glyph.x],
+                        bitmap + static_cast<ptrdiff_t>(row) * pitch, glyph.width);
+        }
+        shelfX_ += glyph.width + GUTTER;
+        shelfHeight_ = std::max(shelfHeight_, glyph.height);
+        dirty_ = true;
+    } else {
+        glyph.width = 0;
+        glyph.height = 0;
+    }
+
+    if (!present_[code]) {
+        ++glyphCount_;
+    }
+    glyphs_[code] = glyph;
+    present_[code] = true;
+    return true;
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::find(unsigned char code) const {
+    return present_[code] ? &glyphs_[code] : nullptr;
+}
+
+bool GlyphAtlas::containsAll(const std::string& text) const {
+    for (char c : text) {
+        if (!present_[static_cast<unsigned char>(c)]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int GlyphAtlas::layout(const std::string& text, ArenaVector<GlyphQuad>& quads, int& ascent, int& descent) const {
+    quads.clear();
+    ascent = 0;
+    descent = 0;
+
+    // Extent of the line first: quads are placed relative to its top
+    for (char c : text) {
+        const Glyph* glyph = find(static_cast<unsigned char>(c));
+        if (glyph && glyph->height > 0) {
+            ascent = std::max(ascent, glyph->bearingY);
+            descent = std::max(descent, glyph->height - glyph->bearingY);
+        }
+    }
+
+    const float invWidth = 1.0f / width_;
+    const float invHeight = 1.0f / height_;
+    int penX = 0;
+    for (char c : text) {
+        const Glyph* glyph = find(static_cast<unsigned char>(c));
+        if (!glyph) {
+            continue;
+        }
+        if (glyph->width > 0) {
+            GlyphQuad quad;
+            quad.x = penX + glyph->bearingX;
+            quad.y = ascent - glyph->bearingY;
+            quad.width = glyph->width;
+            quad.height = glyph->height;
+            quad.u0 = glyph->x * invWidth;
+            quad.v0 = glyph->y * invHeight;
+            quad.u1 = (glyph->x + glyph->width) * invWidth;
+            quad.v1 = (glyph->y + glyph->height) * invHeight;
+            quads.push_back(quad);
+        }
+        penX += glyph->advance;
+    }
+    return penX;
+}
+
+} // namespace videocomposer
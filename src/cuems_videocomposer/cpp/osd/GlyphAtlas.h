@@ -0,0 +1,102 @@
+#ifndef VIDEOCOMPOSER_GLYPHATLAS_H
+#define VIDEOCOMPOSER_GLYPHATLAS_H
+
+#include "../utils/FrameArena.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * One glyph of laid-out text: destination rectangle in pixels relative to
+ * the text's top-left corner, and its source rectangle in the atlas
+ * (normalised texture coordinates, v = 0 at the top row)
+ */
+struct GlyphQuad {
+    int x, y;
+    int width, height;
+    float u0, v0, u1, v1;
+};
+
+/**
+ * GlyphAtlas - Rasterized glyphs of one font size packed into one bitmap
+ *
+ * Glyph coverage bitmaps are packed into a single alpha image on shelves
+ * (rows of glyphs, each as high as its tallest glyph), together with their
+ * metrics. Text is then laid out from the cached metrics as one quad per
+ * glyph, so drawing changing text (timecode, frame numbers) needs neither
+ * rasterization nor a new texture. FreeType and GL stay with the caller:
+ * it rasterizes glyphs the atlas doesn't have yet and uploads pixels()
+ * when isDirty().
+ */
+class GlyphAtlas {
+public:
+    struct Glyph {
+        int x = 0, y = 0;           // Position in the atlas
+        int width = 0, height = 0;  // Bitmap size (0 for blanks)
+        int bearingX = 0;           // Pen to bitmap left edge
+        int bearingY = 0;           // Baseline to bitmap top (up is positive)
+        int advance = 0;            // Pen advance
+    };
+
+    static constexpr int DEFAULT_SIZE = 512;
+
+    explicit GlyphAtlas(int width = DEFAULT_SIZE, int height = DEFAULT_SIZE);
+
+    /** Drop all glyphs and start over for a font size (0 = none) */
+    void reset(int fontSize);
+    int getFontSize() const { return fontSize_; }
+
+    /**
+     * Pack a glyph's coverage bitmap (one byte per pixel, pitch bytes per row)
+     * @return false if it doesn't fit (the glyph is not added)
+     */
+    bool add(unsigned char code, const Glyph& metrics, const uint8_t* bitmap, int pitch);
+
+    /** Cached glyph, or nullptr if not rasterized yet */
+    const Glyph* find(unsigned char code) const;
+
+    /** True if every character of text has a glyph */
+    bool containsAll(const std::string& text) const;
+
+    /**
+     * Lay out one line of text from the cached metrics (missing glyphs are
+     * skipped); ascent/descent are the extent above and below the baseline
+     * @return Text width in pixels
+     */
+    int layout(const std::string& text, ArenaVector<GlyphQuad>& quads, int& ascent, int& descent) const;
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    size_t getGlyphCount() const { return glyphCount_; }
+
+    /** Coverage image, row-major, top row first */
+    const std::vector<uint8_t>& pixels() const { return pixels_; }
+
+    /** Set when glyphs were added since the last markClean() */
+    bool isDirty() const { return dirty_; }
+    void markClean() { dirty_ = false; }
+
+private:
+    static constexpr int GUTTER = 1;  // Empty pixels between glyphs (no bleeding with linear filtering)
+
+    int width_;
+    int height_;
+    int fontSize_;
+    std::vector<uint8_t> pixels_;
+    std::array<Glyph, 256> glyphs_;
+    std::array<bool, 256> present_;
+    size_t glyphCount_;
+    bool dirty_;
+
+    // Shelf packing state
+    int shelfX_;
+    int shelfY_;
+    int shelfHeight_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_GLYPHATLAS_H
@@ -8,6 +8,7 @@ namespace videocomposer {
 
 OSDManager::OSDManager()
     : mode_(BOX)  // BOX enabled by default (matches xjadeo: OSD_mode = OSD_BOX in ui_osd_clear)
+    , version_(0)
     , frameXAlign_(1)  // Center by default (OSD_CENTER = -2 in xjadeo, we use 1)
     , frameYPercent_(95)  // Default 95% from top (matches xjadeo's default when frame enabled)
     , smpteXAlign_(1)  // Center by default (OSD_CENTER = -2 in xjadeo, we use 1)
@@ -21,8 +22,8 @@ OSDManager::~OSDManager() {
 }
 
 void OSDManager::setFramePosition(int xAlign, int yPercent) {
-    frameXAlign_ = xAlign;
-    frameYPercent_ = yPercent;
+    change(frameXAlign_, xAlign);
+    change(frameYPercent_, yPercent);
 }
 
 void OSDManager::setFrameNumber(int64_t frame) {
@@ -32,57 +33,62 @@ void OSDManager::setFrameNumber(int64_t frame) {
 void OSDManager::formatFrameNumber(int64_t frame) {
     std::ostringstream oss;
     oss << frame;
-    frameText_ = oss.str();
+    change(frameText_, oss.str());
 }
 
 void OSDManager::setSMPTEPosition(int xAlign, int yPercent) {
-    smpteXAlign_ = xAlign;
-    smpteYPercent_ = yPercent;
+    change(smpteXAlign_, xAlign);
+    change(smpteYPercent_, yPercent);
 }
 
 void OSDManager::setSMPTETimecode(const std::string& tc) {
-    smpteText_ = tc;
+    change(smpteText_, tc);
 }
 
 void OSDManager::setText(const std::string& text) {
-    text_ = text;
+    change(text_, text);
     if (!text_.empty()) {
         enableMode(TEXT);
     }
 }
 
 void OSDManager::setTextPosition(int xAlign, int yPercent) {
-    textXAlign_ = xAlign;
-    textYPercent_ = yPercent;
+    change(textXAlign_, xAlign);
+    change(textYPercent_, yPercent);
 }
 
 void OSDManager::setFontFile(const std::string& fontFile) {
-    fontFile_ = fontFile;
+    change(fontFile_, fontFile);
 }
 
 void OSDManager::setMessage(const std::string& msg) {
-    message_ = msg;
+    change(message_, msg);
     if (!message_.empty()) {
         enableMode(MSG);
     }
 }
 
+void OSDManager::setGpuTimings(const std::vector<std::string>& lines) {
+    change(gpuTimings_, lines);
+}
+
 void OSDManager::clear() {
-    mode_ = BOX;  // Matches xjadeo: OSD_mode = OSD_BOX when clearing
-    frameText_.clear();
-    smpteText_.clear();
-    text_.clear();
-    message_.clear();
+    changeMode(BOX);  // Matches xjadeo: OSD_mode = OSD_BOX when clearing
+    change(frameText_, std::string());
+    change(smpteText_, std::string());
+    change(text_, std::string());
+    change(message_, std::string());
+    change(gpuTimings_, std::vector<std::string>());
 }
 
 void OSDManager::formatSMPTE(int64_t frame, double framerate) {
     if (framerate <= 0.0) {
-        smpteText_ = "00:00:00:00";
+        change(smpteText_, std::string("00:00:00:00"));
         return;
     }
     
     // Use SMPTEUtils for proper timecode formatting (handles drop-frames, etc.)
-    smpteText_ = SMPTEUtils::frameToSmpteString(frame, framerate, false, false, false, true);
+    change(smpteText_, SMPTEUtils::frameToSmpteString(frame, framerate, false, false, false, true));
 }
 
 } // namespace videocomposer
@@ -2,6 +2,7 @@
 #define VIDEOCOMPOSER_OSDMANAGER_H
 
 #include <string>
+#include <vector>
 #include <cstdint>
 
 namespace videocomposer {
@@ -25,17 +26,18 @@ public:
         MSG      = 0x0080,  // Display message
         NFO      = 0x0400,  // Display file info
         POS      = 0x1000,  // Display position
-        GEO      = 0x2000   // Display geometry
+        GEO      = 0x2000,  // Display geometry
+        GPU      = 0x4000   // Display GPU timings (one line per section)
     };
 
     OSDManager();
     ~OSDManager();
 
     // Mode control
-    void setMode(int mode) { mode_ = mode; }
+    void setMode(int mode) { changeMode(mode); }
     int getMode() const { return mode_; }
-    void enableMode(Mode flag) { mode_ |= flag; }
-    void disableMode(Mode flag) { mode_ &= ~flag; }
+    void enableMode(Mode flag) { changeMode(mode_ | flag); }
+    void disableMode(Mode flag) { changeMode(mode_ & ~flag); }
     bool isModeEnabled(Mode flag) const { return (mode_ & flag) != 0; }
 
     // Frame number display
@@ -43,35 +45,43 @@ public:
     int getFrameXAlign() const { return frameXAlign_; }
     int getFrameYPercent() const { return frameYPercent_; }
     void setFrameNumber(int64_t frame);
-    std::string getFrameText() const { return frameText_; }
+    const std::string& getFrameText() const { return frameText_; }
 
     // SMPTE timecode display
     void setSMPTEPosition(int xAlign, int yPercent);
     int getSMPTEXAlign() const { return smpteXAlign_; }
     int getSMPTEYPercent() const { return smpteYPercent_; }
     void setSMPTETimecode(const std::string& tc);
-    std::string getSMPTETimecode() const { return smpteText_; }
+    const std::string& getSMPTETimecode() const { return smpteText_; }
 
     // Custom text display
     void setText(const std::string& text);
-    std::string getText() const { return text_; }
+    const std::string& getText() const { return text_; }
     void setTextPosition(int xAlign, int yPercent);
     int getTextXAlign() const { return textXAlign_; }
     int getTextYPercent() const { return textYPercent_; }
 
     // Font configuration
     void setFontFile(const std::string& fontFile);
-    std::string getFontFile() const { return fontFile_; }
+    const std::string& getFontFile() const { return fontFile_; }
 
     // Message display (temporary)
     void setMessage(const std::string& msg);
-    std::string getMessage() const { return message_; }
+    const std::string& getMessage() const { return message_; }
+
+    // GPU timings overlay (lines made by the application, see GpuTimingStats)
+    void setGpuTimings(const std::vector<std::string>& lines);
+    const std::vector<std::string>& getGpuTimings() const { return gpuTimings_; }
 
     // Clear all OSD
     void clear();
 
+    // Bumped by every change of what the OSD shows (idle detection)
+    uint64_t getVersion() const { return version_; }
+
 private:
     int mode_;
+    uint64_t version_;
     
     // Frame number display
     int frameXAlign_;  // 0=left, 1=center, 2=right
@@ -94,9 +104,22 @@ private:
     // Temporary message
     std::string message_;
     
+    // GPU timings overlay
+    std::vector<std::string> gpuTimings_;
+    
     // Helper to format frame number
     void formatFrameNumber(int64_t frame);
     
+    // Set a member, bumping the version if it changes
+    template <typename T>
+    void change(T& member, const T& value) {
+        if (!(member == value)) {
+            member = value;
+            version_++;
+        }
+    }
+    void changeMode(int mode) { change(mode_, mode); }
+    
     // Helper to format SMPTE timecode
     void formatSMPTE(int64_t frame, double framerate);
 };
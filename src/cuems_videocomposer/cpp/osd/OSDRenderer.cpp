@@ -22,6 +22,7 @@ OSDRenderer::OSDRenderer()
     , ftLibrary_(nullptr)
     , ftFace_(nullptr)
     , fontSize_(24)  // Will be recalculated based on video height
+    , atlasTexture_(0)
 {
 }
 
@@ -49,6 +50,12 @@ bool OSDRenderer::init() {
 }
 
 void OSDRenderer::cleanup() {
+    // Called with the GL context current (see the displays' closeWindow)
+    if (atlasTexture_ != 0) {
+        glDeleteTextures(1, &atlasTexture_);
+        atlasTexture_ = 0;
+    }
+    atlas_.reset(0);
 #ifdef HAVE_FT
     if (ftFace_) {
         FT_Done_Face(reinterpret_cast<FT_Face>(ftFace_));
@@ -128,48 +135,13 @@ bool OSDRenderer::loadFont(const std::string& fontFile) {
     }
 
     currentFontFile_ = fontFile;
+    atlas_.reset(0);  // New face: rasterize again on next use
     return true;
 #else
     return false;
 #endif
 }
 
-void OSDRenderer::measureText(const std::string& text, int& width, int& height) {
-    width = 0;
-    height = 0;
-
-#ifdef HAVE_FT
-    if (!freetypeAvailable_ || !ftFace_) {
-        // Fallback: estimate based on character count
-        width = static_cast<int>(text.length() * fontSize_ * 0.6);
-        height = fontSize_;
-        return;
-    }
-
-    FT_Face face = reinterpret_cast<FT_Face>(ftFace_);
-    FT_GlyphSlot slot = face->glyph;
-    int maxHeight = 0;
-    int currentWidth = 0;
-
-    for (size_t n = 0; n < text.length(); ++n) {
-        FT_Error error = FT_Load_Char(face, text[n], FT_LOAD_RENDER);
-        if (error) continue;
-
-        currentWidth += slot->advance.x >> 6;
-        if (static_cast<int>(slot->bitmap.rows) > maxHeight) {
-            maxHeight = static_cast<int>(slot->bitmap.rows);
-        }
-    }
-
-    width = currentWidth;
-    height = maxHeight > 0 ? maxHeight : fontSize_;
-#else
-    // Fallback: estimate
-    width = static_cast<int>(text.length() * fontSize_ * 0.6);
-    height = fontSize_;
-#endif
-}
-
 int OSDRenderer::calculateFontSize(int videoHeight) const {
     // Matches xjadeo formula: MIN(MAX(13, height / 18), 56)
     int size = videoHeight / 18;
@@ -178,163 +150,148 @@ int OSDRenderer::calculateFontSize(int videoHeight) const {
     return size;
 }
 
-unsigned int OSDRenderer::renderTextToTexture(const std::string& text, int& width, int& height, bool createBox) {
-    if (text.empty()) {
-        width = 0;
-        height = 0;
-        return 0;
-    }
-
+bool OSDRenderer::applyFontSize() {
 #ifdef HAVE_FT
-    if (!freetypeAvailable_) {
-        LOG_WARNING << "OSD: Freetype not available";
-        width = 0;
-        height = 0;
-        return 0;
-    }
-    
     if (!ftFace_) {
-        // Try to load default font if not loaded
-        if (!loadFont("")) {
-            LOG_WARNING << "OSD: Failed to load default font";
-            width = 0;
-            height = 0;
-            return 0;
-        }
+        return false;
     }
+    FT_Error error = FT_Set_Char_Size(reinterpret_cast<FT_Face>(ftFace_), 0, fontSize_ * 64, 0, 72);
+    if (error) {
+        LOG_WARNING << "Failed to set font size";
+        return false;
+    }
+    // Glyphs of the old size are no longer valid
+    atlas_.reset(0);
+    return true;
+#else
+    return false;
+#endif
+}
 
+bool OSDRenderer::rasterizeGlyph(unsigned char code) {
+#ifdef HAVE_FT
     FT_Face face = reinterpret_cast<FT_Face>(ftFace_);
-    FT_GlyphSlot slot = face->glyph;
+    FT_Error error = FT_Load_Char(face, code, FT_LOAD_RENDER);
+    if (error) {
+        LOG_WARNING << "OSD: Failed to load character: " << static_cast<int>(code) << " (error: " << error << ")";
+        return false;
+    }
 
-    // Measure text first
-    measureText(text, width, height);
+    FT_GlyphSlot slot = face->glyph;
+    FT_Bitmap* bmp = &slot->bitmap;
+    if (bmp->pixel_mode != FT_PIXEL_MODE_GRAY) {
+        LOG_WARNING << "OSD: Unexpected bitmap pixel mode: " << bmp->pixel_mode << " (expected GRAY)";
+        return false;
+    }
 
-    if (width == 0 || height == 0) {
-        return 0;
+    GlyphAtlas::Glyph metrics;
+    metrics.width = static_cast<int>(bmp->width);
+    metrics.height = static_cast<int>(bmp->rows);
+    metrics.bearingX = slot->bitmap_left;
+    metrics.bearingY = slot->bitmap_top;
+    metrics.advance = static_cast<int>(slot->advance.x >> 6);
+    if (!atlas_.add(code, metrics, bmp->buffer, bmp->pitch)) {
+        LOG_WARNING << "OSD: Glyph atlas full, dropping character: " << static_cast<int>(code);
+        return false;
     }
+    return true;
+#else
+    (void)code;
+    return false;
+#endif
+}
 
-    // Add padding for box if needed
-    int padding = createBox ? 8 : 4;
-    int texWidth = width + padding * 2;
-    int texHeight = height + padding * 2;
+bool OSDRenderer::ensureGlyphs(const std::string& text) {
+    if (!ftFace_) {
+        return false;
+    }
 
-    // Create bitmap buffer (RGBA) - initialize to fully transparent
-    // RGB values don't matter when A=0 with proper blending, but use black for consistency
-    std::vector<unsigned char> bitmap(texWidth * texHeight * 4, 0);
-    
-    // Initialize all pixels to fully transparent (A=0)
-    // RGB values are set to 0 but won't be visible when alpha blending is correct
-    for (int y = 0; y < texHeight; ++y) {
-        for (int x = 0; x < texWidth; ++x) {
-            int idx = (y * texWidth + x) * 4;
-            bitmap[idx] = 0;       // R = 0
-            bitmap[idx + 1] = 0;   // G = 0
-            bitmap[idx + 2] = 0;   // B = 0
-            bitmap[idx + 3] = 0;   // A = 0 (fully transparent)
+    if (atlas_.getFontSize() != fontSize_) {
+        // New font or size: rasterize the printable ASCII range once, which
+        // covers timecode, frame numbers and most messages
+        atlas_.reset(fontSize_);
+        for (int code = 32; code < 127; ++code) {
+            rasterizeGlyph(static_cast<unsigned char>(code));
         }
     }
 
-    // Fill with black box if requested
-    if (createBox) {
-        // Fill entire bitmap with opaque black (R=0, G=0, B=0, A=255)
-        for (int y = 0; y < texHeight; ++y) {
-            for (int x = 0; x < texWidth; ++x) {
-                int idx = (y * texWidth + x) * 4;
-                bitmap[idx] = 0;     // R = 0 (black)
-                bitmap[idx + 1] = 0; // G = 0 (black)
-                bitmap[idx + 2] = 0; // B = 0 (black)
-                bitmap[idx + 3] = 255; // A = 255 (fully opaque)
+    if (!atlas_.containsAll(text)) {
+        for (char c : text) {
+            unsigned char code = static_cast<unsigned char>(c);
+            if (!atlas_.find(code)) {
+                rasterizeGlyph(code);
             }
         }
     }
+    return true;
+}
 
-    // Render text
-    int penX = padding;
-    int penY = padding + height; // Baseline
-
-    for (size_t n = 0; n < text.length(); ++n) {
-        FT_Error error = FT_Load_Char(face, text[n], FT_LOAD_RENDER);
-        if (error) {
-            LOG_WARNING << "OSD: Failed to load character: " << text[n] << " (error: " << error << ")";
-            continue;
-        }
-
-        FT_Bitmap* bmp = &slot->bitmap;
-        int x = penX + slot->bitmap_left;
-        int y = penY - slot->bitmap_top;
+bool OSDRenderer::uploadAtlas() {
+    if (atlasTexture_ != 0 && !atlas_.isDirty()) {
+        return true;
+    }
 
-        // Check bitmap format
-        if (bmp->pixel_mode != FT_PIXEL_MODE_GRAY) {
-            LOG_WARNING << "OSD: Unexpected bitmap pixel mode: " << bmp->pixel_mode << " (expected GRAY)";
-        }
+    // White texels with the glyph coverage as alpha (drawn with MODULATE)
+    const std::vector<uint8_t>& coverage = atlas_.pixels();
+    std::vector<unsigned char> rgba(coverage.size() * 4, 255);
+    for (size_t i = 0; i < coverage.size(); ++i) {
+        rgba[i * 4 + 3] = coverage[i];
+    }
 
-        // Draw bitmap
-        for (int row = 0; row < static_cast<int>(bmp->rows); ++row) {
-            for (int col = 0; col < static_cast<int>(bmp->width); ++col) {
-                int px = x + col;
-                int py = y + row;
-
-                if (px >= 0 && px < texWidth && py >= 0 && py < texHeight) {
-                    // FreeType bitmap is grayscale (alpha channel)
-                    // Buffer is row-major, with pitch bytes per row
-                    unsigned char alpha = bmp->buffer[row * bmp->pitch + col];
-                    int idx = (py * texWidth + px) * 4;
-
-                    // White text on existing background (black box or transparent)
-                    // Only overwrite if there's actual glyph data (alpha > 0)
-                    if (alpha > 0) {
-                    bitmap[idx] = 255;     // R
-                    bitmap[idx + 1] = 255; // G
-                    bitmap[idx + 2] = 255; // B
-                    bitmap[idx + 3] = alpha; // A
-                    }
-                    // If alpha is 0, keep existing pixel (black box or transparent)
-                }
-            }
+    if (atlasTexture_ == 0) {
+        glGenTextures(1, &atlasTexture_);
+        if (atlasTexture_ == 0) {
+            return false;
         }
-
-        penX += slot->advance.x >> 6;
+        glBindTexture(GL_TEXTURE_2D, atlasTexture_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // Row 0 of the atlas is its top; quads use v = 0 at the top to match
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas_.getWidth(), atlas_.getHeight(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    } else {
+        // Only when glyphs were added (new size or character), not per text change
+        glBindTexture(GL_TEXTURE_2D, atlasTexture_);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlas_.getWidth(), atlas_.getHeight(),
+                        GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
     }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    atlas_.markClean();
+    return true;
+}
 
-    // Create OpenGL texture
-    unsigned int textureId;
-    glGenTextures(1, &textureId);
-    if (textureId == 0) {
-        return 0;
+bool OSDRenderer::layoutText(const std::string& text, bool createBox, OSDRenderItem& item) {
+    if (text.empty() || !ensureGlyphs(text) || !uploadAtlas()) {
+        return false;
     }
 
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // Upload texture data
-    // Note: OpenGL expects RGBA with (0,0) at bottom-left, but our bitmap has (0,0) at top-left
-    // We'll handle the Y-flip in the texture coordinates during rendering
-    // Use GL_RGBA8 internal format for explicit 8-bit per channel
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texWidth, texHeight, 0,
-                 GL_RGBA, GL_UNSIGNED_BYTE, bitmap.data());
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return textureId;
-#else
-    // No Freetype - return 0
-    width = 0;
-    height = 0;
-    return 0;
-#endif
-}
+    int ascent = 0, descent = 0;
+    int textWidth = atlas_.layout(text, item.glyphs, ascent, descent);
+    int textHeight = ascent + descent;
+    if (textWidth == 0) {
+        return false;
+    }
+    if (textHeight == 0) {
+        textHeight = fontSize_;  // Blanks only
+    }
 
-void OSDRenderer::cleanupTexture(unsigned int textureId) {
-    if (textureId != 0) {
-        glDeleteTextures(1, &textureId);
+    // Padding around the text (the box extends into it)
+    int padding = createBox ? 8 : 4;
+    for (auto& quad : item.glyphs) {
+        quad.x += padding;
+        quad.y += padding;
     }
+    item.textureId = atlasTexture_;
+    item.width = textWidth + padding * 2;
+    item.height = textHeight + padding * 2;
+    item.hasBox = createBox;
+    return true;
 }
 
-std::vector<OSDRenderItem> OSDRenderer::prepareOSDRender(OSDManager* osd, int windowWidth, int windowHeight) {
-    std::vector<OSDRenderItem> items;
+ArenaVector<OSDRenderItem> OSDRenderer::prepareOSDRender(OSDManager* osd, int windowWidth, int windowHeight) {
+    ArenaVector<OSDRenderItem> items;
 
     if (!osd || !initialized_ || windowWidth <= 0 || windowHeight <= 0) {
         return items;
@@ -344,36 +301,29 @@ std::vector<OSDRenderItem> OSDRenderer::prepareOSDRender(OSDManager* osd, int wi
     int newFontSize = calculateFontSize(windowHeight);
     if (newFontSize != fontSize_) {
         fontSize_ = newFontSize;
-        // Reload font with new size if font is already loaded
-        if (ftFace_) {
-            std::string fontFile = osd->getFontFile();
-            loadFont(fontFile);
-        }
+        applyFontSize();
     }
 
     // Load font if needed
-    std::string fontFile = osd->getFontFile();
+    const std::string& fontFile = osd->getFontFile();
     if (!fontFile.empty() || !ftFace_) {
         loadFont(fontFile);
     }
+    if (!ftFace_) {
+        return items;
+    }
+
+    bool hasBox = osd->isModeEnabled(OSDManager::BOX);
 
     // Render frame number if enabled
     if (osd->isModeEnabled(OSDManager::FRAME)) {
-        std::string frameText = osd->getFrameText();
+        const std::string& frameText = osd->getFrameText();
         if (!frameText.empty()) {
-        int textWidth, textHeight;
-        bool hasBox = osd->isModeEnabled(OSDManager::BOX);
-            unsigned int texId = renderTextToTexture(frameText, textWidth, textHeight, hasBox);
-        
-        if (texId != 0) {
             OSDRenderItem item;
-            item.textureId = texId;
-            item.width = textWidth;
-            item.height = textHeight;
-            item.hasBox = hasBox;
-            item.y = calculateYPosition(osd->getFrameYPercent(), textHeight, windowHeight);
-            item.x = calculateXPosition(osd->getFrameXAlign(), textWidth, windowWidth);
-            items.push_back(item);
+            if (layoutText(frameText, hasBox, item)) {
+                item.y = calculateYPosition(osd->getFrameYPercent(), item.height, windowHeight);
+                item.x = calculateXPosition(osd->getFrameXAlign(), item.width, windowWidth);
+                items.push_back(std::move(item));
             } else {
                 LOG_WARNING << "OSD: Failed to render frame text: '" << frameText << "'";
             }
@@ -384,21 +334,13 @@ std::vector<OSDRenderItem> OSDRenderer::prepareOSDRender(OSDManager* osd, int wi
 
     // Render SMPTE timecode if enabled
     if (osd->isModeEnabled(OSDManager::SMPTE)) {
-        std::string smpteText = osd->getSMPTETimecode();
+        const std::string& smpteText = osd->getSMPTETimecode();
         if (!smpteText.empty()) {
-        int textWidth, textHeight;
-        bool hasBox = osd->isModeEnabled(OSDManager::BOX);
-            unsigned int texId = renderTextToTexture(smpteText, textWidth, textHeight, hasBox);
-        
-        if (texId != 0) {
             OSDRenderItem item;
-            item.textureId = texId;
-            item.width = textWidth;
-            item.height = textHeight;
-            item.hasBox = hasBox;
-            item.y = calculateYPosition(osd->getSMPTEYPercent(), textHeight, windowHeight);
-            item.x = calculateXPosition(osd->getSMPTEXAlign(), textWidth, windowWidth);
-            items.push_back(item);
+            if (layoutText(smpteText, hasBox, item)) {
+                item.y = calculateYPosition(osd->getSMPTEYPercent(), item.height, windowHeight);
+                item.x = calculateXPosition(osd->getSMPTEXAlign(), item.width, windowWidth);
+                items.push_back(std::move(item));
             } else {
                 LOG_WARNING << "OSD: Failed to render SMPTE text: '" << smpteText << "'";
             }
@@ -409,21 +351,13 @@ std::vector<OSDRenderItem> OSDRenderer::prepareOSDRender(OSDManager* osd, int wi
 
     // Render custom text if enabled
     if (osd->isModeEnabled(OSDManager::TEXT)) {
-        std::string text = osd->getText();
+        const std::string& text = osd->getText();
         if (!text.empty()) {
-        int textWidth, textHeight;
-        bool hasBox = osd->isModeEnabled(OSDManager::BOX);
-            unsigned int texId = renderTextToTexture(text, textWidth, textHeight, hasBox);
-        
-        if (texId != 0) {
             OSDRenderItem item;
-            item.textureId = texId;
-            item.width = textWidth;
-            item.height = textHeight;
-            item.hasBox = hasBox;
-            item.y = calculateYPosition(osd->getTextYPercent(), textHeight, windowHeight);
-            item.x = calculateXPosition(osd->getTextXAlign(), textWidth, windowWidth);
-            items.push_back(item);
+            if (layoutText(text, hasBox, item)) {
+                item.y = calculateYPosition(osd->getTextYPercent(), item.height, windowHeight);
+                item.x = calculateXPosition(osd->getTextXAlign(), item.width, windowWidth);
+                items.push_back(std::move(item));
             } else {
                 LOG_WARNING << "OSD: Failed to render text: '" << text << "'";
             }
@@ -434,19 +368,29 @@ std::vector<OSDRenderItem> OSDRenderer::prepareOSDRender(OSDManager* osd, int wi
 
     // Render message if enabled
     if (osd->isModeEnabled(OSDManager::MSG) && !osd->getMessage().empty()) {
-        int textWidth, textHeight;
-        bool hasBox = osd->isModeEnabled(OSDManager::BOX);
-        unsigned int texId = renderTextToTexture(osd->getMessage(), textWidth, textHeight, hasBox);
-        
-        if (texId != 0) {
+        OSDRenderItem item;
+        if (layoutText(osd->getMessage(), hasBox, item)) {
+            item.y = calculateYPosition(50, item.height, windowHeight); // Center
+            item.x = calculateXPosition(1, item.width, windowWidth); // Center
+            items.push_back(std::move(item));
+        }
+    }
+
+    // GPU timings: a left-aligned column from the top
+    if (osd->isModeEnabled(OSDManager::GPU)) {
+        int y = calculateYPosition(0, 0, windowHeight);
+        for (const std::string& line : osd->getGpuTimings()) {
             OSDRenderItem item;
-            item.textureId = texId;
-            item.width = textWidth;
-            item.height = textHeight;
-            item.hasBox = hasBox;
-            item.y = calculateYPosition(50, textHeight, windowHeight); // Center
-            item.x = calculateXPosition(1, textWidth, windowWidth); // Center
-            items.push_back(item);
+            if (!layoutText(line, hasBox, item)) {
+                continue;
+            }
+            item.x = calculateXPosition(0, item.width, windowWidth);
+            item.y = y;
+            y += item.height;
+            if (y > windowHeight) {
+                break;
+            }
+            items.push_back(std::move(item));
         }
     }
 
@@ -2,6 +2,7 @@
 #define VIDEOCOMPOSER_OSDRENDERER_H
 
 #include "OSDManager.h"
+#include "GlyphAtlas.h"
 #include <string>
 #include <memory>
 #include <vector>
@@ -10,17 +11,19 @@
 namespace videocomposer {
 
 /**
- * OSDRenderer - Renders OSD text using Freetype to OpenGL textures
+ * OSDRenderer - Renders OSD text using Freetype and a glyph atlas
  * 
  * This class handles the actual rendering of OSD elements onto the display.
- * It renders text using Freetype to bitmaps, then creates OpenGL textures
- * that can be composited by OpenGLRenderer.
+ * Glyphs are rasterized with Freetype once per font size into a GlyphAtlas
+ * texture owned by the renderer; each text becomes a list of glyph quads
+ * that OpenGLRenderer draws in one batch.
  */
 struct OSDRenderItem {
-    unsigned int textureId;
+    unsigned int textureId;         // Glyph atlas (owned by OSDRenderer, don't delete)
     int x, y;
-    int width, height;
+    int width, height;              // Box, text plus padding
     bool hasBox;  // Draw black box background
+    ArenaVector<GlyphQuad> glyphs;  // Relative to x, y
 };
 
 class OSDRenderer {
@@ -36,7 +39,8 @@ public:
 
     // Prepare OSD elements for rendering
     // Returns a list of render items that OpenGLRenderer can render
-    std::vector<OSDRenderItem> prepareOSDRender(OSDManager* osd, int windowWidth, int windowHeight);
+    // (in the current frame arena: valid until the render loop resets it)
+    ArenaVector<OSDRenderItem> prepareOSDRender(OSDManager* osd, int windowWidth, int windowHeight);
 
     // Check if Freetype is available
     bool isFreetypeAvailable() const { return freetypeAvailable_; }
@@ -54,17 +58,23 @@ private:
     std::string currentFontFile_;
     int fontSize_;
     
-    // Text rendering to texture
-    unsigned int renderTextToTexture(const std::string& text, int& width, int& height, bool createBox);
-    void cleanupTexture(unsigned int textureId);
+    // Glyph atlas for the current font and size, and its texture
+    GlyphAtlas atlas_;
+    unsigned int atlasTexture_;
+    
+    // Lay out text into a render item from the atlas
+    bool layoutText(const std::string& text, bool createBox, OSDRenderItem& item);
+    
+    // Rasterize glyphs missing from the atlas (all printable ASCII on a new size)
+    bool ensureGlyphs(const std::string& text);
+    bool rasterizeGlyph(unsigned char code);
+    bool uploadAtlas();
+    bool applyFontSize();
     
     // Calculate text position based on alignment
     int calculateXPosition(int xAlign, int textWidth, int windowWidth);
     int calculateYPosition(int yPercent, int textHeight, int windowHeight);
     
-    // Measure text dimensions
-    void measureText(const std::string& text, int& width, int& height);
-    
     // Calculate font size based on video/window height (matches xjadeo)
     int calculateFontSize(int videoHeight) const;
 };
@@ -0,0 +1,486 @@
+/**
+ * DeckLinkOutput.cpp - DeckLink (SDI/HDMI) program output sink
+ */
+
+#include "DeckLinkOutput.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace videocomposer {
+
+#ifdef HAVE_DECKLINK_SDK
+namespace {
+
+bool sameIID(REFIID a, const REFIID& b) {
+    return std::memcmp(&a, &b, sizeof(REFIID)) == 0;
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+std::string displayName(IDeckLink* device) {
+    const char* name = nullptr;
+    if (device->GetDisplayName(&name) != S_OK || !name) {
+        return "DeckLink";
+    }
+    std::string result = name;
+    free(const_cast<char*>(name));
+    return result;
+}
+
+std::string modeName(IDeckLinkDisplayMode* mode) {
+    const char* name = nullptr;
+    if (mode->GetName(&name) != S_OK || !name) {
+        return "";
+    }
+    std::string result = name;
+    free(const_cast<char*>(name));
+    return result;
+}
+
+/**
+ * A captured frame as the card sees it: no copy, the FrameData is held
+ * until the card releases the frame after showing it
+ */
+class SharedVideoFrame : public IDeckLinkVideoFrame {
+public:
+    explicit SharedVideoFrame(std::shared_ptr<const FrameData> frame)
+        : frame_(std::move(frame)), refCount_(1) {}
+    virtual ~SharedVideoFrame() = default;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override {
+        CFUUIDBytes iunknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+        if (sameIID(iid, iunknown) || sameIID(iid, IID_IDeckLinkVideoFrame)) {
+            *ppv = static_cast<IDeckLinkVideoFrame*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount_; }
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG count = --refCount_;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    long STDMETHODCALLTYPE GetWidth() override { return frame_->width; }
+    long STDMETHODCALLTYPE GetHeight() override { return frame_->height; }
+    long STDMETHODCALLTYPE GetRowBytes() override { return frame_->width * 2; }
+    BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat() override { return bmdFormat8BitYUV; }
+    BMDFrameFlags STDMETHODCALLTYPE GetFlags() override { return bmdFrameFlagDefault; }
+    HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) override {
+        *buffer = const_cast<uint8_t*>(frame_->data);
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE GetTimecode(BMDTimecodeFormat, IDeckLinkTimecode** timecode) override {
+        *timecode = nullptr;
+        return S_FALSE;
+    }
+    HRESULT STDMETHODCALLTYPE GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) override {
+        *ancillary = nullptr;
+        return S_FALSE;
+    }
+
+private:
+    std::shared_ptr<const FrameData> frame_;
+    std::atomic<ULONG> refCount_;
+};
+
+class CompletionCallback : public IDeckLinkVideoOutputCallback {
+public:
+    explicit CompletionCallback(DeckLinkOutput* owner) : owner_(owner), refCount_(1) {}
+    virtual ~CompletionCallback() = default;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override {
+        CFUUIDBytes iunknown = CFUUIDGetUUIDBytes(IUnknownUUID);
+        if (sameIID(iid, iunknown) || sameIID(iid, IID_IDeckLinkVideoOutputCallback)) {
+            *ppv = static_cast<IDeckLinkVideoOutputCallback*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount_; }
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG count = --refCount_;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE ScheduledFrameCompleted(IDeckLinkVideoFrame*,
+                                                      BMDOutputFrameCompletionResult result) override {
+        PlayoutSchedule::Completion completion = PlayoutSchedule::Completion::DISPLAYED;
+        switch (result) {
+            case bmdOutputFrameDisplayedLate: completion = PlayoutSchedule::Completion::LATE; break;
+            case bmdOutputFrameDropped: completion = PlayoutSchedule::Completion::DROPPED; break;
+            case bmdOutputFrameFlushed: completion = PlayoutSchedule::Completion::FLUSHED; break;
+            default: break;
+        }
+        owner_->onFrameCompleted(completion);
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE ScheduledPlaybackHasStopped() override { return S_OK; }
+
+private:
+    DeckLinkOutput* owner_;
+    std::atomic<ULONG> refCount_;
+};
+
+IDeckLinkDisplayMode* findMode(IDeckLinkOutput* output, const OutputSinkConfig& config) {
+    IDeckLinkDisplayModeIterator* iterator = nullptr;
+    if (output->GetDisplayModeIterator(&iterator) != S_OK) {
+        return nullptr;
+    }
+    std::string wanted = lowercase(config.codec);
+    IDeckLinkDisplayMode* best = nullptr;
+    IDeckLinkDisplayMode* mode = nullptr;
+    while (iterator->Next(&mode) == S_OK) {
+        bool match = false;
+        if (!wanted.empty()) {
+            match = lowercase(modeName(mode)) == wanted;
+        } else {
+            BMDTimeValue duration = 0;
+            BMDTimeScale scale = 0;
+            mode->GetFrameRate(&duration, &scale);
+            double rate = duration > 0 ? static_cast<double>(scale) / duration : 0.0;
+            match = mode->GetWidth() == config.width && mode->GetHeight() == config.height &&
+                    std::fabs(rate - config.frameRate) < 0.01;
+            // Interlaced modes of the same rate only if nothing progressive
+            if (match && best && mode->GetFieldDominance() != bmdProgressiveFrame) {
+                match = false;
+            }
+        }
+        if (match && (!best || best->GetFieldDominance() != bmdProgressiveFrame)) {
+            if (best) {
+                best->Release();
+            }
+            best = mode;
+            continue;
+        }
+        mode->Release();
+    }
+    iterator->Release();
+    return best;
+}
+
+} // namespace
+#endif
+
+DeckLinkOutput::DeckLinkOutput() = default;
+
+DeckLinkOutput::~DeckLinkOutput() {
+    close();
+}
+
+std::vector<std::string> DeckLinkOutput::listDevices() {
+    std::vector<std::string> names;
+#ifdef HAVE_DECKLINK_SDK
+    IDeckLinkIterator* iterator = CreateDeckLinkIteratorInstance();
+    if (!iterator) {
+        return names;
+    }
+    IDeckLink* device = nullptr;
+    while (iterator->Next(&device) == S_OK) {
+        names.push_back(displayName(device));
+        device->Release();
+    }
+    iterator->Release();
+#endif
+    return names;
+}
+
+bool DeckLinkOutput::open(const std::string& destination, const OutputSinkConfig& config) {
+    close();
+
+    // UYVY packs two pixels per macropixel
+    width_ = config.width & ~1;
+    height_ = config.height;
+    frameRate_ = config.frameRate > 0.0 ? config.frameRate : 25.0;
+    if (width_ <= 0 || height_ <= 0) {
+        LOG_ERROR << "DeckLinkOutput: Invalid size " << config.width << "x" << config.height;
+        return false;
+    }
+
+#ifdef HAVE_DECKLINK_SDK
+    IDeckLinkIterator* iterator = CreateDeckLinkIteratorInstance();
+    if (!iterator) {
+        LOG_ERROR << "DeckLinkOutput: DeckLink driver not installed";
+        return false;
+    }
+    // First card, by index, or by part of its name
+    char* end = nullptr;
+    long index = destination.empty() ? 0 : std::strtol(destination.c_str(), &end, 10);
+    bool byIndex = destination.empty() || (end && *end == '\0');
+    IDeckLink* device = nullptr;
+    for (long i = 0; iterator->Next(&device) == S_OK; ++i) {
+        std::string name = displayName(device);
+        if (byIndex ? i == index : name.find(destination) != std::string::npos) {
+            device_ = device;
+            deviceName_ = name;
+            break;
+        }
+        device->Release();
+    }
+    iterator->Release();
+    if (!device_) {
+        LOG_ERROR << "DeckLinkOutput: No DeckLink card '" << destination << "'";
+        return false;
+    }
+    if (device_->QueryInterface(IID_IDeckLinkOutput, reinterpret_cast<void**>(&output_)) != S_OK) {
+        LOG_ERROR << "DeckLinkOutput: " << deviceName_ << " has no video output";
+        close();
+        return false;
+    }
+    device_->QueryInterface(IID_IDeckLinkStatus, reinterpret_cast<void**>(&status_));
+
+    IDeckLinkDisplayMode* mode = findMode(output_, config);
+    if (!mode) {
+        LOG_ERROR << "DeckLinkOutput: " << deviceName_ << " has no mode "
+                  << (config.codec.empty() ? std::to_string(width_) + "x" + std::to_string(height_) + " @ " +
+                                                 std::to_string(frameRate_) + " fps"
+                                           : config.codec);
+        close();
+        return false;
+    }
+    modeName_ = modeName(mode);
+    width_ = static_cast<int>(mode->GetWidth());
+    height_ = static_cast<int>(mode->GetHeight());
+    BMDTimeValue frameDuration = 0;
+    BMDTimeScale timeScale = 0;
+    mode->GetFrameRate(&frameDuration, &timeScale);
+    BMDDisplayMode displayMode = mode->GetDisplayMode();
+    mode->Release();
+    if (frameDuration <= 0 || timeScale <= 0) {
+        close();
+        return false;
+    }
+    frameRate_ = static_cast<double>(timeScale) / frameDuration;
+
+    if (output_->EnableVideoOutput(displayMode, bmdVideoOutputFlagDefault) != S_OK) {
+        LOG_ERROR << "DeckLinkOutput: Could not enable " << modeName_ << " output on " << deviceName_;
+        close();
+        return false;
+    }
+    callback_ = new CompletionCallback(this);
+    output_->SetScheduledFrameCompletionCallback(callback_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        schedule_.reset(frameDuration, timeScale);
+        timing_.reset();
+        timing_.init(frameRate_);
+        lastReferenceCheckNs_ = 0;
+        checkReference();
+    }
+
+    LOG_INFO << "DeckLinkOutput: " << getDescription();
+    return true;
+#else
+    (void)destination;
+    LOG_ERROR << "DeckLink SDK not available (compiled without HAVE_DECKLINK_SDK)";
+    return false;
+#endif
+}
+
+void DeckLinkOutput::close() {
+#ifdef HAVE_DECKLINK_SDK
+    IDeckLinkOutput* output = nullptr;
+    bool started = false;
+    {
+        // A completion arriving meanwhile no longer touches the output
+        std::lock_guard<std::mutex> lock(mutex_);
+        output = output_;
+        output_ = nullptr;
+        started = schedule_.isStarted();
+    }
+    if (output) {
+        if (started) {
+            // Flushes the queued frames: the card releases them
+            output->StopScheduledPlayback(0, nullptr, 0);
+        }
+        output->SetScheduledFrameCompletionCallback(nullptr);
+        output->DisableVideoOutput();
+        output->Release();
+    }
+    if (callback_) {
+        callback_->Release();
+        callback_ = nullptr;
+    }
+    if (status_) {
+        status_->Release();
+        status_ = nullptr;
+    }
+    if (device_) {
+        device_->Release();
+        device_ = nullptr;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedule_.reset(schedule_.getFrameDuration(), schedule_.getTimeScale());
+    warnedGeometry_ = false;
+    referenceLocked_ = false;
+}
+
+bool DeckLinkOutput::isReady() const {
+#ifdef HAVE_DECKLINK_SDK
+    std::lock_guard<std::mutex> lock(mutex_);
+    return output_ != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool DeckLinkOutput::writeFrame(const FrameData& frame) {
+    // The card reads the frame after this returns: a copy it can keep
+    if (!frame.data || frame.size == 0) {
+        return false;
+    }
+    auto copy = std::make_shared<FrameData>();
+    copy->data = new uint8_t[frame.size];
+    copy->ownsData = true;
+    std::memcpy(copy->data, frame.data, frame.size);
+    copy->size = frame.size;
+    copy->width = frame.width;
+    copy->height = frame.height;
+    copy->format = frame.format;
+    copy->timestamp = frame.timestamp;
+    copy->frameNumber = frame.frameNumber;
+    copy->timecode = frame.timecode;
+    copy->timecodeFps = frame.timecodeFps;
+    return writeSharedFrame(copy);
+}
+
+bool DeckLinkOutput::writeSharedFrame(const std::shared_ptr<const FrameData>& frame) {
+#ifdef HAVE_DECKLINK_SDK
+    if (!frame || !frame->data) {
+        return false;
+    }
+    if (frame->format != PixelFormat::UYVY422 || frame->width != width_ || frame->height != height_) {
+        if (!warnedGeometry_) {
+            LOG_WARNING << "DeckLinkOutput: Dropping " << frame->width << "x" << frame->height
+                        << " frames, " << modeName_ << " plays " << width_ << "x" << height_ << " UYVY";
+            warnedGeometry_ = true;
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t displayTime = 0;
+    if (!output_ || !schedule_.next(displayTime)) {
+        return false;  // Far enough ahead of the card already
+    }
+    SharedVideoFrame* videoFrame = new SharedVideoFrame(frame);
+    HRESULT result = output_->ScheduleVideoFrame(videoFrame, displayTime, schedule_.getFrameDuration(),
+                                                 schedule_.getTimeScale());
+    videoFrame->Release();  // The card holds its own reference
+    if (result != S_OK) {
+        return false;
+    }
+    schedule_.scheduled();
+    if (schedule_.readyToStart()) {
+        if (output_->StartScheduledPlayback(0, schedule_.getTimeScale(), 1.0) != S_OK) {
+            LOG_ERROR << "DeckLinkOutput: Could not start playback on " << deviceName_;
+            return false;
+        }
+        schedule_.started();
+    }
+    return true;
+#else
+    (void)frame;
+    return false;
+#endif
+}
+
+void DeckLinkOutput::onFrameCompleted(PlayoutSchedule::Completion completion) {
+#ifdef HAVE_DECKLINK_SDK
+    BMDTimeValue streamTime = 0;
+    double speed = 0.0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (output_) {
+        output_->GetScheduledStreamTime(schedule_.getTimeScale(), &streamTime, &speed);
+    }
+    schedule_.completed(completion, streamTime);
+    if (completion == PlayoutSchedule::Completion::FLUSHED) {
+        return;
+    }
+    // The frame left the card now: a flip on the card's clock
+    int64_t nowNs = PresentationTiming::getCurrentTimeNs();
+    timing_.recordFlip(static_cast<unsigned int>(nowNs / 1000000000),
+                       static_cast<unsigned int>((nowNs / 1000) % 1000000),
+                       static_cast<unsigned int>(schedule_.getOutputFrame(streamTime)));
+    if (nowNs - lastReferenceCheckNs_ >= 1000000000) {
+        lastReferenceCheckNs_ = nowNs;
+        checkReference();
+    }
+#else
+    (void)completion;
+#endif
+}
+
+#ifdef HAVE_DECKLINK_SDK
+void DeckLinkOutput::checkReference() {
+    bool locked = false;
+    if (status_) {
+        status_->GetFlag(bmdDeckLinkStatusReferenceSignalLocked, &locked);
+    }
+    if (locked != referenceLocked_ || lastReferenceCheckNs_ == 0) {
+        if (locked) {
+            LOG_INFO << "DeckLinkOutput: " << deviceName_ << " locked to its reference input";
+        } else {
+            LOG_WARNING << "DeckLinkOutput: " << deviceName_ << " has no reference lock (free running)";
+        }
+    }
+    referenceLocked_ = locked;
+}
+#endif
+
+bool DeckLinkOutput::isReferenceLocked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return referenceLocked_;
+}
+
+bool DeckLinkOutput::getOutputClock(int64_t& frame, double& rateHz, int64_t& leadNs) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t next = timing_.getNextVsyncCounter();
+    if (!schedule_.isStarted() || next < 0) {
+        return false;
+    }
+    // The next frame written queues behind the ones in flight
+    int ahead = schedule_.getInFlight();
+    int64_t frameNs = static_cast<int64_t>(1e9 / frameRate_);
+    frame = next + ahead;
+    rateHz = frameRate_;
+    leadNs = timing_.getTimeToNextVsync() + ahead * frameNs;
+    return true;
+}
+
+CaptureFormat DeckLinkOutput::getCaptureFormat() const {
+    CaptureFormat format;
+    format.format = PixelFormat::UYVY422;
+    format.width = width_;
+    format.height = height_;
+    return format;
+}
+
+std::string DeckLinkOutput::getDescription() const {
+    char rate[32];
+    snprintf(rate, sizeof(rate), "%.2f", frameRate_);
+    return "DeckLink '" + deviceName_ + "' " + modeName_ + " (" + std::to_string(width_) + "x" +
+           std::to_string(height_) + " UYVY @ " + rate + " fps, scheduled)";
+}
+
+} // namespace videocomposer
@@ -0,0 +1,105 @@
+/**
+ * DeckLinkOutput.h - DeckLink (SDI/HDMI) program output sink
+ *
+ * Plays the program output out of a Blackmagic DeckLink card with
+ * scheduled playback, so frames leave on the card's clock (genlocked to
+ * its reference input when one is connected) rather than the render
+ * loop's. Frames arrive as UYVY, converted on the GPU before readback (see
+ * CaptureConverter), and are handed to the card as they came out of the
+ * capture readback ring: the card DMAs from the frame's bytes, the sink
+ * never copies or converts pixels.
+ */
+
+#ifndef VIDEOCOMPOSER_DECKLINKOUTPUT_H
+#define VIDEOCOMPOSER_DECKLINKOUTPUT_H
+
+#include "OutputSink.h"
+#include "PlayoutSchedule.h"
+#include "../display/drm/PresentationTiming.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_DECKLINK_SDK
+#include <DeckLinkAPI.h>
+#endif
+
+namespace videocomposer {
+
+/**
+ * DeckLinkOutput - OutputSink feeding a DeckLink card's scheduled playback
+ *
+ * The destination selects the card: empty for the first one, an index
+ * ("1") or part of its display name. The video mode is the one matching
+ * the feed's size and frame rate (OutputSinkConfig width/height/frameRate,
+ * progressive first) or, with OutputSinkConfig.codec set, the mode of
+ * that name (e.g. "1080p25").
+ *
+ * Frames are kept by reference (writeSharedFrame()) until the card reports
+ * them completed. Completions are recorded in a PresentationTiming, which
+ * makes the card's output a clock the render loop can follow
+ * (getOutputClock()).
+ */
+class DeckLinkOutput : public OutputSink {
+public:
+    DeckLinkOutput();
+    ~DeckLinkOutput() override;
+
+    DeckLinkOutput(const DeckLinkOutput&) = delete;
+    DeckLinkOutput& operator=(const DeckLinkOutput&) = delete;
+
+    // ===== OutputSink =====
+
+    bool open(const std::string& destination, const OutputSinkConfig& config) override;
+    void close() override;
+    bool isReady() const override;
+
+    bool writeFrame(const FrameData& frame) override;
+    bool writeSharedFrame(const std::shared_ptr<const FrameData>& frame) override;
+
+    CaptureFormat getCaptureFormat() const override;
+    size_t getQueueDepth() const override { return 1; }
+
+    bool getOutputClock(int64_t& frame, double& rateHz, int64_t& leadNs) const override;
+
+    Type getType() const override { return Type::HARDWARE; }
+    std::string getId() const override { return "decklink:" + deviceName_; }
+    std::string getDescription() const override;
+
+    /** Whether the card is locked to its reference input (genlock) */
+    bool isReferenceLocked() const;
+
+    /** Card names, in index order */
+    static std::vector<std::string> listDevices();
+
+    // Card callback thread
+    void onFrameCompleted(PlayoutSchedule::Completion completion);
+
+private:
+    std::string deviceName_;
+    std::string modeName_;
+    int width_ = 0;
+    int height_ = 0;
+    double frameRate_ = 0.0;
+
+    mutable std::mutex mutex_;   // Schedule and timing: writer vs. card callback
+    PlayoutSchedule schedule_;
+    PresentationTiming timing_;
+    bool warnedGeometry_ = false;
+    bool referenceLocked_ = false;
+    int64_t lastReferenceCheckNs_ = 0;
+
+#ifdef HAVE_DECKLINK_SDK
+    void checkReference();
+
+    IDeckLink* device_ = nullptr;
+    IDeckLinkOutput* output_ = nullptr;
+    IDeckLinkStatus* status_ = nullptr;
+    IDeckLinkVideoOutputCallback* callback_ = nullptr;
+#endif
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DECKLINKOUTPUT_H
@@ -0,0 +1,220 @@
+/**
+ * FileEncoderOutput.cpp - Software mastering-codec file output sink
+ */
+
+#include "FileEncoderOutput.h"
+#include "../utils/Logger.h"
+#include "../utils/SMPTEUtils.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+std::string avError(int err) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    return errbuf;
+}
+
+bool isHap(const std::string& codec) {
+    return codec.compare(0, 3, "hap") == 0;
+}
+
+} // namespace
+
+FileEncoderOutput::FileEncoderOutput() {
+}
+
+FileEncoderOutput::~FileEncoderOutput() {
+    close();
+}
+
+bool FileEncoderOutput::open(const std::string& destination, const OutputSinkConfig& config) {
+    close();
+
+    destination_ = destination;
+    // HAP compresses 4x4 texel blocks; 4:2:2 needs an even width
+    int align = isHap(config.codec) ? 4 : 2;
+    width_ = config.width / align * align;
+    height_ = isHap(config.codec) ? config.height / align * align : config.height;
+    if (width_ <= 0 || height_ <= 0) {
+        LOG_ERROR << "FileEncoderOutput: Invalid size " << config.width << "x" << config.height;
+        return false;
+    }
+
+    if (!openEncoder(config) || !openMuxer(config)) {
+        release();
+        return false;
+    }
+
+    ready_ = true;
+    LOG_INFO << "FileEncoderOutput: " << getDescription();
+    return true;
+}
+
+bool FileEncoderOutput::openEncoder(const OutputSinkConfig& config) {
+    bool hap = isHap(config.codec);
+    codecName_ = hap ? "hap" : "prores_ks";
+    const AVCodec* codec = avcodec_find_encoder_by_name(codecName_.c_str());
+    if (!codec) {
+        LOG_ERROR << "FileEncoderOutput: FFmpeg has no " << codecName_ << " encoder";
+        return false;
+    }
+
+    int64_t fpsNum = 0, fpsDen = 1;
+    SMPTEUtils::framerateToRational(config.frameRate > 0.0 ? config.frameRate : 25.0, fpsNum, fpsDen);
+
+    codecCtx_ = avcodec_alloc_context3(codec);
+    if (!codecCtx_) {
+        return false;
+    }
+    codecCtx_->width = width_;
+    codecCtx_->height = height_;
+    codecCtx_->pix_fmt = hap ? AV_PIX_FMT_RGBA : AV_PIX_FMT_YUV422P10LE;
+    codecCtx_->time_base = AVRational{static_cast<int>(fpsDen), static_cast<int>(fpsNum)};
+    codecCtx_->framerate = AVRational{static_cast<int>(fpsNum), static_cast<int>(fpsDen)};
+    codecCtx_->thread_count = 0;   // All cores
+    if (hap) {
+        av_opt_set(codecCtx_->priv_data, "format", config.codec.c_str(), 0);
+    } else {
+        av_opt_set(codecCtx_->priv_data, "profile", "hq", 0);
+        codecCtx_->color_primaries = AVCOL_PRI_BT709;
+        codecCtx_->color_trc = AVCOL_TRC_BT709;
+        codecCtx_->colorspace = AVCOL_SPC_BT709;
+        codecCtx_->color_range = AVCOL_RANGE_MPEG;
+    }
+
+    frame_ = av_frame_alloc();
+    packet_ = av_packet_alloc();
+    if (!frame_ || !packet_) {
+        return false;
+    }
+    frame_->format = codecCtx_->pix_fmt;
+    frame_->width = width_;
+    frame_->height = height_;
+    int ret = av_frame_get_buffer(frame_, 0);
+    if (ret < 0) {
+        LOG_ERROR << "FileEncoderOutput: Failed to allocate frame: " << avError(ret);
+        return false;
+    }
+    return true;
+}
+
+bool FileEncoderOutput::openMuxer(const OutputSinkConfig& config) {
+    const char* container = config.container.empty() ? nullptr : config.container.c_str();
+    int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, container, destination_.c_str());
+    if (ret < 0 || !formatCtx_) {
+        LOG_ERROR << "FileEncoderOutput: No container for " << destination_ << ": " << avError(ret);
+        return false;
+    }
+    if (formatCtx_->oformat->flags & AVFMT_GLOBALHEADER) {
+        codecCtx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    ret = avcodec_open2(codecCtx_, codecCtx_->codec, nullptr);
+    if (ret < 0) {
+        LOG_ERROR << "FileEncoderOutput: Failed to open " << codecName_ << ": " << avError(ret);
+        return false;
+    }
+
+    stream_ = avformat_new_stream(formatCtx_, nullptr);
+    if (!stream_) {
+        return false;
+    }
+    stream_->time_base = codecCtx_->time_base;
+    avcodec_parameters_from_context(stream_->codecpar, codecCtx_);
+
+    if (!(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&formatCtx_->pb, destination_.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            LOG_ERROR << "FileEncoderOutput: Failed to open " << destination_ << ": " << avError(ret);
+            return false;
+        }
+    }
+    ret = avformat_write_header(formatCtx_, nullptr);
+    if (ret < 0) {
+        LOG_ERROR << "FileEncoderOutput: Failed to write header: " << avError(ret);
+        return false;
+    }
+    nextPts_ = 0;
+    return true;
+}
+
+bool FileEncoderOutput::writeFrame(const FrameData& frame) {
+    if (!ready_ || !frame.data || frame.format != PixelFormat::RGBA32 ||
+        frame.size < FrameData::frameSize(PixelFormat::RGBA32, frame.width, frame.height)) {
+        return false;
+    }
+
+    // The encoder may still reference the previous frame's buffers
+    if (av_frame_make_writable(frame_) < 0) {
+        return false;
+    }
+
+    // Readback is bottom row first: start at the last row, step backwards
+    int stride = frame.width * 4;
+    const uint8_t* src[1] = {frame.data + static_cast<size_t>(frame.height - 1) * stride};
+    int srcStride[1] = {-stride};
+    if (!scaler_.scale(src, srcStride, frame.width, frame.height, AV_PIX_FMT_RGBA,
+                       frame_->data, frame_->linesize, width_, height_, codecCtx_->pix_fmt, SWS_BICUBIC)) {
+        LOG_WARNING << "FileEncoderOutput: No conversion from " << frame.width << "x" << frame.height;
+        return false;
+    }
+
+    frame_->pts = nextPts_++;
+    return encode(frame_);
+}
+
+bool FileEncoderOutput::encode(AVFrame* frame) {
+    int ret = avcodec_send_frame(codecCtx_, frame);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        LOG_WARNING << "FileEncoderOutput: Encode failed: " << avError(ret);
+        return false;
+    }
+    while ((ret = avcodec_receive_packet(codecCtx_, packet_)) >= 0) {
+        av_packet_rescale_ts(packet_, codecCtx_->time_base, stream_->time_base);
+        packet_->stream_index = stream_->index;
+        ret = av_interleaved_write_frame(formatCtx_, packet_);
+        if (ret < 0) {
+            LOG_WARNING << "FileEncoderOutput: Failed to write packet: " << avError(ret);
+        }
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+}
+
+void FileEncoderOutput::close() {
+    if (ready_) {
+        ready_ = false;
+        encode(nullptr);
+        av_write_trailer(formatCtx_);
+        LOG_INFO << "FileEncoderOutput: Closed " << destination_ << " after " << nextPts_ << " frames";
+    }
+    release();
+}
+
+void FileEncoderOutput::release() {
+    if (formatCtx_) {
+        if (!(formatCtx_->oformat->flags & AVFMT_NOFILE) && formatCtx_->pb) {
+            avio_closep(&formatCtx_->pb);
+        }
+        avformat_free_context(formatCtx_);
+        formatCtx_ = nullptr;
+        stream_ = nullptr;
+    }
+    scaler_.reset();
+    av_frame_free(&frame_);
+    av_packet_free(&packet_);
+    avcodec_free_context(&codecCtx_);
+}
+
+std::string FileEncoderOutput::getDescription() const {
+    return codecName_ + " " + std::to_string(width_) + "x" + std::to_string(height_) +
+           " -> " + destination_;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,82 @@
+/**
+ * FileEncoderOutput.h - Software mastering-codec file output sink
+ *
+ * Encodes the captured program into an intra-only mastering codec with
+ * FFmpeg's software encoders, for the offline render (--render): ProRes
+ * 422 HQ (prores_ks, 10-bit 4:2:2) or HAP (DXT compressed RGBA). Every
+ * frame must reach the file, so the sink blocks the capture path instead
+ * of dropping when the encoder falls behind.
+ */
+
+#ifndef VIDEOCOMPOSER_FILEENCODEROUTPUT_H
+#define VIDEOCOMPOSER_FILEENCODEROUTPUT_H
+
+#include "OutputSink.h"
+#include "../video/SliceScaler.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace videocomposer {
+
+/**
+ * FileEncoderOutput - CPU sink writing ProRes or HAP files
+ *
+ * Takes RGBA readbacks (bottom row first), converts them to the encoder's
+ * pixel format with swscale and encodes on OutputSinkManager's worker
+ * thread; the encoder's own threads use every core.
+ *
+ * OutputSinkConfig: width/height, frameRate, codec ("prores", "hap",
+ * "hap_alpha" or "hap_q"), container (default from the file extension).
+ */
+class FileEncoderOutput : public OutputSink {
+public:
+    FileEncoderOutput();
+    ~FileEncoderOutput() override;
+
+    // Disable copy
+    FileEncoderOutput(const FileEncoderOutput&) = delete;
+    FileEncoderOutput& operator=(const FileEncoderOutput&) = delete;
+
+    // ===== OutputSink =====
+
+    bool open(const std::string& destination, const OutputSinkConfig& config) override;
+    void close() override;
+    bool isReady() const override { return ready_; }
+
+    bool writeFrame(const FrameData& frame) override;
+
+    // Lossless: readbacks queue up to the depth, then the renderer waits
+    DropPolicy getDropPolicy() const override { return DropPolicy::BLOCK; }
+    size_t getQueueDepth() const override { return 8; }
+
+    Type getType() const override { return Type::FILE; }
+    std::string getId() const override { return "file:" + destination_; }
+    std::string getDescription() const override;
+
+private:
+    bool openEncoder(const OutputSinkConfig& config);
+    bool openMuxer(const OutputSinkConfig& config);
+    bool encode(AVFrame* frame);   // nullptr drains the encoder
+    void release();
+
+    std::string destination_;
+    std::string codecName_;
+    int width_ = 0;
+    int height_ = 0;
+    bool ready_ = false;
+
+    AVCodecContext* codecCtx_ = nullptr;
+    AVFormatContext* formatCtx_ = nullptr;
+    AVStream* stream_ = nullptr;
+    AVPacket* packet_ = nullptr;
+    AVFrame* frame_ = nullptr;
+    SliceScaler scaler_;
+    int64_t nextPts_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FILEENCODEROUTPUT_H
@@ -44,42 +44,22 @@ bool FrameCapture::initialize(int width, int height, PixelFormat format) {
     }
     
     // Create PBOs
-    glGenBuffers(NUM_PBOS, pbo_);
-    
-    for (int i = 0; i < NUM_PBOS; ++i) {
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[i]);
-        glBufferData(GL_PIXEL_PACK_BUFFER, frameSize_, nullptr, GL_STREAM_READ);
-    }
-    
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    
-    // Check for errors
-    GLenum err = glGetError();
-    if (err != GL_NO_ERROR) {
-        LOG_ERROR << "FrameCapture: OpenGL error during PBO creation: " << err;
+    if (!readback_.configure(frameSize_)) {
+        LOG_ERROR << "FrameCapture: PBO creation failed";
         cleanup();
         return false;
     }
     
     initialized_ = true;
     LOG_INFO << "FrameCapture: Initialized " << width << "x" << height 
-             << " with PBO support";
+             << " with " << readback_.getDepth() << " PBOs";
     
     return true;
 }
 
 void FrameCapture::cleanup() {
-    // Complete any pending reads
-    if (pendingRead_ && pboSupported_) {
-        FrameData dummy;
-        getCompletedFrame(dummy);
-    }
-    
-    // Delete PBOs
-    if (pbo_[0] != 0) {
-        glDeleteBuffers(NUM_PBOS, pbo_);
-        pbo_[0] = pbo_[1] = 0;
-    }
+    // Delete PBOs (readbacks in flight are dropped)
+    readback_.release();
     
     // Clear queue
     std::lock_guard<std::mutex> lock(queueMutex_);
@@ -88,9 +68,6 @@ void FrameCapture::cleanup() {
     }
     
     initialized_ = false;
-    pendingRead_ = false;
-    pendingPBO_ = -1;
-    currentPBO_ = 0;
 }
 
 void FrameCapture::checkPBOSupport() {
@@ -125,7 +102,10 @@ GLenum FrameCapture::getGLFormat() const {
         case PixelFormat::RGB24:
             return GL_RGB;
         case PixelFormat::YUV420P:
+        case PixelFormat::YUV420P10:
         case PixelFormat::UYVY422:
+        case PixelFormat::YUYV422:
+        case PixelFormat::NV12:
             // These formats need special handling, fallback to RGBA for readback
             return GL_RGBA;
     }
@@ -148,9 +128,18 @@ void FrameCapture::startCapture() {
         return;
     }
     
-    // Complete any pending read first
-    if (pendingRead_) {
-        completePendingRead();
+    GLuint buffer = 0;
+    if (pboSupported_) {
+        // Finished readbacks free their buffers; a lossless capture waits
+        // for the oldest one when none did
+        while (completeReadback(false)) {}
+        if (readback_.full() && lossless_) {
+            completeReadback(true);
+        }
+        buffer = readback_.begin();
+        if (buffer == 0) {
+            return;   // GPU a whole ring behind: frame dropped
+        }
     }
     
     // Bind source FBO
@@ -166,19 +155,13 @@ void FrameCapture::startCapture() {
     
     if (pboSupported_) {
         // Async read with PBO
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[currentPBO_]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
         
-        // Initiate async read (non-blocking)
+        // Initiate async read (non-blocking), fenced
         glReadPixels(sourceX_, sourceY_, width_, height_, format, type, nullptr);
         
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        
-        // Mark this PBO as pending
-        pendingPBO_ = currentPBO_;
-        pendingRead_ = true;
-        
-        // Swap to next PBO for next frame
-        currentPBO_ = (currentPBO_ + 1) % NUM_PBOS;
+        readback_.submit(++frameNumber_);
         
     } else {
         // Synchronous read (fallback)
@@ -205,51 +188,35 @@ void FrameCapture::startCapture() {
     }
 }
 
-bool FrameCapture::completePendingRead() {
-    if (!pendingRead_ || pendingPBO_ < 0 || !pboSupported_) {
+bool FrameCapture::completeReadback(bool wait) {
+    if (wait ? readback_.pending() == 0 : !readback_.ready()) {
         return false;
     }
     
-    // Bind the pending PBO
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pendingPBO_]);
-    
-    // Map buffer (this will block until transfer is complete)
-    void* mappedData = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-    
-    if (mappedData) {
-        // Create frame with copy of data
-        FrameData frame;
-        frame.width = width_;
-        frame.height = height_;
-        frame.format = format_;
-        frame.size = frameSize_;
-        frame.data = new uint8_t[frameSize_];
-        frame.ownsData = true;
-        frame.timestamp = getCurrentTimestamp();
-        frame.frameNumber = ++frameNumber_;
-        
-        memcpy(frame.data, mappedData, frameSize_);
-        
-        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-        
-        // Add to queue
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        completedFrames_.push(std::move(frame));
+    // Create frame with copy of data
+    FrameData frame;
+    frame.width = width_;
+    frame.height = height_;
+    frame.format = format_;
+    frame.size = frameSize_;
+    frame.data = new uint8_t[frameSize_];
+    frame.ownsData = true;
+    bool copied = wait ? readback_.wait(frame.data, frameSize_, &frame.frameNumber)
+                       : readback_.poll(frame.data, frameSize_, &frame.frameNumber);
+    if (!copied) {
+        return false;
     }
+    frame.timestamp = getCurrentTimestamp();
     
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-    
-    pendingRead_ = false;
-    pendingPBO_ = -1;
-    
+    // Add to queue
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    completedFrames_.push(std::move(frame));
     return true;
 }
 
 bool FrameCapture::getCompletedFrame(FrameData& frame) {
-    // Complete any pending read
-    if (pendingRead_) {
-        completePendingRead();
-    }
+    // Finished readbacks only: never map a buffer the GPU still writes
+    while (completeReadback(false)) {}
     
     // Get from queue
     std::lock_guard<std::mutex> lock(queueMutex_);
@@ -264,5 +231,16 @@ bool FrameCapture::getCompletedFrame(FrameData& frame) {
     return true;
 }
 
+void FrameCapture::flush() {
+    while (readback_.pending() > 0) {
+        if (!completeReadback(true) && readback_.pending() > 0) {
+            LOG_WARNING << "FrameCapture: Readback did not finish, " << readback_.pending() << " dropped";
+            readback_.release();
+            readback_.configure(frameSize_);
+            break;
+        }
+    }
+}
+
 } // namespace videocomposer
 
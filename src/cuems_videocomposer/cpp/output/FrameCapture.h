@@ -3,11 +3,11 @@
  * 
  * Shared component for Multi-Display and NDI implementations.
  * Provides efficient asynchronous GPU-to-CPU frame capture using
- * OpenGL Pixel Buffer Objects (PBO) for double-buffered transfers.
+ * OpenGL Pixel Buffer Objects (PBO), fenced in a ReadbackRing.
  * 
  * Features:
- * - Double-buffered PBO for async transfers
- * - Non-blocking capture initiation
+ * - N-deep PBO ring, mapped only once a transfer's fence has signalled
+ * - Non-blocking capture initiation and completion
  * - Configurable capture source (FBO or default framebuffer)
  * - Multiple pixel format support
  */
@@ -15,6 +15,7 @@
 #ifndef VIDEOCOMPOSER_FRAMECAPTURE_H
 #define VIDEOCOMPOSER_FRAMECAPTURE_H
 
+#include "ReadbackRing.h"
 #include "../video/FrameFormat.h"
 #include <GL/glew.h>
 #include <queue>
@@ -35,6 +36,8 @@ struct FrameData {
     PixelFormat format = PixelFormat::RGBA32;
     int64_t timestamp = 0;      // Timestamp in microseconds
     int64_t frameNumber = 0;    // Sequential frame number
+    int64_t timecode = -1;      // Show timecode in frames (-1 = no sync source)
+    double timecodeFps = 0.0;   // Framerate of the timecode
     bool ownsData = false;      // If true, destructor frees data
     
     FrameData() = default;
@@ -42,7 +45,8 @@ struct FrameData {
     FrameData(FrameData&& other) noexcept
         : data(other.data), size(other.size), width(other.width),
           height(other.height), format(other.format), timestamp(other.timestamp),
-          frameNumber(other.frameNumber), ownsData(other.ownsData) {
+          frameNumber(other.frameNumber), timecode(other.timecode),
+          timecodeFps(other.timecodeFps), ownsData(other.ownsData) {
         other.data = nullptr;
         other.ownsData = false;
     }
@@ -59,6 +63,8 @@ struct FrameData {
             format = other.format;
             timestamp = other.timestamp;
             frameNumber = other.frameNumber;
+            timecode = other.timecode;
+            timecodeFps = other.timecodeFps;
             ownsData = other.ownsData;
             other.data = nullptr;
             other.ownsData = false;
@@ -88,15 +94,39 @@ struct FrameData {
                 return 3;
             case PixelFormat::YUV420P:
                 return 1;  // Actually 1.5, handled specially
+            case PixelFormat::YUV420P10:
+                return 2;  // Actually 3, handled specially
             case PixelFormat::UYVY422:
+            case PixelFormat::YUYV422:
                 return 2;
+            case PixelFormat::NV12:
+                return 1;  // Actually 1.5, handled specially
         }
         return 4;
     }
+    
+    /**
+     * Calculate total bytes of a frame, including chroma planes
+     */
+    static size_t frameSize(PixelFormat fmt, int width, int height) {
+        size_t pixels = static_cast<size_t>(width) * height;
+        switch (fmt) {
+            case PixelFormat::YUV420P:
+            case PixelFormat::NV12:
+                return pixels + 2 * (static_cast<size_t>(width / 2) * (height / 2));
+            case PixelFormat::YUV420P10:
+                return 2 * (pixels + 2 * (static_cast<size_t>(width / 2) * (height / 2)));
+            default:
+                return pixels * bytesPerPixel(fmt);
+        }
+    }
 };
 
 /**
- * FrameCapture - Async frame capture with PBO double-buffering
+ * FrameCapture - Async frame capture through a fenced PBO ring
+ *
+ * When every buffer is in flight the frame is dropped, unless the capture
+ * is lossless (offline render): then the oldest readback is waited for.
  */
 class FrameCapture {
 public:
@@ -134,16 +164,21 @@ public:
     void startCapture();
     
     /**
-     * Get completed frame (from previous capture)
+     * Get the oldest completed frame (never waits on the GPU)
      * @param frame Output frame data
      * @return true if a completed frame is available
      */
     bool getCompletedFrame(FrameData& frame);
     
+    /**
+     * Wait for every readback in flight (they queue for getCompletedFrame())
+     */
+    void flush();
+    
     /**
      * Check if there's a pending capture
      */
-    bool hasPendingCapture() const { return pendingRead_; }
+    bool hasPendingCapture() const { return readback_.pending() > 0; }
     
     // ===== Configuration =====
     
@@ -166,6 +201,11 @@ public:
      */
     void setSourceOffset(int x, int y) { sourceX_ = x; sourceY_ = y; }
     
+    /**
+     * Wait for the oldest readback instead of dropping when the ring is full
+     */
+    void setLossless(bool lossless) { lossless_ = lossless; }
+    
     // ===== Query =====
     
     /**
@@ -184,12 +224,14 @@ public:
      */
     PixelFormat getFormat() const { return format_; }
     
+    /**
+     * Frames dropped because every readback was in flight
+     */
+    uint64_t getDroppedFrames() const { return readback_.getDropped(); }
+    
 private:
-    // PBO buffer indices
-    static const int NUM_PBOS = 2;
-    GLuint pbo_[NUM_PBOS] = {0, 0};
-    int currentPBO_ = 0;
-    int pendingPBO_ = -1;
+    // Fenced PBO ring, tagged with the frame number
+    ReadbackRing readback_;
     
     // Capture parameters
     int width_ = 0;
@@ -206,7 +248,7 @@ private:
     // State
     bool pboSupported_ = false;
     bool initialized_ = false;
-    bool pendingRead_ = false;
+    bool lossless_ = false;
     int64_t frameNumber_ = 0;
     
     // Completed frames queue
@@ -236,9 +278,10 @@ private:
     int64_t getCurrentTimestamp() const;
     
     /**
-     * Complete a pending read (map PBO and copy data)
+     * Queue the oldest readback if it has finished (or wait for it)
+     * @return true if a frame was queued
      */
-    bool completePendingRead();
+    bool completeReadback(bool wait);
 };
 
 } // namespace videocomposer
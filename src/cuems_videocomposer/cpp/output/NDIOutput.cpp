@@ -0,0 +1,179 @@
+/**
+ * NDIOutput.cpp - NDI program output sink
+ */
+
+#include "NDIOutput.h"
+#include "../utils/Logger.h"
+#include "../utils/SMPTEUtils.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace videocomposer {
+
+NDIOutput::NDIOutput() = default;
+
+NDIOutput::~NDIOutput() {
+    close();
+}
+
+bool NDIOutput::open(const std::string& destination, const OutputSinkConfig& config) {
+    close();
+
+    name_ = destination.empty() ? config.name : destination;
+    if (name_.empty()) {
+        name_ = "cuems-videocomposer";
+    }
+    // UYVY packs two pixels per macropixel
+    width_ = config.width & ~1;
+    height_ = config.height;
+    if (width_ <= 0 || height_ <= 0) {
+        LOG_ERROR << "NDIOutput: Invalid size " << config.width << "x" << config.height;
+        return false;
+    }
+    SMPTEUtils::framerateToRational(config.frameRate > 0.0 ? config.frameRate : 25.0,
+                                    frameRateNum_, frameRateDen_);
+
+#ifdef HAVE_NDI_SDK
+    if (!NDIlib_initialize()) {
+        LOG_ERROR << "NDIOutput: Failed to initialize NDI library (CPU not supported?)";
+        return false;
+    }
+
+    NDIlib_send_create_t sendDesc;
+    sendDesc.p_ndi_name = name_.c_str();
+    sendDesc.p_groups = nullptr;
+    // The render loop paces the frames; the SDK must not wait on its own clock
+    sendDesc.clock_video = false;
+    sendDesc.clock_audio = false;
+    sender_ = NDIlib_send_create(&sendDesc);
+    if (!sender_) {
+        LOG_ERROR << "NDIOutput: Failed to create NDI sender '" << name_ << "'";
+        return false;
+    }
+
+    LOG_INFO << "NDIOutput: " << getDescription();
+    return true;
+#else
+    LOG_ERROR << "NDI SDK not available (compiled without HAVE_NDI_SDK)";
+    return false;
+#endif
+}
+
+void NDIOutput::close() {
+#ifdef HAVE_NDI_SDK
+    if (sender_) {
+        // Flush: after this the SDK no longer reads the last frame
+        NDIlib_send_send_video_async_v2(sender_, nullptr);
+        NDIlib_send_destroy(sender_);
+        sender_ = nullptr;
+    }
+#endif
+    inFlight_.reset();
+    buffers_[0].reset();
+    buffers_[1].reset();
+    warnedGeometry_ = false;
+}
+
+bool NDIOutput::isReady() const {
+#ifdef HAVE_NDI_SDK
+    return sender_ != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool NDIOutput::writeFrame(const FrameData& frame) {
+    if (!frame.data || frame.size == 0) {
+        return false;
+    }
+
+    // Whichever buffer is not in flight: released by the SDK when the last send returned
+    std::shared_ptr<FrameData>& buffer = buffers_[inFlight_ && inFlight_ == buffers_[0] ? 1 : 0];
+    if (!buffer || buffer->size != frame.size) {
+        buffer = std::make_shared<FrameData>();
+        buffer->data = new uint8_t[frame.size];
+        buffer->size = frame.size;
+        buffer->ownsData = true;
+    }
+    std::memcpy(buffer->data, frame.data, frame.size);
+    buffer->width = frame.width;
+    buffer->height = frame.height;
+    buffer->format = frame.format;
+    buffer->timestamp = frame.timestamp;
+    buffer->frameNumber = frame.frameNumber;
+    buffer->timecode = frame.timecode;
+    buffer->timecodeFps = frame.timecodeFps;
+    return send(buffer);
+}
+
+bool NDIOutput::writeSharedFrame(const std::shared_ptr<const FrameData>& frame) {
+    return send(frame);
+}
+
+bool NDIOutput::send(const std::shared_ptr<const FrameData>& frame) {
+#ifdef HAVE_NDI_SDK
+    if (!sender_ || !frame || !frame->data) {
+        return false;
+    }
+    if (frame->format != PixelFormat::UYVY422 || frame->width != width_ || frame->height != height_) {
+        if (!warnedGeometry_) {
+            LOG_WARNING << "NDIOutput: Dropping " << frame->width << "x" << frame->height
+                        << " frames, the source sends " << width_ << "x" << height_ << " UYVY";
+            warnedGeometry_ = true;
+        }
+        return false;
+    }
+
+    NDIlib_video_frame_v2_t video;
+    video.xres = width_;
+    video.yres = height_;
+    video.FourCC = NDIlib_FourCC_video_type_UYVY;
+    video.frame_rate_N = static_cast<int>(frameRateNum_);
+    video.frame_rate_D = static_cast<int>(frameRateDen_);
+    video.picture_aspect_ratio = static_cast<float>(width_) / static_cast<float>(height_);
+    video.frame_format_type = NDIlib_frame_format_type_progressive;
+    // NDI timecode is in 100 ns units
+    if (frame->timecode >= 0 && frame->timecodeFps > 0.0) {
+        video.timecode = std::llround(static_cast<double>(frame->timecode) / frame->timecodeFps * 1e7);
+    } else {
+        video.timecode = NDIlib_send_timecode_synthesize;
+    }
+    video.p_data = const_cast<uint8_t*>(frame->data);
+    video.line_stride_in_bytes = width_ * 2;
+    video.p_metadata = nullptr;
+
+    // Returns once the previous frame is no longer read, so it can go
+    NDIlib_send_send_video_async_v2(sender_, &video);
+    inFlight_ = frame;
+    return true;
+#else
+    (void)frame;
+    return false;
+#endif
+}
+
+CaptureFormat NDIOutput::getCaptureFormat() const {
+    CaptureFormat format;
+    format.format = PixelFormat::UYVY422;
+    format.width = width_;
+    format.height = height_;
+    return format;
+}
+
+int NDIOutput::getConnectionCount() const {
+#ifdef HAVE_NDI_SDK
+    return sender_ ? NDIlib_send_get_no_connections(sender_, 0) : 0;
+#else
+    return 0;
+#endif
+}
+
+std::string NDIOutput::getDescription() const {
+    char rate[32];
+    snprintf(rate, sizeof(rate), "%.2f", static_cast<double>(frameRateNum_) / frameRateDen_);
+    return "NDI source '" + name_ + "' (" + std::to_string(width_) + "x" + std::to_string(height_) +
+           " UYVY @ " + rate + " fps)";
+}
+
+} // namespace videocomposer
@@ -0,0 +1,86 @@
+/**
+ * NDIOutput.h - NDI program output sink
+ *
+ * Sends the program output as an NDI source. Frames arrive as UYVY,
+ * converted on the GPU before readback (see CaptureConverter), and are
+ * sent with NDIlib_send_send_video_async_v2, so neither the capture path
+ * nor the sink's thread waits for the network or converts pixels.
+ */
+
+#ifndef VIDEOCOMPOSER_NDIOUTPUT_H
+#define VIDEOCOMPOSER_NDIOUTPUT_H
+
+#include "OutputSink.h"
+#include <memory>
+#include <string>
+
+#ifdef HAVE_NDI_SDK
+#include <Processing.NDI.Lib.h>
+#endif
+
+namespace videocomposer {
+
+/**
+ * NDIOutput - OutputSink publishing an NDI source
+ *
+ * An async send reads its buffer until the next send (or the flush in
+ * close()) returns, so the sink holds two frames: the one being sent and
+ * the one the SDK may still read. Frames from OutputSinkManager are kept
+ * by reference (writeSharedFrame()), others are copied into one of two
+ * buffers of its own.
+ *
+ * The destination is the NDI source name. OutputSinkConfig: width/height
+ * of the feed (the canvas is scaled on the GPU), frameRate.
+ */
+class NDIOutput : public OutputSink {
+public:
+    NDIOutput();
+    ~NDIOutput() override;
+
+    // Disable copy
+    NDIOutput(const NDIOutput&) = delete;
+    NDIOutput& operator=(const NDIOutput&) = delete;
+
+    // ===== OutputSink =====
+
+    bool open(const std::string& destination, const OutputSinkConfig& config) override;
+    void close() override;
+    bool isReady() const override;
+
+    bool writeFrame(const FrameData& frame) override;
+    bool writeSharedFrame(const std::shared_ptr<const FrameData>& frame) override;
+
+    CaptureFormat getCaptureFormat() const override;
+
+    Type getType() const override { return Type::NDI; }
+    std::string getId() const override { return "ndi:" + name_; }
+    std::string getDescription() const override;
+
+    /**
+     * Receivers connected to the source (0 when not open)
+     */
+    int getConnectionCount() const;
+
+private:
+    bool send(const std::shared_ptr<const FrameData>& frame);
+
+    std::string name_;
+    int width_ = 0;
+    int height_ = 0;
+    int64_t frameRateNum_ = 25;
+    int64_t frameRateDen_ = 1;
+
+    // The frame the SDK may still read, and the two copy buffers of
+    // writeFrame() (the one not in flight is always free)
+    std::shared_ptr<const FrameData> inFlight_;
+    std::shared_ptr<FrameData> buffers_[2];
+    bool warnedGeometry_ = false;
+
+#ifdef HAVE_NDI_SDK
+    NDIlib_send_instance_t sender_ = nullptr;
+#endif
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_NDIOUTPUT_H
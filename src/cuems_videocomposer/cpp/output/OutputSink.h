@@ -11,6 +11,9 @@
 
 #include "FrameCapture.h"
 #include <string>
+#include <atomic>
+#include <cstddef>
+#include <memory>
 
 namespace videocomposer {
 
@@ -30,6 +33,23 @@ struct OutputSinkConfig {
     std::string container;      // Container format
 };
 
+/**
+ * Frame format a sink wants from the capture path; the canvas is
+ * converted and scaled on the GPU before readback
+ */
+struct CaptureFormat {
+    PixelFormat format = PixelFormat::RGBA32;
+    int width = 0;              // 0 = canvas size / 2^level
+    int height = 0;
+    int level = 0;              // Capture pyramid level: 0 full, 1 half, 2 quarter...
+    
+    bool operator==(const CaptureFormat& other) const {
+        return format == other.format && width == other.width && height == other.height &&
+               level == other.level;
+    }
+    bool operator!=(const CaptureFormat& other) const { return !(*this == other); }
+};
+
 /**
  * OutputSink - Abstract interface for virtual video outputs
  * 
@@ -48,7 +68,17 @@ public:
         NDI,        // NDI network streaming
         HARDWARE,   // Hardware capture card output
         STREAMING,  // RTSP/WebRTC streaming
-        FILE        // File recording
+        FILE,       // File recording
+        SHARED_MEMORY // Local readers through a shared-memory ring
+    };
+    
+    /**
+     * What OutputSinkManager does when this sink's frame queue is full
+     */
+    enum class DropPolicy {
+        DROP_OLDEST,    // Discard the oldest queued frame (live outputs)
+        DROP_NEWEST,    // Discard the incoming frame
+        BLOCK           // Wait for room; lossless, but holds up the caller
     };
     
     virtual ~OutputSink() = default;
@@ -77,12 +107,78 @@ public:
     
     /**
      * Write a frame to the output
-     * Must be thread-safe - may be called from render thread
+     * Called from this sink's worker thread in OutputSinkManager, one frame
+     * at a time; may block for as long as the output needs
      * @param frame Frame data to write
      * @return true on success
      */
     virtual bool writeFrame(const FrameData& frame) = 0;
     
+    /**
+     * Write a frame the sink may keep a reference to after returning
+     * (e.g. an async send reading the buffer until the next frame)
+     * Called by OutputSinkManager instead of writeFrame(); the default
+     * just writes it
+     */
+    virtual bool writeSharedFrame(const std::shared_ptr<const FrameData>& frame) {
+        return writeFrame(*frame);
+    }
+    
+    /**
+     * Policy when the queue in front of this sink is full
+     */
+    virtual DropPolicy getDropPolicy() const { return DropPolicy::DROP_OLDEST; }
+    
+    /**
+     * Frames queued in front of this sink at most
+     */
+    virtual size_t getQueueDepth() const { return 2; }
+    
+    /**
+     * Format and size of the frames this sink is given (RGBA32, NV12,
+     * YUV420P, UYVY422 or BGRA32); converted before readback
+     */
+    virtual CaptureFormat getCaptureFormat() const { return CaptureFormat(); }
+    
+    // ===== GPU Output =====
+    
+    /**
+     * GPU sinks take the canvas texture on the render thread instead of a
+     * readback (e.g. hardware encoders importing it as dmabuf); they are
+     * never given frames through writeFrame()
+     */
+    virtual bool isGpuSink() const { return false; }
+    
+    /**
+     * Hand over the canvas (render thread, canvas context current)
+     * Must return quickly: only queue GPU work, never wait on it
+     * @param texture Canvas texture, bottom row first
+     * @param width Canvas width
+     * @param height Canvas height
+     * @param timestamp Monotonic time of the frame in microseconds
+     * @return true if the frame was taken (false = dropped)
+     */
+    virtual bool writeTexture(GLuint texture, int width, int height, int64_t timestamp) {
+        (void)texture; (void)width; (void)height; (void)timestamp;
+        return false;
+    }
+    
+    // ===== Output Clock =====
+    
+    /**
+     * Hardware outputs playing on their own clock (genlocked SDI) report
+     * where the next frame written will be shown, so the render loop can
+     * follow them instead of the display
+     * @param frame Output frame counter the next frame is shown on
+     * @param rateHz Output frame rate
+     * @param leadNs Time from now until it is shown
+     * @return false if the sink has no clock (or it is not running yet)
+     */
+    virtual bool getOutputClock(int64_t& frame, double& rateHz, int64_t& leadNs) const {
+        (void)frame; (void)rateHz; (void)leadNs;
+        return false;
+    }
+    
     // ===== Identification =====
     
     /**
@@ -102,20 +198,29 @@ public:
     
     // ===== Statistics =====
     
+    // Defaults are measured by OutputSinkManager around writeFrame()
+    
     /**
      * Get frames written since open
      */
-    virtual int64_t getFramesWritten() const { return 0; }
+    virtual int64_t getFramesWritten() const { return framesWritten_.load(std::memory_order_relaxed); }
     
     /**
      * Get frames dropped (couldn't be written in time)
      */
-    virtual int64_t getFramesDropped() const { return 0; }
+    virtual int64_t getFramesDropped() const { return framesDropped_.load(std::memory_order_relaxed); }
     
     /**
-     * Get current output latency in milliseconds
+     * Get current output latency in milliseconds: from the frame being
+     * handed to the manager until writeFrame() returned, smoothed
      */
-    virtual double getLatencyMs() const { return 0.0; }
+    virtual double getLatencyMs() const { return latencyUs_.load(std::memory_order_relaxed) / 1000.0; }
+    
+private:
+    friend class OutputSinkManager;
+    std::atomic<int64_t> framesWritten_{0};
+    std::atomic<int64_t> framesDropped_{0};
+    std::atomic<int64_t> latencyUs_{0};
 };
 
 /**
@@ -127,6 +232,7 @@ inline const char* outputSinkTypeName(OutputSink::Type type) {
         case OutputSink::Type::HARDWARE: return "Hardware";
         case OutputSink::Type::STREAMING: return "Streaming";
         case OutputSink::Type::FILE: return "File";
+        case OutputSink::Type::SHARED_MEMORY: return "Shared memory";
         default: return "Unknown";
     }
 }
@@ -4,6 +4,10 @@
 
 #include "OutputSinkManager.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/TimeUtils.h"
+#include <algorithm>
+#include <cstring>
 
 namespace videocomposer {
 
@@ -26,7 +30,7 @@ bool OutputSinkManager::addSink(std::unique_ptr<OutputSink> sink) {
     // Check for duplicate ID
     std::string id = sink->getId();
     for (const auto& existing : sinks_) {
-        if (existing->getId() == id) {
+        if (existing->sink->getId() == id) {
             LOG_ERROR << "OutputSinkManager: Sink with ID '" << id << "' already exists";
             return false;
         }
@@ -35,7 +39,9 @@ bool OutputSinkManager::addSink(std::unique_ptr<OutputSink> sink) {
     LOG_INFO << "OutputSinkManager: Added sink '" << id 
              << "' (" << sink->getDescription() << ")";
     
-    sinks_.push_back(std::move(sink));
+    auto worker = std::make_unique<SinkWorker>();
+    worker->sink = std::move(sink);
+    sinks_.push_back(std::move(worker));
     return true;
 }
 
@@ -43,8 +49,9 @@ bool OutputSinkManager::removeSink(const std::string& id) {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     for (auto it = sinks_.begin(); it != sinks_.end(); ++it) {
-        if ((*it)->getId() == id) {
-            (*it)->close();
+        if ((*it)->sink->getId() == id) {
+            stopWorker(**it);
+            (*it)->sink->close();
             LOG_INFO << "OutputSinkManager: Removed sink '" << id << "'";
             sinks_.erase(it);
             return true;
@@ -57,9 +64,9 @@ bool OutputSinkManager::removeSink(const std::string& id) {
 OutputSink* OutputSinkManager::getSink(const std::string& id) {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
-    for (auto& sink : sinks_) {
-        if (sink->getId() == id) {
-            return sink.get();
+    for (auto& worker : sinks_) {
+        if (worker->sink->getId() == id) {
+            return worker->sink.get();
         }
     }
     
@@ -69,9 +76,9 @@ OutputSink* OutputSinkManager::getSink(const std::string& id) {
 OutputSink* OutputSinkManager::getSinkByType(OutputSink::Type type) {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
-    for (auto& sink : sinks_) {
-        if (sink->getType() == type) {
-            return sink.get();
+    for (auto& worker : sinks_) {
+        if (worker->sink->getType() == type) {
+            return worker->sink.get();
         }
     }
     
@@ -82,32 +89,95 @@ std::vector<OutputSink*> OutputSinkManager::getSinksByType(OutputSink::Type type
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     std::vector<OutputSink*> result;
-    for (auto& sink : sinks_) {
-        if (sink->getType() == type) {
-            result.push_back(sink.get());
+    for (auto& worker : sinks_) {
+        if (worker->sink->getType() == type) {
+            result.push_back(worker->sink.get());
         }
     }
     
     return result;
 }
 
+void OutputSinkManager::writeFrameToAll(FrameData&& frame) {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    
+    stampTimecode(frame);
+    std::shared_ptr<const FrameData> shared;
+    int64_t nowUs = vc_get_monotonic_time();
+    for (auto& worker : sinks_) {
+        if (!worker->sink->isReady() || worker->sink->isGpuSink()) {
+            continue;
+        }
+        if (!shared) {
+            // A borrowed buffer may be reused once we return
+            shared = frame.ownsData ? std::make_shared<const FrameData>(std::move(frame)) : copyFrame(frame);
+        }
+        enqueue(*worker, shared, nowUs);
+    }
+}
+
 void OutputSinkManager::writeFrameToAll(const FrameData& frame) {
+    if (!hasActiveSinks()) {
+        return;
+    }
+    FrameData copy;
+    copy.data = frame.data;
+    copy.size = frame.size;
+    copy.width = frame.width;
+    copy.height = frame.height;
+    copy.format = frame.format;
+    copy.timestamp = frame.timestamp;
+    copy.frameNumber = frame.frameNumber;
+    copy.timecode = frame.timecode;
+    copy.timecodeFps = frame.timecodeFps;
+    copy.ownsData = false;
+    writeFrameToAll(std::move(copy));
+}
+
+void OutputSinkManager::writeFrameToFormat(FrameData&& frame, const CaptureFormat& format) {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    
+    stampTimecode(frame);
+    std::shared_ptr<const FrameData> shared;
+    int64_t nowUs = vc_get_monotonic_time();
+    for (auto& worker : sinks_) {
+        if (!worker->sink->isReady() || worker->sink->isGpuSink() ||
+            worker->sink->getCaptureFormat() != format) {
+            continue;
+        }
+        if (!shared) {
+            shared = frame.ownsData ? std::make_shared<const FrameData>(std::move(frame)) : copyFrame(frame);
+        }
+        enqueue(*worker, shared, nowUs);
+    }
+}
+
+bool OutputSinkManager::writeTextureToGpuSinks(GLuint texture, int width, int height, int64_t timestamp) {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
-    for (auto& sink : sinks_) {
-        if (sink->isReady()) {
-            sink->writeFrame(frame);
+    bool any = false;
+    for (auto& worker : sinks_) {
+        OutputSink& sink = *worker->sink;
+        if (!sink.isReady() || !sink.isGpuSink()) {
+            continue;
+        }
+        any = true;
+        if (sink.writeTexture(texture, width, height, timestamp)) {
+            sink.framesWritten_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            sink.framesDropped_.fetch_add(1, std::memory_order_relaxed);
         }
     }
+    return any;
 }
 
 bool OutputSinkManager::writeFrameToSink(const std::string& id, const FrameData& frame) {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
-    for (auto& sink : sinks_) {
-        if (sink->getId() == id) {
-            if (sink->isReady()) {
-                return sink->writeFrame(frame);
+    for (auto& worker : sinks_) {
+        if (worker->sink->getId() == id) {
+            if (worker->sink->isReady() && !worker->sink->isGpuSink()) {
+                return enqueue(*worker, copyFrame(frame), vc_get_monotonic_time());
             }
             return false;
         }
@@ -116,11 +186,135 @@ bool OutputSinkManager::writeFrameToSink(const std::string& id, const FrameData&
     return false;
 }
 
+void OutputSinkManager::flush() {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    
+    for (auto& worker : sinks_) {
+        std::unique_lock<std::mutex> queueLock(worker->mutex);
+        worker->idle.wait(queueLock, [&worker]() {
+            return (worker->queue.empty() && !worker->writing) || !worker->thread.joinable();
+        });
+    }
+}
+
+void OutputSinkManager::setTimecode(int64_t frame, double fps) {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    timecode_ = frame;
+    timecodeFps_ = fps;
+}
+
+void OutputSinkManager::stampTimecode(FrameData& frame) const {
+    if (frame.timecode < 0) {
+        frame.timecode = timecode_;
+        frame.timecodeFps = timecodeFps_;
+    }
+}
+
+std::shared_ptr<const FrameData> OutputSinkManager::copyFrame(const FrameData& frame) {
+    auto copy = std::make_shared<FrameData>();
+    copy->size = frame.size;
+    copy->width = frame.width;
+    copy->height = frame.height;
+    copy->format = frame.format;
+    copy->timestamp = frame.timestamp;
+    copy->frameNumber = frame.frameNumber;
+    copy->timecode = frame.timecode;
+    copy->timecodeFps = frame.timecodeFps;
+    if (frame.data && frame.size > 0) {
+        copy->data = new uint8_t[frame.size];
+        std::memcpy(copy->data, frame.data, frame.size);
+        copy->ownsData = true;
+    }
+    return copy;
+}
+
+bool OutputSinkManager::enqueue(SinkWorker& worker, const std::shared_ptr<const FrameData>& frame, int64_t nowUs) {
+    startWorker(worker);
+    
+    OutputSink& sink = *worker.sink;
+    size_t depth = std::max<size_t>(1, sink.getQueueDepth());
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (worker.queue.size() >= depth) {
+        switch (sink.getDropPolicy()) {
+            case OutputSink::DropPolicy::DROP_OLDEST:
+                worker.queue.pop_front();
+                sink.framesDropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case OutputSink::DropPolicy::DROP_NEWEST:
+                sink.framesDropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OutputSink::DropPolicy::BLOCK:
+                worker.idle.wait(lock, [&worker, depth]() {
+                    return worker.queue.size() < depth || worker.stopping;
+                });
+                break;
+        }
+    }
+    worker.queue.push_back(QueuedFrame{frame, nowUs});
+    worker.wake.notify_one();
+    return true;
+}
+
+void OutputSinkManager::startWorker(SinkWorker& worker) {
+    if (worker.thread.joinable()) {
+        return;
+    }
+    worker.stopping = false;
+    worker.thread = std::thread(runWorker, &worker);
+}
+
+void OutputSinkManager::stopWorker(SinkWorker& worker) {
+    if (!worker.thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.stopping = true;
+    }
+    worker.wake.notify_one();
+    worker.thread.join();
+    worker.idle.notify_all();
+}
+
+void OutputSinkManager::runWorker(SinkWorker* worker) {
+    ThreadRoles::instance().apply(ThreadRole::OUTPUT);
+    OutputSink& sink = *worker->sink;
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    while (true) {
+        worker->wake.wait(lock, [worker]() { return worker->stopping || !worker->queue.empty(); });
+        if (worker->queue.empty()) {
+            break;  // Stopping, and everything queued was written
+        }
+        QueuedFrame item = std::move(worker->queue.front());
+        worker->queue.pop_front();
+        worker->writing = true;
+        worker->idle.notify_all();
+        lock.unlock();
+        
+        bool written = sink.isReady() && sink.writeSharedFrame(item.frame);
+        if (written) {
+            sink.framesWritten_.fetch_add(1, std::memory_order_relaxed);
+            // Smoothed over about 8 frames
+            int64_t latency = vc_get_monotonic_time() - item.queuedUs;
+            int64_t previous = sink.latencyUs_.load(std::memory_order_relaxed);
+            sink.latencyUs_.store(previous > 0 ? previous + (latency - previous) / 8 : latency,
+                                  std::memory_order_relaxed);
+        } else {
+            sink.framesDropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        item.frame.reset();
+        
+        lock.lock();
+        worker->writing = false;
+        worker->idle.notify_all();
+    }
+}
+
 bool OutputSinkManager::hasActiveSinks() const {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
-    for (const auto& sink : sinks_) {
-        if (sink->isReady()) {
+    for (const auto& worker : sinks_) {
+        if (worker->sink->isReady()) {
             return true;
         }
     }
@@ -132,8 +326,8 @@ size_t OutputSinkManager::getActiveSinkCount() const {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     size_t count = 0;
-    for (const auto& sink : sinks_) {
-        if (sink->isReady()) {
+    for (const auto& worker : sinks_) {
+        if (worker->sink->isReady()) {
             ++count;
         }
     }
@@ -145,21 +339,38 @@ std::vector<std::string> OutputSinkManager::getActiveSinkIds() const {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     std::vector<std::string> ids;
-    for (const auto& sink : sinks_) {
-        if (sink->isReady()) {
-            ids.push_back(sink->getId());
+    for (const auto& worker : sinks_) {
+        if (worker->sink->isReady()) {
+            ids.push_back(worker->sink->getId());
         }
     }
     
     return ids;
 }
 
+std::vector<CaptureFormat> OutputSinkManager::getCaptureFormats() const {
+    std::lock_guard<std::mutex> lock(sinksMutex_);
+    
+    std::vector<CaptureFormat> formats;
+    for (const auto& worker : sinks_) {
+        if (!worker->sink->isReady() || worker->sink->isGpuSink()) {
+            continue;
+        }
+        CaptureFormat format = worker->sink->getCaptureFormat();
+        if (std::find(formats.begin(), formats.end(), format) == formats.end()) {
+            formats.push_back(format);
+        }
+    }
+    
+    return formats;
+}
+
 std::vector<std::string> OutputSinkManager::getAllSinkIds() const {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     std::vector<std::string> ids;
-    for (const auto& sink : sinks_) {
-        ids.push_back(sink->getId());
+    for (const auto& worker : sinks_) {
+        ids.push_back(worker->sink->getId());
     }
     
     return ids;
@@ -168,9 +379,11 @@ std::vector<std::string> OutputSinkManager::getAllSinkIds() const {
 void OutputSinkManager::closeAll() {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
-    for (auto& sink : sinks_) {
-        if (sink->isReady()) {
-            sink->close();
+    // Queued frames are written before the sink closes
+    for (auto& worker : sinks_) {
+        stopWorker(*worker);
+        if (worker->sink->isReady()) {
+            worker->sink->close();
         }
     }
     
@@ -180,6 +393,9 @@ void OutputSinkManager::closeAll() {
 void OutputSinkManager::clear() {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
+    for (auto& worker : sinks_) {
+        stopWorker(*worker);
+    }
     sinks_.clear();
     LOG_INFO << "OutputSinkManager: Cleared all sinks";
 }
@@ -188,8 +404,8 @@ int64_t OutputSinkManager::getTotalFramesWritten() const {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     int64_t total = 0;
-    for (const auto& sink : sinks_) {
-        total += sink->getFramesWritten();
+    for (const auto& worker : sinks_) {
+        total += worker->sink->getFramesWritten();
     }
     
     return total;
@@ -199,8 +415,8 @@ int64_t OutputSinkManager::getTotalFramesDropped() const {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     
     int64_t total = 0;
-    for (const auto& sink : sinks_) {
-        total += sink->getFramesDropped();
+    for (const auto& worker : sinks_) {
+        total += worker->sink->getFramesDropped();
     }
     
     return total;
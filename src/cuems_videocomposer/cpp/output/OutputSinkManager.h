@@ -13,6 +13,9 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 #include <string>
 
 namespace videocomposer {
@@ -25,6 +28,11 @@ namespace videocomposer {
  * - Broadcasting frames to all active sinks
  * - Thread-safe frame distribution
  * - Status reporting
+ *
+ * Each sink is fed by its own worker thread through a bounded queue, so a
+ * slow sink only drops its own frames (see OutputSink::DropPolicy) and the
+ * render loop never waits on writeFrame(). Queued frames are shared
+ * between the sinks, not copied per sink.
  */
 class OutputSinkManager {
 public:
@@ -69,20 +77,46 @@ public:
     // ===== Frame Distribution =====
     
     /**
-     * Write a frame to all active sinks
+     * Queue a frame for all active sinks (returns without waiting for them)
      * Thread-safe - can be called from render thread
-     * @param frame Frame data to write
+     * @param frame Frame data to write (moved from without a copy)
      */
+    void writeFrameToAll(FrameData&& frame);
     void writeFrameToAll(const FrameData& frame);
     
     /**
-     * Write a frame to a specific sink
+     * Queue a frame for the active sinks that asked for this format
+     * (see getCaptureFormats())
+     */
+    void writeFrameToFormat(FrameData&& frame, const CaptureFormat& format);
+    
+    /**
+     * Hand the canvas texture to the GPU sinks (render thread only)
+     * @return true if there is any GPU sink
+     */
+    bool writeTextureToGpuSinks(GLuint texture, int width, int height, int64_t timestamp);
+    
+    /**
+     * Queue a frame for a specific sink
      * @param id Sink ID
      * @param frame Frame data
-     * @return true if sink found and frame written
+     * @return true if sink found and frame queued
      */
     bool writeFrameToSink(const std::string& id, const FrameData& frame);
     
+    /**
+     * Show timecode stamped on the frames queued from now on (frames that
+     * already carry one keep it)
+     * @param frame Timecode in frames (-1 = none)
+     * @param fps Framerate of the timecode
+     */
+    void setTimecode(int64_t frame, double fps);
+    
+    /**
+     * Wait until every sink has written its queued frames
+     */
+    void flush();
+    
     // ===== Status =====
     
     /**
@@ -100,6 +134,11 @@ public:
      */
     std::vector<std::string> getActiveSinkIds() const;
     
+    /**
+     * Distinct capture formats of the active CPU sinks, one conversion each
+     */
+    std::vector<CaptureFormat> getCaptureFormats() const;
+    
     /**
      * Get all sink IDs (active and inactive)
      */
@@ -130,8 +169,34 @@ public:
     int64_t getTotalFramesDropped() const;
     
 private:
-    std::vector<std::unique_ptr<OutputSink>> sinks_;
+    struct QueuedFrame {
+        std::shared_ptr<const FrameData> frame;
+        int64_t queuedUs = 0;       // Monotonic time the frame was handed over
+    };
+    
+    // One sink, its queue and the thread writing to it
+    struct SinkWorker {
+        std::unique_ptr<OutputSink> sink;
+        std::deque<QueuedFrame> queue;
+        std::mutex mutex;
+        std::condition_variable wake;   // Frame queued, or stopping
+        std::condition_variable idle;   // Room in the queue, or queue drained
+        bool writing = false;
+        bool stopping = false;
+        std::thread thread;
+    };
+    
+    static std::shared_ptr<const FrameData> copyFrame(const FrameData& frame);
+    void stampTimecode(FrameData& frame) const;
+    bool enqueue(SinkWorker& worker, const std::shared_ptr<const FrameData>& frame, int64_t nowUs);
+    static void startWorker(SinkWorker& worker);
+    static void stopWorker(SinkWorker& worker);   // Writes what is queued first
+    static void runWorker(SinkWorker* worker);
+    
+    std::vector<std::unique_ptr<SinkWorker>> sinks_;
     mutable std::mutex sinksMutex_;
+    int64_t timecode_ = -1;
+    double timecodeFps_ = 0.0;
 };
 
 } // namespace videocomposer
@@ -0,0 +1,57 @@
+/**
+ * PlayoutSchedule.cpp - Frame slots of a scheduled-playback output
+ */
+
+#include "PlayoutSchedule.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+void PlayoutSchedule::reset(int64_t frameDuration, int64_t timeScale) {
+    frameDuration_ = std::max<int64_t>(frameDuration, 1);
+    timeScale_ = std::max<int64_t>(timeScale, 1);
+    nextSlot_ = 0;
+    inFlight_ = 0;
+    started_ = false;
+    reanchor_ = false;
+    anchorTime_ = 0;
+    late_ = 0;
+    dropped_ = 0;
+}
+
+bool PlayoutSchedule::next(int64_t& displayTime) {
+    if (inFlight_ >= MAX_AHEAD) {
+        return false;
+    }
+    if (reanchor_) {
+        // Behind the card: the slots already due are skipped
+        int64_t now = anchorTime_ / frameDuration_;
+        nextSlot_ = std::max(nextSlot_, now + PREROLL);
+        reanchor_ = false;
+    }
+    displayTime = nextSlot_ * frameDuration_;
+    ++nextSlot_;
+    return true;
+}
+
+void PlayoutSchedule::completed(Completion completion, int64_t streamTime) {
+    inFlight_ = std::max(inFlight_ - 1, 0);
+    switch (completion) {
+        case Completion::LATE:
+            ++late_;
+            break;
+        case Completion::DROPPED:
+            ++dropped_;
+            break;
+        default:
+            return;
+    }
+    reanchor_ = true;
+    anchorTime_ = std::max(anchorTime_, streamTime);
+}
+
+int64_t PlayoutSchedule::getOutputFrame(int64_t streamTime) const {
+    return streamTime > 0 ? streamTime / frameDuration_ : 0;
+}
+
+} // namespace videocomposer
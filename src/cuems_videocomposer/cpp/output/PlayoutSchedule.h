@@ -0,0 +1,88 @@
+/**
+ * PlayoutSchedule.h - Frame slots of a scheduled-playback output
+ */
+
+#ifndef VIDEOCOMPOSER_PLAYOUTSCHEDULE_H
+#define VIDEOCOMPOSER_PLAYOUTSCHEDULE_H
+
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * PlayoutSchedule - Which output frame each rendered frame is shown on
+ *
+ * Scheduled playback (DeckLink) shows a frame at a stream time in units
+ * of the card's reference clock, one frame duration apart. Rendered frames
+ * take consecutive slots; playback starts once PREROLL of them are queued.
+ * The card runs on its own (genlocked) clock, so the render loop may fall
+ * behind: a frame shown late or dropped moves the next slot to the
+ * card's current position plus the preroll rather than queueing further
+ * frames that are already late. A render loop running fast is held at
+ * MAX_AHEAD scheduled frames (the rest are dropped), keeping the latency
+ * bounded.
+ */
+class PlayoutSchedule {
+public:
+    static constexpr int PREROLL = 3;
+    static constexpr int MAX_AHEAD = 5;
+
+    enum class Completion {
+        DISPLAYED,
+        LATE,       // Shown, after its slot
+        DROPPED,    // Never shown
+        FLUSHED     // Discarded when playback stopped
+    };
+
+    /**
+     * @param frameDuration,timeScale One frame in reference clock units
+     *        (e.g. 1000/25000 for 25 fps, 1001/30000 for 29.97)
+     */
+    void reset(int64_t frameDuration, int64_t timeScale);
+
+    /**
+     * Slot for the next rendered frame
+     * @param displayTime Stream time to schedule it at
+     * @return false if MAX_AHEAD frames are scheduled (drop this one)
+     */
+    bool next(int64_t& displayTime);
+
+    /** A frame was queued at the last next() slot */
+    void scheduled() { ++inFlight_; }
+
+    /** Whether enough frames are queued to start playback */
+    bool readyToStart() const { return !started_ && inFlight_ >= PREROLL; }
+    void started() { started_ = true; }
+    bool isStarted() const { return started_; }
+
+    /**
+     * A scheduled frame completed
+     * @param streamTime The card's stream time now (for re-anchoring late output)
+     */
+    void completed(Completion completion, int64_t streamTime);
+
+    int getInFlight() const { return inFlight_; }
+    int64_t getFrameDuration() const { return frameDuration_; }
+    int64_t getTimeScale() const { return timeScale_; }
+
+    /** Output frames played so far: the card's frame counter */
+    int64_t getOutputFrame(int64_t streamTime) const;
+
+    uint64_t getLateCount() const { return late_; }
+    uint64_t getDroppedCount() const { return dropped_; }
+
+private:
+    int64_t frameDuration_ = 1000;
+    int64_t timeScale_ = 25000;
+    int64_t nextSlot_ = 0;      // In frames
+    int inFlight_ = 0;
+    bool started_ = false;
+    bool reanchor_ = false;
+    int64_t anchorTime_ = 0;
+    uint64_t late_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PLAYOUTSCHEDULE_H
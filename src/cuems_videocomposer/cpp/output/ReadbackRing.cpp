@@ -0,0 +1,187 @@
+/**
+ * ReadbackRing.cpp - Fenced pixel pack buffer ring
+ */
+
+#include "ReadbackRing.h"
+#include "../utils/Logger.h"
+#include <GL/glew.h>  // Must be included before GL/gl.h
+#include <GL/gl.h>
+#include <algorithm>
+#include <cstring>
+
+namespace videocomposer {
+
+namespace {
+
+GLuint glCreatePackBuffer(size_t size) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    if (buffer == 0) {
+        return 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return buffer;
+}
+
+bool glSignalled(void* fence, bool wait) {
+    // The flush makes sure the fence reaches the GPU, or a wait would never end
+    GLuint64 timeout = wait ? 1000000000ull : 0;   // 1 s
+    GLenum status = glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED;
+}
+
+bool glCopyOut(GLuint buffer, void* dest, size_t size) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+    if (ptr) {
+        memcpy(dest, ptr, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return ptr != nullptr;
+}
+
+ReadbackRing::Backend glBackend() {
+    ReadbackRing::Backend backend;
+    backend.createBuffer = glCreatePackBuffer;
+    backend.deleteBuffer = [](GLuint buffer) { glDeleteBuffers(1, &buffer); };
+    backend.fence = []() -> void* { return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); };
+    backend.signalled = glSignalled;
+    backend.deleteFence = [](void* fence) { glDeleteSync(static_cast<GLsync>(fence)); };
+    backend.copy = glCopyOut;
+    return backend;
+}
+
+} // namespace
+
+std::atomic<int> ReadbackRing::defaultDepth_(ReadbackRing::DEFAULT_DEPTH);
+
+void ReadbackRing::setDefaultDepth(int depth) {
+    defaultDepth_.store(std::max(1, std::min(depth, MAX_DEPTH)));
+}
+
+int ReadbackRing::getDefaultDepth() {
+    return defaultDepth_.load();
+}
+
+ReadbackRing::ReadbackRing()
+    : backend_(glBackend()) {
+}
+
+ReadbackRing::ReadbackRing(const Backend& backend)
+    : backend_(backend) {
+}
+
+ReadbackRing::~ReadbackRing() {
+    release();
+}
+
+bool ReadbackRing::configure(size_t size, int depth) {
+    if (depth <= 0) {
+        depth = getDefaultDepth();
+    }
+    depth = std::max(1, std::min(depth, MAX_DEPTH));
+    if (size == size_ && depth == getDepth()) {
+        return true;
+    }
+
+    release();
+    if (size == 0) {
+        return false;
+    }
+    slots_.resize(static_cast<size_t>(depth));
+    for (Slot& slot : slots_) {
+        slot.buffer = backend_.createBuffer(size);
+        if (slot.buffer == 0) {
+            LOG_ERROR << "ReadbackRing: Failed to create " << depth << " pack buffers of " << size << " bytes";
+            release();
+            return false;
+        }
+    }
+    size_ = size;
+    LOG_VERBOSE << "ReadbackRing: " << depth << " buffers of " << size << " bytes";
+    return true;
+}
+
+void ReadbackRing::release() {
+    for (Slot& slot : slots_) {
+        if (slot.fence) {
+            backend_.deleteFence(slot.fence);
+        }
+        if (slot.buffer != 0) {
+            backend_.deleteBuffer(slot.buffer);
+        }
+    }
+    slots_.clear();
+    size_ = 0;
+    head_ = 0;
+    count_ = 0;
+    begun_ = false;
+}
+
+GLuint ReadbackRing::begin() {
+    if (slots_.empty()) {
+        return 0;
+    }
+    if (full()) {
+        ++dropped_;
+        return 0;
+    }
+    begun_ = true;
+    return slots_[(head_ + count_) % slots_.size()].buffer;
+}
+
+void ReadbackRing::submit(int64_t tag) {
+    if (!begun_) {
+        return;
+    }
+    begun_ = false;
+    Slot& slot = slots_[(head_ + count_) % slots_.size()];
+    slot.fence = backend_.fence();
+    slot.tag = tag;
+    ++count_;
+}
+
+bool ReadbackRing::ready() {
+    if (count_ == 0) {
+        return false;
+    }
+    const Slot& slot = slots_[static_cast<size_t>(head_)];
+    return !slot.fence || backend_.signalled(slot.fence, false);
+}
+
+bool ReadbackRing::poll(void* dest, size_t size, int64_t* tag) {
+    return take(dest, size, tag, false);
+}
+
+bool ReadbackRing::wait(void* dest, size_t size, int64_t* tag) {
+    return take(dest, size, tag, true);
+}
+
+bool ReadbackRing::take(void* dest, size_t size, int64_t* tag, bool block) {
+    if (count_ == 0) {
+        return false;
+    }
+    Slot& slot = slots_[static_cast<size_t>(head_)];
+    if (slot.fence && !backend_.signalled(slot.fence, block)) {
+        return false;
+    }
+    if (slot.fence) {
+        backend_.deleteFence(slot.fence);
+        slot.fence = nullptr;
+    }
+    head_ = (head_ + 1) % static_cast<int>(slots_.size());
+    --count_;
+
+    if (!dest || size < size_) {
+        return false;
+    }
+    if (tag) {
+        *tag = slot.tag;
+    }
+    return backend_.copy(slot.buffer, dest, size_);
+}
+
+} // namespace videocomposer
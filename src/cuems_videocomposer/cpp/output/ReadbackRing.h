@@ -0,0 +1,149 @@
+/**
+ * ReadbackRing.h - N-deep fenced pixel pack buffer ring for GPU readback
+ *
+ * glReadPixels into a pixel pack buffer returns at once, but mapping the
+ * buffer waits for the transfer. With two buffers the map of the previous
+ * frame's readback stalls the render loop whenever the GPU runs more than
+ * a frame behind. Here every readback gets a fence, and a buffer is only
+ * mapped once its fence has signalled: capture never waits on the GPU.
+ */
+
+#ifndef VIDEOCOMPOSER_READBACKRING_H
+#define VIDEOCOMPOSER_READBACKRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Forward declaration to avoid including OpenGL headers here
+typedef unsigned int GLuint;
+
+namespace videocomposer {
+
+/**
+ * ReadbackRing - Readbacks in flight, handed out oldest first
+ *
+ * Usage (render context current):
+ *   ring.configure(frameBytes);
+ *   // Every frame:
+ *   while (ring.ready()) { ring.poll(data, frameBytes); ... }  // Finished readbacks
+ *   GLuint buffer = ring.begin();                        // 0: all in flight, frame dropped
+ *   if (buffer) {
+ *       glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+ *       glReadPixels(..., nullptr);
+ *       glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+ *       ring.submit(frameNumber);
+ *   }
+ *
+ * Lossless callers wait() for the oldest readback instead of dropping
+ * when the ring is full.
+ */
+class ReadbackRing {
+public:
+    /**
+     * GL calls behind the ring (replaced in tests)
+     */
+    struct Backend {
+        std::function<GLuint(size_t size)> createBuffer;       // Pixel pack buffer, 0 on failure
+        std::function<void(GLuint buffer)> deleteBuffer;
+        std::function<void*()> fence;                          // GLsync, nullptr = none (map waits)
+        std::function<bool(void* fence, bool wait)> signalled; // wait: block until it signals
+        std::function<void(void* fence)> deleteFence;
+        std::function<bool(GLuint buffer, void* dest, size_t size)> copy;  // Map, copy out, unmap
+    };
+
+    static constexpr int DEFAULT_DEPTH = 3;
+    static constexpr int MAX_DEPTH = 8;
+
+    /**
+     * Depth of rings configured without one (capture_readback_depth)
+     */
+    static void setDefaultDepth(int depth);
+    static int getDefaultDepth();
+
+    /** Backed by the current GL context */
+    ReadbackRing();
+    explicit ReadbackRing(const Backend& backend);
+    ~ReadbackRing();
+
+    ReadbackRing(const ReadbackRing&) = delete;
+    ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+    /**
+     * Allocate the buffers (again only if the size or depth changed;
+     * readbacks in flight are dropped then)
+     * @param size Bytes of one readback
+     * @param depth Buffers (0 = default depth)
+     * @return true on success
+     */
+    bool configure(size_t size, int depth = 0);
+
+    /** Delete the buffers and fences (render context current) */
+    void release();
+
+    bool isConfigured() const { return !slots_.empty(); }
+
+    /**
+     * Buffer to issue the next readback into
+     * @return Buffer name, 0 when every buffer is in flight (counted as a drop)
+     */
+    GLuint begin();
+
+    /**
+     * Fence the readback just issued into begin()'s buffer
+     * @param tag Caller's frame number, returned with the bytes
+     */
+    void submit(int64_t tag = 0);
+
+    /** Whether the oldest readback has finished (non-blocking) */
+    bool ready();
+
+    /**
+     * Copy out the oldest readback if its fence has signalled (non-blocking)
+     * @param dest At least getSize() bytes
+     * @param tag Receives the readback's tag (optional)
+     * @return true if bytes were copied
+     */
+    bool poll(void* dest, size_t size, int64_t* tag = nullptr);
+
+    /**
+     * Copy out the oldest readback, waiting for it
+     * @return true if bytes were copied, false if nothing was in flight
+     */
+    bool wait(void* dest, size_t size, int64_t* tag = nullptr);
+
+    /** Readbacks issued and not yet copied out */
+    int pending() const { return count_; }
+    bool full() const { return !slots_.empty() && count_ == static_cast<int>(slots_.size()); }
+
+    int getDepth() const { return static_cast<int>(slots_.size()); }
+    size_t getSize() const { return size_; }
+
+    /** Readbacks skipped because every buffer was in flight */
+    uint64_t getDropped() const { return dropped_; }
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        void* fence = nullptr;
+        int64_t tag = 0;
+    };
+
+    bool take(void* dest, size_t size, int64_t* tag, bool block);
+
+    Backend backend_;
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+    int head_ = 0;     // Oldest readback in flight
+    int count_ = 0;
+    bool begun_ = false;
+    uint64_t dropped_ = 0;
+
+    static std::atomic<int> defaultDepth_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_READBACKRING_H
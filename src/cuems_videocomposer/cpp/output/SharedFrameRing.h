@@ -0,0 +1,110 @@
+/**
+ * SharedFrameRing.h - Memory layout of the shared-memory frame ring
+ *
+ * Shared between SharedMemoryOutput (the writer) and local readers such as
+ * the operator preview. Plain C++ without dependencies, so reader tools
+ * can include this file alone.
+ *
+ * Connecting: a reader connects to the sink's Unix socket and receives one
+ * message: a uint32_t fd count, with SCM_RIGHTS carrying, in order, the
+ * ring memfd, an eventfd that is signalled after every published frame
+ * and, in dmabuf mode, one dmabuf per slot (the same memory, importable
+ * by EGL/Vulkan, pixels at offset SLOT_HEADER_SIZE).
+ *
+ * Reading (seqlock per slot, never blocks the writer):
+ *   1. seq = header->latest; wait on the eventfd if unchanged
+ *   2. slot = slotAt(base, header, seq % header->slotCount)
+ *   3. s1 = slot->sequence (acquire); odd or != 2 * seq + 2 -> overwritten, retry
+ *   4. use the pixels at slotData(base, header, index)
+ *   5. s2 = slot->sequence (acquire); s1 != s2 -> the frame was torn, retry
+ */
+
+#ifndef VIDEOCOMPOSER_SHAREDFRAMERING_H
+#define VIDEOCOMPOSER_SHAREDFRAMERING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace videocomposer {
+namespace shm {
+
+constexpr uint32_t RING_MAGIC = 0x52534356;   // "VCSR"
+constexpr uint32_t RING_VERSION = 1;
+constexpr size_t RING_ALIGNMENT = 4096;       // Slots start on page boundaries (dmabuf export)
+
+/**
+ * Pixel formats, values fixed for the ABI
+ */
+enum RingFormat : uint32_t {
+    RING_FORMAT_RGBA = 1,       // 4 bytes per pixel, R G B A
+    RING_FORMAT_BGRA = 2,
+    RING_FORMAT_UYVY = 3,       // 4:2:2 packed, U Y0 V Y1
+    RING_FORMAT_NV12 = 4,       // Y plane, then interleaved UV plane
+    RING_FORMAT_I420 = 5        // Y, U, V planes
+};
+
+/**
+ * At offset 0 of the memfd
+ */
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t format;            // RingFormat
+    uint32_t width;
+    uint32_t height;
+    uint64_t slotStride;        // Bytes from one slot to the next (page multiple)
+    uint64_t firstSlotOffset;   // Offset of slot 0 (page multiple)
+    uint64_t frameSize;         // Bytes of one frame
+    uint32_t planeOffsets[3];   // Within the frame data (unused planes = 0)
+    uint32_t planeStrides[3];
+    std::atomic<uint64_t> latest;   // Sequence number of the newest complete frame
+    std::atomic<uint64_t> published;// Frames published so far (latest + 1, 0 = none yet)
+};
+
+/**
+ * At the start of each slot; the frame's pixels follow at SLOT_HEADER_SIZE
+ */
+struct SlotHeader {
+    std::atomic<uint64_t> sequence; // 2 * seq + 1 while writing, 2 * seq + 2 when complete
+    int64_t frameNumber;            // Capture frame number
+    int64_t timestampUs;            // Monotonic capture time (CLOCK_MONOTONIC)
+    int64_t timecode;               // Show timecode in frames, -1 = none
+    double timecodeFps;             // Framerate of the timecode
+};
+
+constexpr size_t SLOT_HEADER_SIZE = 64;
+static_assert(sizeof(SlotHeader) <= SLOT_HEADER_SIZE, "slot header grew");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring needs lock-free 64-bit atomics");
+
+inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Bytes one slot takes for a frame size
+ */
+inline size_t slotStrideFor(size_t frameSize) {
+    return alignUp(SLOT_HEADER_SIZE + frameSize, RING_ALIGNMENT);
+}
+
+/**
+ * Total memfd size
+ */
+inline size_t ringSize(uint32_t slotCount, size_t frameSize) {
+    return alignUp(sizeof(RingHeader), RING_ALIGNMENT) + slotCount * slotStrideFor(frameSize);
+}
+
+inline SlotHeader* slotAt(uint8_t* base, const RingHeader* header, uint32_t index) {
+    return reinterpret_cast<SlotHeader*>(base + header->firstSlotOffset + index * header->slotStride);
+}
+
+inline uint8_t* slotData(uint8_t* base, const RingHeader* header, uint32_t index) {
+    return reinterpret_cast<uint8_t*>(slotAt(base, header, index)) + SLOT_HEADER_SIZE;
+}
+
+} // namespace shm
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SHAREDFRAMERING_H
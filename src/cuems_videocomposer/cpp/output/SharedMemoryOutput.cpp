@@ -0,0 +1,387 @@
+/**
+ * SharedMemoryOutput.cpp - Shared-memory frame ring for local readers
+ */
+
+#include "SharedMemoryOutput.h"
+#include "../utils/Logger.h"
+
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#if __has_include(<linux/udmabuf.h>)
+#include <linux/udmabuf.h>
+#else
+// Older kernel headers: the ABI from linux/udmabuf.h
+#define UDMABUF_FLAGS_CLOEXEC 0x01
+struct udmabuf_create {
+    uint32_t memfd;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t size;
+};
+#define UDMABUF_CREATE _IOW('u', 0x42, struct udmabuf_create)
+#endif
+
+namespace videocomposer {
+
+SharedMemoryOutput::SharedMemoryOutput(bool exportDmabuf, uint32_t slotCount)
+    : exportDmabuf_(exportDmabuf)
+    , slotCount_(slotCount > 0 ? slotCount : DEFAULT_SLOTS)
+{
+}
+
+SharedMemoryOutput::~SharedMemoryOutput() {
+    close();
+}
+
+uint32_t SharedMemoryOutput::ringFormat(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGBA32: return shm::RING_FORMAT_RGBA;
+        case PixelFormat::BGRA32: return shm::RING_FORMAT_BGRA;
+        case PixelFormat::UYVY422: return shm::RING_FORMAT_UYVY;
+        case PixelFormat::NV12: return shm::RING_FORMAT_NV12;
+        case PixelFormat::YUV420P: return shm::RING_FORMAT_I420;
+        default: return 0;
+    }
+}
+
+bool SharedMemoryOutput::open(const std::string& destination, const OutputSinkConfig& config) {
+    close();
+
+    if (ringFormat(config.format) == 0) {
+        LOG_ERROR << "SharedMemoryOutput: Unsupported pixel format";
+        return false;
+    }
+
+    // Same rounding as the capture conversion, so frames arrive at this size
+    format_ = config.format;
+    width_ = config.width;
+    height_ = config.height;
+    if (format_ == PixelFormat::UYVY422) {
+        width_ &= ~1;
+    } else if (format_ == PixelFormat::NV12 || format_ == PixelFormat::YUV420P) {
+        width_ &= ~3;
+        height_ &= ~1;
+    }
+    if (width_ <= 0 || height_ <= 0) {
+        LOG_ERROR << "SharedMemoryOutput: Invalid size " << config.width << "x" << config.height;
+        return false;
+    }
+    frameSize_ = FrameData::frameSize(format_, width_, height_);
+    socketPath_ = destination;
+
+    if (!createRing() || !listen()) {
+        close();
+        return false;
+    }
+    if (exportDmabuf_) {
+        exportDmabufs();
+    }
+
+    LOG_INFO << "SharedMemoryOutput: " << getDescription();
+    return true;
+}
+
+bool SharedMemoryOutput::createRing() {
+    memFd_ = memfd_create("cuems-videocomposer-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memFd_ < 0) {
+        LOG_ERROR << "SharedMemoryOutput: memfd_create failed: " << strerror(errno);
+        return false;
+    }
+
+    ringSize_ = shm::ringSize(slotCount_, frameSize_);
+    if (ftruncate(memFd_, static_cast<off_t>(ringSize_)) != 0) {
+        LOG_ERROR << "SharedMemoryOutput: Cannot size the ring: " << strerror(errno);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR << "SharedMemoryOutput: mmap failed: " << strerror(errno);
+        return false;
+    }
+    ring_ = static_cast<uint8_t*>(mapping);
+
+    header_ = new (ring_) shm::RingHeader();
+    header_->magic = shm::RING_MAGIC;
+    header_->version = shm::RING_VERSION;
+    header_->slotCount = slotCount_;
+    header_->format = ringFormat(format_);
+    header_->width = static_cast<uint32_t>(width_);
+    header_->height = static_cast<uint32_t>(height_);
+    header_->slotStride = shm::slotStrideFor(frameSize_);
+    header_->firstSlotOffset = shm::alignUp(sizeof(shm::RingHeader), shm::RING_ALIGNMENT);
+    header_->frameSize = frameSize_;
+
+    uint32_t lumaSize = static_cast<uint32_t>(width_ * height_);
+    switch (format_) {
+        case PixelFormat::UYVY422:
+            header_->planeStrides[0] = static_cast<uint32_t>(width_ * 2);
+            break;
+        case PixelFormat::NV12:
+            header_->planeStrides[0] = static_cast<uint32_t>(width_);
+            header_->planeOffsets[1] = lumaSize;
+            header_->planeStrides[1] = static_cast<uint32_t>(width_);
+            break;
+        case PixelFormat::YUV420P:
+            header_->planeStrides[0] = static_cast<uint32_t>(width_);
+            header_->planeOffsets[1] = lumaSize;
+            header_->planeStrides[1] = static_cast<uint32_t>(width_ / 2);
+            header_->planeOffsets[2] = lumaSize + lumaSize / 4;
+            header_->planeStrides[2] = static_cast<uint32_t>(width_ / 2);
+            break;
+        default:
+            header_->planeStrides[0] = static_cast<uint32_t>(width_ * 4);
+            break;
+    }
+    header_->latest.store(0, std::memory_order_relaxed);
+    header_->published.store(0, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < slotCount_; ++i) {
+        shm::SlotHeader* slot = new (shm::slotAt(ring_, header_, i)) shm::SlotHeader();
+        slot->sequence.store(0, std::memory_order_relaxed);
+        slot->timecode = -1;
+    }
+    nextSequence_ = 0;
+
+    // Readers may map it but never resize it under us
+    if (fcntl(memFd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        LOG_WARNING << "SharedMemoryOutput: Cannot seal the ring: " << strerror(errno);
+    }
+    return true;
+}
+
+void SharedMemoryOutput::exportDmabufs() {
+    int device = ::open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (device < 0) {
+        LOG_WARNING << "SharedMemoryOutput: /dev/udmabuf not available (" << strerror(errno)
+                    << "), readers get the memfd only";
+        return;
+    }
+
+    for (uint32_t i = 0; i < slotCount_; ++i) {
+        udmabuf_create create{};
+        create.memfd = static_cast<uint32_t>(memFd_);
+        create.flags = UDMABUF_FLAGS_CLOEXEC;
+        create.offset = header_->firstSlotOffset + i * header_->slotStride;
+        create.size = header_->slotStride;
+        int fd = ioctl(device, UDMABUF_CREATE, &create);
+        if (fd < 0) {
+            LOG_WARNING << "SharedMemoryOutput: UDMABUF_CREATE failed (" << strerror(errno)
+                        << "), readers get the memfd only";
+            for (int exported : dmabufFds_) {
+                ::close(exported);
+            }
+            dmabufFds_.clear();
+            break;
+        }
+        dmabufFds_.push_back(fd);
+    }
+    ::close(device);
+}
+
+bool SharedMemoryOutput::listen() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath_.empty() || socketPath_.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR << "SharedMemoryOutput: Invalid socket path '" << socketPath_ << "'";
+        return false;
+    }
+    std::strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenSocket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenSocket_ < 0) {
+        LOG_ERROR << "SharedMemoryOutput: socket failed: " << strerror(errno);
+        return false;
+    }
+
+    // A stale socket from a previous run
+    unlink(socketPath_.c_str());
+    if (bind(listenSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenSocket_, 8) != 0) {
+        LOG_ERROR << "SharedMemoryOutput: Cannot listen on " << socketPath_ << ": " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void SharedMemoryOutput::close() {
+    {
+        std::lock_guard<std::mutex> lock(readersMutex_);
+        for (auto& reader : readers_) {
+            closeReader(reader);
+        }
+        readers_.clear();
+    }
+
+    if (listenSocket_ >= 0) {
+        ::close(listenSocket_);
+        listenSocket_ = -1;
+        unlink(socketPath_.c_str());
+    }
+    for (int fd : dmabufFds_) {
+        ::close(fd);
+    }
+    dmabufFds_.clear();
+    if (ring_) {
+        munmap(ring_, ringSize_);
+        ring_ = nullptr;
+        header_ = nullptr;
+    }
+    if (memFd_ >= 0) {
+        ::close(memFd_);
+        memFd_ = -1;
+    }
+    warnedGeometry_ = false;
+}
+
+void SharedMemoryOutput::closeReader(Reader& reader) {
+    if (reader.socket >= 0) {
+        ::close(reader.socket);
+        reader.socket = -1;
+    }
+    if (reader.eventFd >= 0) {
+        ::close(reader.eventFd);
+        reader.eventFd = -1;
+    }
+}
+
+void SharedMemoryOutput::acceptReaders() {
+    for (;;) {
+        int client = accept4(listenSocket_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0) {
+            return;   // EAGAIN: nobody waiting
+        }
+
+        Reader reader;
+        reader.socket = client;
+        reader.eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (reader.eventFd < 0) {
+            LOG_WARNING << "SharedMemoryOutput: eventfd failed: " << strerror(errno);
+            closeReader(reader);
+            continue;
+        }
+
+        // memfd, eventfd, then one dmabuf per slot
+        std::vector<int> fds;
+        fds.push_back(memFd_);
+        fds.push_back(reader.eventFd);
+        fds.insert(fds.end(), dmabufFds_.begin(), dmabufFds_.end());
+
+        uint32_t fdCount = static_cast<uint32_t>(fds.size());
+        iovec iov{};
+        iov.iov_base = &fdCount;
+        iov.iov_len = sizeof(fdCount);
+
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()), 0);
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+        if (sendmsg(client, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(fdCount))) {
+            LOG_WARNING << "SharedMemoryOutput: Cannot hand the ring to a reader: " << strerror(errno);
+            closeReader(reader);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(readersMutex_);
+        readers_.push_back(reader);
+        LOG_VERBOSE << "SharedMemoryOutput: Reader connected (" << readers_.size() << " total)";
+    }
+}
+
+void SharedMemoryOutput::signalReaders() {
+    std::lock_guard<std::mutex> lock(readersMutex_);
+
+    uint64_t one = 1;
+    for (auto it = readers_.begin(); it != readers_.end();) {
+        // Readers never send anything: a readable socket means it hung up
+        char byte;
+        ssize_t n = recv(it->socket, &byte, 1, MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeReader(*it);
+            it = readers_.erase(it);
+            LOG_VERBOSE << "SharedMemoryOutput: Reader disconnected (" << readers_.size() << " left)";
+            continue;
+        }
+        // Fails only when the counter would overflow, which a reader notices anyway
+        ssize_t written = write(it->eventFd, &one, sizeof(one));
+        (void)written;
+        ++it;
+    }
+}
+
+bool SharedMemoryOutput::writeFrame(const FrameData& frame) {
+    if (!ring_) {
+        return false;
+    }
+
+    acceptReaders();
+
+    if (frame.format != format_ || frame.width != width_ || frame.height != height_ ||
+        frame.size < frameSize_) {
+        if (!warnedGeometry_) {
+            LOG_WARNING << "SharedMemoryOutput: Dropping " << frame.width << "x" << frame.height
+                        << " frames, the ring holds " << width_ << "x" << height_;
+            warnedGeometry_ = true;
+        }
+        return false;
+    }
+
+    uint64_t seq = nextSequence_++;
+    uint32_t index = static_cast<uint32_t>(seq % slotCount_);
+    shm::SlotHeader* slot = shm::slotAt(ring_, header_, index);
+
+    // Odd while writing; readers holding this slot see the change and retry
+    slot->sequence.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->frameNumber = frame.frameNumber;
+    slot->timestampUs = frame.timestamp;
+    slot->timecode = frame.timecode;
+    slot->timecodeFps = frame.timecodeFps;
+    std::memcpy(shm::slotData(ring_, header_, index), frame.data, frameSize_);
+
+    slot->sequence.store(2 * seq + 2, std::memory_order_release);
+    header_->latest.store(seq, std::memory_order_release);
+    header_->published.store(seq + 1, std::memory_order_release);
+
+    signalReaders();
+    return true;
+}
+
+CaptureFormat SharedMemoryOutput::getCaptureFormat() const {
+    CaptureFormat format;
+    format.format = format_;
+    format.width = width_;
+    format.height = height_;
+    return format;
+}
+
+size_t SharedMemoryOutput::getReaderCount() const {
+    std::lock_guard<std::mutex> lock(readersMutex_);
+    return readers_.size();
+}
+
+std::string SharedMemoryOutput::getDescription() const {
+    return "Shared memory ring " + socketPath_ + " (" + std::to_string(width_) + "x" +
+           std::to_string(height_) + ", " + std::to_string(slotCount_) + " slots" +
+           (dmabufFds_.empty() ? "" : ", dmabuf") + ")";
+}
+
+} // namespace videocomposer
@@ -0,0 +1,120 @@
+/**
+ * SharedMemoryOutput.h - Shared-memory frame ring for local readers
+ *
+ * Publishes the program output to processes on the same machine (operator
+ * preview, calibration tools) through a memfd-backed ring of frame slots,
+ * without encoding or a network stack. See SharedFrameRing.h for the
+ * layout and the reader protocol.
+ */
+
+#ifndef VIDEOCOMPOSER_SHAREDMEMORYOUTPUT_H
+#define VIDEOCOMPOSER_SHAREDMEMORYOUTPUT_H
+
+#include "OutputSink.h"
+#include "SharedFrameRing.h"
+#include <mutex>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * SharedMemoryOutput - OutputSink writing into a shared frame ring
+ *
+ * The destination is the path of the Unix socket readers connect to.
+ * Each captured frame is copied once into the next slot (already in its
+ * final format and size, see getCaptureFormat()); readers map the ring
+ * and use the pixels in place. Readers that fall behind by more than
+ * the slot count skip frames; the writer never waits for them.
+ *
+ * With exportDmabuf, every slot is also handed out as a dmabuf
+ * (/dev/udmabuf over the memfd), so GPU readers import it without a
+ * copy. The dmabuf covers the whole slot; pixels start at SLOT_HEADER_SIZE.
+ */
+class SharedMemoryOutput : public OutputSink {
+public:
+    static constexpr uint32_t DEFAULT_SLOTS = 4;
+
+    /**
+     * @param exportDmabuf Also export each slot as a dmabuf
+     * @param slotCount Frames in the ring
+     */
+    explicit SharedMemoryOutput(bool exportDmabuf = false, uint32_t slotCount = DEFAULT_SLOTS);
+    ~SharedMemoryOutput() override;
+
+    // Disable copy
+    SharedMemoryOutput(const SharedMemoryOutput&) = delete;
+    SharedMemoryOutput& operator=(const SharedMemoryOutput&) = delete;
+
+    // ===== OutputSink =====
+
+    /**
+     * @param destination Unix socket path (replaced if it exists)
+     * @param config width/height and format (RGBA32, BGRA32, UYVY422, NV12
+     *        or YUV420P); the size is rounded down to what the format packs
+     */
+    bool open(const std::string& destination, const OutputSinkConfig& config) override;
+    void close() override;
+    bool isReady() const override { return ring_ != nullptr; }
+
+    bool writeFrame(const FrameData& frame) override;
+
+    CaptureFormat getCaptureFormat() const override;
+
+    Type getType() const override { return Type::SHARED_MEMORY; }
+    std::string getId() const override { return "shm:" + socketPath_; }
+    std::string getDescription() const override;
+
+    // ===== Status =====
+
+    /**
+     * Readers connected right now
+     */
+    size_t getReaderCount() const;
+
+    /**
+     * Whether slots are exported as dmabufs (false if the kernel lacks udmabuf)
+     */
+    bool hasDmabuf() const { return !dmabufFds_.empty(); }
+
+    /**
+     * Ring format for a pixel format (0 = not supported)
+     */
+    static uint32_t ringFormat(PixelFormat format);
+
+private:
+    struct Reader {
+        int socket = -1;
+        int eventFd = -1;
+    };
+
+    bool createRing();
+    void exportDmabufs();
+    bool listen();
+    void acceptReaders();
+    void signalReaders();
+    static void closeReader(Reader& reader);
+
+    bool exportDmabuf_;
+    uint32_t slotCount_;
+    std::string socketPath_;
+    PixelFormat format_ = PixelFormat::RGBA32;
+    int width_ = 0;
+    int height_ = 0;
+    size_t frameSize_ = 0;
+
+    int memFd_ = -1;
+    uint8_t* ring_ = nullptr;
+    size_t ringSize_ = 0;
+    shm::RingHeader* header_ = nullptr;
+    uint64_t nextSequence_ = 0;
+    std::vector<int> dmabufFds_;
+
+    int listenSocket_ = -1;
+    std::vector<Reader> readers_;
+    mutable std::mutex readersMutex_;
+    bool warnedGeometry_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SHAREDMEMORYOUTPUT_H
@@ -0,0 +1,557 @@
+/**
+ * VaapiEncoderOutput.cpp - Zero-copy hardware encoder output sink
+ */
+
+#ifdef HAVE_VAAPI_INTEROP
+
+#include "VaapiEncoderOutput.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/SMPTEUtils.h"
+
+#include <va/va_drmcommon.h>
+#include <drm_fourcc.h>
+#include <unistd.h>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/hwcontext_vaapi.h>
+#include <libavutil/opt.h>
+}
+
+// EGL extension constants for DMA-BUF import
+#ifndef EGL_LINUX_DMA_BUF_EXT
+#define EGL_LINUX_DMA_BUF_EXT             0x3270
+#endif
+#ifndef EGL_LINUX_DRM_FOURCC_EXT
+#define EGL_LINUX_DRM_FOURCC_EXT          0x3271
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_FD_EXT
+#define EGL_DMA_BUF_PLANE0_FD_EXT         0x3272
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_OFFSET_EXT
+#define EGL_DMA_BUF_PLANE0_OFFSET_EXT     0x3273
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_PITCH_EXT
+#define EGL_DMA_BUF_PLANE0_PITCH_EXT      0x3274
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT
+#define EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT 0x3443
+#endif
+#ifndef EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT
+#define EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT 0x3444
+#endif
+
+namespace videocomposer {
+
+namespace {
+
+// Surfaces in the pool: the queue, the encoder's references and the one
+// being rendered
+constexpr int SURFACE_POOL_SIZE = 16;
+
+std::string avError(int err) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    return errbuf;
+}
+
+bool startsWith(const std::string& s, const char* prefix) {
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer
+const char* NV12_VERTEX_SHADER = R"(
+#version 330 core
+
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// Y plane (R8, full size) or interleaved CbCr plane (GR88, half size);
+// the planes are top row first, the canvas bottom row first. BT.709,
+// limited range
+const char* NV12_FRAGMENT_SHADER = R"(
+#version 330 core
+
+uniform sampler2D uSourceTex;
+uniform int uPlane;              // 0 = Y, 1 = CbCr
+uniform vec2 uPlaneSize;         // Target plane size in texels
+
+out vec4 fragColor;
+
+vec3 sampleAt(vec2 uv) {
+    return texture(uSourceTex, vec2(uv.x, 1.0 - uv.y)).rgb;
+}
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / uPlaneSize;
+    const vec3 coeffs = vec3(0.2126, 0.7152, 0.0722);
+    if (uPlane == 0) {
+        float y = dot(sampleAt(uv), coeffs);
+        fragColor = vec4((16.0 + 219.0 * y) / 255.0, 0.0, 0.0, 1.0);
+    } else {
+        // Average of the 2x2 luma pixels the chroma sample covers
+        vec2 d = 0.25 / uPlaneSize;
+        vec3 rgb = 0.25 * (sampleAt(uv + vec2(-d.x, -d.y)) + sampleAt(uv + vec2(d.x, -d.y)) +
+                           sampleAt(uv + vec2(-d.x, d.y)) + sampleAt(uv + vec2(d.x, d.y)));
+        float y = dot(rgb, coeffs);
+        vec2 cbcr = (128.0 + 224.0 * vec2((rgb.b - y) / 1.8556, (rgb.r - y) / 1.5748)) / 255.0;
+        fragColor = vec4(cbcr, 0.0, 1.0);
+    }
+}
+)";
+
+} // namespace
+
+VaapiEncoderOutput::VaapiEncoderOutput(DisplayBackend* display)
+    : display_(display)
+{
+}
+
+VaapiEncoderOutput::~VaapiEncoderOutput() {
+    close();
+}
+
+bool VaapiEncoderOutput::open(const std::string& destination, const OutputSinkConfig& config) {
+    close();
+
+    if (!display_ || !display_->hasVaapiSupport()) {
+        LOG_ERROR << "VaapiEncoderOutput: Display backend has no VAAPI support";
+        return false;
+    }
+    vaDisplay_ = display_->getVADisplay();
+    eglDisplay_ = display_->getEGLDisplay();
+    eglCreateImageKHR_ = display_->getEglCreateImageKHR();
+    eglDestroyImageKHR_ = display_->getEglDestroyImageKHR();
+    glEGLImageTargetTexture2DOES_ = display_->getGlEGLImageTargetTexture2DOES();
+    if (!vaDisplay_ || eglDisplay_ == EGL_NO_DISPLAY || !eglCreateImageKHR_ ||
+        !eglDestroyImageKHR_ || !glEGLImageTargetTexture2DOES_) {
+        LOG_ERROR << "VaapiEncoderOutput: VA display or EGL dmabuf import not available";
+        return false;
+    }
+
+    destination_ = destination;
+    type_ = destination.find("://") != std::string::npos ? Type::STREAMING : Type::FILE;
+    // Even sizes for 4:2:0
+    width_ = config.width & ~1;
+    height_ = config.height & ~1;
+    if (width_ <= 0 || height_ <= 0) {
+        LOG_ERROR << "VaapiEncoderOutput: Invalid size " << config.width << "x" << config.height;
+        return false;
+    }
+
+    if (!openEncoder(config) || !openMuxer(config) || !createShader()) {
+        close();
+        return false;
+    }
+
+    stopping_ = false;
+    encoderThread_ = std::thread(&VaapiEncoderOutput::runEncoder, this);
+    ready_ = true;
+    LOG_INFO << "VaapiEncoderOutput: " << getDescription();
+    return true;
+}
+
+bool VaapiEncoderOutput::openEncoder(const OutputSinkConfig& config) {
+    codecName_ = config.codec == "hevc" || config.codec == "h265" ? "hevc_vaapi" : "h264_vaapi";
+    const AVCodec* codec = avcodec_find_encoder_by_name(codecName_.c_str());
+    if (!codec) {
+        LOG_ERROR << "VaapiEncoderOutput: FFmpeg has no " << codecName_ << " encoder";
+        return false;
+    }
+
+    // Share the decoder's VA display instead of opening the device again
+    deviceRef_ = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_VAAPI);
+    if (!deviceRef_) {
+        return false;
+    }
+    auto* device = reinterpret_cast<AVHWDeviceContext*>(deviceRef_->data);
+    reinterpret_cast<AVVAAPIDeviceContext*>(device->hwctx)->display = vaDisplay_;
+    int ret = av_hwdevice_ctx_init(deviceRef_);
+    if (ret < 0) {
+        LOG_ERROR << "VaapiEncoderOutput: Failed to init VAAPI device: " << avError(ret);
+        return false;
+    }
+
+    framesRef_ = av_hwframe_ctx_alloc(deviceRef_);
+    if (!framesRef_) {
+        return false;
+    }
+    auto* frames = reinterpret_cast<AVHWFramesContext*>(framesRef_->data);
+    frames->format = AV_PIX_FMT_VAAPI;
+    frames->sw_format = AV_PIX_FMT_NV12;
+    frames->width = width_;
+    frames->height = height_;
+    frames->initial_pool_size = SURFACE_POOL_SIZE;
+    ret = av_hwframe_ctx_init(framesRef_);
+    if (ret < 0) {
+        LOG_ERROR << "VaapiEncoderOutput: Failed to create " << width_ << "x" << height_
+                  << " surface pool: " << avError(ret);
+        return false;
+    }
+
+    int64_t fpsNum = 0, fpsDen = 1;
+    SMPTEUtils::framerateToRational(config.frameRate > 0.0 ? config.frameRate : 25.0, fpsNum, fpsDen);
+
+    codecCtx_ = avcodec_alloc_context3(codec);
+    if (!codecCtx_) {
+        return false;
+    }
+    codecCtx_->width = width_;
+    codecCtx_->height = height_;
+    codecCtx_->pix_fmt = AV_PIX_FMT_VAAPI;
+    codecCtx_->time_base = AVRational{static_cast<int>(fpsDen), static_cast<int>(fpsNum)};
+    codecCtx_->framerate = AVRational{static_cast<int>(fpsNum), static_cast<int>(fpsDen)};
+    codecCtx_->gop_size = static_cast<int>((fpsNum + fpsDen - 1) / fpsDen);   // One second
+    codecCtx_->max_b_frames = 0;                                              // Low latency
+    codecCtx_->bit_rate = config.bitrate > 0 ? config.bitrate
+                                             : static_cast<int64_t>(width_) * height_ * 6;
+    codecCtx_->color_primaries = AVCOL_PRI_BT709;
+    codecCtx_->color_trc = AVCOL_TRC_BT709;
+    codecCtx_->colorspace = AVCOL_SPC_BT709;
+    codecCtx_->color_range = AVCOL_RANGE_MPEG;
+    codecCtx_->hw_frames_ctx = av_buffer_ref(framesRef_);
+
+    packet_ = av_packet_alloc();
+    return packet_ != nullptr;
+}
+
+bool VaapiEncoderOutput::openMuxer(const OutputSinkConfig& config) {
+    const char* container = nullptr;
+    if (!config.container.empty()) {
+        container = config.container.c_str();
+    } else if (startsWith(destination_, "srt://") || startsWith(destination_, "udp://")) {
+        container = "mpegts";
+    }
+    int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, container, destination_.c_str());
+    if (ret < 0 || !formatCtx_) {
+        LOG_ERROR << "VaapiEncoderOutput: No container for " << destination_ << ": " << avError(ret);
+        return false;
+    }
+    if (formatCtx_->oformat->flags & AVFMT_GLOBALHEADER) {
+        codecCtx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    ret = avcodec_open2(codecCtx_, codecCtx_->codec, nullptr);
+    if (ret < 0) {
+        LOG_ERROR << "VaapiEncoderOutput: Failed to open " << codecName_ << ": " << avError(ret);
+        return false;
+    }
+
+    stream_ = avformat_new_stream(formatCtx_, nullptr);
+    if (!stream_) {
+        return false;
+    }
+    stream_->time_base = codecCtx_->time_base;
+    avcodec_parameters_from_context(stream_->codecpar, codecCtx_);
+
+    if (!(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&formatCtx_->pb, destination_.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            LOG_ERROR << "VaapiEncoderOutput: Failed to open " << destination_ << ": " << avError(ret);
+            return false;
+        }
+    }
+    ret = avformat_write_header(formatCtx_, nullptr);
+    if (ret < 0) {
+        LOG_ERROR << "VaapiEncoderOutput: Failed to write header: " << avError(ret);
+        return false;
+    }
+    nextPts_ = 0;
+    return true;
+}
+
+bool VaapiEncoderOutput::createShader() {
+    shader_ = std::make_unique<ShaderProgram>();
+    if (!shader_->createFromSource(NV12_VERTEX_SHADER, NV12_FRAGMENT_SHADER)) {
+        LOG_ERROR << "VaapiEncoderOutput: Failed to compile NV12 shader";
+        return false;
+    }
+    glGenVertexArrays(1, &vao_);
+    return true;
+}
+
+bool VaapiEncoderOutput::writeTexture(GLuint texture, int width, int height, int64_t timestamp) {
+    (void)width; (void)height; (void)timestamp;
+    if (!ready_) {
+        return false;
+    }
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) {
+        return false;
+    }
+    // Pool exhausted: the encoder is behind, drop this frame
+    if (av_hwframe_get_buffer(framesRef_, frame, 0) < 0) {
+        av_frame_free(&frame);
+        return false;
+    }
+    VASurfaceID surface = static_cast<VASurfaceID>(reinterpret_cast<uintptr_t>(frame->data[3]));
+    SurfaceTargets* targets = targetsFor(surface);
+    if (!targets) {
+        av_frame_free(&frame);
+        return false;
+    }
+
+    GLint previousFbo = 0;
+    GLint viewport[4] = {0, 0, 0, 0};
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+
+    shader_->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    shader_->setUniform("uSourceTex", 0);
+    glBindVertexArray(vao_);
+    for (int plane = 0; plane < 2; ++plane) {
+        int planeWidth = plane == 0 ? width_ : width_ / 2;
+        int planeHeight = plane == 0 ? height_ : height_ / 2;
+        glBindFramebuffer(GL_FRAMEBUFFER, targets->fbos[plane]);
+        glViewport(0, 0, planeWidth, planeHeight);
+        shader_->setUniform("uPlane", plane);
+        shader_->setUniform("uPlaneSize", static_cast<float>(planeWidth), static_cast<float>(planeHeight));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    shader_->unbind();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+
+    // Submit now; the encoder's read waits on the dmabuf's implicit fence
+    glFlush();
+
+    frame->pts = nextPts_++;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (queue_.size() >= getQueueDepth()) {
+            av_frame_free(&queue_.front());
+            queue_.pop_front();
+            queueDropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue_.push_back(frame);
+    }
+    queueCond_.notify_one();
+    return true;
+}
+
+VaapiEncoderOutput::SurfaceTargets* VaapiEncoderOutput::targetsFor(VASurfaceID surface) {
+    auto it = targets_.find(surface);
+    if (it != targets_.end()) {
+        return &it->second;
+    }
+    SurfaceTargets targets;
+    if (!importSurface(surface, targets)) {
+        destroyTargets(targets);
+        return nullptr;
+    }
+    return &targets_.emplace(surface, targets).first->second;
+}
+
+bool VaapiEncoderOutput::importSurface(VASurfaceID surface, SurfaceTargets& targets) {
+    VADRMPRIMESurfaceDescriptor desc;
+    memset(&desc, 0, sizeof(desc));
+    VAStatus status = vaExportSurfaceHandle(vaDisplay_, surface,
+                                            VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                                            VA_EXPORT_SURFACE_WRITE_ONLY | VA_EXPORT_SURFACE_SEPARATE_LAYERS,
+                                            &desc);
+    if (status != VA_STATUS_SUCCESS) {
+        LOG_ERROR << "VaapiEncoderOutput: vaExportSurfaceHandle failed: " << status;
+        return false;
+    }
+
+    bool ok = desc.num_layers == 2;
+    if (!ok) {
+        LOG_ERROR << "VaapiEncoderOutput: Unexpected surface layout (" << desc.num_layers << " layers)";
+    }
+    for (int plane = 0; ok && plane < 2; ++plane) {
+        const auto& layer = desc.layers[plane];
+        const auto& object = desc.objects[layer.object_index[0]];
+        int planeWidth = plane == 0 ? width_ : width_ / 2;
+        int planeHeight = plane == 0 ? height_ : height_ / 2;
+
+        EGLint attribs[] = {
+            EGL_WIDTH, planeWidth,
+            EGL_HEIGHT, planeHeight,
+            EGL_LINUX_DRM_FOURCC_EXT, static_cast<EGLint>(plane == 0 ? DRM_FORMAT_R8 : DRM_FORMAT_GR88),
+            EGL_DMA_BUF_PLANE0_FD_EXT, object.fd,
+            EGL_DMA_BUF_PLANE0_OFFSET_EXT, static_cast<EGLint>(layer.offset[0]),
+            EGL_DMA_BUF_PLANE0_PITCH_EXT, static_cast<EGLint>(layer.pitch[0]),
+            EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, static_cast<EGLint>(object.drm_format_modifier & 0xffffffff),
+            EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT, static_cast<EGLint>(object.drm_format_modifier >> 32),
+            EGL_NONE
+        };
+        // Linear or unknown layout: leave the modifier to the driver
+        bool hasModifier = object.drm_format_modifier != DRM_FORMAT_MOD_INVALID &&
+                           object.drm_format_modifier != DRM_FORMAT_MOD_LINEAR;
+        if (!hasModifier) {
+            attribs[12] = EGL_NONE;
+        }
+        targets.images[plane] = eglCreateImageKHR_(eglDisplay_, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+                                                   nullptr, attribs);
+        if (targets.images[plane] == EGL_NO_IMAGE_KHR) {
+            LOG_ERROR << "VaapiEncoderOutput: Failed to import " << (plane == 0 ? "Y" : "UV")
+                      << " plane of surface " << surface;
+            ok = false;
+            break;
+        }
+        targets.fds[plane] = dup(object.fd);
+
+        glGenTextures(1, &targets.textures[plane]);
+        glBindTexture(GL_TEXTURE_2D, targets.textures[plane]);
+        glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, targets.images[plane]);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        GLint previousFbo = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+        glGenFramebuffers(1, &targets.fbos[plane]);
+        glBindFramebuffer(GL_FRAMEBUFFER, targets.fbos[plane]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               targets.textures[plane], 0);
+        GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFbo);
+        if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+            LOG_ERROR << "VaapiEncoderOutput: Surface plane is not renderable, status=" << fboStatus;
+            ok = false;
+        }
+    }
+
+    for (uint32_t i = 0; i < desc.num_objects; ++i) {
+        ::close(desc.objects[i].fd);
+    }
+    return ok;
+}
+
+void VaapiEncoderOutput::destroyTargets(SurfaceTargets& targets) {
+    for (int plane = 0; plane < 2; ++plane) {
+        if (targets.fbos[plane] != 0) {
+            glDeleteFramebuffers(1, &targets.fbos[plane]);
+            targets.fbos[plane] = 0;
+        }
+        if (targets.textures[plane] != 0) {
+            glDeleteTextures(1, &targets.textures[plane]);
+            targets.textures[plane] = 0;
+        }
+        if (targets.images[plane] != EGL_NO_IMAGE_KHR) {
+            eglDestroyImageKHR_(eglDisplay_, targets.images[plane]);
+            targets.images[plane] = EGL_NO_IMAGE_KHR;
+        }
+        if (targets.fds[plane] >= 0) {
+            ::close(targets.fds[plane]);
+            targets.fds[plane] = -1;
+        }
+    }
+}
+
+void VaapiEncoderOutput::runEncoder() {
+    ThreadRoles::instance().apply(ThreadRole::OUTPUT);
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    while (true) {
+        queueCond_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;  // Stopping, and everything queued was encoded
+        }
+        AVFrame* frame = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+
+        encode(frame);
+        av_frame_free(&frame);
+
+        lock.lock();
+    }
+    lock.unlock();
+    encode(nullptr);
+}
+
+bool VaapiEncoderOutput::encode(AVFrame* frame) {
+    int ret = avcodec_send_frame(codecCtx_, frame);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        LOG_WARNING << "VaapiEncoderOutput: Encode failed: " << avError(ret);
+        return false;
+    }
+    while ((ret = avcodec_receive_packet(codecCtx_, packet_)) >= 0) {
+        av_packet_rescale_ts(packet_, codecCtx_->time_base, stream_->time_base);
+        packet_->stream_index = stream_->index;
+        ret = av_interleaved_write_frame(formatCtx_, packet_);
+        if (ret < 0) {
+            LOG_WARNING << "VaapiEncoderOutput: Failed to write packet: " << avError(ret);
+        }
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+}
+
+void VaapiEncoderOutput::close() {
+    bool wasReady = ready_;
+    ready_ = false;
+
+    if (encoderThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            stopping_ = true;
+        }
+        queueCond_.notify_one();
+        encoderThread_.join();
+    }
+    if (wasReady && formatCtx_) {
+        av_write_trailer(formatCtx_);
+        LOG_INFO << "VaapiEncoderOutput: Closed " << destination_ << " after "
+                 << getFramesWritten() << " frames";
+    }
+
+    releaseGL();
+    releaseEncoder();
+}
+
+void VaapiEncoderOutput::releaseGL() {
+    for (auto& entry : targets_) {
+        destroyTargets(entry.second);
+    }
+    targets_.clear();
+    if (vao_ != 0) {
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    shader_.reset();
+}
+
+void VaapiEncoderOutput::releaseEncoder() {
+    for (AVFrame* frame : queue_) {
+        av_frame_free(&frame);
+    }
+    queue_.clear();
+    if (formatCtx_) {
+        if (!(formatCtx_->oformat->flags & AVFMT_NOFILE) && formatCtx_->pb) {
+            avio_closep(&formatCtx_->pb);
+        }
+        avformat_free_context(formatCtx_);
+        formatCtx_ = nullptr;
+        stream_ = nullptr;
+    }
+    av_packet_free(&packet_);
+    avcodec_free_context(&codecCtx_);
+    av_buffer_unref(&framesRef_);
+    av_buffer_unref(&deviceRef_);
+}
+
+std::string VaapiEncoderOutput::getDescription() const {
+    return codecName_ + " " + std::to_string(width_) + "x" + std::to_string(height_) +
+           " -> " + destination_;
+}
+
+int64_t VaapiEncoderOutput::getFramesDropped() const {
+    return OutputSink::getFramesDropped() + queueDropped_.load(std::memory_order_relaxed);
+}
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
@@ -0,0 +1,149 @@
+/**
+ * VaapiEncoderOutput.h - Zero-copy hardware encoder output sink
+ *
+ * Records or streams the program output (file, SRT, UDP...) with the GPU's
+ * VAAPI H.264/HEVC encoder. The canvas texture is converted to NV12 by a
+ * shader that renders straight into the encoder's VA surfaces, imported as
+ * dmabuf render targets, so no pixels are read back to the CPU.
+ */
+
+#ifndef VIDEOCOMPOSER_VAAPIENCODEROUTPUT_H
+#define VIDEOCOMPOSER_VAAPIENCODEROUTPUT_H
+
+#ifdef HAVE_VAAPI_INTEROP
+
+#include "OutputSink.h"
+#include "../display/DisplayBackend.h"   // EGL image function pointer types
+#include "../display/ShaderProgram.h"
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <va/va.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/hwcontext.h>
+}
+
+namespace videocomposer {
+
+/**
+ * VaapiEncoderOutput - GPU sink encoding the canvas with VAAPI
+ *
+ * Pipeline (render thread):
+ *   canvas texture -> NV12 shader -> VA surface (dmabuf EGL images)
+ * then (encoder thread):
+ *   VA surface -> h264_vaapi / hevc_vaapi -> muxer -> file or network
+ *
+ * Surfaces come from FFmpeg's VAAPI frame pool; each is exported and
+ * imported once and its plane render targets are cached by VASurfaceID.
+ * The GL rendering is ordered before the encode by the dmabuf's implicit
+ * fence, so the render thread only flushes.
+ *
+ * OutputSinkConfig: width/height (0 = canvas), frameRate, bitrate,
+ * codec ("h264" or "hevc"), container (default from the destination:
+ * mpegts for srt:// and udp://, else from the file extension).
+ *
+ * open() and close() must be called with the canvas GL context current.
+ */
+class VaapiEncoderOutput : public OutputSink {
+public:
+    /**
+     * @param display Display backend providing the VA and EGL displays (not owned)
+     */
+    explicit VaapiEncoderOutput(DisplayBackend* display);
+    ~VaapiEncoderOutput() override;
+
+    // Disable copy
+    VaapiEncoderOutput(const VaapiEncoderOutput&) = delete;
+    VaapiEncoderOutput& operator=(const VaapiEncoderOutput&) = delete;
+
+    // ===== OutputSink =====
+
+    bool open(const std::string& destination, const OutputSinkConfig& config) override;
+    void close() override;
+    bool isReady() const override { return ready_; }
+
+    bool writeFrame(const FrameData& frame) override { (void)frame; return false; }
+    bool isGpuSink() const override { return true; }
+    bool writeTexture(GLuint texture, int width, int height, int64_t timestamp) override;
+
+    // Only the encoder thread may fall behind; the render thread never waits
+    size_t getQueueDepth() const override { return 4; }
+
+    Type getType() const override { return type_; }
+    std::string getId() const override { return "vaapi:" + destination_; }
+    std::string getDescription() const override;
+
+    int64_t getFramesDropped() const override;
+
+private:
+    // Y and UV planes of one VA surface as GL render targets
+    struct SurfaceTargets {
+        EGLImageKHR images[2] = {EGL_NO_IMAGE_KHR, EGL_NO_IMAGE_KHR};
+        GLuint textures[2] = {0, 0};
+        GLuint fbos[2] = {0, 0};
+        int fds[2] = {-1, -1};
+    };
+
+    bool openEncoder(const OutputSinkConfig& config);
+    bool openMuxer(const OutputSinkConfig& config);
+    bool createShader();
+    SurfaceTargets* targetsFor(VASurfaceID surface);
+    bool importSurface(VASurfaceID surface, SurfaceTargets& targets);
+    void destroyTargets(SurfaceTargets& targets);
+    void releaseGL();
+    void releaseEncoder();
+
+    void runEncoder();
+    bool encode(AVFrame* frame);   // nullptr drains the encoder
+
+    DisplayBackend* display_;
+    VADisplay vaDisplay_ = nullptr;
+    EGLDisplay eglDisplay_ = EGL_NO_DISPLAY;
+    PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR_ = nullptr;
+    PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR_ = nullptr;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES_ = nullptr;
+
+    std::string destination_;
+    std::string codecName_;
+    Type type_ = Type::FILE;
+    int width_ = 0;
+    int height_ = 0;
+    bool ready_ = false;
+
+    // FFmpeg encoder and muxer
+    AVBufferRef* deviceRef_ = nullptr;
+    AVBufferRef* framesRef_ = nullptr;
+    AVCodecContext* codecCtx_ = nullptr;
+    AVFormatContext* formatCtx_ = nullptr;
+    AVStream* stream_ = nullptr;
+    AVPacket* packet_ = nullptr;
+    int64_t nextPts_ = 0;
+
+    // Render thread: NV12 conversion into the surfaces
+    std::unique_ptr<ShaderProgram> shader_;
+    GLuint vao_ = 0;
+    std::unordered_map<VASurfaceID, SurfaceTargets> targets_;
+
+    // Encoder thread, fed with rendered surfaces (newest kept when full)
+    std::thread encoderThread_;
+    std::mutex queueMutex_;
+    std::condition_variable queueCond_;
+    std::deque<AVFrame*> queue_;
+    bool stopping_ = false;
+    std::atomic<int64_t> queueDropped_{0};
+};
+
+} // namespace videocomposer
+
+#endif // HAVE_VAAPI_INTEROP
+
+#endif // VIDEOCOMPOSER_VAAPIENCODEROUTPUT_H
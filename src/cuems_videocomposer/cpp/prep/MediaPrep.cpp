@@ -0,0 +1,550 @@
+/**
+ * MediaPrep.cpp - Show media preparation tool (cuems-videocomposer-prep)
+ *
+ * Transcodes clips to HAP with settings for the machine that plays them:
+ * HapPrepPlanner picks the variant, the chunk count (one per HAP chunk
+ * thread, so decompression runs in parallel on the HapChunkPool) and
+ * whether Snappy is worth its decode time. Pass this machine's benchmark
+ * results (--benchmarks, the admission_costs file) to plan with measured
+ * decode costs instead of the built-in ones.
+ *
+ * Every written file is then checked the way the player will read it:
+ * the MOV sample table must map frame N to sample N (direct packet
+ * access for scrubbing and reverse play), every frame must carry the
+ * planned chunks, and the file is opened once through VideoFileInput
+ * with the frame index cache on, so whatever the player would index at
+ * cue load is in the cache already.
+ *
+ *   cuems-videocomposer-prep [options] FILE...
+ *
+ * One line per clip on stdout; exit status 1 if any clip failed.
+ */
+
+#include "hap/HapChunkPool.h"
+#include "hap/HapPrepPlanner.h"
+#include "hap/MovSampleTable.h"
+#include "input/VideoFileInput.h"
+#include "layer/LoadAdmission.h"
+#include "utils/Logger.h"
+#include "utils/SMPTEUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+#include <libavutil/error.h>
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+#ifdef ENABLE_HAP_DIRECT
+#include <hap.h>
+#endif
+}
+
+using namespace videocomposer;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> files;
+    std::string outputDir;          // Empty = next to each source
+    HapPrepPlanner::Format format = HapPrepPlanner::Format::AUTO;
+    bool highQuality = false;
+    std::string benchmarks;
+    int hapThreads = 0;             // 0 = HapChunkPool default
+    bool bptc = false;
+    double storageMBps = 0.0;
+    int layers = 1;
+    std::string indexCacheDir;
+    bool planOnly = false;
+    bool verifyOnly = false;
+    bool force = false;
+};
+
+std::string avError(int err) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    return errbuf;
+}
+
+// "dir/name.ext" -> "<outputDir or dir>/name.hap.mov"
+std::string outputPathFor(const std::string& source, const std::string& outputDir) {
+    size_t slash = source.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : source.substr(0, slash);
+    std::string name = slash == std::string::npos ? source : source.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        name.erase(dot);
+    }
+    return (outputDir.empty() ? dir : outputDir) + "/" + name + ".hap.mov";
+}
+
+/**
+ * Decodes a source clip's video frames to RGBA
+ */
+class SourceReader {
+public:
+    ~SourceReader() {
+        sws_freeContext(scaler_);
+        av_frame_free(&decoded_);
+        av_frame_free(&rgba_);
+        av_packet_free(&packet_);
+        avcodec_free_context(&codecCtx_);
+        avformat_close_input(&formatCtx_);
+    }
+
+    bool open(const std::string& path, std::string& error) {
+        int ret = avformat_open_input(&formatCtx_, path.c_str(), nullptr, nullptr);
+        if (ret < 0) {
+            error = avError(ret);
+            return false;
+        }
+        avformat_find_stream_info(formatCtx_, nullptr);
+        const AVCodec* codec = nullptr;
+        stream_ = av_find_best_stream(formatCtx_, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+        if (stream_ < 0 || !codec) {
+            error = "no video stream";
+            return false;
+        }
+        AVStream* stream = formatCtx_->streams[stream_];
+        codecCtx_ = avcodec_alloc_context3(codec);
+        if (!codecCtx_ || avcodec_parameters_to_context(codecCtx_, stream->codecpar) < 0) {
+            error = "out of memory";
+            return false;
+        }
+        codecCtx_->thread_count = 0;
+        ret = avcodec_open2(codecCtx_, codec, nullptr);
+        if (ret < 0) {
+            error = std::string("cannot open ") + codec->name + ": " + avError(ret);
+            return false;
+        }
+
+        AVRational rate = av_guess_frame_rate(formatCtx_, stream, nullptr);
+        framerate_ = rate.num > 0 && rate.den > 0 ? av_q2d(rate) : 25.0;
+        const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(codecCtx_->pix_fmt);
+        alpha_ = desc && (desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+
+        decoded_ = av_frame_alloc();
+        rgba_ = av_frame_alloc();
+        packet_ = av_packet_alloc();
+        if (!decoded_ || !rgba_ || !packet_) {
+            error = "out of memory";
+            return false;
+        }
+        rgba_->format = AV_PIX_FMT_RGBA;
+        rgba_->width = codecCtx_->width;
+        rgba_->height = codecCtx_->height;
+        if (av_frame_get_buffer(rgba_, 0) < 0) {
+            error = "out of memory";
+            return false;
+        }
+        return true;
+    }
+
+    int width() const { return codecCtx_->width; }
+    int height() const { return codecCtx_->height; }
+    double framerate() const { return framerate_; }
+    bool alpha() const { return alpha_; }
+
+    /** Next frame as RGBA; nullptr at the end (or on error, with error set) */
+    const AVFrame* next(std::string& error) {
+        for (;;) {
+            int ret = avcodec_receive_frame(codecCtx_, decoded_);
+            if (ret >= 0) {
+                return convert(error);
+            }
+            if (ret == AVERROR_EOF) {
+                return nullptr;
+            }
+            if (ret != AVERROR(EAGAIN)) {
+                error = "decode failed: " + avError(ret);
+                return nullptr;
+            }
+            if (draining_) {
+                return nullptr;
+            }
+            ret = av_read_frame(formatCtx_, packet_);
+            if (ret < 0) {
+                draining_ = true;
+                avcodec_send_packet(codecCtx_, nullptr);
+                continue;
+            }
+            if (packet_->stream_index == stream_) {
+                avcodec_send_packet(codecCtx_, packet_);
+            }
+            av_packet_unref(packet_);
+        }
+    }
+
+private:
+    const AVFrame* convert(std::string& error) {
+        scaler_ = sws_getCachedContext(scaler_, decoded_->width, decoded_->height,
+                                       static_cast<AVPixelFormat>(decoded_->format),
+                                       rgba_->width, rgba_->height, AV_PIX_FMT_RGBA,
+                                       SWS_BICUBIC, nullptr, nullptr, nullptr);
+        if (!scaler_ || av_frame_make_writable(rgba_) < 0) {
+            error = "cannot convert frames";
+            return nullptr;
+        }
+        sws_scale(scaler_, decoded_->data, decoded_->linesize, 0, decoded_->height, rgba_->data, rgba_->linesize);
+        av_frame_unref(decoded_);
+        return rgba_;
+    }
+
+    AVFormatContext* formatCtx_ = nullptr;
+    AVCodecContext* codecCtx_ = nullptr;
+    int stream_ = -1;
+    SwsContext* scaler_ = nullptr;
+    AVFrame* decoded_ = nullptr;
+    AVFrame* rgba_ = nullptr;
+    AVPacket* packet_ = nullptr;
+    double framerate_ = 25.0;
+    bool alpha_ = false;
+    bool draining_ = false;
+};
+
+/**
+ * Writes HAP frames into a MOV, one sample per frame at a constant rate
+ */
+class HapWriter {
+public:
+    ~HapWriter() {
+        if (formatCtx_) {
+            if (!(formatCtx_->oformat->flags & AVFMT_NOFILE) && formatCtx_->pb) {
+                avio_closep(&formatCtx_->pb);
+            }
+            avformat_free_context(formatCtx_);
+        }
+        av_packet_free(&packet_);
+        avcodec_free_context(&codecCtx_);
+    }
+
+    bool open(const HapPrepPlanner::Plan& plan, int width, int height, double framerate, const std::string& path,
+              std::string& error) {
+        const AVCodec* codec = avcodec_find_encoder_by_name("hap");
+        if (!codec) {
+            error = "FFmpeg has no HAP encoder";
+            return false;
+        }
+        int64_t fpsNum = 0, fpsDen = 1;
+        SMPTEUtils::framerateToRational(framerate, fpsNum, fpsDen);
+
+        int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, "mov", path.c_str());
+        codecCtx_ = avcodec_alloc_context3(codec);
+        if (ret < 0 || !formatCtx_ || !codecCtx_) {
+            error = "cannot create " + path;
+            return false;
+        }
+        codecCtx_->width = width;
+        codecCtx_->height = height;
+        codecCtx_->pix_fmt = AV_PIX_FMT_RGBA;
+        codecCtx_->time_base = AVRational{static_cast<int>(fpsDen), static_cast<int>(fpsNum)};
+        codecCtx_->framerate = AVRational{static_cast<int>(fpsNum), static_cast<int>(fpsDen)};
+        codecCtx_->thread_count = 0;   // Texture compression slices on all cores
+
+        AVDictionary* options = nullptr;
+        av_dict_set(&options, "format", HapPrepPlanner::formatName(plan.format), 0);
+        av_dict_set_int(&options, "chunks", plan.chunks, 0);
+        av_dict_set(&options, "compressor", plan.snappy ? "snappy" : "none", 0);
+        ret = avcodec_open2(codecCtx_, codec, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            error = std::string("cannot encode ") + HapPrepPlanner::formatName(plan.format) + ": " + avError(ret);
+            return false;
+        }
+
+        stream_ = avformat_new_stream(formatCtx_, nullptr);
+        packet_ = av_packet_alloc();
+        if (!stream_ || !packet_) {
+            error = "out of memory";
+            return false;
+        }
+        stream_->time_base = codecCtx_->time_base;
+        avcodec_parameters_from_context(stream_->codecpar, codecCtx_);
+        ret = avio_open(&formatCtx_->pb, path.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            error = path + ": " + avError(ret);
+            return false;
+        }
+        // Sample table ahead of the media: the player indexes it without seeking to the end
+        AVDictionary* muxOptions = nullptr;
+        av_dict_set(&muxOptions, "movflags", "+faststart", 0);
+        ret = avformat_write_header(formatCtx_, &muxOptions);
+        av_dict_free(&muxOptions);
+        if (ret < 0) {
+            error = "cannot write header: " + avError(ret);
+            return false;
+        }
+        return true;
+    }
+
+    bool write(AVFrame* frame, std::string& error) {
+        frame->pts = frames_++;
+        return encode(frame, error);
+    }
+
+    bool finish(std::string& error) {
+        if (!encode(nullptr, error)) {
+            return false;
+        }
+        int ret = av_write_trailer(formatCtx_);
+        if (ret < 0) {
+            error = "cannot write trailer: " + avError(ret);
+            return false;
+        }
+        return true;
+    }
+
+    int64_t frames() const { return frames_; }
+
+private:
+    bool encode(AVFrame* frame, std::string& error) {
+        int ret = avcodec_send_frame(codecCtx_, frame);
+        if (ret < 0) {
+            error = "encode failed: " + avError(ret);
+            return false;
+        }
+        while ((ret = avcodec_receive_packet(codecCtx_, packet_)) >= 0) {
+            av_packet_rescale_ts(packet_, codecCtx_->time_base, stream_->time_base);
+            packet_->stream_index = stream_->index;
+            ret = av_interleaved_write_frame(formatCtx_, packet_);
+            if (ret < 0) {
+                error = "write failed: " + avError(ret);
+                return false;
+            }
+        }
+        return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+    }
+
+    AVFormatContext* formatCtx_ = nullptr;
+    AVCodecContext* codecCtx_ = nullptr;
+    AVStream* stream_ = nullptr;
+    AVPacket* packet_ = nullptr;
+    int64_t frames_ = 0;
+};
+
+bool transcode(SourceReader& source, const HapPrepPlanner::Plan& plan, const std::string& path, int64_t& frames,
+               std::string& error) {
+    HapWriter writer;
+    if (!writer.open(plan, source.width(), source.height(), source.framerate(), path, error)) {
+        return false;
+    }
+    // The encoder takes a frame it may keep; SourceReader reuses its own
+    AVFrame* frame = av_frame_alloc();
+    bool ok = frame != nullptr;
+    while (ok) {
+        const AVFrame* rgba = source.next(error);
+        if (!rgba) {
+            ok = error.empty();
+            break;
+        }
+        ok = av_frame_ref(frame, rgba) >= 0 && writer.write(frame, error);
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+    ok = ok && writer.finish(error);
+    frames = writer.frames();
+    return ok;
+}
+
+/**
+ * Check a written file the way the player reads it
+ * @param frames Frames expected (0 = unknown)
+ */
+bool verify(const std::string& path, const HapPrepPlanner::Plan* plan, int64_t frames, const Options& options,
+            std::string& error) {
+    MovSampleTable table;
+    if (!table.open(path)) {
+        error = "no direct sample access (not a constant-rate HAP MOV)";
+        return false;
+    }
+    if (frames > 0 && table.getSampleCount() != frames) {
+        error = "has " + std::to_string(table.getSampleCount()) + " samples for " + std::to_string(frames) + " frames";
+        return false;
+    }
+#ifdef ENABLE_HAP_DIRECT
+    for (int64_t i = 0; plan && plan->snappy && i < table.getSampleCount(); ++i) {
+        size_t size = 0;
+        const uint8_t* packet = table.packet(i, size);
+        unsigned int textures = 0;
+        if (!packet || HapGetFrameTextureCount(packet, size, &textures) != HapResult_No_Error) {
+            error = "frame " + std::to_string(i) + " is not a HAP frame";
+            return false;
+        }
+        for (unsigned int t = 0; t < textures; ++t) {
+            int chunks = 0;
+            if (HapGetFrameTextureChunkCount(packet, size, t, &chunks) != HapResult_No_Error || chunks != plan->chunks) {
+                error = "frame " + std::to_string(i) + " has " + std::to_string(chunks) + " chunk(s), planned " +
+                        std::to_string(plan->chunks);
+                return false;
+            }
+        }
+    }
+#else
+    (void)plan;
+#endif
+
+    // Same open as a cue load: the index (if the player needs one) lands in the cache
+    VideoFileInput input;
+    input.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+    input.setIndexCache(true, options.indexCacheDir);
+    input.setFramePoolBudget(0);
+    if (!input.open(path)) {
+        error = "the player cannot open it";
+        return false;
+    }
+    input.close();
+    return true;
+}
+
+void printPlan(const std::string& file, const HapPrepPlanner::Plan& plan) {
+    std::cout << file << ": " << HapPrepPlanner::formatName(plan.format) << ", " << plan.chunks << " chunk(s), "
+              << (plan.snappy ? "snappy" : "uncompressed") << " (" << plan.reason << ")" << std::endl;
+}
+
+bool prepare(const std::string& file, const HapPrepPlanner::Machine& machine, const Options& options) {
+    if (options.verifyOnly) {
+        std::string error;
+        bool ok = verify(file, nullptr, 0, options, error);
+        std::cout << file << ": " << (ok ? "ok" : error) << std::endl;
+        return ok;
+    }
+
+    SourceReader source;
+    std::string error;
+    if (!source.open(file, error)) {
+        std::cout << file << ": " << error << std::endl;
+        return false;
+    }
+    HapPrepPlanner::Source media;
+    media.width = source.width();
+    media.height = source.height();
+    media.framerate = source.framerate();
+    media.alpha = source.alpha();
+    HapPrepPlanner::Plan plan = HapPrepPlanner::plan(machine, media, options.format, options.highQuality);
+    printPlan(file, plan);
+    if (options.planOnly) {
+        return true;
+    }
+
+    std::string output = outputPathFor(file, options.outputDir);
+    if (!options.force && access(output.c_str(), F_OK) == 0) {
+        std::cout << output << ": exists (--force to replace)" << std::endl;
+        return false;
+    }
+    int64_t frames = 0;
+    bool ok = transcode(source, plan, output, frames, error);
+    if (!ok && plan.format == HapPrepPlanner::Format::HAP_R) {
+        // Stock FFmpeg encodes no BPTC: plan again without it
+        HapPrepPlanner::Machine fallback = machine;
+        fallback.bptc = false;
+        plan = HapPrepPlanner::plan(fallback, media, options.format, options.highQuality);
+        std::cout << file << ": " << error << ", writing " << HapPrepPlanner::formatName(plan.format) << std::endl;
+        SourceReader again;
+        error.clear();
+        ok = again.open(file, error) && transcode(again, plan, output, frames, error);
+    }
+    ok = ok && verify(output, &plan, frames, options, error);
+    if (!ok) {
+        std::remove(output.c_str());
+    }
+    std::cout << output << ": " << (ok ? "ok, " + std::to_string(frames) + " frames" : error) << std::endl;
+    return ok;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] FILE...\n"
+              << "Transcode show media to HAP tuned for this machine and check it for playback.\n"
+              << "  --output-dir DIR     Where NAME.hap.mov files go (default: next to each source)\n"
+              << "  --format FORMAT      auto, hap, hap_alpha, hap_q or hap_r (default: auto)\n"
+              << "  --quality Q          normal or high (auto picks HAP Q / HAP R; default: normal)\n"
+              << "  --benchmarks FILE    This machine's bench_decode results (as for --admission-costs)\n"
+              << "  --hap-threads N      HAP chunk threads the player uses (default: " << HapChunkPool::defaultConcurrency() << ")\n"
+              << "  --bptc               The GPU samples BPTC textures (allows HAP R)\n"
+              << "  --storage-mbps N     Sustained read rate of the media disk in MB/s (default: unknown)\n"
+              << "  --layers N           HAP layers playing at once (default: 1)\n"
+              << "  --index-cache-dir D  Frame index cache of the player (default: its default)\n"
+              << "  --plan               Print the settings, do not transcode\n"
+              << "  --verify             Only check existing HAP files\n"
+              << "  --force              Replace existing output files\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--output-dir" && hasValue) {
+            options.outputDir = argv[++i];
+        } else if (arg == "--format" && hasValue) {
+            if (!HapPrepPlanner::parseFormat(argv[++i], options.format)) return false;
+        } else if (arg == "--quality" && hasValue) {
+            options.highQuality = std::string(argv[++i]) == "high";
+        } else if (arg == "--benchmarks" && hasValue) {
+            options.benchmarks = argv[++i];
+        } else if (arg == "--hap-threads" && hasValue) {
+            options.hapThreads = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "--bptc") {
+            options.bptc = true;
+        } else if (arg == "--storage-mbps" && hasValue) {
+            options.storageMBps = std::max(std::atof(argv[++i]), 0.0);
+        } else if (arg == "--layers" && hasValue) {
+            options.layers = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--index-cache-dir" && hasValue) {
+            options.indexCacheDir = argv[++i];
+        } else if (arg == "--plan") {
+            options.planOnly = true;
+        } else if (arg == "--verify") {
+            options.verifyOnly = true;
+        } else if (arg == "--force") {
+            options.force = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    return !options.files.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    Logger::getInstance().setLevel(Logger::WARNING);
+    av_log_set_level(AV_LOG_ERROR);
+
+    LoadAdmission costs;
+    if (!options.benchmarks.empty() && !costs.loadBenchmarkFile(options.benchmarks)) {
+        std::cerr << "prep: cannot read benchmark results " << options.benchmarks << "\n";
+        return 2;
+    }
+    HapPrepPlanner::Machine machine;
+    machine.chunkThreads = options.hapThreads > 0 ? static_cast<size_t>(options.hapThreads)
+                                                  : HapChunkPool::defaultConcurrency();
+    machine.bptc = options.bptc;
+    machine.storageBytesPerSecond = options.storageMBps * 1e6;
+    machine.layers = options.layers;
+    machine.costs = &costs;
+    std::cout << "machine: " << std::thread::hardware_concurrency() << " hardware threads, "
+              << machine.chunkThreads << " HAP chunk threads"
+              << (options.benchmarks.empty() ? ", built-in decode costs" : ", benchmarked decode costs") << std::endl;
+
+    bool ok = true;
+    for (const std::string& file : options.files) {
+        ok = prepare(file, machine, options) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "ClusterReplicator.h"
+#include <set>
+#include <sstream>
+
+namespace videocomposer {
+
+namespace {
+
+std::vector<std::string> splitLines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream input(text);
+    std::string line;
+    while (std::getline(input, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+const std::string* findKey(const ClusterReplicator::Lines& lines, const std::string& key) {
+    for (const std::string& line : lines) {
+        if (ClusterReplicator::keyOf(line) == key) {
+            return &line;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+ClusterReplicator::ClusterReplicator(uint64_t epoch, int64_t keyframeUs)
+    : epoch_(epoch)
+    , keyframeUs_(keyframeUs > 0 ? keyframeUs : DEFAULT_KEYFRAME_US)
+    , sequence_(0)
+    , lastKeyframeUs_(-1)
+    , keyframes_(0)
+    , hasEpoch_(false)
+    , lastApplied_(0)
+    , lastMissing_(0)
+    , stale_(false)
+    , gaps_(0)
+    , dropped_(0)
+{
+}
+
+std::string ClusterReplicator::keyOf(const std::string& line) {
+    size_t end = line.find(' ');
+    return end == std::string::npos ? line : line.substr(0, end);
+}
+
+const ClusterReplicator::Lines* ClusterReplicator::findLayer(const std::string& cueId) const {
+    auto it = scene_.find(cueId);
+    return it != scene_.end() ? &it->second : nullptr;
+}
+
+std::vector<double> ClusterReplicator::header() {
+    return {static_cast<double>(++sequence_), static_cast<double>(epoch_)};
+}
+
+bool ClusterReplicator::sendLayer(const std::string& cueId, const Lines& lines, bool full, const Sender& send) {
+    std::string label = cueId;
+    for (const std::string& line : lines) {
+        label += "\n" + line;
+    }
+    std::vector<double> values = header();
+    values.push_back(full ? 1.0 : 0.0);
+    return send(LAYER_PATH, label, values);
+}
+
+size_t ClusterReplicator::publish(const Scene& scene, int64_t nowUs, const Sender& send) {
+    bool keyframe = lastKeyframeUs_ < 0 || nowUs - lastKeyframeUs_ >= keyframeUs_;
+    uint64_t firstSequence = sequence_ + 1;
+    size_t sent = 0;
+    for (const auto& entry : scene) {
+        auto previous = scene_.find(entry.first);
+        if (keyframe || previous == scene_.end()) {
+            sent += sendLayer(entry.first, entry.second, true, send);
+            continue;
+        }
+        // A line that went away (e.g. the LUT was cleared) can only be sent as the full layer
+        bool dropsKey = false;
+        for (const std::string& line : previous->second) {
+            dropsKey = dropsKey || !findKey(entry.second, keyOf(line));
+        }
+        Lines changed;
+        for (const std::string& line : entry.second) {
+            const std::string* before = findKey(previous->second, keyOf(line));
+            if (!before || *before != line) {
+                changed.push_back(line);
+            }
+        }
+        if (dropsKey) {
+            sent += sendLayer(entry.first, entry.second, true, send);
+        } else if (!changed.empty()) {
+            sent += sendLayer(entry.first, changed, false, send);
+        }
+    }
+    for (const auto& entry : scene_) {
+        if (scene.find(entry.first) == scene.end()) {
+            sent += send(REMOVE_PATH, entry.first, header());
+        }
+    }
+    if (keyframe) {
+        std::string cues;
+        for (const auto& entry : scene) {
+            cues += (cues.empty() ? "" : "\n") + entry.first;
+        }
+        // Tells followers where the keyframe started, so they know it was complete
+        std::vector<double> values = header();
+        values.push_back(static_cast<double>(firstSequence));
+        sent += send(SYNC_PATH, cues, values);
+        lastKeyframeUs_ = nowUs;
+        keyframes_++;
+    }
+    scene_ = scene;
+    return sent;
+}
+
+void ClusterReplicator::mergeLines(Lines& into, const Lines& lines) {
+    for (const std::string& line : lines) {
+        std::string key = keyOf(line);
+        bool replaced = false;
+        for (std::string& existing : into) {
+            if (keyOf(existing) == key) {
+                existing = line;
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) {
+            into.push_back(line);
+        }
+    }
+}
+
+bool ClusterReplicator::receive(ClusterMessage kind, const std::string& label, const std::vector<double>& values,
+                                std::vector<Change>& changes) {
+    if (values.size() < 2 || values[0] < 1.0) {
+        dropped_++;
+        return false;
+    }
+    uint64_t sequence = static_cast<uint64_t>(values[0]);
+    uint64_t epoch = static_cast<uint64_t>(values[1]);
+    if (!hasEpoch_ || epoch != epoch_) {
+        // Joined (or the authority restarted): everything before this is unknown
+        hasEpoch_ = true;
+        epoch_ = epoch;
+        lastMissing_ = sequence - 1;
+        stale_ = true;
+    } else if (sequence <= lastApplied_) {
+        dropped_++;
+        return false;
+    } else if (sequence > lastApplied_ + 1) {
+        gaps_ += sequence - lastApplied_ - 1;
+        lastMissing_ = sequence - 1;
+        stale_ = true;
+    }
+    lastApplied_ = sequence;
+
+    switch (kind) {
+    case ClusterMessage::LAYER: {
+        Lines lines = splitLines(label);
+        if (lines.empty() || lines.front().empty()) {
+            dropped_++;
+            return false;
+        }
+        std::string cueId = lines.front();
+        lines.erase(lines.begin());
+        bool full = values.size() > 2 && values[2] != 0.0;
+        auto it = scene_.find(cueId);
+        if (full) {
+            scene_[cueId] = std::move(lines);
+        } else if (it != scene_.end()) {
+            mergeLines(it->second, lines);
+        } else {
+            // The cue's first message was lost: it comes with the next keyframe
+            stale_ = true;
+            dropped_++;
+            return false;
+        }
+        changes.push_back(Change{cueId, false});
+        return true;
+    }
+    case ClusterMessage::REMOVE:
+        if (scene_.erase(label) > 0) {
+            changes.push_back(Change{label, true});
+        }
+        return true;
+    case ClusterMessage::SYNC: {
+        Lines cues = splitLines(label);
+        std::set<std::string> listed(cues.begin(), cues.end());
+        for (auto it = scene_.begin(); it != scene_.end();) {
+            if (listed.count(it->first) == 0) {
+                changes.push_back(Change{it->first, true});
+                it = scene_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // Complete if nothing of this keyframe went missing
+        uint64_t firstSequence = values.size() > 2 ? static_cast<uint64_t>(values[2]) : sequence;
+        stale_ = lastMissing_ >= firstSequence;
+        return true;
+    }
+    }
+    return false;
+}
+
+} // namespace videocomposer
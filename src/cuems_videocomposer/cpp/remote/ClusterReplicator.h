@@ -0,0 +1,128 @@
+#ifndef VIDEOCOMPOSER_CLUSTERREPLICATOR_H
+#define VIDEOCOMPOSER_CLUSTERREPLICATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/** Message from the cluster authority (see ClusterReplicator) */
+enum class ClusterMessage { LAYER, REMOVE, SYNC };
+
+/**
+ * ClusterReplicator - Scene state of the cluster authority, replicated to followers
+ *
+ * One node is the scene authority; the others follow it. A layer is the
+ * "key values" lines of its show journal block (ShowJournal::formatLayer),
+ * one line per item, keyed by the line's first word. Every publish() the
+ * authority sends, per cue, only the lines that changed since the last
+ * one (a new cue sends them all), and a remove for cues that went away:
+ *
+ *   /videocomposer/cluster/layer   s:"cueId\nline\nline..." seq epoch full
+ *   /videocomposer/cluster/remove  s:cueId seq epoch
+ *   /videocomposer/cluster/sync    s:"cueId\ncueId..." seq epoch firstSeq
+ *
+ * Every keyframe interval all layers are sent in full, followed by a sync
+ * with the cue list and the keyframe's first number. Messages are
+ * numbered; a follower drops those older than the last one it applied
+ * (reordered or duplicated datagrams) and counts the gaps. A change lost
+ * in a gap is repaired by the next keyframe: full layers replace what the
+ * follower had, the sync removes cues it missed the removal of. A
+ * restarted authority has a new epoch and its numbering is taken as it
+ * comes.
+ *
+ * Main thread only.
+ */
+class ClusterReplicator {
+public:
+    static constexpr int64_t DEFAULT_KEYFRAME_US = 1000000;
+
+    static constexpr const char* LAYER_PATH = "/videocomposer/cluster/layer";
+    static constexpr const char* REMOVE_PATH = "/videocomposer/cluster/remove";
+    static constexpr const char* SYNC_PATH = "/videocomposer/cluster/sync";
+
+    using Lines = std::vector<std::string>;
+    using Scene = std::map<std::string, Lines>;   // Cue ID -> layer lines
+
+    /** A cue whose state changed on a follower */
+    struct Change {
+        std::string cueId;
+        bool removed = false;
+    };
+
+    using Sender = std::function<bool(const std::string& path, const std::string& label,
+                                      const std::vector<double>& values)>;
+
+    /**
+     * @param epoch Authority instance (e.g. its start time); followers
+     *              restart the numbering when it changes
+     */
+    explicit ClusterReplicator(uint64_t epoch = 0, int64_t keyframeUs = DEFAULT_KEYFRAME_US);
+
+    // ===== Authority =====
+
+    /**
+     * Send what changed since the last call (everything when a keyframe is due)
+     * @return Messages sent
+     */
+    size_t publish(const Scene& scene, int64_t nowUs, const Sender& send);
+
+    /** Send everything on the next publish() */
+    void forceKeyframe() { lastKeyframeUs_ = -1; }
+
+    uint64_t getSequence() const { return sequence_; }
+    uint64_t getKeyframeCount() const { return keyframes_; }
+
+    // ===== Follower =====
+
+    /**
+     * Apply a message from the authority
+     * @param changes Cues changed by it, appended
+     * @return false if dropped (stale, malformed or an unknown cue's delta)
+     */
+    bool receive(ClusterMessage kind, const std::string& label, const std::vector<double>& values,
+                 std::vector<Change>& changes);
+
+    /** The replicated scene (follower), or what was sent last (authority) */
+    const Scene& getScene() const { return scene_; }
+
+    /** Lines of one cue (nullptr if not in the scene) */
+    const Lines* findLayer(const std::string& cueId) const;
+
+    /** A gap was seen since the last keyframe: some cues may be stale */
+    bool isStale() const { return stale_; }
+    uint64_t getGapCount() const { return gaps_; }
+    uint64_t getDroppedCount() const { return dropped_; }
+
+    /** First word of a line */
+    static std::string keyOf(const std::string& line);
+
+private:
+    bool sendLayer(const std::string& cueId, const Lines& lines, bool full, const Sender& send);
+    std::vector<double> header();
+    static void mergeLines(Lines& into, const Lines& lines);
+
+    uint64_t epoch_;
+    int64_t keyframeUs_;
+    Scene scene_;
+
+    // Authority
+    uint64_t sequence_;
+    int64_t lastKeyframeUs_;
+    uint64_t keyframes_;
+
+    // Follower
+    bool hasEpoch_;
+    uint64_t lastApplied_;
+    uint64_t lastMissing_;      // Newest message number known to be lost
+    bool stale_;
+    uint64_t gaps_;
+    uint64_t dropped_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CLUSTERREPLICATOR_H
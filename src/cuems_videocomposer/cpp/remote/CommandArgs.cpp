@@ -0,0 +1,207 @@
+#include "CommandArgs.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+namespace videocomposer {
+
+int CommandArg::toInt() const {
+    switch (type_) {
+        case Type::INT:
+            return value_.i;
+        case Type::INT64:
+            return static_cast<int>(value_.h);
+        case Type::FLOAT:
+            return static_cast<int>(value_.f);
+        case Type::DOUBLE:
+            return static_cast<int>(value_.d);
+        case Type::STRING:
+            break;
+    }
+    return std::atoi(str_);
+}
+
+int64_t CommandArg::toInt64() const {
+    switch (type_) {
+        case Type::INT:
+            return value_.i;
+        case Type::INT64:
+            return value_.h;
+        case Type::FLOAT:
+            return static_cast<int64_t>(value_.f);
+        case Type::DOUBLE:
+            return static_cast<int64_t>(value_.d);
+        case Type::STRING:
+            break;
+    }
+    return std::atoll(str_);
+}
+
+float CommandArg::toFloat() const {
+    return type_ == Type::FLOAT ? value_.f : static_cast<float>(toDouble());
+}
+
+double CommandArg::toDouble() const {
+    switch (type_) {
+        case Type::INT:
+            return value_.i;
+        case Type::INT64:
+            return static_cast<double>(value_.h);
+        case Type::FLOAT:
+            return value_.f;
+        case Type::DOUBLE:
+            return value_.d;
+        case Type::STRING:
+            break;
+    }
+    return std::atof(str_);
+}
+
+const char* CommandArg::c_str() const {
+    if (type_ == Type::STRING) {
+        return str_;
+    }
+    if (!formatted_) {
+        // Same text the OSC layer used to produce with an ostringstream
+        switch (type_) {
+            case Type::INT:
+                std::snprintf(number_, sizeof(number_), "%d", value_.i);
+                break;
+            case Type::INT64:
+                std::snprintf(number_, sizeof(number_), "%" PRId64, value_.h);
+                break;
+            case Type::FLOAT:
+                std::snprintf(number_, sizeof(number_), "%g", value_.f);
+                break;
+            default:
+                // Full precision: doubles carry timestamps (frame lock)
+                std::snprintf(number_, sizeof(number_), "%.17g", value_.d);
+                break;
+        }
+        formatted_ = true;
+    }
+    return number_;
+}
+
+std::string_view CommandArg::view() const {
+    if (type_ == Type::STRING) {
+        return std::string_view(str_, length_);
+    }
+    return std::string_view(c_str());
+}
+
+CommandArgs::CommandArgs(const std::vector<std::string>& strings) {
+    size_t bytes = 0;
+    for (const std::string& s : strings) {
+        bytes += s.size() + 1;
+    }
+    reserve(strings.size(), bytes);
+    for (const std::string& s : strings) {
+        addString(s);
+    }
+}
+
+CommandArgs::CommandArgs(const CommandArgs& other)
+    : args_(other.args_)
+    , text_(other.text_)
+{
+    rebase();
+}
+
+CommandArgs& CommandArgs::operator=(const CommandArgs& other) {
+    if (this != &other) {
+        args_ = other.args_;
+        text_ = other.text_;
+        rebase();
+    }
+    return *this;
+}
+
+void CommandArgs::clear() {
+    args_.clear();
+    text_.clear();
+}
+
+void CommandArgs::reserve(size_t args, size_t textBytes) {
+    args_.reserve(args);
+    if (textBytes > text_.capacity()) {
+        text_.reserve(textBytes);
+        rebase();
+    }
+}
+
+void CommandArgs::addInt(int32_t value) {
+    CommandArg arg;
+    arg.type_ = CommandArg::Type::INT;
+    arg.value_.i = value;
+    args_.push_back(arg);
+}
+
+void CommandArgs::addInt64(int64_t value) {
+    CommandArg arg;
+    arg.type_ = CommandArg::Type::INT64;
+    arg.value_.h = value;
+    args_.push_back(arg);
+}
+
+void CommandArgs::addFloat(float value) {
+    CommandArg arg;
+    arg.type_ = CommandArg::Type::FLOAT;
+    arg.value_.f = value;
+    args_.push_back(arg);
+}
+
+void CommandArgs::addDouble(double value) {
+    CommandArg arg;
+    arg.type_ = CommandArg::Type::DOUBLE;
+    arg.value_.d = value;
+    args_.push_back(arg);
+}
+
+void CommandArgs::addString(std::string_view value) {
+    CommandArg arg;
+    arg.type_ = CommandArg::Type::STRING;
+    arg.offset_ = static_cast<uint32_t>(text_.size());
+    arg.length_ = static_cast<uint32_t>(value.size());
+
+    const char* before = text_.data();
+    text_.insert(text_.end(), value.begin(), value.end());
+    text_.push_back('\0');
+    arg.str_ = text_.data() + arg.offset_;
+    args_.push_back(arg);
+    if (text_.data() != before) {
+        // Text buffer grew and moved
+        rebase();
+    }
+}
+
+void CommandArgs::rebase() {
+    for (CommandArg& arg : args_) {
+        if (arg.type_ == CommandArg::Type::STRING) {
+            arg.str_ = text_.data() + arg.offset_;
+        }
+    }
+}
+
+CommandArgs CommandArgs::tail(size_t first) const {
+    CommandArgs rest;
+    for (size_t i = first; i < args_.size(); ++i) {
+        if (args_[i].isString()) {
+            rest.addString(args_[i].view());
+        } else {
+            rest.args_.push_back(args_[i]);
+        }
+    }
+    return rest;
+}
+
+std::vector<std::string> CommandArgs::toStrings() const {
+    std::vector<std::string> strings;
+    strings.reserve(args_.size());
+    for (const CommandArg& arg : args_) {
+        strings.push_back(arg.str());
+    }
+    return strings;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,113 @@
+#ifndef VIDEOCOMPOSER_COMMANDARGS_H
+#define VIDEOCOMPOSER_COMMANDARGS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * CommandArg - One remote command argument, kept in its wire type
+ *
+ * Numbers stay numbers: toInt()/toFloat()/toDouble() read them without a
+ * round trip through text, and only parse when the argument was sent as a
+ * string. c_str() formats numbers on first use, like the string arguments
+ * handlers used to get.
+ */
+class CommandArg {
+public:
+    enum class Type { INT, INT64, FLOAT, DOUBLE, STRING };
+
+    Type type() const { return type_; }
+    bool isString() const { return type_ == Type::STRING; }
+
+    int toInt() const;
+    int64_t toInt64() const;
+    float toFloat() const;
+    double toDouble() const;
+
+    /** Text of the argument (valid while the owning CommandArgs is) */
+    const char* c_str() const;
+    std::string_view view() const;
+    std::string str() const { return std::string(view()); }
+    operator std::string() const { return str(); }
+
+    size_t length() const { return view().size(); }
+    size_t size() const { return length(); }
+    bool empty() const { return length() == 0; }
+    size_t find_first_of(const char* chars, size_t pos = 0) const { return view().find_first_of(chars, pos); }
+
+    bool operator==(std::string_view text) const { return view() == text; }
+    bool operator!=(std::string_view text) const { return view() != text; }
+    bool operator==(const char* text) const { return view() == text; }
+    bool operator!=(const char* text) const { return view() != text; }
+
+private:
+    friend class CommandArgs;
+
+    Type type_ = Type::INT;
+    union {
+        int32_t i;
+        int64_t h;
+        float f;
+        double d;
+    } value_ = {};
+    uint32_t offset_ = 0;           // Strings: position in CommandArgs::text_
+    uint32_t length_ = 0;
+    const char* str_ = nullptr;     // Strings: text_.data() + offset_
+    mutable char number_[32] = {};  // Numbers: formatted by c_str()
+    mutable bool formatted_ = false;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const CommandArg& arg) {
+    return os << arg.view();
+}
+
+/**
+ * CommandArgs - Arguments of one remote command
+ *
+ * clear() keeps the storage, so an instance reused for every message
+ * (one per queue slot) stops allocating once it has seen the largest
+ * command. Strings are copied into one shared text buffer.
+ */
+class CommandArgs {
+public:
+    CommandArgs() = default;
+    CommandArgs(const std::vector<std::string>& strings);
+    CommandArgs(const CommandArgs& other);
+    CommandArgs& operator=(const CommandArgs& other);
+
+    void clear();
+    void reserve(size_t args, size_t textBytes);
+
+    void addInt(int32_t value);
+    void addInt64(int64_t value);
+    void addFloat(float value);
+    void addDouble(double value);
+    void addString(std::string_view value);
+
+    size_t size() const { return args_.size(); }
+    bool empty() const { return args_.empty(); }
+    const CommandArg& operator[](size_t index) const { return args_[index]; }
+    std::vector<CommandArg>::const_iterator begin() const { return args_.begin(); }
+    std::vector<CommandArg>::const_iterator end() const { return args_.end(); }
+
+    /** Copy of the arguments from index first on (wrapped commands) */
+    CommandArgs tail(size_t first) const;
+
+    std::vector<std::string> toStrings() const;
+
+private:
+    void rebase();
+
+    std::vector<CommandArg> args_;
+    std::vector<char> text_;  // NUL-terminated string arguments
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_COMMANDARGS_H
@@ -0,0 +1,74 @@
+#include "CommandScheduler.h"
+#include <algorithm>
+#include <iterator>
+
+namespace videocomposer {
+
+namespace {
+
+// Seconds from 1900-01-01 (NTP epoch) to 1970-01-01
+constexpr int64_t NTP_UNIX_OFFSET_S = 2208988800LL;
+
+} // namespace
+
+bool CommandScheduler::scheduleAtFrame(int64_t frame, std::string_view path, const CommandArgs& args) {
+    return insert(frameCommands_, frame, path, args);
+}
+
+bool CommandScheduler::scheduleAtTime(int64_t wallUs, std::string_view path, const CommandArgs& args) {
+    return insert(timeCommands_, wallUs, path, args);
+}
+
+bool CommandScheduler::insert(std::vector<Scheduled>& list, int64_t at, std::string_view path,
+                              const CommandArgs& args) {
+    if (size() >= MAX_PENDING) {
+        return false;
+    }
+    Scheduled command;
+    command.at = at;
+    command.serial = serial_++;
+    command.path.assign(path.data(), path.size());
+    command.args = args;
+
+    // After everything due at the same time: same-frame commands keep their order
+    auto it = std::upper_bound(list.begin(), list.end(), at,
+                               [](int64_t value, const Scheduled& s) { return value < s.at; });
+    list.insert(it, std::move(command));
+    return true;
+}
+
+size_t CommandScheduler::runList(std::vector<Scheduled>& list, int64_t now, const Runner& run) {
+    auto end = std::upper_bound(list.begin(), list.end(), now,
+                                [](int64_t value, const Scheduled& s) { return value < s.at; });
+    if (end == list.begin()) {
+        return 0;
+    }
+    // Taken out first: a command may schedule others
+    std::vector<Scheduled> due(std::make_move_iterator(list.begin()), std::make_move_iterator(end));
+    list.erase(list.begin(), end);
+    for (const Scheduled& command : due) {
+        run(command.path, command.args);
+    }
+    return due.size();
+}
+
+size_t CommandScheduler::runDue(int64_t frame, int64_t presentationUs, const Runner& run) {
+    size_t count = 0;
+    if (frame >= 0) {
+        count += runList(frameCommands_, frame, run);
+    }
+    count += runList(timeCommands_, presentationUs, run);
+    return count;
+}
+
+void CommandScheduler::clear() {
+    frameCommands_.clear();
+    timeCommands_.clear();
+}
+
+int64_t CommandScheduler::timetagToUnixUs(uint32_t seconds, uint32_t fraction) {
+    int64_t us = (static_cast<int64_t>(seconds) - NTP_UNIX_OFFSET_S) * 1000000LL;
+    return us + static_cast<int64_t>((static_cast<uint64_t>(fraction) * 1000000ULL) >> 32);
+}
+
+} // namespace videocomposer
@@ -0,0 +1,70 @@
+#ifndef VIDEOCOMPOSER_COMMANDSCHEDULER_H
+#define VIDEOCOMPOSER_COMMANDSCHEDULER_H
+
+#include "CommandArgs.h"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * CommandScheduler - Remote commands held back until the frame they are for
+ *
+ * Commands are keyed on a sync-source frame (/at <timecode> ...) or on a
+ * wall-clock time (OSC bundle timetags). runDue() is called once per frame
+ * with the frame and wall clock this render will be presented at, so a
+ * command fires on the first frame at or past its time whatever the
+ * network timing was. Commands due on the same frame fire in time order,
+ * then in the order they were scheduled.
+ */
+class CommandScheduler {
+public:
+    using Runner = std::function<void(std::string_view path, const CommandArgs& args)>;
+
+    // Beyond this many pending commands new ones are refused
+    static constexpr size_t MAX_PENDING = 4096;
+
+    /** @return false if too many commands are pending */
+    bool scheduleAtFrame(int64_t frame, std::string_view path, const CommandArgs& args);
+    bool scheduleAtTime(int64_t wallUs, std::string_view path, const CommandArgs& args);
+
+    /**
+     * Run the commands due for this render
+     * @param frame Sync-source frame presented (-1 = no sync source; frame
+     *              commands wait)
+     * @param presentationUs Wall clock of the vblank this render is shown on
+     * @return Number of commands run
+     */
+    size_t runDue(int64_t frame, int64_t presentationUs, const Runner& run);
+
+    /** Drop every pending command */
+    void clear();
+
+    size_t size() const { return frameCommands_.size() + timeCommands_.size(); }
+
+    /** OSC/NTP timetag (seconds since 1900, 2^-32 fractions) to Unix microseconds */
+    static int64_t timetagToUnixUs(uint32_t seconds, uint32_t fraction);
+
+private:
+    struct Scheduled {
+        int64_t at = 0;
+        uint64_t serial = 0;
+        std::string path;
+        CommandArgs args;
+    };
+
+    bool insert(std::vector<Scheduled>& list, int64_t at, std::string_view path, const CommandArgs& args);
+    size_t runList(std::vector<Scheduled>& list, int64_t now, const Runner& run);
+
+    std::vector<Scheduled> frameCommands_;  // Sorted by (at, serial)
+    std::vector<Scheduled> timeCommands_;
+    uint64_t serial_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_COMMANDSCHEDULER_H
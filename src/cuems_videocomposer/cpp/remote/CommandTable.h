@@ -0,0 +1,91 @@
+#ifndef VIDEOCOMPOSER_COMMANDTABLE_H
+#define VIDEOCOMPOSER_COMMANDTABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * CommandTable - Command path to handler, looked up without allocating
+ *
+ * Open-addressing hash table rebuilt on every registration (registration
+ * happens once, at startup), kept at most half full so a lookup is one
+ * hash of the path and usually a single compare. find() takes a view of
+ * the path as received, no std::string key is built.
+ */
+template <typename Handler>
+class CommandTable {
+public:
+    void insert(const std::string& path, Handler handler) {
+        for (Entry& entry : entries_) {
+            if (entry.path == path) {
+                entry.handler = std::move(handler);
+                return;
+            }
+        }
+        entries_.push_back(Entry{path, std::move(handler)});
+        rebuild();
+    }
+
+    /** @return Handler for this path, nullptr if none */
+    const Handler* find(std::string_view path) const {
+        if (slots_.empty()) {
+            return nullptr;
+        }
+        size_t mask = slots_.size() - 1;
+        for (size_t slot = hash(path) & mask; slots_[slot] != EMPTY; slot = (slot + 1) & mask) {
+            const Entry& entry = entries_[slots_[slot]];
+            if (entry.path == path) {
+                return &entry.handler;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const { return entries_.size(); }
+
+    static uint32_t hash(std::string_view path) {
+        // FNV-1a
+        uint32_t h = 2166136261u;
+        for (char c : path) {
+            h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return h;
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        Handler handler;
+    };
+
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+
+    void rebuild() {
+        size_t capacity = 16;
+        while (capacity < entries_.size() * 2) {
+            capacity *= 2;
+        }
+        slots_.assign(capacity, EMPTY);
+        size_t mask = capacity - 1;
+        for (size_t index = 0; index < entries_.size(); ++index) {
+            size_t slot = hash(entries_[index].path) & mask;
+            while (slots_[slot] != EMPTY) {
+                slot = (slot + 1) & mask;
+            }
+            slots_[slot] = static_cast<uint32_t>(index);
+        }
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> slots_;  // Index into entries_, EMPTY = free
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_COMMANDTABLE_H
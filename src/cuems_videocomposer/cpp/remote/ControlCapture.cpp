@@ -0,0 +1,481 @@
+#include "ControlCapture.h"
+#include "../utils/Logger.h"
+#include "../utils/TimeUtils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace videocomposer {
+
+namespace {
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void putSigned(std::string& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void putBytes(std::string& out, const void* data, size_t size) {
+    // Little-endian hosts only (x86, ARM): the value bytes as they are
+    out.append(static_cast<const char*>(data), size);
+}
+
+void putString(std::string& out, std::string_view text) {
+    putVarint(out, text.size());
+    out.append(text.data(), text.size());
+}
+
+bool getVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end) {
+            return false;
+        }
+        uint8_t byte = *data++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool getSigned(const uint8_t*& data, const uint8_t* end, int64_t& value) {
+    uint64_t raw;
+    if (!getVarint(data, end, raw)) {
+        return false;
+    }
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+bool getBytes(const uint8_t*& data, const uint8_t* end, void* value, size_t size) {
+    if (static_cast<size_t>(end - data) < size) {
+        return false;
+    }
+    std::memcpy(value, data, size);
+    data += size;
+    return true;
+}
+
+bool getString(const uint8_t*& data, const uint8_t* end, std::string_view& text) {
+    uint64_t size;
+    if (!getVarint(data, end, size) || static_cast<uint64_t>(end - data) < size) {
+        return false;
+    }
+    text = std::string_view(reinterpret_cast<const char*>(data), static_cast<size_t>(size));
+    data += size;
+    return true;
+}
+
+void putHeader(std::string& out, ControlRecord::Kind kind, int64_t timeUs, int64_t& previousUs) {
+    out += static_cast<char>(kind);
+    putVarint(out, static_cast<uint64_t>(std::max<int64_t>(timeUs - previousUs, 0)));
+    previousUs = std::max(timeUs, previousUs);
+}
+
+} // namespace
+
+constexpr char ControlLog::MAGIC[9];
+
+void ControlLog::encode(const ControlRecord& record, int64_t& previousUs, std::string& out) {
+    if (record.kind == ControlRecord::Kind::COMMAND) {
+        encodeCommand(record.timeUs, record.path, record.args, record.scheduled, record.atOffsetUs, previousUs, out);
+        return;
+    }
+    putHeader(out, record.kind, record.timeUs, previousUs);
+    if (record.kind == ControlRecord::Kind::TRANSPORT) {
+        out += static_cast<char>(record.transport);
+    }
+    putSigned(out, record.frame);
+}
+
+void ControlLog::encodeCommand(int64_t timeUs, std::string_view path, const CommandArgs& args, bool scheduled,
+                               int64_t atOffsetUs, int64_t& previousUs, std::string& out) {
+    putHeader(out, ControlRecord::Kind::COMMAND, timeUs, previousUs);
+    out += static_cast<char>(scheduled ? 1 : 0);
+    if (scheduled) {
+        putSigned(out, atOffsetUs);
+    }
+    putString(out, path);
+    putVarint(out, args.size());
+    for (const CommandArg& arg : args) {
+        out += static_cast<char>(arg.type());
+        switch (arg.type()) {
+            case CommandArg::Type::INT:
+                putSigned(out, arg.toInt());
+                break;
+            case CommandArg::Type::INT64:
+                putSigned(out, arg.toInt64());
+                break;
+            case CommandArg::Type::FLOAT: {
+                float value = arg.toFloat();
+                putBytes(out, &value, sizeof(value));
+                break;
+            }
+            case CommandArg::Type::DOUBLE: {
+                double value = arg.toDouble();
+                putBytes(out, &value, sizeof(value));
+                break;
+            }
+            case CommandArg::Type::STRING:
+                putString(out, arg.view());
+                break;
+        }
+    }
+}
+
+bool ControlLog::decode(const uint8_t*& data, const uint8_t* end, int64_t& previousUs, ControlRecord& record) {
+    if (data == end) {
+        return false;
+    }
+    uint8_t kind = *data++;
+    uint64_t deltaUs;
+    if (!getVarint(data, end, deltaUs)) {
+        return false;
+    }
+    record = ControlRecord();
+    record.timeUs = previousUs + static_cast<int64_t>(deltaUs);
+    previousUs = record.timeUs;
+
+    switch (static_cast<ControlRecord::Kind>(kind)) {
+        case ControlRecord::Kind::FRAME:
+            record.kind = ControlRecord::Kind::FRAME;
+            return getSigned(data, end, record.frame);
+        case ControlRecord::Kind::TRANSPORT: {
+            record.kind = ControlRecord::Kind::TRANSPORT;
+            if (data == end || *data > static_cast<uint8_t>(TransportEvent::Kind::START)) {
+                return false;
+            }
+            record.transport = static_cast<TransportEvent::Kind>(*data++);
+            return getSigned(data, end, record.frame);
+        }
+        case ControlRecord::Kind::COMMAND:
+            break;
+        default:
+            return false;
+    }
+
+    record.kind = ControlRecord::Kind::COMMAND;
+    if (data == end) {
+        return false;
+    }
+    record.scheduled = *data++ != 0;
+    std::string_view path;
+    uint64_t count;
+    if ((record.scheduled && !getSigned(data, end, record.atOffsetUs)) || !getString(data, end, path) ||
+        !getVarint(data, end, count)) {
+        return false;
+    }
+    record.path.assign(path);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (data == end) {
+            return false;
+        }
+        uint8_t type = *data++;
+        switch (static_cast<CommandArg::Type>(type)) {
+            case CommandArg::Type::INT:
+            case CommandArg::Type::INT64: {
+                int64_t value;
+                if (!getSigned(data, end, value)) {
+                    return false;
+                }
+                if (static_cast<CommandArg::Type>(type) == CommandArg::Type::INT) {
+                    record.args.addInt(static_cast<int32_t>(value));
+                } else {
+                    record.args.addInt64(value);
+                }
+                break;
+            }
+            case CommandArg::Type::FLOAT: {
+                float value;
+                if (!getBytes(data, end, &value, sizeof(value))) {
+                    return false;
+                }
+                record.args.addFloat(value);
+                break;
+            }
+            case CommandArg::Type::DOUBLE: {
+                double value;
+                if (!getBytes(data, end, &value, sizeof(value))) {
+                    return false;
+                }
+                record.args.addDouble(value);
+                break;
+            }
+            case CommandArg::Type::STRING: {
+                std::string_view text;
+                if (!getString(data, end, text)) {
+                    return false;
+                }
+                record.args.addString(text);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool ControlLog::load(const std::string& path, std::vector<ControlRecord>& records) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR << "Control log: cannot read " << path << ": " << std::strerror(errno);
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t magic = sizeof(MAGIC) - 1;
+    if (contents.size() < magic || contents.compare(0, magic, MAGIC) != 0) {
+        LOG_ERROR << "Control log: " << path << " is not a control log";
+        return false;
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(contents.data()) + magic;
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(contents.data()) + contents.size();
+    int64_t previousUs = 0;
+    records.clear();
+    while (data != end) {
+        ControlRecord record;
+        if (!decode(data, end, previousUs, record)) {
+            // A capture cut short (crash, power loss) keeps what was flushed
+            LOG_WARNING << "Control log: " << path << " truncated after " << records.size() << " records";
+            break;
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+// ControlCapture
+
+ControlCapture& ControlCapture::instance() {
+    static ControlCapture capture;
+    return capture;
+}
+
+ControlCapture::~ControlCapture() {
+    stop();
+}
+
+bool ControlCapture::start(const std::string& path) {
+    stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR << "Control capture: cannot write " << path << ": " << std::strerror(errno);
+        return false;
+    }
+    path_ = path;
+    buffer_.assign(ControlLog::MAGIC, sizeof(ControlLog::MAGIC) - 1);
+    buffer_.reserve(FLUSH_BYTES * 2);
+    startUs_ = vc_get_monotonic_time();
+    previousUs_ = 0;
+    records_ = 0;
+    recording_.store(true, std::memory_order_relaxed);
+    LOG_INFO << "Control capture: recording MTC and remote commands to " << path;
+    return true;
+}
+
+void ControlCapture::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+    recording_.store(false, std::memory_order_relaxed);
+    flushLocked(true);
+    std::fclose(file_);
+    file_ = nullptr;
+    LOG_INFO << "Control capture: " << records_ << " records in " << path_;
+}
+
+int64_t ControlCapture::elapsedLocked() const {
+    return std::max(vc_get_monotonic_time() - startUs_, previousUs_);
+}
+
+void ControlCapture::flushLocked(bool force) {
+    if (!file_ || buffer_.empty() || (!force && buffer_.size() < FLUSH_BYTES)) {
+        return;
+    }
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+        LOG_WARNING << "Control capture: write to " << path_ << " failed";
+    }
+    std::fflush(file_);
+    buffer_.clear();
+}
+
+void ControlCapture::recordFrame(int64_t frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+    ControlRecord record;
+    record.kind = ControlRecord::Kind::FRAME;
+    record.timeUs = elapsedLocked();
+    record.frame = frame;
+    ControlLog::encode(record, previousUs_, buffer_);
+    ++records_;
+    flushLocked(false);
+}
+
+void ControlCapture::recordTransport(TransportEvent::Kind kind, int64_t frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+    ControlRecord record;
+    record.kind = ControlRecord::Kind::TRANSPORT;
+    record.timeUs = elapsedLocked();
+    record.transport = kind;
+    record.frame = frame;
+    ControlLog::encode(record, previousUs_, buffer_);
+    ++records_;
+    flushLocked(false);
+}
+
+void ControlCapture::recordCommand(std::string_view path, const CommandArgs& args, int64_t atUs) {
+    int64_t atOffsetUs = atUs != 0 ? atUs - vc_get_realtime() : 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+    ControlLog::encodeCommand(elapsedLocked(), path, args, atUs != 0, atOffsetUs, previousUs_, buffer_);
+    ++records_;
+    flushLocked(false);
+}
+
+uint64_t ControlCapture::getRecordCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+}
+
+// ControlReplay
+
+ControlReplay& ControlReplay::instance() {
+    static ControlReplay replay;
+    return replay;
+}
+
+bool ControlReplay::load(const std::string& path, bool fast) {
+    std::vector<ControlRecord> records;
+    if (!ControlLog::load(path, records)) {
+        return false;
+    }
+    LOG_INFO << "Control replay: " << records.size() << " records from " << path
+             << (fast ? " (as fast as possible)" : " (original timing)");
+    setRecords(std::move(records), fast);
+    return true;
+}
+
+void ControlReplay::setRecords(std::vector<ControlRecord> records, bool fast) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_ = std::move(records);
+    commands_.clear();
+    next_ = 0;
+    startUs_ = -1;
+    frame_ = -1;
+    fast_ = fast;
+    hasFrames_ = std::any_of(records_.begin(), records_.end(),
+                             [](const ControlRecord& r) { return r.kind == ControlRecord::Kind::FRAME; });
+    hasCommands_ = std::any_of(records_.begin(), records_.end(),
+                               [](const ControlRecord& r) { return r.kind == ControlRecord::Kind::COMMAND; });
+    fullFrame_ = false;
+    active_ = true;
+    finishedLogged_ = false;
+}
+
+bool ControlReplay::isActive() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_;
+}
+
+bool ControlReplay::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_ && next_ >= records_.size() && commands_.empty();
+}
+
+bool ControlReplay::hasCommands() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hasCommands_;
+}
+
+void ControlReplay::playLocked(size_t index) {
+    const ControlRecord& record = records_[index];
+    switch (record.kind) {
+        case ControlRecord::Kind::FRAME:
+            frame_ = record.frame;
+            break;
+        case ControlRecord::Kind::TRANSPORT:
+            events_.post(record.transport, record.frame);
+            if (record.transport == TransportEvent::Kind::LOCATE) {
+                fullFrame_ = true;
+            }
+            break;
+        case ControlRecord::Kind::COMMAND:
+            commands_.push_back(index);
+            break;
+    }
+}
+
+void ControlReplay::update(int64_t nowUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) {
+        return;
+    }
+    if (startUs_ < 0) {
+        startUs_ = nowUs;
+    }
+    if (fast_) {
+        // Up to and including the next frame: one frame per render
+        while (next_ < records_.size()) {
+            bool frame = records_[next_].kind == ControlRecord::Kind::FRAME;
+            playLocked(next_++);
+            if (frame || !hasFrames_) {
+                break;
+            }
+        }
+    } else {
+        while (next_ < records_.size() && records_[next_].timeUs <= nowUs - startUs_) {
+            playLocked(next_++);
+        }
+    }
+    if (next_ >= records_.size() && !finishedLogged_) {
+        finishedLogged_ = true;
+        LOG_INFO << "Control replay: finished after " << (nowUs - startUs_) / 1000 << " ms";
+    }
+}
+
+int64_t ControlReplay::getFrame() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_;
+}
+
+bool ControlReplay::takeFullFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool fullFrame = fullFrame_;
+    fullFrame_ = false;
+    return fullFrame;
+}
+
+size_t ControlReplay::takeCommands(const CommandCallback& route) {
+    std::deque<size_t> commands;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands.swap(commands_);
+    }
+    // Records are not touched once loaded: routed without the lock
+    for (size_t index : commands) {
+        const ControlRecord& record = records_[index];
+        route(record.path, record.args, record.scheduled ? vc_get_realtime() + record.atOffsetUs : 0);
+    }
+    return commands.size();
+}
+
+} // namespace videocomposer
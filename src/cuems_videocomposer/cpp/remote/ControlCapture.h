@@ -0,0 +1,169 @@
+#ifndef VIDEOCOMPOSER_CONTROLCAPTURE_H
+#define VIDEOCOMPOSER_CONTROLCAPTURE_H
+
+#include "CommandArgs.h"
+#include "../sync/TransportEventLog.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * ControlRecord - One entry of a control traffic log
+ */
+struct ControlRecord {
+    enum class Kind : uint8_t {
+        FRAME = 1,       // Frame the MIDI driver reported (-1 = none)
+        TRANSPORT = 2,   // Transport event of the MIDI driver
+        COMMAND = 3      // Remote command as it arrived (OSC, local channel)
+    };
+    Kind kind = Kind::FRAME;
+    int64_t timeUs = 0;            // Since the capture started
+    int64_t frame = -1;            // FRAME, TRANSPORT
+    TransportEvent::Kind transport = TransportEvent::Kind::LOCATE;
+    std::string path;              // COMMAND
+    CommandArgs args;
+    bool scheduled = false;        // COMMAND of a timetagged bundle
+    int64_t atOffsetUs = 0;        // Its timetag, relative to the arrival
+};
+
+/**
+ * ControlLog - Binary format of the control traffic log
+ *
+ * An 8-byte magic, then the records back to back: a kind byte, the time
+ * since the previous record as a varint, the payload (signed values
+ * zigzag varints, floats and doubles little-endian, strings length
+ * prefixed). A running MTC stream takes about 7 bytes a frame.
+ */
+class ControlLog {
+public:
+    static constexpr char MAGIC[9] = "VCCTRL1\n";
+
+    /** Append a record; previousUs is the time of the record before (updated) */
+    static void encode(const ControlRecord& record, int64_t& previousUs, std::string& out);
+
+    static void encodeCommand(int64_t timeUs, std::string_view path, const CommandArgs& args, bool scheduled,
+                              int64_t atOffsetUs, int64_t& previousUs, std::string& out);
+
+    /**
+     * Read the record at data (advanced past it)
+     * @return false at a truncated or unknown record
+     */
+    static bool decode(const uint8_t*& data, const uint8_t* end, int64_t& previousUs, ControlRecord& record);
+
+    /** Every record of a log file */
+    static bool load(const std::string& path, std::vector<ControlRecord>& records);
+};
+
+/**
+ * ControlCapture - Records the MTC and remote control traffic of a show
+ *
+ * MIDISyncSource reports what its MIDI driver delivers (each new frame,
+ * transport events), OSCRemoteControl each command as it arrives, with
+ * its bundle timetag. Records are buffered and written to the log every
+ * FLUSH_BYTES and on stop(). Thread-safe; isRecording() is the cheap test
+ * callers make first.
+ */
+class ControlCapture {
+public:
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;
+
+    static ControlCapture& instance();
+
+    bool start(const std::string& path);
+    void stop();
+    bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+    void recordFrame(int64_t frame);
+    void recordTransport(TransportEvent::Kind kind, int64_t frame);
+
+    /** @param atUs Bundle timetag, wall clock microseconds (0 = immediately) */
+    void recordCommand(std::string_view path, const CommandArgs& args, int64_t atUs);
+
+    uint64_t getRecordCount() const;
+
+private:
+    ControlCapture() = default;
+    ~ControlCapture();
+
+    int64_t elapsedLocked() const;       // Monotonic, never before the previous record
+    void flushLocked(bool force);
+
+    mutable std::mutex mutex_;
+    std::atomic<bool> recording_{false};
+    FILE* file_ = nullptr;
+    std::string path_;
+    std::string buffer_;
+    int64_t startUs_ = 0;
+    int64_t previousUs_ = 0;
+    uint64_t records_ = 0;
+};
+
+/**
+ * ControlReplay - Plays a control traffic log back into the application
+ *
+ * ReplayMIDIDriver takes the frames and transport events, OSCRemoteControl
+ * the commands (routed as if they had just arrived; timetags keep their
+ * distance to the arrival). The application calls update() once per
+ * render, the first call starts the replay: with the original timing,
+ * records are played when their time has passed; as fast as possible,
+ * every update() plays up to the next frame record (or one record of a
+ * log without frames), so the show advances a frame per render.
+ */
+class ControlReplay {
+public:
+    using CommandCallback = std::function<void(const std::string& path, const CommandArgs& args, int64_t atUs)>;
+
+    static ControlReplay& instance();
+
+    ControlReplay() = default;
+
+    bool load(const std::string& path, bool fast);
+    void setRecords(std::vector<ControlRecord> records, bool fast);
+    bool isActive() const;
+    bool isFinished() const;
+    bool hasCommands() const;
+
+    /** Play the records due at nowUs (monotonic) */
+    void update(int64_t nowUs);
+
+    int64_t getFrame() const;
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+        return events_.read(since, events);
+    }
+    bool takeFullFrame();
+
+    /**
+     * Hand the commands played so far to route
+     * @return Number of commands
+     */
+    size_t takeCommands(const CommandCallback& route);
+
+private:
+    void playLocked(size_t index);
+
+    mutable std::mutex mutex_;
+    std::vector<ControlRecord> records_;
+    std::deque<size_t> commands_;    // Played command records, not taken yet
+    TransportEventLog events_;
+    size_t next_ = 0;
+    int64_t startUs_ = -1;
+    int64_t frame_ = -1;
+    bool fast_ = false;
+    bool hasFrames_ = false;
+    bool hasCommands_ = false;
+    bool fullFrame_ = false;
+    bool active_ = false;
+    bool finishedLogged_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_CONTROLCAPTURE_H
@@ -0,0 +1,273 @@
+/**
+ * LocalControlChannel.cpp - Remote commands from local controllers over shared memory
+ */
+
+#include "LocalControlChannel.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/WakeSignal.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace videocomposer {
+
+LocalControlChannel::LocalControlChannel()
+    : capacity_(LocalControlRing::DEFAULT_CAPACITY)
+    , listenSocket_(-1)
+    , stopFd_(-1)
+    , wake_(nullptr)
+{
+}
+
+LocalControlChannel::~LocalControlChannel() {
+    close();
+}
+
+bool LocalControlChannel::open(const std::string& socketPath, uint32_t capacity) {
+    close();
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR << "LocalControlChannel: Invalid socket path '" << socketPath << "'";
+        return false;
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    socketPath_ = socketPath;
+    capacity_ = capacity;
+
+    stopFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stopFd_ < 0) {
+        LOG_ERROR << "LocalControlChannel: eventfd failed: " << strerror(errno);
+        return false;
+    }
+    listenSocket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenSocket_ < 0) {
+        LOG_ERROR << "LocalControlChannel: socket failed: " << strerror(errno);
+        close();
+        return false;
+    }
+
+    // A stale socket from a previous run
+    unlink(socketPath_.c_str());
+    if (bind(listenSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenSocket_, 8) != 0) {
+        LOG_ERROR << "LocalControlChannel: Cannot listen on " << socketPath_ << ": " << strerror(errno);
+        close();
+        return false;
+    }
+
+    watcher_ = std::thread(&LocalControlChannel::watchLoop, this);
+    LOG_INFO << "Local control: listening on " << socketPath_;
+    return true;
+}
+
+void LocalControlChannel::close() {
+    if (watcher_.joinable()) {
+        uint64_t one = 1;
+        if (write(stopFd_, &one, sizeof(one)) < 0) {
+            LOG_WARNING << "LocalControlChannel: Failed to wake the watcher thread";
+        }
+        watcher_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        for (auto& client : clients_) {
+            closeClient(*client);
+        }
+        clients_.clear();
+    }
+    if (listenSocket_ >= 0) {
+        ::close(listenSocket_);
+        listenSocket_ = -1;
+        unlink(socketPath_.c_str());
+    }
+    if (stopFd_ >= 0) {
+        ::close(stopFd_);
+        stopFd_ = -1;
+    }
+}
+
+void LocalControlChannel::closeClient(Client& client) {
+    client.ring.detach();
+    if (client.mapping) {
+        munmap(client.mapping, client.size);
+        client.mapping = nullptr;
+    }
+    for (int* fd : {&client.socket, &client.memFd, &client.eventFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void LocalControlChannel::watchLoop() {
+    ThreadRoles::instance().apply(ThreadRole::OSC);
+    std::vector<pollfd> fds;
+    std::vector<Client*> owners;   // Client of each fds entry (nullptr: stop or listen)
+    for (;;) {
+        fds.clear();
+        owners.clear();
+        fds.push_back(pollfd{stopFd_, POLLIN, 0});
+        fds.push_back(pollfd{listenSocket_, POLLIN, 0});
+        owners.resize(2, nullptr);
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            for (auto& client : clients_) {
+                if (client->socket < 0) {
+                    continue;   // Hung up, drained and removed by drain()
+                }
+                fds.push_back(pollfd{client->eventFd, POLLIN, 0});
+                fds.push_back(pollfd{client->socket, POLLIN, 0});
+                owners.push_back(client.get());
+                owners.push_back(client.get());
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_WARNING << "LocalControlChannel: poll failed: " << strerror(errno);
+            return;
+        }
+        if (fds[0].revents) {
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            acceptClients();
+        }
+
+        bool signalled = false;
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            Client* client = owners[i];
+            if (fds[i].fd == client->eventFd) {
+                uint64_t count;
+                while (read(client->eventFd, &count, sizeof(count)) > 0) {
+                }
+                signalled = true;
+            } else if (client->socket >= 0) {
+                // Controllers never send on the socket: readable means it hung up.
+                // What it queued is still routed; drain() removes it after that
+                ::close(client->socket);
+                client->socket = -1;
+                signalled = true;
+            }
+        }
+        WakeSignal* wake = wake_.load(std::memory_order_acquire);
+        if (signalled && wake) {
+            wake->notify();
+        }
+    }
+}
+
+void LocalControlChannel::acceptClients() {
+    for (;;) {
+        int socketFd = accept4(listenSocket_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socketFd < 0) {
+            return;   // EAGAIN: nobody waiting
+        }
+
+        auto client = std::make_unique<Client>();
+        client->socket = socketFd;
+        client->size = LocalControlRing::sizeFor(capacity_);
+        client->memFd = memfd_create("cuems-videocomposer-control", MFD_CLOEXEC);
+        client->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (client->memFd >= 0 && client->eventFd >= 0 &&
+            ftruncate(client->memFd, static_cast<off_t>(client->size)) == 0) {
+            void* mapping = mmap(nullptr, client->size, PROT_READ | PROT_WRITE, MAP_SHARED, client->memFd, 0);
+            client->mapping = mapping != MAP_FAILED ? mapping : nullptr;
+        }
+        if (!client->mapping || !LocalControlRing::initialize(client->mapping, client->size, capacity_) ||
+            !client->ring.attach(client->mapping, client->size)) {
+            LOG_WARNING << "LocalControlChannel: Cannot create a ring: " << strerror(errno);
+            closeClient(*client);
+            continue;
+        }
+
+        // memfd, then eventfd
+        int handed[2] = {client->memFd, client->eventFd};
+        uint32_t fdCount = 2;
+        iovec iov{};
+        iov.iov_base = &fdCount;
+        iov.iov_len = sizeof(fdCount);
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(handed))] = {};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(handed));
+        std::memcpy(CMSG_DATA(cmsg), handed, sizeof(handed));
+
+        if (sendmsg(socketFd, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(fdCount))) {
+            LOG_WARNING << "LocalControlChannel: Cannot hand the ring to a controller: " << strerror(errno);
+            closeClient(*client);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        clients_.push_back(std::move(client));
+        LOG_INFO << "Local control: controller connected (" << clients_.size() << " total)";
+    }
+}
+
+size_t LocalControlChannel::drain(const std::function<bool()>& canContinue, const Route& route) {
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    size_t count = 0;
+    bool stopped = false;
+    for (auto it = clients_.begin(); it != clients_.end();) {
+        Client& client = **it;
+        bool inBundle = false;
+        while (!stopped) {
+            // The budget only cuts between bundles
+            if (!inBundle && !canContinue()) {
+                stopped = true;
+                break;
+            }
+            if (!client.ring.pop(command_)) {
+                break;
+            }
+            route(command_);
+            inBundle = command_.bundleContinues;
+            count++;
+        }
+        uint64_t drops = client.ring.getDropped();
+        if (drops != client.reportedDrops) {
+            LOG_WARNING << "Local control: controller dropped " << (drops - client.reportedDrops)
+                        << " command(s), its ring was full";
+            client.reportedDrops = drops;
+        }
+        if (client.socket < 0 && !stopped) {
+            closeClient(client);
+            it = clients_.erase(it);
+            LOG_INFO << "Local control: controller disconnected (" << clients_.size() << " left)";
+            continue;
+        }
+        ++it;
+    }
+    return count;
+}
+
+size_t LocalControlChannel::getClientCount() const {
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    return clients_.size();
+}
+
+} // namespace videocomposer
@@ -0,0 +1,93 @@
+/**
+ * LocalControlChannel.h - Remote commands from local controllers over shared memory
+ */
+
+#ifndef VIDEOCOMPOSER_LOCALCONTROLCHANNEL_H
+#define VIDEOCOMPOSER_LOCALCONTROLCHANNEL_H
+
+#include "LocalControlRing.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+class WakeSignal;
+
+/**
+ * LocalControlChannel - Command rings handed to controllers on this machine
+ *
+ * Listens on a Unix socket; every controller that connects gets a ring of
+ * its own (see LocalControlRing.h for the protocol) and an eventfd it
+ * signals after queueing. A watcher thread accepts controllers, notices
+ * them hanging up and turns their eventfd signals into a WakeSignal
+ * notification for the idle render loop. The commands themselves are read
+ * by drain() on the main thread, as decoded records, in queue order per
+ * controller; the caller routes them like OSC messages.
+ */
+class LocalControlChannel {
+public:
+    using Route = std::function<void(const LocalControlRing::Command& command)>;
+
+    LocalControlChannel();
+    ~LocalControlChannel();
+
+    LocalControlChannel(const LocalControlChannel&) = delete;
+    LocalControlChannel& operator=(const LocalControlChannel&) = delete;
+
+    /**
+     * @param socketPath Unix socket controllers connect to (replaced if it exists)
+     * @param capacity Record space of each controller's ring (power of two)
+     */
+    bool open(const std::string& socketPath, uint32_t capacity = LocalControlRing::DEFAULT_CAPACITY);
+    void close();
+    bool isOpen() const { return listenSocket_ >= 0; }
+
+    /** Notified from the watcher thread when a controller signals its eventfd */
+    void setWakeSignal(WakeSignal* wake) { wake_.store(wake, std::memory_order_release); }
+
+    /**
+     * Route the queued commands, controller by controller
+     * @param canContinue Asked before each command outside a bundle; false
+     *                    leaves the rest queued for the next call
+     * @return Commands routed
+     */
+    size_t drain(const std::function<bool()>& canContinue, const Route& route);
+
+    size_t getClientCount() const;
+    const std::string& getSocketPath() const { return socketPath_; }
+
+private:
+    struct Client {
+        int socket = -1;
+        int memFd = -1;
+        int eventFd = -1;
+        void* mapping = nullptr;
+        size_t size = 0;
+        LocalControlRing ring;
+        uint64_t reportedDrops = 0;
+    };
+
+    void watchLoop();
+    void acceptClients();
+    static void closeClient(Client& client);
+
+    std::string socketPath_;
+    uint32_t capacity_;
+    int listenSocket_;
+    int stopFd_;                  // eventfd, signalled by close()
+    std::thread watcher_;
+    std::atomic<WakeSignal*> wake_;
+
+    std::vector<std::unique_ptr<Client>> clients_;
+    mutable std::mutex clientsMutex_;
+    LocalControlRing::Command command_;   // Reused by drain()
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LOCALCONTROLCHANNEL_H
@@ -0,0 +1,271 @@
+#include "LocalControlRing.h"
+#include <cstring>
+#include <new>
+
+namespace videocomposer {
+
+namespace {
+
+constexpr uint32_t RECORD_ALIGNMENT = 8;
+constexpr uint32_t MIN_CAPACITY = 4096;
+
+uint32_t alignRecord(size_t size) {
+    return static_cast<uint32_t>((size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT);
+}
+
+// Bytes an argument takes in a record
+size_t argSize(const CommandArg& arg) {
+    switch (arg.type()) {
+        case CommandArg::Type::INT:
+        case CommandArg::Type::FLOAT:
+            return 1 + 4;
+        case CommandArg::Type::INT64:
+        case CommandArg::Type::DOUBLE:
+            return 1 + 8;
+        case CommandArg::Type::STRING:
+            return 1 + 4 + arg.length();
+    }
+    return 1;
+}
+
+template <typename T>
+uint8_t* put(uint8_t* out, const T& value) {
+    std::memcpy(out, &value, sizeof(value));
+    return out + sizeof(value);
+}
+
+// Reads a value if it lies before end
+template <typename T>
+bool take(const uint8_t*& in, const uint8_t* end, T& value) {
+    if (static_cast<size_t>(end - in) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return true;
+}
+
+} // namespace
+
+size_t LocalControlRing::sizeFor(uint32_t capacity) {
+    return ctl::DATA_OFFSET + capacity;
+}
+
+bool LocalControlRing::initialize(void* memory, size_t size, uint32_t capacity) {
+    if (!memory || capacity < MIN_CAPACITY || (capacity & (capacity - 1)) != 0 || size < sizeFor(capacity)) {
+        return false;
+    }
+    ctl::RingHeader* header = new (memory) ctl::RingHeader();
+    header->magic = ctl::RING_MAGIC;
+    header->version = ctl::RING_VERSION;
+    header->capacity = capacity;
+    header->dataOffset = ctl::DATA_OFFSET;
+    header->head.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_release);
+    return true;
+}
+
+bool LocalControlRing::attach(void* memory, size_t size) {
+    detach();
+    if (!memory || size < sizeof(ctl::RingHeader)) {
+        return false;
+    }
+    ctl::RingHeader* header = static_cast<ctl::RingHeader*>(memory);
+    uint32_t capacity = header->capacity;
+    if (header->magic != ctl::RING_MAGIC || header->version != ctl::RING_VERSION ||
+        header->dataOffset != ctl::DATA_OFFSET || capacity < MIN_CAPACITY ||
+        (capacity & (capacity - 1)) != 0 || size < sizeFor(capacity)) {
+        return false;
+    }
+    header_ = header;
+    data_ = static_cast<uint8_t*>(memory) + ctl::DATA_OFFSET;
+    mask_ = capacity - 1;
+    return true;
+}
+
+void LocalControlRing::detach() {
+    header_ = nullptr;
+    data_ = nullptr;
+    mask_ = 0;
+}
+
+bool LocalControlRing::push(std::string_view path, const CommandArgs& args, bool bundleContinues, int64_t atUs) {
+    if (!header_) {
+        return false;
+    }
+    size_t size = sizeof(ctl::RecordHeader) + path.size();
+    for (const CommandArg& arg : args) {
+        size += argSize(arg);
+    }
+    uint32_t capacity = mask_ + 1;
+    if (path.empty() || path.size() > 0xFFFF || args.size() > MAX_ARGS || size > capacity / 2) {
+        return false;
+    }
+    uint32_t need = alignRecord(size);
+
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    uint32_t offset = static_cast<uint32_t>(head & mask_);
+    uint32_t pad = offset + need > capacity ? capacity - offset : 0;
+    if (capacity - (head - tail) < static_cast<uint64_t>(pad) + need) {
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (pad > 0) {
+        ctl::RecordHeader padding{};
+        padding.size = pad;
+        padding.flags = ctl::RECORD_PAD;
+        std::memcpy(data_ + offset, &padding, sizeof(padding) <= pad ? sizeof(padding) : pad);
+        offset = 0;
+    }
+
+    uint8_t* out = data_ + offset;
+    ctl::RecordHeader record{};
+    record.size = need;
+    record.pathLength = static_cast<uint16_t>(path.size());
+    record.flags = bundleContinues ? ctl::RECORD_BUNDLE_CONTINUES : 0;
+    record.argCount = static_cast<uint8_t>(args.size());
+    record.atUs = atUs;
+    out = put(out, record);
+    std::memcpy(out, path.data(), path.size());
+    out += path.size();
+    for (const CommandArg& arg : args) {
+        switch (arg.type()) {
+            case CommandArg::Type::INT:
+                *out++ = 'i';
+                out = put(out, static_cast<int32_t>(arg.toInt()));
+                break;
+            case CommandArg::Type::INT64:
+                *out++ = 'h';
+                out = put(out, arg.toInt64());
+                break;
+            case CommandArg::Type::FLOAT:
+                *out++ = 'f';
+                out = put(out, arg.toFloat());
+                break;
+            case CommandArg::Type::DOUBLE:
+                *out++ = 'd';
+                out = put(out, arg.toDouble());
+                break;
+            case CommandArg::Type::STRING: {
+                *out++ = 's';
+                std::string_view text = arg.view();
+                out = put(out, static_cast<uint32_t>(text.size()));
+                std::memcpy(out, text.data(), text.size());
+                out += text.size();
+                break;
+            }
+        }
+    }
+    std::memset(out, 0, need - size);
+
+    header_->head.store(head + pad + need, std::memory_order_release);
+    return true;
+}
+
+bool LocalControlRing::pop(Command& command) {
+    if (!header_) {
+        return false;
+    }
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    uint32_t capacity = mask_ + 1;
+    while (tail != head) {
+        uint64_t queued = head - tail;
+        uint32_t offset = static_cast<uint32_t>(tail & mask_);
+        uint32_t size = 0;
+        std::memcpy(&size, data_ + offset, sizeof(size));
+        uint8_t flags = data_[offset + offsetof(ctl::RecordHeader, flags)];
+        bool valid = queued <= capacity && size >= RECORD_ALIGNMENT && size % RECORD_ALIGNMENT == 0 &&
+                     size <= capacity - offset && size <= queued;
+        if (valid && (flags & ctl::RECORD_PAD)) {
+            tail += size;
+            header_->tail.store(tail, std::memory_order_release);
+            continue;
+        }
+        if (!valid || size < sizeof(ctl::RecordHeader) || !decode(data_ + offset, size, command)) {
+            // Nothing after a broken record can be trusted to line up
+            malformed_++;
+            header_->tail.store(head, std::memory_order_release);
+            return false;
+        }
+        header_->tail.store(tail + size, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+bool LocalControlRing::decode(const uint8_t* record, uint32_t size, Command& command) const {
+    const uint8_t* end = record + size;
+    ctl::RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    const uint8_t* in = record + sizeof(header);
+    if (static_cast<size_t>(end - in) < header.pathLength || header.pathLength == 0) {
+        return false;
+    }
+    command.path.assign(reinterpret_cast<const char*>(in), header.pathLength);
+    in += header.pathLength;
+    command.bundleContinues = (header.flags & ctl::RECORD_BUNDLE_CONTINUES) != 0;
+    command.atUs = header.atUs;
+    command.args.clear();
+
+    for (uint8_t i = 0; i < header.argCount; ++i) {
+        uint8_t type = 0;
+        if (!take(in, end, type)) {
+            return false;
+        }
+        switch (type) {
+            case 'i': {
+                int32_t value;
+                if (!take(in, end, value)) {
+                    return false;
+                }
+                command.args.addInt(value);
+                break;
+            }
+            case 'h': {
+                int64_t value;
+                if (!take(in, end, value)) {
+                    return false;
+                }
+                command.args.addInt64(value);
+                break;
+            }
+            case 'f': {
+                float value;
+                if (!take(in, end, value)) {
+                    return false;
+                }
+                command.args.addFloat(value);
+                break;
+            }
+            case 'd': {
+                double value;
+                if (!take(in, end, value)) {
+                    return false;
+                }
+                command.args.addDouble(value);
+                break;
+            }
+            case 's': {
+                uint32_t length;
+                if (!take(in, end, length) || static_cast<size_t>(end - in) < length) {
+                    return false;
+                }
+                command.args.addString(std::string_view(reinterpret_cast<const char*>(in), length));
+                in += length;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+uint64_t LocalControlRing::getDropped() const {
+    return header_ ? header_->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,143 @@
+/**
+ * LocalControlRing.h - Shared-memory command ring of the local control channel
+ *
+ * A controller on the same machine queues remote commands here instead of
+ * sending them as OSC over UDP: no network stack, no liblo decoding, the
+ * records map one to one onto RemoteCommandRouter paths and CommandArgs.
+ *
+ * Connecting: the controller connects to the channel's Unix socket (see
+ * LocalControlChannel) and receives one message: a uint32_t fd count, with
+ * SCM_RIGHTS carrying the ring memfd and an eventfd. It maps the memfd,
+ * writes records and signals the eventfd (write 8 bytes, any value) after
+ * publishing them, so an idle render loop wakes. Closing the socket ends
+ * the session. The layout is fixed for the ABI (little-endian, offsets
+ * checked below) so tools in other languages can write it directly.
+ *
+ * Header at offset 0; records from dataOffset, in a space of capacity bytes
+ * (a power of two) addressed by head and tail modulo capacity:
+ *   head     bytes written, moved by the controller after writing a record
+ *   tail     bytes consumed, moved by the composer
+ *   dropped  commands the controller found no room for (it counts them)
+ * Free space is capacity - (head - tail). A record starts 8-byte aligned
+ * and never wraps: if it does not fit before the end of the space, a pad
+ * record (size = bytes to the end, flags = RECORD_PAD) fills the rest and
+ * the record starts at offset 0.
+ *
+ * Record: RecordHeader, the path (pathLength bytes, no NUL), then argCount
+ * arguments, each a type byte followed by its value, in the OSC type letters:
+ *   'i' int32   'h' int64   'f' float   'd' double   's' uint32 length + bytes
+ * padded with zeros to a multiple of 8. Bundles: every record of a bundle
+ * but the last has RECORD_BUNDLE_CONTINUES; written with one head move
+ * after the last record, the bundle is routed on one frame. A record with
+ * atUs runs at that wall-clock time, like a timetag.
+ */
+
+#ifndef VIDEOCOMPOSER_LOCALCONTROLRING_H
+#define VIDEOCOMPOSER_LOCALCONTROLRING_H
+
+#include "CommandArgs.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace videocomposer {
+namespace ctl {
+
+constexpr uint32_t RING_MAGIC = 0x52434356;   // "VCCR"
+constexpr uint32_t RING_VERSION = 1;
+constexpr uint32_t DATA_OFFSET = 256;
+
+enum RecordFlags : uint8_t {
+    RECORD_PAD = 0x01,                // Skip to the start of the space
+    RECORD_BUNDLE_CONTINUES = 0x02    // More records of the same bundle follow
+};
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;                          // Bytes of record space (power of two)
+    uint32_t dataOffset;                        // Offset of the record space
+    alignas(64) std::atomic<uint64_t> head;     // Controller
+    std::atomic<uint64_t> dropped;              // Controller
+    alignas(64) std::atomic<uint64_t> tail;     // Composer
+};
+
+struct RecordHeader {
+    uint32_t size;          // Whole record, header and padding included (multiple of 8)
+    uint16_t pathLength;
+    uint8_t flags;          // RecordFlags
+    uint8_t argCount;
+    int64_t atUs;           // Unix microseconds to run at (0 = immediately)
+};
+
+static_assert(offsetof(RingHeader, head) == 64, "ring header layout");
+static_assert(offsetof(RingHeader, dropped) == 72, "ring header layout");
+static_assert(offsetof(RingHeader, tail) == 128, "ring header layout");
+static_assert(sizeof(RingHeader) <= DATA_OFFSET, "ring header grew");
+static_assert(sizeof(RecordHeader) == 16, "record header layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring needs lock-free 64-bit atomics");
+
+} // namespace ctl
+
+/**
+ * LocalControlRing - Writes and reads command records in a mapped ring
+ *
+ * One writer (the controller) and one reader (the composer's main thread)
+ * per ring. The reader checks every record against the space it claims
+ * and drops the queued records at the first malformed one, so a broken
+ * controller cannot make it read outside the ring.
+ */
+class LocalControlRing {
+public:
+    static constexpr uint32_t DEFAULT_CAPACITY = 256 * 1024;
+    static constexpr uint8_t MAX_ARGS = 255;
+
+    /** Decoded record, reused between pop() calls */
+    struct Command {
+        std::string path;
+        CommandArgs args;
+        bool bundleContinues = false;
+        int64_t atUs = 0;
+    };
+
+    /** Bytes of memory a ring of this capacity takes */
+    static size_t sizeFor(uint32_t capacity);
+
+    /**
+     * Lay out an empty ring
+     * @param capacity Record space, a power of two of at least 4096
+     */
+    static bool initialize(void* memory, size_t size, uint32_t capacity);
+
+    /** Use a ring laid out by initialize() (false if not a valid ring) */
+    bool attach(void* memory, size_t size);
+    void detach();
+    bool isAttached() const { return header_ != nullptr; }
+
+    // ===== Writer =====
+
+    /** @return false if there is no room (counted in dropped) or the command does not fit a record */
+    bool push(std::string_view path, const CommandArgs& args, bool bundleContinues = false, int64_t atUs = 0);
+
+    // ===== Reader =====
+
+    /** Oldest record into command; false if none (or the ring was malformed) */
+    bool pop(Command& command);
+
+    uint64_t getDropped() const;
+    uint64_t getMalformed() const { return malformed_; }
+
+private:
+    bool decode(const uint8_t* record, uint32_t size, Command& command) const;
+
+    ctl::RingHeader* header_ = nullptr;
+    uint8_t* data_ = nullptr;
+    uint32_t mask_ = 0;
+    uint64_t malformed_ = 0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LOCALCONTROLRING_H
@@ -1,9 +1,13 @@
 #include "OSCRemoteControl.h"
+#include "ControlCapture.h"
 #include "../VideoComposerApplication.h"
 #include "../layer/LayerManager.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/WakeSignal.h"
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
-#include <sstream>
 #include <chrono>
 
 extern "C" {
@@ -18,8 +22,18 @@ static void oscErrorHandler(int num, const char* msg, const char* path) {
 
 OSCRemoteControl::OSCRemoteControl(VideoComposerApplication* app, LayerManager* layerManager)
     : oscServer_(nullptr)
+    , groupServer_(nullptr)
     , router_(std::make_unique<RemoteCommandRouter>(app, layerManager))
     , userData_(nullptr)
+    , receiving_(false)
+    , wake_(nullptr)
+    , slots_(MAX_QUEUED_COMMANDS)
+    , queueHead_(0)
+    , queueTail_(0)
+    , queueWrite_(0)
+    , bundleDepth_(0)
+    , bundleTimeUs_()
+    , droppedCommands_(0)
     , port_(7000)
     , active_(false)
 {
@@ -50,6 +64,11 @@ bool OSCRemoteControl::initialize(int port) {
 
     // Register catch-all handler
     lo_server_add_method(oscServer_, nullptr, nullptr, handleOSCMessage, userData_);
+    
+    // Bundles reach the main thread whole; timetagged ones are dispatched
+    // now and scheduled against presentation time, not held by liblo
+    lo_server_add_bundle_handlers(oscServer_, handleBundleStart, handleBundleEnd, userData_);
+    lo_server_enable_queue(oscServer_, 0, 1);
 
     // Register specific methods for compatibility with existing OSC interface
     lo_server_add_method(oscServer_, "/videocomposer/quit", "", handleOSCMessage, userData_);
@@ -67,6 +86,11 @@ bool OSCRemoteControl::initialize(int port) {
     lo_server_add_method(oscServer_, "/videocomposer/osd/frame", "i", handleOSCMessage, userData_);
     lo_server_add_method(oscServer_, "/videocomposer/osd/box", "i", handleOSCMessage, userData_);
     lo_server_add_method(oscServer_, "/videocomposer/osd/text", "s", handleOSCMessage, userData_);
+    
+    // Show preparation and diagnostics
+    lo_server_add_method(oscServer_, "/videocomposer/show/prewarm", NULL, handleOSCMessage, userData_);  // One or more s paths
+    lo_server_add_method(oscServer_, "/videocomposer/stats/framepool", NULL, handleOSCMessage, userData_);  // Optional s "reset"
+    lo_server_add_method(oscServer_, "/videocomposer/stats/hapdecode", NULL, handleOSCMessage, userData_);  // Optional s "reset"
 
     // Layer-level commands
     lo_server_add_method(oscServer_, "/videocomposer/layer/add", "s", handleOSCMessage, userData_);
@@ -86,7 +110,10 @@ bool OSCRemoteControl::initialize(int port) {
     
     // New file loading commands
     lo_server_add_method(oscServer_, "/videocomposer/layer/load", "ss", handleOSCMessage, userData_);
+    lo_server_add_method(oscServer_, "/videocomposer/layer/load", "ssi", handleOSCMessage, userData_);  // With load priority (0-2)
     lo_server_add_method(oscServer_, "/videocomposer/layer/unload", "s", handleOSCMessage, userData_);
+    lo_server_add_method(oscServer_, "/videocomposer/layer/prioritize", "s", handleOSCMessage, userData_);   // Cue goes next
+    lo_server_add_method(oscServer_, "/videocomposer/layer/prioritize", "si", handleOSCMessage, userData_);
     lo_server_add_method(oscServer_, "/videocomposer/layer/*/file", "s", handleOSCMessage, userData_);
     
     // Loop and auto-unload commands
@@ -101,6 +128,11 @@ bool OSCRemoteControl::initialize(int port) {
     lo_server_add_method(oscServer_, "/videocomposer/layer/*/offset", "i", handleOSCMessage, userData_);
     lo_server_add_method(oscServer_, "/videocomposer/layer/*/offset", "s", handleOSCMessage, userData_);
     lo_server_add_method(oscServer_, "/videocomposer/layer/*/mtcfollow", "i", handleOSCMessage, userData_);
+    lo_server_add_method(oscServer_, "/videocomposer/layer/*/arm", "", handleOSCMessage, userData_);   // Standby at frame 0
+    lo_server_add_method(oscServer_, "/videocomposer/layer/*/arm", "i", handleOSCMessage, userData_);
+    lo_server_add_method(oscServer_, "/videocomposer/layer/*/arm", "s", handleOSCMessage, userData_);  // SMPTE start
+    lo_server_add_method(oscServer_, "/videocomposer/layer/*/go", "", handleOSCMessage, userData_);
+    lo_server_add_method(oscServer_, "/videocomposer/layer/*/cues", NULL, handleOSCMessage, userData_);  // Any number of i/s cue times
     
     // Transform commands
     lo_server_add_method(oscServer_, "/videocomposer/layer/*/scale", "ff", handleOSCMessage, userData_);
@@ -154,17 +186,82 @@ bool OSCRemoteControl::initialize(int port) {
     lo_server_add_method(oscServer_, "/videocomposer/master/gamma", "f", handleOSCMessage, userData_);
     lo_server_add_method(oscServer_, "/videocomposer/master/color/reset", "", handleOSCMessage, userData_);
 
+    // Receive on a thread; handlers only queue commands
+    receiving_ = true;
+    receiveThread_ = std::thread(&OSCRemoteControl::receiveLoop, this);
+
     active_ = true;
     return true;
 }
 
+void OSCRemoteControl::receiveLoop() {
+    ThreadRoles::instance().apply(ThreadRole::OSC);
+    while (receiving_) {
+        // Short timeout so shutdown() does not wait long
+        if (groupServer_) {
+            lo_server servers[2] = {oscServer_, groupServer_};
+            int received[2] = {0, 0};
+            lo_servers_recv_noblock(servers, received, 2, 50);
+        } else {
+            lo_server_recv_noblock(oscServer_, 50);
+        }
+    }
+}
+
+bool OSCRemoteControl::joinGroup(const std::string& target) {
+    size_t colon = target.rfind(':');
+    if (!active_ || colon == std::string::npos || colon == 0) {
+        LOG_WARNING << "OSC: Cannot join group '" << target << "' (expected group:port)";
+        return false;
+    }
+    // The receive thread reads the servers: stopped while they change
+    receiving_ = false;
+    if (receiveThread_.joinable()) {
+        receiveThread_.join();
+    }
+    if (groupServer_) {
+        lo_server_free(groupServer_);
+    }
+    groupServer_ = lo_server_new_multicast(target.substr(0, colon).c_str(),
+                                           target.substr(colon + 1).c_str(), oscErrorHandler);
+    if (groupServer_) {
+        // Catch-all, bundles handled like the control port's
+        lo_server_add_method(groupServer_, nullptr, nullptr, handleOSCMessage, userData_);
+        lo_server_add_bundle_handlers(groupServer_, handleBundleStart, handleBundleEnd, userData_);
+        lo_server_enable_queue(groupServer_, 0, 1);
+        LOG_INFO << "OSC: Receiving group " << target;
+    } else {
+        LOG_WARNING << "OSC: Cannot join group " << target;
+    }
+    receiving_ = true;
+    receiveThread_ = std::thread(&OSCRemoteControl::receiveLoop, this);
+    return groupServer_ != nullptr;
+}
+
+void OSCRemoteControl::setWakeSignal(WakeSignal* wake) {
+    wake_.store(wake, std::memory_order_release);
+    if (localChannel_) {
+        localChannel_->setWakeSignal(wake);
+    }
+}
+
+bool OSCRemoteControl::openLocalChannel(const std::string& socketPath) {
+    auto channel = std::make_unique<LocalControlChannel>();
+    if (!channel->open(socketPath)) {
+        return false;
+    }
+    channel->setWakeSignal(wake_.load(std::memory_order_acquire));
+    localChannel_ = std::move(channel);
+    return true;
+}
+
 int OSCRemoteControl::process() {
     if (!active_ || !oscServer_) {
         return 0;
     }
 
     // Use time-based budget to ensure video playback always has priority
-    // Spend up to 2ms processing OSC messages per frame
+    // Spend up to 2ms routing OSC commands per frame
     // This ensures video rendering (60fps = 16.67ms per frame) is never blocked
     // Video playback has absolute priority - OSC processing is secondary
     const auto MAX_TIME_BUDGET = std::chrono::microseconds(2000); // 2ms max per frame (12% of frame time)
@@ -173,26 +270,82 @@ int OSCRemoteControl::process() {
     auto startTime = std::chrono::high_resolution_clock::now();
     int count = 0;
     
-    while (count < MAX_MESSAGES_PER_FRAME) {
-        auto elapsed = std::chrono::high_resolution_clock::now() - startTime;
-        if (elapsed >= MAX_TIME_BUDGET) {
-            // Time budget exceeded - stop processing to preserve video playback priority
-            break;
+    // Only what was queued when the frame started: a flood arriving now
+    // waits for the next frame instead of stretching this one
+    uint64_t head = queueHead_.load(std::memory_order_relaxed);
+    uint64_t tail = queueTail_.load(std::memory_order_acquire);
+    bool inBundle = false;
+    
+    // --replay-control: the recorded commands played this frame, routed
+    // as if they had just arrived (outside the budget, like a bundle)
+    count += static_cast<int>(ControlReplay::instance().takeCommands(
+        [this](const std::string& path, const CommandArgs& args, int64_t atUs) {
+            if (atUs != 0) {
+                router_->scheduleAtTime(atUs, path, args);
+            } else {
+                router_->routeCommand(path, args);
+            }
+        }));
+    
+    while (head != tail) {
+        // The budget only cuts between bundles
+        if (!inBundle) {
+            auto elapsed = std::chrono::high_resolution_clock::now() - startTime;
+            if (count >= MAX_MESSAGES_PER_FRAME || elapsed >= MAX_TIME_BUDGET) {
+                // Time budget exceeded - the rest waits for the next frame
+                break;
+            }
         }
         
-        int result = lo_server_recv_noblock(oscServer_, 0);
-        if (result <= 0) {
-            // No more messages available
-            break;
+        // Published slots are not touched by the receive thread
+        const Command& command = slots_[head & (MAX_QUEUED_COMMANDS - 1)];
+        if (command.atUs != 0) {
+            router_->scheduleAtTime(command.atUs, command.path, command.args);
+        } else {
+            router_->routeCommand(command.path, command.args);
         }
-        
+        inBundle = command.bundleContinues;
+        queueHead_.store(++head, std::memory_order_release);
         count++;
     }
     
+    if (localChannel_ && !inBundle) {
+        // Local controllers: records decode straight into router commands
+        localChannel_->drain(
+            [&]() {
+                return count < MAX_MESSAGES_PER_FRAME &&
+                       std::chrono::high_resolution_clock::now() - startTime < MAX_TIME_BUDGET;
+            },
+            [&](const LocalControlRing::Command& command) {
+                if (ControlCapture::instance().isRecording()) {
+                    ControlCapture::instance().recordCommand(command.path, command.args, command.atUs);
+                }
+                if (command.atUs != 0) {
+                    router_->scheduleAtTime(command.atUs, command.path, command.args);
+                } else {
+                    router_->routeCommand(command.path, command.args);
+                }
+                count++;
+            });
+    }
+    
     return count;
 }
 
 void OSCRemoteControl::shutdown() {
+    receiving_ = false;
+    if (receiveThread_.joinable()) {
+        receiveThread_.join();
+    }
+    localChannel_.reset();
+    queueHead_ = 0;
+    queueTail_ = 0;
+    queueWrite_ = 0;
+    bundleDepth_ = 0;
+    if (groupServer_) {
+        lo_server_free(groupServer_);
+        groupServer_ = nullptr;
+    }
     if (oscServer_) {
         lo_server_free(oscServer_);
         oscServer_ = nullptr;
@@ -201,9 +354,83 @@ void OSCRemoteControl::shutdown() {
         delete userData_;
         userData_ = nullptr;
     }
+    for (auto& entry : addresses_) {
+        lo_address_free(entry.second);
+    }
+    addresses_.clear();
     active_ = false;
 }
 
+lo_address OSCRemoteControl::resolveAddress(const std::string& target) {
+    auto it = addresses_.find(target);
+    if (it != addresses_.end()) {
+        return it->second;
+    }
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        LOG_WARNING << "OSC: Invalid destination '" << target << "' (expected host:port)";
+        return nullptr;
+    }
+    lo_address address = lo_address_new(target.substr(0, colon).c_str(), target.substr(colon + 1).c_str());
+    if (!address) {
+        LOG_WARNING << "OSC: Cannot resolve destination " << target;
+        return nullptr;
+    }
+    addresses_.emplace(target, address);
+    return address;
+}
+
+bool OSCRemoteControl::sendMessage(const std::string& target, const std::string& path,
+                                   const std::string& label, const std::vector<double>& values) {
+    lo_address address = resolveAddress(target);
+    if (!address) {
+        return false;
+    }
+
+    lo_message msg = lo_message_new();
+    if (!label.empty()) {
+        lo_message_add_string(msg, label.c_str());
+    }
+    for (double value : values) {
+        lo_message_add_double(msg, value);
+    }
+    int ret = lo_send_message(address, path.c_str(), msg);
+    lo_message_free(msg);
+    return ret >= 0;
+}
+
+bool OSCRemoteControl::sendData(const std::string& target, const std::string& path,
+                                const std::vector<std::string>& strings, const std::vector<double>& values,
+                                const std::string& data) {
+    lo_address address = resolveAddress(target);
+    if (!address) {
+        return false;
+    }
+
+    lo_message msg = lo_message_new();
+    for (const std::string& string : strings) {
+        lo_message_add_string(msg, string.c_str());
+    }
+    for (double value : values) {
+        lo_message_add_double(msg, value);
+    }
+    lo_blob blob = nullptr;
+    if (!data.empty()) {
+        blob = lo_blob_new(static_cast<int32_t>(data.size()), data.data());
+        lo_message_add_blob(msg, blob);
+    }
+    int ret = lo_send_message(address, path.c_str(), msg);
+    lo_message_free(msg);
+    if (blob) {
+        lo_blob_free(blob);
+    }
+    return ret >= 0;
+}
+
+size_t OSCRemoteControl::runScheduled(int64_t frame, int64_t presentationUs) {
+    return router_->runScheduled(frame, presentationUs);
+}
+
 bool OSCRemoteControl::isActive() const {
     return active_ && oscServer_ != nullptr;
 }
@@ -216,49 +443,119 @@ int OSCRemoteControl::handleOSCMessage(const char* path, const char* types,
         return 1;
     }
 
-    // Convert OSC arguments to string vector
-    std::vector<std::string> args = data->instance->convertOSCArgs(types, argv, argc);
+    // Receive thread: decode here, route on the main thread in process()
+    OSCRemoteControl* self = data->instance;
+    uint64_t write = self->queueWrite_;
+    if (write - self->queueHead_.load(std::memory_order_acquire) >= MAX_QUEUED_COMMANDS) {
+        // Count and report only the first of a burst
+        if (self->droppedCommands_++ == 0) {
+            LOG_WARNING << "OSC: Command queue full, dropping commands";
+        }
+        return 0;
+    }
+    if (self->droppedCommands_ > 0) {
+        LOG_WARNING << "OSC: Command queue recovered (" << self->droppedCommands_ << " commands dropped)";
+        self->droppedCommands_ = 0;
+    }
+
+    // Free slot, only this thread writes it; its storage is reused
+    Command& command = self->slots_[write & (MAX_QUEUED_COMMANDS - 1)];
+    command.path.assign(path);
+    convertOSCArgs(types, argv, argc, command.args);
+    command.bundleContinues = self->bundleDepth_ > 0;
+    command.atUs = self->bundleDepth_ > 0
+        ? self->bundleTimeUs_[std::min(self->bundleDepth_, MAX_BUNDLE_DEPTH) - 1]
+        : 0;
+    self->queueWrite_ = write + 1;
+    if (ControlCapture::instance().isRecording()) {
+        ControlCapture::instance().recordCommand(command.path, command.args, command.atUs);
+    }
+
+    // Inside a bundle the slots are published when it ends
+    if (self->bundleDepth_ == 0) {
+        self->queueTail_.store(self->queueWrite_, std::memory_order_release);
+        self->notifyWake();
+    }
+
+    // Consumed: the catch-all handler must not queue it again
+    return 0;
+}
+
+int OSCRemoteControl::handleBundleStart(lo_timetag time, void* userData) {
+    OSCUserData* data = static_cast<OSCUserData*>(userData);
+    if (!data || !data->instance) {
+        return 0;
+    }
+    OSCRemoteControl* self = data->instance;
+    int depth = self->bundleDepth_++;
+    if (depth >= MAX_BUNDLE_DEPTH) {
+        return 0;  // Deeper bundles use the deepest timetag kept
+    }
+    // 0.1 is "immediately": a nested bundle then keeps its parent's time
+    bool immediate = time.sec == 0 && time.frac == 1;
+    int64_t parentUs = depth > 0 ? self->bundleTimeUs_[depth - 1] : 0;
+    self->bundleTimeUs_[depth] = immediate ? parentUs : CommandScheduler::timetagToUnixUs(time.sec, time.frac);
+    return 0;
+}
 
-    // Route command
-    std::string pathStr(path);
-    bool handled = data->instance->router_->routeCommand(pathStr, args);
+int OSCRemoteControl::handleBundleEnd(void* userData) {
+    OSCUserData* data = static_cast<OSCUserData*>(userData);
+    if (!data || !data->instance) {
+        return 0;
+    }
+    OSCRemoteControl* self = data->instance;
+    if (self->bundleDepth_ > 0 && --self->bundleDepth_ > 0) {
+        return 0;  // Nested bundle: the outer one publishes
+    }
+    uint64_t tail = self->queueTail_.load(std::memory_order_relaxed);
+    if (self->queueWrite_ != tail) {
+        // Last message of the bundle ends it for process()
+        self->slots_[(self->queueWrite_ - 1) & (MAX_QUEUED_COMMANDS - 1)].bundleContinues = false;
+        self->queueTail_.store(self->queueWrite_, std::memory_order_release);
+        self->notifyWake();
+    }
+    return 0;
+}
 
-    return handled ? 0 : 1;
+void OSCRemoteControl::notifyWake() {
+    WakeSignal* wake = wake_.load(std::memory_order_acquire);
+    if (wake) {
+        wake->notify();
+    }
 }
 
-std::vector<std::string> OSCRemoteControl::convertOSCArgs(const char* types, lo_arg** argv, int argc) {
-    std::vector<std::string> args;
-    args.reserve(argc);
+void OSCRemoteControl::convertOSCArgs(const char* types, lo_arg** argv, int argc, CommandArgs& args) {
+    args.clear();
 
     for (int i = 0; i < argc && types[i] != '\0'; ++i) {
-        std::ostringstream oss;
         switch (types[i]) {
             case 'i':
-                oss << argv[i]->i;
+                args.addInt(argv[i]->i);
                 break;
             case 'f':
-                oss << argv[i]->f;
+                args.addFloat(argv[i]->f);
                 break;
             case 's':
-                oss << &argv[i]->s;
+                args.addString(&argv[i]->s);
                 break;
             case 'd':
-                oss << argv[i]->d;
+                args.addDouble(argv[i]->d);
                 break;
             case 'h':
-                oss << argv[i]->h;
+                args.addInt64(argv[i]->h);
                 break;
-            case 't':
-                oss << argv[i]->t.sec << "." << argv[i]->t.frac;
+            case 't': {
+                // Rare: kept as the "sec.frac" text handlers used to get
+                char text[32];
+                std::snprintf(text, sizeof(text), "%u.%u", argv[i]->t.sec, argv[i]->t.frac);
+                args.addString(text);
                 break;
+            }
             default:
                 // Unknown type, skip
                 continue;
         }
-        args.push_back(oss.str());
     }
-
-    return args;
 }
 
 } // namespace videocomposer
@@ -3,8 +3,12 @@
 
 #include "RemoteControl.h"
 #include "RemoteCommandRouter.h"
+#include "LocalControlChannel.h"
+#include <atomic>
+#include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 extern "C" {
@@ -23,6 +27,20 @@ class LayerManager;
  * Implements RemoteControl interface using liblo for OSC protocol.
  * This is the only remote control implementation for now, but the architecture
  * is ready for future implementations (MessageQueue, IPC, etc.).
+ *
+ * The socket is read and messages are decoded on a receive thread; process()
+ * only routes already decoded commands on the main thread, so control
+ * traffic never makes the render loop wait on the network. Messages are
+ * decoded in place into a fixed ring of slots whose storage is reused, so
+ * a steady stream of property updates does not allocate.
+ *
+ * The ring is lock-free (one producer, the receive thread; one consumer,
+ * the main thread). process() runs once per frame before the layers are
+ * updated and drains what was queued when it started, so all commands it
+ * applies show on the same frame. An OSC bundle is published to the ring
+ * when it ends and never split across frames by the time budget. A bundle
+ * with a timetag is not run when it arrives: its commands are scheduled
+ * for the first render presented at or after that time.
  */
 class OSCRemoteControl : public RemoteControl {
 public:
@@ -35,10 +53,35 @@ public:
     void shutdown() override;
     bool isActive() const override;
     const char* getProtocolName() const override { return "OSC"; }
+    
+    size_t runScheduled(int64_t frame, int64_t presentationUs) override;
+    size_t getScheduledCount() const override { return router_->getScheduledCount(); }
+    
+    /** Notified from the receive thread as messages are published */
+    void setWakeSignal(WakeSignal* wake) override;
+    
+    /**
+     * Send an OSC message over UDP (label as 's', values as 'd')
+     * @param target "host:port"
+     */
+    bool sendMessage(const std::string& target, const std::string& path,
+                     const std::string& label, const std::vector<double>& values) override;
+    
+    /** Strings as 's', values as 'd', data as a blob 'b' */
+    bool sendData(const std::string& target, const std::string& path,
+                  const std::vector<std::string>& strings, const std::vector<double>& values,
+                  const std::string& data) override;
+    
+    /** Second server on the group's port, read by the same receive thread */
+    bool joinGroup(const std::string& target) override;
+    
+    /** Drained by process() after the OSC messages, in the same time budget */
+    bool openLocalChannel(const std::string& socketPath) override;
 
 private:
     // OSC server
     lo_server oscServer_;
+    lo_server groupServer_;     // Multicast group (joinGroup), or nullptr
     std::unique_ptr<RemoteCommandRouter> router_;
 
     // OSC user data (for callbacks)
@@ -51,9 +94,51 @@ private:
     static int handleOSCMessage(const char* path, const char* types, 
                                  lo_arg** argv, int argc, lo_message msg, 
                                  void* userData);
+    static int handleBundleStart(lo_timetag time, void* userData);
+    static int handleBundleEnd(void* userData);
     
-    // Convert OSC arguments to string vector
-    std::vector<std::string> convertOSCArgs(const char* types, lo_arg** argv, int argc);
+    // Convert OSC arguments to typed command arguments
+    static void convertOSCArgs(const char* types, lo_arg** argv, int argc, CommandArgs& args);
+
+    // Decoded message waiting to be routed on the main thread
+    struct Command {
+        std::string path;
+        CommandArgs args;
+        bool bundleContinues = false;  // More messages of the same bundle follow
+        int64_t atUs = 0;              // Bundle timetag, Unix microseconds (0 = immediately)
+    };
+    
+    // Bursts beyond this are dropped rather than growing without bound
+    // (power of two: ring positions wrap with a mask)
+    static constexpr size_t MAX_QUEUED_COMMANDS = 4096;
+    static_assert((MAX_QUEUED_COMMANDS & (MAX_QUEUED_COMMANDS - 1)) == 0, "ring size must be a power of two");
+    
+    void receiveLoop();
+    void notifyWake();   // Receive thread, after publishing slots
+    lo_address resolveAddress(const std::string& target);   // Cached in addresses_
+    
+    std::thread receiveThread_;
+    std::atomic<bool> receiving_;
+    std::atomic<WakeSignal*> wake_;   // Idle render loop (RemoteControl::setWakeSignal)
+    
+    // Ring of slots: the receive thread fills the slots after queueTail_ and
+    // publishes them by moving it, the main thread routes the slot at
+    // queueHead_ in place, then frees it by moving queueHead_
+    std::vector<Command> slots_;
+    std::atomic<uint64_t> queueHead_;
+    std::atomic<uint64_t> queueTail_;
+    
+    // Receive thread only
+    uint64_t queueWrite_;      // Next slot to fill (ahead of queueTail_ inside a bundle)
+    int bundleDepth_;
+    static constexpr int MAX_BUNDLE_DEPTH = 8;
+    int64_t bundleTimeUs_[MAX_BUNDLE_DEPTH];  // Timetag per nesting level (0 = immediately)
+    uint64_t droppedCommands_;
+
+    std::unique_ptr<LocalControlChannel> localChannel_;
+
+    // Outbound destinations, by "host:port" (main thread only)
+    std::map<std::string, lo_address> addresses_;
 
     // Port
     int port_;
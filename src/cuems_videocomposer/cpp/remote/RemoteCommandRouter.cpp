@@ -1,440 +1,711 @@
 #include "RemoteCommandRouter.h"
+#include "TelemetryPublisher.h"
 #include "../VideoComposerApplication.h"
 #include "../layer/LayerManager.h"
 #include "../layer/VideoLayer.h"
 #include "../input/VideoFileInput.h"
+#include "../input/HAPVideoInput.h"
+#include "../input/RamClipCache.h"
+#include "../input/PageCachePolicy.h"
+#include "../video/MemoryBudget.h"
 #include "../sync/MIDISyncSource.h"
+#include "../sync/FrameLockSyncSource.h"
+#include "../sync/VblankClockSyncSource.h"
+#include "../sync/SyncSource.h"
 #include "../osd/OSDManager.h"
 #include "../display/OpenGLRenderer.h"
 #include "../display/DisplayBackend.h"
+#include "../display/SyncLatencyMonitor.h"
 #include "../utils/Logger.h"  // For LOG_INFO, LOG_WARNING
 #include "../utils/SMPTEUtils.h"
+#include "../utils/FrameTracer.h"
+#include "../utils/TimeUtils.h"
 #include <sstream>
 #include <algorithm>
+#include <charconv>
 #include <cstdlib>
 #include <iostream>
 
 namespace videocomposer {
 
+namespace {
+
+constexpr PropertyAnimator::Property offsetProperty(PropertyAnimator::Property first, int offset) {
+    return static_cast<PropertyAnimator::Property>(static_cast<int>(first) + offset);
+}
+
+// Animatable properties, named like their direct commands
+struct AnimatedProperty {
+    const char* name;
+    PropertyAnimator::Property first;
+    int count;  // Values: consecutive properties from first
+};
+
+const AnimatedProperty ANIMATED_PROPERTIES[] = {
+    {"opacity", PropertyAnimator::Property::OPACITY, 1},
+    {"position", PropertyAnimator::Property::X, 2},
+    {"scale", PropertyAnimator::Property::SCALE_X, 2},
+    {"xscale", PropertyAnimator::Property::SCALE_X, 1},
+    {"yscale", PropertyAnimator::Property::SCALE_Y, 1},
+    {"rotation", PropertyAnimator::Property::ROTATION, 1},
+    {"brightness", PropertyAnimator::Property::BRIGHTNESS, 1},
+    {"contrast", PropertyAnimator::Property::CONTRAST, 1},
+    {"saturation", PropertyAnimator::Property::SATURATION, 1},
+    {"hue", PropertyAnimator::Property::HUE, 1},
+    {"gamma", PropertyAnimator::Property::GAMMA, 1},
+    {"corners", PropertyAnimator::Property::CORNER_0, 8},
+    {"corner1", PropertyAnimator::Property::CORNER_0, 2},
+    {"corner2", offsetProperty(PropertyAnimator::Property::CORNER_0, 2), 2},
+    {"corner3", offsetProperty(PropertyAnimator::Property::CORNER_0, 4), 2},
+    {"corner4", offsetProperty(PropertyAnimator::Property::CORNER_0, 6), 2},
+};
+
+const AnimatedProperty* findAnimatedProperty(std::string_view name) {
+    for (const AnimatedProperty& property : ANIMATED_PROPERTIES) {
+        if (name == property.name) {
+            return &property;
+        }
+    }
+    return nullptr;
+}
+
+bool parseBlendMode(int mode, LayerProperties::BlendMode& blendMode) {
+    switch (mode) {
+        case 0:
+            blendMode = LayerProperties::NORMAL;
+            return true;
+        case 1:
+            blendMode = LayerProperties::MULTIPLY;
+            return true;
+        case 2:
+            blendMode = LayerProperties::SCREEN;
+            return true;
+        case 3:
+            blendMode = LayerProperties::OVERLAY;
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
 RemoteCommandRouter::RemoteCommandRouter(VideoComposerApplication* app, LayerManager* layerManager)
     : app_(app)
     , layerManager_(layerManager)
+    , inCmd_(false)
 {
     // Register app-level commands
-    registerAppCommand("quit", [this](const std::vector<std::string>& args) {
+    registerAppCommand("quit", [this](const CommandArgs& args) {
         return handleQuit(args);
     });
-    registerAppCommand("load", [this](const std::vector<std::string>& args) {
+    registerAppCommand("load", [this](const CommandArgs& args) {
         return handleLoad(args);
     });
-    registerAppCommand("seek", [this](const std::vector<std::string>& args) {
+    registerAppCommand("seek", [this](const CommandArgs& args) {
         return handleSeek(args);
     });
-    registerAppCommand("fps", [this](const std::vector<std::string>& args) {
+    registerAppCommand("fps", [this](const CommandArgs& args) {
         return handleFPS(args);
     });
-    registerAppCommand("offset", [this](const std::vector<std::string>& args) {
+    registerAppCommand("offset", [this](const CommandArgs& args) {
         return handleOffset(args);
     });
-    registerAppCommand("layer/add", [this](const std::vector<std::string>& args) {
+    registerAppCommand("layer/add", [this](const CommandArgs& args) {
         return handleLayerAdd(args);
     });
-    registerAppCommand("layer/remove", [this](const std::vector<std::string>& args) {
+    registerAppCommand("layer/remove", [this](const CommandArgs& args) {
         return handleLayerRemove(args);
     });
-    registerAppCommand("layer/duplicate", [this](const std::vector<std::string>& args) {
+    registerAppCommand("layer/duplicate", [this](const CommandArgs& args) {
         return handleLayerDuplicate(args);
     });
-    registerAppCommand("layer/reorder", [this](const std::vector<std::string>& args) {
+    registerAppCommand("layer/reorder", [this](const CommandArgs& args) {
         return handleLayerReorder(args);
     });
-    registerAppCommand("layer/list", [this](const std::vector<std::string>& args) {
+    registerAppCommand("layer/list", [this](const CommandArgs& args) {
         return handleLayerList(args);
     });
-    registerAppCommand("osd/frame", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/frame", [this](const CommandArgs& args) {
         return handleOSDFrame(args);
     });
-    registerAppCommand("osd/smpte", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/smpte", [this](const CommandArgs& args) {
         return handleOSDSMPTE(args);
     });
-    registerAppCommand("osd/text", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/text", [this](const CommandArgs& args) {
         return handleOSDText(args);
     });
-    registerAppCommand("osd/box", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/box", [this](const CommandArgs& args) {
         return handleOSDBox(args);
     });
-    registerAppCommand("osd/font", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/font", [this](const CommandArgs& args) {
         return handleOSDFont(args);
     });
-    registerAppCommand("osd/pos", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/pos", [this](const CommandArgs& args) {
         return handleOSDPos(args);
     });
-    registerAppCommand("art/timescale", [this](const std::vector<std::string>& args) {
+    registerAppCommand("osd/gpu", [this](const CommandArgs& args) {
+        return handleOSDGpu(args);
+    });
+    registerAppCommand("art/timescale", [this](const CommandArgs& args) {
         if (args.size() >= 2) {
             return handleTimeScale2(args);  // timescale + offset
         } else {
             return handleTimeScale(args);   // timescale only
         }
     });
-    registerAppCommand("art/loop", [this](const std::vector<std::string>& args) {
+    registerAppCommand("art/loop", [this](const CommandArgs& args) {
         return handleLoop(args);
     });
-    registerAppCommand("art/reverse", [this](const std::vector<std::string>& args) {
+    registerAppCommand("art/reverse", [this](const CommandArgs& args) {
         return handleReverse(args);
     });
-    registerAppCommand("art/pan", [this](const std::vector<std::string>& args) {
+    registerAppCommand("art/pan", [this](const CommandArgs& args) {
         return handlePan(args);
     });
 
     // Register layer-level commands
-    registerLayerCommand("seek", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("seek", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerSeek(layer, args);
     });
-    registerLayerCommand("play", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("seek_async", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerSeekAsync(layer, args);
+    });
+    registerLayerCommand("play", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerPlay(layer, args);
     });
-    registerLayerCommand("pause", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("pause", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerPause(layer, args);
     });
-    registerLayerCommand("position", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("position", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerPosition(layer, args);
     });
-    registerLayerCommand("opacity", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("opacity", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerOpacity(layer, args);
     });
-    registerLayerCommand("visible", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("visible", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerVisible(layer, args);
     });
-    registerLayerCommand("zorder", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("zorder", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerZOrder(layer, args);
     });
-    registerLayerCommand("timescale", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("timescale", [this](VideoLayer* layer, const CommandArgs& args) {
         if (args.size() >= 2) {
             return handleLayerTimeScale2(layer, args);  // timescale + offset
         } else {
             return handleLayerTimeScale(layer, args);   // timescale only
         }
     });
-    registerLayerCommand("loop", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("loop", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerLoop(layer, args);
     });
-    registerLayerCommand("reverse", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("reverse", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerReverse(layer, args);
     });
-    registerLayerCommand("pan", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("pan", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerPan(layer, args);
     });
-    registerLayerCommand("crop", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("crop", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCrop(layer, args);
     });
-    registerLayerCommand("crop/disable", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("crop/disable", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCropDisable(layer, args);
     });
-    registerLayerCommand("panorama", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("panorama", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerPanorama(layer, args);
     });
-    registerLayerCommand("file", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("file", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerFile(layer, args);
     });
-    registerLayerCommand("autounload", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("autounload", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerAutoUnload(layer, args);
     });
-    registerLayerCommand("loop/region", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("preload", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerPreload(layer, args);
+    });
+    registerLayerCommand("loop/region", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerLoopRegion(layer, args);
     });
-    registerLayerCommand("loop/region/disable", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("loop/region/disable", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerLoopRegionDisable(layer, args);
     });
-    registerLayerCommand("offset", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("offset", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerOffset(layer, args);
     });
-    registerLayerCommand("mtcfollow", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("mtcfollow", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerMtcFollow(layer, args);
     });
-    registerLayerCommand("scale", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("arm", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerArm(layer, args);
+    });
+    registerLayerCommand("go", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerGo(layer, args);
+    });
+    registerLayerCommand("cues", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerCues(layer, args);
+    });
+    registerLayerCommand("decode_priority", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerDecodePriority(layer, args);
+    });
+    registerLayerCommand("underrun_policy", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerUnderrunPolicy(layer, args);
+    });
+    registerLayerCommand("loop_cache", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerLoopCache(layer, args);
+    });
+    registerLayerCommand("suspend_hidden", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerSuspendHidden(layer, args);
+    });
+    registerLayerCommand("critical", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerCritical(layer, args);
+    });
+    registerLayerCommand("scale", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerScale(layer, args);
     });
-    registerLayerCommand("xscale", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("xscale", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerXScale(layer, args);
     });
-    registerLayerCommand("yscale", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("yscale", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerYScale(layer, args);
     });
-    registerLayerCommand("rotation", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("rotation", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerRotation(layer, args);
     });
-    registerLayerCommand("corner_deform", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner_deform", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCornerDeform(layer, args);
     });
-    registerLayerCommand("corner_deform_enable", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner_deform_enable", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCornerDeformEnable(layer, args);
     });
-    registerLayerCommand("corner_deform_hq", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner_deform_hq", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCornerDeformHQ(layer, args);
     });
-    registerLayerCommand("corners", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corners", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCorners(layer, args);
     });
-    registerLayerCommand("corner1", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner1", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCorner1(layer, args);
     });
-    registerLayerCommand("corner2", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner2", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCorner2(layer, args);
     });
-    registerLayerCommand("corner3", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner3", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCorner3(layer, args);
     });
-    registerLayerCommand("corner4", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("corner4", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerCorner4(layer, args);
     });
-    registerLayerCommand("blendmode", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("blendmode", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerBlendMode(layer, args);
     });
+    registerLayerCommand("packedalpha", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerPackedAlpha(layer, args);
+    });
+    registerLayerCommand("blur", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerBlur(layer, args);
+    });
+    registerLayerCommand("sharpen", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerSharpen(layer, args);
+    });
+    registerLayerCommand("chromakey", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerChromaKey(layer, args);
+    });
+    registerLayerCommand("vignette", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerVignette(layer, args);
+    });
+    registerLayerCommand("group", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerGroup(layer, args);
+    });
+    registerLayerCommand("animate", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerAnimate(layer, args);
+    });
+    registerLayerCommand("animate/stop", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerAnimateStop(layer, args);
+    });
     
     // Layer color correction commands
-    registerLayerCommand("brightness", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("brightness", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerBrightness(layer, args);
     });
-    registerLayerCommand("contrast", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("contrast", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerContrast(layer, args);
     });
-    registerLayerCommand("saturation", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("saturation", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerSaturation(layer, args);
     });
-    registerLayerCommand("hue", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("hue", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerHue(layer, args);
     });
-    registerLayerCommand("gamma", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("gamma", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerGamma(layer, args);
     });
-    registerLayerCommand("color/reset", [this](VideoLayer* layer, const std::vector<std::string>& args) {
+    registerLayerCommand("lut", [this](VideoLayer* layer, const CommandArgs& args) {
+        return handleLayerLut(layer, args);
+    });
+    registerLayerCommand("color/reset", [this](VideoLayer* layer, const CommandArgs& args) {
         return handleLayerColorReset(layer, args);
     });
     
+    // Layer group commands (transform of the group image)
+    registerGroupCommand("position", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupPosition(group, args);
+    });
+    registerGroupCommand("opacity", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupOpacity(group, args);
+    });
+    registerGroupCommand("visible", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupVisible(group, args);
+    });
+    registerGroupCommand("zorder", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupZOrder(group, args);
+    });
+    registerGroupCommand("scale", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupScale(group, args);
+    });
+    registerGroupCommand("rotation", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupRotation(group, args);
+    });
+    registerGroupCommand("blendmode", [this](LayerGroup* group, const CommandArgs& args) {
+        return handleGroupBlendMode(group, args);
+    });
+    
     // Register master layer commands (composite transforms)
-    registerAppCommand("master/opacity", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/opacity", [this](const CommandArgs& args) {
         return handleMasterOpacity(args);
     });
-    registerAppCommand("master/position", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/position", [this](const CommandArgs& args) {
         return handleMasterPosition(args);
     });
-    registerAppCommand("master/scale", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/scale", [this](const CommandArgs& args) {
         return handleMasterScale(args);
     });
-    registerAppCommand("master/xscale", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/xscale", [this](const CommandArgs& args) {
         return handleMasterXScale(args);
     });
-    registerAppCommand("master/yscale", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/yscale", [this](const CommandArgs& args) {
         return handleMasterYScale(args);
     });
-    registerAppCommand("master/rotation", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/rotation", [this](const CommandArgs& args) {
         return handleMasterRotation(args);
     });
-    registerAppCommand("master/corners", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/corners", [this](const CommandArgs& args) {
         return handleMasterCorners(args);
     });
-    registerAppCommand("master/corner1", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/corner1", [this](const CommandArgs& args) {
         return handleMasterCorner1(args);
     });
-    registerAppCommand("master/corner2", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/corner2", [this](const CommandArgs& args) {
         return handleMasterCorner2(args);
     });
-    registerAppCommand("master/corner3", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/corner3", [this](const CommandArgs& args) {
         return handleMasterCorner3(args);
     });
-    registerAppCommand("master/corner4", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/corner4", [this](const CommandArgs& args) {
         return handleMasterCorner4(args);
     });
-    registerAppCommand("master/reset", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/reset", [this](const CommandArgs& args) {
         return handleMasterReset(args);
     });
     
     // Master color correction commands
-    registerAppCommand("master/brightness", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/brightness", [this](const CommandArgs& args) {
         return handleMasterBrightness(args);
     });
-    registerAppCommand("master/contrast", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/contrast", [this](const CommandArgs& args) {
         return handleMasterContrast(args);
     });
-    registerAppCommand("master/saturation", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/saturation", [this](const CommandArgs& args) {
         return handleMasterSaturation(args);
     });
-    registerAppCommand("master/hue", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/hue", [this](const CommandArgs& args) {
         return handleMasterHue(args);
     });
-    registerAppCommand("master/gamma", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/gamma", [this](const CommandArgs& args) {
         return handleMasterGamma(args);
     });
-    registerAppCommand("master/color/reset", [this](const std::vector<std::string>& args) {
+    registerAppCommand("master/lut", [this](const CommandArgs& args) {
+        return handleMasterLut(args);
+    });
+    registerAppCommand("master/color/reset", [this](const CommandArgs& args) {
         return handleMasterColorReset(args);
     });
     
     // Display configuration commands (Phase 4)
-    registerAppCommand("display/list", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/list", [this](const CommandArgs& args) {
         return handleDisplayList(args);
     });
-    registerAppCommand("display/modes", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/modes", [this](const CommandArgs& args) {
         return handleDisplayModes(args);
     });
-    registerAppCommand("display/mode", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/mode", [this](const CommandArgs& args) {
         return handleDisplayMode(args);
     });
-    registerAppCommand("display/resolution_mode", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/resolution_mode", [this](const CommandArgs& args) {
         return handleDisplayResolutionMode(args);
     });
-    registerAppCommand("display/region", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/region", [this](const CommandArgs& args) {
         return handleDisplayRegion(args);
     });
-    registerAppCommand("display/assign", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/assign", [this](const CommandArgs& args) {
         return handleDisplayAssign(args);
     });
-    registerAppCommand("display/blend", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/blend", [this](const CommandArgs& args) {
         return handleDisplayBlend(args);
     });
-    registerAppCommand("display/save", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/save", [this](const CommandArgs& args) {
         return handleDisplaySave(args);
     });
-    registerAppCommand("display/load", [this](const std::vector<std::string>& args) {
+    registerAppCommand("display/load", [this](const CommandArgs& args) {
         return handleDisplayLoad(args);
     });
     
     // Virtual output commands (NDI, streaming, capture)
-    registerAppCommand("output/capture", [this](const std::vector<std::string>& args) {
+    registerAppCommand("output/capture", [this](const CommandArgs& args) {
         return handleOutputCapture(args);
     });
-    registerAppCommand("output/list", [this](const std::vector<std::string>& args) {
+    registerAppCommand("output/list", [this](const CommandArgs& args) {
         return handleOutputList(args);
     });
+    
+    // Show preparation commands
+    registerAppCommand("show/prewarm", [this](const CommandArgs& args) {
+        return handleShowPrewarm(args);
+    });
+    registerAppCommand("show/thumbnail", [this](const CommandArgs& args) {
+        return handleShowThumbnail(args);
+    });
+    
+    // Statistics commands
+    registerAppCommand("stats/framepool", [this](const CommandArgs& args) {
+        return handleStatsFramePool(args);
+    });
+    registerAppCommand("stats/hapdecode", [this](const CommandArgs& args) {
+        return handleStatsHapDecode(args);
+    });
+    registerAppCommand("stats/underrun", [this](const CommandArgs& args) {
+        return handleStatsUnderrun(args);
+    });
+    registerAppCommand("stats/io", [this](const CommandArgs& args) {
+        return handleStatsIo(args);
+    });
+    registerAppCommand("stats/gpu", [this](const CommandArgs& args) {
+        return handleStatsGpu(args);
+    });
+    registerAppCommand("stats/memory", [this](const CommandArgs& args) {
+        return handleStatsMemory(args);
+    });
+    registerAppCommand("stats/subscribe", [this](const CommandArgs& args) {
+        return handleStatsSubscribe(args);
+    });
+    registerAppCommand("stats/unsubscribe", [this](const CommandArgs& args) {
+        return handleStatsUnsubscribe(args);
+    });
+    registerAppCommand("synctest/report", [this](const CommandArgs& args) {
+        return handleSyncTestReport(args);
+    });
+    registerAppCommand("synctest/photodiode", [this](const CommandArgs& args) {
+        return handleSyncTestPhotodiode(args);
+    });
+    registerAppCommand("trace/dump", [this](const CommandArgs& args) {
+        return handleTraceDump(args);
+    });
+    registerAppCommand("trace/enable", [this](const CommandArgs& args) {
+        return handleTraceEnable(args);
+    });
+    registerAppCommand("framelock/timeline", [this](const CommandArgs& args) {
+        return handleFrameLockTimeline(args);
+    });
+    registerAppCommand("cluster/layer", [this](const CommandArgs& args) {
+        return handleClusterMessage(ClusterMessage::LAYER, args);
+    });
+    registerAppCommand("cluster/remove", [this](const CommandArgs& args) {
+        return handleClusterMessage(ClusterMessage::REMOVE, args);
+    });
+    registerAppCommand("cluster/sync", [this](const CommandArgs& args) {
+        return handleClusterMessage(ClusterMessage::SYNC, args);
+    });
+    registerAppCommand("clock/start", [this](const CommandArgs& args) {
+        return handleClockStart(args);
+    });
+    registerAppCommand("clock/stop", [this](const CommandArgs& args) {
+        return handleClockStop(args);
+    });
+    registerAppCommand("clock/locate", [this](const CommandArgs& args) {
+        return handleClockLocate(args);
+    });
+    registerAppCommand("at", [this](const CommandArgs& args) {
+        return handleAt(args);
+    });
+    registerAppCommand("at/clear", [this](const CommandArgs& args) {
+        return handleAtClear(args);
+    });
 }
 
 RemoteCommandRouter::~RemoteCommandRouter() {
 }
 
-bool RemoteCommandRouter::routeCommand(const std::string& path, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::scheduleAtTime(int64_t wallUs, std::string_view path, const CommandArgs& args) {
+    if (!scheduler_.scheduleAtTime(wallUs, path, args)) {
+        LOG_WARNING << "Scheduler full (" << CommandScheduler::MAX_PENDING << " commands), dropping " << path;
+        return false;
+    }
+    return true;
+}
+
+size_t RemoteCommandRouter::runScheduled(int64_t frame, int64_t presentationUs) {
+    if (scheduler_.size() == 0) {
+        return 0;
+    }
+    return scheduler_.runDue(frame, presentationUs, [this](std::string_view path, const CommandArgs& args) {
+        routeCommand(path, args);
+    });
+}
+
+bool RemoteCommandRouter::routeCommand(std::string_view path, const CommandArgs& args) {
     // Handle /videocomposer/cmd - remote command interface (takes a string command)
     if (path == "/videocomposer/cmd" && !args.empty()) {
         // Parse the command string (e.g., "osd smpte 89")
-        std::string cmd = args[0];
+        std::string_view cmd = args[0].view();
         size_t firstSpace = cmd.find(' ');
-        std::string cmdPath = (firstSpace != std::string::npos) ? cmd.substr(0, firstSpace) : cmd;
-        std::vector<std::string> cmdArgs;
-        
+        std::string_view cmdPath = cmd.substr(0, firstSpace);
+
+        // A nested /cmd gets its own arguments, the outer ones are still in use
+        CommandArgs nestedArgs;
+        CommandArgs& cmdArgs = inCmd_ ? nestedArgs : cmdArgs_;
+        cmdArgs.clear();
+
         // Parse remaining arguments
         size_t pos = firstSpace;
-        while (pos != std::string::npos && pos < cmd.length()) {
+        while (pos != std::string_view::npos && pos < cmd.length()) {
             pos = cmd.find_first_not_of(' ', pos);
-            if (pos == std::string::npos) break;
+            if (pos == std::string_view::npos) break;
             size_t end = cmd.find(' ', pos);
-            if (end == std::string::npos) {
-                cmdArgs.push_back(cmd.substr(pos));
-                break;
-            } else {
-                cmdArgs.push_back(cmd.substr(pos, end - pos));
-                pos = end;
-            }
+            cmdArgs.addString(cmd.substr(pos, end == std::string_view::npos ? end : end - pos));
+            pos = end;
         }
-        
+
         // Route the parsed command
-        return routeCommand(cmdPath, cmdArgs);
+        bool wasInCmd = inCmd_;
+        inCmd_ = true;
+        bool handled = routeCommand(cmdPath, cmdArgs);
+        inCmd_ = wasInCmd;
+        return handled;
     }
-    
+
     // Remove leading /videocomposer/ if present
-    std::string cleanPath = path;
-    if (cleanPath.find("/videocomposer/") == 0) {
-        cleanPath = cleanPath.substr(15); // Remove "/videocomposer/"
-    } else if (cleanPath.find("/videocomposer") == 0) {
-        cleanPath = cleanPath.substr(14); // Remove "/videocomposer"
+    std::string_view cleanPath = path;
+    if (cleanPath.compare(0, 15, "/videocomposer/") == 0) {
+        cleanPath.remove_prefix(15); // Remove "/videocomposer/"
+    } else if (cleanPath.compare(0, 14, "/videocomposer") == 0) {
+        cleanPath.remove_prefix(14); // Remove "/videocomposer"
     }
-    
+
     // Log only in verbose mode to avoid blocking on high message rates
     // LOG_VERBOSE << "OSC: Routing command: path='" << path << "' cleanPath='" << cleanPath << "' args.size()=" << args.size();
 
     // Check if it's a layer-level command
-    if (cleanPath.find("layer/") == 0) {
-        std::string remaining = cleanPath.substr(6); // Remove "layer/"
-        
+    if (cleanPath.compare(0, 6, "layer/") == 0) {
+        std::string_view remaining = cleanPath.substr(6); // Remove "layer/"
+
         // Check for special commands: load, unload
         if (remaining == "load") {
-            // /videocomposer/layer/load s s (filepath, cueId)
+            // /videocomposer/layer/load s s [i] [i] (filepath, cueId, priority, preload)
             return handleLayerLoad(args);
         } else if (remaining == "unload") {
             // /videocomposer/layer/unload s (cueId)
             return handleLayerUnload(args);
+        } else if (remaining == "prioritize") {
+            // /videocomposer/layer/prioritize s [i] (cueId, priority)
+            return handleLayerPrioritize(args);
         }
-        
+
         // Parse layer ID (UUID string) and command
-        std::string cueId;
-        std::string command;
-        
         size_t slashPos = remaining.find('/');
-        if (slashPos != std::string::npos) {
-            cueId = remaining.substr(0, slashPos);
-            command = remaining.substr(slashPos + 1);
-            
-            // Try to get layer by cue ID (UUID)
-            VideoLayer* layer = layerManager_->getLayerByCueId(cueId);
+        if (slashPos != std::string_view::npos) {
+            VideoLayer* layer = findLayer(remaining.substr(0, slashPos));
             if (layer) {
-                // Layer found by UUID - route to layer command
-                auto it = layerCommands_.find(command);
-                if (it != layerCommands_.end()) {
-                    return it->second(layer, args);
-                }
-            } else {
-                // Try integer layer ID for backward compatibility
-                int layerId = std::atoi(cueId.c_str());
-                if (layerId >= 0) {
-                    layer = layerManager_->getLayer(layerId);
-                    if (layer) {
-            auto it = layerCommands_.find(command);
-            if (it != layerCommands_.end()) {
-                return it->second(layer, args);
-                        }
-                    }
+                const LayerHandler* handler = layerCommands_.find(remaining.substr(slashPos + 1));
+                if (handler) {
+                    return (*handler)(layer, args);
                 }
             }
-        } else {
-            // No layer ID specified - treat as app-level layer command
-            command = remaining;
-            auto it = appCommands_.find("layer/" + command);
-            if (it != appCommands_.end()) {
-                return it->second(args);
-            }
+            return false;
         }
-    } else {
-        // App-level command
-        auto it = appCommands_.find(cleanPath);
-        if (it != appCommands_.end()) {
-            return it->second(args);
+        // No layer ID specified - treat as app-level layer command
+    }
+
+    // Group-level command: group/<name>/<command>
+    if (cleanPath.compare(0, 6, "group/") == 0 && layerManager_) {
+        std::string_view remaining = cleanPath.substr(6);
+        size_t slashPos = remaining.find('/');
+        if (slashPos == std::string_view::npos) {
+            return false;
+        }
+        std::string_view name = remaining.substr(0, slashPos);
+        std::string_view command = remaining.substr(slashPos + 1);
+        if (command == "remove") {
+            return layerManager_->removeGroup(name);
+        }
+        const GroupHandler* handler = groupCommands_.find(command);
+        if (!handler) {
+            return false;
         }
+        LayerGroup* group = layerManager_->getGroup(name);
+        if (!group) {
+            group = layerManager_->createGroup(std::string(name));
+        }
+        return group && (*handler)(group, args);
+    }
+
+    // App-level command
+    const AppHandler* handler = appCommands_.find(cleanPath);
+    if (handler) {
+        return (*handler)(args);
     }
 
     return false;
 }
 
 void RemoteCommandRouter::registerAppCommand(const std::string& path,
-                                             std::function<bool(const std::vector<std::string>&)> handler) {
-    appCommands_[path] = handler;
+                                             AppHandler handler) {
+    appCommands_.insert(path, std::move(handler));
 }
 
 void RemoteCommandRouter::registerLayerCommand(const std::string& path,
-                                               std::function<bool(VideoLayer*, const std::vector<std::string>&)> handler) {
-    layerCommands_[path] = handler;
+                                               LayerHandler handler) {
+    layerCommands_.insert(path, std::move(handler));
 }
 
-bool RemoteCommandRouter::parsePath(const std::string& path, std::string& command, int& layerId) {
-    // This is handled in routeCommand now
-    return false;
+void RemoteCommandRouter::registerGroupCommand(const std::string& path,
+                                               GroupHandler handler) {
+    groupCommands_.insert(path, std::move(handler));
+}
+
+VideoLayer* RemoteCommandRouter::findLayer(std::string_view id) {
+    // Try to get layer by cue ID (UUID)
+    VideoLayer* layer = layerManager_->getLayerByCueId(id);
+    if (layer) {
+        return layer;
+    }
+
+    // Try integer layer ID for backward compatibility (atoi rules: no digits = 0)
+    int layerId = 0;
+    std::from_chars(id.data(), id.data() + id.size(), layerId);
+    if (layerId < 0) {
+        return nullptr;
+    }
+    return layerManager_->getLayer(layerId);
 }
 
 // App-level command handlers
-bool RemoteCommandRouter::handleQuit(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleQuit(const CommandArgs& args) {
     if (app_) {
         app_->quit();
     }
     return true;
 }
 
-bool RemoteCommandRouter::handleLoad(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLoad(const CommandArgs& args) {
     if (args.empty()) {
         return false;
     }
@@ -445,12 +716,12 @@ bool RemoteCommandRouter::handleLoad(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleSeek(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleSeek(const CommandArgs& args) {
     if (args.empty()) {
         return false;
     }
 
-    int64_t frame = std::atoll(args[0].c_str());
+    int64_t frame = args[0].toInt64();
     
     // Seek all layers or first layer
     if (layerManager_) {
@@ -463,25 +734,25 @@ bool RemoteCommandRouter::handleSeek(const std::vector<std::string>& args) {
     return false;
 }
 
-bool RemoteCommandRouter::handleFPS(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleFPS(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    double fps = std::atof(args[0].c_str());
+    double fps = args[0].toDouble();
     return app_->setFPS(fps);
 }
 
-bool RemoteCommandRouter::handleOffset(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOffset(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    int64_t offset = std::atoll(args[0].c_str());
+    int64_t offset = args[0].toInt64();
     return app_->setTimeOffset(offset);
 }
 
-bool RemoteCommandRouter::handleLayerAdd(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerAdd(const CommandArgs& args) {
     if (args.empty()) {
         return false;
     }
@@ -491,24 +762,24 @@ bool RemoteCommandRouter::handleLayerAdd(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerRemove(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerRemove(const CommandArgs& args) {
     if (args.empty()) {
         return false;
     }
 
-    int layerId = std::atoi(args[0].c_str());
+    int layerId = args[0].toInt();
     if (layerManager_) {
         return layerManager_->removeLayer(layerId);
     }
     return false;
 }
 
-bool RemoteCommandRouter::handleLayerDuplicate(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerDuplicate(const CommandArgs& args) {
     if (args.empty()) {
         return false;
     }
 
-    int layerId = std::atoi(args[0].c_str());
+    int layerId = args[0].toInt();
     if (layerManager_) {
         int newLayerId = -1;
         if (layerManager_->duplicateLayer(layerId, &newLayerId)) {
@@ -519,12 +790,12 @@ bool RemoteCommandRouter::handleLayerDuplicate(const std::vector<std::string>& a
     return false;
 }
 
-bool RemoteCommandRouter::handleLayerReorder(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerReorder(const CommandArgs& args) {
     if (args.size() < 2) {
         return false;
     }
 
-    int layerId = std::atoi(args[0].c_str());
+    int layerId = args[0].toInt();
     std::string action = args[1];
     
     if (layerManager_) {
@@ -545,7 +816,7 @@ bool RemoteCommandRouter::handleLayerReorder(const std::vector<std::string>& arg
     return false;
 }
 
-bool RemoteCommandRouter::handleLayerList(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerList(const CommandArgs& args) {
     if (!layerManager_) {
         return false;
     }
@@ -561,30 +832,49 @@ bool RemoteCommandRouter::handleLayerList(const std::vector<std::string>& args)
 }
 
 // Layer-level command handlers
-bool RemoteCommandRouter::handleLayerSeek(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerSeek(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
 
-    int64_t frame = std::atoll(args[0].c_str());
+    int64_t frame = args[0].toInt64();
     return layer->seek(frame);
 }
 
-bool RemoteCommandRouter::handleLayerPlay(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerSeekAsync(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    // Expected: /videocomposer/layer/<cueId>/seek_async frame [hold|blank]
+    // (done: /videocomposer/layer/seeked to the event_report target)
+    LayerPlayback::SeekPlaceholder placeholder = LayerPlayback::SeekPlaceholder::HOLD;
+    if (args.size() > 1) {
+        if (args[1] == "blank") {
+            placeholder = LayerPlayback::SeekPlaceholder::BLANK;
+        } else if (args[1] != "hold") {
+            LOG_WARNING << "Unknown seek placeholder: " << args[1] << " (expected hold or blank)";
+            return false;
+        }
+    }
+    return layer->seekAsync(args[0].toInt64(), placeholder);
+}
+
+bool RemoteCommandRouter::handleLayerPlay(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
     return layer->play();
 }
 
-bool RemoteCommandRouter::handleLayerPause(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerPause(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
     return layer->pause();
 }
 
-bool RemoteCommandRouter::handleLayerPosition(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerPosition(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.size() < 2) {
         return false;
     }
@@ -592,8 +882,8 @@ bool RemoteCommandRouter::handleLayerPosition(VideoLayer* layer, const std::vect
     auto& props = layer->properties();
     // Support both integer and float positions for smooth movement
     // Try parsing as float first (for smooth sub-pixel positioning)
-    float x = std::atof(args[0].c_str());
-    float y = std::atof(args[1].c_str());
+    float x = args[0].toFloat();
+    float y = args[1].toFloat();
     props.x = static_cast<int>(x);
     props.y = static_cast<int>(y);
     // Store sub-pixel precision if needed (for future interpolation)
@@ -601,40 +891,40 @@ bool RemoteCommandRouter::handleLayerPosition(VideoLayer* layer, const std::vect
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerOpacity(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerOpacity(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
 
-    float opacity = std::atof(args[0].c_str());
+    float opacity = args[0].toFloat();
     opacity = std::max(0.0f, std::min(1.0f, opacity)); // Clamp to 0-1
     layer->properties().opacity = opacity;
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerVisible(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerVisible(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
 
-    int visible = std::atoi(args[0].c_str());
+    int visible = args[0].toInt();
     layer->properties().visible = (visible != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerZOrder(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerZOrder(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
 
-    int zOrder = std::atoi(args[0].c_str());
+    int zOrder = args[0].toInt();
     if (layerManager_) {
         return layerManager_->setLayerZOrder(layer->getLayerId(), zOrder);
     }
     return false;
 }
 
-bool RemoteCommandRouter::handleOSDFrame(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOSDFrame(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -652,7 +942,7 @@ bool RemoteCommandRouter::handleOSDFrame(const std::vector<std::string>& args) {
             osd->enableMode(OSDManager::FRAME);
         }
     } else {
-        int yPos = std::atoi(args[0].c_str());
+        int yPos = args[0].toInt();
         if (yPos < 0) {
             osd->disableMode(OSDManager::FRAME);
         } else if (yPos <= 100) {
@@ -666,7 +956,7 @@ bool RemoteCommandRouter::handleOSDFrame(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleOSDSMPTE(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOSDSMPTE(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -684,7 +974,7 @@ bool RemoteCommandRouter::handleOSDSMPTE(const std::vector<std::string>& args) {
             osd->enableMode(OSDManager::SMPTE);
         }
     } else {
-        int yPos = std::atoi(args[0].c_str());
+        int yPos = args[0].toInt();
         if (yPos < 0) {
             osd->disableMode(OSDManager::SMPTE);
         } else if (yPos <= 100) {
@@ -698,7 +988,7 @@ bool RemoteCommandRouter::handleOSDSMPTE(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleOSDText(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOSDText(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -730,7 +1020,7 @@ bool RemoteCommandRouter::handleOSDText(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleOSDBox(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOSDBox(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -750,7 +1040,7 @@ bool RemoteCommandRouter::handleOSDBox(const std::vector<std::string>& args) {
             LOG_INFO << "OSD: BOX enabled";
         }
     } else {
-        int enable = std::atoi(args[0].c_str());
+        int enable = args[0].toInt();
         if (enable) {
             osd->enableMode(OSDManager::BOX);
             LOG_INFO << "OSD: BOX enabled (via arg)";
@@ -762,7 +1052,28 @@ bool RemoteCommandRouter::handleOSDBox(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleOSDFont(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOSDGpu(const CommandArgs& args) {
+    if (!app_) {
+        return false;
+    }
+    
+    OSDManager* osd = app_->getOSDManager();
+    if (!osd) {
+        return false;
+    }
+    
+    bool enable = args.empty() ? !osd->isModeEnabled(OSDManager::GPU) : args[0].toInt() != 0;
+    if (enable) {
+        osd->enableMode(OSDManager::GPU);
+    } else {
+        osd->disableMode(OSDManager::GPU);
+        osd->setGpuTimings({});
+    }
+    LOG_INFO << "OSD: GPU timings " << (enable ? "enabled" : "disabled");
+    return true;
+}
+
+bool RemoteCommandRouter::handleOSDFont(const CommandArgs& args) {
     if (!app_ || args.empty()) {
         return false;
     }
@@ -776,7 +1087,7 @@ bool RemoteCommandRouter::handleOSDFont(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleOSDPos(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOSDPos(const CommandArgs& args) {
     if (!app_ || args.size() < 2) {
         return false;
     }
@@ -786,8 +1097,8 @@ bool RemoteCommandRouter::handleOSDPos(const std::vector<std::string>& args) {
         return false;
     }
     
-    int xAlign = std::atoi(args[0].c_str()); // 0=left, 1=center, 2=right
-    int yPos = std::atoi(args[1].c_str());    // 0-100
+    int xAlign = args[0].toInt(); // 0=left, 1=center, 2=right
+    int yPos = args[1].toInt();    // 0-100
     
     if (xAlign < 0 || xAlign > 2 || yPos < 0 || yPos > 100) {
         return false;
@@ -797,7 +1108,7 @@ bool RemoteCommandRouter::handleOSDPos(const std::vector<std::string>& args) {
     return true;
 }
 
-bool RemoteCommandRouter::handleTimeScale(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleTimeScale(const CommandArgs& args) {
     if (!app_ || args.empty()) {
         return false;
     }
@@ -806,7 +1117,7 @@ bool RemoteCommandRouter::handleTimeScale(const std::vector<std::string>& args)
     if (layerManager_ && layerManager_->getLayerCount() > 0) {
         auto layers = layerManager_->getLayers();
         if (!layers.empty() && layers[0]) {
-            double scale = std::atof(args[0].c_str());
+            double scale = args[0].toDouble();
             layers[0]->setTimeScale(scale);
             return true;
         }
@@ -814,7 +1125,7 @@ bool RemoteCommandRouter::handleTimeScale(const std::vector<std::string>& args)
     return false;
 }
 
-bool RemoteCommandRouter::handleTimeScale2(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleTimeScale2(const CommandArgs& args) {
     if (!app_ || args.size() < 2) {
         return false;
     }
@@ -823,8 +1134,8 @@ bool RemoteCommandRouter::handleTimeScale2(const std::vector<std::string>& args)
     if (layerManager_ && layerManager_->getLayerCount() > 0) {
         auto layers = layerManager_->getLayers();
         if (!layers.empty() && layers[0]) {
-            double scale = std::atof(args[0].c_str());
-            int64_t offset = std::atoll(args[1].c_str());
+            double scale = args[0].toDouble();
+            int64_t offset = args[1].toInt64();
             layers[0]->setTimeScale(scale);
             layers[0]->setTimeOffset(offset);
             return true;
@@ -833,7 +1144,7 @@ bool RemoteCommandRouter::handleTimeScale2(const std::vector<std::string>& args)
     return false;
 }
 
-bool RemoteCommandRouter::handleLoop(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLoop(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -844,7 +1155,7 @@ bool RemoteCommandRouter::handleLoop(const std::vector<std::string>& args) {
         if (!layers.empty() && layers[0]) {
             bool enabled = false;
             if (!args.empty()) {
-                int val = std::atoi(args[0].c_str());
+                int val = args[0].toInt();
                 enabled = (val != 0);
             }
             layers[0]->setWraparound(enabled);
@@ -854,7 +1165,7 @@ bool RemoteCommandRouter::handleLoop(const std::vector<std::string>& args) {
     return false;
 }
 
-bool RemoteCommandRouter::handleReverse(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleReverse(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -870,29 +1181,29 @@ bool RemoteCommandRouter::handleReverse(const std::vector<std::string>& args) {
     return false;
 }
 
-bool RemoteCommandRouter::handleLayerTimeScale(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerTimeScale(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    double scale = std::atof(args[0].c_str());
+    double scale = args[0].toDouble();
     layer->setTimeScale(scale);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerTimeScale2(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerTimeScale2(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.size() < 2) {
         return false;
     }
     
-    double scale = std::atof(args[0].c_str());
-    int64_t offset = std::atoll(args[1].c_str());
+    double scale = args[0].toDouble();
+    int64_t offset = args[1].toInt64();
     layer->setTimeScale(scale);
     layer->setTimeOffset(offset);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerLoop(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerLoop(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -901,7 +1212,7 @@ bool RemoteCommandRouter::handleLayerLoop(VideoLayer* layer, const std::vector<s
     
     // Handle loop count if provided (second argument)
     if (args.size() >= 2) {
-        int loopCount = std::atoi(args[1].c_str());
+        int loopCount = args[1].toInt();
         props.fullFileLoopCount = loopCount;
         props.currentFullFileLoopCount = (loopCount > 0) ? loopCount : -1;
     }
@@ -909,7 +1220,7 @@ bool RemoteCommandRouter::handleLayerLoop(VideoLayer* layer, const std::vector<s
     // Handle enable/disable (first argument)
     bool enabled = false;
     if (!args.empty()) {
-        int val = std::atoi(args[0].c_str());
+        int val = args[0].toInt();
         enabled = (val != 0);
     }
     layer->setWraparound(enabled);
@@ -923,7 +1234,7 @@ bool RemoteCommandRouter::handleLayerLoop(VideoLayer* layer, const std::vector<s
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerReverse(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerReverse(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -932,7 +1243,7 @@ bool RemoteCommandRouter::handleLayerReverse(VideoLayer* layer, const std::vecto
     return true;
 }
 
-bool RemoteCommandRouter::handlePan(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handlePan(const CommandArgs& args) {
     if (!app_ || args.empty()) {
         return false;
     }
@@ -941,7 +1252,7 @@ bool RemoteCommandRouter::handlePan(const std::vector<std::string>& args) {
     if (layerManager_ && layerManager_->getLayerCount() > 0) {
         auto layers = layerManager_->getLayers();
         if (!layers.empty() && layers[0]) {
-            int panOffset = std::atoi(args[0].c_str());
+            int panOffset = args[0].toInt();
             auto& props = layers[0]->properties();
             
             // Enable panorama mode if not already enabled
@@ -962,12 +1273,12 @@ bool RemoteCommandRouter::handlePan(const std::vector<std::string>& args) {
     return false;
 }
 
-bool RemoteCommandRouter::handleLayerPan(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerPan(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    int panOffset = std::atoi(args[0].c_str());
+    int panOffset = args[0].toInt();
     auto& props = layer->properties();
     
     // Enable panorama mode if not already enabled
@@ -985,7 +1296,7 @@ bool RemoteCommandRouter::handleLayerPan(VideoLayer* layer, const std::vector<st
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCrop(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerCrop(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -997,10 +1308,10 @@ bool RemoteCommandRouter::handleLayerCrop(VideoLayer* layer, const std::vector<s
         props.crop.enabled = !props.crop.enabled;
     } else if (args.size() >= 4) {
         // Set crop rectangle: x, y, width, height
-        props.crop.x = std::atoi(args[0].c_str());
-        props.crop.y = std::atoi(args[1].c_str());
-        props.crop.width = std::atoi(args[2].c_str());
-        props.crop.height = std::atoi(args[3].c_str());
+        props.crop.x = args[0].toInt();
+        props.crop.y = args[1].toInt();
+        props.crop.width = args[2].toInt();
+        props.crop.height = args[3].toInt();
         props.crop.enabled = true;
     } else {
         return false;
@@ -1009,7 +1320,7 @@ bool RemoteCommandRouter::handleLayerCrop(VideoLayer* layer, const std::vector<s
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCropDisable(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerCropDisable(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -1018,7 +1329,7 @@ bool RemoteCommandRouter::handleLayerCropDisable(VideoLayer* layer, const std::v
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerPanorama(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerPanorama(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -1030,25 +1341,27 @@ bool RemoteCommandRouter::handleLayerPanorama(VideoLayer* layer, const std::vect
         props.panoramaMode = !props.panoramaMode;
     } else {
         // Enable/disable based on argument
-        int enabled = std::atoi(args[0].c_str());
+        int enabled = args[0].toInt();
         props.panoramaMode = (enabled != 0);
     }
     
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerLoad(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerLoad(const CommandArgs& args) {
     if (!app_ || args.size() < 2) {
         return false;
     }
     
     std::string filepath = args[0];
     std::string cueId = args[1];
+    int priority = args.size() > 2 ? args[2].toInt() : 1;
+    bool preload = args.size() > 3 && args[3].toInt() != 0;
     
-    return app_->createLayerWithFile(cueId, filepath);
+    return app_->createLayerWithFile(cueId, filepath, priority, preload);
 }
 
-bool RemoteCommandRouter::handleLayerFile(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerFile(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || !app_ || args.empty()) {
         return false;
     }
@@ -1065,7 +1378,7 @@ bool RemoteCommandRouter::handleLayerFile(VideoLayer* layer, const std::vector<s
     return app_->loadFileIntoLayer(cueId, filepath);
 }
 
-bool RemoteCommandRouter::handleLayerUnload(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerUnload(const CommandArgs& args) {
     if (!app_ || args.empty()) {
         return false;
     }
@@ -1074,29 +1387,49 @@ bool RemoteCommandRouter::handleLayerUnload(const std::vector<std::string>& args
     return app_->unloadFileFromLayer(cueId);
 }
 
-bool RemoteCommandRouter::handleLayerAutoUnload(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerPrioritize(const CommandArgs& args) {
+    if (!app_ || args.empty()) {
+        return false;
+    }
+    
+    // Default: the cue goes next
+    int priority = args.size() > 1 ? args[1].toInt() : 2;
+    return app_->prioritizeLoad(args[0], priority);
+}
+
+bool RemoteCommandRouter::handleLayerAutoUnload(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    int enabled = std::atoi(args[0].c_str());
+    int enabled = args[0].toInt();
     layer->properties().autoUnload = (enabled != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerLoopRegion(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerPreload(VideoLayer* layer, const CommandArgs& args) {
+    // Expected: /videocomposer/layer/<cueId>/preload <0|1> (applies to the next file loaded)
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    layer->properties().preload = args[0].toInt() != 0;
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerLoopRegion(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.size() < 2) {
         return false;
     }
     
     auto& props = layer->properties();
-    props.loopRegion.startFrame = std::atoll(args[0].c_str());
-    props.loopRegion.endFrame = std::atoll(args[1].c_str());
+    props.loopRegion.startFrame = args[0].toInt64();
+    props.loopRegion.endFrame = args[1].toInt64();
     props.loopRegion.enabled = true;
     
     // Set loop count if provided (third argument)
     if (args.size() >= 3) {
-        props.loopRegion.loopCount = std::atoi(args[2].c_str());
+        props.loopRegion.loopCount = args[2].toInt();
     } else {
         props.loopRegion.loopCount = -1; // Infinite
     }
@@ -1107,7 +1440,7 @@ bool RemoteCommandRouter::handleLayerLoopRegion(VideoLayer* layer, const std::ve
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerLoopRegionDisable(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerLoopRegionDisable(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -1117,7 +1450,7 @@ bool RemoteCommandRouter::handleLayerLoopRegionDisable(VideoLayer* layer, const
 }
 
 
-bool RemoteCommandRouter::handleLayerOffset(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerOffset(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
@@ -1147,297 +1480,600 @@ bool RemoteCommandRouter::handleLayerOffset(VideoLayer* layer, const std::vector
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerMtcFollow(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerMtcFollow(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    int enabled = std::atoi(args[0].c_str());
+    int enabled = args[0].toInt();
     layer->setMtcFollow(enabled != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerScale(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.size() < 2) {
+bool RemoteCommandRouter::handleLayerArm(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer) {
         return false;
     }
     
-    auto& props = layer->properties();
-    props.scaleX = std::atof(args[0].c_str());
-    props.scaleY = std::atof(args[1].c_str());
+    // Expected: /videocomposer/layer/<cueId>/arm [frame or SMPTE] (default: frame 0)
+    int64_t frame = 0;
+    if (!args.empty()) {
+        const std::string& arg = args[0];
+        if (arg.find(':') != std::string::npos || arg.find(';') != std::string::npos) {
+            FrameInfo info = layer->getFrameInfo();
+            double framerate = info.framerate > 0 ? info.framerate : 25.0;
+            bool haveDropframes = (arg.find(';') != std::string::npos);
+            frame = SMPTEUtils::smpteStringToFrame(arg, framerate, haveDropframes, false, true);
+        } else {
+            frame = std::atoll(arg.c_str());
+        }
+    }
+    
+    layer->arm(frame);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerXScale(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.empty()) {
+bool RemoteCommandRouter::handleLayerGo(VideoLayer* layer, const CommandArgs& args) {
+    (void)args;
+    if (!layer) {
         return false;
     }
     
-    layer->properties().scaleX = std::atof(args[0].c_str());
+    // Expected: /videocomposer/layer/<cueId>/go - shown from the next composite
+    layer->go();
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerYScale(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.empty()) {
+bool RemoteCommandRouter::handleLayerCues(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer) {
         return false;
     }
     
-    layer->properties().scaleY = std::atof(args[0].c_str());
+    // Expected: /videocomposer/layer/<cueId>/cues [tc ...] (frames or SMPTE, no args = clear)
+    FrameInfo info = layer->getFrameInfo();
+    double framerate = info.framerate > 0 ? info.framerate : 25.0;
+    
+    std::vector<int64_t> cues;
+    cues.reserve(args.size());
+    for (const CommandArg& arg : args) {
+        std::string_view text = arg.view();
+        if (text.find(':') != std::string_view::npos || text.find(';') != std::string_view::npos) {
+            bool haveDropframes = (text.find(';') != std::string_view::npos);
+            cues.push_back(SMPTEUtils::smpteStringToFrame(arg.str(), framerate, haveDropframes, false, true));
+        } else {
+            cues.push_back(arg.toInt64());
+        }
+    }
+    
+    layer->setCuePoints(cues);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerRotation(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerDecodePriority(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    layer->properties().rotation = std::atof(args[0].c_str());
+    // Expected: /videocomposer/layer/<cueId>/decode_priority <n> (1 = default)
+    int priority = args[0].toInt();
+    if (priority < 1) {
+        LOG_WARNING << "Decode priority must be >= 1, got " << args[0];
+        return false;
+    }
+    layer->setDecodePriority(priority);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCornerDeform(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.size() < 8) {
+bool RemoteCommandRouter::handleLayerUnderrunPolicy(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    auto& props = layer->properties();
-    // Corner deform expects 8 float values: 4 corners * (x_offset, y_offset)
-    // Format: corner0_x, corner0_y, corner1_x, corner1_y, corner2_x, corner2_y, corner3_x, corner3_y
-    for (int i = 0; i < 8; i++) {
-        props.cornerDeform.corners[i] = std::atof(args[i].c_str());
+    // Expected: /videocomposer/layer/<cueId>/underrun_policy block|hold|drop
+    InputSource::UnderrunPolicy policy;
+    if (args[0] == "block") {
+        policy = InputSource::UnderrunPolicy::BLOCK;
+    } else if (args[0] == "hold") {
+        policy = InputSource::UnderrunPolicy::HOLD;
+    } else if (args[0] == "drop") {
+        policy = InputSource::UnderrunPolicy::DROP;
+    } else {
+        LOG_WARNING << "Unknown underrun policy: " << args[0] << " (expected block, hold or drop)";
+        return false;
     }
+    layer->setUnderrunPolicy(policy);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCornerDeformEnable(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerLoopCache(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    layer->properties().cornerDeform.enabled = (std::atoi(args[0].c_str()) != 0);
+    // Expected: /videocomposer/layer/<cueId>/loop_cache off|on|compressed
+    LoopFrameCache::Mode mode;
+    if (!LoopFrameCache::parseMode(args[0].str(), mode)) {
+        LOG_WARNING << "Unknown loop cache mode: " << args[0].str() << " (expected off, on or compressed)";
+        return false;
+    }
+    layer->setLoopCacheMode(mode);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCornerDeformHQ(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerSuspendHidden(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    layer->properties().cornerDeform.highQuality = (std::atoi(args[0].c_str()) != 0);
+    // Expected: /videocomposer/layer/<cueId>/suspend_hidden 0|1
+    int enabled = args[0].toInt();
+    layer->setSuspendWhenOccluded(enabled != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCorners(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.size() < 8) {
+bool RemoteCommandRouter::handleLayerCritical(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    auto& props = layer->properties();
-    for (int i = 0; i < 8; ++i) {
-        props.cornerDeform.corners[i] = std::atof(args[i].c_str());
-    }
-    props.cornerDeform.enabled = true;
+    // Expected: /videocomposer/layer/<cueId>/critical 0|1 (never degraded by the load governor)
+    int critical = args[0].toInt();
+    layer->setCritical(critical != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCorner1(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerScale(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.size() < 2) {
         return false;
     }
     
     auto& props = layer->properties();
-    props.cornerDeform.corners[0] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[1] = std::atof(args[1].c_str());
-    props.cornerDeform.enabled = true;
+    props.scaleX = args[0].toFloat();
+    props.scaleY = args[1].toFloat();
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCorner2(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.size() < 2) {
+bool RemoteCommandRouter::handleLayerXScale(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    auto& props = layer->properties();
-    props.cornerDeform.corners[2] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[3] = std::atof(args[1].c_str());
-    props.cornerDeform.enabled = true;
+    layer->properties().scaleX = args[0].toFloat();
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCorner3(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.size() < 2) {
+bool RemoteCommandRouter::handleLayerYScale(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    auto& props = layer->properties();
-    props.cornerDeform.corners[4] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[5] = std::atof(args[1].c_str());
-    props.cornerDeform.enabled = true;
+    layer->properties().scaleY = args[0].toFloat();
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerCorner4(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.size() < 2) {
+bool RemoteCommandRouter::handleLayerRotation(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    auto& props = layer->properties();
-    props.cornerDeform.corners[6] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[7] = std::atof(args[1].c_str());
-    props.cornerDeform.enabled = true;
+    layer->properties().rotation = args[0].toFloat();
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerBlendMode(VideoLayer* layer, const std::vector<std::string>& args) {
-    if (!layer || args.empty()) {
+bool RemoteCommandRouter::handleLayerCornerDeform(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.size() < 8) {
         return false;
     }
     
-    int mode = std::atoi(args[0].c_str());
     auto& props = layer->properties();
-    
-    switch (mode) {
-        case 0:
-            props.blendMode = LayerProperties::NORMAL;
-            break;
-        case 1:
-            props.blendMode = LayerProperties::MULTIPLY;
-            break;
-        case 2:
-            props.blendMode = LayerProperties::SCREEN;
-            break;
-        case 3:
-            props.blendMode = LayerProperties::OVERLAY;
-            break;
-        default:
-            return false;
+    // Corner deform expects 8 float values: 4 corners * (x_offset, y_offset)
+    // Format: corner0_x, corner0_y, corner1_x, corner1_y, corner2_x, corner2_y, corner3_x, corner3_y
+    for (int i = 0; i < 8; i++) {
+        props.cornerDeform.corners[i] = args[i].toFloat();
     }
-    
     return true;
 }
 
-// Master layer handlers (composite transforms)
-bool RemoteCommandRouter::handleMasterOpacity(const std::vector<std::string>& args) {
-    if (args.empty() || !app_) {
+bool RemoteCommandRouter::handleLayerCornerDeformEnable(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    float opacity = std::atof(args[0].c_str());
-    app_->renderer().masterProperties().opacity = std::max(0.0f, std::min(1.0f, opacity));
+    layer->properties().cornerDeform.enabled = (args[0].toInt() != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterPosition(const std::vector<std::string>& args) {
-    if (args.size() < 2 || !app_) {
+bool RemoteCommandRouter::handleLayerCornerDeformHQ(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
         return false;
     }
     
-    auto& props = app_->renderer().masterProperties();
-    props.x = std::atof(args[0].c_str());
-    props.y = std::atof(args[1].c_str());
+    layer->properties().cornerDeform.highQuality = (args[0].toInt() != 0);
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterScale(const std::vector<std::string>& args) {
-    if (args.size() < 2 || !app_) {
+bool RemoteCommandRouter::handleLayerAnimate(VideoLayer* layer, const CommandArgs& args) {
+    // Expected: /videocomposer/layer/<cueId>/animate s:property f:seconds f:value [f ...] [s:easing]
+    if (!layer || args.size() < 3) {
+        return false;
+    }
+    const AnimatedProperty* property = findAnimatedProperty(args[0].view());
+    if (!property) {
+        LOG_WARNING << "animate: Unknown property " << args[0];
+        return false;
+    }
+    size_t values = static_cast<size_t>(property->count);
+    if (args.size() < 2 + values) {
+        LOG_WARNING << "animate: " << property->name << " needs " << values << " value(s)";
+        return false;
+    }
+    PropertyAnimator::Easing easing = PropertyAnimator::Easing::LINEAR;
+    if (args.size() > 2 + values && !PropertyAnimator::parseEasing(args[2 + values].view(), easing)) {
+        LOG_WARNING << "animate: Unknown easing " << args[2 + values] << " (expected linear, in, out, inout or smooth)";
         return false;
     }
     
-    auto& props = app_->renderer().masterProperties();
-    props.scaleX = std::atof(args[0].c_str());
-    props.scaleY = std::atof(args[1].c_str());
+    int64_t durationUs = static_cast<int64_t>(args[1].toDouble() * 1e6);
+    for (size_t i = 0; i < values; ++i) {
+        float target = args[2 + i].toFloat();
+        if (property->first == PropertyAnimator::Property::HUE) {
+            // Wrap hue to -180 to 180, like /hue
+            while (target > 180.0f) target -= 360.0f;
+            while (target < -180.0f) target += 360.0f;
+        }
+        layer->animator().animate(offsetProperty(property->first, static_cast<int>(i)), target, durationUs, easing);
+    }
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterXScale(const std::vector<std::string>& args) {
-    if (args.empty() || !app_) {
+bool RemoteCommandRouter::handleLayerAnimateStop(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer) {
         return false;
     }
-    
-    app_->renderer().masterProperties().scaleX = std::atof(args[0].c_str());
+    if (args.empty()) {
+        layer->animator().stopAll();
+        return true;
+    }
+    const AnimatedProperty* property = findAnimatedProperty(args[0].view());
+    if (!property) {
+        LOG_WARNING << "animate/stop: Unknown property " << args[0];
+        return false;
+    }
+    for (int i = 0; i < property->count; ++i) {
+        layer->animator().stop(offsetProperty(property->first, i));
+    }
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterYScale(const std::vector<std::string>& args) {
-    if (args.empty() || !app_) {
+bool RemoteCommandRouter::handleLayerCorners(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.size() < 8) {
         return false;
     }
     
-    app_->renderer().masterProperties().scaleY = std::atof(args[0].c_str());
+    auto& props = layer->properties();
+    for (int i = 0; i < 8; ++i) {
+        props.cornerDeform.corners[i] = args[i].toFloat();
+    }
+    props.cornerDeform.enabled = true;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterRotation(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerCorner1(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.size() < 2) {
+        return false;
+    }
+    
+    auto& props = layer->properties();
+    props.cornerDeform.corners[0] = args[0].toFloat();
+    props.cornerDeform.corners[1] = args[1].toFloat();
+    props.cornerDeform.enabled = true;
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerCorner2(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.size() < 2) {
+        return false;
+    }
+    
+    auto& props = layer->properties();
+    props.cornerDeform.corners[2] = args[0].toFloat();
+    props.cornerDeform.corners[3] = args[1].toFloat();
+    props.cornerDeform.enabled = true;
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerCorner3(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.size() < 2) {
+        return false;
+    }
+    
+    auto& props = layer->properties();
+    props.cornerDeform.corners[4] = args[0].toFloat();
+    props.cornerDeform.corners[5] = args[1].toFloat();
+    props.cornerDeform.enabled = true;
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerCorner4(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.size() < 2) {
+        return false;
+    }
+    
+    auto& props = layer->properties();
+    props.cornerDeform.corners[6] = args[0].toFloat();
+    props.cornerDeform.corners[7] = args[1].toFloat();
+    props.cornerDeform.enabled = true;
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerBlendMode(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    return parseBlendMode(args[0].toInt(), layer->properties().blendMode);
+}
+
+bool RemoteCommandRouter::handleLayerPackedAlpha(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    LayerProperties& props = layer->properties();
+    if (!PackedAlpha::parseLayout(args[0].str(), props.packedAlpha)) {
+        LOG_WARNING << "Unknown packed alpha layout: " << args[0].str();
+        return false;
+    }
+    props.packedAlphaPremultiplied = args.size() > 1 && args[1].toInt() != 0;
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerBlur(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    layer->properties().effects.blurRadius = std::max(0.0f, args[0].toFloat());
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerSharpen(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    LayerProperties::Effects& effects = layer->properties().effects;
+    effects.sharpenAmount = std::max(0.0f, args[0].toFloat());
+    if (args.size() > 1) {
+        effects.sharpenRadius = std::max(0.5f, args[1].toFloat());
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerChromaKey(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    LayerProperties::Effects::ChromaKey& key = layer->properties().effects.chromaKey;
+    key.enabled = args[0].toInt() != 0;
+    if (args.size() >= 4) {
+        key.red = std::clamp(args[1].toFloat(), 0.0f, 1.0f);
+        key.green = std::clamp(args[2].toFloat(), 0.0f, 1.0f);
+        key.blue = std::clamp(args[3].toFloat(), 0.0f, 1.0f);
+    }
+    if (args.size() >= 7) {
+        key.similarity = std::clamp(args[4].toFloat(), 0.0f, 1.0f);
+        key.smoothness = std::clamp(args[5].toFloat(), 0.0f, 1.0f);
+        key.spill = std::clamp(args[6].toFloat(), 0.0f, 1.0f);
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerVignette(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || args.empty()) {
+        return false;
+    }
+    
+    LayerProperties::Effects& effects = layer->properties().effects;
+    effects.vignetteAmount = std::clamp(args[0].toFloat(), 0.0f, 1.0f);
+    if (args.size() > 1) {
+        effects.vignetteSoftness = std::clamp(args[1].toFloat(), 0.0f, 1.0f);
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerGroup(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer || !layerManager_) {
+        return false;
+    }
+    std::string_view name = args.empty() ? std::string_view() : args[0].view();
+    if (name == "none") {
+        name = std::string_view();
+    }
+    return layerManager_->setLayerGroup(layer->getLayerId(), name);
+}
+
+bool RemoteCommandRouter::handleGroupPosition(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.size() < 2) {
+        return false;
+    }
+    group->properties.x = static_cast<int>(args[0].toFloat());
+    group->properties.y = static_cast<int>(args[1].toFloat());
+    return true;
+}
+
+bool RemoteCommandRouter::handleGroupOpacity(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.empty()) {
+        return false;
+    }
+    group->properties.opacity = std::max(0.0f, std::min(1.0f, args[0].toFloat()));
+    return true;
+}
+
+bool RemoteCommandRouter::handleGroupVisible(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.empty()) {
+        return false;
+    }
+    group->properties.visible = args[0].toInt() != 0;
+    return true;
+}
+
+bool RemoteCommandRouter::handleGroupZOrder(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.empty()) {
+        return false;
+    }
+    group->properties.zOrder = args[0].toInt();
+    return true;
+}
+
+bool RemoteCommandRouter::handleGroupScale(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.empty()) {
+        return false;
+    }
+    // One value scales uniformly
+    group->properties.scaleX = args[0].toFloat();
+    group->properties.scaleY = args.size() > 1 ? args[1].toFloat() : group->properties.scaleX;
+    return true;
+}
+
+bool RemoteCommandRouter::handleGroupRotation(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.empty()) {
+        return false;
+    }
+    group->properties.rotation = args[0].toFloat();
+    return true;
+}
+
+bool RemoteCommandRouter::handleGroupBlendMode(LayerGroup* group, const CommandArgs& args) {
+    if (!group || args.empty()) {
+        return false;
+    }
+    return parseBlendMode(args[0].toInt(), group->properties.blendMode);
+}
+
+// Master layer handlers (composite transforms)
+bool RemoteCommandRouter::handleMasterOpacity(const CommandArgs& args) {
+    if (args.empty() || !app_) {
+        return false;
+    }
+    
+    float opacity = args[0].toFloat();
+    app_->renderer().masterProperties().opacity = std::max(0.0f, std::min(1.0f, opacity));
+    return true;
+}
+
+bool RemoteCommandRouter::handleMasterPosition(const CommandArgs& args) {
+    if (args.size() < 2 || !app_) {
+        return false;
+    }
+    
+    auto& props = app_->renderer().masterProperties();
+    props.x = args[0].toFloat();
+    props.y = args[1].toFloat();
+    return true;
+}
+
+bool RemoteCommandRouter::handleMasterScale(const CommandArgs& args) {
+    if (args.size() < 2 || !app_) {
+        return false;
+    }
+    
+    auto& props = app_->renderer().masterProperties();
+    props.scaleX = args[0].toFloat();
+    props.scaleY = args[1].toFloat();
+    return true;
+}
+
+bool RemoteCommandRouter::handleMasterXScale(const CommandArgs& args) {
+    if (args.empty() || !app_) {
+        return false;
+    }
+    
+    app_->renderer().masterProperties().scaleX = args[0].toFloat();
+    return true;
+}
+
+bool RemoteCommandRouter::handleMasterYScale(const CommandArgs& args) {
+    if (args.empty() || !app_) {
+        return false;
+    }
+    
+    app_->renderer().masterProperties().scaleY = args[0].toFloat();
+    return true;
+}
+
+bool RemoteCommandRouter::handleMasterRotation(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    app_->renderer().masterProperties().rotation = std::atof(args[0].c_str());
+    app_->renderer().masterProperties().rotation = args[0].toFloat();
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterCorners(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterCorners(const CommandArgs& args) {
     if (args.size() < 8 || !app_) {
         return false;
     }
     
     auto& props = app_->renderer().masterProperties();
     for (int i = 0; i < 8; ++i) {
-        props.cornerDeform.corners[i] = std::atof(args[i].c_str());
+        props.cornerDeform.corners[i] = args[i].toFloat();
     }
     props.cornerDeform.enabled = true;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterCorner1(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterCorner1(const CommandArgs& args) {
     if (args.size() < 2 || !app_) {
         return false;
     }
     
     auto& props = app_->renderer().masterProperties();
-    props.cornerDeform.corners[0] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[1] = std::atof(args[1].c_str());
+    props.cornerDeform.corners[0] = args[0].toFloat();
+    props.cornerDeform.corners[1] = args[1].toFloat();
     props.cornerDeform.enabled = true;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterCorner2(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterCorner2(const CommandArgs& args) {
     if (args.size() < 2 || !app_) {
         return false;
     }
     
     auto& props = app_->renderer().masterProperties();
-    props.cornerDeform.corners[2] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[3] = std::atof(args[1].c_str());
+    props.cornerDeform.corners[2] = args[0].toFloat();
+    props.cornerDeform.corners[3] = args[1].toFloat();
     props.cornerDeform.enabled = true;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterCorner3(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterCorner3(const CommandArgs& args) {
     if (args.size() < 2 || !app_) {
         return false;
     }
     
     auto& props = app_->renderer().masterProperties();
-    props.cornerDeform.corners[4] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[5] = std::atof(args[1].c_str());
+    props.cornerDeform.corners[4] = args[0].toFloat();
+    props.cornerDeform.corners[5] = args[1].toFloat();
     props.cornerDeform.enabled = true;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterCorner4(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterCorner4(const CommandArgs& args) {
     if (args.size() < 2 || !app_) {
         return false;
     }
     
     auto& props = app_->renderer().masterProperties();
-    props.cornerDeform.corners[6] = std::atof(args[0].c_str());
-    props.cornerDeform.corners[7] = std::atof(args[1].c_str());
+    props.cornerDeform.corners[6] = args[0].toFloat();
+    props.cornerDeform.corners[7] = args[1].toFloat();
     props.cornerDeform.enabled = true;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterReset(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterReset(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -1447,45 +2083,45 @@ bool RemoteCommandRouter::handleMasterReset(const std::vector<std::string>& args
 }
 
 // Layer color correction handlers
-bool RemoteCommandRouter::handleLayerBrightness(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerBrightness(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    float brightness = std::atof(args[0].c_str());
+    float brightness = args[0].toFloat();
     brightness = std::max(-1.0f, std::min(1.0f, brightness));  // Clamp to -1 to 1
     layer->properties().colorAdjust.brightness = brightness;
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerContrast(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerContrast(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    float contrast = std::atof(args[0].c_str());
+    float contrast = args[0].toFloat();
     contrast = std::max(0.0f, std::min(2.0f, contrast));  // Clamp to 0 to 2
     layer->properties().colorAdjust.contrast = contrast;
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerSaturation(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerSaturation(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    float saturation = std::atof(args[0].c_str());
+    float saturation = args[0].toFloat();
     saturation = std::max(0.0f, std::min(2.0f, saturation));  // Clamp to 0 to 2
     layer->properties().colorAdjust.saturation = saturation;
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerHue(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerHue(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    float hue = std::atof(args[0].c_str());
+    float hue = args[0].toFloat();
     // Wrap hue to -180 to 180
     while (hue > 180.0f) hue -= 360.0f;
     while (hue < -180.0f) hue += 360.0f;
@@ -1493,18 +2129,28 @@ bool RemoteCommandRouter::handleLayerHue(VideoLayer* layer, const std::vector<st
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerGamma(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerGamma(VideoLayer* layer, const CommandArgs& args) {
     if (!layer || args.empty()) {
         return false;
     }
     
-    float gamma = std::atof(args[0].c_str());
+    float gamma = args[0].toFloat();
     gamma = std::max(0.1f, std::min(3.0f, gamma));  // Clamp to 0.1 to 3
     layer->properties().colorAdjust.gamma = gamma;
     return true;
 }
 
-bool RemoteCommandRouter::handleLayerColorReset(VideoLayer* layer, const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleLayerLut(VideoLayer* layer, const CommandArgs& args) {
+    if (!layer) {
+        return false;
+    }
+    
+    // .cube table applied after the adjustments; no argument or "" removes it
+    layer->properties().colorAdjust.lutFile = args.empty() ? std::string() : args[0].str();
+    return true;
+}
+
+bool RemoteCommandRouter::handleLayerColorReset(VideoLayer* layer, const CommandArgs& args) {
     if (!layer) {
         return false;
     }
@@ -1514,63 +2160,73 @@ bool RemoteCommandRouter::handleLayerColorReset(VideoLayer* layer, const std::ve
 }
 
 // Master color correction handlers
-bool RemoteCommandRouter::handleMasterBrightness(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterBrightness(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    float brightness = std::atof(args[0].c_str());
+    float brightness = args[0].toFloat();
     brightness = std::max(-1.0f, std::min(1.0f, brightness));
     app_->renderer().masterProperties().colorAdjust.brightness = brightness;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterContrast(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterContrast(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    float contrast = std::atof(args[0].c_str());
+    float contrast = args[0].toFloat();
     contrast = std::max(0.0f, std::min(2.0f, contrast));
     app_->renderer().masterProperties().colorAdjust.contrast = contrast;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterSaturation(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterSaturation(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    float saturation = std::atof(args[0].c_str());
+    float saturation = args[0].toFloat();
     saturation = std::max(0.0f, std::min(2.0f, saturation));
     app_->renderer().masterProperties().colorAdjust.saturation = saturation;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterHue(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterHue(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    float hue = std::atof(args[0].c_str());
+    float hue = args[0].toFloat();
     while (hue > 180.0f) hue -= 360.0f;
     while (hue < -180.0f) hue += 360.0f;
     app_->renderer().masterProperties().colorAdjust.hue = hue;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterGamma(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterGamma(const CommandArgs& args) {
     if (args.empty() || !app_) {
         return false;
     }
     
-    float gamma = std::atof(args[0].c_str());
+    float gamma = args[0].toFloat();
     gamma = std::max(0.1f, std::min(3.0f, gamma));
     app_->renderer().masterProperties().colorAdjust.gamma = gamma;
     return true;
 }
 
-bool RemoteCommandRouter::handleMasterColorReset(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleMasterLut(const CommandArgs& args) {
+    if (!app_) {
+        return false;
+    }
+    
+    // Venue calibration for the whole composite; no argument or "" removes it
+    app_->renderer().masterProperties().colorAdjust.lutFile = args.empty() ? std::string() : args[0].str();
+    return true;
+}
+
+bool RemoteCommandRouter::handleMasterColorReset(const CommandArgs& args) {
     if (!app_) {
         return false;
     }
@@ -1583,7 +2239,7 @@ bool RemoteCommandRouter::handleMasterColorReset(const std::vector<std::string>&
 // Display Configuration Handlers (Phase 4)
 // ============================================================================
 
-bool RemoteCommandRouter::handleDisplayList(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayList(const CommandArgs& args) {
     (void)args;  // No arguments needed
     
     auto* backend = app_->getDisplayBackend();
@@ -1606,7 +2262,7 @@ bool RemoteCommandRouter::handleDisplayList(const std::vector<std::string>& args
     return true;
 }
 
-bool RemoteCommandRouter::handleDisplayModes(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayModes(const CommandArgs& args) {
     // Expected: /videocomposer/display/modes <outputName>
     if (args.empty()) {
         LOG_WARNING << "display/modes requires: <outputName>";
@@ -1650,7 +2306,7 @@ bool RemoteCommandRouter::handleDisplayModes(const std::vector<std::string>& arg
     return true;
 }
 
-bool RemoteCommandRouter::handleDisplayMode(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayMode(const CommandArgs& args) {
     // Expected: /videocomposer/display/mode <name> <width> <height> [refresh]
     LOG_INFO << "handleDisplayMode called with " << args.size() << " args";
     for (size_t i = 0; i < args.size(); ++i) {
@@ -1669,9 +2325,9 @@ bool RemoteCommandRouter::handleDisplayMode(const std::vector<std::string>& args
     }
     
     std::string name = args[0];
-    int width = std::atoi(args[1].c_str());
-    int height = std::atoi(args[2].c_str());
-    double refresh = (args.size() > 3) ? std::atof(args[3].c_str()) : 0.0;
+    int width = args[1].toInt();
+    int height = args[2].toInt();
+    double refresh = (args.size() > 3) ? args[3].toDouble() : 0.0;
     
     LOG_INFO << "Parsed: name=" << name << " width=" << width << " height=" << height << " refresh=" << refresh;
     
@@ -1720,7 +2376,7 @@ bool RemoteCommandRouter::handleDisplayMode(const std::vector<std::string>& args
     return false;
 }
 
-bool RemoteCommandRouter::handleDisplayResolutionMode(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayResolutionMode(const CommandArgs& args) {
     // Expected: /videocomposer/display/resolution_mode <mode>
     // Modes: preferred, native, 1080p, 720p, 4k
     
@@ -1755,7 +2411,7 @@ bool RemoteCommandRouter::handleDisplayResolutionMode(const std::vector<std::str
     return false;
 }
 
-bool RemoteCommandRouter::handleDisplayRegion(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayRegion(const CommandArgs& args) {
     // Expected: /videocomposer/display/region <outputName> <canvasX> <canvasY> [width] [height]
     if (args.size() < 3) {
         LOG_WARNING << "display/region requires: <outputName> <canvasX> <canvasY> [width] [height]";
@@ -1769,10 +2425,10 @@ bool RemoteCommandRouter::handleDisplayRegion(const std::vector<std::string>& ar
     }
     
     std::string outputName = args[0];
-    int canvasX = std::atoi(args[1].c_str());
-    int canvasY = std::atoi(args[2].c_str());
-    int width = (args.size() > 3) ? std::atoi(args[3].c_str()) : 0;
-    int height = (args.size() > 4) ? std::atoi(args[4].c_str()) : 0;
+    int canvasX = args[1].toInt();
+    int canvasY = args[2].toInt();
+    int width = (args.size() > 3) ? args[3].toInt() : 0;
+    int height = (args.size() > 4) ? args[4].toInt() : 0;
     
     if (backend->configureOutputRegion(outputName, canvasX, canvasY, width, height)) {
         LOG_INFO << "Configured region for " << outputName 
@@ -1787,7 +2443,7 @@ bool RemoteCommandRouter::handleDisplayRegion(const std::vector<std::string>& ar
     return false;
 }
 
-bool RemoteCommandRouter::handleDisplayAssign(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayAssign(const CommandArgs& args) {
     // Expected: /videocomposer/display/assign <layerId> <outputName>
     // NOTE: In Virtual Canvas mode, layers render to the canvas, not directly to outputs.
     // This command is a legacy holdover and may be deprecated.
@@ -1796,7 +2452,7 @@ bool RemoteCommandRouter::handleDisplayAssign(const std::vector<std::string>& ar
         return false;
     }
     
-    int layerId = std::atoi(args[0].c_str());
+    int layerId = args[0].toInt();
     std::string outputName = args[1];
     
     LOG_INFO << "Layer " << layerId << " assigned to output " << outputName
@@ -1805,7 +2461,7 @@ bool RemoteCommandRouter::handleDisplayAssign(const std::vector<std::string>& ar
     return true;
 }
 
-bool RemoteCommandRouter::handleDisplayBlend(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayBlend(const CommandArgs& args) {
     // Expected: /videocomposer/display/blend <outputName> <left> <right> <top> <bottom> [gamma]
     if (args.size() < 5) {
         LOG_WARNING << "display/blend requires: <outputName> <left> <right> <top> <bottom> [gamma]";
@@ -1819,11 +2475,11 @@ bool RemoteCommandRouter::handleDisplayBlend(const std::vector<std::string>& arg
     }
     
     std::string outputName = args[0];
-    float left = std::atof(args[1].c_str());
-    float right = std::atof(args[2].c_str());
-    float top = std::atof(args[3].c_str());
-    float bottom = std::atof(args[4].c_str());
-    float gamma = (args.size() > 5) ? std::atof(args[5].c_str()) : 2.2f;
+    float left = args[1].toFloat();
+    float right = args[2].toFloat();
+    float top = args[3].toFloat();
+    float bottom = args[4].toFloat();
+    float gamma = (args.size() > 5) ? args[5].toFloat() : 2.2f;
     
     if (backend->configureOutputBlend(outputName, left, right, top, bottom, gamma)) {
         LOG_INFO << "Configured blend for " << outputName 
@@ -1836,7 +2492,7 @@ bool RemoteCommandRouter::handleDisplayBlend(const std::vector<std::string>& arg
     return false;
 }
 
-bool RemoteCommandRouter::handleDisplaySave(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplaySave(const CommandArgs& args) {
     // Expected: /videocomposer/display/save [path]
     auto* backend = app_->getDisplayBackend();
     if (!backend) {
@@ -1844,7 +2500,7 @@ bool RemoteCommandRouter::handleDisplaySave(const std::vector<std::string>& args
         return false;
     }
     
-    std::string path = args.empty() ? "" : args[0];
+    std::string path = args.empty() ? std::string() : args[0].str();
     
     if (backend->saveConfiguration(path)) {
         LOG_INFO << "Display configuration saved" 
@@ -1856,7 +2512,7 @@ bool RemoteCommandRouter::handleDisplaySave(const std::vector<std::string>& args
     return false;
 }
 
-bool RemoteCommandRouter::handleDisplayLoad(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleDisplayLoad(const CommandArgs& args) {
     // Expected: /videocomposer/display/load [path]
     auto* backend = app_->getDisplayBackend();
     if (!backend) {
@@ -1864,7 +2520,7 @@ bool RemoteCommandRouter::handleDisplayLoad(const std::vector<std::string>& args
         return false;
     }
     
-    std::string path = args.empty() ? "" : args[0];
+    std::string path = args.empty() ? std::string() : args[0].str();
     
     if (backend->loadConfiguration(path)) {
         LOG_INFO << "Display configuration loaded" 
@@ -1881,7 +2537,7 @@ bool RemoteCommandRouter::handleDisplayLoad(const std::vector<std::string>& args
 // Virtual Output Handlers (Phase 6)
 // ============================================================================
 
-bool RemoteCommandRouter::handleOutputCapture(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOutputCapture(const CommandArgs& args) {
     // Expected: /videocomposer/output/capture <enable|disable|status>
     //           /videocomposer/output/capture enable [width] [height]
     if (args.empty()) {
@@ -1904,8 +2560,8 @@ bool RemoteCommandRouter::handleOutputCapture(const std::vector<std::string>& ar
     }
     
     if (action == "enable" || action == "1" || action == "on") {
-        int width = (args.size() > 1) ? std::atoi(args[1].c_str()) : 0;
-        int height = (args.size() > 2) ? std::atoi(args[2].c_str()) : 0;
+        int width = (args.size() > 1) ? args[1].toInt() : 0;
+        int height = (args.size() > 2) ? args[2].toInt() : 0;
         
         backend->setCaptureEnabled(true, width, height);
         LOG_INFO << "Output capture enabled";
@@ -1925,7 +2581,7 @@ bool RemoteCommandRouter::handleOutputCapture(const std::vector<std::string>& ar
     return false;
 }
 
-bool RemoteCommandRouter::handleOutputList(const std::vector<std::string>& args) {
+bool RemoteCommandRouter::handleOutputList(const CommandArgs& args) {
     // Expected: /videocomposer/output/list
     (void)args;
     
@@ -1965,5 +2621,429 @@ bool RemoteCommandRouter::handleOutputList(const std::vector<std::string>& args)
     return true;
 }
 
-} // namespace videocomposer
+bool RemoteCommandRouter::handleShowPrewarm(const CommandArgs& args) {
+    // Expected: /videocomposer/show/prewarm s [s ...] (video file paths)
+    if (args.empty()) {
+        LOG_WARNING << "show/prewarm: Expected one or more file paths";
+        return false;
+    }
+    return app_->prewarmShowIndexes(args.toStrings());
+}
+
+bool RemoteCommandRouter::handleShowThumbnail(const CommandArgs& args) {
+    // Expected: /videocomposer/show/thumbnail path seconds [width] [host port]
+    // Answered with /videocomposer/thumbnail/ready (or /failed) to host:port, else the event_report target
+    if (args.size() < 2 || !args[0].isString()) {
+        LOG_WARNING << "show/thumbnail: expected path seconds [width] [host port]";
+        return false;
+    }
+    int width = args.size() > 2 ? args[2].toInt() : 0;
+    std::string target;
+    if (args.size() > 4) {
+        target = std::string(args[3].view()) + ":" + std::to_string(args[4].toInt());
+    }
+    return app_->requestThumbnail(args[0].str(), args[1].toDouble(), width, target);
+}
+
+bool RemoteCommandRouter::handleStatsFramePool(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/framepool [reset]
+    if (!layerManager_) {
+        return false;
+    }
+    
+    bool reset = !args.empty() && args[0] == "reset";
+    
+    size_t totalCapacity = 0;
+    size_t totalInUse = 0;
+    size_t totalBytes = 0;
+    uint64_t totalHits = 0;
+    uint64_t totalMisses = 0;
+    
+    LOG_INFO << "=== Frame Pools ===";
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        auto* videoInput = dynamic_cast<VideoFileInput*>(layer->getInputSource());
+        std::shared_ptr<FramePool> pool = videoInput ? videoInput->getFramePool() : nullptr;
+        if (!pool) {
+            continue;
+        }
+        
+        FramePool::Stats st = pool->getStats();
+        uint64_t lookups = st.hits + st.misses;
+        LOG_INFO << "  Layer " << layer->getLayerId()
+                 << " [" << layerManager_->getCueIdFromLayer(layer) << "]: "
+                 << st.inUse << "/" << st.capacity << " slots in use (peak " << st.peakInUse << ")"
+                 << ", " << (st.capacity * st.bytesPerFrame) / (1024 * 1024) << " MB"
+                 << ", hits " << st.hits << ", misses " << st.misses
+                 << (lookups > 0 ? " (" + std::to_string(st.hits * 100 / lookups) + "% hit)" : std::string())
+                 << ", exhausted " << st.exhausted;
+        
+        totalCapacity += st.capacity;
+        totalInUse += st.inUse;
+        totalBytes += st.capacity * st.bytesPerFrame;
+        totalHits += st.hits;
+        totalMisses += st.misses;
+        
+        if (reset) {
+            pool->resetStats();
+        }
+    }
+    LOG_INFO << "  Total: " << totalInUse << "/" << totalCapacity << " slots, "
+             << totalBytes / (1024 * 1024) << " MB, hits " << totalHits << ", misses " << totalMisses;
+    
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsUnderrun(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/underrun [reset]
+    if (!layerManager_) {
+        return false;
+    }
+    
+    bool reset = !args.empty() && args[0] == "reset";
+    static const char* const policyNames[] = {"block", "hold", "drop"};
+    
+    LOG_INFO << "=== Decode Underruns ===";
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        auto* videoInput = dynamic_cast<VideoFileInput*>(layer->getInputSource());
+        if (!videoInput) {
+            continue;
+        }
+        
+        VideoFileInput::UnderrunStats st = videoInput->getUnderrunStats();
+        LOG_INFO << "  Layer " << layer->getLayerId()
+                 << " [" << layerManager_->getCueIdFromLayer(layer) << "]: "
+                 << policyNames[static_cast<int>(videoInput->getUnderrunPolicy())]
+                 << ", misses " << st.misses << ", held " << st.held
+                 << ", resyncs " << st.resyncs << ", skipped " << st.skipped
+                 << ", sync decodes " << st.syncDecodes;
+        
+        if (reset) {
+            videoInput->resetUnderrunStats();
+        }
+    }
+    
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsIo(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/io
+    (void)args;
+    if (!layerManager_) {
+        return false;
+    }
+    
+    RamClipCache::Stats ram = RamClipCache::instance().getStats();
+    LOG_INFO << "=== Storage I/O ===";
+    LOG_INFO << "  Preloaded: " << ram.clips << " clip(s), " << ram.bytes / (1024 * 1024) << " MB ("
+             << ram.lockedBytes / (1024 * 1024) << " MB locked) of " << ram.budgetBytes / (1024 * 1024) << " MB";
+    PageCachePolicy::Stats cache = PageCachePolicy::instance().getStats();
+    LOG_INFO << "  Page cache: " << cache.prefetches << " prefetches (" << cache.prefetchBytes / (1024 * 1024)
+             << " MB), " << cache.drops << " drops (" << cache.droppedBytes / (1024 * 1024) << " MB), "
+             << cache.playheads << " playhead(s), " << cache.protectedRanges << " protected range(s)";
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        auto* videoInput = dynamic_cast<VideoFileInput*>(layer->getInputSource());
+        ReadAheadIO::Stats st;
+        if (!videoInput || !videoInput->getReadAheadStats(st)) {
+            continue;
+        }
+        
+        LOG_INFO << "  Layer " << layer->getLayerId()
+                 << " [" << layerManager_->getCueIdFromLayer(layer) << "]: "
+                 << (st.bytesRead / (1024 * 1024)) << " MB read in " << st.chunkReads << " chunks at "
+                 << st.throughputMBs << " MB/s, " << st.seeks << " seeks, "
+                 << st.stalls << " stalls (" << (st.stallUs / 1000) << " ms, max "
+                 << (st.maxStallUs / 1000) << " ms)";
+    }
+    
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsGpu(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/gpu [reset]
+    if (!app_) {
+        return false;
+    }
+    
+    GpuTimer& timer = app_->renderer().gpuTimer();
+    LOG_INFO << "=== GPU Timings (last " << GpuTimingStats::WINDOW << " frames) ===";
+    if (!timer.isActive()) {
+        LOG_INFO << (timer.isAvailable() ? "  GPU timers off" : "  GPU timers not supported");
+        return true;
+    }
+    for (const GpuTimingStats::Summary& summary : timer.stats().getSummaries()) {
+        LOG_INFO << "  " << GpuTimingStats::formatLine(summary);
+    }
+    LOG_INFO << "  Dropped query sets: " << timer.getDroppedFrames();
+    
+    if (!args.empty() && args[0] == "reset") {
+        timer.stats().reset();
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsMemory(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/memory [host port]
+    // With a target, also sends /videocomposer/memory/pool, /memory/subsystem
+    // and /memory/layer there (see VideoComposerApplication::sendMemoryReport)
+    LOG_INFO << "=== Memory Budget ===";
+    for (const std::string& line : MemoryBudget::instance().formatReport()) {
+        LOG_INFO << "  " << line;
+    }
+    
+    if (args.size() >= 2 && args[0].isString()) {
+        int port = args[1].toInt();
+        if (!app_ || port <= 0 || port > 65535) {
+            LOG_WARNING << "stats/memory: invalid port " << port;
+            return false;
+        }
+        return app_->sendMemoryReport(std::string(args[0].view()) + ":" + std::to_string(port));
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleSyncTestReport(const CommandArgs& args) {
+    // Expected: /videocomposer/synctest/report [reset]
+    SyncLatencyMonitor* monitor = app_ ? app_->getSyncTest() : nullptr;
+    if (!monitor) {
+        LOG_WARNING << "synctest/report: sync test not running (--sync-test)";
+        return false;
+    }
+    
+    LOG_INFO << "=== Sync Test ===";
+    for (const std::string& line : monitor->formatReport()) {
+        LOG_INFO << "  " << line;
+    }
+    
+    if (!args.empty() && args[0] == "reset") {
+        monitor->reset();
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleSyncTestPhotodiode(const CommandArgs& args) {
+    // Expected: /videocomposer/synctest/photodiode [time]
+    // A level change of the photodiode on the patch, at a monotonic time in
+    // microseconds (default: when the message is handled)
+    SyncLatencyMonitor* monitor = app_ ? app_->getSyncTest() : nullptr;
+    if (!monitor) {
+        return false;
+    }
+    int64_t timeUs = args.empty() ? vc_get_monotonic_time() : args[0].toInt64();
+    if (!monitor->recordPhotodiodeEdge(timeUs * 1000)) {
+        LOG_VERBOSE << "synctest/photodiode: no flip of the patch before " << timeUs;
+    }
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsSubscribe(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/subscribe host port [rate]
+    // Sends /videocomposer/telemetry/global and /telemetry/layer (see TelemetryPublisher)
+    if (!app_ || !app_->getTelemetry() || args.size() < 2 || !args[0].isString()) {
+        LOG_WARNING << "stats/subscribe: expected host port [rate]";
+        return false;
+    }
+    int port = args[1].toInt();
+    if (port <= 0 || port > 65535) {
+        LOG_WARNING << "stats/subscribe: invalid port " << port;
+        return false;
+    }
+    double rate = args.size() > 2 ? args[2].toDouble() : 2.0;
+    std::string target = std::string(args[0].view()) + ":" + std::to_string(port);
+    if (!app_->getTelemetry()->subscribe(target, rate, vc_get_monotonic_time())) {
+        LOG_WARNING << "stats/subscribe: " << TelemetryPublisher::MAX_SUBSCRIBERS
+                    << " targets subscribed already, not adding " << target;
+        return false;
+    }
+    LOG_INFO << "Telemetry: " << target << " subscribed at "
+             << std::clamp(rate, TelemetryPublisher::MIN_RATE, TelemetryPublisher::MAX_RATE) << " Hz";
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsUnsubscribe(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/unsubscribe host port
+    if (!app_ || !app_->getTelemetry() || args.size() < 2 || !args[0].isString()) {
+        return false;
+    }
+    std::string target = std::string(args[0].view()) + ":" + std::to_string(args[1].toInt());
+    if (!app_->getTelemetry()->unsubscribe(target)) {
+        LOG_WARNING << "stats/unsubscribe: " << target << " is not subscribed";
+        return false;
+    }
+    LOG_INFO << "Telemetry: " << target << " unsubscribed";
+    return true;
+}
+
+bool RemoteCommandRouter::handleTraceDump(const CommandArgs& args) {
+    // Expected: /videocomposer/trace/dump [path]
+    std::string path;
+    if (!args.empty() && args[0].isString()) {
+        path = std::string(args[0].view());
+    } else {
+        path = "/tmp/cuems-videocomposer-trace-" + std::to_string(FrameTracer::nowNs() / 1000000) + ".json";
+    }
+    if (!FrameTracer::instance().isEnabled()) {
+        LOG_WARNING << "Trace: recording is off (/videocomposer/trace/enable 1), dumping what was recorded";
+    }
+    return FrameTracer::instance().dumpChromeJson(path);
+}
+
+bool RemoteCommandRouter::handleTraceEnable(const CommandArgs& args) {
+    // Expected: /videocomposer/trace/enable i
+    if (args.empty()) {
+        return false;
+    }
+    bool enabled = args[0].toInt() != 0;
+    if (enabled && !FrameTracer::instance().isEnabled()) {
+        FrameTracer::instance().clear();
+    }
+    FrameTracer::instance().setEnabled(enabled);
+    LOG_INFO << "Trace: recording " << (enabled ? "on" : "off");
+    return true;
+}
+
+bool RemoteCommandRouter::handleStatsHapDecode(const CommandArgs& args) {
+    // Expected: /videocomposer/stats/hapdecode [reset]
+#ifdef ENABLE_HAP_DIRECT
+    if (!layerManager_) {
+        return false;
+    }
+    
+    bool reset = !args.empty() && args[0] == "reset";
+    
+    HapChunkPool& pool = HapChunkPool::instance();
+    HapChunkPool::Stats ps = pool.getStats();
+    LOG_INFO << "=== HAP Decode ===";
+    LOG_INFO << "  Chunk pool: " << ps.maxConcurrency << " thread(s), " << ps.batches << " batches, "
+             << ps.chunks << " chunks (" << ps.workerChunks << " on workers), "
+             << ps.lateBatches << " past deadline";
+    
+    for (VideoLayer* layer : layerManager_->getLayers()) {
+        auto* hapInput = dynamic_cast<HAPVideoInput*>(layer->getInputSource());
+        if (!hapInput) {
+            continue;
+        }
+        
+        HapDecodeLatency lat = hapInput->getDecodeLatency();
+        std::ostringstream histogram;
+        for (int i = 0; i < HapDecodeLatency::BUCKETS; ++i) {
+            if (i < HapDecodeLatency::BUCKETS - 1) {
+                histogram << " <" << HapDecodeLatency::BUCKET_LIMITS_MS[i] << "ms:";
+            } else {
+                histogram << " >=" << HapDecodeLatency::BUCKET_LIMITS_MS[i - 1] << "ms:";
+            }
+            histogram << lat.counts[i];
+        }
+        LOG_INFO << "  Layer " << layer->getLayerId()
+                 << " [" << layerManager_->getCueIdFromLayer(layer) << "]: "
+                 << lat.frames << " frames, avg " << lat.averageMs() << " ms, max " << lat.maxMs << " ms,"
+                 << histogram.str();
+        
+        if (reset) {
+            hapInput->resetDecodeLatency();
+        }
+    }
+    if (reset) {
+        pool.resetStats();
+    }
+    return true;
+#else
+    (void)args;
+    LOG_WARNING << "stats/hapdecode: built without direct HAP decode";
+    return false;
+#endif
+}
+
+bool RemoteCommandRouter::handleFrameLockTimeline(const CommandArgs& args) {
+    // Expected: /videocomposer/framelock/timeline d:position d:realtimeUs (from the master node)
+    FrameLockSyncSource* frameLock = app_ ? app_->getFrameLock() : nullptr;
+    if (!frameLock || args.size() < 2) {
+        return false;
+    }
+    frameLock->receiveTimeline(args[0].toDouble(),
+                               static_cast<int64_t>(args[1].toDouble()));
+    return true;
+}
+
+bool RemoteCommandRouter::handleClusterMessage(ClusterMessage kind, const CommandArgs& args) {
+    // Expected: /videocomposer/cluster/layer s:"cueId\nlines" d:seq d:epoch d:full
+    //           /videocomposer/cluster/remove s:cueId d:seq d:epoch
+    //           /videocomposer/cluster/sync s:"cueIds" d:seq d:epoch d:firstSeq
+    if (!app_ || args.size() < 3 || !args[0].isString()) {
+        return false;
+    }
+    std::vector<double> values;
+    for (size_t i = 1; i < args.size(); ++i) {
+        values.push_back(args[i].toDouble());
+    }
+    return app_->receiveClusterMessage(kind, args[0].str(), values);
+}
+
+bool RemoteCommandRouter::handleClockStart(const CommandArgs& args) {
+    (void)args;
+    VblankClockSyncSource* clock = app_ ? app_->getInternalClock() : nullptr;
+    if (!clock) {
+        LOG_WARNING << "clock/start: internal clock not enabled (--internal-sync)";
+        return false;
+    }
+    clock->start();
+    return true;
+}
+
+bool RemoteCommandRouter::handleClockStop(const CommandArgs& args) {
+    (void)args;
+    VblankClockSyncSource* clock = app_ ? app_->getInternalClock() : nullptr;
+    if (!clock) {
+        LOG_WARNING << "clock/stop: internal clock not enabled (--internal-sync)";
+        return false;
+    }
+    clock->stop();
+    return true;
+}
+
+bool RemoteCommandRouter::handleClockLocate(const CommandArgs& args) {
+    VblankClockSyncSource* clock = app_ ? app_->getInternalClock() : nullptr;
+    if (!clock || args.empty()) {
+        return false;
+    }
+    // Frame number or SMPTE timecode at the clock's framerate
+    int64_t frame = args[0].find_first_of(":;") != std::string::npos
+        ? SMPTEUtils::smpteStringToFrame(args[0], clock->getFramerate())
+        : args[0].toInt64();
+    clock->locate(frame);
+    return true;
+}
+
+bool RemoteCommandRouter::handleAt(const CommandArgs& args) {
+    // Expected: /videocomposer/at frame|SMPTE s:path [args ...] (sync-source timecode)
+    if (args.size() < 2 || !args[1].isString()) {
+        LOG_WARNING << "at: Expected a timecode and a command path";
+        return false;
+    }
+    int64_t frame;
+    if (args[0].find_first_of(":;") != std::string::npos) {
+        SyncSource* sync = app_ ? app_->getSyncSource() : nullptr;
+        double fps = sync ? sync->getFramerate() : -1.0;
+        if (fps <= 0.0) {
+            LOG_WARNING << "at: No sync source framerate for timecode " << args[0];
+            return false;
+        }
+        bool haveDropframes = args[0].find_first_of(";") != std::string::npos;
+        frame = SMPTEUtils::smpteStringToFrame(args[0], fps, haveDropframes);
+    } else {
+        frame = args[0].toInt64();
+    }
+    if (!scheduler_.scheduleAtFrame(frame, args[1].view(), args.tail(2))) {
+        LOG_WARNING << "Scheduler full (" << CommandScheduler::MAX_PENDING << " commands), dropping " << args[1];
+        return false;
+    }
+    return true;
+}
 
+bool RemoteCommandRouter::handleAtClear(const CommandArgs& args) {
+    (void)args;
+    LOG_INFO << "at/clear: Dropped " << scheduler_.size() << " scheduled commands";
+    scheduler_.clear();
+    return true;
+}
+
+} // namespace videocomposer
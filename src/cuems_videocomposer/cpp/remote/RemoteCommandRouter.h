@@ -1,10 +1,13 @@
 #ifndef VIDEOCOMPOSER_REMOTECOMMANDROUTER_H
 #define VIDEOCOMPOSER_REMOTECOMMANDROUTER_H
 
+#include "CommandArgs.h"
+#include "CommandScheduler.h"
+#include "CommandTable.h"
+#include "ClusterReplicator.h"
 #include <string>
+#include <string_view>
 #include <functional>
-#include <map>
-#include <vector>
 
 namespace videocomposer {
 
@@ -12,6 +15,7 @@ namespace videocomposer {
 class VideoComposerApplication;
 class VideoLayer;
 class LayerManager;
+struct LayerGroup;
 
 /**
  * RemoteCommandRouter - Routes commands to application or specific layers
@@ -19,160 +23,271 @@ class LayerManager;
  * Parses command paths and delegates to appropriate handlers:
  * - App-level: /videocomposer/quit, /videocomposer/layer/add, etc.
  * - Layer-level: /videocomposer/layer/<id>/seek, /videocomposer/layer/<id>/play, etc.
+ * - Group-level: /videocomposer/group/<name>/opacity, /videocomposer/group/<name>/remove, etc.
+ *
+ * Paths are split as views and looked up in tables built at registration,
+ * and arguments arrive typed, so routing a command does not allocate.
  */
 class RemoteCommandRouter {
 public:
+    using AppHandler = std::function<bool(const CommandArgs&)>;
+    using LayerHandler = std::function<bool(VideoLayer*, const CommandArgs&)>;
+    using GroupHandler = std::function<bool(LayerGroup*, const CommandArgs&)>;
+
     RemoteCommandRouter(VideoComposerApplication* app, LayerManager* layerManager);
     ~RemoteCommandRouter();
 
     // Route a command (called from RemoteControl implementations)
     // Returns true if command was handled, false otherwise
-    bool routeCommand(const std::string& path, const std::vector<std::string>& args);
+    bool routeCommand(std::string_view path, const CommandArgs& args);
+
+    /**
+     * Route this command on the first render presented at or after a wall
+     * clock time (OSC bundle timetags)
+     * @return false if too many commands are pending
+     */
+    bool scheduleAtTime(int64_t wallUs, std::string_view path, const CommandArgs& args);
+
+    /**
+     * Route the scheduled commands due for this render (once per frame,
+     * before the layers are updated)
+     * @param frame Sync-source frame presented (-1 = none)
+     * @param presentationUs Wall clock of the vblank this render is shown on
+     */
+    size_t runScheduled(int64_t frame, int64_t presentationUs);
+    size_t getScheduledCount() const { return scheduler_.size(); }
 
     // Register command handlers (for extensibility)
     void registerAppCommand(const std::string& path, 
-                            std::function<bool(const std::vector<std::string>&)> handler);
+                            AppHandler handler);
     void registerLayerCommand(const std::string& path,
-                              std::function<bool(VideoLayer*, const std::vector<std::string>&)> handler);
+                              LayerHandler handler);
+    void registerGroupCommand(const std::string& path,
+                              GroupHandler handler);
 
 private:
     VideoComposerApplication* app_;
     LayerManager* layerManager_;
 
-    // Command handler maps
-    std::map<std::string, std::function<bool(const std::vector<std::string>&)>> appCommands_;
-    std::map<std::string, std::function<bool(VideoLayer*, const std::vector<std::string>&)>> layerCommands_;
+    // Command handler tables
+    CommandTable<AppHandler> appCommands_;
+    CommandTable<LayerHandler> layerCommands_;
+    CommandTable<GroupHandler> groupCommands_;
+
+    // Commands waiting for their frame (/at, timetagged bundles)
+    CommandScheduler scheduler_;
+
+    // Arguments split out of /videocomposer/cmd strings (reused)
+    CommandArgs cmdArgs_;
+    bool inCmd_;
 
-    // Parse command path
-    bool parsePath(const std::string& path, std::string& command, int& layerId);
+    // Layer by cue ID, or by integer layer ID for backward compatibility
+    VideoLayer* findLayer(std::string_view id);
 
     // App-level command handlers
-    bool handleQuit(const std::vector<std::string>& args);
-    bool handleLoad(const std::vector<std::string>& args);
-    bool handleSeek(const std::vector<std::string>& args);
-    bool handleFPS(const std::vector<std::string>& args);
-    bool handleOffset(const std::vector<std::string>& args);
-    bool handleLayerAdd(const std::vector<std::string>& args);
-    bool handleLayerRemove(const std::vector<std::string>& args);
-    bool handleLayerDuplicate(const std::vector<std::string>& args);
-    bool handleLayerReorder(const std::vector<std::string>& args);
-    bool handleLayerList(const std::vector<std::string>& args);
+    bool handleQuit(const CommandArgs& args);
+    bool handleLoad(const CommandArgs& args);
+    bool handleSeek(const CommandArgs& args);
+    bool handleFPS(const CommandArgs& args);
+    bool handleOffset(const CommandArgs& args);
+    bool handleLayerAdd(const CommandArgs& args);
+    bool handleLayerRemove(const CommandArgs& args);
+    bool handleLayerDuplicate(const CommandArgs& args);
+    bool handleLayerReorder(const CommandArgs& args);
+    bool handleLayerList(const CommandArgs& args);
     
     // OSD command handlers
-    bool handleOSDFrame(const std::vector<std::string>& args);
-    bool handleOSDSMPTE(const std::vector<std::string>& args);
-    bool handleOSDText(const std::vector<std::string>& args);
-    bool handleOSDBox(const std::vector<std::string>& args);
-    bool handleOSDFont(const std::vector<std::string>& args);
-    bool handleOSDPos(const std::vector<std::string>& args);
+    bool handleOSDFrame(const CommandArgs& args);
+    bool handleOSDSMPTE(const CommandArgs& args);
+    bool handleOSDText(const CommandArgs& args);
+    bool handleOSDBox(const CommandArgs& args);
+    bool handleOSDFont(const CommandArgs& args);
+    bool handleOSDPos(const CommandArgs& args);
+    bool handleOSDGpu(const CommandArgs& args);  // /osd/gpu [i]
 
     // Layer-level command handlers
-    bool handleLayerSeek(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerPlay(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerPause(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerPosition(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerOpacity(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerVisible(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerZOrder(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerSeek(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerSeekAsync(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/seek_async frame [hold|blank]
+    bool handleLayerPlay(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerPause(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerPosition(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerOpacity(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerVisible(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerZOrder(VideoLayer* layer, const CommandArgs& args);
     
     // Time-scaling command handlers (app-level)
-    bool handleTimeScale(const std::vector<std::string>& args);
-    bool handleTimeScale2(const std::vector<std::string>& args);  // timescale + offset
-    bool handleLoop(const std::vector<std::string>& args);
-    bool handleReverse(const std::vector<std::string>& args);
+    bool handleTimeScale(const CommandArgs& args);
+    bool handleTimeScale2(const CommandArgs& args);  // timescale + offset
+    bool handleLoop(const CommandArgs& args);
+    bool handleReverse(const CommandArgs& args);
     
     // Time-scaling command handlers (layer-level)
-    bool handleLayerTimeScale(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerTimeScale2(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerLoop(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerReverse(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerTimeScale(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerTimeScale2(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerLoop(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerReverse(VideoLayer* layer, const CommandArgs& args);
     
     // Crop/Panorama command handlers (app-level)
-    bool handlePan(const std::vector<std::string>& args);
+    bool handlePan(const CommandArgs& args);
     
     // Crop/Panorama command handlers (layer-level)
-    bool handleLayerPan(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCrop(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCropDisable(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerPanorama(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerPan(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCrop(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCropDisable(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerPanorama(VideoLayer* layer, const CommandArgs& args);
     
     // File loading/unloading handlers
-    bool handleLayerLoad(const std::vector<std::string>& args);  // /layer/load s s (filepath, cueId)
-    bool handleLayerFile(VideoLayer* layer, const std::vector<std::string>& args);  // /layer/<cueId>/file s
-    bool handleLayerUnload(const std::vector<std::string>& args);  // /layer/unload s (cueId)
+    bool handleLayerLoad(const CommandArgs& args);  // /layer/load s s [i] (filepath, cueId, priority)
+    bool handleLayerFile(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/file s
+    bool handleLayerUnload(const CommandArgs& args);  // /layer/unload s (cueId)
+    bool handleLayerPrioritize(const CommandArgs& args);  // /layer/prioritize s [i] (cueId, priority)
     
     // Loop and auto-unload handlers
-    bool handleLayerAutoUnload(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerLoopRegion(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerLoopRegionDisable(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerAutoUnload(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerPreload(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/preload <0|1>
+    bool handleLayerLoopRegion(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerLoopRegionDisable(VideoLayer* layer, const CommandArgs& args);
     
     // Offset and MTC follow handlers
-    bool handleLayerOffset(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerMtcFollow(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerOffset(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerMtcFollow(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerArm(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/arm [i|s] (start frame)
+    bool handleLayerGo(VideoLayer* layer, const CommandArgs& args);   // /layer/<cueId>/go
+    bool handleLayerCues(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/cues [tc ...]
+    bool handleLayerDecodePriority(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/decode_priority <n>
+    bool handleLayerUnderrunPolicy(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/underrun_policy block|hold|drop
+    bool handleLayerLoopCache(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/loop_cache off|on|compressed
+    bool handleLayerSuspendHidden(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/suspend_hidden 0|1
+    bool handleLayerCritical(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/critical 0|1
+    
+    // Property tweens: /layer/<cueId>/animate s:property f:seconds f:value [f ...] [s:easing]
+    bool handleLayerAnimate(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerAnimateStop(VideoLayer* layer, const CommandArgs& args);  // /layer/<cueId>/animate/stop [s:property]
     
     // Transform handlers
-    bool handleLayerScale(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerXScale(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerYScale(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerRotation(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCornerDeform(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCornerDeformEnable(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCornerDeformHQ(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerScale(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerXScale(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerYScale(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerRotation(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCornerDeform(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCornerDeformEnable(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCornerDeformHQ(VideoLayer* layer, const CommandArgs& args);
     
     // Corner deformation handlers
-    bool handleLayerCorners(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCorner1(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCorner2(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCorner3(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerCorner4(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerCorners(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCorner1(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCorner2(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCorner3(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerCorner4(VideoLayer* layer, const CommandArgs& args);
     
     // Blend mode handler
-    bool handleLayerBlendMode(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerBlendMode(VideoLayer* layer, const CommandArgs& args);
+    
+    // Packed-alpha frames: /layer/<cueId>/packedalpha s:none|stacked|side_by_side [i:premultiplied]
+    bool handleLayerPackedAlpha(VideoLayer* layer, const CommandArgs& args);
+    
+    // Layer effects: /layer/<cueId>/blur f:radius, sharpen f:amount [f:radius],
+    // chromakey i:on [f:r f:g f:b [f:similarity f:smoothness f:spill]],
+    // vignette f:amount [f:softness] (0 turns each off)
+    bool handleLayerBlur(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerSharpen(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerChromaKey(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerVignette(VideoLayer* layer, const CommandArgs& args);
+    
+    // Layer groups: /layer/<cueId>/group [s:name] (none = ungroup), then
+    // /group/<name>/<command> on the group image (the group is created on first use)
+    bool handleLayerGroup(VideoLayer* layer, const CommandArgs& args);
+    bool handleGroupPosition(LayerGroup* group, const CommandArgs& args);
+    bool handleGroupOpacity(LayerGroup* group, const CommandArgs& args);
+    bool handleGroupVisible(LayerGroup* group, const CommandArgs& args);
+    bool handleGroupZOrder(LayerGroup* group, const CommandArgs& args);
+    bool handleGroupScale(LayerGroup* group, const CommandArgs& args);
+    bool handleGroupRotation(LayerGroup* group, const CommandArgs& args);
+    bool handleGroupBlendMode(LayerGroup* group, const CommandArgs& args);
     
     // Layer color correction handlers
-    bool handleLayerBrightness(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerContrast(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerSaturation(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerHue(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerGamma(VideoLayer* layer, const std::vector<std::string>& args);
-    bool handleLayerColorReset(VideoLayer* layer, const std::vector<std::string>& args);
+    bool handleLayerBrightness(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerContrast(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerSaturation(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerHue(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerGamma(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerLut(VideoLayer* layer, const CommandArgs& args);
+    bool handleLayerColorReset(VideoLayer* layer, const CommandArgs& args);
     
     // Master layer handlers (composite transforms)
-    bool handleMasterOpacity(const std::vector<std::string>& args);
-    bool handleMasterPosition(const std::vector<std::string>& args);
-    bool handleMasterScale(const std::vector<std::string>& args);
-    bool handleMasterXScale(const std::vector<std::string>& args);
-    bool handleMasterYScale(const std::vector<std::string>& args);
-    bool handleMasterRotation(const std::vector<std::string>& args);
-    bool handleMasterCorners(const std::vector<std::string>& args);
-    bool handleMasterCorner1(const std::vector<std::string>& args);
-    bool handleMasterCorner2(const std::vector<std::string>& args);
-    bool handleMasterCorner3(const std::vector<std::string>& args);
-    bool handleMasterCorner4(const std::vector<std::string>& args);
-    bool handleMasterReset(const std::vector<std::string>& args);
+    bool handleMasterOpacity(const CommandArgs& args);
+    bool handleMasterPosition(const CommandArgs& args);
+    bool handleMasterScale(const CommandArgs& args);
+    bool handleMasterXScale(const CommandArgs& args);
+    bool handleMasterYScale(const CommandArgs& args);
+    bool handleMasterRotation(const CommandArgs& args);
+    bool handleMasterCorners(const CommandArgs& args);
+    bool handleMasterCorner1(const CommandArgs& args);
+    bool handleMasterCorner2(const CommandArgs& args);
+    bool handleMasterCorner3(const CommandArgs& args);
+    bool handleMasterCorner4(const CommandArgs& args);
+    bool handleMasterReset(const CommandArgs& args);
     
     // Master color correction handlers
-    bool handleMasterBrightness(const std::vector<std::string>& args);
-    bool handleMasterContrast(const std::vector<std::string>& args);
-    bool handleMasterSaturation(const std::vector<std::string>& args);
-    bool handleMasterHue(const std::vector<std::string>& args);
-    bool handleMasterGamma(const std::vector<std::string>& args);
-    bool handleMasterColorReset(const std::vector<std::string>& args);
+    bool handleMasterBrightness(const CommandArgs& args);
+    bool handleMasterContrast(const CommandArgs& args);
+    bool handleMasterSaturation(const CommandArgs& args);
+    bool handleMasterHue(const CommandArgs& args);
+    bool handleMasterGamma(const CommandArgs& args);
+    bool handleMasterLut(const CommandArgs& args);
+    bool handleMasterColorReset(const CommandArgs& args);
     
     // Display configuration handlers (Phase 4)
-    bool handleDisplayList(const std::vector<std::string>& args);
-    bool handleDisplayModes(const std::vector<std::string>& args);
-    bool handleDisplayMode(const std::vector<std::string>& args);
-    bool handleDisplayResolutionMode(const std::vector<std::string>& args);
-    bool handleDisplayRegion(const std::vector<std::string>& args);
-    bool handleDisplayAssign(const std::vector<std::string>& args);
-    bool handleDisplayBlend(const std::vector<std::string>& args);
-    bool handleDisplaySave(const std::vector<std::string>& args);
-    bool handleDisplayLoad(const std::vector<std::string>& args);
+    bool handleDisplayList(const CommandArgs& args);
+    bool handleDisplayModes(const CommandArgs& args);
+    bool handleDisplayMode(const CommandArgs& args);
+    bool handleDisplayResolutionMode(const CommandArgs& args);
+    bool handleDisplayRegion(const CommandArgs& args);
+    bool handleDisplayAssign(const CommandArgs& args);
+    bool handleDisplayBlend(const CommandArgs& args);
+    bool handleDisplaySave(const CommandArgs& args);
+    bool handleDisplayLoad(const CommandArgs& args);
     
     // Virtual output handlers (Phase 6)
-    bool handleOutputCapture(const std::vector<std::string>& args);
-    bool handleOutputList(const std::vector<std::string>& args);
+    bool handleOutputCapture(const CommandArgs& args);
+    bool handleOutputList(const CommandArgs& args);
+    
+    // Show preparation handlers
+    bool handleShowPrewarm(const CommandArgs& args);  // /show/prewarm s [s ...]
+    bool handleShowThumbnail(const CommandArgs& args);  // /show/thumbnail s:path f:seconds [i:width] [s:host i:port]
+    
+    // Statistics handlers
+    bool handleStatsFramePool(const CommandArgs& args);  // /stats/framepool [reset]
+    bool handleStatsHapDecode(const CommandArgs& args);  // /stats/hapdecode [reset]
+    bool handleStatsUnderrun(const CommandArgs& args);   // /stats/underrun [reset]
+    bool handleStatsIo(const CommandArgs& args);         // /stats/io
+    bool handleStatsGpu(const CommandArgs& args);        // /stats/gpu [reset]
+    bool handleStatsMemory(const CommandArgs& args);     // /stats/memory [s:host i:port]
+    bool handleStatsSubscribe(const CommandArgs& args);    // /stats/subscribe s:host i:port [f:rate]
+    bool handleStatsUnsubscribe(const CommandArgs& args);  // /stats/unsubscribe s:host i:port
+    
+    // Sync test handlers (--sync-test)
+    bool handleSyncTestReport(const CommandArgs& args);      // /synctest/report [reset]
+    bool handleSyncTestPhotodiode(const CommandArgs& args);  // /synctest/photodiode [h:monotonic us]
+    
+    // Frame timeline trace handlers
+    bool handleTraceDump(const CommandArgs& args);    // /trace/dump [s:path]
+    bool handleTraceEnable(const CommandArgs& args);  // /trace/enable i
+    
+    // Frame lock handlers
+    bool handleFrameLockTimeline(const CommandArgs& args);  // /framelock/timeline d d
+    
+    // Cluster handlers (from the scene authority, see ClusterReplicator)
+    bool handleClusterMessage(ClusterMessage kind, const CommandArgs& args);  // /cluster/layer|remove|sync s d d [d]
+    
+    // Scheduling handlers
+    bool handleAt(const CommandArgs& args);       // /at frame|SMPTE s [args ...]
+    bool handleAtClear(const CommandArgs& args);  // /at/clear
+
+    // Internal clock handlers
+    bool handleClockStart(const CommandArgs& args);   // /clock/start
+    bool handleClockStop(const CommandArgs& args);    // /clock/stop
+    bool handleClockLocate(const CommandArgs& args);  // /clock/locate frame|SMPTE
 };
 
 } // namespace videocomposer
@@ -1,10 +1,15 @@
 #ifndef VIDEOCOMPOSER_REMOTECONTROL_H
 #define VIDEOCOMPOSER_REMOTECONTROL_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace videocomposer {
 
+class WakeSignal;
+
 /**
  * RemoteControl - Abstract base class for remote control protocols
  * 
@@ -46,6 +51,75 @@ public:
      * @return String identifier (e.g., "OSC", "MQ", "IPC")
      */
     virtual const char* getProtocolName() const = 0;
+
+    /**
+     * Route the scheduled commands due for this render (protocols without
+     * scheduling ignore it)
+     * @param frame Sync-source frame presented (-1 = no sync source)
+     * @param presentationUs Wall clock of the vblank this render is shown on
+     * @return Number of commands run
+     */
+    virtual size_t runScheduled(int64_t frame, int64_t presentationUs) {
+        (void)frame; (void)presentationUs;
+        return 0;
+    }
+
+    /**
+     * Scheduled commands not run yet
+     */
+    virtual size_t getScheduledCount() const { return 0; }
+
+    /**
+     * Send a message to another host (protocols without outbound messages ignore it)
+     * @param target Destination, e.g. "host:port"
+     * @param path Message path
+     * @param label Optional leading string argument (empty = none)
+     * @param values Numeric arguments
+     * @return true if sent
+     */
+    virtual bool sendMessage(const std::string& target, const std::string& path,
+                             const std::string& label, const std::vector<double>& values) {
+        (void)target; (void)path; (void)label; (void)values;
+        return false;
+    }
+
+    /**
+     * Send a message with string arguments, numbers and binary data
+     * (protocols without outbound messages ignore it)
+     * @param strings Leading string arguments
+     * @param data Trailing binary argument (empty = none)
+     * @return true if sent
+     */
+    virtual bool sendData(const std::string& target, const std::string& path,
+                          const std::vector<std::string>& strings, const std::vector<double>& values,
+                          const std::string& data) {
+        (void)target; (void)path; (void)strings; (void)values; (void)data;
+        return false;
+    }
+
+    /**
+     * Notified whenever a message is queued for process(), so an idle
+     * render loop wakes for it (protocols polled by process() ignore it)
+     * @param wake Signal to notify (nullptr = none); outlives the protocol
+     */
+    virtual void setWakeSignal(WakeSignal* wake) { (void)wake; }
+
+    /**
+     * Also receive the messages sent to a multicast group, routed like the
+     * others (protocols without multicast ignore it)
+     * @param target "group:port", e.g. "239.255.0.1:7100"
+     * @return true if joined
+     */
+    virtual bool joinGroup(const std::string& target) { (void)target; return false; }
+
+    /**
+     * Also take commands from controllers on this machine through shared
+     * memory rings (see LocalControlChannel), routed like the others
+     * (protocols without a local channel ignore it)
+     * @param socketPath Unix socket controllers connect to
+     * @return true if listening
+     */
+    virtual bool openLocalChannel(const std::string& socketPath) { (void)socketPath; return false; }
 };
 
 } // namespace videocomposer
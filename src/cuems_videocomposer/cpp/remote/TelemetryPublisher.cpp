@@ -0,0 +1,205 @@
+#include "TelemetryPublisher.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+namespace {
+
+double megabytes(double bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+// Counter difference; a counter that went back (layer reopened) restarted at 0
+uint64_t since(uint64_t now, uint64_t before) {
+    return now >= before ? now - before : now;
+}
+
+} // namespace
+
+void FrameTimeHistogram::record(double ms) {
+    if (!(ms >= 0.0)) {
+        return;
+    }
+    size_t bucket = std::min(static_cast<size_t>(ms / BUCKET_MS), BUCKETS - 1);
+    ++buckets_[bucket];
+    ++count_;
+    max_ = std::max(max_, ms);
+}
+
+double FrameTimeHistogram::percentile(double fraction) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * count_));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            // The last bucket is open-ended: its edge would understate
+            return i == BUCKETS - 1 ? max_ : std::min((i + 1) * BUCKET_MS, max_);
+        }
+    }
+    return max_;
+}
+
+void FrameTimeHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    max_ = 0.0;
+}
+
+TelemetryPublisher::TelemetryPublisher()
+    : subscriberCount_(0)
+    , layers_(MAX_LAYERS)
+    , layerCount_(0)
+{
+    values_.reserve(16);
+}
+
+bool TelemetryPublisher::subscribe(const std::string& target, double rateHz, int64_t nowUs) {
+    double rate = std::clamp(rateHz, MIN_RATE, MAX_RATE);
+    Subscriber* subscriber = nullptr;
+    for (size_t i = 0; i < subscriberCount_; ++i) {
+        if (subscribers_[i].target == target) {
+            subscriber = &subscribers_[i];
+        }
+    }
+    if (!subscriber) {
+        if (subscriberCount_ >= MAX_SUBSCRIBERS) {
+            return false;
+        }
+        subscriber = &subscribers_[subscriberCount_++];
+        subscriber->target = target;
+        subscriber->hasBaseline = false;
+        subscriber->layerCount = 0;
+        subscriber->frameTimes.reset();
+        // First message on the next publish
+        subscriber->lastUs = nowUs - static_cast<int64_t>(1e6 / rate);
+    }
+    subscriber->intervalUs = static_cast<int64_t>(1e6 / rate);
+    return true;
+}
+
+bool TelemetryPublisher::unsubscribe(const std::string& target) {
+    for (size_t i = 0; i < subscriberCount_; ++i) {
+        if (subscribers_[i].target == target) {
+            // The last one takes its place
+            if (i + 1 < subscriberCount_) {
+                std::swap(subscribers_[i], subscribers_[subscriberCount_ - 1]);
+            }
+            --subscriberCount_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TelemetryPublisher::recordFrame(double ms) {
+    for (size_t i = 0; i < subscriberCount_; ++i) {
+        subscribers_[i].frameTimes.record(ms);
+    }
+}
+
+bool TelemetryPublisher::isDue(int64_t nowUs) const {
+    for (size_t i = 0; i < subscriberCount_; ++i) {
+        if (nowUs - subscribers_[i].lastUs >= subscribers_[i].intervalUs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TelemetryPublisher::Sample& TelemetryPublisher::beginSample() {
+    sample_ = Sample();
+    layerCount_ = 0;
+    return sample_;
+}
+
+TelemetryPublisher::LayerSample* TelemetryPublisher::addLayer() {
+    if (layerCount_ >= layers_.size()) {
+        return nullptr;
+    }
+    LayerSample& layer = layers_[layerCount_++];
+    // Assigning keeps the cue id's storage
+    layer.layerId = -1;
+    layer.cueId.clear();
+    layer.decodedFrames = 0;
+    layer.underruns = 0;
+    layer.queueDepth = 0;
+    return &layer;
+}
+
+const TelemetryPublisher::LayerBaseline* TelemetryPublisher::findBaseline(const Subscriber& subscriber, int layerId) {
+    for (size_t i = 0; i < subscriber.layerCount; ++i) {
+        if (subscriber.layers[i].layerId == layerId) {
+            return &subscriber.layers[i];
+        }
+    }
+    return nullptr;
+}
+
+size_t TelemetryPublisher::publish(int64_t nowUs, const Sender& send) {
+    size_t sent = 0;
+    for (size_t i = 0; i < subscriberCount_; ++i) {
+        Subscriber& subscriber = subscribers_[i];
+        if (nowUs - subscriber.lastUs >= subscriber.intervalUs) {
+            publishTo(subscriber, nowUs, send, sent);
+        }
+    }
+    return sent;
+}
+
+void TelemetryPublisher::publishTo(Subscriber& subscriber, int64_t nowUs, const Sender& send, size_t& sent) {
+    double interval = (nowUs - subscriber.lastUs) / 1e6;
+    const FrameTimeHistogram& frames = subscriber.frameTimes;
+
+    values_.clear();
+    values_.push_back(interval);
+    values_.push_back(frames.percentile(0.50));
+    values_.push_back(frames.percentile(0.95));
+    values_.push_back(frames.percentile(0.99));
+    values_.push_back(frames.getMax());
+    values_.push_back(subscriber.hasBaseline ? static_cast<double>(since(sample_.lateFrames, subscriber.lateFrames)) : -1.0);
+    values_.push_back(subscriber.hasBaseline ? static_cast<double>(since(sample_.sinkDrops, subscriber.sinkDrops)) : -1.0);
+    values_.push_back(sample_.vramUsedBytes >= 0 ? megabytes(static_cast<double>(sample_.vramUsedBytes)) : -1.0);
+    values_.push_back(megabytes(static_cast<double>(sample_.texturePoolBytes)));
+    values_.push_back(megabytes(static_cast<double>(sample_.framePoolBytes)));
+    values_.push_back(megabytes(static_cast<double>(sample_.ramClipBytes)));
+    values_.push_back(megabytes(static_cast<double>(sample_.residentBytes)));
+    values_.push_back(sample_.syncJitterMs);
+    values_.push_back(static_cast<double>(layerCount_));
+    if (send(subscriber.target, "/videocomposer/telemetry/global", "", values_)) {
+        ++sent;
+    }
+
+    for (size_t i = 0; i < layerCount_; ++i) {
+        const LayerSample& layer = layers_[i];
+        const LayerBaseline* baseline = subscriber.hasBaseline ? findBaseline(subscriber, layer.layerId) : nullptr;
+        values_.clear();
+        values_.push_back(layer.layerId);
+        values_.push_back(baseline && interval > 0.0
+                          ? since(layer.decodedFrames, baseline->decodedFrames) / interval : -1.0);
+        values_.push_back(static_cast<double>(layer.queueDepth));
+        values_.push_back(baseline ? static_cast<double>(since(layer.underruns, baseline->underruns)) : -1.0);
+        if (send(subscriber.target, "/videocomposer/telemetry/layer", layer.cueId, values_)) {
+            ++sent;
+        }
+    }
+
+    // This message's totals are the next one's baseline
+    subscriber.lateFrames = sample_.lateFrames;
+    subscriber.sinkDrops = sample_.sinkDrops;
+    subscriber.layerCount = layerCount_;
+    for (size_t i = 0; i < layerCount_; ++i) {
+        subscriber.layers[i].layerId = layers_[i].layerId;
+        subscriber.layers[i].decodedFrames = layers_[i].decodedFrames;
+        subscriber.layers[i].underruns = layers_[i].underruns;
+    }
+    subscriber.hasBaseline = true;
+    subscriber.frameTimes.reset();
+    subscriber.lastUs = nowUs;
+}
+
+} // namespace videocomposer
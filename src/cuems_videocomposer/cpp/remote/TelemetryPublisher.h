@@ -0,0 +1,156 @@
+#ifndef VIDEOCOMPOSER_TELEMETRYPUBLISHER_H
+#define VIDEOCOMPOSER_TELEMETRYPUBLISHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * FrameTimeHistogram - Frame times in fixed 0.25 ms buckets, for percentiles
+ *
+ * Recording is one increment; times past the last bucket count in it.
+ * Percentiles are the upper edge of their bucket.
+ */
+class FrameTimeHistogram {
+public:
+    static constexpr double BUCKET_MS = 0.25;
+    static constexpr size_t BUCKETS = 400;   // Up to 100 ms
+
+    FrameTimeHistogram() { reset(); }
+
+    void record(double ms);
+
+    /** @param fraction 0.5 = median, 0.99 = 99th percentile (0 if empty) */
+    double percentile(double fraction) const;
+    double getMax() const { return max_; }
+    uint64_t getCount() const { return count_; }
+
+    void reset();
+
+private:
+    std::array<uint32_t, BUCKETS> buckets_;
+    uint64_t count_;
+    double max_;
+};
+
+/**
+ * TelemetryPublisher - Periodic health messages to subscribed OSC targets
+ *
+ * Subscribers get, each at their own rate, one global message and one
+ * message per layer:
+ *
+ *   /videocomposer/telemetry/global  interval p50 p95 p99 max late sinkDrops
+ *                                    vramMB texturePoolMB framePoolMB ramClipMB rssMB
+ *                                    syncJitterMs layers
+ *   /videocomposer/telemetry/layer   s:cueId layerId decodeFps queueDepth underruns
+ *
+ * Frame time percentiles cover the subscriber's last interval; late frames,
+ * sink drops and underruns are counted since its previous message; -1 is
+ * "not available". Subscribers, frame time histograms, counter baselines
+ * and the collected sample are fixed-size storage reused every time, so
+ * collecting and publishing cost the same from the first message on.
+ *
+ * Main thread only.
+ */
+class TelemetryPublisher {
+public:
+    static constexpr size_t MAX_SUBSCRIBERS = 8;
+    static constexpr size_t MAX_LAYERS = 64;
+    static constexpr double MIN_RATE = 0.1;    // Messages per second
+    static constexpr double MAX_RATE = 30.0;
+
+    /** One layer, filled in by the collector (totals since the layer opened) */
+    struct LayerSample {
+        int layerId = -1;
+        std::string cueId;
+        uint64_t decodedFrames = 0;
+        uint64_t underruns = 0;
+        size_t queueDepth = 0;
+    };
+
+    /** Global state, filled in by the collector (totals are running totals) */
+    struct Sample {
+        uint64_t lateFrames = 0;        // Output vblanks missed
+        uint64_t sinkDrops = 0;         // Frames virtual outputs dropped
+        int64_t vramUsedBytes = -1;     // -1 = driver does not say
+        size_t texturePoolBytes = 0;
+        size_t framePoolBytes = 0;
+        size_t ramClipBytes = 0;
+        size_t residentBytes = 0;
+        double syncJitterMs = -1.0;
+    };
+
+    using Sender = std::function<bool(const std::string& target, const std::string& path,
+                                      const std::string& label, const std::vector<double>& values)>;
+
+    TelemetryPublisher();
+
+    /**
+     * Add a target or change its rate
+     * @param target "host:port"
+     * @param rateHz Messages per second (clamped to MIN_RATE..MAX_RATE)
+     * @return false if MAX_SUBSCRIBERS targets are subscribed already
+     */
+    bool subscribe(const std::string& target, double rateHz, int64_t nowUs);
+    bool unsubscribe(const std::string& target);
+    size_t getSubscriberCount() const { return subscriberCount_; }
+
+    /** Time of one render loop iteration (every frame) */
+    void recordFrame(double ms);
+
+    /** True if a subscriber's next message is due (collect only then) */
+    bool isDue(int64_t nowUs) const;
+
+    /**
+     * Start filling the sample for publish() (storage is reused)
+     */
+    Sample& beginSample();
+
+    /** @return Next layer entry, or nullptr past MAX_LAYERS */
+    LayerSample* addLayer();
+
+    /**
+     * Send the sample to the subscribers that are due
+     * @return Messages sent
+     */
+    size_t publish(int64_t nowUs, const Sender& send);
+
+private:
+    struct LayerBaseline {
+        int layerId = -1;
+        uint64_t decodedFrames = 0;
+        uint64_t underruns = 0;
+    };
+
+    struct Subscriber {
+        std::string target;
+        int64_t intervalUs = 0;
+        int64_t lastUs = 0;
+        FrameTimeHistogram frameTimes;
+        bool hasBaseline = false;
+        uint64_t lateFrames = 0;        // Totals at the previous message
+        uint64_t sinkDrops = 0;
+        std::array<LayerBaseline, MAX_LAYERS> layers;
+        size_t layerCount = 0;
+    };
+
+    void publishTo(Subscriber& subscriber, int64_t nowUs, const Sender& send, size_t& sent);
+    static const LayerBaseline* findBaseline(const Subscriber& subscriber, int layerId);
+
+    std::array<Subscriber, MAX_SUBSCRIBERS> subscribers_;
+    size_t subscriberCount_;
+
+    Sample sample_;
+    std::vector<LayerSample> layers_;   // MAX_LAYERS entries, the first layerCount_ in use
+    size_t layerCount_;
+    std::vector<double> values_;        // Message arguments, capacity reused
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TELEMETRYPUBLISHER_H
@@ -1,11 +1,13 @@
 #include "ALSASeqMIDIDriver.h"
 #include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/TimeUtils.h"
 #include <alsa/asoundlib.h>
-#include <pthread.h>
 #include <poll.h>
 #include <unistd.h>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 
 // No longer using C globals - all configuration passed via methods
 
@@ -14,6 +16,8 @@ namespace videocomposer {
 ALSASeqMIDIDriver::ALSASeqMIDIDriver()
     : seq_(nullptr)
     , portId_(-1)
+    , queueId_(-1)
+    , queueOffsetUs_(0)
     , framerate_(25.0)
     , stopThread_(false)
     , connected_(false)
@@ -116,6 +120,7 @@ void ALSASeqMIDIDriver::close() {
     connected_ = false;
     currentFrame_ = -1;
     lastFrame_ = -1;
+    clock_.reset();
 }
 
 bool ALSASeqMIDIDriver::isConnected() const {
@@ -137,6 +142,13 @@ int64_t ALSASeqMIDIDriver::pollFrame() {
         return -1;
     }
 
+    // Between complete timecodes, follow the phase-locked clock model
+    double position = clock_.getPosition(vc_get_monotonic_time());
+    bool smoothed = position >= 0.0;
+    if (smoothed) {
+        frame = static_cast<int64_t>(std::floor(position * mtcDecoder_.timecodeFramerate(framerate_)));
+    }
+
     // Apply clock adjustment if enabled
     if (midiClkAdj_) {
         const auto& tc = mtcDecoder_.getTimecode();
@@ -150,6 +162,7 @@ int64_t ALSASeqMIDIDriver::pollFrame() {
             if (stopCount_ > threshold) {
                 // Transport appears stuck - reset
                 mtcDecoder_.reset();
+                clock_.reset();
                 if (verbose_) {
                     printf("\r\t\t\t\t\t\t        -?-\r");
                     fflush(stdout);
@@ -161,8 +174,8 @@ int64_t ALSASeqMIDIDriver::pollFrame() {
             lastFrame_ = frame;
         }
 
-        // Apply quarter-frame adjustment
-        double diff = tc.tick / 4.0;
+        // Apply quarter-frame adjustment (the clock model already covers it)
+        double diff = smoothed ? 0.0 : tc.tick / 4.0;
         if (verbose_) {
             double adj = (diff < 0) ? std::rint(4.0 * (1.75 - diff)) :
                         (diff < 2.0) ? 0 : std::rint(4.0 * (diff - 1.75));
@@ -198,7 +211,8 @@ bool ALSASeqMIDIDriver::openSequencer() {
     // Set client name for ALSA Sequencer (appears in aconnect -l)
     const char* seqName = "cuems-videocomposer";
 
-    int err = snd_seq_open(&seq_, "default", SND_SEQ_OPEN_INPUT, 0);
+    // Duplex: starting the timestamp queue is an output event
+    int err = snd_seq_open(&seq_, "default", SND_SEQ_OPEN_DUPLEX, 0);
     if (err < 0) {
         LOG_ERROR << "Cannot open ALSA sequencer: " << snd_strerror(err);
         seq_ = nullptr;
@@ -229,6 +243,13 @@ void ALSASeqMIDIDriver::closeSequencer() {
         fflush(stdout);
     }
 
+    if (queueId_ >= 0) {
+        snd_seq_stop_queue(seq_, queueId_, nullptr);
+        snd_seq_drain_output(seq_);
+        snd_seq_free_queue(seq_, queueId_);
+        queueId_ = -1;
+    }
+
     snd_seq_close(seq_);
     seq_ = nullptr;
     portId_ = -1;
@@ -239,15 +260,36 @@ bool ALSASeqMIDIDriver::createPort() {
         return false;
     }
 
-    int err = snd_seq_create_simple_port(seq_, "MTC in",
-                                         SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
-                                         SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    // Events are stamped when they enter the sequencer, not when this
+    // thread gets to read them
+    queueId_ = snd_seq_alloc_named_queue(seq_, "cuems-videocomposer MTC");
+    if (queueId_ < 0) {
+        LOG_WARNING << "MTC: No sequencer queue for timestamps (" << snd_strerror(queueId_)
+                    << "), using read times";
+    }
+
+    snd_seq_port_info_t* pinfo;
+    snd_seq_port_info_alloca(&pinfo);
+    snd_seq_port_info_set_name(pinfo, "MTC in");
+    snd_seq_port_info_set_capability(pinfo, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE);
+    snd_seq_port_info_set_type(pinfo, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (queueId_ >= 0) {
+        snd_seq_port_info_set_timestamping(pinfo, 1);
+        snd_seq_port_info_set_timestamp_real(pinfo, 1);
+        snd_seq_port_info_set_timestamp_queue(pinfo, queueId_);
+    }
+    int err = snd_seq_create_port(seq_, pinfo);
     if (err < 0) {
         LOG_ERROR << "Cannot create port: " << snd_strerror(err);
         return false;
     }
 
-    portId_ = err;
+    portId_ = snd_seq_port_info_get_port(pinfo);
+    
+    if (queueId_ >= 0 && !startTimestampQueue()) {
+        snd_seq_free_queue(seq_, queueId_);
+        queueId_ = -1;
+    }
     
     // Get client ID and always print port info (not just verbose)
     int clientId = snd_seq_client_id(seq_);
@@ -258,6 +300,33 @@ bool ALSASeqMIDIDriver::createPort() {
     return true;
 }
 
+bool ALSASeqMIDIDriver::startTimestampQueue() {
+    int err = snd_seq_start_queue(seq_, queueId_, nullptr);
+    if (err >= 0) {
+        err = snd_seq_drain_output(seq_);
+    }
+    if (err < 0) {
+        LOG_WARNING << "MTC: Cannot start the timestamp queue (" << snd_strerror(err) << "), using read times";
+        return false;
+    }
+    
+    // Queue real time is kernel monotonic time since the start; read both
+    // clocks once to map event stamps onto vc_get_monotonic_time()
+    snd_seq_queue_status_t* status;
+    snd_seq_queue_status_alloca(&status);
+    int64_t before = vc_get_monotonic_time();
+    err = snd_seq_get_queue_status(seq_, queueId_, status);
+    int64_t after = vc_get_monotonic_time();
+    if (err < 0) {
+        LOG_WARNING << "MTC: Cannot read the timestamp queue (" << snd_strerror(err) << "), using read times";
+        return false;
+    }
+    const snd_seq_real_time_t* real = snd_seq_queue_status_get_real_time(status);
+    int64_t queueUs = static_cast<int64_t>(real->tv_sec) * 1000000 + real->tv_nsec / 1000;
+    queueOffsetUs_ = (before + after) / 2 - queueUs;
+    return true;
+}
+
 bool ALSASeqMIDIDriver::connectToPort(const std::string& portName) {
     if (!seq_ || portId_ < 0) {
         return false;
@@ -280,24 +349,37 @@ bool ALSASeqMIDIDriver::connectToPort(const std::string& portName) {
     return true;
 }
 
-void ALSASeqMIDIDriver::processEvent(void* eventPtr) {
+void ALSASeqMIDIDriver::processEvent(void* eventPtr, int64_t receivedUs) {
     snd_seq_event_t* ev = static_cast<snd_seq_event_t*>(eventPtr);
     
-    // Always log event type for debugging (not just verbose)
-    printf("MTC: Received event type: %d (0x%02x)\n", ev->type, ev->type);
-    fflush(stdout);
+    // Printing on every quarter frame would delay the next one: verbose only
+    if (verbose_) {
+        printf("MTC: Received event type: %d (0x%02x)\n", ev->type, ev->type);
+        fflush(stdout);
+    }
     
     if (ev->type == SND_SEQ_EVENT_QFRAME) {
         // MTC quarter-frame message (ALSA sequencer QFRAME event)
         // The value contains the quarter-frame data byte (lower 7 bits)
         uint8_t data = static_cast<uint8_t>(ev->data.control.value & 0x7F);
         
-        printf("MTC: Received QFRAME event: 0x%02x (value=%d)\n", data, ev->data.control.value);
-        fflush(stdout);
+        if (verbose_) {
+            printf("MTC: Received QFRAME event: 0x%02x (value=%d)\n", data, ev->data.control.value);
+            fflush(stdout);
+        }
         
         bool complete = mtcDecoder_.processByte(data);
         if (complete) {
-            // Timecode decoded successfully
+            // The timecode is that of the first quarter frame, 7 quarter frames
+            // ago; the sample is timed by when the last one reached the sequencer
+            int64_t arrivalUs = receivedUs;
+            if (queueId_ >= 0 && (ev->flags & SND_SEQ_TIME_STAMP_MASK) == SND_SEQ_TIME_STAMP_REAL) {
+                arrivalUs = queueOffsetUs_ + static_cast<int64_t>(ev->time.time.tv_sec) * 1000000 +
+                            ev->time.time.tv_nsec / 1000;
+            }
+            double fps = mtcDecoder_.timecodeFramerate(framerate_);
+            double position = (mtcDecoder_.timecodeToFrame(framerate_) + 1.75) / fps;
+            clock_.addSample(position, std::min(arrivalUs, receivedUs));
         }
     } else if (ev->type >= SND_SEQ_EVENT_NOTE && ev->type <= SND_SEQ_EVENT_SENSING) {
         // MIDI events (note, controller, etc.) - these shouldn't contain MTC
@@ -320,6 +402,9 @@ void ALSASeqMIDIDriver::processEvent(void* eventPtr) {
 }
 
 void ALSASeqMIDIDriver::runThread() {
+    // Timecode must not wait behind rendering or decoding threads (SCHED_FIFO
+    // unless thread_midi says otherwise)
+    ThreadRoles::instance().apply(ThreadRole::MIDI);
     if (!seq_) {
         return;
     }
@@ -343,7 +428,8 @@ void ALSASeqMIDIDriver::runThread() {
             continue; // Timeout
         }
 
-        // Process events
+        // Process events (stamps the sequencer did not set fall back to now)
+        int64_t receivedUs = vc_get_monotonic_time();
         do {
             snd_seq_event_t* event = nullptr;
             int err = snd_seq_event_input(seq_, &event);
@@ -354,7 +440,7 @@ void ALSASeqMIDIDriver::runThread() {
             
             if (event) {
                 std::lock_guard<std::mutex> lock(mutex_);
-                processEvent(event);
+                processEvent(event, receivedUs);
             }
         } while (true); // Continue until no more events
     }
@@ -475,5 +561,16 @@ bool ALSASeqMIDIDriver::connectToMidiThrough() {
     return false;
 }
 
+double ALSASeqMIDIDriver::getJitter() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return clock_.isLocked() ? clock_.getJitter() : -1.0;
+}
+
+int64_t ALSASeqMIDIDriver::getFrameTime(int64_t frame) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double fps = mtcDecoder_.timecodeFramerate(framerate_);
+    return fps > 0.0 ? clock_.getTime(frame / fps) : -1;
+}
+
 } // namespace videocomposer
 
@@ -3,6 +3,7 @@
 
 #include "MIDIDriver.h"
 #include "MTCDecoder.h"
+#include "TimecodeClock.h"
 #include <string>
 #include <memory>
 #include <thread>
@@ -21,6 +22,11 @@ namespace videocomposer {
  * 
  * Implements MIDIDriver using ALSA Sequencer API.
  * Supports MTC (MIDI Time Code) synchronization via ALSA sequencer ports.
+ *
+ * The receive thread blocks in poll() on the sequencer descriptors and runs
+ * at real-time priority. The port stamps every event with a queue's real
+ * time (SND_SEQ_TIME_STAMP_REAL) as it enters the sequencer. The clock
+ * model is fed those arrival times, so thread wake-up latency adds no jitter.
  */
 class ALSASeqMIDIDriver : public MIDIDriver {
 public:
@@ -34,6 +40,8 @@ public:
     int64_t pollFrame() override;
     const char* getName() const override { return "ALSA-Sequencer"; }
     bool isSupported() const override;
+    double getJitter() const override;
+    int64_t getFrameTime(int64_t frame) const override;
 
     /**
      * Set framerate for frame calculation
@@ -78,19 +86,23 @@ private:
     void closeSequencer();
     bool createPort();
     bool connectToPort(const std::string& portName);
-    void processEvent(void* event);
+    bool startTimestampQueue();
+    void processEvent(void* event, int64_t receivedUs);
     
     // Background thread function
     void runThread();
 
     snd_seq_t* seq_;
     int portId_;
+    int queueId_;            // Queue whose real time stamps incoming events (-1: none)
+    int64_t queueOffsetUs_;  // Monotonic time at queue real time 0
     MTCDecoder mtcDecoder_;
+    TimecodeClock clock_;  // Smooths the complete timecodes (every 2 frames)
     double framerate_;
     
     // Thread management
     std::thread thread_;
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
     std::atomic<bool> stopThread_;
     std::atomic<bool> connected_;
     
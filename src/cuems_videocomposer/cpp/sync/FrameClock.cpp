@@ -0,0 +1,113 @@
+#include "FrameClock.h"
+
+namespace videocomposer {
+
+FrameClock::FrameClock(SyncSource* source)
+    : source_(source)
+{
+}
+
+void FrameClock::setSource(SyncSource* source) {
+    if (source == source_) {
+        return;
+    }
+    source_ = source;
+    sample_ = Sample();
+}
+
+const FrameClock::Sample& FrameClock::sample() {
+    uint64_t serial = sample_.serial + 1;
+    sample_ = Sample();
+    sample_.serial = serial;
+    if (!source_ || !source_->isConnected()) {
+        return sample_;
+    }
+    uint8_t rolling = 0;
+    sample_.connected = true;
+    sample_.frame = source_->pollFrame(&rolling);
+    sample_.rolling = rolling != 0;
+    sample_.framerate = source_->getFramerate();
+    return sample_;
+}
+
+const FrameClock::Sample& FrameClock::sample(int64_t presentUs, int64_t nowUs) {
+    if (source_) {
+        source_->setPresentationLead(static_cast<double>(presentUs - nowUs) / 1e6);
+    }
+    return sample();
+}
+
+bool FrameClock::connect(const char* param) {
+    return source_ ? source_->connect(param) : false;
+}
+
+void FrameClock::disconnect() {
+    if (source_) {
+        source_->disconnect();
+    }
+}
+
+bool FrameClock::isConnected() const {
+    if (sample_.serial == 0) {
+        return source_ ? source_->isConnected() : false;
+    }
+    return sample_.connected;
+}
+
+int64_t FrameClock::pollFrame(uint8_t* rolling) {
+    if (sample_.serial == 0) {
+        if (!source_) {
+            if (rolling) {
+                *rolling = 0;
+            }
+            return -1;
+        }
+        return source_->pollFrame(rolling);
+    }
+    if (rolling) {
+        *rolling = sample_.rolling ? 1 : 0;
+    }
+    return sample_.frame;
+}
+
+int64_t FrameClock::getCurrentFrame() const {
+    if (sample_.serial == 0) {
+        return source_ ? source_->getCurrentFrame() : -1;
+    }
+    return sample_.frame;
+}
+
+const char* FrameClock::getName() const {
+    return source_ ? source_->getName() : "FrameClock";
+}
+
+double FrameClock::getFramerate() const {
+    if (sample_.serial == 0) {
+        return source_ ? source_->getFramerate() : -1.0;
+    }
+    return sample_.framerate;
+}
+
+bool FrameClock::wasFullFrameReceived() {
+    return source_ ? source_->wasFullFrameReceived() : false;
+}
+
+uint64_t FrameClock::readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+    return source_ ? source_->readTransportEvents(since, events) : since;
+}
+
+void FrameClock::setPresentationLead(double seconds) {
+    if (source_) {
+        source_->setPresentationLead(seconds);
+    }
+}
+
+double FrameClock::getJitter() const {
+    return source_ ? source_->getJitter() : -1.0;
+}
+
+int64_t FrameClock::getFrameTime(int64_t frame) const {
+    return source_ ? source_->getFrameTime(frame) : -1;
+}
+
+} // namespace videocomposer
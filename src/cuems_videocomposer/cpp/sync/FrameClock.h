@@ -0,0 +1,76 @@
+#ifndef VIDEOCOMPOSER_FRAMECLOCK_H
+#define VIDEOCOMPOSER_FRAMECLOCK_H
+
+#include "SyncSource.h"
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * FrameClock - The global sync source, sampled once per render
+ *
+ * Every layer's FramerateConverterSyncSource, the OSD and the outputs
+ * used to poll the global source on their own, each at a slightly later
+ * moment of the same loop iteration: with a clock model interpolating
+ * between timecode messages two layers could land on either side of a
+ * frame boundary. The loop calls sample() once, after the presentation
+ * lead is set, and everything polling the clock reads that sample: one
+ * position (at the predicted presentation time), rolling state and rate
+ * per rendered frame, for one poll of the source.
+ *
+ * Before the first sample, pollFrame() reads the source directly. Transport
+ * events, full frames and clock queries are passed through.
+ */
+class FrameClock : public SyncSource {
+public:
+    struct Sample {
+        bool connected = false;
+        int64_t frame = -1;         // At the presentation time, -1 if unknown
+        bool rolling = false;
+        double framerate = -1.0;    // Of the timecode, -1.0 if unknown
+        uint64_t serial = 0;        // Samples taken, 0 = none yet
+    };
+
+    explicit FrameClock(SyncSource* source = nullptr);
+
+    /** The source sampled (non-owning); another one drops the sample */
+    void setSource(SyncSource* source);
+    SyncSource* getSource() const { return source_; }
+
+    /** Poll the source for this render (once per loop iteration) */
+    const Sample& sample();
+
+    /**
+     * Poll the source for the frame shown at presentUs (monotonic, us)
+     * The lead is set to the time left from nowUs, so samples taken at
+     * different moments for the same vsync pick the same frame.
+     */
+    const Sample& sample(int64_t presentUs, int64_t nowUs);
+
+    /** The last sample */
+    const Sample& getSample() const { return sample_; }
+
+    // SyncSource interface: the sample, or the source before there is one
+    bool connect(const char* param = nullptr) override;
+    void disconnect() override;
+    bool isConnected() const override;
+    int64_t pollFrame(uint8_t* rolling = nullptr) override;
+    int64_t getCurrentFrame() const override;
+    const char* getName() const override;
+    double getFramerate() const override;
+
+    // Passed through to the source
+    bool wasFullFrameReceived() override;
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override;
+    void setPresentationLead(double seconds) override;
+    double getJitter() const override;
+    int64_t getFrameTime(int64_t frame) const override;
+
+private:
+    SyncSource* source_;
+    Sample sample_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMECLOCK_H
@@ -0,0 +1,182 @@
+#include "FrameLockSyncSource.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+namespace {
+const char* const TIMELINE_PATH = "/videocomposer/framelock/timeline";
+const char* const SKEW_PATH = "/videocomposer/framelock/skew";
+}
+
+FrameLockSyncSource::FrameLockSyncSource(std::unique_ptr<SyncSource> syncSource, Role role)
+    : syncSource_(std::move(syncSource))
+    , role_(role)
+    , lastTimelineUs_(0)
+    , updated_(false)
+    , frame_(-1)
+    , rolling_(0)
+    , shownFrame_(-1)
+    , lastLocalFrame_(-1)
+    , lastVblankUs_(0)
+    , lastReportUs_(0)
+{
+}
+
+void FrameLockSyncSource::setTransport(Sender sender, std::vector<std::string> peers,
+                                       std::string reportTarget, std::string nodeName) {
+    sender_ = std::move(sender);
+    peers_ = std::move(peers);
+    reportTarget_ = std::move(reportTarget);
+    nodeName_ = std::move(nodeName);
+}
+
+void FrameLockSyncSource::update(int64_t vblankRealtimeUs) {
+    if (!syncSource_) {
+        return;
+    }
+
+    uint8_t rolling = 0;
+    int64_t localFrame = syncSource_->pollFrame(&rolling);
+    double fps = getFramerate();
+
+    if (role_ == Role::Master) {
+        if (rolling && localFrame >= 0 && localFrame != lastLocalFrame_) {
+            // The frame became due between the previous vblank and this one
+            int64_t dueUs = vblankRealtimeUs;
+            if (localFrame == lastLocalFrame_ + 1 && lastVblankUs_ > 0) {
+                dueUs = (lastVblankUs_ + vblankRealtimeUs) / 2;
+            }
+            double position = localFrame / fps;
+            addTimelineSample(position, dueUs);
+            if (sender_) {
+                for (const std::string& peer : peers_) {
+                    sender_(peer, TIMELINE_PATH, "", {position, static_cast<double>(dueUs)});
+                }
+            }
+        }
+        lastLocalFrame_ = rolling ? localFrame : -1;
+        lastVblankUs_ = vblankRealtimeUs;
+    }
+
+    int64_t previousFrame = shownFrame_;
+    shownFrame_ = -1;
+    frame_ = localFrame;
+    rolling_ = rolling;
+    if (timeline_.isLocked() && vblankRealtimeUs - lastTimelineUs_ < TIMELINE_TIMEOUT_US) {
+        // First vblank at or after the agreed time shows the frame
+        double position = timeline_.getPosition(vblankRealtimeUs);
+        int64_t frame = static_cast<int64_t>(std::floor(position * fps + 1e-6));
+        if (frame != previousFrame) {
+            // Skew of the first vblank showing each frame
+            int64_t dueUs = timeline_.getTime(frame / fps);
+            double lateUs = static_cast<double>(std::max<int64_t>(0, vblankRealtimeUs - dueUs));
+            stats_.meanLateUs = (stats_.meanLateUs * stats_.frames + lateUs) / (stats_.frames + 1);
+            stats_.maxLateUs = std::max(stats_.maxLateUs, lateUs);
+            stats_.frames++;
+            if (localFrame != frame) {
+                stats_.mismatches++;
+            }
+        }
+        shownFrame_ = frame;
+        frame_ = frame;
+        rolling_ = 1;
+    }
+    updated_ = true;
+
+    report(vblankRealtimeUs);
+}
+
+void FrameLockSyncSource::receiveTimeline(double position, int64_t realtimeUs) {
+    if (role_ != Role::Follower) {
+        return;
+    }
+    addTimelineSample(position, realtimeUs);
+}
+
+void FrameLockSyncSource::addTimelineSample(double position, int64_t realtimeUs) {
+    timeline_.addSample(position, realtimeUs);
+    lastTimelineUs_ = realtimeUs;
+    if (timeline_.wasLocated()) {
+        LOG_INFO << "FrameLock: Timeline located to " << position << " s";
+    }
+}
+
+FrameLockSyncSource::SkewStats FrameLockSyncSource::takeSkewStats() {
+    SkewStats stats = stats_;
+    stats_ = SkewStats();
+    return stats;
+}
+
+void FrameLockSyncSource::report(int64_t nowUs) {
+    if (!sender_ || reportTarget_.empty() || nowUs - lastReportUs_ < REPORT_INTERVAL_US) {
+        return;
+    }
+    lastReportUs_ = nowUs;
+    SkewStats stats = takeSkewStats();
+    sender_(reportTarget_, SKEW_PATH, nodeName_,
+            {static_cast<double>(stats.frames), stats.meanLateUs / 1000.0, stats.maxLateUs / 1000.0,
+             static_cast<double>(stats.mismatches)});
+}
+
+bool FrameLockSyncSource::connect(const char* param) {
+    return syncSource_ && syncSource_->connect(param);
+}
+
+void FrameLockSyncSource::disconnect() {
+    if (syncSource_) {
+        syncSource_->disconnect();
+    }
+}
+
+bool FrameLockSyncSource::isConnected() const {
+    return syncSource_ && syncSource_->isConnected();
+}
+
+int64_t FrameLockSyncSource::pollFrame(uint8_t* rolling) {
+    if (!updated_) {
+        // Not driven by the render loop (yet): plain pass-through
+        return syncSource_ ? syncSource_->pollFrame(rolling) : -1;
+    }
+    if (rolling) {
+        *rolling = rolling_;
+    }
+    return frame_;
+}
+
+int64_t FrameLockSyncSource::getCurrentFrame() const {
+    return updated_ ? frame_ : (syncSource_ ? syncSource_->getCurrentFrame() : -1);
+}
+
+const char* FrameLockSyncSource::getName() const {
+    return syncSource_ ? syncSource_->getName() : "FrameLock";
+}
+
+double FrameLockSyncSource::getFramerate() const {
+    double fps = syncSource_ ? syncSource_->getFramerate() : -1.0;
+    return fps > 0.0 ? fps : 25.0;
+}
+
+bool FrameLockSyncSource::wasFullFrameReceived() {
+    return syncSource_ && syncSource_->wasFullFrameReceived();
+}
+
+uint64_t FrameLockSyncSource::readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+    return syncSource_ ? syncSource_->readTransportEvents(since, events) : since;
+}
+
+void FrameLockSyncSource::setPresentationLead(double seconds) {
+    if (syncSource_) {
+        syncSource_->setPresentationLead(seconds);
+    }
+}
+
+double FrameLockSyncSource::getJitter() const {
+    if (role_ == Role::Follower && timeline_.isLocked()) {
+        return timeline_.getJitter();
+    }
+    return syncSource_ ? syncSource_->getJitter() : -1.0;
+}
+
+} // namespace videocomposer
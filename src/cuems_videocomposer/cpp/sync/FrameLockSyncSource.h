@@ -0,0 +1,124 @@
+#ifndef VIDEOCOMPOSER_FRAMELOCKSYNCSOURCE_H
+#define VIDEOCOMPOSER_FRAMELOCKSYNCSOURCE_H
+
+#include "SyncSource.h"
+#include "TimecodeClock.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * FrameLockSyncSource - Frame lock between several nodes on one surface
+ *
+ * Wraps the global sync source. The master publishes a timeline: each time
+ * its timecode moves to a new frame, the wall-clock time (vc_get_realtime,
+ * PTP/NTP-disciplined) at which that frame became due. Every node, master
+ * included, fits a TimecodeClock to the timeline and shows a frame on the
+ * first vblank at or after its agreed time, so projectors flipping on
+ * independent vblanks never disagree by more than the vblank phase.
+ *
+ * Without a timeline (before the first message, or when the master stops
+ * sending), the wrapped source is used unchanged.
+ */
+class FrameLockSyncSource : public SyncSource {
+public:
+    enum class Role { Master, Follower };
+
+    // Timeline samples older than this no longer drive frame choice
+    static constexpr int64_t TIMELINE_TIMEOUT_US = 500000;
+    static constexpr int64_t REPORT_INTERVAL_US = 1000000;
+
+    /**
+     * Send an OSC message: target ("host:port"), path, label, values
+     */
+    using Sender = std::function<void(const std::string&, const std::string&,
+                                      const std::string&, const std::vector<double>&)>;
+
+    struct SkewStats {
+        int64_t frames = 0;         // Frames presented from the timeline
+        double meanLateUs = 0.0;    // Vblank time after the agreed frame time
+        double maxLateUs = 0.0;
+        int64_t mismatches = 0;     // Frames where the local timecode disagreed
+    };
+
+    FrameLockSyncSource(std::unique_ptr<SyncSource> syncSource, Role role);
+
+    /**
+     * @param sender Message transport (e.g. OSCRemoteControl::sendMessage)
+     * @param peers Followers receiving the timeline (master only)
+     * @param reportTarget Receiver of skew telemetry (empty = none)
+     * @param nodeName Label of this node in the telemetry
+     */
+    void setTransport(Sender sender, std::vector<std::string> peers,
+                      std::string reportTarget, std::string nodeName);
+
+    /**
+     * Choose the frame for the next render (once per render, after the
+     * presentation lead is set)
+     * @param vblankRealtimeUs Predicted wall-clock time of the vblank showing it
+     */
+    void update(int64_t vblankRealtimeUs);
+
+    /**
+     * Timeline sample from the master (follower only)
+     * @param position Timecode in seconds
+     * @param realtimeUs Wall-clock time the position became due
+     */
+    void receiveTimeline(double position, int64_t realtimeUs);
+
+    /**
+     * Skew since the last call
+     */
+    SkewStats takeSkewStats();
+
+    Role getRole() const { return role_; }
+    SyncSource* getWrappedSyncSource() { return syncSource_.get(); }
+
+    // SyncSource interface - delegates to the wrapped source, except for
+    // the frame chosen in update()
+    bool connect(const char* param = nullptr) override;
+    void disconnect() override;
+    bool isConnected() const override;
+    int64_t pollFrame(uint8_t* rolling = nullptr) override;
+    int64_t getCurrentFrame() const override;
+    const char* getName() const override;
+    double getFramerate() const override;
+    bool wasFullFrameReceived() override;
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override;
+    void setPresentationLead(double seconds) override;
+    double getJitter() const override;   // Of the master's timeline on followers
+
+private:
+    void addTimelineSample(double position, int64_t realtimeUs);
+    void report(int64_t nowUs);
+
+    std::unique_ptr<SyncSource> syncSource_;
+    Role role_;
+    TimecodeClock timeline_;
+    int64_t lastTimelineUs_;      // Wall-clock time of the last sample
+
+    // Frame chosen by update(), returned by pollFrame()
+    bool updated_;
+    int64_t frame_;
+    uint8_t rolling_;
+    int64_t shownFrame_;          // Last frame taken from the timeline (-1 = none)
+
+    // Master: local frame transitions
+    int64_t lastLocalFrame_;
+    int64_t lastVblankUs_;
+
+    Sender sender_;
+    std::vector<std::string> peers_;
+    std::string reportTarget_;
+    std::string nodeName_;
+    SkewStats stats_;
+    int64_t lastReportUs_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMELOCKSYNCSOURCE_H
@@ -1,5 +1,6 @@
 #include "FramerateConverterSyncSource.h"
-#include <cmath>
+#include "../utils/SMPTEUtils.h"
+#include <numeric>
 
 namespace videocomposer {
 
@@ -8,6 +9,14 @@ FramerateConverterSyncSource::FramerateConverterSyncSource(
     InputSource* inputSource)
     : wrappedSyncSource_(syncSource)
     , inputSource_(inputSource)
+    , ratioSyncFps_(-1.0)
+    , ratioInputFps_(-1.0)
+    , ratioInputNum_(-1)
+    , ratioInputDen_(-1)
+    , ratioNum_(1)
+    , ratioDen_(1)
+    , lastSyncFrame_(-1)
+    , lastVideoFrame_(-1)
 {
     if (!wrappedSyncSource_) {
         // Can't work without a sync source
@@ -40,32 +49,67 @@ int64_t FramerateConverterSyncSource::pollFrame(uint8_t* rolling) {
         return -1;
     }
     // Get frame from wrapped sync source
-    int64_t syncFrame = wrappedSyncSource_->pollFrame(rolling);
+    uint8_t isRolling = 0;
+    int64_t syncFrame = wrappedSyncSource_->pollFrame(&isRolling);
+    if (rolling) {
+        *rolling = isRolling;
+    }
     
     // Match xjadeo's framerate conversion logic:
     // - Default (midi_clkconvert == 0): Use MTC fps info directly (no conversion)
     // - Only convert if framerates are different AND conversion is needed
     // - Use floor() for timescale (handled in LayerPlayback), rint() only for explicit resample mode
-    // For now, we only convert if framerates differ significantly
-    // This matches xjadeo's default behavior of using MTC fps directly
-    if (syncFrame >= 0 && inputSource_) {
-        double syncFps = wrappedSyncSource_->getFramerate();
-        if (syncFps > 0) {
-            FrameInfo info = inputSource_->getFrameInfo();
-            double inputFps = info.framerate;
-            
-            // Only convert if both framerates are known and significantly different
-            // Use floor() instead of rint() to match xjadeo's timescale behavior
-            // This prevents rounding issues that cause frame skips
-            if (inputFps > 0 && std::abs(syncFps - inputFps) > 0.01) {
-                // Convert: inputFrame = floor(syncFrame * inputFps / syncFps)
-                // Using floor() matches xjadeo's timescale approach and prevents rounding skips
-                syncFrame = static_cast<int64_t>(std::floor(static_cast<double>(syncFrame) * inputFps / syncFps));
-            }
-        }
+    if (syncFrame < 0 || !inputSource_ || !updateRatio(wrappedSyncSource_->getFramerate(), inputSource_->getFrameInfo())) {
+        lastSyncFrame_ = -1;
+        return syncFrame;
     }
-    
-    return syncFrame;
+
+    if (isRolling && syncFrame == lastSyncFrame_ - 1) {
+        // Sync jitter across a frame boundary: keep the frame on screen
+        return lastVideoFrame_;
+    }
+
+    // Floor division (exact for negative values too)
+    int64_t product = syncFrame * ratioNum_;
+    int64_t videoFrame = product / ratioDen_;
+    if (product % ratioDen_ != 0 && product < 0) {
+        --videoFrame;
+    }
+    lastSyncFrame_ = syncFrame;
+    lastVideoFrame_ = videoFrame;
+    return videoFrame;
+}
+
+bool FramerateConverterSyncSource::updateRatio(double syncFps, const FrameInfo& info) {
+    if (syncFps == ratioSyncFps_ && info.framerate == ratioInputFps_ && info.framerateNum == ratioInputNum_ && info.framerateDen == ratioInputDen_) {
+        return ratioNum_ != ratioDen_;
+    }
+    ratioSyncFps_ = syncFps;
+    ratioInputFps_ = info.framerate;
+    ratioInputNum_ = info.framerateNum;
+    ratioInputDen_ = info.framerateDen;
+    ratioNum_ = 1;
+    ratioDen_ = 1;
+    lastSyncFrame_ = -1;
+
+    int64_t syncNum = 0, syncDen = 1;
+    SMPTEUtils::framerateToRational(syncFps, syncNum, syncDen);
+    int64_t inputNum = info.framerateNum;
+    int64_t inputDen = info.framerateDen;
+    if (inputNum <= 0 || inputDen <= 0) {
+        SMPTEUtils::framerateToRational(info.framerate, inputNum, inputDen);
+    }
+    // Only convert if both framerates are known and different
+    if (syncNum <= 0 || inputNum <= 0) {
+        return false;
+    }
+
+    int64_t num = inputNum * syncDen;
+    int64_t den = inputDen * syncNum;
+    int64_t g = std::gcd(num, den);
+    ratioNum_ = num / g;
+    ratioDen_ = den / g;
+    return ratioNum_ != ratioDen_;
 }
 
 int64_t FramerateConverterSyncSource::getCurrentFrame() const {
@@ -103,5 +147,18 @@ bool FramerateConverterSyncSource::wasFullFrameReceived() {
     return wrappedSyncSource_->wasFullFrameReceived();
 }
 
+uint64_t FramerateConverterSyncSource::readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+    if (!wrappedSyncSource_) {
+        return since;
+    }
+    return wrappedSyncSource_->readTransportEvents(since, events);
+}
+
+void FramerateConverterSyncSource::setPresentationLead(double seconds) {
+    if (wrappedSyncSource_) {
+        wrappedSyncSource_->setPresentationLead(seconds);
+    }
+}
+
 } // namespace videocomposer
 
@@ -10,7 +10,10 @@ namespace videocomposer {
  * FramerateConverterSyncSource - Wraps any SyncSource and converts framerate
  * 
  * This adapter converts frames from the sync source's framerate to the input
- * source's framerate using Option 2 (resample): videoFrame = rint(syncFrame * inputFps / syncFps)
+ * source's framerate: videoFrame = floor(syncFrame * inputFps / syncFps),
+ * in exact integer arithmetic on the rational framerates (e.g. 30000/1001
+ * MTC against 24000/1001 media is exactly 4/5), so long shows neither drift
+ * nor flip between neighbouring frames on rounding.
  * 
  * This is timecode-agnostic and works with:
  * - Any sync source (MIDI, LTC, JACK, etc.)
@@ -48,10 +51,47 @@ public:
      * Check if a full frame SYSEX was just received - delegates to wrapped sync source
      */
     bool wasFullFrameReceived() override;
+    
+    /**
+     * Transport events of the wrapped sync source (frames are its frames)
+     */
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override;
+    
+    /**
+     * Set the presentation lead - delegates to wrapped sync source
+     */
+    void setPresentationLead(double seconds) override;
+    
+    /**
+     * Jitter of the wrapped sync source
+     */
+    double getJitter() const override { return wrappedSyncSource_ ? wrappedSyncSource_->getJitter() : -1.0; }
+    // Frames of the wrapped source (not converted)
+    int64_t getFrameTime(int64_t frame) const override {
+        return wrappedSyncSource_ ? wrappedSyncSource_->getFrameTime(frame) : -1;
+    }
 
 private:
+    /**
+     * Recompute the reduced ratio when either framerate changed
+     * @return true if a conversion is needed
+     */
+    bool updateRatio(double syncFps, const FrameInfo& info);
+
     SyncSource* wrappedSyncSource_;  // Non-owning reference to sync source
     InputSource* inputSource_;  // Non-owning reference
+
+    // videoFrame = floor(syncFrame * ratioNum_ / ratioDen_)
+    double ratioSyncFps_;
+    double ratioInputFps_;
+    int ratioInputNum_;
+    int ratioInputDen_;
+    int64_t ratioNum_;
+    int64_t ratioDen_;
+
+    // Hysteresis: a one-frame step back while rolling is jitter, not a seek
+    int64_t lastSyncFrame_;
+    int64_t lastVideoFrame_;
 };
 
 } // namespace videocomposer
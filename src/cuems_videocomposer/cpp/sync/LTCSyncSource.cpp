@@ -0,0 +1,324 @@
+#include "LTCSyncSource.h"
+#include "../utils/Logger.h"
+#include "../utils/ThreadRoles.h"
+#include "../utils/SMPTEUtils.h"
+#include "../utils/TimeUtils.h"
+#include <alsa/asoundlib.h>
+#include <ltc.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace videocomposer {
+
+namespace {
+// No frame decoded for this long: transport stopped
+constexpr int64_t ROLLING_TIMEOUT_US = 100000;
+}
+
+LTCSyncSource::LTCSyncSource()
+    : pcm_(nullptr)
+    , decoder_(nullptr)
+    , sampleRate_(DEFAULT_SAMPLE_RATE)
+    , periodFrames_(DEFAULT_PERIOD_FRAMES)
+    , channel_(0)
+    , channels_(1)
+    , stopThread_(false)
+    , connected_(false)
+    , framerate_(25.0)
+    , currentFrame_(-1)
+    , lastDecodedFrame_(-1)
+    , lastDecodeUs_(0)
+    , reverse_(false)
+    , located_(false)
+    , wasRunning_(false)
+    , lead_(0.0)
+    , lastSecs_(-1)
+    , maxFrameInSecond_(-1)
+{
+}
+
+LTCSyncSource::~LTCSyncSource() {
+    disconnect();
+}
+
+void LTCSyncSource::setFramerate(double fps) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fps > 0.0) {
+        framerate_ = fps;
+    }
+}
+
+void LTCSyncSource::setCaptureFormat(unsigned int sampleRate, unsigned int periodFrames, unsigned int channel) {
+    sampleRate_ = sampleRate > 0 ? sampleRate : DEFAULT_SAMPLE_RATE;
+    periodFrames_ = periodFrames > 0 ? periodFrames : DEFAULT_PERIOD_FRAMES;
+    channel_ = channel;
+}
+
+double LTCSyncSource::getFramerate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return framerate_;
+}
+
+bool LTCSyncSource::connect(const char* param) {
+    if (connected_) {
+        disconnect();
+    }
+
+    std::string device = (param && param[0] != '\0') ? param : "default";
+    if (!openCapture(device)) {
+        return false;
+    }
+
+    // Audio frames per video frame for the decoder's initial bit clock;
+    // it adapts to the actual LTC speed
+    int apv = static_cast<int>(sampleRate_ / framerate_);
+    decoder_ = ltc_decoder_create(apv, 32);
+    if (!decoder_) {
+        LOG_ERROR << "LTC: Cannot create decoder";
+        closeCapture();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clock_.reset();
+        currentFrame_ = -1;
+        lastDecodedFrame_ = -1;
+        lastDecodeUs_ = 0;
+        reverse_ = false;
+        located_ = false;
+        wasRunning_ = false;
+    }
+    lastSecs_ = -1;
+    maxFrameInSecond_ = -1;
+
+    stopThread_ = false;
+    try {
+        thread_ = std::thread(&LTCSyncSource::captureThread, this);
+    } catch (const std::exception& e) {
+        LOG_ERROR << "LTC: Failed to start capture thread: " << e.what();
+        ltc_decoder_free(decoder_);
+        decoder_ = nullptr;
+        closeCapture();
+        return false;
+    }
+
+    connected_ = true;
+    LOG_INFO << "LTC: Capturing from " << device << " (" << sampleRate_ << " Hz, "
+             << periodFrames_ << "-frame periods, channel " << channel_ + 1 << ")";
+    return true;
+}
+
+void LTCSyncSource::disconnect() {
+    stopThread_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (decoder_) {
+        ltc_decoder_free(decoder_);
+        decoder_ = nullptr;
+    }
+    closeCapture();
+    connected_ = false;
+}
+
+bool LTCSyncSource::isConnected() const {
+    return connected_;
+}
+
+bool LTCSyncSource::openCapture(const std::string& device) {
+    int err = snd_pcm_open(&pcm_, device.c_str(), SND_PCM_STREAM_CAPTURE, 0);
+    if (err < 0) {
+        LOG_ERROR << "LTC: Cannot open capture device " << device << " - " << snd_strerror(err);
+        pcm_ = nullptr;
+        return false;
+    }
+
+    // Four periods of buffer; short periods keep the decode latency low
+    channels_ = channel_ + 1;
+    unsigned int latencyUs = static_cast<unsigned int>(4ULL * periodFrames_ * 1000000 / sampleRate_);
+    err = snd_pcm_set_params(pcm_, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED,
+                             channels_, sampleRate_, 1, latencyUs);
+    if (err < 0) {
+        LOG_ERROR << "LTC: Cannot configure " << device << " for " << channels_ << " channel(s) at "
+                  << sampleRate_ << " Hz - " << snd_strerror(err);
+        closeCapture();
+        return false;
+    }
+
+    snd_pcm_uframes_t bufferSize = 0;
+    snd_pcm_uframes_t periodSize = 0;
+    if (snd_pcm_get_params(pcm_, &bufferSize, &periodSize) == 0 && periodSize > 0) {
+        periodFrames_ = static_cast<unsigned int>(periodSize);
+    }
+    return true;
+}
+
+void LTCSyncSource::closeCapture() {
+    if (pcm_) {
+        snd_pcm_close(pcm_);
+        pcm_ = nullptr;
+    }
+}
+
+double LTCSyncSource::detectFramerate(int frame, int secs, bool dropFrame) {
+    // LTC carries no framerate: the highest frame number before the seconds
+    // change gives it
+    if (secs != lastSecs_) {
+        int count = maxFrameInSecond_ + 1;
+        if (lastSecs_ >= 0 && (count == 24 || count == 25 || count == 30)) {
+            double fps = (count == 30 && dropFrame) ? 30000.0 / 1001.0 : count;
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (fps != framerate_) {
+                LOG_INFO << "LTC: Detected " << fps << " fps";
+                framerate_ = fps;
+            }
+        }
+        lastSecs_ = secs;
+        maxFrameInSecond_ = -1;
+    }
+    if (frame > maxFrameInSecond_) {
+        maxFrameInSecond_ = frame;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return framerate_;
+}
+
+void LTCSyncSource::captureThread() {
+    // Audio must not wait behind rendering or decoding threads (SCHED_FIFO
+    // unless thread_ltc says otherwise)
+    ThreadRoles::instance().apply(ThreadRole::LTC);
+    std::vector<short> interleaved(static_cast<size_t>(periodFrames_) * channels_);
+    std::vector<short> samples(periodFrames_);
+    ltc_off_t samplePos = 0;
+
+    while (!stopThread_) {
+        snd_pcm_sframes_t n = snd_pcm_readi(pcm_, interleaved.data(), periodFrames_);
+        if (n < 0) {
+            // Overrun or suspend: recover and drop the decoder's partial frame
+            n = snd_pcm_recover(pcm_, static_cast<int>(n), 1);
+            if (n < 0) {
+                LOG_ERROR << "LTC: Capture failed - " << snd_strerror(static_cast<int>(n));
+                break;
+            }
+            LOG_WARNING << "LTC: Capture overrun";
+            continue;
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        // Frames still in the buffer were captured after the last one read.
+        // Without a delay report, assume one period is queued
+        int64_t nowUs = vc_get_monotonic_time();
+        snd_pcm_sframes_t delay = 0;
+        if (snd_pcm_delay(pcm_, &delay) < 0 || delay < 0) {
+            delay = periodFrames_;
+        }
+        int64_t lastSampleUs = nowUs - static_cast<int64_t>(delay) * 1000000 / sampleRate_;
+
+        for (snd_pcm_sframes_t i = 0; i < n; ++i) {
+            samples[i] = interleaved[i * channels_ + channel_];
+        }
+        ltc_decoder_write_s16(decoder_, samples.data(), static_cast<size_t>(n), samplePos);
+        samplePos += n;
+
+        LTCFrameExt frame;
+        while (ltc_decoder_read(decoder_, &frame)) {
+            SMPTETimecode stime;
+            ltc_frame_to_time(&stime, &frame.ltc, 0);
+            double fps = detectFramerate(stime.frame, stime.secs, frame.ltc.dfbit != 0);
+
+            // Same frame numbering as MTCDecoder::timecodeToFrame
+            int64_t frameNumber;
+            if (frame.ltc.dfbit) {
+                frameNumber = SMPTEUtils::dropFrameToFrame(stime.frame, stime.secs, stime.mins, stime.hours);
+            } else {
+                int64_t totalSeconds = stime.hours * 3600 + stime.mins * 60 + stime.secs;
+                frameNumber = static_cast<int64_t>(totalSeconds * fps) + stime.frame;
+            }
+
+            // The last sample of a forward frame is where the next frame starts
+            int64_t endUs = lastSampleUs -
+                static_cast<int64_t>(samplePos - 1 - frame.off_end) * 1000000 / sampleRate_;
+            double position = (frameNumber + (frame.reverse ? 0 : 1)) / fps;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            lastDecodedFrame_ = frameNumber;
+            lastDecodeUs_ = nowUs;
+            reverse_ = frame.reverse != 0;
+            if (reverse_) {
+                // The clock model only runs forward
+                clock_.reset();
+            } else {
+                clock_.addSample(position, endUs);
+                if (clock_.wasLocated()) {
+                    located_ = true;
+                    transportEvents_.post(TransportEvent::Kind::LOCATE, frameNumber);
+                }
+            }
+        }
+    }
+}
+
+int64_t LTCSyncSource::pollFrame(uint8_t* rolling) {
+    if (!connected_) {
+        if (rolling) {
+            *rolling = 0;
+        }
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t nowUs = vc_get_monotonic_time();
+    bool running = lastDecodeUs_ > 0 && nowUs - lastDecodeUs_ < ROLLING_TIMEOUT_US;
+
+    int64_t frame = lastDecodedFrame_;
+    if (running && !reverse_) {
+        double position = clock_.getPosition(nowUs);
+        if (position >= 0.0) {
+            // Select the frame for when it will be on screen, not for now
+            frame = static_cast<int64_t>(std::floor((position + lead_) * framerate_));
+        }
+    }
+
+    currentFrame_ = frame;
+    if (running != wasRunning_) {
+        transportEvents_.post(running ? TransportEvent::Kind::START : TransportEvent::Kind::STOP, frame);
+        wasRunning_ = running;
+    }
+    if (rolling) {
+        *rolling = (running && frame >= 0) ? 1 : 0;
+    }
+    return frame;
+}
+
+int64_t LTCSyncSource::getCurrentFrame() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return currentFrame_;
+}
+
+bool LTCSyncSource::wasFullFrameReceived() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool result = located_;
+    located_ = false;
+    return result;
+}
+
+void LTCSyncSource::setPresentationLead(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lead_ = seconds;
+}
+
+double LTCSyncSource::getJitter() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return clock_.isLocked() ? clock_.getJitter() : -1.0;
+}
+
+int64_t LTCSyncSource::getFrameTime(int64_t frame) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return framerate_ > 0.0 ? clock_.getTime(frame / framerate_) : -1;
+}
+
+} // namespace videocomposer
@@ -2,43 +2,115 @@
 #define VIDEOCOMPOSER_LTCSYNCSOURCE_H
 
 #include "SyncSource.h"
+#include "TimecodeClock.h"
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
 #include <cstdint>
 
+// Forward declarations for ALSA and libltc
+typedef struct _snd_pcm snd_pcm_t;
+struct LTCDecoder;
+
 namespace videocomposer {
 
 /**
  * LTCSyncSource - LTC (Linear Time Code) synchronization source
- * 
+ *
  * Implements SyncSource interface for LTC synchronization.
  * Uses libltc to decode LTC timecode from audio signal.
+ *
+ * Audio is captured from an ALSA PCM device on a real-time priority thread
+ * with short periods. Each decoded frame is timestamped from the capture
+ * delay of its last sample and fed to a TimecodeClock, so polls get the
+ * same smoothed, extrapolated position as the MTC drivers.
  */
 class LTCSyncSource : public SyncSource {
 public:
+    static constexpr unsigned int DEFAULT_SAMPLE_RATE = 48000;
+    static constexpr unsigned int DEFAULT_PERIOD_FRAMES = 128;  // 2.7 ms at 48 kHz
+
     LTCSyncSource();
     virtual ~LTCSyncSource();
 
     // SyncSource interface
+    /**
+     * Start capturing
+     * @param param ALSA PCM device (e.g., "hw:1,0"), nullptr = "default"
+     */
     bool connect(const char* param = nullptr) override;
     void disconnect() override;
     bool isConnected() const override;
     int64_t pollFrame(uint8_t* rolling = nullptr) override;
     int64_t getCurrentFrame() const override;
     const char* getName() const override { return "LTC"; }
+    double getFramerate() const override;
+
+    /**
+     * A locate (jump in the timecode) was seen since the last check
+     */
+    bool wasFullFrameReceived() override;
+
+    /**
+     * Locates (from the capture thread) and running changes (seen by pollFrame())
+     */
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override {
+        return transportEvents_.read(since, events);
+    }
+
+    void setPresentationLead(double seconds) override;
+    double getJitter() const override;
+    int64_t getFrameTime(int64_t frame) const override;
 
     /**
      * Set framerate for frame calculation
-     * This should match the video file's framerate
+     * Used until the LTC framerate has been detected from the signal
      * @param fps Framerate in frames per second
      */
     void setFramerate(double fps);
 
+    /**
+     * Capture settings, applied on the next connect()
+     * @param channel Input channel carrying LTC (0-based)
+     */
+    void setCaptureFormat(unsigned int sampleRate, unsigned int periodFrames, unsigned int channel);
+
 private:
+    bool openCapture(const std::string& device);
+    void closeCapture();
+    void captureThread();
+    double detectFramerate(int frame, int secs, bool dropFrame);
+
+    snd_pcm_t* pcm_;
+    LTCDecoder* decoder_;
+    unsigned int sampleRate_;
+    unsigned int periodFrames_;
+    unsigned int channel_;
+    unsigned int channels_;       // Channels opened (channel_ + 1)
+
+    std::thread thread_;
+    std::atomic<bool> stopThread_;
+    std::atomic<bool> connected_;
+
+    // Shared with the capture thread
+    mutable std::mutex mutex_;
+    TimecodeClock clock_;
     double framerate_;
     int64_t currentFrame_;
-    bool connected_;
+    int64_t lastDecodedFrame_;
+    int64_t lastDecodeUs_;        // Monotonic time of the last decoded frame
+    bool reverse_;
+    bool located_;
+    bool wasRunning_;             // Running state at the last poll
+    double lead_;
+    TransportEventLog transportEvents_;
+
+    // Framerate detection (capture thread only)
+    int lastSecs_;
+    int maxFrameInSecond_;
 };
 
 } // namespace videocomposer
 
 #endif // VIDEOCOMPOSER_LTCSYNCSOURCE_H
-
@@ -1,5 +1,6 @@
 #include "MIDIDriver.h"
 #include "NullMIDIDriver.h"
+#include "ReplayMIDIDriver.h"
 #include "ALSASeqMIDIDriver.h"
 #ifdef HAVE_MTCRECEIVER
 #include "MtcReceiverMIDIDriver.h"
@@ -24,6 +25,11 @@ std::unique_ptr<MIDIDriver> MIDIDriverFactory::create(const std::string& driverN
     }
 #endif
     
+    // Recorded control traffic (ControlReplay)
+    if (lowerName == "replay") {
+        return std::make_unique<ReplayMIDIDriver>();
+    }
+    
     // ALSA Sequencer driver
     if (lowerName == "alsa-sequencer" || lowerName == "alsa-seq" || lowerName == "alsa") {
         auto driver = std::make_unique<ALSASeqMIDIDriver>();
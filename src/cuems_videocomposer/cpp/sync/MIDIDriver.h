@@ -1,6 +1,7 @@
 #ifndef VIDEOCOMPOSER_MIDIDRIVER_H
 #define VIDEOCOMPOSER_MIDIDRIVER_H
 
+#include "TransportEventLog.h"
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -55,6 +56,27 @@ public:
      * @return true if supported
      */
     virtual bool isSupported() const = 0;
+
+    /**
+     * Delivery jitter of the timecode, from the driver's clock model
+     * @return RMS jitter in seconds, or -1.0 if not measured
+     */
+    virtual double getJitter() const { return -1.0; }
+
+    /**
+     * Time at which the timecode reached a frame, from the driver's clock model
+     * @return Monotonic time in microseconds, or -1 if not modelled
+     */
+    virtual int64_t getFrameTime(int64_t frame) const { (void)frame; return -1; }
+
+    /**
+     * Transport events detected while polling (see SyncSource::readTransportEvents)
+     * @return Serial of the newest event, or since if the driver posts none
+     */
+    virtual uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+        (void)events;
+        return since;
+    }
 };
 
 /**
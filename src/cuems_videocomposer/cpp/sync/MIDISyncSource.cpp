@@ -1,6 +1,8 @@
 #include "MIDISyncSource.h"
 #include "NullMIDIDriver.h"
+#include "ReplayMIDIDriver.h"
 #include "ALSASeqMIDIDriver.h"
+#include "../remote/ControlCapture.h"
 #ifdef HAVE_MTCRECEIVER
 #include "MtcReceiverMIDIDriver.h"
 #endif
@@ -12,6 +14,8 @@ MIDISyncSource::MIDISyncSource()
     : framerate_(25.0)
     , currentFrame_(-1)
     , connected_(false)
+    , capturedFrame_(-1)
+    , captureSerial_(0)
 {
     // Start with null driver (will be replaced when driver is chosen)
     driver_ = std::make_unique<NullMIDIDriver>();
@@ -32,8 +36,10 @@ bool MIDISyncSource::connect(const char* param) {
         midiPort_ = "-1"; // Default: autodetect
     }
 
-    // If no driver selected, try to get first available
-    if (!driver_ || dynamic_cast<NullMIDIDriver*>(driver_.get())) {
+    // If no driver selected, try to get first available (the replay
+    // driver is a NullMIDIDriver that was chosen)
+    if (!driver_ || (dynamic_cast<NullMIDIDriver*>(driver_.get()) &&
+                     !dynamic_cast<ReplayMIDIDriver*>(driver_.get()))) {
         driver_ = MIDIDriverFactory::createFirstAvailable();
         if (!driver_) {
             driver_ = std::make_unique<NullMIDIDriver>();
@@ -116,6 +122,20 @@ int64_t MIDISyncSource::pollFrame(uint8_t* rolling) {
         currentFrame_ = frame;
     }
 
+    // --capture-control: what the driver delivered, as it changes
+    ControlCapture& capture = ControlCapture::instance();
+    if (capture.isRecording()) {
+        if (frame != capturedFrame_) {
+            capture.recordFrame(frame);
+            capturedFrame_ = frame;
+        }
+        captureEvents_.clear();
+        captureSerial_ = driver_->readTransportEvents(captureSerial_, captureEvents_);
+        for (const TransportEvent& event : captureEvents_) {
+            capture.recordTransport(event.kind, event.frame);
+        }
+    }
+
     // Determine rolling state based on driver type
     if (rolling) {
 #ifdef HAVE_MTCRECEIVER
@@ -171,9 +191,24 @@ bool MIDISyncSource::wasFullFrameReceived() {
         return mtcDriver->wasFullFrameReceived();
     }
 #endif
+    ReplayMIDIDriver* replayDriver = dynamic_cast<ReplayMIDIDriver*>(driver_.get());
+    if (replayDriver) {
+        return replayDriver->wasFullFrameReceived();
+    }
     // Other drivers don't support full frame detection yet
     return false;
 }
 
+void MIDISyncSource::setPresentationLead(double seconds) {
+#ifdef HAVE_MTCRECEIVER
+    MtcReceiverMIDIDriver* mtcDriver = dynamic_cast<MtcReceiverMIDIDriver*>(driver_.get());
+    if (mtcDriver) {
+        mtcDriver->setLookahead(seconds);
+    }
+#else
+    (void)seconds;
+#endif
+}
+
 } // namespace videocomposer
 
@@ -7,6 +7,7 @@
 #include <string>
 #include <memory>
 #include <cstdint>
+#include <vector>
 
 namespace videocomposer {
 
@@ -78,6 +79,17 @@ public:
      */
     bool wasFullFrameReceived() override;
     
+    /**
+     * Forward the presentation lead to the driver (mtcreceiver only)
+     */
+    void setPresentationLead(double seconds) override;
+    
+    double getJitter() const override { return driver_ ? driver_->getJitter() : -1.0; }
+    int64_t getFrameTime(int64_t frame) const override { return driver_ ? driver_->getFrameTime(frame) : -1; }
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override {
+        return driver_ ? driver_->readTransportEvents(since, events) : since;
+    }
+    
 private:
     std::unique_ptr<MIDIDriver> driver_;
     MTCDecoder mtcDecoder_;
@@ -85,6 +97,11 @@ private:
     double framerate_;
     int64_t currentFrame_;
     bool connected_;
+    
+    // Control capture: last frame recorded, transport events read so far
+    int64_t capturedFrame_;
+    uint64_t captureSerial_;
+    std::vector<TransportEvent> captureEvents_;
 };
 
 } // namespace videocomposer
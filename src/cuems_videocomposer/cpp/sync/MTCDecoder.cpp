@@ -1,4 +1,6 @@
 #include "MTCDecoder.h"
+#include "../utils/SMPTEUtils.h"
+#include "../utils/FrameTracer.h"
 #include <cmath>
 
 namespace videocomposer {
@@ -42,6 +44,7 @@ bool MTCDecoder::processByte(uint8_t data) {
             // Reset for next timecode
             tc_.type = tc_.min = tc_.frame = tc_.sec = tc_.hour = tc_.tick = 0;
             fullTC_ = 0;
+            FrameTracer::instance().instant("mtc.receive", FrameTracer::nowNs(), lastTC_.frame);
             return true;
         }
     }
@@ -107,18 +110,16 @@ int64_t MTCDecoder::timecodeToFrame(double framerate) const {
     // Use lastTC_ which is set when complete timecode is received
     const auto& tc = lastTC_;
     
+    if (tc.type == 2) {
+        // 29.97 drop-frame: labels are skipped, frames are not
+        return SMPTEUtils::dropFrameToFrame(tc.frame, tc.sec, tc.min, tc.hour);
+    }
+
     // Calculate total seconds
     int64_t totalSeconds = tc.hour * 3600 + tc.min * 60 + tc.sec;
     
     // Get frames per second based on MTC type
-    double fps;
-    switch (tc.type) {
-        case 0: fps = 24.0; break;
-        case 1: fps = 25.0; break;
-        case 2: fps = 29.97; break;  // Drop-frame (29.97 fps)
-        case 3: fps = 30.0; break;
-        default: fps = framerate; break;
-    }
+    double fps = timecodeFramerate(framerate);
     
     // Convert to frame number using MTC's native FPS (like xjadeo)
     // xjadeo's default behavior (midi_clkconvert == 0): use MTC fps info directly
@@ -131,5 +132,15 @@ int64_t MTCDecoder::timecodeToFrame(double framerate) const {
     return frame;
 }
 
+double MTCDecoder::timecodeFramerate(double framerate) const {
+    switch (lastTC_.type) {
+        case 0: return 24.0;
+        case 1: return 25.0;
+        case 2: return 30000.0 / 1001.0;  // Drop-frame (29.97 fps)
+        case 3: return 30.0;
+        default: return framerate;
+    }
+}
+
 } // namespace videocomposer
 
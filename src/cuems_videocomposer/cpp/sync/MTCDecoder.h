@@ -44,6 +44,12 @@ public:
      */
     int64_t timecodeToFrame(double framerate) const;
 
+    /**
+     * Framerate of the decoded timecode type
+     * @param framerate Fallback if the type is unknown
+     */
+    double timecodeFramerate(double framerate) const;
+
     /**
      * Reset decoder state
      */
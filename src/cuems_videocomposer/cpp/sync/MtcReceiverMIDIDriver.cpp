@@ -4,6 +4,7 @@
 
 #include "MtcReceiverMIDIDriver.h"
 #include "../utils/Logger.h"
+#include "../utils/TimeUtils.h"
 #include <cmath>
 #include <algorithm>
 #include <rtmidi/RtMidi.h>
@@ -18,6 +19,11 @@ MtcReceiverMIDIDriver::MtcReceiverMIDIDriver()
     , verbose_(false)
     , clockAdjustment_(false)
     , lastFullFrameReceived_(false)
+    , lastReportedFrame_(-1)
+    , wasRunning_(false)
+    , lookahead_(0.0)
+    , lastMtcHeadMs_(-1)
+    , clockFps_(0.0)
 {
 }
 
@@ -136,9 +142,6 @@ int64_t MtcReceiverMIDIDriver::pollFrame() {
     // No incremental updates, no backwards jumps from mtcHead resets
     MtcFrame curFrame = MtcReceiver::getCurFrame();
     
-    // For detecting resync vs seek: remember last frame we reported
-    static int64_t lastReportedFrame = -1;
-    
     // Check if we have valid timecode
     // Note: mtcHeadMs == 0 can be valid for timecode 00:00:00:00
     // So we also accept full frames (explicit position commands) even if mtcHead is 0
@@ -152,14 +155,6 @@ int64_t MtcReceiverMIDIDriver::pollFrame() {
     // Check if timecode is running (for rolling state)
     bool isRunning = MtcReceiver::isTimecodeRunning.load();
     
-    // Debug: log timecode running state changes
-    static bool lastRunningState = false;
-    if (isRunning != lastRunningState) {
-        printf("MTC: isTimecodeRunning changed: %s\n", isRunning ? "true" : "false");
-        fflush(stdout);
-        lastRunningState = isRunning;
-    }
-    
     // Get frame rate from MTC type (matches xjadeo's smpte_to_frame logic)
     double fps = framerate_;
     switch (curFrame.rate) {
@@ -174,7 +169,28 @@ int64_t MtcReceiverMIDIDriver::pollFrame() {
     // This gives us sub-frame precision which is essential for smooth 60Hz playback
     // mtcHead is updated by libmtcmaster based on MTC quarter-frames + elapsed time
     double mtcSeconds = static_cast<double>(mtcHeadMs) / 1000.0;
+    if (isRunning) {
+        // mtcHead steps as quarter frames are delivered, with the MIDI link's
+        // jitter; the clock model gives a steady position for this poll.
+        // New values are timestamped when seen; the up to one poll period
+        // this adds is averaged out by the loop like delivery jitter
+        int64_t nowUs = vc_get_monotonic_time();
+        if (mtcHeadMs != lastMtcHeadMs_) {
+            clock_.addSample(mtcSeconds, nowUs);
+            lastMtcHeadMs_ = mtcHeadMs;
+        }
+        double smoothed = clock_.getPosition(nowUs);
+        if (smoothed >= 0.0) {
+            mtcSeconds = smoothed;
+        }
+        // Select the frame for when it will be on screen, not for now
+        mtcSeconds += lookahead_;
+    } else {
+        clock_.reset();
+        lastMtcHeadMs_ = -1;
+    }
     int64_t frame = static_cast<int64_t>(std::floor(mtcSeconds * fps));
+    clockFps_ = fps;
     
     // Detect if full frame is a RESYNC (periodic, position matches) vs SEEK (position jump)
     // Resync full frames are sent periodically for network reliability (rtpmidid)
@@ -183,12 +199,12 @@ int64_t MtcReceiverMIDIDriver::pollFrame() {
     if (fullFrameReceived) {
         // Check if the full frame position matches where we expect to be
         // Allow tolerance of 2 frames (accounts for MTC 8-quarter-frame delay)
-        int64_t frameDiff = std::abs(frame - lastReportedFrame);
-        if (lastReportedFrame < 0 || frameDiff > 2) {
+        int64_t frameDiff = std::abs(frame - lastReportedFrame_);
+        if (lastReportedFrame_ < 0 || frameDiff > 2) {
             // Position jump or first full frame - this is a SEEK
             isSeekFullFrame = true;
             printf("MTC: Full frame SEEK - frame=%lld (was %lld), timecode=%s\n", 
-                   (long long)frame, (long long)lastReportedFrame, curFrame.toString().c_str());
+                   (long long)frame, (long long)lastReportedFrame_, curFrame.toString().c_str());
             fflush(stdout);
             if (verbose_) {
                 LOG_INFO << "MTC: Full frame SEEK to frame " << frame 
@@ -208,7 +224,20 @@ int64_t MtcReceiverMIDIDriver::pollFrame() {
     }
     
     // Update last reported frame
-    lastReportedFrame = frame;
+    lastReportedFrame_ = frame;
+    
+    // Every reader of the transport events sees the locate (the flag below
+    // goes to whoever asks first); a stop or start is only a change of
+    // the running state, reported with the frame it happened at
+    if (isSeekFullFrame) {
+        transportEvents_.post(TransportEvent::Kind::LOCATE, frame);
+    }
+    if (isRunning != wasRunning_) {
+        printf("MTC: isTimecodeRunning changed: %s\n", isRunning ? "true" : "false");
+        fflush(stdout);
+        transportEvents_.post(isRunning ? TransportEvent::Kind::START : TransportEvent::Kind::STOP, frame);
+        wasRunning_ = isRunning;
+    }
     
     // Return frame even if not "running" - we have valid MTC data
     // The rolling state will be determined separately
@@ -228,8 +257,12 @@ int64_t MtcReceiverMIDIDriver::pollFrame() {
     }
     
     // Store the full frame flag so it can be checked by the sync source
-    // Only mark as "full frame received" if it's a SEEK, not a resync
-    lastFullFrameReceived_ = isSeekFullFrame;
+    // Only mark as "full frame received" if it's a SEEK, not a resync.
+    // It stays set until read: later polls of the same full frame are
+    // no longer a position jump and must not clear it
+    if (isSeekFullFrame) {
+        lastFullFrameReceived_ = true;
+    }
     
     return frame;
 }
@@ -249,6 +282,11 @@ void MtcReceiverMIDIDriver::setClockAdjustment(bool enable) {
     clockAdjustment_ = enable;
 }
 
+void MtcReceiverMIDIDriver::setLookahead(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lookahead_ = seconds;
+}
+
 bool MtcReceiverMIDIDriver::wasFullFrameReceived() {
     std::lock_guard<std::mutex> lock(mutex_);
     bool result = lastFullFrameReceived_;
@@ -261,5 +299,15 @@ bool MtcReceiverMIDIDriver::wasFullFrameReceived() {
     return result;
 }
 
+double MtcReceiverMIDIDriver::getJitter() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return clock_.isLocked() ? clock_.getJitter() : -1.0;
+}
+
+int64_t MtcReceiverMIDIDriver::getFrameTime(int64_t frame) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return clockFps_ > 0.0 ? clock_.getTime(frame / clockFps_) : -1;
+}
+
 } // namespace videocomposer
 
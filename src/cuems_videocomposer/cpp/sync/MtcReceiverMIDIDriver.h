@@ -9,6 +9,7 @@
 #define VIDEOCOMPOSER_MTCRECEIVER_MIDI_DRIVER_H
 
 #include "MIDIDriver.h"
+#include "TimecodeClock.h"
 #include "../../mtcreceiver/mtcreceiver.h"
 #include <memory>
 #include <mutex>
@@ -37,15 +38,36 @@ public:
     void setVerbose(bool verbose);
     void setClockAdjustment(bool enable);
     
+    /**
+     * Time added to the running timecode before it is turned into a frame
+     * (render-to-screen latency)
+     */
+    void setLookahead(double seconds);
+    
     // Check if a full frame SYSEX was just received (indicates position jump/seek needed)
     bool wasFullFrameReceived();
     
+    double getJitter() const override;
+    int64_t getFrameTime(int64_t frame) const override;
+    
+    // Locates (seek full frames) and running changes, posted by pollFrame()
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override {
+        return transportEvents_.read(since, events);
+    }
+    
 private:
     std::unique_ptr<MtcReceiver> mtcReceiver_;
     double framerate_;
     bool verbose_;
     bool clockAdjustment_;
     bool lastFullFrameReceived_;
+    int64_t lastReportedFrame_; // For telling a seek full frame from a resync
+    bool wasRunning_;
+    TransportEventLog transportEvents_;
+    double lookahead_;  // Seconds
+    TimecodeClock clock_;       // Smooths mtcHead while running
+    long int lastMtcHeadMs_;    // Last mtcHead fed to clock_
+    double clockFps_;           // Frame rate of the last polled timecode
     mutable std::mutex mutex_;
 };
 
@@ -0,0 +1,28 @@
+#include "ReplayMIDIDriver.h"
+#include "../remote/ControlCapture.h"
+#include "../utils/Logger.h"
+
+namespace videocomposer {
+
+bool ReplayMIDIDriver::open(const std::string& portId) {
+    (void)portId;
+    connected_ = ControlReplay::instance().isActive();
+    if (!connected_) {
+        LOG_WARNING << "Replay MIDI driver: no control log loaded (--replay-control)";
+    }
+    return connected_;
+}
+
+int64_t ReplayMIDIDriver::pollFrame() {
+    return connected_ ? ControlReplay::instance().getFrame() : -1;
+}
+
+uint64_t ReplayMIDIDriver::readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+    return connected_ ? ControlReplay::instance().readTransportEvents(since, events) : since;
+}
+
+bool ReplayMIDIDriver::wasFullFrameReceived() {
+    return connected_ && ControlReplay::instance().takeFullFrame();
+}
+
+} // namespace videocomposer
@@ -0,0 +1,33 @@
+#ifndef VIDEOCOMPOSER_REPLAYMIDIDRIVER_H
+#define VIDEOCOMPOSER_REPLAYMIDIDRIVER_H
+
+#include "NullMIDIDriver.h"
+
+namespace videocomposer {
+
+/**
+ * ReplayMIDIDriver - MTC from a recorded control traffic log
+ *
+ * Reports the frames and transport events ControlReplay plays back
+ * (--replay-control), as the driver of the recorded show delivered them.
+ * Connected while a replay is loaded, whatever the port.
+ */
+class ReplayMIDIDriver : public NullMIDIDriver {
+public:
+    bool open(const std::string& portId) override;
+    void close() override { connected_ = false; }
+    bool isConnected() const override { return connected_; }
+    int64_t pollFrame() override;
+    const char* getName() const override { return "Replay"; }
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override;
+
+    /** A locate was played since the last call */
+    bool wasFullFrameReceived();
+
+private:
+    bool connected_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_REPLAYMIDIDRIVER_H
@@ -1,7 +1,9 @@
 #ifndef VIDEOCOMPOSER_SYNCSOURCE_H
 #define VIDEOCOMPOSER_SYNCSOURCE_H
 
+#include "TransportEventLog.h"
 #include <cstdint>
+#include <vector>
 
 namespace videocomposer {
 
@@ -64,6 +66,41 @@ public:
      * @return true if a full frame was received since last check
      */
     virtual bool wasFullFrameReceived() { return false; }
+    
+    /**
+     * Transport events (locate, stop, start) posted after `since`, oldest
+     * first. Each reader keeps its own serial, so every reader sees every
+     * event, unlike wasFullFrameReceived() which the first caller takes.
+     * Events are detected while the source is polled.
+     * @param since Serial returned by the previous call (0 = from the start)
+     * @return Serial of the newest event, or since if the source posts none
+     */
+    virtual uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const {
+        (void)events;
+        return since;
+    }
+    
+    /**
+     * Set how far ahead of now the polled frame should be (time until the
+     * rendered frame is on screen). Only running sources that can
+     * interpolate between timecode messages apply it.
+     * @param seconds Lead time in seconds
+     */
+    virtual void setPresentationLead(double seconds) { (void)seconds; }
+    
+    /**
+     * Delivery jitter of the incoming timecode, as measured by the source's
+     * clock model (RMS, seconds)
+     * @return Jitter, or -1.0 if the source does not measure it
+     */
+    virtual double getJitter() const { return -1.0; }
+
+    /**
+     * Monotonic time at which the timecode itself (no presentation lead)
+     * reached a frame, from the source's clock model
+     * @return Time in microseconds, or -1 without a clock model
+     */
+    virtual int64_t getFrameTime(int64_t frame) const { (void)frame; return -1; }
 };
 
 } // namespace videocomposer
@@ -0,0 +1,93 @@
+#include "TimecodeClock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace videocomposer {
+
+TimecodeClock::TimecodeClock()
+    : locateThreshold_(DEFAULT_LOCATE_THRESHOLD)
+{
+    reset();
+}
+
+void TimecodeClock::reset() {
+    anchorPosition_ = 0.0;
+    anchorUs_ = 0;
+    rate_ = 1.0;
+    samples_ = 0;
+    lastOutput_ = -1.0;
+    locked_ = false;
+    located_ = false;
+    jitterSquared_ = 0.0;
+}
+
+void TimecodeClock::lock(double position, int64_t timeUs) {
+    anchorPosition_ = position;
+    anchorUs_ = timeUs;
+    rate_ = 1.0;
+    samples_ = 1;
+    lastOutput_ = -1.0;
+    locked_ = true;
+}
+
+void TimecodeClock::addSample(double position, int64_t timeUs) {
+    if (!locked_) {
+        lock(position, timeUs);
+        return;
+    }
+
+    double dt = std::max(0.0, (timeUs - anchorUs_) / 1e6);
+    double predicted = anchorPosition_ + rate_ * dt;
+    double error = position - predicted;
+
+    // Locate, or samples resumed after a dropout: follow at once
+    if (std::fabs(error) > locateThreshold_ || dt > MAX_EXTRAPOLATION) {
+        lock(position, timeUs);
+        located_ = true;
+        return;
+    }
+
+    // The second sample after a lock is the first the rate is not a guess for
+    if (samples_ > 1) {
+        jitterSquared_ += JITTER_GAIN * (error * error - jitterSquared_);
+    }
+    
+    // Average the first samples evenly, then settle into the fixed loop
+    ++samples_;
+    double phaseGain = std::max(PHASE_GAIN, 1.0 / samples_);
+    anchorPosition_ = predicted + phaseGain * error;
+    anchorUs_ = timeUs;
+    if (dt > 0.0) {
+        rate_ += RATE_GAIN * error / dt;
+        rate_ = std::clamp(rate_, 1.0 - MAX_RATE_DEVIATION, 1.0 + MAX_RATE_DEVIATION);
+    }
+}
+
+double TimecodeClock::getPosition(int64_t timeUs) {
+    if (!locked_) {
+        return -1.0;
+    }
+    double dt = std::clamp((timeUs - anchorUs_) / 1e6, 0.0, MAX_EXTRAPOLATION);
+    double position = anchorPosition_ + rate_ * dt;
+    // Phase corrections may step back slightly: hold instead
+    if (position < lastOutput_) {
+        position = lastOutput_;
+    }
+    lastOutput_ = position;
+    return position;
+}
+
+int64_t TimecodeClock::getTime(double position) const {
+    if (!locked_) {
+        return -1;
+    }
+    return anchorUs_ + static_cast<int64_t>(std::llround((position - anchorPosition_) / rate_ * 1e6));
+}
+
+bool TimecodeClock::wasLocated() {
+    bool result = located_;
+    located_ = false;
+    return result;
+}
+
+} // namespace videocomposer
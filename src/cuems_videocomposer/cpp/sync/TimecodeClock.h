@@ -0,0 +1,95 @@
+#ifndef VIDEOCOMPOSER_TIMECODECLOCK_H
+#define VIDEOCOMPOSER_TIMECODECLOCK_H
+
+#include <cmath>
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * TimecodeClock - Phase-locked model of an incoming timecode
+ *
+ * Timecode arrives in steps (MTC quarter frames, ~100 Hz) with the
+ * delivery jitter of the MIDI link. The clock tracks offset and rate from
+ * the arrival times with a second-order loop, so the position can be
+ * queried at any time and advances smoothly and never backwards. Times are
+ * in microseconds on the samples' clock (vc_get_monotonic_time for local
+ * sources, vc_get_realtime when shared between hosts). Jumps beyond the locate threshold relock
+ * immediately instead of being slewed.
+ */
+class TimecodeClock {
+public:
+    static constexpr double DEFAULT_LOCATE_THRESHOLD = 0.2;  // Seconds
+
+    TimecodeClock();
+
+    /**
+     * Add a received timecode position
+     * @param position Timecode in seconds
+     * @param timeUs Monotonic arrival time in microseconds
+     */
+    void addSample(double position, int64_t timeUs);
+
+    /**
+     * Smoothed timecode position at a monotonic time
+     * Holds at the last extrapolated value if samples stop arriving.
+     * @return Position in seconds, or -1.0 if not locked
+     */
+    double getPosition(int64_t timeUs);
+
+    /**
+     * Time at which the model reaches a position
+     * @return Time in microseconds (same clock as the samples), or -1 if not locked
+     */
+    int64_t getTime(double position) const;
+
+    /**
+     * Drop the lock (transport stopped or source changed)
+     */
+    void reset();
+
+    bool isLocked() const { return locked_; }
+
+    /**
+     * Estimated timecode rate (1.0 = real time)
+     */
+    double getRate() const { return rate_; }
+
+    /**
+     * Check if the last samples caused a relock (one-time notification)
+     */
+    bool wasLocated();
+
+    /**
+     * Delivery jitter: RMS of the samples' distance from the model, averaged
+     * over about a second (seconds, 0 until measured; relocks not counted)
+     */
+    double getJitter() const { return std::sqrt(jitterSquared_); }
+
+    void setLocateThreshold(double seconds) { locateThreshold_ = seconds; }
+
+private:
+    void lock(double position, int64_t timeUs);
+
+    double anchorPosition_;   // Loop estimate at anchorUs_
+    int64_t anchorUs_;
+    double rate_;
+    int samples_;             // Since the last lock
+    double lastOutput_;       // Keeps getPosition() monotonic
+    bool locked_;
+    bool located_;
+    double locateThreshold_;
+    double jitterSquared_;    // Averaged squared phase error
+
+    // Loop gains per sample: phase correction and rate correction. Critically
+    // damped for ~100 Hz samples; jitter is averaged over about a second
+    static constexpr double PHASE_GAIN = 0.1;
+    static constexpr double RATE_GAIN = 0.005;
+    static constexpr double MAX_RATE_DEVIATION = 0.1;  // Varispeed range
+    static constexpr double MAX_EXTRAPOLATION = 0.1;   // Seconds past the last sample
+    static constexpr double JITTER_GAIN = 0.01;        // ~100 samples
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TIMECODECLOCK_H
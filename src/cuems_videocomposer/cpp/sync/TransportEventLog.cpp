@@ -0,0 +1,38 @@
+#include "TransportEventLog.h"
+
+namespace videocomposer {
+
+TransportEventLog::TransportEventLog()
+    : serial_(0)
+{
+}
+
+uint64_t TransportEventLog::post(TransportEvent::Kind kind, int64_t frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TransportEvent event;
+    event.kind = kind;
+    event.frame = frame;
+    event.serial = ++serial_;
+    events_.push_back(event);
+    if (events_.size() > CAPACITY) {
+        events_.pop_front();
+    }
+    return event.serial;
+}
+
+uint64_t TransportEventLog::read(uint64_t since, std::vector<TransportEvent>& events) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const TransportEvent& event : events_) {
+        if (event.serial > since) {
+            events.push_back(event);
+        }
+    }
+    return serial_;
+}
+
+uint64_t TransportEventLog::getSerial() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return serial_;
+}
+
+} // namespace videocomposer
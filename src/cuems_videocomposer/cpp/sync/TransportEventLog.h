@@ -0,0 +1,58 @@
+#ifndef VIDEOCOMPOSER_TRANSPORTEVENTLOG_H
+#define VIDEOCOMPOSER_TRANSPORTEVENTLOG_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace videocomposer {
+
+/** A change of the timecode transport (see SyncSource::readTransportEvents) */
+struct TransportEvent {
+    enum class Kind {
+        LOCATE,   // Position jumped (MTC full frame, LTC relocate)
+        STOP,     // Timecode stopped running
+        START     // Timecode started running
+    };
+    Kind kind = Kind::LOCATE;
+    int64_t frame = -1;     // Source frame at the event
+    uint64_t serial = 0;    // 1 for the first event, then consecutive
+};
+
+/**
+ * TransportEventLog - Transport events of a sync source, for many readers
+ *
+ * The source posts events as it detects them; each reader keeps the
+ * serial of the last event it read and gets the newer ones, so an event
+ * reaches every reader whoever polls the source first. The newest
+ * CAPACITY events are kept; a reader further behind misses the older
+ * ones (only the last locate matters to a layer). Thread-safe.
+ */
+class TransportEventLog {
+public:
+    static constexpr size_t CAPACITY = 16;
+
+    TransportEventLog();
+
+    /** @return Serial of the posted event */
+    uint64_t post(TransportEvent::Kind kind, int64_t frame);
+
+    /**
+     * Append the events posted after `since`, oldest first
+     * @return Serial of the newest event (the reader's next `since`)
+     */
+    uint64_t read(uint64_t since, std::vector<TransportEvent>& events) const;
+
+    /** Serial of the newest event (0 = none yet) */
+    uint64_t getSerial() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<TransportEvent> events_;
+    uint64_t serial_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TRANSPORTEVENTLOG_H
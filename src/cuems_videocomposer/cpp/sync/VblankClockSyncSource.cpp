@@ -0,0 +1,142 @@
+#include "VblankClockSyncSource.h"
+#include "../utils/SMPTEUtils.h"
+#include "../utils/Logger.h"
+#include <numeric>
+
+namespace videocomposer {
+
+namespace {
+// A counter jump larger than this (display reconfigured, output switched)
+// restarts counting instead of advancing
+constexpr int64_t MAX_VBLANK_STEP = 240;
+}
+
+VblankClockSyncSource::VblankClockSyncSource(double framerate)
+    : connected_(false)
+    , rolling_(false)
+    , located_(false)
+    , framerate_(framerate > 0.0 ? framerate : 25.0)
+    , frame_(0)
+    , remainder_(0)
+    , stepNum_(0)
+    , stepDen_(1)
+    , stepRefreshHz_(0.0)
+    , lastMsc_(-1)
+    , lastTimeUs_(0)
+{
+}
+
+bool VblankClockSyncSource::connect(const char* param) {
+    (void)param;
+    connected_ = true;
+    locate(0);
+    start();
+    LOG_INFO << "Internal clock: Free-running at " << framerate_ << " fps";
+    return true;
+}
+
+void VblankClockSyncSource::disconnect() {
+    connected_ = false;
+    rolling_ = false;
+}
+
+void VblankClockSyncSource::setFramerate(double fps) {
+    if (fps <= 0.0 || fps == framerate_) {
+        return;
+    }
+    framerate_ = fps;
+    remainder_ = 0;
+    stepRefreshHz_ = 0.0;
+}
+
+void VblankClockSyncSource::updateStep(double refreshHz) {
+    int64_t fpsNum = 0, fpsDen = 1, hzNum = 0, hzDen = 1;
+    SMPTEUtils::framerateToRational(framerate_, fpsNum, fpsDen);
+    SMPTEUtils::framerateToRational(refreshHz, hzNum, hzDen);
+    if (fpsNum <= 0 || hzNum <= 0) {
+        stepNum_ = 0;
+        stepDen_ = 1;
+    } else {
+        // (fpsNum / fpsDen) / (hzNum / hzDen) frames per vblank, reduced
+        int64_t num = fpsNum * hzDen;
+        int64_t den = fpsDen * hzNum;
+        int64_t g = std::gcd(num, den);
+        stepNum_ = num / g;
+        stepDen_ = den / g;
+    }
+    remainder_ = 0;
+    stepRefreshHz_ = refreshHz;
+}
+
+void VblankClockSyncSource::advanceToVblank(int64_t msc, double refreshHz) {
+    lastTimeUs_ = 0;
+    if (refreshHz != stepRefreshHz_) {
+        updateStep(refreshHz);
+    }
+    int64_t vblanks = lastMsc_ >= 0 ? msc - lastMsc_ : 0;
+    lastMsc_ = msc;
+    if (!rolling_ || vblanks <= 0 || vblanks > MAX_VBLANK_STEP || stepNum_ <= 0) {
+        return;
+    }
+    // Missed vblanks still count, so the cadence stays on the display's grid
+    remainder_ += vblanks * stepNum_;
+    frame_ += remainder_ / stepDen_;
+    remainder_ %= stepDen_;
+}
+
+void VblankClockSyncSource::advanceToTime(int64_t nowUs) {
+    lastMsc_ = -1;
+    stepRefreshHz_ = 0.0;
+    int64_t elapsedUs = lastTimeUs_ > 0 ? nowUs - lastTimeUs_ : 0;
+    lastTimeUs_ = nowUs;
+    if (!rolling_ || elapsedUs <= 0) {
+        return;
+    }
+    // Microseconds as the vblank unit: fps / 1e6 frames per step
+    int64_t fpsNum = 0, fpsDen = 1;
+    SMPTEUtils::framerateToRational(framerate_, fpsNum, fpsDen);
+    int64_t den = fpsDen * 1000000;
+    if (stepDen_ != den) {
+        stepDen_ = den;
+        remainder_ = 0;
+    }
+    remainder_ += elapsedUs * fpsNum;
+    frame_ += remainder_ / stepDen_;
+    remainder_ %= stepDen_;
+}
+
+void VblankClockSyncSource::start() {
+    if (!rolling_) {
+        transportEvents_.post(TransportEvent::Kind::START, frame_);
+    }
+    rolling_ = true;
+}
+
+void VblankClockSyncSource::stop() {
+    if (rolling_) {
+        transportEvents_.post(TransportEvent::Kind::STOP, frame_);
+    }
+    rolling_ = false;
+}
+
+void VblankClockSyncSource::locate(int64_t frame) {
+    frame_ = frame >= 0 ? frame : 0;
+    remainder_ = 0;
+    located_ = true;
+    transportEvents_.post(TransportEvent::Kind::LOCATE, frame_);
+}
+
+int64_t VblankClockSyncSource::pollFrame(uint8_t* rolling) {
+    if (rolling) {
+        *rolling = (connected_ && rolling_) ? 1 : 0;
+    }
+    return connected_ ? frame_ : -1;
+}
+
+bool VblankClockSyncSource::wasFullFrameReceived() {
+    bool result = located_;
+    located_ = false;
+    return result;
+}
+
+} // namespace videocomposer
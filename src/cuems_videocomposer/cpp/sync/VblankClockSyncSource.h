@@ -0,0 +1,91 @@
+#ifndef VIDEOCOMPOSER_VBLANKCLOCKSYNCSOURCE_H
+#define VIDEOCOMPOSER_VBLANKCLOCKSYNCSOURCE_H
+
+#include "SyncSource.h"
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * VblankClockSyncSource - Free-running internal clock counted in vblanks
+ *
+ * Used when no MTC or LTC is present. Each vblank advances the position by
+ * exactly fps / refresh frames, kept as an integer remainder (error
+ * diffusion), so 25 fps on 50 Hz is a strict 2:2 cadence and 24 fps on
+ * 60 Hz a strict 3:2, with no drift against the display and no timers.
+ *
+ * Without a vblank counter (non-DRM backends) the position follows the
+ * monotonic clock instead.
+ */
+class VblankClockSyncSource : public SyncSource {
+public:
+    explicit VblankClockSyncSource(double framerate = 25.0);
+
+    /**
+     * Advance to the vblank the next render is shown on
+     * @param msc Display vblank counter
+     * @param refreshHz Display refresh rate
+     */
+    void advanceToVblank(int64_t msc, double refreshHz);
+
+    /**
+     * Advance by elapsed time, for displays without a vblank counter
+     * @param nowUs Monotonic time in microseconds
+     */
+    void advanceToTime(int64_t nowUs);
+
+    // Transport
+    void start();
+    void stop();
+    void locate(int64_t frame);
+    bool isRolling() const { return rolling_; }
+
+    void setFramerate(double fps);
+
+    // SyncSource interface
+    /**
+     * @param param Unused; the clock starts rolling from frame 0
+     */
+    bool connect(const char* param = nullptr) override;
+    void disconnect() override;
+    bool isConnected() const override { return connected_; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override;
+    int64_t getCurrentFrame() const override { return frame_; }
+    const char* getName() const override { return "Internal"; }
+    double getFramerate() const override { return framerate_; }
+
+    /**
+     * A locate was made since the last check
+     */
+    bool wasFullFrameReceived() override;
+
+    /**
+     * start(), stop() and locate() calls
+     */
+    uint64_t readTransportEvents(uint64_t since, std::vector<TransportEvent>& events) const override {
+        return transportEvents_.read(since, events);
+    }
+
+private:
+    void updateStep(double refreshHz);
+
+    bool connected_;
+    bool rolling_;
+    bool located_;
+    TransportEventLog transportEvents_;
+    double framerate_;
+
+    // position = frame_ + remainder_ / stepDen_ frames
+    int64_t frame_;
+    int64_t remainder_;
+    int64_t stepNum_;             // Per vblank: stepNum_ / stepDen_ frames
+    int64_t stepDen_;
+    double stepRefreshHz_;        // Refresh the step was computed for (0 = none)
+
+    int64_t lastMsc_;             // -1 = not counting vblanks
+    int64_t lastTimeUs_;          // 0 = not counting time
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_VBLANKCLOCKSYNCSOURCE_H
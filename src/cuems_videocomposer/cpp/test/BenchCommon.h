@@ -0,0 +1,180 @@
+#ifndef VIDEOCOMPOSER_BENCHCOMMON_H
+#define VIDEOCOMPOSER_BENCHCOMMON_H
+
+#include "input/InputSource.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace videocomposer {
+namespace bench {
+
+/**
+ * Helpers shared by the benchmark executables (timing, corpus, JSON output)
+ */
+
+inline double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Process CPU time, every thread
+inline double cpuSeconds() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+inline size_t residentBytes() {
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+    unsigned long pages = 0, resident = 0;
+    int fields = std::fscanf(file, "%lu %lu", &pages, &resident);
+    std::fclose(file);
+    return fields == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+// Nearest-rank percentile (fraction 0..1); 0 for no samples
+inline double percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+    return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+}
+
+inline std::string jsonString(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+inline bool isHap(InputSource::CodecType codec) {
+    return codec == InputSource::CodecType::HAP || codec == InputSource::CodecType::HAP_Q ||
+           codec == InputSource::CodecType::HAP_ALPHA;
+}
+
+inline const char* codecName(InputSource::CodecType codec) {
+    switch (codec) {
+        case InputSource::CodecType::HAP:       return "HAP";
+        case InputSource::CodecType::HAP_Q:     return "HAP_Q";
+        case InputSource::CodecType::HAP_ALPHA: return "HAP_ALPHA";
+        case InputSource::CodecType::H264:      return "H264";
+        case InputSource::CodecType::HEVC:      return "HEVC";
+        case InputSource::CodecType::AV1:       return "AV1";
+        case InputSource::CodecType::SOFTWARE:  return "SOFTWARE";
+    }
+    return "UNKNOWN";
+}
+
+// Written by bench_media next to the clips it generates
+constexpr const char* MANIFEST_NAME = "manifest.jsonl";
+
+// String value of "key" in a one-line JSON object; empty if absent
+inline std::string jsonStringField(const std::string& line, const char* key) {
+    std::string marker = "\"" + std::string(key) + "\":\"";
+    size_t pos = line.find(marker);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    std::string value;
+    for (pos += marker.size(); pos < line.size() && line[pos] != '"'; ++pos) {
+        if (line[pos] == '\\' && pos + 1 < line.size()) {
+            ++pos;
+        }
+        value += line[pos];
+    }
+    return value;
+}
+
+// Manifest: the "file" of every line, relative to the manifest
+inline bool isManifest(const std::string& path) {
+    return path.size() >= 6 && path.compare(path.size() - 6, 6, ".jsonl") == 0;
+}
+
+inline void addManifest(const char* program, const std::string& path, std::vector<std::string>& files) {
+    std::ifstream manifest(path);
+    if (!manifest) {
+        std::cerr << program << ": " << path << ": " << std::strerror(errno) << "\n";
+        return;
+    }
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::string file = jsonStringField(line, "file");
+        if (!file.empty()) {
+            files.push_back(file[0] == '/' ? file : directory + file);
+        }
+    }
+}
+
+// Corpus: files as given, manifests, directories one level deep (sorted; a
+// directory with a manifest is its manifest)
+inline void addCorpus(const char* program, const std::string& path, std::vector<std::string>& files) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        std::cerr << program << ": " << path << ": " << std::strerror(errno) << "\n";
+        return;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        if (isManifest(path)) {
+            addManifest(program, path, files);
+        } else {
+            files.push_back(path);
+        }
+        return;
+    }
+    std::string manifest = path + "/" + MANIFEST_NAME;
+    if (stat(manifest.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+        addManifest(program, manifest, files);
+        return;
+    }
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return;
+    }
+    std::vector<std::string> entries;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        std::string full = path + "/" + name;
+        if (name[0] != '.' && stat(full.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            entries.push_back(full);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    files.insert(files.end(), entries.begin(), entries.end());
+}
+
+} // namespace bench
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_BENCHCOMMON_H
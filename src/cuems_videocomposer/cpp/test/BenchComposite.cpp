@@ -0,0 +1,700 @@
+/**
+ * BenchComposite.cpp - Compositor stress benchmark (cuems_videocomposer_bench_composite)
+ *
+ * Builds synthetic scenes - N layers x source resolution x blend mode x
+ * corner deform x color adjust x output count (with edge blend and warp) -
+ * and renders them offscreen through MultiOutputRenderer on a headless EGL
+ * context, either as fast as possible or paced at a refresh rate. Prints
+ * one JSON object per scene on stdout (JSON Lines, logging on stderr):
+ *
+ *   {"layers":8,"resolution":"1920x1080","blend":"screen","deform":true,
+ *    "color":true,"outputs":2,"edge_blend":200,"warp":true,"warp_grid":0,
+ *    "animated":false,"canvas":false,"paced_hz":0,"frames":300,"fps":212.4,
+ *    "frame_ms":{"p50":4.6,"p99":5.3,"max":7.0},"cpu_ms":1.2,
+ *    "gpu_ms":{"avg":4.1,"max":5.0}}
+ *
+ * frame_ms is a whole frame (layer update, composite, output blits and
+ * glFinish; a single plain output is composited into directly unless
+ * --canvas); cpu_ms is process CPU time per frame; gpu_ms is the GPU
+ * timer's "frame" section over its last GpuTimingStats::WINDOW frames
+ * (-1 where timer queries are missing). With --find-max, each scene's
+ * layer count is searched for the largest that keeps frame_ms p99 within
+ * --budget-ms and reported as "max_layers": the capacity figure of the
+ * machine for that kind of scene.
+ *
+ * Layers are full-canvas at --opacity (0.5 by default, so none is culled as
+ * occluded). Static layers upload their image once; --animated layers
+ * alternate between two frames, so every frame uploads every layer.
+ */
+
+#include "BenchCommon.h"
+#include "display/MultiOutputRenderer.h"
+#include "display/OpenGLRenderer.h"
+#include "display/GpuTimingStats.h"
+#include "display/GridWarpMesh.h"
+#include "layer/LayerManager.h"
+#include "layer/VideoLayer.h"
+#include "input/InputSource.h"
+#include "sync/SyncSource.h"
+#include "video/FrameBuffer.h"
+#include "utils/Logger.h"
+#include "display/DisplayBackend.h"
+#ifdef HAVE_DRM_BACKEND
+#include "display/HeadlessDisplay.h"
+#endif
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::bench;
+
+namespace {
+
+struct Resolution {
+    int width;
+    int height;
+};
+
+struct Scene {
+    int layers = 1;
+    Resolution resolution{1920, 1080};
+    LayerProperties::BlendMode blend = LayerProperties::NORMAL;
+    bool deform = false;
+    bool color = false;
+    int outputs = 1;
+};
+
+struct Options {
+    std::vector<int> layers{1, 4, 16};
+    std::vector<Resolution> resolutions{{1920, 1080}};
+    std::vector<LayerProperties::BlendMode> blends{LayerProperties::NORMAL};
+    std::vector<bool> deforms{false};
+    std::vector<bool> colors{false};
+    std::vector<int> outputs{1};
+    Resolution outputSize{1920, 1080};
+    int edgeBlend = 0;          // Overlap between neighbouring outputs (pixels)
+    bool warp = false;
+    int warpGrid = 0;           // Warp as a mesh from an N x N grid, 0 = displacement texture
+    bool animated = false;
+    bool canvas = false;        // Keep the canvas and blit for a single output
+    float opacity = 0.5f;
+    double pacedHz = 0.0;       // 0 = as fast as possible
+    int frames = 300;
+    int warmup = 30;
+    bool findMax = false;
+    double budgetMs = 1000.0 / 60.0;
+    int maxLayers = 128;
+    bool verbose = false;
+};
+
+struct Measurement {
+    int frames = 0;
+    double seconds = 0.0;
+    std::vector<double> frameMs;
+    double cpuMs = 0.0;
+    double gpuAverageMs = -1.0;
+    double gpuMaxMs = -1.0;
+};
+
+const char* blendName(LayerProperties::BlendMode blend) {
+    switch (blend) {
+        case LayerProperties::NORMAL:   return "normal";
+        case LayerProperties::MULTIPLY: return "multiply";
+        case LayerProperties::SCREEN:   return "screen";
+        case LayerProperties::OVERLAY:  return "overlay";
+    }
+    return "normal";
+}
+
+#if defined(HAVE_DRM_BACKEND) && defined(HAVE_EGL)
+
+/**
+ * Synthetic BGRA gradient; animated sources alternate between two images
+ */
+class PatternInput : public InputSource {
+public:
+    PatternInput(int width, int height, bool animated) : animated_(animated) {
+        info_.width = width;
+        info_.height = height;
+        info_.framerate = 60.0;
+        info_.totalFrames = 0;
+        info_.format = PixelFormat::BGRA32;
+        for (int i = 0; i < (animated ? 2 : 1); ++i) {
+            auto frame = std::make_shared<FrameBuffer>();
+            frame->allocate(info_);
+            uint8_t* pixels = frame->data();
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    uint8_t* p = pixels + (static_cast<size_t>(y) * width + x) * 4;
+                    p[0] = static_cast<uint8_t>(x * 255 / std::max(width - 1, 1));
+                    p[1] = static_cast<uint8_t>(y * 255 / std::max(height - 1, 1));
+                    p[2] = static_cast<uint8_t>(i ? 255 - p[0] : p[1] / 2);
+                    p[3] = 255;
+                }
+            }
+            frames_.push_back(std::move(frame));
+        }
+    }
+
+    bool open(const std::string& source) override { (void)source; return true; }
+    void close() override {}
+    bool isReady() const override { return true; }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override {
+        const std::shared_ptr<FrameBuffer>& frame = frames_[static_cast<size_t>(frameNumber) % frames_.size()];
+        return buffer.wrap(frame->data(), frame->size(), frame->info(), frame);
+    }
+    bool seek(int64_t frameNumber) override { (void)frameNumber; return true; }
+    FrameInfo getFrameInfo() const override { return info_; }
+    int64_t getCurrentFrame() const override { return 0; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+    bool hasInstantSeek() const override { return true; }
+    bool isStatic() const override { return !animated_; }
+
+private:
+    FrameInfo info_;
+    bool animated_;
+    std::vector<std::shared_ptr<FrameBuffer>> frames_;
+};
+
+/**
+ * Sync source that moves one frame per rendered frame
+ */
+class BenchClock : public SyncSource {
+public:
+    explicit BenchClock(const int64_t& frame) : frame_(frame) {}
+    bool connect(const char* param = nullptr) override { (void)param; return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        if (rolling) {
+            *rolling = 1;
+        }
+        return frame_;
+    }
+    int64_t getCurrentFrame() const override { return frame_; }
+    const char* getName() const override { return "Bench"; }
+
+private:
+    const int64_t& frame_;
+};
+
+/**
+ * Gentle barrel displacement, as a projector warp would sample
+ */
+class BenchWarpMesh : public WarpMesh {
+public:
+    static constexpr int SIZE = 64;
+
+    BenchWarpMesh() {
+        std::vector<uint8_t> texels(SIZE * SIZE * 2);
+        for (int y = 0; y < SIZE; ++y) {
+            for (int x = 0; x < SIZE; ++x) {
+                float u = x / float(SIZE - 1) * 2.0f - 1.0f;
+                float v = y / float(SIZE - 1) * 2.0f - 1.0f;
+                float r2 = u * u + v * v;
+                texels[(y * SIZE + x) * 2 + 0] = static_cast<uint8_t>(127.5f + 40.0f * u * r2 * 0.5f);
+                texels[(y * SIZE + x) * 2 + 1] = static_cast<uint8_t>(127.5f + 40.0f * v * r2 * 0.5f);
+            }
+        }
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, SIZE, SIZE, 0, GL_RG, GL_UNSIGNED_BYTE, texels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    ~BenchWarpMesh() override {
+        glDeleteTextures(1, &texture_);
+    }
+
+    unsigned int getTexture() const override { return texture_; }
+    bool isValid() const override { return texture_ != 0; }
+    void getDimensions(int& width, int& height) const override {
+        width = SIZE;
+        height = SIZE;
+    }
+
+private:
+    GLuint texture_ = 0;
+};
+
+/**
+ * The same barrel as a calibration grid, drawn as a mesh
+ */
+std::shared_ptr<GridWarpMesh> makeBarrelGrid(int size) {
+    std::vector<float> points;
+    points.reserve(static_cast<size_t>(size) * size * 2);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            float s = x / float(size - 1), t = y / float(size - 1);
+            float u = s * 2.0f - 1.0f, v = t * 2.0f - 1.0f;
+            float r2 = u * u + v * v;
+            // Displacement texel 127.5 + 20 * r2 * u, times 2 - 1, times 0.1
+            points.push_back(std::min(std::max(s + 0.1f * 40.0f / 255.0f * u * r2, 0.0f), 1.0f));
+            points.push_back(std::min(std::max(t + 0.1f * 40.0f / 255.0f * v * r2, 0.0f), 1.0f));
+        }
+    }
+    auto mesh = std::make_shared<GridWarpMesh>();
+    mesh->setGrid(size, size, points);
+    return mesh;
+}
+
+/**
+ * Output rendered into an FBO of its own instead of a display
+ */
+class OffscreenSurface : public OutputSurface {
+public:
+    OffscreenSurface(DisplayBackend* display, int index, int width, int height) : display_(display) {
+        info_.name = "BENCH-" + std::to_string(index + 1);
+        info_.width = width;
+        info_.height = height;
+        info_.refreshRate = 60.0;
+        info_.connected = true;
+        info_.enabled = true;
+        info_.index = index;
+
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenFramebuffers(1, &fbo_);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~OffscreenSurface() override {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &texture_);
+    }
+
+    void makeCurrent() override {
+        display_->makeCurrent();
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    }
+    void releaseCurrent() override { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+    void swapBuffers() override {}
+    uint32_t getWidth() const override { return static_cast<uint32_t>(info_.width); }
+    uint32_t getHeight() const override { return static_cast<uint32_t>(info_.height); }
+    const OutputInfo& getOutputInfo() const override { return info_; }
+
+private:
+    DisplayBackend* display_;
+    OutputInfo info_;
+    GLuint texture_ = 0;
+    GLuint fbo_ = 0;
+};
+
+/**
+ * One scene: its layers, outputs and renderer, rendered frame by frame
+ */
+class SceneRun {
+public:
+    SceneRun(HeadlessDisplay& display, const Options& options, const Scene& scene)
+        : display_(display), options_(options), scene_(scene) {}
+
+    bool setUp() {
+        if (!renderer_.init(display_.getEGLDisplay(), static_cast<EGLContext>(display_.getContext()))) {
+            return false;
+        }
+        renderer_.setDamageTracking(false);  // Composite every frame
+        renderer_.setOutputFastPath(!options_.canvas);
+
+        // Outputs side by side, overlapping by the edge blend width
+        std::vector<OutputRegion> regions;
+        std::vector<OutputSurface*> surfaces;
+        int step = options_.outputSize.width - options_.edgeBlend;
+        for (int i = 0; i < scene_.outputs; ++i) {
+            OutputRegion region;
+            region.name = "BENCH-" + std::to_string(i + 1);
+            region.canvasX = i * step;
+            region.canvasY = 0;
+            region.canvasWidth = options_.outputSize.width;
+            region.canvasHeight = options_.outputSize.height;
+            region.physicalWidth = options_.outputSize.width;
+            region.physicalHeight = options_.outputSize.height;
+            if (options_.edgeBlend > 0) {
+                region.blend.left = i > 0 ? static_cast<float>(options_.edgeBlend) : 0.0f;
+                region.blend.right = i + 1 < scene_.outputs ? static_cast<float>(options_.edgeBlend) : 0.0f;
+            }
+            if (options_.warp && options_.warpGrid >= 2) {
+                region.warpMesh = makeBarrelGrid(options_.warpGrid);
+            } else if (options_.warp) {
+                region.warpMesh = std::make_shared<BenchWarpMesh>();
+            }
+            surfaces_.push_back(std::make_unique<OffscreenSurface>(&display_, i,
+                                options_.outputSize.width, options_.outputSize.height));
+            surfaces.push_back(surfaces_.back().get());
+            regions.push_back(std::move(region));
+        }
+        renderer_.configureOutputs(regions, surfaces);
+
+        for (int i = 0; i < scene_.layers; ++i) {
+            auto layer = std::make_unique<VideoLayer>();
+            layer->setInputSource(std::make_unique<PatternInput>(scene_.resolution.width, scene_.resolution.height,
+                                                                 options_.animated));
+            layer->setSyncSource(std::make_unique<BenchClock>(frame_));
+            int layerId = layers_->addLayer(std::move(layer));
+            VideoLayer* added = layers_->getLayer(layerId);
+            if (!added) {
+                return false;
+            }
+            LayerProperties& props = added->properties();
+            props.width = scene_.resolution.width;
+            props.height = scene_.resolution.height;
+            props.zOrder = i;
+            props.opacity = options_.opacity;
+            props.blendMode = scene_.blend;
+            if (scene_.deform) {
+                static const float KEYSTONE[8] = {0.08f, 0.05f, -0.06f, 0.04f, -0.03f, -0.05f, 0.05f, -0.02f};
+                std::copy(std::begin(KEYSTONE), std::end(KEYSTONE), props.cornerDeform.corners);
+                props.cornerDeform.enabled = true;
+            }
+            if (scene_.color) {
+                props.colorAdjust.brightness = 0.05f;
+                props.colorAdjust.contrast = 1.1f;
+                props.colorAdjust.saturation = 0.9f;
+            }
+        }
+        return true;
+    }
+
+    ~SceneRun() {
+        display_.makeCurrent();
+        layers_.reset();    // Layer resources first, while the renderer is alive
+        renderer_.cleanup();
+    }
+
+    Measurement run() {
+        Measurement result;
+        result.frameMs.reserve(static_cast<size_t>(options_.frames));
+        OpenGLRenderer* renderer = renderer_.getRenderer();
+        double cpuStart = 0.0;
+        double wallStart = 0.0;
+        double nextFrame = nowSeconds();
+
+        for (int i = 0; i < options_.warmup + options_.frames; ++i) {
+            if (i == options_.warmup) {
+                cpuStart = cpuSeconds();
+                wallStart = nowSeconds();
+                if (renderer) {
+                    renderer->gpuTimer().stats().reset();
+                }
+            }
+            double start = nowSeconds();
+            ++frame_;
+            display_.makeCurrent();
+            layers_->updateAll();
+            renderer_.render(layers_.get());
+            glFinish();
+            if (i >= options_.warmup) {
+                result.frameMs.push_back((nowSeconds() - start) * 1000.0);
+            }
+            if (options_.pacedHz > 0.0) {
+                nextFrame += 1.0 / options_.pacedHz;
+                std::this_thread::sleep_for(std::chrono::duration<double>(std::max(nextFrame - nowSeconds(), 0.0)));
+            }
+        }
+
+        result.frames = options_.frames;
+        result.seconds = nowSeconds() - wallStart;
+        result.cpuMs = (cpuSeconds() - cpuStart) * 1000.0 / options_.frames;
+        GpuTimingStats::Summary gpu;
+        if (renderer && renderer->gpuTimer().isActive() && renderer->gpuTimer().stats().getSummary("frame", -1, gpu)) {
+            result.gpuAverageMs = gpu.averageMs;
+            result.gpuMaxMs = gpu.maxMs;
+        }
+        return result;
+    }
+
+private:
+    HeadlessDisplay& display_;
+    const Options& options_;
+    Scene scene_;
+    int64_t frame_ = 0;
+    std::vector<std::unique_ptr<OffscreenSurface>> surfaces_;
+    MultiOutputRenderer renderer_;
+    std::unique_ptr<LayerManager> layers_ = std::make_unique<LayerManager>();
+};
+
+bool measureScene(HeadlessDisplay& display, const Options& options, const Scene& scene, Measurement& result) {
+    SceneRun run(display, options, scene);
+    if (!run.setUp()) {
+        return false;
+    }
+    result = run.run();
+    return true;
+}
+
+void printScene(const Options& options, const Scene& scene, const Measurement* result, int maxLayers) {
+    std::ostringstream out;
+    out << "{\"layers\":" << scene.layers
+        << ",\"resolution\":\"" << scene.resolution.width << "x" << scene.resolution.height << "\""
+        << ",\"blend\":\"" << blendName(scene.blend) << "\""
+        << ",\"deform\":" << (scene.deform ? "true" : "false")
+        << ",\"color\":" << (scene.color ? "true" : "false")
+        << ",\"outputs\":" << scene.outputs
+        << ",\"edge_blend\":" << options.edgeBlend
+        << ",\"warp\":" << (options.warp ? "true" : "false")
+        << ",\"warp_grid\":" << (options.warp ? options.warpGrid : 0)
+        << ",\"animated\":" << (options.animated ? "true" : "false")
+        << ",\"canvas\":" << (options.canvas ? "true" : "false")
+        << ",\"paced_hz\":" << options.pacedHz;
+    if (!result) {
+        out << ",\"status\":\"error\"}";
+        std::cout << out.str() << std::endl;
+        return;
+    }
+    out << ",\"status\":\"ok\""
+        << ",\"frames\":" << result->frames
+        << ",\"fps\":" << (result->seconds > 0.0 ? result->frames / result->seconds : 0.0)
+        << ",\"frame_ms\":{\"p50\":" << percentile(result->frameMs, 0.50)
+        << ",\"p99\":" << percentile(result->frameMs, 0.99)
+        << ",\"max\":" << percentile(result->frameMs, 1.0) << "}"
+        << ",\"cpu_ms\":" << result->cpuMs
+        << ",\"gpu_ms\":{\"avg\":" << result->gpuAverageMs << ",\"max\":" << result->gpuMaxMs << "}";
+    if (maxLayers >= 0) {
+        out << ",\"budget_ms\":" << options.budgetMs << ",\"max_layers\":" << maxLayers;
+    }
+    out << "}";
+    std::cout << out.str() << std::endl;
+}
+
+/**
+ * Largest layer count of this scene within budget: doubling, then bisection
+ * @return Layer count (0 = not even one layer), printed with the measurement at it
+ */
+int findMaxLayers(HeadlessDisplay& display, const Options& options, Scene scene, Measurement& atMax) {
+    auto fits = [&](int layers, Measurement& result) {
+        scene.layers = layers;
+        return measureScene(display, options, scene, result) &&
+               percentile(result.frameMs, 0.99) <= options.budgetMs;
+    };
+    int good = 0;
+    int bad = -1;
+    for (int layers = 1; layers <= options.maxLayers; layers *= 2) {
+        Measurement result;
+        if (!fits(layers, result)) {
+            bad = layers;
+            break;
+        }
+        good = layers;
+        atMax = std::move(result);
+    }
+    if (bad < 0) {
+        bad = options.maxLayers + 1;
+    }
+    while (bad - good > 1) {
+        int middle = good + (bad - good) / 2;
+        Measurement result;
+        if (fits(middle, result)) {
+            good = middle;
+            atMax = std::move(result);
+        } else {
+            bad = middle;
+        }
+    }
+    return good;
+}
+
+#endif // HAVE_DRM_BACKEND && HAVE_EGL
+
+template <typename T, typename Parse>
+bool parseList(const std::string& text, std::vector<T>& values, Parse parse) {
+    values.clear();
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        T value;
+        if (!parse(item, value)) {
+            std::cerr << "bench_composite: invalid value " << item << "\n";
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+bool parseResolution(const std::string& text, Resolution& resolution) {
+    return std::sscanf(text.c_str(), "%dx%d", &resolution.width, &resolution.height) == 2 &&
+           resolution.width > 0 && resolution.height > 0;
+}
+
+bool parseInt(const std::string& text, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    value = static_cast<int>(parsed);
+    return end && *end == '\0' && parsed >= 0;
+}
+
+bool parseBool(const std::string& text, bool& value) {
+    value = text == "1" || text == "on" || text == "true";
+    return value || text == "0" || text == "off" || text == "false";
+}
+
+bool parseBlend(const std::string& text, LayerProperties::BlendMode& blend) {
+    for (LayerProperties::BlendMode mode : {LayerProperties::NORMAL, LayerProperties::MULTIPLY,
+                                            LayerProperties::SCREEN, LayerProperties::OVERLAY}) {
+        if (text == blendName(mode)) {
+            blend = mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "Scene dimensions (comma-separated lists, every combination is run):\n"
+              << "  --layers LIST       Layer counts (default 1,4,16)\n"
+              << "  --resolution LIST   Layer source sizes, WxH (default 1920x1080)\n"
+              << "  --blend LIST        normal, multiply, screen, overlay (default normal)\n"
+              << "  --deform LIST       Corner deform off/on: 0,1 (default 0)\n"
+              << "  --color LIST        Color adjust off/on: 0,1 (default 0)\n"
+              << "  --outputs LIST      Output counts (default 1)\n"
+              << "Outputs and pacing:\n"
+              << "  --output-size WxH   Size of each output (default 1920x1080)\n"
+              << "  --edge-blend PX     Overlap between neighbouring outputs (default 0)\n"
+              << "  --warp              Warp every output\n"
+              << "  --warp-grid N       Warp as a mesh from an N x N grid (default: texture)\n"
+              << "  --animated          Upload every layer every frame\n"
+              << "  --canvas            Single output through the canvas and blit (no fast path)\n"
+              << "  --opacity F         Layer opacity (default 0.5)\n"
+              << "  --paced HZ          Render at HZ instead of as fast as possible\n"
+              << "  --frames N          Frames measured per scene (default 300)\n"
+              << "  --warmup N          Frames rendered first and not measured (default 30)\n"
+              << "Capacity:\n"
+              << "  --find-max          Search each scene's largest layer count within budget\n"
+              << "                      (ignores --layers)\n"
+              << "  --budget-ms MS      Frame time p99 budget (default 16.67)\n"
+              << "  --max-layers N      Upper bound of the search (default 128)\n"
+              << "  --verbose           Log renderer messages (stderr)\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--layers" && hasValue) {
+            if (!parseList(argv[++i], options.layers, parseInt)) return false;
+        } else if (arg == "--resolution" && hasValue) {
+            if (!parseList(argv[++i], options.resolutions, parseResolution)) return false;
+        } else if (arg == "--blend" && hasValue) {
+            if (!parseList(argv[++i], options.blends, parseBlend)) return false;
+        } else if (arg == "--deform" && hasValue) {
+            if (!parseList(argv[++i], options.deforms, parseBool)) return false;
+        } else if (arg == "--color" && hasValue) {
+            if (!parseList(argv[++i], options.colors, parseBool)) return false;
+        } else if (arg == "--outputs" && hasValue) {
+            if (!parseList(argv[++i], options.outputs, parseInt)) return false;
+        } else if (arg == "--output-size" && hasValue) {
+            if (!parseResolution(argv[++i], options.outputSize)) return false;
+        } else if (arg == "--edge-blend" && hasValue) {
+            if (!parseInt(argv[++i], options.edgeBlend)) return false;
+        } else if (arg == "--warp") {
+            options.warp = true;
+        } else if (arg == "--warp-grid" && hasValue) {
+            if (!parseInt(argv[++i], options.warpGrid)) return false;
+            options.warp = true;
+        } else if (arg == "--animated") {
+            options.animated = true;
+        } else if (arg == "--canvas") {
+            options.canvas = true;
+        } else if (arg == "--opacity" && hasValue) {
+            options.opacity = std::clamp(static_cast<float>(std::atof(argv[++i])), 0.0f, 1.0f);
+        } else if (arg == "--paced" && hasValue) {
+            options.pacedHz = std::max(std::atof(argv[++i]), 0.0);
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmup = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "--find-max") {
+            options.findMax = true;
+        } else if (arg == "--budget-ms" && hasValue) {
+            options.budgetMs = std::atof(argv[++i]);
+        } else if (arg == "--max-layers" && hasValue) {
+            options.maxLayers = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    if (options.edgeBlend >= options.outputSize.width) {
+        std::cerr << "bench_composite: edge blend must be narrower than an output\n";
+        return false;
+    }
+    return std::none_of(options.outputs.begin(), options.outputs.end(), [](int n) { return n < 1; });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // INFO goes to stdout, which carries the results
+    Logger::getInstance().setLevel(options.verbose ? Logger::INFO : Logger::WARNING);
+
+#if defined(HAVE_DRM_BACKEND) && defined(HAVE_EGL)
+    HeadlessDisplay display;
+    display.setDimensions(options.outputSize.width, options.outputSize.height);
+    if (!display.openWindow()) {
+        std::cerr << "bench_composite: no headless GL context (render node, EGL)\n";
+        return 1;
+    }
+    display.makeCurrent();
+
+    std::vector<int> layerCounts = options.findMax ? std::vector<int>{0} : options.layers;
+    int failures = 0;
+    for (const Resolution& resolution : options.resolutions)
+    for (LayerProperties::BlendMode blend : options.blends)
+    for (bool deform : options.deforms)
+    for (bool color : options.colors)
+    for (int outputs : options.outputs)
+    for (int layers : layerCounts) {
+        Scene scene;
+        scene.layers = layers;
+        scene.resolution = resolution;
+        scene.blend = blend;
+        scene.deform = deform;
+        scene.color = color;
+        scene.outputs = outputs;
+        Measurement result;
+        if (options.findMax) {
+            int maxLayers = findMaxLayers(display, options, scene, result);
+            scene.layers = maxLayers;
+            printScene(options, scene, maxLayers > 0 ? &result : nullptr, maxLayers);
+        } else if (measureScene(display, options, scene, result)) {
+            printScene(options, scene, &result, -1);
+        } else {
+            printScene(options, scene, nullptr, -1);
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 2;
+#else
+    std::cerr << "bench_composite: built without the headless display (HAVE_DRM_BACKEND, HAVE_EGL)\n";
+    return 1;
+#endif
+}
@@ -0,0 +1,365 @@
+/**
+ * BenchDecode.cpp - Decode throughput benchmark (cuems_videocomposer_bench_decode)
+ *
+ * Decodes every file of a media corpus headless with each backend that
+ * applies to it and prints one JSON object per file and backend (JSON
+ * Lines on stdout, logging on stderr), for qualifying hardware and drivers:
+ *
+ *   {"file":"a.mov","codec":"H264","width":1920,"height":1080,"framerate":25,
+ *    "backend":"vaapi-zerocopy","status":"ok","frames":600,"fps":412.3,
+ *    "latency_ms":{"p50":2.1,"p99":4.8,"max":9.7},"cpu_percent":38.5,
+ *    "rss_mb":310.2,"vram_mb":96.0}
+ *
+ * Backends:
+ *   software        VideoFileInput, FFmpeg software decode to CPU frames
+ *   vaapi-zerocopy  VideoFileInput + AsyncDecodeQueue, VA surfaces imported as textures
+ *   vaapi-readback  VideoFileInput + AsyncDecodeQueue, VA surfaces copied to CPU frames
+ *   hap-direct      HAPVideoInput, HAP SDK decode to compressed textures
+ *   hap-ffmpeg      HAPVideoInput, FFmpeg RGBA fallback
+ *
+ * Latency is the time one frame read took, GPU work included (glFinish);
+ * for the decode-ahead backends it is the wait on the queue. CPU is the
+ * whole process (decode threads included) against wall time. A backend
+ * that cannot run here (no device, built without it) reports status
+ * "unavailable", so runs from different machines line up.
+ */
+
+#include "BenchCommon.h"
+#include "input/VideoFileInput.h"
+#include "input/HAPVideoInput.h"
+#include "display/DisplayBackend.h"
+#include "display/OpenGLRenderer.h"
+#include "video/FrameBuffer.h"
+#include "video/GPUTextureFrameBuffer.h"
+#include "utils/Logger.h"
+#ifdef HAVE_DRM_BACKEND
+#include "display/HeadlessDisplay.h"
+#endif
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::bench;
+
+namespace {
+
+const char* const ALL_BACKENDS[] = {
+    "software", "vaapi-zerocopy", "vaapi-readback", "hap-direct", "hap-ffmpeg"
+};
+
+struct Options {
+    std::vector<std::string> backends;
+    std::vector<std::string> files;
+    int64_t frames = 600;
+    int64_t warmup = 30;
+    bool verbose = false;
+};
+
+struct Result {
+    std::string status = "ok";
+    std::string error;
+    int64_t frames = 0;
+    double seconds = 0.0;
+    std::vector<double> latencies;   // ms, one per measured frame
+    double cpuSeconds = 0.0;
+    size_t residentBytes = 0;
+    int64_t vramBytes = -1;
+};
+
+/**
+ * Context for GPU backends: one headless EGL context for the whole run
+ */
+class GpuContext {
+public:
+    bool open() {
+#ifdef HAVE_DRM_BACKEND
+        if (display_) {
+            return true;
+        }
+        auto display = std::make_unique<HeadlessDisplay>();
+        display->setDimensions(1920, 1080);
+        if (!display->openWindow()) {
+            return false;
+        }
+        display_ = std::move(display);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    DisplayBackend* display() {
+#ifdef HAVE_DRM_BACKEND
+        return display_.get();
+#else
+        return nullptr;
+#endif
+    }
+
+    int64_t videoMemoryUsed() {
+        OpenGLRenderer* renderer = display() ? display()->getRenderer() : nullptr;
+        return renderer ? renderer->getVideoMemoryUsed() : -1;
+    }
+
+private:
+#ifdef HAVE_DRM_BACKEND
+    std::unique_ptr<HeadlessDisplay> display_;
+#endif
+};
+
+bool usesGpu(const std::string& backend) {
+    return backend == "vaapi-zerocopy" || backend == "hap-direct" || backend == "hap-ffmpeg";
+}
+
+/** Read frames [0, warmup + frames) in order, timing the measured ones */
+template <typename ReadFn>
+void measure(const Options& options, int64_t totalFrames, GpuContext* gpu, ReadFn read, Result& result) {
+    int64_t last = options.warmup + options.frames;
+    if (totalFrames > 0) {
+        last = std::min(last, totalFrames);
+    }
+    result.latencies.reserve(static_cast<size_t>(options.frames));
+    int64_t vramBefore = gpu ? gpu->videoMemoryUsed() : -1;
+    double cpuStart = 0.0;
+    double wallStart = 0.0;
+
+    for (int64_t frame = 0; frame < last; ++frame) {
+        if (frame == options.warmup) {
+            cpuStart = cpuSeconds();
+            wallStart = nowSeconds();
+        }
+        double start = nowSeconds();
+        if (!read(frame)) {
+            result.status = "error";
+            result.error = "frame " + std::to_string(frame) + " not decoded";
+            break;
+        }
+        if (gpu) {
+            glFinish();
+        }
+        if (frame >= options.warmup) {
+            result.latencies.push_back((nowSeconds() - start) * 1000.0);
+        }
+    }
+
+    result.frames = static_cast<int64_t>(result.latencies.size());
+    if (result.frames > 0) {
+        result.seconds = nowSeconds() - wallStart;
+        result.cpuSeconds = cpuSeconds() - cpuStart;
+    } else if (result.status == "ok") {
+        result.status = "error";
+        result.error = "file shorter than the warm-up";
+    }
+    result.residentBytes = residentBytes();
+    int64_t vramAfter = gpu ? gpu->videoMemoryUsed() : -1;
+    if (vramBefore >= 0 && vramAfter >= 0) {
+        result.vramBytes = std::max<int64_t>(vramAfter - vramBefore, 0);
+    }
+}
+
+Result runVideoFile(const Options& options, const std::string& path, const std::string& backend, GpuContext& gpu) {
+    Result result;
+    VideoFileInput input;
+    input.setBackgroundIndexing(false);
+    input.setIndexCache(false);
+    if (backend == "software") {
+        input.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+    } else {
+        input.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::VAAPI);
+    }
+#ifdef HAVE_VAAPI_INTEROP
+    if (backend == "vaapi-zerocopy") {
+        input.setDisplayBackend(gpu.display());
+    }
+#endif
+    if (!input.open(path)) {
+        result.status = "error";
+        result.error = "open failed";
+        return result;
+    }
+    if (backend != "software" && input.getOptimalBackend() != InputSource::DecodeBackend::GPU_HARDWARE) {
+        result.status = "unavailable";
+        result.error = "no VAAPI decoder for this file";
+        return result;
+    }
+
+    int64_t totalFrames = input.getFrameInfo().totalFrames;
+    if (backend == "vaapi-zerocopy") {
+        GPUTextureFrameBuffer texture;
+        measure(options, totalFrames, &gpu, [&](int64_t frame) {
+            return input.readFrameToTexture(frame, texture);
+        }, result);
+#ifdef HAVE_VAAPI_INTEROP
+        if (result.status == "ok" && !input.hasVaapiZeroCopy()) {
+            result.status = "unavailable";
+            result.error = "no VAAPI/EGL interop (frames were copied)";
+        }
+#endif
+    } else {
+        FrameBuffer buffer;
+        measure(options, totalFrames, nullptr, [&](int64_t frame) {
+            return input.readFrame(frame, buffer);
+        }, result);
+    }
+    return result;
+}
+
+Result runHap(const Options& options, const std::string& path, const std::string& backend, GpuContext& gpu) {
+    Result result;
+#ifdef ENABLE_HAP_DIRECT
+    HAPVideoInput input;
+    input.setDirectDecode(backend == "hap-direct");
+    if (!input.open(path)) {
+        result.status = "error";
+        result.error = "open failed";
+        return result;
+    }
+    GPUTextureFrameBuffer texture;
+    measure(options, input.getFrameInfo().totalFrames, &gpu, [&](int64_t frame) {
+        return input.readFrameToTexture(frame, texture);
+    }, result);
+#else
+    (void)options;
+    (void)path;
+    (void)backend;
+    (void)gpu;
+    result.status = "unavailable";
+    result.error = "built without ENABLE_HAP_DIRECT";
+#endif
+    return result;
+}
+
+void printResult(const std::string& path, const FrameInfo& info, InputSource::CodecType codec,
+                 const std::string& backend, const Result& result) {
+    std::ostringstream out;
+    out << "{\"file\":" << jsonString(path)
+        << ",\"codec\":\"" << codecName(codec) << "\""
+        << ",\"width\":" << info.width << ",\"height\":" << info.height
+        << ",\"framerate\":" << info.framerate
+        << ",\"backend\":\"" << backend << "\""
+        << ",\"status\":\"" << result.status << "\"";
+    if (!result.error.empty()) {
+        out << ",\"error\":" << jsonString(result.error);
+    }
+    if (result.frames > 0) {
+        out << ",\"frames\":" << result.frames
+            << ",\"fps\":" << (result.seconds > 0.0 ? result.frames / result.seconds : 0.0)
+            << ",\"latency_ms\":{\"p50\":" << percentile(result.latencies, 0.50)
+            << ",\"p99\":" << percentile(result.latencies, 0.99)
+            << ",\"max\":" << percentile(result.latencies, 1.0) << "}"
+            << ",\"cpu_percent\":" << (result.seconds > 0.0 ? result.cpuSeconds / result.seconds * 100.0 : 0.0)
+            << ",\"rss_mb\":" << result.residentBytes / (1024.0 * 1024.0)
+            << ",\"vram_mb\":" << (result.vramBytes >= 0 ? result.vramBytes / (1024.0 * 1024.0) : -1.0);
+    }
+    out << "}";
+    std::cout << out.str() << std::endl;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <file|directory|manifest>...\n"
+              << "  --backends LIST   Comma-separated subset of: software, vaapi-zerocopy,\n"
+              << "                    vaapi-readback, hap-direct, hap-ffmpeg (default: all)\n"
+              << "  --frames N        Frames measured per file and backend (default 600)\n"
+              << "  --warmup N        Frames decoded first and not measured (default 30)\n"
+              << "  --verbose         Log decoder messages (stderr)\n"
+              << "Prints one JSON object per file and backend on stdout.\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--backends" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                if (std::find(std::begin(ALL_BACKENDS), std::end(ALL_BACKENDS), name) == std::end(ALL_BACKENDS)) {
+                    std::cerr << "bench_decode: unknown backend " << name << "\n";
+                    return false;
+                }
+                options.backends.push_back(name);
+            }
+        } else if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::max<int64_t>(std::atoll(argv[++i]), 1);
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::max<int64_t>(std::atoll(argv[++i]), 0);
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg == "--help" || arg == "-h" || arg[0] == '-') {
+            return false;
+        } else {
+            addCorpus("bench_decode", arg, options.files);
+        }
+    }
+    if (options.backends.empty()) {
+        options.backends.assign(std::begin(ALL_BACKENDS), std::end(ALL_BACKENDS));
+    }
+    return !options.files.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // INFO goes to stdout, which carries the results
+    Logger::getInstance().setLevel(options.verbose ? Logger::INFO : Logger::WARNING);
+
+    GpuContext gpu;
+    bool needsGpu = std::any_of(options.backends.begin(), options.backends.end(), usesGpu);
+    bool haveGpu = needsGpu && gpu.open();
+    if (needsGpu && !haveGpu) {
+        std::cerr << "bench_decode: no headless GL context, GPU backends unavailable\n";
+    } else if (haveGpu) {
+        gpu.display()->makeCurrent();
+    }
+
+    int failures = 0;
+    for (const std::string& path : options.files) {
+        // Probe once for the codec and the format fields of every line
+        VideoFileInput probe;
+        probe.setBackgroundIndexing(false);
+        probe.setIndexCache(false);
+        probe.setNoIndex(true);
+        probe.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+        if (!probe.open(path)) {
+            std::cout << "{\"file\":" << jsonString(path) << ",\"status\":\"error\",\"error\":\"not a video file\"}"
+                      << std::endl;
+            ++failures;
+            continue;
+        }
+        FrameInfo info = probe.getFrameInfo();
+        InputSource::CodecType codec = probe.detectCodec();
+        probe.close();
+
+        for (const std::string& backend : options.backends) {
+            bool hapBackend = backend.compare(0, 4, "hap-") == 0;
+            if (hapBackend != isHap(codec)) {
+                continue;  // HAP files only run the HAP backends and the other way round
+            }
+            Result result;
+            if (usesGpu(backend) && !haveGpu) {
+                result.status = "unavailable";
+                result.error = "no headless GL context";
+            } else if (hapBackend) {
+                result = runHap(options, path, backend, gpu);
+            } else {
+                result = runVideoFile(options, path, backend, gpu);
+            }
+            if (result.status == "error") {
+                ++failures;
+            }
+            printResult(path, info, codec, backend, result);
+        }
+    }
+    return failures == 0 ? 0 : 2;
+}
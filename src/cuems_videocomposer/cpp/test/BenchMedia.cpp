@@ -0,0 +1,433 @@
+/**
+ * BenchMedia.cpp - Benchmark media generator (cuems_videocomposer_bench_media)
+ *
+ * Encodes the same synthetic clip in every profile and size into an output
+ * directory and writes manifest.jsonl there, one JSON object per clip:
+ *
+ *   {"file":"h264-gop12_1920x1080.mp4","profile":"h264-gop12","codec":"h264",
+ *    "encoder":"libx264","container":"mp4","width":1920,"height":1080,
+ *    "framerate":25,"frames":250,"gop":12,"bframes":2,"alpha":false,
+ *    "framecode_rows":16}
+ *
+ * The decode and seek benchmarks take the manifest in place of a corpus
+ * directory, so runs on different machines measure the same files. Every
+ * frame is a TestPatternInput frame: FrameCode strips along the top and
+ * bottom edge carry the frame number, so a decoded or displayed frame can
+ * be checked against the one that was asked for. Alpha profiles add an
+ * alpha ramp across the middle of the image; the strips stay opaque.
+ *
+ * Encoders missing from this FFmpeg build are reported on stdout (status
+ * "unavailable") and left out of the manifest.
+ */
+
+#include "BenchCommon.h"
+#include "input/TestPatternInput.h"
+#include "video/FrameBuffer.h"
+#include "utils/Logger.h"
+#include "utils/SMPTEUtils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+#include <libavutil/error.h>
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+using namespace videocomposer;
+using namespace videocomposer::bench;
+
+namespace {
+
+struct Profile {
+    const char* name;
+    const char* encoder;
+    const char* container;      // File extension, the muxer is guessed from it
+    AVPixelFormat pixelFormat;
+    int gop;
+    int bFrames;
+    bool alpha;
+    const char* options;        // Encoder options, key=value:key=value
+};
+
+// Long-GOP codecs at GOP lengths the seek benchmark tells apart, and the
+// intra codecs shows are played from
+const Profile PROFILES[] = {
+    {"h264-intra",        "libx264",   "mp4", AV_PIX_FMT_YUV420P,     1,   0, false, "preset=medium"},
+    {"h264-gop12",        "libx264",   "mp4", AV_PIX_FMT_YUV420P,     12,  2, false, "preset=medium"},
+    {"h264-gop250",       "libx264",   "mp4", AV_PIX_FMT_YUV420P,     250, 3, false, "preset=medium"},
+    {"hevc-gop12",        "libx265",   "mp4", AV_PIX_FMT_YUV420P,     12,  2, false, "preset=medium"},
+    {"hevc-gop250",       "libx265",   "mp4", AV_PIX_FMT_YUV420P,     250, 3, false, "preset=medium"},
+    {"prores-hq",         "prores_ks", "mov", AV_PIX_FMT_YUV422P10LE, 1,   0, false, "profile=hq"},
+    {"prores-4444-alpha", "prores_ks", "mov", AV_PIX_FMT_YUVA444P10LE, 1,  0, true,  "profile=4444:alpha_bits=16"},
+    {"hap",               "hap",       "mov", AV_PIX_FMT_RGBA,        1,   0, false, "format=hap:chunks=4"},
+    {"hap-alpha",         "hap",       "mov", AV_PIX_FMT_RGBA,        1,   0, true,  "format=hap_alpha:chunks=4"},
+    {"hap-q",             "hap",       "mov", AV_PIX_FMT_RGBA,        1,   0, false, "format=hap_q:chunks=4"},
+};
+
+struct Size {
+    int width;
+    int height;
+};
+
+struct Options {
+    std::vector<std::string> profiles;
+    std::vector<Size> sizes;
+    std::string directory;
+    int64_t frames = 250;
+    double framerate = 25.0;
+    bool verbose = false;
+};
+
+std::string avError(int err) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    return errbuf;
+}
+
+/**
+ * One clip being written: encoder, muxer and the BGRA to encoder converter
+ */
+class ClipWriter {
+public:
+    ~ClipWriter() { release(); }
+
+    bool open(const Profile& profile, const Size& size, double framerate, const std::string& path,
+              std::string& error) {
+        const AVCodec* codec = avcodec_find_encoder_by_name(profile.encoder);
+        if (!codec) {
+            error = "unavailable";
+            return false;
+        }
+        int64_t fpsNum = 0, fpsDen = 1;
+        SMPTEUtils::framerateToRational(framerate, fpsNum, fpsDen);
+
+        int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, nullptr, path.c_str());
+        if (ret < 0 || !formatCtx_) {
+            error = "no muxer for " + path;
+            return false;
+        }
+        codecCtx_ = avcodec_alloc_context3(codec);
+        if (!codecCtx_) {
+            return false;
+        }
+        codecCtx_->width = size.width;
+        codecCtx_->height = size.height;
+        codecCtx_->pix_fmt = profile.pixelFormat;
+        codecCtx_->time_base = AVRational{static_cast<int>(fpsDen), static_cast<int>(fpsNum)};
+        codecCtx_->framerate = AVRational{static_cast<int>(fpsNum), static_cast<int>(fpsDen)};
+        codecCtx_->gop_size = profile.gop;
+        codecCtx_->max_b_frames = profile.bFrames;
+        if (profile.pixelFormat != AV_PIX_FMT_RGBA) {
+            // BT.709 limited range, set on the converter below
+            codecCtx_->color_primaries = AVCOL_PRI_BT709;
+            codecCtx_->color_trc = AVCOL_TRC_BT709;
+            codecCtx_->colorspace = AVCOL_SPC_BT709;
+            codecCtx_->color_range = AVCOL_RANGE_MPEG;
+        }
+        if (profile.gop == 1) {
+            codecCtx_->keyint_min = 1;
+        }
+        if (formatCtx_->oformat->flags & AVFMT_GLOBALHEADER) {
+            codecCtx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+
+        AVDictionary* options = nullptr;
+        av_dict_parse_string(&options, profile.options, "=", ":", 0);
+        ret = avcodec_open2(codecCtx_, codec, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            error = std::string("cannot open ") + profile.encoder + ": " + avError(ret);
+            return false;
+        }
+
+        stream_ = avformat_new_stream(formatCtx_, nullptr);
+        if (!stream_) {
+            return false;
+        }
+        stream_->time_base = codecCtx_->time_base;
+        avcodec_parameters_from_context(stream_->codecpar, codecCtx_);
+        if (!(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
+            ret = avio_open(&formatCtx_->pb, path.c_str(), AVIO_FLAG_WRITE);
+            if (ret < 0) {
+                error = path + ": " + avError(ret);
+                return false;
+            }
+        }
+        ret = avformat_write_header(formatCtx_, nullptr);
+        if (ret < 0) {
+            error = "cannot write header: " + avError(ret);
+            return false;
+        }
+
+        scaler_ = sws_getContext(size.width, size.height, AV_PIX_FMT_BGRA, size.width, size.height,
+                                 profile.pixelFormat, SWS_POINT, nullptr, nullptr, nullptr);
+        if (scaler_ && profile.pixelFormat != AV_PIX_FMT_RGBA) {
+            sws_setColorspaceDetails(scaler_, sws_getCoefficients(SWS_CS_DEFAULT), 1,
+                                     sws_getCoefficients(SWS_CS_ITU709), 0, 0, 1 << 16, 1 << 16);
+        }
+        frame_ = av_frame_alloc();
+        packet_ = av_packet_alloc();
+        if (!scaler_ || !frame_ || !packet_) {
+            error = "out of memory";
+            return false;
+        }
+        frame_->format = profile.pixelFormat;
+        frame_->width = size.width;
+        frame_->height = size.height;
+        if (av_frame_get_buffer(frame_, 0) < 0) {
+            error = "out of memory";
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const FrameBuffer& image, int64_t pts, std::string& error) {
+        if (av_frame_make_writable(frame_) < 0) {
+            error = "out of memory";
+            return false;
+        }
+        const uint8_t* planes[] = {image.data()};
+        const int strides[] = {image.info().width * 4};
+        sws_scale(scaler_, planes, strides, 0, image.info().height, frame_->data, frame_->linesize);
+        frame_->pts = pts;
+        return encode(frame_, error);
+    }
+
+    bool finish(std::string& error) {
+        if (!encode(nullptr, error)) {
+            return false;
+        }
+        int ret = av_write_trailer(formatCtx_);
+        if (ret < 0) {
+            error = "cannot write trailer: " + avError(ret);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool encode(AVFrame* frame, std::string& error) {
+        int ret = avcodec_send_frame(codecCtx_, frame);
+        if (ret < 0) {
+            error = "encode failed: " + avError(ret);
+            return false;
+        }
+        while ((ret = avcodec_receive_packet(codecCtx_, packet_)) >= 0) {
+            av_packet_rescale_ts(packet_, codecCtx_->time_base, stream_->time_base);
+            packet_->stream_index = stream_->index;
+            ret = av_interleaved_write_frame(formatCtx_, packet_);
+            if (ret < 0) {
+                error = "write failed: " + avError(ret);
+                return false;
+            }
+        }
+        return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+    }
+
+    void release() {
+        if (formatCtx_) {
+            if (!(formatCtx_->oformat->flags & AVFMT_NOFILE) && formatCtx_->pb) {
+                avio_closep(&formatCtx_->pb);
+            }
+            avformat_free_context(formatCtx_);
+            formatCtx_ = nullptr;
+        }
+        sws_freeContext(scaler_);
+        scaler_ = nullptr;
+        av_frame_free(&frame_);
+        av_packet_free(&packet_);
+        avcodec_free_context(&codecCtx_);
+    }
+
+    AVFormatContext* formatCtx_ = nullptr;
+    AVCodecContext* codecCtx_ = nullptr;
+    AVStream* stream_ = nullptr;
+    SwsContext* scaler_ = nullptr;
+    AVFrame* frame_ = nullptr;
+    AVPacket* packet_ = nullptr;
+};
+
+// Alpha ramp, transparent on the left, over the middle half of the rows
+void applyAlphaRamp(FrameBuffer& image) {
+    int width = image.info().width;
+    int height = image.info().height;
+    for (int y = height / 4; y < height * 3 / 4; ++y) {
+        uint8_t* row = image.data() + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            row[x * 4 + 3] = static_cast<uint8_t>(x * 255 / std::max(width - 1, 1));
+        }
+    }
+}
+
+std::string clipName(const Profile& profile, const Size& size) {
+    return std::string(profile.name) + "_" + std::to_string(size.width) + "x" + std::to_string(size.height) +
+           "." + profile.container;
+}
+
+bool generate(const Options& options, const Profile& profile, const Size& size, std::ostream& manifest) {
+    std::string file = clipName(profile, size);
+    std::string path = options.directory + "/" + file;
+    std::cout << "{\"file\":" << jsonString(file);
+
+    double start = nowSeconds();
+    std::string error;
+    ClipWriter writer;
+    bool ok = writer.open(profile, size, options.framerate, path, error);
+    TestPatternInput pattern(size.width, size.height, options.framerate);
+    FrameBuffer image;
+    for (int64_t frame = 0; ok && frame < options.frames; ++frame) {
+        ok = pattern.readFrame(frame, image);
+        if (ok && profile.alpha) {
+            applyAlphaRamp(image);
+        }
+        ok = ok && writer.write(image, frame, error);
+    }
+    ok = ok && writer.finish(error);
+
+    if (!ok) {
+        std::cout << ",\"status\":" << jsonString(error == "unavailable" ? error : "error");
+        if (error != "unavailable") {
+            std::cout << ",\"error\":" << jsonString(error.empty() ? "encode failed" : error);
+        }
+        std::cout << "}" << std::endl;
+        std::remove(path.c_str());
+        return error == "unavailable";
+    }
+    std::cout << ",\"status\":\"ok\",\"seconds\":" << nowSeconds() - start << "}" << std::endl;
+
+    manifest << "{\"file\":" << jsonString(file)
+             << ",\"profile\":" << jsonString(profile.name)
+             << ",\"codec\":" << jsonString(avcodec_get_name(avcodec_find_encoder_by_name(profile.encoder)->id))
+             << ",\"encoder\":" << jsonString(profile.encoder)
+             << ",\"container\":" << jsonString(profile.container)
+             << ",\"width\":" << size.width << ",\"height\":" << size.height
+             << ",\"framerate\":" << options.framerate << ",\"frames\":" << options.frames
+             << ",\"gop\":" << profile.gop << ",\"bframes\":" << profile.bFrames
+             << ",\"alpha\":" << (profile.alpha ? "true" : "false")
+             << ",\"framecode_rows\":" << pattern.stripHeight() << "}" << std::endl;
+    return true;
+}
+
+bool parseProfiles(const char* text, std::vector<std::string>& names) {
+    std::stringstream list(text);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        bool known = false;
+        for (const Profile& profile : PROFILES) {
+            known = known || name == profile.name;
+        }
+        if (!known) {
+            std::cerr << "bench_media: unknown profile " << name << "\n";
+            return false;
+        }
+        names.push_back(name);
+    }
+    return true;
+}
+
+bool parseSizes(const char* text, std::vector<Size>& sizes) {
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        Size size;
+        if (std::sscanf(item.c_str(), "%dx%d", &size.width, &size.height) != 2 ||
+            size.width < 64 || size.height < 64 || size.width % 2 != 0 || size.height % 2 != 0) {
+            std::cerr << "bench_media: bad size " << item << " (even WxH, at least 64x64)\n";
+            return false;
+        }
+        sizes.push_back(size);
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <output directory>\n"
+              << "  --profiles LIST   Subset of:";
+    for (const Profile& profile : PROFILES) {
+        std::cerr << " " << profile.name;
+    }
+    std::cerr << "\n"
+              << "                    (default: all)\n"
+              << "  --sizes LIST      Frame sizes, WxH (default 1280x720,1920x1080,3840x2160)\n"
+              << "  --frames N        Frames per clip (default 250)\n"
+              << "  --framerate FPS   Clip frame rate (default 25)\n"
+              << "  --verbose         Log encoder messages (stderr)\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--profiles" && hasValue) {
+            if (!parseProfiles(argv[++i], options.profiles)) return false;
+        } else if (arg == "--sizes" && hasValue) {
+            if (!parseSizes(argv[++i], options.sizes)) return false;
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max<int64_t>(std::atoll(argv[++i]), 1);
+        } else if (arg == "--framerate" && hasValue) {
+            options.framerate = std::atof(argv[++i]);
+            if (options.framerate <= 0.0) return false;
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg[0] == '-' || !options.directory.empty()) {
+            return false;
+        } else {
+            options.directory = arg;
+        }
+    }
+    if (options.profiles.empty()) {
+        for (const Profile& profile : PROFILES) {
+            options.profiles.push_back(profile.name);
+        }
+    }
+    if (options.sizes.empty()) {
+        options.sizes = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    }
+    return !options.directory.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    Logger::getInstance().setLevel(options.verbose ? Logger::INFO : Logger::WARNING);
+    av_log_set_level(options.verbose ? AV_LOG_INFO : AV_LOG_ERROR);
+
+    if (mkdir(options.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "bench_media: " << options.directory << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::string manifestPath = options.directory + "/" + MANIFEST_NAME;
+    std::ofstream manifest(manifestPath, std::ios::trunc);
+    if (!manifest) {
+        std::cerr << "bench_media: cannot write " << manifestPath << "\n";
+        return 1;
+    }
+
+    int failures = 0;
+    for (const Profile& profile : PROFILES) {
+        if (std::find(options.profiles.begin(), options.profiles.end(), profile.name) == options.profiles.end()) {
+            continue;
+        }
+        for (const Size& size : options.sizes) {
+            if (!generate(options, profile, size, manifest)) {
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 2;
+}
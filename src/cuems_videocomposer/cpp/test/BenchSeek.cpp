@@ -0,0 +1,606 @@
+/**
+ * BenchSeek.cpp - Seek and locate latency benchmark (cuems_videocomposer_bench_seek)
+ *
+ * Plays every file of a media corpus through a real VideoLayer on the
+ * headless display, driven by a scripted sync source, and jumps it around
+ * the way a show does. For each file, backend, index mode and scenario it
+ * prints one JSON object (JSON Lines on stdout, logging on stderr):
+ *
+ *   {"file":"a.mov","codec":"H264","gop":48,"gop_class":"long-gop",
+ *    "backend":"software","index":"indexed","scenario":"mtc","status":"ok",
+ *    "first_frame_ms":38.2,"jumps":50,"timeouts":0,
+ *    "latency_ms":{"p50":21.7,"p90":30.4,"p99":41.0,"max":41.0},
+ *    "updates":{"p50":1,"max":2},"keyframe_distance":{"p50":23,"max":47}}
+ *
+ * Scenarios:
+ *   seek   LayerPlayback::seek() to the target, the clock held there
+ *   mtc    Clock jumps to the target with a full-frame message (LOCATE)
+ *   loop   Layer loop region ending after the clock, wrapped to the target
+ *
+ * Latency is time-to-first-correct-frame on screen: from the jump to the
+ * end of the first rendered frame (glFinish) whose layer image is the
+ * target frame; "updates" counts the layer updates that took. Before each
+ * jump the layer plays --settle frames, so the decoder is in its playing
+ * state. Targets are random (--seed) or the frames of a --script file.
+ *
+ * Index modes: indexed (frame index built on open), noindex (timestamp
+ * seeks) and direct (intra-only codecs: computed positions, HAP sample
+ * tables). The GOP class comes from the longest keyframe distance of the
+ * file's index: intra, short-gop (up to --short-gop frames) or long-gop.
+ */
+
+#include "BenchCommon.h"
+#include "input/VideoFileInput.h"
+#include "input/HAPVideoInput.h"
+#include "display/DisplayBackend.h"
+#include "layer/LayerManager.h"
+#include "layer/VideoLayer.h"
+#include "sync/SyncSource.h"
+#include "utils/Logger.h"
+#ifdef HAVE_DRM_BACKEND
+#include "display/HeadlessDisplay.h"
+#endif
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::bench;
+
+namespace {
+
+const char* const ALL_BACKENDS[] = {
+    "software", "vaapi-zerocopy", "vaapi-readback", "hap-direct", "hap-ffmpeg"
+};
+const char* const ALL_INDEX_MODES[] = {"indexed", "noindex", "direct"};
+const char* const ALL_SCENARIOS[] = {"seek", "mtc", "loop"};
+
+struct Options {
+    std::vector<std::string> files;
+    std::vector<std::string> backends;
+    std::vector<std::string> indexModes;
+    std::vector<std::string> scenarios;
+    std::string script;          // Target frames, one per line (empty = random)
+    int jumps = 50;
+    unsigned int seed = 1;
+    int settle = 5;
+    int loopLength = 100;
+    int shortGop = 30;
+    double timeoutMs = 5000.0;
+    bool verbose = false;
+};
+
+struct Result {
+    std::string status = "ok";
+    std::string error;
+    double firstFrameMs = -1.0;
+    int timeouts = 0;
+    std::vector<double> latencies;       // ms, one per jump shown in time
+    std::vector<double> updates;         // Layer updates until shown
+    std::vector<double> keyframeDistances;
+};
+
+/**
+ * Sync source positioned by the benchmark, as MTC would position the layer
+ */
+class ScriptedClock : public SyncSource {
+public:
+    bool connect(const char* param = nullptr) override { (void)param; return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        if (rolling) {
+            *rolling = 1;
+        }
+        return frame_;
+    }
+    int64_t getCurrentFrame() const override { return frame_; }
+    const char* getName() const override { return "Scripted"; }
+    bool wasFullFrameReceived() override {
+        bool received = fullFrame_;
+        fullFrame_ = false;
+        return received;
+    }
+
+    void setFrame(int64_t frame) { frame_ = frame; }
+    void locate(int64_t frame) {
+        frame_ = frame;
+        fullFrame_ = true;
+    }
+
+private:
+    int64_t frame_ = 0;
+    bool fullFrame_ = false;
+};
+
+// Longest keyframe distance of the file + 1 (1 = intra-only), -1 without an index
+int64_t probeGop(const std::string& path) {
+    VideoFileInput probe;
+    probe.setBackgroundIndexing(false);
+    probe.setIndexCache(false);
+    probe.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+    if (!probe.open(path)) {
+        return -1;
+    }
+    if (probe.hasInstantSeek()) {
+        return 1;
+    }
+    int64_t longest = -1;
+    for (int64_t frame = 0; frame < probe.getFrameInfo().totalFrames; ++frame) {
+        longest = std::max(longest, probe.getKeyframeDistance(frame));
+    }
+    return longest >= 0 ? longest + 1 : -1;
+}
+
+std::string gopClass(int64_t gop, int shortGop) {
+    if (gop < 0) {
+        return "unknown";
+    }
+    if (gop <= 1) {
+        return "intra";
+    }
+    return gop <= shortGop ? "short-gop" : "long-gop";
+}
+
+bool loadScript(const std::string& path, std::vector<int64_t>& targets) {
+    std::ifstream script(path);
+    if (!script) {
+        std::cerr << "bench_seek: cannot read " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(script, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        int64_t frame;
+        if (fields >> frame) {
+            targets.push_back(frame);
+        }
+    }
+    return !targets.empty();
+}
+
+#if defined(HAVE_DRM_BACKEND)
+
+/**
+ * Create the input of one run
+ * @return nullptr with result status "unavailable" or "error" set
+ */
+std::unique_ptr<InputSource> createInput(const std::string& path, const std::string& backend,
+                                         const std::string& indexMode, DisplayBackend* display,
+                                         Result& result) {
+    bool hapBackend = backend.compare(0, 4, "hap-") == 0;
+    if (hapBackend) {
+#ifdef ENABLE_HAP_DIRECT
+        if (indexMode != "direct") {
+            result.status = "unavailable";
+            result.error = "HAP seeks through its sample table (direct)";
+            return nullptr;
+        }
+        auto input = std::make_unique<HAPVideoInput>();
+        input->setDirectDecode(backend == "hap-direct");
+        if (!input->open(path)) {
+            result.status = "error";
+            result.error = "open failed";
+            return nullptr;
+        }
+        return input;
+#else
+        result.status = "unavailable";
+        result.error = "built without ENABLE_HAP_DIRECT";
+        return nullptr;
+#endif
+    }
+
+    auto input = std::make_unique<VideoFileInput>();
+    input->setBackgroundIndexing(false);
+    input->setIndexCache(false);
+    input->setNoIndex(indexMode == "noindex");
+    input->setHardwareDecodePreference(backend == "software"
+        ? VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY
+        : VideoFileInput::HardwareDecodePreference::VAAPI);
+#ifdef HAVE_VAAPI_INTEROP
+    if (backend == "vaapi-zerocopy") {
+        input->setDisplayBackend(display);
+    }
+#else
+    (void)display;
+#endif
+    if (!input->open(path)) {
+        result.status = "error";
+        result.error = "open failed";
+        return nullptr;
+    }
+    if (backend != "software" && input->getOptimalBackend() != InputSource::DecodeBackend::GPU_HARDWARE) {
+        result.status = "unavailable";
+        result.error = "no VAAPI decoder for this file";
+        return nullptr;
+    }
+    // Intra-only files never build an index: "indexed" would measure direct seeks
+    bool intra = input->hasInstantSeek();
+    if ((indexMode == "direct" && !intra) || (indexMode == "indexed" && intra)) {
+        result.status = "unavailable";
+        result.error = intra ? "intra-only files use direct seeks" : "direct seeks need an intra-only codec";
+        return nullptr;
+    }
+    return input;
+}
+
+/**
+ * One layer on the headless display, stepped update by update
+ */
+class SeekRun {
+public:
+    SeekRun(HeadlessDisplay& display, const Options& options) : display_(display), options_(options) {}
+
+    ~SeekRun() {
+        display_.makeCurrent();
+        layers_.reset();
+    }
+
+    bool setUp(std::unique_ptr<InputSource> input) {
+        totalFrames_ = input->getFrameInfo().totalFrames;
+        videoInput_ = dynamic_cast<VideoFileInput*>(input.get());
+        auto layer = std::make_unique<VideoLayer>();
+        layer->setInputSource(std::move(input));
+        auto clock = std::make_unique<ScriptedClock>();
+        clock_ = clock.get();
+        layer->setSyncSource(std::move(clock));
+        int layerId = layers_->addLayer(std::move(layer));
+        layer_ = layers_->getLayer(layerId);
+        return layer_ && totalFrames_ > 0;
+    }
+
+    int64_t getTotalFrames() const { return totalFrames_; }
+
+    int64_t keyframeDistance(int64_t frame) const {
+        return videoInput_ ? videoInput_->getKeyframeDistance(frame) : 0;
+    }
+
+    // Layer update and one rendered frame, finished on the GPU
+    void step() {
+        display_.makeCurrent();
+        layers_->updateAll();
+        display_.render(layers_.get());
+        display_.makeCurrent();
+        glFinish();
+    }
+
+    /**
+     * Step until the layer shows target
+     * @param follow Called after each update (the clock following a loop wrap)
+     * @return Updates it took, or -1 on timeout
+     */
+    template <typename Follow>
+    int waitFor(int64_t target, double start, Follow follow) {
+        for (int updates = 1; ; ++updates) {
+            step();
+            if (layer_->getLoadedFrame() == target) {
+                return updates;
+            }
+            if ((nowSeconds() - start) * 1000.0 > options_.timeoutMs) {
+                return -1;
+            }
+            follow();
+        }
+    }
+
+    int waitFor(int64_t target, double start) {
+        return waitFor(target, start, [] {});
+    }
+
+    // Play forward from the current frame, as the show would before a cue
+    void settle(int64_t from) {
+        for (int i = 0; i < options_.settle && from + i < totalFrames_; ++i) {
+            clock_->setFrame(from + i);
+            step();
+        }
+    }
+
+    /**
+     * Jump to target per scenario
+     * @return Latency in ms (-1 on timeout); updates set to the updates it took
+     */
+    double jump(const std::string& scenario, int64_t target, int& updates) {
+        double start = 0.0;
+        if (scenario == "seek") {
+            settle(std::min(layer_->getLoadedFrame() + 1, totalFrames_ - 1));
+            start = nowSeconds();
+            layer_->seek(target);
+            clock_->setFrame(target);
+            updates = waitFor(target, start);
+        } else if (scenario == "mtc") {
+            settle(std::min(layer_->getLoadedFrame() + 1, totalFrames_ - 1));
+            start = nowSeconds();
+            clock_->locate(target);
+            updates = waitFor(target, start);
+        } else {
+            // Loop region [target, end): approach its end, then let the layer wrap
+            int64_t end = std::min<int64_t>(target + options_.loopLength, totalFrames_ - 1);
+            LayerProperties::LoopRegion& loop = layer_->properties().loopRegion;
+            loop.enabled = true;
+            loop.startFrame = target;
+            loop.endFrame = end;
+            loop.loopCount = -1;
+            loop.currentLoopCount = -1;
+            int64_t approach = std::max<int64_t>(end - options_.settle, 0);
+            clock_->locate(approach);
+            if (waitFor(approach, nowSeconds()) < 0) {
+                updates = -1;
+                return -1.0;
+            }
+            settle(approach + 1);
+            start = nowSeconds();
+            clock_->setFrame(end);
+            // The clock follows the wrap, as a looping show clock would
+            updates = waitFor(target, start, [&] {
+                if (layer_->getCurrentFrame() < end) {
+                    clock_->setFrame(layer_->getCurrentFrame());
+                }
+            });
+            loop.enabled = false;
+        }
+        return updates < 0 ? -1.0 : (nowSeconds() - start) * 1000.0;
+    }
+
+private:
+    HeadlessDisplay& display_;
+    const Options& options_;
+    std::unique_ptr<LayerManager> layers_ = std::make_unique<LayerManager>();
+    VideoLayer* layer_ = nullptr;
+    ScriptedClock* clock_ = nullptr;
+    VideoFileInput* videoInput_ = nullptr;
+    int64_t totalFrames_ = 0;
+};
+
+Result runScenario(HeadlessDisplay& display, const Options& options, const std::string& path,
+                   const std::string& backend, const std::string& indexMode, const std::string& scenario,
+                   const std::vector<int64_t>& script) {
+    Result result;
+    display.makeCurrent();
+    double openStart = nowSeconds();
+    std::unique_ptr<InputSource> input = createInput(path, backend, indexMode, &display, result);
+    if (!input) {
+        return result;
+    }
+    SeekRun run(display, options);
+    if (!run.setUp(std::move(input))) {
+        result.status = "error";
+        result.error = "unknown duration";
+        return result;
+    }
+    if (run.waitFor(0, openStart) < 0) {
+        result.status = "error";
+        result.error = "first frame not shown";
+        return result;
+    }
+    result.firstFrameMs = (nowSeconds() - openStart) * 1000.0;
+
+    // Loop starts leave room for the loop and the approach to its end
+    int64_t total = run.getTotalFrames();
+    int64_t range = scenario == "loop" ? total - options.loopLength - options.settle - 1 : total;
+    if (range <= 0) {
+        result.status = "unavailable";
+        result.error = "file shorter than a loop";
+        return result;
+    }
+    std::vector<int64_t> targets;
+    if (script.empty()) {
+        std::mt19937 random(options.seed);
+        std::uniform_int_distribution<int64_t> frames(0, range - 1);
+        for (int i = 0; i < options.jumps; ++i) {
+            targets.push_back(frames(random));
+        }
+    } else {
+        std::copy_if(script.begin(), script.end(), std::back_inserter(targets),
+                     [range](int64_t frame) { return frame >= 0 && frame < range; });
+    }
+
+    for (int64_t target : targets) {
+        int updates = 0;
+        double latency = run.jump(scenario, target, updates);
+        if (latency < 0.0) {
+            ++result.timeouts;
+            continue;
+        }
+        result.latencies.push_back(latency);
+        result.updates.push_back(updates);
+        int64_t distance = run.keyframeDistance(target);
+        if (distance >= 0) {
+            result.keyframeDistances.push_back(static_cast<double>(distance));
+        }
+    }
+    if (result.latencies.empty()) {
+        result.status = "error";
+        result.error = targets.empty() ? "no script target within the file" : "no jump shown in time";
+    }
+    return result;
+}
+
+#endif // HAVE_DRM_BACKEND
+
+void printResult(const std::string& path, InputSource::CodecType codec, int64_t gop, const Options& options,
+                 const std::string& backend, const std::string& indexMode, const std::string& scenario,
+                 const Result& result) {
+    std::ostringstream out;
+    out << "{\"file\":" << jsonString(path)
+        << ",\"codec\":\"" << codecName(codec) << "\""
+        << ",\"gop\":" << gop
+        << ",\"gop_class\":\"" << gopClass(gop, options.shortGop) << "\""
+        << ",\"backend\":\"" << backend << "\""
+        << ",\"index\":\"" << indexMode << "\""
+        << ",\"scenario\":\"" << scenario << "\""
+        << ",\"status\":\"" << result.status << "\"";
+    if (!result.error.empty()) {
+        out << ",\"error\":" << jsonString(result.error);
+    }
+    if (result.firstFrameMs >= 0.0) {
+        out << ",\"first_frame_ms\":" << result.firstFrameMs;
+    }
+    if (!result.latencies.empty()) {
+        out << ",\"jumps\":" << result.latencies.size() + result.timeouts
+            << ",\"timeouts\":" << result.timeouts
+            << ",\"latency_ms\":{\"p50\":" << percentile(result.latencies, 0.50)
+            << ",\"p90\":" << percentile(result.latencies, 0.90)
+            << ",\"p99\":" << percentile(result.latencies, 0.99)
+            << ",\"max\":" << percentile(result.latencies, 1.0) << "}"
+            << ",\"updates\":{\"p50\":" << percentile(result.updates, 0.50)
+            << ",\"max\":" << percentile(result.updates, 1.0) << "}";
+        if (!result.keyframeDistances.empty()) {
+            out << ",\"keyframe_distance\":{\"p50\":" << percentile(result.keyframeDistances, 0.50)
+                << ",\"max\":" << percentile(result.keyframeDistances, 1.0) << "}";
+        }
+    }
+    out << "}";
+    std::cout << out.str() << std::endl;
+}
+
+template <size_t N>
+bool parseNames(const char* text, const char* const (&known)[N], std::vector<std::string>& names) {
+    std::stringstream list(text);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        if (std::find(std::begin(known), std::end(known), name) == std::end(known)) {
+            std::cerr << "bench_seek: unknown name " << name << "\n";
+            return false;
+        }
+        names.push_back(name);
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <file|directory|manifest>...\n"
+              << "  --backends LIST   Subset of: software, vaapi-zerocopy, vaapi-readback,\n"
+              << "                    hap-direct, hap-ffmpeg (default: all)\n"
+              << "  --index LIST      Subset of: indexed, noindex, direct (default: all)\n"
+              << "  --scenarios LIST  Subset of: seek, mtc, loop (default: all)\n"
+              << "  --jumps N         Random targets per run (default 50)\n"
+              << "  --seed N          Random target seed (default 1)\n"
+              << "  --script FILE     Target frames, one per line, instead of random ones\n"
+              << "  --settle N        Frames played before each jump (default 5)\n"
+              << "  --loop-length N   Frames of a loop region (default 100)\n"
+              << "  --short-gop N     Longest GOP counted as short (default 30)\n"
+              << "  --timeout-ms MS   Give up on a jump after MS (default 5000)\n"
+              << "  --verbose         Log decoder messages (stderr)\n"
+              << "Prints one JSON object per file, backend, index mode and scenario on stdout.\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--backends" && hasValue) {
+            if (!parseNames(argv[++i], ALL_BACKENDS, options.backends)) return false;
+        } else if (arg == "--index" && hasValue) {
+            if (!parseNames(argv[++i], ALL_INDEX_MODES, options.indexModes)) return false;
+        } else if (arg == "--scenarios" && hasValue) {
+            if (!parseNames(argv[++i], ALL_SCENARIOS, options.scenarios)) return false;
+        } else if (arg == "--jumps" && hasValue) {
+            options.jumps = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--script" && hasValue) {
+            options.script = argv[++i];
+        } else if (arg == "--settle" && hasValue) {
+            options.settle = std::max(std::atoi(argv[++i]), 0);
+        } else if (arg == "--loop-length" && hasValue) {
+            options.loopLength = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--short-gop" && hasValue) {
+            options.shortGop = std::max(std::atoi(argv[++i]), 2);
+        } else if (arg == "--timeout-ms" && hasValue) {
+            options.timeoutMs = std::max(std::atof(argv[++i]), 1.0);
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            addCorpus("bench_seek", arg, options.files);
+        }
+    }
+    if (options.backends.empty()) {
+        options.backends.assign(std::begin(ALL_BACKENDS), std::end(ALL_BACKENDS));
+    }
+    if (options.indexModes.empty()) {
+        options.indexModes.assign(std::begin(ALL_INDEX_MODES), std::end(ALL_INDEX_MODES));
+    }
+    if (options.scenarios.empty()) {
+        options.scenarios.assign(std::begin(ALL_SCENARIOS), std::end(ALL_SCENARIOS));
+    }
+    return !options.files.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // INFO goes to stdout, which carries the results
+    Logger::getInstance().setLevel(options.verbose ? Logger::INFO : Logger::WARNING);
+
+    std::vector<int64_t> script;
+    if (!options.script.empty() && !loadScript(options.script, script)) {
+        return 1;
+    }
+
+#ifdef HAVE_DRM_BACKEND
+    // Every run renders: the latency is to the frame on screen
+    HeadlessDisplay display;
+    display.setDimensions(1920, 1080);
+    if (!display.openWindow()) {
+        std::cerr << "bench_seek: no headless GL context (render node, EGL)\n";
+        return 1;
+    }
+
+    int failures = 0;
+    for (const std::string& path : options.files) {
+        VideoFileInput probe;
+        probe.setBackgroundIndexing(false);
+        probe.setIndexCache(false);
+        probe.setNoIndex(true);
+        probe.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+        if (!probe.open(path)) {
+            std::cout << "{\"file\":" << jsonString(path) << ",\"status\":\"error\",\"error\":\"not a video file\"}"
+                      << std::endl;
+            ++failures;
+            continue;
+        }
+        InputSource::CodecType codec = probe.detectCodec();
+        probe.close();
+        int64_t gop = isHap(codec) ? 1 : probeGop(path);
+
+        for (const std::string& backend : options.backends) {
+            if ((backend.compare(0, 4, "hap-") == 0) != isHap(codec)) {
+                continue;  // HAP files only run the HAP backends and the other way round
+            }
+            for (const std::string& indexMode : options.indexModes)
+            for (const std::string& scenario : options.scenarios) {
+                Result result = runScenario(display, options, path, backend, indexMode, scenario, script);
+                if (result.status == "error") {
+                    ++failures;
+                }
+                printResult(path, codec, gop, options, backend, indexMode, scenario, result);
+            }
+        }
+    }
+    return failures == 0 ? 0 : 2;
+#else
+    std::cerr << "bench_seek: built without the headless display (HAVE_DRM_BACKEND)\n";
+    return 1;
+#endif
+}
@@ -0,0 +1,966 @@
+/**
+ * BenchStartup.cpp - Startup and cue-load time benchmark (cuems_videocomposer_bench_startup)
+ *
+ * Measures how long the show takes to come up and how long a cue takes to
+ * be ready. Prints one JSON object per measurement (JSON Lines on stdout,
+ * logging on stderr):
+ *
+ *   {"key":"startup/drm","scenario":"startup","backend":"drm","status":"ok",
+ *    "runs":5,"first_flip_ms":{"p50":412.3,"p90":428.9,"max":431.0},"to_main_ms":18.2,
+ *    "initialize_ms":371.5,"first_render_ms":22.6,
+ *    "phases_ms":{"display":301.2,"layers":88.4,...},"headline_ms":412.3}
+ *
+ * Scenarios:
+ *   startup   Process start to first flip, per display backend: the
+ *             benchmark starts itself as the application (fork/exec), runs
+ *             initialize() and one frame of run(); per-step timings come
+ *             from StartupSequence
+ *   cue-load  One cue at a time through AsyncVideoLoader, per file: request
+ *             to loaded (load_ms) and to its first frame rendered on the
+ *             headless display (first_frame_ms)
+ *   loader    --counts cues requested at once (files of the corpus in
+ *             turn): time until every load completed, loads per second
+ *
+ * cue-load and loader run with a cold and a warm page cache (cold: the
+ * media and cache files dropped with POSIX_FADV_DONTNEED, which needs no
+ * root but keeps pages another process maps) and with the frame index and
+ * probe caches on (filled beforehand, in a private directory) and off.
+ *
+ * Every line has a "key" and a "headline_ms". --history appends the lines
+ * to a file (with --label and the time), --baseline compares each
+ * headline with the last line of the same key in such a file: lines
+ * slower by more than --tolerance percent get "regression":true and the
+ * exit status is 3.
+ */
+
+#include "BenchCommon.h"
+#include "VideoComposerApplication.h"
+#include "config/ConfigurationManager.h"
+#include "input/AsyncVideoLoader.h"
+#include "input/VideoFileInput.h"
+#include "display/DisplayBackend.h"
+#include "display/X11Display.h"
+#include "layer/LayerManager.h"
+#include "layer/VideoLayer.h"
+#include "sync/SyncSource.h"
+#include "utils/Logger.h"
+#ifdef HAVE_WAYLAND
+#include "display/WaylandDisplay.h"
+#endif
+#ifdef HAVE_DRM_BACKEND
+#include "display/HeadlessDisplay.h"
+#include "display/drm/DRMBackend.h"
+#endif
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <ftw.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+using namespace videocomposer;
+using namespace videocomposer::bench;
+
+namespace {
+
+const char* const ALL_BACKENDS[] = {"drm", "wayland", "x11", "headless"};
+const char* const ALL_SCENARIOS[] = {"startup", "cue-load", "loader"};
+const char* const ALL_PAGE_CACHE[] = {"cold", "warm"};
+const char* const ALL_INDEX_CACHE[] = {"off", "on"};
+
+struct Options {
+    std::vector<std::string> files;
+    std::vector<std::string> backends;
+    std::vector<std::string> scenarios;
+    std::vector<std::string> pageCache;
+    std::vector<std::string> indexCache;
+    std::vector<int> counts;
+    std::vector<std::string> appArgs;   // After "--", given to the application
+    int runs = 5;
+    double timeoutMs = 30000.0;
+    std::string history;
+    std::string baseline;
+    std::string label;
+    double tolerancePct = 10.0;
+    bool verbose = false;
+};
+
+// {"p50":..,"p90":..,"max":..} of samples
+std::string spread(const std::vector<double>& samples) {
+    std::ostringstream out;
+    out << "{\"p50\":" << percentile(samples, 0.50)
+        << ",\"p90\":" << percentile(samples, 0.90)
+        << ",\"max\":" << percentile(samples, 1.0) << "}";
+    return out.str();
+}
+
+// Number value of "key" in a one-line JSON object; -1 if absent
+double jsonNumberField(const std::string& line, const char* key) {
+    std::string marker = "\"" + std::string(key) + "\":";
+    size_t pos = line.find(marker);
+    return pos == std::string::npos ? -1.0 : std::atof(line.c_str() + pos + marker.size());
+}
+
+/**
+ * Result lines to stdout, the history file and against the baseline
+ */
+class Report {
+public:
+    bool open(const Options& options) {
+        label_ = options.label;
+        tolerancePct_ = options.tolerancePct;
+        if (!options.baseline.empty()) {
+            std::ifstream baseline(options.baseline);
+            if (!baseline) {
+                std::cerr << "bench_startup: cannot read " << options.baseline << "\n";
+                return false;
+            }
+            std::string line;
+            while (std::getline(baseline, line)) {
+                std::string key = jsonStringField(line, "key");
+                double headline = jsonNumberField(line, "headline_ms");
+                if (!key.empty() && headline > 0.0 && jsonStringField(line, "status") == "ok") {
+                    baseline_[key] = headline;   // Latest run of the key wins
+                }
+            }
+        }
+        if (!options.history.empty()) {
+            history_.open(options.history, std::ios::app);
+            if (!history_) {
+                std::cerr << "bench_startup: cannot write " << options.history << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @param fields ",\"name\":value" pairs after the key
+     * @param headlineMs Compared with the baseline (<= 0: none)
+     */
+    void emit(const std::string& key, const std::string& fields, double headlineMs) {
+        std::ostringstream out;
+        out << "{\"key\":" << jsonString(key) << fields;
+        if (headlineMs > 0.0) {
+            out << ",\"headline_ms\":" << headlineMs;
+            auto base = baseline_.find(key);
+            if (base != baseline_.end()) {
+                double change = (headlineMs - base->second) / base->second * 100.0;
+                out << ",\"baseline_ms\":" << base->second << ",\"change_pct\":" << change;
+                if (change > tolerancePct_) {
+                    out << ",\"regression\":true";
+                    ++regressions_;
+                }
+            }
+        }
+        if (!label_.empty()) {
+            out << ",\"label\":" << jsonString(label_);
+        }
+        out << ",\"time\":" << static_cast<long long>(std::time(nullptr)) << "}";
+        std::cout << out.str() << std::endl;
+        if (history_.is_open()) {
+            history_ << out.str() << std::endl;
+        }
+    }
+
+    int getRegressions() const { return regressions_; }
+
+private:
+    std::map<std::string, double> baseline_;
+    std::ofstream history_;
+    std::string label_;
+    double tolerancePct_ = 10.0;
+    int regressions_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Startup: the benchmark run again as the application
+
+bool backendAvailable(const std::string& backend, std::string& why) {
+#ifndef HAVE_DRM_BACKEND
+    if (backend == "drm" || backend == "headless") {
+        why = "built without HAVE_DRM_BACKEND";
+        return false;
+    }
+#endif
+#ifndef HAVE_WAYLAND
+    if (backend == "wayland") {
+        why = "built without HAVE_WAYLAND";
+        return false;
+    }
+#endif
+    if (backend == "wayland" && !std::getenv("WAYLAND_DISPLAY")) {
+        why = "WAYLAND_DISPLAY not set";
+        return false;
+    }
+    if (backend == "x11" && !std::getenv("DISPLAY")) {
+        why = "DISPLAY not set";
+        return false;
+    }
+    return true;
+}
+
+// Environment that makes the application pick the backend (see initializeDisplay)
+void selectBackend(const std::string& backend) {
+    unsetenv("VIDEOCOMPOSER_HEADLESS");
+    if (backend == "headless") {
+        setenv("VIDEOCOMPOSER_HEADLESS", "1", 1);
+    } else if (backend == "x11") {
+        unsetenv("WAYLAND_DISPLAY");
+    } else if (backend == "drm") {
+        unsetenv("WAYLAND_DISPLAY");
+        unsetenv("DISPLAY");
+    }
+}
+
+const char* backendName(DisplayBackend* display) {
+#ifdef HAVE_DRM_BACKEND
+    if (dynamic_cast<HeadlessDisplay*>(display)) return "headless";
+    if (dynamic_cast<DRMBackend*>(display)) return "drm";
+#endif
+#ifdef HAVE_WAYLAND
+    if (dynamic_cast<WaylandDisplay*>(display)) return "wayland";
+#endif
+    if (dynamic_cast<X11Display*>(display)) return "x11";
+    return "none";
+}
+
+/**
+ * The application side (--child): reports on fd, one record per line
+ *   clock <main> <initialize start> <initialize end> <first flip>  (steady clock, s)
+ *   backend <name>
+ *   step <name> <start ms> <duration ms> <ran> <ok>
+ */
+int runChild(int fd, std::vector<std::string> appArgs, const char* program) {
+    double mainStart = nowSeconds();
+    FILE* report = fdopen(fd, "w");
+    if (!report) {
+        return 1;
+    }
+    // The show journal of the machine is left alone
+    appArgs.insert(appArgs.begin(), "--no-show-journal");
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(program));
+    for (std::string& arg : appArgs) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    int status = 0;
+    {
+        VideoComposerApplication app;
+        double initStart = nowSeconds();
+        if (!app.initialize(static_cast<int>(argv.size()) - 1, argv.data())) {
+            std::fprintf(report, "error initialize failed\n");
+            status = 1;
+        } else {
+            double initEnd = nowSeconds();
+            app.setFrameLimit(1);
+            status = app.run();
+            double flip = nowSeconds();
+            std::fprintf(report, "clock %.6f %.6f %.6f %.6f\n", mainStart, initStart, initEnd, flip);
+            std::fprintf(report, "backend %s\n", backendName(app.getDisplayBackend()));
+            for (const StartupSequence::Timing& timing : app.getStartupTimings()) {
+                std::fprintf(report, "step %s %.3f %.3f %d %d\n", timing.name.c_str(), timing.startMs,
+                             timing.durationMs, timing.ran ? 1 : 0, timing.ok ? 1 : 0);
+            }
+        }
+    }
+    std::fclose(report);
+    return status;
+}
+
+struct StartupRun {
+    std::string error;
+    std::string backend;            // Backend that came up
+    double toMainMs = 0.0;          // exec to main()
+    double initializeMs = 0.0;
+    double firstRenderMs = 0.0;     // initialize() end to first flip
+    double firstFlipMs = 0.0;       // exec to first flip
+    std::vector<std::pair<std::string, double>> steps;
+};
+
+// Start the application once; the steady clock is system-wide (CLOCK_MONOTONIC)
+bool spawnStartup(const std::string& backend, const Options& options, const char* program, StartupRun& run) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        run.error = std::strerror(errno);
+        return false;
+    }
+    double spawn = nowSeconds();
+    pid_t pid = fork();
+    if (pid < 0) {
+        run.error = std::strerror(errno);
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(STDERR_FILENO, STDOUT_FILENO);   // Application output stays off the results
+        selectBackend(backend);
+        std::vector<std::string> args = {program, "--child", backend, std::to_string(fds[1]), "--"};
+        args.insert(args.end(), options.appArgs.begin(), options.appArgs.end());
+        if (options.verbose) {
+            args.insert(args.begin() + 1, "--verbose");
+        }
+        std::vector<char*> argv;
+        for (std::string& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        argv.push_back(nullptr);
+        execv("/proc/self/exe", argv.data());
+        _exit(127);
+    }
+    close(fds[1]);
+
+    std::string output;
+    double deadline = spawn + options.timeoutMs / 1000.0;
+    bool timedOut = false;
+    char buffer[4096];
+    while (true) {
+        int waitMs = static_cast<int>((deadline - nowSeconds()) * 1000.0);
+        if (waitMs <= 0) {
+            timedOut = true;
+            break;
+        }
+        pollfd readable = {fds[0], POLLIN, 0};
+        if (poll(&readable, 1, waitMs) <= 0) {
+            continue;
+        }
+        ssize_t got = read(fds[0], buffer, sizeof(buffer));
+        if (got <= 0) {
+            break;
+        }
+        output.append(buffer, static_cast<size_t>(got));
+    }
+    close(fds[0]);
+    if (timedOut) {
+        kill(pid, SIGKILL);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (timedOut) {
+        run.error = "no first flip in time";
+        return false;
+    }
+
+    std::istringstream lines(output);
+    std::string line;
+    bool clock = false;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string record;
+        fields >> record;
+        if (record == "clock") {
+            double mainStart, initStart, initEnd, flip;
+            if (fields >> mainStart >> initStart >> initEnd >> flip) {
+                run.toMainMs = (mainStart - spawn) * 1000.0;
+                run.initializeMs = (initEnd - initStart) * 1000.0;
+                run.firstRenderMs = (flip - initEnd) * 1000.0;
+                run.firstFlipMs = (flip - spawn) * 1000.0;
+                clock = true;
+            }
+        } else if (record == "backend") {
+            fields >> run.backend;
+        } else if (record == "step") {
+            std::string name;
+            double start, duration;
+            int ran, ok;
+            if (fields >> name >> start >> duration >> ran >> ok && ran) {
+                run.steps.emplace_back(name, duration);
+            }
+        } else if (record == "error") {
+            std::getline(fields >> std::ws, run.error);
+        }
+    }
+    if (!clock) {
+        if (run.error.empty()) {
+            run.error = WIFSIGNALED(status) ? "application crashed" : "application failed to start";
+        }
+        return false;
+    }
+    return true;
+}
+
+// Adds the failures
+int benchStartup(const Options& options, const char* program, Report& report) {
+    int failures = 0;
+    for (const std::string& backend : options.backends) {
+        std::string key = "startup/" + backend;
+        std::string fields = ",\"scenario\":\"startup\",\"backend\":\"" + backend + "\"";
+        std::string why;
+        if (!backendAvailable(backend, why)) {
+            report.emit(key, fields + ",\"status\":\"unavailable\",\"error\":" + jsonString(why), 0.0);
+            continue;
+        }
+
+        std::vector<double> firstFlip, toMain, initialize, firstRender;
+        std::vector<std::string> stepOrder;
+        std::map<std::string, std::vector<double>> steps;
+        std::string error;
+        bool fellBack = false;
+        for (int i = 0; i < options.runs; ++i) {
+            StartupRun run;
+            if (!spawnStartup(backend, options, program, run)) {
+                error = run.error;
+                break;
+            }
+            if (run.backend != backend) {
+                // DRM without a free output comes up headless
+                error = "came up as " + run.backend;
+                fellBack = true;
+                break;
+            }
+            firstFlip.push_back(run.firstFlipMs);
+            toMain.push_back(run.toMainMs);
+            initialize.push_back(run.initializeMs);
+            firstRender.push_back(run.firstRenderMs);
+            for (const auto& step : run.steps) {
+                if (steps.find(step.first) == steps.end()) {
+                    stepOrder.push_back(step.first);
+                }
+                steps[step.first].push_back(step.second);
+            }
+        }
+        if (firstFlip.empty()) {
+            if (!fellBack) {
+                ++failures;
+            }
+            report.emit(key, fields + ",\"status\":\"" + (fellBack ? "unavailable" : "error") +
+                        "\",\"error\":" + jsonString(error), 0.0);
+            continue;
+        }
+
+        std::ostringstream out;
+        out << fields << ",\"status\":\"ok\",\"runs\":" << firstFlip.size()
+            << ",\"first_flip_ms\":" << spread(firstFlip)
+            << ",\"to_main_ms\":" << percentile(toMain, 0.50)
+            << ",\"initialize_ms\":" << percentile(initialize, 0.50)
+            << ",\"first_render_ms\":" << percentile(firstRender, 0.50)
+            << ",\"phases_ms\":{";
+        for (size_t i = 0; i < stepOrder.size(); ++i) {
+            out << (i ? "," : "") << jsonString(stepOrder[i]) << ":" << percentile(steps[stepOrder[i]], 0.50);
+        }
+        out << "}";
+        if (!error.empty()) {
+            out << ",\"error\":" << jsonString(error);
+        }
+        report.emit(key, out.str(), percentile(firstFlip, 0.50));
+    }
+    return failures;
+}
+
+#if defined(HAVE_DRM_BACKEND)
+
+// ---------------------------------------------------------------------------
+// Cue loads through AsyncVideoLoader
+
+// Drop the file's pages (cold page cache)
+void evictFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// Read the whole file (warm page cache)
+void readFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    std::vector<char> buffer(1 << 20);
+    while (read(fd, buffer.data(), buffer.size()) > 0) {}
+    close(fd);
+}
+
+int evictEntry(const char* path, const struct stat* info, int type, FTW* ftw) {
+    (void)info;
+    (void)ftw;
+    if (type == FTW_F) {
+        evictFile(path);
+    }
+    return 0;
+}
+
+int removeEntry(const char* path, const struct stat* info, int type, FTW* ftw) {
+    (void)info;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+/**
+ * Sync source held at frame 0: the first frame of the cue
+ */
+class HeldClock : public SyncSource {
+public:
+    bool connect(const char* param = nullptr) override { (void)param; return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        if (rolling) {
+            *rolling = 0;
+        }
+        return 0;
+    }
+    int64_t getCurrentFrame() const override { return 0; }
+    const char* getName() const override { return "Held"; }
+};
+
+/**
+ * An AsyncVideoLoader with the index and probe caches on or off
+ */
+class LoadRun {
+public:
+    LoadRun(HeadlessDisplay& display, const Options& options, bool indexCache, const std::string& cacheDir)
+        : display_(display), options_(options) {
+        config_.setBool("index_cache", indexCache);
+        config_.setString("index_cache_dir", cacheDir);
+        display_.makeCurrent();
+        loader_.initialize(&config_, &display_);
+    }
+
+    ~LoadRun() {
+        loader_.shutdown();
+        display_.makeCurrent();
+        inputs_.clear();
+    }
+
+    size_t getWorkers() const { return loader_.workerCount(); }
+
+    // Index build and one load, untimed: the caches hold the files
+    void fillCaches(const std::vector<std::string>& files) {
+        loader_.requestIndexPrewarm(files);
+        double start = nowSeconds();
+        while (loader_.pendingCount() > 0 && elapsedMs(start) < options_.timeoutMs) {
+            usleep(1000);
+        }
+        std::vector<double> latencies;
+        int failed = 0;
+        loadAll(files, latencies, failed);
+        release();
+    }
+
+    /**
+     * Request every file at once (one cue each), wait for all of them
+     * @param latencies Request to loaded, per successful cue (ms)
+     * @return Until the last completed (ms), -1 on timeout
+     */
+    double loadAll(const std::vector<std::string>& files, std::vector<double>& latencies, int& failed) {
+        size_t done = 0;
+        double start = nowSeconds();
+        for (const std::string& path : files) {
+            loader_.requestLoad("bench-" + std::to_string(nextCue_++), path,
+                [this, start, &latencies, &failed, &done](const std::string&, const std::string&,
+                                                          std::unique_ptr<InputSource> input, bool success) {
+                    ++done;
+                    if (success && input) {
+                        latencies.push_back(elapsedMs(start));
+                        inputs_.push_back(std::move(input));
+                    } else {
+                        ++failed;
+                    }
+                });
+        }
+        while (done < files.size()) {
+            if (elapsedMs(start) > options_.timeoutMs) {
+                return -1.0;
+            }
+            display_.makeCurrent();
+            if (loader_.pollCompleted() == 0) {
+                usleep(1000);
+            }
+        }
+        return elapsedMs(start);
+    }
+
+    /**
+     * Show the first loaded input on a layer until its frame 0 is rendered
+     * @return false on timeout
+     */
+    bool showFirst(double start) {
+        if (inputs_.empty()) {
+            return false;
+        }
+        display_.makeCurrent();
+        LayerManager layers;
+        auto layer = std::make_unique<VideoLayer>();
+        layer->setInputSource(std::move(inputs_.front()));
+        layer->setSyncSource(std::make_unique<HeldClock>());
+        VideoLayer* shown = layers.getLayer(layers.addLayer(std::move(layer)));
+        while (shown) {
+            display_.makeCurrent();
+            layers.updateAll();
+            display_.render(&layers);
+            display_.makeCurrent();
+            glFinish();
+            if (shown->getLoadedFrame() == 0) {
+                return true;
+            }
+            if (elapsedMs(start) > options_.timeoutMs) {
+                break;
+            }
+        }
+        return false;
+    }
+
+    // Close the loaded inputs
+    void release() {
+        display_.makeCurrent();
+        inputs_.clear();
+    }
+
+private:
+    static double elapsedMs(double start) { return (nowSeconds() - start) * 1000.0; }
+
+    HeadlessDisplay& display_;
+    const Options& options_;
+    ConfigurationManager config_;
+    AsyncVideoLoader loader_;
+    std::vector<std::unique_ptr<InputSource>> inputs_;
+    uint64_t nextCue_ = 0;
+};
+
+// Page cache state before a timed load
+void prepareFiles(const std::vector<std::string>& files, const std::string& pageCache, const std::string& cacheDir) {
+    for (const std::string& path : files) {
+        if (pageCache == "cold") {
+            evictFile(path);
+        } else {
+            readFile(path);
+        }
+    }
+    if (pageCache == "cold") {
+        nftw(cacheDir.c_str(), evictEntry, 16, FTW_PHYS);
+    }
+}
+
+// Fresh cache directory per run: "off" leaves it empty, "on" fills it first
+bool resetCacheDir(const std::string& cacheDir) {
+    nftw(cacheDir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return mkdir(cacheDir.c_str(), 0700) == 0;
+}
+
+std::string containerName(const std::string& path) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    return dot == std::string::npos || (slash != std::string::npos && dot < slash) ? "" : path.substr(dot + 1);
+}
+
+int benchCueLoad(HeadlessDisplay& display, const Options& options, const std::string& cacheDir, Report& report) {
+    int failures = 0;
+    for (const std::string& path : options.files) {
+        VideoFileInput probe;
+        probe.setBackgroundIndexing(false);
+        probe.setIndexCache(false);
+        probe.setNoIndex(true);
+        probe.setHardwareDecodePreference(VideoFileInput::HardwareDecodePreference::SOFTWARE_ONLY);
+        InputSource::CodecType codec = InputSource::CodecType::SOFTWARE;
+        bool video = probe.open(path);
+        if (video) {
+            codec = probe.detectCodec();
+            probe.close();
+        }
+
+        for (const std::string& pageCache : options.pageCache)
+        for (const std::string& indexCache : options.indexCache) {
+            std::string key = "cue-load/" + path + "/" + pageCache + "/" + indexCache;
+            std::ostringstream fields;
+            fields << ",\"scenario\":\"cue-load\",\"file\":" << jsonString(path)
+                   << ",\"codec\":\"" << codecName(codec) << "\""
+                   << ",\"container\":" << jsonString(containerName(path))
+                   << ",\"page_cache\":\"" << pageCache << "\",\"index_cache\":\"" << indexCache << "\"";
+            if (!video) {
+                ++failures;
+                report.emit(key, fields.str() + ",\"status\":\"error\",\"error\":\"not a video file\"", 0.0);
+                continue;
+            }
+            if (!resetCacheDir(cacheDir)) {
+                ++failures;
+                report.emit(key, fields.str() + ",\"status\":\"error\",\"error\":\"no cache directory\"", 0.0);
+                continue;
+            }
+
+            LoadRun run(display, options, indexCache == "on", cacheDir);
+            if (indexCache == "on") {
+                run.fillCaches({path});
+            }
+            std::vector<double> loads, firstFrames;
+            std::string error;
+            for (int i = 0; i < options.runs; ++i) {
+                prepareFiles({path}, pageCache, cacheDir);
+                std::vector<double> latencies;
+                int failed = 0;
+                double start = nowSeconds();
+                if (run.loadAll({path}, latencies, failed) < 0.0 || latencies.empty()) {
+                    error = failed ? "load failed" : "not loaded in time";
+                    break;
+                }
+                if (!run.showFirst(start)) {
+                    error = "first frame not shown";
+                    run.release();
+                    break;
+                }
+                loads.push_back(latencies.front());
+                firstFrames.push_back((nowSeconds() - start) * 1000.0);
+                run.release();
+            }
+            if (firstFrames.empty()) {
+                ++failures;
+                report.emit(key, fields.str() + ",\"status\":\"error\",\"error\":" + jsonString(error), 0.0);
+                continue;
+            }
+            fields << ",\"status\":\"ok\",\"runs\":" << firstFrames.size()
+                   << ",\"load_ms\":" << spread(loads)
+                   << ",\"first_frame_ms\":" << spread(firstFrames);
+            if (!error.empty()) {
+                fields << ",\"error\":" << jsonString(error);
+            }
+            report.emit(key, fields.str(), percentile(firstFrames, 0.50));
+        }
+    }
+    return failures;
+}
+
+int benchLoader(HeadlessDisplay& display, const Options& options, const std::string& cacheDir, Report& report) {
+    int failures = 0;
+    for (int count : options.counts) {
+        // The corpus in turn: several cues of a file share its open
+        std::vector<std::string> cues;
+        for (int i = 0; i < count; ++i) {
+            cues.push_back(options.files[static_cast<size_t>(i) % options.files.size()]);
+        }
+        for (const std::string& pageCache : options.pageCache)
+        for (const std::string& indexCache : options.indexCache) {
+            std::string key = "loader/" + std::to_string(count) + "/" + pageCache + "/" + indexCache;
+            std::ostringstream fields;
+            fields << ",\"scenario\":\"loader\",\"cues\":" << count
+                   << ",\"files\":" << std::min<size_t>(cues.size(), options.files.size())
+                   << ",\"page_cache\":\"" << pageCache << "\",\"index_cache\":\"" << indexCache << "\"";
+            if (!resetCacheDir(cacheDir)) {
+                ++failures;
+                report.emit(key, fields.str() + ",\"status\":\"error\",\"error\":\"no cache directory\"", 0.0);
+                continue;
+            }
+
+            LoadRun run(display, options, indexCache == "on", cacheDir);
+            if (indexCache == "on") {
+                run.fillCaches(std::vector<std::string>(cues.begin(), cues.begin() +
+                               std::min<size_t>(cues.size(), options.files.size())));
+            }
+            prepareFiles(cues, pageCache, cacheDir);
+            std::vector<double> latencies;
+            int failed = 0;
+            double totalMs = run.loadAll(cues, latencies, failed);
+            run.release();
+            fields << ",\"workers\":" << run.getWorkers();
+            if (totalMs < 0.0 || latencies.empty()) {
+                ++failures;
+                report.emit(key, fields.str() + ",\"status\":\"error\",\"error\":" +
+                            jsonString(totalMs < 0.0 ? "loads not done in time" : "every load failed"), 0.0);
+                continue;
+            }
+            fields << ",\"status\":\"ok\",\"failed\":" << failed
+                   << ",\"total_ms\":" << totalMs
+                   << ",\"loads_per_s\":" << latencies.size() / (totalMs / 1000.0)
+                   << ",\"latency_ms\":{\"p50\":" << percentile(latencies, 0.50)
+                   << ",\"p99\":" << percentile(latencies, 0.99)
+                   << ",\"max\":" << percentile(latencies, 1.0) << "}";
+            if (failed > 0) {
+                ++failures;
+            }
+            report.emit(key, fields.str(), totalMs);
+        }
+    }
+    return failures;
+}
+
+#endif // HAVE_DRM_BACKEND
+
+// ---------------------------------------------------------------------------
+
+template <size_t N>
+bool parseNames(const char* text, const char* const (&known)[N], std::vector<std::string>& names) {
+    std::stringstream list(text);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        if (std::find(std::begin(known), std::end(known), name) == std::end(known)) {
+            std::cerr << "bench_startup: unknown name " << name << "\n";
+            return false;
+        }
+        names.push_back(name);
+    }
+    return true;
+}
+
+bool parseCounts(const char* text, std::vector<int>& counts) {
+    std::stringstream list(text);
+    std::string count;
+    while (std::getline(list, count, ',')) {
+        int value = std::atoi(count.c_str());
+        if (value <= 0) {
+            std::cerr << "bench_startup: bad count " << count << "\n";
+            return false;
+        }
+        counts.push_back(value);
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] [<file|directory|manifest>...] [-- application options]\n"
+              << "  --scenarios LIST  Subset of: startup, cue-load, loader (default: all)\n"
+              << "  --backends LIST   Subset of: drm, wayland, x11, headless (default: all)\n"
+              << "  --page-cache LIST Subset of: cold, warm (default: both)\n"
+              << "  --index-cache LIST Subset of: off, on (default: both)\n"
+              << "  --counts LIST     Cues loaded at once (default 10,50,100)\n"
+              << "  --runs N          Runs per startup and cue-load measurement (default 5)\n"
+              << "  --timeout-ms MS   Give up on a start or a load after MS (default 30000)\n"
+              << "  --history FILE    Append the results to FILE\n"
+              << "  --baseline FILE   Compare with the last result of each key in FILE\n"
+              << "  --tolerance PCT   Slower than the baseline by more is a regression (default 10)\n"
+              << "  --label TEXT      Stored with the results (e.g. the commit)\n"
+              << "  --verbose         Log decoder and application messages (stderr)\n"
+              << "The cue-load and loader scenarios need media files. Prints one JSON object\n"
+              << "per measurement on stdout; exit status 3 on a regression.\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--") {
+            options.appArgs.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg == "--scenarios" && hasValue) {
+            if (!parseNames(argv[++i], ALL_SCENARIOS, options.scenarios)) return false;
+        } else if (arg == "--backends" && hasValue) {
+            if (!parseNames(argv[++i], ALL_BACKENDS, options.backends)) return false;
+        } else if (arg == "--page-cache" && hasValue) {
+            if (!parseNames(argv[++i], ALL_PAGE_CACHE, options.pageCache)) return false;
+        } else if (arg == "--index-cache" && hasValue) {
+            if (!parseNames(argv[++i], ALL_INDEX_CACHE, options.indexCache)) return false;
+        } else if (arg == "--counts" && hasValue) {
+            if (!parseCounts(argv[++i], options.counts)) return false;
+        } else if (arg == "--runs" && hasValue) {
+            options.runs = std::max(std::atoi(argv[++i]), 1);
+        } else if (arg == "--timeout-ms" && hasValue) {
+            options.timeoutMs = std::max(std::atof(argv[++i]), 1.0);
+        } else if (arg == "--history" && hasValue) {
+            options.history = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baseline = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            options.tolerancePct = std::max(std::atof(argv[++i]), 0.0);
+        } else if (arg == "--label" && hasValue) {
+            options.label = argv[++i];
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            addCorpus("bench_startup", arg, options.files);
+        }
+    }
+    if (options.scenarios.empty()) {
+        options.scenarios.assign(std::begin(ALL_SCENARIOS), std::end(ALL_SCENARIOS));
+    }
+    if (options.backends.empty()) {
+        options.backends.assign(std::begin(ALL_BACKENDS), std::end(ALL_BACKENDS));
+    }
+    if (options.pageCache.empty()) {
+        options.pageCache.assign(std::begin(ALL_PAGE_CACHE), std::end(ALL_PAGE_CACHE));
+    }
+    if (options.indexCache.empty()) {
+        options.indexCache.assign(std::begin(ALL_INDEX_CACHE), std::end(ALL_INDEX_CACHE));
+    }
+    if (options.counts.empty()) {
+        options.counts = {10, 50, 100};
+    }
+    return true;
+}
+
+bool wants(const Options& options, const char* scenario) {
+    return std::find(options.scenarios.begin(), options.scenarios.end(), scenario) != options.scenarios.end();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Started by the startup scenario: [--verbose] --child BACKEND FD -- application options
+    int first = argc > 1 && std::string(argv[1]) == "--verbose" ? 2 : 1;
+    if (argc > first + 3 && std::string(argv[first]) == "--child" && std::string(argv[first + 3]) == "--") {
+        Logger::getInstance().setLevel(first == 2 ? Logger::INFO : Logger::WARNING);
+        return runChild(std::atoi(argv[first + 2]),
+                        std::vector<std::string>(argv + first + 4, argv + argc), argv[0]);
+    }
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // INFO goes to stdout, which carries the results
+    Logger::getInstance().setLevel(options.verbose ? Logger::INFO : Logger::WARNING);
+
+    Report report;
+    if (!report.open(options)) {
+        return 1;
+    }
+    int failures = 0;
+    // Before this process holds a GL context of its own
+    if (wants(options, "startup")) {
+        failures += benchStartup(options, argv[0], report);
+    }
+
+    bool loads = wants(options, "cue-load") || wants(options, "loader");
+    if (loads && options.files.empty()) {
+        std::cerr << "bench_startup: cue-load and loader need media files\n";
+        return failures > 0 ? 2 : 1;
+    }
+    if (loads) {
+#ifdef HAVE_DRM_BACKEND
+        HeadlessDisplay display;
+        display.setDimensions(1920, 1080);
+        if (!display.openWindow()) {
+            std::cerr << "bench_startup: no headless GL context (render node, EGL)\n";
+            return 1;
+        }
+        char cacheTemplate[] = "/tmp/bench_startup.XXXXXX";
+        if (!mkdtemp(cacheTemplate)) {
+            std::cerr << "bench_startup: no temporary directory\n";
+            return 1;
+        }
+        std::string cacheDir = std::string(cacheTemplate) + "/cache";
+        if (wants(options, "cue-load")) {
+            failures += benchCueLoad(display, options, cacheDir, report);
+        }
+        if (wants(options, "loader")) {
+            failures += benchLoader(display, options, cacheDir, report);
+        }
+        nftw(cacheTemplate, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+#else
+        std::cerr << "bench_startup: built without the headless display (HAVE_DRM_BACKEND)\n";
+        return 1;
+#endif
+    }
+    if (failures > 0) {
+        return 2;
+    }
+    return report.getRegressions() == 0 ? 0 : 3;
+}
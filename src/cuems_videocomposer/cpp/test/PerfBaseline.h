@@ -0,0 +1,167 @@
+#ifndef VIDEOCOMPOSER_PERFBASELINE_H
+#define VIDEOCOMPOSER_PERFBASELINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#ifndef VIDEOCOMPOSER_PERF_BASELINE_FILE
+#define VIDEOCOMPOSER_PERF_BASELINE_FILE "perf_baseline.txt"
+#endif
+
+namespace videocomposer {
+namespace test {
+
+/**
+ * PerfBaseline - Stored timings of the performance tests
+ *
+ * A performance test times one operation (nanoseconds, the fastest of RUNS
+ * timed runs) and fails when it is more than the tolerance slower than its
+ * baseline. Baselines belong to one machine and build type: a text file of
+ * "name ns" lines, VIDEOCOMPOSER_PERF_BASELINE or test/perf_baseline.txt in
+ * the source tree. A test without a baseline passes and prints its time;
+ * VIDEOCOMPOSER_PERF_RECORD=1 makes the run's times the new baselines.
+ * VIDEOCOMPOSER_PERF_TOLERANCE is the tolerance in percent (default 25).
+ */
+class PerfBaseline {
+public:
+    static constexpr int RUNS = 5;
+    static constexpr double MIN_RUN_SECONDS = 0.02;  // Iterations double until a run lasts this long
+
+    static PerfBaseline& instance() {
+        static PerfBaseline inst;
+        return inst;
+    }
+
+    /**
+     * Time an operation
+     * @param body Called as body(iterations); runs the operation that often
+     * @return Nanoseconds per operation
+     */
+    template <typename Body>
+    static double measure(Body&& body) {
+        using Clock = std::chrono::steady_clock;
+        uint64_t iterations = 1;
+        double seconds = 0.0;
+        for (;;) {
+            Clock::time_point start = Clock::now();
+            body(iterations);
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (seconds >= MIN_RUN_SECONDS || iterations >= (uint64_t(1) << 40)) {
+                break;
+            }
+            iterations *= 2;
+        }
+        double best = seconds;
+        for (int run = 1; run < RUNS; ++run) {
+            Clock::time_point start = Clock::now();
+            body(iterations);
+            best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+        }
+        return best * 1e9 / static_cast<double>(iterations);
+    }
+
+    /**
+     * Compare a time with its baseline
+     * @return false if it is more than the tolerance slower
+     */
+    bool check(const std::string& name, double nsPerOp) {
+        measured_[name] = nsPerOp;
+        auto it = baselines_.find(name);
+        char line[200];
+        if (record_ || it == baselines_.end() || it->second <= 0.0) {
+            std::snprintf(line, sizeof(line), "  %s: %.2f ns/op%s", name.c_str(), nsPerOp,
+                          record_ ? " (recorded)" : " (no baseline)");
+            std::cout << line << "\n";
+            return true;
+        }
+        double change = (nsPerOp / it->second - 1.0) * 100.0;
+        std::snprintf(line, sizeof(line), "  %s: %.2f ns/op, baseline %.2f (%+.1f%%)",
+                      name.c_str(), nsPerOp, it->second, change);
+        std::cout << line << "\n";
+        if (change > tolerance_) {
+            std::cerr << "Performance regression: " << name << " " << change
+                      << "% slower than its baseline (tolerance " << tolerance_ << "%)\n";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Write the times of this run as baselines (VIDEOCOMPOSER_PERF_RECORD=1)
+     */
+    bool save() const {
+        if (!record_ || measured_.empty()) {
+            return true;
+        }
+        std::map<std::string, double> merged = baselines_;
+        for (const auto& entry : measured_) {
+            merged[entry.first] = entry.second;
+        }
+        std::ofstream out(path_);
+        if (!out) {
+            std::cerr << "Cannot write performance baselines to " << path_ << "\n";
+            return false;
+        }
+        out << "# Performance test baselines: name, nanoseconds per operation\n"
+            << "# Rewritten by VIDEOCOMPOSER_PERF_RECORD=1 cuems_videocomposer_test --perf\n";
+        for (const auto& entry : merged) {
+            char line[200];
+            std::snprintf(line, sizeof(line), "%s %.3f\n", entry.first.c_str(), entry.second);
+            out << line;
+        }
+        std::cout << "Recorded " << measured_.size() << " baseline(s) in " << path_ << "\n";
+        return true;
+    }
+
+private:
+    PerfBaseline() : tolerance_(25.0), record_(false) {
+        const char* path = std::getenv("VIDEOCOMPOSER_PERF_BASELINE");
+        path_ = path && *path ? path : VIDEOCOMPOSER_PERF_BASELINE_FILE;
+        if (const char* tolerance = std::getenv("VIDEOCOMPOSER_PERF_TOLERANCE")) {
+            tolerance_ = std::max(0.0, std::atof(tolerance));
+        }
+        const char* record = std::getenv("VIDEOCOMPOSER_PERF_RECORD");
+        record_ = record && std::string(record) == "1";
+
+        std::ifstream in(path_);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string name;
+            double ns = 0.0;
+            if (line.empty() || line[0] == '#' || !(fields >> name >> ns)) {
+                continue;
+            }
+            baselines_[name] = ns;
+        }
+    }
+
+    std::string path_;
+    double tolerance_;
+    bool record_;
+    std::map<std::string, double> baselines_;
+    std::map<std::string, double> measured_;
+};
+
+// Keeps a computed value alive so the timed loop is not optimized away
+// (a compiler barrier: the value's memory counts as read, no store)
+template <typename T>
+inline void keepValue(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+#define TEST_ASSERT_PERF(name, nsPerOp) \
+    TEST_ASSERT(videocomposer::test::PerfBaseline::instance().check(name, nsPerOp))
+
+} // namespace test
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PERFBASELINE_H
@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "../display/AdvancedBlend.h"
+#include "../display/VideoShaders.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_AdvancedBlend_ChoosePath() {
+    AdvancedBlend::Capabilities caps;
+    TEST_ASSERT(AdvancedBlend::choosePath(caps) == AdvancedBlend::Path::COPY_BOUNDS);
+
+    // Barriers cost a little: fetch goes first unless the equations are coherent
+    caps.blendEquation = true;
+    TEST_ASSERT(AdvancedBlend::choosePath(caps) == AdvancedBlend::Path::BLEND_EQUATION);
+    caps.framebufferFetch = true;
+    TEST_ASSERT(AdvancedBlend::choosePath(caps) == AdvancedBlend::Path::FRAMEBUFFER_FETCH);
+    caps.coherent = true;
+    TEST_ASSERT(AdvancedBlend::choosePath(caps) == AdvancedBlend::Path::BLEND_EQUATION);
+
+    TEST_ASSERT_FALSE(AdvancedBlend::readsDestination(LayerProperties::NORMAL));
+    TEST_ASSERT_TRUE(AdvancedBlend::readsDestination(LayerProperties::OVERLAY));
+    return true;
+}
+
+bool test_AdvancedBlend_LayerBounds() {
+    float mvp[16] = {};
+    mvp[0] = mvp[5] = mvp[10] = mvp[15] = 1.0f;
+    AdvancedBlend::Region viewport;
+    viewport.x = 100;
+    viewport.y = 50;
+    viewport.width = 1920;
+    viewport.height = 1080;
+
+    // Full-viewport quad: all of it
+    AdvancedBlend::Region bounds;
+    TEST_ASSERT_TRUE(AdvancedBlend::layerBounds(mvp, nullptr, viewport, bounds));
+    TEST_ASSERT_EQ(bounds.x, 100);
+    TEST_ASSERT_EQ(bounds.y, 50);
+    TEST_ASSERT_EQ(bounds.width, 1920);
+    TEST_ASSERT_EQ(bounds.height, 1080);
+
+    // Quarter-size layer in the top right: its box plus a pixel each side
+    mvp[0] = mvp[5] = 0.25f;
+    mvp[12] = 0.5f;
+    mvp[13] = 0.5f;
+    TEST_ASSERT_TRUE(AdvancedBlend::layerBounds(mvp, nullptr, viewport, bounds));
+    TEST_ASSERT_EQ(bounds.x, 100 + 1200 - 1);
+    TEST_ASSERT_EQ(bounds.y, 50 + 675 - 1);
+    TEST_ASSERT_EQ(bounds.width, 480 + 2);
+    TEST_ASSERT_EQ(bounds.height, 270 + 2);
+
+    // Homography first: squeezed to the left half of the quad
+    float homography[16] = {};
+    homography[0] = 0.5f;
+    homography[12] = -0.5f;
+    homography[5] = homography[10] = homography[15] = 1.0f;
+    TEST_ASSERT_TRUE(AdvancedBlend::layerBounds(mvp, homography, viewport, bounds));
+    TEST_ASSERT_EQ(bounds.x, 100 + 1200 - 1);
+    TEST_ASSERT_EQ(bounds.width, 240 + 2);
+
+    // Clipped at the viewport edge, nothing when fully outside
+    mvp[12] = 1.0f;
+    TEST_ASSERT_TRUE(AdvancedBlend::layerBounds(mvp, nullptr, viewport, bounds));
+    TEST_ASSERT_EQ(bounds.x + bounds.width, 100 + 1920);
+    mvp[12] = 3.0f;
+    TEST_ASSERT_FALSE(AdvancedBlend::layerBounds(mvp, nullptr, viewport, bounds));
+
+    // Behind the eye: no finite box, the whole viewport
+    mvp[12] = 0.0f;
+    mvp[15] = -1.0f;
+    TEST_ASSERT_TRUE(AdvancedBlend::layerBounds(mvp, nullptr, viewport, bounds));
+    TEST_ASSERT_EQ(bounds.width, 1920);
+    return true;
+}
+
+bool test_AdvancedBlend_Shaders() {
+    // Extension directives stay ahead of the GLES precisions
+    std::string preamble = "#extension GL_EXT_shader_framebuffer_fetch : require\n#define BLEND_FETCH\n";
+    std::string fetch = VideoShaders::specialize(VideoShaders::FRAGMENT_RGBA, VideoShaders::FEATURE_ADVANCED_BLEND,
+                                                 preamble);
+    TEST_ASSERT(fetch.find("#extension") < fetch.find("#define USE_ADVANCED_BLEND\n"));
+    std::string es = VideoShaders::forGLES(fetch);
+    TEST_ASSERT(es.find("#version 300 es\n#extension GL_EXT_shader_framebuffer_fetch") != std::string::npos);
+    TEST_ASSERT(es.find("precision highp float;") > es.find("#extension"));
+    TEST_ASSERT(es.find("#define BLEND_FETCH") > es.find("precision highp sampler3D;"));
+
+    // Every layer format ends in blendOutput()
+    const std::string sources[] = {VideoShaders::FRAGMENT_RGBA, VideoShaders::FRAGMENT_NV12,
+                                   VideoShaders::FRAGMENT_YUV420P, VideoShaders::FRAGMENT_UYVY};
+    for (const std::string& source : sources) {
+        TEST_ASSERT(source.find("FragColor = blendOutput(") != std::string::npos);
+    }
+    return true;
+}
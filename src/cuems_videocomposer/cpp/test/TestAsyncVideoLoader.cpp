@@ -0,0 +1,55 @@
+#include "TestFramework.h"
+#include "../input/AsyncVideoLoader.h"
+#include "../config/ConfigurationManager.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_AsyncVideoLoader_Priority() {
+    using Priority = AsyncVideoLoader::Priority;
+    ConfigurationManager config;
+    config.setInt("loader_threads", 1);  // Serve requests one at a time, in queue order
+
+    std::vector<std::string> completed;
+    auto record = [&completed](const std::string& cueId, const std::string& filepath,
+                               std::unique_ptr<InputSource>, bool success) {
+        completed.push_back(cueId + ":" + filepath + (success ? ":ok" : ":fail"));
+    };
+
+    // Queue before the worker starts so the order is deterministic
+    AsyncVideoLoader loader;
+    loader.requestLoad("a", "/nonexistent/a.mov", record);
+    loader.requestLoad("b", "/nonexistent/b.mov", record, Priority::NEXT);
+    loader.requestLoad("c", "/nonexistent/c.mov", record, Priority::BACKGROUND);
+    loader.requestLoad("d", "/nonexistent/d1.mov", record);
+    loader.requestLoad("d", "/nonexistent/d2.mov", record);  // Supersedes d1
+    loader.requestLoad("a", "/nonexistent/a.mov", record);   // Already pending
+    loader.requestLoad("e", "/nonexistent/e.mov", record);
+    loader.cancelLoad("e");
+    TEST_ASSERT_EQ(loader.pendingCount(), static_cast<size_t>(4));
+    TEST_ASSERT_TRUE(loader.isLoadPending("d"));
+    TEST_ASSERT_FALSE(loader.isLoadPending("e"));
+
+    // c goes from background to ahead of every normal load
+    TEST_ASSERT_TRUE(loader.setPriority("c", Priority::NEXT));
+    TEST_ASSERT_FALSE(loader.setPriority("e", Priority::NEXT));
+
+    loader.initialize(&config, nullptr);
+    TEST_ASSERT_EQ(loader.workerCount(), static_cast<size_t>(1));
+    for (int i = 0; i < 500 && loader.pendingCount() > 0; ++i) {
+        loader.pollCompleted();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    loader.shutdown();
+
+    TEST_ASSERT_EQ(completed.size(), static_cast<size_t>(4));
+    TEST_ASSERT_EQ(completed[0], std::string("b:/nonexistent/b.mov:fail"));
+    TEST_ASSERT_EQ(completed[1], std::string("c:/nonexistent/c.mov:fail"));
+    TEST_ASSERT_EQ(completed[2], std::string("a:/nonexistent/a.mov:fail"));
+    TEST_ASSERT_EQ(completed[3], std::string("d:/nonexistent/d2.mov:fail"));
+    return true;
+}
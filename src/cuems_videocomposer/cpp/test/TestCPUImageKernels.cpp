@@ -0,0 +1,213 @@
+#include "TestFramework.h"
+#include "../display/CPUImageKernels.h"
+#include "../display/CPUImageProcessor.h"
+#include "../video/FrameBuffer.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+FrameBuffer makeBgraFrame(int width, int height) {
+    FrameInfo info;
+    info.width = width;
+    info.height = height;
+    info.format = PixelFormat::BGRA32;
+    FrameBuffer frame;
+    frame.allocate(info);
+    uint32_t seed = 12345;
+    uint8_t* data = frame.data();
+    for (size_t i = 0; i < frame.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = static_cast<uint8_t>(seed >> 24);
+    }
+    return frame;
+}
+
+const uint8_t* pixelAt(const FrameBuffer& frame, int x, int y) {
+    return frame.data() + (static_cast<size_t>(y) * frame.info().width + x) * 4;
+}
+
+bool samePixel(const uint8_t* a, const uint8_t* b) {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+} // namespace
+
+bool test_CPUImageKernels_IsaParity() {
+    FrameBuffer frame = makeBgraFrame(67, 41);
+    const FrameBuffer& input = frame;
+    CPUImageKernels::Source source;
+    source.data = input.data();
+    source.width = 67;
+    source.height = 41;
+    source.stride = 67 * 4;
+
+    // Each SIMD kernel gives the scalar kernel's bytes
+    struct Case { double scaleX, scaleY, degrees; };
+    const Case cases[] = {{0.73, 0.73, 0.0}, {1.0, 1.0, 17.0}, {2.3, 1.7, -123.0}, {-1.0, 1.0, 0.0}};
+    for (const Case& c : cases) {
+        int width = 0, height = 0;
+        CPUImageKernels::AffineMap map =
+            CPUImageKernels::scaleRotate(67, 41, c.scaleX, c.scaleY, c.degrees, width, height);
+        std::vector<uint8_t> expected(static_cast<size_t>(width) * height * 4);
+        CPUImageKernels::Target target{expected.data(), width, height, width * 4};
+        CPUImageKernels::bilinearRows(source, target, map, 0, height, CPUImageKernels::Isa::Scalar);
+
+        for (auto isa : {CPUImageKernels::Isa::SSE41, CPUImageKernels::Isa::AVX2, CPUImageKernels::Isa::NEON}) {
+            if (!CPUImageKernels::isSupported(isa)) {
+                continue;
+            }
+            std::vector<uint8_t> result(expected.size(), 0xAA);
+            target.data = result.data();
+            CPUImageKernels::bilinearRows(source, target, map, 0, height, isa);
+            TEST_ASSERT(result == expected);
+        }
+    }
+    return true;
+}
+
+bool test_CPUImageKernels_ExactCases() {
+    CPUImageProcessor processor;
+    FrameBuffer input = makeBgraFrame(4, 2);
+    const FrameBuffer& in = input;
+    FrameBuffer output;
+
+    // No scale or rotation: the pixels themselves
+    LayerProperties properties;
+    TEST_ASSERT(processor.transform(in, output, properties, in.info()));
+    TEST_ASSERT_EQ(output.info().width, 4);
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            TEST_ASSERT(samePixel(pixelAt(output, x, y), pixelAt(in, x, y)));
+        }
+    }
+
+    // A quarter turn counter-clockwise: the top row becomes the left column
+    // read upwards, pixels copied not blended
+    properties.rotation = 90.0f;
+    TEST_ASSERT(processor.transform(in, output, properties, in.info()));
+    TEST_ASSERT_EQ(output.info().width, 2);
+    TEST_ASSERT_EQ(output.info().height, 4);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 2; ++x) {
+            TEST_ASSERT(samePixel(pixelAt(output, x, y), pixelAt(in, 3 - y, x)));
+        }
+    }
+
+    // Crop fused with a half turn
+    properties.rotation = 180.0f;
+    properties.crop.enabled = true;
+    properties.crop.x = 1;
+    properties.crop.y = 0;
+    properties.crop.width = 2;
+    properties.crop.height = 2;
+    TEST_ASSERT(processor.transform(in, output, properties, in.info()));
+    TEST_ASSERT_EQ(output.info().width, 2);
+    TEST_ASSERT(samePixel(pixelAt(output, 0, 0), pixelAt(in, 2, 1)));
+    TEST_ASSERT(samePixel(pixelAt(output, 1, 1), pixelAt(in, 1, 0)));
+
+    // Bilinear upscale of a black-white pair: edges clamp, samples between
+    // pixel centres blend
+    FrameInfo pairInfo;
+    pairInfo.width = 2;
+    pairInfo.height = 2;
+    pairInfo.format = PixelFormat::BGRA32;
+    FrameBuffer pair;
+    TEST_ASSERT(pair.allocate(pairInfo));
+    for (int y = 0; y < 2; ++y) {
+        for (int c = 0; c < 4; ++c) {
+            pair.data()[y * 8 + 4 + c] = 255;
+        }
+    }
+    LayerProperties scale;
+    scale.scaleX = 2.0f;
+    TEST_ASSERT(processor.transform(pair, output, scale, pairInfo));
+    TEST_ASSERT_EQ(output.info().width, 4);
+    TEST_ASSERT_EQ(pixelAt(output, 0, 0)[0], 0);
+    TEST_ASSERT_EQ(pixelAt(output, 1, 0)[0], 64);
+    TEST_ASSERT_EQ(pixelAt(output, 2, 0)[0], 191);
+    TEST_ASSERT_EQ(pixelAt(output, 3, 1)[0], 255);
+    return true;
+}
+
+bool test_CPUImageKernels_Tiles() {
+    // Row tiles across the worker pool: the same bytes as one pass
+    FrameBuffer frame = makeBgraFrame(1280, 720);
+    const FrameBuffer& input = frame;
+    CPUImageKernels::Source source{input.data(), 1280, 720, 1280 * 4};
+    int width = 0, height = 0;
+    CPUImageKernels::AffineMap map = CPUImageKernels::scaleRotate(1280, 720, 0.9, 0.9, 30.0, width, height);
+
+    std::vector<uint8_t> single(static_cast<size_t>(width) * height * 4);
+    std::vector<uint8_t> tiled(single.size(), 0xAA);
+    CPUImageKernels::bilinearRows(source, {single.data(), width, height, width * 4}, map, 0, height,
+                                  CPUImageKernels::activeIsa());
+    CPUImageKernels::transform(source, {tiled.data(), width, height, width * 4}, map, 4);
+    TEST_ASSERT(tiled == single);
+
+    // Corners of a rotated picture are outside the source: zero
+    TEST_ASSERT(single[0] == 0 && single[3] == 0);
+    return true;
+}
+
+bool test_CPUImageKernels_WindowedFrames() {
+    FrameInfo full;
+    full.width = 16;
+    full.height = 8;
+    full.format = PixelFormat::BGRA32;
+    FrameBuffer picture = makeBgraFrame(16, 8);
+    const FrameBuffer& whole = picture;
+
+    LayerProperties properties;
+    FrameWindow shown;
+    TEST_ASSERT_FALSE(CPUImageProcessor::shownWindow(properties, full, shown));
+    properties.panoramaMode = true;
+    properties.panOffset = 12;
+    TEST_ASSERT(CPUImageProcessor::shownWindow(properties, full, shown));
+    TEST_ASSERT(shown.x == 8 && shown.y == 0 && shown.width == 8 && shown.height == 8);
+    properties.panoramaMode = false;
+    properties.crop.enabled = true;
+    properties.crop.x = 5;
+    properties.crop.y = 3;
+    properties.crop.width = 6;
+    properties.crop.height = 4;
+    TEST_ASSERT(CPUImageProcessor::shownWindow(properties, full, shown));
+    TEST_ASSERT(shown.x == 5 && shown.y == 3 && shown.width == 6 && shown.height == 4);
+
+    // A frame converted for the crop rounded out to 4:2:0 chroma: x 4-12, y 2-8
+    FrameInfo partInfo = full;
+    partInfo.width = 8;
+    partInfo.height = 6;
+    partInfo.window.x = 4;
+    partInfo.window.y = 2;
+    partInfo.window.width = 8;
+    partInfo.window.height = 6;
+    FrameBuffer part;
+    TEST_ASSERT(part.allocate(partInfo));
+    for (int y = 0; y < 6; ++y) {
+        std::memcpy(part.data() + y * 8 * 4, pixelAt(whole, 4, y + 2), 8 * 4);
+    }
+
+    // The crop of it is the crop of the whole picture
+    CPUImageProcessor processor;
+    FrameBuffer fromWhole, fromPart;
+    TEST_ASSERT(processor.processCPU(whole, fromWhole, properties, full));
+    TEST_ASSERT(processor.processCPU(part, fromPart, properties, full));
+    TEST_ASSERT(fromPart.info().width == 6 && fromPart.info().height == 4 && fromPart.info().window.isWhole());
+    TEST_ASSERT(std::memcmp(fromWhole.data(), fromPart.data(), fromWhole.size()) == 0);
+
+    properties.rotation = 90.0f;
+    TEST_ASSERT(processor.transform(whole, fromWhole, properties, full));
+    TEST_ASSERT(processor.transform(part, fromPart, properties, full));
+    TEST_ASSERT(std::memcmp(fromWhole.data(), fromPart.data(), fromWhole.size()) == 0);
+
+    // A crop outside the part held cannot be cut from it
+    properties.rotation = 0.0f;
+    properties.crop.x = 0;
+    TEST_ASSERT_FALSE(processor.processCPU(part, fromPart, properties, full));
+    return true;
+}
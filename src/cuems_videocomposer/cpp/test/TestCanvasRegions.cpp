@@ -0,0 +1,88 @@
+#include "TestFramework.h"
+#include "../display/CanvasRegions.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+bool covers(const CanvasRegions& regions, int x, int y) {
+    int count = 0;
+    for (const CanvasRect& rect : regions.rects()) {
+        count += x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+    }
+    return count == 1;     // Disjoint: never covered twice
+}
+
+} // namespace
+
+bool test_CanvasRegions_Merge() {
+    CanvasRegions regions;
+    TEST_ASSERT(regions.coversAll());
+
+    // Side by side outputs cover the canvas as one rectangle
+    regions.set({{0, 0, 1920, 1080}, {1920, 0, 1920, 1080}}, 3840, 1080);
+    TEST_ASSERT(regions.coversAll());
+    TEST_ASSERT(regions.rects().size() == 1);
+
+    // L-shape: two outputs on the bottom row, one above the left one
+    regions.set({{0, 0, 1920, 1080}, {1920, 0, 1920, 1080}, {0, 1080, 1920, 1080}}, 3840, 2160);
+    TEST_ASSERT(!regions.coversAll());
+    TEST_ASSERT(regions.coverage() == 0.75f);
+    TEST_ASSERT(regions.rects().size() == 2);
+    TEST_ASSERT(covers(regions, 100, 2000) && covers(regions, 3000, 100));
+    TEST_ASSERT(!covers(regions, 3000, 2000));
+
+    // Overlapping projectors (edge blend) count the overlap once
+    regions.set({{0, 0, 1000, 500}, {800, 0, 1000, 500}}, 2000, 600);
+    TEST_ASSERT(regions.coverage() == (1800.0f * 500.0f) / (2000.0f * 600.0f));
+    for (int x = 0; x < 2000; x += 50) {
+        for (int y = 0; y < 600; y += 50) {
+            TEST_ASSERT(covers(regions, x, y) == (x < 1800 && y < 500));
+        }
+    }
+
+    // Regions partly off the canvas are clipped
+    regions.set({{-100, -100, 300, 300}}, 1000, 1000);
+    TEST_ASSERT(regions.rects().size() == 1);
+    TEST_ASSERT(regions.rects()[0] == (CanvasRect{0, 0, 200, 200}));
+    TEST_ASSERT(regions.flipped()[0] == (CanvasRect{0, 800, 200, 200}));
+    return true;
+}
+
+bool test_CanvasRegions_Intersects() {
+    CanvasRegions regions;
+    regions.set({{0, 0, 1920, 1080}, {1920, 0, 1920, 1080}, {0, 1080, 1920, 1080}}, 3840, 2160);
+
+    // A layer in the unused corner touches no output; one straddling the gap does
+    TEST_ASSERT(!regions.intersects(2000.0f, 1200.0f, 3800.0f, 2100.0f));
+    TEST_ASSERT(regions.intersects(1800.0f, 1200.0f, 2500.0f, 2100.0f));
+    TEST_ASSERT(regions.intersects(3000.0f, 1000.0f, 3500.0f, 1500.0f));
+
+    // Edges are exclusive
+    TEST_ASSERT(!regions.intersects(1920.0f, 1080.0f, 2000.0f, 1200.0f));
+
+    // Whole canvas visible: anything on the canvas intersects
+    regions.set({{0, 0, 100, 100}}, 100, 100);
+    TEST_ASSERT(regions.intersects(-10.0f, -10.0f, 1.0f, 1.0f));
+    TEST_ASSERT(!regions.intersects(100.0f, 0.0f, 200.0f, 100.0f));
+    return true;
+}
+
+bool test_CanvasRegions_Scaled() {
+    CanvasRegions regions;
+    TEST_ASSERT(regions.scaled(0.5f, 1920, 1080).coversAll());
+
+    // The L-shape at half size: same parts, a pixel around each
+    regions.set({{0, 0, 1920, 1080}, {1920, 0, 1920, 1080}, {0, 1080, 1920, 1080}}, 3840, 2160);
+    CanvasRegions half = regions.scaled(0.5f, 1920, 1080);
+    TEST_ASSERT(!half.coversAll());
+    TEST_ASSERT(covers(half, 50, 1000) && covers(half, 1500, 50));
+    TEST_ASSERT(covers(half, 960, 540));
+    TEST_ASSERT(!covers(half, 1500, 1000));
+
+    // Everything shown stays everything
+    regions.set({{0, 0, 3840, 2160}}, 3840, 2160);
+    TEST_ASSERT(regions.scaled(0.625f, 2400, 1350).coversAll());
+    return true;
+}
@@ -0,0 +1,47 @@
+#include "TestFramework.h"
+#include "../display/CaptureConverter.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_CaptureConverter_PyramidSizes() {
+    // Pyramid levels: canvas size / 2^level, explicit sizes win
+    CaptureFormat half;
+    half.level = 1;
+    int width = 0, height = 0;
+    CaptureConverter::frameSize(half, 3840, 2160, width, height);
+    TEST_ASSERT_EQ(width, 1920);
+    TEST_ASSERT_EQ(height, 1080);
+    
+    CaptureFormat custom;
+    custom.width = 320;
+    custom.height = 180;
+    custom.level = 2;
+    CaptureConverter::frameSize(custom, 3840, 2160, width, height);
+    TEST_ASSERT_EQ(width, 320);
+    TEST_ASSERT_EQ(height, 180);
+    
+    // Sampled level: none up to 2:1, then one below the scale
+    TEST_ASSERT_EQ(CaptureConverter::pyramidLevel(3840, 2160, 3840, 2160), 0);
+    TEST_ASSERT_EQ(CaptureConverter::pyramidLevel(3840, 2160, 1920, 1080), 0);
+    TEST_ASSERT_EQ(CaptureConverter::pyramidLevel(3840, 2160, 960, 540), 1);
+    TEST_ASSERT_EQ(CaptureConverter::pyramidLevel(3840, 2160, 320, 180), 3);
+    
+    // Packed targets hold exactly the frame's bytes
+    int packedWidth = 0, packedHeight = 0;
+    width = 1918;
+    height = 1081;
+    TEST_ASSERT(CaptureConverter::packedSize(PixelFormat::NV12, width, height, packedWidth, packedHeight));
+    TEST_ASSERT_EQ(width, 1916);
+    TEST_ASSERT_EQ(height, 1080);
+    TEST_ASSERT_EQ(static_cast<size_t>(packedWidth) * packedHeight * 4,
+                   FrameData::frameSize(PixelFormat::NV12, width, height));
+    
+    width = 1920;
+    height = 1080;
+    TEST_ASSERT(CaptureConverter::packedSize(PixelFormat::UYVY422, width, height, packedWidth, packedHeight));
+    TEST_ASSERT_EQ(static_cast<size_t>(packedWidth) * packedHeight * 4,
+                   FrameData::frameSize(PixelFormat::UYVY422, width, height));
+    TEST_ASSERT(!CaptureConverter::packedSize(PixelFormat::RGB24, width, height, packedWidth, packedHeight));
+    return true;
+}
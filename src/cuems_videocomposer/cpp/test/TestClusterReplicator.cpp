@@ -0,0 +1,164 @@
+#include "TestFramework.h"
+#include "../remote/ClusterReplicator.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+struct Sent {
+    ClusterMessage kind;
+    std::string label;
+    std::vector<double> values;
+};
+
+// Records what the authority sends, in order
+struct Wire {
+    std::vector<Sent> messages;
+
+    ClusterReplicator::Sender sender() {
+        return [this](const std::string& path, const std::string& label, const std::vector<double>& values) {
+            ClusterMessage kind = path == ClusterReplicator::LAYER_PATH ? ClusterMessage::LAYER
+                                : path == ClusterReplicator::REMOVE_PATH ? ClusterMessage::REMOVE
+                                : ClusterMessage::SYNC;
+            messages.push_back(Sent{kind, label, values});
+            return true;
+        };
+    }
+
+    // Deliver (and forget) what was sent, skipping one message if asked
+    size_t deliver(ClusterReplicator& follower, int skip = -1) {
+        size_t changes = 0;
+        for (size_t i = 0; i < messages.size(); ++i) {
+            if (static_cast<int>(i) == skip) {
+                continue;
+            }
+            std::vector<ClusterReplicator::Change> changed;
+            follower.receive(messages[i].kind, messages[i].label, messages[i].values, changed);
+            changes += changed.size();
+        }
+        messages.clear();
+        return changes;
+    }
+};
+
+ClusterReplicator::Lines layerLines(const std::string& source, float opacity) {
+    return {"source " + source, "opacity " + std::to_string(opacity), "z 1"};
+}
+
+} // namespace
+
+bool test_ClusterReplicator_SendsOnlyChangedLines() {
+    ClusterReplicator authority(1, 1000);
+    ClusterReplicator follower;
+    Wire wire;
+    ClusterReplicator::Scene scene;
+    scene["a"] = layerLines("a.mov", 1.0f);
+
+    // The first publish is a keyframe: the full layer and the cue list
+    TEST_ASSERT_EQ(authority.publish(scene, 0, wire.sender()), static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(wire.messages[1].kind == ClusterMessage::SYNC);
+    wire.deliver(follower);
+    TEST_ASSERT_FALSE(follower.isStale());
+    TEST_ASSERT_TRUE(follower.getScene() == scene);
+
+    // Nothing changed: nothing sent
+    TEST_ASSERT_EQ(authority.publish(scene, 10, wire.sender()), static_cast<size_t>(0));
+
+    // Only the opacity line travels; the follower merges it
+    scene["a"][1] = "opacity 0.5";
+    TEST_ASSERT_EQ(authority.publish(scene, 20, wire.sender()), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(wire.messages[0].label, std::string("a\nopacity 0.5"));
+    TEST_ASSERT_EQ(wire.messages[0].values[2], 0.0);
+    TEST_ASSERT_EQ(wire.deliver(follower), static_cast<size_t>(1));
+    TEST_ASSERT_TRUE(follower.getScene() == scene);
+
+    // A dropped line sends the layer in full; a removed cue a remove
+    scene["a"].pop_back();
+    scene["b"] = layerLines("b.mov", 1.0f);
+    authority.publish(scene, 30, wire.sender());
+    wire.deliver(follower);
+    TEST_ASSERT_TRUE(follower.getScene() == scene);
+    scene.erase("a");
+    authority.publish(scene, 40, wire.sender());
+    TEST_ASSERT_TRUE(wire.messages[0].kind == ClusterMessage::REMOVE);
+    wire.deliver(follower);
+    TEST_ASSERT_TRUE(follower.findLayer("a") == nullptr);
+    TEST_ASSERT_TRUE(follower.getScene() == scene);
+    TEST_ASSERT_EQ(follower.getGapCount(), static_cast<uint64_t>(0));
+    return true;
+}
+
+bool test_ClusterReplicator_KeyframeRepairsGaps() {
+    ClusterReplicator authority(1, 1000);
+    ClusterReplicator follower;
+    Wire wire;
+    ClusterReplicator::Scene scene;
+    scene["a"] = layerLines("a.mov", 1.0f);
+    scene["b"] = layerLines("b.mov", 1.0f);
+    authority.publish(scene, 0, wire.sender());
+    wire.deliver(follower);
+
+    // The change to "a" is lost: "b"'s arrives, the gap is seen
+    scene["a"][1] = "opacity 0.25";
+    scene["b"][1] = "opacity 0.75";
+    authority.publish(scene, 10, wire.sender());
+    wire.deliver(follower, 0);
+    TEST_ASSERT_TRUE(follower.isStale());
+    TEST_ASSERT_EQ(follower.getGapCount(), static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(follower.findLayer("a")->at(1), std::string("opacity 1.000000"));
+
+    // So is the removal of "b"
+    scene.erase("b");
+    authority.publish(scene, 20, wire.sender());
+    wire.deliver(follower, 0);
+    TEST_ASSERT_TRUE(follower.findLayer("b") != nullptr);
+
+    // The keyframe brings the follower back to the authority's scene
+    authority.publish(scene, 1000, wire.sender());
+    wire.deliver(follower);
+    TEST_ASSERT_FALSE(follower.isStale());
+    TEST_ASSERT_TRUE(follower.getScene() == scene);
+
+    // A keyframe with a hole leaves the follower stale
+    scene["a"][1] = "opacity 0.5";
+    scene["c"] = layerLines("c.mov", 1.0f);
+    authority.publish(scene, 2000, wire.sender());
+    wire.deliver(follower, 1);
+    TEST_ASSERT_TRUE(follower.isStale());
+    TEST_ASSERT_TRUE(follower.findLayer("c") == nullptr);
+    return true;
+}
+
+bool test_ClusterReplicator_DropsStaleAndFollowsRestart() {
+    ClusterReplicator authority(1, 1000);
+    ClusterReplicator follower;
+    Wire wire;
+    ClusterReplicator::Scene scene;
+    scene["a"] = layerLines("a.mov", 1.0f);
+    authority.publish(scene, 0, wire.sender());
+    std::vector<Sent> keyframe = wire.messages;
+    wire.deliver(follower);
+
+    // A datagram delivered twice is dropped the second time
+    std::vector<ClusterReplicator::Change> changes;
+    TEST_ASSERT_FALSE(follower.receive(keyframe[0].kind, keyframe[0].label, keyframe[0].values, changes));
+    TEST_ASSERT_TRUE(changes.empty());
+    TEST_ASSERT_EQ(follower.getDroppedCount(), static_cast<uint64_t>(1));
+
+    // A delta for a cue the follower never saw waits for a keyframe
+    TEST_ASSERT_FALSE(follower.receive(ClusterMessage::LAYER, "x\nopacity 1", {5.0, 1.0, 0.0}, changes));
+    TEST_ASSERT_TRUE(follower.findLayer("x") == nullptr);
+
+    // A restarted authority numbers from 1 again under a new epoch
+    ClusterReplicator restarted(2, 1000);
+    ClusterReplicator::Scene other;
+    other["b"] = layerLines("b.mov", 1.0f);
+    restarted.publish(other, 0, wire.sender());
+    wire.deliver(follower);
+    TEST_ASSERT_FALSE(follower.isStale());
+    TEST_ASSERT_TRUE(follower.getScene() == other);
+    return true;
+}
@@ -0,0 +1,122 @@
+#include "TestFramework.h"
+#include "../display/ColorLut.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Largest channel difference between the table and the direct adjustment
+float maxLutError(const ColorLut& lut, const ColorLut::Adjustment& adjustment) {
+    uint32_t seed = 777;
+    float worst = 0.0f;
+    for (int i = 0; i < 4000; ++i) {
+        float in[3];
+        for (float& c : in) {
+            seed = seed * 1664525u + 1013904223u;
+            c = (seed >> 8) / 16777216.0f;
+        }
+        float expected[3] = {in[0], in[1], in[2]};
+        ColorLut::adjust(adjustment, expected);
+        float out[3];
+        lut.sample(in, out);
+        for (int c = 0; c < 3; ++c) {
+            worst = std::max(worst, std::abs(out[c] - expected[c]));
+        }
+    }
+    return worst;
+}
+
+} // namespace
+
+bool test_ColorLut_BakedAdjustment() {
+    // Identity: the table gives colours back unchanged
+    ColorLut identity;
+    TEST_ASSERT(identity.build(ColorLut::Adjustment()));
+    TEST_ASSERT_EQ(identity.size(), ColorLut::DEFAULT_SIZE);
+    TEST_ASSERT(maxLutError(identity, ColorLut::Adjustment()) < 1e-5f);
+    
+    // A strong grade stays within a few 8-bit steps of the per-pixel math
+    // (the worst just above black, where the gamma curve is steepest)
+    ColorLut::Adjustment grade;
+    grade.brightness = 0.1f;
+    grade.contrast = 1.3f;
+    grade.saturation = 0.7f;
+    grade.hue = 40.0f;
+    grade.gamma = 1.4f;
+    ColorLut lut;
+    TEST_ASSERT(lut.build(grade));
+    TEST_ASSERT(maxLutError(lut, grade) < 8.0f / 255.0f);
+    grade.gamma = 1.0f;
+    TEST_ASSERT(lut.build(grade));
+    TEST_ASSERT(maxLutError(lut, grade) < 3.0f / 255.0f);
+    
+    // Saturation 0 is grey; everything clamps to 0-1
+    ColorLut::Adjustment grey;
+    grey.saturation = 0.0f;
+    grey.brightness = 0.5f;
+    float rgb[3] = {1.0f, 0.2f, 0.0f};
+    ColorLut::adjust(grey, rgb);
+    TEST_ASSERT(rgb[0] == rgb[1] && rgb[1] == rgb[2]);
+    TEST_ASSERT(rgb[0] <= 1.0f);
+    
+    TEST_ASSERT(!lut.build(grade, 1));
+    return true;
+}
+
+bool test_ColorLut_CubeFile() {
+    std::string path = "/tmp/test_color_lut.cube";
+    {
+        // Inverting table over a 0-2 domain, red fastest
+        std::ofstream file(path);
+        file << "# venue calibration\nTITLE \"invert\"\nLUT_3D_SIZE 2\n";
+        file << "DOMAIN_MIN 0 0 0\nDOMAIN_MAX 2 2 2\n";
+        for (int b = 0; b < 2; ++b) {
+            for (int g = 0; g < 2; ++g) {
+                for (int r = 0; r < 2; ++r) {
+                    file << 1 - r << " " << 1 - g << " " << 1 - b << "\n";
+                }
+            }
+        }
+    }
+    ColorLut cube;
+    TEST_ASSERT(cube.loadCube(path));
+    TEST_ASSERT_EQ(cube.size(), 2);
+    float in[3] = {0.5f, 1.0f, 2.0f};
+    float out[3];
+    cube.sample(in, out);
+    TEST_ASSERT(std::abs(out[0] - 0.75f) < 1e-6f);
+    TEST_ASSERT(std::abs(out[1] - 0.5f) < 1e-6f);
+    TEST_ASSERT(std::abs(out[2] - 0.0f) < 1e-6f);
+    
+    // Adjustment then calibration, baked into one 0-1 table
+    ColorLut::Adjustment dim;
+    dim.brightness = -0.25f;
+    ColorLut baked;
+    TEST_ASSERT(baked.build(dim, 5, &cube));
+    float white[3] = {1.0f, 1.0f, 1.0f};
+    baked.sample(white, out);
+    TEST_ASSERT(std::abs(out[0] - (1.0f - 0.75f / 2.0f)) < 1e-5f);
+    
+    // Entry count must match the size
+    {
+        std::ofstream file(path);
+        file << "LUT_3D_SIZE 3\n0 0 0\n1 1 1\n";
+    }
+    ColorLut broken;
+    TEST_ASSERT(!broken.loadCube(path));
+    TEST_ASSERT(!broken.isValid());
+    {
+        std::ofstream file(path);
+        file << "LUT_1D_SIZE 2\n0 0 0\n1 1 1\n";
+    }
+    TEST_ASSERT(!broken.loadCube(path));
+    std::remove(path.c_str());
+    return true;
+}
@@ -0,0 +1,96 @@
+#include "TestFramework.h"
+#include "../remote/CommandArgs.h"
+#include "../remote/CommandTable.h"
+#include <string>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_CommandArgs_TypedValues() {
+    CommandArgs args;
+    args.addFloat(0.5f);
+    args.addInt(42);
+    args.addDouble(1234567.125);
+    args.addString("12.75");
+    args.addString("block");
+
+    // Numbers are read as sent, strings are parsed
+    TEST_ASSERT_TRUE(args[0].toFloat() == 0.5f);
+    TEST_ASSERT_EQ(args[0].toInt(), 0);
+    TEST_ASSERT_EQ(args[1].toInt(), 42);
+    TEST_ASSERT_TRUE(args[1].toFloat() == 42.0f);
+    TEST_ASSERT_TRUE(args[2].toDouble() == 1234567.125);
+    TEST_ASSERT_EQ(args[2].toInt64(), static_cast<int64_t>(1234567));
+    TEST_ASSERT_TRUE(args[3].toFloat() == 12.75f);
+    TEST_ASSERT_EQ(args[3].toInt(), 12);
+
+    // Text form matches the old string arguments
+    TEST_ASSERT_EQ(std::string(args[0].c_str()), std::string("0.5"));
+    TEST_ASSERT_EQ(std::string(args[1].c_str()), std::string("42"));
+    TEST_ASSERT_EQ(args[2].str(), std::string("1234567.125"));
+    TEST_ASSERT_TRUE(args[4] == "block");
+    TEST_ASSERT_TRUE(args[4] != "hold");
+    TEST_ASSERT_EQ(args[4].length(), static_cast<size_t>(5));
+
+    // Copies own their text
+    CommandArgs copy = args;
+    args.clear();
+    args.addString("something else entirely");
+    TEST_ASSERT_EQ(copy.size(), static_cast<size_t>(5));
+    TEST_ASSERT_EQ(copy[4].str(), std::string("block"));
+    TEST_ASSERT_EQ(copy.toStrings()[3], std::string("12.75"));
+    return true;
+}
+
+bool test_CommandArgs_ReusesStorage() {
+    CommandArgs args;
+    // Many strings: the text buffer moves while filling
+    for (int i = 0; i < 64; ++i) {
+        args.addString(std::to_string(i * 1000));
+    }
+    for (int i = 0; i < 64; ++i) {
+        TEST_ASSERT_EQ(args[i].toInt(), i * 1000);
+    }
+
+    // Refilling a cleared instance keeps its storage
+    const CommandArg* first = &args[0];
+    const char* text = args[0].c_str();
+    args.clear();
+    args.addString("5");
+    args.addFloat(1.0f);
+    TEST_ASSERT_TRUE(&args[0] == first);
+    TEST_ASSERT_TRUE(args[0].c_str() == text);
+
+    CommandArgs fromStrings(std::vector<std::string>{"a", "bc", ""});
+    TEST_ASSERT_EQ(fromStrings.size(), static_cast<size_t>(3));
+    TEST_ASSERT_TRUE(fromStrings[1] == "bc");
+    TEST_ASSERT_TRUE(fromStrings[2].empty());
+    return true;
+}
+
+bool test_CommandTable_Lookup() {
+    CommandTable<int> table;
+    for (int i = 0; i < 100; ++i) {
+        table.insert("layer/cmd" + std::to_string(i), i);
+    }
+    table.insert("opacity", 1000);
+    table.insert("opacity", 1001);  // Re-registration replaces
+    TEST_ASSERT_EQ(table.size(), static_cast<size_t>(101));
+
+    for (int i = 0; i < 100; ++i) {
+        std::string path = "layer/cmd" + std::to_string(i);
+        const int* handler = table.find(path);
+        TEST_ASSERT_TRUE(handler != nullptr);
+        TEST_ASSERT_EQ(*handler, i);
+    }
+    // Views into a longer path, as the router passes them
+    std::string_view received = "/videocomposer/layer/abc/opacity";
+    const int* handler = table.find(received.substr(25));
+    TEST_ASSERT_TRUE(handler != nullptr);
+    TEST_ASSERT_EQ(*handler, 1001);
+
+    TEST_ASSERT_TRUE(table.find("opacit") == nullptr);
+    TEST_ASSERT_TRUE(table.find("") == nullptr);
+    TEST_ASSERT_TRUE(CommandTable<int>().find("opacity") == nullptr);
+    return true;
+}
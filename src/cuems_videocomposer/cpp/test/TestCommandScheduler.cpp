@@ -0,0 +1,86 @@
+#include "TestFramework.h"
+#include "../remote/CommandScheduler.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+struct Recorder {
+    std::vector<std::string> ran;
+
+    CommandScheduler::Runner runner() {
+        return [this](std::string_view path, const CommandArgs& args) {
+            std::string entry(path);
+            for (const CommandArg& arg : args) {
+                entry += " " + arg.str();
+            }
+            ran.push_back(entry);
+        };
+    }
+};
+
+CommandArgs floats(float value) {
+    CommandArgs args;
+    args.addFloat(value);
+    return args;
+}
+
+} // namespace
+
+bool test_CommandScheduler_FiresOnFrame() {
+    CommandScheduler scheduler;
+    Recorder recorder;
+
+    // "At 100, show A and fade B out", sent well ahead
+    scheduler.scheduleAtFrame(100, "layer/A/visible", floats(1.0f));
+    scheduler.scheduleAtFrame(100, "layer/B/opacity", floats(0.0f));
+    scheduler.scheduleAtFrame(250, "layer/A/visible", floats(0.0f));
+    TEST_ASSERT_EQ(scheduler.size(), static_cast<size_t>(3));
+
+    // No sync source: frame commands wait
+    TEST_ASSERT_EQ(scheduler.runDue(-1, 0, recorder.runner()), static_cast<size_t>(0));
+    TEST_ASSERT_EQ(scheduler.runDue(99, 0, recorder.runner()), static_cast<size_t>(0));
+
+    // Both on the same frame, in the order sent
+    TEST_ASSERT_EQ(scheduler.runDue(100, 0, recorder.runner()), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(recorder.ran.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(recorder.ran[0], std::string("layer/A/visible 1"));
+    TEST_ASSERT_EQ(recorder.ran[1], std::string("layer/B/opacity 0"));
+    TEST_ASSERT_EQ(scheduler.runDue(100, 0, recorder.runner()), static_cast<size_t>(0));
+
+    // A locate past the time still fires, once
+    TEST_ASSERT_EQ(scheduler.runDue(400, 0, recorder.runner()), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(scheduler.size(), static_cast<size_t>(0));
+    return true;
+}
+
+bool test_CommandScheduler_Timetags() {
+    CommandScheduler scheduler;
+    Recorder recorder;
+
+    // 1970-01-01 00:00:01.5 in NTP time
+    TEST_ASSERT_EQ(CommandScheduler::timetagToUnixUs(2208988801u, 0x80000000u), static_cast<int64_t>(1500000));
+
+    int64_t t0 = 1700000000000000LL;
+    scheduler.scheduleAtTime(t0 + 40000, "seek", floats(2.0f));
+    scheduler.scheduleAtTime(t0 + 20000, "seek", floats(1.0f));
+
+    // Only what is due by this render's presentation time
+    TEST_ASSERT_EQ(scheduler.runDue(-1, t0 + 19999, recorder.runner()), static_cast<size_t>(0));
+    TEST_ASSERT_EQ(scheduler.runDue(-1, t0 + 20000, recorder.runner()), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(recorder.ran.back(), std::string("seek 1"));
+
+    // A command run can schedule another; it does not run in the same pass
+    scheduler.runDue(-1, t0 + 40000, [&scheduler, &recorder](std::string_view path, const CommandArgs& args) {
+        recorder.ran.push_back(std::string(path));
+        scheduler.scheduleAtTime(0, "again", args);
+    });
+    TEST_ASSERT_EQ(recorder.ran.back(), std::string("seek"));
+    TEST_ASSERT_EQ(scheduler.size(), static_cast<size_t>(1));
+    scheduler.clear();
+    TEST_ASSERT_EQ(scheduler.size(), static_cast<size_t>(0));
+    return true;
+}
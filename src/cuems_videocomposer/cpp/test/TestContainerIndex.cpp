@@ -0,0 +1,93 @@
+#include "TestFramework.h"
+#include "../input/ContainerIndex.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// 25 fps in a 1/12800 time base (512 ticks per frame)
+int64_t frameTime25(int64_t frame) {
+    return frame * 512;
+}
+
+} // namespace
+
+bool test_ContainerIndex_Samples() {
+    // GOP of 4 with a B-frame delay: decode timestamps start one frame early
+    std::vector<ContainerIndex::Sample> samples;
+    for (int i = 0; i < 10; ++i) {
+        samples.push_back({(i - 1) * 512, 1000 + i * 100, i % 4 == 0});
+    }
+
+    std::vector<FrameIndexCache::Entry> entries;
+    TEST_ASSERT(ContainerIndex::fromSamples(samples, frameTime25, entries));
+    TEST_ASSERT_EQ(static_cast<int>(entries.size()), 10);
+
+    TEST_ASSERT_EQ(static_cast<int>(entries[0].key), 1);
+    TEST_ASSERT_EQ(entries[0].pkt_pts, -512);
+    TEST_ASSERT_EQ(entries[0].frame_pos, 1000);
+    TEST_ASSERT_EQ(entries[3].timestamp, 3 * 512);
+    TEST_ASSERT_EQ(entries[3].frame_pos, -1);
+
+    // Frames seek to the keyframe opening their GOP
+    TEST_ASSERT_EQ(entries[3].seekpts, -512);
+    TEST_ASSERT_EQ(entries[3].seekpos, 1000);
+    TEST_ASSERT_EQ(entries[4].seekpts, 3 * 512);
+    TEST_ASSERT_EQ(entries[7].seekpos, 1400);
+    TEST_ASSERT_EQ(entries[9].seekpts, 7 * 512);
+    return true;
+}
+
+bool test_ContainerIndex_SamplesNeedKeyframe() {
+    std::vector<ContainerIndex::Sample> samples;
+    for (int i = 0; i < 5; ++i) {
+        samples.push_back({i * 512, -1, false});
+    }
+    std::vector<FrameIndexCache::Entry> entries;
+    TEST_ASSERT(!ContainerIndex::fromSamples(samples, frameTime25, entries));
+    TEST_ASSERT(entries.empty());
+    return true;
+}
+
+bool test_ContainerIndex_Keyframes() {
+    // Matroska-style cues in milliseconds at 30000/1001 fps: keyframes every
+    // 12 frames, timestamps rounded to the millisecond
+    auto frameTimeMs = [](int64_t frame) { return frame * 1001 / 30; };
+    const int64_t start = 80;
+    std::vector<ContainerIndex::Sample> cues;
+    for (int k = 0; k < 5; ++k) {
+        int64_t frame = k * 12;
+        cues.push_back({start + (frame * 1001 + 15) / 30, 5000 + k * 70000, true});
+    }
+
+    std::vector<FrameIndexCache::Entry> entries;
+    TEST_ASSERT(ContainerIndex::fromKeyframes(cues, start, 60, frameTimeMs, entries));
+    TEST_ASSERT_EQ(static_cast<int>(entries.size()), 60);
+
+    for (int i = 0; i < 60; ++i) {
+        TEST_ASSERT_EQ(static_cast<int>(entries[i].key), i % 12 == 0 ? 1 : 0);
+        TEST_ASSERT_EQ(entries[i].seekpts, cues[i / 12].timestamp);
+        TEST_ASSERT_EQ(entries[i].seekpos, cues[i / 12].pos);
+        TEST_ASSERT_EQ(entries[i].timestamp, frameTimeMs(i));
+    }
+    TEST_ASSERT_EQ(entries[24].pkt_pts, cues[2].timestamp);
+    TEST_ASSERT_EQ(entries[25].pkt_pts, start + frameTimeMs(25));
+    return true;
+}
+
+bool test_ContainerIndex_KeyframesTooSparse() {
+    std::vector<FrameIndexCache::Entry> entries;
+
+    // Cues only every 400 frames: scanning is the only way to seek well
+    std::vector<ContainerIndex::Sample> cues = {{0, 0, true}, {400 * 512, 1 << 20, true}};
+    TEST_ASSERT(!ContainerIndex::fromKeyframes(cues, 0, 800, frameTime25, entries));
+    TEST_ASSERT(entries.empty());
+
+    // Cues that stop long before the end of the stream
+    cues = {{0, 0, true}, {100 * 512, 4096, true}};
+    TEST_ASSERT(!ContainerIndex::fromKeyframes(cues, 0, 1000, frameTime25, entries));
+
+    TEST_ASSERT(!ContainerIndex::fromKeyframes({}, 0, 100, frameTime25, entries));
+    return true;
+}
@@ -0,0 +1,235 @@
+#include "TestFramework.h"
+#include "../remote/ControlCapture.h"
+#include "../utils/TimeUtils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+ControlRecord frameRecord(int64_t timeUs, int64_t frame) {
+    ControlRecord record;
+    record.kind = ControlRecord::Kind::FRAME;
+    record.timeUs = timeUs;
+    record.frame = frame;
+    return record;
+}
+
+ControlRecord commandRecord(int64_t timeUs, const std::string& path) {
+    ControlRecord record;
+    record.kind = ControlRecord::Kind::COMMAND;
+    record.timeUs = timeUs;
+    record.path = path;
+    return record;
+}
+
+} // namespace
+
+bool test_ControlLog_RoundTrip() {
+    std::vector<ControlRecord> records;
+    records.push_back(frameRecord(0, -1));
+    records.push_back(frameRecord(40000, 90000));
+    ControlRecord transport;
+    transport.kind = ControlRecord::Kind::TRANSPORT;
+    transport.timeUs = 40000;
+    transport.transport = TransportEvent::Kind::STOP;
+    transport.frame = 90000;
+    records.push_back(transport);
+    ControlRecord command = commandRecord(1234567, "/videocomposer/layer/opacity");
+    command.args.addString("cue-1");
+    command.args.addFloat(0.25f);
+    command.args.addInt(-7);
+    command.args.addInt64(-5000000000LL);
+    command.args.addDouble(3600.5);
+    command.scheduled = true;
+    command.atOffsetUs = -1500;
+    records.push_back(command);
+
+    std::string data;
+    int64_t previousUs = 0;
+    for (const ControlRecord& record : records) {
+        ControlLog::encode(record, previousUs, data);
+    }
+    // A running frame costs a few bytes
+    std::string frameOnly;
+    int64_t framePreviousUs = 0;
+    ControlLog::encode(frameRecord(40000, 90000), framePreviousUs, frameOnly);
+    TEST_ASSERT(frameOnly.size() <= 8);
+
+    const uint8_t* at = reinterpret_cast<const uint8_t*>(data.data());
+    const uint8_t* end = at + data.size();
+    previousUs = 0;
+    std::vector<ControlRecord> read;
+    ControlRecord record;
+    while (at < end && ControlLog::decode(at, end, previousUs, record)) {
+        read.push_back(record);
+    }
+    TEST_ASSERT(at == end);
+    TEST_ASSERT_EQ(read.size(), records.size());
+    TEST_ASSERT(read[0].kind == ControlRecord::Kind::FRAME && read[0].frame == -1);
+    TEST_ASSERT(read[1].timeUs == 40000 && read[1].frame == 90000);
+    TEST_ASSERT(read[2].kind == ControlRecord::Kind::TRANSPORT && read[2].transport == TransportEvent::Kind::STOP);
+    TEST_ASSERT(read[2].timeUs == 40000 && read[2].frame == 90000);
+
+    const ControlRecord& c = read[3];
+    TEST_ASSERT(c.kind == ControlRecord::Kind::COMMAND && c.timeUs == 1234567);
+    TEST_ASSERT_EQ(c.path, std::string("/videocomposer/layer/opacity"));
+    TEST_ASSERT_EQ(c.args.size(), static_cast<size_t>(5));
+    TEST_ASSERT(c.args[0].isString() && c.args[0] == "cue-1");
+    TEST_ASSERT(c.args[1].type() == CommandArg::Type::FLOAT && c.args[1].toFloat() == 0.25f);
+    TEST_ASSERT(c.args[2].type() == CommandArg::Type::INT && c.args[2].toInt() == -7);
+    TEST_ASSERT(c.args[3].type() == CommandArg::Type::INT64 && c.args[3].toInt64() == -5000000000LL);
+    TEST_ASSERT(c.args[4].type() == CommandArg::Type::DOUBLE && c.args[4].toDouble() == 3600.5);
+    TEST_ASSERT(c.scheduled && c.atOffsetUs == -1500);
+
+    // A truncated record is not read
+    at = reinterpret_cast<const uint8_t*>(data.data());
+    end = at + data.size() - 1;
+    previousUs = 0;
+    size_t complete = 0;
+    while (at < end && ControlLog::decode(at, end, previousUs, record)) {
+        ++complete;
+    }
+    TEST_ASSERT_EQ(complete, records.size() - 1);
+    return true;
+}
+
+bool test_ControlReplay_Timing() {
+    std::vector<ControlRecord> records;
+    records.push_back(frameRecord(0, 100));
+    records.push_back(commandRecord(10000, "/videocomposer/layer/play"));
+    records.push_back(frameRecord(40000, 101));
+    ControlRecord locate;
+    locate.kind = ControlRecord::Kind::TRANSPORT;
+    locate.timeUs = 50000;
+    locate.transport = TransportEvent::Kind::LOCATE;
+    locate.frame = 500;
+    records.push_back(locate);
+    records.push_back(frameRecord(50000, 500));
+
+    // Original timing: played when their time has passed since the first update
+    ControlReplay replay;
+    replay.setRecords(records, false);
+    TEST_ASSERT(replay.isActive() && replay.hasCommands());
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(-1));
+    replay.update(1000000);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(100));
+    std::vector<std::string> routed;
+    bool immediate = true;
+    auto route = [&](const std::string& path, const CommandArgs&, int64_t atUs) {
+        routed.push_back(path);
+        immediate = immediate && atUs == 0;
+    };
+    TEST_ASSERT_EQ(replay.takeCommands(route), static_cast<size_t>(0));
+
+    replay.update(1039999);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(100));
+    TEST_ASSERT_EQ(replay.takeCommands(route), static_cast<size_t>(1));
+    TEST_ASSERT(routed.size() == 1 && routed[0] == "/videocomposer/layer/play" && immediate);
+    TEST_ASSERT_FALSE(replay.takeFullFrame());
+
+    replay.update(1060000);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(500));
+    TEST_ASSERT_TRUE(replay.takeFullFrame());
+    TEST_ASSERT_FALSE(replay.takeFullFrame());
+    std::vector<TransportEvent> events;
+    TEST_ASSERT_EQ(replay.readTransportEvents(0, events), static_cast<uint64_t>(1));
+    TEST_ASSERT(events.size() == 1 && events[0].kind == TransportEvent::Kind::LOCATE && events[0].frame == 500);
+    TEST_ASSERT_TRUE(replay.isFinished());
+    return true;
+}
+
+bool test_ControlReplay_Fast() {
+    // As fast as possible: a frame per update, whatever the recorded times
+    std::vector<ControlRecord> records;
+    records.push_back(frameRecord(0, 10));
+    records.push_back(commandRecord(5000000, "/videocomposer/layer/load"));
+    records.push_back(frameRecord(9000000, 11));
+    records.push_back(frameRecord(9040000, 12));
+
+    ControlReplay replay;
+    replay.setRecords(records, true);
+    replay.update(0);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(10));
+    replay.update(0);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(11));
+    size_t commands = replay.takeCommands([](const std::string&, const CommandArgs&, int64_t) {});
+    TEST_ASSERT_EQ(commands, static_cast<size_t>(1));
+    TEST_ASSERT_FALSE(replay.isFinished());
+    replay.update(0);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(12));
+    TEST_ASSERT_TRUE(replay.isFinished());
+
+    // A log of commands only: one command per update, timetags kept relative
+    std::vector<ControlRecord> oscOnly;
+    oscOnly.push_back(commandRecord(0, "/a"));
+    ControlRecord scheduled = commandRecord(1000, "/b");
+    scheduled.scheduled = true;
+    scheduled.atOffsetUs = 20000;
+    oscOnly.push_back(scheduled);
+    replay.setRecords(oscOnly, true);
+    TEST_ASSERT_EQ(replay.getFrame(), static_cast<int64_t>(-1));
+    replay.update(0);
+    std::vector<std::string> routed;
+    int64_t scheduledAtUs = 0;
+    auto route = [&](const std::string& path, const CommandArgs&, int64_t atUs) {
+        routed.push_back(path);
+        if (atUs != 0) {
+            scheduledAtUs = atUs;
+        }
+    };
+    TEST_ASSERT_EQ(replay.takeCommands(route), static_cast<size_t>(1));
+    int64_t beforeUs = vc_get_realtime();
+    replay.update(0);
+    TEST_ASSERT_EQ(replay.takeCommands(route), static_cast<size_t>(1));
+    TEST_ASSERT(routed.size() == 2 && routed[1] == "/b");
+    TEST_ASSERT(scheduledAtUs >= beforeUs + 20000 && scheduledAtUs < beforeUs + 20000 + 1000000);
+    return true;
+}
+
+bool test_ControlCapture_File() {
+    char directory[] = "/tmp/controlcapture-XXXXXX";
+    TEST_ASSERT(mkdtemp(directory) != nullptr);
+    std::string path = std::string(directory) + "/show.vcctrl";
+
+    ControlCapture& capture = ControlCapture::instance();
+    TEST_ASSERT(capture.start(path));
+    TEST_ASSERT_TRUE(capture.isRecording());
+    capture.recordFrame(250);
+    capture.recordTransport(TransportEvent::Kind::START, 250);
+    CommandArgs args;
+    args.addString("cue-2");
+    args.addInt(1);
+    capture.recordCommand("/videocomposer/layer/visible", args, 0);
+    capture.recordFrame(251);
+    TEST_ASSERT_EQ(capture.getRecordCount(), static_cast<uint64_t>(4));
+    capture.stop();
+    TEST_ASSERT_FALSE(capture.isRecording());
+
+    std::vector<ControlRecord> records;
+    TEST_ASSERT(ControlLog::load(path, records));
+    TEST_ASSERT_EQ(records.size(), static_cast<size_t>(4));
+    TEST_ASSERT(records[0].kind == ControlRecord::Kind::FRAME && records[0].frame == 250);
+    TEST_ASSERT(records[1].kind == ControlRecord::Kind::TRANSPORT && records[1].transport == TransportEvent::Kind::START);
+    TEST_ASSERT(records[2].path == "/videocomposer/layer/visible" && records[2].args.size() == 2);
+    TEST_ASSERT(!records[2].scheduled && records[2].args[1].toInt() == 1);
+    TEST_ASSERT(records[3].frame == 251 && records[3].timeUs >= records[0].timeUs);
+
+    // Not a log
+    std::string other = std::string(directory) + "/other";
+    FILE* file = std::fopen(other.c_str(), "wb");
+    TEST_ASSERT(file != nullptr);
+    std::fputs("not a control log", file);
+    std::fclose(file);
+    TEST_ASSERT_FALSE(ControlLog::load(other, records));
+
+    std::remove(path.c_str());
+    std::remove(other.c_str());
+    rmdir(directory);
+    return true;
+}
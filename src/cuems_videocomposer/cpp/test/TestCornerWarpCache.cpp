@@ -0,0 +1,75 @@
+#include "TestFramework.h"
+#include "../display/CornerWarpCache.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Apply a uHomography-layout matrix to a point
+void project(const float m[16], float x, float y, float& u, float& v) {
+    float w = m[3] * x + m[7] * y + m[15];
+    u = (m[0] * x + m[4] * y + m[12]) / w;
+    v = (m[1] * x + m[5] * y + m[13]) / w;
+}
+
+} // namespace
+
+bool test_CornerWarpCache_Solve() {
+    // Each quad corner lands on its offset corner
+    const float quadX = 0.75f, quadY = 1.0f;
+    const float corners[8] = {0.1f, 0.05f, -0.2f, 0.0f, 0.05f, -0.15f, 0.0f, 0.1f};
+    float matrix[16];
+    TEST_ASSERT(CornerWarpCache::solve(quadX, quadY, corners, matrix));
+    const float base[4][2] = {{-quadX, -quadY}, {quadX, -quadY}, {quadX, quadY}, {-quadX, quadY}};
+    for (int i = 0; i < 4; ++i) {
+        float u, v;
+        project(matrix, base[i][0], base[i][1], u, v);
+        TEST_ASSERT(std::abs(u - (base[i][0] + corners[i * 2])) < 1e-5f);
+        TEST_ASSERT(std::abs(v - (base[i][1] + corners[i * 2 + 1])) < 1e-5f);
+    }
+
+    // No offsets is the identity; a parallelogram is affine
+    const float none[8] = {};
+    TEST_ASSERT(CornerWarpCache::solve(quadX, quadY, none, matrix));
+    TEST_ASSERT(matrix[0] == 1.0f && matrix[5] == 1.0f && matrix[3] == 0.0f && matrix[7] == 0.0f);
+    TEST_ASSERT(CornerWarpCache::distortion(matrix, quadX, quadY) < 1.0001f);
+    const float shear[8] = {0.2f, 0.0f, 0.2f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    TEST_ASSERT(CornerWarpCache::solve(1.0f, 1.0f, shear, matrix));
+    TEST_ASSERT(std::abs(matrix[3]) < 1e-6f && std::abs(matrix[7]) < 1e-6f);
+
+    // Collapsed quads are rejected with the identity
+    const float collapsed[8] = {2.0f, 2.0f, 0.0f, 2.0f, 0.0f, 0.0f, 2.0f, 0.0f};
+    TEST_ASSERT(!CornerWarpCache::solve(1.0f, 1.0f, collapsed, matrix));
+    TEST_ASSERT(matrix[0] == 1.0f && matrix[12] == 0.0f);
+    return true;
+}
+
+bool test_CornerWarpCache_Reuse() {
+    CornerWarpCache cache;
+    float corners[8] = {0.02f, 0.0f, -0.02f, 0.01f, 0.0f, 0.0f, 0.01f, -0.01f};
+
+    // A static deform is solved once; mild keystones skip gradient sampling
+    const CornerWarpCache::Warp& first = cache.get(1.0f, 1.0f, corners);
+    TEST_ASSERT(&cache.get(1.0f, 1.0f, corners) == &first);
+    TEST_ASSERT(cache.getEntryCount() == 1);
+    TEST_ASSERT(first.isMild());
+
+    // A moved corner or letterboxed quad is a new warp
+    corners[2] = -0.6f;
+    corners[4] = -0.6f;
+    const CornerWarpCache::Warp& strong = cache.get(1.0f, 1.0f, corners);
+    TEST_ASSERT(cache.getEntryCount() == 2);
+    TEST_ASSERT(!strong.isMild());
+    cache.get(0.5f, 1.0f, corners);
+    TEST_ASSERT(cache.getEntryCount() == 3);
+
+    // Animated deforms stay bounded
+    for (size_t i = 0; i < CornerWarpCache::MAX_ENTRIES * 2; ++i) {
+        corners[0] = 0.001f * i;
+        cache.get(1.0f, 1.0f, corners);
+    }
+    TEST_ASSERT(cache.getEntryCount() == CornerWarpCache::MAX_ENTRIES);
+    return true;
+}
@@ -0,0 +1,258 @@
+#include "TestFramework.h"
+#include "../input/DecodeJitterTracker.h"
+#include "../input/DecodeAheadBudget.h"
+#include "../input/DecodeThreadBudget.h"
+#include "../input/DecodeScheduler.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_DecodeJitterTracker_Depth() {
+    const double period = 1.0 / 25.0;  // 40 ms
+    DecodeJitterTracker tracker;
+
+    // Too few samples: no estimate, keep the maximum
+    for (int i = 0; i < 4; ++i) {
+        tracker.addSample(0.005);
+    }
+    TEST_ASSERT_EQ(tracker.depthFor(period, 0.01, 2, 8), static_cast<size_t>(8));
+
+    // Steady 5 ms decodes: the minimum depth is enough
+    for (int i = 0; i < 100; ++i) {
+        tracker.addSample(0.005);
+    }
+    TEST_ASSERT_EQ(tracker.depthFor(period, 0.01, 2, 8), static_cast<size_t>(2));
+
+    // 5% of decodes spike to 130 ms: a 1% target must cover them (4 periods + shown frame)
+    tracker.reset();
+    for (int i = 0; i < 100; ++i) {
+        tracker.addSample(i % 20 == 0 ? 0.130 : 0.005);
+    }
+    TEST_ASSERT(tracker.percentile(0.5) < 0.01);
+    TEST_ASSERT_EQ(tracker.depthFor(period, 0.01, 2, 8), static_cast<size_t>(5));
+    // A 10% target tolerates them
+    TEST_ASSERT_EQ(tracker.depthFor(period, 0.10, 2, 8), static_cast<size_t>(2));
+    // Never beyond the pool
+    TEST_ASSERT_EQ(tracker.depthFor(period, 0.01, 2, 4), static_cast<size_t>(4));
+
+    // Slower than real time on average: depth cannot help, use everything
+    tracker.reset();
+    for (int i = 0; i < 50; ++i) {
+        tracker.addSample(0.050);
+    }
+    TEST_ASSERT_EQ(tracker.depthFor(period, 0.01, 2, 8), static_cast<size_t>(8));
+    return true;
+}
+
+bool test_DecodeAheadBudget_Share() {
+    DecodeAheadBudget budget;
+
+    // Unlimited: every demand is granted
+    DecodeAheadBudget::ClientId a = budget.addClient();
+    DecodeAheadBudget::ClientId b = budget.addClient();
+    TEST_ASSERT_EQ(budget.request(a, 600), static_cast<size_t>(600));
+
+    // Demands fit the budget
+    budget.configure(1000);
+    TEST_ASSERT_EQ(budget.request(b, 300), static_cast<size_t>(300));
+    TEST_ASSERT_EQ(budget.request(a, 600), static_cast<size_t>(600));
+
+    // Over budget, equal priority: each gets half
+    TEST_ASSERT_EQ(budget.request(b, 800), static_cast<size_t>(500));
+    TEST_ASSERT_EQ(budget.request(a, 800), static_cast<size_t>(500));
+
+    // Priority 3 vs 1: 750 / 250
+    budget.setPriority(a, 3);
+    TEST_ASSERT_EQ(budget.request(a, 800), static_cast<size_t>(750));
+    TEST_ASSERT_EQ(budget.request(b, 800), static_cast<size_t>(250));
+
+    // A small demand is met in full and leaves the rest to the others
+    DecodeAheadBudget::ClientId c = budget.addClient(4);
+    TEST_ASSERT_EQ(budget.request(c, 100), static_cast<size_t>(100));
+    TEST_ASSERT_EQ(budget.request(a, 800), static_cast<size_t>(675));
+    TEST_ASSERT_EQ(budget.request(b, 800), static_cast<size_t>(225));
+
+    // Leaving frees the share
+    budget.removeClient(c);
+    budget.removeClient(b);
+    TEST_ASSERT_EQ(budget.request(a, 800), static_cast<size_t>(800));
+    return true;
+}
+
+bool test_DecodeThreadBudget_Share() {
+    DecodeThreadBudget budget;
+    budget.configure(8);
+
+    // Unknown clients keep FFmpeg's default
+    TEST_ASSERT_EQ(budget.grant(99).threads, 0);
+
+    // Two HD layers split the cores, with frame threading
+    DecodeThreadBudget::ClientId a = budget.addClient(1920, 1080);
+    DecodeThreadBudget::ClientId b = budget.addClient(1920, 1080);
+    TEST_ASSERT_EQ(budget.grant(a).threads, 4);
+    TEST_ASSERT_EQ(budget.grant(b).threads, 4);
+    TEST_ASSERT(budget.grant(a).frameThreads);
+
+    // A UHD layer weighs four HD ones: 1.33 / 1.33 / 5.33, leftover to the first
+    uint64_t generation = budget.getGeneration();
+    DecodeThreadBudget::ClientId c = budget.addClient(3840, 2160);
+    TEST_ASSERT(budget.getGeneration() != generation);
+    TEST_ASSERT_EQ(budget.grant(a).threads, 2);
+    TEST_ASSERT_EQ(budget.grant(b).threads, 1);
+    TEST_ASSERT_EQ(budget.grant(c).threads, 5);
+    TEST_ASSERT(!budget.grant(b).frameThreads);  // One thread: nothing to thread
+
+    // Priority 4 on b: 0.89 / 3.56 / 3.56
+    budget.setPriority(b, 4);
+    TEST_ASSERT_EQ(budget.grant(a).threads, 1);
+    TEST_ASSERT_EQ(budget.grant(b).threads, 4);
+    TEST_ASSERT_EQ(budget.grant(c).threads, 3);
+
+    // Low latency keeps the share but drops frame threading
+    budget.setLowLatency(c, true);
+    TEST_ASSERT_EQ(budget.grant(c).threads, 3);
+    TEST_ASSERT(!budget.grant(c).frameThreads);
+
+    // Unchanged settings do not trigger a rebalance
+    generation = budget.getGeneration();
+    budget.setLowLatency(c, true);
+    budget.setPriority(b, 4);
+    TEST_ASSERT_EQ(budget.getGeneration(), generation);
+
+    // More layers than threads: one each
+    std::vector<DecodeThreadBudget::ClientId> many;
+    for (int i = 0; i < 10; ++i) {
+        many.push_back(budget.addClient(1280, 720));
+    }
+    for (DecodeThreadBudget::ClientId id : many) {
+        TEST_ASSERT_EQ(budget.grant(id).threads, 1);
+        budget.removeClient(id);
+    }
+
+    // Leaving returns the share
+    budget.removeClient(b);
+    budget.removeClient(c);
+    TEST_ASSERT_EQ(budget.grant(a).threads, 8);
+
+    // Never beyond the per-decoder cap
+    budget.configure(64);
+    TEST_ASSERT_EQ(budget.grant(a).threads, DecodeThreadBudget::MAX_CLIENT_THREADS);
+    return true;
+}
+
+bool test_DecodeScheduler_Deadline() {
+    // Priority shortens the slack, hidden layers queue behind visible ones
+    TEST_ASSERT(DecodeScheduler::deadline(10.0, 0.3, 1, true) > DecodeScheduler::deadline(10.0, 0.016, 1, true));
+    TEST_ASSERT_EQ(DecodeScheduler::deadline(10.0, 0.2, 2, true), DecodeScheduler::deadline(10.0, 0.1, 1, true));
+    TEST_ASSERT(DecodeScheduler::deadline(10.0, 0.0, 1, false) > DecodeScheduler::deadline(10.0, 0.9, 1, true));
+    TEST_ASSERT_EQ(DecodeScheduler::deadline(10.0, -1.0, 1, true), 10.0);
+    return true;
+}
+
+bool test_DecodeScheduler_EarliestDeadlineFirst() {
+    using std::chrono::milliseconds;
+    DecodeScheduler scheduler;
+    scheduler.configure(1, 1);
+    TEST_ASSERT_EQ(scheduler.getSlots(DecodeScheduler::Resource::CPU), 1);
+
+    DecodeScheduler::ClientId holder = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    DecodeScheduler::ClientId relaxed = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    DecodeScheduler::ClientId urgent = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    DecodeScheduler::ClientId hidden = scheduler.addClient(DecodeScheduler::Resource::CPU, 4);
+    DecodeScheduler::ClientId hardware = scheduler.addClient(DecodeScheduler::Resource::HARDWARE);
+    scheduler.setVisible(hidden, false);
+
+    // Unknown clients are not scheduled
+    TEST_ASSERT(scheduler.acquire(999, 0.0, milliseconds(0)));
+
+    TEST_ASSERT(scheduler.acquire(holder, 0.5, milliseconds(0)));
+    TEST_ASSERT(!scheduler.acquire(relaxed, 0.3, milliseconds(0)));  // Slot taken
+    TEST_ASSERT(scheduler.acquire(hardware, 0.0, milliseconds(0)));  // Other resource
+    scheduler.release(hardware);
+
+    // Three layers wait; the slot goes to the one closest to running dry
+    std::atomic<int> order{0};
+    int relaxedTurn = 0, urgentTurn = 0, hiddenTurn = 0;
+    auto wait = [&](DecodeScheduler::ClientId id, double slack, int& turn) {
+        if (scheduler.acquire(id, slack, milliseconds(2000))) {
+            turn = ++order;
+            std::this_thread::sleep_for(milliseconds(5));
+            scheduler.release(id);
+        }
+    };
+    std::thread t1(wait, hidden, 0.0, std::ref(hiddenTurn));
+    std::thread t2(wait, relaxed, 0.3, std::ref(relaxedTurn));
+    std::thread t3(wait, urgent, 0.016, std::ref(urgentTurn));
+    std::this_thread::sleep_for(milliseconds(50));  // All three waiting
+    scheduler.release(holder);
+    t1.join();
+    t2.join();
+    t3.join();
+    TEST_ASSERT_EQ(urgentTurn, 1);
+    TEST_ASSERT_EQ(relaxedTurn, 2);
+    TEST_ASSERT_EQ(hiddenTurn, 3);
+
+    // Removing a client frees what it held
+    TEST_ASSERT(scheduler.acquire(holder, 0.0, milliseconds(0)));
+    scheduler.removeClient(holder);
+    TEST_ASSERT(scheduler.acquire(relaxed, 0.0, milliseconds(0)));
+    scheduler.release(relaxed);
+    return true;
+}
+
+bool test_DecodeScheduler_Background() {
+    using std::chrono::milliseconds;
+    DecodeScheduler scheduler;
+    scheduler.configure(2, 1);
+    DecodeScheduler::ClientId layer = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    DecodeScheduler::ClientId other = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    DecodeScheduler::ClientId thumbnails = scheduler.addClient(DecodeScheduler::Resource::CPU);
+    DecodeScheduler::ClientId hardwareThumbnails = scheduler.addClient(DecodeScheduler::Resource::HARDWARE);
+    scheduler.setBackground(thumbnails, true);
+    scheduler.setBackground(hardwareThumbnails, true);
+
+    // The last free slot is kept for playback
+    TEST_ASSERT(scheduler.acquire(layer, 0.0, milliseconds(0)));
+    TEST_ASSERT(!scheduler.acquire(thumbnails, 100.0, milliseconds(0)));
+    scheduler.release(layer);
+    TEST_ASSERT(scheduler.acquire(thumbnails, 100.0, milliseconds(0)));
+    TEST_ASSERT(scheduler.acquire(other, 100.0, milliseconds(0)));
+    scheduler.release(other);
+    scheduler.release(thumbnails);
+
+    // A single slot is shared only while nobody else wants it
+    TEST_ASSERT(scheduler.acquire(hardwareThumbnails, 0.0, milliseconds(0)));
+    scheduler.release(hardwareThumbnails);
+
+    // Behind any waiter, whatever the deadlines
+    TEST_ASSERT(scheduler.acquire(layer, 0.0, milliseconds(0)));
+    TEST_ASSERT(scheduler.acquire(other, 0.0, milliseconds(0)));
+    int otherTurn = 0, thumbnailTurn = 0;
+    std::atomic<int> order{0};
+    std::thread background([&] {
+        if (scheduler.acquire(thumbnails, 0.0, milliseconds(2000))) {
+            thumbnailTurn = ++order;
+            scheduler.release(thumbnails);
+        }
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    std::thread playback([&] {
+        if (scheduler.acquire(other, 10.0, milliseconds(2000))) {
+            otherTurn = ++order;
+            std::this_thread::sleep_for(milliseconds(20));
+            scheduler.release(other);
+        }
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    scheduler.release(other);   // One free: playback takes it
+    std::this_thread::sleep_for(milliseconds(50));
+    scheduler.release(layer);
+    playback.join();
+    background.join();
+    TEST_ASSERT_EQ(otherTurn, 1);
+    TEST_ASSERT_EQ(thumbnailTurn, 2);
+    return true;
+}
@@ -0,0 +1,80 @@
+#include "TestFramework.h"
+#include "../layer/DecodeGovernor.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+DecodeGovernor::LayerSample sample(const std::string& cueId, int priority, bool hasProxy, uint64_t misses) {
+    DecodeGovernor::LayerSample layer;
+    layer.cueId = cueId;
+    layer.priority = priority;
+    layer.hasProxy = hasProxy;
+    layer.misses = misses;
+    return layer;
+}
+
+} // namespace
+
+bool test_DecodeGovernor_DegradesByPriority() {
+    DecodeGovernor governor;
+    DecodeGovernor::Settings settings;
+    settings.holdSeconds = 5.0;
+    governor.configure(settings);
+
+    // "main" is critical, "bg" (priority 1) has a proxy, "pip" (priority 2) too
+    auto layers = [](uint64_t misses) {
+        std::vector<DecodeGovernor::LayerSample> all = {
+            sample("main", 3, true, 0), sample("bg", 1, true, misses), sample("pip", 2, true, 0)};
+        all[0].critical = true;
+        return all;
+    };
+
+    double t = 100.0;
+    TEST_ASSERT_TRUE(governor.update(layers(0), 0, t).empty());
+
+    // Overloaded: proxies first, lowest priority first, one step per second
+    t += 1.0;
+    auto decisions = governor.update(layers(10), 0, t);
+    TEST_ASSERT_EQ(decisions.size(), static_cast<size_t>(1));
+    TEST_ASSERT_TRUE(decisions[0].cueId == "bg");
+    TEST_ASSERT_TRUE(decisions[0].level == DecodeGovernor::Level::PROXY);
+    t += 1.0;
+    decisions = governor.update(layers(20), 0, t);
+    TEST_ASSERT_TRUE(decisions.size() == 1 && decisions[0].cueId == "pip");
+    TEST_ASSERT_TRUE(decisions[0].level == DecodeGovernor::Level::PROXY);
+
+    // Then half rate; late output frames count as overload as well
+    t += 1.0;
+    decisions = governor.update(layers(20), 5, t);
+    TEST_ASSERT_TRUE(decisions.size() == 1 && decisions[0].cueId == "bg");
+    TEST_ASSERT_TRUE(decisions[0].level == DecodeGovernor::Level::HALF_RATE);
+    t += 1.0;
+    decisions = governor.update(layers(30), 5, t);
+    TEST_ASSERT_TRUE(decisions.size() == 1 && decisions[0].cueId == "pip");
+    t += 1.0;
+    TEST_ASSERT_TRUE(governor.update(layers(40), 5, t).empty());  // Nothing left: the critical layer stays
+    TEST_ASSERT_TRUE(governor.getLevel("main") == DecodeGovernor::Level::FULL);
+    TEST_ASSERT_EQ(governor.getStepCount(), static_cast<size_t>(4));
+
+    // Load gone: nothing until the hold has passed, then undone last step first
+    t += 2.0;
+    TEST_ASSERT_TRUE(governor.update(layers(40), 5, t).empty());
+    t += 4.0;
+    decisions = governor.update(layers(40), 5, t);
+    TEST_ASSERT_TRUE(decisions.size() == 1 && decisions[0].cueId == "pip");
+    TEST_ASSERT_TRUE(decisions[0].level == DecodeGovernor::Level::PROXY);
+
+    // A layer made critical is restored at once
+    auto critical = layers(40);
+    critical[1].critical = true;
+    t += 0.25;
+    decisions = governor.update(critical, 5, t);
+    TEST_ASSERT_TRUE(decisions.size() == 1 && decisions[0].cueId == "bg");
+    TEST_ASSERT_TRUE(decisions[0].level == DecodeGovernor::Level::FULL);
+    TEST_ASSERT_EQ(governor.getStepCount(), static_cast<size_t>(1));
+    return true;
+}
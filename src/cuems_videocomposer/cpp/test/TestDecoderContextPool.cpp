@@ -0,0 +1,117 @@
+#include "TestFramework.h"
+#include "../input/DecoderContextPool.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/pixfmt.h>
+}
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Raw video decoders: always built, open without headers
+AVCodecParameters* rawParams(int width, int height) {
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    params->codec_type = AVMEDIA_TYPE_VIDEO;
+    params->codec_id = AV_CODEC_ID_RAWVIDEO;
+    params->width = width;
+    params->height = height;
+    params->format = AV_PIX_FMT_RGBA;
+    return params;
+}
+
+AVCodecContext* openRaw(const AVCodecParameters* params) {
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_RAWVIDEO);
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    if (!ctx || avcodec_parameters_to_context(ctx, params) < 0 || avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+    }
+    return ctx;
+}
+
+} // namespace
+
+bool test_DecoderContextPool_ReuseByKey() {
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_RAWVIDEO);
+    TEST_ASSERT_TRUE(codec != nullptr);
+    AVCodecParameters* hd = rawParams(1920, 1080);
+    AVCodecParameters* sd = rawParams(720, 576);
+
+    DecoderContextPool pool;
+    DecoderContextPool::Key hdKey = DecoderContextPool::makeKey(codec, hd, "");
+    DecoderContextPool::Key sdKey = DecoderContextPool::makeKey(codec, sd, "");
+    TEST_ASSERT_TRUE(hdKey != sdKey);
+    TEST_ASSERT_TRUE(hdKey != DecoderContextPool::makeKey(codec, hd, "/dev/dri/renderD128"));
+    TEST_ASSERT_TRUE(hdKey != DecoderContextPool::makeKey(codec, hd, "", 4, true));
+
+    // Other headers: the decoder would keep the ones it opened with
+    uint8_t headers[4] = {1, 2, 3, 4};
+    hd->extradata = static_cast<uint8_t*>(av_mallocz(sizeof(headers) + AV_INPUT_BUFFER_PADDING_SIZE));
+    hd->extradata_size = sizeof(headers);
+    std::copy(headers, headers + sizeof(headers), hd->extradata);
+    TEST_ASSERT_TRUE(hdKey != DecoderContextPool::makeKey(codec, hd, ""));
+    TEST_ASSERT_TRUE(DecoderContextPool::makeKey(codec, hd, "") == DecoderContextPool::makeKey(codec, hd, ""));
+
+    // Returned flushed, taken by the next matching load only
+    AVCodecContext* ctx = openRaw(sd);
+    TEST_ASSERT_TRUE(ctx != nullptr);
+    AVCodecContext* opened = ctx;
+    ctx->skip_frame = AVDISCARD_NONKEY;
+    pool.release(sdKey, ctx);
+    TEST_ASSERT_TRUE(ctx == nullptr);
+    TEST_ASSERT_EQ(pool.getIdleCount(), static_cast<size_t>(1));
+    TEST_ASSERT_TRUE(pool.acquire(hdKey) == nullptr);
+    AVCodecContext* reused = pool.acquire(sdKey);
+    TEST_ASSERT_TRUE(reused == opened);
+    TEST_ASSERT_TRUE(reused->skip_frame == AVDISCARD_DEFAULT);
+    TEST_ASSERT_EQ(pool.getReuseCount(), static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(pool.getIdleCount(), static_cast<size_t>(0));
+    pool.release(sdKey, reused);
+
+    avcodec_parameters_free(&hd);
+    avcodec_parameters_free(&sd);
+    return true;
+}
+
+bool test_DecoderContextPool_Capacity() {
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_RAWVIDEO);
+    AVCodecParameters* params[3] = {rawParams(320, 240), rawParams(640, 480), rawParams(1280, 720)};
+    DecoderContextPool::Key keys[3];
+    for (int i = 0; i < 3; ++i) {
+        keys[i] = DecoderContextPool::makeKey(codec, params[i], "");
+    }
+
+    // Beyond the capacity the least recently returned goes
+    DecoderContextPool pool;
+    pool.setCapacity(2);
+    for (int i = 0; i < 3; ++i) {
+        AVCodecContext* ctx = openRaw(params[i]);
+        TEST_ASSERT_TRUE(ctx != nullptr);
+        pool.release(keys[i], ctx);
+    }
+    TEST_ASSERT_EQ(pool.getIdleCount(), static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(pool.acquire(keys[0]) == nullptr);
+    AVCodecContext* newest = pool.acquire(keys[2]);
+    TEST_ASSERT_TRUE(newest != nullptr);
+
+    // Off: contexts are freed on release; shrinking frees the excess
+    pool.setCapacity(0);
+    TEST_ASSERT_EQ(pool.getIdleCount(), static_cast<size_t>(0));
+    pool.release(keys[2], newest);
+    TEST_ASSERT_TRUE(newest == nullptr);
+    TEST_ASSERT_EQ(pool.getIdleCount(), static_cast<size_t>(0));
+
+    // Contexts without a key (unknown decoder) are never kept
+    pool.setCapacity(2);
+    AVCodecContext* unkeyed = openRaw(params[0]);
+    pool.release(DecoderContextPool::Key(), unkeyed);
+    TEST_ASSERT_EQ(pool.getIdleCount(), static_cast<size_t>(0));
+
+    for (AVCodecParameters*& p : params) {
+        avcodec_parameters_free(&p);
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#include "TestFramework.h"
+#include "../display/DrawOrder.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+DrawOrder::Item item(uint32_t key, float x0, float y0, float x1, float y1) {
+    DrawOrder::Item result;
+    result.stateKey = key;
+    result.x0 = x0;
+    result.y0 = y0;
+    result.x1 = x1;
+    result.y1 = y1;
+    return result;
+}
+
+} // namespace
+
+bool test_DrawOrder_GroupsDisjoint() {
+    // Four tiles in a row, alternating plain (0) and colour-corrected (1)
+    std::vector<DrawOrder::Item> items = {
+        item(0, 0, 0, 1, 1), item(1, 1, 0, 2, 1), item(0, 2, 0, 3, 1), item(1, 3, 0, 4, 1)};
+    std::vector<size_t> order;
+    DrawOrder::groupByState(items, order);
+    TEST_ASSERT_EQ(static_cast<int>(order.size()), 4);
+    TEST_ASSERT_EQ(static_cast<int>(order[0]), 0);
+    TEST_ASSERT_EQ(static_cast<int>(order[1]), 2);
+    TEST_ASSERT_EQ(static_cast<int>(order[2]), 1);
+    TEST_ASSERT_EQ(static_cast<int>(order[3]), 3);
+    return true;
+}
+
+bool test_DrawOrder_KeepsOverlapOrder() {
+    // Layer 2 overlaps layer 1: it cannot jump it, even with a matching key
+    std::vector<DrawOrder::Item> items = {
+        item(0, 0, 0, 1, 1), item(1, 2, 0, 4, 2), item(0, 3, 1, 5, 3), item(1, 6, 0, 7, 1)};
+    std::vector<size_t> order;
+    DrawOrder::groupByState(items, order);
+    TEST_ASSERT_EQ(static_cast<int>(order[0]), 0);
+    TEST_ASSERT_EQ(static_cast<int>(order[1]), 1);
+    TEST_ASSERT_EQ(static_cast<int>(order[2]), 3);
+    TEST_ASSERT_EQ(static_cast<int>(order[3]), 2);
+
+    // Full-screen layers overlap everything: order unchanged
+    std::vector<DrawOrder::Item> stacked = {
+        item(0, -1, -1, 1, 1), item(1, -1, -1, 1, 1), item(0, -1, -1, 1, 1)};
+    DrawOrder::groupByState(stacked, order);
+    TEST_ASSERT_EQ(static_cast<int>(order[0]), 0);
+    TEST_ASSERT_EQ(static_cast<int>(order[1]), 1);
+    TEST_ASSERT_EQ(static_cast<int>(order[2]), 2);
+
+    // Touching edges do not overlap
+    TEST_ASSERT(!DrawOrder::overlaps(items[0], item(0, 1, 0, 2, 1)));
+    TEST_ASSERT(DrawOrder::overlaps(items[1], items[2]));
+    return true;
+}
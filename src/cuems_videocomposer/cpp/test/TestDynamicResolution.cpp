@@ -0,0 +1,68 @@
+#include "TestFramework.h"
+#include "../display/DynamicResolution.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+/** Feed frames of a cost at native size (cost follows the pixel count) */
+int run(DynamicResolution& controller, double nativeMs, int frames) {
+    int changes = 0;
+    for (int i = 0; i < frames; ++i) {
+        float scale = controller.getScale();
+        changes += controller.update(nativeMs * scale * scale) ? 1 : 0;
+    }
+    return changes;
+}
+
+} // namespace
+
+bool test_DynamicResolution_Hysteresis() {
+    DynamicResolution controller;
+    controller.setBudget(20.0);
+    TEST_ASSERT_FALSE(controller.update(40.0));     // Off
+    TEST_ASSERT_EQ(controller.getScale(), 1.0f);
+
+    controller.setEnabled(true);
+
+    // Under budget: native
+    TEST_ASSERT_EQ(run(controller, 15.0, 200), 0);
+    TEST_ASSERT_EQ(controller.getScale(), 1.0f);
+
+    // A single slow frame does not drop it
+    TEST_ASSERT_FALSE(controller.update(19.0));
+    TEST_ASSERT_FALSE(controller.update(10.0));
+    TEST_ASSERT_EQ(controller.getScale(), 1.0f);
+
+    // Sustained overload drops to what fits the target in one change
+    TEST_ASSERT_EQ(run(controller, 30.0, DynamicResolution::DOWN_FRAMES), 1);
+    float scale = controller.getScale();
+    TEST_ASSERT(scale < 1.0f && scale >= controller.getMinScale());
+    TEST_ASSERT(30.0 * scale * scale <= DynamicResolution::TARGET * 20.0);
+
+    // It holds there (no oscillation) while the load stays
+    TEST_ASSERT_EQ(run(controller, 30.0, 500), 0);
+    TEST_ASSERT_EQ(controller.getScale(), scale);
+
+    // The load gone, it climbs back one step at a time to native
+    int steps = run(controller, 5.0, 2000);
+    TEST_ASSERT(steps >= 2);
+    TEST_ASSERT_EQ(controller.getScale(), 1.0f);
+
+    // Never below the minimum
+    controller.setMinScale(0.75f);
+    run(controller, 200.0, 100);
+    TEST_ASSERT_EQ(controller.getScale(), 0.75f);
+
+    // Off: native at once
+    controller.setEnabled(false);
+    TEST_ASSERT_EQ(controller.getScale(), 1.0f);
+
+    // Minimum snaps to a step
+    controller.setMinScale(0.3f);
+    TEST_ASSERT_EQ(controller.getMinScale(), 0.25f);
+    TEST_ASSERT_EQ(DynamicResolution::scaledSize(1920, 0.625f), 1200);
+    TEST_ASSERT_EQ(DynamicResolution::scaledSize(1, 0.125f), 1);
+    return true;
+}
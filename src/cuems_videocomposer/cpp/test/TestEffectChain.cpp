@@ -0,0 +1,135 @@
+#include "TestFramework.h"
+#include "../display/EffectChain.h"
+#include "../display/EffectTargetPool.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+float kernelSum(const EffectChain::Plan& plan) {
+    float sum = plan.weights[0];
+    for (int i = 1; i <= plan.taps; ++i) {
+        sum += 2.0f * plan.weights[i];
+    }
+    return sum;
+}
+
+} // namespace
+
+bool test_EffectChain_Plan() {
+    LayerProperties::Effects effects;
+    EffectChain::Plan plan = EffectChain::plan(effects, 1920, 1080);
+    TEST_ASSERT_FALSE(plan.fused);
+    TEST_ASSERT_FALSE(plan.filter);
+    TEST_ASSERT_EQ(plan.passes(), 0);
+
+    // Key and vignette are fused into the layer draw, no passes
+    effects.chromaKey.enabled = true;
+    effects.vignetteAmount = 0.5f;
+    plan = EffectChain::plan(effects, 1920, 1080);
+    TEST_ASSERT_TRUE(plan.fused);
+    TEST_ASSERT_FALSE(plan.filter);
+    TEST_ASSERT_EQ(plan.filterWeight, 0.0f);
+
+    // A small blur runs at half size
+    effects.blurRadius = 8.0f;
+    plan = EffectChain::plan(effects, 1920, 1081);
+    TEST_ASSERT_TRUE(plan.filter);
+    TEST_ASSERT_EQ(plan.passes(), 3);
+    TEST_ASSERT_EQ(plan.shift, 1);
+    TEST_ASSERT_EQ(plan.width, 960);
+    TEST_ASSERT_EQ(plan.height, 541);
+    TEST_ASSERT_EQ(plan.filterWeight, 1.0f);
+    TEST_ASSERT_TRUE(plan.taps > 0 && plan.taps <= EffectChain::MAX_TAPS);
+    TEST_ASSERT_TRUE(std::fabs(kernelSum(plan) - 1.0f) < 1e-4f);
+
+    // A wide one goes smaller to stay within the taps
+    effects.blurRadius = 100.0f;
+    plan = EffectChain::plan(effects, 1920, 1080);
+    TEST_ASSERT_EQ(plan.shift, 3);
+    TEST_ASSERT_EQ(plan.width, 240);
+    TEST_ASSERT_TRUE(std::fabs(kernelSum(plan) - 1.0f) < 1e-4f);
+    effects.blurRadius = 5000.0f;
+    plan = EffectChain::plan(effects, 1920, 1080);
+    TEST_ASSERT_EQ(plan.shift, EffectChain::MAX_SHIFT);
+    TEST_ASSERT_EQ(plan.taps, EffectChain::MAX_TAPS);
+    TEST_ASSERT_TRUE(std::fabs(kernelSum(plan) - 1.0f) < 1e-4f);
+
+    // Offsets lie between the two texels each tap reads
+    for (int i = 1; i <= plan.taps; ++i) {
+        TEST_ASSERT_TRUE(plan.offsets[i] >= 2 * i - 1 && plan.offsets[i] <= 2 * i);
+    }
+
+    // Sharpen subtracts the blurred image (blur wins when both are set)
+    effects.blurRadius = 0.0f;
+    effects.sharpenAmount = 0.75f;
+    plan = EffectChain::plan(effects, 1920, 1080);
+    TEST_ASSERT_TRUE(plan.filter);
+    TEST_ASSERT_EQ(plan.filterWeight, -0.75f);
+    effects.blurRadius = 4.0f;
+    plan = EffectChain::plan(effects, 1920, 1080);
+    TEST_ASSERT_EQ(plan.filterWeight, 1.0f);
+
+    // Nothing to filter without a source
+    plan = EffectChain::plan(effects, 0, 0);
+    TEST_ASSERT_FALSE(plan.filter);
+    TEST_ASSERT_EQ(plan.filterWeight, 0.0f);
+    return true;
+}
+
+bool test_EffectChain_TargetPool() {
+    int live = 0;
+    int nextName = 1;
+    EffectTargetPool::Backend backend;
+    backend.create = [&](int width, int height, EffectTargetPool::Target& target) {
+        if (width > 4096) {
+            return false;
+        }
+        target.fbo = static_cast<GLuint>(nextName++);
+        target.texture = static_cast<GLuint>(nextName++);
+        ++live;
+        return true;
+    };
+    backend.destroy = [&](const EffectTargetPool::Target&) { --live; };
+
+    {
+        EffectTargetPool pool(backend);
+        const EffectTargetPool::Target* a = pool.acquire(960, 540);
+        const EffectTargetPool::Target* b = pool.acquire(960, 540);
+        TEST_ASSERT_TRUE(a && b && a != b);
+        TEST_ASSERT_EQ(a->width, 960);
+        TEST_ASSERT_EQ(a->height, 540);
+        TEST_ASSERT_TRUE(pool.acquire(8192, 8192) == nullptr);
+
+        // The next layer's passes get the same targets back
+        pool.release(a);
+        pool.release(b);
+        const EffectTargetPool::Target* c = pool.acquire(960, 540);
+        TEST_ASSERT_TRUE(c == a || c == b);
+        TEST_ASSERT_EQ(pool.getReuseCount(), 1u);
+        pool.release(c);
+
+        // Only an exact size is reused
+        const EffectTargetPool::Target* d = pool.acquire(480, 270);
+        TEST_ASSERT_TRUE(d != a && d != b);
+        TEST_ASSERT_EQ(pool.getCreatedCount(), 3u);
+        TEST_ASSERT_EQ(live, 3);
+
+        // Idle targets go, the one in use stays
+        for (uint64_t frame = 0; frame <= EffectTargetPool::IDLE_FRAMES; ++frame) {
+            pool.endFrame();
+        }
+        TEST_ASSERT_EQ(pool.getTargetCount(), 1u);
+        TEST_ASSERT_EQ(live, 1);
+        pool.release(d);
+        pool.clear();
+        TEST_ASSERT_EQ(live, 0);
+
+        pool.acquire(960, 540);
+    }
+    // The pool deletes what it still holds
+    TEST_ASSERT_EQ(live, 0);
+    return true;
+}
@@ -0,0 +1,86 @@
+#include "TestFramework.h"
+#include "../video/FieldSelector.h"
+#include <cmath>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Phases of each source frame's output frames (vsyncs at outputHz)
+std::vector<std::vector<int>> cadence(double framerate, double outputHz, int vsyncs) {
+    FieldSelector selector;
+    std::vector<std::vector<int>> frames;
+    int64_t shown = -1;
+    for (int i = 0; i < vsyncs; ++i) {
+        double now = i / outputHz;
+        int64_t frame = static_cast<int64_t>(std::floor(now * framerate + 1e-9));
+        if (frame != shown) {
+            shown = frame;
+            frames.emplace_back();
+        }
+        selector.update(static_cast<uint64_t>(frame + 1), now, framerate);
+        frames.back().push_back(selector.getPhase());
+    }
+    return frames;
+}
+
+} // namespace
+
+bool test_FieldSelector_Parity() {
+    using Mode = FieldSelector::Mode;
+    TEST_ASSERT(FieldSelector::parseMode("bob") == Mode::BOB);
+    TEST_ASSERT(FieldSelector::parseMode("adaptive") == Mode::ADAPTIVE);
+    TEST_ASSERT(FieldSelector::parseMode("off") == Mode::OFF);
+    TEST_ASSERT(FieldSelector::parseMode("") == Mode::AUTO);
+
+    // Auto: interlaced sources only
+    TEST_ASSERT(FieldSelector::resolve(Mode::AUTO, FieldOrder::TOP_FIRST) == Mode::ADAPTIVE);
+    TEST_ASSERT(FieldSelector::resolve(Mode::AUTO, FieldOrder::PROGRESSIVE) == Mode::OFF);
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::AUTO, FieldOrder::PROGRESSIVE, 1), -1);
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::OFF, FieldOrder::TOP_FIRST, 0), -1);
+
+    // First field in time, then the other
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::AUTO, FieldOrder::TOP_FIRST, 0), 0);
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::AUTO, FieldOrder::TOP_FIRST, 1), 1);
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::BOB, FieldOrder::BOTTOM_FIRST, 0), 1);
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::BOB, FieldOrder::BOTTOM_FIRST, 1), 0);
+    // Forced on an unflagged source: top first
+    TEST_ASSERT_EQ(FieldSelector::parity(Mode::BOB, FieldOrder::PROGRESSIVE, 0), 0);
+    return true;
+}
+
+bool test_FieldSelector_Cadence() {
+    // Field rate equals output rate: every field once, in order
+    for (const auto& rates : {std::vector<double>{25.0, 50.0}, std::vector<double>{30000.0 / 1001.0, 60000.0 / 1001.0}}) {
+        auto frames = cadence(rates[0], rates[1], 200);
+        for (size_t i = 1; i + 1 < frames.size(); ++i) {
+            TEST_ASSERT_EQ(static_cast<int>(frames[i].size()), 2);
+            TEST_ASSERT_EQ(frames[i][0], 0);
+            TEST_ASSERT_EQ(frames[i][1], 1);
+        }
+    }
+
+    // 25i on 60 Hz: frames take two or three vsyncs, both fields shown, never out of order
+    auto frames = cadence(25.0, 60.0, 600);
+    for (size_t i = 1; i + 1 < frames.size(); ++i) {
+        TEST_ASSERT_EQ(frames[i][0], 0);
+        TEST_ASSERT_EQ(frames[i].back(), 1);
+        for (size_t v = 1; v < frames[i].size(); ++v) {
+            TEST_ASSERT_TRUE(frames[i][v] >= frames[i][v - 1]);
+        }
+    }
+
+    // A held frame (paused) stays on its second field; no rate, no second field
+    FieldSelector held;
+    held.update(1, 0.0, 25.0);
+    held.update(1, 1.0, 25.0);
+    held.update(1, 2.0, 25.0);
+    TEST_ASSERT_EQ(held.getPhase(), 1);
+    FieldSelector unknown;
+    unknown.update(1, 0.0, 0.0);
+    unknown.update(1, 1.0, 0.0);
+    TEST_ASSERT_EQ(unknown.getPhase(), 0);
+    return true;
+}
@@ -0,0 +1,64 @@
+#include "TestFramework.h"
+#include "../output/FileEncoderOutput.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_FileEncoderOutput_ProRes() {
+    std::string path = "/tmp/vc-test-render-" + std::to_string(getpid()) + ".mov";
+
+    FileEncoderOutput sink;
+    OutputSinkConfig config;
+    config.width = 65;      // Rounded down to 64 for 4:2:2
+    config.height = 36;
+    config.frameRate = 25.0;
+    config.codec = "prores";
+    TEST_ASSERT(sink.open(path, config));
+    TEST_ASSERT(sink.isReady());
+    TEST_ASSERT(sink.getDropPolicy() == OutputSink::DropPolicy::BLOCK);
+
+    // Not RGBA: refused
+    std::vector<uint8_t> pixels(FrameData::frameSize(PixelFormat::RGBA32, 64, 36));
+    FrameData frame;
+    frame.data = pixels.data();
+    frame.size = pixels.size();
+    frame.width = 64;
+    frame.height = 36;
+    frame.format = PixelFormat::NV12;
+    TEST_ASSERT(!sink.writeFrame(frame));
+
+    frame.format = PixelFormat::RGBA32;
+    for (int i = 0; i < 5; ++i) {
+        std::fill(pixels.begin(), pixels.end(), static_cast<uint8_t>(40 * i));
+        TEST_ASSERT(sink.writeFrame(frame));
+    }
+    sink.close();
+    TEST_ASSERT(!sink.isReady());
+
+    // Read the file back: every frame is one intra packet
+    AVFormatContext* input = nullptr;
+    TEST_ASSERT(avformat_open_input(&input, path.c_str(), nullptr, nullptr) == 0);
+    TEST_ASSERT(avformat_find_stream_info(input, nullptr) >= 0);
+    TEST_ASSERT(input->nb_streams == 1);
+    AVCodecParameters* codecpar = input->streams[0]->codecpar;
+    TEST_ASSERT(codecpar->codec_id == AV_CODEC_ID_PRORES);
+    TEST_ASSERT_EQ(codecpar->width, 64);
+    TEST_ASSERT_EQ(codecpar->height, 36);
+    int packets = 0;
+    AVPacket* packet = av_packet_alloc();
+    while (av_read_frame(input, packet) >= 0) {
+        ++packets;
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&input);
+    TEST_ASSERT_EQ(packets, 5);
+
+    std::remove(path.c_str());
+    return true;
+}
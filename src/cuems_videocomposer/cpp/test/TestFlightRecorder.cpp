@@ -0,0 +1,75 @@
+#include "TestFramework.h"
+#include "../utils/FlightRecorder.h"
+#include "../utils/FrameTracer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_FlightRecorder_Snapshot() {
+    char tmpl[] = "/tmp/cvc_flight_XXXXXX";
+    const char* dir = mkdtemp(tmpl);
+    TEST_ASSERT_TRUE(dir != nullptr);
+
+    FlightRecorder recorder;
+    FlightRecorder::Settings settings;
+    settings.windowSeconds = 1.0;
+    settings.postRollSeconds = 0.0;
+    settings.cooldownSeconds = 60.0;
+    settings.directory = dir;
+    recorder.configure(settings);
+
+    // The ring keeps the newest MAX_FRAMES
+    int64_t now = FrameTracer::nowNs();
+    const uint64_t total = FlightRecorder::MAX_FRAMES + 100;
+    for (uint64_t i = 0; i < total; ++i) {
+        FlightRecorder::FrameSample sample;
+        sample.timeNs = now - static_cast<int64_t>(total - i) * 1000000LL;   // 1 ms apart
+        sample.frame = i;
+        sample.workMs = 4.0f;
+        sample.budgetMs = 16.7f;
+        recorder.recordFrame(sample);
+    }
+    std::vector<FlightRecorder::FrameSample> frames;
+    recorder.copyFrames(INT64_MIN, frames);
+    TEST_ASSERT_EQ(frames.size(), FlightRecorder::MAX_FRAMES);
+    TEST_ASSERT_EQ(frames.front().frame, 100u);
+    TEST_ASSERT_EQ(frames.back().frame, total - 1);
+    recorder.copyFrames(now - 500 * 1000000LL, frames);
+    TEST_ASSERT_EQ(frames.size(), 500u);
+
+    // One snapshot per cooldown
+    TEST_ASSERT_TRUE(recorder.trigger(FlightRecorder::Trigger::MISSED_VBLANK, "msc +3"));
+    TEST_ASSERT_FALSE(recorder.trigger(FlightRecorder::Trigger::DECODE_UNDERRUN));
+    TEST_ASSERT_EQ(recorder.getTriggerCount(), 1u);
+    recorder.stop();
+    TEST_ASSERT_EQ(recorder.getSnapshotCount(), 1u);
+
+    std::string path = recorder.getLastSnapshotPath();
+    TEST_ASSERT_TRUE(path.find("missed_vblank.json") != std::string::npos);
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string json = content.str();
+    TEST_ASSERT_TRUE(json.find("\"traceEvents\":[") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"trigger\":\"missed_vblank\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"detail\":\"msc +3\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"system\":{") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"frame\":" + std::to_string(total - 1)) != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"frame\":" + std::to_string(total - 1001) + ",") == std::string::npos);
+
+    // Disabled records and triggers nothing
+    settings.enabled = false;
+    settings.cooldownSeconds = 0.0;
+    recorder.configure(settings);
+    TEST_ASSERT_FALSE(recorder.trigger(FlightRecorder::Trigger::OVER_BUDGET));
+
+    std::remove(path.c_str());
+    rmdir(dir);
+    return true;
+}
@@ -0,0 +1,92 @@
+#include "TestFramework.h"
+#include "../display/drm/FormatModifiers.h"
+#include <cstring>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+constexpr uint32_t XRGB = 0x34325258;   // XR24
+constexpr uint32_t ARGB = 0x34325241;   // AR24
+constexpr uint32_t NV12 = 0x3231564e;   // NV12
+constexpr uint64_t LINEAR = 0;
+constexpr uint64_t X_TILED = (1ull << 56) | 1;
+constexpr uint64_t CCS = (1ull << 56) | 4;
+constexpr uint64_t INVALID = (1ull << 56) - 1;
+
+struct Modifier {
+    uint64_t formats;
+    uint32_t offset;
+    uint32_t pad;
+    uint64_t modifier;
+};
+
+// IN_FORMATS as the kernel lays it out: header, formats, modifiers
+std::vector<uint8_t> makeBlob(const std::vector<uint32_t>& formats, const std::vector<Modifier>& modifiers) {
+    uint32_t header[6] = {1, 0, static_cast<uint32_t>(formats.size()), 24,
+                          static_cast<uint32_t>(modifiers.size()), 0};
+    size_t formatsEnd = 24 + formats.size() * 4;
+    header[5] = static_cast<uint32_t>((formatsEnd + 7) & ~size_t(7));
+    std::vector<uint8_t> blob(header[5] + modifiers.size() * sizeof(Modifier), 0);
+    memcpy(blob.data(), header, sizeof(header));
+    memcpy(blob.data() + 24, formats.data(), formats.size() * 4);
+    memcpy(blob.data() + header[5], modifiers.data(), modifiers.size() * sizeof(Modifier));
+    return blob;
+}
+
+} // namespace
+
+bool test_FormatModifiers_ParseInFormats() {
+    // XRGB: linear, X-tiled, CCS; ARGB: linear, X-tiled; NV12: linear only
+    std::vector<uint8_t> blob = makeBlob({XRGB, ARGB, NV12}, {
+        {0x7, 0, 0, LINEAR},
+        {0x3, 0, 0, X_TILED},
+        {0x1, 0, 0, CCS},
+        {0x7, 0, 0, INVALID},
+    });
+
+    FormatModifierTable table;
+    TEST_ASSERT(table.empty());
+    TEST_ASSERT(table.supports(XRGB, CCS));   // Nothing known: anything goes
+    TEST_ASSERT(table.parse(blob.data(), blob.size()));
+    TEST_ASSERT(!table.empty());
+
+    std::vector<uint64_t> xrgb = table.getModifiers(XRGB);
+    TEST_ASSERT_EQ(static_cast<int>(xrgb.size()), 3);
+    TEST_ASSERT(xrgb[0] == LINEAR && xrgb[1] == X_TILED && xrgb[2] == CCS);
+    TEST_ASSERT_EQ(static_cast<int>(table.getModifiers(ARGB).size()), 2);
+    TEST_ASSERT(table.supports(NV12, LINEAR));
+    TEST_ASSERT(!table.supports(NV12, X_TILED));
+    TEST_ASSERT(!table.supports(XRGB, INVALID));
+    TEST_ASSERT(table.getModifiers(0x12345678).empty());
+
+    TEST_ASSERT(FormatModifierTable::hasTiled(xrgb));
+    TEST_ASSERT(!FormatModifierTable::hasTiled(table.getModifiers(NV12)));
+
+    // Canvas buffers scanned out by two planes: what both take
+    std::vector<uint64_t> common = FormatModifierTable::intersect(xrgb, table.getModifiers(ARGB));
+    TEST_ASSERT_EQ(static_cast<int>(common.size()), 2);
+    TEST_ASSERT(common[0] == LINEAR && common[1] == X_TILED);
+    return true;
+}
+
+bool test_FormatModifiers_RejectsMalformed() {
+    std::vector<uint8_t> blob = makeBlob({XRGB}, {{0x1, 0, 0, X_TILED}});
+    FormatModifierTable table;
+    TEST_ASSERT(!table.parse(blob.data(), 10));
+    TEST_ASSERT(!table.parse(blob.data(), blob.size() - 1));   // Modifier cut short
+    TEST_ASSERT(table.empty());
+
+    // Format bits past the format list are ignored
+    std::vector<uint8_t> wide = makeBlob({XRGB}, {{0xff, 0, 0, X_TILED}});
+    TEST_ASSERT(table.parse(wide.data(), wide.size()));
+    TEST_ASSERT_EQ(static_cast<int>(table.getModifiers(XRGB).size()), 1);
+
+    // Unknown version
+    blob[0] = 2;
+    TEST_ASSERT(!table.parse(blob.data(), blob.size()));
+    TEST_ASSERT(table.empty());
+    return true;
+}
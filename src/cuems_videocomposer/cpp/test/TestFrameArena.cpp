@@ -0,0 +1,91 @@
+#include "TestFramework.h"
+#include "../utils/FrameArena.h"
+#include <cstdint>
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_FrameArena_ResetAndCoalesce() {
+    FrameArena arena(1024);
+    TEST_ASSERT(arena.allocate(16) != nullptr);
+    TEST_ASSERT_EQ(arena.blockCount(), static_cast<size_t>(1));
+
+    // Requested alignment is honoured
+    void* aligned = arena.allocate(24, 64);
+    TEST_ASSERT(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+
+    // Allocations come back after reset
+    arena.reset();
+    void* first = arena.allocate(16);
+    arena.reset();
+    TEST_ASSERT(arena.allocate(16) == first);
+
+    // A frame that outgrows the block: more blocks, then one block of
+    // their size, so the same frame again takes nothing from the heap
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT(arena.allocate(500) != nullptr);
+    }
+    TEST_ASSERT(arena.blockCount() > 1);
+    arena.reset();
+    TEST_ASSERT_EQ(arena.blockCount(), static_cast<size_t>(1));
+    TEST_ASSERT(arena.highWater() >= static_cast<size_t>(5000));
+
+    uint64_t heapBefore = arena.heapAllocations();
+    for (int frame = 0; frame < 3; ++frame) {
+        for (int i = 0; i < 10; ++i) {
+            TEST_ASSERT(arena.allocate(500) != nullptr);
+        }
+        arena.reset();
+    }
+    TEST_ASSERT_EQ(arena.heapAllocations(), heapBefore);
+    TEST_ASSERT_EQ(arena.used(), static_cast<size_t>(0));
+
+    // Larger than any block
+    TEST_ASSERT(arena.allocate(1 << 20) != nullptr);
+    return true;
+}
+
+bool test_FrameArena_Containers() {
+    // No current arena: the heap
+    TEST_ASSERT(FrameArena::current() == nullptr);
+    ArenaVector<int> heapList;
+    TEST_ASSERT(heapList.get_allocator().arena() == nullptr);
+    heapList.assign(100, 1);
+
+    FrameArena arena;
+    {
+        FrameArena::Scope scope(&arena);
+        TEST_ASSERT(FrameArena::current() == &arena);
+
+        ArenaVector<int> list;
+        TEST_ASSERT(list.get_allocator().arena() == &arena);
+        for (int i = 0; i < 1000; ++i) {
+            list.push_back(i);
+        }
+        TEST_ASSERT_EQ(list[999], 999);
+        TEST_ASSERT(arena.used() >= 1000 * sizeof(int));
+
+        // Moves and copies stay in the arena
+        ArenaVector<int> moved(std::move(list));
+        ArenaVector<int> copied(moved);
+        TEST_ASSERT(copied.get_allocator().arena() == &arena);
+        TEST_ASSERT_EQ(copied[500], 500);
+
+        // Nested containers: inner vectors take the arena too
+        ArenaVector<ArenaVector<int>> nested;
+        nested.emplace_back();
+        nested.back().push_back(7);
+        TEST_ASSERT(nested.back().get_allocator().arena() == &arena);
+
+        // Other threads have no current arena
+        FrameArena* other = &arena;
+        std::thread worker([&other]() { other = FrameArena::current(); });
+        worker.join();
+        TEST_ASSERT(other == nullptr);
+    }
+    TEST_ASSERT(FrameArena::current() == nullptr);
+    arena.reset();
+    TEST_ASSERT_EQ(heapList.size(), static_cast<size_t>(100));
+    return true;
+}
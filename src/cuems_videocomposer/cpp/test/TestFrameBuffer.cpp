@@ -0,0 +1,151 @@
+#include "TestFramework.h"
+#include "../video/FrameBuffer.h"
+#include <memory>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_FrameBuffer_SharedWrap() {
+    // An SDK frame: released when the deleter runs
+    bool released = false;
+    std::vector<uint8_t> pixels(8 * 2 * 2, 0x80);
+    std::shared_ptr<void> owner(pixels.data(), [&released](void*) { released = true; });
+
+    FrameInfo info;
+    info.width = 8;
+    info.height = 2;
+    info.format = PixelFormat::UYVY422;
+
+    FrameBuffer captured;
+    TEST_ASSERT(captured.wrap(pixels.data(), pixels.size(), info, owner));
+    owner.reset();
+    TEST_ASSERT(captured.isShared());
+    TEST_ASSERT(!captured.ownsData());
+
+    // Copies reference the same memory instead of copying it
+    FrameBuffer layerFrame;
+    layerFrame = captured;
+    FrameBuffer another(captured);
+    TEST_ASSERT(layerFrame.data() == pixels.data());
+    TEST_ASSERT(another.data() == pixels.data());
+    TEST_ASSERT(layerFrame.info().format == PixelFormat::UYVY422);
+
+    // Moves and swaps carry the reference along
+    FrameBuffer moved(std::move(another));
+    TEST_ASSERT(moved.isShared());
+    TEST_ASSERT(!another.isShared());
+    FrameBuffer empty;
+    empty.swap(moved);
+    TEST_ASSERT(empty.isShared());
+    TEST_ASSERT(!moved.isShared());
+
+    // Released with the last reference only
+    captured.release();
+    empty.release();
+    TEST_ASSERT(!released);
+    layerFrame.release();
+    TEST_ASSERT(released);
+    TEST_ASSERT(!layerFrame.isValid());
+    return true;
+}
+
+bool test_FrameBuffer_CopyOnWrite() {
+    FrameInfo info;
+    info.width = 16;
+    info.height = 4;
+    info.format = PixelFormat::BGRA32;
+
+    FrameBuffer decoded;
+    TEST_ASSERT(decoded.allocate(info));
+    TEST_ASSERT(!decoded.isShared());
+    TEST_ASSERT(decoded.data()[0] == 0);
+    decoded.data()[0] = 7;
+
+    // Copies share the block: no pixels copied
+    FrameBuffer cached(decoded);
+    FrameBuffer shown;
+    shown = cached;
+    const FrameBuffer& cachedView = cached;
+    const FrameBuffer& decodedView = decoded;
+    TEST_ASSERT(cachedView.data() == decodedView.data());
+    TEST_ASSERT(decoded.isShared());
+    TEST_ASSERT(cached.ownsData());
+
+    // Writing gives the writer its own copy, the others keep the old pixels
+    uint8_t* written = decoded.data();
+    TEST_ASSERT(written != cachedView.data());
+    TEST_ASSERT(written[0] == 7);
+    written[0] = 9;
+    TEST_ASSERT(cachedView.data()[0] == 7);
+    TEST_ASSERT(!decoded.isShared());
+    TEST_ASSERT(cached.isShared());
+
+    // A shared block is not reused in place for the next frame
+    const uint8_t* before = cachedView.data();
+    TEST_ASSERT(cached.ensureAllocated(info));
+    TEST_ASSERT(cachedView.data() != before);
+    TEST_ASSERT(!shown.isShared());
+    TEST_ASSERT(shown.ensureAllocated(info));
+    TEST_ASSERT(static_cast<const FrameBuffer&>(shown).data() == before);
+
+    // Wrapped writable memory is copied, never referenced
+    std::vector<uint8_t> mapping(info.width * info.height * 4, 3);
+    FrameBuffer slot;
+    TEST_ASSERT(slot.wrap(mapping.data(), mapping.size(), info));
+    FrameBuffer copy(slot);
+    TEST_ASSERT(copy.ownsData());
+    TEST_ASSERT(copy.data() != mapping.data());
+    TEST_ASSERT(copy.data()[5] == 3);
+    TEST_ASSERT(slot.ensureAllocated(info));
+    TEST_ASSERT(slot.data() == mapping.data());
+    return true;
+}
+
+bool test_FrameBuffer_AlignedPlanes() {
+    FrameInfo info;
+    info.width = 100;
+    info.height = 10;
+    info.format = PixelFormat::YUV420P;
+
+    // Packed: planes back to back, rows unpadded
+    FrameBuffer packed;
+    TEST_ASSERT(packed.allocate(info));
+    TEST_ASSERT(reinterpret_cast<uintptr_t>(packed.data()) % 64 == 0);
+    TEST_ASSERT_EQ(packed.stride(0), 100);
+    TEST_ASSERT_EQ(packed.stride(1), 50);
+    TEST_ASSERT_EQ(packed.planeOffset(1), static_cast<size_t>(1000));
+    TEST_ASSERT_EQ(packed.planeOffset(2), static_cast<size_t>(1250));
+    TEST_ASSERT_EQ(packed.size(), static_cast<size_t>(1500));
+
+    // Aligned rows: every row of every plane starts on 64 bytes
+    FrameBuffer aligned;
+    TEST_ASSERT(aligned.allocate(info, 64));
+    TEST_ASSERT_EQ(aligned.stride(0), 128);
+    TEST_ASSERT_EQ(aligned.stride(1), 64);
+    const uint8_t* planes[4];
+    int strides[4];
+    TEST_ASSERT(aligned.getPlanes(planes, strides));
+    for (int plane = 0; plane < 3; ++plane) {
+        TEST_ASSERT(reinterpret_cast<uintptr_t>(planes[plane]) % 64 == 0);
+        TEST_ASSERT_EQ(strides[plane] % 64, 0);
+    }
+    TEST_ASSERT(planes[3] == nullptr);
+
+    // A different row alignment is a different allocation
+    const uint8_t* before = planes[0];
+    TEST_ASSERT(aligned.ensureAllocated(info, 64));
+    TEST_ASSERT(static_cast<const FrameBuffer&>(aligned).data() == before);
+    TEST_ASSERT(aligned.ensureAllocated(info));
+    TEST_ASSERT_EQ(aligned.stride(0), 100);
+
+    // Frame-sized blocks are page aligned
+    info.width = 1920;
+    info.height = 1080;
+    info.format = PixelFormat::BGRA32;
+    FrameBuffer frame;
+    TEST_ASSERT(frame.allocate(info));
+    TEST_ASSERT(reinterpret_cast<uintptr_t>(frame.data()) % 4096 == 0);
+    TEST_ASSERT_EQ(frame.stride(0), 1920 * 4);
+    return true;
+}
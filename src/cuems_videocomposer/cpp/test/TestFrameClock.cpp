@@ -0,0 +1,142 @@
+#include "TestFramework.h"
+#include "../sync/FrameClock.h"
+#include <cmath>
+#include <string>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Timecode moving on every poll, like an interpolating clock model
+class MovingSyncSource : public SyncSource {
+public:
+    int64_t frame = 100;
+    bool connected = true;
+    int polls = 0;
+    double lead = 0.0;
+
+    bool connect(const char*) override { connected = true; return true; }
+    void disconnect() override { connected = false; }
+    bool isConnected() const override { return connected; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        polls++;
+        if (rolling) {
+            *rolling = 1;
+        }
+        return frame++;
+    }
+    int64_t getCurrentFrame() const override { return frame - 1; }
+    const char* getName() const override { return "Moving"; }
+    double getFramerate() const override { return 25.0; }
+    void setPresentationLead(double seconds) override { lead = seconds; }
+};
+
+// Rolling timecode read like LTCSyncSource: floor((position(now) + lead) * fps)
+class ClockModelSyncSource : public SyncSource {
+public:
+    int64_t nowUs = 0;          // The position is the time, from 0
+    double lead = 0.0;
+
+    bool connect(const char*) override { return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        if (rolling) {
+            *rolling = 1;
+        }
+        return static_cast<int64_t>(std::floor((static_cast<double>(nowUs) / 1e6 + lead) * 25.0));
+    }
+    int64_t getCurrentFrame() const override { return -1; }
+    const char* getName() const override { return "ClockModel"; }
+    double getFramerate() const override { return 25.0; }
+    void setPresentationLead(double seconds) override { lead = seconds; }
+};
+
+} // namespace
+
+bool test_FrameClock_OneSamplePerRender() {
+    MovingSyncSource source;
+    FrameClock clock(&source);
+
+    // Before the first sample the source is read directly
+    TEST_ASSERT_EQ(clock.pollFrame(), static_cast<int64_t>(100));
+    TEST_ASSERT_EQ(clock.getSample().serial, 0u);
+
+    const FrameClock::Sample& sample = clock.sample();
+    TEST_ASSERT_TRUE(sample.connected);
+    TEST_ASSERT_TRUE(sample.rolling);
+    TEST_ASSERT_EQ(sample.frame, static_cast<int64_t>(101));
+    TEST_ASSERT_EQ(sample.framerate, 25.0);
+    TEST_ASSERT_EQ(source.polls, 2);
+
+    // Every layer of the render reads the same frame, without polling
+    for (int layer = 0; layer < 8; ++layer) {
+        uint8_t rolling = 0;
+        TEST_ASSERT_EQ(clock.pollFrame(&rolling), static_cast<int64_t>(101));
+        TEST_ASSERT_EQ(rolling, 1);
+    }
+    TEST_ASSERT_EQ(clock.getCurrentFrame(), static_cast<int64_t>(101));
+    TEST_ASSERT_EQ(source.polls, 2);
+
+    // The next render moves on
+    TEST_ASSERT_EQ(clock.sample().frame, static_cast<int64_t>(102));
+    TEST_ASSERT_EQ(clock.pollFrame(), static_cast<int64_t>(102));
+    TEST_ASSERT_EQ(clock.getSample().serial, 2u);
+
+    // Passed through
+    clock.setPresentationLead(0.04);
+    TEST_ASSERT_EQ(source.lead, 0.04);
+    TEST_ASSERT_EQ(std::string(clock.getName()), std::string("Moving"));
+    return true;
+}
+
+bool test_FrameClock_SourceChanges() {
+    MovingSyncSource source;
+    FrameClock clock(&source);
+
+    // A disconnected source gives no frame and is not polled
+    source.connected = false;
+    const FrameClock::Sample& sample = clock.sample();
+    TEST_ASSERT_FALSE(sample.connected);
+    TEST_ASSERT_EQ(sample.frame, static_cast<int64_t>(-1));
+    TEST_ASSERT_FALSE(clock.isConnected());
+    TEST_ASSERT_EQ(clock.pollFrame(), static_cast<int64_t>(-1));
+    TEST_ASSERT_EQ(source.polls, 0);
+
+    // Another source: the old sample is dropped
+    MovingSyncSource other;
+    other.frame = 7;
+    clock.setSource(&other);
+    TEST_ASSERT_EQ(clock.getSample().serial, 0u);
+    TEST_ASSERT_TRUE(clock.isConnected());
+    TEST_ASSERT_EQ(clock.sample().frame, static_cast<int64_t>(7));
+
+    clock.setSource(nullptr);
+    TEST_ASSERT_FALSE(clock.sample().connected);
+    TEST_ASSERT_EQ(clock.getFramerate(), -1.0);
+    return true;
+}
+
+bool test_FrameClock_SameFrameForOneVsync() {
+    ClockModelSyncSource source;
+    FrameClock clock(&source);
+
+    // The vsync this render is shown on: 1.039 s, frame 25
+    const int64_t vsyncUs = 1039000;
+
+    // Sampled before the layer update, and again at the late latch
+    source.nowUs = 1020000;
+    TEST_ASSERT_EQ(clock.sample(vsyncUs, source.nowUs).frame, static_cast<int64_t>(25));
+    source.nowUs = 1035000;
+    TEST_ASSERT_EQ(clock.sample(vsyncUs, source.nowUs).frame, static_cast<int64_t>(25));
+    TEST_ASSERT_EQ(source.lead, 0.004);
+
+    // The lead of the first sample, kept to the latch, lands past the vsync
+    source.setPresentationLead(0.019);
+    TEST_ASSERT_EQ(clock.sample().frame, static_cast<int64_t>(26));
+
+    // The next vsync moves on
+    TEST_ASSERT_EQ(clock.sample(vsyncUs + 40000, source.nowUs).frame, static_cast<int64_t>(26));
+    return true;
+}
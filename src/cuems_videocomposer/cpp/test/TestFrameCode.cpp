@@ -0,0 +1,66 @@
+#include "TestFramework.h"
+#include "../video/FrameCode.h"
+#include "../input/TestPatternInput.h"
+#include "../video/FrameBuffer.h"
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_FrameCode_RoundTrip() {
+    std::vector<uint8_t> row(1920 * 4);
+    const int64_t frames[] = {0, 1, 25, 90000, FrameCode::MODULO - 1};
+    for (int64_t frame : frames) {
+        FrameCode::encodeRow(row.data(), 1920, frame);
+        TEST_ASSERT_EQ(FrameCode::decodeRow(row.data(), 1920), frame);
+    }
+    // Wraps at MODULO
+    FrameCode::encodeRow(row.data(), 1920, FrameCode::MODULO + 7);
+    TEST_ASSERT_EQ(FrameCode::decodeRow(row.data(), 1920), static_cast<int64_t>(7));
+
+    // Scaled down by three (every third pixel), as a smaller output shows it
+    FrameCode::encodeRow(row.data(), 1920, 12345);
+    std::vector<uint8_t> scaled(640 * 4);
+    for (int x = 0; x < 640; ++x) {
+        for (int c = 0; c < 4; ++c) {
+            scaled[x * 4 + c] = row[x * 3 * 4 + c];
+        }
+    }
+    TEST_ASSERT_EQ(FrameCode::decodeRow(scaled.data(), 640), static_cast<int64_t>(12345));
+
+    // Two frames blended, a flat grey row and a damaged cell: rejected
+    std::vector<uint8_t> other(1920 * 4);
+    FrameCode::encodeRow(other.data(), 1920, 12346);
+    std::vector<uint8_t> blended(1920 * 4);
+    for (size_t i = 0; i < blended.size(); ++i) {
+        blended[i] = static_cast<uint8_t>((row[i] + other[i]) / 2);
+    }
+    TEST_ASSERT_EQ(FrameCode::decodeRow(blended.data(), 1920), static_cast<int64_t>(-1));
+    std::vector<uint8_t> grey(1920 * 4, 96);
+    TEST_ASSERT_EQ(FrameCode::decodeRow(grey.data(), 1920), static_cast<int64_t>(-1));
+    for (int x = 1920 * 5 / 32; x < 1920 * 6 / 32; ++x) {
+        row[x * 4 + 0] = row[x * 4 + 1] = row[x * 4 + 2] = static_cast<uint8_t>(255 - row[x * 4 + 1]);
+    }
+    TEST_ASSERT_EQ(FrameCode::decodeRow(row.data(), 1920), static_cast<int64_t>(-1));
+    return true;
+}
+
+bool test_TestPatternInput_Strips() {
+    TestPatternInput pattern(320, 180, 25.0);
+    TEST_ASSERT_EQ(pattern.getFrameInfo().totalFrames, static_cast<int64_t>(0));
+    TEST_ASSERT_FALSE(pattern.isStatic());
+
+    FrameBuffer buffer;
+    TEST_ASSERT_TRUE(pattern.readFrame(4321, buffer));
+    const size_t stride = 320 * 4;
+    TEST_ASSERT_EQ(FrameCode::decodeRow(buffer.data(), 320), static_cast<int64_t>(4321));
+    TEST_ASSERT_EQ(FrameCode::decodeRow(buffer.data() + 179 * stride, 320), static_cast<int64_t>(4321));
+    TEST_ASSERT_EQ(FrameCode::decodeRow(buffer.data() + 90 * stride, 320), static_cast<int64_t>(-1));
+
+    // Photodiode patch: white on even frames, black on odd
+    const size_t patch = (180 - pattern.stripHeight() - 2) * stride + 4;
+    TEST_ASSERT_EQ(static_cast<int>(buffer.data()[patch + 1]), 0);
+    TEST_ASSERT_TRUE(pattern.readFrame(4322, buffer));
+    TEST_ASSERT_EQ(static_cast<int>(buffer.data()[patch + 1]), 255);
+    return true;
+}
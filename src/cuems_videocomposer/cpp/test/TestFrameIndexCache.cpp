@@ -0,0 +1,150 @@
+#include "TestFramework.h"
+#include "../input/FrameIndexCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+std::string makeTempDir() {
+    char tmpl[] = "/tmp/cvc_idxcache_XXXXXX";
+    const char* dir = mkdtemp(tmpl);
+    return dir ? std::string(dir) : std::string();
+}
+
+bool writeFile(const std::string& path, const std::string& content) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fwrite(content.data(), 1, content.size(), f);
+    fclose(f);
+    return true;
+}
+
+} // namespace
+
+bool test_FrameIndexCache_RoundTrip() {
+    std::string dir = makeTempDir();
+    TEST_ASSERT_FALSE(dir.empty());
+    std::string media = dir + "/clip.mov";
+    TEST_ASSERT_TRUE(writeFile(media, "not really a movie, but stable content"));
+
+    std::vector<FrameIndexCache::Entry> entries(3);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i] = {};
+        entries[i].pkt_pts = static_cast<int64_t>(i) * 512;
+        entries[i].timestamp = static_cast<int64_t>(i) * 512;
+        entries[i].seekpts = 0;
+        entries[i].key = (i == 0) ? 1 : 0;
+    }
+    FrameIndexCache::Metadata meta;
+    meta.frameCount = 3;
+    meta.totalFrames = 3;
+
+    FrameIndexCache cache(dir + "/cache");
+    FrameIndexCache::Entry* loaded = nullptr;
+    FrameIndexCache::Metadata loadedMeta;
+
+    // Miss before anything is stored
+    TEST_ASSERT_FALSE(cache.load(media, loaded, loadedMeta));
+    TEST_ASSERT(loaded == nullptr);
+
+    TEST_ASSERT_TRUE(cache.store(media, entries.data(), meta));
+    TEST_ASSERT_TRUE(cache.load(media, loaded, loadedMeta));
+    TEST_ASSERT(loaded != nullptr);
+    TEST_ASSERT_EQ(loadedMeta.frameCount, static_cast<int64_t>(3));
+    TEST_ASSERT_EQ(loaded[2].pkt_pts, static_cast<int64_t>(1024));
+    TEST_ASSERT_EQ(static_cast<int>(loaded[0].key), 1);
+    free(loaded);
+
+    unlink(cache.cachePathFor(media).c_str());
+    unlink(media.c_str());
+    rmdir((dir + "/cache").c_str());
+    rmdir(dir.c_str());
+    return true;
+}
+
+bool test_FrameIndexCache_Invalidation() {
+    std::string dir = makeTempDir();
+    TEST_ASSERT_FALSE(dir.empty());
+    std::string media = dir + "/clip.mp4";
+    TEST_ASSERT_TRUE(writeFile(media, "original content"));
+
+    std::vector<FrameIndexCache::Entry> entries(1);
+    entries[0] = {};
+    FrameIndexCache::Metadata meta;
+    meta.frameCount = 1;
+
+    FrameIndexCache cache(dir);
+    TEST_ASSERT_TRUE(cache.store(media, entries.data(), meta));
+
+    // Rewriting the media file (different size and content) makes the entry stale
+    TEST_ASSERT_TRUE(writeFile(media, "replaced with a longer file body"));
+    FrameIndexCache::Entry* loaded = nullptr;
+    FrameIndexCache::Metadata loadedMeta;
+    TEST_ASSERT_FALSE(cache.load(media, loaded, loadedMeta));
+
+    // Explicit invalidation removes the cache file
+    TEST_ASSERT_TRUE(cache.store(media, entries.data(), meta));
+    TEST_ASSERT_TRUE(cache.load(media, loaded, loadedMeta));
+    free(loaded);
+    loaded = nullptr;
+    cache.invalidate(media);
+    TEST_ASSERT_FALSE(cache.load(media, loaded, loadedMeta));
+
+    unlink(media.c_str());
+    rmdir(dir.c_str());
+    return true;
+}
+
+bool test_FrameIndexCache_Probe() {
+    std::string dir = makeTempDir();
+    TEST_ASSERT_FALSE(dir.empty());
+    std::string media = dir + "/clip.mov";
+    TEST_ASSERT_TRUE(writeFile(media, "probe me"));
+
+    FrameIndexCache::Probe probe;
+    probe.formatName = "mov,mp4,m4a,3gp,3g2,mj2";
+    probe.streamIndex = 1;
+    probe.codecId = 27;
+    probe.pixelFormat = 0;
+    probe.width = 1920;
+    probe.height = 1080;
+    probe.frameRate[0] = 25;
+    probe.avgFrameRate[0] = 25;
+    probe.timeBase[1] = 12800;
+    probe.duration = 1280000;
+    probe.extradata = {0x01, 0x64, 0x00, 0x28};
+
+    FrameIndexCache cache(dir);
+    FrameIndexCache::Probe loaded;
+    TEST_ASSERT_FALSE(cache.loadProbe(media, loaded));
+    TEST_ASSERT_TRUE(cache.storeProbe(media, probe));
+    TEST_ASSERT_TRUE(cache.probePathFor(media) != cache.cachePathFor(media));
+    TEST_ASSERT_TRUE(cache.loadProbe(media, loaded));
+    TEST_ASSERT_TRUE(loaded.formatName == probe.formatName);
+    TEST_ASSERT_EQ(loaded.streamIndex, static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(loaded.width, static_cast<int64_t>(1920));
+    TEST_ASSERT_EQ(loaded.timeBase[1], static_cast<int64_t>(12800));
+    TEST_ASSERT_EQ(loaded.startTime, INT64_MIN);
+    TEST_ASSERT_EQ(loaded.duration, static_cast<int64_t>(1280000));
+    TEST_ASSERT_TRUE(loaded.extradata == probe.extradata);
+
+    // Nothing to name the demuxer by: not stored
+    FrameIndexCache::Probe unnamed;
+    TEST_ASSERT_FALSE(cache.storeProbe(media, unnamed));
+
+    // A changed file makes the probe stale, invalidation removes it
+    TEST_ASSERT_TRUE(writeFile(media, "probe me again"));
+    TEST_ASSERT_FALSE(cache.loadProbe(media, loaded));
+    TEST_ASSERT_TRUE(cache.storeProbe(media, probe));
+    cache.invalidate(media);
+    TEST_ASSERT_FALSE(cache.loadProbe(media, loaded));
+
+    unlink(media.c_str());
+    rmdir(dir.c_str());
+    return true;
+}
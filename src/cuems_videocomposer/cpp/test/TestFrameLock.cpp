@@ -0,0 +1,121 @@
+#include "TestFramework.h"
+#include "../sync/FrameLockSyncSource.h"
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Timecode source whose frame is set by the test
+class ScriptedSyncSource : public SyncSource {
+public:
+    int64_t frame = -1;
+    bool running = false;
+
+    bool connect(const char*) override { return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        if (rolling) {
+            *rolling = running ? 1 : 0;
+        }
+        return frame;
+    }
+    int64_t getCurrentFrame() const override { return frame; }
+    const char* getName() const override { return "Scripted"; }
+    double getFramerate() const override { return 25.0; }
+};
+
+struct Message {
+    double position;
+    int64_t realtimeUs;
+};
+
+int64_t frameAt(int64_t timeUs) {
+    return static_cast<int64_t>(std::floor(timeUs / 1e6 * 25.0));
+}
+
+} // namespace
+
+bool test_FrameLock_FollowerMatchesTimeline() {
+    auto masterInput = std::make_unique<ScriptedSyncSource>();
+    auto followerInput = std::make_unique<ScriptedSyncSource>();
+    ScriptedSyncSource* masterMtc = masterInput.get();
+    ScriptedSyncSource* followerMtc = followerInput.get();
+    FrameLockSyncSource master(std::move(masterInput), FrameLockSyncSource::Role::Master);
+    FrameLockSyncSource follower(std::move(followerInput), FrameLockSyncSource::Role::Follower);
+
+    std::vector<Message> sent;
+    master.setTransport([&sent](const std::string& target, const std::string& path,
+                                const std::string&, const std::vector<double>& values) {
+        if (target == "follower:7000" && path == "/videocomposer/framelock/timeline" && values.size() == 2) {
+            sent.push_back({values[0], static_cast<int64_t>(values[1])});
+        }
+    }, {"follower:7000"}, "", "master");
+
+    // Before any timeline the follower uses its own timecode
+    followerMtc->frame = 77;
+    followerMtc->running = true;
+    follower.update(0);
+    TEST_ASSERT_EQ(follower.pollFrame(), static_cast<int64_t>(77));
+
+    // Master at 60 Hz; follower at 59.94 Hz with another phase. Its own MTC
+    // runs a frame late, which the timeline overrides
+    const int64_t start = 1000000000000LL;
+    const int64_t masterPeriod = 16667;
+    const int64_t followerPeriod = 16683;
+    int64_t masterVblank = start;
+    int64_t followerVblank = start + 7000;
+    int compared = 0;
+    int offByOne = 0;
+    for (int i = 0; i < 600; ++i) {
+        if (i == 120) {
+            follower.takeSkewStats();   // Lock-in done
+        }
+        masterMtc->running = true;
+        masterMtc->frame = frameAt(masterVblank);
+        master.update(masterVblank);
+        masterVblank += masterPeriod;
+
+        while (followerVblank < masterVblank) {
+            for (const Message& m : sent) {
+                follower.receiveTimeline(m.position, m.realtimeUs);
+            }
+            sent.clear();
+            followerMtc->frame = frameAt(followerVblank) - 1;
+            follower.update(followerVblank);
+
+            uint8_t rolling = 0;
+            int64_t shown = follower.pollFrame(&rolling);
+            if (i > 120) {
+                TEST_ASSERT_EQ(rolling, static_cast<uint8_t>(1));
+                int64_t expected = frameAt(followerVblank);
+                TEST_ASSERT(std::llabs(shown - expected) <= 1);
+                ++compared;
+                if (shown != expected) {
+                    ++offByOne;
+                }
+            }
+            followerVblank += followerPeriod;
+        }
+    }
+    // Only vblanks within the timeline error of a frame boundary may differ
+    TEST_ASSERT(compared > 400);
+    TEST_ASSERT(offByOne * 10 < compared);
+
+    // 8 s at 25 fps
+    FrameLockSyncSource::SkewStats stats = follower.takeSkewStats();
+    TEST_ASSERT(stats.frames >= 195);
+    TEST_ASSERT(stats.maxLateUs <= followerPeriod + 2000);
+    TEST_ASSERT(stats.mismatches > stats.frames / 2);
+
+    // Master stops sending: the follower falls back to its own timecode
+    followerMtc->frame = 5;
+    follower.update(followerVblank + FrameLockSyncSource::TIMELINE_TIMEOUT_US);
+    TEST_ASSERT_EQ(follower.pollFrame(), static_cast<int64_t>(5));
+    return true;
+}
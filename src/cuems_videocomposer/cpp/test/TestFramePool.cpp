@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "../video/FramePool.h"
+#include "../utils/AllocationCounter.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_FramePool_AcquireRelease() {
+    auto pool = FramePool::create(2);
+    TEST_ASSERT_EQ(pool->capacity(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(2));
+
+    FramePool::Handle a = pool->acquire();
+    FramePool::Handle b = pool->acquire();
+    TEST_ASSERT(a.get() != nullptr);
+    TEST_ASSERT(b.get() != nullptr);
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(0));
+
+    // Exhausted pool returns nullptr instead of allocating
+    FramePool::Handle c = pool->acquire();
+    TEST_ASSERT(c.get() == nullptr);
+    TEST_ASSERT_EQ(pool->getStats().exhausted, static_cast<uint64_t>(1));
+
+    // Shared references keep the slot out of the pool
+    a->frameNumber = 42;
+    FramePool::Handle aCopy = a;
+    a.reset();
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(0));
+    aCopy.reset();
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(1));
+
+    // Recycled slot is reset
+    FramePool::Handle d = pool->acquire();
+    TEST_ASSERT(d.get() != nullptr);
+    TEST_ASSERT_EQ(d->frameNumber, static_cast<int64_t>(-1));
+
+    FramePool::Stats st = pool->getStats();
+    TEST_ASSERT_EQ(st.inUse, static_cast<size_t>(2));
+    TEST_ASSERT_EQ(st.peakInUse, static_cast<size_t>(2));
+
+    return true;
+}
+
+bool test_FramePool_Budget() {
+    const size_t frame1080 = 1920 * 1080 * 4;
+
+    // 128 MB of 1080p BGRA frames
+    TEST_ASSERT_EQ(FramePool::capacityForBudget(128 * 1024 * 1024, frame1080), static_cast<size_t>(16));
+    // Tiny and unset budgets fall back to the minimum
+    TEST_ASSERT_EQ(FramePool::capacityForBudget(1024, frame1080), FramePool::MIN_FRAMES);
+    TEST_ASSERT_EQ(FramePool::capacityForBudget(0, frame1080), FramePool::MIN_FRAMES);
+    // Huge budgets are capped
+    TEST_ASSERT_EQ(FramePool::capacityForBudget(static_cast<size_t>(64) * 1024 * 1024 * 1024, frame1080),
+                   FramePool::MAX_FRAMES);
+
+    // Handles outliving the caller's pool reference still release cleanly
+    FramePool::Handle orphan;
+    {
+        auto pool = FramePool::create(1);
+        orphan = pool->acquire();
+        pool->recordHit();
+        pool->recordMiss();
+        TEST_ASSERT_EQ(pool->getStats().hits, static_cast<uint64_t>(1));
+        TEST_ASSERT_EQ(pool->getStats().misses, static_cast<uint64_t>(1));
+    }
+    TEST_ASSERT(orphan.get() != nullptr);
+    orphan.reset();
+
+    return true;
+}
+
+bool test_FramePool_NoAllocationPerFrame() {
+    TEST_ASSERT_TRUE(AllocationCounter::isEnabled());
+    auto pool = FramePool::create(4);
+
+    // Decode-and-show cycles: handles copied, aliased and dropped
+    uint64_t before = AllocationCounter::threadCount();
+    for (int64_t frame = 0; frame < 1000; ++frame) {
+        FramePool::Handle decoded = pool->acquire();
+        FramePool::Handle ahead = pool->acquire();
+        TEST_ASSERT(decoded.get() != nullptr);
+        TEST_ASSERT(ahead.get() != nullptr);
+        decoded->frameNumber = frame;
+        FramePool::Handle shown = decoded;
+        std::shared_ptr<void> owner(shown, &shown->buffer);
+        decoded.reset();
+        shown.reset();
+        TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(2));
+    }
+    TEST_ASSERT_EQ(AllocationCounter::threadCount(), before);
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(4));
+    TEST_ASSERT_EQ(pool->getStats().peakInUse, static_cast<size_t>(2));
+    return true;
+}
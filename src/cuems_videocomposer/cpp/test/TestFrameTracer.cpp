@@ -0,0 +1,81 @@
+#include "TestFramework.h"
+#include "../utils/FrameTracer.h"
+#include <string>
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+bool test_FrameTracer_ChromeJson() {
+    FrameTracer tracer(16);
+    tracer.setThreadName("render");
+    tracer.record("composite", 1000000, 1002500, 3);
+    tracer.instant("flip.complete", 1005000);
+
+    std::string json = tracer.exportChromeJson();
+    TEST_ASSERT_TRUE(json.find("\"traceEvents\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"args\":{\"name\":\"render\"}") != std::string::npos);
+    // Microseconds with nanosecond decimals
+    TEST_ASSERT_TRUE(json.find("\"name\":\"composite\",\"ph\":\"X\",\"pid\":1,\"tid\":") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ts\":1000.000,\"dur\":2.500,\"args\":{\"arg\":3}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"name\":\"flip.complete\",\"ph\":\"i\"") != std::string::npos);
+
+    // Disabled: nothing recorded
+    tracer.clear();
+    tracer.setEnabled(false);
+    tracer.record("composite", 0, 10);
+    tracer.setEnabled(true);
+    TEST_ASSERT_EQ(countOf(tracer.exportChromeJson(), "\"composite\""), static_cast<size_t>(0));
+    return true;
+}
+
+bool test_FrameTracer_RingsPerThread() {
+    FrameTracer tracer(16);
+
+    // A full ring keeps the newest events (but the slot written next)
+    for (int i = 0; i < 40; ++i) {
+        tracer.record("main", i * 10, i * 10 + 5, i);
+    }
+    std::string json = tracer.exportChromeJson();
+    TEST_ASSERT_EQ(countOf(json, "\"main\""), static_cast<size_t>(15));
+    TEST_ASSERT_TRUE(json.find("\"arg\":39}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"arg\":25}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"arg\":24}") == std::string::npos);
+
+    // Each thread gets its own ring; a finished thread's ring is reused
+    std::thread([&tracer]() { tracer.record("worker", 1, 2); }).join();
+    TEST_ASSERT_EQ(tracer.getThreadCount(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(countOf(tracer.exportChromeJson(), "\"worker\""), static_cast<size_t>(1));
+    std::thread([&tracer]() { tracer.record("worker2", 1, 2); }).join();
+    TEST_ASSERT_EQ(tracer.getThreadCount(), static_cast<size_t>(2));
+    json = tracer.exportChromeJson();
+    TEST_ASSERT_EQ(countOf(json, "\"worker\""), static_cast<size_t>(0));
+    TEST_ASSERT_EQ(countOf(json, "\"worker2\""), static_cast<size_t>(1));
+
+    // Export while another thread records
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (int i = 0; i < 20000; ++i) {
+            tracer.record("busy", i, i + 1, i);
+        }
+        done = true;
+    });
+    while (!done) {
+        std::string snapshot = tracer.exportChromeJson();
+        TEST_ASSERT_TRUE(countOf(snapshot, "\"busy\"") <= 16);
+    }
+    writer.join();
+    return true;
+}
@@ -0,0 +1,110 @@
+#include "TestFramework.h"
+#include "../sync/FramerateConverterSyncSource.h"
+#include "../input/InputSource.h"
+#include "../utils/SMPTEUtils.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+class RateSyncSource : public SyncSource {
+public:
+    int64_t frame = 0;
+    bool rolling = true;
+    double fps = 30000.0 / 1001.0;
+
+    bool connect(const char*) override { return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* isRolling = nullptr) override {
+        if (isRolling) {
+            *isRolling = rolling ? 1 : 0;
+        }
+        return frame;
+    }
+    int64_t getCurrentFrame() const override { return frame; }
+    const char* getName() const override { return "Rate"; }
+    double getFramerate() const override { return fps; }
+};
+
+class RateInputSource : public InputSource {
+public:
+    FrameInfo info;
+
+    bool open(const std::string&) override { return true; }
+    void close() override {}
+    bool seek(int64_t) override { return true; }
+    bool readFrame(int64_t, FrameBuffer&) override { return true; }
+    FrameInfo getFrameInfo() const override { return info; }
+    bool isReady() const override { return true; }
+    int64_t getCurrentFrame() const override { return 0; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+};
+
+} // namespace
+
+bool test_FramerateConverter_DropFrameToFilm() {
+    // 29.97 drop-frame labels count real frames
+    TEST_ASSERT_EQ(SMPTEUtils::dropFrameToFrame(29, 59, 0, 0), static_cast<int64_t>(1799));
+    TEST_ASSERT_EQ(SMPTEUtils::dropFrameToFrame(2, 0, 1, 0), static_cast<int64_t>(1800));
+    TEST_ASSERT_EQ(SMPTEUtils::dropFrameToFrame(0, 0, 10, 0), static_cast<int64_t>(17982));
+    TEST_ASSERT_EQ(SMPTEUtils::dropFrameToFrame(0, 0, 0, 1), static_cast<int64_t>(107892));
+
+    RateSyncSource sync;
+    RateInputSource input;
+    input.info.framerate = 24000.0 / 1001.0;
+    input.info.framerateNum = 24000;
+    input.info.framerateDen = 1001;
+    FramerateConverterSyncSource converter(&sync, &input);
+
+    // 30000/1001 -> 24000/1001 is exactly 4/5, for a whole day of timecode
+    int64_t previous = -1;
+    for (int64_t f = 0; f < 24 * 107892; f += 7) {
+        sync.frame = f;
+        int64_t video = converter.pollFrame();
+        TEST_ASSERT_EQ(video, f * 4 / 5);
+        TEST_ASSERT(video >= previous);
+        previous = video;
+    }
+
+    // Every film frame is shown once across consecutive sync frames
+    previous = converter.pollFrame();
+    int64_t start = sync.frame;
+    for (int64_t f = start + 1; f < start + 1000; ++f) {
+        sync.frame = f;
+        int64_t video = converter.pollFrame();
+        TEST_ASSERT(video == previous || video == previous + 1);
+        previous = video;
+    }
+    return true;
+}
+
+bool test_FramerateConverter_Hysteresis() {
+    RateSyncSource sync;
+    sync.fps = 25.0;
+    RateInputSource input;
+    input.info.framerate = 24000.0 / 1001.0;   // No exact rate: derived from the double
+    FramerateConverterSyncSource converter(&sync, &input);
+
+    // 25 -> 24000/1001: frame 26 is video 24, frame 25 is video 23
+    sync.frame = 26;
+    TEST_ASSERT_EQ(converter.pollFrame(), static_cast<int64_t>(24));
+
+    // One step back while rolling holds the frame on screen
+    sync.frame = 25;
+    TEST_ASSERT_EQ(converter.pollFrame(), static_cast<int64_t>(24));
+
+    // Stopped (locate by one frame) follows exactly
+    sync.rolling = false;
+    TEST_ASSERT_EQ(converter.pollFrame(), static_cast<int64_t>(23));
+
+    // Same rates: no conversion
+    input.info.framerate = 25.0;
+    sync.frame = 1234;
+    TEST_ASSERT_EQ(converter.pollFrame(), static_cast<int64_t>(1234));
+    return true;
+}
@@ -26,16 +26,28 @@ public:
     }
 
     void addTest(const std::string& name, bool (*testFunc)()) {
-        tests_.push_back({name, testFunc});
+        tests_.push_back({name, testFunc, false});
     }
 
-    int runAll() {
-        std::cout << "Running " << tests_.size() << " test(s)...\n\n";
+    // Performance tests (see PerfBaseline) run only with runAll(true)
+    void addPerfTest(const std::string& name, bool (*testFunc)()) {
+        tests_.push_back({name, testFunc, true});
+    }
+
+    int runAll(bool perf = false) {
+        size_t count = 0;
+        for (const auto& test : tests_) {
+            count += test.perf == perf ? 1 : 0;
+        }
+        std::cout << "Running " << count << (perf ? " performance" : "") << " test(s)...\n\n";
         
         int passed = 0;
         int failed = 0;
 
         for (const auto& test : tests_) {
+            if (test.perf != perf) {
+                continue;
+            }
             std::cout << "Test: " << test.name << " ... ";
             try {
                 if (test.func()) {
@@ -64,6 +76,7 @@ private:
     struct Test {
         std::string name;
         bool (*func)();
+        bool perf;
     };
     
     std::vector<Test> tests_;
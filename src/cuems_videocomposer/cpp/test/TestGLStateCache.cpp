@@ -0,0 +1,114 @@
+#include "TestFramework.h"
+#include "../display/GLStateCache.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// GL stand-in: records the calls that reach it
+struct FakeGL {
+    std::vector<std::string> calls;
+
+    GLStateCache::Backend backend() {
+        GLStateCache::Backend backend;
+        backend.useProgram = [this](GLuint program) { calls.push_back("program " + std::to_string(program)); };
+        backend.bindVertexArray = [this](GLuint vao) { calls.push_back("vao " + std::to_string(vao)); };
+        backend.setBlend = [this](bool enabled) { calls.push_back(enabled ? "blend on" : "blend off"); };
+        backend.blendFunc = [this](GLenum src, GLenum dst) {
+            calls.push_back("func " + std::to_string(src) + " " + std::to_string(dst));
+        };
+        backend.activeTexture = [this](GLuint unit) { calls.push_back("unit " + std::to_string(unit)); };
+        backend.bindTexture2D = [this](GLuint texture) { calls.push_back("texture " + std::to_string(texture)); };
+        return backend;
+    }
+};
+
+} // namespace
+
+bool test_GLStateCache_SkipsRedundant() {
+    FakeGL gl;
+    GLStateCache cache(gl.backend());
+
+    // First call of each kind always reaches the GL
+    cache.useProgram(3);
+    cache.bindVertexArray(1);
+    cache.setBlend(true);
+    cache.blendFunc(0x302, 0x303);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 4);
+
+    // Ten layers drawn the same way: nothing more
+    for (int i = 0; i < 10; ++i) {
+        cache.blendFunc(0x302, 0x303);
+        cache.useProgram(3);
+        cache.bindVertexArray(1);
+    }
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 4);
+    TEST_ASSERT_EQ(cache.getSkipped(), 30u);
+
+    // Changes pass, in order
+    cache.useProgram(5);
+    cache.blendFunc(0x306, 0);
+    cache.setBlend(false);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 7);
+    TEST_ASSERT(gl.calls[4] == "program 5");
+    TEST_ASSERT(gl.calls[5] == "func 774 0");
+    TEST_ASSERT(gl.calls[6] == "blend off");
+    TEST_ASSERT_EQ(cache.getIssued(), 7u);
+    return true;
+}
+
+bool test_GLStateCache_Invalidate() {
+    FakeGL gl;
+    GLStateCache cache(gl.backend());
+    cache.useProgram(0);
+    cache.bindVertexArray(0);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 2);
+
+    // Someone else drew: the same values are set again
+    cache.invalidate();
+    cache.useProgram(0);
+    cache.bindVertexArray(0);
+    cache.setBlend(false);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 5);
+    cache.useProgram(0);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 5);
+    return true;
+}
+
+bool test_GLStateCache_Textures() {
+    FakeGL gl;
+    GLStateCache cache(gl.backend());
+
+    // NV12 layer: two units, unit 1 left active
+    cache.bindTexture(0, 10);
+    cache.bindTexture(1, 11);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 4);
+    TEST_ASSERT(gl.calls[2] == "unit 1");
+    TEST_ASSERT(gl.calls[3] == "texture 11");
+
+    // Same planes again: only the unit switches back
+    cache.bindTexture(0, 10);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 5);
+    TEST_ASSERT(gl.calls[4] == "unit 0");
+    cache.bindTexture(0, 10);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 5);
+
+    // An upload bound something else on an unknown unit
+    cache.invalidateTextures();
+    cache.bindTexture(0, 10);
+    cache.bindTexture(1, 11);
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 9);
+
+    // End of pass: unit 1 cleared, unit 0 cleared last and left active
+    cache.unbindTextures();
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 12);
+    TEST_ASSERT(gl.calls[9] == "texture 0");
+    TEST_ASSERT(gl.calls[10] == "unit 0");
+    TEST_ASSERT(gl.calls[11] == "texture 0");
+    cache.unbindTextures();
+    TEST_ASSERT_EQ(static_cast<int>(gl.calls.size()), 12);
+    return true;
+}
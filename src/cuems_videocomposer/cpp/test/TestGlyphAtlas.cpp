@@ -0,0 +1,64 @@
+#include "TestFramework.h"
+#include "../osd/GlyphAtlas.h"
+#include <cmath>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_GlyphAtlas_PackAndLayout() {
+    GlyphAtlas atlas(25, 17);
+    atlas.reset(12);
+    TEST_ASSERT_EQ(atlas.getFontSize(), 12);
+
+    // 10x8 glyph, baseline 6 px below its top (2 px descender)
+    std::vector<uint8_t> bitmap(10 * 8, 200);
+    GlyphAtlas::Glyph metrics;
+    metrics.width = 10;
+    metrics.height = 8;
+    metrics.bearingX = 1;
+    metrics.bearingY = 6;
+    metrics.advance = 12;
+    TEST_ASSERT_TRUE(atlas.add('A', metrics, bitmap.data(), 10));
+    TEST_ASSERT_TRUE(atlas.add('B', metrics, bitmap.data(), 10));
+    atlas.markClean();
+
+    // Third glyph doesn't fit the first shelf and starts a second one
+    TEST_ASSERT_TRUE(atlas.add('C', metrics, bitmap.data(), 10));
+    TEST_ASSERT_TRUE(atlas.isDirty());
+    TEST_ASSERT_EQ(atlas.find('B')->x, 11);
+    TEST_ASSERT_EQ(atlas.find('C')->x, 0);
+    TEST_ASSERT_EQ(atlas.find('C')->y, 9);
+    TEST_ASSERT_EQ(static_cast<int>(atlas.pixels()[9 * 25]), 200);
+    TEST_ASSERT_EQ(static_cast<int>(atlas.pixels()[10]), 0);  // Gutter
+
+    // Full atlas rejects the glyph; blanks need no space
+    TEST_ASSERT_TRUE(atlas.add('D', metrics, bitmap.data(), 10));
+    TEST_ASSERT_FALSE(atlas.add('E', metrics, bitmap.data(), 10));
+    GlyphAtlas::Glyph blank;
+    blank.advance = 5;
+    TEST_ASSERT_TRUE(atlas.add(' ', blank, nullptr, 0));
+    TEST_ASSERT_EQ(atlas.getGlyphCount(), static_cast<size_t>(5));
+    TEST_ASSERT_TRUE(atlas.containsAll("A B"));
+    TEST_ASSERT_FALSE(atlas.containsAll("AE"));
+
+    // Layout from cached metrics: one quad per visible glyph
+    ArenaVector<GlyphQuad> quads;
+    int ascent = 0, descent = 0;
+    int width = atlas.layout("A C", quads, ascent, descent);
+    TEST_ASSERT_EQ(width, 12 + 5 + 12);
+    TEST_ASSERT_EQ(ascent, 6);
+    TEST_ASSERT_EQ(descent, 2);
+    TEST_ASSERT_EQ(quads.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(quads[0].x, 1);
+    TEST_ASSERT_EQ(quads[0].y, 0);
+    TEST_ASSERT_EQ(quads[1].x, 12 + 5 + 1);
+    TEST_ASSERT_TRUE(std::fabs(quads[1].v0 - 9.0f / 17.0f) < 1e-6f);
+    TEST_ASSERT_TRUE(std::fabs(quads[1].u1 - 10.0f / 25.0f) < 1e-6f);
+
+    // Reset drops everything
+    atlas.reset(20);
+    TEST_ASSERT_TRUE(atlas.find('A') == nullptr);
+    TEST_ASSERT_EQ(atlas.getGlyphCount(), static_cast<size_t>(0));
+    return true;
+}
@@ -0,0 +1,53 @@
+#include "TestFramework.h"
+#include "../display/GpuTimingStats.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_GpuTimingStats_RollingWindow() {
+    GpuTimingStats stats;
+
+    // Layer 3 at 1 ms with one 4 ms spike, the master pass once
+    for (int frame = 0; frame < 10; ++frame) {
+        stats.beginFrame();
+        stats.add("layer", 3, frame == 4 ? 4.0 : 1.0);
+        if (frame == 0) {
+            stats.add("master", -1, 0.5);
+        }
+    }
+
+    GpuTimingStats::Summary layer;
+    TEST_ASSERT_TRUE(stats.getSummary("layer", 3, layer));
+    TEST_ASSERT_EQ(layer.samples, static_cast<size_t>(10));
+    TEST_ASSERT_TRUE(std::fabs(layer.averageMs - 1.3) < 1e-5);
+    TEST_ASSERT_TRUE(std::fabs(layer.maxMs - 4.0) < 1e-5);
+    TEST_ASSERT_TRUE(std::fabs(layer.lastMs - 1.0) < 1e-5);
+    TEST_ASSERT_FALSE(stats.getSummary("layer", 4, layer));
+
+    // Order of first appearance
+    std::vector<GpuTimingStats::Summary> all = stats.getSummaries();
+    TEST_ASSERT_EQ(all.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(all[0].name, std::string("layer"));
+    TEST_ASSERT_EQ(all[1].name, std::string("master"));
+    TEST_ASSERT_EQ(GpuTimingStats::formatLine(all[0]), std::string("layer 3: 1.30 ms avg, 4.00 max"));
+    TEST_ASSERT_EQ(GpuTimingStats::formatLine(all[1]), std::string("master: 0.50 ms avg, 0.50 max"));
+
+    // The spike leaves the window after WINDOW more frames
+    for (size_t frame = 0; frame < GpuTimingStats::WINDOW; ++frame) {
+        stats.beginFrame();
+        stats.add("layer", 3, 2.0);
+    }
+    TEST_ASSERT_TRUE(stats.getSummary("layer", 3, layer));
+    TEST_ASSERT_EQ(layer.samples, GpuTimingStats::WINDOW);
+    TEST_ASSERT_TRUE(std::fabs(layer.averageMs - 2.0) < 1e-5);
+    TEST_ASSERT_TRUE(std::fabs(layer.maxMs - 2.0) < 1e-5);
+
+    // Not seen for a whole window: dropped (the master pass went away)
+    GpuTimingStats::Summary master;
+    TEST_ASSERT_FALSE(stats.getSummary("master", -1, master));
+
+    stats.reset();
+    TEST_ASSERT_TRUE(stats.getSummaries().empty());
+    return true;
+}
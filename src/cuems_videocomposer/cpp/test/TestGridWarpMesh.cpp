@@ -0,0 +1,136 @@
+#include "TestFramework.h"
+#include "../display/GridWarpMesh.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+std::vector<float> makeGrid(int columns, int rows, float barrel) {
+    std::vector<float> points;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            float s = static_cast<float>(column) / (columns - 1);
+            float t = static_cast<float>(row) / (rows - 1);
+            float x = s * 2.0f - 1.0f, y = t * 2.0f - 1.0f;
+            float r2 = x * x + y * y;
+            points.push_back(s + barrel * x * r2);
+            points.push_back(t + barrel * y * r2);
+        }
+    }
+    return points;
+}
+
+} // namespace
+
+bool test_GridWarpMesh_Interpolation() {
+    // A flat grid is the identity everywhere, and needs no subdivision
+    GridWarpMesh flat;
+    TEST_ASSERT(!flat.isValid());
+    TEST_ASSERT(flat.setGrid(3, 3, makeGrid(3, 3, 0.0f)));
+    float u, v;
+    flat.evaluate(0.1f, 0.95f, u, v);
+    TEST_ASSERT(std::abs(u - 0.1f) < 1e-5f && std::abs(v - 0.95f) < 1e-5f);
+    std::vector<WarpVertex> vertices;
+    std::vector<uint32_t> indices;
+    TEST_ASSERT(flat.buildMesh(1920, 1080, vertices, indices));
+    TEST_ASSERT_EQ(vertices.size(), static_cast<size_t>(9));
+    TEST_ASSERT_EQ(indices.size(), static_cast<size_t>(8 * 3));
+    
+    // Both interpolations pass through the control points
+    std::vector<float> points = makeGrid(9, 9, 0.05f);
+    GridWarpMesh curved;
+    TEST_ASSERT(curved.setGrid(9, 9, points));
+    unsigned int revision = curved.revision();
+    for (auto mode : {GridWarpMesh::Interpolation::Bicubic, GridWarpMesh::Interpolation::Bilinear}) {
+        curved.setInterpolation(mode);
+        curved.evaluate(3.0f / 8.0f, 5.0f / 8.0f, u, v);
+        TEST_ASSERT(std::abs(u - points[(5 * 9 + 3) * 2]) < 1e-5f);
+        TEST_ASSERT(std::abs(v - points[(5 * 9 + 3) * 2 + 1]) < 1e-5f);
+    }
+    TEST_ASSERT(curved.revision() != revision);
+    
+    // Wrong point count is refused
+    TEST_ASSERT(!curved.setGrid(4, 4, points));
+    return true;
+}
+
+bool test_GridWarpMesh_AdaptiveMesh() {
+    const int width = 1920, height = 1080;
+    GridWarpMesh mesh;
+    TEST_ASSERT(mesh.setGrid(9, 9, makeGrid(9, 9, 0.05f)));
+    mesh.setTolerance(0.5f);
+    
+    std::vector<int> columnSteps, rowSteps;
+    mesh.subdivisions(width, height, columnSteps, rowSteps);
+    TEST_ASSERT_EQ(columnSteps.size(), static_cast<size_t>(8));
+    // The barrel bends most at the borders
+    TEST_ASSERT(columnSteps[0] > 1);
+    TEST_ASSERT(columnSteps[0] >= columnSteps[3]);
+    
+    std::vector<WarpVertex> vertices;
+    std::vector<uint32_t> indices;
+    TEST_ASSERT(mesh.buildMesh(width, height, vertices, indices));
+    size_t columns = 1, rows = 1;
+    for (int steps : columnSteps) columns += steps;
+    for (int steps : rowSteps) rows += steps;
+    TEST_ASSERT_EQ(vertices.size(), columns * rows);
+    TEST_ASSERT_EQ(indices.size(), (columns - 1) * (rows - 1) * 6);
+    TEST_ASSERT(vertices.front().x == 0.0f && vertices.back().x == 1.0f && vertices.back().y == 1.0f);
+    for (uint32_t index : indices) {
+        TEST_ASSERT(index < vertices.size());
+    }
+    
+    // Edges of the triangles stay close to the interpolated warp
+    float worst = 0.0f;
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t column = 0; column + 1 < columns; ++column) {
+            const WarpVertex& a = vertices[row * columns + column];
+            const WarpVertex& b = vertices[row * columns + column + 1];
+            float u, v;
+            mesh.evaluate(0.5f * (a.x + b.x), 0.5f * (a.y + b.y), u, v);
+            float du = (u - 0.5f * (a.u + b.u)) * width;
+            float dv = (v - 0.5f * (a.v + b.v)) * height;
+            worst = std::max(worst, std::sqrt(du * du + dv * dv));
+        }
+    }
+    TEST_ASSERT(worst < 1.0f);
+    return true;
+}
+
+bool test_GridWarpMesh_LoadFile() {
+    std::string path = "/tmp/test_grid_warp_mesh.txt";
+    {
+        std::ofstream file(path);
+        file << "# projector 2 calibration\n";
+        file << "grid 2 2 bilinear\n";
+        file << "0 0\n1 0  # bottom row\n";
+        file << "0.1 1\n0.9 1\n";
+    }
+    GridWarpMesh mesh;
+    TEST_ASSERT(mesh.loadFromFile(path));
+    int columns = 0, rows = 0;
+    mesh.getDimensions(columns, rows);
+    TEST_ASSERT_EQ(columns, 2);
+    TEST_ASSERT_EQ(rows, 2);
+    TEST_ASSERT(mesh.getInterpolation() == GridWarpMesh::Interpolation::Bilinear);
+    float u, v;
+    mesh.evaluate(0.0f, 0.5f, u, v);
+    TEST_ASSERT(std::abs(u - 0.05f) < 1e-5f && std::abs(v - 0.5f) < 1e-5f);
+    
+    // Missing points: not loaded
+    {
+        std::ofstream file(path);
+        file << "grid 3 3\n0 0\n";
+    }
+    GridWarpMesh broken;
+    TEST_ASSERT(!broken.loadFromFile(path));
+    TEST_ASSERT(!broken.isValid());
+    std::remove(path.c_str());
+    return true;
+}
@@ -0,0 +1,132 @@
+#include "TestFramework.h"
+#include "../hap/HapChunkPool.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+struct ChunkCounts {
+    std::vector<std::atomic<int>> hits;
+    explicit ChunkCounts(unsigned int count) : hits(count) {
+        for (auto& h : hits) {
+            h = 0;
+        }
+    }
+};
+
+void countChunk(void* p, unsigned int index) {
+    static_cast<ChunkCounts*>(p)->hits[index]++;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+bool eachChunkOnce(const ChunkCounts& counts) {
+    for (const auto& h : counts.hits) {
+        if (h.load() != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct NestedBatches {
+    HapChunkPool* pool;
+    std::vector<std::unique_ptr<ChunkCounts>> inner;
+};
+
+// Outer chunk = one texture, whose own chunks go to the same pool
+void runNested(void* p, unsigned int index) {
+    NestedBatches* nested = static_cast<NestedBatches*>(p);
+    ChunkCounts* counts = nested->inner[index].get();
+    nested->pool->run(countChunk, counts, static_cast<unsigned int>(counts->hits.size()));
+}
+
+} // namespace
+
+bool test_HapChunkPool_RunsAllChunks() {
+    HapChunkPool pool(3);
+    TEST_ASSERT_EQ(pool.getMaxConcurrency(), static_cast<size_t>(3));
+
+    // Several layers decoding at once share the same workers
+    const int callers = 4;
+    const unsigned int chunks = 32;
+    std::vector<std::unique_ptr<ChunkCounts>> counts;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < callers; ++i) {
+        counts.push_back(std::make_unique<ChunkCounts>(chunks));
+    }
+    auto now = HapChunkPool::Clock::now();
+    for (int i = 0; i < callers; ++i) {
+        ChunkCounts* c = counts[i].get();
+        auto deadline = now + std::chrono::milliseconds(10 * (i + 1));
+        threads.emplace_back([&pool, c, deadline] {
+            for (int frame = 0; frame < 3; ++frame) {
+                pool.run(countChunk, c, chunks, deadline);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto& c : counts) {
+        for (auto& h : c->hits) {
+            TEST_ASSERT_EQ(h.load(), 3);
+        }
+    }
+
+    HapChunkPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQ(stats.batches, static_cast<uint64_t>(callers * 3));
+    TEST_ASSERT_EQ(stats.chunks, static_cast<uint64_t>(callers * 3 * chunks));
+    TEST_ASSERT(stats.workerChunks <= stats.chunks);
+    return true;
+}
+
+bool test_HapChunkPool_Reconfigure() {
+    // Concurrency 1: everything runs on the caller
+    HapChunkPool pool(1);
+    ChunkCounts serial(8);
+    pool.run(countChunk, &serial, 8);
+    TEST_ASSERT_TRUE(eachChunkOnce(serial));
+    TEST_ASSERT_EQ(pool.getStats().workerChunks, static_cast<uint64_t>(0));
+
+    // Resizing while a batch runs must not lose or repeat chunks
+    ChunkCounts busy(64);
+    std::thread caller([&pool, &busy] { pool.run(countChunk, &busy, 64); });
+    pool.configure(4);
+    caller.join();
+    TEST_ASSERT_TRUE(eachChunkOnce(busy));
+    TEST_ASSERT_EQ(pool.getMaxConcurrency(), static_cast<size_t>(4));
+
+    pool.resetStats();
+    ChunkCounts after(16);
+    pool.run(countChunk, &after, 16);
+    TEST_ASSERT_TRUE(eachChunkOnce(after));
+    TEST_ASSERT_EQ(pool.getStats().chunks, static_cast<uint64_t>(16));
+    TEST_ASSERT_EQ(pool.getStats().maxConcurrency, static_cast<size_t>(4));
+    return true;
+}
+
+bool test_HapChunkPool_NestedBatches() {
+    // HAP Q Alpha: two textures in parallel, each with its chunks
+    HapChunkPool pool(3);
+    NestedBatches nested;
+    nested.pool = &pool;
+    nested.inner.push_back(std::make_unique<ChunkCounts>(16));
+    nested.inner.push_back(std::make_unique<ChunkCounts>(8));
+    for (int frame = 0; frame < 5; ++frame) {
+        for (auto& c : nested.inner) {
+            for (auto& h : c->hits) {
+                h = 0;
+            }
+        }
+        pool.run(runNested, &nested, 2);
+        TEST_ASSERT_TRUE(eachChunkOnce(*nested.inner[0]));
+        TEST_ASSERT_TRUE(eachChunkOnce(*nested.inner[1]));
+    }
+    TEST_ASSERT_EQ(pool.getStats().batches, static_cast<uint64_t>(5 * 3));
+    return true;
+}
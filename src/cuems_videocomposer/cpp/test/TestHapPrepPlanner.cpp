@@ -0,0 +1,78 @@
+#include "TestFramework.h"
+#include "../hap/HapPrepPlanner.h"
+#include "../layer/LoadAdmission.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_HapPrepPlanner_ChunksFollowThreads() {
+    // 1080p HAP: 480x270 blocks of 8 bytes
+    size_t bytes = HapPrepPlanner::textureBytes(HapPrepPlanner::Format::HAP, 1920, 1080);
+    TEST_ASSERT_EQ(bytes, static_cast<size_t>(480 * 270 * 8));
+    TEST_ASSERT_EQ(HapPrepPlanner::textureBytes(HapPrepPlanner::Format::HAP_Q, 1920, 1080), bytes * 2);
+
+    TEST_ASSERT_EQ(HapPrepPlanner::chooseChunks(bytes, 1), 1);
+    TEST_ASSERT_EQ(HapPrepPlanner::chooseChunks(bytes, 8), 8);
+    size_t uhd = HapPrepPlanner::textureBytes(HapPrepPlanner::Format::HAP_Q, 3840, 2160);
+    TEST_ASSERT_EQ(HapPrepPlanner::chooseChunks(uhd, 200), HapPrepPlanner::MAX_CHUNKS);
+    // 1 MB of texture: no chunk smaller than MIN_CHUNK_BYTES (15 of 69120 bytes)
+    TEST_ASSERT_EQ(HapPrepPlanner::chooseChunks(bytes, 200), 15);
+    // Not a divisor of the texture: the next smaller one
+    TEST_ASSERT_EQ(HapPrepPlanner::chooseChunks(bytes, 7), 6);
+    // Small frames are not cut below MIN_CHUNK_BYTES
+    size_t small = HapPrepPlanner::textureBytes(HapPrepPlanner::Format::HAP, 320, 240);
+    TEST_ASSERT_EQ(HapPrepPlanner::chooseChunks(small, 16), 1);
+
+    HapPrepPlanner::Machine machine;
+    machine.chunkThreads = 8;
+    HapPrepPlanner::Source source;
+    source.width = 3840;
+    source.height = 2160;
+    HapPrepPlanner::Plan plan = HapPrepPlanner::plan(machine, source, HapPrepPlanner::Format::AUTO, false);
+    TEST_ASSERT_TRUE(plan.format == HapPrepPlanner::Format::HAP);
+    TEST_ASSERT_EQ(plan.chunks, 8);
+    TEST_ASSERT_TRUE(plan.snappy);
+    TEST_ASSERT_TRUE(plan.decodeMs > 0.0);
+    return true;
+}
+
+bool test_HapPrepPlanner_FormatAndSnappy() {
+    HapPrepPlanner::Machine machine;
+    machine.chunkThreads = 4;
+    HapPrepPlanner::Source source;
+    source.width = 1920;
+    source.height = 1080;
+    source.framerate = 60.0;
+
+    // Variant from alpha, quality and the GPU
+    using Format = HapPrepPlanner::Format;
+    TEST_ASSERT_TRUE(HapPrepPlanner::plan(machine, source, Format::AUTO, true).format == Format::HAP_Q);
+    source.alpha = true;
+    TEST_ASSERT_TRUE(HapPrepPlanner::plan(machine, source, Format::AUTO, false).format == Format::HAP_ALPHA);
+    TEST_ASSERT_TRUE(HapPrepPlanner::plan(machine, source, Format::HAP_R, false).format == Format::HAP_ALPHA);
+    machine.bptc = true;
+    TEST_ASSERT_TRUE(HapPrepPlanner::plan(machine, source, Format::AUTO, true).format == Format::HAP_R);
+    source.alpha = false;
+
+    // Slow decompression (benchmarked) on a disk that carries raw textures: no Snappy
+    LoadAdmission costs;
+    costs.setDecodeCost("HAP", false, 0.01);
+    machine.costs = &costs;
+    machine.storageBytesPerSecond = 2e9;
+    HapPrepPlanner::Plan plan = HapPrepPlanner::plan(machine, source, Format::HAP, false);
+    TEST_ASSERT_FALSE(plan.snappy);
+    TEST_ASSERT_EQ(plan.chunks, 1);
+    TEST_ASSERT_EQ(plan.decodeMs, 0.0);
+
+    // The same on a slow disk, or with the storage unknown: Snappy stays
+    machine.storageBytesPerSecond = 50e6;
+    TEST_ASSERT_TRUE(HapPrepPlanner::plan(machine, source, Format::HAP, false).snappy);
+    machine.storageBytesPerSecond = 0.0;
+    TEST_ASSERT_TRUE(HapPrepPlanner::plan(machine, source, Format::HAP, false).snappy);
+
+    Format parsed = Format::AUTO;
+    TEST_ASSERT_TRUE(HapPrepPlanner::parseFormat("hap_q", parsed));
+    TEST_ASSERT_TRUE(parsed == Format::HAP_Q);
+    TEST_ASSERT_FALSE(HapPrepPlanner::parseFormat("dxv", parsed));
+    return true;
+}
@@ -0,0 +1,81 @@
+#include "TestFramework.h"
+#include "../input/HardwareDeviceCache.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+HardwareDeviceCache::Capability capability(AVCodecID codec, int profile, int maxSize, int bitDepth) {
+    HardwareDeviceCache::Capability entry;
+    entry.codec = codec;
+    entry.profile = profile;
+    entry.maxWidth = maxSize;
+    entry.maxHeight = maxSize;
+    entry.maxBitDepth = bitDepth;
+    return entry;
+}
+
+} // namespace
+
+bool test_HardwareDeviceCache_Capabilities() {
+    using Support = HardwareDeviceCache::Support;
+    const std::string node = "/dev/dri/renderD128";
+    HardwareDeviceCache cache;
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_H264, 100, 1920, 1080, 8) == Support::UNKNOWN);
+
+    // H.264 High up to 4096, HEVC Main 10 up to 8192
+    cache.setCapabilities(node, {capability(AV_CODEC_ID_H264, 100, 4096, 8),
+                                 capability(AV_CODEC_ID_HEVC, 2, 8192, 10)});
+    TEST_ASSERT_TRUE(cache.isProbed(node));
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_H264, 77, 1920, 1080, 8) == Support::SUPPORTED);
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_H264, 110, 1920, 1080, 10) == Support::UNSUPPORTED);
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_H264, 100, 7680, 4320, 8) == Support::UNSUPPORTED);
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_HEVC, 1, 7680, 4320, 8) == Support::SUPPORTED);
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_HEVC, HardwareDeviceCache::PROFILE_UNKNOWN, 3840, 2160, 12) ==
+                     Support::UNSUPPORTED);
+    TEST_ASSERT_TRUE(cache.supports(node, AV_CODEC_ID_AV1, 0, 1920, 1080, 8) == Support::UNSUPPORTED);
+
+    // Saved and loaded; a file from another FFmpeg build is ignored
+    char tmpl[] = "/tmp/cvc_hwcaps_XXXXXX";
+    int fd = mkstemp(tmpl);
+    TEST_ASSERT_TRUE(fd >= 0);
+    ::close(fd);
+    TEST_ASSERT_TRUE(cache.save(tmpl));
+    HardwareDeviceCache loaded;
+    TEST_ASSERT_TRUE(loaded.load(tmpl));
+    TEST_ASSERT_TRUE(loaded.isProbed(node));
+    TEST_ASSERT_TRUE(loaded.supports(node, AV_CODEC_ID_HEVC, 1, 7680, 4320, 8) == Support::SUPPORTED);
+    TEST_ASSERT_TRUE(loaded.supports(node, AV_CODEC_ID_H264, 100, 7680, 4320, 8) == Support::UNSUPPORTED);
+    {
+        std::ofstream stale(tmpl);
+        stale << "# cuems-videocomposer hardware decode capabilities\nffmpeg 0.0\ndevice " << node << "\n";
+    }
+    HardwareDeviceCache staleCache;
+    TEST_ASSERT_FALSE(staleCache.load(tmpl));
+    TEST_ASSERT_FALSE(staleCache.isProbed(node));
+    std::remove(tmpl);
+
+    // One device context per key, shared by reference
+    int created = 0;
+    auto factory = [&created]() -> AVBufferRef* {
+        created++;
+        return av_buffer_alloc(16);
+    };
+    AVBufferRef* first = cache.acquireDevice(node, factory);
+    AVBufferRef* second = cache.acquireDevice(node, factory);
+    TEST_ASSERT_TRUE(first && second && first->data == second->data);
+    TEST_ASSERT_EQ(created, 1);
+    TEST_ASSERT_TRUE(cache.acquireDevice("broken", []() -> AVBufferRef* { return nullptr; }) == nullptr);
+    av_buffer_unref(&first);
+    av_buffer_unref(&second);
+    cache.releaseDevices();
+    AVBufferRef* third = cache.acquireDevice(node, factory);
+    TEST_ASSERT_EQ(created, 2);
+    av_buffer_unref(&third);
+    return true;
+}
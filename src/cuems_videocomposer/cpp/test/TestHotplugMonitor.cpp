@@ -0,0 +1,104 @@
+#include "TestFramework.h"
+#include "../display/drm/HotplugMonitor.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_HotplugMonitor_Changes() {
+    // Connector 31 unplugged at start, 32 and 33 connected
+    std::map<uint32_t, bool> hardware = {{31, false}, {32, true}, {33, true}};
+    int forcedProbes = 0;
+    HotplugMonitor monitor;
+    monitor.setConnectors({{31, false}, {32, true}, {33, true}});
+    TEST_ASSERT(monitor.start([&](uint32_t id, bool force, bool& connected) {
+        forcedProbes += force;
+        if (id == 33) {
+            return false;   // Unreadable: never reported
+        }
+        connected = hardware[id];
+        return true;
+    }, 60000));
+    // Probe installed, thread stopped: the passes below run on this thread
+    monitor.stop();
+
+    // No change, nothing queued
+    monitor.probeAll(false);
+    TEST_ASSERT(monitor.takeChanges().empty());
+
+    // A projector power-cycles while another is plugged in
+    hardware[32] = false;
+    hardware[31] = true;
+    hardware[33] = false;
+    monitor.probeAll(true);
+    std::vector<HotplugMonitor::Change> changes = monitor.takeChanges();
+    TEST_ASSERT(changes.size() == 2);
+    TEST_ASSERT(changes[0].connectorId == 31 && changes[0].connected);
+    TEST_ASSERT(changes[1].connectorId == 32 && !changes[1].connected);
+    TEST_ASSERT(forcedProbes == 3);
+    TEST_ASSERT(monitor.takeChanges().empty());
+
+    // Reported once, then again when it comes back
+    monitor.probeAll(false);
+    TEST_ASSERT(monitor.takeChanges().empty());
+    hardware[32] = true;
+    monitor.probeAll(false);
+    changes = monitor.takeChanges();
+    TEST_ASSERT(changes.size() == 1 && changes[0].connectorId == 32 && changes[0].connected);
+    return true;
+}
+
+bool test_HotplugMonitor_Thread() {
+    std::mutex mutex;
+    bool plugged = false;
+    std::atomic<int> probes(0);
+    HotplugMonitor monitor;
+    monitor.setConnectors({{40, false}});
+    TEST_ASSERT(monitor.start([&](uint32_t, bool, bool& connected) {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected = plugged;
+        ++probes;
+        return true;
+    }, 5));
+    TEST_ASSERT(monitor.isRunning());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        plugged = true;
+    }
+
+    // Picked up by the probe thread, not the caller
+    std::vector<HotplugMonitor::Change> changes;
+    for (int i = 0; i < 400 && changes.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        changes = monitor.takeChanges();
+    }
+    TEST_ASSERT(changes.size() == 1 && changes[0].connectorId == 40 && changes[0].connected);
+
+    // stop() returns without waiting out the interval
+    monitor.stop();
+    TEST_ASSERT(!monitor.isRunning());
+    int stopped = probes;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_ASSERT(probes == stopped);
+    return true;
+}
+
+bool test_HotplugMonitor_Uevent() {
+    const char hotplug[] = "change@/devices/pci0000:00/0000:00:02.0/drm/card0\0ACTION=change\0"
+                           "DEVPATH=/devices/pci0000:00/0000:00:02.0/drm/card0\0SUBSYSTEM=drm\0"
+                           "HOTPLUG=1\0DEVNAME=dri/card0\0SEQNUM=4242";
+    TEST_ASSERT(HotplugMonitor::isDrmHotplugEvent(hotplug, sizeof(hotplug) - 1));
+
+    // Other subsystems, other actions and a truncated message are not
+    const char usb[] = "change@/devices/usb1\0ACTION=change\0SUBSYSTEM=usb\0HOTPLUG=1";
+    TEST_ASSERT(!HotplugMonitor::isDrmHotplugEvent(usb, sizeof(usb) - 1));
+    const char add[] = "add@/devices/drm/card0\0ACTION=add\0SUBSYSTEM=drm\0HOTPLUG=1";
+    TEST_ASSERT(!HotplugMonitor::isDrmHotplugEvent(add, sizeof(add) - 1));
+    TEST_ASSERT(!HotplugMonitor::isDrmHotplugEvent(hotplug, 60));
+    TEST_ASSERT(!HotplugMonitor::isDrmHotplugEvent(nullptr, 0));
+    return true;
+}
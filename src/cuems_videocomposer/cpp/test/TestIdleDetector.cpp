@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "../display/IdleDetector.h"
+#include "../utils/WakeSignal.h"
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_IdleDetector_SettlesThenHolds() {
+    IdleDetector detector(2);
+    IdleDetector::Frame frame;
+    frame.sceneVersion = 5;
+
+    // The first frame is a change; two quiet frames are still rendered
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+    TEST_ASSERT_TRUE(detector.update(frame, 10));
+    TEST_ASSERT_TRUE(detector.update(frame, 20));
+    TEST_ASSERT_FALSE(detector.isIdle());
+    TEST_ASSERT_FALSE(detector.update(frame, 30));
+    TEST_ASSERT_TRUE(detector.isIdle());
+    TEST_ASSERT_EQ(detector.getIdleSinceUs(), static_cast<int64_t>(30));
+    TEST_ASSERT_FALSE(detector.update(frame, 40));
+    TEST_ASSERT_EQ(detector.getIdlePeriods(), static_cast<uint64_t>(1));
+
+    // An OSD change ends idle on the frame it is seen
+    frame.osdVersion = 1;
+    TEST_ASSERT_TRUE(detector.update(frame, 130));
+    TEST_ASSERT_FALSE(detector.isIdle());
+    TEST_ASSERT_EQ(detector.getLastIdleUs(), static_cast<int64_t>(100));
+
+    // A visible layer never goes idle, however static
+    frame.visible = true;
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_TRUE(detector.update(frame, 140 + i));
+    }
+    TEST_ASSERT_EQ(detector.getIdlePeriods(), static_cast<uint64_t>(1));
+    return true;
+}
+
+bool test_IdleDetector_ActivityAndDisable() {
+    IdleDetector detector(1);
+    IdleDetector::Frame frame;
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+    TEST_ASSERT_FALSE(detector.update(frame, 0));
+
+    // Activity (a command, a rolling clock) restarts the settle frames
+    frame.activity = true;
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+    frame.activity = false;
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+    TEST_ASSERT_FALSE(detector.update(frame, 0));
+
+    // A new scene version (layer added, property or frame changed) too
+    frame.sceneVersion = 2;
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+
+    // The backend could not hold its frame: rendering goes on
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+    TEST_ASSERT_FALSE(detector.update(frame, 0));
+    detector.reset();
+    TEST_ASSERT_FALSE(detector.isIdle());
+    TEST_ASSERT_TRUE(detector.update(frame, 0));
+
+    detector.setEnabled(false);
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_TRUE(detector.update(frame, 0));
+    }
+    TEST_ASSERT_FALSE(detector.isIdle());
+    return true;
+}
+
+bool test_WakeSignal_KeepsEarlyNotify() {
+    WakeSignal wake;
+    TEST_ASSERT_FALSE(wake.waitFor(1000));
+
+    // Notified before the wait: returns at once, and only once
+    wake.notify();
+    TEST_ASSERT_TRUE(wake.waitFor(10000000));
+    TEST_ASSERT_FALSE(wake.waitFor(1000));
+
+    std::thread notifier([&wake] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        wake.notify();
+    });
+    bool woken = wake.waitFor(10000000);
+    notifier.join();
+    TEST_ASSERT_TRUE(woken);
+
+    wake.notify();
+    wake.clear();
+    TEST_ASSERT_FALSE(wake.waitFor(1000));
+    return true;
+}
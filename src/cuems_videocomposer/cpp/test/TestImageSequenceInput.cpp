@@ -0,0 +1,85 @@
+#include "TestFramework.h"
+#include "../input/ImageSequenceInput.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+std::string makeTempDir() {
+    char tmpl[] = "/tmp/cvc_sequence_XXXXXX";
+    const char* dir = mkdtemp(tmpl);
+    return dir ? std::string(dir) : std::string();
+}
+
+bool touch(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
+
+} // namespace
+
+bool test_ImageSequenceInput_Pattern() {
+    using Pattern = ImageSequenceInput::Pattern;
+    Pattern pattern;
+    int64_t number = 0;
+
+    // printf pattern
+    TEST_ASSERT_TRUE(Pattern::parse("/shots/a.%06d.dpx", pattern, &number));
+    TEST_ASSERT_EQ(pattern.prefix, std::string("/shots/a."));
+    TEST_ASSERT_EQ(pattern.suffix, std::string(".dpx"));
+    TEST_ASSERT_EQ(pattern.digits, 6);
+    TEST_ASSERT_EQ(number, -1);
+    TEST_ASSERT_EQ(pattern.pathFor(42), std::string("/shots/a.000042.dpx"));
+    TEST_ASSERT_EQ(pattern.pathFor(12345678), std::string("/shots/a.12345678.dpx"));
+
+    // '#' run
+    TEST_ASSERT_TRUE(Pattern::parse("/shots/b_####.exr", pattern, &number));
+    TEST_ASSERT_EQ(pattern.prefix, std::string("/shots/b_"));
+    TEST_ASSERT_EQ(pattern.digits, 4);
+    TEST_ASSERT_EQ(number, -1);
+
+    // Numbered file: the last digit run, not the one in the directory or name
+    TEST_ASSERT_TRUE(Pattern::parse("/take2/v3_0100.png", pattern, &number));
+    TEST_ASSERT_EQ(pattern.prefix, std::string("/take2/v3_"));
+    TEST_ASSERT_EQ(pattern.suffix, std::string(".png"));
+    TEST_ASSERT_EQ(pattern.digits, 4);
+    TEST_ASSERT_EQ(number, 100);
+
+    TEST_ASSERT_FALSE(Pattern::parse("/take2/logo.png", pattern));
+    TEST_ASSERT_FALSE(Pattern::parse("/shots/a.%s.dpx", pattern));
+
+    TEST_ASSERT_TRUE(ImageSequenceInput::isImageExtension("/a/b.TIFF"));
+    TEST_ASSERT_FALSE(ImageSequenceInput::isImageExtension("/a.dpx/clip.mov"));
+
+    // Scan finds the range, ignoring other names and other paddings
+    std::string dir = makeTempDir();
+    TEST_ASSERT_TRUE(!dir.empty());
+    const char* names[] = { "f_0007.tga", "f_0008.tga", "f_0010.tga", "f_10000.tga",
+                            "f_007.tga", "f_00009.tga", "g_0001.tga", "f_0003.png" };
+    for (const char* name : names) {
+        TEST_ASSERT_TRUE(touch(dir + "/" + name));
+    }
+    TEST_ASSERT_TRUE(Pattern::parse(dir + "/f_0008.tga", pattern));
+    TEST_ASSERT_TRUE(pattern.scan());
+    TEST_ASSERT_EQ(pattern.first, 7);
+    TEST_ASSERT_EQ(pattern.last, 10000);
+    TEST_ASSERT_EQ(pattern.frameCount(), 9994);
+
+    TEST_ASSERT_TRUE(ImageSequenceInput::isSequencePath(dir + "/f_0007.tga"));
+    TEST_ASSERT_TRUE(ImageSequenceInput::isSequencePath(dir + "/f_%04d.tga"));
+    // A lone numbered still is not a sequence
+    TEST_ASSERT_FALSE(ImageSequenceInput::isSequencePath(dir + "/g_0001.tga"));
+
+    for (const char* name : names) {
+        unlink((dir + "/" + name).c_str());
+    }
+    rmdir(dir.c_str());
+    return true;
+}
@@ -158,3 +158,79 @@ bool test_LayerManager_Reorder() {
     return true;
 }
 
+
+bool test_LayerManager_Snapshot() {
+    LayerManager manager;
+    
+    auto low = std::make_unique<VideoLayer>();
+    low->setInputSource(std::make_unique<MockInputSource>());
+    low->properties().zOrder = 1;
+    auto high = std::make_unique<VideoLayer>();
+    high->setInputSource(std::make_unique<MockInputSource>());
+    high->properties().zOrder = 2;
+    int lowId = manager.addLayer(std::move(low));
+    int highId = manager.addLayer(std::move(high));
+    
+    auto first = manager.getSnapshot();
+    TEST_ASSERT_EQ(first->layers.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(first->entries[0].layerId, highId);
+    TEST_ASSERT_EQ(first->entries[1].layerId, lowId);
+    
+    // Nothing changed: same version, same list
+    TEST_ASSERT_FALSE(manager.publishSnapshot());
+    TEST_ASSERT_TRUE(manager.getSnapshot() == first);
+    
+    // A property change publishes a new version; the held one stays as it was
+    manager.getLayer(lowId)->properties().opacity = 0.5f;
+    TEST_ASSERT_TRUE(manager.publishSnapshot());
+    auto second = manager.getSnapshot();
+    TEST_ASSERT_TRUE(second->version > first->version);
+    TEST_ASSERT_TRUE(first->entries[1].properties.opacity == 1.0f);
+    TEST_ASSERT_TRUE(second->entries[1].properties.opacity == 0.5f);
+    
+    // Removing a layer drops it from the render list at once
+    manager.removeLayer(highId);
+    auto third = manager.getSnapshot();
+    TEST_ASSERT_EQ(third->layers.size(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(third->entries[0].layerId, lowId);
+    
+    return true;
+}
+
+bool test_LayerManager_Groups() {
+    LayerManager manager;
+    
+    auto logo = std::make_unique<VideoLayer>();
+    logo->setInputSource(std::make_unique<MockInputSource>());
+    auto lowerThird = std::make_unique<VideoLayer>();
+    lowerThird->setInputSource(std::make_unique<MockInputSource>());
+    int logoId = manager.addLayer(std::move(logo));
+    int lowerThirdId = manager.addLayer(std::move(lowerThird));
+    
+    // Joining a group creates it; both members share its id
+    TEST_ASSERT_TRUE(manager.setLayerGroup(logoId, "scene"));
+    TEST_ASSERT_TRUE(manager.setLayerGroup(lowerThirdId, "scene"));
+    LayerGroup* group = manager.getGroup("scene");
+    TEST_ASSERT_TRUE(group != nullptr);
+    TEST_ASSERT_EQ(manager.getGroupCount(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(manager.getLayer(logoId)->properties().groupId, group->groupId);
+    TEST_ASSERT_TRUE(manager.createGroup("scene") == group);
+    
+    // The render list carries the group; moving it is a new version
+    TEST_ASSERT_TRUE(manager.publishSnapshot());
+    auto before = manager.getSnapshot();
+    TEST_ASSERT_EQ(before->groups.size(), static_cast<size_t>(1));
+    group->properties.opacity = 0.5f;
+    TEST_ASSERT_TRUE(manager.publishSnapshot());
+    TEST_ASSERT_TRUE(manager.getSnapshot()->groups[0].properties.opacity == 0.5f);
+    TEST_ASSERT_TRUE(before->groups[0].properties.opacity == 1.0f);
+    
+    // Removing the group leaves its members as plain layers
+    TEST_ASSERT_TRUE(manager.removeGroup("scene"));
+    TEST_ASSERT_FALSE(manager.removeGroup("scene"));
+    TEST_ASSERT_EQ(manager.getLayer(lowerThirdId)->properties().groupId, 0);
+    TEST_ASSERT_TRUE(manager.setLayerGroup(logoId, ""));
+    TEST_ASSERT_FALSE(manager.setLayerGroup(999, "scene"));
+    
+    return true;
+}
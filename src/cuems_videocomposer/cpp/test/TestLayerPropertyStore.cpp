@@ -0,0 +1,43 @@
+#include "TestFramework.h"
+#include "../layer/LayerPropertyStore.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_LayerPropertyStore_StableSlots() {
+    LayerPropertyStore store;
+    // Owners are only compared, never dereferenced
+    VideoLayer* a = reinterpret_cast<VideoLayer*>(0x10);
+    VideoLayer* b = reinterpret_cast<VideoLayer*>(0x20);
+
+    LayerProperties initial;
+    initial.opacity = 0.25f;
+    size_t slotA = store.acquire(a, initial);
+    size_t slotB = store.acquire(b, LayerProperties());
+    TEST_ASSERT_EQ(slotA, static_cast<size_t>(0));
+    TEST_ASSERT_EQ(slotB, static_cast<size_t>(1));
+    TEST_ASSERT_TRUE(store.at(slotA).opacity == 0.25f);
+    TEST_ASSERT_TRUE(store.owner(slotB) == b);
+
+    // Addresses survive growth past one block
+    LayerProperties* held = &store.at(slotA);
+    for (size_t i = 0; i < LayerPropertyStore::BLOCK_SIZE * 2; ++i) {
+        store.acquire(b, LayerProperties());
+    }
+    TEST_ASSERT_TRUE(&store.at(slotA) == held);
+    TEST_ASSERT_EQ(store.size(), LayerPropertyStore::BLOCK_SIZE * 2 + 2);
+
+    // A released slot is reset and reused first
+    store.release(slotA);
+    TEST_ASSERT_TRUE(store.owner(slotA) == nullptr);
+    TEST_ASSERT_EQ(store.acquire(b, LayerProperties()), slotA);
+    TEST_ASSERT_TRUE(store.at(slotA).opacity == 1.0f);
+
+    // Releasing twice or out of range is harmless
+    store.release(slotB);
+    store.release(slotB);
+    store.release(10000);
+    TEST_ASSERT_EQ(store.size(), LayerPropertyStore::BLOCK_SIZE * 2 + 1);
+    TEST_ASSERT_EQ(store.slotCount(), LayerPropertyStore::BLOCK_SIZE * 2 + 2);
+    return true;
+}
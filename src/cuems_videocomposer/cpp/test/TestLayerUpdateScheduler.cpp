@@ -0,0 +1,57 @@
+#include "TestFramework.h"
+#include "../layer/LayerUpdateScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_LayerUpdateScheduler_RunsAllJobs() {
+    LayerUpdateScheduler scheduler(3);
+    TEST_ASSERT_EQ(scheduler.getWorkerCount(), static_cast<size_t>(3));
+
+    std::atomic<int> ran{0};
+    std::vector<std::function<void()>> jobs;
+    for (int i = 0; i < 16; ++i) {
+        jobs.push_back([&ran] { ran++; });
+    }
+    bool renderWorkRan = false;
+    auto deadline = LayerUpdateScheduler::Clock::now() + std::chrono::seconds(5);
+
+    // Several batches reuse the same workers
+    for (int batch = 0; batch < 4; ++batch) {
+        size_t skipped = scheduler.run(jobs, deadline, [&renderWorkRan] { renderWorkRan = true; });
+        TEST_ASSERT_EQ(skipped, static_cast<size_t>(0));
+    }
+    TEST_ASSERT_EQ(ran.load(), 64);
+    TEST_ASSERT_TRUE(renderWorkRan);
+
+    LayerUpdateScheduler::Stats stats = scheduler.getStats();
+    TEST_ASSERT_EQ(stats.batches, static_cast<uint64_t>(4));
+    TEST_ASSERT_EQ(stats.jobs, static_cast<uint64_t>(64));
+    return true;
+}
+
+bool test_LayerUpdateScheduler_Deadline() {
+    // No workers: jobs run in order on this thread, so the skip count is exact
+    LayerUpdateScheduler scheduler(0);
+
+    std::atomic<int> ran{0};
+    std::vector<std::function<void()>> jobs;
+    jobs.push_back([&ran] {
+        ran++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+    for (int i = 0; i < 3; ++i) {
+        jobs.push_back([&ran] { ran++; });
+    }
+
+    auto deadline = LayerUpdateScheduler::Clock::now() + std::chrono::milliseconds(5);
+    size_t skipped = scheduler.run(jobs, deadline);
+    TEST_ASSERT_EQ(skipped, static_cast<size_t>(3));
+    TEST_ASSERT_EQ(ran.load(), 1);
+    TEST_ASSERT_EQ(scheduler.getStats().skipped, static_cast<uint64_t>(3));
+    return true;
+}
@@ -0,0 +1,111 @@
+#include "TestFramework.h"
+#include "../input/LiveInputSource.h"
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Produces numbered 4x4 frames, as many as the test allows
+class FakeLiveInput : public LiveInputSource {
+public:
+    ~FakeLiveInput() override { close(); }
+
+    bool open(const std::string&) override { startCaptureThread(); return true; }
+    void close() override { stopping_ = true; stopCaptureThread(); }
+    bool isReady() const override { return true; }
+    FrameInfo getFrameInfo() const override { return FrameInfo(); }
+    int64_t getCurrentFrame() const override { return produced_; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+
+    void allow(int frames) { allowed_ += frames; }
+
+    // Wait until the capture thread has published everything allowed
+    bool waitPublished() {
+        for (int i = 0; i < 200; ++i) {
+            if (getStatistics().framesCaptured == static_cast<uint64_t>(allowed_.load())) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+
+protected:
+    bool captureFrame(FrameBuffer& buffer) override {
+        while (produced_ >= allowed_) {
+            if (stopping_) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        FrameInfo info;
+        info.width = 4;
+        info.height = 4;
+        info.format = PixelFormat::BGRA32;
+        if (!buffer.ensureAllocated(info)) {
+            return false;
+        }
+        buffer.data()[0] = static_cast<uint8_t>(produced_++);
+        return true;
+    }
+
+private:
+    std::atomic<int> allowed_{0};
+    std::atomic<int> produced_{0};
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace
+
+bool test_LiveInputSource_BufferSwap() {
+    FakeLiveInput input;
+    TEST_ASSERT(input.open(""));
+
+    FrameBuffer frame;
+    std::set<const uint8_t*> storage;
+
+    input.allow(1);
+    TEST_ASSERT(input.waitPublished());
+    TEST_ASSERT(input.readLatestFrame(frame));
+    TEST_ASSERT_EQ(frame.data()[0], 0);
+    storage.insert(frame.data());
+
+    // Nothing new: no frame, the caller keeps the one it has
+    TEST_ASSERT(!input.readLatestFrame(frame));
+    TEST_ASSERT_EQ(frame.data()[0], 0);
+
+    // Only the newest of several frames is delivered, the others count as dropped
+    input.allow(3);
+    TEST_ASSERT(input.waitPublished());
+    TEST_ASSERT_EQ(input.getBufferedFrameCount(), 1);
+    TEST_ASSERT(input.readLatestFrame(frame));
+    TEST_ASSERT_EQ(frame.data()[0], 3);
+    TEST_ASSERT(input.isBufferEmpty());
+    storage.insert(frame.data());
+
+    LiveInputSource::Statistics stats = input.getStatistics();
+    TEST_ASSERT_EQ(stats.framesCaptured, static_cast<uint64_t>(4));
+    TEST_ASSERT_EQ(stats.framesDropped, static_cast<uint64_t>(2));
+    TEST_ASSERT_EQ(stats.framesDelivered, static_cast<uint64_t>(2));
+
+    // Buffers are exchanged, not copied: the three slots and the caller's own
+    // storage are all that ever cycle through
+    for (int i = 0; i < 6; ++i) {
+        input.allow(1);
+        TEST_ASSERT(input.waitPublished());
+        TEST_ASSERT(input.readLatestFrame(frame));
+        TEST_ASSERT_EQ(frame.data()[0], 4 + i);
+        storage.insert(frame.data());
+    }
+    TEST_ASSERT(storage.size() <= 4);
+
+    input.close();
+    return true;
+}
@@ -0,0 +1,87 @@
+#include "TestFramework.h"
+#include "../input/LiveJitterBuffer.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// A tiny frame tagged with its number in the first byte
+FrameBuffer makeFrame(int number) {
+    FrameInfo info;
+    info.width = 2;
+    info.height = 2;
+    info.format = PixelFormat::RGBA32;
+    FrameBuffer frame;
+    frame.ensureAllocated(info);
+    frame.data()[0] = static_cast<uint8_t>(number);
+    return frame;
+}
+
+bool push(LiveJitterBuffer& jitter, int number, double pts, double received) {
+    FrameBuffer frame = makeFrame(number);
+    return jitter.push(pts, received, frame);
+}
+
+} // namespace
+
+bool test_LiveJitterBuffer_Pacing() {
+    // 25 fps with 2 s of network transit (pts clock and local clock differ)
+    LiveJitterBuffer jitter(0.1);
+    jitter.setFramePeriod(0.04);
+    FrameBuffer shown;
+
+    // Frame 0 is due 100ms after it arrived
+    TEST_ASSERT(push(jitter, 0, 0.0, 2.0));
+    TEST_ASSERT(!jitter.pop(2.05, shown));
+    double received = 0.0;
+    TEST_ASSERT(jitter.pop(2.101, shown, &received));
+    TEST_ASSERT_EQ(shown.data()[0], 0);
+    TEST_ASSERT(received == 2.0);
+
+    // Frame 1 arrives 60ms late (less than the target): still released on schedule
+    TEST_ASSERT(push(jitter, 1, 0.04, 2.1));
+    TEST_ASSERT(!jitter.pop(2.13, shown));
+    TEST_ASSERT(jitter.pop(2.145, shown));
+    TEST_ASSERT_EQ(shown.data()[0], 1);
+    TEST_ASSERT_EQ(jitter.depth(), 0u);
+
+    // Nothing for three frame periods: repeats, then a late frame goes out at once
+    TEST_ASSERT(!jitter.pop(2.29, shown));
+    TEST_ASSERT_EQ(jitter.repeatedFrames(), 3u);
+    TEST_ASSERT(push(jitter, 2, 0.08, 2.3));
+    TEST_ASSERT(jitter.pop(2.3, shown));
+    TEST_ASSERT_EQ(shown.data()[0], 2);
+
+    // Frames behind what was already shown are dropped
+    TEST_ASSERT(!push(jitter, 9, 0.04, 2.31));
+    TEST_ASSERT_EQ(jitter.droppedFrames(), 1u);
+    return true;
+}
+
+bool test_LiveJitterBuffer_CatchUp() {
+    LiveJitterBuffer jitter(0.1);
+    jitter.setFramePeriod(0.04);
+    FrameBuffer shown;
+    TEST_ASSERT(push(jitter, 0, 0.0, 10.0));
+    TEST_ASSERT(jitter.pop(10.15, shown));
+
+    // A 300ms stall, then a burst: only the newest due frame is shown
+    for (int i = 1; i <= 8; ++i) {
+        TEST_ASSERT(push(jitter, i, i * 0.04, 10.4));
+    }
+    TEST_ASSERT(jitter.nextDueTime() < 10.4);
+    TEST_ASSERT(jitter.pop(10.4, shown));
+    TEST_ASSERT_EQ(shown.data()[0], 7);  // Frames 1-7 are due, 8 is not
+    TEST_ASSERT_EQ(jitter.droppedFrames(), 6u);
+    TEST_ASSERT_EQ(jitter.depth(), 1u);
+    TEST_ASSERT(jitter.pop(10.44, shown));
+    TEST_ASSERT_EQ(shown.data()[0], 8);
+
+    // Timestamps restart (new stream): pacing restarts instead of dropping everything
+    TEST_ASSERT(push(jitter, 20, 0.0, 12.0));
+    TEST_ASSERT(!jitter.pop(12.05, shown));
+    TEST_ASSERT(jitter.pop(12.15, shown));
+    TEST_ASSERT_EQ(shown.data()[0], 20);
+    return true;
+}
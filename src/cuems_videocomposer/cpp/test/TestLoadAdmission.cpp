@@ -0,0 +1,136 @@
+#include "TestFramework.h"
+#include "../layer/LoadAdmission.h"
+#include <cmath>
+#include <string>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+LoadAdmission::MediaProfile uhdHevc(bool hardware) {
+    LoadAdmission::MediaProfile media;
+    media.codec = "HEVC";
+    media.width = 3840;
+    media.height = 2160;
+    media.framerate = 50.0;
+    media.gopLength = 50;
+    media.hardware = hardware;
+    return media;
+}
+
+bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-6;
+}
+
+} // namespace
+
+bool test_LoadAdmission_Predict() {
+    LoadAdmission admission;
+    LoadAdmission::Settings settings;
+    settings.cpuThreads = 8;
+    settings.outputHz = 60.0;
+    admission.configure(settings);
+    admission.setDecodeCost("HEVC", false, 0.004);
+    admission.setGpuCost(0.0002);
+
+    // 8.29 MP x 4 ms/MP = 33 ms a frame, 50 fps on 8 threads
+    LoadAdmission::MediaProfile media = uhdHevc(false);
+    LoadAdmission::Load load = admission.predict(media);
+    double frameSeconds = 3840.0 * 2160.0 / 1e6 * 0.004;
+    TEST_ASSERT_TRUE(near(load.cpu, 50.0 * frameSeconds / 8.0));
+    TEST_ASSERT_TRUE(near(load.hardware, 0.0));
+    TEST_ASSERT_TRUE(near(load.gpu, 60.0 * 3840.0 * 2160.0 / 1e6 * 0.0002));
+    TEST_ASSERT_TRUE(near(load.seekSeconds, 50.0 * frameSeconds));
+
+    // Peaks above the reference bitrate cost more; hardware decode is its own resource
+    media.peakBitrate = static_cast<int64_t>(0.6 * 3840 * 2160 * 50);
+    TEST_ASSERT_TRUE(near(admission.predict(media).cpu, 2.0 * load.cpu));
+    LoadAdmission::Load hardware = admission.predict(uhdHevc(true));
+    TEST_ASSERT_TRUE(near(hardware.cpu, 0.0));
+    TEST_ASSERT_TRUE(hardware.hardware > 0.0);
+    return true;
+}
+
+bool test_LoadAdmission_Benchmark() {
+    LoadAdmission admission;
+    std::string lines =
+        "{\"file\":\"a.mov\",\"codec\":\"HEVC\",\"width\":1920,\"height\":1080,\"framerate\":25,"
+        "\"backend\":\"software\",\"status\":\"ok\",\"frames\":600,\"fps\":100,\"latency_ms\":{\"p50\":9.8}}\n"
+        "{\"file\":\"b.mov\",\"codec\":\"HEVC\",\"width\":3840,\"height\":2160,\"framerate\":25,"
+        "\"backend\":\"vaapi-zerocopy\",\"status\":\"ok\",\"frames\":600,\"fps\":200}\n"
+        "{\"file\":\"b.mov\",\"codec\":\"HEVC\",\"width\":3840,\"height\":2160,\"framerate\":25,"
+        "\"backend\":\"vaapi-readback\",\"status\":\"ok\",\"frames\":600,\"fps\":100}\n"
+        "{\"file\":\"c.mov\",\"codec\":\"AV1\",\"width\":1920,\"height\":1080,\"framerate\":25,"
+        "\"backend\":\"vaapi-zerocopy\",\"status\":\"unavailable\",\"error\":\"no device\"}\n"
+        "{\"layers\":4,\"resolution\":\"1920x1080\",\"blend\":\"normal\",\"animated\":true,\"frames\":300,"
+        "\"fps\":250,\"gpu_ms\":{\"avg\":4.0,\"max\":5.0}}\n"
+        "{\"layers\":8,\"resolution\":\"1920x1080\",\"animated\":false,\"gpu_ms\":{\"avg\":20.0,\"max\":25.0}}\n"
+        "not json\n";
+    TEST_ASSERT_EQ(admission.loadBenchmarkLines(lines), 5);
+
+    const double hd = 1920.0 * 1080.0 / 1e6;
+    const double uhd = 3840.0 * 2160.0 / 1e6;
+    TEST_ASSERT_TRUE(near(admission.getDecodeCost("HEVC", false), 1.0 / (100.0 * hd)));
+    TEST_ASSERT_TRUE(near(admission.getDecodeCost("HEVC", true), 1.0 / (200.0 * uhd)));  // Fastest path
+    // Animated scenes (uploads every frame) win over a heavier static one
+    TEST_ASSERT_TRUE(near(admission.getGpuCost(), 0.004 / (4.0 * hd)));
+    // Not measured: defaults stay
+    TEST_ASSERT_TRUE(admission.getDecodeCost("AV1", false) > 0.0);
+    return true;
+}
+
+bool test_LoadAdmission_Policies() {
+    LoadAdmission::Settings settings;
+    settings.cpuThreads = 4;
+    settings.headroom = 0.9;
+    settings.outputHz = 60.0;
+
+    auto build = [&settings](LoadAdmission::Policy policy) {
+        LoadAdmission admission;
+        settings.policy = policy;
+        admission.configure(settings);
+        admission.setDecodeCost("HEVC", false, 0.004);  // ~41% of 4 threads for one 4K50 layer
+        admission.setGpuCost(0.0001);
+        return admission;
+    };
+
+    // Two layers fit, a third does not
+    LoadAdmission warn = build(LoadAdmission::Policy::WARN);
+    TEST_ASSERT(warn.admit("a", uhdHevc(false)).verdict == LoadAdmission::Verdict::ACCEPT);
+    TEST_ASSERT(warn.admit("b", uhdHevc(false)).verdict == LoadAdmission::Verdict::ACCEPT);
+    LoadAdmission::Decision third = warn.admit("c", uhdHevc(false));
+    TEST_ASSERT(third.verdict == LoadAdmission::Verdict::WARN);
+    TEST_ASSERT_TRUE(third.total.cpu > 0.9);
+    TEST_ASSERT_TRUE(third.reason.find("cpu decode") != std::string::npos);
+    TEST_ASSERT_EQ(static_cast<int>(warn.getAdmittedCount()), 3);
+
+    // Reloading a cue replaces its share; released cues free theirs
+    TEST_ASSERT(warn.admit("c", uhdHevc(true)).verdict == LoadAdmission::Verdict::ACCEPT);
+    warn.prune([](const std::string& cueId) { return cueId != "b"; });
+    TEST_ASSERT_EQ(static_cast<int>(warn.getAdmittedCount()), 2);
+
+    LoadAdmission reject = build(LoadAdmission::Policy::REJECT);
+    reject.admit("a", uhdHevc(false));
+    reject.admit("b", uhdHevc(false));
+    TEST_ASSERT(reject.admit("c", uhdHevc(false)).verdict == LoadAdmission::Verdict::REJECT);
+    TEST_ASSERT_EQ(static_cast<int>(reject.getAdmittedCount()), 2);
+    reject.release("a");
+    TEST_ASSERT(reject.admit("c", uhdHevc(false)).verdict == LoadAdmission::Verdict::ACCEPT);
+
+    // Degraded to half rate: the third layer costs half its decode
+    LoadAdmission degrade = build(LoadAdmission::Policy::DEGRADE);
+    LoadAdmission::Load full = degrade.admit("a", uhdHevc(false)).cue;
+    degrade.admit("b", uhdHevc(false));
+    LoadAdmission::Decision half = degrade.admit("c", uhdHevc(false));
+    TEST_ASSERT(half.verdict == LoadAdmission::Verdict::DEGRADE);
+    TEST_ASSERT_TRUE(near(half.cue.cpu, full.cpu / 2.0));
+    TEST_ASSERT_TRUE(near(degrade.getTotal().cpu, 2.5 * full.cpu));
+
+    LoadAdmission off = build(LoadAdmission::Policy::OFF);
+    for (const char* cue : {"a", "b", "c", "d"}) {
+        TEST_ASSERT(off.admit(cue, uhdHevc(false)).verdict == LoadAdmission::Verdict::ACCEPT);
+    }
+    TEST_ASSERT_EQ(static_cast<int>(off.getAdmittedCount()), 0);
+    return true;
+}
@@ -0,0 +1,115 @@
+#include "TestFramework.h"
+#include "../remote/LocalControlRing.h"
+#include <cstring>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Backing memory for a ring, 8-byte aligned like a mapping
+struct RingMemory {
+    explicit RingMemory(uint32_t capacity)
+        : words((LocalControlRing::sizeFor(capacity) + 7) / 8, 0) {
+        LocalControlRing::initialize(data(), size(), capacity);
+    }
+    void* data() { return words.data(); }
+    size_t size() { return words.size() * 8; }
+    uint8_t* bytes() { return reinterpret_cast<uint8_t*>(words.data()) + ctl::DATA_OFFSET; }
+    ctl::RingHeader* header() { return reinterpret_cast<ctl::RingHeader*>(words.data()); }
+    std::vector<uint64_t> words;
+};
+
+} // namespace
+
+bool test_LocalControlRing_RoundTripAndWrap() {
+    RingMemory memory(4096);
+    LocalControlRing writer;
+    LocalControlRing reader;
+    TEST_ASSERT_TRUE(writer.attach(memory.data(), memory.size()));
+    TEST_ASSERT_TRUE(reader.attach(memory.data(), memory.size()));
+
+    LocalControlRing::Command command;
+    TEST_ASSERT_FALSE(reader.pop(command));
+
+    CommandArgs args;
+    args.addInt(-7);
+    args.addInt64(1LL << 40);
+    args.addFloat(0.5f);
+    args.addDouble(2.25);
+    args.addString("video.mp4");
+    TEST_ASSERT_TRUE(writer.push("/videocomposer/layer/load", args, false, 1234));
+    TEST_ASSERT_TRUE(reader.pop(command));
+    TEST_ASSERT_EQ(command.path, std::string("/videocomposer/layer/load"));
+    TEST_ASSERT_EQ(command.args.size(), static_cast<size_t>(5));
+    TEST_ASSERT_EQ(command.args[0].toInt(), -7);
+    TEST_ASSERT_EQ(command.args[1].toInt64(), static_cast<int64_t>(1LL << 40));
+    TEST_ASSERT_EQ(command.args[2].toFloat(), 0.5f);
+    TEST_ASSERT_EQ(command.args[3].toDouble(), 2.25);
+    TEST_ASSERT_TRUE(command.args[4] == "video.mp4");
+    TEST_ASSERT_EQ(command.atUs, static_cast<int64_t>(1234));
+    TEST_ASSERT_FALSE(command.bundleContinues);
+
+    // Enough traffic to wrap several times; records never straddle the end
+    CommandArgs one;
+    one.addString(std::string(100, 'x'));
+    for (int i = 0; i < 200; ++i) {
+        TEST_ASSERT_TRUE(writer.push("/videocomposer/layer/opacity", one));
+        TEST_ASSERT_TRUE(reader.pop(command));
+        TEST_ASSERT_EQ(command.args[0].length(), static_cast<size_t>(100));
+    }
+    TEST_ASSERT_FALSE(reader.pop(command));
+    TEST_ASSERT_EQ(reader.getMalformed(), static_cast<uint64_t>(0));
+    return true;
+}
+
+bool test_LocalControlRing_FullAndMalformed() {
+    RingMemory memory(4096);
+    LocalControlRing ring;
+    TEST_ASSERT_TRUE(ring.attach(memory.data(), memory.size()));
+
+    // Fill it: the command that does not fit is counted, the queued ones stay
+    CommandArgs args;
+    args.addString(std::string(200, 'y'));
+    int pushed = 0;
+    while (ring.push("/videocomposer/layer/load", args, pushed % 2 == 0)) {
+        pushed++;
+    }
+    TEST_ASSERT_TRUE(pushed > 0);
+    TEST_ASSERT_EQ(ring.getDropped(), static_cast<uint64_t>(1));
+    LocalControlRing::Command command;
+    for (int i = 0; i < pushed; ++i) {
+        TEST_ASSERT_TRUE(ring.pop(command));
+        TEST_ASSERT_EQ(command.bundleContinues, i % 2 == 0);
+    }
+    TEST_ASSERT_FALSE(ring.pop(command));
+
+    // A record claiming more than the ring holds: everything queued is dropped
+    TEST_ASSERT_TRUE(ring.push("/videocomposer/layer/a", CommandArgs()));
+    TEST_ASSERT_TRUE(ring.push("/videocomposer/layer/b", CommandArgs()));
+    uint64_t tail = memory.header()->tail.load();
+    uint32_t bogus = 1u << 20;
+    std::memcpy(memory.bytes() + (tail & 4095), &bogus, sizeof(bogus));
+    TEST_ASSERT_FALSE(ring.pop(command));
+    TEST_ASSERT_EQ(ring.getMalformed(), static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(memory.header()->tail.load(), memory.header()->head.load());
+
+    // An unknown argument type is malformed too; the ring keeps working after it
+    CommandArgs number;
+    number.addInt(3);
+    TEST_ASSERT_TRUE(ring.push("/videocomposer/layer/c", number));
+    tail = memory.header()->tail.load();
+    memory.bytes()[(tail & 4095) + sizeof(ctl::RecordHeader) + std::strlen("/videocomposer/layer/c")] = 'q';
+    TEST_ASSERT_FALSE(ring.pop(command));
+    TEST_ASSERT_EQ(ring.getMalformed(), static_cast<uint64_t>(2));
+    TEST_ASSERT_TRUE(ring.push("/videocomposer/layer/c", number));
+    TEST_ASSERT_TRUE(ring.pop(command));
+    TEST_ASSERT_EQ(command.args[0].toInt(), 3);
+
+    // Not a ring
+    std::vector<uint64_t> zeros(1024, 0);
+    TEST_ASSERT_FALSE(ring.attach(zeros.data(), zeros.size() * 8));
+    TEST_ASSERT_FALSE(LocalControlRing::initialize(zeros.data(), zeros.size() * 8, 3000));
+    return true;
+}
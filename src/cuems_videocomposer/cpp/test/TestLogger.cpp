@@ -0,0 +1,113 @@
+#include "TestFramework.h"
+#include "../utils/Logger.h"
+#include "../utils/LogRing.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_LogRing_Basics() {
+    LogRing ring(4);
+    TEST_ASSERT_EQ(ring.capacity(), static_cast<size_t>(4));
+
+    LogRing::Record record;
+    TEST_ASSERT_FALSE(ring.pop(record));
+
+    TEST_ASSERT_TRUE(ring.push(Logger::INFO, "one", 3));
+    TEST_ASSERT_TRUE(ring.push(Logger::ERROR, "two", 3));
+    TEST_ASSERT_TRUE(ring.pop(record));
+    TEST_ASSERT_EQ(record.level, static_cast<int>(Logger::INFO));
+    TEST_ASSERT_EQ(std::string(record.text, record.length), std::string("one"));
+
+    // Full ring drops and counts; the queued records are untouched
+    TEST_ASSERT_TRUE(ring.push(Logger::INFO, "3", 1));
+    TEST_ASSERT_TRUE(ring.push(Logger::INFO, "4", 1));
+    TEST_ASSERT_TRUE(ring.push(Logger::INFO, "5", 1));
+    TEST_ASSERT_FALSE(ring.push(Logger::INFO, "6", 1));
+    TEST_ASSERT_EQ(ring.takeDropped(), static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(ring.takeDropped(), static_cast<uint64_t>(0));
+    TEST_ASSERT_TRUE(ring.pop(record));
+    TEST_ASSERT_EQ(std::string(record.text, record.length), std::string("two"));
+
+    // Long texts are cut to a slot
+    std::string longText(LogRing::TEXT_SIZE + 10, 'x');
+    while (ring.pop(record)) {}
+    TEST_ASSERT_TRUE(ring.push(Logger::INFO, longText.data(), longText.size()));
+    TEST_ASSERT_TRUE(ring.pop(record));
+    TEST_ASSERT_TRUE(record.truncated);
+    TEST_ASSERT_EQ(static_cast<size_t>(record.length), LogRing::TEXT_SIZE);
+    TEST_ASSERT_EQ(ring.readPosition(), ring.writePosition());
+    return true;
+}
+
+bool test_LogRing_MultiProducer() {
+    const int producers = 4;
+    const int perProducer = 2000;
+    LogRing ring(256);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p]() {
+            for (int i = 0; i < perProducer; ++i) {
+                std::string text = std::to_string(p) + ":" + std::to_string(i);
+                while (!ring.push(Logger::DEBUG, text.data(), text.size())) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Every record arrives once, each producer's in order
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    bool ordered = true;
+    LogRing::Record record;
+    while (received < producers * perProducer) {
+        if (!ring.pop(record)) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::string text(record.text, record.length);
+        size_t colon = text.find(':');
+        int p = std::stoi(text.substr(0, colon));
+        int i = std::stoi(text.substr(colon + 1));
+        if (next[p] != i) {
+            ordered = false;
+        }
+        next[p] = i + 1;
+        ++received;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ring.takeDropped();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_FALSE(ring.pop(record));
+    return true;
+}
+
+bool test_LogRateLimit_PerSite() {
+    LogRateLimit site;
+    TEST_ASSERT_TRUE(site.allow(60000));
+    TEST_ASSERT_FALSE(site.allow(60000));
+    TEST_ASSERT_FALSE(site.allow(60000));
+    TEST_ASSERT_EQ(site.takeSuppressed(), static_cast<uint32_t>(2));
+    TEST_ASSERT_EQ(site.takeSuppressed(), static_cast<uint32_t>(0));
+
+    // Another site has its own budget
+    LogRateLimit other;
+    TEST_ASSERT_TRUE(other.allow(60000));
+
+    // Filtered levels don't evaluate their arguments
+    Logger::Level saved = Logger::getInstance().getLevel();
+    Logger::getInstance().setLevel(Logger::WARNING);
+    int evaluated = 0;
+    LOG_DEBUG << ++evaluated;
+    LOG_VERBOSE_EVERY(1000) << ++evaluated;
+    Logger::getInstance().setLevel(saved);
+    TEST_ASSERT_EQ(evaluated, 0);
+    return true;
+}
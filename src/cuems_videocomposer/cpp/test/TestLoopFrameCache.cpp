@@ -0,0 +1,105 @@
+#include "TestFramework.h"
+#include "../video/LoopFrameCache.h"
+#include <memory>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Bookkeeping only: frames without textures
+std::shared_ptr<const GPUTextureFrameBuffer> frame() {
+    return std::make_shared<GPUTextureFrameBuffer>();
+}
+
+} // namespace
+
+bool test_LoopFrameCache_FillsAndServes() {
+    LoopFrameCache::Mode mode;
+    TEST_ASSERT_TRUE(LoopFrameCache::parseMode("compressed", mode));
+    TEST_ASSERT_TRUE(mode == LoopFrameCache::Mode::COMPRESSED);
+    TEST_ASSERT_FALSE(LoopFrameCache::parseMode("bc7", mode));
+
+    LoopFrameCache cache(3);
+    int source = 0;
+    cache.setLoop(&source, 10, 14);
+    TEST_ASSERT_FALSE(cache.wants(10));   // Off
+    cache.setMode(LoopFrameCache::Mode::UNCOMPRESSED);
+    TEST_ASSERT_TRUE(cache.wants(10));
+    TEST_ASSERT_FALSE(cache.wants(14));   // Past the loop
+
+    // The first pass may start anywhere in the loop
+    TEST_ASSERT_TRUE(cache.store(12, frame(), 100));
+    TEST_ASSERT_TRUE(cache.store(13, frame(), 100));
+    TEST_ASSERT_FALSE(cache.store(13, frame(), 100));
+    TEST_ASSERT_TRUE(cache.store(10, frame(), 100));
+    TEST_ASSERT_FALSE(cache.isComplete());
+    TEST_ASSERT_TRUE(cache.find(10) == nullptr);   // Served once complete only
+    TEST_ASSERT_TRUE(cache.store(11, frame(), 100));
+    TEST_ASSERT_TRUE(cache.isComplete());
+    TEST_ASSERT_FALSE(cache.wants(11));
+    TEST_ASSERT_TRUE(cache.has(13));
+    std::shared_ptr<const GPUTextureFrameBuffer> shown = cache.find(13);
+    TEST_ASSERT_TRUE(shown != nullptr);
+
+    LoopFrameCache::Stats stats = cache.getStats();
+    TEST_ASSERT_EQ(stats.frames, 4);
+    TEST_ASSERT_EQ(stats.loopFrames, 4);
+    TEST_ASSERT_EQ(stats.bytes, 400u);
+    TEST_ASSERT_EQ(stats.hits, 1u);
+
+    // Evicted whole; the frame on screen is still held by its user
+    TEST_ASSERT_EQ(cache.evict(1), 400u);
+    TEST_ASSERT_FALSE(cache.isComplete());
+    TEST_ASSERT_FALSE(cache.wants(10));
+    TEST_ASSERT_EQ(shown.use_count(), 1);
+
+    // Another loop fills again
+    cache.setLoop(&source, 0, 2);
+    TEST_ASSERT_TRUE(cache.wants(0));
+    cache.setLoop(nullptr, 0, 0);
+    TEST_ASSERT_FALSE(cache.wants(0));
+    return true;
+}
+
+bool test_LoopFrameCache_GivesUp() {
+    LoopFrameCache cache(4);
+    int source = 0;
+    cache.setMode(LoopFrameCache::Mode::UNCOMPRESSED);
+
+    // Frames skipped on every pass: given up after MAX_PASSES wraps
+    cache.setLoop(&source, 0, 4);
+    TEST_ASSERT_TRUE(cache.store(0, frame(), 10));
+    TEST_ASSERT_TRUE(cache.store(2, frame(), 10));
+    TEST_ASSERT_TRUE(cache.store(1, frame(), 10));   // Wrap 1
+    TEST_ASSERT_FALSE(cache.store(0, frame(), 10));   // Already in
+    TEST_ASSERT_FALSE(cache.wants(2));
+    TEST_ASSERT_TRUE(cache.wants(3));
+    cache.setLoop(&source, 0, 4);   // Unchanged: kept
+    TEST_ASSERT_EQ(cache.getStats().frames, 3);
+    TEST_ASSERT_TRUE(cache.store(3, frame(), 10));
+    TEST_ASSERT_TRUE(cache.isComplete());
+
+    cache.setLoop(&source, 0, 6);
+    TEST_ASSERT_TRUE(cache.store(4, frame(), 10));
+    TEST_ASSERT_TRUE(cache.store(1, frame(), 10));   // Wrap 1
+    TEST_ASSERT_TRUE(cache.store(5, frame(), 10));
+    TEST_ASSERT_FALSE(cache.store(0, frame(), 10));  // Wrap 2: given up
+    TEST_ASSERT_TRUE(cache.getStats().abandoned);
+    TEST_ASSERT_EQ(cache.getStats().frames, 0);
+    TEST_ASSERT_FALSE(cache.wants(2));
+
+    // Too long to keep
+    cache.setLoop(&source, 0, LoopFrameCache::MAX_FRAMES + 1);
+    TEST_ASSERT_FALSE(cache.wants(0));
+
+    // The renderer gives up on what it cannot copy
+    cache.setLoop(&source, 0, 2);
+    TEST_ASSERT_TRUE(cache.wants(0));
+    cache.abandon("pixel format");
+    TEST_ASSERT_FALSE(cache.wants(0));
+    cache.setMode(LoopFrameCache::Mode::OFF);
+    cache.setMode(LoopFrameCache::Mode::COMPRESSED);
+    TEST_ASSERT_TRUE(cache.wants(0));
+    return true;
+}
@@ -1,4 +1,6 @@
 #include "TestFramework.h"
+#include "PerfBaseline.h"
+#include <string>
 
 // Forward declarations of test functions
 extern bool test_LayerManager_AddLayer();
@@ -6,6 +8,8 @@ extern bool test_LayerManager_RemoveLayer();
 extern bool test_LayerManager_ZOrder();
 extern bool test_LayerManager_DuplicateLayer();
 extern bool test_LayerManager_Reorder();
+extern bool test_LayerManager_Snapshot();
+extern bool test_LayerManager_Groups();
 
 extern bool test_VideoLayer_PlayPause();
 extern bool test_VideoLayer_Seek();
@@ -14,6 +18,11 @@ extern bool test_VideoLayer_TimeScale();
 extern bool test_VideoLayer_Wraparound();
 extern bool test_VideoLayer_Reverse();
 extern bool test_VideoLayer_SyncUpdate();
+extern bool test_VideoLayer_StaticFrame();
+extern bool test_VideoLayer_Arm();
+extern bool test_VideoLayer_HotSwap();
+extern bool test_VideoLayer_SeekAsync();
+extern bool test_VideoLayer_LateLatch();
 
 extern bool test_ConfigurationManager_Defaults();
 extern bool test_ConfigurationManager_SetGet();
@@ -26,15 +35,226 @@ extern bool test_Integration_LayerProperties();
 
 extern bool test_MTCDecoder();
 
+extern bool test_FramePool_AcquireRelease();
+extern bool test_FramePool_Budget();
+extern bool test_FramePool_NoAllocationPerFrame();
+
+extern bool test_MappedFrameRing_AcquireRelease();
+extern bool test_MappedFrameRing_ForcedDetach();
+
+extern bool test_FrameIndexCache_RoundTrip();
+extern bool test_FrameIndexCache_Invalidation();
+extern bool test_FrameIndexCache_Probe();
+extern bool test_ContainerIndex_Samples();
+extern bool test_ContainerIndex_SamplesNeedKeyframe();
+extern bool test_ContainerIndex_Keyframes();
+extern bool test_ContainerIndex_KeyframesTooSparse();
+
+extern bool test_LayerUpdateScheduler_RunsAllJobs();
+extern bool test_LayerUpdateScheduler_Deadline();
+extern bool test_HapChunkPool_RunsAllChunks();
+extern bool test_HapChunkPool_Reconfigure();
+extern bool test_HapChunkPool_NestedBatches();
+extern bool test_MovSampleTable_Index();
+extern bool test_MovSampleTable_Rejects();
+extern bool test_ReverseFrameRing_Plan();
+extern bool test_ReverseFrameRing_Store();
+extern bool test_SpscFrameRing_PushFindDrop();
+extern bool test_SpscFrameRing_Epochs();
+extern bool test_SpscFrameRing_Threaded();
+extern bool test_DecodeJitterTracker_Depth();
+extern bool test_DecodeAheadBudget_Share();
+extern bool test_DecodeThreadBudget_Share();
+extern bool test_DecodeScheduler_Deadline();
+extern bool test_DecodeScheduler_EarliestDeadlineFirst();
+extern bool test_DecodeScheduler_Background();
+extern bool test_VideoShaders_Specialize();
+extern bool test_ProgramBinaryCache_RoundTrip();
+extern bool test_PresentationTiming_PredictNextVsync();
+extern bool test_TimecodeClock_Jitter();
+extern bool test_TimecodeClock_Locate();
+extern bool test_FrameLock_FollowerMatchesTimeline();
+extern bool test_FramerateConverter_DropFrameToFilm();
+extern bool test_FramerateConverter_Hysteresis();
+extern bool test_FrameClock_OneSamplePerRender();
+extern bool test_FrameClock_SourceChanges();
+extern bool test_FrameClock_SameFrameForOneVsync();
+extern bool test_VblankClock_Cadence();
+extern bool test_VblankClock_Transport();
+extern bool test_TransportEventLog_EveryReaderSeesEvents();
+extern bool test_TransportEventLog_KeepsNewest();
+extern bool test_OutputInfo_FindRefreshMultiple();
+extern bool test_PresentationTiming_BufferStats();
+extern bool test_PresentationTiming_FrameLog();
+extern bool test_OutputSinkManager_DropPolicies();
+extern bool test_OutputSinkManager_BlockAndLatency();
+extern bool test_OutputSinkManager_CaptureFormats();
+extern bool test_OutputSinkManager_GpuSinks();
+extern bool test_OutputSinkManager_SharedFrames();
+extern bool test_CaptureConverter_PyramidSizes();
+extern bool test_OutputBlitShader_BlendMask();
+extern bool test_OutputBlitShader_RegionChanges();
+extern bool test_GridWarpMesh_Interpolation();
+extern bool test_GridWarpMesh_AdaptiveMesh();
+extern bool test_GridWarpMesh_LoadFile();
+extern bool test_ColorLut_BakedAdjustment();
+extern bool test_ColorLut_CubeFile();
+extern bool test_CornerWarpCache_Solve();
+extern bool test_CornerWarpCache_Reuse();
+extern bool test_CanvasRegions_Merge();
+extern bool test_CanvasRegions_Intersects();
+extern bool test_CanvasRegions_Scaled();
+extern bool test_HotplugMonitor_Changes();
+extern bool test_HotplugMonitor_Thread();
+extern bool test_HotplugMonitor_Uevent();
+extern bool test_StartupSequence_Order();
+extern bool test_StartupSequence_Failure();
+extern bool test_ShowJournal_RoundTrip();
+extern bool test_ShowJournal_Writer();
+extern bool test_PreviewGrid_Layout();
+extern bool test_PreviewGrid_Pacer();
+extern bool test_SharedMemoryOutput_Ring();
+extern bool test_FileEncoderOutput_ProRes();
+extern bool test_ReadbackRing_PollsOnlySignalled();
+extern bool test_ReadbackRing_WaitAndReconfigure();
+extern bool test_FormatModifiers_ParseInFormats();
+extern bool test_FormatModifiers_RejectsMalformed();
+extern bool test_PlaneAssignment_PictureInPicture();
+extern bool test_PlaneAssignment_CompositedAboveBlocks();
+extern bool test_GLStateCache_SkipsRedundant();
+extern bool test_GLStateCache_Invalidate();
+extern bool test_GLStateCache_Textures();
+extern bool test_DrawOrder_GroupsDisjoint();
+extern bool test_DrawOrder_KeepsOverlapOrder();
+extern bool test_VideoShaders_ForGLES();
+extern bool test_FrameBuffer_SharedWrap();
+extern bool test_FrameBuffer_CopyOnWrite();
+extern bool test_FrameBuffer_AlignedPlanes();
+extern bool test_LiveInputSource_BufferSwap();
+extern bool test_V4L2VideoInput_CopyTight();
+extern bool test_LiveJitterBuffer_Pacing();
+extern bool test_LiveJitterBuffer_CatchUp();
+extern bool test_ImageSequenceInput_Pattern();
+extern bool test_AsyncVideoLoader_Priority();
+extern bool test_SharedMediaRegistry_FramesAndIndex();
+extern bool test_ReadAheadIO_ReadSeek();
+extern bool test_RamClipCache_PreloadAndBudget();
+extern bool test_PageCachePolicy_DropBehindPlayheads();
+extern bool test_MosaicInput_StitchesTiles();
+extern bool test_ProxyMedia_Covers();
+extern bool test_ProxySwitcher_Conditions();
+extern bool test_DecodeGovernor_DegradesByPriority();
+extern bool test_LoadAdmission_Predict();
+extern bool test_LoadAdmission_Benchmark();
+extern bool test_LoadAdmission_Policies();
+extern bool test_HapPrepPlanner_ChunksFollowThreads();
+extern bool test_HapPrepPlanner_FormatAndSnappy();
+extern bool test_RenderNodeManager_LeastLoaded();
+extern bool test_HardwareDeviceCache_Capabilities();
+extern bool test_DecoderContextPool_ReuseByKey();
+extern bool test_DecoderContextPool_Capacity();
+extern bool test_TexturePool_RecyclesAfterFence();
+extern bool test_TexturePool_TrimsOldestOverLimit();
+extern bool test_TexturePool_EvictsRecycledForBudget();
+extern bool test_MemoryBudget_EvictsTiersInOrder();
+extern bool test_MemoryBudget_EnforceEvictsForCharges();
+extern bool test_MemoryBudget_AttributesToLayerScope();
+extern bool test_LoopFrameCache_FillsAndServes();
+extern bool test_LoopFrameCache_GivesUp();
+extern bool test_CommandArgs_TypedValues();
+extern bool test_CommandArgs_ReusesStorage();
+extern bool test_ControlLog_RoundTrip();
+extern bool test_ControlReplay_Timing();
+extern bool test_ControlReplay_Fast();
+extern bool test_ControlCapture_File();
+extern bool test_LocalControlRing_RoundTripAndWrap();
+extern bool test_LocalControlRing_FullAndMalformed();
+extern bool test_CommandTable_Lookup();
+extern bool test_CommandScheduler_FiresOnFrame();
+extern bool test_CommandScheduler_Timetags();
+extern bool test_PropertyAnimator_Fade();
+extern bool test_PropertyAnimator_DirectSetWins();
+extern bool test_LayerPropertyStore_StableSlots();
+extern bool test_GlyphAtlas_PackAndLayout();
+extern bool test_LogRing_Basics();
+extern bool test_LogRing_MultiProducer();
+extern bool test_LogRateLimit_PerSite();
+extern bool test_FrameTracer_ChromeJson();
+extern bool test_FrameTracer_RingsPerThread();
+extern bool test_ThreadRoles_Parse();
+extern bool test_ThreadRoles_ParseRejects();
+extern bool test_GpuTimingStats_RollingWindow();
+extern bool test_IdleDetector_SettlesThenHolds();
+extern bool test_IdleDetector_ActivityAndDisable();
+extern bool test_WakeSignal_KeepsEarlyNotify();
+extern bool test_TelemetryPublisher_Histogram();
+extern bool test_TelemetryPublisher_Publish();
+extern bool test_ClusterReplicator_SendsOnlyChangedLines();
+extern bool test_ClusterReplicator_KeyframeRepairsGaps();
+extern bool test_ClusterReplicator_DropsStaleAndFollowsRestart();
+extern bool test_FrameCode_RoundTrip();
+extern bool test_FieldSelector_Parity();
+extern bool test_FieldSelector_Cadence();
+extern bool test_PackedAlpha_Regions();
+extern bool test_PackedAlpha_AspectAndNames();
+extern bool test_TilePyramid_Levels();
+extern bool test_TilePyramid_Select();
+extern bool test_TileResidency_Lru();
+extern bool test_TiledImage_BuildAndMap();
+extern bool test_TiledImage_AlphaWeightedLevels();
+extern bool test_ThumbnailService_FitSize();
+extern bool test_ThumbnailService_CachePath();
+extern bool test_ThumbnailService_Requests();
+extern bool test_AdvancedBlend_ChoosePath();
+extern bool test_AdvancedBlend_LayerBounds();
+extern bool test_AdvancedBlend_Shaders();
+extern bool test_EffectChain_Plan();
+extern bool test_EffectChain_TargetPool();
+extern bool test_TestPatternInput_Strips();
+extern bool test_SyncLatencyMonitor_Cadence();
+extern bool test_SyncLatencyMonitor_Latency();
+extern bool test_FrameArena_ResetAndCoalesce();
+extern bool test_FrameArena_Containers();
+extern bool test_CPUImageKernels_IsaParity();
+extern bool test_CPUImageKernels_ExactCases();
+extern bool test_CPUImageKernels_Tiles();
+extern bool test_CPUImageKernels_WindowedFrames();
+extern bool test_SoftwareCompositor_BlendParity();
+extern bool test_SoftwareCompositor_BlendModes();
+extern bool test_SoftwareCompositor_Placement();
+extern bool test_SoftwareCompositor_Composite();
+extern bool test_SoftwareCompositor_ColorTable();
+extern bool test_SliceScaler_PlanSlices();
+extern bool test_SliceScaler_MatchesOneContext();
+extern bool test_NDIDirectory_Updates();
+extern bool test_NDIDirectory_WaitFor();
+extern bool test_NDIBandwidthPolicy_Switching();
+extern bool test_PlayoutSchedule_Slots();
+extern bool test_PinnedBufferPool_Reuse();
+extern bool test_DynamicResolution_Hysteresis();
+extern bool test_FlightRecorder_Snapshot();
+
+// Performance tests (--perf)
+extern bool test_Perf_MTCDecoder();
+extern bool test_Perf_LayerManager();
+extern bool test_Perf_FrameBuffer();
+extern bool test_Perf_OSCDispatch();
+extern bool test_Perf_FramerateConverter();
+extern bool test_Perf_CPUImageProcessor();
+
 using namespace videocomposer::test;
 
-int main() {
+int main(int argc, char** argv) {
+    bool perf = argc > 1 && std::string(argv[1]) == "--perf";
+
     // Register all tests
     TestFramework::instance().addTest("LayerManager_AddLayer", test_LayerManager_AddLayer);
     TestFramework::instance().addTest("LayerManager_RemoveLayer", test_LayerManager_RemoveLayer);
     TestFramework::instance().addTest("LayerManager_ZOrder", test_LayerManager_ZOrder);
     TestFramework::instance().addTest("LayerManager_DuplicateLayer", test_LayerManager_DuplicateLayer);
     TestFramework::instance().addTest("LayerManager_Reorder", test_LayerManager_Reorder);
+    TestFramework::instance().addTest("LayerManager_Snapshot", test_LayerManager_Snapshot);
+    TestFramework::instance().addTest("LayerManager_Groups", test_LayerManager_Groups);
     
     TestFramework::instance().addTest("VideoLayer_PlayPause", test_VideoLayer_PlayPause);
     TestFramework::instance().addTest("VideoLayer_Seek", test_VideoLayer_Seek);
@@ -43,6 +263,11 @@ int main() {
     TestFramework::instance().addTest("VideoLayer_Wraparound", test_VideoLayer_Wraparound);
     TestFramework::instance().addTest("VideoLayer_Reverse", test_VideoLayer_Reverse);
     TestFramework::instance().addTest("VideoLayer_SyncUpdate", test_VideoLayer_SyncUpdate);
+    TestFramework::instance().addTest("VideoLayer_StaticFrame", test_VideoLayer_StaticFrame);
+    TestFramework::instance().addTest("VideoLayer_Arm", test_VideoLayer_Arm);
+    TestFramework::instance().addTest("VideoLayer_HotSwap", test_VideoLayer_HotSwap);
+    TestFramework::instance().addTest("VideoLayer_SeekAsync", test_VideoLayer_SeekAsync);
+    TestFramework::instance().addTest("VideoLayer_LateLatch", test_VideoLayer_LateLatch);
     
     TestFramework::instance().addTest("ConfigurationManager_Defaults", test_ConfigurationManager_Defaults);
     TestFramework::instance().addTest("ConfigurationManager_SetGet", test_ConfigurationManager_SetGet);
@@ -55,6 +280,216 @@ int main() {
     
     TestFramework::instance().addTest("MTCDecoder", test_MTCDecoder);
     
-    return TestFramework::instance().runAll();
+    TestFramework::instance().addTest("FramePool_AcquireRelease", test_FramePool_AcquireRelease);
+    TestFramework::instance().addTest("FramePool_Budget", test_FramePool_Budget);
+    TestFramework::instance().addTest("FramePool_NoAllocationPerFrame", test_FramePool_NoAllocationPerFrame);
+    
+    TestFramework::instance().addTest("MappedFrameRing_AcquireRelease", test_MappedFrameRing_AcquireRelease);
+    TestFramework::instance().addTest("MappedFrameRing_ForcedDetach", test_MappedFrameRing_ForcedDetach);
+    
+    TestFramework::instance().addTest("FrameIndexCache_RoundTrip", test_FrameIndexCache_RoundTrip);
+    TestFramework::instance().addTest("FrameIndexCache_Invalidation", test_FrameIndexCache_Invalidation);
+    TestFramework::instance().addTest("FrameIndexCache_Probe", test_FrameIndexCache_Probe);
+    TestFramework::instance().addTest("ContainerIndex_Samples", test_ContainerIndex_Samples);
+    TestFramework::instance().addTest("ContainerIndex_SamplesNeedKeyframe", test_ContainerIndex_SamplesNeedKeyframe);
+    TestFramework::instance().addTest("ContainerIndex_Keyframes", test_ContainerIndex_Keyframes);
+    TestFramework::instance().addTest("ContainerIndex_KeyframesTooSparse", test_ContainerIndex_KeyframesTooSparse);
+    
+    TestFramework::instance().addTest("LayerUpdateScheduler_RunsAllJobs", test_LayerUpdateScheduler_RunsAllJobs);
+    TestFramework::instance().addTest("LayerUpdateScheduler_Deadline", test_LayerUpdateScheduler_Deadline);
+    TestFramework::instance().addTest("HapChunkPool_RunsAllChunks", test_HapChunkPool_RunsAllChunks);
+    TestFramework::instance().addTest("HapChunkPool_Reconfigure", test_HapChunkPool_Reconfigure);
+    TestFramework::instance().addTest("HapChunkPool_NestedBatches", test_HapChunkPool_NestedBatches);
+    TestFramework::instance().addTest("MovSampleTable_Index", test_MovSampleTable_Index);
+    TestFramework::instance().addTest("MovSampleTable_Rejects", test_MovSampleTable_Rejects);
+    TestFramework::instance().addTest("ReverseFrameRing_Plan", test_ReverseFrameRing_Plan);
+    TestFramework::instance().addTest("ReverseFrameRing_Store", test_ReverseFrameRing_Store);
+    TestFramework::instance().addTest("SpscFrameRing_PushFindDrop", test_SpscFrameRing_PushFindDrop);
+    TestFramework::instance().addTest("SpscFrameRing_Epochs", test_SpscFrameRing_Epochs);
+    TestFramework::instance().addTest("SpscFrameRing_Threaded", test_SpscFrameRing_Threaded);
+    TestFramework::instance().addTest("DecodeJitterTracker_Depth", test_DecodeJitterTracker_Depth);
+    TestFramework::instance().addTest("DecodeAheadBudget_Share", test_DecodeAheadBudget_Share);
+    TestFramework::instance().addTest("DecodeThreadBudget_Share", test_DecodeThreadBudget_Share);
+    TestFramework::instance().addTest("DecodeScheduler_Deadline", test_DecodeScheduler_Deadline);
+    TestFramework::instance().addTest("DecodeScheduler_EarliestDeadlineFirst", test_DecodeScheduler_EarliestDeadlineFirst);
+    TestFramework::instance().addTest("DecodeScheduler_Background", test_DecodeScheduler_Background);
+    TestFramework::instance().addTest("VideoShaders_Specialize", test_VideoShaders_Specialize);
+    TestFramework::instance().addTest("ProgramBinaryCache_RoundTrip", test_ProgramBinaryCache_RoundTrip);
+    TestFramework::instance().addTest("PresentationTiming_PredictNextVsync", test_PresentationTiming_PredictNextVsync);
+    TestFramework::instance().addTest("TimecodeClock_Jitter", test_TimecodeClock_Jitter);
+    TestFramework::instance().addTest("TimecodeClock_Locate", test_TimecodeClock_Locate);
+    TestFramework::instance().addTest("FrameLock_FollowerMatchesTimeline", test_FrameLock_FollowerMatchesTimeline);
+    TestFramework::instance().addTest("FramerateConverter_DropFrameToFilm", test_FramerateConverter_DropFrameToFilm);
+    TestFramework::instance().addTest("FramerateConverter_Hysteresis", test_FramerateConverter_Hysteresis);
+    TestFramework::instance().addTest("FrameClock_OneSamplePerRender", test_FrameClock_OneSamplePerRender);
+    TestFramework::instance().addTest("FrameClock_SourceChanges", test_FrameClock_SourceChanges);
+    TestFramework::instance().addTest("FrameClock_SameFrameForOneVsync", test_FrameClock_SameFrameForOneVsync);
+    TestFramework::instance().addTest("VblankClock_Cadence", test_VblankClock_Cadence);
+    TestFramework::instance().addTest("VblankClock_Transport", test_VblankClock_Transport);
+    TestFramework::instance().addTest("TransportEventLog_EveryReaderSeesEvents", test_TransportEventLog_EveryReaderSeesEvents);
+    TestFramework::instance().addTest("TransportEventLog_KeepsNewest", test_TransportEventLog_KeepsNewest);
+    TestFramework::instance().addTest("OutputInfo_FindRefreshMultiple", test_OutputInfo_FindRefreshMultiple);
+    TestFramework::instance().addTest("PresentationTiming_BufferStats", test_PresentationTiming_BufferStats);
+    TestFramework::instance().addTest("PresentationTiming_FrameLog", test_PresentationTiming_FrameLog);
+    TestFramework::instance().addTest("OutputSinkManager_DropPolicies", test_OutputSinkManager_DropPolicies);
+    TestFramework::instance().addTest("OutputSinkManager_BlockAndLatency", test_OutputSinkManager_BlockAndLatency);
+    TestFramework::instance().addTest("OutputSinkManager_CaptureFormats", test_OutputSinkManager_CaptureFormats);
+    TestFramework::instance().addTest("OutputSinkManager_GpuSinks", test_OutputSinkManager_GpuSinks);
+    TestFramework::instance().addTest("OutputSinkManager_SharedFrames", test_OutputSinkManager_SharedFrames);
+    TestFramework::instance().addTest("CaptureConverter_PyramidSizes", test_CaptureConverter_PyramidSizes);
+    TestFramework::instance().addTest("OutputBlitShader_BlendMask", test_OutputBlitShader_BlendMask);
+    TestFramework::instance().addTest("OutputBlitShader_RegionChanges", test_OutputBlitShader_RegionChanges);
+    TestFramework::instance().addTest("GridWarpMesh_Interpolation", test_GridWarpMesh_Interpolation);
+    TestFramework::instance().addTest("GridWarpMesh_AdaptiveMesh", test_GridWarpMesh_AdaptiveMesh);
+    TestFramework::instance().addTest("GridWarpMesh_LoadFile", test_GridWarpMesh_LoadFile);
+    TestFramework::instance().addTest("ColorLut_BakedAdjustment", test_ColorLut_BakedAdjustment);
+    TestFramework::instance().addTest("ColorLut_CubeFile", test_ColorLut_CubeFile);
+    TestFramework::instance().addTest("CornerWarpCache_Solve", test_CornerWarpCache_Solve);
+    TestFramework::instance().addTest("CornerWarpCache_Reuse", test_CornerWarpCache_Reuse);
+    TestFramework::instance().addTest("CanvasRegions_Merge", test_CanvasRegions_Merge);
+    TestFramework::instance().addTest("CanvasRegions_Intersects", test_CanvasRegions_Intersects);
+    TestFramework::instance().addTest("CanvasRegions_Scaled", test_CanvasRegions_Scaled);
+    TestFramework::instance().addTest("HotplugMonitor_Changes", test_HotplugMonitor_Changes);
+    TestFramework::instance().addTest("HotplugMonitor_Thread", test_HotplugMonitor_Thread);
+    TestFramework::instance().addTest("HotplugMonitor_Uevent", test_HotplugMonitor_Uevent);
+    TestFramework::instance().addTest("StartupSequence_Order", test_StartupSequence_Order);
+    TestFramework::instance().addTest("StartupSequence_Failure", test_StartupSequence_Failure);
+    TestFramework::instance().addTest("ShowJournal_RoundTrip", test_ShowJournal_RoundTrip);
+    TestFramework::instance().addTest("ShowJournal_Writer", test_ShowJournal_Writer);
+    TestFramework::instance().addTest("PreviewGrid_Layout", test_PreviewGrid_Layout);
+    TestFramework::instance().addTest("PreviewGrid_Pacer", test_PreviewGrid_Pacer);
+    TestFramework::instance().addTest("SharedMemoryOutput_Ring", test_SharedMemoryOutput_Ring);
+    TestFramework::instance().addTest("FileEncoderOutput_ProRes", test_FileEncoderOutput_ProRes);
+    TestFramework::instance().addTest("ReadbackRing_PollsOnlySignalled", test_ReadbackRing_PollsOnlySignalled);
+    TestFramework::instance().addTest("ReadbackRing_WaitAndReconfigure", test_ReadbackRing_WaitAndReconfigure);
+    TestFramework::instance().addTest("FormatModifiers_ParseInFormats", test_FormatModifiers_ParseInFormats);
+    TestFramework::instance().addTest("FormatModifiers_RejectsMalformed", test_FormatModifiers_RejectsMalformed);
+    TestFramework::instance().addTest("PlaneAssignment_PictureInPicture", test_PlaneAssignment_PictureInPicture);
+    TestFramework::instance().addTest("PlaneAssignment_CompositedAboveBlocks", test_PlaneAssignment_CompositedAboveBlocks);
+    TestFramework::instance().addTest("GLStateCache_SkipsRedundant", test_GLStateCache_SkipsRedundant);
+    TestFramework::instance().addTest("GLStateCache_Invalidate", test_GLStateCache_Invalidate);
+    TestFramework::instance().addTest("GLStateCache_Textures", test_GLStateCache_Textures);
+    TestFramework::instance().addTest("DrawOrder_GroupsDisjoint", test_DrawOrder_GroupsDisjoint);
+    TestFramework::instance().addTest("DrawOrder_KeepsOverlapOrder", test_DrawOrder_KeepsOverlapOrder);
+    TestFramework::instance().addTest("VideoShaders_ForGLES", test_VideoShaders_ForGLES);
+    TestFramework::instance().addTest("FrameBuffer_SharedWrap", test_FrameBuffer_SharedWrap);
+    TestFramework::instance().addTest("FrameBuffer_CopyOnWrite", test_FrameBuffer_CopyOnWrite);
+    TestFramework::instance().addTest("FrameBuffer_AlignedPlanes", test_FrameBuffer_AlignedPlanes);
+    TestFramework::instance().addTest("LiveInputSource_BufferSwap", test_LiveInputSource_BufferSwap);
+    TestFramework::instance().addTest("V4L2VideoInput_CopyTight", test_V4L2VideoInput_CopyTight);
+    TestFramework::instance().addTest("LiveJitterBuffer_Pacing", test_LiveJitterBuffer_Pacing);
+    TestFramework::instance().addTest("LiveJitterBuffer_CatchUp", test_LiveJitterBuffer_CatchUp);
+    TestFramework::instance().addTest("ImageSequenceInput_Pattern", test_ImageSequenceInput_Pattern);
+    TestFramework::instance().addTest("AsyncVideoLoader_Priority", test_AsyncVideoLoader_Priority);
+    TestFramework::instance().addTest("SharedMediaRegistry_FramesAndIndex", test_SharedMediaRegistry_FramesAndIndex);
+    TestFramework::instance().addTest("ReadAheadIO_ReadSeek", test_ReadAheadIO_ReadSeek);
+    TestFramework::instance().addTest("RamClipCache_PreloadAndBudget", test_RamClipCache_PreloadAndBudget);
+    TestFramework::instance().addTest("PageCachePolicy_DropBehindPlayheads", test_PageCachePolicy_DropBehindPlayheads);
+    TestFramework::instance().addTest("MosaicInput_StitchesTiles", test_MosaicInput_StitchesTiles);
+    TestFramework::instance().addTest("ProxyMedia_Covers", test_ProxyMedia_Covers);
+    TestFramework::instance().addTest("ProxySwitcher_Conditions", test_ProxySwitcher_Conditions);
+    TestFramework::instance().addTest("DecodeGovernor_DegradesByPriority", test_DecodeGovernor_DegradesByPriority);
+    TestFramework::instance().addTest("LoadAdmission_Predict", test_LoadAdmission_Predict);
+    TestFramework::instance().addTest("LoadAdmission_Benchmark", test_LoadAdmission_Benchmark);
+    TestFramework::instance().addTest("LoadAdmission_Policies", test_LoadAdmission_Policies);
+    TestFramework::instance().addTest("HapPrepPlanner_ChunksFollowThreads", test_HapPrepPlanner_ChunksFollowThreads);
+    TestFramework::instance().addTest("HapPrepPlanner_FormatAndSnappy", test_HapPrepPlanner_FormatAndSnappy);
+    TestFramework::instance().addTest("RenderNodeManager_LeastLoaded", test_RenderNodeManager_LeastLoaded);
+    TestFramework::instance().addTest("HardwareDeviceCache_Capabilities", test_HardwareDeviceCache_Capabilities);
+    TestFramework::instance().addTest("DecoderContextPool_ReuseByKey", test_DecoderContextPool_ReuseByKey);
+    TestFramework::instance().addTest("DecoderContextPool_Capacity", test_DecoderContextPool_Capacity);
+    TestFramework::instance().addTest("TexturePool_RecyclesAfterFence", test_TexturePool_RecyclesAfterFence);
+    TestFramework::instance().addTest("TexturePool_TrimsOldestOverLimit", test_TexturePool_TrimsOldestOverLimit);
+    TestFramework::instance().addTest("TexturePool_EvictsRecycledForBudget", test_TexturePool_EvictsRecycledForBudget);
+    TestFramework::instance().addTest("MemoryBudget_EvictsTiersInOrder", test_MemoryBudget_EvictsTiersInOrder);
+    TestFramework::instance().addTest("MemoryBudget_EnforceEvictsForCharges", test_MemoryBudget_EnforceEvictsForCharges);
+    TestFramework::instance().addTest("MemoryBudget_AttributesToLayerScope", test_MemoryBudget_AttributesToLayerScope);
+    TestFramework::instance().addTest("LoopFrameCache_FillsAndServes", test_LoopFrameCache_FillsAndServes);
+    TestFramework::instance().addTest("LoopFrameCache_GivesUp", test_LoopFrameCache_GivesUp);
+    TestFramework::instance().addTest("CommandArgs_TypedValues", test_CommandArgs_TypedValues);
+    TestFramework::instance().addTest("CommandArgs_ReusesStorage", test_CommandArgs_ReusesStorage);
+    TestFramework::instance().addTest("ControlLog_RoundTrip", test_ControlLog_RoundTrip);
+    TestFramework::instance().addTest("ControlReplay_Timing", test_ControlReplay_Timing);
+    TestFramework::instance().addTest("ControlReplay_Fast", test_ControlReplay_Fast);
+    TestFramework::instance().addTest("ControlCapture_File", test_ControlCapture_File);
+    TestFramework::instance().addTest("LocalControlRing_RoundTripAndWrap", test_LocalControlRing_RoundTripAndWrap);
+    TestFramework::instance().addTest("LocalControlRing_FullAndMalformed", test_LocalControlRing_FullAndMalformed);
+    TestFramework::instance().addTest("CommandTable_Lookup", test_CommandTable_Lookup);
+    TestFramework::instance().addTest("CommandScheduler_FiresOnFrame", test_CommandScheduler_FiresOnFrame);
+    TestFramework::instance().addTest("CommandScheduler_Timetags", test_CommandScheduler_Timetags);
+    TestFramework::instance().addTest("PropertyAnimator_Fade", test_PropertyAnimator_Fade);
+    TestFramework::instance().addTest("PropertyAnimator_DirectSetWins", test_PropertyAnimator_DirectSetWins);
+    TestFramework::instance().addTest("LayerPropertyStore_StableSlots", test_LayerPropertyStore_StableSlots);
+    TestFramework::instance().addTest("GlyphAtlas_PackAndLayout", test_GlyphAtlas_PackAndLayout);
+    TestFramework::instance().addTest("LogRing_Basics", test_LogRing_Basics);
+    TestFramework::instance().addTest("LogRing_MultiProducer", test_LogRing_MultiProducer);
+    TestFramework::instance().addTest("LogRateLimit_PerSite", test_LogRateLimit_PerSite);
+    TestFramework::instance().addTest("FrameTracer_ChromeJson", test_FrameTracer_ChromeJson);
+    TestFramework::instance().addTest("FrameTracer_RingsPerThread", test_FrameTracer_RingsPerThread);
+    TestFramework::instance().addTest("ThreadRoles_Parse", test_ThreadRoles_Parse);
+    TestFramework::instance().addTest("ThreadRoles_ParseRejects", test_ThreadRoles_ParseRejects);
+    TestFramework::instance().addTest("GpuTimingStats_RollingWindow", test_GpuTimingStats_RollingWindow);
+    TestFramework::instance().addTest("IdleDetector_SettlesThenHolds", test_IdleDetector_SettlesThenHolds);
+    TestFramework::instance().addTest("IdleDetector_ActivityAndDisable", test_IdleDetector_ActivityAndDisable);
+    TestFramework::instance().addTest("WakeSignal_KeepsEarlyNotify", test_WakeSignal_KeepsEarlyNotify);
+    TestFramework::instance().addTest("TelemetryPublisher_Histogram", test_TelemetryPublisher_Histogram);
+    TestFramework::instance().addTest("TelemetryPublisher_Publish", test_TelemetryPublisher_Publish);
+    TestFramework::instance().addTest("ClusterReplicator_SendsOnlyChangedLines", test_ClusterReplicator_SendsOnlyChangedLines);
+    TestFramework::instance().addTest("ClusterReplicator_KeyframeRepairsGaps", test_ClusterReplicator_KeyframeRepairsGaps);
+    TestFramework::instance().addTest("ClusterReplicator_DropsStaleAndFollowsRestart", test_ClusterReplicator_DropsStaleAndFollowsRestart);
+    TestFramework::instance().addTest("FrameCode_RoundTrip", test_FrameCode_RoundTrip);
+    TestFramework::instance().addTest("FieldSelector_Parity", test_FieldSelector_Parity);
+    TestFramework::instance().addTest("FieldSelector_Cadence", test_FieldSelector_Cadence);
+    TestFramework::instance().addTest("PackedAlpha_Regions", test_PackedAlpha_Regions);
+    TestFramework::instance().addTest("PackedAlpha_AspectAndNames", test_PackedAlpha_AspectAndNames);
+    TestFramework::instance().addTest("TilePyramid_Levels", test_TilePyramid_Levels);
+    TestFramework::instance().addTest("TilePyramid_Select", test_TilePyramid_Select);
+    TestFramework::instance().addTest("TileResidency_Lru", test_TileResidency_Lru);
+    TestFramework::instance().addTest("TiledImage_BuildAndMap", test_TiledImage_BuildAndMap);
+    TestFramework::instance().addTest("TiledImage_AlphaWeightedLevels", test_TiledImage_AlphaWeightedLevels);
+    TestFramework::instance().addTest("ThumbnailService_FitSize", test_ThumbnailService_FitSize);
+    TestFramework::instance().addTest("ThumbnailService_CachePath", test_ThumbnailService_CachePath);
+    TestFramework::instance().addTest("ThumbnailService_Requests", test_ThumbnailService_Requests);
+    TestFramework::instance().addTest("AdvancedBlend_ChoosePath", test_AdvancedBlend_ChoosePath);
+    TestFramework::instance().addTest("AdvancedBlend_LayerBounds", test_AdvancedBlend_LayerBounds);
+    TestFramework::instance().addTest("AdvancedBlend_Shaders", test_AdvancedBlend_Shaders);
+    TestFramework::instance().addTest("EffectChain_Plan", test_EffectChain_Plan);
+    TestFramework::instance().addTest("EffectChain_TargetPool", test_EffectChain_TargetPool);
+    TestFramework::instance().addTest("TestPatternInput_Strips", test_TestPatternInput_Strips);
+    TestFramework::instance().addTest("SyncLatencyMonitor_Cadence", test_SyncLatencyMonitor_Cadence);
+    TestFramework::instance().addTest("SyncLatencyMonitor_Latency", test_SyncLatencyMonitor_Latency);
+    TestFramework::instance().addTest("FrameArena_ResetAndCoalesce", test_FrameArena_ResetAndCoalesce);
+    TestFramework::instance().addTest("FrameArena_Containers", test_FrameArena_Containers);
+    TestFramework::instance().addTest("CPUImageKernels_IsaParity", test_CPUImageKernels_IsaParity);
+    TestFramework::instance().addTest("CPUImageKernels_ExactCases", test_CPUImageKernels_ExactCases);
+    TestFramework::instance().addTest("CPUImageKernels_Tiles", test_CPUImageKernels_Tiles);
+    TestFramework::instance().addTest("CPUImageKernels_WindowedFrames", test_CPUImageKernels_WindowedFrames);
+    TestFramework::instance().addTest("SoftwareCompositor_BlendParity", test_SoftwareCompositor_BlendParity);
+    TestFramework::instance().addTest("SoftwareCompositor_BlendModes", test_SoftwareCompositor_BlendModes);
+    TestFramework::instance().addTest("SoftwareCompositor_Placement", test_SoftwareCompositor_Placement);
+    TestFramework::instance().addTest("SoftwareCompositor_Composite", test_SoftwareCompositor_Composite);
+    TestFramework::instance().addTest("SoftwareCompositor_ColorTable", test_SoftwareCompositor_ColorTable);
+    TestFramework::instance().addTest("SliceScaler_PlanSlices", test_SliceScaler_PlanSlices);
+    TestFramework::instance().addTest("SliceScaler_MatchesOneContext", test_SliceScaler_MatchesOneContext);
+    TestFramework::instance().addTest("NDIDirectory_Updates", test_NDIDirectory_Updates);
+    TestFramework::instance().addTest("NDIDirectory_WaitFor", test_NDIDirectory_WaitFor);
+    TestFramework::instance().addTest("NDIBandwidthPolicy_Switching", test_NDIBandwidthPolicy_Switching);
+    TestFramework::instance().addTest("PlayoutSchedule_Slots", test_PlayoutSchedule_Slots);
+    TestFramework::instance().addTest("PinnedBufferPool_Reuse", test_PinnedBufferPool_Reuse);
+    TestFramework::instance().addTest("DynamicResolution_Hysteresis", test_DynamicResolution_Hysteresis);
+    TestFramework::instance().addTest("FlightRecorder_Snapshot", test_FlightRecorder_Snapshot);
+
+    TestFramework::instance().addPerfTest("Perf_MTCDecoder", test_Perf_MTCDecoder);
+    TestFramework::instance().addPerfTest("Perf_LayerManager", test_Perf_LayerManager);
+    TestFramework::instance().addPerfTest("Perf_FrameBuffer", test_Perf_FrameBuffer);
+    TestFramework::instance().addPerfTest("Perf_OSCDispatch", test_Perf_OSCDispatch);
+    TestFramework::instance().addPerfTest("Perf_FramerateConverter", test_Perf_FramerateConverter);
+    TestFramework::instance().addPerfTest("Perf_CPUImageProcessor", test_Perf_CPUImageProcessor);
+    
+    int result = TestFramework::instance().runAll(perf);
+    if (perf) {
+        PerfBaseline::instance().save();
+    }
+    return result;
 }
 
@@ -0,0 +1,100 @@
+#include "TestFramework.h"
+#include "../video/MappedFrameRing.h"
+#include <cstring>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+FrameInfo ringInfo() {
+    FrameInfo info;
+    info.width = 16;
+    info.height = 8;
+    info.format = PixelFormat::BGRA32;
+    return info;
+}
+
+} // namespace
+
+bool test_MappedFrameRing_AcquireRelease() {
+    auto ring = MappedFrameRing::create();
+    FrameInfo info = ringInfo();
+    const size_t slotSize = static_cast<size_t>(info.width) * info.height * 4;
+
+    // Detached ring hands out nothing
+    TEST_ASSERT(ring->acquire(info).get() == nullptr);
+
+    // Stand-in for the renderer's mapped PBOs
+    std::vector<uint8_t> storage(slotSize * MappedFrameRing::SLOTS);
+    uint8_t* memory[MappedFrameRing::SLOTS];
+    for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+        memory[i] = storage.data() + i * slotSize;
+    }
+    TEST_ASSERT_TRUE(ring->attach(memory, slotSize, info));
+
+    MappedFrameRing::Handle a = ring->acquire(info);
+    TEST_ASSERT(a.get() != nullptr);
+    TEST_ASSERT(a->buffer.data() == memory[a->index]);
+    TEST_ASSERT_FALSE(a->buffer.ownsData());
+    TEST_ASSERT_EQ(ring->indexOf(&a->buffer), a->index);
+
+    // Geometry mismatch falls back to the caller's buffer
+    FrameInfo other = info;
+    other.width = 32;
+    TEST_ASSERT(ring->acquire(other).get() == nullptr);
+
+    // GPU-busy slots stay unavailable after their handle is dropped
+    MappedFrameRing::Handle b = ring->acquire(info);
+    MappedFrameRing::Handle c = ring->acquire(info);
+    TEST_ASSERT(c.get() != nullptr);
+    TEST_ASSERT(ring->acquire(info).get() == nullptr);
+    int busy = b->index;
+    ring->setGpuBusy(busy, true);
+    b.reset();
+    c.reset();
+    MappedFrameRing::Handle d = ring->acquire(info);
+    TEST_ASSERT(d.get() != nullptr);
+    TEST_ASSERT(d->index != busy);
+    TEST_ASSERT(ring->acquire(info).get() == nullptr);
+    ring->setGpuBusy(busy, false);
+    TEST_ASSERT(ring->acquire(info).get() != nullptr);
+
+    TEST_ASSERT_EQ(ring->getStats().unavailable, static_cast<uint64_t>(2));
+    return true;
+}
+
+bool test_MappedFrameRing_ForcedDetach() {
+    auto ring = MappedFrameRing::create();
+    FrameInfo info = ringInfo();
+    const size_t slotSize = static_cast<size_t>(info.width) * info.height * 4;
+
+    std::vector<uint8_t> storage(slotSize * MappedFrameRing::SLOTS, 0);
+    uint8_t* memory[MappedFrameRing::SLOTS];
+    for (int i = 0; i < MappedFrameRing::SLOTS; ++i) {
+        memory[i] = storage.data() + i * slotSize;
+    }
+    TEST_ASSERT_TRUE(ring->attach(memory, slotSize, info));
+
+    MappedFrameRing::Handle shown = ring->acquire(info);
+    TEST_ASSERT(shown.get() != nullptr);
+    std::memset(shown->buffer.data(), 0x5A, slotSize);
+
+    // Held slots block a plain detach and a re-attach
+    TEST_ASSERT_FALSE(ring->detach(false));
+    TEST_ASSERT_FALSE(ring->attach(memory, slotSize, info));
+
+    // Forced detach keeps the displayed pixels in owned memory
+    TEST_ASSERT_TRUE(ring->detach(true));
+    TEST_ASSERT_FALSE(ring->isAttached());
+    TEST_ASSERT_TRUE(shown->buffer.ownsData());
+    TEST_ASSERT(shown->buffer.data() != memory[shown->index]);
+    std::memset(storage.data(), 0, storage.size());
+    TEST_ASSERT_EQ(static_cast<int>(shown->buffer.data()[slotSize - 1]), 0x5A);
+    TEST_ASSERT_EQ(ring->indexOf(&shown->buffer), -1);
+
+    shown.reset();
+    TEST_ASSERT_TRUE(ring->attach(memory, slotSize, info));
+    return true;
+}
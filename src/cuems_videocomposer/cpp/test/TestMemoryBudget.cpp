@@ -0,0 +1,153 @@
+#include "TestFramework.h"
+#include "../video/MemoryBudget.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+using Subsystem = MemoryBudget::Subsystem;
+using Account = MemoryBudget::Account;
+
+// A cache of one subsystem that gives everything back when evicted
+struct FakeCache {
+    MemoryBudget& budget;
+    Subsystem subsystem;
+    std::string name;
+    std::vector<std::string>& calls;
+    size_t held = 0;
+
+    bool fill(size_t bytes) {
+        if (!budget.reserve(Account(subsystem, MemoryBudget::NO_LAYER), bytes)) {
+            return false;
+        }
+        held += bytes;
+        return true;
+    }
+
+    size_t evict(size_t) {
+        calls.push_back(name);
+        size_t freed = held;
+        budget.release(Account(subsystem, MemoryBudget::NO_LAYER), freed);
+        held = 0;
+        return freed;
+    }
+};
+
+size_t subsystemBytes(const MemoryBudget& budget, Subsystem subsystem) {
+    return budget.getReport().subsystems[static_cast<size_t>(subsystem)];
+}
+
+} // namespace
+
+bool test_MemoryBudget_EvictsTiersInOrder() {
+    MemoryBudget budget;
+    budget.setLimit(MemoryBudget::Pool::RAM, 100);
+    std::vector<std::string> calls;
+    FakeCache cues{budget, Subsystem::CUE_PREFETCH, "cues", calls};
+    FakeCache loops{budget, Subsystem::LOOP_PREFETCH, "loops", calls};
+    budget.addEvictor(MemoryBudget::Tier::PREFETCH, MemoryBudget::Pool::RAM,
+                      [&cues](size_t bytes) { return cues.evict(bytes); });
+    budget.addEvictor(MemoryBudget::Tier::LOOP_CACHE, MemoryBudget::Pool::RAM,
+                      [&loops](size_t bytes) { return loops.evict(bytes); });
+    TEST_ASSERT_TRUE(cues.fill(30));
+    TEST_ASSERT_TRUE(loops.fill(30));
+
+    // Cue prefetch goes first; it is enough
+    TEST_ASSERT_TRUE(budget.reserve(Account(Subsystem::RAM_CLIPS, MemoryBudget::NO_LAYER), 60));
+    TEST_ASSERT_EQ(calls.size(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(calls[0], std::string("cues"));
+    TEST_ASSERT_EQ(loops.held, static_cast<size_t>(30));
+    TEST_ASSERT_EQ(budget.getUsed(MemoryBudget::Pool::RAM), static_cast<size_t>(90));
+
+    // A cache never evicts its own tier or a later one
+    TEST_ASSERT_FALSE(cues.fill(20));
+    TEST_ASSERT_EQ(loops.held, static_cast<size_t>(30));
+
+    // Then the loop caches
+    TEST_ASSERT_TRUE(budget.reserve(Account(Subsystem::RAM_CLIPS, MemoryBudget::NO_LAYER), 40));
+    TEST_ASSERT_EQ(calls.back(), std::string("loops"));
+    TEST_ASSERT_EQ(budget.getUsed(MemoryBudget::Pool::RAM), static_cast<size_t>(100));
+
+    // Nothing left to evict: refused, nothing charged
+    TEST_ASSERT_FALSE(budget.reserve(Account(Subsystem::RAM_CLIPS, MemoryBudget::NO_LAYER), 1));
+    MemoryBudget::PoolUsage ram = budget.getReport().pools[static_cast<size_t>(MemoryBudget::Pool::RAM)];
+    TEST_ASSERT_EQ(ram.used, static_cast<size_t>(100));
+    TEST_ASSERT_EQ(ram.refusals, static_cast<uint64_t>(2));
+    TEST_ASSERT_EQ(ram.evictions, static_cast<uint64_t>(2));
+    TEST_ASSERT_EQ(ram.evictedBytes, static_cast<uint64_t>(60));
+
+    // VRAM has no limit here and is a pool of its own
+    TEST_ASSERT_TRUE(budget.reserve(Account(Subsystem::LAYER_TEXTURES, 1), 1000));
+    TEST_ASSERT_EQ(budget.getUsed(MemoryBudget::Pool::RAM), static_cast<size_t>(100));
+    return true;
+}
+
+bool test_MemoryBudget_EnforceEvictsForCharges() {
+    MemoryBudget budget;
+    budget.setLimit(MemoryBudget::Pool::VRAM, 100);
+    std::vector<std::string> calls;
+    FakeCache warmups{budget, Subsystem::ARMED_UPLOADS, "warmups", calls};
+    int id = budget.addEvictor(MemoryBudget::Tier::WARMUP, MemoryBudget::Pool::VRAM,
+                               [&warmups](size_t bytes) { return warmups.evict(bytes); });
+    TEST_ASSERT_TRUE(warmups.fill(50));
+
+    // Charged anyway: over the limit until the next enforce()
+    budget.charge(Account(Subsystem::CANVAS, MemoryBudget::NO_LAYER), 80);
+    TEST_ASSERT_EQ(budget.getUsed(MemoryBudget::Pool::VRAM), static_cast<size_t>(130));
+    TEST_ASSERT_EQ(budget.enforce(), static_cast<size_t>(50));
+    TEST_ASSERT_EQ(budget.getUsed(MemoryBudget::Pool::VRAM), static_cast<size_t>(80));
+    TEST_ASSERT_EQ(subsystemBytes(budget, Subsystem::ARMED_UPLOADS), static_cast<size_t>(0));
+
+    // Within the limit: nothing evicted; removed evictors are not called
+    TEST_ASSERT_TRUE(warmups.fill(10));
+    TEST_ASSERT_EQ(budget.enforce(), static_cast<size_t>(0));
+    budget.removeEvictor(id);
+    budget.charge(Account(Subsystem::CANVAS, MemoryBudget::NO_LAYER), 80);
+    TEST_ASSERT_EQ(budget.enforce(), static_cast<size_t>(0));
+    TEST_ASSERT_EQ(calls.size(), static_cast<size_t>(1));
+    return true;
+}
+
+bool test_MemoryBudget_AttributesToLayerScope() {
+    MemoryBudget budget;
+    Account texture(Subsystem::LAYER_TEXTURES);  // CURRENT_LAYER
+    Account pool(Subsystem::FRAME_POOLS);
+    {
+        MemoryBudget::LayerScope scope(7);
+        budget.charge(texture, 100);
+        {
+            MemoryBudget::LayerScope nested(9);
+            budget.charge(pool, 50);
+        }
+        budget.charge(pool, 30);
+        TEST_ASSERT_EQ(MemoryBudget::resolve(texture).layerId, 7);
+    }
+    TEST_ASSERT_EQ(MemoryBudget::currentLayer(), MemoryBudget::NO_LAYER);
+    budget.charge(texture, 10);
+
+    MemoryBudget::Report report = budget.getReport();
+    TEST_ASSERT_EQ(report.layers.size(), static_cast<size_t>(3));
+    TEST_ASSERT_EQ(report.layers[0].layerId, MemoryBudget::NO_LAYER);
+    TEST_ASSERT_EQ(report.layers[0].bytes[0], static_cast<size_t>(10));
+    TEST_ASSERT_EQ(report.layers[1].layerId, 7);
+    TEST_ASSERT_EQ(report.layers[1].bytes[0], static_cast<size_t>(100));
+    TEST_ASSERT_EQ(report.layers[1].bytes[1], static_cast<size_t>(30));
+    TEST_ASSERT_EQ(report.layers[2].layerId, 9);
+    TEST_ASSERT_EQ(report.layers[2].bytes[1], static_cast<size_t>(50));
+    TEST_ASSERT_EQ(report.subsystems[static_cast<size_t>(Subsystem::FRAME_POOLS)], static_cast<size_t>(80));
+
+    // Released to the layer it was charged to; empty layers drop out
+    budget.release(Account(Subsystem::FRAME_POOLS, 9), 50);
+    TEST_ASSERT_EQ(budget.getReport().layers.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(budget.getUsed(MemoryBudget::Pool::RAM), static_cast<size_t>(30));
+
+    bool layerLine = false;
+    for (const std::string& line : budget.formatReport()) {
+        layerLine = layerLine || line.find("Layer 7") == 0;
+    }
+    TEST_ASSERT_TRUE(layerLine);
+    return true;
+}
@@ -0,0 +1,120 @@
+#include "TestFramework.h"
+#include "../input/MosaicInput.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Solid tile whose pixels encode the tile id and frame number
+class SolidTile : public InputSource {
+public:
+    SolidTile(uint8_t id, int width, int height, int64_t missedFrame)
+        : id_(id), missedFrame_(missedFrame) {
+        info_.width = width;
+        info_.height = height;
+        info_.framerate = 25.0;
+        info_.totalFrames = 100;
+        info_.format = PixelFormat::BGRA32;
+    }
+    bool open(const std::string&) override { return true; }
+    void close() override {}
+    bool isReady() const override { return true; }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override {
+        if (frameNumber == missedFrame_ || !buffer.ensureAllocated(info_)) {
+            return false;
+        }
+        for (size_t i = 0; i < buffer.size(); i += 4) {
+            buffer.data()[i] = id_;
+            buffer.data()[i + 1] = static_cast<uint8_t>(frameNumber);
+            buffer.data()[i + 2] = 0;
+            buffer.data()[i + 3] = 255;
+        }
+        current_ = frameNumber;
+        return true;
+    }
+    bool seek(int64_t frameNumber) override { current_ = frameNumber; return true; }
+    FrameInfo getFrameInfo() const override { return info_; }
+    int64_t getCurrentFrame() const override { return current_; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+
+private:
+    FrameInfo info_;
+    uint8_t id_;
+    int64_t missedFrame_;
+    int64_t current_ = -1;
+};
+
+std::string writeManifest(const std::string& text) {
+    char tmpl[] = "/tmp/cvc_mosaic_XXXXXX";
+    int fd = mkstemp(tmpl);
+    if (fd < 0) {
+        return std::string();
+    }
+    bool ok = write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+    ::close(fd);
+    return ok ? std::string(tmpl) : std::string();
+}
+
+} // namespace
+
+bool test_MosaicInput_StitchesTiles() {
+    TEST_ASSERT_TRUE(MosaicInput::isMosaicPath("/show/wall.MOSAIC"));
+    TEST_ASSERT_FALSE(MosaicInput::isMosaicPath("/show.mosaic/wall.mov"));
+
+    const std::string path = writeManifest(
+        "# 2x1 wall with a gap below\n"
+        "canvas 8 3\n"
+        "tile 0 0 left.mov\n"
+        "tile 4 0 /media/right file.mov\n");
+    TEST_ASSERT_FALSE(path.empty());
+
+    MosaicInput::Manifest manifest;
+    TEST_ASSERT_TRUE(MosaicInput::Manifest::parse(path, manifest));
+    TEST_ASSERT_EQ(manifest.width, 8);
+    TEST_ASSERT_EQ(manifest.tiles.size(), static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(manifest.tiles[0].path == "/tmp/left.mov");
+    TEST_ASSERT_TRUE(manifest.tiles[1].path == "/media/right file.mov");
+    TEST_ASSERT_EQ(manifest.tiles[1].x, 4);
+
+    // The right tile misses frame 7
+    MosaicInput mosaic;
+    mosaic.setTileFactory([](const std::string& tilePath) -> std::unique_ptr<InputSource> {
+        bool left = tilePath == "/tmp/left.mov";
+        return std::make_unique<SolidTile>(left ? 1 : 2, 4, 2, left ? -1 : 7);
+    });
+    TEST_ASSERT_TRUE(mosaic.open(path));
+    TEST_ASSERT_EQ(mosaic.getFrameInfo().width, 8);
+    TEST_ASSERT_EQ(mosaic.getFrameInfo().height, 3);
+    TEST_ASSERT_EQ(mosaic.getTileCount(), static_cast<size_t>(2));
+
+    FrameBuffer frame;
+    TEST_ASSERT_TRUE(mosaic.readFrame(5, frame));
+    const uint8_t* px = frame.data();
+    TEST_ASSERT_EQ(px[0], 1);                        // Left tile
+    TEST_ASSERT_EQ(px[(1 * 8 + 5) * 4], 2);          // Right tile, second row
+    TEST_ASSERT_EQ(px[(1 * 8 + 5) * 4 + 1], 5);      // ... at the same frame
+    TEST_ASSERT_EQ(px[(2 * 8 + 1) * 4 + 3], 0);      // Uncovered row stays transparent
+
+    // A frame one tile misses is not shown at all
+    TEST_ASSERT_FALSE(mosaic.readFrame(7, frame));
+    TEST_ASSERT_EQ(mosaic.getCurrentFrame(), static_cast<int64_t>(5));
+    TEST_ASSERT_EQ(mosaic.getTornFrames(), static_cast<uint64_t>(1));
+    TEST_ASSERT_TRUE(mosaic.readFrame(8, frame));
+    mosaic.close();
+
+    // Overlapping tiles are refused
+    const std::string overlap = writeManifest("tile 0 0 a.mov\ntile 2 0 b.mov\n");
+    TEST_ASSERT_FALSE(mosaic.open(overlap));
+
+    unlink(path.c_str());
+    unlink(overlap.c_str());
+    return true;
+}
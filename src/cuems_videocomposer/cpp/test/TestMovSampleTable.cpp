@@ -0,0 +1,177 @@
+#include "TestFramework.h"
+#include "../hap/MovSampleTable.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+void putU32(Bytes& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void putType(Bytes& out, const char* type) {
+    out.insert(out.end(), type, type + 4);
+}
+
+Bytes box(const char* type, const Bytes& payload) {
+    Bytes out;
+    putU32(out, static_cast<uint32_t>(payload.size() + 8));
+    putType(out, type);
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+Bytes concat(std::initializer_list<Bytes> parts) {
+    Bytes out;
+    for (const Bytes& part : parts) {
+        out.insert(out.end(), part.begin(), part.end());
+    }
+    return out;
+}
+
+// Full box payload: version/flags followed by 32-bit fields
+Bytes fullBox(std::initializer_list<uint32_t> fields) {
+    Bytes out;
+    putU32(out, 0);
+    for (uint32_t v : fields) {
+        putU32(out, v);
+    }
+    return out;
+}
+
+struct MovOptions {
+    const char* codec = "Hap1";
+    uint32_t secondDelta = 100;   // stts delta of the last sample
+    uint32_t editMediaTime = 0;
+    uint32_t offsetShift = 0;     // Added to every chunk offset
+};
+
+/**
+ * Three samples in two chunks (2 + 1), mdat before moov:
+ * frame i is (i + 1) * 10 bytes filled with 'A' + i
+ */
+Bytes buildMov(const MovOptions& options) {
+    Bytes ftyp = box("ftyp", concat({Bytes{'q', 't', ' ', ' '}, fullBox({})}));
+
+    Bytes samples;
+    for (int i = 0; i < 3; ++i) {
+        samples.insert(samples.end(), (i + 1) * 10, static_cast<uint8_t>('A' + i));
+    }
+    Bytes mdat = box("mdat", samples);
+    uint32_t firstChunk = static_cast<uint32_t>(ftyp.size() + 8) + options.offsetShift;
+    uint32_t secondChunk = firstChunk + 30;
+
+    Bytes hdlr;
+    putU32(hdlr, 0);
+    putType(hdlr, "mhlr");
+    putType(hdlr, "vide");
+    hdlr.resize(hdlr.size() + 12, 0);
+
+    Bytes sampleEntry;
+    putU32(sampleEntry, 16);
+    putType(sampleEntry, options.codec);
+    sampleEntry.resize(sampleEntry.size() + 8, 0);
+
+    Bytes stbl = box("stbl", concat({
+        box("stsd", concat({fullBox({1}), sampleEntry})),
+        box("stts", fullBox({2, 2, 100, 1, options.secondDelta})),
+        box("stsc", fullBox({2, 1, 2, 1, 2, 1, 1})),
+        box("stsz", fullBox({0, 3, 10, 20, 30})),
+        box("stco", fullBox({2, firstChunk, secondChunk})),
+    }));
+    Bytes minf = box("minf", concat({box("vmhd", fullBox({0, 0})), stbl}));
+    Bytes mdia = box("mdia", concat({box("hdlr", hdlr), minf}));
+    Bytes edts = box("edts", box("elst", fullBox({1, 300, options.editMediaTime, 0x10000})));
+    Bytes moov = box("moov", box("trak", concat({edts, mdia})));
+
+    return concat({ftyp, mdat, moov});
+}
+
+bool packetIs(const MovSampleTable& table, int64_t frame, size_t expectedSize, uint8_t fill) {
+    size_t size = 0;
+    const uint8_t* data = table.packet(frame, size);
+    if (!data || size != expectedSize) {
+        return false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != fill) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool test_MovSampleTable_Index() {
+    Bytes mov = buildMov(MovOptions());
+    MovSampleTable table;
+    TEST_ASSERT_TRUE(table.parse(mov.data(), mov.size()));
+    TEST_ASSERT_EQ(table.getSampleCount(), static_cast<int64_t>(3));
+
+    // Random and reverse access need no prior state
+    TEST_ASSERT_TRUE(packetIs(table, 2, 30, 'C'));
+    TEST_ASSERT_TRUE(packetIs(table, 0, 10, 'A'));
+    TEST_ASSERT_TRUE(packetIs(table, 1, 20, 'B'));
+    size_t size = 0;
+    TEST_ASSERT(table.packet(3, size) == nullptr);
+    TEST_ASSERT(table.packet(-1, size) == nullptr);
+
+    // Same file through the mapping
+    char path[] = "/tmp/videocomposer_movXXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT(fd >= 0);
+    bool written = write(fd, mov.data(), mov.size()) == static_cast<ssize_t>(mov.size());
+    close(fd);
+    MovSampleTable mapped;
+    bool opened = written && mapped.open(path);
+    unlink(path);
+    TEST_ASSERT_TRUE(opened);
+    TEST_ASSERT_TRUE(packetIs(mapped, 2, 30, 'C'));
+    mapped.prefetch(1);
+    TEST_ASSERT_TRUE(packetIs(mapped, 1, 20, 'B'));
+    mapped.close();
+    TEST_ASSERT_FALSE(mapped.isOpen());
+    return true;
+}
+
+bool test_MovSampleTable_Rejects() {
+    MovSampleTable table;
+
+    MovOptions otherCodec;
+    otherCodec.codec = "avc1";
+    Bytes mov = buildMov(otherCodec);
+    TEST_ASSERT_FALSE(table.parse(mov.data(), mov.size()));
+
+    // Frame numbers would no longer be sample numbers
+    MovOptions variableRate;
+    variableRate.secondDelta = 50;
+    mov = buildMov(variableRate);
+    TEST_ASSERT_FALSE(table.parse(mov.data(), mov.size()));
+
+    MovOptions shifted;
+    shifted.editMediaTime = 100;
+    mov = buildMov(shifted);
+    TEST_ASSERT_FALSE(table.parse(mov.data(), mov.size()));
+
+    MovOptions outside;
+    outside.offsetShift = 1000;
+    mov = buildMov(outside);
+    TEST_ASSERT_FALSE(table.parse(mov.data(), mov.size()));
+    TEST_ASSERT_FALSE(table.isOpen());
+
+    // Truncated moov
+    mov = buildMov(MovOptions());
+    TEST_ASSERT_FALSE(table.parse(mov.data(), mov.size() - 20));
+    return true;
+}
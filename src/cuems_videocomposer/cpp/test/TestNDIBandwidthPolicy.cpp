@@ -0,0 +1,42 @@
+#include "TestFramework.h"
+#include "../input/NDIBandwidthPolicy.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_NDIBandwidthPolicy_Switching() {
+    using Bandwidth = NDIBandwidthPolicy::Bandwidth;
+    NDIBandwidthPolicy policy;
+    policy.setSourceSize(1920, 1080);
+
+    // Unknown or full size: the full stream
+    TEST_ASSERT_TRUE(policy.update(0, 0, 0.0) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(policy.update(1920, 1080, 0.0) == Bandwidth::HIGHEST);
+
+    // A multiview tile goes to the proxy once it has settled
+    TEST_ASSERT_TRUE(policy.update(480, 270, 1.0) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(policy.update(480, 270, 1.5) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(policy.update(480, 270, 1.0 + NDIBandwidthPolicy::SETTLE_SECONDS) == Bandwidth::LOWEST);
+    policy.setCurrent(Bandwidth::LOWEST);
+    policy.setProxySize(640, 360);
+
+    // Up to the proxy size it stays; larger goes back at once
+    TEST_ASSERT_TRUE(policy.update(640, 360, 3.0) == Bandwidth::LOWEST);
+    TEST_ASSERT_TRUE(policy.update(1920, 1080, 3.1) == Bandwidth::HIGHEST);
+    policy.setCurrent(Bandwidth::HIGHEST);
+
+    // Going down needs headroom below the proxy, and a fresh settle
+    TEST_ASSERT_TRUE(policy.update(640, 360, 4.0) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(policy.update(640, 360, 10.0) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(policy.update(560, 315, 10.0) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(policy.update(560, 315, 11.0) == Bandwidth::LOWEST);
+
+    // Nothing to gain from a source no larger than the proxy, or when disabled
+    NDIBandwidthPolicy small;
+    small.setSourceSize(640, 360);
+    TEST_ASSERT_TRUE(small.update(100, 50, 0.0) == Bandwidth::HIGHEST);
+    TEST_ASSERT_TRUE(small.update(100, 50, 5.0) == Bandwidth::HIGHEST);
+    policy.setEnabled(false);
+    TEST_ASSERT_TRUE(policy.update(100, 50, 20.0) == Bandwidth::HIGHEST);
+    return true;
+}
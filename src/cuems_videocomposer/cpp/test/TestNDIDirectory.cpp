@@ -0,0 +1,70 @@
+#include "TestFramework.h"
+#include "../input/NDIDirectory.h"
+#include <chrono>
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+NDIDirectory::Source source(const std::string& name, const std::string& url) {
+    NDIDirectory::Source s;
+    s.name = name;
+    s.url = url;
+    return s;
+}
+
+} // namespace
+
+bool test_NDIDirectory_Updates() {
+    NDIDirectory directory;
+    NDIDirectory::Source found;
+    TEST_ASSERT_FALSE(directory.find("CAM", found));
+
+    directory.update({source("STAGE (CAM 1)", "10.0.0.5:5961"), source("FOH (Graphics)", "10.0.0.9:5961")}, 1000);
+    TEST_ASSERT_EQ(directory.getSourceNames().size(), 2u);
+
+    // Exact name first, else the first that contains it
+    TEST_ASSERT_TRUE(directory.find("FOH (Graphics)", found));
+    TEST_ASSERT_EQ(found.url, std::string("10.0.0.9:5961"));
+    TEST_ASSERT_TRUE(directory.find("CAM 1", found));
+    TEST_ASSERT_EQ(found.name, std::string("STAGE (CAM 1)"));
+    TEST_ASSERT_EQ(found.revision, 1u);
+
+    // A restarted sender at a new address bumps the revision
+    directory.update({source("STAGE (CAM 1)", "10.0.0.6:5961")}, 2000);
+    TEST_ASSERT_TRUE(directory.find("STAGE (CAM 1)", found));
+    TEST_ASSERT_EQ(found.url, std::string("10.0.0.6:5961"));
+    TEST_ASSERT_EQ(found.revision, 2u);
+    directory.update({source("STAGE (CAM 1)", "10.0.0.6:5961")}, 3000);
+    TEST_ASSERT_TRUE(directory.find("STAGE (CAM 1)", found));
+    TEST_ASSERT_EQ(found.revision, 2u);
+
+    // Gone sources linger, then drop
+    TEST_ASSERT_TRUE(directory.find("Graphics", found));
+    directory.update({source("STAGE (CAM 1)", "10.0.0.6:5961")}, 1000 + NDIDirectory::LINGER_MS + 1);
+    TEST_ASSERT_FALSE(directory.find("Graphics", found));
+    TEST_ASSERT_EQ(directory.getSourceNames().size(), 1u);
+    return true;
+}
+
+bool test_NDIDirectory_WaitFor() {
+    NDIDirectory directory;
+    NDIDirectory::Source found;
+    TEST_ASSERT_FALSE(directory.waitFor("CAM", 20, found));
+
+    // A source that appears while waiting is returned then
+    std::thread announcer([&directory]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        directory.update({source("STAGE (Other)", "")}, NDIDirectory::nowMs());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        directory.update({source("STAGE (Other)", ""), source("STAGE (CAM 2)", "10.0.0.7:5961")},
+                         NDIDirectory::nowMs());
+    });
+    bool waited = directory.waitFor("CAM 2", 5000, found);
+    announcer.join();
+    TEST_ASSERT_TRUE(waited);
+    TEST_ASSERT_EQ(found.name, std::string("STAGE (CAM 2)"));
+    return true;
+}
@@ -0,0 +1,77 @@
+#include "TestFramework.h"
+#include "../display/OutputBlitShader.h"
+#include <cmath>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_OutputBlitShader_BlendMask() {
+    // No blending: every pixel at full weight
+    BlendEdges none;
+    std::vector<uint16_t> mask;
+    OutputBlitShader::buildBlendMask(none, 8, 4, mask);
+    TEST_ASSERT_EQ(mask.size(), static_cast<size_t>(32));
+    for (uint16_t weight : mask) {
+        TEST_ASSERT_EQ(weight, 65535);
+    }
+    
+    // 100 px left ramp: rises from near zero, full weight past the ramp
+    BlendEdges left;
+    left.left = 100.0f;
+    OutputBlitShader::buildBlendMask(left, 200, 2, mask);
+    TEST_ASSERT(mask[0] < 10);
+    for (int x = 1; x < 100; ++x) {
+        TEST_ASSERT(mask[x] >= mask[x - 1]);
+    }
+    TEST_ASSERT_EQ(mask[150], 65535);
+    TEST_ASSERT_EQ(mask[200 + 50], mask[50]);
+    
+    // Same weights as the per-pixel curve, gamma applied after the product
+    BlendEdges corner;
+    corner.right = 40.0f;
+    corner.bottom = 20.0f;
+    corner.gamma = 1.8f;
+    OutputBlitShader::buildBlendMask(corner, 64, 32, mask);
+    float t1 = (64 - 50.5f) / 40.0f;
+    float t2 = (32 - 25.5f) / 20.0f;
+    float expected = std::pow(t1 * t1 * (3 - 2 * t1) * t2 * t2 * (3 - 2 * t2), 1.8f);
+    TEST_ASSERT(std::abs(OutputBlitShader::blendWeight(corner, 64, 32, 50, 25) - expected) < 1e-5f);
+    TEST_ASSERT(std::abs(mask[25 * 64 + 50] / 65535.0f - expected) < 1e-4f);
+    TEST_ASSERT_EQ(mask[0], 65535);
+    return true;
+}
+
+bool test_OutputBlitShader_RegionChanges() {
+    OutputRegion region = OutputRegion::createDefault("HDMI-A-1", 1920, 1080);
+    OutputRegion next = region;
+    TEST_ASSERT_FALSE(region.changesTo(next).any());
+    
+    // A blend tweak rebakes the mask only: the canvas stays as it is
+    next.blend.right = 120.0f;
+    OutputRegion::Changes changes = region.changesTo(next);
+    TEST_ASSERT_TRUE(changes.blend);
+    TEST_ASSERT_FALSE(changes.placement || changes.physical || changes.warp);
+    TEST_ASSERT_FALSE(changes.affectsCanvas());
+    
+    next = region;
+    next.warpMesh = std::make_shared<WarpMesh>();
+    changes = region.changesTo(next);
+    TEST_ASSERT_TRUE(changes.warp);
+    TEST_ASSERT_FALSE(changes.affectsCanvas());
+    
+    next = region;
+    next.physicalWidth = 1280;
+    TEST_ASSERT_TRUE(region.changesTo(next).physical);
+    TEST_ASSERT_FALSE(region.changesTo(next).affectsCanvas());
+    
+    // Moving it or turning it off changes what the canvas composites
+    next = region;
+    next.canvasX = 1800;
+    TEST_ASSERT_TRUE(region.changesTo(next).placement);
+    TEST_ASSERT_TRUE(region.changesTo(next).affectsCanvas());
+    next = region;
+    next.enabled = false;
+    TEST_ASSERT_TRUE(region.changesTo(next).affectsCanvas());
+    return true;
+}
@@ -0,0 +1,60 @@
+#include "TestFramework.h"
+#include "../display/OutputInfo.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+OutputInfo makeOutput(double currentHz, std::initializer_list<double> refreshRates) {
+    OutputInfo info;
+    info.width = 1920;
+    info.height = 1080;
+    info.refreshRate = currentHz;
+    for (double hz : refreshRates) {
+        OutputMode mode;
+        mode.width = 1920;
+        mode.height = 1080;
+        mode.refreshRate = hz;
+        info.modes.push_back(mode);
+    }
+    OutputMode other;
+    other.width = 1280;
+    other.height = 720;
+    other.refreshRate = 50.0;
+    info.modes.push_back(other);
+    return info;
+}
+
+} // namespace
+
+bool test_OutputInfo_FindRefreshMultiple() {
+    OutputInfo output = makeOutput(60.0, {24.0, 25.0, 50.0, 59.94006, 60.0, 100.0});
+
+    // 25 fps: 50 Hz is the multiple closest to the current 60 Hz
+    const OutputMode* mode = output.findRefreshMultiple(1920, 1080, 25.0);
+    TEST_ASSERT(mode != nullptr);
+    TEST_ASSERT(std::abs(mode->refreshRate - 50.0) < 0.001);
+
+    // 29.97 fps: 59.94 Hz, not 60 Hz
+    mode = output.findRefreshMultiple(1920, 1080, 30000.0 / 1001.0);
+    TEST_ASSERT(mode != nullptr);
+    TEST_ASSERT(std::abs(mode->refreshRate - 59.94006) < 0.001);
+
+    // 24 fps: 60 Hz needs 3:2 pulldown, 24 Hz is the only multiple
+    mode = output.findRefreshMultiple(1920, 1080, 24.0);
+    TEST_ASSERT(mode != nullptr);
+    TEST_ASSERT(std::abs(mode->refreshRate - 24.0) < 0.001);
+
+    // Already on a multiple: stays there
+    output.refreshRate = 100.0;
+    mode = output.findRefreshMultiple(1920, 1080, 25.0);
+    TEST_ASSERT(mode != nullptr);
+    TEST_ASSERT(std::abs(mode->refreshRate - 100.0) < 0.001);
+
+    // No multiple at this resolution
+    TEST_ASSERT(output.findRefreshMultiple(1280, 720, 24.0) == nullptr);
+    TEST_ASSERT(output.findRefreshMultiple(1920, 1080, 23.0) == nullptr);
+    TEST_ASSERT(output.findRefreshMultiple(1920, 1080, 0.0) == nullptr);
+    return true;
+}
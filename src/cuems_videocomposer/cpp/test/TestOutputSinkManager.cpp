@@ -0,0 +1,315 @@
+#include "TestFramework.h"
+#include "../output/OutputSinkManager.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+class FakeSink : public OutputSink {
+public:
+    FakeSink(const std::string& id, DropPolicy policy, size_t depth)
+        : id_(id), policy_(policy), depth_(depth) {}
+
+    bool open(const std::string&, const OutputSinkConfig&) override { return true; }
+    void close() override { open_ = false; }
+    bool isReady() const override { return open_; }
+
+    bool writeFrame(const FrameData& frame) override {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            gate_.wait(lock, [this]() { return !held_; });
+        }
+        if (delayMs_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs_));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames_.push_back(frame.frameNumber);
+        data_.push_back(frame.data);
+        return true;
+    }
+
+    Type getType() const override { return Type::NDI; }
+    std::string getId() const override { return id_; }
+    std::string getDescription() const override { return "Fake " + id_; }
+    DropPolicy getDropPolicy() const override { return policy_; }
+    size_t getQueueDepth() const override { return depth_; }
+    CaptureFormat getCaptureFormat() const override { return format_; }
+    
+    void setCaptureFormat(const CaptureFormat& format) { format_ = format; }
+
+    // Hold writeFrame() (a stalled network sink) until release()
+    void hold() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_ = true;
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            held_ = false;
+        }
+        gate_.notify_all();
+    }
+    void setDelayMs(int ms) { delayMs_ = ms; }
+
+    std::vector<int64_t> frames() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frames_;
+    }
+    const uint8_t* dataOf(int64_t frameNumber) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(frames_.begin(), frames_.end(), frameNumber);
+        return it == frames_.end() ? nullptr : data_[it - frames_.begin()];
+    }
+
+private:
+    std::string id_;
+    DropPolicy policy_;
+    size_t depth_;
+    CaptureFormat format_;
+    bool open_ = true;
+    bool held_ = false;
+    int delayMs_ = 0;
+    std::mutex mutex_;
+    std::condition_variable gate_;
+    std::vector<int64_t> frames_;
+    std::vector<const uint8_t*> data_;
+};
+
+// Takes the canvas texture on the render thread, like a hardware encoder
+class FakeGpuSink : public OutputSink {
+public:
+    bool open(const std::string&, const OutputSinkConfig&) override { return true; }
+    void close() override {}
+    bool isReady() const override { return true; }
+    bool writeFrame(const FrameData&) override { ++cpuFrames; return true; }
+    bool isGpuSink() const override { return true; }
+    bool writeTexture(GLuint texture, int, int, int64_t) override {
+        lastTexture = texture;
+        return texture != 0;
+    }
+    Type getType() const override { return Type::FILE; }
+    std::string getId() const override { return "gpu"; }
+    std::string getDescription() const override { return "Fake encoder"; }
+
+    std::atomic<int> cpuFrames{0};
+    GLuint lastTexture = 0;
+};
+
+// Keeps the last frame after returning, like an async network send
+class FakeAsyncSink : public OutputSink {
+public:
+    bool open(const std::string&, const OutputSinkConfig&) override { return true; }
+    void close() override { inFlight.reset(); }
+    bool isReady() const override { return true; }
+    bool writeFrame(const FrameData&) override { return false; }
+    bool writeSharedFrame(const std::shared_ptr<const FrameData>& frame) override {
+        inFlight = frame;
+        return true;
+    }
+    Type getType() const override { return Type::NDI; }
+    std::string getId() const override { return "async"; }
+    std::string getDescription() const override { return "Fake async sender"; }
+
+    std::shared_ptr<const FrameData> inFlight;
+};
+
+void writeFrames(OutputSinkManager& manager, int count) {
+    for (int i = 0; i < count; ++i) {
+        FrameData frame;
+        frame.width = 4;
+        frame.height = 4;
+        frame.size = 64;
+        frame.data = new uint8_t[frame.size]();
+        frame.ownsData = true;
+        frame.frameNumber = i;
+        manager.writeFrameToAll(std::move(frame));
+    }
+}
+
+} // namespace
+
+bool test_OutputSinkManager_DropPolicies() {
+    OutputSinkManager manager;
+    auto oldest = std::make_unique<FakeSink>("oldest", OutputSink::DropPolicy::DROP_OLDEST, 2);
+    auto newest = std::make_unique<FakeSink>("newest", OutputSink::DropPolicy::DROP_NEWEST, 2);
+    auto fast = std::make_unique<FakeSink>("fast", OutputSink::DropPolicy::DROP_OLDEST, 16);
+    FakeSink* oldestSink = oldest.get();
+    FakeSink* newestSink = newest.get();
+    FakeSink* fastSink = fast.get();
+    oldestSink->hold();
+    newestSink->hold();
+    TEST_ASSERT(manager.addSink(std::move(oldest)));
+    TEST_ASSERT(manager.addSink(std::move(newest)));
+    TEST_ASSERT(manager.addSink(std::move(fast)));
+
+    // Two stalled sinks do not hold up the caller or the other sink
+    auto start = std::chrono::steady_clock::now();
+    writeFrames(manager, 10);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    TEST_ASSERT(elapsed < std::chrono::milliseconds(500));
+
+    oldestSink->release();
+    newestSink->release();
+    manager.flush();
+
+    std::vector<int64_t> all = fastSink->frames();
+    TEST_ASSERT_EQ(all.size(), static_cast<size_t>(10));
+    TEST_ASSERT_EQ(fastSink->getFramesDropped(), static_cast<int64_t>(0));
+
+    // Drop-oldest keeps the latest frames
+    std::vector<int64_t> kept = oldestSink->frames();
+    TEST_ASSERT(kept.size() >= 2 && kept.size() <= 3);
+    TEST_ASSERT_EQ(kept.back(), static_cast<int64_t>(9));
+    TEST_ASSERT_EQ(oldestSink->getFramesWritten() + oldestSink->getFramesDropped(), static_cast<int64_t>(10));
+
+    // Drop-newest keeps the first ones
+    kept = newestSink->frames();
+    TEST_ASSERT(kept.size() >= 2 && kept.size() <= 3);
+    TEST_ASSERT_EQ(kept.front(), static_cast<int64_t>(0));
+    TEST_ASSERT(std::find(kept.begin(), kept.end(), 9) == kept.end());
+    TEST_ASSERT_EQ(newestSink->getFramesWritten() + newestSink->getFramesDropped(), static_cast<int64_t>(10));
+
+    // One buffer per frame, shared by the sinks
+    TEST_ASSERT(oldestSink->dataOf(9) != nullptr);
+    TEST_ASSERT(oldestSink->dataOf(9) == fastSink->dataOf(9));
+
+    TEST_ASSERT_EQ(manager.getTotalFramesDropped(),
+                   oldestSink->getFramesDropped() + newestSink->getFramesDropped());
+    return true;
+}
+
+bool test_OutputSinkManager_BlockAndLatency() {
+    OutputSinkManager manager;
+    auto recorder = std::make_unique<FakeSink>("recorder", OutputSink::DropPolicy::BLOCK, 1);
+    FakeSink* sink = recorder.get();
+    sink->setDelayMs(5);
+    TEST_ASSERT(manager.addSink(std::move(recorder)));
+
+    // Blocking sinks lose nothing
+    writeFrames(manager, 10);
+    manager.flush();
+    std::vector<int64_t> frames = sink->frames();
+    TEST_ASSERT_EQ(frames.size(), static_cast<size_t>(10));
+    for (size_t i = 0; i < frames.size(); ++i) {
+        TEST_ASSERT_EQ(frames[i], static_cast<int64_t>(i));
+    }
+    TEST_ASSERT_EQ(sink->getFramesDropped(), static_cast<int64_t>(0));
+    TEST_ASSERT_EQ(manager.getTotalFramesWritten(), static_cast<int64_t>(10));
+
+    // Latency covers the queue and the write
+    TEST_ASSERT(sink->getLatencyMs() >= 4.0);
+
+    // Closed sinks get nothing queued
+    manager.closeAll();
+    writeFrames(manager, 3);
+    manager.flush();
+    TEST_ASSERT_EQ(sink->frames().size(), static_cast<size_t>(10));
+    return true;
+}
+
+bool test_OutputSinkManager_CaptureFormats() {
+    OutputSinkManager manager;
+    CaptureFormat nv12;
+    nv12.format = PixelFormat::NV12;
+    nv12.width = 1280;
+    nv12.height = 720;
+    
+    auto canvas = std::make_unique<FakeSink>("canvas", OutputSink::DropPolicy::BLOCK, 4);
+    auto encoderA = std::make_unique<FakeSink>("encoderA", OutputSink::DropPolicy::BLOCK, 4);
+    auto encoderB = std::make_unique<FakeSink>("encoderB", OutputSink::DropPolicy::BLOCK, 4);
+    encoderA->setCaptureFormat(nv12);
+    encoderB->setCaptureFormat(nv12);
+    FakeSink* canvasSink = canvas.get();
+    FakeSink* encoderSink = encoderA.get();
+    TEST_ASSERT(manager.addSink(std::move(canvas)));
+    TEST_ASSERT(manager.addSink(std::move(encoderA)));
+    TEST_ASSERT(manager.addSink(std::move(encoderB)));
+    
+    // One conversion per distinct format
+    std::vector<CaptureFormat> formats = manager.getCaptureFormats();
+    TEST_ASSERT_EQ(formats.size(), static_cast<size_t>(2));
+    TEST_ASSERT(std::find(formats.begin(), formats.end(), CaptureFormat()) != formats.end());
+    TEST_ASSERT(std::find(formats.begin(), formats.end(), nv12) != formats.end());
+    
+    // NV12 is 1.5 bytes per pixel
+    TEST_ASSERT_EQ(FrameData::frameSize(PixelFormat::NV12, 1280, 720), static_cast<size_t>(1280 * 720 * 3 / 2));
+    TEST_ASSERT_EQ(FrameData::frameSize(PixelFormat::RGBA32, 1280, 720), static_cast<size_t>(1280 * 720 * 4));
+    
+    // Frames only reach the sinks that asked for their format
+    FrameData frame;
+    frame.width = nv12.width;
+    frame.height = nv12.height;
+    frame.format = PixelFormat::NV12;
+    frame.size = FrameData::frameSize(frame.format, frame.width, frame.height);
+    frame.data = new uint8_t[frame.size]();
+    frame.ownsData = true;
+    frame.frameNumber = 7;
+    manager.writeFrameToFormat(std::move(frame), nv12);
+    manager.flush();
+    TEST_ASSERT(canvasSink->frames().empty());
+    TEST_ASSERT_EQ(encoderSink->frames().size(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(manager.getTotalFramesWritten(), static_cast<int64_t>(2));
+    return true;
+}
+
+bool test_OutputSinkManager_GpuSinks() {
+    OutputSinkManager manager;
+    auto gpu = std::make_unique<FakeGpuSink>();
+    auto cpu = std::make_unique<FakeSink>("cpu", OutputSink::DropPolicy::BLOCK, 4);
+    FakeGpuSink* gpuSink = gpu.get();
+    FakeSink* cpuSink = cpu.get();
+    TEST_ASSERT(!manager.writeTextureToGpuSinks(5, 1920, 1080, 0));
+    TEST_ASSERT(manager.addSink(std::move(gpu)));
+    TEST_ASSERT(manager.addSink(std::move(cpu)));
+    
+    // No readback is requested for GPU sinks
+    TEST_ASSERT_EQ(manager.getCaptureFormats().size(), static_cast<size_t>(1));
+    
+    // They get the texture, never CPU frames
+    TEST_ASSERT(manager.writeTextureToGpuSinks(5, 1920, 1080, 0));
+    TEST_ASSERT_EQ(gpuSink->lastTexture, static_cast<GLuint>(5));
+    writeFrames(manager, 3);
+    manager.flush();
+    TEST_ASSERT_EQ(gpuSink->cpuFrames.load(), 0);
+    TEST_ASSERT_EQ(cpuSink->frames().size(), static_cast<size_t>(3));
+    
+    // Refused textures count as drops
+    manager.writeTextureToGpuSinks(0, 1920, 1080, 0);
+    TEST_ASSERT_EQ(gpuSink->getFramesWritten(), static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(gpuSink->getFramesDropped(), static_cast<int64_t>(1));
+    return true;
+}
+
+bool test_OutputSinkManager_SharedFrames() {
+    OutputSinkManager manager;
+    auto async = std::make_unique<FakeAsyncSink>();
+    FakeAsyncSink* asyncSink = async.get();
+    TEST_ASSERT(manager.addSink(std::move(async)));
+    
+    // The sink keeps the queued frame itself, no copy
+    FrameData frame;
+    frame.width = 4;
+    frame.height = 4;
+    frame.size = 64;
+    frame.data = new uint8_t[frame.size]();
+    frame.ownsData = true;
+    frame.frameNumber = 7;
+    uint8_t* pixels = frame.data;
+    manager.setTimecode(1500, 25.0);
+    manager.writeFrameToAll(std::move(frame));
+    manager.flush();
+    
+    TEST_ASSERT(asyncSink->inFlight != nullptr);
+    TEST_ASSERT(asyncSink->inFlight->data == pixels);
+    TEST_ASSERT_EQ(asyncSink->inFlight->frameNumber, static_cast<int64_t>(7));
+    TEST_ASSERT_EQ(asyncSink->inFlight->timecode, static_cast<int64_t>(1500));
+    TEST_ASSERT_EQ(asyncSink->getFramesWritten(), static_cast<int64_t>(1));
+    return true;
+}
@@ -0,0 +1,59 @@
+#include "TestFramework.h"
+#include "../video/PackedAlpha.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+bool near(float a, float b) {
+    return std::fabs(a - b) < 1e-6f;
+}
+
+} // namespace
+
+bool test_PackedAlpha_Regions() {
+    PackedAlpha::Rect color;
+    PackedAlpha::Rect alpha;
+
+    // 1920x2160 stacked: two 1920x1080 pictures, inset one texel
+    PackedAlpha::regions(PackedAlpha::Layout::STACKED, 1920, 2160, 1.0f, color, alpha);
+    TEST_ASSERT_TRUE(near(color.offsetX, 1.0f / 1920.0f));
+    TEST_ASSERT_TRUE(near(color.offsetY, 1.0f / 2160.0f));
+    TEST_ASSERT_TRUE(near(color.scaleX, 1.0f - 2.0f / 1920.0f));
+    TEST_ASSERT_TRUE(near(color.scaleY, 0.5f - 2.0f / 2160.0f));
+    TEST_ASSERT_TRUE(near(alpha.offsetX, color.offsetX));
+    TEST_ASSERT_TRUE(near(alpha.offsetY, color.offsetY + 0.5f));
+    // Neither region reaches the seam
+    TEST_ASSERT_TRUE(color.offsetY + color.scaleY < 0.5f);
+    TEST_ASSERT_TRUE(alpha.offsetY > 0.5f);
+    TEST_ASSERT_TRUE(alpha.offsetY + alpha.scaleY < 1.0f);
+
+    PackedAlpha::regions(PackedAlpha::Layout::SIDE_BY_SIDE, 3840, 1080, 0.5f, color, alpha);
+    TEST_ASSERT_TRUE(near(color.scaleX, 0.5f - 1.0f / 3840.0f));
+    TEST_ASSERT_TRUE(near(alpha.offsetX, 0.5f + 0.5f / 3840.0f));
+    TEST_ASSERT_TRUE(near(alpha.offsetY, color.offsetY));
+
+    // Unpacked (or no frame yet): the whole texture
+    PackedAlpha::regions(PackedAlpha::Layout::NONE, 1920, 1080, 1.0f, color, alpha);
+    TEST_ASSERT_TRUE(near(color.offsetX, 0.0f) && near(color.scaleX, 1.0f) && near(color.scaleY, 1.0f));
+    PackedAlpha::regions(PackedAlpha::Layout::STACKED, 0, 0, 1.0f, color, alpha);
+    TEST_ASSERT_TRUE(near(color.scaleY, 1.0f));
+    return true;
+}
+
+bool test_PackedAlpha_AspectAndNames() {
+    TEST_ASSERT_TRUE(near(PackedAlpha::pictureAspect(PackedAlpha::Layout::STACKED, 1920.0f / 2160.0f), 16.0f / 9.0f));
+    TEST_ASSERT_TRUE(near(PackedAlpha::pictureAspect(PackedAlpha::Layout::SIDE_BY_SIDE, 3840.0f / 1080.0f), 16.0f / 9.0f));
+    TEST_ASSERT_TRUE(near(PackedAlpha::pictureAspect(PackedAlpha::Layout::NONE, 1.5f), 1.5f));
+
+    PackedAlpha::Layout layout = PackedAlpha::Layout::NONE;
+    TEST_ASSERT_TRUE(PackedAlpha::parseLayout("top_bottom", layout));
+    TEST_ASSERT_TRUE(layout == PackedAlpha::Layout::STACKED);
+    TEST_ASSERT_TRUE(PackedAlpha::parseLayout(PackedAlpha::layoutName(PackedAlpha::Layout::SIDE_BY_SIDE), layout));
+    TEST_ASSERT_TRUE(layout == PackedAlpha::Layout::SIDE_BY_SIDE);
+    TEST_ASSERT_FALSE(PackedAlpha::parseLayout("over_under", layout));
+    TEST_ASSERT_TRUE(layout == PackedAlpha::Layout::SIDE_BY_SIDE);
+    return true;
+}
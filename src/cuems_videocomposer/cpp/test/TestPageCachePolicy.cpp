@@ -0,0 +1,57 @@
+#include "TestFramework.h"
+#include "../input/PageCachePolicy.h"
+#include <string>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_PageCachePolicy_DropBehindPlayheads() {
+    const int64_t MB = 1024 * 1024;
+    const std::string path = "/nonexistent/cvc_show.mov";  // Only the bookkeeping is checked
+
+    PageCachePolicy policy;
+    policy.configure(true, 16 * MB, 8 * MB);
+
+    // The opening of the file is never dropped
+    PageCachePolicy::ClientId a = policy.addPlayhead(path);
+    TEST_ASSERT_TRUE(a != 0);
+    policy.updatePlayhead(a, 10 * MB);
+    TEST_ASSERT_EQ(policy.getStats().drops, static_cast<uint64_t>(0));
+
+    // Far enough ahead: everything from the opening to keepBehind goes
+    policy.updatePlayhead(a, 40 * MB);
+    PageCachePolicy::Stats stats = policy.getStats();
+    TEST_ASSERT_EQ(stats.drops, static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(stats.droppedBytes, static_cast<uint64_t>(16 * MB));
+
+    // A second layer that has not played yet holds drops back
+    PageCachePolicy::ClientId b = policy.addPlayhead(path);
+    policy.updatePlayhead(a, 80 * MB);
+    TEST_ASSERT_EQ(policy.getStats().drops, static_cast<uint64_t>(1));
+
+    // Drops follow the slowest playhead, and skip prefetched ranges
+    policy.updatePlayhead(b, 20 * MB);
+    policy.prefetch(path, 30 * MB);
+    policy.updatePlayhead(b, 60 * MB);
+    stats = policy.getStats();
+    TEST_ASSERT_EQ(stats.drops, static_cast<uint64_t>(2));
+    TEST_ASSERT_EQ(stats.droppedBytes, static_cast<uint64_t>((16 + 14 + 6) * MB));
+    TEST_ASSERT_EQ(stats.prefetches, static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(stats.protectedRanges, static_cast<size_t>(1));
+    TEST_ASSERT_EQ(stats.playheads, static_cast<size_t>(2));
+
+    // Small steps are batched
+    policy.updatePlayhead(b, 62 * MB);
+    TEST_ASSERT_EQ(policy.getStats().drops, static_cast<uint64_t>(2));
+
+    policy.removePlayhead(a);
+    policy.removePlayhead(b);
+    TEST_ASSERT_EQ(policy.getStats().playheads, static_cast<size_t>(0));
+
+    // Disabled: nothing is tracked
+    policy.configure(false, 16 * MB, 8 * MB);
+    TEST_ASSERT_EQ(policy.addPlayhead(path), static_cast<PageCachePolicy::ClientId>(0));
+    policy.prefetch(path);
+    TEST_ASSERT_EQ(policy.getStats().prefetches, static_cast<uint64_t>(1));
+    return true;
+}
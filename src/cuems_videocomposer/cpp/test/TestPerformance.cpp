@@ -0,0 +1,322 @@
+#include "TestFramework.h"
+#include "PerfBaseline.h"
+#include "../sync/MTCDecoder.h"
+#include "../sync/FramerateConverterSyncSource.h"
+#include "../layer/LayerManager.h"
+#include "../layer/VideoLayer.h"
+#include "../input/InputSource.h"
+#include "../video/FrameBuffer.h"
+#include "../display/CPUImageProcessor.h"
+#include "../remote/CommandArgs.h"
+#include "../remote/CommandTable.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+/**
+ * Performance tests of hot paths, against stored baselines (PerfBaseline)
+ * Run with cuems_videocomposer_test --perf (ctest -L perf).
+ */
+
+namespace {
+
+constexpr int MANY_LAYERS = 128;
+
+class PerfInputSource : public InputSource {
+public:
+    FrameInfo info;
+
+    PerfInputSource() {
+        info.width = 1920;
+        info.height = 1080;
+        info.framerate = 24000.0 / 1001.0;
+        info.framerateNum = 24000;
+        info.framerateDen = 1001;
+        info.totalFrames = 100000;
+        info.format = PixelFormat::BGRA32;
+    }
+
+    bool open(const std::string&) override { return true; }
+    void close() override {}
+    bool seek(int64_t) override { return true; }
+    bool readFrame(int64_t, FrameBuffer&) override { return true; }
+    FrameInfo getFrameInfo() const override { return info; }
+    bool isReady() const override { return true; }
+    int64_t getCurrentFrame() const override { return 0; }
+    CodecType detectCodec() const override { return CodecType::SOFTWARE; }
+    bool supportsDirectGPUTexture() const override { return false; }
+    DecodeBackend getOptimalBackend() const override { return DecodeBackend::CPU_SOFTWARE; }
+};
+
+class PerfSyncSource : public SyncSource {
+public:
+    int64_t frame = 0;
+
+    bool connect(const char*) override { return true; }
+    void disconnect() override {}
+    bool isConnected() const override { return true; }
+    int64_t pollFrame(uint8_t* rolling = nullptr) override {
+        if (rolling) {
+            *rolling = 1;
+        }
+        return frame;
+    }
+    int64_t getCurrentFrame() const override { return frame; }
+    const char* getName() const override { return "Perf"; }
+    double getFramerate() const override { return 30000.0 / 1001.0; }
+};
+
+std::string cueName(int index) {
+    return "cue-" + std::to_string(index);
+}
+
+std::unique_ptr<LayerManager> manyLayers(std::vector<int>& ids) {
+    auto manager = std::make_unique<LayerManager>();
+    for (int i = 0; i < MANY_LAYERS; ++i) {
+        auto layer = std::make_unique<VideoLayer>();
+        layer->setInputSource(std::make_unique<PerfInputSource>());
+        manager->addLayerWithId(cueName(i), std::move(layer));
+        ids.push_back(manager->getLayerByCueId(cueName(i))->getLayerId());
+    }
+    return manager;
+}
+
+FrameInfo frame1080p() {
+    FrameInfo info;
+    info.width = 1920;
+    info.height = 1080;
+    info.format = PixelFormat::BGRA32;
+    return info;
+}
+
+} // namespace
+
+bool test_Perf_MTCDecoder() {
+    // One full timecode per 8 quarter frames, as an MTC stream carries them
+    const uint8_t quarterFrames[] = {0x09, 0x10, 0x21, 0x33, 0x40, 0x50, 0x60, 0x72};
+    MTCDecoder decoder;
+    double ns = PerfBaseline::measure([&](uint64_t iterations) {
+        int64_t total = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            if (decoder.processByte(quarterFrames[i & 7])) {
+                total += decoder.timecodeToFrame(25.0);
+            }
+        }
+        keepValue(total);
+    });
+    TEST_ASSERT_PERF("mtc.quarter_frame", ns);
+    return true;
+}
+
+bool test_Perf_LayerManager() {
+    std::vector<int> ids;
+    std::unique_ptr<LayerManager> manager = manyLayers(ids);
+    TEST_ASSERT_EQ(manager->getLayerCount(), static_cast<size_t>(MANY_LAYERS));
+
+    std::vector<std::string> cues;
+    for (int i = 0; i < MANY_LAYERS; ++i) {
+        cues.push_back(cueName(i));
+    }
+    double lookup = PerfBaseline::measure([&](uint64_t iterations) {
+        size_t found = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            found += manager->getLayerByCueId(cues[i % MANY_LAYERS]) != nullptr;
+            found += manager->getLayer(ids[(i * 7) % MANY_LAYERS]) != nullptr;
+        }
+        keepValue(found);
+    });
+    TEST_ASSERT_PERF("layers128.lookup", lookup);
+
+    double reorder = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            int id = ids[i % MANY_LAYERS];
+            manager->moveLayerUp(id);
+            manager->moveLayerDown(id);
+        }
+    });
+    TEST_ASSERT_PERF("layers128.reorder", reorder);
+
+    double snapshot = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            manager->getLayer(ids[i % MANY_LAYERS])->properties().opacity = (i & 1) ? 0.5f : 1.0f;
+            manager->publishSnapshot();
+        }
+    });
+    TEST_ASSERT_PERF("layers128.snapshot", snapshot);
+
+    double addRemove = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            auto layer = std::make_unique<VideoLayer>();
+            layer->setInputSource(std::make_unique<PerfInputSource>());
+            manager->addLayerWithId("extra", std::move(layer));
+            manager->removeLayerByCueId("extra");
+        }
+    });
+    TEST_ASSERT_PERF("layers128.add_remove", addRemove);
+    TEST_ASSERT_EQ(manager->getLayerCount(), static_cast<size_t>(MANY_LAYERS));
+    return true;
+}
+
+bool test_Perf_FrameBuffer() {
+    FrameBuffer source;
+    TEST_ASSERT_TRUE(source.allocate(frame1080p()));
+
+    // Copies share the pixels; the first write makes the writer's own copy
+    double copy = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            const FrameBuffer copied(source);
+            keepValue(copied.data()[i % copied.size()]);
+        }
+    });
+    TEST_ASSERT_PERF("framebuffer.copy_1080p", copy);
+
+    double write = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            FrameBuffer copied(source);
+            copied.data()[i % copied.size()] = 1;
+        }
+    });
+    TEST_ASSERT_PERF("framebuffer.copy_write_1080p", write);
+
+    // Copy assignment shares too, whatever the target held
+    FrameBuffer target;
+    TEST_ASSERT_TRUE(target.allocate(frame1080p()));
+    double assign = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            target = source;
+        }
+        keepValue(target.data()[0]);
+    });
+    TEST_ASSERT_PERF("framebuffer.assign_1080p", assign);
+
+    double move = PerfBaseline::measure([&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            FrameBuffer moved(std::move(source));
+            source = std::move(moved);
+        }
+    });
+    TEST_ASSERT_PERF("framebuffer.move", move);
+    TEST_ASSERT_TRUE(source.isValid());
+
+    double reuse = PerfBaseline::measure([&](uint64_t iterations) {
+        bool ok = true;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            ok = target.ensureAllocated(frame1080p()) && ok;
+        }
+        keepValue(ok);
+    });
+    TEST_ASSERT_PERF("framebuffer.ensure_allocated", reuse);
+    return true;
+}
+
+bool test_Perf_OSCDispatch() {
+    // The router's path handling: prefix, layer UUID, command table, handler
+    // (RemoteCommandRouter itself needs the application)
+    std::vector<int> ids;
+    std::unique_ptr<LayerManager> manager = manyLayers(ids);
+    using LayerHandler = std::function<bool(VideoLayer*, const CommandArgs&)>;
+    CommandTable<LayerHandler> commands;
+    const char* names[] = {"opacity", "visible", "position", "scale", "rotation", "crop", "blend", "zorder",
+                           "fade", "seek", "play", "pause", "loop", "offset", "timescale", "mute"};
+    for (const char* name : names) {
+        commands.insert(name, [](VideoLayer* layer, const CommandArgs& args) {
+            layer->properties().opacity = args.empty() ? 1.0f : args[0].toFloat();
+            return true;
+        });
+    }
+    std::vector<std::string> paths;
+    for (int i = 0; i < MANY_LAYERS; ++i) {
+        paths.push_back("/videocomposer/layer/" + cueName(i) + "/" + names[i % 16]);
+    }
+
+    CommandArgs args;
+    double ns = PerfBaseline::measure([&](uint64_t iterations) {
+        size_t handled = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            args.clear();
+            args.addFloat(0.5f);
+            std::string_view path = paths[i % MANY_LAYERS];
+            path.remove_prefix(21);  // "/videocomposer/layer/"
+            size_t slash = path.find('/');
+            VideoLayer* layer = manager->getLayerByCueId(path.substr(0, slash));
+            const LayerHandler* handler = layer ? commands.find(path.substr(slash + 1)) : nullptr;
+            handled += handler && (*handler)(layer, args);
+        }
+        keepValue(handled);
+    });
+    TEST_ASSERT_PERF("osc.layer_dispatch", ns);
+    return true;
+}
+
+bool test_Perf_FramerateConverter() {
+    // 29.97 timecode driving 23.976 media, the common pulldown case
+    PerfSyncSource sync;
+    PerfInputSource input;
+    FramerateConverterSyncSource converter(&sync, &input);
+    double ns = PerfBaseline::measure([&](uint64_t iterations) {
+        int64_t total = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            sync.frame = static_cast<int64_t>(i);
+            total += converter.pollFrame();
+        }
+        keepValue(total);
+    });
+    TEST_ASSERT_PERF("framerate_converter.poll", ns);
+    return true;
+}
+
+bool test_Perf_CPUImageProcessor() {
+    CPUImageProcessor processor;
+    FrameBuffer input;
+    TEST_ASSERT_TRUE(input.allocate(frame1080p()));
+    FrameBuffer output;
+
+    struct Kernel {
+        const char* name;
+        LayerProperties properties;
+        bool transform = false;  // Scale/rotation too (CPUImageProcessor::transform)
+    };
+    std::vector<Kernel> kernels(6);
+    kernels[0].name = "cpu_image.copy_1080p";
+    kernels[1].name = "cpu_image.crop_1080p";
+    kernels[1].properties.crop.enabled = true;
+    kernels[1].properties.crop.x = 480;
+    kernels[1].properties.crop.y = 270;
+    kernels[1].properties.crop.width = 960;
+    kernels[1].properties.crop.height = 540;
+    kernels[2].name = "cpu_image.panorama_1080p";
+    kernels[2].properties.panoramaMode = true;
+    kernels[2].properties.panOffset = 320;
+    kernels[3].name = "cpu_image.scale_1080p";
+    kernels[3].transform = true;
+    kernels[3].properties.scaleX = 0.75f;
+    kernels[3].properties.scaleY = 0.75f;
+    kernels[4].name = "cpu_image.rotate_1080p";
+    kernels[4].transform = true;
+    kernels[4].properties.rotation = 30.0f;
+    kernels[5].name = "cpu_image.crop_scale_rotate_1080p";
+    kernels[5].transform = true;
+    kernels[5].properties = kernels[1].properties;
+    kernels[5].properties.scaleX = 2.0f;
+    kernels[5].properties.scaleY = 2.0f;
+    kernels[5].properties.rotation = 90.0f;
+
+    for (const Kernel& kernel : kernels) {
+        bool ok = true;
+        double ns = PerfBaseline::measure([&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                ok = (kernel.transform
+                      ? processor.transform(input, output, kernel.properties, input.info())
+                      : processor.processCPU(input, output, kernel.properties, input.info())) && ok;
+            }
+        });
+        TEST_ASSERT_TRUE(ok);
+        TEST_ASSERT_PERF(kernel.name, ns);
+    }
+    return true;
+}
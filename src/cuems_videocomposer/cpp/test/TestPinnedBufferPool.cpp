@@ -0,0 +1,46 @@
+#include "TestFramework.h"
+#include "../video/PinnedBufferPool.h"
+#include <cstdint>
+#include <cstring>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_PinnedBufferPool_Reuse() {
+    PinnedBufferPool pool(2);
+    const size_t frameBytes = 1920 * 1080 * 2;
+
+    void* a = pool.acquire(frameBytes);
+    void* b = pool.acquire(frameBytes);
+    TEST_ASSERT_TRUE(a && b && a != b);
+    TEST_ASSERT_EQ(reinterpret_cast<uintptr_t>(a) % PinnedBufferPool::ALIGNMENT, 0u);
+    std::memset(a, 0x80, frameBytes);
+    TEST_ASSERT_EQ(pool.getOutstandingCount(), 2u);
+
+    // Released buffers come back instead of new allocations
+    pool.release(a);
+    TEST_ASSERT_EQ(pool.getFreeCount(), 1u);
+    void* c = pool.acquire(frameBytes);
+    TEST_ASSERT_TRUE(c == a);
+    TEST_ASSERT_EQ(pool.getAllocationCount(), 2u);
+
+    // A smaller frame fits, a larger one needs its own
+    pool.release(c);
+    TEST_ASSERT_TRUE(pool.acquire(720 * 576 * 2) == a);
+    void* large = pool.acquire(frameBytes * 4);
+    TEST_ASSERT_TRUE(large != nullptr);
+    TEST_ASSERT_EQ(pool.getAllocationCount(), 3u);
+
+    // At most maxFree are kept
+    pool.release(a);
+    pool.release(b);
+    pool.release(large);
+    TEST_ASSERT_EQ(pool.getFreeCount(), 2u);
+    TEST_ASSERT_EQ(pool.getOutstandingCount(), 0u);
+    pool.release(nullptr);
+    pool.release(b);  // Not outstanding any more: ignored
+    TEST_ASSERT_EQ(pool.getFreeCount(), 2u);
+    pool.trim();
+    TEST_ASSERT_EQ(pool.getFreeCount(), 0u);
+    return true;
+}
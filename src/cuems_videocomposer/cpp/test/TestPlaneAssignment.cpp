@@ -0,0 +1,81 @@
+#include "TestFramework.h"
+#include "../display/drm/PlaneAssignment.h"
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+PlaneCandidate layer(float x0, float y0, float x1, float y1, bool eligible = true, int output = 0) {
+    PlaneCandidate candidate;
+    candidate.eligible = eligible;
+    candidate.output = eligible ? output : -1;
+    candidate.x0 = x0;
+    candidate.y0 = y0;
+    candidate.x1 = x1;
+    candidate.y1 = y1;
+    return candidate;
+}
+
+} // namespace
+
+bool test_PlaneAssignment_PictureInPicture() {
+    // Full-screen background (composited), two insets over it
+    std::vector<PlaneCandidate> layers = {
+        layer(0, 0, 1920, 1080, false),
+        layer(100, 100, 580, 370),
+        layer(1340, 100, 1820, 370),
+    };
+    std::vector<size_t> chosen = PlaneAssignment::choose(layers, {2});
+    TEST_ASSERT_EQ(chosen.size(), 2u);
+    TEST_ASSERT_EQ(chosen[0], 1u);   // Bottom first: the lower plane
+    TEST_ASSERT_EQ(chosen[1], 2u);
+
+    // One plane: the top inset gets it
+    chosen = PlaneAssignment::choose(layers, {1});
+    TEST_ASSERT_EQ(chosen.size(), 1u);
+    TEST_ASSERT_EQ(chosen[0], 2u);
+
+    // No planes, or none on that output
+    TEST_ASSERT_TRUE(PlaneAssignment::choose(layers, {}).empty());
+    TEST_ASSERT_TRUE(PlaneAssignment::choose(layers, {0, 2}).empty());
+    return true;
+}
+
+bool test_PlaneAssignment_CompositedAboveBlocks() {
+    // A composited title over the first inset keeps it in the composite
+    std::vector<PlaneCandidate> layers = {
+        layer(100, 100, 580, 370),
+        layer(1340, 100, 1820, 370),
+        layer(400, 300, 900, 400, false),
+    };
+    std::vector<size_t> chosen = PlaneAssignment::choose(layers, {4});
+    TEST_ASSERT_EQ(chosen.size(), 1u);
+    TEST_ASSERT_EQ(chosen[0], 1u);
+
+    // Edges touching is no overlap
+    layers[2] = layer(580, 100, 1340, 370, false);
+    TEST_ASSERT_EQ(PlaneAssignment::choose(layers, {4}).size(), 2u);
+
+    // A plane layer above another is fine: planes keep the order
+    layers = {
+        layer(100, 100, 580, 370),
+        layer(300, 200, 800, 500),
+    };
+    TEST_ASSERT_EQ(PlaneAssignment::choose(layers, {2}).size(), 2u);
+
+    // Out of planes, the top layer is composited and hides the one below
+    chosen = PlaneAssignment::choose({layer(100, 100, 580, 370, true, 0), layer(300, 200, 800, 500, true, 1)},
+                                     {1, 0});
+    TEST_ASSERT_TRUE(chosen.empty());
+
+    // Per output counts
+    chosen = PlaneAssignment::choose({layer(0, 0, 100, 100, true, 0), layer(2000, 0, 2100, 100, true, 1),
+                                      layer(200, 0, 300, 100, true, 0)},
+                                     {1, 1});
+    TEST_ASSERT_EQ(chosen.size(), 2u);
+    TEST_ASSERT_EQ(chosen[0], 1u);
+    TEST_ASSERT_EQ(chosen[1], 2u);
+    return true;
+}
@@ -0,0 +1,53 @@
+#include "TestFramework.h"
+#include "../output/PlayoutSchedule.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_PlayoutSchedule_Slots() {
+    using Completion = PlayoutSchedule::Completion;
+    PlayoutSchedule schedule;
+    schedule.reset(1000, 25000);  // 25 fps
+
+    // Consecutive slots, playback starts after the preroll
+    int64_t time = -1;
+    for (int i = 0; i < PlayoutSchedule::PREROLL; ++i) {
+        TEST_ASSERT_FALSE(schedule.readyToStart());
+        TEST_ASSERT_TRUE(schedule.next(time));
+        TEST_ASSERT_EQ(time, static_cast<int64_t>(i) * 1000);
+        schedule.scheduled();
+    }
+    TEST_ASSERT_TRUE(schedule.readyToStart());
+    schedule.started();
+    TEST_ASSERT_FALSE(schedule.readyToStart());
+
+    // A fast render loop is held at MAX_AHEAD
+    while (schedule.getInFlight() < PlayoutSchedule::MAX_AHEAD) {
+        TEST_ASSERT_TRUE(schedule.next(time));
+        schedule.scheduled();
+    }
+    TEST_ASSERT_EQ(time, static_cast<int64_t>(PlayoutSchedule::MAX_AHEAD - 1) * 1000);
+    TEST_ASSERT_FALSE(schedule.next(time));
+    schedule.completed(Completion::DISPLAYED, 1000);
+    TEST_ASSERT_TRUE(schedule.next(time));
+    TEST_ASSERT_EQ(time, static_cast<int64_t>(PlayoutSchedule::MAX_AHEAD) * 1000);
+    schedule.scheduled();
+
+    // Late output skips the slots already due instead of queueing behind them
+    schedule.completed(Completion::LATE, 40000);
+    TEST_ASSERT_EQ(schedule.getLateCount(), 1u);
+    TEST_ASSERT_TRUE(schedule.next(time));
+    TEST_ASSERT_EQ(time, static_cast<int64_t>(40 + PlayoutSchedule::PREROLL) * 1000);
+    schedule.scheduled();
+    schedule.completed(Completion::DISPLAYED, 41000);
+    TEST_ASSERT_TRUE(schedule.next(time));
+    TEST_ASSERT_EQ(time, static_cast<int64_t>(41 + PlayoutSchedule::PREROLL) * 1000);
+
+    // Flushed frames only free their slot
+    schedule.completed(Completion::DROPPED, 10000);
+    TEST_ASSERT_EQ(schedule.getDroppedCount(), 1u);
+    schedule.completed(Completion::FLUSHED, 0);
+    TEST_ASSERT_EQ(schedule.getOutputFrame(45500), 45);
+    TEST_ASSERT_EQ(schedule.getOutputFrame(-1), 0);
+    return true;
+}
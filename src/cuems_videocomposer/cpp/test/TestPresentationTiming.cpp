@@ -0,0 +1,107 @@
+#include "TestFramework.h"
+#include "../display/drm/PresentationTiming.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_PresentationTiming_PredictNextVsync() {
+    PresentationTiming timing;
+    timing.init(50.0);  // 20 ms
+    const int64_t vsync = 20000000;
+
+    // No flip yet: nothing to extrapolate from
+    TEST_ASSERT_EQ(timing.predictNextVsync(0), static_cast<int64_t>(0));
+    TEST_ASSERT_EQ(timing.getTimeToNextVsync(), static_cast<int64_t>(0));
+
+    // First flip at 10 s: the expected duration is used
+    timing.recordFlip(10, 0, 500);
+    const int64_t flip = 10000000000LL;
+    TEST_ASSERT_EQ(timing.predictNextVsync(flip), flip + vsync);
+    TEST_ASSERT_EQ(timing.predictNextVsync(flip + 5000000), flip + vsync);
+    TEST_ASSERT_EQ(timing.predictNextVsync(flip + vsync), flip + 2 * vsync);
+    TEST_ASSERT_EQ(timing.predictNextVsync(flip + 3 * vsync + 1), flip + 4 * vsync);
+    // Before the last flip: that flip is the next vsync
+    TEST_ASSERT_EQ(timing.predictNextVsync(flip - 1), flip);
+
+    // Measured duration wins over the nominal one (display really at 50.05 Hz)
+    timing.recordFlip(10, 39960, 502);
+    const int64_t measured = 19980000;
+    const int64_t second = flip + 2 * measured;
+    TEST_ASSERT_EQ(timing.getVsyncDuration(), measured);
+    TEST_ASSERT_EQ(timing.predictNextVsync(second + 1), second + measured);
+    TEST_ASSERT_EQ(timing.predictNextVsync(second + 10 * measured), second + 11 * measured);
+    return true;
+}
+
+bool test_PresentationTiming_BufferStats() {
+    PresentationTiming timing;
+    timing.init(50.0);
+
+    // Displayed, pending and queued: a full triple-buffered chain
+    timing.recordQueueDepth(2);
+    timing.recordQueueDepth(3);
+    timing.recordBufferReplaced();
+    timing.recordQueueDepth(2);
+
+    // Finished 5 ms and 25 ms before their flips
+    timing.recordFlip(10, 0, 500);
+    timing.recordBufferPresented(10000000000LL - 5000000);
+    timing.recordFlip(10, 20000, 501);
+    timing.recordBufferPresented(10020000000LL - 25000000);
+    // Unknown completion time: counted, not aged
+    timing.recordFlip(10, 40000, 502);
+    timing.recordBufferPresented(0);
+
+    BufferQueueStats stats = timing.getBufferStats();
+    TEST_ASSERT_EQ(stats.queueDepth, 2);
+    TEST_ASSERT_EQ(stats.maxQueueDepth, 3);
+    TEST_ASSERT_EQ(stats.replaced, static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(stats.presented, static_cast<int64_t>(3));
+    TEST_ASSERT_EQ(stats.lastBufferAgeNs, static_cast<int64_t>(25000000));
+    TEST_ASSERT_EQ(stats.maxBufferAgeNs, static_cast<int64_t>(25000000));
+    TEST_ASSERT_EQ(stats.totalBufferAgeNs, static_cast<int64_t>(30000000));
+
+    // A new refresh rate starts the statistics over, keeping the depth
+    timing.init(60.0);
+    stats = timing.getBufferStats();
+    TEST_ASSERT_EQ(stats.presented, static_cast<int64_t>(0));
+    TEST_ASSERT_EQ(stats.queueDepth, 2);
+    TEST_ASSERT_EQ(stats.maxQueueDepth, 2);
+    return true;
+}
+
+bool test_PresentationTiming_FrameLog() {
+    PresentationTiming timing;
+    timing.init(60.0);
+
+    // Off by default
+    timing.recordFlip(10, 0, 600);
+    timing.recordPresentedFrame(7);
+    std::vector<PresentedFrame> frames;
+    timing.takePresentedFrames(frames);
+    TEST_ASSERT_TRUE(frames.empty());
+
+    timing.setFrameLogEnabled(true);
+    timing.recordFlip(10, 16667, 601);
+    timing.recordPresentedFrame(8);
+    timing.recordFlip(10, 33333, 602);
+    timing.recordPresentedFrame(-1);
+    timing.takePresentedFrames(frames);
+    TEST_ASSERT_EQ(frames.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(frames[0].msc, static_cast<int64_t>(601));
+    TEST_ASSERT_EQ(frames[0].flipNs, static_cast<int64_t>(10016667000LL));
+    TEST_ASSERT_EQ(frames[0].tag, static_cast<int64_t>(8));
+    TEST_ASSERT_EQ(frames[1].tag, static_cast<int64_t>(-1));
+
+    // Taken once; bounded while nobody takes them
+    frames.clear();
+    timing.takePresentedFrames(frames);
+    TEST_ASSERT_TRUE(frames.empty());
+    for (size_t i = 0; i < PresentationTiming::FRAME_LOG_LIMIT + 10; ++i) {
+        timing.recordPresentedFrame(static_cast<int64_t>(i));
+    }
+    timing.takePresentedFrames(frames);
+    TEST_ASSERT_EQ(frames.size(), PresentationTiming::FRAME_LOG_LIMIT);
+    TEST_ASSERT_EQ(frames.front().tag, static_cast<int64_t>(10));
+    return true;
+}
@@ -0,0 +1,70 @@
+#include "TestFramework.h"
+#include "../display/PreviewGrid.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+bool overlaps(const CanvasRect& a, const CanvasRect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+} // namespace
+
+bool test_PreviewGrid_Layout() {
+    TEST_ASSERT(PreviewGrid::layout(0, 640, 360).empty());
+    TEST_ASSERT(PreviewGrid::layout(3, 0, 360).empty());
+
+    // Program alone fills the atlas
+    std::vector<CanvasRect> tiles = PreviewGrid::layout(1, 640, 360);
+    TEST_ASSERT(tiles.size() == 1);
+    TEST_ASSERT(tiles[0] == (CanvasRect{0, 0, 640, 360}));
+
+    // Program and four layers: 3 x 2, program at the top left
+    tiles = PreviewGrid::layout(5, 640, 360);
+    TEST_ASSERT(tiles.size() == 5);
+    TEST_ASSERT(tiles[0].x == 0 && tiles[0].y + tiles[0].height == 360);
+    TEST_ASSERT(tiles[3].x == 0 && tiles[3].y == 0);
+    TEST_ASSERT(tiles[1].y == tiles[0].y && tiles[1].x > tiles[0].x);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        TEST_ASSERT(tiles[i].width == (640 - 2 * 2) / 3 && tiles[i].height == (360 - 2) / 2);
+        TEST_ASSERT(tiles[i].x + tiles[i].width <= 640 && tiles[i].y + tiles[i].height <= 360);
+        for (size_t j = i + 1; j < tiles.size(); ++j) {
+            TEST_ASSERT(!overlaps(tiles[i], tiles[j]));
+        }
+    }
+
+    // Stored top row first: the program is at y = 0
+    tiles = PreviewGrid::layout(5, 640, 360, true);
+    TEST_ASSERT(tiles[0].y == 0 && tiles[3].y == tiles[0].height + 2);
+    return true;
+}
+
+bool test_PreviewGrid_Pacer() {
+    PreviewPacer pacer(5.0, 1.0);
+    TEST_ASSERT(pacer.isDue(0));
+    pacer.markRendered(1000000);
+    TEST_ASSERT(!pacer.isDue(1100000));
+    TEST_ASSERT(pacer.isDue(1200000));
+
+    // Three times the budget: a third of the rate
+    pacer.reportGpuTime(3.0);
+    TEST_ASSERT(pacer.getStretch() == 3.0);
+    pacer.markRendered(1200000);
+    TEST_ASSERT(!pacer.isDue(1700000));
+    TEST_ASSERT(pacer.isDue(1800000));
+
+    // Way over is capped, back under budget restores the rate
+    pacer.reportGpuTime(100.0);
+    TEST_ASSERT(pacer.getStretch() == PreviewPacer::MAX_STRETCH);
+    pacer.reportGpuTime(0.4);
+    TEST_ASSERT(pacer.getStretch() == 1.0);
+    TEST_ASSERT(pacer.getRenderCount() == 2);
+
+    // Nonsense settings fall back to sane ones
+    pacer.setRate(0.0);
+    pacer.setBudget(-1.0);
+    TEST_ASSERT(pacer.getRate() > 0.0 && pacer.getBudget() > 0.0);
+    return true;
+}
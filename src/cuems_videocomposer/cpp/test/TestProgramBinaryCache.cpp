@@ -0,0 +1,60 @@
+#include "TestFramework.h"
+#include "../display/ProgramBinaryCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_ProgramBinaryCache_RoundTrip() {
+    char tmpl[] = "/tmp/cvc_progcache_XXXXXX";
+    const char* created = mkdtemp(tmpl);
+    TEST_ASSERT_TRUE(created != nullptr);
+    // Nested directory is created on first store
+    ProgramBinaryCache cache(std::string(created) + "/shaders");
+
+    // Key depends on driver and both sources
+    uint64_t key = ProgramBinaryCache::keyFor("Mesa\nIntel\n4.6\n", "vs", "fs");
+    TEST_ASSERT(key != ProgramBinaryCache::keyFor("Mesa\nAMD\n4.6\n", "vs", "fs"));
+    TEST_ASSERT(key != ProgramBinaryCache::keyFor("Mesa\nIntel\n4.6\n", "vs", "fs2"));
+    TEST_ASSERT(ProgramBinaryCache::keyFor("d", "ab", "c") != ProgramBinaryCache::keyFor("d", "a", "bc"));
+
+    uint32_t format = 0;
+    std::vector<uint8_t> binary;
+    TEST_ASSERT_FALSE(cache.load(key, format, binary));
+
+    const uint8_t blob[] = {1, 2, 3, 4, 5, 6, 7};
+    TEST_ASSERT_TRUE(cache.store(key, 0x8741, blob, sizeof(blob)));
+    TEST_ASSERT_TRUE(cache.load(key, format, binary));
+    TEST_ASSERT_EQ(format, static_cast<uint32_t>(0x8741));
+    TEST_ASSERT_EQ(binary.size(), sizeof(blob));
+    TEST_ASSERT(binary[6] == 7);
+
+    // Another key is a miss, even if its file holds a valid binary
+    uint64_t other = key + 1;
+    TEST_ASSERT_FALSE(cache.load(other, format, binary));
+    std::rename(cache.cachePathFor(key).c_str(), cache.cachePathFor(other).c_str());
+    TEST_ASSERT_FALSE(cache.load(other, format, binary));
+    cache.invalidate(other);
+
+    // Truncated file is stale
+    TEST_ASSERT_TRUE(cache.store(key, 0x8741, blob, sizeof(blob)));
+    TEST_ASSERT_EQ(truncate(cache.cachePathFor(key).c_str(), 20), 0);
+    TEST_ASSERT_FALSE(cache.load(key, format, binary));
+
+    // Disabled: no reads or writes
+    TEST_ASSERT_TRUE(cache.store(key, 0x8741, blob, sizeof(blob)));
+    cache.configure(false, std::string(created) + "/shaders");
+    TEST_ASSERT_FALSE(cache.load(key, format, binary));
+    TEST_ASSERT_FALSE(cache.store(key, 0x8741, blob, sizeof(blob)));
+    cache.configure(true, std::string(created) + "/shaders");
+    TEST_ASSERT_TRUE(cache.load(key, format, binary));
+
+    cache.invalidate(key);
+    TEST_ASSERT_FALSE(cache.load(key, format, binary));
+    rmdir((std::string(created) + "/shaders").c_str());
+    rmdir(created);
+    return true;
+}
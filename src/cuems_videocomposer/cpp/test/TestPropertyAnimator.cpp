@@ -0,0 +1,90 @@
+#include "TestFramework.h"
+#include "../layer/PropertyAnimator.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+bool near(float a, float b) {
+    return std::fabs(a - b) < 1e-4f;
+}
+
+} // namespace
+
+bool test_PropertyAnimator_Fade() {
+    LayerProperties props;
+    PropertyAnimator animator;
+    using P = PropertyAnimator::Property;
+
+    // 1 s fade out, then a move, both driven by presentation time only
+    animator.animate(P::OPACITY, 0.0f, 1000000);
+    animator.animate(P::X, 200.0f, 500000, PropertyAnimator::Easing::EASE_IN_OUT);
+    TEST_ASSERT_TRUE(animator.isAnimating(P::OPACITY));
+
+    // Starts on the first render: nothing moves yet
+    int64_t t0 = 5000000;
+    animator.apply(props, t0);
+    TEST_ASSERT_TRUE(near(props.opacity, 1.0f));
+    TEST_ASSERT_EQ(props.x, 0);
+
+    animator.apply(props, t0 + 250000);
+    TEST_ASSERT_TRUE(near(props.opacity, 0.75f));
+    TEST_ASSERT_EQ(props.x, 100);  // In-out: halfway at half time
+
+    // Lands exactly on target and finishes
+    animator.apply(props, t0 + 600000);
+    TEST_ASSERT_EQ(props.x, 200);
+    TEST_ASSERT_FALSE(animator.isAnimating(P::X));
+    animator.apply(props, t0 + 1000000);
+    TEST_ASSERT_TRUE(props.opacity == 0.0f);
+    TEST_ASSERT_FALSE(animator.isAnimating());
+
+    // Zero duration: set on the next render
+    animator.animate(P::CORNER_0, 0.1f, 0);
+    animator.apply(props, t0 + 1000001);
+    TEST_ASSERT_TRUE(near(props.cornerDeform.corners[0], 0.1f));
+    TEST_ASSERT_TRUE(props.cornerDeform.enabled);
+    return true;
+}
+
+bool test_PropertyAnimator_DirectSetWins() {
+    LayerProperties props;
+    PropertyAnimator animator;
+    using P = PropertyAnimator::Property;
+
+    animator.animate(P::ROTATION, 90.0f, 1000000);
+    animator.apply(props, 0);
+    animator.apply(props, 500000);
+    TEST_ASSERT_TRUE(near(props.rotation, 45.0f));
+
+    // /rotation while animating: the tween stops, the set value stays
+    props.rotation = 10.0f;
+    animator.apply(props, 600000);
+    TEST_ASSERT_TRUE(near(props.rotation, 10.0f));
+    TEST_ASSERT_FALSE(animator.isAnimating());
+
+    // A new tween replaces the running one, from where it is
+    animator.animate(P::GAMMA, 3.0f, 1000000);
+    animator.apply(props, 0);
+    animator.apply(props, 500000);
+    animator.animate(P::GAMMA, 1.0f, 1000000);
+    float from = props.colorAdjust.gamma;
+    animator.apply(props, 500000);
+    TEST_ASSERT_TRUE(near(props.colorAdjust.gamma, from));
+    animator.apply(props, 1500000);
+    TEST_ASSERT_TRUE(near(props.colorAdjust.gamma, 1.0f));
+
+    // Targets keep the direct commands' ranges
+    animator.animate(P::CONTRAST, 5.0f, 0);
+    animator.apply(props, 0);
+    TEST_ASSERT_TRUE(near(props.colorAdjust.contrast, 2.0f));
+
+    PropertyAnimator::Easing easing;
+    TEST_ASSERT_TRUE(PropertyAnimator::parseEasing("smooth", easing));
+    TEST_ASSERT_TRUE(easing == PropertyAnimator::Easing::SMOOTH);
+    TEST_ASSERT_FALSE(PropertyAnimator::parseEasing("bounce", easing));
+    TEST_ASSERT_TRUE(near(PropertyAnimator::ease(PropertyAnimator::Easing::EASE_OUT, 0.5f), 0.875f));
+    return true;
+}
@@ -0,0 +1,36 @@
+#include "TestFramework.h"
+#include "../input/ProxyMedia.h"
+#include <string>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_ProxyMedia_Covers() {
+    TEST_ASSERT_TRUE(ProxyMedia::proxyPathFor("/show/clip.mov") == "/show/clip.proxy.mov");
+    TEST_ASSERT_TRUE(ProxyMedia::proxyPathFor("/show.d/clip") == "/show.d/clip.proxy");
+    TEST_ASSERT_TRUE(ProxyMedia::proxyPathFor("/show/.hidden") == "/show/.hidden.proxy");
+
+    ProxyMedia::Probe clip{3840, 2160, 25.0, 120.0};
+    ProxyMedia::Probe proxy{1920, 1080, 25.0, 120.02};
+
+    // Picture-in-picture: the proxy still covers the layer
+    TEST_ASSERT_TRUE(ProxyMedia::covers(clip, proxy, 960, 540));
+    TEST_ASSERT_TRUE(ProxyMedia::covers(clip, proxy, 1920, 1080));
+
+    // Larger than the proxy, or size unknown: full resolution
+    TEST_ASSERT_FALSE(ProxyMedia::covers(clip, proxy, 1921, 1080));
+    TEST_ASSERT_FALSE(ProxyMedia::covers(clip, proxy, 0, 0));
+
+    // Frame numbers must line up
+    ProxyMedia::Probe retimed{1920, 1080, 30.0, 120.0};
+    TEST_ASSERT_FALSE(ProxyMedia::covers(clip, retimed, 960, 540));
+    ProxyMedia::Probe shorter{1920, 1080, 25.0, 119.9};
+    TEST_ASSERT_FALSE(ProxyMedia::covers(clip, shorter, 960, 540));
+
+    // Not smaller than the clip: nothing to gain
+    TEST_ASSERT_FALSE(ProxyMedia::covers(proxy, clip, 960, 540));
+
+    // No proxy file: the clip itself
+    TEST_ASSERT_TRUE(ProxyMedia::select("/nonexistent/clip.mov", 960, 540) == "/nonexistent/clip.mov");
+    return true;
+}
@@ -0,0 +1,100 @@
+#include "TestFramework.h"
+#include "../input/ProxySwitcher.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// clip.mov (4K) has a matching HD proxy; other.mov has none
+bool fakeProbe(const std::string& path, ProxyMedia::Probe& probe) {
+    if (path == "/show/clip.mov") {
+        probe = {3840, 2160, 25.0, 60.0};
+        return true;
+    }
+    if (path == "/show/clip.proxy.mov") {
+        probe = {1920, 1080, 25.0, 60.0};
+        return true;
+    }
+    if (path == "/show/other.mov") {
+        probe = {3840, 2160, 25.0, 60.0};
+        return true;
+    }
+    return false;
+}
+
+ProxySwitcher::LayerState layerState(const std::string& path, int width, int height, int64_t frame) {
+    ProxySwitcher::LayerState state;
+    state.cueId = "cue";
+    state.path = path;
+    state.displayWidth = width;
+    state.displayHeight = height;
+    state.frame = frame;
+    state.framerate = 25.0;
+    state.playing = true;
+    return state;
+}
+
+} // namespace
+
+bool test_ProxySwitcher_Conditions() {
+    TEST_ASSERT_TRUE(ProxyMedia::masterPathFor("/show/clip.proxy.mov") == "/show/clip.mov");
+    TEST_ASSERT_TRUE(ProxyMedia::masterPathFor("/show/clip.proxy") == "/show/clip");
+    TEST_ASSERT_TRUE(ProxyMedia::masterPathFor("/show/clip.mov").empty());
+    TEST_ASSERT_TRUE(ProxyMedia::masterPathFor("/show/.proxy.mov").empty());
+
+    ProxySwitcher switcher;
+    switcher.setProbeFunction(fakeProbe);
+
+    // Shown small: to the proxy
+    double t = 100.0;
+    auto change = switcher.update({layerState("/show/clip.mov", 960, 540, 0)}, 0, t);
+    TEST_ASSERT_TRUE(change.cueId == "cue");
+    TEST_ASSERT_TRUE(change.toProxy);
+    TEST_ASSERT_TRUE(change.path == "/show/clip.proxy.mov");
+
+    // On the proxy and still small: nothing to do
+    t += 2.0;
+    TEST_ASSERT_TRUE(switcher.update({layerState("/show/clip.proxy.mov", 960, 540, 50)}, 0, t).cueId.empty());
+
+    // Enlarged past the proxy: back to the master
+    t += 2.0;
+    change = switcher.update({layerState("/show/clip.proxy.mov", 3840, 2160, 100)}, 0, t);
+    TEST_ASSERT_TRUE(change.path == "/show/clip.mov");
+    TEST_ASSERT_FALSE(change.toProxy);
+
+    // Decode overload: full-size layers go to the proxy, and back once it has cleared
+    t += 2.0;
+    change = switcher.update({layerState("/show/clip.mov", 0, 0, 150)}, 10, t);
+    TEST_ASSERT_TRUE(change.toProxy);
+    TEST_ASSERT_TRUE(change.reason == "decode overload");
+    t += 5.0;
+    TEST_ASSERT_TRUE(switcher.update({layerState("/show/clip.proxy.mov", 0, 0, 275)}, 10, t).cueId.empty());
+    t += 6.0;
+    change = switcher.update({layerState("/show/clip.proxy.mov", 0, 0, 425)}, 10, t);
+    TEST_ASSERT_TRUE(change.path == "/show/clip.mov");
+
+    // One locate is not a scrub; repeated jumps are
+    t += 2.0;
+    TEST_ASSERT_TRUE(switcher.update({layerState("/show/clip.mov", 0, 0, 475)}, 10, t).cueId.empty());
+    t += 0.5;
+    TEST_ASSERT_TRUE(switcher.update({layerState("/show/clip.mov", 0, 0, 1000)}, 10, t).cueId.empty());
+    t += 0.5;
+    change = switcher.update({layerState("/show/clip.mov", 0, 0, 400)}, 10, t);
+    TEST_ASSERT_TRUE(change.toProxy);
+    TEST_ASSERT_TRUE(change.reason == "scrubbing");
+
+    // No proxy: never switched
+    ProxySwitcher other;
+    other.setProbeFunction(fakeProbe);
+    TEST_ASSERT_TRUE(other.update({layerState("/show/other.mov", 320, 180, 0)}, 0, 1.0).cueId.empty());
+
+    // Disabled
+    ProxySwitcher::Settings settings;
+    settings.enabled = false;
+    other.configure(settings);
+    TEST_ASSERT_TRUE(other.update({layerState("/show/clip.mov", 320, 180, 0)}, 0, 1.0).cueId.empty());
+    return true;
+}
@@ -0,0 +1,82 @@
+#include "TestFramework.h"
+#include "../input/RamClipCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+std::string writeTempFile(const std::vector<uint8_t>& data) {
+    char tmpl[] = "/tmp/cvc_ramclip_XXXXXX";
+    int fd = mkstemp(tmpl);
+    if (fd < 0) {
+        return std::string();
+    }
+    bool ok = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    ::close(fd);
+    return ok ? std::string(tmpl) : std::string();
+}
+
+} // namespace
+
+bool test_RamClipCache_PreloadAndBudget() {
+    std::vector<uint8_t> data(3 * 1024 * 1024 + 123);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7 + (i >> 16));
+    }
+    const std::string path = writeTempFile(data);
+    const std::string other = writeTempFile(data);
+    TEST_ASSERT_FALSE(path.empty());
+    TEST_ASSERT_FALSE(other.empty());
+
+    RamClipCache cache;
+    cache.setBudget(data.size() + 1024);
+
+    // The RAM copy opens like a file and holds the same bytes
+    auto clip = cache.acquire(path);
+    TEST_ASSERT_TRUE(clip != nullptr);
+    TEST_ASSERT_EQ(clip->size(), data.size());
+    TEST_ASSERT_TRUE(clip->path() != path);
+    FILE* f = fopen(clip->path().c_str(), "rb");
+    TEST_ASSERT_TRUE(f != nullptr);
+    std::vector<uint8_t> copy(data.size());
+    TEST_ASSERT_EQ(fread(copy.data(), 1, copy.size(), f), data.size());
+    fclose(f);
+    TEST_ASSERT_TRUE(copy == data);
+
+    // A second layer on the same file shares the copy
+    auto again = cache.acquire(path);
+    TEST_ASSERT_TRUE(again == clip);
+    TEST_ASSERT_EQ(cache.getStats().clips, static_cast<size_t>(1));
+    TEST_ASSERT_EQ(cache.getStats().bytes, data.size());
+
+    unlink(path.c_str());  // Storage gone: the copy must not need it
+    f = fopen(clip->path().c_str(), "rb");
+    TEST_ASSERT_TRUE(f != nullptr);
+    TEST_ASSERT_EQ(fread(copy.data(), 1, copy.size(), f), data.size());
+    fclose(f);
+
+    // Another file does not fit next to it
+    TEST_ASSERT_TRUE(cache.acquire(other) == nullptr);
+
+    // Released with the last user, making room again
+    clip.reset();
+    again.reset();
+    TEST_ASSERT_EQ(cache.getStats().clips, static_cast<size_t>(0));
+    auto next = cache.acquire(other);
+    TEST_ASSERT_TRUE(next != nullptr);
+
+    // Aborted copies give their reservation back
+    next.reset();
+    std::atomic<bool> abort{true};
+    TEST_ASSERT_TRUE(cache.acquire(other, &abort) == nullptr);
+    TEST_ASSERT_TRUE(cache.acquire(other) != nullptr);
+
+    unlink(other.c_str());
+    return true;
+}
@@ -0,0 +1,85 @@
+#include "TestFramework.h"
+#include "../input/ReadAheadIO.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/error.h>
+}
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_ReadAheadIO_ReadSeek() {
+    TEST_ASSERT_TRUE(ReadAheadIO::parseMode("off") == ReadAheadIO::Mode::OFF);
+    TEST_ASSERT_TRUE(ReadAheadIO::parseMode("on") == ReadAheadIO::Mode::ON);
+    TEST_ASSERT_TRUE(ReadAheadIO::parseMode("auto") == ReadAheadIO::Mode::AUTO);
+    TEST_ASSERT_FALSE(ReadAheadIO::wanted(ReadAheadIO::Mode::OFF, "/tmp"));
+    TEST_ASSERT_TRUE(ReadAheadIO::wanted(ReadAheadIO::Mode::ON, "/tmp"));
+
+    // Two and a half chunks of a position-dependent pattern
+    std::vector<uint8_t> data(ReadAheadIO::CHUNK_SIZE * 5 / 2);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>((i * 31) ^ (i >> 12));
+    }
+    char tmpl[] = "/tmp/cvc_readahead_XXXXXX";
+    int fd = mkstemp(tmpl);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_TRUE(write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    ::close(fd);
+    const std::string path = tmpl;
+
+    ReadAheadIO io;
+    TEST_ASSERT_TRUE(io.open(path, 2 * ReadAheadIO::CHUNK_SIZE));
+    TEST_ASSERT_TRUE(io.getContext() != nullptr);
+    TEST_ASSERT_EQ(io.getFileSize(), static_cast<int64_t>(data.size()));
+    TEST_ASSERT_EQ(io.seek(0, AVSEEK_SIZE), static_cast<int64_t>(data.size()));
+
+    // Sequential reads across chunk boundaries
+    std::vector<uint8_t> out(data.size());
+    size_t done = 0;
+    while (done < out.size()) {
+        int n = io.read(out.data() + done, 300000);
+        TEST_ASSERT_TRUE(n > 0);
+        done += static_cast<size_t>(n);
+    }
+    TEST_ASSERT_TRUE(out == data);
+    TEST_ASSERT_EQ(io.read(out.data(), 16), AVERROR_EOF);
+
+    // Seek back into the first chunk, then relative to the end
+    TEST_ASSERT_EQ(io.seek(1000, SEEK_SET), static_cast<int64_t>(1000));
+    uint8_t small[64];
+    TEST_ASSERT_EQ(io.read(small, sizeof(small)), static_cast<int>(sizeof(small)));
+    TEST_ASSERT_TRUE(std::equal(small, small + sizeof(small), data.begin() + 1000));
+    TEST_ASSERT_EQ(io.seek(-10, SEEK_END), static_cast<int64_t>(data.size() - 10));
+    TEST_ASSERT_EQ(io.read(small, sizeof(small)), 10);
+    TEST_ASSERT_TRUE(std::equal(small, small + 10, data.end() - 10));
+    TEST_ASSERT_TRUE(io.seek(-1, SEEK_SET) < 0);
+
+    ReadAheadIO::Stats st = io.getStats();
+    TEST_ASSERT_EQ(st.seeks, static_cast<uint64_t>(2));
+    TEST_ASSERT_TRUE(st.bytesRead >= data.size());
+    TEST_ASSERT_EQ(st.bytesServed, static_cast<uint64_t>(data.size() + 64 + 10));
+
+    io.close();
+
+    // O_DIRECT (or cached reads where the filesystem lacks it) serves the same bytes
+    ReadAheadIO direct;
+    TEST_ASSERT_TRUE(direct.open(path, ReadAheadIO::CHUNK_SIZE, true));
+    std::fill(out.begin(), out.end(), 0);
+    done = 0;
+    while (done < out.size()) {
+        int n = direct.read(out.data() + done, 1 << 20);
+        TEST_ASSERT_TRUE(n > 0);
+        done += static_cast<size_t>(n);
+    }
+    TEST_ASSERT_TRUE(out == data);
+    direct.close();
+    unlink(path.c_str());
+    return true;
+}
@@ -0,0 +1,145 @@
+#include "TestFramework.h"
+#include "../output/ReadbackRing.h"
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// GL stand-in: buffers hold their name as bytes, fences signal when told to
+// (or when waited on)
+struct FakeGL {
+    GLuint nextName = 1;
+    std::set<GLuint> live;
+    std::map<void*, bool> fences;  // fence -> signalled
+    int nextFence = 1;
+    int waits = 0;
+
+    ReadbackRing::Backend backend() {
+        ReadbackRing::Backend backend;
+        backend.createBuffer = [this](size_t) { live.insert(nextName); return nextName++; };
+        backend.deleteBuffer = [this](GLuint buffer) { live.erase(buffer); };
+        backend.fence = [this]() {
+            void* fence = reinterpret_cast<void*>(static_cast<uintptr_t>(nextFence++));
+            fences[fence] = false;
+            return fence;
+        };
+        backend.signalled = [this](void* fence, bool wait) {
+            if (wait) {
+                waits++;
+                fences[fence] = true;
+            }
+            return fences[fence];
+        };
+        backend.deleteFence = [this](void* fence) { fences.erase(fence); };
+        backend.copy = [](GLuint buffer, void* dest, size_t size) {
+            memset(dest, static_cast<int>(buffer), size);
+            return true;
+        };
+        return backend;
+    }
+
+    void signalOldest() {
+        fences.begin()->second = true;
+    }
+};
+
+} // namespace
+
+bool test_ReadbackRing_PollsOnlySignalled() {
+    FakeGL gl;
+    ReadbackRing ring(gl.backend());
+    TEST_ASSERT(ring.configure(16, 3));
+    TEST_ASSERT_EQ(ring.getDepth(), 3);
+    TEST_ASSERT_EQ(static_cast<int>(gl.live.size()), 3);
+
+    std::vector<GLuint> buffers;
+    for (int i = 0; i < 3; ++i) {
+        GLuint buffer = ring.begin();
+        TEST_ASSERT_TRUE(buffer != 0);
+        buffers.push_back(buffer);
+        ring.submit(100 + i);
+    }
+    TEST_ASSERT(ring.full());
+
+    // Every buffer in flight: the frame is dropped, nothing waits
+    TEST_ASSERT_EQ(ring.begin(), 0u);
+    TEST_ASSERT_EQ(ring.getDropped(), 1u);
+
+    uint8_t bytes[16] = {0};
+    int64_t tag = 0;
+    TEST_ASSERT(!ring.ready());
+    TEST_ASSERT(!ring.poll(bytes, sizeof(bytes), &tag));
+    TEST_ASSERT_EQ(gl.waits, 0);
+
+    // Oldest first, once its fence has signalled
+    gl.signalOldest();
+    TEST_ASSERT(ring.ready());
+    TEST_ASSERT(ring.poll(bytes, sizeof(bytes), &tag));
+    TEST_ASSERT_EQ(tag, 100);
+    TEST_ASSERT_EQ(static_cast<GLuint>(bytes[15]), buffers[0]);
+    TEST_ASSERT_EQ(ring.pending(), 2);
+    TEST_ASSERT(!ring.poll(bytes, sizeof(bytes), &tag));
+
+    // The freed buffer takes the next readback
+    TEST_ASSERT_EQ(ring.begin(), buffers[0]);
+    ring.submit(103);
+    TEST_ASSERT_EQ(ring.pending(), 3);
+    TEST_ASSERT_EQ(gl.waits, 0);
+    return true;
+}
+
+bool test_ReadbackRing_WaitAndReconfigure() {
+    FakeGL gl;
+    ReadbackRing ring(gl.backend());
+    TEST_ASSERT(ring.configure(8, 2));
+    ring.begin();
+    ring.submit(1);
+    ring.begin();
+    ring.submit(2);
+
+    // Lossless callers wait for the oldest
+    uint8_t bytes[8];
+    int64_t tag = 0;
+    TEST_ASSERT(ring.wait(bytes, sizeof(bytes), &tag));
+    TEST_ASSERT_EQ(tag, 1);
+    TEST_ASSERT_EQ(gl.waits, 1);
+    TEST_ASSERT(ring.wait(bytes, sizeof(bytes), &tag));
+    TEST_ASSERT_EQ(tag, 2);
+    TEST_ASSERT(!ring.wait(bytes, sizeof(bytes), &tag));
+    TEST_ASSERT(gl.fences.empty());
+
+    // Too small a destination consumes the readback but copies nothing
+    ring.begin();
+    ring.submit(3);
+    gl.signalOldest();
+    TEST_ASSERT(!ring.poll(bytes, 4));
+    TEST_ASSERT_EQ(ring.pending(), 0);
+
+    // Same size and depth: kept; another size: new buffers, fences dropped
+    std::set<GLuint> before = gl.live;
+    TEST_ASSERT(ring.configure(8, 2));
+    TEST_ASSERT(gl.live == before);
+    ring.begin();
+    ring.submit(4);
+    TEST_ASSERT(ring.configure(32, 4));
+    TEST_ASSERT_EQ(static_cast<int>(gl.live.size()), 4);
+    TEST_ASSERT(gl.fences.empty());
+    TEST_ASSERT_EQ(ring.pending(), 0);
+    TEST_ASSERT_EQ(ring.getSize(), 32u);
+
+    // Depth from the default, clamped
+    ReadbackRing::setDefaultDepth(99);
+    TEST_ASSERT_EQ(ReadbackRing::getDefaultDepth(), ReadbackRing::MAX_DEPTH);
+    ReadbackRing::setDefaultDepth(ReadbackRing::DEFAULT_DEPTH);
+    TEST_ASSERT(ring.configure(32));
+    TEST_ASSERT_EQ(ring.getDepth(), ReadbackRing::DEFAULT_DEPTH);
+
+    ring.release();
+    TEST_ASSERT(gl.live.empty());
+    return true;
+}
@@ -0,0 +1,52 @@
+#include "TestFramework.h"
+#include "../input/RenderNodeManager.h"
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_RenderNodeManager_LeastLoaded() {
+    RenderNodeManager nodes;
+    // renderD130 has no VAAPI driver
+    nodes.setProbe([](const std::string& path) { return path != "/dev/dri/renderD130"; });
+    std::vector<std::string> paths = {"/dev/dri/renderD128", "/dev/dri/renderD129", "/dev/dri/renderD130"};
+    TEST_ASSERT_EQ(nodes.setNodes(paths), static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(nodes.getNodes()[0].primary);
+
+    // Idle nodes: the compositing GPU first, then the other one takes the load
+    RenderNodeManager::SessionId uhd = nodes.acquire(3840, 2160);
+    TEST_ASSERT_NE(uhd, static_cast<RenderNodeManager::SessionId>(0));
+    TEST_ASSERT_TRUE(nodes.isPrimary(uhd));
+    RenderNodeManager::SessionId hd1 = nodes.acquire(1920, 1080);
+    RenderNodeManager::SessionId hd2 = nodes.acquire(1920, 1080);
+    TEST_ASSERT_EQ(nodes.getPath(hd1), std::string("/dev/dri/renderD129"));
+    TEST_ASSERT_EQ(nodes.getPath(hd2), std::string("/dev/dri/renderD129"));
+    TEST_ASSERT_FALSE(nodes.isPrimary(hd2));
+    TEST_ASSERT_EQ(nodes.getNodes()[1].sessions, 2);
+
+    // Released sessions free their node
+    nodes.release(uhd);
+    RenderNodeManager::SessionId small = nodes.acquire(640, 360);
+    TEST_ASSERT_TRUE(nodes.isPrimary(small));
+    TEST_ASSERT_EQ(nodes.getNodes()[0].pixels, static_cast<uint64_t>(640 * 360));
+
+    // Frames the compositing GPU cannot import: the node gets no new sessions
+    nodes.reportShareFailure(hd1);
+    nodes.release(hd1);
+    nodes.release(hd2);
+    nodes.release(small);
+    TEST_ASSERT_FALSE(nodes.getNodes()[1].shareable);
+    TEST_ASSERT_TRUE(nodes.isPrimary(nodes.acquire(1920, 1080)));
+    TEST_ASSERT_TRUE(nodes.isPrimary(nodes.acquire(1920, 1080)));
+
+    // A configured primary node; a single node leaves decoders on the default device
+    TEST_ASSERT_EQ(nodes.setNodes(paths, "/dev/dri/renderD129"), static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(nodes.getNodes()[1].primary && !nodes.getNodes()[0].primary);
+    TEST_ASSERT_EQ(nodes.setNodes({"/dev/dri/renderD128"}), static_cast<size_t>(1));
+    RenderNodeManager::SessionId only = nodes.acquire(1920, 1080);
+    TEST_ASSERT_EQ(only, static_cast<RenderNodeManager::SessionId>(0));
+    TEST_ASSERT_TRUE(nodes.isPrimary(only));
+    TEST_ASSERT_TRUE(nodes.getPath(only).empty());
+    return true;
+}
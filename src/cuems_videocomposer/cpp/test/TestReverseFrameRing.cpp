@@ -0,0 +1,70 @@
+#include "TestFramework.h"
+#include "../input/ReverseFrameRing.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_ReverseFrameRing_Plan() {
+    // Whole GOP fits: decode and keep keyframe..target
+    ReverseFrameRing::Segment s = ReverseFrameRing::plan(59, 30, 40);
+    TEST_ASSERT_EQ(s.decodeFrom, static_cast<int64_t>(30));
+    TEST_ASSERT_EQ(s.keepFrom, static_cast<int64_t>(30));
+    TEST_ASSERT_EQ(s.keepTo, static_cast<int64_t>(59));
+
+    // Longer GOP: keep the last capacity frames, later passes reuse the keyframe
+    s = ReverseFrameRing::plan(249, 0, 100);
+    TEST_ASSERT_EQ(s.decodeFrom, static_cast<int64_t>(0));
+    TEST_ASSERT_EQ(s.keepFrom, static_cast<int64_t>(150));
+    TEST_ASSERT_EQ(s.keepTo, static_cast<int64_t>(249));
+    s = ReverseFrameRing::plan(149, 0, 100);
+    TEST_ASSERT_EQ(s.keepFrom, static_cast<int64_t>(50));
+
+    // Target on the keyframe itself
+    s = ReverseFrameRing::plan(30, 30, 8);
+    TEST_ASSERT_EQ(s.keepFrom, static_cast<int64_t>(30));
+    TEST_ASSERT_EQ(s.keepTo, static_cast<int64_t>(30));
+
+    // Nothing to plan without a ring or a frame
+    s = ReverseFrameRing::plan(10, 0, 0);
+    TEST_ASSERT_EQ(s.keepTo, static_cast<int64_t>(-1));
+    s = ReverseFrameRing::plan(-1, 0, 8);
+    TEST_ASSERT_EQ(s.keepTo, static_cast<int64_t>(-1));
+    return true;
+}
+
+bool test_ReverseFrameRing_Store() {
+    ReverseFrameRing ring;
+    TEST_ASSERT_EQ(ring.capacity(), static_cast<size_t>(0));
+    TEST_ASSERT(ring.store(0).get() == nullptr);
+
+    auto pool = FramePool::create(3);
+    ring.setPool(pool);
+    TEST_ASSERT_EQ(ring.capacity(), static_cast<size_t>(3));
+
+    for (int64_t frame = 10; frame < 13; ++frame) {
+        FramePool::Handle slot = ring.store(frame);
+        TEST_ASSERT(slot.get() != nullptr);
+        TEST_ASSERT_EQ(slot->frameNumber, frame);
+    }
+    // Full ring and out-of-order frames are refused
+    TEST_ASSERT(ring.store(13).get() == nullptr);
+    TEST_ASSERT_EQ(ring.size(), static_cast<size_t>(3));
+
+    // Served in reverse
+    for (int64_t frame = 12; frame >= 10; --frame) {
+        FramePool::Handle slot = ring.find(frame);
+        TEST_ASSERT(slot.get() != nullptr);
+        TEST_ASSERT_EQ(slot->frameNumber, frame);
+    }
+    TEST_ASSERT(ring.find(9).get() == nullptr);
+    TEST_ASSERT(ring.find(13).get() == nullptr);
+
+    // Clearing returns the slots for the next segment
+    ring.clear();
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(3));
+    TEST_ASSERT(ring.store(5).get() != nullptr);
+    TEST_ASSERT(ring.store(5).get() == nullptr);
+    ring.setPool(nullptr);
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(3));
+    return true;
+}
@@ -0,0 +1,87 @@
+#include "TestFramework.h"
+#include "../input/SharedMediaRegistry.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_SharedMediaRegistry_FramesAndIndex() {
+    SharedMediaRegistry registry;
+    const std::string path = "/shows/mirror.mov";
+    FrameInfo info;
+    info.width = 4;
+    info.height = 2;
+    info.format = PixelFormat::BGRA32;
+
+    // One layer: nothing is published
+    registry.addUser(path);
+    TEST_ASSERT_FALSE(registry.isShared(path));
+    auto frame = registry.acquireFrame(path);
+    TEST_ASSERT_TRUE(frame->allocate(info));
+    registry.publishFrame(path, 10, frame);
+    FrameBuffer buffer;
+    TEST_ASSERT_FALSE(registry.findFrame(path, 10, buffer));
+
+    // Two layers: the second wraps the first's frame, no copy
+    registry.addUser(path);
+    TEST_ASSERT_TRUE(registry.isShared(path));
+    frame->data()[0] = 42;
+    registry.publishFrame(path, 10, frame);
+    TEST_ASSERT_TRUE(registry.findFrame(path, 10, buffer));
+    TEST_ASSERT_TRUE(buffer.isShared());
+    TEST_ASSERT_TRUE(buffer.data() == frame->data());
+    TEST_ASSERT_FALSE(registry.findFrame(path, 11, buffer));
+
+    // Frames pushed out of the recent list are recycled once nobody shows them
+    const uint8_t* first = frame->data();
+    frame.reset();
+    buffer.release();
+    for (int64_t n = 11; n <= 12; ++n) {
+        auto next = registry.acquireFrame(path);
+        TEST_ASSERT_TRUE(next->ensureAllocated(info));
+        registry.publishFrame(path, n, next);
+    }
+    TEST_ASSERT_FALSE(registry.findFrame(path, 10, buffer));
+    auto recycled = registry.acquireFrame(path);
+    TEST_ASSERT_TRUE(recycled->data() == first);
+
+    // Index: shared while the file is unchanged
+    char tmpl[] = "/tmp/cvc_shared_XXXXXX";
+    int fd = mkstemp(tmpl);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_TRUE(write(fd, "abc", 3) == 3);
+    close(fd);
+    std::string media = tmpl;
+    std::vector<FrameIndexCache::Entry> entries(2);
+    entries[0] = {};
+    entries[1] = {};
+    entries[1].pkt_pts = 512;
+    FrameIndexCache::Metadata meta;
+    meta.frameCount = 2;
+    meta.totalFrames = 2;
+    registry.publishIndex(media, entries.data(), meta);
+
+    std::vector<FrameIndexCache::Entry> loaded;
+    FrameIndexCache::Metadata loadedMeta;
+    TEST_ASSERT_TRUE(registry.findIndex(media, loaded, loadedMeta));
+    TEST_ASSERT_EQ(loaded.size(), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(loaded[1].pkt_pts, 512);
+    TEST_ASSERT_EQ(loadedMeta.totalFrames, 2);
+
+    FILE* f = fopen(media.c_str(), "ab");
+    TEST_ASSERT_TRUE(f != nullptr);
+    fputs("changed", f);
+    fclose(f);
+    TEST_ASSERT_FALSE(registry.findIndex(media, loaded, loadedMeta));
+    unlink(media.c_str());
+
+    // Last layer gone: frames dropped
+    registry.removeUser(path);
+    registry.removeUser(path);
+    TEST_ASSERT_FALSE(registry.isShared(path));
+    TEST_ASSERT_EQ(registry.getStats().files, static_cast<size_t>(0));
+    return true;
+}
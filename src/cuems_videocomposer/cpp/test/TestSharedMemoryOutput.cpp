@@ -0,0 +1,149 @@
+#include "TestFramework.h"
+#include "../output/SharedMemoryOutput.h"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Connect like a reader
+bool connectReader(const std::string& path, int& sock) {
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return false;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(sock);
+        return false;
+    }
+    return true;
+}
+
+// Receive the fds the sink hands out
+bool receiveFds(int sock, std::vector<int>& fds) {
+    uint32_t count = 0;
+    iovec iov{&count, sizeof(count)};
+    char control[CMSG_SPACE(sizeof(int) * 16)];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(sock, &msg, 0) != static_cast<ssize_t>(sizeof(count))) {
+        return false;
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS) {
+        return false;
+    }
+    size_t received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    fds.resize(received);
+    std::memcpy(fds.data(), CMSG_DATA(cmsg), received * sizeof(int));
+    return received == count;
+}
+
+} // namespace
+
+bool test_SharedMemoryOutput_Ring() {
+    std::string path = "/tmp/vc-test-shm-" + std::to_string(getpid()) + ".sock";
+
+    SharedMemoryOutput sink(false, 3);
+    OutputSinkConfig config;
+    config.width = 66;      // Rounded down to 64 for 4:2:0
+    config.height = 33;
+    config.format = PixelFormat::NV12;
+    TEST_ASSERT(sink.open(path, config));
+    TEST_ASSERT(sink.isReady());
+
+    CaptureFormat format = sink.getCaptureFormat();
+    TEST_ASSERT(format.format == PixelFormat::NV12);
+    TEST_ASSERT_EQ(format.width, 64);
+    TEST_ASSERT_EQ(format.height, 32);
+
+    int reader = -1;
+    TEST_ASSERT(connectReader(path, reader));
+
+    size_t frameSize = FrameData::frameSize(PixelFormat::NV12, 64, 32);
+    std::vector<uint8_t> pixels(frameSize);
+    auto publish = [&](int64_t number) {
+        std::memset(pixels.data(), static_cast<int>(number), frameSize);
+        FrameData frame;
+        frame.data = pixels.data();
+        frame.size = frameSize;
+        frame.width = 64;
+        frame.height = 32;
+        frame.format = PixelFormat::NV12;
+        frame.frameNumber = number;
+        frame.timecode = 1000 + number;
+        frame.timecodeFps = 25.0;
+        return sink.writeFrame(frame);
+    };
+
+    // The first write hands the ring to the waiting reader
+    TEST_ASSERT(publish(1));
+    TEST_ASSERT_EQ(sink.getReaderCount(), static_cast<size_t>(1));
+
+    std::vector<int> fds;
+    TEST_ASSERT(receiveFds(reader, fds));
+    TEST_ASSERT_EQ(fds.size(), static_cast<size_t>(2));   // memfd, eventfd
+
+    size_t size = shm::ringSize(3, frameSize);
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    TEST_ASSERT(mapping != MAP_FAILED);
+    uint8_t* base = static_cast<uint8_t*>(mapping);
+    auto* header = reinterpret_cast<shm::RingHeader*>(base);
+    TEST_ASSERT_EQ(header->magic, shm::RING_MAGIC);
+    TEST_ASSERT_EQ(header->slotCount, 3u);
+    TEST_ASSERT_EQ(header->format, static_cast<uint32_t>(shm::RING_FORMAT_NV12));
+    TEST_ASSERT_EQ(header->planeOffsets[1], 64u * 32u);
+    TEST_ASSERT_EQ(header->published.load(), 1u);
+
+    uint64_t signals = 0;
+    TEST_ASSERT_EQ(read(fds[1], &signals, sizeof(signals)), static_cast<ssize_t>(sizeof(signals)));
+    TEST_ASSERT_EQ(signals, 1u);
+
+    // Wrap the ring: the newest frame is complete, in slot seq % slotCount
+    TEST_ASSERT(publish(2));
+    TEST_ASSERT(publish(3));
+    TEST_ASSERT(publish(4));
+    uint64_t seq = header->latest.load();
+    TEST_ASSERT_EQ(seq, 3u);
+    shm::SlotHeader* slot = shm::slotAt(base, header, static_cast<uint32_t>(seq % 3));
+    TEST_ASSERT_EQ(slot->sequence.load(), 2 * seq + 2);
+    TEST_ASSERT_EQ(slot->frameNumber, 4);
+    TEST_ASSERT_EQ(slot->timecode, 1004);
+    TEST_ASSERT_EQ(shm::slotData(base, header, static_cast<uint32_t>(seq % 3))[frameSize - 1], 4);
+
+    // Frames of another geometry are dropped, the ring is sealed against resizing
+    FrameData wrong;
+    wrong.data = pixels.data();
+    wrong.size = frameSize;
+    wrong.width = 32;
+    wrong.height = 32;
+    wrong.format = PixelFormat::NV12;
+    TEST_ASSERT(!sink.writeFrame(wrong));
+    TEST_ASSERT(ftruncate(fds[0], 0) != 0);
+
+    // A reader that hangs up is dropped on the next frame
+    ::close(reader);
+    TEST_ASSERT(publish(5));
+    TEST_ASSERT_EQ(sink.getReaderCount(), static_cast<size_t>(0));
+
+    munmap(mapping, size);
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    sink.close();
+    TEST_ASSERT(access(path.c_str(), F_OK) != 0);
+    return true;
+}
@@ -0,0 +1,129 @@
+#include "TestFramework.h"
+#include "../layer/ShowJournal.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+ShowJournal::State showState() {
+    ShowJournal::State state;
+    state.resolutionMode = "native";
+
+    ShowJournal::Layer backdrop;
+    backdrop.cueId = "5c1f0a52-0d5e-4a9c-9f55-0b6f2f3b1e01";
+    backdrop.source = "/media/show/act one/backdrop.mov";
+    LayerProperties& p = backdrop.properties;
+    p.x = 120;
+    p.y = -40;
+    p.width = 1920;
+    p.height = 1080;
+    p.opacity = 0.35f;
+    p.zOrder = 3;
+    p.scaleX = 1.25f;
+    p.rotation = 12.5f;
+    p.crop.enabled = true;
+    p.crop.width = 960;
+    p.crop.height = 540;
+    p.blendMode = LayerProperties::SCREEN;
+    p.packedAlpha = PackedAlpha::Layout::SIDE_BY_SIDE;
+    p.packedAlphaPremultiplied = true;
+    for (int i = 0; i < 8; ++i) {
+        p.cornerDeform.corners[i] = 0.1f * i;
+    }
+    p.cornerDeform.enabled = true;
+    p.colorAdjust.gamma = 1.8f;
+    p.colorAdjust.lutFile = "/media/show/luts/warm grade.cube";
+    p.effects.blurRadius = 6.5f;
+    p.effects.chromaKey.enabled = true;
+    p.effects.chromaKey.green = 0.7f;
+    p.effects.vignetteAmount = 0.25f;
+    p.loopRegion.enabled = true;
+    p.loopRegion.startFrame = 250;
+    p.loopRegion.endFrame = 1250;
+    p.loopRegion.loopCount = 4;
+    backdrop.timeOffset = -90000;
+    backdrop.timeScale = 0.5;
+    backdrop.mtcFollow = false;
+    backdrop.decodePriority = 3;
+    backdrop.critical = true;
+    state.layers.push_back(backdrop);
+
+    ShowJournal::Layer camera;
+    camera.cueId = "camera";
+    camera.source = "v4l2:///dev/video0";
+    for (float& corner : camera.properties.cornerDeform.corners) {
+        corner = 0.0f;
+    }
+    state.layers.push_back(camera);
+    return state;
+}
+
+} // namespace
+
+bool test_ShowJournal_RoundTrip() {
+    ShowJournal::State state = showState();
+    std::istringstream text(ShowJournal::format(state));
+    ShowJournal::State read;
+    TEST_ASSERT(ShowJournal::parse(text, read));
+    TEST_ASSERT(read.resolutionMode == "native");
+    TEST_ASSERT(read.layers.size() == 2);
+
+    const ShowJournal::Layer& backdrop = read.layers[0];
+    TEST_ASSERT(backdrop.cueId == state.layers[0].cueId);
+    TEST_ASSERT(backdrop.source == "/media/show/act one/backdrop.mov");
+    TEST_ASSERT(backdrop.properties.rendersSameAs(state.layers[0].properties));
+    TEST_ASSERT(backdrop.properties.colorAdjust.lutFile == "/media/show/luts/warm grade.cube");
+    TEST_ASSERT(backdrop.properties.loopRegion.enabled && backdrop.properties.loopRegion.endFrame == 1250);
+    TEST_ASSERT(backdrop.properties.loopRegion.currentLoopCount == 4);
+    TEST_ASSERT(backdrop.timeOffset == -90000 && backdrop.timeScale == 0.5);
+    TEST_ASSERT(!backdrop.mtcFollow && backdrop.decodePriority == 3 && backdrop.critical);
+    TEST_ASSERT(read.layers[1].source == "v4l2:///dev/video0" && read.layers[1].mtcFollow);
+
+    // Not a journal, a bad value, and a layer whose source was lost
+    std::istringstream other("cuems-videocomposer show journal 0\n");
+    TEST_ASSERT(!ShowJournal::parse(other, read));
+    std::istringstream bad(std::string("cuems-videocomposer show journal 1\nlayer a\nsource x\nopacity half\nend\n"));
+    TEST_ASSERT(!ShowJournal::parse(bad, read));
+    std::istringstream sourceless(std::string("cuems-videocomposer show journal 1\nlayer a\nz 2\nend\n"));
+    TEST_ASSERT(ShowJournal::parse(sourceless, read) && read.layers.empty());
+    return true;
+}
+
+bool test_ShowJournal_Writer() {
+    char directory[] = "/tmp/showjournal-XXXXXX";
+    TEST_ASSERT(mkdtemp(directory) != nullptr);
+    std::string path = std::string(directory) + "/nested/show.journal";
+
+    ShowJournal journal;
+    TEST_ASSERT(journal.open(path));
+    ShowJournal::State state = showState();
+    journal.submit(state);
+    for (int i = 0; i < 400 && journal.getWriteCount() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    TEST_ASSERT(journal.getWriteCount() == 1);
+
+    // An unchanged state is not written again; close() writes the last one
+    journal.submit(state);
+    state.layers.pop_back();
+    journal.submit(state);
+    journal.close();
+    TEST_ASSERT(journal.getWriteCount() == 2);
+
+    ShowJournal::State read;
+    TEST_ASSERT(ShowJournal::load(path, read));
+    TEST_ASSERT(read.layers.size() == 1 && read.layers[0].cueId == state.layers[0].cueId);
+    TEST_ASSERT(!ShowJournal::load(path + ".tmp", read));
+
+    std::remove(path.c_str());
+    rmdir((std::string(directory) + "/nested").c_str());
+    rmdir(directory);
+    return true;
+}
@@ -0,0 +1,91 @@
+#include "TestFramework.h"
+#include "../video/SliceScaler.h"
+#include "../display/CPUImageKernels.h"
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_SliceScaler_PlanSlices() {
+    std::vector<SliceScaler::Slice> slices;
+
+    // 4K over eight threads: eight equal slices
+    SliceScaler::planSlices(2160, 2, 8, SliceScaler::MIN_SLICE_ROWS, slices);
+    TEST_ASSERT_EQ(static_cast<int>(slices.size()), 8);
+    TEST_ASSERT_EQ(slices[1].first, 270);
+    TEST_ASSERT_EQ(slices[7].rows, 270);
+
+    // Boundaries on chroma rows, the last slice takes the rest
+    SliceScaler::planSlices(1081, 4, 4, SliceScaler::MIN_SLICE_ROWS, slices);
+    TEST_ASSERT_EQ(static_cast<int>(slices.size()), 4);
+    int next = 0;
+    for (const SliceScaler::Slice& slice : slices) {
+        TEST_ASSERT_EQ(slice.first, next);
+        TEST_ASSERT_EQ(slice.first % 4, 0);
+        next += slice.rows;
+    }
+    TEST_ASSERT_EQ(next, 1081);
+
+    // Too few rows to split
+    SliceScaler::planSlices(100, 2, 8, SliceScaler::MIN_SLICE_ROWS, slices);
+    TEST_ASSERT_EQ(static_cast<int>(slices.size()), 1);
+    TEST_ASSERT_EQ(slices[0].rows, 100);
+    SliceScaler::planSlices(0, 2, 8, SliceScaler::MIN_SLICE_ROWS, slices);
+    TEST_ASSERT(slices.empty());
+    return true;
+}
+
+bool test_SliceScaler_MatchesOneContext() {
+    // 4:2:0 to BGRA in slices: the same bytes as one sws_scale()
+    const int width = 1280;
+    const int height = 722;
+    std::vector<uint8_t> y(static_cast<size_t>(width) * height);
+    std::vector<uint8_t> u(static_cast<size_t>(width / 2) * (height / 2));
+    std::vector<uint8_t> v(u.size());
+    uint32_t seed = 12345;
+    for (std::vector<uint8_t>* plane : {&y, &u, &v}) {
+        for (uint8_t& byte : *plane) {
+            seed = seed * 1664525u + 1013904223u;
+            byte = static_cast<uint8_t>(seed >> 24);
+        }
+    }
+    const uint8_t* src[4] = {y.data(), u.data(), v.data(), nullptr};
+    int srcStride[4] = {width, width / 2, width / 2, 0};
+
+    std::vector<uint8_t> single(static_cast<size_t>(width) * height * 4);
+    std::vector<uint8_t> sliced(single.size(), 0xAA);
+    uint8_t* dst[4] = {single.data(), nullptr, nullptr, nullptr};
+    int dstStride[4] = {width * 4, 0, 0, 0};
+    SwsContext* context = sws_getContext(width, height, AV_PIX_FMT_YUV420P, width, height, AV_PIX_FMT_BGRA,
+                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
+    TEST_ASSERT(context != nullptr);
+    sws_scale(context, src, srcStride, 0, height, dst, dstStride);
+    sws_freeContext(context);
+
+    SliceScaler scaler;
+    TEST_ASSERT(!scaler.isReady());
+    dst[0] = sliced.data();
+    TEST_ASSERT(scaler.scale(src, srcStride, width, height, AV_PIX_FMT_YUV420P, dst, dstStride,
+                             width, height, AV_PIX_FMT_BGRA, SWS_BILINEAR));
+    TEST_ASSERT(scaler.isReady());
+    if (CPUImageKernels::getConcurrency() > 1) {
+        TEST_ASSERT(scaler.getSliceCount() > 1);
+    }
+    TEST_ASSERT(sliced == single);
+
+    // Scaled vertically: one context
+    std::vector<uint8_t> half(static_cast<size_t>(width / 2) * (height / 2) * 4);
+    dst[0] = half.data();
+    dstStride[0] = width * 2;
+    TEST_ASSERT(scaler.scale(src, srcStride, width, height, AV_PIX_FMT_YUV420P, dst, dstStride,
+                             width / 2, height / 2, AV_PIX_FMT_BGRA, SWS_BILINEAR));
+    TEST_ASSERT_EQ(scaler.getSliceCount(), 1);
+    scaler.reset();
+    TEST_ASSERT(!scaler.isReady());
+    return true;
+}
@@ -0,0 +1,202 @@
+#include "TestFramework.h"
+#include "../display/ColorLut.h"
+#include "../display/SoftwareCompositor.h"
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+std::vector<uint8_t> noise(size_t bytes, uint32_t seed) {
+    std::vector<uint8_t> data(bytes);
+    for (uint8_t& value : data) {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(seed >> 24);
+    }
+    return data;
+}
+
+std::vector<uint8_t> solid(int width, int height, uint8_t b, uint8_t g, uint8_t r, uint8_t a) {
+    std::vector<uint8_t> data(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < data.size(); i += 4) {
+        data[i] = b;
+        data[i + 1] = g;
+        data[i + 2] = r;
+        data[i + 3] = a;
+    }
+    return data;
+}
+
+SoftwareCompositor::Layer layerOf(const std::vector<uint8_t>& pixels, int width, int height) {
+    SoftwareCompositor::Layer layer;
+    layer.source.data = pixels.data();
+    layer.source.width = width;
+    layer.source.height = height;
+    layer.source.stride = width * 4;
+    return layer;
+}
+
+} // namespace
+
+bool test_SoftwareCompositor_BlendParity() {
+    // Each SIMD kernel gives the scalar kernel's bytes (odd lengths: the tails too)
+    const int n = 37;
+    std::vector<uint8_t> source = noise(n * 4, 7);
+    std::vector<uint8_t> canvas = noise(n * 4, 11);
+    for (size_t i = 3; i < canvas.size(); i += 4) {
+        canvas[i] = 255;
+    }
+    for (int opacity : {256, 255, 181, 1}) {
+        std::vector<uint8_t> expected = canvas;
+        SoftwareCompositor::blendRow(source.data(), expected.data(), n, opacity, LayerProperties::NORMAL,
+                                     CPUImageKernels::Isa::Scalar);
+        for (auto isa : {CPUImageKernels::Isa::AVX2, CPUImageKernels::Isa::NEON}) {
+            if (!CPUImageKernels::isSupported(isa)) {
+                continue;
+            }
+            std::vector<uint8_t> result = canvas;
+            SoftwareCompositor::blendRow(source.data(), result.data(), n, opacity, LayerProperties::NORMAL, isa);
+            TEST_ASSERT(result == expected);
+        }
+        for (size_t i = 3; i < expected.size(); i += 4) {
+            TEST_ASSERT_EQ(static_cast<int>(expected[i]), 255);
+        }
+    }
+
+    // Opaque at full opacity replaces, transparent leaves the canvas
+    std::vector<uint8_t> opaque = solid(4, 1, 10, 20, 30, 255);
+    std::vector<uint8_t> clear = solid(4, 1, 10, 20, 30, 0);
+    std::vector<uint8_t> under = solid(4, 1, 200, 100, 50, 255);
+    std::vector<uint8_t> result = under;
+    auto isa = CPUImageKernels::activeIsa();
+    SoftwareCompositor::blendRow(clear.data(), result.data(), 4, 256, LayerProperties::NORMAL, isa);
+    TEST_ASSERT(result == under);
+    SoftwareCompositor::blendRow(opaque.data(), result.data(), 4, 256, LayerProperties::NORMAL, isa);
+    TEST_ASSERT(result == opaque);
+    return true;
+}
+
+bool test_SoftwareCompositor_BlendModes() {
+    std::vector<uint8_t> canvas = solid(1, 1, 40, 128, 200, 255);
+    auto blend = [&](LayerProperties::BlendMode mode, uint8_t value) {
+        std::vector<uint8_t> source = solid(1, 1, value, value, value, 255);
+        std::vector<uint8_t> result = canvas;
+        SoftwareCompositor::blendRow(source.data(), result.data(), 1, 256, mode, CPUImageKernels::Isa::Scalar);
+        return result;
+    };
+    TEST_ASSERT(blend(LayerProperties::MULTIPLY, 255) == canvas);
+    TEST_ASSERT(blend(LayerProperties::MULTIPLY, 0) == solid(1, 1, 0, 0, 0, 255));
+    TEST_ASSERT(blend(LayerProperties::SCREEN, 0) == canvas);
+    TEST_ASSERT(blend(LayerProperties::SCREEN, 255) == solid(1, 1, 255, 255, 255, 255));
+
+    // Overlay: multiply under mid grey, screen from there
+    std::vector<uint8_t> overlay = blend(LayerProperties::OVERLAY, 128);
+    TEST_ASSERT(std::abs(overlay[0] - 40) <= 1 && std::abs(overlay[1] - 128) <= 1 && std::abs(overlay[2] - 200) <= 1);
+    overlay = blend(LayerProperties::OVERLAY, 0);
+    TEST_ASSERT(overlay[0] == 0 && overlay[2] > 0 && overlay[2] < 200);
+    return true;
+}
+
+bool test_SoftwareCompositor_Placement() {
+    std::vector<uint8_t> pixels = solid(640, 480, 0, 0, 0, 255);
+    SoftwareCompositor::Layer layer = layerOf(pixels, 640, 480);
+    SoftwareCompositor::Placement placement;
+
+    // 4:3 on 16:9: pillarboxed, one source pixel per 2.25 canvas pixels
+    TEST_ASSERT(SoftwareCompositor::place(layer, 1920, 1080, placement));
+    TEST_ASSERT(placement.x0 == 240 && placement.x1 == 1680 && placement.y0 == 0 && placement.y1 == 1080);
+    TEST_ASSERT(std::abs(placement.map.dxx - 480.0 / 1080.0) < 1e-9 && placement.map.dxy == 0.0);
+
+    // Half size about the centre
+    layer.properties.scaleX = 0.5f;
+    layer.properties.scaleY = 0.5f;
+    TEST_ASSERT(SoftwareCompositor::place(layer, 1920, 1080, placement));
+    TEST_ASSERT(placement.x0 == 600 && placement.x1 == 1320 && placement.y0 == 270 && placement.y1 == 810);
+
+    // A quarter turn of a full-canvas 16:9 source: 1080 wide, cut off at top and bottom
+    std::vector<uint8_t> wide = solid(160, 90, 0, 0, 0, 255);
+    SoftwareCompositor::Layer turned = layerOf(wide, 160, 90);
+    turned.properties.rotation = 90.0f;
+    TEST_ASSERT(SoftwareCompositor::place(turned, 1920, 1080, placement));
+    TEST_ASSERT(placement.x0 == 420 && placement.x1 == 1500 && placement.y0 == 0 && placement.y1 == 1080);
+    TEST_ASSERT(placement.map.dxx == 0.0 && placement.map.dyy == 0.0);
+
+    // Display aspect wins over the pixel count (anamorphic)
+    layer.properties.scaleX = 1.0f;
+    layer.properties.scaleY = 1.0f;
+    layer.aspect = 16.0f / 9.0f;
+    TEST_ASSERT(SoftwareCompositor::place(layer, 1920, 1080, placement));
+    TEST_ASSERT(placement.x0 == 0 && placement.x1 == 1920);
+
+    layer.properties.scaleX = 0.0f;
+    TEST_ASSERT_FALSE(SoftwareCompositor::place(layer, 1920, 1080, placement));
+    return true;
+}
+
+bool test_SoftwareCompositor_Composite() {
+    const int width = 640, height = 360;
+    std::vector<uint8_t> canvas(static_cast<size_t>(width) * height * 4, 0x55);
+    std::vector<uint8_t> red = solid(16, 9, 0, 0, 255, 255);
+    std::vector<uint8_t> blue = solid(16, 9, 255, 0, 0, 255);
+
+    // Bottom first: red full canvas, half-size blue at half opacity on top
+    std::vector<SoftwareCompositor::Layer> layers;
+    layers.push_back(layerOf(red, 16, 9));
+    SoftwareCompositor::Layer top = layerOf(blue, 16, 9);
+    top.properties.scaleX = 0.5f;
+    top.properties.scaleY = 0.5f;
+    top.properties.opacity = 0.5f;
+    layers.push_back(top);
+    SoftwareCompositor::Layer hidden = layerOf(blue, 16, 9);
+    hidden.properties.visible = false;
+    layers.push_back(hidden);
+
+    SoftwareCompositor compositor;
+    compositor.composite(layers, canvas.data(), width, height, width * 4);
+    auto at = [&](int x, int y) { return canvas.data() + (static_cast<size_t>(y) * width + x) * 4; };
+    const uint8_t* corner = at(2, 2);
+    TEST_ASSERT(corner[0] == 0 && corner[1] == 0 && corner[2] == 255 && corner[3] == 255);
+    const uint8_t* centre = at(width / 2, height / 2);
+    TEST_ASSERT(std::abs(centre[0] - 128) <= 1 && std::abs(centre[2] - 127) <= 1 && centre[3] == 255);
+
+    // No layers: opaque black
+    compositor.composite({}, canvas.data(), width, height, width * 4);
+    TEST_ASSERT(at(5, 300)[0] == 0 && at(5, 300)[2] == 0 && at(5, 300)[3] == 255);
+
+    // RGBA source on the BGRA canvas
+    SoftwareCompositor::Layer rgba = layerOf(blue, 16, 9);   // bytes 255,0,0 = red in RGBA
+    rgba.swapRedBlue = true;
+    compositor.composite({rgba}, canvas.data(), width, height, width * 4);
+    TEST_ASSERT(at(100, 100)[2] == 255 && at(100, 100)[0] == 0);
+    return true;
+}
+
+bool test_SoftwareCompositor_ColorTable() {
+    // Identity bake: every value within a step of itself
+    ColorLut lut;
+    TEST_ASSERT(lut.build(ColorLut::Adjustment(), ColorLut::DEFAULT_SIZE));
+    SoftwareCompositor::ColorTable table;
+    SoftwareCompositor::bakeTable(lut, table);
+    std::vector<uint8_t> pixels = noise(4096, 3);
+    std::vector<uint8_t> original = pixels;
+    SoftwareCompositor::applyTable(table, pixels.data(), 1024, false);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        TEST_ASSERT(std::abs(pixels[i] - original[i]) <= 1);
+    }
+
+    // Full desaturation: equal channels, alpha untouched
+    ColorLut::Adjustment grey;
+    grey.saturation = 0.0f;
+    TEST_ASSERT(lut.build(grey, ColorLut::DEFAULT_SIZE));
+    SoftwareCompositor::bakeTable(lut, table);
+    pixels = original;
+    SoftwareCompositor::applyTable(table, pixels.data(), 1024, true);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        TEST_ASSERT(std::abs(pixels[i] - pixels[i + 1]) <= 1 && std::abs(pixels[i + 1] - pixels[i + 2]) <= 1);
+        TEST_ASSERT_EQ(pixels[i + 3], original[i + 3]);
+    }
+    return true;
+}
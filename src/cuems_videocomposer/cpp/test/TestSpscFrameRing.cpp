@@ -0,0 +1,109 @@
+#include "TestFramework.h"
+#include "../input/SpscFrameRing.h"
+#include <thread>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+FramePool::Handle frameSlot(const std::shared_ptr<FramePool>& pool, int64_t frameNumber) {
+    FramePool::Handle slot = pool->acquire();
+    if (slot) {
+        slot->frameNumber = frameNumber;
+    }
+    return slot;
+}
+
+} // namespace
+
+bool test_SpscFrameRing_PushFindDrop() {
+    auto pool = FramePool::create(4);
+    SpscFrameRing ring(3);
+    TEST_ASSERT_EQ(ring.oldestFrame(), static_cast<int64_t>(-1));
+
+    for (int64_t frame = 10; frame < 13; ++frame) {
+        TEST_ASSERT_TRUE(ring.push(frameSlot(pool, frame), 0));
+    }
+    // Full ring refuses the frame; its slot goes straight back to the pool
+    TEST_ASSERT_FALSE(ring.push(frameSlot(pool, 13), 0));
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(ring.size(), static_cast<size_t>(3));
+    TEST_ASSERT_EQ(ring.oldestFrame(), static_cast<int64_t>(10));
+    TEST_ASSERT_EQ(ring.newestFrame(), static_cast<int64_t>(12));
+
+    TEST_ASSERT(ring.find(11, 0).get() != nullptr);
+    TEST_ASSERT(ring.find(13, 0).get() == nullptr);
+    TEST_ASSERT_EQ(ring.findClosestBefore(20, 0)->frameNumber, static_cast<int64_t>(12));
+    TEST_ASSERT(ring.findClosestBefore(9, 0).get() == nullptr);
+
+    // Popping frees room and pool slots; positions wrap around the entries
+    ring.dropBefore(12, 0);
+    TEST_ASSERT_EQ(ring.size(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(3));
+    TEST_ASSERT_TRUE(ring.push(frameSlot(pool, 13), 0));
+    TEST_ASSERT_TRUE(ring.push(frameSlot(pool, 14), 0));
+    TEST_ASSERT(ring.find(14, 0).get() != nullptr);
+    TEST_ASSERT_EQ(ring.oldestFrame(), static_cast<int64_t>(12));
+
+    ring.clear();
+    TEST_ASSERT_EQ(ring.size(), static_cast<size_t>(0));
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(4));
+    return true;
+}
+
+bool test_SpscFrameRing_Epochs() {
+    auto pool = FramePool::create(4);
+    SpscFrameRing ring(4);
+
+    TEST_ASSERT_TRUE(ring.push(frameSlot(pool, 5), 0));
+    // Delivered after a seek to frame 100 (epoch 1) but decoded for the old position
+    TEST_ASSERT_TRUE(ring.push(frameSlot(pool, 6), 0));
+    TEST_ASSERT_TRUE(ring.push(frameSlot(pool, 100), 1));
+
+    TEST_ASSERT(ring.find(6, 1).get() == nullptr);
+    TEST_ASSERT(ring.findClosestBefore(100, 1)->frameNumber == 100);
+    TEST_ASSERT(ring.findClosestBefore(99, 1).get() == nullptr);
+
+    // Old-epoch frames are dropped whatever their frame number
+    ring.dropBefore(0, 1);
+    TEST_ASSERT_EQ(ring.size(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(ring.oldestFrame(), static_cast<int64_t>(100));
+    return true;
+}
+
+bool test_SpscFrameRing_Threaded() {
+    const int64_t frames = 2000;
+    auto pool = FramePool::create(8);
+    SpscFrameRing ring(8);
+
+    std::thread producer([&]() {
+        for (int64_t frame = 0; frame < frames; ) {
+            FramePool::Handle slot = frameSlot(pool, frame);
+            if (slot && ring.push(std::move(slot), 0)) {
+                ++frame;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // Consumer sees every frame, in order, without locks
+    bool inOrder = true;
+    for (int64_t frame = 0; frame < frames && inOrder; ) {
+        FramePool::Handle slot = ring.find(frame, 0);
+        if (!slot) {
+            std::this_thread::yield();
+            continue;
+        }
+        inOrder = slot->frameNumber == frame && ring.oldestFrame() == frame;
+        slot.reset();
+        ring.dropBefore(++frame, 0);
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQ(ring.size(), static_cast<size_t>(0));
+    TEST_ASSERT_EQ(pool->available(), static_cast<size_t>(8));
+    return true;
+}
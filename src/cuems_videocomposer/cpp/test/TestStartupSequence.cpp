@@ -0,0 +1,72 @@
+#include "TestFramework.h"
+#include "../utils/StartupSequence.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_StartupSequence_Order() {
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::mutex mutex;
+    std::vector<std::string> order;
+    std::atomic<bool> displayOnMain(false);
+    auto record = [&](const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(name);
+    };
+
+    StartupSequence sequence;
+    sequence.add("display", [&] {
+        displayOnMain = std::this_thread::get_id() == mainThread;
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        record("display");
+        return true;
+    }, {}, true);
+    sequence.add("layers", [&] { record("layers"); return true; });
+    sequence.add("remote", [&] { record("remote"); return true; }, {"layers"});
+    sequence.add("loader", [&] { record("loader"); return true; }, {"display", "layers"}, true);
+    TEST_ASSERT(sequence.run());
+    TEST_ASSERT(displayOnMain);
+
+    // Background steps don't wait for the display; dependants wait for both
+    TEST_ASSERT(order.size() == 4);
+    TEST_ASSERT(order[0] == "layers" && order[1] == "remote");
+    TEST_ASSERT(order[2] == "display" && order[3] == "loader");
+
+    const std::vector<StartupSequence::Timing>& timings = sequence.timings();
+    TEST_ASSERT(timings.size() == 4 && timings[0].name == "display");
+    TEST_ASSERT(timings[0].ran && timings[0].ok && timings[0].durationMs >= 25.0);
+    TEST_ASSERT(timings[3].startMs >= timings[0].startMs + timings[0].durationMs);
+    TEST_ASSERT(sequence.totalMs() >= timings[0].durationMs);
+    return true;
+}
+
+bool test_StartupSequence_Failure() {
+    std::atomic<int> ran(0);
+    StartupSequence sequence;
+    sequence.add("config", [] { return true; }, {}, true);
+    sequence.add("display", [] { return false; }, {"config"}, true);
+    sequence.add("sync", [&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++ran;
+        return true;
+    }, {"config"});
+    sequence.add("layer", [&] { ++ran; return true; }, {"display"}, true);
+    TEST_ASSERT(!sequence.run());
+
+    // The running step finishes, the dependant never starts
+    TEST_ASSERT(ran == 1);
+    TEST_ASSERT(sequence.timings()[1].ran && !sequence.timings()[1].ok);
+    TEST_ASSERT(sequence.timings()[2].ok);
+    TEST_ASSERT(!sequence.timings()[3].ran);
+
+    // Naming a step that doesn't exist fails the run
+    StartupSequence typo;
+    typo.add("remote", [] { return true; }, {"layres"});
+    TEST_ASSERT(!typo.run());
+    return true;
+}
@@ -0,0 +1,100 @@
+#include "TestFramework.h"
+#include "../display/SyncLatencyMonitor.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+const int64_t VSYNC_NS = 1000000000 / 60;
+
+PresentedFrame flip(int64_t msc, int64_t tag) {
+    PresentedFrame frame;
+    frame.msc = msc;
+    frame.flipNs = 1000000000 + msc * VSYNC_NS;
+    frame.tag = tag;
+    return frame;
+}
+
+} // namespace
+
+bool test_SyncLatencyMonitor_Cadence() {
+    SyncLatencyMonitor monitor;
+    monitor.configure(60.0, 24.0);
+
+    // 24 fps on 60 Hz: holds of 2 and 3 (the 3:2 pulldown)
+    const int pattern[] = {3, 2};
+    int64_t msc = 100;
+    for (int64_t tag = 0; tag < 41; ++tag) {
+        if (tag > 0) {
+            msc += pattern[(tag - 1) % 2];
+        }
+        monitor.recordPresented(flip(msc, tag), -1);
+        monitor.recordPresented(flip(msc + 1, tag), -1);  // Repeat flip of the same frame
+    }
+    SyncLatencyMonitor::Report report = monitor.getReport();
+    TEST_ASSERT_EQ(report.frames, static_cast<int64_t>(41));
+    TEST_ASSERT_EQ(report.totalHolds, static_cast<int64_t>(40));
+    TEST_ASSERT_EQ(report.correctHolds, static_cast<int64_t>(40));
+    TEST_ASSERT_EQ(report.holds[2], static_cast<int64_t>(20));
+    TEST_ASSERT_EQ(report.holds[3], static_cast<int64_t>(20));
+    TEST_ASSERT_TRUE(report.maxPhaseError < 1.0);
+    TEST_ASSERT_EQ(report.skipped, static_cast<int64_t>(0));
+
+    // A 4-vsync hold, a skipped frame, a step back and a locate
+    monitor.recordPresented(flip(msc + 4, 41), -1);
+    monitor.recordPresented(flip(msc + 6, 43), -1);
+    monitor.recordPresented(flip(msc + 8, 42), -1);
+    monitor.recordPresented(flip(msc + 10, 5000), -1);
+    monitor.recordPresented(flip(msc + 11, -1), -1);
+    report = monitor.getReport();
+    TEST_ASSERT_EQ(report.holds[4], static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(report.correctHolds, static_cast<int64_t>(41));
+    TEST_ASSERT_EQ(report.skipped, static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(report.backwards, static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(report.locates, static_cast<int64_t>(1));
+    TEST_ASSERT_EQ(report.unknown, static_cast<int64_t>(1));
+    TEST_ASSERT_TRUE(report.maxPhaseError > 1.0);
+    TEST_ASSERT_EQ(monitor.formatReport().size(), static_cast<size_t>(5));
+
+    monitor.reset();
+    TEST_ASSERT_EQ(monitor.getReport().frames, static_cast<int64_t>(0));
+    return true;
+}
+
+bool test_SyncLatencyMonitor_Latency() {
+    SyncLatencyMonitor monitor;
+    monitor.configure(60.0, 30.0);
+
+    // Against the plan: frame 10 planned for vsync 200, shown at 201
+    monitor.recordPlan(200, 10);
+    monitor.recordPlan(202, 11);
+    monitor.recordPresented(flip(201, 10), -1);
+    monitor.recordPresented(flip(203, 11), -1);
+    SyncLatencyMonitor::Report report = monitor.getReport();
+    TEST_ASSERT_FALSE(report.latencyFromClock);
+    TEST_ASSERT_EQ(report.latency.samples, static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(std::fabs(report.latency.p50Ms - 1000.0 / 60.0) < 1e-6);
+
+    // Against the timecode: flips 40 ms after the source reached the frame
+    monitor.reset();
+    for (int64_t tag = 0; tag < 10; ++tag) {
+        PresentedFrame frame = flip(300 + tag * 2, tag);
+        monitor.recordPresented(frame, frame.flipNs / 1000 - 40000);
+    }
+    report = monitor.getReport();
+    TEST_ASSERT_TRUE(report.latencyFromClock);
+    TEST_ASSERT_TRUE(std::fabs(report.latency.maxMs - 40.0) < 1e-6);
+    TEST_ASSERT_TRUE(std::fabs(report.latency.minMs - 40.0) < 1e-6);
+
+    // Photodiode edge 12 ms after the last flip, matched once
+    int64_t lastFlip = flip(318, 9).flipNs;
+    TEST_ASSERT_TRUE(monitor.recordPhotodiodeEdge(lastFlip + 12000000));
+    TEST_ASSERT_FALSE(monitor.recordPhotodiodeEdge(lastFlip + 13000000));
+    TEST_ASSERT_FALSE(monitor.recordPhotodiodeEdge(lastFlip + 500000000));
+    report = monitor.getReport();
+    TEST_ASSERT_EQ(report.photon.samples, static_cast<size_t>(1));
+    TEST_ASSERT_TRUE(std::fabs(report.photon.p50Ms - 12.0) < 1e-6);
+    return true;
+}
@@ -0,0 +1,122 @@
+#include "TestFramework.h"
+#include "../remote/TelemetryPublisher.h"
+#include <cmath>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+struct Message {
+    std::string target;
+    std::string path;
+    std::string label;
+    std::vector<double> values;
+};
+
+} // namespace
+
+bool test_TelemetryPublisher_Histogram() {
+    FrameTimeHistogram histogram;
+    TEST_ASSERT_EQ(histogram.percentile(0.5), 0.0);
+
+    // 98 frames at 16.6 ms, two spikes
+    for (int i = 0; i < 98; ++i) {
+        histogram.record(16.6);
+    }
+    histogram.record(33.3);
+    histogram.record(250.0);
+    TEST_ASSERT_EQ(histogram.getCount(), static_cast<uint64_t>(100));
+
+    // Upper bucket edges; the open-ended last bucket reports the max
+    TEST_ASSERT_TRUE(std::fabs(histogram.percentile(0.50) - 16.75) < 1e-9);
+    TEST_ASSERT_TRUE(std::fabs(histogram.percentile(0.98) - 16.75) < 1e-9);
+    TEST_ASSERT_TRUE(std::fabs(histogram.percentile(0.99) - 33.5) < 1e-9);
+    TEST_ASSERT_TRUE(std::fabs(histogram.percentile(1.0) - 250.0) < 1e-9);
+    TEST_ASSERT_TRUE(std::fabs(histogram.getMax() - 250.0) < 1e-9);
+
+    histogram.reset();
+    TEST_ASSERT_EQ(histogram.getCount(), static_cast<uint64_t>(0));
+    return true;
+}
+
+bool test_TelemetryPublisher_Publish() {
+    TelemetryPublisher telemetry;
+    std::vector<Message> sent;
+    auto send = [&sent](const std::string& target, const std::string& path,
+                        const std::string& label, const std::vector<double>& values) {
+        sent.push_back({target, path, label, values});
+        return true;
+    };
+
+    TEST_ASSERT_FALSE(telemetry.isDue(0));
+    TEST_ASSERT_TRUE(telemetry.subscribe("127.0.0.1:9000", 2.0, 0));
+    TEST_ASSERT_TRUE(telemetry.isDue(0));
+
+    // First message: totals have no baseline yet
+    telemetry.recordFrame(16.0);
+    TelemetryPublisher::Sample& sample = telemetry.beginSample();
+    sample.lateFrames = 5;
+    sample.syncJitterMs = 0.8;
+    TelemetryPublisher::LayerSample* layer = telemetry.addLayer();
+    layer->layerId = 1;
+    layer->cueId = "cue-a";
+    layer->decodedFrames = 100;
+    layer->underruns = 2;
+    layer->queueDepth = 6;
+    TEST_ASSERT_EQ(telemetry.publish(0, send), static_cast<size_t>(2));
+    TEST_ASSERT_EQ(sent[0].path, std::string("/videocomposer/telemetry/global"));
+    TEST_ASSERT_EQ(sent[0].values.size(), static_cast<size_t>(14));
+    TEST_ASSERT_EQ(sent[0].values[5], -1.0);
+    TEST_ASSERT_EQ(sent[0].values[7], -1.0);
+    TEST_ASSERT_TRUE(std::fabs(sent[0].values[12] - 0.8) < 1e-9);
+    TEST_ASSERT_EQ(sent[0].values[13], 1.0);
+    TEST_ASSERT_EQ(sent[1].path, std::string("/videocomposer/telemetry/layer"));
+    TEST_ASSERT_EQ(sent[1].label, std::string("cue-a"));
+    TEST_ASSERT_EQ(sent[1].values[1], -1.0);
+    TEST_ASSERT_EQ(sent[1].values[2], 6.0);
+
+    // Not due again for half a second
+    TEST_ASSERT_FALSE(telemetry.isDue(400000));
+    TEST_ASSERT_EQ(telemetry.publish(400000, send), static_cast<size_t>(0));
+
+    // Second message: rates and deltas since the first
+    sent.clear();
+    for (int i = 0; i < 30; ++i) {
+        telemetry.recordFrame(i == 0 ? 40.0 : 16.0);
+    }
+    TelemetryPublisher::Sample& next = telemetry.beginSample();
+    next.lateFrames = 7;
+    layer = telemetry.addLayer();
+    layer->layerId = 1;
+    layer->cueId = "cue-a";
+    layer->decodedFrames = 112;
+    layer->underruns = 3;
+    layer->queueDepth = 4;
+    layer = telemetry.addLayer();
+    layer->layerId = 2;
+    layer->cueId = "cue-b";
+    layer->decodedFrames = 10;
+    TEST_ASSERT_EQ(telemetry.publish(500000, send), static_cast<size_t>(3));
+    TEST_ASSERT_TRUE(std::fabs(sent[0].values[0] - 0.5) < 1e-9);
+    TEST_ASSERT_TRUE(std::fabs(sent[0].values[1] - 16.25) < 1e-9);
+    TEST_ASSERT_TRUE(std::fabs(sent[0].values[4] - 40.0) < 1e-9);
+    TEST_ASSERT_EQ(sent[0].values[5], 2.0);
+    TEST_ASSERT_EQ(sent[0].values[12], -1.0);
+    TEST_ASSERT_TRUE(std::fabs(sent[1].values[1] - 24.0) < 1e-9);
+    TEST_ASSERT_EQ(sent[1].values[3], 1.0);
+    // A layer new since the last message has no rate yet
+    TEST_ASSERT_EQ(sent[2].label, std::string("cue-b"));
+    TEST_ASSERT_EQ(sent[2].values[1], -1.0);
+
+    // Full, then unsubscribing frees a place
+    for (size_t i = 1; i < TelemetryPublisher::MAX_SUBSCRIBERS; ++i) {
+        TEST_ASSERT_TRUE(telemetry.subscribe("host:" + std::to_string(i), 1.0, 0));
+    }
+    TEST_ASSERT_FALSE(telemetry.subscribe("host:99", 1.0, 0));
+    TEST_ASSERT_TRUE(telemetry.unsubscribe("127.0.0.1:9000"));
+    TEST_ASSERT_FALSE(telemetry.unsubscribe("127.0.0.1:9000"));
+    TEST_ASSERT_TRUE(telemetry.subscribe("host:99", 1.0, 0));
+    TEST_ASSERT_EQ(telemetry.getSubscriberCount(), TelemetryPublisher::MAX_SUBSCRIBERS);
+    return true;
+}
@@ -0,0 +1,164 @@
+#include "TestFramework.h"
+#include "../video/TexturePool.h"
+#include "../video/MemoryBudget.h"
+#include <map>
+#include <set>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// GL stand-in: names count up, fences signal when told to
+struct FakeGL {
+    GLuint nextName = 1;
+    int created = 0;
+    std::set<GLuint> deleted;
+    std::map<void*, bool> fences;  // fence -> signalled
+    int nextFence = 1;
+
+    TexturePool::Backend backend() {
+        TexturePool::Backend backend;
+        backend.createTexture = [this](const TexturePool::Key&) { created++; return nextName++; };
+        backend.deleteTexture = [this](GLuint texture) { deleted.insert(texture); };
+        backend.createBuffer = [this](size_t) { created++; return nextName++; };
+        backend.deleteBuffer = [this](GLuint buffer) { deleted.insert(buffer); };
+        backend.fence = [this]() {
+            void* fence = reinterpret_cast<void*>(static_cast<uintptr_t>(nextFence++));
+            fences[fence] = false;
+            return fence;
+        };
+        backend.signalled = [this](void* fence) { return fences[fence]; };
+        backend.deleteFence = [this](void* fence) { fences.erase(fence); };
+        backend.immutableStorage = []() { return true; };
+        return backend;
+    }
+
+    void signalAll() {
+        for (auto& fence : fences) {
+            fence.second = true;
+        }
+    }
+};
+
+TexturePool::Key key(int width, int height, GLenum format = 0x8058 /* GL_RGBA8 */) {
+    TexturePool::Key k;
+    k.width = width;
+    k.height = height;
+    k.internalFormat = format;
+    return k;
+}
+
+} // namespace
+
+bool test_TexturePool_RecyclesAfterFence() {
+    FakeGL gl;
+    TexturePool pool(gl.backend());
+
+    GLuint first = pool.acquireTexture(key(1920, 1080));
+    TEST_ASSERT_TRUE(first != 0);
+    pool.releaseTexture(first, key(1920, 1080));
+
+    // Still read by queued draws: a new texture instead of waiting
+    GLuint second = pool.acquireTexture(key(1920, 1080));
+    TEST_ASSERT_TRUE(second != first);
+    TEST_ASSERT_EQ(gl.created, 2);
+
+    // Fence signalled: the same storage comes back, no allocation
+    gl.signalAll();
+    GLuint third = pool.acquireTexture(key(1920, 1080));
+    TEST_ASSERT_EQ(third, first);
+    TEST_ASSERT_EQ(gl.created, 2);
+    TEST_ASSERT_TRUE(gl.fences.empty());
+
+    // Other size or format: never handed out
+    pool.releaseTexture(third, key(1920, 1080));
+    gl.signalAll();
+    TEST_ASSERT_TRUE(pool.acquireTexture(key(1280, 720)) != first);
+    TEST_ASSERT_TRUE(pool.acquireTexture(key(1920, 1080, 0x83F3)) != first);
+
+    TexturePool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQ(stats.textureHits, static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(stats.freeTextures, static_cast<size_t>(1));
+    TEST_ASSERT_EQ(stats.freeBytes, static_cast<size_t>(1920 * 1080 * 4));
+
+    // Buffers: the smallest one that fits
+    pool.releaseBuffer(pool.acquireBuffer(4096), 4096);
+    pool.releaseBuffer(pool.acquireBuffer(1024), 1024);
+    gl.signalAll();
+    GLuint small = pool.acquireBuffer(512);
+    TEST_ASSERT_EQ(pool.getStats().bufferHits, static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(small, gl.nextName - 1);
+    return true;
+}
+
+bool test_TexturePool_TrimsOldestOverLimit() {
+    FakeGL gl;
+    TexturePool pool(gl.backend());
+    size_t bytes = TexturePool::textureBytes(key(256, 256));
+    pool.setLimit(bytes * 2);
+
+    GLuint textures[3];
+    for (GLuint& texture : textures) {
+        texture = pool.acquireTexture(key(256, 256));
+    }
+    for (GLuint texture : textures) {
+        pool.releaseTexture(texture, key(256, 256));
+    }
+    gl.signalAll();
+    pool.collect();
+
+    // Oldest release goes first
+    TEST_ASSERT_EQ(gl.deleted.size(), static_cast<size_t>(1));
+    TEST_ASSERT_TRUE(gl.deleted.count(textures[0]) == 1);
+    TEST_ASSERT_EQ(pool.getStats().freeBytes, bytes * 2);
+    TEST_ASSERT_EQ(pool.getStats().trimmed, static_cast<uint64_t>(1));
+
+    pool.clear();
+    TEST_ASSERT_EQ(gl.deleted.size(), static_cast<size_t>(3));
+    TEST_ASSERT_EQ(pool.getStats().freeBytes, static_cast<size_t>(0));
+
+    // Block-compressed and mipmapped sizes
+    TEST_ASSERT_EQ(TexturePool::textureBytes(key(1920, 1080, 0x83F0)), static_cast<size_t>(480 * 270 * 8));
+    TEST_ASSERT_EQ(TexturePool::fullMipLevels(1920, 1080), 11);
+    TEST_ASSERT_EQ(TexturePool::fullMipLevels(1, 1), 1);
+    return true;
+}
+
+bool test_TexturePool_EvictsRecycledForBudget() {
+    FakeGL gl;
+    MemoryBudget budget;
+    size_t bytes = TexturePool::textureBytes(key(256, 256));
+    budget.setLimit(MemoryBudget::Pool::VRAM, bytes * 2);
+    TexturePool pool(gl.backend(), &budget);
+    MemoryBudget::Account layer(MemoryBudget::Subsystem::LAYER_TEXTURES, 1);
+
+    GLuint first = pool.acquireTexture(key(256, 256), layer);
+    GLuint second = pool.acquireTexture(key(256, 256), layer);
+    TEST_ASSERT_TRUE(first != 0 && second != 0);
+
+    // Full and nothing recycled: refused instead of allocated
+    TEST_ASSERT_EQ(pool.acquireTexture(key(128, 128), layer), static_cast<GLuint>(0));
+    TEST_ASSERT_EQ(pool.getStats().refused, static_cast<uint64_t>(1));
+    TEST_ASSERT_EQ(gl.created, 2);
+
+    // Released textures stay charged to the pool until evicted for a new one
+    pool.releaseTexture(first, key(256, 256));
+    gl.signalAll();
+    pool.collect();
+    MemoryBudget::Report report = budget.getReport();
+    TEST_ASSERT_EQ(report.subsystems[static_cast<size_t>(MemoryBudget::Subsystem::TEXTURE_POOL)], bytes);
+    TEST_ASSERT_TRUE(pool.acquireTexture(key(128, 128), layer) != 0);
+    TEST_ASSERT_TRUE(gl.deleted.count(first) == 1);
+    report = budget.getReport();
+    TEST_ASSERT_EQ(report.subsystems[static_cast<size_t>(MemoryBudget::Subsystem::TEXTURE_POOL)], static_cast<size_t>(0));
+    TEST_ASSERT_EQ(report.subsystems[static_cast<size_t>(MemoryBudget::Subsystem::LAYER_TEXTURES)],
+                   bytes + TexturePool::textureBytes(key(128, 128)));
+
+    // Moved between accounts without changing the total
+    pool.reassignTexture(second, MemoryBudget::Account(MemoryBudget::Subsystem::ARMED_UPLOADS, 2));
+    report = budget.getReport();
+    TEST_ASSERT_EQ(report.subsystems[static_cast<size_t>(MemoryBudget::Subsystem::ARMED_UPLOADS)], bytes);
+    TEST_ASSERT_EQ(report.pools[0].used, bytes + TexturePool::textureBytes(key(128, 128)));
+    return true;
+}
@@ -0,0 +1,51 @@
+#include "TestFramework.h"
+#include "../utils/ThreadRoles.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_ThreadRoles_Parse() {
+    ThreadRoles::Policy policy;
+
+    // Render on two isolated cores
+    TEST_ASSERT(ThreadRoles::parse("fifo:70@2-3", policy));
+    TEST_ASSERT(policy.scheduler == ThreadRoles::FIFO);
+    TEST_ASSERT_EQ(policy.priority, 70);
+    TEST_ASSERT_EQ(static_cast<int>(policy.cpus.size()), 2);
+    TEST_ASSERT_EQ(policy.cpus[0], 2);
+    TEST_ASSERT_EQ(policy.cpus[1], 3);
+
+    // Affinity only: decoders on the remaining cores
+    TEST_ASSERT(ThreadRoles::parse("@0-1,4", policy));
+    TEST_ASSERT(policy.scheduler == ThreadRoles::OTHER);
+    TEST_ASSERT_EQ(policy.priority, 0);
+    TEST_ASSERT_EQ(static_cast<int>(policy.cpus.size()), 3);
+    TEST_ASSERT_EQ(policy.cpus[2], 4);
+
+    // Real-time without a priority gets the middle one; no CPUs = all
+    TEST_ASSERT(ThreadRoles::parse("rr", policy));
+    TEST_ASSERT(policy.scheduler == ThreadRoles::RR);
+    TEST_ASSERT_EQ(policy.priority, 50);
+    TEST_ASSERT(policy.cpus.empty());
+    TEST_ASSERT(ThreadRoles::parse("batch", policy));
+    TEST_ASSERT(policy.scheduler == ThreadRoles::BATCH);
+    return true;
+}
+
+bool test_ThreadRoles_ParseRejects() {
+    ThreadRoles::Policy policy;
+    policy.priority = 42;
+    TEST_ASSERT(!ThreadRoles::parse("deadline", policy));
+    TEST_ASSERT(!ThreadRoles::parse("fifo:0", policy));
+    TEST_ASSERT(!ThreadRoles::parse("fifo:100", policy));
+    TEST_ASSERT(!ThreadRoles::parse("other:10", policy));   // Priority is real-time only
+    TEST_ASSERT(!ThreadRoles::parse("fifo:70@", policy));
+    TEST_ASSERT(!ThreadRoles::parse("fifo:70@3-1", policy));
+    TEST_ASSERT(!ThreadRoles::parse("fifo:70@2,,3", policy));
+    TEST_ASSERT(!ThreadRoles::parse("fifo:x", policy));
+    TEST_ASSERT_EQ(policy.priority, 42);                    // Untouched on failure
+
+    TEST_ASSERT(std::string(ThreadRoles::roleName(ThreadRole::RENDER)) == "render");
+    TEST_ASSERT(std::string(ThreadRoles::roleName(ThreadRole::OUTPUT)) == "output");
+    return true;
+}
@@ -0,0 +1,130 @@
+#include "TestFramework.h"
+#include "../input/ThumbnailService.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Results of the worker, waited for up to a few seconds
+std::vector<ThumbnailService::Result> waitResults(ThumbnailService& service, size_t count) {
+    std::vector<ThumbnailService::Result> results;
+    for (int i = 0; i < 500 && results.size() < count; ++i) {
+        service.takeResults([&](const ThumbnailService::Result& result) { results.push_back(result); });
+        if (results.size() < count) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    return results;
+}
+
+} // namespace
+
+bool test_ThumbnailService_FitSize() {
+    int w = 0, h = 0;
+    ThumbnailService::fitSize(1920, 1080, 1, 1, 320, w, h);
+    TEST_ASSERT(w == 320 && h == 180);
+
+    // Anamorphic PAL widescreen: 720x576 shown 1024 wide
+    ThumbnailService::fitSize(720, 576, 64, 45, 320, w, h);
+    TEST_ASSERT(w == 320 && h == 180);
+
+    // Never upscaled
+    ThumbnailService::fitSize(160, 120, 0, 0, 320, w, h);
+    TEST_ASSERT(w == 160 && h == 120);
+
+    // Even sizes for 4:2:0
+    ThumbnailService::fitSize(1000, 333, 1, 1, 321, w, h);
+    TEST_ASSERT(w % 2 == 0 && h % 2 == 0);
+    TEST_ASSERT(w >= 320 && w <= 322 && h >= 106 && h <= 108);
+
+    ThumbnailService::fitSize(0, 1080, 1, 1, 320, w, h);
+    TEST_ASSERT(w == 0 && h == 0);
+    return true;
+}
+
+bool test_ThumbnailService_CachePath() {
+    using Format = ThumbnailService::Format;
+    std::string a = ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1000, 5, 1.5, 320, Format::JPEG);
+    TEST_ASSERT_EQ(a, ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1000, 5, 1.5, 320, Format::JPEG));
+    TEST_ASSERT(a.compare(0, 7, "/cache/") == 0);
+    TEST_ASSERT(a.find("-1500ms-320w.jpg") != std::string::npos);
+
+    // A replaced file, another time or width: another image
+    TEST_ASSERT(a != ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1001, 5, 1.5, 320, Format::JPEG));
+    TEST_ASSERT(a != ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1000, 6, 1.5, 320, Format::JPEG));
+    TEST_ASSERT(a != ThumbnailService::cachePathFor("/cache", "/media/b.mov", 1000, 5, 1.5, 320, Format::JPEG));
+    TEST_ASSERT(a != ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1000, 5, 2.0, 320, Format::JPEG));
+    TEST_ASSERT(a != ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1000, 5, 1.5, 640, Format::JPEG));
+    std::string png = ThumbnailService::cachePathFor("/cache", "/media/a.mov", 1000, 5, 1.5, 320, Format::PNG);
+    TEST_ASSERT(png.size() > 4 && png.compare(png.size() - 4, 4, ".png") == 0);
+
+    TEST_ASSERT(ThumbnailService::parseFormat("PNG") == Format::PNG);
+    TEST_ASSERT(ThumbnailService::parseFormat("jpeg") == Format::JPEG);
+    TEST_ASSERT(ThumbnailService::parseFormat("webp") == Format::JPEG);
+    return true;
+}
+
+bool test_ThumbnailService_Requests() {
+    char directory[] = "/tmp/thumbnails-XXXXXX";
+    TEST_ASSERT(mkdtemp(directory) != nullptr);
+    std::string cacheDir = std::string(directory) + "/cache";
+    std::string clip = std::string(directory) + "/clip.mov";
+    FILE* file = std::fopen(clip.c_str(), "wb");
+    TEST_ASSERT(file != nullptr);
+    std::fputs("not decoded: the thumbnail is cached", file);
+    std::fclose(file);
+
+    // Cached thumbnail of the clip at 2 s
+    struct stat st;
+    TEST_ASSERT(stat(clip.c_str(), &st) == 0);
+    int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    std::string cached = ThumbnailService::cachePathFor(cacheDir, clip, static_cast<uint64_t>(st.st_size), mtimeNs,
+                                                        2.0, 200, ThumbnailService::Format::JPEG);
+    TEST_ASSERT(mkdir(cacheDir.c_str(), 0755) == 0);
+    file = std::fopen(cached.c_str(), "wb");
+    TEST_ASSERT(file != nullptr);
+    std::fputs("jpeg", file);
+    std::fclose(file);
+
+    ThumbnailService service;
+    ThumbnailService::Settings settings;
+    settings.cacheDir = cacheDir;
+    settings.width = 200;
+    service.configure(settings);
+
+    ThumbnailService::Request hit;
+    hit.path = clip;
+    hit.seconds = 2.0;
+    hit.target = "127.0.0.1:9000";
+    TEST_ASSERT(service.request(hit));
+    ThumbnailService::Request missing = hit;
+    missing.path = std::string(directory) + "/missing.mov";
+    TEST_ASSERT(service.request(missing));
+
+    std::vector<ThumbnailService::Result> results = waitResults(service, 2);
+    TEST_ASSERT_EQ(results.size(), static_cast<size_t>(2));
+    const ThumbnailService::Result& first = results[0].request.path == clip ? results[0] : results[1];
+    const ThumbnailService::Result& second = results[0].request.path == clip ? results[1] : results[0];
+    TEST_ASSERT(first.ok && first.cached);
+    TEST_ASSERT_EQ(first.file, cached);
+    TEST_ASSERT_EQ(first.data, std::string("jpeg"));
+    TEST_ASSERT_EQ(first.request.target, std::string("127.0.0.1:9000"));
+    TEST_ASSERT_FALSE(second.ok);
+    TEST_ASSERT_EQ(service.getPendingCount(), static_cast<size_t>(0));
+    service.stop();
+
+    std::remove(cached.c_str());
+    rmdir(cacheDir.c_str());
+    std::remove(clip.c_str());
+    rmdir(directory);
+    return true;
+}
@@ -0,0 +1,122 @@
+#include "TestFramework.h"
+#include "../video/TilePyramid.h"
+#include "../video/TileResidency.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// 20000x10000 image shown at `scale` screen pixels per image texel, its
+// top-left corner at the top-left of a 1920x1080 viewport
+TilePyramid::Projector viewAt(float scale) {
+    return [scale](float u0, float v0, float u1, float v1, float& across, float& down) {
+        float x0 = u0 * 20000.0f * scale;
+        float y0 = v0 * 10000.0f * scale;
+        across = (u1 - u0) * 20000.0f * scale;
+        down = (v1 - v0) * 10000.0f * scale;
+        return x0 < 1920.0f && y0 < 1080.0f;
+    };
+}
+
+} // namespace
+
+bool test_TilePyramid_Levels() {
+    TilePyramid pyramid(20000, 10000, 512);
+    TEST_ASSERT_EQ(pyramid.getLevelCount(), 7);
+    TEST_ASSERT_EQ(pyramid.tilesX(0), 40);
+    TEST_ASSERT_EQ(pyramid.tilesY(0), 20);
+    TEST_ASSERT_EQ(pyramid.levelWidth(5), 625);
+    TEST_ASSERT_EQ(pyramid.levelHeight(6), 157);
+    TEST_ASSERT_EQ(pyramid.tilesX(6), 1);
+    TEST_ASSERT_EQ(pyramid.tilesY(6), 1);
+
+    // Indices run level by level and back
+    TilePyramid::Tile tile;
+    tile.level = 3;
+    tile.x = 4;
+    tile.y = 2;
+    uint32_t index = pyramid.tileIndex(tile);
+    TilePyramid::Tile back = pyramid.tileAt(index);
+    TEST_ASSERT_EQ(back.level, 3);
+    TEST_ASSERT_EQ(back.x, 4);
+    TEST_ASSERT_EQ(back.y, 2);
+    TEST_ASSERT_EQ(static_cast<size_t>(pyramid.tileIndex(TilePyramid::Tile{6, 0, 0})) + 1, pyramid.getTileCount());
+
+    // Edge tiles: partial texels, region clamped to the image
+    TilePyramid::Tile edge{0, 39, 19};
+    TEST_ASSERT_EQ(pyramid.tileTexelsX(edge), 20000 - 39 * 512);
+    TEST_ASSERT_EQ(pyramid.tileTexelsY(edge), 10000 - 19 * 512);
+    float u0, v0, u1, v1;
+    pyramid.tileRegion(edge, u0, v0, u1, v1);
+    TEST_ASSERT_EQ(u1, 1.0f);
+    TEST_ASSERT_EQ(v1, 1.0f);
+    float tx, ty;
+    pyramid.tileTexels(edge, u0, v0, tx, ty);
+    TEST_ASSERT_TRUE(tx > -0.01f && tx < 0.01f && ty > -0.01f && ty < 0.01f);
+
+    TEST_ASSERT_EQ(TilePyramid(0, 100).getTileCount(), static_cast<size_t>(0));
+    return true;
+}
+
+bool test_TilePyramid_Select() {
+    TilePyramid pyramid(20000, 10000, 512);
+    std::vector<TilePyramid::Tile> tiles;
+
+    // Whole image across the viewport: the level nearest one texel per pixel
+    pyramid.select(viewAt(1920.0f / 20000.0f), 1000, tiles);
+    TEST_ASSERT_EQ(tiles.size(), static_cast<size_t>(15));
+    for (const TilePyramid::Tile& tile : tiles) {
+        TEST_ASSERT_EQ(tile.level, 3);
+    }
+
+    // One to one: only the full-resolution tiles under the viewport
+    pyramid.select(viewAt(1.0f), 1000, tiles);
+    TEST_ASSERT_EQ(tiles.size(), static_cast<size_t>(12));
+    for (const TilePyramid::Tile& tile : tiles) {
+        TEST_ASSERT_EQ(tile.level, 0);
+        TEST_ASSERT_TRUE(tile.x < 4 && tile.y < 3);
+    }
+
+    // Over the budget: coarser, never more tiles than allowed
+    pyramid.select(viewAt(1.0f), 6, tiles);
+    TEST_ASSERT_FALSE(tiles.empty());
+    TEST_ASSERT_TRUE(tiles.size() <= 6);
+    TEST_ASSERT_TRUE(tiles[0].level > 0);
+
+    // Off screen: nothing
+    pyramid.select([](float, float, float, float, float&, float&) { return false; }, 1000, tiles);
+    TEST_ASSERT_TRUE(tiles.empty());
+    return true;
+}
+
+bool test_TileResidency_Lru() {
+    TileResidency residency(2);
+    uint32_t evicted = 0;
+    int a = residency.allocate(10, 1, evicted);
+    TEST_ASSERT_TRUE(a >= 0);
+    TEST_ASSERT_EQ(evicted, TileResidency::NO_TILE);
+    int b = residency.allocate(11, 1, evicted);
+    TEST_ASSERT_TRUE(b >= 0 && b != a);
+
+    // Both on screen at this stamp: nothing to give up
+    TEST_ASSERT_EQ(residency.allocate(12, 1, evicted), -1);
+
+    // Next draw: the tile not used again goes first
+    TEST_ASSERT_EQ(residency.use(11, 2), b);
+    TEST_ASSERT_EQ(residency.allocate(12, 2, evicted), a);
+    TEST_ASSERT_EQ(evicted, static_cast<uint32_t>(10));
+    TEST_ASSERT_EQ(residency.find(10), -1);
+    TEST_ASSERT_EQ(residency.getResidentCount(), static_cast<size_t>(2));
+
+    // Pinned tiles stay whatever their last use
+    residency.pin(11);
+    TEST_ASSERT_EQ(residency.allocate(13, 3, evicted), a);
+    TEST_ASSERT_EQ(evicted, static_cast<uint32_t>(12));
+    TEST_ASSERT_EQ(residency.allocate(14, 3, evicted), -1);
+    TEST_ASSERT_EQ(residency.find(11), b);
+
+    residency.clear();
+    TEST_ASSERT_EQ(residency.getResidentCount(), static_cast<size_t>(0));
+    return true;
+}
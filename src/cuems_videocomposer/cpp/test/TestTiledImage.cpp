@@ -0,0 +1,142 @@
+#include "TestFramework.h"
+#include "../input/TiledImage.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+std::string makeTempDir() {
+    char tmpl[] = "/tmp/cvc_tiles_XXXXXX";
+    const char* dir = mkdtemp(tmpl);
+    return dir ? std::string(dir) : std::string();
+}
+
+void pattern(int x, int y, uint8_t* texel) {
+    texel[0] = static_cast<uint8_t>(x);
+    texel[1] = static_cast<uint8_t>(y);
+    texel[2] = static_cast<uint8_t>(x + y);
+    texel[3] = 255;
+}
+
+// width x height of pattern(), rows checked to arrive top to bottom once
+TiledImage::RowSource patternRows(int width, int& nextRow) {
+    return [width, &nextRow](int y, int rows, uint8_t* dst) {
+        if (y != nextRow) {
+            return false;
+        }
+        for (int r = 0; r < rows; ++r) {
+            for (int x = 0; x < width; ++x) {
+                pattern(x, y + r, dst + (static_cast<size_t>(r) * width + x) * 4);
+            }
+        }
+        nextRow = y + rows;
+        return true;
+    };
+}
+
+const uint8_t* texel(const TiledImage& image, const TilePyramid::Tile& tile, int x, int y) {
+    const uint8_t* data = image.tileData(image.getPyramid().tileIndex(tile));
+    return data + (static_cast<size_t>(y + TiledImage::BORDER) * image.getTileStride() + x + TiledImage::BORDER) * 4;
+}
+
+} // namespace
+
+bool test_TiledImage_BuildAndMap() {
+    std::string dir = makeTempDir();
+    TEST_ASSERT_FALSE(dir.empty());
+    TiledImage::SourceIdentity id;
+    id.size = 1234;
+    id.mtimeNs = 5678;
+    std::string path = TiledImage::cachePathFor(dir + "/cache", dir + "/backplate.tif");
+
+    int nextRow = 0;
+    TEST_ASSERT_TRUE(TiledImage::build(path, id, 100, 70, false, 32, patternRows(100, nextRow)));
+    TEST_ASSERT_EQ(nextRow, 70);
+
+    TiledImage image;
+    TEST_ASSERT_TRUE(image.open(path, id));
+    const TilePyramid& pyramid = image.getPyramid();
+    TEST_ASSERT_EQ(pyramid.getLevelCount(), 3);
+    TEST_ASSERT_EQ(pyramid.tilesX(0), 4);
+    TEST_ASSERT_EQ(pyramid.tilesY(0), 3);
+
+    // Interior texel, the border from the neighbour, clamped at the edges
+    uint8_t expected[4];
+    pattern(32, 32, expected);
+    TEST_ASSERT_TRUE(std::equal(expected, expected + 4, texel(image, {0, 1, 1}, 0, 0)));
+    pattern(31, 31, expected);
+    TEST_ASSERT_TRUE(std::equal(expected, expected + 4, texel(image, {0, 1, 1}, -1, -1)));
+    pattern(99, 69, expected);
+    TEST_ASSERT_TRUE(std::equal(expected, expected + 4, texel(image, {0, 3, 2}, 4, 6)));
+    TEST_ASSERT_TRUE(std::equal(expected, expected + 4, texel(image, {0, 3, 2}, 31, 31)));
+
+    // Levels above are box filtered
+    FrameBuffer frame;
+    TEST_ASSERT_TRUE(image.readLevel(1, frame));
+    TEST_ASSERT_EQ(frame.info().width, 50);
+    TEST_ASSERT_EQ(frame.info().height, 35);
+    TEST_ASSERT_EQ(static_cast<int>(frame.data()[(10 * 50 + 20) * 4]), 41);      // (40 + 41 + 40 + 41 + 2) / 4
+    TEST_ASSERT_EQ(static_cast<int>(frame.data()[(10 * 50 + 20) * 4 + 1]), 21);  // (20 + 20 + 21 + 21 + 2) / 4
+    TEST_ASSERT_EQ(image.levelFitting(64), 1);
+    TEST_ASSERT_EQ(image.levelFitting(40), 2);
+
+    // Streamed on request
+    TilePyramid::Tile wanted{0, 2, 1};
+    uint32_t index = pyramid.tileIndex(wanted);
+    image.prefetch({index});
+    for (int i = 0; i < 200 && !image.isPrefetched(index); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    TEST_ASSERT_TRUE(image.isPrefetched(index));
+    TEST_ASSERT_EQ(image.getPrefetchCount(), static_cast<uint64_t>(1));
+    image.close();
+
+    // Another source (or a changed one) does not use the file
+    TiledImage::SourceIdentity changed = id;
+    changed.mtimeNs += 1;
+    TEST_ASSERT_FALSE(image.open(path, changed));
+    TEST_ASSERT_FALSE(image.open(dir + "/missing.cvtiles", id));
+
+    remove(path.c_str());
+    rmdir((dir + "/cache").c_str());
+    rmdir(dir.c_str());
+    return true;
+}
+
+bool test_TiledImage_AlphaWeightedLevels() {
+    std::string dir = makeTempDir();
+    TEST_ASSERT_FALSE(dir.empty());
+    TiledImage::SourceIdentity id;
+    std::string path = dir + "/alpha.cvtiles";
+
+    // Opaque white next to transparent black: the level above stays white
+    auto rows = [](int y, int count, uint8_t* dst) {
+        (void)y;
+        for (int i = 0; i < count * 40; ++i) {
+            uint8_t value = (i % 40) % 2 == 0 ? 255 : 0;
+            for (int c = 0; c < 4; ++c) {
+                dst[i * 4 + c] = value;
+            }
+        }
+        return true;
+    };
+    TEST_ASSERT_TRUE(TiledImage::build(path, id, 40, 1, true, 32, rows));
+    TiledImage image;
+    TEST_ASSERT_TRUE(image.open(path, id));
+    TEST_ASSERT_TRUE(image.hasAlpha());
+    const uint8_t* top = texel(image, {1, 0, 0}, 0, 0);
+    TEST_ASSERT_EQ(static_cast<int>(top[0]), 255);
+    TEST_ASSERT_EQ(static_cast<int>(top[3]), 128);
+    image.close();
+
+    remove(path.c_str());
+    rmdir(dir.c_str());
+    return true;
+}
@@ -0,0 +1,78 @@
+#include "TestFramework.h"
+#include "../sync/TimecodeClock.h"
+#include <cmath>
+#include <cstdlib>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_TimecodeClock_Jitter() {
+    TimecodeClock clock;
+    TEST_ASSERT(clock.getPosition(0) < 0.0);
+
+    // Quarter frames at 25 fps (100 Hz) from a source running 0.1% fast,
+    // delivered up to 4 ms late
+    const double rate = 1.001;
+    std::srand(1);
+    int64_t nextRenderUs = 0;
+    double lastPosition = -1.0;
+    double maxError = 0.0;
+    double maxStepError = 0.0;
+    for (int i = 0; i < 1000; ++i) {
+        double position = 100.0 + i * 0.01;
+        int64_t sentUs = static_cast<int64_t>(i * 0.01 / rate * 1e6);
+        int64_t arrivalUs = 1000000 + sentUs + std::rand() % 4000;
+
+        // 60 Hz renders until this sample arrives
+        while (nextRenderUs < arrivalUs) {
+            double smoothed = clock.getPosition(nextRenderUs);
+            if (i > 300) {
+                // Mean delivery delay is 2 ms of timecode
+                double truth = 100.0 + (nextRenderUs - 1000000) / 1e6 * rate - 0.002;
+                maxError = std::max(maxError, std::fabs(smoothed - truth));
+                maxStepError = std::max(maxStepError, std::fabs(smoothed - lastPosition - rate / 60.0));
+            }
+            TEST_ASSERT(smoothed >= lastPosition);
+            lastPosition = smoothed;
+            nextRenderUs += 1000000 / 60;
+        }
+        clock.addSample(position, arrivalUs);
+    }
+    TEST_ASSERT(std::fabs(clock.getRate() - rate) < 0.001);
+    TEST_ASSERT(maxError < 0.002);
+    // Raw quarter-frame steps would be 6.7 ms off a 60 Hz render period
+    TEST_ASSERT(maxStepError < 0.001);
+    TEST_ASSERT(!clock.wasLocated());
+    // 0-4 ms uniform delivery delay: about 1.2 ms RMS
+    TEST_ASSERT(clock.getJitter() > 0.0005 && clock.getJitter() < 0.003);
+    return true;
+}
+
+bool test_TimecodeClock_Locate() {
+    TimecodeClock clock;
+    for (int i = 0; i < 50; ++i) {
+        clock.addSample(10.0 + i * 0.01, i * 10000);
+    }
+    TEST_ASSERT(std::fabs(clock.getPosition(500000) - 10.5) < 0.001);
+    TEST_ASSERT(clock.getJitter() < 1e-6);
+
+    // Jump to 60 s: followed on the first sample
+    clock.addSample(60.0, 510000);
+    TEST_ASSERT(clock.wasLocated());
+    TEST_ASSERT(!clock.wasLocated());
+    TEST_ASSERT(std::fabs(clock.getPosition(510000) - 60.0) < 1e-9);
+
+    // Backwards locate is allowed too
+    clock.addSample(5.0, 520000);
+    TEST_ASSERT(clock.wasLocated());
+    TEST_ASSERT(std::fabs(clock.getPosition(520000) - 5.0) < 1e-9);
+
+    // No samples: extrapolation stops instead of running away
+    double held = clock.getPosition(520000 + 10000000);
+    TEST_ASSERT(held < 5.0 + 0.11);
+
+    clock.reset();
+    TEST_ASSERT(!clock.isLocked());
+    TEST_ASSERT(clock.getPosition(600000) < 0.0);
+    return true;
+}
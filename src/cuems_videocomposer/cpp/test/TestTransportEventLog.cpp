@@ -0,0 +1,66 @@
+#include "TestFramework.h"
+#include "../sync/TransportEventLog.h"
+#include "../sync/VblankClockSyncSource.h"
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_TransportEventLog_EveryReaderSeesEvents() {
+    TransportEventLog log;
+    std::vector<TransportEvent> events;
+    TEST_ASSERT_EQ(log.read(0, events), static_cast<uint64_t>(0));
+    TEST_ASSERT_TRUE(events.empty());
+
+    log.post(TransportEvent::Kind::STOP, 100);
+    log.post(TransportEvent::Kind::LOCATE, 2500);
+
+    // Two readers (e.g. the app and a per-layer source): the first does not take it from the second
+    uint64_t first = log.read(0, events);
+    TEST_ASSERT_EQ(first, static_cast<uint64_t>(2));
+    TEST_ASSERT_EQ(events.size(), static_cast<size_t>(2));
+    TEST_ASSERT_TRUE(events[1].kind == TransportEvent::Kind::LOCATE);
+    TEST_ASSERT_EQ(events[1].frame, static_cast<int64_t>(2500));
+    events.clear();
+    TEST_ASSERT_EQ(log.read(0, events), static_cast<uint64_t>(2));
+    TEST_ASSERT_EQ(events.size(), static_cast<size_t>(2));
+
+    // Read again from the returned serial: only what is new
+    events.clear();
+    TEST_ASSERT_EQ(log.read(first, events), first);
+    TEST_ASSERT_TRUE(events.empty());
+    log.post(TransportEvent::Kind::START, 2500);
+    log.read(first, events);
+    TEST_ASSERT_EQ(events.size(), static_cast<size_t>(1));
+    TEST_ASSERT_EQ(events[0].serial, static_cast<uint64_t>(3));
+    return true;
+}
+
+bool test_TransportEventLog_KeepsNewest() {
+    TransportEventLog log;
+    for (int i = 0; i < static_cast<int>(TransportEventLog::CAPACITY) + 4; ++i) {
+        log.post(TransportEvent::Kind::LOCATE, i);
+    }
+
+    // A reader far behind gets the newest events, the last locate among them
+    std::vector<TransportEvent> events;
+    TEST_ASSERT_EQ(log.read(0, events), static_cast<uint64_t>(TransportEventLog::CAPACITY + 4));
+    TEST_ASSERT_EQ(events.size(), TransportEventLog::CAPACITY);
+    TEST_ASSERT_EQ(events.front().frame, static_cast<int64_t>(4));
+    TEST_ASSERT_EQ(events.back().frame, static_cast<int64_t>(TransportEventLog::CAPACITY + 3));
+
+    // The internal clock posts its transport calls
+    VblankClockSyncSource clock(25.0);
+    clock.connect();
+    clock.locate(300);
+    clock.stop();
+    clock.stop();
+    events.clear();
+    TEST_ASSERT_EQ(clock.readTransportEvents(0, events), static_cast<uint64_t>(4));
+    TEST_ASSERT_TRUE(events[0].kind == TransportEvent::Kind::LOCATE);
+    TEST_ASSERT_TRUE(events[1].kind == TransportEvent::Kind::START);
+    TEST_ASSERT_TRUE(events[2].kind == TransportEvent::Kind::LOCATE);
+    TEST_ASSERT_EQ(events[2].frame, static_cast<int64_t>(300));
+    TEST_ASSERT_TRUE(events[3].kind == TransportEvent::Kind::STOP);
+    return true;
+}
@@ -0,0 +1,42 @@
+#include "TestFramework.h"
+#include "../input/V4L2VideoInput.h"
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_V4L2VideoInput_CopyTight() {
+    // NV12 4x2 with a 6-byte pitch: 2 luma rows, 1 chroma row
+    FrameInfo info;
+    info.width = 4;
+    info.height = 2;
+    info.format = PixelFormat::NV12;
+    std::vector<uint8_t> padded(6 * 3, 0xEE);
+    for (int row = 0; row < 3; ++row) {
+        for (int x = 0; x < 4; ++x) {
+            padded[row * 6 + x] = static_cast<uint8_t>(row * 10 + x);
+        }
+    }
+
+    FrameBuffer tight;
+    TEST_ASSERT(V4L2VideoInput::copyTight(padded.data(), 6, info, tight));
+    TEST_ASSERT(tight.size() >= 12u);
+    for (int row = 0; row < 3; ++row) {
+        for (int x = 0; x < 4; ++x) {
+            TEST_ASSERT_EQ(tight.data()[row * 4 + x], static_cast<uint8_t>(row * 10 + x));
+        }
+    }
+
+    // Packed YUYV: 2 bytes per pixel, pitch smaller than a row is rejected
+    info.format = PixelFormat::YUYV422;
+    std::vector<uint8_t> packed(12 * 2, 0x11);
+    packed[12] = 0x22;
+    TEST_ASSERT(V4L2VideoInput::copyTight(packed.data(), 12, info, tight));
+    TEST_ASSERT_EQ(tight.data()[8], static_cast<uint8_t>(0x22));
+    TEST_ASSERT(!V4L2VideoInput::copyTight(packed.data(), 6, info, tight));
+
+    // Formats V4L2 never negotiates
+    info.format = PixelFormat::RGBA32;
+    TEST_ASSERT(!V4L2VideoInput::copyTight(packed.data(), 16, info, tight));
+    return true;
+}
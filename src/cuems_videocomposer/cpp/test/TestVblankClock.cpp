@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "../sync/VblankClockSyncSource.h"
+#include <vector>
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+namespace {
+
+// Vblanks each frame is held for, over a number of frames
+std::vector<int> cadence(VblankClockSyncSource& clock, double refreshHz, int64_t firstMsc, int frames) {
+    std::vector<int> holds;
+    int64_t msc = firstMsc;
+    clock.advanceToVblank(msc, refreshHz);
+    int64_t shown = clock.pollFrame();
+    int held = 1;
+    while (static_cast<int>(holds.size()) < frames) {
+        clock.advanceToVblank(++msc, refreshHz);
+        int64_t frame = clock.pollFrame();
+        if (frame != shown) {
+            holds.push_back(held);
+            held = 1;
+            shown = frame;
+        } else {
+            ++held;
+        }
+    }
+    return holds;
+}
+
+} // namespace
+
+bool test_VblankClock_Cadence() {
+    // 25 fps on 50 Hz: strict 2:2
+    VblankClockSyncSource pal(25.0);
+    pal.connect();
+    std::vector<int> holds = cadence(pal, 50.0, 1000, 500);
+    for (size_t i = 1; i < holds.size(); ++i) {
+        TEST_ASSERT_EQ(holds[i], 2);
+    }
+
+    // 24 fps on 60 Hz (and the NTSC pair 23.976 on 59.94): strict 3:2
+    double rates[2][2] = {{24.0, 60.0}, {24000.0 / 1001.0, 60000.0 / 1001.0}};
+    for (auto& rate : rates) {
+        VblankClockSyncSource film(rate[0]);
+        film.connect();
+        holds = cadence(film, rate[1], 0, 1000);
+        for (size_t i = 2; i < holds.size(); ++i) {
+            TEST_ASSERT_EQ(holds[i] + holds[i - 1], 5);
+            TEST_ASSERT(holds[i] == 2 || holds[i] == 3);
+        }
+    }
+
+    // Missed vblanks still advance: 24 fps after 60 vblanks is frame 24
+    VblankClockSyncSource skip(24.0);
+    skip.connect();
+    skip.advanceToVblank(100, 60.0);
+    skip.advanceToVblank(130, 60.0);
+    skip.advanceToVblank(160, 60.0);
+    TEST_ASSERT_EQ(skip.pollFrame(), static_cast<int64_t>(24));
+    return true;
+}
+
+bool test_VblankClock_Transport() {
+    VblankClockSyncSource clock(25.0);
+    TEST_ASSERT_EQ(clock.pollFrame(), static_cast<int64_t>(-1));
+    clock.connect();
+    TEST_ASSERT(clock.wasFullFrameReceived());
+
+    uint8_t rolling = 0;
+    clock.advanceToVblank(0, 50.0);
+    clock.advanceToVblank(100, 50.0);
+    TEST_ASSERT_EQ(clock.pollFrame(&rolling), static_cast<int64_t>(50));
+    TEST_ASSERT_EQ(rolling, static_cast<uint8_t>(1));
+
+    // Stopped: position holds while vblanks pass
+    clock.stop();
+    clock.advanceToVblank(200, 50.0);
+    TEST_ASSERT_EQ(clock.pollFrame(&rolling), static_cast<int64_t>(50));
+    TEST_ASSERT_EQ(rolling, static_cast<uint8_t>(0));
+
+    clock.locate(1000);
+    TEST_ASSERT(clock.wasFullFrameReceived());
+    TEST_ASSERT(!clock.wasFullFrameReceived());
+    clock.start();
+    clock.advanceToVblank(210, 50.0);
+    TEST_ASSERT_EQ(clock.pollFrame(), static_cast<int64_t>(1005));
+
+    // Without a vblank counter: elapsed monotonic time
+    clock.advanceToTime(5000000);
+    clock.advanceToTime(7000000);
+    TEST_ASSERT_EQ(clock.pollFrame(), static_cast<int64_t>(1055));
+    return true;
+}
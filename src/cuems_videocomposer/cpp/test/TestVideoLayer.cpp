@@ -3,7 +3,11 @@
 #include "../input/InputSource.h"
 #include "../sync/SyncSource.h"
 #include "../video/FrameBuffer.h"
+#include "../video/LoopFrameCache.h"
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 using namespace videocomposer;
 using namespace videocomposer::test;
@@ -100,6 +104,8 @@ bool test_VideoLayer_Seek() {
     bool seeked = layer->seek(100);
     TEST_ASSERT_TRUE(seeked);
     TEST_ASSERT_EQ(layer->getCurrentFrame(), 100);
+    // Seeking positions the input; the image is loaded by the next update
+    TEST_ASSERT_EQ(layer->getLoadedFrame(), static_cast<int64_t>(-1));
     
     // The mock's seek() should have been called by VideoLayer::seek()
     // Since layer->seek(100) returned true, we know inputSource_->seek(100) was called
@@ -188,7 +194,274 @@ bool test_VideoLayer_SyncUpdate() {
     
     // Frame should be updated from sync source
     TEST_ASSERT_EQ(layer->getCurrentFrame(), 50);
+    TEST_ASSERT_EQ(layer->getLoadedFrame(), static_cast<int64_t>(50));
     
     return true;
 }
 
+
+// Still image: the same frame for every position
+class MockStillSource : public MockInputSource {
+public:
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override {
+        readCount_++;
+        return MockInputSource::readFrame(frameNumber, buffer);
+    }
+    bool isStatic() const override { return true; }
+    
+    int readCount_ = 0;
+};
+
+bool test_VideoLayer_StaticFrame() {
+    auto layer = std::make_unique<VideoLayer>();
+    auto still = std::make_unique<MockStillSource>();
+    MockStillSource* stillPtr = still.get();
+    layer->setInputSource(std::move(still));
+    
+    auto mockSync = std::make_unique<MockSyncSource>();
+    MockSyncSource* syncPtr = mockSync.get();
+    layer->setSyncSource(std::move(mockSync));
+    syncPtr->connect();
+    syncPtr->setRolling(true);
+    
+    syncPtr->setCurrentFrame(50);
+    layer->update();
+    TEST_ASSERT_EQ(stillPtr->readCount_, 1);
+    uint64_t generation = layer->getFrameGeneration();
+    
+    // Sync moves on: the position follows, the frame is neither read nor new
+    syncPtr->setCurrentFrame(51);
+    layer->update();
+    syncPtr->setCurrentFrame(52);
+    layer->update();
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 52);
+    TEST_ASSERT_EQ(stillPtr->readCount_, 1);
+    TEST_ASSERT_EQ(layer->getFrameGeneration(), generation);
+    
+    // A new source is loaded again
+    layer->setInputSource(std::make_unique<MockStillSource>());
+    TEST_ASSERT_NE(layer->getFrameGeneration(), generation);
+    
+    return true;
+}
+
+bool test_VideoLayer_Arm() {
+    auto layer = std::make_unique<VideoLayer>();
+    auto mockSync = std::make_unique<MockSyncSource>();
+    MockSyncSource* syncPtr = mockSync.get();
+    layer->setSyncSource(std::move(mockSync));
+    syncPtr->connect();
+    syncPtr->setRolling(true);
+    syncPtr->setCurrentFrame(500);
+    
+    // Armed before the file has loaded: hidden, start frame loaded on arrival
+    layer->arm(120);
+    TEST_ASSERT_FALSE(layer->properties().visible);
+    TEST_ASSERT_FALSE(layer->isArmedFrameReady());
+    auto input = std::make_unique<MockInputSource>();
+    MockInputSource* inputPtr = input.get();
+    layer->setInputSource(std::move(input));
+    layer->update();
+    TEST_ASSERT_TRUE(layer->isArmedFrameReady());
+    TEST_ASSERT_EQ(inputPtr->lastSeekFrame_, 120);
+    TEST_ASSERT_EQ(inputPtr->lastReadFrame_, 120);
+    uint64_t generation = layer->getFrameGeneration();
+    
+    // Sync rolls on: the armed layer holds its start frame, nothing is reloaded
+    syncPtr->setCurrentFrame(510);
+    layer->update();
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 120);
+    TEST_ASSERT_EQ(layer->getFrameGeneration(), generation);
+    
+    // GO: shown at once; sync mapping to the armed frame needs no load
+    layer->setTimeOffset(120 - 510);
+    layer->go();
+    TEST_ASSERT_TRUE(layer->properties().visible);
+    TEST_ASSERT_FALSE(layer->isArmed());
+    layer->update();
+    TEST_ASSERT_EQ(layer->getFrameGeneration(), generation);
+    
+    // Then follows sync from there
+    syncPtr->setCurrentFrame(511);
+    layer->update();
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 121);
+    TEST_ASSERT_EQ(inputPtr->lastReadFrame_, 121);
+    
+    return true;
+}
+
+// Incoming source: frames are decoded on the layer's helper thread
+class MockIncomingSource : public MockInputSource {
+public:
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override {
+        (void)buffer;
+        lastRead_ = frameNumber;
+        return true;
+    }
+    std::atomic<int64_t> lastRead_{-1};
+};
+
+bool test_VideoLayer_HotSwap() {
+    auto layer = std::make_unique<VideoLayer>();
+    auto mockSync = std::make_unique<MockSyncSource>();
+    MockSyncSource* syncPtr = mockSync.get();
+    layer->setSyncSource(std::move(mockSync));
+    syncPtr->connect();
+    syncPtr->setRolling(true);
+    syncPtr->setCurrentFrame(100);
+    auto current = std::make_unique<MockInputSource>();
+    MockInputSource* currentPtr = current.get();
+    layer->setInputSource(std::move(current));
+    layer->update();
+    TEST_ASSERT_EQ(currentPtr->lastReadFrame_, 100);
+    
+    // The incoming file is prepared a few frames ahead while the current one plays
+    auto incoming = std::make_unique<MockIncomingSource>();
+    MockIncomingSource* incomingPtr = incoming.get();
+    layer->setIncomingSource(std::move(incoming), nullptr);
+    TEST_ASSERT_TRUE(layer->getInputSource() == currentPtr);
+    for (int i = 0; i < 200 && incomingPtr->lastRead_ != 103; ++i) {
+        layer->update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    TEST_ASSERT_EQ(incomingPtr->lastRead_.load(), 103);
+    
+    syncPtr->setCurrentFrame(101);
+    layer->update();
+    TEST_ASSERT_EQ(currentPtr->lastReadFrame_, 101);
+    syncPtr->setCurrentFrame(102);
+    layer->update();
+    TEST_ASSERT_EQ(currentPtr->lastReadFrame_, 102);
+    TEST_ASSERT_TRUE(layer->getInputSource() == currentPtr);
+    
+    // At the prepared frame it takes over with that frame already loaded
+    syncPtr->setCurrentFrame(103);
+    uint64_t generation = layer->getFrameGeneration();
+    layer->update();
+    TEST_ASSERT_TRUE(layer->getInputSource() == incomingPtr);
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 103);
+    TEST_ASSERT_TRUE(layer->getFrameGeneration() != generation);
+    
+    syncPtr->setCurrentFrame(104);
+    layer->update();
+    TEST_ASSERT_EQ(incomingPtr->lastRead_.load(), 104);
+    
+    return true;
+}
+
+// Seeks block until released, as a long-GOP seek would
+class MockSlowSeekSource : public MockInputSource {
+public:
+    bool seek(int64_t frameNumber) override {
+        while (!released_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        seeked_ = frameNumber;
+        return true;
+    }
+    bool readFrame(int64_t frameNumber, FrameBuffer& buffer) override {
+        (void)buffer;
+        read_ = frameNumber;
+        return true;
+    }
+    std::atomic<bool> released_{true};
+    std::atomic<int64_t> seeked_{-1};
+    std::atomic<int64_t> read_{-1};
+};
+
+bool test_VideoLayer_SeekAsync() {
+    auto layer = std::make_unique<VideoLayer>();
+    auto input = std::make_unique<MockSlowSeekSource>();
+    MockSlowSeekSource* inputPtr = input.get();
+    auto mockSync = std::make_unique<MockSyncSource>();
+    mockSync->connect();
+    layer->setSyncSource(std::move(mockSync));
+    layer->setInputSource(std::move(input));
+    layer->update();
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 0);
+    layer->setMtcFollow(false);  // Operator-driven from here
+    
+    // Returns at once; the current frame stays while the seek runs
+    inputPtr->released_ = false;
+    TEST_ASSERT_TRUE(layer->seekAsync(500, LayerPlayback::SeekPlaceholder::BLANK));
+    TEST_ASSERT_TRUE(layer->isSeeking());
+    TEST_ASSERT_FALSE(layer->properties().visible);
+    uint64_t generation = layer->getFrameGeneration();
+    layer->update();
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 0);
+    TEST_ASSERT_EQ(layer->getFrameGeneration(), generation);
+    LayerPlayback::SeekCompletion completion;
+    TEST_ASSERT_FALSE(layer->takeSeekCompletion(completion));
+    
+    // A newer request replaces the one in flight
+    TEST_ASSERT_TRUE(layer->seekAsync(5000));
+    inputPtr->released_ = true;
+    for (int i = 0; i < 200 && layer->isSeeking(); ++i) {
+        layer->update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    TEST_ASSERT_FALSE(layer->isSeeking());
+    TEST_ASSERT_EQ(inputPtr->read_.load(), 999);   // Clamped to the last frame
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 999);
+    TEST_ASSERT_EQ(layer->getLoadedFrame(), static_cast<int64_t>(999));
+    TEST_ASSERT_TRUE(layer->getFrameGeneration() != generation);
+    TEST_ASSERT_TRUE(layer->properties().visible);
+    TEST_ASSERT_TRUE(layer->takeSeekCompletion(completion));
+    TEST_ASSERT_EQ(completion.frame, static_cast<int64_t>(999));
+    TEST_ASSERT_TRUE(completion.loaded);
+    TEST_ASSERT_FALSE(layer->takeSeekCompletion(completion));
+    
+    // A synchronous seek waits for one in flight and wins
+    inputPtr->released_ = false;
+    TEST_ASSERT_TRUE(layer->seekAsync(10));
+    inputPtr->released_ = true;
+    TEST_ASSERT_TRUE(layer->seek(20));
+    TEST_ASSERT_FALSE(layer->isSeeking());
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 20);
+    return true;
+}
+
+bool test_VideoLayer_LateLatch() {
+    auto layer = std::make_unique<VideoLayer>();
+    auto input = std::make_unique<MockInputSource>();
+    MockInputSource* inputPtr = input.get();
+    layer->setInputSource(std::move(input));
+    auto mockSync = std::make_unique<MockSyncSource>();
+    MockSyncSource* syncPtr = mockSync.get();
+    layer->setSyncSource(std::move(mockSync));
+    syncPtr->connect();
+    syncPtr->setRolling(true);
+    
+    // A loop kept decoded: its frames can be taken just before the draw
+    auto& loop = layer->properties().loopRegion;
+    loop.enabled = true;
+    loop.startFrame = 50;
+    loop.endFrame = 53;
+    layer->setLoopCacheMode(LoopFrameCache::Mode::UNCOMPRESSED);
+    std::shared_ptr<LoopFrameCache> cache = layer->getLoopCache();
+    for (int64_t frame = 50; frame <= 53; ++frame) {
+        TEST_ASSERT_TRUE(cache->store(frame, std::make_shared<GPUTextureFrameBuffer>(), 100));
+    }
+    syncPtr->setCurrentFrame(50);
+    layer->update();
+    TEST_ASSERT_EQ(layer->getLoadedFrame(), static_cast<int64_t>(50));
+    
+    // Sync moved on after the update: the decoded frame is latched
+    syncPtr->setCurrentFrame(51);
+    TEST_ASSERT_TRUE(layer->latchSync());
+    TEST_ASSERT_EQ(layer->getCurrentFrame(), 51);
+    TEST_ASSERT_EQ(layer->getLoadedFrame(), static_cast<int64_t>(51));
+    TEST_ASSERT_FALSE(layer->latchSync());   // Already shown
+    
+    // A frame that still needs a decode waits for the next update
+    syncPtr->setCurrentFrame(60);
+    TEST_ASSERT_FALSE(layer->latchSync());
+    TEST_ASSERT_EQ(layer->getLoadedFrame(), static_cast<int64_t>(51));
+    TEST_ASSERT_EQ(inputPtr->lastReadFrame_, static_cast<int64_t>(-1));
+    
+    // Stopped: the update decides
+    syncPtr->setCurrentFrame(52);
+    syncPtr->setRolling(false);
+    TEST_ASSERT_FALSE(layer->latchSync());
+    return true;
+}
@@ -0,0 +1,76 @@
+#include "TestFramework.h"
+#include "../display/VideoShaders.h"
+
+using namespace videocomposer;
+using namespace videocomposer::test;
+
+bool test_VideoShaders_Specialize() {
+    // No features: source unchanged
+    TEST_ASSERT(VideoShaders::specialize(VideoShaders::FRAGMENT_RGBA, 0) == VideoShaders::FRAGMENT_RGBA);
+
+    // Defines follow the #version line (which must stay first)
+    std::string cc = VideoShaders::specialize(VideoShaders::FRAGMENT_NV12, VideoShaders::FEATURE_COLOR_CORRECTION);
+    size_t version = cc.find("#version 330 core\n");
+    TEST_ASSERT(version != std::string::npos);
+    TEST_ASSERT(cc.find("#define USE_COLOR_CORRECTION\n") == version + std::string("#version 330 core\n").size());
+    TEST_ASSERT(cc.find("#define USE_HOMOGRAPHY") == std::string::npos);
+
+    // All bits
+    std::string all = VideoShaders::specialize(VideoShaders::VERTEX_SHADER,
+                                               VideoShaders::FEATURE_COLOR_CORRECTION |
+                                               VideoShaders::FEATURE_HOMOGRAPHY |
+                                               VideoShaders::FEATURE_ANISOTROPIC);
+    TEST_ASSERT(all.find("#define USE_COLOR_CORRECTION\n") != std::string::npos);
+    TEST_ASSERT(all.find("#define USE_HOMOGRAPHY\n") != std::string::npos);
+    TEST_ASSERT(all.find("#define USE_ANISOTROPIC\n") != std::string::npos);
+    
+    // Field sampling replaces every plane fetch of the YUV shaders
+    std::string field = VideoShaders::specialize(VideoShaders::FRAGMENT_NV12, VideoShaders::FEATURE_DEINTERLACE);
+    TEST_ASSERT(field.find("#define USE_DEINTERLACE\n") != std::string::npos);
+    TEST_ASSERT(VideoShaders::FRAGMENT_NV12.find("texture(uTexY") == std::string::npos);
+    TEST_ASSERT(VideoShaders::FRAGMENT_YUV420P.find("samplePlane(uTexV, colorUV)") != std::string::npos);
+    TEST_ASSERT(all.find("#define") > all.find("#version"));
+    
+    // Packed alpha: both halves sampled, alpha from the luma plane
+    std::string packed = VideoShaders::specialize(VideoShaders::FRAGMENT_NV12, VideoShaders::FEATURE_PACKED_ALPHA);
+    TEST_ASSERT(packed.find("#define USE_PACKED_ALPHA\n") != std::string::npos);
+    TEST_ASSERT(VideoShaders::FRAGMENT_NV12.find("samplePlane(uTexY, packedAlphaUV(vTexCoord))") != std::string::npos);
+    TEST_ASSERT(VideoShaders::FRAGMENT_RGBA.find("packedStraightColor") != std::string::npos);
+
+    // Effects: one permutation, each stage gated by its uniform
+    std::string effects = VideoShaders::specialize(VideoShaders::FRAGMENT_UYVY, VideoShaders::FEATURE_EFFECTS);
+    TEST_ASSERT(effects.find("#define USE_EFFECTS\n") != std::string::npos);
+    TEST_ASSERT(VideoShaders::FRAGMENT_YUV420P.find("applyEffects(") != std::string::npos);
+    TEST_ASSERT(VideoShaders::EFFECT_BLUR_FRAGMENT_SHADER.find("uOffsets[9]") != std::string::npos);
+    
+    // Plain layer programs carry no optional stage
+    TEST_ASSERT(VideoShaders::FRAGMENT_RGBA.find("#ifdef USE_COLOR_CORRECTION") != std::string::npos);
+    TEST_ASSERT(VideoShaders::FRAGMENT_RGBA.find("uColorCorrectionEnabled") == std::string::npos);
+    TEST_ASSERT(VideoShaders::VERTEX_SHADER.find("uUseHomography") == std::string::npos);
+    return true;
+}
+
+bool test_VideoShaders_ForGLES() {
+    // Version line replaced, default precisions follow it
+    std::string es = VideoShaders::forGLES(VideoShaders::specialize(VideoShaders::FRAGMENT_NV12,
+                                                                    VideoShaders::FEATURE_COLOR_CORRECTION));
+    TEST_ASSERT(es.find("#version 330 core") == std::string::npos);
+    size_t version = es.find("#version 300 es\n");
+    TEST_ASSERT(version != std::string::npos);
+    TEST_ASSERT(es.find("precision highp float;\n") > version);
+    TEST_ASSERT(es.find("precision highp sampler3D;\n") > version);
+    TEST_ASSERT(es.find("#define USE_COLOR_CORRECTION\n") > es.find("precision highp sampler3D;"));
+    TEST_ASSERT(es.find("#version") == es.rfind("#version"));
+
+    // Every program the renderer builds has the desktop version line
+    const std::string sources[] = {VideoShaders::VERTEX_SHADER, VideoShaders::FRAGMENT_RGBA,
+                                   VideoShaders::MASTER_VERTEX_SHADER, VideoShaders::MASTER_FRAGMENT_SHADER,
+                                   VideoShaders::OSD_VERTEX_SHADER, VideoShaders::OSD_FRAGMENT_SHADER};
+    for (const std::string& source : sources) {
+        TEST_ASSERT(VideoShaders::forGLES(source).find("#version 300 es") != std::string::npos);
+    }
+
+    // Nothing to translate: unchanged
+    TEST_ASSERT(VideoShaders::forGLES("void main() {}") == "void main() {}");
+    return true;
+}
@@ -0,0 +1,110 @@
+#include "AllocationCounter.h"
+
+#ifdef VIDEOCOMPOSER_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local uint64_t threadAllocations = 0;
+
+void* countedAlloc(std::size_t size) {
+    ++threadAllocations;
+    return std::malloc(size ? size : 1);
+}
+
+void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    ++threadAllocations;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+    void* memory = nullptr;
+    if (posix_memalign(&memory, align, size ? size : 1) != 0) {
+        return nullptr;
+    }
+    return memory;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    void* memory = countedAlloc(size);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* memory = countedAlignedAlloc(size, alignment);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { std::free(memory); }
+
+namespace videocomposer {
+
+bool AllocationCounter::isEnabled() {
+    return true;
+}
+
+uint64_t AllocationCounter::threadCount() {
+    return threadAllocations;
+}
+
+} // namespace videocomposer
+
+#else
+
+namespace videocomposer {
+
+bool AllocationCounter::isEnabled() {
+    return false;
+}
+
+uint64_t AllocationCounter::threadCount() {
+    return 0;
+}
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_COUNT_ALLOCATIONS
@@ -0,0 +1,26 @@
+#ifndef VIDEOCOMPOSER_ALLOCATIONCOUNTER_H
+#define VIDEOCOMPOSER_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * AllocationCounter - Heap allocations made by the calling thread
+ *
+ * Built with VIDEOCOMPOSER_COUNT_ALLOCATIONS (Debug builds of the
+ * application), AllocationCounter.cpp replaces the global operator new
+ * with one that counts per thread, so the render loop can check that its
+ * steady state does not allocate. Otherwise the count stays 0.
+ */
+class AllocationCounter {
+public:
+    static bool isEnabled();
+
+    /** operator new calls on this thread so far */
+    static uint64_t threadCount();
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_ALLOCATIONCOUNTER_H
@@ -0,0 +1,439 @@
+#include "FlightRecorder.h"
+#include "FrameTracer.h"
+#include "Logger.h"
+#include "ThreadRoles.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace videocomposer {
+
+namespace {
+
+bool createDirectories(const std::string& path) {
+    size_t pos = 0;
+    std::string full = path + "/";
+    while ((pos = full.find('/', pos + 1)) != std::string::npos) {
+        std::string partial = full.substr(0, pos);
+        if (mkdir(partial.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// First line of a sysfs/procfs file, trailing whitespace removed
+bool readLine(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    if (!file || !std::getline(file, line)) {
+        return false;
+    }
+    while (!line.empty() && (line.back() == '\n' || line.back() == ' ' || line.back() == '\t')) {
+        line.pop_back();
+    }
+    return true;
+}
+
+// The selected line of an amdgpu pp_dpm_* table ("1: 1800Mhz *")
+bool readSelectedLevel(const std::string& path, std::string& level) {
+    std::ifstream file(path);
+    std::string line;
+    while (file && std::getline(file, line)) {
+        size_t star = line.find('*');
+        if (star != std::string::npos) {
+            size_t colon = line.find(':');
+            size_t begin = colon == std::string::npos ? 0 : colon + 1;
+            while (begin < star && line[begin] == ' ') {
+                ++begin;
+            }
+            size_t end = star;
+            while (end > begin && line[end - 1] == ' ') {
+                --end;
+            }
+            level = line.substr(begin, end - begin);
+            return true;
+        }
+    }
+    return false;
+}
+
+void appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            out += c;
+        }
+    }
+}
+
+void appendString(std::string& out, const char* key, const std::string& value) {
+    out += '"';
+    out += key;
+    out += "\":\"";
+    appendEscaped(out, value);
+    out += '"';
+}
+
+std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return names;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// CPU, load, GPU and thermal state as a JSON object
+std::string systemContext() {
+    std::string out = "{";
+    std::string line;
+
+    out += "\"cpu_khz\":[";
+    bool first = true;
+    for (const std::string& name : listDirectory("/sys/devices/system/cpu")) {
+        if (name.compare(0, 3, "cpu") != 0 || name.size() < 4 || name[3] < '0' || name[3] > '9') {
+            continue;
+        }
+        if (readLine("/sys/devices/system/cpu/" + name + "/cpufreq/scaling_cur_freq", line)) {
+            out += first ? "" : ",";
+            out += std::to_string(std::atoll(line.c_str()));
+            first = false;
+        }
+    }
+    out += "]";
+    if (readLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", line)) {
+        out += ",";
+        appendString(out, "cpu_governor", line);
+    }
+    if (readLine("/proc/loadavg", line)) {
+        out += ",";
+        appendString(out, "loadavg", line);
+    }
+
+    out += ",\"gpus\":[";
+    first = true;
+    for (const std::string& name : listDirectory("/sys/class/drm")) {
+        // cardN only, not its connectors (card0-HDMI-A-1)
+        if (name.compare(0, 4, "card") != 0 || name.find('-') != std::string::npos) {
+            continue;
+        }
+        std::string base = "/sys/class/drm/" + name;
+        std::string gpu;
+        std::string value;
+        if (readSelectedLevel(base + "/device/pp_dpm_sclk", value)) {
+            gpu += ",";
+            appendString(gpu, "sclk", value);
+        }
+        if (readSelectedLevel(base + "/device/pp_dpm_mclk", value)) {
+            gpu += ",";
+            appendString(gpu, "mclk", value);
+        }
+        if (readLine(base + "/device/gpu_busy_percent", value)) {
+            gpu += ",\"busy_percent\":" + std::to_string(std::atoi(value.c_str()));
+        }
+        if (readLine(base + "/gt_cur_freq_mhz", value)) {
+            gpu += ",\"cur_mhz\":" + std::to_string(std::atoi(value.c_str()));
+        }
+        if (readLine(base + "/gt_max_freq_mhz", value)) {
+            gpu += ",\"max_mhz\":" + std::to_string(std::atoi(value.c_str()));
+        }
+        out += first ? "{" : ",{";
+        appendString(out, "card", name);
+        out += gpu;
+        out += "}";
+        first = false;
+    }
+    out += "]";
+
+    out += ",\"thermal\":[";
+    first = true;
+    for (const std::string& name : listDirectory("/sys/class/thermal")) {
+        if (name.compare(0, 12, "thermal_zone") != 0) {
+            continue;
+        }
+        std::string type;
+        std::string temp;
+        if (readLine("/sys/class/thermal/" + name + "/type", type) &&
+            readLine("/sys/class/thermal/" + name + "/temp", temp)) {
+            out += first ? "{" : ",{";
+            appendString(out, "zone", type);
+            out += ",\"millicelsius\":" + std::to_string(std::atoll(temp.c_str())) + "}";
+            first = false;
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace
+
+FlightRecorder::FlightRecorder()
+    : frames_(MAX_FRAMES)
+    , frameHead_(0)
+    , frameCount_(0)
+    , enabled_(true)
+    , cooldownUntilNs_(0)
+    , triggerCount_(0)
+    , snapshotCount_(0)
+    , stop_(false)
+{
+}
+
+FlightRecorder::~FlightRecorder() {
+    stop();
+}
+
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+void FlightRecorder::configure(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.windowSeconds = std::max(settings_.windowSeconds, 0.1);
+    settings_.postRollSeconds = std::max(settings_.postRollSeconds, 0.0);
+    settings_.cooldownSeconds = std::max(settings_.cooldownSeconds, 0.0);
+    settings_.maxSnapshots = std::max(settings_.maxSnapshots, 1);
+    enabled_.store(settings_.enabled, std::memory_order_relaxed);
+}
+
+FlightRecorder::Settings FlightRecorder::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+std::string FlightRecorder::defaultDirectory() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/cuems-videocomposer/flight";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && home[0]) {
+        return std::string(home) + "/.cache/cuems-videocomposer/flight";
+    }
+    return "/tmp/cuems-videocomposer/flight";
+}
+
+const char* FlightRecorder::triggerName(Trigger trigger) {
+    switch (trigger) {
+        case Trigger::MISSED_VBLANK:   return "missed_vblank";
+        case Trigger::DECODE_UNDERRUN: return "decode_underrun";
+        case Trigger::OVER_BUDGET:     return "over_budget";
+    }
+    return "unknown";
+}
+
+void FlightRecorder::recordFrame(const FrameSample& sample) {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_[frameHead_] = sample;
+    frameHead_ = (frameHead_ + 1) % MAX_FRAMES;
+    frameCount_ = std::min(frameCount_ + 1, MAX_FRAMES);
+}
+
+bool FlightRecorder::trigger(Trigger trigger, const char* detail) {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    int64_t now = FrameTracer::nowNs();
+    if (now < cooldownUntilNs_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Another thread may have won the race to the lock
+    if (now < cooldownUntilNs_.load(std::memory_order_relaxed) || stop_) {
+        return false;
+    }
+    cooldownUntilNs_.store(now + static_cast<int64_t>(settings_.cooldownSeconds * 1e9),
+                           std::memory_order_relaxed);
+    triggerCount_.fetch_add(1, std::memory_order_relaxed);
+    FrameTracer::instance().instant("flight.trigger", now, static_cast<int64_t>(trigger));
+
+    Pending pending;
+    pending.trigger = trigger;
+    pending.detail = detail ? detail : "";
+    pending.timeNs = now;
+    pending.writeAtNs = now + static_cast<int64_t>(settings_.postRollSeconds * 1e9);
+    pending_.push_back(std::move(pending));
+    if (!writerThread_.joinable()) {
+        writerThread_ = std::thread(&FlightRecorder::writerThreadFunc, this);
+    }
+    writerCond_.notify_one();
+    LOG_WARNING << "FlightRecorder: " << triggerName(trigger)
+                << (detail && detail[0] ? std::string(" (") + detail + ")" : std::string())
+                << ", snapshot in " << settings_.postRollSeconds << " s";
+    return true;
+}
+
+void FlightRecorder::copyFrames(int64_t sinceNs, std::vector<FrameSample>& frames) const {
+    frames.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames.reserve(frameCount_);
+    size_t start = (frameHead_ + MAX_FRAMES - frameCount_) % MAX_FRAMES;
+    for (size_t i = 0; i < frameCount_; ++i) {
+        const FrameSample& sample = frames_[(start + i) % MAX_FRAMES];
+        if (sample.timeNs >= sinceNs) {
+            frames.push_back(sample);
+        }
+    }
+}
+
+std::string FlightRecorder::formatFrames(const std::vector<FrameSample>& frames) {
+    std::string out;
+    out.reserve(2 + frames.size() * 80);
+    out += '[';
+    char buffer[160];
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameSample& f = frames[i];
+        std::snprintf(buffer, sizeof(buffer),
+                      "%s{\"ts\":%lld.%03lld,\"frame\":%llu,\"work_ms\":%.3f,\"gpu_ms\":%.3f,\"budget_ms\":%.3f}",
+                      i ? "," : "", static_cast<long long>(f.timeNs / 1000), static_cast<long long>(f.timeNs % 1000),
+                      static_cast<unsigned long long>(f.frame), f.workMs, f.gpuMs, f.budgetMs);
+        out += buffer;
+    }
+    out += ']';
+    return out;
+}
+
+std::string FlightRecorder::getLastSnapshotPath() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastSnapshotPath_;
+}
+
+void FlightRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    writerCond_.notify_one();
+    if (writerThread_.joinable()) {
+        writerThread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = false;
+}
+
+void FlightRecorder::writerThreadFunc() {
+    ThreadRoles::instance().apply(ThreadRole::IO);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (pending_.empty()) {
+            if (stop_) {
+                break;
+            }
+            writerCond_.wait(lock);
+            continue;
+        }
+        // The post-roll is part of the window; stop writes out what there is
+        int64_t wait = pending_.front().writeAtNs - FrameTracer::nowNs();
+        if (wait > 0 && !stop_) {
+            writerCond_.wait_for(lock, std::chrono::nanoseconds(wait));
+            continue;
+        }
+        Pending pending = std::move(pending_.front());
+        pending_.erase(pending_.begin());
+        Settings settings = settings_;
+        lock.unlock();
+        writeSnapshot(pending, settings);
+        lock.lock();
+    }
+}
+
+bool FlightRecorder::writeSnapshot(const Pending& pending, const Settings& settings) {
+    std::string directory = settings.directory.empty() ? defaultDirectory() : settings.directory;
+    if (!createDirectories(directory)) {
+        LOG_WARNING << "FlightRecorder: cannot create " << directory << ": " << std::strerror(errno);
+        return false;
+    }
+
+    int64_t sinceNs = pending.timeNs - static_cast<int64_t>(settings.windowSeconds * 1e9);
+    std::vector<FrameSample> frames;
+    copyFrames(sinceNs, frames);
+
+    std::time_t wall = std::time(nullptr);
+    struct tm local;
+    localtime_r(&wall, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    char iso[32];
+    std::strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%S%z", &local);
+
+    std::string extra = "\"metadata\":{";
+    appendString(extra, "trigger", triggerName(pending.trigger));
+    extra += ",";
+    appendString(extra, "detail", pending.detail);
+    extra += ",";
+    appendString(extra, "time", iso);
+    extra += ",\"trigger_ts\":" + std::to_string(pending.timeNs / 1000);
+    extra += ",\"window_s\":" + std::to_string(settings.windowSeconds);
+    extra += ",\"system\":" + systemContext();
+    extra += "},\"frames\":" + formatFrames(frames);
+
+    std::string path = directory + "/flight-" + stamp + "-" + triggerName(pending.trigger) + ".json";
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG_WARNING << "FlightRecorder: cannot write " << temp;
+            return false;
+        }
+        file << FrameTracer::instance().exportChromeJson(sinceNs, extra);
+        if (!file.flush()) {
+            LOG_WARNING << "FlightRecorder: write to " << temp << " failed";
+            unlink(temp.c_str());
+            return false;
+        }
+    }
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        LOG_WARNING << "FlightRecorder: cannot rename to " << path << ": " << std::strerror(errno);
+        unlink(temp.c_str());
+        return false;
+    }
+    pruneSnapshots(directory, settings.maxSnapshots);
+
+    snapshotCount_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastSnapshotPath_ = path;
+    }
+    LOG_INFO << "FlightRecorder: " << frames.size() << " frame(s) around " << triggerName(pending.trigger)
+             << " written to " << path;
+    return true;
+}
+
+void FlightRecorder::pruneSnapshots(const std::string& directory, int keep) const {
+    // Names start with the time, so they sort oldest first
+    std::vector<std::string> snapshots;
+    for (const std::string& name : listDirectory(directory)) {
+        if (name.compare(0, 7, "flight-") == 0 && name.size() > 5 &&
+            name.compare(name.size() - 5, 5, ".json") == 0) {
+            snapshots.push_back(name);
+        }
+    }
+    for (size_t i = 0; i + static_cast<size_t>(keep) < snapshots.size(); ++i) {
+        unlink((directory + "/" + snapshots[i]).c_str());
+    }
+}
+
+} // namespace videocomposer
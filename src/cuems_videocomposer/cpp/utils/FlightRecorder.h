@@ -0,0 +1,134 @@
+#ifndef VIDEOCOMPOSER_FLIGHTRECORDER_H
+#define VIDEOCOMPOSER_FLIGHTRECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * FlightRecorder - Keeps the last seconds of the timeline for glitches
+ *
+ * A missed vblank in a show is rarely reproducible, and the FrameTracer
+ * rings are long overwritten by the time someone asks for a dump. The
+ * recorder keeps a bounded ring of per-frame statistics next to those
+ * rings; when something goes wrong (a flip beyond the expected vblank, a
+ * decode underrun, a frame over its budget) it snapshots the window
+ * around it to disk: the trace events and frames of the last
+ * windowSeconds up to postRollSeconds after the trigger, plus what the
+ * machine was doing (CPU frequencies and governor, load, GPU clocks and
+ * busy, temperatures).
+ *
+ * trigger() is safe from any thread and takes no lock while in cooldown;
+ * snapshots are written by a background thread as Chrome trace JSON with
+ * "metadata" and "frames" members, to flight-<time>-<reason>.json. Only
+ * the newest maxSnapshots files of the directory are kept.
+ */
+class FlightRecorder {
+public:
+    static constexpr size_t MAX_FRAMES = 2400;   // 10 s at 240 Hz
+
+    enum class Trigger {
+        MISSED_VBLANK,
+        DECODE_UNDERRUN,
+        OVER_BUDGET
+    };
+
+    struct FrameSample {
+        int64_t timeNs = 0;    // FrameTracer::nowNs() at the start of the frame
+        uint64_t frame = 0;
+        float workMs = 0.0f;   // CPU time of the frame's work
+        float gpuMs = 0.0f;    // 0 = not measured
+        float budgetMs = 0.0f;
+    };
+
+    struct Settings {
+        bool enabled = true;
+        double windowSeconds = 10.0;
+        double postRollSeconds = 1.0;
+        double cooldownSeconds = 30.0;     // Between snapshots
+        int maxSnapshots = 50;             // Files kept in the directory
+        std::string directory;             // Empty = defaultDirectory()
+    };
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    static FlightRecorder& instance();
+
+    void configure(const Settings& settings);
+    Settings getSettings() const;
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * Default snapshot directory: $XDG_CACHE_HOME/cuems-videocomposer/flight,
+     * falling back to ~/.cache/cuems-videocomposer/flight
+     */
+    static std::string defaultDirectory();
+    static const char* triggerName(Trigger trigger);
+
+    /** Add a frame to the ring (render thread) */
+    void recordFrame(const FrameSample& sample);
+
+    /**
+     * Something went wrong: schedule a snapshot unless disabled or in
+     * cooldown (detail is copied only then)
+     * @return true if a snapshot was scheduled
+     */
+    bool trigger(Trigger trigger, const char* detail = nullptr);
+
+    /** Frames in the ring at or after sinceNs, oldest first */
+    void copyFrames(int64_t sinceNs, std::vector<FrameSample>& frames) const;
+
+    /** Frames as a JSON array (timestamps in microseconds, as the trace) */
+    static std::string formatFrames(const std::vector<FrameSample>& frames);
+
+    uint64_t getTriggerCount() const { return triggerCount_.load(std::memory_order_relaxed); }
+    uint64_t getSnapshotCount() const { return snapshotCount_.load(std::memory_order_relaxed); }
+    std::string getLastSnapshotPath() const;
+
+    /** Write a pending snapshot now and stop the writer thread */
+    void stop();
+
+private:
+    struct Pending {
+        Trigger trigger = Trigger::MISSED_VBLANK;
+        std::string detail;
+        int64_t timeNs = 0;
+        int64_t writeAtNs = 0;
+    };
+
+    void writerThreadFunc();
+    bool writeSnapshot(const Pending& pending, const Settings& settings);
+    void pruneSnapshots(const std::string& directory, int keep) const;
+
+    mutable std::mutex mutex_;
+    Settings settings_;
+    std::vector<FrameSample> frames_;   // Ring of MAX_FRAMES
+    size_t frameHead_;
+    size_t frameCount_;
+
+    std::atomic<bool> enabled_;
+    std::atomic<int64_t> cooldownUntilNs_;
+    std::atomic<uint64_t> triggerCount_;
+    std::atomic<uint64_t> snapshotCount_;
+
+    std::condition_variable writerCond_;
+    std::vector<Pending> pending_;
+    std::string lastSnapshotPath_;
+    bool stop_;
+    std::thread writerThread_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FLIGHTRECORDER_H
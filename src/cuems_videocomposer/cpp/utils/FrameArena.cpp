@@ -0,0 +1,118 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+namespace {
+
+thread_local FrameArena* currentArena = nullptr;
+
+// Block payloads start max_align_t aligned
+constexpr size_t HEADER_SIZE = (sizeof(void*) + sizeof(size_t) + alignof(std::max_align_t) - 1)
+                               / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+} // namespace
+
+FrameArena::FrameArena(size_t blockSize)
+    : blockSize_(std::max<size_t>(blockSize, 256)) {
+}
+
+FrameArena::~FrameArena() {
+    if (currentArena == this) {
+        currentArena = nullptr;
+    }
+    freeBlocks();
+}
+
+FrameArena* FrameArena::current() {
+    return currentArena;
+}
+
+void FrameArena::setCurrent(FrameArena* arena) {
+    currentArena = arena;
+}
+
+uint8_t* FrameArena::blockData(Block* block) {
+    return reinterpret_cast<uint8_t*>(block) + HEADER_SIZE;
+}
+
+FrameArena::Block* FrameArena::addBlock(size_t minimumSize) {
+    size_t size = std::max(blockSize_, minimumSize);
+    void* memory = ::operator new(HEADER_SIZE + size);
+    ++heapAllocations_;
+
+    Block* block = static_cast<Block*>(memory);
+    block->next = blocks_;
+    block->size = size;
+    blocks_ = block;
+    offset_ = 0;
+    return block;
+}
+
+void FrameArena::freeBlocks() {
+    while (blocks_) {
+        Block* next = blocks_->next;
+        ::operator delete(blocks_);
+        blocks_ = next;
+    }
+    offset_ = 0;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        alignment = alignof(std::max_align_t);
+    }
+    bytes = std::max<size_t>(bytes, 1);
+
+    if (blocks_) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(blockData(blocks_));
+        uintptr_t aligned = (base + offset_ + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        size_t start = aligned - base;
+        if (start <= blocks_->size && bytes <= blocks_->size - start) {
+            offset_ = start + bytes;
+            used_ += bytes;
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    // New block, big enough for this allocation at any alignment
+    if (bytes > std::numeric_limits<size_t>::max() - HEADER_SIZE - alignment) {
+        throw std::bad_alloc();
+    }
+    Block* block = addBlock(std::max(bytes + alignment, blocks_ ? blocks_->size * 2 : 0));
+    uintptr_t base = reinterpret_cast<uintptr_t>(blockData(block));
+    uintptr_t aligned = (base + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    offset_ = (aligned - base) + bytes;
+    used_ += bytes;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void FrameArena::reset() {
+    highWater_ = std::max(highWater_, used_);
+    used_ = 0;
+    if (blocks_ && blocks_->next) {
+        // Grown this frame: one block that holds all of it from now on
+        size_t total = capacity();
+        freeBlocks();
+        addBlock(total);
+    }
+    offset_ = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block* block = blocks_; block; block = block->next) {
+        total += block->size;
+    }
+    return total;
+}
+
+size_t FrameArena::blockCount() const {
+    size_t count = 0;
+    for (const Block* block = blocks_; block; block = block->next) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace videocomposer
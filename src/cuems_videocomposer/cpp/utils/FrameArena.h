@@ -0,0 +1,140 @@
+#ifndef VIDEOCOMPOSER_FRAMEARENA_H
+#define VIDEOCOMPOSER_FRAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * FrameArena - Bump allocator for memory that lives for one frame
+ *
+ * Allocation moves a pointer through a block; nothing is freed until
+ * reset(), which the render loop calls once per vsync. When a frame needed
+ * more than one block, reset() replaces them with a single block of their
+ * combined size, so after the first frames the steady state allocates
+ * nothing from the heap.
+ *
+ * An arena belongs to one thread. The render loop makes its arena the
+ * thread's current() one; ArenaAllocator picks it up from there.
+ */
+class FrameArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit FrameArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /** Memory valid until the next reset() (throws std::bad_alloc) */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /** Drop every allocation of this frame */
+    void reset();
+
+    size_t used() const { return used_; }             // Bytes handed out since reset()
+    size_t highWater() const { return highWater_; }   // Largest frame so far
+    size_t capacity() const;                          // All blocks
+    size_t blockCount() const;
+    uint64_t heapAllocations() const { return heapAllocations_; }  // Blocks taken from the heap
+
+    /** Arena of the calling thread (null if none) */
+    static FrameArena* current();
+    static void setCurrent(FrameArena* arena);
+
+    /** Makes an arena current for a scope */
+    class Scope {
+    public:
+        explicit Scope(FrameArena* arena) : previous_(current()) { setCurrent(arena); }
+        ~Scope() { setCurrent(previous_); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameArena* previous_;
+    };
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;   // Usable bytes after the header
+    };
+
+    Block* addBlock(size_t minimumSize);
+    void freeBlocks();
+    static uint8_t* blockData(Block* block);
+
+    size_t blockSize_;
+    Block* blocks_ = nullptr;    // Newest first; allocations come from the newest
+    size_t offset_ = 0;          // In the newest block
+    size_t used_ = 0;
+    size_t highWater_ = 0;
+    uint64_t heapAllocations_ = 0;
+};
+
+/**
+ * ArenaAllocator - Standard allocator over the current FrameArena
+ *
+ * Takes the calling thread's current arena when constructed and falls back
+ * to the heap when there is none (other threads, tests, start-up), so the
+ * same container type works everywhere. Deallocation in an arena is a
+ * no-op: containers made with it must not outlive the frame, keep them
+ * local to the code that renders it.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() noexcept : arena_(FrameArena::current()) {}
+    explicit ArenaAllocator(FrameArena* arena) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        if (arena_) {
+            return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        if (!arena_) {
+            ::operator delete(pointer);
+        }
+    }
+
+    FrameArena* arena() const noexcept { return arena_; }
+
+private:
+    FrameArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+/** Vector for per-frame lists (layers to update, OSD items, ...) */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMEARENA_H
@@ -0,0 +1,266 @@
+#include "FrameTracer.h"
+#include "Logger.h"
+#include "ThreadRoles.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+namespace videocomposer {
+
+namespace {
+
+std::atomic<uint64_t> nextGeneration{1};
+
+// The calling thread's ring of the tracer it last recorded to
+struct ThreadRingCache {
+    uint64_t generation = 0;
+    std::shared_ptr<void> ring;      // FrameTracer::ThreadRing
+    std::atomic<bool>* inUse = nullptr;
+
+    ~ThreadRingCache() {
+        // Thread exit: the ring can be handed to a new thread
+        if (inUse) {
+            inUse->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRingCache ringCache;
+
+void appendEscaped(std::string& out, const char* text) {
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        if (static_cast<unsigned char>(*c) >= 0x20) {
+            out += *c;
+        }
+    }
+}
+
+// Nanoseconds as microseconds with three decimals (the trace format's unit)
+void appendMicros(std::string& out, int64_t ns) {
+    char buffer[32];
+    if (ns < 0) {
+        out += '-';
+        ns = -ns;
+    }
+    std::snprintf(buffer, sizeof(buffer), "%lld.%03lld",
+                  static_cast<long long>(ns / 1000), static_cast<long long>(ns % 1000));
+    out += buffer;
+}
+
+} // namespace
+
+FrameTracer::FrameTracer(size_t eventsPerThread)
+    : eventsPerThread_(std::max<size_t>(eventsPerThread, 16))
+    , generation_(nextGeneration.fetch_add(1, std::memory_order_relaxed))
+    , enabled_(true)
+{
+}
+
+FrameTracer::~FrameTracer() = default;
+
+FrameTracer& FrameTracer::instance() {
+    // Never destroyed: threads may still record while statics are torn down
+    static FrameTracer* tracer = new FrameTracer();
+    return *tracer;
+}
+
+int64_t FrameTracer::nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+FrameTracer::ThreadRing* FrameTracer::ringForThisThread() {
+    if (ringCache.generation == generation_) {
+        return static_cast<ThreadRing*>(ringCache.ring.get());
+    }
+
+    // First event of this thread for this tracer: take a ring a finished
+    // thread left behind, or add one
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    std::shared_ptr<ThreadRing> ring;
+    for (const auto& candidate : rings_) {
+        bool expected = false;
+        if (candidate->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            ring = candidate;
+            ring->clearedAt.store(ring->head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            ring->threadName.store(nullptr, std::memory_order_relaxed);
+            break;
+        }
+    }
+    if (!ring) {
+        ring = std::make_shared<ThreadRing>(eventsPerThread_);
+        rings_.push_back(ring);
+    }
+    static std::atomic<int> nextTid{1};
+    ring->tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+
+    if (ringCache.inUse) {
+        ringCache.inUse->store(false, std::memory_order_release);
+    }
+    ringCache.generation = generation_;
+    ringCache.ring = ring;
+    ringCache.inUse = &ring->inUse;
+    return ring.get();
+}
+
+void FrameTracer::record(const char* name, int64_t startNs, int64_t endNs, int64_t arg) {
+    if (!isEnabled() || !name) {
+        return;
+    }
+    ThreadRing* ring = ringForThisThread();
+    uint64_t index = ring->head.load(std::memory_order_relaxed);
+    Event& event = ring->events[index % ring->capacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.durNs.store(endNs - startNs, std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+void FrameTracer::setThreadName(const char* name) {
+    ringForThisThread()->threadName.store(name, std::memory_order_relaxed);
+}
+
+void FrameTracer::clear() {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    for (const auto& ring : rings_) {
+        ring->clearedAt.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+size_t FrameTracer::getThreadCount() const {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    return rings_.size();
+}
+
+void FrameTracer::copyEvents(std::vector<CopiedEvent>& events, std::vector<CopiedThread>& threads) const {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    for (const auto& ring : rings_) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = std::max<uint64_t>(ring->clearedAt.load(std::memory_order_relaxed),
+                                            head > ring->capacity ? head - ring->capacity : 0);
+        size_t first = events.size();
+        for (uint64_t index = begin; index < head; ++index) {
+            const Event& event = ring->events[index % ring->capacity];
+            // Acquire loads keep the second head read below after them
+            events.push_back({event.name.load(std::memory_order_acquire),
+                              event.startNs.load(std::memory_order_acquire),
+                              event.durNs.load(std::memory_order_acquire),
+                              event.arg.load(std::memory_order_acquire),
+                              ring->tid});
+        }
+
+        // Events the writer may have overwritten while they were copied are
+        // dropped, including the slot the next event is going into
+        uint64_t headAfter = ring->head.load(std::memory_order_acquire);
+        if (headAfter >= ring->capacity && headAfter - ring->capacity + 1 > begin) {
+            size_t torn = std::min<size_t>(headAfter - ring->capacity + 1 - begin, events.size() - first);
+            events.erase(events.begin() + first, events.begin() + first + torn);
+        }
+
+        const char* name = ring->threadName.load(std::memory_order_relaxed);
+        if (events.size() > first || name) {
+            threads.push_back({ring->tid, name});
+        }
+    }
+}
+
+std::string FrameTracer::formatJson(const std::vector<CopiedEvent>& events, const std::vector<CopiedThread>& threads,
+                                    const std::string& extraMembers) {
+    std::string out;
+    out.reserve(128 + extraMembers.size() + events.size() * 96);
+    out += "{\"displayTimeUnit\":\"ns\",";
+    if (!extraMembers.empty()) {
+        out += extraMembers;
+        out += ',';
+    }
+    out += "\"traceEvents\":[";
+    bool first = true;
+    for (const CopiedThread& thread : threads) {
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        out += std::to_string(thread.tid);
+        out += ",\"args\":{\"name\":\"";
+        if (thread.name) {
+            appendEscaped(out, thread.name);
+        } else {
+            out += "thread " + std::to_string(thread.tid);
+        }
+        out += "\"}}";
+    }
+    for (const CopiedEvent& event : events) {
+        if (!event.name) {
+            continue;
+        }
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += "{\"name\":\"";
+        appendEscaped(out, event.name);
+        out += event.durNs > 0 ? "\",\"ph\":\"X\"" : "\",\"ph\":\"i\",\"s\":\"t\"";
+        out += ",\"pid\":1,\"tid\":";
+        out += std::to_string(event.tid);
+        out += ",\"ts\":";
+        appendMicros(out, event.startNs);
+        if (event.durNs > 0) {
+            out += ",\"dur\":";
+            appendMicros(out, event.durNs);
+        }
+        if (event.arg != NO_ARG) {
+            out += ",\"args\":{\"arg\":";
+            out += std::to_string(event.arg);
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+std::string FrameTracer::exportChromeJson() const {
+    std::vector<CopiedEvent> events;
+    std::vector<CopiedThread> threads;
+    copyEvents(events, threads);
+    return formatJson(events, threads);
+}
+
+std::string FrameTracer::exportChromeJson(int64_t sinceNs, const std::string& extraMembers) const {
+    std::vector<CopiedEvent> events;
+    std::vector<CopiedThread> threads;
+    copyEvents(events, threads);
+    events.erase(std::remove_if(events.begin(), events.end(),
+                                [sinceNs](const CopiedEvent& event) { return event.startNs + event.durNs < sinceNs; }),
+                 events.end());
+    return formatJson(events, threads, extraMembers);
+}
+
+bool FrameTracer::dumpChromeJson(const std::string& path) const {
+    if (path.empty()) {
+        return false;
+    }
+    auto events = std::make_shared<std::vector<CopiedEvent>>();
+    auto threads = std::make_shared<std::vector<CopiedThread>>();
+    copyEvents(*events, *threads);
+
+    // Formatting and writing megabytes of JSON stays off the calling thread
+    std::thread([events, threads, path]() {
+        ThreadRoles::instance().apply(ThreadRole::IO);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG_WARNING << "Trace: cannot write " << path;
+            return;
+        }
+        file << formatJson(*events, *threads);
+        LOG_INFO << "Trace: " << events->size() << " event(s) from " << threads->size()
+                 << " thread(s) written to " << path;
+    }).detach();
+    return true;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,155 @@
+#ifndef VIDEOCOMPOSER_FRAMETRACER_H
+#define VIDEOCOMPOSER_FRAMETRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * FrameTracer - Timeline of scoped events across the threads of a frame
+ *
+ * Each thread records into its own ring of fixed-size events (name, start,
+ * duration in nanoseconds on CLOCK_MONOTONIC, one integer argument), so
+ * recording takes no lock and never allocates once the thread's ring
+ * exists; the oldest events are overwritten. Names must be string
+ * literals. exportChromeJson() writes the rings out in the Chrome trace
+ * event format, which Perfetto and chrome://tracing open.
+ *
+ * Recording is on by default and costs two clock reads per scope; with
+ * it off a scope is one relaxed load.
+ */
+class FrameTracer {
+public:
+    static constexpr size_t DEFAULT_EVENTS_PER_THREAD = 8192;
+    static constexpr int64_t NO_ARG = INT64_MIN;
+
+    explicit FrameTracer(size_t eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+    ~FrameTracer();
+
+    FrameTracer(const FrameTracer&) = delete;
+    FrameTracer& operator=(const FrameTracer&) = delete;
+
+    static FrameTracer& instance();
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /** CLOCK_MONOTONIC in nanoseconds (the trace clock) */
+    static int64_t nowNs();
+
+    /** Record a finished span on the calling thread's ring */
+    void record(const char* name, int64_t startNs, int64_t endNs, int64_t arg = NO_ARG);
+
+    /** Record a point event (flip completion, timecode received) */
+    void instant(const char* name, int64_t timeNs, int64_t arg = NO_ARG) { record(name, timeNs, timeNs, arg); }
+
+    /** Name the calling thread in exported traces (literal or long-lived string) */
+    void setThreadName(const char* name);
+
+    /** Drop all recorded events (threads keep their rings) */
+    void clear();
+
+    /** All rings as a Chrome trace event JSON document */
+    std::string exportChromeJson() const;
+
+    /**
+     * Events ending at or after sinceNs only, with extra top-level members
+     * ("key":value pairs, comma-separated; empty = none) in the document
+     */
+    std::string exportChromeJson(int64_t sinceNs, const std::string& extraMembers) const;
+
+    /**
+     * Copy the rings now and write them to a file from a background thread
+     * (safe to call from the render loop)
+     */
+    bool dumpChromeJson(const std::string& path) const;
+
+    size_t getThreadCount() const;
+
+private:
+    struct Event {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> startNs{0};
+        std::atomic<int64_t> durNs{0};
+        std::atomic<int64_t> arg{0};
+    };
+
+    // One writer (its thread), read by exports; indices grow forever
+    struct ThreadRing {
+        explicit ThreadRing(size_t capacity) : events(new Event[capacity]), capacity(capacity) {}
+        std::unique_ptr<Event[]> events;
+        const size_t capacity;
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> clearedAt{0};   // Events before this index were cleared
+        std::atomic<const char*> threadName{nullptr};
+        std::atomic<bool> inUse{true};        // False once its thread exited (reused)
+        int tid = 0;
+    };
+
+    struct CopiedEvent {
+        const char* name;
+        int64_t startNs;
+        int64_t durNs;
+        int64_t arg;
+        int tid;
+    };
+    struct CopiedThread {
+        int tid;
+        const char* name;
+    };
+
+    ThreadRing* ringForThisThread();
+    void copyEvents(std::vector<CopiedEvent>& events, std::vector<CopiedThread>& threads) const;
+    static std::string formatJson(const std::vector<CopiedEvent>& events, const std::vector<CopiedThread>& threads,
+                                  const std::string& extraMembers = std::string());
+
+    const size_t eventsPerThread_;
+    const uint64_t generation_;   // Tells thread-local ring caches of different tracers apart
+    std::atomic<bool> enabled_;
+
+    mutable std::mutex ringsMutex_;   // Thread registration and exports only
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+};
+
+/** Records the span from construction to destruction (see FRAME_TRACE_SCOPE) */
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, int64_t arg = FrameTracer::NO_ARG)
+        : name_(FrameTracer::instance().isEnabled() ? name : nullptr)
+        , arg_(arg)
+        , startNs_(name_ ? FrameTracer::nowNs() : 0) {}
+
+    ~TraceScope() {
+        if (name_) {
+            FrameTracer::instance().record(name_, startNs_, FrameTracer::nowNs(), arg_);
+        }
+    }
+
+    /** Argument known only later in the scope (frame number, layer) */
+    void setArg(int64_t arg) { arg_ = arg; }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    int64_t arg_;
+    int64_t startNs_;
+};
+
+#define FRAME_TRACE_CONCAT_(a, b) a##b
+#define FRAME_TRACE_CONCAT(a, b) FRAME_TRACE_CONCAT_(a, b)
+
+// Trace the rest of the enclosing block, e.g. FRAME_TRACE_SCOPE("composite");
+#define FRAME_TRACE_SCOPE(...) \
+    videocomposer::TraceScope FRAME_TRACE_CONCAT(frameTraceScope_, __LINE__)(__VA_ARGS__)
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMETRACER_H
@@ -0,0 +1,134 @@
+#ifndef VIDEOCOMPOSER_LOGRING_H
+#define VIDEOCOMPOSER_LOGRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace videocomposer {
+
+/**
+ * LogRing - Bounded lock-free queue of log records, many writers, one reader
+ *
+ * Each slot carries a sequence number (Vyukov's bounded queue): a writer
+ * claims a slot with one compare-exchange on the write position, copies
+ * the text in and publishes the slot by advancing its sequence. Writers
+ * never block and never allocate; when the ring is full the record is
+ * dropped and counted. Texts longer than a slot are truncated.
+ */
+class LogRing {
+public:
+    static constexpr size_t TEXT_SIZE = 496;
+
+    struct Record {
+        int level = 0;
+        uint32_t length = 0;
+        bool truncated = false;
+        char text[TEXT_SIZE];
+    };
+
+    /** @param capacity Number of slots (rounded up to a power of two) */
+    explicit LogRing(size_t capacity = 1024)
+        : capacity_(roundUp(capacity))
+        , mask_(capacity_ - 1)
+        , slots_(new Slot[capacity_])
+        , writePos_(0)
+        , readPos_(0)
+        , dropped_(0)
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    /**
+     * Queue a record (any thread)
+     * @return false if the ring was full and the record was dropped
+     */
+    bool push(int level, const char* text, size_t length) {
+        size_t pos = writePos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (writePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = writePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        Record& record = slot->record;
+        record.level = level;
+        record.truncated = length > TEXT_SIZE;
+        record.length = static_cast<uint32_t>(record.truncated ? TEXT_SIZE : length);
+        std::memcpy(record.text, text, record.length);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Take the oldest record (the single reader only)
+     * @return false if nothing is queued (or the oldest is still being written)
+     */
+    bool pop(Record& out) {
+        size_t pos = readPos_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != pos + 1) {
+            return false;
+        }
+        out.level = slot.record.level;
+        out.length = slot.record.length;
+        out.truncated = slot.record.truncated;
+        std::memcpy(out.text, slot.record.text, out.length);
+        slot.sequence.store(pos + capacity_, std::memory_order_release);
+        readPos_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Records claimed so far / taken so far (for flushing up to a point) */
+    size_t writePosition() const { return writePos_.load(std::memory_order_acquire); }
+    size_t readPosition() const { return readPos_.load(std::memory_order_acquire); }
+
+    /** Records dropped since the last call */
+    uint64_t takeDropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    static size_t roundUp(size_t value) {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> writePos_;
+    alignas(64) std::atomic<size_t> readPos_;
+    std::atomic<uint64_t> dropped_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LOGRING_H
@@ -0,0 +1,159 @@
+#include "Logger.h"
+#include "LogRing.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace videocomposer {
+
+namespace {
+
+const char* levelPrefix(int level) {
+    switch (level) {
+        case Logger::ERROR: return "[ERROR] ";
+        case Logger::WARNING: return "[WARNING] ";
+        case Logger::INFO: return "[INFO] ";
+        case Logger::DEBUG: return "[DEBUG] ";
+        default: return "[VERBOSE] ";
+    }
+}
+
+// Errors and warnings go to stderr, the rest to stdout (as before the queue)
+std::ostream& levelStream(int level) {
+    return level <= Logger::WARNING ? std::cerr : std::cout;
+}
+
+void writeLine(int level, const char* text, size_t length, bool truncated) {
+    std::ostream& out = levelStream(level);
+    out << levelPrefix(level);
+    out.write(text, static_cast<std::streamsize>(length));
+    if (truncated) {
+        out << "...";
+    }
+    out << '\n';
+}
+
+} // namespace
+
+struct Logger::Writer {
+    LogRing ring;
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    // The writer sleeps here when the ring is empty; writers only notify
+    // when it does, and it wakes up on its own anyway (no lost messages)
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping{false};
+
+    void notify() {
+        if (sleeping.load(std::memory_order_acquire)) {
+            wake.notify_one();
+        }
+    }
+
+    // Write out everything queued; the formatting (prefix, line end) is done here
+    bool drain(Logger& logger) {
+        LogRing::Record record;
+        bool wroteOut = false, wroteErr = false;
+        while (ring.pop(record)) {
+            writeLine(record.level, record.text, record.length, record.truncated);
+            (record.level <= WARNING ? wroteErr : wroteOut) = true;
+        }
+        uint64_t dropped = ring.takeDropped();
+        if (dropped > 0) {
+            logger.droppedTotal_.fetch_add(dropped, std::memory_order_relaxed);
+            std::cerr << "[WARNING] Logger: " << dropped << " message(s) dropped (queue full)\n";
+            wroteErr = true;
+        }
+        if (wroteOut) {
+            std::cout.flush();
+        }
+        if (wroteErr) {
+            std::cerr.flush();
+        }
+        return wroteOut || wroteErr;
+    }
+
+    void run(Logger& logger) {
+        while (running.load(std::memory_order_acquire)) {
+            if (drain(logger)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            sleeping.store(true, std::memory_order_release);
+            wake.wait_for(lock, std::chrono::milliseconds(20));
+            sleeping.store(false, std::memory_order_release);
+        }
+        drain(logger);
+    }
+};
+
+Logger::Logger()
+    : level_(INFO)
+    , quiet_(false)
+    , droppedTotal_(0)
+    , writer_(new Writer())
+{
+    writer_->running.store(true, std::memory_order_release);
+    writer_->thread = std::thread([this]() { writer_->run(*this); });
+    std::atexit([]() { Logger::getInstance().shutdown(); });
+}
+
+void Logger::write(Level level, const std::string& message) {
+    if (!writer_->running.load(std::memory_order_acquire)) {
+        // Writer stopped (exit): write directly
+        writeLine(level, message.data(), message.size(), false);
+        levelStream(level).flush();
+        return;
+    }
+
+    bool queued = writer_->ring.push(level, message.data(), message.size());
+    writer_->notify();
+    if (level == ERROR) {
+        flush();
+        if (!queued) {
+            // An error is never dropped
+            writeLine(level, message.data(), message.size(), false);
+            levelStream(level).flush();
+        }
+    }
+}
+
+void Logger::flush() {
+    if (!writer_->running.load(std::memory_order_acquire) ||
+        std::this_thread::get_id() == writer_->thread.get_id()) {
+        return;
+    }
+    size_t target = writer_->ring.writePosition();
+    while (writer_->ring.readPosition() < target && writer_->running.load(std::memory_order_acquire)) {
+        writer_->wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void Logger::shutdown() {
+    if (!writer_->running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    writer_->wake.notify_one();
+    if (writer_->thread.joinable()) {
+        writer_->thread.join();
+    }
+}
+
+Logger::LogStream::~LogStream() {
+    if (!shouldLog_) {
+        return;
+    }
+    if (site_) {
+        uint32_t suppressed = site_->takeSuppressed();
+        if (suppressed > 0) {
+            stream_ << " (" << suppressed << " similar suppressed)";
+        }
+    }
+    logger_.write(level_, stream_.str());
+}
+
+} // namespace videocomposer
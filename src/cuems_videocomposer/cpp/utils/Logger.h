@@ -4,14 +4,33 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Levels above this are compiled out of the LOG_* macros entirely (their
+ * arguments are never evaluated). 0 = errors only ... 4 = everything.
+ */
+#ifndef VIDEOCOMPOSER_LOG_MAX_LEVEL
+#define VIDEOCOMPOSER_LOG_MAX_LEVEL 4
+#endif
 
 namespace videocomposer {
 
+class LogRateLimit;
+
 /**
  * Logger - Simple logging utility for C++ code
  * 
  * Provides consistent logging interface that can integrate with
  * existing C code's logging (want_quiet, want_verbose, want_debug).
+ *
+ * Messages are queued on a lock-free ring (LogRing) and written to the
+ * console by a background thread, so logging from the render loop or a
+ * decode thread costs a copy, not I/O. Errors are written before the call
+ * returns; messages that find the ring full are dropped and counted.
+ * The LOG_* macros don't format anything for disabled levels.
  */
 class Logger {
 public:
@@ -24,74 +43,86 @@ public:
     };
 
     static Logger& getInstance() {
-        static Logger instance;
-        return instance;
+        // Never destroyed: threads may log during static destruction
+        // (the writer is stopped at exit, later messages are written directly)
+        static Logger* instance = new Logger();
+        return *instance;
     }
 
-    void setLevel(Level level) { level_ = level; }
-    Level getLevel() const { return level_; }
+    void setLevel(Level level) { level_.store(level, std::memory_order_relaxed); }
+    Level getLevel() const { return level_.load(std::memory_order_relaxed); }
+
+    void setQuiet(bool quiet) { quiet_.store(quiet, std::memory_order_relaxed); }
+    bool isQuiet() const { return quiet_.load(std::memory_order_relaxed); }
 
-    void setQuiet(bool quiet) { quiet_ = quiet; }
-    bool isQuiet() const { return quiet_; }
+    bool isEnabled(Level level) const { return !isQuiet() && getLevel() >= level; }
+
+    /** Compile-time and runtime filter used by the LOG_* macros */
+    static bool shouldLog(Level level) {
+        return level <= VIDEOCOMPOSER_LOG_MAX_LEVEL && getInstance().isEnabled(level);
+    }
 
     // Logging methods
     void error(const std::string& message) {
-        if (!quiet_ && level_ >= ERROR) {
-            std::cerr << "[ERROR] " << message << std::endl;
+        if (isEnabled(ERROR)) {
+            write(ERROR, message);
         }
     }
 
     void warning(const std::string& message) {
-        if (!quiet_ && level_ >= WARNING) {
-            std::cerr << "[WARNING] " << message << std::endl;
+        if (isEnabled(WARNING)) {
+            write(WARNING, message);
         }
     }
 
     void info(const std::string& message) {
-        if (!quiet_ && level_ >= INFO) {
-            std::cout << "[INFO] " << message << std::endl;
+        if (isEnabled(INFO)) {
+            write(INFO, message);
         }
     }
 
     void debug(const std::string& message) {
-        if (!quiet_ && level_ >= DEBUG) {
-            std::cout << "[DEBUG] " << message << std::endl;
+        if (isEnabled(DEBUG)) {
+            write(DEBUG, message);
         }
     }
 
     void verbose(const std::string& message) {
-        if (!quiet_ && level_ >= VERBOSE) {
-            std::cout << "[VERBOSE] " << message << std::endl;
+        if (isEnabled(VERBOSE)) {
+            write(VERBOSE, message);
         }
     }
 
+    /** Queue a message regardless of the level filter */
+    void write(Level level, const std::string& message);
+
+    /** Wait until everything queued so far has been written */
+    void flush();
+
+    /** Stop the writer thread after draining the queue (called at exit) */
+    void shutdown();
+
+    /** Messages dropped because the queue was full, since startup */
+    uint64_t getDroppedCount() const { return droppedTotal_.load(std::memory_order_relaxed); }
+
     // Convenience macros (can be used like: LOG_INFO << "message")
     class LogStream {
     public:
-        LogStream(Logger& logger, Level level, bool shouldLog)
-            : logger_(logger), level_(level), shouldLog_(shouldLog) {}
+        LogStream(Logger& logger, Level level, bool shouldLog, LogRateLimit* site = nullptr)
+            : logger_(logger), level_(level), shouldLog_(shouldLog), site_(site) {}
         
         // Move constructor (needed because ostringstream is not copyable)
         LogStream(LogStream&& other) noexcept
             : logger_(other.logger_), level_(other.level_), shouldLog_(other.shouldLog_),
-              stream_(std::move(other.stream_)) {}
+              site_(other.site_), stream_(std::move(other.stream_)) {
+            other.shouldLog_ = false;
+        }
         
         // Delete copy constructor
         LogStream(const LogStream&) = delete;
         LogStream& operator=(const LogStream&) = delete;
         
-        ~LogStream() {
-            if (shouldLog_) {
-                std::string msg = stream_.str();
-                switch (level_) {
-                    case ERROR: logger_.error(msg); break;
-                    case WARNING: logger_.warning(msg); break;
-                    case INFO: logger_.info(msg); break;
-                    case DEBUG: logger_.debug(msg); break;
-                    case VERBOSE: logger_.verbose(msg); break;
-                }
-            }
-        }
+        ~LogStream();
 
         template<typename T>
         LogStream& operator<<(const T& value) {
@@ -101,35 +132,100 @@ public:
             return *this;
         }
 
+        // Stream manipulators (std::hex, std::dec, ...)
+        LogStream& operator<<(std::ios_base& (*manipulator)(std::ios_base&)) {
+            if (shouldLog_) {
+                stream_ << manipulator;
+            }
+            return *this;
+        }
+
     private:
         Logger& logger_;
         Level level_;
         bool shouldLog_;
+        LogRateLimit* site_;
         std::ostringstream stream_;
     };
 
-    LogStream error() { return LogStream(*this, ERROR, !quiet_ && level_ >= ERROR); }
-    LogStream warning() { return LogStream(*this, WARNING, !quiet_ && level_ >= WARNING); }
-    LogStream info() { return LogStream(*this, INFO, !quiet_ && level_ >= INFO); }
-    LogStream debug() { return LogStream(*this, DEBUG, !quiet_ && level_ >= DEBUG); }
-    LogStream verbose() { return LogStream(*this, VERBOSE, !quiet_ && level_ >= VERBOSE); }
+    LogStream error() { return LogStream(*this, ERROR, isEnabled(ERROR)); }
+    LogStream warning() { return LogStream(*this, WARNING, isEnabled(WARNING)); }
+    LogStream info() { return LogStream(*this, INFO, isEnabled(INFO)); }
+    LogStream debug() { return LogStream(*this, DEBUG, isEnabled(DEBUG)); }
+    LogStream verbose() { return LogStream(*this, VERBOSE, isEnabled(VERBOSE)); }
+
+    /** Stream for a call site that already passed its filters (the macros) */
+    LogStream stream(Level level, LogRateLimit* site = nullptr) { return LogStream(*this, level, true, site); }
+
+    /** Turns the macros' stream expression into void for the ?: filter */
+    struct Voidify {
+        void operator&(const LogStream&) {}
+    };
 
 private:
-    Logger() : level_(INFO), quiet_(false) {}
+    Logger();
     ~Logger() = default;
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    Level level_;
-    bool quiet_;
+    std::atomic<Level> level_;
+    std::atomic<bool> quiet_;
+    std::atomic<uint64_t> droppedTotal_;
+
+    // Queue and writer thread live in Logger.cpp
+    struct Writer;
+    Writer* writer_;
+};
+
+/**
+ * LogRateLimit - Per-call-site limit for the LOG_*_EVERY macros
+ *
+ * Lets one message through per interval; the ones held back in between
+ * are counted and reported with the next message that gets through.
+ */
+class LogRateLimit {
+public:
+    bool allow(int64_t intervalMs) {
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t next = nextMs_.load(std::memory_order_relaxed);
+        if (now < next || !nextMs_.compare_exchange_strong(next, now + intervalMs, std::memory_order_relaxed)) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /** Messages held back since the last call */
+    uint32_t takeSuppressed() { return suppressed_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> nextMs_{0};
+    std::atomic<uint32_t> suppressed_{0};
 };
 
-// Convenience macros
-#define LOG_ERROR   videocomposer::Logger::getInstance().error()
-#define LOG_WARNING videocomposer::Logger::getInstance().warning()
-#define LOG_INFO    videocomposer::Logger::getInstance().info()
-#define LOG_DEBUG   videocomposer::Logger::getInstance().debug()
-#define LOG_VERBOSE videocomposer::Logger::getInstance().verbose()
+// Convenience macros; arguments are not evaluated when the level is filtered out
+#define VIDEOCOMPOSER_LOG_AT(level) \
+    !videocomposer::Logger::shouldLog(level) ? (void)0 \
+        : videocomposer::Logger::Voidify() & videocomposer::Logger::getInstance().stream(level)
+
+#define LOG_ERROR   VIDEOCOMPOSER_LOG_AT(videocomposer::Logger::ERROR)
+#define LOG_WARNING VIDEOCOMPOSER_LOG_AT(videocomposer::Logger::WARNING)
+#define LOG_INFO    VIDEOCOMPOSER_LOG_AT(videocomposer::Logger::INFO)
+#define LOG_DEBUG   VIDEOCOMPOSER_LOG_AT(videocomposer::Logger::DEBUG)
+#define LOG_VERBOSE VIDEOCOMPOSER_LOG_AT(videocomposer::Logger::VERBOSE)
+
+// At most one message per intervalMs from this call site (for per-frame paths),
+// e.g. LOG_WARNING_EVERY(1000) << "Frame " << n << " late";
+#define VIDEOCOMPOSER_LOG_EVERY(level, intervalMs) \
+    for (videocomposer::LogRateLimit* logSite_ = [] { static videocomposer::LogRateLimit site; return &site; }(); \
+         logSite_ && videocomposer::Logger::shouldLog(level) && logSite_->allow(intervalMs); logSite_ = nullptr) \
+        videocomposer::Logger::getInstance().stream(level, logSite_)
+
+#define LOG_WARNING_EVERY(ms) VIDEOCOMPOSER_LOG_EVERY(videocomposer::Logger::WARNING, ms)
+#define LOG_INFO_EVERY(ms)    VIDEOCOMPOSER_LOG_EVERY(videocomposer::Logger::INFO, ms)
+#define LOG_DEBUG_EVERY(ms)   VIDEOCOMPOSER_LOG_EVERY(videocomposer::Logger::DEBUG, ms)
+#define LOG_VERBOSE_EVERY(ms) VIDEOCOMPOSER_LOG_EVERY(videocomposer::Logger::VERBOSE, ms)
 
 } // namespace videocomposer
 
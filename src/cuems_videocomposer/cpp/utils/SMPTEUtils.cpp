@@ -93,6 +93,35 @@ int64_t SMPTEUtils::insertDropFrames(int64_t frames) {
     return (1800L * minutes + off_f + off_adj);
 }
 
+int64_t SMPTEUtils::dropFrameToFrame(int f, int s, int m, int h) {
+    // 17982 frames per ten minutes (18000 labels minus 9 * 2 dropped)
+    int64_t tens = static_cast<int64_t>(h) * 6 + m / 10;
+    int64_t offM = m % 10;
+    return tens * 17982 + 30 * (offM * 60 + s) + f - 2 * offM;
+}
+
+void SMPTEUtils::framerateToRational(double framerate, int64_t& num, int64_t& den) {
+    if (framerate <= 0.0) {
+        num = 0;
+        den = 1;
+        return;
+    }
+    double nominal = std::rint(framerate);
+    if (std::abs(framerate - nominal) < 0.001) {
+        num = static_cast<int64_t>(nominal);
+        den = 1;
+        return;
+    }
+    double ntsc = std::rint(framerate * 1.001);
+    if (std::abs(framerate - ntsc / 1.001) < 0.001) {
+        num = static_cast<int64_t>(ntsc) * 1000;
+        den = 1001;
+        return;
+    }
+    num = static_cast<int64_t>(std::rint(framerate * 1000.0));
+    den = 1000;
+}
+
 int64_t SMPTEUtils::smpteToFrame(int type, int f, int s, int m, int h, int overflow,
                                   double framerate, bool wantDropframes, int midiClkConvert) {
     int64_t frame = 0;
@@ -114,11 +143,7 @@ int64_t SMPTEUtils::smpteToFrame(int type, int f, int s, int m, int h, int overf
          * Drop frame numbers (not frames) 00:00 and 00:01 at the
          * start of every minute except the tenth.
          */
-        int64_t base_time = static_cast<int64_t>((h * 3600) + ((m / 10) * 10 * 60)) * fps;
-        int64_t off_m = m % 10;
-        int64_t off_s = (off_m * 60) + s;
-        int64_t off_f = (30 * off_s) + f - (2 * off_m);
-        frame = base_time + off_f;
+        frame = dropFrameToFrame(f, s, m, h);
         fps = 30.0;
     } else {
         frame = f + static_cast<int64_t>(fps * (s + 60 * m + 3600 * h));
@@ -67,6 +67,22 @@ public:
                                           bool wantDropframes = false,
                                           bool wantAutodrop = true);
 
+    /**
+     * Frame count of a 29.97 fps drop-frame timecode
+     *
+     * Exact integer arithmetic: labels ;00 and ;01 are skipped at the
+     * start of every minute except each tenth.
+     */
+    static int64_t dropFrameToFrame(int f, int s, int m, int h);
+
+    /**
+     * Exact rational for a framerate given as a double
+     *
+     * NTSC rates (23.976, 29.97, 47.952, 59.94, 119.88) map to N*1000/1001,
+     * integer rates to N/1, anything else to millihertz.
+     */
+    static void framerateToRational(double framerate, int64_t& num, int64_t& den);
+
 private:
     // Internal BCD structure for timecode components
     enum { SMPTE_FRAME = 0, SMPTE_SEC, SMPTE_MIN, SMPTE_HOUR, SMPTE_OVERFLOW, SMPTE_LAST };
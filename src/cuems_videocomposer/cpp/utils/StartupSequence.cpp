@@ -0,0 +1,157 @@
+#include "StartupSequence.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace videocomposer {
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+void StartupSequence::add(const std::string& name, Step step, const std::vector<std::string>& after,
+                          bool mainThread) {
+    Entry entry;
+    entry.name = name;
+    entry.step = std::move(step);
+    entry.mainThread = mainThread;
+    for (const std::string& dependency : after) {
+        size_t index = 0;
+        while (index < entries_.size() && entries_[index].name != dependency) {
+            ++index;
+        }
+        if (index == entries_.size()) {
+            // Only earlier steps can be named, so the graph has no cycles
+            LOG_ERROR << "StartupSequence: '" << name << "' needs unknown step '" << dependency << "'";
+            entry.step = [] { return false; };
+            continue;
+        }
+        entry.after.push_back(index);
+    }
+    entries_.push_back(std::move(entry));
+}
+
+bool StartupSequence::run() {
+    enum class State { Waiting, Running, Done };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<State> states(entries_.size(), State::Waiting);
+    timings_.assign(entries_.size(), Timing());
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        timings_[i].name = entries_[i].name;
+    }
+
+    std::mutex mutex;
+    std::condition_variable doneCond;
+    std::vector<std::thread> threads;
+    size_t running = 0;
+    bool failed = false;
+
+    auto ready = [&](size_t index) {
+        if (states[index] != State::Waiting) {
+            return false;
+        }
+        for (size_t dependency : entries_[index].after) {
+            if (states[dependency] != State::Done) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Starts every ready background step (mutex held); a finishing step
+    // calls it too, so its dependants don't wait for a main thread step
+    std::function<void(size_t)> execute;
+    auto launchReady = [&]() {
+        for (size_t i = 0; i < entries_.size() && !failed; ++i) {
+            if (!entries_[i].mainThread && ready(i)) {
+                states[i] = State::Running;
+                ++running;
+                threads.emplace_back(execute, i);
+            }
+        }
+    };
+
+    execute = [&](size_t index) {
+        double startMs = msSince(start);
+        bool ok = false;
+        try {
+            ok = entries_[index].step();
+        } catch (const std::exception& e) {
+            LOG_ERROR << "StartupSequence: '" << entries_[index].name << "' threw: " << e.what();
+        }
+        double durationMs = msSince(start) - startMs;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Timing& timing = timings_[index];
+        timing.startMs = startMs;
+        timing.durationMs = durationMs;
+        timing.ok = ok;
+        timing.ran = true;
+        states[index] = State::Done;
+        failed = failed || !ok;
+        --running;
+        launchReady();
+        doneCond.notify_all();
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        launchReady();
+        size_t mainStep = entries_.size();
+        for (size_t i = 0; i < entries_.size() && !failed && mainStep == entries_.size(); ++i) {
+            if (entries_[i].mainThread && ready(i)) {
+                mainStep = i;
+            }
+        }
+
+        if (mainStep < entries_.size()) {
+            states[mainStep] = State::Running;
+            ++running;
+            lock.unlock();
+            execute(mainStep);
+            lock.lock();
+            continue;
+        }
+        if (running == 0) {
+            break;
+        }
+        doneCond.wait(lock);
+    }
+    lock.unlock();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    totalMs_ = msSince(start);
+    return !failed;
+}
+
+void StartupSequence::logTimings() const {
+    for (const Timing& timing : timings_) {
+        if (!timing.ran) {
+            LOG_INFO << "Startup: " << timing.name << " skipped";
+            continue;
+        }
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << "Startup: " << timing.name << " " << timing.durationMs
+             << " ms (at " << timing.startMs << " ms)" << (timing.ok ? "" : " FAILED");
+        LOG_INFO << line.str();
+    }
+    std::ostringstream total;
+    total << std::fixed << std::setprecision(1) << totalMs_;
+    LOG_INFO << "Startup: " << total.str() << " ms total";
+}
+
+} // namespace videocomposer
@@ -0,0 +1,67 @@
+#ifndef VIDEOCOMPOSER_STARTUPSEQUENCE_H
+#define VIDEOCOMPOSER_STARTUPSEQUENCE_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * StartupSequence - Startup steps run as a dependency graph
+ *
+ * Each step names the steps it needs. A step whose dependencies are done
+ * starts right away: background steps on their own thread, main thread
+ * steps (anything touching the GL context or the display) on the thread
+ * calling run(). So MIDI and OSC setup or the VAAPI probe overlap the
+ * DRM/EGL bring-up instead of waiting for it.
+ *
+ * A step returning false stops the sequence: nothing new is started, the
+ * running steps are waited for and run() returns false. Optional
+ * steps report their own failure and return true.
+ */
+class StartupSequence {
+public:
+    using Step = std::function<bool()>;
+
+    struct Timing {
+        std::string name;
+        double startMs = 0.0;     // Since run() started
+        double durationMs = 0.0;
+        bool ok = false;
+        bool ran = false;         // False if skipped after a failure
+    };
+
+    /**
+     * @param after Steps that must finish first (added earlier)
+     * @param mainThread Run on the thread calling run()
+     */
+    void add(const std::string& name, Step step, const std::vector<std::string>& after = {},
+             bool mainThread = false);
+
+    bool run();
+
+    /** Per-step timings of the last run(), in the order the steps were added */
+    const std::vector<Timing>& timings() const { return timings_; }
+    double totalMs() const { return totalMs_; }
+
+    /** Log the timings (one line per step) */
+    void logTimings() const;
+
+private:
+    struct Entry {
+        std::string name;
+        Step step;
+        std::vector<size_t> after;
+        bool mainThread = false;
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<Timing> timings_;
+    double totalMs_ = 0.0;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_STARTUPSEQUENCE_H
@@ -0,0 +1,230 @@
+#include "ThreadRoles.h"
+#include "Logger.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace videocomposer {
+
+namespace {
+
+const char* const ROLE_NAMES[] = {
+    "render", "midi", "ltc", "osc", "decode", "loader", "hap", "io", "output"
+};
+
+// MIDI below LTC capture, both above rendering and decoding; LTC below
+// JACK's usual -P70 so audio servers keep precedence
+constexpr int MIDI_PRIORITY = 55;
+constexpr int LTC_PRIORITY = 60;
+
+bool parseInt(const std::string& text, int& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < 0 || parsed > 4095) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// "0-3,6" -> 0 1 2 3 6
+bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        std::string item = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t dash = item.find('-');
+        int first = 0;
+        int last = 0;
+        if (dash == std::string::npos) {
+            if (!parseInt(item, first)) {
+                return false;
+            }
+            last = first;
+        } else if (!parseInt(item.substr(0, dash), first) || !parseInt(item.substr(dash + 1), last) ||
+                   last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return !cpus.empty();
+}
+
+} // namespace
+
+ThreadRoles& ThreadRoles::instance() {
+    static ThreadRoles roles;
+    return roles;
+}
+
+ThreadRoles::ThreadRoles()
+    : configured_(false)
+{
+    for (int i = 0; i < static_cast<int>(ThreadRole::COUNT); ++i) {
+        hasPolicy_[i] = false;
+        warned_[i] = false;
+    }
+    policies_[static_cast<int>(ThreadRole::MIDI)].scheduler = FIFO;
+    policies_[static_cast<int>(ThreadRole::MIDI)].priority = MIDI_PRIORITY;
+    hasPolicy_[static_cast<int>(ThreadRole::MIDI)] = true;
+    policies_[static_cast<int>(ThreadRole::LTC)].scheduler = FIFO;
+    policies_[static_cast<int>(ThreadRole::LTC)].priority = LTC_PRIORITY;
+    hasPolicy_[static_cast<int>(ThreadRole::LTC)] = true;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                startCpus_.push_back(cpu);
+            }
+        }
+    }
+}
+
+const char* ThreadRoles::roleName(ThreadRole role) {
+    int index = static_cast<int>(role);
+    return index >= 0 && index < static_cast<int>(ThreadRole::COUNT) ? ROLE_NAMES[index] : "unknown";
+}
+
+bool ThreadRoles::parse(const std::string& spec, Policy& policy) {
+    Policy parsed;
+    std::string schedule = spec;
+    size_t at = spec.find('@');
+    if (at != std::string::npos) {
+        schedule = spec.substr(0, at);
+        if (!parseCpuList(spec.substr(at + 1), parsed.cpus)) {
+            return false;
+        }
+    }
+    
+    std::string name = schedule;
+    size_t colon = schedule.find(':');
+    if (colon != std::string::npos) {
+        name = schedule.substr(0, colon);
+        if (!parseInt(schedule.substr(colon + 1), parsed.priority)) {
+            return false;
+        }
+    }
+    
+    if (name.empty() || name == "other") {
+        parsed.scheduler = OTHER;
+    } else if (name == "batch") {
+        parsed.scheduler = BATCH;
+    } else if (name == "idle") {
+        parsed.scheduler = IDLE;
+    } else if (name == "fifo") {
+        parsed.scheduler = FIFO;
+    } else if (name == "rr") {
+        parsed.scheduler = RR;
+    } else {
+        return false;
+    }
+    
+    // Real-time policies need a priority, the others take none
+    bool realtime = parsed.scheduler == FIFO || parsed.scheduler == RR;
+    if (realtime && colon == std::string::npos) {
+        parsed.priority = 50;
+    }
+    if (realtime ? (parsed.priority < 1 || parsed.priority > 99) : parsed.priority != 0) {
+        return false;
+    }
+    policy = parsed;
+    return true;
+}
+
+bool ThreadRoles::configure(ThreadRole role, const std::string& spec) {
+    if (spec.empty()) {
+        return true;
+    }
+    Policy policy;
+    if (!parse(spec, policy)) {
+        LOG_WARNING << "Invalid thread_" << roleName(role) << " \"" << spec
+                    << "\" (expected policy[:priority][@cpus], e.g. fifo:70@2-3)";
+        return false;
+    }
+    setPolicy(role, policy);
+    return true;
+}
+
+void ThreadRoles::setPolicy(ThreadRole role, const Policy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int index = static_cast<int>(role);
+    policies_[index] = policy;
+    hasPolicy_[index] = true;
+    configured_ = true;
+}
+
+bool ThreadRoles::apply(ThreadRole role) {
+    int index = static_cast<int>(role);
+    Policy policy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!hasPolicy_[index] && !configured_) {
+            return true;  // Nothing configured: leave the thread as created
+        }
+        if (hasPolicy_[index]) {
+            policy = policies_[index];
+        }
+    }
+    
+    static const int POLICIES[] = {SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR};
+    sched_param sp;
+    std::memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = policy.priority;
+    int schedErr = pthread_setschedparam(pthread_self(), POLICIES[policy.scheduler], &sp);
+    
+    const std::vector<int>& cpus = policy.cpus.empty() ? startCpus_ : policy.cpus;
+    int affinityErr = 0;
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        affinityErr = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    
+    if (schedErr == 0 && affinityErr == 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!warned_[index]) {
+        warned_[index] = true;
+        if (schedErr != 0) {
+            LOG_WARNING << "No " << (policy.scheduler == FIFO || policy.scheduler == RR ? "real-time " : "")
+                        << "scheduling for " << roleName(role) << " threads (" << strerror(schedErr)
+                        << "), timing may jitter under load";
+        }
+        if (affinityErr != 0) {
+            LOG_WARNING << "Cannot pin " << roleName(role) << " threads to their CPUs (" << strerror(affinityErr) << ")";
+        }
+    }
+    return false;
+}
+
+bool ThreadRoles::lockMemory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        LOG_WARNING << "Cannot lock memory (" << strerror(errno) << "), raise RLIMIT_MEMLOCK or grant CAP_IPC_LOCK";
+        return false;
+    }
+    LOG_INFO << "Memory locked: no page faults on real-time threads";
+    return true;
+}
+
+} // namespace videocomposer
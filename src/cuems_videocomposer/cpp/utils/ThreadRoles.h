@@ -0,0 +1,99 @@
+#ifndef VIDEOCOMPOSER_THREADROLES_H
+#define VIDEOCOMPOSER_THREADROLES_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * Kinds of thread, each with its own scheduling configuration
+ */
+enum class ThreadRole {
+    RENDER,   // Main loop: composite, flip
+    MIDI,     // MTC receive
+    LTC,      // LTC audio capture
+    OSC,      // Remote control receive
+    DECODE,   // Layer decode, decode-ahead, image sequences, live inputs
+    LOADER,   // Cue loading, prefetch, background indexing
+    HAP,      // HAP chunk decompression workers
+    IO,       // Read-ahead, page cache policy, journal and trace writers
+    OUTPUT,   // Encoders and output sinks
+    COUNT
+};
+
+/**
+ * ThreadRoles - Scheduling policy, priority and CPU affinity per thread role
+ *
+ * Every long-lived thread calls apply() with its role when it starts. A
+ * role is configured with a spec "policy[:priority][@cpus]", e.g.
+ * "fifo:70@2-3" (render on isolated cores) or "other@0-1,4" (affinity
+ * only); policies are other, batch, idle, fifo and rr.
+ *
+ * Threads inherit policy and affinity from their creator, so once any
+ * role is configured the unconfigured ones are put back to SCHED_OTHER on
+ * the CPUs the process started with. With nothing configured only the
+ * built-in defaults apply (MIDI and LTC at SCHED_FIFO, as before).
+ */
+class ThreadRoles {
+public:
+    enum Scheduler {
+        OTHER,
+        BATCH,
+        IDLE,
+        FIFO,
+        RR
+    };
+
+    struct Policy {
+        Scheduler scheduler = OTHER;
+        int priority = 0;          // 1-99 for FIFO/RR, 0 otherwise
+        std::vector<int> cpus;     // Empty = the CPUs the process started with
+    };
+
+    static ThreadRoles& instance();
+
+    /** Config name of a role ("render", "midi", ...): key thread_<name> */
+    static const char* roleName(ThreadRole role);
+
+    /**
+     * Parse a role spec
+     * @return false (policy untouched) if the spec is malformed
+     */
+    static bool parse(const std::string& spec, Policy& policy);
+
+    /**
+     * Configure a role from a spec; an empty spec leaves the default
+     * @return false if the spec is malformed (logged, role unchanged)
+     */
+    bool configure(ThreadRole role, const std::string& spec);
+
+    void setPolicy(ThreadRole role, const Policy& policy);
+
+    /**
+     * Apply the role's policy to the calling thread
+     * @return false if the kernel refused part of it (logged once per role)
+     */
+    bool apply(ThreadRole role);
+
+    /**
+     * Lock current and future pages in RAM (mlockall), so a page fault
+     * never stalls a real-time thread
+     */
+    static bool lockMemory();
+
+private:
+    ThreadRoles();
+
+    mutable std::mutex mutex_;
+    Policy policies_[static_cast<int>(ThreadRole::COUNT)];
+    bool hasPolicy_[static_cast<int>(ThreadRole::COUNT)];
+    bool warned_[static_cast<int>(ThreadRole::COUNT)];
+    bool configured_;              // A role was configured: reset the others
+    std::vector<int> startCpus_;   // Process affinity at startup
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_THREADROLES_H
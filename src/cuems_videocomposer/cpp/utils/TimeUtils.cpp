@@ -3,7 +3,7 @@
 
 extern "C" {
 
-int64_t xj_get_monotonic_time(void) {
+int64_t vc_get_monotonic_time(void) {
     // Use std::chrono::steady_clock for monotonic time on Linux
     // This is equivalent to CLOCK_MONOTONIC
     auto now = std::chrono::steady_clock::now();
@@ -12,5 +12,11 @@ int64_t xj_get_monotonic_time(void) {
     return microseconds.count();
 }
 
+int64_t vc_get_realtime(void) {
+    auto now = std::chrono::system_clock::now();
+    auto duration = now.time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
 } // extern "C"
 
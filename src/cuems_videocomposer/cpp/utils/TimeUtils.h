@@ -20,6 +20,16 @@ extern "C" {
  */
 int64_t vc_get_monotonic_time(void);
 
+/**
+ * Get wall-clock time (CLOCK_REALTIME) in microseconds since the epoch
+ * 
+ * Not monotonic, but comparable between hosts whose clocks are
+ * disciplined by PTP or NTP.
+ * 
+ * @return Wall-clock time in microseconds
+ */
+int64_t vc_get_realtime(void);
+
 #ifdef __cplusplus
 }
 #endif
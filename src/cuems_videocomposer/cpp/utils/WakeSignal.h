@@ -0,0 +1,53 @@
+#ifndef VIDEOCOMPOSER_WAKESIGNAL_H
+#define VIDEOCOMPOSER_WAKESIGNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace videocomposer {
+
+/**
+ * WakeSignal - Wakes a thread sleeping on it from any other thread
+ *
+ * A notify() while nobody waits is kept for the next wait, so an event
+ * arriving just before the sleep is not lost.
+ */
+class WakeSignal {
+public:
+    void notify() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            signalled_ = true;
+        }
+        cond_.notify_one();
+    }
+
+    /**
+     * Sleep until notified or the timeout passes (consumes the notification)
+     * @return true if notified
+     */
+    bool waitFor(int64_t timeoutUs) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait_for(lock, std::chrono::microseconds(timeoutUs), [this] { return signalled_; });
+        bool signalled = signalled_;
+        signalled_ = false;
+        return signalled;
+    }
+
+    /** Forget a notification nobody waited for */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        signalled_ = false;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool signalled_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_WAKESIGNAL_H
@@ -0,0 +1,35 @@
+#ifndef VIDEOCOMPOSER_DMABUFPLANES_H
+#define VIDEOCOMPOSER_DMABUFPLANES_H
+
+#include <cstdint>
+#include <memory>
+
+namespace videocomposer {
+
+/**
+ * DmaBufPlanes - DMA-BUF behind hardware-decoded NV12 textures
+ *
+ * Lets the DRM backend put a decoded frame straight on a plane instead of
+ * compositing it, and the Vulkan display import it without GL. The fds
+ * stay owned by the decoder interop (or VaapiDmaBufExporter); `owner`
+ * holds the decoder surface so it is not decoded into while it is on
+ * screen.
+ */
+struct DmaBufPlanes {
+    uint64_t key = 0;               // Unique per decoder surface (framebuffer cache key)
+    int fds[2] = {-1, -1};          // Y, UV (not owned)
+    uint32_t offsets[2] = {0, 0};
+    uint32_t pitches[2] = {0, 0};
+    uint64_t modifier = 0;          // DRM format modifier
+    int width = 0;
+    int height = 0;
+    std::shared_ptr<void> owner;    // Keeps the decoder surface alive
+
+    bool isValid() const {
+        return fds[0] >= 0 && fds[1] >= 0 && width > 0 && height > 0;
+    }
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_DMABUFPLANES_H
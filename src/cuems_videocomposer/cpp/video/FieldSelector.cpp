@@ -0,0 +1,47 @@
+#include "FieldSelector.h"
+
+namespace videocomposer {
+
+FieldSelector::FieldSelector()
+    : generation_(0)
+    , shownAt_(0.0)
+    , phase_(0)
+{
+}
+
+FieldSelector::Mode FieldSelector::parseMode(const std::string& name) {
+    if (name == "off") return Mode::OFF;
+    if (name == "bob") return Mode::BOB;
+    if (name == "adaptive") return Mode::ADAPTIVE;
+    return Mode::AUTO;
+}
+
+FieldSelector::Mode FieldSelector::resolve(Mode mode, FieldOrder order) {
+    if (mode == Mode::AUTO) {
+        return order == FieldOrder::PROGRESSIVE ? Mode::OFF : Mode::ADAPTIVE;
+    }
+    return mode;
+}
+
+int FieldSelector::parity(Mode mode, FieldOrder order, int phase) {
+    if (resolve(mode, order) == Mode::OFF) {
+        return -1;
+    }
+    // Forced on an unflagged source: top field first, as most sources are
+    int first = order == FieldOrder::BOTTOM_FIRST ? 1 : 0;
+    return phase == 0 ? first : 1 - first;
+}
+
+void FieldSelector::update(uint64_t frameGeneration, double nowSeconds, double framerate) {
+    if (frameGeneration != generation_) {
+        generation_ = frameGeneration;
+        shownAt_ = nowSeconds;
+        phase_ = 0;
+        return;
+    }
+    if (framerate > 0.0 && nowSeconds - shownAt_ >= SECOND_FIELD_AT * 0.5 / framerate) {
+        phase_ = 1;
+    }
+}
+
+} // namespace videocomposer
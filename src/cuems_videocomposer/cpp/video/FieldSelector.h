@@ -0,0 +1,67 @@
+#ifndef VIDEOCOMPOSER_FIELDSELECTOR_H
+#define VIDEOCOMPOSER_FIELDSELECTOR_H
+
+#include "FrameFormat.h"
+#include <cstdint>
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * FieldSelector - Which field of an interlaced frame an output frame shows
+ *
+ * Interlaced sources are shown at field rate: each frame's first field
+ * from when it is shown, its second field once half the frame period has
+ * gone by. The phase follows the output frames the frame is actually
+ * shown on, so any output rate cadence (25i on 60 Hz: fields of two or
+ * one output frames) keeps the fields in order, with no field skipped
+ * where the output rate allows both. The renderer then draws the field
+ * (VAAPI VPP already did, or the deinterlace shader does it).
+ */
+class FieldSelector {
+public:
+    enum class Mode {
+        OFF,       // Show frames as they are
+        AUTO,      // ADAPTIVE for sources flagged interlaced
+        BOB,       // Interpolate the shown field's lines
+        ADAPTIVE   // Keep both fields where they agree, bob where they comb
+    };
+
+    // Share of half a frame period after which the second field is due
+    // (an output frame a little early still shows it)
+    static constexpr double SECOND_FIELD_AT = 0.75;
+
+    FieldSelector();
+
+    static Mode parseMode(const std::string& name);
+
+    /** Mode a source is drawn with (OFF for progressive sources unless forced) */
+    static Mode resolve(Mode mode, FieldOrder order);
+
+    /**
+     * Line parity to show
+     * @param phase 0 for the first field in time, 1 for the second
+     * @return 0 = top (even) lines, 1 = bottom (odd) lines, -1 = whole frame
+     */
+    static int parity(Mode mode, FieldOrder order, int phase);
+
+    /**
+     * Once per output frame
+     * @param frameGeneration Changes whenever a new frame is shown
+     * @param nowSeconds Monotonic time of this output frame
+     * @param framerate Source frames per second (as played, 0 = unknown)
+     */
+    void update(uint64_t frameGeneration, double nowSeconds, double framerate);
+
+    /** Field due now: 0 = first, 1 = second */
+    int getPhase() const { return phase_; }
+
+private:
+    uint64_t generation_;
+    double shownAt_;
+    int phase_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FIELDSELECTOR_H
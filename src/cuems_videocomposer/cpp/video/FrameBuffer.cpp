@@ -1,7 +1,11 @@
 #include "FrameBuffer.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <utility>  // for std::swap
+#include <vector>
+#include <unistd.h>
 
 extern "C" {
 #include <libavutil/avutil.h>
@@ -11,45 +15,136 @@ extern "C" {
 
 namespace videocomposer {
 
-FrameBuffer::FrameBuffer() : buffer_(nullptr), size_(0) {
-}
+namespace {
 
-FrameBuffer::FrameBuffer(const FrameBuffer& other) 
-    : buffer_(nullptr), size_(0), info_(other.info_) {
-    // Deep copy: allocate new buffer and copy data
-    if (other.buffer_ && other.size_ > 0 && other.info_.width > 0 && other.info_.height > 0) {
-        if (allocate(other.info_)) {
-            // Only copy if allocation succeeded and sizes match
-            if (buffer_ && size_ == other.size_) {
-                memcpy(buffer_, other.buffer_, size_);
+constexpr size_t CACHE_ALIGNMENT = 64;              // Cache line, widest SIMD load
+constexpr size_t PAGE_ALIGN_FROM = 64 * 1024;       // Frame-sized blocks: page aligned
+constexpr size_t STORAGE_CACHE_BYTES = 256 * 1024 * 1024;
+constexpr size_t STORAGE_CACHE_BLOCKS = 16;
+
+/**
+ * Storage blocks released by the last buffer using them, kept for the next
+ * allocation of the same size: a frame-sized block from the heap is a fresh
+ * mapping, and page faults on every frame cost as much as the copy
+ * copy-on-write saves.
+ */
+class StorageCache {
+public:
+    static StorageCache& instance() {
+        // Never destroyed: buffers may outlive static destruction
+        static StorageCache* cache = new StorageCache();
+        return *cache;
+    }
+
+    uint8_t* acquire(size_t capacity) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < blocks_.size(); ++i) {
+                if (blocks_[i].capacity == capacity) {
+                    uint8_t* data = blocks_[i].data;
+                    bytes_ -= capacity;
+                    blocks_[i] = blocks_.back();
+                    blocks_.pop_back();
+                    return data;
+                }
+            }
+        }
+        size_t alignment = capacity >= PAGE_ALIGN_FROM ? static_cast<size_t>(sysconf(_SC_PAGESIZE)) : CACHE_ALIGNMENT;
+        void* data = nullptr;
+        if (posix_memalign(&data, std::max(alignment, CACHE_ALIGNMENT), capacity) != 0) {
+            return nullptr;
+        }
+        return static_cast<uint8_t*>(data);
+    }
+
+    void release(uint8_t* data, size_t capacity) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (blocks_.size() < STORAGE_CACHE_BLOCKS && bytes_ + capacity <= STORAGE_CACHE_BYTES) {
+                blocks_.push_back({data, capacity});
+                bytes_ += capacity;
+                return;
             }
         }
+        free(data);
     }
+
+private:
+    struct Block {
+        uint8_t* data;
+        size_t capacity;
+    };
+
+    std::mutex mutex_;
+    std::vector<Block> blocks_;
+    size_t bytes_ = 0;
+};
+
+// Convert PixelFormat to AVPixelFormat
+AVPixelFormat toAVPixelFormat(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::YUV420P:
+            return AV_PIX_FMT_YUV420P;
+        case PixelFormat::RGB24:
+            return AV_PIX_FMT_RGB24;
+        case PixelFormat::RGBA32:
+            return AV_PIX_FMT_RGB32;
+        case PixelFormat::BGRA32:
+            return AV_PIX_FMT_BGR32;
+        case PixelFormat::UYVY422:
+            return AV_PIX_FMT_UYVY422;
+        case PixelFormat::YUV420P10:
+            return AV_PIX_FMT_YUV420P10LE;
+        case PixelFormat::NV12:
+            return AV_PIX_FMT_NV12;
+        case PixelFormat::YUYV422:
+            return AV_PIX_FMT_YUYV422;
+        default:
+            return AV_PIX_FMT_YUV420P;
+    }
+}
+
+} // namespace
+
+FrameBuffer::FrameBuffer() : buffer_(nullptr), size_(0), ownsBuffer_(true) {
+}
+
+FrameBuffer::FrameBuffer(const FrameBuffer& other) 
+    : buffer_(nullptr), size_(0), info_(other.info_), ownsBuffer_(true) {
+    *this = other;
 }
 
 FrameBuffer& FrameBuffer::operator=(const FrameBuffer& other) {
     if (this != &other) {
         release();
         info_ = other.info_;
-        // Deep copy: allocate new buffer and copy data
-        if (other.buffer_ && other.size_ > 0 && other.info_.width > 0 && other.info_.height > 0) {
-            if (allocate(other.info_)) {
-                // Only copy if allocation succeeded and sizes match
-                if (buffer_ && size_ == other.size_) {
-                    memcpy(buffer_, other.buffer_, size_);
-                }
-            }
+        if (other.owner_) {
+            // Storage block or shared external memory: reference it
+            buffer_ = other.buffer_;
+            size_ = other.size_;
+            ownsBuffer_ = other.ownsBuffer_;
+            owner_ = other.owner_;
+            layout_ = other.layout_;
+            return *this;
+        }
+        // Wrapped memory whose lifetime we don't control: copy it
+        if (other.buffer_ && other.size_ > 0 && allocateStorage(other.size_, false)) {
+            memcpy(buffer_, other.buffer_, size_);
+            layout_ = other.layout_;
         }
     }
     return *this;
 }
 
 FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
-    : buffer_(other.buffer_), size_(other.size_), info_(other.info_) {
+    : buffer_(other.buffer_), size_(other.size_), info_(other.info_), ownsBuffer_(other.ownsBuffer_),
+      owner_(std::move(other.owner_)), layout_(other.layout_) {
     // Take ownership, leave other in valid empty state
     other.buffer_ = nullptr;
     other.size_ = 0;
     other.info_ = {};
+    other.ownsBuffer_ = true;
+    other.layout_ = {};
 }
 
 FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept {
@@ -58,10 +153,15 @@ FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept {
         buffer_ = other.buffer_;
         size_ = other.size_;
         info_ = other.info_;
+        ownsBuffer_ = other.ownsBuffer_;
+        owner_ = std::move(other.owner_);
+        layout_ = other.layout_;
         // Leave other in valid empty state
         other.buffer_ = nullptr;
         other.size_ = 0;
         other.info_ = {};
+        other.ownsBuffer_ = true;
+        other.layout_ = {};
     }
     return *this;
 }
@@ -70,64 +170,124 @@ void FrameBuffer::swap(FrameBuffer& other) noexcept {
     std::swap(buffer_, other.buffer_);
     std::swap(size_, other.size_);
     std::swap(info_, other.info_);
+    std::swap(ownsBuffer_, other.ownsBuffer_);
+    std::swap(owner_, other.owner_);
+    std::swap(layout_, other.layout_);
 }
 
 FrameBuffer::~FrameBuffer() {
     release();
 }
 
-bool FrameBuffer::allocate(const FrameInfo& info) {
+bool FrameBuffer::allocateStorage(size_t size, bool zero) {
+    release();
+    size_t capacity = (size + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+    uint8_t* data = capacity > 0 ? StorageCache::instance().acquire(capacity) : nullptr;
+    if (!data) {
+        return false;
+    }
+    if (zero) {
+        memset(data, 0, size);
+    }
+    owner_ = std::shared_ptr<void>(data, [capacity](void* block) {
+        StorageCache::instance().release(static_cast<uint8_t*>(block), capacity);
+    });
+    buffer_ = data;
+    size_ = size;
+    ownsBuffer_ = true;
+    return true;
+}
+
+void FrameBuffer::setLayout(int rowAlignment) {
+    layout_ = {};
+    uint8_t* planes[4] = {nullptr, nullptr, nullptr, nullptr};
+    int ret = av_image_fill_arrays(planes, layout_.strides, buffer_, toAVPixelFormat(info_.format),
+                                   info_.width, info_.height, rowAlignment);
+    if (ret < 0 || static_cast<size_t>(ret) > size_) {
+        layout_ = {};
+        return;
+    }
+    for (int i = 0; i < 4; ++i) {
+        layout_.offsets[i] = planes[i] ? static_cast<size_t>(planes[i] - buffer_) : 0;
+    }
+    layout_.rowAlignment = rowAlignment;
+}
+
+void FrameBuffer::detach() {
+    // Another buffer still shows these pixels: write into a copy
+    std::shared_ptr<void> shared = owner_;
+    const uint8_t* source = buffer_;
+    PlaneLayout layout = layout_;
+    if (allocateStorage(size_, false)) {
+        memcpy(buffer_, source, size_);
+        layout_ = layout;
+    }
+}
+
+bool FrameBuffer::allocate(const FrameInfo& info, int rowAlignment) {
     release();
     
     info_ = info;
-    
-    // Convert PixelFormat to AVPixelFormat
-    AVPixelFormat avFormat;
-    switch (info.format) {
-        case PixelFormat::YUV420P:
-            avFormat = AV_PIX_FMT_YUV420P;
-            break;
-        case PixelFormat::RGB24:
-            avFormat = AV_PIX_FMT_RGB24;
-            break;
-        case PixelFormat::RGBA32:
-            avFormat = AV_PIX_FMT_RGB32;
-            break;
-        case PixelFormat::BGRA32:
-            avFormat = AV_PIX_FMT_BGR32;
-            break;
-        case PixelFormat::UYVY422:
-            avFormat = AV_PIX_FMT_UYVY422;
-            break;
-        default:
-            avFormat = AV_PIX_FMT_YUV420P;
-            break;
-    }
+    rowAlignment = std::max(rowAlignment, 1);
     
     // Calculate buffer size using modern FFmpeg API
-    int ret = av_image_get_buffer_size(avFormat, info.width, info.height, 1);
-    if (ret < 0) {
+    int ret = av_image_get_buffer_size(toAVPixelFormat(info.format), info.width, info.height, rowAlignment);
+    if (ret < 0 || !allocateStorage(static_cast<size_t>(ret), true)) {
         return false;
     }
-    size_ = ret;
-    
-    // Allocate buffer
-    buffer_ = static_cast<uint8_t*>(calloc(1, size_));
-    if (!buffer_) {
-        size_ = 0;
+    setLayout(rowAlignment);
+    return true;
+}
+
+bool FrameBuffer::ensureAllocated(const FrameInfo& info, int rowAlignment) {
+    // Wrapped writable memory (a mapping) is reused as it is
+    if (isValid() && !isShared() && info_.width == info.width && info_.height == info.height &&
+        info_.format == info.format && (!ownsBuffer_ || layout_.rowAlignment == std::max(rowAlignment, 1))) {
+        // Same geometry - keep the existing allocation, refresh metadata only
+        info_ = info;
+        return true;
+    }
+    return allocate(info, rowAlignment);
+}
+
+void FrameBuffer::release() {
+    buffer_ = nullptr;
+    size_ = 0;
+    ownsBuffer_ = true;
+    owner_.reset();
+    layout_ = {};
+}
+
+bool FrameBuffer::getPlanes(const uint8_t* planes[4], int strides[4]) const {
+    if (!isValid() || layout_.rowAlignment == 0) {
         return false;
     }
-    
+    for (int i = 0; i < 4; ++i) {
+        planes[i] = layout_.strides[i] > 0 ? buffer_ + layout_.offsets[i] : nullptr;
+        strides[i] = layout_.strides[i];
+    }
     return true;
 }
 
-void FrameBuffer::release() {
-    if (buffer_) {
-        free(buffer_);
-        buffer_ = nullptr;
+bool FrameBuffer::wrap(uint8_t* data, size_t size, const FrameInfo& info) {
+    release();
+    if (!data || size == 0) {
+        return false;
     }
-    size_ = 0;
+    buffer_ = data;
+    size_ = size;
+    info_ = info;
+    ownsBuffer_ = false;
+    setLayout(1);
+    return true;
 }
 
-} // namespace videocomposer
+bool FrameBuffer::wrap(const uint8_t* data, size_t size, const FrameInfo& info, std::shared_ptr<void> owner) {
+    if (!wrap(const_cast<uint8_t*>(data), size, info)) {
+        return false;
+    }
+    owner_ = std::move(owner);
+    return true;
+}
 
+} // namespace videocomposer
@@ -8,6 +8,15 @@
 
 namespace videocomposer {
 
+/**
+ * FrameBuffer - Pixels of one frame, in CPU memory
+ *
+ * Owned pixels live in a refcounted storage block (64-byte aligned, page
+ * aligned from 64 KiB). Copies share the block and the first write through
+ * data() on a shared block gives the writer its own copy (copy-on-write),
+ * so frames move between decode, caches, processing and upload at the cost
+ * of a reference count. Do not keep a data() pointer across a copy.
+ */
 class FrameBuffer {
 public:
     FrameBuffer();
@@ -20,19 +29,55 @@ public:
     // Swap contents with another buffer (for efficient buffer swapping)
     void swap(FrameBuffer& other) noexcept;
 
-    // Allocate buffer for given format and dimensions
-    bool allocate(const FrameInfo& info);
+    // Allocate a zeroed buffer for given format and dimensions. Rows of
+    // every plane start at a multiple of rowAlignment bytes (1 = packed)
+    bool allocate(const FrameInfo& info, int rowAlignment = 1);
+
+    // Allocate only if the current buffer does not already match the given
+    // dimensions and format, or is shared (keeps pooled buffers from
+    // reallocating per frame)
+    bool ensureAllocated(const FrameInfo& info, int rowAlignment = 1);
     
     // Release buffer
     void release();
+    
+    // Use external memory (e.g. a mapped PBO) as this buffer's storage.
+    // The buffer does not own it: release() only forgets the pointer, and
+    // copies made from it are regular owning buffers.
+    bool wrap(uint8_t* data, size_t size, const FrameInfo& info);
+    
+    // Use read-only memory kept alive by owner (e.g. a frame an SDK hands
+    // out until it is freed). Copies share it instead of copying, and the
+    // owner is dropped with the last buffer referencing it.
+    bool wrap(const uint8_t* data, size_t size, const FrameInfo& info, std::shared_ptr<void> owner);
+    bool ownsData() const { return ownsBuffer_; }
 
-    // Get buffer pointer
-    uint8_t* data() { return buffer_; }
+    // Pixels referenced by other buffers too, or external read-only memory
+    bool isShared() const { return owner_ && (!ownsBuffer_ || owner_.use_count() > 1); }
+
+    // Get buffer pointer for writing: a block shared with other buffers is
+    // copied first (wrapped read-only memory must not be written through it)
+    uint8_t* data() {
+        if (ownsBuffer_ && owner_ && owner_.use_count() > 1) {
+            detach();
+        }
+        return buffer_;
+    }
     const uint8_t* data() const { return buffer_; }
 
     // Get buffer size
     size_t size() const { return size_; }
 
+    // Plane pointers and strides (bytes) for planar formats; packed formats
+    // return a single plane
+    bool getPlanes(const uint8_t* planes[4], int strides[4]) const;
+
+    // Bytes from one row of a plane to the next (0 if the plane is absent)
+    int stride(int plane = 0) const { return plane >= 0 && plane < 4 ? layout_.strides[plane] : 0; }
+
+    // Offset of a plane from data()
+    size_t planeOffset(int plane) const { return plane >= 0 && plane < 4 ? layout_.offsets[plane] : 0; }
+
     // Get frame info
     const FrameInfo& info() const { return info_; }
 
@@ -40,9 +85,22 @@ public:
     bool isValid() const { return buffer_ != nullptr && size_ > 0; }
 
 private:
+    struct PlaneLayout {
+        int strides[4] = {0, 0, 0, 0};
+        size_t offsets[4] = {0, 0, 0, 0};
+        int rowAlignment = 0;       // 0 = no layout (unknown format or short buffer)
+    };
+
+    bool allocateStorage(size_t size, bool zero);
+    void setLayout(int rowAlignment);
+    void detach();
+
     uint8_t* buffer_;
     size_t size_;
     FrameInfo info_;
+    bool ownsBuffer_;
+    std::shared_ptr<void> owner_;   // Owned storage block, or shared external memory (see wrap())
+    PlaneLayout layout_;
 };
 
 } // namespace videocomposer
@@ -0,0 +1,81 @@
+#include "FrameCode.h"
+
+namespace videocomposer {
+
+namespace {
+
+constexpr int CHECK_BITS = FrameCode::CELLS - 2 - FrameCode::BITS;
+constexpr int MIN_CONTRAST = 64;    // Reference cells closer than this: no strip
+
+// Cell values, reference cells first
+void cellValues(int64_t frame, bool (&white)[FrameCode::CELLS], uint32_t check) {
+    uint32_t value = static_cast<uint32_t>(frame % FrameCode::MODULO);
+    white[0] = true;
+    white[1] = false;
+    for (int bit = 0; bit < FrameCode::BITS; ++bit) {
+        white[2 + bit] = (value >> (FrameCode::BITS - 1 - bit)) & 1;
+    }
+    for (int bit = 0; bit < CHECK_BITS; ++bit) {
+        white[2 + FrameCode::BITS + bit] = (check >> (CHECK_BITS - 1 - bit)) & 1;
+    }
+}
+
+int luma(const uint8_t* pixel) {
+    return (pixel[0] + 2 * pixel[1] + pixel[2]) / 4;
+}
+
+} // namespace
+
+uint32_t FrameCode::check(uint32_t value) {
+    // Fold the bits, plus an odd constant so a black strip is invalid
+    uint32_t folded = 0x2D;
+    for (int shift = 0; shift < BITS; shift += CHECK_BITS) {
+        folded ^= value >> shift;
+    }
+    return folded & ((1u << CHECK_BITS) - 1);
+}
+
+void FrameCode::encodeRow(uint8_t* pixels, int width, int64_t frame) {
+    if (!pixels || width < CELLS) {
+        return;
+    }
+    if (frame < 0) {
+        frame = frame % MODULO + MODULO;
+    }
+    bool white[CELLS];
+    cellValues(frame, white, check(static_cast<uint32_t>(frame % MODULO)));
+    for (int x = 0; x < width; ++x) {
+        uint8_t level = white[static_cast<int64_t>(x) * CELLS / width] ? 255 : 0;
+        uint8_t* pixel = pixels + x * 4;
+        pixel[0] = pixel[1] = pixel[2] = level;
+        pixel[3] = 255;
+    }
+}
+
+int64_t FrameCode::decodeRow(const uint8_t* pixels, int width) {
+    if (!pixels || width < CELLS) {
+        return -1;
+    }
+    // Sample the middle of each cell, away from edges softened by scaling
+    int levels[CELLS];
+    for (int cell = 0; cell < CELLS; ++cell) {
+        int x = static_cast<int>((static_cast<int64_t>(cell) * 2 + 1) * width / (2 * CELLS));
+        levels[cell] = luma(pixels + x * 4);
+    }
+    if (levels[0] - levels[1] < MIN_CONTRAST) {
+        return -1;
+    }
+    int threshold = (levels[0] + levels[1]) / 2;
+
+    uint32_t value = 0;
+    for (int bit = 0; bit < BITS; ++bit) {
+        value = (value << 1) | (levels[2 + bit] > threshold ? 1u : 0u);
+    }
+    uint32_t stored = 0;
+    for (int bit = 0; bit < CHECK_BITS; ++bit) {
+        stored = (stored << 1) | (levels[2 + BITS + bit] > threshold ? 1u : 0u);
+    }
+    return stored == check(value) ? static_cast<int64_t>(value) : -1;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,44 @@
+#ifndef VIDEOCOMPOSER_FRAMECODE_H
+#define VIDEOCOMPOSER_FRAMECODE_H
+
+#include <cstdint>
+
+namespace videocomposer {
+
+/**
+ * FrameCode - Frame number as a strip of black and white cells
+ *
+ * The strip is CELLS equal cells across the image: a white and a black
+ * reference cell, the frame number (BITS bits, most significant first,
+ * white = 1) and a 6-bit check. Cells are wide enough to survive scaling
+ * and filtering, so a frame number can be read back from the composited
+ * canvas or a camera image of the screen, and a damaged or blended strip
+ * (two frames mixed) fails the check instead of reading as a wrong frame.
+ */
+class FrameCode {
+public:
+    static constexpr int CELLS = 32;
+    static constexpr int BITS = 24;
+    static constexpr int64_t MODULO = int64_t(1) << BITS;   // Frame numbers wrap here
+
+    /**
+     * Write one row of the strip
+     * @param pixels Row of 4-byte pixels (BGRA or RGBA; the strip is grey)
+     * @param width Pixels in the row
+     * @param frame Frame number (taken modulo MODULO)
+     */
+    static void encodeRow(uint8_t* pixels, int width, int64_t frame);
+
+    /**
+     * Read one row of the strip
+     * @return Frame number, or -1 if the row is not a valid strip
+     */
+    static int64_t decodeRow(const uint8_t* pixels, int width);
+
+private:
+    static uint32_t check(uint32_t value);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMECODE_H
@@ -10,7 +10,45 @@ enum class PixelFormat {
     RGB24,
     RGBA32,
     BGRA32,
-    UYVY422
+    UYVY422,
+    YUV420P10,  // Planar 4:2:0, 10 bits per sample in 16-bit little-endian words
+    NV12,       // Y plane + interleaved UV plane, 4:2:0 (capture output, V4L2)
+    YUYV422     // Packed Y0 U Y1 V, 4:2:2 (V4L2 capture)
+};
+
+// YUV -> RGB matrix and sample range (used when YUV is converted on the GPU)
+enum class ColorMatrix {
+    BT601,
+    BT709,
+    BT2020
+};
+
+enum class ColorRange {
+    LIMITED,    // 16-235 (TV)
+    FULL        // 0-255 (PC/JPEG)
+};
+
+// Scan of the source: an interlaced frame holds two fields, its even (top)
+// and odd (bottom) lines, captured half a frame period apart
+enum class FieldOrder {
+    PROGRESSIVE,
+    TOP_FIRST,
+    BOTTOM_FIRST
+};
+
+// Part of the source picture a frame holds, in source pixels: set when the
+// decoder converted only what a layer shows (crop, panorama)
+struct FrameWindow {
+    int x = 0;
+    int y = 0;
+    int width = 0;              // 0 = the whole picture
+    int height = 0;
+
+    bool isWhole() const { return width <= 0 || height <= 0; }
+    bool operator==(const FrameWindow& other) const {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+    bool operator!=(const FrameWindow& other) const { return !(*this == other); }
 };
 
 struct FrameInfo {
@@ -18,12 +56,30 @@ struct FrameInfo {
     int height = 0;
     float aspect = 0.0f;
     double framerate = 0.0;
+    int framerateNum = 0;        // Exact framerate as num/den (0 = unknown, use framerate)
+    int framerateDen = 1;
     int64_t totalFrames = 0;
     double duration = 0.0;
     int64_t fileFrameOffset = 0;
     PixelFormat format = PixelFormat::YUV420P;
+    ColorMatrix colorMatrix = ColorMatrix::BT709;
+    ColorRange colorRange = ColorRange::LIMITED;
+    FieldOrder fieldOrder = FieldOrder::PROGRESSIVE;
+    FrameWindow window;          // Of a frame: the part of the picture held (width x height)
 };
 
+// Planar YUV formats that the renderer converts to RGB in a shader
+inline bool isPlanarYUV(PixelFormat format) {
+    return format == PixelFormat::YUV420P || format == PixelFormat::YUV420P10;
+}
+
+// CPU frames the renderer converts to RGB in a shader: planar YUV, and
+// NV12 and packed 4:2:2 from live inputs
+inline bool isShaderYUV(PixelFormat format) {
+    return isPlanarYUV(format) || format == PixelFormat::UYVY422 ||
+           format == PixelFormat::YUYV422 || format == PixelFormat::NV12;
+}
+
 } // namespace videocomposer
 
 #endif // VIDEOCOMPOSER_FRAMEFORMAT_H
@@ -0,0 +1,179 @@
+#include "FramePool.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+namespace {
+// The slot is reset when its control block is freed (HandleAllocator)
+struct KeepSlot {
+    void operator()(FramePool::Slot*) const {}
+};
+}
+
+/**
+ * Places a handle's control block in its slot. The block is freed after
+ * it is destroyed, so that is when the slot can go back to the pool: a
+ * slot released from the deleter could be handed out again while the old
+ * block is still being torn down.
+ */
+template <typename T>
+class FramePool::HandleAllocator {
+public:
+    using value_type = T;
+
+    HandleAllocator(FramePool* pool, Slot* slot) : pool_(pool), slot_(slot) {}
+    template <typename U>
+    HandleAllocator(const HandleAllocator<U>& other) : pool_(other.pool_), slot_(other.slot_) {}
+
+    T* allocate(size_t n) {
+        static_assert(sizeof(T) <= HANDLE_BLOCK_SIZE, "FramePool::HANDLE_BLOCK_SIZE too small");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "FramePool handle block misaligned");
+        (void)n;  // Always 1: one control block per handle
+        return reinterpret_cast<T*>(slot_->handleBlock);
+    }
+
+    void deallocate(T*, size_t) {
+        pool_->release(slot_);
+    }
+
+    template <typename U>
+    bool operator==(const HandleAllocator<U>& other) const { return slot_ == other.slot_; }
+    template <typename U>
+    bool operator!=(const HandleAllocator<U>& other) const { return slot_ != other.slot_; }
+
+private:
+    template <typename U> friend class HandleAllocator;
+
+    FramePool* pool_;
+    Slot* slot_;
+};
+
+std::shared_ptr<FramePool> FramePool::create(size_t capacity, size_t bytesPerFrame) {
+    // Constructor is private, so make_shared cannot be used
+    return std::shared_ptr<FramePool>(new FramePool(capacity, bytesPerFrame));
+}
+
+size_t FramePool::capacityForBudget(size_t budgetBytes, size_t bytesPerFrame,
+                                    size_t minFrames, size_t maxFrames) {
+    if (maxFrames < minFrames) {
+        maxFrames = minFrames;
+    }
+    if (budgetBytes == 0 || bytesPerFrame == 0) {
+        return minFrames;
+    }
+    size_t frames = budgetBytes / bytesPerFrame;
+    return std::max(minFrames, std::min(frames, maxFrames));
+}
+
+FramePool::FramePool(size_t capacity, size_t bytesPerFrame)
+    : bytesPerFrame_(bytesPerFrame)
+    , peakInUse_(0)
+    , hits_(0)
+    , misses_(0)
+    , exhausted_(0)
+    , budgetAccount_(MemoryBudget::resolve(MemoryBudget::Account(MemoryBudget::Subsystem::FRAME_POOLS)))
+{
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    // Slots fill up once playing: charged at capacity from the start
+    MemoryBudget::instance().charge(budgetAccount_, capacity * bytesPerFrame_);
+
+    slots_.reserve(capacity);
+    freeSlots_.reserve(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        auto slot = std::make_unique<Slot>();
+        // AVFrame shells are allocated once; only their refs change per frame
+        slot->avFrame = av_frame_alloc();
+        freeSlots_.push_back(slot.get());
+        slots_.push_back(std::move(slot));
+    }
+}
+
+FramePool::~FramePool() {
+    // Handles keep the pool alive, so no slot can be in use here
+    for (auto& slot : slots_) {
+        if (slot->avFrame) {
+            av_frame_free(&slot->avFrame);
+        }
+    }
+    MemoryBudget::instance().release(budgetAccount_, slots_.size() * bytesPerFrame_);
+}
+
+FramePool::Handle FramePool::acquire() {
+    Slot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (freeSlots_.empty()) {
+            exhausted_++;
+            return nullptr;
+        }
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        peakInUse_ = std::max(peakInUse_, slots_.size() - freeSlots_.size());
+        if (!self_) {
+            // The pool outlives its handles: one reference while any is out,
+            // not one per frame
+            self_ = shared_from_this();
+        }
+    }
+
+    return Handle(slot, KeepSlot(), HandleAllocator<Slot>(this, slot));
+}
+
+void FramePool::release(Slot* slot) {
+    slot->frameNumber = -1;
+    if (slot->avFrame) {
+        // Drops decoder/hardware surface references, keeps the AVFrame shell
+        av_frame_unref(slot->avFrame);
+    }
+    // slot->buffer stays allocated so the next user can reuse it
+
+    std::shared_ptr<FramePool> self;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeSlots_.push_back(slot);
+        if (freeSlots_.size() == slots_.size()) {
+            self = std::move(self_);
+        }
+    }
+    // May destroy the pool, when its owners let go of it first
+}
+
+void FramePool::recordHit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hits_++;
+}
+
+void FramePool::recordMiss() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    misses_++;
+}
+
+size_t FramePool::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return freeSlots_.size();
+}
+
+FramePool::Stats FramePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.capacity = slots_.size();
+    stats.inUse = slots_.size() - freeSlots_.size();
+    stats.peakInUse = peakInUse_;
+    stats.bytesPerFrame = bytesPerFrame_;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.exhausted = exhausted_;
+    return stats;
+}
+
+void FramePool::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peakInUse_ = slots_.size() - freeSlots_.size();
+    hits_ = 0;
+    misses_ = 0;
+    exhausted_ = 0;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,130 @@
+#ifndef VIDEOCOMPOSER_FRAMEPOOL_H
+#define VIDEOCOMPOSER_FRAMEPOOL_H
+
+#include "FrameBuffer.h"
+#include "MemoryBudget.h"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace videocomposer {
+
+/**
+ * FramePool - Refcounted, fixed-capacity pool of decoded frames
+ *
+ * Shared by VideoFileInput (CPU pre-buffer) and AsyncDecodeQueue (decode-ahead
+ * queue) so that each layer has one bounded set of frame slots instead of two
+ * independent caches that allocate per frame.
+ *
+ * - Slots are allocated once when the pool is created and recycled afterwards
+ * - acquire() hands out a shared_ptr handle; dropping the last reference
+ *   returns the slot to the pool (AVFrame refs are unreferenced, CPU buffers
+ *   are kept allocated for reuse)
+ * - The handle's control block lives in its slot, so acquire() and release
+ *   do not touch the heap; the pool keeps itself alive while slots are out
+ * - acquire() returns nullptr when every slot is in use - callers treat this
+ *   as back-pressure rather than allocating more memory
+ * - Capacity is derived from a per-layer memory budget (see capacityForBudget)
+ * - capacity x bytesPerFrame is charged to MemoryBudget (FRAME_POOLS), to
+ *   the layer of the creating thread's LayerScope
+ */
+class FramePool : public std::enable_shared_from_this<FramePool> {
+    // Room for one handle's shared_ptr control block
+    static constexpr size_t HANDLE_BLOCK_SIZE = 64;
+
+public:
+    /**
+     * One pooled frame. Either buffer (software path) or avFrame (decoder
+     * output, possibly a hardware surface reference) is used by the owner.
+     */
+    struct Slot {
+        int64_t frameNumber = -1;
+        FrameBuffer buffer;
+        AVFrame* avFrame = nullptr;
+
+    private:
+        friend class FramePool;
+        alignas(std::max_align_t) unsigned char handleBlock[HANDLE_BLOCK_SIZE];
+    };
+
+    using Handle = std::shared_ptr<Slot>;
+
+    struct Stats {
+        size_t capacity = 0;
+        size_t inUse = 0;
+        size_t peakInUse = 0;
+        size_t bytesPerFrame = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t exhausted = 0;  // acquire() calls that found no free slot
+    };
+
+    static constexpr size_t MIN_FRAMES = 4;
+    static constexpr size_t MAX_FRAMES = 32;
+
+    /**
+     * Create a pool with a fixed number of slots
+     * @param capacity Number of slots (clamped to at least 1)
+     * @param bytesPerFrame Approximate size of one frame (statistics and budget)
+     */
+    static std::shared_ptr<FramePool> create(size_t capacity, size_t bytesPerFrame = 0);
+
+    /**
+     * Compute pool capacity from a memory budget
+     * @param budgetBytes Memory budget for this pool (0 = use minFrames)
+     * @param bytesPerFrame Size of one decoded frame
+     * @return Number of slots, clamped to [minFrames, maxFrames]
+     */
+    static size_t capacityForBudget(size_t budgetBytes, size_t bytesPerFrame,
+                                    size_t minFrames = MIN_FRAMES,
+                                    size_t maxFrames = MAX_FRAMES);
+
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * Take a free slot from the pool
+     * @return Handle to the slot, or nullptr if the pool is exhausted
+     */
+    Handle acquire();
+
+    // Cache lookup accounting (recorded by the pool's users)
+    void recordHit();
+    void recordMiss();
+
+    size_t capacity() const { return slots_.size(); }
+    size_t available() const;
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    template <typename T> class HandleAllocator;
+
+    FramePool(size_t capacity, size_t bytesPerFrame);
+
+    void release(Slot* slot);
+
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::vector<Slot*> freeSlots_;
+    size_t bytesPerFrame_;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<FramePool> self_;  // Set while any slot is in use
+    size_t peakInUse_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t exhausted_;
+    MemoryBudget::Account budgetAccount_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_FRAMEPOOL_H
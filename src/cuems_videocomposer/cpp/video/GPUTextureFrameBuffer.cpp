@@ -1,8 +1,13 @@
 #include "GPUTextureFrameBuffer.h"
+#include "TexturePool.h"
 #include "../utils/Logger.h"
+#include "../utils/FrameTracer.h"
 #include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <utility>
+#include <algorithm>
+#include <vector>
 
 // OpenGL includes
 #ifdef __APPLE__
@@ -11,7 +16,7 @@
 #include <GL/gl.h>
 #endif
 
-// HAP uses S3TC compressed textures (DXT1/DXT5) and BPTC (BC7) for HAP R
+// HAP uses S3TC compressed textures (DXT1/DXT5) and BPTC (BC7/BC6H) for HAP R and HAP HDR
 #ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
 #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
 #endif
@@ -21,9 +26,28 @@
 #ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
 #define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
 #endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+
+// Texture swizzle (GL 3.3 / ES 3.0), lets YUYV share the UYVY shader
+#ifndef GL_TEXTURE_SWIZZLE_R
+#define GL_TEXTURE_SWIZZLE_R 0x8E42
+#define GL_TEXTURE_SWIZZLE_G 0x8E43
+#define GL_TEXTURE_SWIZZLE_B 0x8E44
+#define GL_TEXTURE_SWIZZLE_A 0x8E45
+#endif
 
 namespace videocomposer {
 
+// Sample Y0 U Y1 V texels as U Y0 V Y1 (texture must be bound)
+static void setYUYVSwizzle() {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_GREEN);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_ALPHA);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_BLUE);
+}
+
 // Helper function to check OpenGL errors
 static bool checkGLError(const char* operation) {
     GLenum error = glGetError();
@@ -46,6 +70,7 @@ static bool checkGLError(const char* operation) {
 
 GPUTextureFrameBuffer::GPUTextureFrameBuffer()
     : textureIds_{0, 0, 0}
+    , immutable_(false)
     , numPlanes_(1)
     , planeType_(TexturePlaneType::SINGLE)
     , textureFormat_(0)
@@ -64,6 +89,8 @@ GPUTextureFrameBuffer::~GPUTextureFrameBuffer() {
 
 GPUTextureFrameBuffer::GPUTextureFrameBuffer(const GPUTextureFrameBuffer& other)
     : textureIds_{other.textureIds_[0], other.textureIds_[1], other.textureIds_[2]}
+    , planeKeys_{other.planeKeys_[0], other.planeKeys_[1], other.planeKeys_[2]}
+    , immutable_(other.immutable_)
     , numPlanes_(other.numPlanes_)
     , planeType_(other.planeType_)
     , textureFormat_(other.textureFormat_)
@@ -71,6 +98,8 @@ GPUTextureFrameBuffer::GPUTextureFrameBuffer(const GPUTextureFrameBuffer& other)
     , isHAP_(other.isHAP_)
     , ownsTexture_(false)  // Copy does NOT own the texture
     , hapVariant_(other.hapVariant_)
+    , dmaBuf_(other.dmaBuf_)
+    , fields_(other.fields_)
 {
 }
 
@@ -85,6 +114,10 @@ GPUTextureFrameBuffer& GPUTextureFrameBuffer::operator=(const GPUTextureFrameBuf
         textureIds_[0] = other.textureIds_[0];
         textureIds_[1] = other.textureIds_[1];
         textureIds_[2] = other.textureIds_[2];
+        for (int i = 0; i < MAX_PLANES; i++) {
+            planeKeys_[i] = other.planeKeys_[i];
+        }
+        immutable_ = other.immutable_;
         numPlanes_ = other.numPlanes_;
         planeType_ = other.planeType_;
         textureFormat_ = other.textureFormat_;
@@ -92,12 +125,16 @@ GPUTextureFrameBuffer& GPUTextureFrameBuffer::operator=(const GPUTextureFrameBuf
         isHAP_ = other.isHAP_;
         ownsTexture_ = false;  // Copy does NOT own the texture
         hapVariant_ = other.hapVariant_;
+        dmaBuf_ = other.dmaBuf_;
+        fields_ = other.fields_;
     }
     return *this;
 }
 
 GPUTextureFrameBuffer::GPUTextureFrameBuffer(GPUTextureFrameBuffer&& other) noexcept
     : textureIds_{other.textureIds_[0], other.textureIds_[1], other.textureIds_[2]}
+    , planeKeys_{other.planeKeys_[0], other.planeKeys_[1], other.planeKeys_[2]}
+    , immutable_(other.immutable_)
     , numPlanes_(other.numPlanes_)
     , planeType_(other.planeType_)
     , textureFormat_(other.textureFormat_)
@@ -105,11 +142,14 @@ GPUTextureFrameBuffer::GPUTextureFrameBuffer(GPUTextureFrameBuffer&& other) noex
     , isHAP_(other.isHAP_)
     , ownsTexture_(other.ownsTexture_)  // Take ownership from other
     , hapVariant_(other.hapVariant_)
+    , dmaBuf_(std::move(other.dmaBuf_))
+    , fields_(other.fields_)
 {
     // Clear other so it doesn't delete the texture
     other.textureIds_[0] = 0;
     other.textureIds_[1] = 0;
     other.textureIds_[2] = 0;
+    other.immutable_ = false;
     other.numPlanes_ = 1;
     other.planeType_ = TexturePlaneType::SINGLE;
     other.textureFormat_ = 0;
@@ -129,6 +169,10 @@ GPUTextureFrameBuffer& GPUTextureFrameBuffer::operator=(GPUTextureFrameBuffer&&
         textureIds_[0] = other.textureIds_[0];
         textureIds_[1] = other.textureIds_[1];
         textureIds_[2] = other.textureIds_[2];
+        for (int i = 0; i < MAX_PLANES; i++) {
+            planeKeys_[i] = other.planeKeys_[i];
+        }
+        immutable_ = other.immutable_;
         numPlanes_ = other.numPlanes_;
         planeType_ = other.planeType_;
         textureFormat_ = other.textureFormat_;
@@ -136,11 +180,14 @@ GPUTextureFrameBuffer& GPUTextureFrameBuffer::operator=(GPUTextureFrameBuffer&&
         isHAP_ = other.isHAP_;
         ownsTexture_ = other.ownsTexture_;
         hapVariant_ = other.hapVariant_;
+        dmaBuf_ = std::move(other.dmaBuf_);
+        fields_ = other.fields_;
         
         // Clear other so it doesn't delete the texture
         other.textureIds_[0] = 0;
         other.textureIds_[1] = 0;
         other.textureIds_[2] = 0;
+        other.immutable_ = false;
         other.numPlanes_ = 1;
         other.planeType_ = TexturePlaneType::SINGLE;
         other.textureFormat_ = 0;
@@ -156,6 +203,8 @@ bool GPUTextureFrameBuffer::allocate(const FrameInfo& info, GLenum textureFormat
     if (ownsTexture_) {
         release();
     }
+    dmaBuf_ = DmaBufPlanes();
+    fields_ = DeinterlacedFields();
     
     info_ = info;
     textureFormat_ = textureFormat;
@@ -170,70 +219,49 @@ bool GPUTextureFrameBuffer::allocate(const FrameInfo& info, GLenum textureFormat
     numPlanes_ = 1;
     planeType_ = TexturePlaneType::SINGLE;
     
-    // Generate OpenGL texture
     // Clear ALL pending GL errors first (important for DRM/KMS)
     while (glGetError() != GL_NO_ERROR) {}
-    GLenum error;
-    glGenTextures(1, &textureIds_[0]);
-    error = glGetError();
-    if (textureIds_[0] == 0 || error != GL_NO_ERROR) {
-        if (error == GL_NO_ERROR && textureIds_[0] == 0) {
-            LOG_WARNING << "GPUTextureFrameBuffer: glGenTextures returned 0 (no OpenGL context?)";
-        } else {
-            checkGLError("glGenTextures");
-        }
-        return false;
-    }
 
-    glBindTexture(GL_TEXTURE_2D, textureIds_[0]);
-    if (!checkGLError("glBindTexture")) {
-        LOG_WARNING << "GPUTextureFrameBuffer: glBindTexture failed";
-        glDeleteTextures(1, &textureIds_[0]);
-        textureIds_[0] = 0;
-        return false;
-    }
-    
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    if (!checkGLError("glTexParameteri")) {
-        LOG_WARNING << "GPUTextureFrameBuffer: glTexParameteri failed";
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDeleteTextures(1, &textureIds_[0]);
-        textureIds_[0] = 0;
+    // Storage comes from the pool: compressed HAP formats as they are,
+    // uncompressed ones sized (immutable storage needs sized formats)
+    TexturePool::Key key;
+    key.width = info.width;
+    key.height = info.height;
+    key.internalFormat = sizedFormat(textureFormat);
+    if (!acquirePlane(0, key)) {
+        LOG_WARNING << "GPUTextureFrameBuffer: No texture (no OpenGL context?)";
         return false;
     }
 
-    // Allocate texture storage (empty for now, will be filled by upload methods)
-    if (isHAP) {
-        // For HAP, we'll upload compressed data later
-        // Just allocate the texture object
-    } else {
-        // For uncompressed, allocate empty texture
-        glTexImage2D(GL_TEXTURE_2D, 0, textureFormat_, 
-                     info.width, info.height, 0,
-                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-        if (!checkGLError("glTexImage2D")) {
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glDeleteTextures(1, &textureIds_[0]);
-            textureIds_[0] = 0;
-            return false;
-        }
-    }
-
     glBindTexture(GL_TEXTURE_2D, 0);
     checkGLError("glBindTexture(unbind)");
     return true;
 }
 
+const TexturePool::Key& GPUTextureFrameBuffer::getPlaneStorage(int plane) const {
+    static const TexturePool::Key none;
+    if (plane < 0 || plane >= MAX_PLANES) {
+        return none;
+    }
+    return planeKeys_[plane];
+}
+
+size_t GPUTextureFrameBuffer::getTextureBytes() const {
+    size_t bytes = 0;
+    for (int i = 0; ownsTexture_ && i < numPlanes_; i++) {
+        if (textureIds_[i] != 0) {
+            bytes += TexturePool::textureBytes(planeKeys_[i]);
+        }
+    }
+    return bytes;
+}
+
 void GPUTextureFrameBuffer::release() {
     if (ownsTexture_) {
-        // Delete all allocated planes
+        // Planes go back to the pool, reused once the GPU is done with them
         for (int i = 0; i < numPlanes_; i++) {
             if (textureIds_[i] != 0) {
-                glDeleteTextures(1, &textureIds_[i]);
+                TexturePool::instance().releaseTexture(textureIds_[i], planeKeys_[i]);
                 textureIds_[i] = 0;
             }
         }
@@ -241,12 +269,66 @@ void GPUTextureFrameBuffer::release() {
     textureIds_[0] = 0;
     textureIds_[1] = 0;
     textureIds_[2] = 0;
+    for (int i = 0; i < MAX_PLANES; i++) {
+        planeKeys_[i] = TexturePool::Key();
+    }
+    immutable_ = false;
     numPlanes_ = 1;
     planeType_ = TexturePlaneType::SINGLE;
     textureFormat_ = 0;
     isHAP_ = false;
     ownsTexture_ = false;
     hapVariant_ = HapVariant::NONE;
+    dmaBuf_ = DmaBufPlanes();
+    fields_ = DeinterlacedFields();
+}
+
+GLenum GPUTextureFrameBuffer::sizedFormat(GLenum format) {
+    switch (format) {
+        case GL_RGBA:
+            return GL_RGBA8;
+        case GL_RGB:
+            return GL_RGB8;
+        case GL_RED:
+            return GL_R8;
+        case GL_RG:
+            return GL_RG8;
+        default:
+            return format;
+    }
+}
+
+bool GPUTextureFrameBuffer::acquirePlane(int plane, const TexturePool::Key& key) {
+    TexturePool& pool = TexturePool::instance();
+    textureIds_[plane] = pool.acquireTexture(key, budgetAccount_);
+    if (textureIds_[plane] == 0) {
+        return false;
+    }
+    planeKeys_[plane] = key;
+    immutable_ = pool.hasImmutableStorage();
+
+    // A recycled texture keeps the parameters of its last user
+    glBindTexture(GL_TEXTURE_2D, textureIds_[plane]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_RED);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_GREEN);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_BLUE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_ALPHA);
+    if (!checkGLError("glTexParameteri")) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        TexturePool::instance().releaseTexture(textureIds_[plane], key);
+        textureIds_[plane] = 0;
+        return false;
+    }
+    return true;
+}
+
+bool GPUTextureFrameBuffer::matchesStorage(int plane, int width, int height, GLenum format) const {
+    const TexturePool::Key& key = planeKeys_[plane];
+    return key.width == width && key.height == height && key.internalFormat == sizedFormat(format);
 }
 
 GLuint GPUTextureFrameBuffer::getTextureId(int plane) const {
@@ -256,11 +338,51 @@ GLuint GPUTextureFrameBuffer::getTextureId(int plane) const {
     return 0;
 }
 
+bool GPUTextureFrameBuffer::isCompressedFormatSupported(GLenum format) {
+    // The list only depends on the driver: query it once
+    static std::vector<GLint> formats;
+    static bool queried = false;
+    if (!queried) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        formats.resize(static_cast<size_t>(std::max(count, 0)));
+        if (count > 0) {
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        }
+        queried = glGetError() == GL_NO_ERROR;
+    }
+    return std::find(formats.begin(), formats.end(), static_cast<GLint>(format)) != formats.end();
+}
+
 bool GPUTextureFrameBuffer::uploadCompressedData(const uint8_t* data, size_t size, int width, int height, GLenum format) {
-    if (textureIds_[0] == 0 || data == nullptr || size == 0) {
+    if (data == nullptr) {
+        return false;
+    }
+    return compressedImage(data, size, width, height, format);
+}
+
+bool GPUTextureFrameBuffer::uploadCompressedFromBuffer(size_t offset, size_t size, int width, int height, GLenum format) {
+    return compressedImage(reinterpret_cast<const void*>(offset), size, width, height, format);
+}
+
+bool GPUTextureFrameBuffer::compressedImage(const void* pixels, size_t size, int width, int height, GLenum format) {
+    FRAME_TRACE_SCOPE("upload");
+    if (textureIds_[0] == 0 || size == 0) {
         return false;
     }
 
+    // Immutable storage cannot be respecified: a new size or format takes another texture
+    if (immutable_ && !matchesStorage(0, width, height, format)) {
+        FrameInfo info = info_;
+        info.width = width;
+        info.height = height;
+        HapVariant variant = hapVariant_;
+        if (!allocate(info, format, isHAP_)) {
+            return false;
+        }
+        hapVariant_ = variant;
+    }
+
     // Clear any pending GL errors (similar fix as VAAPI interop)
     while (glGetError() != GL_NO_ERROR) {}
 
@@ -269,10 +391,15 @@ bool GPUTextureFrameBuffer::uploadCompressedData(const uint8_t* data, size_t siz
         return false;
     }
     
-    // Upload compressed texture data (DXT1/DXT5 for HAP)
-    glCompressedTexImage2D(GL_TEXTURE_2D, 0, format,
-                           width, height, 0,
-                           static_cast<GLsizei>(size), data);
+    // Upload compressed texture data (DXT1/DXT5/BPTC for HAP)
+    if (immutable_) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
+                                  static_cast<GLsizei>(size), pixels);
+    } else {
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, format,
+                               width, height, 0,
+                               static_cast<GLsizei>(size), pixels);
+    }
     if (!checkGLError("glCompressedTexImage2D")) {
         glBindTexture(GL_TEXTURE_2D, 0);
         return false;
@@ -284,10 +411,20 @@ bool GPUTextureFrameBuffer::uploadCompressedData(const uint8_t* data, size_t siz
 }
 
 bool GPUTextureFrameBuffer::uploadUncompressedData(const uint8_t* data, size_t size, int width, int height, GLenum format, int stride) {
+    FRAME_TRACE_SCOPE("upload");
     if (textureIds_[0] == 0 || data == nullptr || size == 0) {
         return false;
     }
 
+    if (immutable_ && !matchesStorage(0, width, height, format)) {
+        FrameInfo info = info_;
+        info.width = width;
+        info.height = height;
+        if (!allocate(info, format, false)) {
+            return false;
+        }
+    }
+
     // Clear any pending GL errors
     while (glGetError() != GL_NO_ERROR) {}
 
@@ -306,9 +443,14 @@ bool GPUTextureFrameBuffer::uploadUncompressedData(const uint8_t* data, size_t s
     }
 
     // Upload uncompressed texture data
-    glTexImage2D(GL_TEXTURE_2D, 0, format,
-                 width, height, 0,
-                 GL_RGBA, GL_UNSIGNED_BYTE, data);
+    if (immutable_) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, data);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, format,
+                     width, height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
     if (!checkGLError("glTexImage2D")) {
         // Reset pixel store before returning
         if (stride > 0 && stride != width * 4) {
@@ -334,6 +476,8 @@ bool GPUTextureFrameBuffer::allocateMultiPlane(const FrameInfo& info, TexturePla
     if (ownsTexture_) {
         release();
     }
+    dmaBuf_ = DmaBufPlanes();
+    fields_ = DeinterlacedFields();
     
     info_ = info;
     planeType_ = planeType;
@@ -343,12 +487,15 @@ bool GPUTextureFrameBuffer::allocateMultiPlane(const FrameInfo& info, TexturePla
     // Determine number of planes
     switch (planeType) {
         case TexturePlaneType::SINGLE:
+        case TexturePlaneType::YUV_UYVY:
+        case TexturePlaneType::YUV_YUYV:
             numPlanes_ = 1;
             break;
         case TexturePlaneType::YUV_NV12:
             numPlanes_ = 2;
             break;
         case TexturePlaneType::YUV_420P:
+        case TexturePlaneType::YUV_420P10:
             numPlanes_ = 3;
             break;
         default:
@@ -359,72 +506,52 @@ bool GPUTextureFrameBuffer::allocateMultiPlane(const FrameInfo& info, TexturePla
     LOG_VERBOSE << "GPUTextureFrameBuffer: Allocating multi-plane texture (width=" << info.width 
                << ", height=" << info.height << ", planes=" << numPlanes_ << ")";
     
-    // Generate textures for all planes
-    glGenTextures(numPlanes_, textureIds_);
-    if (!checkGLError("glGenTextures(multi-plane)")) {
-        return false;
-    }
-    
     // Setup each plane
     for (int i = 0; i < numPlanes_; i++) {
-        if (textureIds_[i] == 0) {
-            LOG_ERROR << "GPUTextureFrameBuffer: glGenTextures returned 0 for plane " << i;
-            release();
-            return false;
-        }
-        
-        // Bind texture
-        glBindTexture(GL_TEXTURE_2D, textureIds_[i]);
-        if (!checkGLError("glBindTexture(multi-plane)")) {
-            release();
-            return false;
-        }
-        
-        // Set texture parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        
         // Determine plane dimensions and format
         int planeWidth = info.width;
         int planeHeight = info.height;
         GLenum internalFormat = GL_R8;
-        GLenum format = GL_RED;
         
         if (planeType == TexturePlaneType::YUV_NV12) {
-            if (i == 0) {
-                // Y plane: full resolution, R8
-                internalFormat = GL_R8;
-                format = GL_RED;
-            } else {
-                // UV plane: half resolution, RG8
+            if (i > 0) {
+                // UV plane: half resolution, RG8 (Y plane: full resolution, R8)
                 planeWidth = info.width / 2;
                 planeHeight = info.height / 2;
                 internalFormat = GL_RG8;
-                format = GL_RG;
             }
         } else if (planeType == TexturePlaneType::YUV_420P) {
-            if (i == 0) {
-                // Y plane: full resolution, R8
-                internalFormat = GL_R8;
-                format = GL_RED;
-            } else {
+            if (i > 0) {
                 // U/V planes: quarter resolution, R8
-                planeWidth = info.width / 2;
-                planeHeight = info.height / 2;
-                internalFormat = GL_R8;
-                format = GL_RED;
+                planeWidth = (info.width + 1) / 2;
+                planeHeight = (info.height + 1) / 2;
+            }
+        } else if (planeType == TexturePlaneType::YUV_420P10) {
+            // 10-bit samples in 16-bit words; the shader rescales to [0, 1]
+            if (i > 0) {
+                planeWidth = (info.width + 1) / 2;
+                planeHeight = (info.height + 1) / 2;
             }
+            internalFormat = GL_R16;
+        } else if (planeType == TexturePlaneType::YUV_UYVY || planeType == TexturePlaneType::YUV_YUYV) {
+            // Two pixels per texel; the shader filters luma itself
+            planeWidth = (info.width + 1) / 2;
+            internalFormat = GL_RGBA8;
         }
         
-        // Allocate texture storage
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, planeWidth, planeHeight, 
-                    0, format, GL_UNSIGNED_BYTE, nullptr);
-        if (!checkGLError("glTexImage2D(multi-plane)")) {
+        // Storage from the pool (allocated there when nothing can be recycled)
+        TexturePool::Key key;
+        key.width = planeWidth;
+        key.height = planeHeight;
+        key.internalFormat = internalFormat;
+        if (!acquirePlane(i, key)) {
+            LOG_ERROR << "GPUTextureFrameBuffer: No texture for plane " << i;
             release();
             return false;
         }
+        if (planeType == TexturePlaneType::YUV_YUYV) {
+            setYUYVSwizzle();
+        }
     }
     
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -435,6 +562,7 @@ bool GPUTextureFrameBuffer::allocateMultiPlane(const FrameInfo& info, TexturePla
 
 bool GPUTextureFrameBuffer::uploadMultiPlaneData(const uint8_t* yData, const uint8_t* uData, const uint8_t* vData,
                                                  int yStride, int uStride, int vStride) {
+    FRAME_TRACE_SCOPE("upload");
     if (textureIds_[0] == 0) {
         LOG_ERROR << "GPUTextureFrameBuffer: No texture allocated for multi-plane upload";
         return false;
@@ -474,58 +602,71 @@ bool GPUTextureFrameBuffer::uploadMultiPlaneData(const uint8_t* yData, const uin
         glBindTexture(GL_TEXTURE_2D, 0);
         return checkGLError("uploadMultiPlaneData(NV12)");
         
-    } else if (planeType_ == TexturePlaneType::YUV_420P) {
-        // YUV420P: 3 planes (Y, U, V)
+    } else if (planeType_ == TexturePlaneType::YUV_420P || planeType_ == TexturePlaneType::YUV_420P10) {
+        // YUV420P/YUV420P10: 3 planes (Y, U, V)
         if (!yData || !uData || !vData) {
             LOG_ERROR << "GPUTextureFrameBuffer: Invalid data pointers for YUV420P";
             return false;
         }
         
-        int uvWidth = info_.width / 2;
-        int uvHeight = info_.height / 2;
+        bool tenBit = planeType_ == TexturePlaneType::YUV_420P10;
+        int bytesPerSample = tenBit ? 2 : 1;
+        GLenum type = tenBit ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+        int uvWidth = (info_.width + 1) / 2;
+        int uvHeight = (info_.height + 1) / 2;
         
-        // Upload Y plane
-        glBindTexture(GL_TEXTURE_2D, textureIds_[0]);
-        if (yStride != info_.width) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, yStride);
-        }
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, info_.width, info_.height,
-                       GL_RED, GL_UNSIGNED_BYTE, yData);
-        if (yStride != info_.width) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        }
+        const uint8_t* planes[3] = {yData, uData, vData};
+        int strides[3] = {yStride, uStride, vStride};
+        int widths[3] = {info_.width, uvWidth, uvWidth};
+        int heights[3] = {info_.height, uvHeight, uvHeight};
         
-        // Upload U plane
-        glBindTexture(GL_TEXTURE_2D, textureIds_[1]);
-        if (uStride != uvWidth) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, uStride);
+        // Rows of tightly packed CPU frames are not 4-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int i = 0; i < 3; ++i) {
+            glBindTexture(GL_TEXTURE_2D, textureIds_[i]);
+            int rowLength = strides[i] / bytesPerSample;
+            if (rowLength != widths[i]) {
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, widths[i], heights[i],
+                           GL_RED, type, planes[i]);
+            if (rowLength != widths[i]) {
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            }
         }
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, uvWidth, uvHeight,
-                       GL_RED, GL_UNSIGNED_BYTE, uData);
-        if (uStride != uvWidth) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return checkGLError(tenBit ? "uploadMultiPlaneData(YUV420P10)" : "uploadMultiPlaneData(YUV420P)");
+        
+    } else if (planeType_ == TexturePlaneType::YUV_UYVY || planeType_ == TexturePlaneType::YUV_YUYV) {
+        // UYVY/YUYV: the packed frame as is, half the bytes of BGRA
+        if (!yData) {
+            LOG_ERROR << "GPUTextureFrameBuffer: Invalid data pointer for UYVY";
+            return false;
         }
         
-        // Upload V plane
-        glBindTexture(GL_TEXTURE_2D, textureIds_[2]);
-        if (vStride != uvWidth) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, vStride);
+        int texelWidth = (info_.width + 1) / 2;
+        glBindTexture(GL_TEXTURE_2D, textureIds_[0]);
+        if (yStride != texelWidth * 4) {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, yStride / 4);
         }
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, uvWidth, uvHeight,
-                       GL_RED, GL_UNSIGNED_BYTE, vData);
-        if (vStride != uvWidth) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texelWidth, info_.height,
+                       GL_RGBA, GL_UNSIGNED_BYTE, yData);
+        if (yStride != texelWidth * 4) {
             glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
         }
         
         glBindTexture(GL_TEXTURE_2D, 0);
-        return checkGLError("uploadMultiPlaneData(YUV420P)");
+        return checkGLError("uploadMultiPlaneData(UYVY)");
     }
     
     LOG_ERROR << "GPUTextureFrameBuffer: Invalid plane type for multi-plane upload";
     return false;
 }
 
-bool GPUTextureFrameBuffer::setExternalNV12Textures(GLuint texY, GLuint texUV, const FrameInfo& info) {
+bool GPUTextureFrameBuffer::setExternalNV12Textures(GLuint texY, GLuint texUV, const FrameInfo& info,
+                                                    bool highDepth) {
     if (texY == 0 || texUV == 0) {
         LOG_ERROR << "GPUTextureFrameBuffer: Invalid external texture IDs";
         return false;
@@ -541,12 +682,74 @@ bool GPUTextureFrameBuffer::setExternalNV12Textures(GLuint texY, GLuint texUV, c
     textureIds_[1] = texUV;
     textureIds_[2] = 0;
     numPlanes_ = 2;
-    planeType_ = TexturePlaneType::YUV_NV12;
+    planeType_ = highDepth ? TexturePlaneType::YUV_P010 : TexturePlaneType::YUV_NV12;
     textureFormat_ = GL_RG;  // NV12 UV plane format
     info_ = info;
     isHAP_ = false;
-    ownsTexture_ = false;  // Don't own these textures - VaapiInterop owns them
+    ownsTexture_ = false;  // Don't own these textures - the hardware interop owns them
+    hapVariant_ = HapVariant::NONE;
+    dmaBuf_ = DmaBufPlanes();  // Set again by the caller if it has one
+    fields_ = DeinterlacedFields();
+    
+    return true;
+}
+
+bool GPUTextureFrameBuffer::setExternalDmaBuf(const DmaBufPlanes& planes, const FrameInfo& info, bool highDepth) {
+    if (!planes.isValid()) {
+        LOG_ERROR << "GPUTextureFrameBuffer: Invalid external DMA-BUF";
+        return false;
+    }
+    
+    if (ownsTexture_) {
+        release();
+    }
+    
+    textureIds_[0] = 0;
+    textureIds_[1] = 0;
+    textureIds_[2] = 0;
+    numPlanes_ = 2;
+    planeType_ = highDepth ? TexturePlaneType::YUV_P010 : TexturePlaneType::YUV_NV12;
+    textureFormat_ = 0;
+    info_ = info;
+    isHAP_ = false;
+    ownsTexture_ = false;  // The exporter owns the fds, planes.owner the surface
+    hapVariant_ = HapVariant::NONE;
+    dmaBuf_ = planes;
+    fields_ = DeinterlacedFields();
+    
+    return true;
+}
+
+bool GPUTextureFrameBuffer::setExternalPackedTexture(GLuint texture, TexturePlaneType planeType,
+                                                     const FrameInfo& info) {
+    if (texture == 0 ||
+        (planeType != TexturePlaneType::YUV_UYVY && planeType != TexturePlaneType::YUV_YUYV)) {
+        LOG_ERROR << "GPUTextureFrameBuffer: Invalid external packed texture";
+        return false;
+    }
+    
+    if (ownsTexture_) {
+        release();
+    }
+    
+    if (planeType == TexturePlaneType::YUV_YUYV) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        setYUYVSwizzle();
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    
+    textureIds_[0] = texture;
+    textureIds_[1] = 0;
+    textureIds_[2] = 0;
+    numPlanes_ = 1;
+    planeType_ = planeType;
+    textureFormat_ = GL_RGBA;
+    info_ = info;
+    isHAP_ = false;
+    ownsTexture_ = false;  // Owned by the capture interop
     hapVariant_ = HapVariant::NONE;
+    dmaBuf_ = DmaBufPlanes();
+    fields_ = DeinterlacedFields();
     
     return true;
 }
@@ -567,30 +770,15 @@ bool GPUTextureFrameBuffer::allocateHapQAlpha(const FrameInfo& info) {
     LOG_VERBOSE << "GPUTextureFrameBuffer: Allocating HAP Q Alpha dual-texture (width=" << info.width 
                << ", height=" << info.height << ")";
     
-    // Generate textures for both planes
-    glGenTextures(2, textureIds_);
-    if (!checkGLError("glGenTextures(HAP Q Alpha)")) {
-        return false;
-    }
-    
-    // Setup first texture (YCoCg DXT5)
-    glBindTexture(GL_TEXTURE_2D, textureIds_[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    if (!checkGLError("glTexParameteri(HAP Q Alpha color)")) {
-        release();
-        return false;
-    }
-    
-    // Setup second texture (Alpha RGTC1)
-    glBindTexture(GL_TEXTURE_2D, textureIds_[1]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    if (!checkGLError("glTexParameteri(HAP Q Alpha alpha)")) {
+    // YCoCg DXT5 colour and RGTC1 alpha, both from the pool
+    TexturePool::Key color;
+    color.width = info.width;
+    color.height = info.height;
+    color.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    TexturePool::Key alpha = color;
+    alpha.internalFormat = GL_COMPRESSED_RED_RGTC1;
+    if (!acquirePlane(0, color) || !acquirePlane(1, alpha)) {
+        LOG_ERROR << "GPUTextureFrameBuffer: No HAP Q Alpha textures";
         release();
         return false;
     }
@@ -604,21 +792,52 @@ bool GPUTextureFrameBuffer::allocateHapQAlpha(const FrameInfo& info) {
 bool GPUTextureFrameBuffer::uploadHapQAlphaData(const uint8_t* colorData, size_t colorSize,
                                                 const uint8_t* alphaData, size_t alphaSize,
                                                 int width, int height) {
+    if (!colorData || !alphaData) {
+        LOG_ERROR << "GPUTextureFrameBuffer: Invalid HAP Q Alpha data";
+        return false;
+    }
+    return hapQAlphaImages(colorData, colorSize, alphaData, alphaSize, width, height);
+}
+
+bool GPUTextureFrameBuffer::uploadHapQAlphaFromBuffer(size_t colorOffset, size_t colorSize,
+                                                      size_t alphaOffset, size_t alphaSize,
+                                                      int width, int height) {
+    return hapQAlphaImages(reinterpret_cast<const void*>(colorOffset), colorSize,
+                           reinterpret_cast<const void*>(alphaOffset), alphaSize, width, height);
+}
+
+bool GPUTextureFrameBuffer::hapQAlphaImages(const void* colorPixels, size_t colorSize,
+                                            const void* alphaPixels, size_t alphaSize,
+                                            int width, int height) {
     if (textureIds_[0] == 0 || textureIds_[1] == 0) {
         LOG_ERROR << "GPUTextureFrameBuffer: No HAP Q Alpha textures allocated";
         return false;
     }
     
-    if (!colorData || !alphaData || colorSize == 0 || alphaSize == 0) {
+    if (colorSize == 0 || alphaSize == 0) {
         LOG_ERROR << "GPUTextureFrameBuffer: Invalid HAP Q Alpha data";
         return false;
     }
     
+    if (immutable_ && !matchesStorage(0, width, height, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)) {
+        FrameInfo info = info_;
+        info.width = width;
+        info.height = height;
+        if (!allocateHapQAlpha(info)) {
+            return false;
+        }
+    }
+    
     // Upload YCoCg color texture (DXT5)
     glBindTexture(GL_TEXTURE_2D, textureIds_[0]);
-    glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
-                           width, height, 0,
-                           static_cast<GLsizei>(colorSize), colorData);
+    if (immutable_) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+                                  static_cast<GLsizei>(colorSize), colorPixels);
+    } else {
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+                               width, height, 0,
+                               static_cast<GLsizei>(colorSize), colorPixels);
+    }
     if (!checkGLError("glCompressedTexImage2D(HAP Q Alpha color)")) {
         glBindTexture(GL_TEXTURE_2D, 0);
         return false;
@@ -627,9 +846,14 @@ bool GPUTextureFrameBuffer::uploadHapQAlphaData(const uint8_t* colorData, size_t
     // Upload alpha texture (RGTC1/BC4)
     glBindTexture(GL_TEXTURE_2D, textureIds_[1]);
     // GL_COMPRESSED_RED_RGTC1 = 0x8DBB (same as HapTextureFormat_A_RGTC1)
-    glCompressedTexImage2D(GL_TEXTURE_2D, 0, 0x8DBB,
-                           width, height, 0,
-                           static_cast<GLsizei>(alphaSize), alphaData);
+    if (immutable_) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_COMPRESSED_RED_RGTC1,
+                                  static_cast<GLsizei>(alphaSize), alphaPixels);
+    } else {
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RED_RGTC1,
+                               width, height, 0,
+                               static_cast<GLsizei>(alphaSize), alphaPixels);
+    }
     if (!checkGLError("glCompressedTexImage2D(HAP Q Alpha alpha)")) {
         glBindTexture(GL_TEXTURE_2D, 0);
         return false;
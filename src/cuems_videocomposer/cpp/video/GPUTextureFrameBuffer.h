@@ -2,14 +2,11 @@
 #define VIDEOCOMPOSER_GPUTEXTUREFRAMEBUFFER_H
 
 #include "FrameFormat.h"
+#include "DmaBufPlanes.h"
+#include "TexturePool.h"
 #include <cstdint>
 #include <cstddef>
 
-// Forward declaration to avoid including OpenGL headers here
-// OpenGL types will be defined when needed
-typedef unsigned int GLuint;
-typedef unsigned int GLenum;
-
 namespace videocomposer {
 
 /**
@@ -18,7 +15,11 @@ namespace videocomposer {
 enum class TexturePlaneType {
     SINGLE,         // Single-plane RGB/RGBA
     YUV_NV12,       // 2 planes: Y (R8) + UV (RG8)
+    YUV_P010,       // 2 planes: Y (R16) + UV (RG16), 10-16 bit samples in the high bits
     YUV_420P,       // 3 planes: Y (R8) + U (R8) + V (R8)
+    YUV_420P10,     // 3 planes: Y (R16) + U (R16) + V (R16), 10-bit samples
+    YUV_UYVY,       // 1 plane: packed U Y0 V Y1 (RGBA8, half width)
+    YUV_YUYV,       // 1 plane: packed Y0 U Y1 V (RGBA8, half width, swizzled to read as UYVY)
     HAP_Q_ALPHA     // 2 planes: YCoCg DXT5 + Alpha RGTC1 (HAP Q Alpha)
 };
 
@@ -31,7 +32,8 @@ enum class HapVariant {
     HAP_Q,          // HAP Q (DXT5 YCoCg)
     HAP_ALPHA,      // HAP Alpha (DXT5 RGBA)
     HAP_Q_ALPHA,    // HAP Q Alpha (DXT5 YCoCg + RGTC1 Alpha)
-    HAP_R           // HAP R (BPTC/BC7 RGBA - best quality + alpha) - UNTESTED
+    HAP_R,          // HAP R (BPTC/BC7 RGBA - best quality + alpha) - UNTESTED
+    HAP_HDR         // HAP HDR (BPTC/BC6H float RGB, linear light) - tone mapped to the output
 };
 
 /**
@@ -45,8 +47,11 @@ enum class HapVariant {
  * Key feature: Zero-copy - frames stay on GPU, no CPU→GPU transfer needed
  * 
  * Copy semantics: Copying creates a non-owning reference to the same texture.
- * Only the original owner (the instance that called allocate()) will delete
+ * Only the original owner (the instance that called allocate()) will release
  * the texture when destroyed. Copies are "views" that don't own the texture.
+ *
+ * Owned textures come from TexturePool and go back to it on release, so a
+ * layer reloading or resizing recycles storage instead of reallocating.
  */
 class GPUTextureFrameBuffer {
 public:
@@ -68,7 +73,7 @@ public:
     // Allocate GPU texture for given format and dimensions
     bool allocate(const FrameInfo& info, GLenum textureFormat, bool isHAP = false);
     
-    // Release GPU texture
+    // Release GPU texture (back to the texture pool)
     void release();
 
     // Get OpenGL texture ID (single-plane or plane 0)
@@ -98,11 +103,15 @@ public:
     // Get frame info
     const FrameInfo& info() const { return info_; }
 
-    // Check if buffer is valid
-    bool isValid() const { return textureIds_[0] != 0; }
+    // Check if buffer is valid (textures, or a DMA-BUF alone: setExternalDmaBuf)
+    bool isValid() const { return textureIds_[0] != 0 || dmaBuf_.isValid(); }
+
+    // Whether the current GL context accepts a compressed texture format
+    // (GL_COMPRESSED_TEXTURE_FORMATS; BPTC needs GL 4.2 or ARB_texture_compression_bptc)
+    static bool isCompressedFormatSupported(GLenum format);
 
     // Upload compressed texture data (for HAP)
-    // data: compressed texture data (DXT1/DXT5)
+    // data: compressed texture data (DXT1/DXT5/BPTC)
     // size: size of compressed data in bytes
     bool uploadCompressedData(const uint8_t* data, size_t size, int width, int height, GLenum format);
     
@@ -114,6 +123,13 @@ public:
                              const uint8_t* alphaData, size_t alphaSize,
                              int width, int height);
     
+    // Same uploads sourced from the bound GL_PIXEL_UNPACK_BUFFER
+    // (offsets into the buffer instead of client pointers, see HapUploadRing)
+    bool uploadCompressedFromBuffer(size_t offset, size_t size, int width, int height, GLenum format);
+    bool uploadHapQAlphaFromBuffer(size_t colorOffset, size_t colorSize,
+                                   size_t alphaOffset, size_t alphaSize,
+                                   int width, int height);
+    
     // Set HAP variant
     void setHapVariant(HapVariant variant) { hapVariant_ = variant; }
 
@@ -123,23 +139,90 @@ public:
     // Allocate multi-plane YUV texture (for zero-copy VAAPI/CUDA)
     // NV12: 2 planes (Y plane R8, UV plane RG8)
     // YUV420P: 3 planes (Y, U, V all R8)
+    // YUV420P10: 3 planes (Y, U, V all R16)
+    // UYVY/YUYV: 1 plane (RGBA8, two pixels per texel)
     bool allocateMultiPlane(const FrameInfo& info, TexturePlaneType planeType);
     
-    // Upload multi-plane YUV data
+    // Upload multi-plane YUV data (strides in bytes)
     // For NV12: yData (full res), uvData (half res)
-    // For YUV420P: yData (full res), uData (quarter res), vData (quarter res)
+    // For YUV420P/YUV420P10: yData (full res), uData (quarter res), vData (quarter res)
+    // For UYVY/YUYV: yData (packed frame), yStride in bytes
     bool uploadMultiPlaneData(const uint8_t* yData, const uint8_t* uData, const uint8_t* vData,
                              int yStride, int uStride, int vStride);
     
-    // Set external NV12 textures (for VAAPI zero-copy)
+    // Update colour metadata (matrix/range) without reallocating
+    void setColorInfo(ColorMatrix matrix, ColorRange range) {
+        info_.colorMatrix = matrix;
+        info_.colorRange = range;
+    }
+    
+    // Set external NV12 textures (for VAAPI/NVDEC zero-copy)
     // This does NOT take ownership of the textures - caller must keep them alive
-    // Used when VaapiInterop provides texture IDs directly from DMA-BUF import
-    bool setExternalNV12Textures(GLuint texY, GLuint texUV, const FrameInfo& info);
+    // Used when VaapiInterop (DMA-BUF import) or CudaInterop (CUDA-registered
+    // textures) provides the texture IDs directly
+    // highDepth: R16/RG16 textures of a P010 (or deeper) surface
+    bool setExternalNV12Textures(GLuint texY, GLuint texUV, const FrameInfo& info, bool highDepth = false);
+    
+    // Set an external packed 4:2:2 texture (RGBA8, half width) imported from
+    // a capture buffer. Not owned; a YUYV texture gets its swizzle set here.
+    bool setExternalPackedTexture(GLuint texture, TexturePlaneType planeType, const FrameInfo& info);
+    
+    // Hardware-decoded NV12 (or P010) frame as its DMA-BUF only, no GL
+    // textures: for backends that import it themselves (VulkanDisplay,
+    // DisplayBackend::importsDmaBuf). getTextureId() stays 0.
+    bool setExternalDmaBuf(const DmaBufPlanes& planes, const FrameInfo& info, bool highDepth = false);
+    
+    // DMA-BUF behind external NV12 textures (VAAPI), for plane scanout.
+    // Cleared whenever the textures change.
+    void setDmaBufPlanes(const DmaBufPlanes& planes) { dmaBuf_ = planes; }
+    const DmaBufPlanes& getDmaBufPlanes() const { return dmaBuf_; }
+    
+    // External NV12 textures VAAPI VPP deinterlaced: the textures are the
+    // frame's first field made progressive, secondY/secondUV its second
+    // field (0 = first field only). Not owned; cleared with the textures.
+    void setDeinterlacedFields(GLuint secondY, GLuint secondUV) {
+        fields_.deinterlaced = true;
+        fields_.secondY = secondY;
+        fields_.secondUV = secondUV;
+    }
+    bool isDeinterlaced() const { return fields_.deinterlaced; }
+    bool hasSecondField() const { return fields_.secondY != 0 && fields_.secondUV != 0; }
+    GLuint getSecondFieldTextureId(int plane) const { return plane == 0 ? fields_.secondY : fields_.secondUV; }
+
+    /**
+     * Memory budget account of textures allocated from now on (default:
+     * layer textures of the allocating thread's layer); kept by this
+     * instance, not copied or moved
+     */
+    void setBudgetAccount(const MemoryBudget::Account& account) { budgetAccount_ = account; }
+
+    // Pool storage of a plane (empty key for external textures)
+    const TexturePool::Key& getPlaneStorage(int plane) const;
+
+    // Bytes of the owned planes
+    size_t getTextureBytes() const;
 
 private:
-    static constexpr int MAX_PLANES = 3;  // Maximum 3 planes (YUV420P)
+    static constexpr int MAX_PLANES = 3;  // Maximum 3 planes (YUV420P/YUV420P10)
+    
+    // Sized internal format for immutable storage (GL_RGBA -> GL_RGBA8, ...)
+    static GLenum sizedFormat(GLenum format);
+    
+    // Plane texture from the pool, with default sampling parameters (left bound)
+    bool acquirePlane(int plane, const TexturePool::Key& key);
+    
+    // Plane storage has this size and format (immutable textures cannot change)
+    bool matchesStorage(int plane, int width, int height, GLenum format) const;
+    
+    // pixels: client memory, or an offset while an unpack buffer is bound
+    bool compressedImage(const void* pixels, size_t size, int width, int height, GLenum format);
+    bool hapQAlphaImages(const void* colorPixels, size_t colorSize,
+                         const void* alphaPixels, size_t alphaSize,
+                         int width, int height);
     
     GLuint textureIds_[MAX_PLANES];  // OpenGL texture IDs (one per plane)
+    TexturePool::Key planeKeys_[MAX_PLANES];  // Pool storage of owned planes
+    bool immutable_;                 // Owned planes have immutable storage (SubImage uploads)
     int numPlanes_;                  // Number of texture planes (1, 2, or 3)
     TexturePlaneType planeType_;     // Plane type (single, NV12, YUV420P)
     GLenum textureFormat_;           // OpenGL texture format
@@ -147,6 +230,14 @@ private:
     bool isHAP_;                     // True if this is a HAP texture (DXT1/DXT5)
     bool ownsTexture_;               // True if this instance owns the texture (should delete on destruction)
     HapVariant hapVariant_;          // HAP variant (if isHAP_ is true)
+    DmaBufPlanes dmaBuf_;            // Source DMA-BUF (external VAAPI textures only)
+    struct DeinterlacedFields {
+        bool deinterlaced = false;
+        GLuint secondY = 0;
+        GLuint secondUV = 0;
+    };
+    DeinterlacedFields fields_;      // VPP fields (external VAAPI textures only)
+    MemoryBudget::Account budgetAccount_;
 };
 
 } // namespace videocomposer
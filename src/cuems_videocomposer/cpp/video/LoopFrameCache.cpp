@@ -0,0 +1,216 @@
+#include "LoopFrameCache.h"
+#include "../utils/Logger.h"
+
+namespace videocomposer {
+
+LoopFrameCache::LoopFrameCache(int layerId)
+    : layerId_(layerId)
+    , mode_(Mode::OFF)
+    , source_(nullptr)
+    , start_(0)
+    , end_(0)
+    , bytes_(0)
+    , lastStored_(-1)
+    , passes_(0)
+    , abandoned_(false)
+    , hits_(0)
+    , evictorId_(0)
+{
+}
+
+LoopFrameCache::~LoopFrameCache() {
+    if (evictorId_ != 0) {
+        MemoryBudget::instance().removeEvictor(evictorId_);
+    }
+}
+
+const char* LoopFrameCache::modeName(Mode mode) {
+    switch (mode) {
+        case Mode::OFF: return "off";
+        case Mode::UNCOMPRESSED: return "on";
+        case Mode::COMPRESSED: return "compressed";
+    }
+    return "off";
+}
+
+bool LoopFrameCache::parseMode(const std::string& name, Mode& mode) {
+    if (name == "off") {
+        mode = Mode::OFF;
+    } else if (name == "on") {
+        mode = Mode::UNCOMPRESSED;
+    } else if (name == "compressed") {
+        mode = Mode::COMPRESSED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void LoopFrameCache::setMode(Mode mode) {
+    FrameMap dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode == mode_) {
+        return;
+    }
+    mode_ = mode;
+    clearLocked(dropped);
+    abandoned_ = false;
+}
+
+LoopFrameCache::Mode LoopFrameCache::getMode() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_;
+}
+
+void LoopFrameCache::setLoop(const void* source, int64_t start, int64_t end) {
+    if (end <= start) {
+        source = nullptr;
+        start = 0;
+        end = 0;
+    }
+    FrameMap dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (source == source_ && start == start_ && end == end_) {
+        return;
+    }
+    source_ = source;
+    start_ = start;
+    end_ = end;
+    clearLocked(dropped);
+    abandoned_ = false;
+    if (end_ - start_ > MAX_FRAMES) {
+        abandoned_ = true;
+        LOG_INFO << "Loop cache: layer " << layerId_ << " loop of " << end_ - start_
+                 << " frames is longer than " << MAX_FRAMES << ", decoding every pass";
+    }
+}
+
+int64_t LoopFrameCache::getLoopLength() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return end_ - start_;
+}
+
+bool LoopFrameCache::wants(int64_t frame) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_ != Mode::OFF && !abandoned_ && frame >= start_ && frame < end_ &&
+           frames_.find(frame) == frames_.end();
+}
+
+bool LoopFrameCache::store(int64_t frame, std::shared_ptr<const GPUTextureFrameBuffer> texture, size_t bytes) {
+    FrameMap dropped;
+    bool registerEvictor = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!texture || mode_ == Mode::OFF || abandoned_ || frame < start_ || frame >= end_ ||
+            frames_.find(frame) != frames_.end()) {
+            return false;
+        }
+        // Back at the start of the loop without the frames that were skipped
+        if (frame < lastStored_ && ++passes_ >= MAX_PASSES) {
+            LOG_INFO << "Loop cache: layer " << layerId_ << " has " << frames_.size() << " of "
+                     << end_ - start_ << " frames after " << passes_ << " passes, decoding every pass";
+            clearLocked(dropped);
+            abandoned_ = true;
+            return false;
+        }
+        lastStored_ = frame;
+        frames_[frame] = std::move(texture);
+        bytes_ += bytes;
+        if (static_cast<int64_t>(frames_.size()) == end_ - start_) {
+            LOG_INFO << "Loop cache: layer " << layerId_ << " plays its " << frames_.size() << " frame loop from "
+                     << bytes_ / (1024 * 1024) << " MB of VRAM (" << modeName(mode_) << ")";
+        }
+        if (evictorId_ == 0) {
+            renderThread_ = std::this_thread::get_id();
+            registerEvictor = true;
+        }
+    }
+    // Registered outside the lock: the budget calls evict() under its own
+    if (registerEvictor) {
+        int id = MemoryBudget::instance().addEvictor(
+            MemoryBudget::Tier::LOOP_CACHE, MemoryBudget::Pool::VRAM,
+            [this](size_t requested) { return evict(requested); });
+        std::lock_guard<std::mutex> lock(mutex_);
+        evictorId_ = id;
+    }
+    return true;
+}
+
+bool LoopFrameCache::isComplete() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_ != Mode::OFF && !abandoned_ && end_ > start_ &&
+           static_cast<int64_t>(frames_.size()) == end_ - start_;
+}
+
+bool LoopFrameCache::has(int64_t frame) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mode_ != Mode::OFF && !abandoned_ && static_cast<int64_t>(frames_.size()) == end_ - start_ &&
+           frames_.find(frame) != frames_.end();
+}
+
+std::shared_ptr<const GPUTextureFrameBuffer> LoopFrameCache::find(int64_t frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode_ == Mode::OFF || abandoned_ || static_cast<int64_t>(frames_.size()) != end_ - start_) {
+        return nullptr;
+    }
+    auto it = frames_.find(frame);
+    if (it == frames_.end()) {
+        return nullptr;
+    }
+    hits_++;
+    return it->second;
+}
+
+void LoopFrameCache::abandon(const char* reason) {
+    FrameMap dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (abandoned_ || mode_ == Mode::OFF) {
+        return;
+    }
+    LOG_INFO << "Loop cache: layer " << layerId_ << " not cached (" << (reason ? reason : "given up")
+             << "), decoding every pass";
+    clearLocked(dropped);
+    abandoned_ = true;
+}
+
+size_t LoopFrameCache::evict(size_t bytes) {
+    (void)bytes;   // All or nothing
+    FrameMap dropped;
+    size_t freed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Textures are released with GL fences: only on the render thread
+        if (std::this_thread::get_id() != renderThread_ || frames_.empty()) {
+            return 0;
+        }
+        freed = bytes_;
+        LOG_INFO << "Loop cache: layer " << layerId_ << " gives its " << freed / (1024 * 1024)
+                 << " MB of VRAM back, decoding every pass";
+        clearLocked(dropped);
+        abandoned_ = true;
+    }
+    dropped.clear();
+    return freed;
+}
+
+LoopFrameCache::Stats LoopFrameCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.mode = mode_;
+    stats.frames = static_cast<int64_t>(frames_.size());
+    stats.loopFrames = end_ - start_;
+    stats.bytes = bytes_;
+    stats.complete = mode_ != Mode::OFF && !abandoned_ && end_ > start_ && stats.frames == stats.loopFrames;
+    stats.abandoned = abandoned_;
+    stats.hits = hits_;
+    return stats;
+}
+
+void LoopFrameCache::clearLocked(FrameMap& dropped) {
+    dropped.swap(frames_);
+    bytes_ = 0;
+    lastStored_ = -1;
+    passes_ = 0;
+}
+
+} // namespace videocomposer
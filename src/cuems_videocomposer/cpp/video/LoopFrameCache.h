@@ -0,0 +1,128 @@
+#ifndef VIDEOCOMPOSER_LOOPFRAMECACHE_H
+#define VIDEOCOMPOSER_LOOPFRAMECACHE_H
+
+#include "GPUTextureFrameBuffer.h"
+#include "MemoryBudget.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace videocomposer {
+
+/**
+ * LoopFrameCache - A layer's short loop kept decoded in VRAM
+ *
+ * A clip looping for the whole show is decoded again on every pass. The
+ * renderer copies each frame of the loop's first pass (as it was prepared:
+ * hardware decoded planes, HAP blocks, uploads; optionally BC1 compressed)
+ * into textures of its own; once every frame of the loop is in, the layer
+ * plays from here and its decoder is left idle.
+ *
+ * The textures are charged to LOOP_TEXTURES and the cache gives way to
+ * anything more important in VRAM: the budget evictor drops it whole (a
+ * partial loop would still need the decoder). A loop too long, or not
+ * complete after MAX_PASSES passes (frames skipped by the sync source),
+ * is given up. Frames are handed out as shared pointers, so one on screen
+ * outlives an eviction. Textures are created and released on the render
+ * thread; find() and the rest are safe from any thread.
+ */
+class LoopFrameCache {
+public:
+    static constexpr int64_t MAX_FRAMES = 600;   // 10 s at 60 fps
+    static constexpr int MAX_PASSES = 2;
+
+    enum class Mode {
+        OFF,
+        UNCOMPRESSED,   // Frames as prepared
+        COMPRESSED      // RGBA frames BC1 compressed (no alpha)
+    };
+
+    struct Stats {
+        Mode mode = Mode::OFF;
+        int64_t frames = 0;       // Cached
+        int64_t loopFrames = 0;   // In the loop
+        size_t bytes = 0;
+        bool complete = false;
+        bool abandoned = false;
+        uint64_t hits = 0;        // Frames played from the cache
+    };
+
+    explicit LoopFrameCache(int layerId = MemoryBudget::NO_LAYER);
+    ~LoopFrameCache();
+
+    LoopFrameCache(const LoopFrameCache&) = delete;
+    LoopFrameCache& operator=(const LoopFrameCache&) = delete;
+
+    static const char* modeName(Mode mode);
+
+    /** "off", "on" or "compressed" */
+    static bool parseMode(const std::string& name, Mode& mode);
+
+    void setMode(Mode mode);
+    Mode getMode() const;
+
+    /**
+     * Frames [start, end) of a source make one pass. Another source or range
+     * drops the cache and lets it fill again; an empty range (no loop) just
+     * drops it.
+     */
+    void setLoop(const void* source, int64_t start, int64_t end);
+
+    int64_t getLoopLength() const;
+
+    /** Filling and this frame of the loop not in yet */
+    bool wants(int64_t frame) const;
+
+    /**
+     * Add a frame copied by the renderer (its textures charged to
+     * LOOP_TEXTURES of the layer)
+     * @return false if not wanted (the texture is dropped)
+     */
+    bool store(int64_t frame, std::shared_ptr<const GPUTextureFrameBuffer> texture, size_t bytes);
+
+    /** Every frame of the loop is in */
+    bool isComplete() const;
+
+    /** A complete cache has this frame */
+    bool has(int64_t frame) const;
+
+    /** A frame of a complete cache (nullptr otherwise) */
+    std::shared_ptr<const GPUTextureFrameBuffer> find(int64_t frame);
+
+    /** Drop the frames and stop filling until the loop changes */
+    void abandon(const char* reason);
+
+    /** Budget evictor: gives up the cache (render thread only, 0 elsewhere) */
+    size_t evict(size_t bytes);
+
+    Stats getStats() const;
+
+private:
+    using FrameMap = std::map<int64_t, std::shared_ptr<const GPUTextureFrameBuffer>>;
+
+    // Frames are released by the caller, outside the lock
+    void clearLocked(FrameMap& dropped);
+
+    int layerId_;
+    mutable std::mutex mutex_;
+    Mode mode_;
+    const void* source_;
+    int64_t start_;
+    int64_t end_;
+    FrameMap frames_;
+    size_t bytes_;
+    int64_t lastStored_;
+    int passes_;            // Wraps seen while filling
+    bool abandoned_;
+    uint64_t hits_;
+    int evictorId_;
+    std::thread::id renderThread_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_LOOPFRAMECACHE_H
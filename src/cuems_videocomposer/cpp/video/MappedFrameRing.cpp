@@ -0,0 +1,134 @@
+#include "MappedFrameRing.h"
+
+namespace videocomposer {
+
+std::shared_ptr<MappedFrameRing> MappedFrameRing::create() {
+    // Constructor is private, so make_shared cannot be used
+    return std::shared_ptr<MappedFrameRing>(new MappedFrameRing());
+}
+
+MappedFrameRing::MappedFrameRing()
+    : attached_(false)
+    , nextGeneration_(0)
+{
+    for (int i = 0; i < SLOTS; ++i) {
+        slots_[i] = std::make_unique<Slot>();
+        slots_[i]->index = i;
+        held_[i] = false;
+        gpuBusy_[i] = false;
+    }
+}
+
+MappedFrameRing::Handle MappedFrameRing::acquire(const FrameInfo& info) {
+    Slot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Decoders always write packed 4-byte pixels, so geometry is enough
+        if (!attached_ || info.width != info_.width || info.height != info_.height) {
+            return nullptr;
+        }
+        for (int i = 0; i < SLOTS; ++i) {
+            if (!held_[i] && !gpuBusy_[i]) {
+                slot = slots_[i].get();
+                held_[i] = true;
+                slot->generation = ++nextGeneration_;
+                break;
+            }
+        }
+        if (!slot) {
+            stats_.unavailable++;
+            return nullptr;
+        }
+        stats_.acquired++;
+    }
+
+    // The deleter holds a strong reference so the ring outlives its handles
+    std::shared_ptr<MappedFrameRing> self = shared_from_this();
+    return Handle(slot, [self](Slot* s) { self->release(s); });
+}
+
+void MappedFrameRing::release(Slot* slot) {
+    if (!slot) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    held_[slot->index] = false;
+}
+
+bool MappedFrameRing::isAttached() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return attached_;
+}
+
+bool MappedFrameRing::attach(uint8_t* const memory[SLOTS], size_t slotSize, const FrameInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < SLOTS; ++i) {
+        if (held_[i] || !memory[i]) {
+            return false;
+        }
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        slots_[i]->buffer.wrap(memory[i], slotSize, info);
+        gpuBusy_[i] = false;
+    }
+    info_ = info;
+    attached_ = true;
+    return true;
+}
+
+bool MappedFrameRing::detach(bool force) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!attached_) {
+        return true;
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        if (!held_[i]) {
+            slots_[i]->buffer.release();
+            continue;
+        }
+        if (!force) {
+            return false;
+        }
+        // Still displayed: keep the pixels, in memory the buffer owns
+        FrameBuffer copy(slots_[i]->buffer);
+        slots_[i]->buffer.swap(copy);
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        gpuBusy_[i] = false;
+    }
+    attached_ = false;
+    return true;
+}
+
+int MappedFrameRing::indexOf(const FrameBuffer* buffer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!attached_ || !buffer) {
+        return -1;
+    }
+    for (int i = 0; i < SLOTS; ++i) {
+        // A slot reallocated by its producer no longer points into the mapping
+        if (&slots_[i]->buffer == buffer && !buffer->ownsData()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint64_t MappedFrameRing::generation(int index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (index >= 0 && index < SLOTS) ? slots_[index]->generation : 0;
+}
+
+void MappedFrameRing::setGpuBusy(int index, bool busy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= 0 && index < SLOTS) {
+        gpuBusy_[index] = busy;
+    }
+}
+
+MappedFrameRing::Stats MappedFrameRing::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,110 @@
+#ifndef VIDEOCOMPOSER_MAPPEDFRAMERING_H
+#define VIDEOCOMPOSER_MAPPEDFRAMERING_H
+
+#include "FrameBuffer.h"
+#include "FrameFormat.h"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace videocomposer {
+
+/**
+ * MappedFrameRing - Decode targets backed by renderer-owned mapped memory
+ *
+ * The renderer attaches persistently mapped PBOs to a layer's ring; the
+ * layer then decodes (sws_scale) straight into a free slot, and the renderer
+ * streams that slot into the layer texture without touching the pixels on
+ * the CPU. This turns decode -> FrameBuffer -> PBO -> texture into
+ * decode -> PBO -> texture.
+ *
+ * Ownership:
+ * - acquire() hands out a Handle; the layer keeps it as its current frame
+ *   for as long as the frame is displayed
+ * - The renderer marks a slot GPU-busy while a transfer from it is in
+ *   flight; busy slots are never handed out
+ * - A slot is free again when its handle is dropped and the GPU is done
+ *
+ * Producers only write while LayerManager::updateAll() runs, which never
+ * overlaps rendering. This is what allows detach(force) to copy displayed
+ * slots out of the mapping before the renderer unmaps it.
+ *
+ * The ring itself is GL-free; OpenGLRenderer owns the buffer objects.
+ */
+class MappedFrameRing : public std::enable_shared_from_this<MappedFrameRing> {
+public:
+    static constexpr int SLOTS = 3;  // Displayed + in transfer + decoding
+
+    struct Slot {
+        FrameBuffer buffer;        // Wraps mapped memory while attached
+        int index = -1;
+        uint64_t generation = 0;   // Bumped on every acquire
+    };
+
+    using Handle = std::shared_ptr<Slot>;
+
+    struct Stats {
+        uint64_t acquired = 0;     // Frames decoded into mapped memory
+        uint64_t unavailable = 0;  // acquire() calls that found no usable slot
+    };
+
+    static std::shared_ptr<MappedFrameRing> create();
+
+    MappedFrameRing(const MappedFrameRing&) = delete;
+    MappedFrameRing& operator=(const MappedFrameRing&) = delete;
+
+    // ===== Producer (layer update) =====
+
+    /**
+     * Take a free slot for a frame of the given geometry
+     * @return Handle, or nullptr if detached, the geometry differs or all
+     *         slots are in use (caller decodes into its own buffer)
+     */
+    Handle acquire(const FrameInfo& info);
+
+    // ===== Renderer (render thread) =====
+
+    bool isAttached() const;
+
+    /**
+     * Attach mapped memory, one block of slotSize bytes per slot
+     * @return false if a slot is still held (retry later)
+     */
+    bool attach(uint8_t* const memory[SLOTS], size_t slotSize, const FrameInfo& info);
+
+    /**
+     * Stop handing out mapped slots before the memory goes away
+     * @param force Copy held slots into owned memory instead of failing
+     * @return false if slots are held and force is false
+     */
+    bool detach(bool force);
+
+    /**
+     * Slot index of a buffer (-1 unless it is a slot of this attached ring)
+     */
+    int indexOf(const FrameBuffer* buffer) const;
+    uint64_t generation(int index) const;
+    void setGpuBusy(int index, bool busy);
+
+    Stats getStats() const;
+
+private:
+    MappedFrameRing();
+
+    void release(Slot* slot);
+
+    std::unique_ptr<Slot> slots_[SLOTS];
+    bool held_[SLOTS];
+    bool gpuBusy_[SLOTS];
+    FrameInfo info_;
+    bool attached_;
+    uint64_t nextGeneration_;
+    Stats stats_;
+
+    mutable std::mutex mutex_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_MAPPEDFRAMERING_H
@@ -0,0 +1,309 @@
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace videocomposer {
+
+namespace {
+
+thread_local int currentLayerId = MemoryBudget::NO_LAYER;
+
+std::string megabytes(uint64_t bytes) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MB";
+    return out.str();
+}
+
+} // namespace
+
+MemoryBudget::LayerScope::LayerScope(int layerId)
+    : previous_(currentLayerId)
+{
+    currentLayerId = layerId;
+}
+
+MemoryBudget::LayerScope::~LayerScope() {
+    currentLayerId = previous_;
+}
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+MemoryBudget::MemoryBudget()
+    : subsystems_()
+    , nextEvictorId_(1)
+{
+}
+
+MemoryBudget::Pool MemoryBudget::poolOf(Subsystem subsystem) {
+    switch (subsystem) {
+        case Subsystem::FRAME_POOLS:
+        case Subsystem::RAM_CLIPS:
+        case Subsystem::CUE_PREFETCH:
+        case Subsystem::LOOP_PREFETCH:
+            return Pool::RAM;
+        default:
+            return Pool::VRAM;
+    }
+}
+
+MemoryBudget::Tier MemoryBudget::tierOf(Subsystem subsystem) {
+    switch (subsystem) {
+        case Subsystem::TEXTURE_POOL: return Tier::RECYCLED;
+        case Subsystem::CUE_PREFETCH: return Tier::PREFETCH;
+        case Subsystem::LOOP_PREFETCH:
+        case Subsystem::LOOP_TEXTURES: return Tier::LOOP_CACHE;
+        case Subsystem::ARMED_UPLOADS: return Tier::WARMUP;
+        default: return Tier::ESSENTIAL;
+    }
+}
+
+const char* MemoryBudget::subsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+        case Subsystem::LAYER_TEXTURES: return "layer textures";
+        case Subsystem::ARMED_UPLOADS: return "armed uploads";
+        case Subsystem::UPLOAD_BUFFERS: return "upload buffers";
+        case Subsystem::DECODE_SURFACES: return "decode surfaces";
+        case Subsystem::CANVAS: return "canvas";
+        case Subsystem::GROUP_IMAGES: return "group images";
+        case Subsystem::EFFECT_TARGETS: return "effect targets";
+        case Subsystem::LOOP_TEXTURES: return "loop textures";
+        case Subsystem::TEXTURE_POOL: return "texture pool";
+        case Subsystem::FRAME_POOLS: return "frame pools";
+        case Subsystem::RAM_CLIPS: return "ram clips";
+        case Subsystem::CUE_PREFETCH: return "cue prefetch";
+        case Subsystem::LOOP_PREFETCH: return "loop prefetch";
+    }
+    return "unknown";
+}
+
+const char* MemoryBudget::poolName(Pool pool) {
+    return pool == Pool::VRAM ? "vram" : "ram";
+}
+
+int MemoryBudget::currentLayer() {
+    return currentLayerId;
+}
+
+MemoryBudget::Account MemoryBudget::resolve(const Account& account) {
+    Account resolved = account;
+    if (resolved.layerId == CURRENT_LAYER) {
+        resolved.layerId = currentLayerId;
+    }
+    return resolved;
+}
+
+void MemoryBudget::setLimit(Pool pool, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_[index(pool)].limit = bytes;
+}
+
+size_t MemoryBudget::getLimit(Pool pool) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pools_[index(pool)].limit;
+}
+
+size_t MemoryBudget::getUsed(Pool pool) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pools_[index(pool)].used;
+}
+
+bool MemoryBudget::fitsLocked(Pool pool, size_t bytes) const {
+    return excessLocked(pool, bytes) == 0;
+}
+
+size_t MemoryBudget::excessLocked(Pool pool, size_t bytes) const {
+    const PoolUsage& usage = pools_[index(pool)];
+    if (usage.limit == 0 || usage.used + bytes <= usage.limit) {
+        return 0;
+    }
+    return usage.used + bytes - usage.limit;
+}
+
+void MemoryBudget::chargeLocked(const Account& account, size_t bytes) {
+    size_t pool = index(poolOf(account.subsystem));
+    PoolUsage& usage = pools_[pool];
+    usage.used += bytes;
+    usage.peak = std::max(usage.peak, usage.used);
+    subsystems_[index(account.subsystem)] += bytes;
+    LayerUsage& layer = layers_[account.layerId];
+    layer.layerId = account.layerId;
+    layer.bytes[pool] += bytes;
+}
+
+bool MemoryBudget::reserve(const Account& account, size_t bytes) {
+    Account resolved = resolve(account);
+    Pool pool = poolOf(resolved.subsystem);
+    Tier own = tierOf(resolved.subsystem);
+    size_t excess;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fitsLocked(pool, bytes)) {
+            chargeLocked(resolved, bytes);
+            return true;
+        }
+        excess = excessLocked(pool, bytes);
+    }
+
+    for (int tier = 0; tier < static_cast<int>(own); ++tier) {
+        evictTier(pool, static_cast<Tier>(tier), excess);
+        if (tier > static_cast<int>(Tier::RECYCLED)) {
+            // Evicted caches mostly hand their storage back to the pool
+            evictTier(pool, Tier::RECYCLED, excess);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fitsLocked(pool, bytes)) {
+            chargeLocked(resolved, bytes);
+            return true;
+        }
+        excess = excessLocked(pool, bytes);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_[index(pool)].refusals++;
+    return false;
+}
+
+void MemoryBudget::charge(const Account& account, size_t bytes) {
+    Account resolved = resolve(account);
+    std::lock_guard<std::mutex> lock(mutex_);
+    chargeLocked(resolved, bytes);
+}
+
+void MemoryBudget::release(const Account& account, size_t bytes) {
+    Account resolved = resolve(account);
+    size_t pool = index(poolOf(resolved.subsystem));
+    std::lock_guard<std::mutex> lock(mutex_);
+    PoolUsage& usage = pools_[pool];
+    usage.used -= std::min(usage.used, bytes);
+    size_t& subsystem = subsystems_[index(resolved.subsystem)];
+    subsystem -= std::min(subsystem, bytes);
+    auto it = layers_.find(resolved.layerId);
+    if (it != layers_.end()) {
+        it->second.bytes[pool] -= std::min(it->second.bytes[pool], bytes);
+        if (it->second.bytes[0] == 0 && it->second.bytes[1] == 0) {
+            layers_.erase(it);
+        }
+    }
+}
+
+int MemoryBudget::addEvictor(Tier tier, Pool pool, Evictor evictor) {
+    auto entry = std::make_shared<EvictorEntry>();
+    entry->tier = tier;
+    entry->pool = pool;
+    entry->evictor = std::move(evictor);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry->id = nextEvictorId_++;
+    evictors_.push_back(entry);
+    return entry->id;
+}
+
+void MemoryBudget::removeEvictor(int id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = std::find_if(evictors_.begin(), evictors_.end(),
+                           [id](const std::shared_ptr<EvictorEntry>& entry) { return entry->id == id; });
+    if (it == evictors_.end()) {
+        return;
+    }
+    std::shared_ptr<EvictorEntry> entry = *it;
+    entry->removed = true;
+    evictors_.erase(it);
+    idle_.wait(lock, [&entry] { return entry->calls == 0; });
+}
+
+size_t MemoryBudget::evictTier(Pool pool, Tier tier, size_t bytes) {
+    std::vector<std::shared_ptr<EvictorEntry>> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const std::shared_ptr<EvictorEntry>& entry : evictors_) {
+            if (entry->tier == tier && entry->pool == pool && !entry->removed) {
+                entry->calls++;
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    size_t freed = 0;
+    for (const std::shared_ptr<EvictorEntry>& entry : entries) {
+        size_t entryFreed = 0;
+        if (freed < bytes) {
+            entryFreed = entry->evictor(bytes - freed);
+            freed += entryFreed;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entryFreed > 0) {
+            pools_[index(pool)].evictedBytes += entryFreed;
+            pools_[index(pool)].evictions++;
+        }
+        entry->calls--;
+        idle_.notify_all();
+    }
+    return freed;
+}
+
+size_t MemoryBudget::enforce() {
+    size_t freed = 0;
+    for (Pool pool : {Pool::VRAM, Pool::RAM}) {
+        size_t excess;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            excess = excessLocked(pool, 0);
+        }
+        for (int tier = 0; excess > 0 && tier < static_cast<int>(Tier::ESSENTIAL); ++tier) {
+            freed += evictTier(pool, static_cast<Tier>(tier), excess);
+            if (tier > static_cast<int>(Tier::RECYCLED)) {
+                freed += evictTier(pool, Tier::RECYCLED, excess);
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            excess = excessLocked(pool, 0);
+        }
+    }
+    return freed;
+}
+
+MemoryBudget::Report MemoryBudget::getReport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Report report;
+    for (size_t i = 0; i < POOLS; ++i) {
+        report.pools[i] = pools_[i];
+    }
+    std::copy(subsystems_, subsystems_ + SUBSYSTEMS, report.subsystems);
+    for (const auto& entry : layers_) {
+        report.layers.push_back(entry.second);
+    }
+    return report;
+}
+
+std::vector<std::string> MemoryBudget::formatReport() const {
+    Report report = getReport();
+    std::vector<std::string> lines;
+    for (Pool pool : {Pool::VRAM, Pool::RAM}) {
+        const PoolUsage& usage = report.pools[index(pool)];
+        std::ostringstream line;
+        line << (pool == Pool::VRAM ? "VRAM: " : "RAM: ") << megabytes(usage.used) << " (peak "
+             << megabytes(usage.peak) << "), limit " << (usage.limit > 0 ? megabytes(usage.limit) : "none")
+             << ", evicted " << megabytes(usage.evictedBytes) << " in " << usage.evictions << " step(s), "
+             << usage.refusals << " refused";
+        lines.push_back(line.str());
+        for (size_t i = 0; i < SUBSYSTEMS; ++i) {
+            Subsystem subsystem = static_cast<Subsystem>(i);
+            if (poolOf(subsystem) == pool && report.subsystems[i] > 0) {
+                lines.push_back(std::string("  ") + subsystemName(subsystem) + ": " +
+                                megabytes(report.subsystems[i]));
+            }
+        }
+    }
+    for (const LayerUsage& layer : report.layers) {
+        std::ostringstream line;
+        line << (layer.layerId == NO_LAYER ? std::string("Shared") : "Layer " + std::to_string(layer.layerId))
+             << ": " << megabytes(layer.bytes[index(Pool::VRAM)]) << " VRAM, "
+             << megabytes(layer.bytes[index(Pool::RAM)]) << " RAM";
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,206 @@
+#ifndef VIDEOCOMPOSER_MEMORYBUDGET_H
+#define VIDEOCOMPOSER_MEMORYBUDGET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * MemoryBudget - Accounting of GPU and large CPU allocations under limits
+ *
+ * Subsystems charge what they allocate, per layer where the allocation
+ * belongs to one: callers name the layer, or leave it to the LayerScope the
+ * allocating thread runs in (VideoLayer opens one while it updates).
+ *
+ * Allocations with a fallback reserve() first. Over the pool's limit,
+ * caches are evicted tier by tier (recycled textures, cue prefetch, loop
+ * prefetch, armed-layer uploads) until the allocation fits; a cache only
+ * evicts tiers before its own, so it never pushes out a more valuable one.
+ * What still does not fit is refused and the caller takes its fallback
+ * (play from storage, skip the prime, no texture) instead of failing in the
+ * driver. Allocations without one are charged, and enforce() (once a frame)
+ * evicts for them when they took a pool over its limit.
+ *
+ * Evictors run on the reserving thread, without the budget's lock held, and
+ * release what they freed through it. VRAM evictors delete GL objects, so
+ * VRAM is reserved from threads current on the render share group (render
+ * and upload threads) and only charged elsewhere. Thread-safe.
+ */
+class MemoryBudget {
+public:
+    enum class Pool {
+        VRAM,
+        RAM
+    };
+    static constexpr size_t POOLS = 2;
+
+    enum class Subsystem {
+        LAYER_TEXTURES,   // VRAM: layer and decoded frame textures
+        ARMED_UPLOADS,    // VRAM: start frames uploaded for armed (hidden) layers
+        UPLOAD_BUFFERS,   // VRAM: pixel unpack buffers
+        DECODE_SURFACES,  // VRAM: hardware decoder and video processing surfaces
+        CANVAS,           // VRAM: virtual canvas
+        GROUP_IMAGES,     // VRAM: layer group images
+        EFFECT_TARGETS,   // VRAM: layer effect intermediates (see EffectTargetPool)
+        LOOP_TEXTURES,    // VRAM: short loops kept decoded (see LoopFrameCache)
+        TEXTURE_POOL,     // VRAM: released textures and buffers kept for reuse
+        FRAME_POOLS,      // RAM: decoded frame pools
+        RAM_CLIPS,        // RAM: preloaded clips
+        CUE_PREFETCH,     // RAM: decoders parked on cue frames
+        LOOP_PREFETCH     // RAM: decoders parked on loop targets
+    };
+    static constexpr size_t SUBSYSTEMS = 13;
+
+    // Caches in eviction order; ESSENTIAL allocations may evict all of them
+    enum class Tier {
+        RECYCLED,
+        PREFETCH,
+        LOOP_CACHE,
+        WARMUP,
+        ESSENTIAL
+    };
+
+    static constexpr int NO_LAYER = -1;       // Shared by all layers
+    static constexpr int CURRENT_LAYER = -2;  // The calling thread's LayerScope
+
+    /** Who an allocation is charged to */
+    struct Account {
+        Subsystem subsystem = Subsystem::LAYER_TEXTURES;
+        int layerId = CURRENT_LAYER;
+
+        Account() = default;
+        explicit Account(Subsystem s, int layer = CURRENT_LAYER) : subsystem(s), layerId(layer) {}
+    };
+
+    /**
+     * Frees cached memory
+     * @param bytes About this much is wanted (more or less may be freed)
+     * @return Bytes freed (already released through the budget)
+     */
+    using Evictor = std::function<size_t(size_t bytes)>;
+
+    struct PoolUsage {
+        size_t used = 0;
+        size_t peak = 0;
+        size_t limit = 0;          // 0 = none
+        uint64_t evictedBytes = 0;
+        uint64_t evictions = 0;    // Evictor calls that freed memory
+        uint64_t refusals = 0;     // Reservations that did not fit
+    };
+
+    struct LayerUsage {
+        int layerId = NO_LAYER;
+        size_t bytes[POOLS] = {0, 0};
+    };
+
+    struct Report {
+        PoolUsage pools[POOLS];
+        size_t subsystems[SUBSYSTEMS] = {};
+        std::vector<LayerUsage> layers;  // By layer id, NO_LAYER first
+    };
+
+    /**
+     * Charges allocations of this thread with CURRENT_LAYER to a layer
+     * while it exists (nests)
+     */
+    class LayerScope {
+    public:
+        explicit LayerScope(int layerId);
+        ~LayerScope();
+
+        LayerScope(const LayerScope&) = delete;
+        LayerScope& operator=(const LayerScope&) = delete;
+
+    private:
+        int previous_;
+    };
+
+    static MemoryBudget& instance();
+
+    MemoryBudget();
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    static Pool poolOf(Subsystem subsystem);
+    static Tier tierOf(Subsystem subsystem);
+    static const char* subsystemName(Subsystem subsystem);
+    static const char* poolName(Pool pool);
+
+    /** Layer of the calling thread's LayerScope (NO_LAYER outside one) */
+    static int currentLayer();
+
+    /** The account with CURRENT_LAYER replaced (store this to release later) */
+    static Account resolve(const Account& account);
+
+    /** @param bytes 0 = no limit */
+    void setLimit(Pool pool, size_t bytes);
+    size_t getLimit(Pool pool) const;
+    size_t getUsed(Pool pool) const;
+
+    /**
+     * Charge an allocation if it fits, evicting caches of earlier tiers
+     * @return false if it does not fit (nothing charged)
+     */
+    bool reserve(const Account& account, size_t bytes);
+
+    /** Charge an allocation that is made anyway */
+    void charge(const Account& account, size_t bytes);
+
+    void release(const Account& account, size_t bytes);
+
+    /**
+     * @return Id for removeEvictor()
+     */
+    int addEvictor(Tier tier, Pool pool, Evictor evictor);
+
+    /** Returns once the evictor is no longer running */
+    void removeEvictor(int id);
+
+    /**
+     * Evict caches of every tier of pools over their limit
+     * @return Bytes freed
+     */
+    size_t enforce();
+
+    Report getReport() const;
+    std::vector<std::string> formatReport() const;
+
+private:
+    struct EvictorEntry {
+        int id = 0;
+        Tier tier = Tier::RECYCLED;
+        Pool pool = Pool::VRAM;
+        Evictor evictor;
+        int calls = 0;         // Running outside the lock
+        bool removed = false;
+    };
+
+    static size_t index(Pool pool) { return static_cast<size_t>(pool); }
+    static size_t index(Subsystem subsystem) { return static_cast<size_t>(subsystem); }
+
+    bool fitsLocked(Pool pool, size_t bytes) const;
+    void chargeLocked(const Account& account, size_t bytes);
+    size_t excessLocked(Pool pool, size_t bytes) const;
+    size_t evictTier(Pool pool, Tier tier, size_t bytes);
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;   // An evictor call returned
+    PoolUsage pools_[POOLS];
+    size_t subsystems_[SUBSYSTEMS];
+    std::map<int, LayerUsage> layers_;
+    std::vector<std::shared_ptr<EvictorEntry>> evictors_;
+    int nextEvictorId_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_MEMORYBUDGET_H
@@ -0,0 +1,61 @@
+#include "PackedAlpha.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+bool PackedAlpha::parseLayout(const std::string& name, Layout& layout) {
+    if (name == "none") {
+        layout = Layout::NONE;
+    } else if (name == "stacked" || name == "top_bottom") {
+        layout = Layout::STACKED;
+    } else if (name == "side_by_side") {
+        layout = Layout::SIDE_BY_SIDE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* PackedAlpha::layoutName(Layout layout) {
+    switch (layout) {
+        case Layout::STACKED: return "stacked";
+        case Layout::SIDE_BY_SIDE: return "side_by_side";
+        default: return "none";
+    }
+}
+
+void PackedAlpha::regions(Layout layout, int width, int height, float insetTexels,
+                          Rect& color, Rect& alpha) {
+    color = Rect();
+    alpha = Rect();
+    if (layout == Layout::NONE || width <= 0 || height <= 0) {
+        return;
+    }
+    float insetX = insetTexels / static_cast<float>(width);
+    float insetY = insetTexels / static_cast<float>(height);
+    bool stacked = layout == Layout::STACKED;
+    float halfX = stacked ? 1.0f : 0.5f;
+    float halfY = stacked ? 0.5f : 1.0f;
+
+    // Each half loses the inset on both sides (never more than the half itself)
+    color.scaleX = std::max(halfX - 2.0f * insetX, 0.0f);
+    color.scaleY = std::max(halfY - 2.0f * insetY, 0.0f);
+    color.offsetX = insetX;
+    color.offsetY = insetY;
+    alpha = color;
+    if (stacked) {
+        alpha.offsetY += 0.5f;
+    } else {
+        alpha.offsetX += 0.5f;
+    }
+}
+
+float PackedAlpha::pictureAspect(Layout layout, float frameAspect) {
+    switch (layout) {
+        case Layout::STACKED: return frameAspect * 2.0f;
+        case Layout::SIDE_BY_SIDE: return frameAspect * 0.5f;
+        default: return frameAspect;
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,54 @@
+#ifndef VIDEOCOMPOSER_PACKEDALPHA_H
+#define VIDEOCOMPOSER_PACKEDALPHA_H
+
+#include <string>
+
+namespace videocomposer {
+
+/**
+ * PackedAlpha - Colour and alpha pictures packed into one opaque frame
+ *
+ * H.264/HEVC carry no alpha plane, but a frame twice the picture's height
+ * (colour over alpha) or width (colour left, alpha right) does, and still
+ * decodes on the VAAPI zero-copy path. The layer shaders sample both
+ * halves (alpha from the luma of its half) and recombine them; the layer
+ * is laid out with the aspect of one picture, not of the whole frame.
+ */
+class PackedAlpha {
+public:
+    enum class Layout {
+        NONE,          // Opaque frame as it is
+        STACKED,       // Colour in the top half, alpha in the bottom half
+        SIDE_BY_SIDE   // Colour in the left half, alpha in the right half
+    };
+
+    /** Region of the frame in texture coordinates: uv' = offset + uv * scale */
+    struct Rect {
+        float offsetX = 0.0f;
+        float offsetY = 0.0f;
+        float scaleX = 1.0f;
+        float scaleY = 1.0f;
+    };
+
+    /** "none", "stacked" (or "top_bottom"), "side_by_side"; false if unknown */
+    static bool parseLayout(const std::string& name, Layout& layout);
+
+    static const char* layoutName(Layout layout);
+
+    /**
+     * Colour and alpha regions of a packed frame
+     * Each is inset by insetTexels from the seam and the frame edges so
+     * filtering never blends the two pictures (one texel covers 4:2:0 chroma)
+     * @param width Frame width in texels (both pictures)
+     * @param height Frame height in texels
+     */
+    static void regions(Layout layout, int width, int height, float insetTexels,
+                        Rect& color, Rect& alpha);
+
+    /** Aspect ratio of one picture from that of the whole frame */
+    static float pictureAspect(Layout layout, float frameAspect);
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PACKEDALPHA_H
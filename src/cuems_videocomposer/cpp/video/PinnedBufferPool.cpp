@@ -0,0 +1,111 @@
+#include "PinnedBufferPool.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace videocomposer {
+
+PinnedBufferPool::PinnedBufferPool(size_t maxFree)
+    : maxFree_(maxFree)
+{
+}
+
+PinnedBufferPool::~PinnedBufferPool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Buffer& buffer : free_) {
+        freeBuffer(buffer);
+    }
+    // Whoever still holds one must not outlive the pool
+    for (const Buffer& buffer : outstanding_) {
+        freeBuffer(buffer);
+    }
+}
+
+void PinnedBufferPool::freeBuffer(const Buffer& buffer) {
+    if (buffer.locked) {
+        munlock(buffer.data, buffer.size);
+    }
+    free(buffer.data);
+}
+
+void* PinnedBufferPool::acquire(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Capture frames have one size: the first free one that is big enough
+    auto it = std::find_if(free_.begin(), free_.end(), [size](const Buffer& buffer) { return buffer.size >= size; });
+    if (it != free_.end()) {
+        Buffer buffer = *it;
+        free_.erase(it);
+        outstanding_.push_back(buffer);
+        return buffer.data;
+    }
+
+    Buffer buffer;
+    buffer.size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (buffer.size == 0 || posix_memalign(&buffer.data, ALIGNMENT, buffer.size) != 0) {
+        return nullptr;
+    }
+    buffer.locked = mlock(buffer.data, buffer.size) == 0;
+    if (!buffer.locked) {
+        allLocked_ = false;
+        if (!warned_) {
+            LOG_WARNING << "Capture buffers: Could not lock frames in memory (" << strerror(errno)
+                        << ", raise RLIMIT_MEMLOCK); uploads may be staged";
+            warned_ = true;
+        }
+    }
+    ++allocations_;
+    outstanding_.push_back(buffer);
+    return buffer.data;
+}
+
+void PinnedBufferPool::release(void* data) {
+    if (!data) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(outstanding_.begin(), outstanding_.end(),
+                           [data](const Buffer& buffer) { return buffer.data == data; });
+    if (it == outstanding_.end()) {
+        return;
+    }
+    Buffer buffer = *it;
+    outstanding_.erase(it);
+    if (free_.size() >= maxFree_) {
+        freeBuffer(buffer);
+        return;
+    }
+    free_.push_back(buffer);
+}
+
+void PinnedBufferPool::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Buffer& buffer : free_) {
+        freeBuffer(buffer);
+    }
+    free_.clear();
+}
+
+size_t PinnedBufferPool::getOutstandingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return outstanding_.size();
+}
+
+size_t PinnedBufferPool::getFreeCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
+uint64_t PinnedBufferPool::getAllocationCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocations_;
+}
+
+bool PinnedBufferPool::isLocked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allLocked_;
+}
+
+} // namespace videocomposer
@@ -0,0 +1,73 @@
+#ifndef VIDEOCOMPOSER_PINNEDBUFFERPOOL_H
+#define VIDEOCOMPOSER_PINNEDBUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * PinnedBufferPool - Recycled, page-aligned, locked frame buffers
+ *
+ * For capture hardware that DMAs frames into memory it is given (DeckLink
+ * input): every buffer is page aligned and locked in RAM, so the card
+ * writes into it directly and the texture upload reads it without the
+ * driver staging it first. Buffers are kept for reuse rather than freed,
+ * as a capture allocates one per frame at the frame rate.
+ *
+ * Thread-safe: the card's thread acquires, whichever thread drops the
+ * last reference to a frame releases.
+ */
+class PinnedBufferPool {
+public:
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr size_t DEFAULT_MAX_FREE = 8;
+
+    explicit PinnedBufferPool(size_t maxFree = DEFAULT_MAX_FREE);
+    ~PinnedBufferPool();
+
+    PinnedBufferPool(const PinnedBufferPool&) = delete;
+    PinnedBufferPool& operator=(const PinnedBufferPool&) = delete;
+
+    /**
+     * A buffer of at least size bytes (a free one of that size, else a new one)
+     * @return nullptr if out of memory
+     */
+    void* acquire(size_t size);
+
+    /** Give a buffer from acquire() back */
+    void release(void* buffer);
+
+    /** Free the buffers not in use */
+    void trim();
+
+    size_t getOutstandingCount() const;
+    size_t getFreeCount() const;
+    uint64_t getAllocationCount() const;
+
+    /** Whether every buffer so far could be locked (RLIMIT_MEMLOCK) */
+    bool isLocked() const;
+
+private:
+    struct Buffer {
+        void* data = nullptr;
+        size_t size = 0;
+        bool locked = false;
+    };
+
+    static void freeBuffer(const Buffer& buffer);
+
+    mutable std::mutex mutex_;
+    size_t maxFree_;
+    std::vector<Buffer> free_;
+    std::vector<Buffer> outstanding_;
+    uint64_t allocations_ = 0;
+    bool allLocked_ = true;
+    bool warned_ = false;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_PINNEDBUFFERPOOL_H
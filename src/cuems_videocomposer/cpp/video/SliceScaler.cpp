@@ -0,0 +1,166 @@
+#include "SliceScaler.h"
+#include "../display/CPUImageKernels.h"
+#include <algorithm>
+#include <functional>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace videocomposer {
+
+namespace {
+
+bool isSliceable(const AVPixFmtDescriptor* desc) {
+    return desc && !(desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM |
+                                    AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BAYER));
+}
+
+// Chroma planes of vertically subsampled YUV have fewer rows
+int planeRowShift(const AVPixFmtDescriptor* desc, int plane) {
+    if (desc->flags & AV_PIX_FMT_FLAG_RGB) {
+        return 0;
+    }
+    for (int c = 1; c < 3 && c < desc->nb_components; ++c) {
+        if (desc->comp[c].plane == plane && desc->comp[0].plane != plane) {
+            return desc->log2_chroma_h;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+SliceScaler::~SliceScaler() {
+    reset();
+}
+
+void SliceScaler::reset() {
+    for (SwsContext* context : contexts_) {
+        sws_freeContext(context);
+    }
+    contexts_.clear();
+    slices_.clear();
+    sliceOk_.clear();
+    srcWidth_ = 0;
+    srcHeight_ = 0;
+    dstWidth_ = 0;
+    dstHeight_ = 0;
+    srcFormat_ = AV_PIX_FMT_NONE;
+    dstFormat_ = AV_PIX_FMT_NONE;
+    flags_ = 0;
+}
+
+void SliceScaler::planSlices(int height, int alignment, int maxSlices, int minRows,
+                             std::vector<Slice>& slices) {
+    slices.clear();
+    if (height <= 0) {
+        return;
+    }
+    alignment = std::max(alignment, 1);
+    int count = std::max(1, std::min(maxSlices, height / std::max(minRows, 1)));
+    int rows = (height + count - 1) / count;
+    rows = (rows + alignment - 1) / alignment * alignment;
+    for (int first = 0; first < height; first += rows) {
+        Slice slice;
+        slice.first = first;
+        slice.rows = std::min(rows, height - first);
+        slices.push_back(slice);
+    }
+}
+
+bool SliceScaler::scale(const uint8_t* const src[], const int srcStride[], int srcWidth, int srcHeight,
+                        AVPixelFormat srcFormat, uint8_t* const dst[], const int dstStride[],
+                        int dstWidth, int dstHeight, AVPixelFormat dstFormat, int flags) {
+    if (!src || !srcStride || !dst || !dstStride || srcWidth <= 0 || srcHeight <= 0 ||
+        dstWidth <= 0 || dstHeight <= 0) {
+        return false;
+    }
+
+    if (!isReady() || srcWidth != srcWidth_ || srcHeight != srcHeight_ || srcFormat != srcFormat_ ||
+        dstWidth != dstWidth_ || dstHeight != dstHeight_ || dstFormat != dstFormat_ || flags != flags_) {
+        const AVPixFmtDescriptor* srcDesc = av_pix_fmt_desc_get(srcFormat);
+        const AVPixFmtDescriptor* dstDesc = av_pix_fmt_desc_get(dstFormat);
+        if (!srcDesc || !dstDesc) {
+            reset();
+            return false;
+        }
+        bool sliced = srcHeight == dstHeight && isSliceable(srcDesc) && isSliceable(dstDesc) &&
+                      static_cast<int64_t>(std::max(srcWidth, dstWidth)) * srcHeight >= MIN_PARALLEL_PIXELS;
+        int alignment = 1 << std::max(srcDesc->log2_chroma_h, dstDesc->log2_chroma_h);
+        int maxSlices = sliced ? static_cast<int>(CPUImageKernels::getConcurrency()) : 1;
+        planSlices(srcHeight, alignment, maxSlices, MIN_SLICE_ROWS, slices_);
+
+        srcPlanes_ = std::min(std::max(av_pix_fmt_count_planes(srcFormat), 1), 4);
+        dstPlanes_ = std::min(std::max(av_pix_fmt_count_planes(dstFormat), 1), 4);
+        for (int p = 0; p < 4; ++p) {
+            srcShift_[p] = sliced ? planeRowShift(srcDesc, p) : 0;
+            dstShift_[p] = sliced ? planeRowShift(dstDesc, p) : 0;
+        }
+
+        // Contexts of slices no longer there go; the others are adapted
+        while (contexts_.size() > slices_.size()) {
+            sws_freeContext(contexts_.back());
+            contexts_.pop_back();
+        }
+        contexts_.resize(slices_.size(), nullptr);
+        sliceOk_.assign(slices_.size(), 0);
+        for (size_t i = 0; i < slices_.size(); ++i) {
+            int srcRows = sliced ? slices_[i].rows : srcHeight;
+            int dstRows = sliced ? slices_[i].rows : dstHeight;
+            contexts_[i] = sws_getCachedContext(contexts_[i], srcWidth, srcRows, srcFormat,
+                                                dstWidth, dstRows, dstFormat, flags,
+                                                nullptr, nullptr, nullptr);
+            if (!contexts_[i]) {
+                reset();
+                return false;
+            }
+        }
+        srcWidth_ = srcWidth;
+        srcHeight_ = srcHeight;
+        dstWidth_ = dstWidth;
+        dstHeight_ = dstHeight;
+        srcFormat_ = srcFormat;
+        dstFormat_ = dstFormat;
+        flags_ = flags;
+    }
+
+    const int count = static_cast<int>(slices_.size());
+    if (count == 1) {
+        return scaleSlice(0, src, srcStride, dst, dstStride);
+    }
+    auto band = [&](int first, int end) {
+        for (int i = first; i < end; ++i) {
+            sliceOk_[i] = scaleSlice(static_cast<size_t>(i), src, srcStride, dst, dstStride) ? 1 : 0;
+        }
+    };
+    if (!CPUImageKernels::runBands(count, 1, std::ref(band))) {
+        band(0, count);
+    }
+    return std::all_of(sliceOk_.begin(), sliceOk_.end(), [](uint8_t ok) { return ok != 0; });
+}
+
+bool SliceScaler::scaleSlice(size_t index, const uint8_t* const src[], const int srcStride[],
+                             uint8_t* const dst[], const int dstStride[]) {
+    const Slice& slice = slices_[index];
+    const uint8_t* srcSlice[4] = {nullptr, nullptr, nullptr, nullptr};
+    int srcSliceStride[4] = {0, 0, 0, 0};
+    uint8_t* dstSlice[4] = {nullptr, nullptr, nullptr, nullptr};
+    int dstSliceStride[4] = {0, 0, 0, 0};
+    for (int p = 0; p < srcPlanes_; ++p) {
+        srcSliceStride[p] = srcStride[p];
+        if (src[p]) {
+            srcSlice[p] = src[p] + static_cast<ptrdiff_t>(slice.first >> srcShift_[p]) * srcStride[p];
+        }
+    }
+    for (int p = 0; p < dstPlanes_; ++p) {
+        dstSliceStride[p] = dstStride[p];
+        if (dst[p]) {
+            dstSlice[p] = dst[p] + static_cast<ptrdiff_t>(slice.first >> dstShift_[p]) * dstStride[p];
+        }
+    }
+    return sws_scale(contexts_[index], srcSlice, srcSliceStride, 0, slice.rows, dstSlice, dstSliceStride) > 0;
+}
+
+} // namespace videocomposer
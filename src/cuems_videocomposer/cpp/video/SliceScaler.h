@@ -0,0 +1,98 @@
+#ifndef VIDEOCOMPOSER_SLICESCALER_H
+#define VIDEOCOMPOSER_SLICESCALER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+struct SwsContext;
+
+namespace videocomposer {
+
+/**
+ * SliceScaler - sws_scale() split into horizontal slices across threads
+ *
+ * The CPU conversions that remain (odd pixel formats, the software
+ * fallback, sinks without GPU conversion) run through here instead of one
+ * SwsContext on the calling thread. Each slice has a context of its own,
+ * created for the slice's size and kept while formats and sizes stay the
+ * same, so the slices convert concurrently on the CPUImageKernels worker
+ * pool. Slice boundaries fall on chroma rows of both formats.
+ *
+ * Only conversions keeping the height are sliced (a vertical filter would
+ * need rows across the boundary); those, small frames and paletted or
+ * bitstream formats use one context on the calling thread. While another
+ * caller has the pool, the slices run one after the other here.
+ *
+ * One caller at a time per instance, as with an SwsContext.
+ */
+class SliceScaler {
+public:
+    struct Slice {
+        int first = 0;
+        int rows = 0;
+    };
+
+    static constexpr int MIN_SLICE_ROWS = 64;
+    static constexpr int64_t MIN_PARALLEL_PIXELS = 512 * 512;
+
+    SliceScaler() = default;
+    ~SliceScaler();
+
+    SliceScaler(const SliceScaler&) = delete;
+    SliceScaler& operator=(const SliceScaler&) = delete;
+
+    /**
+     * Convert a whole frame, as sws_scale() from row 0 to srcHeight
+     * @param flags SWS_* scaling flags
+     * @return false if swscale has no such conversion
+     */
+    bool scale(const uint8_t* const src[], const int srcStride[], int srcWidth, int srcHeight,
+               AVPixelFormat srcFormat, uint8_t* const dst[], const int dstStride[],
+               int dstWidth, int dstHeight, AVPixelFormat dstFormat, int flags);
+
+    /** A conversion has been set up (a frame can be converted again) */
+    bool isReady() const { return !contexts_.empty() && contexts_[0] != nullptr; }
+
+    /** Slices of the last scale() (1 when not sliced) */
+    int getSliceCount() const { return static_cast<int>(slices_.size()); }
+
+    /** Free the contexts */
+    void reset();
+
+    /**
+     * Split rows [0, height) into at most maxSlices (and height / minRows)
+     * slices of about equal rows, every boundary on a multiple of alignment
+     */
+    static void planSlices(int height, int alignment, int maxSlices, int minRows,
+                           std::vector<Slice>& slices);
+
+private:
+    bool scaleSlice(size_t index, const uint8_t* const src[], const int srcStride[],
+                    uint8_t* const dst[], const int dstStride[]);
+
+    std::vector<SwsContext*> contexts_;   // One per slice
+    std::vector<Slice> slices_;
+    std::vector<uint8_t> sliceOk_;        // Written by the slices' threads
+
+    // Conversion the contexts were made for
+    int srcWidth_ = 0;
+    int srcHeight_ = 0;
+    int dstWidth_ = 0;
+    int dstHeight_ = 0;
+    AVPixelFormat srcFormat_ = AV_PIX_FMT_NONE;
+    AVPixelFormat dstFormat_ = AV_PIX_FMT_NONE;
+    int flags_ = 0;
+    int srcPlanes_ = 0;
+    int dstPlanes_ = 0;
+    int srcShift_[4] = {0, 0, 0, 0};      // Row shift of each plane (chroma subsampling)
+    int dstShift_[4] = {0, 0, 0, 0};
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_SLICESCALER_H
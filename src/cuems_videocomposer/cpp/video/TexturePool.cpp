@@ -0,0 +1,443 @@
+#include "TexturePool.h"
+#include "../utils/Logger.h"
+#include <GL/glew.h>  // Must be included before GL/gl.h
+#include <GL/gl.h>
+#include <algorithm>
+
+namespace videocomposer {
+
+namespace {
+
+bool isCompressedFormat(GLenum format) {
+    switch (format) {
+        case 0x83F0:  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+        case 0x83F3:  // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        case 0x8DBB:  // GL_COMPRESSED_RED_RGTC1
+        case 0x8E8C:  // GL_COMPRESSED_RGBA_BPTC_UNORM
+        case 0x8E8E:  // GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+        case 0x8E8F:  // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Client format and type for glTexImage2D when there is no glTexStorage2D
+void uncompressedUpload(GLenum internalFormat, GLenum& format, GLenum& type) {
+    type = GL_UNSIGNED_BYTE;
+    switch (internalFormat) {
+        case GL_R8:
+            format = GL_RED;
+            break;
+        case GL_R16:
+            format = GL_RED;
+            type = GL_UNSIGNED_SHORT;
+            break;
+        case GL_RG8:
+            format = GL_RG;
+            break;
+        case GL_RG32UI:
+            format = GL_RG_INTEGER;
+            type = GL_UNSIGNED_INT;
+            break;
+        default:
+            format = GL_BGRA;
+            break;
+    }
+}
+
+bool glImmutableStorage() {
+    return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+}
+
+GLuint glCreateTexture(const TexturePool::Key& key) {
+    while (glGetError() != GL_NO_ERROR) {}
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    if (texture == 0) {
+        return 0;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (glImmutableStorage()) {
+        glTexStorage2D(GL_TEXTURE_2D, key.levels, key.internalFormat, key.width, key.height);
+    } else if (!isCompressedFormat(key.internalFormat)) {
+        GLenum format, type;
+        uncompressedUpload(key.internalFormat, format, type);
+        int width = key.width;
+        int height = key.height;
+        for (int level = 0; level < key.levels; ++level) {
+            glTexImage2D(GL_TEXTURE_2D, level, key.internalFormat, width, height, 0, format, type, nullptr);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, key.levels - 1);
+    }
+    // Mutable compressed textures get their storage from the first upload
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (glGetError() != GL_NO_ERROR) {
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+    return texture;
+}
+
+GLuint glCreateBuffer(size_t size) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    if (buffer == 0) {
+        return 0;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return buffer;
+}
+
+TexturePool::Backend glBackend() {
+    TexturePool::Backend backend;
+    backend.createTexture = glCreateTexture;
+    backend.deleteTexture = [](GLuint texture) { glDeleteTextures(1, &texture); };
+    backend.createBuffer = glCreateBuffer;
+    backend.deleteBuffer = [](GLuint buffer) { glDeleteBuffers(1, &buffer); };
+    backend.fence = []() -> void* { return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); };
+    backend.signalled = [](void* fence) {
+        GLenum status = glClientWaitSync(static_cast<GLsync>(fence), 0, 0);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED;
+    };
+    backend.deleteFence = [](void* fence) { glDeleteSync(static_cast<GLsync>(fence)); };
+    backend.immutableStorage = glImmutableStorage;
+    return backend;
+}
+
+} // namespace
+
+TexturePool& TexturePool::instance() {
+    MemoryBudget& budget = MemoryBudget::instance();  // Constructed first, so it outlives the pool
+    static TexturePool pool(glBackend(), &budget);
+    return pool;
+}
+
+TexturePool::TexturePool(const Backend& backend, MemoryBudget* budget)
+    : backend_(backend)
+    , freeBytes_(0)
+    , limit_(DEFAULT_LIMIT_BYTES)
+    , serial_(0)
+    , budget_(budget)
+    , evictorId_(0)
+{
+    if (budget_) {
+        evictorId_ = budget_->addEvictor(MemoryBudget::Tier::RECYCLED, MemoryBudget::Pool::VRAM,
+                                         [this](size_t bytes) { return evict(bytes); });
+    }
+}
+
+TexturePool::~TexturePool() {
+    // No GL here: the context may already be gone at exit (see clear())
+    if (budget_) {
+        budget_->removeEvictor(evictorId_);
+    }
+}
+
+int TexturePool::fullMipLevels(int width, int height) {
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+size_t TexturePool::textureBytes(const Key& key) {
+    size_t width = static_cast<size_t>(std::max(key.width, 0));
+    size_t height = static_cast<size_t>(std::max(key.height, 0));
+    size_t level0;
+    switch (key.internalFormat) {
+        case 0x83F0:  // DXT1 and RGTC1: 8 bytes per 4x4 block
+        case 0x8DBB:
+            level0 = ((width + 3) / 4) * ((height + 3) / 4) * 8;
+            break;
+        case 0x83F3:  // DXT5 and BPTC: 16 bytes per 4x4 block
+        case 0x8E8C:
+        case 0x8E8E:
+        case 0x8E8F:
+            level0 = ((width + 3) / 4) * ((height + 3) / 4) * 16;
+            break;
+        case GL_R8:
+            level0 = width * height;
+            break;
+        case GL_R16:
+        case GL_RG8:
+            level0 = width * height * 2;
+            break;
+        case GL_RG32UI:
+            level0 = width * height * 8;
+            break;
+        default:
+            level0 = width * height * 4;
+            break;
+    }
+    // A full mipmap chain adds a third
+    return key.levels > 1 ? level0 + level0 / 3 : level0;
+}
+
+bool TexturePool::readyLocked(FreeObject& object) {
+    if (object.fence && !backend_.signalled(object.fence)) {
+        return false;
+    }
+    if (object.fence) {
+        backend_.deleteFence(object.fence);
+        object.fence = nullptr;
+    }
+    return true;
+}
+
+void TexturePool::takeLocked(std::unordered_map<GLuint, LiveObject>& live, GLuint name,
+                             const MemoryBudget::Account& account, size_t size, bool recycled) {
+    LiveObject& object = live[name];
+    object.account = account;
+    object.size = size;
+    if (budget_ && recycled) {
+        budget_->release(MemoryBudget::Account(MemoryBudget::Subsystem::TEXTURE_POOL, MemoryBudget::NO_LAYER), size);
+        budget_->charge(account, size);
+    }
+}
+
+size_t TexturePool::giveBackLocked(std::unordered_map<GLuint, LiveObject>& live, GLuint name, size_t size) {
+    auto it = live.find(name);
+    if (it != live.end()) {
+        size = it->second.size;
+        if (budget_) {
+            budget_->release(it->second.account, size);
+        }
+        live.erase(it);
+    }
+    if (budget_) {
+        budget_->charge(MemoryBudget::Account(MemoryBudget::Subsystem::TEXTURE_POOL, MemoryBudget::NO_LAYER), size);
+    }
+    return size;
+}
+
+GLuint TexturePool::acquireTexture(const Key& key, const MemoryBudget::Account& account) {
+    if (key.width <= 0 || key.height <= 0 || key.levels <= 0) {
+        return 0;
+    }
+    MemoryBudget::Account owner = MemoryBudget::resolve(account);
+    size_t size = textureBytes(key);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = textures_.begin(); it != textures_.end(); ++it) {
+            if (it->key == key && readyLocked(*it)) {
+                GLuint texture = it->name;
+                freeBytes_ -= it->size;
+                textures_.erase(it);
+                stats_.textureHits++;
+                takeLocked(liveTextures_, texture, owner, size, true);
+                return texture;
+            }
+        }
+        stats_.textureMisses++;
+    }
+    // Reserved outside the lock: the budget may evict this pool's free objects
+    if (budget_ && !budget_->reserve(owner, size)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stats_.refused++ % 100 == 0) {
+            LOG_WARNING << "TexturePool: Memory budget refuses a " << key.width << "x" << key.height << " "
+                        << MemoryBudget::subsystemName(owner.subsystem) << " texture ("
+                        << budget_->getUsed(MemoryBudget::Pool::VRAM) / (1024 * 1024) << " of "
+                        << budget_->getLimit(MemoryBudget::Pool::VRAM) / (1024 * 1024) << " MB VRAM in use)";
+        }
+        return 0;
+    }
+    GLuint texture = backend_.createTexture(key);
+    if (texture == 0) {
+        LOG_WARNING << "TexturePool: Could not create a " << key.width << "x" << key.height
+                    << " texture (format 0x" << std::hex << key.internalFormat << std::dec << ")";
+        if (budget_) {
+            budget_->release(owner, size);
+        }
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    takeLocked(liveTextures_, texture, owner, size, false);
+    return texture;
+}
+
+void TexturePool::reassignTexture(GLuint texture, const MemoryBudget::Account& account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = liveTextures_.find(texture);
+    if (it == liveTextures_.end()) {
+        return;
+    }
+    MemoryBudget::Account owner = MemoryBudget::resolve(account);
+    if (budget_) {
+        budget_->release(it->second.account, it->second.size);
+        budget_->charge(owner, it->second.size);
+    }
+    it->second.account = owner;
+}
+
+void TexturePool::releaseTexture(GLuint texture, const Key& key) {
+    if (texture == 0) {
+        return;
+    }
+    FreeObject object;
+    object.name = texture;
+    object.key = key;
+    object.fence = backend_.fence();
+    std::lock_guard<std::mutex> lock(mutex_);
+    object.size = giveBackLocked(liveTextures_, texture, textureBytes(key));
+    object.serial = serial_++;
+    freeBytes_ += object.size;
+    textures_.push_back(object);
+}
+
+GLuint TexturePool::acquireBuffer(size_t size, const MemoryBudget::Account& account) {
+    if (size == 0) {
+        return 0;
+    }
+    MemoryBudget::Account owner = MemoryBudget::resolve(account);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Smallest free buffer that fits, so big ones stay for big frames
+        auto best = buffers_.end();
+        for (auto it = buffers_.begin(); it != buffers_.end(); ++it) {
+            if (it->size >= size && (best == buffers_.end() || it->size < best->size) && readyLocked(*it)) {
+                best = it;
+            }
+        }
+        if (best != buffers_.end()) {
+            GLuint buffer = best->name;
+            size_t bufferSize = best->size;
+            freeBytes_ -= bufferSize;
+            buffers_.erase(best);
+            stats_.bufferHits++;
+            takeLocked(liveBuffers_, buffer, owner, bufferSize, true);
+            return buffer;
+        }
+        stats_.bufferMisses++;
+    }
+    if (budget_ && !budget_->reserve(owner, size)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stats_.refused++ % 100 == 0) {
+            LOG_WARNING << "TexturePool: Memory budget refuses a " << size / 1024 << " KB buffer";
+        }
+        return 0;
+    }
+    GLuint buffer = backend_.createBuffer(size);
+    if (buffer == 0) {
+        if (budget_) {
+            budget_->release(owner, size);
+        }
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    takeLocked(liveBuffers_, buffer, owner, size, false);
+    return buffer;
+}
+
+void TexturePool::releaseBuffer(GLuint buffer, size_t size) {
+    if (buffer == 0) {
+        return;
+    }
+    FreeObject object;
+    object.name = buffer;
+    object.fence = backend_.fence();
+    std::lock_guard<std::mutex> lock(mutex_);
+    object.size = giveBackLocked(liveBuffers_, buffer, size);
+    object.serial = serial_++;
+    freeBytes_ += object.size;
+    buffers_.push_back(object);
+}
+
+bool TexturePool::hasImmutableStorage() const {
+    return backend_.immutableStorage && backend_.immutableStorage();
+}
+
+void TexturePool::deleteLocked(FreeObject& object, bool texture) {
+    if (object.fence) {
+        backend_.deleteFence(object.fence);
+        object.fence = nullptr;
+    }
+    if (texture) {
+        backend_.deleteTexture(object.name);
+    } else {
+        backend_.deleteBuffer(object.name);
+    }
+    freeBytes_ -= object.size;
+    if (budget_) {
+        budget_->release(MemoryBudget::Account(MemoryBudget::Subsystem::TEXTURE_POOL, MemoryBudget::NO_LAYER),
+                         object.size);
+    }
+}
+
+void TexturePool::trimLocked() {
+    while (freeBytes_ > limit_ && (!textures_.empty() || !buffers_.empty())) {
+        // Oldest release of either kind goes first
+        bool texture = buffers_.empty() ||
+                       (!textures_.empty() && textures_.front().serial < buffers_.front().serial);
+        std::vector<FreeObject>& list = texture ? textures_ : buffers_;
+        deleteLocked(list.front(), texture);
+        list.erase(list.begin());
+        stats_.trimmed++;
+    }
+}
+
+size_t TexturePool::evict(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t freed = 0;
+    while (freed < bytes && (!textures_.empty() || !buffers_.empty())) {
+        bool texture = buffers_.empty() ||
+                       (!textures_.empty() && textures_.front().serial < buffers_.front().serial);
+        std::vector<FreeObject>& list = texture ? textures_ : buffers_;
+        freed += list.front().size;
+        deleteLocked(list.front(), texture);
+        list.erase(list.begin());
+        stats_.trimmed++;
+    }
+    return freed;
+}
+
+void TexturePool::collect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (FreeObject& object : textures_) {
+        readyLocked(object);
+    }
+    for (FreeObject& object : buffers_) {
+        readyLocked(object);
+    }
+    trimLocked();
+}
+
+void TexturePool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (FreeObject& object : textures_) {
+        deleteLocked(object, true);
+    }
+    for (FreeObject& object : buffers_) {
+        deleteLocked(object, false);
+    }
+    textures_.clear();
+    buffers_.clear();
+    freeBytes_ = 0;
+}
+
+void TexturePool::setLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limit_ = bytes;
+    trimLocked();
+}
+
+size_t TexturePool::getLimit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+}
+
+TexturePool::Stats TexturePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.freeTextures = textures_.size();
+    stats.freeBuffers = buffers_.size();
+    stats.freeBytes = freeBytes_;
+    return stats;
+}
+
+} // namespace videocomposer
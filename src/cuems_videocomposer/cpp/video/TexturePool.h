@@ -0,0 +1,189 @@
+#ifndef VIDEOCOMPOSER_TEXTUREPOOL_H
+#define VIDEOCOMPOSER_TEXTUREPOOL_H
+
+#include "MemoryBudget.h"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaration to avoid including OpenGL headers here
+typedef unsigned int GLuint;
+typedef unsigned int GLenum;
+
+namespace videocomposer {
+
+/**
+ * TexturePool - Recycles layer textures and upload PBOs across the renderer
+ *
+ * Layers loading, resizing or changing format hand their textures back
+ * here instead of deleting them, and the next layer asking for the same
+ * size and format gets one back without a driver allocation. Textures use
+ * immutable storage (glTexStorage2D) where the GL has it, so a texture is
+ * never respecified: uploads go through glTex(Compressed)SubImage2D.
+ *
+ * A released texture or buffer may still be read by queued draws. It gets
+ * a fence and is only handed out again once the fence has signalled, so
+ * reuse never waits on implicit synchronisation. Free objects above the
+ * byte limit are deleted oldest first in collect().
+ *
+ * With a MemoryBudget, objects in use are charged to the account they were
+ * acquired for and free ones to TEXTURE_POOL; new storage is reserved first
+ * (refused: no object), and free objects are the budget's first VRAM tier.
+ *
+ * Objects belong to the render context's share group; the pool is used
+ * from the threads current on it and is thread-safe.
+ */
+class TexturePool {
+public:
+    /**
+     * Storage of one texture (one plane of a multi-plane frame)
+     */
+    struct Key {
+        int width = 0;
+        int height = 0;
+        GLenum internalFormat = 0;  // Sized or compressed format (GL_RGBA8, GL_R8, DXT5, ...)
+        int levels = 1;             // Mipmap levels
+
+        bool operator==(const Key& other) const {
+            return width == other.width && height == other.height &&
+                   internalFormat == other.internalFormat && levels == other.levels;
+        }
+    };
+
+    /**
+     * GL calls behind the pool (replaced in tests)
+     */
+    struct Backend {
+        std::function<GLuint(const Key& key)> createTexture;   // 0 on failure
+        std::function<void(GLuint texture)> deleteTexture;
+        std::function<GLuint(size_t size)> createBuffer;       // Pixel unpack buffer
+        std::function<void(GLuint buffer)> deleteBuffer;
+        std::function<void*()> fence;                          // GLsync, nullptr = none
+        std::function<bool(void* fence)> signalled;            // Non-blocking poll
+        std::function<void(void* fence)> deleteFence;
+        std::function<bool()> immutableStorage;                // glTexStorage2D available
+    };
+
+    struct Stats {
+        uint64_t textureHits = 0;     // Requests served from the pool
+        uint64_t textureMisses = 0;   // Requests that allocated
+        uint64_t bufferHits = 0;
+        uint64_t bufferMisses = 0;
+        uint64_t trimmed = 0;         // Free objects deleted over the limit or evicted
+        uint64_t refused = 0;         // Allocations the memory budget refused
+        size_t freeTextures = 0;
+        size_t freeBuffers = 0;
+        size_t freeBytes = 0;
+    };
+
+    static constexpr size_t DEFAULT_LIMIT_BYTES = 256 * 1024 * 1024;
+
+    /**
+     * Shared instance, backed by the current GL context
+     */
+    static TexturePool& instance();
+
+    /**
+     * @param budget Accounts the pool's objects (nullptr = none; the shared
+     *               instance uses MemoryBudget::instance())
+     */
+    explicit TexturePool(const Backend& backend, MemoryBudget* budget = nullptr);
+    ~TexturePool();
+
+    TexturePool(const TexturePool&) = delete;
+    TexturePool& operator=(const TexturePool&) = delete;
+
+    /**
+     * Texture with this storage: a recycled one whose fence has signalled,
+     * else a new one. The caller sets the sampling parameters.
+     * @param account Charged while the texture is in use
+     * @return Texture name, 0 on failure or if the budget refuses it
+     */
+    GLuint acquireTexture(const Key& key, const MemoryBudget::Account& account = MemoryBudget::Account());
+
+    /** Charge a texture in use to another account (e.g. an armed upload going live) */
+    void reassignTexture(GLuint texture, const MemoryBudget::Account& account);
+
+    /** Hand a texture back (fenced against the draws queued so far) */
+    void releaseTexture(GLuint texture, const Key& key);
+
+    /**
+     * Pixel unpack buffer of at least this size
+     * @return Buffer name, 0 on failure
+     */
+    GLuint acquireBuffer(size_t size,
+                         const MemoryBudget::Account& account =
+                             MemoryBudget::Account(MemoryBudget::Subsystem::UPLOAD_BUFFERS));
+    void releaseBuffer(GLuint buffer, size_t size);
+
+    /** Whether pooled textures have immutable storage (upload with SubImage) */
+    bool hasImmutableStorage() const;
+
+    /**
+     * Retire signalled fences and trim free objects over the limit
+     * (after a swap)
+     */
+    void collect();
+
+    /** Delete every free object (render context still current) */
+    void clear();
+
+    /**
+     * Delete free objects oldest first, fenced or not (GL defers the
+     * deletion of storage still in use)
+     * @return Bytes deleted
+     */
+    size_t evict(size_t bytes);
+
+    void setLimit(size_t bytes);
+    size_t getLimit() const;
+
+    Stats getStats() const;
+
+    /** Mipmap levels of a full chain down to 1x1 */
+    static int fullMipLevels(int width, int height);
+
+    /** Approximate memory of a texture with this storage */
+    static size_t textureBytes(const Key& key);
+
+private:
+    struct FreeObject {
+        GLuint name = 0;
+        Key key;          // Textures
+        size_t size = 0;  // Bytes (buffer size for buffers)
+        void* fence = nullptr;
+        uint64_t serial = 0;  // Release order, oldest trimmed first
+    };
+
+    struct LiveObject {
+        MemoryBudget::Account account;  // Resolved
+        size_t size = 0;
+    };
+
+    bool readyLocked(FreeObject& object);
+    void trimLocked();
+    void deleteLocked(FreeObject& object, bool texture);
+    void takeLocked(std::unordered_map<GLuint, LiveObject>& live, GLuint name,
+                    const MemoryBudget::Account& account, size_t size, bool recycled);
+    size_t giveBackLocked(std::unordered_map<GLuint, LiveObject>& live, GLuint name, size_t size);
+
+    Backend backend_;
+    mutable std::mutex mutex_;
+    std::vector<FreeObject> textures_;
+    std::vector<FreeObject> buffers_;
+    size_t freeBytes_;
+    size_t limit_;
+    uint64_t serial_;
+    Stats stats_;
+    MemoryBudget* budget_;
+    int evictorId_;
+    std::unordered_map<GLuint, LiveObject> liveTextures_;  // Acquired, by name
+    std::unordered_map<GLuint, LiveObject> liveBuffers_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TEXTUREPOOL_H
@@ -0,0 +1,160 @@
+#include "TilePyramid.h"
+#include <algorithm>
+
+namespace videocomposer {
+
+TilePyramid::TilePyramid()
+    : width_(0)
+    , height_(0)
+    , tileSize_(DEFAULT_TILE_SIZE)
+    , tileCount_(0)
+{
+}
+
+TilePyramid::TilePyramid(int width, int height, int tileSize)
+    : width_(std::max(width, 0))
+    , height_(std::max(height, 0))
+    , tileSize_(std::max(tileSize, 1))
+    , tileCount_(0)
+{
+    if (width_ == 0 || height_ == 0) {
+        return;
+    }
+    // A level-l texel covers 2^l level-0 texels (the last one partially)
+    for (int level = 0; ; ++level) {
+        Level l;
+        l.width = static_cast<int>((static_cast<int64_t>(width_) + (int64_t(1) << level) - 1) >> level);
+        l.height = static_cast<int>((static_cast<int64_t>(height_) + (int64_t(1) << level) - 1) >> level);
+        l.tilesX = (l.width + tileSize_ - 1) / tileSize_;
+        l.tilesY = (l.height + tileSize_ - 1) / tileSize_;
+        l.firstTile = static_cast<uint32_t>(tileCount_);
+        tileCount_ += static_cast<size_t>(l.tilesX) * l.tilesY;
+        levels_.push_back(l);
+        if (l.tilesX == 1 && l.tilesY == 1) {
+            break;
+        }
+    }
+}
+
+int TilePyramid::levelWidth(int level) const {
+    return level >= 0 && level < getLevelCount() ? levels_[level].width : 0;
+}
+
+int TilePyramid::levelHeight(int level) const {
+    return level >= 0 && level < getLevelCount() ? levels_[level].height : 0;
+}
+
+int TilePyramid::tilesX(int level) const {
+    return level >= 0 && level < getLevelCount() ? levels_[level].tilesX : 0;
+}
+
+int TilePyramid::tilesY(int level) const {
+    return level >= 0 && level < getLevelCount() ? levels_[level].tilesY : 0;
+}
+
+uint32_t TilePyramid::tileIndex(const Tile& tile) const {
+    const Level& l = levels_[tile.level];
+    return l.firstTile + static_cast<uint32_t>(tile.y * l.tilesX + tile.x);
+}
+
+TilePyramid::Tile TilePyramid::tileAt(uint32_t index) const {
+    Tile tile;
+    for (int level = getTopLevel(); level >= 0; --level) {
+        const Level& l = levels_[level];
+        if (index >= l.firstTile) {
+            uint32_t offset = index - l.firstTile;
+            tile.level = level;
+            tile.x = static_cast<int>(offset % static_cast<uint32_t>(l.tilesX));
+            tile.y = static_cast<int>(offset / static_cast<uint32_t>(l.tilesX));
+            break;
+        }
+    }
+    return tile;
+}
+
+int TilePyramid::tileTexelsX(const Tile& tile) const {
+    return std::min(tileSize_, levelWidth(tile.level) - tile.x * tileSize_);
+}
+
+int TilePyramid::tileTexelsY(const Tile& tile) const {
+    return std::min(tileSize_, levelHeight(tile.level) - tile.y * tileSize_);
+}
+
+void TilePyramid::tileRegion(const Tile& tile, float& u0, float& v0, float& u1, float& v1) const {
+    double span = static_cast<double>(tileSize_) * static_cast<double>(int64_t(1) << tile.level);
+    u0 = static_cast<float>(std::min(1.0, tile.x * span / width_));
+    v0 = static_cast<float>(std::min(1.0, tile.y * span / height_));
+    u1 = static_cast<float>(std::min(1.0, (tile.x + 1) * span / width_));
+    v1 = static_cast<float>(std::min(1.0, (tile.y + 1) * span / height_));
+}
+
+void TilePyramid::tileTexels(const Tile& tile, float u, float v, float& tx, float& ty) const {
+    double texel = static_cast<double>(int64_t(1) << tile.level);
+    tx = static_cast<float>(u * width_ / texel - static_cast<double>(tile.x) * tileSize_);
+    ty = static_cast<float>(v * height_ / texel - static_cast<double>(tile.y) * tileSize_);
+}
+
+void TilePyramid::select(const Projector& project, size_t maxTiles, std::vector<Tile>& tiles) const {
+    tiles.clear();
+    if (levels_.empty() || maxTiles == 0) {
+        return;
+    }
+
+    struct Candidate {
+        Tile tile;
+        float pixelsAcross;
+        float pixelsDown;
+    };
+    auto visible = [this, &project](const Tile& tile, Candidate& candidate) {
+        float u0, v0, u1, v1;
+        tileRegion(tile, u0, v0, u1, v1);
+        candidate.tile = tile;
+        return project(u0, v0, u1, v1, candidate.pixelsAcross, candidate.pixelsDown);
+    };
+
+    // Breadth first: when the budget runs out, a whole level stays coarser
+    // rather than one corner of the image being sharp
+    std::vector<Candidate> current;
+    std::vector<Candidate> next;
+    Candidate top;
+    Tile topTile;
+    topTile.level = getTopLevel();
+    if (!visible(topTile, top)) {
+        return;
+    }
+    current.push_back(top);
+
+    Candidate children[4];
+    while (!current.empty()) {
+        next.clear();
+        for (size_t i = 0; i < current.size(); ++i) {
+            const Candidate& c = current[i];
+            bool magnified = c.pixelsAcross > tileTexelsX(c.tile) || c.pixelsDown > tileTexelsY(c.tile);
+            size_t childCount = 0;
+            if (c.tile.level > 0 && magnified) {
+                for (int dy = 0; dy < 2; ++dy) {
+                    for (int dx = 0; dx < 2; ++dx) {
+                        Tile child;
+                        child.level = c.tile.level - 1;
+                        child.x = c.tile.x * 2 + dx;
+                        child.y = c.tile.y * 2 + dy;
+                        if (child.x < tilesX(child.level) && child.y < tilesY(child.level) &&
+                            visible(child, children[childCount])) {
+                            ++childCount;
+                        }
+                    }
+                }
+            }
+            // Tiles still waiting each take at least one entry
+            size_t committed = tiles.size() + next.size() + (current.size() - i - 1);
+            if (childCount > 0 && committed + childCount <= maxTiles) {
+                next.insert(next.end(), children, children + childCount);
+            } else {
+                tiles.push_back(c.tile);
+            }
+        }
+        current.swap(next);
+    }
+}
+
+} // namespace videocomposer
@@ -0,0 +1,93 @@
+#ifndef VIDEOCOMPOSER_TILEPYRAMID_H
+#define VIDEOCOMPOSER_TILEPYRAMID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * TilePyramid - Mip levels of a giant image cut into square tiles
+ *
+ * Level 0 is the full image; each level above halves it (rounding up)
+ * until the top level fits in one tile. Tiles are numbered level by
+ * level from level 0, row by row, so a tile index is also its position
+ * in the tile cache file (see TiledImage).
+ *
+ * select() walks the quadtree from the top tile down, refining a tile
+ * only while it shows more pixels than it has texels, so the tiles drawn
+ * stay near one texel per screen pixel whatever the layer's transform.
+ */
+class TilePyramid {
+public:
+    static constexpr int DEFAULT_TILE_SIZE = 512;
+
+    struct Tile {
+        int level = 0;
+        int x = 0;
+        int y = 0;
+    };
+
+    /**
+     * On-screen size of an image region (normalized coordinates, v down)
+     * @return false if the region is outside the viewport
+     */
+    using Projector = std::function<bool(float u0, float v0, float u1, float v1,
+                                         float& pixelsAcross, float& pixelsDown)>;
+
+    TilePyramid();
+    TilePyramid(int width, int height, int tileSize = DEFAULT_TILE_SIZE);
+
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    int getTileSize() const { return tileSize_; }
+    int getLevelCount() const { return static_cast<int>(levels_.size()); }
+    int getTopLevel() const { return getLevelCount() - 1; }
+    size_t getTileCount() const { return tileCount_; }
+
+    int levelWidth(int level) const;
+    int levelHeight(int level) const;
+    int tilesX(int level) const;
+    int tilesY(int level) const;
+
+    /** Position of a tile in level order (see above) */
+    uint32_t tileIndex(const Tile& tile) const;
+    Tile tileAt(uint32_t index) const;
+
+    /** Texels of the image in a tile (edge tiles are partial) */
+    int tileTexelsX(const Tile& tile) const;
+    int tileTexelsY(const Tile& tile) const;
+
+    /** Region of the image a tile covers, normalized (v down) */
+    void tileRegion(const Tile& tile, float& u0, float& v0, float& u1, float& v1) const;
+
+    /** Texel position in a tile of an image point (normalized, v down) */
+    void tileTexels(const Tile& tile, float u, float v, float& tx, float& ty) const;
+
+    /**
+     * Visible tiles at the level each needs, at most maxTiles (the
+     * refinement stops early, one level at a time, beyond that)
+     */
+    void select(const Projector& project, size_t maxTiles, std::vector<Tile>& tiles) const;
+
+private:
+    struct Level {
+        int width;
+        int height;
+        int tilesX;
+        int tilesY;
+        uint32_t firstTile;
+    };
+
+    int width_;
+    int height_;
+    int tileSize_;
+    size_t tileCount_;
+    std::vector<Level> levels_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TILEPYRAMID_H
@@ -0,0 +1,76 @@
+#include "TileResidency.h"
+
+namespace videocomposer {
+
+TileResidency::TileResidency(size_t slots)
+    : slots_(slots)
+{
+}
+
+int TileResidency::use(uint32_t tile, uint64_t stamp) {
+    auto it = slotOf_.find(tile);
+    if (it == slotOf_.end()) {
+        return -1;
+    }
+    slots_[it->second].lastUsed = stamp;
+    return it->second;
+}
+
+int TileResidency::find(uint32_t tile) const {
+    auto it = slotOf_.find(tile);
+    return it == slotOf_.end() ? -1 : it->second;
+}
+
+int TileResidency::allocate(uint32_t tile, uint64_t stamp, uint32_t& evicted) {
+    evicted = NO_TILE;
+    int existing = use(tile, stamp);
+    if (existing >= 0) {
+        return existing;
+    }
+
+    // A free slot, else the least recently used tile not on screen now
+    int chosen = -1;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        const Slot& slot = slots_[i];
+        if (slot.tile == NO_TILE) {
+            chosen = static_cast<int>(i);
+            break;
+        }
+        if (slot.pinned || slot.lastUsed >= stamp) {
+            continue;
+        }
+        if (chosen < 0 || slot.lastUsed < slots_[chosen].lastUsed) {
+            chosen = static_cast<int>(i);
+        }
+    }
+    if (chosen < 0) {
+        return -1;
+    }
+
+    Slot& slot = slots_[chosen];
+    if (slot.tile != NO_TILE) {
+        evicted = slot.tile;
+        slotOf_.erase(slot.tile);
+    }
+    slot.tile = tile;
+    slot.lastUsed = stamp;
+    slot.pinned = false;
+    slotOf_[tile] = chosen;
+    return chosen;
+}
+
+void TileResidency::pin(uint32_t tile) {
+    int slot = find(tile);
+    if (slot >= 0) {
+        slots_[slot].pinned = true;
+    }
+}
+
+void TileResidency::clear() {
+    for (Slot& slot : slots_) {
+        slot = Slot();
+    }
+    slotOf_.clear();
+}
+
+} // namespace videocomposer
@@ -0,0 +1,60 @@
+#ifndef VIDEOCOMPOSER_TILERESIDENCY_H
+#define VIDEOCOMPOSER_TILERESIDENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace videocomposer {
+
+/**
+ * TileResidency - Which tiles of a TiledImage occupy the slots of its atlas
+ *
+ * The atlas has a fixed number of tile slots (the VRAM budget of the
+ * layer). Tiles are used with a stamp, normally one per draw; a new tile
+ * takes a free slot or the least recently used one, but never a slot used
+ * at the current stamp (those tiles are on screen) or a pinned one (the
+ * top tile, drawn wherever nothing finer is resident).
+ */
+class TileResidency {
+public:
+    static constexpr uint32_t NO_TILE = UINT32_MAX;
+
+    explicit TileResidency(size_t slots = 0);
+
+    size_t getSlotCount() const { return slots_.size(); }
+    size_t getResidentCount() const { return slotOf_.size(); }
+
+    /** Slot holding a tile (-1 = not resident); marks it used at stamp */
+    int use(uint32_t tile, uint64_t stamp);
+
+    /** Slot holding a tile without marking it (-1 = not resident) */
+    int find(uint32_t tile) const;
+
+    /**
+     * Slot for a tile to be uploaded into, used at stamp
+     * @param evicted Receives the tile that held the slot (NO_TILE if free)
+     * @return -1 when every slot is pinned or in use at stamp
+     */
+    int allocate(uint32_t tile, uint64_t stamp, uint32_t& evicted);
+
+    /** Keep a resident tile whatever its last use */
+    void pin(uint32_t tile);
+
+    void clear();
+
+private:
+    struct Slot {
+        uint32_t tile = NO_TILE;
+        uint64_t lastUsed = 0;
+        bool pinned = false;
+    };
+
+    std::vector<Slot> slots_;
+    std::unordered_map<uint32_t, int> slotOf_;
+};
+
+} // namespace videocomposer
+
+#endif // VIDEOCOMPOSER_TILERESIDENCY_H
@@ -154,4 +154,20 @@ static inline int64_t av_frame_get_pkt_pos(const AVFrame *frame)
 #endif
 #endif
 
+// FFmpeg 4.4 (lavf 58.78.100) made AVStream index entries private: older
+// versions only have the fields
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 78, 100)
+static inline int avformat_index_get_entries_count(const AVStream *st)
+{
+	return st->nb_index_entries;
+}
+
+static inline const AVIndexEntry *avformat_index_get_entry(AVStream *st, int idx)
+{
+	if (idx < 0 || idx >= st->nb_index_entries)
+		return NULL;
+	return &st->index_entries[idx];
+}
+#endif
+
 #endif /* FFCOMPAT_H */